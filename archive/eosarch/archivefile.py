@@ -111,9 +111,12 @@ class ArchiveFile(object):
             else:
                 break
 
-    def files(self):
+    def files(self, skip=0):
         """Generator to read file entries from the archive file.
 
+        Args:
+            skip (int): Number of file entries to skip from the beginning.
+
         Returns:
             Return a file entry from the archive file which looks like this:
             ['f', "./rel/path/file", "val1", ,"val2" ... ]
@@ -122,6 +125,12 @@ class ArchiveFile(object):
         line = self.file.readline().decode("utf-8")
 
         while line:
+            if skip:
+                # No need to parse the entries which are skipped
+                skip -= 1
+                line = self.file.readline().decode("utf-8")
+                continue
+
             fentry = json.loads(line)
 
             if fentry[0] == 'f':
@@ -130,9 +139,12 @@ class ArchiveFile(object):
             else:
                 break
 
-    def entries(self):
+    def entries(self, skip_files=0):
         """ Generator to read all entries from the archive file.
 
+        Args:
+            skip_files (int): Number of file entries to skip
+
         Return:
             A list representing a file or directory entry. See above for the
             actual format.
@@ -140,7 +152,7 @@ class ArchiveFile(object):
         for dentry in self.dirs():
             yield dentry
 
-        for fentry in self.files():
+        for fentry in self.files(skip_files):
             yield fentry
 
     def get_fs(self, url):
@@ -396,7 +408,7 @@ class ArchiveFile(object):
                     self.logger.error(err_msg)
                     raise IOError(err_msg)
 
-    def verify(self, best_effort, tx_check_only=False):
+    def verify(self, best_effort, tx_check_only=False, skip_files=0):
         """ Check the integrity of the archive either on disk or on tape.
 
         Args:
@@ -406,6 +418,8 @@ class ArchiveFile(object):
             tx_check_only (boolean): If True then only check the existence of the
                 entry, the size and checksum value. This is done only for archive
                 GET operations.
+            skip_files (int): Number of file entries at the beginning of the
+                archive which are known to be transferred and are not checked.
 
         Returns:
             (status, lst_failed) - Status is True if archive is valid, otherwise
@@ -418,7 +432,7 @@ class ArchiveFile(object):
         status = True
         lst_failed = []
 
-        for entry in self.entries():
+        for entry in self.entries(skip_files):
             try:
                 self._verify_entry(entry, tx_check_only)
             except CheckEntryException as __:
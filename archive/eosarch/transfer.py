@@ -26,6 +26,8 @@ from __future__ import unicode_literals
 from __future__ import division
 import os
 import time
+import json
+import fcntl
 import logging
 import threading
 import zmq
@@ -41,6 +43,63 @@ from eosarch.asynchandler import MetaHandler
 from eosarch.exceptions import NoErrorException
 
 
+class DestinationSlots(object):
+    """ Slots bounding the number of copy jobs running in parallel towards the
+    same destination host, shared by all the transfer processes of the daemon.
+    Each slot is a lock file in the archive directory and a job holds the lock
+    of one of them while running. The locks are released by the kernel if the
+    process dies.
+
+    Attributes:
+        max_slots     (int): Max number of jobs per destination, 0 for no limit
+        prefix     (string): Path prefix of the slot files of the destination
+    """
+    def __init__(self, config, dst):
+        """Constructor
+
+        Args:
+            config (Configuration): Configuration object
+            dst (string): Destination URL of a transfer
+        """
+        self.max_slots = getattr(config, 'MAX_THREADS_PER_DST', 0)
+        self.poll_timeout = config.JOIN_TIMEOUT
+        hostid = client.URL(dst.encode("utf-8")).hostid
+        self.prefix = ''.join([config.EOS_ARCHIVE_DIR, "dst_",
+                               sha256(hostid).hexdigest()[:16], ".slot"])
+
+    def acquire(self):
+        """ Wait until a slot is free and take it
+
+        Returns:
+            File object holding the lock of the slot or None if there is no
+            limit per destination.
+        """
+        if self.max_slots <= 0:
+            return None
+
+        while True:
+            for indx in range(self.max_slots):
+                fslot = open("{0}{1}".format(self.prefix, indx), 'a')
+
+                try:
+                    fcntl.flock(fslot, fcntl.LOCK_EX | fcntl.LOCK_NB)
+                    return fslot
+                except IOError as __:
+                    fslot.close()
+
+            sleep(self.poll_timeout)
+
+    @staticmethod
+    def release(fslot):
+        """ Release a slot taken with acquire
+
+        Args:
+            fslot (file): File object returned by acquire
+        """
+        if fslot:
+            fslot.close()
+
+
 class ThreadJob(threading.Thread):
     """ Job executing a client.CopyProcess in a separate thread. This makes sense
     since a third-party copy job is mostly waiting for the completion of the
@@ -51,18 +110,24 @@ class ThreadJob(threading.Thread):
         lst_jobs           (list): List of jobs to be executed
         proc (client.CopyProcess): Copy process which is being executed
         retires             (int): Number of times this job was retried
+        batch             (tuple): Indexes of the first and last file entries
+                                   of the archive copied by this job
     """
-    def __init__(self, jobs, retry=0):
+    def __init__(self, jobs, retry=0, slots=None, batch=None):
         """Constructor
 
         Args:
             jobs (list): List of transfers to be executed
             retry (int): Number of times this job was retried
+            slots (DestinationSlots): Slots of the destination of the jobs
+            batch (tuple): Indexes of the file entries copied by this job
         """
         threading.Thread.__init__(self)
         self.retries = retry
         self.xrd_status = None
         self.lst_jobs = list(jobs)
+        self.slots = slots
+        self.batch = batch
 
     def run(self):
         """ Run method
@@ -75,10 +140,15 @@ class ThreadJob(threading.Thread):
             proc.add_job(job[0].encode("utf-8"), job[1].encode("utf-8"),
                          force=True, thirdparty="only")
 
-        self.xrd_status = proc.prepare()
+        fslot = self.slots.acquire() if self.slots else None
+
+        try:
+            self.xrd_status = proc.prepare()
 
-        if self.xrd_status.ok:
-            self.xrd_status, __ = proc.run()
+            if self.xrd_status.ok:
+                self.xrd_status, __ = proc.run()
+        finally:
+            DestinationSlots.release(fslot)
 
 
 class ThreadStatus(threading.Thread):
@@ -197,7 +267,22 @@ class Transfer(object):
         self.uuid = sha256(self.root_dir).hexdigest()
         local_file = join(self.config.DIR[self.oper], self.uuid)
         self.tx_file = local_file + ".tx"
+        self.ckpt_file = local_file + ".ckpt"
         self.list_jobs, self.threads = [], []
+        # Number of threads of this transfer, can be set per request
+        self.max_threads = self.config.MAX_THREADS
+
+        try:
+            if int(req_json.get('threads', 0)) > 0:
+                self.max_threads = int(req_json['threads'])
+        except ValueError as __:
+            pass
+
+        self.dst_slots = None
+        # Checkpoint: number of file entries from the beginning of the archive
+        # which are known to be copied and the batches still running
+        self.ckpt_files, self.ckpt_batches = 0, {}
+        self.batch_first, self.batch_last = None, 0
         self.pid = os.getpid()
         self.archive = None
         # Special case for inital PUT as we need to copy also the archive file
@@ -241,8 +326,10 @@ class Transfer(object):
             self.archive_prepare()
 
             if self.do_retry:
+                self.ckpt_files = self.load_checkpoint()
                 self.do_retry_transfer()
             else:
+                self.remove_checkpoint()
                 self.do_transfer()
         elif self.oper in [self.config.PURGE_OP, self.config.DELETE_OP]:
             self.archive_prepare()
@@ -548,12 +635,16 @@ class Transfer(object):
                 except OSError as __:
                     pass
 
-        # Delete all local files associated with this transfer
+        # Delete all local files associated with this transfer, the checkpoint
+        # is kept for a retry
         try:
             os.remove(self.tx_file)
         except OSError as __:
             pass
 
+        if check_ok:
+            self.remove_checkpoint()
+
         # Join async status thread
         self.thread_status.do_finish()
         self.thread_status.join()
@@ -636,6 +727,11 @@ class Transfer(object):
             self.logger.info("Copying from {0} to {1}".format(src, dst))
             self.list_jobs.append((src, dst))
 
+            if self.batch_first is None:
+                self.batch_first = indx_file
+
+            self.batch_last = indx_file
+
             if len(self.list_jobs) >= self.config.BATCH_SIZE:
                 st = self.flush_files(False)
 
@@ -667,7 +763,7 @@ class Transfer(object):
 
         # Wait until a thread from the pool gets freed if we reached the maximum
         # allowed number of running threads
-        while len(self.threads) >= self.config.MAX_THREADS:
+        while len(self.threads) >= self.max_threads:
             remove_indx, retry_threads = [], []
 
             for indx, thread in enumerate(self.threads):
@@ -682,7 +778,8 @@ class Transfer(object):
                         self.logger.log(logging.INFO,
                                         ("Thread={0} failed, retries={1}").format
                                         (thread.ident, thread.retries))
-                        rthread = ThreadJob(thread.lst_jobs, thread.retries)
+                        rthread = ThreadJob(thread.lst_jobs, thread.retries,
+                                            thread.slots, thread.batch)
                         rthread.start()
                         retry_threads.append(rthread)
                         remove_indx.append(indx)
@@ -695,6 +792,7 @@ class Transfer(object):
                     self.logger.log(log_level,("Thread={0} status={1} msg={2}").format
                                     (thread.ident, thread.xrd_status.ok,
                                      thread.xrd_status.message.decode("utf-8")))
+                    self.update_checkpoint(thread)
                     remove_indx.append(indx)
                     break
 
@@ -713,7 +811,17 @@ class Transfer(object):
         # is a backup operartion (best-effort even if we have failed transfers)
         if (self.list_jobs and ((self.oper != self.config.BACKUP_OP and status) or
                                 (self.oper == self.config.BACKUP_OP))):
-            thread = ThreadJob(self.list_jobs)
+            if self.dst_slots is None:
+                self.dst_slots = DestinationSlots(self.config, self.list_jobs[-1][1])
+
+            batch = None
+
+            if self.batch_first is not None:
+                batch = (self.batch_first, self.batch_last)
+                self.ckpt_batches[self.batch_first] = [self.batch_last, False]
+                self.batch_first = None
+
+            thread = ThreadJob(self.list_jobs, 0, self.dst_slots, batch)
             thread.start()
             self.threads.append(thread)
             del self.list_jobs[:]
@@ -733,7 +841,8 @@ class Transfer(object):
 
                         self.logger.log(logging.INFO, ("Thread={0} failed, retries={1}").format
                                         (thread.ident, thread.retries))
-                        rthread = ThreadJob(thread.lst_jobs, thread.retries)
+                        rthread = ThreadJob(thread.lst_jobs, thread.retries,
+                                            thread.slots, thread.batch)
                         rthread.start()
                         retry_threads.append(rthread)
                         remove_indx.append(indx)
@@ -746,6 +855,7 @@ class Transfer(object):
                     self.logger.log(log_level, ("Thread={0} status={1} msg={2}").format
                                     (thread.ident, thread.xrd_status.ok,
                                      thread.xrd_status.message.decode("utf-8")))
+                    self.update_checkpoint(thread)
                     remove_indx.append(indx)
 
                 # Remove old/finished threads and add retry ones. For removal we
@@ -761,6 +871,72 @@ class Transfer(object):
 
         return status
 
+    def update_checkpoint(self, thread):
+        """ Advance the checkpoint once the batches of all the file entries
+        before it are copied and save it to the local disk, so that a retry
+        skips the entries which are known to be transferred.
+
+        Args:
+            thread (ThreadJob): Finished job
+        """
+        if (not thread.xrd_status.ok or thread.batch is None or
+                self.oper not in [self.config.PUT_OP, self.config.GET_OP]):
+            return
+
+        self.ckpt_batches[thread.batch[0]][1] = True
+        ckpt_files = self.ckpt_files
+
+        for first in sorted(self.ckpt_batches):
+            last, done = self.ckpt_batches[first]
+
+            if not done:
+                break
+
+            ckpt_files = last
+            del self.ckpt_batches[first]
+
+        if ckpt_files == self.ckpt_files:
+            return
+
+        self.ckpt_files = ckpt_files
+        tmp_file = self.ckpt_file + ".tmp"
+
+        try:
+            with open(tmp_file, 'w') as fckpt:
+                json.dump({"uuid": self.uuid, "num_files": self.ckpt_files}, fckpt)
+
+            os.rename(tmp_file, self.ckpt_file)
+        except (IOError, OSError) as err:
+            self.logger.warning("Failed to save checkpoint: {0}".format(err))
+
+    def load_checkpoint(self):
+        """ Load the checkpoint saved by a previous run
+
+        Returns:
+            Number of file entries from the beginning of the archive which
+            were copied by the previous run.
+        """
+        try:
+            with open(self.ckpt_file, 'r') as fckpt:
+                ckpt = json.load(fckpt)
+
+            if ckpt['uuid'] == self.uuid:
+                self.logger.info("Found checkpoint num_files={0}".format
+                                 (ckpt['num_files']))
+                return int(ckpt['num_files'])
+        except (IOError, OSError, ValueError, KeyError) as __:
+            pass
+
+        return 0
+
+    def remove_checkpoint(self):
+        """ Remove the checkpoint of a previous run
+        """
+        try:
+            os.remove(self.ckpt_file)
+        except OSError as __:
+            pass
+
     def update_file_access(self, err_entry=None, found_checkpoint=False):
         """ Set the ownership and the permissions for the files copied to EOS.
         This is done only for GET operation i.e. self.archive.d2t == False.
@@ -873,8 +1049,9 @@ class Transfer(object):
         msg = "verify last run"
         self.set_status(msg)
         meta_ok = False
-        # Check for existence, file size and checksum
-        tx_ok, lst_failed = self.archive.verify(False, True)
+        # Check for existence, file size and checksum of the entries after
+        # the checkpoint
+        tx_ok, lst_failed = self.archive.verify(False, True, self.ckpt_files)
 
         if tx_ok:
             meta_ok, lst_failed = self.archive.verify(False, False)
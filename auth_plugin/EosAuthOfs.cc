@@ -21,8 +21,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
  ************************************************************************/
 
+#include <chrono>
 #include <cstdio>
+#include <cstring>
 #include <sstream>
+#include <vector>
 #include <fcntl.h>
 #include <syscall.h>
 #include <sys/time.h>
@@ -85,7 +88,7 @@ EOSAUTHNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 EosAuthOfs::EosAuthOfs():
   XrdOfs(), eos::common::LogId(),  proxy_tid(0), mFrontend(0), mMaster(0),
-  mSizePoolSocket(5), mPort(0), mLogLevel(LOG_INFO)
+  mSizePoolSocket(5), mPort(0), mLogLevel(LOG_INFO), mRequestId(0)
 {
   // Initialise the ZMQ client
   mZmqContext = new zmq::context_t(1);
@@ -260,13 +263,10 @@ EosAuthOfs::Configure(XrdSysError& error, XrdOucEnv* envP)
         NoGo = 1;
       }
 
-      // Create a pool of sockets connected to the master proxy service
+      // Create a pool of sockets queueing requests to the proxy thread
       for (int i = 0; i < mSizePoolSocket; i++) {
-        // Set socket receive timeout to 5 seconds
-        zmq::socket_t* socket = new zmq::socket_t(*mZmqContext, ZMQ_REQ);
+        zmq::socket_t* socket = new zmq::socket_t(*mZmqContext, ZMQ_PUSH);
 #if ZMQ_VERSION >= 20200
-        int timeout_mili = 5000;
-        socket->setsockopt(ZMQ_RCVTIMEO, &timeout_mili, sizeof timeout_mili);
         int socket_linger = 0;
         socket->setsockopt(ZMQ_LINGER, &socket_linger, sizeof(socket_linger));
 #endif
@@ -364,8 +364,8 @@ EosAuthOfs::StartAuthProxyThread(void* pp)
 void
 EosAuthOfs::AuthProxyThread()
 {
-  // Bind the client facing socket
-  mFrontend = new zmq::socket_t(*mZmqContext, ZMQ_ROUTER);
+  // Bind the socket receiving the requests of the XRootD threads
+  mFrontend = new zmq::socket_t(*mZmqContext, ZMQ_PULL);
   mFrontend->bind("inproc://proxyfrontend");
   // Connect sockets facing the MGM nodes - master and slave
   std::ostringstream sstr;
@@ -388,8 +388,8 @@ EosAuthOfs::AuthProxyThread()
   // Set the master to point to the master MGM - no need for lock
   mMaster = mBackend1.second;
   int rc = -1;
+  zmq::message_t msg_id;
   zmq::message_t msg;
-  // Start the proxy using the first entry
   int more;
   size_t moresz;
   int poll_size = 2;
@@ -405,7 +405,8 @@ EosAuthOfs::AuthProxyThread()
 
   // Main loop in which the proxy thread accepts request from the clients and
   // then he forwards them to the current master MGM. The master MGM can change
-  // at any point.
+  // at any point. The responses of both MGMs complete the requests waiting
+  // for them, in whatever order they arrive.
   while (true) {
     // Wait while there are either requests or replies to process
     try {
@@ -419,36 +420,39 @@ EosAuthOfs::AuthProxyThread()
       return;
     }
 
-    // Process a request
+    // Process a request made of the request id and the payload frames
     if (items[0].revents & ZMQ_POLLIN) {
       eos_debug("got frontend event");
 
-      while (true) {
-        if (!mFrontend->recv(&msg)) {
-          eos_err("error while recv on frontend");
-          return;
-        }
+      if (!mFrontend->recv(&msg_id) || !mFrontend->recv(&msg)) {
+        eos_err("error while recv on frontend");
+        return;
+      }
 
-        try {
-          moresz = sizeof more;
-          mFrontend->getsockopt(ZMQ_RCVMORE, &more, &moresz);
-        } catch (zmq::error_t& err) {
-          eos_err("exception in getsockopt");
-          return;
-        }
+      try {
+        moresz = sizeof more;
+        mFrontend->getsockopt(ZMQ_RCVMORE, &more, &moresz);
+      } catch (zmq::error_t& err) {
+        eos_err("exception in getsockopt");
+        return;
+      }
 
-        // Send request to the current master MGM
-        {
-          XrdSysMutexHelper scop_lock(mMutexMaster);
+      if (more) {
+        eos_err("malformed request on frontend");
+        return;
+      }
 
-          if (!mMaster->send(msg, more ? ZMQ_SNDMORE : 0)) {
-            eos_err("error while sending to master");
-            return;
-          }
-        }
+      // Send request to the current master MGM, the empty delimiter frame
+      // makes the request id the envelope the MGM workers reply to
+      {
+        XrdSysMutexHelper scop_lock(mMutexMaster);
+        zmq::message_t delimiter;
 
-        if (more == 0) {
-          break;
+        if (!mMaster->send(msg_id, ZMQ_SNDMORE) ||
+            !mMaster->send(delimiter, ZMQ_SNDMORE) ||
+            !mMaster->send(msg, 0)) {
+          eos_err("error while sending to master");
+          return;
         }
       }
     }
@@ -457,29 +461,9 @@ EosAuthOfs::AuthProxyThread()
     if (items[1].revents & ZMQ_POLLIN) {
       eos_debug("got mBackend1 event");
 
-      while (true) {
-        if (!mBackend1.second->recv(&msg)) {
-          eos_err("error while recv on mBackend1");
-          return;
-        }
-
-        moresz = sizeof more;
-
-        try {
-          mBackend1.second->getsockopt(ZMQ_RCVMORE, &more, &moresz);
-        } catch (zmq::error_t& err) {
-          eos_err("exception in getsockopt");
-          return;
-        }
-
-        if (!mFrontend->send(msg, more ? ZMQ_SNDMORE : 0)) {
-          eos_err("error while send to frontend(1)");
-          return;
-        }
-
-        if (more == 0) {
-          break;
-        }
+      if (!CompleteRequest(mBackend1.second)) {
+        eos_err("error while recv on mBackend1");
+        return;
       }
     }
 
@@ -487,32 +471,78 @@ EosAuthOfs::AuthProxyThread()
     if ((poll_size == 3) && (items[2].revents & ZMQ_POLLIN)) {
       eos_debug("got mBackend2 event");
 
-      while (true) {
-        if (!mBackend2.second->recv(&msg)) {
-          eos_err("error while recv on mBackend2");
-          return;
-        }
+      if (!CompleteRequest(mBackend2.second)) {
+        eos_err("error while recv on mBackend2");
+        return;
+      }
+    }
+  }
+}
 
-        moresz = sizeof more;
 
-        try {
-          mBackend2.second->getsockopt(ZMQ_RCVMORE, &more, &moresz);
-        } catch (zmq::error_t& err) {
-          eos_err("exception in getsockopt");
-          return;
-        }
+//------------------------------------------------------------------------------
+// Receive a response from an MGM and complete the request waiting for it
+//------------------------------------------------------------------------------
+bool
+EosAuthOfs::CompleteRequest(zmq::socket_t* socket)
+{
+  std::vector<std::string> frames;
+  zmq::message_t msg;
+  int more = 0;
+  size_t moresz;
 
-        if (!mFrontend->send(msg, more ? ZMQ_SNDMORE : 0)) {
-          eos_err("error while send to frontend(2)");
-          return;
-        }
+  do {
+    if (!socket->recv(&msg)) {
+      return false;
+    }
 
-        if (more == 0) {
-          break;
-        }
-      }
+    frames.emplace_back(static_cast<char*>(msg.data()), msg.size());
+    moresz = sizeof more;
+
+    try {
+      socket->getsockopt(ZMQ_RCVMORE, &more, &moresz);
+    } catch (zmq::error_t& err) {
+      eos_err("exception in getsockopt");
+      return false;
     }
+  } while (more);
+
+  // Expected frames: request id, empty delimiter, response
+  uint64_t req_id;
+
+  if ((frames.size() != 3) || (frames[0].size() != sizeof(req_id))) {
+    eos_err("dropping malformed response with %lu frames", frames.size());
+    return true;
+  }
+
+  memcpy(&req_id, frames[0].data(), sizeof(req_id));
+  std::lock_guard<std::mutex> lock(mMutexPending);
+  auto it = mPending.find(req_id);
+
+  if (it == mPending.end()) {
+    eos_warning("dropping response of expired request id=%llu",
+                (unsigned long long) req_id);
+    return true;
   }
+
+  PendingRequest* pending = it->second;
+  mPending.erase(it);
+  std::lock_guard<std::mutex> req_lock(pending->mMutex);
+  pending->mResponse.swap(frames[2]);
+  pending->mDone = true;
+  pending->mCv.notify_one();
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Get the pending request object of the calling thread
+//------------------------------------------------------------------------------
+EosAuthOfs::PendingRequest&
+EosAuthOfs::GetPendingRequest()
+{
+  static thread_local PendingRequest pending;
+  return pending;
 }
 
 
@@ -555,16 +585,14 @@ EosAuthOfs::stat(const char* path,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS stat");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_stat = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_stat = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_stat) {
       retc = resp_stat->response();
@@ -585,9 +613,8 @@ EosAuthOfs::stat(const char* path,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -611,16 +638,14 @@ EosAuthOfs::stat(const char* path,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS statm");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_stat = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_stat = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_stat) {
       retc = resp_stat->response();
@@ -639,9 +664,8 @@ EosAuthOfs::stat(const char* path,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -679,16 +703,14 @@ EosAuthOfs::fsctl(const int cmd,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS fsctl");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_fsctl1 = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_fsctl1 = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_fsctl1) {
       retc = resp_fsctl1->response();
@@ -702,9 +724,8 @@ EosAuthOfs::fsctl(const int cmd,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -725,16 +746,14 @@ EosAuthOfs::FSctl(const int cmd,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS FSctl");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_fsctl2 = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_fsctl2 = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_fsctl2) {
       retc = resp_fsctl2->response();
@@ -748,9 +767,8 @@ EosAuthOfs::FSctl(const int cmd,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -773,16 +791,14 @@ EosAuthOfs::chmod(const char* path,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS chmod");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_chmod = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_chmod = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_chmod) {
       retc = resp_chmod->response();
@@ -796,9 +812,8 @@ EosAuthOfs::chmod(const char* path,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -822,16 +837,14 @@ EosAuthOfs::chksum(csFunc func,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS chksum");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_chksum = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_chksum = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_chksum) {
       retc = resp_chksum->response();
@@ -846,9 +859,8 @@ EosAuthOfs::chksum(csFunc func,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -870,16 +882,14 @@ EosAuthOfs::exists(const char* path,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS exists");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_exists = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_exists = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_exists) {
       retc = resp_exists->response();
@@ -898,9 +908,8 @@ EosAuthOfs::exists(const char* path,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -927,16 +936,14 @@ EosAuthOfs::mkdir(const char* path,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS mkdir");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_mkdir = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_mkdir = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_mkdir) {
       retc = resp_mkdir->response();
@@ -951,9 +958,8 @@ EosAuthOfs::mkdir(const char* path,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -974,16 +980,14 @@ EosAuthOfs::remdir(const char* path,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS remdir");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_remdir = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_remdir = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_remdir) {
       retc = resp_remdir->response();
@@ -998,9 +1002,8 @@ EosAuthOfs::remdir(const char* path,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -1021,16 +1024,14 @@ EosAuthOfs::rem(const char* path,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS rem");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_rem = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_rem = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_rem) {
       retc = resp_rem->response();
@@ -1045,9 +1046,8 @@ EosAuthOfs::rem(const char* path,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -1071,16 +1071,14 @@ EosAuthOfs::rename(const char* oldName,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS rename");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_rename = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_rename = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_rename) {
       retc = resp_rename->response();
@@ -1095,9 +1093,8 @@ EosAuthOfs::rename(const char* oldName,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -1117,16 +1114,14 @@ EosAuthOfs::prepare(XrdSfsPrep& pargs,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS prepare");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_prepare = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_prepare = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_prepare) {
       retc = resp_prepare->response();
@@ -1141,9 +1136,8 @@ EosAuthOfs::prepare(XrdSfsPrep& pargs,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -1166,16 +1160,14 @@ EosAuthOfs::truncate(const char* path,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC FS truncate");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_truncate = static_cast<ResponseProto*>(GetResponse(socket));
+  if (SendProtoBufRequest(req_proto, req_id)) {
+    ResponseProto* resp_truncate = static_cast<ResponseProto*>(GetResponse(req_id));
 
     if (resp_truncate) {
       retc = resp_truncate->response();
@@ -1190,9 +1182,8 @@ EosAuthOfs::truncate(const char* path,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -1214,8 +1205,8 @@ EosAuthOfs::getStats(char* buff, int blen)
 // Send ProtocolBuffer object using ZMQ
 //------------------------------------------------------------------------------
 bool
-EosAuthOfs::SendProtoBufRequest(zmq::socket_t* socket,
-                                google::protobuf::Message* message)
+EosAuthOfs::SendProtoBufRequest(google::protobuf::Message* message,
+                                uint64_t& req_id)
 {
   // Send the request
   bool sent = false;
@@ -1230,10 +1221,30 @@ EosAuthOfs::SendProtoBufRequest(zmq::socket_t* socket,
     return sent;
   }
 
-  sent = socket->send(request, ZMQ_NOBLOCK);
+  req_id = ++mRequestId;
+  zmq::message_t request_id(sizeof(req_id));
+  memcpy(request_id.data(), &req_id, sizeof(req_id));
+  PendingRequest& pending = GetPendingRequest();
+  {
+    std::lock_guard<std::mutex> lock(pending.mMutex);
+    pending.mDone = false;
+    pending.mResponse.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mMutexPending);
+    mPending[req_id] = &pending;
+  }
+  // The socket is only held while the request gets queued
+  zmq::socket_t* socket;
+  mPoolSocket.wait_pop(socket);
+  sent = (socket->send(request_id, ZMQ_SNDMORE | ZMQ_NOBLOCK) &&
+          socket->send(request, ZMQ_NOBLOCK));
+  mPoolSocket.push(socket);
 
   if (!sent) {
     eos_err("unable to send request using zmq");
+    std::lock_guard<std::mutex> lock(mMutexPending);
+    mPending.erase(req_id);
   }
 
   return sent;
@@ -1244,62 +1255,35 @@ EosAuthOfs::SendProtoBufRequest(zmq::socket_t* socket,
 // Get ProtocolBuffer response object using ZMQ
 //------------------------------------------------------------------------------
 google::protobuf::Message*
-EosAuthOfs::GetResponse(zmq::socket_t*& socket)
+EosAuthOfs::GetResponse(uint64_t req_id)
 {
   // It makes no sense to wait more than 1 min since the XRootD client will
   // timeout by default after 60 seconds.
-  int num_retries = 12; // 1 min = 12 * 5 sec
-  bool done = false;
-  bool reset_socket = false;
-  zmq::message_t reply;
+  PendingRequest& pending = GetPendingRequest();
   ResponseProto* resp = static_cast<ResponseProto*>(0);
-
-  try {
-    do {
-      done = socket->recv(&reply);
-      --num_retries;
-
-      if (!done) {
-        eos_err("ptr_socket=%p, num_retries=%i failed receive", socket,
-                num_retries);
-      }
-    } while (!done && (num_retries > 0));
-  } catch (zmq::error_t& e) {
-    eos_err("socket error: %s", e.what());
-    reset_socket = true;
-  }
-
-  // We time out while waiting for a response or a fatal error occurent -
-  // then we throw away the socket and create a new one
-  if ((num_retries <= 0) || reset_socket) {
-    eos_err("discard current socket and create a new one");
-    delete socket;
-    socket = new zmq::socket_t(*mZmqContext, ZMQ_REQ);
-#if ZMQ_VERSION >= 20200
-    int timeout_mili = 5000;
-    socket->setsockopt(ZMQ_RCVTIMEO, &timeout_mili, sizeof timeout_mili);
-    int socket_linger = 0;
-    socket->setsockopt(ZMQ_LINGER, &socket_linger, sizeof(socket_linger));
-#endif
-    std::string endpoint = "inproc://proxyfrontend";
-
-    // Try in a loop to connect to the proxyfrontend as it can take a while for
-    // the proxy thread to do the binding, therefore connect can fail
-    while (1) {
-      try {
-        socket->connect(endpoint.c_str());
-      } catch (zmq::error_t& err) {
-        eos_warning("dealing with connect exception, retrying ...");
-        continue;
-      }
-
-      break;
+  std::unique_lock<std::mutex> lock(pending.mMutex);
+  bool done = pending.mCv.wait_for(lock, std::chrono::seconds(60),
+  [&pending]() {
+    return pending.mDone;
+  });
+
+  if (!done) {
+    // Drop the request unless the proxy thread is completing it right now,
+    // which happens while holding mMutexPending
+    lock.unlock();
+    {
+      std::lock_guard<std::mutex> pending_lock(mMutexPending);
+      mPending.erase(req_id);
     }
+    lock.lock();
+    done = pending.mDone;
   }
 
+  std::string resp_str;
+  resp_str.swap(pending.mResponse);
+  lock.unlock();
+
   if (done) {
-    std::string resp_str = std::string(static_cast<char*>(reply.data()),
-                                       reply.size());
     resp = new ResponseProto();
     resp->ParseFromString(resp_str);
 
@@ -1327,7 +1311,8 @@ EosAuthOfs::GetResponse(zmq::socket_t*& socket)
       }
     }
   } else {
-    eos_err("socket error/timeout during receive");
+    eos_err("timeout while waiting for the response of request id=%llu",
+            (unsigned long long) req_id);
   }
 
   return resp;
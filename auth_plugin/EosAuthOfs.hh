@@ -28,7 +28,11 @@
 #include "Namespace.hh"
 #include "common/ConcurrentQueue.hh"
 #include <zmq.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 //! Forward declaration
 class EosAuthOfsDirectory;
@@ -67,10 +71,15 @@ EOSAUTHNAMESPACE_BEGIN
         requests and receive responses. Only the mastermgm parameter is mandatory
         the other one is optional and can be left out.
     - eosauth.numsockets - once a clients wants to send a request the thread
-        allocated to him in XRootD will require a socket to send the request
-        to the MGM node. Therefore, we set up a pool of sockets from the
-        begining which can be used to send/receiver requests/responses.
-        The default size is 10 sockets.
+        allocated to him in XRootD will require a socket to hand the request
+        over to the proxy thread. Therefore, we set up a pool of sockets from
+        the begining which are only held while a request is queued. The
+        default size is 5 sockets.
+
+    The proxy thread forwards the requests tagged with a request id to the
+    MGM over a single DEALER socket, so that any number of them can be
+    outstanding, and completes the waiting XRootD threads as the responses
+    come back in any order.
 
     MGM - configuration
     ===================
@@ -251,7 +260,7 @@ private:
   XrdSysMutex mMutexMaster; ///< mutex for switching the MGM master
   int mSizePoolSocket; ///< maximum size of the client socket pool
   eos::common::ConcurrentQueue<zmq::socket_t*>
-  mPoolSocket; ///< ZMQ client socket pool
+  mPoolSocket; ///< ZMQ sockets queueing requests to the proxy thread
   ///! MGM endpoints to which requests can be dispatched and the corresponding sockets
   std::pair<std::string, zmq::socket_t*> mBackend1;
   std::pair<std::string, zmq::socket_t*> mBackend2;
@@ -259,6 +268,35 @@ private:
   int mPort;   ///< port on which the current auth server runs
   int mLogLevel; ///< log level value 0 -7 (LOG_EMERG - LOG_DEBUG)
 
+  //--------------------------------------------------------------------------
+  //! Request waiting for its response, one per XRootD thread
+  //--------------------------------------------------------------------------
+  struct PendingRequest {
+    std::mutex mMutex; ///< mutex protecting the members below
+    std::condition_variable mCv; ///< notified when the response arrived
+    bool mDone {false}; ///< the response arrived
+    std::string mResponse; ///< serialized response
+  };
+
+  std::atomic<uint64_t> mRequestId; ///< id of the last request sent
+  std::mutex mMutexPending; ///< mutex protecting the pending requests
+  ///! Requests waiting for their response indexed by request id
+  std::unordered_map<uint64_t, PendingRequest*> mPending;
+
+  //--------------------------------------------------------------------------
+  //! Get the pending request object of the calling thread
+  //--------------------------------------------------------------------------
+  static PendingRequest& GetPendingRequest();
+
+  //--------------------------------------------------------------------------
+  //! Receive a response from an MGM and complete the request waiting for it
+  //!
+  //! @param socket socket connected to the MGM
+  //!
+  //! @return false if the socket failed, otherwise true
+  //--------------------------------------------------------------------------
+  bool CompleteRequest(zmq::socket_t* socket);
+
   //--------------------------------------------------------------------------
   //! Authentication proxy thread which forwards requests form the clients
   //! to the proper MGM intance.
@@ -273,25 +311,26 @@ private:
   //--------------------------------------------------------------------------
   //! Send ProtocolBuffer object using ZMQ
   //!
-  //! @param socket ZMQ socket object
   //! @param object to be sent over the wire
+  //! @param req_id set to the id of the request
   //!
   //! @return true if object sent successfully, otherwise false
   //!
   //--------------------------------------------------------------------------
-  bool SendProtoBufRequest(zmq::socket_t* socket,
-                           google::protobuf::Message* message);
+  bool SendProtoBufRequest(google::protobuf::Message* message,
+                           uint64_t& req_id);
 
   //--------------------------------------------------------------------------
-  //! Get ProtocolBuffer reply object using ZMQ
+  //! Wait for the ProtocolBuffer reply object of a request, has to be called
+  //! by the thread which sent the request
   //!
-  //! @param socket ZMQ socket object
+  //! @param req_id request id
   //!
   //! @return pointer to received object, the user has the responsibility to
   //!         delete the obtained object
   //!
   //--------------------------------------------------------------------------
-  google::protobuf::Message* GetResponse(zmq::socket_t*& socket);
+  google::protobuf::Message* GetResponse(uint64_t req_id);
 
   //--------------------------------------------------------------------------
   //! Update the socket pointing to the master MGM instance
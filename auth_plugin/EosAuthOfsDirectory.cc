@@ -74,17 +74,15 @@ EosAuthOfsDirectory::open(const char* name,
   if (!utils::ComputeHMAC(req_proto))
   {
     eos_err("error HMAC dir open");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (gOFS->SendProtoBufRequest(req_proto, req_id))
   {
-    ResponseProto* resp_open = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
+    ResponseProto* resp_open = static_cast<ResponseProto*>(gOFS->GetResponse(req_id));
 
     if (resp_open)
     {
@@ -94,9 +92,8 @@ EosAuthOfsDirectory::open(const char* name,
     }
   }
   
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -117,17 +114,15 @@ EosAuthOfsDirectory::nextEntry()
   if (!utils::ComputeHMAC(req_proto))
   {
     eos_err("error HMAC dir nextEntry");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return static_cast<const char*>(0) ;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (gOFS->SendProtoBufRequest(req_proto, req_id))
   {
-    ResponseProto* resp_read = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
+    ResponseProto* resp_read = static_cast<ResponseProto*>(gOFS->GetResponse(req_id));
 
     if (resp_read)
     {
@@ -148,9 +143,8 @@ EosAuthOfsDirectory::nextEntry()
     }
   }
   
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return (retc ? static_cast<const char*>(0) : mNextEntry.c_str());
 }
 
@@ -171,17 +165,15 @@ EosAuthOfsDirectory::close()
   if (!utils::ComputeHMAC(req_proto))
   {
     eos_err("error dir close");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (gOFS->SendProtoBufRequest(req_proto, req_id))
   {
-    ResponseProto* resp_close = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
+    ResponseProto* resp_close = static_cast<ResponseProto*>(gOFS->GetResponse(req_id));
 
     if (resp_close)
     {
@@ -191,9 +183,8 @@ EosAuthOfsDirectory::close()
     }
   }
   
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -214,17 +205,15 @@ EosAuthOfsDirectory::FName()
   if (!utils::ComputeHMAC(req_proto))
   {
     eos_err("error HMAC dir fname");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return static_cast<const char*>(0) ;
   }
   
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto))
+  if (gOFS->SendProtoBufRequest(req_proto, req_id))
   {
-    ResponseProto* resp_fname = static_cast<ResponseProto*>(gOFS->GetResponse(socket));
+    ResponseProto* resp_fname = static_cast<ResponseProto*>(gOFS->GetResponse(req_id));
 
     if (resp_fname)
     {
@@ -245,9 +234,8 @@ EosAuthOfsDirectory::FName()
     }
   }
   
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return (retc ? static_cast<const char*>(0) : mName.c_str());
 }
 
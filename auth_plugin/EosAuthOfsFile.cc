@@ -77,17 +77,15 @@ EosAuthOfsFile::open(const char* fileName,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC file open");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto)) {
+  if (gOFS->SendProtoBufRequest(req_proto, req_id)) {
     ResponseProto* resp_open = static_cast<ResponseProto*>(gOFS->GetResponse(
-                                 socket));
+                                 req_id));
 
     if (resp_open) {
       retc = resp_open->response();
@@ -102,9 +100,8 @@ EosAuthOfsFile::open(const char* fileName,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -127,17 +124,15 @@ EosAuthOfsFile::read(XrdSfsFileOffset offset,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC file read");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto)) {
+  if (gOFS->SendProtoBufRequest(req_proto, req_id)) {
     ResponseProto* resp_fread = static_cast<ResponseProto*>(gOFS->GetResponse(
-                                  socket));
+                                  req_id));
 
     if (resp_fread) {
       retc = resp_fread->response();
@@ -152,9 +147,8 @@ EosAuthOfsFile::read(XrdSfsFileOffset offset,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -178,17 +172,15 @@ EosAuthOfsFile::write(XrdSfsFileOffset offset,
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC file write");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto)) {
+  if (gOFS->SendProtoBufRequest(req_proto, req_id)) {
     ResponseProto* resp_fwrite = static_cast<ResponseProto*>(gOFS->GetResponse(
-                                   socket));
+                                   req_id));
 
     if (resp_fwrite) {
       retc = resp_fwrite->response();
@@ -197,9 +189,8 @@ EosAuthOfsFile::write(XrdSfsFileOffset offset,
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -220,17 +211,15 @@ EosAuthOfsFile::FName()
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC file name");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return "";
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto)) {
+  if (gOFS->SendProtoBufRequest(req_proto, req_id)) {
     ResponseProto* resp_fname = static_cast<ResponseProto*>(gOFS->GetResponse(
-                                  socket));
+                                  req_id));
 
     if (resp_fname) {
       retc = resp_fname->response();
@@ -247,9 +236,8 @@ EosAuthOfsFile::FName()
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return (retc ? static_cast<const char*>(0) :
           (mName.empty() ? "" : mName.c_str()));
 }
@@ -271,17 +259,15 @@ EosAuthOfsFile::stat(struct stat* buf)
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC file stat");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto)) {
+  if (gOFS->SendProtoBufRequest(req_proto, req_id)) {
     ResponseProto* resp_fstat = static_cast<ResponseProto*>(gOFS->GetResponse(
-                                  socket));
+                                  req_id));
 
     if (resp_fstat) {
       retc = resp_fstat->response();
@@ -296,9 +282,8 @@ EosAuthOfsFile::stat(struct stat* buf)
     memset(buf, 0, sizeof(struct stat));
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -319,17 +304,15 @@ EosAuthOfsFile::close()
   // Compute HMAC for request object
   if (!utils::ComputeHMAC(req_proto)) {
     eos_err("error HMAC file close");
-    delete req_proto;
+    utils::ReleaseRequestProto(req_proto);
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  uint64_t req_id = 0;
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto)) {
+  if (gOFS->SendProtoBufRequest(req_proto, req_id)) {
     ResponseProto* resp_close = static_cast<ResponseProto*>(gOFS->GetResponse(
-                                  socket));
+                                  req_id));
 
     if (resp_close) {
       retc = resp_close->response();
@@ -338,9 +321,8 @@ EosAuthOfsFile::close()
     }
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
+  // Free memory
+  utils::ReleaseRequestProto(req_proto);
   return retc;
 }
 
@@ -23,7 +23,9 @@
 
 /*----------------------------------------------------------------------------*/
 #include "ProtoUtils.hh"
+#include <mutex>
 #include <sstream>
+#include <vector>
 /*----------------------------------------------------------------------------*/
 #include "common/Logging.hh"
 #include "common/SymKeys.hh"
@@ -37,6 +39,14 @@
 
 EOSAUTHNAMESPACE_BEGIN
 
+namespace
+{
+//! Maximum number of released RequestProto objects kept for reuse
+const size_t kMaxPoolRequestProto = 256;
+std::mutex gMutexPoolRequestProto; ///< mutex protecting the pool
+std::vector<RequestProto*> gPoolRequestProto; ///< released RequestProto objects
+}
+
 //------------------------------------------------------------------------------
 // Convert XrdSecEntity object to ProtocolBuffers representation
 //------------------------------------------------------------------------------
@@ -302,6 +312,52 @@ utils::DeleteXrdSfsFSctl(XrdSfsFSctl*& obj)
 }
 
 
+//------------------------------------------------------------------------------
+// Get an empty RequestProto object
+//------------------------------------------------------------------------------
+RequestProto*
+utils::GetRequestProto()
+{
+  {
+    std::lock_guard<std::mutex> lock(gMutexPoolRequestProto);
+
+    if (!gPoolRequestProto.empty()) {
+      RequestProto* req = gPoolRequestProto.back();
+      gPoolRequestProto.pop_back();
+      return req;
+    }
+  }
+
+  return new RequestProto();
+}
+
+
+//------------------------------------------------------------------------------
+// Give back a RequestProto object for reuse
+//------------------------------------------------------------------------------
+void
+utils::ReleaseRequestProto(RequestProto*& req)
+{
+  if (!req) {
+    return;
+  }
+
+  // Clear keeps the nested messages and the string buffers allocated
+  req->Clear();
+  {
+    std::lock_guard<std::mutex> lock(gMutexPoolRequestProto);
+
+    if (gPoolRequestProto.size() < kMaxPoolRequestProto) {
+      gPoolRequestProto.push_back(req);
+      req = 0;
+      return;
+    }
+  }
+  delete req;
+  req = 0;
+}
+
+
 //------------------------------------------------------------------------------
 // Compute HMAC value of the RequestProto object and append it to the
 // object using the required field hmac
@@ -309,7 +365,8 @@ utils::DeleteXrdSfsFSctl(XrdSfsFSctl*& obj)
 bool
 utils::ComputeHMAC(RequestProto*& req)
 {
-  std::string smsg;
+  // The serialization buffer is reused by the calling thread
+  thread_local std::string smsg;
   req->set_hmac(""); // set it temporarily, we update it later
 
   if (!req->SerializeToString(&smsg)) {
@@ -343,7 +400,7 @@ utils::GetStatRequest(RequestProto_OperationType type,
                       const XrdSecEntity* client,
                       const char* opaque)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::StatProto* stat_proto = req_proto->mutable_stat();
   eos::auth::XrdOucErrInfoProto* xoei_proto = stat_proto->mutable_error();
   eos::auth::XrdSecEntityProto* xse_proto = stat_proto->mutable_client();
@@ -371,7 +428,7 @@ utils::GetFsctlRequest(const int cmd,
                        XrdOucErrInfo& error,
                        const XrdSecEntity* client)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::FsctlProto* fsctl_proto = req_proto->mutable_fsctl1();
   eos::auth::XrdOucErrInfoProto* xoei_proto = fsctl_proto->mutable_error();
   eos::auth::XrdSecEntityProto* xse_proto = fsctl_proto->mutable_client();
@@ -393,7 +450,7 @@ utils::GetFSctlRequest(const int cmd,
                        XrdOucErrInfo& error,
                        const XrdSecEntity* client)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::FSctlProto* fsctl_proto = req_proto->mutable_fsctl2();
   eos::auth::XrdSfsFSctlProto* args_proto = fsctl_proto->mutable_args();
   eos::auth::XrdOucErrInfoProto* xoei_proto = fsctl_proto->mutable_error();
@@ -417,7 +474,7 @@ utils::GetChmodRequest(const char* path,
                        const XrdSecEntity* client,
                        const char* opaque)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::ChmodProto* chmod_proto = req_proto->mutable_chmod();
   eos::auth::XrdOucErrInfoProto* xoei_proto = chmod_proto->mutable_error();
   eos::auth::XrdSecEntityProto* xse_proto = chmod_proto->mutable_client();
@@ -446,7 +503,7 @@ utils::GetChksumRequest(XrdSfsFileSystem::csFunc func,
                         const XrdSecEntity* client,
                         const char* opaque)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::ChksumProto* chksum_proto = req_proto->mutable_chksum();
   eos::auth::XrdOucErrInfoProto* xoei_proto = chksum_proto->mutable_error();
   chksum_proto->set_func(func);
@@ -483,7 +540,7 @@ utils::GetExistsRequest(const char* path,
                         const XrdSecEntity* client,
                         const char* opaque)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::ExistsProto* exists_proto = req_proto->mutable_exists();
   eos::auth::XrdOucErrInfoProto* xoei_proto = exists_proto->mutable_error();
   eos::auth::XrdSecEntityProto* xse_proto = exists_proto->mutable_client();
@@ -510,7 +567,7 @@ utils::GetMkdirRequest(const char* path,
                        const XrdSecEntity* client,
                        const char* opaque)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::MkdirProto* mkdir_proto = req_proto->mutable_mkdir();
   eos::auth::XrdOucErrInfoProto* xoei_proto = mkdir_proto->mutable_error();
   eos::auth::XrdSecEntityProto* xse_proto = mkdir_proto->mutable_client();
@@ -538,7 +595,7 @@ utils::GetRemdirRequest(const char* path,
                         const XrdSecEntity* client,
                         const char* opaque)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::RemdirProto* remdir_proto = req_proto->mutable_remdir();
   eos::auth::XrdOucErrInfoProto* xoei_proto = remdir_proto->mutable_error();
   eos::auth::XrdSecEntityProto* xse_proto = remdir_proto->mutable_client();
@@ -564,7 +621,7 @@ utils::GetRemRequest(const char* path,
                      const XrdSecEntity* client,
                      const char* opaque)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::RemProto* rem_proto = req_proto->mutable_rem();
   eos::auth::XrdOucErrInfoProto* xoei_proto = rem_proto->mutable_error();
   eos::auth::XrdSecEntityProto* xse_proto = rem_proto->mutable_client();
@@ -592,7 +649,7 @@ utils::GetRenameRequest(const char* oldName,
                         const char* opaqueO,
                         const char* opaqueN)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::RenameProto* rename_proto = req_proto->mutable_rename();
   eos::auth::XrdOucErrInfoProto* xoei_proto = rename_proto->mutable_error();
   eos::auth::XrdSecEntityProto* xse_proto = rename_proto->mutable_client();
@@ -622,7 +679,7 @@ utils::GetPrepareRequest(XrdSfsPrep& pargs,
                          XrdOucErrInfo& error,
                          const XrdSecEntity* client)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::PrepareProto* prepare_proto = req_proto->mutable_prepare();
   eos::auth::XrdSfsPrepProto* xsp_proto = prepare_proto->mutable_pargs();
   eos::auth::XrdOucErrInfoProto* xoei_proto = prepare_proto->mutable_error();
@@ -645,7 +702,7 @@ utils::GetTruncateRequest(const char* path,
                           const XrdSecEntity* client,
                           const char* opaque)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::TruncateProto* truncate_proto = req_proto->mutable_truncate();
   eos::auth::XrdOucErrInfoProto* xoei_proto = truncate_proto->mutable_error();
   eos::auth::XrdSecEntityProto* xse_proto = truncate_proto->mutable_client();
@@ -674,7 +731,7 @@ utils::GetDirOpenRequest(std::string&& uuid,
                          const char* user,
                          int monid)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::DirOpenProto* dopen_proto = req_proto->mutable_diropen();
   eos::auth::XrdSecEntityProto* xse_proto = dopen_proto->mutable_client();
   // Save the address of the directory object
@@ -699,7 +756,7 @@ utils::GetDirOpenRequest(std::string&& uuid,
 RequestProto*
 utils::GetDirReadRequest(std::string&& uuid)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::DirReadProto* dread_proto = req_proto->mutable_dirread();
   dread_proto->set_uuid(uuid);
   req_proto->set_type(RequestProto_OperationType_DIRREAD);
@@ -713,7 +770,7 @@ utils::GetDirReadRequest(std::string&& uuid)
 RequestProto*
 utils::GetDirFnameRequest(std::string&& uuid)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::DirFnameProto* dfname_proto = req_proto->mutable_dirfname();
   dfname_proto->set_uuid(uuid);
   req_proto->set_type(RequestProto_OperationType_DIRFNAME);
@@ -727,7 +784,7 @@ utils::GetDirFnameRequest(std::string&& uuid)
 RequestProto*
 utils::GetDirCloseRequest(std::string&& uuid)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::DirCloseProto* dclose_proto = req_proto->mutable_dirclose();
   dclose_proto->set_uuid(uuid);
   req_proto->set_type(RequestProto_OperationType_DIRCLOSE);
@@ -748,7 +805,7 @@ utils::GetFileOpenRequest(std::string&& uuid,
                           const char* user,
                           int monid)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::FileOpenProto* fopen_proto = req_proto->mutable_fileopen();
   eos::auth::XrdSecEntityProto* xse_proto = fopen_proto->mutable_client();
   // Save the address of the file object
@@ -775,7 +832,7 @@ utils::GetFileOpenRequest(std::string&& uuid,
 RequestProto*
 utils::GetFileFnameRequest(std::string&& uuid)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::FileFnameProto* ffname_proto = req_proto->mutable_filefname();
   ffname_proto->set_uuid(uuid);
   req_proto->set_type(RequestProto_OperationType_FILEFNAME);
@@ -789,7 +846,7 @@ utils::GetFileFnameRequest(std::string&& uuid)
 RequestProto*
 utils::GetFileStatRequest(std::string&& uuid)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::FileStatProto* fstat_proto = req_proto->mutable_filestat();
   fstat_proto->set_uuid(uuid);
   req_proto->set_type(RequestProto_OperationType_FILESTAT);
@@ -805,7 +862,7 @@ utils::GetFileReadRequest(std::string&& uuid,
                           long long offset,
                           int length)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::FileReadProto* fread_proto = req_proto->mutable_fileread();
   fread_proto->set_uuid(uuid);
   fread_proto->set_offset(offset);
@@ -824,7 +881,7 @@ utils::GetFileWriteRequest(std::string&& uuid,
                            const char* buff,
                            int length)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::FileWriteProto* fwrite_proto = req_proto->mutable_filewrite();
   fwrite_proto->set_uuid(uuid);
   fwrite_proto->set_offset(offset);
@@ -841,7 +898,7 @@ utils::GetFileWriteRequest(std::string&& uuid,
 RequestProto*
 utils::GetFileCloseRequest(std::string&& uuid)
 {
-  eos::auth::RequestProto* req_proto = new eos::auth::RequestProto();
+  eos::auth::RequestProto* req_proto = GetRequestProto();
   eos::auth::FileCloseProto* fclose_proto = req_proto->mutable_fileclose();
   fclose_proto->set_uuid(uuid);
   req_proto->set_type(RequestProto_OperationType_FILECLOSE);
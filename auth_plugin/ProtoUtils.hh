@@ -143,6 +143,23 @@ void DeleteXrdSfsFSctl(XrdSfsFSctl*& obj);
 //----------------------------------------------------------------------------
 bool ComputeHMAC(eos::auth::RequestProto*& req);
 
+//----------------------------------------------------------------------------
+//! Get an empty RequestProto object, reused from the pool of released
+//! objects if possible so that its nested messages and strings keep their
+//! allocations
+//!
+//! @return request ProtoBuffer object
+//----------------------------------------------------------------------------
+eos::auth::RequestProto* GetRequestProto();
+
+//----------------------------------------------------------------------------
+//! Give back a RequestProto object obtained from any of the Get*Request
+//! functions, the object is cleared and kept for reuse
+//!
+//! @param req RequestProto object, set to null
+//----------------------------------------------------------------------------
+void ReleaseRequestProto(eos::auth::RequestProto*& req);
+
 //----------------------------------------------------------------------------
 //! Create stat request ProtocolBuffer object
 //!
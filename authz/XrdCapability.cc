@@ -36,6 +36,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <cstring>
+#include <vector>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
 
 #ifdef __APPLE__
 #define ENOKEY 126
@@ -47,6 +51,130 @@ XrdSysError TkEroute(0, "capability");
 XrdOucTrace TkTrace(&TkEroute);
 /*----------------------------------------------------------------------------*/
 XrdCapability gCapabilityEngine;
+std::atomic<bool> XrdCapability::sBinaryFormat {false};
+constexpr const char* XrdCapability::sBinaryPrefix;
+
+namespace
+{
+/*----------------------------------------------------------------------------*/
+/* Binary capability layout, integers in host byte order (little endian on all
+   supported platforms):
+   header | AES-256-GCM(env) | GCM tag
+   The header is authenticated as additional data.
+*/
+/*----------------------------------------------------------------------------*/
+struct BinaryCapHeader {
+  char     mMagic[4];
+  uint8_t  mVersion;
+  uint8_t  mFlags;
+  uint16_t mReserved;
+  uint32_t mPayloadLen;
+  uint64_t mExpires;
+  unsigned char mIv[12];
+} __attribute__((packed));
+
+static_assert(sizeof(BinaryCapHeader) == 32, "unexpected capability header");
+
+const char sBinaryMagic[4] = {'E', 'O', 'S', 'C'};
+const uint8_t sBinaryVersion = 2;
+const size_t sBinaryTagLen = 16;
+const size_t sMaxBinaryPayload = 1024 * 1024;
+
+/*----------------------------------------------------------------------------*/
+/* Per thread cipher contexts, keyed with the AES key derived from the last
+   symmetric key used, so that the key schedule is only computed on a key
+   change. The GCM nonces are a random per thread start value incremented for
+   every capability.
+*/
+/*----------------------------------------------------------------------------*/
+struct CapCipherCtx {
+  EVP_CIPHER_CTX* mCtx {nullptr};
+  char mKeyDigest[SHA_DIGEST_LENGTH];
+  bool mKeyed {false};
+
+  ~CapCipherCtx()
+  {
+    if (mCtx) {
+      EVP_CIPHER_CTX_free(mCtx);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Initialize the context for a new message, returns false on failure
+  //----------------------------------------------------------------------------
+  bool Init(eos::common::SymKey* key, const unsigned char* iv, bool encrypt)
+  {
+    if (!mCtx && !(mCtx = EVP_CIPHER_CTX_new())) {
+      return false;
+    }
+
+    int rc;
+
+    if (mKeyed && !memcmp(mKeyDigest, key->GetDigest(), SHA_DIGEST_LENGTH)) {
+      rc = encrypt ? EVP_EncryptInit_ex(mCtx, nullptr, nullptr, nullptr, iv) :
+           EVP_DecryptInit_ex(mCtx, nullptr, nullptr, nullptr, iv);
+    } else {
+      // AES-256 needs a 32 byte key, the symmetric keys have SHA_DIGEST_LENGTH
+      static const char label[] = "eos.capability.v2";
+      unsigned char seed[sizeof(label) + SHA_DIGEST_LENGTH];
+      unsigned char aeskey[SHA256_DIGEST_LENGTH];
+      memcpy(seed, label, sizeof(label));
+      memcpy(seed + sizeof(label), key->GetKey(), SHA_DIGEST_LENGTH);
+      SHA256(seed, sizeof(seed), aeskey);
+      OPENSSL_cleanse(seed, sizeof(seed));
+      mKeyed = false;
+      rc = encrypt ?
+           EVP_EncryptInit_ex(mCtx, EVP_aes_256_gcm(), nullptr, aeskey, iv) :
+           EVP_DecryptInit_ex(mCtx, EVP_aes_256_gcm(), nullptr, aeskey, iv);
+      OPENSSL_cleanse(aeskey, sizeof(aeskey));
+
+      if (rc == 1) {
+        memcpy(mKeyDigest, key->GetDigest(), SHA_DIGEST_LENGTH);
+        mKeyed = true;
+      }
+    }
+
+    if (rc != 1) {
+      mKeyed = false;
+      return false;
+    }
+
+    return true;
+  }
+};
+
+struct CapThreadState {
+  CapCipherCtx mEncrypt;
+  CapCipherCtx mDecrypt;
+  unsigned char mIv[12];
+  bool mIvInit {false};
+
+  //----------------------------------------------------------------------------
+  // Get the next nonce
+  //----------------------------------------------------------------------------
+  void NextIv(unsigned char* iv)
+  {
+    if (!mIvInit) {
+      if (RAND_bytes(mIv, sizeof(mIv)) != 1) {
+        // Fall back to the time and thread address which are unique as well
+        uint64_t seed = ((uint64_t) time(NULL) << 20) ^ (uint64_t) this;
+        memset(mIv, 0, sizeof(mIv));
+        memcpy(mIv, &seed, sizeof(seed));
+      }
+
+      mIvInit = true;
+    }
+
+    uint64_t counter;
+    memcpy(&counter, mIv + 4, sizeof(counter));
+    ++counter;
+    memcpy(mIv + 4, &counter, sizeof(counter));
+    memcpy(iv, mIv, sizeof(mIv));
+  }
+};
+
+thread_local CapThreadState tlCapState;
+}
 
 /*----------------------------------------------------------------------------*/
 XrdAccPrivs
@@ -116,6 +244,24 @@ XrdCapability::Create(XrdOucEnv* inenv,
   }
 
   int envlen;
+
+  if (sBinaryFormat) {
+    const char* env = inenv->Env(envlen);
+    XrdOucString msg;
+    int rc = CreateBinary(env, envlen, key, time(NULL) + cap_validity, msg);
+
+    if (rc) {
+      return rc;
+    }
+
+    XrdOucString encenv = "cap.sym=";
+    encenv += key->GetDigest64();
+    encenv += "&cap.msg=";
+    encenv += msg;
+    outenv = new XrdOucEnv(encenv.c_str());
+    return 0;
+  }
+
   XrdOucString toencrypt = inenv->Env(envlen);
   // Add the validity time - default 1 hour
   toencrypt += "&cap.valid=";
@@ -157,6 +303,24 @@ XrdCapability::Extract(XrdOucEnv* inenv, XrdOucEnv*& outenv)
     return EINVAL;
   }
 
+  // Binary capabilities need none of the newline fixing below
+  const char* binmsg = inenv->Get("cap.msg");
+
+  if (binmsg && !strncmp(binmsg, sBinaryPrefix, strlen(sBinaryPrefix))) {
+    const char* binsym = inenv->Get("cap.sym");
+    eos::common::SymKey* key = 0;
+
+    if (!binsym) {
+      return EINVAL;
+    }
+
+    if (!(key = eos::common::gSymKeyStore.GetKey(binsym))) {
+      return ENOKEY;
+    }
+
+    return ExtractBinary(binmsg + strlen(sBinaryPrefix), key, outenv);
+  }
+
   int envlen;
   XrdOucString instring = inenv->Env(envlen);
 
@@ -210,6 +374,122 @@ XrdCapability::Extract(XrdOucEnv* inenv, XrdOucEnv*& outenv)
   return 0;
 }
 
+/*----------------------------------------------------------------------------*/
+int
+XrdCapability::CreateBinary(const char* env, int envlen,
+                            eos::common::SymKey* key, uint64_t expires,
+                            XrdOucString& msg)
+{
+  if (!env || (envlen < 0) || ((size_t) envlen > sMaxBinaryPayload)) {
+    return EINVAL;
+  }
+
+  size_t caplen = sizeof(BinaryCapHeader) + envlen + sBinaryTagLen;
+  std::vector<unsigned char> cap(caplen);
+  BinaryCapHeader* hdr = (BinaryCapHeader*) cap.data();
+  memcpy(hdr->mMagic, sBinaryMagic, sizeof(sBinaryMagic));
+  hdr->mVersion = sBinaryVersion;
+  hdr->mFlags = 0;
+  hdr->mReserved = 0;
+  hdr->mPayloadLen = (uint32_t) envlen;
+  hdr->mExpires = expires;
+  CapThreadState& state = tlCapState;
+  state.NextIv(hdr->mIv);
+  CapCipherCtx& cctx = state.mEncrypt;
+  unsigned char* ct = cap.data() + sizeof(BinaryCapHeader);
+  int len = 0;
+
+  if (!cctx.Init(key, hdr->mIv, true) ||
+      (EVP_EncryptUpdate(cctx.mCtx, nullptr, &len, cap.data(),
+                         sizeof(BinaryCapHeader)) != 1) ||
+      (envlen && (EVP_EncryptUpdate(cctx.mCtx, ct, &len,
+                                    (const unsigned char*) env, envlen) != 1)) ||
+      (EVP_EncryptFinal_ex(cctx.mCtx, ct + envlen, &len) != 1) ||
+      (EVP_CIPHER_CTX_ctrl(cctx.mCtx, EVP_CTRL_GCM_GET_TAG, sBinaryTagLen,
+                           ct + envlen) != 1)) {
+    cctx.mKeyed = false;
+    return EKEYREJECTED;
+  }
+
+  std::vector<char> b64(strlen(sBinaryPrefix) + 4 * ((caplen + 2) / 3) + 1);
+  memcpy(b64.data(), sBinaryPrefix, strlen(sBinaryPrefix));
+  EVP_EncodeBlock((unsigned char*) b64.data() + strlen(sBinaryPrefix),
+                  cap.data(), caplen);
+  msg = b64.data();
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+int
+XrdCapability::ExtractBinary(const char* msg, eos::common::SymKey* key,
+                             XrdOucEnv*& outenv)
+{
+  size_t b64len = strlen(msg);
+
+  if (!b64len || (b64len % 4) ||
+      (b64len > 4 * ((sMaxBinaryPayload + sizeof(BinaryCapHeader) +
+                      sBinaryTagLen + 2) / 3))) {
+    return EINVAL;
+  }
+
+  std::vector<unsigned char> cap(3 * (b64len / 4));
+  int caplen = EVP_DecodeBlock(cap.data(), (const unsigned char*) msg, b64len);
+
+  if (caplen < 0) {
+    return EINVAL;
+  }
+
+  // EVP_DecodeBlock keeps the bytes of the padding
+  caplen -= (msg[b64len - 1] == '=') + (msg[b64len - 2] == '=');
+
+  if ((size_t) caplen < sizeof(BinaryCapHeader) + sBinaryTagLen) {
+    return EINVAL;
+  }
+
+  BinaryCapHeader* hdr = (BinaryCapHeader*) cap.data();
+  size_t envlen = hdr->mPayloadLen;
+
+  if (memcmp(hdr->mMagic, sBinaryMagic, sizeof(sBinaryMagic)) ||
+      (hdr->mVersion != sBinaryVersion) ||
+      (envlen != caplen - sizeof(BinaryCapHeader) - sBinaryTagLen)) {
+    return EINVAL;
+  }
+
+  CapCipherCtx& cctx = tlCapState.mDecrypt;
+  unsigned char* ct = cap.data() + sizeof(BinaryCapHeader);
+  std::vector<char> env(envlen + 32);
+  int len = 0;
+
+  if (!cctx.Init(key, hdr->mIv, false) ||
+      (EVP_DecryptUpdate(cctx.mCtx, nullptr, &len, cap.data(),
+                         sizeof(BinaryCapHeader)) != 1) ||
+      (envlen && (EVP_DecryptUpdate(cctx.mCtx, (unsigned char*) env.data(),
+                                    &len, ct, envlen) != 1)) ||
+      (EVP_CIPHER_CTX_ctrl(cctx.mCtx, EVP_CTRL_GCM_SET_TAG, sBinaryTagLen,
+                           ct + envlen) != 1)) {
+    cctx.mKeyed = false;
+    return EKEYREJECTED;
+  }
+
+  // The tag check fails for a wrong key or modified data
+  if (EVP_DecryptFinal_ex(cctx.mCtx, (unsigned char*) env.data() + envlen,
+                          &len) != 1) {
+    return EKEYREJECTED;
+  }
+
+  // Expose the validity like the env format does
+  uint64_t expires = hdr->mExpires;
+  snprintf(env.data() + envlen, 32, "&cap.valid=%llu",
+           (unsigned long long) expires);
+  outenv = new XrdOucEnv(env.data());
+
+  if (expires < (uint64_t) time(NULL)) {
+    return ETIME;
+  }
+
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 // Destructor
 //------------------------------------------------------------------------------
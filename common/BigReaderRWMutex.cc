@@ -0,0 +1,260 @@
+//------------------------------------------------------------------------------
+// File: BigReaderRWMutex.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/BigReaderRWMutex.hh"
+#include <errno.h>
+#include <thread>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+constexpr size_t BigReaderRWMutex::kNumSlots;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+BigReaderRWMutex::BigReaderRWMutex(bool prefer_readers):
+  mWriter(false), mWrOwned(false), mPreferReaders(prefer_readers)
+{}
+
+//------------------------------------------------------------------------------
+// Get the reader slot of the calling thread - threads are assigned slots in
+// a round-robin fashion the first time they take a read lock.
+//------------------------------------------------------------------------------
+BigReaderRWMutex::ReaderSlot&
+BigReaderRWMutex::GetSlot()
+{
+  static std::atomic<size_t> sNextSlot {0};
+  static thread_local size_t sSlot = sNextSlot++ % kNumSlots;
+  return mSlots[sSlot];
+}
+
+//------------------------------------------------------------------------------
+// Check if there is any registered reader
+//------------------------------------------------------------------------------
+bool
+BigReaderRWMutex::HasReaders() const
+{
+  for (size_t i = 0; i < kNumSlots; ++i) {
+    if (mSlots[i].mCount.load()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Read lock, optionally bounded by a deadline
+//------------------------------------------------------------------------------
+int
+BigReaderRWMutex::DoLockRead(const Clock::time_point* deadline)
+{
+  ReaderSlot& slot = GetSlot();
+
+  while (true) {
+    // Register first and then check for a writer, the writer does the
+    // opposite so at least one of the two sees the other one.
+    slot.mCount.fetch_add(1);
+
+    if (!mWriter.load()) {
+      return 0;
+    }
+
+    slot.mCount.fetch_sub(1);
+    auto no_writer = [&]() {
+      return !mWriter.load();
+    };
+    std::unique_lock<std::mutex> lock(mWaitMutex);
+
+    if (deadline) {
+      if (!mWaitCv.wait_until(lock, *deadline, no_writer)) {
+        return ETIMEDOUT;
+      }
+    } else {
+      mWaitCv.wait(lock, no_writer);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Mark writer active and wait for all readers to drain
+//------------------------------------------------------------------------------
+bool
+BigReaderRWMutex::AcquireWriter(const Clock::time_point* deadline)
+{
+  while (true) {
+    mWriter.store(true);
+
+    if (!HasReaders()) {
+      return true;
+    }
+
+    if (mPreferReaders) {
+      // Give way to the readers and retry once they are gone
+      ReleaseWriter();
+
+      while (HasReaders()) {
+        if (deadline && (Clock::now() >= *deadline)) {
+          return false;
+        }
+
+        std::this_thread::yield();
+      }
+    } else {
+      // New readers are blocked, wait for the current ones to finish
+      while (HasReaders()) {
+        if (deadline && (Clock::now() >= *deadline)) {
+          ReleaseWriter();
+          return false;
+        }
+
+        std::this_thread::yield();
+      }
+
+      return true;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Clear writer flag and wake up waiting readers
+//------------------------------------------------------------------------------
+void
+BigReaderRWMutex::ReleaseWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mWaitMutex);
+    mWriter.store(false);
+  }
+  mWaitCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Acquire writer ownership
+//------------------------------------------------------------------------------
+bool
+BigReaderRWMutex::AcquireOwnership(const Clock::time_point* deadline)
+{
+  auto not_owned = [&]() {
+    return !mWrOwned;
+  };
+  std::unique_lock<std::mutex> lock(mWaitMutex);
+
+  if (deadline) {
+    if (!mWrCv.wait_until(lock, *deadline, not_owned)) {
+      return false;
+    }
+  } else {
+    mWrCv.wait(lock, not_owned);
+  }
+
+  mWrOwned = true;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Release writer ownership
+//------------------------------------------------------------------------------
+void
+BigReaderRWMutex::ReleaseOwnership()
+{
+  {
+    std::lock_guard<std::mutex> lock(mWaitMutex);
+    mWrOwned = false;
+  }
+  mWrCv.notify_one();
+}
+
+//------------------------------------------------------------------------------
+// Lock for read
+//------------------------------------------------------------------------------
+int
+BigReaderRWMutex::LockRead()
+{
+  return DoLockRead(nullptr);
+}
+
+//------------------------------------------------------------------------------
+// Unlock a read lock
+//------------------------------------------------------------------------------
+int
+BigReaderRWMutex::UnLockRead()
+{
+  GetSlot().mCount.fetch_sub(1);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Try to read lock the mutex within the timeout
+//------------------------------------------------------------------------------
+int
+BigReaderRWMutex::TimedRdLock(uint64_t timeout_ns)
+{
+  Clock::time_point deadline = Clock::now() + std::chrono::nanoseconds(
+                                 timeout_ns);
+  return DoLockRead(&deadline);
+}
+
+//------------------------------------------------------------------------------
+// Lock for write
+//------------------------------------------------------------------------------
+int
+BigReaderRWMutex::LockWrite()
+{
+  (void) AcquireOwnership(nullptr);
+  (void) AcquireWriter(nullptr);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Unlock a write lock
+//------------------------------------------------------------------------------
+int
+BigReaderRWMutex::UnLockWrite()
+{
+  ReleaseWriter();
+  ReleaseOwnership();
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Try to write lock the mutex within the timeout
+//------------------------------------------------------------------------------
+int
+BigReaderRWMutex::TimedWrLock(uint64_t timeout_ns)
+{
+  Clock::time_point deadline = Clock::now() + std::chrono::nanoseconds(
+                                 timeout_ns);
+
+  if (!AcquireOwnership(&deadline)) {
+    return ETIMEDOUT;
+  }
+
+  if (!AcquireWriter(&deadline)) {
+    ReleaseOwnership();
+    return ETIMEDOUT;
+  }
+
+  return 0;
+}
+
+EOSCOMMONNAMESPACE_END
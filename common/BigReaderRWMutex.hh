@@ -0,0 +1,182 @@
+//------------------------------------------------------------------------------
+// File: BigReaderRWMutex.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "common/Namespace.hh"
+#include "common/IRWMutex.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class BigReaderRWMutex - read-write mutex for read-mostly data where every
+//! thread registers as a reader in its own cache line sized slot, so readers
+//! on different cores do not contend on one shared counter. A writer has to
+//! scan all the slots and wait until they are drained, therefore write locks
+//! are considerably more expensive than with the other implementations.
+//!
+//! With reader preference a writer backs off as long as there are readers,
+//! which makes recursive read locking safe. Without it, a pending writer
+//! blocks new readers and recursive read locks may deadlock.
+//------------------------------------------------------------------------------
+class BigReaderRWMutex: public IRWMutex
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param prefer_readers if true writers give way to readers
+  // ---------------------------------------------------------------------------
+  BigReaderRWMutex(bool prefer_readers = false);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~BigReaderRWMutex() = default;
+
+  //----------------------------------------------------------------------------
+  //! Move constructor
+  //----------------------------------------------------------------------------
+  BigReaderRWMutex(BigReaderRWMutex&& other) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Move assignment operator
+  //----------------------------------------------------------------------------
+  BigReaderRWMutex& operator=(BigReaderRWMutex&& other) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Copy constructor
+  //----------------------------------------------------------------------------
+  BigReaderRWMutex(const BigReaderRWMutex&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Copy assignment operator
+  //----------------------------------------------------------------------------
+  BigReaderRWMutex& operator=(const BigReaderRWMutex&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Lock for read
+  //----------------------------------------------------------------------------
+  int LockRead() override;
+
+  //----------------------------------------------------------------------------
+  //! Unlock a read lock
+  //----------------------------------------------------------------------------
+  int UnLockRead() override;
+
+  //----------------------------------------------------------------------------
+  //! Try to read lock the mutex within the timeout
+  //!
+  //! @param timeout_ns nano seconds timeout
+  //!
+  //! @return 0 if successful, otherwise error number
+  //----------------------------------------------------------------------------
+  int TimedRdLock(uint64_t timeout_ns) override;
+
+  //----------------------------------------------------------------------------
+  //! Lock for write
+  //----------------------------------------------------------------------------
+  int LockWrite() override;
+
+  //----------------------------------------------------------------------------
+  //! Unlock a write lock
+  //----------------------------------------------------------------------------
+  int UnLockWrite() override;
+
+  //----------------------------------------------------------------------------
+  //! Try to write lock the mutex within the timeout
+  //!
+  //! @param timeout_ns nano seconds timeout
+  //!
+  //! @return 0 if successful, otherwise error number
+  //----------------------------------------------------------------------------
+  int TimedWrLock(uint64_t timeout_ns) override;
+
+  static constexpr size_t kNumSlots = 64; ///< Number of reader slots
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  //----------------------------------------------------------------------------
+  //! Reader slot padded to a cache line
+  //----------------------------------------------------------------------------
+  struct alignas(64) ReaderSlot {
+    std::atomic<int64_t> mCount {0};
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the reader slot of the calling thread
+  //----------------------------------------------------------------------------
+  ReaderSlot& GetSlot();
+
+  //----------------------------------------------------------------------------
+  //! Read lock, optionally bounded by a deadline
+  //!
+  //! @return 0 if successful, otherwise ETIMEDOUT
+  //----------------------------------------------------------------------------
+  int DoLockRead(const Clock::time_point* deadline);
+
+  //----------------------------------------------------------------------------
+  //! Mark writer active and wait for all readers to drain. Must be called
+  //! after the writer ownership was acquired.
+  //!
+  //! @return true if successful, false if deadline expired in which case the
+  //!         writer flag is cleared again
+  //----------------------------------------------------------------------------
+  bool AcquireWriter(const Clock::time_point* deadline);
+
+  //----------------------------------------------------------------------------
+  //! Clear writer flag and wake up waiting readers
+  //----------------------------------------------------------------------------
+  void ReleaseWriter();
+
+  //----------------------------------------------------------------------------
+  //! Acquire writer ownership which serializes writers, optionally bounded
+  //! by a deadline
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool AcquireOwnership(const Clock::time_point* deadline);
+
+  //----------------------------------------------------------------------------
+  //! Release writer ownership
+  //----------------------------------------------------------------------------
+  void ReleaseOwnership();
+
+  //----------------------------------------------------------------------------
+  //! Check if there is any registered reader
+  //----------------------------------------------------------------------------
+  bool HasReaders() const;
+
+  ReaderSlot mSlots[kNumSlots]; ///< Per-thread reader counters
+  alignas(64) std::atomic<bool> mWriter; ///< Writer holds or acquires lock
+  std::mutex mWaitMutex; ///< Mutex used by threads waiting for a writer
+  std::condition_variable mWaitCv; ///< Signal readers that writer is done
+  std::condition_variable mWrCv; ///< Signal writers that writer is done
+  bool mWrOwned; ///< A writer owns the lock, protected by mWaitMutex
+  bool mPreferReaders; ///< Writers give way to readers if true
+};
+
+EOSCOMMONNAMESPACE_END
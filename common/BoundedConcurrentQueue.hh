@@ -0,0 +1,335 @@
+// ----------------------------------------------------------------------
+//! @file BoundedConcurrentQueue.hh
+//! @brief Bounded lock-free multi-producer multi-consumer queue
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "common/Namespace.hh"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Event count letting threads sleep until a condition they polled changes,
+//! without taking a lock on the notification path unless somebody waits.
+//!
+//! A waiter calls PrepareWait, checks its condition once more and then either
+//! CancelWait or Wait with the returned key. Notifications issued after
+//! PrepareWait are never lost.
+//------------------------------------------------------------------------------
+class EventCount
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Announce the intention to wait
+  //!
+  //! @return key to pass to Wait
+  //----------------------------------------------------------------------------
+  inline uint64_t PrepareWait()
+  {
+    mWaiters.fetch_add(1);
+    // Pairs with the fence in Notify*, either the waiter sees the change of
+    // the condition or the notifier sees the waiter
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return mEpoch.load();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Give up waiting, the condition became true in the meantime
+  //----------------------------------------------------------------------------
+  inline void CancelWait()
+  {
+    mWaiters.fetch_sub(1);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Sleep until notified after the PrepareWait call which returned key
+  //----------------------------------------------------------------------------
+  void Wait(uint64_t key)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+
+      while (mEpoch.load() == key) {
+        mCond.wait(lock);
+      }
+    }
+    mWaiters.fetch_sub(1);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Wake up one waiter, if any
+  //----------------------------------------------------------------------------
+  inline void NotifyOne()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (mWaiters.load()) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mEpoch.fetch_add(1);
+      mCond.notify_one();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Wake up all the waiters
+  //----------------------------------------------------------------------------
+  inline void NotifyAll()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (mWaiters.load()) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mEpoch.fetch_add(1);
+      mCond.notify_all();
+    }
+  }
+
+private:
+  std::atomic<uint64_t> mEpoch {0}; ///< Changed by every notification
+  std::atomic<uint32_t> mWaiters {0}; ///< Threads between Prepare and Wait end
+  std::mutex mMutex;
+  std::condition_variable mCond;
+};
+
+//------------------------------------------------------------------------------
+//! Bounded lock-free multi-producer multi-consumer queue with the interface
+//! of ConcurrentQueue. The elements are kept in a ring of cells, each with a
+//! sequence number telling producers and consumers whose turn it is, so that
+//! push and pop only contend on one atomic increment. Producers block while
+//! the queue is full, consumers while it is empty, both sleep on an event
+//! count which is only signalled if somebody actually waits.
+//------------------------------------------------------------------------------
+template <typename Data>
+class BoundedConcurrentQueue
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param capacity max number of elements, rounded up to a power of two
+  //----------------------------------------------------------------------------
+  explicit BoundedConcurrentQueue(size_t capacity = 1024):
+    mMask(RoundUp(capacity) - 1), mCells(new Cell[mMask + 1])
+  {
+    for (size_t i = 0; i <= mMask; ++i) {
+      mCells[i].mSeq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedConcurrentQueue(const BoundedConcurrentQueue&) = delete;
+  BoundedConcurrentQueue& operator=(const BoundedConcurrentQueue&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Get max number of elements
+  //----------------------------------------------------------------------------
+  inline size_t capacity() const
+  {
+    return mMask + 1;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get size of the queue, only a snapshot while used concurrently
+  //----------------------------------------------------------------------------
+  size_t size() const
+  {
+    size_t tail = mDequeuePos.load(std::memory_order_acquire);
+    size_t head = mEnqueuePos.load(std::memory_order_acquire);
+    return (head > tail) ? (head - tail) : 0;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Test if queue is empty
+  //----------------------------------------------------------------------------
+  inline bool empty()
+  {
+    return (size() == 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Push data to the queue, blocking while the queue is full
+  //----------------------------------------------------------------------------
+  void push(Data& data)
+  {
+    while (!try_push(data)) {
+      uint64_t key = mNotFull.PrepareWait();
+
+      if (try_push(data)) {
+        mNotFull.CancelWait();
+        return;
+      }
+
+      mNotFull.Wait(key);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Push data to the queue if queue size is less then max_size
+  //!
+  //! @param data object to be pushed in the queue
+  //! @param max_size max size allowed of the queue
+  //!
+  //! @return true if pushed, false if there are too many elements
+  //----------------------------------------------------------------------------
+  bool push_size(Data& data, size_t max_size)
+  {
+    if (size() > max_size) {
+      return false;
+    }
+
+    return try_push(data);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Push data to the queue unless it is full
+  //!
+  //! @return true if pushed, otherwise false
+  //----------------------------------------------------------------------------
+  bool try_push(Data& data)
+  {
+    size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+
+    while (true) {
+      cell = &mCells[pos & mMask];
+      size_t seq = cell->mSeq.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+
+      if (diff == 0) {
+        if (mEnqueuePos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = mEnqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->mData = data;
+    cell->mSeq.store(pos + 1, std::memory_order_release);
+    mNotEmpty.NotifyOne();
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Try to get data from queue
+  //!
+  //! @return true if an element was popped, false if the queue is empty
+  //----------------------------------------------------------------------------
+  bool try_pop(Data& popped_value)
+  {
+    size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+
+    while (true) {
+      cell = &mCells[pos & mMask];
+      size_t seq = cell->mSeq.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t) seq - (intptr_t)(pos + 1);
+
+      if (diff == 0) {
+        if (mDequeuePos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = mDequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    popped_value = std::move(cell->mData);
+    // Do not keep resources of the popped element alive in the ring
+    cell->mData = Data();
+    cell->mSeq.store(pos + mMask + 1, std::memory_order_release);
+    mNotFull.NotifyOne();
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get data from queue, if empty queue then block until at least one element
+  //! is added
+  //----------------------------------------------------------------------------
+  void wait_pop(Data& popped_value)
+  {
+    while (!try_pop(popped_value)) {
+      uint64_t key = mNotEmpty.PrepareWait();
+
+      if (try_pop(popped_value)) {
+        mNotEmpty.CancelWait();
+        return;
+      }
+
+      mNotEmpty.Wait(key);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove all elements from the queue
+  //----------------------------------------------------------------------------
+  void clear()
+  {
+    Data data;
+
+    while (try_pop(data)) {}
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Slot of the ring
+  //----------------------------------------------------------------------------
+  struct Cell {
+    std::atomic<size_t> mSeq;
+    Data mData;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Round up to the next power of two
+  //----------------------------------------------------------------------------
+  static size_t RoundUp(size_t value)
+  {
+    size_t result = 2;
+
+    while (result < value) {
+      result <<= 1;
+    }
+
+    return result;
+  }
+
+  const size_t mMask;
+  std::unique_ptr<Cell[]> mCells;
+  //! Positions on separate cache lines, producers and consumers do not
+  //! invalidate each other
+  alignas(64) std::atomic<size_t> mEnqueuePos {0};
+  alignas(64) std::atomic<size_t> mDequeuePos {0};
+  alignas(64) EventCount mNotEmpty;
+  EventCount mNotFull;
+};
+
+EOSCOMMONNAMESPACE_END
@@ -229,7 +229,7 @@ private:
   //! db is a pointer to the db manager of the data
   //! the TDmapInterface is not supposed to be thread-safe. So db must be protected by a lock.
   // ------------------------------------------------------------------------
-  TDbMapInterface* pDb;
+  DbMapInterface* pDb;
 
   // ------------------------------------------------------------------------
   //! this is mutex at instance granularity
@@ -400,6 +400,10 @@ protected:
       Tmap::const_iterator it = pSetSeqMap.find(keystr);
 
       if (it != pSetSeqMap.end()) {
+        if (it->second.seqid == 0) {
+          return false;
+        }
+
         *val = (it->second);
         return true;
       }
@@ -434,7 +438,8 @@ protected:
     if (pSetSequence) {
       std::string keystr(key.ToString());
       pSetSeqList.push_back(Tkeyval(keystr, val));
-      pSetSeqMap.erase(keystr);
+      // Keep the removal so that the entry is not read back from the db
+      pSetSeqMap[keystr] = val;
       return pSetSeqList.size();
     } else {
       if (doRemove(key, val)) {
@@ -646,10 +651,19 @@ public:
   //! Constructor
   //----------------------------------------------------------------------------
   DbMapT():
+    DbMapT(new TDbMapInterface())
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Constructor using another db implementation than the default one
+  //!
+  //! @param db db interface, the DbMap takes ownership of it
+  //----------------------------------------------------------------------------
+  explicit DbMapT(DbMapInterface* db):
     pUseMap(true), pUseSeqId(true),
     pSetSequence(false), pNestedSetSeq(0)
   {
-    pDb = new TDbMapInterface();
+    pDb = db;
     char buffer[32];
     sprintf(buffer, "dbmap%p", this);
     pName = buffer;
@@ -681,7 +695,7 @@ public:
     gNamesMutex.LockWrite();
     gNames.erase(pName);
     gNamesMutex.UnLockWrite();
-    delete static_cast<TDbMapInterface*>(pDb);
+    delete pDb;
   }
 
   //----------------------------------------------------------------------------
@@ -994,6 +1008,17 @@ public:
     return 0;
   }
 
+  //----------------------------------------------------------------------------
+  //! Sync the writes of set sequences to disk before endSetSequence returns
+  //!
+  //! @param sync if true sync the writes, otherwise leave it to the OS
+  //----------------------------------------------------------------------------
+  void setSyncSetSequence(bool sync)
+  {
+    RWMutexWriteLock lock(pMutex);
+    pDb->setSyncTransactions(sync);
+  }
+
   // ------------------------------------------------------------------------
   //! Get the underlying db system
   //! @return a string containing the name of the underlying db system
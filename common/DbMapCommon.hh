@@ -478,6 +478,14 @@ public:
   //----------------------------------------------------------------------------
   virtual bool endTransaction() = 0;
 
+  //----------------------------------------------------------------------------
+  //! Sync the writes of the transactions to disk before endTransaction
+  //! returns, by default the implementations leave it to the OS
+  //!
+  //! @param sync if true sync the writes
+  //----------------------------------------------------------------------------
+  virtual void setSyncTransactions(bool sync) {}
+
   // Data Content Persistency
 
   //----------------------------------------------------------------------------
@@ -660,7 +660,7 @@ bool LvDbDbLogInterface::clear()
 }
 
 LvDbDbMapInterface::LvDbDbMapInterface() :
-  pNDbEntries(0) , pBatched(false), AttachedDb(0)
+  pNDbEntries(0) , pBatched(false), pSyncTransactions(false), AttachedDb(0)
 {
 }
 
@@ -781,7 +781,9 @@ LvDbDbMapInterface::endTransaction()
       SizeHandler handler(this);
       pDbBatch.Iterate(&handler);
       pNDbEntries += handler.GetDiff();
-      status = AttachedDb->Write(leveldb::WriteOptions(), &pDbBatch);
+      leveldb::WriteOptions wopt;
+      wopt.sync = pSyncTransactions;
+      status = AttachedDb->Write(wopt, &pDbBatch);
       TestLvDbError(status, this);
       pDbBatch.Clear();
     }
@@ -266,6 +266,7 @@ class LvDbDbMapInterface : public LvDbInterfaceBase, public DbMapInterface
   leveldb::WriteBatch pExportBatch;
   leveldb::WriteBatch pDbBatch;
   bool pBatched;
+  bool pSyncTransactions;
 
   typedef std::pair<LvDbDbLogInterface*, bool> tOwnedLDLIptr; // pointer, ownit
   std::map<std::string, tOwnedLDLIptr> pAttachedDbs;
@@ -284,6 +285,11 @@ public:
   virtual const std::string& getName() const;
   virtual bool beginTransaction();
   virtual bool endTransaction();
+  //! If true, the write of a transaction is synced to disk before returning
+  virtual void setSyncTransactions(bool sync)
+  {
+    pSyncTransactions = sync;
+  }
   virtual bool getEntry(const Slice& key, Tval* val);
   virtual bool setEntry(const Slice& key, const TvalSlice& val);
   virtual bool removeEntry(const Slice& key, const TvalSlice& val);
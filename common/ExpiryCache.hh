@@ -40,6 +40,10 @@ public:
 //!        Before expiry, the data in cache is not updated and request is served from cache instantly.
 //!        After expiry and before invalidity, data is served from cache instantly and asynchronous update is issued.
 //!        After invalidity (or in case of a forced update), update is synchronous, and client waits for it to happen.
+//!        With an update timeout (stale-while-revalidate mode), updates always run in a background thread, one at a
+//!        time. Clients needing an update wait at most the timeout, then a forced update is served the data in cache
+//!        if it is not invalid, otherwise an UpdateException is thrown: the invalidity time is the hard maximum
+//!        staleness.
 //! @tparam T type of the object to be stored in the cache
 template <typename T>
 class ExpiryCache {
@@ -49,6 +53,7 @@ private:
   std::atomic_bool mIsUpdatePending{false};
   std::atomic<std::chrono::seconds> mExpiredAfter;
   std::atomic<std::chrono::seconds> mInvalidAfter;
+  std::atomic<std::chrono::milliseconds> mUpdateTimeout;
   std::chrono::time_point<std::chrono::steady_clock> mUpdatedAt = std::chrono::steady_clock::now();
 
   std::shared_future<void> mUpdateFuture;
@@ -80,14 +85,32 @@ private:
     return false;
   }
 
+  //! @brief Check if the updates run in the background with a timeout
+  bool IsNonBlocking() const {
+    return mUpdateTimeout.load() != std::chrono::milliseconds::max();
+  }
+
 public:
   //! @brief Construct a cache object
   //! @param expiredAfter expiry time, after this data is served from cache instantly and asynchronous update is issued
   //! @param invalidAfter invalidity time, after this the data is no longer served from cache, the client will wait for a synchronous update, never by default
-  explicit ExpiryCache(std::chrono::seconds expiredAfter, std::chrono::seconds invalidAfter = std::chrono::seconds::max())
-    : mExpiredAfter(expiredAfter), mInvalidAfter(invalidAfter > expiredAfter ? invalidAfter : std::chrono::seconds::max())
+  //! @param updateTimeout max time a client waits for an update, no timeout by default
+  explicit ExpiryCache(std::chrono::seconds expiredAfter, std::chrono::seconds invalidAfter = std::chrono::seconds::max(),
+                       std::chrono::milliseconds updateTimeout = std::chrono::milliseconds::max())
+    : mExpiredAfter(expiredAfter), mInvalidAfter(invalidAfter > expiredAfter ? invalidAfter : std::chrono::seconds::max()),
+      mUpdateTimeout(updateTimeout)
   {}
 
+  //! @brief Destructor, waits for an update running in the background
+  ~ExpiryCache() {
+    eos::common::RWMutexReadLock promiseLock(mUpdatePromiseLock);
+
+    if (mUpdateFuture.valid() &&
+        mUpdateFuture.wait_for(std::chrono::seconds(0)) != std::future_status::deferred) {
+      mUpdateFuture.wait();
+    }
+  }
+
   //! @brief Set the expiry time, only changed if expiry < invalidity relation remains
   //! @param expiredAfter expiry time
   void SetExpiredAfter(std::chrono::seconds expiredAfter) {
@@ -102,25 +125,35 @@ public:
       mInvalidAfter.store(invalidAfter);
   }
 
+  //! @brief Set the update timeout, milliseconds::max() to wait for the updates like before
+  //! @param updateTimeout max time a client waits for an update
+  void SetUpdateTimeout(std::chrono::milliseconds updateTimeout) {
+    mUpdateTimeout.store(updateTimeout);
+  }
+
   //! @brief Request for the cached data.
   //! @tparam Functor type of the updating function object
   //! @tparam ARGS variadic template type for the arguments
   //! @param forceUpdate tells whether it should be a forced update
   //! @param produceObject function object to call for an update, it has to return a pointer to the new object
-  //! @param params variadic parameters, will be perfect forwarded to the updating function
+  //! @param params variadic parameters, will be perfect forwarded to the updating function. An update can outlive
+  //!        the call, so the function object and the parameters are copied, pass std::ref only for objects which
+  //!        outlive the cache
   //! @return the object in the cache
   template<typename Functor, typename... ARGS>
   typename std::remove_reference<T>::type getCachedObject(bool forceUpdate, Functor&& produceObject, ARGS&&... params) {
     bool isInvalid = false;
+    bool nonBlocking = IsNonBlocking();
+
     if (IsUpdateNeeded(forceUpdate, isInvalid)) {
       eos::common::RWMutexWriteLock promiseLock(mUpdatePromiseLock);
       if (IsUpdateNeeded(forceUpdate, isInvalid)) {
         mIsUpdatePending = true;
         mUpdateFuture = std::async(
-          isInvalid ? std::launch::deferred : std::launch::async,
-          [&](ARGS&& ... params) {
+          (isInvalid && !nonBlocking) ? std::launch::deferred : std::launch::async,
+          [this](typename std::decay<Functor>::type producer, typename std::decay<ARGS>::type... args) {
             try {
-              T* updatedObject = produceObject(std::forward<ARGS>(params)...);
+              T* updatedObject = producer(args...);
               if (updatedObject != nullptr) {
                 eos::common::RWMutexWriteLock lock(mObjectLock);
                 mCachedObject.reset(updatedObject);
@@ -129,16 +162,36 @@ public:
             } catch (...) {}
             mIsUpdatePending = false;
           },
+          std::forward<Functor>(produceObject),
           std::forward<ARGS>(params)...
         );
       }
     }
 
     if(isInvalid) {
-      eos::common::RWMutexReadLock promiseLock(mUpdatePromiseLock);
-      mUpdateFuture.get();
+      std::shared_future<void> updateFuture;
+      {
+        eos::common::RWMutexReadLock promiseLock(mUpdatePromiseLock);
+        updateFuture = mUpdateFuture;
+      }
+
+      if (updateFuture.valid()) {
+        if (nonBlocking) {
+          updateFuture.wait_for(mUpdateTimeout.load());
+        } else {
+          updateFuture.get();
+        }
+      }
     }
+
     eos::common::RWMutexReadLock lock(mObjectLock);
+
+    if (nonBlocking && mCachedObject &&
+        (std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - mUpdatedAt) >=
+         mInvalidAfter.load())) {
+      throw UpdateException("Could not update the data in time, the data present is invalid.");
+    }
+
     return mCachedObject ? *mCachedObject : throw UpdateException("Could not update the data, no valid data is present.");
   }
 };
@@ -34,7 +34,7 @@ EOSCOMMONNAMESPACE_BEGIN
 // Constructor
 //------------------------------------------------------------------------------
 JeMallocHandler::JeMallocHandler():
-  mallctl(0)
+  mallctl(0), malloc_stats_print(0)
 {
   pJeMallocLoaded = IsJemallocLoader();
   pCanProfile = pJeMallocLoaded ? IsProfEnabled() : false;
@@ -73,6 +73,13 @@ bool JeMallocHandler::IsJemallocLoader()
     } else {
       isloaded = false;
     }
+
+    void* pstatsprint = dlsym(handle, "malloc_stats_print");
+
+    if (dlerror() == NULL) {
+      malloc_stats_print = reinterpret_cast<void (*)(void (*)(void*, const char*),
+                           void*, const char*)>(pstatsprint);
+    }
   }
 
   dlclose(handle);
@@ -122,4 +129,73 @@ bool JeMallocHandler::DumpProfile()
   return mallctl("prof.dump", NULL, NULL, NULL, 0) == 0;
 }
 
+bool JeMallocHandler::DumpProfile(const std::string& path)
+{
+  if (path.empty()) {
+    return DumpProfile();
+  }
+
+  const char* fn = path.c_str();
+  return mallctl("prof.dump", NULL, NULL, &fn, sizeof(const char*)) == 0;
+}
+
+bool JeMallocHandler::GetCounters(uint64_t& allocated, uint64_t& active,
+                                  uint64_t& resident)
+{
+  if (!pJeMallocLoaded) {
+    return false;
+  }
+
+  // The statistics are a snapshot taken when the epoch is advanced
+  uint64_t epoch = 1;
+  size_t s = sizeof(epoch);
+
+  if (mallctl("epoch", &epoch, &s, &epoch, sizeof(epoch))) {
+    return false;
+  }
+
+  size_t value = 0;
+  s = sizeof(value);
+
+  if (mallctl("stats.allocated", &value, &s, NULL, 0)) {
+    return false;
+  }
+
+  allocated = value;
+
+  if (mallctl("stats.active", &value, &s, NULL, 0)) {
+    return false;
+  }
+
+  active = value;
+
+  if (mallctl("stats.resident", &value, &s, NULL, 0)) {
+    return false;
+  }
+
+  resident = value;
+  return true;
+}
+
+namespace
+{
+void AppendStats(void* opaque, const char* msg)
+{
+  static_cast<std::string*>(opaque)->append(msg);
+}
+}
+
+bool JeMallocHandler::GetStats(std::string& out, bool per_arena)
+{
+  out.clear();
+
+  if (!pJeMallocLoaded || !malloc_stats_print) {
+    return false;
+  }
+
+  // 'a' leaves out the arenas, 'b' and 'l' the bins and large size classes
+  malloc_stats_print(AppendStats, &out, per_arena ? "bl" : "abl");
+  return true;
+}
+
 EOSCOMMONNAMESPACE_END
@@ -26,6 +26,8 @@
 
 #include "common/Namespace.hh"
 #include <cstddef>
+#include <cstdint>
+#include <string>
 
 EOSCOMMONNAMESPACE_BEGIN
 
@@ -38,6 +40,7 @@ class JeMallocHandler
   bool pCanProfile;
   bool pProfRunning;
   int (*mallctl)(const char*, void*, size_t*, void*, size_t);
+  void (*malloc_stats_print)(void (*)(void*, const char*), void*, const char*);
 
   bool IsJemallocLoader();
 
@@ -67,6 +70,38 @@ public:
   bool StartProfiling();
   bool StopProfiling();
   bool DumpProfile();
+
+  //----------------------------------------------------------------------------
+  //! Dump the heap profile to the given file instead of the automatically
+  //! named one in the prof_prefix directory
+  //!
+  //! @param path output file, empty for the default name
+  //!
+  //! @return true if dumped, otherwise false
+  //----------------------------------------------------------------------------
+  bool DumpProfile(const std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Get the process wide allocation counters, refreshed before reading
+  //!
+  //! @param allocated bytes allocated by the application
+  //! @param active bytes in the pages holding allocations
+  //! @param resident bytes of physically resident pages of the allocator
+  //!
+  //! @return true if read, otherwise false
+  //----------------------------------------------------------------------------
+  bool GetCounters(uint64_t& allocated, uint64_t& active, uint64_t& resident);
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics report of malloc_stats_print
+  //!
+  //! @param out report
+  //! @param per_arena also report every arena, bins and large size classes
+  //!        are left out in both cases
+  //!
+  //! @return true if jemalloc is loaded, otherwise false
+  //----------------------------------------------------------------------------
+  bool GetStats(std::string& out, bool per_arena);
 };
 
 EOSCOMMONNAMESPACE_END
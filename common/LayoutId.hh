@@ -176,7 +176,7 @@ public:
   //! Build a layout id from given parameters
   //--------------------------------------------------------------------------
 
-  static unsigned long
+  static constexpr unsigned long
   GetId(int layout,
         int checksum = 1,
         int stripesize = 1,
@@ -213,7 +213,7 @@ public:
   //! Convert the blocksize enum to bytes
   //--------------------------------------------------------------------------
 
-  static unsigned long
+  static constexpr unsigned long
   BlockSize(int blocksize)
   {
     if (blocksize == k4k) {
@@ -299,7 +299,7 @@ public:
   //! Get Checksum enum from given layout
   //--------------------------------------------------------------------------
 
-  static unsigned long
+  static constexpr unsigned long
   GetChecksum(unsigned long layout)
   {
     return (layout & 0xf);
@@ -310,7 +310,7 @@ public:
   //! Get Length of Layout checksum in bytes
   //--------------------------------------------------------------------------
 
-  static unsigned long
+  static constexpr unsigned long
   GetChecksumLen(unsigned long layout)
   {
     if ((layout & 0xf) == kAdler) {
@@ -382,7 +382,7 @@ public:
   //--------------------------------------------------------------------------
   //! Return layout type enum
   //--------------------------------------------------------------------------
-  static unsigned long
+  static constexpr unsigned long
   GetLayoutType(unsigned long layout)
   {
     return ((layout >> 4) & 0xf);
@@ -417,7 +417,7 @@ public:
   //--------------------------------------------------------------------------
   //! Return layout stripe enum
   //--------------------------------------------------------------------------
-  static unsigned long
+  static constexpr unsigned long
   GetStripeNumber(unsigned long layout)
   {
     return ((layout >> 8) & 0xff);
@@ -439,7 +439,7 @@ public:
   //--------------------------------------------------------------------------
   //! Return layout blocksize in bytes
   //--------------------------------------------------------------------------
-  static unsigned long
+  static constexpr unsigned long
   GetBlocksize(unsigned long layout)
   {
     return BlockSize(((layout >> 16) & 0xf));
@@ -448,7 +448,7 @@ public:
   //--------------------------------------------------------------------------
   //! Return layout blocksize enum
   //--------------------------------------------------------------------------
-  static unsigned long
+  static constexpr unsigned long
   GetBlocksizeType(unsigned long layout)
   {
     return ((layout >> 16) & 0xf);
@@ -457,7 +457,7 @@ public:
   //--------------------------------------------------------------------------
   //! Return layout checksum enum
   //--------------------------------------------------------------------------
-  static unsigned long
+  static constexpr unsigned long
   GetBlockChecksum(unsigned long layout)
   {
     // disable block checksum in replica layouts
@@ -497,7 +497,7 @@ public:
   //--------------------------------------------------------------------------
   //! Return excess replicas
   //--------------------------------------------------------------------------
-  static unsigned long
+  static constexpr unsigned long
   GetExcessStripeNumber(unsigned long layout)
   {
     return ((layout >> 24) & 0xf);
@@ -506,7 +506,7 @@ public:
   //--------------------------------------------------------------------------
   //! Return redundancy stripes
   //--------------------------------------------------------------------------
-  static unsigned long
+  static constexpr unsigned long
   GetRedundancyStripeNumber(unsigned long layout)
   {
     return ((layout >> 28) & 0x7);
@@ -524,7 +524,7 @@ public:
   //--------------------------------------------------------------------------
   //! Return length of checksum
   //--------------------------------------------------------------------------
-  static unsigned long
+  static constexpr unsigned long
   GetBlockChecksumLen(unsigned long layout)
   {
     return GetChecksumLen((layout >> 20) & 0xf);
@@ -534,7 +534,7 @@ public:
   //! Return multiplication factor for a given layout e.g. the physical space
   //! factor for a given layout
   //--------------------------------------------------------------------------
-  static double
+  static constexpr double
   GetSizeFactor(unsigned long layout)
   {
     if (GetLayoutType(layout) == kPlain) {
@@ -567,7 +567,7 @@ public:
   //! Return minimum number of replicas which have to be online for a layout
   //! to be readable
   //--------------------------------------------------------------------------
-  static size_t
+  static constexpr size_t
   GetMinOnlineReplica(unsigned long layout)
   {
     if (GetLayoutType(layout) == kRaidDP) {
@@ -589,7 +589,7 @@ public:
   //! Return number of replicas which have to be online for a layout to be
   //! immediately writable
   //--------------------------------------------------------------------------
-  static unsigned long
+  static constexpr unsigned long
   GetOnlineStripeNumber(unsigned long layout)
   {
     if (GetLayoutType(layout) == kRaidDP) {
@@ -1253,6 +1253,54 @@ public:
   ~LayoutId();
 };
 
+//------------------------------------------------------------------------------
+//! Layout id decoded once together with the values derived from it, for the
+//! hot paths asking for several properties of the same layout. Being a
+//! literal type, descriptors of constant layout ids are built at compile time.
+//------------------------------------------------------------------------------
+struct LayoutDescriptor {
+  constexpr explicit LayoutDescriptor(unsigned long layout = 0):
+    mLayoutId(layout),
+    mType(LayoutId::GetLayoutType(layout)),
+    mChecksum(LayoutId::GetChecksum(layout)),
+    mChecksumLen(LayoutId::GetChecksumLen(layout)),
+    mStripes(LayoutId::GetStripeNumber(layout) + 1),
+    mExcessStripes(LayoutId::GetExcessStripeNumber(layout)),
+    mRedundancyStripes(LayoutId::GetRedundancyStripeNumber(layout)),
+    mBlocksizeType(LayoutId::GetBlocksizeType(layout)),
+    mBlocksize(LayoutId::GetBlocksize(layout)),
+    mBlockChecksum(LayoutId::GetBlockChecksum(layout)),
+    mBlockChecksumLen(LayoutId::GetBlockChecksumLen(layout)),
+    mSizeFactor(LayoutId::GetSizeFactor(layout)),
+    mMinOnlineReplica(LayoutId::GetMinOnlineReplica(layout)),
+    mOnlineStripes(LayoutId::GetOnlineStripeNumber(layout))
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Check if the layout is one of the RAIN layouts
+  //----------------------------------------------------------------------------
+  constexpr bool IsRain() const
+  {
+    return ((mType == LayoutId::kRaidDP) || (mType == LayoutId::kRaid6) ||
+            (mType == LayoutId::kArchive));
+  }
+
+  unsigned long mLayoutId; ///< layout id decoded
+  unsigned long mType; ///< layout type enum
+  unsigned long mChecksum; ///< file checksum enum
+  unsigned long mChecksumLen; ///< file checksum length in bytes
+  unsigned long mStripes; ///< number of stripes, not the stripe enum
+  unsigned long mExcessStripes; ///< excess replicas
+  unsigned long mRedundancyStripes; ///< parity stripes
+  unsigned long mBlocksizeType; ///< blocksize enum
+  unsigned long mBlocksize; ///< blocksize in bytes
+  unsigned long mBlockChecksum; ///< block checksum enum, none for replicas
+  unsigned long mBlockChecksumLen; ///< block checksum length in bytes
+  double mSizeFactor; ///< physical space factor, see GetSizeFactor
+  size_t mMinOnlineReplica; ///< stripes needed online to read
+  unsigned long mOnlineStripes; ///< stripes needed online to write
+};
+
 EOSCOMMONNAMESPACE_END
 
 #endif
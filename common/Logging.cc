@@ -24,11 +24,15 @@
 #include "common/Namespace.hh"
 #include "common/Logging.hh"
 #include "XrdSys/XrdSysPthread.hh"
+#include <algorithm>
+#include <chrono>
 #include <new>
 #include <type_traits>
+#include <unistd.h>
 
 EOSCOMMONNAMESPACE_BEGIN
 
+constexpr uint64_t Logging::kAsyncRingSize;
 static std::atomic<int> sCounter {0};
 static typename std::aligned_storage<sizeof(Logging), alignof(Logging)>::type
 logging_buf; ///< Memory for the global logging object
@@ -68,7 +72,8 @@ Logging::GetInstance()
 //------------------------------------------------------------------------------
 Logging::Logging():
   gLogMask(0), gPriorityLevel(0), gToSysLog(false),  gUnit("none"),
-  gShortFormat(0)
+  gShortFormat(0), mAsync(false), mAsyncPid(0), mAsyncRunning(false),
+  mAsyncHead(0), mAsyncTail(0), mAsyncDropped(0)
 {
   // Initialize the log array and sets the log circular size
   gLogCircularIndex.resize(LOG_DEBUG + 1);
@@ -91,6 +96,157 @@ Logging::Logging():
       gToSysLog = true;
     }
   }
+
+  // The writer thread is started when the first line is logged
+  const char* ptr = getenv("EOS_LOG_ASYNC");
+
+  if (ptr && ((strcmp(ptr, "1") == 0) || (strcmp(ptr, "true") == 0))) {
+    mAsync = true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+Logging::~Logging()
+{
+  StopAsync();
+}
+
+//------------------------------------------------------------------------------
+// Enable or disable the asynchronous mode
+//------------------------------------------------------------------------------
+void
+Logging::SetAsync(bool onoff)
+{
+  XrdSysMutexHelper scope_lock(gMutex);
+
+  if (!onoff) {
+    StopAsync();
+  }
+
+  mAsync = onoff;
+}
+
+//------------------------------------------------------------------------------
+// Stop the writer thread after writing all the buffered lines
+//------------------------------------------------------------------------------
+void
+Logging::StopAsync()
+{
+  if (mAsyncThread.joinable() && (mAsyncPid == getpid())) {
+    mAsyncRunning = false;
+    mAsyncThread.join();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Write a formatted line directly or through the writer thread
+//------------------------------------------------------------------------------
+void
+Logging::Output(FILE* fd, const char* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+
+  if (mAsync && !mAsyncThread.joinable()) {
+    try {
+      mAsyncRing.resize(kAsyncRingSize);
+      mAsyncRunning = true;
+      mAsyncPid = getpid();
+      mAsyncThread = std::thread(&Logging::AsyncWriter, this);
+    } catch (const std::system_error& e) {
+      mAsync = false;
+    }
+  }
+
+  // Forked children don't inherit the writer thread
+  if (!mAsync || (mAsyncPid != getpid())) {
+    vfprintf(fd, format, args);
+    fflush(fd);
+    va_end(args);
+    return;
+  }
+
+  uint64_t head = mAsyncHead.load(std::memory_order_relaxed);
+
+  if (head - mAsyncTail.load(std::memory_order_acquire) >= kAsyncRingSize) {
+    ++mAsyncDropped;
+    va_end(args);
+    return;
+  }
+
+  AsyncRecord& rec = mAsyncRing[head % kAsyncRingSize];
+  va_list cargs;
+  va_copy(cargs, args);
+  int len = vsnprintf(nullptr, 0, format, cargs);
+  va_end(cargs);
+
+  if (len > 0) {
+    rec.mFd = fd;
+    rec.mText.resize(len);
+    vsnprintf(&rec.mText[0], len + 1, format, args);
+    mAsyncHead.store(head + 1, std::memory_order_release);
+  }
+
+  va_end(args);
+}
+
+//------------------------------------------------------------------------------
+// Loop of the writer thread
+//------------------------------------------------------------------------------
+void
+Logging::AsyncWriter()
+{
+  std::vector<FILE*> fds;
+  uint64_t reported_drops = 0;
+
+  while (true) {
+    uint64_t head = mAsyncHead.load(std::memory_order_acquire);
+    uint64_t tail = mAsyncTail.load(std::memory_order_relaxed);
+
+    if (head == tail) {
+      if (!mAsyncRunning) {
+        break;
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      continue;
+    }
+
+    // Write the whole batch and flush every destination only once
+    fds.clear();
+
+    for (; tail != head; ++tail) {
+      AsyncRecord& rec = mAsyncRing[tail % kAsyncRingSize];
+      fwrite(rec.mText.data(), 1, rec.mText.length(), rec.mFd);
+
+      if (std::find(fds.begin(), fds.end(), rec.mFd) == fds.end()) {
+        fds.push_back(rec.mFd);
+      }
+
+      // Don't keep the memory of very long lines around
+      if (rec.mText.capacity() > 64 * 1024) {
+        std::string().swap(rec.mText);
+      }
+
+      mAsyncTail.store(tail + 1, std::memory_order_release);
+    }
+
+    uint64_t drops = mAsyncDropped;
+
+    if (drops != reported_drops) {
+      fprintf(stderr, "                 ---- %lu log messages dropped ----\n",
+              (unsigned long)(drops - reported_drops));
+      reported_drops = drops;
+    }
+
+    for (auto fd : fds) {
+      fflush(fd);
+    }
+
+    fflush(stderr);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -169,9 +325,15 @@ Logging::log(const char* func, const char* file, int line, const char* logid,
   static struct timezone tz;
   struct tm tm;
   XrdSysMutexHelper scope_lock(gMutex);
+  gettimeofday(&tv, &tz);
+
+  // Suppressed messages are dropped before paying for their formatting
+  if (!silent && rate_limit(tv, priority, file, line)) {
+    return "";
+  }
+
   va_list args;
   va_start(args, msg);
-  gettimeofday(&tv, &tz);
   current_time = tv.tv_sec;
   static char linen[16];
   sprintf(linen, "%d", line);
@@ -223,10 +385,6 @@ Logging::log(const char* func, const char* file, int line, const char* logid,
   // limit the length of the output to buffer-1 length
   vsnprintf(ptr, logmsgbuffersize - (ptr - buffer + 1), msg, args);
 
-  if (!silent && rate_limit(tv, priority, file, line)) {
-    return "";
-  }
-
   if (!silent && gToSysLog) {
     syslog(priority, "%s", ptr);
   }
@@ -235,45 +393,40 @@ Logging::log(const char* func, const char* file, int line, const char* logid,
     if (gLogFanOut.size()) {
       // we do log-message fanout
       if (gLogFanOut.count("*")) {
-        fprintf(gLogFanOut["*"], "%s\n", buffer);
-        fflush(gLogFanOut["*"]);
+        Output(gLogFanOut["*"], "%s\n", buffer);
       }
 
       if (gLogFanOut.count(File.c_str())) {
         buffer[15] = 0;
-        fprintf(gLogFanOut[File.c_str()], "%s %s%s%s %-30s %s \n",
-                buffer,
-                GetLogColour(GetPriorityString(priority)),
-                GetPriorityString(priority),
-                EOS_TEXTNORMAL,
-                sourceline,
-                ptr);
-        fflush(gLogFanOut[File.c_str()]);
+        Output(gLogFanOut[File.c_str()], "%s %s%s%s %-30s %s \n",
+               buffer,
+               GetLogColour(GetPriorityString(priority)),
+               GetPriorityString(priority),
+               EOS_TEXTNORMAL,
+               sourceline,
+               ptr);
         buffer[15] = ' ';
       } else {
         if (gLogFanOut.count("#")) {
           buffer[15] = 0;
-          fprintf(gLogFanOut["#"], "%s %s%s%s [%05d/%05d] %16s ::%-16s %s \n",
-                  buffer,
-                  GetLogColour(GetPriorityString(priority)),
-                  GetPriorityString(priority),
-                  EOS_TEXTNORMAL,
-                  vid.uid,
-                  vid.gid,
-                  truncname.c_str(),
-                  func,
-                  ptr
-                 );
-          fflush(gLogFanOut["#"]);
+          Output(gLogFanOut["#"], "%s %s%s%s [%05d/%05d] %16s ::%-16s %s \n",
+                 buffer,
+                 GetLogColour(GetPriorityString(priority)),
+                 GetPriorityString(priority),
+                 EOS_TEXTNORMAL,
+                 vid.uid,
+                 vid.gid,
+                 truncname.c_str(),
+                 func,
+                 ptr
+                );
           buffer[15] = ' ';
         }
       }
 
-      fprintf(stderr, "%s\n", buffer);
-      fflush(stderr);
+      Output(stderr, "%s\n", buffer);
     } else {
-      fprintf(stderr, "%s\n", buffer);
-      fflush(stderr);
+      Output(stderr, "%s\n", buffer);
     }
   }
 
@@ -59,6 +59,8 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <atomic>
+#include <thread>
 
 #define SSTR(message) static_cast<std::ostringstream&>(std::ostringstream().flush() << message).str()
 
@@ -97,6 +99,14 @@ EOSCOMMONNAMESPACE_BEGIN
                                             (LOG_ERR), __VA_ARGS__);        \
       }
 
+//------------------------------------------------------------------------------
+//! Check the log mask before the arguments of a log macro are evaluated, so
+//! that masked messages don't pay for building their arguments
+//------------------------------------------------------------------------------
+#define EOS_LOG_ENABLED(__EOSCOMMON_LOG_PRIORITY__) \
+  ((LOG_MASK(__EOSCOMMON_LOG_PRIORITY__) & \
+    eos::common::Logging::GetInstance().GetLogMask()) != 0)
+
 //------------------------------------------------------------------------------
 //! Log Macros usable in objects inheriting from the logId Class
 //------------------------------------------------------------------------------
@@ -105,29 +115,37 @@ EOSCOMMONNAMESPACE_BEGIN
     this->uid, this->gid, this->ruid, this->rgid, this->cident, \
     LOG_MASK(__EOSCOMMON_LOG_PRIORITY__) , __VA_ARGS__
 #define eos_debug(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
-                                          vid, this->cident, (LOG_DEBUG), __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_DEBUG) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
+     vid, this->cident, (LOG_DEBUG), __VA_ARGS__) : "")
 #define eos_info(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
-                                          vid, this->cident, (LOG_INFO), __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_INFO) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
+     vid, this->cident, (LOG_INFO), __VA_ARGS__) : "")
 #define eos_notice(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
-                                          vid, this->cident, (LOG_NOTICE), __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_NOTICE) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
+     vid, this->cident, (LOG_NOTICE), __VA_ARGS__) : "")
 #define eos_warning(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
-            vid, this->cident, (LOG_WARNING), __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_WARNING) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
+     vid, this->cident, (LOG_WARNING), __VA_ARGS__) : "")
 #define eos_err(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
-            vid, this->cident, (LOG_ERR) , __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_ERR) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
+     vid, this->cident, (LOG_ERR) , __VA_ARGS__) : "")
 #define eos_crit(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
-            vid, this->cident, (LOG_CRIT), __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_CRIT) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
+     vid, this->cident, (LOG_CRIT), __VA_ARGS__) : "")
 #define eos_alert(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
-            vid, this->cident, (LOG_ALERT)  , __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_ALERT) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
+     vid, this->cident, (LOG_ALERT)  , __VA_ARGS__) : "")
 #define eos_emerg(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
-                                          vid, this->cident, (LOG_EMERG)  , __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_EMERG) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
+     vid, this->cident, (LOG_EMERG)  , __VA_ARGS__) : "")
 #define eos_silent(...) \
   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, this->logId, \
                                           vid, this->cident, (LOG_SILENT)  , __VA_ARGS__)
@@ -139,29 +157,37 @@ EOSCOMMONNAMESPACE_BEGIN
 //! You should define locally LodId ThreadLogId in the thread function
 //------------------------------------------------------------------------------
 #define eos_thread_debug(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
-                                          vid, ThreadLogId.cident, (LOG_DEBUG)  , __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_DEBUG) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
+     vid, ThreadLogId.cident, (LOG_DEBUG)  , __VA_ARGS__) : "")
 #define eos_thread_info(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
-                                          vid, ThreadLogId.cident, (LOG_INFO)   , __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_INFO) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
+     vid, ThreadLogId.cident, (LOG_INFO)   , __VA_ARGS__) : "")
 #define eos_thread_notice(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
-                                          vid, ThreadLogId.cident, (LOG_NOTICE) , __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_NOTICE) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
+     vid, ThreadLogId.cident, (LOG_NOTICE) , __VA_ARGS__) : "")
 #define eos_thread_warning(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
-                                          vid, ThreadLogId.cident, (LOG_WARNING), __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_WARNING) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
+     vid, ThreadLogId.cident, (LOG_WARNING), __VA_ARGS__) : "")
 #define eos_thread_err(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
-                                          vid, ThreadLogId.cident, (LOG_ERR)    , __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_ERR) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
+     vid, ThreadLogId.cident, (LOG_ERR)    , __VA_ARGS__) : "")
 #define eos_thread_crit(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
-                                          vid, ThreadLogId.cident, (LOG_CRIT)   , __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_CRIT) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
+     vid, ThreadLogId.cident, (LOG_CRIT)   , __VA_ARGS__) : "")
 #define eos_thread_alert(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
-                                          vid, ThreadLogId.cident, (LOG_ALERT)  , __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_ALERT) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
+     vid, ThreadLogId.cident, (LOG_ALERT)  , __VA_ARGS__) : "")
 #define eos_thread_emerg(...) \
+  (EOS_LOG_ENABLED(LOG_EMERG) ? \
    eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, ThreadLogId.logId, \
-                                           vid, ThreadLogId.cident, (LOG_EMERG)  , __VA_ARGS__)
+     vid, ThreadLogId.cident, (LOG_EMERG)  , __VA_ARGS__) : "")
 
 //------------------------------------------------------------------------------
 //! Log Macros usable from static member functions without LogId object
@@ -170,33 +196,56 @@ EOSCOMMONNAMESPACE_BEGIN
   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static", \
     0,0,0,0, "",  (__EOSCOMMON_LOG_PRIORITY__) , __VA_ARGS__
 #define eos_static_debug(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
-                                          eos::common::gLogging.gZeroVid, "", (LOG_DEBUG), __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_DEBUG) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
+     eos::common::gLogging.gZeroVid, "", (LOG_DEBUG), __VA_ARGS__) : "")
 #define eos_static_info(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
-                             eos::common::gLogging.gZeroVid, "", (LOG_INFO), __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_INFO) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
+     eos::common::gLogging.gZeroVid, "", (LOG_INFO), __VA_ARGS__) : "")
 #define eos_static_notice(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
-                                          eos::common::gLogging.gZeroVid, "", (LOG_NOTICE), __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_NOTICE) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
+     eos::common::gLogging.gZeroVid, "", (LOG_NOTICE), __VA_ARGS__) : "")
 #define eos_static_warning(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
-                                          eos::common::gLogging.gZeroVid, "", (LOG_WARNING), __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_WARNING) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
+     eos::common::gLogging.gZeroVid, "", (LOG_WARNING), __VA_ARGS__) : "")
 #define eos_static_err(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
-                                          eos::common::gLogging.gZeroVid, "", (LOG_ERR), __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_ERR) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
+     eos::common::gLogging.gZeroVid, "", (LOG_ERR), __VA_ARGS__) : "")
 #define eos_static_crit(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
-                                          eos::common::gLogging.gZeroVid, "", (LOG_CRIT), __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_CRIT) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
+     eos::common::gLogging.gZeroVid, "", (LOG_CRIT), __VA_ARGS__) : "")
 #define eos_static_alert(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
-                                          eos::common::gLogging.gZeroVid, "", (LOG_ALERT)  , __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_ALERT) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
+     eos::common::gLogging.gZeroVid, "", (LOG_ALERT)  , __VA_ARGS__) : "")
 #define eos_static_emerg(...) \
-  eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
-                                          eos::common::gLogging.gZeroVid,"", (LOG_EMERG)  , __VA_ARGS__)
+  (EOS_LOG_ENABLED(LOG_EMERG) ? \
+   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
+     eos::common::gLogging.gZeroVid,"", (LOG_EMERG)  , __VA_ARGS__) : "")
 #define eos_static_silent(...) \
   eos::common::Logging::GetInstance().log(__FUNCTION__,__FILE__, __LINE__, "static..............................", \
                                           eos::common::gLogging.gZeroVid,"", (LOG_SILENT)  , __VA_ARGS__)
 
+//------------------------------------------------------------------------------
+//! Debug log macros for hot paths like the read/write paths. They are compiled
+//! out when building with -DNO_HOTPATH_DEBUG=1, the arguments are then never
+//! evaluated but still type checked.
+//------------------------------------------------------------------------------
+#ifdef EOS_NO_HOTPATH_DEBUG
+#define eos_hotpath_debug(...) \
+  (false ? (void) eos_debug(__VA_ARGS__) : (void) 0)
+#define eos_static_hotpath_debug(...) \
+  (false ? (void) eos_static_debug(__VA_ARGS__) : (void) 0)
+#else
+#define eos_hotpath_debug(...) eos_debug(__VA_ARGS__)
+#define eos_static_hotpath_debug(...) eos_static_debug(__VA_ARGS__)
+#endif
+
 //------------------------------------------------------------------------------
 //! Log Macros to check if a function would log in a certain log level
 //------------------------------------------------------------------------------
@@ -367,7 +416,7 @@ public:
   //----------------------------------------------------------------------------
   //! Destructor
   //----------------------------------------------------------------------------
-  ~Logging() = default;
+  ~Logging();
 
   //----------------------------------------------------------------------------
   //! Get current loglevel
@@ -628,6 +677,63 @@ public:
   //---------------------------------------------------------------------------
 
   bool rate_limit(struct timeval& tv, int priority, const char* file, int line);
+
+  //----------------------------------------------------------------------------
+  //! Enable or disable the asynchronous mode in which the log lines are
+  //! written to stderr and the fan-outs by a dedicated thread. Enabled by
+  //! default if EOS_LOG_ASYNC is set to 1.
+  //!
+  //! @param onoff if true enable, otherwise write synchronously
+  //----------------------------------------------------------------------------
+  void SetAsync(bool onoff);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of log lines dropped because the writer was lagging
+  //----------------------------------------------------------------------------
+  inline uint64_t GetAsyncDropped() const
+  {
+    return mAsyncDropped;
+  }
+
+private:
+  //! Number of log lines buffered in asynchronous mode
+  static constexpr uint64_t kAsyncRingSize = 16384;
+
+  //! Log line waiting to be written by the writer thread
+  struct AsyncRecord {
+    FILE* mFd; ///< Destination
+    std::string mText; ///< Formatted line
+  };
+
+  //----------------------------------------------------------------------------
+  //! Write a formatted line to the given destination, either directly or
+  //! through the writer thread. Must be called with gMutex locked.
+  //!
+  //! @param fd destination
+  //! @param format printf like format
+  //----------------------------------------------------------------------------
+  void Output(FILE* fd, const char* format, ...)
+  __attribute__((format(printf, 3, 4)));
+
+  //----------------------------------------------------------------------------
+  //! Loop of the writer thread
+  //----------------------------------------------------------------------------
+  void AsyncWriter();
+
+  //----------------------------------------------------------------------------
+  //! Stop the writer thread after writing all the buffered lines
+  //----------------------------------------------------------------------------
+  void StopAsync();
+
+  bool mAsync; ///< Asynchronous mode enabled, protected by gMutex
+  std::thread mAsyncThread; ///< Writer thread
+  pid_t mAsyncPid; ///< Process running the writer thread
+  std::atomic<bool> mAsyncRunning; ///< Writer thread should keep running
+  //! Ring of buffered lines, filled under gMutex and drained by the writer
+  std::vector<AsyncRecord> mAsyncRing;
+  std::atomic<uint64_t> mAsyncHead; ///< Next slot to be filled
+  std::atomic<uint64_t> mAsyncTail; ///< Next slot to be written
+  std::atomic<uint64_t> mAsyncDropped; ///< Lines dropped as the ring was full
 };
 
 extern Logging& gLogging; ///< Global logging object
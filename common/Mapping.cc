@@ -29,8 +29,9 @@
 #include "common/SymKeys.hh"
 #include "XrdSys/XrdSysDNS.hh"
 #include "XrdOuc/XrdOucEnv.hh"
-#include <pwd.h>
 #include <grp.h>
+#include <functional>
+#include <mutex>
 
 EOSCOMMONNAMESPACE_BEGIN
 
@@ -40,7 +41,7 @@ const std::string Mapping::PROXY_GEOTAG = "proxy";
 /*----------------------------------------------------------------------------*/
 // global mapping objects
 /*----------------------------------------------------------------------------*/
-RWMutex Mapping::gMapMutex;
+RWMutex Mapping::gMapMutex(false, true);
 XrdSysMutex Mapping::gPhysicalIdMutex;
 
 Mapping::UserRoleMap_t Mapping::gUserRoleVector;
@@ -58,16 +59,50 @@ XrdSysMutex Mapping::ActiveLock;
 
 google::dense_hash_map<std::string, time_t> Mapping::ActiveTidents;
 
+namespace
+{
+//------------------------------------------------------------------------------
+// Keys of the physical mapping rules, built once instead of once per IdMap
+//------------------------------------------------------------------------------
+const std::string kKrb5PwdUid = "krb5:\"<pwd>\":uid";
+const std::string kKrb5PwdGid = "krb5:\"<pwd>\":gid";
+const std::string kGsiPwdUid = "gsi:\"<pwd>\":uid";
+const std::string kGsiPwdGid = "gsi:\"<pwd>\":gid";
+const std::string kHttpsPwdUid = "https:\"<pwd>\":uid";
+const std::string kHttpsPwdGid = "https:\"<pwd>\":gid";
+const std::string kSssPwdUid = "sss:\"<pwd>\":uid";
+const std::string kSssPwdGid = "sss:\"<pwd>\":gid";
+const std::string kUnixPwdUid = "unix:\"<pwd>\":uid";
+const std::string kUnixPwdGid = "unix:\"<pwd>\":gid";
+
+//------------------------------------------------------------------------------
+// Look up a mapping rule with a single search and without inserting it, the
+// maps are only read locked in IdMap
+//------------------------------------------------------------------------------
+template<typename Map>
+bool FindRule(const Map& map, const std::string& key,
+              typename Map::mapped_type& value)
+{
+  auto it = map.find(key);
+
+  if (it == map.end()) {
+    return false;
+  }
+
+  value = it->second;
+  return true;
+}
+}
+
 XrdOucHash<Mapping::id_pair> Mapping::gPhysicalUidCache;
 XrdOucHash<Mapping::gid_vector> Mapping::gPhysicalGidCache;
 
-XrdSysMutex Mapping::gPhysicalNameCacheMutex;
-std::map<uid_t, std::string> Mapping::gPhysicalUserNameCache;
-std::map<gid_t, std::string> Mapping::gPhysicalGroupNameCache;
-std::map<std::string, uid_t> Mapping::gPhysicalUserIdCache;
-std::map<std::string, gid_t> Mapping::gPhysicalGroupIdCache;
+NssResolver Mapping::gNssResolver;
 
 Mapping::ip_cache Mapping::gIpCache(300);
+Mapping::vid_cache Mapping::gVidCache(60);
+constexpr size_t Mapping::vid_cache::sNumShards;
+constexpr size_t Mapping::vid_cache::sMaxShardEntries;
 /*----------------------------------------------------------------------------*/
 /**
  * Initialize Google maps
@@ -87,6 +122,36 @@ Mapping::Init()
       !strcmp("1", getenv("EOS_FUSE_NO_ROOT_SQUASH"))) {
     gRootSquash = false;
   }
+
+  // lifetime of the mapped identity cache, 0 disables it
+  if (getenv("EOS_MGM_VID_CACHE_LIFETIME")) {
+    gVidCache.SetLifeTime(atoi(getenv("EOS_MGM_VID_CACHE_LIFETIME")));
+  }
+
+  // name service resolver threads, cache lifetimes and max caller wait time
+  unsigned int nss_threads = 4;
+  unsigned int nss_ttl = 3600;
+  unsigned int nss_negative_ttl = 60;
+  unsigned int nss_timeout_ms = 5000;
+
+  if (getenv("EOS_MGM_NSS_THREADS")) {
+    nss_threads = atoi(getenv("EOS_MGM_NSS_THREADS"));
+  }
+
+  if (getenv("EOS_MGM_NSS_CACHE_TTL")) {
+    nss_ttl = atoi(getenv("EOS_MGM_NSS_CACHE_TTL"));
+  }
+
+  if (getenv("EOS_MGM_NSS_NEGATIVE_TTL")) {
+    nss_negative_ttl = atoi(getenv("EOS_MGM_NSS_NEGATIVE_TTL"));
+  }
+
+  if (getenv("EOS_MGM_NSS_TIMEOUT_MS")) {
+    nss_timeout_ms = atoi(getenv("EOS_MGM_NSS_TIMEOUT_MS"));
+  }
+
+  gNssResolver.Configure(nss_threads, nss_ttl, nss_negative_ttl,
+                         nss_timeout_ms);
 }
 
 //------------------------------------------------------------------------------
@@ -100,17 +165,12 @@ Mapping::Reset()
     gPhysicalUidCache.Purge();
     gPhysicalGidCache.Purge();
   }
-  {
-    XrdSysMutexHelper mLock(gPhysicalNameCacheMutex);
-    gPhysicalGroupNameCache.clear();
-    gPhysicalUserNameCache.clear();
-    gPhysicalGroupIdCache.clear();
-    gPhysicalUserIdCache.clear();
-  }
+  gNssResolver.Clear();
   {
     XrdSysMutexHelper mLock(ActiveLock);
     ActiveTidents.clear();
   }
+  gVidCache.Invalidate();
 }
 
 
@@ -147,7 +207,151 @@ Mapping::ActiveExpire(int interval, bool force)
 
     Mapping::ActiveTidents.resize(0);
     expire = now + 1800;
+    PrefetchActiveIds();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Queue name lookups of the users in the ActiveTidents map
+//------------------------------------------------------------------------------
+void
+Mapping::PrefetchActiveIds()
+{
+  std::set<std::string> uids;
+
+  for (auto it = ActiveTidents.begin(); it != ActiveTidents.end(); ++it) {
+    uids.insert(it->first.substr(0, it->first.find('^')));
   }
+
+  gNssResolver.Prefetch(NssResolver::Type::kUidToName,
+                        std::vector<std::string>(uids.begin(), uids.end()));
+}
+
+//------------------------------------------------------------------------------
+// Maintain the active client map and expire old entries
+//------------------------------------------------------------------------------
+void
+Mapping::TrackActiveTident(const VirtualIdentity& vid,
+                           const std::string& mytident)
+{
+  time_t now = time(NULL);
+  XrdSysMutexHelper aLock(ActiveLock);
+
+  // ---------------------------------------------------------------------------
+  // safty measures not to exceed memory by 'nasty' clients
+  // ---------------------------------------------------------------------------
+  if (ActiveTidents.size() > 25000) {
+    ActiveExpire();
+  }
+
+  if (ActiveTidents.size() < 60000) {
+    char actident[1024];
+    snprintf(actident, sizeof(actident) - 1, "%d^%s^%s^%s^%s", vid.uid,
+             mytident.c_str(), vid.prot.c_str(), vid.host.c_str(), vid.app.c_str());
+    std::string intident = actident;
+    ActiveTidents[intident] = now;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Build the cache key of a client request
+//------------------------------------------------------------------------------
+std::string
+Mapping::vid_cache::MakeKey(const XrdSecEntity* client, const char* tident,
+                            XrdOucEnv& env)
+{
+  const char* ruid = env.Get("eos.ruid");
+  const char* rgid = env.Get("eos.rgid");
+  const char* rapp = env.Get("eos.app");
+  std::string key;
+  key.reserve(256);
+  // Fields separated by a character which can not show up in any of them
+  key += (tident ? tident : "");
+  key += '\n';
+  key += client->prot;
+  key += '\n';
+  key += (client->name ? client->name : "");
+  key += '\n';
+  key += (client->host ? client->host : "");
+  key += '\n';
+  key += (client->role ? client->role : "");
+  key += '\n';
+  key += (client->grps ? client->grps : "");
+  key += '\n';
+  key += (client->endorsements ? client->endorsements : "");
+  key += '\n';
+  key += (ruid ? ruid : "");
+  key += '\n';
+  key += (rgid ? rgid : "");
+  key += '\n';
+  key += (rapp ? rapp : "");
+  return key;
+}
+
+//------------------------------------------------------------------------------
+// Get a cached identity
+//------------------------------------------------------------------------------
+bool
+Mapping::vid_cache::Get(const std::string& key, VirtualIdentity& vid,
+                        std::string& mytident)
+{
+  shard_t& shard = mShards[std::hash<std::string>()(key) % sNumShards];
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(shard.mMutex);
+    auto it = shard.mEntries.find(key);
+
+    if ((it != shard.mEntries.end()) &&
+        (it->second.generation == mGeneration.load()) &&
+        (it->second.expires > time(NULL))) {
+      vid = it->second.vid;
+      mytident = it->second.mytident;
+      ++mHits;
+      return true;
+    }
+  }
+  ++mMisses;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Store an identity
+//------------------------------------------------------------------------------
+void
+Mapping::vid_cache::Store(const std::string& key, uint64_t generation,
+                          const VirtualIdentity& vid,
+                          const std::string& mytident)
+{
+  // mapping rules changed while computing the identity
+  if (generation != mGeneration.load()) {
+    return;
+  }
+
+  time_t now = time(NULL);
+  shard_t& shard = mShards[std::hash<std::string>()(key) % sNumShards];
+  std::unique_lock<std::shared_timed_mutex> lock(shard.mMutex);
+
+  if (shard.mEntries.size() >= sMaxShardEntries) {
+    uint64_t current = mGeneration.load();
+
+    for (auto it = shard.mEntries.begin(); it != shard.mEntries.end();) {
+      if ((it->second.generation != current) || (it->second.expires <= now)) {
+        it = shard.mEntries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    // too many active clients - start over
+    if (shard.mEntries.size() >= sMaxShardEntries) {
+      shard.mEntries.clear();
+    }
+  }
+
+  entry_t& entry = shard.mEntries[key];
+  entry.vid = vid;
+  entry.mytident = mytident;
+  entry.generation = generation;
+  entry.expires = now + mLifeTime.load();
 }
 
 /*----------------------------------------------------------------------------*/
@@ -171,9 +375,33 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
 
   eos_static_debug("name:%s role:%s group:%s tident:%s", client->name,
                    client->role, client->grps, client->tident);
+  XrdOucEnv Env(env);
+  // an externally set geo location takes part in the mapping, don't cache it
+  bool use_cache = gVidCache.IsEnabled() && !vid.geolocation.length();
+  std::string cache_key;
+  uint64_t cache_generation = 0;
+
+  if (use_cache) {
+    cache_key = vid_cache::MakeKey(client, tident, Env);
+    // taken before reading any of the mapping rules
+    cache_generation = gVidCache.GetGeneration();
+    std::string cached_tident;
+
+    if (gVidCache.Get(cache_key, vid, cached_tident)) {
+      TrackActiveTident(vid, cached_tident);
+
+      if (log) {
+        eos_static_info("%s sec.tident=\"%s\"",
+                        eos::common::SecEntity::ToString(client,
+                            Env.Get("eos.app")).c_str(), tident);
+      }
+
+      return;
+    }
+  }
+
   // you first are 'nobody'
   Nobody(vid);
-  XrdOucEnv Env(env);
   vid.name = client->name;
   vid.tident = tident;
   vid.sudoer = false;
@@ -200,14 +428,14 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "krb5")) {
     eos_static_debug("krb5 mapping");
 
-    if (gVirtualUidMap.count("krb5:\"<pwd>\":uid")) {
+    if (gVirtualUidMap.count(kKrb5PwdUid)) {
       // use physical mapping for kerberos names
       Mapping::getPhysicalIds(client->name, vid);
       vid.gid = 99;
       vid.gid_list.clear();
     }
 
-    if (gVirtualGidMap.count("krb5:\"<pwd>\":gid")) {
+    if (gVirtualGidMap.count(kKrb5PwdGid)) {
       // use physical mapping for kerberos names
       uid_t uid = vid.uid;
       Mapping::getPhysicalIds(client->name, vid);
@@ -224,14 +452,14 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "gsi")) {
     eos_static_debug("gsi mapping");
 
-    if (gVirtualUidMap.count("gsi:\"<pwd>\":uid")) {
+    if (gVirtualUidMap.count(kGsiPwdUid)) {
       // use physical mapping for gsi names
       Mapping::getPhysicalIds(client->name, vid);
       vid.gid = 99;
       vid.gid_list.clear();
     }
 
-    if (gVirtualGidMap.count("gsi:\"<pwd>\":gid")) {
+    if (gVirtualGidMap.count(kGsiPwdGid)) {
       // use physical mapping for gsi names
       uid_t uid = vid.uid;
       Mapping::getPhysicalIds(client->name, vid);
@@ -263,28 +491,31 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       vomsgidstring += ":gid";
 
       // mapping to user
-      if (gVirtualUidMap.count(vomsuidstring)) {
+      uid_t voms_uid = 0;
+      gid_t voms_gid = 0;
+
+      if (FindRule(gVirtualUidMap, vomsuidstring, voms_uid)) {
         vid.uid_list.clear();
         vid.gid_list.clear();
         // use physical mapping for VOMS roles
         // convert mapped uid to user name
         int errc = 0;
-        std::string cname = Mapping::UidToUserName(gVirtualUidMap[vomsuidstring], errc);
+        std::string cname = Mapping::UidToUserName(voms_uid, errc);
 
         if (!errc) {
           Mapping::getPhysicalIds(cname.c_str(), vid);
         } else {
           Nobody(vid);
           eos_static_err("voms-mapping: cannot translate uid=%d to user name with the password db",
-                         (int) gVirtualUidMap[vomsuidstring]);
+                         (int) voms_uid);
         }
       }
 
       // mapping to group
-      if (gVirtualGidMap.count(vomsgidstring)) {
+      if (FindRule(gVirtualGidMap, vomsgidstring, voms_gid)) {
         // use group mapping for VOMS roles
         vid.gid_list.clear();
-        vid.gid = gVirtualGidMap[vomsgidstring];
+        vid.gid = voms_gid;
         vid.gid_list.push_back(vid.gid);
       }
     }
@@ -296,23 +527,26 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "https")) {
     eos_static_debug("https mapping");
 
-    if (gVirtualUidMap.count("https:\"<pwd>\":uid")) {
-      if (gVirtualGidMap["https:\"<pwd>\":uid"] == 0) {
+    uid_t rule_uid = 0;
+    gid_t rule_gid = 0;
+
+    if (FindRule(gVirtualUidMap, kHttpsPwdUid, rule_uid)) {
+      if (rule_uid == 0) {
         // use physical mapping for https names
         Mapping::getPhysicalIds(client->name, vid);
         vid.gid = 99;
         vid.gid_list.clear();
       } else {
         vid.uid_list.clear();
-        vid.uid_list.push_back(gVirtualGidMap["https:\"<pwd>\":uid"]);
+        vid.uid_list.push_back(rule_uid);
         vid.uid_list.push_back(99);
         vid.gid = 99;
         vid.gid_list.clear();
       }
     }
 
-    if (gVirtualGidMap.count("https:\"<pwd>\":gid")) {
-      if (gVirtualGidMap["https:\"<pwd>\":gid"] == 0) {
+    if (FindRule(gVirtualGidMap, kHttpsPwdGid, rule_gid)) {
+      if (rule_gid == 0) {
         // use physical mapping for gsi names
         uid_t uid = vid.uid;
         Mapping::getPhysicalIds(client->name, vid);
@@ -322,7 +556,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         vid.uid_list.push_back(99);
       } else {
         vid.gid_list.clear();
-        vid.gid_list.push_back(gVirtualGidMap["https:\"<pwd>\":gid"]);
+        vid.gid_list.push_back(rule_gid);
         vid.gid_list.push_back(99);
       }
     }
@@ -334,8 +568,11 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "sss")) {
     eos_static_debug("sss mapping");
 
-    if (gVirtualUidMap.count("sss:\"<pwd>\":uid")) {
-      if (gVirtualUidMap["sss:\"<pwd>\":uid"] == 0) {
+    uid_t rule_uid = 0;
+    gid_t rule_gid = 0;
+
+    if (FindRule(gVirtualUidMap, kSssPwdUid, rule_uid)) {
+      if (rule_uid == 0) {
         eos_static_debug("sss uid mapping");
         Mapping::getPhysicalIds(client->name, vid);
         vid.gid = 99;
@@ -344,7 +581,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         eos_static_debug("sss uid forced mapping");
         // map to the requested id
         vid.uid_list.clear();
-        vid.uid = gVirtualUidMap["sss:\"<pwd>\":uid"];
+        vid.uid = rule_uid;
         vid.uid_list.push_back(vid.uid);
 
         if (vid.uid != 99) {
@@ -357,8 +594,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       }
     }
 
-    if (gVirtualGidMap.count("sss:\"<pwd>\":gid")) {
-      if (gVirtualGidMap["sss:\"<pwd>\":gid"] == 0) {
+    if (FindRule(gVirtualGidMap, kSssPwdGid, rule_gid)) {
+      if (rule_gid == 0) {
         eos_static_debug("sss gid mapping");
         // use physical mapping for sss names
         uid_t uid = vid.uid;
@@ -371,7 +608,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         eos_static_debug("sss forced gid mapping");
         // map to the requested id
         vid.gid_list.clear();
-        vid.gid = gVirtualGidMap["sss:\"<pwd>\":gid"];
+        vid.gid = rule_gid;
         vid.gid_list.push_back(vid.gid);
       }
     }
@@ -383,8 +620,11 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "unix")) {
     eos_static_debug("unix mapping");
 
-    if (gVirtualUidMap.count("unix:\"<pwd>\":uid")) {
-      if (gVirtualUidMap["unix:\"<pwd>\":uid"] == 0) {
+    uid_t rule_uid = 0;
+    gid_t rule_gid = 0;
+
+    if (FindRule(gVirtualUidMap, kUnixPwdUid, rule_uid)) {
+      if (rule_uid == 0) {
         eos_static_debug("unix uid mapping");
         // use physical mapping for unix names
         Mapping::getPhysicalIds(client->name, vid);
@@ -394,7 +634,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         eos_static_debug("unix uid forced mapping");
         // map to the requested id
         vid.uid_list.clear();
-        vid.uid = gVirtualUidMap["unix:\"<pwd>\":uid"];
+        vid.uid = rule_uid;
         vid.uid_list.push_back(vid.uid);
 
         if (vid.uid != 99) {
@@ -407,8 +647,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       }
     }
 
-    if (gVirtualGidMap.count("unix:\"<pwd>\":gid")) {
-      if (gVirtualGidMap["unix:\"<pwd>\":gid"] == 0) {
+    if (FindRule(gVirtualGidMap, kUnixPwdGid, rule_gid)) {
+      if (rule_gid == 0) {
         eos_static_debug("unix gid mapping");
         // use physical mapping for unix names
         uid_t uid = vid.uid;
@@ -421,7 +661,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         eos_static_debug("unix forced gid mapping");
         // map to the requested id
         vid.gid_list.clear();
-        vid.gid = gVirtualGidMap["unix:\"<pwd>\":gid"];
+        vid.gid = rule_gid;
         vid.gid_list.push_back(vid.gid);
       }
     }
@@ -812,8 +1052,6 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
     vid.app = rapp.c_str();
   }
 
-  time_t now = time(NULL);
-
   // ---------------------------------------------------------------------------
   // Check the Geo Location
   // ---------------------------------------------------------------------------
@@ -849,27 +1087,11 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
     }
   }
 
-  // ---------------------------------------------------------------------------
-  // Maintain the active client map and expire old entries
-  // ---------------------------------------------------------------------------
-  ActiveLock.Lock();
-
-  // ---------------------------------------------------------------------------
-  // safty measures not to exceed memory by 'nasty' clients
-  // ---------------------------------------------------------------------------
-  if (ActiveTidents.size() > 25000) {
-    ActiveExpire();
+  if (use_cache) {
+    gVidCache.Store(cache_key, cache_generation, vid, mytident.c_str());
   }
 
-  if (ActiveTidents.size() < 60000) {
-    char actident[1024];
-    snprintf(actident, sizeof(actident) - 1, "%d^%s^%s^%s^%s", vid.uid,
-             mytident.c_str(), vid.prot.c_str(), vid.host.c_str(), vid.app.c_str());
-    std::string intident = actident;
-    ActiveTidents[intident] = now;
-  }
-
-  ActiveLock.UnLock();
+  TrackActiveTident(vid, mytident.c_str());
   eos_static_debug("selected %d %d [%s %s]", vid.uid, vid.gid, ruid.c_str(),
                    rgid.c_str());
 
@@ -1105,6 +1327,25 @@ Mapping::Print(XrdOucString& stdOut, XrdOucString option)
     }
   }
 
+  if (((option.find("r")) != STR_NPOS)) {
+    NssResolver::Stats stats = gNssResolver.GetStats();
+    char sline[1024];
+    snprintf(sline, sizeof(sline) - 1,
+             "resolver: hits=%llu negative-hits=%llu misses=%llu timeouts=%llu "
+             "lookups=%llu failures=%llu avg-latency-ms=%.03f "
+             "max-latency-ms=%.03f entries=%llu\n",
+             (unsigned long long) stats.mHits,
+             (unsigned long long) stats.mNegativeHits,
+             (unsigned long long) stats.mMisses,
+             (unsigned long long) stats.mTimeouts,
+             (unsigned long long) stats.mLookups,
+             (unsigned long long) stats.mFailures,
+             stats.mLookups ? stats.mSumLatencyUs / 1000.0 / stats.mLookups : 0.0,
+             stats.mMaxLatencyUs / 1000.0,
+             (unsigned long long) stats.mEntries);
+    stdOut += sline;
+  }
+
   if ((!option.length())) {
     for (auto it = gAllowedTidentMatches.begin(); it != gAllowedTidentMatches.end();
          ++it) {
@@ -1128,16 +1369,12 @@ Mapping::Print(XrdOucString& stdOut, XrdOucString option)
 void
 Mapping::getPhysicalIds(const char* name, VirtualIdentity& vid)
 {
-  struct passwd passwdinfo;
-  char buffer[131072];
-
   if (!name) {
     return;
   }
 
   gid_vector* gv;
   id_pair* id  = 0;
-  memset(&passwdinfo, 0, sizeof(passwdinfo));
   eos_static_debug("find in uid cache %s", name);
   XrdSysMutexHelper gLock(gPhysicalIdMutex);
 
@@ -1192,15 +1429,17 @@ Mapping::getPhysicalIds(const char* name, VirtualIdentity& vid)
           } else {
             // only user id got forwarded, we retrieve the corresponding group
             uid_t ruid = (bituser >> 6) & 0xfffffffff;
+            NssResolver::Reply reply;
             gPhysicalIdMutex.UnLock();
-            struct passwd* pwbufp = 0;
+            int rc = gNssResolver.Lookup(NssResolver::Type::kUidToName,
+                                         std::to_string(ruid), reply);
+            gPhysicalIdMutex.Lock();
 
-            if (getpwuid_r(ruid, &passwdinfo, buffer, 16384, &pwbufp) || (!pwbufp)) {
-              gPhysicalIdMutex.Lock();
+            if (rc) {
               return;
             }
 
-            id = new id_pair(passwdinfo.pw_uid, passwdinfo.pw_gid);
+            id = new id_pair(reply.mId, reply.mGid);
           }
 
           eos_static_debug("using base64 mapping %s %d %d", sname.c_str(), id->uid,
@@ -1235,16 +1474,16 @@ Mapping::getPhysicalIds(const char* name, VirtualIdentity& vid)
     }
 
     if (use_pw) {
+      NssResolver::Reply reply;
       gPhysicalIdMutex.UnLock();
-      struct passwd* pwbufp = 0;
-      {
-        if (getpwnam_r(name, &passwdinfo, buffer, 16384, &pwbufp) || (!pwbufp)) {
-          gPhysicalIdMutex.Lock();
-          return;
-        }
-      }
+      int rc = gNssResolver.Lookup(NssResolver::Type::kNameToUid, name, reply);
       gPhysicalIdMutex.Lock();
-      id = new id_pair(passwdinfo.pw_uid, passwdinfo.pw_gid);
+
+      if (rc) {
+        return;
+      }
+
+      id = new id_pair(reply.mId, reply.mGid);
       gPhysicalUidCache.Add(name, id, 3600);
       eos_static_debug("adding to cache uid=%u gid=%u", id->uid, id->gid);
     }
@@ -1319,52 +1558,16 @@ Mapping::getPhysicalIds(const char* name, VirtualIdentity& vid)
 std::string
 Mapping::UidToUserName(uid_t uid, int& errc)
 {
-  errc = 0;
-  {
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
+  NssResolver::Reply reply;
+  std::string suid = std::to_string(uid);
 
-    if (gPhysicalUserNameCache.count(uid)) {
-      return gPhysicalUserNameCache[uid];
-    }
-  }
-  char buffer[131072];
-  int buflen = sizeof(buffer);
-  std::string uid_string = "";
-  struct passwd pwbuf;
-  struct passwd* pwbufp = 0;
-  (void) getpwuid_r(uid, &pwbuf, buffer, buflen, &pwbufp);
-
-  if (pwbufp == NULL) {
-    char buffer[131072];
-    int buflen = sizeof(buffer);
-    std::string uid_string = "";
-    struct passwd pwbuf;
-    struct passwd* pwbufp = 0;
-    {
-      if (getpwuid_r(uid, &pwbuf, buffer, buflen, &pwbufp) || (!pwbufp)) {
-        char suid[1024];
-        snprintf(suid, sizeof(suid) - 1, "%u", uid);
-        uid_string = suid;
-        errc = EINVAL;
-        return uid_string; // don't cache this one
-      } else {
-        uid_string = pwbuf.pw_name;
-        errc = 0;
-      }
-    }
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
-    gPhysicalUserNameCache[uid] = uid_string;
-    gPhysicalUserIdCache[uid_string] = uid;
-    return uid_string;
-  } else {
-    uid_string = pwbuf.pw_name;
-    errc = 0;
+  if (gNssResolver.Lookup(NssResolver::Type::kUidToName, suid, reply)) {
+    errc = EINVAL;
+    return suid;
   }
 
-  XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
-  gPhysicalUserNameCache[uid] = uid_string;
-  gPhysicalUserIdCache[uid_string] = uid;
-  return uid_string;
+  errc = 0;
+  return reply.mName;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1381,38 +1584,16 @@ Mapping::UidToUserName(uid_t uid, int& errc)
 std::string
 Mapping::GidToGroupName(gid_t gid, int& errc)
 {
-  errc = 0;
-  {
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
+  NssResolver::Reply reply;
+  std::string sgid = std::to_string(gid);
 
-    if (gPhysicalGroupNameCache.count(gid)) {
-      return gPhysicalGroupNameCache[gid];
-    }
+  if (gNssResolver.Lookup(NssResolver::Type::kGidToName, sgid, reply)) {
+    errc = EINVAL;
+    return sgid;
   }
-  {
-    char buffer[131072];
-    int buflen = sizeof(buffer);
-    struct group grbuf;
-    struct group* grbufp = 0;
-    std::string gid_string = "";
-
-    if (getgrgid_r(gid, &grbuf, buffer, buflen, &grbufp) || (!grbufp)) {
-      // cannot translate this name
-      char sgid[1024];
-      snprintf(sgid, sizeof(sgid) - 1, "%u", gid);
-      gid_string = sgid;
-      errc = EINVAL;
-      return gid_string; // don't cache this one
-    } else {
-      gid_string = grbuf.gr_name;
-      errc = 0;
-    }
 
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
-    gPhysicalGroupNameCache[gid] = gid_string;
-    gPhysicalGroupIdCache[gid_string] = gid;
-    return gid_string;
-  }
+  errc = 0;
+  return reply.mName;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1428,53 +1609,30 @@ Mapping::GidToGroupName(gid_t gid, int& errc)
 uid_t
 Mapping::UserNameToUid(const std::string& username, int& errc)
 {
-  {
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
-
-    if (gPhysicalUserIdCache.count(username)) {
-      return gPhysicalUserIdCache[username];
-    }
-  }
-  char buffer[131072];
-  int buflen = sizeof(buffer);
-  uid_t uid = 99;
-  struct passwd pwbuf;
-  struct passwd* pwbufp = 0;
+  NssResolver::Reply reply;
   errc = 0;
-  (void) getpwnam_r(username.c_str(), &pwbuf, buffer, buflen, &pwbufp);
 
-  if (pwbufp == NULL) {
-    bool is_number = true;
-
-    for (size_t i = 0; i < username.length(); i++) {
-      if (!isdigit(username[i])) {
-        is_number = false;
-        break;
-      }
-    }
+  if (!gNssResolver.Lookup(NssResolver::Type::kNameToUid, username, reply)) {
+    return reply.mId;
+  }
 
-    uid = atoi(username.c_str());
+  bool is_number = true;
 
-    if ((uid != 0) && (is_number)) {
-      errc = 0;
-      return uid;
-    } else {
-      errc = EINVAL;
-      uid = 99;
-      return uid;
+  for (size_t i = 0; i < username.length(); i++) {
+    if (!isdigit(username[i])) {
+      is_number = false;
+      break;
     }
-  } else {
-    uid = pwbuf.pw_uid;
-    errc = 0;
   }
 
-  if (!errc) {
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
-    gPhysicalUserIdCache[username] = uid;
-    gPhysicalUserNameCache[uid] = username;
+  uid_t uid = atoi(username.c_str());
+
+  if ((uid != 0) && (is_number)) {
+    return uid;
   }
 
-  return uid;
+  errc = EINVAL;
+  return 99;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1491,52 +1649,30 @@ Mapping::UserNameToUid(const std::string& username, int& errc)
 gid_t
 Mapping::GroupNameToGid(const std::string& groupname, int& errc)
 {
-  {
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
-
-    if (gPhysicalGroupIdCache.count(groupname)) {
-      return gPhysicalGroupIdCache[groupname];
-    }
-  }
-  char buffer[131072];
-  int buflen = sizeof(buffer);
-  struct group grbuf;
-  struct group* grbufp = 0;
-  gid_t gid = 99;
+  NssResolver::Reply reply;
   errc = 0;
-  (void) getgrnam_r(groupname.c_str(), &grbuf, buffer, buflen, &grbufp);
 
-  if (!grbufp) {
-    bool is_number = true;
-
-    for (size_t i = 0; i < groupname.length(); i++) {
-      if (!isdigit(groupname[i])) {
-        is_number = false;
-        break;
-      }
-    }
+  if (!gNssResolver.Lookup(NssResolver::Type::kNameToGid, groupname, reply)) {
+    return reply.mId;
+  }
 
-    gid = atoi(groupname.c_str());
+  bool is_number = true;
 
-    if ((gid != 0) && (is_number)) {
-      errc = 0;
-      return gid;
-    } else {
-      errc = EINVAL;
-      gid = 99;
+  for (size_t i = 0; i < groupname.length(); i++) {
+    if (!isdigit(groupname[i])) {
+      is_number = false;
+      break;
     }
-  } else {
-    gid = grbuf.gr_gid;
-    errc = 0;
   }
 
-  if (!errc) {
-    XrdSysMutexHelper cMutex(gPhysicalNameCacheMutex);
-    gPhysicalGroupIdCache[groupname] = gid;
-    gPhysicalGroupNameCache[gid] = groupname;
+  gid_t gid = atoi(groupname.c_str());
+
+  if ((gid != 0) && (is_number)) {
+    return gid;
   }
 
-  return gid;
+  errc = EINVAL;
+  return 99;
 }
 
 /*----------------------------------------------------------------------------*/
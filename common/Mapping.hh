@@ -27,16 +27,21 @@
 
 #include "common/Namespace.hh"
 #include "common/RWMutex.hh"
+#include "common/NssResolver.hh"
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdOuc/XrdOucHash.hh"
+#include <atomic>
 #include <map>
 #include <set>
 #include <vector>
 #include <string>
+#include <shared_mutex>
+#include <unordered_map>
 #include <google/dense_hash_map>
 
 //! Forward declaration
 class XrdSecEntity;
+class XrdOucEnv;
 
 EOSCOMMONNAMESPACE_BEGIN
 
@@ -159,6 +164,113 @@ public:
   //----------------------------------------------------------------------------
   typedef struct VirtualIdentity_t VirtualIdentity;
 
+  //----------------------------------------------------------------------------
+  //! Cache of the fully mapped virtual identities per client connection. It
+  //! is sharded by the hash of the key and every shard is guarded by its own
+  //! reader-writer lock, so concurrent lookups hardly ever contend. Entries
+  //! become invalid when the generation is bumped by a change of the mapping
+  //! rules and expire after the lifetime to pick up password db changes.
+  //----------------------------------------------------------------------------
+  class vid_cache
+  {
+  public:
+    //--------------------------------------------------------------------------
+    //! Constructor
+    //!
+    //! @param lifetime lifetime of the entries in seconds, 0 disables the cache
+    //--------------------------------------------------------------------------
+    vid_cache(int lifetime = 60):
+      mGeneration(0), mHits(0), mMisses(0), mLifeTime(lifetime) {}
+
+    //--------------------------------------------------------------------------
+    //! Build the cache key of a client request from everything the mapping
+    //! depends on
+    //--------------------------------------------------------------------------
+    static std::string MakeKey(const XrdSecEntity* client, const char* tident,
+                               XrdOucEnv& env);
+
+    //--------------------------------------------------------------------------
+    //! Check if the cache is enabled
+    //--------------------------------------------------------------------------
+    inline bool IsEnabled() const
+    {
+      return (mLifeTime > 0);
+    }
+
+    //--------------------------------------------------------------------------
+    //! Set the lifetime of new entries in seconds, 0 disables the cache
+    //--------------------------------------------------------------------------
+    void SetLifeTime(int lifetime)
+    {
+      mLifeTime = lifetime;
+      Invalidate();
+    }
+
+    //--------------------------------------------------------------------------
+    //! Get the current generation, to be taken before the mapping is computed
+    //--------------------------------------------------------------------------
+    inline uint64_t GetGeneration() const
+    {
+      return mGeneration.load();
+    }
+
+    //--------------------------------------------------------------------------
+    //! Invalidate all the entries, to be called on any mapping rule change
+    //--------------------------------------------------------------------------
+    inline void Invalidate()
+    {
+      ++mGeneration;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Get a cached identity
+    //!
+    //! @param key cache key built by MakeKey
+    //! @param vid filled with the cached identity
+    //! @param mytident filled with the reduced trace identifier
+    //!
+    //! @return true if found and still valid
+    //--------------------------------------------------------------------------
+    bool Get(const std::string& key, VirtualIdentity& vid,
+             std::string& mytident);
+
+    //--------------------------------------------------------------------------
+    //! Store an identity computed with the mapping rules of the generation
+    //--------------------------------------------------------------------------
+    void Store(const std::string& key, uint64_t generation,
+               const VirtualIdentity& vid, const std::string& mytident);
+
+    //--------------------------------------------------------------------------
+    //! Get number of hits and misses
+    //--------------------------------------------------------------------------
+    void GetStats(uint64_t& hits, uint64_t& misses) const
+    {
+      hits = mHits.load();
+      misses = mMisses.load();
+    }
+
+  private:
+    struct entry_t {
+      VirtualIdentity vid;
+      std::string mytident;
+      uint64_t generation;
+      time_t expires;
+    };
+
+    struct shard_t {
+      std::shared_timed_mutex mMutex;
+      std::unordered_map<std::string, entry_t> mEntries;
+    };
+
+    static constexpr size_t sNumShards = 64;
+    static constexpr size_t sMaxShardEntries = 1024;
+    shard_t mShards[sNumShards];
+    std::atomic<uint64_t> mGeneration;
+    std::atomic<uint64_t> mHits;
+    std::atomic<uint64_t> mMisses;
+    std::atomic<int> mLifeTime;
+  };
+
   //----------------------------------------------------------------------------
   //! Function creating the Nobody identity
   //----------------------------------------------------------------------------
@@ -250,20 +362,9 @@ public:
   static XrdOucHash<gid_vector> gPhysicalGidCache;
 
   // ---------------------------------------------------------------------------
-  //! A mutex protecting the physical id->name caches
-  // ---------------------------------------------------------------------------
-  static XrdSysMutex gPhysicalNameCacheMutex;
-
-  // ---------------------------------------------------------------------------
-  //! A cache for physical user name caching (e.g. from uid to name)
-  static std::map<uid_t, std::string> gPhysicalUserNameCache;
-  static std::map<std::string, uid_t> gPhysicalUserIdCache;
-
-  // ---------------------------------------------------------------------------
-  //! A cache for physical group id caching (e.g. from gid name to name)
+  //! Resolver and cache of the physical id <=> name translations
   // ---------------------------------------------------------------------------
-  static std::map<gid_t, std::string> gPhysicalGroupNameCache;
-  static std::map<std::string, gid_t> gPhysicalGroupIdCache;
+  static NssResolver gNssResolver;
 
   // ---------------------------------------------------------------------------
   //! Mutex to protect the physical ID caches
@@ -285,11 +386,22 @@ public:
   // ---------------------------------------------------------------------------
   static ip_cache gIpCache;
 
+  // ---------------------------------------------------------------------------
+  //! Cache of the mapped virtual identities
+  // ---------------------------------------------------------------------------
+  static vid_cache gVidCache;
+
   // ---------------------------------------------------------------------------
   //! Function to expire unused ActiveTident entries by default after 1 day
   // ---------------------------------------------------------------------------
   static void ActiveExpire(int interval = 300, bool force = false);
 
+  // ---------------------------------------------------------------------------
+  //! Queue name lookups of the users in the ActiveTidents map, needs the
+  //! ActiveLock
+  // ---------------------------------------------------------------------------
+  static void PrefetchActiveIds();
+
   // ---------------------------------------------------------------------------
   //! Function initializing static maps
   // ---------------------------------------------------------------------------
@@ -390,6 +502,12 @@ public:
   // ---------------------------------------------------------------------------
   static std::string GidAsString(gid_t gid);
 
+private:
+  // ---------------------------------------------------------------------------
+  //! Maintain the active client map and expire old entries
+  // ---------------------------------------------------------------------------
+  static void TrackActiveTident(const VirtualIdentity& vid,
+                                const std::string& mytident);
 };
 
 /*----------------------------------------------------------------------------*/
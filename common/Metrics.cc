@@ -0,0 +1,433 @@
+//------------------------------------------------------------------------------
+// File: Metrics.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/Metrics.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+//! Format a value the way Prometheus expects it
+//------------------------------------------------------------------------------
+std::string
+FormatValue(double value)
+{
+  if (std::isnan(value)) {
+    return "NaN";
+  }
+
+  if (std::isinf(value)) {
+    return (value > 0) ? "+Inf" : "-Inf";
+  }
+
+  // Shortest of the two precisions which reads back as the same value
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.15g", value);
+
+  if (strtod(buf, nullptr) != value) {
+    snprintf(buf, sizeof(buf), "%.17g", value);
+  }
+
+  return buf;
+}
+
+//------------------------------------------------------------------------------
+//! Escape a label value
+//------------------------------------------------------------------------------
+std::string
+EscapeLabel(const std::string& value)
+{
+  std::string out;
+  out.reserve(value.size());
+
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      out += '\\';
+      out += c;
+    } else if (c == '\n') {
+      out += "\\n";
+    } else {
+      out += c;
+    }
+  }
+
+  return out;
+}
+
+//------------------------------------------------------------------------------
+//! Metric names are [a-zA-Z_:][a-zA-Z0-9_:]*, anything else becomes '_'
+//------------------------------------------------------------------------------
+std::string
+SanitizeName(const std::string& name)
+{
+  std::string out = name;
+
+  for (size_t i = 0; i < out.size(); ++i) {
+    char c = out[i];
+    bool ok = (isalpha((unsigned char) c) || c == '_' || c == ':' ||
+               (i && isdigit((unsigned char) c)));
+
+    if (!ok) {
+      out[i] = '_';
+    }
+  }
+
+  return out;
+}
+}
+
+//------------------------------------------------------------------------------
+// Get the current value of a counter
+//------------------------------------------------------------------------------
+uint64_t
+MetricCounter::Get() const
+{
+  uint64_t sum = 0;
+
+  for (const auto& shard : mShards) {
+    sum += shard.mValue.load(std::memory_order_relaxed);
+  }
+
+  return sum;
+}
+
+//------------------------------------------------------------------------------
+// Shard of the calling thread
+//------------------------------------------------------------------------------
+size_t
+MetricCounter::GetShard()
+{
+  static thread_local size_t shard =
+    std::hash<std::thread::id>()(std::this_thread::get_id()) % kNumShards;
+  return shard;
+}
+
+//------------------------------------------------------------------------------
+// Set the value of a gauge
+//------------------------------------------------------------------------------
+void
+MetricGauge::Set(double value)
+{
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  mBits.store(bits, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+// Add to the value of a gauge
+//------------------------------------------------------------------------------
+void
+MetricGauge::Add(double delta)
+{
+  uint64_t old_bits = mBits.load(std::memory_order_relaxed);
+  uint64_t new_bits;
+
+  do {
+    double value;
+    memcpy(&value, &old_bits, sizeof(value));
+    value += delta;
+    memcpy(&new_bits, &value, sizeof(new_bits));
+  } while (!mBits.compare_exchange_weak(old_bits, new_bits,
+                                        std::memory_order_relaxed));
+}
+
+//------------------------------------------------------------------------------
+// Get the value of a gauge
+//------------------------------------------------------------------------------
+double
+MetricGauge::Get() const
+{
+  uint64_t bits = mBits.load(std::memory_order_relaxed);
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+//------------------------------------------------------------------------------
+// Histogram constructor
+//------------------------------------------------------------------------------
+MetricHistogram::MetricHistogram(const std::vector<double>& bounds):
+  mBounds(bounds), mCounts(new std::atomic<uint64_t>[bounds.size() + 1])
+{
+  std::sort(mBounds.begin(), mBounds.end());
+
+  for (size_t i = 0; i <= mBounds.size(); ++i) {
+    mCounts[i] = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Record a value
+//------------------------------------------------------------------------------
+void
+MetricHistogram::Observe(double value)
+{
+  size_t bucket = std::lower_bound(mBounds.begin(), mBounds.end(), value) -
+                  mBounds.begin();
+  mCounts[bucket].fetch_add(1, std::memory_order_relaxed);
+  mSum.Add(value);
+}
+
+//------------------------------------------------------------------------------
+// Get the cumulative counts
+//------------------------------------------------------------------------------
+std::vector<uint64_t>
+MetricHistogram::GetCumulativeCounts() const
+{
+  std::vector<uint64_t> counts(mBounds.size() + 1);
+  uint64_t total = 0;
+
+  for (size_t i = 0; i <= mBounds.size(); ++i) {
+    total += mCounts[i].load(std::memory_order_relaxed);
+    counts[i] = total;
+  }
+
+  return counts;
+}
+
+//------------------------------------------------------------------------------
+// Default bounds for latencies in seconds
+//------------------------------------------------------------------------------
+const std::vector<double>&
+MetricHistogram::LatencyBounds()
+{
+  static const std::vector<double> bounds {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1,
+    0.25, 0.5, 1, 2.5, 5, 10, 30, 60
+  };
+  return bounds;
+}
+
+//------------------------------------------------------------------------------
+// Get the registry of the process
+//------------------------------------------------------------------------------
+MetricsRegistry&
+MetricsRegistry::Instance()
+{
+  // Leaked on purpose, metrics may be updated during static destruction
+  static MetricsRegistry* registry = new MetricsRegistry();
+  return *registry;
+}
+
+//------------------------------------------------------------------------------
+// Get the series, creating family and series if needed
+//------------------------------------------------------------------------------
+MetricsRegistry::Series&
+MetricsRegistry::GetSeries(const std::string& name, const std::string& help,
+                           Type type, const MetricLabels& labels)
+{
+  std::string sname = SanitizeName(name);
+  auto it_family = mFamilies.find(sname);
+
+  if (it_family == mFamilies.end()) {
+    it_family = mFamilies.emplace(sname, Family()).first;
+    it_family->second.mType = type;
+    it_family->second.mHelp = help;
+  } else if (it_family->second.mType != type) {
+    throw std::invalid_argument("metric " + sname +
+                                " registered with another type");
+  }
+
+  Series& series = it_family->second.mSeries[FormatLabels(labels)];
+  series.mLabels = labels;
+  return series;
+}
+
+//------------------------------------------------------------------------------
+// Get or create a counter
+//------------------------------------------------------------------------------
+MetricCounter&
+MetricsRegistry::GetCounter(const std::string& name, const std::string& help,
+                            const MetricLabels& labels)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  Series& series = GetSeries(name, help, Type::kCounter, labels);
+
+  if (!series.mCounter) {
+    series.mCounter.reset(new MetricCounter());
+  }
+
+  return *series.mCounter;
+}
+
+//------------------------------------------------------------------------------
+// Get or create a gauge
+//------------------------------------------------------------------------------
+MetricGauge&
+MetricsRegistry::GetGauge(const std::string& name, const std::string& help,
+                          const MetricLabels& labels)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  Series& series = GetSeries(name, help, Type::kGauge, labels);
+
+  if (!series.mGauge) {
+    series.mGauge.reset(new MetricGauge());
+  }
+
+  return *series.mGauge;
+}
+
+//------------------------------------------------------------------------------
+// Get or create a histogram
+//------------------------------------------------------------------------------
+MetricHistogram&
+MetricsRegistry::GetHistogram(const std::string& name, const std::string& help,
+                              const std::vector<double>& bounds,
+                              const MetricLabels& labels)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  Series& series = GetSeries(name, help, Type::kHistogram, labels);
+
+  if (!series.mHistogram) {
+    series.mHistogram.reset(new MetricHistogram(bounds));
+  }
+
+  return *series.mHistogram;
+}
+
+//------------------------------------------------------------------------------
+// Expose a value computed at scrape time as a gauge
+//------------------------------------------------------------------------------
+void
+MetricsRegistry::SetGaugeCallback(const std::string& name,
+                                  const std::string& help,
+                                  std::function<double()> callback,
+                                  const MetricLabels& labels)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  GetSeries(name, help, Type::kGauge, labels).mCallback = std::move(callback);
+}
+
+//------------------------------------------------------------------------------
+// Remove a callback
+//------------------------------------------------------------------------------
+void
+MetricsRegistry::RemoveGaugeCallback(const std::string& name,
+                                     const MetricLabels& labels)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it_family = mFamilies.find(SanitizeName(name));
+
+  if (it_family != mFamilies.end()) {
+    auto it = it_family->second.mSeries.find(FormatLabels(labels));
+
+    if ((it != it_family->second.mSeries.end()) && !it->second.mGauge) {
+      it_family->second.mSeries.erase(it);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Render a label set
+//------------------------------------------------------------------------------
+std::string
+MetricsRegistry::FormatLabels(const MetricLabels& labels,
+                              const std::string& extra_key,
+                              const std::string& extra_value)
+{
+  if (labels.empty() && extra_key.empty()) {
+    return "";
+  }
+
+  std::string out = "{";
+  bool first = true;
+
+  for (const auto& label : labels) {
+    out += (first ? "" : ",");
+    out += SanitizeName(label.first) + "=\"" + EscapeLabel(label.second) + "\"";
+    first = false;
+  }
+
+  if (!extra_key.empty()) {
+    out += (first ? "" : ",");
+    out += extra_key + "=\"" + extra_value + "\"";
+  }
+
+  out += "}";
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Render all metrics in the Prometheus text exposition format
+//------------------------------------------------------------------------------
+std::string
+MetricsRegistry::Expose() const
+{
+  std::ostringstream oss;
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (const auto& elem : mFamilies) {
+    const std::string& name = elem.first;
+    const Family& family = elem.second;
+
+    if (family.mSeries.empty()) {
+      continue;
+    }
+
+    oss << "# HELP " << name << " " << family.mHelp << "\n"
+        << "# TYPE " << name << " "
+        << (family.mType == Type::kCounter ? "counter" :
+            (family.mType == Type::kGauge ? "gauge" : "histogram")) << "\n";
+
+    for (const auto& entry : family.mSeries) {
+      const Series& series = entry.second;
+
+      if (series.mCounter) {
+        oss << name << entry.first << " " << series.mCounter->Get() << "\n";
+      } else if (series.mGauge) {
+        oss << name << entry.first << " " << FormatValue(series.mGauge->Get())
+            << "\n";
+      } else if (series.mCallback) {
+        oss << name << entry.first << " " << FormatValue(series.mCallback())
+            << "\n";
+      } else if (series.mHistogram) {
+        const auto& bounds = series.mHistogram->GetBounds();
+        auto counts = series.mHistogram->GetCumulativeCounts();
+
+        for (size_t i = 0; i < bounds.size(); ++i) {
+          oss << name << "_bucket"
+              << FormatLabels(series.mLabels, "le", FormatValue(bounds[i]))
+              << " " << counts[i] << "\n";
+        }
+
+        oss << name << "_bucket" << FormatLabels(series.mLabels, "le", "+Inf")
+            << " " << counts.back() << "\n"
+            << name << "_sum" << entry.first << " "
+            << FormatValue(series.mHistogram->GetSum()) << "\n"
+            << name << "_count" << entry.first << " " << counts.back() << "\n";
+      }
+    }
+  }
+
+  return oss.str();
+}
+
+EOSCOMMONNAMESPACE_END
@@ -0,0 +1,258 @@
+//------------------------------------------------------------------------------
+//! @file Metrics.hh
+//! @brief Lock-free counters, gauges and histograms exposed in the Prometheus
+//!        text format
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "common/Namespace.hh"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//! Label set of a metric e.g. {{"op", "open"}}
+typedef std::map<std::string, std::string> MetricLabels;
+
+//------------------------------------------------------------------------------
+//! Monotonic counter. The value is spread over a few cache lines indexed by
+//! thread so that hot counters updated by many threads do not bounce.
+//------------------------------------------------------------------------------
+class MetricCounter
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Increment the counter
+  //----------------------------------------------------------------------------
+  inline void Inc(uint64_t value = 1)
+  {
+    mShards[GetShard()].mValue.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the current value
+  //----------------------------------------------------------------------------
+  uint64_t Get() const;
+
+private:
+  static constexpr size_t kNumShards = 16;
+
+  //----------------------------------------------------------------------------
+  //! Shard of the calling thread
+  //----------------------------------------------------------------------------
+  static size_t GetShard();
+
+  //! Padded to a cache line, alignas would need the C++17 aligned new
+  struct Shard {
+    std::atomic<uint64_t> mValue {0};
+    char mPadding[64 - sizeof(std::atomic<uint64_t>)];
+  };
+
+  Shard mShards[kNumShards];
+};
+
+//------------------------------------------------------------------------------
+//! Gauge holding a floating point value
+//------------------------------------------------------------------------------
+class MetricGauge
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Set the value
+  //----------------------------------------------------------------------------
+  void Set(double value);
+
+  //----------------------------------------------------------------------------
+  //! Add to the value, can be negative
+  //----------------------------------------------------------------------------
+  void Add(double delta);
+
+  //----------------------------------------------------------------------------
+  //! Get the current value
+  //----------------------------------------------------------------------------
+  double Get() const;
+
+private:
+  std::atomic<uint64_t> mBits {0}; ///< bit pattern of the double value
+};
+
+//------------------------------------------------------------------------------
+//! Histogram with fixed upper bounds, cumulated only when exposed
+//------------------------------------------------------------------------------
+class MetricHistogram
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param bounds increasing upper bounds of the buckets, +Inf is implicit
+  //----------------------------------------------------------------------------
+  MetricHistogram(const std::vector<double>& bounds);
+
+  //----------------------------------------------------------------------------
+  //! Record a value
+  //----------------------------------------------------------------------------
+  void Observe(double value);
+
+  //----------------------------------------------------------------------------
+  //! Get the bucket bounds
+  //----------------------------------------------------------------------------
+  inline const std::vector<double>& GetBounds() const
+  {
+    return mBounds;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the cumulative counts, one per bound plus the +Inf one
+  //----------------------------------------------------------------------------
+  std::vector<uint64_t> GetCumulativeCounts() const;
+
+  //----------------------------------------------------------------------------
+  //! Get the sum of the recorded values
+  //----------------------------------------------------------------------------
+  inline double GetSum() const
+  {
+    return mSum.Get();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Default bounds for latencies in seconds, from 100us to 60s
+  //----------------------------------------------------------------------------
+  static const std::vector<double>& LatencyBounds();
+
+private:
+  std::vector<double> mBounds;
+  std::unique_ptr<std::atomic<uint64_t>[]> mCounts; ///< per bucket, not cumulated
+  MetricGauge mSum;
+};
+
+//------------------------------------------------------------------------------
+//! @brief Registry of the metrics of a daemon
+//!
+//! Subsystems register their metrics once, at startup or on first use, and
+//! keep the returned reference: registration and exposition take the registry
+//! mutex, updates never do. Metrics live as long as the registry. Values owned
+//! by some other object can be exposed through callbacks, which must not take
+//! any lock shared with the data path since they run on every scrape.
+//------------------------------------------------------------------------------
+class MetricsRegistry
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Get the registry of the process
+  //----------------------------------------------------------------------------
+  static MetricsRegistry& Instance();
+
+  //----------------------------------------------------------------------------
+  //! Get or create a counter
+  //!
+  //! @param name metric name, Prometheus conventions e.g. eos_mgm_ops_total
+  //! @param help description of the metric family
+  //! @param labels labels of this series
+  //----------------------------------------------------------------------------
+  MetricCounter& GetCounter(const std::string& name, const std::string& help,
+                            const MetricLabels& labels = {});
+
+  //----------------------------------------------------------------------------
+  //! Get or create a gauge
+  //----------------------------------------------------------------------------
+  MetricGauge& GetGauge(const std::string& name, const std::string& help,
+                        const MetricLabels& labels = {});
+
+  //----------------------------------------------------------------------------
+  //! Get or create a histogram
+  //!
+  //! @param bounds bucket bounds, only used when the histogram is created
+  //----------------------------------------------------------------------------
+  MetricHistogram& GetHistogram(const std::string& name,
+                                const std::string& help,
+                                const std::vector<double>& bounds =
+                                  MetricHistogram::LatencyBounds(),
+                                const MetricLabels& labels = {});
+
+  //----------------------------------------------------------------------------
+  //! Expose a value computed at scrape time as a gauge. The callback runs
+  //! with the registry mutex held and must not use the registry itself.
+  //----------------------------------------------------------------------------
+  void SetGaugeCallback(const std::string& name, const std::string& help,
+                        std::function<double()> callback,
+                        const MetricLabels& labels = {});
+
+  //----------------------------------------------------------------------------
+  //! Remove a callback, to be done before the object it reads is destroyed
+  //----------------------------------------------------------------------------
+  void RemoveGaugeCallback(const std::string& name,
+                           const MetricLabels& labels = {});
+
+  //----------------------------------------------------------------------------
+  //! Render all metrics in the Prometheus text exposition format 0.0.4
+  //----------------------------------------------------------------------------
+  std::string Expose() const;
+
+  //----------------------------------------------------------------------------
+  //! Render a label set as {key="value",...}, empty if there are no labels
+  //----------------------------------------------------------------------------
+  static std::string FormatLabels(const MetricLabels& labels,
+                                  const std::string& extra_key = "",
+                                  const std::string& extra_value = "");
+
+private:
+  enum class Type { kCounter, kGauge, kHistogram };
+
+  //----------------------------------------------------------------------------
+  //! One time series of a family
+  //----------------------------------------------------------------------------
+  struct Series {
+    MetricLabels mLabels;
+    std::unique_ptr<MetricCounter> mCounter;
+    std::unique_ptr<MetricGauge> mGauge;
+    std::unique_ptr<MetricHistogram> mHistogram;
+    std::function<double()> mCallback;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Metrics sharing a name
+  //----------------------------------------------------------------------------
+  struct Family {
+    Type mType;
+    std::string mHelp;
+    std::map<std::string, Series> mSeries; ///< keyed by formatted labels
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the series, creating family and series if needed. Needs mMutex.
+  //!
+  //! @throws std::invalid_argument if the name is used with another type
+  //----------------------------------------------------------------------------
+  Series& GetSeries(const std::string& name, const std::string& help,
+                    Type type, const MetricLabels& labels);
+
+  mutable std::mutex mMutex;
+  std::map<std::string, Family> mFamilies;
+};
+
+EOSCOMMONNAMESPACE_END
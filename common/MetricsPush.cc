@@ -0,0 +1,386 @@
+//------------------------------------------------------------------------------
+//! @file MetricsPush.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/MetricsPush.hh"
+#include "common/Metrics.hh"
+#include "common/Logging.hh"
+#include <arpa/inet.h>
+#include <curl/curl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+constexpr size_t MetricsPush::kMaxBatchSize;
+constexpr uint64_t MetricsPush::kFullEvery;
+constexpr size_t MetricsPush::kBurstSize;
+
+//------------------------------------------------------------------------------
+// Pack the samples of an exposition into batches
+//------------------------------------------------------------------------------
+std::vector<std::string>
+MetricsPush::MakeBatches(const std::string& exposition,
+                         const std::string& header, size_t max_size,
+                         std::map<std::string, std::string>& last, bool full)
+{
+  std::vector<std::string> lines;
+  std::map<std::string, std::string> current;
+  size_t pos = 0;
+
+  while (pos < exposition.length()) {
+    size_t end = exposition.find('\n', pos);
+
+    if (end == std::string::npos) {
+      end = exposition.length();
+    }
+
+    // Comments are left out, the collectors know the metric types
+    if ((end > pos) && (exposition[pos] != '#')) {
+      std::string line = exposition.substr(pos, end - pos);
+      size_t spos = line.rfind(' ');
+
+      if ((spos != std::string::npos) && (spos > 0)) {
+        std::string series = line.substr(0, spos);
+        std::string value = line.substr(spos + 1);
+        auto it = last.find(series);
+
+        if (full || (it == last.end()) || (it->second != value)) {
+          lines.push_back(std::move(line));
+        }
+
+        current[series] = value;
+      }
+    }
+
+    pos = end + 1;
+  }
+
+  // Series gone from the registry are forgotten
+  last.swap(current);
+  std::vector<std::string> bodies;
+
+  if (lines.empty()) {
+    return bodies;
+  }
+
+  // Room for " <part>/<parts> delta\n", a line longer than a batch goes alone
+  const size_t budget = header.length() + 32;
+  std::string body;
+
+  for (const auto& line : lines) {
+    if (!body.empty() &&
+        (budget + body.length() + line.length() + 1 > max_size)) {
+      bodies.push_back(std::move(body));
+      body.clear();
+    }
+
+    body += line;
+    body += '\n';
+  }
+
+  bodies.push_back(std::move(body));
+  std::vector<std::string> batches;
+  const std::string kind = (full ? "full" : "delta");
+
+  for (size_t i = 0; i < bodies.size(); ++i) {
+    batches.push_back(header + " " + std::to_string(i + 1) + "/" +
+                      std::to_string(bodies.size()) + " " + kind + "\n" +
+                      bodies[i]);
+  }
+
+  return batches;
+}
+
+//------------------------------------------------------------------------------
+// Get the push interval configured in the environment
+//------------------------------------------------------------------------------
+int
+MetricsPush::GetIntervalFromEnv()
+{
+  const char* ptr = getenv("EOS_MONITORING_PUSH_INTERVAL");
+  long val = (ptr ? strtol(ptr, nullptr, 10) : 0);
+  return (val > 0 ? (int) val : 0);
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+MetricsPush::MetricsPush(MetricsRegistry* registry):
+  mRegistry(registry ? registry : &MetricsRegistry::Instance())
+{
+  char host[256] = {0};
+
+  if (gethostname(host, sizeof(host) - 1) == 0) {
+    mHostName = host;
+  } else {
+    mHostName = "localhost";
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+MetricsPush::~MetricsPush()
+{
+  Stop();
+
+  if (mSocket >= 0) {
+    close(mSocket);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Start the push thread
+//------------------------------------------------------------------------------
+void
+MetricsPush::Start(const std::string& daemon, int interval)
+{
+  if (interval <= 0) {
+    return;
+  }
+
+  Stop();
+  mDaemon = daemon;
+  mInterval = interval;
+
+  if (mSocket < 0) {
+    mSocket = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (mSocket < 0) {
+      eos_static_err("msg=\"failed to create the metrics push socket\" "
+                     "errno=%d", errno);
+    }
+  }
+
+  mThread.reset(&MetricsPush::Run, this);
+}
+
+//------------------------------------------------------------------------------
+// Stop the push thread
+//------------------------------------------------------------------------------
+void
+MetricsPush::Stop()
+{
+  mThread.join();
+}
+
+//------------------------------------------------------------------------------
+// Set the targets
+//------------------------------------------------------------------------------
+void
+MetricsPush::SetTargets(const std::string& targets)
+{
+  std::vector<UdpTarget> udp_targets;
+  std::vector<std::string> http_targets;
+  size_t pos = 0;
+
+  while (pos <= targets.length()) {
+    size_t end = targets.find_first_of("|,", pos);
+
+    if (end == std::string::npos) {
+      end = targets.length();
+    }
+
+    std::string target = targets.substr(pos, end - pos);
+    pos = end + 1;
+
+    if (target.empty()) {
+      continue;
+    }
+
+    if ((target.find("http://") == 0) || (target.find("https://") == 0)) {
+      http_targets.push_back(target);
+      continue;
+    }
+
+    std::string host = target;
+    std::string port = "31000";
+    size_t spos = target.rfind(':');
+
+    if (spos != std::string::npos) {
+      host = target.substr(0, spos);
+      port = target.substr(spos + 1);
+    }
+
+    struct addrinfo hints;
+    struct addrinfo* res = nullptr;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) || !res) {
+      eos_static_err("msg=\"failed to resolve metrics push target\" "
+                     "target=%s", target.c_str());
+      continue;
+    }
+
+    UdpTarget udp_target;
+    udp_target.mName = target;
+    memcpy(&udp_target.mAddr, res->ai_addr, sizeof(udp_target.mAddr));
+    freeaddrinfo(res);
+    udp_targets.push_back(udp_target);
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mTargets = targets;
+  mUdpTargets.swap(udp_targets);
+  mHttpTargets.swap(http_targets);
+}
+
+//------------------------------------------------------------------------------
+// Get the targets as set
+//------------------------------------------------------------------------------
+std::string
+MetricsPush::GetTargets() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mTargets;
+}
+
+//------------------------------------------------------------------------------
+// Push thread loop
+//------------------------------------------------------------------------------
+void
+MetricsPush::Run(ThreadAssistant& assistant) noexcept
+{
+  eos_static_info("msg=\"started metrics push\" daemon=%s interval=%d",
+                  mDaemon.c_str(), mInterval);
+
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(std::chrono::seconds(mInterval));
+
+    if (assistant.terminationRequested()) {
+      break;
+    }
+
+    Push(assistant);
+  }
+
+  eos_static_info("msg=\"stopped metrics push\" daemon=%s", mDaemon.c_str());
+}
+
+//------------------------------------------------------------------------------
+// Push one snapshot of the registry to all the targets
+//------------------------------------------------------------------------------
+void
+MetricsPush::Push(ThreadAssistant& assistant)
+{
+  std::vector<UdpTarget> udp_targets;
+  std::vector<std::string> http_targets;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    udp_targets = mUdpTargets;
+    http_targets = mHttpTargets;
+  }
+
+  if (udp_targets.empty() && http_targets.empty()) {
+    return;
+  }
+
+  const bool full = ((mSeq % kFullEvery) == 0);
+  std::string header = "#eos " + mDaemon + " " + mHostName + " " +
+                       std::to_string(time(nullptr)) + " " +
+                       std::to_string(mSeq);
+  ++mSeq;
+  std::vector<std::string> batches = MakeBatches(mRegistry->Expose(), header,
+                                     kMaxBatchSize, mLast, full);
+
+  if (batches.empty()) {
+    return;
+  }
+
+  if (mSocket >= 0) {
+    for (const auto& target : udp_targets) {
+      for (size_t i = 0; i < batches.size(); ++i) {
+        if (i && ((i % kBurstSize) == 0)) {
+          assistant.wait_for(std::chrono::milliseconds(10));
+
+          if (assistant.terminationRequested()) {
+            return;
+          }
+        }
+
+        if (sendto(mSocket, batches[i].c_str(), batches[i].length(), 0,
+                   (const struct sockaddr*) &target.mAddr,
+                   sizeof(target.mAddr)) < 0) {
+          eos_static_debug("msg=\"failed to push metrics\" target=%s errno=%d",
+                           target.mName.c_str(), errno);
+          break;
+        }
+      }
+    }
+  }
+
+  for (const auto& url : http_targets) {
+    if (!HttpPost(url, batches)) {
+      eos_static_debug("msg=\"failed to push metrics\" target=%s",
+                       url.c_str());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// POST the batches of a push to an HTTP target
+//------------------------------------------------------------------------------
+bool
+MetricsPush::HttpPost(const std::string& url,
+                      const std::vector<std::string>& batches)
+{
+  std::string body;
+
+  for (const auto& batch : batches) {
+    body += batch;
+  }
+
+  CURL* curl = curl_easy_init();
+
+  if (!curl) {
+    return false;
+  }
+
+  struct curl_slist* headers = curl_slist_append(nullptr,
+                               "Content-Type: text/plain");
+  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+  curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+  curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long) body.length());
+  curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L);
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+  CURLcode rc = curl_easy_perform(curl);
+  long status = 0;
+
+  if (rc == CURLE_OK) {
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+  }
+
+  curl_slist_free_all(headers);
+  curl_easy_cleanup(curl);
+  return ((rc == CURLE_OK) && (status >= 200) && (status < 300));
+}
+
+EOSCOMMONNAMESPACE_END
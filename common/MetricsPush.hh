@@ -0,0 +1,165 @@
+//------------------------------------------------------------------------------
+//! @file MetricsPush.hh
+//! @brief Periodic push of the metrics registry to UDP and HTTP collectors
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "common/Namespace.hh"
+#include "common/AssistedThread.hh"
+#include <map>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <vector>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+class MetricsRegistry;
+
+//------------------------------------------------------------------------------
+//! @brief In-process push of the metrics of a daemon, replacing the external
+//! collectors which fork commands and scrape the daemon
+//!
+//! Every interval the registry is rendered once and its samples are packed
+//! into batches of at most kMaxBatchSize bytes, each one a datagram for the
+//! UDP targets. A batch starts with the header line
+//! "#eos <daemon> <host> <time> <seq> <part>/<parts> full|delta" followed by
+//! "<series> <value>" lines in the Prometheus sample syntax. Only the series
+//! whose value changed since the previous push are sent, every kFullEvery
+//! pushes the full snapshot is sent so that collectors recover from lost
+//! datagrams. The datagrams are paced in bursts of kBurstSize to not flood
+//! the receive buffers of the collectors.
+//!
+//! The targets are host:port for UDP, default port 31000 like the Iostat
+//! UDP targets, or http(s):// URLs receiving all the batches of a push in
+//! one POST request.
+//------------------------------------------------------------------------------
+class MetricsPush
+{
+public:
+  //! Max size of a batch, fits in an unfragmented datagram
+  static constexpr size_t kMaxBatchSize = 1400;
+  //! Every how many pushes the full snapshot is sent
+  static constexpr uint64_t kFullEvery = 10;
+  //! Number of datagrams sent without pause
+  static constexpr size_t kBurstSize = 32;
+
+  //----------------------------------------------------------------------------
+  //! Pack the samples of an exposition into batches
+  //!
+  //! @param exposition registry rendered in the Prometheus text format
+  //! @param header start of the first line of every batch, the part, the
+  //!        number of parts and full|delta are appended
+  //! @param max_size max size of a batch
+  //! @param last values of the series sent so far, updated
+  //! @param full if true send all the series, otherwise only the changed ones
+  //!
+  //! @return batches, empty if there is nothing to send
+  //----------------------------------------------------------------------------
+  static std::vector<std::string>
+  MakeBatches(const std::string& exposition, const std::string& header,
+              size_t max_size, std::map<std::string, std::string>& last,
+              bool full);
+
+  //----------------------------------------------------------------------------
+  //! Get the push interval configured in EOS_MONITORING_PUSH_INTERVAL
+  //!
+  //! @return seconds between two pushes, 0 if the push is disabled
+  //----------------------------------------------------------------------------
+  static int GetIntervalFromEnv();
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param registry registry to push, the one of the process by default
+  //----------------------------------------------------------------------------
+  MetricsPush(MetricsRegistry* registry = nullptr);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~MetricsPush();
+
+  //----------------------------------------------------------------------------
+  //! Start the push thread
+  //!
+  //! @param daemon name of the daemon in the batch header e.g. mgm or fst
+  //! @param interval seconds between two pushes, nothing is done if 0
+  //----------------------------------------------------------------------------
+  void Start(const std::string& daemon, int interval);
+
+  //----------------------------------------------------------------------------
+  //! Stop the push thread
+  //----------------------------------------------------------------------------
+  void Stop();
+
+  //----------------------------------------------------------------------------
+  //! Set the targets
+  //!
+  //! @param targets list of targets separated by '|' or ','
+  //----------------------------------------------------------------------------
+  void SetTargets(const std::string& targets);
+
+  //----------------------------------------------------------------------------
+  //! Get the targets as set
+  //----------------------------------------------------------------------------
+  std::string GetTargets() const;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Resolved UDP target
+  //----------------------------------------------------------------------------
+  struct UdpTarget {
+    std::string mName;
+    struct sockaddr_in mAddr;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Push thread loop
+  //----------------------------------------------------------------------------
+  void Run(ThreadAssistant& assistant) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Push one snapshot of the registry to all the targets
+  //----------------------------------------------------------------------------
+  void Push(ThreadAssistant& assistant);
+
+  //----------------------------------------------------------------------------
+  //! POST the batches of a push to an HTTP target
+  //----------------------------------------------------------------------------
+  static bool HttpPost(const std::string& url,
+                       const std::vector<std::string>& batches);
+
+  MetricsRegistry* mRegistry; ///< registry to push
+  AssistedThread mThread; ///< push thread
+  std::string mDaemon; ///< daemon name in the header
+  std::string mHostName; ///< host name in the header
+  int mInterval {0}; ///< seconds between two pushes
+  int mSocket {-1}; ///< UDP socket used for all the targets
+  mutable std::mutex mMutex; ///< protects the targets
+  std::string mTargets; ///< targets as set
+  std::vector<UdpTarget> mUdpTargets; ///< resolved UDP targets
+  std::vector<std::string> mHttpTargets; ///< HTTP URLs
+  std::map<std::string, std::string> mLast; ///< values last sent per series
+  uint64_t mSeq {0}; ///< number of pushes done
+};
+
+EOSCOMMONNAMESPACE_END
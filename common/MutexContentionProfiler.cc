@@ -0,0 +1,452 @@
+//------------------------------------------------------------------------------
+// File: MutexContentionProfiler.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/MutexContentionProfiler.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+std::atomic<uint32_t> MutexContentionProfiler::sModulo {0};
+std::atomic<uint64_t> MutexContentionProfiler::sMinWaitNs {1000};
+thread_local int64_t MutexContentionProfiler::sThreadCountdown {0};
+
+namespace
+{
+//! Slots of a per-thread table and maximum probes before dropping a sample
+constexpr size_t kTableSlots = 512;
+constexpr size_t kMaxProbes = 16;
+constexpr size_t kNameLength = 32;
+
+//------------------------------------------------------------------------------
+//! Contention of one tuple. Only the owner thread writes an entry, the fields
+//! are atomics so that the report can be built while samples come in.
+//------------------------------------------------------------------------------
+struct Entry {
+  std::atomic<uint64_t> mKey {0}; ///< 0 if free, published last
+  std::atomic<uintptr_t> mMutex {0};
+  std::atomic<uintptr_t> mWaiter {0};
+  std::atomic<uintptr_t> mHolder {0};
+  std::atomic<bool> mWrite {false};
+  std::atomic<uint64_t> mCount {0};
+  std::atomic<uint64_t> mTotalNs {0};
+  std::atomic<uint64_t> mMaxNs {0};
+  char mName[kNameLength] {};
+};
+
+//------------------------------------------------------------------------------
+//! Open addressing table owned by one thread at a time
+//------------------------------------------------------------------------------
+struct Table {
+  std::atomic<bool> mInUse {true};
+  std::atomic<uint64_t> mEpoch {0};
+  std::atomic<uint64_t> mDropped {0};
+  Entry mEntries[kTableSlots];
+};
+
+//------------------------------------------------------------------------------
+//! Tables of all threads, never released so that they can be reused
+//------------------------------------------------------------------------------
+struct Registry {
+  std::mutex mMutex;
+  std::vector<std::unique_ptr<Table>> mTables;
+  std::atomic<uint64_t> mEpoch {0}; ///< bumped by every reset
+};
+
+Registry&
+GetRegistry()
+{
+  // Leaked on purpose, threads may still record during static destruction
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+//------------------------------------------------------------------------------
+//! Releases the table of a thread when the thread exits
+//------------------------------------------------------------------------------
+struct TableHandle {
+  Table* mTable {nullptr};
+
+  ~TableHandle()
+  {
+    if (mTable) {
+      mTable->mInUse.store(false, std::memory_order_release);
+    }
+  }
+};
+
+thread_local TableHandle tHandle;
+
+//------------------------------------------------------------------------------
+//! Get the table of the calling thread, reusing the one of an exited thread
+//------------------------------------------------------------------------------
+Table*
+GetThreadTable()
+{
+  if (tHandle.mTable) {
+    return tHandle.mTable;
+  }
+
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mMutex);
+
+  for (auto& table : registry.mTables) {
+    bool in_use = false;
+
+    if (table->mInUse.compare_exchange_strong(in_use, true)) {
+      tHandle.mTable = table.get();
+      return tHandle.mTable;
+    }
+  }
+
+  registry.mTables.emplace_back(new Table());
+  tHandle.mTable = registry.mTables.back().get();
+  tHandle.mTable->mEpoch = registry.mEpoch.load();
+  return tHandle.mTable;
+}
+
+//------------------------------------------------------------------------------
+//! Hash of a tuple, never 0
+//------------------------------------------------------------------------------
+inline uint64_t
+HashTuple(uintptr_t mutex, bool write, uintptr_t waiter, uintptr_t holder)
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+
+  for (uint64_t value : {
+         (uint64_t) mutex, (uint64_t) waiter, (uint64_t) holder, (uint64_t) write
+       }) {
+    hash ^= value;
+    hash *= 0x100000001b3ull;
+    hash ^= (hash >> 29);
+  }
+
+  return hash | 1;
+}
+}
+
+//------------------------------------------------------------------------------
+// Enable or disable the profiler
+//------------------------------------------------------------------------------
+void
+MutexContentionProfiler::SetSampling(double rate, uint64_t min_wait_ns)
+{
+  uint32_t modulo = 0;
+
+  if (rate > 0) {
+    modulo = (rate >= 1.0) ? 1 : (uint32_t) std::lround(1.0 / rate);
+  }
+
+  sMinWaitNs = min_wait_ns;
+  sModulo = modulo;
+}
+
+//------------------------------------------------------------------------------
+// Get the sampling rate
+//------------------------------------------------------------------------------
+double
+MutexContentionProfiler::GetSampling()
+{
+  uint32_t modulo = sModulo.load();
+  return modulo ? 1.0 / modulo : 0.0;
+}
+
+//------------------------------------------------------------------------------
+// Draw the number of locks until the next sample
+//------------------------------------------------------------------------------
+int64_t
+MutexContentionProfiler::NextInterval(uint32_t modulo)
+{
+  static thread_local uint64_t state = 0;
+
+  if (state == 0) {
+    state = (uint64_t)(uintptr_t) &state | 1;
+  }
+
+  // xorshift64, uniform in [1, 2 * modulo - 1]
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return 1 + (int64_t)(state % (2 * (uint64_t) modulo - 1));
+}
+
+//------------------------------------------------------------------------------
+// Account a sampled wait to the table of the calling thread
+//------------------------------------------------------------------------------
+void
+MutexContentionProfiler::Record(const void* mutex, const char* name,
+                                bool write, uintptr_t waiter, uintptr_t holder,
+                                uint64_t wait_ns)
+{
+  if (wait_ns < sMinWaitNs.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  Table* table = GetThreadTable();
+  uint64_t epoch = GetRegistry().mEpoch.load(std::memory_order_acquire);
+
+  if (table->mEpoch.load(std::memory_order_relaxed) != epoch) {
+    // A reset happened since the last sample, clear before publishing again
+    for (auto& entry : table->mEntries) {
+      entry.mKey.store(0, std::memory_order_relaxed);
+    }
+
+    table->mDropped.store(0, std::memory_order_relaxed);
+    table->mEpoch.store(epoch, std::memory_order_release);
+  }
+
+  uintptr_t mtx = (uintptr_t) mutex;
+  uint64_t key = HashTuple(mtx, write, waiter, holder);
+
+  for (size_t probe = 0; probe < kMaxProbes; ++probe) {
+    Entry& entry = table->mEntries[(key + probe) % kTableSlots];
+    uint64_t slot_key = entry.mKey.load(std::memory_order_relaxed);
+
+    if (slot_key == 0) {
+      entry.mMutex.store(mtx, std::memory_order_relaxed);
+      entry.mWaiter.store(waiter, std::memory_order_relaxed);
+      entry.mHolder.store(holder, std::memory_order_relaxed);
+      entry.mWrite.store(write, std::memory_order_relaxed);
+      entry.mCount.store(1, std::memory_order_relaxed);
+      entry.mTotalNs.store(wait_ns, std::memory_order_relaxed);
+      entry.mMaxNs.store(wait_ns, std::memory_order_relaxed);
+      strncpy(entry.mName, name ? name : "", kNameLength - 1);
+      entry.mName[kNameLength - 1] = '\0';
+      entry.mKey.store(key, std::memory_order_release);
+      return;
+    }
+
+    if ((slot_key == key) &&
+        (entry.mMutex.load(std::memory_order_relaxed) == mtx) &&
+        (entry.mWaiter.load(std::memory_order_relaxed) == waiter) &&
+        (entry.mHolder.load(std::memory_order_relaxed) == holder) &&
+        (entry.mWrite.load(std::memory_order_relaxed) == write)) {
+      // Single writer, so plain load/store instead of read-modify-write
+      entry.mCount.store(entry.mCount.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+      entry.mTotalNs.store(entry.mTotalNs.load(std::memory_order_relaxed) +
+                           wait_ns, std::memory_order_relaxed);
+
+      if (wait_ns > entry.mMaxNs.load(std::memory_order_relaxed)) {
+        entry.mMaxNs.store(wait_ns, std::memory_order_relaxed);
+      }
+
+      return;
+    }
+  }
+
+  table->mDropped.store(table->mDropped.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+// Merge the tables of all threads and return the most contended sites
+//------------------------------------------------------------------------------
+std::vector<MutexContentionProfiler::Site>
+MutexContentionProfiler::GetTopSites(size_t max_sites)
+{
+  typedef std::tuple<uintptr_t, bool, uintptr_t, uintptr_t> TupleKey;
+  std::map<TupleKey, Site> merged;
+  Registry& registry = GetRegistry();
+  uint64_t epoch = registry.mEpoch.load(std::memory_order_acquire);
+  std::lock_guard<std::mutex> lock(registry.mMutex);
+
+  for (auto& table : registry.mTables) {
+    if (table->mEpoch.load(std::memory_order_acquire) != epoch) {
+      // Samples from before the last reset
+      continue;
+    }
+
+    for (auto& entry : table->mEntries) {
+      if (entry.mKey.load(std::memory_order_acquire) == 0) {
+        continue;
+      }
+
+      uintptr_t mtx = entry.mMutex.load(std::memory_order_relaxed);
+      TupleKey tkey(mtx, entry.mWrite.load(std::memory_order_relaxed),
+                    entry.mWaiter.load(std::memory_order_relaxed),
+                    entry.mHolder.load(std::memory_order_relaxed));
+      Site& site = merged[tkey];
+
+      if (site.mCount == 0) {
+        site.mWrite = std::get<1>(tkey);
+        site.mWaiter = std::get<2>(tkey);
+        site.mHolder = std::get<3>(tkey);
+        char name[kNameLength];
+        memcpy(name, entry.mName, kNameLength);
+        name[kNameLength - 1] = '\0';
+
+        if (name[0]) {
+          site.mMutex = name;
+        } else {
+          std::ostringstream oss;
+          oss << "0x" << std::hex << mtx;
+          site.mMutex = oss.str();
+        }
+      }
+
+      site.mCount += entry.mCount.load(std::memory_order_relaxed);
+      site.mTotalNs += entry.mTotalNs.load(std::memory_order_relaxed);
+      site.mMaxNs = std::max(site.mMaxNs,
+                             entry.mMaxNs.load(std::memory_order_relaxed));
+    }
+  }
+
+  std::vector<Site> sites;
+  sites.reserve(merged.size());
+
+  for (auto& elem : merged) {
+    sites.push_back(std::move(elem.second));
+  }
+
+  std::sort(sites.begin(), sites.end(), [](const Site & a, const Site & b) {
+    return a.mTotalNs > b.mTotalNs;
+  });
+
+  if (sites.size() > max_sites) {
+    sites.resize(max_sites);
+  }
+
+  return sites;
+}
+
+//------------------------------------------------------------------------------
+// Number of samples dropped because the table of their thread was full
+//------------------------------------------------------------------------------
+uint64_t
+MutexContentionProfiler::GetDropped()
+{
+  Registry& registry = GetRegistry();
+  uint64_t epoch = registry.mEpoch.load();
+  uint64_t dropped = 0;
+  std::lock_guard<std::mutex> lock(registry.mMutex);
+
+  for (auto& table : registry.mTables) {
+    if (table->mEpoch.load() == epoch) {
+      dropped += table->mDropped.load(std::memory_order_relaxed);
+    }
+  }
+
+  return dropped;
+}
+
+//------------------------------------------------------------------------------
+// Forget all collected samples
+//------------------------------------------------------------------------------
+void
+MutexContentionProfiler::Reset()
+{
+  // Tables are cleared lazily by their owner on the next sample
+  GetRegistry().mEpoch++;
+}
+
+//------------------------------------------------------------------------------
+// Resolve a call site into "function+offset" when possible
+//------------------------------------------------------------------------------
+std::string
+MutexContentionProfiler::Symbolize(uintptr_t address)
+{
+  std::ostringstream oss;
+
+  if (address == 0) {
+    return "unknown";
+  }
+
+  void* addr = (void*) address;
+  char** symbols = backtrace_symbols(&addr, 1);
+
+  if (symbols) {
+    // Format is "binary(mangled+0xoffset) [0xaddress]"
+    std::string symbol = symbols[0];
+    free(symbols);
+    size_t begin = symbol.find('(');
+    size_t plus = symbol.find('+', begin);
+    size_t end = symbol.find(')', begin);
+
+    if ((begin != std::string::npos) && (plus != std::string::npos) &&
+        (end != std::string::npos) && (plus > begin + 1) && (plus < end)) {
+      std::string mangled = symbol.substr(begin + 1, plus - begin - 1);
+      int status = 0;
+      char* demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr,
+                                            &status);
+
+      if (status == 0 && demangled) {
+        oss << demangled;
+      } else {
+        oss << mangled;
+      }
+
+      free(demangled);
+      oss << symbol.substr(plus, end - plus);
+      return oss.str();
+    }
+  }
+
+  oss << "0x" << std::hex << address;
+  return oss.str();
+}
+
+//------------------------------------------------------------------------------
+// Print a human readable report of the most contended sites
+//------------------------------------------------------------------------------
+std::string
+MutexContentionProfiler::Dump(size_t max_sites)
+{
+  std::ostringstream oss;
+  auto sites = GetTopSites(max_sites);
+  double rate = GetSampling();
+  oss << "# contention profiling is " << (rate > 0 ? "on" : "off");
+
+  if (rate > 0) {
+    oss << " (sampling rate " << rate << ", contended above "
+        << sMinWaitNs.load() << " nsec)";
+  }
+
+  oss << std::endl
+      << "# dropped samples: " << GetDropped() << std::endl;
+
+  for (const auto& site : sites) {
+    oss << "mutex=" << site.mMutex
+        << " type=" << (site.mWrite ? "write" : "read")
+        << " samples=" << site.mCount
+        << " total_wait_ms=" << std::fixed << std::setprecision(3)
+        << site.mTotalNs / 1e6
+        << " avg_wait_us=" << site.mTotalNs / 1e3 / site.mCount
+        << " max_wait_us=" << site.mMaxNs / 1e3 << std::endl
+        << "    waiter: " << Symbolize(site.mWaiter) << std::endl
+        << "    holder: " << Symbolize(site.mHolder) << std::endl;
+  }
+
+  return oss.str();
+}
+
+EOSCOMMONNAMESPACE_END
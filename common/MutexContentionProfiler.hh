@@ -0,0 +1,157 @@
+//------------------------------------------------------------------------------
+//! @file MutexContentionProfiler.hh
+//! @brief Sampling profiler of the lock contention of RWMutex call sites
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "common/Namespace.hh"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Continuous, sampling lock contention profiler
+//!
+//! On average one lock acquisition out of N is timed. If the thread had to
+//! wait longer than a threshold, the wait is accounted to the tuple (mutex,
+//! lock type, waiter call site, holder call site) in a table owned by the
+//! calling thread, so that recording needs neither locks nor atomic
+//! read-modify-write operations. The holder call site is the one of the last write lock or of
+//! the last sampled read lock of the mutex, which is the likely culprit but not
+//! necessarily the thread still holding it. Tables are only read when somebody
+//! asks for the top contended call sites and survive the exit of their thread.
+//! When the profiler is disabled the cost per lock is one relaxed load.
+//------------------------------------------------------------------------------
+class MutexContentionProfiler
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Contention accounted to one tuple of call sites
+  //----------------------------------------------------------------------------
+  struct Site {
+    std::string mMutex; ///< debug name of the mutex or its address
+    bool mWrite {false}; ///< waiter asked for a write lock
+    uintptr_t mWaiter {0}; ///< return address of the waiting lock call
+    uintptr_t mHolder {0}; ///< return address of the likely holder
+    uint64_t mCount {0}; ///< contended samples
+    uint64_t mTotalNs {0}; ///< total sampled wait
+    uint64_t mMaxNs {0}; ///< longest sampled wait
+  };
+
+  //----------------------------------------------------------------------------
+  //! Enable or disable the profiler
+  //!
+  //! @param rate fraction of the lock acquisitions to time, 0 disables it
+  //! @param min_wait_ns waits shorter than this are not considered contended
+  //----------------------------------------------------------------------------
+  static void SetSampling(double rate, uint64_t min_wait_ns = 1000);
+
+  //----------------------------------------------------------------------------
+  //! Get the sampling rate, 0 if the profiler is disabled
+  //----------------------------------------------------------------------------
+  static double GetSampling();
+
+  //----------------------------------------------------------------------------
+  //! Check if the profiler is enabled
+  //----------------------------------------------------------------------------
+  static inline bool IsEnabled()
+  {
+    return (sModulo.load(std::memory_order_relaxed) != 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Decide if the current lock acquisition should be timed
+  //----------------------------------------------------------------------------
+  static inline bool Sample()
+  {
+    uint32_t modulo = sModulo.load(std::memory_order_relaxed);
+
+    if (modulo == 0) {
+      return false;
+    }
+
+    // A countdown drawn for a lower rate is cut short
+    if ((--sThreadCountdown > 0) && (sThreadCountdown < 2 * (int64_t) modulo)) {
+      return false;
+    }
+
+    // Randomized interval so that periodic lock patterns do not alias
+    sThreadCountdown = NextInterval(modulo);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Account a sampled wait to the table of the calling thread
+  //!
+  //! @param mutex address of the mutex
+  //! @param name debug name of the mutex, can be null
+  //! @param write waiter asked for a write lock
+  //! @param waiter return address of the waiting lock call
+  //! @param holder return address of the likely holder
+  //! @param wait_ns time spent waiting for the lock
+  //----------------------------------------------------------------------------
+  static void Record(const void* mutex, const char* name, bool write,
+                     uintptr_t waiter, uintptr_t holder, uint64_t wait_ns);
+
+  //----------------------------------------------------------------------------
+  //! Merge the tables of all threads and return the most contended sites
+  //!
+  //! @param max_sites number of sites to return
+  //!
+  //! @return sites sorted by decreasing total wait
+  //----------------------------------------------------------------------------
+  static std::vector<Site> GetTopSites(size_t max_sites);
+
+  //----------------------------------------------------------------------------
+  //! Number of samples dropped because the table of their thread was full
+  //----------------------------------------------------------------------------
+  static uint64_t GetDropped();
+
+  //----------------------------------------------------------------------------
+  //! Forget all collected samples
+  //----------------------------------------------------------------------------
+  static void Reset();
+
+  //----------------------------------------------------------------------------
+  //! Resolve a call site into "function+offset" when possible
+  //----------------------------------------------------------------------------
+  static std::string Symbolize(uintptr_t address);
+
+  //----------------------------------------------------------------------------
+  //! Print a human readable report of the most contended sites
+  //----------------------------------------------------------------------------
+  static std::string Dump(size_t max_sites);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Draw the number of locks until the next sample, sModulo on average
+  //----------------------------------------------------------------------------
+  static int64_t NextInterval(uint32_t modulo);
+
+  static std::atomic<uint32_t> sModulo; ///< 1 out of sModulo locks is timed
+  static std::atomic<uint64_t> sMinWaitNs;
+  static thread_local int64_t sThreadCountdown;
+};
+
+EOSCOMMONNAMESPACE_END
@@ -0,0 +1,529 @@
+//------------------------------------------------------------------------------
+// File: NssResolver.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/NssResolver.hh"
+#include "common/ThreadPool.hh"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <grp.h>
+#include <pwd.h>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+constexpr size_t NssResolver::sMaxEntries;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Parse a decimal uid/gid
+//------------------------------------------------------------------------------
+bool
+ParseId(const std::string& key, uint32_t& id)
+{
+  if (key.empty() || (key.length() > 10)) {
+    return false;
+  }
+
+  for (auto c : key) {
+    if (!isdigit(c)) {
+      return false;
+    }
+  }
+
+  unsigned long long value = strtoull(key.c_str(), nullptr, 10);
+
+  if (value > 0xffffffffull) {
+    return false;
+  }
+
+  id = (uint32_t) value;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Map the return code of a getpw* / getgr* call without a result, "not found"
+// is reported in several ways
+//------------------------------------------------------------------------------
+int
+NotFoundErrc(int rc)
+{
+  if ((rc == 0) || (rc == ENOENT) || (rc == ESRCH) || (rc == EBADF) ||
+      (rc == EPERM)) {
+    return ENOENT;
+  }
+
+  return rc;
+}
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+NssResolver::NssResolver(unsigned int threads, unsigned int ttl,
+                         unsigned int negative_ttl, unsigned int timeout_ms):
+  mBackend(&NssResolver::NssLookup), mThreads(threads ? threads : 1),
+  mTtl(ttl), mNegativeTtl(negative_ttl), mTimeoutMs(timeout_ms)
+{}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+NssResolver::~NssResolver()
+{
+  std::unique_ptr<ThreadPool> pool;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    pool.swap(mPool);
+  }
+
+  // Queued lookups still run and need the mutex
+  if (pool) {
+    pool->Stop();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Configure the resolver
+//------------------------------------------------------------------------------
+void
+NssResolver::Configure(unsigned int threads, unsigned int ttl,
+                       unsigned int negative_ttl, unsigned int timeout_ms)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mThreads = threads ? threads : 1;
+  mTtl = ttl;
+  mNegativeTtl = negative_ttl;
+  mTimeoutMs = timeout_ms;
+}
+
+//------------------------------------------------------------------------------
+// Replace the name service backend
+//------------------------------------------------------------------------------
+void
+NssResolver::SetBackend(Backend backend)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mBackend = backend;
+}
+
+//------------------------------------------------------------------------------
+// Synchronous lookup
+//------------------------------------------------------------------------------
+int
+NssResolver::Lookup(Type type, const std::string& key, Reply& reply)
+{
+  std::string ckey = static_cast<char>(type) + key;
+  std::shared_future<Reply> future;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto now = std::chrono::steady_clock::now();
+    auto it = mCache.find(ckey);
+
+    if ((it != mCache.end()) && it->second.mValid &&
+        (now < it->second.mExpires)) {
+      reply = it->second.mReply;
+
+      if (reply.mErrc) {
+        ++mNegativeHits;
+      } else {
+        ++mHits;
+
+        if (now >= it->second.mRefresh) {
+          Schedule(ckey, it->second);
+        }
+      }
+
+      return reply.mErrc;
+    }
+
+    ++mMisses;
+
+    if (it == mCache.end()) {
+      Purge(now);
+    }
+
+    Entry& entry = mCache[ckey];
+    Schedule(ckey, entry);
+    future = entry.mFuture;
+  }
+  unsigned int timeout_ms = mTimeoutMs;
+
+  if (timeout_ms && (future.wait_for(std::chrono::milliseconds(timeout_ms)) !=
+                     std::future_status::ready)) {
+    ++mTimeouts;
+    reply = Reply();
+    reply.mErrc = ETIMEDOUT;
+    return reply.mErrc;
+  }
+
+  reply = future.get();
+  return reply.mErrc;
+}
+
+//------------------------------------------------------------------------------
+// Asynchronous lookup
+//------------------------------------------------------------------------------
+void
+NssResolver::LookupAsync(Type type, const std::string& key, Callback cb)
+{
+  std::string ckey = static_cast<char>(type) + key;
+  Reply reply;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto now = std::chrono::steady_clock::now();
+    auto it = mCache.find(ckey);
+
+    if ((it == mCache.end()) || !it->second.mValid ||
+        (now >= it->second.mExpires)) {
+      ++mMisses;
+
+      if (it == mCache.end()) {
+        Purge(now);
+      }
+
+      Entry& entry = mCache[ckey];
+      entry.mCallbacks.push_back(std::move(cb));
+      Schedule(ckey, entry);
+      return;
+    }
+
+    reply = it->second.mReply;
+
+    if (reply.mErrc) {
+      ++mNegativeHits;
+    } else {
+      ++mHits;
+
+      if (now >= it->second.mRefresh) {
+        Schedule(ckey, it->second);
+      }
+    }
+  }
+  cb(reply);
+}
+
+//------------------------------------------------------------------------------
+// Queue lookups for the keys which are not cached or about to expire
+//------------------------------------------------------------------------------
+void
+NssResolver::Prefetch(Type type, const std::vector<std::string>& keys)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto now = std::chrono::steady_clock::now();
+
+  for (const auto& key : keys) {
+    std::string ckey = static_cast<char>(type) + key;
+    auto it = mCache.find(ckey);
+
+    if (it == mCache.end()) {
+      Purge(now);
+      Schedule(ckey, mCache[ckey]);
+    } else if (!it->second.mValid || (now >= it->second.mRefresh)) {
+      Schedule(ckey, it->second);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop all cached entries
+//------------------------------------------------------------------------------
+void
+NssResolver::Clear()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (auto it = mCache.begin(); it != mCache.end();) {
+    if (it->second.mPending) {
+      // The running lookup stores a fresh answer
+      it->second.mValid = false;
+      ++it;
+    } else {
+      it = mCache.erase(it);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the statistics
+//------------------------------------------------------------------------------
+NssResolver::Stats
+NssResolver::GetStats()
+{
+  Stats stats;
+  stats.mHits = mHits;
+  stats.mNegativeHits = mNegativeHits;
+  stats.mMisses = mMisses;
+  stats.mTimeouts = mTimeouts;
+  stats.mLookups = mLookups;
+  stats.mFailures = mFailures;
+  stats.mSumLatencyUs = mSumLatencyUs;
+  stats.mMaxLatencyUs = mMaxLatencyUs;
+  std::lock_guard<std::mutex> lock(mMutex);
+  stats.mEntries = mCache.size();
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Schedule a lookup of the key unless one is pending
+//------------------------------------------------------------------------------
+void
+NssResolver::Schedule(const std::string& ckey, Entry& entry)
+{
+  if (entry.mPending) {
+    return;
+  }
+
+  entry.mPending = true;
+  entry.mPromise = std::make_shared<std::promise<Reply>>();
+  entry.mFuture = entry.mPromise->get_future().share();
+
+  if (!mPool) {
+    mPool.reset(new ThreadPool(mThreads, mThreads, 10, 12, 10, "nss_resolver"));
+  }
+
+  mPool->PushTask<void>([this, ckey]() {
+    Resolve(ckey);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Run the lookup of a cache key on a worker
+//------------------------------------------------------------------------------
+void
+NssResolver::Resolve(const std::string& ckey)
+{
+  Type type = static_cast<Type>(ckey[0]);
+  std::string key = ckey.substr(1);
+  Backend backend;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    backend = mBackend;
+  }
+  Reply reply;
+  auto start = std::chrono::steady_clock::now();
+  backend(type, key, reply);
+  auto now = std::chrono::steady_clock::now();
+  uint64_t latency_us = std::chrono::duration_cast<std::chrono::microseconds>
+                        (now - start).count();
+  ++mLookups;
+  mSumLatencyUs += latency_us;
+  uint64_t max_us = mMaxLatencyUs;
+
+  while ((latency_us > max_us) &&
+         !mMaxLatencyUs.compare_exchange_weak(max_us, latency_us)) {}
+
+  if (reply.mErrc) {
+    ++mFailures;
+  }
+
+  // Only "not found" answers are cached negatively, other errors are retried
+  bool transient = reply.mErrc && (reply.mErrc != ENOENT);
+  std::shared_ptr<std::promise<Reply>> promise;
+  std::vector<Callback> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mCache.find(ckey);
+
+    if (it != mCache.end()) {
+      promise.swap(it->second.mPromise);
+      callbacks.swap(it->second.mCallbacks);
+      it->second.mPending = false;
+    }
+
+    Store(ckey, reply, transient, now);
+  }
+
+  if (promise) {
+    promise->set_value(reply);
+  }
+
+  for (auto& cb : callbacks) {
+    cb(reply);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Store a result in the cache
+//------------------------------------------------------------------------------
+void
+NssResolver::Store(const std::string& ckey, const Reply& reply, bool transient,
+                   std::chrono::steady_clock::time_point now)
+{
+  auto it = mCache.find(ckey);
+
+  if (it == mCache.end()) {
+    return;
+  }
+
+  Entry& entry = it->second;
+
+  if (transient) {
+    // Keep serving a previous positive answer until it expires
+    if (!entry.mValid) {
+      mCache.erase(it);
+    }
+
+    return;
+  }
+
+  unsigned int ttl = reply.mErrc ? mNegativeTtl.load() : mTtl.load();
+  entry.mReply = reply;
+  entry.mValid = true;
+  entry.mExpires = now + std::chrono::seconds(ttl);
+  // Positive entries used during the last 10% of their lifetime get refreshed
+  entry.mRefresh = reply.mErrc ? entry.mExpires :
+                   now + std::chrono::milliseconds(ttl * 900ull);
+
+  if (reply.mErrc) {
+    return;
+  }
+
+  // A user/group lookup answers the reverse lookup as well
+  std::string rkey;
+
+  switch (static_cast<Type>(ckey[0])) {
+  case Type::kUidToName:
+    rkey = static_cast<char>(Type::kNameToUid) + reply.mName;
+    break;
+
+  case Type::kNameToUid:
+    rkey = static_cast<char>(Type::kUidToName) + std::to_string(reply.mId);
+    break;
+
+  case Type::kGidToName:
+    rkey = static_cast<char>(Type::kNameToGid) + reply.mName;
+    break;
+
+  case Type::kNameToGid:
+    rkey = static_cast<char>(Type::kGidToName) + std::to_string(reply.mId);
+    break;
+  }
+
+  Entry& rentry = mCache[rkey];
+
+  if (!rentry.mPending) {
+    rentry.mReply = reply;
+    rentry.mValid = true;
+    rentry.mExpires = entry.mExpires;
+    rentry.mRefresh = entry.mRefresh;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Purge the expired entries if the cache is full
+//------------------------------------------------------------------------------
+void
+NssResolver::Purge(std::chrono::steady_clock::time_point now)
+{
+  if (mCache.size() < sMaxEntries) {
+    return;
+  }
+
+  for (auto it = mCache.begin(); it != mCache.end();) {
+    if (!it->second.mPending && (now >= it->second.mExpires)) {
+      it = mCache.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (mCache.size() < sMaxEntries) {
+    return;
+  }
+
+  for (auto it = mCache.begin(); it != mCache.end();) {
+    if (!it->second.mPending) {
+      it = mCache.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Default backend calling the name service
+//------------------------------------------------------------------------------
+void
+NssResolver::NssLookup(Type type, const std::string& key, Reply& reply)
+{
+  std::vector<char> buffer(16384);
+  uint32_t id = 0;
+  reply = Reply();
+
+  if (((type == Type::kUidToName) || (type == Type::kGidToName)) &&
+      !ParseId(key, id)) {
+    reply.mErrc = ENOENT;
+    return;
+  }
+
+  while (true) {
+    int rc = 0;
+
+    if ((type == Type::kUidToName) || (type == Type::kNameToUid)) {
+      struct passwd pwbuf;
+      struct passwd* pwbufp = 0;
+
+      if (type == Type::kUidToName) {
+        rc = getpwuid_r(id, &pwbuf, buffer.data(), buffer.size(), &pwbufp);
+      } else {
+        rc = getpwnam_r(key.c_str(), &pwbuf, buffer.data(), buffer.size(),
+                        &pwbufp);
+      }
+
+      if (pwbufp) {
+        reply.mId = pwbufp->pw_uid;
+        reply.mGid = pwbufp->pw_gid;
+        reply.mName = pwbufp->pw_name;
+        return;
+      }
+    } else {
+      struct group grbuf;
+      struct group* grbufp = 0;
+
+      if (type == Type::kGidToName) {
+        rc = getgrgid_r(id, &grbuf, buffer.data(), buffer.size(), &grbufp);
+      } else {
+        rc = getgrnam_r(key.c_str(), &grbuf, buffer.data(), buffer.size(),
+                        &grbufp);
+      }
+
+      if (grbufp) {
+        reply.mId = grbufp->gr_gid;
+        reply.mGid = grbufp->gr_gid;
+        reply.mName = grbufp->gr_name;
+        return;
+      }
+    }
+
+    // Groups with many members need larger buffers
+    if ((rc == ERANGE) && (buffer.size() < 16 * 1024 * 1024)) {
+      buffer.resize(buffer.size() * 2);
+      continue;
+    }
+
+    reply.mErrc = NotFoundErrc(rc);
+    return;
+  }
+}
+
+EOSCOMMONNAMESPACE_END
@@ -0,0 +1,213 @@
+//------------------------------------------------------------------------------
+//! @file NssResolver.hh
+//! @brief Asynchronous user/group name service resolver with TTL caches
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "common/Namespace.hh"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+class ThreadPool;
+
+//------------------------------------------------------------------------------
+//! @brief Resolver for the getpw* / getgr* name service lookups
+//!
+//! The lookups run on a small pool of worker threads, so that a slow name
+//! service (SSSD, LDAP) only delays the callers for a bounded time. Results
+//! are kept in a positive cache and failures in a negative cache, each with
+//! its own lifetime. Concurrent lookups of the same key share one request.
+//! Positive entries used during the last fraction of their lifetime are
+//! refreshed in the background.
+//------------------------------------------------------------------------------
+class NssResolver
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Lookup types
+  //----------------------------------------------------------------------------
+  enum class Type : char {
+    kUidToName = 'u',
+    kGidToName = 'g',
+    kNameToUid = 'U',
+    kNameToGid = 'G'
+  };
+
+  //----------------------------------------------------------------------------
+  //! Lookup result, mId is the uid or gid and mGid the primary group of a user
+  //----------------------------------------------------------------------------
+  struct Reply {
+    int mErrc {0}; ///< 0, ENOENT if unknown, ETIMEDOUT or another errno
+    uint32_t mId {0};
+    gid_t mGid {0};
+    std::string mName;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Statistics
+  //----------------------------------------------------------------------------
+  struct Stats {
+    uint64_t mHits {0}; ///< served from the positive cache
+    uint64_t mNegativeHits {0}; ///< served from the negative cache
+    uint64_t mMisses {0}; ///< requests not answered by the cache
+    uint64_t mTimeouts {0}; ///< callers giving up waiting for a lookup
+    uint64_t mLookups {0}; ///< name service calls
+    uint64_t mFailures {0}; ///< name service calls not finding the key
+    uint64_t mSumLatencyUs {0}; ///< total latency of the name service calls
+    uint64_t mMaxLatencyUs {0}; ///< max latency of a name service call
+    uint64_t mEntries {0}; ///< cached entries
+  };
+
+  //! Callback of an asynchronous lookup, called from a worker or the caller
+  using Callback = std::function<void(const Reply&)>;
+  //! Name service backend performing one lookup
+  using Backend = std::function<void(Type, const std::string&, Reply&)>;
+
+  //----------------------------------------------------------------------------
+  //! Constructor, the worker threads are only started by the first miss
+  //!
+  //! @param threads number of worker threads
+  //! @param ttl lifetime of the positive entries in seconds
+  //! @param negative_ttl lifetime of the negative entries in seconds
+  //! @param timeout_ms max time a synchronous caller waits, 0 waits forever
+  //----------------------------------------------------------------------------
+  NssResolver(unsigned int threads = 4, unsigned int ttl = 3600,
+              unsigned int negative_ttl = 60, unsigned int timeout_ms = 5000);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~NssResolver();
+
+  //----------------------------------------------------------------------------
+  //! Configure the resolver, the number of threads only takes effect before
+  //! the first lookup
+  //----------------------------------------------------------------------------
+  void Configure(unsigned int threads, unsigned int ttl,
+                 unsigned int negative_ttl, unsigned int timeout_ms);
+
+  //----------------------------------------------------------------------------
+  //! Replace the name service backend, used by the tests
+  //----------------------------------------------------------------------------
+  void SetBackend(Backend backend);
+
+  //----------------------------------------------------------------------------
+  //! Synchronous lookup waiting at most for the configured timeout
+  //!
+  //! @param type lookup type
+  //! @param key uid/gid in decimal or the user/group name
+  //! @param reply lookup result
+  //!
+  //! @return reply.mErrc
+  //----------------------------------------------------------------------------
+  int Lookup(Type type, const std::string& key, Reply& reply);
+
+  //----------------------------------------------------------------------------
+  //! Asynchronous lookup, the callback runs immediately for a cached key
+  //----------------------------------------------------------------------------
+  void LookupAsync(Type type, const std::string& key, Callback cb);
+
+  //----------------------------------------------------------------------------
+  //! Queue lookups for the keys which are not cached or about to expire
+  //----------------------------------------------------------------------------
+  void Prefetch(Type type, const std::vector<std::string>& keys);
+
+  //----------------------------------------------------------------------------
+  //! Drop all cached entries, pending lookups are kept
+  //----------------------------------------------------------------------------
+  void Clear();
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics
+  //----------------------------------------------------------------------------
+  Stats GetStats();
+
+  //----------------------------------------------------------------------------
+  //! Default backend calling getpwuid_r, getgrgid_r, getpwnam_r, getgrnam_r
+  //----------------------------------------------------------------------------
+  static void NssLookup(Type type, const std::string& key, Reply& reply);
+
+  // Max number of cached entries before the expired ones are purged
+  static constexpr size_t sMaxEntries = 100000;
+
+private:
+  struct Entry {
+    Reply mReply;
+    bool mValid {false}; ///< mReply holds a result
+    bool mPending {false}; ///< lookup queued or running
+    std::chrono::steady_clock::time_point mExpires;
+    std::chrono::steady_clock::time_point mRefresh; ///< refresh ahead after
+    std::shared_ptr<std::promise<Reply>> mPromise;
+    std::shared_future<Reply> mFuture;
+    std::vector<Callback> mCallbacks;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Schedule a lookup of the key unless one is pending, needs mMutex
+  //----------------------------------------------------------------------------
+  void Schedule(const std::string& ckey, Entry& entry);
+
+  //----------------------------------------------------------------------------
+  //! Run the lookup of a cache key on a worker
+  //----------------------------------------------------------------------------
+  void Resolve(const std::string& ckey);
+
+  //----------------------------------------------------------------------------
+  //! Store a result in the cache, needs mMutex
+  //----------------------------------------------------------------------------
+  void Store(const std::string& ckey, const Reply& reply, bool transient,
+             std::chrono::steady_clock::time_point now);
+
+  //----------------------------------------------------------------------------
+  //! Purge the expired entries if the cache is full, needs mMutex
+  //----------------------------------------------------------------------------
+  void Purge(std::chrono::steady_clock::time_point now);
+
+  std::mutex mMutex; ///< Protects the members below
+  std::unordered_map<std::string, Entry> mCache; ///< keyed by type + key
+  std::unique_ptr<ThreadPool> mPool;
+  Backend mBackend;
+  unsigned int mThreads;
+  std::atomic<unsigned int> mTtl;
+  std::atomic<unsigned int> mNegativeTtl;
+  std::atomic<unsigned int> mTimeoutMs;
+
+  std::atomic<uint64_t> mHits {0};
+  std::atomic<uint64_t> mNegativeHits {0};
+  std::atomic<uint64_t> mMisses {0};
+  std::atomic<uint64_t> mTimeouts {0};
+  std::atomic<uint64_t> mLookups {0};
+  std::atomic<uint64_t> mFailures {0};
+  std::atomic<uint64_t> mSumLatencyUs {0};
+  std::atomic<uint64_t> mMaxLatencyUs {0};
+};
+
+EOSCOMMONNAMESPACE_END
@@ -24,15 +24,22 @@
 /**
  * @file   Parallel.hh
  *
- * @brief  Class providing a parallel for function using lambda functions/threads
+ * @brief  Class providing parallel loops using lambda functions on a shared
+ *         thread pool
  *
  *
  */
 
-#include <thread>
+#include "common/ThreadPool.hh"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <iterator>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <type_traits>
 #include <vector>
-#include <cmath>
 #include <features.h>
 #ifndef __EOSCOMMON__PARALLEL__HH
 #define __EOSCOMMON__PARALLEL__HH
@@ -41,59 +48,342 @@ EOSCOMMONNAMESPACE_BEGIN
 
 #if __GNUC_PREREQ(4,8) || defined(__clang__)
 
+//------------------------------------------------------------------------------
+//! Parallel loops on a work-stealing pool shared by the whole process
+//!
+//! The calling thread takes part in the loop together with up to
+//! hardware_concurrency() - 1 pool threads. The range is handed out in
+//! chunks of remaining / (2 * threads) iterations, at least one, so the
+//! first chunks are large and the last ones small and a thread which got
+//! expensive iterations is caught up by the others. The caller never waits
+//! for a queued helper to start, loops nested in a loop body or started from
+//! any pool task then always make progress.
+//------------------------------------------------------------------------------
 class Parallel
 {
 
 public:
 
+  //----------------------------------------------------------------------------
+  //! Call func(i) for every i in [start, end)
+  //!
+  //! An exception thrown by func stops handing out iterations and is rethrown
+  //! once the iterations already started are done.
+  //----------------------------------------------------------------------------
   template<typename Index, typename Callable>
   static void For(Index start, Index end, Callable func)
   {
-    // Estimate number of threads in the pool
+    char none = 0;
+    auto body = [&func](const typename IndexSource<Index>::Range & range,
+    char&) {
+      for (Index i = range.mFirst; i < range.mLast; ++i) {
+        func(i);
+      }
+    };
+    auto combine = [](char&, char&) { };
+    Execute<IndexSource<Index>>(none, body, combine, Helpers(end - start),
+                                start, end, Threads());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Call func(i, local) for every i in [start, end) with a reduction object
+  //! per thread, copied from init by every thread taking part
+  //!
+  //! @param combine called as combine(result, local) once per thread, one
+  //!        at a time, with result starting as a copy of init
+  //!
+  //! @return result after all the threads combined their local object
+  //----------------------------------------------------------------------------
+  template<typename Index, typename T, typename Callable, typename Combine>
+  static T For(Index start, Index end, const T& init, Callable func,
+               Combine combine)
+  {
+    auto body = [&func](const typename IndexSource<Index>::Range & range,
+    T & local) {
+      for (Index i = range.mFirst; i < range.mLast; ++i) {
+        func(i, local);
+      }
+    };
+    return Execute<IndexSource<Index>>(init, body, combine,
+                                       Helpers(end - start), start, end,
+                                       Threads());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Call func(*it) for every it in [first, last), e.g. over the entries of
+  //! a namespace or filesystem map. Random access iterators are handed out
+  //! like indexes, the others are advanced under a lock by the thread taking
+  //! a chunk.
+  //----------------------------------------------------------------------------
+  template<typename Iterator, typename Callable>
+  static void ForEach(Iterator first, Iterator last, Callable func)
+  {
+    ForEachImpl(first, last, func, typename
+                std::iterator_traits<Iterator>::iterator_category());
+  }
+
+  // Serial version for easy comparison
+  template<typename Index, typename Callable>
+  static void SequentialFor(Index start, Index end, Callable func)
+  {
+    for (Index i = start; i < end; i++) {
+      func(i);
+    }
+  }
+
+private:
+
+  //----------------------------------------------------------------------------
+  //! Number of threads taking part in a loop, the caller included
+  //----------------------------------------------------------------------------
+  static unsigned Threads()
+  {
     const static unsigned nb_threads_hint = std::thread::hardware_concurrency();
     const static unsigned nb_threads = (nb_threads_hint == 0u ? 8u :
                                         nb_threads_hint);
-    // Size of a slice for the range functions
-    Index n = end - start + 1;
-    Index slice = (Index) std::round(n / static_cast<double>(nb_threads));
-    slice = std::max(slice, Index(1));
-    // [Helper] Inner loop
-    auto launchRange = [&func](int k1, int k2) {
-      for (Index k = k1; k < k2; k++) {
-        func(k);
+    return nb_threads;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Number of pool threads to ask for a loop of the given length
+  //----------------------------------------------------------------------------
+  template<typename Size>
+  static unsigned Helpers(Size length)
+  {
+    if (length <= Size(1)) {
+      return 0;
+    }
+
+    return ((uint64_t) length - 1 < Threads() - 1) ?
+           (unsigned)(length - 1) : Threads() - 1;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Pool shared by all the loops of the process
+  //----------------------------------------------------------------------------
+  static ThreadPool& GetPool()
+  {
+    static ThreadPool pool(Threads() > 1 ? Threads() - 1 : 1,
+                           Threads() > 1 ? Threads() - 1 : 1,
+                           10, 12, 10, "parallel_for");
+    return pool;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Chunks of an index range, taken without a lock
+  //----------------------------------------------------------------------------
+  template<typename Index>
+  class IndexSource
+  {
+  public:
+    struct Range {
+      Index mFirst;
+      Index mLast;
+    };
+
+    IndexSource(Index start, Index end, unsigned threads):
+      mNext(start), mEnd(end), mDivisor(2 * threads) {}
+
+    bool Claim(Range& range)
+    {
+      Index next = mNext.load();
+
+      while (next < mEnd) {
+        Index chunk = (mEnd - next) / mDivisor;
+        chunk = (chunk < Index(1) ? Index(1) : chunk);
+        Index stop = (mEnd - next > chunk ? next + chunk : mEnd);
+
+        if (mNext.compare_exchange_weak(next, stop)) {
+          range.mFirst = next;
+          range.mLast = stop;
+          return true;
+        }
       }
+
+      return false;
+    }
+
+    void Cancel()
+    {
+      mNext = mEnd;
+    }
+
+  private:
+    std::atomic<Index> mNext;
+    const Index mEnd;
+    const Index mDivisor;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Chunks of an iterator range, the shared iterator is advanced under a lock
+  //----------------------------------------------------------------------------
+  template<typename Iterator>
+  class IteratorSource
+  {
+  public:
+    struct Range {
+      Iterator mFirst;
+      size_t mCount;
     };
-    // Create pool and launch jobs
-    std::vector<std::thread> pool;
-    pool.reserve(nb_threads);
-    Index i1 = start;
-    Index i2 = std::min(start + slice, end);
-
-    for (unsigned i = 0; i + 1 < nb_threads && i1 < end; ++i) {
-      pool.emplace_back(launchRange, i1, i2);
-      i1 = i2;
-      i2 = std::min(i2 + slice, end);
+
+    IteratorSource(Iterator first, size_t count, unsigned threads):
+      mNext(first), mRemaining(count), mDivisor(2 * threads) {}
+
+    bool Claim(Range& range)
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+
+      if (mRemaining == 0) {
+        return false;
+      }
+
+      size_t chunk = std::max(mRemaining / mDivisor, (size_t) 1);
+      range.mFirst = mNext;
+      range.mCount = chunk;
+      std::advance(mNext, chunk);
+      mRemaining -= chunk;
+      return true;
     }
 
-    if (i1 < end) {
-      pool.emplace_back(launchRange, i1, end);
+    void Cancel()
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mRemaining = 0;
     }
 
-    // Wait for jobs to finish
-    for (std::thread& t : pool) {
-      if (t.joinable()) {
-        t.join();
+  private:
+    std::mutex mMutex;
+    Iterator mNext;
+    size_t mRemaining;
+    const size_t mDivisor;
+  };
+
+  //----------------------------------------------------------------------------
+  //! State of a loop shared by its threads, it outlives the loop if queued
+  //! helpers only start after the loop is done
+  //----------------------------------------------------------------------------
+  template<typename Source>
+  struct Shared {
+    template<typename... Args>
+    explicit Shared(Args&& ... args): mSource(std::forward<Args>(args)...) {}
+
+    Source mSource;
+    std::atomic<unsigned> mActive {0}; ///< Helpers inside the loop
+    std::mutex mMutex; ///< Protects the result, mError and mCv
+    std::condition_variable mCv; ///< Signaled when the last helper leaves
+    std::exception_ptr mError; ///< First exception thrown by the body
+  };
+
+  //----------------------------------------------------------------------------
+  //! Take and run chunks until the source is exhausted, the local object is
+  //! only created, and combined, if at least one chunk was taken so that a
+  //! helper starting late does not touch the objects of the caller
+  //----------------------------------------------------------------------------
+  template<typename Source, typename T, typename Body, typename Combine>
+  static void Participate(Shared<Source>& shared, const T& init, Body& body,
+                          Combine& combine, T& result)
+  {
+    std::unique_ptr<T> local;
+    typename Source::Range range;
+
+    try {
+      while (shared.mSource.Claim(range)) {
+        if (!local) {
+          local.reset(new T(init));
+        }
+
+        body(range, *local);
+      }
+
+      if (local) {
+        std::lock_guard<std::mutex> lock(shared.mMutex);
+        combine(result, *local);
+      }
+    } catch (...) {
+      shared.mSource.Cancel();
+      std::lock_guard<std::mutex> lock(shared.mMutex);
+
+      if (!shared.mError) {
+        shared.mError = std::current_exception();
       }
     }
   }
 
-  // Serial version for easy comparison
-  template<typename Index, typename Callable>
-  static void SequentialFor(Index start, Index end, Callable func)
+  //----------------------------------------------------------------------------
+  //! Run a loop on the calling thread and the given number of pool threads
+  //----------------------------------------------------------------------------
+  template<typename Source, typename T, typename Body, typename Combine,
+           typename... Args>
+  static T Execute(const T& init, Body& body, Combine& combine,
+                   unsigned helpers, Args&& ... args)
   {
-    for (Index i = start; i < end; i++) {
-      func(i);
+    auto shared = std::make_shared<Shared<Source>>(std::forward<Args>(args)...);
+    T result(init);
+
+    if (helpers) {
+      ThreadPool& pool = GetPool();
+
+      for (unsigned i = 0; i < helpers; ++i) {
+        pool.PushTask<void>([shared, &init, &body, &combine, &result]() {
+          ++shared->mActive;
+          Participate(*shared, init, body, combine, result);
+
+          if (--shared->mActive == 0) {
+            std::lock_guard<std::mutex> lock(shared->mMutex);
+            shared->mCv.notify_all();
+          }
+        });
+      }
     }
+
+    Participate(*shared, init, body, combine, result);
+    // The source is exhausted, a helper which took a chunk entered before
+    {
+      std::unique_lock<std::mutex> lock(shared->mMutex);
+      shared->mCv.wait(lock, [&shared]() {
+        return (shared->mActive.load() == 0);
+      });
+
+      if (shared->mError) {
+        std::rethrow_exception(shared->mError);
+      }
+    }
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+  //! ForEach over random access iterators
+  //----------------------------------------------------------------------------
+  template<typename Iterator, typename Callable>
+  static void ForEachImpl(Iterator first, Iterator last, Callable& func,
+                          std::random_access_iterator_tag)
+  {
+    typedef typename std::iterator_traits<Iterator>::difference_type Diff;
+    For(Diff(0), Diff(last - first), [&func, &first](Diff i) {
+      func(*(first + i));
+    });
+  }
+
+  //----------------------------------------------------------------------------
+  //! ForEach over forward iterators
+  //----------------------------------------------------------------------------
+  template<typename Iterator, typename Callable>
+  static void ForEachImpl(Iterator first, Iterator last, Callable& func,
+                          std::forward_iterator_tag)
+  {
+    typedef IteratorSource<Iterator> Source;
+    size_t count = std::distance(first, last);
+    char none = 0;
+    auto body = [&func](const typename Source::Range & range, char&) {
+      Iterator it = range.mFirst;
+
+      for (size_t n = 0; n < range.mCount; ++n, ++it) {
+        func(*it);
+      }
+    };
+    auto combine = [](char&, char&) { };
+    Execute<Source>(none, body, combine, Helpers(count), first, count,
+                    Threads());
   }
 };
 
@@ -26,6 +26,8 @@
 #include "common/RWMutex.hh"
 #include "common/PthreadRWMutex.hh"
 #include "common/SharedMutex.hh"
+#include "common/BigReaderRWMutex.hh"
+#include "common/MutexContentionProfiler.hh"
 #include <sstream>
 #include <exception>
 
@@ -117,7 +119,7 @@ pthread_rwlock_t RWMutex::mOrderChkLock;
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-RWMutex::RWMutex(bool prefer_rd):
+RWMutex::RWMutex(bool prefer_rd, bool big_reader):
   mBlocking(false), mMutexImpl(nullptr), mRdLockCounter(0), mWrLockCounter(0),
   mPreferRd(prefer_rd)
 {
@@ -142,7 +144,9 @@ RWMutex::RWMutex(bool prefer_rd):
   ResetTimingStatistics();
 #endif
 
-  if (getenv("EOS_USE_PTHREAD_MUTEX")) {
+  if (big_reader && !getenv("EOS_DISABLE_BIGREADER_MUTEX")) {
+    mMutexImpl = new BigReaderRWMutex(prefer_rd);
+  } else if (getenv("EOS_USE_PTHREAD_MUTEX")) {
     mMutexImpl = new PthreadRWMutex(prefer_rd);
   } else {
     mMutexImpl = new SharedMutex();
@@ -253,9 +257,26 @@ RWMutex::TimedRdLock(uint64_t timeout_ns)
 //------------------------------------------------------------------------------
 void
 RWMutex::LockRead()
+{
+  LockReadFrom((uintptr_t) __builtin_return_address(0));
+}
+
+//------------------------------------------------------------------------------
+// Lock for read on behalf of a call site
+//------------------------------------------------------------------------------
+void
+RWMutex::LockReadFrom(uintptr_t caller)
 {
   EOS_RWMUTEX_CHECKORDER_LOCK;
   EOS_RWMUTEX_TIMER_START;
+  uint64_t contention_start = 0;
+  uintptr_t holder = 0;
+
+  if (MutexContentionProfiler::Sample()) {
+    holder = mLastHolderSite.load(std::memory_order_relaxed);
+    contention_start = Timing::GetNowInNs();
+  }
+
 #ifdef EOS_INSTRUMENTED_RWMUTEX
 
   if (sEnableGlobalDeadlockCheck) {
@@ -275,6 +296,10 @@ RWMutex::LockRead()
     std::terminate();
   }
 
+  if (contention_start) {
+    ProfileContention(false, caller, holder, contention_start);
+  }
+
   EOS_RWMUTEX_TIMER_STOP_AND_UPDATE(mRd);
 }
 
@@ -318,9 +343,26 @@ RWMutex::UnLockRead()
 //------------------------------------------------------------------------------
 void
 RWMutex::LockWrite()
+{
+  LockWriteFrom((uintptr_t) __builtin_return_address(0));
+}
+
+//------------------------------------------------------------------------------
+// Lock for write on behalf of a call site
+//------------------------------------------------------------------------------
+void
+RWMutex::LockWriteFrom(uintptr_t caller)
 {
   EOS_RWMUTEX_CHECKORDER_LOCK;
   EOS_RWMUTEX_TIMER_START;
+  uint64_t contention_start = 0;
+  uintptr_t holder = 0;
+
+  if (MutexContentionProfiler::Sample()) {
+    holder = mLastHolderSite.load(std::memory_order_relaxed);
+    contention_start = Timing::GetNowInNs();
+  }
+
 #ifdef EOS_INSTRUMENTED_RWMUTEX
 
   if (sEnableGlobalDeadlockCheck) {
@@ -383,9 +425,34 @@ RWMutex::LockWrite()
   // mLastWriteLock should be updated _after_ we acquire the lock!
   mLastWriteLock = std::chrono::duration_cast<std::chrono::milliseconds>
                    (std::chrono::steady_clock::now().time_since_epoch()).count();
+
+  if (contention_start) {
+    ProfileContention(true, caller, holder, contention_start);
+  } else if (MutexContentionProfiler::IsEnabled()) {
+    // Writers are the usual holders, so keep their site even if not sampled
+    mLastHolderSite.store(caller, std::memory_order_relaxed);
+  }
+
   EOS_RWMUTEX_TIMER_STOP_AND_UPDATE(mWr);
 }
 
+//------------------------------------------------------------------------------
+// Feed a lock acquisition to the contention profiler
+//------------------------------------------------------------------------------
+void
+RWMutex::ProfileContention(bool write, uintptr_t caller, uintptr_t holder,
+                           uint64_t start_ns)
+{
+  uint64_t wait_ns = Timing::GetNowInNs() - start_ns;
+#ifdef EOS_INSTRUMENTED_RWMUTEX
+  const char* name = mDebugName.c_str();
+#else
+  const char* name = nullptr;
+#endif
+  MutexContentionProfiler::Record(this, name, write, caller, holder, wait_ns);
+  mLastHolderSite.store(caller, std::memory_order_relaxed);
+}
+
 //------------------------------------------------------------------------------
 // Unlock a write lock
 //------------------------------------------------------------------------------
@@ -1280,7 +1347,7 @@ RWMutex::ResetCheckOrder()
 RWMutexWriteLock::RWMutexWriteLock(RWMutex& mutex):
   mWrMutex(&mutex)
 {
-  mWrMutex->LockWrite();
+  mWrMutex->LockWriteFrom((uintptr_t) __builtin_return_address(0));
 }
 
 //----------------------------------------------------------------------------
@@ -1294,7 +1361,7 @@ RWMutexWriteLock::Grab(RWMutex& mutex)
   }
 
   mWrMutex = &mutex;
-  mWrMutex->LockWrite();
+  mWrMutex->LockWriteFrom((uintptr_t) __builtin_return_address(0));
 }
 
 
@@ -1327,7 +1394,7 @@ RWMutexWriteLock::~RWMutexWriteLock()
 //------------------------------------------------------------------------------
 RWMutexReadLock::RWMutexReadLock(RWMutex& mutex)
 {
-  Grab(mutex);
+  GrabFrom(mutex, (uintptr_t) __builtin_return_address(0));
 }
 
 //----------------------------------------------------------------------------
@@ -1335,13 +1402,22 @@ RWMutexReadLock::RWMutexReadLock(RWMutex& mutex)
 //----------------------------------------------------------------------------
 void
 RWMutexReadLock::Grab(RWMutex& mutex)
+{
+  GrabFrom(mutex, (uintptr_t) __builtin_return_address(0));
+}
+
+//----------------------------------------------------------------------------
+// Grab mutex and read lock it on behalf of a call site
+//----------------------------------------------------------------------------
+void
+RWMutexReadLock::GrabFrom(RWMutex& mutex, uintptr_t caller)
 {
   if (mRdMutex) {
     throw std::runtime_error("already holding a mutex");
   }
 
   mRdMutex = &mutex;
-  mRdMutex->LockRead();
+  mRdMutex->LockReadFrom(caller);
 
   // acquiredAt must be updated _after_ we get the lock, since LockRead
   // may take a long time to complete
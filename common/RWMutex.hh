@@ -87,8 +87,13 @@ class RWMutex
 public:
   //----------------------------------------------------------------------------
   //! Constructor
+  //!
+  //! @param prefer_rd if true reads go ahead of writes and are reentrant
+  //! @param big_reader if true use the BigReaderRWMutex implementation which
+  //!        scales better for read-mostly mutexes at the expense of writers.
+  //!        Can be disabled globally with EOS_DISABLE_BIGREADER_MUTEX.
   // ---------------------------------------------------------------------------
-  RWMutex(bool prefer_rd = false);
+  RWMutex(bool prefer_rd = false, bool big_reader = false);
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -167,6 +172,14 @@ public:
   //----------------------------------------------------------------------------
   void LockRead();
 
+  //----------------------------------------------------------------------------
+  //! Lock for read on behalf of a call site
+  //!
+  //! @param caller return address accounted to this lock by the contention
+  //!        profiler, see MutexContentionProfiler
+  //----------------------------------------------------------------------------
+  void LockReadFrom(uintptr_t caller);
+
   //----------------------------------------------------------------------------
   //! Unlock a read lock
   //----------------------------------------------------------------------------
@@ -186,6 +199,14 @@ public:
   //----------------------------------------------------------------------------
   void LockWrite();
 
+  //----------------------------------------------------------------------------
+  //! Lock for write on behalf of a call site
+  //!
+  //! @param caller return address accounted to this lock by the contention
+  //!        profiler, see MutexContentionProfiler
+  //----------------------------------------------------------------------------
+  void LockWriteFrom(uintptr_t caller);
+
   //----------------------------------------------------------------------------
   //! Unlock a write lock
   //----------------------------------------------------------------------------
@@ -496,7 +517,21 @@ public:
 #endif
 
 private:
+  //----------------------------------------------------------------------------
+  //! Feed a lock acquisition to the contention profiler
+  //!
+  //! @param write true for a write lock
+  //! @param caller call site of the lock
+  //! @param holder call site of the likely holder sampled before waiting
+  //! @param start_ns timestamp taken before waiting, 0 if not sampled
+  //----------------------------------------------------------------------------
+  void ProfileContention(bool write, uintptr_t caller, uintptr_t holder,
+                         uint64_t start_ns);
+
   std::atomic<uint64_t> mLastWriteLock;
+  //! Call site of the last write lock or sampled read lock, only maintained
+  //! while the contention profiler is enabled
+  std::atomic<uintptr_t> mLastHolderSite {0};
 
   bool mBlocking;
   IRWMutex* mMutexImpl;
@@ -651,6 +686,11 @@ public:
   ~RWMutexReadLock();
 
 private:
+  //----------------------------------------------------------------------------
+  //! Grab mutex and read lock it on behalf of a call site
+  //----------------------------------------------------------------------------
+  void GrabFrom(RWMutex& mutex, uintptr_t caller);
+
   std::chrono::steady_clock::time_point mAcquiredAt;
   RWMutex* mRdMutex = nullptr;
 };
@@ -34,6 +34,7 @@
 #include <vector>
 #include <mutex>
 #include <map>
+#include <atomic>
 
 using Milliseconds = int64_t;
 
@@ -47,6 +48,8 @@ using Milliseconds = int64_t;
 //    form of a shared pointer. No need to worry about locks or races after
 //    acquiring such a snapshot.
 // 3. Hashing: You can specify a custom hasing function to map from Key -> shard id.
+//    The hash is scrambled before picking the shard, so small or sequential
+//    hashes like pids still spread over all shards.
 // 4. Garbage collection: Thanks to shared pointers, we can keep track of how many
 //    references currently exist for each element in the cache by calling use_count.
 //
@@ -56,6 +59,14 @@ using Milliseconds = int64_t;
 //    - If this element is retrieved after that, we unset the mark.
 //    - If during the next pass the mark is still there, it means it hasn't been
 //      used for at least N seconds, so we evict it.
+//
+//    The TTL counts from the last use, so entries which are hot never expire
+//    and don't need to be refreshed ahead.
+// 5. Size budget: Optionally, a shard holds at most maxPerShard elements. When
+//    a store goes over the budget, one element is evicted following the CLOCK
+//    approximation of LRU: every hit sets a reference bit, the hand of the
+//    shard goes round clearing the bits and evicts the first element found
+//    without one.
 
 template<typename Key>
 struct IdentityHash {
@@ -65,6 +76,15 @@ struct IdentityHash {
   }
 };
 
+// Counters of a cache
+struct ShardedCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evicted = 0; // over the size budget
+  uint64_t expired = 0; // unused for the TTL
+  uint64_t size = 0;
+};
+
 template<typename Key, typename Value, typename Hash>
 class ShardedCache
 {
@@ -93,13 +113,25 @@ private:
   };
 
   int64_t calculateShard(const Key &key) {
-    return Hash::hash(key) >> shardBits;
+    if (shardBits == 0) {
+      return 0;
+    }
+
+    // Fibonacci hashing, the top bits of the product depend on all the bits
+    // of the hash
+    return (Hash::hash(key) * 0x9E3779B97F4A7C15ull) >> (64 - shardBits);
   }
 
 public:
   // TTL is approximate. An element can stay while unused from [ttl, 2*ttl]
-  ShardedCache(size_t shardBits_, Milliseconds ttl_)
-  : shardBits(shardBits_), shards(pow(2, shardBits)), ttl(ttl_), mutexes(shards), contents(shards) {
+  // maxPerShard_ of 0 means no size budget
+  ShardedCache(size_t shardBits_, Milliseconds ttl_, size_t maxPerShard_ = 0)
+  : shardBits(shardBits_), shards(size_t(1) << shardBits), ttl(ttl_),
+    maxPerShard(maxPerShard_), mutexes(shards), contents(shards), hands(shards) {
+    for (size_t i = 0; i < shards; i++) {
+      hands[i] = contents[i].end();
+    }
+
     cleanupThread.reset(&ShardedCache<Key, Value, Hash>::garbageCollector, this);
   }
 
@@ -111,11 +143,13 @@ public:
     typename std::map<Key, CacheEntry>::iterator it = contents[guard.getShard()].find(key);
 
     if (it == contents[guard.getShard()].end()) {
+      misses++;
       return std::shared_ptr<Value>();
     }
 
-    // if(it->first == 4) std::cerr << "erasing " << it->first << std::endl;
+    hits++;
     it->second.marked = false;
+    it->second.referenced = true;
     return it->second.value;
   }
 
@@ -127,20 +161,25 @@ public:
   {
     CacheEntry entry;
     entry.marked = false;
+    entry.referenced = true;
     entry.value = std::move(value);
     ShardGuard guard(this, key);
+    std::map<Key, CacheEntry>& shard = contents[guard.getShard()];
+    std::pair<typename std::map<Key, CacheEntry>::iterator, bool> status;
+    status = shard.insert(std::pair<Key, CacheEntry>(key, entry));
 
-    if (replace) {
-      contents[guard.getShard()][key] = entry;
-      retval = entry.value;
-      return true;
+    if (status.second) {
+      entries++;
+
+      if (maxPerShard && (shard.size() > maxPerShard)) {
+        evictOne(guard.getShard(), status.first);
+      }
+    } else if (replace) {
+      status.first->second = entry;
     }
 
-    std::pair<typename std::map<Key, CacheEntry>::iterator, bool> status;
-    status = contents[guard.getShard()].insert(std::pair<Key, CacheEntry>(key,
-             entry));
     retval = status.first->second.value;
-    return status.second;
+    return (status.second || replace);
   }
 
   // store overload without retval
@@ -165,25 +204,86 @@ public:
   bool invalidate(const Key& key) {
     ShardGuard guard(this, key);
     typename std::map<Key, CacheEntry>::iterator it = contents[guard.getShard()].find(key);
-    contents[guard.getShard()].erase(it);
+
+    if (it == contents[guard.getShard()].end()) {
+      return false;
+    }
+
+    erase(guard.getShard(), it);
     return true;
   }
 
+  ShardedCacheStats getStats() const {
+    ShardedCacheStats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.evicted = evicted;
+    stats.expired = expired;
+    stats.size = entries;
+    return stats;
+  }
+
 private:
   size_t shardBits;
   size_t shards;
   Milliseconds ttl;
+  size_t maxPerShard;
 
   struct CacheEntry {
     std::shared_ptr<Value> value;
     bool marked;
+    bool referenced;
   };
 
   std::vector<std::mutex> mutexes;
   std::vector<std::map<Key, CacheEntry>> contents;
+  // CLOCK hand of each shard, end() when it has to start over
+  std::vector<typename std::map<Key, CacheEntry>::iterator> hands;
+
+  std::atomic<uint64_t> hits {0};
+  std::atomic<uint64_t> misses {0};
+  std::atomic<uint64_t> evicted {0};
+  std::atomic<uint64_t> expired {0};
+  std::atomic<uint64_t> entries {0};
 
   AssistedThread cleanupThread;
 
+  // Erase an element keeping the hand of its shard valid - shard mutex must
+  // be locked
+  typename std::map<Key, CacheEntry>::iterator
+  erase(size_t shard, typename std::map<Key, CacheEntry>::iterator it) {
+    if (hands[shard] == it) {
+      hands[shard] = std::next(it);
+    }
+
+    entries--;
+    return contents[shard].erase(it);
+  }
+
+  // Evict one element of a shard over its budget other than the one just
+  // stored - shard mutex must be locked
+  void evictOne(size_t shard, typename std::map<Key, CacheEntry>::iterator
+    stored) {
+    // Two turns at most, the first one clears all the reference bits
+    for (size_t n = 0; n < 2 * contents[shard].size(); n++) {
+      if (hands[shard] == contents[shard].end()) {
+        hands[shard] = contents[shard].begin();
+      }
+
+      typename std::map<Key, CacheEntry>::iterator it = hands[shard];
+
+      if ((it == stored) || it->second.referenced) {
+        it->second.referenced = false;
+        hands[shard]++;
+        continue;
+      }
+
+      erase(shard, it);
+      evicted++;
+      return;
+    }
+  }
+
   // Sweep through all entries in all shards to either mark them as unused or
   // remove them
   void collectorPass() {
@@ -195,7 +295,8 @@ private:
       for (iterator = contents[i].begin();
            iterator != contents[i].end(); /* no increment */) {
         if (iterator->second.marked) {
-          iterator = contents[i].erase(iterator);
+          iterator = erase(i, iterator);
+          expired++;
           continue;
         }
 
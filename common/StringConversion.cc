@@ -25,14 +25,245 @@
 #include "common/Logging.hh"
 #include "common/Timing.hh"
 #include <XrdOuc/XrdOucTokenizer.hh>
-#include "curl/curl.h"
 #include <regex>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 EOSCOMMONNAMESPACE_BEGIN
 
 char StringConversion::pAscii2HexLkup[256];
 char StringConversion::pHex2AsciiLkup[16];
 
+namespace
+{
+const char* const sHexLower = "0123456789abcdef";
+const char* const sHexUpper = "0123456789ABCDEF";
+
+//------------------------------------------------------------------------------
+// Bitmap of a set of characters
+//------------------------------------------------------------------------------
+struct CharSet {
+  CharSet(const char* chars, size_t n)
+  {
+    for (size_t i = 0; i < n; ++i) {
+      unsigned char c = chars[i];
+      mBits[c >> 6] |= (1ull << (c & 63));
+    }
+  }
+
+  bool Has(unsigned char c) const
+  {
+    return (mBits[c >> 6] >> (c & 63)) & 1;
+  }
+
+  uint64_t mBits[4] = {0, 0, 0, 0};
+};
+
+//------------------------------------------------------------------------------
+// Value of a hex digit or -1
+//------------------------------------------------------------------------------
+inline int
+HexValue(char c)
+{
+  if ((c >= '0') && (c <= '9')) {
+    return c - '0';
+  }
+
+  if ((c >= 'a') && (c <= 'f')) {
+    return c - 'a' + 10;
+  }
+
+  if ((c >= 'A') && (c <= 'F')) {
+    return c - 'A' + 10;
+  }
+
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+// Check if a character is kept as is by curl_easy_escape, or is '/'
+//------------------------------------------------------------------------------
+inline bool
+IsUrlSafe(char c)
+{
+  return (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) ||
+          ((c >= '0') && (c <= '9')) || ((c >= '-') && (c <= '/')) ||
+          (c == '_') || (c == '~'));
+}
+
+#if defined(__SSE2__)
+//------------------------------------------------------------------------------
+// Mask of the bytes in [lo, hi], only valid for ASCII bounds
+//------------------------------------------------------------------------------
+inline __m128i
+InRange(__m128i v, char lo, char hi)
+{
+  return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+                       _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), v));
+}
+
+//------------------------------------------------------------------------------
+// Convert hex digits to their values, invalid digits give 0 and are not
+// flagged in valid
+//------------------------------------------------------------------------------
+inline __m128i
+HexNibbles(__m128i v, bool upper, __m128i& valid)
+{
+  __m128i digit = InRange(v, '0', '9');
+  __m128i lower = InRange(v, 'a', 'f');
+  __m128i nib = _mm_or_si128(
+                  _mm_and_si128(digit, _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+                  _mm_and_si128(lower, _mm_sub_epi8(v, _mm_set1_epi8('a' - 10))));
+  valid = _mm_or_si128(digit, lower);
+
+  if (upper) {
+    __m128i alpha = InRange(v, 'A', 'F');
+    nib = _mm_or_si128(nib, _mm_and_si128(alpha,
+                                          _mm_sub_epi8(v, _mm_set1_epi8('A' - 10))));
+    valid = _mm_or_si128(valid, alpha);
+  }
+
+  return nib;
+}
+
+//------------------------------------------------------------------------------
+// Combine 16 nibbles, most significant first, into the low 8 bytes
+//------------------------------------------------------------------------------
+inline __m128i
+PackNibbles(__m128i nib)
+{
+  // Every 16 bit lane holds first | second << 8
+  __m128i hi = _mm_slli_epi16(_mm_and_si128(nib, _mm_set1_epi16(0x00ff)), 4);
+  __m128i lo = _mm_srli_epi16(nib, 8);
+  return _mm_packus_epi16(_mm_or_si128(hi, lo), _mm_setzero_si128());
+}
+
+//------------------------------------------------------------------------------
+// Bitmask of the bytes escaped by curl_escaped
+//------------------------------------------------------------------------------
+inline int
+UrlUnsafeMask(__m128i v)
+{
+  __m128i safe = _mm_or_si128(
+                   _mm_or_si128(InRange(v, 'a', 'z'), InRange(v, 'A', 'Z')),
+                   _mm_or_si128(InRange(v, '0', '9'), InRange(v, '-', '/')));
+  safe = _mm_or_si128(safe, _mm_or_si128(
+                        _mm_cmpeq_epi8(v, _mm_set1_epi8('_')),
+                        _mm_cmpeq_epi8(v, _mm_set1_epi8('~'))));
+  return ~_mm_movemask_epi8(safe) & 0xffff;
+}
+#endif
+
+//------------------------------------------------------------------------------
+// Find the first character at or after pos which is (match) or is not one of
+// the delimiters
+//------------------------------------------------------------------------------
+size_t
+FindDelimiter(const char* str, size_t len, size_t pos, const char* delimiters,
+              size_t ndelim, bool match)
+{
+  if (pos >= len) {
+    return std::string::npos;
+  }
+
+  if (!ndelim) {
+    return match ? std::string::npos : pos;
+  }
+
+  if (match && (ndelim == 1)) {
+    const char* ptr = (const char*) memchr(str + pos, delimiters[0], len - pos);
+    return ptr ? ptr - str : std::string::npos;
+  }
+
+#if defined(__SSE2__)
+
+  if (ndelim <= 4) {
+    __m128i needles[4];
+
+    for (size_t i = 0; i < ndelim; ++i) {
+      needles[i] = _mm_set1_epi8(delimiters[i]);
+    }
+
+    for (; pos + 16 <= len; pos += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(str + pos));
+      __m128i eq = _mm_cmpeq_epi8(v, needles[0]);
+
+      for (size_t i = 1; i < ndelim; ++i) {
+        eq = _mm_or_si128(eq, _mm_cmpeq_epi8(v, needles[i]));
+      }
+
+      int mask = _mm_movemask_epi8(eq);
+
+      if (!match) {
+        mask = ~mask & 0xffff;
+      }
+
+      if (mask) {
+        return pos + __builtin_ctz(mask);
+      }
+    }
+  }
+
+#endif
+  CharSet set(delimiters, ndelim);
+
+  for (; pos < len; ++pos) {
+    if (set.Has(str[pos]) == match) {
+      return pos;
+    }
+  }
+
+  return std::string::npos;
+}
+
+//------------------------------------------------------------------------------
+// Find the first character at or after pos escaped by curl_escaped
+//------------------------------------------------------------------------------
+size_t
+FindUrlUnsafe(const char* str, size_t len, size_t pos)
+{
+#if defined(__SSE2__)
+
+  for (; pos + 16 <= len; pos += 16) {
+    int mask = UrlUnsafeMask(_mm_loadu_si128((const __m128i*)(str + pos)));
+
+    if (mask) {
+      return pos + __builtin_ctz(mask);
+    }
+  }
+
+#endif
+
+  while ((pos < len) && IsUrlSafe(str[pos])) {
+    ++pos;
+  }
+
+  return pos;
+}
+}
+
+//------------------------------------------------------------------------------
+// Find the first character which is one of the delimiters
+//------------------------------------------------------------------------------
+size_t
+StringConversion::FindFirstOf(const char* str, size_t len, size_t pos,
+                              const char* delimiters, size_t ndelim)
+{
+  return FindDelimiter(str, len, pos, delimiters, ndelim, true);
+}
+
+//------------------------------------------------------------------------------
+// Find the first character which is none of the delimiters
+//------------------------------------------------------------------------------
+size_t
+StringConversion::FindFirstNotOf(const char* str, size_t len, size_t pos,
+                                 const char* delimiters, size_t ndelim)
+{
+  return FindDelimiter(str, len, pos, delimiters, ndelim, false);
+}
+
 //------------------------------------------------------------------------------
 // Tokenize a string
 //------------------------------------------------------------------------------
@@ -41,18 +272,22 @@ StringConversion::Tokenize(const std::string& str,
                            std::vector<std::string>& tokens,
                            const std::string& delimiters)
 {
+  const char* data = str.data();
+  size_t len = str.length();
+  const char* delim = delimiters.data();
+  size_t ndelim = delimiters.length();
   // Skip delimiters at beginning.
-  std::string::size_type lastPos = str.find_first_not_of(delimiters, 0);
+  size_t lastPos = FindFirstNotOf(data, len, 0, delim, ndelim);
   // Find first "non-delimiter".
-  std::string::size_type pos = str.find_first_of(delimiters, lastPos);
+  size_t pos = FindFirstOf(data, len, lastPos, delim, ndelim);
 
   while (std::string::npos != pos || std::string::npos != lastPos) {
     // Found a token, add it to the vector.
-    tokens.push_back(str.substr(lastPos, pos - lastPos));
+    tokens.emplace_back(data + lastPos, std::min(pos, len) - lastPos);
     // Skip delimiters.  Note the "not_of"
-    lastPos = str.find_first_not_of(delimiters, pos);
+    lastPos = FindFirstNotOf(data, len, pos, delim, ndelim);
     // Find next "non-delimiter"
-    pos = str.find_first_of(delimiters, lastPos);
+    pos = FindFirstOf(data, len, lastPos, delim, ndelim);
   }
 }
 
@@ -64,23 +299,27 @@ StringConversion::EmptyTokenize(const std::string& str,
                                 std::vector<std::string>& tokens,
                                 const std::string& delimiters)
 {
+  const char* data = str.data();
+  size_t len = str.length();
+  const char* delim = delimiters.data();
+  size_t ndelim = delimiters.length();
   // Skip delimiters at beginning.
-  std::string::size_type lastPos = str.find_first_not_of(delimiters, 0);
+  size_t lastPos = FindFirstNotOf(data, len, 0, delim, ndelim);
   // Find first "non-delimiter".
-  std::string::size_type pos = str.find_first_of(delimiters, lastPos);
+  size_t pos = FindFirstOf(data, len, lastPos, delim, ndelim);
 
   while (std::string::npos != pos || std::string::npos != lastPos) {
     // Found a token, add it to the vector.
-    tokens.push_back(str.substr(lastPos, pos - lastPos));
+    tokens.emplace_back(data + lastPos, std::min(pos, len) - lastPos);
     // Skip delimiters.  Note the "not_of"
-    lastPos = str.find_first_of(delimiters, pos);
+    lastPos = FindFirstOf(data, len, pos, delim, ndelim);
 
     if (lastPos != std::string::npos) {
       lastPos++;
     }
 
     // Find next "non-delimiter"
-    pos = str.find_first_of(delimiters, lastPos);
+    pos = FindFirstOf(data, len, lastPos, delim, ndelim);
   }
 }
 
@@ -166,18 +405,123 @@ StringConversion::GetReadableSizeString(XrdOucString& sizestring,
 std::string
 StringConversion::string_to_hex(const std::string& input)
 {
-  static const char* const lut = "0123456789ABCDEF";
-  size_t len = input.length();
   std::string output;
-  output.reserve(2 * len);
+  output.resize(2 * input.length());
+  HexEncode(input.data(), input.length(), &output[0], true);
+  return output;
+}
+
+//------------------------------------------------------------------------------
+// Hex encode a buffer
+//------------------------------------------------------------------------------
+char*
+StringConversion::HexEncode(const char* data, size_t len, char* out,
+                            bool upper)
+{
+  const char* lut = upper ? sHexUpper : sHexLower;
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i zero = _mm_set1_epi8('0');
+  // Distance from '9' + 1 to the first letter
+  const __m128i alpha = _mm_set1_epi8(upper ? 'A' - '0' - 10 : 'a' - '0' - 10);
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+    __m128i lo = _mm_and_si128(v, mask);
+    __m128i n0 = _mm_unpacklo_epi8(hi, lo);
+    __m128i n1 = _mm_unpackhi_epi8(hi, lo);
+    n0 = _mm_add_epi8(_mm_add_epi8(n0, zero),
+                      _mm_and_si128(_mm_cmpgt_epi8(n0, nine), alpha));
+    n1 = _mm_add_epi8(_mm_add_epi8(n1, zero),
+                      _mm_and_si128(_mm_cmpgt_epi8(n1, nine), alpha));
+    _mm_storeu_si128((__m128i*) out, n0);
+    _mm_storeu_si128((__m128i*)(out + 16), n1);
+    out += 32;
+  }
+
+#endif
+
+  for (; i < len; ++i) {
+    const unsigned char c = data[i];
+    *out++ = lut[c >> 4];
+    *out++ = lut[c & 15];
+  }
+
+  return out;
+}
 
-  for (size_t i = 0; i < len; ++i) {
-    const unsigned char c = input[i];
-    output.push_back(lut[c >> 4]);
-    output.push_back(lut[c & 15]);
+//------------------------------------------------------------------------------
+// Decode a hex string
+//------------------------------------------------------------------------------
+bool
+StringConversion::HexDecode(const char* hex, size_t len, char* out)
+{
+  if (len & 1) {
+    return false;
   }
 
-  return output;
+  size_t i = 0;
+#if defined(__SSE2__)
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i valid;
+    __m128i nib = HexNibbles(_mm_loadu_si128((const __m128i*)(hex + i)), true,
+                             valid);
+
+    if (_mm_movemask_epi8(valid) != 0xffff) {
+      return false;
+    }
+
+    _mm_storel_epi64((__m128i*) out, PackNibbles(nib));
+    out += 8;
+  }
+
+#endif
+
+  for (; i < len; i += 2) {
+    int hi = HexValue(hex[i]);
+    int lo = HexValue(hex[i + 1]);
+
+    if ((hi < 0) || (lo < 0)) {
+      return false;
+    }
+
+    *out++ = (char)((hi << 4) | lo);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Vectorized conversion of up to 16 hex digits
+//------------------------------------------------------------------------------
+bool
+StringConversion::AsciiHexToUInt64(const char* s, size_t len, uint64_t& value)
+{
+#if defined(__SSE2__)
+
+  // The lookup table conversion stops at a null character
+  if ((len > 16) || (strnlen(s, len) != len)) {
+    return false;
+  }
+
+  // Right aligned, the leading '0' digits don't change the value
+  char buffer[16];
+  memset(buffer, '0', sizeof(buffer));
+  memcpy(buffer + sizeof(buffer) - len, s, len);
+  __m128i valid;
+  __m128i nib = HexNibbles(_mm_loadu_si128((const __m128i*) buffer), false,
+                           valid);
+  uint64_t packed;
+  _mm_storel_epi64((__m128i*) &packed, PackNibbles(nib));
+  value = __builtin_bswap64(packed);
+  return true;
+#else
+  return false;
+#endif
 }
 
 //------------------------------------------------------------------------------
@@ -354,9 +698,9 @@ const char*
 StringConversion::GetSizeString(std::string& sizestring,
                                 unsigned long long insize)
 {
-  char buffer[1024];
-  sprintf(buffer, "%llu", insize);
-  sizestring = buffer;
+  char buffer[32];
+  char* end = FastUnsignedToAscii(insize, buffer);
+  sizestring.assign(buffer, end - buffer);
   return sizestring.c_str();
 }
 
@@ -367,12 +711,44 @@ const char*
 StringConversion::GetSizeString(XrdOucString& sizestring,
                                 unsigned long long insize)
 {
-  char buffer[1024];
-  sprintf(buffer, "%llu", insize);
+  char buffer[32];
+  *FastUnsignedToAscii(insize, buffer) = '\0';
   sizestring = buffer;
   return sizestring.c_str();
 }
 
+//------------------------------------------------------------------------------
+// Convert an unsigned number into its decimal representation
+//------------------------------------------------------------------------------
+char*
+StringConversion::FastUnsignedToAscii(unsigned long long u, char* s)
+{
+  static const char* const digits =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536"
+    "37383940414243444546474849505152535455565758596061626364656667686970717273"
+    "7475767778798081828384858687888990919293949596979899";
+  char buffer[20];
+  char* ptr = buffer + sizeof(buffer);
+
+  while (u >= 100) {
+    unsigned int i = (u % 100) * 2;
+    u /= 100;
+    *--ptr = digits[i + 1];
+    *--ptr = digits[i];
+  }
+
+  if (u < 10) {
+    *--ptr = '0' + u;
+  } else {
+    *--ptr = digits[u * 2 + 1];
+    *--ptr = digits[u * 2];
+  }
+
+  size_t len = buffer + sizeof(buffer) - ptr;
+  memcpy(s, ptr, len);
+  return s + len;
+}
+
 //------------------------------------------------------------------------------
 // Convert a floating point number into a string
 //------------------------------------------------------------------------------
@@ -702,7 +1078,8 @@ StringConversion::TimeNowAsString(XrdOucString& stime)
 const char*
 StringConversion::MaskTag(XrdOucString& line, const char* tag)
 {
-  XrdOucString smask = tag;
+  // Tags are short, the mask then fits in the inline buffer of the string
+  std::string smask = tag;
   smask += "=";
   int spos = line.find(smask.c_str());
   int epos = line.find("&", spos + 1);
@@ -922,105 +1299,100 @@ StringConversion::GetPrettySize(float size)
 }
 
 //------------------------------------------------------------------------------
-// CURL init/cleanup using local storage
+// Escape string the way curl_easy_escape does, keeping '/'
 //------------------------------------------------------------------------------
-void StringConversion::tlCurlFree(void* arg)
+std::string
+StringConversion::curl_escaped(const std::string& str)
 {
-  eos_static_debug("destroying thread specific CURL session");
-  // delete the buffer
-  curl_easy_cleanup((CURL*)arg);
+  std::string ret_str;
+  ret_str.reserve(str.length() + 16);
+  curl_escaped(str.data(), str.length(), ret_str);
+  return ret_str;
 }
 
-CURL* StringConversion::tlCurlInit()
+//------------------------------------------------------------------------------
+// Append the escaped string to the output
+//------------------------------------------------------------------------------
+void
+StringConversion::curl_escaped(const char* str, size_t len, std::string& out)
 {
-  eos_static_debug("allocating thread specific CURL session");
-  CURL* buf = curl_easy_init();
+  // this is a hack to avoid decoding a pathname twice
+  out.append("/#curl#", 7);
+  size_t pos = 0;
 
-  if (!buf) {
-    eos_static_crit("error initialising CURL easy session");
-  }
+  while (pos < len) {
+    size_t end = FindUrlUnsafe(str, len, pos);
+    out.append(str + pos, end - pos);
 
-  if (buf && pthread_setspecific(sPthreadKey, buf))
-    eos_static_crit("error registering thread-local buffer located at %p for "
-                    "cleaning up : memory will be leaked when thread is "
-                    "terminated", buf);
+    if (end == len) {
+      break;
+    }
 
-  return buf;
+    const unsigned char c = str[end];
+    const char escaped[3] = {'%', sHexUpper[c >> 4], sHexUpper[c & 15]};
+    out.append(escaped, 3);
+    pos = end + 1;
+  }
 }
 
-void StringConversion::tlInitThreadKey()
+//------------------------------------------------------------------------------
+// Unescape string the way curl_easy_unescape does
+//------------------------------------------------------------------------------
+std::string
+StringConversion::curl_unescaped(const std::string& str)
 {
-  curl_global_init(CURL_GLOBAL_DEFAULT);
-  pthread_key_create(&sPthreadKey, StringConversion::tlCurlFree);
+  std::string ret_str;
+  curl_unescaped(str.data(), str.length(), ret_str);
+  return ret_str;
 }
 
-thread_local CURL* StringConversion::curl = NULL;
-pthread_key_t  StringConversion::sPthreadKey;
-pthread_once_t StringConversion::sTlInit = PTHREAD_ONCE_INIT;
-
 //------------------------------------------------------------------------------
-// Escape string using CURL
+// Append the unescaped string to the output
 //------------------------------------------------------------------------------
-std::string
-StringConversion::curl_escaped(const std::string& str)
+void
+StringConversion::curl_unescaped(const char* str, size_t len, std::string& out)
 {
-  pthread_once(&sTlInit, tlInitThreadKey);
-  std::string ret_str = "<no-encoding>";
-
-  // encode the key
-  if (!curl) {
-    curl = tlCurlInit();
+  if ((len < 7) || memcmp(str, "/#curl#", 7)) {
+    // the string has already been decoded
+    out.append(str, len);
+    return;
   }
 
-  if (curl) {
-    char* output = curl_easy_escape(curl, str.c_str(), str.length());
+  size_t pos = 7;
 
-    if (output) {
-      ret_str = output;
-      curl_free(output);
-      // don't escape '/'
-      XrdOucString no_slash = ret_str.c_str();
+  while (pos < len) {
+    const char* pct = (const char*) memchr(str + pos, '%', len - pos);
+    size_t end = pct ? pct - str : len;
+    // curl returns a C string, a null character ends it
+    const char* nul = (const char*) memchr(str + pos, '\0', end - pos);
 
-      while (no_slash.replace("%2F", "/")) {}
-
-      // this is a hack to avoid decoding a pathname twice
-      no_slash.insert("/#curl#", 0);
-      ret_str = no_slash.c_str();
+    if (nul) {
+      out.append(str + pos, nul - (str + pos));
+      return;
     }
-  }
 
-  return ret_str;
-}
+    out.append(str + pos, end - pos);
 
-//------------------------------------------------------------------------------
-// Unescape string using CURL
-//------------------------------------------------------------------------------
-std::string
-StringConversion::curl_unescaped(const std::string& str)
-{
-  pthread_once(&sTlInit, tlInitThreadKey);
-  std::string ret_str = "<no-encoding>";
+    if (!pct) {
+      return;
+    }
 
-  // encode the key
-  if (!curl) {
-    curl = tlCurlInit();
-  }
+    int hi = (end + 2 < len) ? HexValue(str[end + 1]) : -1;
+    int lo = (hi >= 0) ? HexValue(str[end + 2]) : -1;
 
-  if (curl) {
-    if (strncmp(str.c_str(), "/#curl#", 7)) {
-      // the string has already been decoded
-      return str;
+    if (lo < 0) {
+      out.push_back('%');
+      pos = end + 1;
+      continue;
     }
 
-    char* output = curl_easy_unescape(curl, str.c_str() + 7, str.length() - 7, 0);
-
-    if (output) {
-      ret_str = output;
-      curl_free(output);
+    if (!(hi | lo)) {
+      return;
     }
-  }
 
-  return ret_str;
+    out.push_back((char)((hi << 4) | lo));
+    pos = end + 3;
+  }
 }
 
 // ---------------------------------------------------------------------------
@@ -1179,22 +1551,74 @@ StringConversion::EncodeInvalidUTF8(const string& key)
 std::string
 StringConversion::SealXrdOpaque(const std::string& input)
 {
-  std::string sealed {
-    input
-  };
-  ReplaceStringInPlace(sealed, "&", "#AND#");
+  std::string sealed;
+  sealed.reserve(input.length());
+  SealXrdOpaque(input.data(), input.length(), sealed);
   return sealed;
 }
 
+//------------------------------------------------------------------------------
+// Append the sealed opaque xrootd info to the output
+//------------------------------------------------------------------------------
+void
+StringConversion::SealXrdOpaque(const char* input, size_t len,
+                                std::string& out)
+{
+  const char* end = input + len;
+
+  while (input < end) {
+    const char* amp = (const char*) memchr(input, '&', end - input);
+
+    if (!amp) {
+      out.append(input, end - input);
+      return;
+    }
+
+    out.append(input, amp - input);
+    out.append("#AND#", 5);
+    input = amp + 1;
+  }
+}
+
 //------------------------------------------------------------------------------
 // Unseal opaque xrootd info. I.e. replace any #AND# with &
 //------------------------------------------------------------------------------
 std::string
 StringConversion::UnsealXrdOpaque(const std::string& input)
 {
-  std::string unsealed {input};
-  ReplaceStringInPlace(unsealed, "#AND#", "&");
+  std::string unsealed;
+  unsealed.reserve(input.length());
+  UnsealXrdOpaque(input.data(), input.length(), unsealed);
   return unsealed;
 }
 
+//------------------------------------------------------------------------------
+// Append the unsealed opaque xrootd info to the output
+//------------------------------------------------------------------------------
+void
+StringConversion::UnsealXrdOpaque(const char* input, size_t len,
+                                  std::string& out)
+{
+  const char* end = input + len;
+
+  while (input < end) {
+    const char* hash = (const char*) memchr(input, '#', end - input);
+
+    if (!hash) {
+      out.append(input, end - input);
+      return;
+    }
+
+    out.append(input, hash - input);
+
+    if ((end - hash >= 5) && !memcmp(hash, "#AND#", 5)) {
+      out.push_back('&');
+      input = hash + 5;
+    } else {
+      out.push_back('#');
+      input = hash + 1;
+    }
+  }
+}
+
 EOSCOMMONNAMESPACE_END
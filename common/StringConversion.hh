@@ -44,8 +44,6 @@
 #include <fstream>
 #include <sstream>
 
-typedef void CURL;
-
 EOSCOMMONNAMESPACE_BEGIN
 
 //! Constants used throughout the code
@@ -93,6 +91,63 @@ public:
                             std::vector<std::string>& tokens,
                             const std::string& delimiters = " ");
 
+  // ---------------------------------------------------------------------------
+  /**
+   * Tokenize a buffer without allocating, same splitting as Tokenize
+   *
+   * @param str buffer to be tokenized
+   * @param len length of the buffer
+   * @param delimiters delimiter characters
+   * @param func called as func(const char* token, size_t length) per token
+   */
+  // ---------------------------------------------------------------------------
+  template <typename Func>
+  static void ForEachToken(const char* str, size_t len, const char* delimiters,
+                           Func func)
+  {
+    size_t ndelim = strlen(delimiters);
+    size_t last = FindFirstNotOf(str, len, 0, delimiters, ndelim);
+
+    while (last != std::string::npos) {
+      size_t pos = FindFirstOf(str, len, last, delimiters, ndelim);
+
+      if (pos == std::string::npos) {
+        func(str + last, len - last);
+        return;
+      }
+
+      func(str + last, pos - last);
+      last = FindFirstNotOf(str, len, pos, delimiters, ndelim);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  /**
+   * Find the first character of a buffer which is one of the delimiters,
+   * vectorized for up to 4 delimiters
+   *
+   * @param str buffer to search
+   * @param len length of the buffer
+   * @param pos start position
+   * @param delimiters delimiter characters
+   * @param ndelim number of delimiter characters
+   *
+   * @return position or std::string::npos, like std::string::find_first_of
+   */
+  // ---------------------------------------------------------------------------
+  static size_t FindFirstOf(const char* str, size_t len, size_t pos,
+                            const char* delimiters, size_t ndelim);
+
+  // ---------------------------------------------------------------------------
+  /**
+   * Find the first character of a buffer which is none of the delimiters
+   *
+   * @return position or std::string::npos, like std::string::find_first_not_of
+   */
+  // ---------------------------------------------------------------------------
+  static size_t FindFirstNotOf(const char* str, size_t len, size_t pos,
+                               const char* delimiters, size_t ndelim);
+
 
   // ---------------------------------------------------------------------------
   /**
@@ -106,6 +161,34 @@ public:
   static std::string string_to_hex(const std::string& input);
   static std::string char_to_hex(const char input);
 
+  // ---------------------------------------------------------------------------
+  /**
+   * Hex encode a buffer, vectorized
+   *
+   * @param data buffer to encode
+   * @param len length of the buffer
+   * @param out output buffer of at least 2 * len characters
+   * @param upper use upper case hex digits
+   *
+   * @return the address of the last character written in the buffer + 1
+   */
+  // ---------------------------------------------------------------------------
+  static char* HexEncode(const char* data, size_t len, char* out,
+                         bool upper = false);
+
+  // ---------------------------------------------------------------------------
+  /**
+   * Decode a hex string, vectorized, both upper and lower case are accepted
+   *
+   * @param hex hex string
+   * @param len length of the hex string
+   * @param out output buffer of at least len / 2 characters
+   *
+   * @return true if successful, false if len is odd or not a hex string
+   */
+  // ---------------------------------------------------------------------------
+  static bool HexDecode(const char* hex, size_t len, char* out);
+
   // ---------------------------------------------------------------------------
   /**
    * Convert a long long value into time s,m,h,d  scale
@@ -228,6 +311,18 @@ public:
   static const char*
   GetSizeString(std::string& sizestring, unsigned long long insize);
 
+  // ---------------------------------------------------------------------------
+  /**
+   * Convert an unsigned number into its decimal representation
+   *
+   * @param u number
+   * @param s buffer of at least 20 characters to write the result to
+   *
+   * @return the address of the last character written in the buffer + 1
+   */
+  // ---------------------------------------------------------------------------
+  static char* FastUnsignedToAscii(unsigned long long u, char* s);
+
   // ---------------------------------------------------------------------------
   /**
    * Convert a floating point number into a string
@@ -634,6 +729,13 @@ public:
   template <typename UnsignedType> static void
   FastAsciiHexToUnsigned(char* s, UnsignedType* u, int len = -1)
   {
+    uint64_t value;
+
+    if ((len > 0) && (len <= 16) && AsciiHexToUInt64(s, len, value)) {
+      *u = static_cast<UnsignedType>(value);
+      return;
+    }
+
     *u = 0;
 
     for (int j = 0; s[j] != 0 && j != len; j++) {
@@ -653,6 +755,18 @@ public:
   static std::string
   curl_unescaped(const std::string& str);
 
+  // ---------------------------------------------------------------------------
+  /**
+   * Append an unescaped URI to the output
+   *
+   * @param str uri to unescape
+   * @param len length of the uri
+   * @param out string to which the result is appended
+   */
+  // ---------------------------------------------------------------------------
+  static void
+  curl_unescaped(const char* str, size_t len, std::string& out);
+
   // ---------------------------------------------------------------------------
   /**
    * Return an escaped URI
@@ -664,6 +778,19 @@ public:
   static std::string
   curl_escaped(const std::string& str);
 
+  // ---------------------------------------------------------------------------
+  /**
+   * Append an escaped URI to the output, same encoding as curl_easy_escape
+   * except that '/' is kept and prefixed by the /#curl# marker
+   *
+   * @param str uri to escape
+   * @param len length of the uri
+   * @param out string to which the result is appended
+   */
+  // ---------------------------------------------------------------------------
+  static void
+  curl_escaped(const char* str, size_t len, std::string& out);
+
   // ---------------------------------------------------------------------------
   /**
    * Return an enocded json string
@@ -719,7 +846,7 @@ public:
 
     size_t pos = 0;
 
-    while ((pos = subject.find(search)) != std::string::npos) {
+    while ((pos = subject.find(search, pos)) != std::string::npos) {
       subject.replace(pos, search.length(), replace);
       pos += replace.length();
     }
@@ -752,6 +879,11 @@ public:
   //----------------------------------------------------------------------------
   static std::string SealXrdOpaque(const std::string& input);
 
+  //----------------------------------------------------------------------------
+  //! Append the sealed opaque xrootd info to the output
+  //----------------------------------------------------------------------------
+  static void SealXrdOpaque(const char* input, size_t len, std::string& out);
+
   //----------------------------------------------------------------------------
   //! Unseal opaque xrootd inf i.e. replace any #AND# with &
   //!
@@ -761,6 +893,11 @@ public:
   //----------------------------------------------------------------------------
   static std::string UnsealXrdOpaque(const std::string& input);
 
+  //----------------------------------------------------------------------------
+  //! Append the unsealed opaque xrootd info to the output
+  //----------------------------------------------------------------------------
+  static void UnsealXrdOpaque(const char* input, size_t len, std::string& out);
+
   //----------------------------------------------------------------------------
   //! Constructor
   //----------------------------------------------------------------------------
@@ -775,13 +912,14 @@ private:
   //! Lookup Table for Hex Ascii Conversion
   static char pAscii2HexLkup[256];
   static char pHex2AsciiLkup[16];
-  static thread_local CURL* curl;
-  //! Thread-local storage management
-  static pthread_key_t sPthreadKey;
-  static pthread_once_t sTlInit;
-  static void tlCurlFree(void* arg);
-  static CURL* tlCurlInit();
-  static void tlInitThreadKey();
+
+  //----------------------------------------------------------------------------
+  //! Vectorized conversion of up to 16 hex digits with the semantics of the
+  //! lookup table i.e. characters other than [0-9a-f] count as 0
+  //!
+  //! @return false if the digits contain a null character
+  //----------------------------------------------------------------------------
+  static bool AsciiHexToUInt64(const char* s, size_t len, uint64_t& value);
 };
 
 EOSCOMMONNAMESPACE_END
@@ -0,0 +1,205 @@
+//------------------------------------------------------------------------------
+// File: StripedRWMutex.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "common/Namespace.hh"
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class StripedRWMutex - fixed set of read-write mutexes selected by hashing
+//! an object id. Operations touching different objects most likely end up on
+//! different stripes and do not block each other, while operations on the
+//! same object are serialized. Locking several ids is done in stripe order to
+//! avoid deadlocks.
+//------------------------------------------------------------------------------
+class StripedRWMutex
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param num_stripes number of stripes, rounded up to a power of two
+  //----------------------------------------------------------------------------
+  explicit StripedRWMutex(size_t num_stripes = 256):
+    mMask(RoundUpPow2(num_stripes) - 1),
+    mStripes(new std::shared_timed_mutex[mMask + 1])
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Forbid copying or moving
+  //----------------------------------------------------------------------------
+  StripedRWMutex(const StripedRWMutex&) = delete;
+  StripedRWMutex& operator=(const StripedRWMutex&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Get stripe index for the given id
+  //----------------------------------------------------------------------------
+  inline size_t
+  GetStripeIndex(uint64_t id) const
+  {
+    // Fibonacci hashing so that consecutive ids spread over the stripes
+    return (size_t)((id * 0x9e3779b97f4a7c15ull) >> 32) & mMask;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get stripe mutex for the given id
+  //----------------------------------------------------------------------------
+  inline std::shared_timed_mutex&
+  GetStripe(uint64_t id)
+  {
+    return mStripes[GetStripeIndex(id)];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get stripe mutex by index
+  //----------------------------------------------------------------------------
+  inline std::shared_timed_mutex&
+  GetStripeByIndex(size_t index)
+  {
+    return mStripes[index & mMask];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of stripes
+  //----------------------------------------------------------------------------
+  inline size_t
+  GetNumStripes() const
+  {
+    return mMask + 1;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Round up to the next power of two
+  //----------------------------------------------------------------------------
+  static size_t
+  RoundUpPow2(size_t val)
+  {
+    size_t pow2 = 1;
+
+    while (pow2 < val) {
+      pow2 <<= 1;
+    }
+
+    return pow2;
+  }
+
+  size_t mMask; ///< Mask used to select the stripe
+  std::unique_ptr<std::shared_timed_mutex[]> mStripes; ///< Stripe mutexes
+};
+
+//------------------------------------------------------------------------------
+//! Write lock on the stripes of one or several ids - the stripes are locked
+//! in increasing index order and each stripe only once.
+//------------------------------------------------------------------------------
+class StripedWriteLock
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param mutex striped mutex, if null the lock is a no-op
+  //! @param ids object ids to lock
+  //----------------------------------------------------------------------------
+  StripedWriteLock(StripedRWMutex* mutex, std::initializer_list<uint64_t> ids):
+    mMutex(mutex)
+  {
+    if (mMutex) {
+      for (auto id : ids) {
+        mIndexes.push_back(mMutex->GetStripeIndex(id));
+      }
+
+      std::sort(mIndexes.begin(), mIndexes.end());
+      mIndexes.erase(std::unique(mIndexes.begin(), mIndexes.end()),
+                     mIndexes.end());
+
+      for (auto index : mIndexes) {
+        mMutex->GetStripeByIndex(index).lock();
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~StripedWriteLock()
+  {
+    if (mMutex) {
+      for (auto it = mIndexes.rbegin(); it != mIndexes.rend(); ++it) {
+        mMutex->GetStripeByIndex(*it).unlock();
+      }
+    }
+  }
+
+  StripedWriteLock(const StripedWriteLock&) = delete;
+  StripedWriteLock& operator=(const StripedWriteLock&) = delete;
+
+private:
+  StripedRWMutex* mMutex;
+  std::vector<size_t> mIndexes;
+};
+
+//------------------------------------------------------------------------------
+//! Read lock on the stripe of one id
+//------------------------------------------------------------------------------
+class StripedReadLock
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param mutex striped mutex, if null the lock is a no-op
+  //! @param id object id to lock
+  //----------------------------------------------------------------------------
+  StripedReadLock(StripedRWMutex* mutex, uint64_t id):
+    mStripe(mutex ? &mutex->GetStripe(id) : nullptr)
+  {
+    if (mStripe) {
+      mStripe->lock_shared();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~StripedReadLock()
+  {
+    if (mStripe) {
+      mStripe->unlock_shared();
+    }
+  }
+
+  StripedReadLock(const StripedReadLock&) = delete;
+  StripedReadLock& operator=(const StripedReadLock&) = delete;
+
+private:
+  std::shared_timed_mutex* mStripe;
+};
+
+EOSCOMMONNAMESPACE_END
@@ -23,9 +23,20 @@
 
 #pragma once
 #include "common/Namespace.hh"
-#include "common/ConcurrentQueue.hh"
+#include "common/Logging.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #ifdef __APPLE__
 #include <cmath>
@@ -35,10 +46,27 @@ EOSCOMMONNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------------
 //! @brief Dynamically scaling pool of threads which will asynchronously execute tasks
+//!
+//! Every worker has its own task deque, tasks pushed from a worker of the pool
+//! go into the deque of that worker, all the others into a global injection
+//! queue. A worker takes the most recent task of its own deque, then the
+//! oldest one of the global queue and otherwise steals the oldest task of
+//! another worker, so the workers only contend when they run out of work.
+//!
+//! The pool grows as soon as the oldest queued task waits for longer than
+//! sMaxQueueWaitMs and shrinks by stopping the threads which stay idle.
 //------------------------------------------------------------------------------------
 class ThreadPool
 {
 public:
+  // Enumerators rather than static members, the class is header only
+  enum : unsigned int {
+    //! Queue wait time in milliseconds beyond which new threads are started
+    sMaxQueueWaitMs = 100,
+    //! Interval in milliseconds at which the maintainer checks the wait time
+    sMaintainerIntervalMs = 50
+  };
+
   //----------------------------------------------------------------------------------
   //! @brief Create a new thread pool
   //!
@@ -46,15 +74,14 @@ public:
   //!        defaults to hardware concurrency
   //! @param threadsMax the maximum number of allocated threads,
   //!        defaults to hardware concurrency
-  //! @param samplingInterval sampling interval in seconds for the waiting jobs,
-  //!        required for dynamic scaling, defaults to 10 seconds
-  //! @param samplingNumber number of samples to collect before making a scaling
-  //!        decision, scaling decision will be made after samplingInterval *
-  //!        samplingNumber seconds
-  //! @param averageWaitingJobsPerNewThread the average number of waiting jobs per which
-  //!        one new thread should be started, defaults to 10,
-  //!        e.g. if in average 27.8 jobs were waiting for execution, then 2 new
-  //!        threads will be added to the pool
+  //! @param samplingInterval sampling interval in seconds, see samplingNumber
+  //! @param samplingNumber the pool shrinks back to threadsMin within
+  //!        samplingInterval * samplingNumber seconds of becoming idle, the
+  //!        threads idle for 90% of that time are stopped
+  //! @param averageWaitingJobsPerNewThread the number of waiting jobs per which
+  //!        one new thread is started when the queue wait time is too long,
+  //!        defaults to 10, e.g. if 27 jobs are waiting then 2 new threads
+  //!        will be added to the pool
   //! @param name identifier for the thread pool
   //----------------------------------------------------------------------------------
   explicit ThreadPool(unsigned int threadsMin =
@@ -66,117 +93,13 @@ public:
                       const std::string& identifier = "default"):
     mThreadsMin(threadsMin),
     mThreadsMax(threadsMin > threadsMax ? threadsMin : threadsMax),
-    mPoolSize(0ul), mId(identifier)
+    mIdleTimeout(std::max(900u * samplingInterval * samplingNumber,
+                          (unsigned int) sMaxQueueWaitMs)),
+    mJobsPerNewThread(std::max(averageWaitingJobsPerNewThread, 1u)),
+    mId(identifier)
   {
-    auto threadPoolFunc = [this] {
-      std::pair<bool, std::shared_ptr<std::function<void(void)>>> task;
-      bool toContinue = true;
-
-      do {
-        mTasks.wait_pop(task);
-        toContinue = task.first;
-
-        // Termination is signalled by false
-        if (toContinue)
-        {
-          (*(task.second))();
-        }
-      } while (toContinue);
-    };
-
-    for (auto i = 0u; i < std::max(mThreadsMin.load(), 1u); ++i) {
-      try {
-        mThreadPool.emplace_back(std::async(std::launch::async, threadPoolFunc));
-      } catch (const std::exception& e) {
-        std::cerr << "error: std::async couldn't start a new thread "
-                  << "and threw an exception: " << e.what() << std::endl;
-        continue;
-      }
-
-      ++mThreadCount;
-    }
-
-    mPoolSize = mThreadPool.size();
-
-    if (mThreadsMax > mThreadsMin) {
-      auto maintainerThreadFunc = [this, threadPoolFunc, samplingInterval,
-      samplingNumber, averageWaitingJobsPerNewThread] {
-        auto rounds = 0u, sumQueueSize = 0u;
-        auto signalFuture = mMaintainerSignal.get_future();
-
-        while (true)
-        {
-          if (signalFuture.valid()) {
-            if (signalFuture.wait_for(std::chrono::seconds(samplingInterval)) ==
-            std::future_status::ready) {
-              break;
-            }
-          } else {
-            break;
-          }
-
-          // Check first if we have finished, removable threads/futures and remove them
-          mThreadPool.erase(
-            std::remove_if(mThreadPool.begin(), mThreadPool.end(),
-          [](std::future<void>& future) {
-            return (future.wait_for(std::chrono::seconds(0)) ==
-                    std::future_status::ready);
-          }),
-          mThreadPool.end());
-          sumQueueSize += mTasks.size();
-
-          if (++rounds == samplingNumber) {
-            auto averageQueueSize = (double) sumQueueSize / rounds;
-
-            if ((averageQueueSize > mThreadCount) && (mThreadCount <= mThreadsMax)) {
-              auto threadsToAdd =
-                std::min((unsigned int) floor(averageQueueSize /
-                                              averageWaitingJobsPerNewThread),
-                         mThreadsMax - mThreadCount);
-
-              while (threadsToAdd > 0) {
-                try {
-                  mThreadPool.emplace_back(std::async(std::launch::async,
-                                                      threadPoolFunc));
-                } catch (const std::exception& e) {
-                  std::cerr << "error: std::async couldn't start a new thread "
-                            << "and threw an exception: " << e.what() << std::endl;
-                  continue;
-                }
-
-                ++mThreadCount;
-                --threadsToAdd;
-              }
-            } else {
-              unsigned int threadsToRemove = 0ull;
-
-              if (mThreadCount > mThreadsMax) {
-                threadsToRemove = mThreadCount - mThreadsMax;
-              } else {
-                threadsToRemove = mThreadCount -
-                                  std::max((unsigned int) floor(averageQueueSize), mThreadsMin.load());
-              }
-
-              // Push in fake tasks for each thread to be stopped so threads can wake up and
-              // notice that they should terminate. Termination is signalled with false.
-              for (auto i = 0u; i < threadsToRemove; ++i) {
-                auto fake_task = std::make_pair(false, std::make_shared
-                                                <std::function<void(void)>> ([] {}));
-                mTasks.push(fake_task);
-              }
-
-              mThreadCount -= threadsToRemove;
-            }
-
-            sumQueueSize = 0u;
-            rounds = 0u;
-          }
-
-          mPoolSize = mThreadPool.size();
-        }
-      };
-      mMaintainerThread.reset(new std::thread(maintainerThreadFunc));
-    }
+    StartThreads(std::max(mThreadsMin.load(), 1u));
+    mMaintainerThread.reset(new std::thread(&ThreadPool::Maintain, this));
   }
 
   //----------------------------------------------------------------------------
@@ -193,42 +116,73 @@ public:
   std::future<Ret> PushTask(std::function<Ret(void)> func)
   {
     auto task = std::make_shared<std::packaged_task<Ret(void)>>(func);
-    auto taskFunc =
-      std::make_pair(true,
-    std::make_shared<std::function<void(void)>>([task] {
-      (*task)();
-    }));
-    mTasks.push(taskFunc);
+    Task entry {[task] {
+        (*task)();
+      }, std::chrono::steady_clock::now()
+    };
+    Worker* worker = CurrentWorker();
+
+    if (worker && (worker->mPool == this)) {
+      std::lock_guard<std::mutex> lock(worker->mMutex);
+      worker->mTasks.push_back(std::move(entry));
+    } else {
+      std::lock_guard<std::mutex> lock(mGlobalMutex);
+      mGlobalTasks.push_back(std::move(entry));
+    }
+
+    ++mQueued;
+
+    // Only wake up a worker if one is actually sleeping
+    if (mNumIdle.load()) {
+      std::lock_guard<std::mutex> lock(mIdleMutex);
+      mIdleCv.notify_one();
+    }
+
     return task->get_future();
   }
 
   //----------------------------------------------------------------------------
-  //! @brief Stop the thread pool. All threads will be stopped and the pool
-  //! cannot be used again.
+  //! @brief Stop the thread pool. The tasks already queued are executed, then
+  //! all threads are stopped and the pool cannot be used again.
   //----------------------------------------------------------------------------
   void Stop()
   {
+    {
+      std::lock_guard<std::mutex> lock(mIdleMutex);
+      mStop = true;
+      mIdleCv.notify_all();
+      mMaintainerCv.notify_all();
+    }
+
     if (mMaintainerThread && mMaintainerThread->joinable()) {
-      mMaintainerSignal.set_value();
       mMaintainerThread->join();
     }
 
-    // Push in fake tasks for each threads so all waiting can wake up and
-    // notice that running is over. Termination is signalled with false.
-    for (auto i = 0u; i < mThreadPool.size(); ++i) {
-      auto fake_task = std::make_pair(false, std::make_shared
-                                      <std::function<void(void)>> ([] {}));
-      mTasks.push(fake_task);
+    // No more threads are started once the maintainer is gone. Keep the
+    // workers listed while joining them so that their tasks can be stolen.
+    std::vector<std::shared_ptr<Worker>> workers;
+    {
+      std::shared_lock<std::shared_timed_mutex> lock(mWorkersMutex);
+      workers = mWorkers;
+      workers.insert(workers.end(), mRetired.begin(), mRetired.end());
     }
 
-    for (auto& future : mThreadPool) {
-      if (future.valid()) {
-        future.get();
+    for (auto& worker : workers) {
+      if (worker->mThread.joinable()) {
+        worker->mThread.join();
       }
     }
 
-    mTasks.clear();
-    mThreadPool.clear();
+    {
+      std::unique_lock<std::shared_timed_mutex> lock(mWorkersMutex);
+      mWorkers.clear();
+      mRetired.clear();
+    }
+
+    // Tasks pushed after stopping are dropped, breaking their promises
+    std::lock_guard<std::mutex> lock(mGlobalMutex);
+    mGlobalTasks.clear();
+    mQueued = 0;
   }
 
   //----------------------------------------------------------------------------
@@ -248,8 +202,8 @@ public:
     oss <<  "thread_pool=" << mId
         << " min=" << mThreadsMin
         << " max=" << mThreadsMax
-        << " size=" << mPoolSize
-        << " queue_size=" << mTasks.size();
+        << " size=" << mThreadCount
+        << " queue_size=" << mQueued;
     return oss.str();
   }
 
@@ -292,7 +246,7 @@ public:
   //----------------------------------------------------------------------------
   unsigned int GetSize()
   {
-    return mPoolSize;
+    return mThreadCount;
   }
 
   // Disable copy/move constructors and assignment operators
@@ -302,14 +256,285 @@ public:
   ThreadPool& operator=(ThreadPool&&) = delete;
 
 private:
-  std::vector<std::future<void>> mThreadPool;
-  eos::common::ConcurrentQueue<std::pair<bool, std::shared_ptr<std::function<void(void)>>>>
-  mTasks;
-  std::unique_ptr<std::thread> mMaintainerThread;
-  std::promise<void> mMaintainerSignal;
+  //----------------------------------------------------------------------------
+  //! Queued task with the time it was pushed
+  //----------------------------------------------------------------------------
+  struct Task {
+    std::function<void(void)> mFunc;
+    std::chrono::steady_clock::time_point mQueued;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Worker thread with its own task deque
+  //----------------------------------------------------------------------------
+  struct Worker {
+    explicit Worker(ThreadPool* pool): mPool(pool) {}
+
+    ThreadPool* mPool;
+    std::mutex mMutex; ///< Protects mTasks
+    std::deque<Task> mTasks;
+    std::thread mThread;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Worker of the pool running on the current thread, if any
+  //----------------------------------------------------------------------------
+  static Worker*& CurrentWorker()
+  {
+    static thread_local Worker* worker = nullptr;
+    return worker;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Start the given number of threads
+  //----------------------------------------------------------------------------
+  void StartThreads(unsigned int num)
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(mWorkersMutex);
+
+    for (auto i = 0u; i < num; ++i) {
+      auto worker = std::make_shared<Worker>(this);
+      ++mThreadCount;
+
+      try {
+        worker->mThread = std::thread(&ThreadPool::Run, this, worker.get());
+      } catch (const std::exception& e) {
+        eos_static_err("msg=\"failed to start thread\" thread_pool=%s "
+                       "reason=\"%s\"", mId.c_str(), e.what());
+        --mThreadCount;
+        break;
+      }
+
+      mWorkers.push_back(std::move(worker));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Take a task from the own deque, the global queue or another worker
+  //!
+  //! @return true if a task was found, otherwise false
+  //----------------------------------------------------------------------------
+  bool TakeTask(Worker* self, Task& task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(self->mMutex);
+
+      if (!self->mTasks.empty()) {
+        task = std::move(self->mTasks.back());
+        self->mTasks.pop_back();
+        return true;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mGlobalMutex);
+
+      if (!mGlobalTasks.empty()) {
+        task = std::move(mGlobalTasks.front());
+        mGlobalTasks.pop_front();
+        return true;
+      }
+    }
+
+    std::shared_lock<std::shared_timed_mutex> lock(mWorkersMutex);
+    size_t num = mWorkers.size();
+    // Spread the thieves over the victims
+    size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+    for (size_t i = 0; i < num; ++i) {
+      Worker* victim = mWorkers[(start + i) % num].get();
+
+      if (victim == self) {
+        continue;
+      }
+
+      std::lock_guard<std::mutex> vlock(victim->mMutex);
+
+      if (!victim->mTasks.empty()) {
+        task = std::move(victim->mTasks.front());
+        victim->mTasks.pop_front();
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Stop the given worker if the pool has more than the given number of
+  //! threads, its remaining tasks are moved to the global queue
+  //!
+  //! @return true if the worker must exit, otherwise false
+  //----------------------------------------------------------------------------
+  bool Retire(Worker* self, unsigned int limit)
+  {
+    unsigned int count = mThreadCount.load();
+
+    do {
+      if (count <= std::max(limit, 1u)) {
+        return false;
+      }
+    } while (!mThreadCount.compare_exchange_weak(count, count - 1));
+
+    std::unique_lock<std::shared_timed_mutex> lock(mWorkersMutex);
+    {
+      std::lock_guard<std::mutex> glock(mGlobalMutex);
+      std::lock_guard<std::mutex> wlock(self->mMutex);
+
+      for (auto& task : self->mTasks) {
+        mGlobalTasks.push_back(std::move(task));
+      }
+
+      self->mTasks.clear();
+    }
+
+    for (auto it = mWorkers.begin(); it != mWorkers.end(); ++it) {
+      if (it->get() == self) {
+        // Joined by the maintainer
+        mRetired.push_back(std::move(*it));
+        mWorkers.erase(it);
+        break;
+      }
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Loop of a worker thread
+  //----------------------------------------------------------------------------
+  void Run(Worker* self)
+  {
+    CurrentWorker() = self;
+    Task task;
+
+    while (true) {
+      if (TakeTask(self, task)) {
+        --mQueued;
+        task.mFunc();
+        task.mFunc = nullptr;
+
+        // The max may have been lowered
+        if (!mStop && Retire(self, mThreadsMax)) {
+          break;
+        }
+
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(mIdleMutex);
+
+      if (mStop && !mQueued.load()) {
+        break;
+      }
+
+      ++mNumIdle;
+      bool woken = mIdleCv.wait_for(lock, std::chrono::milliseconds(mIdleTimeout),
+      [this] {
+        return mStop || mQueued.load();
+      });
+      --mNumIdle;
+      lock.unlock();
+
+      if (!woken && Retire(self, mThreadsMin)) {
+        break;
+      }
+    }
+
+    CurrentWorker() = nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get how long the oldest queued task has been waiting
+  //----------------------------------------------------------------------------
+  std::chrono::steady_clock::duration GetMaxQueueWait()
+  {
+    auto now = std::chrono::steady_clock::now();
+    auto oldest = now;
+    {
+      std::lock_guard<std::mutex> lock(mGlobalMutex);
+
+      if (!mGlobalTasks.empty()) {
+        oldest = std::min(oldest, mGlobalTasks.front().mQueued);
+      }
+    }
+    std::shared_lock<std::shared_timed_mutex> lock(mWorkersMutex);
+
+    for (auto& worker : mWorkers) {
+      std::lock_guard<std::mutex> wlock(worker->mMutex);
+
+      if (!worker->mTasks.empty()) {
+        oldest = std::min(oldest, worker->mTasks.front().mQueued);
+      }
+    }
+
+    return now - oldest;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Loop of the maintainer thread starting threads when the tasks wait for
+  //! too long and joining the stopped ones
+  //----------------------------------------------------------------------------
+  void Maintain()
+  {
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mIdleMutex);
+
+        if (mMaintainerCv.wait_for(lock,
+                                   std::chrono::milliseconds(sMaintainerIntervalMs),
+        [this] {
+        return mStop.load();
+        })) {
+          break;
+        }
+      }
+
+      std::vector<std::shared_ptr<Worker>> retired;
+      {
+        std::unique_lock<std::shared_timed_mutex> lock(mWorkersMutex);
+        retired.swap(mRetired);
+      }
+
+      for (auto& worker : retired) {
+        worker->mThread.join();
+      }
+
+      unsigned int count = mThreadCount.load();
+      unsigned int max = mThreadsMax.load();
+      unsigned int to_add = 0;
+
+      if (count < mThreadsMin.load()) {
+        to_add = mThreadsMin.load() - count;
+      } else if ((count < max) && mQueued.load() && !mNumIdle.load() &&
+                 (GetMaxQueueWait() > std::chrono::milliseconds(sMaxQueueWaitMs))) {
+        to_add = std::min(std::max(mQueued.load() / mJobsPerNewThread, 1u),
+                          max - count);
+      }
+
+      if (to_add) {
+        StartThreads(to_add);
+      }
+    }
+  }
+
   std::atomic_uint mThreadCount {0};
-  std::atomic_uint mThreadsMin, mThreadsMax, mPoolSize;
+  std::atomic_uint mThreadsMin, mThreadsMax;
+  unsigned int mIdleTimeout; ///< Idle time in ms before stopping a thread
+  unsigned int mJobsPerNewThread; ///< Queued jobs per thread to start
   std::string mId; ///< Thread pool identifier
+  std::atomic<bool> mStop {false};
+  std::atomic_uint mQueued {0}; ///< Number of queued tasks
+  std::atomic_uint mNumIdle {0}; ///< Number of sleeping workers
+  std::mutex mIdleMutex; ///< Mutex for mIdleCv
+  std::condition_variable mIdleCv; ///< Wakes up the sleeping workers
+  std::condition_variable mMaintainerCv; ///< Wakes up the maintainer
+  std::mutex mGlobalMutex; ///< Protects mGlobalTasks
+  std::deque<Task> mGlobalTasks; ///< Injection queue for external tasks
+  std::shared_timed_mutex mWorkersMutex; ///< Protects mWorkers and mRetired
+  std::vector<std::shared_ptr<Worker>> mWorkers; ///< Running workers
+  std::vector<std::shared_ptr<Worker>> mRetired; ///< Stopped, not yet joined
+  std::unique_ptr<std::thread> mMaintainerThread;
 };
 
 EOSCOMMONNAMESPACE_END
@@ -22,16 +22,20 @@
  ************************************************************************/
 
 #include "common/XrdConnPool.hh"
+#include <algorithm>
 #include <limits>
 #include <sstream>
 
 EOSCOMMONNAMESPACE_BEGIN
 
+constexpr uint32_t XrdConnPool::sMaxPoolSize;
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 XrdConnPool::XrdConnPool(bool is_enabled, uint32_t max_size):
-  mIsEnabled(is_enabled), mMaxSize(max_size)
+  mIsEnabled(is_enabled), mMaxSize(max_size),
+  mTargetDelay(1000), mIdleTimeout(300)
 {
   if (!mIsEnabled && getenv("EOS_XRD_USE_CONNECTION_POOL")) {
     mIsEnabled = true;
@@ -46,14 +50,24 @@ XrdConnPool::XrdConnPool(bool is_enabled, uint32_t max_size):
       max_size = 1;
     }
 
-    if (max_size > 1024) {
+    if (max_size > sMaxPoolSize) {
       eos_warning("%s", "msg=\"too big EOS_XRD_CONNECTION_POOL_SIZE, forcing "
                   "max size to 1024\"");
-      max_size = 1024;
+      max_size = sMaxPoolSize;
     }
 
     mMaxSize = max_size;
   }
+
+  if (getenv("EOS_XRD_CONNECTION_POOL_TARGET_DELAY_MS")) {
+    mTargetDelay = std::chrono::milliseconds
+                   (strtoul(getenv("EOS_XRD_CONNECTION_POOL_TARGET_DELAY_MS"), 0, 10));
+  }
+
+  if (getenv("EOS_XRD_CONNECTION_POOL_IDLE_SEC")) {
+    mIdleTimeout = std::chrono::seconds
+                   (strtoul(getenv("EOS_XRD_CONNECTION_POOL_IDLE_SEC"), 0, 10));
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -74,18 +88,26 @@ XrdConnPool::AssignConnection(XrdCl::URL& url)
   uint32_t best_conn_id {1};
   uint32_t best_conn_val {std::numeric_limits<uint32_t>::max()};
   std::string target_host = url.GetHostName();
+  Clock::time_point now = Clock::now();
   std::unique_lock<std::mutex> scope_lock(mPoolMutex);
-  // Map of connection id and score for current host
-  auto& map_id_score = mConnPool[target_host];
+  // Connections and their usage for the current host
+  auto& ep = mConnPool[target_host];
+
+  if (ep.mLimit == 0) {
+    ep.mLimit = mMaxSize;
+  }
 
-  for (auto& elem : map_id_score) {
-    if (elem.second < best_conn_val) {
+  RemoveIdle(ep, now);
+  ++ep.mAssigned;
+
+  for (auto& elem : ep.mConns) {
+    if (elem.second.mInFlight < best_conn_val) {
       best_conn_id = elem.first;
-      best_conn_val = elem.second;
+      best_conn_val = elem.second.mInFlight;
     }
 
-    if (elem.second == 0) {
-      ++elem.second;
+    if (elem.second.mInFlight == 0) {
+      ++elem.second.mInFlight;
       conn_id = elem.first;
       found = true;
       break;
@@ -93,15 +115,38 @@ XrdConnPool::AssignConnection(XrdCl::URL& url)
   }
 
   if (!found) {
-    if (map_id_score.size() >= mMaxSize) {
+    if ((ep.mConns.size() >= ep.mLimit) && (ep.mLimit < sMaxPoolSize) &&
+        ShouldGrow(ep)) {
+      ++ep.mLimit;
+      ++ep.mGrown;
+      eos_info("msg=\"growing connection pool\" host=%s limit=%u "
+               "excl_latency_ms=%.0f shared_latency_ms=%.0f",
+               target_host.c_str(), ep.mLimit, ep.mExclLatency,
+               ep.mSharedLatency);
+    }
+
+    if (ep.mConns.size() >= ep.mLimit) {
       // Share the least busy connection
-      ++map_id_score[best_conn_id];
+      ++ep.mConns[best_conn_id].mInFlight;
+      ++ep.mShared;
       conn_id = best_conn_id;
       eos_warning("msg=\"connection pool limit reached - using %u/%u connections\"",
-                  map_id_score.size(), mMaxSize);
+                  ep.mConns.size(), ep.mLimit);
     } else {
-      conn_id = map_id_score.size() + 1;
-      map_id_score[conn_id] = 1;
+      // Use the smallest id not present in the pool
+      conn_id = 1;
+
+      for (const auto& elem : ep.mConns) {
+        if (elem.first != conn_id) {
+          break;
+        }
+
+        ++conn_id;
+      }
+
+      ConnInfo& info = ep.mConns[conn_id];
+      info.mInFlight = 1;
+      info.mLastUsed = now;
     }
   }
 
@@ -116,7 +161,7 @@ XrdConnPool::AssignConnection(XrdCl::URL& url)
 // Release a connection and update the status of the pool
 //------------------------------------------------------------------------------
 void
-XrdConnPool::ReleaseConnection(const XrdCl::URL& url)
+XrdConnPool::ReleaseConnection(const XrdCl::URL& url, int64_t latency_ms)
 {
   if (!mIsEnabled) {
     return;
@@ -131,17 +176,72 @@ XrdConnPool::ReleaseConnection(const XrdCl::URL& url)
   }
 
   if (conn_id) {
+    Clock::time_point now = Clock::now();
     std::unique_lock<std::mutex> scope_lock(mPoolMutex);
     auto it = mConnPool.find(url.GetHostName());
 
     if (it != mConnPool.end()) {
-      auto& map_id_score = it->second;
+      auto& ep = it->second;
+      auto it_conn = ep.mConns.find(conn_id);
+
+      if (it_conn != ep.mConns.end()) {
+        ConnInfo& info = it_conn->second;
+
+        if (latency_ms >= 0) {
+          // Exponential moving average of the request latency
+          double& avg = ((info.mInFlight > 1) ? ep.mSharedLatency :
+                         ep.mExclLatency);
+          avg = ((avg < 0) ? latency_ms : (0.8 * avg + 0.2 * latency_ms));
+        }
+
+        if (info.mInFlight >= 1) {
+          --info.mInFlight;
+        }
 
-      if (map_id_score[conn_id] >= 1) {
-        --map_id_score[conn_id];
+        info.mLastUsed = now;
       }
+
+      RemoveIdle(ep, now);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check if the endpoint is allowed to open one more connection
+//------------------------------------------------------------------------------
+bool
+XrdConnPool::ShouldGrow(const Endpoint& ep) const
+{
+  if ((ep.mExclLatency < 0) || (ep.mSharedLatency < 0)) {
+    return false;
+  }
+
+  return ((ep.mSharedLatency - ep.mExclLatency) > mTargetDelay.count());
+}
+
+//------------------------------------------------------------------------------
+// Remove the connections of an endpoint which are idle for too long
+//------------------------------------------------------------------------------
+void
+XrdConnPool::RemoveIdle(Endpoint& ep, Clock::time_point now)
+{
+  if (mIdleTimeout.count() == 0) {
+    return;
+  }
+
+  for (auto it = ep.mConns.begin(); it != ep.mConns.end(); /* no increment */) {
+    if ((it->second.mInFlight == 0) &&
+        (now - it->second.mLastUsed > mIdleTimeout)) {
+      it = ep.mConns.erase(it);
+      ++ep.mShrunk;
+    } else {
+      ++it;
     }
   }
+
+  if (ep.mLimit > mMaxSize) {
+    ep.mLimit = std::max(mMaxSize, (uint32_t) ep.mConns.size());
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -152,15 +252,49 @@ XrdConnPool::Dump(std::string& out) const
 {
   std::ostringstream oss;
   oss << "[connection-pool-dump]" << std::endl;
+  std::unique_lock<std::mutex> scope_lock(mPoolMutex);
 
   for (auto it = mConnPool.begin(); it != mConnPool.end(); ++it) {
-    for (auto fit = it->second.begin(); fit != it->second.end(); ++fit) {
+    const auto& ep = it->second;
+    oss << "[connection-pool] host=" << it->first << " limit=" << ep.mLimit
+        << " assigned=" << ep.mAssigned << " shared=" << ep.mShared
+        << " grown=" << ep.mGrown << " shrunk=" << ep.mShrunk
+        << " excl_latency_ms=" << ep.mExclLatency
+        << " shared_latency_ms=" << ep.mSharedLatency << std::endl;
+
+    for (auto fit = ep.mConns.begin(); fit != ep.mConns.end(); ++fit) {
       oss << "[connection-pool] host=" << it->first << " id="
-          << fit->first << " usage=" << fit->second << std::endl;
+          << fit->first << " usage=" << fit->second.mInFlight << std::endl;
     }
   }
 
   out = oss.str();
 }
 
+//------------------------------------------------------------------------------
+// Get the aggregated statistics of the connection pool
+//------------------------------------------------------------------------------
+XrdConnPool::Stats
+XrdConnPool::GetStats() const
+{
+  Stats stats;
+  std::unique_lock<std::mutex> scope_lock(mPoolMutex);
+  stats.mEndpoints = mConnPool.size();
+
+  for (const auto& elem : mConnPool) {
+    const auto& ep = elem.second;
+    stats.mConnections += ep.mConns.size();
+    stats.mAssigned += ep.mAssigned;
+    stats.mShared += ep.mShared;
+    stats.mGrown += ep.mGrown;
+    stats.mShrunk += ep.mShrunk;
+
+    for (const auto& conn : ep.mConns) {
+      stats.mInFlight += conn.second.mInFlight;
+    }
+  }
+
+  return stats;
+}
+
 EOSCOMMONNAMESPACE_END
@@ -25,6 +25,8 @@
 #include "common/Namespace.hh"
 #include "common/Logging.hh"
 #include "XrdCl/XrdClURL.hh"
+#include <chrono>
+#include <map>
 #include <mutex>
 
 EOSCOMMONNAMESPACE_BEGIN
@@ -32,10 +34,29 @@ EOSCOMMONNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 //! Class XrdConnPool help in creating a pool of xrootd connections that can
 //! be reused and allocated the least congested connection to a new request.
+//! The pool adapts per endpoint: when all the connections to an endpoint are
+//! busy and requests sharing a connection are slower than the ones using an
+//! exclusive connection by more than the target queueing delay, the
+//! endpoint is allowed to open more connections. Connections idle for longer
+//! than the idle timeout are dropped from the pool and the endpoint limit
+//! shrinks back to the configured size.
 //------------------------------------------------------------------------------
 class XrdConnPool: public eos::common::LogId
 {
 public:
+  //----------------------------------------------------------------------------
+  //! Aggregated statistics of the connection pool
+  //----------------------------------------------------------------------------
+  struct Stats {
+    uint64_t mEndpoints {0}; ///< Number of endpoints
+    uint64_t mConnections {0}; ///< Number of connections in the pool
+    uint64_t mInFlight {0}; ///< Number of requests using the connections
+    uint64_t mAssigned {0}; ///< Number of assignments
+    uint64_t mShared {0}; ///< Number of assignments to a busy connection
+    uint64_t mGrown {0}; ///< Number of connections added above the size
+    uint64_t mShrunk {0}; ///< Number of idle connections removed
+  };
+
   //----------------------------------------------------------------------------
   //! Constructor
   //!
@@ -64,8 +85,10 @@ public:
   //! Release a connection and update the status of the pool
   //!
   //! @param url given url
+  //! @param latency_ms duration of the request using the connection in
+  //!        milliseconds, negative if not known
   //----------------------------------------------------------------------------
-  void ReleaseConnection(const XrdCl::URL& url);
+  void ReleaseConnection(const XrdCl::URL& url, int64_t latency_ms = -1);
 
   //----------------------------------------------------------------------------
   //! Dump the status of the connection pool to the given string
@@ -74,11 +97,85 @@ public:
   //----------------------------------------------------------------------------
   void Dump(std::string& out) const;
 
+  //----------------------------------------------------------------------------
+  //! Get the aggregated statistics of the connection pool
+  //----------------------------------------------------------------------------
+  Stats GetStats() const;
+
+  //----------------------------------------------------------------------------
+  //! Set the target queueing delay above which an endpoint can grow
+  //!
+  //! @param delay target delay
+  //----------------------------------------------------------------------------
+  inline void SetTargetDelay(std::chrono::milliseconds delay)
+  {
+    std::unique_lock<std::mutex> scope_lock(mPoolMutex);
+    mTargetDelay = delay;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Set the timeout after which idle connections are removed
+  //!
+  //! @param timeout idle timeout
+  //----------------------------------------------------------------------------
+  inline void SetIdleTimeout(std::chrono::seconds timeout)
+  {
+    std::unique_lock<std::mutex> scope_lock(mPoolMutex);
+    mIdleTimeout = timeout;
+  }
+
+  //! Hard limit for the number of connections per endpoint
+  static constexpr uint32_t sMaxPoolSize = 1024;
+
 private:
+  using Clock = std::chrono::steady_clock;
+
+  //----------------------------------------------------------------------------
+  //! Status of a connection
+  //----------------------------------------------------------------------------
+  struct ConnInfo {
+    uint32_t mInFlight {0}; ///< Number of requests using the connection
+    Clock::time_point mLastUsed; ///< Last time the connection was released
+  };
+
+  //----------------------------------------------------------------------------
+  //! Status of an endpoint
+  //----------------------------------------------------------------------------
+  struct Endpoint {
+    std::map<uint32_t, ConnInfo> mConns; ///< Connections indexed by id
+    uint32_t mLimit {0}; ///< Current max number of connections
+    uint64_t mAssigned {0}; ///< Number of assignments
+    uint64_t mShared {0}; ///< Number of assignments to a busy connection
+    uint64_t mGrown {0}; ///< Number of connections added above the size
+    uint64_t mShrunk {0}; ///< Number of idle connections removed
+    double mExclLatency {-1}; ///< Avg latency with exclusive connection (ms)
+    double mSharedLatency {-1}; ///< Avg latency with shared connection (ms)
+  };
+
+  //----------------------------------------------------------------------------
+  //! Check if the endpoint is allowed to open one more connection
+  //!
+  //! @param ep endpoint
+  //!
+  //! @return true if the queueing delay exceeds the target
+  //----------------------------------------------------------------------------
+  bool ShouldGrow(const Endpoint& ep) const;
+
+  //----------------------------------------------------------------------------
+  //! Remove the connections of an endpoint which are idle for longer than
+  //! the idle timeout
+  //!
+  //! @param ep endpoint
+  //! @param now current time
+  //----------------------------------------------------------------------------
+  void RemoveIdle(Endpoint& ep, Clock::time_point now);
+
   bool mIsEnabled; ///< Mark if connection pool is enabled
-  uint32_t mMaxSize; ///< Maximum size of the connection pool
-  std::map<std::string, std::map<uint32_t, uint32_t>> mConnPool;
-  std::mutex mPoolMutex; ///< Mutex protecting access to the pool
+  uint32_t mMaxSize; ///< Configured size of the pool per endpoint
+  std::chrono::milliseconds mTargetDelay; ///< Target queueing delay
+  std::chrono::seconds mIdleTimeout; ///< Timeout for idle connections
+  std::map<std::string, Endpoint> mConnPool; ///< Endpoints indexed by host
+  mutable std::mutex mPoolMutex; ///< Mutex protecting access to the pool
 };
 
 //------------------------------------------------------------------------------
@@ -98,6 +195,7 @@ public:
   {
     mConnId = mPool.AssignConnection(url);
     mUrl = url;
+    mStart = std::chrono::steady_clock::now();
   }
 
   //----------------------------------------------------------------------------
@@ -106,7 +204,9 @@ public:
   ~XrdConnIdHelper()
   {
     if (mConnId) {
-      mPool.ReleaseConnection(mUrl);
+      mPool.ReleaseConnection(mUrl,
+                              std::chrono::duration_cast<std::chrono::milliseconds>
+                              (std::chrono::steady_clock::now() - mStart).count());
     }
   }
 
@@ -130,6 +230,7 @@ private:
   uint32_t mConnId; ///< Allocated connection id, 0 if none allocated
   XrdConnPool& mPool; ///< Reference to connection pool
   XrdCl::URL mUrl; ///< URL corresponding to the connection id
+  std::chrono::steady_clock::time_point mStart; ///< Time of the assignment
 };
 
 EOSCOMMONNAMESPACE_END
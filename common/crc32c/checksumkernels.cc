@@ -0,0 +1,467 @@
+// Runtime dispatched Adler-32 and CRC-32 kernels.
+//
+// The SSSE3 Adler-32 and the PCLMULQDQ CRC-32 kernels follow the approach
+// used by the Chromium zlib fork, see "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction" (Intel, 2009) for the folding
+// constants.
+
+#include "checksumkernels.h"
+#include "crc32c.h"
+#include <zlib.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+
+namespace checksum
+{
+
+static uint32_t adler32_CPUDetection(uint32_t adler, const void* data,
+                                     size_t length)
+{
+  ChecksumFunctionPtr best = detectBestAdler32();
+  adler32 = best;
+  return best(adler, data, length);
+}
+
+static uint32_t crc32_CPUDetection(uint32_t crc, const void* data,
+                                   size_t length)
+{
+  ChecksumFunctionPtr best = detectBestCRC32();
+  crc32 = best;
+  return best(crc, data, length);
+}
+
+ChecksumFunctionPtr adler32 = adler32_CPUDetection;
+ChecksumFunctionPtr crc32 = crc32_CPUDetection;
+
+//------------------------------------------------------------------------------
+// Generic implementations delegating to zlib
+//------------------------------------------------------------------------------
+uint32_t adler32Zlib(uint32_t adler, const void* data, size_t length)
+{
+  return ::adler32(adler, (const Bytef*) data, length);
+}
+
+uint32_t crc32Zlib(uint32_t crc, const void* data, size_t length)
+{
+  return ::crc32(crc, (const Bytef*) data, length);
+}
+
+#if defined(__x86_64__)
+
+// Largest n such that 255n(n+1)/2 + (n+1)(BASE-1) <= 2^32-1
+static const uint32_t kAdlerBase = 65521;
+static const uint32_t kAdlerNmax = 5552;
+
+//------------------------------------------------------------------------------
+// Finish the remaining bytes of an Adler-32 computation
+//------------------------------------------------------------------------------
+static inline uint32_t adler32Tail(uint32_t s1, uint32_t s2,
+                                   const unsigned char* buf, size_t length)
+{
+  while (length--) {
+    s1 += *buf++;
+    s2 += s1;
+  }
+
+  s1 %= kAdlerBase;
+  s2 %= kAdlerBase;
+  return s1 | (s2 << 16);
+}
+
+//------------------------------------------------------------------------------
+// Adler-32 using SSSE3 - processes blocks of 32 bytes
+//------------------------------------------------------------------------------
+__attribute__((target("ssse3")))
+uint32_t adler32Sse3(uint32_t adler, const void* data, size_t length)
+{
+  const unsigned char* buf = (const unsigned char*) data;
+  uint32_t s1 = adler & 0xffff;
+  uint32_t s2 = adler >> 16;
+  const size_t block_size = 32;
+  size_t blocks = length / block_size;
+  length -= blocks * block_size;
+  const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                     24, 23, 22, 21, 20, 19, 18, 17);
+  const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                     8, 7, 6, 5, 4, 3, 2, 1);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+
+  while (blocks) {
+    size_t n = kAdlerNmax / block_size;
+
+    if (n > blocks) {
+      n = blocks;
+    }
+
+    blocks -= n;
+    // v_ps accumulates the previous s1 values, each one of them contributes
+    // block_size times to s2
+    __m128i v_ps = _mm_set_epi32(0, 0, 0, s1 * n);
+    __m128i v_s2 = _mm_set_epi32(0, 0, 0, s2);
+    __m128i v_s1 = _mm_setzero_si128();
+
+    do {
+      const __m128i bytes1 = _mm_loadu_si128((const __m128i*) buf);
+      const __m128i bytes2 = _mm_loadu_si128((const __m128i*)(buf + 16));
+      v_ps = _mm_add_epi32(v_ps, v_s1);
+      v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+      const __m128i mad1 = _mm_maddubs_epi16(bytes1, tap1);
+      v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(mad1, ones));
+      v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+      const __m128i mad2 = _mm_maddubs_epi16(bytes2, tap2);
+      v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(mad2, ones));
+      buf += block_size;
+    } while (--n);
+
+    v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+    // Horizontal sum of the 32-bit lanes
+    v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+    v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+    s1 += _mm_cvtsi128_si32(v_s1);
+    v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+    v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+    s2 = _mm_cvtsi128_si32(v_s2);
+    s1 %= kAdlerBase;
+    s2 %= kAdlerBase;
+  }
+
+  return adler32Tail(s1, s2, buf, length);
+}
+
+//------------------------------------------------------------------------------
+// Adler-32 using AVX2 - same algorithm with one 32 byte load per block
+//------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+uint32_t adler32Avx2(uint32_t adler, const void* data, size_t length)
+{
+  const unsigned char* buf = (const unsigned char*) data;
+  uint32_t s1 = adler & 0xffff;
+  uint32_t s2 = adler >> 16;
+  const size_t block_size = 32;
+  size_t blocks = length / block_size;
+  length -= blocks * block_size;
+  const __m256i tap = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                       24, 23, 22, 21, 20, 19, 18, 17,
+                                       16, 15, 14, 13, 12, 11, 10, 9,
+                                       8, 7, 6, 5, 4, 3, 2, 1);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi16(1);
+
+  while (blocks) {
+    size_t n = kAdlerNmax / block_size;
+
+    if (n > blocks) {
+      n = blocks;
+    }
+
+    blocks -= n;
+    __m256i v_ps = _mm256_setzero_si256();
+    __m256i v_s2 = _mm256_setzero_si256();
+    __m256i v_s1 = _mm256_setzero_si256();
+    uint32_t ps = s1 * n;
+
+    do {
+      const __m256i bytes = _mm256_loadu_si256((const __m256i*) buf);
+      v_ps = _mm256_add_epi32(v_ps, v_s1);
+      v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes, zero));
+      const __m256i mad = _mm256_maddubs_epi16(bytes, tap);
+      v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(mad, ones));
+      buf += block_size;
+    } while (--n);
+
+    v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 5));
+    // Horizontal sum of the 32-bit lanes
+    __m128i sum1 = _mm_add_epi32(_mm256_castsi256_si128(v_s1),
+                                 _mm256_extracti128_si256(v_s1, 1));
+    __m128i sum2 = _mm_add_epi32(_mm256_castsi256_si128(v_s2),
+                                 _mm256_extracti128_si256(v_s2, 1));
+    sum1 = _mm_add_epi32(sum1, _mm_shuffle_epi32(sum1, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum1 = _mm_add_epi32(sum1, _mm_shuffle_epi32(sum1, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum2 = _mm_add_epi32(sum2, _mm_shuffle_epi32(sum2, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum2 = _mm_add_epi32(sum2, _mm_shuffle_epi32(sum2, _MM_SHUFFLE(1, 0, 3, 2)));
+    s2 += (ps << 5) + (uint32_t) _mm_cvtsi128_si32(sum2);
+    s1 += (uint32_t) _mm_cvtsi128_si32(sum1);
+    s1 %= kAdlerBase;
+    s2 %= kAdlerBase;
+  }
+
+  return adler32Tail(s1, s2, buf, length);
+}
+
+//------------------------------------------------------------------------------
+// CRC-32 (IEEE) using carry-less multiplication, the bulk of the data is
+// folded with PCLMULQDQ in blocks of 64 bytes and the tail is handled by zlib
+//------------------------------------------------------------------------------
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32PclmulFold(const unsigned char* buf, size_t len,
+                                uint32_t crc)
+{
+  alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+  alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+  alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+  alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+  // There is at least one block of 64 bytes
+  x1 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+  x2 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+  x3 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+  x4 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+  x0 = _mm_load_si128((const __m128i*) k1k2);
+  buf += 64;
+  len -= 64;
+
+  // Parallel fold blocks of 64 bytes
+  while (len >= 64) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+    y5 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+    y6 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+    y7 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+    y8 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+    buf += 64;
+    len -= 64;
+  }
+
+  // Fold into 128 bits
+  x0 = _mm_load_si128((const __m128i*) k3k4);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  // Single fold blocks of 16 bytes
+  while (len >= 16) {
+    x2 = _mm_loadu_si128((const __m128i*) buf);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    buf += 16;
+    len -= 16;
+  }
+
+  // Fold 128 bits to 64 bits
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_srli_si128(x1, 8);
+  x1 = _mm_xor_si128(x1, x2);
+  x0 = _mm_loadl_epi64((const __m128i*) k5k0);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  // Barrett reduction to 32 bits
+  x0 = _mm_load_si128((const __m128i*) poly);
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return _mm_extract_epi32(x1, 1);
+}
+
+uint32_t crc32Pclmul(uint32_t crc, const void* data, size_t length)
+{
+  const unsigned char* buf = (const unsigned char*) data;
+
+  if (length >= 64) {
+    size_t chunk = length & ~((size_t) 15);
+    crc = ~crc32PclmulFold(buf, chunk, ~crc);
+    buf += chunk;
+    length -= chunk;
+  }
+
+  if (length) {
+    crc = ::crc32(crc, (const Bytef*) buf, length);
+  }
+
+  return crc;
+}
+
+uint32_t crc32Armv8(uint32_t crc, const void* data, size_t length)
+{
+  return crc32Zlib(crc, data, length);
+}
+
+#elif defined(__aarch64__)
+
+uint32_t adler32Sse3(uint32_t adler, const void* data, size_t length)
+{
+  return adler32Zlib(adler, data, length);
+}
+
+uint32_t adler32Avx2(uint32_t adler, const void* data, size_t length)
+{
+  return adler32Zlib(adler, data, length);
+}
+
+uint32_t crc32Pclmul(uint32_t crc, const void* data, size_t length)
+{
+  return crc32Zlib(crc, data, length);
+}
+
+//------------------------------------------------------------------------------
+// CRC-32 (IEEE) using the ARMv8 CRC32 instructions
+//------------------------------------------------------------------------------
+__attribute__((target("+crc")))
+uint32_t crc32Armv8(uint32_t crc, const void* data, size_t length)
+{
+  const unsigned char* buf = (const unsigned char*) data;
+  crc = ~crc;
+
+  while (length && ((uintptr_t) buf & 7)) {
+    crc = __crc32b(crc, *buf++);
+    --length;
+  }
+
+  while (length >= 8) {
+    crc = __crc32d(crc, *(const uint64_t*) buf);
+    buf += 8;
+    length -= 8;
+  }
+
+  while (length--) {
+    crc = __crc32b(crc, *buf++);
+  }
+
+  return ~crc;
+}
+
+#else
+
+uint32_t adler32Sse3(uint32_t adler, const void* data, size_t length)
+{
+  return adler32Zlib(adler, data, length);
+}
+
+uint32_t adler32Avx2(uint32_t adler, const void* data, size_t length)
+{
+  return adler32Zlib(adler, data, length);
+}
+
+uint32_t crc32Pclmul(uint32_t crc, const void* data, size_t length)
+{
+  return crc32Zlib(crc, data, length);
+}
+
+uint32_t crc32Armv8(uint32_t crc, const void* data, size_t length)
+{
+  return crc32Zlib(crc, data, length);
+}
+
+#endif
+
+//------------------------------------------------------------------------------
+// Kernels supported by the running CPU, best one first
+//------------------------------------------------------------------------------
+const ChecksumKernel* adler32Kernels()
+{
+  static ChecksumKernel kernels[4];
+  static bool initialized = ([]() {
+    int i = 0;
+#if defined(__x86_64__)
+
+    if (__builtin_cpu_supports("avx2")) {
+      kernels[i++] = { "avx2", adler32Avx2 };
+    }
+
+    if (__builtin_cpu_supports("ssse3")) {
+      kernels[i++] = { "ssse3", adler32Sse3 };
+    }
+
+#endif
+    kernels[i++] = { "zlib", adler32Zlib };
+    kernels[i] = { nullptr, nullptr };
+    return true;
+  })();
+  (void) initialized;
+  return kernels;
+}
+
+const ChecksumKernel* crc32Kernels()
+{
+  static ChecksumKernel kernels[3];
+  static bool initialized = ([]() {
+    int i = 0;
+#if defined(__x86_64__)
+
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1")) {
+      kernels[i++] = { "pclmul", crc32Pclmul };
+    }
+
+#elif defined(__aarch64__)
+
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+      kernels[i++] = { "armv8", crc32Armv8 };
+    }
+
+#endif
+    kernels[i++] = { "zlib", crc32Zlib };
+    kernels[i] = { nullptr, nullptr };
+    return true;
+  })();
+  (void) initialized;
+  return kernels;
+}
+
+const ChecksumKernel* crc32cKernels()
+{
+  static ChecksumKernel kernels[4];
+  static bool initialized = ([]() {
+    int i = 0;
+#if defined(__x86_64__)
+
+    if (__builtin_cpu_supports("sse4.2")) {
+      kernels[i++] = { "sse42", crc32cHardware64 };
+    }
+
+#elif defined(__aarch64__)
+
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+      kernels[i++] = { "armv8", crc32cArmv8 };
+    }
+
+#endif
+    kernels[i++] = { "slicing8", crc32cSlicingBy8 };
+    kernels[i] = { nullptr, nullptr };
+    return true;
+  })();
+  (void) initialized;
+  return kernels;
+}
+
+ChecksumFunctionPtr detectBestAdler32()
+{
+  return adler32Kernels()[0].function;
+}
+
+ChecksumFunctionPtr detectBestCRC32()
+{
+  return crc32Kernels()[0].function;
+}
+
+}  // namespace checksum
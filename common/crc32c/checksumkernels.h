@@ -0,0 +1,50 @@
+// Runtime dispatched Adler-32 and CRC-32 kernels. These complement the
+// CRC32-C implementations in crc32c.h and follow the same conventions: the
+// best implementation for the running CPU is selected on the first call.
+
+#ifndef LOGGING_CHECKSUMKERNELS_H__
+#define LOGGING_CHECKSUMKERNELS_H__
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace checksum
+{
+
+/** Pointer to a function that updates a checksum with the given data.
+@arg value Previous checksum value with the same semantics as the zlib
+     adler32/crc32 functions i.e. 1 for an empty adler32 and 0 for crc32.
+@arg data Pointer to the data to be checksummed.
+@arg length length of the data in bytes.
+*/
+typedef uint32_t (*ChecksumFunctionPtr)(uint32_t value, const void* data,
+                                        size_t length);
+
+/** Description of an available checksum kernel. */
+struct ChecksumKernel {
+  const char* name;
+  ChecksumFunctionPtr function;
+};
+
+/** These will map automatically to the "best" implementation. */
+extern ChecksumFunctionPtr adler32;
+extern ChecksumFunctionPtr crc32;
+
+ChecksumFunctionPtr detectBestAdler32();
+ChecksumFunctionPtr detectBestCRC32();
+
+/** Return the kernels supported by the running CPU, terminated by an entry
+with a null name. Mostly useful for testing and benchmarking. */
+const ChecksumKernel* adler32Kernels();
+const ChecksumKernel* crc32Kernels();
+const ChecksumKernel* crc32cKernels();
+
+uint32_t adler32Zlib(uint32_t adler, const void* data, size_t length);
+uint32_t adler32Sse3(uint32_t adler, const void* data, size_t length);
+uint32_t adler32Avx2(uint32_t adler, const void* data, size_t length);
+uint32_t crc32Zlib(uint32_t crc, const void* data, size_t length);
+uint32_t crc32Pclmul(uint32_t crc, const void* data, size_t length);
+uint32_t crc32Armv8(uint32_t crc, const void* data, size_t length);
+
+}  // namespace checksum
+#endif
@@ -9,6 +9,14 @@
 #include "crc32c.h"
 #include "crc32ctables.h"
 
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+
 #undef __PIC__
 
 namespace checksum
@@ -25,6 +33,7 @@ static uint32_t crc32c_CPUDetection(uint32_t crc, const void* data,
 
 CRC32CFunctionPtr crc32c = crc32c_CPUDetection;
 
+#if defined(__x86_64__) || defined(__i386__)
 static uint32_t cpuid(uint32_t functionInput)
 {
   uint32_t ecx;
@@ -84,6 +93,21 @@ CRC32CFunctionPtr detectBestCRC32C()
     return crc32cSlicingBy8;
   }
 }
+#elif defined(__aarch64__)
+CRC32CFunctionPtr detectBestCRC32C()
+{
+  if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+    return crc32cArmv8;
+  }
+
+  return crc32cSlicingBy8;
+}
+#else
+CRC32CFunctionPtr detectBestCRC32C()
+{
+  return crc32cSlicingBy8;
+}
+#endif
 
 // Implementations adapted from Intel's Slicing By 8 Sourceforge Project
 // http://sourceforge.net/projects/slicing-by-8/
@@ -190,6 +214,7 @@ uint32_t crc32cSlicingBy8(uint32_t crc, const void* data, size_t length)
   return crc;
 }
 
+#if defined(__x86_64__) || defined(__i386__)
 // Hardware-accelerated CRC-32C (using CRC32 instruction)
 uint32_t crc32cHardware32(uint32_t crc, const void* data, size_t length)
 {
@@ -297,5 +322,123 @@ uint32_t crc32cHardware64(uint32_t crc, const void* data, size_t length)
   return crc32bit;
 #endif
 }
+#else
+uint32_t crc32cHardware32(uint32_t crc, const void* data, size_t length)
+{
+  return crc32cSlicingBy8(crc, data, length);
+}
+
+uint32_t crc32cHardware64(uint32_t crc, const void* data, size_t length)
+{
+  return crc32cSlicingBy8(crc, data, length);
+}
+#endif
+
+#if defined(__aarch64__)
+// Hardware-accelerated CRC-32C using the ARMv8 CRC32 instructions
+__attribute__((target("+crc")))
+uint32_t crc32cArmv8(uint32_t crc, const void* data, size_t length)
+{
+  const unsigned char* p_buf = (const unsigned char*) data;
+
+  while (length && ((uintptr_t) p_buf & 7)) {
+    crc = __crc32cb(crc, *p_buf++);
+    --length;
+  }
+
+  while (length >= 8) {
+    crc = __crc32cd(crc, *(const uint64_t*) p_buf);
+    p_buf += 8;
+    length -= 8;
+  }
+
+  while (length--) {
+    crc = __crc32cb(crc, *p_buf++);
+  }
+
+  return crc;
+}
+#else
+uint32_t crc32cArmv8(uint32_t crc, const void* data, size_t length)
+{
+  return crc32cSlicingBy8(crc, data, length);
+}
+#endif
+
+// Multiplies a vector by a 32x32 matrix over GF(2)
+static uint32_t gf2MatrixTimes(const uint32_t* mat, uint32_t vec)
+{
+  uint32_t sum = 0;
+
+  while (vec) {
+    if (vec & 1) {
+      sum ^= *mat;
+    }
+
+    vec >>= 1;
+    mat++;
+  }
+
+  return sum;
+}
+
+static void gf2MatrixSquare(uint32_t* square, const uint32_t* mat)
+{
+  for (int n = 0; n < 32; n++) {
+    square[n] = gf2MatrixTimes(mat, mat[n]);
+  }
+}
+
+// Same algorithm as zlib's crc32_combine with the CRC32-C polynomial: the
+// first CRC is shifted over length2 zero bytes by repeated squaring of the
+// one zero bit operator.
+uint32_t crc32cCombine(uint32_t crc1, uint32_t crc2, uint64_t length2)
+{
+  uint32_t even[32];
+  uint32_t odd[32];
+
+  if (length2 == 0) {
+    return crc1;
+  }
+
+  // Operator for one zero bit in odd
+  odd[0] = 0x82F63B78;
+  uint32_t row = 1;
+
+  for (int n = 1; n < 32; n++) {
+    odd[n] = row;
+    row <<= 1;
+  }
+
+  // Operators for two and four zero bits
+  gf2MatrixSquare(even, odd);
+  gf2MatrixSquare(odd, even);
+
+  // Apply length2 zero bytes to crc1, the first square gives the operator
+  // for one zero byte
+  do {
+    gf2MatrixSquare(even, odd);
+
+    if (length2 & 1) {
+      crc1 = gf2MatrixTimes(even, crc1);
+    }
+
+    length2 >>= 1;
+
+    if (length2 == 0) {
+      break;
+    }
+
+    gf2MatrixSquare(odd, even);
+
+    if (length2 & 1) {
+      crc1 = gf2MatrixTimes(odd, crc1);
+    }
+
+    length2 >>= 1;
+  } while (length2);
+
+  return crc1 ^ crc2;
+}
 
 }  // namespace checksum
@@ -41,6 +41,15 @@ uint32_t crc32cSlicingBy4(uint32_t crc, const void* data, size_t length);
 uint32_t crc32cSlicingBy8(uint32_t crc, const void* data, size_t length);
 uint32_t crc32cHardware32(uint32_t crc, const void* data, size_t length);
 uint32_t crc32cHardware64(uint32_t crc, const void* data, size_t length);
+uint32_t crc32cArmv8(uint32_t crc, const void* data, size_t length);
+
+/** Combines the final CRC32-C values of two consecutive blocks.
+@arg crc1 Final CRC32-C value of the first block.
+@arg crc2 Final CRC32-C value of the second block.
+@arg length2 length of the second block in bytes.
+@return Final CRC32-C value of both blocks.
+*/
+uint32_t crc32cCombine(uint32_t crc1, uint32_t crc2, uint64_t length2);
 
 }  // namespace checksum
 #endif
@@ -24,6 +24,7 @@
 #include "common/http/HttpServer.hh"
 #include "common/http/PlainHttpResponse.hh"
 #include "common/Logging.hh"
+#include "common/Metrics.hh"
 #include "common/StringConversion.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdSys/XrdSysLogger.hh"
@@ -31,9 +32,12 @@
 #include "XrdNet/XrdNet.hh"
 #include "XrdNet/XrdNetBuffer.hh"
 #include "XrdNet/XrdNetPeer.hh"
+#include <condition_variable>
+#include <cstring>
 #include <string>
 #include <map>
 #include <sstream>
+#include <vector>
 
 EOSCOMMONNAMESPACE_BEGIN
 
@@ -41,8 +45,174 @@ EOSCOMMONNAMESPACE_BEGIN
 #define MHD_USE_EPOLL_LINUX_ONLY 512
 #endif
 
+// Suspending connections with internal select threads and queueing responses
+// on suspended connections from other threads needs a recent libmicrohttpd
+#if MHD_VERSION >= 0x00095200
+#define EOS_MHD_SUSPEND_RESUME
+#endif
+
 HttpServer* HttpServer::gHttp; //!< Global HTTP server
 
+#ifdef EOS_MICRO_HTTPD
+thread_local HttpServer::AsyncConnection* HttpServer::sCurrentConnection =
+  nullptr;
+
+//------------------------------------------------------------------------------
+//! Request state in event mode, wraps the state the derived handler keeps in
+//! *ptr. The connection is suspended while a worker runs the handler, so the
+//! handler calls of one request never overlap.
+//------------------------------------------------------------------------------
+struct HttpServer::AsyncConnection {
+  void* mHandlerState {nullptr}; //!< *ptr of the derived handler
+  std::string mUpload; //!< Upload data handed over to the worker
+  int mResult {MHD_YES}; //!< Result of the last handler call on a worker
+  std::shared_ptr<AsyncReader> mReader; //!< Reader of the response body
+};
+
+//------------------------------------------------------------------------------
+//! Reader producing the body of a response on the worker pool. One block is
+//! read ahead while the previous one is sent, the connection is suspended
+//! only if the client is faster than the storage.
+//------------------------------------------------------------------------------
+class HttpServer::AsyncReader
+{
+public:
+  AsyncReader(HttpServer* server, struct MHD_Connection* connection,
+              MHD_ContentReaderCallback crc, void* crc_cls, size_t block_size):
+    mServer(server), mConnection(connection), mCrc(crc), mCrcCls(crc_cls),
+    mData(block_size), mFill(block_size)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Copy the next part of the body, called by the I/O thread
+  //----------------------------------------------------------------------------
+  ssize_t Read(char* buf, size_t max)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    while (true) {
+      if (mDataOff < mDataLen) {
+        size_t len = std::min(max, mDataLen - mDataOff);
+        memcpy(buf, mData.data() + mDataOff, len);
+        mDataOff += len;
+        StartFill();
+        return len;
+      }
+
+      if (mDone) {
+        return mEnd;
+      }
+
+      if (mPending) {
+        // Resumed by the worker once the block is there
+        mSuspended = true;
+        MHD_suspend_connection(mConnection);
+        return 0;
+      }
+
+      if (mFillReady) {
+        mFillReady = false;
+        std::swap(mData, mFill);
+        mDataOff = 0;
+        mDataLen = 0;
+
+        if (mFillResult <= 0) {
+          mDone = true;
+          mEnd = mFillResult;
+        } else {
+          mDataLen = mFillResult;
+        }
+
+        continue;
+      }
+
+      if (!StartFill()) {
+        return MHD_CONTENT_READER_END_WITH_ERROR;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Wait until no block is being read, must be called before the state used
+  //! by the reader callback is released
+  //----------------------------------------------------------------------------
+  void WaitIdle()
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdleCv.wait(lock, [this] { return !mPending; });
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Start reading the next block unless already done, called under mMutex
+  //!
+  //! @return false if the worker pool does not accept jobs anymore
+  //----------------------------------------------------------------------------
+  bool StartFill()
+  {
+    if (mPending || mFillReady || mDone) {
+      return true;
+    }
+
+    mPending = mServer->Offload([this]() {
+      Fill();
+    });
+    return mPending;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Read the next block, called by a worker
+  //----------------------------------------------------------------------------
+  void Fill()
+  {
+    // Only this job touches mFill and mNextPos while mPending is set
+    ssize_t ret = mCrc(mCrcCls, mNextPos, mFill.data(), mFill.size());
+    struct MHD_Connection* connection = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+
+      if (ret > 0) {
+        mNextPos += ret;
+      }
+
+      mFillResult = ret;
+      mFillReady = true;
+      mPending = false;
+
+      if (mSuspended) {
+        mSuspended = false;
+        connection = mConnection;
+      }
+
+      mIdleCv.notify_all();
+    }
+
+    // The reader may be gone once the connection is resumed
+    if (connection) {
+      MHD_resume_connection(connection);
+    }
+  }
+
+  HttpServer* mServer;
+  struct MHD_Connection* mConnection;
+  MHD_ContentReaderCallback mCrc;
+  void* mCrcCls;
+  std::mutex mMutex;
+  std::condition_variable mIdleCv;
+  std::vector<char> mData; //!< Block served to the client
+  size_t mDataOff {0};
+  size_t mDataLen {0};
+  std::vector<char> mFill; //!< Block read by the worker
+  ssize_t mFillResult {0};
+  uint64_t mNextPos {0}; //!< Body offset of the next block to read
+  bool mFillReady {false};
+  bool mPending {false}; //!< A worker is reading into mFill
+  bool mSuspended {false}; //!< Connection waits for the pending block
+  bool mDone {false}; //!< The callback signalled the end of the body
+  ssize_t mEnd {0}; //!< Last value returned by the callback
+};
+#endif
+
 /*----------------------------------------------------------------------------*/
 HttpServer::HttpServer(int port)
 {
@@ -52,6 +222,8 @@ HttpServer::HttpServer(int port)
 #endif
   mPort = port;
   mRunning = false;
+  mEventMode = false;
+  mWorkersStopped = false;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -94,6 +266,16 @@ HttpServer::Run(ThreadAssistant& assistant) noexcept
       }
     }
 
+#ifndef EOS_MHD_SUSPEND_RESUME
+
+    if (thread_model == "event") {
+      eos_static_warning("msg=\"libmicrohttpd too old for the event mode, "
+                         "using epoll\"");
+      thread_model = "epoll";
+    }
+
+#endif
+
     if (thread_model == "threads") {
       eos_static_notice("msg=\"starting http server\" mode=\"thread-per-connection\"");
       mDaemon = MHD_start_daemon(MHD_USE_DEBUG |  MHD_USE_THREAD_PER_CONNECTION |
@@ -135,6 +317,50 @@ HttpServer::Run(ThreadAssistant& assistant) noexcept
                                    getenv("EOS_HTTP_CONNECTION_TIMEOUT")) : 128,
                                  MHD_OPTION_END
                                 );
+#ifdef EOS_MHD_SUSPEND_RESUME
+    } else if (thread_model == "event") {
+      // A few I/O threads drive the connections, the handlers and the file
+      // reads run on the worker pool while the connection is suspended
+      int nio = 4;
+
+      if (getenv("EOS_HTTP_IO_THREADS")) {
+        nio = atoi(getenv("EOS_HTTP_IO_THREADS"));
+
+        if (nio < 1) {
+          nio = 4;
+        }
+
+        if (nio > 64) {
+          nio = 64;
+        }
+      }
+
+      eos_static_notice("msg=\"starting http server\" mode=\"event\" "
+                        "io-threads=%d workers=%d", nio, nthreads);
+      mWorkers.reset(new ThreadPool(std::max(nthreads / 4, 1), nthreads, 10, 12,
+                                    10, "http"));
+      mEventMode = true;
+      mDaemon = MHD_start_daemon(MHD_USE_DEBUG |  MHD_USE_SELECT_INTERNALLY |
+                                 MHD_USE_DUAL_STACK |
+                                 MHD_USE_EPOLL_LINUX_ONLY |
+                                 MHD_USE_SUSPEND_RESUME,
+                                 mPort,
+                                 NULL,
+                                 NULL,
+                                 &HttpServer::StaticHandler,
+                                 (void*) 0,
+                                 MHD_OPTION_THREAD_POOL_SIZE,
+                                 nio,
+                                 MHD_OPTION_NOTIFY_COMPLETED, &HttpServer::StaticCompleteHandler, NULL,
+                                 MHD_OPTION_CONNECTION_MEMORY_LIMIT,
+                                 getenv("EOS_HTTP_CONNECTION_MEMORY_LIMIT") ? atoi(
+                                   getenv("EOS_HTTP_CONNECTION_MEMORY_LIMIT")) : (128 * 1024 * 1024),
+                                 MHD_OPTION_CONNECTION_TIMEOUT,
+                                 getenv("EOS_HTTP_CONNECTION_TIMEOUT") ? atoi(
+                                   getenv("EOS_HTTP_CONNECTION_TIMEOUT")) : 128,
+                                 MHD_OPTION_END
+                                );
+#endif
     } else {
       eos_static_notice("msg=\"starting http server\" mode=\"single-threaded\"");
       mDaemon = MHD_start_daemon(MHD_USE_DEBUG | MHD_USE_DUAL_STACK,
@@ -152,6 +378,7 @@ HttpServer::Run(ThreadAssistant& assistant) noexcept
   }
 
   if (!mDaemon) {
+    StopWorkers();
     mRunning = false;
     eos_static_warning("msg=\"start of micro httpd failed [port=%d]\"", mPort);
     return;
@@ -167,7 +394,8 @@ HttpServer::Run(ThreadAssistant& assistant) noexcept
   unsigned MHD_LONG_LONG mhd_timeout;
   struct timeval tv;
 
-  if ((thread_model == "epoll") || (thread_model == "threads")) {
+  if ((thread_model == "epoll") || (thread_model == "threads") ||
+      (thread_model == "event")) {
     while (!assistant.terminationRequested()) {
       assistant.wait_for(std::chrono::seconds(30));
     }
@@ -196,6 +424,8 @@ HttpServer::Run(ThreadAssistant& assistant) noexcept
     }
   }
 
+  // Finish the jobs first, they resume the connections they suspended
+  StopWorkers();
   MHD_stop_daemon(mDaemon);
 #endif
 }
@@ -228,7 +458,21 @@ HttpServer::StaticHandler(void* cls,
                           size_t* upload_data_size,
                           void** ptr)
 {
+  static const bool metrics = getenv("EOS_HTTP_METRICS") &&
+                              atoi(getenv("EOS_HTTP_METRICS"));
+
+  // The metrics are served inline, without authentication nor protocol handler
+  if (metrics && url && method && !strcmp(url, "/metrics") &&
+      !strcmp(method, "GET")) {
+    return ServeMetrics(connection);
+  }
+
   // The static handler function calls back the original http object
+  if (gHttp && gHttp->mEventMode) {
+    return gHttp->AsyncHandler(cls, connection, url, method, version,
+                               upload_data, upload_data_size, ptr);
+  }
+
   if (gHttp) {
     return gHttp->Handler(cls,
                           connection,
@@ -243,6 +487,26 @@ HttpServer::StaticHandler(void* cls,
   }
 }
 
+/*----------------------------------------------------------------------------*/
+int
+HttpServer::ServeMetrics(struct MHD_Connection* connection)
+{
+  std::string body = MetricsRegistry::Instance().Expose();
+  struct MHD_Response* response =
+    MHD_create_response_from_buffer(body.size(), (void*) body.c_str(),
+                                    MHD_RESPMEM_MUST_COPY);
+
+  if (!response) {
+    return MHD_NO;
+  }
+
+  MHD_add_response_header(response, "Content-Type",
+                          "text/plain; version=0.0.4; charset=utf-8");
+  int ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+  MHD_destroy_response(response);
+  return ret;
+}
+
 /*----------------------------------------------------------------------------*/
 void
 HttpServer::StaticCompleteHandler(void* cls,
@@ -251,6 +515,20 @@ HttpServer::StaticCompleteHandler(void* cls,
                                   enum MHD_RequestTerminationCode toe)
 {
   // The static handler function calls back the original http object
+  if (gHttp && gHttp->mEventMode && con_cls && *con_cls) {
+    AsyncConnection* conn = static_cast<AsyncConnection*>(*con_cls);
+
+    // A block may still be read ahead from the file of the handler
+    if (conn->mReader) {
+      conn->mReader->WaitIdle();
+    }
+
+    gHttp->CompleteHandler(cls, connection, &conn->mHandlerState, toe);
+    delete conn;
+    *con_cls = nullptr;
+    return;
+  }
+
   if (gHttp) {
     gHttp->CompleteHandler(cls, connection, con_cls, toe);
   }
@@ -258,6 +536,152 @@ HttpServer::StaticCompleteHandler(void* cls,
   return;
 }
 
+/*----------------------------------------------------------------------------*/
+int
+HttpServer::AsyncHandler(void* cls,
+                         struct MHD_Connection* connection,
+                         const char* url,
+                         const char* method,
+                         const char* version,
+                         const char* upload_data,
+                         size_t* upload_data_size,
+                         void** ptr)
+{
+  AsyncConnection* conn = static_cast<AsyncConnection*>(*ptr);
+
+  if (!conn) {
+    conn = new AsyncConnection();
+    *ptr = conn;
+  }
+
+  // The call run by the worker before the connection was resumed failed
+  if (conn->mResult != MHD_YES) {
+    return conn->mResult;
+  }
+
+  // Upload data is consumed right away, the next chunk is only delivered
+  // once the worker has handed it to the handler and resumed the connection
+  if (*upload_data_size) {
+    conn->mUpload.assign(upload_data, *upload_data_size);
+    *upload_data_size = 0;
+  }
+
+  auto job = [this, conn, cls, connection, url, method, version]() {
+    const char* data = conn->mUpload.c_str();
+    size_t left = conn->mUpload.size();
+    int ret = MHD_YES;
+    sCurrentConnection = conn;
+
+    // Same contract as with libmicrohttpd, call again until the handler
+    // consumed all the data given to it
+    do {
+      size_t size = left;
+      ret = Handler(cls, connection, url, method, version, data, &size,
+                    &conn->mHandlerState);
+
+      if (left && (size >= left) && (ret == MHD_YES)) {
+        eos_static_err("msg=\"handler did not consume the upload data\" "
+                       "url=\"%s\"", url);
+        ret = MHD_NO;
+      }
+
+      data += left - size;
+      left = size;
+    } while ((ret == MHD_YES) && left);
+
+    sCurrentConnection = nullptr;
+    conn->mUpload.clear();
+    conn->mResult = ret;
+    // The request may be completed and conn deleted once resumed
+    MHD_resume_connection(connection);
+  };
+  MHD_suspend_connection(connection);
+
+  if (!Offload(job)) {
+    // Shutting down, run the handler in place
+    job();
+  }
+
+  return MHD_YES;
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+HttpServer::Offload(std::function<void()> job)
+{
+  std::lock_guard<std::mutex> lock(mWorkersMutex);
+
+  if (mWorkersStopped || !mWorkers) {
+    return false;
+  }
+
+  mWorkers->PushTask<void>(std::move(job));
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+void
+HttpServer::StopWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(mWorkersMutex);
+    mWorkersStopped = true;
+  }
+
+  if (mWorkers) {
+    mWorkers->Stop();
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+struct MHD_Response*
+HttpServer::CreateResponseFromCallback(struct MHD_Connection* connection,
+                                       uint64_t size,
+                                       size_t block_size,
+                                       MHD_ContentReaderCallback crc,
+                                       void* crc_cls)
+{
+  AsyncConnection* conn = sCurrentConnection;
+
+  if (!mEventMode || !conn) {
+    return MHD_create_response_from_callback(size, block_size, crc, crc_cls, 0);
+  }
+
+  conn->mReader = std::make_shared<AsyncReader>(this, connection, crc, crc_cls,
+                  block_size);
+  auto* holder = new std::shared_ptr<AsyncReader>(conn->mReader);
+  struct MHD_Response* response =
+    MHD_create_response_from_callback(size, block_size,
+                                      &HttpServer::AsyncReaderCallback,
+                                      holder, &HttpServer::AsyncReaderFree);
+
+  if (!response) {
+    delete holder;
+    conn->mReader.reset();
+  }
+
+  return response;
+}
+
+/*----------------------------------------------------------------------------*/
+ssize_t
+HttpServer::AsyncReaderCallback(void* cls, uint64_t pos, char* buf,
+                                size_t max)
+{
+  // The body is read sequentially, the reader keeps track of the position
+  auto* holder = static_cast<std::shared_ptr<AsyncReader>*>(cls);
+  return (*holder)->Read(buf, max);
+}
+
+/*----------------------------------------------------------------------------*/
+void
+HttpServer::AsyncReaderFree(void* cls)
+{
+  auto* holder = static_cast<std::shared_ptr<AsyncReader>*>(cls);
+  (*holder)->WaitIdle();
+  delete holder;
+}
+
 /*----------------------------------------------------------------------------*/
 int
 HttpServer::BuildHeaderMap(void* cls,
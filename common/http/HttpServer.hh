@@ -35,6 +35,9 @@
 #include "common/http/HttpResponse.hh"
 #include "common/AssistedThread.hh"
 #include "common/Namespace.hh"
+#include "common/ThreadPool.hh"
+#include <memory>
+#include <mutex>
 #include <string>
 #include <iostream>
 
@@ -57,6 +60,10 @@ protected:
   static HttpServer* gHttp;     //!< This is the instance of the HTTP server
   //!< allowing the Handler function to call
   //!< class member functions
+  bool               mEventMode; //!< Handlers run on the worker pool
+  std::unique_ptr<ThreadPool> mWorkers; //!< Worker pool in event mode
+  std::mutex         mWorkersMutex; //!< Protects the submission to mWorkers
+  bool               mWorkersStopped; //!< No more jobs accepted by mWorkers
 
   static std::string to_string(unsigned long long num)
   {
@@ -181,6 +188,27 @@ public:
   DecodeURI(std::string& cgi);
 
 #ifdef EOS_MICRO_HTTPD
+  /**
+   * Create a response whose body is produced by the given reader callback.
+   * In event mode the callback runs on the worker pool one block ahead of
+   * the client and the connection is suspended while no data is ready, so
+   * that slow storage or slow clients do not block the I/O threads.
+   *
+   * @param connection  connection the response is queued on
+   * @param size        size of the body
+   * @param block_size  max size of one block returned by the callback
+   * @param crc         reader callback
+   * @param crc_cls     argument of the reader callback
+   *
+   * @return MHD response object or nullptr
+   */
+  struct MHD_Response*
+  CreateResponseFromCallback(struct MHD_Connection*    connection,
+                             uint64_t                  size,
+                             size_t                    block_size,
+                             MHD_ContentReaderCallback crc,
+                             void*                     crc_cls);
+
   /**
    * Calls the instance handler function of the Http object
    *
@@ -196,6 +224,15 @@ public:
                 size_t*                upload_data_size,
                 void**                 ptr);
 
+  /**
+   * Answers GET /metrics with the metrics registry of the process in the
+   * Prometheus text format, enabled with EOS_HTTP_METRICS=1
+   *
+   * @return see Handler
+   */
+  static int
+  ServeMetrics(struct MHD_Connection* connection);
+
   /**
    * Calls the instance handler function of the Http object
    *
@@ -273,6 +310,54 @@ public:
   void
   CleanupConnections();
 
+private:
+  struct AsyncConnection;
+  class AsyncReader;
+
+  //! Connection whose handler is currently run by this worker thread
+  static thread_local AsyncConnection* sCurrentConnection;
+
+  /**
+   * Event mode handler: suspends the connection and runs the handler call
+   * on the worker pool, the upload data is copied and consumed immediately
+   *
+   * @return see Handler
+   */
+  int
+  AsyncHandler(void*                  cls,
+               struct MHD_Connection* connection,
+               const char*            url,
+               const char*            method,
+               const char*            version,
+               const char*            upload_data,
+               size_t*                upload_data_size,
+               void**                 ptr);
+
+  /**
+   * Submit a job to the worker pool
+   *
+   * @return true if submitted, false if the pool is shutting down
+   */
+  bool
+  Offload(std::function<void()> job);
+
+  /**
+   * Stop accepting jobs and run the ones already submitted
+   */
+  void
+  StopWorkers();
+
+  /**
+   * Reader callback of the responses created in event mode
+   */
+  static ssize_t
+  AsyncReaderCallback(void* cls, uint64_t pos, char* buf, size_t max);
+
+  /**
+   * Free callback of the responses created in event mode
+   */
+  static void
+  AsyncReaderFree(void* cls);
 #endif
 };
 
@@ -39,8 +39,11 @@
 #include "XrdOuc/XrdOucTokenizer.hh"
 #include "XrdOuc/XrdOucEnv.hh"
 #include "XrdCl/XrdClFile.hh"
+#include <algorithm>
+#include <fstream>
 #include <iomanip>
 #include <setjmp.h>
+#include <sys/wait.h>
 #include <readline/readline.h>
 #include <readline/history.h>
 
@@ -215,6 +218,7 @@ bool pipemode = false;
 bool runpipe = false;
 bool ispipe = false;
 bool json = false;
+bool mgm_online = false;
 
 eos::common::IoPipe iopipe;
 int retcfd = 0;
@@ -623,6 +627,256 @@ std::string textblue("\001\033[49;34m\002");
 std::string textbold("\001\033[1m\002");
 std::string textunbold("\001\033[0m\002");
 
+//------------------------------------------------------------------------------
+// Encode a string as a JSON string value
+//------------------------------------------------------------------------------
+static std::string
+json_string(const std::string& in)
+{
+  std::string encoded = eos::common::StringConversion::json_encode(in);
+  std::string out;
+  out.reserve(encoded.length() + 2);
+  out += '"';
+
+  for (char c : encoded) {
+    if ((unsigned char) c < 0x20) {
+      // control characters not escaped by json_encode
+      char hex[8];
+      snprintf(hex, sizeof(hex), "\\u%04x", (unsigned char) c);
+      out += hex;
+    } else {
+      out += c;
+    }
+  }
+
+  out += '"';
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Read and close a temporary file
+//------------------------------------------------------------------------------
+static std::string
+read_tmpfile(FILE* file)
+{
+  std::string out;
+  char buffer[4096];
+  size_t nread;
+  rewind(file);
+
+  while ((nread = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    out.append(buffer, nread);
+  }
+
+  fclose(file);
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Read the commands of a batch, one per line, from a file or from stdin
+//------------------------------------------------------------------------------
+static bool
+read_commands(const std::string& source, std::vector<std::string>& cmds)
+{
+  std::ifstream file;
+
+  if (source != "-") {
+    file.open(source.c_str());
+
+    if (!file.is_open()) {
+      return false;
+    }
+  }
+
+  std::istream& in = ((source == "-") ? std::cin : file);
+  std::string line;
+
+  while (std::getline(in, line)) {
+    eos::common::trim(line);
+
+    // skip empty lines and comments
+    if (line.empty() || (line[0] == '#')) {
+      continue;
+    }
+
+    cmds.push_back(line);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Execute a command with its stdout and stderr captured and return the result
+// as a JSON object on a single line
+//------------------------------------------------------------------------------
+static std::string
+execute_captured(const std::string& cmd, int& retc)
+{
+  std::string out;
+  std::string err;
+  FILE* outfile = tmpfile();
+  FILE* errfile = tmpfile();
+
+  if (!outfile || !errfile) {
+    retc = errno ? errno : EIO;
+    err = "error: unable to create a file to capture the command output";
+
+    if (outfile) {
+      fclose(outfile);
+    }
+
+    if (errfile) {
+      fclose(errfile);
+    }
+  } else {
+    std::cout << std::flush;
+    std::cerr << std::flush;
+    fflush(stdout);
+    fflush(stderr);
+    int saved_out = dup(STDOUT_FILENO);
+    int saved_err = dup(STDERR_FILENO);
+    dup2(fileno(outfile), STDOUT_FILENO);
+    dup2(fileno(errfile), STDERR_FILENO);
+    std::vector<char> line(cmd.begin(), cmd.end());
+    line.push_back(0);
+    global_retc = 0;
+    execute_line(line.data());
+    retc = global_retc;
+    std::cout << std::flush;
+    std::cerr << std::flush;
+    fflush(stdout);
+    fflush(stderr);
+    dup2(saved_out, STDOUT_FILENO);
+    dup2(saved_err, STDERR_FILENO);
+    close(saved_out);
+    close(saved_err);
+    out = read_tmpfile(outfile);
+    err = read_tmpfile(errfile);
+  }
+
+  std::ostringstream oss;
+  oss << "{\"command\":" << json_string(cmd) << ",\"retc\":" << retc
+      << ",\"stdout\":" << json_string(out) << ",\"stderr\":"
+      << json_string(err) << "}";
+  return oss.str();
+}
+
+//------------------------------------------------------------------------------
+// Run a batch of commands and print their results in order as a JSON array
+//------------------------------------------------------------------------------
+int
+run_commands(const std::string& source, int parallel)
+{
+  std::vector<std::string> cmds;
+
+  if (!read_commands(source, cmds)) {
+    fprintf(stderr, "error: unable to read commands from %s\n", source.c_str());
+    return EINVAL;
+  }
+
+  interactive = false;
+  global_highlighting = false;
+
+  if (cmds.size() && !CheckMgmOnline(serveruri.c_str())) {
+    std::cerr << "error: MGM " << serveruri.c_str()
+              << " not online/reachable" << std::endl;
+    return ENONET;
+  }
+
+  // the MGM is not pinged again before each command of the batch
+  mgm_online = true;
+  std::vector<std::string> results(cmds.size());
+  std::vector<int> retcs(cmds.size(), 0);
+  size_t nworkers = std::min((size_t) std::max(parallel, 1), cmds.size());
+
+  if (nworkers <= 1) {
+    // all the commands go through the connection of this process
+    for (size_t i = 0; i < cmds.size(); ++i) {
+      results[i] = execute_captured(cmds[i], retcs[i]);
+    }
+  } else {
+    // every worker process runs every nworkers-th command over its own
+    // session and writes one "<retc> <result>" line per command
+    std::vector<FILE*> outputs;
+    std::vector<pid_t> pids;
+    std::cout << std::flush;
+    fflush(stdout);
+    fflush(stderr);
+
+    for (size_t w = 0; w < nworkers; ++w) {
+      FILE* output = tmpfile();
+      pid_t pid = (output ? fork() : -1);
+
+      if (pid == 0) {
+        for (size_t i = w; i < cmds.size(); i += nworkers) {
+          int retc = 0;
+          std::string result = execute_captured(cmds[i], retc);
+          fprintf(output, "%d %s\n", retc, result.c_str());
+          fflush(output);
+        }
+
+        _exit(0);
+      }
+
+      if (pid < 0) {
+        fprintf(stderr, "error: unable to start worker %lu of the batch\n",
+                (unsigned long) w);
+
+        if (output) {
+          fclose(output);
+        }
+
+        output = nullptr;
+      }
+
+      outputs.push_back(output);
+      pids.push_back(pid);
+    }
+
+    for (auto pid : pids) {
+      if (pid > 0) {
+        waitpid(pid, nullptr, 0);
+      }
+    }
+
+    for (size_t w = 0; w < nworkers; ++w) {
+      std::istringstream lines(outputs[w] ? read_tmpfile(outputs[w]) : "");
+      std::string line;
+
+      for (size_t i = w; i < cmds.size(); i += nworkers) {
+        size_t pos;
+
+        if (std::getline(lines, line) &&
+            ((pos = line.find(' ')) != std::string::npos)) {
+          retcs[i] = atoi(line.c_str());
+          results[i] = line.substr(pos + 1);
+        } else {
+          // the worker died before running this command
+          retcs[i] = EIO;
+          results[i] = "{\"command\":" + json_string(cmds[i]) + ",\"retc\":" +
+                       std::to_string(EIO) + ",\"stdout\":\"\",\"stderr\":" +
+                       json_string("error: command was not executed") + "}";
+        }
+      }
+    }
+  }
+
+  int retc = 0;
+  fprintf(stdout, "[");
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    fprintf(stdout, "%s\n%s", i ? "," : "", results[i].c_str());
+
+    if (retcs[i]) {
+      retc = retcs[i];
+    }
+  }
+
+  fprintf(stdout, "\n]\n");
+  fflush(stdout);
+  return retc;
+}
+
 //------------------------------------------------------------------------------
 // Usage Information
 //------------------------------------------------------------------------------
@@ -632,7 +886,7 @@ usage()
   fprintf(stderr,
           "`eos' is the command line interface (CLI) of the EOS storage system.\n");
   fprintf(stderr,
-          "Usage: eos [-r|--role <uid> <gid>] [-b|--batch] [-v|--version] [-p|--pipe] [-j|--json] [<mgm-url>] [<cmd> {<argN>}|<filename>.eosh]\n");
+          "Usage: eos [-r|--role <uid> <gid>] [-b|--batch] [-v|--version] [-p|--pipe] [-j|--json] [<mgm-url>] [<cmd> {<argN>}|<filename>.eosh|-c|--commands <filename>|- [--parallel <n>]]\n");
   fprintf(stderr,
           "            -r, --role <uid> <gid>              : select user role <uid> and group role <gid>\n");
   fprintf(stderr,
@@ -652,7 +906,11 @@ usage()
   fprintf(stderr,
           "            {<argN>}                            : single or list of arguments for the eos shell command <cmd>\n");
   fprintf(stderr,
-          "            <filename>.eosh                     : eos script file name ending with .eosh suffix\n\n");
+          "            <filename>.eosh                     : eos script file name ending with .eosh suffix\n");
+  fprintf(stderr,
+          "            -c, --commands <filename>|-         : run the commands of a file or of stdin (one per line) over one session and print their results in order as a JSON array\n");
+  fprintf(stderr,
+          "            --parallel <n>                      : run the commands of --commands over <n> sessions concurrently\n\n");
   fprintf(stderr, "Environment Variables: \n");
   fprintf(stderr,
           "            EOS_MGM_URL                         : sets the redirector URL\n");
@@ -684,6 +942,8 @@ usage()
           "            eos --version                       : print version information\n");
   fprintf(stderr,
           "            eos -b eosscript.eosh               : run the eos shell script 'eosscript.eosh'. This script has to contain linewise commands which are understood by the eos interactive shell\n");
+  fprintf(stderr,
+          "            eos -c - --parallel 4 < cmds.txt    : run the eos shell commands of 'cmds.txt' over 4 sessions and print the results as JSON\n");
   fprintf(stderr, "\n");
   fprintf(stderr,
           "You can leave the interactive shell with <Control-D>. <Control-C> cleans the current shell line or terminates the shell when a command is currently executed.\n");
@@ -738,11 +998,13 @@ Run(int argc, char* argv[])
           (in1 != "--pipe") &&
           (in1 != "--role") &&
           (in1 != "--json") &&
+          (in1 != "--commands") &&
           (in1 != "-h") &&
           (in1 != "-b") &&
           (in1 != "-p") &&
           (in1 != "-v") &&
           (in1 != "-j") &&
+          (in1 != "-c") &&
           (in1 != "-r")) {
         usage();
         exit(-1);
@@ -843,6 +1105,37 @@ Run(int argc, char* argv[])
       in1 = argv[argindex];
     }
 
+    if ((in1 == "--commands") || (in1 == "-c")) {
+      int parallel = 1;
+
+      if (argindex + 1 >= argc) {
+        usage();
+        exit(-1);
+      }
+
+      if ((argindex + 3 < argc) && !strcmp(argv[argindex + 2], "--parallel")) {
+        parallel = atoi(argv[argindex + 3]);
+      } else if (argindex + 2 < argc) {
+        parallel = 0;
+      }
+
+      if (parallel < 1) {
+        usage();
+        exit(-1);
+      }
+
+      if ((!selectedrole) && (!getuid()) &&
+          (serveruri.beginswith("root://localhost"))) {
+        // we are root, we always select also the root role by default
+        XrdOucString cmdline = "role 0 0 ";
+        silent = true;
+        execute_line((char*) cmdline.c_str());
+        silent = false;
+      }
+
+      exit(run_commands(argv[argindex + 1], parallel));
+    }
+
     if (in1.length()) {
       // check if this is a file (workaround for XrdOucString bug
       if ((in1.length() > 5) && (in1.endswith(".eosh")) &&
@@ -1154,7 +1447,7 @@ execute_line(char* line)
   std::string args = line_without_comment;
 
   // Check MGM availability
-  if (RequiresMgm(command->name, args) &&
+  if (RequiresMgm(command->name, args) && !mgm_online &&
       !CheckMgmOnline(serveruri.c_str())) {
     std::cerr << "error: MGM " << serveruri.c_str()
               << " not online/reachable" << std::endl;
@@ -96,6 +96,18 @@ std::string parse_comment(const char* line, std::string& comment);
 COMMAND* find_command(const char* command);
 int execute_line(char* line);
 
+//------------------------------------------------------------------------------
+//! Run a batch of commands and print their results in order as a JSON array
+//! of {"command", "retc", "stdout", "stderr"} objects
+//!
+//! @param source file with one command per line, "-" for stdin
+//! @param parallel number of sessions running the commands concurrently, with
+//!        1 all the commands use the connection of the calling process
+//!
+//! @return 0 if all the commands succeeded, otherwise the last failed retc
+//------------------------------------------------------------------------------
+int run_commands(const std::string& source, int parallel);
+
 int Run(int argc, char* argv[]);
 
 //------------------------------------------------------------------------------
@@ -54,14 +54,26 @@ com_archive(char* arg1)
 
     if (!token.length()) {
       goto com_archive_usage;
-    } else if (token.beginswith("--")) {
+    }
+
+    while (token.beginswith("--")) {
       token.erase(0, 2);
 
-      if (token != "retry") {
+      if (token == "retry") {
+        in_cmd << "&mgm.archive.option=r";
+      } else if ((token == "threads") &&
+                 ((subcmd == "put") || (subcmd == "get"))) {
+        token = subtokenizer.GetToken();
+
+        if (!token.length() || (atoi(token.c_str()) <= 0)) {
+          fprintf(stdout, "error: --threads needs a positive number\n");
+          goto com_archive_usage;
+        }
+
+        in_cmd << "&mgm.archive.threads=" << atoi(token.c_str());
+      } else {
         fprintf(stdout, "Unknown option: %s", token.c_str());
         goto com_archive_usage;
-      } else {
-        in_cmd << "&mgm.archive.option=r";
       }
 
       token = subtokenizer.GetToken();
@@ -114,9 +126,9 @@ com_archive_usage:
   oss << "usage: archive <subcmd> " << std::endl
       << "               create <path>                          "
       << ": create archive file" << std::endl
-      << "               put [--retry] <path>                   "
+      << "               put [--retry] [--threads <n>] <path>   "
       << ": copy files from EOS to archive location" << std::endl
-      << "               get [--retry] <path>                   "
+      << "               get [--retry] [--threads <n>] <path>   "
       << ": recall archive back to EOS" << std::endl
       << "               purge[--retry] <path>                  "
       << ": purge files on disk" << std::endl
@@ -129,7 +141,12 @@ com_archive_usage:
       << "               delete <path>                          "
       << ": delete files from tape, keeping the ones on disk" << std::endl
       << "               help [--help|-h]                       "
-      << ": display help message" << std::endl;
+      << ": display help message" << std::endl
+      << std::endl
+      << "Options:" << std::endl
+      << "  --threads <n> : number of parallel copy jobs of this transfer, "
+      << "the default is" << std::endl
+      << "                  set in the archive daemon configuration" << std::endl;
   fprintf(stdout, "%s", oss.str().c_str());
   global_retc = EINVAL;
   return 0;
@@ -442,6 +442,15 @@ com_attr_usage:
   fprintf(stdout,
           "                                                 defines the rule that files with a given match will be converted to the layouts defined by sys.conversion.<match> when their access time reaches <age>. Optionally a size limitation can be given e.g. '*:1w:>1G' as 1 week old and larger than 1G or '*:1d:<1k' as one day old and smaller than 1k \n");
   fprintf(stdout, "\n");
+  fprintf(stdout,
+          "         sys.tier.hot=<space>                  : place new files in the hot space <space>\n");
+  fprintf(stdout,
+          "         sys.tier.cold=<space>                 : move files older than sys.tier.age into the cold space <space> [needs the converter of <space>]\n");
+  fprintf(stdout,
+          "         sys.tier.age=<age>                    : cool down age after which files move to the cold space\n");
+  fprintf(stdout,
+          "         sys.tier.layout=<hexlayout>           : layout of the files moved to the cold space, by default the layout is kept\n");
+  fprintf(stdout, "\n");
   // ---------------------------------------------------------------------------
   fprintf(stdout,
           "         sys.stall.unavailable=<sec>           : stall clients for <sec> seconds if a needed file system is unavailable\n");
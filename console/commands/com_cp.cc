@@ -23,6 +23,8 @@
 
 /*----------------------------------------------------------------------------*/
 #include <iomanip>
+#include <map>
+#include <sys/wait.h>
 #include "common/StringTokenizer.hh"
 #include "console/ConsoleMain.hh"
 #include "common/Path.hh"
@@ -39,7 +41,7 @@ int
 com_cp_usage()
 {
   fprintf(stdout,
-          "Usage: cp [--async] [--atomic] [--rate=<rate>] [--streams=<n>] [--depth=<d>] [--checksum] [--no-overwrite|-k] [--preserve|-p] [--recursive|-r|-R] [-s|--silent] [-a] [-n] [-S] [-d] <src> <dst>\n");
+          "Usage: cp [--async] [--atomic] [--rate=<rate>] [--streams=<n>] [--depth=<d>] [--parallel=<n>] [--checksum] [--no-overwrite|-k] [--preserve|-p] [--recursive|-r|-R] [-s|--silent] [-a] [-n] [-S] [-d] <src> <dst>\n");
   fprintf(stdout, "'[eos] cp ..' provides copy functionality to EOS.\n");
   fprintf(stdout,
           "          <src>|<dst> can be root://<host>/<path>, a local path /tmp/../ or an eos path /eos/ in the connected instance\n");
@@ -51,6 +53,8 @@ com_cp_usage()
   fprintf(stdout, "       --rate          : limit the cp rate to <rate>\n");
   fprintf(stdout, "       --streams       : use <#> parallel streams\n");
   fprintf(stdout, "       --depth         : depth for recursive copy\n");
+  fprintf(stdout,
+          "       --parallel      : run up to <n> file transfers in parallel and show one aggregated progress\n");
   fprintf(stdout, "       --checksum      : output the checksums\n");
   fprintf(stdout,
           "       -a              : append to the target, don't truncate\n");
@@ -127,6 +131,13 @@ struct File_t {
   File_t() : name(""), opaque(""), protocol(Protocol::UNKNOWN), size(0) { }
 };
 
+struct CopyJob_t {
+  File_t* source;
+  XrdOucString dest;
+  XrdOucString target_path;
+  bool temporary_file;
+};
+
 /* Helper functions */
 int run_eos_command(const char* cmdline, std::vector<XrdOucString>& result);
 int run_command(const char* cmdline, std::vector<XrdOucString>& result);
@@ -166,6 +177,7 @@ com_cp(char* argin)
   unsigned long long copysize = 0;
   unsigned long long copiedsize = 0;
   unsigned long depth = 0;
+  unsigned long parallel = 1;
   struct timeval start_time, end_time;
   struct timezone tz;
   int files_copied = 0;
@@ -222,6 +234,19 @@ com_cp(char* argin)
       preserve = true;
     } else if (option == "--atomic") {
       atomic = "&eos.atomic=1";
+    } else if (option.beginswith("--parallel=")) {
+      option.replace("--parallel=", "");
+
+      try {
+        parallel = std::stoul(option.c_str());
+      } catch (...) {
+        parallel = 0;
+      }
+
+      if (!parallel) {
+        fprintf(stderr, "error: invalid value for <n>=%s\n", option.c_str());
+        return com_cp_usage();
+      }
     } else if (option.beginswith("--depth=")) {
       option.replace("--depth=", "");
 
@@ -775,6 +800,264 @@ com_cp(char* argin)
   int file_idx = -1;
   retc = 0;
 
+  if (target_is_stdout) {
+    parallel = 1;
+  }
+
+  // Parallel transfers show one aggregated progress instead of a bar each
+  bool aggregate_progress = ((parallel > 1) && !noprogress);
+
+  if (parallel > 1) {
+    noprogress = true;
+  }
+
+  // --------------------------------------------------------------------------
+  // Check the outcome of a copy, returns 0 to go on, 1 to stop on a
+  // CONTROL-C and -1 to abort the command
+  // --------------------------------------------------------------------------
+  auto finish_copy = [&](CopyJob_t & job, int lrc) -> int {
+    File_t& source = *job.source;
+    XrdOucString& dest = job.dest;
+    XrdOucString& target_path = job.target_path;
+    bool temporary_file = job.temporary_file;
+    XrdOucString cmdtext;
+
+    // Check if we got a CONTROL-C
+    if (lrc == EINTR) {
+      fprintf(stderr, "<Control-C>\n");
+      return 1;
+    }
+
+    if (WEXITSTATUS(lrc)) {
+      fprintf(stderr, "error: failed copying path=%s\n", target_path.c_str());
+      retc |= lrc;
+      return 0;
+    }
+
+    //------------------------------------
+    // Check target size
+    //------------------------------------
+
+    if (((target.protocol == Protocol::EOS)    ||
+         (target.protocol == Protocol::XROOT)  ||
+         (target.protocol == Protocol::LOCAL)) && (!target_is_stdout)) {
+      struct stat buf;
+
+      if (!do_stat(target_path.c_str(), target.protocol, buf)) {
+        if ((!source.size) ||
+            (buf.st_size == (off_t)(append ? target_stat.st_size + source.size :
+                                    (off_t) source.size)
+            )
+           ) {
+          // Preserve creation and modification timestamps
+          if ((preserve) && (source.atime.tv_sec > 0) && (source.mtime.tv_sec > 0)) {
+            bool updateok;
+
+            if (target.protocol == Protocol::LOCAL) {
+              struct timeval times[2];
+              times[0].tv_sec = source.atime.tv_sec;
+              times[0].tv_usec = source.atime.tv_nsec / 1000;
+              times[1].tv_sec = source.mtime.tv_sec;
+              times[1].tv_usec = source.mtime.tv_nsec / 1000;
+              updateok = (utimes(target_path.c_str(), times) == 0);
+            } else {
+              char update[1024];
+              const char* roles = eos_roles_opaque();
+              sprintf(update, "%ceos.app=eoscp%s%s&mgm.pcmd=utimes"
+                      "&tv1_sec=%llu&tv1_nsec=%llu"
+                      "&tv2_sec=%llu&tv2_nsec=%llu",
+                      (target.opaque.length()) ? '&' : '?',
+                      (roles) ? "&" : "",
+                      (roles) ? roles : "",
+                      (unsigned long long) source.atime.tv_sec,
+                      (unsigned long long) source.atime.tv_nsec,
+                      (unsigned long long) source.mtime.tv_sec,
+                      (unsigned long long) source.mtime.tv_nsec);
+              XrdOucString request = target_path.c_str();
+              request += update;
+              char value[4096];
+              value[0] = 0;
+              long long update_rc = XrdPosixXrootd::QueryOpaque(request.c_str(),
+                                    value, 4096);
+              updateok = (update_rc >= 0);
+
+              // Parse the stat output
+              if (updateok) {
+                char tag[1024];
+                int tmp_retc;
+                int items = sscanf(value, "%1023s retc=%d", tag, &tmp_retc);
+                updateok = ((items == 2) && (strcmp(tag, "utimes:") == 0));
+              }
+            }
+
+            if (!updateok) {
+              fprintf(stderr, "warning: creation/modification time "
+                      "could not be preserved for path=%s\n",
+                      target_path.c_str());
+            }
+          }
+
+          // Verify checksum
+          if ((checksums) && (target.protocol != Protocol::LOCAL)) {
+            XrdOucString address = serveruri.c_str();
+            address += "//dummy";
+            XrdCl::URL url(address.c_str());
+
+            if (!url.IsValid()) {
+              fprintf(stderr, "error: invalid file system URL=%s "
+                      "[attempting checksum]\n",
+                      url.GetURL().c_str());
+              global_retc = EINVAL;
+              return -1;
+            }
+
+            auto* fs = new XrdCl::FileSystem(url);
+
+            if (!fs) {
+              fprintf(stderr, "error: failed to get new FS object "
+                      "[attempting checksum]\n");
+              global_retc = EINVAL;
+              return -1;
+            }
+
+            XrdCl::Buffer arg;
+            XrdCl::Buffer* response = nullptr;
+            XrdCl::XRootDStatus status;
+            std::string query_path = dest.c_str();
+            std::string::size_type pos = query_path.rfind("//");
+
+            if (pos != std::string::npos) {
+              query_path.erase(0, pos + 1);
+            }
+
+            arg.FromString(query_path);
+            status = fs->Query(XrdCl::QueryCode::Checksum, arg, response);
+
+            if (status.IsOK()) {
+              XrdOucString xsum = response->GetBuffer();
+              xsum.replace("eos ", "");
+              fprintf(stdout, "path=%s size=%llu checksum=%s\n",
+                      source.name.c_str(), source.size, xsum.c_str());
+            } else {
+              fprintf(stdout, "warning: failed getting checksum for path=%s size=%llu\n",
+                      source.name.c_str(), source.size);
+            }
+
+            delete response;
+            delete fs;
+          }
+        } else {
+          XrdOucString ssize1, ssize2;
+          fprintf(stderr, "error: file size difference between source and target file "
+                  "source=%s [%s] target=%s [%s]\n",
+                  source.name.c_str(),
+                  eos::common::StringConversion::GetReadableSizeString(ssize1,
+                      source.size, "B"),
+                  target_path.c_str(),
+                  eos::common::StringConversion::GetReadableSizeString(ssize2,
+                      (unsigned long long) buf.st_size, "B"));
+          lrc |= 0xffff00;
+        }
+      } else {
+        fprintf(stderr, "error: target file not created source=%s target=%s\n",
+                source.name.c_str(), target_path.c_str());
+        lrc |= 0xffff00;
+      }
+    }
+
+    // Attempt to upload temporary file
+    if (temporary_file) {
+      if (target.protocol == Protocol::GSIFTP) {
+        cmdtext = "globus-url-copy file://";
+        cmdtext += dest.c_str();
+        cmdtext += " ";
+        cmdtext += target_path.c_str();
+
+        if (silent || noprogress) {
+          cmdtext += " >& /dev/null";
+        }
+
+        if (debug) {
+          fprintf(stderr, "[eos-cp] running: %s\n", cmdtext.c_str());
+        }
+
+        int rc = system(cmdtext.c_str());
+
+        if (WEXITSTATUS(rc)) {
+          fprintf(stderr, "error: failed to upload %s [protocol=gsiftp]\n",
+                  target_path.c_str());
+          lrc |= 0xffff00;
+        }
+      }
+
+      if ((target.protocol == Protocol::HTTP) ||
+          (target.protocol == Protocol::HTTPS)) {
+        fprintf(stderr, "error: file uploads not supported for %s protocol [path=%s]\n",
+                protocol_to_string(target.protocol), target_path.c_str());
+        lrc |= 0xffff00;
+      }
+
+      // Clean-up the temporary file
+      unlink(dest.c_str());
+    }
+
+    if (!WEXITSTATUS(lrc)) {
+      files_copied++;
+      copiedsize += source.size;
+    }
+
+    retc |= lrc;
+    return 0;
+  };
+
+  // Transfers running in the background with --parallel, by pid
+  std::map<pid_t, CopyJob_t> running;
+  int files_done = 0;
+  int stop = 0;
+
+  // --------------------------------------------------------------------------
+  // Wait for one background transfer and check its outcome
+  // --------------------------------------------------------------------------
+  auto reap_copy = [&]() {
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+
+    if (pid < 0) {
+      // no child left to wait for
+      running.clear();
+      return;
+    }
+
+    auto it = running.find(pid);
+
+    if (it == running.end()) {
+      return;
+    }
+
+    CopyJob_t job = it->second;
+    running.erase(it);
+
+    if (WIFSIGNALED(status) && (WTERMSIG(status) == SIGINT)) {
+      status = EINTR;
+    }
+
+    int rc = finish_copy(job, status);
+
+    if (rc && (stop >= 0)) {
+      stop = rc;
+    }
+
+    files_done++;
+
+    if (aggregate_progress) {
+      XrdOucString ssize;
+      fprintf(stderr, "\r[eos-cp] finished %d/%d files - copied %s",
+              files_done, (int) source_list.size(),
+              eos::common::StringConversion::GetReadableSizeString(ssize, copiedsize,
+                  "B"));
+    }
+  };
+
   for (auto& source : source_list) {
     XrdOucString dest = target.name.c_str();
     // Processed target path + original target opaque info
@@ -1072,193 +1355,57 @@ com_cp(char* argin)
       fprintf(stderr, "[eos-cp] running: %s\n", cmdtext.c_str());
     }
 
-    int lrc = system(cmdtext.c_str());
+    CopyJob_t job {&source, dest, target_path, temporary_file};
 
-    // Check if we got a CONTROL-C
-    if (lrc == EINTR) {
-      fprintf(stderr, "<Control-C>\n");
-      break;
-    }
+    if (parallel <= 1) {
+      int rc = finish_copy(job, system(cmdtext.c_str()));
+
+      if (rc < 0) {
+        return -1;
+      } else if (rc) {
+        break;
+      }
 
-    if (WEXITSTATUS(lrc)) {
-      fprintf(stderr, "error: failed copying path=%s\n", target_path.c_str());
-      retc |= lrc;
       continue;
     }
 
-    //------------------------------------
-    // Check target size
-    //------------------------------------
-
-    if (((target.protocol == Protocol::EOS)    ||
-         (target.protocol == Protocol::XROOT)  ||
-         (target.protocol == Protocol::LOCAL)) && (!target_is_stdout)) {
-      struct stat buf;
-
-      if (!do_stat(target_path.c_str(), target.protocol, buf)) {
-        if ((!source.size) ||
-            (buf.st_size == (off_t)(append ? target_stat.st_size + source.size :
-                                    (off_t) source.size)
-            )
-           ) {
-          // Preserve creation and modification timestamps
-          if ((preserve) && (source.atime.tv_sec > 0) && (source.mtime.tv_sec > 0)) {
-            bool updateok;
-
-            if (target.protocol == Protocol::LOCAL) {
-              struct timeval times[2];
-              times[0].tv_sec = source.atime.tv_sec;
-              times[0].tv_usec = source.atime.tv_nsec / 1000;
-              times[1].tv_sec = source.mtime.tv_sec;
-              times[1].tv_usec = source.mtime.tv_nsec / 1000;
-              updateok = (utimes(target_path.c_str(), times) == 0);
-            } else {
-              char update[1024];
-              const char* roles = eos_roles_opaque();
-              sprintf(update, "%ceos.app=eoscp%s%s&mgm.pcmd=utimes"
-                      "&tv1_sec=%llu&tv1_nsec=%llu"
-                      "&tv2_sec=%llu&tv2_nsec=%llu",
-                      (target.opaque.length()) ? '&' : '?',
-                      (roles) ? "&" : "",
-                      (roles) ? roles : "",
-                      (unsigned long long) source.atime.tv_sec,
-                      (unsigned long long) source.atime.tv_nsec,
-                      (unsigned long long) source.mtime.tv_sec,
-                      (unsigned long long) source.mtime.tv_nsec);
-              XrdOucString request = target_path.c_str();
-              request += update;
-              char value[4096];
-              value[0] = 0;
-              long long update_rc = XrdPosixXrootd::QueryOpaque(request.c_str(),
-                                    value, 4096);
-              updateok = (update_rc >= 0);
-
-              // Parse the stat output
-              if (updateok) {
-                char tag[1024];
-                int tmp_retc;
-                int items = sscanf(value, "%1023s retc=%d", tag, &tmp_retc);
-                updateok = ((items == 2) && (strcmp(tag, "utimes:") == 0));
-              }
-            }
-
-            if (!updateok) {
-              fprintf(stderr, "warning: creation/modification time "
-                      "could not be preserved for path=%s\n",
-                      target_path.c_str());
-            }
-          }
-
-          // Verify checksum
-          if ((checksums) && (target.protocol != Protocol::LOCAL)) {
-            XrdOucString address = serveruri.c_str();
-            address += "//dummy";
-            XrdCl::URL url(address.c_str());
-
-            if (!url.IsValid()) {
-              fprintf(stderr, "error: invalid file system URL=%s "
-                      "[attempting checksum]\n",
-                      url.GetURL().c_str());
-              global_retc = EINVAL;
-              return -1;
-            }
-
-            auto* fs = new XrdCl::FileSystem(url);
-
-            if (!fs) {
-              fprintf(stderr, "error: failed to get new FS object "
-                      "[attempting checksum]\n");
-              global_retc = EINVAL;
-              return -1;
-            }
-
-            XrdCl::Buffer arg;
-            XrdCl::Buffer* response = nullptr;
-            XrdCl::XRootDStatus status;
-            std::string query_path = dest.c_str();
-            std::string::size_type pos = query_path.rfind("//");
-
-            if (pos != std::string::npos) {
-              query_path.erase(0, pos + 1);
-            }
-
-            arg.FromString(query_path);
-            status = fs->Query(XrdCl::QueryCode::Checksum, arg, response);
-
-            if (status.IsOK()) {
-              XrdOucString xsum = response->GetBuffer();
-              xsum.replace("eos ", "");
-              fprintf(stdout, "path=%s size=%llu checksum=%s\n",
-                      source.name.c_str(), source.size, xsum.c_str());
-            } else {
-              fprintf(stdout, "warning: failed getting checksum for path=%s size=%llu\n",
-                      source.name.c_str(), source.size);
-            }
-
-            delete response;
-            delete fs;
-          }
-        } else {
-          XrdOucString ssize1, ssize2;
-          fprintf(stderr, "error: file size difference between source and target file "
-                  "source=%s [%s] target=%s [%s]\n",
-                  source.name.c_str(),
-                  eos::common::StringConversion::GetReadableSizeString(ssize1,
-                      source.size, "B"),
-                  target_path.c_str(),
-                  eos::common::StringConversion::GetReadableSizeString(ssize2,
-                      (unsigned long long) buf.st_size, "B"));
-          lrc |= 0xffff00;
-        }
-      } else {
-        fprintf(stderr, "error: target file not created source=%s target=%s\n",
-                source.name.c_str(), target_path.c_str());
-        lrc |= 0xffff00;
-      }
+    // Wait for a free slot and start the transfer in the background
+    while (running.size() >= parallel) {
+      reap_copy();
     }
 
-    // Attempt to upload temporary file
-    if (temporary_file) {
-      if (target.protocol == Protocol::GSIFTP) {
-        cmdtext = "globus-url-copy file://";
-        cmdtext += dest.c_str();
-        cmdtext += " ";
-        cmdtext += target_path.c_str();
-
-        if (silent || noprogress) {
-          cmdtext += " >& /dev/null";
-        }
+    if (stop) {
+      break;
+    }
 
-        if (debug) {
-          fprintf(stderr, "[eos-cp] running: %s\n", cmdtext.c_str());
-        }
+    pid_t pid = fork();
 
-        int rc = system(cmdtext.c_str());
+    if (pid == 0) {
+      execl("/bin/sh", "sh", "-c", cmdtext.c_str(), (char*) 0);
+      _exit(127);
+    }
 
-        if (WEXITSTATUS(rc)) {
-          fprintf(stderr, "error: failed to upload %s [protocol=gsiftp]\n",
-                  target_path.c_str());
-          lrc |= 0xffff00;
-        }
-      }
+    if (pid < 0) {
+      fprintf(stderr, "error: failed to start the copy of path=%s\n",
+              target_path.c_str());
+      retc |= 0xffff00;
+      continue;
+    }
 
-      if ((target.protocol == Protocol::HTTP) ||
-          (target.protocol == Protocol::HTTPS)) {
-        fprintf(stderr, "error: file uploads not supported for %s protocol [path=%s]\n",
-                protocol_to_string(target.protocol), target_path.c_str());
-        lrc |= 0xffff00;
-      }
+    running[pid] = job;
+  }
 
-      // Clean-up the temporary file
-      unlink(dest.c_str());
-    }
+  // Wait for the background transfers still running
+  while (running.size()) {
+    reap_copy();
+  }
 
-    if (!WEXITSTATUS(lrc)) {
-      files_copied++;
-      copiedsize += source.size;
-    }
+  if (aggregate_progress && files_done) {
+    fprintf(stderr, "\n");
+  }
 
-    retc |= lrc;
+  if (stop < 0) {
+    return -1;
   }
 
   // Mark end timestamp
@@ -53,7 +53,25 @@ com_debug(char* arg1)
       return (0);
     }
 
-    if (level.length()) {
+    if (level == "heap") {
+      // allocator statistics and heap profiles of the MGM
+      XrdOucString action = nodequeue;
+      XrdOucString arg = subtokenizer.GetToken();
+
+      if ((action == "stats") || (action == "start") || (action == "stop") ||
+          (action == "dump")) {
+        XrdOucString in = "mgm.cmd=debug&mgm.subcmd=heap&mgm.heap.action=";
+        in += action;
+
+        if (arg.length()) {
+          in += "&mgm.heap.arg=";
+          in += arg;
+        }
+
+        global_retc = output_result(client_command(in, true));
+        return (0);
+      }
+    } else if (level.length()) {
       XrdOucString in = "mgm.cmd=debug&mgm.debuglevel=";
       in += level;
 
@@ -82,6 +100,8 @@ com_debug(char* arg1)
 
   fprintf(stdout,
           "Usage: debug [node-queue] this|<level> [--filter <unitlist>]\n");
+  fprintf(stdout,
+          "       debug heap stats [--arenas]|start|stop|dump [<file>]\n");
   fprintf(stdout,
           "'[eos] debug ...' allows to modify the verbosity of the EOS log files in MGM and FST services.\n\n");
   fprintf(stdout, "Options:\n");
@@ -94,6 +114,15 @@ com_debug(char* arg1)
   fprintf(stdout, "debug  <level> <node-queue> [--filter <unitlist>] :\n");
   fprintf(stdout,
           "                                                  set the <node-queue> into debug level <level>. <node-queue> are internal EOS names e.g. '/eos/<hostname>:<port>/fst'\n");
+  fprintf(stdout, "debug  heap stats [--arenas] :\n");
+  fprintf(stdout,
+          "                                                  print the jemalloc allocation counters of the MGM, with --arenas per arena\n");
+  fprintf(stdout, "debug  heap start|stop :\n");
+  fprintf(stdout,
+          "                                                  activate/deactivate jemalloc heap profiling in the MGM (needs MALLOC_CONF=prof:true)\n");
+  fprintf(stdout, "debug  heap dump [<file>] :\n");
+  fprintf(stdout,
+          "                                                  dump a heap profile of the MGM to <file> or into the prof_prefix location\n");
   fprintf(stdout,
           "     <unitlist> : a comma separated list of strings of software units which should be filtered out in the message log!\n");
   fprintf(stdout,
@@ -952,6 +952,20 @@ com_fs_usage:
   fprintf(stdout, "fs config <fsid> drainperiod=<seconds> : \n");
   fprintf(stdout,
           "                                                  drain period a drain job is waiting to finish the drain procedure\n");
+  fprintf(stdout, "fs config <fsid> fmdcommit=direct|batch|batchsync : \n");
+  fprintf(stdout,
+          "                                                  direct writes every file meta data record to the local FST database on its own (default)\n");
+  fprintf(stdout,
+          "                                                  batch groups the records and writes them after a short delay, the last records can be lost on a crash\n");
+  fprintf(stdout,
+          "                                                  batchsync groups the records and syncs every group to disk\n");
+  fprintf(stdout, "fs config <fsid> fmdstore=leveldb|slot : \n");
+  fprintf(stdout,
+          "                                                  leveldb keeps the file meta data records of the filesystem in a LevelDB database on the FST (default)\n");
+  fprintf(stdout,
+          "                                                  slot keeps them in a memory-mapped file indexed by file id, without compaction\n");
+  fprintf(stdout,
+          "                                                  applied when the filesystem boots, the records of the previous database are migrated\n");
   fprintf(stdout, "fs config <fsid> proxygroup=<proxygroupname> : \n");
   fprintf(stdout,
           "                                                  schedule a proxy for this fs by taking it from the given proxygroup\n");
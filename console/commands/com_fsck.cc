@@ -136,7 +136,7 @@ com_fsck(char* arg1)
   return (0);
 com_fsck_usage:
   fprintf(stdout,
-          "usage: fsck stat                                                  :  print status of consistency check\n");
+          "usage: fsck stat                                                  :  print status of consistency check and progress of the repair jobs\n");
   fprintf(stdout,
           "       fsck enable [<interval>]                                   :  enable fsck\n");
   fprintf(stdout,
@@ -186,6 +186,8 @@ com_fsck_usage:
           "                                                                  :  drop the damaged replica of the file and recover with a healthy one if possible!\n");
   fprintf(stdout,
           "       fsck repair --all                                          :  do all the repair actions besides <checksum-commit>\n");
+  fprintf(stdout,
+          "                                                                  :  repair jobs run in the background, files with the fewest healthy replicas first\n");
   global_retc = EINVAL;
   return (0);
 }
@@ -251,6 +251,8 @@ com_io_usage:
           "                                                               -w :  show history for the last 7 days\n");
   fprintf(stdout,
           "                                                               -f :  show the 'hotfiles' which are the files with highest number of present file opens\n");
+  fprintf(stdout,
+          "                                                                     and the files with the highest IO rate (rio/wio)\n");
   global_retc = EINVAL;
   return (0);
 }
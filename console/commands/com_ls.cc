@@ -24,9 +24,143 @@
 #include "console/ConsoleMain.hh"
 #include "common/StringTokenizer.hh"
 #include "common/StringConversion.hh"
+#include "common/FileId.hh"
+#include "common/FileSystem.hh"
+#include "common/Timing.hh"
+#include "mq/XrdMqMessage.hh"
 #include "XrdPosix/XrdPosixXrootd.hh"
 #include "XrdOuc/XrdOucEnv.hh"
 #include "namespace/utils/Mode.hh"
+#include <json/json.h>
+
+//------------------------------------------------------------------------------
+// Print one entry of a paginated listing like the server side 'ls'
+//------------------------------------------------------------------------------
+static void
+print_page_entry(const Json::Value& entry, const XrdOucString& option)
+{
+  std::string name = entry["name"].asString();
+  mode_t mode = entry["mode"].asUInt();
+  std::string dirmarker;
+
+  if (S_ISDIR(mode) && ((option.find("F")) != STR_NPOS)) {
+    dirmarker = "/";
+  }
+
+  if (((option.find("l")) == STR_NPOS)) {
+    fprintf(stdout, "%s%s\n", name.c_str(), dirmarker.c_str());
+    return;
+  }
+
+  unsigned long long ino = entry["ino"].asUInt64();
+  unsigned long nlink = entry["nlink"].asUInt();
+
+  if ((option.find("i")) != STR_NPOS) {
+    fprintf(stdout, "%-16llu", (unsigned long long)(S_ISDIR(mode) ? ino :
+            eos::common::FileId::InodeToFid(ino)));
+  }
+
+  if ((option.find("y")) != STR_NPOS) {
+    char sbst[256];
+    snprintf(sbst, sizeof(sbst), "d%lu::t%i ", (mode & EOS_TAPE_MODE_T) ?
+             nlink - 1 : nlink, (mode & EOS_TAPE_MODE_T ? 1 : 0));
+    fprintf(stdout, "%-9s", sbst);
+  }
+
+  char modestr[11];
+  eos::modeToBuffer(mode, modestr);
+  std::string suid = (entry.isMember("user") ? entry["user"].asString() :
+                      std::to_string(entry["uid"].asUInt()));
+  std::string sgid = (entry.isMember("group") ? entry["group"].asString() :
+                      std::to_string(entry["gid"].asUInt()));
+  XrdOucString sizestring;
+  unsigned long long size = entry["size"].asUInt64();
+
+  if ((option.find("h")) == STR_NPOS) {
+    eos::common::StringConversion::GetSizeString(sizestring, size);
+  } else {
+    eos::common::StringConversion::GetReadableSizeString(sizestring, size, "");
+  }
+
+  time_t mtime = entry["mtime"].asUInt64();
+  struct tm t_tm_local;
+  std::string t_creat = eos::common::Timing::ToLsFormat(
+                          localtime_r(&mtime, &t_tm_local));
+  fprintf(stdout, "%s %3d %-8.8s %-8.8s %12s %s %s%s", modestr, (int) nlink,
+          suid.c_str(), sgid.c_str(), sizestring.c_str(), t_creat.c_str(),
+          name.c_str(), dirmarker.c_str());
+
+  if (entry.isMember("link")) {
+    fprintf(stdout, " -> %s", entry["link"].asString().c_str());
+  }
+
+  fprintf(stdout, "\n");
+}
+
+//------------------------------------------------------------------------------
+// List a directory page by page, the MGM returns the entries of each page
+// with their stat information
+//------------------------------------------------------------------------------
+static int
+list_pages(const XrdOucString& path, const XrdOucString& option,
+           unsigned long pagesize)
+{
+  std::string token;
+
+  do {
+    XrdOucString in = "mgm.cmd=ls&mgm.path=";
+    in += path;
+    in += "&mgm.option=";
+    in += option;
+    in += "&mgm.ls.limit=";
+    in += std::to_string(pagesize).c_str();
+
+    if (token.length()) {
+      in += "&mgm.ls.token=";
+      in += eos::common::StringConversion::curl_escaped(token).c_str();
+    }
+
+    if (!json) {
+      in += "&mgm.format=json";
+    }
+
+    XrdOucEnv* result = client_command(in);
+
+    if (!result) {
+      return EINVAL;
+    }
+
+    XrdOucString rjson = result->Get("mgm.proc.json");
+    delete result;
+    XrdMqMessage::UnSeal(rjson);
+    Json::Value page;
+    Json::Reader reader;
+
+    if (!rjson.length() || !reader.parse(rjson.c_str(), page)) {
+      fprintf(stderr, "error: failed to parse the listing reply\n");
+      return EIO;
+    }
+
+    int retc = atoi(page["retc"].asString().c_str());
+
+    if (retc) {
+      fprintf(stderr, "%s\n", page["errormsg"].asString().c_str());
+      return retc;
+    }
+
+    if (json) {
+      fprintf(stdout, "%s\n", rjson.c_str());
+    } else {
+      for (const auto& entry : page["entries"]) {
+        print_page_entry(entry, option);
+      }
+    }
+
+    token = page["token"].asString();
+  } while (token.length());
+
+  return 0;
+}
 
 /* List a directory */
 int
@@ -39,6 +173,7 @@ com_ls(char* arg1)
   XrdOucString option = "";
   XrdOucString path = "";
   XrdOucString in = "mgm.cmd=ls";
+  unsigned long pagesize = 0;
 
   do {
     param = subtokenizer.GetToken();
@@ -55,6 +190,17 @@ com_ls(char* arg1)
       goto com_ls_usage;
     }
 
+    if (param == "--page") {
+      param = subtokenizer.GetToken();
+      pagesize = strtoul(param.c_str(), 0, 10);
+
+      if (!pagesize) {
+        goto com_ls_usage;
+      }
+
+      continue;
+    }
+
     if (param.beginswith("-")) {
       option += param;
 
@@ -258,6 +404,12 @@ com_ls(char* arg1)
   }
 
   path = abspath(path.c_str());
+
+  if (pagesize) {
+    global_retc = list_pages(path, option, pagesize);
+    return (0);
+  }
+
   in += "&mgm.path=";
   in += path;
   in += "&mgm.option=";
@@ -266,7 +418,7 @@ com_ls(char* arg1)
   return (0);
 com_ls_usage:
   fprintf(stdout,
-          "usage: ls [-laniyF] <path>                                             :  list directory <path>\n");
+          "usage: ls [-laniyF] [--page <n>] <path>                                :  list directory <path>\n");
   fprintf(stdout, "                    -l : show long listing\n");
   fprintf(stdout,
           "                    -y : show long listing with backend(tape) status\n");
@@ -278,6 +430,8 @@ com_ls_usage:
   fprintf(stdout, "                    -F : append indicator '/' to directories \n");
   fprintf(stdout,
           "                    -s : checks only if the directory exists without listing\n");
+  fprintf(stdout,
+          "            --page <n> : fetch the listing in pages of <n> entries with their stat information\n");
   fprintf(stdout, "         path=file:... : list on a local file system\n");
   fprintf(stdout,
           "         path=root:... : list on a plain XRootD server (does not work on native XRootD clusters\n");
@@ -138,6 +138,10 @@ void com_fs_help()
       << "    scanrate=<MB/s>" << std::endl
       << "      configure the maximum scan rate"
       << std::endl
+      << "    iobw.scrub|iobw.balance|iobw.drain=<MB/s>" << std::endl
+      << "      configure the maximum rate of the scrub, balance or drain IO"
+      << std::endl
+      << "      on the filesystem. 0 disables the limit" << std::endl
       << "    graceperiod=<seconds>" << std::endl
       << "      grace period before a filesystem with an operation error gets"
       << std::endl
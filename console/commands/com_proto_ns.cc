@@ -119,6 +119,37 @@ NsHelper::ParseCommand(const char* arg)
           mutex->set_sample_rate10(true);
         } else if (soption == "--smplrate100") {
           mutex->set_sample_rate100(true);
+        } else if (soption == "--contention") {
+          if (!(option = tokenizer.GetToken())) {
+            return false;
+          }
+
+          soption = option;
+          char* end = nullptr;
+          float rate = strtof(soption.c_str(), &end);
+
+          if (soption.empty() || *end || (rate < 0) || (rate > 1)) {
+            return false;
+          }
+
+          mutex->set_contention_set(true);
+          mutex->set_contention_rate(rate);
+        } else if (soption == "--contention-top") {
+          if (!(option = tokenizer.GetToken())) {
+            return false;
+          }
+
+          soption = option;
+          char* end = nullptr;
+          unsigned long top = strtoul(soption.c_str(), &end, 10);
+
+          if (soption.empty() || *end || (top == 0)) {
+            return false;
+          }
+
+          mutex->set_contention_top(top);
+        } else if (soption == "--contention-reset") {
+          mutex->set_contention_reset(true);
         } else {
           return false;
         }
@@ -261,7 +292,9 @@ NsHelper::ParseCommand(const char* arg)
         int pos = 0;
         soption = option;
 
-        if ((soption.find("cid:") == 0)) {
+        if (soption == "--incremental") {
+          quota->set_incremental(true);
+        } else if ((soption.find("cid:") == 0)) {
           pos = soption.find(':') + 1;
           quota->mutable_container()->set_cid(soption.substr(pos));
         } else if (soption.find("cxid:") == 0) {
@@ -420,6 +453,14 @@ void com_ns_help()
       << std::endl
       << "    --smplrate100    : set timing sample rate at 100% (severe slow-down)"
       << std::endl
+      << "    --contention <rate>  : sample <rate> (0-1, 0 is off) of the lock"
+      << std::endl
+      << "                           acquisitions to profile lock contention e.g. 0.001"
+      << std::endl
+      << "    --contention-top <n> : print the <n> most contended call sites"
+      << std::endl
+      << "    --contention-reset   : drop the collected contention samples"
+      << std::endl
       << std::endl
       << "  ns compact off|on <delay> [<interval>] [<type>]" << std::endl
       << "    enable online compaction after <delay> seconds" << std::endl
@@ -448,13 +489,19 @@ void com_ns_help()
       << std::endl
       << "    recompute the tree size of a directory and all its subdirectories"
       << std::endl
+      << "    and their tree hash if the MGM runs with EOS_NS_TREE_HASH"
+      << std::endl
       << "    --depth : maximum depth for recomputation, default 0 i.e no limit"
       << std::endl
       << std::endl
-      << "  ns recompute_quotanode <path>|cid:<decimal_id>|cxid:<hex_id>"
+      << "  ns recompute_quotanode <path>|cid:<decimal_id>|cxid:<hex_id> [--incremental]"
       << std::endl
       << "    recompute the specified quotanode"
       << std::endl
+      << "    --incremental : only explore the subdirectories of the quotanode whose"
+      << std::endl
+      << "                    tree size changed since the last recompute"
+      << std::endl
       << std::endl
       << "  ns cache set|drop [-d|-f] [<max_num>] [<max_size>K|M|G...]" << std::endl
       << "    set the max number of entries or the max size of the cache. Use the" <<
@@ -501,6 +501,22 @@ com_space_usage:
           "       space config <space-name> space.converter=on|off              : enable/disable the space converter [default=off]\n");
   fprintf(stdout,
           "       space config <space-name> space.converter.ntx=<#>             : configure the number of parallel conversions per space                 [ default=2 (streams) ]\n");
+  fprintf(stdout,
+          "       space config <space-name> space.converter.group.ntx=<#>       : configure the number of parallel conversions per source and target group [ default=0 (unlimited) ]\n");
+  fprintf(stdout,
+          "       space config <space-name> space.planner=on|off|dryrun         : plan the balancing of the groups or geotags of the space, replaces the group and geo balancer when on [default=off]\n");
+  fprintf(stdout,
+          "       space config <space-name> space.planner.scope=group|geotag    : balance the groups or the geotags [default=group]\n");
+  fprintf(stdout,
+          "       space config <space-name> space.planner.tolerance=<percent>   : tolerated deviation of a unit from the space filling [default=2 (%%)]\n");
+  fprintf(stdout,
+          "       space config <space-name> space.planner.interval=<sec>        : interval between two balance plans [default=300]\n");
+  fprintf(stdout,
+          "       space config <space-name> space.planner.node.bw=<percent>     : share of the NIC bandwidth a node spends on balancing per interval [default=20 (%%)]\n");
+  fprintf(stdout,
+          "       space config <space-name> space.planner.ntx=<#>               : max number of planned transfers in flight [default=100]\n");
+  fprintf(stdout,
+          "       space config <space-name> space.planner.file.minsize=<size>   : don't move files smaller than this size [default=0]\n");
   fprintf(stdout,
           "       space config <space-name> space.drainer.node.rate=<MB/s >     : configure the nominal transfer bandwith per running transfer on a node [ default=25 (MB/s)   ]\n");
   fprintf(stdout,
@@ -515,6 +531,16 @@ com_space_usage:
           "       space config <space-name> space.lru=on|off                    : enable/disable the LRU policy engine [default=off]\n");
   fprintf(stdout,
           "       space config <space-name> space.lru.interval=<sec>            : configure the default lru scan interval\n");
+  fprintf(stdout,
+          "       space config default space.hotreplica=on|off                  : enable/disable extra replicas for files which make a filesystem a hot spot [default=off]\n");
+  fprintf(stdout,
+          "       space config default space.hotreplica.rate=<bytes/s>          : read rate of a file on one filesystem making it hot [default=0=ignored]\n");
+  fprintf(stdout,
+          "       space config default space.hotreplica.opens=<n>               : readers of a file on one filesystem making it hot [default=0=ignored]\n");
+  fprintf(stdout,
+          "       space config default space.hotreplica.max=<n>                 : maximum number of extra replicas of a hot file [default=2]\n");
+  fprintf(stdout,
+          "       space config default space.hotreplica.cooldown=<sec>          : time without load after which the extra replicas are removed [default=3600]\n");
   fprintf(stdout,
           "       space config <space-name> space.headroom=<size>               : configure the default disk headroom if not defined on a filesystem (see fs for details)\n");
   fprintf(stdout,
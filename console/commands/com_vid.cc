@@ -484,7 +484,7 @@ com_vid(char* arg1)
 
 com_vid_usage:
   fprintf(stdout,
-          "usage: vid ls [-u] [-g] [-s] [-U] [-G] [-g] [-a] [-l] [-n] : list configured policies\n");
+          "usage: vid ls [-u] [-g] [-s] [-U] [-G] [-g] [-a] [-l] [-r] [-n] : list configured policies\n");
   fprintf(stdout,
           "                                        -u : show only user role mappings\n");
   fprintf(stdout,
@@ -501,6 +501,8 @@ com_vid_usage:
           "                                        -a : show authentication\n");
   fprintf(stdout,
           "                                        -l : show geo location mapping\n");
+  fprintf(stdout,
+          "                                        -r : show user/group name resolver statistics\n");
   fprintf(stdout,
           "                                        -n : show numerical ids instead of user/group names\n");
   fprintf(stdout, "\n");
@@ -22,6 +22,7 @@
  ************************************************************************/
 
 #include "fst/FmdDbMap.hh"
+#include "fst/FmdSlotDbMapInterface.hh"
 #include "common/Path.hh"
 #include "common/ShellCmd.hh"
 #include "proto/Fs.pb.h"
@@ -35,11 +36,17 @@
 #include "namespace/ns_quarkdb/persistency/RequestBuilder.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
 #include <stdio.h>
+#include <dirent.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <fts.h>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <thread>
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -48,6 +55,58 @@ FmdDbMapHandler gFmdDbMapHandler;
 
 using eos::common::LayoutId;
 
+//------------------------------------------------------------------------------
+// Get the max delay in microseconds before a batch of records is written
+//------------------------------------------------------------------------------
+static int64_t
+GetBatchDelayUs()
+{
+  static int64_t sDelayUs = []() {
+    const char* ptr = getenv("EOS_FST_FMD_BATCH_DELAY_MS");
+    long delay_ms = (ptr ? strtol(ptr, 0, 10) : 20l);
+    return 1000ll * std::min(std::max(delay_ms, 1l), 10000l);
+  }();
+  return sDelayUs;
+}
+
+//------------------------------------------------------------------------------
+// Get the max number of records in a batch
+//------------------------------------------------------------------------------
+static uint64_t
+GetBatchMaxRecords()
+{
+  static uint64_t sMaxRecords = []() {
+    const char* ptr = getenv("EOS_FST_FMD_BATCH_MAX");
+    unsigned long max = (ptr ? strtoul(ptr, 0, 10) : 1024ul);
+    return std::max(max, 1ul);
+  }();
+  return sMaxRecords;
+}
+
+//------------------------------------------------------------------------------
+// Get the number of threads applying the QuarkDB metadata during a resync
+//------------------------------------------------------------------------------
+static uint32_t
+GetQdbResyncWorkers()
+{
+  static uint32_t sNumWorkers = []() {
+    const char* ptr = getenv("EOS_FST_QDB_RESYNC_WORKERS");
+    unsigned long num = (ptr ? strtoul(ptr, 0, 10) : 4ul);
+    return (uint32_t) std::min(std::max(num, 1ul), 64ul);
+  }();
+  return sNumWorkers;
+}
+
+//------------------------------------------------------------------------------
+// Get the current steady time in microseconds
+//------------------------------------------------------------------------------
+static int64_t
+GetSteadyTimeUs()
+{
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -356,11 +415,168 @@ FmdDbMapHandler::GetNumFileSystems() const
   return mDbMap.size();
 }
 
+//------------------------------------------------------------------------------
+// Convert string to store type
+//------------------------------------------------------------------------------
+FmdDbMapHandler::StoreType
+FmdDbMapHandler::GetStoreTypeFromString(const std::string& type)
+{
+  if (type == "slot") {
+    return StoreType::kSlot;
+  }
+
+  return StoreType::kLevelDb;
+}
+
+//------------------------------------------------------------------------------
+// Create an unattached DB map of the given type
+//------------------------------------------------------------------------------
+eos::common::DbMap*
+FmdDbMapHandler::NewDbMap(StoreType type)
+{
+  if (type == StoreType::kSlot) {
+    return new eos::common::DbMap(new FmdSlotDbMapInterface());
+  }
+
+  return new eos::common::DbMap();
+}
+
+//------------------------------------------------------------------------------
+// Attach a DB map to its files and switch it to out-of-core mode
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::AttachDbMap(eos::common::DbMap* db, const std::string& db_name,
+                             StoreType type)
+{
+  // Create / or attach the db (try to repair if needed)
+  eos::common::LvDbDbMapInterface::Option* dbopt = &lvdboption;
+
+  // If we have not set the leveldb option, use the default (currently, bloom
+  // filter 10 bits and 100MB cache)
+  if ((lvdboption.BloomFilterNbits == 0) || (type != StoreType::kLevelDb)) {
+    dbopt = NULL;
+  }
+
+  if (!db->attachDb(db_name, true, 0, dbopt)) {
+    eos_err("msg=\"failed to attach database\" file=%s", db_name.c_str());
+    return false;
+  }
+
+  db->outOfCore(true);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the DB file name of a filesystem
+//------------------------------------------------------------------------------
+static std::string
+GetDbFileName(const char* meta_dir, int fsid, FmdDbMapHandler::StoreType type)
+{
+  char name[1024];
+  snprintf(name, sizeof(name), "%s/fmd.%04d.%s", meta_dir, fsid,
+           (type == FmdDbMapHandler::StoreType::kSlot) ?
+           FmdSlotDbMapInterface::getDbType().c_str() :
+           eos::common::DbMap::getDbType().c_str());
+  return name;
+}
+
+//------------------------------------------------------------------------------
+// Remove a DB directory, the DBs do not have sub-directories
+//------------------------------------------------------------------------------
+static bool
+RemoveDbDir(const std::string& path)
+{
+  DIR* dir = opendir(path.c_str());
+
+  if (!dir) {
+    return (errno == ENOENT);
+  }
+
+  while (struct dirent* entry = readdir(dir)) {
+    std::string name = entry->d_name;
+
+    if ((name != ".") && (name != "..")) {
+      (void) unlink((path + "/" + name).c_str());
+    }
+  }
+
+  closedir(dir);
+  return (rmdir(path.c_str()) == 0);
+}
+
+//------------------------------------------------------------------------------
+// Copy all the records of a DB into a new DB of another type
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::MigrateDB(const std::string& src, StoreType src_type,
+                           const std::string& dst, StoreType dst_type)
+{
+  // Fill a temporary DB so that an interrupted migration is started over
+  std::string tmp = dst + ".migrating";
+  eos_notice("msg=\"migrating database\" src=%s dst=%s", src.c_str(),
+             dst.c_str());
+
+  if (!RemoveDbDir(tmp)) {
+    eos_err("msg=\"failed to remove incomplete migration\" path=%s errno=%d",
+            tmp.c_str(), errno);
+    return false;
+  }
+
+  std::unique_ptr<eos::common::DbMap> src_db(NewDbMap(src_type));
+  std::unique_ptr<eos::common::DbMap> dst_db(NewDbMap(dst_type));
+
+  if (!AttachDbMap(src_db.get(), src, src_type) ||
+      !AttachDbMap(dst_db.get(), tmp, dst_type)) {
+    return false;
+  }
+
+  const eos::common::DbMapTypes::Tkey* k;
+  const eos::common::DbMapTypes::Tval* v;
+  uint64_t num_copied = 0;
+  bool ok = true;
+  dst_db->beginSetSequence();
+
+  for (src_db->beginIter(); src_db->iterate(&k, &v);) {
+    dst_db->set(*k, v->value, v->comment);
+
+    if ((++num_copied % 10000) == 0) {
+      ok = (dst_db->endSetSequence() >= 0) && ok;
+      dst_db->beginSetSequence();
+    }
+  }
+
+  ok = (dst_db->endSetSequence() >= 0) && ok;
+  unsigned long long src_size = src_db->size();
+  unsigned long long dst_size = dst_db->size();
+  src_db->detachDb();
+  dst_db->detachDb();
+
+  if (!ok || (src_size != dst_size)) {
+    eos_err("msg=\"failed to migrate database\" src=%s dst=%s src_records=%llu "
+            "dst_records=%llu", src.c_str(), dst.c_str(), src_size, dst_size);
+    RemoveDbDir(tmp);
+    return false;
+  }
+
+  std::string old = src + ".migrated";
+
+  if (!RemoveDbDir(old) || rename(tmp.c_str(), dst.c_str()) ||
+      rename(src.c_str(), old.c_str())) {
+    eos_err("msg=\"failed to rename migrated database\" src=%s dst=%s "
+            "errno=%d", src.c_str(), dst.c_str(), errno);
+    return false;
+  }
+
+  eos_notice("msg=\"migrated database\" src=%s dst=%s records=%llu",
+             src.c_str(), dst.c_str(), dst_size);
+  return true;
+}
+
 //------------------------------------------------------------------------------
 // Set a new DB file for a filesystem id
 //------------------------------------------------------------------------------
 bool
-FmdDbMapHandler::SetDBFile(const char* meta_dir, int fsid)
+FmdDbMapHandler::SetDBFile(const char* meta_dir, int fsid, StoreType type)
 {
   bool is_attached = false;
   {
@@ -378,16 +594,22 @@ FmdDbMapHandler::SetDBFile(const char* meta_dir, int fsid)
     }
   }
 
-  char fsDBFileName[1024];
-  sprintf(fsDBFileName, "%s/fmd.%04d.%s", meta_dir, fsid,
-          eos::common::DbMap::getDbType().c_str());
-  eos_info("%s DB is now %s", eos::common::DbMap::getDbType().c_str(),
-           fsDBFileName);
+  StoreType other_type = ((type == StoreType::kSlot) ? StoreType::kLevelDb :
+                          StoreType::kSlot);
+  std::string db_name = GetDbFileName(meta_dir, fsid, type);
+  std::string other_name = GetDbFileName(meta_dir, fsid, other_type);
+  eos_info("DB is now %s", db_name.c_str());
   eos::common::RWMutexWriteLock wr_lock(mMapMutex);
   FsWriteLock wlock(fsid);
+  struct stat buf;
+
+  if (::stat(db_name.c_str(), &buf) && !::stat(other_name.c_str(), &buf) &&
+      !MigrateDB(other_name, other_type, db_name, type)) {
+    return false;
+  }
 
   if (!is_attached) {
-    auto result = mDbMap.insert(std::make_pair(fsid, new eos::common::DbMap()));
+    auto result = mDbMap.insert(std::make_pair(fsid, NewDbMap(type)));
 
     if (result.second == false) {
       eos_err("msg=\"failed to insert new db in map, fsid=%lli", fsid);
@@ -395,23 +617,12 @@ FmdDbMapHandler::SetDBFile(const char* meta_dir, int fsid)
     }
   }
 
-  // Create / or attach the db (try to repair if needed)
-  eos::common::LvDbDbMapInterface::Option* dbopt = &lvdboption;
-
-  // If we have not set the leveldb option, use the default (currently, bloom
-  // filter 10 bits and 100MB cache)
-  if (lvdboption.BloomFilterNbits == 0) {
-    dbopt = NULL;
-  }
-
-  if (!mDbMap[fsid]->attachDb(fsDBFileName, true, 0, dbopt)) {
-    eos_static_err("failed to attach %s database file %s",
-                   eos::common::DbMap::getDbType().c_str(), fsDBFileName);
+  if (!AttachDbMap(mDbMap[fsid], db_name, type)) {
     return false;
-  } else {
-    mDbMap[fsid]->outOfCore(true);
   }
 
+  mDbMap[fsid]->setSyncSetSequence(GetBatchState(fsid)->mMode ==
+                                   CommitMode::kBatchSync);
   return true;
 }
 
@@ -430,6 +641,8 @@ FmdDbMapHandler::ShutdownDB(eos::common::FileSystem::fsid_t fsid, bool do_lock)
   }
 
   if (mDbMap.count(fsid)) {
+    DoFlushBatch(fsid, GetBatchState(fsid));
+
     if (mDbMap[fsid]->detachDb()) {
       delete mDbMap[fsid];
       mDbMap.erase(fsid);
@@ -608,6 +821,84 @@ FmdDbMapHandler::LocalDeleteFmd(eos::common::FileId::fileid_t fid,
   return rc;
 }
 
+//------------------------------------------------------------------------------
+// Delete the records associated with several fids in one write
+//------------------------------------------------------------------------------
+size_t
+FmdDbMapHandler::LocalDeleteFmds(const
+                                 std::vector<eos::common::FileId::fileid_t>& fids,
+                                 eos::common::FileSystem::fsid_t fsid)
+{
+  size_t ndeleted = 0;
+  eos::common::RWMutexReadLock lock(mMapMutex);
+  FsWriteLock wlock(fsid);
+
+  if (!mDbMap.count(fsid)) {
+    eos_crit("no %s DB open for fsid=%llu", eos::common::DbMap::getDbType().c_str(),
+             (unsigned long) fsid);
+    return 0;
+  }
+
+  // Don't nest into an open commit batch
+  DoFlushBatch(fsid, GetBatchState(fsid));
+  mDbMap[fsid]->beginSetSequence();
+
+  for (auto fid : fids) {
+    if (LocalExistFmd(fid, fsid)) {
+      if (mDbMap[fsid]->remove(eos::common::Slice((const char*)&fid,
+                               sizeof(fid))) < 0) {
+        eos_err("unable to delete fid=%08llx from fst table", fid);
+      } else {
+        ++ndeleted;
+      }
+    }
+  }
+
+  if (mDbMap[fsid]->endSetSequence() == (unsigned long) - 1) {
+    eos_err("msg=\"failed to write deletion batch\" fsid=%u", fsid);
+    return 0;
+  }
+
+  return ndeleted;
+}
+
+//------------------------------------------------------------------------------
+// Get the time of the last checksum scan of a file
+//------------------------------------------------------------------------------
+unsigned long
+FmdDbMapHandler::LocalGetCheckTime(eos::common::FileId::fileid_t fid,
+                                   eos::common::FileSystem::fsid_t fsid)
+{
+  eos::common::RWMutexReadLock lock(mMapMutex);
+  FsReadLock rlock(fsid);
+
+  if (!LocalExistFmd(fid, fsid)) {
+    return 0;
+  }
+
+  return LocalRetrieveFmd(fid, fsid).checktime();
+}
+
+//------------------------------------------------------------------------------
+// Update the time of the last checksum scan of an existing record
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::LocalUpdateCheckTime(eos::common::FileId::fileid_t fid,
+                                      eos::common::FileSystem::fsid_t fsid,
+                                      unsigned long checktime)
+{
+  eos::common::RWMutexReadLock lock(mMapMutex);
+  FsWriteLock wlock(fsid);
+
+  if (!LocalExistFmd(fid, fsid)) {
+    return false;
+  }
+
+  Fmd valfmd = LocalRetrieveFmd(fid, fsid);
+  valfmd.set_checktime(checktime);
+  return LocalPutFmd(fid, fsid, valfmd);
+}
+
 //------------------------------------------------------------------------------
 // Commit modified Fmd record to the DB file
 //------------------------------------------------------------------------------
@@ -628,20 +919,34 @@ FmdDbMapHandler::Commit(FmdHelper* fmd, bool lockit)
   fmd->mProtoFmd.set_mtime_ns(tv.tv_usec * 1000);
   fmd->mProtoFmd.set_atime_ns(tv.tv_usec * 1000);
 
+  int64_t start_us = GetSteadyTimeUs();
+  BatchState* batch = GetBatchState(fsid);
+
   if (lockit) {
     mMapMutex.LockRead();
     FsLockWrite(fsid);
   }
 
   if (mDbMap.count(fsid)) {
+    if ((batch->mMode != CommitMode::kDirect) && !batch->mOpenSince) {
+      mDbMap[fsid]->beginSetSequence();
+      batch->mOpenSince = GetSteadyTimeUs();
+    }
+
     bool res = LocalPutFmd(fid, fsid, fmd->mProtoFmd);
 
+    if (batch->mOpenSince && (++batch->mPending >= GetBatchMaxRecords())) {
+      DoFlushBatch(fsid, batch);
+    }
+
     // Updateed in-memory
     if (lockit) {
       FsUnlockWrite(fsid);
       mMapMutex.UnLockRead();
     }
 
+    ++batch->mCommits;
+    batch->mCommitUs += GetSteadyTimeUs() - start_us;
     return res;
   } else {
     eos_crit("no %s DB open for fsid=%llu", eos::common::DbMap::getDbType().c_str(),
@@ -656,6 +961,172 @@ FmdDbMapHandler::Commit(FmdHelper* fmd, bool lockit)
   return false;
 }
 
+//------------------------------------------------------------------------------
+// Convert string to commit mode
+//------------------------------------------------------------------------------
+FmdDbMapHandler::CommitMode
+FmdDbMapHandler::GetCommitModeFromString(const std::string& mode)
+{
+  if (mode == "batch") {
+    return CommitMode::kBatch;
+  } else if (mode == "batchsync") {
+    return CommitMode::kBatchSync;
+  }
+
+  return CommitMode::kDirect;
+}
+
+//------------------------------------------------------------------------------
+// Set the commit mode of a filesystem
+//------------------------------------------------------------------------------
+void
+FmdDbMapHandler::SetCommitMode(eos::common::FileSystem::fsid_t fsid,
+                               CommitMode mode)
+{
+  {
+    eos::common::RWMutexReadLock lock(mMapMutex);
+    FsWriteLock wlock(fsid);
+    BatchState* batch = GetBatchState(fsid);
+
+    if (batch->mMode == mode) {
+      return;
+    }
+
+    if (mDbMap.count(fsid)) {
+      DoFlushBatch(fsid, batch);
+      mDbMap[fsid]->setSyncSetSequence(mode == CommitMode::kBatchSync);
+    }
+
+    batch->mMode = mode;
+  }
+
+  eos_info("msg=\"update commit mode\" fsid=%u mode=%s", fsid,
+           ((mode == CommitMode::kBatchSync) ? "batchsync" :
+            ((mode == CommitMode::kBatch) ? "batch" : "direct")));
+
+  if (mode != CommitMode::kDirect) {
+    std::lock_guard<std::mutex> lock(mBatchMutex);
+
+    if (!mFlushRunning) {
+      mFlushThread.reset(&FmdDbMapHandler::FlushExpiredBatches, this);
+      mFlushThread.setName("FmdBatchFlusher");
+      mFlushRunning = true;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Write the pending batch of a filesystem to the local database
+//------------------------------------------------------------------------------
+void
+FmdDbMapHandler::FlushBatch(eos::common::FileSystem::fsid_t fsid)
+{
+  eos::common::RWMutexReadLock lock(mMapMutex);
+  FsWriteLock wlock(fsid);
+
+  if (mDbMap.count(fsid)) {
+    DoFlushBatch(fsid, GetBatchState(fsid));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the commit statistics accumulated since the previous call
+//------------------------------------------------------------------------------
+FmdDbMapHandler::CommitStats
+FmdDbMapHandler::CollectCommitStats(eos::common::FileSystem::fsid_t fsid)
+{
+  BatchState* batch = GetBatchState(fsid);
+  CommitStats stats;
+  stats.mCommits = batch->mCommits.exchange(0);
+  uint64_t commit_us = batch->mCommitUs.exchange(0);
+  uint64_t flushes = batch->mFlushes.exchange(0);
+  uint64_t records = batch->mFlushedRecords.exchange(0);
+  uint64_t flush_us = batch->mFlushUs.exchange(0);
+  stats.mCommitLatency = (stats.mCommits ? (commit_us / 1000.0 / stats.mCommits) :
+                          0.0);
+  // Without batching every commit is written on its own
+  stats.mBatchSize = (flushes ? (1.0 * records / flushes) :
+                      (stats.mCommits ? 1.0 : 0.0));
+  stats.mFlushLatency = (flushes ? (flush_us / 1000.0 / flushes) : 0.0);
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Get the batch state of a filesystem
+//------------------------------------------------------------------------------
+FmdDbMapHandler::BatchState*
+FmdDbMapHandler::GetBatchState(eos::common::FileSystem::fsid_t fsid)
+{
+  std::lock_guard<std::mutex> lock(mBatchMutex);
+  auto& batch = mBatches[fsid];
+
+  if (!batch) {
+    batch.reset(new BatchState());
+  }
+
+  return batch.get();
+}
+
+//------------------------------------------------------------------------------
+// Write the open batch of a filesystem
+//------------------------------------------------------------------------------
+void
+FmdDbMapHandler::DoFlushBatch(eos::common::FileSystem::fsid_t fsid,
+                              BatchState* batch)
+{
+  if (!batch->mOpenSince) {
+    return;
+  }
+
+  int64_t start_us = GetSteadyTimeUs();
+  unsigned long nrecords = mDbMap[fsid]->endSetSequence();
+  int64_t flush_us = GetSteadyTimeUs() - start_us;
+
+  if (nrecords == (unsigned long) - 1) {
+    eos_err("msg=\"failed to write batch\" fsid=%u records=%llu", fsid,
+            batch->mPending);
+  } else {
+    ++batch->mFlushes;
+    batch->mFlushedRecords += nrecords;
+    batch->mFlushUs += flush_us;
+  }
+
+  batch->mPending = 0;
+  batch->mOpenSince = 0;
+}
+
+//------------------------------------------------------------------------------
+// Loop writing the batches which are pending for longer than the delay
+//------------------------------------------------------------------------------
+void
+FmdDbMapHandler::FlushExpiredBatches(ThreadAssistant& assistant) noexcept
+{
+  const int64_t delay_us = GetBatchDelayUs();
+  std::vector<eos::common::FileSystem::fsid_t> expired;
+
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(std::chrono::microseconds(std::max(delay_us / 4,
+                       (int64_t) 1000)));
+    expired.clear();
+    {
+      std::lock_guard<std::mutex> lock(mBatchMutex);
+      int64_t now_us = GetSteadyTimeUs();
+
+      for (const auto& elem : mBatches) {
+        int64_t open_since = elem.second->mOpenSince;
+
+        if (open_since && (now_us - open_since >= delay_us)) {
+          expired.push_back(elem.first);
+        }
+      }
+    }
+
+    for (auto fsid : expired) {
+      FlushBatch(fsid);
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 // Update fmd from disk i.e. physical file extended attributes
 //------------------------------------------------------------------------------
@@ -783,6 +1254,7 @@ FmdDbMapHandler::ResetDiskInformation(eos::common::FileSystem::fsid_t fsid)
     const eos::common::DbMapTypes::Tkey* k;
     const eos::common::DbMapTypes::Tval* v;
     eos::common::DbMapTypes::Tval val;
+    DoFlushBatch(fsid, GetBatchState(fsid));
     mDbMap[fsid]->beginSetSequence();
     unsigned long cpt = 0;
 
@@ -827,6 +1299,7 @@ FmdDbMapHandler::ResetMgmInformation(eos::common::FileSystem::fsid_t fsid)
     const eos::common::DbMapTypes::Tkey* k;
     const eos::common::DbMapTypes::Tval* v;
     eos::common::DbMapTypes::Tval val;
+    DoFlushBatch(fsid, GetBatchState(fsid));
     mDbMap[fsid]->beginSetSequence();
     unsigned long cpt = 0;
 
@@ -1186,7 +1659,8 @@ FmdDbMapHandler::ResyncAllMgm(eos::common::FileSystem::fsid_t fsid,
 //------------------------------------------------------------------------------
 bool
 FmdDbMapHandler::ResyncAllFromQdb(const QdbContactDetails& contactDetails,
-                                  eos::common::FileSystem::fsid_t fsid)
+                                  eos::common::FileSystem::fsid_t fsid,
+                                  std::function<void(uint64_t, uint64_t)> progress)
 {
   using namespace std::chrono;
 
@@ -1195,113 +1669,250 @@ FmdDbMapHandler::ResyncAllFromQdb(const QdbContactDetails& contactDetails,
     return false;
   }
 
-  // Collect all file ids on the desired file system
-  std::string cursor = "0";
-  long long count = 250000;
-  std::pair<std::string, std::vector<std::string>> reply;
   std::unique_ptr<qclient::QClient>
   qcl(new qclient::QClient(contactDetails.members,
                            contactDetails.constructOptions()));
   qclient::QSet qset(*qcl.get(),  eos::RequestBuilder::keyFilesystemFiles(fsid));
-  std::unordered_set<eos::IFileMD::id_t> file_ids;
+  uint64_t total = 0;
 
   try {
-    do {
-      reply = qset.sscan(cursor, count);
-      cursor = reply.first;
-
-      for (const auto& elem : reply.second) {
-        file_ids.insert(std::stoull(elem));
-      }
-    } while (cursor != "0");
+    total = qset.size();
   } catch (const std::runtime_error& e) {
     // It means there are no records for the current file system
   }
 
+  const uint32_t num_workers = GetQdbResyncWorkers();
+  const size_t batch_size = 1000;
+  eos_info("resyncing %llu files for file_system %u with %u workers", total,
+           fsid, num_workers);
+  // Batches of file ids streamed from the set and consumed by the workers
+  std::mutex mutex;
+  std::condition_variable cv_pop, cv_push;
+  std::deque<std::vector<eos::IFileMD::id_t>> batches;
+  bool walk_done = false;
+  std::atomic<uint64_t> num_files {0};
+  std::atomic<bool> failed {false};
   auto start = steady_clock::now();
-  uint64_t total = file_ids.size();
-  eos_info("resyncing %llu files for file_system %u", total, fsid);
-  uint64_t num_files = 0;
-  auto it = file_ids.begin();
-  std::list<folly::Future<eos::ns::FileMdProto>> files;
-
-  // Pre-fetch the first 1000 files
-  while ((it != file_ids.end()) && (num_files < 1000)) {
-    ++num_files;
-    files.emplace_back(MetadataFetcher::getFileFromId(*qcl.get(),
-                       FileIdentifier(*it)));
-    ++it;
-  }
-
-  while (!files.empty()) {
-    struct Fmd ns_fmd;
-    FmdHelper::Reset(ns_fmd);
-
-    try {
-      NsFileProtoToFmd(files.front().get(), ns_fmd);
-    } catch (const eos::MDException& e) {
-      eos_err("msg=\"failed to get metadata from QuarkDB: %s\"", e.what());
-      files.pop_front();
-      continue;
+  // Log the progress roughly every 10000 files
+  auto report = [&](uint64_t done, uint64_t prev) {
+    if (done / 10000 == prev / 10000) {
+      return;
     }
 
-    files.pop_front();
-    FmdHelper* local_fmd = LocalGetFmd(ns_fmd.fid(), fsid, ns_fmd.uid(),
-                                       ns_fmd.gid(), ns_fmd.lid(), true, true);
-    ns_fmd.set_layouterror(FmdHelper::LayoutError(ns_fmd, fsid));
+    double rate = 0;
+    auto ms = duration_cast<milliseconds>(steady_clock::now() - start);
 
-    if (local_fmd) {
-      // Check if it exists on disk
-      if (local_fmd->mProtoFmd.disksize() == 0xfffffffffff1ULL) {
-        ns_fmd.set_layouterror(ns_fmd.layouterror() | LayoutId::kMissing);
-        eos_warning("found missing replica for fid=%08llx on fsid=%lu",
-                    ns_fmd.fid(), (unsigned long) fsid);
+    if (ms.count()) {
+      rate = (done * 1000.0) / (double)ms.count();
+    }
+
+    eos_info("fsid=%u resynced %llu/%llu files at a rate of %.2f Hz",
+             fsid, done, total, rate);
+
+    if (progress) {
+      progress(done, total);
+    }
+  };
+  auto worker = [&]() {
+    while (true) {
+      std::vector<eos::IFileMD::id_t> ids;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv_pop.wait(lock, [&] { return !batches.empty() || walk_done; });
+
+        if (batches.empty()) {
+          return;
+        }
+
+        ids = std::move(batches.front());
+        batches.pop_front();
+      }
+      cv_push.notify_one();
+      // Send all the requests of the batch before waiting for any reply
+      std::vector<folly::Future<eos::ns::FileMdProto>> files;
+      files.reserve(ids.size());
+
+      for (const auto id : ids) {
+        files.emplace_back(MetadataFetcher::getFileFromId(*qcl.get(),
+                           FileIdentifier(id)));
       }
 
-      if (!UpdateFromMgm(fsid, ns_fmd.fid(), ns_fmd.cid(), ns_fmd.lid(),
-                         ns_fmd.mgmsize(), ns_fmd.mgmchecksum(), ns_fmd.uid(),
-                         ns_fmd.gid(), ns_fmd.ctime(), ns_fmd.ctime_ns(),
-                         ns_fmd.mtime(), ns_fmd.mtime_ns(),
-                         ns_fmd.layouterror(), ns_fmd.locations())) {
-        eos_err("failed to update fid %llu", ns_fmd.fid());
+      std::vector<Fmd> ns_fmds;
+      ns_fmds.reserve(files.size());
+
+      for (auto& file : files) {
+        struct Fmd ns_fmd;
+        FmdHelper::Reset(ns_fmd);
+
+        try {
+          NsFileProtoToFmd(file.get(), ns_fmd);
+        } catch (const eos::MDException& e) {
+          eos_err("msg=\"failed to get metadata from QuarkDB: %s\"", e.what());
+          continue;
+        }
+
+        ns_fmds.push_back(std::move(ns_fmd));
       }
 
-      delete local_fmd;
-    } else {
-      eos_err("failed to get/create local fid %llu", ns_fmd.fid());
+      if (!ApplyMgmBatch(fsid, ns_fmds)) {
+        failed = true;
+      }
+
+      uint64_t prev = num_files.fetch_add(ids.size());
+      report(prev + ids.size(), prev);
     }
+  };
+  std::vector<std::thread> workers;
 
-    if (it != file_ids.end()) {
-      ++num_files;
-      files.emplace_back(MetadataFetcher::getFileFromId(*qcl.get(),
-                         FileIdentifier(*it)));
-      ++it;
+  for (uint32_t i = 0; i < num_workers; ++i) {
+    workers.emplace_back(worker);
+  }
+
+  auto push_batch = [&](std::vector<eos::IFileMD::id_t>&& ids) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv_push.wait(lock, [&] { return batches.size() < 2 * num_workers; });
+      batches.push_back(std::move(ids));
     }
+    cv_pop.notify_one();
+  };
+  // Stream the file ids, duplicates returned by SSCAN are simply applied twice
+  std::string cursor = "0";
+  long long count = 10000;
+  std::pair<std::string, std::vector<std::string>> reply;
+  std::vector<eos::IFileMD::id_t> ids;
 
-    if (num_files % 10000 == 0) {
-      double rate = 0;
-      auto duration = steady_clock::now() - start;
-      auto ms = duration_cast<milliseconds>(duration);
+  try {
+    do {
+      reply = qset.sscan(cursor, count);
+      cursor = reply.first;
+
+      for (const auto& elem : reply.second) {
+        ids.push_back(std::stoull(elem));
 
-      if (ms.count()) {
-        rate = (num_files * 1000.0) / (double)ms.count();
+        if (ids.size() >= batch_size) {
+          push_batch(std::move(ids));
+          ids.clear();
+        }
       }
+    } while (cursor != "0");
+  } catch (const std::runtime_error& e) {
+    // It means there are no records for the current file system
+  }
 
-      eos_info("fsid=%u resynced %llu/%llu files at a rate of %.2f Hz",
-               fsid, num_files, total, rate);
-    }
+  if (!ids.empty()) {
+    push_batch(std::move(ids));
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    walk_done = true;
+  }
+  cv_pop.notify_all();
+
+  for (auto& th : workers) {
+    th.join();
   }
 
   double rate = 0;
-  auto duration = steady_clock::now() - start;
-  auto ms = duration_cast<milliseconds>(duration);
+  auto ms = duration_cast<milliseconds>(steady_clock::now() - start);
 
   if (ms.count()) {
     rate = (num_files * 1000.0) / (double)ms.count();
   }
 
   eos_info("fsid=%u resynced %llu/%llu files at a rate of %.2f Hz",
-           fsid, num_files, total, rate);
+           fsid, num_files.load(), total, rate);
+
+  if (progress) {
+    progress(num_files, std::max(total, num_files.load()));
+  }
+
+  return !failed;
+}
+
+//------------------------------------------------------------------------------
+// Apply a batch of records from the namespace to the local DB in one write
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::ApplyMgmBatch(eos::common::FileSystem::fsid_t fsid,
+                               std::vector<Fmd>& ns_fmds)
+{
+  eos::common::RWMutexReadLock lock(mMapMutex);
+  FsWriteLock wlock(fsid);
+
+  if (!mDbMap.count(fsid)) {
+    eos_crit("no %s DB open for fsid=%llu", eos::common::DbMap::getDbType().c_str(),
+             (unsigned long) fsid);
+    return false;
+  }
+
+  // Don't nest into an open commit batch
+  DoFlushBatch(fsid, GetBatchState(fsid));
+  struct timeval tv;
+  struct timezone tz;
+  gettimeofday(&tv, &tz);
+  mDbMap[fsid]->beginSetSequence();
+
+  for (auto& ns_fmd : ns_fmds) {
+    eos::common::FileId::fileid_t fid = ns_fmd.fid();
+
+    if (!fid) {
+      eos_info("skipping to insert a file with fid 0");
+      continue;
+    }
+
+    Fmd valfmd;
+
+    if (LocalExistFmd(fid, fsid)) {
+      valfmd = LocalRetrieveFmd(fid, fsid);
+    } else {
+      // Create a new record like LocalGetFmd does
+      FmdHelper::Reset(valfmd);
+      valfmd.set_fsid(fsid);
+      valfmd.set_fid(fid);
+      valfmd.set_atime(tv.tv_sec);
+      valfmd.set_atime_ns(tv.tv_usec * 1000);
+    }
+
+    int layouterror = FmdHelper::LayoutError(ns_fmd, fsid);
+
+    // Check if it exists on disk
+    if (valfmd.disksize() == 0xfffffffffff1ULL) {
+      layouterror |= LayoutId::kMissing;
+      eos_warning("found missing replica for fid=%08llx on fsid=%lu", fid,
+                  (unsigned long) fsid);
+    }
+
+    valfmd.set_mgmsize(ns_fmd.mgmsize());
+    valfmd.set_size(ns_fmd.mgmsize());
+    valfmd.set_cid(ns_fmd.cid());
+    valfmd.set_lid(ns_fmd.lid());
+    valfmd.set_uid(ns_fmd.uid());
+    valfmd.set_gid(ns_fmd.gid());
+    valfmd.set_ctime(ns_fmd.ctime());
+    valfmd.set_ctime_ns(ns_fmd.ctime_ns());
+    valfmd.set_mtime(ns_fmd.mtime());
+    valfmd.set_mtime_ns(ns_fmd.mtime_ns());
+    valfmd.set_layouterror(layouterror);
+    valfmd.set_locations(ns_fmd.locations());
+    // Truncate the checksum to the right string length
+    size_t cslen = LayoutId::GetChecksumLen(ns_fmd.lid()) * 2;
+    std::string checksum = ns_fmd.mgmchecksum();
+    checksum.erase(std::min(checksum.length(), cslen));
+    valfmd.set_mgmchecksum(checksum);
+    valfmd.set_checksum(checksum);
+
+    if (!LocalPutFmd(fid, fsid, valfmd)) {
+      eos_err("failed to update fid %llu", fid);
+    }
+  }
+
+  if (mDbMap[fsid]->endSetSequence() == (unsigned long) - 1) {
+    eos_err("msg=\"failed to write resync batch\" fsid=%u", fsid);
+    return false;
+  }
+
   return true;
 }
 
@@ -1318,6 +1929,8 @@ FmdDbMapHandler::RemoveGhostEntries(const char* path,
   std::vector<eos::common::FileId::fileid_t> to_delete;
 
   if (!IsSyncing(fsid)) {
+    // Pending records are not seen while iterating
+    FlushBatch(fsid);
     {
       eos::common::RWMutexReadLock rd_lock(mMapMutex);
       FsReadLock fs_rd_lock(fsid);
@@ -1388,6 +2001,8 @@ FmdDbMapHandler::GetInconsistencyStatistics(eos::common::FileSystem::fsid_t
     std::map<std::string, size_t>& statistics,
     std::map<std::string, std::set < eos::common::FileId::fileid_t> >& fidset)
 {
+  // Pending records are not seen while iterating
+  FlushBatch(fsid);
   eos::common::RWMutexReadLock lock(mMapMutex);
 
   if (!mDbMap.count(fsid)) {
@@ -1508,6 +2123,7 @@ FmdDbMapHandler::ResetDB(eos::common::FileSystem::fsid_t fsid)
   // Erase the hash entry
   if (mDbMap.count(fsid)) {
     FsWriteLock fs_wr_lock(fsid);
+    DoFlushBatch(fsid, GetBatchState(fsid));
 
     // Delete in the in-memory hash
     if (!mDbMap[fsid]->clear()) {
@@ -26,10 +26,16 @@
 #include "common/DbMap.hh"
 #include "common/FileId.hh"
 #include "common/LayoutId.hh"
+#include "common/AssistedThread.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
 #ifdef __APPLE__
 #define ECOMM 70
 #endif
@@ -52,6 +58,51 @@ EOSFSTNAMESPACE_BEGIN
 class FmdDbMapHandler : public eos::common::LogId
 {
 public:
+  //----------------------------------------------------------------------------
+  //! Modes used to commit the records of a filesystem to the local database
+  //----------------------------------------------------------------------------
+  enum class CommitMode {
+    kDirect, ///< every record is written on its own (default)
+    kBatch, ///< records are grouped and written after a bounded delay
+    kBatchSync ///< like kBatch but every group is synced to disk
+  };
+
+  //----------------------------------------------------------------------------
+  //! Commit statistics of a filesystem
+  //----------------------------------------------------------------------------
+  struct CommitStats {
+    uint64_t mCommits; ///< Number of committed records
+    double mCommitLatency; ///< Average time spent in Commit in ms
+    double mBatchSize; ///< Average number of records per written batch
+    double mFlushLatency; ///< Average time to write a batch in ms
+  };
+
+  //----------------------------------------------------------------------------
+  //! Types of local database storing the records of a filesystem
+  //----------------------------------------------------------------------------
+  enum class StoreType {
+    kLevelDb, ///< LevelDB database (default)
+    kSlot ///< memory-mapped slot file, see FmdSlotDbMapInterface
+  };
+
+  //----------------------------------------------------------------------------
+  //! Convert string to store type
+  //!
+  //! @param type "leveldb" or "slot"
+  //!
+  //! @return store type, kLevelDb for unknown values
+  //----------------------------------------------------------------------------
+  static StoreType GetStoreTypeFromString(const std::string& type);
+
+  //----------------------------------------------------------------------------
+  //! Convert string to commit mode
+  //!
+  //! @param mode "direct", "batch" or "batchsync"
+  //!
+  //! @return commit mode, kDirect for unknown values
+  //----------------------------------------------------------------------------
+  static CommitMode GetCommitModeFromString(const std::string& mode);
+
   //----------------------------------------------------------------------------
   //! Convert an FST env representation to an Fmd struct
   //!
@@ -115,14 +166,18 @@ public:
   }
 
   //----------------------------------------------------------------------------
-  //! Set a new DB file for a filesystem id
+  //! Set a new DB file for a filesystem id. If there is no DB of the given
+  //! type but one of the other type, its records are migrated and the old DB
+  //! is renamed to <name>.migrated.
   //!
   //! @param meta_dir meta data directory where to place the files
   //! @param fsid filesystem id identified by this file
+  //! @param type type of the DB
   //!
   //! @return true if successful, otherwise false
   //----------------------------------------------------------------------------
-  bool SetDBFile(const char* dbfile, int fsid);
+  bool SetDBFile(const char* dbfile, int fsid,
+                 StoreType type = StoreType::kLevelDb);
 
   //----------------------------------------------------------------------------
   //! Shutdown an open DB file
@@ -166,6 +221,42 @@ public:
   bool LocalDeleteFmd(eos::common::FileId::fileid_t fid,
                       eos::common::FileSystem::fsid_t fsid);
 
+  //----------------------------------------------------------------------------
+  //! Delete the records associated with several fids of filesystem fsid in
+  //! one write to the local database
+  //!
+  //! @param fids file ids
+  //! @param fsid filesystem id
+  //!
+  //! @return number of deleted records, the fids without record are skipped
+  //----------------------------------------------------------------------------
+  size_t LocalDeleteFmds(const std::vector<eos::common::FileId::fileid_t>& fids,
+                         eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Get the time of the last checksum scan of a file
+  //!
+  //! @param fid file id
+  //! @param fsid filesystem id
+  //!
+  //! @return check time in seconds, 0 if no record or never checked
+  //----------------------------------------------------------------------------
+  unsigned long LocalGetCheckTime(eos::common::FileId::fileid_t fid,
+                                  eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Update the time of the last checksum scan of an existing record
+  //!
+  //! @param fid file id
+  //! @param fsid filesystem id
+  //! @param checktime check time in seconds
+  //!
+  //! @return true if updated, false if the record does not exist
+  //----------------------------------------------------------------------------
+  bool LocalUpdateCheckTime(eos::common::FileId::fileid_t fid,
+                            eos::common::FileSystem::fsid_t fsid,
+                            unsigned long checktime);
+
   //----------------------------------------------------------------------------
   //! Commit modified Fmd record to the local database
   //!
@@ -175,6 +266,34 @@ public:
   //----------------------------------------------------------------------------
   bool Commit(FmdHelper* fmd, bool lockit = true);
 
+  //----------------------------------------------------------------------------
+  //! Set the commit mode of a filesystem. In the batch modes the records are
+  //! kept in a set sequence of the DB map, so they are visible to readers
+  //! right away, and written in one batch once EOS_FST_FMD_BATCH_DELAY_MS
+  //! elapsed or EOS_FST_FMD_BATCH_MAX records are pending. Records still
+  //! pending are lost if the FST crashes, in which case the boot resync or
+  //! the scanner fix them up.
+  //!
+  //! @param fsid filesystem id
+  //! @param mode commit mode
+  //----------------------------------------------------------------------------
+  void SetCommitMode(eos::common::FileSystem::fsid_t fsid, CommitMode mode);
+
+  //----------------------------------------------------------------------------
+  //! Write the pending batch of a filesystem to the local database
+  //!
+  //! @param fsid filesystem id
+  //----------------------------------------------------------------------------
+  void FlushBatch(eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Get the commit statistics of a filesystem accumulated since the
+  //! previous call
+  //!
+  //! @param fsid filesystem id
+  //----------------------------------------------------------------------------
+  CommitStats CollectCommitStats(eos::common::FileSystem::fsid_t fsid);
+
   //----------------------------------------------------------------------------
   //! Update fmd from disk i.e. physical file extended attributes
   //!
@@ -289,15 +408,21 @@ public:
                     const char* manager);
 
   //----------------------------------------------------------------------------
-  //! Resync all meta data from QuarkdDB
+  //! Resync all meta data from QuarkdDB. The file ids of the filesystem are
+  //! streamed with SSCAN and handed in batches to EOS_FST_QDB_RESYNC_WORKERS
+  //! threads (default 4) which fetch the file metadata of a batch in one
+  //! pipeline and apply it to the local DB in one write.
   //!
   //! @param qdb_members members of the QDB cluster
   //! @param fsid filesystem id
+  //! @param progress called with the number of files done and the total
+  //!        number of files, from the worker threads
   //!
   //! @return true if successful, otherwise false
   //----------------------------------------------------------------------------
   bool ResyncAllFromQdb(const QdbContactDetails& contactDetails,
-                        eos::common::FileSystem::fsid_t fsid);
+                        eos::common::FileSystem::fsid_t fsid,
+                        std::function<void(uint64_t, uint64_t)> progress = nullptr);
 
   //----------------------------------------------------------------------------
   //! Remove ghost entries - entries which are neither on disk nor ath the MGM
@@ -377,6 +502,13 @@ public:
   void
   Shutdown()
   {
+    // Pending batches are written by ShutdownDB
+    mFlushThread.join();
+    {
+      std::lock_guard<std::mutex> lock(mBatchMutex);
+      mFlushRunning = false;
+    }
+
     while (!mDbMap.empty()) {
       ShutdownDB(mDbMap.begin()->first);
     }
@@ -411,6 +543,94 @@ private:
   mFsMtxMap;
   eos::common::RWMutex mFsMtxMapMutex; ///< Mutex protecting the previous map
 
+  //----------------------------------------------------------------------------
+  //! Batch commit state of a filesystem, the mode and the pending counter are
+  //! protected by the filesystem write lock
+  //----------------------------------------------------------------------------
+  struct BatchState {
+    CommitMode mMode {CommitMode::kDirect}; ///< Commit mode
+    uint64_t mPending {0}; ///< Records committed in the open batch
+    ///< Time in us when the open batch started, 0 if no batch is open
+    std::atomic<int64_t> mOpenSince {0};
+    std::atomic<uint64_t> mCommits {0}; ///< Committed records
+    std::atomic<uint64_t> mCommitUs {0}; ///< Time spent in Commit
+    std::atomic<uint64_t> mFlushes {0}; ///< Written batches
+    std::atomic<uint64_t> mFlushedRecords {0}; ///< Records in written batches
+    std::atomic<uint64_t> mFlushUs {0}; ///< Time spent writing batches
+  };
+
+  std::mutex mBatchMutex; ///< Mutex protecting the map and flag below
+  std::map<eos::common::FileSystem::fsid_t, std::unique_ptr<BatchState>>
+      mBatches;
+  bool mFlushRunning {false}; ///< True if the flush thread was started
+  AssistedThread mFlushThread; ///< Thread writing the expired batches
+
+  //----------------------------------------------------------------------------
+  //! Get the batch state of a filesystem, created if it does not exist
+  //!
+  //! @param fsid filesystem id
+  //----------------------------------------------------------------------------
+  BatchState* GetBatchState(eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Create an unattached DB map of the given type
+  //----------------------------------------------------------------------------
+  static eos::common::DbMap* NewDbMap(StoreType type);
+
+  //----------------------------------------------------------------------------
+  //! Attach a DB map to its files and switch it to out-of-core mode
+  //!
+  //! @param db DB map created by NewDbMap
+  //! @param db_name DB file name
+  //! @param type type of the DB
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool AttachDbMap(eos::common::DbMap* db, const std::string& db_name,
+                   StoreType type);
+
+  //----------------------------------------------------------------------------
+  //! Copy all the records of a DB into a new DB of another type, the source
+  //! is renamed to <src>.migrated once the destination is complete
+  //!
+  //! @param src source DB file name
+  //! @param src_type type of the source DB
+  //! @param dst destination DB file name, must not exist
+  //! @param dst_type type of the destination DB
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool MigrateDB(const std::string& src, StoreType src_type,
+                 const std::string& dst, StoreType dst_type);
+
+  //----------------------------------------------------------------------------
+  //! Write the open batch of a filesystem if there is any
+  //!
+  //! @param fsid filesystem id
+  //! @param batch batch state of the filesystem
+  //! @note this function must be called with the mMapMutex locked and also the
+  //! mutex corresponding to the filesystem write locked
+  //----------------------------------------------------------------------------
+  void DoFlushBatch(eos::common::FileSystem::fsid_t fsid, BatchState* batch);
+
+  //----------------------------------------------------------------------------
+  //! Apply a batch of records from the namespace to the local DB in one write
+  //!
+  //! @param fsid filesystem id
+  //! @param ns_fmds records built from the namespace file metadata
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool ApplyMgmBatch(eos::common::FileSystem::fsid_t fsid,
+                     std::vector<Fmd>& ns_fmds);
+
+  //----------------------------------------------------------------------------
+  //! Loop writing the batches which are pending for longer than the delay
+  //!
+  //! @param assistant thread running the loop
+  //----------------------------------------------------------------------------
+  void FlushExpiredBatches(ThreadAssistant& assistant) noexcept;
+
   //----------------------------------------------------------------------------
   //! Lock mutex corresponding to the given file systemd id
   //!
@@ -533,8 +753,9 @@ private:
   {
     std::string sval;
     fmd.SerializePartialToString(&sval);
+    // In a set sequence the number of buffered entries is returned
     return mDbMap[fsid]->set(eos::common::Slice((const char*)&fid, sizeof(fid)),
-                             sval, "") == 0;
+                             sval, "") >= 0;
   }
 
   //----------------------------------------------------------------------------
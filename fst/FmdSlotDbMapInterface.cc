@@ -0,0 +1,1285 @@
+//------------------------------------------------------------------------------
+//! @file FmdSlotDbMapInterface.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/FmdSlotDbMapInterface.hh"
+#include "proto/FmdBase.pb.h"
+#include "common/Logging.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+EOSFSTNAMESPACE_BEGIN
+
+constexpr uint32_t FmdSlotDbMapInterface::kSlotsPerPage;
+constexpr uint32_t FmdSlotDbMapInterface::kSlotSize;
+constexpr uint32_t FmdSlotDbMapInterface::kPageSize;
+constexpr uint32_t FmdSlotDbMapInterface::kChunkSize;
+constexpr uint64_t FmdSlotDbMapInterface::kJournalMaxSize;
+
+namespace
+{
+const char sFileMagic[8] = {'E', 'O', 'S', 'F', 'M', 'D', 'S', 'L'};
+const uint32_t sVersion = 1;
+const uint64_t sHeaderSize = 4096;
+const uint64_t sPageMagic = 0x45474150444d4645ull;
+const uint32_t sPageHeaderSize = 256;
+const uint32_t sJournalMagic = 0x4c4e524a;
+const uint64_t sMinMapLength = 64 * 1024 * 1024;
+const uint32_t sUsed = 0x1;
+const uint32_t sOverflow = 0x2;
+const int sNumStrings = 4;
+
+//------------------------------------------------------------------------------
+//! Header at the beginning of the slot file
+//------------------------------------------------------------------------------
+struct FileHeader {
+  char mMagic[8];
+  uint32_t mVersion;
+  uint32_t mSlotSize;
+  uint32_t mSlotsPerPage;
+  uint32_t mPageSize;
+  uint32_t mChunkSize;
+  uint32_t mPad;
+};
+
+//------------------------------------------------------------------------------
+//! Header of a page, the page key is fid / kSlotsPerPage
+//------------------------------------------------------------------------------
+struct PageHeader {
+  uint64_t mMagic;
+  uint64_t mKey;
+  uint32_t mCrc;
+  uint32_t mPad;
+};
+
+//------------------------------------------------------------------------------
+//! Overflow chunk holding the strings of a record
+//------------------------------------------------------------------------------
+struct Chunk {
+  uint32_t mCrc;
+  uint32_t mPad;
+  uint64_t mFid;
+  uint16_t mStrLen[sNumStrings];
+  char mStr[FmdSlotDbMapInterface::kChunkSize - 24];
+};
+
+//------------------------------------------------------------------------------
+//! Header of a journal entry, followed by the serialized record
+//------------------------------------------------------------------------------
+struct JournalHeader {
+  uint32_t mMagic;
+  uint32_t mOp;
+  uint64_t mFid;
+  uint32_t mLength;
+  uint32_t mCrc;
+};
+
+static_assert(sizeof(Chunk) == FmdSlotDbMapInterface::kChunkSize,
+              "wrong chunk size");
+static_assert(sizeof(JournalHeader) == 24, "wrong journal header size");
+
+//------------------------------------------------------------------------------
+// Checksum of a buffer, skipping the leading crc field
+//------------------------------------------------------------------------------
+uint32_t
+ComputeCrc(const void* ptr, size_t len)
+{
+  const Bytef* buf = static_cast<const Bytef*>(ptr) + sizeof(uint32_t);
+  return crc32(0, buf, len - sizeof(uint32_t));
+}
+
+//------------------------------------------------------------------------------
+// Checksum of a journal entry
+//------------------------------------------------------------------------------
+uint32_t
+ComputeJournalCrc(const JournalHeader& hdr, const char* value)
+{
+  uLong crc = crc32(0, reinterpret_cast<const Bytef*>(&hdr.mOp),
+                    offsetof(JournalHeader, mCrc) - offsetof(JournalHeader, mOp));
+  return crc32(crc, reinterpret_cast<const Bytef*>(value), hdr.mLength);
+}
+
+//------------------------------------------------------------------------------
+// Write a full buffer at an offset
+//------------------------------------------------------------------------------
+bool
+PwriteAll(int fd, const char* buf, size_t len, off_t off)
+{
+  while (len) {
+    ssize_t nwrite = ::pwrite(fd, buf, len, off);
+
+    if (nwrite < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return false;
+    }
+
+    buf += nwrite;
+    len -= nwrite;
+    off += nwrite;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Read a full buffer at an offset
+//------------------------------------------------------------------------------
+bool
+PreadAll(int fd, char* buf, size_t len, off_t off)
+{
+  while (len) {
+    ssize_t nread = ::pread(fd, buf, len, off);
+
+    if (nread < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return false;
+    }
+
+    if (nread == 0) {
+      return false;
+    }
+
+    buf += nread;
+    len -= nread;
+    off += nread;
+  }
+
+  return true;
+}
+}
+
+//------------------------------------------------------------------------------
+//! Slot holding the fixed-size fields of a record and its strings if they
+//! fit, otherwise mChunk is the overflow chunk holding them
+//------------------------------------------------------------------------------
+struct FmdSlotDbMapInterface::Slot {
+  uint32_t mCrc;
+  uint32_t mFlags;
+  uint64_t mFid;
+  uint64_t mCid;
+  uint64_t mSize;
+  uint64_t mDiskSize;
+  uint64_t mMgmSize;
+  int64_t mFileCxError;
+  int64_t mBlockCxError;
+  int64_t mLayoutError;
+  uint32_t mFsid;
+  uint32_t mCtime;
+  uint32_t mCtimeNs;
+  uint32_t mMtime;
+  uint32_t mMtimeNs;
+  uint32_t mAtime;
+  uint32_t mAtimeNs;
+  uint32_t mCheckTime;
+  uint32_t mLid;
+  uint32_t mUid;
+  uint32_t mGid;
+  uint16_t mStrLen[sNumStrings];
+  uint32_t mChunk;
+  char mStr[64];
+};
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FmdSlotDbMapInterface::FmdSlotDbMapInterface()
+{
+  static_assert(sizeof(Slot) == kSlotSize, "wrong slot size");
+  static_assert(sPageHeaderSize + kSlotsPerPage * kSlotSize == kPageSize,
+                "wrong page geometry");
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+FmdSlotDbMapInterface::~FmdSlotDbMapInterface()
+{
+  detachDb();
+}
+
+//------------------------------------------------------------------------------
+// Get a page in the mapped file
+//------------------------------------------------------------------------------
+char*
+FmdSlotDbMapInterface::GetPage(uint32_t idx) const
+{
+  return mBase + sHeaderSize + (uint64_t) idx * kPageSize;
+}
+
+//------------------------------------------------------------------------------
+// Get the slot of a file id
+//------------------------------------------------------------------------------
+const FmdSlotDbMapInterface::Slot*
+FmdSlotDbMapInterface::GetSlot(uint64_t fid) const
+{
+  auto it = mPages.find(fid / kSlotsPerPage);
+
+  if (it == mPages.end()) {
+    return nullptr;
+  }
+
+  return reinterpret_cast<const Slot*>(GetPage(it->second) + sPageHeaderSize +
+                                       (fid % kSlotsPerPage) * kSlotSize);
+}
+
+FmdSlotDbMapInterface::Slot*
+FmdSlotDbMapInterface::GetSlot(uint64_t fid, bool create)
+{
+  uint64_t page_key = fid / kSlotsPerPage;
+  auto it = mPages.find(page_key);
+  int64_t idx;
+
+  if (it != mPages.end()) {
+    idx = it->second;
+  } else {
+    if (!create) {
+      return nullptr;
+    }
+
+    idx = AllocPage(page_key);
+
+    if (idx < 0) {
+      return nullptr;
+    }
+  }
+
+  return reinterpret_cast<Slot*>(GetPage(idx) + sPageHeaderSize +
+                                 (fid % kSlotsPerPage) * kSlotSize);
+}
+
+//------------------------------------------------------------------------------
+// Map the slot file for at least the given size
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::MapSlots(uint64_t min_length)
+{
+  if (min_length <= mMapLength) {
+    return true;
+  }
+
+  // Map more than the file size so that the file can grow without remapping
+  uint64_t length = std::max(std::max(min_length, 2 * mMapLength),
+                             sMinMapLength);
+
+  if (mBase) {
+    munmap(mBase, mMapLength);
+    mBase = nullptr;
+    mMapLength = 0;
+  }
+
+  void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   mSlotFd, 0);
+
+  if (ptr == MAP_FAILED) {
+    eos_static_err("msg=\"failed to map slot file\" db=%s errno=%d",
+                   mDbName.c_str(), errno);
+    return false;
+  }
+
+  mBase = static_cast<char*>(ptr);
+  mMapLength = length;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Allocate a page for a key
+//------------------------------------------------------------------------------
+int64_t
+FmdSlotDbMapInterface::AllocPage(uint64_t page_key)
+{
+  uint32_t idx;
+
+  if (!mFreePages.empty()) {
+    idx = mFreePages.back();
+    mFreePages.pop_back();
+    memset(GetPage(idx), 0, kPageSize);
+  } else {
+    idx = mNumPages;
+    uint64_t length = sHeaderSize + (uint64_t)(idx + 1) * kPageSize;
+
+    if (ftruncate(mSlotFd, length) || !MapSlots(length)) {
+      eos_static_err("msg=\"failed to extend slot file\" db=%s errno=%d",
+                     mDbName.c_str(), errno);
+      return -1;
+    }
+
+    ++mNumPages;
+  }
+
+  PageHeader* hdr = reinterpret_cast<PageHeader*>(GetPage(idx));
+  hdr->mMagic = sPageMagic;
+  hdr->mKey = page_key;
+  hdr->mCrc = crc32(0, reinterpret_cast<const Bytef*>(hdr),
+                    offsetof(PageHeader, mCrc));
+  mPages[page_key] = idx;
+  mPageKeys.insert(page_key);
+  return idx;
+}
+
+//------------------------------------------------------------------------------
+// Convert a slot to a record
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::SlotToFmd(const Slot* slot, FmdBase& fmd) const
+{
+  Chunk chunk;
+  const char* str = slot->mStr;
+  const uint16_t* len = slot->mStrLen;
+
+  if (slot->mFlags & sOverflow) {
+    if (!PreadAll(mOverflowFd, reinterpret_cast<char*>(&chunk), sizeof(chunk),
+                  (off_t) slot->mChunk * kChunkSize) ||
+        (chunk.mCrc != ComputeCrc(&chunk, sizeof(chunk))) ||
+        (chunk.mFid != slot->mFid)) {
+      eos_static_err("msg=\"invalid overflow chunk\" db=%s fid=%llu chunk=%u",
+                     mDbName.c_str(), (unsigned long long) slot->mFid,
+                     slot->mChunk);
+      return false;
+    }
+
+    str = chunk.mStr;
+    len = chunk.mStrLen;
+  }
+
+  fmd.Clear();
+  fmd.set_fid(slot->mFid);
+  fmd.set_cid(slot->mCid);
+  fmd.set_fsid(slot->mFsid);
+  fmd.set_ctime(slot->mCtime);
+  fmd.set_ctime_ns(slot->mCtimeNs);
+  fmd.set_mtime(slot->mMtime);
+  fmd.set_mtime_ns(slot->mMtimeNs);
+  fmd.set_atime(slot->mAtime);
+  fmd.set_atime_ns(slot->mAtimeNs);
+  fmd.set_checktime(slot->mCheckTime);
+  fmd.set_size(slot->mSize);
+  fmd.set_disksize(slot->mDiskSize);
+  fmd.set_mgmsize(slot->mMgmSize);
+  fmd.set_checksum(str, len[0]);
+  str += len[0];
+  fmd.set_diskchecksum(str, len[1]);
+  str += len[1];
+  fmd.set_mgmchecksum(str, len[2]);
+  str += len[2];
+  fmd.set_lid(slot->mLid);
+  fmd.set_uid(slot->mUid);
+  fmd.set_gid(slot->mGid);
+  fmd.set_filecxerror(slot->mFileCxError);
+  fmd.set_blockcxerror(slot->mBlockCxError);
+  fmd.set_layouterror(slot->mLayoutError);
+  fmd.set_locations(str, len[3]);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Store a record in its slot and if needed in an overflow chunk
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::ApplySet(uint64_t fid, const std::string& value)
+{
+  FmdBase fmd;
+
+  if (!fmd.ParseFromString(value)) {
+    eos_static_err("msg=\"failed to parse record\" db=%s fid=%llu",
+                   mDbName.c_str(), (unsigned long long) fid);
+    return false;
+  }
+
+  const std::string* strs[sNumStrings] = {
+    &fmd.checksum(), &fmd.diskchecksum(), &fmd.mgmchecksum(), &fmd.locations()
+  };
+  Slot rec;
+  memset(&rec, 0, sizeof(rec));
+  size_t total = 0;
+
+  for (int i = 0; i < sNumStrings; ++i) {
+    rec.mStrLen[i] = strs[i]->length();
+    total += strs[i]->length();
+  }
+
+  if (total > sizeof(Chunk::mStr)) {
+    eos_static_err("msg=\"record too large for the slot store\" db=%s "
+                   "fid=%llu length=%zu", mDbName.c_str(),
+                   (unsigned long long) fid, total);
+    return false;
+  }
+
+  Slot* slot = GetSlot(fid, true);
+
+  if (!slot) {
+    return false;
+  }
+
+  bool was_used = (slot->mFlags & sUsed);
+  bool had_chunk = was_used && (slot->mFlags & sOverflow);
+  uint32_t old_chunk = slot->mChunk;
+  rec.mFlags = sUsed;
+  rec.mFid = fid;
+  rec.mCid = fmd.cid();
+  rec.mSize = fmd.size();
+  rec.mDiskSize = fmd.disksize();
+  rec.mMgmSize = fmd.mgmsize();
+  rec.mFileCxError = fmd.filecxerror();
+  rec.mBlockCxError = fmd.blockcxerror();
+  rec.mLayoutError = fmd.layouterror();
+  rec.mFsid = fmd.fsid();
+  rec.mCtime = fmd.ctime();
+  rec.mCtimeNs = fmd.ctime_ns();
+  rec.mMtime = fmd.mtime();
+  rec.mMtimeNs = fmd.mtime_ns();
+  rec.mAtime = fmd.atime();
+  rec.mAtimeNs = fmd.atime_ns();
+  rec.mCheckTime = fmd.checktime();
+  rec.mLid = fmd.lid();
+  rec.mUid = fmd.uid();
+  rec.mGid = fmd.gid();
+
+  if (total > sizeof(rec.mStr)) {
+    Chunk chunk;
+    memset(&chunk, 0, sizeof(chunk));
+    chunk.mFid = fid;
+    char* ptr = chunk.mStr;
+
+    for (int i = 0; i < sNumStrings; ++i) {
+      chunk.mStrLen[i] = rec.mStrLen[i];
+      memcpy(ptr, strs[i]->data(), strs[i]->length());
+      ptr += strs[i]->length();
+    }
+
+    chunk.mCrc = ComputeCrc(&chunk, sizeof(chunk));
+    uint32_t idx;
+
+    if (had_chunk) {
+      idx = old_chunk;
+    } else if (!mFreeChunks.empty()) {
+      idx = mFreeChunks.back();
+      mFreeChunks.pop_back();
+    } else {
+      idx = mNumChunks++;
+    }
+
+    // The chunk is written before the slot referencing it
+    if (!PwriteAll(mOverflowFd, reinterpret_cast<const char*>(&chunk),
+                   sizeof(chunk), (off_t) idx * kChunkSize)) {
+      eos_static_err("msg=\"failed to write overflow chunk\" db=%s fid=%llu "
+                     "errno=%d", mDbName.c_str(), (unsigned long long) fid,
+                     errno);
+
+      if (!had_chunk) {
+        mFreeChunks.push_back(idx);
+      }
+
+      return false;
+    }
+
+    rec.mFlags |= sOverflow;
+    rec.mChunk = idx;
+  } else {
+    char* ptr = rec.mStr;
+
+    for (int i = 0; i < sNumStrings; ++i) {
+      memcpy(ptr, strs[i]->data(), strs[i]->length());
+      ptr += strs[i]->length();
+    }
+  }
+
+  rec.mCrc = ComputeCrc(&rec, sizeof(rec));
+  memcpy(slot, &rec, sizeof(rec));
+
+  if (!was_used) {
+    ++mNumEntries;
+  }
+
+  if (had_chunk && !(rec.mFlags & sOverflow)) {
+    mFreeChunks.push_back(old_chunk);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Remove a record
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::ApplyRemove(uint64_t fid)
+{
+  Slot* slot = GetSlot(fid, false);
+
+  if (!slot || !(slot->mFlags & sUsed)) {
+    return true;
+  }
+
+  if (slot->mFlags & sOverflow) {
+    mFreeChunks.push_back(slot->mChunk);
+  }
+
+  memset(slot, 0, sizeof(*slot));
+  --mNumEntries;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Remove all the records
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::ApplyClear()
+{
+  if (ftruncate(mSlotFd, sHeaderSize) || ftruncate(mOverflowFd, 0)) {
+    eos_static_err("msg=\"failed to truncate the slot store\" db=%s errno=%d",
+                   mDbName.c_str(), errno);
+    return false;
+  }
+
+  mPages.clear();
+  mPageKeys.clear();
+  mFreePages.clear();
+  mFreeChunks.clear();
+  mNumPages = 0;
+  mNumChunks = 0;
+  mNumEntries = 0;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Encode a journal entry
+//------------------------------------------------------------------------------
+void
+FmdSlotDbMapInterface::EncodeJournal(std::string& out, JournalOp op,
+                                     uint64_t fid, const std::string& value)
+{
+  JournalHeader hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.mMagic = sJournalMagic;
+  hdr.mOp = op;
+  hdr.mFid = fid;
+  hdr.mLength = value.length();
+  hdr.mCrc = ComputeJournalCrc(hdr, value.data());
+  out.append(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+  out.append(value);
+}
+
+//------------------------------------------------------------------------------
+// Append data to the journal
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::WriteJournal(const std::string& data)
+{
+  const char* ptr = data.data();
+  size_t len = data.length();
+
+  while (len) {
+    ssize_t nwrite = ::write(mJournalFd, ptr, len);
+
+    if (nwrite < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      eos_static_err("msg=\"failed to write journal\" db=%s errno=%d",
+                     mDbName.c_str(), errno);
+      return false;
+    }
+
+    ptr += nwrite;
+    len -= nwrite;
+  }
+
+  mJournalSize += data.length();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the value associated with a key
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::getEntry(const eos::common::Slice& key, Tval* val)
+{
+  if (mDbName.empty() || (key.size() != sizeof(uint64_t))) {
+    return false;
+  }
+
+  uint64_t fid;
+  memcpy(&fid, key.data(), sizeof(fid));
+  const Slot* slot = GetSlot(fid);
+
+  if (!slot || !(slot->mFlags & sUsed)) {
+    return false;
+  }
+
+  FmdBase fmd;
+
+  if (!SlotToFmd(slot, fmd)) {
+    return false;
+  }
+
+  val->value.clear();
+  fmd.SerializePartialToString(&val->value);
+  val->timestampstr.clear();
+  val->seqid = 1;
+  val->writer = mName;
+  val->comment.clear();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Set a key / value
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::setEntry(const eos::common::Slice& key,
+                                const TvalSlice& val)
+{
+  if (mDbName.empty() || (key.size() != sizeof(uint64_t))) {
+    eos_static_err("msg=\"slot store needs 8-byte file id keys\" db=%s",
+                   mDbName.c_str());
+    return false;
+  }
+
+  PendingOp op {kOpSet, 0, val.value.ToString()};
+  memcpy(&op.mFid, key.data(), sizeof(op.mFid));
+  FmdBase fmd;
+
+  if (!fmd.ParseFromString(op.mValue)) {
+    eos_static_err("msg=\"slot store value is not a record\" db=%s fid=%llu",
+                   mDbName.c_str(), (unsigned long long) op.mFid);
+    return false;
+  }
+
+  if (mInTransaction) {
+    mPending.push_back(std::move(op));
+    return true;
+  }
+
+  std::string data;
+  EncodeJournal(data, kOpSet, op.mFid, op.mValue);
+
+  if (!WriteJournal(data) || !ApplySet(op.mFid, op.mValue)) {
+    return false;
+  }
+
+  if (mJournalSize > kJournalMaxSize) {
+    return Checkpoint();
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Remove the entry associated to a key
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::removeEntry(const eos::common::Slice& key,
+                                   const TvalSlice& val)
+{
+  if (mDbName.empty() || (key.size() != sizeof(uint64_t))) {
+    return false;
+  }
+
+  PendingOp op {kOpRemove, 0, std::string()};
+  memcpy(&op.mFid, key.data(), sizeof(op.mFid));
+
+  if (mInTransaction) {
+    mPending.push_back(std::move(op));
+    return true;
+  }
+
+  std::string data;
+  EncodeJournal(data, kOpRemove, op.mFid, op.mValue);
+
+  if (!WriteJournal(data) || !ApplyRemove(op.mFid)) {
+    return false;
+  }
+
+  if (mJournalSize > kJournalMaxSize) {
+    return Checkpoint();
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Clear the content of the db
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::clear()
+{
+  if (mDbName.empty()) {
+    return false;
+  }
+
+  mPending.clear();
+  std::string data;
+  EncodeJournal(data, kOpClear, 0, std::string());
+  return WriteJournal(data) && ApplyClear() && Checkpoint();
+}
+
+//------------------------------------------------------------------------------
+// Get the number of entries
+//------------------------------------------------------------------------------
+size_t
+FmdSlotDbMapInterface::size() const
+{
+  return mNumEntries;
+}
+
+//------------------------------------------------------------------------------
+// Get the number of entries matching a key
+//------------------------------------------------------------------------------
+size_t
+FmdSlotDbMapInterface::count(const eos::common::Slice& key) const
+{
+  if (mDbName.empty() || (key.size() != sizeof(uint64_t))) {
+    return 0;
+  }
+
+  uint64_t fid;
+  memcpy(&fid, key.data(), sizeof(fid));
+  const Slot* slot = GetSlot(fid);
+  return (slot && (slot->mFlags & sUsed)) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// Get all the entries by blocks in file id order
+//------------------------------------------------------------------------------
+size_t
+FmdSlotDbMapInterface::getAll(TlogentryVec* retvec, size_t nmax,
+                              Tlogentry* startafter) const
+{
+  if (mDbName.empty()) {
+    return 0;
+  }
+
+  size_t count = retvec->size();
+  uint64_t start = 0;
+
+  if (startafter && (startafter->key.size() == sizeof(uint64_t))) {
+    memcpy(&start, startafter->key.data(), sizeof(start));
+
+    if (++start == 0) {
+      // Last possible file id already returned
+      *startafter = Tlogentry();
+      return 0;
+    }
+  }
+
+  if (!nmax) {
+    nmax = std::numeric_limits<size_t>::max();
+  }
+
+  size_t n = 0;
+
+  for (auto it = mPageKeys.lower_bound(start / kSlotsPerPage);
+       (it != mPageKeys.end()) && (n < nmax); ++it) {
+    uint32_t first = (*it == start / kSlotsPerPage) ? start % kSlotsPerPage : 0;
+    const char* page = GetPage(mPages.at(*it));
+
+    for (uint32_t i = first; (i < kSlotsPerPage) && (n < nmax); ++i) {
+      const Slot* slot = reinterpret_cast<const Slot*>(page + sPageHeaderSize +
+                         i * kSlotSize);
+      FmdBase fmd;
+
+      if (!(slot->mFlags & sUsed) || !SlotToFmd(slot, fmd)) {
+        continue;
+      }
+
+      Tlogentry entry;
+      entry.key.assign(reinterpret_cast<const char*>(&slot->mFid),
+                       sizeof(slot->mFid));
+      fmd.SerializePartialToString(&entry.value);
+      entry.seqid = "1";
+      entry.writer = mName;
+      retvec->push_back(std::move(entry));
+      ++n;
+    }
+  }
+
+  if (startafter) {
+    if (retvec->empty()) {
+      (*startafter) = Tlogentry();
+    } else {
+      (*startafter) = (*retvec)[retvec->size() - 1];
+    }
+  }
+
+  return retvec->size() - count;
+}
+
+//------------------------------------------------------------------------------
+// Start a transaction
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::beginTransaction()
+{
+  mInTransaction = true;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// End a transaction - the journal is written in one go before the slots
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::endTransaction()
+{
+  if (!mInTransaction) {
+    return true;
+  }
+
+  mInTransaction = false;
+
+  if (mPending.empty()) {
+    return true;
+  }
+
+  std::string data;
+
+  for (const auto& op : mPending) {
+    EncodeJournal(data, op.mOp, op.mFid, op.mValue);
+  }
+
+  if (!WriteJournal(data)) {
+    mPending.clear();
+    return false;
+  }
+
+  if (mSyncTransactions && fdatasync(mJournalFd)) {
+    eos_static_err("msg=\"failed to sync journal\" db=%s errno=%d",
+                   mDbName.c_str(), errno);
+  }
+
+  bool ok = true;
+
+  for (const auto& op : mPending) {
+    if (op.mOp == kOpSet) {
+      ok = ApplySet(op.mFid, op.mValue) && ok;
+    } else {
+      ok = ApplyRemove(op.mFid) && ok;
+    }
+  }
+
+  mPending.clear();
+
+  if (mJournalSize > kJournalMaxSize) {
+    ok = Checkpoint() && ok;
+  }
+
+  return ok;
+}
+
+//------------------------------------------------------------------------------
+// Sync the slots and the overflow to disk and truncate the journal
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::Checkpoint()
+{
+  if (mSlotFd < 0) {
+    return false;
+  }
+
+  if (mBase && mNumPages &&
+      msync(mBase, sHeaderSize + (uint64_t) mNumPages * kPageSize, MS_SYNC)) {
+    eos_static_err("msg=\"failed to sync slot file\" db=%s errno=%d",
+                   mDbName.c_str(), errno);
+    return false;
+  }
+
+  if (fdatasync(mOverflowFd) || fdatasync(mSlotFd)) {
+    eos_static_err("msg=\"failed to sync slot store\" db=%s errno=%d",
+                   mDbName.c_str(), errno);
+    return false;
+  }
+
+  // Only once everything is on disk the journal can be dropped
+  if (mJournalSize && (ftruncate(mJournalFd, 0) || fsync(mJournalFd))) {
+    eos_static_err("msg=\"failed to truncate journal\" db=%s errno=%d",
+                   mDbName.c_str(), errno);
+    return false;
+  }
+
+  mJournalSize = 0;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Rebuild the page table, the counters and the free lists from the files
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::Load()
+{
+  struct stat buf;
+  FileHeader hdr;
+
+  if (fstat(mSlotFd, &buf)) {
+    return false;
+  }
+
+  if ((uint64_t) buf.st_size < sHeaderSize) {
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.mMagic, sFileMagic, sizeof(hdr.mMagic));
+    hdr.mVersion = sVersion;
+    hdr.mSlotSize = kSlotSize;
+    hdr.mSlotsPerPage = kSlotsPerPage;
+    hdr.mPageSize = kPageSize;
+    hdr.mChunkSize = kChunkSize;
+
+    if (ftruncate(mSlotFd, sHeaderSize) ||
+        !PwriteAll(mSlotFd, reinterpret_cast<const char*>(&hdr), sizeof(hdr), 0) ||
+        fdatasync(mSlotFd)) {
+      eos_static_err("msg=\"failed to initialize slot file\" db=%s errno=%d",
+                     mDbName.c_str(), errno);
+      return false;
+    }
+
+    buf.st_size = sHeaderSize;
+  } else {
+    if (!PreadAll(mSlotFd, reinterpret_cast<char*>(&hdr), sizeof(hdr), 0) ||
+        memcmp(hdr.mMagic, sFileMagic, sizeof(hdr.mMagic)) ||
+        (hdr.mVersion != sVersion) || (hdr.mSlotSize != kSlotSize) ||
+        (hdr.mSlotsPerPage != kSlotsPerPage) || (hdr.mPageSize != kPageSize) ||
+        (hdr.mChunkSize != kChunkSize)) {
+      eos_static_err("msg=\"incompatible slot file\" db=%s", mDbName.c_str());
+      return false;
+    }
+  }
+
+  mNumPages = (buf.st_size - sHeaderSize) / kPageSize;
+
+  if ((uint64_t) buf.st_size != sHeaderSize + (uint64_t) mNumPages * kPageSize) {
+    // Drop the partially allocated last page
+    if (ftruncate(mSlotFd, sHeaderSize + (uint64_t) mNumPages * kPageSize)) {
+      return false;
+    }
+  }
+
+  if (!MapSlots(sHeaderSize + (uint64_t) mNumPages * kPageSize)) {
+    return false;
+  }
+
+  if (fstat(mOverflowFd, &buf)) {
+    return false;
+  }
+
+  mNumChunks = buf.st_size / kChunkSize;
+  std::vector<bool> used_chunks(mNumChunks, false);
+  uint64_t num_dropped = 0;
+
+  for (uint32_t idx = 0; idx < mNumPages; ++idx) {
+    char* page = GetPage(idx);
+    const PageHeader* phdr = reinterpret_cast<const PageHeader*>(page);
+
+    if ((phdr->mMagic != sPageMagic) ||
+        (phdr->mCrc != crc32(0, reinterpret_cast<const Bytef*>(phdr),
+                             offsetof(PageHeader, mCrc))) ||
+        mPages.count(phdr->mKey)) {
+      mFreePages.push_back(idx);
+      continue;
+    }
+
+    mPages[phdr->mKey] = idx;
+    mPageKeys.insert(phdr->mKey);
+
+    for (uint32_t i = 0; i < kSlotsPerPage; ++i) {
+      Slot* slot = reinterpret_cast<Slot*>(page + sPageHeaderSize +
+                                           i * kSlotSize);
+
+      if (!(slot->mFlags & sUsed)) {
+        continue;
+      }
+
+      FmdBase fmd;
+
+      if ((slot->mCrc != ComputeCrc(slot, sizeof(*slot))) ||
+          (slot->mFid != phdr->mKey * kSlotsPerPage + i) ||
+          ((slot->mFlags & sOverflow) && ((slot->mChunk >= mNumChunks) ||
+                                           used_chunks[slot->mChunk] ||
+                                           !SlotToFmd(slot, fmd)))) {
+        // Torn or inconsistent record, repaired by the journal if it was
+        // modified after the last checkpoint otherwise lost
+        memset(slot, 0, sizeof(*slot));
+        ++num_dropped;
+        continue;
+      }
+
+      if (slot->mFlags & sOverflow) {
+        used_chunks[slot->mChunk] = true;
+      }
+
+      ++mNumEntries;
+    }
+  }
+
+  // Reuse the lowest free chunks and pages first
+  for (uint32_t i = mNumChunks; i > 0; --i) {
+    if (!used_chunks[i - 1]) {
+      mFreeChunks.push_back(i - 1);
+    }
+  }
+
+  std::reverse(mFreePages.begin(), mFreePages.end());
+
+  if (num_dropped) {
+    eos_static_warning("msg=\"dropped invalid records\" db=%s count=%llu",
+                       mDbName.c_str(), (unsigned long long) num_dropped);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Replay the journal
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::Replay()
+{
+  struct stat buf;
+
+  if (fstat(mJournalFd, &buf)) {
+    return false;
+  }
+
+  std::string data(buf.st_size, '\0');
+
+  if (buf.st_size &&
+      !PreadAll(mJournalFd, &data[0], data.length(), 0)) {
+    eos_static_err("msg=\"failed to read journal\" db=%s errno=%d",
+                   mDbName.c_str(), errno);
+    return false;
+  }
+
+  size_t pos = 0;
+  uint64_t num_ops = 0;
+
+  while (pos + sizeof(JournalHeader) <= data.length()) {
+    JournalHeader hdr;
+    memcpy(&hdr, data.data() + pos, sizeof(hdr));
+
+    if ((hdr.mMagic != sJournalMagic) ||
+        (pos + sizeof(hdr) + hdr.mLength > data.length()) ||
+        (hdr.mCrc != ComputeJournalCrc(hdr, data.data() + pos + sizeof(hdr)))) {
+      // Torn tail of the journal, these updates never reached the slots
+      break;
+    }
+
+    std::string value(data, pos + sizeof(hdr), hdr.mLength);
+    pos += sizeof(hdr) + hdr.mLength;
+    ++num_ops;
+
+    if (hdr.mOp == kOpSet) {
+      ApplySet(hdr.mFid, value);
+    } else if (hdr.mOp == kOpRemove) {
+      ApplyRemove(hdr.mFid);
+    } else if (hdr.mOp == kOpClear) {
+      ApplyClear();
+    }
+  }
+
+  if (num_ops) {
+    eos_static_notice("msg=\"replayed journal\" db=%s ops=%llu dropped_bytes=%zu",
+                      mDbName.c_str(), (unsigned long long) num_ops,
+                      data.length() - pos);
+  }
+
+  mJournalSize = data.length();
+  return Checkpoint();
+}
+
+//------------------------------------------------------------------------------
+// Attach a db
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::attachDb(const std::string& dbname, bool repair,
+                                int createperm, void* option)
+{
+  if (!mDbName.empty()) {
+    eos_static_err("msg=\"slot store already attached\" db=%s",
+                   mDbName.c_str());
+    return false;
+  }
+
+  int perm = (createperm ? createperm : 0644);
+
+  if (mkdir(dbname.c_str(), perm | S_IXUSR | S_IXGRP | S_IXOTH) &&
+      (errno != EEXIST)) {
+    eos_static_err("msg=\"failed to create slot store\" db=%s errno=%d",
+                   dbname.c_str(), errno);
+    return false;
+  }
+
+  mDbName = dbname;
+  mSlotFd = open((dbname + "/slots").c_str(), O_RDWR | O_CREAT, perm);
+  mOverflowFd = open((dbname + "/overflow").c_str(), O_RDWR | O_CREAT, perm);
+  mJournalFd = open((dbname + "/journal").c_str(),
+                    O_RDWR | O_CREAT | O_APPEND, perm);
+
+  if ((mSlotFd < 0) || (mOverflowFd < 0) || (mJournalFd < 0) || !Load() ||
+      !Replay()) {
+    eos_static_err("msg=\"failed to attach slot store\" db=%s errno=%d",
+                   dbname.c_str(), errno);
+    Close();
+    return false;
+  }
+
+  eos_static_info("msg=\"attached slot store\" db=%s entries=%llu pages=%u "
+                  "chunks=%u", mDbName.c_str(),
+                  (unsigned long long) mNumEntries, mNumPages, mNumChunks);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Consolidate the db - there is nothing to compact, take a checkpoint
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::trimDb()
+{
+  if (mDbName.empty()) {
+    return false;
+  }
+
+  return Checkpoint();
+}
+
+//------------------------------------------------------------------------------
+// Get the name of the attached db
+//------------------------------------------------------------------------------
+std::string
+FmdSlotDbMapInterface::getAttachedDbName() const
+{
+  return mDbName;
+}
+
+//------------------------------------------------------------------------------
+// Copy the content of the db to an in memory map
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::syncFromDb(::google::dense_hash_map<Tkey, Tval>* map)
+{
+  if (mDbName.empty()) {
+    return false;
+  }
+
+  TlogentryVec entries;
+  getAll(&entries);
+
+  for (const auto& entry : entries) {
+    Tval val;
+    eos::common::Tlogentry2Tval(entry, &val);
+    (*map)[entry.key] = val;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Close the files
+//------------------------------------------------------------------------------
+void
+FmdSlotDbMapInterface::Close()
+{
+  if (mBase) {
+    munmap(mBase, mMapLength);
+    mBase = nullptr;
+    mMapLength = 0;
+  }
+
+  for (int* fd : {
+         &mSlotFd, &mOverflowFd, &mJournalFd
+       }) {
+    if (*fd >= 0) {
+      close(*fd);
+      *fd = -1;
+    }
+  }
+
+  mDbName.clear();
+  mPages.clear();
+  mPageKeys.clear();
+  mFreePages.clear();
+  mFreeChunks.clear();
+  mPending.clear();
+  mNumPages = 0;
+  mNumChunks = 0;
+  mNumEntries = 0;
+  mJournalSize = 0;
+  mInTransaction = false;
+}
+
+//------------------------------------------------------------------------------
+// Detach the db
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::detachDb()
+{
+  if (mDbName.empty()) {
+    return false;
+  }
+
+  endTransaction();
+  Checkpoint();
+  Close();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// DB logs are not supported
+//------------------------------------------------------------------------------
+bool
+FmdSlotDbMapInterface::attachDbLog(const std::string& dbname,
+                                   int volumeduration, int createperm,
+                                   void* option)
+{
+  eos_static_err("msg=\"slot store does not support db logs\" db=%s",
+                 mDbName.c_str());
+  return false;
+}
+
+bool
+FmdSlotDbMapInterface::detachDbLog(const std::string& dbname)
+{
+  return false;
+}
+
+bool
+FmdSlotDbMapInterface::attachDbLog(eos::common::DbLogInterface* dblogint)
+{
+  eos_static_err("msg=\"slot store does not support db logs\" db=%s",
+                 mDbName.c_str());
+  return false;
+}
+
+bool
+FmdSlotDbMapInterface::detachDbLog(eos::common::DbLogInterface* dblogint)
+{
+  return false;
+}
+
+EOSFSTNAMESPACE_END
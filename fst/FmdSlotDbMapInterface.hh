@@ -0,0 +1,249 @@
+//------------------------------------------------------------------------------
+//! @file FmdSlotDbMapInterface.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "fst/Namespace.hh"
+#include "common/DbMapCommon.hh"
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+EOSFSTNAMESPACE_BEGIN
+
+class FmdBase;
+
+//------------------------------------------------------------------------------
+//! Class FmdSlotDbMapInterface - DbMapInterface storing the Fmd records of a
+//! filesystem in a memory-mapped file of fixed-size slots indexed by file id,
+//! used instead of LevelDB by the filesystems configured with fmdstore=slot.
+//!
+//! The db is a directory holding three files:
+//!  - slots: pages of kSlotsPerPage slots, the page of a file id is found
+//!    through an in-memory page table so lookups are O(1). A slot holds the
+//!    fixed-size fields of the record and its strings if they fit.
+//!  - overflow: chunks holding the strings of the records which do not fit
+//!    in their slot, one chunk per record, reused once freed.
+//!  - journal: every update is appended to the journal before the slots and
+//!    the overflow are modified in place. At a checkpoint the slots and the
+//!    overflow are synced and the journal is truncated, the attach replays the
+//!    journal so that a torn slot write after a crash is repaired.
+//!
+//! There is no compaction, trimDb only takes a checkpoint. The keys must be
+//! 8-byte file ids and the values serialized Fmd records. DB logs are not
+//! supported. Like all the DbMapInterfaces the object is not thread-safe,
+//! only concurrent getEntry calls are allowed.
+//------------------------------------------------------------------------------
+class FmdSlotDbMapInterface : public eos::common::DbMapInterface
+{
+public:
+  //! Number of slots per page
+  static constexpr uint32_t kSlotsPerPage = 340;
+  //! Size of a slot
+  static constexpr uint32_t kSlotSize = 192;
+  //! Size of a page
+  static constexpr uint32_t kPageSize = 65536;
+  //! Size of an overflow chunk
+  static constexpr uint32_t kChunkSize = 512;
+  //! Journal size triggering a checkpoint at the end of a transaction
+  static constexpr uint64_t kJournalMaxSize = 64 * 1024 * 1024;
+
+  static std::string getDbType()
+  {
+    return "Slot";
+  }
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  FmdSlotDbMapInterface();
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~FmdSlotDbMapInterface();
+
+  FmdSlotDbMapInterface(const FmdSlotDbMapInterface&) = delete;
+  FmdSlotDbMapInterface& operator=(const FmdSlotDbMapInterface&) = delete;
+
+  virtual void setName(const std::string& name) override
+  {
+    mName = name;
+  }
+
+  virtual const std::string& getName() const override
+  {
+    return mName;
+  }
+
+  virtual bool getEntry(const eos::common::Slice& key, Tval* val) override;
+  virtual bool setEntry(const eos::common::Slice& key,
+                        const TvalSlice& val) override;
+  virtual bool removeEntry(const eos::common::Slice& key,
+                           const TvalSlice& val) override;
+  virtual bool clear() override;
+  virtual size_t size() const override;
+  virtual size_t count(const eos::common::Slice& key) const override;
+  virtual size_t getAll(TlogentryVec* retvec, size_t nmax = 0,
+                        Tlogentry* startafter = NULL) const override;
+  virtual bool beginTransaction() override;
+  virtual bool endTransaction() override;
+
+  //----------------------------------------------------------------------------
+  //! If true, the journal is synced to disk at the end of every transaction
+  //----------------------------------------------------------------------------
+  virtual void setSyncTransactions(bool sync) override
+  {
+    mSyncTransactions = sync;
+  }
+
+  virtual bool attachDb(const std::string& dbname, bool repair = false,
+                        int createperm = 0, void* option = NULL) override;
+  virtual bool trimDb() override;
+  virtual std::string getAttachedDbName() const override;
+  virtual bool syncFromDb(::google::dense_hash_map<Tkey, Tval>* map) override;
+  virtual bool detachDb() override;
+  virtual bool attachDbLog(const std::string& dbname, int volumeduration,
+                           int createperm, void* option) override;
+  virtual bool detachDbLog(const std::string& dbname) override;
+  virtual bool attachDbLog(eos::common::DbLogInterface* dblogint) override;
+  virtual bool detachDbLog(eos::common::DbLogInterface* dblogint) override;
+
+  //----------------------------------------------------------------------------
+  //! Sync the slots and the overflow to disk and truncate the journal
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Checkpoint();
+
+  //----------------------------------------------------------------------------
+  //! Get the size of the journal, for tests
+  //----------------------------------------------------------------------------
+  uint64_t GetJournalSize() const
+  {
+    return mJournalSize;
+  }
+
+private:
+  //! Operations recorded in the journal
+  enum JournalOp : uint32_t {
+    kOpSet = 1,
+    kOpRemove = 2,
+    kOpClear = 3
+  };
+
+  struct Slot;
+
+  //----------------------------------------------------------------------------
+  //! Pending operation of a transaction
+  //----------------------------------------------------------------------------
+  struct PendingOp {
+    JournalOp mOp;
+    uint64_t mFid;
+    std::string mValue;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the slot of a file id
+  //!
+  //! @param fid file id
+  //! @param create if true allocate the page of the slot if needed
+  //!
+  //! @return slot or nullptr if there is none
+  //----------------------------------------------------------------------------
+  Slot* GetSlot(uint64_t fid, bool create);
+  const Slot* GetSlot(uint64_t fid) const;
+
+  //----------------------------------------------------------------------------
+  //! Get a page in the mapped file
+  //----------------------------------------------------------------------------
+  char* GetPage(uint32_t idx) const;
+
+  //----------------------------------------------------------------------------
+  //! Allocate a page for a key
+  //!
+  //! @return page index or -1 if failed
+  //----------------------------------------------------------------------------
+  int64_t AllocPage(uint64_t page_key);
+
+  //----------------------------------------------------------------------------
+  //! Map the slot file for at least the given size
+  //----------------------------------------------------------------------------
+  bool MapSlots(uint64_t min_length);
+
+  //----------------------------------------------------------------------------
+  //! Convert a slot to a record
+  //----------------------------------------------------------------------------
+  bool SlotToFmd(const Slot* slot, FmdBase& fmd) const;
+
+  //----------------------------------------------------------------------------
+  //! Apply operations to the slots and the overflow
+  //----------------------------------------------------------------------------
+  bool ApplySet(uint64_t fid, const std::string& value);
+  bool ApplyRemove(uint64_t fid);
+  bool ApplyClear();
+
+  //----------------------------------------------------------------------------
+  //! Append operations to the journal
+  //----------------------------------------------------------------------------
+  static void EncodeJournal(std::string& out, JournalOp op, uint64_t fid,
+                            const std::string& value);
+  bool WriteJournal(const std::string& data);
+
+  //----------------------------------------------------------------------------
+  //! Rebuild the page table, the counters and the free lists from the files
+  //----------------------------------------------------------------------------
+  bool Load();
+
+  //----------------------------------------------------------------------------
+  //! Replay the journal
+  //----------------------------------------------------------------------------
+  bool Replay();
+
+  //----------------------------------------------------------------------------
+  //! Close the files
+  //----------------------------------------------------------------------------
+  void Close();
+
+  std::string mName; ///< Writer name
+  std::string mDbName; ///< Attached db directory, empty if not attached
+  int mSlotFd {-1}; ///< Slot file
+  int mOverflowFd {-1}; ///< Overflow file
+  int mJournalFd {-1}; ///< Journal file
+  char* mBase {nullptr}; ///< Mapping of the slot file
+  uint64_t mMapLength {0}; ///< Length of the mapping
+  uint32_t mNumPages {0}; ///< Number of pages in the slot file
+  uint32_t mNumChunks {0}; ///< Number of chunks in the overflow file
+  uint64_t mNumEntries {0}; ///< Number of records
+  uint64_t mJournalSize {0}; ///< Size of the journal
+  bool mSyncTransactions {false}; ///< Sync the journal in endTransaction
+  bool mInTransaction {false}; ///< Transaction ongoing
+  //! Page table from fid / kSlotsPerPage to page index
+  std::unordered_map<uint64_t, uint32_t> mPages;
+  std::set<uint64_t> mPageKeys; ///< Sorted page keys used to iterate
+  std::vector<uint32_t> mFreePages; ///< Pages without a valid header
+  std::vector<uint32_t> mFreeChunks; ///< Unused overflow chunks
+  std::vector<PendingOp> mPending; ///< Operations of the ongoing transaction
+};
+
+EOSFSTNAMESPACE_END
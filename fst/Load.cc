@@ -22,9 +22,14 @@
  ************************************************************************/
 
 #include "fst/Load.hh"
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <errno.h>
+#include <fstream>
+#include <sstream>
+#include <thread>
 #include <sys/stat.h>
 #include "XrdOuc/XrdOucString.hh"
 
@@ -37,7 +42,7 @@ EOSFSTNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-Load::Load(unsigned int ival):
+Load::Load(unsigned int ival, int fast_ival_ms):
   mTid(0)
 {
   mInterval = ival;
@@ -45,6 +50,19 @@ Load::Load(unsigned int ival):
   if (mInterval == 0) {
     mInterval = 1;
   }
+
+  if (fast_ival_ms < 0) {
+    const char* ptr = getenv("EOS_FST_LOAD_SAMPLE_MS");
+    fast_ival_ms = (ptr ? atoi(ptr) : 250);
+  }
+
+  if (fast_ival_ms > 0) {
+    // Faster sampling makes the deltas of the millisecond counters too coarse
+    fast_ival_ms = std::max(fast_ival_ms, 100);
+    fast_ival_ms = std::min(fast_ival_ms, (int)(mInterval * 1000));
+  }
+
+  mFastIntervalMs = (fast_ival_ms > 0 ? fast_ival_ms : 0);
 }
 
 //------------------------------------------------------------------------------
@@ -148,6 +166,44 @@ Load::GetNetRate(const char* dev, const char* tag)
   return val;
 }
 
+//------------------------------------------------------------------------------
+// Get the busy percentage of the device of a path
+//------------------------------------------------------------------------------
+double
+Load::GetDiskBusy(const char* dev_path)
+{
+  std::string dev = DevMap(dev_path);
+
+  if (mFastIntervalMs) {
+    double busy = fDiskBusy.GetBusy(dev);
+
+    if (busy >= 0) {
+      return busy;
+    }
+  }
+
+  return std::min(fDiskStat.GetRate(dev.c_str(), "millisIO") / 10.0, 100.0);
+}
+
+//------------------------------------------------------------------------------
+// Get the average queue depth of the device of a path
+//------------------------------------------------------------------------------
+double
+Load::GetDiskQueueDepth(const char* dev_path)
+{
+  std::string dev = DevMap(dev_path);
+
+  if (mFastIntervalMs) {
+    double depth = fDiskBusy.GetQueueDepth(dev);
+
+    if (depth >= 0) {
+      return depth;
+    }
+  }
+
+  return fDiskStat.GetRate(dev.c_str(), "weightedMillisIO") / 1000.0;
+}
+
 //------------------------------------------------------------------------------
 // Method run by scurbber thread to  measurement both disk and network values
 // on regular intervals.
@@ -155,19 +211,35 @@ Load::GetNetRate(const char* dev, const char* tag)
 void
 Load::Measure()
 {
+  std::chrono::steady_clock::time_point next_rates;
+
   while (true) {
     XrdSysThread::SetCancelOff();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if (now >= next_rates) {
+      next_rates = now + std::chrono::seconds(mInterval);
+
+      if (!fDiskStat.Measure()) {
+        fprintf(stderr, "error: cannot get disk IO statistic\n");
+      }
 
-    if (!fDiskStat.Measure()) {
-      fprintf(stderr, "error: cannot get disk IO statistic\n");
+      if (!fNetStat.Measure()) {
+        fprintf(stderr, "error: cannot get network IO statistic\n");
+      }
     }
 
-    if (!fNetStat.Measure()) {
-      fprintf(stderr, "error: cannot get network IO statistic\n");
+    if (mFastIntervalMs && !fDiskBusy.Measure()) {
+      fprintf(stderr, "error: cannot get disk utilization\n");
     }
 
     XrdSysThread::SetCancelOn();
-    sleep(mInterval);
+
+    if (mFastIntervalMs) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(mFastIntervalMs));
+    } else {
+      sleep(mInterval);
+    }
   }
 }
 
@@ -327,6 +399,141 @@ DiskStat::Measure()
   }
 }
 
+//------------------------------------------------------------------------------
+//                                 DiskBusy Class
+//------------------------------------------------------------------------------
+
+constexpr double DiskBusy::sTimeConstant;
+
+//------------------------------------------------------------------------------
+// Sample /proc/diskstats
+//------------------------------------------------------------------------------
+bool
+DiskBusy::Measure()
+{
+  std::ifstream file("/proc/diskstats");
+
+  if (!file.is_open()) {
+    return false;
+  }
+
+  std::stringstream content;
+  content << file.rdbuf();
+  return Update(content.str(), std::chrono::steady_clock::now());
+}
+
+//------------------------------------------------------------------------------
+// Update the averages from the content of /proc/diskstats
+//------------------------------------------------------------------------------
+bool
+DiskBusy::Update(const std::string& diskstats,
+                 std::chrono::steady_clock::time_point now)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  double dt_ms = std::chrono::duration_cast<std::chrono::microseconds>
+                 (now - mLastSample).count() / 1000.0;
+  bool first = (mLastSample == std::chrono::steady_clock::time_point());
+  // Weight of the new sample for an average over sTimeConstant seconds
+  double alpha = 1.0 - exp(-dt_ms / (sTimeConstant * 1000.0));
+  bool found = false;
+  std::istringstream lines(diskstats);
+  std::string line;
+  char dev_name[1024];
+
+  while (std::getline(lines, line)) {
+    unsigned int major, minor;
+    unsigned long long stats[11];
+
+    // Newer kernels append discard and flush counters, the first 14 fields
+    // are the same
+    if (sscanf(line.c_str(), "%u %u %1023s %llu %llu %llu %llu %llu %llu %llu "
+               "%llu %llu %llu %llu", &major, &minor, dev_name, &stats[0],
+               &stats[1], &stats[2], &stats[3], &stats[4], &stats[5],
+               &stats[6], &stats[7], &stats[8], &stats[9], &stats[10]) != 14) {
+      continue;
+    }
+
+    found = true;
+    Device& dev = mDevices[dev_name];
+    unsigned long long millis_io = stats[9];
+    unsigned long long weighted_millis_io = stats[10];
+    dev.mInFlight = stats[8];
+
+    // Skip the first sample and counters which wrapped around or were reset
+    if (!first && (dt_ms > 0) && (millis_io >= dev.mMillisIO) &&
+        (weighted_millis_io >= dev.mWeightedMillisIO)) {
+      double busy = std::min(100.0 * (millis_io - dev.mMillisIO) / dt_ms, 100.0);
+      double depth = (weighted_millis_io - dev.mWeightedMillisIO) / dt_ms;
+
+      if (dev.mAveraged) {
+        dev.mBusy += alpha * (busy - dev.mBusy);
+        dev.mQueueDepth += alpha * (depth - dev.mQueueDepth);
+      } else {
+        dev.mBusy = busy;
+        dev.mQueueDepth = depth;
+        dev.mAveraged = true;
+      }
+    }
+
+    dev.mMillisIO = millis_io;
+    dev.mWeightedMillisIO = weighted_millis_io;
+  }
+
+  if (found) {
+    mLastSample = now;
+  }
+
+  return found;
+}
+
+//------------------------------------------------------------------------------
+// Get the busy percentage of a device
+//------------------------------------------------------------------------------
+double
+DiskBusy::GetBusy(const std::string& dev)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mDevices.find(dev);
+
+  if ((it == mDevices.end()) || !it->second.mAveraged) {
+    return -1;
+  }
+
+  return it->second.mBusy;
+}
+
+//------------------------------------------------------------------------------
+// Get the average queue depth of a device
+//------------------------------------------------------------------------------
+double
+DiskBusy::GetQueueDepth(const std::string& dev)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mDevices.find(dev);
+
+  if ((it == mDevices.end()) || !it->second.mAveraged) {
+    return -1;
+  }
+
+  return it->second.mQueueDepth;
+}
+
+//------------------------------------------------------------------------------
+// Get the number of requests in flight on a device
+//------------------------------------------------------------------------------
+long long
+DiskBusy::GetInFlight(const std::string& dev)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mDevices.find(dev);
+
+  if (it == mDevices.end()) {
+    return -1;
+  }
+
+  return it->second.mInFlight;
+}
+
 //------------------------------------------------------------------------------
 //                                 NetStat Class
 //------------------------------------------------------------------------------
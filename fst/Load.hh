@@ -26,6 +26,8 @@
 
 #include "fst/Namespace.hh"
 #include "XrdSys/XrdSysPthread.hh"
+#include <chrono>
+#include <mutex>
 #include <vector>
 #include <map>
 #include <string>
@@ -121,6 +123,81 @@ private:
   XrdSysRWLock mMutexRW; ///< RW mutex for protecting accces to the rates map
 };
 
+//------------------------------------------------------------------------------
+//! Class tracking the utilization and the queue depth of the disks, meant to
+//! be sampled every few hundred milliseconds. The values are smoothed with an
+//! exponentially weighted moving average with a time constant of one second,
+//! so that background jobs notice user IO within about a second.
+//------------------------------------------------------------------------------
+class DiskBusy
+{
+public:
+  //! Time constant of the moving averages in seconds
+  static constexpr double sTimeConstant = 1.0;
+
+  //----------------------------------------------------------------------------
+  //! Sample /proc/diskstats
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Measure();
+
+  //----------------------------------------------------------------------------
+  //! Update the averages from the content of /proc/diskstats
+  //!
+  //! @param diskstats content of /proc/diskstats
+  //! @param now time of the sample
+  //!
+  //! @return true if at least one device was found, otherwise false
+  //----------------------------------------------------------------------------
+  bool Update(const std::string& diskstats,
+              std::chrono::steady_clock::time_point now);
+
+  //----------------------------------------------------------------------------
+  //! Get the percentage of time the device was busy with IO
+  //!
+  //! @param dev device name
+  //!
+  //! @return busy percentage in [0, 100] or -1 if the device is unknown
+  //----------------------------------------------------------------------------
+  double GetBusy(const std::string& dev);
+
+  //----------------------------------------------------------------------------
+  //! Get the average number of requests queued on the device
+  //!
+  //! @param dev device name
+  //!
+  //! @return average queue depth or -1 if the device is unknown
+  //----------------------------------------------------------------------------
+  double GetQueueDepth(const std::string& dev);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of requests in flight on the device at the last sample
+  //!
+  //! @param dev device name
+  //!
+  //! @return number of requests or -1 if the device is unknown
+  //----------------------------------------------------------------------------
+  long long GetInFlight(const std::string& dev);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Counters and averages of a device
+  //----------------------------------------------------------------------------
+  struct Device {
+    unsigned long long mMillisIO {0}; ///< time spent doing IO
+    unsigned long long mWeightedMillisIO {0}; ///< weighted time doing IO
+    long long mInFlight {0}; ///< IOs currently in progress
+    double mBusy {0}; ///< average busy percentage
+    double mQueueDepth {0}; ///< average queue depth
+    bool mAveraged {false}; ///< the averages were computed at least once
+  };
+
+  std::mutex mMutex; ///< mutex protecting the members below
+  std::map<std::string, Device> mDevices; ///< devices by name
+  std::chrono::steady_clock::time_point mLastSample; ///< time of last sample
+};
+
 //------------------------------------------------------------------------------
 //! Class Load
 //------------------------------------------------------------------------------
@@ -139,8 +216,13 @@ public:
 
   //----------------------------------------------------------------------------
   //! Constructor
+  //!
+  //! @param ival sampling interval of the disk and network rates in seconds
+  //! @param fast_ival_ms sampling interval of the disk utilization and queue
+  //!        depth in milliseconds, by default EOS_FST_LOAD_SAMPLE_MS or 250,
+  //!        0 disables the high frequency sampling
   //----------------------------------------------------------------------------
-  Load(unsigned int ival = 15);
+  Load(unsigned int ival = 15, int fast_ival_ms = -1);
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -180,6 +262,26 @@ public:
   //----------------------------------------------------------------------------
   double GetNetRate(const char* dev, const char* tag);
 
+  //----------------------------------------------------------------------------
+  //! Get the percentage of time the device of a path is busy with IO, from
+  //! the high frequency samples if enabled, otherwise from the disk rates
+  //!
+  //! @param dev_path device path
+  //!
+  //! @return busy percentage, 0 if unknown
+  //----------------------------------------------------------------------------
+  double GetDiskBusy(const char* dev_path);
+
+  //----------------------------------------------------------------------------
+  //! Get the average number of requests queued on the device of a path, from
+  //! the high frequency samples if enabled, otherwise from the disk rates
+  //!
+  //! @param dev_path device path
+  //!
+  //! @return average queue depth, 0 if unknown
+  //----------------------------------------------------------------------------
+  double GetDiskQueueDepth(const char* dev_path);
+
   //----------------------------------------------------------------------------
   //! Static method used to start the scrubber thread
   //----------------------------------------------------------------------------
@@ -188,7 +290,9 @@ public:
 private:
   pthread_t mTid; ///< Monitor thread id
   unsigned int mInterval; ///< Sampling interval for the monitor thread
+  unsigned int mFastIntervalMs; ///< High frequency sampling interval
   DiskStat fDiskStat; ///< Disk statistics
+  DiskBusy fDiskBusy; ///< High frequency disk utilization
   NetStat fNetStat; ///< Network statistics
 };
 
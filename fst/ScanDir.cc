@@ -28,77 +28,52 @@
 #include "fst/Config.hh"
 #include "fst/XrdFstOfs.hh"
 #include "fst/io/FileIoPluginCommon.hh"
+#include "fst/io/BufferPool.hh"
 #include "fst/FmdDbMap.hh"
 #include "fst/checksum/ChecksumPlugins.hh"
+#include "fst/utils/IoPriority.hh"
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <new>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/time.h>
-#ifndef __APPLE__
-#include <sys/syscall.h>
-#endif
 #include <syslog.h>
 #include <unistd.h>
 #include <fcntl.h>
 
+EOSFSTNAMESPACE_BEGIN
+
+constexpr time_t ScanDir::kCursorInterval;
+
 //------------------------------------------------------------------------------
-// We're missing ioprio.h and gettid
+// Get the number of reader threads used to verify the files of a filesystem
 //------------------------------------------------------------------------------
-static int
-ioprio_set(int which, int who, int ioprio)
+static uint32_t
+GetScanReaders()
 {
-#ifdef __APPLE__
-  return 0;
-#else
-  return syscall(SYS_ioprio_set, which, who, ioprio);
-#endif
+  static uint32_t sNumReaders = []() {
+    const char* ptr = getenv("EOS_FST_SCAN_READERS");
+    uint32_t num = (ptr ? strtoul(ptr, 0, 10) : 1ul);
+    return std::min(std::max(num, 1u), 16u);
+  }();
+  return sNumReaders;
 }
 
-//static int ioprio_get(int which, int who)
-//{
-//  return syscall(SYS_ioprio_get, which, who);
-//}
-
-/*
- * Gives us 8 prio classes with 13-bits of data for each class
- */
-#define IOPRIO_BITS             (16)
-#define IOPRIO_CLASS_SHIFT      (13)
-#define IOPRIO_PRIO_MASK        ((1UL << IOPRIO_CLASS_SHIFT) - 1)
-
-#define IOPRIO_PRIO_CLASS(mask) ((mask) >> IOPRIO_CLASS_SHIFT)
-#define IOPRIO_PRIO_DATA(mask)  ((mask) & IOPRIO_PRIO_MASK)
-#define IOPRIO_PRIO_VALUE(class, data)  (((class) << IOPRIO_CLASS_SHIFT) | data)
-
-#define ioprio_valid(mask)      (IOPRIO_PRIO_CLASS((mask)) != IOPRIO_CLASS_NONE)
-
-/*
- * These are the io priority groups as implemented by CFQ. RT is the realtime
- * class, it always gets premium service. BE is the best-effort scheduling
- * class, the default for any process. IDLE is the idle scheduling class, it
- * is only served when no one else is using the disk.
- */
-
-enum {
-  IOPRIO_CLASS_NONE,
-  IOPRIO_CLASS_RT,
-  IOPRIO_CLASS_BE,
-  IOPRIO_CLASS_IDLE,
-};
-
-/*
- * 8 best effort priority levels are supported
- */
-#define IOPRIO_BE_NR (8)
-
-enum {
-  IOPRIO_WHO_PROCESS = 1,
-  IOPRIO_WHO_PGRP,
-  IOPRIO_WHO_USER,
-};
-
-EOSFSTNAMESPACE_BEGIN
+//------------------------------------------------------------------------------
+// Get the disk queue depth above which the parallel scan slows down
+//------------------------------------------------------------------------------
+static double
+GetScanMaxQueueDepth()
+{
+  static double sMaxQueueDepth = []() {
+    const char* ptr = getenv("EOS_FST_SCAN_MAX_QUEUE_DEPTH");
+    double depth = (ptr ? strtod(ptr, 0) : 4.0);
+    return ((depth > 0) ? depth : 4.0);
+  }();
+  return sMaxQueueDepth;
+}
 
 //------------------------------------------------------------------------------
 // Constructor
@@ -107,7 +82,10 @@ ScanDir::ScanDir(const char* dirpath, eos::common::FileSystem::fsid_t fsid,
                  eos::fst::Load* fstload, bool bgthread, long int testinterval,
                  int ratebandwidth, bool setchecksum) :
   fstLoad(fstload), fsId(fsid), dirPath(dirpath), mTestInterval(testinterval),
-  mRateBandwidth(ratebandwidth), setChecksum(setchecksum), forcedScan(false)
+  mRateBandwidth(ratebandwidth), setChecksum(setchecksum), forcedScan(false),
+  mNumReaders(GetScanReaders()), mBusyReaders(0), mStopReaders(false),
+  mThrottleNext(std::chrono::steady_clock::now()),
+  mCursorPath(std::string(dirpath) + "/.eosscancursor"), mCursorTime(0)
 {
   thread = 0;
   noNoChecksumFiles = noScanFiles = 0;
@@ -121,12 +99,15 @@ ScanDir::ScanDir(const char* dirpath, eos::common::FileSystem::fsid_t fsid,
   size_t palignment = alignment;
 
   if (alignment > 0) {
-    bufferSize = 256 * alignment;
-
-    if (posix_memalign((void**) &buffer, palignment, bufferSize)) {
-      buffer = 0;
-      fprintf(stderr, "error: error calling posix_memaling on dirpath=%s. \n",
-              dirPath.c_str());
+    // Parallel readers use larger requests
+    bufferSize = ((mNumReaders > 1) ? 1024 : 256) * alignment;
+
+    try {
+      mBuffer = BufferPool::GetInstance().Get(bufferSize, palignment);
+      buffer = mBuffer.GetDataPtr();
+    } catch (const std::bad_alloc&) {
+      fprintf(stderr, "error: error allocating the aligned buffer on "
+              "dirpath=%s. \n", dirPath.c_str());
       return;
     }
 
@@ -161,9 +142,7 @@ ScanDir::~ScanDir()
     closelog();
   }
 
-  if (buffer) {
-    free(buffer);
-  }
+  StopReaders();
 }
 
 //------------------------------------------------------------------------------
@@ -221,21 +200,57 @@ ScanDir::ScanFiles()
     return;
   }
 
+  // Resume an interrupted pass after the last file handed out
+  std::string cursor = (bgThread ? ReadCursor() : "");
+  bool skipping = !cursor.empty();
+  bool restart = false;
+
+  if (skipping) {
+    eos_notice("msg=\"resuming scan\" dirpath=%s cursor=%s", dirPath.c_str(),
+               cursor.c_str());
+  }
+
   pthread_cleanup_push(scandir_cleanup_handle, handle);
   std::string filePath;
 
   while ((filePath = io->ftsRead(handle)) != "") {
+    if (skipping) {
+      if (filePath == cursor) {
+        skipping = false;
+      }
+
+      XrdSysThread::CancelPoint();
+      continue;
+    }
+
     if (!bgThread) {
       fprintf(stderr, "[ScanDir] processing file %s\n", filePath.c_str());
     }
 
-    CheckFile(filePath.c_str());
+    if (mNumReaders > 1) {
+      EnqueueFile(filePath);
+    } else {
+      CheckFile(filePath.c_str());
+    }
 
     if (bgThread) {
+      WriteCursor(filePath);
       XrdSysThread::CancelPoint();
     }
   }
 
+  if (mNumReaders > 1) {
+    WaitReadersIdle();
+  }
+
+  // The pass is complete unless the cursor was not found, in which case the
+  // tree is walked again from the start
+  restart = skipping;
+
+  if (bgThread) {
+    RemoveCursor();
+  }
+
   if (io->ftsClose(handle)) {
     if (bgThread) {
       eos_err("fts_close failed");
@@ -246,11 +261,93 @@ ScanDir::ScanFiles()
 
   delete handle;
   pthread_cleanup_pop(0);
+
+  if (restart) {
+    eos_warning("msg=\"scan cursor not found, restarting\" dirpath=%s "
+                "cursor=%s", dirPath.c_str(), cursor.c_str());
+    ScanFiles();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Read the scan cursor left by an interrupted pass
+//------------------------------------------------------------------------------
+std::string
+ScanDir::ReadCursor()
+{
+  std::string cursor;
+  FILE* fp = fopen(mCursorPath.c_str(), "r");
+
+  if (fp) {
+    char line[4096];
+
+    if (fgets(line, sizeof(line), fp)) {
+      cursor = line;
+
+      if (!cursor.empty() && (cursor.back() == '\n')) {
+        cursor.pop_back();
+      }
+    }
+
+    fclose(fp);
+  }
+
+  return cursor;
+}
+
+//------------------------------------------------------------------------------
+// Persist the scan cursor, at most once every kCursorInterval seconds
+//------------------------------------------------------------------------------
+void
+ScanDir::WriteCursor(const std::string& filepath)
+{
+  time_t now = time(NULL);
+
+  if (now - mCursorTime < kCursorInterval) {
+    return;
+  }
+
+  mCursorTime = now;
+  // Write to a temporary file and rename so that the cursor is never partial
+  std::string tmp_path = mCursorPath + ".tmp";
+  FILE* fp = fopen(tmp_path.c_str(), "w");
+
+  if (!fp) {
+    eos_err("msg=\"failed to write scan cursor\" path=%s errno=%d",
+            tmp_path.c_str(), errno);
+    return;
+  }
+
+  bool ok = (fprintf(fp, "%s\n", filepath.c_str()) > 0);
+  ok = (fclose(fp) == 0) && ok;
+
+  if (!ok || rename(tmp_path.c_str(), mCursorPath.c_str())) {
+    eos_err("msg=\"failed to write scan cursor\" path=%s errno=%d",
+            mCursorPath.c_str(), errno);
+    unlink(tmp_path.c_str());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove the scan cursor once a pass is complete
+//------------------------------------------------------------------------------
+void
+ScanDir::RemoveCursor()
+{
+  unlink(mCursorPath.c_str());
+  mCursorTime = 0;
 }
 
 /*----------------------------------------------------------------------------*/
 void
 ScanDir::CheckFile(const char* filepath)
+{
+  CheckFile(filepath, buffer);
+}
+
+/*----------------------------------------------------------------------------*/
+void
+ScanDir::CheckFile(const char* filepath, char* buf)
 {
   float scantime;
   unsigned long layoutid = 0;
@@ -293,6 +390,23 @@ ScanDir::CheckFile(const char* filepath)
     }
   }
 
+  // Skip files verified within the interval and not modified since, based on
+  // the check time kept in the local DB, without touching the attributes
+  unsigned long checkTime = 0;
+
+  if (bgThread && !forcedScan) {
+    eos::common::Path cPath(filePath.c_str());
+    eos::common::FileId::fileid_t fid = strtoul(cPath.GetName(), 0, 16);
+    checkTime = gFmdDbMapHandler.LocalGetCheckTime(fid, fsId);
+
+    if (checkTime && (buf1.st_mtime < (time_t) checkTime) &&
+        (time(NULL) - (time_t) checkTime < mTestInterval)) {
+      SkippedFiles++;
+      io->fileClose();
+      return;
+    }
+  }
+
 #endif
   io->attrGet("user.eos.checksumtype", checksumType);
   memset(checksumVal, 0, sizeof(checksumVal));
@@ -329,7 +443,8 @@ ScanDir::CheckFile(const char* filepath)
                                               checksumtype);
 
       if (rescan && (!ScanFileLoadAware(io, scansize, scantime, checksumVal, layoutid,
-                                        logicalFileName.c_str(), filecxerror, blockcxerror))) {
+                                        logicalFileName.c_str(), filecxerror, blockcxerror,
+                                        buf))) {
         bool reopened = false;
 #ifndef _NOOFS
 
@@ -391,9 +506,8 @@ ScanDir::CheckFile(const char* filepath)
         }
       }
 
-      // Collect statistics
+      // Collect statistics, the scan duration is the wall time of the pass
       if (rescan) {
-        durationScan += scantime;
         totalScanSize += scansize;
       }
 
@@ -401,9 +515,21 @@ ScanDir::CheckFile(const char* filepath)
 
       if (rescan) {
         if (!skiptosettime) {
-          if (io->attrSet("user.eos.timestamp", GetTimestampSmeared())) {
+          std::string timestamp = GetTimestampSmeared();
+
+          if (io->attrSet("user.eos.timestamp", timestamp)) {
             failedtoset |= true;
           }
+
+#ifndef _NOOFS
+          else if (bgThread) {
+            eos::common::Path cPath(filePath.c_str());
+            eos::common::FileId::fileid_t fid = strtoul(cPath.GetName(), 0, 16);
+            gFmdDbMapHandler.LocalUpdateCheckTime(fid, fsId,
+                                                  atoll(timestamp.c_str()) / 1000000);
+          }
+
+#endif
         }
 
         if ((io->attrSet("user.eos.filecxerror", filecxerror ? "1" : "0")) ||
@@ -517,6 +643,16 @@ ScanDir::CheckFile(const char* filepath)
     }
   } else {
     SkippedFiles++;
+#ifndef _NOOFS
+
+    // Record the check time of files verified before the DB kept it
+    if (bgThread && scanTime && (checkTime != (unsigned long) scanTime)) {
+      eos::common::Path cPath(filePath.c_str());
+      eos::common::FileId::fileid_t fid = strtoul(cPath.GetName(), 0, 16);
+      gFmdDbMapHandler.LocalUpdateCheckTime(fid, fsId, scanTime);
+    }
+
+#endif
   }
 
   io->fileClose();
@@ -646,23 +782,20 @@ void*
 ScanDir::ThreadProc(void)
 {
   if (bgThread) {
-    // set low IO priority
-    int retc = 0;
-    pid_t tid = (pid_t) syscall(SYS_gettid);
-
-    if ((retc = ioprio_set(IOPRIO_WHO_PROCESS, tid,
-                           IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 7)))) {
-      eos_err("cannot set io priority to lowest best effort = retc=%d errno=%d\n",
-              retc, errno);
-    } else {
-      eos_notice("setting io priority to 7(lowest best-effort) for PID %u", tid);
-    }
+    // set the IO priority of the scan class, lowest best-effort by default
+    IoPriority::SetThreadClass(IoPriority::kScan);
   }
 
   if (bgThread) {
     XrdSysThread::SetCancelOn();
   }
 
+  if (mNumReaders > 1) {
+    eos_notice("msg=\"starting parallel scan\" readers=%u dirpath=%s",
+               mNumReaders, dirPath.c_str());
+    StartReaders();
+  }
+
   forcedScan = false;
   struct stat buf;
   std::string forcedrun = dirPath.c_str();
@@ -678,7 +811,8 @@ ScanDir::ThreadProc(void)
     }
   }
 
-  if (bgThread && !forcedScan) {
+  // An interrupted pass is resumed right away, otherwise get a random smearing
+  if (bgThread && !forcedScan && ReadCursor().empty()) {
     // Get a random smearing and avoid that all start at the same time!
     // start in the range of 0 to 4 hours
     size_t sleeper = (4 * 3600.0 * random() / RAND_MAX);
@@ -726,22 +860,22 @@ ScanDir::ThreadProc(void)
     if (bgThread) {
       syslog(LOG_ERR,
              "Directory: %s, files=%li scanduration=%.02f [s] scansize=%lli [Bytes] [ %lli MB ] scannedfiles=%li  corruptedfiles=%li hwcorrupted=%li nochecksumfiles=%li skippedfiles=%li\n",
-             dirPath.c_str(), noTotalFiles, (durationScan / 1000.0), totalScanSize,
-             ((totalScanSize / 1000) / 1000), noScanFiles, noCorruptFiles, noHWCorruptFiles,
-             noNoChecksumFiles,
-             SkippedFiles);
+             dirPath.c_str(), noTotalFiles.load(), (durationScan / 1000.0),
+             totalScanSize.load(), ((totalScanSize.load() / 1000) / 1000),
+             noScanFiles.load(), noCorruptFiles.load(), noHWCorruptFiles.load(),
+             noNoChecksumFiles.load(), SkippedFiles.load());
       eos_notice("Directory: %s, files=%li scanduration=%.02f [s] scansize=%lli [Bytes] [ %lli MB ] scannedfiles=%li  corruptedfiles=%li hwcorrupted=%li nochecksumfiles=%li skippedfiles=%li",
-                 dirPath.c_str(), noTotalFiles, (durationScan / 1000.0), totalScanSize,
-                 ((totalScanSize / 1000) / 1000), noScanFiles, noCorruptFiles, noHWCorruptFiles,
-                 noNoChecksumFiles,
-                 SkippedFiles);
+                 dirPath.c_str(), noTotalFiles.load(), (durationScan / 1000.0),
+                 totalScanSize.load(), ((totalScanSize.load() / 1000) / 1000),
+                 noScanFiles.load(), noCorruptFiles.load(), noHWCorruptFiles.load(),
+                 noNoChecksumFiles.load(), SkippedFiles.load());
     } else {
       fprintf(stderr,
               "[ScanDir] Directory: %s, files=%li scanduration=%.02f [s] scansize=%lli [Bytes] [ %lli MB ] scannedfiles=%li  corruptedfiles=%li hwcorrupted=%li nochecksumfiles=%li skippedfiles=%li\n",
-              dirPath.c_str(), noTotalFiles, (durationScan / 1000.0), totalScanSize,
-              ((totalScanSize / 1000) / 1000), noScanFiles, noCorruptFiles, noHWCorruptFiles,
-              noNoChecksumFiles,
-              SkippedFiles);
+              dirPath.c_str(), noTotalFiles.load(), (durationScan / 1000.0),
+              totalScanSize.load(), ((totalScanSize.load() / 1000) / 1000),
+              noScanFiles.load(), noCorruptFiles.load(), noHWCorruptFiles.load(),
+              noNoChecksumFiles.load(), SkippedFiles.load());
     }
 
     if (!bgThread) {
@@ -772,6 +906,7 @@ ScanDir::ThreadProc(void)
     }
   } while (1);
 
+  StopReaders();
   return NULL;
 }
 
@@ -780,8 +915,10 @@ bool
 ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
                            unsigned long long& scansize, float& scantime,
                            const char* checksumVal, unsigned long layoutid,
-                           const char* lfn, bool& filecxerror, bool& blockcxerror)
+                           const char* lfn, bool& filecxerror, bool& blockcxerror,
+                           char* buf)
 {
+  char* data = (buf ? buf : buffer);
   double load;
   bool retVal, corruptBlockXS = false;
   int currentRate = mRateBandwidth;
@@ -816,33 +953,59 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
 
   int nread = 0;
   off_t offset = 0;
+  // In parallel mode local files are read through a separate descriptor,
+  // with O_DIRECT if supported, so that the scan does not fill the page cache
+  int fd = -1;
+  bool direct = false;
+
+  if ((mNumReaders > 1) && (filePath[0] == '/')) {
+#ifdef O_DIRECT
+    fd = open(filePath.c_str(), O_RDONLY | O_DIRECT);
+    direct = (fd >= 0);
+#endif
+
+    if (fd < 0) {
+      fd = open(filePath.c_str(), O_RDONLY);
+    }
+  }
 
   do {
     errno = 0;
-    nread = io->fileRead(offset, buffer, bufferSize);
+
+    if (mNumReaders > 1) {
+      nread = ReadChunk(io, fd, direct, offset, data, bufferSize);
+    } else {
+      nread = io->fileRead(offset, data, bufferSize);
+    }
 
     if (nread < 0) {
       if (blockXS) {
         blockXS->CloseMap();
       }
 
+      if (fd >= 0) {
+        (void) close(fd);
+      }
+
       return false;
     }
 
     if (nread) {
       if (!corruptBlockXS && blockXS)
-        if (!blockXS->CheckBlockSum(offset, buffer, nread)) {
+        if (!blockXS->CheckBlockSum(offset, data, nread)) {
           corruptBlockXS = true;
         }
 
       //      fprintf(stderr,"adding %ld %llu\n", nread,offset);
       if (normalXS) {
-        normalXS->Add(buffer, nread, offset);
+        normalXS->Add(data, nread, offset);
       }
 
       offset += nread;
 
-      if (currentRate) {
+      if (mNumReaders > 1) {
+        ThrottleScan(nread);
+      } else if (currentRate) {
         // regulate the verification rate
         gettimeofday(&currenttime, &tz);
         scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
@@ -855,7 +1018,7 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
         }
 
         //adjust the rate according to the load information
-        load = fstLoad->GetDiskRate(dirPath.c_str(), "millisIO") / 1000.0;
+        load = fstLoad->GetDiskBusy(dirPath.c_str()) / 100.0;
 
         if (load > 0.7) {
           //adjust currentRate
@@ -869,6 +1032,10 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
     }
   } while (nread == bufferSize);
 
+  if (fd >= 0) {
+    (void) close(fd);
+  }
+
   gettimeofday(&currenttime, &tz);
   scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
                 currenttime.tv_usec - opentime.tv_usec) / 1000.0));
@@ -950,4 +1117,226 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
   return retVal;
 }
 
+//------------------------------------------------------------------------------
+// Start the reader threads used by the parallel scan
+//------------------------------------------------------------------------------
+void
+ScanDir::StartReaders()
+{
+  std::unique_lock<std::mutex> lock(mPendingMutex);
+  mStopReaders = false;
+
+  while (mReaders.size() < mNumReaders) {
+    mReaders.emplace_back(&ScanDir::ReaderProc, this);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Stop and join the reader threads
+//------------------------------------------------------------------------------
+void
+ScanDir::StopReaders()
+{
+  {
+    std::unique_lock<std::mutex> lock(mPendingMutex);
+    mStopReaders = true;
+    mPending.clear();
+  }
+  mPendingCond.notify_all();
+
+  for (auto& reader : mReaders) {
+    reader.join();
+  }
+
+  mReaders.clear();
+}
+
+//------------------------------------------------------------------------------
+// Loop run by the reader threads
+//------------------------------------------------------------------------------
+void
+ScanDir::ReaderProc()
+{
+  if (bgThread) {
+    // Same IO priority as the thread walking the tree
+    IoPriority::SetThreadClass(IoPriority::kScan);
+  }
+
+  BufferPool::Buffer lease;
+
+  try {
+    lease = BufferPool::GetInstance().Get(bufferSize, alignment);
+  } catch (const std::bad_alloc&) {
+    eos_err("msg=\"failed to allocate scan buffer\" dirpath=%s", dirPath.c_str());
+    return;
+  }
+
+  char* buf = lease.GetDataPtr();
+
+  std::string filepath;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mPendingMutex);
+      mPendingCond.wait(lock, [&] {
+        return (mStopReaders || !mPending.empty());
+      });
+
+      if (mStopReaders) {
+        break;
+      }
+
+      filepath = mPending.front();
+      mPending.pop_front();
+      ++mBusyReaders;
+    }
+
+    if (!bgThread) {
+      fprintf(stderr, "[ScanDir] processing file %s\n", filepath.c_str());
+    }
+
+    CheckFile(filepath.c_str(), buf);
+    {
+      std::unique_lock<std::mutex> lock(mPendingMutex);
+      --mBusyReaders;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Queue a file to be verified by the readers. The walking thread can be
+// cancelled, therefore it polls instead of waiting on the condition variable.
+//------------------------------------------------------------------------------
+void
+ScanDir::EnqueueFile(const std::string& filepath)
+{
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mPendingMutex);
+
+      if (mPending.size() < 2 * mNumReaders) {
+        mPending.push_back(filepath);
+        mPendingCond.notify_one();
+        return;
+      }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    if (bgThread) {
+      XrdSysThread::CancelPoint();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Wait until all the queued files are verified
+//------------------------------------------------------------------------------
+void
+ScanDir::WaitReadersIdle()
+{
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mPendingMutex);
+
+      if (mPending.empty() && (mBusyReaders == 0)) {
+        return;
+      }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    if (bgThread) {
+      XrdSysThread::CancelPoint();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Read a chunk of the file in parallel mode
+//------------------------------------------------------------------------------
+int64_t
+ScanDir::ReadChunk(const std::unique_ptr<eos::fst::FileIo>& io, int fd,
+                   bool direct, off_t offset, char* buf, int64_t length)
+{
+  if (fd < 0) {
+    return io->fileRead(offset, buf, length);
+  }
+
+  int64_t nread = 0;
+
+  while (nread < length) {
+    ssize_t n = pread(fd, buf + nread, length - nread, offset + nread);
+
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return -1;
+    }
+
+    if (n == 0) {
+      break;
+    }
+
+    nread += n;
+
+    // O_DIRECT reads past the end of file come back short
+    if (direct && (nread % alignment)) {
+      break;
+    }
+  }
+
+#ifdef POSIX_FADV_DONTNEED
+
+  if (!direct && nread) {
+    (void) posix_fadvise(fd, offset, nread, POSIX_FADV_DONTNEED);
+  }
+
+#endif
+  return nread;
+}
+
+//------------------------------------------------------------------------------
+// Throttle the parallel scan
+//------------------------------------------------------------------------------
+void
+ScanDir::ThrottleScan(uint64_t nbytes)
+{
+  double rate = mRateBandwidth;
+
+  if (rate <= 0) {
+    return;
+  }
+
+  if (fstLoad) {
+    // Average number of requests queued on the device
+    double queue_depth = fstLoad->GetDiskQueueDepth(dirPath.c_str());
+    double max_depth = GetScanMaxQueueDepth();
+
+    if (queue_depth > max_depth) {
+      rate = std::max(rate * max_depth / queue_depth, 1.0);
+    }
+  }
+
+  // Rate in MB/s is the same as bytes per microsecond
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::duration delay;
+  {
+    std::unique_lock<std::mutex> lock(mThrottleMutex);
+
+    if (mThrottleNext < now) {
+      mThrottleNext = now;
+    }
+
+    delay = mThrottleNext - now;
+    mThrottleNext += std::chrono::microseconds((int64_t)(nbytes / rate));
+  }
+
+  if (delay.count() > 0) {
+    std::this_thread::sleep_for(delay);
+  }
+}
+
 EOSFSTNAMESPACE_END
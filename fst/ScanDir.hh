@@ -26,9 +26,17 @@
 
 #include <pthread.h>
 #include "fst/Namespace.hh"
+#include "fst/io/BufferPool.hh"
 #include "common/Logging.hh"
 #include "common/FileSystem.hh"
 #include "XrdOuc/XrdOucString.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <sys/syscall.h>
 #ifndef __APPLE__
@@ -45,6 +53,17 @@ class CheckSum;
 //! Class ScanDir
 //! @brief Scan a directory tree and checks checksums (and blockchecksums if
 //! present) on a regular interval with limited bandwidth
+//!
+//! When EOS_FST_SCAN_READERS is bigger than 1, the tree is walked by one
+//! thread and the files are verified by a pool of reader threads. The readers
+//! use large O_DIRECT reads (or drop the pages from the cache once read),
+//! share the scan bandwidth budget and reduce it when the queue depth of the
+//! disk goes above EOS_FST_SCAN_MAX_QUEUE_DEPTH.
+//!
+//! The background scan keeps the last file handed out in a cursor file at the
+//! top of the tree so that an interrupted pass is resumed where it stopped,
+//! and skips files whose last check time recorded in the local DB is recent
+//! enough and newer than their modification time.
 //------------------------------------------------------------------------------
 class ScanDir : eos::common::LogId
 {
@@ -77,13 +96,22 @@ public:
 
   void CheckFile(const char*);
 
+  //----------------------------------------------------------------------------
+  //! Check file using the given buffer for reading
+  //!
+  //! @param filepath file path
+  //! @param buf aligned buffer of size bufferSize
+  //----------------------------------------------------------------------------
+  void CheckFile(const char* filepath, char* buf);
+
   std::unique_ptr<eos::fst::CheckSum> GetBlockXS(const char*,
     unsigned long long maxfilesize);
 
   bool ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>&,
                          unsigned long long&, float&, const char*,
                          unsigned long, const char* lfn,
-                         bool& filecxerror, bool& blockxserror);
+                         bool& filecxerror, bool& blockxserror,
+                         char* buf = nullptr);
 
   std::string GetTimestamp();
 
@@ -92,6 +120,80 @@ public:
   bool RescanFile(std::string);
 
 private:
+  //----------------------------------------------------------------------------
+  //! Start the reader threads used by the parallel scan
+  //----------------------------------------------------------------------------
+  void StartReaders();
+
+  //----------------------------------------------------------------------------
+  //! Stop and join the reader threads
+  //----------------------------------------------------------------------------
+  void StopReaders();
+
+  //----------------------------------------------------------------------------
+  //! Loop run by the reader threads, verifies the files in the queue
+  //----------------------------------------------------------------------------
+  void ReaderProc();
+
+  //----------------------------------------------------------------------------
+  //! Queue a file to be verified by the readers, blocks while the queue is
+  //! full
+  //!
+  //! @param filepath file path
+  //----------------------------------------------------------------------------
+  void EnqueueFile(const std::string& filepath);
+
+  //----------------------------------------------------------------------------
+  //! Wait until all the queued files are verified
+  //----------------------------------------------------------------------------
+  void WaitReadersIdle();
+
+  //----------------------------------------------------------------------------
+  //! Read a chunk of the file in parallel mode, using O_DIRECT if possible
+  //!
+  //! @param io file object used if no local descriptor is available
+  //! @param fd local descriptor or -1
+  //! @param direct true if fd is opened with O_DIRECT
+  //! @param offset read offset
+  //! @param buf buffer
+  //! @param length read length
+  //!
+  //! @return number of bytes read or -1 in case of error
+  //----------------------------------------------------------------------------
+  int64_t ReadChunk(const std::unique_ptr<eos::fst::FileIo>& io, int fd,
+                    bool direct, off_t offset, char* buf, int64_t length);
+
+  //----------------------------------------------------------------------------
+  //! Throttle the parallel scan so that all the readers together stay within
+  //! the scan rate. The rate is reduced in proportion to the disk queue depth
+  //! when this is above the configured maximum.
+  //!
+  //! @param nbytes number of bytes just read
+  //----------------------------------------------------------------------------
+  void ThrottleScan(uint64_t nbytes);
+
+  //----------------------------------------------------------------------------
+  //! Read the scan cursor left by an interrupted pass
+  //!
+  //! @return path of the last file handed out or empty if none
+  //----------------------------------------------------------------------------
+  std::string ReadCursor();
+
+  //----------------------------------------------------------------------------
+  //! Persist the scan cursor, at most once every kCursorInterval seconds
+  //!
+  //! @param filepath path of the last file handed out
+  //----------------------------------------------------------------------------
+  void WriteCursor(const std::string& filepath);
+
+  //----------------------------------------------------------------------------
+  //! Remove the scan cursor once a pass is complete
+  //----------------------------------------------------------------------------
+  void RemoveCursor();
+
+  //! Min interval in seconds between two updates of the scan cursor
+  static constexpr time_t kCursorInterval = 30;
+
   eos::fst::Load* fstLoad;
   eos::common::FileSystem::fsid_t fsId;
   XrdOucString dirPath;
@@ -99,23 +201,38 @@ private:
   std::atomic<int> mRateBandwidth; ///< Max scan rate in MB/s
 
   // Statistics
-  long int noScanFiles;
-  long int noCorruptFiles;
-  long int noHWCorruptFiles;
+  std::atomic<long int> noScanFiles;
+  std::atomic<long int> noCorruptFiles;
+  std::atomic<long int> noHWCorruptFiles;
   float durationScan;
-  long long int totalScanSize;
+  std::atomic<long long int> totalScanSize;
   long long int bufferSize;
-  long int noNoChecksumFiles;
-  long int noTotalFiles;
-  long int SkippedFiles;
+  std::atomic<long int> noNoChecksumFiles;
+  std::atomic<long int> noTotalFiles;
+  std::atomic<long int> SkippedFiles;
 
   bool setChecksum;
 
   long alignment;
+  BufferPool::Buffer mBuffer; ///< buffer of the walking thread
   char* buffer;
   pthread_t thread;
   bool bgThread;
-  bool forcedScan;
+  std::atomic<bool> forcedScan;
+
+  // Parallel scan
+  uint32_t mNumReaders; ///< Number of reader threads, 1 means no readers
+  std::vector<std::thread> mReaders; ///< Reader threads
+  std::mutex mPendingMutex; ///< Mutex protecting the members below
+  std::condition_variable mPendingCond; ///< Signal new files or stop
+  std::deque<std::string> mPending; ///< Files waiting to be verified
+  uint32_t mBusyReaders; ///< Readers currently verifying a file
+  bool mStopReaders; ///< Readers should exit
+  std::mutex mThrottleMutex; ///< Mutex protecting the throttle slot
+  ///< Time from which the next chunk can be read
+  std::chrono::steady_clock::time_point mThrottleNext;
+  std::string mCursorPath; ///< Path of the scan cursor file
+  time_t mCursorTime; ///< Last time the scan cursor was written
 };
 
 EOSFSTNAMESPACE_END
@@ -57,6 +57,7 @@ public:
   bool commitChecksum;
   bool commitSize;
   bool commitFmd;
+  bool background; ///< queued after the user requested verifications
 
   unsigned int verifyRate;
 
@@ -80,6 +81,7 @@ public:
     commitSize = inCommitSize;
     verifyRate = inVerifyRate;
     commitFmd = inCommitFmd;
+    background = false;
   }
 
   static Verify*
@@ -155,9 +157,16 @@ public:
     int envlen = 0;
     fid = eos::common::FileId::Hex2Fid(hexfid.c_str());
     fsid = atoi(sfsid);
-    return new Verify(fid, fsid, localprefix, smanager, capOpaque->Env(envlen),
-                      container, cid, lid, path, computeChecksum, commitChecksum, commitSize,
-                      commitFmd, verifyRate);
+    Verify* verify = new Verify(fid, fsid, localprefix, smanager,
+                                capOpaque->Env(envlen), container, cid, lid,
+                                path, computeChecksum, commitChecksum,
+                                commitSize, commitFmd, verifyRate);
+
+    if (capOpaque->Get("mgm.verify.background")) {
+      verify->background = atoi(capOpaque->Get("mgm.verify.background"));
+    }
+
+    return verify;
   };
 
   ~Verify() { };
@@ -170,9 +179,9 @@ public:
   {
     eos_static_info("Verify fid=%llu on fs=%u path=%s compute_checksum=%d "
                     "commit_checksum=%d commit_size=%d commit_fmd=%d "
-                    "verify_rate=%d %s", fId, fsId, path.c_str(),
+                    "verify_rate=%d background=%d %s", fId, fsId, path.c_str(),
                     computeChecksum, commitChecksum, commitSize, commitFmd,
-                    verifyRate, show);
+                    verifyRate, background, show);
   }
 };
 
@@ -165,6 +165,32 @@ XrdFstOfs::XrdFstOfs() :
     fprintf(stderr, "Config Enabled CallManager xrootd connection pool with "
             "size=%i\n", max_size);
   }
+
+  if (CommitBatcher::GetMaxDelay().count()) {
+    mCommitBatcher.reset(new CommitBatcher(
+    [this](const std::string & manager, const std::string & opaque,
+    std::string & response) {
+      XrdOucErrInfo error;
+      XrdOucString query = opaque.c_str();
+      XrdOucString result;
+      int rc = CallManager(&error, "/", manager.empty() ? nullptr :
+                           manager.c_str(), query, &result, 0, true, false);
+      response = result.c_str();
+      return rc;
+    }, CommitBatcher::GetMaxDelay(), CommitBatcher::GetMaxEntries()));
+    fprintf(stderr, "Config Enabled commit batching with max_delay=%lims "
+            "max_entries=%zu\n", (long) CommitBatcher::GetMaxDelay().count(),
+            CommitBatcher::GetMaxEntries());
+  }
+
+  if (AsyncCommitQueue::GetNumThreads()) {
+    mAsyncCommitQueue.reset(new AsyncCommitQueue(
+                              AsyncCommitQueue::GetNumThreads(),
+                              AsyncCommitQueue::GetMaxAttempts()));
+    fprintf(stderr, "Config Enabled asynchronous close with threads=%zu "
+            "max_attempts=%zu\n", AsyncCommitQueue::GetNumThreads(),
+            AsyncCommitQueue::GetMaxAttempts());
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -263,6 +289,8 @@ XrdFstOfs::xrdfstofs_shutdown(int sig)
   std::this_thread::sleep_for(std::chrono::seconds(1));
   gOFS.Storage->ShutdownThreads();
   eos_static_warning("%s", "op=shutdown msg=\"stop messaging\"");
+  // Last attempt of the pending asynchronous close commits
+  gOFS.mAsyncCommitQueue.reset();
   eos_static_warning("%s", "op=shutdown msg=\"shutdown fmddbmap handler\"");
   gFmdDbMapHandler.Shutdown();
 
@@ -337,6 +365,8 @@ XrdFstOfs::xrdfstofs_graceful_shutdown(int sig)
     eos_static_err("op=shutdown msg=\"failed graceful IO shutdown\"");
   }
 
+  // Last attempt of the pending asynchronous close commits
+  gOFS.mAsyncCommitQueue.reset();
   std::this_thread::sleep_for(std::chrono::seconds(1));
   gOFS.Storage->ShutdownThreads();
   eos_static_warning("op=shutdown msg=\"shutdown fmddbmap handler\"");
@@ -814,6 +844,7 @@ XrdFstOfs::Configure(XrdSysError& Eroute, XrdOucEnv* envP)
     mHttpd->Start();
   }
 
+  mMetricsPush.Start("fst", eos::common::MetricsPush::GetIntervalFromEnv());
   eos_notice("FST_HOST=%s FST_PORT=%ld FST_HTTP_PORT=%d VERSION=%s RELEASE=%s KEYTABADLER=%s",
              mHostName, myPort, mHttpdPort, VERSION, RELEASE, kt_cks.c_str());
   return 0;
@@ -977,43 +1008,7 @@ again:
   } else {
     eos_static_err("msg=\"MGM query failed\" opaque=\"%s\"", opaque.c_str());
     msg = (status.GetErrorMessage().c_str());
-    rc = SFS_ERROR;
-
-    if (msg.find("[EIDRM]") != STR_NPOS) {
-      rc = EIDRM;
-    }
-
-    if (msg.find("[EBADE]") != STR_NPOS) {
-      rc = EBADE;
-    }
-
-    if (msg.find("[EBADR]") != STR_NPOS) {
-      rc = EBADR;
-    }
-
-    if (msg.find("[EINVAL]") != STR_NPOS) {
-      rc = EINVAL;
-    }
-
-    if (msg.find("[EADV]") != STR_NPOS) {
-      rc = EADV;
-    }
-
-    if (msg.find("[EAGAIN]") != STR_NPOS) {
-      rc = EAGAIN;
-    }
-
-    if (msg.find("[ENOTCONN]") != STR_NPOS) {
-      rc = ENOTCONN;
-    }
-
-    if (msg.find("[EPROTO]") != STR_NPOS) {
-      rc = EPROTO;
-    }
-
-    if (msg.find("[EREMCHG]") != STR_NPOS) {
-      rc = EREMCHG;
-    }
+    rc = GetManagerErrorCode(msg);
 
     if (rc != SFS_ERROR) {
       return gOFS.Emsg(epname, *error, rc, msg.c_str(), path);
@@ -1052,6 +1047,82 @@ again:
   return rc;
 }
 
+//------------------------------------------------------------------------------
+// Get the error code tagged in an error message of the manager
+//------------------------------------------------------------------------------
+int
+XrdFstOfs::GetManagerErrorCode(const XrdOucString& msg)
+{
+  int rc = SFS_ERROR;
+
+  if (msg.find("[EIDRM]") != STR_NPOS) {
+    rc = EIDRM;
+  }
+
+  if (msg.find("[EBADE]") != STR_NPOS) {
+    rc = EBADE;
+  }
+
+  if (msg.find("[EBADR]") != STR_NPOS) {
+    rc = EBADR;
+  }
+
+  if (msg.find("[EINVAL]") != STR_NPOS) {
+    rc = EINVAL;
+  }
+
+  if (msg.find("[EADV]") != STR_NPOS) {
+    rc = EADV;
+  }
+
+  if (msg.find("[EAGAIN]") != STR_NPOS) {
+    rc = EAGAIN;
+  }
+
+  if (msg.find("[ENOTCONN]") != STR_NPOS) {
+    rc = ENOTCONN;
+  }
+
+  if (msg.find("[EPROTO]") != STR_NPOS) {
+    rc = EPROTO;
+  }
+
+  if (msg.find("[EREMCHG]") != STR_NPOS) {
+    rc = EREMCHG;
+  }
+
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+// Commit a replica to the manager
+//------------------------------------------------------------------------------
+int
+XrdFstOfs::CommitReplica(XrdOucErrInfo* error, const char* path,
+                         const char* manager, XrdOucString& capOpaqueFile)
+{
+  EPNAME("CommitReplica");
+
+  if (mCommitBatcher) {
+    CommitBatcher::Result res =
+      mCommitBatcher->Commit(manager ? manager : "", capOpaqueFile.c_str());
+
+    if (!res.mFallback) {
+      if (res.mErrno == 0) {
+        return SFS_OK;
+      }
+
+      // Same error codes as a commit sent through CallManager
+      XrdOucString msg = res.mMsg.c_str();
+      int rc = GetManagerErrorCode(msg);
+      return gOFS.Emsg(epname, *error, (rc != SFS_ERROR) ? rc : ECOMM,
+                       msg.c_str(), path);
+    }
+  }
+
+  return CallManager(error, path, manager, capOpaqueFile, nullptr, 0, true);
+}
+
 //------------------------------------------------------------------------------
 // Set debug level based on the env info
 //------------------------------------------------------------------------------
@@ -1158,7 +1229,12 @@ XrdFstOfs::SendRtLog(XrdMqMessage* message)
 }
 
 //------------------------------------------------------------------------------
-//
+// Send the fsck inconsistency sets of all filesystems. An incremental request
+// carries the "<epoch>:<seq>" entries of all FSTs known to the MGM, if the
+// own entry is found only the changes since this sequence number are sent
+// as "+tag@fsid:..." and "-tag@fsid:..." lines. Filesystems whose feed does
+// not reach back far enough are sent in full and listed in the header line
+// "#fsck <epoch> <seq> <fsid,...>" so the MGM replaces their state.
 //------------------------------------------------------------------------------
 void
 XrdFstOfs::SendFsck(XrdMqMessage* message)
@@ -1167,83 +1243,139 @@ XrdFstOfs::SendFsck(XrdMqMessage* message)
   XrdOucString stdOut = "";
   // The tag is either '*' for all or a, seperated list of tag names
   XrdOucString tag = opaque.Get("mgm.fsck.tags");
+  bool incremental = (opaque.Get("mgm.fsck.incremental") != nullptr);
+  bool has_since = false;
+  uint64_t since = 0;
+
+  if (incremental && opaque.Get("mgm.fsck.since")) {
+    std::vector<std::string> entries;
+    std::string prefix = gOFS.Storage->mFsckEpoch + ":";
+    eos::common::StringConversion::Tokenize(opaque.Get("mgm.fsck.since"),
+                                            entries, ",");
+
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+      if (it->compare(0, prefix.length(), prefix) == 0) {
+        since = strtoull(it->c_str() + prefix.length(), 0, 10);
+        has_since = true;
+        break;
+      }
+    }
+  }
+
+  auto send_reply = [&]() {
+    XrdMqMessage repmessage("fsck reply message");
+    repmessage.SetBody(stdOut.c_str());
+    repmessage.MarkAsMonitor();
+
+    if (!XrdMqMessaging::gMessageClient.ReplyMessage(repmessage, *message)) {
+      eos_err("unable to send fsck reply message to %s",
+              message->kMessageHeader.kSenderId.c_str());
+    }
+
+    stdOut = "";
+  };
+  // Append a line "<prefix><tag>@<fsid>:<fid>:<fid>..." split into replies
+  // of at most 64kB
+  auto append_set = [&](const char* prefix, const std::string & itag,
+                        eos::common::FileSystem::fsid_t fsid,
+                        const std::set<eos::common::FileId::fileid_t>& fids,
+  bool skip_open) {
+    char stag[4096];
+    snprintf(stag, sizeof(stag) - 1, "%s%s@%lu", prefix, itag.c_str(),
+             (unsigned long) fsid);
+    stdOut += stag;
+
+    for (auto fit = fids.cbegin(); fit != fids.cend(); ++fit) {
+      // Don't report files which are currently write-open
+      if (skip_open && gOFS.openedForWriting.isOpen(fsid, *fit)) {
+        continue;
+      }
+
+      char sfid[4096];
+      snprintf(sfid, sizeof(sfid) - 1, ":%08llx", *fit);
+      stdOut += sfid;
+
+      if (stdOut.length() > (64 * 1024)) {
+        stdOut += "\n";
+        send_reply();
+        stdOut = stag;
+      }
+    }
+
+    stdOut += "\n";
+  };
+  auto selected = [&](const std::string & itag) {
+    return ((itag != "mem_n") && (itag != "d_sync_n") && (itag != "m_sync_n") &&
+            ((tag == "*") || ((tag.find(itag.c_str()) != STR_NPOS))));
+  };
 
   if ((!tag.length())) {
     eos_err("parameter tag missing");
   } else {
-    stdOut = "";
-    // loop over filesystems
+    // Read the sequence number before the sets, changes racing with this
+    // reply are sent again with the next one
+    uint64_t seq = gOFS.Storage->mFsckSeq.load();
+    std::string full_fsids;
     eos::common::RWMutexReadLock fsLock(gOFS.Storage->mFsMutex);
-    std::vector <eos::fst::FileSystem*>::const_iterator it;
 
     for (unsigned int i = 0; i < gOFS.Storage->mFsVect.size(); i++) {
-      XrdSysMutexHelper ISLock(
-        gOFS.Storage->mFsVect[i]->InconsistencyStatsMutex);
-      std::map<std::string, std::set<eos::common::FileId::fileid_t> >* icset =
-        gOFS.Storage->mFsVect[i]->GetInconsistencySets();
-      std::map<std::string, std::set<eos::common::FileId::fileid_t> >::const_iterator
-      icit;
-
-      for (icit = icset->begin(); icit != icset->end(); icit++) {
-        // loop over all tags
-        if (((icit->first != "mem_n") && (icit->first != "d_sync_n") &&
-             (icit->first != "m_sync_n")) &&
-            ((tag == "*") || ((tag.find(icit->first.c_str()) != STR_NPOS)))) {
-          char stag[4096];
-          eos::common::FileSystem::fsid_t fsid =
-            gOFS.Storage->mFsVect[i]->GetId();
-          snprintf(stag, sizeof(stag) - 1, "%s@%lu", icit->first.c_str(),
-                   (unsigned long) fsid);
-          stdOut += stag;
-          std::set<eos::common::FileId::fileid_t>::const_iterator fit;
-
-          if (gOFS.Storage->mFsVect[i]->GetStatus() !=
-              eos::common::FileSystem::kBooted) {
-            // we don't report filesystems which are not booted!
-            continue;
+      eos::fst::FileSystem* fs = gOFS.Storage->mFsVect[i];
+      eos::common::FileSystem::fsid_t fsid = fs->GetId();
+      XrdSysMutexHelper ISLock(fs->InconsistencyStatsMutex);
+
+      if (has_since) {
+        std::map<std::string, std::set<eos::common::FileId::fileid_t> > added;
+        std::map<std::string, std::set<eos::common::FileId::fileid_t> > removed;
+
+        if (fs->GetInconsistencyDelta(since, added, removed)) {
+          for (auto icit = added.cbegin(); icit != added.cend(); ++icit) {
+            if (selected(icit->first) && icit->second.size()) {
+              append_set("+", icit->first, fsid, icit->second, false);
+            }
           }
 
-          for (fit = icit->second.begin(); fit != icit->second.end(); fit++) {
-            // Don't report files which are currently write-open
-            if (gOFS.openedForWriting.isOpen(fsid, *fit)) {
-              continue;
+          for (auto icit = removed.cbegin(); icit != removed.cend(); ++icit) {
+            if (selected(icit->first) && icit->second.size()) {
+              append_set("-", icit->first, fsid, icit->second, false);
             }
+          }
 
-            // loop over all fids
-            char sfid[4096];
-            snprintf(sfid, sizeof(sfid) - 1, ":%08llx", *fit);
-            stdOut += sfid;
+          continue;
+        }
+      }
 
-            if (stdOut.length() > (64 * 1024)) {
-              stdOut += "\n";
-              XrdMqMessage repmessage("fsck reply message");
-              repmessage.SetBody(stdOut.c_str());
-              repmessage.MarkAsMonitor();
+      if (incremental && fsid) {
+        if (full_fsids.length()) {
+          full_fsids += ",";
+        }
 
-              if (!XrdMqMessaging::gMessageClient.ReplyMessage(repmessage, *message)) {
-                eos_err("unable to send fsck reply message to %s",
-                        message->kMessageHeader.kSenderId.c_str());
-              }
+        full_fsids += std::to_string(fsid);
+      }
 
-              stdOut = stag;
-            }
-          }
+      if (fs->GetStatus() != eos::common::FileSystem::kBooted) {
+        // we don't report filesystems which are not booted!
+        continue;
+      }
+
+      std::map<std::string, std::set<eos::common::FileId::fileid_t> >* icset =
+        fs->GetInconsistencySets();
 
-          stdOut += "\n";
+      for (auto icit = icset->cbegin(); icit != icset->cend(); ++icit) {
+        if (selected(icit->first)) {
+          append_set("", icit->first, fsid, icit->second, true);
         }
       }
     }
+
+    if (incremental) {
+      std::string header = "#fsck " + gOFS.Storage->mFsckEpoch + " " +
+                           std::to_string(seq) + " " + full_fsids + "\n";
+      stdOut.insert(header.c_str(), 0);
+    }
   }
 
   if (stdOut.length()) {
-    XrdMqMessage repmessage("fsck reply message");
-    repmessage.SetBody(stdOut.c_str());
-    repmessage.MarkAsMonitor();
-
-    if (!XrdMqMessaging::gMessageClient.ReplyMessage(repmessage, *message)) {
-      eos_err("unable to send fsck reply message to %s",
-              message->kMessageHeader.kSenderId.c_str());
-    }
+    send_reply();
   }
 }
 
@@ -1301,7 +1433,8 @@ int
 XrdFstOfs::_rem(const char* path, XrdOucErrInfo& error,
                 const XrdSecEntity* client, XrdOucEnv* capOpaque,
                 const char* fstpath, unsigned long long fid,
-                unsigned long fsid, bool ignoreifnotexist)
+                unsigned long fsid, bool ignoreifnotexist,
+                bool deleteFmd)
 {
   EPNAME("rem");
   XrdOucString fstPath = "";
@@ -1398,7 +1531,7 @@ XrdFstOfs::_rem(const char* path, XrdOucErrInfo& error,
     MakeDeletionReport(fsid, fid, sbd);
   }
 
-  if (!gFmdDbMapHandler.LocalDeleteFmd(fid, fsid)) {
+  if (deleteFmd && !gFmdDbMapHandler.LocalDeleteFmd(fid, fsid)) {
     eos_notice("unable to delete fmd for fid %llu on filesystem %lu", fid, fsid);
     return gOFS.Emsg(epname, error, EIO, "delete file meta data ", fstPath.c_str());
   }
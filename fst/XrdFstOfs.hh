@@ -28,8 +28,11 @@
 #include "fst/Config.hh"
 #include "fst/Fmd.hh"
 #include "fst/utils/OpenFileTracker.hh"
+#include "fst/utils/AsyncCommitQueue.hh"
+#include "fst/utils/CommitBatcher.hh"
 #include "common/Logging.hh"
 #include "common/XrdConnPool.hh"
+#include "common/MetricsPush.hh"
 #include "mq/XrdMqMessaging.hh"
 #include "mq/XrdMqSharedObject.hh"
 #include "XrdOfs/XrdOfs.hh"
@@ -257,6 +260,9 @@ public:
 
   //----------------------------------------------------------------------------
   //! Remove path - low-level function
+  //!
+  //! @param deleteFmd if false the local metadata record is kept, the caller
+  //!        deletes it e.g. in a batch with other records
   //----------------------------------------------------------------------------
   int _rem(const char* path,
            XrdOucErrInfo& out_error,
@@ -265,7 +271,8 @@ public:
            const char* fstPath = 0,
            unsigned long long fid = 0,
            unsigned long fsid = 0,
-           bool ignoreifnotexist = false);
+           bool ignoreifnotexist = false,
+           bool deleteFmd = true);
 
   //----------------------------------------------------------------------------
   //! Get checksum - we publish checksums at the MGM
@@ -307,6 +314,20 @@ public:
                   bool use_xrd_conn_pool = false,
                   bool retry = true);
 
+  //----------------------------------------------------------------------------
+  //! Commit a replica to the manager - batched with the commits of other
+  //! closes if EOS_FST_COMMIT_BATCH_MS is set, otherwise sent through
+  //! CallManager. The error codes are the same in both cases.
+  //----------------------------------------------------------------------------
+  int CommitReplica(XrdOucErrInfo* error, const char* path,
+                    const char* manager, XrdOucString& capOpaqueFile);
+
+  //----------------------------------------------------------------------------
+  //! Get the error code tagged in an error message of the manager, e.g.
+  //! "[EIDRM]", or SFS_ERROR if there is none
+  //----------------------------------------------------------------------------
+  static int GetManagerErrorCode(const XrdOucString& msg);
+
   //----------------------------------------------------------------------------
   //! Function dealing with plugin calls
   //----------------------------------------------------------------------------
@@ -380,9 +401,16 @@ public:
   QdbContactDetails mQdbContactDetails; ///< QDB contact details
   bool mMqOnQdb; ///< Are we using QDB as an MQ?
   int mHttpdPort; ///< listening port of the http server
+  //! Push of the metrics to the targets set by the MGM in monitoring.targets
+  eos::common::MetricsPush mMetricsPush;
 private:
   //! Xrd connection pool for interaction with the MGM, used from CallManager
   std::unique_ptr<eos::common::XrdConnPool> mMgmXrdPool;
+  //! Batches the replica commits of concurrent closes, used from CommitReplica
+  std::unique_ptr<CommitBatcher> mCommitBatcher;
+  //! Background commits of the files closed asynchronously by fusex clients,
+  //! null if EOS_FST_ASYNC_CLOSE_THREADS is not set
+  std::unique_ptr<AsyncCommitQueue> mAsyncCommitQueue;
   HttpServer* mHttpd; ///< Embedded http server
   bool Simulate_IO_read_error; ///< simulate an IO error on read
   bool Simulate_IO_write_error; ///< simulate an IO error on write
@@ -22,7 +22,9 @@
  ************************************************************************/
 #define __STDC_FORMAT_MACROS
 #include <cinttypes>
+#include <fcntl.h>
 #include "common/Constants.hh"
+#include "common/Metrics.hh"
 #include "common/Path.hh"
 #include "common/http/OwnCloud.hh"
 #include "common/StringTokenizer.hh"
@@ -37,7 +39,11 @@
 #include "fst/storage/FileSystem.hh"
 #include "authz/XrdCapability.hh"
 #include "XrdOss/XrdOssApi.hh"
+#include "XrdOuc/XrdOucSFVec.hh"
+#include "XrdSfs/XrdSfsDio.hh"
 #include "fst/io/FileIoPluginCommon.hh"
+#include "fst/io/BufferPool.hh"
+#include "fst/utils/ReadVCoalescer.hh"
 
 extern XrdOssSys* XrdOfsOss;
 
@@ -55,9 +61,9 @@ XrdFstOfsFile::XrdFstOfsFile(const char* user, int MonID) :
   writeDelete(false), mRainSize(0), mNsPath(""), mLocalPrefix(""),
   mRedirectManager(""), mSecString(""), mTpcKey(""), mEtag(""), mFileId(0),
   mFsId(0), mLid(0), mCid(0), mForcedMtime(1), mForcedMtime_ms(0), mFusex(false),
-  mFusexIsUnlinked(false),
+  mFusexIsUnlinked(false), mAsyncClose(false),
   closed(false), opened(false), mHasWrite(false), hasWriteError(false),
-  hasReadError(false), isRW(false), mIsTpcDst(false), mIsDevNull(false),
+  hasReadError(false), isRW(false), mSendFile(false), mIsTpcDst(false), mIsDevNull(false),
   isCreation(false), isReplication(false), mIsInjection(false),
   mRainReconstruct(false), deleteOnClose(false), repairOnClose(false),
   commitReconstruction(false), mEventOnClose(false), mEventWorkflow(""),
@@ -421,6 +427,16 @@ XrdFstOfsFile::open(const char* path, XrdSfsFileOpenMode open_mode,
   }
 
   eos_info("fstpath=%s", mFstPath.c_str());
+
+  // An asynchronous close of the file may still be committing its meta data,
+  // wait for it so that we get the committed record
+  if (gOFS.mAsyncCommitQueue &&
+      !gOFS.mAsyncCommitQueue->Wait(GetAsyncCommitKey(mFsId, mFileId),
+                                    std::chrono::seconds(5))) {
+    eos_warning("msg=\"asynchronous commit of a previous close still "
+                "pending\" fsid=%lu fxid=%08llx", mFsId, mFileId);
+  }
+
   fMd = gFmdDbMapHandler.LocalGetFmd(mFileId, mFsId, vid.uid, vid.gid, mLid, isRW,
                                      isRepairRead);
 
@@ -990,6 +1006,128 @@ XrdFstOfsFile::verifychecksum()
   return checksumerror;
 }
 
+//------------------------------------------------------------------------------
+// Get the key of the asynchronous commits of a file
+//------------------------------------------------------------------------------
+std::string
+XrdFstOfsFile::GetAsyncCommitKey(unsigned long fsid, unsigned long long fid)
+{
+  return std::to_string(fsid) + ":" + std::to_string(fid);
+}
+
+//------------------------------------------------------------------------------
+// Check if the meta data of the file can be committed asynchronously
+//------------------------------------------------------------------------------
+bool
+XrdFstOfsFile::CanCommitAsync()
+{
+  if (!mAsyncClose || !gOFS.mAsyncCommitQueue || !layOut->IsEntryServer() ||
+      IsRainLayout(layOut->GetLayoutId()) || mRainReconstruct ||
+      isReplication || mIsInjection || IsChunkedUpload() ||
+      mEventOnClose || mSyncEventOnClose) {
+    return false;
+  }
+
+  // The close returns before the commit so the data has to be on disk
+  if (layOut->Sync()) {
+    eos_warning("msg=\"failed to sync the file, committing synchronously\" "
+                "path=%s", mNsPath.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Commit the meta data of the file in the background
+//------------------------------------------------------------------------------
+int
+XrdFstOfsFile::CommitAsync(const XrdOucString& capOpaqueFile)
+{
+  EPNAME("close");
+  std::shared_ptr<FmdHelper> fmd = std::make_shared<FmdHelper>();
+  fmd->mProtoFmd.CopyFrom(fMd->mProtoFmd);
+  const char* ptr = mCapOpaque->Get("mgm.manager");
+  bool has_manager = (ptr != nullptr);
+  std::string manager = (ptr ? ptr : "");
+  ptr = mCapOpaque->Get("mgm.path");
+  std::string path = (ptr ? ptr : "");
+  std::string opaque = capOpaqueFile.c_str();
+  unsigned long fsid = mFsId;
+  unsigned long long fid = mFileId;
+  bool fmd_committed = false;
+  AsyncCommitQueue::Job job = [=](size_t attempt) mutable {
+    if (!fmd_committed) {
+      if (!gFmdDbMapHandler.Commit(fmd.get())) {
+        eos_static_err("msg=\"unable to commit meta data to local database\" "
+                       "fsid=%lu fxid=%08llx attempt=%zu", fsid, fid, attempt);
+        return AsyncCommitQueue::Status::kRetry;
+      }
+
+      fmd_committed = true;
+    }
+
+    XrdOucErrInfo error;
+    XrdOucString query = opaque.c_str();
+    int rc = gOFS.CommitReplica(&error, path.c_str(),
+                                has_manager ? manager.c_str() : nullptr, query);
+
+    if (rc == 0) {
+      gOFS.Storage->CloseTransaction(fsid, fid);
+      return AsyncCommitQueue::Status::kDone;
+    }
+
+    int errc = error.getErrInfo();
+
+    if ((errc == EIDRM) || (errc == EBADE) || (errc == EBADR) ||
+        (errc == EREMCHG)) {
+      // Rejected by the MGM, which released the caps of the file so that the
+      // fusex clients see the state of the namespace
+      gOFS.Storage->CloseTransaction(fsid, fid);
+
+      if (errc == EIDRM) {
+        eos_static_info("msg=\"asynchronous commit of an unlinked file\" "
+                        "fsid=%lu fxid=%08llx path=%s", fsid, fid, path.c_str());
+      } else {
+        eos_static_err("msg=\"asynchronous commit rejected\" fsid=%lu "
+                       "fxid=%08llx path=%s errc=%d msg=\"%s\"", fsid, fid,
+                       path.c_str(), errc, error.getErrText());
+      }
+
+      return AsyncCommitQueue::Status::kFailed;
+    }
+
+    eos_static_warning("msg=\"asynchronous commit failed, will retry\" "
+                       "fsid=%lu fxid=%08llx path=%s attempt=%zu rc=%d msg=\"%s\"",
+                       fsid, fid, path.c_str(), attempt, rc, error.getErrText());
+    return AsyncCommitQueue::Status::kRetry;
+  };
+  AsyncCommitQueue::GiveUp give_up = [=]() {
+    // The open transaction makes the cleaner resync the file with the MGM
+    eos_static_crit("msg=\"giving up asynchronous commit, keeping the "
+                    "transaction\" fsid=%lu fxid=%08llx path=%s", fsid, fid,
+                    path.c_str());
+  };
+
+  if (gOFS.mAsyncCommitQueue->Push(GetAsyncCommitKey(fsid, fid), job,
+                                   give_up)) {
+    eos_info("msg=\"queued asynchronous commit\" fxid=%08llx path=%s", fid,
+             mNsPath.c_str());
+    return SFS_OK;
+  }
+
+  // The queue is full, commit in place with a single attempt
+  eos_warning("msg=\"asynchronous commit queue full, committing in place\" "
+              "path=%s", mNsPath.c_str());
+
+  if (job(1) == AsyncCommitQueue::Status::kDone) {
+    return SFS_OK;
+  }
+
+  return gOFS.Emsg(epname, this->error, EIO, "close - unable to commit meta "
+                   "data", mNsPath.c_str());
+}
+
 //------------------------------------------------------------------------------
 // Close file
 //------------------------------------------------------------------------------
@@ -1005,6 +1143,7 @@ XrdFstOfsFile::close()
   bool minimumsizeerror = false;
   bool consistencyerror = false;
   bool atomicoverlap = false;
+  bool asyncCommit = false;
 
   // Any close on a file opened in TPC mode invalidates tpc keys
   if (mTpcKey.length()) {
@@ -1227,14 +1366,20 @@ XrdFstOfsFile::close()
               fMd->mProtoFmd.set_gid(atoi(mCapOpaque->Get("mgm.source.rgid")));
             }
 
+            // For an asynchronous close the data is synced now and the meta
+            // data is committed in the background
+            asyncCommit = CanCommitAsync();
+
             // Commit local
-            try {
-              if (!gFmdDbMapHandler.Commit(fMd)) {
-                eos_err("unabel to commit meta data to local database");
-                (void) gOFS.Emsg(epname, this->error, EIO, "close - unable to "
-                                 "commit meta data", mNsPath.c_str());
-              }
-            } catch (const std::length_error& e) {}
+            if (!asyncCommit) {
+              try {
+                if (!gFmdDbMapHandler.Commit(fMd)) {
+                  eos_err("unabel to commit meta data to local database");
+                  (void) gOFS.Emsg(epname, this->error, EIO, "close - unable to "
+                                   "commit meta data", mNsPath.c_str());
+                }
+              } catch (const std::length_error& e) {}
+            }
 
             // Commit to central mgm cache
             int envlen = 0;
@@ -1266,6 +1411,11 @@ XrdFstOfsFile::close()
               capOpaqueFile += "&mgm.fusex=1";
             }
 
+            if (asyncCommit) {
+              // Lets the MGM release the caps of the file if it rejects it
+              capOpaqueFile += "&mgm.fusex.async=1";
+            }
+
             if (mHasWrite) {
               capOpaqueFile += "&mgm.modified=1";
             }
@@ -1308,11 +1458,16 @@ XrdFstOfsFile::close()
               capOpaqueFile += eos::common::OwnCloud::FilterOcQuery(mOpenOpaque->Env(envlen));
             }
 
-            rc = gOFS.CallManager(&error, mCapOpaque->Get("mgm.path"),
-                                  mCapOpaque->Get("mgm.manager"), capOpaqueFile,
-                                  nullptr, 0, true);
+            if (asyncCommit) {
+              // The transaction is closed by the commit in the background
+              rc = CommitAsync(capOpaqueFile);
+            } else {
+              rc = gOFS.CommitReplica(&error, mCapOpaque->Get("mgm.path"),
+                                      mCapOpaque->Get("mgm.manager"),
+                                      capOpaqueFile);
+            }
 
-            if (rc) {
+            if (rc && !asyncCommit) {
               if ((error.getErrInfo() == EIDRM) || (error.getErrInfo() == EBADE) ||
                   (error.getErrInfo() == EBADR) || (error.getErrInfo() == EREMCHG)) {
                 if (!gOFS.Storage->CloseTransaction(mFsId, mFileId)) {
@@ -1359,7 +1514,7 @@ XrdFstOfsFile::close()
                   gOFS.Storage->CloseTransaction(mFsId, mFileId);
                 }
               }
-            } else {
+            } else if (!rc) {
               committed = true;
             }
           }
@@ -1367,7 +1522,7 @@ XrdFstOfsFile::close()
       }
     }
 
-    if (isRW && (rc == SFS_OK)) {
+    if (isRW && (rc == SFS_OK) && !asyncCommit) {
       gOFS.Storage->CloseTransaction(mFsId, mFileId);
     }
 
@@ -1764,10 +1919,17 @@ XrdSfsXferSize
 XrdFstOfsFile::readofs(XrdSfsFileOffset fileOffset, char* buffer,
                        XrdSfsXferSize buffer_size)
 {
+  IoPriorityGuard io_guard(mIoClass);
+
+  if (mIoThrottle && (buffer_size > 0)) {
+    mIoThrottle->Acquire(buffer_size);
+  }
+
   gettimeofday(&cTime, &tz);
   rCalls++;
   int rc = XrdOfsFile::read(fileOffset, buffer, buffer_size);
-  eos_debug("read %llu %llu %i rc=%d", this, fileOffset, buffer_size, rc);
+  eos_hotpath_debug("read %llu %llu %i rc=%d", this, fileOffset, buffer_size,
+                    rc);
 
   if (gOFS.Simulate_IO_read_error) {
     return gOFS.Emsg("readofs", error, EIO, "read file - simulated IO error fn=",
@@ -1775,42 +1937,50 @@ XrdFstOfsFile::readofs(XrdSfsFileOffset fileOffset, char* buffer,
                                    mCapOpaque->Get("mgm.path") : FName()) : FName());
   }
 
+  AccountRead(fileOffset, rc);
+  gettimeofday(&lrTime, &tz);
+  AddReadTime();
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+// Account a read in the seek and read statistics
+//------------------------------------------------------------------------------
+void
+XrdFstOfsFile::AccountRead(XrdSfsFileOffset offset, XrdSfsXferSize length)
+{
   // Account seeks for monitoring
-  if (rOffset != static_cast<unsigned long long>(fileOffset)) {
-    if (rOffset < static_cast<unsigned long long>(fileOffset)) {
+  if (rOffset != static_cast<unsigned long long>(offset)) {
+    if (rOffset < static_cast<unsigned long long>(offset)) {
       nFwdSeeks++;
-      sFwdBytes += (fileOffset - rOffset);
+      sFwdBytes += (offset - rOffset);
     } else {
       nBwdSeeks++;
-      sBwdBytes += (rOffset - fileOffset);
+      sBwdBytes += (rOffset - offset);
     }
 
     if ((rOffset + (EOS_FSTOFS_LARGE_SEEKS)) < (static_cast<unsigned long long>
-        (fileOffset))) {
-      sXlFwdBytes += (fileOffset - rOffset);
+        (offset))) {
+      sXlFwdBytes += (offset - rOffset);
       nXlFwdSeeks++;
     }
 
     if ((static_cast<unsigned long long>(rOffset) > (EOS_FSTOFS_LARGE_SEEKS)) &&
         (rOffset - (EOS_FSTOFS_LARGE_SEEKS)) > (static_cast<unsigned long long>
-            (fileOffset))) {
-      sXlBwdBytes += (rOffset - fileOffset);
+            (offset))) {
+      sXlBwdBytes += (rOffset - offset);
       nXlBwdSeeks++;
     }
   }
 
-  if (rc > 0) {
+  if (length > 0) {
     if (layOut->IsEntryServer() || IsRainLayout(mLid)) {
       XrdSysMutexHelper vecLock(vecMutex);
-      rvec.push_back(rc);
+      rvec.push_back(length);
     }
 
-    rOffset = fileOffset + rc;
+    rOffset = offset + length;
   }
-
-  gettimeofday(&lrTime, &tz);
-  AddReadTime();
-  return rc;
 }
 
 //------------------------------------------------------------------------------
@@ -1820,7 +1990,7 @@ int
 XrdFstOfsFile::read(XrdSfsFileOffset fileOffset, XrdSfsXferSize amount)
 {
   int rc = XrdOfsFile::read(fileOffset, amount);
-  eos_debug("rc=%d offset=%lu size=%llu", rc, fileOffset, amount);
+  eos_hotpath_debug("rc=%d offset=%lu size=%llu", rc, fileOffset, amount);
   return rc;
 }
 
@@ -1831,7 +2001,7 @@ XrdSfsXferSize
 XrdFstOfsFile::read(XrdSfsFileOffset fileOffset, char* buffer,
                     XrdSfsXferSize buffer_size)
 {
-  eos_debug("fileOffset=%lli, buffer_size=%i", fileOffset, buffer_size);
+  eos_hotpath_debug("fileOffset=%lli, buffer_size=%i", fileOffset, buffer_size);
 
   //  EPNAME("read");
   if (mTpcFlag == kTpcSrcRead) {
@@ -1846,7 +2016,7 @@ XrdFstOfsFile::read(XrdSfsFileOffset fileOffset, char* buffer,
   }
 
   int rc = layOut->Read(fileOffset, buffer, buffer_size);
-  eos_debug("layout read %d checkSum %d", rc, mCheckSum.get());
+  eos_hotpath_debug("layout read %d checkSum %d", rc, mCheckSum.get());
 
   if ((rc > 0) && (mCheckSum)) {
     XrdSysMutexHelper cLock(ChecksumMutex);
@@ -1856,6 +2026,11 @@ XrdFstOfsFile::read(XrdSfsFileOffset fileOffset, char* buffer,
 
   if (rc > 0) {
     rOffset = fileOffset + rc;
+    static eos::common::MetricCounter& read_bytes =
+      eos::common::MetricsRegistry::Instance().GetCounter(
+        "eos_fst_read_bytes_total", "Bytes read by clients");
+    read_bytes.Inc(rc);
+    gOFS.openedForReading.addIo(mFsId, mFileId, rc);
   }
 
   gettimeofday(&lrTime, &tz);
@@ -1873,8 +2048,8 @@ XrdFstOfsFile::read(XrdSfsFileOffset fileOffset, char* buffer,
     hasReadError = true;
   }
 
-  eos_debug("rc=%d offset=%lu size=%llu", rc, fileOffset,
-            static_cast<unsigned long long>(buffer_size));
+  eos_hotpath_debug("rc=%d offset=%lu size=%llu", rc, fileOffset,
+                    static_cast<unsigned long long>(buffer_size));
 
   if ((fileOffset + buffer_size) >= openSize) {
     if (mCheckSum) {
@@ -1898,9 +2073,54 @@ XrdFstOfsFile::read(XrdSfsFileOffset fileOffset, char* buffer,
 XrdSfsXferSize
 XrdFstOfsFile::readvofs(XrdOucIOVec* readV, uint32_t readCount)
 {
-  eos_debug("read count=%i", readCount);
+  eos_hotpath_debug("read count=%i", readCount);
   gettimeofday(&cTime, &tz);
-  XrdSfsXferSize sz = XrdOfsFile::readv(readV, readCount);
+  XrdSfsXferSize sz = -1;
+  bool done = false;
+  uint32_t max_gap = ReadVCoalescer::GetMaxGap();
+
+  if (max_gap && (readCount > 1)) {
+    // Merge chunks which are close to each other into bigger reads and copy
+    // the data back into the chunk buffers
+    ReadVCoalescer coalescer(readV, readCount, max_gap);
+
+    if (coalescer.IsCoalesced()) {
+      XrdSfsXferSize nread;
+
+      if (coalescer.GetReadCount() == 1) {
+        XrdOucIOVec* merged = coalescer.GetReadV();
+        nread = XrdOfsFile::read(merged->offset, merged->data, merged->size);
+      } else {
+        nread = XrdOfsFile::readv(coalescer.GetReadV(),
+                                  coalescer.GetReadCount());
+      }
+
+      // Short reads fall back to the original vector read below
+      if (nread == (XrdSfsXferSize) coalescer.GetReadLength()) {
+        coalescer.Scatter();
+        sz = coalescer.GetReqLength();
+        done = true;
+        ReadVCoalescer::Stats& stats = ReadVCoalescer::GetStats();
+        stats.mReqBytes += coalescer.GetReqLength();
+        stats.mReadBytes += coalescer.GetReadLength();
+        stats.mReqChunks += readCount;
+        stats.mReadChunks += coalescer.GetReadCount();
+      }
+    }
+  }
+
+  if (!done) {
+    sz = XrdOfsFile::readv(readV, readCount);
+
+    if (sz > 0) {
+      ReadVCoalescer::Stats& stats = ReadVCoalescer::GetStats();
+      stats.mReqBytes += sz;
+      stats.mReadBytes += sz;
+      stats.mReqChunks += readCount;
+      stats.mReadChunks += readCount;
+    }
+  }
+
   gettimeofday(&lrvTime, &tz);
   AddReadVTime();
   // Collect monitoring info
@@ -1924,7 +2144,7 @@ XrdFstOfsFile::readvofs(XrdOucIOVec* readV, uint32_t readCount)
 XrdSfsXferSize
 XrdFstOfsFile::readv(XrdOucIOVec* readV, int readCount)
 {
-  eos_debug("read count=%i", readCount);
+  eos_hotpath_debug("read count=%i", readCount);
   // Copy the XrdOucIOVec structure to XrdCl::ChunkList
   uint32_t total_read = 0;
   XrdCl::ChunkList chunkList;
@@ -1937,7 +2157,13 @@ XrdFstOfsFile::readv(XrdOucIOVec* readV, int readCount)
                                          (void*)readV[i].data));
   }
 
-  return layOut->ReadV(chunkList, total_read);
+  XrdSfsXferSize rc = layOut->ReadV(chunkList, total_read);
+
+  if (rc > 0) {
+    gOFS.openedForReading.addIo(mFsId, mFileId, rc);
+  }
+
+  return rc;
 }
 
 //------------------------------------------------------------------------------
@@ -1996,6 +2222,12 @@ XrdFstOfsFile::writeofs(XrdSfsFileOffset fileOffset, const char* buffer,
     }
   }
 
+  IoPriorityGuard io_guard(mIoClass);
+
+  if (mIoThrottle && (buffer_size > 0)) {
+    mIoThrottle->Acquire(buffer_size);
+  }
+
   gettimeofday(&cTime, &tz);
   wCalls++;
   int rc = XrdOfsFile::write(fileOffset, buffer, buffer_size);
@@ -2051,8 +2283,8 @@ XrdFstOfsFile::write(XrdSfsFileOffset fileOffset, const char* buffer,
                      XrdSfsXferSize buffer_size)
 {
   if (mIsDevNull) {
-    eos_debug("offset=%llu, length=%li discarded for sink file", fileOffset,
-              buffer_size);
+    eos_hotpath_debug("offset=%llu, length=%li discarded for sink file",
+                      fileOffset, buffer_size);
     maxOffsetWritten = fileOffset + buffer_size;
     return buffer_size;
   }
@@ -2071,6 +2303,12 @@ XrdFstOfsFile::write(XrdSfsFileOffset fileOffset, const char* buffer,
 
   // Evt. add checksum
   if (rc > 0) {
+    static eos::common::MetricCounter& write_bytes =
+      eos::common::MetricsRegistry::Instance().GetCounter(
+        "eos_fst_write_bytes_total", "Bytes written by clients");
+    write_bytes.Inc(rc);
+    gOFS.openedForWriting.addIo(mFsId, mFileId, rc);
+
     if (mCheckSum) {
       XrdSysMutexHelper cLock(ChecksumMutex);
       mCheckSum->Add(buffer, static_cast<size_t>(rc),
@@ -2084,8 +2322,8 @@ XrdFstOfsFile::write(XrdSfsFileOffset fileOffset, const char* buffer,
   }
 
   mHasWrite = true;
-  eos_debug("rc=%d offset=%lu size=%lu", rc, fileOffset,
-            static_cast<unsigned long>(buffer_size));
+  eos_hotpath_debug("rc=%d offset=%lu size=%lu", rc, fileOffset,
+                    static_cast<unsigned long>(buffer_size));
 
   if (rc < 0) {
     int envlen = 0;
@@ -2549,6 +2787,124 @@ XrdFstOfsFile::fctl(const int cmd, int alen, const char* args,
   return SFS_ERROR;
 }
 
+//------------------------------------------------------------------------------
+// Implementation dependant commands (version 1)
+//------------------------------------------------------------------------------
+int
+XrdFstOfsFile::fctl(const int cmd, const char* args, XrdOucErrInfo& out_error)
+{
+  if (cmd == SFS_FCTL_GETFD) {
+    mSendFile = IsSendFileCandidate();
+    out_error.setErrCode(mSendFile ? SFS_SFIO_FDVAL : -1);
+    return SFS_OK;
+  }
+
+  return XrdOfsFile::fctl(cmd, args, out_error);
+}
+
+//------------------------------------------------------------------------------
+// Check if the file can be served using the SendData interface
+//------------------------------------------------------------------------------
+bool
+XrdFstOfsFile::IsSendFileCandidate()
+{
+  static bool disabled = (getenv("EOS_FST_NO_SENDFILE") != nullptr);
+
+  if (disabled || isRW || !layOut ||
+      (eos::common::LayoutId::GetLayoutType(mLid) !=
+       eos::common::LayoutId::kPlain)) {
+    return false;
+  }
+
+  FileIo* io = layOut->GetFileIo();
+  return (io && (io->GetIoType() == "LocalIo"));
+}
+
+//------------------------------------------------------------------------------
+// Get a duplicate of the local file descriptor to send the whole file
+//------------------------------------------------------------------------------
+int
+XrdFstOfsFile::GetSendFileFd()
+{
+  if (!IsSendFileCandidate() || mCheckSum || (mTpcFlag == kTpcSrcRead) ||
+      gOFS.Simulate_IO_read_error ||
+      XrdOfsFile::fctl(SFS_FCTL_GETFD, 0, error)) {
+    return -1;
+  }
+
+  int fd = fcntl(error.getErrInfo(), F_DUPFD_CLOEXEC, 0);
+
+  if (fd < 0) {
+    eos_err("msg=\"failed to duplicate file descriptor\" errno=%d fxid=%08llx",
+            errno, mFileId);
+    return -1;
+  }
+
+  gettimeofday(&cTime, &tz);
+  rCalls++;
+  AccountRead(0, openSize);
+  gettimeofday(&lrTime, &tz);
+  AddReadTime();
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+// Send data to the client using sendfile from the local file descriptor
+//------------------------------------------------------------------------------
+int
+XrdFstOfsFile::SendData(XrdSfsDio* sfDio, XrdSfsFileOffset offset,
+                        XrdSfsXferSize size)
+{
+  // The first entry is reserved for the response header
+  XrdOucSFVec sfvec[2];
+  int fd = -1;
+
+  if (mSendFile && !mCheckSum && (mTpcFlag != kTpcSrcRead) &&
+      !gOFS.Simulate_IO_read_error &&
+      !XrdOfsFile::fctl(SFS_FCTL_GETFD, 0, error)) {
+    fd = error.getErrInfo();
+  }
+
+  if (fd < 0) {
+    // Regular read through the layout
+    BufferPool::Buffer buffer = BufferPool::GetInstance().Get(size);
+    XrdSfsXferSize nread = read(offset, buffer.GetDataPtr(), size);
+
+    if (nread < 0) {
+      return SFS_ERROR;
+    }
+
+    sfvec[1].buffer = buffer.GetDataPtr();
+    sfvec[1].sendsz = nread;
+    sfvec[1].fdnum = -1;
+    return (sfDio->SendFile(sfvec, 2) ? SFS_ERROR : SFS_OK);
+  }
+
+  // Don't send beyond the end of the file
+  if (offset >= openSize) {
+    size = 0;
+  } else if (offset + size > openSize) {
+    size = openSize - offset;
+  }
+
+  gettimeofday(&cTime, &tz);
+  rCalls++;
+  sfvec[1].offset = offset;
+  sfvec[1].sendsz = size;
+  sfvec[1].fdnum = fd;
+
+  if (sfDio->SendFile(sfvec, 2)) {
+    eos_err("msg=\"sendfile failed\" offset=%lli length=%i fxid=%08llx",
+            offset, size, mFileId);
+    return SFS_ERROR;
+  }
+
+  AccountRead(offset, size);
+  gettimeofday(&lrTime, &tz);
+  AddReadTime();
+  return SFS_OK;
+}
+
 //------------------------------------------------------------------------------
 // Filter out particular tags from the opaque information
 //------------------------------------------------------------------------------
@@ -2675,6 +3031,13 @@ XrdFstOfsFile::ProcessOpenOpaque()
     mFusex = true;
   }
 
+  // fst.asyncclose=1 - The fusex client accepts that the meta data is
+  // committed in the background after the close returned
+  if (mFusex && (val = mOpenOpaque->Get("fst.asyncclose")) &&
+      (strcmp(val, "1") == 0)) {
+    mAsyncClose = true;
+  }
+
   // Handle workflow events
   if ((val = mOpenOpaque->Get("mgm.event"))) {
     std::string event = val;
@@ -2716,6 +3079,12 @@ XrdFstOfsFile::ProcessOpenOpaque()
     mIsOCchunk = true;
   }
 
+  if ((val = mOpenOpaque->Get("s3.part.offset"))) {
+    // S3 multipart uploads write their parts in place, an interrupted part
+    // must not clean up the parts which are already stored
+    mIsOCchunk = true;
+  }
+
   // Check if transfer is still valid to avoid any open replays
   if ((val = mOpenOpaque->Get("fst.valid"))) {
     try {
@@ -2949,6 +3318,22 @@ XrdFstOfsFile::ProcessMixedOpaque()
   mFsId = atoi(sfsid);
   FileId::FidPrefix2FullPath(FileId::Fid2Hex(mFileId).c_str(),
                              mLocalPrefix.c_str(), mFstPath);
+  // The application is the last field of the security summary,
+  // drain and balance transfers run in their background IO class
+  std::string sec = mSecString.c_str();
+  size_t pos = sec.rfind('|');
+  mIoClass = IoPriority::GetClassFromApp((pos == std::string::npos) ? sec :
+                                         sec.substr(pos + 1));
+
+  if (mIoClass != IoPriority::kUser) {
+    eos::common::RWMutexReadLock lock(gOFS.Storage->mFsMutex);
+    auto it_fs = gOFS.Storage->mFileSystemsMap.find(mFsId);
+
+    if (it_fs != gOFS.Storage->mFileSystemsMap.end()) {
+      mIoThrottle = &it_fs->second->GetIoThrottle(mIoClass);
+    }
+  }
+
   return SFS_OK;
 }
 
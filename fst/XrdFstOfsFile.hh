@@ -30,6 +30,7 @@
 #include "fst/Namespace.hh"
 #include "fst/checksum/CheckSum.hh"
 #include "fst/storage/Storage.hh"
+#include "fst/utils/IoPriority.hh"
 #include "common/FileId.hh"
 #include "XrdOfs/XrdOfs.hh"
 #include "XrdOfs/XrdOfsTPCInfo.hh"
@@ -90,6 +91,35 @@ public:
                    const char* args,
                    const XrdSecEntity* client = 0);
 
+  //----------------------------------------------------------------------------
+  //! Execute special operation on the file (version 1). The local file
+  //! descriptor is never returned for SFS_FCTL_GETFD since sending data
+  //! directly from it would bypass the layout, instead the SendData interface
+  //! is offered for plain files read from the local disk.
+  //!
+  //! @param cmd operation to be performed
+  //! @param args data sent with the request
+  //! @param out_error error information, for SFS_FCTL_GETFD it holds the
+  //!        file descriptor value
+  //!
+  //! @return SFS_OK if successful, otherwise SFS_ERROR
+  //----------------------------------------------------------------------------
+  virtual int fctl(const int cmd, const char* args, XrdOucErrInfo& out_error);
+
+  //----------------------------------------------------------------------------
+  //! Send data to the client using sendfile from the local file descriptor.
+  //! Falls back to a regular read if the data needs to go through the layout
+  //! e.g. for checksum verification.
+  //!
+  //! @param sfDio object used to send the data
+  //! @param offset file offset
+  //! @param size amount of data to send
+  //!
+  //! @return SFS_OK if data was sent, otherwise SFS_ERROR
+  //----------------------------------------------------------------------------
+  virtual int SendData(XrdSfsDio* sfDio, XrdSfsFileOffset offset,
+                       XrdSfsXferSize size);
+
   //--------------------------------------------------------------------------
   //! Return the Etag
   //--------------------------------------------------------------------------
@@ -315,6 +345,16 @@ public:
   //--------------------------------------------------------------------------
   std::string GetFmdChecksum();
 
+  //--------------------------------------------------------------------------
+  //! Get a duplicate of the local file descriptor if the whole file can be
+  //! sent straight from the disk, i.e. plain file read from the local disk
+  //! without checksum verification. The read is accounted as if the whole
+  //! file was read and the caller owns the descriptor.
+  //!
+  //! @return file descriptor or -1 if the data has to go through the layout
+  //--------------------------------------------------------------------------
+  int GetSendFileFd();
+
   //--------------------------------------------------------------------------
   //! Check for chunked upload flag
   //--------------------------------------------------------------------------
@@ -355,12 +395,14 @@ protected:
   unsigned long long mForcedMtime_ms;
   bool mFusex; //! indicator that we are commiting from a fusex client
   bool mFusexIsUnlinked; //! indicator for an already unlinked file
+  bool mAsyncClose; //! fusex client asked for an asynchronous commit at close
   bool closed; //! indicator the file is closed
   bool opened; //! indicator that file is opened
   bool mHasWrite; //! indicator that file was written/modified
   bool hasWriteError;// indicator for write errros to avoid message flooding
   bool hasReadError; //! indicator if a RAIN file could be reconstructed or not
   bool isRW; //! indicator that file is opened for rw
+  bool mSendFile; //! data can be sent to the client using sendfile
   bool mIsTpcDst; ///< If true this is a TPC destination, otherwise a source
   bool mIsDevNull; ///< If true file act as a sink i.e. /dev/null
   bool isCreation; //! indicator that a new file is created
@@ -514,6 +556,21 @@ private:
   //--------------------------------------------------------------------------
   void AddReadTime();
 
+  //--------------------------------------------------------------------------
+  //! Account a successful read in the seek and read statistics
+  //!
+  //! @param offset read offset
+  //! @param length number of bytes read
+  //--------------------------------------------------------------------------
+  void AccountRead(XrdSfsFileOffset offset, XrdSfsXferSize length);
+
+  //--------------------------------------------------------------------------
+  //! Check if the file can be served using the SendData interface i.e. plain
+  //! layout opened for reading from the local disk. Can be disabled using the
+  //! EOS_FST_NO_SENDFILE env variable.
+  //--------------------------------------------------------------------------
+  bool IsSendFileCandidate();
+
   //--------------------------------------------------------------------------
   //! Compute total time to serve vector read requests
   //--------------------------------------------------------------------------
@@ -569,6 +626,33 @@ private:
   //----------------------------------------------------------------------------
   void MakeReportEnv(XrdOucString& reportString);
 
+  //----------------------------------------------------------------------------
+  //! Get the key of the asynchronous commits of a file
+  //----------------------------------------------------------------------------
+  static std::string GetAsyncCommitKey(unsigned long fsid,
+                                       unsigned long long fid);
+
+  //----------------------------------------------------------------------------
+  //! Check if the meta data of the file can be committed in the background at
+  //! close, i.e. a fusex client asked for it and the file is a plain or
+  //! replica file written through this entry server. The data is synced to
+  //! disk if so.
+  //!
+  //! @return true if the commit can be done asynchronously, otherwise false
+  //----------------------------------------------------------------------------
+  bool CanCommitAsync();
+
+  //----------------------------------------------------------------------------
+  //! Commit the meta data of the file to the local database and to the MGM in
+  //! the background, the transaction is closed once committed. If the queue
+  //! is full the commit is done in place.
+  //!
+  //! @param capOpaqueFile commit opaque sent to the MGM
+  //!
+  //! @return SFS_OK if queued or committed, otherwise SFS_ERROR
+  //----------------------------------------------------------------------------
+  int CommitAsync(const XrdOucString& capOpaqueFile);
+
   //----------------------------------------------------------------------------
   //! Static method used to start an asynchronous thread which is doing the
   //! TPC transfer
@@ -634,6 +718,10 @@ public:
   XrdSysMutex mTpcJobMutex; ///< TPC job mutex
   int mTpcRetc; ///< TPC job return code
   uint16_t mTimeout; ///< timeout for layout operations
+  //! IO class of a drain or balance transfer, kUser for the user IO
+  IoPriority::Class mIoClass {IoPriority::kUser};
+  //! Bandwidth limit of the IO class on the filesystem, null for the user IO
+  IoThrottle* mIoThrottle {nullptr};
 
   //----------------------------------------------------------------------------
   //! Notify the workflow protobuf endpoint that the user has closed a file that
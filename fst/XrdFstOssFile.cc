@@ -23,6 +23,7 @@
 
 #include <fcntl.h>
 #include <algorithm>
+#include <memory>
 #include "fst/XrdFstOss.hh"
 #include "fst/XrdFstOssFile.hh"
 #include "fst/checksum/ChecksumPlugins.hh"
@@ -326,6 +327,11 @@ XrdFstOssFile::ReadV(XrdOucIOVec* readV, int n)
 {
   ssize_t rdsz;
   ssize_t totBytes = 0;
+
+  if (mBlockXs) {
+    return ReadVBlockXs(readV, n);
+  }
+
 #if defined(__linux__)
   long long begOff, endOff, begLst = -1, endLst = -1;
   int nPR = n;
@@ -402,6 +408,111 @@ XrdFstOssFile::ReadV(XrdOucIOVec* readV, int n)
 }
 
 
+//------------------------------------------------------------------------------
+// Vector read of a file with block checksums
+//------------------------------------------------------------------------------
+ssize_t
+XrdFstOssFile::ReadVBlockXs(XrdOucIOVec* readV, int n)
+{
+  // Block aligned range covering chunks which overlap or touch
+  struct Range {
+    off_t mOffset;
+    off_t mEnd;
+    int mFirst; ///< first index in order
+    int mLast; ///< one past the last index in order
+  };
+  static const off_t sMaxRange = 8 * 1024 * 1024;
+  const off_t blk_size = eos::common::LayoutId::OssXsBlockSize;
+  std::vector<int> order;
+  std::vector<Range> ranges;
+  order.reserve(n);
+
+  for (int i = 0; i < n; ++i) {
+    if (readV[i].size > 0) {
+      order.push_back(i);
+    }
+  }
+
+  std::sort(order.begin(), order.end(), [readV](int a, int b) {
+    return (readV[a].offset < readV[b].offset);
+  });
+
+  for (int i = 0; i < (int) order.size(); ++i) {
+    const XrdOucIOVec& chunk = readV[order[i]];
+    off_t start = (chunk.offset / blk_size) * blk_size;
+    off_t end = ((chunk.offset + chunk.size + blk_size - 1) / blk_size) *
+                blk_size;
+
+    if (ranges.size() && (start <= ranges.back().mEnd) &&
+        (std::max(end, ranges.back().mEnd) - ranges.back().mOffset <= sMaxRange)) {
+      ranges.back().mEnd = std::max(end, ranges.back().mEnd);
+      ranges.back().mLast = i + 1;
+    } else {
+      ranges.push_back({start, end, i, i + 1});
+    }
+  }
+
+  off_t max_length = 0;
+
+  for (const auto& range : ranges) {
+    max_length = std::max(max_length, range.mEnd - range.mOffset);
+  }
+
+  std::unique_ptr<char[]> buffer(new char[max_length]);
+  ssize_t totBytes = 0;
+
+  for (const auto& range : ranges) {
+    ssize_t length = range.mEnd - range.mOffset;
+    ssize_t nread = 0;
+
+    while (nread < length) {
+      ssize_t rc = pread(fd, buffer.get() + nread, length - nread,
+                         range.mOffset + nread);
+
+      if (rc < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+
+        eos_err("error=failed read offset=%lli, length=%zi",
+                (long long) range.mOffset, length);
+        return -EIO;
+      }
+
+      if (rc == 0) {
+        break;
+      }
+
+      nread += rc;
+    }
+
+    if (nread) {
+      XrdSysRWLockHelper wr_lock(mRWLockXs, 0);
+
+      if (!mBlockXs->CheckBlockSum(range.mOffset, buffer.get(), nread)) {
+        eos_err("error=readv block-xs error offset=%lli, length=%zi",
+                (long long) range.mOffset, nread);
+        return -EIO;
+      }
+    }
+
+    for (int i = range.mFirst; i < range.mLast; ++i) {
+      XrdOucIOVec& chunk = readV[order[i]];
+
+      // Chunk past the end of the file
+      if (chunk.offset + chunk.size > range.mOffset + nread) {
+        return -ESPIPE;
+      }
+
+      memcpy(chunk.data, buffer.get() + (chunk.offset - range.mOffset),
+             chunk.size);
+      totBytes += chunk.size;
+    }
+  }
+
+  return totBytes;
+}
+
 //------------------------------------------------------------------------------
 // Vector write
 //------------------------------------------------------------------------------
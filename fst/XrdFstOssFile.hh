@@ -217,6 +217,20 @@ public:
   //!
   //--------------------------------------------------------------------------
   std::vector<XrdOucIOVec> AlignBuffer(void* buffer, off_t offset, size_t length);
+
+  //--------------------------------------------------------------------------
+  //! Vector read of a file with block checksums. The chunks are read by
+  //! block aligned ranges, merging the chunks which overlap or touch, and
+  //! every range is verified with a single CheckBlockSum call.
+  //!
+  //! @param readV generic data structure for vector reads
+  //! @param n number of individual reads in the vector request
+  //!
+  //! @return is successful total number of bytes read, otherwise -ESPIPE
+  //!         or -EIO if a block checksum does not match
+  //!
+  //--------------------------------------------------------------------------
+  ssize_t ReadVBlockXs(XrdOucIOVec* readV, int n);
 };
 
 EOSFSTNAMESPACE_END
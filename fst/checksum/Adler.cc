@@ -35,7 +35,31 @@ Adler::Add (const char* buffer, size_t length, off_t offset)
 
   adler = adler32(0L, Z_NULL, 0);
   Chunk currChunk;
-  adler = adler32(adler, (const Bytef*) buffer, length);
+  adler = checksum::adler32(adler, buffer, length);
+  adleroffset = offset + length;
+  if (adleroffset > maxoffset)
+  {
+    maxoffset = adleroffset;
+  }
+  currChunk.offset = offset;
+  currChunk.length = length;
+  currChunk.adler = adler;
+
+  map = AddElementToMap(map, currChunk);
+
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+Adler::AddSegment (uint32_t value, off_t offset, size_t length)
+{
+  // same as Add but with the adler of the segment already computed
+  if (offset != adleroffset)
+    needsRecalculation = true;
+
+  Chunk currChunk;
+  adler = value;
   adleroffset = offset + length;
   if (adleroffset > maxoffset)
   {
@@ -26,6 +26,7 @@
 
 #include "fst/Namespace.hh"
 #include "fst/checksum/CheckSum.hh"
+#include "common/crc32c/checksumkernels.h"
 #include "XrdOuc/XrdOucEnv.hh"
 #include "XrdOuc/XrdOucString.hh"
 #include <zlib.h>
@@ -72,6 +73,26 @@ public:
   bool Add(const char* buffer, size_t length, off_t offset);
   MapChunks& AddElementToMap(MapChunks& map, Chunk& chunk);
 
+  bool
+  IsCombinable()
+  {
+    return true;
+  }
+
+  uint32_t
+  SegmentInit()
+  {
+    return adler32(0L, Z_NULL, 0);
+  }
+
+  uint32_t
+  SegmentAdd(uint32_t value, const char* buffer, size_t length)
+  {
+    return checksum::adler32(value, buffer, length);
+  }
+
+  bool AddSegment(uint32_t value, off_t offset, size_t length);
+
   off_t
   GetLastOffset()
   {
@@ -0,0 +1,423 @@
+// ----------------------------------------------------------------------
+// File: BlockXsCache.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/checksum/BlockXsCache.hh"
+#include "common/Logging.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sys/stat.h>
+#include <unistd.h>
+
+EOSFSTNAMESPACE_BEGIN
+
+constexpr size_t BlockXsCache::kPageSize;
+
+//------------------------------------------------------------------------------
+// Get the cache size per filesystem
+//------------------------------------------------------------------------------
+size_t
+BlockXsCache::GetCapacity()
+{
+  static size_t sCapacity = []() {
+    size_t capacity = 0;
+    const char* ptr = getenv("EOS_FST_BLOCKXS_CACHE_MB");
+
+    if (ptr) {
+      long val = strtol(ptr, nullptr, 10);
+
+      if (val > 0) {
+        capacity = (size_t) val * 1024 * 1024;
+      }
+    }
+
+    return capacity;
+  }();
+  return sCapacity;
+}
+
+//------------------------------------------------------------------------------
+// Get the cache of a filesystem
+//------------------------------------------------------------------------------
+BlockXsCache*
+BlockXsCache::GetInstance(dev_t dev)
+{
+  static std::mutex sMutex;
+  static std::map<dev_t, std::unique_ptr<BlockXsCache>> sCaches;
+
+  if (!GetCapacity()) {
+    return nullptr;
+  }
+
+  std::unique_lock<std::mutex> lock(sMutex);
+  auto& cache = sCaches[dev];
+
+  if (!cache) {
+    cache.reset(new BlockXsCache(GetCapacity()));
+  }
+
+  return cache.get();
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+BlockXsCache::BlockXsCache(size_t capacity, size_t num_shards)
+{
+  num_shards = std::max(num_shards, (size_t) 1);
+  mPagesPerShard = std::max(capacity / kPageSize / num_shards, (size_t) 1);
+
+  for (size_t i = 0; i < num_shards; ++i) {
+    mShards.emplace_back(new Shard());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Attach a descriptor of a map file
+//------------------------------------------------------------------------------
+void
+BlockXsCache::Attach(ino_t ino)
+{
+  std::unique_lock<std::mutex> lock(mMapsMutex);
+  ++mMaps[ino];
+}
+
+//------------------------------------------------------------------------------
+// Detach a descriptor of a map file
+//------------------------------------------------------------------------------
+bool
+BlockXsCache::Detach(ino_t ino, int fd)
+{
+  bool last = true;
+  bool retc = true;
+  {
+    std::unique_lock<std::mutex> lock(mMapsMutex);
+    auto it = mMaps.find(ino);
+
+    if (it != mMaps.end()) {
+      if (--it->second) {
+        last = false;
+      } else {
+        mMaps.erase(it);
+      }
+    }
+  }
+
+  for (auto& shard : mShards) {
+    std::unique_lock<std::mutex> lock(shard->mMutex);
+    auto it_ino = shard->mPages.find(ino);
+
+    if (it_ino == shard->mPages.end()) {
+      continue;
+    }
+
+    std::vector<PageList::iterator> pages;
+
+    for (auto& elem : it_ino->second) {
+      pages.push_back(elem.second);
+    }
+
+    for (auto& it : pages) {
+      // The descriptor is about to be closed, its dirty pages can not wait
+      if ((it->mFd == fd) || (last && (it->mFd != -1))) {
+        if (!WriteBack(*it)) {
+          retc = false;
+          Erase(*shard, it);
+          continue;
+        }
+      }
+
+      if (last) {
+        Erase(*shard, it);
+      }
+    }
+  }
+
+  return retc;
+}
+
+//------------------------------------------------------------------------------
+// Read a range of a map file
+//------------------------------------------------------------------------------
+bool
+BlockXsCache::Read(ino_t ino, int fd, off_t offset, char* buffer,
+                   size_t length)
+{
+  while (length) {
+    uint64_t index = offset / kPageSize;
+    size_t page_off = offset % kPageSize;
+    size_t len = std::min(length, kPageSize - page_off);
+    Shard& shard = GetShard(ino, index);
+    std::unique_lock<std::mutex> lock(shard.mMutex);
+    Page* page = GetPage(shard, ino, fd, index);
+
+    if (!page) {
+      return false;
+    }
+
+    memcpy(buffer, page->mData.get() + page_off, len);
+    buffer += len;
+    offset += len;
+    length -= len;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Write a range of a map file into the cache
+//------------------------------------------------------------------------------
+bool
+BlockXsCache::Write(ino_t ino, int fd, off_t offset, const char* buffer,
+                    size_t length)
+{
+  while (length) {
+    uint64_t index = offset / kPageSize;
+    size_t page_off = offset % kPageSize;
+    size_t len = std::min(length, kPageSize - page_off);
+    Shard& shard = GetShard(ino, index);
+    std::unique_lock<std::mutex> lock(shard.mMutex);
+    Page* page = GetPage(shard, ino, fd, index);
+
+    if (!page) {
+      return false;
+    }
+
+    memcpy(page->mData.get() + page_off, buffer, len);
+    page->mFd = fd;
+    buffer += len;
+    offset += len;
+    length -= len;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Write back the dirty pages of a map file
+//------------------------------------------------------------------------------
+bool
+BlockXsCache::Flush(ino_t ino)
+{
+  bool retc = true;
+
+  for (auto& shard : mShards) {
+    std::unique_lock<std::mutex> lock(shard->mMutex);
+    auto it_ino = shard->mPages.find(ino);
+
+    if (it_ino == shard->mPages.end()) {
+      continue;
+    }
+
+    for (auto& elem : it_ino->second) {
+      if ((elem.second->mFd != -1) && !WriteBack(*elem.second)) {
+        retc = false;
+      }
+    }
+  }
+
+  return retc;
+}
+
+//------------------------------------------------------------------------------
+// Drop the cached content of a map file past a size
+//------------------------------------------------------------------------------
+void
+BlockXsCache::Truncate(ino_t ino, off_t size)
+{
+  uint64_t first = size / kPageSize;
+  size_t page_off = size % kPageSize;
+
+  for (auto& shard : mShards) {
+    std::unique_lock<std::mutex> lock(shard->mMutex);
+    auto it_ino = shard->mPages.find(ino);
+
+    if (it_ino == shard->mPages.end()) {
+      continue;
+    }
+
+    std::vector<PageList::iterator> pages;
+
+    for (auto& elem : it_ino->second) {
+      if ((elem.first > first) || ((elem.first == first) && !page_off)) {
+        pages.push_back(elem.second);
+      } else if (elem.first == first) {
+        memset(elem.second->mData.get() + page_off, 0, kPageSize - page_off);
+      }
+    }
+
+    // Dropped without write back, they would extend the file again
+    for (auto& it : pages) {
+      Erase(*shard, it);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the number of cached pages
+//------------------------------------------------------------------------------
+size_t
+BlockXsCache::GetNumPages()
+{
+  size_t num_pages = 0;
+
+  for (auto& shard : mShards) {
+    std::unique_lock<std::mutex> lock(shard->mMutex);
+    num_pages += shard->mLru.size();
+  }
+
+  return num_pages;
+}
+
+//------------------------------------------------------------------------------
+// Get the shard of a page
+//------------------------------------------------------------------------------
+BlockXsCache::Shard&
+BlockXsCache::GetShard(ino_t ino, uint64_t index)
+{
+  uint64_t hash = ((uint64_t) ino * 0x9e3779b97f4a7c15ULL) ^ index;
+  return *mShards[hash % mShards.size()];
+}
+
+//------------------------------------------------------------------------------
+// Get a page, loading it if not cached
+//------------------------------------------------------------------------------
+BlockXsCache::Page*
+BlockXsCache::GetPage(Shard& shard, ino_t ino, int fd, uint64_t index)
+{
+  auto& pages = shard.mPages[ino];
+  auto it = pages.find(index);
+
+  if (it != pages.end()) {
+    shard.mLru.splice(shard.mLru.begin(), shard.mLru, it->second);
+    return &*it->second;
+  }
+
+  std::unique_ptr<char[]> data(new char[kPageSize]);
+  ssize_t nread;
+
+  do {
+    nread = pread(fd, data.get(), kPageSize, index * kPageSize);
+  } while ((nread < 0) && (errno == EINTR));
+
+  if (nread < 0) {
+    eos_static_err("msg=\"failed to read block xs map page\" ino=%llu "
+                   "page=%llu errno=%d", (unsigned long long) ino,
+                   (unsigned long long) index, errno);
+
+    if (pages.empty()) {
+      shard.mPages.erase(ino);
+    }
+
+    return nullptr;
+  }
+
+  // Past the end of the map file
+  memset(data.get() + nread, 0, kPageSize - nread);
+
+  while (shard.mLru.size() >= mPagesPerShard) {
+    auto victim = std::prev(shard.mLru.end());
+
+    if ((victim->mFd != -1) && !WriteBack(*victim)) {
+      eos_static_crit("msg=\"dropping dirty block xs map page\" ino=%llu "
+                      "page=%llu", (unsigned long long) victim->mIno,
+                      (unsigned long long) victim->mIndex);
+    }
+
+    Erase(shard, victim);
+  }
+
+  shard.mLru.push_front(Page {ino, index, -1, std::move(data)});
+  // The eviction may have dropped the page map of the inode
+  shard.mPages[ino][index] = shard.mLru.begin();
+  return &shard.mLru.front();
+}
+
+//------------------------------------------------------------------------------
+// Write back a dirty page
+//------------------------------------------------------------------------------
+bool
+BlockXsCache::WriteBack(Page& page)
+{
+  // The map files are sized by the block checksum, do not extend them with
+  // the tail of their last page
+  struct stat buf;
+
+  if (fstat(page.mFd, &buf)) {
+    eos_static_err("msg=\"failed to stat block xs map\" ino=%llu errno=%d",
+                   (unsigned long long) page.mIno, errno);
+    return false;
+  }
+
+  off_t start = page.mIndex * kPageSize;
+  size_t length = 0;
+
+  if (buf.st_size > start) {
+    length = std::min((size_t)(buf.st_size - start), kPageSize);
+  }
+
+  size_t nwrite = 0;
+
+  while (nwrite < length) {
+    ssize_t rc = pwrite(page.mFd, page.mData.get() + nwrite, length - nwrite,
+                        start + nwrite);
+
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      eos_static_err("msg=\"failed to write block xs map page\" ino=%llu "
+                     "page=%llu errno=%d", (unsigned long long) page.mIno,
+                     (unsigned long long) page.mIndex, errno);
+      return false;
+    }
+
+    nwrite += rc;
+  }
+
+  page.mFd = -1;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Remove a page from a shard
+//------------------------------------------------------------------------------
+void
+BlockXsCache::Erase(Shard& shard, PageList::iterator it)
+{
+  auto it_ino = shard.mPages.find(it->mIno);
+
+  if (it_ino != shard.mPages.end()) {
+    it_ino->second.erase(it->mIndex);
+
+    if (it_ino->second.empty()) {
+      shard.mPages.erase(it_ino);
+    }
+  }
+
+  shard.mLru.erase(it);
+}
+
+EOSFSTNAMESPACE_END
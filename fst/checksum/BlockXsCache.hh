@@ -0,0 +1,205 @@
+// ----------------------------------------------------------------------
+// File: BlockXsCache.hh
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef EOS_FST_CHECKSUM_BLOCKXSCACHE_H
+#define EOS_FST_CHECKSUM_BLOCKXSCACHE_H
+
+#include "fst/Namespace.hh"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class BlockXsCache - cache of the pages of the block checksum map files of
+//! one filesystem. The map entries are read and written with pread/pwrite
+//! through the cached pages instead of mmapping every map file. Dirty pages
+//! are written back when evicted, when a map is synced and when the last
+//! descriptor of a map is detached, after which its pages are dropped. Pages
+//! are identified by the inode of the map file so that all the openers of the
+//! same map share its pages.
+//------------------------------------------------------------------------------
+class BlockXsCache
+{
+public:
+  static constexpr size_t kPageSize = 4096; ///< size of a cached page
+
+  //----------------------------------------------------------------------------
+  //! Get the cache size per filesystem in bytes, configured in MB through
+  //! EOS_FST_BLOCKXS_CACHE_MB - default 0 which keeps the mmapped maps
+  //----------------------------------------------------------------------------
+  static size_t GetCapacity();
+
+  //----------------------------------------------------------------------------
+  //! Get the cache of a filesystem, created on first use
+  //!
+  //! @param dev device of the filesystem
+  //!
+  //! @return cache or nullptr if the cache is disabled
+  //----------------------------------------------------------------------------
+  static BlockXsCache* GetInstance(dev_t dev);
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param capacity maximum size of the cached pages in bytes
+  //! @param num_shards number of independently locked parts of the cache
+  //----------------------------------------------------------------------------
+  BlockXsCache(size_t capacity, size_t num_shards = 16);
+
+  //----------------------------------------------------------------------------
+  //! Destructor - dirty pages still cached are lost, every map has to be
+  //! detached before
+  //----------------------------------------------------------------------------
+  ~BlockXsCache() = default;
+
+  BlockXsCache(const BlockXsCache&) = delete;
+  BlockXsCache& operator=(const BlockXsCache&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Attach a descriptor of a map file
+  //!
+  //! @param ino inode of the map file
+  //----------------------------------------------------------------------------
+  void Attach(ino_t ino);
+
+  //----------------------------------------------------------------------------
+  //! Detach a descriptor of a map file before closing it. The pages dirtied
+  //! through the descriptor are written back and the pages of the map are
+  //! dropped once its last descriptor is detached.
+  //!
+  //! @param ino inode of the map file
+  //! @param fd descriptor of the map file
+  //!
+  //! @return true if successful, false if a write back failed
+  //----------------------------------------------------------------------------
+  bool Detach(ino_t ino, int fd);
+
+  //----------------------------------------------------------------------------
+  //! Read a range of a map file, bytes past the end of the file read as 0
+  //!
+  //! @param ino inode of the map file
+  //! @param fd descriptor of the map file
+  //! @param offset offset in the map file
+  //! @param buffer output buffer
+  //! @param length length to read
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Read(ino_t ino, int fd, off_t offset, char* buffer, size_t length);
+
+  //----------------------------------------------------------------------------
+  //! Write a range of a map file into the cache
+  //!
+  //! @param ino inode of the map file
+  //! @param fd descriptor of the map file, used for the write back
+  //! @param offset offset in the map file
+  //! @param buffer input buffer
+  //! @param length length to write
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Write(ino_t ino, int fd, off_t offset, const char* buffer,
+             size_t length);
+
+  //----------------------------------------------------------------------------
+  //! Write back the dirty pages of a map file
+  //!
+  //! @param ino inode of the map file
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Flush(ino_t ino);
+
+  //----------------------------------------------------------------------------
+  //! Drop the cached content of a map file past a size, to be called before
+  //! truncating the file
+  //!
+  //! @param ino inode of the map file
+  //! @param size new size of the map file
+  //----------------------------------------------------------------------------
+  void Truncate(ino_t ino, off_t size);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of cached pages
+  //----------------------------------------------------------------------------
+  size_t GetNumPages();
+
+private:
+  //----------------------------------------------------------------------------
+  //! Cached page
+  //----------------------------------------------------------------------------
+  struct Page {
+    ino_t mIno; ///< inode of the map file
+    uint64_t mIndex; ///< index of the page in the map file
+    int mFd; ///< descriptor used for the write back, -1 if clean
+    std::unique_ptr<char[]> mData; ///< content of the page
+  };
+
+  using PageList = std::list<Page>;
+
+  //----------------------------------------------------------------------------
+  //! Part of the cache with its own lock and LRU list
+  //----------------------------------------------------------------------------
+  struct Shard {
+    std::mutex mMutex; ///< protects the members below
+    PageList mLru; ///< pages, most recently used first
+    //! Pages by page index per inode
+    std::unordered_map<ino_t, std::unordered_map<uint64_t, PageList::iterator>>
+        mPages;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the shard of a page
+  //----------------------------------------------------------------------------
+  Shard& GetShard(ino_t ino, uint64_t index);
+
+  //----------------------------------------------------------------------------
+  //! Get a page, loading it if not cached. The shard lock has to be held.
+  //!
+  //! @return page or nullptr if it could not be loaded
+  //----------------------------------------------------------------------------
+  Page* GetPage(Shard& shard, ino_t ino, int fd, uint64_t index);
+
+  //----------------------------------------------------------------------------
+  //! Write back a dirty page. The shard lock has to be held.
+  //----------------------------------------------------------------------------
+  bool WriteBack(Page& page);
+
+  //----------------------------------------------------------------------------
+  //! Remove a page from a shard. The shard lock has to be held.
+  //----------------------------------------------------------------------------
+  void Erase(Shard& shard, PageList::iterator it);
+
+  size_t mPagesPerShard; ///< maximum number of pages of a shard
+  std::vector<std::unique_ptr<Shard>> mShards; ///< parts of the cache
+  std::mutex mMapsMutex; ///< protects mMaps
+  std::unordered_map<ino_t, size_t> mMaps; ///< attached descriptors per inode
+};
+
+EOSFSTNAMESPACE_END
+
+#endif // EOS_FST_CHECKSUM_BLOCKXSCACHE_H
@@ -27,6 +27,7 @@
 /*----------------------------------------------------------------------------*/
 #include "fst/Namespace.hh"
 #include "fst/checksum/CheckSum.hh"
+#include "common/crc32c/checksumkernels.h"
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucEnv.hh"
 #include "XrdOuc/XrdOucString.hh"
@@ -64,7 +65,38 @@ public:
       needsRecalculation = true;
       return false;
     }
-    crcsum = crc32(crcsum, (const Bytef*) buffer, length);
+    crcsum = checksum::crc32(crcsum, buffer, length);
+    crc32offset += length;
+    return true;
+  }
+
+  bool
+  IsCombinable ()
+  {
+    return true;
+  }
+
+  uint32_t
+  SegmentInit ()
+  {
+    return crc32(0L, Z_NULL, 0);
+  }
+
+  uint32_t
+  SegmentAdd (uint32_t value, const char* buffer, size_t length)
+  {
+    return checksum::crc32(value, buffer, length);
+  }
+
+  bool
+  AddSegment (uint32_t value, off_t offset, size_t length)
+  {
+    if (offset != crc32offset)
+    {
+      needsRecalculation = true;
+      return false;
+    }
+    crcsum = crc32_combine(crcsum, value, length);
     crc32offset += length;
     return true;
   }
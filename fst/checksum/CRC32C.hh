@@ -72,6 +72,40 @@ public:
     return true;
   }
 
+  bool
+  IsCombinable()
+  {
+    return true;
+  }
+
+  uint32_t
+  SegmentInit()
+  {
+    return checksum::crc32cInit();
+  }
+
+  uint32_t
+  SegmentAdd(uint32_t value, const char* buffer, size_t length)
+  {
+    return checksum::crc32c(value, (const Bytef*) buffer, length);
+  }
+
+  bool
+  AddSegment(uint32_t value, off_t offset, size_t length)
+  {
+    if (offset != crc32coffset) {
+      needsRecalculation = true;
+      return false;
+    }
+
+    // the combination works on the final values
+    crcsum = checksum::crc32cFinish(checksum::crc32cCombine(
+                                      checksum::crc32cFinish(crcsum),
+                                      checksum::crc32cFinish(value), length));
+    crc32coffset += length;
+    return true;
+  }
+
   const char*
   GetHexChecksum()
   {
@@ -22,6 +22,7 @@
  ************************************************************************/
 
 #include "fst/checksum/CheckSum.hh"
+#include "fst/checksum/BlockXsCache.hh"
 #include "fst/checksum/Adler.hh"
 #include "fst/checksum/CRC32.hh"
 #include "fst/checksum/CRC32C.hh"
@@ -36,7 +37,12 @@
 #include <sys/time.h>
 #include <sys/mman.h>
 #include <fcntl.h>
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 #include "common/XattrCompat.hh"
 
 
@@ -62,6 +68,127 @@ sigbus_hdl(int sig, siginfo_t* siginfo, void* ptr)
   siglongjmp(sj_env[ SYSGETTID % 65536] , 1);
 }
 
+namespace
+{
+//------------------------------------------------------------------------------
+//! Reads the buffers of a scan in a separate thread, one buffer ahead of the
+//! one being checksummed
+//------------------------------------------------------------------------------
+class ScanReadAhead
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor - starts reading
+  //!
+  //! @param read read function
+  //! @param buffersize size of a read
+  //! @param offset start offset
+  //----------------------------------------------------------------------------
+  ScanReadAhead(const std::function<int(char*, size_t, off_t)>& read,
+                size_t buffersize, off_t offset):
+    mRead(read), mBufferSize(buffersize)
+  {
+    for (auto& slot : mSlots) {
+      slot.mData.reset(new char[buffersize]);
+    }
+
+    mThread = std::thread(&ScanReadAhead::Run, this, offset);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Destructor - waits for the pending read
+  //----------------------------------------------------------------------------
+  ~ScanReadAhead()
+  {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mStop = true;
+    }
+    mCv.notify_all();
+    mThread.join();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the next buffer, the previous one is handed back to the reader
+  //!
+  //! @param buffer set to the data
+  //!
+  //! @return number of bytes read, less than the buffer size at the end of
+  //!         the file and -1 on error
+  //----------------------------------------------------------------------------
+  int Next(char*& buffer)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mHeld) {
+      mSlots[mNext].mFull = false;
+      mNext ^= 1;
+      mHeld = false;
+      mCv.notify_all();
+    }
+
+    mCv.wait(lock, [&]() {
+      return mSlots[mNext].mFull;
+    });
+    mHeld = true;
+    buffer = mSlots[mNext].mData.get();
+    return mSlots[mNext].mNread;
+  }
+
+private:
+  struct Slot {
+    std::unique_ptr<char[]> mData;
+    int mNread {0};
+    bool mFull {false};
+  };
+
+  //----------------------------------------------------------------------------
+  //! Reader loop, stops after a short read
+  //----------------------------------------------------------------------------
+  void Run(off_t offset)
+  {
+    int idx = 0;
+
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCv.wait(lock, [&]() {
+          return (mStop || !mSlots[idx].mFull);
+        });
+
+        if (mStop) {
+          return;
+        }
+      }
+      int nread = mRead(mSlots[idx].mData.get(), mBufferSize, offset);
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mSlots[idx].mNread = nread;
+        mSlots[idx].mFull = true;
+      }
+      mCv.notify_all();
+
+      if (nread != (int) mBufferSize) {
+        return;
+      }
+
+      offset += nread;
+      idx ^= 1;
+    }
+  }
+
+  std::function<int(char*, size_t, off_t)> mRead; ///< read function
+  size_t mBufferSize; ///< size of a read
+  Slot mSlots[2]; ///< buffers, read alternately
+  int mNext {0}; ///< next slot returned to the scan
+  bool mHeld {false}; ///< the scan holds the mNext slot
+  bool mStop {false}; ///< the reader has to exit
+  std::mutex mMutex; ///< protects the slots state
+  std::condition_variable mCv; ///< signals state changes
+  std::thread mThread; ///< reader thread
+};
+}
+
 /*----------------------------------------------------------------------------*/
 bool
 CheckSum::Compare(const char* refchecksum)
@@ -105,7 +232,16 @@ bool
 CheckSum::ScanFile(int fd, unsigned long long& scansize, float& scantime,
                    int rate)
 {
-  static int buffersize = 1024 * 1024;
+  // very large files are scanned by parallel segments if the checksum allows
+  static const size_t sMinSegment = 256 * 1024 * 1024;
+  size_t num_threads = GetScanThreads();
+  struct stat buf;
+
+  if ((!rate) && (num_threads > 1) && IsCombinable() && (!fstat(fd, &buf)) &&
+      (buf.st_size >= (off_t)(2 * sMinSegment))) {
+    return ScanFileParallel(fd, scansize, scantime, num_threads, sMinSegment);
+  }
+
   struct timezone tz;
   struct timeval opentime;
   struct timeval currenttime;
@@ -113,48 +249,20 @@ CheckSum::ScanFile(int fd, unsigned long long& scansize, float& scantime,
   scantime = 0;
   gettimeofday(&opentime, &tz);
   Reset();
-  int nread = 0;
   off_t offset = 0;
-  char* buffer = (char*) malloc(buffersize);
+  ScanRead read = [fd](char* buffer, size_t size, off_t off) {
+    return pread(fd, buffer, size, off);
+  };
 
-  if (!buffer) {
+  if (!ScanRange(read, offset, opentime, rate)) {
     return false;
   }
 
-  do {
-    errno = 0;
-    nread = pread(fd, buffer, buffersize, offset);
-
-    if (nread < 0) {
-      free(buffer);
-      return false;
-    }
-
-    if (nread > 0) {
-      Add(buffer, nread, offset);
-      offset += nread;
-    }
-
-    if (rate) {
-      // regulate the verification rate
-      gettimeofday(&currenttime, &tz);
-      scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
-                    currenttime.tv_usec - opentime.tv_usec) / 1000.0));
-      float expecttime = (1.0 * offset / rate) / 1000.0;
-
-      if (expecttime > scantime) {
-        std::this_thread::sleep_for
-        (std::chrono::milliseconds((int)(expecttime - scantime)));
-      }
-    }
-  } while (nread == buffersize);
-
   gettimeofday(&currenttime, &tz);
   scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
                 currenttime.tv_usec - opentime.tv_usec) / 1000.0));
   scansize = (unsigned long long) offset;
   Finalize();
-  free(buffer);
   return true;
 }
 
@@ -167,7 +275,6 @@ bool
 CheckSum::ScanFile(ReadCallBack rcb, unsigned long long& scansize,
                    float& scantime, int rate)
 {
-  static int buffersize = 1024 * 1024;
   struct timezone tz;
   struct timeval opentime;
   struct timeval currenttime;
@@ -176,23 +283,167 @@ CheckSum::ScanFile(ReadCallBack rcb, unsigned long long& scansize,
   gettimeofday(&opentime, &tz);
   Reset();
   //move at the right location in the  file
-  int nread = 0;
   off_t offset = 0;
-  char* buffer = (char*) malloc(buffersize);
 
-  if (!buffer) {
+  // the callback is only called by the read-ahead thread
+  ScanRead read = [&rcb](char* buffer, size_t size, off_t off) {
+    errno = 0;
+    rcb.data.offset = off;
+    rcb.data.buffer = buffer;
+    rcb.data.size = size;
+    return rcb.call(&rcb.data);
+  };
+
+  if (!ScanRange(read, offset, opentime, rate)) {
     return false;
   }
 
+  gettimeofday(&currenttime, &tz);
+  scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
+                currenttime.tv_usec - opentime.tv_usec) / 1000.0));
+  scansize = (unsigned long long) offset;
+  Finalize();
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* scan of a file by parallel segments combined at the end */
+bool
+CheckSum::ScanFileParallel(int fd, unsigned long long& scansize,
+                           float& scantime, size_t num_threads,
+                           size_t min_segment)
+{
+  static const size_t buffersize = 1024 * 1024;
+  struct timezone tz;
+  struct timeval opentime;
+  struct timeval currenttime;
+  struct stat buf;
+
+  if ((!IsCombinable()) || fstat(fd, &buf)) {
+    return ScanFile(fd, scansize, scantime);
+  }
+
+  scansize = 0;
+  scantime = 0;
+  gettimeofday(&opentime, &tz);
+  // segments are a multiple of the buffer size
+  off_t filesize = buf.st_size;
+  size_t nsegments = std::max((size_t) 1, std::min(num_threads,
+                              (size_t)(filesize / std::max(min_segment, (size_t) 1))));
+  off_t seglen = (filesize / nsegments) + buffersize - 1;
+  seglen -= seglen % buffersize;
+  nsegments = seglen ? ((filesize + seglen - 1) / seglen) : 0;
+  std::vector<uint32_t> values(nsegments);
+  std::vector<char> complete(nsegments, 0);
+  std::vector<std::thread> workers;
+
+  for (size_t i = 0; i < nsegments; ++i) {
+    workers.emplace_back([&, i]() {
+      off_t offset = i * seglen;
+      off_t end = std::min(filesize, (off_t)((i + 1) * seglen));
+      std::unique_ptr<char[]> buffer(new char[buffersize]);
+      uint32_t value = SegmentInit();
+
+      while (offset < end) {
+        ssize_t nread = pread(fd, buffer.get(),
+                              std::min((off_t) buffersize, end - offset), offset);
+
+        if (nread <= 0) {
+          return;
+        }
+
+        value = SegmentAdd(value, buffer.get(), nread);
+        offset += nread;
+      }
+
+      values[i] = value;
+      complete[i] = 1;
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  for (size_t i = 0; i < nsegments; ++i) {
+    if (!complete[i]) {
+      // the file shrank or a read failed, scan it again sequentially
+      return ScanFile(fd, scansize, scantime);
+    }
+  }
+
+  Reset();
+  off_t offset = 0;
+
+  for (size_t i = 0; i < nsegments; ++i) {
+    off_t length = std::min(filesize, offset + seglen) - offset;
+
+    if (!AddSegment(values[i], offset, length)) {
+      return false;
+    }
+
+    offset += length;
+  }
+
+  // the file may have grown since the stat
+  ScanRead read = [fd](char* buffer, size_t size, off_t off) {
+    return pread(fd, buffer, size, off);
+  };
+
+  if (!ScanRange(read, offset, opentime, 0)) {
+    return false;
+  }
+
+  gettimeofday(&currenttime, &tz);
+  scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
+                currenttime.tv_usec - opentime.tv_usec) / 1000.0));
+  scansize = (unsigned long long) offset;
+  Finalize();
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* number of threads scanning a large file */
+size_t
+CheckSum::GetScanThreads()
+{
+  static size_t sNumThreads = []() {
+    size_t num_threads = 1;
+    const char* ptr = getenv("EOS_FST_SCAN_THREADS");
+
+    if (ptr) {
+      long val = strtol(ptr, nullptr, 10);
+
+      if (val > 0) {
+        num_threads = std::min((size_t) val, (size_t) 64);
+      }
+    }
+
+    return num_threads;
+  }();
+  return sNumThreads;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/* add the data of a file from an offset to its end, reading ahead */
+bool
+CheckSum::ScanRange(const ScanRead& read, off_t& offset,
+                    const struct timeval& opentime, int rate)
+{
+  static const size_t buffersize = 1024 * 1024;
+  struct timezone tz;
+  struct timeval currenttime;
+  ScanReadAhead reader(read, buffersize, offset);
+  int nread = 0;
+
   do {
-    errno = 0;
-    rcb.data.offset = offset;
-    rcb.data.buffer = buffer;
-    rcb.data.size = buffersize;
-    nread = rcb.call(&rcb.data);
+    char* buffer = 0;
+    nread = reader.Next(buffer);
 
     if (nread < 0) {
-      free(buffer);
       return false;
     }
 
@@ -204,22 +455,17 @@ CheckSum::ScanFile(ReadCallBack rcb, unsigned long long& scansize,
     if (rate) {
       // regulate the verification rate
       gettimeofday(&currenttime, &tz);
-      scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
-                    currenttime.tv_usec - opentime.tv_usec) / 1000.0));
+      float scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
+                          currenttime.tv_usec - opentime.tv_usec) / 1000.0));
       float expecttime = (1.0 * offset / rate) / 1000.0;
 
       if (expecttime > scantime) {
-        usleep(1000.0 * (expecttime - scantime));
+        std::this_thread::sleep_for
+        (std::chrono::milliseconds((int)(expecttime - scantime)));
       }
     }
-  } while (nread == buffersize);
+  } while (nread == (int) buffersize);
 
-  gettimeofday(&currenttime, &tz);
-  scantime = (((currenttime.tv_sec - opentime.tv_sec) * 1000.0) + ((
-                currenttime.tv_usec - opentime.tv_usec) / 1000.0));
-  scansize = (unsigned long long) offset;
-  Finalize();
-  free(buffer);
   return true;
 }
 
@@ -304,6 +550,7 @@ CheckSum::OpenMap(const char* mapfilepath, size_t maxfilesize, size_t blocksize,
                   bool isRW)
 {
   CheckSumMapFile = mapfilepath;
+  mXsCache = 0;
   struct stat buf;
   eos::common::Path cPath(mapfilepath);
 
@@ -379,9 +626,6 @@ CheckSum::OpenMap(const char* mapfilepath, size_t maxfilesize, size_t blocksize,
       //      fprintf(stderr,"posix allocate failed\n")
       return false;
     }
-
-    ChecksumMap = (char*) mmap(0, ChecksumMapSize, PROT_READ | PROT_WRITE,
-                               MAP_SHARED, ChecksumMapFd, 0);
   } else {
     // make sure the file on disk is large enough
     struct stat xsstat;
@@ -399,11 +643,30 @@ CheckSum::OpenMap(const char* mapfilepath, size_t maxfilesize, size_t blocksize,
     } else {
       ChecksumMapSize = xsstat.st_size;
     }
+  }
+
+  // With the page cache the map entries are accessed with pread/pwrite
+  struct stat xsstat;
+
+  if (!fstat(ChecksumMapFd, &xsstat)) {
+    mXsCache = BlockXsCache::GetInstance(xsstat.st_dev);
+  }
+
+  if (mXsCache) {
+    mXsMapIno = xsstat.st_ino;
+
+    if (isRW) {
+      // Cached content past the truncated size is stale
+      mXsCache->Truncate(mXsMapIno, ChecksumMapSize);
+    }
 
-    ChecksumMap = (char*) mmap(0, ChecksumMapSize, PROT_READ | PROT_WRITE,
-                               MAP_SHARED, ChecksumMapFd, 0);
+    mXsCache->Attach(mXsMapIno);
+    return true;
   }
 
+  ChecksumMap = (char*) mmap(0, ChecksumMapSize, PROT_READ | PROT_WRITE,
+                             MAP_SHARED, ChecksumMapFd, 0);
+
   if (ChecksumMap == MAP_FAILED) {
     close(ChecksumMapFd);
     fprintf(stderr, "Fatal: [CheckSum::OpenMap] mmap failed\n");
@@ -431,6 +694,16 @@ CheckSum::OpenMap(const char* mapfilepath, size_t maxfilesize, size_t blocksize,
 bool
 CheckSum::SyncMap()
 {
+  if (mXsCache) {
+    if (mXsCache->Flush(mXsMapIno)) {
+      return true;
+    }
+
+    fprintf(stderr, "Fatal: [CheckSum::SyncMap] fd=%d flush failed\n",
+            ChecksumMapFd);
+    return false;
+  }
+
   if (ChecksumMapFd) {
     if (ChecksumMap) {
       if (!msync(ChecksumMap, ChecksumMapSize, MS_ASYNC)) {
@@ -457,7 +730,7 @@ CheckSum::ChangeMap(size_t newsize, bool shrink)
   // newsize is the real file size
   newsize = ((newsize / BlockSize) + 1) * (GetCheckSumLen());
 
-  if ((!ChecksumMapFd) || (!ChecksumMap)) {
+  if ((!ChecksumMapFd) || ((!ChecksumMap) && (!mXsCache))) {
     fprintf(stderr, "Fatal: [CheckSum:ChangeMap] no fd/map %d %llu\n",
             (int) ChecksumMapFd, (unsigned long long) ChecksumMap);
     return false;
@@ -476,6 +749,23 @@ CheckSum::ChangeMap(size_t newsize, bool shrink)
     newsize = ChecksumMapSize + (64 * 1024);
   }
 
+  if (mXsCache) {
+    if (newsize < ChecksumMapSize) {
+      mXsCache->Truncate(mXsMapIno, newsize);
+    }
+
+    if (ftruncate(ChecksumMapFd, newsize)) {
+      fprintf(stderr,
+              "Fatal: [CheckSum:ChangeMap] ftruncate failed [ fd=%d mapsize=%llu errno=%d]\n",
+              (int) ChecksumMapFd, (unsigned long long) ChecksumMapSize, (int) errno);
+      ChecksumMapSize = 0;
+      return false;
+    }
+
+    ChecksumMapSize = newsize;
+    return true;
+  }
+
   if (!SyncMap()) {
     fprintf(stderr,
             "Fatal: [CheckSum:ChangeMap] sync failed [ fd=%d map=%llu mapsize=%llu\n",
@@ -522,6 +812,14 @@ bool
 CheckSum::CloseMap()
 {
   //  fprintf(stderr,"[Checksum::CloseMap] %d %llu %llu\n", ChecksumMapFd, ChecksumMap, ChecksumMapSize);
+  if (mXsCache) {
+    bool retc = mXsCache->Detach(mXsMapIno, ChecksumMapFd);
+    close(ChecksumMapFd);
+    mXsCache = 0;
+    ChecksumMapFd = 0;
+    return retc;
+  }
+
   if (ChecksumMapFd) {
     if (ChecksumMap) {
       SyncMap();
@@ -660,19 +958,38 @@ CheckSum::CheckBlockSum(off_t offset, const char* buffer, size_t len)
 
   if (aligned_len) {
     off_t endoffset = aligned_offset + aligned_len;
-    off_t position = offset;
     const char* bufferptr = buffer + (aligned_offset - offset);
+    size_t xslen = GetCheckSumLen();
+    size_t nblocks = aligned_len / BlockSize;
+
+    if (!ChangeMap(endoffset, false)) {
+      fprintf(stderr, "Fatal: [CheckSum::CheckBlockSum] ChangeMap failed\n");
+      return false;
+    }
+
+    // fetch the map entries of all the blocks at once
+    std::vector<char> xsmap(nblocks * xslen);
+
+    if (!ReadXSMap((aligned_offset / BlockSize) * xslen, xsmap.data(),
+                   xsmap.size())) {
+      return false;
+    }
 
     // loop over all blocks
-    for (position = aligned_offset; position < endoffset; position += BlockSize) {
+    for (size_t i = 0; i < nblocks; i++) {
       // checksum this block
       Reset();
       Add(bufferptr, BlockSize, 0);
       Finalize();
-
-      // compare the checksum page
-      if (!VerifyXSMap(position)) {
-        return false;
+      int cks_len = 0;
+      const char* cks = GetBinChecksum(cks_len);
+      const char* xs = xsmap.data() + (i * xslen);
+
+      // compare with the map entry, 0 is not set
+      for (int n = 0; n < cks_len; n++) {
+        if ((xs[n]) && (xs[n] != cks[n])) {
+          return false;
+        }
       }
 
       nXSBlocksChecked++;
@@ -695,6 +1012,10 @@ CheckSum::SetXSMap(off_t offset)
   int len = 0;
   const char* cks = GetBinChecksum(len);
 
+  if (mXsCache) {
+    return mXsCache->Write(mXsMapIno, ChecksumMapFd, mapoffset, cks, len);
+  }
+
   if (!sigsetjmp(sj_env[ SYSGETTID % 65536], 1)) {
     for (int i = 0; i < len; i++) {
       ChecksumMap[i + mapoffset] = cks[i];
@@ -725,6 +1046,22 @@ CheckSum::VerifyXSMap(off_t offset)
   int len = 0;
   const char* cks = GetBinChecksum(len);
 
+  if (mXsCache) {
+    std::vector<char> xs(len);
+
+    if (!ReadXSMap(mapoffset, xs.data(), len)) {
+      return false;
+    }
+
+    for (int i = 0; i < len; i++) {
+      if ((xs[i]) && (xs[i] != cks[i])) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   if (!sigsetjmp(sj_env[ SYSGETTID % 65536], 1)) {
     for (int i = 0; i < len; i++) {
       //    fprintf(stderr,"Compare %llu %llu\n", ChecksumMap[i+mapoffset], cks[i]);
@@ -746,6 +1083,36 @@ CheckSum::VerifyXSMap(off_t offset)
   return true;
 }
 
+/*----------------------------------------------------------------------------*/
+bool
+CheckSum::ReadXSMap(off_t mapoffset, char* buffer, size_t length)
+{
+  if (mXsCache) {
+    return mXsCache->Read(mXsMapIno, ChecksumMapFd, mapoffset, buffer, length);
+  }
+
+  if ((!ChecksumMap) || (mapoffset + length > ChecksumMapSize)) {
+    fprintf(stderr,
+            "Fatal: [CheckSum::ReadXSMap] out of map [ mapoffset=%llu length=%llu map=%llu mapsize=%llu ]\n",
+            (unsigned long long) mapoffset, (unsigned long long) length,
+            (unsigned long long) ChecksumMap, (unsigned long long) ChecksumMapSize);
+    return false;
+  }
+
+  if (!sigsetjmp(sj_env[ SYSGETTID % 65536], 1)) {
+    memcpy(buffer, ChecksumMap + mapoffset, length);
+  } else {
+    // return point from signal handler
+    fprintf(stderr,
+            "Fatal: [CheckSum::ReadXSMap] recovered SIGBUS by illegal read access to mmaped XS map file [ mapoffset=%llu fd=%d map=%llu mapsize=%llu ]\n",
+            (unsigned long long) mapoffset, (int) ChecksumMapFd,
+            (unsigned long long) ChecksumMap, (unsigned long long) ChecksumMapSize);
+    return false;
+  }
+
+  return true;
+}
+
 /*----------------------------------------------------------------------------*/
 bool
 CheckSum::AddBlockSumHoles(int fd)
@@ -770,14 +1137,27 @@ CheckSum::AddBlockSumHoles(int fd)
     if (buffer) {
       size_t len = GetCheckSumLen();
       size_t nblocks = ChecksumMapSize / len;
+      // scan the map by chunks of entries
+      size_t nchunk = 4096;
+      std::vector<char> xsmap(nchunk * len);
       bool iszero;
 
-      if (!sigsetjmp(sj_env[ SYSGETTID % 65536], 1)) {
-        for (size_t i = 0; i < nblocks; i++) {
+      for (size_t first = 0; first < nblocks; first += nchunk) {
+        size_t count = std::min(nchunk, nblocks - first);
+
+        if (!ReadXSMap(first * len, xsmap.data(), count * len)) {
+          fprintf(stderr,
+                  "Fatal: [CheckSum::AddBlockSumHoles] failed to read XS map [ nblocks=%u map=%llu ]\n",
+                  (unsigned int) nblocks, (unsigned long long) ChecksumMapSize);
+          free(buffer);
+          return false;
+        }
+
+        for (size_t i = first; i < first + count; i++) {
           iszero = true;
 
           for (size_t n = 0; n < len; n++) {
-            if (ChecksumMap[(i * len) + n ]) {
+            if (xsmap[((i - first) * len) + n]) {
               iszero = false;
               break;
             }
@@ -805,13 +1185,6 @@ CheckSum::AddBlockSumHoles(int fd)
             nXSBlocksWrittenHoles++;
           }
         }
-      } else {
-        // return point from signal handler
-        fprintf(stderr,
-                "Fatal: [CheckSum::AddBlockSumHoles] recovered SIGBUS by illegal write access to mmaped XS map file [ nblocks=%u map=%llu ]\n",
-                (unsigned int) nblocks, (unsigned long long) ChecksumMapSize);
-        free(buffer);
-        return false;
       }
 
       free(buffer);
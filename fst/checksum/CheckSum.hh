@@ -32,13 +32,18 @@
 #include "XrdOuc/XrdOucString.hh"
 /*----------------------------------------------------------------------------*/
 #include <google/sparse_hash_map>
+#include <functional>
 #include <setjmp.h>
 #include <signal.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <sys/types.h>
 
 /*----------------------------------------------------------------------------*/
 
 EOSFSTNAMESPACE_BEGIN
 
+class BlockXsCache;
 
 class CheckSum
 {
@@ -58,6 +63,8 @@ protected:
   unsigned long long nXSBlocksChecked;
   unsigned long long nXSBlocksWritten;
   unsigned long long nXSBlocksWrittenHoles;
+  BlockXsCache* mXsCache; ///< page cache of the XS map, null if mmapped
+  ino_t mXsMapIno; ///< inode of the XS map file
 
 public:
 
@@ -65,6 +72,8 @@ public:
   {
     Name = "";
     ChecksumMap = 0;
+    mXsCache = 0;
+    mXsMapIno = 0;
     mNumRd = 0;
     mNumWr = 0;
     finalized = false;
@@ -83,6 +92,8 @@ public:
     nXSBlocksWrittenHoles = 0;
     BlockXSPath = "";
     ChecksumMapFd = -1;
+    mXsCache = 0;
+    mXsMapIno = 0;
     mNumRd = 0;
     mNumWr = 0;
     finalized = false;
@@ -197,6 +208,79 @@ public:
   virtual bool ScanFile(const char* path, off_t offsetInit, size_t lengthInit,
                         const char* partialChecksum,
                         unsigned long long& scansize, float& scantime, int rate = 0);
+
+  //----------------------------------------------------------------------------
+  //! Scan a file computing the checksums of consecutive segments in parallel
+  //! and combining them, falls back to a sequential scan if the checksum can
+  //! not be combined or the file shrinks during the scan
+  //!
+  //! @param fd file descriptor
+  //! @param scansize number of bytes scanned
+  //! @param scantime scan time in ms
+  //! @param num_threads number of segments scanned in parallel
+  //! @param min_segment minimum size of a segment
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  virtual bool ScanFileParallel(int fd, unsigned long long& scansize,
+                                float& scantime, size_t num_threads,
+                                size_t min_segment);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of threads scanning a large file, configured through
+  //! EOS_FST_SCAN_THREADS - default 1 which scans sequentially
+  //----------------------------------------------------------------------------
+  static size_t GetScanThreads();
+
+  //----------------------------------------------------------------------------
+  //! Check if the checksum of consecutive segments can be combined. The
+  //! segment functions below are then stateless and can be called
+  //! concurrently.
+  //----------------------------------------------------------------------------
+  virtual bool
+  IsCombinable()
+  {
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the initial checksum value of a segment
+  //----------------------------------------------------------------------------
+  virtual uint32_t
+  SegmentInit()
+  {
+    return 0;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Update the checksum value of a segment with data
+  //!
+  //! @param value current value of the segment
+  //! @param buffer data
+  //! @param length length of the data
+  //!
+  //! @return new value of the segment
+  //----------------------------------------------------------------------------
+  virtual uint32_t
+  SegmentAdd(uint32_t value, const char* buffer, size_t length)
+  {
+    return value;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Add the checksum value of a segment like Add would do with its data
+  //!
+  //! @param value value of the segment
+  //! @param offset offset of the segment
+  //! @param length length of the segment
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  virtual bool
+  AddSegment(uint32_t value, off_t offset, size_t length)
+  {
+    return false;
+  }
   virtual bool VerifyXSMap(off_t offset);
 
   virtual bool OpenMap(const char* mapfilepath, size_t maxfilesize,
@@ -212,7 +296,7 @@ public:
   virtual bool AddBlockSum(off_t offset, const char* buffer,
                            size_t buffersize);  // this only calculates the checksum on full blocks, not matching edge is not calculated
   virtual bool CheckBlockSum(off_t offset, const char* buffer,
-                             size_t buffersizem); // this only verifies the checksum on full blocks, not matching edge is not calculated
+                             size_t buffersizem); // this only verifies the checksum on full blocks, not matching edge is not calculated, the map entries of all the blocks are read at once
   virtual bool AddBlockSumHoles(int fd);
 
   virtual const char*
@@ -314,6 +398,36 @@ public:
 private:
   virtual bool SetXSMap(off_t offset);
 
+  //----------------------------------------------------------------------------
+  //! Read a range of the XS map, either from the page cache or the mmapped map
+  //!
+  //! @param mapoffset offset in the XS map
+  //! @param buffer output buffer
+  //! @param length length to read, the map has to be large enough
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool ReadXSMap(off_t mapoffset, char* buffer, size_t length);
+
+  //----------------------------------------------------------------------------
+  //! Read function of a scan, returns the number of bytes read or -1
+  //----------------------------------------------------------------------------
+  using ScanRead = std::function<int(char* buffer, size_t size, off_t offset)>;
+
+  //----------------------------------------------------------------------------
+  //! Add data to the checksum until the end of the file, the next buffer is
+  //! read while the current one is added
+  //!
+  //! @param read read function
+  //! @param offset start offset, updated with the end of the scan
+  //! @param opentime start time of the scan for the rate regulation
+  //! @param rate scan rate in MB/s, 0 for no limit
+  //!
+  //! @return true if successful, false if a read failed
+  //----------------------------------------------------------------------------
+  bool ScanRange(const ScanRead& read, off_t& offset,
+                 const struct timeval& opentime, int rate);
+
   unsigned int mNumRd; ///< number of reader references
   unsigned int mNumWr; ///< number of writer references
 };
@@ -31,6 +31,8 @@
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdSfs/XrdSfsInterface.hh"
 /*----------------------------------------------------------------------------*/
+#include <unistd.h>
+/*----------------------------------------------------------------------------*/
 
 /*----------------------------------------------------------------------------*/
 
@@ -150,10 +152,38 @@ HttpServer::Handler(void* cls,
 
   if (response->mUseFileReaderCallback) {
     eos_static_debug("response length=%d", response->mResponseLength);
-    mhdResponse = MHD_create_response_from_callback(response->mResponseLength,
-                  4 * 1024 * 1024, /* 4M page size */
-                  &HttpServer::FileReaderCallback,
-                  (void*) protocolHandler, 0);
+    mhdResponse = 0;
+#if MHD_VERSION >= 0x00094000
+    // Plain files are sent straight from the disk using sendfile, the range
+    // requests, checksum verification and the other layouts need the copy
+    eos::fst::HttpHandler* httpHandle =
+      dynamic_cast<eos::fst::HttpHandler*>(protocolHandler);
+    int fd = -1;
+
+    if (httpHandle && httpHandle->mFile && !httpHandle->mRangeRequest) {
+      fd = httpHandle->mFile->GetSendFileFd();
+    }
+
+    if (fd >= 0) {
+      // The response owns the descriptor from now on
+      mhdResponse = MHD_create_response_from_fd_at_offset64(
+                      response->mResponseLength, fd, 0);
+
+      if (!mhdResponse) {
+        close(fd);
+      }
+    }
+
+#endif
+
+    if (!mhdResponse) {
+      // In event mode the file is read on the worker pool
+      mhdResponse = CreateResponseFromCallback(connection,
+                    response->mResponseLength,
+                    4 * 1024 * 1024, /* 4M page size */
+                    &HttpServer::FileReaderCallback,
+                    (void*) protocolHandler);
+    }
   } else {
     mhdResponse = MHD_create_response_from_buffer(response->GetBodySize(),
                   (void*) response->GetBody().c_str(),
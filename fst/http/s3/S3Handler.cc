@@ -67,9 +67,23 @@ S3Handler::HandleRequest(eos::common::HttpRequest* request)
     mode_t create_mode = 0;
 
     if (request->GetMethod() == "PUT") {
+      // parts of multipart uploads are written in place into the staging file
+      // which the MGM has assigned, all the others replace the object
+      XrdOucEnv queryEnv(request->GetQuery().c_str());
+      const char* partOffset = queryEnv.Get("s3.part.offset");
+
+      if (partOffset) {
+        mIsPart = true;
+        mPartOffset = strtoull(partOffset, 0, 10);
+      }
+
       // use the proper creation/open flags for PUT's
       open_mode |= SFS_O_CREAT;
-      open_mode |= SFS_O_TRUNC;
+
+      if (!mIsPart) {
+        open_mode |= SFS_O_TRUNC;
+      }
+
       open_mode |= SFS_O_RDWR;
       open_mode |= SFS_O_MKPTH;
       create_mode |= (SFS_O_MKPTH | S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
@@ -84,6 +98,10 @@ S3Handler::HandleRequest(eos::common::HttpRequest* request)
     mFileId = mFile->getFileId();
     mLogId = mFile->logId;
 
+    if (mIsPart) {
+      mCurrentCallbackOffset = mPartOffset;
+    }
+
     // check for range requests
     if (request->GetHeaders().count("range")) {
       if (!DecodeByteRange(request->GetHeaders()["range"],
@@ -247,6 +265,12 @@ S3Handler::Put(eos::common::HttpRequest* request)
         mFile = 0;
       } else {
         eos_static_info("msg=\"stored requested bytes\"");
+
+        if (mIsPart) {
+          mPartMD5.Add(request->GetBody().c_str(), *bodySize,
+                       mCurrentCallbackOffset - mPartOffset);
+        }
+
         // decrease the upload left data size
         mUploadLeftSize -= *bodySize;
         mCurrentCallbackOffset += *bodySize;
@@ -255,6 +279,16 @@ S3Handler::Put(eos::common::HttpRequest* request)
       }
     } else {
       eos_static_info("entering close handler");
+
+      if (mIsPart) {
+        // the checksum of the object is computed once all parts are there
+        std::string cmd = "nochecksum";
+
+        if (mFile->fctl(SFS_FCTL_SPEC1, cmd.length(), cmd.c_str(), 0)) {
+          eos_static_err("msg=\"failed to disable the checksum of the part\"");
+        }
+      }
+
       mCloseCode = mFile->close();
 
       if (mCloseCode) {
@@ -275,7 +309,16 @@ S3Handler::Put(eos::common::HttpRequest* request)
   responseheader["x-amz-request-id"] = mLogId;
   responseheader["Server"] = gOFS.mHostName;
   responseheader["Connection"] = "close";
-  responseheader["ETag"] = sFileId;
+
+  if (mIsPart) {
+    // the ETag of a part is its MD5, the MGM builds the object ETag from it
+    mPartMD5.Finalize();
+    responseheader["ETag"] = "\"";
+    responseheader["ETag"] += mPartMD5.GetHexChecksum();
+    responseheader["ETag"] += "\"";
+  } else {
+    responseheader["ETag"] = sFileId;
+  }
 
   if (response) {
     delete response;
@@ -33,6 +33,7 @@
 /*----------------------------------------------------------------------------*/
 #include "common/http/s3/S3Handler.hh"
 #include "fst/http/HttpHandler.hh"
+#include "fst/checksum/MD5.hh"
 #include "fst/Namespace.hh"
 /*----------------------------------------------------------------------------*/
 /*----------------------------------------------------------------------------*/
@@ -52,7 +53,7 @@ public:
   /**
    * Constructor
    */
-  S3Handler () {};
+  S3Handler () : mIsPart(false), mPartOffset(0) {};
 
   /**
    * Destructor
@@ -104,6 +105,11 @@ public:
   eos::common::HttpResponse*
   Put (eos::common::HttpRequest *request);
 
+private:
+  bool               mIsPart;     //< request uploads a part of a multipart upload
+  unsigned long long mPartOffset; //< offset of the part in the staging file
+  eos::fst::MD5      mPartMD5;    //< MD5 of the part, its S3 ETag
+
 };
 
 /*----------------------------------------------------------------------------*/
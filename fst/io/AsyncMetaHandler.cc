@@ -24,6 +24,7 @@
 #include "fst/io/ChunkHandler.hh"
 #include "fst/io/VectChunkHandler.hh"
 #include "fst/io/AsyncMetaHandler.hh"
+#include <algorithm>
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -38,6 +39,8 @@ AsyncMetaHandler::AsyncMetaHandler() :
   mErrorType(XrdCl::errNone),
   mAsyncReq(0),
   mAsyncVReq(0),
+  mWrBytes(0),
+  mMaxWrBytes(0),
   mHandlerDel(NULL),
   mVHandlerDel(NULL)
 {
@@ -99,8 +102,37 @@ AsyncMetaHandler::Register(uint64_t offset, uint32_t length, char* buffer,
     return NULL;
   }
 
+  if (isWrite && mMaxWrBytes) {
+    // Bound the data in flight, one request is always accepted
+    while (mWrBytes && (mWrBytes + length > mMaxWrBytes) &&
+           (mErrorType != XrdCl::errOperationExpired)) {
+      mCond.Wait();
+    }
+
+    if (mErrorType == XrdCl::errOperationExpired) {
+      mCond.UnLock(); // <--
+      return NULL;
+    }
+
+    mAsyncReq++;
+    mWrBytes += length;
+    mCond.UnLock(); // <--
+
+    if (mQRecycle.try_pop(ptr_chunk)) {
+      ptr_chunk->Update(this, offset, length, buffer, isWrite);
+    } else {
+      ptr_chunk = new ChunkHandler(this, offset, length, buffer, isWrite);
+    }
+
+    return ptr_chunk;
+  }
+
   mAsyncReq++;
 
+  if (isWrite) {
+    mWrBytes += length;
+  }
+
   if (mQRecycle.size() + mAsyncReq >= msMaxNumAsyncObj) {
     mCond.UnLock();   // <--
     mQRecycle.wait_pop(ptr_chunk);
@@ -179,6 +211,14 @@ AsyncMetaHandler::HandleResponse(XrdCl::XRootDStatus* pStatus,
     }
   }
 
+  if (chunk->IsWrite() && mWrBytes) {
+    mWrBytes -= std::min(mWrBytes, (uint64_t) chunk->GetLength());
+
+    if (mMaxWrBytes) {
+      mCond.Broadcast();
+    }
+  }
+
   if (--mAsyncReq == 0) {
     mCond.Broadcast();
   }
@@ -281,8 +321,21 @@ AsyncMetaHandler::Reset()
   mErrorType = XrdCl::errNone;
   mAsyncReq = 0;
   mAsyncVReq = 0;
+  mWrBytes = 0;
   mErrors.clear();
   mCond.UnLock();
 }
 
+//------------------------------------------------------------------------------
+// Set the maximum amount of data of the write requests in flight
+//------------------------------------------------------------------------------
+void
+AsyncMetaHandler::SetMaxWriteInFlight(uint64_t max_bytes)
+{
+  mCond.Lock();
+  mMaxWrBytes = max_bytes;
+  mCond.Broadcast();
+  mCond.UnLock();
+}
+
 EOSFSTNAMESPACE_END
@@ -116,12 +116,24 @@ public:
   //----------------------------------------------------------------------------
   void Reset();
 
+  //----------------------------------------------------------------------------
+  //! Set the maximum amount of data of the write requests in flight. Once the
+  //! limit is reached new write requests block until enough responses are
+  //! received. With a limit set, the number of write requests in flight is no
+  //! longer bounded by msMaxNumAsyncObj.
+  //!
+  //! @param max_bytes max number of bytes in flight, 0 means no limit
+  //----------------------------------------------------------------------------
+  void SetMaxWriteInFlight(uint64_t max_bytes);
+
 private:
   uint16_t mErrorType; ///< type of error, we are mostly interested in timeouts
   //! number of async requests in flight (for which no response was received)
   uint32_t mAsyncReq;
   //! number of async VECTOR req. in flight (for which no response was received)
   uint32_t mAsyncVReq;
+  uint64_t mWrBytes; ///< number of bytes of the write requests in flight
+  uint64_t mMaxWrBytes; ///< max bytes of write requests in flight, 0 no limit
   //! condition variable to signal the receival of all responses
   XrdSysCondVar mCond;
   ChunkHandler* mHandlerDel; ///< pointer to handler to be deleted
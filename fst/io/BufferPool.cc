@@ -0,0 +1,238 @@
+// ----------------------------------------------------------------------
+// File: BufferPool.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/BufferPool.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+
+EOSFSTNAMESPACE_BEGIN
+
+constexpr size_t BufferPool::kAlignment;
+constexpr size_t BufferPool::kMinClassSize;
+constexpr size_t BufferPool::kMaxClassSize;
+constexpr size_t BufferPool::kHugePageSize;
+
+//------------------------------------------------------------------------------
+// Move constructor
+//------------------------------------------------------------------------------
+BufferPool::Buffer::Buffer(Buffer&& other) noexcept:
+  mPool(other.mPool), mData(other.mData), mCapacity(other.mCapacity),
+  mCached(other.mCached)
+{
+  other.mPool = nullptr;
+  other.mData = nullptr;
+  other.mCapacity = 0;
+}
+
+//------------------------------------------------------------------------------
+// Move assignment
+//------------------------------------------------------------------------------
+BufferPool::Buffer&
+BufferPool::Buffer::operator=(Buffer&& other) noexcept
+{
+  if (this != &other) {
+    Release();
+    mPool = other.mPool;
+    mData = other.mData;
+    mCapacity = other.mCapacity;
+    mCached = other.mCached;
+    other.mPool = nullptr;
+    other.mData = nullptr;
+    other.mCapacity = 0;
+  }
+
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+// Give the buffer back to the pool
+//------------------------------------------------------------------------------
+void
+BufferPool::Buffer::Release()
+{
+  if (mData) {
+    mPool->Put(mData, mCapacity, mCached);
+    mPool = nullptr;
+    mData = nullptr;
+    mCapacity = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the pool shared by the whole FST
+//------------------------------------------------------------------------------
+BufferPool&
+BufferPool::GetInstance()
+{
+  // Never destroyed, buffers held by other static objects may be released
+  // at exit after the pool would have been gone
+  static BufferPool* sPool = []() {
+    const char* ptr = getenv("EOS_FST_BUFFER_POOL_MB");
+    uint64_t max_mb = (ptr ? strtoull(ptr, 0, 10) : 256ull);
+    ptr = getenv("EOS_FST_BUFFER_POOL_HUGEPAGES");
+    bool huge_pages = (ptr && (strtol(ptr, 0, 10) == 1));
+    return new BufferPool(max_mb * 1024 * 1024, huge_pages);
+  }();
+  return *sPool;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+BufferPool::BufferPool(uint64_t max_cached, bool huge_pages):
+  mMaxCached(max_cached), mHugePages(huge_pages), mCachedBytes(0),
+  mLeasedBytes(0)
+{}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+BufferPool::~BufferPool()
+{
+  for (auto& elem : mFree) {
+    for (auto data : elem.second) {
+      free(data);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Lease a buffer
+//------------------------------------------------------------------------------
+BufferPool::Buffer
+BufferPool::Get(size_t size, size_t alignment)
+{
+  size_t capacity = GetClassSize(size);
+  bool cached = (capacity && (alignment <= kAlignment));
+
+  if (cached) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mFree.find(capacity);
+
+    if ((it != mFree.end()) && !it->second.empty()) {
+      char* data = it->second.back();
+      it->second.pop_back();
+      mCachedBytes -= capacity;
+      mLeasedBytes += capacity;
+      return Buffer(this, data, capacity, true);
+    }
+  } else {
+    // Rounded to full pages, the tail of an O_DIRECT read stays in the buffer
+    capacity = ((std::max(size, (size_t) 1) + kAlignment - 1) / kAlignment) *
+               kAlignment;
+  }
+
+  char* data = Allocate(capacity, std::max(alignment, kAlignment));
+  std::lock_guard<std::mutex> lock(mMutex);
+  mLeasedBytes += capacity;
+  return Buffer(this, data, capacity, cached);
+}
+
+//------------------------------------------------------------------------------
+// Get the amount of memory held by the released buffers
+//------------------------------------------------------------------------------
+uint64_t
+BufferPool::GetCachedBytes()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mCachedBytes;
+}
+
+//------------------------------------------------------------------------------
+// Get the amount of memory of the leased buffers
+//------------------------------------------------------------------------------
+uint64_t
+BufferPool::GetLeasedBytes()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mLeasedBytes;
+}
+
+//------------------------------------------------------------------------------
+// Get the size class of a buffer size
+//------------------------------------------------------------------------------
+size_t
+BufferPool::GetClassSize(size_t size)
+{
+  if (size > kMaxClassSize) {
+    return 0;
+  }
+
+  size_t class_size = kMinClassSize;
+
+  while (class_size < size) {
+    class_size <<= 1;
+  }
+
+  return class_size;
+}
+
+//------------------------------------------------------------------------------
+// Take back a released buffer
+//------------------------------------------------------------------------------
+void
+BufferPool::Put(char* data, size_t capacity, bool cached)
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mLeasedBytes -= capacity;
+
+    if (cached && (mCachedBytes + capacity <= mMaxCached)) {
+      mFree[capacity].push_back(data);
+      mCachedBytes += capacity;
+      return;
+    }
+  }
+  free(data);
+}
+
+//------------------------------------------------------------------------------
+// Allocate aligned memory
+//------------------------------------------------------------------------------
+char*
+BufferPool::Allocate(size_t capacity, size_t alignment)
+{
+  bool huge = (mHugePages && (capacity >= kHugePageSize));
+  void* data = nullptr;
+
+  if (huge) {
+    alignment = std::max(alignment, kHugePageSize);
+  }
+
+  if (posix_memalign(&data, alignment, capacity)) {
+    throw std::bad_alloc();
+  }
+
+#ifdef MADV_HUGEPAGE
+
+  if (huge) {
+    // Only a hint, the buffer works the same without huge pages
+    (void) madvise(data, capacity, MADV_HUGEPAGE);
+  }
+
+#endif
+  return static_cast<char*>(data);
+}
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,181 @@
+// ----------------------------------------------------------------------
+// File: BufferPool.hh
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_BUFFERPOOL_HH__
+#define __EOSFST_BUFFERPOOL_HH__
+
+#include "fst/Namespace.hh"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class BufferPool - aligned IO buffers shared by the layouts and the IO
+//! plugins of the FST. Buffers are handed out in power of two size classes
+//! and cached once released so that opening and closing files does not
+//! churn through fresh allocations. Every buffer is page aligned, which
+//! makes it usable for O_DIRECT reads. The memory held by the released
+//! buffers is bounded by EOS_FST_BUFFER_POOL_MB (default 256 MB), the
+//! buffers of 2 MB and more are backed by transparent huge pages when
+//! EOS_FST_BUFFER_POOL_HUGEPAGES is set to 1.
+//------------------------------------------------------------------------------
+class BufferPool
+{
+public:
+  static constexpr size_t kAlignment = 4096; ///< alignment of all buffers
+  static constexpr size_t kMinClassSize = 4096; ///< smallest size class
+  //! Largest size class, bigger buffers are allocated for each lease
+  static constexpr size_t kMaxClassSize = 64 * 1024 * 1024;
+  static constexpr size_t kHugePageSize = 2 * 1024 * 1024; ///< huge page size
+
+  //----------------------------------------------------------------------------
+  //! Buffer leased from the pool, given back when destroyed
+  //----------------------------------------------------------------------------
+  class Buffer
+  {
+  public:
+    //--------------------------------------------------------------------------
+    //! Constructor of an empty buffer
+    //--------------------------------------------------------------------------
+    Buffer(): mPool(nullptr), mData(nullptr), mCapacity(0), mCached(false) {}
+
+    //--------------------------------------------------------------------------
+    //! Destructor
+    //--------------------------------------------------------------------------
+    ~Buffer()
+    {
+      Release();
+    }
+
+    Buffer(Buffer&& other) noexcept;
+    Buffer& operator=(Buffer&& other) noexcept;
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    //--------------------------------------------------------------------------
+    //! Give the buffer back to the pool, the buffer is empty afterwards
+    //--------------------------------------------------------------------------
+    void Release();
+
+    //--------------------------------------------------------------------------
+    //! Get the data of the buffer
+    //--------------------------------------------------------------------------
+    inline char* GetDataPtr() const
+    {
+      return mData;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Get the size of the buffer, at least the size asked for
+    //--------------------------------------------------------------------------
+    inline size_t GetCapacity() const
+    {
+      return mCapacity;
+    }
+
+  private:
+    friend class BufferPool;
+
+    Buffer(BufferPool* pool, char* data, size_t capacity, bool cached):
+      mPool(pool), mData(data), mCapacity(capacity), mCached(cached) {}
+
+    BufferPool* mPool; ///< pool the buffer belongs to
+    char* mData; ///< aligned data
+    size_t mCapacity; ///< size of the data
+    bool mCached; ///< buffer of a size class, cached once released
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the pool shared by the whole FST
+  //----------------------------------------------------------------------------
+  static BufferPool& GetInstance();
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param max_cached max memory held by the released buffers
+  //! @param huge_pages back the buffers of kHugePageSize and more by huge
+  //!        pages
+  //----------------------------------------------------------------------------
+  BufferPool(uint64_t max_cached, bool huge_pages = false);
+
+  //----------------------------------------------------------------------------
+  //! Destructor - the buffers still leased must not outlive the pool
+  //----------------------------------------------------------------------------
+  ~BufferPool();
+
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Lease a buffer
+  //!
+  //! @param size minimum size of the buffer
+  //! @param alignment alignment of the buffer, the alignments above
+  //!        kAlignment are served by buffers which are not cached
+  //!
+  //! @return buffer, throws std::bad_alloc if the memory can not be allocated
+  //----------------------------------------------------------------------------
+  Buffer Get(size_t size, size_t alignment = kAlignment);
+
+  //----------------------------------------------------------------------------
+  //! Get the amount of memory held by the released buffers
+  //----------------------------------------------------------------------------
+  uint64_t GetCachedBytes();
+
+  //----------------------------------------------------------------------------
+  //! Get the amount of memory of the leased buffers
+  //----------------------------------------------------------------------------
+  uint64_t GetLeasedBytes();
+
+  //----------------------------------------------------------------------------
+  //! Get the size class of a buffer size, 0 if too big for the classes
+  //----------------------------------------------------------------------------
+  static size_t GetClassSize(size_t size);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Take back a released buffer
+  //----------------------------------------------------------------------------
+  void Put(char* data, size_t capacity, bool cached);
+
+  //----------------------------------------------------------------------------
+  //! Allocate aligned memory
+  //----------------------------------------------------------------------------
+  char* Allocate(size_t capacity, size_t alignment);
+
+  std::mutex mMutex; ///< protects the members below
+  uint64_t mMaxCached; ///< max memory held by the released buffers
+  bool mHugePages; ///< back the big buffers by huge pages
+  uint64_t mCachedBytes; ///< memory held by the released buffers
+  uint64_t mLeasedBytes; ///< memory of the leased buffers
+  //! Released buffers indexed by their size class
+  std::map<size_t, std::vector<char*>> mFree;
+};
+
+EOSFSTNAMESPACE_END
+
+#endif // __EOSFST_BUFFERPOOL_HH__
@@ -27,6 +27,9 @@
 
 #include "fst/io/FileIo.hh"
 #include "fst/io/local/FsIo.hh"
+#ifdef IO_URING_FOUND
+#include "fst/io/local/UringIo.hh"
+#endif
 #include "fst/io/xrd/XrdIo.hh"
 #ifdef RADOS_FOUND
 #include "fst/io/rados/RadosIo.hh"
@@ -76,6 +79,13 @@ public:
     auto ioType = eos::common::LayoutId::GetIoType(path.c_str());
 
     if (ioType == LayoutId::kLocal) {
+#ifdef IO_URING_FOUND
+
+      if (UringIo::IsEnabled()) {
+        return static_cast<FileIo*>(new UringIo(path));
+      }
+
+#endif // IO_URING_FOUND
       return static_cast<FileIo*>(new FsIo(path));
     } else if (ioType == LayoutId::kXrdCl) {
       return static_cast<FileIo*>(new XrdIo(path));
@@ -385,9 +385,10 @@ public:
   //----------------------------------------------------------------------------
   virtual int ftsClose(FileIo::FtsHandle* fts_handle);
 
-private:
+protected:
   int mFd; //< file descriptor to filesystem file
 
+private:
   //----------------------------------------------------------------------------
   //! Disable copy constructor
   //----------------------------------------------------------------------------
@@ -0,0 +1,404 @@
+//------------------------------------------------------------------------------
+// File: IoUring.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/local/IoUring.hh"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <thread>
+
+EOSFSTNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+// io_uring system call wrappers
+//------------------------------------------------------------------------------
+int
+SysIoUringSetup(unsigned int entries, struct io_uring_params* params)
+{
+#ifdef __NR_io_uring_setup
+  return (int) syscall(__NR_io_uring_setup, entries, params);
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+int
+SysIoUringEnter(int fd, unsigned int to_submit, unsigned int min_complete,
+                unsigned int flags)
+{
+#ifdef __NR_io_uring_enter
+  return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                       flags, nullptr, 0);
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Get number of submission queue entries used for new rings
+//------------------------------------------------------------------------------
+unsigned int
+GetRingEntries()
+{
+  unsigned int entries = 256;
+  const char* ptr = getenv("EOS_FST_IO_URING_ENTRIES");
+
+  if (ptr) {
+    int val = atoi(ptr);
+
+    if (val > 0) {
+      entries = std::min(val, 4096);
+    }
+  }
+
+  return entries;
+}
+}
+
+//------------------------------------------------------------------------------
+//! Request in flight - the iovec must stay valid until the kernel has
+//! consumed the submission
+//------------------------------------------------------------------------------
+struct IoUring::Request {
+  struct iovec mIov;
+  Callback mCb;
+};
+
+//------------------------------------------------------------------------------
+// Get the ring shared by all files on the same device
+//------------------------------------------------------------------------------
+std::shared_ptr<IoUring>
+IoUring::GetRing(dev_t dev)
+{
+  static std::mutex sMutex;
+  static std::map<dev_t, std::shared_ptr<IoUring>> sRings;
+  std::lock_guard<std::mutex> lock(sMutex);
+  auto it = sRings.find(dev);
+
+  if (it != sRings.end()) {
+    return it->second;
+  }
+
+  std::shared_ptr<IoUring> ring = std::make_shared<IoUring>(GetRingEntries());
+
+  if (!ring->IsOk()) {
+    ring.reset();
+  }
+
+  sRings[dev] = ring;
+  return ring;
+}
+
+//------------------------------------------------------------------------------
+// Check if the running kernel supports io_uring
+//------------------------------------------------------------------------------
+bool
+IoUring::IsSupported()
+{
+  static bool sSupported = []() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = SysIoUringSetup(1, &params);
+
+    if (fd < 0) {
+      return false;
+    }
+
+    close(fd);
+    return true;
+  }();
+  return sSupported;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+IoUring::IoUring(unsigned int entries):
+  mRingFd(-1), mEntries(0), mSqPtr(MAP_FAILED), mSqSize(0),
+  mCqPtr(MAP_FAILED), mCqSize(0), mSqes(nullptr), mSqesSize(0),
+  mSqHead(nullptr), mSqTail(nullptr), mSqMask(nullptr), mSqArray(nullptr),
+  mCqHead(nullptr), mCqTail(nullptr), mCqMask(nullptr), mCqes(nullptr),
+  mInFlight(0)
+{
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = SysIoUringSetup(entries, &params);
+
+  if (fd < 0) {
+    return;
+  }
+
+  mSqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  mCqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+  single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP);
+
+  if (single_mmap) {
+    mSqSize = mCqSize = std::max(mSqSize, mCqSize);
+  }
+
+#endif
+  mSqPtr = mmap(nullptr, mSqSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+  if (mSqPtr == MAP_FAILED) {
+    close(fd);
+    return;
+  }
+
+  if (single_mmap) {
+    mCqPtr = mSqPtr;
+  } else {
+    mCqPtr = mmap(nullptr, mCqSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+
+    if (mCqPtr == MAP_FAILED) {
+      munmap(mSqPtr, mSqSize);
+      mSqPtr = MAP_FAILED;
+      close(fd);
+      return;
+    }
+  }
+
+  mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+  if (sqes == MAP_FAILED) {
+    if (mCqPtr != mSqPtr) {
+      munmap(mCqPtr, mCqSize);
+    }
+
+    munmap(mSqPtr, mSqSize);
+    mSqPtr = mCqPtr = MAP_FAILED;
+    close(fd);
+    return;
+  }
+
+  char* sq = (char*) mSqPtr;
+  char* cq = (char*) mCqPtr;
+  mSqes = (io_uring_sqe*) sqes;
+  mSqHead = (unsigned*)(sq + params.sq_off.head);
+  mSqTail = (unsigned*)(sq + params.sq_off.tail);
+  mSqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+  mSqArray = (unsigned*)(sq + params.sq_off.array);
+  mCqHead = (unsigned*)(cq + params.cq_off.head);
+  mCqTail = (unsigned*)(cq + params.cq_off.tail);
+  mCqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+  mCqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+  mEntries = params.sq_entries;
+  mRingFd = fd;
+  mThread.reset(&IoUring::ReapCompletions, this);
+  mThread.setName("io_uring");
+  // Wake up the completion thread with an empty request when stopping
+  mThread.registerCallback([this]() {
+    (void) Submit(IORING_OP_NOP, -1, nullptr, 0, 0, nullptr);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+IoUring::~IoUring()
+{
+  if (mRingFd < 0) {
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCv.wait(lock, [&]() {
+      return (mInFlight == 0);
+    });
+  }
+  mThread.join();
+  munmap(mSqes, mSqesSize);
+
+  if (mCqPtr != mSqPtr) {
+    munmap(mCqPtr, mCqSize);
+  }
+
+  munmap(mSqPtr, mSqSize);
+  close(mRingFd);
+}
+
+//------------------------------------------------------------------------------
+// Submit a read request
+//------------------------------------------------------------------------------
+bool
+IoUring::SubmitRead(int fd, char* buffer, size_t length, off_t offset,
+                    Callback cb)
+{
+  return Submit(IORING_OP_READV, fd, buffer, length, offset, std::move(cb));
+}
+
+//------------------------------------------------------------------------------
+// Submit a write request
+//------------------------------------------------------------------------------
+bool
+IoUring::SubmitWrite(int fd, const char* buffer, size_t length, off_t offset,
+                     Callback cb)
+{
+  return Submit(IORING_OP_WRITEV, fd, (void*) buffer, length, offset,
+                std::move(cb));
+}
+
+//------------------------------------------------------------------------------
+// Submit a fsync request
+//------------------------------------------------------------------------------
+bool
+IoUring::SubmitFsync(int fd, Callback cb)
+{
+  return Submit(IORING_OP_FSYNC, fd, nullptr, 0, 0, std::move(cb));
+}
+
+//------------------------------------------------------------------------------
+// Add a request to the submission queue and notify the kernel. Requests
+// without a callback are only used to wake up the completion thread and are
+// not accounted as in flight.
+//------------------------------------------------------------------------------
+bool
+IoUring::Submit(uint8_t opcode, int fd, void* buffer, size_t length,
+                off_t offset, Callback cb)
+{
+  if (mRingFd < 0) {
+    errno = ENODEV;
+    return false;
+  }
+
+  std::unique_ptr<Request> req;
+
+  if (cb) {
+    req.reset(new Request());
+    req->mIov.iov_base = buffer;
+    req->mIov.iov_len = length;
+    req->mCb = std::move(cb);
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  if (req) {
+    // The completion queue holds twice the submission entries, bounding the
+    // requests in flight makes sure it never overflows
+    mCv.wait(lock, [&]() {
+      return (mInFlight < mEntries);
+    });
+  }
+
+  unsigned tail = *mSqTail;
+  unsigned index = tail & *mSqMask;
+  io_uring_sqe* sqe = &mSqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+
+  if (req && (opcode != IORING_OP_FSYNC)) {
+    sqe->addr = (unsigned long) &req->mIov;
+    sqe->len = 1;
+    sqe->off = offset;
+  }
+
+  sqe->user_data = (unsigned long) req.get();
+  mSqArray[index] = index;
+  __atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+  int retc;
+
+  do {
+    retc = SysIoUringEnter(mRingFd, 1, 0, 0);
+  } while ((retc < 0) && ((errno == EINTR) || (errno == EAGAIN) ||
+                          (errno == EBUSY)));
+
+  if (retc < 0) {
+    // Without SQPOLL the kernel only consumes entries during the enter call,
+    // therefore the failed entry can be dropped again
+    int errc = errno;
+    __atomic_store_n(mSqTail, tail, __ATOMIC_RELEASE);
+    errno = errc;
+    return false;
+  }
+
+  if (req) {
+    ++mInFlight;
+    (void) req.release();
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Loop collecting completions and running the callbacks
+//------------------------------------------------------------------------------
+void
+IoUring::ReapCompletions(ThreadAssistant& assistant)
+{
+  while (true) {
+    unsigned head = *mCqHead;
+    unsigned tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+
+    if (head != tail) {
+      // The requests are handed over through the kernel, synchronize with
+      // their submitters before touching them
+      std::lock_guard<std::mutex> lock(mMutex);
+    }
+
+    while (head != tail) {
+      io_uring_cqe* cqe = &mCqes[head & *mCqMask];
+      Request* req = (Request*) cqe->user_data;
+      int res = cqe->res;
+      ++head;
+      __atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+
+      if (req) {
+        req->mCb(res);
+        delete req;
+        {
+          std::lock_guard<std::mutex> lock(mMutex);
+          --mInFlight;
+        }
+        mCv.notify_all();
+      }
+    }
+
+    if (assistant.terminationRequested()) {
+      break;
+    }
+
+    // The wake-up request submitted on termination makes sure this returns
+    if ((SysIoUringEnter(mRingFd, 0, 1, IORING_ENTER_GETEVENTS) < 0) &&
+        (errno != EINTR) && (errno != EAGAIN) && (errno != EBUSY)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,167 @@
+//------------------------------------------------------------------------------
+// File: IoUring.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "fst/Namespace.hh"
+#include "common/AssistedThread.hh"
+#include <sys/types.h>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class IoUring - thin wrapper around a Linux io_uring submission and
+//! completion queue pair. Requests are submitted from any thread and their
+//! callbacks are executed by a dedicated completion thread. The ring is used
+//! through the raw system calls so that no extra library is needed.
+//------------------------------------------------------------------------------
+class IoUring
+{
+public:
+  //! Callback receiving the result of the request i.e. number of bytes
+  //! transferred or -errno
+  using Callback = std::function<void(int)>;
+
+  //----------------------------------------------------------------------------
+  //! Get the ring shared by all files on the same device, creating it if it
+  //! does not exist yet
+  //!
+  //! @param dev device id of the mount
+  //!
+  //! @return ring object or null if io_uring is not available
+  //----------------------------------------------------------------------------
+  static std::shared_ptr<IoUring> GetRing(dev_t dev);
+
+  //----------------------------------------------------------------------------
+  //! Check if the running kernel supports io_uring
+  //----------------------------------------------------------------------------
+  static bool IsSupported();
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param entries number of submission queue entries
+  //----------------------------------------------------------------------------
+  explicit IoUring(unsigned int entries);
+
+  //----------------------------------------------------------------------------
+  //! Destructor - waits for all the requests in flight
+  //----------------------------------------------------------------------------
+  ~IoUring();
+
+  //----------------------------------------------------------------------------
+  //! Copy constructor and assignment operator
+  //----------------------------------------------------------------------------
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Check if the ring was set up successfully
+  //----------------------------------------------------------------------------
+  bool IsOk() const
+  {
+    return (mRingFd >= 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Submit a read request
+  //!
+  //! @param fd file descriptor
+  //! @param buffer destination buffer, must stay valid until completion
+  //! @param length read length
+  //! @param offset file offset
+  //! @param cb completion callback
+  //!
+  //! @return true if submitted, otherwise false and the callback is not called
+  //----------------------------------------------------------------------------
+  bool SubmitRead(int fd, char* buffer, size_t length, off_t offset,
+                  Callback cb);
+
+  //----------------------------------------------------------------------------
+  //! Submit a write request
+  //!
+  //! @param fd file descriptor
+  //! @param buffer source buffer, must stay valid until completion
+  //! @param length write length
+  //! @param offset file offset
+  //! @param cb completion callback
+  //!
+  //! @return true if submitted, otherwise false and the callback is not called
+  //----------------------------------------------------------------------------
+  bool SubmitWrite(int fd, const char* buffer, size_t length, off_t offset,
+                   Callback cb);
+
+  //----------------------------------------------------------------------------
+  //! Submit a fsync request
+  //!
+  //! @param fd file descriptor
+  //! @param cb completion callback
+  //!
+  //! @return true if submitted, otherwise false and the callback is not called
+  //----------------------------------------------------------------------------
+  bool SubmitFsync(int fd, Callback cb);
+
+private:
+  struct Request;
+
+  //----------------------------------------------------------------------------
+  //! Add a request to the submission queue and notify the kernel
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Submit(uint8_t opcode, int fd, void* buffer, size_t length,
+              off_t offset, Callback cb);
+
+  //----------------------------------------------------------------------------
+  //! Loop collecting completions and running the callbacks
+  //----------------------------------------------------------------------------
+  void ReapCompletions(ThreadAssistant& assistant);
+
+  int mRingFd; ///< io_uring file descriptor
+  unsigned int mEntries; ///< size of the submission queue
+  void* mSqPtr; ///< mapped submission queue ring
+  size_t mSqSize; ///< size of the submission queue mapping
+  void* mCqPtr; ///< mapped completion queue ring
+  size_t mCqSize; ///< size of the completion queue mapping
+  io_uring_sqe* mSqes; ///< mapped submission queue entries
+  size_t mSqesSize; ///< size of the submission queue entries mapping
+  unsigned* mSqHead; ///< submission queue head, updated by the kernel
+  unsigned* mSqTail; ///< submission queue tail
+  unsigned* mSqMask; ///< submission queue index mask
+  unsigned* mSqArray; ///< submission queue index array
+  unsigned* mCqHead; ///< completion queue head
+  unsigned* mCqTail; ///< completion queue tail, updated by the kernel
+  unsigned* mCqMask; ///< completion queue index mask
+  io_uring_cqe* mCqes; ///< completion queue entries
+  std::mutex mMutex; ///< serializes submissions
+  std::condition_variable mCv; ///< signals that requests completed
+  unsigned int mInFlight; ///< requests in flight, protected by mMutex
+  AssistedThread mThread; ///< completion thread
+};
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,368 @@
+//------------------------------------------------------------------------------
+// File: UringIo.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/local/UringIo.hh"
+#include "fst/io/AsyncMetaHandler.hh"
+#include "fst/io/ChunkHandler.hh"
+#include <sys/stat.h>
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <mutex>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Check if the io_uring local IO is enabled
+//------------------------------------------------------------------------------
+bool
+UringIo::IsEnabled()
+{
+  static bool sEnabled = []() {
+    const char* ptr = getenv("EOS_FST_IO_URING");
+    return (ptr && (strcmp(ptr, "1") == 0) && IoUring::IsSupported());
+  }();
+  return sEnabled;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+UringIo::UringIo(std::string path) :
+  FsIo(path, "UringIo"), mMetaHandler(new AsyncMetaHandler())
+{
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+UringIo::~UringIo()
+{
+  // The completions still reference the meta handler
+  (void) mMetaHandler->WaitOK();
+  delete mMetaHandler;
+}
+
+//------------------------------------------------------------------------------
+// Open file
+//------------------------------------------------------------------------------
+int
+UringIo::fileOpen(XrdSfsFileOpenMode flags, mode_t mode,
+                  const std::string& opaque, uint16_t timeout)
+{
+  if (FsIo::fileOpen(flags, mode, opaque, timeout)) {
+    return -1;
+  }
+
+  struct stat info;
+
+  if (::fstat(mFd, &info) == 0) {
+    mRing = IoUring::GetRing(info.st_dev);
+  }
+
+  if (!mRing) {
+    eos_warning("msg=\"no io_uring available, using sync IO\" path=%s",
+                mFilePath.c_str());
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Submit the request described by the chunk handler to the ring
+//------------------------------------------------------------------------------
+bool
+UringIo::SubmitChunk(ChunkHandler* handler, bool is_write)
+{
+  uint64_t offset = handler->GetOffset();
+  uint32_t length = handler->GetLength();
+  char* buffer = handler->GetBuffer();
+  auto done = [handler, offset, length, buffer, is_write](int res) {
+    XrdCl::XRootDStatus* status = new XrdCl::XRootDStatus();
+    XrdCl::AnyObject* response = nullptr;
+
+    if (res < 0) {
+      *status = XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errOSError, -res);
+    } else if (is_write) {
+      if ((uint32_t) res != length) {
+        *status = XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errOSError, EIO);
+      }
+    } else {
+      // A short read is flagged as an error by the chunk handler
+      response = new XrdCl::AnyObject();
+      response->Set(new XrdCl::ChunkInfo(offset, res, buffer));
+    }
+
+    handler->HandleResponse(status, response);
+  };
+  bool submitted = (is_write ?
+                    mRing->SubmitWrite(mFd, buffer, length, offset, done) :
+                    mRing->SubmitRead(mFd, buffer, length, offset, done));
+
+  if (!submitted) {
+    eos_err("msg=\"failed io_uring submission\" path=%s errno=%d",
+            mFilePath.c_str(), errno);
+    XrdCl::XRootDStatus status(XrdCl::stError, XrdCl::errOSError, errno);
+    mMetaHandler->HandleResponse(&status, handler);
+  }
+
+  return submitted;
+}
+
+//------------------------------------------------------------------------------
+// Read from file - async
+//------------------------------------------------------------------------------
+int64_t
+UringIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
+                       XrdSfsXferSize length, bool readahead,
+                       uint16_t timeout)
+{
+  if (!mRing) {
+    return fileRead(offset, buffer, length, timeout);
+  }
+
+  ChunkHandler* handler = mMetaHandler->Register(offset, length, buffer, false);
+
+  // If previous requests failed then we won't get a new handler and we
+  // return directly an error
+  if (!handler) {
+    return SFS_ERROR;
+  }
+
+  if (!SubmitChunk(handler, false)) {
+    return SFS_ERROR;
+  }
+
+  return length;
+}
+
+//------------------------------------------------------------------------------
+// Write to file - async
+//------------------------------------------------------------------------------
+int64_t
+UringIo::fileWriteAsync(XrdSfsFileOffset offset, const char* buffer,
+                        XrdSfsXferSize length, uint16_t timeout)
+{
+  if (!mRing) {
+    return fileWrite(offset, buffer, length, timeout);
+  }
+
+  ChunkHandler* handler = mMetaHandler->Register(offset, length, (char*)buffer,
+                          true);
+
+  if (!handler) {
+    return SFS_ERROR;
+  }
+
+  // Obs: the handler holds a copy of the data for write requests
+  if (!SubmitChunk(handler, true)) {
+    return SFS_ERROR;
+  }
+
+  return length;
+}
+
+//------------------------------------------------------------------------------
+// Vector read - sync
+//------------------------------------------------------------------------------
+int64_t
+UringIo::fileReadV(XrdCl::ChunkList& chunkList, uint16_t timeout)
+{
+  int64_t nread = 0;
+
+  if (!mRing) {
+    for (auto& chunk : chunkList) {
+      int64_t ret = fileRead(chunk.offset, (char*) chunk.buffer, chunk.length,
+                             timeout);
+
+      if (ret != (int64_t) chunk.length) {
+        errno = (ret < 0 ? errno : EIO);
+        return SFS_ERROR;
+      }
+
+      nread += ret;
+    }
+
+    return nread;
+  }
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t pending = 0;
+  int errc = 0;
+
+  for (auto& chunk : chunkList) {
+    uint32_t length = chunk.length;
+    auto done = [&, length](int res) {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      if (res < 0) {
+        errc = -res;
+      } else if ((uint32_t) res != length) {
+        errc = EIO;
+      } else {
+        nread += res;
+      }
+
+      if (--pending == 0) {
+        cv.notify_one();
+      }
+    };
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++pending;
+    }
+
+    // Don't hold the lock while submitting, the submission can block until
+    // some of the earlier requests complete
+    if (!mRing->SubmitRead(mFd, (char*) chunk.buffer, chunk.length,
+                           chunk.offset, done)) {
+      int submit_errc = errno;
+      std::lock_guard<std::mutex> lock(mutex);
+      errc = submit_errc;
+      --pending;
+      break;
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  cv.wait(lock, [&]() {
+    return (pending == 0);
+  });
+
+  if (errc) {
+    errno = errc;
+    return SFS_ERROR;
+  }
+
+  return nread;
+}
+
+//------------------------------------------------------------------------------
+// Vector read - async
+//------------------------------------------------------------------------------
+int64_t
+UringIo::fileReadVAsync(XrdCl::ChunkList& chunkList, uint16_t timeout)
+{
+  if (!mRing) {
+    return fileReadV(chunkList, timeout);
+  }
+
+  int64_t nread = 0;
+
+  for (auto& chunk : chunkList) {
+    ChunkHandler* handler = mMetaHandler->Register(chunk.offset, chunk.length,
+                            (char*) chunk.buffer, false);
+
+    if (!handler || !SubmitChunk(handler, false)) {
+      return SFS_ERROR;
+    }
+
+    nread += chunk.length;
+  }
+
+  return nread;
+}
+
+//------------------------------------------------------------------------------
+// Wait for all async IO
+//------------------------------------------------------------------------------
+int
+UringIo::fileWaitAsyncIO()
+{
+  if (mMetaHandler->WaitOK() != XrdCl::errNone) {
+    eos_err("error=async requests failed for file path=%s", mFilePath.c_str());
+    errno = EIO;
+    return -1;
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Sync file to disk
+//------------------------------------------------------------------------------
+int
+UringIo::fileSync(uint16_t timeout)
+{
+  if (fileWaitAsyncIO()) {
+    return -1;
+  }
+
+  if (!mRing) {
+    return FsIo::fileSync(timeout);
+  }
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+  int retc = 0;
+  auto cb = [&](int res) {
+    std::lock_guard<std::mutex> lock(mutex);
+    retc = res;
+    done = true;
+    cv.notify_one();
+  };
+
+  if (!mRing->SubmitFsync(mFd, cb)) {
+    return FsIo::fileSync(timeout);
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  cv.wait(lock, [&]() {
+    return done;
+  });
+
+  if (retc < 0) {
+    errno = -retc;
+    return -1;
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Get pointer to async meta handler object
+//------------------------------------------------------------------------------
+void*
+UringIo::fileGetAsyncHandler()
+{
+  return static_cast<void*>(mMetaHandler);
+}
+
+//------------------------------------------------------------------------------
+// Close file
+//------------------------------------------------------------------------------
+int
+UringIo::fileClose(uint16_t timeout)
+{
+  int retc = fileWaitAsyncIO();
+
+  if (FsIo::fileClose(timeout)) {
+    retc = -1;
+  }
+
+  mRing.reset();
+  return retc;
+}
+
+EOSFSTNAMESPACE_END
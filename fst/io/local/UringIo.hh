@@ -0,0 +1,183 @@
+//------------------------------------------------------------------------------
+// File: UringIo.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "fst/io/local/FsIo.hh"
+#include "fst/io/local/IoUring.hh"
+#include <memory>
+
+EOSFSTNAMESPACE_BEGIN
+
+class AsyncMetaHandler;
+class ChunkHandler;
+
+//------------------------------------------------------------------------------
+//! Class UringIo - local IO where the async and vector requests are executed
+//! through an io_uring ring shared by all the files on the same mount. The
+//! completions are delivered to an AsyncMetaHandler exactly like for the
+//! XrdIo async requests. If no ring can be set up, the class behaves like
+//! FsIo.
+//------------------------------------------------------------------------------
+class UringIo : public FsIo
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Check if the io_uring local IO is enabled i.e. EOS_FST_IO_URING is set
+  //! to 1 and the kernel supports io_uring
+  //----------------------------------------------------------------------------
+  static bool IsEnabled();
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param path file path
+  //----------------------------------------------------------------------------
+  UringIo(std::string path);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~UringIo();
+
+  //----------------------------------------------------------------------------
+  //! Open file
+  //!
+  //! @param flags open flags
+  //! @param mode open mode
+  //! @param opaque opaque information
+  //! @param timeout timeout value
+  //!
+  //! @return 0 if successful, -1 otherwise and error code is set
+  //----------------------------------------------------------------------------
+  int fileOpen(XrdSfsFileOpenMode flags,
+               mode_t mode = 0,
+               const std::string& opaque = "",
+               uint16_t timeout = 0) override;
+
+  //----------------------------------------------------------------------------
+  //! Read from file - async
+  //!
+  //! @param offset offset in file
+  //! @param buffer where the data is read
+  //! @param length read length
+  //! @param readahead ignored
+  //! @param timeout timeout value
+  //!
+  //! @return number of bytes read or -1 if error
+  //! @note The buffer is populated only after fileWaitAsyncIO returns.
+  //----------------------------------------------------------------------------
+  int64_t fileReadAsync(XrdSfsFileOffset offset,
+                        char* buffer,
+                        XrdSfsXferSize length,
+                        bool readahead = false,
+                        uint16_t timeout = 0) override;
+
+  //----------------------------------------------------------------------------
+  //! Vector read - sync
+  //!
+  //! @param chunkList list of chunks that should be read
+  //! @param timeout timeout value
+  //!
+  //! @return number of bytes read of -1 if error
+  //----------------------------------------------------------------------------
+  int64_t fileReadV(XrdCl::ChunkList& chunkList,
+                    uint16_t timeout = 0) override;
+
+  //----------------------------------------------------------------------------
+  //! Vector read - async
+  //!
+  //! @param chunkList list of chunks that should be read
+  //! @param timeout timeout value
+  //!
+  //! @return number of bytes requested or -1 if error
+  //----------------------------------------------------------------------------
+  int64_t fileReadVAsync(XrdCl::ChunkList& chunkList,
+                         uint16_t timeout = 0) override;
+
+  //----------------------------------------------------------------------------
+  //! Write to file - async
+  //!
+  //! @param offset offset
+  //! @param buffer data to be written, copied before returning
+  //! @param length length
+  //! @param timeout timeout value
+  //!
+  //! @return number of bytes written or -1 if error
+  //----------------------------------------------------------------------------
+  int64_t fileWriteAsync(XrdSfsFileOffset offset,
+                         const char* buffer,
+                         XrdSfsXferSize length,
+                         uint16_t timeout = 0) override;
+
+  //----------------------------------------------------------------------------
+  //! Wait for all async IO
+  //!
+  //! @return 0 if all requests were successful, otherwise -1
+  //----------------------------------------------------------------------------
+  int fileWaitAsyncIO() override;
+
+  //----------------------------------------------------------------------------
+  //! Sync file to disk after all the async writes completed
+  //!
+  //! @param timeout timeout value
+  //!
+  //! @return 0 on success, -1 otherwise and error code is set
+  //----------------------------------------------------------------------------
+  int fileSync(uint16_t timeout = 0) override;
+
+  //----------------------------------------------------------------------------
+  //! Get pointer to async meta handler object
+  //!
+  //! @return pointer to async handler
+  //----------------------------------------------------------------------------
+  void* fileGetAsyncHandler() override;
+
+  //----------------------------------------------------------------------------
+  //! Close file after all the async requests completed
+  //!
+  //! @param timeout timeout value
+  //!
+  //! @return 0 on success, -1 otherwise and error code is set
+  //----------------------------------------------------------------------------
+  int fileClose(uint16_t timeout = 0) override;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Submit the request described by the chunk handler to the ring, the
+  //! response is delivered to the handler once the request completes
+  //!
+  //! @param handler chunk handler
+  //! @param is_write true if this is a write request
+  //!
+  //! @return true if submitted, otherwise false and the handler was already
+  //!         notified about the failure
+  //----------------------------------------------------------------------------
+  bool SubmitChunk(ChunkHandler* handler, bool is_write);
+
+  std::shared_ptr<IoUring> mRing; ///< ring of the file's mount
+  AsyncMetaHandler* mMetaHandler; ///< async requests meta handler
+
+  UringIo(const UringIo&) = delete;
+  UringIo& operator = (const UringIo&) = delete;
+};
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,216 @@
+//------------------------------------------------------------------------------
+// File: Readahead.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/xrd/Readahead.hh"
+#include <algorithm>
+#include <cstdlib>
+
+EOSFSTNAMESPACE_BEGIN
+
+constexpr uint32_t ReadaheadPolicy::kSampleSize;
+
+//------------------------------------------------------------------------------
+// Get the pool shared by all the XrdIo objects
+//------------------------------------------------------------------------------
+ReadaheadBlockPool&
+ReadaheadBlockPool::GetInstance()
+{
+  static ReadaheadBlockPool sPool([]() {
+    const char* ptr = getenv("EOS_FST_XRDIO_RDAHEAD_POOL_MB");
+    uint64_t max_mb = (ptr ? strtoull(ptr, 0, 10) : 256ull);
+    return max_mb * 1024 * 1024;
+  }());
+  return sPool;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ReadaheadBlockPool::ReadaheadBlockPool(uint64_t max_bytes):
+  mMaxBytes(max_bytes), mAllocBytes(0), mCachedBytes(0)
+{}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+ReadaheadBlockPool::~ReadaheadBlockPool()
+{
+  for (auto& elem : mCached) {
+    for (auto block : elem.second) {
+      delete block;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get a block with the given size
+//------------------------------------------------------------------------------
+ReadaheadBlock*
+ReadaheadBlockPool::Get(uint64_t blocksize)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mCached.find(blocksize);
+
+  if ((it != mCached.end()) && !it->second.empty()) {
+    ReadaheadBlock* block = it->second.back();
+    it->second.pop_back();
+    mCachedBytes -= blocksize;
+    return block;
+  }
+
+  // Drop cached blocks of other sizes to make room for the new one
+  auto iter = mCached.begin();
+
+  while ((mAllocBytes + blocksize > mMaxBytes) && (iter != mCached.end())) {
+    while (!iter->second.empty() && (mAllocBytes + blocksize > mMaxBytes)) {
+      delete iter->second.back();
+      iter->second.pop_back();
+      mAllocBytes -= iter->first;
+      mCachedBytes -= iter->first;
+    }
+
+    ++iter;
+  }
+
+  if (mAllocBytes + blocksize > mMaxBytes) {
+    return nullptr;
+  }
+
+  mAllocBytes += blocksize;
+  return new ReadaheadBlock(blocksize);
+}
+
+//------------------------------------------------------------------------------
+// Return a block to the pool
+//------------------------------------------------------------------------------
+void
+ReadaheadBlockPool::Put(ReadaheadBlock* block)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mCached[block->capacity].push_back(block);
+  mCachedBytes += block->capacity;
+}
+
+//------------------------------------------------------------------------------
+// Get the amount of memory allocated for blocks
+//------------------------------------------------------------------------------
+uint64_t
+ReadaheadBlockPool::GetAllocatedBytes()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mAllocBytes;
+}
+
+//------------------------------------------------------------------------------
+// Get the amount of memory held by cached blocks
+//------------------------------------------------------------------------------
+uint64_t
+ReadaheadBlockPool::GetCachedBytes()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mCachedBytes;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ReadaheadPolicy::ReadaheadPolicy(uint32_t init_window, uint32_t max_window):
+  mWindow(std::max(1u, init_window)),
+  mMaxWindow(std::max(mWindow, max_window)),
+  mHasLast(false), mLastOffset(0), mLastLength(0), mStride(0),
+  mSampleHits(0), mSampleCount(0), mHits(0), mMisses(0)
+{}
+
+//------------------------------------------------------------------------------
+// Classify a new request
+//------------------------------------------------------------------------------
+ReadaheadPolicy::Pattern
+ReadaheadPolicy::Update(uint64_t offset, uint32_t length)
+{
+  Pattern pattern = Pattern::kSequential;
+
+  if (mHasLast) {
+    int64_t stride = (int64_t)(offset - mLastOffset);
+
+    if (offset == mLastOffset + mLastLength) {
+      pattern = Pattern::kSequential;
+    } else if ((stride > 0) && (stride == mStride)) {
+      pattern = Pattern::kStrided;
+    } else {
+      pattern = Pattern::kRandom;
+    }
+
+    mStride = stride;
+  }
+
+  // The first request is assumed to start a sequential stream
+  mHasLast = true;
+  mLastOffset = offset;
+  mLastLength = length;
+  return pattern;
+}
+
+//------------------------------------------------------------------------------
+// Account a hit
+//------------------------------------------------------------------------------
+void
+ReadaheadPolicy::Hit()
+{
+  ++mHits;
+  ++mSampleHits;
+  ++mSampleCount;
+  Adjust();
+}
+
+//------------------------------------------------------------------------------
+// Account a miss
+//------------------------------------------------------------------------------
+void
+ReadaheadPolicy::Miss()
+{
+  ++mMisses;
+  ++mSampleCount;
+  Adjust();
+}
+
+//------------------------------------------------------------------------------
+// Adjust the window once enough lookups were sampled
+//------------------------------------------------------------------------------
+void
+ReadaheadPolicy::Adjust()
+{
+  if (mSampleCount < kSampleSize) {
+    return;
+  }
+
+  // Grow if at least 3/4 of the lookups were hits, shrink if less than half
+  if (4 * mSampleHits >= 3 * mSampleCount) {
+    mWindow = std::min(2 * mWindow, mMaxWindow);
+  } else if (2 * mSampleHits < mSampleCount) {
+    mWindow = std::max(mWindow / 2, 1u);
+  }
+
+  mSampleHits = 0;
+  mSampleCount = 0;
+}
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,235 @@
+//------------------------------------------------------------------------------
+// File: Readahead.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "fst/Namespace.hh"
+#include "fst/io/SimpleHandler.hh"
+#include "fst/io/BufferPool.hh"
+#include <map>
+#include <mutex>
+#include <vector>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Struct that holds a readahead buffer and corresponding handler
+//------------------------------------------------------------------------------
+struct ReadaheadBlock {
+
+  //----------------------------------------------------------------------------
+  //! Constuctor
+  //!
+  //! @param blocksize the size of the readahead
+  //----------------------------------------------------------------------------
+  ReadaheadBlock(uint64_t blocksize)
+  {
+    lease = BufferPool::GetInstance().Get(blocksize);
+    buffer = lease.GetDataPtr();
+    capacity = blocksize;
+    handler = new SimpleHandler();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Update current request
+  //!
+  //! @param offset offset
+  //! @param length length
+  //! @param isWrite true if write request, otherwise false
+  //----------------------------------------------------------------------------
+  void Update(uint64_t offset, uint32_t length, bool isWrite)
+  {
+    handler->Update(offset, length, isWrite);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~ReadaheadBlock()
+  {
+    delete handler;
+  }
+
+  BufferPool::Buffer lease; ///< buffer leased from the FST buffer pool
+  char* buffer; ///< pointer to where the data is read
+  uint64_t capacity; ///< size of the buffer
+  SimpleHandler* handler; ///< async handler for the requests
+};
+
+//------------------------------------------------------------------------------
+//! Class ReadaheadBlockPool - readahead blocks shared by all the XrdIo
+//! objects. The memory used by the blocks, both handed out and cached, is
+//! bounded by EOS_FST_XRDIO_RDAHEAD_POOL_MB (default 256 MB).
+//------------------------------------------------------------------------------
+class ReadaheadBlockPool
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Get the pool shared by all the XrdIo objects
+  //----------------------------------------------------------------------------
+  static ReadaheadBlockPool& GetInstance();
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param max_bytes max memory used by the blocks of the pool
+  //----------------------------------------------------------------------------
+  ReadaheadBlockPool(uint64_t max_bytes);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~ReadaheadBlockPool();
+
+  //----------------------------------------------------------------------------
+  //! Get a block with the given size
+  //!
+  //! @param blocksize size of the block
+  //!
+  //! @return block or null if the memory limit is reached
+  //----------------------------------------------------------------------------
+  ReadaheadBlock* Get(uint64_t blocksize);
+
+  //----------------------------------------------------------------------------
+  //! Return a block to the pool, the block must not have any request in flight
+  //!
+  //! @param block block to be returned
+  //----------------------------------------------------------------------------
+  void Put(ReadaheadBlock* block);
+
+  //----------------------------------------------------------------------------
+  //! Get the amount of memory allocated for blocks
+  //----------------------------------------------------------------------------
+  uint64_t GetAllocatedBytes();
+
+  //----------------------------------------------------------------------------
+  //! Get the amount of memory held by cached blocks
+  //----------------------------------------------------------------------------
+  uint64_t GetCachedBytes();
+
+private:
+  std::mutex mMutex; ///< mutex protecting the members below
+  uint64_t mMaxBytes; ///< max memory used by blocks
+  uint64_t mAllocBytes; ///< memory used by all allocated blocks
+  uint64_t mCachedBytes; ///< memory used by the cached blocks
+  ///< Cached blocks indexed by their size
+  std::map<uint64_t, std::vector<ReadaheadBlock*>> mCached;
+};
+
+//------------------------------------------------------------------------------
+//! Class ReadaheadPolicy - decides what should be prefetched based on the
+//! observed access pattern. Every request is classified as sequential,
+//! strided (constant distance from the previous request) or random. The
+//! number of blocks prefetched ahead of the current position doubles when the
+//! prefetched blocks are consistently used and halves when they are not.
+//------------------------------------------------------------------------------
+class ReadaheadPolicy
+{
+public:
+  //! Access pattern
+  enum class Pattern {
+    kRandom,
+    kSequential,
+    kStrided
+  };
+
+  //! Number of block lookups after which the window is adjusted
+  static constexpr uint32_t kSampleSize = 16;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param init_window initial number of blocks prefetched ahead
+  //! @param max_window max number of blocks prefetched ahead
+  //----------------------------------------------------------------------------
+  ReadaheadPolicy(uint32_t init_window, uint32_t max_window);
+
+  //----------------------------------------------------------------------------
+  //! Classify a new request
+  //!
+  //! @param offset request offset
+  //! @param length request length
+  //!
+  //! @return access pattern including this request
+  //----------------------------------------------------------------------------
+  Pattern Update(uint64_t offset, uint32_t length);
+
+  //----------------------------------------------------------------------------
+  //! Account a block lookup which found the data in a prefetched block
+  //----------------------------------------------------------------------------
+  void Hit();
+
+  //----------------------------------------------------------------------------
+  //! Account a block lookup which did not find the data in a prefetched block
+  //----------------------------------------------------------------------------
+  void Miss();
+
+  //----------------------------------------------------------------------------
+  //! Get the number of blocks that should be prefetched ahead
+  //----------------------------------------------------------------------------
+  inline uint32_t GetWindow() const
+  {
+    return mWindow;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the distance between the last two requests
+  //----------------------------------------------------------------------------
+  inline int64_t GetStride() const
+  {
+    return mStride;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the length of the last request
+  //----------------------------------------------------------------------------
+  inline uint32_t GetLastLength() const
+  {
+    return mLastLength;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the percentage of block lookups served by prefetched blocks
+  //----------------------------------------------------------------------------
+  inline double GetEfficiency() const
+  {
+    return ((mHits + mMisses) ? (100.0 * mHits / (mHits + mMisses)) : 0.0);
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Adjust the window once enough lookups were sampled
+  //----------------------------------------------------------------------------
+  void Adjust();
+
+  uint32_t mWindow; ///< Number of blocks prefetched ahead
+  uint32_t mMaxWindow; ///< Max number of blocks prefetched ahead
+  bool mHasLast; ///< True after the first request
+  uint64_t mLastOffset; ///< Offset of the last request
+  uint32_t mLastLength; ///< Length of the last request
+  int64_t mStride; ///< Distance between the last two requests
+  uint32_t mSampleHits; ///< Hits in the current sample
+  uint32_t mSampleCount; ///< Lookups in the current sample
+  uint64_t mHits; ///< Total number of hits
+  uint64_t mMisses; ///< Total number of misses
+};
+
+EOSFSTNAMESPACE_END
@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <cstdlib>
+#include <limits>
 #include "fst/io/xrd/XrdIo.hh"
 #include "fst/io/ChunkHandler.hh"
 #include "fst/io/VectChunkHandler.hh"
@@ -101,6 +102,7 @@ XrdIo::XrdIo(std::string path) :
   mBlocksize(mDefaultBlocksize),
   mXrdFile(NULL),
   mMetaHandler(new AsyncMetaHandler()),
+  mRaPolicy(mNumRdAheadBlocks, InitMaxRdAheadBlocks()),
   mXrdIdHelper(nullptr)
 {
   // Set the TimeoutResolution to 1
@@ -131,16 +133,12 @@ XrdIo::~XrdIo()
     fileClose();
   }
 
-  while (!mQueueBlocks.empty()) {
-    ReadaheadBlock* ptr_readblock = mQueueBlocks.front();
-    mQueueBlocks.pop();
-    delete ptr_readblock;
+  if (mDoReadahead) {
+    eos_debug("msg=\"readahead statistics\" efficiency=%.02f window=%u",
+              mRaPolicy.GetEfficiency(), mRaPolicy.GetWindow());
   }
 
-  while (!mMapBlocks.empty()) {
-    delete mMapBlocks.begin()->second;
-    mMapBlocks.erase(mMapBlocks.begin());
-  }
+  (void) RecycleBlocks(std::numeric_limits<uint64_t>::max());
 
   delete mMetaHandler;
 
@@ -170,53 +168,7 @@ XrdIo::fileOpen(XrdSfsFileOpenMode flags,
                 const std::string& opaque,
                 uint16_t timeout)
 {
-  const char* val = 0;
-  std::string lOpaque;
-  XrdOucEnv open_opaque(mOpaque.c_str());
-
-  XrdCl::XRootDStatus okstatus;
-  mWriteStatus = okstatus;
-
-  // Decide if readahead is used and the block size
-  if ((val = open_opaque.Get("fst.readahead")) &&
-      (strncmp(val, "true", 4) == 0)) {
-    eos_debug("Enabling the readahead.");
-    mDoReadahead = true;
-    val = 0;
-
-    if ((val = open_opaque.Get("fst.blocksize"))) {
-      mBlocksize = static_cast<uint64_t>(atoll(val));
-    }
-
-    for (unsigned int i = 0; i < mNumRdAheadBlocks; i++) {
-      mQueueBlocks.push(new ReadaheadBlock(mBlocksize));
-    }
-  }
-
-  // Final path + opaque info used in the open
-  std::string request;
-  ProcessOpaqueInfo(opaque, request);
-
-  if (mXrdFile) {
-    delete mXrdFile;
-    mXrdFile = NULL;
-  }
-
-  mXrdFile = new XrdCl::File();
-  mTargetUrl.FromString(request);
-  mXrdIdHelper.reset(new eos::common::XrdConnIdHelper(mXrdConnPool, mTargetUrl));
-
-  if (mXrdIdHelper->HasNewConnection()) {
-    eos_info("xrd_connection_id=%s", mTargetUrl.GetHostId().c_str());
-  }
-
-  // Disable recovery on read and write
-  if (!mXrdFile->SetProperty("ReadRecovery", "false") ||
-      !mXrdFile->SetProperty("WriteRecovery", "false")) {
-    eos_warning("failed to set XrdCl::File properties read recovery and write "
-                "recovery to false");
-  }
-
+  PrepareOpen(opaque, mOpaque);
   XrdCl::OpenFlags::Flags flags_xrdcl = eos::common::LayoutId::MapFlagsSfs2XrdCl(
                                           flags);
   XrdCl::Access::Mode mode_xrdcl = eos::common::LayoutId::MapModeSfs2XrdCl(mode);
@@ -251,20 +203,39 @@ XrdIo::fileOpenAsync(void* io_handler,
                      XrdSfsFileOpenMode flags, mode_t mode,
                      const std::string& opaque, uint16_t timeout)
 {
-  const char* val = 0;
-  std::string request;
-  std::string lOpaque;
-  size_t qpos = 0;
+  // Opaque info can be part of the 'path', otherwise the readahead is
+  // requested through the open opaque info
+  PrepareOpen(opaque, (mFilePath.find("?") != std::string::npos) ?
+              mOpaque : opaque);
+  XrdCl::OpenFlags::Flags flags_xrdcl =
+    eos::common::LayoutId::MapFlagsSfs2XrdCl(flags);
+  XrdCl::Access::Mode mode_xrdcl = eos::common::LayoutId::MapModeSfs2XrdCl(mode);
+  XrdCl::XRootDStatus status =
+    mXrdFile->Open(mTargetUrl.GetURL().c_str(), flags_xrdcl, mode_xrdcl,
+                   (XrdCl::ResponseHandler*)(io_handler), timeout);
 
-  // Opaque info can be part of the 'path'
-  if (((qpos = mFilePath.find("?")) != std::string::npos)) {
-    lOpaque = mFilePath.substr(qpos + 1);
-    //    mFilePath.erase(qpos);
-  } else {
-    lOpaque = opaque;
+  if (!status.IsOK()) {
+    eos_err("error=opening remote XrdClFile");
+    errno = status.errNo;
+    mLastErrMsg = status.ToString().c_str();
+    mLastErrCode  = status.code;
+    mLastErrNo  = status.errNo;
+    return SFS_ERROR;
   }
 
-  XrdOucEnv open_opaque(lOpaque.c_str());
+  return SFS_OK;
+}
+
+//------------------------------------------------------------------------------
+// Prepare a new XrdCl::File object for an open
+//------------------------------------------------------------------------------
+void
+XrdIo::PrepareOpen(const std::string& opaque, const std::string& ra_opaque)
+{
+  const char* val = 0;
+  XrdOucEnv open_opaque(ra_opaque.c_str());
+  XrdCl::XRootDStatus okstatus;
+  mWriteStatus = okstatus;
 
   // Decide if readahead is used and the block size
   if ((val = open_opaque.Get("fst.readahead")) &&
@@ -276,15 +247,11 @@ XrdIo::fileOpenAsync(void* io_handler,
     if ((val = open_opaque.Get("fst.blocksize"))) {
       mBlocksize = static_cast<uint64_t>(atoll(val));
     }
-
-    for (unsigned int i = 0; i < mNumRdAheadBlocks; i++) {
-      mQueueBlocks.push(new ReadaheadBlock(mBlocksize));
-    }
   }
 
-  request = mFilePath;
-  request += "?";
-  request += lOpaque;
+  // Final path + opaque info used in the open
+  std::string request;
+  ProcessOpaqueInfo(opaque, request);
 
   if (mXrdFile) {
     delete mXrdFile;
@@ -305,24 +272,6 @@ XrdIo::fileOpenAsync(void* io_handler,
     eos_warning("failed to set XrdCl::File properties read recovery and write "
                 "recovery to false");
   }
-
-  XrdCl::OpenFlags::Flags flags_xrdcl =
-    eos::common::LayoutId::MapFlagsSfs2XrdCl(flags);
-  XrdCl::Access::Mode mode_xrdcl = eos::common::LayoutId::MapModeSfs2XrdCl(mode);
-  XrdCl::XRootDStatus status =
-    mXrdFile->Open(mTargetUrl.GetURL().c_str(), flags_xrdcl, mode_xrdcl,
-                   (XrdCl::ResponseHandler*)(io_handler), timeout);
-
-  if (!status.IsOK()) {
-    eos_err("error=opening remote XrdClFile");
-    errno = status.errNo;
-    mLastErrMsg = status.ToString().c_str();
-    mLastErrCode  = status.code;
-    mLastErrNo  = status.errNo;
-    return SFS_ERROR;
-  }
-
-  return SFS_OK;
 }
 
 //------------------------------------------------------------------------------
@@ -414,7 +363,10 @@ XrdIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
     uint32_t aligned_length;
     uint32_t shift;
     std::map<uint64_t, ReadaheadBlock*>::iterator iter;
+    // Offset of the block prefetched for the current miss, if any
+    uint64_t miss_offset = std::numeric_limits<uint64_t>::max();
     mPrefetchMutex.Lock(); // -->
+    ReadaheadPolicy::Pattern pattern = mRaPolicy.Update(offset, length);
 
     while (length) {
       iter = FindBlock(offset);
@@ -424,21 +376,16 @@ XrdIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
         SimpleHandler* sh = iter->second->handler;
         shift = offset - iter->first;
 
-        // We can prefetch another block if we still have available blocks in
-        // the queue or if first read was from second prefetched block
-        if (!mQueueBlocks.empty() || (iter != mMapBlocks.begin())) {
-          if (iter != mMapBlocks.begin()) {
-            eos_debug("recycle the oldest block");
-            mQueueBlocks.push(mMapBlocks.begin()->second);
-            mMapBlocks.erase(mMapBlocks.begin());
-          }
+        if (iter->first != miss_offset) {
+          mRaPolicy.Hit();
+        }
 
-          eos_debug("prefetch new block(2)");
+        // Blocks before the current one are no longer needed, use them to
+        // prefetch the next ones
+        (void) RecycleBlocks(iter->first);
 
-          if (!PrefetchBlock(offset + mBlocksize, false, timeout)) {
-            eos_warning("failed to send prefetch request(2)");
-            break;
-          }
+        if (pattern != ReadaheadPolicy::Pattern::kRandom) {
+          FillWindow(iter->first, pattern, timeout);
         }
 
         if (sh->WaitOK()) {
@@ -455,9 +402,9 @@ XrdIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
           aligned_length = sh->GetRespLength() - shift;
           read_length = ((uint32_t) length < aligned_length) ? length : aligned_length;
 
-          // If prefetch block smaller than mBlocksize and current offset at end
-          // of the prefetch block then we reached the end of file
-          if ((sh->GetRespLength() != mBlocksize) &&
+          // If prefetch block smaller than the requested length and current
+          // offset at end of the prefetch block then we reached the end of file
+          if ((sh->GetRespLength() != sh->GetLength()) &&
               ((uint64_t) offset >= iter->first + sh->GetRespLength())) {
             done_read = true;
             break;
@@ -471,39 +418,49 @@ XrdIo::fileReadAsync(XrdSfsFileOffset offset, char* buffer,
           nread += read_length;
         } else {
           // Error while prefetching, remove block from map
-          mQueueBlocks.push(iter->second);
+          ReadaheadBlockPool::GetInstance().Put(iter->second);
           mMapBlocks.erase(iter);
           eos_err("error=prefetching failed, disable it and remove block from map");
           mDoReadahead = false;
           break;
         }
       } else {
+        mRaPolicy.Miss();
+
+        if (pattern == ReadaheadPolicy::Pattern::kRandom) {
+          // Prefetching does not help random reads, drop the blocks and
+          // serve the request directly
+          eos_debug("random access, skip readahead");
+          (void) RecycleBlocks(std::numeric_limits<uint64_t>::max());
+          break;
+        }
+
+        if (pattern == ReadaheadPolicy::Pattern::kStrided) {
+          // Serve the current request directly and prefetch the blocks at
+          // the next strides, keep any block which might still be used
+          (void) RecycleBlocks(offset);
+
+          if (nread == 0) {
+            FillWindow(offset, pattern, timeout);
+          }
+
+          break;
+        }
+
         // Remove all elements from map so that we can align with the new
         // requests and prefetch a new block. But first we need to collect any
         // responses which are in-flight as otherwise these response might
         // arrive later on, when we are expecting replies for other blocks since
         // we are recycling the SimpleHandler objects.
-        while (!mMapBlocks.empty()) {
-          SimpleHandler* sh = mMapBlocks.begin()->second->handler;
+        (void) RecycleBlocks(std::numeric_limits<uint64_t>::max());
+        eos_debug("prefetch new block(1)");
 
-          if (sh->HasRequest()) {
-            // Not interested in the result - discard it
-            sh->WaitOK();
-          }
-
-          mQueueBlocks.push(mMapBlocks.begin()->second);
-          mMapBlocks.erase(mMapBlocks.begin());
+        if (!PrefetchBlock(offset, false, timeout)) {
+          eos_warning("failed to send prefetch request(1)");
+          break;
         }
 
-        if (!mQueueBlocks.empty()) {
-          eos_debug("prefetch new block(1)");
-
-          if (!PrefetchBlock(offset, false, timeout)) {
-            eos_err("error=failed to send prefetch request(1)");
-            mDoReadahead = false;
-            break;
-          }
-        }
+        miss_offset = offset;
       }
     }
 
@@ -734,16 +691,7 @@ XrdIo::fileWaitAsyncIO()
     XrdSysMutexHelper scope_lock(mPrefetchMutex);
 
     // Wait for any requests on the fly and then close
-    while (!mMapBlocks.empty()) {
-      SimpleHandler* shandler = mMapBlocks.begin()->second->handler;
-
-      if (shandler->HasRequest()) {
-        async_ok = shandler->WaitOK();
-      }
-
-      delete mMapBlocks.begin()->second;
-      mMapBlocks.erase(mMapBlocks.begin());
-    }
+    async_ok = RecycleBlocks(std::numeric_limits<uint64_t>::max());
   }
 
   // Wait for any async requests before closing
@@ -1004,12 +952,6 @@ void
 XrdIo::CleanReadCache()
 {
   fileWaitAsyncIO();
-
-  if (mQueueBlocks.empty()) {
-    for (unsigned int i = 0; i < mNumRdAheadBlocks; i++) {
-      mQueueBlocks.push(new ReadaheadBlock(mBlocksize));
-    }
-  }
 }
 
 //------------------------------------------------------------------------------
@@ -1024,10 +966,10 @@ XrdIo::PrefetchBlock(int64_t offset, bool isWrite, uint16_t timeout)
   eos_debug("try to prefetch with offset: %lli, length: %lu",
             offset, mBlocksize);
 
-  if (!mQueueBlocks.empty()) {
-    block = mQueueBlocks.front();
-    mQueueBlocks.pop();
-  } else {
+  block = ReadaheadBlockPool::GetInstance().Get(mBlocksize);
+
+  if (!block) {
+    eos_debug("msg=\"readahead pool exhausted\"");
     done = false;
     return done;
   }
@@ -1040,7 +982,9 @@ XrdIo::PrefetchBlock(int64_t offset, bool isWrite, uint16_t timeout)
     // Create tmp status which is deleted in the HandleResponse method
     XrdCl::XRootDStatus* tmp_status = new XrdCl::XRootDStatus(status);
     block->handler->HandleResponse(tmp_status, NULL);
-    mQueueBlocks.push(block);
+    // Collect the failed response so that the handler can be reused
+    (void) block->handler->WaitOK();
+    ReadaheadBlockPool::GetInstance().Put(block);
     done = false;
   } else {
     mMapBlocks.insert(std::make_pair(offset, block));
@@ -1049,6 +993,59 @@ XrdIo::PrefetchBlock(int64_t offset, bool isWrite, uint16_t timeout)
   return done;
 }
 
+//------------------------------------------------------------------------------
+// Prefetch the blocks following the given one
+//------------------------------------------------------------------------------
+void
+XrdIo::FillWindow(uint64_t offset, ReadaheadPolicy::Pattern pattern,
+                  uint16_t timeout)
+{
+  uint64_t step = mBlocksize;
+
+  // Strides shorter than a block are covered by prefetching whole blocks
+  if ((pattern == ReadaheadPolicy::Pattern::kStrided) &&
+      (mRaPolicy.GetStride() > mBlocksize)) {
+    step = mRaPolicy.GetStride();
+  }
+
+  for (uint32_t i = 1; i <= mRaPolicy.GetWindow(); ++i) {
+    uint64_t blk_offset = offset + i * step;
+
+    if (mMapBlocks.find(blk_offset) != mMapBlocks.end()) {
+      continue;
+    }
+
+    eos_debug("prefetch new block(2)");
+
+    if (!PrefetchBlock(blk_offset, false, timeout)) {
+      eos_warning("failed to send prefetch request(2)");
+      break;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Return to the pool the prefetched blocks starting before the given offset
+//------------------------------------------------------------------------------
+bool
+XrdIo::RecycleBlocks(uint64_t offset)
+{
+  bool all_ok = true;
+
+  while (!mMapBlocks.empty() && (mMapBlocks.begin()->first < offset)) {
+    SimpleHandler* sh = mMapBlocks.begin()->second->handler;
+
+    if (sh->HasRequest()) {
+      all_ok = (sh->WaitOK() && all_ok);
+    }
+
+    ReadaheadBlockPool::GetInstance().Put(mMapBlocks.begin()->second);
+    mMapBlocks.erase(mMapBlocks.begin());
+  }
+
+  return all_ok;
+}
+
 //------------------------------------------------------------------------------
 // Get pointer to async meta handler object
 //------------------------------------------------------------------------------
@@ -26,18 +26,16 @@
 #define __EOSFST_XRDFILEIO_HH__
 
 #include "fst/io/FileIo.hh"
-#include "fst/io/SimpleHandler.hh"
+#include "fst/io/xrd/Readahead.hh"
 #include "common/FileMap.hh"
 #include "common/XrdConnPool.hh"
 #include "XrdCl/XrdClFile.hh"
-#include <queue>
 
 EOSFSTNAMESPACE_BEGIN
 
 //! Forward declarations
 class XrdIo;
 class AsyncMetaHandler;
-struct ReadaheadBlock;
 
 //------------------------------------------------------------------------------
 //! Class used for handling asynchronous open responses
@@ -78,48 +76,6 @@ private:
 
 typedef std::map<uint64_t, ReadaheadBlock*> PrefetchMap;
 
-//------------------------------------------------------------------------------
-//! Struct that holds a readahead buffer and corresponding handler
-//------------------------------------------------------------------------------
-struct ReadaheadBlock {
-
-  //----------------------------------------------------------------------------
-  //! Constuctor
-  //!
-  //! @param blocksize the size of the readahead
-  //----------------------------------------------------------------------------
-  ReadaheadBlock(uint64_t blocksize)
-  {
-    buffer = new char[blocksize];
-    handler = new SimpleHandler();
-  }
-
-  //----------------------------------------------------------------------------
-  //! Update current request
-  //!
-  //! @param offset offset
-  //! @param length length
-  //! @param isWrite true if write request, otherwise false
-  //----------------------------------------------------------------------------
-  void Update(uint64_t offset, uint32_t length, bool isWrite)
-  {
-    handler->Update(offset, length, isWrite);
-  }
-
-  //----------------------------------------------------------------------------
-  //! Destructor
-  //----------------------------------------------------------------------------
-  virtual ~ReadaheadBlock()
-  {
-    delete[] buffer;
-    delete handler;
-  }
-
-  char* buffer; ///< pointer to where the data is read
-  SimpleHandler* handler; ///< async handler for the requests
-};
-
-
 //------------------------------------------------------------------------------
 //! Class used for doing remote IO operations using the Xrd client
 //------------------------------------------------------------------------------
@@ -127,6 +83,14 @@ class XrdIo : public FileIo
 {
   friend class AsyncIoOpenHandler;
 public:
+  //----------------------------------------------------------------------------
+  //! Get the connection pool shared by all the XrdIo objects
+  //----------------------------------------------------------------------------
+  static eos::common::XrdConnPool& GetConnPool()
+  {
+    return mXrdConnPool;
+  }
+
   //----------------------------------------------------------------------------
   //! InitBlocksize
   //!
@@ -152,6 +116,18 @@ public:
     return (ptr ? strtoul(ptr, 0, 10) : 2ul);
   }
 
+  //----------------------------------------------------------------------------
+  //! InitMaxRdAheadBlocks
+  //!
+  //! @return : max number of blocks that can be read ahead
+  //----------------------------------------------------------------------------
+  static uint32_t InitMaxRdAheadBlocks()
+  {
+    char* ptr = getenv("EOS_FST_XRDIO_RDAHEAD_MAX_BLOCKS");
+    // default is 8 if envar is not set
+    return (ptr ? strtoul(ptr, 0, 10) : 8ul);
+  }
+
   //----------------------------------------------------------------------------
   //! GetDefaultBlocksize
   //!
@@ -542,7 +518,7 @@ private:
   XrdCl::File* mXrdFile; ///< handler to xrd file
   AsyncMetaHandler* mMetaHandler; ///< async requests meta handler
   PrefetchMap mMapBlocks; ///< map of block read/prefetched
-  std::queue<ReadaheadBlock*> mQueueBlocks; ///< queue containing available blocks
+  ReadaheadPolicy mRaPolicy; ///< decides the blocks to be prefetched
   XrdSysMutex mPrefetchMutex; ///< mutex to serialise the prefetch step
   eos::common::FileMap mFileMap; ///< extended attribute file map
   std::string mAttrUrl; ///< extended attribute url
@@ -566,6 +542,27 @@ private:
   //----------------------------------------------------------------------------
   bool PrefetchBlock(int64_t offset, bool isWrite, uint16_t timeout = 0);
 
+  //----------------------------------------------------------------------------
+  //! Prefetch the blocks following the given one as decided by the readahead
+  //! policy. Blocks which are already prefetched are skipped.
+  //!
+  //! @param offset begin offset of the current block
+  //! @param pattern access pattern of the current request
+  //! @param timeout timeout value
+  //----------------------------------------------------------------------------
+  void FillWindow(uint64_t offset, ReadaheadPolicy::Pattern pattern,
+                  uint16_t timeout);
+
+  //----------------------------------------------------------------------------
+  //! Return to the pool the prefetched blocks starting before the given offset
+  //! after collecting any response in-flight for them
+  //!
+  //! @param offset blocks with a smaller begin offset are recycled
+  //!
+  //! @return true if all the collected responses were successful
+  //----------------------------------------------------------------------------
+  bool RecycleBlocks(uint64_t offset);
+
   //----------------------------------------------------------------------------
   //! Try to find a block in cache with contains the provided offset
   //!
@@ -612,6 +609,15 @@ private:
   //----------------------------------------------------------------------------
   void ProcessOpaqueInfo(const std::string& opaque, std::string& out) const;
 
+  //----------------------------------------------------------------------------
+  //! Prepare a new XrdCl::File object for an open, shared by the synchronous
+  //! and asynchronous opens so that both send the same request
+  //!
+  //! @param opaque opaque information
+  //! @param ra_opaque opaque information deciding the readahead settings
+  //----------------------------------------------------------------------------
+  void PrepareOpen(const std::string& opaque, const std::string& ra_opaque);
+
   //----------------------------------------------------------------------------
   //! Disable copy constructor
   //----------------------------------------------------------------------------
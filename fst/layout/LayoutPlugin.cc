@@ -29,6 +29,7 @@
 #include "fst/layout/RaidDpLayout.hh"
 #include "fst/layout/ReedSLayout.hh"
 #include "fst/Load.hh"
+#include <type_traits>
 /*----------------------------------------------------------------------------*/
 
 EOSFSTNAMESPACE_BEGIN
@@ -51,6 +52,73 @@ LayoutPlugin::~LayoutPlugin()
 }
 
 
+namespace
+{
+//------------------------------------------------------------------------------
+//! Layout plugin class implementing a layout type, the rain plugins take the
+//! store recovery flag as well
+//------------------------------------------------------------------------------
+template<unsigned long type> struct LayoutTraits;
+
+template<> struct LayoutTraits<LayoutId::kPlain> {
+  typedef PlainLayout Class;
+  static constexpr bool kRain = false;
+};
+
+template<> struct LayoutTraits<LayoutId::kReplica> {
+  typedef ReplicaParLayout Class;
+  static constexpr bool kRain = false;
+};
+
+template<> struct LayoutTraits<LayoutId::kRaidDP> {
+  typedef RaidDpLayout Class;
+  static constexpr bool kRain = true;
+};
+
+template<> struct LayoutTraits<LayoutId::kRaid6> {
+  typedef ReedSLayout Class;
+  static constexpr bool kRain = true;
+};
+
+template<> struct LayoutTraits<LayoutId::kArchive> {
+  typedef ReedSLayout Class;
+  static constexpr bool kRain = true;
+};
+
+template<typename T>
+Layout*
+MakeLayout(std::false_type, XrdFstOfsFile* file, unsigned long layoutId,
+           const XrdSecEntity* client, XrdOucErrInfo* error, const char* path,
+           uint16_t timeout, bool)
+{
+  return new T(file, layoutId, client, error, path, timeout);
+}
+
+template<typename T>
+Layout*
+MakeLayout(std::true_type, XrdFstOfsFile* file, unsigned long layoutId,
+           const XrdSecEntity* client, XrdOucErrInfo* error, const char* path,
+           uint16_t timeout, bool storeRecovery)
+{
+  return new T(file, layoutId, client, error, path, timeout, storeRecovery);
+}
+
+//------------------------------------------------------------------------------
+//! Create the layout plugin object of a layout type known at compile time
+//------------------------------------------------------------------------------
+template<unsigned long type>
+Layout*
+CreateLayout(XrdFstOfsFile* file, unsigned long layoutId,
+             const XrdSecEntity* client, XrdOucErrInfo* error,
+             const char* path, uint16_t timeout, bool storeRecovery)
+{
+  typedef LayoutTraits<type> Traits;
+  return MakeLayout<typename Traits::Class>
+         (std::integral_constant<bool, Traits::kRain>(), file, layoutId, client,
+          error, path, timeout, storeRecovery);
+}
+}
+
 //------------------------------------------------------------------------------
 // Get layout object
 //------------------------------------------------------------------------------
@@ -63,28 +131,30 @@ LayoutPlugin::GetLayoutObject(XrdFstOfsFile* file,
                               uint16_t timeout,
                               bool storeRecovery)
 {
-  if (LayoutId::GetLayoutType(layoutId) == LayoutId::kPlain) {
-    return static_cast<Layout*>(new PlainLayout(file, layoutId, client, error, path,
-                                timeout));
-  }
+  switch (LayoutId::GetLayoutType(layoutId)) {
+  case LayoutId::kPlain:
+    return CreateLayout<LayoutId::kPlain>(file, layoutId, client, error, path,
+                                          timeout, storeRecovery);
 
-  if (LayoutId::GetLayoutType(layoutId) == LayoutId::kReplica) {
-    return static_cast<Layout*>(new ReplicaParLayout(file, layoutId, client, error,
-                                path, timeout));
-  }
+  case LayoutId::kReplica:
+    return CreateLayout<LayoutId::kReplica>(file, layoutId, client, error, path,
+                                            timeout, storeRecovery);
 
-  if (LayoutId::GetLayoutType(layoutId) == LayoutId::kRaidDP) {
-    return static_cast<Layout*>(new RaidDpLayout(file, layoutId, client, error,
-                                path, timeout, storeRecovery));
-  }
+  case LayoutId::kRaidDP:
+    return CreateLayout<LayoutId::kRaidDP>(file, layoutId, client, error, path,
+                                           timeout, storeRecovery);
 
-  if ((LayoutId::GetLayoutType(layoutId) == LayoutId::kRaid6) ||
-      (LayoutId::GetLayoutType(layoutId) == LayoutId::kArchive)) {
-    return static_cast<Layout*>(new ReedSLayout(file, layoutId, client, error, path,
-                                timeout, storeRecovery));
-  }
+  case LayoutId::kRaid6:
+    return CreateLayout<LayoutId::kRaid6>(file, layoutId, client, error, path,
+                                          timeout, storeRecovery);
+
+  case LayoutId::kArchive:
+    return CreateLayout<LayoutId::kArchive>(file, layoutId, client, error, path,
+                                            timeout, storeRecovery);
 
-  return 0;
+  default:
+    return 0;
+  }
 }
 
 EOSFSTNAMESPACE_END
@@ -833,16 +833,21 @@ RaidDpLayout::Truncate(XrdSfsFileOffset offset)
       truncate_offset = offset;
     }
 
-    for (unsigned int i = 1; i < mStripe.size(); i++) {
+    // Truncate all the remote stripes at once
+    auto truncate_stripe = [&](unsigned int i) {
       eos_debug("Truncate stripe %i, to file_offset = %lli, stripe_offset = %zu",
                 i, offset, truncate_offset);
 
-      if (mStripe[i]) {
-        if (mStripe[i]->fileTruncate(truncate_offset, mTimeout)) {
-          eos_err("error while truncating");
-          return SFS_ERROR;
-        }
+      if (mStripe[i]->fileTruncate(truncate_offset, mTimeout)) {
+        eos_err("error while truncating");
+        return SFS_ERROR;
       }
+
+      return SFS_OK;
+    };
+
+    if (ForEachStripe(1, truncate_stripe)) {
+      return SFS_ERROR;
     }
   }
 
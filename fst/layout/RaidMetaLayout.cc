@@ -21,13 +21,19 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
  ************************************************************************/
 
+#include <chrono>
 #include <cmath>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <utility>
 #include <stdint.h>
 #include "common/Timing.hh"
 #include "fst/layout/RaidMetaLayout.hh"
+#include "fst/layout/StripeOpenTracker.hh"
 #include "fst/io/AsyncMetaHandler.hh"
+#include "fst/io/BufferPool.hh"
+#include "fst/io/xrd/XrdIo.hh"
 #include "fst/layout/HeaderCRC.hh"
 
 // Linux compat for Apple
@@ -39,6 +45,30 @@
 
 EOSFSTNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+// Get the time in milliseconds a read open waits for the slowest stripes once
+// enough stripes to serve the data are open - can be overwritten using the
+// EOS_FST_RAIN_OPEN_GRACE_MS env variable, 0 waits for all the stripes.
+//------------------------------------------------------------------------------
+static std::chrono::milliseconds
+GetOpenGrace()
+{
+  static std::chrono::milliseconds grace = []() {
+    long ms = 1000;
+
+    if (getenv("EOS_FST_RAIN_OPEN_GRACE_MS")) {
+      try {
+        ms = std::stol(getenv("EOS_FST_RAIN_OPEN_GRACE_MS"));
+      } catch (...) {
+        // keep the default value
+      }
+    }
+
+    return std::chrono::milliseconds(ms > 0 ? ms : 0);
+  }();
+  return grace;
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -70,6 +100,7 @@ RaidMetaLayout::RaidMetaLayout(XrdFstOfsFile* file,
   mTargetSize(targetSize),
   mSizeLine(0),
   mSizeGroup(0),
+  mNbWriteGroups(16),
   mBookingOpaque(bookingOpaque)
 {
   mStripeWidth = eos::common::LayoutId::GetBlocksize(lid);
@@ -80,6 +111,14 @@ RaidMetaLayout::RaidMetaLayout(XrdFstOfsFile* file,
   mOffGroupParity = -1;
   mPhysicalStripeIndex = -1;
   mIsEntryServer = false;
+
+  if (getenv("EOS_FST_RAIN_WRITE_GROUPS")) {
+    try {
+      mNbWriteGroups = std::stoul(getenv("EOS_FST_RAIN_WRITE_GROUPS"));
+    } catch (...) {
+      // keep the default value
+    }
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -87,6 +126,16 @@ RaidMetaLayout::RaidMetaLayout(XrdFstOfsFile* file,
 //------------------------------------------------------------------------------
 RaidMetaLayout::~RaidMetaLayout()
 {
+  // The stripes left behind by an early open can only go once their open
+  // response arrived, which the open timeout bounds
+  if (mOpenTracker) {
+    (void) mOpenTracker->Wait(0, std::chrono::milliseconds(0));
+  }
+
+  for (auto file : mLateStripes) {
+    delete file;
+  }
+
   while (!mHdrInfo.empty()) {
     HeaderCRC* hd = mHdrInfo.back();
     mHdrInfo.pop_back();
@@ -104,11 +153,8 @@ RaidMetaLayout::~RaidMetaLayout()
     delete file;
   }
 
-  while (!mDataBlocks.empty()) {
-    char* ptr_char = mDataBlocks.back();
-    mDataBlocks.pop_back();
-    delete[] ptr_char;
-  }
+  // The memory of the blocks goes back to the buffer pool with mDataBuffers
+  mDataBlocks.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -229,7 +275,8 @@ RaidMetaLayout::Open(XrdSfsFileOpenMode flags, mode_t mode, const char* opaque)
 
     // Allocate memory for blocks - used only by the entry server
     for (unsigned int i = 0; i < mNbTotalBlocks; i++) {
-      mDataBlocks.push_back(new char[mStripeWidth]);
+      mDataBuffers.push_back(BufferPool::GetInstance().Get(mStripeWidth));
+      mDataBlocks.push_back(mDataBuffers.back().GetDataPtr());
     }
 
     // Assign stripe urls and check minimal requirements
@@ -267,6 +314,20 @@ RaidMetaLayout::Open(XrdSfsFileOpenMode flags, mode_t mode, const char* opaque)
     if ((mOfsFile->mTpcFlag == XrdFstOfsFile::kTpcSrcRead) ||
         (mOfsFile->mTpcFlag == XrdFstOfsFile::kTpcDstSetup) ||
         (mOfsFile->mTpcFlag == XrdFstOfsFile::kTpcNone)) {
+      // Set the correct open flags for the stripes
+      if (mStoreRecovery || (flags & (SFS_O_RDWR | SFS_O_TRUNC | SFS_O_WRONLY))) {
+        mIsRw = true;
+        eos_debug("Write case with flags:%x", flags);
+      } else {
+        mode = 0;
+        eos_debug("Read case with flags=%x", flags);
+      }
+
+      // The opens are sent to all the remote stripes at once and their
+      // responses collected by the tracker
+      std::shared_ptr<StripeOpenTracker> tracker =
+        std::make_shared<StripeOpenTracker>(stripe_urls.size());
+
       for (unsigned int i = 0; i < stripe_urls.size(); i++) {
         if (i != (unsigned int) mPhysicalStripeIndex) {
           eos_info("Open remote stripe i=%i ", i);
@@ -290,44 +351,78 @@ RaidMetaLayout::Open(XrdSfsFileOpenMode flags, mode_t mode, const char* opaque)
           }
 
           stripe_urls[i] += remoteOpenOpaque.c_str();
-          int ret = -1;
           FileIo* file = FileIoPlugin::GetIoObject(stripe_urls[i].c_str(), mOfsFile,
                          mSecEntity);
+          unsigned int pos = mStripe.size();
+          mStripe.push_back(file);
+          mHdrInfo.push_back(new HeaderCRC(mSizeHeader, mStripeWidth));
+          XrdIo* io_file = dynamic_cast<XrdIo*>(file);
 
-          // Set the correct open flags for the stripe
-          if (mStoreRecovery || (flags & (SFS_O_RDWR | SFS_O_TRUNC | SFS_O_WRONLY))) {
-            mIsRw = true;
-            eos_debug("Write case with flags:%x", flags);
-          } else {
-            mode = 0;
-            eos_debug("Read case with flags=%x", flags);
+          if (!io_file) {
+            // No asynchronous open for this type of IO
+            tracker->Done(pos, file->fileOpen(flags, mode, enhanced_opaque.c_str(),
+                                              mTimeout) == SFS_OK);
+            continue;
           }
 
-          // Doing the actual open
-          ret = file->fileOpen(flags, mode, enhanced_opaque.c_str(), mTimeout);
-          mLastTriedUrl = file->GetLastTriedUrl();
+          XrdCl::ResponseHandler* stripe_handler = tracker->GetHandler(pos);
+          AsyncIoOpenHandler* io_handler = new AsyncIoOpenHandler(io_file,
+              stripe_handler);
 
-          if (ret == SFS_ERROR) {
-            eos_warning("warning=failed to open remote stripe: %s", stripe_urls[i].c_str());
-            delete file;
-            file = NULL;
-          } else {
-            mLastUrl = file->GetLastUrl();
+          if (io_file->fileOpenAsync(io_handler, flags, mode,
+                                     enhanced_opaque.c_str(), mTimeout)) {
+            delete io_handler;
+            delete stripe_handler;
+            tracker->Done(pos, false);
           }
+        }
+      }
 
-          mStripe.push_back(file);
-          mHdrInfo.push_back(new HeaderCRC(mSizeHeader, mStripeWidth));
-          // Read header information for remote files
-          hd = mHdrInfo.back();
-          file = mStripe.back();
+      // A read only needs the data stripes, the slowest ones are given a
+      // grace period after which they are treated as missing
+      size_t min_ok = 0;
 
-          if (file && !hd->ReadFromFile(file, mTimeout)) {
-            eos_warning("reading header failed for remote stripe phyid=%i",
-                        mStripe.size() - 1);
-          }
+      if (!mIsRw && (GetOpenGrace().count() > 0)) {
+        min_ok = mNbDataFiles - 1;
+      }
+
+      if (!tracker->Wait(min_ok, GetOpenGrace())) {
+        mOpenTracker = tracker;
+      }
+
+      for (unsigned int i = 1; i < mStripe.size(); i++) {
+        FileIo* file = mStripe[i];
+        StripeOpenTracker::State state = tracker->GetState(i);
+        mLastTriedUrl = file->GetLastTriedUrl();
+
+        if (state == StripeOpenTracker::State::kOk) {
+          mLastUrl = file->GetLastUrl();
+          continue;
+        }
+
+        if (state == StripeOpenTracker::State::kPending) {
+          eos_warning("warning=remote stripe not opened within the grace "
+                      "period: %s", file->GetPath().c_str());
+          mLateStripes.push_back(file);
+        } else {
+          eos_warning("warning=failed to open remote stripe: %s",
+                      file->GetPath().c_str());
+          delete file;
         }
+
+        mStripe[i] = NULL;
       }
 
+      // Read header information for remote files
+      (void) ForEachStripe(1, [this](unsigned int i) {
+        if (!mHdrInfo[i]->ReadFromFile(mStripe[i], mTimeout)) {
+          eos_warning("reading header failed for remote stripe phyid=%i", i);
+          return SFS_ERROR;
+        }
+
+        return SFS_OK;
+      });
+
       // Consistency checks
       if (mStripe.size() != mNbTotalFiles) {
         eos_err("number of files opened is different from the one expected");
@@ -341,6 +436,10 @@ RaidMetaLayout::Open(XrdSfsFileOpenMode flags, mode_t mode, const char* opaque)
         errno = EIO;
         return SFS_ERROR;
       }
+
+      if (mIsRw) {
+        SetWriteWindow();
+      }
     }
   }
 
@@ -396,7 +495,8 @@ RaidMetaLayout::OpenPio(std::vector<std::string> stripeUrls,
 
   // Allocate memory for blocks - done only once
   for (unsigned int i = 0; i < mNbTotalBlocks; i++) {
-    mDataBlocks.push_back(new char[mStripeWidth]);
+    mDataBuffers.push_back(BufferPool::GetInstance().Get(mStripeWidth));
+    mDataBlocks.push_back(mDataBuffers.back().GetDataPtr());
   }
 
   //!!!!
@@ -412,21 +512,25 @@ RaidMetaLayout::OpenPio(std::vector<std::string> stripeUrls,
     eos_debug("Read case");
   }
 
-// Open stripes
+  // Open stripes, all of them at once
   for (unsigned int i = 0; i < stripe_urls.size(); i++) {
-    int ret = -1;
-    FileIo* file = FileIoPlugin::GetIoObject(stripe_urls[i]);
+    mStripe.push_back(FileIoPlugin::GetIoObject(stripe_urls[i]));
+    mHdrInfo.push_back(new HeaderCRC(mSizeHeader, mStripeWidth));
+  }
+
+  std::vector<int> open_rc(mStripe.size(), SFS_ERROR);
+  (void) ForEachStripe(0, [&](unsigned int i) {
+    FileIo* file = mStripe[i];
     XrdOucString openOpaque = opaque;
     openOpaque += "&mgm.replicaindex=";
     openOpaque += static_cast<int>(i);
     openOpaque += "&fst.readahead=true";
     openOpaque += "&fst.blocksize=";
     openOpaque += static_cast<int>(mStripeWidth);
-    ret = file->fileOpen(flags, mode, openOpaque.c_str());
-    mLastTriedUrl = file->GetLastTriedUrl();
+    int ret = file->fileOpen(flags, mode, openOpaque.c_str());
 
     if (ret == SFS_ERROR) {
-      eos_err("failed to open remote stripes", stripe_urls[i].c_str());
+      eos_err("failed to open remote stripe %s", stripe_urls[i].c_str());
 
       // If flag is SFS_RDWR then we can try to create the file
       if (flags & SFS_O_RDWR) {
@@ -436,26 +540,29 @@ RaidMetaLayout::OpenPio(std::vector<std::string> stripeUrls,
 
         if (ret == SFS_ERROR) {
           eos_err("error=failed to create remote stripes %s", stripe_urls[i].c_str());
-          delete file;
-          file = NULL;
         }
-      } else {
-        delete file;
-        file = NULL;
       }
-    } else {
-      mLastUrl = file->GetLastUrl();
     }
 
-    mStripe.push_back(file);
-    mHdrInfo.push_back(new HeaderCRC(mSizeHeader, mStripeWidth));
-    // Read header information for remote files
-    HeaderCRC* hd = mHdrInfo.back();
-    file = mStripe.back();
+    open_rc[i] = ret;
 
-    if (file && !hd->ReadFromFile(file, mTimeout)) {
+    // Read header information for remote files
+    if ((ret != SFS_ERROR) && !mHdrInfo[i]->ReadFromFile(file, mTimeout)) {
       eos_err("RAIN header invalid");
     }
+
+    return ret;
+  });
+
+  for (unsigned int i = 0; i < mStripe.size(); i++) {
+    mLastTriedUrl = mStripe[i]->GetLastTriedUrl();
+
+    if (open_rc[i] == SFS_ERROR) {
+      delete mStripe[i];
+      mStripe[i] = NULL;
+    } else {
+      mLastUrl = mStripe[i]->GetLastUrl();
+    }
   }
 
   // For PIO if header invalid then we abort
@@ -619,7 +726,9 @@ RaidMetaLayout::Read(XrdSfsFileOffset offset, char* buffer,
         len = mSizeGroup;
       }
 
-      char* recover_block = new char[mStripeWidth];
+      BufferPool::Buffer recover_buffer =
+        BufferPool::GetInstance().Get(mStripeWidth);
+      char* recover_block = recover_buffer.GetDataPtr();
 
       while ((uint32_t)len >= mStripeWidth) {
         all_errs.push_back(XrdCl::ChunkInfo((uint64_t)offset,
@@ -629,7 +738,6 @@ RaidMetaLayout::Read(XrdSfsFileOffset offset, char* buffer,
         if (offset % mSizeGroup == 0) {
           if (!RecoverPieces(all_errs)) {
             eos_err("failed recovery of stripe");
-            delete[] recover_block;
             return SFS_ERROR;
           } else {
             all_errs.clear();
@@ -639,8 +747,6 @@ RaidMetaLayout::Read(XrdSfsFileOffset offset, char* buffer,
         len -= mSizeGroup;
         offset += mSizeGroup;
       }
-
-      delete[] recover_block;
     } else {
       // Reset all the async handlers
       for (unsigned int i = 0; i < mStripe.size(); i++) {
@@ -1234,6 +1340,54 @@ RaidMetaLayout::SparseParityComputation(bool force)
   return done;
 }
 
+//------------------------------------------------------------------------------
+// Limit the amount of data written asynchronously to each of the stripes
+//------------------------------------------------------------------------------
+void
+RaidMetaLayout::SetWriteWindow()
+{
+  if (mNbWriteGroups == 0) {
+    return;
+  }
+
+  // Every stripe receives the same share of each group, both data and parity
+  uint64_t max_bytes = mNbWriteGroups * (mSizeGroup / mNbDataFiles);
+
+  for (unsigned int i = 0; i < mStripe.size(); i++) {
+    if (mStripe[i]) {
+      AsyncMetaHandler* phandler =
+        static_cast<AsyncMetaHandler*>(mStripe[i]->fileGetAsyncHandler());
+
+      if (phandler) {
+        phandler->SetMaxWriteInFlight(max_bytes);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Wait for all the asynchronous requests sent to the stripes
+//------------------------------------------------------------------------------
+bool
+RaidMetaLayout::WaitAsyncRequests()
+{
+  bool done = true;
+
+  for (unsigned int i = 0; i < mStripe.size(); i++) {
+    if (mStripe[i]) {
+      AsyncMetaHandler* phandler =
+        static_cast<AsyncMetaHandler*>(mStripe[i]->fileGetAsyncHandler());
+
+      if (phandler && (phandler->WaitOK() != XrdCl::errNone)) {
+        eos_err("async requests failed for stripe=%u", i);
+        done = false;
+      }
+    }
+  }
+
+  return done;
+}
+
 //------------------------------------------------------------------------------
 // Sync files to disk
 //------------------------------------------------------------------------------
@@ -1254,17 +1408,31 @@ RaidMetaLayout::Sync()
     }
 
     if (mIsEntryServer) {
+      // Collect the responses of the pending writes before syncing
+      if (!WaitAsyncRequests()) {
+        eos_err("write failed in previous requests");
+        ret = SFS_ERROR;
+      }
+
       // Sync remote files
       for (unsigned int i = 1; i < mStripe.size(); i++) {
-        if (mStripe[i]) {
-          if (mStripe[i]->fileSync(mTimeout)) {
-            eos_err("file %i could not be synced", i);
-            ret = SFS_ERROR;
-          }
-        } else {
+        if (!mStripe[i]) {
           eos_warning("remote file could not be synced as it is NULL");
         }
       }
+
+      auto sync_stripe = [this](unsigned int i) {
+        if (mStripe[i]->fileSync(mTimeout)) {
+          eos_err("file %i could not be synced", i);
+          return SFS_ERROR;
+        }
+
+        return SFS_OK;
+      };
+
+      if (ForEachStripe(1, sync_stripe)) {
+        ret = SFS_ERROR;
+      }
     }
   } else {
     eos_err("file is not opened");
@@ -1286,15 +1454,23 @@ RaidMetaLayout::Remove()
   if (mIsEntryServer) {
     // Unlink remote stripes
     for (unsigned int i = 1; i < mStripe.size(); i++) {
-      if (mStripe[i]) {
-        if (mStripe[i]->fileRemove(mTimeout)) {
-          eos_err("failed to remove remote stripe %i", i);
-          ret = SFS_ERROR;
-        }
-      } else {
+      if (!mStripe[i]) {
         eos_warning("remote file could not be removed as it is NULL");
       }
     }
+
+    auto remove_stripe = [this](unsigned int i) {
+      if (mStripe[i]->fileRemove(mTimeout)) {
+        eos_err("failed to remove remote stripe %i", i);
+        return SFS_ERROR;
+      }
+
+      return SFS_OK;
+    };
+
+    if (ForEachStripe(1, remove_stripe)) {
+      ret = SFS_ERROR;
+    }
   }
 
   // Unlink local stripe
@@ -1322,14 +1498,27 @@ RaidMetaLayout::Stat(struct stat* buf)
 
   if (mIsOpen) {
     if (mIsEntryServer) {
-      for (unsigned int i = 0; i < mStripe.size(); i++) {
-        if (mStripe[i]) {
-          if (mStripe[i]->fileStat(buf, mTimeout) == SFS_OK) {
+      if (mStripe[0] && (mStripe[0]->fileStat(buf, mTimeout) == SFS_OK)) {
+        found = true;
+      } else {
+        // Ask all the remote stripes at once, the first one answering in
+        // stripe order is used
+        std::vector<struct stat> stripe_buf(mStripe.size());
+        std::vector<int> stat_rc(mStripe.size(), SFS_ERROR);
+        auto stat_stripe = [&](unsigned int i) {
+          stat_rc[i] = mStripe[i]->fileStat(&stripe_buf[i], mTimeout);
+          return stat_rc[i];
+        };
+        (void) ForEachStripe(1, stat_stripe);
+
+        for (unsigned int i = 0; i < mStripe.size(); i++) {
+          if (!mStripe[i]) {
+            eos_warning("file %i could not be stat as it is NULL", i);
+          } else if (stat_rc[i] == SFS_OK) {
+            *buf = stripe_buf[i];
             found = true;
             break;
           }
-        } else {
-          eos_warning("file %i could not be stat as it is NULL", i);
         }
       }
     } else {
@@ -1396,17 +1585,17 @@ RaidMetaLayout::Close()
         }
 
         // Collect all the write responses and reset all the handlers
+        if (!WaitAsyncRequests()) {
+          eos_err("write failed in previous requests.");
+          rc = SFS_ERROR;
+        }
+
         for (unsigned int i = 0; i < mStripe.size(); i++) {
           if (mStripe[i]) {
             AsyncMetaHandler* phandler =
               static_cast<AsyncMetaHandler*>(mStripe[i]->fileGetAsyncHandler());
 
             if (phandler) {
-              if (phandler->WaitOK() != XrdCl::errNone) {
-                eos_err("write failed in previous requests.");
-                rc = SFS_ERROR;
-              }
-
               phandler->Reset();
             }
           }
@@ -1440,31 +1629,47 @@ RaidMetaLayout::Close()
           for (unsigned int i = 0; i < mStripe.size(); i++) {
             mHdrInfo[i]->SetIdStripe(mapPL[i]);
 
-            if (mStripe[i]) {
-              if (!mHdrInfo[i]->WriteToFile(mStripe[i], mTimeout)) {
-                eos_err("write header to file failed for stripe:%i", i);
-                rc =  SFS_ERROR;
-              }
-            } else {
+            if (!mStripe[i]) {
               eos_warning("could not write header info to NULL file.");
             }
           }
 
+          auto write_header = [this](unsigned int i) {
+            if (!mHdrInfo[i]->WriteToFile(mStripe[i], mTimeout)) {
+              eos_err("write header to file failed for stripe:%i", i);
+              return SFS_ERROR;
+            }
+
+            return SFS_OK;
+          };
+
+          if (ForEachStripe(0, write_header)) {
+            rc = SFS_ERROR;
+          }
+
           mUpdateHeader = false;
         }
       }
 
       // Close remote files
       for (unsigned int i = 1; i < mStripe.size(); i++) {
-        if (mStripe[i]) {
-          if (mStripe[i]->fileClose(mTimeout)) {
-            eos_err("error=failed to close remote file %i", i);
-            rc = SFS_ERROR;
-          }
-        } else {
+        if (!mStripe[i]) {
           eos_warning("remote stripe could not be closed as the file is NULL");
         }
       }
+
+      auto close_stripe = [this](unsigned int i) {
+        if (mStripe[i]->fileClose(mTimeout)) {
+          eos_err("error=failed to close remote file %i", i);
+          return SFS_ERROR;
+        }
+
+        return SFS_OK;
+      };
+
+      if (ForEachStripe(1, close_stripe)) {
+        rc = SFS_ERROR;
+      }
     }
 
     // Close local file
@@ -1491,20 +1696,65 @@ RaidMetaLayout::Close()
 int
 RaidMetaLayout::Fctl(const std::string& cmd, const XrdSecEntity* client)
 {
-  int retc = SFS_OK;
-
-  for (unsigned int i = 0; i < mStripe.size(); ++i) {
+  auto fctl_stripe = [&](unsigned int i) {
     eos_debug("Send cmd=\"%s\" to stripe %i", cmd.c_str(), i);
 
+    if (mStripe[i]->fileFctl(cmd, mTimeout)) {
+      eos_err("error while executing command \"%s\"", cmd.c_str());
+      return SFS_ERROR;
+    }
+
+    return SFS_OK;
+  };
+  return ForEachStripe(0, fctl_stripe);
+}
+
+//------------------------------------------------------------------------------
+// Run an operation on the stripe files in parallel
+//------------------------------------------------------------------------------
+int
+RaidMetaLayout::ForEachStripe(unsigned int first,
+                              const std::function<int(unsigned int)>& op)
+{
+  std::vector<unsigned int> stripes;
+
+  for (unsigned int i = first; i < mStripe.size(); ++i) {
     if (mStripe[i]) {
-      if (mStripe[i]->fileFctl(cmd, mTimeout)) {
-        eos_err("error while executing command \"%s\"", cmd.c_str());
-        retc = SFS_ERROR;
-      }
+      stripes.push_back(i);
     }
   }
 
-  return retc;
+  if (stripes.empty()) {
+    return SFS_OK;
+  }
+
+  std::vector<int> rc(stripes.size(), SFS_OK);
+  std::vector<std::thread> threads;
+
+  for (size_t i = 1; i < stripes.size(); ++i) {
+    try {
+      threads.emplace_back([&, i]() {
+        rc[i] = op(stripes[i]);
+      });
+    } catch (const std::system_error&) {
+      // No more threads, do it in the calling one
+      rc[i] = op(stripes[i]);
+    }
+  }
+
+  rc[0] = op(stripes[0]);
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (auto retc : rc) {
+    if (retc != SFS_OK) {
+      return SFS_ERROR;
+    }
+  }
+
+  return SFS_OK;
 }
 
 //------------------------------------------------------------------------------
@@ -28,13 +28,17 @@
 #include <vector>
 #include <string>
 #include <list>
+#include <functional>
+#include <memory>
 #include "fst/layout/Layout.hh"
+#include "fst/io/BufferPool.hh"
 
 class XrdFstOfsFile;
 
 EOSFSTNAMESPACE_BEGIN
 
  class HeaderCRC;
+ class StripeOpenTracker;
 
 //------------------------------------------------------------------------------
 //! Generic class to read/write different RAID-like layout files
@@ -111,6 +115,16 @@ public:
 
 
 
+  //----------------------------------------------------------------------------
+  //! Get the size of the data in a group, a read aligned to groups is served
+  //! by all the data stripes in parallel
+  //----------------------------------------------------------------------------
+  inline uint64_t
+  GetSizeGroup() const
+  {
+    return mSizeGroup;
+  }
+
   //----------------------------------------------------------------------------
   //! Read from file
   //!
@@ -296,9 +310,11 @@ protected:
   ///< computed the parity blocks
   uint64_t mSizeGroup; ///< size of a group of blocks
   ///< eg. RAIDDP: group = noDataStr^2 blocks
+  unsigned int mNbWriteGroups; ///< max number of groups written in parallel
 
   std::string mBookingOpaque; ///< opaque information
   std::vector<char*> mDataBlocks; ///< vector containing the data in a group
+  std::vector<BufferPool::Buffer> mDataBuffers; ///< leased memory of the blocks
   std::vector<FileIo*> mStripe; ///< file IO layout obj for each stripe
   std::vector<HeaderCRC*> mHdrInfo; ///< headers of the stripe files
   std::map<unsigned int, unsigned int> mapLP; ///< map of url to stripes
@@ -306,6 +322,9 @@ protected:
   std::map<uint64_t, uint32_t> mMapPieces; ///< map of pieces written for which
   ///< parity computation has not been done yet
   std::string mLastErrMsg; ///< last error messages ssen
+  //! Tracker of the stripe opens still in flight after an early completion
+  std::shared_ptr<StripeOpenTracker> mOpenTracker;
+  std::vector<FileIo*> mLateStripes; ///< stripes left behind by an early open
 
   //----------------------------------------------------------------------------
   //! Test and recover any corrupted headers in the stripe files
@@ -407,6 +426,37 @@ protected:
   bool SparseParityComputation(bool force);
 
 
+  //----------------------------------------------------------------------------
+  //! Limit the amount of data written asynchronously to each of the stripes
+  //! so that at most mNbWriteGroups groups are in flight
+  //----------------------------------------------------------------------------
+  void SetWriteWindow();
+
+
+  //----------------------------------------------------------------------------
+  //! Wait for all the asynchronous requests sent to the stripes
+  //!
+  //! @return true if all the requests were successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool WaitAsyncRequests();
+
+
+  //----------------------------------------------------------------------------
+  //! Run an operation on the stripe files in parallel, one thread per stripe
+  //! with the calling thread handling the first one. The NULL stripes are
+  //! skipped.
+  //!
+  //! @param first index of the first stripe the operation is run on
+  //! @param op operation taking the stripe index and returning SFS_OK or
+  //!        SFS_ERROR
+  //!
+  //! @return SFS_OK if the operation was successful on all the stripes,
+  //!         otherwise SFS_ERROR
+  //----------------------------------------------------------------------------
+  int ForEachStripe(unsigned int first,
+                    const std::function<int(unsigned int)>& op);
+
+
 
 private:
 
@@ -25,7 +25,10 @@
 #include <map>
 #include <set>
 #include <algorithm>
+#include <functional>
+#include <mutex>
 #include "common/Timing.hh"
+#include "common/ThreadPool.hh"
 #include "fst/layout/ReedSLayout.hh"
 #include "fst/io/AsyncMetaHandler.hh"
 #include "fst/layout/jerasure/include/jerasure.h"
@@ -36,6 +39,46 @@
 
 EOSFSTNAMESPACE_BEGIN
 
+//! Minimum number of bytes per stripe handled by one coding task
+static constexpr size_t sMinCodingChunk = 64 * 1024;
+
+//------------------------------------------------------------------------------
+// Get number of threads used for parity computation and recovery - can be
+// overwritten using the EOS_FST_RAIN_CODING_THREADS env variable, 1 disables
+// the parallel coding.
+//------------------------------------------------------------------------------
+static unsigned int
+GetNumCodingThreads()
+{
+  static unsigned int num_threads = []() {
+    unsigned int num = std::min(4u, std::thread::hardware_concurrency());
+
+    if (getenv("EOS_FST_RAIN_CODING_THREADS")) {
+      try {
+        num = std::stoul(getenv("EOS_FST_RAIN_CODING_THREADS"));
+      } catch (...) {
+        // keep the default value
+      }
+    }
+
+    return (num ? num : 1);
+  }();
+  return num_threads;
+}
+
+//------------------------------------------------------------------------------
+// Get thread pool shared by all the Reed-Solomon files for the coding tasks,
+// the calling thread always handles one of the chunks itself.
+//------------------------------------------------------------------------------
+static eos::common::ThreadPool&
+GetCodingThreadPool()
+{
+  static eos::common::ThreadPool pool(GetNumCodingThreads() - 1,
+                                      GetNumCodingThreads() - 1,
+                                      10, 12, 10, "rain_coding");
+  return pool;
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -51,7 +94,8 @@ ReedSLayout::ReedSLayout(XrdFstOfsFile* file,
   RaidMetaLayout(file, lid, client, outError, path, timeout,
                  storeRecovery, targetSize, bookingOpaque),
   mDoneInitialisation(false),
-  mPacketSize(0), matrix(0), bitmatrix(0), schedule(0)
+  mPacketSize(0), matrix(0), bitmatrix(0), schedule(0),
+  mMaxRecoveredGroups(4)
 {
   mNbDataBlocks = mNbDataFiles;
   mNbTotalBlocks = mNbDataFiles + mNbParityFiles;
@@ -59,6 +103,14 @@ ReedSLayout::ReedSLayout(XrdFstOfsFile* file,
   mSizeLine = mSizeGroup;
   // Set the parameters for the Jerasure codes
   w = 8;      // "word size" this can be adjusted between 4..32
+
+  if (getenv("EOS_FST_RAIN_RECOVERY_GROUPS")) {
+    try {
+      mMaxRecoveredGroups = std::stoul(getenv("EOS_FST_RAIN_RECOVERY_GROUPS"));
+    } catch (...) {
+      // keep the default value
+    }
+  }
 }
 
 
@@ -77,6 +129,20 @@ ReedSLayout::~ReedSLayout()
 bool
 ReedSLayout::InitialiseJerasure()
 {
+  // The Galois fields are created lazily by Jerasure, make sure this happens
+  // only once before any concurrent coding
+  static std::once_flag galois_flag;
+  static bool galois_ok = false;
+  std::call_once(galois_flag, [this]() {
+    galois_ok = ((galois_init_default_field(w) == 0) &&
+                 (galois_init_default_field(32) == 0));
+  });
+
+  if (!galois_ok) {
+    eos_err("failed to initialise the Galois fields");
+    return false;
+  }
+
   mPacketSize = mSizeLine / (mNbDataBlocks * w * sizeof(int));
   eos_debug("mStripeWidth=%zu, mSizeLine=%zu, mNbDataBlocks=%u, mNbParityFiles=%u,"
             " w=%u, mPacketSize=%u", mStripeWidth, mSizeLine, mNbDataBlocks,
@@ -126,9 +192,78 @@ ReedSLayout::ComputeParity()
   }
 
   // Encode the blocks
-  jerasure_schedule_encode(mNbDataBlocks, mNbParityFiles, w, schedule, data,
-                           coding, mStripeWidth, mPacketSize);
-  return true;
+  return RunCoding(data, coding, mStripeWidth,
+  [&](char** pdata, char** pcoding, int len) {
+    jerasure_schedule_encode(mNbDataBlocks, mNbParityFiles, w, schedule, pdata,
+                             pcoding, len, mPacketSize);
+    return 0;
+  });
+}
+
+
+//------------------------------------------------------------------------------
+// Run coding operation over the current group split in chunks handled in
+// parallel
+//------------------------------------------------------------------------------
+bool
+ReedSLayout::RunCoding(char** data, char** coding, uint64_t length,
+                       const std::function<int(char**, char**, int)>& op)
+{
+  // Jerasure processes the stripes in units of w * mPacketSize bytes and
+  // the same operations are applied to every unit, therefore the units can
+  // be handled independently.
+  const size_t unit_sz = w * mPacketSize;
+  size_t num_units = length / unit_sz;
+  size_t num_chunks = std::min((size_t) GetNumCodingThreads(), num_units);
+  num_chunks = std::min(num_chunks, (size_t)(length / sMinCodingChunk));
+
+  if (num_chunks <= 1) {
+    return (op(data, coding, length) != -1);
+  }
+
+  // Build the offset pointers for each of the chunks
+  size_t units_per_chunk = (num_units + num_chunks - 1) / num_chunks;
+  std::vector<std::vector<char*>> chunk_ptrs;
+  std::vector<std::pair<size_t, size_t>> chunk_span;
+
+  for (size_t unit = 0; unit < num_units; unit += units_per_chunk) {
+    size_t off = unit * unit_sz;
+    size_t len = std::min(units_per_chunk, num_units - unit) * unit_sz;
+    std::vector<char*> ptrs;
+
+    for (unsigned int i = 0; i < mNbDataFiles; ++i) {
+      ptrs.push_back(data[i] + off);
+    }
+
+    for (unsigned int i = 0; i < mNbParityFiles; ++i) {
+      ptrs.push_back(coding[i] + off);
+    }
+
+    chunk_ptrs.push_back(std::move(ptrs));
+    chunk_span.emplace_back(off, len);
+  }
+
+  std::vector<std::future<int>> futures;
+
+  for (size_t i = 1; i < chunk_ptrs.size(); ++i) {
+    std::vector<char*>& ptrs = chunk_ptrs[i];
+    int len = (int) chunk_span[i].second;
+    futures.emplace_back(GetCodingThreadPool().PushTask<int>(
+    [&op, &ptrs, len, this]() {
+      return op(ptrs.data(), ptrs.data() + mNbDataFiles, len);
+    }));
+  }
+
+  bool done = (op(chunk_ptrs[0].data(), chunk_ptrs[0].data() + mNbDataFiles,
+                  (int) chunk_span[0].second) != -1);
+
+  for (auto& fut : futures) {
+    if (fut.get() == -1) {
+      done = false;
+    }
+  }
+
+  return done;
 }
 
 
@@ -149,9 +284,13 @@ ReedSLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
     mDoneInitialisation = true;
   }
 
+  // Read-only access reconstructs only the requested parts of the group
+  if (!mStoreRecovery && !mIsRw) {
+    return RecoverRangeInGroup(grp_errs);
+  }
+
   // Obs: RecoverPiecesInGroup also checks the parity blocks
   bool ret = true;
-  int64_t nread = 0;
   int64_t nwrite = 0;
   unsigned int physical_id;
   // Use "set" as we might add the same stripe index twice as a result of an early
@@ -162,58 +301,7 @@ ReedSLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
   uint64_t offset_group = (offset / mSizeGroup) * mSizeGroup;
   AsyncMetaHandler* phandler = 0;
   offset_local += mSizeHeader;
-
-  for (unsigned int i = 0; i < mNbTotalFiles; i++) {
-    physical_id = mapLP[i];
-
-    // Read data from stripe
-    if (mStripe[physical_id]) {
-      phandler = static_cast<AsyncMetaHandler*>
-                 (mStripe[physical_id]->fileGetAsyncHandler());
-
-      if (phandler) {
-        phandler->Reset();
-      }
-
-      // Enable readahead
-      nread = mStripe[physical_id]->fileReadAsync(offset_local, mDataBlocks[i],
-              mStripeWidth, true, mTimeout);
-
-      if (nread != (int64_t)mStripeWidth) {
-        eos_err("read block corrupted stripe=%u.", i);
-        invalid_ids.insert(i);
-      }
-    } else {
-      // File not opened, register it as an error
-      invalid_ids.insert(i);
-    }
-  }
-
-  // Wait for read responses and mark corrupted blocks
-  for (unsigned int i = 0; i < mStripe.size(); i++) {
-    physical_id = mapLP[i];
-
-    if (mStripe[physical_id]) {
-      phandler = static_cast<AsyncMetaHandler*>
-                 (mStripe[physical_id]->fileGetAsyncHandler());
-
-      if (phandler) {
-        uint16_t error_type = phandler->WaitOK();
-
-        if (error_type != XrdCl::errNone) {
-          std::pair< uint16_t, std::map<uint64_t, uint32_t> > pair_err;
-          eos_err("remote block corrupted id=%u", i);
-          invalid_ids.insert(i);
-
-          if (error_type == XrdCl::errOperationExpired) {
-            mStripe[physical_id]->fileClose(mTimeout);
-            delete mStripe[physical_id];
-            mStripe[physical_id] = NULL;
-          }
-        }
-      }
-    }
-  }
+  ReadStripes(offset_local, mStripeWidth, mDataBlocks.data(), invalid_ids);
 
   if (invalid_ids.size() == 0) {
     return true;
@@ -245,13 +333,16 @@ ReedSLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
 
   erasures[invalid_ids.size()] = -1;
   // ******* DECODE ******
-  int decode = jerasure_schedule_decode_lazy(mNbDataBlocks, mNbParityFiles, w,
-               bitmatrix, erasures, data, coding,
-               mStripeWidth, mPacketSize, 1);
+  bool decode = RunCoding(data, coding, mStripeWidth,
+  [&](char** pdata, char** pcoding, int len) {
+    return jerasure_schedule_decode_lazy(mNbDataBlocks, mNbParityFiles, w,
+                                         bitmatrix, erasures, pdata, pcoding,
+                                         len, mPacketSize, 1);
+  });
   // Free memory
   delete[] erasures;
 
-  if (decode == -1) {
+  if (!decode) {
     eos_err("decoding was unsuccessful");
     return false;
   }
@@ -330,6 +421,208 @@ ReedSLayout::RecoverPiecesInGroup(XrdCl::ChunkList& grp_errs)
 }
 
 
+//------------------------------------------------------------------------------
+// Read the same range from all the stripes of a group in parallel
+//------------------------------------------------------------------------------
+void
+ReedSLayout::ReadStripes(uint64_t offset_local, uint64_t length,
+                         char** buffers, std::set<unsigned int>& invalid_ids)
+{
+  int64_t nread = 0;
+  unsigned int physical_id;
+  AsyncMetaHandler* phandler = 0;
+
+  for (unsigned int i = 0; i < mNbTotalFiles; i++) {
+    physical_id = mapLP[i];
+
+    // Read data from stripe
+    if (mStripe[physical_id]) {
+      phandler = static_cast<AsyncMetaHandler*>
+                 (mStripe[physical_id]->fileGetAsyncHandler());
+
+      if (phandler) {
+        phandler->Reset();
+      }
+
+      // Enable readahead
+      nread = mStripe[physical_id]->fileReadAsync(offset_local, buffers[i],
+              length, true, mTimeout);
+
+      if (nread != (int64_t)length) {
+        eos_err("read block corrupted stripe=%u.", i);
+        invalid_ids.insert(i);
+      }
+    } else {
+      // File not opened, register it as an error
+      invalid_ids.insert(i);
+    }
+  }
+
+  // Wait for read responses and mark corrupted blocks
+  for (unsigned int i = 0; i < mStripe.size(); i++) {
+    physical_id = mapLP[i];
+
+    if (mStripe[physical_id]) {
+      phandler = static_cast<AsyncMetaHandler*>
+                 (mStripe[physical_id]->fileGetAsyncHandler());
+
+      if (phandler) {
+        uint16_t error_type = phandler->WaitOK();
+
+        if (error_type != XrdCl::errNone) {
+          eos_err("remote block corrupted id=%u", i);
+          invalid_ids.insert(i);
+
+          if (error_type == XrdCl::errOperationExpired) {
+            mStripe[physical_id]->fileClose(mTimeout);
+            delete mStripe[physical_id];
+            mStripe[physical_id] = NULL;
+          }
+        }
+      }
+    }
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// Get reconstructed group from the LRU or add a new empty one
+//------------------------------------------------------------------------------
+ReedSLayout::RecoveredGroup&
+ReedSLayout::GetRecoveredGroup(uint64_t offset_group)
+{
+  for (auto it = mRecoveredGroups.begin(); it != mRecoveredGroups.end(); ++it) {
+    if (it->mOffset == offset_group) {
+      mRecoveredGroups.splice(mRecoveredGroups.begin(), mRecoveredGroups, it);
+      return mRecoveredGroups.front();
+    }
+  }
+
+  // Reuse the buffer of the least recently used group if the LRU is full
+  RecoveredGroup grp;
+
+  if (!mRecoveredGroups.empty() &&
+      (mRecoveredGroups.size() >= std::max(mMaxRecoveredGroups, 1u))) {
+    grp = std::move(mRecoveredGroups.back());
+    mRecoveredGroups.pop_back();
+  } else {
+    grp.mData = BufferPool::GetInstance().Get(mNbDataFiles * mStripeWidth);
+  }
+
+  grp.mOffset = offset_group;
+  grp.mValid.assign(mStripeWidth / (w * mPacketSize), false);
+  mRecoveredGroups.push_front(std::move(grp));
+  return mRecoveredGroups.front();
+}
+
+
+//------------------------------------------------------------------------------
+// Recover corrupted chunks of a group by reconstructing only the units of the
+// stripes covered by the chunks
+//------------------------------------------------------------------------------
+bool
+ReedSLayout::RecoverRangeInGroup(XrdCl::ChunkList& grp_errs)
+{
+  const uint64_t unit_sz = w * mPacketSize;
+  const uint64_t num_units = mStripeWidth / unit_sz;
+  uint64_t offset_group = (grp_errs.begin()->offset / mSizeGroup) * mSizeGroup;
+  uint64_t first_unit = num_units;
+  uint64_t last_unit = 0;
+
+  // Find the units covered by the chunks to be recovered
+  for (auto chunk = grp_errs.begin(); chunk != grp_errs.end(); ++chunk) {
+    if (chunk->length == 0) {
+      continue;
+    }
+
+    uint64_t off_stripe = (chunk->offset - offset_group) % mStripeWidth;
+    uint64_t end_stripe = std::min(off_stripe + chunk->length, mStripeWidth);
+    first_unit = std::min(first_unit, off_stripe / unit_sz);
+    last_unit = std::max(last_unit, (end_stripe - 1) / unit_sz);
+  }
+
+  if (first_unit == num_units) {
+    return true;
+  }
+
+  RecoveredGroup& grp = GetRecoveredGroup(offset_group);
+
+  // Decode only the units which are not already available
+  while ((first_unit <= last_unit) && grp.mValid[first_unit]) {
+    ++first_unit;
+  }
+
+  while ((last_unit > first_unit) && grp.mValid[last_unit]) {
+    --last_unit;
+  }
+
+  if (first_unit <= last_unit) {
+    uint64_t off_unit = first_unit * unit_sz;
+    uint64_t length = (last_unit - first_unit + 1) * unit_sz;
+    uint64_t offset_local = (offset_group / mSizeGroup) * mStripeWidth +
+                            mSizeHeader + off_unit;
+    std::set<unsigned int> invalid_ids;
+    char* buffers[mNbTotalFiles];
+
+    // Data is read directly into the group, parity into the data blocks
+    for (unsigned int i = 0; i < mNbTotalFiles; ++i) {
+      if (i < mNbDataFiles) {
+        buffers[i] = grp.mData.GetDataPtr() + i * mStripeWidth + off_unit;
+      } else {
+        buffers[i] = mDataBlocks[i] + off_unit;
+      }
+    }
+
+    ReadStripes(offset_local, length, buffers, invalid_ids);
+
+    if (invalid_ids.size() > mNbParityFiles) {
+      eos_err("more blocks corrupted than the maximum number supported");
+      mRecoveredGroups.pop_front();
+      return false;
+    }
+
+    if (!invalid_ids.empty()) {
+      int erasures[invalid_ids.size() + 1];
+      int index = 0;
+
+      for (auto iter = invalid_ids.begin(); iter != invalid_ids.end();
+           ++iter, ++index) {
+        erasures[index] = *iter;
+      }
+
+      erasures[invalid_ids.size()] = -1;
+      bool decode = RunCoding(buffers, buffers + mNbDataFiles, length,
+      [&](char** pdata, char** pcoding, int len) {
+        return jerasure_schedule_decode_lazy(mNbDataBlocks, mNbParityFiles, w,
+                                             bitmatrix, erasures, pdata,
+                                             pcoding, len, mPacketSize, 1);
+      });
+
+      if (!decode) {
+        eos_err("decoding was unsuccessful");
+        mRecoveredGroups.pop_front();
+        return false;
+      }
+    }
+
+    for (uint64_t unit = first_unit; unit <= last_unit; ++unit) {
+      grp.mValid[unit] = true;
+    }
+  }
+
+  // Copy the recovered data to the reading buffers
+  for (auto chunk = grp_errs.begin(); chunk != grp_errs.end(); ++chunk) {
+    uint64_t off_grp = chunk->offset - offset_group;
+    chunk->buffer = static_cast<char*>(memcpy(chunk->buffer,
+                                       grp.mData.GetDataPtr() + off_grp,
+                                       chunk->length));
+  }
+
+  mDoneRecovery = true;
+  return true;
+}
+
+
 //------------------------------------------------------------------------------
 // Writing a file in streaming mode
 // Add a new data used to compute parity block
@@ -445,16 +738,21 @@ ReedSLayout::Truncate(XrdSfsFileOffset offset)
       truncate_offset = offset;
     }
 
-    for (unsigned int i = 1; i < mStripe.size(); i++) {
+    // Truncate all the remote stripes at once
+    auto truncate_stripe = [&](unsigned int i) {
       eos_debug("Truncate stripe %i, to file_offset=%lli, stripe_offset=%zu",
                 i, offset, truncate_offset);
 
-      if (mStripe[i]) {
-        if (mStripe[i]->fileTruncate(truncate_offset, mTimeout)) {
-          eos_err("error while truncating");
-          return SFS_ERROR;
-        }
+      if (mStripe[i]->fileTruncate(truncate_offset, mTimeout)) {
+        eos_err("error while truncating");
+        return SFS_ERROR;
       }
+
+      return SFS_OK;
+    };
+
+    if (ForEachStripe(1, truncate_stripe)) {
+      return SFS_ERROR;
     }
   }
 
@@ -27,6 +27,10 @@
 
 /*----------------------------------------------------------------------------*/
 #include "fst/layout/RaidMetaLayout.hh"
+#include <functional>
+#include <list>
+#include <memory>
+#include <set>
 /*----------------------------------------------------------------------------*/
 
 EOSFSTNAMESPACE_BEGIN
@@ -113,6 +117,20 @@ private:
   int* bitmatrix;
   int** schedule;
 
+  //----------------------------------------------------------------------------
+  //! Data of a group reconstructed from the surviving stripes when reading in
+  //! degraded mode. Only the units marked as valid hold recovered data.
+  //----------------------------------------------------------------------------
+  struct RecoveredGroup {
+    uint64_t mOffset; ///< offset of the group in the file
+    BufferPool::Buffer mData; ///< data blocks of the group
+    std::vector<bool> mValid; ///< units of the data blocks which are valid
+  };
+
+  //! LRU of reconstructed groups with the most recently used one first
+  std::list<RecoveredGroup> mRecoveredGroups;
+  unsigned int mMaxRecoveredGroups; ///< max number of cached groups
+
 
   //----------------------------------------------------------------------------
   //! Initialise the Jerasure structures used for encoding and decoding
@@ -123,6 +141,59 @@ private:
   bool InitialiseJerasure();
 
 
+  //----------------------------------------------------------------------------
+  //! Run a Jerasure coding operation over the current group. The stripes are
+  //! split in chunks which are processed in parallel by the coding thread
+  //! pool and the calling thread.
+  //!
+  //! @param data pointers to the data blocks
+  //! @param coding pointers to the parity blocks
+  //! @param op coding operation receiving the data and parity pointers of
+  //!        a chunk and its length, returns -1 in case of error
+  //!
+  //! @return true if all chunks were successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool RunCoding(char** data, char** coding, uint64_t length,
+                 const std::function<int(char**, char**, int)>& op);
+
+
+  //----------------------------------------------------------------------------
+  //! Read the same range from all the stripes of a group in parallel
+  //!
+  //! @param offset_local offset in the stripe files including the header
+  //! @param length length to read from each stripe
+  //! @param buffers destination buffer for each of the logical stripes
+  //! @param invalid_ids collects the logical stripes which failed
+  //----------------------------------------------------------------------------
+  void ReadStripes(uint64_t offset_local, uint64_t length, char** buffers,
+                   std::set<unsigned int>& invalid_ids);
+
+
+  //----------------------------------------------------------------------------
+  //! Recover corrupted chunks of a group by reconstructing only the units of
+  //! the stripes covered by the chunks. Jerasure encodes each unit of
+  //! w * mPacketSize bytes independently hence this is the smallest piece
+  //! that can be decoded. Reconstructed units are kept in the LRU of groups
+  //! and reused by subsequent reads.
+  //!
+  //! @param grp_errs chunks to be recovered, all in the same group
+  //!
+  //! @return true if recovery successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool RecoverRangeInGroup(XrdCl::ChunkList& grp_errs);
+
+
+  //----------------------------------------------------------------------------
+  //! Get reconstructed group from the LRU or add a new empty one, evicting
+  //! the least recently used group if the LRU is full
+  //!
+  //! @param offset_group offset of the group
+  //!
+  //! @return group object
+  //----------------------------------------------------------------------------
+  RecoveredGroup& GetRecoveredGroup(uint64_t offset_group);
+
+
   //----------------------------------------------------------------------------
   //! Check if a number is prime
   //!
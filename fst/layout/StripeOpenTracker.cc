@@ -0,0 +1,144 @@
+// ----------------------------------------------------------------------
+// File: StripeOpenTracker.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/layout/StripeOpenTracker.hh"
+
+EOSFSTNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+//! Handler reporting the open response of one stripe to the tracker
+//------------------------------------------------------------------------------
+class StripeOpenHandler: public XrdCl::ResponseHandler
+{
+public:
+  StripeOpenHandler(std::shared_ptr<StripeOpenTracker> tracker,
+                    unsigned int stripe):
+    mTracker(tracker), mStripe(stripe) {}
+
+  virtual ~StripeOpenHandler() {}
+
+  virtual void HandleResponseWithHosts(XrdCl::XRootDStatus* status,
+                                       XrdCl::AnyObject* response,
+                                       XrdCl::HostList* hostList)
+  {
+    bool ok = (status && status->IsOK());
+    delete status;
+    delete response;
+    delete hostList;
+    mTracker->Done(mStripe, ok);
+    delete this;
+  }
+
+private:
+  std::shared_ptr<StripeOpenTracker> mTracker; ///< tracker of the opens
+  unsigned int mStripe; ///< stripe index
+};
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StripeOpenTracker::StripeOpenTracker(size_t num_stripes):
+  mStates(num_stripes, State::kNone), mNumPending(0), mNumOk(0)
+{}
+
+//------------------------------------------------------------------------------
+// Get a handler reporting the open response of a stripe
+//------------------------------------------------------------------------------
+XrdCl::ResponseHandler*
+StripeOpenTracker::GetHandler(unsigned int stripe)
+{
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mStates[stripe] != State::kPending) {
+      mStates[stripe] = State::kPending;
+      ++mNumPending;
+    }
+  }
+  return new StripeOpenHandler(shared_from_this(), stripe);
+}
+
+//------------------------------------------------------------------------------
+// Record the outcome of the open of a stripe
+//------------------------------------------------------------------------------
+void
+StripeOpenTracker::Done(unsigned int stripe, bool ok)
+{
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mStates[stripe] == State::kPending) {
+      --mNumPending;
+    }
+
+    mStates[stripe] = (ok ? State::kOk : State::kFailed);
+
+    if (ok) {
+      ++mNumOk;
+    }
+  }
+  mCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Wait for the responses of the pending opens
+//------------------------------------------------------------------------------
+bool
+StripeOpenTracker::Wait(size_t min_ok, std::chrono::milliseconds grace)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  bool early = false;
+  std::chrono::steady_clock::time_point deadline;
+
+  while (mNumPending) {
+    if (min_ok && (mNumOk >= min_ok)) {
+      // The grace period starts once enough stripes are open
+      if (!early) {
+        early = true;
+        deadline = std::chrono::steady_clock::now() + grace;
+      }
+
+      if (mCv.wait_until(lock, deadline) == std::cv_status::timeout) {
+        break;
+      }
+    } else {
+      mCv.wait(lock);
+    }
+  }
+
+  return (mNumPending == 0);
+}
+
+//------------------------------------------------------------------------------
+// Get the state of the open of a stripe
+//------------------------------------------------------------------------------
+StripeOpenTracker::State
+StripeOpenTracker::GetState(unsigned int stripe)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mStates[stripe];
+}
+
+EOSFSTNAMESPACE_END
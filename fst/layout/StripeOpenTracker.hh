@@ -0,0 +1,111 @@
+// ----------------------------------------------------------------------
+// File: StripeOpenTracker.hh
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_STRIPEOPENTRACKER_HH__
+#define __EOSFST_STRIPEOPENTRACKER_HH__
+
+#include "fst/Namespace.hh"
+#include "XrdCl/XrdClXRootDResponses.hh"
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class StripeOpenTracker - collects the responses of the asynchronous opens
+//! sent to the stripes of a RAIN file. The tracker is shared with the
+//! response handlers so that a stripe left behind by an early completion can
+//! still report its response once the open has moved on.
+//------------------------------------------------------------------------------
+class StripeOpenTracker:
+  public std::enable_shared_from_this<StripeOpenTracker>
+{
+public:
+  //----------------------------------------------------------------------------
+  //! State of the open of a stripe
+  //----------------------------------------------------------------------------
+  enum class State {
+    kNone, ///< no open sent
+    kPending, ///< open sent, no response yet
+    kOk, ///< open successful
+    kFailed ///< open failed
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param num_stripes number of stripes
+  //----------------------------------------------------------------------------
+  explicit StripeOpenTracker(size_t num_stripes);
+
+  //----------------------------------------------------------------------------
+  //! Get a handler reporting the open response of a stripe, the stripe is
+  //! marked as pending. The handler deletes itself once the response is
+  //! handled, it has to be deleted by the caller if the open fails to be
+  //! sent.
+  //!
+  //! @param stripe stripe index
+  //!
+  //! @return response handler
+  //----------------------------------------------------------------------------
+  XrdCl::ResponseHandler* GetHandler(unsigned int stripe);
+
+  //----------------------------------------------------------------------------
+  //! Record the outcome of the open of a stripe
+  //!
+  //! @param stripe stripe index
+  //! @param ok true if the open was successful
+  //----------------------------------------------------------------------------
+  void Done(unsigned int stripe, bool ok);
+
+  //----------------------------------------------------------------------------
+  //! Wait for the responses of the pending opens. Once min_ok opens are
+  //! successful the remaining ones are waited for at most grace.
+  //!
+  //! @param min_ok number of successful opens enough to complete early, 0
+  //!        waits for all the responses
+  //! @param grace time to wait for the remaining responses
+  //!
+  //! @return true if all the responses arrived, false if some opens are still
+  //!         pending
+  //----------------------------------------------------------------------------
+  bool Wait(size_t min_ok, std::chrono::milliseconds grace);
+
+  //----------------------------------------------------------------------------
+  //! Get the state of the open of a stripe
+  //----------------------------------------------------------------------------
+  State GetState(unsigned int stripe);
+
+private:
+  std::mutex mMutex; ///< protects the members below
+  std::condition_variable mCv; ///< signalled on every response
+  std::vector<State> mStates; ///< open state per stripe
+  size_t mNumPending; ///< number of opens waiting for their response
+  size_t mNumOk; ///< number of successful opens
+};
+
+EOSFSTNAMESPACE_END
+
+#endif // __EOSFST_STRIPEOPENTRACKER_HH__
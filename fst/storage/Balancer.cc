@@ -26,6 +26,7 @@
 #include "fst/txqueue/TransferJob.hh"
 #include "fst/txqueue/TransferQueue.hh"
 #include "fst/storage/FileSystem.hh"
+#include <algorithm>
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -237,19 +238,20 @@ Storage::GetFileSystemInBalanceMode(std::vector<unsigned int>& balancefsvector,
 }
 
 /*----------------------------------------------------------------------------*/
-bool
-Storage::GetBalanceJob(unsigned int index)
+unsigned long long
+Storage::GetBalanceJob(unsigned long id, unsigned long long freebytes,
+                       unsigned long long njobs, int wait_sec)
 /*----------------------------------------------------------------------------*/
 /**
- * @brief get a balance job for the filesystem in the filesystem vector with index
- * @param index index in the filesystem vector
- * @return true if scheduled otherwise false
+ * @brief get a batch of balance jobs for a filesystem
+ * @param id filesystem id
+ * @param freebytes free bytes of the filesystem
+ * @param njobs max number of jobs to get
+ * @param wait_sec seconds the manager waits for a job if none is available
+ * @return number of jobs scheduled
  */
 /*----------------------------------------------------------------------------*/
 {
-  unsigned long long freebytes =
-    mFsVect[index]->GetLongLong("stat.statfs.freebytes");
-  unsigned long id = mFsVect[index]->GetId();
   XrdOucErrInfo error;
   XrdOucString managerQuery = "/?";
   managerQuery += "mgm.pcmd=schedule2balance";
@@ -261,28 +263,40 @@ Storage::GetBalanceJob(unsigned int index)
   char sfree[1024];
   snprintf(sfree, sizeof(sfree) - 1, "%llu", freebytes);
   managerQuery += sfree;
+  managerQuery += "&mgm.njobs=";
+  managerQuery += std::to_string(njobs).c_str();
+  managerQuery += "&mgm.wait=";
+  managerQuery += wait_sec;
   managerQuery += "&mgm.logid=";
   managerQuery += logId;
   XrdOucString response = "";
+  // A long-polling request must not time out before the manager answers
   int rc = gOFS.CallManager(&error,
                             "/",
                             0,
                             managerQuery,
-                            &response);
+                            &response,
+                            wait_sec ? wait_sec + kSchedulingTimeoutSec : 0);
 
   if (rc) {
     eos_static_err("manager returned errno=%d for schedule2balance on fsid=%u",
                    rc, id);
   } else {
+    // Managers without batching answer with a single job
     if (response == "submitted") {
       eos_static_info("msg=\"new transfer job\" fsid=%u", id);
-      return true;
+      return 1;
+    } else if (response.beginswith("submitted:")) {
+      unsigned long long nsubmitted = strtoull(response.c_str() + 10, 0, 10);
+      eos_static_info("msg=\"new transfer jobs\" fsid=%u njobs=%llu", id,
+                      nsubmitted);
+      return nsubmitted;
     } else {
       eos_static_debug("manager returned no file to schedule [ENODATA]");
     }
   }
 
-  return false;
+  return 0;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -345,20 +359,20 @@ Storage::Balancer()
 
     // -------------------------------------------------------------------------
     // -- 2 --
-    // wait that balance slots are free
+    // wait that balance slots are free, the queue holds up to
+    // kSchedulingQueueFactor jobs per slot so that no slot sits idle between
+    // two requests to the manager
     // -------------------------------------------------------------------------
-    nscheduled = WaitFreeBalanceSlot(nparalleltx, totalscheduled, totalexecuted);
+    unsigned long long queuedepth = kSchedulingQueueFactor * nparalleltx;
+    nscheduled = WaitFreeBalanceSlot(queuedepth, totalscheduled, totalexecuted);
     // -------------------------------------------------------------------------
     // -- 3 --
     // get the filesystems which are in balance mode and get their configuration
-    // exclude filesystems which couldn't be scheduled for 1 minute
     // -------------------------------------------------------------------------
     std::vector<unsigned int> balancefsindex;
-    std::vector<bool> balancefsindexSchedulingFailed;
-    std::map<unsigned int, time_t> balancefsindexSchedulingTime;
-    // ************************************************************************>
-    // read lock the file system vector from now on
+    std::vector<std::pair<unsigned long, unsigned long long>> balancefs;
     {
+      // The manager requests run without the lock of the filesystem vector
       eos::common::RWMutexReadLock lock(mFsMutex);
 
       if (!GetFileSystemInBalanceMode(balancefsindex,
@@ -372,63 +386,70 @@ Storage::Balancer()
         noBalancer = false;
       }
 
-      balancefsindexSchedulingFailed.resize(balancefsindex.size());
-      // -------------------------------------------------------------------------
-      // -- 4 --
-      // cycle over all filesystems until all slots are filled or
-      // none can schedule anymore
-      // -------------------------------------------------------------------------
-      size_t slotstofill = ((nparalleltx - nscheduled) > 0) ?
-                           (nparalleltx - nscheduled) : 0;
-      bool stillGotOneScheduled;
-
-      if (slotstofill) {
-        do {
-          stillGotOneScheduled = false;
-
-          for (size_t i = 0; i < balancefsindex.size(); i++) {
-            // ---------------------------------------------------------------------
-            // skip indices where we know we couldn't schedule
-            // ---------------------------------------------------------------------
-            if (balancefsindexSchedulingFailed[i]) {
-              continue;
-            }
-
-            // ---------------------------------------------------------------------
-            // skip filesystems where the scheduling has been blocked for some time
-            // ---------------------------------------------------------------------
-            if ((balancefsindexSchedulingTime.count(balancefsindex[i])) &&
-                (balancefsindexSchedulingTime[balancefsindex[i]] > time(NULL))) {
-              continue;
-            }
-
-            // ---------------------------------------------------------------------
-            // try to get a balancejob for the indexed filesystem
-            // ---------------------------------------------------------------------
-            if (GetBalanceJob(balancefsindex[i])) {
-              balancefsindexSchedulingTime[balancefsindex[i]] = 0;
-              totalscheduled++;
-              stillGotOneScheduled = true;
-              slotstofill--;
-            } else {
-              balancefsindexSchedulingFailed[i] = true;
-              balancefsindexSchedulingTime[balancefsindex[i]] = time(NULL) + 60;
-            }
-
-            // we stop if we have all slots full
-            if (!slotstofill) {
-              break;
-            }
-          }
-        } while (slotstofill && stillGotOneScheduled);
-
-        // reset the failed vector, otherwise we starveforever
-        for (size_t i = 0; i < balancefsindex.size(); i++) {
-          balancefsindexSchedulingFailed[i] = false;
+      for (auto index : balancefsindex) {
+        balancefs.emplace_back(mFsVect[index]->GetId(),
+                               mFsVect[index]->
+                               GetLongLong("stat.statfs.freebytes"));
+      }
+    }
+    // -------------------------------------------------------------------------
+    // -- 4 --
+    // cycle over all filesystems until all slots are filled or none can
+    // schedule anymore, each request asks for a batch of jobs
+    // -------------------------------------------------------------------------
+    unsigned long long slotstofill = queuedepth - nscheduled;
+    std::vector<bool> balancefsSchedulingFailed(balancefs.size(), false);
+    bool stillGotOneScheduled;
+
+    do {
+      stillGotOneScheduled = false;
+      size_t nactive = std::count(balancefsSchedulingFailed.begin(),
+                                  balancefsSchedulingFailed.end(), false);
+
+      if (!nactive) {
+        break;
+      }
+
+      for (size_t i = 0; (i < balancefs.size()) && slotstofill; i++) {
+        // skip filesystems where we know we couldn't schedule
+        if (balancefsSchedulingFailed[i]) {
+          continue;
+        }
+
+        // share the free slots between the filesystems still scheduling
+        unsigned long long njobs = std::max(slotstofill / nactive, 1ull);
+        unsigned long long ngot = GetBalanceJob(balancefs[i].first,
+                                                balancefs[i].second, njobs, 0);
+        ngot = std::min(ngot, slotstofill);
+        totalscheduled += ngot;
+        slotstofill -= ngot;
+
+        if (ngot) {
+          stillGotOneScheduled = true;
+        }
+
+        if (ngot < njobs) {
+          balancefsSchedulingFailed[i] = true;
         }
       }
+    } while (slotstofill && stillGotOneScheduled);
+
+    // -------------------------------------------------------------------------
+    // -- 5 --
+    // if there is no work at all, wait in the manager until a job for the
+    // first filesystem of the cycle is available instead of polling
+    // -------------------------------------------------------------------------
+    if (!nscheduled && (slotstofill == queuedepth)) {
+      unsigned long long ngot = GetBalanceJob(balancefs[0].first,
+                                              balancefs[0].second, slotstofill,
+                                              kSchedulingWaitSec);
+      totalscheduled += std::min(ngot, slotstofill);
+
+      if (ngot) {
+        continue;
+      }
     }
-    // ************************************************************************>
+
     balanceJobNotification.WaitMS(1000);
   }
 }
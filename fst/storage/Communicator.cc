@@ -24,6 +24,7 @@
 #include "fst/storage/Storage.hh"
 #include "fst/XrdFstOfs.hh"
 #include "fst/storage/FileSystem.hh"
+#include "fst/FmdDbMap.hh"
 #include "common/SymKeys.hh"
 
 EOSFSTNAMESPACE_BEGIN
@@ -39,6 +40,10 @@ Storage::Communicator(ThreadAssistant &assistant)
   std::string watch_bootsenttime = "bootsenttime";
   std::string watch_scaninterval = "scaninterval";
   std::string watch_scanrate = "scanrate";
+  std::string watch_fmdcommit = "fmdcommit";
+  std::string watch_iobw_scrub = "iobw.scrub";
+  std::string watch_iobw_balance = "iobw.balance";
+  std::string watch_iobw_drain = "iobw.drain";
   std::string watch_symkey = "symkey";
   std::string watch_manager = "manager";
   std::string watch_publishinterval = "publish.interval";
@@ -47,6 +52,7 @@ Storage::Communicator(ThreadAssistant &assistant)
   std::string watch_gateway_rate = "gw.rate";
   std::string watch_gateway_ntx = "gw.ntx";
   std::string watch_error_simulation = "error.simulation";
+  std::string watch_monitoring_targets = "monitoring.targets";
   std::string watch_regex = ".*";
   bool ok = true;
   ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator", watch_id,
@@ -57,6 +63,14 @@ Storage::Communicator(ThreadAssistant &assistant)
         XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
   ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator", watch_scaninterval,
         XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
+  ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator", watch_fmdcommit,
+        XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
+  ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator", watch_iobw_scrub,
+        XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
+  ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator", watch_iobw_balance,
+        XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
+  ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator", watch_iobw_drain,
+        XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
   ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator", watch_symkey,
         XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
   ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator", watch_manager,
@@ -74,6 +88,9 @@ Storage::Communicator(ThreadAssistant &assistant)
   ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator",
         watch_error_simulation,
         XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
+  ok &= gOFS.ObjectNotifier.SubscribesToKey("communicator",
+        watch_monitoring_targets,
+        XrdMqSharedObjectChangeNotifier::kMqSubjectModification);
   ok &= gOFS.ObjectNotifier.SubscribesToSubjectRegex("communicator", watch_regex,
         XrdMqSharedObjectChangeNotifier::kMqSubjectCreation);
 
@@ -330,6 +347,18 @@ Storage::Communicator(ThreadAssistant &assistant)
 
             gOFS.ObjectManager.HashMutex.UnLockRead();
           }
+
+          if (key == "monitoring.targets") {
+            gOFS.ObjectManager.HashMutex.LockRead();
+            XrdMqSharedHash* hash = gOFS.ObjectManager.GetObject(queue.c_str(), "hash");
+            std::string targets = (hash ? hash->Get("monitoring.targets") : "");
+            gOFS.ObjectManager.HashMutex.UnLockRead();
+
+            if (hash) {
+              eos_static_info("cmd=set monitoring.targets=%s", targets.c_str());
+              gOFS.mMetricsPush.SetTargets(targets);
+            }
+          }
         } else {
           mFsMutex.LockRead();
 
@@ -405,6 +434,21 @@ Storage::Communicator(ThreadAssistant &assistant)
                         fs->ConfigScanner(&mFstLoad, key.c_str(), value);
                       }
                     }
+                  } else if (key == "fmdcommit") {
+                    auto it_fs = mQueue2FsMap.find(queue.c_str());
+
+                    if (it_fs != mQueue2FsMap.end()) {
+                      FileSystem* fs = it_fs->second;
+                      std::string mode = fs->GetString(key.c_str());
+                      gFmdDbMapHandler.SetCommitMode(fs->GetId(),
+                        FmdDbMapHandler::GetCommitModeFromString(mode));
+                    }
+                  } else if (key.beginswith("iobw.")) {
+                    auto it_fs = mQueue2FsMap.find(queue.c_str());
+
+                    if (it_fs != mQueue2FsMap.end()) {
+                      it_fs->second->ConfigIoBandwidth(key.c_str());
+                    }
                   }
                 }
               }
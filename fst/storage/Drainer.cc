@@ -26,6 +26,7 @@
 #include "fst/txqueue/TransferJob.hh"
 #include "fst/txqueue/TransferQueue.hh"
 #include "fst/storage/FileSystem.hh"
+#include <algorithm>
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -207,15 +208,12 @@ Storage::GetFileSystemInDrainMode(std::vector<unsigned int>& drainfsvector,
 }
 
 //------------------------------------------------------------------------------
-// Get drain job for the reuqested filesystem
+// Get a batch of drain jobs for the requested filesystem
 //------------------------------------------------------------------------------
-bool
-Storage::GetDrainJob(unsigned int index)
-
+unsigned long long
+Storage::GetDrainJob(unsigned long id, unsigned long long freebytes,
+                     unsigned long long njobs, int wait_sec)
 {
-  unsigned long long freebytes =
-    mFsVect[index]->GetLongLong("stat.statfs.freebytes");
-  unsigned long id = mFsVect[index]->GetId();
   XrdOucErrInfo error;
   XrdOucString managerQuery = "/?";
   managerQuery += "mgm.pcmd=schedule2drain";
@@ -227,25 +225,37 @@ Storage::GetDrainJob(unsigned int index)
   char sfree[1024];
   snprintf(sfree, sizeof(sfree) - 1, "%llu", freebytes);
   managerQuery += sfree;
+  managerQuery += "&mgm.njobs=";
+  managerQuery += std::to_string(njobs).c_str();
+  managerQuery += "&mgm.wait=";
+  managerQuery += wait_sec;
   managerQuery += "&mgm.logid=";
   managerQuery += logId;
   XrdOucString response = "";
-  int rc = gOFS.CallManager(&error, "/", 0, managerQuery, &response);
+  // A long-polling request must not time out before the manager answers
+  int rc = gOFS.CallManager(&error, "/", 0, managerQuery, &response,
+                            wait_sec ? wait_sec + kSchedulingTimeoutSec : 0);
   eos_static_debug("job-response=%s", response.c_str());
 
   if (rc) {
     eos_static_err("manager returned errno=%d for schedule2drain on fsid=%u",
                    rc, id);
   } else {
+    // Managers without batching answer with a single job
     if (response == "submitted") {
       eos_static_info("msg=\"new transfer job\" fsid=%u", id);
-      return true;
+      return 1;
+    } else if (response.beginswith("submitted:")) {
+      unsigned long long nsubmitted = strtoull(response.c_str() + 10, 0, 10);
+      eos_static_info("msg=\"new transfer jobs\" fsid=%u njobs=%llu", id,
+                      nsubmitted);
+      return nsubmitted;
     } else {
       eos_static_debug("manager returned no file to schedule [ENODATA]");
     }
   }
 
-  return false;
+  return 0;
 }
 
 //------------------------------------------------------------------------------
@@ -301,19 +311,20 @@ Storage::Drainer()
 
     // -------------------------------------------------------------------------
     // -- 2 --
-    // wait that drain slots are free
+    // wait that drain slots are free, the queue holds up to
+    // kSchedulingQueueFactor jobs per slot so that no slot sits idle between
+    // two requests to the manager
     // -------------------------------------------------------------------------
-    nscheduled = WaitFreeDrainSlot(nparalleltx, totalscheduled, totalexecuted);
+    unsigned long long queuedepth = kSchedulingQueueFactor * nparalleltx;
+    nscheduled = WaitFreeDrainSlot(queuedepth, totalscheduled, totalexecuted);
     // -------------------------------------------------------------------------
     // -- 3 --
     // get the filesystems which are in drain mode and get their configuration
-    // exclude filesystems which couldn't be scheduled for 1 minute
     // -------------------------------------------------------------------------
     std::vector<unsigned int> drainfsindex;
-    std::vector<bool> drainfsindexSchedulingFailed;
-    std::map<unsigned int, time_t> drainfsindexSchedulingTime;
+    std::vector<std::pair<unsigned long, unsigned long long>> drainfs;
     {
-      // Read lock the file system vector from now on
+      // The manager requests run without the lock of the filesystem vector
       eos::common::RWMutexReadLock lock(mFsMutex);
 
       if (!GetFileSystemInDrainMode(drainfsindex, cycler, nparalleltx, ratetx)) {
@@ -323,62 +334,75 @@ Storage::Drainer()
         noDrainer = false;
       }
 
-      drainfsindexSchedulingFailed.resize(drainfsindex.size());
-      // -------------------------------------------------------------------------
-      // -- 4 --
-      // cycle over all filesystems in drain mode until all slots are filled or
-      // none can schedule anymore
-      // -------------------------------------------------------------------------
-      size_t slotstofill = ((nparalleltx - nscheduled) > 0) ?
-                           (nparalleltx - nscheduled) : 0;
-      bool stillGotOneScheduled;
-      eos_static_debug("slotstofill=%u nparalleltx=%u nscheduled=%u "
-                       "totalscheduled=%llu totalexecuted=%llu",
-                       slotstofill, nparalleltx, nscheduled, totalscheduled,
-                       totalexecuted);
-
-      if (slotstofill) {
-        do {
-          stillGotOneScheduled = false;
-
-          for (size_t i = 0; i < drainfsindex.size(); i++) {
-            // Skip indices where we know we couldn't schedule
-            if (drainfsindexSchedulingFailed[i]) {
-              continue;
-            }
-
-            // Skip filesystems where scheduling has been blocked for some time
-            if ((drainfsindexSchedulingTime.count(drainfsindex[i])) &&
-                (drainfsindexSchedulingTime[drainfsindex[i]] > time(NULL))) {
-              continue;
-            }
-
-            // Try to get a drainjob for the indexed filesystem
-            if (GetDrainJob(drainfsindex[i])) {
-              eos_static_debug("got scheduled totalscheduled=%llu slotstofill=%llu",
-                               totalscheduled, slotstofill);
-              drainfsindexSchedulingTime[drainfsindex[i]] = 0;
-              totalscheduled++;
-              stillGotOneScheduled = true;
-              slotstofill--;
-            } else {
-              drainfsindexSchedulingFailed[i] = true;
-              drainfsindexSchedulingTime[drainfsindex[i]] = time(NULL) + 60;
-            }
-
-            // Stop if all slots are full
-            if (!slotstofill) {
-              break;
-            }
-          }
-        } while (slotstofill && stillGotOneScheduled);
-
-        // Reset the failed vector, otherwise we starve forever
-        for (size_t i = 0; i < drainfsindex.size(); i++) {
-          drainfsindexSchedulingFailed[i] = false;
+      for (auto index : drainfsindex) {
+        drainfs.emplace_back(mFsVect[index]->GetId(),
+                             mFsVect[index]->
+                             GetLongLong("stat.statfs.freebytes"));
+      }
+    }
+    // -------------------------------------------------------------------------
+    // -- 4 --
+    // cycle over all filesystems in drain mode until all slots are filled or
+    // none can schedule anymore, each request asks for a batch of jobs
+    // -------------------------------------------------------------------------
+    unsigned long long slotstofill = queuedepth - nscheduled;
+    std::vector<bool> drainfsSchedulingFailed(drainfs.size(), false);
+    bool stillGotOneScheduled;
+    eos_static_debug("slotstofill=%u nparalleltx=%u nscheduled=%u "
+                     "totalscheduled=%llu totalexecuted=%llu",
+                     slotstofill, nparalleltx, nscheduled, totalscheduled,
+                     totalexecuted);
+
+    do {
+      stillGotOneScheduled = false;
+      size_t nactive = std::count(drainfsSchedulingFailed.begin(),
+                                  drainfsSchedulingFailed.end(), false);
+
+      if (!nactive) {
+        break;
+      }
+
+      for (size_t i = 0; (i < drainfs.size()) && slotstofill; i++) {
+        // Skip filesystems where we know we couldn't schedule
+        if (drainfsSchedulingFailed[i]) {
+          continue;
+        }
+
+        // Share the free slots between the filesystems still scheduling
+        unsigned long long njobs = std::max(slotstofill / nactive, 1ull);
+        unsigned long long ngot = GetDrainJob(drainfs[i].first,
+                                              drainfs[i].second, njobs, 0);
+        ngot = std::min(ngot, slotstofill);
+        totalscheduled += ngot;
+        slotstofill -= ngot;
+        eos_static_debug("got scheduled totalscheduled=%llu slotstofill=%llu",
+                         totalscheduled, slotstofill);
+
+        if (ngot) {
+          stillGotOneScheduled = true;
+        }
+
+        if (ngot < njobs) {
+          drainfsSchedulingFailed[i] = true;
         }
       }
+    } while (slotstofill && stillGotOneScheduled);
+
+    // -------------------------------------------------------------------------
+    // -- 5 --
+    // if there is no work at all, wait in the manager until a job for the
+    // first filesystem of the cycle is available instead of polling
+    // -------------------------------------------------------------------------
+    if (!nscheduled && (slotstofill == queuedepth)) {
+      unsigned long long ngot = GetDrainJob(drainfs[0].first, drainfs[0].second,
+                                            slotstofill, kSchedulingWaitSec);
+      totalscheduled += std::min(ngot, slotstofill);
+
+      if (ngot) {
+        continue;
+      }
     }
+
     drainJobNotification.WaitMS(1000);
   }
 }
@@ -26,6 +26,8 @@
 #include "fst/ScanDir.hh"
 #include "fst/txqueue/TransferQueue.hh"
 #include "fst/FmdDbMap.hh"
+#include <algorithm>
+#include <iterator>
 
 #ifdef __APPLE__
 #define O_DIRECT 0
@@ -53,14 +55,19 @@ FileSystem::FileSystem(const char* queuepath,
   std::string n3 = queuepath;
   n3 += "/extern";
   mLocalBootStatus = eos::common::FileSystem::kDown;
-  mTxDrainQueue = new TransferQueue(&mDrainQueue, n1.c_str());
-  mTxBalanceQueue = new TransferQueue(&mBalanceQueue, n2.c_str());
-  mTxExternQueue = new TransferQueue(&mExternQueue, n3.c_str());
+  mTxDrainQueue = new TransferQueue(&mDrainQueue, n1.c_str(), 2, 100,
+                                    TransferQueue::kDrain);
+  mTxBalanceQueue = new TransferQueue(&mBalanceQueue, n2.c_str(), 2, 100,
+                                      TransferQueue::kBalance);
+  mTxExternQueue = new TransferQueue(&mExternQueue, n3.c_str(), 2, 100,
+                                     TransferQueue::kUser);
   mTxMultiplexer.Add(mTxDrainQueue);
   mTxMultiplexer.Add(mTxBalanceQueue);
   mTxMultiplexer.Add(mTxExternQueue);
   mTxMultiplexer.Run();
   mRecoverable = false;
+  mFsckDeltaFids = 0;
+  mFsckTrimmedSeq = 0;
   mFileIO.reset(FileIoPlugin::GetIoObject(mPath));
 }
 
@@ -306,6 +313,32 @@ FileSystem::ConfigScanner(Load* fst_load, const std::string& key,
   mScanDir->SetConfig(key, value);
 }
 
+//------------------------------------------------------------------------------
+// Configure the bandwidth limit of a background IO class
+//------------------------------------------------------------------------------
+bool
+FileSystem::ConfigIoBandwidth(const std::string& key)
+{
+  for (int i = 0; i < IoPriority::kNumClasses; ++i) {
+    IoPriority::Class cls = static_cast<IoPriority::Class>(i);
+
+    if (key == std::string("iobw.") + IoPriority::GetName(cls)) {
+      long long value = GetLongLong(key.c_str());
+      uint64_t rate = ((value > 0) ? (uint64_t) value * 1024 * 1024 : 0);
+
+      if (rate != mIoThrottles[i].GetRate()) {
+        eos_info("msg=\"set io bandwidth limit\" class=%s rate=%lld MB/s",
+                 IoPriority::GetName(cls), (value > 0) ? value : 0);
+        mIoThrottles[i].SetRate(rate);
+      }
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
 /*----------------------------------------------------------------------------*/
 bool
 FileSystem::OpenTransaction(unsigned long long fid)
@@ -376,4 +409,113 @@ FileSystem::IoPing()
 }
 
 
+//------------------------------------------------------------------------------
+// Replace the inconsistency sets and record the change in the fsck feed
+//------------------------------------------------------------------------------
+void
+FileSystem::UpdateInconsistencySets(std::map<std::string,
+                                    std::set<eos::common::FileId::fileid_t> >& sets,
+                                    std::atomic<uint64_t>& seq)
+{
+  FsckDelta delta;
+  delta.size = 0;
+
+  for (auto it = sets.cbegin(); it != sets.cend(); ++it) {
+    auto old = inconsistency_sets.find(it->first);
+
+    if (old == inconsistency_sets.end()) {
+      if (it->second.size()) {
+        delta.added[it->first] = it->second;
+        delta.size += it->second.size();
+      }
+
+      continue;
+    }
+
+    std::set<eos::common::FileId::fileid_t> diff;
+    std::set_difference(it->second.begin(), it->second.end(),
+                        old->second.begin(), old->second.end(),
+                        std::inserter(diff, diff.end()));
+
+    if (diff.size()) {
+      delta.size += diff.size();
+      delta.added[it->first].swap(diff);
+    }
+
+    std::set_difference(old->second.begin(), old->second.end(),
+                        it->second.begin(), it->second.end(),
+                        std::inserter(diff, diff.end()));
+
+    if (diff.size()) {
+      delta.size += diff.size();
+      delta.removed[it->first].swap(diff);
+    }
+  }
+
+  for (auto old = inconsistency_sets.cbegin(); old != inconsistency_sets.cend();
+       ++old) {
+    if (!sets.count(old->first) && old->second.size()) {
+      delta.removed[old->first] = old->second;
+      delta.size += old->second.size();
+    }
+  }
+
+  inconsistency_sets.swap(sets);
+
+  if (!delta.size) {
+    return;
+  }
+
+  delta.seq = ++seq;
+  mFsckDeltaFids += delta.size;
+  mFsckDeltas.push_back(std::move(delta));
+
+  // A feed exceeding the budget is cut from the front, requests reaching
+  // behind the cut are answered with the full sets
+  while ((mFsckDeltaFids > sMaxFsckDeltaFids) && mFsckDeltas.size()) {
+    mFsckTrimmedSeq = mFsckDeltas.front().seq;
+    mFsckDeltaFids -= mFsckDeltas.front().size;
+    mFsckDeltas.pop_front();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the net change of the inconsistency sets after a sequence number
+//------------------------------------------------------------------------------
+bool
+FileSystem::GetInconsistencyDelta(uint64_t since,
+                                  std::map<std::string,
+                                  std::set<eos::common::FileId::fileid_t> >& added,
+                                  std::map<std::string,
+                                  std::set<eos::common::FileId::fileid_t> >& removed)
+{
+  if (since < mFsckTrimmedSeq) {
+    return false;
+  }
+
+  for (auto it = mFsckDeltas.cbegin(); it != mFsckDeltas.cend(); ++it) {
+    if (it->seq <= since) {
+      continue;
+    }
+
+    // Later changes of a fid override earlier ones
+    for (auto tag = it->added.cbegin(); tag != it->added.cend(); ++tag) {
+      for (auto fid : tag->second) {
+        removed[tag->first].erase(fid);
+        added[tag->first].insert(fid);
+      }
+    }
+
+    for (auto tag = it->removed.cbegin(); tag != it->removed.cend(); ++tag) {
+      for (auto fid : tag->second) {
+        added[tag->first].erase(fid);
+        removed[tag->first].insert(fid);
+      }
+    }
+  }
+
+  return true;
+}
+
+
 EOSFSTNAMESPACE_END
@@ -29,10 +29,13 @@
 #include "fst/txqueue/TransferMultiplexer.hh"
 #include "fst/storage/FileSystem.hh"
 #include "fst/io/FileIo.hh"
+#include "fst/utils/IoPriority.hh"
 #include "common/Logging.hh"
 #include "common/FileSystem.hh"
 #include "common/StringConversion.hh"
 #include "common/FileId.hh"
+#include <atomic>
+#include <deque>
 #include <vector>
 #include <list>
 #include <queue>
@@ -88,6 +91,24 @@ public:
   //-----------------------------------------------------------------------------
   void ConfigScanner(Load* fst_load, const std::string& key, long long value);
 
+  //-----------------------------------------------------------------------------
+  //! Configure the bandwidth limit of a background IO class from the
+  //! "iobw.<class>" key of the filesystem, in MB/s, 0 or unset for no limit
+  //!
+  //! @param key configuration key
+  //!
+  //! @return true if the key is an IO bandwidth key, otherwise false
+  //-----------------------------------------------------------------------------
+  bool ConfigIoBandwidth(const std::string& key);
+
+  //-----------------------------------------------------------------------------
+  //! Get the bandwidth limit of a background IO class on this filesystem
+  //-----------------------------------------------------------------------------
+  inline IoThrottle& GetIoThrottle(IoPriority::Class cls)
+  {
+    return mIoThrottles[cls];
+  }
+
   //-----------------------------------------------------------------------------
   //! Get file system mount path
   //-----------------------------------------------------------------------------
@@ -134,6 +155,35 @@ public:
     return &inconsistency_sets;
   }
 
+  //----------------------------------------------------------------------------
+  //! Replace the inconsistency sets and record the difference to the previous
+  //! sets in the fsck change feed. Has to be called with the
+  //! InconsistencyStatsMutex locked.
+  //!
+  //! @param sets new inconsistency sets, swapped into the filesystem
+  //! @param seq node wide sequence number, incremented if anything changed
+  //----------------------------------------------------------------------------
+  void UpdateInconsistencySets(std::map<std::string,
+                               std::set<eos::common::FileId::fileid_t> >& sets,
+                               std::atomic<uint64_t>& seq);
+
+  //----------------------------------------------------------------------------
+  //! Get the net changes of the inconsistency sets after a given sequence
+  //! number. Has to be called with the InconsistencyStatsMutex locked.
+  //!
+  //! @param since last sequence number known to the caller
+  //! @param added fids which entered a set after since
+  //! @param removed fids which left a set after since
+  //!
+  //! @return false if the change feed does not reach back to since, the
+  //!         caller has to use the full sets
+  //----------------------------------------------------------------------------
+  bool GetInconsistencyDelta(uint64_t since,
+                             std::map<std::string,
+                             std::set<eos::common::FileId::fileid_t> >& added,
+                             std::map<std::string,
+                             std::set<eos::common::FileId::fileid_t> >& removed);
+
   void
   SetStatus(eos::common::FileSystem::fsstatus_t status)
   {
@@ -261,6 +311,8 @@ public:
 private:
   std::unique_ptr<eos::fst::ScanDir> mScanDir; ///< Filesystem scanner
   std::unique_ptr<FileIo> mFileIO; ///< File used for statfs calls
+  //! Bandwidth limits of the background IO classes
+  IoThrottle mIoThrottles[IoPriority::kNumClasses];
   XrdOucString transactionDirectory;
 
   unsigned long last_blocks_free;
@@ -276,6 +328,20 @@ private:
   std::map<std::string, std::set<eos::common::FileId::fileid_t> >
   inconsistency_sets;
 
+  //! Change of the inconsistency sets published with one sequence number
+  struct FsckDelta {
+    uint64_t seq;
+    std::map<std::string, std::set<eos::common::FileId::fileid_t> > added;
+    std::map<std::string, std::set<eos::common::FileId::fileid_t> > removed;
+    size_t size;
+  };
+
+  //! Maximum number of fids kept in the fsck change feed
+  static constexpr size_t sMaxFsckDeltaFids = 1000000;
+  std::deque<FsckDelta> mFsckDeltas; ///< Fsck change feed, oldest first
+  size_t mFsckDeltaFids; ///< Number of fids in the change feed
+  uint64_t mFsckTrimmedSeq; ///< Highest sequence number dropped from the feed
+
   long long seqBandwidth; // measurement of sequential bandwidth
   int IOPS; // measurement of IOPS
 
@@ -26,12 +26,21 @@
 #include "fst/txqueue/TransferQueue.hh"
 #include "fst/storage/FileSystem.hh"
 #include "fst/FmdDbMap.hh"
+#include "fst/utils/PublishFilter.hh"
+#include "fst/utils/ReadVCoalescer.hh"
+#include "fst/io/xrd/XrdIo.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
 #include "qclient/Formatting.hh"
 #include "common/LinuxStat.hh"
-#include "common/ShellCmd.hh"
 #include "common/Timing.hh"
 #include "XrdVersion.hh"
+#include <algorithm>
+#include <fcntl.h>
+#include <mutex>
+#include <sstream>
+#include <sys/sysinfo.h>
+#include <unistd.h>
+#include <utmp.h>
 
 XrdVERSIONINFOREF(XrdgetProtocol);
 
@@ -67,59 +76,167 @@ static std::string hotFilesToString(
 }
 
 //------------------------------------------------------------------------------
-// Retrieve net speed
+// Serialize hot IO vector into std::string as <bytes/s>:<iops>:<hexfid>
+// entries. Return " " if given an empty vector, instead of "".
 //------------------------------------------------------------------------------
-static uint64_t getNetspeed(const std::string& tmpname)
+static std::string hotIoToString(
+  const std::vector<eos::fst::OpenFileTracker::HotIoEntry>& entries)
 {
-  if (getenv("EOS_FST_NETWORK_SPEED")) {
-    return strtoull(getenv("EOS_FST_NETWORK_SPEED"), nullptr, 10);
+  if (entries.size() == 0u) {
+    return " ";
   }
 
-  std::string getNetspeedCommand = SSTR(
-                                     "ip route list | sed -ne '/^default/s/.*dev //p' | cut -d ' ' -f1 |"
-                                     " xargs -i ethtool {} 2>&1 | grep Speed | cut -d ' ' -f2 | cut -d 'M' -f1 > "
-                                     << tmpname);
-  eos::common::ShellCmd scmd1(getNetspeedCommand.c_str());
-  eos::common::cmd_status rc = scmd1.wait(5);
-  unsigned long long netspeed = 1000000000;
+  std::ostringstream ss;
 
-  if (rc.exit_code) {
-    eos_static_err("ip route list call failed to get netspeed");
-    return netspeed;
+  for (size_t i = 0; i < entries.size(); i++) {
+    XrdOucString hexfid;
+    eos::common::FileId::Fid2Hex(entries[i].fid, hexfid);
+    ss << (unsigned long long) entries[i].bytesPerSec;
+    ss << ":";
+    ss << (unsigned long long) entries[i].iops;
+    ss << ":";
+    ss << hexfid.c_str();
+    ss << " ";
   }
 
-  FILE* fnetspeed = fopen(tmpname.c_str(), "r");
+  return ss.str();
+}
 
-  if (fnetspeed) {
-    if ((fscanf(fnetspeed, "%llu", &netspeed)) == 1) {
-      // we get MB as a number => convert into bytes
-      netspeed *= 1000000;
-      eos_static_info("ethtool:networkspeed=%.02f GB/s",
-                      1.0 * netspeed / 1000000000.0);
+//------------------------------------------------------------------------------
+// Reader of a file under /proc keeping the file open, every Read returns the
+// current contents
+//------------------------------------------------------------------------------
+class ProcFileReader
+{
+public:
+  ProcFileReader(const char* path): mPath(path), mFd(-1) {}
+
+  ~ProcFileReader()
+  {
+    if (mFd >= 0) {
+      (void) close(mFd);
     }
+  }
 
-    fclose(fnetspeed);
+  bool Read(std::string& contents)
+  {
+    if ((mFd < 0) && ((mFd = open(mPath.c_str(), O_RDONLY | O_CLOEXEC)) < 0)) {
+      return false;
+    }
+
+    char buffer[65536];
+    off_t offset = 0;
+    ssize_t nread;
+    contents.clear();
+
+    while ((nread = pread(mFd, buffer, sizeof(buffer), offset)) > 0) {
+      contents.append(buffer, nread);
+      offset += nread;
+    }
+
+    return (nread == 0);
+  }
+
+private:
+  std::string mPath;
+  int mFd;
+};
+
+//------------------------------------------------------------------------------
+// Retrieve net speed of the interface of the default route in bytes/s
+//------------------------------------------------------------------------------
+static uint64_t getNetspeed()
+{
+  if (getenv("EOS_FST_NETWORK_SPEED")) {
+    return strtoull(getenv("EOS_FST_NETWORK_SPEED"), nullptr, 10);
+  }
+
+  unsigned long long netspeed = 1000000000;
+  std::string route;
+  std::string iface;
+
+  if (eos::common::StringConversion::LoadFileIntoString("/proc/net/route",
+      route)) {
+    std::istringstream iss(route);
+    std::string line;
+
+    while (std::getline(iss, line)) {
+      char name[64];
+      unsigned long dest;
+
+      // Iface Destination ..., the default route has destination 0
+      if ((sscanf(line.c_str(), "%63s %lx", name, &dest) == 2) && (dest == 0)) {
+        iface = name;
+        break;
+      }
+    }
+  }
+
+  std::string speed;
+
+  if (iface.empty() ||
+      !eos::common::StringConversion::LoadFileIntoString(
+        SSTR("/sys/class/net/" << iface << "/speed").c_str(), speed) ||
+      (strtoll(speed.c_str(), nullptr, 10) <= 0)) {
+    eos_static_err("msg=\"failed to get the speed of the default route "
+                   "interface\" iface=\"%s\"", iface.c_str());
+    return netspeed;
   }
 
+  // we get Mb/s as a number => convert into bytes
+  netspeed = strtoull(speed.c_str(), nullptr, 10) * 1000000;
+  eos_static_info("iface=%s networkspeed=%.02f GB/s", iface.c_str(),
+                  1.0 * netspeed / 1000000000.0);
   return netspeed;
 }
 
 //------------------------------------------------------------------------------
-// Retrieve uptime
+// Retrieve uptime in the format of the uptime command
 //------------------------------------------------------------------------------
-static std::string getUptime(const std::string& tmpname)
+static std::string getUptime()
 {
-  eos::common::ShellCmd cmd(SSTR("uptime | tr -d \"\n\" > " << tmpname));
-  eos::common::cmd_status rc = cmd.wait(5);
+  struct sysinfo info;
 
-  if (rc.exit_code) {
+  if (sysinfo(&info)) {
     eos_static_err("retrieve uptime call failed");
     return "N/A";
   }
 
-  std::string retval;
-  eos::common::StringConversion::LoadFileIntoString(tmpname.c_str(), retval);
-  return retval;
+  // Number of logged in users
+  int nusers = 0;
+  struct utmp* entry;
+  setutent();
+
+  while ((entry = getutent())) {
+    if (entry->ut_type == USER_PROCESS) {
+      ++nusers;
+    }
+  }
+
+  endutent();
+  time_t now = time(nullptr);
+  struct tm tm_now;
+  localtime_r(&now, &tm_now);
+  long days = info.uptime / 86400;
+  long hours = (info.uptime % 86400) / 3600;
+  long minutes = (info.uptime % 3600) / 60;
+  const double scale = 1 << SI_LOAD_SHIFT;
+  char uptime[256];
+  char up[64];
+
+  if (days) {
+    snprintf(up, sizeof(up), "%ld day%s, %2ld:%02ld", days,
+             (days > 1) ? "s" : "", hours, minutes);
+  } else {
+    snprintf(up, sizeof(up), "%2ld:%02ld", hours, minutes);
+  }
+
+  snprintf(uptime, sizeof(uptime),
+           " %02d:%02d:%02d up %s,  %d user%s,  load average: %.2f, %.2f, %.2f",
+           tm_now.tm_hour, tm_now.tm_min, tm_now.tm_sec, up, nusers,
+           (nusers == 1) ? "" : "s", info.loads[0] / scale, info.loads[1] / scale,
+           info.loads[2] / scale);
+  return uptime;
 }
 
 //------------------------------------------------------------------------------
@@ -173,28 +290,80 @@ static std::string getNetworkInterface()
 // Retrieve number of TCP sockets in the system
 // TODO: Change return value to integer..
 //------------------------------------------------------------------------------
-static std::string getNumberOfTCPSockets(const std::string& tmpname)
+static std::string getNumberOfTCPSockets()
 {
-  std::string command = SSTR("cat /proc/net/tcp | wc -l | tr -d \"\n\" > " <<
-                             tmpname);
-  eos::common::ShellCmd cmd(command.c_str());
-  eos::common::cmd_status rc = cmd.wait(5);
+  static std::mutex sMutex;
+  static ProcFileReader sReader("/proc/net/tcp");
+  std::lock_guard<std::mutex> lock(sMutex);
+  std::string contents;
 
-  if (rc.exit_code) {
+  if (!sReader.Read(contents)) {
     eos_static_err("retrieve #socket call failed");
+    return "";
   }
 
-  std::string retval;
-  eos::common::StringConversion::LoadFileIntoString(tmpname.c_str(), retval);
-  return retval;
+  // Same as counting the lines with wc -l, including the header line
+  return std::to_string(std::count(contents.begin(), contents.end(), '\n'));
 }
 
+//------------------------------------------------------------------------------
+// Helper publishing the values of a filesystem through the publish filter,
+// the hash is only updated and the value broadcast if it changed
+//------------------------------------------------------------------------------
+class FsPublisher
+{
+public:
+  FsPublisher(PublishFilter& filter, FileSystem* fs):
+    mFilter(filter), mFs(fs), mSubject(fs->GetQueuePath())
+  {}
+
+  bool SetString(const char* key, const char* value)
+  {
+    return (!mFilter.Changed(mSubject, key, std::string(value)) ||
+            mFs->SetString(key, value));
+  }
+
+  bool SetLongLong(const char* key, long long value)
+  {
+    return (!mFilter.Changed(mSubject, key, value) ||
+            mFs->SetLongLong(key, value));
+  }
+
+  bool SetDouble(const char* key, double value)
+  {
+    return (!mFilter.Changed(mSubject, key, value) ||
+            mFs->SetDouble(key, value));
+  }
+
+  bool SetStatfs(struct statfs* statfs)
+  {
+    bool success = true;
+    success &= SetLongLong("stat.statfs.type", statfs->f_type);
+    success &= SetLongLong("stat.statfs.bsize", statfs->f_bsize);
+    success &= SetLongLong("stat.statfs.blocks", statfs->f_blocks);
+    success &= SetLongLong("stat.statfs.bfree", statfs->f_bfree);
+    success &= SetLongLong("stat.statfs.bavail", statfs->f_bavail);
+    success &= SetLongLong("stat.statfs.files", statfs->f_files);
+    success &= SetLongLong("stat.statfs.ffree", statfs->f_ffree);
+#ifdef __APPLE__
+    success &= SetLongLong("stat.statfs.namelen", MNAMELEN);
+#else
+    success &= SetLongLong("stat.statfs.namelen", statfs->f_namelen);
+#endif
+    return success;
+  }
+
+private:
+  PublishFilter& mFilter;
+  FileSystem* mFs;
+  std::string mSubject;
+};
+
 //------------------------------------------------------------------------------
 // Get statistics about this FST, used for publishing
 //------------------------------------------------------------------------------
 std::map<std::string, std::string>
-Storage::getFSTStatistics(const std::string& tmpfile,
-                          unsigned long long netspeed)
+Storage::getFSTStatistics(unsigned long long netspeed)
 {
   eos::common::LinuxStat::linux_stat_t osstat;
 
@@ -218,9 +387,9 @@ Storage::getFSTStatistics(const std::string& tmpfile,
   // adler32 of keytab
   output["stat.sys.keytab"] = eos::fst::Config::gConfig.KeyTabAdler.c_str();
   // machine uptime
-  output["stat.sys.uptime"] = getUptime(tmpfile);
+  output["stat.sys.uptime"] = getUptime();
   // active TCP sockets
-  output["stat.sys.sockets"] = getNumberOfTCPSockets(tmpfile);
+  output["stat.sys.sockets"] = getNumberOfTCPSockets();
   // startup time of the FST daemon
   output["stat.sys.eos.start"] = eos::fst::Config::gConfig.StartDate.c_str();
   // FST geotag
@@ -240,31 +409,27 @@ Storage::getFSTStatistics(const std::string& tmpfile,
   output["stat.net.outratemib"] = SSTR(
                                     mFstLoad.GetNetRate(getNetworkInterface().c_str(),
                                         "txbytes") / 1024.0 / 1024.0);
+  // vector read coalescing
+  ReadVCoalescer::Stats& readv_stats = ReadVCoalescer::GetStats();
+  output["stat.readv.reqbytes"] = SSTR(readv_stats.mReqBytes.load());
+  output["stat.readv.readbytes"] = SSTR(readv_stats.mReadBytes.load());
+  output["stat.readv.reqchunks"] = SSTR(readv_stats.mReqChunks.load());
+  output["stat.readv.readchunks"] = SSTR(readv_stats.mReadChunks.load());
+  // xrootd connection pool used for the remote IO
+  eos::common::XrdConnPool::Stats pool_stats = XrdIo::GetConnPool().GetStats();
+  output["stat.connpool.endpoints"] = SSTR(pool_stats.mEndpoints);
+  output["stat.connpool.conns"] = SSTR(pool_stats.mConnections);
+  output["stat.connpool.inflight"] = SSTR(pool_stats.mInFlight);
+  output["stat.connpool.assigned"] = SSTR(pool_stats.mAssigned);
+  output["stat.connpool.shared"] = SSTR(pool_stats.mShared);
+  output["stat.connpool.grown"] = SSTR(pool_stats.mGrown);
+  output["stat.connpool.shrunk"] = SSTR(pool_stats.mShrunk);
   // publish timestamp
   output["stat.publishtimestamp"] = SSTR(
                                       eos::common::getEpochInMilliseconds().count());
   return output;
 }
 
-//------------------------------------------------------------------------------
-// open random temporary file in /tmp/
-// Return value: string containing the temporary file. If opening it was
-// not possible, return empty string.
-//------------------------------------------------------------------------------
-std::string makeTemporaryFile()
-{
-  char tmp_name[] = "/tmp/fst.publish.XXXXXX";
-  int tmp_fd = mkstemp(tmp_name);
-
-  if (tmp_fd == -1) {
-    eos_static_crit("failed to create temporary file!");
-    return "";
-  }
-
-  (void) close(tmp_fd);
-  return tmp_name;
-}
-
 //------------------------------------------------------------------------------
 // Publish
 //------------------------------------------------------------------------------
@@ -272,16 +437,10 @@ void
 Storage::Publish(ThreadAssistant& assistant)
 {
   eos_static_info("Publisher activated ...");
-  // Get our network speed
-  std::string tmp_name = makeTemporaryFile();
-
-  if (tmp_name.empty()) {
-    return;
-  }
-
   XrdOucString lNodeGeoTag = (getenv("EOS_GEOTAG") ?
                               getenv("EOS_GEOTAG") : "geotagdefault");
-  unsigned long long netspeed = getNetspeed(tmp_name);
+  // Get our network speed
+  unsigned long long netspeed = getNetspeed();
   eos_static_info("publishing:networkspeed=%.02f GB/s",
                   1.0 * netspeed / 1000000000.0);
   // The following line acts as a barrier that prevents progress
@@ -289,12 +448,14 @@ Storage::Publish(ThreadAssistant& assistant)
   eos::fst::Config::gConfig.getFstNodeConfigQueue("Publish");
   std::chrono::steady_clock::time_point next_consistency_stats;
   std::chrono::steady_clock::time_point last_consistency_stats;
+  // Only the values which changed are broadcast
+  PublishFilter filter(PublishFilter::GetTolerance(),
+                       PublishFilter::GetRefreshInterval());
 
   while (!assistant.terminationRequested()) {
-    std::string publish_uptime = getUptime(tmp_name);
-    std::string publish_sockets = getNumberOfTCPSockets(tmp_name);
     std::chrono::steady_clock::time_point cycleStart =
       std::chrono::steady_clock::now();
+    filter.BeginCycle(cycleStart);
     std::chrono::milliseconds randomizedReportInterval =
       eos::fst::Config::gConfig.getRandomizedPublishInterval();
     {
@@ -318,10 +479,15 @@ Storage::Publish(ThreadAssistant& assistant)
             continue;
           }
 
+          FsPublisher fs_pub(filter, mFsVect[i]);
           std::string r_open_hotfiles =
             hotFilesToString(gOFS.openedForReading.getHotFiles(fsid, 10));
           std::string w_open_hotfiles =
             hotFilesToString(gOFS.openedForWriting.getHotFiles(fsid, 10));
+          std::string r_hotio =
+            hotIoToString(gOFS.openedForReading.getHotIo(fsid, 10));
+          std::string w_hotio =
+            hotIoToString(gOFS.openedForWriting.getHotIo(fsid, 10));
           // Retrieve Statistics from the local db
           std::map<std::string, size_t>::const_iterator isit;
           bool success = true;
@@ -331,16 +497,19 @@ Storage::Publish(ThreadAssistant& assistant)
               eos_static_debug("msg=\"publish consistency stats\"");
               last_consistency_stats = cycleStart;
               XrdSysMutexHelper ISLock(mFsVect[i]->InconsistencyStatsMutex);
-              gFmdDbMapHandler.GetInconsistencyStatistics(fsid,
-                  *mFsVect[i]->GetInconsistencyStats(),
-                  *mFsVect[i]->GetInconsistencySets());
+              std::map<std::string, std::set<eos::common::FileId::fileid_t> > icsets;
+
+              if (gFmdDbMapHandler.GetInconsistencyStatistics(fsid,
+                  *mFsVect[i]->GetInconsistencyStats(), icsets)) {
+                mFsVect[i]->UpdateInconsistencySets(icsets, mFsckSeq);
+              }
 
               for (isit = mFsVect[i]->GetInconsistencyStats()->begin();
                    isit != mFsVect[i]->GetInconsistencyStats()->end(); isit++) {
                 //eos_static_debug("%-24s => %lu", isit->first.c_str(), isit->second);
                 std::string sname = "stat.fsck.";
                 sname += isit->first;
-                success &= mFsVect[i]->SetLongLong(sname.c_str(), isit->second);
+                success &= fs_pub.SetLongLong(sname.c_str(), isit->second);
               }
             }
           }
@@ -350,7 +519,7 @@ Storage::Publish(ThreadAssistant& assistant)
           // call the update function which stores into the filesystem shared hash
           if (statfs) {
             // call the update function which stores into the filesystem shared hash
-            if (!mFsVect[i]->SetStatfs(statfs->GetStatfs())) {
+            if (!fs_pub.SetStatfs(statfs->GetStatfs())) {
               eos_static_err("cannot SetStatfs on filesystem %s",
                              mFsVect[i]->GetPath().c_str());
             }
@@ -377,10 +546,10 @@ Storage::Publish(ThreadAssistant& assistant)
                                               "millisIO") / 1000.0;
             }
 
-            success &= mFsVect[i]->SetDouble("stat.disk.readratemb", readratemb);
-            success &= mFsVect[i]->SetDouble("stat.disk.writeratemb",
+            success &= fs_pub.SetDouble("stat.disk.readratemb", readratemb);
+            success &= fs_pub.SetDouble("stat.disk.writeratemb",
                                              writeratemb);
-            success &= mFsVect[i]->SetDouble("stat.disk.load", diskload);
+            success &= fs_pub.SetDouble("stat.disk.load", diskload);
           }
           // copy out net info
           {
@@ -391,60 +560,76 @@ Storage::Publish(ThreadAssistant& assistant)
               health = mFstHealth.getDiskHealth(mFsVect[i]->GetPath());
             }
 
-            success &= mFsVect[i]->SetString("stat.health",
+            success &= fs_pub.SetString("stat.health",
                                              (health.count("summary") ? health["summary"].c_str() : "N/A"));
-            success &= mFsVect[i]->SetLongLong("stat.health.indicator",
+            success &= fs_pub.SetLongLong("stat.health.indicator",
                                                strtoll(health["indicator"].c_str(), 0, 10));
-            success &= mFsVect[i]->SetLongLong("stat.health.drives_total",
+            success &= fs_pub.SetLongLong("stat.health.drives_total",
                                                strtoll(health["drives_total"].c_str(), 0, 10));
-            success &= mFsVect[i]->SetLongLong("stat.health.drives_failed",
+            success &= fs_pub.SetLongLong("stat.health.drives_failed",
                                                strtoll(health["drives_failed"].c_str(), 0, 10));
-            success &= mFsVect[i]->SetLongLong("stat.health.redundancy_factor",
+            success &= fs_pub.SetLongLong("stat.health.redundancy_factor",
                                                strtoll(health["redundancy_factor"].c_str(), 0, 10));
           }
           long long r_open = (long long) gOFS.openedForReading.getOpenOnFilesystem(fsid);
           long long w_open = (long long) gOFS.openedForWriting.getOpenOnFilesystem(fsid);
-          success &= mFsVect[i]->SetLongLong("stat.ropen", r_open);
-          success &= mFsVect[i]->SetLongLong("stat.wopen", w_open);
-          success &= mFsVect[i]->SetLongLong("stat.statfs.freebytes",
+          success &= fs_pub.SetLongLong("stat.ropen", r_open);
+          success &= fs_pub.SetLongLong("stat.wopen", w_open);
+          success &= fs_pub.SetLongLong("stat.statfs.freebytes",
                                              mFsVect[i]->GetLongLong("stat.statfs.bfree") *
                                              mFsVect[i]->GetLongLong("stat.statfs.bsize"));
-          success &= mFsVect[i]->SetLongLong("stat.statfs.usedbytes",
+          success &= fs_pub.SetLongLong("stat.statfs.usedbytes",
                                              (mFsVect[i]->GetLongLong("stat.statfs.blocks") -
                                               mFsVect[i]->GetLongLong("stat.statfs.bfree")) *
                                              mFsVect[i]->GetLongLong("stat.statfs.bsize"));
-          success &= mFsVect[i]->SetDouble("stat.statfs.filled",
+          success &= fs_pub.SetDouble("stat.statfs.filled",
                                            100.0 * ((mFsVect[i]->GetLongLong("stat.statfs.blocks") -
                                                mFsVect[i]->GetLongLong("stat.statfs.bfree"))) /
                                            (1 + mFsVect[i]->GetLongLong("stat.statfs.blocks")));
-          success &= mFsVect[i]->SetLongLong("stat.statfs.capacity",
+          success &= fs_pub.SetLongLong("stat.statfs.capacity",
                                              mFsVect[i]->GetLongLong("stat.statfs.blocks") *
                                              mFsVect[i]->GetLongLong("stat.statfs.bsize"));
-          success &= mFsVect[i]->SetLongLong("stat.statfs.fused",
+          success &= fs_pub.SetLongLong("stat.statfs.fused",
                                              (mFsVect[i]->GetLongLong("stat.statfs.files") -
                                               mFsVect[i]->GetLongLong("stat.statfs.ffree")) *
                                              mFsVect[i]->GetLongLong("stat.statfs.bsize"));
-          success &= mFsVect[i]->SetLongLong("stat.usedfiles",
+          success &= fs_pub.SetLongLong("stat.usedfiles",
                                              gFmdDbMapHandler.GetNumFiles(fsid));
-          success &= mFsVect[i]->SetString("stat.boot",
+          success &= fs_pub.SetLongLong("stat.deletions.queued",
+                                             GetNumDeletions(fsid));
+          FmdDbMapHandler::CommitStats commit_stats =
+            gFmdDbMapHandler.CollectCommitStats(fsid);
+          success &= fs_pub.SetDouble("stat.fmd.batchsize",
+                                           commit_stats.mBatchSize);
+          success &= fs_pub.SetDouble("stat.fmd.commitlatency",
+                                           commit_stats.mCommitLatency);
+          success &= fs_pub.SetDouble("stat.fmd.flushlatency",
+                                           commit_stats.mFlushLatency);
+          success &= fs_pub.SetString("stat.boot",
                                            mFsVect[i]->GetStatusAsString(mFsVect[i]->GetStatus()));
-          success &= mFsVect[i]->SetString("stat.geotag", lNodeGeoTag.c_str());
-          success &= mFsVect[i]->SetLongLong("stat.publishtimestamp",
+          success &= fs_pub.SetString("stat.geotag", lNodeGeoTag.c_str());
+          success &= fs_pub.SetLongLong("stat.publishtimestamp",
                                              eos::common::getEpochInMilliseconds().count());
-          success &= mFsVect[i]->SetLongLong("stat.drainer.running",
+          success &= fs_pub.SetLongLong("stat.drainer.running",
                                              mFsVect[i]->GetDrainQueue()->GetRunningAndQueued());
-          success &= mFsVect[i]->SetLongLong("stat.balancer.running",
+          success &= fs_pub.SetLongLong("stat.balancer.running",
                                              mFsVect[i]->GetBalanceQueue()->GetRunningAndQueued());
-          success &= mFsVect[i]->SetLongLong("stat.disk.iops",
+          success &= fs_pub.SetDouble("stat.drainer.throughput",
+                                           mFsVect[i]->GetDrainQueue()->GetThroughput());
+          success &= fs_pub.SetDouble("stat.balancer.throughput",
+                                           mFsVect[i]->GetBalanceQueue()->GetThroughput());
+          success &= fs_pub.SetLongLong("stat.disk.iops",
                                              mFsVect[i]->getIOPS());
-          success &= mFsVect[i]->SetDouble("stat.disk.bw",
+          success &= fs_pub.SetDouble("stat.disk.bw",
                                            mFsVect[i]->getSeqBandwidth()); // in MB
-          success &= mFsVect[i]->SetLongLong("stat.http.port", gOFS.mHttpdPort);
+          success &= fs_pub.SetLongLong("stat.http.port", gOFS.mHttpdPort);
           // Copy out hot file list
-          success &= mFsVect[i]->SetString("stat.ropen.hotfiles",
+          success &= fs_pub.SetString("stat.ropen.hotfiles",
                                            r_open_hotfiles.c_str());
-          success &= mFsVect[i]->SetString("stat.wopen.hotfiles",
+          success &= fs_pub.SetString("stat.wopen.hotfiles",
                                            w_open_hotfiles.c_str());
+          success &= fs_pub.SetString("stat.ropen.hotio", r_hotio.c_str());
+          success &= fs_pub.SetString("stat.wopen.hotio", w_hotio.c_str());
           CheckFilesystemFullness(i, fsid);
 
           if (!success) {
@@ -454,18 +639,20 @@ Storage::Publish(ThreadAssistant& assistant)
         }
 
         {
-          std::map<std::string, std::string> fstStats = getFSTStatistics(tmp_name,
-              netspeed);
+          std::map<std::string, std::string> fstStats = getFSTStatistics(netspeed);
+          std::string node_queue =
+            Config::gConfig.getFstNodeConfigQueue("Publish").c_str();
           // set node status values
           gOFS.ObjectManager.HashMutex.LockRead();
           // we received a new symkey
-          XrdMqSharedHash* hash = gOFS.ObjectManager.GetObject(
-                                    Config::gConfig.getFstNodeConfigQueue("Publish").c_str(),
-                                    "hash");
+          XrdMqSharedHash* hash = gOFS.ObjectManager.GetObject(node_queue.c_str(),
+                                  "hash");
 
           if (hash) {
             for (auto it = fstStats.begin(); it != fstStats.end(); it++) {
-              hash->Set(it->first.c_str(), it->second.c_str());
+              if (filter.Changed(node_queue, it->first, it->second)) {
+                hash->Set(it->first.c_str(), it->second.c_str());
+              }
             }
           }
 
@@ -492,8 +679,6 @@ Storage::Publish(ThreadAssistant& assistant)
       assistant.wait_for(sleepTime);
     }
   }
-
-  (void) unlink(tmp_name.c_str());
 }
 
 //------------------------------------------------------------------------------
@@ -513,27 +698,16 @@ void Storage::QdbPublishNodeStats(const QdbContactDetails& cd,
   //----------------------------------------------------------------------------
   // Setup required variables..
   //----------------------------------------------------------------------------
-  std::string tmp_name = makeTemporaryFile();
-  unsigned long long netspeed = getNetspeed(tmp_name);
-
-  if (tmp_name.empty()) {
-    return;
-  }
+  unsigned long long netspeed = getNetspeed();
 
   //----------------------------------------------------------------------------
   // Main loop
   //----------------------------------------------------------------------------
   while (!assistant.terminationRequested()) {
-    std::map<std::string, std::string> fstStats = getFSTStatistics(tmp_name,
-        netspeed);
+    std::map<std::string, std::string> fstStats = getFSTStatistics(netspeed);
     qcl->exec("publish", channel, qclient::Formatting::serialize(fstStats));
     assistant.wait_for(eos::fst::Config::gConfig.getRandomizedPublishInterval());
   }
-
-  //----------------------------------------------------------------------------
-  // Cleanup temporary file
-  //----------------------------------------------------------------------------
-  (void) unlink(tmp_name.c_str());
 }
 
 EOSFSTNAMESPACE_END
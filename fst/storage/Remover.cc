@@ -24,6 +24,8 @@
 #include "fst/storage/Storage.hh"
 #include "fst/XrdFstOfs.hh"
 #include "fst/Deletion.hh"
+#include "fst/FmdDbMap.hh"
+#include "fst/utils/IoPriority.hh"
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -35,7 +37,6 @@ Storage::Remover()
   static int deletionInterval = 300;
   std::string nodeconfigqueue =
     eos::fst::Config::gConfig.getFstNodeConfigQueue("Remover").c_str();
-  std::unique_ptr<Deletion> to_del {};
 
   if (getenv("EOS_FST_DELETE_QUERY_INTERVAL")) {
     try {
@@ -43,44 +44,9 @@ Storage::Remover()
     } catch (...) {}
   }
 
-  // Thread that unlinks stored files
+  // Thread asking the manager for deletions, the files are unlinked by the
+  // deletion threads of each filesystem
   while (true) {
-    while ((to_del = GetDeletion())) {
-      eos_static_debug("%u files to delete", GetNumDeletions());
-
-      for (unsigned int j = 0; j < to_del->fIdVector.size(); ++j) {
-        eos_static_debug("Deleting file_id=%llu on fs_id=%u", to_del->fIdVector[j],
-                         to_del->fsId);
-        XrdOucString hexstring = "";
-        eos::common::FileId::Fid2Hex(to_del->fIdVector[j], hexstring);
-        XrdOucErrInfo error;
-        XrdOucString capOpaqueString = "/?mgm.pcmd=drop";
-        XrdOucString OpaqueString = "";
-        OpaqueString += "&mgm.fsid=";
-        OpaqueString += (int) to_del->fsId;
-        OpaqueString += "&mgm.fid=";
-        OpaqueString += hexstring;
-        OpaqueString += "&mgm.localprefix=";
-        OpaqueString += to_del->localPrefix;
-        XrdOucEnv Opaque(OpaqueString.c_str());
-        capOpaqueString += OpaqueString;
-
-        if ((gOFS._rem("/DELETION", error, (const XrdSecEntity*) 0, &Opaque,
-                       0, 0, 0, true) != SFS_OK)) {
-          eos_static_warning("unable to remove fid %s fsid %lu localprefix=%s",
-                             hexstring.c_str(), to_del->fsId, to_del->localPrefix.c_str());
-        }
-
-        // Update the manager
-        int rc = gOFS.CallManager(&error, 0, 0 , capOpaqueString);
-
-        if (rc) {
-          eos_static_err("unable to drop file id %s fsid %u at manager %s",
-                         hexstring.c_str(), to_del->fsId, to_del->managerId.c_str());
-        }
-      }
-    }
-
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
     time_t now = time(NULL);
 
@@ -122,4 +88,80 @@ Storage::Remover()
   }
 }
 
+/*----------------------------------------------------------------------------*/
+void
+Storage::Deleter(eos::common::FileSystem::fsid_t fsid)
+{
+  std::unique_ptr<Deletion> to_del {};
+  IoPriority::SetThreadClass(IoPriority::kDelete);
+
+  // Thread that unlinks stored files of one filesystem
+  while (true) {
+    if ((to_del = GetDeletion(fsid))) {
+      eos_static_debug("fsid=%u %u files to delete", fsid,
+                       GetNumDeletions(fsid));
+      ProcessDeletion(*to_del);
+    }
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+void
+Storage::ProcessDeletion(const Deletion& del)
+{
+  std::vector<eos::common::FileId::fileid_t> removed;
+  removed.reserve(del.fIdVector.size());
+
+  for (unsigned int j = 0; j < del.fIdVector.size(); ++j) {
+    eos_static_debug("Deleting file_id=%llu on fs_id=%u", del.fIdVector[j],
+                     del.fsId);
+    XrdOucString hexstring = "";
+    eos::common::FileId::Fid2Hex(del.fIdVector[j], hexstring);
+    XrdOucErrInfo error;
+    XrdOucString OpaqueString = "";
+    OpaqueString += "&mgm.fsid=";
+    OpaqueString += (int) del.fsId;
+    OpaqueString += "&mgm.fid=";
+    OpaqueString += hexstring;
+    OpaqueString += "&mgm.localprefix=";
+    OpaqueString += del.localPrefix;
+    XrdOucEnv Opaque(OpaqueString.c_str());
+
+    // The local metadata records are deleted below in one batch
+    if ((gOFS._rem("/DELETION", error, (const XrdSecEntity*) 0, &Opaque,
+                   0, 0, 0, true, false) != SFS_OK)) {
+      eos_static_warning("unable to remove fid %s fsid %lu localprefix=%s",
+                         hexstring.c_str(), del.fsId, del.localPrefix.c_str());
+    } else {
+      removed.push_back(del.fIdVector[j]);
+    }
+  }
+
+  if (removed.size() &&
+      (gFmdDbMapHandler.LocalDeleteFmds(removed, del.fsId) != removed.size())) {
+    eos_static_notice("msg=\"unable to delete some fmd records\" fsid=%lu "
+                      "nfiles=%lu", del.fsId, (unsigned long) removed.size());
+  }
+
+  // Update the manager
+  for (unsigned int j = 0; j < del.fIdVector.size(); ++j) {
+    XrdOucString hexstring = "";
+    eos::common::FileId::Fid2Hex(del.fIdVector[j], hexstring);
+    XrdOucErrInfo error;
+    XrdOucString capOpaqueString = "/?mgm.pcmd=drop";
+    capOpaqueString += "&mgm.fsid=";
+    capOpaqueString += (int) del.fsId;
+    capOpaqueString += "&mgm.fid=";
+    capOpaqueString += hexstring;
+    capOpaqueString += "&mgm.localprefix=";
+    capOpaqueString += del.localPrefix;
+    int rc = gOFS.CallManager(&error, 0, 0 , capOpaqueString);
+
+    if (rc) {
+      eos_static_err("unable to drop file id %s fsid %u at manager %s",
+                     hexstring.c_str(), del.fsId, del.managerId.c_str());
+    }
+  }
+}
+
 EOSFSTNAMESPACE_END
@@ -23,6 +23,7 @@
 
 #include "fst/storage/Storage.hh"
 #include "fst/storage/FileSystem.hh"
+#include "fst/utils/IoPriority.hh"
 #include <fcntl.h>
 
 #ifdef __APPLE__
@@ -46,6 +47,8 @@ Storage::Scrub()
   }
 
   eos_static_info("Start Scrubbing ...");
+  // the scrub IO only runs when the disks are idle by default
+  IoPriority::SetThreadClass(IoPriority::kScrub);
 
   // this thread reads the oldest files and checks their integrity
   while (1) {
@@ -77,6 +80,7 @@ Storage::Scrub()
         bool direct_io = (mFsVect[i]->GetStatfs()->GetStatfs()->f_type !=
                           0x2fc12fc1);
         unsigned long id = mFsVect[i]->GetId();
+        IoThrottle* throttle = &mFsVect[i]->GetIoThrottle(IoPriority::kScrub);
         eos::common::FileSystem::fsstatus_t bootstatus =
           mFsVect[i]->GetStatus();
         eos::common::FileSystem::fsstatus_t configstatus =
@@ -112,7 +116,7 @@ Storage::Scrub()
           continue;
         }
 
-        if (ScrubFs(path.c_str(), free, blocks, id, direct_io)) {
+        if (ScrubFs(path.c_str(), free, blocks, id, direct_io, throttle)) {
           // filesystem has errors!
           mFsMutex.LockRead();
 
@@ -142,7 +146,8 @@ Storage::Scrub()
 //------------------------------------------------------------------------------
 int
 Storage::ScrubFs(const char* path, unsigned long long free,
-                 unsigned long long blocks, unsigned long id, bool direct_io)
+                 unsigned long long blocks, unsigned long id, bool direct_io,
+                 IoThrottle* throttle)
 {
   int MB = 1; // the test files have 1 MB
   int index = 10 - (int)(10.0 * free / blocks);
@@ -192,6 +197,10 @@ Storage::ScrubFs(const char* path, unsigned long long free,
         eos_static_debug("rshift is %d", rshift);
 
         for (int i = 0; i < MB; i++) {
+          if (throttle) {
+            throttle->Acquire(1024 * 1024);
+          }
+
           int nwrite = write(ff, mScrubPattern[rshift], 1024 * 1024);
 
           if (nwrite != (1024 * 1024)) {
@@ -220,6 +229,10 @@ Storage::ScrubFs(const char* path, unsigned long long free,
       int eberrors = 0;
 
       for (int i = 0; i < MB; i++) {
+        if (throttle) {
+          throttle->Acquire(1024 * 1024);
+        }
+
         int nread = read(ff, mScrubPatternVerify, 1024 * 1024);
 
         if (nread != (1024 * 1024)) {
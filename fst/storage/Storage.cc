@@ -37,6 +37,9 @@
 #include "MonitorVarPartition.hh"
 #include <google/dense_hash_map>
 #include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
 #include "fst/XrdFstOss.hh"
 
 extern eos::fst::XrdFstOss* XrdOfsOss;
@@ -84,6 +87,16 @@ Storage::Storage(const char* meta_dir)
   }
 
   mMetaDir = meta_dir;
+  mFsckSeq = 0;
+  {
+    std::random_device rd;
+    char epoch[64];
+    snprintf(epoch, sizeof(epoch), "%llx%08x", (unsigned long long)
+             std::chrono::duration_cast<std::chrono::microseconds>
+             (std::chrono::system_clock::now().time_since_epoch()).count(),
+             (unsigned int) rd());
+    mFsckEpoch = epoch;
+  }
 
   // Check if the meta directory is accessible
   if (access(meta_dir, R_OK | W_OK | X_OK)) {
@@ -158,16 +171,6 @@ Storage::Storage(const char* meta_dir)
     mZombie = true;
   }
 
-  mThreadSet.insert(tid);
-  eos_info("starting verification thread");
-
-  if ((rc = XrdSysThread::Run(&tid, Storage::StartFsVerify,
-                              static_cast<void*>(this),
-                              0, "Verify Thread"))) {
-    eos_crit("cannot start verify thread");
-    mZombie = true;
-  }
-
   mThreadSet.insert(tid);
   eos_info("starting filesystem communication thread");
   mCommunicatorThread.reset(&Storage::Communicator, this);
@@ -299,20 +302,99 @@ Storage::ShutdownThreads()
 }
 
 //------------------------------------------------------------------------------
-// Push new verification job to the queue if the maximum number of pending
-// verifications is not exceeded.
+// Push new verification job to the queue of its filesystem if the maximum
+// number of pending verifications is not exceeded.
 //------------------------------------------------------------------------------
 void
 Storage::PushVerification(eos::fst::Verify* entry)
 {
-  XrdSysMutexHelper scope_lock(mVerifyMutex);
+  std::unique_ptr<eos::fst::Verify> verify(entry);
+  XrdSysCondVarHelper scope_lock(mVerifyCond);
 
-  if (mVerifications.size() < 1000000) {
-    mVerifications.push(entry);
-    entry->Show();
-  } else {
+  if (mNumVerifications >= 1000000) {
     eos_err("verify list has already 1 Mio. entries - discarding verify message");
+    return;
+  }
+
+  auto it = mVerifyQueues.find(entry->fsId);
+
+  if (it == mVerifyQueues.end()) {
+    it = mVerifyQueues.emplace(entry->fsId, VerifyQueue()).first;
+    RunVerifyThreads(entry->fsId);
+  }
+
+  entry->Show();
+
+  if (entry->background) {
+    it->second.mBackground.push_back(std::move(verify));
+  } else {
+    it->second.mUser.push_back(std::move(verify));
+  }
+
+  ++mNumVerifications;
+  mVerifyCond.Broadcast();
+}
+
+//------------------------------------------------------------------------------
+// Get verification job of a filesystem removing it from the queue
+//------------------------------------------------------------------------------
+std::unique_ptr<eos::fst::Verify>
+Storage::GetVerification(eos::common::FileSystem::fsid_t fsid)
+{
+  std::unique_ptr<eos::fst::Verify> verify;
+  XrdSysCondVarHelper scope_lock(mVerifyCond);
+  VerifyQueue& queue = mVerifyQueues[fsid];
+
+  if (queue.mUser.empty() && queue.mBackground.empty()) {
+    mVerifyCond.Wait(1);
+  }
+
+  std::deque< std::unique_ptr<eos::fst::Verify> >* pendings[] = {
+    &queue.mUser, &queue.mBackground
+  };
+
+  // Files open for writing go back to the end of their queue
+  for (auto pending : pendings) {
+    for (size_t n = pending->size(); n; --n) {
+      verify.swap(pending->front());
+      pending->pop_front();
+
+      if (!gOFS.openedForWriting.isOpen(verify->fsId, verify->fId)) {
+        --mNumVerifications;
+        queue.mOpenWarned.erase(verify->fId);
+        return verify;
+      }
+
+      time_t now = time(NULL);
+
+      if (queue.mOpenWarned[verify->fId] < now) {
+        eos_static_warning("file is currently opened for writing id=%x on "
+                           "fs=%u - skipping verification", verify->fId,
+                           verify->fsId);
+        // Spit this message out only once per minute
+        queue.mOpenWarned[verify->fId] = now + 60;
+      }
+
+      pending->push_back(std::move(verify));
+    }
+  }
+
+  // Only files open for writing are pending, don't spin on them
+  if (mNumVerifications) {
+    mVerifyCond.Wait(1);
   }
+
+  return verify;
+}
+
+//------------------------------------------------------------------------------
+// Get number of pending verifications
+//------------------------------------------------------------------------------
+size_t
+Storage::GetNumVerifications()
+{
+  XrdSysCondVarHelper scope_lock(mVerifyCond);
+  return mNumVerifications;
 }
 
 //------------------------------------------------------------------------------
@@ -418,13 +500,23 @@ Storage::Boot(FileSystem* fs)
   }
 
   // Attach to the local DB
-  if (!gFmdDbMapHandler.SetDBFile(mMetaDir.c_str(), fsid)) {
+  if (!gFmdDbMapHandler.SetDBFile(mMetaDir.c_str(), fsid,
+                                  FmdDbMapHandler::GetStoreTypeFromString(
+                                    fs->GetString("fmdstore")))) {
     fs->SetStatus(eos::common::FileSystem::kBootFailure);
     fs->SetError(EFAULT, "cannot set DB filename - see the fst logfile "
                  "for details");
     return;
   }
 
+  gFmdDbMapHandler.SetCommitMode(fsid, FmdDbMapHandler::GetCommitModeFromString(
+                                   fs->GetString("fmdcommit")));
+
+  for (int i = 0; i < IoPriority::kNumClasses; ++i) {
+    fs->ConfigIoBandwidth(std::string("iobw.") +
+                          IoPriority::GetName(static_cast<IoPriority::Class>(i)));
+  }
+
   bool resyncmgm = (fs->GetLongLong("bootcheck") ==
                     eos::common::FileSystem::kBootResync);
   bool resyncdisk = (fs->GetLongLong("bootcheck") >=
@@ -462,8 +554,14 @@ Storage::Boot(FileSystem* fs)
     if (!gOFS.mQdbContactDetails.empty()) {
       // Resync meta data connecting directly to QuarkDB
       eos_info("msg=\"synchronizing from QuarkDB backend\"");
-
-      if (!gFmdDbMapHandler.ResyncAllFromQdb(gOFS.mQdbContactDetails, fsid)) {
+      // Publish the percentage of files resynced while booting
+      auto progress = [fs](uint64_t done, uint64_t total) {
+        fs->SetDouble("stat.bootprogress",
+                      (total ? std::min(100.0, 100.0 * done / total) : 100.0));
+      };
+
+      if (!gFmdDbMapHandler.ResyncAllFromQdb(gOFS.mQdbContactDetails, fsid,
+                                             progress)) {
         fs->SetStatus(eos::common::FileSystem::kBootFailure);
         fs->SetError(EFAULT, "cannot resync meta data from QuarkDB");
         return;
@@ -606,6 +704,20 @@ Storage::StartFsRemover(void* pp)
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Start deletion thread of a filesystem
+//------------------------------------------------------------------------------
+void*
+Storage::StartFsDeleter(void* pp)
+{
+  DeletionThreadInfo* info = (DeletionThreadInfo*) pp;
+  Storage* storage = info->storage;
+  eos::common::FileSystem::fsid_t fsid = info->fsid;
+  delete info;
+  storage->Deleter(fsid);
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 // Start reporter thread
 //------------------------------------------------------------------------------
@@ -629,13 +741,16 @@ Storage::StartFsErrorReport(void* pp)
 }
 
 //------------------------------------------------------------------------------
-// Start verification thread
+// Start verification thread of a filesystem
 //------------------------------------------------------------------------------
 void*
 Storage::StartFsVerify(void* pp)
 {
-  Storage* storage = (Storage*) pp;
-  storage->Verify();
+  VerifyThreadInfo* info = (VerifyThreadInfo*) pp;
+  Storage* storage = info->storage;
+  eos::common::FileSystem::fsid_t fsid = info->fsid;
+  delete info;
+  storage->Verify(fsid);
   return 0;
 }
 
@@ -801,27 +916,43 @@ Storage::CloseTransaction(unsigned int fsid, unsigned long long fid)
 }
 
 //------------------------------------------------------------------------------
-// Add deletion to the list of pending ones
+// Add deletion to the queue of pending ones of its filesystem
 //------------------------------------------------------------------------------
 void
 Storage::AddDeletion(std::unique_ptr<Deletion> del)
 {
-  XrdSysMutexHelper scope_lock(mDeletionsMutex);
-  mListDeletions.push_front(std::move(del));
+  eos::common::FileSystem::fsid_t fsid = del->fsId;
+  XrdSysCondVarHelper scope_lock(mDeletionsCond);
+  auto it = mDeletionQueues.find(fsid);
+
+  if (it == mDeletionQueues.end()) {
+    it = mDeletionQueues.emplace(fsid, DeletionQueue()).first;
+    RunDeletionThreads(fsid);
+  }
+
+  it->second.mNumFiles += del->fIdVector.size();
+  it->second.mDeletions.push_front(std::move(del));
+  mDeletionsCond.Broadcast();
 }
 
 //------------------------------------------------------------------------------
-// Get deletion object removing it from the list
+// Get deletion object of a filesystem removing it from the queue
 //------------------------------------------------------------------------------
 std::unique_ptr<Deletion>
-Storage::GetDeletion()
+Storage::GetDeletion(eos::common::FileSystem::fsid_t fsid)
 {
   std::unique_ptr<Deletion> del;
-  XrdSysMutexHelper scope_lock(mDeletionsMutex);
+  XrdSysCondVarHelper scope_lock(mDeletionsCond);
+  DeletionQueue& queue = mDeletionQueues[fsid];
+
+  if (queue.mDeletions.empty()) {
+    mDeletionsCond.Wait(1);
+  }
 
-  if (mListDeletions.size()) {
-    del.swap(mListDeletions.back());
-    mListDeletions.pop_back();
+  if (queue.mDeletions.size()) {
+    del.swap(queue.mDeletions.back());
+    queue.mDeletions.pop_back();
+    queue.mNumFiles -= del->fIdVector.size();
   }
 
   return del;
@@ -834,15 +965,90 @@ size_t
 Storage::GetNumDeletions()
 {
   size_t total = 0;
-  XrdSysMutexHelper scope_lock(mDeletionsMutex);
+  XrdSysCondVarHelper scope_lock(mDeletionsCond);
 
-  for (auto it = mListDeletions.cbegin(); it != mListDeletions.cend(); ++it) {
-    total += (*it)->fIdVector.size();
+  for (auto it = mDeletionQueues.cbegin(); it != mDeletionQueues.cend(); ++it) {
+    total += it->second.mNumFiles;
   }
 
   return total;
 }
 
+//------------------------------------------------------------------------------
+// Get number of pending deletions of a filesystem
+//------------------------------------------------------------------------------
+size_t
+Storage::GetNumDeletions(eos::common::FileSystem::fsid_t fsid)
+{
+  XrdSysCondVarHelper scope_lock(mDeletionsCond);
+  auto it = mDeletionQueues.find(fsid);
+  return ((it != mDeletionQueues.end()) ? it->second.mNumFiles : 0);
+}
+
+//------------------------------------------------------------------------------
+// Start the deletion threads of a filesystem
+//------------------------------------------------------------------------------
+void
+Storage::RunDeletionThreads(eos::common::FileSystem::fsid_t fsid)
+{
+  static int nthreads = []() {
+    const char* ptr = getenv("EOS_FST_DELETE_THREADS_PER_FS");
+    int val = (ptr ? atoi(ptr) : 0);
+    return ((val > 0) ? val : 2);
+  }();
+
+  for (int i = 0; i < nthreads; ++i) {
+    DeletionThreadInfo* info = new DeletionThreadInfo;
+    info->storage = this;
+    info->fsid = fsid;
+    pthread_t tid;
+
+    if ((XrdSysThread::Run(&tid, Storage::StartFsDeleter,
+                           static_cast<void*>(info), 0, "Deleter"))) {
+      eos_crit("msg=\"cannot start deletion thread\" fsid=%u", fsid);
+      delete info;
+    } else {
+      XrdSysMutexHelper tsLock(mThreadsMutex);
+      mThreadSet.insert(tid);
+    }
+  }
+
+  eos_notice("msg=\"started deletion threads\" fsid=%u nthreads=%d", fsid,
+             nthreads);
+}
+
+//------------------------------------------------------------------------------
+// Start the verify threads of a filesystem
+//------------------------------------------------------------------------------
+void
+Storage::RunVerifyThreads(eos::common::FileSystem::fsid_t fsid)
+{
+  static int nthreads = []() {
+    const char* ptr = getenv("EOS_FST_VERIFY_THREADS_PER_FS");
+    int val = (ptr ? atoi(ptr) : 0);
+    return ((val > 0) ? val : 2);
+  }();
+
+  for (int i = 0; i < nthreads; ++i) {
+    VerifyThreadInfo* info = new VerifyThreadInfo;
+    info->storage = this;
+    info->fsid = fsid;
+    pthread_t tid;
+
+    if ((XrdSysThread::Run(&tid, Storage::StartFsVerify,
+                           static_cast<void*>(info), 0, "Verify Thread"))) {
+      eos_crit("msg=\"cannot start verify thread\" fsid=%u", fsid);
+      delete info;
+    } else {
+      XrdSysMutexHelper tsLock(mThreadsMutex);
+      mThreadSet.insert(tid);
+    }
+  }
+
+  eos_notice("msg=\"started verify threads\" fsid=%u nthreads=%d", fsid,
+             nthreads);
+}
+
 //------------------------------------------------------------------------------
 // Get the filesystem associated with the given filesystem id
 //------------------------------------------------------------------------------
@@ -33,9 +33,11 @@
 #include "fst/Load.hh"
 #include "fst/Health.hh"
 #include "fst/txqueue/TransferMultiplexer.hh"
+#include <atomic>
 #include <vector>
 #include <list>
 #include <queue>
+#include <deque>
 #include <map>
 
 namespace eos
@@ -49,6 +51,7 @@ class TransferQueue;
 EOSFSTNAMESPACE_BEGIN
 
 class Verify;
+class IoThrottle;
 class Deletion;
 class FileSystem;
 
@@ -85,26 +88,39 @@ public:
   void ShutdownThreads();
 
   //----------------------------------------------------------------------------
-  //! Add deletion object to the list of pending ones
+  //! Add deletion object to the queue of pending ones of its filesystem,
+  //! starting the deletion threads of the filesystem if needed
   //!
   //! @param del deletion object
   //----------------------------------------------------------------------------
   void AddDeletion(std::unique_ptr<Deletion> del);
 
   //----------------------------------------------------------------------------
-  //! Get deletion object removing it from the list
+  //! Get deletion object of a filesystem removing it from the queue, waits
+  //! up to one second for a deletion to arrive
   //!
-  //! @return get deletion object
+  //! @param fsid filesystem id
+  //!
+  //! @return get deletion object or null if there is none
   //----------------------------------------------------------------------------
-  std::unique_ptr<Deletion> GetDeletion();
+  std::unique_ptr<Deletion> GetDeletion(eos::common::FileSystem::fsid_t fsid);
 
   //----------------------------------------------------------------------------
   //! Get number of pending deletions
   //!
-  //! @return number of pending deletions
+  //! @return number of files pending deletion on all filesystems
   //----------------------------------------------------------------------------
   size_t GetNumDeletions();
 
+  //----------------------------------------------------------------------------
+  //! Get number of pending deletions of a filesystem
+  //!
+  //! @param fsid filesystem id
+  //!
+  //! @return number of files pending deletion on the filesystem
+  //----------------------------------------------------------------------------
+  size_t GetNumDeletions(eos::common::FileSystem::fsid_t fsid);
+
   //----------------------------------------------------------------------------
   //! Get the filesystem associated with the given filesystem id
   //! or NULL if none could be found
@@ -138,13 +154,32 @@ public:
                         unsigned long long fid);
 
   //----------------------------------------------------------------------------
-  //! Push new verification job to the queue if the maximum number of pending
-  //! verifications is not exceeded.
+  //! Push new verification job to the queue of its filesystem if the maximum
+  //! number of pending verifications is not exceeded, starting the verify
+  //! threads of the filesystem if needed. The user requested verifications
+  //! are served before the background ones sent by fsck.
   //!
-  //! @param entry verification information about a file
+  //! @param entry verification information about a file, owned by the queue
   //----------------------------------------------------------------------------
   void PushVerification(eos::fst::Verify* entry);
 
+  //----------------------------------------------------------------------------
+  //! Get verification job of a filesystem removing it from the queue, waits
+  //! up to one second for a job to arrive. Files currently open for writing
+  //! are skipped and stay queued.
+  //!
+  //! @param fsid filesystem id
+  //!
+  //! @return verification job or null if there is none
+  //----------------------------------------------------------------------------
+  std::unique_ptr<eos::fst::Verify>
+  GetVerification(eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Get number of pending verifications
+  //----------------------------------------------------------------------------
+  size_t GetNumVerifications();
+
 protected:
   eos::common::RWMutex mFsMutex; ///< Mutex protecting access to the fs map
   std::vector <FileSystem*> mFsVect; ///< Vector of filesystems
@@ -168,7 +203,11 @@ private:
   XrdSysMutex mBootingMutex; // Mutex protecting the boot set
   //! Set containing the filesystems currently booting
   std::set<eos::common::FileSystem::fsid_t> mBootingSet;
-  eos::fst::Verify* mRunningVerify; ///< Currently running verification job
+  //! Sequence number of the last change of any fsck inconsistency set
+  std::atomic<uint64_t> mFsckSeq;
+  //! Identifier of this process in the fsck change feed, a restarted FST
+  //! has lost its feed and answers with the full sets
+  std::string mFsckEpoch;
   XrdSysMutex mThreadsMutex; ///< Mutex protecting access to the set of threads
   std::set<pthread_t> mThreadSet; ///< Set of running helper threads
   XrdSysMutex mFsFullMapMutex; ///< Mutex protecting access to the fs full map
@@ -177,11 +216,33 @@ private:
   //! Map indicating if a filesystem has less than (headroom) space free, which
   //! disables draining and balancing
   std::map<eos::common::FileSystem::fsid_t, bool> mFsFullWarnMap;
-  XrdSysMutex mVerifyMutex; ///< Mutex protecting access to the verifications
-  //! Queue of verification jobs pending
-  std::queue <eos::fst::Verify*> mVerifications;
-  XrdSysMutex mDeletionsMutex; ///< Mutex protecting the list of deletions
-  std::list< std::unique_ptr<Deletion> > mListDeletions; ///< List of deletions
+  //! Pending verifications of a filesystem, served by its own verify threads
+  struct VerifyQueue {
+    //! Verifications requested by users, served first
+    std::deque< std::unique_ptr<eos::fst::Verify> > mUser;
+    //! Background verifications e.g. sent by fsck
+    std::deque< std::unique_ptr<eos::fst::Verify> > mBackground;
+    //! Time until which a file open for writing is not reported again
+    std::map<unsigned long long, time_t> mOpenWarned;
+  };
+
+  //! Condition variable protecting the verify queues, signalled when a
+  //! verification is added
+  XrdSysCondVar mVerifyCond;
+  //! Map of filesystem id to pending verifications
+  std::map<eos::common::FileSystem::fsid_t, VerifyQueue> mVerifyQueues;
+  size_t mNumVerifications {0}; ///< Number of pending verifications
+  //! Pending deletions of a filesystem, served by its own deletion threads
+  struct DeletionQueue {
+    std::list< std::unique_ptr<Deletion> > mDeletions; ///< List of deletions
+    size_t mNumFiles {0}; ///< Number of files in the list of deletions
+  };
+
+  //! Condition variable protecting the deletion queues, signalled when a
+  //! deletion is added
+  XrdSysCondVar mDeletionsCond;
+  //! Map of filesystem id to pending deletions
+  std::map<eos::common::FileSystem::fsid_t, DeletionQueue> mDeletionQueues;
   Load mFstLoad; ///< Net/IO load monitor
   Health mFstHealth; ///< Local disk S.M.A.R.T monitor
 
@@ -191,6 +252,18 @@ private:
     FileSystem* filesystem;
   };
 
+  //! Struct DeletionThreadInfo
+  struct DeletionThreadInfo {
+    Storage* storage;
+    eos::common::FileSystem::fsid_t fsid;
+  };
+
+  //! Struct VerifyThreadInfo
+  struct VerifyThreadInfo {
+    Storage* storage;
+    eos::common::FileSystem::fsid_t fsid;
+  };
+
   //----------------------------------------------------------------------------
   //! Helper methods used for starting worker threads
   //----------------------------------------------------------------------------
@@ -200,6 +273,7 @@ private:
   static void* StartFsScrub(void* pp);
   static void* StartFsTrim(void* pp);
   static void* StartFsRemover(void* pp);
+  static void* StartFsDeleter(void* pp);
   static void* StartFsReport(void* pp);
   static void* StartFsErrorReport(void* pp);
   static void* StartFsVerify(void* pp);
@@ -213,7 +287,7 @@ private:
   //! Get statistics about this FST, used for publishing
   //----------------------------------------------------------------------------
   std::map<std::string, std::string> getFSTStatistics(
-    const std::string &tmpfile, unsigned long long netspeed);
+    unsigned long long netspeed);
 
   //----------------------------------------------------------------------------
   //! Worker threads implementation
@@ -225,9 +299,10 @@ private:
   void Scrub();
   void Trim();
   void Remover();
+  void Deleter(eos::common::FileSystem::fsid_t fsid);
   void Report();
   void ErrorReport();
-  void Verify();
+  void Verify(eos::common::FileSystem::fsid_t fsid);
   void Publish(ThreadAssistant &assistant);
 
   void QdbPublishFilesystemStats(
@@ -243,9 +318,12 @@ private:
 
   //----------------------------------------------------------------------------
   //! Scrub filesystem
+  //!
+  //! @param throttle bandwidth limit of the scrub IO on the filesystem
   //----------------------------------------------------------------------------
   int ScrubFs(const char* path, unsigned long long free,
-              unsigned long long lbocks, unsigned long id, bool direct_io);
+              unsigned long long lbocks, unsigned long id, bool direct_io,
+              IoThrottle* throttle = nullptr);
 
   //----------------------------------------------------------------------------
   //! Check if node is in zombie state i.e. true if any of the helper threads
@@ -257,6 +335,38 @@ private:
     return mZombie;
   }
 
+  //----------------------------------------------------------------------------
+  //! Start the deletion threads of a filesystem, the number of threads is
+  //! given by EOS_FST_DELETE_THREADS_PER_FS (default 2)
+  //!
+  //! @param fsid filesystem id
+  //----------------------------------------------------------------------------
+  void RunDeletionThreads(eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Start the verify threads of a filesystem, the number of threads is
+  //! given by EOS_FST_VERIFY_THREADS_PER_FS (default 2)
+  //!
+  //! @param fsid filesystem id
+  //----------------------------------------------------------------------------
+  void RunVerifyThreads(eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Verify a file: rescan its checksum if requested, update the local
+  //! metadata and commit the result to the manager
+  //!
+  //! @param verifyfile verification job
+  //----------------------------------------------------------------------------
+  void VerifyFile(eos::fst::Verify* verifyfile);
+
+  //----------------------------------------------------------------------------
+  //! Unlink the files of a deletion, delete their local metadata records in
+  //! one batch and acknowledge the deletions to the manager
+  //!
+  //! @param del deletion object
+  //----------------------------------------------------------------------------
+  void ProcessDeletion(const Deletion& del);
+
   //----------------------------------------------------------------------------
   //! Run boot thread for specified filesystem
   //!
@@ -295,6 +405,13 @@ private:
                   std::string uuid, bool fail_noid = false,
                   bool fail_nouuid = false);
 
+  //! Balance and drain jobs queued per transfer slot
+  static constexpr unsigned long long kSchedulingQueueFactor = 2;
+  //! Seconds an idle balancer or drainer waits in the manager for a job
+  static constexpr int kSchedulingWaitSec = 25;
+  //! Seconds added to the wait for the timeout of a long-polling request
+  static constexpr int kSchedulingTimeoutSec = 30;
+
   //----------------------------------------------------------------------------
   //! Balancer related methods
   //----------------------------------------------------------------------------
@@ -317,7 +434,9 @@ private:
                                   unsigned long long nparalleltx,
                                   unsigned long long ratetx);
 
-  bool GetBalanceJob(unsigned int index);
+  unsigned long long GetBalanceJob(unsigned long id,
+                                   unsigned long long freebytes,
+                                   unsigned long long njobs, int wait_sec);
 
   //----------------------------------------------------------------------------
   //! Drain related methods and attributes
@@ -376,13 +495,17 @@ private:
                                 unsigned long long ratetx);
 
   //----------------------------------------------------------------------------
-  //! Get drain job for the requested filesystem
+  //! Get a batch of drain jobs for the requested filesystem
   //!
-  //! @param index index in the filesystem vector
+  //! @param id filesystem id
+  //! @param freebytes free bytes of the filesystem
+  //! @param njobs max number of jobs to get
+  //! @param wait_sec seconds the manager waits for a job if none is available
   //!
-  //! @return true if scheduled otherwise false
+  //! @return number of jobs scheduled
   //----------------------------------------------------------------------------
-  bool GetDrainJob(unsigned int index);
+  unsigned long long GetDrainJob(unsigned long id, unsigned long long freebytes,
+                                 unsigned long long njobs, int wait_sec);
 
   //----------------------------------------------------------------------------
   //! Check if node is active i.e. the stat.active
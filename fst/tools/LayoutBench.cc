@@ -0,0 +1,688 @@
+//------------------------------------------------------------------------------
+//! @file LayoutBench.cc
+//! @brief Benchmark of the FST layouts and IO plugins driven directly, without
+//!        the OFS and the MGM
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/LayoutId.hh"
+#include "fst/checksum/ChecksumPlugins.hh"
+#include "fst/io/FileIoPlugin.hh"
+#include "fst/layout/PlainLayout.hh"
+#include "fst/layout/RaidDpLayout.hh"
+#include "fst/layout/ReedSLayout.hh"
+#include "XrdOuc/XrdOucEnv.hh"
+#include "XrdSfs/XrdSfsInterface.hh"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using eos::common::LayoutId;
+
+//------------------------------------------------------------------------------
+//! Benchmark configuration
+//------------------------------------------------------------------------------
+struct Options {
+  std::string mBase {"/tmp/eos-layout-bench"}; ///< directory or root:// url
+  std::vector<std::string> mLayouts {"plain", "replica", "raiddp", "reeds"};
+  std::vector<int> mStripes {6};
+  std::vector<uint64_t> mBlockSizes {1024 * 1024};
+  std::vector<std::string> mChecksums {"adler"};
+  std::vector<std::pair<uint32_t, uint32_t>> mReadV {{16, 4096}};
+  int mParity {2}; ///< parity stripes of reeds
+  uint64_t mStripeWidth {1024 * 1024};
+  uint64_t mFileSize {256 * 1024 * 1024};
+  size_t mReadVRequests {1000};
+};
+
+//------------------------------------------------------------------------------
+// Remove stripe or replica files through their IO plugin
+//------------------------------------------------------------------------------
+static void
+removeUrls(const std::vector<std::string>& urls)
+{
+  for (const auto& url : urls) {
+    std::unique_ptr<eos::fst::FileIo> file(
+      eos::fst::FileIoPlugin::GetIoObject(url));
+
+    // Remote files are marked for deletion and removed on close
+    if (file && !file->fileOpen(SFS_O_RDWR, 0, "")) {
+      (void) file->fileRemove();
+      (void) file->fileClose();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+//! Object under test, a layout or a fan out over replica IO objects
+//------------------------------------------------------------------------------
+class Target
+{
+public:
+  Target(const std::vector<std::string>& urls):
+    mUrls(urls)
+  {}
+
+  virtual ~Target() = default;
+  virtual bool Open(bool write) = 0;
+  virtual int64_t Write(uint64_t offset, const char* buffer, uint32_t len) = 0;
+  virtual int64_t Read(uint64_t offset, char* buffer, uint32_t len) = 0;
+  virtual int64_t ReadV(XrdCl::ChunkList& chunks, uint32_t len) = 0;
+  virtual bool Close() = 0;
+
+  void Remove()
+  {
+    removeUrls(mUrls);
+  }
+
+protected:
+  std::vector<std::string> mUrls; ///< stripe or replica files
+};
+
+//------------------------------------------------------------------------------
+//! Layout object opened on local or remote stripes
+//------------------------------------------------------------------------------
+class LayoutTarget: public Target
+{
+public:
+  LayoutTarget(const std::string& type, unsigned long lid,
+               const std::vector<std::string>& urls):
+    Target(urls), mType(type), mLid(lid)
+  {}
+
+  bool Open(bool write) override
+  {
+    XrdSfsFileOpenMode flags = (write ? (SFS_O_CREAT | SFS_O_RDWR) :
+                                SFS_O_RDONLY);
+    mode_t mode = S_IRUSR | S_IWUSR;
+
+    if (mType == "plain") {
+      mLayout.reset(new eos::fst::PlainLayout(nullptr, mLid, nullptr, nullptr,
+                                              mUrls[0].c_str()));
+      return (mLayout->Open(flags, mode, "") == SFS_OK);
+    }
+
+    eos::fst::RaidMetaLayout* rain = nullptr;
+
+    if (mType == "raiddp") {
+      rain = new eos::fst::RaidDpLayout(nullptr, mLid, nullptr, nullptr,
+                                        mUrls[0].c_str());
+    } else {
+      rain = new eos::fst::ReedSLayout(nullptr, mLid, nullptr, nullptr,
+                                       mUrls[0].c_str());
+    }
+
+    mLayout.reset(rain);
+    return (rain->OpenPio(mUrls, flags, mode) == SFS_OK);
+  }
+
+  int64_t Write(uint64_t offset, const char* buffer, uint32_t len) override
+  {
+    return mLayout->Write(offset, buffer, len);
+  }
+
+  int64_t Read(uint64_t offset, char* buffer, uint32_t len) override
+  {
+    return mLayout->Read(offset, buffer, len);
+  }
+
+  int64_t ReadV(XrdCl::ChunkList& chunks, uint32_t len) override
+  {
+    return mLayout->ReadV(chunks, len);
+  }
+
+  bool Close() override
+  {
+    int retc = mLayout->Close();
+    mLayout.reset();
+    return (retc == SFS_OK);
+  }
+
+private:
+  std::string mType;
+  unsigned long mLid;
+  std::unique_ptr<eos::fst::Layout> mLayout;
+};
+
+//------------------------------------------------------------------------------
+//! Replica fan out as done by ReplicaParLayout: every block is written
+//! asynchronously to all replicas, reads are served by the first one. The
+//! layout itself needs an OFS file for its replica urls, so its data path is
+//! reproduced on top of the IO objects.
+//------------------------------------------------------------------------------
+class ReplicaTarget: public Target
+{
+public:
+  ReplicaTarget(const std::vector<std::string>& urls):
+    Target(urls)
+  {}
+
+  bool Open(bool write) override
+  {
+    XrdSfsFileOpenMode flags = (write ? (SFS_O_CREAT | SFS_O_RDWR) :
+                                SFS_O_RDONLY);
+    size_t count = (write ? mUrls.size() : 1);
+
+    for (size_t i = 0; i < count; ++i) {
+      mFiles.emplace_back(eos::fst::FileIoPlugin::GetIoObject(mUrls[i]));
+
+      if (!mFiles.back() ||
+          mFiles.back()->fileOpen(flags, S_IRUSR | S_IWUSR, "")) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  int64_t Write(uint64_t offset, const char* buffer, uint32_t len) override
+  {
+    for (auto& file : mFiles) {
+      if (file->fileWriteAsync(offset, buffer, len) != len) {
+        return -1;
+      }
+    }
+
+    return len;
+  }
+
+  int64_t Read(uint64_t offset, char* buffer, uint32_t len) override
+  {
+    return mFiles[0]->fileRead(offset, buffer, len);
+  }
+
+  int64_t ReadV(XrdCl::ChunkList& chunks, uint32_t len) override
+  {
+    return mFiles[0]->fileReadV(chunks);
+  }
+
+  bool Close() override
+  {
+    bool ok = true;
+
+    for (auto& file : mFiles) {
+      ok = (!file->fileWaitAsyncIO() && !file->fileClose() && ok);
+    }
+
+    mFiles.clear();
+    return ok;
+  }
+
+private:
+  std::vector<std::unique_ptr<eos::fst::FileIo>> mFiles;
+};
+
+//------------------------------------------------------------------------------
+//! Wall time, CPU time and latency samples of a phase
+//------------------------------------------------------------------------------
+class PhaseStats
+{
+public:
+  PhaseStats():
+    mStart(std::chrono::steady_clock::now()), mCpuStart(CpuSeconds())
+  {}
+
+  void Add(std::chrono::steady_clock::duration elapsed)
+  {
+    mLatency.push_back(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Print the result as one JSON object
+  //----------------------------------------------------------------------------
+  void Print(const std::string& config, const char* phase, uint64_t bytes,
+             bool ok)
+  {
+    double wall = std::chrono::duration<double>
+                  (std::chrono::steady_clock::now() - mStart).count();
+    double cpu = CpuSeconds() - mCpuStart;
+    double gb = bytes / 1e9;
+    std::sort(mLatency.begin(), mLatency.end());
+    std::ostringstream oss;
+    oss << "{" << config << ", \"phase\": \"" << phase << "\", \"ok\": "
+        << (ok ? "true" : "false") << ", \"bytes\": " << bytes
+        << ", \"seconds\": " << wall
+        << ", \"mb_per_sec\": " << (wall > 0 ? bytes / wall / 1e6 : 0)
+        << ", \"cpu_sec_per_gb\": " << (gb > 0 ? cpu / gb : 0)
+        << ", \"ops\": " << mLatency.size()
+        << ", \"latency_us\": {\"p50\": " << Percentile(50)
+        << ", \"p99\": " << Percentile(99)
+        << ", \"p999\": " << Percentile(99.9)
+        << ", \"max\": " << Percentile(100) << "}}";
+    std::cout << oss.str() << std::endl;
+  }
+
+private:
+  static double CpuSeconds()
+  {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+            (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6);
+  }
+
+  double Percentile(double pct) const
+  {
+    if (mLatency.empty()) {
+      return 0;
+    }
+
+    size_t pos = static_cast<size_t>(pct / 100.0 * (mLatency.size() - 1) + 0.5);
+    return mLatency[std::min(pos, mLatency.size() - 1)] / 1000.0;
+  }
+
+  std::chrono::steady_clock::time_point mStart;
+  double mCpuStart;
+  std::vector<uint64_t> mLatency; ///< nanoseconds
+};
+
+//------------------------------------------------------------------------------
+// Parse a size with an optional k, M or G suffix
+//------------------------------------------------------------------------------
+static uint64_t
+parseSize(const std::string& value)
+{
+  size_t pos = 0;
+  uint64_t size = std::stoull(value, &pos);
+  std::string suffix = value.substr(pos);
+
+  if (suffix == "k" || suffix == "K") {
+    size *= 1024;
+  } else if (suffix == "m" || suffix == "M") {
+    size *= 1024 * 1024;
+  } else if (suffix == "g" || suffix == "G") {
+    size *= 1024 * 1024 * 1024ull;
+  } else if (!suffix.empty()) {
+    throw std::invalid_argument(value);
+  }
+
+  return size;
+}
+
+//------------------------------------------------------------------------------
+// Split a comma separated list
+//------------------------------------------------------------------------------
+static std::vector<std::string>
+splitList(const std::string& value)
+{
+  std::vector<std::string> items;
+  std::istringstream iss(value);
+  std::string item;
+
+  while (std::getline(iss, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+
+  return items;
+}
+
+//------------------------------------------------------------------------------
+// Run the write, read and readv phases for one configuration
+//------------------------------------------------------------------------------
+static void
+runConfig(const Options& opts, const std::string& layout, int stripes,
+          uint64_t block_size, const std::string& xs_name, size_t& run)
+{
+  XrdOucEnv xs_env(("eos.layout.checksum=" + xs_name).c_str());
+  unsigned long xs_type = LayoutId::GetChecksumFromEnv(xs_env);
+  std::vector<std::string> urls;
+  std::ostringstream prefix;
+  prefix << opts.mBase << "/bench." << getpid() << "." << run++;
+  int nurls = ((layout == "plain") ? 1 : stripes);
+
+  for (int i = 0; i < nurls; ++i) {
+    urls.push_back(prefix.str() + ".s" + std::to_string(i));
+  }
+
+  std::unique_ptr<Target> target;
+  int layout_type = LayoutId::kPlain;
+  int parity = 0;
+
+  if (layout == "replica") {
+    target.reset(new ReplicaTarget(urls));
+  } else {
+    if (layout == "raiddp") {
+      layout_type = LayoutId::kRaidDP;
+      parity = 2;
+    } else if (layout == "reeds") {
+      layout_type = LayoutId::kRaid6;
+      parity = opts.mParity;
+    }
+
+    unsigned long lid = LayoutId::GetId(layout_type, xs_type, nurls,
+                                        LayoutId::BlockSizeEnum(opts.mStripeWidth),
+                                        LayoutId::kNone, 0, parity);
+    target.reset(new LayoutTarget(layout, lid, urls));
+  }
+
+  std::ostringstream config;
+  config << "\"layout\": \"" << layout << "\", \"io\": \""
+         << ((LayoutId::GetIoType(urls[0].c_str()) == LayoutId::kLocal) ?
+             "local" : "remote")
+         << "\", \"stripes\": " << nurls << ", \"parity\": " << parity
+         << ", \"block_size\": " << block_size << ", \"checksum\": \""
+         << xs_name << "\"";
+  std::vector<char> buffer(block_size);
+  std::mt19937_64 random(run);
+
+  for (auto& c : buffer) {
+    c = static_cast<char>(random());
+  }
+
+  // Sequential write, the checksum is computed on the fly like in the FST
+  {
+    PhaseStats stats;
+    std::unique_ptr<eos::fst::CheckSum> xs =
+      eos::fst::ChecksumPlugins::GetChecksumObjectPtr(xs_type);
+    bool ok = target->Open(true);
+    uint64_t offset = 0;
+
+    while (ok && (offset < opts.mFileSize)) {
+      uint32_t len = std::min(block_size, opts.mFileSize - offset);
+      auto start = std::chrono::steady_clock::now();
+
+      if (xs) {
+        xs->Add(buffer.data(), len, offset);
+      }
+
+      ok = (target->Write(offset, buffer.data(), len) == len);
+      stats.Add(std::chrono::steady_clock::now() - start);
+      offset += len;
+    }
+
+    if (xs) {
+      xs->Finalize();
+    }
+
+    ok = (target->Close() && ok);
+    stats.Print(config.str(), "write", offset, ok);
+
+    if (!ok) {
+      std::cerr << "[!] Error: write failed for " << prefix.str() << std::endl;
+      target->Remove();
+      return;
+    }
+  }
+
+  // Sequential read, verifying the checksum like a full file read does
+  {
+    PhaseStats stats;
+    std::unique_ptr<eos::fst::CheckSum> xs =
+      eos::fst::ChecksumPlugins::GetChecksumObjectPtr(xs_type);
+    bool ok = target->Open(false);
+    uint64_t offset = 0;
+
+    while (ok && (offset < opts.mFileSize)) {
+      uint32_t len = std::min(block_size, opts.mFileSize - offset);
+      auto start = std::chrono::steady_clock::now();
+      ok = (target->Read(offset, buffer.data(), len) == len);
+
+      if (xs) {
+        xs->Add(buffer.data(), len, offset);
+      }
+
+      stats.Add(std::chrono::steady_clock::now() - start);
+      offset += len;
+    }
+
+    ok = (target->Close() && ok);
+    stats.Print(config.str(), "read", offset, ok);
+  }
+
+  // Vector reads at random offsets
+  for (const auto& pattern : opts.mReadV) {
+    uint32_t nchunks = pattern.first;
+    uint32_t chunk_size = pattern.second;
+
+    if (chunk_size > opts.mFileSize) {
+      continue;
+    }
+
+    PhaseStats stats;
+    std::vector<char> rdv_buffer(static_cast<size_t>(nchunks) * chunk_size);
+    bool ok = target->Open(false);
+    uint64_t bytes = 0;
+
+    for (size_t i = 0; ok && (i < opts.mReadVRequests); ++i) {
+      XrdCl::ChunkList chunks;
+
+      for (uint32_t c = 0; c < nchunks; ++c) {
+        uint64_t offset = random() % (opts.mFileSize - chunk_size + 1);
+        chunks.push_back(XrdCl::ChunkInfo(offset, chunk_size,
+                                          rdv_buffer.data() +
+                                          static_cast<size_t>(c) * chunk_size));
+      }
+
+      uint32_t len = nchunks * chunk_size;
+      auto start = std::chrono::steady_clock::now();
+      ok = (target->ReadV(chunks, len) == len);
+      stats.Add(std::chrono::steady_clock::now() - start);
+      bytes += len;
+    }
+
+    ok = (target->Close() && ok);
+    std::string phase = "readv_" + std::to_string(nchunks) + "x" +
+                        std::to_string(chunk_size);
+    stats.Print(config.str(), phase.c_str(), bytes, ok);
+  }
+
+  target->Remove();
+}
+
+//------------------------------------------------------------------------------
+// Print usage
+//------------------------------------------------------------------------------
+static void
+usage(const char* prog)
+{
+  std::cerr << "Usage: " << prog << " [options]\n"
+            << "  --base <dir|url>        directory or root:// url of the "
+            "stripe files (/tmp/eos-layout-bench)\n"
+            << "  --layouts <list>        plain,replica,raiddp,reeds\n"
+            << "  --stripes <list>        replicas or stripes including "
+            "parity (6)\n"
+            << "  --parity <n>            parity stripes of reeds (2)\n"
+            << "  --stripe-width <size>   RAIN stripe width (1M)\n"
+            << "  --block-sizes <list>    IO request sizes (1M)\n"
+            << "  --checksums <list>      none,adler,crc32,crc32c,md5,sha "
+            "(adler)\n"
+            << "  --readv <list>          vector read patterns as "
+            "<chunks>x<size> (16x4k)\n"
+            << "  --readv-requests <n>    vector reads per pattern (1000)\n"
+            << "  --size <size>           file size (256M)\n"
+            << "Prints one JSON object per configuration and phase.\n";
+}
+
+//------------------------------------------------------------------------------
+// Main function
+//------------------------------------------------------------------------------
+int
+main(int argc, char* argv[])
+{
+  Options opts;
+  static struct option long_opts[] = {
+    {"base", required_argument, nullptr, 'b'},
+    {"layouts", required_argument, nullptr, 'l'},
+    {"stripes", required_argument, nullptr, 's'},
+    {"parity", required_argument, nullptr, 'p'},
+    {"stripe-width", required_argument, nullptr, 'w'},
+    {"block-sizes", required_argument, nullptr, 'B'},
+    {"checksums", required_argument, nullptr, 'x'},
+    {"readv", required_argument, nullptr, 'v'},
+    {"readv-requests", required_argument, nullptr, 'n'},
+    {"size", required_argument, nullptr, 'S'},
+    {"help", no_argument, nullptr, 'h'},
+    {nullptr, 0, nullptr, 0}
+  };
+  int c;
+
+  try {
+    while ((c = getopt_long(argc, argv, "", long_opts, nullptr)) != -1) {
+      switch (c) {
+      case 'b':
+        opts.mBase = optarg;
+        break;
+
+      case 'l':
+        opts.mLayouts = splitList(optarg);
+        break;
+
+      case 's':
+        opts.mStripes.clear();
+
+        for (const auto& item : splitList(optarg)) {
+          opts.mStripes.push_back(std::stoi(item));
+        }
+
+        break;
+
+      case 'p':
+        opts.mParity = std::stoi(optarg);
+        break;
+
+      case 'w':
+        opts.mStripeWidth = parseSize(optarg);
+        break;
+
+      case 'B':
+        opts.mBlockSizes.clear();
+
+        for (const auto& item : splitList(optarg)) {
+          opts.mBlockSizes.push_back(parseSize(item));
+        }
+
+        break;
+
+      case 'x':
+        opts.mChecksums = splitList(optarg);
+        break;
+
+      case 'v':
+        opts.mReadV.clear();
+
+        for (const auto& item : splitList(optarg)) {
+          size_t pos = item.find('x');
+
+          if (pos == std::string::npos) {
+            throw std::invalid_argument(item);
+          }
+
+          opts.mReadV.emplace_back(std::stoul(item.substr(0, pos)),
+                                   parseSize(item.substr(pos + 1)));
+        }
+
+        break;
+
+      case 'n':
+        opts.mReadVRequests = std::stoul(optarg);
+        break;
+
+      case 'S':
+        opts.mFileSize = parseSize(optarg);
+        break;
+
+      default:
+        usage(argv[0]);
+        return 1;
+      }
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "[!] Error: invalid argument " << e.what() << std::endl;
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (LayoutId::BlockSize(LayoutId::BlockSizeEnum(opts.mStripeWidth)) !=
+      opts.mStripeWidth) {
+    std::cerr << "[!] Error: stripe width must be one of 4k, 64k, 128k, 512k, "
+              << "1M, 4M, 16M or 64M" << std::endl;
+    return 1;
+  }
+
+  for (const auto& layout : opts.mLayouts) {
+    if ((layout != "plain") && (layout != "replica") && (layout != "raiddp") &&
+        (layout != "reeds")) {
+      std::cerr << "[!] Error: unknown layout " << layout << std::endl;
+      return 1;
+    }
+  }
+
+  for (auto stripes : opts.mStripes) {
+    if ((stripes < 1) || (stripes > LayoutId::kSixteenStripe + 1)) {
+      std::cerr << "[!] Error: stripes must be between 1 and 16" << std::endl;
+      return 1;
+    }
+  }
+
+  for (auto block_size : opts.mBlockSizes) {
+    if (!block_size || (block_size > (1u << 30))) {
+      std::cerr << "[!] Error: invalid block size " << block_size << std::endl;
+      return 1;
+    }
+  }
+
+  if ((LayoutId::GetIoType(opts.mBase.c_str()) == LayoutId::kLocal) &&
+      mkdir(opts.mBase.c_str(), S_IRWXU) && (errno != EEXIST)) {
+    std::cerr << "[!] Error: failed to create " << opts.mBase << std::endl;
+    return 1;
+  }
+
+  size_t run = 0;
+
+  for (const auto& layout : opts.mLayouts) {
+    for (auto stripes : opts.mStripes) {
+      // RAIN needs at least one data stripe besides the parity
+      int parity = ((layout == "raiddp") ? 2 : opts.mParity);
+
+      if (((layout == "raiddp") || (layout == "reeds")) && (stripes <= parity)) {
+        std::cerr << "[i] Skipping " << layout << " with " << stripes
+                  << " stripes" << std::endl;
+        continue;
+      }
+
+      for (auto block_size : opts.mBlockSizes) {
+        for (const auto& xs : opts.mChecksums) {
+          runConfig(opts, layout, stripes, block_size, xs, run);
+        }
+      }
+
+      // The stripe count doesn't apply to plain files
+      if (layout == "plain") {
+        break;
+      }
+    }
+  }
+
+  return 0;
+}
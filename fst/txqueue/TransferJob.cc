@@ -30,9 +30,14 @@
 #include "fst/txqueue/TransferQueue.hh"
 #include "fst/Config.hh"
 #include "fst/XrdFstOfs.hh"
+#include "fst/io/xrd/XrdIo.hh"
+#include "fst/utils/IoPriority.hh"
+#include "common/XrdConnPool.hh"
 #include "XrdOuc/XrdOucEnv.hh"
 #include "mgm/txengine/TransferEngine.hh"
+#include "XrdCl/XrdClCopyProcess.hh"
 #include <fstream>
+#include <memory>
 #include <sstream>
 #include <cstdio>
 #include <unistd.h>
@@ -80,6 +85,10 @@ TransferJob::~TransferJob()
     delete mJob;
   }
 
+  for (auto job : mPipeline) {
+    delete job;
+  }
+
   if (mProgressThread) {
     XrdSysThread::Cancel(mProgressThread);
     XrdSysThread::Join(mProgressThread, NULL);
@@ -289,6 +298,185 @@ TransferJob::SendState(int state, const char* logfile, float progress)
   return rc;
 }
 
+/* ------------------------------------------------------------------------- */
+// Progress handler of the in-process copies feeding the bandwidth shaper of
+// the queue and cancelling transfers running longer than the job timeout
+/* ------------------------------------------------------------------------- */
+class TransferProgressHandler : public XrdCl::CopyProgressHandler
+{
+public:
+  TransferProgressHandler(TransferQueue* queue, int timeout):
+    mQueue(queue), mTimeOut(timeout), mLastBytes(0), mDeadline(0)
+  {}
+
+  virtual void BeginJob(uint16_t jobNum, uint16_t jobTotal,
+                        const XrdCl::URL* source, const XrdCl::URL* destination)
+  {
+    // every copy of a pipeline gets the full timeout
+    mLastBytes = 0;
+    mDeadline = time(NULL) + mTimeOut;
+  }
+
+  virtual void JobProgress(uint16_t jobNum, uint64_t bytesProcessed,
+                           uint64_t bytesTotal)
+  {
+    if (bytesProcessed > mLastBytes) {
+      uint64_t delta = bytesProcessed - mLastBytes;
+      mLastBytes = bytesProcessed;
+      mQueue->AddBytes(delta);
+      // the copy engine calls back between chunks, sleeping here delays the
+      // next chunk until the queue share allows it
+      mQueue->Throttle(delta);
+    }
+  }
+
+  virtual bool ShouldCancel(uint16_t jobNum)
+  {
+    return (mDeadline && (time(NULL) > mDeadline));
+  }
+
+private:
+  TransferQueue* mQueue;
+  int mTimeOut;
+  uint64_t mLastBytes;
+  time_t mDeadline;
+};
+
+/* ------------------------------------------------------------------------- */
+bool
+TransferJob::IsInProcess(eos::common::TransferJob* cjob)
+{
+  static bool use_eoscp = (getenv("EOS_FST_TX_EOSCP") != 0);
+
+  if (use_eoscp || !cjob || !cjob->GetEnv()) {
+    return false;
+  }
+
+  XrdOucEnv* env = cjob->GetEnv();
+  XrdOucString src = env->Get("source.url");
+  XrdOucString dst = env->Get("target.url");
+  XrdOucString noauth = env->Get("tx.noauth");
+  // scheduled gateway transfers need the progress reports, reconstructions
+  // and forwarded credentials are only supported by eoscp
+  return (!env->Get("tx.id") && !env->Get("tx.layout.reco") &&
+          !env->Get("tx.auth.cred") && (noauth != "1") &&
+          src.beginswith("root://") && dst.beginswith("root://"));
+}
+
+/* ------------------------------------------------------------------------- */
+std::string
+TransferJob::GetTargetHost(eos::common::TransferJob* cjob)
+{
+  if (!cjob || !cjob->GetEnv() || !cjob->GetEnv()->Get("target.url")) {
+    return "";
+  }
+
+  XrdCl::URL url(cjob->GetEnv()->Get("target.url"));
+  return url.GetHostId();
+}
+
+/* ------------------------------------------------------------------------- */
+size_t
+TransferJob::GetPipelineDepth()
+{
+  static size_t depth = []() {
+    const char* ptr = getenv("EOS_FST_TX_PIPELINE_DEPTH");
+    long long val = (ptr ? strtoll(ptr, 0, 10) : 8);
+    return (size_t)((val < 1) ? 1 : ((val > 256) ? 256 : val));
+  }();
+  return depth;
+}
+
+/* ------------------------------------------------------------------------- */
+bool
+TransferJob::IsPipelineFull() const
+{
+  return (mPipeline.size() + 1 >= GetPipelineDepth());
+}
+
+/* ------------------------------------------------------------------------- */
+void
+TransferJob::AddToPipeline(TransferJob* job)
+{
+  mPipeline.push_back(job);
+}
+
+/* ------------------------------------------------------------------------- */
+int
+TransferJob::RunInProcess()
+{
+  std::vector<TransferJob*> jobs {this};
+  jobs.insert(jobs.end(), mPipeline.begin(), mPipeline.end());
+  std::vector<XrdCl::PropertyList> results(jobs.size());
+  // the URLs have to outlive the connection id helpers releasing them
+  std::vector<XrdCl::URL> urls_src;
+  std::vector<XrdCl::URL> urls_dst;
+  std::vector<std::unique_ptr<eos::common::XrdConnIdHelper>> conn_helpers;
+  XrdCl::CopyProcess cpy;
+
+  for (auto job : jobs) {
+    urls_src.emplace_back(job->GetSourceUrl());
+    urls_dst.emplace_back(job->GetTargetUrl());
+  }
+
+  // all the copies of a pipeline go to the same destination and run one
+  // after the other, a single pooled connection serves all of them
+  conn_helpers.emplace_back(new eos::common::XrdConnIdHelper
+                            (XrdIo::GetConnPool(), urls_dst[0]));
+
+  for (size_t i = 0; i < jobs.size(); i++) {
+    if (i) {
+      urls_dst[i].SetUserName(urls_dst[0].GetUserName());
+    }
+
+    conn_helpers.emplace_back(new eos::common::XrdConnIdHelper
+                              (XrdIo::GetConnPool(), urls_src[i]));
+    XrdCl::PropertyList properties;
+    properties.Set("force", true);
+    properties.Set("posc", false);
+    properties.Set("coerce", false);
+    properties.Set("source", urls_src[i]);
+    properties.Set("target", urls_dst[i]);
+    properties.Set("sourceLimit", (uint16_t) 1);
+    properties.Set("chunkSize", (uint32_t)(4 * 1024 * 1024));
+    properties.Set("parallelChunks", (uint8_t) 1);
+    cpy.AddJob(properties, &results[i]);
+  }
+
+  XrdCl::XRootDStatus st = cpy.Prepare();
+
+  if (!st.IsOK()) {
+    eos_static_err("msg=\"failed to prepare in-process copy\" dst=\"%s\" "
+                   "njobs=%zu err=\"%s\"", urls_dst[0].GetHostId().c_str(),
+                   jobs.size(), st.ToString().c_str());
+    return -1;
+  }
+
+  TransferProgressHandler handler(mQueue, mTimeOut);
+  st = cpy.Run(&handler);
+  int rc = 0;
+
+  for (size_t i = 0; i < jobs.size(); i++) {
+    XrdCl::XRootDStatus job_st;
+
+    if (!results[i].Get("status", job_st)) {
+      job_st = st;
+    }
+
+    if (!job_st.IsOK()) {
+      eos_static_err("msg=\"in-process copy failed\" src=\"%s\" dst=\"%s\" "
+                     "err=\"%s\"", urls_src[i].GetURL().c_str(),
+                     urls_dst[i].GetURL().c_str(), job_st.ToString().c_str());
+      rc = -1;
+    } else {
+      eos_static_info("msg=\"in-process copy done\" dst=\"%s\"",
+                      urls_dst[i].GetURL().c_str());
+    }
+  }
+
+  return rc;
+}
+
 /* ------------------------------------------------------------------------- */
 void
 TransferJob::DoIt()
@@ -301,6 +489,13 @@ TransferJob::DoIt()
   //   - stagein
   //   - stageout
   mDoItThread = XrdSysThread::ID();
+  // Drain and balance copies run in their IO class, the external copy
+  // programs inherit the IO priority of this thread
+  TransferQueue::Priority prio = (mQueue ? mQueue->GetPriority() :
+                                  TransferQueue::kUser);
+  IoPriorityGuard io_guard((prio == TransferQueue::kDrain) ? IoPriority::kDrain :
+                           ((prio == TransferQueue::kBalance) ?
+                            IoPriority::kBalance : IoPriority::kUser));
   std::string sTmp, strBand;
   std::string fileName =
       eos::fst::Config::gConfig.FstAuthDir.c_str(); // script name for the transfer script
@@ -601,6 +796,17 @@ TransferJob::DoIt()
     }
   }
 
+  // --------------------------------------------------------------------
+  // plain root to root copies (drain, balance) run inside the FST, the
+  // external copy program is only needed for scheduled, reconstruction,
+  // external protocol or credential forwarding transfers
+  // --------------------------------------------------------------------
+  if (IsInProcess(mJob)) {
+    rc = RunInProcess();
+    eos_static_debug("in-process copy rc=%d", rc);
+    goto cleanup;
+  }
+
   // --------------------------------------------------------------------
   // create a transfer/stagein script
   // --------------------------------------------------------------------
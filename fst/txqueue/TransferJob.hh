@@ -28,6 +28,7 @@
 #include "Xrd/XrdJob.hh"
 #include "XrdOuc/XrdOucString.hh"
 #include <string>
+#include <vector>
 
 //! Forward declaration
 namespace eos
@@ -61,6 +62,7 @@ private:
   pthread_t mDoItThread; // the id of the thread running the DoIt function
   XrdSysMutex mCancelMutex; // protects the canceled variable
   bool mCanceled; // this indicates that the thread should
+  std::vector<TransferJob*> mPipeline; // further copies to the same destination
 
 public:
 
@@ -81,6 +83,43 @@ public:
 
   static void* StaticProgress(void*);
   void* Progress();
+
+  //----------------------------------------------------------------------------
+  //! Check if a job is a plain root to root copy which runs inside the FST
+  //! instead of the external eoscp program
+  //----------------------------------------------------------------------------
+  static bool IsInProcess(eos::common::TransferJob* cjob);
+
+  //----------------------------------------------------------------------------
+  //! Get host:port of the destination of a job
+  //----------------------------------------------------------------------------
+  static std::string GetTargetHost(eos::common::TransferJob* cjob);
+
+  //----------------------------------------------------------------------------
+  //! Get max number of in-process copies run one after the other by a job,
+  //! configured by EOS_FST_TX_PIPELINE_DEPTH
+  //----------------------------------------------------------------------------
+  static size_t GetPipelineDepth();
+
+  //----------------------------------------------------------------------------
+  //! Check if no more copies can be appended to this job
+  //----------------------------------------------------------------------------
+  bool IsPipelineFull() const;
+
+  //----------------------------------------------------------------------------
+  //! Append an in-process copy to the same destination to this job, it runs
+  //! in this job's slot after the own copy. The job takes ownership.
+  //----------------------------------------------------------------------------
+  void AddToPipeline(TransferJob* job);
+
+  //----------------------------------------------------------------------------
+  //! Run the copy of this job and the pipelined ones inside the FST using the
+  //! XrdCl copy engine over pooled connections. The copies are shaped by the
+  //! bandwidth share of the queue and accounted to the queue throughput.
+  //!
+  //! @return 0 if all the copies succeeded, otherwise -1
+  //----------------------------------------------------------------------------
+  int RunInProcess();
 };
 
 EOSFSTNAMESPACE_END
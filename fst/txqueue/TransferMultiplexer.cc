@@ -26,7 +26,11 @@
 #include "fst/XrdFstOfs.hh"
 #include "common/Logging.hh"
 #include "Xrd/XrdScheduler.hh"
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <cstdlib>
+#include <map>
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -34,8 +38,15 @@ EOSFSTNAMESPACE_BEGIN
 // Constructor
 //------------------------------------------------------------------------------
 TransferMultiplexer::TransferMultiplexer():
-  mTid(0)
-{}
+  mTotalBandwidth(0), mTid(0)
+{
+  const char* ptr = getenv("EOS_FST_TX_BANDWIDTH");
+
+  if (ptr) {
+    long long band = strtoll(ptr, nullptr, 10);
+    mTotalBandwidth = (band > 0) ? band : 0;
+  }
+}
 
 //------------------------------------------------------------------------------
 // Destructor
@@ -78,7 +89,101 @@ void
 TransferMultiplexer::Add(TransferQueue* queue)
 {
   eos::common::RWMutexWriteLock lock(mMutex);
-  mQueues.push_back(queue);
+  auto it = mQueues.begin();
+
+  while ((it != mQueues.end()) &&
+         ((*it)->GetPriority() <= queue->GetPriority())) {
+    ++it;
+  }
+
+  mQueues.insert(it, queue);
+}
+
+//------------------------------------------------------------------------------
+// Set bandwidth budget shared by all the queues
+//------------------------------------------------------------------------------
+void
+TransferMultiplexer::SetTotalBandwidth(size_t band)
+{
+  mTotalBandwidth = band;
+}
+
+//------------------------------------------------------------------------------
+// Distribute the bandwidth budget among the queues
+//------------------------------------------------------------------------------
+void
+TransferMultiplexer::UpdateShares()
+{
+  size_t total = mTotalBandwidth;
+  std::vector<double> caps(mQueues.size());
+  std::vector<bool> fixed(mQueues.size(), false);
+
+  // The limit of a queue is the bandwidth of a job times its slots
+  for (size_t i = 0; i < mQueues.size(); i++) {
+    caps[i] = (double) mQueues[i]->GetBandwidth() * mQueues[i]->GetSlots();
+
+    if (!total) {
+      mQueues[i]->SetShare((size_t) caps[i]);
+      fixed[i] = true;
+    } else if (!mQueues[i]->GetRunningAndQueued()) {
+      // Idle queues are prepared for their weighted share but don't take part
+      // in the distribution
+      unsigned int sum_weights = 0;
+
+      for (auto queue : mQueues) {
+        sum_weights += queue->GetWeight();
+      }
+
+      double share = (double) total * mQueues[i]->GetWeight() / sum_weights;
+      mQueues[i]->SetShare(std::max(1.0, caps[i] ? std::min(share, caps[i]) :
+                                    share));
+      fixed[i] = true;
+    }
+  }
+
+  // Weighted water-filling: queues limited below their weighted share get
+  // their limit, the rest of the budget goes to the others
+  double remaining = total;
+  bool changed = true;
+
+  while (changed) {
+    changed = false;
+    unsigned int sum_weights = 0;
+
+    for (size_t i = 0; i < mQueues.size(); i++) {
+      if (!fixed[i]) {
+        sum_weights += mQueues[i]->GetWeight();
+      }
+    }
+
+    if (!sum_weights) {
+      break;
+    }
+
+    for (size_t i = 0; i < mQueues.size(); i++) {
+      if (fixed[i]) {
+        continue;
+      }
+
+      double share = remaining * mQueues[i]->GetWeight() / sum_weights;
+
+      if (caps[i] && (caps[i] <= share)) {
+        mQueues[i]->SetShare((size_t) caps[i]);
+        remaining -= caps[i];
+        fixed[i] = true;
+        changed = true;
+      }
+    }
+
+    if (!changed) {
+      for (size_t i = 0; i < mQueues.size(); i++) {
+        if (!fixed[i]) {
+          double share = remaining * mQueues[i]->GetWeight() / sum_weights;
+          mQueues[i]->SetShare(std::max(1.0, share));
+        }
+      }
+    }
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -128,43 +233,105 @@ TransferMultiplexer::ThreadProc(void)
 {
   std::string sTmp, src, dest;
   eos_static_info("running transfer multiplexer with %d queues", mQueues.size());
+  auto last_update = std::chrono::steady_clock::now();
+  // Job per queue taken out while all the slots were busy
+  std::map<TransferQueue*, eos::common::TransferJob*> held;
 
   while (1) {
     {
       XrdSysThread::SetCancelOff();
       eos::common::RWMutexReadLock lock(mMutex);
+      auto now = std::chrono::steady_clock::now();
+      double elapsed = std::chrono::duration<double>(now - last_update).count();
+      last_update = now;
+
+      for (size_t i = 0; i < mQueues.size(); i++) {
+        mQueues[i]->UpdateThroughput(elapsed);
+      }
 
+      UpdateShares();
+
+      // The queues are ordered by priority, higher priority queues get their
+      // jobs scheduled first
       for (size_t i = 0; i < mQueues.size(); i++) {
-        while (mQueues[i]->GetQueue()->Size()) {
-          // look in all registered queues
-          // take an entry from the queue
+        // Jobs created in this round by destination, they are only handed to
+        // the scheduler at the end so that further copies to the same
+        // destination can be appended while all the slots are busy
+        std::vector<TransferJob*> jobs;
+        std::map<std::string, TransferJob*> pipelines;
+
+        while (true) {
           int freeslots = mQueues[i]->GetSlots() - mQueues[i]->GetRunning();
+          eos::common::TransferJob* cjob = 0;
+          auto it_held = held.find(mQueues[i]);
 
-          if (freeslots <= 0) {
-            break;
+          if (it_held != held.end()) {
+            cjob = it_held->second;
+            held.erase(it_held);
+          } else {
+            if (!mQueues[i]->GetQueue()->Size() ||
+                ((freeslots <= 0) && pipelines.empty())) {
+              break;
+            }
+
+            eos_static_info("Found %u transfers in queue %s", (unsigned int)
+                            mQueues[i]->GetQueue()->Size(), mQueues[i]->GetName());
+            mQueues[i]->GetQueue()->OpenTransaction();
+            cjob = mQueues[i]->GetQueue()->Get();
+            mQueues[i]->GetQueue()->CloseTransaction();
+
+            if (!cjob) {
+              eos_static_err("No transfer job created");
+              break;
+            }
           }
 
-          eos_static_info("Found %u transfers in queue %s", (unsigned int)
-                          mQueues[i]->GetQueue()->Size(), mQueues[i]->GetName());
-          mQueues[i]->GetQueue()->OpenTransaction();
-          eos::common::TransferJob* cjob = mQueues[i]->GetQueue()->Get();
-          mQueues[i]->GetQueue()->CloseTransaction();
+          // create new TransferJob, external copy programs get their part of
+          // the queue share as fixed limit
+          size_t bandwidth = mQueues[i]->GetBandwidth();
+
+          if (mQueues[i]->GetShare()) {
+            bandwidth = std::max((size_t) 1, mQueues[i]->GetShare() /
+                                 std::max((size_t) 1, mQueues[i]->GetSlots()));
+          }
+
+          bool in_process = TransferJob::IsInProcess(cjob);
+          std::string host = (in_process ? TransferJob::GetTargetHost(cjob) : "");
+
+          if (freeslots <= 0) {
+            // no free slot, only a copy to a destination already served in
+            // this round can still go along
+            auto it_pipe = pipelines.find(host);
+
+            if (in_process && (it_pipe != pipelines.end()) &&
+                !it_pipe->second->IsPipelineFull()) {
+              it_pipe->second->AddToPipeline(new TransferJob(mQueues[i], cjob,
+                                             bandwidth));
+              continue;
+            }
 
-          if (!cjob) {
-            eos_static_err("No transfer job created");
+            // keep it for the next round
+            held[mQueues[i]] = cjob;
             break;
           }
 
           XrdOucString out = "";
           cjob->PrintOut(out);
           eos_static_info("New transfer %s", out.c_str());
-          //create new TransferJob and submit it to the scheduler
-          TransferJob* job = new TransferJob(mQueues[i], cjob,
-                                             mQueues[i]->GetBandwidth());
+          TransferJob* job = new TransferJob(mQueues[i], cjob, bandwidth);
+          jobs.push_back(job);
+          mQueues[i]->IncRunning();
+
+          if (in_process && (TransferJob::GetPipelineDepth() > 1)) {
+            pipelines[host] = job;
+          }
+        }
+
+        // submit the new jobs to the scheduler
+        for (auto job : jobs) {
           gOFS.TransferSchedulerMutex.Lock();
           gOFS.TransferScheduler->Schedule(job);
           gOFS.TransferSchedulerMutex.UnLock();
-          mQueues[i]->IncRunning();
         }
       }
     }
@@ -27,13 +27,18 @@
 #include "fst/Namespace.hh"
 #include "common/RWMutex.hh"
 #include "fst/txqueue/TransferJob.hh"
+#include <atomic>
 #include <vector>
 #include <pthread.h>
 
 EOSFSTNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
-//! Class TransferMultiplexer
+//! Class TransferMultiplexer feeding the jobs of its queues to the transfer
+//! scheduler. The queues are served in the order of their priority and, if
+//! the multiplexer has a bandwidth budget, they share it weighted by their
+//! priority class. A queue only uses the share of the idle queues as long as
+//! these stay idle.
 //------------------------------------------------------------------------------
 class TransferMultiplexer
 {
@@ -49,12 +54,19 @@ public:
   ~TransferMultiplexer();
 
   //----------------------------------------------------------------------------
-  //! Add queue to multiplexer
+  //! Add queue to multiplexer, keeping the queues ordered by priority
   //!
   //! @param queue new queue to be added
   //----------------------------------------------------------------------------
   void Add(TransferQueue* queue);
 
+  //----------------------------------------------------------------------------
+  //! Set bandwidth budget shared by all the attached queues
+  //!
+  //! @param band bandwidth in MB/s, 0 for no limit
+  //----------------------------------------------------------------------------
+  void SetTotalBandwidth(size_t band);
+
   //----------------------------------------------------------------------------
   //! Set number of slots for each of the attached queues
   //!
@@ -91,8 +103,15 @@ public:
   void* ThreadProc();
 
 private:
+  //----------------------------------------------------------------------------
+  //! Distribute the bandwidth budget among the queues by weighted max-min
+  //! fairness, capped by the limits of each queue. Needs mMutex.
+  //----------------------------------------------------------------------------
+  void UpdateShares();
+
   eos::common::RWMutex mMutex;
   std::vector<TransferQueue*> mQueues;
+  std::atomic<size_t> mTotalBandwidth; ///< MB/s for all the queues, 0 = no limit
   pthread_t mTid;
 };
 
@@ -26,7 +26,9 @@
 #include "fst/txqueue/TransferJob.hh"
 #include "common/Logging.hh"
 /* ------------------------------------------------------------------------- */
+#include <algorithm>
 #include <cstdio>
+#include <thread>
 
 /* ------------------------------------------------------------------------- */
 
@@ -34,10 +36,18 @@ EOSFSTNAMESPACE_BEGIN
 
 /* ------------------------------------------------------------------------- */
 TransferQueue::TransferQueue(eos::common::TransferQueue** queue,
-                             const char* name, int slots, int band)
+                             const char* name, int slots, int band,
+                             Priority prio)
 {
   mQueue = queue;
   mName = name;
+  mPriority = prio;
+  mBytesDone = 0;
+  mLastBytesDone = 0;
+  mThroughput = 0;
+  mShare = 0;
+  mTokens = 0;
+  mLastRefill = std::chrono::steady_clock::now();
   mJobsRunning = 0;
   mJobsDone = 0;
   nslots = slots;
@@ -79,4 +89,76 @@ TransferQueue::SetSlots(size_t slots)
   XrdSysMutexHelper lock(mSlotsMutex);
   nslots = slots;
 }
+
+/* ------------------------------------------------------------------------- */
+size_t
+TransferQueue::GetShare()
+{
+  std::lock_guard<std::mutex> lock(mShaperMutex);
+  return mShare;
+}
+
+/* ------------------------------------------------------------------------- */
+void
+TransferQueue::SetShare(size_t share)
+{
+  std::lock_guard<std::mutex> lock(mShaperMutex);
+  mShare = share;
+}
+
+/* ------------------------------------------------------------------------- */
+void
+TransferQueue::Throttle(unsigned long long bytes)
+{
+  std::chrono::duration<double> wait(0);
+  {
+    std::lock_guard<std::mutex> lock(mShaperMutex);
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - mLastRefill).count();
+    mLastRefill = now;
+
+    if (!mShare) {
+      mTokens = 0;
+      return;
+    }
+
+    // refill with the share, allowing bursts of up to one second
+    double rate = mShare * 1000000.0;
+    mTokens = std::min(mTokens + elapsed * rate, rate);
+    mTokens -= bytes;
+
+    if (mTokens < 0) {
+      wait = std::chrono::duration<double>(-mTokens / rate);
+    }
+  }
+
+  if (wait.count() > 0) {
+    std::this_thread::sleep_for(wait);
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+void
+TransferQueue::UpdateThroughput(double elapsed)
+{
+  if (elapsed <= 0) {
+    return;
+  }
+
+  unsigned long long bytes = mBytesDone;
+  std::lock_guard<std::mutex> lock(mShaperMutex);
+  double rate = (bytes - mLastBytesDone) / elapsed / 1000000.0;
+  mLastBytesDone = bytes;
+  // smooth over a few update periods
+  mThroughput = 0.7 * mThroughput + 0.3 * rate;
+}
+
+/* ------------------------------------------------------------------------- */
+double
+TransferQueue::GetThroughput()
+{
+  std::lock_guard<std::mutex> lock(mShaperMutex);
+  return mThroughput;
+}
+
 EOSFSTNAMESPACE_END
@@ -29,6 +29,9 @@
 #include "common/TransferQueue.hh"
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <string>
 #include <pthread.h>
 
@@ -38,9 +41,33 @@ EOSFSTNAMESPACE_BEGIN
 
 class TransferQueue
 {
+public:
+  //! Priority classes of the queues, the lower the value the higher the
+  //! priority and the bigger the share of the bandwidth
+  enum Priority {
+    kUser = 0,
+    kRepair = 1,
+    kDrain = 2,
+    kBalance = 3
+  };
+
 private:
   eos::common::TransferQueue** mQueue;
   std::string mName;
+  Priority mPriority;
+
+  //! Bytes transferred by all the jobs of this queue
+  std::atomic<unsigned long long> mBytesDone;
+  //! Byte counter at the last throughput update
+  unsigned long long mLastBytesDone;
+  //! Live throughput in MB/s
+  double mThroughput;
+  //! Share of the bandwidth in MB/s assigned by the multiplexer, 0 = no limit
+  size_t mShare;
+  //! Token bucket shaping the in-process transfers to mShare
+  double mTokens;
+  std::chrono::steady_clock::time_point mLastRefill;
+  std::mutex mShaperMutex;
 
   size_t nslots, bandwidth;
 
@@ -57,9 +84,64 @@ private:
 public:
 
   TransferQueue(eos::common::TransferQueue** queue, const char* name,
-                int slots = 2, int band = 100);
+                int slots = 2, int band = 100, Priority prio = kUser);
   ~TransferQueue();
 
+  Priority
+  GetPriority() const
+  {
+    return mPriority;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get weight of the queue in the bandwidth sharing, doubling with every
+  //! priority class: user 8, repair 4, drain 2, balance 1
+  //----------------------------------------------------------------------------
+  unsigned int
+  GetWeight() const
+  {
+    return (1u << (kBalance - mPriority));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the share of the bandwidth in MB/s, 0 if not limited
+  //----------------------------------------------------------------------------
+  size_t GetShare();
+
+  //----------------------------------------------------------------------------
+  //! Set the share of the bandwidth in MB/s, 0 if not limited
+  //----------------------------------------------------------------------------
+  void SetShare(size_t share);
+
+  //----------------------------------------------------------------------------
+  //! Account bytes transferred by a job of this queue
+  //----------------------------------------------------------------------------
+  void
+  AddBytes(unsigned long long bytes)
+  {
+    mBytesDone += bytes;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Block the calling transfer such that all the transfers of this queue
+  //! together stay within the share of the bandwidth
+  //!
+  //! @param bytes number of bytes the caller just transferred
+  //----------------------------------------------------------------------------
+  void Throttle(unsigned long long bytes);
+
+  //----------------------------------------------------------------------------
+  //! Update the live throughput, called periodically by the multiplexer
+  //!
+  //! @param elapsed seconds since the last update
+  //----------------------------------------------------------------------------
+  void UpdateThroughput(double elapsed);
+
+  //----------------------------------------------------------------------------
+  //! Get the live throughput in MB/s
+  //----------------------------------------------------------------------------
+  double GetThroughput();
+
   eos::common::TransferQueue*
   GetQueue()
   {
@@ -23,6 +23,14 @@
 
 #include <set>
 #include <string>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <algorithm>
 #include <math.h>
 #include <unistd.h>
@@ -168,7 +176,7 @@ void
 usage()
 {
   fprintf(stderr,
-          "Usage: %s [-5] [-0] [-X <type>] [-t <mb/s>] [-h] [-x] [-v] [-V] [-d] [-l] [-b <size>] [-T <size>] [-Y] [-n] [-s] [-u <id>] [-g <id>] [-S <#>] [-D <#>] [-O <filename>] [-N <name>]<src1> [src2...] <dst1> [dst2...]\n",
+          "Usage: %s [-5] [-0] [-X <type>] [-t <mb/s>] [-h] [-x] [-v] [-V] [-d] [-l] [-b <size>] [-T <size>] [-Y] [-n] [-s] [-u <id>] [-g <id>] [-S <#>] [-D <#>] [-O <filename>] [-N <name>] [-M <#>] [-W <#>] [-B] <src1> [src2...] <dst1> [dst2...]\n",
           PROGRAM);
   fprintf(stderr, "       -h           : help\n");
   fprintf(stderr, "       -d           : debug mode\n");
@@ -224,6 +232,12 @@ usage()
   fprintf(stderr,
           "       -0           : RAID layouts - don't use parallel IO mode\n");
   fprintf(stderr, "       -x           : don't overwrite an existing file\n");
+  fprintf(stderr,
+          "       -M <#>       : copy a single source with <#> parallel streams over offset ranges, holes of local sources are skipped\n");
+  fprintf(stderr,
+          "       -W <#>       : multi-stream mode - number of buffers in flight per stream (default 4)\n");
+  fprintf(stderr,
+          "       -B           : multi-stream mode - report the throughput of every stream\n");
   exit(-1);
 }
 
@@ -514,6 +528,495 @@ abort_handler(int)
 
 
 
+//------------------------------------------------------------------------------
+// Multi-stream copy mode: the byte range of a single source is split into
+// <nstreams> contiguous parts copied in parallel. Every stream has a reader
+// thread filling a ring of <ringdepth> buffers ahead of a writer thread, so
+// reads and writes of a stream overlap. Holes of local sources are detected
+// with SEEK_DATA and not transferred.
+//------------------------------------------------------------------------------
+int nstreams = 1; ///< number of parallel streams, 1 is the classic copy loop
+int ringdepth = 4; ///< number of buffers in flight per stream
+int benchmark = 0; ///< report the throughput of every stream
+
+//------------------------------------------------------------------------------
+//! Block of a stream in flight between the reader and the writer
+//------------------------------------------------------------------------------
+struct StreamBlock {
+  char* mBuffer;
+  off_t mOffset;
+  size_t mLength;
+};
+
+//------------------------------------------------------------------------------
+//! State and statistics of one stream
+//------------------------------------------------------------------------------
+struct CopyStream {
+  off_t mStart {0}; ///< first byte of the stream range
+  off_t mStop {0}; ///< first byte after the stream range
+  std::vector<char*> mBuffers; ///< buffers of the ring
+  std::deque<char*> mFree; ///< buffers ready to be filled
+  std::deque<StreamBlock> mFilled; ///< blocks ready to be written
+  bool mEof {false}; ///< reader is done
+  std::mutex mMutex;
+  std::condition_variable mCond;
+  unsigned long long mBytes {0}; ///< bytes written
+  unsigned long long mSparse {0}; ///< bytes skipped in holes
+  double mReadMs {0}; ///< time spent reading
+  double mWriteMs {0}; ///< time spent writing
+  double mRealSec {0}; ///< duration of the stream
+};
+
+std::atomic<unsigned long long> ms_totalbytes {0}; ///< bytes of all streams
+std::atomic<bool> ms_error {false}; ///< set by the first failing stream
+
+//------------------------------------------------------------------------------
+// Milliseconds elapsed since the given time
+//------------------------------------------------------------------------------
+static double
+elapsed_ms(const struct timespec& start)
+{
+  struct timespec now;
+  eos::common::Timing::GetTimeSpec(now);
+  return (now.tv_sec - start.tv_sec) * 1000.0 +
+         (now.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+//------------------------------------------------------------------------------
+// Get the size of the opened source
+//------------------------------------------------------------------------------
+static long long
+ms_source_size()
+{
+  switch (src_type[0]) {
+  case LOCAL_ACCESS: {
+    struct stat buf;
+
+    if (!fstat(src_handler[0].first, &buf)) {
+      return buf.st_size;
+    }
+  }
+  break;
+
+  case XRD_ACCESS: {
+    XrdCl::StatInfo* info = 0;
+    XrdCl::XRootDStatus xst = static_cast<XrdCl::File*>
+                              (src_handler[0].second)->Stat(false, info);
+    long long size = -1;
+
+    if (xst.IsOK() && info) {
+      size = info->GetSize();
+    }
+
+    delete info;
+    return size;
+  }
+
+  case RIO_ACCESS: {
+    struct stat buf;
+
+    if (!static_cast<eos::fst::FileIo*>(src_handler[0].second)->fileStat(&buf)) {
+      return buf.st_size;
+    }
+  }
+  break;
+
+  default:
+    break;
+  }
+
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+// Check if the given range of a local source lies entirely in a hole
+//------------------------------------------------------------------------------
+static bool
+ms_is_hole(off_t offset, size_t length)
+{
+  if (src_type[0] != LOCAL_ACCESS) {
+    return false;
+  }
+
+  off_t data = lseek(src_handler[0].first, offset, SEEK_DATA);
+
+  if (data < 0) {
+    // ENXIO: no data after offset, anything else: no hole support
+    return (errno == ENXIO);
+  }
+
+  return (data >= (off_t)(offset + length));
+}
+
+//------------------------------------------------------------------------------
+// Read a block of the source at the given offset
+//------------------------------------------------------------------------------
+static int64_t
+ms_read(char* buf, off_t offset, size_t length)
+{
+  switch (src_type[0]) {
+  case LOCAL_ACCESS: {
+    size_t done = 0;
+
+    while (done < length) {
+      ssize_t nread = pread(src_handler[0].first, buf + done, length - done,
+                            offset + done);
+
+      if (nread < 0) {
+        return -1;
+      }
+
+      if (nread == 0) {
+        break;
+      }
+
+      done += nread;
+    }
+
+    return done;
+  }
+
+  case XRD_ACCESS: {
+    uint32_t nread = 0;
+    XrdCl::XRootDStatus xst = static_cast<XrdCl::File*>
+                              (src_handler[0].second)->Read(offset, length, buf, nread);
+    return (xst.IsOK() ? (int64_t) nread : -1);
+  }
+
+  case RIO_ACCESS:
+    return static_cast<eos::fst::FileIo*>(src_handler[0].second)->fileRead(
+             offset, buf, length);
+
+  default:
+    return -1;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Write a block to all the destinations at the given offset
+//------------------------------------------------------------------------------
+static bool
+ms_write(const char* buf, off_t offset, size_t length)
+{
+  for (int i = 0; i < ndst; i++) {
+    int64_t nwrite = -1;
+
+    switch (dst_type[i]) {
+    case LOCAL_ACCESS: {
+      size_t done = 0;
+
+      while (done < length) {
+        ssize_t nw = pwrite(dst_handler[i].first, buf + done, length - done,
+                            offset + done);
+
+        if (nw <= 0) {
+          break;
+        }
+
+        done += nw;
+      }
+
+      nwrite = done;
+    }
+    break;
+
+    case XRD_ACCESS:
+    case RIO_ACCESS:
+      nwrite = static_cast<eos::fst::FileIo*>(dst_handler[i].second)->fileWrite(
+                 offset, buf, length);
+      break;
+
+    default:
+      break;
+    }
+
+    if (nwrite != (int64_t) length) {
+      fprintf(stderr, "error: write failed on destination file %s at offset "
+              "%lld - destination file is incomplete!\n",
+              dst_location[i].second.c_str(), (long long) offset);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Reader of a stream, reads ahead as long as there are free buffers
+//------------------------------------------------------------------------------
+static void
+ms_reader(CopyStream* cs)
+{
+  for (off_t offset = cs->mStart; (offset < cs->mStop) && !ms_error;) {
+    size_t length = std::min((off_t) buffersize, cs->mStop - offset);
+
+    if (ms_is_hole(offset, length)) {
+      cs->mSparse += length;
+      ms_totalbytes += length;
+      offset += length;
+      continue;
+    }
+
+    char* buf = 0;
+    {
+      std::unique_lock<std::mutex> lock(cs->mMutex);
+      cs->mCond.wait(lock, [&] {return !cs->mFree.empty() || ms_error;});
+
+      if (ms_error) {
+        break;
+      }
+
+      buf = cs->mFree.front();
+      cs->mFree.pop_front();
+    }
+    struct timespec start;
+    eos::common::Timing::GetTimeSpec(start);
+    int64_t nread = ms_read(buf, offset, length);
+    cs->mReadMs += elapsed_ms(start);
+
+    if (nread != (int64_t) length) {
+      fprintf(stderr, "error: read failed on file %s at offset %lld - "
+              "destination file is incomplete!\n",
+              src_location[0].second.c_str(), (long long) offset);
+      ms_error = true;
+      break;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(cs->mMutex);
+      cs->mFilled.push_back(StreamBlock{buf, offset, length});
+    }
+    cs->mCond.notify_all();
+    offset += length;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(cs->mMutex);
+    cs->mEof = true;
+  }
+  cs->mCond.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Writer of a stream, writes behind the reader and returns the buffers
+//------------------------------------------------------------------------------
+static void
+ms_writer(CopyStream* cs, off_t read_start)
+{
+  while (true) {
+    StreamBlock block;
+    {
+      std::unique_lock<std::mutex> lock(cs->mMutex);
+      cs->mCond.wait(lock, [&] {
+        return !cs->mFilled.empty() || cs->mEof || ms_error;
+      });
+
+      if (ms_error || cs->mFilled.empty()) {
+        break;
+      }
+
+      block = cs->mFilled.front();
+      cs->mFilled.pop_front();
+    }
+    struct timespec start;
+    eos::common::Timing::GetTimeSpec(start);
+
+    if (!ms_write(block.mBuffer, startwritebyte + (block.mOffset - read_start),
+                  block.mLength)) {
+      ms_error = true;
+      cs->mCond.notify_all();
+      break;
+    }
+
+    cs->mWriteMs += elapsed_ms(start);
+    cs->mBytes += block.mLength;
+    unsigned long long total = (ms_totalbytes += block.mLength);
+    {
+      std::unique_lock<std::mutex> lock(cs->mMutex);
+      cs->mFree.push_back(block.mBuffer);
+    }
+    cs->mCond.notify_all();
+
+    if (bandwidth) {
+      // regulate the aggregated io of all the streams
+      gettimeofday(&abs_stop_time, &tz);
+      float abs_time = static_cast<float>((abs_stop_time.tv_sec -
+                                           abs_start_time.tv_sec) * 1000 +
+                                          (abs_stop_time.tv_usec - abs_start_time.tv_usec) / 1000);
+      float exp_time = total / bandwidth / 1000.0;
+
+      if (abs_time < exp_time) {
+        usleep((int)(1000 * (exp_time - abs_time)));
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check if the transfer can run in multi-stream mode
+//------------------------------------------------------------------------------
+static bool
+ms_supported(std::string& reason)
+{
+  if ((nsrc != 1) || isRaidTransfer) {
+    reason = "RAIN or multiple sources (use -0 to disable parallel IO)";
+    return false;
+  }
+
+  if ((src_type[0] != LOCAL_ACCESS) && (src_type[0] != XRD_ACCESS) &&
+      (src_type[0] != RIO_ACCESS)) {
+    reason = "source is not seekable";
+    return false;
+  }
+
+  for (int i = 0; i < ndst; i++) {
+    if ((dst_type[i] != LOCAL_ACCESS) && (dst_type[i] != XRD_ACCESS) &&
+        (dst_type[i] != RIO_ACCESS)) {
+      reason = "destination is not seekable";
+      return false;
+    }
+  }
+
+  if (computeXS) {
+    reason = "checksums need the data in order";
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Copy using parallel streams
+//
+// @param size size of the source
+//
+// @return number of bytes copied, including the holes
+//------------------------------------------------------------------------------
+static long long
+ms_copy(long long size)
+{
+  off_t read_start = (startbyte > 0) ? startbyte : 0;
+  off_t read_stop = ((stopbyte >= 0) && (stopbyte < size)) ? stopbyte : size;
+
+  if (read_stop <= read_start) {
+    return 0;
+  }
+
+  // Split the range in parts aligned to the buffer size
+  off_t length = read_stop - read_start;
+  off_t part = (length + nstreams - 1) / nstreams;
+  part = ((part + buffersize - 1) / buffersize) * buffersize;
+  std::vector<std::unique_ptr<CopyStream>> streams;
+
+  for (off_t offset = read_start; offset < read_stop; offset += part) {
+    std::unique_ptr<CopyStream> cs(new CopyStream());
+    cs->mStart = offset;
+    cs->mStop = std::min(offset + part, read_stop);
+
+    for (int i = 0; i < ringdepth; i++) {
+      cs->mBuffers.push_back(new char[buffersize]);
+      cs->mFree.push_back(cs->mBuffers.back());
+    }
+
+    streams.push_back(std::move(cs));
+  }
+
+  if (debug) {
+    fprintf(stderr, "[eoscp]: copying %lld bytes with %zu streams of %lld "
+            "bytes and %d buffers of %u bytes each\n", (long long) length,
+            streams.size(), (long long) part, ringdepth, buffersize);
+  }
+
+  std::vector<std::thread> threads;
+  std::atomic<size_t> running {streams.size()};
+
+  for (auto& cs : streams) {
+    CopyStream* ptr = cs.get();
+    threads.emplace_back([ptr, read_start, &running]() {
+      struct timespec start;
+      eos::common::Timing::GetTimeSpec(start);
+      std::thread reader(ms_reader, ptr);
+      ms_writer(ptr, read_start);
+      reader.join();
+      ptr->mRealSec = elapsed_ms(start) / 1000.0;
+      --running;
+    });
+  }
+
+  // Report the progress while the streams are running
+  while (running) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    if (progressFile.length()) {
+      write_progress(ms_totalbytes, length);
+    }
+
+    if (progbar) {
+      gettimeofday(&abs_stop_time, &tz);
+      print_progbar(ms_totalbytes, length);
+    }
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  unsigned long long sparse = 0;
+
+  for (size_t i = 0; i < streams.size(); i++) {
+    CopyStream* cs = streams[i].get();
+    sparse += cs->mSparse;
+    read_wait += cs->mReadMs;
+    write_wait += cs->mWriteMs;
+
+    if (benchmark) {
+      COUT(("[eoscp] # Stream %-3zu range=%lld:%lld bytes=%llu sparse=%llu "
+            "read_ms=%.0f write_ms=%.0f realtime=%.3f rate[MB/s]=%.2f\n", i,
+            (long long) cs->mStart, (long long) cs->mStop, cs->mBytes,
+            cs->mSparse, cs->mReadMs, cs->mWriteMs, cs->mRealSec,
+            cs->mRealSec > 0 ? cs->mBytes / cs->mRealSec / 1000000.0 : 0.0));
+    }
+
+    for (auto buf : cs->mBuffers) {
+      delete[] buf;
+    }
+  }
+
+  if (ms_error) {
+    exit(-EIO);
+  }
+
+  // Holes at the end of the source are not written, fix the target size
+  if (sparse) {
+    off_t target_size = startwritebyte + length;
+
+    for (int i = 0; i < ndst; i++) {
+      int rc = 0;
+
+      if (dst_type[i] == LOCAL_ACCESS) {
+        rc = ftruncate(dst_handler[i].first, target_size);
+      } else {
+        rc = static_cast<eos::fst::FileIo*>(dst_handler[i].second)->fileTruncate(
+               target_size);
+      }
+
+      if (rc) {
+        fprintf(stderr, "error: cannot set size of destination file %s\n",
+                dst_location[i].second.c_str());
+        exit(-EIO);
+      }
+    }
+  }
+
+  if (benchmark) {
+    COUT(("[eoscp] # Streams                  : %zu\n", streams.size()));
+    COUT(("[eoscp] # Sparse Data [bytes]      : %llu\n", sparse));
+  }
+
+  return length;
+}
+
+
 //------------------------------------------------------------------------------
 // Main function
 //------------------------------------------------------------------------------
@@ -528,7 +1031,7 @@ main(int argc, char* argv[])
   extern int optind;
 
   while ((c = getopt(argc, argv,
-                     "nshxdvlipfce:P:X:b:m:u:g:t:S:D:5aA:r:N:L:RT:O:V0")) != -1) {
+                     "nshxdvlipfce:P:X:b:m:u:g:t:S:D:5aA:r:N:L:RT:O:V0M:W:B")) != -1) {
     switch (c) {
     case 'v':
       verbose = 1;
@@ -781,6 +1284,30 @@ main(int argc, char* argv[])
       isStreamFile = true;
       break;
 
+    case 'M':
+      nstreams = atoi(optarg);
+
+      if ((nstreams < 1) || (nstreams > 64)) {
+        fprintf(stderr, "error: # of streams must be 1 <= # <= 64\n");
+        exit(-1);
+      }
+
+      break;
+
+    case 'W':
+      ringdepth = atoi(optarg);
+
+      if ((ringdepth < 1) || (ringdepth > 64)) {
+        fprintf(stderr, "error: # of buffers per stream must be 1 <= # <= 64\n");
+        exit(-1);
+      }
+
+      break;
+
+    case 'B':
+      benchmark = 1;
+      break;
+
     case 'h':
     default:
       usage();
@@ -2019,196 +2546,220 @@ main(int argc, char* argv[])
   struct timespec start, end;
   stopwritebyte = startwritebyte;
 
-  while (1) {
-    if (progressFile.length()) {
-      write_progress(totalbytes, st[0].st_size);
-    }
+  if (nstreams > 1) {
+    std::string reason;
 
-    if (progbar) {
-      gettimeofday(&abs_stop_time, &tz);
-
-      for (int i = 0; i < nsrc; i++) {
-        if ((src_type[i] == XRD_ACCESS) && (targetsize)) {
-          st[i].st_size = targetsize;
-        }
-      }
-
-      print_progbar(totalbytes, st[0].st_size);
-    }
-
-    if (bandwidth) {
-      gettimeofday(&abs_stop_time, &tz);
-      float abs_time = static_cast<float>((abs_stop_time.tv_sec -
-                                           abs_start_time.tv_sec) * 1000 +
-                                          (abs_stop_time.tv_usec - abs_start_time.tv_usec) / 1000);
-      //........................................................................
-      // Regulate the io - sleep as desired
-      //........................................................................
-      float exp_time = totalbytes / bandwidth / 1000.0;
-
-      if (abs_time < exp_time) {
-        usleep((int)(1000 * (exp_time - abs_time)));
-      }
-    }
-
-    //..........................................................................
-    // For ranges we have to adjust the last buffersize
-    //..........................................................................
-    if ((stopbyte >= 0) &&
-        (((stopbyte - startbyte) - totalbytes) < buffersize)) {
-      buffersize = (stopbyte - startbyte) - totalbytes;
+    if (!ms_supported(reason)) {
+      fprintf(stderr, "warning: multi-stream mode not possible - %s, using a "
+              "single stream\n", reason.c_str());
+      nstreams = 1;
     }
+  }
 
-    int nread = -1;
-
-    switch (src_type[0]) {
-    case LOCAL_ACCESS:
-    case CONSOLE_ACCESS:
-      nread = read(src_handler[0].first,
-                   static_cast<void*>(ptr_buffer),
-                   buffersize);
-      break;
+  if (nstreams > 1) {
+    long long size = ms_source_size();
 
-    case RAID_ACCESS: {
-      nread = redundancyObj->Read(offsetXrd, ptr_buffer, buffersize);
-      offsetXrd += nread;
+    if (size < 0) {
+      fprintf(stderr, "error: cannot get size of source %s\n",
+              src_location[0].second.c_str());
+      exit(-EIO);
     }
-    break;
-
-    case XRD_ACCESS: {
-      eos::common::Timing::GetTimeSpec(start);
-      uint32_t xnread = 0;
-      status = static_cast<XrdCl::File*>(src_handler[0].second)->Read(offsetXrd,
-               buffersize, ptr_buffer, xnread);
-      nread = xnread;
 
-      if (!status.IsOK()) {
-        fprintf(stderr, "Error while doing reading. \n");
-        exit(-1);
+    st[0].st_size = size;
+    totalbytes = ms_copy(size);
+    stopwritebyte = startwritebyte + totalbytes;
+  } else {
+    while (1) {
+      if (progressFile.length()) {
+        write_progress(totalbytes, st[0].st_size);
       }
 
-      eos::common::Timing::GetTimeSpec(end);
-      wait_time = static_cast<double>((end.tv_sec * 1000 + end.tv_nsec / 1000000) -
-                                      (start.tv_sec * 1000 + start.tv_nsec / 1000000));
-      read_wait += wait_time;
-      offsetXrd += nread;
+      if (progbar) {
+        gettimeofday(&abs_stop_time, &tz);
 
-      if (debug) {
-        fprintf(stderr, "[eoscp] read=%d\n", nread);
-      }
-    }
-    break;
-
-    case RIO_ACCESS: {
-      eos::common::Timing::GetTimeSpec(start);
-      int64_t nread64;
-      nread64 = static_cast<eos::fst::FileIo*>(src_handler[0].second)->fileRead(
-                  offsetXrd, ptr_buffer, buffersize);
+        for (int i = 0; i < nsrc; i++) {
+          if ((src_type[i] == XRD_ACCESS) && (targetsize)) {
+            st[i].st_size = targetsize;
+          }
+        }
 
-      if (nread64 < 0) {
-        nread = -1;
-      } else {
-        nread = (int) nread64;
+        print_progbar(totalbytes, st[0].st_size);
       }
 
-      eos::common::Timing::GetTimeSpec(end);
-      wait_time = static_cast<double>((end.tv_sec * 1000 + end.tv_nsec / 1000000) -
-                                      (start.tv_sec * 1000 + start.tv_nsec / 1000000));
-      read_wait += wait_time;
-      offsetXrd += nread;
+      if (bandwidth) {
+        gettimeofday(&abs_stop_time, &tz);
+        float abs_time = static_cast<float>((abs_stop_time.tv_sec -
+                                             abs_start_time.tv_sec) * 1000 +
+                                            (abs_stop_time.tv_usec - abs_start_time.tv_usec) / 1000);
+        //........................................................................
+        // Regulate the io - sleep as desired
+        //........................................................................
+        float exp_time = totalbytes / bandwidth / 1000.0;
 
-      if (debug) {
-        fprintf(stderr, "[eoscp] read=%d\n", nread);
+        if (abs_time < exp_time) {
+          usleep((int)(1000 * (exp_time - abs_time)));
+        }
       }
-    }
-    break;
-    }
-
-    if (nread < 0) {
-      fprintf(stderr, "error: read failed on file %s - destination file "
-              "is incomplete!\n", src_location[0].second.c_str());
-      exit(-EIO);
-    }
 
-    if (nread == 0) {
-      // end of file
-      break;
-    }
-
-    if (computeXS && xsObj) {
-      xsObj->Add(static_cast<const char*>(ptr_buffer), nread, offsetXS);
-      offsetXS += nread;
-    }
+      //..........................................................................
+      // For ranges we have to adjust the last buffersize
+      //..........................................................................
+      if ((stopbyte >= 0) &&
+          (((stopbyte - startbyte) - totalbytes) < buffersize)) {
+        buffersize = (stopbyte - startbyte) - totalbytes;
+      }
 
-    int64_t nwrite = 0;
+      int nread = -1;
 
-    for (int i = 0; i < ndst; i++) {
-      switch (dst_type[i]) {
+      switch (src_type[0]) {
       case LOCAL_ACCESS:
       case CONSOLE_ACCESS:
-        nwrite = write(dst_handler[i].first, ptr_buffer, nread);
-        nwrite = nread;
+        nread = read(src_handler[0].first,
+                     static_cast<void*>(ptr_buffer),
+                     buffersize);
         break;
 
       case RAID_ACCESS: {
-        if (i == 0) {
-          nwrite = redundancyObj->Write(stopwritebyte, ptr_buffer, nread);
-          i = ndst;
-        }
+        nread = redundancyObj->Read(offsetXrd, ptr_buffer, buffersize);
+        offsetXrd += nread;
       }
       break;
 
       case XRD_ACCESS: {
-        // Do writes in async mode
         eos::common::Timing::GetTimeSpec(start);
-        nwrite = static_cast<eos::fst::FileIo*>(dst_handler[i].second)->fileWriteAsync(
-                   stopwritebyte, ptr_buffer, nread);
+        uint32_t xnread = 0;
+        status = static_cast<XrdCl::File*>(src_handler[0].second)->Read(offsetXrd,
+                 buffersize, ptr_buffer, xnread);
+        nread = xnread;
+
+        if (!status.IsOK()) {
+          fprintf(stderr, "Error while doing reading. \n");
+          exit(-1);
+        }
+
         eos::common::Timing::GetTimeSpec(end);
         wait_time = static_cast<double>((end.tv_sec * 1000 + end.tv_nsec / 1000000) -
                                         (start.tv_sec * 1000 + start.tv_nsec / 1000000));
-        write_wait += wait_time;
+        read_wait += wait_time;
+        offsetXrd += nread;
 
         if (debug) {
-          fprintf(stderr, "[eoscp] write=%li\n", nwrite);
+          fprintf(stderr, "[eoscp] read=%d\n", nread);
         }
       }
       break;
 
       case RIO_ACCESS: {
         eos::common::Timing::GetTimeSpec(start);
-        int64_t nwrite64;
-        nwrite64 = static_cast<eos::fst::FileIo*>(dst_handler[i].second)->fileWrite(
-                     stopwritebyte, ptr_buffer, nread);
+        int64_t nread64;
+        nread64 = static_cast<eos::fst::FileIo*>(src_handler[0].second)->fileRead(
+                    offsetXrd, ptr_buffer, buffersize);
 
-        if (nwrite64 < 0) {
-          nwrite = -1;
+        if (nread64 < 0) {
+          nread = -1;
         } else {
-          nwrite = (int) nwrite64;
+          nread = (int) nread64;
         }
 
         eos::common::Timing::GetTimeSpec(end);
         wait_time = static_cast<double>((end.tv_sec * 1000 + end.tv_nsec / 1000000) -
                                         (start.tv_sec * 1000 + start.tv_nsec / 1000000));
-        write_wait += wait_time;
+        read_wait += wait_time;
+        offsetXrd += nread;
 
         if (debug) {
-          fprintf(stderr, "[eoscp] write=%li\n", nwrite);
+          fprintf(stderr, "[eoscp] read=%d\n", nread);
         }
       }
       break;
       }
 
-      if (nwrite != nread) {
-        fprintf(stderr, "error: write failed on destination file %s - "
-                "wrote %lld/%lld bytes - destination file is incomplete!\n",
-                dst_location[i].second.c_str(), (long long) nwrite, (long long) nread);
+      if (nread < 0) {
+        fprintf(stderr, "error: read failed on file %s - destination file "
+                "is incomplete!\n", src_location[0].second.c_str());
         exit(-EIO);
       }
-    }
 
-    totalbytes += nwrite;
-    stopwritebyte += nwrite;
-  } // end while(1)
+      if (nread == 0) {
+        // end of file
+        break;
+      }
+
+      if (computeXS && xsObj) {
+        xsObj->Add(static_cast<const char*>(ptr_buffer), nread, offsetXS);
+        offsetXS += nread;
+      }
+
+      int64_t nwrite = 0;
+
+      for (int i = 0; i < ndst; i++) {
+        switch (dst_type[i]) {
+        case LOCAL_ACCESS:
+        case CONSOLE_ACCESS:
+          nwrite = write(dst_handler[i].first, ptr_buffer, nread);
+          nwrite = nread;
+          break;
+
+        case RAID_ACCESS: {
+          if (i == 0) {
+            nwrite = redundancyObj->Write(stopwritebyte, ptr_buffer, nread);
+            i = ndst;
+          }
+        }
+        break;
+
+        case XRD_ACCESS: {
+          // Do writes in async mode
+          eos::common::Timing::GetTimeSpec(start);
+          nwrite = static_cast<eos::fst::FileIo*>(dst_handler[i].second)->fileWriteAsync(
+                     stopwritebyte, ptr_buffer, nread);
+          eos::common::Timing::GetTimeSpec(end);
+          wait_time = static_cast<double>((end.tv_sec * 1000 + end.tv_nsec / 1000000) -
+                                          (start.tv_sec * 1000 + start.tv_nsec / 1000000));
+          write_wait += wait_time;
+
+          if (debug) {
+            fprintf(stderr, "[eoscp] write=%li\n", nwrite);
+          }
+        }
+        break;
+
+        case RIO_ACCESS: {
+          eos::common::Timing::GetTimeSpec(start);
+          int64_t nwrite64;
+          nwrite64 = static_cast<eos::fst::FileIo*>(dst_handler[i].second)->fileWrite(
+                       stopwritebyte, ptr_buffer, nread);
+
+          if (nwrite64 < 0) {
+            nwrite = -1;
+          } else {
+            nwrite = (int) nwrite64;
+          }
+
+          eos::common::Timing::GetTimeSpec(end);
+          wait_time = static_cast<double>((end.tv_sec * 1000 + end.tv_nsec / 1000000) -
+                                          (start.tv_sec * 1000 + start.tv_nsec / 1000000));
+          write_wait += wait_time;
+
+          if (debug) {
+            fprintf(stderr, "[eoscp] write=%li\n", nwrite);
+          }
+        }
+        break;
+        }
+
+        if (nwrite != nread) {
+          fprintf(stderr, "error: write failed on destination file %s - "
+                  "wrote %lld/%lld bytes - destination file is incomplete!\n",
+                  dst_location[i].second.c_str(), (long long) nwrite, (long long) nread);
+          exit(-EIO);
+        }
+      }
+
+      totalbytes += nwrite;
+      stopwritebyte += nwrite;
+    } // end while(1)
+  }
 
   // Wait for all async write requests before moving on
   eos::common::Timing::GetTimeSpec(start);
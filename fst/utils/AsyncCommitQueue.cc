@@ -0,0 +1,241 @@
+// ----------------------------------------------------------------------
+// File: AsyncCommitQueue.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/utils/AsyncCommitQueue.hh"
+#include <algorithm>
+#include <cstdlib>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Get the number of commit threads
+//------------------------------------------------------------------------------
+size_t
+AsyncCommitQueue::GetNumThreads()
+{
+  static size_t sNumThreads = []() {
+    size_t num_threads = 0;
+    const char* ptr = getenv("EOS_FST_ASYNC_CLOSE_THREADS");
+
+    if (ptr) {
+      long val = strtol(ptr, nullptr, 10);
+
+      if (val > 0) {
+        num_threads = std::min((size_t) val, (size_t) 64);
+      }
+    }
+
+    return num_threads;
+  }();
+  return sNumThreads;
+}
+
+//------------------------------------------------------------------------------
+// Get the maximum number of attempts of a commit
+//------------------------------------------------------------------------------
+size_t
+AsyncCommitQueue::GetMaxAttempts()
+{
+  static size_t sMaxAttempts = []() {
+    size_t max_attempts = 10;
+    const char* ptr = getenv("EOS_FST_ASYNC_CLOSE_RETRIES");
+
+    if (ptr) {
+      long val = strtol(ptr, nullptr, 10);
+
+      if (val > 0) {
+        max_attempts = val;
+      }
+    }
+
+    return max_attempts;
+  }();
+  return sMaxAttempts;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+AsyncCommitQueue::AsyncCommitQueue(size_t num_threads, size_t max_attempts,
+                                   std::chrono::milliseconds retry_delay,
+                                   std::chrono::milliseconds max_retry_delay,
+                                   size_t max_queued):
+  mMaxAttempts(std::max(max_attempts, (size_t) 1)), mRetryDelay(retry_delay),
+  mMaxRetryDelay(std::max(max_retry_delay, retry_delay)),
+  mMaxQueued(max_queued)
+{
+  for (size_t i = 0; i < std::max(num_threads, (size_t) 1); ++i) {
+    mThreads.emplace_back(&AsyncCommitQueue::Run, this);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+AsyncCommitQueue::~AsyncCommitQueue()
+{
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mStop = true;
+  }
+  mCv.notify_all();
+
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Queue a commit
+//------------------------------------------------------------------------------
+bool
+AsyncCommitQueue::Push(const std::string& key, Job job, GiveUp give_up)
+{
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+  entry->mJob = std::move(job);
+  entry->mGiveUp = std::move(give_up);
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mStop || (mQueued >= mMaxQueued)) {
+      return false;
+    }
+
+    auto& entries = mKeys[key];
+    entries.push_back(entry);
+    ++mQueued;
+
+    // A later commit of the same key is scheduled once the previous one is
+    // finished
+    if (entries.size() > 1) {
+      return true;
+    }
+
+    mSchedule.emplace(Clock::now(), key);
+  }
+  mCv.notify_one();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Wait until there is no queued commit for a key
+//------------------------------------------------------------------------------
+bool
+AsyncCommitQueue::Wait(const std::string& key,
+                       std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mDoneCv.wait_for(lock, timeout, [&]() {
+    return (mKeys.count(key) == 0);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Get the number of queued commits
+//------------------------------------------------------------------------------
+size_t
+AsyncCommitQueue::GetQueued()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mQueued;
+}
+
+//------------------------------------------------------------------------------
+// Get the delay before the next attempt of a commit
+//------------------------------------------------------------------------------
+std::chrono::milliseconds
+AsyncCommitQueue::GetRetryDelay(size_t attempt) const
+{
+  std::chrono::milliseconds delay = mRetryDelay;
+
+  for (size_t i = 1; (i < attempt) && (delay < mMaxRetryDelay); ++i) {
+    delay *= 2;
+  }
+
+  return std::min(delay, mMaxRetryDelay);
+}
+
+//------------------------------------------------------------------------------
+// Commit thread loop
+//------------------------------------------------------------------------------
+void
+AsyncCommitQueue::Run()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  while (true) {
+    if (mSchedule.empty()) {
+      if (mStop) {
+        break;
+      }
+
+      mCv.wait(lock);
+      continue;
+    }
+
+    // When stopping the retries do not wait for their delay
+    auto it = mSchedule.begin();
+
+    if (!mStop && (it->first > Clock::now())) {
+      // The entry may be gone once woken up, wait on a copy of its time
+      Clock::time_point deadline = it->first;
+      mCv.wait_until(lock, deadline);
+      continue;
+    }
+
+    std::string key = it->second;
+    mSchedule.erase(it);
+    std::shared_ptr<Entry> entry = mKeys[key].front();
+    size_t attempt = ++entry->mAttempt;
+    lock.unlock();
+    Status status = entry->mJob(attempt);
+    lock.lock();
+
+    if (status == Status::kRetry) {
+      if (!mStop && (attempt < mMaxAttempts)) {
+        mSchedule.emplace(Clock::now() + GetRetryDelay(attempt), key);
+        continue;
+      }
+
+      if (entry->mGiveUp) {
+        lock.unlock();
+        entry->mGiveUp();
+        lock.lock();
+      }
+    }
+
+    auto& entries = mKeys[key];
+    entries.pop_front();
+    --mQueued;
+
+    if (entries.empty()) {
+      mKeys.erase(key);
+    } else {
+      mSchedule.emplace(Clock::now(), key);
+      mCv.notify_one();
+    }
+
+    mDoneCv.notify_all();
+  }
+}
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,173 @@
+// ----------------------------------------------------------------------
+// File: AsyncCommitQueue.hh
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef EOS_FST_UTILS_ASYNCCOMMITQUEUE_H
+#define EOS_FST_UTILS_ASYNCCOMMITQUEUE_H
+
+#include "fst/Namespace.hh"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class AsyncCommitQueue - runs the meta data commits of the files closed
+//! asynchronously in background threads. A commit asking to be retried is
+//! run again after a delay doubling at each attempt, up to the maximum number
+//! of attempts. The commits queued with the same key, i.e. of the same file,
+//! run one after the other in queue order. At destruction every queued commit
+//! is attempted one last time.
+//------------------------------------------------------------------------------
+class AsyncCommitQueue
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Outcome of a commit attempt
+  //----------------------------------------------------------------------------
+  enum class Status {
+    kDone, ///< commit done
+    kRetry, ///< temporary failure, the commit has to be attempted again
+    kFailed ///< permanent failure, the commit is dropped
+  };
+
+  //----------------------------------------------------------------------------
+  //! Commit function, called with the attempt number starting at 1
+  //----------------------------------------------------------------------------
+  using Job = std::function<Status(size_t attempt)>;
+
+  //----------------------------------------------------------------------------
+  //! Function called when a commit still fails after its last attempt
+  //----------------------------------------------------------------------------
+  using GiveUp = std::function<void()>;
+
+  //----------------------------------------------------------------------------
+  //! Get the number of commit threads, configured through
+  //! EOS_FST_ASYNC_CLOSE_THREADS - default 0 which disables the async close
+  //----------------------------------------------------------------------------
+  static size_t GetNumThreads();
+
+  //----------------------------------------------------------------------------
+  //! Get the maximum number of attempts of a commit, configured through
+  //! EOS_FST_ASYNC_CLOSE_RETRIES - default 10
+  //----------------------------------------------------------------------------
+  static size_t GetMaxAttempts();
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param num_threads number of commit threads
+  //! @param max_attempts maximum number of attempts of a commit
+  //! @param retry_delay delay before the first retry
+  //! @param max_retry_delay maximum delay between two attempts
+  //! @param max_queued maximum number of queued commits
+  //----------------------------------------------------------------------------
+  AsyncCommitQueue(size_t num_threads, size_t max_attempts,
+                   std::chrono::milliseconds retry_delay =
+                     std::chrono::milliseconds(1000),
+                   std::chrono::milliseconds max_retry_delay =
+                     std::chrono::milliseconds(60000),
+                   size_t max_queued = 100000);
+
+  //----------------------------------------------------------------------------
+  //! Destructor - every queued commit gets one last attempt
+  //----------------------------------------------------------------------------
+  ~AsyncCommitQueue();
+
+  AsyncCommitQueue(const AsyncCommitQueue&) = delete;
+  AsyncCommitQueue& operator=(const AsyncCommitQueue&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Queue a commit
+  //!
+  //! @param key commits with the same key run in queue order
+  //! @param job commit function
+  //! @param give_up function called if the commit fails at its last attempt
+  //!
+  //! @return true if queued, false if the queue is full or stopping and the
+  //!         caller has to commit synchronously
+  //----------------------------------------------------------------------------
+  bool Push(const std::string& key, Job job, GiveUp give_up);
+
+  //----------------------------------------------------------------------------
+  //! Wait until there is no queued commit for a key
+  //!
+  //! @param key commit key
+  //! @param timeout maximum time to wait
+  //!
+  //! @return true if there is no queued commit left, false on timeout
+  //----------------------------------------------------------------------------
+  bool Wait(const std::string& key, std::chrono::milliseconds timeout);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of queued commits, including the ones running
+  //----------------------------------------------------------------------------
+  size_t GetQueued();
+
+private:
+  //----------------------------------------------------------------------------
+  //! Queued commit
+  //----------------------------------------------------------------------------
+  struct Entry {
+    Job mJob; ///< commit function
+    GiveUp mGiveUp; ///< called if the last attempt fails
+    size_t mAttempt {0}; ///< number of attempts done
+  };
+
+  using Clock = std::chrono::steady_clock;
+
+  //----------------------------------------------------------------------------
+  //! Commit thread loop
+  //----------------------------------------------------------------------------
+  void Run();
+
+  //----------------------------------------------------------------------------
+  //! Get the delay before the next attempt of a commit
+  //----------------------------------------------------------------------------
+  std::chrono::milliseconds GetRetryDelay(size_t attempt) const;
+
+  size_t mMaxAttempts; ///< maximum attempts of a commit
+  std::chrono::milliseconds mRetryDelay; ///< delay before the first retry
+  std::chrono::milliseconds mMaxRetryDelay; ///< maximum delay between attempts
+  size_t mMaxQueued; ///< maximum number of queued commits
+  std::mutex mMutex; ///< protects the members below
+  std::condition_variable mCv; ///< signals commits to run and the stop
+  std::condition_variable mDoneCv; ///< signals finished commits
+  bool mStop {false}; ///< the commit threads have to exit
+  size_t mQueued {0}; ///< number of queued commits
+  //! Queued commits per key, the first one is scheduled or running
+  std::map<std::string, std::deque<std::shared_ptr<Entry>>> mKeys;
+  //! Keys whose first commit is waiting to run, by time of the attempt
+  std::multimap<Clock::time_point, std::string> mSchedule;
+  std::vector<std::thread> mThreads; ///< commit threads
+};
+
+EOSFSTNAMESPACE_END
+
+#endif // EOS_FST_UTILS_ASYNCCOMMITQUEUE_H
@@ -0,0 +1,336 @@
+// ----------------------------------------------------------------------
+// File: CommitBatcher.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/utils/CommitBatcher.hh"
+#include "common/Logging.hh"
+#include "common/StringConversion.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+EOSFSTNAMESPACE_BEGIN
+
+//! Maximum number of entries of a batch accepted by the MGM
+static constexpr size_t sMaxBatchEntries = 256;
+
+//------------------------------------------------------------------------------
+// Get the maximum time a commit waits for a batch
+//------------------------------------------------------------------------------
+std::chrono::milliseconds
+CommitBatcher::GetMaxDelay()
+{
+  static std::chrono::milliseconds sMaxDelay = []() {
+    long delay = 0;
+    const char* ptr = getenv("EOS_FST_COMMIT_BATCH_MS");
+
+    if (ptr) {
+      long val = strtol(ptr, nullptr, 10);
+
+      if (val > 0) {
+        delay = std::min(val, 1000l);
+      }
+    }
+
+    return std::chrono::milliseconds(delay);
+  }();
+  return sMaxDelay;
+}
+
+//------------------------------------------------------------------------------
+// Get the maximum number of commits in a batch
+//------------------------------------------------------------------------------
+size_t
+CommitBatcher::GetMaxEntries()
+{
+  static size_t sMaxEntries = []() {
+    size_t max_entries = 64;
+    const char* ptr = getenv("EOS_FST_COMMIT_BATCH_MAX");
+
+    if (ptr) {
+      long val = strtol(ptr, nullptr, 10);
+
+      if (val > 0) {
+        max_entries = std::min((size_t) val, sMaxBatchEntries);
+      }
+    }
+
+    return max_entries;
+  }();
+  return sMaxEntries;
+}
+
+//------------------------------------------------------------------------------
+// Encode commit opaques into a commitbatch query
+//------------------------------------------------------------------------------
+std::string
+CommitBatcher::EncodeBatch(const std::vector<std::string>& opaques)
+{
+  std::string query = "/?mgm.pcmd=commitbatch&mgm.batch.n=";
+  query += std::to_string(opaques.size());
+
+  for (size_t i = 0; i < opaques.size(); ++i) {
+    query += "&mgm.batch.";
+    query += std::to_string(i);
+    query += "=";
+    eos::common::StringConversion::SealXrdOpaque(opaques[i].data(),
+        opaques[i].length(), query);
+  }
+
+  return query;
+}
+
+//------------------------------------------------------------------------------
+// Decode the response to a commitbatch query
+//------------------------------------------------------------------------------
+bool
+CommitBatcher::DecodeResponse(const std::string& response, size_t num,
+                              std::vector<Result>& results)
+{
+  results.clear();
+  // The response may carry a trailing NUL from the transport
+  size_t end = response.find('\0');
+
+  if (end == std::string::npos) {
+    end = response.length();
+  }
+
+  if (response.compare(0, 2, "OK") != 0) {
+    return false;
+  }
+
+  size_t pos = 2;
+
+  while (pos < end) {
+    if (response[pos] != '\n') {
+      return false;
+    }
+
+    ++pos;
+    size_t eol = response.find('\n', pos);
+
+    if ((eol == std::string::npos) || (eol > end)) {
+      eol = end;
+    }
+
+    std::string line = response.substr(pos, eol - pos);
+    char* ptr = nullptr;
+    long code = strtol(line.c_str(), &ptr, 10);
+
+    if ((ptr == line.c_str()) || (code < 0) || (*ptr && (*ptr != ' '))) {
+      return false;
+    }
+
+    Result result;
+    result.mErrno = (int) code;
+
+    if (*ptr) {
+      result.mMsg = ptr + 1;
+    }
+
+    results.push_back(result);
+    pos = eol;
+  }
+
+  return (results.size() == num);
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+CommitBatcher::CommitBatcher(Sender sender,
+                             std::chrono::milliseconds max_delay,
+                             size_t max_entries, size_t num_threads,
+                             size_t max_bytes):
+  mSender(sender), mMaxDelay(max_delay),
+  mMaxEntries(std::max(std::min(max_entries, sMaxBatchEntries), (size_t) 1)),
+  mMaxBytes(max_bytes)
+{
+  for (size_t i = 0; i < std::max(num_threads, (size_t) 1); ++i) {
+    mThreads.emplace_back(&CommitBatcher::Run, this);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+CommitBatcher::~CommitBatcher()
+{
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mStop = true;
+  }
+  mCv.notify_all();
+
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
+
+  Result fallback;
+  fallback.mFallback = true;
+
+  for (auto& queue : mQueues) {
+    for (auto& entry : queue.second.mEntries) {
+      entry->mPromise.set_value(fallback);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Commit a replica
+//------------------------------------------------------------------------------
+CommitBatcher::Result
+CommitBatcher::Commit(const std::string& manager, const std::string& opaque)
+{
+  Result fallback;
+  fallback.mFallback = true;
+
+  // Sealed values inside the opaque would not survive the batch encoding
+  if (opaque.find("#AND#") != std::string::npos) {
+    return fallback;
+  }
+
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+  entry->mOpaque = opaque.compare(0, 2, "/?") ? opaque : opaque.substr(2);
+  entry->mQueued = std::chrono::steady_clock::now();
+  std::future<Result> future = entry->mPromise.get_future();
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mStop || mUnsupported.count(manager)) {
+      return fallback;
+    }
+
+    Queue& queue = mQueues[manager];
+    queue.mBytes += entry->mOpaque.length();
+    queue.mEntries.push_back(entry);
+  }
+  mCv.notify_one();
+  return future.get();
+}
+
+//------------------------------------------------------------------------------
+// Sender thread loop
+//------------------------------------------------------------------------------
+void
+CommitBatcher::Run()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  while (!mStop) {
+    auto now = std::chrono::steady_clock::now();
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    auto ready = mQueues.end();
+
+    for (auto it = mQueues.begin(); it != mQueues.end(); ++it) {
+      if (it->second.mEntries.empty()) {
+        continue;
+      }
+
+      auto due = it->second.mEntries.front()->mQueued + mMaxDelay;
+
+      if ((it->second.mEntries.size() >= mMaxEntries) ||
+          (it->second.mBytes >= mMaxBytes) || (due <= now)) {
+        ready = it;
+        break;
+      }
+
+      deadline = std::min(deadline, due);
+    }
+
+    if (ready == mQueues.end()) {
+      if (deadline == std::chrono::steady_clock::time_point::max()) {
+        mCv.wait(lock);
+      } else {
+        mCv.wait_until(lock, deadline);
+      }
+
+      continue;
+    }
+
+    // Take the oldest commits of the queue within the batch limits
+    std::string manager = ready->first;
+    Queue& queue = ready->second;
+    std::vector<std::shared_ptr<Entry>> batch;
+    size_t bytes = 0;
+
+    while (!queue.mEntries.empty() && (batch.size() < mMaxEntries) &&
+           (batch.empty() ||
+            (bytes + queue.mEntries.front()->mOpaque.length() <= mMaxBytes))) {
+      bytes += queue.mEntries.front()->mOpaque.length();
+      batch.push_back(queue.mEntries.front());
+      queue.mEntries.pop_front();
+    }
+
+    queue.mBytes -= bytes;
+    lock.unlock();
+    Send(manager, batch);
+    lock.lock();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Send a batch and fulfill the promises of its entries
+//------------------------------------------------------------------------------
+void
+CommitBatcher::Send(const std::string& manager,
+                    std::vector<std::shared_ptr<Entry>>& batch)
+{
+  Result fallback;
+  fallback.mFallback = true;
+  std::vector<Result> results;
+
+  // A single commit goes out as a plain commit
+  if (batch.size() > 1) {
+    std::vector<std::string> opaques;
+
+    for (const auto& entry : batch) {
+      opaques.push_back(entry->mOpaque);
+    }
+
+    std::string response;
+    int rc = mSender(manager, EncodeBatch(opaques), response);
+
+    if (rc == 0) {
+      if (!DecodeResponse(response, batch.size(), results)) {
+        eos_static_err("msg=\"malformed commit batch response\" manager=\"%s\" "
+                       "entries=%zu", manager.c_str(), batch.size());
+        results.clear();
+      }
+    } else {
+      eos_static_warning("msg=\"commit batch failed, committing one by one\" "
+                         "manager=\"%s\" entries=%zu rc=%d", manager.c_str(),
+                         batch.size(), rc);
+
+      if (rc == EINVAL) {
+        // Manager not knowing commitbatch, stop batching towards it
+        std::unique_lock<std::mutex> lock(mMutex);
+        mUnsupported.insert(manager);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    batch[i]->mPromise.set_value(results.empty() ? fallback : results[i]);
+  }
+}
+
+EOSFSTNAMESPACE_END
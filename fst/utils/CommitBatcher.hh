@@ -0,0 +1,173 @@
+// ----------------------------------------------------------------------
+// File: CommitBatcher.hh
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef EOS_FST_UTILS_COMMITBATCHER_H
+#define EOS_FST_UTILS_COMMITBATCHER_H
+
+#include "fst/Namespace.hh"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class CommitBatcher - collects the replica commits of concurrent file
+//! closes and sends them to the MGM as one commitbatch request. A commit
+//! waits at most the maximum delay for other commits to the same manager;
+//! a batch is sent earlier once it reaches the maximum number of entries or
+//! bytes. The MGM applies a batch under one namespace lock and answers with
+//! one result per entry. Commits which cannot be batched - a batch of one, a
+//! failed batch, or a manager not knowing commitbatch - are reported as
+//! fallback and the caller sends them on its own as before.
+//------------------------------------------------------------------------------
+class CommitBatcher
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Result of a commit
+  //----------------------------------------------------------------------------
+  struct Result {
+    int mErrno {0}; ///< errno reported by the MGM, 0 if successful
+    std::string mMsg; ///< error message reported by the MGM
+    bool mFallback {false}; ///< the caller has to send the commit itself
+  };
+
+  //----------------------------------------------------------------------------
+  //! Function sending an opaque query to a manager, empty for the broadcasted
+  //! manager, and returning 0 and the response if successful
+  //----------------------------------------------------------------------------
+  using Sender = std::function<int(const std::string& manager,
+                                   const std::string& opaque,
+                                   std::string& response)>;
+
+  //----------------------------------------------------------------------------
+  //! Get the maximum time a commit waits for a batch, configured through
+  //! EOS_FST_COMMIT_BATCH_MS - default 0 which disables the batching
+  //----------------------------------------------------------------------------
+  static std::chrono::milliseconds GetMaxDelay();
+
+  //----------------------------------------------------------------------------
+  //! Get the maximum number of commits in a batch, configured through
+  //! EOS_FST_COMMIT_BATCH_MAX - default 64
+  //----------------------------------------------------------------------------
+  static size_t GetMaxEntries();
+
+  //----------------------------------------------------------------------------
+  //! Encode commit opaques into a commitbatch query
+  //!
+  //! @param opaques commit opaques without the leading "/?"
+  //----------------------------------------------------------------------------
+  static std::string EncodeBatch(const std::vector<std::string>& opaques);
+
+  //----------------------------------------------------------------------------
+  //! Decode the response to a commitbatch query
+  //!
+  //! @param response "OK" followed by one "\n<errno> <message>" per entry
+  //! @param num number of entries of the batch
+  //! @param results filled with one result per entry
+  //!
+  //! @return true if the response is well formed, otherwise false
+  //----------------------------------------------------------------------------
+  static bool DecodeResponse(const std::string& response, size_t num,
+                             std::vector<Result>& results);
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param sender function sending the batches
+  //! @param max_delay maximum time a commit waits for a batch
+  //! @param max_entries maximum number of commits in a batch
+  //! @param num_threads number of batches in flight
+  //! @param max_bytes maximum size of the commit opaques of a batch
+  //----------------------------------------------------------------------------
+  CommitBatcher(Sender sender, std::chrono::milliseconds max_delay,
+                size_t max_entries, size_t num_threads = 4,
+                size_t max_bytes = 256 * 1024);
+
+  //----------------------------------------------------------------------------
+  //! Destructor - pending commits are reported as fallback
+  //----------------------------------------------------------------------------
+  ~CommitBatcher();
+
+  //----------------------------------------------------------------------------
+  //! Commit a replica, blocks until the batch containing it was answered
+  //!
+  //! @param manager manager to send the commit to, empty for the broadcasted
+  //!        manager
+  //! @param opaque commit opaque, with or without the leading "/?"
+  //----------------------------------------------------------------------------
+  Result Commit(const std::string& manager, const std::string& opaque);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Queued commit
+  //----------------------------------------------------------------------------
+  struct Entry {
+    std::string mOpaque; ///< commit opaque without the leading "/?"
+    std::promise<Result> mPromise; ///< fulfilled once the batch is answered
+    std::chrono::steady_clock::time_point mQueued; ///< time of queueing
+  };
+
+  //----------------------------------------------------------------------------
+  //! Commits queued for one manager
+  //----------------------------------------------------------------------------
+  struct Queue {
+    std::deque<std::shared_ptr<Entry>> mEntries; ///< commits in queue order
+    size_t mBytes {0}; ///< size of the queued opaques
+  };
+
+  //----------------------------------------------------------------------------
+  //! Sender thread loop
+  //----------------------------------------------------------------------------
+  void Run();
+
+  //----------------------------------------------------------------------------
+  //! Send a batch and fulfill the promises of its entries
+  //----------------------------------------------------------------------------
+  void Send(const std::string& manager,
+            std::vector<std::shared_ptr<Entry>>& batch);
+
+  Sender mSender; ///< function sending the batches
+  std::chrono::milliseconds mMaxDelay; ///< maximum wait for a batch
+  size_t mMaxEntries; ///< maximum commits per batch
+  size_t mMaxBytes; ///< maximum opaque bytes per batch
+  std::mutex mMutex; ///< protects the members below
+  std::condition_variable mCv; ///< signals new commits and the stop
+  bool mStop {false}; ///< the sender threads have to exit
+  std::map<std::string, Queue> mQueues; ///< queued commits per manager
+  std::set<std::string> mUnsupported; ///< managers without commitbatch
+  std::vector<std::thread> mThreads; ///< sender threads
+};
+
+EOSFSTNAMESPACE_END
+
+#endif // EOS_FST_UTILS_COMMITBATCHER_H
@@ -0,0 +1,317 @@
+// ----------------------------------------------------------------------
+// File: IoPriority.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/utils/IoPriority.hh"
+#include "common/Logging.hh"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#ifndef __APPLE__
+#include <sys/syscall.h>
+#endif
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// We're missing ioprio.h - 8 prio classes with 13-bits of data for each class
+//------------------------------------------------------------------------------
+#define IOPRIO_CLASS_SHIFT      (13)
+#define IOPRIO_PRIO_VALUE(class, data)  (((class) << IOPRIO_CLASS_SHIFT) | (data))
+
+//------------------------------------------------------------------------------
+// These are the io priority groups as implemented by CFQ and BFQ. RT is the
+// realtime class, BE is the best-effort scheduling class, the default for any
+// process. IDLE is only served when no one else is using the disk.
+//------------------------------------------------------------------------------
+enum {
+  IOPRIO_CLASS_NONE,
+  IOPRIO_CLASS_RT,
+  IOPRIO_CLASS_BE,
+  IOPRIO_CLASS_IDLE,
+};
+
+enum {
+  IOPRIO_WHO_PROCESS = 1,
+  IOPRIO_WHO_PGRP,
+  IOPRIO_WHO_USER,
+};
+
+EOSFSTNAMESPACE_BEGIN
+
+namespace
+{
+const char* sClassNames[IoPriority::kNumClasses] = {
+  "scrub", "scan", "delete", "balance", "drain"
+};
+
+//! Default priorities, the user IO runs in be:4
+const int sDefaultIoprio[IoPriority::kNumClasses] = {
+  IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0),
+  IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 7),
+  IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 6),
+  IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 7),
+  IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 5)
+};
+
+//------------------------------------------------------------------------------
+// IO priority syscalls of the calling thread
+//------------------------------------------------------------------------------
+int
+ioprio_set(int ioprio)
+{
+#ifdef __APPLE__
+  return 0;
+#else
+  return syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS,
+                 (pid_t) syscall(SYS_gettid), ioprio);
+#endif
+}
+
+int
+ioprio_get()
+{
+#ifdef __APPLE__
+  return 0;
+#else
+  return syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS,
+                 (pid_t) syscall(SYS_gettid));
+#endif
+}
+}
+
+//------------------------------------------------------------------------------
+// Get the name of a class
+//------------------------------------------------------------------------------
+const char*
+IoPriority::GetName(Class cls)
+{
+  if ((cls < 0) || (cls >= kNumClasses)) {
+    return "user";
+  }
+
+  return sClassNames[cls];
+}
+
+//------------------------------------------------------------------------------
+// Get the class of the IO done for an application tag of a capability
+//------------------------------------------------------------------------------
+IoPriority::Class
+IoPriority::GetClassFromApp(const std::string& app)
+{
+  if (app == "eos/draining") {
+    return kDrain;
+  }
+
+  if (app == "eos/balancing") {
+    return kBalance;
+  }
+
+  return kUser;
+}
+
+//------------------------------------------------------------------------------
+// Parse an IO priority specification
+//------------------------------------------------------------------------------
+bool
+IoPriority::Parse(const std::string& spec, int& ioprio)
+{
+  if (spec == "none") {
+    ioprio = 0;
+    return true;
+  }
+
+  if (spec == "idle") {
+    ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0);
+    return true;
+  }
+
+  if (spec == "be") {
+    ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 4);
+    return true;
+  }
+
+  if ((spec.length() == 4) && (spec.compare(0, 3, "be:") == 0) &&
+      (spec[3] >= '0') && (spec[3] <= '7')) {
+    ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, spec[3] - '0');
+    return true;
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Get the IO priority of a class
+//------------------------------------------------------------------------------
+int
+IoPriority::Get(Class cls)
+{
+  static const std::vector<int> ioprios = []() {
+    std::vector<int> values(sDefaultIoprio, sDefaultIoprio + kNumClasses);
+
+    for (int i = 0; i < kNumClasses; ++i) {
+      std::string var = "EOS_FST_IOPRIO_";
+      std::string name = sClassNames[i];
+      std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+      var += name;
+      const char* ptr = getenv(var.c_str());
+
+      if (ptr && !Parse(ptr, values[i])) {
+        eos_static_err("msg=\"invalid io priority, using default\" var=%s "
+                       "value=\"%s\"", var.c_str(), ptr);
+        values[i] = sDefaultIoprio[i];
+      }
+    }
+
+    return values;
+  }();
+
+  if ((cls < 0) || (cls >= kNumClasses)) {
+    return 0;
+  }
+
+  return ioprios[cls];
+}
+
+//------------------------------------------------------------------------------
+// Get the IO priority of the calling thread
+//------------------------------------------------------------------------------
+int
+IoPriority::GetThread()
+{
+  return ioprio_get();
+}
+
+//------------------------------------------------------------------------------
+// Set the IO priority of the calling thread
+//------------------------------------------------------------------------------
+bool
+IoPriority::SetThread(int ioprio)
+{
+  return (ioprio_set(ioprio) == 0);
+}
+
+//------------------------------------------------------------------------------
+// Tag the IO of the calling thread with the priority of a class
+//------------------------------------------------------------------------------
+bool
+IoPriority::SetThreadClass(Class cls)
+{
+  int ioprio = Get(cls);
+
+  if (ioprio == 0) {
+    return true;
+  }
+
+  if (!SetThread(ioprio)) {
+    eos_static_err("msg=\"cannot set io priority\" class=%s ioprio=%d "
+                   "errno=%d", GetName(cls), ioprio, errno);
+    return false;
+  }
+
+  eos_static_notice("msg=\"set io priority\" class=%s ioprio=%d",
+                    GetName(cls), ioprio);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+IoPriorityGuard::IoPriorityGuard(IoPriority::Class cls):
+  mOldIoprio(-1)
+{
+  int ioprio = IoPriority::Get(cls);
+
+  if (ioprio == 0) {
+    return;
+  }
+
+  int old_ioprio = IoPriority::GetThread();
+
+  if ((old_ioprio >= 0) && (old_ioprio != ioprio) &&
+      IoPriority::SetThread(ioprio)) {
+    mOldIoprio = old_ioprio;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+IoPriorityGuard::~IoPriorityGuard()
+{
+  if (mOldIoprio >= 0) {
+    (void) IoPriority::SetThread(mOldIoprio);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Set the rate limit
+//------------------------------------------------------------------------------
+void
+IoThrottle::SetRate(uint64_t bytes_per_sec)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mRate = bytes_per_sec;
+}
+
+//------------------------------------------------------------------------------
+// Reserve bandwidth for an IO
+//------------------------------------------------------------------------------
+std::chrono::microseconds
+IoThrottle::Reserve(uint64_t bytes, std::chrono::steady_clock::time_point now)
+{
+  if (mRate == 0) {
+    return std::chrono::microseconds(0);
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  uint64_t rate = mRate;
+
+  if (rate == 0) {
+    return std::chrono::microseconds(0);
+  }
+
+  if (mNext < now) {
+    mNext = now;
+  }
+
+  std::chrono::microseconds delay =
+    std::chrono::duration_cast<std::chrono::microseconds>(mNext - now);
+  mNext += std::chrono::microseconds(bytes * 1000000 / rate);
+  return delay;
+}
+
+//------------------------------------------------------------------------------
+// Reserve bandwidth for an IO and wait until it can be done
+//------------------------------------------------------------------------------
+void
+IoThrottle::Acquire(uint64_t bytes)
+{
+  std::chrono::microseconds delay = Reserve(bytes);
+
+  if (delay.count() > 0) {
+    std::this_thread::sleep_for(delay);
+  }
+}
+
+EOSFSTNAMESPACE_END
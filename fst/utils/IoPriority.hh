@@ -0,0 +1,173 @@
+// ----------------------------------------------------------------------
+// File: IoPriority.hh
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef EOS_FST_UTILS_IOPRIORITY_H
+#define EOS_FST_UTILS_IOPRIORITY_H
+
+#include "fst/Namespace.hh"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class IoPriority - IO classes of the FST background activities. Each class
+//! has a Linux IO priority applied to the threads doing its IO, by default
+//! scrub and scan in the lowest best-effort levels or idle, deletion, balancing
+//! and drain in lower best-effort levels than the user IO (be:4). The
+//! priority of a class can be changed through EOS_FST_IOPRIO_<CLASS> set to
+//! "idle", "be:<0-7>" or "none" to leave the threads untouched.
+//------------------------------------------------------------------------------
+class IoPriority
+{
+public:
+  //! IO classes, kUser is the foreground IO which is never tagged
+  enum Class {
+    kUser = -1,
+    kScrub = 0,
+    kScan,
+    kDelete,
+    kBalance,
+    kDrain,
+    kNumClasses
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the name of a class as used in the configuration keys
+  //----------------------------------------------------------------------------
+  static const char* GetName(Class cls);
+
+  //----------------------------------------------------------------------------
+  //! Get the class of the IO done for an application tag of a capability
+  //! e.g. "eos/draining", kUser if the application is not a background one
+  //----------------------------------------------------------------------------
+  static Class GetClassFromApp(const std::string& app);
+
+  //----------------------------------------------------------------------------
+  //! Parse an IO priority specification
+  //!
+  //! @param spec "idle", "be", "be:<0-7>" or "none"
+  //! @param ioprio set to the kernel IO priority value, 0 for "none"
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool Parse(const std::string& spec, int& ioprio);
+
+  //----------------------------------------------------------------------------
+  //! Get the IO priority of a class, 0 if the class is not tagged
+  //----------------------------------------------------------------------------
+  static int Get(Class cls);
+
+  //----------------------------------------------------------------------------
+  //! Get the IO priority of the calling thread
+  //----------------------------------------------------------------------------
+  static int GetThread();
+
+  //----------------------------------------------------------------------------
+  //! Set the IO priority of the calling thread
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool SetThread(int ioprio);
+
+  //----------------------------------------------------------------------------
+  //! Tag the IO of the calling thread with the priority of a class
+  //!
+  //! @return true if successful or the class is not tagged, otherwise false
+  //----------------------------------------------------------------------------
+  static bool SetThreadClass(Class cls);
+};
+
+//------------------------------------------------------------------------------
+//! Class IoPriorityGuard - tags the IO of the calling thread with a class for
+//! the lifetime of the object, used by the XRootD threads serving background
+//! transfers. The previous priority is restored on destruction.
+//------------------------------------------------------------------------------
+class IoPriorityGuard
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  IoPriorityGuard(IoPriority::Class cls);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~IoPriorityGuard();
+
+  IoPriorityGuard(const IoPriorityGuard&) = delete;
+  IoPriorityGuard& operator=(const IoPriorityGuard&) = delete;
+
+private:
+  int mOldIoprio; ///< Priority to restore, -1 if not changed
+};
+
+//------------------------------------------------------------------------------
+//! Class IoThrottle - bandwidth limit of one IO class on one filesystem. The
+//! IO requests are spaced so that their throughput does not exceed the rate,
+//! requests arriving after an idle period do not accumulate credit.
+//------------------------------------------------------------------------------
+class IoThrottle
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Set the rate limit
+  //!
+  //! @param bytes_per_sec rate in bytes per second, 0 for no limit
+  //----------------------------------------------------------------------------
+  void SetRate(uint64_t bytes_per_sec);
+
+  uint64_t GetRate() const
+  {
+    return mRate;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Reserve bandwidth for an IO
+  //!
+  //! @param bytes size of the IO
+  //! @param now current time
+  //!
+  //! @return time to wait before doing the IO
+  //----------------------------------------------------------------------------
+  std::chrono::microseconds Reserve(uint64_t bytes,
+                                    std::chrono::steady_clock::time_point now =
+                                      std::chrono::steady_clock::now());
+
+  //----------------------------------------------------------------------------
+  //! Reserve bandwidth for an IO and wait until it can be done
+  //----------------------------------------------------------------------------
+  void Acquire(uint64_t bytes);
+
+private:
+  std::mutex mMutex; ///< Protects mNext
+  std::atomic<uint64_t> mRate {0}; ///< Rate in bytes per second, 0 = no limit
+  std::chrono::steady_clock::time_point mNext; ///< Earliest start of next IO
+};
+
+EOSFSTNAMESPACE_END
+
+#endif
@@ -26,20 +26,23 @@
 
 #include "fst/utils/OpenFileTracker.hh"
 #include "common/Assert.hh"
+#include <algorithm>
 
 EOSFSTNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-OpenFileTracker::OpenFileTracker() {}
+OpenFileTracker::OpenFileTracker(eos::common::SteadyClock* clock,
+  std::chrono::seconds ioWindow) : mClock(clock), mIoWindow(ioWindow) {}
 
 //------------------------------------------------------------------------------
 // Mark that the given file ID, on the given filesystem ID, was just opened
 //------------------------------------------------------------------------------
 void OpenFileTracker::up(eos::common::FileSystem::fsid_t fsid, uint64_t fid) {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mContents[fsid][fid]++;
+  Shard& shard = getShard(fid);
+  std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+  shard.contents[fsid][fid]++;
 }
 
 //------------------------------------------------------------------------------
@@ -49,10 +52,11 @@ void OpenFileTracker::up(eos::common::FileSystem::fsid_t fsid, uint64_t fid) {
 // never go negative.
 //------------------------------------------------------------------------------
 void OpenFileTracker::down(eos::common::FileSystem::fsid_t fsid, uint64_t fid) {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+  Shard& shard = getShard(fid);
+  std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
 
-  auto fsit = mContents.find(fsid);
-  if(fsit == mContents.end()) {
+  auto fsit = shard.contents.find(fsid);
+  if(fsit == shard.contents.end()) {
     // Can happen if OpenFileTracker is misused
     eos_static_crit("Could not find fsid=%" PRIu64 " when calling OpenFileTracker::down for fid=%" PRIu64, fsid, fid);
     return;
@@ -71,7 +75,7 @@ void OpenFileTracker::down(eos::common::FileSystem::fsid_t fsid, uint64_t fid) {
 
     // Also remove fs from top-level map?
     if(fsit->second.empty()) {
-      mContents.erase(fsit);
+      shard.contents.erase(fsit);
     }
 
     return;
@@ -98,10 +102,11 @@ bool OpenFileTracker::isOpen(eos::common::FileSystem::fsid_t fsid, uint64_t fid)
 // Checks if the given file ID, on the given filesystem ID, is currently open
 //----------------------------------------------------------------------------
 int32_t OpenFileTracker::getUseCount(eos::common::FileSystem::fsid_t fsid, uint64_t fid) const {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+  const Shard& shard = getShard(fid);
+  std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
 
-  auto fsit = mContents.find(fsid);
-  if(fsit == mContents.end()) {
+  auto fsit = shard.contents.find(fsid);
+  if(fsit == shard.contents.end()) {
     return 0;
   }
 
@@ -117,8 +122,14 @@ int32_t OpenFileTracker::getUseCount(eos::common::FileSystem::fsid_t fsid, uint6
 // Checks if there's _any_ operation currently in progress
 //------------------------------------------------------------------------------
 bool OpenFileTracker::isAnyOpen() const {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-  return ! mContents.empty();
+  for(const Shard& shard : mShards) {
+    std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+    if(!shard.contents.empty()) {
+      return true;
+    }
+  }
+
+  return false;
 }
 
 //----------------------------------------------------------------------------
@@ -128,16 +139,19 @@ std::map<size_t, std::set<uint64_t>> OpenFileTracker::getSortedByUsecount(
   eos::common::FileSystem::fsid_t fsid) const {
 
   std::map<size_t, std::set<uint64_t>> contentsSortedByUsecount;
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
 
-  auto fsit = mContents.find(fsid);
-  if(fsit == mContents.end()) {
-    // Filesystem has no open files
-    return {};
-  }
+  for(const Shard& shard : mShards) {
+    std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
 
-  for(auto it = fsit->second.begin(); it != fsit->second.end(); it++) {
-    contentsSortedByUsecount[it->second].insert(it->first);
+    auto fsit = shard.contents.find(fsid);
+    if(fsit == shard.contents.end()) {
+      // No open files of this filesystem in the shard
+      continue;
+    }
+
+    for(auto it = fsit->second.begin(); it != fsit->second.end(); it++) {
+      contentsSortedByUsecount[it->second].insert(it->first);
+    }
   }
 
   return contentsSortedByUsecount;
@@ -147,14 +161,18 @@ std::map<size_t, std::set<uint64_t>> OpenFileTracker::getSortedByUsecount(
 // Get number of distinct open files by filesystem
 //----------------------------------------------------------------------------
 int32_t OpenFileTracker::getOpenOnFilesystem(eos::common::FileSystem::fsid_t fsid) const {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+  int32_t count = 0;
 
-  auto fsit = mContents.find(fsid);
-  if(fsit == mContents.end()) {
-    return 0;
+  for(const Shard& shard : mShards) {
+    std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+
+    auto fsit = shard.contents.find(fsid);
+    if(fsit != shard.contents.end()) {
+      count += fsit->second.size();
+    }
   }
 
-  return fsit->second.size();
+  return count;
 }
 
 //------------------------------------------------------------------------------
@@ -180,4 +198,116 @@ done:
   return results;
 }
 
+//------------------------------------------------------------------------------
+// Account one IO operation of the given number of bytes to a file
+//------------------------------------------------------------------------------
+void OpenFileTracker::addIo(eos::common::FileSystem::fsid_t fsid, uint64_t fid,
+  uint64_t bytes) {
+
+  std::chrono::steady_clock::time_point now = eos::common::SteadyClock::now(mClock);
+  Shard& shard = getShard(fid);
+  std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+
+  auto fsit = shard.io.find(fsid);
+  if(fsit == shard.io.end()) {
+    fsit = shard.io.emplace(fsid, IoSketch()).first;
+    fsit->second.windowStart = now;
+    fsit->second.current.reserve(kSketchSize);
+  }
+
+  IoSketch& sketch = fsit->second;
+  std::chrono::steady_clock::duration elapsed = now - sketch.windowStart;
+
+  if(elapsed >= mIoWindow) {
+    // Roll the window, the previous one is only kept if it just ended
+    if(elapsed < 2 * mIoWindow) {
+      sketch.previous.swap(sketch.current);
+      sketch.previousLength = elapsed;
+    } else {
+      sketch.previous.clear();
+    }
+
+    sketch.current.clear();
+    sketch.windowStart = now;
+  }
+
+  IoCounter* min = nullptr;
+  for(IoCounter& counter : sketch.current) {
+    if(counter.fid == fid) {
+      counter.bytes += bytes;
+      counter.ops++;
+      return;
+    }
+
+    if(!min || (counter.bytes < min->bytes)) {
+      min = &counter;
+    }
+  }
+
+  if(sketch.current.size() < kSketchSize) {
+    sketch.current.push_back({fid, bytes, 1});
+    return;
+  }
+
+  // Space-saving: the new file takes over the counts of the least busy one
+  min->fid = fid;
+  min->bytes += bytes;
+  min->ops++;
+}
+
+//------------------------------------------------------------------------------
+// Get the files with the highest IO rate on the given filesystem
+//------------------------------------------------------------------------------
+std::vector<OpenFileTracker::HotIoEntry> OpenFileTracker::getHotIo(
+  eos::common::FileSystem::fsid_t fsid, size_t maxEntries) const {
+
+  std::chrono::steady_clock::time_point now = eos::common::SteadyClock::now(mClock);
+  std::vector<HotIoEntry> results;
+
+  for(const Shard& shard : mShards) {
+    std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+
+    auto fsit = shard.io.find(fsid);
+    if(fsit == shard.io.end()) {
+      continue;
+    }
+
+    // Report the last complete window: the current one if it is over but no
+    // IO came in since, to roll it, otherwise the previous one. Nothing if the
+    // roll would drop both.
+    const IoSketch& sketch = fsit->second;
+    std::chrono::steady_clock::duration elapsed = now - sketch.windowStart;
+    const std::vector<IoCounter>* counters = &sketch.previous;
+    std::chrono::steady_clock::duration length = sketch.previousLength;
+
+    if(elapsed >= 2 * mIoWindow) {
+      continue;
+    } else if(elapsed >= mIoWindow) {
+      counters = &sketch.current;
+      length = elapsed;
+    }
+
+    double seconds = std::chrono::duration<double>(length).count();
+    if(seconds <= 0) {
+      continue;
+    }
+
+    for(const IoCounter& counter : *counters) {
+      results.push_back({fsid, counter.fid, counter.bytes / seconds,
+                         counter.ops / seconds});
+    }
+  }
+
+  std::sort(results.begin(), results.end(),
+    [](const HotIoEntry& a, const HotIoEntry& b) {
+      return a.bytesPerSec > b.bytesPerSec;
+    });
+
+  if(results.size() > maxEntries) {
+    results.resize(maxEntries);
+  }
+
+  return results;
+}
+
 EOSFSTNAMESPACE_END
@@ -26,6 +26,8 @@
 
 #include "fst/Namespace.hh"
 #include "common/FileSystem.hh"
+#include "common/SteadyClock.hh"
+#include <chrono>
 #include <shared_mutex>
 
 EOSFSTNAMESPACE_BEGIN
@@ -36,13 +38,24 @@ EOSFSTNAMESPACE_BEGIN
 //!
 //! Thread-safe. To track both "open-for-read" and "open-for-write" files,
 //! use two different objects.
+//!
+//! The tracker is split into shards by file ID, each with its own lock, so
+//! that opens, closes and IO accounting of different files rarely contend.
+//! Besides the use counts, every shard keeps the bytes and operations of the
+//! busiest files of each filesystem in a space-saving sketch of fixed size,
+//! over windows of fixed length. Memory is bounded by the number of
+//! filesystems, not by the number of files ever accessed.
 //------------------------------------------------------------------------------
 class OpenFileTracker {
 public:
   //----------------------------------------------------------------------------
   //! Constructor
+  //!
+  //! @param clock clock used for the IO windows, fake one for tests
+  //! @param ioWindow length of the IO accounting windows
   //----------------------------------------------------------------------------
-  OpenFileTracker();
+  OpenFileTracker(eos::common::SteadyClock* clock = nullptr,
+                  std::chrono::seconds ioWindow = std::chrono::seconds(30));
 
   //----------------------------------------------------------------------------
   //! Mark that the given file ID, on the given filesystem ID, was just opened
@@ -107,9 +120,60 @@ public:
 
   std::vector<HotEntry> getHotFiles(eos::common::FileSystem::fsid_t fsid, size_t maxEntries) const;
 
+  //----------------------------------------------------------------------------
+  //! Account one IO operation of the given number of bytes to a file
+  //----------------------------------------------------------------------------
+  void addIo(eos::common::FileSystem::fsid_t fsid, uint64_t fid, uint64_t bytes);
+
+  //----------------------------------------------------------------------------
+  //! IO rates of a file over the last complete window
+  //----------------------------------------------------------------------------
+  struct HotIoEntry {
+    eos::common::FileSystem::fsid_t fsid;
+    uint64_t fid;
+    double bytesPerSec;
+    double iops;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the files with the highest IO rate on the given filesystem, sorted by
+  //! decreasing bytes per second. Rates of files which entered the sketch late
+  //! are overestimated by at most the traffic of the file they replaced.
+  //----------------------------------------------------------------------------
+  std::vector<HotIoEntry> getHotIo(eos::common::FileSystem::fsid_t fsid,
+                                   size_t maxEntries) const;
+
 private:
-  mutable std::shared_timed_mutex mMutex;
-  std::map<eos::common::FileSystem::fsid_t, std::map<uint64_t, int32_t>> mContents;
+  static constexpr size_t kNumShards = 16;
+  //! Sketch entries per shard and filesystem
+  static constexpr size_t kSketchSize = 16;
+
+  struct IoCounter {
+    uint64_t fid;
+    uint64_t bytes;
+    uint64_t ops;
+  };
+
+  struct IoSketch {
+    std::chrono::steady_clock::time_point windowStart;
+    std::chrono::steady_clock::duration previousLength;
+    std::vector<IoCounter> current;
+    std::vector<IoCounter> previous;
+  };
+
+  struct Shard {
+    mutable std::shared_timed_mutex mutex;
+    std::map<eos::common::FileSystem::fsid_t, std::map<uint64_t, int32_t>> contents;
+    std::map<eos::common::FileSystem::fsid_t, IoSketch> io;
+  };
+
+  Shard& getShard(uint64_t fid) const {
+    return mShards[fid % kNumShards];
+  }
+
+  eos::common::SteadyClock* mClock;
+  std::chrono::steady_clock::duration mIoWindow;
+  mutable Shard mShards[kNumShards];
 };
 
 EOSFSTNAMESPACE_END
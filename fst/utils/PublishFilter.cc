@@ -0,0 +1,154 @@
+// ----------------------------------------------------------------------
+// File: PublishFilter.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/utils/PublishFilter.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Get the relative tolerance for floating point values
+//------------------------------------------------------------------------------
+double
+PublishFilter::GetTolerance()
+{
+  static double sTolerance = []() {
+    const char* ptr = getenv("EOS_FST_PUBLISH_TOLERANCE");
+    double val = (ptr ? strtod(ptr, nullptr) : -1.0);
+    return ((val >= 0.0) ? val : 0.01);
+  }();
+  return sTolerance;
+}
+
+//------------------------------------------------------------------------------
+// Get the full refresh interval
+//------------------------------------------------------------------------------
+std::chrono::seconds
+PublishFilter::GetRefreshInterval()
+{
+  static std::chrono::seconds sRefresh = []() {
+    const char* ptr = getenv("EOS_FST_PUBLISH_REFRESH_SEC");
+    long val = (ptr ? strtol(ptr, nullptr, 10) : -1);
+    return std::chrono::seconds((val >= 0) ? val : 60);
+  }();
+  return sRefresh;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+PublishFilter::PublishFilter(double tolerance, std::chrono::seconds refresh):
+  mTolerance(tolerance), mRefresh(refresh)
+{}
+
+//------------------------------------------------------------------------------
+// Start a publishing cycle
+//------------------------------------------------------------------------------
+void
+PublishFilter::BeginCycle(std::chrono::steady_clock::time_point now)
+{
+  mRefreshCycle = (mValues.empty() || (now - mLastRefresh >= mRefresh));
+
+  if (mRefreshCycle) {
+    mLastRefresh = now;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check if a string value has to be published
+//------------------------------------------------------------------------------
+bool
+PublishFilter::Changed(const std::string& subject, const std::string& key,
+                       const std::string& value)
+{
+  Value& val = mValues[subject][key];
+  bool changed = (!val.mSet || val.mIsNum || (val.mStr != value));
+
+  if (!Decide(changed)) {
+    return false;
+  }
+
+  val.mSet = true;
+  val.mIsNum = false;
+  val.mStr = value;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Check if an integer value has to be published
+//------------------------------------------------------------------------------
+bool
+PublishFilter::Changed(const std::string& subject, const std::string& key,
+                       long long value)
+{
+  return Changed(subject, key, std::to_string(value));
+}
+
+//------------------------------------------------------------------------------
+// Check if a floating point value has to be published
+//------------------------------------------------------------------------------
+bool
+PublishFilter::Changed(const std::string& subject, const std::string& key,
+                       double value)
+{
+  Value& val = mValues[subject][key];
+  bool changed = (!val.mSet || !val.mIsNum ||
+                  (std::fabs(value - val.mNum) >
+                   mTolerance * std::max(std::fabs(val.mNum), 1.0)));
+
+  if (!Decide(changed)) {
+    return false;
+  }
+
+  val.mSet = true;
+  val.mIsNum = true;
+  val.mNum = value;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Forget the values of a subject
+//------------------------------------------------------------------------------
+void
+PublishFilter::Forget(const std::string& subject)
+{
+  mValues.erase(subject);
+}
+
+//------------------------------------------------------------------------------
+// Account for a value and return its decision
+//------------------------------------------------------------------------------
+bool
+PublishFilter::Decide(bool changed)
+{
+  if (changed || mRefreshCycle) {
+    ++mPublished;
+    return true;
+  }
+
+  ++mSuppressed;
+  return false;
+}
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,135 @@
+// ----------------------------------------------------------------------
+// File: PublishFilter.hh
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef EOS_FST_UTILS_PUBLISHFILTER_H
+#define EOS_FST_UTILS_PUBLISHFILTER_H
+
+#include "fst/Namespace.hh"
+#include <chrono>
+#include <map>
+#include <string>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class PublishFilter - remembers the last values published for each subject
+//! (filesystem or node queue) and key, so that the publisher only broadcasts
+//! the values which changed. Strings and integers are published on any
+//! change, floating point values only if they moved by more than the
+//! tolerance. Every refresh interval all values are published again, which
+//! repairs the state of observers that missed an update.
+//------------------------------------------------------------------------------
+class PublishFilter
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Get the relative tolerance for floating point values, configured through
+  //! EOS_FST_PUBLISH_TOLERANCE - default 0.01
+  //----------------------------------------------------------------------------
+  static double GetTolerance();
+
+  //----------------------------------------------------------------------------
+  //! Get the full refresh interval, configured through
+  //! EOS_FST_PUBLISH_REFRESH_SEC - default 60 seconds
+  //----------------------------------------------------------------------------
+  static std::chrono::seconds GetRefreshInterval();
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param tolerance relative change of a floating point value which is
+  //!        published, changes smaller than tolerance in absolute value are
+  //!        also ignored
+  //! @param refresh interval after which all values are published again
+  //----------------------------------------------------------------------------
+  PublishFilter(double tolerance, std::chrono::seconds refresh);
+
+  //----------------------------------------------------------------------------
+  //! Start a publishing cycle, deciding if all values have to be published
+  //!
+  //! @param now current time
+  //----------------------------------------------------------------------------
+  void BeginCycle(std::chrono::steady_clock::time_point now =
+                    std::chrono::steady_clock::now());
+
+  //----------------------------------------------------------------------------
+  //! Check if a value has to be published, remembering it if so
+  //!
+  //! @param subject filesystem or node queue
+  //! @param key key of the value
+  //! @param value new value
+  //!
+  //! @return true if the value has to be published
+  //----------------------------------------------------------------------------
+  bool Changed(const std::string& subject, const std::string& key,
+               const std::string& value);
+  bool Changed(const std::string& subject, const std::string& key,
+               long long value);
+  bool Changed(const std::string& subject, const std::string& key,
+               double value);
+
+  //----------------------------------------------------------------------------
+  //! Forget the values of a subject e.g. a removed filesystem
+  //----------------------------------------------------------------------------
+  void Forget(const std::string& subject);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of values published and suppressed since the construction
+  //----------------------------------------------------------------------------
+  inline uint64_t GetNumPublished() const
+  {
+    return mPublished;
+  }
+
+  inline uint64_t GetNumSuppressed() const
+  {
+    return mSuppressed;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Last published value
+  //----------------------------------------------------------------------------
+  struct Value {
+    bool mSet {false}; ///< A value was published
+    bool mIsNum {false}; ///< The value is a floating point one
+    std::string mStr;
+    double mNum {0};
+  };
+
+  //----------------------------------------------------------------------------
+  //! Account for a value and return its decision
+  //----------------------------------------------------------------------------
+  bool Decide(bool changed);
+
+  double mTolerance;
+  std::chrono::seconds mRefresh;
+  std::chrono::steady_clock::time_point mLastRefresh;
+  bool mRefreshCycle {true}; ///< Publish all values in the current cycle
+  std::map<std::string, std::map<std::string, Value>> mValues;
+  uint64_t mPublished {0};
+  uint64_t mSuppressed {0};
+};
+
+EOSFSTNAMESPACE_END
+
+#endif
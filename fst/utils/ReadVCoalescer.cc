@@ -0,0 +1,155 @@
+// ----------------------------------------------------------------------
+// File: ReadVCoalescer.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/utils/ReadVCoalescer.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Get the global statistics
+//------------------------------------------------------------------------------
+ReadVCoalescer::Stats&
+ReadVCoalescer::GetStats()
+{
+  static Stats sStats;
+  return sStats;
+}
+
+//------------------------------------------------------------------------------
+// Get the maximum gap between chunks which are merged
+//------------------------------------------------------------------------------
+uint32_t
+ReadVCoalescer::GetMaxGap()
+{
+  static uint32_t sMaxGap = []() {
+    uint32_t max_gap = 32 * 1024;
+    const char* ptr = getenv("EOS_FST_READV_MAX_GAP");
+
+    if (ptr) {
+      long val = strtol(ptr, nullptr, 10);
+
+      if (val >= 0) {
+        max_gap = (uint32_t) std::min(val, 1024l * 1024);
+      }
+    }
+
+    return max_gap;
+  }();
+  return sMaxGap;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ReadVCoalescer::ReadVCoalescer(const XrdOucIOVec* readV, uint32_t count,
+                               uint32_t max_gap, uint32_t max_length):
+  mReadV(readV), mCount(count), mReqLength(0), mReadLength(0)
+{
+  mOrder.resize(count);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    mOrder[i] = i;
+    mReqLength += readV[i].size;
+  }
+
+  std::stable_sort(mOrder.begin(), mOrder.end(),
+  [readV](uint32_t a, uint32_t b) {
+    return (readV[a].offset < readV[b].offset);
+  });
+  // Build the groups of chunks that are close enough to each other
+  uint64_t buffer_size = 0;
+  uint32_t pos = 0;
+
+  while (pos < count) {
+    const XrdOucIOVec& first = readV[mOrder[pos]];
+    long long start = first.offset;
+    long long end = first.offset + first.size;
+    uint32_t last = pos + 1;
+
+    while (last < count) {
+      const XrdOucIOVec& next = readV[mOrder[last]];
+      long long next_end = std::max(end, next.offset + next.size);
+
+      if ((next.offset > end + max_gap) || (next_end - start > max_length)) {
+        break;
+      }
+
+      end = next_end;
+      ++last;
+    }
+
+    XrdOucIOVec merged;
+    memset(&merged, 0, sizeof(merged));
+    merged.offset = start;
+    merged.size = (int)(end - start);
+
+    if (last - pos == 1) {
+      merged.data = first.data;
+    } else {
+      // Buffer is assigned after all the groups are known
+      buffer_size += merged.size;
+    }
+
+    mGroups.push_back(Group{pos, last});
+    mMerged.push_back(merged);
+    mReadLength += merged.size;
+    pos = last;
+  }
+
+  if (buffer_size) {
+    mBuffer.reset(new char[buffer_size]);
+    char* ptr = mBuffer.get();
+
+    for (size_t i = 0; i < mGroups.size(); ++i) {
+      if (mGroups[i].mLast - mGroups[i].mFirst > 1) {
+        mMerged[i].data = ptr;
+        ptr += mMerged[i].size;
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Copy the data of the merged reads into the original chunk buffers
+//------------------------------------------------------------------------------
+void
+ReadVCoalescer::Scatter() const
+{
+  for (size_t i = 0; i < mGroups.size(); ++i) {
+    const Group& grp = mGroups[i];
+
+    if (grp.mLast - grp.mFirst == 1) {
+      continue;
+    }
+
+    for (uint32_t j = grp.mFirst; j < grp.mLast; ++j) {
+      const XrdOucIOVec& chunk = mReadV[mOrder[j]];
+      memcpy(chunk.data, mMerged[i].data + (chunk.offset - mMerged[i].offset),
+             chunk.size);
+    }
+  }
+}
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,142 @@
+// ----------------------------------------------------------------------
+// File: ReadVCoalescer.hh
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef EOS_FST_UTILS_READVCOALESCER_H
+#define EOS_FST_UTILS_READVCOALESCER_H
+
+#include "fst/Namespace.hh"
+#include "XrdOuc/XrdOucIOVec.hh"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class ReadVCoalescer - merges the chunks of a vector read which are close
+//! to each other into bigger reads. Chunks are merged if the gap between them
+//! is at most the given threshold. Merged reads go into an internal buffer and
+//! Scatter copies the data back into the original chunk buffers. Chunks which
+//! are not merged with any other chunk are read directly into their buffer.
+//------------------------------------------------------------------------------
+class ReadVCoalescer
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Global vector read statistics
+  //----------------------------------------------------------------------------
+  struct Stats {
+    std::atomic<uint64_t> mReqBytes {0}; ///< Bytes requested by the clients
+    std::atomic<uint64_t> mReadBytes {0}; ///< Bytes read including the gaps
+    std::atomic<uint64_t> mReqChunks {0}; ///< Chunks requested by the clients
+    std::atomic<uint64_t> mReadChunks {0}; ///< Chunks read after merging
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the global statistics
+  //----------------------------------------------------------------------------
+  static Stats& GetStats();
+
+  //----------------------------------------------------------------------------
+  //! Get the maximum gap between chunks which are merged, configured through
+  //! EOS_FST_READV_MAX_GAP - 0 disables the coalescing
+  //----------------------------------------------------------------------------
+  static uint32_t GetMaxGap();
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param readV original vector read, must outlive the object
+  //! @param count number of chunks
+  //! @param max_gap maximum gap between chunks that are merged
+  //! @param max_length maximum length of a merged read
+  //----------------------------------------------------------------------------
+  ReadVCoalescer(const XrdOucIOVec* readV, uint32_t count, uint32_t max_gap,
+                 uint32_t max_length = 8 * 1024 * 1024);
+
+  //----------------------------------------------------------------------------
+  //! Check if any chunks were merged
+  //----------------------------------------------------------------------------
+  inline bool IsCoalesced() const
+  {
+    return (mMerged.size() < mCount);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the merged vector read
+  //----------------------------------------------------------------------------
+  inline XrdOucIOVec* GetReadV()
+  {
+    return mMerged.data();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the number of merged chunks
+  //----------------------------------------------------------------------------
+  inline uint32_t GetReadCount() const
+  {
+    return mMerged.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the number of bytes requested by the original vector read
+  //----------------------------------------------------------------------------
+  inline uint64_t GetReqLength() const
+  {
+    return mReqLength;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the number of bytes of the merged vector read
+  //----------------------------------------------------------------------------
+  inline uint64_t GetReadLength() const
+  {
+    return mReadLength;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Copy the data of the merged reads into the original chunk buffers
+  //----------------------------------------------------------------------------
+  void Scatter() const;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Merged read covering a range of the sorted chunks
+  //----------------------------------------------------------------------------
+  struct Group {
+    uint32_t mFirst; ///< First index in mOrder
+    uint32_t mLast; ///< One past the last index in mOrder
+  };
+
+  const XrdOucIOVec* mReadV; ///< Original vector read
+  uint32_t mCount; ///< Number of original chunks
+  uint64_t mReqLength; ///< Requested length
+  uint64_t mReadLength; ///< Length of the merged reads
+  std::vector<uint32_t> mOrder; ///< Original chunks sorted by offset
+  std::vector<Group> mGroups; ///< Merged groups, same order as mMerged
+  std::vector<XrdOucIOVec> mMerged; ///< Merged vector read
+  std::unique_ptr<char[]> mBuffer; ///< Buffer for the merged reads
+};
+
+EOSFSTNAMESPACE_END
+
+#endif
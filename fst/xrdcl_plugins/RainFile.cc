@@ -27,19 +27,53 @@
 #include "fst/layout/RaidDpLayout.hh"
 #include "fst/layout/ReedSLayout.hh"
 /*----------------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstring>
+/*----------------------------------------------------------------------------*/
 
 using namespace eos::common;
 using namespace eos::fst;
 
 EOSFSTNAMESPACE_BEGIN
 
+namespace
+{
+//------------------------------------------------------------------------------
+// Number of groups in a read-ahead window, set by EOS_RAIN_READAHEAD_GROUPS,
+// 0 disables the read-ahead
+//------------------------------------------------------------------------------
+uint64_t
+GetReadAheadGroups()
+{
+  static uint64_t groups = []() {
+    uint64_t value = 2;
+
+    if (getenv("EOS_RAIN_READAHEAD_GROUPS")) {
+      try {
+        value = std::stoull(getenv("EOS_RAIN_READAHEAD_GROUPS"));
+      } catch (...) {
+        // keep the default value
+      }
+    }
+
+    return value;
+  }();
+  return groups;
+}
+
+//! Read length of the layout is an int, keep the windows well below
+const uint64_t sMaxWindowSize = 256 * 1024 * 1024;
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 RainFile::RainFile():
   mIsOpen(false),
   pFile(0),
-  pRainFile(0)
+  pRainFile(0),
+  mWindowSize(0),
+  mLastEnd(0)
 {
   eos_debug("calling constructor");
 }
@@ -51,6 +85,7 @@ RainFile::RainFile():
 RainFile::~RainFile()
 {
   eos_debug("calling destructor");
+  DropReadAhead();
 
   if (pFile) {
     delete pFile;
@@ -146,7 +181,15 @@ RainFile::Open(const std::string& url,
           if (pRainFile->OpenPio(stripeUrls, SFS_O_RDONLY, mode, opaqueInfo)) {
             eos_err("failed PIO open for path=%s", url.c_str());
             delete pRainFile;
+            pRainFile = 0;
             st = XRootDStatus(stError, errInvalidOp, 0, "failed PIO open");
+          } else {
+            // Sequential reads are served from windows of whole groups read
+            // ahead from all the data stripes in parallel
+            mWindowSize = std::min(GetReadAheadGroups() *
+                                   pRainFile->GetSizeGroup(), sMaxWindowSize);
+            mWindowSize -= mWindowSize % pRainFile->GetSizeGroup();
+            eos_debug("read-ahead window=%llu", mWindowSize);
           }
         } else {
           eos_err("no RAIN file allocated");
@@ -196,6 +239,7 @@ RainFile::Close(ResponseHandler* handler,
     if (pFile) {
       st = pFile->Close(handler, timeout);
     } else {
+      DropReadAhead();
       int retc = pRainFile->Close();
 
       if (retc) {
@@ -276,7 +320,30 @@ RainFile::Read(uint64_t offset,
   if (pFile) {
     st = pFile->Read(offset, size, buffer, handler, timeout);
   } else {
-    int64_t retc = pRainFile->Read(offset, (char*)buffer, size);
+    int64_t retc = -1;
+    {
+      std::unique_lock<std::mutex> lock(mReadAheadMutex);
+      bool in_window = (!mWindows.empty() &&
+                        (offset >= mWindows.front()->mOffset) &&
+                        (offset < mWindows.back()->mOffset + mWindowSize));
+
+      if (mWindowSize && (size < mWindowSize) &&
+          ((offset == mLastEnd) || in_window)) {
+        retc = ReadFromWindows(offset, size, (char*)buffer);
+      }
+
+      if (retc == -1) {
+        // Random or large reads go directly to the stripes, a failed window
+        // is read again here to run the recovery for this request
+        lock.unlock();
+        retc = pRainFile->Read(offset, (char*)buffer, size);
+        lock.lock();
+      }
+
+      if (retc != -1) {
+        mLastEnd = offset + retc;
+      }
+    }
 
     if (retc == -1) {
       st = XRootDStatus(stError, errUnknown);
@@ -293,6 +360,108 @@ RainFile::Read(uint64_t offset,
 }
 
 
+//------------------------------------------------------------------------------
+// Start reading the window at the given offset in the background
+//------------------------------------------------------------------------------
+std::shared_ptr<RainFile::ReadAheadWindow>
+RainFile::StartReadAhead(uint64_t offset)
+{
+  auto window = std::make_shared<ReadAheadWindow>();
+  window->mOffset = offset;
+  window->mData.swap(mSpare);
+  window->mData.resize(mWindowSize);
+  // The task must not hold the window, it is kept alive by the blocking
+  // destructor of the future which is the last owner of the task state
+  RaidMetaLayout* layout = pRainFile;
+  char* data = window->mData.data();
+  XrdSfsXferSize length = static_cast<XrdSfsXferSize>(mWindowSize);
+  window->mNread = std::async(std::launch::async, [layout, offset, data,
+  length]() {
+    return layout->Read(offset, data, length);
+  }).share();
+  eos_debug("read-ahead offset=%llu length=%i", offset, length);
+  return window;
+}
+
+
+//------------------------------------------------------------------------------
+// Serve a sequential read from the read-ahead windows
+//------------------------------------------------------------------------------
+int64_t
+RainFile::ReadFromWindows(uint64_t offset, uint32_t size, char* buffer)
+{
+  uint64_t pos = offset;
+  uint64_t end = offset + size;
+
+  while (pos < end) {
+    std::shared_ptr<ReadAheadWindow> window;
+
+    for (auto it = mWindows.begin(); it != mWindows.end(); ++it) {
+      if ((pos >= (*it)->mOffset) && (pos < (*it)->mOffset + mWindowSize)) {
+        window = *it;
+        break;
+      }
+    }
+
+    if (!window) {
+      // Restart the read-ahead at the group of this read
+      DropReadAhead();
+      window = StartReadAhead(pos - (pos % pRainFile->GetSizeGroup()));
+      mWindows.push_back(window);
+    }
+
+    int64_t nread = window->mNread.get();
+
+    if (nread < 0) {
+      eos_warning("read-ahead failed offset=%llu", window->mOffset);
+      DropReadAhead();
+      return -1;
+    }
+
+    // Windows before the current one are consumed, the next window has to
+    // be in flight while this one is read
+    while (mWindows.front() != window) {
+      mWindows.front()->mNread.wait();
+      mSpare.swap(mWindows.front()->mData);
+      mWindows.pop_front();
+    }
+
+    if (((uint64_t) nread == mWindowSize) && (mWindows.size() == 1)) {
+      mWindows.push_back(StartReadAhead(window->mOffset + mWindowSize));
+    }
+
+    uint64_t window_end = window->mOffset + nread;
+
+    if (pos >= window_end) {
+      // End of file
+      break;
+    }
+
+    uint64_t len = std::min(end, window_end) - pos;
+    memcpy(buffer + (pos - offset), window->mData.data() +
+           (pos - window->mOffset), len);
+    pos += len;
+  }
+
+  return pos - offset;
+}
+
+
+//------------------------------------------------------------------------------
+// Wait for the pending read-ahead and drop the windows
+//------------------------------------------------------------------------------
+void
+RainFile::DropReadAhead()
+{
+  for (auto it = mWindows.begin(); it != mWindows.end(); ++it) {
+    (*it)->mNread.wait();
+    mSpare.swap((*it)->mData);
+  }
+
+  mWindows.clear();
+}
+
+
 //------------------------------------------------------------------------------
 // Write
 //------------------------------------------------------------------------------
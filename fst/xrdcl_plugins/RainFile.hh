@@ -29,6 +29,12 @@
 #include "common/Logging.hh"
 #include "XrdCl/XrdClPlugInInterface.hh"
 /*----------------------------------------------------------------------------*/
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+/*----------------------------------------------------------------------------*/
 
 using namespace XrdCl;
 
@@ -179,10 +185,42 @@ class RainFile: public XrdCl::FilePlugIn, eos::common::LogId
   
  private:
 
+  //----------------------------------------------------------------------------
+  //! Window of consecutive groups read ahead in the background, the reads
+  //! of a window are issued to all the data stripes at once
+  //----------------------------------------------------------------------------
+  struct ReadAheadWindow
+  {
+    uint64_t mOffset; ///< file offset of the window
+    std::vector<char> mData; ///< data of the window
+    std::shared_future<int64_t> mNread; ///< bytes read or -1 if error
+  };
+
+  //----------------------------------------------------------------------------
+  //! Start reading the window at the given offset in the background
+  //----------------------------------------------------------------------------
+  std::shared_ptr<ReadAheadWindow> StartReadAhead( uint64_t offset );
+
+  //----------------------------------------------------------------------------
+  //! Serve a sequential read from the read-ahead windows
+  //!
+  //! @return number of bytes read or -1 if a window failed
+  //----------------------------------------------------------------------------
+  int64_t ReadFromWindows( uint64_t offset, uint32_t size, char* buffer );
+
+  //----------------------------------------------------------------------------
+  //! Wait for the pending read-ahead and drop the windows
+  //----------------------------------------------------------------------------
+  void DropReadAhead();
+
   bool mIsOpen; 
   XrdCl::File* pFile;
   eos::fst::RaidMetaLayout *pRainFile;
-  
+  uint64_t mWindowSize; ///< size of a read-ahead window, 0 if disabled
+  uint64_t mLastEnd; ///< end of the last read to detect sequential reads
+  std::list< std::shared_ptr<ReadAheadWindow> > mWindows; ///< current, next
+  std::vector<char> mSpare; ///< buffer of the last dropped window
+  std::mutex mReadAheadMutex; ///< protects the read-ahead state
 };
 
 EOSFSTNAMESPACE_END
@@ -174,7 +174,8 @@ public:
     connectionId(0)
   {
     uidCache = new ShardedCache<CredKey, uint64_t, CredKeyHasher>
-    (16 /* 16 shard bits */, 1000 * 60 * 60 * 3 /* 3 hours */);
+    (16 /* 16 shard bits */, 1000 * 60 * 60 * 3 /* 3 hours */,
+     8 /* 2^19 connections */);
     resize(proccachenbins);
   }
 
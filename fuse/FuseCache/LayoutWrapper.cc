@@ -24,6 +24,7 @@
 #include "../MacOSXHelper.hh"
 #include "LayoutWrapper.hh"
 #include "FileAbstraction.hh"
+#include "ReadBlockCache.hh"
 #include "common/Logging.hh"
 #include "common/LayoutId.hh"
 #include "common/InodeTranslator.hh"
@@ -32,7 +33,9 @@
 #include "fst/layout/ReedSLayout.hh"
 #include "../xrdutils.hh"
 #include "../GlobalInodeTranslator.hh"
+#include <algorithm>
 #include <thread>
+#include <vector>
 
 XrdSysMutex LayoutWrapper::gCacheAuthorityMutex;
 std::map<unsigned long long, LayoutWrapper::CacheEntry>
@@ -772,13 +775,53 @@ int LayoutWrapper::Open(const std::string& path, XrdSfsFileOpenMode flags,
 int64_t LayoutWrapper::Read(XrdSfsFileOffset offset, char* buffer,
                             XrdSfsXferSize length, bool readahead)
 {
+  ReadBlockCache* rcache = ReadBlockCache::GetInstance();
+  timespec mtime = mLocalUtime[0];
+  // only read-only opens with a known modification time share the block cache
+  bool cacheable = rcache && mInode && (length > 0) &&
+                   (mtime.tv_sec || mtime.tv_nsec) &&
+                   !(mFlags & (SFS_O_WRONLY | SFS_O_RDWR));
+
+  if (cacheable) {
+    int64_t nread = rcache->Read(mInode, mtime, buffer, offset, length);
+
+    if (nread >= 0) {
+      return nread;
+    }
+  }
+
   if (MakeOpen()) {
     errno = EBADF;
     return -1;
   }
 
   eos::common::RWMutexReadLock rd_lock(mMakeOpenMutex);
-  return mFile->Read(offset, buffer, length, readahead);
+
+  if (!cacheable) {
+    return mFile->Read(offset, buffer, length, readahead);
+  }
+
+  // read the complete blocks covering the request to store them
+  off_t bsize = rcache->GetBlockSize();
+  off_t start = offset - (offset % bsize);
+  off_t end = ((offset + length + bsize - 1) / bsize) * bsize;
+  std::vector<char> blocks(end - start);
+  int64_t nread = mFile->Read(start, blocks.data(), end - start, readahead);
+
+  if (nread < 0) {
+    return nread;
+  }
+
+  rcache->Store(mInode, mtime, blocks.data(), start, nread,
+                nread < (end - start));
+
+  if (nread <= (offset - start)) {
+    return 0;
+  }
+
+  nread = std::min((int64_t) length, nread - (offset - start));
+  memcpy(buffer, blocks.data() + (offset - start), nread);
+  return nread;
 }
 
 //------------------------------------------------------------------------------
@@ -872,6 +915,10 @@ int64_t LayoutWrapper::Write(XrdSfsFileOffset offset, const char* buffer,
   if (length > 0) {
     eos::common::RWMutexReadLock rd_lock(mMakeOpenMutex);
 
+    if (ReadBlockCache::GetInstance()) {
+      ReadBlockCache::GetInstance()->Invalidate(mInode);
+    }
+
     if ((retc = mFile->Write(offset, buffer, length)) < 0) {
       eos_static_err("Error writing from wrapper : file %s  opaque %s",
                      mPath.c_str(), mOpaque.c_str());
@@ -895,6 +942,10 @@ int LayoutWrapper::Truncate(XrdSfsFileOffset offset, bool touchMtime)
   {
     eos::common::RWMutexReadLock rd_lock(mMakeOpenMutex);
 
+    if (ReadBlockCache::GetInstance()) {
+      ReadBlockCache::GetInstance()->Invalidate(mInode);
+    }
+
     if (mFile->Truncate(offset)) {
       return -1;
     }
@@ -0,0 +1,200 @@
+//------------------------------------------------------------------------------
+// File: ReadBlockCache.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+#include "ReadBlockCache.hh"
+#include <algorithm>
+#include <string.h>
+//------------------------------------------------------------------------------
+
+ReadBlockCache* ReadBlockCache::pInstance = NULL;
+
+//------------------------------------------------------------------------------
+// Enable the read cache
+//------------------------------------------------------------------------------
+void
+ReadBlockCache::Enable(size_t sizeMax, size_t blockSize)
+{
+  if (!pInstance && sizeMax && blockSize) {
+    pInstance = new ReadBlockCache(sizeMax, blockSize);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ReadBlockCache::ReadBlockCache(size_t sizeMax, size_t blockSize) :
+  mSizeMax(sizeMax), mBlockSize(blockSize ? blockSize : 256 * 1024)
+{}
+
+//------------------------------------------------------------------------------
+// Read a range from the cache
+//------------------------------------------------------------------------------
+int64_t
+ReadBlockCache::Read(unsigned long long inode, const timespec& mtime,
+                     char* buf, off_t off, size_t len)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (CheckMtimeLocked(inode, mtime)) {
+    mMisses++;
+    return -1;
+  }
+
+  size_t done = 0;
+
+  while (done < len) {
+    off_t pos = off + done;
+    auto it = mBlocks.find(key_t(inode, pos / mBlockSize));
+
+    if (it == mBlocks.end()) {
+      mMisses++;
+      return -1;
+    }
+
+    // move the block in front of the LRU
+    mLru.splice(mLru.begin(), mLru, it->second);
+    const std::string& data = it->second->mData;
+    size_t boff = pos % mBlockSize;
+
+    if (boff < data.size()) {
+      size_t n = std::min(len - done, data.size() - boff);
+      memcpy(buf + done, data.data() + boff, n);
+      done += n;
+    }
+
+    if (data.size() < mBlockSize) {
+      // this is the last block of the file
+      break;
+    }
+  }
+
+  mHits++;
+  return done;
+}
+
+//------------------------------------------------------------------------------
+// Store data read from the file
+//------------------------------------------------------------------------------
+void
+ReadBlockCache::Store(unsigned long long inode, const timespec& mtime,
+                      const char* buf, off_t off, size_t len, bool eof)
+{
+  if (off % mBlockSize) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (CheckMtimeLocked(inode, mtime) < 0) {
+    // the data was read from an older version of the file
+    return;
+  }
+
+  for (size_t pos = 0; pos < len || (eof && pos == len); pos += mBlockSize) {
+    size_t n = std::min(mBlockSize, len - pos);
+
+    if ((n < mBlockSize) && !eof) {
+      break;
+    }
+
+    if (n > mSizeMax) {
+      break;
+    }
+
+    key_t key(inode, (off + pos) / mBlockSize);
+    auto it = mBlocks.find(key);
+
+    if (it != mBlocks.end()) {
+      mSize -= it->second->mData.size();
+      mLru.erase(it->second);
+      mBlocks.erase(it);
+    }
+
+    while (mSize + n > mSizeMax) {
+      mSize -= mLru.back().mData.size();
+      mBlocks.erase(mLru.back().mKey);
+      mLru.pop_back();
+    }
+
+    mLru.push_front(Block {key, mtime, std::string(buf + pos, n)});
+    mBlocks[key] = mLru.begin();
+    mSize += n;
+
+    if (n < mBlockSize) {
+      break;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop all the blocks of a file
+//------------------------------------------------------------------------------
+void
+ReadBlockCache::Invalidate(unsigned long long inode)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  InvalidateLocked(inode);
+}
+
+//------------------------------------------------------------------------------
+// Drop all the blocks of a file - needs mMutex
+//------------------------------------------------------------------------------
+void
+ReadBlockCache::InvalidateLocked(unsigned long long inode)
+{
+  auto it = mBlocks.lower_bound(key_t(inode, 0));
+
+  while ((it != mBlocks.end()) && (it->first.first == inode)) {
+    mSize -= it->second->mData.size();
+    mLru.erase(it->second);
+    it = mBlocks.erase(it);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Compare the mtime of the cached blocks of a file with the given one
+//------------------------------------------------------------------------------
+int
+ReadBlockCache::CheckMtimeLocked(unsigned long long inode,
+                                 const timespec& mtime)
+{
+  auto it = mBlocks.lower_bound(key_t(inode, 0));
+
+  if ((it == mBlocks.end()) || (it->first.first != inode)) {
+    return 0;
+  }
+
+  const timespec& cached = it->second->mMtime;
+
+  if ((cached.tv_sec == mtime.tv_sec) && (cached.tv_nsec == mtime.tv_nsec)) {
+    return 0;
+  }
+
+  if ((cached.tv_sec > mtime.tv_sec) ||
+      ((cached.tv_sec == mtime.tv_sec) && (cached.tv_nsec > mtime.tv_nsec))) {
+    return -1;
+  }
+
+  InvalidateLocked(inode);
+  return 1;
+}
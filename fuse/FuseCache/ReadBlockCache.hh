@@ -0,0 +1,167 @@
+//------------------------------------------------------------------------------
+// File: ReadBlockCache.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOS_FUSE_READBLOCKCACHE_HH__
+#define __EOS_FUSE_READBLOCKCACHE_HH__
+
+//------------------------------------------------------------------------------
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <time.h>
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//! Class implementing a bounded read cache of data blocks shared by all the
+//! file handles of the client.
+//!
+//! Blocks are keyed by (inode, block index) and tagged with the modification
+//! time of the file the data was read from. A lookup or store with a newer
+//! modification time drops all the blocks of the inode. A block shorter than
+//! the block size is the last block of the file. Blocks are evicted in LRU
+//! order once the maximum size is reached.
+//------------------------------------------------------------------------------
+class ReadBlockCache
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Get instance of class
+  //!
+  //! @return cache object or NULL if the read cache is disabled
+  //----------------------------------------------------------------------------
+  static ReadBlockCache* GetInstance()
+  {
+    return pInstance;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Enable the read cache
+  //!
+  //! @param sizeMax maximum size of the cached data
+  //! @param blockSize size of the cached blocks
+  //----------------------------------------------------------------------------
+  static void Enable(size_t sizeMax, size_t blockSize = 256 * 1024);
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param sizeMax maximum size of the cached data
+  //! @param blockSize size of the cached blocks
+  //----------------------------------------------------------------------------
+  ReadBlockCache(size_t sizeMax, size_t blockSize);
+
+  //----------------------------------------------------------------------------
+  //! Read a range from the cache
+  //!
+  //! @param inode file inode
+  //! @param mtime modification time of the file
+  //! @param buf output buffer
+  //! @param off offset
+  //! @param len length
+  //!
+  //! @return number of bytes read, -1 if the range is not fully cached
+  //----------------------------------------------------------------------------
+  int64_t Read(unsigned long long inode, const timespec& mtime, char* buf,
+               off_t off, size_t len);
+
+  //----------------------------------------------------------------------------
+  //! Store data read from the file
+  //!
+  //! @param inode file inode
+  //! @param mtime modification time of the file
+  //! @param buf data read
+  //! @param off offset of the data, aligned to the block size
+  //! @param len length of the data
+  //! @param eof true if the data ends at the end of the file
+  //----------------------------------------------------------------------------
+  void Store(unsigned long long inode, const timespec& mtime, const char* buf,
+             off_t off, size_t len, bool eof);
+
+  //----------------------------------------------------------------------------
+  //! Drop all the blocks of a file
+  //----------------------------------------------------------------------------
+  void Invalidate(unsigned long long inode);
+
+  size_t GetBlockSize() const
+  {
+    return mBlockSize;
+  }
+
+  size_t GetSize()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSize;
+  }
+
+  uint64_t GetHits() const
+  {
+    return mHits;
+  }
+
+  uint64_t GetMisses() const
+  {
+    return mMisses;
+  }
+
+private:
+  typedef std::pair<unsigned long long, uint64_t> key_t; ///< inode, block
+
+  //----------------------------------------------------------------------------
+  //! Cached block
+  //----------------------------------------------------------------------------
+  struct Block {
+    key_t mKey; ///< inode and block index
+    timespec mMtime; ///< modification time of the file
+    std::string mData; ///< block data
+  };
+
+  typedef std::list<Block> lru_t;
+
+  //----------------------------------------------------------------------------
+  //! Drop all the blocks of a file - needs mMutex
+  //----------------------------------------------------------------------------
+  void InvalidateLocked(unsigned long long inode);
+
+  //----------------------------------------------------------------------------
+  //! Compare the mtime of the cached blocks of a file with the given one and
+  //! drop the blocks if they are older - needs mMutex
+  //!
+  //! @return -1 if the cached blocks are newer, 0 if they have the same mtime
+  //!         or there are none, 1 if older blocks were dropped
+  //----------------------------------------------------------------------------
+  int CheckMtimeLocked(unsigned long long inode, const timespec& mtime);
+
+  static ReadBlockCache* pInstance; ///< singleton object
+  size_t mSizeMax; ///< max cache size
+  size_t mBlockSize; ///< block size
+  std::mutex mMutex; ///< protects the members below
+  size_t mSize {0}; ///< size of the cached data
+  lru_t mLru; ///< blocks in LRU order, most recent first
+  std::map<key_t, lru_t::iterator> mBlocks; ///< blocks sorted by inode
+  std::atomic<uint64_t> mHits {0}; ///< number of reads served from the cache
+  std::atomic<uint64_t> mMisses {0}; ///< number of reads not fully cached
+};
+
+#endif // __EOS_FUSE_READBLOCKCACHE_HH__
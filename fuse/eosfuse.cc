@@ -697,10 +697,12 @@ EosFuse::opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
                        fuse_req_ctx(req)->gid, fuse_req_ctx(req)->pid, dlist,
                        &entriesstats, &nstats);
     unsigned long long in;
+    std::vector<std::string> bnames(dlist.size());
+    std::vector<std::pair<std::string, struct fuse_entry_param*>> nostats;
 
     for (cnt = 0; cnt < dlist.size(); cnt++) {
       in = dlist[cnt];
-      std::string bname = me.fs().base_name(in);
+      std::string& bname = bnames[cnt];
 
       if (cnt == 0) {
         // this is the '.' directory
@@ -708,16 +710,42 @@ EosFuse::opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
       } else if (cnt == 1) {
         // this is the '..' directory
         bname = "..";
+      } else {
+        bname = me.fs().base_name(in);
+      }
+
+      if (entriesstats && (cnt > 1) && (cnt < nstats) && bname.length() &&
+          !entriesstats[cnt].attr.st_ino) {
+        std::string epath = dirfullpath;
+
+        if (epath[epath.length() - 1] != '/') {
+          epath += "/";
+        }
+
+        epath += bname;
+        entriesstats[cnt].ino = in;
+        nostats.push_back(std::make_pair(epath, entriesstats + cnt));
       }
+    }
+
+    if (nostats.size()) {
+      // the listing came without the stat of these entries, fetch them in
+      // parallel rather than one lookup at a time
+      me.fs().stat_entries(nostats, fuse_req_ctx(req)->uid,
+                           fuse_req_ctx(req)->gid, fuse_req_ctx(req)->pid);
+    }
+
+    for (cnt = 0; cnt < dlist.size(); cnt++) {
+      in = dlist[cnt];
 
-      if (bname.length()) {
+      if (bnames[cnt].length()) {
         struct stat* buf = NULL;
 
-        if (entriesstats && entriesstats[cnt].attr.st_ino > 0) {
+        if (entriesstats && (cnt < nstats) && entriesstats[cnt].attr.st_ino > 0) {
           buf = &entriesstats[cnt].attr;
         }
 
-        dirbuf_add(req, &b, bname.c_str(), (fuse_ino_t) in, buf);
+        dirbuf_add(req, &b, bnames[cnt].c_str(), (fuse_ino_t) in, buf);
       } else {
         eos_static_err("failed for inode=%llu", in);
       }
@@ -734,18 +762,20 @@ EosFuse::opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
     fi->fh = (uint64_t) fh_buf;
 
     if (entriesstats) {
-      // Add the stat to the cache
+      // Add the stats to the cache in one go
       for (size_t i = 2; i < nstats; i++) { // the two first ones are . and ..
         entriesstats[i].attr_timeout = me.config.attrcachetime;
         entriesstats[i].entry_timeout = me.config.entrycachetime;
-        me.fs().dir_cache_add_entry(ino, entriesstats[i].attr.st_ino, entriesstats + i);
-        eos_static_debug("add_entry  %lu  %lu", entriesstats[i].ino,
-                         entriesstats[i].attr.st_ino);
+      }
+
+      if (nstats > 2) {
+        me.fs().dir_cache_add_entries(ino, entriesstats + 2, nstats - 2);
       }
 
       free(entriesstats);
-      free(b.p);
     }
+
+    free(b.p);
   } else {
     fi->fh = (uint64_t) fh_buf;
   }
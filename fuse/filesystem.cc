@@ -34,7 +34,9 @@
 #include <string.h>
 #include <pthread.h>
 #include <algorithm>
+#include <atomic>
 #include <limits>
+#include <thread>
 #include "XrdOuc/XrdOucEnv.hh"
 #include "XrdOuc/XrdOucHash.hh"
 #include "XrdOuc/XrdOucTable.hh"
@@ -48,6 +50,7 @@
 #include "XrdCl/XrdClXRootDResponses.hh"
 #include "MacOSXHelper.hh"
 #include "FuseCache/CacheEntry.hh"
+#include "FuseCache/ReadBlockCache.hh"
 #include "ProcCache.hh"
 #include "common/XrdErrorMap.hh"
 #include "common/Timing.hh"
@@ -284,6 +287,11 @@ filesystem::log_settings()
                       getenv("EOS_FUSE_CACHE_PAGE_SIZE") : "(default 262144)";
   s += efpcs;
   log("WARNING", s.c_str());
+  s = "read-cache-size        := ";
+  std::string frcs = getenv("EOS_FUSE_READ_CACHE_SIZE") ?
+                     getenv("EOS_FUSE_READ_CACHE_SIZE") : "0";
+  s += frcs;
+  log("WARNING", s.c_str());
   s = "big-writes             := ";
   std::string bw = getenv("EOS_FUSE_BIGWRITES") ? getenv("EOS_FUSE_BIGWRITES") :
                    "0";
@@ -799,6 +807,30 @@ filesystem::dir_cache_add_entry(unsigned long long inode,
 }
 
 
+//------------------------------------------------------------------------------
+// Add the subentries of a listing to a cached directory
+//------------------------------------------------------------------------------
+void
+filesystem::dir_cache_add_entries(unsigned long long inode,
+                                  struct fuse_entry_param* e,
+                                  size_t nentries)
+{
+  eos::common::RWMutexWriteLock wr_lock(mutex_fuse_cache);
+  FuseCacheEntry* dir = 0;
+
+  if ((inode2cache.count(inode)) && (dir = inode2cache[inode])) {
+    for (size_t i = 0; i < nentries; i++) {
+      if (!e[i].attr.st_ino) {
+        continue;
+      }
+
+      inode2parent[e[i].attr.st_ino] = inode;
+      dir->AddEntry(e[i].attr.st_ino, e + i);
+    }
+  }
+}
+
+
 bool
 filesystem::dir_cache_update_entry(unsigned long long entry_inode,
                                    struct stat* buf)
@@ -1544,6 +1576,44 @@ filesystem::listxattr(const char* path,
 }
 
 
+//------------------------------------------------------------------------------
+// Stat a set of entries in parallel
+//------------------------------------------------------------------------------
+void
+filesystem::stat_entries(std::vector<std::pair<std::string,
+                         struct fuse_entry_param*>>& entries,
+                         uid_t uid, gid_t gid, pid_t pid)
+{
+  std::atomic<size_t> next {0};
+  auto worker = [&]() {
+    size_t i;
+
+    while ((i = next++) < entries.size()) {
+      struct fuse_entry_param* e = entries[i].second;
+
+      if (stat(entries[i].first.c_str(), &e->attr, uid, gid, pid, e->ino)) {
+        e->attr.st_ino = 0;
+      } else {
+        e->ino = e->attr.st_ino;
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  size_t nworkers = std::min((size_t) N_DIRSTAT_THREADS, entries.size());
+
+  // the calling thread is one of the workers
+  for (size_t i = 1; i < nworkers; i++) {
+    workers.emplace_back(worker);
+  }
+
+  worker();
+
+  for (auto& thread : workers) {
+    thread.join();
+  }
+}
+
+
 //------------------------------------------------------------------------------
 // Return file attributes. If a field is meaningless or semi-meaningless
 // (e.g., st_ino) then it should be set to 0 or given a "reasonable" value.
@@ -2415,17 +2485,23 @@ filesystem::inodirlist(unsigned long long dirinode,
     return errno;
   }
 
-  // Start to read
-  int npages = 1;
+  // Start to read - the read size doubles up to MAX_LISTING_READ, so that
+  // large listings arrive in a few round trips
   off_t offset = 0;
   unsigned int nbytes = 0;
-  value = (char*) malloc(PAGESIZE + 1);
+  uint32_t readsize = PAGESIZE;
+  value = (char*) malloc(readsize + 1);
   COMMONTIMING("READSTSTREAM", &inodirtiming);
-  status = file->Read(offset, PAGESIZE, value + offset, nbytes);
+  status = file->Read(offset, readsize, value + offset, nbytes);
+
+  while ((status.IsOK()) && (nbytes == readsize)) {
+    offset += readsize;
+
+    if (readsize < MAX_LISTING_READ) {
+      readsize *= 2;
+    }
 
-  while ((status.IsOK()) && (nbytes == PAGESIZE)) {
-    npages++;
-    char* new_value = (char*) realloc(value, npages * PAGESIZE + 1);
+    char* new_value = (char*) realloc(value, offset + readsize + 1);
 
     if (new_value == nullptr) {
       free(value);
@@ -2434,8 +2510,7 @@ filesystem::inodirlist(unsigned long long dirinode,
     }
 
     value = new_value;
-    offset += PAGESIZE;
-    status = file->Read(offset, PAGESIZE, value + offset, nbytes);
+    status = file->Read(offset, readsize, value + offset, nbytes);
   }
 
   if (status.IsOK()) {
@@ -2705,8 +2780,6 @@ filesystem::inodirlist(unsigned long long dirinode,
         } else {
           buf.st_ino = 0;
         }
-
-        statvec.push_back(buf);
       }
 
       if (!encode_pathname && !checkpathname(whitespacedirpath.c_str())) {
@@ -2725,6 +2798,11 @@ filesystem::inodirlist(unsigned long long dirinode,
         if (show_entry) {
           store_child_p2i(dirinode, inode, whitespacedirpath.c_str());
           dlist.push_back(inode);
+
+          // keep the stats aligned with the listed entries
+          if (stats) {
+            statvec.push_back(buf);
+          }
         }
       }
     }
@@ -4836,6 +4914,12 @@ filesystem::init(int argc, char* argv[], void* userdata,
                                            10));
   }
 
+  // Initialise the shared read cache of data blocks
+  if (getenv("EOS_FUSE_READ_CACHE_SIZE")) {
+    ReadBlockCache::Enable((size_t) strtoull(getenv("EOS_FUSE_READ_CACHE_SIZE"),
+                           0, 10));
+  }
+
 // set the path of the proc fs (default is "/proc/"
   gProcCacheShardSize = AuthIdManager::proccachenbins;
   gProcCacheV.resize(gProcCacheShardSize);
@@ -62,6 +62,8 @@
 #define N_OPEN_MUTEXES_NBITS 12
 #define N_OPEN_MUTEXES (1 << N_OPEN_MUTEXES_NBITS)
 #define PAGESIZE 128 * 1024
+#define MAX_LISTING_READ (64 * PAGESIZE)
+#define N_DIRSTAT_THREADS 16
 
 // Sometimes, XRootd gives a NULL responses on some calls, this is a bug.
 // When it happens we retry.
@@ -419,6 +421,19 @@ public:
                            unsigned long long entry_inode,
                            struct fuse_entry_param* e);
 
+  //----------------------------------------------------------------------------
+  //! Add the subentries of a listing to a cached directory under a single
+  //! lock of the cache, entries without stat information are skipped
+  //!
+  //! @param inode directory inode
+  //! @param e array of fuse_entry_param structures
+  //! @param nentries number of entries in the array
+  //!
+  //----------------------------------------------------------------------------
+  void dir_cache_add_entries(unsigned long long inode,
+                             struct fuse_entry_param* e,
+                             size_t nentries);
+
   //----------------------------------------------------------------------------
   //! Add or update a cache directory entry
   //!
@@ -455,6 +470,17 @@ public:
   int stat(const char* path, struct stat* buf, uid_t uid, gid_t gid, pid_t pid,
            unsigned long long inode, bool onlysizemtime = false);
 
+  //----------------------------------------------------------------------------
+  //! Stat a set of entries in parallel using up to N_DIRSTAT_THREADS threads
+  //!
+  //! @param entries full path of each entry with the structure to fill, whose
+  //!        ino holds the listed inode - the attr.st_ino of the entries which
+  //!        could not be stat'ed is left 0
+  //!
+  //----------------------------------------------------------------------------
+  void stat_entries(std::vector<std::pair<std::string, struct fuse_entry_param*>>&
+                    entries, uid_t uid, gid_t gid, pid_t pid);
+
   //----------------------------------------------------------------------------
   //!
   //----------------------------------------------------------------------------
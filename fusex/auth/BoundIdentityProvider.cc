@@ -205,9 +205,10 @@ BoundIdentityProvider::environmentToBoundIdentity(const JailInformation& jail,
 }
 
 //------------------------------------------------------------------------------
-// Register SSS credentials
+// Register SSS credentials for the given login
 //------------------------------------------------------------------------------
-void BoundIdentityProvider::registerSSS(const BoundIdentity& bdi)
+void BoundIdentityProvider::registerSSS(const BoundIdentity& bdi,
+  const LoginIdentifier& login)
 {
   const UserCredentials uc = bdi.getCreds()->getUC();
 
@@ -238,10 +239,21 @@ void BoundIdentityProvider::registerSSS(const BoundIdentity& bdi)
     }
 
     // register new ID
-    sssRegistry->Register(bdi.getLogin().getStringID().c_str(), newEntity);
+    sssRegistry->Register(login.getStringID().c_str(), newEntity);
   }
 }
 
+//------------------------------------------------------------------------------
+// Allocate an additional login for the credentials of the given BoundIdentity
+//------------------------------------------------------------------------------
+LoginIdentifier BoundIdentityProvider::allocateLogin(
+  const BoundIdentity& identity)
+{
+  LoginIdentifier login(connectionCounter++);
+  registerSSS(identity, login);
+  return login;
+}
+
 //------------------------------------------------------------------------------
 // Given a set of user-provided, non-trusted UserCredentials, attempt to
 // translate them into a BoundIdentity object. (either by allocating a new
@@ -298,7 +310,7 @@ BoundIdentityProvider::userCredsToBoundIdentity(const JailInformation& jail,
   // We made it, the crowd goes wild, allocate a new connection
   //----------------------------------------------------------------------------
   bdi->getLogin() = LoginIdentifier(connectionCounter++);
-  registerSSS(*bdi);
+  registerSSS(*bdi, bdi->getLogin());
 
   //----------------------------------------------------------------------------
   // Store into the cache
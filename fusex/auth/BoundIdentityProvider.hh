@@ -93,6 +93,12 @@ public:
   bool checkValidity(const JailInformation& jail,
     const BoundIdentity& identity);
 
+  //----------------------------------------------------------------------------
+  // Allocate an additional login for the credentials of the given
+  // BoundIdentity, giving the same identity its own physical connection.
+  //----------------------------------------------------------------------------
+  LoginIdentifier allocateLogin(const BoundIdentity& identity);
+
   //----------------------------------------------------------------------------
   // Fallback to unix authentication. Guaranteed to always return a valid
   // BoundIdentity object. (whether this is accepted by the server is another
@@ -147,9 +153,9 @@ private:
     LogbookScope &scope);
 
   //----------------------------------------------------------------------------
-  // Register SSS credentials
+  // Register SSS credentials for the given login
   //----------------------------------------------------------------------------
-  void registerSSS(const BoundIdentity& bdi);
+  void registerSSS(const BoundIdentity& bdi, const LoginIdentifier& login);
 
   std::atomic<uint64_t> connectionCounter{1};
 };
@@ -57,7 +57,8 @@ class CredentialCache
 public:
 
   CredentialCache() : cache(16 /* 2^16 shards */,
-                              1000 * 60 * 60 * 12 /* 12 hours */) { }
+                              1000 * 60 * 60 * 12 /* 12 hours */,
+                              4 /* 2^18 credentials */) { }
 
   std::shared_ptr<const BoundIdentity> retrieve(const UserCredentials& credInfo)
   {
@@ -47,7 +47,8 @@ public:
     use_user_sss(false), tryKrb5First(false), fallback2nobody(false),
     fuse_shared(false),
     environ_deadlock_timeout(500), forknoexec_heuristic(true),
-    ignore_containerization(false) { }
+    ignore_containerization(false), session_cache_revalidation(0),
+    connection_warmup(0), connection_pool(1) { }
 
   //! Indicates if user krb5cc file should be used for authentication
   bool use_user_krb5cc;
@@ -70,6 +71,14 @@ public:
   std::string credentialStore;
   //! Ignore containerization
   bool ignore_containerization;
+  //! How long in seconds new processes may reuse the credentials found for
+  //! their session without reading their environment - 0 disables it
+  unsigned session_cache_revalidation;
+  //! How long in seconds the connections of a login are kept authenticated
+  //! after its last use - 0 disables it
+  unsigned connection_warmup;
+  //! Number of parallel logins used for the data of a strong identity
+  unsigned connection_pool;
 };
 
 //------------------------------------------------------------------------------
@@ -44,7 +44,8 @@ ExecveAlert::~ExecveAlert()
 ProcessCache::ProcessCache(const CredentialConfig &conf,
   BoundIdentityProvider &bip, ProcessInfoProvider &pip, JailResolver &jr)
   : credConfig(conf),
-  cache(16 /* 2^16 shards */, 1000 * 60 * 10 /* 10 minutes inactivity TTL */),
+  cache(16 /* 2^16 shards */, 1000 * 60 * 10 /* 10 minutes inactivity TTL */,
+    kMaxPerShard),
   boundIdentityProvider(bip),
   processInfoProvider(pip),
   jailResolver(jr)
@@ -177,6 +178,107 @@ ProcessCache::discoverBoundIdentity(const JailInformation& jail,
     reconnect, scope);
 }
 
+constexpr size_t ProcessCache::kMaxSessions;
+constexpr size_t ProcessCache::kMaxPerShard;
+
+//------------------------------------------------------------------------------
+// Look up the strong bound identity recently discovered for another process
+// of the same session, uid and gid.
+//------------------------------------------------------------------------------
+std::shared_ptr<const BoundIdentity>
+ProcessCache::retrieveSessionIdentity(const JailInformation& jail,
+  const ProcessInfo& processInfo, uid_t uid, gid_t gid, Logbook &logbook)
+{
+  if (credConfig.session_cache_revalidation == 0 ||
+      processInfo.getSid() <= 0) {
+    return {};
+  }
+
+  std::shared_ptr<const BoundIdentity> bdi;
+  std::chrono::steady_clock::time_point discovered;
+  {
+    std::lock_guard<std::mutex> lock(sessionMtx);
+    auto it = sessionCache.find(ProcessCacheKey(processInfo.getSid(), uid, gid));
+
+    if (it == sessionCache.end() || !(it->second.jail == jail.id)) {
+      sessionMisses++;
+      return {};
+    }
+
+    bdi = it->second.boundIdentity;
+    discovered = it->second.discovered;
+  }
+
+  //----------------------------------------------------------------------------
+  // Past the revalidation interval the environment of the process is read
+  // again, even if the credential file did not change.
+  //----------------------------------------------------------------------------
+  if (eos::common::SteadyClock::now(clock) - discovered >
+      std::chrono::seconds(credConfig.session_cache_revalidation) ||
+      !boundIdentityProvider.checkValidity(jail, *bdi)) {
+    LOGBOOK_INSERT(logbook, "Session " << processInfo.getSid() <<
+      " has a cached bound identity, but it needs revalidation");
+    sessionRevalidations++;
+    return {};
+  }
+
+  LOGBOOK_INSERT(logbook, "Reusing the bound identity of session " <<
+    processInfo.getSid() << " (" << bdi->getLogin().describe() << ")");
+  sessionHits++;
+  return bdi;
+}
+
+//------------------------------------------------------------------------------
+// Remember the bound identity discovered for a process of the session
+//------------------------------------------------------------------------------
+void ProcessCache::storeSessionIdentity(const JailInformation& jail,
+  const ProcessInfo& processInfo, uid_t uid, gid_t gid,
+  const std::shared_ptr<const BoundIdentity>& bdi)
+{
+  //----------------------------------------------------------------------------
+  // Unix identities are tied to the pid, nothing to share with the session.
+  //----------------------------------------------------------------------------
+  if (credConfig.session_cache_revalidation == 0 ||
+      processInfo.getSid() <= 0 || !bdi->getCreds() ||
+      bdi->getCreds()->empty()) {
+    return;
+  }
+
+  std::chrono::steady_clock::time_point now =
+    eos::common::SteadyClock::now(clock);
+  std::lock_guard<std::mutex> lock(sessionMtx);
+
+  if (sessionCache.size() >= kMaxSessions) {
+    for (auto it = sessionCache.begin(); it != sessionCache.end();) {
+      if (now - it->second.discovered >
+          std::chrono::seconds(credConfig.session_cache_revalidation)) {
+        it = sessionCache.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    if (sessionCache.size() >= kMaxSessions) {
+      sessionCache.clear();
+    }
+  }
+
+  SessionEntry& entry =
+    sessionCache[ProcessCacheKey(processInfo.getSid(), uid, gid)];
+  entry.jail = jail.id;
+  entry.boundIdentity = bdi;
+  entry.discovered = now;
+}
+
+//------------------------------------------------------------------------------
+// Get number of sessions in the session cache
+//------------------------------------------------------------------------------
+size_t ProcessCache::getSessionCacheSize()
+{
+  std::lock_guard<std::mutex> lock(sessionMtx);
+  return sessionCache.size();
+}
+
 //------------------------------------------------------------------------------
 // Major retrieve function, called by the rest of eosxd.
 //------------------------------------------------------------------------------
@@ -277,10 +379,21 @@ ProcessSnapshot ProcessCache::retrieve(pid_t pid, uid_t uid, gid_t gid,
 
   //----------------------------------------------------------------------------
   // Discover which bound identity to attach to this process, and store into
-  // the cache for future requests.
+  // the cache for future requests. Processes spawned by the same session,
+  // e.g. by a shell or make, can reuse the identity of the session instead of
+  // reading their environment.
   //----------------------------------------------------------------------------
-  std::shared_ptr<const BoundIdentity> bdi = discoverBoundIdentity(jailInfo,
-    processInfo, uid, gid, reconnect, logbook);
+  std::shared_ptr<const BoundIdentity> bdi;
+
+  if (!reconnect) {
+    bdi = retrieveSessionIdentity(jailInfo, processInfo, uid, gid, logbook);
+  }
+
+  if (!bdi) {
+    bdi = discoverBoundIdentity(jailInfo, processInfo, uid, gid, reconnect,
+      logbook);
+    storeSessionIdentity(jailInfo, processInfo, uid, gid, bdi);
+  }
 
   LOGBOOK_INSERT(logbook, "");
   LOGBOOK_INSERT(logbook, "===== BOUND IDENTITY: =====");
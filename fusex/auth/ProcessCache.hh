@@ -29,6 +29,10 @@
 #include "ProcessInfo.hh"
 #include "BoundIdentityProvider.hh"
 #include "common/ShardedCache.hh"
+#include "common/SteadyClock.hh"
+#include <atomic>
+#include <map>
+#include <mutex>
 
 class Logbook;
 
@@ -121,7 +125,73 @@ public:
   //----------------------------------------------------------------------------
   ProcessSnapshot retrieve(pid_t pid, uid_t uid, gid_t gid, bool reconnect);
 
+  //----------------------------------------------------------------------------
+  // Use the given clock for the session cache, used in testing.
+  //----------------------------------------------------------------------------
+  void setClock(eos::common::SteadyClock* clk)
+  {
+    clock = clk;
+  }
+
+  //----------------------------------------------------------------------------
+  // Session cache statistics: new processes which reused the identity of
+  // their session, which found none, and which found an expired or
+  // invalidated one.
+  //----------------------------------------------------------------------------
+  uint64_t getSessionHits() const
+  {
+    return sessionHits;
+  }
+
+  uint64_t getSessionMisses() const
+  {
+    return sessionMisses;
+  }
+
+  uint64_t getSessionRevalidations() const
+  {
+    return sessionRevalidations;
+  }
+
+  size_t getSessionCacheSize();
+
+  //----------------------------------------------------------------------------
+  // Process cache statistics
+  //----------------------------------------------------------------------------
+  ShardedCacheStats getCacheStats() const
+  {
+    return cache.getStats();
+  }
+
 private:
+  //----------------------------------------------------------------------------
+  // Maximum number of sessions remembered by the session cache
+  //----------------------------------------------------------------------------
+  static constexpr size_t kMaxSessions = 65536;
+
+  //----------------------------------------------------------------------------
+  // Maximum number of processes per shard of the process cache, 2^19 in all
+  //----------------------------------------------------------------------------
+  static constexpr size_t kMaxPerShard = 8;
+
+  //----------------------------------------------------------------------------
+  // Look up the strong bound identity recently discovered for another process
+  // of the same session, uid and gid. Returns nullptr if there's none, if it
+  // was discovered more than session_cache_revalidation seconds ago, or if
+  // its credential file changed.
+  //----------------------------------------------------------------------------
+  std::shared_ptr<const BoundIdentity>
+  retrieveSessionIdentity(const JailInformation& jail,
+    const ProcessInfo& processInfo, uid_t uid, gid_t gid, Logbook &logbook);
+
+  //----------------------------------------------------------------------------
+  // Remember the bound identity discovered for a process of the session, if
+  // it holds credentials.
+  //----------------------------------------------------------------------------
+  void storeSessionIdentity(const JailInformation& jail,
+    const ProcessInfo& processInfo, uid_t uid, gid_t gid,
+    const std::shared_ptr<const BoundIdentity>& bdi);
+
   //----------------------------------------------------------------------------
   // Discover some bound identity to use matching the given arguments.
   //----------------------------------------------------------------------------
@@ -161,6 +231,22 @@ private:
   };
 
   ShardedCache<ProcessCacheKey, ProcessCacheEntry, KeyHasher> cache;
+
+  struct SessionEntry {
+    JailIdentifier jail;
+    std::shared_ptr<const BoundIdentity> boundIdentity;
+    std::chrono::steady_clock::time_point discovered;
+  };
+
+  //----------------------------------------------------------------------------
+  // Session cache, keyed by session id instead of pid
+  //----------------------------------------------------------------------------
+  std::mutex sessionMtx;
+  std::map<ProcessCacheKey, SessionEntry> sessionCache;
+  eos::common::SteadyClock* clock = nullptr;
+  std::atomic<uint64_t> sessionHits {0};
+  std::atomic<uint64_t> sessionMisses {0};
+  std::atomic<uint64_t> sessionRevalidations {0};
   BoundIdentityProvider& boundIdentityProvider;
   ProcessInfoProvider& processInfoProvider;
   JailResolver& jailResolver;
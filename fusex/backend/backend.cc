@@ -42,6 +42,7 @@ backend::backend()
 {
   timeout = 0;
   put_timeout = 0;
+  mCoalesced = 0;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -213,12 +214,13 @@ backend::getMD(fuse_req_t req,
                uint64_t myclock,
                std::vector<eos::fusex::container>& contv,
                bool listing,
-               std::string authid
+               std::string authid,
+               uint64_t since
               )
 /* -------------------------------------------------------------------------- */
 {
   std::string requestURL = getURL(req, inode, myclock, "fuseX" , "getfusex", listing ? "LS" : "GET",
-                                  authid, listing ? true : false);
+                                  authid, listing ? true : false, since);
   if (listing || !use_mdquery()) {
     return fetchResponse(requestURL, contv);
   } else {
@@ -240,6 +242,20 @@ backend::getCAP(fuse_req_t req,
 }
 
 
+/* -------------------------------------------------------------------------- */
+std::string
+/* -------------------------------------------------------------------------- */
+backend::coalescingKey(const std::string& requestURL)
+/* -------------------------------------------------------------------------- */
+{
+  XrdCl::URL url(requestURL);
+  XrdCl::URL::ParamsMap query = url.GetParams();
+  query.erase("fuse.pid");
+  query.erase("fuse.exe");
+  url.SetParams(query);
+  return url.GetURL();
+}
+
 /* -------------------------------------------------------------------------- */
 int
 /* -------------------------------------------------------------------------- */
@@ -247,6 +263,57 @@ backend::fetchQueryResponse(std::string& requestURL,
 			    std::vector<eos::fusex::container>& contv
 			    )
 /* -------------------------------------------------------------------------- */
+{
+  // identical queries issued while one is in flight wait for its result
+  // instead of sending another round-trip to the MGM
+  std::string key = coalescingKey(requestURL);
+  std::promise<fetch_result_t> promise;
+  std::shared_future<fetch_result_t> future;
+  bool leader = false;
+  {
+    XrdSysMutexHelper iLock(mInflightMutex);
+    auto it = mInflight.find(key);
+
+    if (it != mInflight.end()) {
+      future = it->second;
+    } else {
+      future = promise.get_future().share();
+      mInflight[key] = future;
+      leader = true;
+    }
+  }
+
+  if (leader) {
+    shared_contv result = std::make_shared<std::vector<eos::fusex::container>>();
+    int rc = runQueryResponse(requestURL, *result);
+    {
+      XrdSysMutexHelper iLock(mInflightMutex);
+      mInflight.erase(key);
+    }
+    promise.set_value(std::make_pair(rc, result));
+  } else {
+    mCoalesced++;
+    eos_static_debug("msg=\"waiting for query in flight\" request='%s'",
+                     requestURL.c_str());
+  }
+
+  const fetch_result_t& result = future.get();
+  contv.insert(contv.end(), result.second->begin(), result.second->end());
+
+  if (result.first) {
+    errno = result.first;
+  }
+
+  return result.first;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+backend::runQueryResponse(std::string& requestURL,
+			  std::vector<eos::fusex::container>& contv
+			  )
+/* -------------------------------------------------------------------------- */
 {
   XrdCl::URL url(requestURL);
   eos_static_debug("request='%s'", requestURL.c_str());
@@ -785,6 +852,82 @@ backend::putMD(const fuse_id& id, eos::fusex::md* md, std::string authid,
   }
 }
 
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+backend::putMDs(const fuse_id& id, std::vector<eos::fusex::md>& mds,
+                std::vector<eos::fusex::response>& responses)
+{
+  XrdCl::URL url("root://" + hostport);
+  url.SetPath("/dummy");
+  XrdCl::URL::ParamsMap query;
+  fusexrdlogin::loginurl(url, query, id.uid, id.gid, id.pid, 0);
+  query["eos.app"] = get_appname();
+  query["fuse.v"] = std::to_string(FUSEPROTOCOLVERSION);
+  url.SetParams(query);
+  eos::fusex::md batch;
+  batch.set_operation(batch.SETMANY);
+  batch.set_clientuuid(clientuuid);
+
+  for (auto it = mds.begin(); it != mds.end(); ++it) {
+    eos::fusex::md* rec = batch.add_batch();
+    *rec = *it;
+    rec->set_clientuuid(clientuuid);
+  }
+
+  std::string mdstream;
+
+  if (!batch.SerializeToString(&mdstream)) {
+    eos_static_err("fatal serialization error");
+    return EFAULT;
+  }
+
+  XrdCl::Buffer arg;
+  XrdCl::Buffer* response = 0;
+  std::string prefix = "/?fusex:";
+  arg.Append(prefix.c_str(), prefix.length());
+  arg.Append(mdstream.c_str(), mdstream.length());
+  eos_static_debug("query: url=%s path=%s length=%d records=%lu",
+                   url.GetURL().c_str(), prefix.c_str(), mdstream.length(),
+                   mds.size());
+  XrdCl::XRootDStatus status = Query(url, XrdCl::QueryCode::OpaqueFile, arg,
+                                     response, put_timeout);
+
+  if (!status.IsOK()) {
+    eos_static_err("batch query resulted in error records=%lu url=%s",
+                   mds.size(), url.GetURL().c_str());
+
+    if (status.code == XrdCl::errErrorResponse) {
+      return mapErrCode(status.errNo);
+    } else {
+      return EIO;
+    }
+  }
+
+  std::unique_ptr<XrdCl::Buffer> rbuffer(response);
+
+  if (!response || !response->GetBuffer() || (response->GetSize() <= 6) ||
+      (std::string(response->GetBuffer(), 6) != "Fusex:")) {
+    eos_static_err("protocol error - no or illegal batch response received");
+    return EIO;
+  }
+
+  std::string sresponse;
+  std::string b64response;
+  b64response.assign(response->GetBuffer() + 6, response->GetSize() - 6);
+  eos::common::SymKey::DeBase64(b64response, sresponse);
+  eos::fusex::response resp;
+
+  if (!resp.ParseFromString(sresponse) || (resp.type() != resp.BATCH) ||
+      (resp.batch_size() != (int) mds.size())) {
+    eos_static_err("parsing error/wrong batch response received");
+    return EIO;
+  }
+
+  responses.assign(resp.batch().begin(), resp.batch().end());
+  return 0;
+}
+
 /* -------------------------------------------------------------------------- */
 int
 /* -------------------------------------------------------------------------- */
@@ -980,7 +1123,7 @@ std::string
 /* -------------------------------------------------------------------------- */
 backend::getURL(fuse_req_t req, uint64_t inode, uint64_t clock, std::string cmd, 
 		std::string pcmd, std::string op,
-                std::string authid, bool setinline)
+                std::string authid, bool setinline, uint64_t since)
 /* -------------------------------------------------------------------------- */
 {
   XrdCl::URL url("root://" + hostport);
@@ -992,6 +1135,12 @@ backend::getURL(fuse_req_t req, uint64_t inode, uint64_t clock, std::string cmd,
   query["mgm.clock"] =
     eos::common::StringConversion::GetSizeString(sclock,
         (unsigned long long) clock);
+
+  if (since) {
+    // only ask for the children changed after this clock
+    query["mgm.since"] = std::to_string(since);
+  }
+
   char hexinode[32];
   snprintf(hexinode, sizeof(hexinode), "%08lx", (unsigned long) inode);
   query["mgm.inode"] =
@@ -1205,7 +1354,19 @@ backend::Query(XrdCl::URL& url, XrdCl::QueryCode::Code query_code,
     eos::common::Timing::GetTimeSpec(ts, true);
     XrdCl::XRootDStatus status;
 #ifdef EOSCITRINE
-    status = fs->Query(XrdCl::QueryCode::OpaqueFile, arg, response, rtimeout);
+    // the query is sent asynchronously, the calling thread suspends on the
+    // future until the response handler fulfils it
+    QueryHandler* handler = new QueryHandler();
+    std::future<query_result_t> future = handler->get_future();
+    status = fs->Query(XrdCl::QueryCode::OpaqueFile, arg, handler, rtimeout);
+
+    if (status.IsOK()) {
+      query_result_t result = future.get();
+      status = result.status;
+      response = result.response;
+    } else {
+      delete handler;
+    }
 #else
     SyncResponseHandler handler;
     fs->Query(XrdCl::QueryCode::OpaqueFile, arg, &handler);
@@ -1247,6 +1408,31 @@ backend::Query(XrdCl::URL& url, XrdCl::QueryCode::Code query_code,
   } while (1);
 }
 
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+backend::QueryHandler::HandleResponse(XrdCl::XRootDStatus* status,
+                                      XrdCl::AnyObject* response)
+/* -------------------------------------------------------------------------- */
+{
+  query_result_t result;
+
+  if (status) {
+    result.status = *status;
+    delete status;
+  }
+
+  if (response) {
+    // take over the buffer from the response object
+    response->Get(result.response);
+    response->Set((XrdCl::Buffer*) 0);
+    delete response;
+  }
+
+  mPromise.set_value(result);
+  delete this;
+}
+
 /* -------------------------------------------------------------------------- */
 std::string
 /* -------------------------------------------------------------------------- */
@@ -32,8 +32,14 @@
 #include "XrdCl/XrdClStatus.hh"
 #include "XrdCl/XrdClFile.hh"
 #include "XrdCl/XrdClURL.hh"
+#include "XrdCl/XrdClFileSystem.hh"
+#include "XrdSys/XrdSysPthread.hh"
 
 #include <sys/statvfs.h>
+#include <atomic>
+#include <future>
+#include <map>
+#include <memory>
 
 class backend
 {
@@ -66,7 +72,8 @@ public:
             uint64_t myclock,
             std::vector<eos::fusex::container>& cont,
             bool listing,
-            std::string authid = ""
+            std::string authid = "",
+            uint64_t since = 0
            );
 
   int doLock(fuse_req_t req,
@@ -90,6 +97,16 @@ public:
   int putMD(const fuse_id& id, eos::fusex::md* md, std::string authid,
             XrdSysMutex* locker);
 
+  //----------------------------------------------------------------------------
+  //! Push a batch of records with a single SETMANY request, the MGM applies
+  //! them in order and answers every record with its own response
+  //!
+  //! @param mds records with operation SET and their authid set
+  //! @param responses one response per record on success
+  //----------------------------------------------------------------------------
+  int putMDs(const fuse_id& id, std::vector<eos::fusex::md>& mds,
+             std::vector<eos::fusex::response>& responses);
+
   int getCAP(fuse_req_t req,
              uint64_t inode,
              std::vector<eos::fusex::container>& cont
@@ -105,6 +122,50 @@ public:
   }
 
   int statvfs(fuse_req_t req, struct statvfs* stbuf);
+
+  //----------------------------------------------------------------------------
+  //! Number of distinct metadata queries in flight
+  //----------------------------------------------------------------------------
+  size_t inflight()
+  {
+    XrdSysMutexHelper iLock(mInflightMutex);
+    return mInflight.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Number of metadata queries served by a query already in flight
+  //----------------------------------------------------------------------------
+  uint64_t coalesced() const
+  {
+    return mCoalesced.load();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Result of an asynchronous query
+  //----------------------------------------------------------------------------
+  struct query_result_t {
+    query_result_t() : response(nullptr) { }
+    XrdCl::XRootDStatus status;
+    XrdCl::Buffer* response; // owned by the receiver
+  };
+
+  //----------------------------------------------------------------------------
+  //! Response handler fulfilling a promise, deletes itself after the response
+  //----------------------------------------------------------------------------
+  class QueryHandler : public XrdCl::ResponseHandler
+  {
+  public:
+    std::future<query_result_t> get_future()
+    {
+      return mPromise.get_future();
+    }
+
+    virtual void HandleResponse(XrdCl::XRootDStatus* status,
+                                XrdCl::AnyObject* response) override;
+  private:
+    std::promise<query_result_t> mPromise;
+  };
+
 private:
 
   std::string getURL(fuse_req_t req, const std::string& path, std::string cmd = "fuseX",
@@ -115,7 +176,8 @@ private:
                      std::string op = "GET", std::string authid = "", bool setinline=false);
   std::string getURL(fuse_req_t req, uint64_t inode, uint64_t clock, std::string cmd = "fuseX",
 		     std::string pcmd = "getfusex",
-                     std::string op = "GET", std::string authid = "", bool setinline=false);
+                     std::string op = "GET", std::string authid = "", bool setinline=false,
+                     uint64_t since = 0);
 
   std::string hostport;
   std::string mount;
@@ -125,6 +187,26 @@ private:
 
   int mapErrCode(int retc);
 
+  //----------------------------------------------------------------------------
+  //! Run a metadata query and parse the returned containers
+  //----------------------------------------------------------------------------
+  int runQueryResponse(std::string& url,
+                       std::vector<eos::fusex::container>& cont);
+
+  //----------------------------------------------------------------------------
+  //! Key identifying identical metadata queries, the issuing process does not
+  //! change the answer of the MGM and is not part of the key
+  //----------------------------------------------------------------------------
+  static std::string coalescingKey(const std::string& url);
+
+  typedef std::shared_ptr<std::vector<eos::fusex::container>> shared_contv;
+  typedef std::pair<int, shared_contv> fetch_result_t;
+
+  // metadata queries in flight by coalescing key
+  XrdSysMutex mInflightMutex;
+  std::map<std::string, std::shared_future<fetch_result_t>> mInflight;
+  std::atomic<uint64_t> mCoalesced;
+
   XrdCl::XRootDStatus Query(XrdCl::URL& url,
                             XrdCl::QueryCode::Code query_code, XrdCl::Buffer& arg,
                             XrdCl::Buffer*& repsonse,
@@ -0,0 +1,687 @@
+//------------------------------------------------------------------------------
+// File: LoadGenerator.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "LoadGenerator.hh"
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+//! FUSE operation triggered by every recorded system call
+//------------------------------------------------------------------------------
+static const std::map<std::string, std::string> sFuseOps = {
+  {"create", "create"}, {"release", "release"}, {"stat", "getattr"},
+  {"readdir", "readdir"}, {"unlink", "unlink"}, {"mkdir", "mkdir"},
+  {"rmdir", "rmdir"}, {"write", "write"}, {"read", "read"},
+  {"fsync", "fsync"}, {"chmod", "setattr"}, {"utimens", "setattr"},
+  {"mmap-read", "read"}
+};
+
+//------------------------------------------------------------------------------
+// Parse a size with an optional k, M or G suffix
+//------------------------------------------------------------------------------
+static uint64_t
+ParseSize(const std::string& value)
+{
+  size_t pos = 0;
+  uint64_t size = std::stoull(value, &pos);
+  std::string suffix = value.substr(pos);
+
+  if (suffix == "k" || suffix == "K") {
+    size *= 1024;
+  } else if (suffix == "m" || suffix == "M") {
+    size *= 1024 * 1024;
+  } else if (suffix == "g" || suffix == "G") {
+    size *= 1024 * 1024 * 1024ull;
+  } else if (!suffix.empty()) {
+    throw std::invalid_argument(value);
+  }
+
+  return size;
+}
+
+//------------------------------------------------------------------------------
+// Make sure a large file of the given size exists, not timed
+//------------------------------------------------------------------------------
+static bool
+EnsureFile(const std::string& path, uint64_t size, size_t block_size)
+{
+  struct stat buf;
+
+  if (!stat(path.c_str(), &buf) && ((uint64_t) buf.st_size == size)) {
+    return true;
+  }
+
+  int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, S_IRWXU);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  std::vector<char> buffer(block_size, 'e');
+  bool ok = true;
+
+  for (uint64_t offset = 0; ok && (offset < size); offset += block_size) {
+    size_t len = std::min<uint64_t>(block_size, size - offset);
+    ok = (pwrite(fd, buffer.data(), len, offset) == (ssize_t) len);
+  }
+
+  return ((close(fd) == 0) && ok);
+}
+
+//------------------------------------------------------------------------------
+// Parse the eos.stats output into the total count of every operation
+//------------------------------------------------------------------------------
+std::map<std::string, uint64_t>
+LoadGenerator::ParseStats(const std::string& stats)
+{
+  std::map<std::string, uint64_t> counters;
+  std::istringstream iss(stats);
+  std::string line;
+
+  while (std::getline(iss, line)) {
+    std::istringstream lss(line);
+    std::string who, tag, sum;
+
+    if (!(lss >> who >> tag >> sum) || (who != "ALL") || sum.empty() ||
+        (sum.find_first_not_of("0123456789") != std::string::npos)) {
+      continue;
+    }
+
+    counters[tag] = std::stoull(sum);
+  }
+
+  return counters;
+}
+
+//------------------------------------------------------------------------------
+// Read the eosxd counters
+//------------------------------------------------------------------------------
+std::map<std::string, uint64_t>
+LoadGenerator::ReadStats() const
+{
+  std::string path = (mOpts.mStatsPath.empty() ? mOpts.mDir : mOpts.mStatsPath);
+  std::vector<char> buffer(1024 * 1024);
+  ssize_t len = getxattr(path.c_str(), "eos.stats", buffer.data(),
+                         buffer.size());
+
+  if (len <= 0) {
+    return {};
+  }
+
+  return ParseStats(std::string(buffer.data(), len));
+}
+
+//------------------------------------------------------------------------------
+// Parallel create, stat, readdir and unlink storm
+//------------------------------------------------------------------------------
+void
+LoadGenerator::Meta(const std::string& dir, Samples& samples)
+{
+  std::vector<std::string> names;
+
+  for (size_t i = 0; i < mOpts.mFiles; ++i) {
+    names.push_back(dir + "/meta." + std::to_string(i));
+  }
+
+  for (const auto& name : names) {
+    int fd = -1;
+
+    if (Timed(samples, "create", [&]() {
+    return (fd = open(name.c_str(), O_CREAT | O_EXCL | O_WRONLY, S_IRWXU));
+    })) {
+      Timed(samples, "release", [&]() {
+        return close(fd);
+      });
+    }
+  }
+
+  struct stat buf;
+
+  for (const auto& name : names) {
+    Timed(samples, "stat", [&]() {
+      return stat(name.c_str(), &buf);
+    });
+  }
+
+  for (size_t pass = 0; pass < 10; ++pass) {
+    Timed(samples, "readdir", [&]() {
+      DIR* d = opendir(dir.c_str());
+
+      if (!d) {
+        return -1;
+      }
+
+      while (readdir(d)) {}
+
+      return closedir(d);
+    });
+  }
+
+  for (const auto& name : names) {
+    Timed(samples, "unlink", [&]() {
+      return unlink(name.c_str());
+    });
+  }
+}
+
+//------------------------------------------------------------------------------
+// Extraction of a tarball of small files
+//------------------------------------------------------------------------------
+void
+LoadGenerator::Untar(const std::string& dir, size_t index, Samples& samples)
+{
+  std::mt19937_64 random(index);
+  std::vector<char> buffer(mOpts.mSmallMax + 1, 'u');
+  std::vector<std::string> dirs;
+  std::vector<std::string> files;
+  std::string subdir;
+
+  for (size_t i = 0; i < mOpts.mFiles; ++i) {
+    // Like a source tree, a new directory every 50 files
+    if (i % 50 == 0) {
+      subdir = dir + "/untar." + std::to_string(i / 50);
+
+      if (!Timed(samples, "mkdir", [&]() {
+      return mkdir(subdir.c_str(), S_IRWXU);
+      })) {
+        continue;
+      }
+
+      dirs.push_back(subdir);
+    }
+
+    std::string name = subdir + "/file." + std::to_string(i);
+    size_t len = random() % (mOpts.mSmallMax + 1);
+    int fd = -1;
+
+    if (!Timed(samples, "create", [&]() {
+    return (fd = open(name.c_str(), O_CREAT | O_TRUNC | O_WRONLY, S_IRWXU));
+    })) {
+      continue;
+    }
+
+    files.push_back(name);
+
+    if (len && Timed(samples, "write", [&]() {
+    return ((write(fd, buffer.data(), len) == (ssize_t) len) ? 0 : -1);
+    })) {
+      samples.mBytes += len;
+    }
+
+    Timed(samples, "chmod", [&]() {
+      return fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP);
+    });
+    Timed(samples, "utimens", [&]() {
+      struct timespec times[2] = {{1500000000, 0}, {1500000000, 0}};
+      return futimens(fd, times);
+    });
+    Timed(samples, "release", [&]() {
+      return close(fd);
+    });
+  }
+
+  for (const auto& name : files) {
+    Timed(samples, "unlink", [&]() {
+      return unlink(name.c_str());
+    });
+  }
+
+  for (const auto& name : dirs) {
+    Timed(samples, "rmdir", [&]() {
+      return rmdir(name.c_str());
+    });
+  }
+}
+
+//------------------------------------------------------------------------------
+// Large sequential write and read
+//------------------------------------------------------------------------------
+void
+LoadGenerator::SeqIo(const std::string& dir, Samples& samples)
+{
+  std::string name = dir + "/large";
+  std::vector<char> buffer(mOpts.mBlockSize, 's');
+  int fd = -1;
+
+  if (!Timed(samples, "create", [&]() {
+  return (fd = open(name.c_str(), O_CREAT | O_TRUNC | O_WRONLY, S_IRWXU));
+  })) {
+    return;
+  }
+
+  for (uint64_t offset = 0; offset < mOpts.mFileSize;
+       offset += mOpts.mBlockSize) {
+    size_t len = std::min<uint64_t>(mOpts.mBlockSize, mOpts.mFileSize - offset);
+
+    if (!Timed(samples, "write", [&]() {
+    return ((write(fd, buffer.data(), len) == (ssize_t) len) ? 0 : -1);
+    })) {
+      break;
+    }
+
+    samples.mBytes += len;
+  }
+
+  Timed(samples, "fsync", [&]() {
+    return fsync(fd);
+  });
+  Timed(samples, "release", [&]() {
+    return close(fd);
+  });
+
+  if ((fd = open(name.c_str(), O_RDONLY)) < 0) {
+    samples.mErrors["read"]++;
+    return;
+  }
+
+  ssize_t nread = 0;
+
+  do {
+    if (!Timed(samples, "read", [&]() {
+    return (nread = read(fd, buffer.data(), buffer.size()));
+    })) {
+      break;
+    }
+
+    samples.mBytes += nread;
+  } while (nread > 0);
+
+  Timed(samples, "release", [&]() {
+    return close(fd);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Random reads and writes on a large file
+//------------------------------------------------------------------------------
+void
+LoadGenerator::RandIo(const std::string& dir, size_t index, Samples& samples)
+{
+  std::string name = dir + "/large";
+
+  if ((mOpts.mFileSize < mOpts.mRandomSize) ||
+      !EnsureFile(name, mOpts.mFileSize, mOpts.mBlockSize)) {
+    samples.mErrors["read"]++;
+    return;
+  }
+
+  int fd = open(name.c_str(), O_RDWR);
+
+  if (fd < 0) {
+    samples.mErrors["read"]++;
+    return;
+  }
+
+  std::mt19937_64 random(index);
+  std::vector<char> buffer(mOpts.mRandomSize, 'r');
+  uint64_t blocks = mOpts.mFileSize / mOpts.mRandomSize;
+
+  for (size_t i = 0; i < mOpts.mRandomOps; ++i) {
+    off_t offset = (random() % blocks) * mOpts.mRandomSize;
+    // 70% reads, 30% writes
+    bool is_read = (random() % 10 < 7);
+
+    if (Timed(samples, is_read ? "read" : "write", [&]() {
+    ssize_t len = (is_read ?
+                   pread(fd, buffer.data(), buffer.size(), offset) :
+                   pwrite(fd, buffer.data(), buffer.size(), offset));
+      return ((len == (ssize_t) buffer.size()) ? 0 : -1);
+    })) {
+      samples.mBytes += buffer.size();
+    }
+  }
+
+  Timed(samples, "fsync", [&]() {
+    return fsync(fd);
+  });
+  close(fd);
+}
+
+//------------------------------------------------------------------------------
+// Reads through a memory mapping, one page at a time in random order
+//------------------------------------------------------------------------------
+void
+LoadGenerator::Mmap(const std::string& dir, size_t index, Samples& samples)
+{
+  std::string name = dir + "/large";
+  long page = sysconf(_SC_PAGESIZE);
+
+  if ((mOpts.mFileSize < (uint64_t) page) ||
+      !EnsureFile(name, mOpts.mFileSize, mOpts.mBlockSize)) {
+    samples.mErrors["mmap-read"]++;
+    return;
+  }
+
+  int fd = open(name.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    samples.mErrors["mmap-read"]++;
+    return;
+  }
+
+  void* addr = mmap(nullptr, mOpts.mFileSize, PROT_READ, MAP_SHARED, fd, 0);
+
+  if (addr == MAP_FAILED) {
+    samples.mErrors["mmap-read"]++;
+    close(fd);
+    return;
+  }
+
+  // Drop the pages cached by a previous scenario
+  (void) madvise(addr, mOpts.mFileSize, MADV_DONTNEED);
+  std::mt19937_64 random(index);
+  uint64_t pages = mOpts.mFileSize / page;
+  volatile char sum = 0;
+
+  for (size_t i = 0; i < mOpts.mRandomOps; ++i) {
+    const char* ptr = static_cast<const char*>(addr) + (random() % pages) * page;
+    Timed(samples, "mmap-read", [&]() {
+      for (long off = 0; off < page; off += 64) {
+        sum += ptr[off];
+      }
+
+      return 0;
+    });
+    samples.mBytes += page;
+  }
+
+  munmap(addr, mOpts.mFileSize);
+  close(fd);
+}
+
+//------------------------------------------------------------------------------
+// Run one scenario and print its report
+//------------------------------------------------------------------------------
+uint64_t
+LoadGenerator::RunScenario(const std::string& name)
+{
+  std::map<std::string, uint64_t> before = ReadStats();
+  std::vector<Samples> samples(mOpts.mThreads);
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < mOpts.mThreads; ++i) {
+    threads.emplace_back([&, i]() {
+      std::string dir = mOpts.mDir + "/t" + std::to_string(i);
+
+      if (name == "meta") {
+        Meta(dir, samples[i]);
+      } else if (name == "untar") {
+        Untar(dir, i, samples[i]);
+      } else if (name == "seqio") {
+        SeqIo(dir, samples[i]);
+      } else if (name == "randio") {
+        RandIo(dir, i, samples[i]);
+      } else if (name == "mmap") {
+        Mmap(dir, i, samples[i]);
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  double seconds = std::chrono::duration<double>
+                   (std::chrono::steady_clock::now() - start).count();
+  std::map<std::string, uint64_t> after;
+
+  if (!before.empty()) {
+    // eosxd refreshes its counters every second
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    after = ReadStats();
+  }
+
+  // Merge the samples of all threads
+  std::map<std::string, std::vector<uint64_t>> latency;
+  std::map<std::string, uint64_t> errors;
+  uint64_t bytes = 0;
+  uint64_t failed = 0;
+
+  for (auto& sample : samples) {
+    for (auto& elem : sample.mLatency) {
+      auto& all = latency[elem.first];
+      all.insert(all.end(), elem.second.begin(), elem.second.end());
+    }
+
+    for (const auto& elem : sample.mErrors) {
+      errors[elem.first] += elem.second;
+      latency[elem.first];
+      failed += elem.second;
+    }
+
+    bytes += sample.mBytes;
+  }
+
+  std::ostringstream oss;
+  oss << "{\"scenario\": \"" << name << "\", \"threads\": " << mOpts.mThreads
+      << ", \"seconds\": " << seconds << ", \"bytes\": " << bytes
+      << ", \"mb_per_sec\": " << (seconds > 0 ? bytes / seconds / 1e6 : 0)
+      << ", \"ops\": {";
+  bool first = true;
+
+  for (auto& elem : latency) {
+    auto& values = elem.second;
+    std::sort(values.begin(), values.end());
+    auto pct = [&](double p) {
+      if (values.empty()) {
+        return 0.0;
+      }
+
+      size_t pos = static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5);
+      return values[std::min(pos, values.size() - 1)] / 1000.0;
+    };
+    auto it = sFuseOps.find(elem.first);
+    oss << (first ? "" : ", ") << "\"" << elem.first << "\": {\"fuse_op\": \""
+        << ((it != sFuseOps.end()) ? it->second : elem.first)
+        << "\", \"count\": " << values.size()
+        << ", \"errors\": " << errors[elem.first]
+        << ", \"ops_per_sec\": " << (seconds > 0 ? values.size() / seconds : 0)
+        << ", \"latency_us\": {\"p50\": " << pct(50) << ", \"p90\": " << pct(90)
+        << ", \"p99\": " << pct(99) << ", \"p999\": " << pct(99.9)
+        << ", \"max\": " << pct(100) << "}}";
+    first = false;
+  }
+
+  oss << "}, \"fusex_stats\": {";
+  first = true;
+
+  for (const auto& elem : after) {
+    auto it = before.find(elem.first);
+    uint64_t prev = ((it != before.end()) ? it->second : 0);
+
+    if (elem.second > prev) {
+      oss << (first ? "" : ", ") << "\"" << elem.first << "\": "
+          << elem.second - prev;
+      first = false;
+    }
+  }
+
+  oss << "}}";
+  std::cout << oss.str() << std::endl;
+  return failed;
+}
+
+//------------------------------------------------------------------------------
+// Run all configured scenarios
+//------------------------------------------------------------------------------
+int
+LoadGenerator::Run()
+{
+  std::string base = mOpts.mDir + "/fusex-load." + std::to_string(getpid());
+
+  if (mkdir(base.c_str(), S_IRWXU)) {
+    std::cerr << "error: failed to create " << base << std::endl;
+    return 1;
+  }
+
+  if (mOpts.mStatsPath.empty()) {
+    mOpts.mStatsPath = mOpts.mDir;
+  }
+
+  mOpts.mDir = base;
+
+  for (size_t i = 0; i < mOpts.mThreads; ++i) {
+    std::string dir = base + "/t" + std::to_string(i);
+
+    if (mkdir(dir.c_str(), S_IRWXU)) {
+      std::cerr << "error: failed to create " << dir << std::endl;
+      return 1;
+    }
+  }
+
+  uint64_t failed = 0;
+
+  for (const auto& scenario : mOpts.mScenarios) {
+    std::cerr << ">>> " << scenario << std::endl;
+    failed += RunScenario(scenario);
+  }
+
+  for (size_t i = 0; i < mOpts.mThreads; ++i) {
+    std::string dir = base + "/t" + std::to_string(i);
+    (void) unlink((dir + "/large").c_str());
+    (void) rmdir(dir.c_str());
+  }
+
+  (void) rmdir(base.c_str());
+  return (failed ? 2 : 0);
+}
+
+//------------------------------------------------------------------------------
+// Parse the command line of the load mode and run it, argv[0] is "load"
+//------------------------------------------------------------------------------
+int
+LoadGenerator::Main(int argc, char* argv[])
+{
+  Options opts;
+  static struct option long_opts[] = {
+    {"dir", required_argument, nullptr, 'd'},
+    {"stats-path", required_argument, nullptr, 'S'},
+    {"scenarios", required_argument, nullptr, 's'},
+    {"threads", required_argument, nullptr, 't'},
+    {"files", required_argument, nullptr, 'n'},
+    {"small-max", required_argument, nullptr, 'm'},
+    {"size", required_argument, nullptr, 'z'},
+    {"block-size", required_argument, nullptr, 'b'},
+    {"random-size", required_argument, nullptr, 'r'},
+    {"random-ops", required_argument, nullptr, 'o'},
+    {nullptr, 0, nullptr, 0}
+  };
+  int c;
+  bool usage = false;
+
+  try {
+    while ((c = getopt_long(argc, argv, "", long_opts, nullptr)) != -1) {
+      switch (c) {
+      case 'd':
+        opts.mDir = optarg;
+        break;
+
+      case 'S':
+        opts.mStatsPath = optarg;
+        break;
+
+      case 's': {
+        opts.mScenarios.clear();
+        std::istringstream iss(optarg);
+        std::string item;
+
+        while (std::getline(iss, item, ',')) {
+          if ((item != "meta") && (item != "untar") && (item != "seqio") &&
+              (item != "randio") && (item != "mmap")) {
+            throw std::invalid_argument(item);
+          }
+
+          opts.mScenarios.push_back(item);
+        }
+
+        break;
+      }
+
+      case 't':
+        opts.mThreads = std::stoul(optarg);
+        break;
+
+      case 'n':
+        opts.mFiles = std::stoul(optarg);
+        break;
+
+      case 'm':
+        opts.mSmallMax = ParseSize(optarg);
+        break;
+
+      case 'z':
+        opts.mFileSize = ParseSize(optarg);
+        break;
+
+      case 'b':
+        opts.mBlockSize = ParseSize(optarg);
+        break;
+
+      case 'r':
+        opts.mRandomSize = ParseSize(optarg);
+        break;
+
+      case 'o':
+        opts.mRandomOps = std::stoul(optarg);
+        break;
+
+      default:
+        usage = true;
+      }
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "error: invalid argument " << e.what() << std::endl;
+    usage = true;
+  }
+
+  if (usage || !opts.mThreads || !opts.mBlockSize || !opts.mRandomSize) {
+    std::cerr << "usage: fusex-benchmark load [options]\n"
+              << "  --dir <path>          directory on the mount (.)\n"
+              << "  --stats-path <path>   path on eosxd to read eos.stats from "
+              "(--dir)\n"
+              << "  --scenarios <list>    meta,untar,seqio,randio,mmap\n"
+              << "  --threads <n>         parallel threads (8)\n"
+              << "  --files <n>           files per thread of meta and untar "
+              "(1000)\n"
+              << "  --small-max <size>    max size of the untar files (16k)\n"
+              << "  --size <size>         size of the large file of every "
+              "thread (1G)\n"
+              << "  --block-size <size>   sequential io block size (1M)\n"
+              << "  --random-size <size>  random io size (4k)\n"
+              << "  --random-ops <n>      random ios per thread (10000)\n";
+    return 1;
+  }
+
+  return LoadGenerator(opts).Run();
+}
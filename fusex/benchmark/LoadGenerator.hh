@@ -0,0 +1,139 @@
+//------------------------------------------------------------------------------
+//! @file LoadGenerator.hh
+//! @brief Configurable metadata and data load generator for FUSE mounts
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! @brief Load generator replaying scenarios against a directory of a mount
+//!
+//! Every scenario runs its threads in private sub directories and records the
+//! latency of every system call, labelled with the FUSE operation it turns
+//! into. The eosxd counters (eos.stats extended attribute) are read before and
+//! after each scenario so the client side view can be compared with the one
+//! of the application. The report is printed as one JSON object per scenario.
+//------------------------------------------------------------------------------
+class LoadGenerator
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Configuration
+  //----------------------------------------------------------------------------
+  struct Options {
+    std::string mDir {"."}; ///< directory on the mount
+    std::string mStatsPath; ///< path used to read eos.stats, mDir if empty
+    std::vector<std::string> mScenarios {"meta", "untar", "seqio", "randio",
+                                         "mmap"};
+    size_t mThreads {8};
+    size_t mFiles {1000}; ///< files per thread of the metadata scenarios
+    size_t mSmallMax {16384}; ///< max size of the untar files
+    uint64_t mFileSize {1024 * 1024 * 1024}; ///< size of the large files
+    size_t mBlockSize {1024 * 1024}; ///< sequential io block size
+    size_t mRandomSize {4096}; ///< random io block size
+    size_t mRandomOps {10000}; ///< random ios per thread
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  LoadGenerator(const Options& opts):
+    mOpts(opts)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Run all configured scenarios
+  //!
+  //! @return 0 if successful, 1 if the directories could not be created, 2 if
+  //!         some operations failed
+  //----------------------------------------------------------------------------
+  int Run();
+
+  //----------------------------------------------------------------------------
+  //! Parse the command line of the load mode and run it
+  //----------------------------------------------------------------------------
+  static int Main(int argc, char* argv[]);
+
+  //----------------------------------------------------------------------------
+  //! Parse the eos.stats output into the total count of every operation
+  //----------------------------------------------------------------------------
+  static std::map<std::string, uint64_t> ParseStats(const std::string& stats);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Latency samples of one thread, keyed by system call
+  //----------------------------------------------------------------------------
+  struct Samples {
+    std::map<std::string, std::vector<uint64_t>> mLatency; ///< nanoseconds
+    std::map<std::string, uint64_t> mErrors;
+    uint64_t mBytes {0};
+  };
+
+  //----------------------------------------------------------------------------
+  //! Time one call and record it
+  //!
+  //! @return true if the call returned a non negative value
+  //----------------------------------------------------------------------------
+  template<typename F>
+  static bool Timed(Samples& samples, const char* op, F&& call)
+  {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = (call() >= 0);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (ok) {
+      samples.mLatency[op].push_back(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    } else {
+      samples.mErrors[op]++;
+    }
+
+    return ok;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Scenarios, executed by every thread in its own directory
+  //----------------------------------------------------------------------------
+  void Meta(const std::string& dir, Samples& samples);
+  void Untar(const std::string& dir, size_t index, Samples& samples);
+  void SeqIo(const std::string& dir, Samples& samples);
+  void RandIo(const std::string& dir, size_t index, Samples& samples);
+  void Mmap(const std::string& dir, size_t index, Samples& samples);
+
+  //----------------------------------------------------------------------------
+  //! Run one scenario and print its report
+  //!
+  //! @return number of failed operations
+  //----------------------------------------------------------------------------
+  uint64_t RunScenario(const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Read the eosxd counters, empty if the directory is not on eosxd
+  //----------------------------------------------------------------------------
+  std::map<std::string, uint64_t> ReadStats() const;
+
+  Options mOpts;
+};
@@ -7,6 +7,7 @@
 
 #include "common/Timing.hh"
 #include "common/ShellCmd.hh"
+#include "LoadGenerator.hh"
 
 #define LOOP_1 100
 #define LOOP_2 100
@@ -25,6 +26,12 @@
 
 int main(int argc, char* argv[])
 {
+  // fusex-benchmark load [options] runs the configurable load generator,
+  // otherwise the functional tests [test_start [test_stop]] are run
+  if ((argc > 1) && !strcmp(argv[1], "load")) {
+    return LoadGenerator::Main(argc - 1, argv + 1);
+  }
+
   eos::common::Timing tm("Test");
   char name[1024];
   size_t ino = 0;
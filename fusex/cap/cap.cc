@@ -30,6 +30,9 @@
 #include "common/Logging.hh"
 #include "common/Timing.hh"
 
+constexpr size_t cap::cmap::kShards;
+constexpr time_t cap::cmap::kWheelSlots;
+
 /* -------------------------------------------------------------------------- */
 cap::cap()
 /* -------------------------------------------------------------------------- */
@@ -88,14 +91,13 @@ void
 cap::reset()
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(capmap);
+  std::vector<shared_cap> removed;
+  capmap.clear(removed);
   XrdSysMutexHelper rLock(revocationLock);
 
-  for (auto it : capmap) {
-    revocationset.insert(it.second->authid());
+  for (auto& cap : removed) {
+    revocationset.insert(cap->authid());
   }
-
-  capmap.clear();
 }
 
 /* -------------------------------------------------------------------------- */
@@ -159,12 +161,15 @@ cap::ls()
 /* -------------------------------------------------------------------------- */
 {
   std::string listing;
-  XrdSysMutexHelper mLock(capmap);
+  size_t ncaps = 0;
+  capmap.for_each([&](shared_cap & cap) {
+    ncaps++;
 
-  for (auto it = capmap.begin(); it != capmap.end(); ++it) {
-    listing += it->second->dump(false);
-    listing += "\n";
-  }
+    if (listing.size() <= (64 * 1000)) {
+      listing += cap->dump(false);
+      listing += "\n";
+    }
+  });
 
   if (listing.size() > (64 * 1000)) {
     listing.resize((64 * 1000));
@@ -172,7 +177,7 @@ cap::ls()
   }
 
   char csize[32];
-  snprintf(csize, sizeof(csize), "# [ %lu caps ]\n", capmap.size());
+  snprintf(csize, sizeof(csize), "# [ %lu caps ]\n", ncaps);
   listing += csize;
   return listing;
 }
@@ -185,17 +190,30 @@ cap::get(fuse_req_t req,
          bool lock)
 /* -------------------------------------------------------------------------- */
 {
-  std::string cid = cap::capx::capid(req, ino);
-  std::string clientid = cap::capx::getclientid(req);
-  eos_static_debug("inode=%08lx cap-id=%s", ino, cid.c_str());
-  XrdSysMutexHelper mLock(capmap);
+  return get(req, ino, key(ino, cap::capx::getclientid(req)));
+}
 
-  if (capmap.count(cid)) {
-    shared_cap cap = capmap[cid];
-    return cap;
-  } else {
-    shared_cap cap = std::make_shared<capx>();
-    cap->set_clientid(clientid);
+/* -------------------------------------------------------------------------- */
+cap::shared_cap
+/* -------------------------------------------------------------------------- */
+cap::get(fuse_req_t req,
+         fuse_ino_t ino,
+         const capkey& ckey)
+/* -------------------------------------------------------------------------- */
+{
+  eos_static_debug("inode=%08lx cap-id=%lx:%s", ino, ino, ckey.clientid.c_str());
+  cmap::shard& shard = capmap.get_shard(ckey);
+  shared_cap cap;
+  {
+    XrdSysMutexHelper sLock(shard);
+    auto it = shard.map.find(ckey);
+
+    if (it != shard.map.end()) {
+      return it->second;
+    }
+
+    cap = std::make_shared<capx>();
+    cap->set_clientid(ckey.clientid);
     cap->set_authid("");
     cap->set_clientuuid(mds->get_clientuuid());
     cap->set_id(ino);
@@ -203,9 +221,11 @@ cap::get(fuse_req_t req,
     cap->set_gid(fuse_req_ctx(req)->gid);
     cap->set_vtime(0);
     cap->set_vtime_ns(0);
-    capmap[cid] = cap;
-    return cap;
+    cap->mapkey = ckey;
+    shard.map[ckey] = cap;
   }
+  capmap.schedule(cap, 0);
+  return cap;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -214,18 +234,20 @@ cap::shared_cap
 cap::get(fuse_ino_t ino, std::string clientid)
 /* -------------------------------------------------------------------------- */
 {
-  std::string cid = cap::capx::capid(ino, clientid);
-  eos_static_debug("inode=%08lx cap-id=%s", ino, cid.c_str());
-  XrdSysMutexHelper mLock(capmap);
+  capkey ckey = key(ino, clientid);
+  eos_static_debug("inode=%08lx cap-id=%lx:%s", ino, ino, clientid.c_str());
+  cmap::shard& shard = capmap.get_shard(ckey);
+  {
+    XrdSysMutexHelper sLock(shard);
+    auto it = shard.map.find(ckey);
 
-  if (capmap.count(cid)) {
-    shared_cap cap = capmap[cid];
-    return cap;
-  } else {
-    shared_cap cap = std::make_shared<capx>();
-    cap->set_id(0);
-    return cap;
+    if (it != shard.map.end()) {
+      return it->second;
+    }
   }
+  shared_cap cap = std::make_shared<capx>();
+  cap->set_id(0);
+  return cap;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -237,24 +259,29 @@ cap::store(fuse_req_t req,
 {
   std::string clientid = cap::capx::getclientid(req);
   uint64_t id = mds->vmaps().forward(icap.id());
-  std::string cid = cap::capx::capid(req, id); // cid uses the local inode
-  XrdSysMutexHelper mLock(capmap);
+  capkey ckey = key(id, clientid); // the key uses the local inode
+  cmap::shard& shard = capmap.get_shard(ckey);
+  shared_cap cap;
+  {
+    XrdSysMutexHelper sLock(shard);
+    auto it = shard.map.find(ckey);
 
-  if (capmap.count(cid)) {
-    shared_cap cap = capmap[cid];
-    *cap = icap;
-    cap->set_id(id);
-  } else {
-    shared_cap cap = std::make_shared<capx>();
-    cap->set_clientid(clientid);
-    *cap = icap;
-    cap->set_id(id);
-    capmap[cid] = cap;
+    if (it != shard.map.end()) {
+      cap = it->second;
+      *cap = icap;
+      cap->set_id(id);
+    } else {
+      cap = std::make_shared<capx>();
+      cap->set_clientid(clientid);
+      *cap = icap;
+      cap->set_id(id);
+      cap->mapkey = ckey;
+      shard.map[ckey] = cap;
+    }
   }
-
-  eos_static_debug("store inode=[r:%lx l:%lx] capid=%s cap: %s", icap.id(), id,
-                   cid.c_str(),
-                   capmap[cid]->dump().c_str());
+  capmap.schedule(cap, icap.vtime());
+  eos_static_debug("store inode=[r:%lx l:%lx] capid=%lx:%s cap: %s", icap.id(),
+                   id, id, clientid.c_str(), cap->dump().c_str());
 }
 
 /* -------------------------------------------------------------------------- */
@@ -265,14 +292,17 @@ cap::forget(const std::string& cid)
 {
   fuse_ino_t inode = 0;
   {
-    XrdSysMutexHelper mLock(capmap);
+    capkey ckey = key(cid);
+    cmap::shard& shard = capmap.get_shard(ckey);
+    XrdSysMutexHelper sLock(shard);
+    auto it = shard.map.find(ckey);
 
-    if (capmap.count(cid)) {
+    if (it != shard.map.end()) {
       eos_static_debug("forget capid=%s cap: %s", cid.c_str(),
-                       capmap[cid]->dump().c_str());
-      shared_cap cap = capmap[cid];
+                       it->second->dump().c_str());
+      shared_cap cap = it->second;
       inode = cap->id();
-      capmap.erase(cid);
+      shard.map.erase(it);
       XrdSysMutexHelper rLock(revocationLock);
       revocationset.insert(cap->authid());
     } else {
@@ -306,12 +336,32 @@ cap::imply(shared_cap cap,
                          EosFuse::Instance().Config().options.leasetime);
   std::string clientid = cap->clientid();
   std::string cid = capx::capid(ino, clientid);
-  XrdSysMutexHelper mLock(capmap);
-  // TODO: deal with the influence of mode to the cap itself
-  capmap[cid] = implied_cap;
+  capkey ckey = key(ino, clientid);
+  implied_cap->mapkey = ckey;
+  {
+    cmap::shard& shard = capmap.get_shard(ckey);
+    XrdSysMutexHelper sLock(shard);
+    // TODO: deal with the influence of mode to the cap itself
+    shard.map[ckey] = implied_cap;
+  }
+  capmap.schedule(implied_cap, implied_cap->vtime());
   return cid;
 }
 
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+cap::invalidate(shared_cap cap)
+/* -------------------------------------------------------------------------- */
+{
+  cap->invalidate();
+
+  // expire it with the next flush instead of at the former validity time
+  if (!cap->mapkey.clientid.empty()) {
+    capmap.schedule(cap, 0);
+  }
+}
+
 /* -------------------------------------------------------------------------- */
 cap::shared_cap
 /* -------------------------------------------------------------------------- */
@@ -322,9 +372,10 @@ cap::acquire(fuse_req_t req,
             )
 /* -------------------------------------------------------------------------- */
 {
-  std::string cid = cap::capx::capid(req, ino);
-  eos_static_debug("inode=%08lx cap-id=%s mode=%x", ino, cid.c_str(), mode);
-  shared_cap cap = get(req, ino);
+  capkey ckey = key(ino, cap::capx::getclientid(req));
+  eos_static_debug("inode=%08lx cap-id=%lx:%s mode=%x", ino, ino,
+                   ckey.clientid.c_str(), mode);
+  shared_cap cap = get(req, ino, ckey);
   bool try_attach = false;
   // avoid we create the same cap concurrently
   {
@@ -347,16 +398,33 @@ cap::acquire(fuse_req_t req,
 
     eos_static_debug("%s", cap->dump().c_str());
   }
-  XrdSysMutexHelper mLock(capmap);
-  XrdSysMutexHelper mLock2(cap->Locker());
 
   if (try_attach) {
-    if (!capmap.count(cid)) {
-      capmap[cid] = cap;
-      cap->set_id(ino);
+    // the cap might have expired from the map while it was refreshed
+    bool attached = false;
+    {
+      cmap::shard& shard = capmap.get_shard(ckey);
+      XrdSysMutexHelper sLock(shard);
+      XrdSysMutexHelper cLock(cap->Locker());
+
+      if (!shard.map.count(ckey)) {
+        shard.map[ckey] = cap;
+        cap->set_id(ino);
+        attached = true;
+      }
+
+      // stamp latest time of use
+      cap->use();
+    }
+
+    if (attached) {
+      capmap.schedule(cap, cap->vtime());
     }
+
+    return cap;
   }
 
+  XrdSysMutexHelper cLock(cap->Locker());
   // stamp latest time of use
   cap->use();
   return cap;
@@ -521,29 +589,36 @@ cap::capflush(ThreadAssistant& assistant)
 {
   while (!assistant.terminationRequested()) {
     {
-      cmap capdelmap;
+      // only the caps scheduled in the elapsed seconds are visited
+      std::vector<shared_cap> caps;
       cinodes capdelinodes;
-      capmap.Lock();
+      capmap.expired(time(NULL), caps);
 
-      for (auto it = capmap.begin(); it != capmap.end(); ++it) {
-        XrdSysMutexHelper cLock(it->second->Locker());
+      for (auto& cap : caps) {
+        cmap::shard& shard = capmap.get_shard(cap->mapkey);
+        XrdSysMutexHelper sLock(shard);
+        auto it = shard.map.find(cap->mapkey);
 
-        // make a list of caps to timeout
-        if (!it->second->valid(false)) {
-          capdelmap[it->first] = it->second;
-          eos_static_debug("expire %s", it->second->dump().c_str());
-          mds->decrease_cap(it->second->id());
-          capdelinodes.insert(it->second->id());
+        if ((it == shard.map.end()) || (it->second != cap)) {
+          // forgotten or replaced
+          continue;
+        }
+
+        XrdSysMutexHelper cLock(cap->Locker());
+
+        if (cap->valid(false)) {
+          // extended in the meantime
+          capmap.schedule(cap, cap->vtime());
+          continue;
         }
-      }
 
-      for (auto it = capdelmap.begin(); it != capdelmap.end(); ++it) {
         // remove the expired or invalidated by delete caps
-        capmap.erase(it->first);
+        eos_static_debug("expire %s", cap->dump().c_str());
+        shard.map.erase(it);
+        mds->decrease_cap(cap->id());
+        capdelinodes.insert(cap->id());
       }
 
-      capmap.UnLock();
-
       for (auto it = capdelinodes.begin(); it != capdelinodes.end(); ++it) {
         kernelcache::inval_inode(*it, false);
         // retrieve the md object and if there is no cap reference remove all child files
@@ -555,6 +630,130 @@ cap::capflush(ThreadAssistant& assistant)
   }
 }
 
+/* -------------------------------------------------------------------------- */
+cap::capkey
+/* -------------------------------------------------------------------------- */
+cap::key(const std::string& capid)
+/* -------------------------------------------------------------------------- */
+{
+  // cap ids are <hex inode>:<client id>
+  capkey ckey {0, ""};
+  size_t pos = capid.find(':');
+
+  if (pos != std::string::npos) {
+    ckey.ino = strtoull(capid.substr(0, pos).c_str(), 0, 16);
+    ckey.clientid = capid.substr(pos + 1);
+  }
+
+  return ckey;
+}
+
+/* -------------------------------------------------------------------------- */
+cap::cmap::cmap()
+/* -------------------------------------------------------------------------- */
+{
+  wheelTime = time(NULL);
+  wheel.resize(kWheelSlots);
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+cap::cmap::schedule(shared_cap cap, time_t when)
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper wLock(wheelLock);
+
+  // past times go to the next slot, the ones beyond the horizon to the last
+  if (when <= wheelTime) {
+    when = wheelTime + 1;
+  } else if (when >= wheelTime + kWheelSlots) {
+    when = wheelTime + kWheelSlots - 1;
+  }
+
+  if (cap->expiry && (cap->expiry <= when)) {
+    // the earlier check moves it again if needed
+    return;
+  }
+
+  // an entry in a later slot becomes stale
+  cap->expiry = when;
+  wheel[when % kWheelSlots].push_back(cap);
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+cap::cmap::expired(time_t now, std::vector<shared_cap>& caps)
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper wLock(wheelLock);
+
+  while (wheelTime < now) {
+    wheelTime++;
+    std::vector<std::weak_ptr<capx>>& slot = wheel[wheelTime % kWheelSlots];
+
+    for (auto& entry : slot) {
+      shared_cap cap = entry.lock();
+
+      if (cap && (cap->expiry == wheelTime)) {
+        cap->expiry = 0;
+        caps.push_back(cap);
+      }
+    }
+
+    slot.clear();
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+cap::cmap::for_each(const std::function<void(shared_cap&)>& fn)
+/* -------------------------------------------------------------------------- */
+{
+  for (size_t i = 0; i < kShards; ++i) {
+    XrdSysMutexHelper sLock(shards[i]);
+
+    for (auto& it : shards[i].map) {
+      fn(it.second);
+    }
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+cap::cmap::clear(std::vector<shared_cap>& removed)
+/* -------------------------------------------------------------------------- */
+{
+  for (size_t i = 0; i < kShards; ++i) {
+    XrdSysMutexHelper sLock(shards[i]);
+
+    for (auto& it : shards[i].map) {
+      removed.push_back(it.second);
+    }
+
+    shards[i].map.clear();
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+size_t
+/* -------------------------------------------------------------------------- */
+cap::cmap::size()
+/* -------------------------------------------------------------------------- */
+{
+  size_t n = 0;
+
+  for (size_t i = 0; i < kShards; ++i) {
+    XrdSysMutexHelper sLock(shards[i]);
+    n += shards[i].map.size();
+  }
+
+  return n;
+}
+
 /* -------------------------------------------------------------------------- */
 cap::shared_quota
 /* -------------------------------------------------------------------------- */
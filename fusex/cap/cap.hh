@@ -33,8 +33,11 @@
 #include "fusex/fusex.pb.h"
 
 #include "XrdSys/XrdSysPthread.hh"
+#include <functional>
 #include <memory>
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 
 // extension to permission capabilities
@@ -72,6 +75,27 @@ public:
     XrdSysMutex mLock;
   };
 
+  //----------------------------------------------------------------------------
+  //! Key of a cap: the local inode and the client id uid:gid:login@host:name
+  //----------------------------------------------------------------------------
+  struct capkey {
+    fuse_ino_t ino;
+    std::string clientid;
+
+    bool operator==(const capkey& other) const
+    {
+      return (ino == other.ino) && (clientid == other.clientid);
+    }
+  };
+
+  struct capkey_hash {
+    size_t operator()(const capkey& key) const
+    {
+      return (std::hash<uint64_t>()(key.ino) * 0x9e3779b97f4a7c15ull) ^
+             std::hash<std::string>()(key.clientid);
+    }
+  };
+
   class capx : public eos::fusex::cap
   //----------------------------------------------------------------------------
   {
@@ -97,9 +121,10 @@ public:
 
     std::string dump(bool dense = false);
 
-    capx() : lastusage(0) { }
+    capx() : mapkey {0, ""}, lastusage(0), expiry(0) { }
 
-    capx(fuse_req_t req, fuse_ino_t ino)
+    capx(fuse_req_t req, fuse_ino_t ino) : mapkey {0, ""}, lastusage(0),
+      expiry(0)
     {
       set_id(ino);
       std::string cid = getclientid(req);
@@ -126,8 +151,11 @@ public:
     }
 
   private:
+    friend class cap;
+    capkey mapkey; // key in the cap map, set before the cap is inserted
     XrdSysMutex mLock;
     time_t lastusage;
+    time_t expiry; // slot of the expiry wheel, 0 if none - wheel mutex
   };
 
   typedef std::shared_ptr<capx> shared_cap;
@@ -150,14 +178,53 @@ public:
     shared_quota get(shared_cap cap);
   };
 
-  class cmap : public std::map<std::string, shared_cap>, public XrdSysMutex
   //----------------------------------------------------------------------------
+  //! Caps sharded by key, every shard has its own lock. The expiry of the
+  //! caps is tracked in a wheel of one second slots: capflush only visits the
+  //! caps of the elapsed slots, a cap still valid there is moved to the slot
+  //! of its new validity time. Caps beyond the wheel horizon are parked in
+  //! the last slot and moved again when it is visited.
+  //----------------------------------------------------------------------------
+  class cmap
   {
   public:
+    static constexpr size_t kShards = 64;
+    static constexpr time_t kWheelSlots = 4096;
 
-    cmap() { }
+    typedef std::unordered_map<capkey, shared_cap, capkey_hash> shard_map_t;
+
+    struct shard : public XrdSysMutex {
+      shard_map_t map;
+    };
+
+    cmap();
 
     virtual ~cmap() { }
+
+    shard& get_shard(const capkey& key)
+    {
+      return shards[capkey_hash()(key) % kShards];
+    }
+
+    // schedule the expiry check of a cap in the map, the earliest one wins
+    void schedule(shared_cap cap, time_t when);
+
+    // take the caps scheduled in the slots elapsed until now
+    void expired(time_t now, std::vector<shared_cap>& caps);
+
+    // call a function for all caps, with the lock of their shard held
+    void for_each(const std::function<void(shared_cap&)>& fn);
+
+    // remove all caps
+    void clear(std::vector<shared_cap>& removed);
+
+    size_t size();
+
+  private:
+    shard shards[kShards];
+    XrdSysMutex wheelLock; // always taken last
+    time_t wheelTime; // last elapsed slot
+    std::vector<std::vector<std::weak_ptr<capx>>> wheel;
   };
 
   //----------------------------------------------------------------------------
@@ -249,6 +316,8 @@ public:
   std::string imply(shared_cap cap, std::string imply_authid, mode_t mode,
                     fuse_ino_t inode);
 
+  void invalidate(shared_cap cap);
+
   fuse_ino_t forget(const std::string& capid);
 
   void store(fuse_req_t req,
@@ -273,7 +342,6 @@ public:
 
   size_t size()
   {
-    XrdSysMutexHelper mLock(capmap);
     return capmap.size();
   }
 
@@ -284,8 +352,16 @@ public:
 
 private:
 
+  static capkey key(fuse_ino_t ino, const std::string& clientid)
+  {
+    return capkey {ino, clientid};
+  }
+
+  static capkey key(const std::string& capid);
+
+  shared_cap get(fuse_req_t req, fuse_ino_t ino, const capkey& ckey);
+
   cmap capmap;
-  cmap capextionsmap;
   qmap quotamap;
 
   backend* mdbackend;
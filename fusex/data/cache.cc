@@ -26,6 +26,7 @@
 #include "diskcache.hh"
 #include "memorycache.hh"
 #include "journalcache.hh"
+#include "tieredcache.hh"
 #include "cachehandler.hh"
 #include "common/Logging.hh"
 #include "common/Path.hh"
@@ -105,11 +106,19 @@ cachehandler::logconfig()
   eos_static_warning("data-cache-type        := %s",
                      (config.type == cache_t::MEMORY) ? "memory" :
                      "disk");
+  std::string s;
+
+  if (config.memory_budget == 0) {
+    eos_static_warning("data-cache-memory    := disabled");
+  } else {
+    eos_static_warning("data-cache-memory    := %s",
+                       eos::common::StringConversion::GetReadableSizeString(s,
+                           config.memory_budget, "B"));
+  }
 
   if (config.type == cache_t::DISK) {
     eos_static_warning("data-cache-location  := %s",
                        config.location.c_str());
-    std::string s;
 
     if (config.total_file_cache_size == 0) {
       eos_static_warning("data-cache-size      := unlimited");
@@ -167,7 +176,11 @@ cachehandler::get(fuse_ino_t ino)
 
   shared_io entry = std::make_shared<io>(ino);
 
-  if (inmemory()) {
+  if (tiered()) {
+    // hot blocks are kept in the global memory budget
+    entry->set_file(new tieredcache(ino, inmemory() ? nullptr :
+                                    new diskcache(ino)));
+  } else if (inmemory()) {
     entry->set_file(new memorycache(ino));
   } else {
     entry->set_file(new diskcache(ino));
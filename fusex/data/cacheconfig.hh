@@ -37,9 +37,11 @@ struct cacheconfig {
   uint64_t per_file_cache_max_size; // per file maximum file cache size
   uint64_t total_file_journal_size; // total size of the journal cache
   uint64_t per_file_journal_max_size; // per file maximum journal cache size
+  uint64_t memory_budget; // memory budget of the tiered file cache, 0 disables it
   uint64_t default_read_ahead_size; // default start value for read-ahead
   uint64_t max_inflight_read_ahead_buffer_size; // max size of read-ahead-buffers
   uint64_t max_inflight_write_buffer_size; // max size of write buffers
+  uint64_t per_file_max_inflight_write_buffer_size; // max size of write buffers in-flight per file
   uint64_t max_read_ahead_size; // max value for read-ahead block size
   size_t max_read_ahead_blocks; // max  number of read-ahead blocks
   float clean_threshold; // filling percentage of the cache disk when we start to delete
@@ -64,6 +64,11 @@ public:
     return (config.journal.length());
   }
 
+  bool tiered()
+  {
+    return (config.memory_budget != 0);
+  }
+
   cacheconfig& get_config()
   {
     return config;
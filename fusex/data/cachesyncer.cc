@@ -59,7 +59,7 @@ private:
   bool result;
 };
 
-int cachesyncer::sync(int fd, interval_tree<uint64_t,
+int cachesyncer::sync(int fd, interval_vector<uint64_t,
                       uint64_t>& journal,
                       size_t offshift,
                       off_t truncatesize)
@@ -8,7 +8,7 @@
 #ifndef FUSEX_CACHESYNCER_HH_
 #define FUSEX_CACHESYNCER_HH_
 
-#include "interval_tree.hh"
+#include "interval_vector.hh"
 
 #include "XrdCl/XrdClFile.hh"
 
@@ -23,7 +23,7 @@ public:
 
   virtual ~cachesyncer() { }
 
-  int sync(int fd, interval_tree<uint64_t, uint64_t>& journal,
+  int sync(int fd, interval_vector<uint64_t, uint64_t>& journal,
            size_t offshift,
            off_t truncatesize = 0);
 
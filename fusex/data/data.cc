@@ -41,6 +41,12 @@ std::string data::datax::kInlineAttribute = "sys.file.buffer";
 std::string data::datax::kInlineMaxSize = "sys.file.inline.maxsize";
 std::string data::datax::kInlineCompressor = "sys.file.inline.compressor";
 
+namespace
+{
+// seconds a file opened ahead waits for its reader
+const time_t sOpenAheadGrace = 10;
+}
+
 /* -------------------------------------------------------------------------- */
 data::data()
 /* -------------------------------------------------------------------------- */
@@ -77,31 +83,45 @@ data::get(fuse_req_t req,
           metad::shared_md md)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  dmap::Shard& shard = datamap.GetShard(ino);
+  XrdSysMutexHelper mLock(shard.mMutex);
+  bool waited = false;
 
-  if (datamap.count(ino)) {
-    shared_data io = datamap[ino];
-    io->attach(); // client ref counting
-    return io;
-  } else {
-    // protect against running out of file descriptors
-    size_t openfiles = datamap.size();
+  while (true) {
+    auto it = shard.mMap.find(ino);
+
+    if (it != shard.mMap.end()) {
+      shared_data io = it->second;
+      io->attach(); // client ref counting
+      return io;
+    }
+
+    if (waited) {
+      break;
+    }
+
+    // protect against running out of file descriptors, the other shards are
+    // counted without holding the lock of this one
+    mLock.UnLock();
+    size_t openfiles = 0;
     size_t openlimit = (EosFuse::Instance().Config().options.fdlimit - 128) / 2;
 
     while ((openfiles = datamap.size()) > openlimit) {
-      datamap.UnLock();
       eos_static_warning("open-files=%lu limit=%lu - waiting for release of file descriptors",
                          openfiles, openlimit);
       std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-      datamap.Lock();
     }
 
-    shared_data io = std::make_shared<datax>(md);
-    io->set_id(ino, req);
-    datamap[(fuse_ino_t) io->id()] = io;
-    io->attach();
-    return io;
+    mLock.Lock(&shard.mMutex);
+    // somebody might have created the object in the meantime
+    waited = true;
   }
+
+  shared_data io = std::make_shared<datax>(md);
+  io->set_id(ino, req);
+  shard.mMap[(fuse_ino_t) io->id()] = io;
+  io->attach();
+  return io;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -110,11 +130,13 @@ bool
 data::has(fuse_ino_t ino, bool checkwriteopen)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  dmap::Shard& shard = datamap.GetShard(ino);
+  XrdSysMutexHelper mLock(shard.mMutex);
+  auto it = shard.mMap.find(ino);
 
-  if (datamap.count(ino)) {
+  if (it != shard.mMap.end()) {
     if (checkwriteopen) {
-      if (datamap[ino]->flags() & (O_RDWR | O_WRONLY)) {
+      if (it->second->flags() & (O_RDWR | O_WRONLY)) {
         return true;
       } else {
         return false;
@@ -134,17 +156,22 @@ data::release(fuse_req_t req,
               fuse_ino_t ino)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  // the unlinked alias of an inode lives in the same shard
+  dmap::Shard& shard = datamap.GetShard(ino);
+  XrdSysMutexHelper mLock(shard.mMutex);
+  auto it = shard.mMap.find(ino);
 
-  if (datamap.count(ino)) {
-    shared_data io = datamap[ino];
+  if (it != shard.mMap.end()) {
+    shared_data io = it->second;
     io->detach();
     // the object is cleaned by the flush thread
   }
 
-  if (datamap.count(ino + 0xffffffff)) {
+  it = shard.mMap.find(ino + 0xffffffff);
+
+  if (it != shard.mMap.end()) {
     // in case this is an unlinked object
-    shared_data io = datamap[ino + 0xffffffff];
+    shared_data io = it->second;
     io->detach();
   }
 }
@@ -154,10 +181,12 @@ void
 data::update_cookie(uint64_t ino, std::string& cookie)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  dmap::Shard& shard = datamap.GetShard(ino);
+  XrdSysMutexHelper mLock(shard.mMutex);
+  auto it = shard.mMap.find(ino);
 
-  if (datamap.count(ino)) {
-    shared_data io = datamap[ino];
+  if (it != shard.mMap.end()) {
+    shared_data io = it->second;
     io->attach(); // client ref counting
     io->store_cookie(cookie);
     io->detach();
@@ -170,10 +199,12 @@ void
 data::invalidate_cache(fuse_ino_t ino)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  dmap::Shard& shard = datamap.GetShard(ino);
+  XrdSysMutexHelper mLock(shard.mMutex);
+  auto it = shard.mMap.find(ino);
 
-  if (datamap.count(ino)) {
-    shared_data io = datamap[ino];
+  if (it != shard.mMap.end()) {
+    shared_data io = it->second;
     io->attach(); // client ref counting
     io->cache_invalidate();
     io->detach();
@@ -186,17 +217,21 @@ void
 data::unlink(fuse_req_t req, fuse_ino_t ino)
 /* -------------------------------------------------------------------------- */
 {
-  XrdSysMutexHelper mLock(datamap);
+  dmap::Shard& shard = datamap.GetShard(ino);
+  XrdSysMutexHelper mLock(shard.mMutex);
+  auto it = shard.mMap.find(ino);
 
-  if (datamap.count(ino)) {
-    XrdSysMutexHelper helper(datamap[ino]->Locker());
+  if (it != shard.mMap.end()) {
+    shared_data io = it->second;
+    XrdSysMutexHelper helper(io->Locker());
     // wait for open in flight to be done
-    datamap[ino]->WaitOpen();
-    datamap[ino]->unlink(req);
-    // put the unlinked inode in a high bucket, will be removed by the flush thread
-    datamap[ino + 0xffffffff] = datamap[ino];
-    datamap.erase(ino);
-    eos_static_info("datacache::unlink size=%lu", datamap.size());
+    io->WaitOpen();
+    io->unlink(req);
+    // put the unlinked inode in a high bucket, will be removed by the flush
+    // thread - it lives in the same shard
+    shard.mMap.erase(it);
+    shard.mMap[ino + 0xffffffff] = io;
+    eos_static_info("datacache::unlink shard-size=%lu", shard.mMap.size());
   } else {
     shared_data io = std::make_shared<datax>();
     io->set_id(ino, req);
@@ -557,6 +592,8 @@ data::datax::attach(fuse_req_t freq, std::string& cookie, int flags)
     isRW = true;
   }
 
+  // a reader came for a file opened ahead, the flusher can drop it again
+  mOpenAheadUntil = 0;
   eos_info("cookie=%s flags=%o isrw=%d md-size=%d %s", cookie.c_str(), flags,
            isRW, mMd->size(),
            isRW ? mRemoteUrlRW.c_str() : mRemoteUrlRO.c_str());
@@ -628,41 +665,16 @@ data::datax::attach(fuse_req_t freq, std::string& cookie, int flags)
       }
     }
   } else {
-    if (!mFile->has_xrdioro(freq) || mFile->xrdioro(freq)->IsClosing() ||
-        mFile->xrdioro(freq)->IsClosed()) {
-      if (mFile->has_xrdioro(freq) && (mFile->xrdioro(freq)->IsClosing() ||
-                                       mFile->xrdioro(freq)->IsClosed())) {
-        mFile->xrdioro(freq)->WaitClose();
-        mFile->xrdioro(freq)->attach();
-      } else {
-        mFile->set_xrdioro(freq, new XrdCl::Proxy());
-        mFile->xrdioro(freq)->attach();
-        mFile->xrdioro(freq)->set_id(id(), req());
-
-        if (!(flags & O_SYNC)) {
-          if (EOS_LOGS_DEBUG)
-            eos_debug("readhead: strategy=%s nom:%lu max:%lu",
-                      cachehandler::instance().get_config().read_ahead_strategy.c_str(),
-                      cachehandler::instance().get_config().default_read_ahead_size,
-                      cachehandler::instance().get_config().max_read_ahead_size);
-
-          mFile->xrdioro(freq)->set_readahead_strategy(
-            XrdCl::Proxy::readahead_strategy_from_string(
-              cachehandler::instance().get_config().read_ahead_strategy),
-            4096,
-            cachehandler::instance().get_config().default_read_ahead_size,
-            cachehandler::instance().get_config().max_read_ahead_size,
-            cachehandler::instance().get_config().max_read_ahead_blocks
-          );
-          mFile->xrdioro(freq)->set_readahead_maximum_position(mSize);
-        }
-      }
-
-      XrdCl::OpenFlags::Flags targetFlags = XrdCl::OpenFlags::Read;
-      XrdCl::Access::Mode mode = XrdCl::Access::UR | XrdCl::Access::UX;
-      // we might need to wait for a creation to go through
-      WaitOpen();
-      mFile->xrdioro(freq)->OpenAsync(mRemoteUrlRO.c_str(), targetFlags, mode, 0);
+    if (!mFile->has_xrdioro(freq) && inline_buffer && inlined() &&
+        (mMd->size() <= mInlineMaxSize)) {
+      // the content came with the meta-data, the remote file is only opened
+      // once a read can not be served from the inline buffer
+      mDeferredReaders++;
+      eos_debug("deferring remote open of inlined file readers=%lu",
+                mDeferredReaders);
+    } else if (!mFile->has_xrdioro(freq) || mFile->xrdioro(freq)->IsClosing() ||
+               mFile->xrdioro(freq)->IsClosed()) {
+      open_ro(freq, flags);
     } else {
       if (mFile->has_xrdiorw(freq)) {
 	// we have to drop all existing read-ahead buffers to avoid reading outdated buffers
@@ -675,6 +687,94 @@ data::datax::attach(fuse_req_t freq, std::string& cookie, int flags)
   return bcache | jcache;
 }
 
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+data::datax::open_ro(fuse_req_t freq, int flags)
+/* -------------------------------------------------------------------------- */
+{
+  if (mFile->has_xrdioro(freq) && (mFile->xrdioro(freq)->IsClosing() ||
+                                   mFile->xrdioro(freq)->IsClosed())) {
+    mFile->xrdioro(freq)->WaitClose();
+    mFile->xrdioro(freq)->attach();
+  } else {
+    mFile->set_xrdioro(freq, new XrdCl::Proxy());
+    mFile->xrdioro(freq)->attach();
+    mFile->xrdioro(freq)->set_id(id(), req());
+
+    if (!(flags & O_SYNC)) {
+      if (EOS_LOGS_DEBUG)
+        eos_debug("readhead: strategy=%s nom:%lu max:%lu",
+                  cachehandler::instance().get_config().read_ahead_strategy.c_str(),
+                  cachehandler::instance().get_config().default_read_ahead_size,
+                  cachehandler::instance().get_config().max_read_ahead_size);
+
+      mFile->xrdioro(freq)->set_readahead_strategy(
+        XrdCl::Proxy::readahead_strategy_from_string(
+          cachehandler::instance().get_config().read_ahead_strategy),
+        4096,
+        cachehandler::instance().get_config().default_read_ahead_size,
+        cachehandler::instance().get_config().max_read_ahead_size,
+        cachehandler::instance().get_config().max_read_ahead_blocks
+      );
+      mFile->xrdioro(freq)->set_readahead_maximum_position(mSize);
+    }
+
+    if (EosFuse::Instance().Config().options.rain_pio) {
+      // RAIN files are read directly from the stripe servers
+      mFile->xrdioro(freq)->set_pio(true);
+    }
+  }
+
+  XrdCl::OpenFlags::Flags targetFlags = XrdCl::OpenFlags::Read;
+  XrdCl::Access::Mode mode = XrdCl::Access::UR | XrdCl::Access::UX;
+  // we might need to wait for a creation to go through
+  WaitOpen();
+  mFile->xrdioro(freq)->OpenAsync(mRemoteUrlRO.c_str(), targetFlags, mode, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+data::datax::open_ahead(fuse_req_t req)
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper lLock(mLock);
+
+  if (mAttached > 1 || mFile->has_xrdioro(req) || mFile->has_xrdiorw(req) ||
+      mRemoteUrlRO.empty()) {
+    return;
+  }
+
+  eos_info("opening remote file ahead of a reader");
+  mSize = mMd->size();
+  open_ro(req, O_RDONLY);
+  // the proxy is attached by the first reader, a failed open is reissued then
+  mFile->xrdioro(req)->detach();
+  mOpenAheadUntil = time(NULL) + sOpenAheadGrace;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+data::datax::open_deferred(fuse_req_t req)
+/* -------------------------------------------------------------------------- */
+{
+  if (!mDeferredReaders || mFile->has_xrdioro(req) || mFile->has_xrdiorw(req)) {
+    return;
+  }
+
+  eos_info("opening remote file for %lu inline readers", mDeferredReaders);
+  open_ro(req, mFlags);
+
+  // the readers attached so far are now users of the proxy
+  for (size_t i = 1; i < mDeferredReaders; ++i) {
+    mFile->xrdioro(req)->attach();
+  }
+
+  mDeferredReaders = 0;
+}
+
 /* -------------------------------------------------------------------------- */
 bool
 /* -------------------------------------------------------------------------- */
@@ -740,6 +840,7 @@ data::datax::prefetch(fuse_req_t req, bool lock)
   }
 
   if (!mPrefetchHandler && mFile->file() && !mFile->file()->size() && file_size) {
+    open_deferred(req);
     XrdCl::Proxy* proxy = mFile->has_xrdioro(req) ? mFile->xrdioro(
                             req) : mFile->xrdiorw(req);
 
@@ -807,7 +908,7 @@ data::datax::WaitPrefetch(fuse_req_t req, bool lock)
         if ((mPrefetchHandler->vbuffer().size() == file_size) && mFile->file()) {
           ssize_t nwrite = mFile->file()->pwrite(mPrefetchHandler->buffer(),
                                                  mPrefetchHandler->vbuffer().size(), 0);
-          eos_debug("nwb=%lu to local cache", nwrite);
+          eos_hotpath_debug("nwb=%lu to local cache", nwrite);
         }
       } else {
         eos_err("pre-read failed error=%s", status.ToStr().c_str());
@@ -1671,7 +1772,10 @@ data::datax::detach(fuse_req_t req, std::string& cookie, int flags)
       mFile->xrdiorw(req)->detach();
     }
   } else {
-    if (mFile->has_xrdioro(req)) {
+    if (mDeferredReaders) {
+      // this reader never needed the remote file
+      mDeferredReaders--;
+    } else if (mFile->has_xrdioro(req)) {
       mFile->xrdioro(req)->detach();
     }
   }
@@ -1807,6 +1911,7 @@ data::datax::pread(fuse_req_t req, void* buf, size_t count, off_t offset)
   }
 
   // read the missing part remote
+  open_deferred(req);
   XrdCl::Proxy* proxy = mFile->has_xrdioro(req) ? mFile->xrdioro(
                           req) : mFile->xrdiorw(req);
   XrdCl::XRootDStatus status;
@@ -1958,7 +2063,7 @@ data::datax::pwrite(fuse_req_t req, const void* buf, size_t count, off_t offset)
 
     while (mFile->xrdiorw(req)->HasTooManyWritesInFlight()) {
       if (!(cnt % 1000)) {
-        eos_debug("doing XOFF");
+        eos_hotpath_debug("doing XOFF");
       }
 
       EosFuse::instance().datas.set_xoff();
@@ -1986,7 +2091,7 @@ data::datax::pwrite(fuse_req_t req, const void* buf, size_t count, off_t offset)
     }
 
     if (mFlags & O_SYNC) {
-      eos_debug("O_SYNC");
+      eos_hotpath_debug("O_SYNC");
       // make sure the file gets opened
       XrdCl::XRootDStatus status = mFile->xrdiorw(req)->WaitOpen();
 
@@ -2103,8 +2208,8 @@ data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
 
     if (mMd->size() <= (unsigned long long) inline_buffer->getSize()) {
       memcpy(buf, inline_buffer->ptr() + offset, avail_bytes);
-      eos_debug("inline-read byte=%lld inline-buffer-size=%lld", avail_bytes,
-                inline_buffer->getSize());
+      eos_hotpath_debug("inline-read byte=%lld inline-buffer-size=%lld",
+                        avail_bytes, inline_buffer->getSize());
       return avail_bytes;
     }
   }
@@ -2154,11 +2259,12 @@ data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
   }
 
   // read the missing part remote
+  open_deferred(req);
   XrdCl::Proxy* proxy = mFile->has_xrdioro(req) ? mFile->xrdioro(
                           req) : mFile->xrdiorw(req);
   XrdCl::XRootDStatus status;
-  eos_debug("ro=%d offset=%llu count=%lu br=%lu jr=%lu", mFile->has_xrdioro(req),
-            offset, count, br, jr);
+  eos_hotpath_debug("ro=%d offset=%llu count=%lu br=%lu jr=%lu",
+                    mFile->has_xrdioro(req), offset, count, br, jr);
 
   if (proxy) {
     if (proxy->IsOpening()) {
@@ -2508,9 +2614,16 @@ data::datax::set_remote(const std::string& hostport,
   remoteurl += "&eos.app=";
   remoteurl += appname;
   remoteurl += "&mgm.mtime=0&mgm.fusex=1&eos.bookingsize=0";
+
+  if (isRW && EosFuse::Instance().Config().options.async_close) {
+    // The FST commits the meta data in the background after the close
+    remoteurl += "&fst.asyncclose=1";
+  }
   XrdCl::URL url(remoteurl);
   XrdCl::URL::ParamsMap query = url.GetParams();
-  fusexrdlogin::loginurl(url, query, req, md_ino);
+  // Spread the files of an identity over its pooled connections
+  fusexrdlogin::loginurl(url, query, req, md_ino, false,
+                         (int)(md_ino % fusexrdlogin::connectionPool));
   url.SetParams(query);
   remoteurl = url.GetURL();
 
@@ -2559,11 +2672,13 @@ data::dmap::ioflush(ThreadAssistant& assistant)
     {
       //eos_static_debug("");
       std::vector<shared_data> data;
-      {
-        // avoid mutex contention
-        XrdSysMutexHelper mLock(this);
 
-        for (auto it = this->begin(); it != this->end(); ++it) {
+      // avoid mutex contention, copy the shards one by one
+      for (size_t i = 0; i < kNumShards; ++i) {
+        XrdSysMutexHelper mLock(GetShardAt(i).mMutex);
+
+        for (auto it = GetShardAt(i).mMap.begin(); it != GetShardAt(i).mMap.end();
+             ++it) {
           data.push_back(it->second);
         }
       }
@@ -2752,16 +2867,18 @@ data::dmap::ioflush(ThreadAssistant& assistant)
             }
           }
         }
-        XrdSysMutexHelper mLock(this);
+        Shard& shard = GetShard((*it)->id());
+        XrdSysMutexHelper mLock(shard.mMutex);
         XrdSysMutexHelper lLock((*it)->Locker());
 
         // re-check that nobody is attached
-        if (!(*it)->attached_nolock() && !(*it)->file()->get_xrdiorw().size()) {
+        if (!(*it)->attached_nolock() && !(*it)->file()->get_xrdiorw().size() &&
+            !(*it)->opened_ahead_nolock()) {
           // here we make the data object unreachable for new clients
           (*it)->detach_nolock();
           cachehandler::instance().rm((*it)->id());
-          this->erase((*it)->id());
-          this->erase((*it)->id() + 0xffffffff);
+          shard.mMap.erase((*it)->id());
+          shard.mMap.erase((*it)->id() + 0xffffffff);
         }
       }
 
@@ -34,6 +34,7 @@
 #include "cap/cap.hh"
 #include "common/AssistedThread.hh"
 #include "common/FileId.hh"
+#include "misc/ShardedMap.hh"
 #include "bufferll.hh"
 #include "llfusexx.hh"
 #include "fusex/fusex.pb.h"
@@ -65,7 +66,8 @@ public:
       mSimulateWriteErrorInFlush(false),
       mSimulateWriteErrorInFlusher(false),
       mFlags(0), mXoff(false), mIsInlined(false), mInlineMaxSize(0),
-      mInlineCompressor("none"), mIsUnlinked(false)
+      mInlineCompressor("none"), mDeferredReaders(0), mIsUnlinked(false),
+      mOpenAheadUntil(0)
     {
       inline_buffer = nullptr;
     }
@@ -76,7 +78,7 @@ public:
       mSimulateWriteErrorInFlusher(false),
       mFlags(0), mXoff(false),
       mIsInlined(false), mInlineMaxSize(0), mInlineCompressor("none"),
-      mIsUnlinked(false) { }
+      mDeferredReaders(0), mIsUnlinked(false), mOpenAheadUntil(0) { }
 
     virtual ~datax()
     {
@@ -128,6 +130,8 @@ public:
                     const uint64_t md_pino,
                     fuse_req_t req,
                     bool isRW);
+    // open the remote file for a reader expected to come soon
+    void open_ahead(fuse_req_t req);
 
     // IO bridge interface
     ssize_t pread(fuse_req_t req, void* buf, size_t count, off_t offset);
@@ -190,6 +194,12 @@ public:
       return (mAttached == 1) ? true : false;
     }
 
+    bool opened_ahead_nolock()
+    {
+      // an unattached object opened ahead is kept for the next reader
+      return (mOpenAheadUntil && (time(NULL) < mOpenAheadUntil));
+    }
+
     bool unlinked()
     {
       // caller has to have this object locked
@@ -259,7 +269,13 @@ public:
     uint64_t mInlineMaxSize;
     std::string mInlineCompressor;
     bufferllmanager::shared_buffer inline_buffer;
+    size_t mDeferredReaders; // readers served from inline_buffer without a remote open
     bool mIsUnlinked;
+    time_t mOpenAheadUntil; // end of the grace period of an open-ahead
+
+    void open_ro(fuse_req_t req, int flags);
+    // open the remote file once a deferred reader misses the inline buffer
+    void open_deferred(fuse_req_t req);
 
   };
 
@@ -348,7 +364,7 @@ public:
 
   //----------------------------------------------------------------------------
 
-  class dmap : public std::map<fuse_ino_t, shared_data>, public XrdSysMutex
+  class dmap : public ShardedMap<shared_data>
   //----------------------------------------------------------------------------
   {
   public:
@@ -395,7 +411,6 @@ public:
 
   size_t size()
   {
-    XrdSysMutexHelper mLock(datamap);
     return datamap.size();
   }
 
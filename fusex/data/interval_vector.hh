@@ -0,0 +1,397 @@
+/*
+ * interval_vector.hh
+ *
+ ************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef INTERVALVECTOR_HH_
+#define INTERVALVECTOR_HH_
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
+
+template<typename I, typename V>
+struct interval_entry_t {
+
+  interval_entry_t(I low, I high, const V& value) :
+    low(low), high(high), value(value) { }
+
+  I low;
+  I high;
+  V value;
+};
+
+/*
+ * Drop-in replacement of interval_tree keeping the intervals sorted by their
+ * low end in pages of at most kPageSize entries, a B+ tree of depth two.
+ *
+ * The entries of a page are contiguous, lookups are a binary search over the
+ * first keys of the pages followed by one inside a page, so walking or
+ * querying a journal with 100k chunks touches a few cache lines per interval
+ * instead of one heap node each. Emptied pages are kept in a small pool and
+ * reused with their capacity, so a journal which is filled and flushed over
+ * and over does not go back to the allocator.
+ *
+ * As for interval_tree, an interval whose low end is already present is not
+ * inserted and the intervals may overlap. A query only looks back from its
+ * low end by the longest interval inserted since the last clear. Iterators
+ * are invalidated by insert and erase.
+ */
+template<typename I, typename V>
+class interval_vector
+{
+public:
+
+  typedef interval_entry_t<I, V> N;
+
+  // max number of entries in a page before it is split
+  static constexpr size_t kPageSize = 256;
+  // max number of emptied pages kept for reuse
+  static constexpr size_t kPoolSize = 8;
+
+  class iterator
+  {
+    friend class interval_vector;
+
+  public:
+
+    iterator(interval_vector* tree = nullptr, size_t page = 0, size_t pos = 0) :
+      tree(tree), page(page), pos(pos) { }
+
+    N* operator->()
+    {
+      return &tree->pages[page][pos];
+    }
+
+    N& operator*()
+    {
+      return tree->pages[page][pos];
+    }
+
+    const N* operator->() const
+    {
+      return &tree->pages[page][pos];
+    }
+
+    const N& operator*() const
+    {
+      return tree->pages[page][pos];
+    }
+
+    operator bool() const
+    {
+      return tree && (page < tree->pages.size());
+    }
+
+    iterator& operator++()
+    {
+      if (!*this) {
+        return *this;
+      }
+
+      if (++pos == tree->pages[page].size()) {
+        ++page;
+        pos = 0;
+      }
+
+      return *this;
+    }
+
+    bool operator==(const iterator& itr) const
+    {
+      return (tree == itr.tree) && (page == itr.page) && (pos == itr.pos);
+    }
+
+    bool operator!=(const iterator& itr) const
+    {
+      return !(*this == itr);
+    }
+
+  private:
+
+    interval_vector* tree;
+    size_t page;
+    size_t pos;
+  };
+
+  struct less {
+
+    bool operator()(const iterator& x, const iterator& y) const
+    {
+      return x->low < y->low;
+    }
+  };
+
+  interval_vector() : tree_size(0), span(0) { }
+
+  virtual ~interval_vector() { }
+
+  void insert(I low, I high, const V& value)
+  {
+    if (pages.empty()) {
+      pages.push_back(make_page());
+      pages.back().push_back(N(low, high, value));
+      firsts.push_back(low);
+      maxs.push_back(high);
+      ++tree_size;
+      span = high - low;
+      return;
+    }
+
+    size_t p = page_for(low);
+    page_t& page = pages[p];
+    auto it = std::lower_bound(page.begin(), page.end(), low, key_less);
+
+    if (it != page.end() && it->low == low) {
+      return;
+    }
+
+    page.insert(it, N(low, high, value));
+    firsts[p] = page.front().low;
+    maxs[p] = std::max(maxs[p], high);
+    ++tree_size;
+    span = std::max(span, (I)(high - low));
+
+    if (page.size() > kPageSize) {
+      split(p);
+    }
+  }
+
+  void erase(I low, I high)
+  {
+    iterator itr = find(low);
+
+    if (!itr || itr->high != high) {
+      return;
+    }
+
+    page_t& page = pages[itr.page];
+    page.erase(page.begin() + itr.pos);
+    --tree_size;
+
+    if (page.empty()) {
+      release(itr.page);
+      return;
+    }
+
+    firsts[itr.page] = page.front().low;
+    set_max(itr.page);
+
+    // two neighbours which fit together in half a page are joined so that a
+    // journal shrinking by many erases doesn't end up with sparse pages
+    size_t p = itr.page;
+
+    if (p + 1 < pages.size() &&
+        page.size() + pages[p + 1].size() <= kPageSize / 2) {
+      page.insert(page.end(), pages[p + 1].begin(), pages[p + 1].end());
+      maxs[p] = std::max(maxs[p], maxs[p + 1]);
+      release(p + 1);
+    }
+  }
+
+  // merges the adjacent range [high, new_high) into the interval [low, high)
+  // in place, the caller makes sure it doesn't overlap the next intervals;
+  // returns false if there is no such interval
+  bool extend(I low, I high, I new_high)
+  {
+    iterator itr = find(low);
+
+    if (!itr || itr->high != high || new_high < high) {
+      return false;
+    }
+
+    itr->high = new_high;
+    maxs[itr.page] = std::max(maxs[itr.page], new_high);
+    span = std::max(span, (I)(new_high - low));
+    return true;
+  }
+
+  // the intervals overlapping [low, high) sorted by their low end
+  std::vector<iterator> query(I low, I high)
+  {
+    std::vector<iterator> result;
+
+    if (pages.empty()) {
+      return result;
+    }
+
+    // nothing starting before 'from' can reach 'low'
+    I from = (low > (I)(std::numeric_limits<I>::lowest() + span)) ?
+             (I)(low - span) : std::numeric_limits<I>::lowest();
+
+    for (size_t p = page_for(from); (p < pages.size()) && (firsts[p] < high);
+         ++p) {
+      if (maxs[p] <= low) {
+        continue;
+      }
+
+      page_t& page = pages[p];
+      auto it = (firsts[p] < from) ?
+                std::lower_bound(page.begin(), page.end(), from, key_less) :
+                page.begin();
+
+      for (; (it != page.end()) && (it->low < high); ++it) {
+        if (low < it->high) {
+          result.push_back(iterator(this, p, it - page.begin()));
+        }
+      }
+    }
+
+    return result;
+  }
+
+  iterator find(I low)
+  {
+    if (pages.empty()) {
+      return end();
+    }
+
+    size_t p = page_for(low);
+    page_t& page = pages[p];
+    auto it = std::lower_bound(page.begin(), page.end(), low, key_less);
+
+    if (it == page.end() || it->low != low) {
+      return end();
+    }
+
+    return iterator(this, p, it - page.begin());
+  }
+
+  void clear()
+  {
+    for (auto& page : pages) {
+      if (pool.size() >= kPoolSize) {
+        break;
+      }
+
+      page.clear();
+      pool.push_back(std::move(page));
+    }
+
+    pages.clear();
+    firsts.clear();
+    maxs.clear();
+    tree_size = 0;
+    span = 0;
+  }
+
+  size_t size() const
+  {
+    return tree_size;
+  }
+
+  bool empty() const
+  {
+    return !tree_size;
+  }
+
+  iterator begin()
+  {
+    return iterator(this, 0, 0);
+  }
+
+  iterator end()
+  {
+    return iterator(this, pages.size(), 0);
+  }
+
+private:
+
+  typedef std::vector<N> page_t;
+
+  static bool key_less(const N& node, I low)
+  {
+    return node.low < low;
+  }
+
+  // the page where an interval starting at low is or would be inserted
+  size_t page_for(I low) const
+  {
+    auto it = std::upper_bound(firsts.begin(), firsts.end(), low);
+    return (it == firsts.begin()) ? 0 : (it - firsts.begin()) - 1;
+  }
+
+  page_t make_page()
+  {
+    if (pool.empty()) {
+      page_t page;
+      page.reserve(kPageSize + 1);
+      return page;
+    }
+
+    page_t page = std::move(pool.back());
+    pool.pop_back();
+    return page;
+  }
+
+  void split(size_t p)
+  {
+    page_t upper = make_page();
+    page_t& page = pages[p];
+    upper.insert(upper.end(), page.begin() + page.size() / 2, page.end());
+    page.erase(page.begin() + page.size() / 2, page.end());
+    I first = upper.front().low;
+    pages.insert(pages.begin() + p + 1, std::move(upper));
+    firsts.insert(firsts.begin() + p + 1, first);
+    maxs.insert(maxs.begin() + p + 1, I());
+    set_max(p);
+    set_max(p + 1);
+  }
+
+  void release(size_t p)
+  {
+    if (pool.size() < kPoolSize) {
+      pages[p].clear();
+      pool.push_back(std::move(pages[p]));
+    }
+
+    pages.erase(pages.begin() + p);
+    firsts.erase(firsts.begin() + p);
+    maxs.erase(maxs.begin() + p);
+  }
+
+  void set_max(size_t p)
+  {
+    maxs[p] = pages[p].front().high;
+
+    for (const auto& node : pages[p]) {
+      maxs[p] = std::max(maxs[p], node.high);
+    }
+  }
+
+  std::vector<page_t> pages;
+  // the low end of the first interval of each page
+  std::vector<I> firsts;
+  // the highest high end of each page
+  std::vector<I> maxs;
+  // emptied pages kept with their capacity
+  std::vector<page_t> pool;
+  size_t tree_size;
+  // the longest interval since the last clear
+  I span;
+};
+
+template<typename I, typename V>
+constexpr size_t interval_vector<I, V>::kPageSize;
+
+template<typename I, typename V>
+constexpr size_t interval_vector<I, V>::kPoolSize;
+
+#endif /* INTERVALVECTOR_HH_ */
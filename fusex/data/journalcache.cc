@@ -34,6 +34,8 @@
 
 std::string journalcache::sLocation;
 size_t journalcache::sMaxSize = 128 * 1024 * 1024ll; // TODO Some dummy default
+size_t journalcache::sMaxInflightSize = 64 * 1024 * 1024ll;
+constexpr size_t journalcache::kMaxRecordSize;
 
 journalcache::journalcache(fuse_ino_t ino) : ino(ino), cachesize(0),
 					     truncatesize(-1), fd(-1), nbAttached(0), nbFlushed(0), max_offset(0)
@@ -232,8 +234,8 @@ ssize_t journalcache::pread(void* buf, size_t count, off_t offset)
   return bytesRead;
 }
 
-void journalcache::process_intersection(interval_tree<uint64_t, const void*>&
-                                        to_write, interval_tree<uint64_t, uint64_t>::iterator itr,
+void journalcache::process_intersection(interval_vector<uint64_t, const void*>&
+                                        to_write, interval_vector<uint64_t, uint64_t>::iterator itr,
                                         std::vector<chunk_t>& updates)
 {
   auto result = to_write.query(itr->low, itr->high);
@@ -246,7 +248,7 @@ void journalcache::process_intersection(interval_tree<uint64_t, const void*>&
     throw std::logic_error("journalcache: overlapping journal entries");
   }
 
-  const interval_tree<uint64_t, const void*>::iterator to_wrt = *result.begin();
+  const interval_vector<uint64_t, const void*>::iterator to_wrt = *result.begin();
   // the intersection
   uint64_t low = std::max(to_wrt->low, itr->low);
   uint64_t high = std::min(to_wrt->high, itr->high);
@@ -310,7 +312,7 @@ ssize_t journalcache::pwrite(const void* buf, size_t count, off_t offset)
     clck.write_wait();
   }
 
-  interval_tree<uint64_t, const void*> to_write;
+  interval_vector<uint64_t, const void*> to_write;
   std::vector<chunk_t> updates;
   to_write.insert(offset, offset + count, buf);
   auto res = journal.query(offset, offset + count);
@@ -325,11 +327,22 @@ ssize_t journalcache::pwrite(const void* buf, size_t count, off_t offset)
     return -1;
   }
 
-  interval_tree<uint64_t, const void*>::iterator itr;
+  interval_vector<uint64_t, const void*>::iterator itr;
 
   // TODO this could be replaced with a single pwritev
   for (itr = to_write.begin(); itr != to_write.end(); ++itr) {
     uint64_t size = itr->high - itr->low;
+
+    // appending to the last record keeps sequential small writes in a
+    // single journal entry which is flushed as one large write
+    if ((rc = append_last(itr->low, itr->high, itr->value)) < 0) {
+      return -1;
+    }
+
+    if (rc) {
+      continue;
+    }
+
     header_t header;
     header.offset = itr->low;
     header.size = size;
@@ -363,6 +376,44 @@ ssize_t journalcache::pwrite(const void* buf, size_t count, off_t offset)
   return count;
 }
 
+int journalcache::append_last(uint64_t low, uint64_t high, const void* buff)
+{
+  if (!low) {
+    return 0;
+  }
+
+  auto res = journal.query(low - 1, low);
+
+  for (auto& prev : res) {
+    uint64_t prev_size = prev->high - prev->low;
+
+    if ((prev->high != low) ||
+        (prev->value + sizeof(header_t) + prev_size != cachesize) ||
+        (prev_size + (high - low) > kMaxRecordSize)) {
+      continue;
+    }
+
+    // write the data first, the header is only extended once it is there
+    header_t header;
+    header.offset = prev->low;
+    header.size = prev_size + (high - low);
+    uint64_t prev_low = prev->low;
+    uint64_t prev_value = prev->value;
+
+    if ((::pwrite(fd, buff, high - low, cachesize) != (ssize_t)(high - low)) ||
+        (::pwrite(fd, &header, sizeof(header_t), prev_value) !=
+         (ssize_t) sizeof(header_t))) {
+      return -1;
+    }
+
+    journal.extend(prev_low, low, high);
+    cachesize += high - low;
+    return 1;
+  }
+
+  return 0;
+}
+
 int journalcache::truncate(off_t offset, bool invalidate)
 {
   int rc = 0;
@@ -417,6 +468,7 @@ int journalcache::init(const cacheconfig& config)
     journalcache::sMaxSize = config.per_file_journal_max_size;
   }
 
+  journalcache::sMaxInflightSize = config.per_file_max_inflight_write_buffer_size;
   eos_static_info("journalcache location %s", sLocation.c_str());
   return 0;
 }
@@ -464,22 +516,45 @@ int journalcache::remote_sync_async(XrdCl::Proxy* proxy)
   off_t offshift = sizeof(header_t);
   write_lock lck(clck);
 
-  for (auto itr = journal.begin(); itr != journal.end(); ++itr) {
-    off_t cacheoff = itr->value + offshift;
-    size_t size = itr->high - itr->low;
-    // prepare async buffer
-    XrdCl::Proxy::write_handler handler = proxy->WriteAsyncPrepare(size, itr->low,
-                                          0);
-    int bytesRead = ::pread(fd, (void*) handler->buffer(), size, cacheoff);
+  for (auto itr = journal.begin(); itr != journal.end();) {
+    // adjacent journal entries are sent as a single write request
+    auto last = itr;
+    uint64_t low = itr->low;
+    uint64_t high = itr->high;
+
+    for (++last; (last != journal.end()) && (last->low == high) &&
+         (last->high - low <= kMaxRecordSize); ++last) {
+      high = last->high;
+    }
 
-    if (bytesRead < 0) {
-      // TODO handle error
+    size_t size = high - low;
+
+    // bound the amount of buffers in-flight for this file
+    if (sMaxInflightSize && !proxy->WaitWriteBytes(sMaxInflightSize - std::min(size,
+        sMaxInflightSize)).IsOK()) {
+      eos_static_err("failed to wait for in-flight async-writes");
       clck.broadcast();
       return -1;
     }
 
-    if (bytesRead < (int) size) {
-      // TODO handle error - still we continue
+    // prepare async buffer
+    XrdCl::Proxy::write_handler handler = proxy->WriteAsyncPrepare(size, low, 0);
+
+    for (; itr != last; ++itr) {
+      off_t cacheoff = itr->value + offshift;
+      size_t chunk = itr->high - itr->low;
+      int bytesRead = ::pread(fd, (void*)(handler->buffer() + (itr->low - low)),
+                              chunk, cacheoff);
+
+      if (bytesRead < 0) {
+        // TODO handle error
+        clck.broadcast();
+        return -1;
+      }
+
+      if (bytesRead < (int) chunk) {
+        // TODO handle error - still we continue
+      }
     }
 
     XrdCl::XRootDStatus st = proxy->ScheduleWriteAsync(0, handler);
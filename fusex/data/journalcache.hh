@@ -31,7 +31,7 @@
 #include "cacheconfig.hh"
 #include "xrdclproxy.hh"
 
-#include "interval_tree.hh"
+#include "interval_vector.hh"
 
 #include <stdint.h>
 
@@ -143,8 +143,8 @@ private:
 
 private:
 
-  void process_intersection(interval_tree<uint64_t, const void*>& write,
-                            interval_tree<uint64_t, uint64_t>::iterator acr, std::vector<chunk_t>& updates);
+  void process_intersection(interval_vector<uint64_t, const void*>& write,
+                            interval_vector<uint64_t, uint64_t>::iterator acr, std::vector<chunk_t>& updates);
 
   int location(std::string& path, bool mkpath = true);
 
@@ -155,6 +155,14 @@ private:
 
   int update_cache(std::vector<chunk_t>& updates);
 
+  //----------------------------------------------------------------------------
+  //! Append the interval to the journal entry ending at low if it is the last
+  //! record of the cache file, needs the cache lock
+  //!
+  //! @return 1 if appended, 0 if not, -1 on error
+  //----------------------------------------------------------------------------
+  int append_last(uint64_t low, uint64_t high, const void* buff);
+
   int read_journal();
 
   fuse_ino_t ino;
@@ -163,7 +171,7 @@ private:
   off_t max_offset;
   int fd;
   // the value is the offset in the cache file
-  interval_tree<uint64_t, uint64_t> journal;
+  interval_vector<uint64_t, uint64_t> journal;
   size_t nbAttached;
   size_t nbFlushed;
   cachelock clck;
@@ -171,6 +179,10 @@ private:
   bufferllmanager::shared_buffer buffer;
   static std::string sLocation;
   static size_t sMaxSize;
+  //! max size of the async writes in-flight per file, 0 means unlimited
+  static size_t sMaxInflightSize;
+  //! max size of a journal record extended by appends and of a flushed write
+  static constexpr size_t kMaxRecordSize = 4 * 1024 * 1024;
 };
 
 #endif /* FUSEX_JOURNALCACHE_HH_ */
@@ -0,0 +1,373 @@
+//------------------------------------------------------------------------------
+//! @file rainreader.cc
+//! @brief parallel read of RAIN files directly from the stripe servers
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "data/rainreader.hh"
+#include "data/xrdclproxy.hh"
+#include "common/LayoutId.hh"
+#include "common/ThreadPool.hh"
+#include "XrdOuc/XrdOucEnv.hh"
+#include "XrdOuc/XrdOucString.hh"
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <string.h>
+
+constexpr uint64_t XrdCl::RainReader::kSizeHeader;
+constexpr uint64_t XrdCl::RainReader::kMinSize;
+
+/* -------------------------------------------------------------------------- */
+static eos::common::ThreadPool&
+/* -------------------------------------------------------------------------- */
+GetStripeThreadPool()
+/* -------------------------------------------------------------------------- */
+{
+  // shared by all the RAIN readers, the calling thread reads one stripe itself
+  static eos::common::ThreadPool pool(4, 64, 10, 12, 2, "rain_read");
+  return pool;
+}
+
+/* -------------------------------------------------------------------------- */
+XrdCl::RainReader::RainReader() : mOpen(false), mNbDataFiles(0),
+  mStripeWidth(0), mFileSize(0)
+/* -------------------------------------------------------------------------- */
+{
+}
+
+/* -------------------------------------------------------------------------- */
+XrdCl::RainReader::~RainReader()
+/* -------------------------------------------------------------------------- */
+{
+  Release();
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+XrdCl::RainReader::Split(uint64_t offset, uint32_t size, uint32_t ndata,
+                         uint64_t width, std::vector<piece_t>& pieces)
+/* -------------------------------------------------------------------------- */
+{
+  uint64_t line = ndata * width;
+  uint64_t pos = offset;
+  uint64_t end = offset + size;
+  pieces.clear();
+
+  while (pos < end) {
+    uint64_t block_end = (pos / width + 1) * width;
+    piece_t piece;
+    piece.stripe = (pos / width) % ndata;
+    // same mapping as ReedSLayout/RaidDpLayout::GetLocalPos
+    piece.local_offset = (pos / line) * width + (pos % width);
+    piece.size = std::min(block_end, end) - pos;
+    piece.buffer_offset = pos - offset;
+    pieces.push_back(piece);
+    pos += piece.size;
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+bool
+/* -------------------------------------------------------------------------- */
+XrdCl::RainReader::ReadHeader(Proxy* stripe, uint32_t& id, uint64_t& size,
+                              uint16_t timeout)
+/* -------------------------------------------------------------------------- */
+{
+  // layout of fst/layout/HeaderCRC
+  static const char tag_name[] = "_HEADER__RAIDIO_";
+  char header[kSizeHeader];
+  uint32_t bytesRead = 0;
+  XRootDStatus status = stripe->File::Read(0, kSizeHeader, header, bytesRead,
+                        timeout);
+
+  if (!status.IsOK() || (bytesRead != kSizeHeader) ||
+      strncmp(header, tag_name, strlen(tag_name))) {
+    return false;
+  }
+
+  size_t offset = 16;
+  unsigned int id_stripe;
+  long long int num_blocks;
+  size_t size_last_block;
+  size_t size_block;
+  memcpy(&id_stripe, header + offset, sizeof(id_stripe));
+  offset += sizeof(id_stripe);
+  memcpy(&num_blocks, header + offset, sizeof(num_blocks));
+  offset += sizeof(num_blocks);
+  memcpy(&size_last_block, header + offset, sizeof(size_last_block));
+  offset += sizeof(size_last_block);
+  memcpy(&size_block, header + offset, sizeof(size_block));
+
+  if (size_block != mStripeWidth) {
+    return false;
+  }
+
+  id = id_stripe;
+  size = num_blocks ? ((num_blocks - 1) * size_block + size_last_block) : 0;
+  return true;
+}
+
+/* -------------------------------------------------------------------------- */
+XrdCl::XRootDStatus
+/* -------------------------------------------------------------------------- */
+XrdCl::RainReader::Open(const std::string& url, Proxy* gateway,
+                        uint16_t timeout)
+/* -------------------------------------------------------------------------- */
+{
+  // ask the MGM for the stripe locations like fst/xrdcl_plugins/RainFile
+  XrdCl::URL gurl(url);
+  std::string request = gurl.GetPathWithParams();
+  request += (request.find('?') == std::string::npos) ? "?" : "&";
+  request += "mgm.pcmd=open";
+  std::string endpoint = "root://";
+  endpoint += gurl.GetHostId();
+  endpoint += "/";
+  XrdCl::FileSystem fs((XrdCl::URL(endpoint)));
+  Buffer arg;
+  Buffer* response = 0;
+  arg.FromString(request);
+  XRootDStatus status = fs.Query(QueryCode::OpaqueFile, arg, response, timeout);
+
+  if (!status.IsOK()) {
+    return status;
+  }
+
+  XrdOucString stringOpaque = response->ToString().c_str();
+  std::string origResponse = response->ToString();
+  delete response;
+
+  while (stringOpaque.replace("?", "&")) { }
+
+  while (stringOpaque.replace("&&", "&")) { }
+
+  XrdOucEnv openOpaque(stringOpaque.c_str());
+  size_t logid_pos = origResponse.find("mgm.logid");
+
+  if (!openOpaque.Get("mgm.lid") || (logid_pos == std::string::npos)) {
+    return XRootDStatus(stError, errDataError, 0, "no PIO opaque info");
+  }
+
+  unsigned long layout = strtoul(openOpaque.Get("mgm.lid"), 0, 10);
+  unsigned long type = eos::common::LayoutId::GetLayoutType(layout);
+
+  if ((type != eos::common::LayoutId::kRaidDP) &&
+      (type != eos::common::LayoutId::kRaid6) &&
+      (type != eos::common::LayoutId::kArchive)) {
+    return XRootDStatus(stError, errNotSupported, 0, "no RAIN layout");
+  }
+
+  uint32_t nb_total = eos::common::LayoutId::GetStripeNumber(layout) + 1;
+  uint32_t nb_parity = eos::common::LayoutId::GetRedundancyStripeNumber(layout);
+
+  if (nb_total <= nb_parity) {
+    return XRootDStatus(stError, errDataError, 0, "invalid RAIN layout");
+  }
+
+  mNbDataFiles = nb_total - nb_parity;
+  mStripeWidth = eos::common::LayoutId::GetBlocksize(layout);
+  std::string opaque = origResponse.substr(logid_pos);
+  std::string login = gurl.GetUserName().length() ? (gurl.GetUserName() + "@") :
+                      "";
+
+  // open all the stripes in parallel
+  for (uint32_t i = 0; i < nb_total; ++i) {
+    std::string tag = "pio." + std::to_string(i);
+
+    if (!openOpaque.Get(tag.c_str())) {
+      mStripes.push_back(0);
+      continue;
+    }
+
+    std::string stripe_url = "root://";
+    stripe_url += login;
+    stripe_url += openOpaque.Get(tag.c_str());
+    stripe_url += "/";
+    stripe_url += gurl.GetPath();
+    stripe_url += "?";
+    stripe_url += opaque;
+    stripe_url += "&mgm.replicaindex=" + std::to_string(i);
+    stripe_url += "&fst.readahead=true&fst.blocksize=" +
+                  std::to_string(mStripeWidth);
+    Proxy* stripe = new Proxy();
+    stripe->set_id(gateway->id(), gateway->req());
+    stripe->inherit_readahead(gateway);
+    stripe->OpenAsync(stripe_url, OpenFlags::Read, Access::UR, timeout);
+    mStripes.push_back(stripe);
+  }
+
+  // map the data stripes using the ids stored in the headers
+  mData.assign(mNbDataFiles, 0);
+  uint64_t stripe_size = 0;
+
+  for (auto stripe : mStripes) {
+    uint32_t id = 0;
+    uint64_t size = 0;
+
+    if (!stripe || !stripe->WaitOpen().IsOK() ||
+        !ReadHeader(stripe, id, size, timeout)) {
+      continue;
+    }
+
+    if ((id < mNbDataFiles) && !mData[id]) {
+      mData[id] = stripe;
+      mFileSize = size;
+    }
+  }
+
+  for (auto stripe : mData) {
+    if (!stripe) {
+      // reading would require a reconstruction, leave that to the gateway
+      Release();
+      return XRootDStatus(stError, errDataError, 0, "data stripe unavailable");
+    }
+  }
+
+  stripe_size = ((mFileSize + mNbDataFiles * mStripeWidth - 1) /
+                 (mNbDataFiles * mStripeWidth)) * mStripeWidth + kSizeHeader;
+
+  for (auto stripe : mData) {
+    stripe->set_readahead_maximum_position(stripe_size);
+  }
+
+  eos_info("pio open url=%s size=%lu data-stripes=%u width=%lu",
+           gurl.GetPath().c_str(), mFileSize, mNbDataFiles, mStripeWidth);
+  mOpen = true;
+  return XRootDStatus();
+}
+
+/* -------------------------------------------------------------------------- */
+XrdCl::XRootDStatus
+/* -------------------------------------------------------------------------- */
+XrdCl::RainReader::Read(uint64_t offset, uint32_t size, void* buffer,
+                        uint32_t& bytesRead, uint16_t timeout)
+/* -------------------------------------------------------------------------- */
+{
+  bytesRead = 0;
+
+  if (!mOpen) {
+    return XRootDStatus(stError, errInvalidOp, 0, "not open");
+  }
+
+  if (offset >= mFileSize) {
+    return XRootDStatus();
+  }
+
+  if (offset + size > mFileSize) {
+    size = mFileSize - offset;
+  }
+
+  std::vector<piece_t> pieces;
+  Split(offset, size, mNbDataFiles, mStripeWidth, pieces);
+  // the pieces of one stripe are contiguous in the stripe file
+  std::vector<uint64_t> start(mNbDataFiles, 0);
+  std::vector<uint32_t> length(mNbDataFiles, 0);
+
+  for (auto& piece : pieces) {
+    if (!length[piece.stripe]) {
+      start[piece.stripe] = piece.local_offset;
+    }
+
+    length[piece.stripe] += piece.size;
+  }
+
+  std::vector<std::vector<char>> data(mNbDataFiles);
+  std::vector<std::future<bool>> tasks;
+
+  auto read_stripe = [this, &start, &length, &data, timeout](uint32_t s) {
+    uint32_t stripe_read = 0;
+    data[s].resize(length[s]);
+    XRootDStatus st = mData[s]->Read(start[s] + kSizeHeader, length[s],
+                                     data[s].data(), stripe_read, timeout);
+    return (st.IsOK() && (stripe_read == length[s]));
+  };
+
+  uint32_t first = mNbDataFiles;
+
+  for (uint32_t s = 0; s < mNbDataFiles; ++s) {
+    if (!length[s]) {
+      continue;
+    }
+
+    if (first == mNbDataFiles) {
+      first = s;
+      continue;
+    }
+
+    tasks.push_back(GetStripeThreadPool().PushTask<bool>(std::bind(read_stripe,
+                    s)));
+  }
+
+  bool ok = (first == mNbDataFiles) || read_stripe(first);
+
+  for (auto& task : tasks) {
+    ok &= task.get();
+  }
+
+  if (!ok) {
+    eos_warning("pio read failed offset=%lu size=%u", offset, size);
+    return XRootDStatus(stError, errDataError, 0, "stripe read failed");
+  }
+
+  std::vector<uint64_t> pos(mNbDataFiles, 0);
+
+  for (auto& piece : pieces) {
+    memcpy((char*) buffer + piece.buffer_offset,
+           data[piece.stripe].data() + pos[piece.stripe], piece.size);
+    pos[piece.stripe] += piece.size;
+  }
+
+  bytesRead = size;
+  return XRootDStatus();
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+XrdCl::RainReader::Release()
+/* -------------------------------------------------------------------------- */
+{
+  for (auto stripe : mStripes) {
+    if (!stripe) {
+      continue;
+    }
+
+    if (stripe->IsOpening()) {
+      stripe->WaitOpen();
+    }
+
+    if (stripe->IsOpen()) {
+      stripe->DropReadAhead();
+      // the close callback deletes the proxy
+      stripe->flag_selfdestructionTS();
+
+      if (!stripe->CloseAsync(0).IsOK()) {
+        delete stripe;
+      }
+    } else {
+      delete stripe;
+    }
+  }
+
+  mStripes.clear();
+  mData.clear();
+  mOpen = false;
+}
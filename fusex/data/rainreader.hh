@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------------
+//! @file rainreader.hh
+//! @brief parallel read of RAIN files directly from the stripe servers
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef FUSE_RAINREADER_HH_
+#define FUSE_RAINREADER_HH_
+
+#include "XrdCl/XrdClXRootDResponses.hh"
+#include "common/Logging.hh"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace XrdCl
+{
+class Proxy;
+
+// ---------------------------------------------------------------------- //
+//! Class RainReader - reads a RAIN file in parallel IO mode: the MGM returns
+//! the stripe locations, the data stripes are opened directly on their FSTs
+//! and a read is split into one request per data stripe running in parallel.
+//! Each stripe proxy runs its own read-ahead. There is no reconstruction on
+//! the client side, any stripe failure makes the reader invalid and the
+//! caller falls back to the gateway read which reconstructs on the FST.
+// ---------------------------------------------------------------------- //
+
+class RainReader : public eos::common::LogId
+{
+public:
+
+  //! piece of a logical read served by a single data stripe
+  struct piece_t {
+    uint32_t stripe; // logical data stripe index
+    uint64_t local_offset; // offset in the stripe file without header
+    uint32_t size; // size of the piece
+    uint64_t buffer_offset; // offset of the piece in the logical read
+  };
+
+  //! size of the RAIN header in front of every stripe file
+  static constexpr uint64_t kSizeHeader = 4096;
+
+  //! minimum file size for which the parallel IO mode is tried
+  static constexpr uint64_t kMinSize = 4 * 1024 * 1024;
+
+  RainReader();
+
+  virtual ~RainReader();
+
+  // ---------------------------------------------------------------------- //
+  //! Open the stripes of a file
+  //!
+  //! @param url MGM url used to open the file through the gateway
+  //! @param gateway proxy providing the read-ahead settings for the stripes
+  //! @param timeout request timeout
+  //!
+  //! @return errNotSupported if the file does not have a RAIN layout
+  // ---------------------------------------------------------------------- //
+  XRootDStatus Open(const std::string& url, Proxy* gateway, uint16_t timeout);
+
+  // ---------------------------------------------------------------------- //
+  //! Read from the data stripes in parallel
+  // ---------------------------------------------------------------------- //
+  XRootDStatus Read(uint64_t offset, uint32_t size, void* buffer,
+                    uint32_t& bytesRead, uint16_t timeout);
+
+  // ---------------------------------------------------------------------- //
+  //! Release the stripe proxies, they are closed asynchronously
+  // ---------------------------------------------------------------------- //
+  void Release();
+
+  bool IsOpen() const
+  {
+    return mOpen;
+  }
+
+  uint64_t Size() const
+  {
+    return mFileSize;
+  }
+
+  // ---------------------------------------------------------------------- //
+  //! Split a logical read into pieces per data stripe, pieces of the same
+  //! stripe are contiguous in the stripe file
+  //!
+  //! @param offset logical offset
+  //! @param size logical size
+  //! @param ndata number of data stripes
+  //! @param width stripe block size
+  //! @param pieces output pieces in logical order
+  // ---------------------------------------------------------------------- //
+  static void Split(uint64_t offset, uint32_t size, uint32_t ndata,
+                    uint64_t width, std::vector<piece_t>& pieces);
+
+private:
+  // ---------------------------------------------------------------------- //
+  //! Read the header of a stripe
+  //!
+  //! @return true if the header is valid
+  // ---------------------------------------------------------------------- //
+  bool ReadHeader(Proxy* stripe, uint32_t& id, uint64_t& size,
+                  uint16_t timeout);
+
+  bool mOpen;
+  uint32_t mNbDataFiles;
+  uint64_t mStripeWidth;
+  uint64_t mFileSize;
+  std::vector<Proxy*> mStripes; // stripe proxies indexed by physical index
+  std::vector<Proxy*> mData; // data stripe proxies indexed by logical index
+};
+}
+
+#endif
@@ -0,0 +1,683 @@
+//------------------------------------------------------------------------------
+//! @file tieredcache.cc
+//! @brief file start cache keeping hot blocks in a global memory budget
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "tieredcache.hh"
+#include "stat/Stat.hh"
+#include "common/Logging.hh"
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include "common/XattrCompat.hh"
+
+#ifndef EKEYEXPIRED
+#define EKEYEXPIRED 127
+#endif
+
+constexpr size_t tieredcache::kBlockSize;
+
+// maximum number of clock entries inspected to make room for a single block
+static constexpr size_t kMaxScan = 1024;
+
+/* -------------------------------------------------------------------------- */
+cacheclock::cacheclock() : mBudget(0), mStat(nullptr), mBytes(0), mBlocks(0),
+  mEvicted(0)
+/* -------------------------------------------------------------------------- */
+{
+  mHand = mRing.end();
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+cacheclock::configure(uint64_t budget, std::function<uint64_t()> external,
+                      Stat* stat)
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper lLock(mMutex);
+  mBudget = budget;
+  mExternal = external;
+  mStat = stat;
+}
+
+/* -------------------------------------------------------------------------- */
+bool
+/* -------------------------------------------------------------------------- */
+cacheclock::reserve(tieredcache* owner, uint64_t index, block* blk,
+                    position& pos)
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper lLock(mMutex);
+  uint64_t limit = mBudget;
+
+  if (limit && mExternal) {
+    // buffers in-flight use the same memory
+    uint64_t external = mExternal();
+    limit = (external < limit) ? (limit - external) : 0;
+  }
+
+  size_t scanned = 0;
+  size_t max_scan = std::min(2 * mRing.size(), kMaxScan);
+  uint64_t evicted = 0;
+
+  while (mBudget && ((mBytes + tieredcache::kBlockSize) > limit) &&
+         !mRing.empty() && (scanned++ < max_scan)) {
+    if (mHand == mRing.end()) {
+      mHand = mRing.begin();
+    }
+
+    entry& e = *mHand;
+
+    if (e.blk->referenced.exchange(false)) {
+      // second chance
+      ++mHand;
+      continue;
+    }
+
+    tieredcache* victim = e.owner;
+    uint64_t victim_index = e.index;
+
+    if (victim == owner) {
+      if (!owner->mLower) {
+        // dropping our own blocks would break the contiguous start of the
+        // memory-only cache we are currently extending
+        ++mHand;
+        continue;
+      }
+
+      evicted += evict(victim, victim_index);
+    } else {
+      if (!victim->mMutex.CondLock()) {
+        // busy cache, don't wait for it
+        ++mHand;
+        continue;
+      }
+
+      evicted += evict(victim, victim_index);
+      victim->mMutex.UnLock();
+    }
+  }
+
+  if (evicted && mStat) {
+    mStat->Add("cache:ram-evict", 0, 0, evicted);
+  }
+
+  if (mBudget && ((mBytes + tieredcache::kBlockSize) > limit)) {
+    return false;
+  }
+
+  entry e;
+  e.owner = owner;
+  e.index = index;
+  e.blk = blk;
+  // new entries are inserted behind the hand and are inspected last
+  pos = mRing.insert(mHand, e);
+  mBytes += tieredcache::kBlockSize;
+  mBlocks++;
+  return true;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+cacheclock::release(position pos)
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper lLock(mMutex);
+  erase(pos);
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+cacheclock::hit(size_t bytes)
+/* -------------------------------------------------------------------------- */
+{
+  if (mStat) {
+    mStat->Add("cache:ram-hit", 0, 0, bytes);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+cacheclock::miss(size_t bytes)
+/* -------------------------------------------------------------------------- */
+{
+  if (mStat) {
+    mStat->Add("cache:ram-miss", 0, 0, bytes);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+cacheclock::erase(position pos)
+/* -------------------------------------------------------------------------- */
+{
+  if (mHand == pos) {
+    ++mHand;
+  }
+
+  mRing.erase(pos);
+  mBytes -= tieredcache::kBlockSize;
+  mBlocks--;
+}
+
+/* -------------------------------------------------------------------------- */
+uint64_t
+/* -------------------------------------------------------------------------- */
+cacheclock::evict(tieredcache* victim, uint64_t index)
+/* -------------------------------------------------------------------------- */
+{
+  std::vector<position> dropped;
+  victim->evict(index, dropped);
+
+  for (auto it = dropped.begin(); it != dropped.end(); ++it) {
+    erase(*it);
+    mEvicted++;
+  }
+
+  return dropped.size() * tieredcache::kBlockSize;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+tieredcache::init(const cacheconfig& config, std::function<uint64_t()> external,
+                  Stat* stat)
+/* -------------------------------------------------------------------------- */
+{
+  clock().configure(config.memory_budget, external, stat);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+tieredcache::tieredcache(fuse_ino_t _ino, cache* lower) : ino(_ino),
+  mLower(lower)
+  /* -------------------------------------------------------------------------- */
+{
+  return;
+}
+
+/* -------------------------------------------------------------------------- */
+tieredcache::~tieredcache()
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper lLock(mMutex);
+  drop_blocks(0);
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+tieredcache::attach(fuse_req_t req, std::string& cookie, int flags)
+/* -------------------------------------------------------------------------- */
+{
+  if (!mLower) {
+    return 0;
+  }
+
+  XrdSysMutexHelper lLock(mMutex);
+  int rc = mLower->attach(req, cookie, flags);
+
+  if (rc == EKEYEXPIRED) {
+    // the disk cache has been truncated
+    drop_blocks(0);
+    return rc;
+  }
+
+  if (!rc) {
+    // drop blocks which are not backed anymore e.g. after a cache cleaning
+    size_t lsize = mLower->size();
+
+    for (auto it = mBlocks.begin(); it != mBlocks.end(); ++it) {
+      if ((it->first * kBlockSize + it->second.blk->size) > lsize) {
+        drop_blocks(it->first);
+        break;
+      }
+    }
+  }
+
+  return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+tieredcache::detach(std::string& cookie)
+/* -------------------------------------------------------------------------- */
+{
+  return mLower ? mLower->detach(cookie) : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+tieredcache::unlink()
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper lLock(mMutex);
+  drop_blocks(0);
+  return mLower ? mLower->unlink() : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+ssize_t
+/* -------------------------------------------------------------------------- */
+tieredcache::pread(void* buf, size_t count, off_t offset)
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper lLock(mMutex);
+  char* ptr = (char*) buf;
+  ssize_t bytesread = 0;
+
+  while (count) {
+    uint64_t index = offset / kBlockSize;
+    size_t boffset = offset % kBlockSize;
+    cacheclock::block* blk = get_block(index, true);
+
+    if (!blk) {
+      if (mLower) {
+        // no budget left, read the remaining part from the disk cache
+        ssize_t n = mLower->pread(ptr, count, offset);
+
+        if (n < 0) {
+          return bytesread ? bytesread : n;
+        }
+
+        bytesread += n;
+      }
+
+      break;
+    }
+
+    if (boffset >= blk->size) {
+      break;
+    }
+
+    size_t n = std::min(count, blk->size - boffset);
+    memcpy(ptr, blk->data.data() + boffset, n);
+    ptr += n;
+    offset += n;
+    count -= n;
+    bytesread += n;
+
+    if (blk->size < kBlockSize) {
+      // end of the cached data
+      break;
+    }
+  }
+
+  return bytesread;
+}
+
+/* -------------------------------------------------------------------------- */
+ssize_t
+/* -------------------------------------------------------------------------- */
+tieredcache::pwrite(const void* buf, size_t count, off_t offset)
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper lLock(mMutex);
+
+  if (mLower) {
+    // write-through, the disk cache stays complete
+    ssize_t n = mLower->pwrite(buf, count, offset);
+
+    if (n <= 0) {
+      return n;
+    }
+
+    const char* ptr = (const char*) buf;
+    size_t left = std::min((size_t) n, count);
+
+    while (left) {
+      uint64_t index = offset / kBlockSize;
+      size_t boffset = offset % kBlockSize;
+      size_t len = std::min(left, kBlockSize - boffset);
+      auto it = mBlocks.find(index);
+
+      if (it != mBlocks.end()) {
+        cacheclock::block* blk = it->second.blk.get();
+
+        if (boffset > blk->size) {
+          // the disk cache has a hole now, read the block again when needed
+          drop_block(it);
+        } else {
+          memcpy(blk->data.data() + boffset, ptr, len);
+          blk->size = std::max(blk->size, boffset + len);
+          blk->referenced = true;
+        }
+      }
+
+      ptr += len;
+      offset += len;
+      left -= len;
+    }
+
+    return n;
+  }
+
+  size_t fsize = contiguous_size();
+
+  if ((size_t) offset > fsize) {
+    // fill the hole like the memory cache does
+    if (!write_blocks(nullptr, offset - fsize, fsize)) {
+      return count;
+    }
+  }
+
+  // data not fitting into the budget is not written, the cache ends where the
+  // budget was exhausted
+  write_blocks((const char*) buf, count, offset);
+  return count;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+tieredcache::truncate(off_t offset)
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper lLock(mMutex);
+
+  if (mLower) {
+    int rc = mLower->truncate(offset);
+    // the block containing the new end is read again when needed
+    drop_blocks(offset / kBlockSize);
+    return rc;
+  }
+
+  size_t fsize = contiguous_size();
+
+  if ((size_t) offset > fsize) {
+    write_blocks(nullptr, offset - fsize, fsize);
+    return 0;
+  }
+
+  uint64_t index = offset / kBlockSize;
+  size_t boffset = offset % kBlockSize;
+
+  if (boffset) {
+    auto it = mBlocks.find(index);
+
+    if (it != mBlocks.end()) {
+      it->second.blk->size = std::min(it->second.blk->size, boffset);
+    }
+
+    index++;
+  }
+
+  drop_blocks(index);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+tieredcache::sync()
+/* -------------------------------------------------------------------------- */
+{
+  return mLower ? mLower->sync() : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+size_t
+/* -------------------------------------------------------------------------- */
+tieredcache::size()
+/* -------------------------------------------------------------------------- */
+{
+  if (mLower) {
+    return mLower->size();
+  }
+
+  XrdSysMutexHelper lLock(mMutex);
+  return contiguous_size();
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+tieredcache::set_attr(const std::string& key, const std::string& value)
+/* -------------------------------------------------------------------------- */
+{
+  if (mLower) {
+    return mLower->set_attr(key, value);
+  }
+
+  XrdSysMutexHelper lLock(xattrmtx);
+  xattr[key] = value;
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+tieredcache::attr(const std::string& key, std::string& value)
+/* -------------------------------------------------------------------------- */
+{
+  if (mLower) {
+    return mLower->attr(key, value);
+  }
+
+  XrdSysMutexHelper lLock(xattrmtx);
+
+  if (xattr.count(key)) {
+    value = xattr[key];
+    return 0;
+  }
+
+  errno = ENOATTR;
+  return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+tieredcache::rescue(std::string& location)
+/* -------------------------------------------------------------------------- */
+{
+  return mLower ? mLower->rescue(location) : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+tieredcache::recovery_location(std::string& location)
+/* -------------------------------------------------------------------------- */
+{
+  return mLower ? mLower->recovery_location(location) : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+cacheclock::block*
+/* -------------------------------------------------------------------------- */
+tieredcache::get_block(uint64_t index, bool load)
+/* -------------------------------------------------------------------------- */
+{
+  auto it = mBlocks.find(index);
+
+  if (it != mBlocks.end()) {
+    cacheclock::block* blk = it->second.blk.get();
+    blk->referenced = true;
+
+    if (load) {
+      clock().hit(blk->size);
+    }
+
+    return blk;
+  }
+
+  if (!load || !mLower) {
+    if (load) {
+      clock().miss(kBlockSize);
+    }
+
+    return nullptr;
+  }
+
+  cacheclock::block* blk = add_block(index);
+
+  if (!blk) {
+    clock().miss(kBlockSize);
+    return nullptr;
+  }
+
+  ssize_t n = mLower->pread(blk->data.data(), kBlockSize, index * kBlockSize);
+
+  if (n <= 0) {
+    drop_block(mBlocks.find(index));
+    return nullptr;
+  }
+
+  blk->size = n;
+  clock().miss(n);
+  return blk;
+}
+
+/* -------------------------------------------------------------------------- */
+cacheclock::block*
+/* -------------------------------------------------------------------------- */
+tieredcache::add_block(uint64_t index)
+/* -------------------------------------------------------------------------- */
+{
+  std::unique_ptr<cacheclock::block> blk(new cacheclock::block());
+  cacheclock::position pos;
+
+  if (!clock().reserve(this, index, blk.get(), pos)) {
+    return nullptr;
+  }
+
+  blk->data.resize(kBlockSize);
+  slot& s = mBlocks[index];
+  s.blk = std::move(blk);
+  s.pos = pos;
+  return s.blk.get();
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+tieredcache::drop_block(std::map<uint64_t, slot>::iterator it)
+/* -------------------------------------------------------------------------- */
+{
+  clock().release(it->second.pos);
+  mBlocks.erase(it);
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+tieredcache::drop_blocks(uint64_t from_index)
+/* -------------------------------------------------------------------------- */
+{
+  auto it = mBlocks.lower_bound(from_index);
+
+  while (it != mBlocks.end()) {
+    auto next = std::next(it);
+    drop_block(it);
+    it = next;
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+bool
+/* -------------------------------------------------------------------------- */
+tieredcache::write_blocks(const char* buf, size_t count, off_t offset)
+/* -------------------------------------------------------------------------- */
+{
+  while (count) {
+    uint64_t index = offset / kBlockSize;
+    size_t boffset = offset % kBlockSize;
+    size_t len = std::min(count, kBlockSize - boffset);
+    cacheclock::block* blk = get_block(index, false);
+
+    if (!blk) {
+      blk = add_block(index);
+    }
+
+    if (!blk) {
+      // budget exhausted, keep the cached data contiguous
+      drop_blocks(index);
+      return false;
+    }
+
+    if (boffset > blk->size) {
+      memset(blk->data.data() + blk->size, 0, boffset - blk->size);
+    }
+
+    if (buf) {
+      memcpy(blk->data.data() + boffset, buf, len);
+      buf += len;
+    } else {
+      memset(blk->data.data() + boffset, 0, len);
+    }
+
+    blk->size = std::max(blk->size, boffset + len);
+    offset += len;
+    count -= len;
+  }
+
+  return true;
+}
+
+/* -------------------------------------------------------------------------- */
+size_t
+/* -------------------------------------------------------------------------- */
+tieredcache::contiguous_size()
+/* -------------------------------------------------------------------------- */
+{
+  size_t csize = 0;
+  uint64_t index = 0;
+
+  for (auto it = mBlocks.begin(); it != mBlocks.end(); ++it, ++index) {
+    if (it->first != index) {
+      break;
+    }
+
+    csize += it->second.blk->size;
+
+    if (it->second.blk->size < kBlockSize) {
+      break;
+    }
+  }
+
+  return csize;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+tieredcache::evict(uint64_t index, std::vector<cacheclock::position>& dropped)
+/* -------------------------------------------------------------------------- */
+{
+  // the clock mutex is held, positions are removed from the clock by the caller
+  auto it = mLower ? mBlocks.find(index) : mBlocks.lower_bound(index);
+  auto end = mLower ? ((it == mBlocks.end()) ? it : std::next(it)) :
+             mBlocks.end();
+
+  for (auto i = it; i != end; ++i) {
+    dropped.push_back(i->second.pos);
+  }
+
+  mBlocks.erase(it, end);
+}
@@ -0,0 +1,248 @@
+//------------------------------------------------------------------------------
+//! @file tieredcache.hh
+//! @brief file start cache keeping hot blocks in a global memory budget
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef FUSE_TIEREDCACHE_HH_
+#define FUSE_TIEREDCACHE_HH_
+
+#include "cache.hh"
+#include "cacheconfig.hh"
+#include "XrdSys/XrdSysPthread.hh"
+#include <atomic>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Stat;
+class tieredcache;
+
+// ---------------------------------------------------------------------- //
+//! Class cacheclock - global memory budget of all tiered caches. Blocks of
+//! all inodes are kept on a single clock, a block referenced since the hand
+//! passed last gets a second chance, otherwise it is evicted.
+//!
+//! Lock order: a cache holding its own mutex may take the clock mutex, the
+//! clock only tries the mutex of other caches and skips them when busy.
+// ---------------------------------------------------------------------- //
+
+class cacheclock
+{
+public:
+
+  struct block {
+    block() : size(0), referenced(true) { }
+
+    std::vector<char> data; // block data with capacity of the block size
+    size_t size; // valid bytes in the block
+    std::atomic<bool> referenced; // set on every access
+  };
+
+  struct entry {
+    tieredcache* owner;
+    uint64_t index; // block index in the owner
+    block* blk;
+  };
+
+  typedef std::list<entry>::iterator position;
+
+  cacheclock();
+
+  virtual ~cacheclock() { }
+
+  // ---------------------------------------------------------------------- //
+  //! Configure the budget
+  //!
+  //! @param budget bytes available for blocks, 0 disables the budget
+  //! @param external memory used by buffers outside of the caches, the
+  //!        budget left for blocks shrinks by this amount
+  //! @param stat statistics receiving the hit/miss/eviction counters
+  // ---------------------------------------------------------------------- //
+  void configure(uint64_t budget, std::function<uint64_t()> external = nullptr,
+                 Stat* stat = nullptr);
+
+  // ---------------------------------------------------------------------- //
+  //! Account a new block of a cache, blocks are evicted to make room
+  //!
+  //! @param owner cache owning the block, its mutex has to be locked
+  //! @param index block index in the owner
+  //! @param blk the block
+  //! @param pos returned position of the block on the clock
+  //!
+  //! @return false if the budget does not allow for another block
+  // ---------------------------------------------------------------------- //
+  bool reserve(tieredcache* owner, uint64_t index, block* blk, position& pos);
+
+  // ---------------------------------------------------------------------- //
+  //! Release a block, the owner mutex has to be locked
+  // ---------------------------------------------------------------------- //
+  void release(position pos);
+
+  void hit(size_t bytes);
+  void miss(size_t bytes);
+
+  uint64_t budget() const
+  {
+    return mBudget;
+  }
+
+  uint64_t used() const
+  {
+    return mBytes.load();
+  }
+
+  uint64_t blocks() const
+  {
+    return mBlocks.load();
+  }
+
+  uint64_t evicted() const
+  {
+    return mEvicted.load();
+  }
+
+private:
+  XrdSysMutex mMutex;
+  std::list<entry> mRing;
+  position mHand;
+  uint64_t mBudget;
+  std::function<uint64_t()> mExternal;
+  Stat* mStat;
+  std::atomic<uint64_t> mBytes;
+  std::atomic<uint64_t> mBlocks;
+  std::atomic<uint64_t> mEvicted;
+
+  void erase(position pos);
+
+  // evict a block of a cache whose mutex is locked, returns the freed bytes
+  uint64_t evict(tieredcache* victim, uint64_t index);
+};
+
+// ---------------------------------------------------------------------- //
+//! Class tieredcache - file start cache whose blocks live in the global
+//! memory budget. With a disk cache as lower tier, writes go through to the
+//! disk cache and blocks evicted from memory are read back from disk. Without
+//! a lower tier the cache behaves like the memory cache, but evicted blocks
+//! are lost and reads end at the first missing block.
+// ---------------------------------------------------------------------- //
+
+class tieredcache : public cache
+{
+  friend class cacheclock;
+
+public:
+  static constexpr size_t kBlockSize = 128 * 1024;
+
+  tieredcache(fuse_ino_t _ino, cache* lower = nullptr);
+  virtual ~tieredcache();
+
+  // base class interface
+  virtual int attach(fuse_req_t req, std::string& cookie, int flags) override;
+  virtual int detach(std::string& cookie) override;
+  virtual int unlink() override;
+
+  virtual ssize_t pread(void* buf, size_t count, off_t offset) override;
+  virtual ssize_t pwrite(const void* buf, size_t count, off_t offset) override;
+
+  virtual int truncate(off_t) override;
+  virtual int sync() override;
+
+  virtual size_t size() override;
+
+  virtual int set_attr(const std::string& key, const std::string& value) override;
+  virtual int attr(const std::string& key, std::string& value) override;
+
+  virtual int rescue(std::string& location) override;
+
+  virtual int recovery_location(std::string& location) override;
+
+  virtual off_t prefetch_size() override
+  {
+    return mLower ? mLower->prefetch_size() : 0;
+  }
+
+  static int init(const cacheconfig& config,
+                  std::function<uint64_t()> external = nullptr,
+                  Stat* stat = nullptr);
+
+  static cacheclock& clock()
+  {
+    static cacheclock sClock;
+    return sClock;
+  }
+
+private:
+  struct slot {
+    std::unique_ptr<cacheclock::block> blk;
+    cacheclock::position pos;
+  };
+
+  XrdSysMutex mMutex;
+  fuse_ino_t ino;
+  std::unique_ptr<cache> mLower;
+  std::map<uint64_t, slot> mBlocks;
+  XrdSysMutex xattrmtx;
+  std::map<std::string, std::string> xattr;
+
+  // ---------------------------------------------------------------------- //
+  //! Get a block, loading it from the lower tier if needed
+  //!
+  //! @return nullptr if the block is neither in memory nor in the lower tier
+  // ---------------------------------------------------------------------- //
+  cacheclock::block* get_block(uint64_t index, bool load);
+
+  // ---------------------------------------------------------------------- //
+  //! Add an empty block if the budget allows it
+  // ---------------------------------------------------------------------- //
+  cacheclock::block* add_block(uint64_t index);
+
+  void drop_block(std::map<uint64_t, slot>::iterator it);
+
+  void drop_blocks(uint64_t from_index);
+
+  // ---------------------------------------------------------------------- //
+  //! Write into memory blocks of a cache without lower tier
+  //!
+  //! @param buf data to write, nullptr writes zeros
+  //!
+  //! @return false if the budget was exhausted, all blocks from there on are
+  //!         dropped
+  // ---------------------------------------------------------------------- //
+  bool write_blocks(const char* buf, size_t count, off_t offset);
+
+  // ---------------------------------------------------------------------- //
+  //! Size of the data cached contiguously from the start of the file
+  // ---------------------------------------------------------------------- //
+  size_t contiguous_size();
+
+  // ---------------------------------------------------------------------- //
+  //! Called by the clock with the mutex of this cache and of the clock
+  //! locked. Without lower tier all following blocks are dropped as well.
+  //!
+  //! @param dropped positions of the dropped blocks to remove from the clock
+  // ---------------------------------------------------------------------- //
+  void evict(uint64_t index, std::vector<cacheclock::position>& dropped);
+};
+
+#endif
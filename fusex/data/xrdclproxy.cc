@@ -75,6 +75,45 @@ XrdCl::Proxy::Read(uint64_t offset,
     return status;
   }
 
+  if (mPio) {
+    XrdSysMutexHelper lLock(mRainMutex);
+
+    if (mPio && !mRain) {
+      // the stripe servers are tried only once per file
+      mPio = false;
+
+      if (get_readahead_maximum_position() >= (off_t) RainReader::kMinSize) {
+        mRain.reset(new RainReader());
+        mRain->SetLogId(logId);
+        status = mRain->Open(mUrl, this, timeout);
+
+        if (status.IsOK()) {
+          mPio = true;
+        } else {
+          eos_debug("pio disabled msg=%s", status.ToString().c_str());
+          mRain.reset();
+          status = XRootDStatus();
+        }
+      }
+    }
+
+    if (mPio && mRain) {
+      status = mRain->Read(offset, size, buffer, bytesRead, timeout);
+
+      if (status.IsOK()) {
+        return status;
+      }
+
+      // fall back to the gateway which reconstructs the missing stripes
+      eos_warning("pio read failed - falling back to gateway msg=%s",
+                  status.ToString().c_str());
+      mPio = false;
+      mRain.reset();
+      bytesRead = 0;
+      status = XRootDStatus();
+    }
+  }
+
   eos_debug("----: read: offset=%lu size=%u", offset, size);
   int readahead_window_hit = 0;
   uint64_t current_offset = offset;
@@ -515,6 +554,7 @@ XrdCl::Proxy::CloseAsync(uint16_t timeout)
     return XRootDStatus();
   }
 
+  DropPio();
   WaitOpen();
   XrdSysCondVarHelper lLock(OpenCondVar());
 
@@ -606,6 +646,7 @@ XrdCl::Proxy::Close(uint16_t timeout)
     return XRootDStatus();
   }
 
+  DropPio();
   WaitOpen();
 
   if (IsOpen()) {
@@ -1024,6 +1065,44 @@ XrdCl::Proxy::WaitWrite(fuse_req_t req)
   return 0;
 }
 
+/* -------------------------------------------------------------------------- */
+XRootDStatus
+/* -------------------------------------------------------------------------- */
+XrdCl::Proxy::WaitWriteBytes(size_t max_bytes)
+/* -------------------------------------------------------------------------- */
+{
+  // this waits until the buffers of the writes in-flight fit into max_bytes
+  time_t wait_start = time(NULL);
+  XrdSysCondVarHelper lLock(WriteCondVar());
+
+  while (true) {
+    size_t inflight = 0;
+
+    for (auto it = ChunkMap().begin(); it != ChunkMap().end(); ++it) {
+      inflight += it->second->vbuffer().size();
+    }
+
+    if (inflight <= max_bytes) {
+      break;
+    }
+
+    if ((time(NULL) - wait_start) > sChunkTimeout) {
+      eos_err("timeout waiting for %lu bytes in-flight for writing", inflight);
+      return XRootDStatus(XrdCl::stFatal,
+                          suDone,
+                          XrdCl::errSocketTimeout,
+                          "request timeout"
+                         );
+    }
+
+    eos_debug("     [..] in-flight=%lu max=%lu", inflight, max_bytes);
+    // responses signal before they leave the chunk map, so poll
+    WriteCondVar().WaitMS(10);
+  }
+
+  return XRootDStatus();
+}
+
 /* -------------------------------------------------------------------------- */
 XRootDStatus
 /* -------------------------------------------------------------------------- */
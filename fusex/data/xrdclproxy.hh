@@ -32,6 +32,7 @@
 #include "llfusexx.hh"
 #include "common/Logging.hh"
 #include "common/Timing.hh"
+#include "data/rainreader.hh"
 #include <memory>
 #include <map>
 #include <string>
@@ -381,6 +382,9 @@ public:
   // ---------------------------------------------------------------------- //
   int WaitWrite(fuse_req_t); // waiting interrupts
 
+  // ---------------------------------------------------------------------- //
+  XRootDStatus WaitWriteBytes(size_t max_bytes); // waits until the buffers in-flight are <= max_bytes
+
   // ---------------------------------------------------------------------- //
   bool IsWaitWrite();
 
@@ -439,6 +443,35 @@ public:
     mAttached = proxy ? proxy->get_attached() : 1;
   }
 
+  void inherit_readahead(XrdCl::Proxy* proxy)
+  {
+    set_readahead_strategy(proxy->XReadAheadStrategy, proxy->XReadAheadMin,
+                           proxy->XReadAheadNom, proxy->XReadAheadMax,
+                           proxy->XReadAheadBlocksMax);
+  }
+
+  // ---------------------------------------------------------------------- //
+  //! Enable reading RAIN files directly from the stripe servers, it is tried
+  //! once at the first read for files of at least RainReader::kMinSize
+  // ---------------------------------------------------------------------- //
+
+  void set_pio(bool enable)
+  {
+    XrdSysMutexHelper lLock(mRainMutex);
+    mPio = enable;
+  }
+
+  // ---------------------------------------------------------------------- //
+  //! Stop reading from the stripe servers, the gateway is used from now on
+  // ---------------------------------------------------------------------- //
+
+  void DropPio()
+  {
+    XrdSysMutexHelper lLock(mRainMutex);
+    mPio = false;
+    mRain.reset();
+  }
+
   void inherit_writequeue(XrdCl::Proxy* proxy)
   {
     XWriteQueue = proxy->WriteQueue();
@@ -663,6 +696,7 @@ public:
     mRChunksInFlight.store(0, std::memory_order_seq_cst);
     mDeleted = false;
     mReadAheadMaximumPosition = 64 * 1024ll * 1024ll * 1024ll * 1024ll;
+    mPio = false;
   }
 
   void Collect()
@@ -698,6 +732,8 @@ public:
 
   void DropReadAhead()
   {
+    // stripes read directly could be stale as well
+    DropPio();
     WaitWrite();
     XrdSysCondVarHelper lLock(ReadCondVar());
 
@@ -1289,6 +1325,10 @@ private:
   fuse_req_t mReq;
   uint64_t mIno;
 
+  XrdSysMutex mRainMutex; // protects the stripe reader
+  bool mPio; // try to read a RAIN file from the stripe servers
+  std::unique_ptr<RainReader> mRain; // stripe reader in parallel IO mode
+
   std::string mUrl;
   OpenFlags::Flags mFlags;
   Access::Mode mMode;
@@ -42,6 +42,7 @@
 #include <algorithm>
 #include <thread>
 #include <iterator>
+#include <vector>
 #ifndef __APPLE__
 #include <malloc.h>
 #endif
@@ -84,6 +85,7 @@ extern "C" { /* this 'extern "C"' brace will eventually end up in the .h file, t
 #include "kv/kv.hh"
 #include "data/cache.hh"
 #include "data/cachehandler.hh"
+#include "data/tieredcache.hh"
 
 #if ( FUSE_USE_VERSION > 28 )
 #include "EosFuseSessionLoop.hh"
@@ -686,6 +688,22 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       root["options"]["rm-rf-bulk"] = 0;
     }
 
+    if (!root["options"].isMember("readdirplus")) {
+      root["options"]["readdirplus"] = 1;
+    }
+
+    if (!root["options"].isMember("rain-pio")) {
+      root["options"]["rain-pio"] = 0;
+    }
+
+    if (!root["options"].isMember("open-ahead")) {
+      root["options"]["open-ahead"] = 0;
+    }
+
+    if (!root["options"].isMember("md-warmstart")) {
+      root["options"]["md-warmstart"] = 0;
+    }
+
     if (!root["options"].isMember("write-size-flush-interval")) {
       root["options"]["write-size-flush-interval"] = 5;
     }
@@ -694,6 +712,10 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       root["options"]["submounts"] = 0;
     }
 
+    if (!root["options"].isMember("async-close")) {
+      root["options"]["async-close"] = 0;
+    }
+
     // xrdcl default options
     XrdCl::DefaultEnv::GetEnv()->PutInt("TimeoutResolution", 1);
     XrdCl::DefaultEnv::GetEnv()->PutInt("ConnectionWindow", 10);
@@ -820,9 +842,36 @@ EosFuse::run(int argc, char* argv[], void* userdata)
             root["options"]["rm-rf-protect-levels"].asInt();
     config.options.rm_rf_bulk =
             root["options"]["rm-rf-bulk"].asInt();
+    config.options.readdirplus = root["options"]["readdirplus"].asInt();
+    config.options.rain_pio = root["options"]["rain-pio"].asInt();
+    config.options.open_ahead = root["options"]["open-ahead"].asInt();
+    config.options.md_warmstart = root["options"]["md-warmstart"].asInt();
     config.options.show_tree_size = root["options"]["show-tree-size"].asInt();
     config.options.free_md_asap = root["options"]["free-md-asap"].asInt();
     config.options.cpu_core_affinity = root["options"]["cpu-core-affinity"].asInt();
+    config.options.fuse_queues = root["options"]["fuse-queues"].asInt();
+    config.options.fuse_queue_affinity =
+      root["options"]["fuse-queue-affinity"].asString();
+    config.options.fuse_splice = root["options"]["fuse-splice"].asInt();
+
+    if (config.options.fuse_queues < 0) {
+      // one channel per cpu
+      config.options.fuse_queues = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    if (config.options.fuse_queue_affinity.empty()) {
+      config.options.fuse_queue_affinity = "none";
+    }
+
+    if ((config.options.fuse_queue_affinity != "none") &&
+        (config.options.fuse_queue_affinity != "cpu") &&
+        (config.options.fuse_queue_affinity != "numa")) {
+      fprintf(stderr, "error: invalid option value fuse-queue-affinity=%s - "
+              "must be none, cpu or numa\n",
+              config.options.fuse_queue_affinity.c_str());
+      exit(EINVAL);
+    }
+
     config.options.no_xattr = root["options"]["no-xattr"].asInt();
     config.options.no_hardlinks = root["options"]["no-link"].asInt();
     config.options.write_size_flush_interval =
@@ -841,6 +890,7 @@ EosFuse::run(int argc, char* argv[], void* userdata)
     config.options.leasetime = root["options"]["leasetime"].asInt();
 
     config.options.submounts = root["options"]["submounts"].asInt();
+    config.options.async_close = root["options"]["async-close"].asInt();
 
     config.recovery.read = root["recovery"]["read"].asInt();
     config.recovery.read_open = root["recovery"]["read-open"].asInt();
@@ -888,6 +938,10 @@ EosFuse::run(int argc, char* argv[], void* userdata)
     config.auth.environ_deadlock_timeout =
             root["auth"]["environ-deadlock-timeout"].asInt();
     config.auth.forknoexec_heuristic = root["auth"]["forknoexec-heuristic"].asInt();
+    config.auth.session_cache_revalidation =
+            root["auth"]["session-cache-revalidation"].asUInt();
+    config.auth.connection_warmup = root["auth"]["connection-warmup"].asUInt();
+    config.auth.connection_pool = root["auth"]["connection-pool"].asUInt();
 
     if (config.auth.environ_deadlock_timeout <= 0) {
       config.auth.environ_deadlock_timeout = 500;
@@ -924,6 +978,13 @@ EosFuse::run(int argc, char* argv[], void* userdata)
 
 #endif
 
+    // the warm start needs the persistent meta data store
+    if (config.options.md_warmstart && config.mdcachedir.empty()) {
+      fprintf(stderr,
+              "warning: option md-warmstart requires mdcachedir - disabling warm start\n");
+      config.options.md_warmstart = 0;
+    }
+
     // disallow conflicting options
     if (!config.mdcachedir.empty() && (config.mdcacheport != 0 ||
                                        !config.mdcachehost.empty())) {
@@ -1069,6 +1130,14 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       root["cache"]["max-write-buffer"] = (Json::Value::UInt64)best_io_buffer_size;
     }
 
+    if (!root["cache"].isMember("max-write-buffer-per-file")) {
+      root["cache"]["max-write-buffer-per-file"] = 64 * 1024 * 1024;
+    }
+
+    if (!root["cache"].isMember("memory-mb")) {
+      root["cache"]["memory-mb"] = 0;
+    }
+
     cconfig.location = root["cache"]["location"].asString();
     cconfig.journal = root["cache"]["journal"].asString();
     cconfig.default_read_ahead_size =
@@ -1089,6 +1158,8 @@ EosFuse::run(int argc, char* argv[], void* userdata)
             root["cache"]["max-read-ahead-buffer"].asInt();
     cconfig.max_inflight_write_buffer_size =
             root["cache"]["max-write-buffer"].asInt();
+    cconfig.per_file_max_inflight_write_buffer_size =
+            root["cache"]["max-write-buffer-per-file"].asUInt64();
 
 
     // set defaults for journal and file-start cache
@@ -1218,6 +1289,7 @@ EosFuse::run(int argc, char* argv[], void* userdata)
     cconfig.per_file_journal_max_size =
             root["cache"]["file-journal-max-kb"].asUInt64() * 1024;
     cconfig.clean_threshold = root["cache"]["clean-threshold"].asDouble();
+    cconfig.memory_budget = root["cache"]["memory-mb"].asUInt64() * 1024 * 1024;
     int rc = 0;
 
     if ((rc = cachehandler::instance().init(cconfig))) {
@@ -1340,7 +1412,9 @@ EosFuse::run(int argc, char* argv[], void* userdata)
                 getpid(), -PRIO_MAX / 2);
       }
 
-      if (config.options.cpu_core_affinity > 0) {
+      // the threads of the fuse channels are spread over the cpus
+      if ((config.options.cpu_core_affinity > 0) &&
+          (config.options.fuse_queues <= 1)) {
         cpu_set_t cpuset;
         CPU_ZERO(&cpuset);
         CPU_SET(config.options.cpu_core_affinity - 1, &cpuset);
@@ -1511,6 +1585,14 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       exit(errno);
     }
 
+    if (cachehandler::instance().tiered()) {
+      // read-ahead and write buffers in-flight are taken from the memory budget
+      tieredcache::init(cconfig, []() -> uint64_t {
+        return XrdCl::Proxy::sWrBufferManager.inflight() +
+               XrdCl::Proxy::sRaBufferManager.inflight();
+      }, &fusestat);
+    }
+
     fusestat.Add("getattr", 0, 0, 0);
     fusestat.Add("setattr", 0, 0, 0);
     fusestat.Add("setattr:chown", 0, 0, 0);
@@ -1520,6 +1602,7 @@ EosFuse::run(int argc, char* argv[], void* userdata)
     fusestat.Add("lookup", 0, 0, 0);
     fusestat.Add("opendir", 0, 0, 0);
     fusestat.Add("readdir", 0, 0, 0);
+    fusestat.Add("readdirplus", 0, 0, 0);
     fusestat.Add("releasedir", 0, 0, 0);
     fusestat.Add("statfs", 0, 0, 0);
     fusestat.Add("mknod", 0, 0, 0);
@@ -1544,6 +1627,9 @@ EosFuse::run(int argc, char* argv[], void* userdata)
     fusestat.Add("readlink", 0, 0, 0);
     fusestat.Add("symlink", 0, 0, 0);
     fusestat.Add("link", 0, 0, 0);
+    fusestat.Add("cache:ram-hit", 0, 0, 0);
+    fusestat.Add("cache:ram-miss", 0, 0, 0);
+    fusestat.Add("cache:ram-evict", 0, 0, 0);
     fusestat.Add(__SUM__TOTAL__, 0, 0, 0);
     tDumpStatistic.reset(&EosFuse::DumpStatistic, this);
     tStatCirculate.reset(&EosFuse::StatCirculate, this);
@@ -1558,6 +1644,10 @@ EosFuse::run(int argc, char* argv[], void* userdata)
     eos_static_warning("eos-instance-url       := %s", config.hostport.c_str());
     eos_static_warning("thread-pool            := %s",
                        config.options.libfusethreads ? "libfuse" : "custom");
+    eos_static_warning("fuse-channels          := %d affinity=%s splice=%d",
+                       std::max(1, config.options.fuse_queues),
+                       config.options.fuse_queue_affinity.c_str(),
+                       config.options.fuse_splice);
     eos_static_warning("zmq-connection         := %s", config.mqtargethost.c_str());
     eos_static_warning("zmq-identity           := %s", config.mqidentity.c_str());
     eos_static_warning("fd-limit               := %lu", config.options.fdlimit);
@@ -1566,7 +1656,7 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       eos_static_warning("sss-keytabfile         := %s", config.ssskeytab.c_str());
     }
 
-    eos_static_warning("options                := backtrace=%d md-cache:%d md-enoent:%.02f md-timeout:%.02f md-put-timeout:%.02f data-cache:%d mkdir-sync:%d create-sync:%d symlink-sync:%d rename-sync:%d rmdir-sync:%d flush:%d flush-w-open:%d locking:%d no-fsync:%s ol-mode:%03o show-tree-size:%d free-md-asap:%d core-affinity:%d no-xattr:%d no-link:%d nocache-graceperiod:%d rm-rf-protect-level=%d rm-rf-bulk=%d t(lease)=%d t(size-flush)=%d submounts=%d",
+    eos_static_warning("options                := backtrace=%d md-cache:%d md-enoent:%.02f md-timeout:%.02f md-put-timeout:%.02f data-cache:%d mkdir-sync:%d create-sync:%d symlink-sync:%d rename-sync:%d rmdir-sync:%d flush:%d flush-w-open:%d locking:%d no-fsync:%s ol-mode:%03o show-tree-size:%d free-md-asap:%d core-affinity:%d no-xattr:%d no-link:%d nocache-graceperiod:%d rm-rf-protect-level=%d rm-rf-bulk=%d readdirplus=%d rain-pio=%d open-ahead=%d md-warmstart=%d t(lease)=%d t(size-flush)=%d submounts=%d async-close=%d",
                        config.options.enable_backtrace,
                        config.options.md_kernelcache,
                        config.options.md_kernelcache_enoent_timeout,
@@ -1591,22 +1681,29 @@ EosFuse::run(int argc, char* argv[], void* userdata)
                        config.options.nocache_graceperiod,
                        config.options.rm_rf_protect_levels,
                        config.options.rm_rf_bulk,
+                       config.options.readdirplus,
+                       config.options.rain_pio,
+                       config.options.open_ahead,
+                       config.options.md_warmstart,
                        config.options.leasetime,
                        config.options.write_size_flush_interval,
-                       config.options.submounts
+                       config.options.submounts,
+                       config.options.async_close
                        );
-    eos_static_warning("cache                  := rh-type:%s rh-nom:%d rh-max:%d rh-blocks:%d max-rh-buffer=%lu max-wr-buffer=%lu tot-size=%ld tot-ino=%ld dc-loc:%s jc-loc:%s clean-thrs:%02f%%%",
+    eos_static_warning("cache                  := rh-type:%s rh-nom:%d rh-max:%d rh-blocks:%d max-rh-buffer=%lu max-wr-buffer=%lu max-wr-buffer-file=%lu tot-size=%ld tot-ino=%ld dc-loc:%s jc-loc:%s clean-thrs:%02f%%% memory=%lu",
                        cconfig.read_ahead_strategy.c_str(),
                        cconfig.default_read_ahead_size,
                        cconfig.max_read_ahead_size,
                        cconfig.max_read_ahead_blocks,
                        cconfig.max_inflight_read_ahead_buffer_size,
                        cconfig.max_inflight_write_buffer_size,
+                       cconfig.per_file_max_inflight_write_buffer_size,
                        cconfig.total_file_cache_size,
                        cconfig.total_file_cache_inodes,
                        cconfig.location.c_str(),
                        cconfig.journal.c_str(),
-                       cconfig.clean_threshold);
+                       cconfig.clean_threshold,
+                       cconfig.memory_budget);
     eos_static_warning("read-recovery          := enabled:%d ropen:%d ropen-noserv:%d ropen-noserv-window:%u",
                        config.recovery.read,
                        config.recovery.read_open,
@@ -1664,7 +1761,18 @@ EosFuse::run(int argc, char* argv[], void* userdata)
           if (config.options.libfusethreads) {
             err = fuse_session_loop_mt(fusesession);
           } else {
-            EosFuseSessionLoop loop(10, 20, 10, 20);
+            EosFuseSessionLoop::Affinity affinity =
+              EosFuseSessionLoop::Affinity::kNone;
+
+            if (config.options.fuse_queue_affinity == "cpu") {
+              affinity = EosFuseSessionLoop::Affinity::kCpu;
+            } else if (config.options.fuse_queue_affinity == "numa") {
+              affinity = EosFuseSessionLoop::Affinity::kNuma;
+            }
+
+            EosFuseSessionLoop loop(10, 20, 10, 20,
+                                    std::max(1, config.options.fuse_queues),
+                                    affinity);
             err = loop.Loop(fusesession);
           }
 
@@ -1677,6 +1785,7 @@ EosFuse::run(int argc, char* argv[], void* userdata)
                        VERSION, FUSE_USE_VERSION);
     eos_static_warning("********************************************************************************");
     tDumpStatistic.join();
+    fusexrdlogin::stopConnectionWarmer();
     tStatCirculate.join();
     tMetaCacheFlush.join();
     tMetaSizeFlush.join();
@@ -1779,6 +1888,36 @@ EosFuse::init(void* userdata, struct fuse_conn_info* conn)
           FUSE_CAP_BIG_WRITES;
   conn->capable |= FUSE_CAP_EXPORT_SUPPORT | FUSE_CAP_POSIX_LOCKS |
           FUSE_CAP_BIG_WRITES;
+#ifdef FUSE_CAP_SPLICE_WRITE
+
+  // read replies are spliced into the fuse device instead of copied
+  if (EosFuse::instance().config.options.fuse_splice) {
+    if ((conn->capable & FUSE_CAP_SPLICE_WRITE) &&
+        (conn->capable & FUSE_CAP_SPLICE_MOVE)) {
+      conn->want |= FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE;
+    } else {
+      EosFuse::instance().config.options.fuse_splice = 0;
+    }
+  }
+
+#else
+  EosFuse::instance().config.options.fuse_splice = 0;
+#endif
+  // libfuse already asks for the largest sizes the kernel and the channel
+  // buffer allow
+  eos_static_warning("fuse-negotiated        := proto=%u.%u max-write=%u "
+                     "max-readahead=%u splice=%d",
+                     conn->proto_major, conn->proto_minor, conn->max_write,
+                     conn->max_readahead,
+                     EosFuse::instance().config.options.fuse_splice);
+#ifdef _FUSE3
+
+  // readdirplus is enabled by default by libfuse if the kernel supports it
+  if (!EosFuse::instance().config.options.readdirplus) {
+    conn->want &= ~(FUSE_CAP_READDIRPLUS | FUSE_CAP_READDIRPLUS_AUTO);
+  }
+
+#endif
 }
 
 void
@@ -1850,6 +1989,14 @@ EosFuse::DumpStatistic(ThreadAssistant& assistant)
     std::string s6;
     std::string s7;
     std::string s8;
+    std::string s9;
+    std::string s10;
+    ShardedCacheStats proccache;
+
+    if (fusexrdlogin::processCache) {
+      proccache = fusexrdlogin::processCache->getCacheStats();
+    }
+
     {
       std::lock_guard<std::mutex> lock(meminfo.mutex());
       snprintf(ino_stat, sizeof(ino_stat),
@@ -1867,6 +2014,22 @@ EosFuse::DumpStatistic(ThreadAssistant& assistant)
                "ALL        ra-nobuff           := %lu\n"
                "ALL        rd-buf-inflight     := %s\n"
                "ALL        rd-buf-queued       := %s\n"
+               "ALL        ram-cache-used      := %s\n"
+               "ALL        ram-cache-budget    := %s\n"
+               "ALL        ram-cache-evicted   := %lu\n"
+               "ALL        md-query-inflight   := %lu\n"
+               "ALL        md-query-coalesced  := %lu\n"
+               "ALL        session-id-hits     := %lu\n"
+               "ALL        session-id-misses   := %lu\n"
+               "ALL        session-id-revalid  := %lu\n"
+               "ALL        proc-cache-size     := %lu\n"
+               "ALL        proc-cache-hits     := %lu\n"
+               "ALL        proc-cache-misses   := %lu\n"
+               "ALL        proc-cache-evicted  := %lu\n"
+               "ALL        proc-cache-expired  := %lu\n"
+               "ALL        logins-warm         := %lu\n"
+               "ALL        logins-warmed       := %lu\n"
+               "ALL        logins-warm-failed  := %lu\n"
                "ALL        version             := %s\n"
                "ALL        fuseversion         := %d\n"
                "ALL        starttime           := %lu\n"
@@ -1907,6 +2070,30 @@ EosFuse::DumpStatistic(ThreadAssistant& assistant)
                                                                     data::datax::sBufferManager.inflight(), "b"),
                eos::common::StringConversion::GetReadableSizeString(s8,
                                                                     data::datax::sBufferManager.queued(), "b"),
+               eos::common::StringConversion::GetReadableSizeString(s9,
+                                                                    tieredcache::clock().used(), "b"),
+               eos::common::StringConversion::GetReadableSizeString(s10,
+                                                                    tieredcache::clock().budget(), "b"),
+               tieredcache::clock().evicted(),
+               mdbackend.inflight(),
+               mdbackend.coalesced(),
+               fusexrdlogin::processCache ?
+               fusexrdlogin::processCache->getSessionHits() : 0,
+               fusexrdlogin::processCache ?
+               fusexrdlogin::processCache->getSessionMisses() : 0,
+               fusexrdlogin::processCache ?
+               fusexrdlogin::processCache->getSessionRevalidations() : 0,
+               proccache.size,
+               proccache.hits,
+               proccache.misses,
+               proccache.evicted,
+               proccache.expired,
+               fusexrdlogin::connectionWarmer ?
+               fusexrdlogin::connectionWarmer->size() : 0,
+               fusexrdlogin::connectionWarmer ?
+               fusexrdlogin::connectionWarmer->getWarmed() : 0,
+               fusexrdlogin::connectionWarmer ?
+               fusexrdlogin::connectionWarmer->getFailed() : 0,
                VERSION,
                FUSE_USE_VERSION,
                start_time,
@@ -2133,7 +2320,7 @@ EosFuse::setattr(fuse_req_t req, fuse_ino_t ino, struct stat* attr, int op,
         if (S_ISDIR(md->mode())) {
           // if this is a directory we have to revoke a potential existing cap for that directory
           cap::shared_cap cap = Instance().caps.get(req, md->id());
-          cap->invalidate();
+          Instance().caps.invalidate(cap);
 
           if (Instance().mds.has_flush(ino)) {
             // we have also to wait for the upstream flush
@@ -2193,7 +2380,7 @@ EosFuse::setattr(fuse_req_t req, fuse_ino_t ino, struct stat* attr, int op,
         if (S_ISDIR(md->mode())) {
           // if this is a directory we have to revoke a potential existing cap for that directory
           cap::shared_cap cap = Instance().caps.get(req, md->id());
-          cap->invalidate();
+          Instance().caps.invalidate(cap);
 
           if (Instance().mds.has_flush(ino)) {
             // we have also to wait for the upstream flush
@@ -2565,11 +2752,28 @@ EosFuse::opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
     if (isRecursiveRm(req, true, true) &&
         Instance().Config().options.rm_rf_bulk) {
       md = Instance().mds.get(req, ino);
+      // bulk rm only when a recycle bin is configured, unless configured to
+      // delete trees without recycle bin (rm-rf-bulk=2)
+      bool bulk = md && (md->attr().count("sys.recycle") ||
+                         (Instance().Config().options.rm_rf_bulk > 1));
+
+      if (bulk && Instance().Config().options.rm_rf_protect_levels) {
+        // protected levels are refused below, never delete them upstream
+        XrdSysMutexHelper mLock(md->Locker());
+        bulk = (Instance().mds.calculateDepth(md) >
+                Instance().Config().options.rm_rf_protect_levels);
+      }
+
+      if (bulk) {
+        // and only if we may delete in this directory
+        cap::shared_cap dcap = Instance().caps.acquire(req, ino,
+                                                       S_IFDIR | D_OK, true);
+        bulk = !dcap->errc();
+      }
 
-      if (md && md->attr().count("sys.recycle")) {
+      if (bulk) {
         do_listdir = false;
         eos_static_warning("Running recursive rm (pid = %d)", fuse_req_ctx(req)->pid);
-        // bulk rm only when a recycle bin is configured
         {
           XrdSysMutexHelper mLock(md->Locker());
           name = md->name();
@@ -2607,6 +2811,15 @@ EosFuse::opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
             pino = pmd->id();
           }
 
+          // the tree is gone upstream, drop it locally in one go instead of
+          // letting rm unlink every entry
+          size_t nwiped = Instance().mds.wipe_subtree(req, md);
+
+          if (nwiped) {
+            eos_static_warning("rm-rf dropped %lu local entries below ino=%#lx",
+                               nwiped, ino);
+          }
+
           rc = 0;
           if (EOS_LOGS_DEBUG) {
             eos_static_debug("rm-rf returns 0");
@@ -2665,23 +2878,16 @@ EosFuse::opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
 }
 
 /* -------------------------------------------------------------------------- */
-void
+int
 /* -------------------------------------------------------------------------- */
-EosFuse::readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
-                 struct fuse_file_info* fi)
+EosFuse::readdir_common(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                        struct fuse_file_info* fi, bool plus)
 /* -------------------------------------------------------------------------- */
 /*
 EBADF  Invalid directory stream descriptor fi->fh
  */
 {
-  eos::common::Timing timing(__func__);
-  COMMONTIMING("_start_", &timing);
-  ADD_FUSE_STAT(__func__, req);
-
-  EXEC_TIMING_BEGIN(__func__);
-
   int rc = 0;
-  fuse_id id(req);
 
   if (!fi->fh) {
     fuse_reply_err(req, EBADF);
@@ -2749,6 +2955,34 @@ EBADF  Invalid directory stream descriptor fi->fh
     off_t in_off = off;
     off_t i_offset = 0;
     fuse_ino_t cino = pmd_id;
+    // readdirplus entries carry the child attributes, '.' and '..' are added
+    // without inode so that the kernel does not take a lookup reference
+    auto add_entry = [&](const std::string& name, struct stat& stbuf,
+                         struct fuse_entry_param* e, off_t next) -> size_t {
+#ifdef _FUSE3
+      if (plus) {
+        struct fuse_entry_param dot;
+
+        if (!e) {
+          memset(&dot, 0, sizeof(dot));
+          dot.attr = stbuf;
+          e = &dot;
+        }
+
+        return fuse_add_direntry_plus(req, b_ptr, size - b_size, name.c_str(), e,
+                                      next);
+      }
+#endif
+      return fuse_add_direntry(req, b_ptr, size - b_size, name.c_str(), &stbuf,
+                               next);
+    };
+    // attributes returned by readdirplus are valid as long as the directory cap
+    double lifetime = 0;
+
+    if (plus) {
+      cap::shared_cap pcap = Instance().caps.acquire(req, ino, R_OK);
+      lifetime = pcap->lifetime();
+    }
 
     // the root directory adds only '.', all other add '.' and '..' for off=0
     if (off == 0) {
@@ -2762,8 +2996,7 @@ EBADF  Invalid directory stream descriptor fi->fh
       memset(&stbuf, 0, sizeof(struct stat));
       stbuf.st_ino = cino;
       stbuf.st_mode = mode;
-      size_t a_size = fuse_add_direntry(req, b_ptr, size - b_size,
-                                        bname.c_str(), &stbuf, ++off);
+      size_t a_size = add_entry(bname, stbuf, nullptr, ++off);
       eos_static_info("name=%s ino=%08lx mode=%#lx bytes=%u/%u",
                       bname.c_str(), cino, mode, a_size, size - b_size);
       b_ptr += a_size;
@@ -2790,8 +3023,8 @@ EBADF  Invalid directory stream descriptor fi->fh
         memset(&stbuf, 0, sizeof(struct stat));
         stbuf.st_ino = cino;
         stbuf.st_mode = mode;
-        size_t a_size = fuse_add_direntry(req, b_ptr, size - b_size,
-                                          bname.c_str(), &stbuf, ++off); // the .. entry is not counted for the offset list
+        // the .. entry is not counted for the offset list
+        size_t a_size = add_entry(bname, stbuf, nullptr, ++off);
         eos_static_info("name=%s ino=%08lx mode=%#lx bytes=%u/%u",
                         bname.c_str(), cino, mode, a_size, size - b_size);
         b_ptr += a_size;
@@ -2880,8 +3113,15 @@ EBADF  Invalid directory stream descriptor fi->fh
           }
         }
         stbuf.st_mode = mode;
-        size_t a_size = fuse_add_direntry(req, b_ptr, size - b_size,
-                                          bname.c_str(), &stbuf, ++off);
+        struct fuse_entry_param e;
+
+        if (plus) {
+          memset(&e, 0, sizeof(e));
+          XrdSysMutexHelper cLock(cmd->Locker());
+          cmd->convert(e, lifetime);
+        }
+
+        size_t a_size = add_entry(bname, stbuf, plus ? &e : nullptr, ++off);
 
         // store latest offset
         md->next_offset = off - 1;
@@ -2896,6 +3136,11 @@ EBADF  Invalid directory stream descriptor fi->fh
           break;
         }
 
+        if (plus) {
+          // the kernel holds a lookup reference on every readdirplus entry
+          cmd->lookup_inc();
+        }
+
         // add to the shown list
         md->readdir_items.insert(it->first);
         b_ptr += a_size;
@@ -2909,16 +3154,53 @@ EBADF  Invalid directory stream descriptor fi->fh
       fuse_reply_buf(req, b, 0);
     }
 
-    eos_static_info("size=%lu off=%llu reply-size=%lu loop=%lu\n",
-                    size, off, b_size, loop);
+    eos_static_info("size=%lu off=%llu reply-size=%lu loop=%lu plus=%d\n",
+                    size, off, b_size, loop, plus);
   }
 
+  return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+EosFuse::readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                 struct fuse_file_info* fi)
+/* -------------------------------------------------------------------------- */
+{
+  eos::common::Timing timing(__func__);
+  COMMONTIMING("_start_", &timing);
+  ADD_FUSE_STAT(__func__, req);
+  EXEC_TIMING_BEGIN(__func__);
+  fuse_id id(req);
+  int rc = readdir_common(req, ino, size, off, fi, false);
   EXEC_TIMING_END(__func__);
   COMMONTIMING("_stop_", &timing);
   eos_static_notice("t(ms)=%.03f %s", timing.RealTime(),
                     dump(id, ino, 0, rc).c_str());
 }
 
+#ifdef _FUSE3
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+EosFuse::readdirplus(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                     struct fuse_file_info* fi)
+/* -------------------------------------------------------------------------- */
+{
+  eos::common::Timing timing(__func__);
+  COMMONTIMING("_start_", &timing);
+  ADD_FUSE_STAT(__func__, req);
+  EXEC_TIMING_BEGIN(__func__);
+  fuse_id id(req);
+  int rc = readdir_common(req, ino, size, off, fi, true);
+  EXEC_TIMING_END(__func__);
+  COMMONTIMING("_stop_", &timing);
+  eos_static_notice("t(ms)=%.03f %s", timing.RealTime(),
+                    dump(id, ino, 0, rc).c_str());
+}
+#endif
+
 /* -------------------------------------------------------------------------- */
 void
 /* -------------------------------------------------------------------------- */
@@ -3711,7 +3993,9 @@ EosFuse::open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
           std::string md_name = md->name();
           uint64_t md_ino = md->md_ino();
           uint64_t md_pino = md->md_pino();
+          fuse_ino_t md_pid = md->pid();
           std::string cookie = md->Cookie();
+          std::string kernel_cookie = md->kernel_cookie();
           capLock.UnLock();
           struct fuse_entry_param e;
           memset(&e, 0, sizeof(e));
@@ -3739,6 +4023,13 @@ EosFuse::open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
                                   req,
                                   (mode == U_OK));
           bool outdated = (io->ioctx()->attach(req, cookie, fi->flags) == EKEYEXPIRED);
+
+          if (kernel_cookie.length()) {
+            // the kernel has pages of this file, they stay valid as long as
+            // the data version did not change since they have been cached
+            outdated = (kernel_cookie != cookie);
+          }
+
           fi->keep_cache = outdated ? 0 : Instance().Config().options.data_kernelcache;
 
           if (md->creator()) {
@@ -3752,7 +4043,21 @@ EosFuse::open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
           }
 
           fi->direct_io = 0;
+
+          if (Instance().Config().options.data_kernelcache) {
+            // the kernel caches this version from now on
+            mLock.Lock(&md->Locker());
+            md->set_kernel_cookie(cookie);
+            mLock.UnLock();
+          }
+
           eos_static_info("%s data-cache=%d", md->dump(e).c_str(), fi->keep_cache);
+
+          if ((mode == R_OK) && (cap_ino == md_pid) &&
+              (Instance().Config().options.open_ahead > 0)) {
+            // readers of a directory tend to open its files in name order
+            OpenAhead(req, md_pid, md_name);
+          }
         }
       }
     }
@@ -3770,6 +4075,68 @@ EosFuse::open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
                     dump(id, ino, fi, rc).c_str());
 }
 
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+EosFuse::OpenAhead(fuse_req_t req, fuse_ino_t pino, const std::string& name)
+/* -------------------------------------------------------------------------- */
+{
+  std::vector<fuse_ino_t> candidates;
+  {
+    metad::shared_md pmd = Instance().mds.getlocal(req, pino);
+    XrdSysMutexHelper pLock(pmd->Locker());
+
+    if (pmd->err() || !pmd->id()) {
+      return;
+    }
+
+    auto& children = pmd->local_children();
+
+    for (auto it = children.upper_bound(name);
+         (it != children.end()) &&
+         (candidates.size() < (size_t) Instance().Config().options.open_ahead);
+         ++it) {
+      candidates.push_back(it->second);
+    }
+  }
+
+  for (auto ino : candidates) {
+    if (Instance().datas.has(ino)) {
+      // already open or opened ahead
+      continue;
+    }
+
+    metad::shared_md md = Instance().mds.getlocal(req, ino);
+    std::string md_name;
+    uint64_t md_ino = 0;
+    uint64_t md_pino = 0;
+    {
+      XrdSysMutexHelper mLock(md->Locker());
+
+      // files with their own ACL need their own cap, inlined files are
+      // served from the meta data without a remote open
+      if (md->err() || !md->id() || md->deleted() || !S_ISREG(md->mode()) ||
+          !md->size() || md->attr().count("user.acl") ||
+          md->attr().count(data::datax::kInlineAttribute)) {
+        continue;
+      }
+
+      md_name = md->name();
+      md_ino = md->md_ino();
+      md_pino = md->md_pino();
+    }
+
+    data::shared_data io = Instance().datas.get(req, ino, md);
+    io->set_remote(Instance().Config().hostport, md_name, md_ino, md_pino, req,
+                   false);
+    io->open_ahead(req);
+    // the data object stays unattached until a reader comes, the flusher
+    // drops it if nobody comes within the grace period
+    io->detach();
+    eos_static_debug("open-ahead ino=%#lx name=%s", ino, md_name.c_str());
+  }
+}
+
 /* -------------------------------------------------------------------------- */
 void
 /* -------------------------------------------------------------------------- */
@@ -4108,6 +4475,10 @@ EosFuse::read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
 
     if ((res = io->ioctx()->peek_pread(req, buf, size, off)) == -1) {
       rc = errno ? errno : EIO;
+    } else if (Instance().Config().options.fuse_splice) {
+      struct fuse_bufvec bufv = FUSE_BUFVEC_INIT(res);
+      bufv.buf[0].mem = buf;
+      fuse_reply_data(req, &bufv, FUSE_BUF_SPLICE_MOVE);
     } else {
       fuse_reply_buf(req, buf, res);
     }
@@ -4412,6 +4783,11 @@ EosFuse::flush(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
 
         std::string cookie = io->md->Cookie();
         io->ioctx()->store_cookie(cookie);
+
+        if (!invalidate_inode) {
+          // the written data went through the kernel page cache
+          io->md->set_kernel_cookie(cookie);
+        }
         pcap->Locker().Lock();
 
         if (!Instance().caps.has_quota(pcap, 0)) {
@@ -4970,7 +5346,7 @@ EosFuse::setxattr(fuse_req_t req, fuse_ino_t ino, const char* xattr_name,
             (*map)["user.acl"] = std::string(eosAcl);
 
             Instance().mds.update(req, md, pcap->authid());
-            pcap->invalidate();
+            Instance().caps.invalidate(pcap);
 
             if (Instance().mds.has_flush(ino)) {
               Instance().mds.wait_flush(req, md); // wait for upstream flush
@@ -5589,19 +5965,27 @@ EosFuse::setlk(fuse_req_t req, fuse_ino_t ino,
 
     if (io) {
       size_t w_ms = 10;
+      // when the MGM notifies the waiters of a released lock the back-off
+      // only covers lost notifications
+      size_t max_ms = Instance().mds.supports_locknotify() ? 5000 : 1000;
+
+      if (sleep) {
+        Instance().mds.begin_lockwait(ino);
+      }
 
       do {
-        // we currently implement the polling lock on client side due to the
+        // the blocking lock is retried on client side due to the
         // thread-per-link model of XRootD
+        uint64_t generation = sleep ? Instance().mds.lockwait_generation(ino) : 0;
         rc = Instance().mds.setlk(req, io->mdctx(), lock, sleep);
 
         if (rc && sleep) {
-          std::this_thread::sleep_for(std::chrono::milliseconds(w_ms));
-          // do exponential back-off with a hard limit at 1s
+          Instance().mds.wait_lockwait(ino, generation, w_ms);
+          // do exponential back-off with a hard limit
           w_ms *= 2;
 
-          if (w_ms > 1000) {
-            w_ms = 1000;
+          if (w_ms > max_ms) {
+            w_ms = max_ms;
           }
 
           continue;
@@ -5609,6 +5993,10 @@ EosFuse::setlk(fuse_req_t req, fuse_ino_t ino,
 
         break;
       } while (rc);
+
+      if (sleep) {
+        Instance().mds.end_lockwait(ino);
+      }
     } else {
       rc = ENXIO;
     }
@@ -53,7 +53,7 @@
 #include <google/dense_hash_map>
 
 // PROTOBUF protocol version announced via heartbeats and attached to URLs by the backend
-#define FUSEPROTOCOLVERSION eos::fusex::heartbeat::PROTOCOLV4
+#define FUSEPROTOCOLVERSION eos::fusex::heartbeat::PROTOCOLV5
 
 class EosFuse : public llfusexx::FuseBase<EosFuse>
 {
@@ -97,6 +97,19 @@ public:
   static void readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
                       struct fuse_file_info* fi);
 
+#ifdef _FUSE3
+  static void readdirplus(fuse_req_t req, fuse_ino_t ino, size_t size,
+                          off_t off, struct fuse_file_info* fi);
+#endif
+
+  //----------------------------------------------------------------------------
+  //! Fill and send a readdir reply, with the child attributes if plus is set
+  //!
+  //! @return errno of the reply
+  //----------------------------------------------------------------------------
+  static int readdir_common(fuse_req_t req, fuse_ino_t ino, size_t size,
+                            off_t off, struct fuse_file_info* fi, bool plus);
+
   static void releasedir(fuse_req_t req, fuse_ino_t ino,
                          struct fuse_file_info* fi);
 
@@ -251,9 +264,16 @@ public:
       uint64_t fdlimit;
       int rm_rf_protect_levels;
       int rm_rf_bulk;
+      int readdirplus;
+      int rain_pio;
+      int open_ahead;
+      int md_warmstart;
       int show_tree_size;
       int free_md_asap;
       int cpu_core_affinity;
+      int fuse_queues;
+      std::string fuse_queue_affinity;
+      int fuse_splice;
       mode_t overlay_mode;
       int no_xattr;
       int no_hardlinks;
@@ -261,6 +281,7 @@ public:
       int leasetime;
       int write_size_flush_interval;
       int submounts;
+      int async_close;
       std::vector<std::string> no_fsync_suffixes;
     } options_t;
 
@@ -402,6 +423,18 @@ private:
   static bool isRecursiveRm(fuse_req_t req, bool forced = false,
                             bool notverbose = false);
 
+  //----------------------------------------------------------------------------
+  //! Open the next regular files of a directory in read mode in background,
+  //! they are likely to be opened next by a process reading the directory
+  //! in name order
+  //!
+  //! @param req request of the open which triggers the open-ahead
+  //! @param pino parent directory
+  //! @param name name of the file just opened
+  //----------------------------------------------------------------------------
+  static void OpenAhead(fuse_req_t req, fuse_ino_t pino,
+                        const std::string& name);
+
   Track tracker;
 
   SubMount mounter;
@@ -121,6 +121,9 @@ protected:
     operations.opendir = &T::opendir;
     operations.access = &T::access;
     operations.readdir = &T::readdir;
+#ifdef _FUSE3
+    operations.readdirplus = &T::readdirplus;
+#endif
     operations.mkdir = &T::mkdir;
     operations.unlink = &T::unlink;
     operations.rmdir = &T::rmdir;
@@ -36,13 +36,14 @@
 #include <sstream>
 #include <vector>
 #include <thread>
+#include <chrono>
 #include <memory>
 #include <functional>
 #include <assert.h>
 #include <google/protobuf/util/json_util.h>
 
 /* -------------------------------------------------------------------------- */
-metad::metad() : mdflush(0), mdqueue_max_backlog(1000),
+metad::metad() : mdflush(0), lockwaitcond(0), mdqueue_max_backlog(1000),
   z_ctx(0), z_socket(0)
 {
   // make a mapping for inode 1, it is re-loaded afterwards in init '/'
@@ -80,14 +81,19 @@ metad::init(backend* _mdbackend)
   std::string mdstream;
   // load the root node
   fuse_req_t req = 0;
-  XrdSysMutexHelper mLock(mdmap);
-  update(req, mdmap[1], "", true);
+  shared_md root;
+  mdmap.retrieveOrCreateTS(1, root);
+  update(req, root, "", true);
   next_ino.init(EosFuse::Instance().getKV());
   dentrymessaging = false;
   writesizeflush = false;
   appname = false;
   mdquery = false;
+  mdsince = false;
+  mdbatch = false;
+  locknotify = false;
   serverversion = "<unkown>";
+  warmstart = EosFuse::Instance().Config().options.md_warmstart;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -184,7 +190,18 @@ metad::lookup(fuse_req_t req, fuse_ino_t parent, const char* name)
     }
 
     // --------------------------------------------------
-    // STEP 2: check if we hold a cap for that directory
+    // STEP 2: after a restart try the listing persisted in the local KV
+    // --------------------------------------------------
+    if (warmstart && (pmd->type() != pmd->MDLS) && !pmd->creator() &&
+        !pmd->local_children().count(
+          eos::common::StringConversion::EncodeInvalidUTF8(name))) {
+      pmd->Locker().UnLock();
+      warmlisting(req, pmd);
+      pmd->Locker().Lock();
+    }
+
+    // --------------------------------------------------
+    // STEP 3: check if we hold a cap for that directory
     // --------------------------------------------------
     if (pmd->cap_count()) {
       // --------------------------------------------------
@@ -603,6 +620,12 @@ metad::get(fuse_req_t req,
       return md;
     }
 
+    if (listing && warmstart && (md->type() != md->MDLS) &&
+        warmlisting(req, md, authid)) {
+      eos_static_info("returning warm-start listing entry");
+      return md;
+    }
+
     if (pmd && (pmd->cap_count() || pmd->creator()) && !pmd->needs_refresh()) {
       eos_static_info("returning cap entry");
       return md;
@@ -1296,6 +1319,70 @@ metad::rmrf(fuse_req_t req, shared_md md)
   return rc;
 }
 
+/* -------------------------------------------------------------------------- */
+size_t
+metad::wipe_subtree(fuse_req_t req, shared_md md)
+{
+  // called without any md lock, only one md object is locked at a time
+  std::vector<shared_md> dirs(1, md);
+  std::vector<std::pair<fuse_ino_t, std::string>> inval_entry_name;
+  size_t nwiped = 0;
+
+  while (dirs.size()) {
+    shared_md dmd = dirs.back();
+    dirs.pop_back();
+    std::map<std::string, uint64_t> children;
+    fuse_ino_t dino = 0;
+    {
+      XrdSysMutexHelper mLock(dmd->Locker());
+      children.swap(dmd->local_children());
+      dmd->local_enoent().clear();
+      dmd->get_todelete().clear();
+      dmd->set_nchildren(0);
+      dino = dmd->id();
+    }
+
+    for (auto it = children.begin(); it != children.end(); ++it) {
+      shared_md cmd;
+      inval_entry_name.push_back(std::make_pair(dino, it->first));
+
+      if (!mdmap.retrieveTS(it->second, cmd)) {
+        continue;
+      }
+
+      bool is_dir = false;
+      {
+        XrdSysMutexHelper cLock(cmd->Locker());
+
+        if (cmd->deleted()) {
+          continue;
+        }
+
+        // the kernel forgets the inode once its dentry is invalidated
+        cmd->setop_delete();
+        is_dir = S_ISDIR(cmd->mode());
+      }
+
+      if (is_dir) {
+        dirs.push_back(cmd);
+      } else {
+        EosFuse::Instance().datas.unlink(req, cmd->id());
+      }
+
+      unpersist(cmd->id());
+      nwiped++;
+    }
+  }
+
+  if (EosFuse::Instance().Config().options.md_kernelcache) {
+    for (auto it = inval_entry_name.begin(); it != inval_entry_name.end(); ++it) {
+      kernelcache::inval_entry(it->first, it->second);
+    }
+  }
+
+  return nwiped;
+}
+
 /* -------------------------------------------------------------------------- */
 std::string
 metad::dump_md(shared_md md, bool lock)
@@ -1552,6 +1639,67 @@ metad::setlk(fuse_req_t req, shared_md md, struct flock* lock, int sleep)
   return rc;
 }
 
+/* -------------------------------------------------------------------------- */
+void
+metad::begin_lockwait(fuse_ino_t ino)
+{
+  XrdSysCondVarHelper lLock(lockwaitcond);
+  lockwaits[ino].waiters++;
+}
+
+/* -------------------------------------------------------------------------- */
+uint64_t
+metad::lockwait_generation(fuse_ino_t ino)
+{
+  XrdSysCondVarHelper lLock(lockwaitcond);
+  return lockwaits[ino].generation;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+metad::wait_lockwait(fuse_ino_t ino, uint64_t generation, size_t ms)
+{
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(ms);
+  XrdSysCondVarHelper lLock(lockwaitcond);
+
+  while (lockwaits[ino].generation == generation) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>
+                (deadline - std::chrono::steady_clock::now()).count();
+
+    if (left <= 0) {
+      break;
+    }
+
+    lockwaitcond.WaitMS(left);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+metad::end_lockwait(fuse_ino_t ino)
+{
+  XrdSysCondVarHelper lLock(lockwaitcond);
+  auto it = lockwaits.find(ino);
+
+  if ((it != lockwaits.end()) && (--it->second.waiters == 0)) {
+    lockwaits.erase(it);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+metad::notify_lockwait(fuse_ino_t ino)
+{
+  XrdSysCondVarHelper lLock(lockwaitcond);
+  auto it = lockwaits.find(ino);
+
+  if (it != lockwaits.end()) {
+    it->second.generation++;
+    lockwaitcond.Broadcast();
+  }
+}
+
 /* -------------------------------------------------------------------------- */
 int
 metad::statvfs(fuse_req_t req, struct statvfs* svfs)
@@ -1742,11 +1890,11 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
     md->clear_refresh();
     eos_static_info("store local pino=%016lx for %016lx", md->pid(), md->id());
     inomap.insert(md_ino, ino);
+    persist(*md);
     md->Locker().UnLock();
 
     if (is_new) {
-      XrdSysMutexHelper mLock(mdmap);
-      mdmap[ino] = md;
+      mdmap.insertTS(ino, md);
       stat.inodes_inc();
       stat.inodes_ever_inc();
     }
@@ -1903,6 +2051,7 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
             eos_static_debug("%s", md->dump().c_str());
           }
 
+          persist(*md, cap_received.vtime());
           md->Locker().UnLock();
 
           if (!child) {
@@ -1961,6 +2110,7 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
         md->set_pid(p_ino);
         eos_static_info("store local pino=%016lx for %016lx", md->pid(), md->id());
         inomap.insert(map->first, new_ino);
+        persist(*md, cap_received.vtime());
         {
           mdmap.insertTS(new_ino, md);
           stat.inodes_inc();
@@ -2020,6 +2170,7 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
 
       // now flag as a complete listing
       pmd->set_type(pmd->MDLS);
+      persist(*pmd);
     }
 
     if (pmd) {
@@ -2034,23 +2185,191 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
   }
 }
 
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+metad::persist(mdx& md, uint64_t vtime)
+/* -------------------------------------------------------------------------- */
+{
+  // store a meta data record in the local KV to be reused after a restart,
+  // directories carry their local listing
+  if (!warmstart || !md.id() || !md.md_ino()) {
+    return;
+  }
+
+  eos::fusex::md record(md);
+  record.clear_children();
+  record.clear_capability();
+
+  for (auto it = md.local_children().begin(); it != md.local_children().end();
+       ++it) {
+    (*record.mutable_children())[it->first] = it->second;
+  }
+
+  // the record is known to be valid until now or until the cap expires
+  uint64_t now = time(NULL);
+  record.mutable_capability()->set_vtime((vtime > now) ? vtime : now);
+  std::string mdstream;
+  record.SerializeToString(&mdstream);
+
+  if (EosFuse::Instance().getKV()->put(md.id(), mdstream, "m")) {
+    eos_static_err("msg=\"failed to persist md\" ino=%#lx", md.id());
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+metad::unpersist(uint64_t ino)
+/* -------------------------------------------------------------------------- */
+{
+  if (warmstart) {
+    EosFuse::Instance().getKV()->erase(ino, "m");
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+bool
+/* -------------------------------------------------------------------------- */
+metad::warmload(uint64_t ino, eos::fusex::md& md)
+/* -------------------------------------------------------------------------- */
+{
+  std::string mdstream;
+
+  if (!warmstart || EosFuse::Instance().getKV()->get(ino, mdstream, "m") ||
+      !md.ParseFromString(mdstream)) {
+    return false;
+  }
+
+  // records which were not validated for too long are not used
+  if ((md.capability().vtime() + warmstart) < (uint64_t) time(NULL)) {
+    eos_static_debug("msg=\"persisted md expired\" ino=%#lx", ino);
+    return false;
+  }
+
+  return true;
+}
+
+/* -------------------------------------------------------------------------- */
+bool
+/* -------------------------------------------------------------------------- */
+metad::warmlisting(fuse_req_t req, shared_md pmd, std::string authid)
+/* -------------------------------------------------------------------------- */
+{
+  // revalidate a listing persisted before a restart with a single request
+  // returning only the children changed since the persisted directory clock,
+  // the unchanged children are restored from the local KV
+  if (!warmstart || !supports_mdsince()) {
+    return false;
+  }
+
+  uint64_t ino = 0;
+  uint64_t md_ino = 0;
+  {
+    XrdSysMutexHelper mLock(pmd->Locker());
+
+    if (pmd->set_warmed() || (pmd->type() == pmd->MDLS)) {
+      return false;
+    }
+
+    ino = pmd->id();
+    md_ino = pmd->md_ino();
+  }
+  eos::fusex::md record;
+
+  if (!ino || !md_ino || !warmload(ino, record) ||
+      (record.type() != record.MDLS) || (record.md_ino() != md_ino) ||
+      !record.clock()) {
+    return false;
+  }
+
+  std::vector<eos::fusex::container> contv;
+  int rc = mdbackend->getMD(req, md_ino, 0, contv, true, authid, record.clock());
+
+  if (rc) {
+    eos_static_info("msg=\"warm listing failed\" ino=%#lx rc=%d", ino, rc);
+    return false;
+  }
+
+  for (auto it = contv.begin(); it != contv.end(); ++it) {
+    if (it->ref_inode_()) {
+      apply(req, *it, true);
+    }
+  }
+
+  std::map<std::string, uint64_t> children;
+  {
+    XrdSysMutexHelper mLock(pmd->Locker());
+
+    if (pmd->type() != pmd->MDLS) {
+      return false;
+    }
+
+    children = pmd->local_children();
+  }
+  size_t n_restored = 0;
+
+  for (auto it = children.begin(); it != children.end(); ++it) {
+    shared_md md;
+
+    if (mdmap.retrieveTS(it->second, md)) {
+      // this one was sent as changed or is known already
+      continue;
+    }
+
+    eos::fusex::md crecord;
+    uint64_t c_md_ino = inomap.backward(it->second);
+
+    // a child with a newer clock than the directory should have been sent
+    if (!c_md_ino || !warmload(it->second, crecord) ||
+        (crecord.md_ino() != c_md_ino) || (crecord.clock() > record.clock())) {
+      continue;
+    }
+
+    if (!mdmap.retrieveOrCreateTS(it->second, md)) {
+      continue;
+    }
+
+    XrdSysMutexHelper mLock(md->Locker());
+    *md = crecord;
+    md->clear_children();
+    md->clear_capability();
+    md->set_type(md->MD);
+    md->set_id(it->second);
+    md->set_pid(ino);
+    stat.inodes_inc();
+    stat.inodes_ever_inc();
+    n_restored++;
+  }
+
+  eos_static_info("msg=\"warm listing\" ino=%#lx children=%lu restored=%lu",
+                  ino, children.size(), n_restored);
+  return true;
+}
+
 /* -------------------------------------------------------------------------- */
 void
 metad::mdcflush(ThreadAssistant& assistant)
 {
-  uint64_t lastflushid = 0;
+  std::vector<uint64_t> lastflushids;
+  // maximum number of records pushed with a single SETMANY request
+  static const size_t kMaxFlushBatch = 256;
 
   while (!assistant.terminationRequested()) {
     {
       mdflush.Lock();
 
-      if (mdqueue.count(lastflushid)) {
-        // remove entries from the mdqueue, if their ref count is 0
-        if (!mdqueue[lastflushid]) {
-          mdqueue.erase(lastflushid);
+      for (auto lastflushid : lastflushids) {
+        if (mdqueue.count(lastflushid)) {
+          // remove entries from the mdqueue, if their ref count is 0
+          if (!mdqueue[lastflushid]) {
+            mdqueue.erase(lastflushid);
+          }
         }
       }
 
+      lastflushids.clear();
+
       stat.inodes_backlog_store(mdqueue.size());
 
       while (mdqueue.size() == 0) {
@@ -2071,18 +2390,63 @@ metad::mdcflush(ThreadAssistant& assistant)
       std::string authid = it->authid();
       fuse_id f_id = it->get_fuse_id();
       mdx::md_op op = it->op();
-      lastflushid = ino;
+      lastflushids.push_back(ino);
       eos_static_info("metacache::flush ino=%#lx flushqueue-size=%u", ino,
                       mdflushqueue.size());
       eos_static_info("metacache::flush %s", flushentry::dump(*it).c_str());
+      std::vector<flushentry> batch;
+
+      if (((op == metad::mdx::ADD) || (op == metad::mdx::UPDATE)) &&
+          supports_mdbatch()) {
+        batch.push_back(*it);
+      }
+
       mdflushqueue.erase(it);
       mdqueue[ino]--;
+
+      if (batch.size()) {
+        // collect the following creations/updates of the same identity, an
+        // inode is pushed only once per batch to keep the order of its
+        // updates, local stores in between are taken along
+        std::set<uint64_t> inodes;
+        inodes.insert(ino);
+        size_t nremote = 1;
+
+        while (mdflushqueue.size() && (nremote < kMaxFlushBatch)) {
+          auto nit = mdflushqueue.begin();
+
+          if (nit->op() != metad::mdx::LSTORE) {
+            fuse_id n_id = nit->get_fuse_id();
+
+            if (((nit->op() != metad::mdx::ADD) &&
+                 (nit->op() != metad::mdx::UPDATE)) ||
+                (n_id.uid != f_id.uid) || (n_id.gid != f_id.gid) ||
+                (n_id.pid != f_id.pid) || inodes.count(nit->id())) {
+              break;
+            }
+
+            inodes.insert(nit->id());
+            nremote++;
+          }
+
+          batch.push_back(*nit);
+          lastflushids.push_back(nit->id());
+          mdqueue[nit->id()]--;
+          mdflushqueue.pop_front();
+        }
+      }
+
       mdflush.UnLock();
 
       if (assistant.terminationRequested()) {
         return;
       }
 
+      if (batch.size() > 1) {
+        flushbatch(batch);
+        continue;
+      }
+
       if (EOS_LOGS_DEBUG) {
         eos_static_debug("metacache::flush ino=%016lx authid=%s op=%d", ino,
                          authid.c_str(), (int) op);
@@ -2171,15 +2535,13 @@ metad::mdcflush(ThreadAssistant& assistant)
 
             if ((op == metad::mdx::ADD) || (op == metad::mdx::UPDATE) ||
                 (op == metad::mdx::LSTORE)) {
-              // TODO: local MD store is now disabled - delete this code
-              //! std::string mdstream;
-              //! md->SerializeToString(&mdstream);
-              //! EosFuse::Instance().getKV()->put(ino, mdstream);
+              persist(*md);
               md->Locker().UnLock();
             } else {
               md->Locker().UnLock();
 
               if (op == metad::mdx::RM) {
+                unpersist(ino);
                 // this step is coupled to the forget function, since we cannot
                 // forget an entry if we didn't process the outstanding KV changes
                 stat.inodes_deleted_dec();
@@ -2230,6 +2592,142 @@ metad::mdcflush(ThreadAssistant& assistant)
   }
 }
 
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+metad::flushbatch(std::vector<flushentry>& batch)
+/* -------------------------------------------------------------------------- */
+{
+  // records are sent in segments, a segment ends before a record whose
+  // remote parent inode is only assigned by the response to a record of the
+  // same segment, e.g. a file created in a directory created just before
+  fuse_id f_id = batch.front().get_fuse_id();
+  std::vector<shared_md> segment;
+  std::vector<eos::fusex::md> records;
+  std::set<uint64_t> lstores;
+  auto flushsegment = [&]() {
+    if (!segment.size()) {
+      return;
+    }
+
+    std::vector<eos::fusex::response> responses;
+    eos_static_info("metacache::flush backend::putMDs - start records=%lu",
+                    records.size());
+    int rc = mdbackend->putMDs(f_id, records, responses);
+
+    if (rc) {
+      eos_static_err("metacache::flush backend::putMDs failed rc=%d", rc);
+    }
+
+    for (size_t i = 0; i < segment.size(); ++i) {
+      shared_md md = segment[i];
+      XrdSysMutexHelper mdLock(md->Locker());
+      int mrc = rc;
+
+      if (!mrc && (responses[i].type() == responses[i].ACK)) {
+        if (responses[i].ack_().code() == responses[i].ack_().OK) {
+          md->set_md_ino(responses[i].ack_().md_ino());
+        } else {
+          eos_static_err("failed batched set for ino=%lx error='%s'", md->id(),
+                         responses[i].ack_().err_msg().c_str());
+          mrc = responses[i].ack_().err_no() ? (int) responses[i].ack_().err_no() :
+                EIO;
+        }
+      }
+
+      if (mrc) {
+        md->set_err(mrc);
+      } else {
+        inomap.insert(md->md_ino(), md->id());
+      }
+
+      if (md->getop() != md->RM) {
+        md->setop_none();
+        md->clear_mv_authid();
+      }
+
+      md->Signal();
+      persist(*md);
+    }
+
+    eos_static_info("metacache::flush backend::putMDs - stop");
+    segment.clear();
+    records.clear();
+  };
+
+  for (auto it = batch.begin(); it != batch.end(); ++it) {
+    uint64_t ino = it->id();
+
+    if (it->op() == metad::mdx::LSTORE) {
+      lstores.insert(ino);
+      continue;
+    }
+
+    shared_md md;
+
+    if (!mdmap.retrieveTS(ino, md)) {
+      eos_static_crit("metacache::flush failed to retrieve ino=%016lx", ino);
+      continue;
+    }
+
+    for (size_t retry = 0; retry < 2; ++retry) {
+      XrdSysMutexHelper mdLock(md->Locker());
+
+      if (!md->md_pino()) {
+        shared_md pmd;
+
+        if (mdmap.retrieveTS(md->pid(), pmd)) {
+          md->set_md_pino(pmd->md_ino());
+        }
+      }
+
+      if (!md->md_pino() && segment.size() && !retry) {
+        // the parent is created by the current segment
+        mdLock.UnLock();
+        flushsegment();
+        continue;
+      }
+
+      if (!md->md_pino()) {
+        eos_static_crit("metacache::flush ino=%016lx parent remote inode not known",
+                        (unsigned long long) ino);
+      }
+
+      if (!md->id() || md->deleted()) {
+        break;
+      }
+
+      md->set_operation(md->SET);
+
+      if (md->id() != 1) {
+        records.push_back(*md);
+        records.back().set_type(md->MD);
+        records.back().set_authid(it->authid());
+        md->clear_implied_authid();
+        segment.push_back(md);
+      } else {
+        persist(*md);
+      }
+
+      break;
+    }
+  }
+
+  flushsegment();
+
+  for (auto it = lstores.begin(); it != lstores.end(); ++it) {
+    shared_md md;
+
+    if (mdmap.retrieveTS(*it, md)) {
+      XrdSysMutexHelper mdLock(md->Locker());
+
+      if (!md->deleted()) {
+        persist(*md);
+      }
+    }
+  }
+}
+
 /* -------------------------------------------------------------------------- */
 void
 metad::mdsizeflush(ThreadAssistant& assistant)
@@ -2259,28 +2757,36 @@ metad::mdstackfree(ThreadAssistant& assistant)
     }
     // do this ~every 128 seconds
     if (!(cnt % 256)) {
-      XrdSysMutexHelper mLock(mdmap);
-
-      for (auto it = mdmap.begin(); it != mdmap.end();) {
-        // if the parent is gone, we can remove the child
-        if ((!mdmap.count(it->second->pid())) &&
-            (!S_ISDIR(it->second->mode()) || it->second->deleted())) {
-          eos_static_warning("removing orphaned inode from mdmap ino=%#lx path=%s",
-                             it->first, it->second->fullpath().c_str());
-          it = mdmap.erase(it);
-          stat.inodes_dec();
-        } else {
-          if (it->second->deleted()) {
-            if (!has_flush(it->first)) {
-              eos_static_warning("removing deleted inode from mdmap ino=%#lx path=%s",
-                                 it->first, it->second->fullpath().c_str());
-              it = mdmap.erase(it);
+      // go shard by shard to never block the whole inode table
+      for (size_t i = 0; i < pmap::kNumShards; ++i) {
+        std::vector<std::pair<uint64_t, shared_md>> entries;
+        mdmap.snapshotTS(i, entries);
+
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+          bool remove = false;
+
+          // if the parent is gone, we can remove the child
+          if ((!mdmap.countTS(it->second->pid())) &&
+              (!S_ISDIR(it->second->mode()) || it->second->deleted())) {
+            eos_static_warning("removing orphaned inode from mdmap ino=%#lx path=%s",
+                               it->first, it->second->fullpath().c_str());
+            remove = true;
+          } else if (it->second->deleted() && !has_flush(it->first)) {
+            eos_static_warning("removing deleted inode from mdmap ino=%#lx path=%s",
+                               it->first, it->second->fullpath().c_str());
+            remove = true;
+          }
+
+          if (remove) {
+            // only drop the entry if it was not replaced in the meantime
+            pmap::Shard& shard = mdmap.GetShard(it->first);
+            XrdSysMutexHelper mLock(shard.mMutex);
+            auto sit = shard.mMap.find(it->first);
+
+            if ((sit != shard.mMap.end()) && (sit->second == it->second)) {
+              shard.mMap.erase(sit);
               stat.inodes_dec();
-            } else {
-              it++;
             }
-          } else {
-            it++;
           }
         }
       }
@@ -2486,395 +2992,437 @@ metad::mdcommunicate(ThreadAssistant& assistant)
           } while (more);
 
           std::string s((const char*) zmq_msg_data(&message), zmq_msg_size(&message));
+          eos::fusex::response batch;
           rsp.Clear();
+          bool parsed = rsp.ParseFromString(s);
+          int nbatch = 1;
+
+          if (parsed && (rsp.type() == rsp.BATCH)) {
+            // events coalesced by the server into a single frame
+            batch.Swap(&rsp);
+            nbatch = batch.batch_size();
+          }
 
-          if (rsp.ParseFromString(s)) {
-            if (rsp.type() == rsp.EVICT) {
-              eos_static_crit("evict message from MD server - instruction: %s",
-                              rsp.evict_().reason().c_str());
-
-	      if (rsp.evict_().reason().find("setlog") != std::string::npos) {
-		if (rsp.evict_().reason().find("debug") != std::string::npos) {
-		  eos::common::Logging::GetInstance().SetLogPriority(LOG_DEBUG);
-		}
-		if (rsp.evict_().reason().find("info") != std::string::npos) {
-		  eos::common::Logging::GetInstance().SetLogPriority(LOG_INFO);
-		}
-		if (rsp.evict_().reason().find("error") != std::string::npos) {
-		  eos::common::Logging::GetInstance().SetLogPriority(LOG_ERR);
-		}
-		if (rsp.evict_().reason().find("notice") != std::string::npos) {
-		  eos::common::Logging::GetInstance().SetLogPriority(LOG_NOTICE); 
-		}
-		if (rsp.evict_().reason().find("warning") != std::string::npos) {
-		  eos::common::Logging::GetInstance().SetLogPriority(LOG_WARNING); 
-		}
-		if (rsp.evict_().reason().find("crit") != std::string::npos) {
-		  eos::common::Logging::GetInstance().SetLogPriority(LOG_CRIT); 
-		}
-	      } else  {
-		if (rsp.evict_().reason().find("stacktrace") != std::string::npos) {
-		  std::string stacktrace_file = EosFuse::Instance().Config().logfilepath;
-		  stacktrace_file += ".strace";
-		  eos::common::StackTrace::GdbTrace("/usr/bin/eosxd", getpid(), "thread apply all bt", stacktrace_file.c_str(), &stacktrace);
-		  hb.mutable_heartbeat_()->set_trace(stacktrace);
-		} else {
-		  if (rsp.evict_().reason().find("sendlog") != std::string::npos) {
-		    sendlog = "";
-		    int logtagindex = eos::common::Logging::GetInstance().GetPriorityByString("debug");
-		    for (int j = 0; j <= logtagindex; j++) {
-		      for (int i = 1; i <= 512; i++) {
-			std::string logline;
-			eos::common::Logging::GetInstance().gMutex.Lock();
-			const char* log = eos::common::Logging::GetInstance().gLogMemory[j][
-												(eos::common::Logging::GetInstance().gLogCircularIndex[j] - i +
-												 eos::common::Logging::GetInstance().gCircularIndexSize) %
-												eos::common::Logging::GetInstance().gCircularIndexSize].c_str();
-			if (log) {
-			  logline = log;
-			}
-
-			eos::common::Logging::GetInstance().gMutex.UnLock();
+          for (int ibatch = 0; ibatch < nbatch; ++ibatch) {
+            if (batch.batch_size()) {
+              rsp = batch.batch(ibatch);
+            }
+
+            if (parsed) {
+              if (rsp.type() == rsp.EVICT) {
+                eos_static_crit("evict message from MD server - instruction: %s",
+                                rsp.evict_().reason().c_str());
+
+  	      if (rsp.evict_().reason().find("setlog") != std::string::npos) {
+  		if (rsp.evict_().reason().find("debug") != std::string::npos) {
+  		  eos::common::Logging::GetInstance().SetLogPriority(LOG_DEBUG);
+  		}
+  		if (rsp.evict_().reason().find("info") != std::string::npos) {
+  		  eos::common::Logging::GetInstance().SetLogPriority(LOG_INFO);
+  		}
+  		if (rsp.evict_().reason().find("error") != std::string::npos) {
+  		  eos::common::Logging::GetInstance().SetLogPriority(LOG_ERR);
+  		}
+  		if (rsp.evict_().reason().find("notice") != std::string::npos) {
+  		  eos::common::Logging::GetInstance().SetLogPriority(LOG_NOTICE); 
+  		}
+  		if (rsp.evict_().reason().find("warning") != std::string::npos) {
+  		  eos::common::Logging::GetInstance().SetLogPriority(LOG_WARNING); 
+  		}
+  		if (rsp.evict_().reason().find("crit") != std::string::npos) {
+  		  eos::common::Logging::GetInstance().SetLogPriority(LOG_CRIT); 
+  		}
+  	      } else  {
+  		if (rsp.evict_().reason().find("stacktrace") != std::string::npos) {
+  		  std::string stacktrace_file = EosFuse::Instance().Config().logfilepath;
+  		  stacktrace_file += ".strace";
+  		  eos::common::StackTrace::GdbTrace("/usr/bin/eosxd", getpid(), "thread apply all bt", stacktrace_file.c_str(), &stacktrace);
+  		  hb.mutable_heartbeat_()->set_trace(stacktrace);
+  		} else {
+  		  if (rsp.evict_().reason().find("sendlog") != std::string::npos) {
+  		    sendlog = "";
+  		    int logtagindex = eos::common::Logging::GetInstance().GetPriorityByString("debug");
+  		    for (int j = 0; j <= logtagindex; j++) {
+  		      for (int i = 1; i <= 512; i++) {
+  			std::string logline;
+  			eos::common::Logging::GetInstance().gMutex.Lock();
+  			const char* log = eos::common::Logging::GetInstance().gLogMemory[j][
+  												(eos::common::Logging::GetInstance().gLogCircularIndex[j] - i +
+  												 eos::common::Logging::GetInstance().gCircularIndexSize) %
+  												eos::common::Logging::GetInstance().gCircularIndexSize].c_str();
+  			if (log) {
+  			  logline = log;
+  			}
+
+  			eos::common::Logging::GetInstance().gMutex.UnLock();
 			
-			if (logline.length()) {
-			  sendlog += logline;
-			  sendlog += "\n";
-			}
-		      }
-		    }
-		    hb.mutable_heartbeat_()->set_log(sendlog);
-		  } else {
-		    if (rsp.evict_().reason().find("log2big") != std::string::npos) {
-		      // we were asked to truncate our logfile
-		      EosFuse::Instance().truncateLogFile();
-		    } else {
-		      // suicide
-		      if (rsp.evict_().reason().find("abort") != std::string::npos) {
-			kill(getpid(), SIGABRT);
-		      } else {
-			kill(getpid(), SIGTERM);
-		      }
+  			if (logline.length()) {
+  			  sendlog += logline;
+  			  sendlog += "\n";
+  			}
+  		      }
+  		    }
+  		    hb.mutable_heartbeat_()->set_log(sendlog);
+  		  } else {
+  		    if (rsp.evict_().reason().find("log2big") != std::string::npos) {
+  		      // we were asked to truncate our logfile
+  		      EosFuse::Instance().truncateLogFile();
+  		    } else {
+  		      // suicide
+  		      if (rsp.evict_().reason().find("abort") != std::string::npos) {
+  			kill(getpid(), SIGABRT);
+  		      } else {
+  			kill(getpid(), SIGTERM);
+  		      }
 		      
-		      pause();
-		    }
-		  }
-		}
-	      }
-            }
+  		      pause();
+  		    }
+  		  }
+  		}
+  	      }
+              }
 
-            if (rsp.type() == rsp.DROPCAPS) {
-              eos_static_notice("MGM asked us to drop all known caps");
-              // a newly started MGM requests this as a response to the first heartbeat
-              EosFuse::Instance().caps.reset();
-            }
+              if (rsp.type() == rsp.DROPCAPS) {
+                eos_static_notice("MGM asked us to drop all known caps");
+                // a newly started MGM requests this as a response to the first heartbeat
+                EosFuse::Instance().caps.reset();
+              }
 
-            if (rsp.type() == rsp.CONFIG) {
-              if (rsp.config_().hbrate()) {
-                eos_static_warning("MGM asked us to set our heartbeat interval to %d seconds, %s dentry-messaging, %s writesizeflush, %s appname, %s mdquery and server-version=%s",
-                                  rsp.config_().hbrate(),
-                                  rsp.config_().dentrymessaging() ? "enable" : "disable",
-                                  rsp.config_().writesizeflush() ?  "enable" : "disable",
-                                  rsp.config_().appname() ? "accepts" : "rejects",
-				  rsp.config_().mdquery() ? "accepts" : "rejects", 
-                                  rsp.config_().serverversion().c_str());
-                interval = (int) rsp.config_().hbrate();
-                XrdSysMutexHelper cLock(EosFuse::Instance().mds.ConfigMutex);
-                EosFuse::Instance().mds.dentrymessaging = rsp.config_().dentrymessaging();
-                EosFuse::Instance().mds.writesizeflush = rsp.config_().writesizeflush();
-                EosFuse::Instance().mds.appname = rsp.config_().appname();
-		EosFuse::Instance().mds.mdquery = rsp.config_().mdquery();
-                if (rsp.config_().serverversion().length()) {
-                  EosFuse::Instance().mds.serverversion = rsp.config_().serverversion();
+              if (rsp.type() == rsp.CONFIG) {
+                if (rsp.config_().hbrate()) {
+                  eos_static_warning("MGM asked us to set our heartbeat interval to %d seconds, %s dentry-messaging, %s writesizeflush, %s appname, %s mdquery, %s mdsince, %s mdbatch and server-version=%s",
+                                    rsp.config_().hbrate(),
+                                    rsp.config_().dentrymessaging() ? "enable" : "disable",
+                                    rsp.config_().writesizeflush() ?  "enable" : "disable",
+                                    rsp.config_().appname() ? "accepts" : "rejects",
+  				  rsp.config_().mdquery() ? "accepts" : "rejects", 
+                                    rsp.config_().mdsince() ? "accepts" : "rejects",
+                                    rsp.config_().mdbatch() ? "accepts" : "rejects",
+                                    rsp.config_().serverversion().c_str());
+                  interval = (int) rsp.config_().hbrate();
+                  XrdSysMutexHelper cLock(EosFuse::Instance().mds.ConfigMutex);
+                  EosFuse::Instance().mds.dentrymessaging = rsp.config_().dentrymessaging();
+                  EosFuse::Instance().mds.writesizeflush = rsp.config_().writesizeflush();
+                  EosFuse::Instance().mds.appname = rsp.config_().appname();
+  		EosFuse::Instance().mds.mdquery = rsp.config_().mdquery();
+                  EosFuse::Instance().mds.mdsince = rsp.config_().mdsince();
+                  EosFuse::Instance().mds.mdbatch = rsp.config_().mdbatch();
+                  EosFuse::Instance().mds.locknotify = rsp.config_().locknotify();
+                  if (rsp.config_().serverversion().length()) {
+                    EosFuse::Instance().mds.serverversion = rsp.config_().serverversion();
+                  }
                 }
               }
-            }
 
-            if (rsp.type() == rsp.DENTRY) {
-              uint64_t md_ino = rsp.dentry_().md_ino();
-              std::string authid = rsp.dentry_().authid();
-              std::string name = rsp.dentry_().name();
-              uint64_t ino = inomap.forward(md_ino);
+              if (rsp.type() == rsp.DENTRY) {
+                uint64_t md_ino = rsp.dentry_().md_ino();
+                std::string authid = rsp.dentry_().authid();
+                std::string name = rsp.dentry_().name();
+                uint64_t ino = inomap.forward(md_ino);
 
-              if (rsp.dentry_().type() == rsp.dentry_().ADD) {
-              } else if (rsp.dentry_().type() == rsp.dentry_().REMOVE) {
-                eos_static_notice("remove-dentry: remote-ino=%#lx ino=%#lx clientid=%s authid=%s name=%s",
-                                  md_ino, ino, rsp.lease_().clientid().c_str(), authid.c_str(), name.c_str());
+                if (rsp.dentry_().type() == rsp.dentry_().ADD) {
+                } else if (rsp.dentry_().type() == rsp.dentry_().REMOVE) {
+                  eos_static_notice("remove-dentry: remote-ino=%#lx ino=%#lx clientid=%s authid=%s name=%s",
+                                    md_ino, ino, rsp.lease_().clientid().c_str(), authid.c_str(), name.c_str());
 
-                // remove directory entry
-                if (EosFuse::Instance().Config().options.md_kernelcache) {
-                  kernelcache::inval_entry(ino, name);
-                }
+                  // remove directory entry
+                  if (EosFuse::Instance().Config().options.md_kernelcache) {
+                    kernelcache::inval_entry(ino, name);
+                  }
 
-                shared_md pmd;
+                  shared_md pmd;
 
-                if (ino && mdmap.retrieveTS(ino, pmd)) {
-                  XrdSysMutexHelper mLock(pmd->Locker());
+                  if (ino && mdmap.retrieveTS(ino, pmd)) {
+                    XrdSysMutexHelper mLock(pmd->Locker());
 
-                  if (pmd->local_children().count(
-                        eos::common::StringConversion::EncodeInvalidUTF8(name))) {
-                    pmd->local_children().erase(eos::common::StringConversion::EncodeInvalidUTF8(
+                    if (pmd->local_children().count(
+                          eos::common::StringConversion::EncodeInvalidUTF8(name))) {
+                      pmd->local_children().erase(eos::common::StringConversion::EncodeInvalidUTF8(
+                                                    name));
+                      pmd->get_todelete().erase(eos::common::StringConversion::EncodeInvalidUTF8(
                                                   name));
-                    pmd->get_todelete().erase(eos::common::StringConversion::EncodeInvalidUTF8(
-                                                name));
-                    pmd->set_nchildren(pmd->nchildren() - 1);
+                      pmd->set_nchildren(pmd->nchildren() - 1);
+                    }
                   }
                 }
               }
-            }
 
-            if (rsp.type() == rsp.REFRESH) {
-              uint64_t md_ino = rsp.refresh_().md_ino();
-              uint64_t ino = inomap.forward(md_ino);
-              mode_t mode = 0;
-              eos_static_notice("refresh-dentry: remote-ino=%#lx ino=%#lx",
-                                md_ino, ino);
-              shared_md md;
+              if (rsp.type() == rsp.LOCK) {
+                // a lock we wait for was released, retry right away
+                uint64_t md_ino = rsp.lock_().md_ino();
+                uint64_t ino = inomap.forward(md_ino);
+                eos_static_info("lock-release: remote-ino=%#lx ino=%#lx", md_ino, ino);
 
-              // force meta data refresh
-              if (ino && mdmap.retrieveTS(ino, md)) {
-                XrdSysMutexHelper mLock(md->Locker());
-                md->force_refresh();
-                mode = md->mode();
-              }
-
-              if (EOS_LOGS_DEBUG) {
-                eos_static_debug("%s", dump_md(md).c_str());
+                if (ino) {
+                  notify_lockwait(ino);
+                }
               }
 
-              if (EosFuse::Instance().Config().options.md_kernelcache) {
-                eos_static_info("invalidate metadata cache for ino=%#lx", ino);
-                kernelcache::inval_inode(ino, S_ISDIR(mode) ? false : true);
-              }
-            }
-
-            if (rsp.type() == rsp.LEASE) {
-              uint64_t md_ino = rsp.lease_().md_ino();
-              std::string authid = rsp.lease_().authid();
-              uint64_t ino = inomap.forward(md_ino);
-              eos_static_notice("lease: remote-ino=%#lx ino=%#lx clientid=%s authid=%s",
-                                md_ino, ino, rsp.lease_().clientid().c_str(), authid.c_str());
-              shared_md check_md;
-
-              if (ino && mdmap.retrieveTS(ino, check_md)) {
-                std::string capid = cap::capx::capid(ino, rsp.lease_().clientid());
-
-                // wait that the inode is flushed out of the mdqueue
-                do {
-                  mdflush.Lock();
-
-                  if (mdqueue.count(ino)) {
-                    mdflush.UnLock();
-                    eos_static_info("lease: delaying cap-release remote-ino=%#lx ino=%#lx clientid=%s authid=%s",
-                                    md_ino, ino, rsp.lease_().clientid().c_str(), authid.c_str());
-                    std::this_thread::sleep_for(std::chrono::milliseconds(25));
-
-                    if (assistant.terminationRequested()) {
-                      return;
-                    }
-                  } else {
-                    mdflush.UnLock();
-                    break;
-                  }
-                } while (1);
-
-                eos_static_debug("");
-                fuse_ino_t ino = EosFuse::Instance().getCap().forget(capid);
+              if (rsp.type() == rsp.REFRESH) {
+                uint64_t md_ino = rsp.refresh_().md_ino();
+                uint64_t ino = inomap.forward(md_ino);
+                mode_t mode = 0;
+                eos_static_notice("refresh-dentry: remote-ino=%#lx ino=%#lx",
+                                  md_ino, ino);
                 shared_md md;
 
-                if (mdmap.retrieveTS(ino, md)) {
-                  md->Locker().Lock();
+                // force meta data refresh
+                if (ino && mdmap.retrieveTS(ino, md)) {
+                  XrdSysMutexHelper mLock(md->Locker());
+                  md->force_refresh();
+                  mode = md->mode();
                 }
 
-                // invalidate children
-                if (md && md->id()) {
-                  // force an update of the metadata with next access
-                  eos_static_info("md=%16x", md->id());
-                  cleanup(md);
-
-                  if (EOS_LOGS_DEBUG) {
-                    eos_static_debug("%s", dump_md(md).c_str());
-                  }
+                if (EOS_LOGS_DEBUG) {
+                  eos_static_debug("%s", dump_md(md).c_str());
                 }
-              } else {
-                // there might have been several caps and the first has wiped already the MD,
-                // still we want to remove the cap entry
-                std::string capid = cap::capx::capid(ino, rsp.lease_().clientid());
-                eos_static_debug("");
-                EosFuse::Instance().getCap().forget(capid);
-              }
-            }
 
-            if (rsp.type() == rsp.CAP) {
-              std::string clientid = rsp.cap_().clientid();
-              uint64_t ino = inomap.forward(rsp.cap_().id());
-              cap::shared_cap cap = EosFuse::Instance().caps.get(ino, clientid);
-              eos_static_notice("cap-update: cap-id=%#lx %s", rsp.cap_().id(),
-                                cap->dump().c_str());
-
-              if (cap->id()) {
-                EosFuse::Instance().caps.update_quota(cap, rsp.cap_()._quota());
-                eos_static_notice("cap-update: cap-id=%#lx %s", rsp.cap_().id(),
-                                  cap->dump().c_str());
+                if (EosFuse::Instance().Config().options.md_kernelcache) {
+                  eos_static_info("invalidate metadata cache for ino=%#lx", ino);
+                  kernelcache::inval_inode(ino, S_ISDIR(mode) ? false : true);
+                }
               }
-            }
 
-            if (rsp.type() == rsp.MD) {
-              fuse_req_t req;
-              memset(&req, 0, sizeof(fuse_req_t));
-              uint64_t md_ino = rsp.md_().md_ino();
-              std::string authid = rsp.md_().authid();
-              uint64_t ino = inomap.forward(md_ino);
-              eos_static_notice("md-update: remote-ino=%#lx ino=%#lx authid=%s",
-                                md_ino, ino, authid.c_str());
-              // we get this when a file update/flush appeared
-              shared_md md;
-              int64_t bookingsize = 0;
-              uint64_t pino = 0;
-              mode_t mode = 0;
-              std::string md_clientid;
-              std::string old_name;
-
-              // MD update logic
-              if (ino) {
-                eos_static_notice("md-update: (existing) remote-ino=%#lx ino=%#lx authid=%s",
-                                  md_ino, ino, authid.c_str());
-                mdmap.retrieveOrCreateTS(ino, md);
+              if (rsp.type() == rsp.LEASE) {
+                uint64_t md_ino = rsp.lease_().md_ino();
+                std::string authid = rsp.lease_().authid();
+                uint64_t ino = inomap.forward(md_ino);
+                eos_static_notice("lease: remote-ino=%#lx ino=%#lx clientid=%s authid=%s",
+                                  md_ino, ino, rsp.lease_().clientid().c_str(), authid.c_str());
+                shared_md check_md;
+
+                if (ino && mdmap.retrieveTS(ino, check_md)) {
+                  std::string capid = cap::capx::capid(ino, rsp.lease_().clientid());
+
+                  // wait that the inode is flushed out of the mdqueue
+                  do {
+                    mdflush.Lock();
+
+                    if (mdqueue.count(ino)) {
+                      mdflush.UnLock();
+                      eos_static_info("lease: delaying cap-release remote-ino=%#lx ino=%#lx clientid=%s authid=%s",
+                                      md_ino, ino, rsp.lease_().clientid().c_str(), authid.c_str());
+                      std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+                      if (assistant.terminationRequested()) {
+                        return;
+                      }
+                    } else {
+                      mdflush.UnLock();
+                      break;
+                    }
+                  } while (1);
 
-                // updated file MD
-                if (EOS_LOGS_DEBUG) {
-                  eos_static_debug("%s op=%d", md->dump().c_str(), md->getop());
-                }
+                  eos_static_debug("");
+                  fuse_ino_t ino = EosFuse::Instance().getCap().forget(capid);
+                  shared_md md;
 
-                md->Locker().Lock();
-                bookingsize = rsp.md_().size() - md->size();
-                md_clientid = rsp.md_().clientid();
-                eos_static_info("md-update: %s %s", md->name().c_str(),
-                                  rsp.md_().name().c_str());
+                  if (mdmap.retrieveTS(ino, md)) {
+                    md->Locker().Lock();
+                  }
 
-                // check if this implies a rename
-                if (md->name() != rsp.md_().name()) {
-                  old_name = rsp.md_().name();
-                }
+                  // invalidate children
+                  if (md && md->id()) {
+                    // force an update of the metadata with next access
+                    eos_static_info("md=%16x", md->id());
+                    cleanup(md);
 
-                // verify that this record is newer than
-                if (rsp.md_().clock() >= md->clock()) {
-                  eos_static_info("overwriting clock MD %#lx => %#lx", md->clock(),
-                                  rsp.md_().clock());
-                  *md = rsp.md_();
-                  md->set_creator(false);
-                  md->set_bc_time(time(NULL));
+                    if (EOS_LOGS_DEBUG) {
+                      eos_static_debug("%s", dump_md(md).c_str());
+                    }
+                  }
                 } else {
-                  eos_static_warning("keeping clock MD %#lx => %#lx", md->clock(),
-                                     rsp.md_().clock());
+                  // there might have been several caps and the first has wiped already the MD,
+                  // still we want to remove the cap entry
+                  std::string capid = cap::capx::capid(ino, rsp.lease_().clientid());
+                  eos_static_debug("");
+                  EosFuse::Instance().getCap().forget(capid);
                 }
+              }
 
-                md->clear_clientid();
-                pino = inomap.forward(md->md_pino());
-                md->set_id(ino);
-                md->set_pid(pino);
-                mode = md->mode();
+              if (rsp.type() == rsp.CAP) {
+                std::string clientid = rsp.cap_().clientid();
+                uint64_t ino = inomap.forward(rsp.cap_().id());
+                cap::shared_cap cap = EosFuse::Instance().caps.get(ino, clientid);
+                eos_static_notice("cap-update: cap-id=%#lx %s", rsp.cap_().id(),
+                                  cap->dump().c_str());
 
-                if (EOS_LOGS_DEBUG) {
-                  eos_static_debug("%s op=%d", md->dump().c_str(), md->getop());
+                if (cap->id()) {
+                  EosFuse::Instance().caps.update_quota(cap, rsp.cap_()._quota());
+                  eos_static_notice("cap-update: cap-id=%#lx %s", rsp.cap_().id(),
+                                    cap->dump().c_str());
                 }
+              }
 
-                // update the local store
-                update(req, md, authid, true);
-                std::string name = md->name();
-                md->Locker().UnLock();
-                // adjust local quota
-                cap::shared_cap cap = EosFuse::Instance().caps.get(pino, md_clientid);
+              if (rsp.type() == rsp.MD) {
+                fuse_req_t req;
+                memset(&req, 0, sizeof(fuse_req_t));
+                uint64_t md_ino = rsp.md_().md_ino();
+                std::string authid = rsp.md_().authid();
+                uint64_t ino = inomap.forward(md_ino);
+                eos_static_notice("md-update: remote-ino=%#lx ino=%#lx authid=%s",
+                                  md_ino, ino, authid.c_str());
+                // we get this when a file update/flush appeared
+                shared_md md;
+                int64_t bookingsize = 0;
+                uint64_t pino = 0;
+                mode_t mode = 0;
+                std::string md_clientid;
+                std::string old_name;
+                bool data_changed = false;
+
+                // MD update logic
+                if (ino) {
+                  eos_static_notice("md-update: (existing) remote-ino=%#lx ino=%#lx authid=%s",
+                                    md_ino, ino, authid.c_str());
+                  mdmap.retrieveOrCreateTS(ino, md);
+
+                  // updated file MD
+                  if (EOS_LOGS_DEBUG) {
+                    eos_static_debug("%s op=%d", md->dump().c_str(), md->getop());
+                  }
 
-                if (cap->id()) {
-                  if (bookingsize >= 0) {
-                    EosFuse::Instance().caps.book_volume(cap, (uint64_t) bookingsize);
-                  } else {
-                    EosFuse::Instance().caps.free_volume(cap, (uint64_t) - bookingsize);
+                  md->Locker().Lock();
+                  bookingsize = rsp.md_().size() - md->size();
+                  md_clientid = rsp.md_().clientid();
+                  eos_static_info("md-update: %s %s", md->name().c_str(),
+                                    rsp.md_().name().c_str());
+
+                  // check if this implies a rename
+                  if (md->name() != rsp.md_().name()) {
+                    old_name = rsp.md_().name();
                   }
 
-                  EosFuse::instance().caps.book_inode(cap);
-                } else {
-                  eos_static_debug("missing quota node for pino=%#lx and clientid=%s",
-                                   pino, md->clientid().c_str());
-                }
+                  std::string old_cookie = md->Cookie();
+                  uint64_t old_bc_time = md->bc_time();
 
-                // possibly invalidate kernel cache
-                if (EosFuse::Instance().Config().options.md_kernelcache ||
-                    EosFuse::Instance().Config().options.data_kernelcache) {
-                  eos_static_info("invalidate data cache for ino=%#lx", ino);
-                  kernelcache::inval_inode(ino, S_ISDIR(mode) ? false : true);
-                }
+                  // verify that this record is newer than
+                  if (rsp.md_().clock() >= md->clock()) {
+                    eos_static_info("overwriting clock MD %#lx => %#lx", md->clock(),
+                                    rsp.md_().clock());
+                    *md = rsp.md_();
+                    md->set_creator(false);
+                  } else {
+                    eos_static_warning("keeping clock MD %#lx => %#lx", md->clock(),
+                                       rsp.md_().clock());
+                  }
 
-                if (EosFuse::Instance().Config().options.md_kernelcache && old_name.length()) {
-                  eos_static_info("invalidate previous name for ino=%#lx old-name=%s", ino,
-                                  old_name.c_str());
-                  kernelcache::inval_entry(pino, old_name.c_str());
-                  kernelcache::inval_inode(pino, false);
-                }
+                  md->clear_clientid();
+                  pino = inomap.forward(md->md_pino());
+                  md->set_id(ino);
+                  md->set_pid(pino);
+                  mode = md->mode();
+                  // only a change of mtime or size invalidates cached file data
+                  data_changed = (md->Cookie() != old_cookie);
+                  md->set_bc_time(data_changed ? time(NULL) : old_bc_time);
 
-                if (S_ISREG(mode)) {
-                  // invalidate local disk cache
-                  EosFuse::Instance().datas.invalidate_cache(ino);
-                  eos_static_info("invalidate local disk cache for ino=%#lx", ino);
-                }
-              } else {
-                eos_static_info("md-update: (new) remote-ino=%#lx ino=%#lx authid=%s",
-                                  md_ino, ino, authid.c_str());
-                // new file
-                md = std::make_shared<mdx>();
-                *md = rsp.md_();
-                uint64_t new_ino = insert(req, md, authid);
-                uint64_t md_pino = md->md_pino();
-                std::string md_clientid = md->clientid();
-                uint64_t md_size = md->size();
-                md->Locker().Lock();
-                // add to mdmap
-                mdmap.insertTS(new_ino, md);
-                // add to parent
-                uint64_t pino = inomap.forward(md_pino);
-                shared_md pmd;
-
-                if (pino && mdmap.retrieveTS(pino, pmd)) {
-                  if (md->pt_mtime()) {
-                    pmd->set_mtime(md->pt_mtime());
-                    pmd->set_mtime_ns(md->pt_mtime_ns());
+                  if (EOS_LOGS_DEBUG) {
+                    eos_static_debug("%s op=%d", md->dump().c_str(), md->getop());
                   }
 
-                  md->clear_pt_mtime();
-                  md->clear_pt_mtime_ns();
-                  inomap.insert(md->md_ino(), md->id());
-                  add(0, pmd, md, authid, true);
-                  update(req, pmd, authid, true);
+                  // update the local store
+                  update(req, md, authid, true);
+                  std::string name = md->name();
+                  md->Locker().UnLock();
                   // adjust local quota
                   cap::shared_cap cap = EosFuse::Instance().caps.get(pino, md_clientid);
 
                   if (cap->id()) {
-                    EosFuse::Instance().caps.book_volume(cap, md_size);
+                    if (bookingsize >= 0) {
+                      EosFuse::Instance().caps.book_volume(cap, (uint64_t) bookingsize);
+                    } else {
+                      EosFuse::Instance().caps.free_volume(cap, (uint64_t) - bookingsize);
+                    }
+
                     EosFuse::instance().caps.book_inode(cap);
                   } else {
-                    eos_static_debug("missing quota node for pino=%#llx and clientid=%s",
+                    eos_static_debug("missing quota node for pino=%#lx and clientid=%s",
                                      pino, md->clientid().c_str());
                   }
 
-		  md->Locker().UnLock();
+                  // possibly invalidate kernel cache
+                  if (!S_ISDIR(mode) && !data_changed) {
+                    if (EosFuse::Instance().Config().options.md_kernelcache) {
+                      eos_static_info("invalidate attributes for ino=%#lx", ino);
+                      kernelcache::inval_inode(ino, false);
+                    }
+                  } else if (EosFuse::Instance().Config().options.md_kernelcache ||
+                             EosFuse::Instance().Config().options.data_kernelcache) {
+                    eos_static_info("invalidate data cache for ino=%#lx", ino);
+                    kernelcache::inval_inode(ino, S_ISDIR(mode) ? false : true);
+                  }
 
-                  // possibly invalidate kernel cache for parent
-                  if (EosFuse::Instance().Config().options.md_kernelcache) {
-                    eos_static_info("invalidate md cache for ino=%016lx", pino);
-                    kernelcache::inval_entry(pino, md->name());
+                  if (EosFuse::Instance().Config().options.md_kernelcache && old_name.length()) {
+                    eos_static_info("invalidate previous name for ino=%#lx old-name=%s", ino,
+                                    old_name.c_str());
+                    kernelcache::inval_entry(pino, old_name.c_str());
                     kernelcache::inval_inode(pino, false);
-                    pmd->local_enoent().erase(md->name());
+                  }
+
+                  if (S_ISREG(mode) && data_changed) {
+                    // invalidate local disk cache
+                    EosFuse::Instance().datas.invalidate_cache(ino);
+                    eos_static_info("invalidate local disk cache for ino=%#lx", ino);
                   }
                 } else {
-                  eos_static_err("missing parent mapping pino=%16x for ino%16x",
-                                 md_pino,
-                                 md_ino);
-		  md->Locker().UnLock();
+                  eos_static_info("md-update: (new) remote-ino=%#lx ino=%#lx authid=%s",
+                                    md_ino, ino, authid.c_str());
+                  // new file
+                  md = std::make_shared<mdx>();
+                  *md = rsp.md_();
+                  uint64_t new_ino = insert(req, md, authid);
+                  uint64_t md_pino = md->md_pino();
+                  std::string md_clientid = md->clientid();
+                  uint64_t md_size = md->size();
+                  md->Locker().Lock();
+                  // add to mdmap
+                  mdmap.insertTS(new_ino, md);
+                  // add to parent
+                  uint64_t pino = inomap.forward(md_pino);
+                  shared_md pmd;
+
+                  if (pino && mdmap.retrieveTS(pino, pmd)) {
+                    if (md->pt_mtime()) {
+                      pmd->set_mtime(md->pt_mtime());
+                      pmd->set_mtime_ns(md->pt_mtime_ns());
+                    }
+
+                    md->clear_pt_mtime();
+                    md->clear_pt_mtime_ns();
+                    inomap.insert(md->md_ino(), md->id());
+                    add(0, pmd, md, authid, true);
+                    update(req, pmd, authid, true);
+                    // adjust local quota
+                    cap::shared_cap cap = EosFuse::Instance().caps.get(pino, md_clientid);
+
+                    if (cap->id()) {
+                      EosFuse::Instance().caps.book_volume(cap, md_size);
+                      EosFuse::instance().caps.book_inode(cap);
+                    } else {
+                      eos_static_debug("missing quota node for pino=%#llx and clientid=%s",
+                                       pino, md->clientid().c_str());
+                    }
+
+  		  md->Locker().UnLock();
+
+                    // possibly invalidate kernel cache for parent
+                    if (EosFuse::Instance().Config().options.md_kernelcache) {
+                      eos_static_info("invalidate md cache for ino=%016lx", pino);
+                      kernelcache::inval_entry(pino, md->name());
+                      kernelcache::inval_inode(pino, false);
+                      pmd->local_enoent().erase(md->name());
+                    }
+                  } else {
+                    eos_static_err("missing parent mapping pino=%16x for ino%16x",
+                                   md_pino,
+                                   md_ino);
+  		  md->Locker().UnLock();
+                  }
                 }
               }
+            } else {
+              eos_static_err("unable to parse message");
             }
-          } else {
-            eos_static_err("unable to parse message");
           }
 
           zmq_msg_close(&message);
@@ -36,6 +36,7 @@
 #include "common/RWMutex.hh"
 #include "common/AssistedThread.hh"
 #include "misc/FuseId.hh"
+#include "misc/ShardedMap.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include <memory>
 #include <map>
@@ -77,6 +78,7 @@ public:
       cap_count_reset();
       refresh = false;
       rmrf = false;
+      warmed = false;
       inline_size = 0;
     }
 
@@ -315,6 +317,25 @@ public:
       rmrf = false;
     }
 
+    // a persisted listing is tried only once per directory and mount
+    bool set_warmed()
+    {
+      bool was_warmed = warmed;
+      warmed = true;
+      return was_warmed;
+    }
+
+    // data version of the pages kept in the kernel page cache
+    const std::string& kernel_cookie() const
+    {
+      return kcookie;
+    }
+
+    void set_kernel_cookie(const std::string& cookie)
+    {
+      kcookie = cookie;
+    }
+
   private:
     XrdSysMutex mLock;
     XrdSysCondVar mSync;
@@ -325,6 +346,8 @@ public:
     bool lock_remote;
     bool refresh;
     bool rmrf;
+    bool warmed;
+    std::string kcookie;
     uint64_t inline_size;
     std::vector<struct flock> locktable;
     std::map<std::string, uint64_t> todelete;
@@ -371,7 +394,7 @@ public:
     XrdSysMutex mMutex;
   };
 
-  class pmap : public std::map<fuse_ino_t, shared_md>, public XrdSysMutex
+  class pmap : public ShardedMap<shared_md>
   //----------------------------------------------------------------------------
   {
   public:
@@ -382,16 +405,19 @@ public:
 
     bool retrieveOrCreateTS(fuse_ino_t ino, shared_md& ret)
     {
-      XrdSysMutexHelper mLock(this);
+      Shard& shard = GetShard(ino);
+      XrdSysMutexHelper mLock(shard.mMutex);
+      auto it = shard.mMap.find(ino);
 
-      if (this->retrieve(ino, ret)) {
+      if (it != shard.mMap.end()) {
+        ret = it->second;
         return false;
       }
 
       ret = std::make_shared<mdx>();
 
       if (ino) {
-        (*this)[ino] = ret;
+        shard.mMap[ino] = ret;
       }
 
       return true;
@@ -399,59 +425,32 @@ public:
 
     // TS stands for "thread-safe"
 
-    bool retrieveTS(fuse_ino_t ino, shared_md& ret)
-    {
-      XrdSysMutexHelper mLock(this);
-      return this->retrieve(ino, ret);
-    }
-
-    bool retrieve(fuse_ino_t ino, shared_md& ret)
-    {
-      auto it = this->find(ino);
-
-      if (it == this->end()) {
-        return false;
-      }
-
-      ret = it->second;
-      return true;
-    }
-
-    // TS stands for "thread-safe"
-
-    void insertTS(fuse_ino_t ino, shared_md& md)
-    {
-      XrdSysMutexHelper mLock(this);
-      (*this)[ino] = md;
-    }
-
-    // TS stands for "thread-safe"
-
-    bool eraseTS(fuse_ino_t ino)
-    {
-      XrdSysMutexHelper mLock(this);
-      return this->erase(ino) ? true : false;
-    }
-
     void retrieveWithParentTS(fuse_ino_t ino, shared_md& md, shared_md& pmd)
     {
       // Atomically retrieve md objects for an inode, and its parent.
+      Shard& shard = GetShard(ino);
+
       while (true) {
-        // In this particular case, we need to first lock mdmap, and then
-        // md.. The following algorithm is meant to avoid deadlocks with code
-        // which locks md first, and then mdmap.
+        // In this particular case, we need to first lock the mdmap shard, and
+        // then md.. The following algorithm is meant to avoid deadlocks with
+        // code which locks md first, and then mdmap.
         md.reset();
         pmd.reset();
-        XrdSysMutexHelper mLock(this);
+        XrdSysMutexHelper mLock(shard.mMutex);
+        auto it = shard.mMap.find(ino);
 
-        if (!retrieve(ino, md)) {
+        if (it == shard.mMap.end()) {
           return; // ino not there, nothing to do
         }
 
+        md = it->second;
+
         // md has been found. Can we lock it?
         if (md->Locker().CondLock()) {
-          // Success!
-          retrieve(md->pid(), pmd);
+          // Success! The parent can't change while md is locked, the parent
+          // shard is locked after releasing ours to never hold two shards.
+          mLock.UnLock();
+          retrieveTS(md->pid(), pmd);
           md->Locker().UnLock();
           return;
         }
@@ -528,12 +527,27 @@ public:
 
   int rmrf(fuse_req_t req, shared_md md);
 
+  //----------------------------------------------------------------------------
+  //! Drop the local subtree below a directory deleted on the server side:
+  //! the entries are marked deleted, their data caches dropped and the kernel
+  //! dentries invalidated in one pass - no request goes upstream
+  //!
+  //! @return number of local entries dropped
+  //----------------------------------------------------------------------------
+  size_t wipe_subtree(fuse_req_t req, shared_md md);
+
   std::string dump_md(shared_md md, bool lock = true);
   std::string dump_md(eos::fusex::md& md);
   std::string dump_container(eos::fusex::container& cont);
 
   uint64_t apply(fuse_req_t req, eos::fusex::container& cont, bool listing);
 
+  // persistent meta data records for a warm start from the local KV store
+  void persist(mdx& md, uint64_t vtime = 0); // md has to be locked
+  void unpersist(uint64_t ino);
+  bool warmload(uint64_t ino, eos::fusex::md& md);
+  bool warmlisting(fuse_req_t req, shared_md pmd, std::string authid = "");
+
   int getlk(fuse_req_t req, shared_md md, struct flock* lock);
   int setlk(fuse_req_t req, shared_md md, struct flock* lock, int sleep);
 
@@ -834,6 +848,34 @@ public:
     return mdquery;
   }
 
+  bool supports_mdsince()
+  {
+    XrdSysMutexHelper cLock(ConfigMutex);
+    return mdsince;
+  }
+
+  bool supports_mdbatch()
+  {
+    XrdSysMutexHelper cLock(ConfigMutex);
+    return mdbatch;
+  }
+
+  bool supports_locknotify()
+  {
+    XrdSysMutexHelper cLock(ConfigMutex);
+    return locknotify;
+  }
+
+  // SETLKW waiters: a waiter registers once and takes the generation of the
+  // inode before each attempt, a lock release notification from the MGM
+  // bumps the generation and wakes it up, so notifications arriving before
+  // the wait are not lost
+  void begin_lockwait(fuse_ino_t ino);
+  uint64_t lockwait_generation(fuse_ino_t ino);
+  void wait_lockwait(fuse_ino_t ino, uint64_t generation, size_t ms);
+  void end_lockwait(fuse_ino_t ino);
+  void notify_lockwait(fuse_ino_t ino);
+
 private:
 
   // Lock _two_ md objects in the given order.
@@ -884,8 +926,21 @@ private:
   bool writesizeflush;
   bool appname;
   bool mdquery;
+  bool mdsince;
+  bool mdbatch;
+  bool locknotify;
   std::string serverversion;
 
+  struct lockwait_t {
+    uint64_t generation = 0;
+    size_t waiters = 0;
+  };
+
+  XrdSysCondVar lockwaitcond;
+  std::map<fuse_ino_t, lockwait_t> lockwaits; // inodes with SETLKW waiters
+
+  time_t warmstart; // maximum age of persisted records used after a restart
+
   InodeGenerator next_ino;
 
   XrdSysCondVar mdflush;
@@ -893,6 +948,9 @@ private:
   std::map<uint64_t, size_t> mdqueue; // inode, counter of mds to flush
   std::deque<flushentry> mdflushqueue; // linear queue with all entries to flush
 
+  // push consecutive creations/updates of one identity with SETMANY requests
+  void flushbatch(std::vector<flushentry>& batch);
+
   size_t mdqueue_max_backlog;
 
   // ZMQ objects
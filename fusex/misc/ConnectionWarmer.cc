@@ -0,0 +1,274 @@
+//------------------------------------------------------------------------------
+//! @file ConnectionWarmer.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "misc/ConnectionWarmer.hh"
+#include "common/Logging.hh"
+#include "XrdCl/XrdClFileSystem.hh"
+
+constexpr std::chrono::seconds ConnectionWarmer::kRewarmInterval;
+constexpr size_t ConnectionWarmer::kMaxLogins;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ConnectionWarmer::ConnectionWarmer(std::chrono::seconds window, size_t workers,
+                                   Pinger pinger):
+  mWindow(window), mNumWorkers(workers ? workers : 1),
+  mPinger(std::move(pinger))
+{}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+ConnectionWarmer::~ConnectionWarmer()
+{
+  stop();
+}
+
+//------------------------------------------------------------------------------
+// Start the ping threads
+//------------------------------------------------------------------------------
+void
+ConnectionWarmer::start()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStop = false;
+  }
+
+  for (size_t i = 0; i < mNumWorkers; ++i) {
+    mThreads.emplace_back(new AssistedThread(&ConnectionWarmer::run, this));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Stop the ping threads
+//------------------------------------------------------------------------------
+void
+ConnectionWarmer::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStop = true;
+  }
+  mCv.notify_all();
+
+  for (auto& thread : mThreads) {
+    thread->join();
+  }
+
+  mThreads.clear();
+}
+
+//------------------------------------------------------------------------------
+// Record the use of a login towards an endpoint
+//------------------------------------------------------------------------------
+void
+ConnectionWarmer::seen(const std::string& hostid, const std::string& username,
+                       const XrdCl::URL::ParamsMap& params)
+{
+  const std::string key = username + "@" + hostid;
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mLogins.find(key);
+
+  if (it != mLogins.end()) {
+    it->second.lastSeen = now;
+    return;
+  }
+
+  if (mLogins.size() >= kMaxLogins) {
+    return;
+  }
+
+  Login& login = mLogins[key];
+  login.url = makeUrl(hostid, username, params);
+  login.lastSeen = now;
+  login.queued = true;
+  mPending.push_back(key);
+  lock.unlock();
+  mCv.notify_one();
+}
+
+//------------------------------------------------------------------------------
+// Queue the logins due for a ping, forget the old ones
+//------------------------------------------------------------------------------
+void
+ConnectionWarmer::scan(std::chrono::steady_clock::time_point now)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mLastScan = now;
+  bool queued = false;
+
+  for (auto it = mLogins.begin(); it != mLogins.end();) {
+    Login& login = it->second;
+
+    if (now - login.lastSeen > mWindow) {
+      if (!login.queued) {
+        it = mLogins.erase(it);
+        continue;
+      }
+    } else if (!login.queued && (now - login.lastWarm >= kRewarmInterval)) {
+      login.queued = true;
+      mPending.push_back(it->first);
+      queued = true;
+    }
+
+    ++it;
+  }
+
+  lock.unlock();
+
+  if (queued) {
+    mCv.notify_all();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Ping one queued login
+//------------------------------------------------------------------------------
+bool
+ConnectionWarmer::pingOne()
+{
+  std::string key;
+  std::string url;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mPending.empty()) {
+      return false;
+    }
+
+    key = mPending.front();
+    mPending.pop_front();
+    auto it = mLogins.find(key);
+
+    if (it == mLogins.end()) {
+      return true;
+    }
+
+    url = it->second.url;
+  }
+  bool ok = mPinger(url);
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mLogins.find(key);
+
+  if (it != mLogins.end()) {
+    it->second.queued = false;
+    it->second.lastWarm = std::chrono::steady_clock::now();
+  }
+
+  if (ok) {
+    mWarmed++;
+  } else {
+    mFailed++;
+    eos_static_info("msg=\"failed to pre-authenticate login\" login=%s",
+                    key.c_str());
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Build the URL used to ping a login
+//------------------------------------------------------------------------------
+std::string
+ConnectionWarmer::makeUrl(const std::string& hostid,
+                          const std::string& username,
+                          const XrdCl::URL::ParamsMap& params)
+{
+  std::string url = "root://" + username + "@" + hostid + "//";
+  std::string cgi;
+
+  for (const auto& param : params) {
+    if ((param.first.compare(0, 4, "xrd.") == 0) ||
+        (param.first.compare(0, 6, "xrdcl.") == 0)) {
+      cgi += (cgi.empty() ? "?" : "&");
+      cgi += param.first + "=" + param.second;
+    }
+  }
+
+  return url + cgi;
+}
+
+//------------------------------------------------------------------------------
+// Authenticate the connection of the given URL with an XRootD ping
+//------------------------------------------------------------------------------
+bool
+ConnectionWarmer::xrdPing(const std::string& url)
+{
+  XrdCl::FileSystem fs((XrdCl::URL(url)));
+  XrdCl::XRootDStatus status = fs.Ping(30);
+  return status.IsOK();
+}
+
+//------------------------------------------------------------------------------
+// Get number of remembered logins
+//------------------------------------------------------------------------------
+size_t
+ConnectionWarmer::size()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mLogins.size();
+}
+
+//------------------------------------------------------------------------------
+// Ping thread loop
+//------------------------------------------------------------------------------
+void
+ConnectionWarmer::run(ThreadAssistant& assistant)
+{
+  assistant.registerCallback([this]() {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStop = true;
+    }
+    mCv.notify_all();
+  });
+
+  while (!assistant.terminationRequested()) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    bool do_scan = false;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+
+      if (mStop) {
+        break;
+      }
+
+      if (now - mLastScan >= std::chrono::seconds(1)) {
+        // Claim the scan, the other threads keep pinging
+        mLastScan = now;
+        do_scan = true;
+      } else if (mPending.empty()) {
+        mCv.wait_for(lock, std::chrono::seconds(1));
+        continue;
+      }
+    }
+
+    if (do_scan) {
+      scan(now);
+    }
+
+    while (pingOne() && !assistant.terminationRequested()) {}
+  }
+}
@@ -0,0 +1,168 @@
+//------------------------------------------------------------------------------
+//! @file ConnectionWarmer.hh
+//! @brief Authenticate the XRootD logins of recently seen identities ahead of
+//!        their next request
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef FUSE_CONNECTIONWARMER_HH_
+#define FUSE_CONNECTIONWARMER_HH_
+
+#include "common/AssistedThread.hh"
+#include "XrdCl/XrdClURL.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Keeps the connections of the logins used in the last window seconds
+//! established and authenticated.
+//!
+//! XRootD creates one physical connection per login and endpoint and
+//! authenticates it inside the first request using it. A login seen for the
+//! first time is pinged from background threads, so that its extra pooled
+//! logins are authenticated before they are used. Logins seen within the
+//! window are pinged again every kRewarmInterval, so that the client does
+//! not close their connections as idle and the next request of the identity
+//! does not pay the authentication again. Logins not seen for longer than
+//! the window are forgotten.
+//------------------------------------------------------------------------------
+class ConnectionWarmer
+{
+public:
+  //! Function authenticating a connection, returns true on success
+  using Pinger = std::function<bool(const std::string& url)>;
+
+  //! Interval between two pings of the same login
+  static constexpr std::chrono::seconds kRewarmInterval {60};
+  //! Maximum number of remembered logins
+  static constexpr size_t kMaxLogins = 16384;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param window how long a login is kept warm after it was seen
+  //! @param workers number of threads pinging in parallel
+  //! @param pinger ping function, by default an XRootD ping
+  //----------------------------------------------------------------------------
+  ConnectionWarmer(std::chrono::seconds window, size_t workers = 4,
+                   Pinger pinger = xrdPing);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~ConnectionWarmer();
+
+  //----------------------------------------------------------------------------
+  //! Start the ping threads
+  //----------------------------------------------------------------------------
+  void start();
+
+  //----------------------------------------------------------------------------
+  //! Stop the ping threads
+  //----------------------------------------------------------------------------
+  void stop();
+
+  //----------------------------------------------------------------------------
+  //! Record the use of a login towards an endpoint
+  //!
+  //! @param hostid host:port of the endpoint
+  //! @param username XRootD login
+  //! @param params URL parameters of the request, only the credential ones
+  //!        (xrd.* and xrdcl.*) are kept
+  //----------------------------------------------------------------------------
+  void seen(const std::string& hostid, const std::string& username,
+            const XrdCl::URL::ParamsMap& params);
+
+  //----------------------------------------------------------------------------
+  //! Queue the logins which were seen within the window and not pinged for
+  //! kRewarmInterval, forget the others - called periodically by the threads
+  //----------------------------------------------------------------------------
+  void scan(std::chrono::steady_clock::time_point now);
+
+  //----------------------------------------------------------------------------
+  //! Ping one queued login, if any
+  //!
+  //! @return true if a login was pinged
+  //----------------------------------------------------------------------------
+  bool pingOne();
+
+  //----------------------------------------------------------------------------
+  //! Build the URL used to ping a login
+  //----------------------------------------------------------------------------
+  static std::string makeUrl(const std::string& hostid,
+                             const std::string& username,
+                             const XrdCl::URL::ParamsMap& params);
+
+  //----------------------------------------------------------------------------
+  //! Authenticate the connection of the given URL with an XRootD ping
+  //----------------------------------------------------------------------------
+  static bool xrdPing(const std::string& url);
+
+  uint64_t getWarmed() const
+  {
+    return mWarmed;
+  }
+
+  uint64_t getFailed() const
+  {
+    return mFailed;
+  }
+
+  size_t size();
+
+private:
+  //----------------------------------------------------------------------------
+  //! Remembered login
+  //----------------------------------------------------------------------------
+  struct Login {
+    std::string url; ///< ping URL
+    std::chrono::steady_clock::time_point lastSeen; ///< last use
+    std::chrono::steady_clock::time_point lastWarm; ///< last ping
+    bool queued {false}; ///< waiting in mPending
+  };
+
+  //----------------------------------------------------------------------------
+  //! Ping thread loop
+  //----------------------------------------------------------------------------
+  void run(ThreadAssistant& assistant);
+
+  std::chrono::seconds mWindow; ///< how long logins are kept warm
+  size_t mNumWorkers; ///< number of ping threads
+  Pinger mPinger; ///< ping function
+  std::mutex mMutex; ///< protects the members below
+  std::condition_variable mCv; ///< notified when a login is queued
+  std::map<std::string, Login> mLogins; ///< by username@hostid
+  std::deque<std::string> mPending; ///< logins to ping
+  std::chrono::steady_clock::time_point mLastScan; ///< last call of scan
+  bool mStop {false}; ///< threads are stopping
+  std::vector<std::unique_ptr<AssistedThread>> mThreads; ///< ping threads
+  std::atomic<uint64_t> mWarmed {0}; ///< number of successful pings
+  std::atomic<uint64_t> mFailed {0}; ///< number of failed pings
+};
+
+#endif
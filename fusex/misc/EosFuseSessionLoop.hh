@@ -10,12 +10,30 @@
 
 #include "ThreadPool.hh"
 
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <fstream>
 #include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 extern "C" {
 #include <fuse/fuse_lowlevel.h>
 }
 
+#ifndef FUSE_DEV_IOC_CLONE
+//! Attach a new /dev/fuse fd to the connection of an existing one, the
+//! requests read from an fd have to be answered through the same fd
+#define FUSE_DEV_IOC_CLONE _IOR(229, 0, uint32_t)
+#endif
+
 struct fuse_in_header {
   uint32_t len;
   uint32_t opcode;
@@ -54,13 +72,43 @@ class EosFuseSessionLoop
     fuse_chan* chan;
   };
 
+  //----------------------------------------------------------------------------
+  //! Additional channel on a cloned /dev/fuse fd, with its own reader thread
+  //! and worker pools
+  //----------------------------------------------------------------------------
+  struct Queue {
+
+    Queue(int metaMin, int metaMax, int ioMin, int ioMax) :
+      chan(0), metaPool(metaMin, metaMax), ioPool(ioMin, ioMax) { }
+
+    fuse_chan* chan;
+    ThreadPool<FuseTask> metaPool;
+    ThreadPool<FuseTask> ioPool;
+    std::thread reader;
+  };
+
 public:
 
-  EosFuseSessionLoop(int metaMin, int metaMax, int ioMin, int ioMax) :
+  //! How the channels are bound to CPUs
+  enum class Affinity { kNone, kCpu, kNuma };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param queues number of channels - above 1 the additional channels are
+  //!        clones of the session channel, each served by its own threads
+  //! @param affinity binding of the threads of channel i to cpu i or to the
+  //!        cpus of numa node i, modulo the number of cpus or nodes
+  //----------------------------------------------------------------------------
+  EosFuseSessionLoop(int metaMin, int metaMax, int ioMin, int ioMax,
+                     unsigned queues = 1, Affinity affinity = Affinity::kNone) :
+    metaMin(metaMin), metaMax(metaMax), ioMin(ioMin), ioMax(ioMax),
+    numQueues(queues ? queues : 1), affinity(affinity),
     metaPool(metaMin, metaMax), ioPool(ioMin, ioMax) { }
 
   virtual ~EosFuseSessionLoop()
   {
+    StopQueues();
     metaPool.Stop();
     ioPool.Stop();
   }
@@ -70,6 +118,16 @@ public:
     int res = 0;
     struct fuse_chan* ch = fuse_session_next_chan(se, NULL);
     size_t bufsize = fuse_chan_bufsize(ch);
+    std::vector<cpu_set_t> cpus = QueueCpus(numQueues, affinity);
+
+    if (numQueues > 1) {
+      StartQueues(se, ch, bufsize, cpus);
+    }
+
+    // threads of the pools are created by this thread and inherit its binding
+    if (!cpus.empty()) {
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus[0]);
+    }
 
     while (!fuse_session_exited(se)) {
       std::unique_ptr<FuseTask> task(new FuseTask(se, bufsize, ch));
@@ -90,12 +148,311 @@ public:
       }
     }
 
+    // make sure the reader threads of the other channels terminate
+    fuse_session_exit(se);
+    StopQueues();
     fuse_session_reset(se);
     return res < 0 ? -1 : 0;
   }
 
+  //----------------------------------------------------------------------------
+  //! Get the number of channels actually serving requests
+  //----------------------------------------------------------------------------
+  size_t NumChannels() const
+  {
+    return 1 + queues.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Parse a kernel cpu list like "0-3,8,10-11"
+  //!
+  //! @return the cpus, empty if the list is malformed
+  //----------------------------------------------------------------------------
+  static std::vector<int> ParseCpuList(const std::string& list)
+  {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+
+    while (std::getline(ss, range, ',')) {
+      if (range.empty() || (range == "\n")) {
+        continue;
+      }
+
+      char* end = 0;
+      long first = strtol(range.c_str(), &end, 10);
+      long last = first;
+
+      if (end == range.c_str()) {
+        return std::vector<int>();
+      }
+
+      if (*end == '-') {
+        const char* start = end + 1;
+        last = strtol(start, &end, 10);
+
+        if (end == start) {
+          return std::vector<int>();
+        }
+      }
+
+      if ((*end != 0) && (*end != '\n')) {
+        return std::vector<int>();
+      }
+
+      if ((first < 0) || (last < first) || (last >= CPU_SETSIZE)) {
+        return std::vector<int>();
+      }
+
+      for (long cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back((int) cpu);
+      }
+    }
+
+    return cpus;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Compute the cpus of each channel
+  //!
+  //! @return one cpu set per channel, empty without binding
+  //----------------------------------------------------------------------------
+  static std::vector<cpu_set_t> QueueCpus(unsigned queues, Affinity affinity)
+  {
+    std::vector<cpu_set_t> result;
+    std::vector<std::vector<int>> groups;
+
+    if (affinity == Affinity::kNuma) {
+      for (int node = 0; node < CPU_SETSIZE; ++node) {
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) +
+                         "/cpulist");
+        std::string list;
+
+        if (!in.is_open()) {
+          break;
+        }
+
+        std::getline(in, list);
+        std::vector<int> cpus = ParseCpuList(list);
+
+        if (!cpus.empty()) {
+          groups.push_back(cpus);
+        }
+      }
+    }
+
+    if ((affinity == Affinity::kCpu) ||
+        ((affinity == Affinity::kNuma) && groups.empty())) {
+      long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+      for (long cpu = 0; (cpu < ncpu) && (cpu < CPU_SETSIZE); ++cpu) {
+        groups.push_back(std::vector<int>(1, (int) cpu));
+      }
+    }
+
+    if (groups.empty()) {
+      return result;
+    }
+
+    for (unsigned i = 0; i < queues; ++i) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+
+      for (int cpu : groups[i % groups.size()]) {
+        CPU_SET(cpu, &set);
+      }
+
+      result.push_back(set);
+    }
+
+    return result;
+  }
+
 private:
 
+  //----------------------------------------------------------------------------
+  //! Receive a request on a cloned channel
+  //----------------------------------------------------------------------------
+  static int CloneReceive(fuse_chan** chp, char* buf, size_t size)
+  {
+    fuse_chan* ch = *chp;
+    fuse_session* se = (fuse_session*) fuse_chan_data(ch);
+    ssize_t res = 0;
+
+    do {
+      // ENOENT: the request was interrupted before we got it
+      res = ::read(fuse_chan_fd(ch), buf, size);
+    } while ((res == -1) && (errno == ENOENT) && !fuse_session_exited(se));
+
+    int err = errno;
+
+    if (fuse_session_exited(se)) {
+      return 0;
+    }
+
+    if (res == -1) {
+      if (err == ENODEV) {
+        // unmounted
+        fuse_session_exit(se);
+        return 0;
+      }
+
+      return -err;
+    }
+
+    if ((size_t) res < sizeof(fuse_in_header)) {
+      return -EIO;
+    }
+
+    return res;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Send a reply on a cloned channel
+  //----------------------------------------------------------------------------
+  static int CloneSend(fuse_chan* ch, const struct iovec iov[], size_t count)
+  {
+    if (!iov) {
+      return 0;
+    }
+
+    if (::writev(fuse_chan_fd(ch), iov, count) == -1) {
+      // ENOENT: the request was interrupted meanwhile
+      return -errno;
+    }
+
+    return 0;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Close a cloned channel
+  //----------------------------------------------------------------------------
+  static void CloneDestroy(fuse_chan* ch)
+  {
+    ::close(fuse_chan_fd(ch));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Open a clone of the session channel
+  //!
+  //! @return the new channel or 0 if the kernel does not support clones
+  //----------------------------------------------------------------------------
+  static fuse_chan* CloneChan(fuse_session* se, fuse_chan* master,
+                              size_t bufsize)
+  {
+    static struct fuse_chan_ops ops = { CloneReceive, CloneSend, CloneDestroy };
+    int fd = ::open("/dev/fuse", O_RDWR | O_CLOEXEC);
+
+    if (fd == -1) {
+      return 0;
+    }
+
+    uint32_t masterfd = fuse_chan_fd(master);
+
+    if (ioctl(fd, FUSE_DEV_IOC_CLONE, &masterfd) == -1) {
+      ::close(fd);
+      return 0;
+    }
+
+    fuse_chan* ch = fuse_chan_new(&ops, fd, bufsize, se);
+
+    if (!ch) {
+      ::close(fd);
+    }
+
+    return ch;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Clone the session channel and start the reader threads
+  //----------------------------------------------------------------------------
+  void StartQueues(fuse_session* se, fuse_chan* master, size_t bufsize,
+                   const std::vector<cpu_set_t>& cpus)
+  {
+    for (unsigned i = 1; i < numQueues; ++i) {
+      fuse_chan* ch = CloneChan(se, master, bufsize);
+
+      if (!ch) {
+        fprintf(stderr, "# cloning /dev/fuse failed errno=%d - using %u "
+                "channel(s)\n", errno, i);
+        break;
+      }
+
+      std::unique_ptr<Queue> queue(new Queue(metaMin, metaMax, ioMin, ioMax));
+      queue->chan = ch;
+      const cpu_set_t* set = cpus.empty() ? 0 : &cpus[i];
+      Queue* q = queue.get();
+      queues.push_back(std::move(queue));
+      q->reader = std::thread([this, se, q, bufsize, set]() {
+        RunQueue(se, q, bufsize, set);
+      });
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Join the reader threads and close the cloned channels
+  //----------------------------------------------------------------------------
+  void StopQueues()
+  {
+    for (auto& queue : queues) {
+      if (queue->reader.joinable()) {
+        queue->reader.join();
+      }
+
+      queue->metaPool.Stop();
+      queue->ioPool.Stop();
+      fuse_chan_destroy(queue->chan);
+    }
+
+    queues.clear();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Reader loop of a cloned channel
+  //----------------------------------------------------------------------------
+  void RunQueue(fuse_session* se, Queue* q, size_t bufsize,
+                const cpu_set_t* set)
+  {
+    if (set) {
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), set);
+    }
+
+    struct pollfd pfd;
+    pfd.fd = fuse_chan_fd(q->chan);
+    pfd.events = POLLIN;
+
+    while (!fuse_session_exited(se)) {
+      // poll with a timeout, nobody interrupts this thread at shutdown
+      pfd.revents = 0;
+      int rc = poll(&pfd, 1, 1000);
+
+      if ((rc == 0) || ((rc == -1) && (errno == EINTR))) {
+        continue;
+      }
+
+      if (rc == -1) {
+        break;
+      }
+
+      std::unique_ptr<FuseTask> task(new FuseTask(se, bufsize, q->chan));
+      int res = fuse_session_receive_buf(se, &task->buf, &task->chan);
+
+      if ((res == -EINTR) || (res == -EAGAIN)) {
+        continue;
+      }
+
+      if (res <= 0) {
+        break;
+      }
+
+      if (IsIO(task->buf)) {
+        q->ioPool.Execute(task.release());
+      } else {
+        q->metaPool.Execute(task.release());
+      }
+    }
+  }
+
   enum fuse_opcode {
     FUSE_READ = 15,
     FUSE_WRITE = 16,
@@ -116,8 +473,15 @@ private:
     return true;
   }
 
+  int metaMin;
+  int metaMax;
+  int ioMin;
+  int ioMax;
+  unsigned numQueues;
+  Affinity affinity;
   ThreadPool<FuseTask> metaPool;
   ThreadPool<FuseTask> ioPool;
+  std::vector<std::unique_ptr<Queue>> queues;
 };
 
 #endif /* EOSFUSESESSIONLOOP_HH_ */
@@ -0,0 +1,162 @@
+//------------------------------------------------------------------------------
+//! @file ShardedMap.hh
+//! @brief Inode keyed hash map split into independently locked shards
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef FUSE_SHARDEDMAP_HH_
+#define FUSE_SHARDEDMAP_HH_
+
+#include "common/hopscotch_map.hh"
+#include "XrdSys/XrdSysPthread.hh"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Class ShardedMap - hash map keyed by inode, split in shards with their own
+//! mutex so that operations on different inodes don't serialize on a single
+//! lock. The shard is selected by the inode modulo 0xffffffff, which keeps an
+//! inode and its 'unlinked' alias (inode + 0xffffffff) in the same shard.
+//!
+//! Code locking a shard must never lock another shard at the same time, whole
+//! map operations like size or the snapshots go through the shards one by one.
+//------------------------------------------------------------------------------
+template <typename Value, size_t NShards = 64>
+class ShardedMap
+{
+public:
+  typedef tsl::hopscotch_map<uint64_t, Value> Map;
+
+  //----------------------------------------------------------------------------
+  //! Shard of the map
+  //----------------------------------------------------------------------------
+  struct Shard {
+    XrdSysMutex mMutex; ///< Mutex protecting the map
+    Map mMap; ///< Entries of the shard
+  };
+
+  static constexpr size_t kNumShards = NShards;
+
+  ShardedMap() { }
+
+  virtual ~ShardedMap() { }
+
+  //----------------------------------------------------------------------------
+  //! Get the index of the shard holding the given inode
+  //----------------------------------------------------------------------------
+  static inline size_t ShardIndex(uint64_t ino)
+  {
+    return (ino % 0xffffffffull) % NShards;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the shard holding the given inode
+  //----------------------------------------------------------------------------
+  inline Shard& GetShard(uint64_t ino)
+  {
+    return mShards[ShardIndex(ino)];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the shard with the given index
+  //----------------------------------------------------------------------------
+  inline Shard& GetShardAt(size_t index)
+  {
+    return mShards[index];
+  }
+
+  // TS stands for "thread-safe"
+
+  bool retrieveTS(uint64_t ino, Value& ret)
+  {
+    Shard& shard = GetShard(ino);
+    XrdSysMutexHelper mLock(shard.mMutex);
+    auto it = shard.mMap.find(ino);
+
+    if (it == shard.mMap.end()) {
+      return false;
+    }
+
+    ret = it->second;
+    return true;
+  }
+
+  void insertTS(uint64_t ino, const Value& val)
+  {
+    Shard& shard = GetShard(ino);
+    XrdSysMutexHelper mLock(shard.mMutex);
+    shard.mMap[ino] = val;
+  }
+
+  bool eraseTS(uint64_t ino)
+  {
+    Shard& shard = GetShard(ino);
+    XrdSysMutexHelper mLock(shard.mMutex);
+    return shard.mMap.erase(ino) ? true : false;
+  }
+
+  bool countTS(uint64_t ino)
+  {
+    Shard& shard = GetShard(ino);
+    XrdSysMutexHelper mLock(shard.mMutex);
+    return shard.mMap.count(ino) ? true : false;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Copy the entries of one shard
+  //!
+  //! @param index shard index
+  //! @param entries output entries
+  //----------------------------------------------------------------------------
+  void snapshotTS(size_t index, std::vector<std::pair<uint64_t, Value>>& entries)
+  {
+    Shard& shard = mShards[index];
+    XrdSysMutexHelper mLock(shard.mMutex);
+    entries.reserve(entries.size() + shard.mMap.size());
+
+    for (auto it = shard.mMap.begin(); it != shard.mMap.end(); ++it) {
+      entries.emplace_back(it->first, it->second);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the number of entries, the shards are counted one after the other
+  //----------------------------------------------------------------------------
+  size_t size()
+  {
+    size_t n = 0;
+
+    for (size_t i = 0; i < NShards; ++i) {
+      XrdSysMutexHelper mLock(mShards[i].mMutex);
+      n += mShards[i].mMap.size();
+    }
+
+    return n;
+  }
+
+private:
+  Shard mShards[NShards];
+};
+
+template <typename Value, size_t NShards>
+constexpr size_t ShardedMap<Value, NShards>::kNumShards;
+
+#endif
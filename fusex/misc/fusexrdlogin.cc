@@ -27,6 +27,7 @@
 #include "common/Macros.hh"
 #include "common/SymKeys.hh"
 #include "misc/FuseId.hh"
+#include "auth/BoundIdentityProvider.hh"
 #include <algorithm>
 #include <regex>
 #ifdef __APPLE__
@@ -35,11 +36,67 @@
 
 std::unique_ptr<AuthenticationGroup> fusexrdlogin::authGroup;
 ProcessCache* fusexrdlogin::processCache = nullptr;
+std::unique_ptr<ConnectionWarmer> fusexrdlogin::connectionWarmer;
+unsigned fusexrdlogin::connectionPool = 1;
+constexpr size_t fusexrdlogin::kMaxPools;
+std::mutex fusexrdlogin::poolMutex;
+std::map<std::string, std::vector<std::string>> fusexrdlogin::loginPools;
 
 void fusexrdlogin::initializeProcessCache(const CredentialConfig& config)
 {
   authGroup.reset(new AuthenticationGroup(config));
   processCache = authGroup->processCache();
+  connectionPool = std::max(1u, config.connection_pool);
+
+  if (config.connection_warmup) {
+    connectionWarmer.reset(new ConnectionWarmer(
+                             std::chrono::seconds(config.connection_warmup)));
+    connectionWarmer->start();
+  }
+}
+
+void fusexrdlogin::stopConnectionWarmer()
+{
+  if (connectionWarmer) {
+    connectionWarmer->stop();
+  }
+}
+
+std::string fusexrdlogin::pooledLogin(const BoundIdentity& identity,
+                                      int connectionid,
+                                      std::vector<std::string>& allocated)
+{
+  std::string primary = identity.getLogin().getStringID();
+  const TrustedCredentials* creds = identity.getCreds();
+
+  if ((connectionPool <= 1) || creds->empty() ||
+      (creds->getUC().type == CredentialType::NOBODY)) {
+    return primary;
+  }
+
+  std::lock_guard<std::mutex> lock(poolMutex);
+  auto it = loginPools.find(primary);
+
+  if (it == loginPools.end()) {
+    // Renewed credentials get a new primary login, drop the stale pools
+    if (loginPools.size() >= kMaxPools) {
+      loginPools.clear();
+    }
+
+    it = loginPools.emplace(primary, std::vector<std::string>()).first;
+
+    // Allocate the whole pool at once, so that it can be warmed up
+    for (unsigned i = 1; i < connectionPool; ++i) {
+      it->second.push_back(authGroup->boundIdentityProvider()->allocateLogin(
+                             identity).getStringID());
+    }
+
+    allocated = it->second;
+  }
+
+  unsigned slot = (connectionid > 0) ? (unsigned) connectionid % connectionPool :
+                  0;
+  return (slot ? it->second[slot - 1] : primary);
 }
 
 std::string fusexrdlogin::fillExeName(const std::string& execname)
@@ -74,7 +131,7 @@ int fusexrdlogin::loginurl(XrdCl::URL& url,
                            int connection_id)
 {
   fuse_id id(req);
-  return loginurl(url, paramsMap, id.uid, id.gid, id.pid, root_squash,
+  return loginurl(url, paramsMap, id.uid, id.gid, id.pid, ino, root_squash,
                   connection_id);
 }
 
@@ -94,9 +151,11 @@ int fusexrdlogin::loginurl(XrdCl::URL& url,
   ProcessSnapshot snapshot = processCache->retrieve(id.pid, id.uid, id.gid,
                              false);
   std::string username = "nobody";
+  std::vector<std::string> allocated;
 
   if (snapshot) {
-    username = snapshot->getBoundIdentity()->getLogin().getStringID();
+    username = pooledLogin(*snapshot->getBoundIdentity(), connection_id,
+                           allocated);
     snapshot->getBoundIdentity()->getCreds()->toXrdParams(paramsMap);
     paramsMap["fuse.exe"] = fillExeName(snapshot->getExe());
     paramsMap["fuse.pid"] = std::to_string(id.pid);
@@ -105,6 +164,15 @@ int fusexrdlogin::loginurl(XrdCl::URL& url,
   }
 
   url.SetUserName(username);
+
+  if (snapshot && connectionWarmer) {
+    connectionWarmer->seen(url.GetHostId(), username, paramsMap);
+
+    for (const auto& login : allocated) {
+      connectionWarmer->seen(url.GetHostId(), login, paramsMap);
+    }
+  }
+
   int rc = 0;
   eos_static_notice("%s uid=%u gid=%u rc=%d user-name=%s",
                     EosFuse::dump(id, ino, 0, rc).c_str(),
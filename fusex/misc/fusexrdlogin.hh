@@ -26,11 +26,15 @@
 #ifndef FUSE_XRDLOGIN_HH_
 #define FUSE_XRDLOGIN_HH_
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <vector>
 #include "XrdCl/XrdClURL.hh"
 #include "llfusexx.hh"
 #include "auth/AuthenticationGroup.hh"
 #include "auth/ProcessCache.hh"
+#include "misc/ConnectionWarmer.hh"
 
 class fusexrdlogin
 {
@@ -55,9 +59,27 @@ public:
   static std::string environment(fuse_req_t req);
 
   static void initializeProcessCache(const CredentialConfig& config);
+  static void stopConnectionWarmer();
   static std::unique_ptr<AuthenticationGroup> authGroup;
   static ProcessCache* processCache; // owned by authGroup
+  static std::unique_ptr<ConnectionWarmer> connectionWarmer;
+  static unsigned connectionPool;
 private:
+  //----------------------------------------------------------------------------
+  //! Get the login of the given connection of an identity - connection 0 and
+  //! identities without strong credentials always use their primary login
+  //!
+  //! @param allocated filled with the pooled logins if they were just created
+  //----------------------------------------------------------------------------
+  static std::string pooledLogin(const BoundIdentity& identity,
+                                 int connectionid,
+                                 std::vector<std::string>& allocated);
+
+  //! Maximum number of identities with pooled logins
+  static constexpr size_t kMaxPools = 4096;
+  static std::mutex poolMutex;
+  //! Extra logins by primary login
+  static std::map<std::string, std::vector<std::string>> loginPools;
 };
 
 
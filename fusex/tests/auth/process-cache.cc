@@ -68,6 +68,74 @@ TEST_F(Krb5AuthF, UnixFallback)
   ASSERT_EQ(snapshot->getXrdCreds(), "xrd.wantprot=unix");
 }
 
+TEST_F(Krb5AuthF, NoSessionReuse)
+{
+  injectProcess(1234, 1, 1234, 1234, 9999, 0);
+  securityChecker()->inject(localJail().id, "/tmp/my-creds", 1000, 0400, 1);
+  environmentReader()->inject(1234, createEnv("/tmp/my-creds", ""));
+  ProcessSnapshot snapshot = processCache()->retrieve(1234, 1000, 1000, false);
+  ASSERT_EQ(snapshot->getXrdLogin(), LoginIdentifier(1).getStringID());
+  // Same session, but its own (empty) environment is used
+  injectProcess(1240, 1, 1240, 1234, 9999, 0);
+  snapshot = processCache()->retrieve(1240, 1000, 1000, false);
+  ASSERT_EQ(snapshot->getXrdLogin(), LoginIdentifier(1000, 1000, 1240,
+            0).getStringID());
+  ASSERT_EQ(processCache()->getSessionHits(), 0u);
+  ASSERT_EQ(processCache()->getSessionCacheSize(), 0u);
+}
+
+TEST_F(Krb5SessionAuthF, SessionReuse)
+{
+  eos::common::SteadyClock clock(true);
+  processCache()->setClock(&clock);
+  injectProcess(1234, 1, 1234, 1234, 9999, 0);
+  securityChecker()->inject(localJail().id, "/tmp/my-creds", 1000, 0400, 1);
+  environmentReader()->inject(1234, createEnv("/tmp/my-creds", ""));
+  ProcessSnapshot snapshot = processCache()->retrieve(1234, 1000, 1000, false);
+  ASSERT_EQ(snapshot->getXrdLogin(), LoginIdentifier(1).getStringID());
+  ASSERT_EQ(processCache()->getSessionMisses(), 1u);
+  ASSERT_EQ(processCache()->getSessionCacheSize(), 1u);
+  // A child of the session without credentials in its environment
+  injectProcess(1240, 1, 1240, 1234, 9999, 0);
+  snapshot = processCache()->retrieve(1240, 1000, 1000, false);
+  ASSERT_EQ(snapshot->getXrdLogin(), LoginIdentifier(1).getStringID());
+  ASSERT_EQ(snapshot->getXrdCreds(),
+            "xrd.k5ccname=/tmp/my-creds&xrd.wantprot=krb5,unix&xrdcl.secgid=1000&xrdcl.secuid=1000");
+  ASSERT_EQ(processCache()->getSessionHits(), 1u);
+  // Other uid, or other session
+  injectProcess(1241, 1, 1241, 1234, 9999, 0);
+  snapshot = processCache()->retrieve(1241, 1001, 1000, false);
+  ASSERT_EQ(snapshot->getXrdLogin(), LoginIdentifier(1001, 1000, 1241,
+            0).getStringID());
+  injectProcess(1242, 1, 1242, 1242, 9999, 0);
+  snapshot = processCache()->retrieve(1242, 1000, 1000, false);
+  ASSERT_EQ(snapshot->getXrdLogin(), LoginIdentifier(1000, 1000, 1242,
+            0).getStringID());
+  ASSERT_EQ(processCache()->getSessionHits(), 1u);
+  ASSERT_EQ(processCache()->getSessionMisses(), 3u);
+  // Credential file modified
+  securityChecker()->inject(localJail().id, "/tmp/my-creds", 1000, 0400, 2);
+  injectProcess(1243, 1, 1243, 1234, 9999, 0);
+  snapshot = processCache()->retrieve(1243, 1000, 1000, false);
+  ASSERT_EQ(snapshot->getXrdLogin(), LoginIdentifier(1000, 1000, 1243,
+            0).getStringID());
+  ASSERT_EQ(processCache()->getSessionRevalidations(), 1u);
+  // The session leader finds the new credentials, reused until the
+  // revalidation interval is over
+  snapshot = processCache()->retrieve(1234, 1000, 1000, false);
+  ASSERT_EQ(snapshot->getXrdLogin(), LoginIdentifier(2).getStringID());
+  injectProcess(1244, 1, 1244, 1234, 9999, 0);
+  snapshot = processCache()->retrieve(1244, 1000, 1000, false);
+  ASSERT_EQ(snapshot->getXrdLogin(), LoginIdentifier(2).getStringID());
+  clock.advance(std::chrono::seconds(61));
+  injectProcess(1245, 1, 1245, 1234, 9999, 0);
+  snapshot = processCache()->retrieve(1245, 1000, 1000, false);
+  ASSERT_EQ(snapshot->getXrdLogin(), LoginIdentifier(1000, 1000, 1245,
+            0).getStringID());
+  ASSERT_EQ(processCache()->getSessionHits(), 2u);
+  ASSERT_EQ(processCache()->getSessionRevalidations(), 3u);
+}
+
 TEST(UserCredentialFactory, BothKrb5AndX509) {
   CredentialConfig config;
   config.use_user_krb5cc = true;
@@ -80,6 +80,15 @@ public:
     return config;
   }
 
+  //----------------------------------------------------------------------------
+  // Make kerberos-only configuration, reusing the credentials of the session
+  //----------------------------------------------------------------------------
+  static CredentialConfig makeKrb5SessionConfig() {
+    CredentialConfig config = makeKrb5Config();
+    config.session_cache_revalidation = 60;
+    return config;
+  }
+
   //----------------------------------------------------------------------------
   // Inject fake process with given properties
   //----------------------------------------------------------------------------
@@ -125,4 +134,12 @@ public:
   Krb5AuthF() : AuthenticationFixture(makeKrb5Config()) {}
 };
 
+//------------------------------------------------------------------------------
+// krb5 authentication fixture with the session cache enabled
+//------------------------------------------------------------------------------
+class Krb5SessionAuthF : public AuthenticationFixture, public ::testing::Test {
+public:
+  Krb5SessionAuthF() : AuthenticationFixture(makeKrb5SessionConfig()) {}
+};
+
 #endif
@@ -0,0 +1,94 @@
+//------------------------------------------------------------------------------
+//! @file connection-warmer.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fusex/misc/ConnectionWarmer.hh"
+#include "gtest/gtest.h"
+#include <thread>
+
+TEST(ConnectionWarmer, MakeUrl)
+{
+  XrdCl::URL::ParamsMap params;
+  params["xrd.k5ccname"] = "/tmp/krb5cc_1000";
+  params["fuse.pid"] = "123";
+  params["xrdcl.secuid"] = "1000";
+  ASSERT_EQ("root://AAAAAAAB@eos.cern.ch:1094//"
+            "?xrd.k5ccname=/tmp/krb5cc_1000&xrdcl.secuid=1000",
+            ConnectionWarmer::makeUrl("eos.cern.ch:1094", "AAAAAAAB", params));
+  ASSERT_EQ("root://nobody@eos.cern.ch:1094//",
+            ConnectionWarmer::makeUrl("eos.cern.ch:1094", "nobody", {}));
+}
+
+TEST(ConnectionWarmer, PingAndRewarm)
+{
+  std::vector<std::string> pinged;
+  ConnectionWarmer warmer(std::chrono::seconds(600), 1,
+  [&pinged](const std::string & url) {
+    pinged.push_back(url);
+    return (url.find("fail") == std::string::npos);
+  });
+  warmer.seen("mgm:1094", "AAAAAAAB", {});
+  warmer.seen("mgm:1094", "AAAAAAAB", {});
+  warmer.seen("mgm:1094", "fail", {});
+  ASSERT_EQ(2u, warmer.size());
+  ASSERT_TRUE(warmer.pingOne());
+  ASSERT_TRUE(warmer.pingOne());
+  ASSERT_FALSE(warmer.pingOne());
+  ASSERT_EQ(2u, pinged.size());
+  ASSERT_EQ(1u, warmer.getWarmed());
+  ASSERT_EQ(1u, warmer.getFailed());
+  // Nothing is due again before the rewarm interval
+  auto now = std::chrono::steady_clock::now();
+  warmer.scan(now);
+  ASSERT_FALSE(warmer.pingOne());
+  warmer.scan(now + ConnectionWarmer::kRewarmInterval);
+  ASSERT_TRUE(warmer.pingOne());
+  ASSERT_TRUE(warmer.pingOne());
+  ASSERT_FALSE(warmer.pingOne());
+  ASSERT_EQ(4u, pinged.size());
+  // Logins not seen within the window are forgotten
+  warmer.scan(now + std::chrono::seconds(601));
+  ASSERT_EQ(0u, warmer.size());
+  ASSERT_FALSE(warmer.pingOne());
+}
+
+TEST(ConnectionWarmer, BackgroundThreads)
+{
+  std::atomic<int> pings {0};
+  ConnectionWarmer warmer(std::chrono::seconds(600), 2,
+  [&pings](const std::string & url) {
+    pings++;
+    return true;
+  });
+  warmer.start();
+
+  for (int i = 0; i < 10; ++i) {
+    warmer.seen("mgm:1094", "login" + std::to_string(i), {});
+  }
+
+  for (int i = 0; (i < 500) && (warmer.getWarmed() < 10); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  warmer.stop();
+  ASSERT_EQ(10u, warmer.getWarmed());
+  ASSERT_EQ(10, pings);
+}
@@ -0,0 +1,180 @@
+/*
+ * interval-vector.cc
+ *
+ ************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <random>
+#include "fusex/data/interval_tree.hh"
+#include "fusex/data/interval_vector.hh"
+#include "gtest/gtest.h"
+
+TEST(IntervalVector, Querying)
+{
+  interval_vector<int, std::string> tree;
+  tree.insert(5, 10, "(5, 10)");
+  tree.insert(1, 12, "(1, 12)");
+  tree.insert(2, 8, "(2, 8)");
+  tree.insert(15, 25, "(15, 25)");
+  tree.insert(8, 16, "(8, 16)");
+  tree.insert(14, 20, "(14, 20)");
+  tree.insert(18, 21, "(18, 21)");
+  auto result = tree.query(26, 28);
+  ASSERT_EQ(result.size(), 0);
+  result = tree.query(12, 14);
+  ASSERT_EQ(result.size(), 1);
+  result = tree.query(10, 12);
+  ASSERT_EQ(result.size(), 2);
+  result = tree.query(18, 19);
+  ASSERT_EQ(result.size(), 3);
+  result = tree.query(6, 9);
+  ASSERT_EQ(result.size(), 4);
+  result = tree.query(7, 15);
+  ASSERT_EQ(result.size(), 5);
+  result = tree.query(6, 16);
+  ASSERT_EQ(result.size(), 6);
+  result = tree.query(0, 26);
+  ASSERT_EQ(result.size(), 7);
+  ASSERT_EQ(result[0]->value, "(1, 12)");
+  ASSERT_EQ(result[6]->value, "(18, 21)");
+}
+
+TEST(IntervalVector, SameAsIntervalTree)
+{
+  // random overlapping intervals, enough to split and join pages
+  interval_tree<int, int> tree;
+  interval_vector<int, int> vec;
+  std::list< std::pair<int, int> > intervals;
+  std::mt19937 gen(42);
+
+  for (int i = 0; i < 20000; ++i) {
+    int l = gen() % 100000;
+    int h = l + gen() % 200 + 1;
+    tree.insert(l, h, i);
+    vec.insert(l, h, i);
+    intervals.push_back(std::make_pair(l, h));
+  }
+
+  for (int i = 0; i < 15000; ++i) {
+    auto itr = intervals.begin();
+    std::advance(itr, gen() % intervals.size());
+    tree.erase(itr->first, itr->second);
+    vec.erase(itr->first, itr->second);
+    intervals.erase(itr);
+  }
+
+  ASSERT_EQ(tree.size(), vec.size());
+  auto titr = tree.begin();
+  auto vitr = vec.begin();
+
+  for (; titr != tree.end(); ++titr, ++vitr) {
+    ASSERT_TRUE(vitr != vec.end());
+    ASSERT_EQ(titr->low, vitr->low);
+    ASSERT_EQ(titr->high, vitr->high);
+    ASSERT_EQ(titr->value, vitr->value);
+  }
+
+  ASSERT_TRUE(vitr == vec.end());
+
+  for (int i = 0; i < 2000; ++i) {
+    int l = gen() % 100500;
+    int h = l + gen() % 1000;
+    auto tres = tree.query(l, h);
+    auto vres = vec.query(l, h);
+    ASSERT_EQ(tres.size(), vres.size());
+    auto vq = vres.begin();
+
+    for (auto tq : tres) {
+      ASSERT_EQ(tq->low, (*vq)->low);
+      ASSERT_EQ(tq->value, (*vq)->value);
+      ++vq;
+    }
+  }
+}
+
+TEST(IntervalVector, Extend)
+{
+  interval_vector<uint64_t, uint64_t> journal;
+  journal.insert(0, 10, 0);
+  journal.insert(20, 30, 100);
+  ASSERT_FALSE(journal.extend(0, 5, 15));
+  ASSERT_TRUE(journal.extend(0, 10, 15));
+  ASSERT_EQ(journal.size(), 2);
+  auto result = journal.query(12, 13);
+  ASSERT_EQ(result.size(), 1);
+  ASSERT_EQ(result[0]->high, 15);
+  ASSERT_EQ(result[0]->value, 0);
+  ASSERT_TRUE(journal.query(15, 20).empty());
+  journal.clear();
+  ASSERT_TRUE(journal.empty());
+  ASSERT_TRUE(journal.begin() == journal.end());
+  ASSERT_TRUE(journal.query(0, 100).empty());
+}
+
+namespace
+{
+template<typename T>
+double Benchmark(T& journal, const std::vector<uint64_t>& chunks)
+{
+  auto start = std::chrono::steady_clock::now();
+  uint64_t sum = 0;
+
+  // fill the journal like a random write pattern and then read it back
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    journal.insert(chunks[i] * 4096, chunks[i] * 4096 + 4096, i);
+  }
+
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    for (auto& itr : journal.query(chunks[i] * 4096 + 100, chunks[i] * 4096 +
+                                   8192)) {
+      sum += itr->value;
+    }
+  }
+
+  for (auto itr = journal.begin(); itr != journal.end(); ++itr) {
+    sum += itr->high - itr->low;
+  }
+
+  journal.clear();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() -
+                                          start;
+  return sum ? elapsed.count() : 0;
+}
+}
+
+TEST(IntervalVector, Benchmark)
+{
+  std::vector<uint64_t> chunks(100000);
+
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    chunks[i] = i;
+  }
+
+  std::shuffle(chunks.begin(), chunks.end(), std::mt19937(42));
+  interval_tree<uint64_t, uint64_t> tree;
+  interval_vector<uint64_t, uint64_t> vec;
+  double tree_sec = Benchmark(tree, chunks);
+  double vec_sec = Benchmark(vec, chunks);
+  std::cout << "100k journal chunks: interval_tree " << tree_sec
+            << "s interval_vector " << vec_sec << "s" << std::endl;
+  ASSERT_GT(tree_sec, 0);
+  ASSERT_GT(vec_sec, 0);
+}
@@ -123,6 +123,48 @@ TEST(JournalCache, BasicSanity)
   ASSERT_EQ(rc, (int64_t) truncsize);
 }
 
+TEST(JournalCache, SequentialAppend)
+{
+  std::string input = TestData::input;
+  uint64_t chunk_size = 512;
+  cacheconfig config;
+  config.journal = "/tmp/";
+  config.location = "/tmp/";
+  config.per_file_journal_max_size = 0;
+  config.per_file_max_inflight_write_buffer_size = 0;
+  journalcache::init(config);
+  journalcache jc(6);
+  std::string cookie = "";
+  fuse_req_t req;
+  req = 0;
+  int64_t rc = jc.attach(req, cookie, true);
+  ASSERT_EQ(rc, 0);
+  ASSERT_FALSE(jc.reset());
+
+  for (uint64_t offset = 0; offset < input.size(); offset += chunk_size) {
+    size_t size = std::min(chunk_size, input.size() - offset);
+    rc = jc.pwrite(input.c_str() + offset, size, offset);
+    ASSERT_EQ(rc, (int64_t) size);
+  }
+
+  // all the appends end up in a single journal record
+  auto chunks = jc.get_chunks(0, input.size());
+  ASSERT_EQ(chunks.size(), 1u);
+  ASSERT_EQ(input, std::string(reinterpret_cast<const char*>(chunks[0].buff),
+                               chunks[0].size));
+  // the extended record survives reading back the journal
+  rc = jc.detach(cookie);
+  ASSERT_FALSE(rc);
+  journalcache jc2(6);
+  rc = jc2.attach(req, cookie, true);
+  ASSERT_FALSE(rc);
+  std::vector<char> buffer(input.size());
+  rc = jc2.pread(buffer.data(), input.size(), 0);
+  ASSERT_EQ(rc, (int64_t) input.size());
+  ASSERT_EQ(input, std::string(buffer.begin(), buffer.end()));
+  ASSERT_EQ(jc2.get_chunks(0, input.size()).size(), 1u);
+}
+
 const std::string TestData::input =
   "Miusov, as a man man of breeding and deilcacy, could not but feel some inwrd qualms, when he reached the Father Superior's with Ivan: he felt ashamed of havin lost his temper. He felt that he ought to have disdaimed that despicable wretch, Fyodor Pavlovitch, too much to have been upset by him in Father Zossima's cell, and so to have forgotten himself. \"Teh monks were not to blame, in any case,\" he reflceted, on the steps. \"And if they're decent people here (and the Father Superior, I understand, is a nobleman) why not be friendly and courteous withthem? I won't argue, I'll fall in with everything, I'll win them by politness, and show them that I've nothing to do with that Aesop, thta buffoon, that Pierrot, and have merely been takken in over this affair, just as they have.\""
   "He determined to drop his litigation with the monastry, and relinguish his claims to the wood-cuting and fishery rihgts at once. He was the more ready to do this becuase the rights had becom much less valuable, and he had indeed the vaguest idea where the wood and river in quedtion were."
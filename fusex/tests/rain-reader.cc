@@ -0,0 +1,69 @@
+//------------------------------------------------------------------------------
+//! @file rain-reader.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fusex/data/rainreader.hh"
+#include "gtest/gtest.h"
+
+using XrdCl::RainReader;
+
+TEST(RainReader, Split)
+{
+  const uint64_t width = 64 * 1024;
+  std::vector<RainReader::piece_t> pieces;
+  // read crossing a line of 4 data stripes
+  RainReader::Split(3 * width + 10, 2 * width, 4, width, pieces);
+  ASSERT_EQ(3u, pieces.size());
+  ASSERT_EQ(3u, pieces[0].stripe);
+  ASSERT_EQ(10u, pieces[0].local_offset);
+  ASSERT_EQ(width - 10, pieces[0].size);
+  ASSERT_EQ(0u, pieces[0].buffer_offset);
+  ASSERT_EQ(0u, pieces[1].stripe);
+  ASSERT_EQ(width, pieces[1].local_offset);
+  ASSERT_EQ(width, pieces[1].size);
+  ASSERT_EQ(width - 10, pieces[1].buffer_offset);
+  ASSERT_EQ(1u, pieces[2].stripe);
+  ASSERT_EQ(width, pieces[2].local_offset);
+  ASSERT_EQ(10u, pieces[2].size);
+  // pieces of one stripe are contiguous in the stripe file
+  RainReader::Split(width / 2, 9 * width, 4, width, pieces);
+  std::vector<uint64_t> next(4, 0);
+  std::vector<bool> seen(4, false);
+  uint64_t total = 0;
+
+  for (auto& piece : pieces) {
+    if (seen[piece.stripe]) {
+      ASSERT_EQ(next[piece.stripe], piece.local_offset);
+    }
+
+    seen[piece.stripe] = true;
+    next[piece.stripe] = piece.local_offset + piece.size;
+    ASSERT_EQ(total, piece.buffer_offset);
+    total += piece.size;
+  }
+
+  ASSERT_EQ(9 * width, total);
+  // reads inside a single block
+  RainReader::Split(5 * width + 1, 100, 4, width, pieces);
+  ASSERT_EQ(1u, pieces.size());
+  ASSERT_EQ(1u, pieces[0].stripe);
+  ASSERT_EQ(width + 1, pieces[0].local_offset);
+}
@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------------
+//! @file sharded-map.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fusex/misc/ShardedMap.hh"
+#include "gtest/gtest.h"
+#include <thread>
+
+TEST(ShardedMap, BasicSanity)
+{
+  ShardedMap<int, 8> map;
+  int val = 0;
+  ASSERT_FALSE(map.retrieveTS(1, val));
+  map.insertTS(1, 10);
+  map.insertTS(2, 20);
+  ASSERT_TRUE(map.retrieveTS(1, val));
+  ASSERT_EQ(10, val);
+  ASSERT_TRUE(map.countTS(2));
+  ASSERT_EQ(2u, map.size());
+  ASSERT_TRUE(map.eraseTS(1));
+  ASSERT_FALSE(map.eraseTS(1));
+  ASSERT_EQ(1u, map.size());
+  // unlinked alias of an inode stays in the same shard
+  ASSERT_EQ(ShardedMap<int>::ShardIndex(12345),
+            ShardedMap<int>::ShardIndex(12345 + 0xffffffffull));
+}
+
+TEST(ShardedMap, Snapshot)
+{
+  typedef ShardedMap<int, 4> SmallMap;
+  SmallMap map;
+
+  for (uint64_t ino = 1; ino <= 1000; ++ino) {
+    map.insertTS(ino, (int) ino);
+  }
+
+  size_t total = 0;
+
+  for (size_t i = 0; i < SmallMap::kNumShards; ++i) {
+    std::vector<std::pair<uint64_t, int>> entries;
+    map.snapshotTS(i, entries);
+    ASSERT_GT(entries.size(), 0u);
+
+    for (const auto& elem : entries) {
+      ASSERT_EQ(i, SmallMap::ShardIndex(elem.first));
+      ASSERT_EQ((int) elem.first, elem.second);
+    }
+
+    total += entries.size();
+  }
+
+  ASSERT_EQ(1000u, total);
+}
+
+TEST(ShardedMap, Concurrency)
+{
+  ShardedMap<uint64_t> map;
+  std::vector<std::thread> workers;
+
+  for (uint64_t t = 0; t < 8; ++t) {
+    workers.emplace_back([&map, t]() {
+      for (uint64_t i = 0; i < 10000; ++i) {
+        uint64_t ino = t * 100000 + i;
+        map.insertTS(ino, ino);
+        uint64_t val = 0;
+        ASSERT_TRUE(map.retrieveTS(ino, val));
+        ASSERT_EQ(ino, val);
+
+        if (i % 2) {
+          ASSERT_TRUE(map.eraseTS(ino));
+        }
+      }
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  ASSERT_EQ(8u * 5000, map.size());
+}
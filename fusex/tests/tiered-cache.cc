@@ -0,0 +1,156 @@
+//------------------------------------------------------------------------------
+// File: tiered-cache.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fusex/data/tieredcache.hh"
+#include "fusex/data/memorycache.hh"
+#include "gtest/gtest.h"
+
+static const size_t kBlock = tieredcache::kBlockSize;
+
+static std::string pattern(size_t size, char seed)
+{
+  std::string data(size, 0);
+
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = (char)(seed + (i % 251));
+  }
+
+  return data;
+}
+
+//------------------------------------------------------------------------------
+// Memory-only cache stays contiguous when the budget is exhausted
+//------------------------------------------------------------------------------
+TEST(TieredCache, MemoryBudget)
+{
+  tieredcache::clock().configure(4 * kBlock);
+  {
+    tieredcache tc(1);
+    std::string data = pattern(6 * kBlock + 100, 'a');
+    ASSERT_EQ((ssize_t) data.size(), tc.pwrite(data.c_str(), data.size(), 0));
+    ASSERT_EQ(4 * kBlock, tc.size());
+    ASSERT_EQ(4 * kBlock, tieredcache::clock().used());
+    std::string out(data.size(), 0);
+    ASSERT_EQ((ssize_t)(4 * kBlock), tc.pread((char*) out.c_str(), out.size(), 0));
+    ASSERT_EQ(0, memcmp(out.c_str(), data.c_str(), 4 * kBlock));
+    // truncate inside of a block
+    ASSERT_EQ(0, tc.truncate(kBlock + 10));
+    ASSERT_EQ(kBlock + 10, tc.size());
+    ASSERT_EQ(2 * kBlock, tieredcache::clock().used());
+    // writing behind the end fills the hole with zeros
+    ASSERT_EQ(1, tc.pwrite("x", 1, 2 * kBlock));
+    ASSERT_EQ(2 * kBlock + 1, tc.size());
+    char c = 1;
+    ASSERT_EQ(1, tc.pread(&c, 1, kBlock + 10));
+    ASSERT_EQ(0, c);
+  }
+  ASSERT_EQ(0u, tieredcache::clock().used());
+  ASSERT_EQ(0u, tieredcache::clock().blocks());
+}
+
+//------------------------------------------------------------------------------
+// Blocks of all inodes are evicted by a single clock with second chance
+//------------------------------------------------------------------------------
+TEST(TieredCache, ClockEviction)
+{
+  tieredcache::clock().configure(4 * kBlock);
+  uint64_t evicted = tieredcache::clock().evicted();
+  std::string data = pattern(2 * kBlock, 'b');
+  tieredcache a(1);
+  tieredcache b(2);
+  tieredcache c(3);
+  tieredcache d(4);
+  ASSERT_EQ((ssize_t) data.size(), a.pwrite(data.c_str(), data.size(), 0));
+  ASSERT_EQ((ssize_t) data.size(), b.pwrite(data.c_str(), data.size(), 0));
+  // all blocks had a second chance, the oldest file loses its blocks
+  ASSERT_EQ((ssize_t) kBlock, c.pwrite(data.c_str(), kBlock, 0));
+  ASSERT_EQ(0u, a.size());
+  ASSERT_EQ(2 * kBlock, b.size());
+  ASSERT_EQ(kBlock, c.size());
+  ASSERT_EQ(evicted + 2, tieredcache::clock().evicted());
+  // a referenced block survives the next pass of the hand
+  char buf[16];
+  ASSERT_EQ(16, b.pread(buf, sizeof(buf), 0));
+  ASSERT_EQ((ssize_t) data.size(), d.pwrite(data.c_str(), data.size(), 0));
+  ASSERT_EQ(kBlock, b.size());
+  ASSERT_EQ(kBlock, c.size());
+  ASSERT_EQ(2 * kBlock, d.size());
+  ASSERT_EQ(4 * kBlock, tieredcache::clock().used());
+}
+
+//------------------------------------------------------------------------------
+// Memory used by other buffers reduces the budget
+//------------------------------------------------------------------------------
+TEST(TieredCache, ExternalUsage)
+{
+  uint64_t external = 3 * kBlock;
+  tieredcache::clock().configure(4 * kBlock, [&external]() -> uint64_t {
+    return external;
+  });
+  tieredcache tc(1);
+  std::string data = pattern(4 * kBlock, 'c');
+  ASSERT_EQ((ssize_t) data.size(), tc.pwrite(data.c_str(), data.size(), 0));
+  ASSERT_EQ(kBlock, tc.size());
+  external = 0;
+  ASSERT_EQ((ssize_t) data.size(), tc.pwrite(data.c_str(), data.size(), 0));
+  ASSERT_EQ(4 * kBlock, tc.size());
+  tieredcache::clock().configure(0);
+}
+
+//------------------------------------------------------------------------------
+// With a lower tier the data stays complete and blocks are read back from it
+//------------------------------------------------------------------------------
+TEST(TieredCache, LowerTier)
+{
+  tieredcache::clock().configure(2 * kBlock);
+  {
+    tieredcache tc(1, new memorycache(1));
+    std::string data = pattern(4 * kBlock + 10, 'd');
+    ASSERT_EQ((ssize_t) data.size(), tc.pwrite(data.c_str(), data.size(), 0));
+    ASSERT_EQ(data.size(), tc.size());
+    // writes go through, nothing is cached yet
+    ASSERT_EQ(0u, tieredcache::clock().used());
+    std::string out(data.size(), 0);
+
+    for (int i = 0; i < 2; ++i) {
+      ASSERT_EQ((ssize_t) data.size(), tc.pread((char*) out.c_str(), out.size(),
+                0));
+      ASSERT_EQ(data, out);
+      ASSERT_EQ(2 * kBlock, tieredcache::clock().used());
+    }
+
+    // updates of cached blocks are visible
+    ASSERT_LT(0, tc.pwrite("z", 1, 4 * kBlock));
+    char c = 0;
+    ASSERT_EQ(1, tc.pread(&c, 1, 4 * kBlock));
+    ASSERT_EQ('z', c);
+    ASSERT_EQ(0, tc.truncate(kBlock));
+    ASSERT_EQ(kBlock, tc.size());
+    ASSERT_EQ(0, tc.pread(&c, 1, kBlock));
+    ASSERT_EQ(0, tc.set_attr("user.eos.cache.cookie", "abc"));
+    std::string cookie;
+    ASSERT_EQ(0, tc.cookie(cookie));
+    ASSERT_EQ("abc", cookie);
+  }
+  ASSERT_EQ(0u, tieredcache::clock().used());
+  tieredcache::clock().configure(0);
+}
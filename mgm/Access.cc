@@ -81,6 +81,9 @@ std::map<gid_t, std::string> Access::gGroupRedirection;
 //! global rw mutex protecting all static singletons
 eos::common::RWMutex Access::gAccessMutex;
 
+//! token buckets of the user and group rate rules
+RateLimiter Access::gRateLimiter;
+
 /*----------------------------------------------------------------------------*/
 //! constant used in the configuration store
 const char* Access::gUserKey = "BanUsers";
@@ -137,6 +140,7 @@ Access::Reset(bool skip_stall_redirect)
     Access::gGroupRedirection.clear();
     Access::gStallGlobal = Access::gStallRead =
                              Access::gStallWrite = Access::gStallUserGroup = false;
+    UpdateRateLimiter();
   }
 }
 
@@ -288,6 +292,7 @@ Access::ApplyAccessConfig(bool applyredirectandstall)
       }
     }
 
+    UpdateRateLimiter();
     tokens.clear();
     delimiter = ",";
     eos::common::StringConversion::Tokenize(redirect, tokens, delimiter);
@@ -419,6 +424,8 @@ Access::StoreAccessConfig()
     }
   }
 
+  UpdateRateLimiter();
+
   for (itredirect = Access::gRedirectionRules.begin();
        itredirect != Access::gRedirectionRules.end(); itredirect++) {
     redirect += itredirect->first.c_str();
@@ -590,6 +597,19 @@ Access::RemoveStallRule(const std::string& key)
 {
   eos::common::RWMutexWriteLock wr_lock(Access::gAccessMutex);
   Access::gStallRules.erase(key);
+
+  if (key.find("rate:") == 0) {
+    UpdateRateLimiter();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Apply the rate rules from gStallRules to the rate limiter
+//------------------------------------------------------------------------------
+void
+Access::UpdateRateLimiter()
+{
+  gRateLimiter.Configure(gStallRules);
 }
 
 EOSMGMNAMESPACE_END
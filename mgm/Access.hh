@@ -31,6 +31,7 @@
 #include "mgm/Namespace.hh"
 #include "common/RWMutex.hh"
 #include "common/Mapping.hh"
+#include "mgm/RateLimiter.hh"
 #include <map>
 #include <vector>
 #include <string>
@@ -154,6 +155,10 @@ public:
   //! global rw mutex protecting all static set's and maps in Access
   static eos::common::RWMutex gAccessMutex;
 
+  //! token buckets enforcing the user and group rate rules, synchronized
+  //! internally and reconfigured whenever the stall rules change
+  static RateLimiter gRateLimiter;
+
   //----------------------------------------------------------------------------
   //! Struct holding stall info
   //----------------------------------------------------------------------------
@@ -231,6 +236,12 @@ public:
   //----------------------------------------------------------------------------
   static void RemoveStallRule(const std::string& key);
 
+private:
+  //----------------------------------------------------------------------------
+  //! Apply the rate rules from gStallRules to the rate limiter. Has to be
+  //! called with the gAccessMutex held.
+  //----------------------------------------------------------------------------
+  static void UpdateRateLimiter();
 };
 
 EOSMGMNAMESPACE_END
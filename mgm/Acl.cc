@@ -24,7 +24,11 @@
 #include "mgm/Egroup.hh"
 #include "mgm/XrdMgmOfs.hh"
 #include "common/StringConversion.hh"
+#include <algorithm>
+#include <array>
+#include <mutex>
 #include <regex.h>
+#include <unordered_map>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -97,26 +101,193 @@ if (EOS_LOGS_DEBUG) eos_static_debug("sysacl='%s' useracl='%s' evalUseracl=%d",
 }
 
 //------------------------------------------------------------------------------
-// Set the contents of an ACL and compute the canXX and hasXX booleans.
+//! Acl definitions compiled into rules which can be matched without parsing
 //------------------------------------------------------------------------------
-void
-Acl::Set(std::string sysacl, std::string useracl,
-         const eos::common::Mapping::VirtualIdentity& vid, bool allowUserAcl)
+struct Acl::CompiledAcl {
+  //----------------------------------------------------------------------------
+  //! Permission character of a rule with its '!' and '+' modifiers
+  //----------------------------------------------------------------------------
+  struct Perm {
+    char mChar; ///< permission character, 'w' also for 'wo'
+    bool mWriteOnce; ///< 'wo' permission
+    bool mDeny; ///< preceded by '!'
+    bool mReallow; ///< preceded by '+'
+  };
+
+  struct Rule {
+    enum class Type {
+      kNone, kUser, kGroup, kKey, kEgroup, kZ
+    };
+
+    Type mType = Type::kNone;
+    std::string mRaw; ///< Rule as defined e.g. u:1234:rwx
+    std::string mId; ///< uid/username, gid/groupname or egroup of the rule
+    bool mValid = false; ///< rule defines permissions
+    bool mInSysAcl = false; ///< rule is part of the sys.acl
+    size_t mEgroupIndex = 0; ///< index of the egroup among mEgroups
+    std::vector<Perm> mPerms;
+  };
+
+  std::vector<Rule> mRules;
+  std::vector<std::string> mEgroups; ///< egroups referenced by the rules
+};
+
+//------------------------------------------------------------------------------
+// Compile the given acl definitions
+//------------------------------------------------------------------------------
+std::shared_ptr<Acl::CompiledAcl>
+Acl::Compile(const std::string& sysacl, const std::string& useracl)
 {
-  std::string acl = "";
+  using Rule = CompiledAcl::Rule;
+  auto compiled = std::make_shared<CompiledAcl>();
+  std::string acl = sysacl;
 
-  if (sysacl.length()) {
-    acl += sysacl;
+  if (useracl.length()) {
+    if (sysacl.length()) {
+      acl += ",";
+    }
+
+    acl += useracl;
   }
 
-  if (allowUserAcl) {
-    if (useracl.length()) {
-      if (sysacl.length()) {
-        acl += ",";
+  std::vector<std::string> rules;
+  eos::common::StringConversion::Tokenize(acl, rules, ",");
+  compiled->mRules.reserve(rules.size());
+
+  for (const auto& raw : rules) {
+    Rule rule;
+    rule.mRaw = raw;
+    std::vector<std::string> entry;
+    eos::common::StringConversion::Tokenize(raw, entry, ":");
+
+    if (!raw.compare(0, strlen("egroup:"), "egroup:")) {
+      rule.mType = Rule::Type::kEgroup;
+
+      if (entry.size() >= 3) {
+        rule.mId = entry[1];
+      }
+    } else if (!raw.compare(0, strlen("z:"), "z:")) {
+      rule.mType = Rule::Type::kZ;
+    } else if (!raw.compare(0, strlen("k:"), "k:")) {
+      rule.mType = Rule::Type::kKey;
+    } else if (!raw.compare(0, strlen("u:"), "u:") ||
+               !raw.compare(0, strlen("g:"), "g:")) {
+      // The rule matches the tag u:<id>: or g:<id>: of the vid
+      size_t pos = raw.find(':', 2);
+
+      if (pos != std::string::npos) {
+        rule.mType = (raw[0] == 'u' ? Rule::Type::kUser : Rule::Type::kGroup);
+        rule.mId = raw.substr(2, pos - 2);
+      }
+    }
+
+    std::string perms;
+
+    if (entry.size() >= 3) {
+      perms = entry[2];
+      rule.mValid = true;
+    } else if ((rule.mType == Rule::Type::kZ) && (entry.size() >= 2)) {
+      // z tag entries have only two fields
+      perms = entry[1];
+      rule.mValid = true;
+    }
+
+    if (!rule.mValid) {
+      continue;
+    }
+
+    if (rule.mType == Rule::Type::kEgroup) {
+      auto it = std::find(compiled->mEgroups.begin(), compiled->mEgroups.end(),
+                          rule.mId);
+      rule.mEgroupIndex = it - compiled->mEgroups.begin();
+
+      if (it == compiled->mEgroups.end()) {
+        compiled->mEgroups.push_back(rule.mId);
+      }
+    }
+
+    rule.mInSysAcl = (sysacl.find(raw) != std::string::npos);
+    bool deny = false, reallow = false;
+
+    for (size_t i = 0; i < perms.length(); ++i) {
+      char c = perms[i];
+
+      if (c == '!') {
+        deny = true;
+        continue;
       }
 
-      acl += useracl;
+      if (c == '+') {
+        reallow = true;
+        continue;
+      }
+
+      bool write_once = ((c == 'w') && (i + 1 < perms.length()) &&
+                         (perms[i + 1] == 'o'));
+
+      if (write_once) {
+        ++i;
+      }
+
+      rule.mPerms.push_back({c, write_once, deny, reallow});
+      deny = reallow = false;
     }
+
+    compiled->mRules.push_back(std::move(rule));
+  }
+
+  return compiled;
+}
+
+//------------------------------------------------------------------------------
+// Get the compiled form of the given acl definitions from the cache
+//------------------------------------------------------------------------------
+std::shared_ptr<const Acl::CompiledAcl>
+Acl::GetCompiled(const std::string& sysacl, const std::string& useracl)
+{
+  // The cache is keyed by the acl definitions themselves, so that a change of
+  // the acl attributes simply maps to another entry
+  struct Shard {
+    std::mutex mMutex;
+    std::unordered_map<std::string, std::shared_ptr<const CompiledAcl>> mAcls;
+  };
+  static constexpr size_t sNumShards = 16;
+  static constexpr size_t sMaxShardEntries = 4096;
+  static std::array<Shard, sNumShards> sShards;
+  std::string key = sysacl;
+  key += '\n';
+  key += useracl;
+  Shard& shard = sShards[std::hash<std::string>()(key) % sNumShards];
+  {
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    auto it = shard.mAcls.find(key);
+
+    if (it != shard.mAcls.end()) {
+      return it->second;
+    }
+  }
+  std::shared_ptr<const CompiledAcl> compiled = Compile(sysacl, useracl);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+
+  if (shard.mAcls.size() >= sMaxShardEntries) {
+    shard.mAcls.clear();
+  }
+
+  shard.mAcls.emplace(std::move(key), compiled);
+  return compiled;
+}
+
+//------------------------------------------------------------------------------
+// Set the contents of an ACL and compute the canXX and hasXX booleans.
+//------------------------------------------------------------------------------
+void
+Acl::Set(std::string sysacl, std::string useracl,
+         const eos::common::Mapping::VirtualIdentity& vid, bool allowUserAcl)
+{
+  using Rule = CompiledAcl::Rule;
+
+  if (!allowUserAcl) {
+    useracl.clear();
   }
 
   // By default nothing is granted
@@ -141,19 +312,24 @@ Acl::Set(std::string sysacl, std::string useracl,
   mCanArchive = false;
   mCanPrepare = false;
 
-if (EOS_LOGS_DEBUG) eos_static_debug("acl='%s' length=%d allowUserAcl=%d", acl.c_str(), acl.length(), allowUserAcl);
+  if (EOS_LOGS_DEBUG) {
+    eos_static_debug("sysacl='%s' useracl='%s' allowUserAcl=%d", sysacl.c_str(),
+                     useracl.c_str(), allowUserAcl);
+  }
+
   // no acl definition
-  if (!acl.length()) {
+  if (!sysacl.length() && !useracl.length()) {
     return;
   }
 
+  std::shared_ptr<const CompiledAcl> compiled = GetCompiled(sysacl, useracl);
   int errc = 0;
-  std::vector<std::string> rules;
-  std::string delimiter = ",";
-  eos::common::StringConversion::Tokenize(acl, rules, delimiter);
-  std::vector<std::string>::const_iterator it;
   XrdOucString sizestring1;
   XrdOucString sizestring2;
+  bool has_user = false;
+  std::string userid, username, keytag;
+  // Egroup membership of the user per egroup of the acl: -1 not yet resolved
+  std::vector<int> egroup_member(compiled->mEgroups.size(), -1);
 
   for (size_t n_gid = 0; n_gid < vid.gid_list.size(); ++n_gid) {
     gid_t chk_gid = vid.gid_list[n_gid];
@@ -163,199 +339,177 @@ if (EOS_LOGS_DEBUG) eos_static_debug("acl='%s' length=%d allowUserAcl=%d", acl.c
       continue;
     }
 
-    std::string userid = eos::common::StringConversion::GetSizeString(sizestring1,
-                         (unsigned long long) vid.uid);
-    std::string groupid = eos::common::StringConversion::GetSizeString(sizestring2,
-                          (unsigned long long) chk_gid);
-    std::string usertag = "u:";
-    usertag += userid;
-    usertag += ":";
-    std::string grouptag = "g:";
-    grouptag += groupid;
-    grouptag += ":";
-    std::string username = eos::common::Mapping::UidToUserName(vid.uid, errc);
+    if (!has_user) {
+      has_user = true;
+      userid = eos::common::StringConversion::GetSizeString(sizestring1,
+               (unsigned long long) vid.uid);
+      username = eos::common::Mapping::UidToUserName(vid.uid, errc);
 
-    if (errc) {
-      username = "_INVAL_";
+      if (errc) {
+        username = "_INVAL_";
+      }
+
+      keytag = "k:";
+      keytag += vid.key;
+      keytag += ":";
     }
 
+    std::string groupid = eos::common::StringConversion::GetSizeString(sizestring2,
+                          (unsigned long long) chk_gid);
     std::string groupname = eos::common::Mapping::GidToGroupName(chk_gid, errc);
 
     if (errc) {
       groupname = "_INVAL_";
     }
 
-if (EOS_LOGS_DEBUG) eos_static_debug("username '%s' groupname '%s'", username.c_str(), groupname.c_str());
-    std::string usr_name_tag = "u:";
-    usr_name_tag += username;
-    usr_name_tag += ":";
-    std::string grp_name_tag = "g:";
-    grp_name_tag += groupname;
-    grp_name_tag += ":";
-    std::string ztag = "z:";
-    std::string keytag = "k:";
-    keytag += vid.key;
-    keytag += ":";;
-    if (EOS_LOGS_DEBUG) eos_static_debug("%s %s %s %s %s", usertag.c_str(), grouptag.c_str(),
-                     usr_name_tag.c_str(), grp_name_tag.c_str(), keytag.c_str());
+    if (EOS_LOGS_DEBUG) {
+      eos_static_debug("uid=%s username='%s' gid=%s groupname='%s' %s",
+                       userid.c_str(), username.c_str(), groupid.c_str(),
+                       groupname.c_str(), keytag.c_str());
+    }
+
     // Rule interpretation logic
     char denials[256];
     memset(denials, 0, sizeof(denials));        /* start with no denials */
 
-    for (it = rules.begin(); it != rules.end(); it++) {
-      bool egroupmatch = false;
+    for (const Rule& rule : compiled->mRules) {
+      bool match = false;
 
-      // Check for e-group membership
-      if (!it->compare(0, strlen("egroup:"), "egroup:")) {
-        std::vector<std::string> entry;
-        std::string delimiter = ":";
-        eos::common::StringConversion::Tokenize(*it, entry, delimiter);
+      switch (rule.mType) {
+      case Rule::Type::kUser:
+        match = ((rule.mId == userid) || (rule.mId == username));
+        break;
 
-        if (entry.size() < 3) {
-          continue;
-        }
+      case Rule::Type::kGroup:
+        match = ((rule.mId == groupid) || (rule.mId == groupname));
+        break;
 
-        egroupmatch = gOFS->EgroupRefresh->Member(username, entry[1]);
-        mHasEgroup = egroupmatch;
-      }
+      case Rule::Type::kKey:
+        match = !rule.mRaw.compare(0, keytag.length(), keytag);
+        break;
 
-      // Match 'our' rule
-      if ((!it->compare(0, usertag.length(), usertag)) ||
-          (!it->compare(0, grouptag.length(), grouptag)) ||
-          (!it->compare(0, ztag.length(), ztag)) ||
-          (egroupmatch) ||
-          (!it->compare(0, keytag.length(), keytag)) ||
-          (!it->compare(0, usr_name_tag.length(), usr_name_tag)) ||
-          (!it->compare(0, grp_name_tag.length(), grp_name_tag))) {
-        std::vector<std::string> entry;
-        std::string delimiter = ":";
-        eos::common::StringConversion::Tokenize(*it, entry, delimiter);
-
-        if (entry.size() < 3) {
-          // z tag entries have only two fields
-          if (it->compare(0, ztag.length(), ztag) || (entry.size() < 2)) {
-            continue;
-          }
+      case Rule::Type::kZ:
+        match = true;
+        break;
 
-          // add an empty entry field
-          entry.resize(3);
-          entry[2] = entry[1];
-        }
+      case Rule::Type::kEgroup: {
+        // Check for e-group membership, once per egroup
+        int& member = egroup_member[rule.mEgroupIndex];
 
-        if (EOS_LOGS_DEBUG) {
-          eos_static_debug("parsing permissions '%s'", entry[2].c_str());
+        if (member == -1) {
+          member = gOFS->EgroupRefresh->Member(username, rule.mId) ? 1 : 0;
         }
 
-        bool deny = false, reallow = false;
+        match = (member == 1);
+        mHasEgroup = match;
+        break;
+      }
 
-        for (char* s = (char*) entry[2].c_str(); s[0] != 0; s++) {
-          int c = s[0];            /* need a copy in case of an "s++" later */
+      case Rule::Type::kNone:
+        break;
+      }
 
-          if (EOS_LOGS_DEBUG) {
-            eos_static_debug("c=%c deny=%d reallow=%d", c, deny, reallow);
-          }
+      if (!match) {
+        continue;
+      }
 
-          if (reallow && !(c == 'u' || c == 'd')) {
-            eos_static_info("'+' Acl flag ignored for '%c'", c);
-          }
+      for (const CompiledAcl::Perm& perm : rule.mPerms) {
+        bool deny = perm.mDeny;
+        bool reallow = perm.mReallow;
+        unsigned char c = perm.mChar;
 
-          switch (c) {
-          case '!':
-            deny = true;
-            continue;
+        if (EOS_LOGS_DEBUG) {
+          eos_static_debug("c=%c deny=%d reallow=%d", c, deny, reallow);
+        }
 
-          case '+':
-            reallow = true;
-            continue;
+        if (reallow && !(c == 'u' || c == 'd')) {
+          eos_static_info("'+' Acl flag ignored for '%c'", c);
+        }
 
-          case 'a': // 'a' defines archiving permission
-            mCanArchive = !deny;
-            break;
+        switch (c) {
+        case 'a': // 'a' defines archiving permission
+          mCanArchive = !deny;
+          break;
 
-          case 'r': // 'r' defines read permission
-            mCanRead = !deny;
-            break;
+        case 'r': // 'r' defines read permission
+          mCanRead = !deny;
+          break;
 
-          case 'x': // 'x' defines browsing permission
-            mCanBrowse = !deny;
-            break;
+        case 'x': // 'x' defines browsing permission
+          mCanBrowse = !deny;
+          break;
 
-          case 'p': // 'p' defines workflow permission
-            mCanPrepare = !deny;
-            break;
+        case 'p': // 'p' defines workflow permission
+          mCanPrepare = !deny;
+          break;
 
-          case 'm': // 'm' defines mode change permission
-            if (deny) {
-              mCanNotChmod = true;
-            } else {
-              mCanChmod = true;
-            }
+        case 'm': // 'm' defines mode change permission
+          if (deny) {
+            mCanNotChmod = true;
+          } else {
+            mCanChmod = true;
+          }
 
-            break;
+          break;
 
-          case 'c': // 'c' defines owner change permission (for directories)
-            if (sysacl.find(*it) !=
-                std::string::npos) { // this is only valid if specified as a sysacl
-              mCanChown = true;
-            } else {
-              eos_static_debug("'%c' right ignored on user.acl", c);
-            }
-
-            break;
+        case 'c': // 'c' defines owner change permission (for directories)
+          if (rule.mInSysAcl) { // this is only valid if specified as a sysacl
+            mCanChown = true;
+          } else {
+            eos_static_debug("'%c' right ignored on user.acl", c);
+          }
 
-          case 'd': // '!d' forbids deletion
-            if (deny && !mCanDelete) {
-              mCanNotDelete = true;
-            } else if (reallow) {
-              mCanDelete = true;
-              mCanNotDelete = false;
-              mCanWriteOnce = false;
-              denials['d'] = 0;               /* drop denial, 'd' and 'u' are "odd" */
-            }
+          break;
 
-            break;
+        case 'd': // '!d' forbids deletion
+          if (deny && !mCanDelete) {
+            mCanNotDelete = true;
+          } else if (reallow) {
+            mCanDelete = true;
+            mCanNotDelete = false;
+            mCanWriteOnce = false;
+            denials['d'] = 0;               /* drop denial, 'd' and 'u' are "odd" */
+          }
 
-          case 'u':// '!u' denies update, 'u' and '+u' add update. '!+u' and '+!u' would *deny* updates
-            mCanUpdate = !deny;
+          break;
 
-            if (mCanUpdate && reallow) {
-              denials['u'] = 0;  /* drop denial, 'd' and 'u' are "odd" */
-            }
+        case 'u':// '!u' denies update, 'u' and '+u' add update. '!+u' and '+!u' would *deny* updates
+          mCanUpdate = !deny;
 
-            break;
-
-          case 'w': // 'wo' defines write once permissions, 'w' defines write permissions if 'wo' is not granted
-            if ((s + 1)[0] == 'o') {  /* this is a 'wo' */
-              s++;
-              c = 'W';        /* for the denial entry */
-              mCanWriteOnce = !deny;
-            } else {
-              if (!mCanWriteOnce) {
-                mCanWrite = !deny;
-              }
-            }
+          if (mCanUpdate && reallow) {
+            denials['u'] = 0;  /* drop denial, 'd' and 'u' are "odd" */
+          }
 
-            break;
+          break;
 
-          case 'q':
-            if (sysacl.find(*it) != std::string::npos) {
-              mCanSetQuota = !deny;
+        case 'w': // 'wo' defines write once permissions, 'w' defines write permissions if 'wo' is not granted
+          if (perm.mWriteOnce) {
+            c = 'W';        /* for the denial entry */
+            mCanWriteOnce = !deny;
+          } else {
+            if (!mCanWriteOnce) {
+              mCanWrite = !deny;
             }
+          }
 
-            break;
+          break;
 
-          case 'i': // 'i' makes directories immutable
-            mIsMutable = deny;
-            break;
+        case 'q':
+          if (rule.mInSysAcl) {
+            mCanSetQuota = !deny;
           }
 
-          mHasAcl = true;
+          break;
 
-          if (deny) {
-            denials[c] = 1;  /* remember the denials */
-          }
+        case 'i': // 'i' makes directories immutable
+          mIsMutable = deny;
+          break;
+        }
+
+        mHasAcl = true;
 
-          deny = reallow = false;           /* reset for next permission char */
+        if (deny) {
+          denials[c] = 1;  /* remember the denials */
         }
       }
     }
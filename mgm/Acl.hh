@@ -26,6 +26,7 @@
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/interface/IFileMD.hh"
 #include <sys/types.h>
+#include <memory>
 #include <string>
 
 #define P_OK  8   /* Test for workflow permission.  */
@@ -269,6 +270,26 @@ public:         // [+] prevents '+' interpreted as "one or more"
   }
 
 private:
+  struct CompiledAcl;
+
+  //----------------------------------------------------------------------------
+  //! Get the compiled form of the given acl definitions from the cache of
+  //! compiled acls, compiling and caching them if not present
+  //!
+  //! @param sysacl system acl definition string
+  //! @param useracl user acl definition string, empty if not evaluated
+  //!
+  //! @return compiled acl
+  //----------------------------------------------------------------------------
+  static std::shared_ptr<const CompiledAcl>
+  GetCompiled(const std::string& sysacl, const std::string& useracl);
+
+  //----------------------------------------------------------------------------
+  //! Compile the given acl definitions
+  //----------------------------------------------------------------------------
+  static std::shared_ptr<CompiledAcl>
+  Compile(const std::string& sysacl, const std::string& useracl);
+
   bool mCanRead; ///< acl allows read access
   bool mCanNotRead; ///< acl denies read access
   bool mCanWrite; ///< acl allows write access
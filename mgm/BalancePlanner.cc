@@ -0,0 +1,710 @@
+//------------------------------------------------------------------------------
+//! @file BalancePlanner.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/BalancePlanner.hh"
+#include "mgm/FsView.hh"
+#include "mgm/XrdMgmOfs.hh"
+#include "mgm/IMaster.hh"
+#include "common/Logging.hh"
+#include "common/LayoutId.hh"
+#include "common/Mapping.hh"
+#include "namespace/interface/IView.hh"
+#include "namespace/Prefetcher.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <sys/stat.h>
+
+EOSMGMNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+//! Unit of the plan while it is computed
+//------------------------------------------------------------------------------
+struct PlanUnit {
+  std::string mName; ///< group or geotag
+  double mUsed {0}; ///< used bytes
+  double mCapacity {0}; ///< capacity in bytes
+  std::map<std::string, uint64_t> mNodeUsed; ///< used bytes per node
+  double mShed {0}; ///< bytes to send
+  double mNeed {0}; ///< bytes to receive
+};
+
+//------------------------------------------------------------------------------
+// Get the bytes a node may still send or receive
+//------------------------------------------------------------------------------
+uint64_t
+GetBudgetLeft(const std::map<std::string, uint64_t>& budgets,
+              std::map<std::string, uint64_t>& spent, const std::string& node)
+{
+  auto it = budgets.find(node);
+
+  if (it == budgets.end()) {
+    return std::numeric_limits<uint64_t>::max();
+  }
+
+  uint64_t used = spent[node];
+  return (it->second > used ? it->second - used : 0);
+}
+}
+
+//------------------------------------------------------------------------------
+// Compute the plan balancing the units of a set of filesystems
+//------------------------------------------------------------------------------
+BalancePlanner::Plan
+BalancePlanner::ComputePlan(const std::vector<FsEntry>& fs,
+                            const std::map<std::string, uint64_t>& budgets,
+                            double tolerance)
+{
+  Plan plan;
+  std::map<std::string, PlanUnit> units;
+  double used = 0;
+  double capacity = 0;
+
+  for (const auto& entry : fs) {
+    if (!entry.mCapacity) {
+      continue;
+    }
+
+    PlanUnit& unit = units[entry.mUnit];
+    unit.mName = entry.mUnit;
+    unit.mUsed += entry.mUsed;
+    unit.mCapacity += entry.mCapacity;
+    unit.mNodeUsed[entry.mNode] += entry.mUsed;
+    used += entry.mUsed;
+    capacity += entry.mCapacity;
+  }
+
+  if ((units.size() < 2) || (capacity <= 0)) {
+    return plan;
+  }
+
+  plan.mTarget = used / capacity;
+  double shed = 0;
+  double need = 0;
+  std::vector<PlanUnit*> by_filling;
+
+  for (auto& elem : units) {
+    PlanUnit& unit = elem.second;
+    double filled = unit.mUsed / unit.mCapacity;
+    double upper = (plan.mTarget + tolerance) * unit.mCapacity;
+    double lower = std::max(0.0, (plan.mTarget - tolerance) * unit.mCapacity);
+    plan.mDeviation = std::max(plan.mDeviation,
+                               std::fabs(filled - plan.mTarget));
+
+    // Only bring the units back to the edge of the band
+    if (unit.mUsed > upper) {
+      unit.mShed = unit.mUsed - upper;
+      shed += unit.mShed;
+    } else if (unit.mUsed < lower) {
+      unit.mNeed = lower - unit.mUsed;
+      need += unit.mNeed;
+    }
+
+    by_filling.push_back(&unit);
+  }
+
+  std::sort(by_filling.begin(), by_filling.end(),
+  [](const PlanUnit * a, const PlanUnit * b) {
+    return (a->mUsed / a->mCapacity) < (b->mUsed / b->mCapacity);
+  });
+
+  // The excess and the deficit rarely match, the difference goes to or comes
+  // from the other units, first up to the target then up to the band edge
+  for (int pass = 0; (pass < 2) && (shed > need); ++pass) {
+    double level = plan.mTarget + (pass ? tolerance : 0);
+
+    for (auto unit : by_filling) {
+      double room = level * unit->mCapacity - unit->mUsed - unit->mNeed;
+
+      if ((unit->mShed > 0) || (room <= 0)) {
+        continue;
+      }
+
+      double take = std::min(room, shed - need);
+      unit->mNeed += take;
+      need += take;
+
+      if (need >= shed) {
+        break;
+      }
+    }
+  }
+
+  for (int pass = 0; (pass < 2) && (need > shed); ++pass) {
+    double level = std::max(0.0, plan.mTarget - (pass ? tolerance : 0));
+
+    for (auto it = by_filling.rbegin(); it != by_filling.rend(); ++it) {
+      PlanUnit* unit = *it;
+      double room = unit->mUsed - unit->mShed - level * unit->mCapacity;
+
+      if ((unit->mNeed > 0) || (room <= 0)) {
+        continue;
+      }
+
+      double take = std::min(room, need - shed);
+      unit->mShed += take;
+      shed += take;
+
+      if (shed >= need) {
+        break;
+      }
+    }
+  }
+
+  // Match the biggest senders with the biggest receivers through the nodes
+  // with budget left
+  std::vector<PlanUnit*> sources;
+  std::vector<PlanUnit*> sinks;
+
+  for (auto unit : by_filling) {
+    if (unit->mShed >= 1) {
+      sources.push_back(unit);
+    } else if (unit->mNeed >= 1) {
+      sinks.push_back(unit);
+    }
+  }
+
+  std::sort(sources.begin(), sources.end(),
+  [](const PlanUnit * a, const PlanUnit * b) {
+    return a->mShed > b->mShed;
+  });
+  std::sort(sinks.begin(), sinks.end(),
+  [](const PlanUnit * a, const PlanUnit * b) {
+    return a->mNeed > b->mNeed;
+  });
+  std::map<std::string, uint64_t> sent;
+  std::map<std::string, uint64_t> received;
+  size_t i = 0;
+  size_t j = 0;
+
+  while ((i < sources.size()) && (j < sinks.size())) {
+    PlanUnit* src = sources[i];
+    PlanUnit* dst = sinks[j];
+    std::string src_node;
+    std::string dst_node;
+    uint64_t src_left = 0;
+    uint64_t dst_left = 0;
+
+    for (const auto& elem : src->mNodeUsed) {
+      uint64_t left = std::min(elem.second,
+                               GetBudgetLeft(budgets, sent, elem.first));
+
+      if (left > src_left) {
+        src_left = left;
+        src_node = elem.first;
+      }
+    }
+
+    if (!src_left) {
+      ++i;
+      continue;
+    }
+
+    for (const auto& elem : dst->mNodeUsed) {
+      uint64_t left = GetBudgetLeft(budgets, received, elem.first);
+
+      if (left > dst_left) {
+        dst_left = left;
+        dst_node = elem.first;
+      }
+    }
+
+    if (!dst_left) {
+      ++j;
+      continue;
+    }
+
+    uint64_t bytes = std::min(std::min(src_left, dst_left),
+                              std::min((uint64_t) src->mShed,
+                                       (uint64_t) dst->mNeed));
+
+    if (bytes) {
+      Move move;
+      move.mSrcUnit = src->mName;
+      move.mSrcNode = src_node;
+      move.mDstUnit = dst->mName;
+      move.mBytes = bytes;
+      plan.mMoves.push_back(move);
+      plan.mBytes += bytes;
+      sent[src_node] += bytes;
+      received[dst_node] += bytes;
+      src->mNodeUsed[src_node] -= bytes;
+      src->mShed -= bytes;
+      dst->mNeed -= bytes;
+    }
+
+    if (src->mShed < 1) {
+      ++i;
+    }
+
+    if (dst->mNeed < 1) {
+      ++j;
+    }
+  }
+
+  uint64_t total = (uint64_t) std::max(shed, need);
+  plan.mDeferred = (total > plan.mBytes ? total - plan.mBytes : 0);
+  return plan;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+BalancePlanner::BalancePlanner(const char* spacename):
+  mSpaceName(spacename)
+{
+  mThread.reset(&BalancePlanner::Run, this);
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+BalancePlanner::~BalancePlanner()
+{
+  Stop();
+}
+
+//------------------------------------------------------------------------------
+// Stop the planner thread
+//------------------------------------------------------------------------------
+void
+BalancePlanner::Stop()
+{
+  mThread.join();
+}
+
+//------------------------------------------------------------------------------
+// Planner thread loop
+//------------------------------------------------------------------------------
+void
+BalancePlanner::Run(ThreadAssistant& assistant) noexcept
+{
+  gOFS->WaitUntilNamespaceIsBooted(assistant);
+
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(std::chrono::seconds(kCheckSec));
+
+    if (assistant.terminationRequested()) {
+      break;
+    }
+
+    if (!gOFS->mMaster->IsMaster()) {
+      mTransfers.clear();
+      mLastPlan = 0;
+      continue;
+    }
+
+    Settings settings = GetSettings();
+
+    if (!settings.mEnabled) {
+      continue;
+    }
+
+    time_t now = time(NULL);
+
+    if (now < mLastPlan + settings.mInterval) {
+      continue;
+    }
+
+    mLastPlan = now;
+    PlanRound(settings);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Read the configuration of the space
+//------------------------------------------------------------------------------
+BalancePlanner::Settings
+BalancePlanner::GetSettings() const
+{
+  Settings settings;
+  eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+  auto it = FsView::gFsView.mSpaceView.find(mSpaceName);
+
+  if (it == FsView::gFsView.mSpaceView.end()) {
+    return settings;
+  }
+
+  FsSpace* space = it->second;
+  std::string value = space->GetConfigMember("planner");
+  settings.mEnabled = ((value == "on") || (value == "dryrun"));
+  settings.mDryRun = (value == "dryrun");
+  settings.mGeotag = (space->GetConfigMember("planner.scope") == "geotag");
+  settings.mConverter = (space->GetConfigMember("converter") == "on");
+  value = space->GetConfigMember("planner.tolerance");
+
+  if (value.length()) {
+    settings.mTolerance = strtod(value.c_str(), nullptr) / 100.0;
+  }
+
+  value = space->GetConfigMember("planner.interval");
+
+  if (value.length() && (strtol(value.c_str(), nullptr, 10) > 0)) {
+    settings.mInterval = strtol(value.c_str(), nullptr, 10);
+  }
+
+  value = space->GetConfigMember("planner.node.bw");
+
+  if (value.length()) {
+    settings.mNodeShare = strtod(value.c_str(), nullptr) / 100.0;
+  }
+
+  value = space->GetConfigMember("planner.ntx");
+
+  if (value.length()) {
+    settings.mNtx = strtoul(value.c_str(), nullptr, 10);
+  }
+
+  value = space->GetConfigMember("planner.file.minsize");
+  settings.mMinFileSize = strtoull(value.c_str(), nullptr, 10);
+  return settings;
+}
+
+//------------------------------------------------------------------------------
+// Run one planning round
+//------------------------------------------------------------------------------
+void
+BalancePlanner::PlanRound(const Settings& settings)
+{
+  UpdateTransfers();
+  std::vector<FsEntry> fs;
+  std::map<std::string, uint64_t> budgets;
+  Collect(settings, fs, budgets);
+  Plan plan = ComputePlan(fs, budgets, settings.mTolerance);
+
+  for (const auto& move : plan.mMoves) {
+    eos_static_info("msg=\"planned move\" space=%s src=%s node=%s dst=%s "
+                    "bytes=%llu dryrun=%d", mSpaceName.c_str(),
+                    move.mSrcUnit.c_str(), move.mSrcNode.c_str(),
+                    move.mDstUnit.c_str(), (unsigned long long) move.mBytes,
+                    settings.mDryRun);
+  }
+
+  size_t jobs = 0;
+
+  if (!settings.mDryRun && !plan.mMoves.empty()) {
+    if (settings.mConverter) {
+      for (const auto& move : plan.mMoves) {
+        jobs += Emit(settings, move, fs);
+      }
+    } else {
+      eos_static_warning("msg=\"converter is off, the balance plan is not "
+                         "executed\" space=%s", mSpaceName.c_str());
+    }
+  }
+
+  eos_static_info("msg=\"balance plan\" space=%s target=%.02f%% "
+                  "deviation=%.02f%% moves=%lu bytes=%llu deferred=%llu "
+                  "jobs=%lu inflight=%lu", mSpaceName.c_str(),
+                  plan.mTarget * 100.0, plan.mDeviation * 100.0,
+                  plan.mMoves.size(), (unsigned long long) plan.mBytes,
+                  (unsigned long long) plan.mDeferred, jobs, mTransfers.size());
+  Publish(settings, plan, jobs);
+}
+
+//------------------------------------------------------------------------------
+// Collect the filesystems of the space and the budgets of their nodes
+//------------------------------------------------------------------------------
+void
+BalancePlanner::Collect(const Settings& settings, std::vector<FsEntry>& fs,
+                        std::map<std::string, uint64_t>& budgets)
+{
+  std::map<std::string, double> rates;
+  {
+    eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+    auto it = FsView::gFsView.mSpaceView.find(mSpaceName);
+
+    if (it == FsView::gFsView.mSpaceView.end()) {
+      return;
+    }
+
+    std::map<std::string, bool> groups_on;
+
+    for (auto fs_it = it->second->cbegin(); fs_it != it->second->cend();
+         ++fs_it) {
+      auto id_it = FsView::gFsView.mIdView.find(*fs_it);
+
+      if ((id_it == FsView::gFsView.mIdView.end()) ||
+          (id_it->second->GetActiveStatus() !=
+           eos::common::FileSystem::kOnline)) {
+        continue;
+      }
+
+      eos::common::FileSystem::fs_snapshot_t snapshot;
+      id_it->second->SnapShotFileSystem(snapshot, false);
+
+      // Draining and read-only filesystems are left to the drain, they can't
+      // receive any file
+      if ((snapshot.mStatus != eos::common::FileSystem::kBooted) ||
+          (snapshot.mConfigStatus != eos::common::FileSystem::kRW) ||
+          (snapshot.mDiskCapacity <= 0)) {
+        continue;
+      }
+
+      FsEntry entry;
+      entry.mId = snapshot.mId;
+      entry.mNode = snapshot.mHostPort;
+      entry.mCapacity = snapshot.mDiskCapacity;
+      entry.mUsed = (snapshot.mDiskCapacity > snapshot.mDiskFreeBytes ?
+                     snapshot.mDiskCapacity - snapshot.mDiskFreeBytes : 0);
+
+      if (settings.mGeotag) {
+        entry.mUnit = snapshot.mGeoTag;
+      } else {
+        auto grp_it = groups_on.find(snapshot.mGroup);
+
+        if (grp_it == groups_on.end()) {
+          auto view_it = FsView::gFsView.mGroupView.find(snapshot.mGroup);
+          bool on = ((view_it != FsView::gFsView.mGroupView.end()) &&
+                     (view_it->second->GetConfigMember("status") == "on"));
+          grp_it = groups_on.emplace(snapshot.mGroup, on).first;
+        }
+
+        if (grp_it->second) {
+          entry.mUnit = snapshot.mGroup;
+        }
+      }
+
+      if (entry.mUnit.empty()) {
+        continue;
+      }
+
+      fs.push_back(entry);
+
+      if (snapshot.mNetEthRateMiB > 0) {
+        rates[entry.mNode] = snapshot.mNetEthRateMiB * 1024 * 1024 *
+                             settings.mNodeShare;
+      }
+    }
+  }
+  // The transfers still in flight are accounted as done, their bytes are
+  // taken from the budgets of the source nodes
+  std::map<fsid_t, size_t> fs_index;
+  std::map<std::string, size_t> unit_index;
+
+  for (size_t i = 0; i < fs.size(); ++i) {
+    fs_index[fs[i].mId] = i;
+    unit_index.emplace(fs[i].mUnit, i);
+  }
+
+  std::map<std::string, uint64_t> inflight;
+
+  for (const auto& elem : mTransfers) {
+    const Transfer& transfer = elem.second;
+    auto src_it = fs_index.find(transfer.mSrcFsId);
+
+    if (src_it != fs_index.end()) {
+      FsEntry& src = fs[src_it->second];
+      src.mUsed -= std::min(src.mUsed, transfer.mSize);
+      inflight[src.mNode] += transfer.mSize;
+    }
+
+    auto dst_it = unit_index.find(transfer.mDstUnit);
+
+    if (!settings.mGeotag && (dst_it != unit_index.end())) {
+      fs[dst_it->second].mUsed += transfer.mSize;
+    }
+  }
+
+  for (const auto& elem : rates) {
+    double budget = elem.second * settings.mInterval;
+    // Drain traffic of the node goes first
+    uint64_t busy = inflight[elem.first] +
+                    gOFS->mDrainEngine.GetScheduler().GetNodeInflight(elem.first);
+    budgets[elem.first] = (budget > busy ? (uint64_t)(budget - busy) : 0);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop the transfers whose conversion entry is gone
+//------------------------------------------------------------------------------
+void
+BalancePlanner::UpdateTransfers()
+{
+  eos::common::Mapping::VirtualIdentity rootvid;
+  eos::common::Mapping::Root(rootvid);
+
+  for (auto it = mTransfers.begin(); it != mTransfers.end();) {
+    XrdOucErrInfo error;
+    struct stat buf;
+
+    if (gOFS->_stat(it->second.mPath.c_str(), &buf, error, rootvid, "")) {
+      it = mTransfers.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Create the conversion jobs of a move
+//------------------------------------------------------------------------------
+size_t
+BalancePlanner::Emit(const Settings& settings, const Move& move,
+                     const std::vector<FsEntry>& fs)
+{
+  std::vector<fsid_t> candidates;
+
+  for (const auto& entry : fs) {
+    if ((entry.mUnit == move.mSrcUnit) && (entry.mNode == move.mSrcNode)) {
+      candidates.push_back(entry.mId);
+    }
+  }
+
+  auto is_scheduled = [this](uint64_t fid) {
+    return (mTransfers.count(fid) != 0);
+  };
+  // Geotags can't be targeted, the converter places the files in the space
+  // and the geo scheduling spreads them
+  std::string target = (settings.mGeotag ? mSpaceName : move.mDstUnit);
+  uint64_t min_size = std::max(settings.mMinFileSize, (uint64_t) 1);
+  uint64_t left = move.mBytes;
+  size_t jobs = 0;
+  eos::common::Mapping::VirtualIdentity rootvid;
+  eos::common::Mapping::Root(rootvid);
+
+  while (!candidates.empty() && (left >= min_size) &&
+         (mTransfers.size() < settings.mNtx)) {
+    size_t index = random() % candidates.size();
+    fsid_t fsid = candidates[index];
+    uint64_t fid = 0;
+
+    if (!mSizeIndex.Choose(fsid, min_size, left, is_scheduled, fid)) {
+      candidates.erase(candidates.begin() + index);
+      continue;
+    }
+
+    uint64_t size = 0;
+    std::string path = GetConversionEntry(fid, target, size);
+
+    if (path.empty()) {
+      mSizeIndex.Remove(fsid, fid);
+      continue;
+    }
+
+    XrdOucErrInfo error;
+
+    if (gOFS->_touch(path.c_str(), error, rootvid, 0)) {
+      eos_static_err("msg=\"failed to schedule transfer\" schedulingfile=\"%s\"",
+                     path.c_str());
+      break;
+    }
+
+    eos_static_debug("scheduledfile=%s", path.c_str());
+    Transfer& transfer = mTransfers[fid];
+    transfer.mPath = path;
+    transfer.mSrcFsId = fsid;
+    transfer.mDstUnit = move.mDstUnit;
+    transfer.mSize = size;
+    left -= std::min(left, size);
+    ++jobs;
+  }
+
+  return jobs;
+}
+
+//------------------------------------------------------------------------------
+// Get the conversion entry moving a file to a target group or space
+//------------------------------------------------------------------------------
+std::string
+BalancePlanner::GetConversionEntry(uint64_t fid, const std::string& target,
+                                   uint64_t& size)
+{
+  eos::common::LayoutId::layoutid_t layoutid = 0;
+  {
+    eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, fid);
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+    try {
+      std::shared_ptr<eos::IFileMD> fmd = gOFS->eosFileService->getFileMD(fid);
+
+      if (!fmd->getContainerId() || !fmd->getSize()) {
+        return std::string();
+      }
+
+      // Don't touch files in any ../proc/ directory
+      if (gOFS->eosView->getUri(fmd.get()).find(gOFS->MgmProcPath.c_str()) == 0) {
+        return std::string();
+      }
+
+      layoutid = fmd->getLayoutId();
+      size = fmd->getSize();
+    } catch (eos::MDException& e) {
+      eos_static_debug("msg=\"exception\" ec=%d emsg=\"%s\"", e.getErrno(),
+                       e.getMessage().str().c_str());
+      return std::string();
+    }
+  }
+  char entry[1024];
+  snprintf(entry, sizeof(entry), "%s/%016llx:%s#%08lx",
+           gOFS->MgmProcConversionPath.c_str(), (unsigned long long) fid,
+           target.c_str(), (unsigned long) layoutid);
+  return std::string(entry);
+}
+
+//------------------------------------------------------------------------------
+// Publish the last plan in the space variables
+//------------------------------------------------------------------------------
+void
+BalancePlanner::Publish(const Settings& settings, const Plan& plan,
+                        size_t jobs)
+{
+  char target[32];
+  char deviation[32];
+  snprintf(target, sizeof(target), "%.02f", plan.mTarget * 100.0);
+  snprintf(deviation, sizeof(deviation), "%.02f", plan.mDeviation * 100.0);
+  eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+  auto it = FsView::gFsView.mSpaceView.find(mSpaceName);
+
+  if (it == FsView::gFsView.mSpaceView.end()) {
+    return;
+  }
+
+  FsSpace* space = it->second;
+  space->SetConfigMember("stat.planner.scope",
+                         settings.mGeotag ? "geotag" : "group", true,
+                         "/eos/*/mgm", true);
+  space->SetConfigMember("stat.planner.target", target, true, "/eos/*/mgm",
+                         true);
+  space->SetConfigMember("stat.planner.deviation", deviation, true,
+                         "/eos/*/mgm", true);
+  space->SetConfigMember("stat.planner.moves",
+                         std::to_string(plan.mMoves.size()), true,
+                         "/eos/*/mgm", true);
+  space->SetConfigMember("stat.planner.bytes", std::to_string(plan.mBytes),
+                         true, "/eos/*/mgm", true);
+  space->SetConfigMember("stat.planner.deferred",
+                         std::to_string(plan.mDeferred), true, "/eos/*/mgm",
+                         true);
+  space->SetConfigMember("stat.planner.jobs", std::to_string(jobs), true,
+                         "/eos/*/mgm", true);
+  space->SetConfigMember("stat.planner.inflight",
+                         std::to_string(mTransfers.size()), true, "/eos/*/mgm",
+                         true);
+  space->SetConfigMember("stat.planner.time", std::to_string(mLastPlan), true,
+                         "/eos/*/mgm", true);
+}
+
+EOSMGMNAMESPACE_END
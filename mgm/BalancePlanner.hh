@@ -0,0 +1,227 @@
+//------------------------------------------------------------------------------
+//! @file BalancePlanner.hh
+//! @brief Space wide planner of the balancing transfers between groups or
+//!        geotags
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "mgm/FsSizeIndex.hh"
+#include "common/AssistedThread.hh"
+#include "common/FileSystem.hh"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Planner computing the transfers which balance a space, replaces
+//! the greedy group and geotag balancer loops when enabled
+//!
+//! Every interval the planner takes the filling of all the units (groups or
+//! geotags) of the space and computes one plan. The target filling is the
+//! capacity weighted filling of the whole space, so that added capacity only
+//! lowers the target instead of making the units oscillate around an average
+//! of ratios. A unit outside of the tolerance band around the target sheds or
+//! receives only the bytes which bring it back to the edge of the band, the
+//! units inside the band take the remainder when the excess and the deficit
+//! don't match. Moving the excess down to the upper edge is the minimal
+//! number of bytes which reaches the target within the tolerance.
+//!
+//! Each node sends and receives at most its budget per interval: a share of
+//! its NIC bandwidth minus the bytes in flight of the drains of the node and
+//! of the planner transfers still running. Units are only planned with the
+//! nodes which have budget left, the remainder is planned in a later round.
+//!
+//! The moves are turned into conversion jobs in the proc conversion
+//! directory, executed by the converter of the space like the ones of the
+//! group balancer. Files are taken from the filesystems of the source node,
+//! biggest first up to the planned bytes. In dry-run mode the plan is only
+//! logged and published in the stat.planner.* space variables.
+//!
+//! Configured per space: planner=on|off|dryrun, planner.scope=group|geotag,
+//! planner.tolerance (%), planner.interval (s), planner.node.bw (% of the
+//! NIC bandwidth), planner.ntx and planner.file.minsize (bytes).
+//------------------------------------------------------------------------------
+class BalancePlanner
+{
+public:
+  using fsid_t = eos::common::FileSystem::fsid_t;
+
+  //----------------------------------------------------------------------------
+  //! Filesystem taking part in the plan
+  //----------------------------------------------------------------------------
+  struct FsEntry {
+    fsid_t mId {0}; ///< filesystem id
+    std::string mUnit; ///< group or geotag of the filesystem
+    std::string mNode; ///< host:port of the filesystem
+    uint64_t mUsed {0}; ///< used bytes
+    uint64_t mCapacity {0}; ///< capacity in bytes
+  };
+
+  //----------------------------------------------------------------------------
+  //! Bytes to move from the filesystems of one node of a unit to a unit
+  //----------------------------------------------------------------------------
+  struct Move {
+    std::string mSrcUnit; ///< unit shedding the bytes
+    std::string mSrcNode; ///< node whose filesystems send the bytes
+    std::string mDstUnit; ///< unit receiving the bytes
+    uint64_t mBytes {0}; ///< bytes to move
+  };
+
+  //----------------------------------------------------------------------------
+  //! Result of one planning round
+  //----------------------------------------------------------------------------
+  struct Plan {
+    double mTarget {0}; ///< target filling of all the units
+    double mDeviation {0}; ///< max deviation of a unit from the target
+    uint64_t mBytes {0}; ///< bytes planned in this round
+    uint64_t mDeferred {0}; ///< bytes left for later rounds by the budgets
+    std::vector<Move> mMoves; ///< planned moves
+  };
+
+  //----------------------------------------------------------------------------
+  //! Configuration taken from the space
+  //----------------------------------------------------------------------------
+  struct Settings {
+    bool mEnabled {false}; ///< plan at all
+    bool mDryRun {false}; ///< only log and publish the plan
+    bool mGeotag {false}; ///< balance the geotags instead of the groups
+    double mTolerance {0.02}; ///< tolerated deviation from the target
+    int mInterval {300}; ///< seconds between two plans
+    double mNodeShare {0.2}; ///< share of the NIC bandwidth of a node
+    size_t mNtx {100}; ///< max planner transfers in flight
+    uint64_t mMinFileSize {0}; ///< min size of the files to move
+    bool mConverter {false}; ///< converter of the space is running
+  };
+
+  //----------------------------------------------------------------------------
+  //! Compute the plan balancing the units of a set of filesystems
+  //!
+  //! @param fs filesystems with their unit, node and filling
+  //! @param budgets bytes each node may send and receive in this round, the
+  //!        nodes which are not listed are not limited
+  //! @param tolerance tolerated deviation from the target filling
+  //!
+  //! @return plan
+  //----------------------------------------------------------------------------
+  static Plan ComputePlan(const std::vector<FsEntry>& fs,
+                          const std::map<std::string, uint64_t>& budgets,
+                          double tolerance);
+
+  //----------------------------------------------------------------------------
+  //! Constructor (per space), starts the planner thread
+  //----------------------------------------------------------------------------
+  BalancePlanner(const char* spacename);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~BalancePlanner();
+
+  //----------------------------------------------------------------------------
+  //! Stop the planner thread
+  //----------------------------------------------------------------------------
+  void Stop();
+
+private:
+  //----------------------------------------------------------------------------
+  //! Transfer emitted by the planner and not yet done
+  //----------------------------------------------------------------------------
+  struct Transfer {
+    std::string mPath; ///< conversion entry in proc
+    fsid_t mSrcFsId {0}; ///< filesystem the file is taken from
+    std::string mDstUnit; ///< unit receiving the file
+    uint64_t mSize {0}; ///< file size
+  };
+
+  //! Seconds between two checks of the configuration
+  static constexpr int kCheckSec = 10;
+
+  //----------------------------------------------------------------------------
+  //! Planner thread loop
+  //----------------------------------------------------------------------------
+  void Run(ThreadAssistant& assistant) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Read the configuration of the space
+  //----------------------------------------------------------------------------
+  Settings GetSettings() const;
+
+  //----------------------------------------------------------------------------
+  //! Run one planning round
+  //----------------------------------------------------------------------------
+  void PlanRound(const Settings& settings);
+
+  //----------------------------------------------------------------------------
+  //! Collect the filesystems of the space and the budgets of their nodes
+  //!
+  //! @param settings current configuration
+  //! @param fs filesystems taking part in the plan
+  //! @param budgets byte budget of the nodes with a known NIC bandwidth
+  //----------------------------------------------------------------------------
+  void Collect(const Settings& settings, std::vector<FsEntry>& fs,
+               std::map<std::string, uint64_t>& budgets);
+
+  //----------------------------------------------------------------------------
+  //! Drop the transfers whose conversion entry is gone
+  //----------------------------------------------------------------------------
+  void UpdateTransfers();
+
+  //----------------------------------------------------------------------------
+  //! Create the conversion jobs of a move
+  //!
+  //! @param settings current configuration
+  //! @param move planned move
+  //! @param fs filesystems taking part in the plan
+  //!
+  //! @return number of jobs created
+  //----------------------------------------------------------------------------
+  size_t Emit(const Settings& settings, const Move& move,
+              const std::vector<FsEntry>& fs);
+
+  //----------------------------------------------------------------------------
+  //! Get the conversion entry moving a file to a target group or space
+  //!
+  //! @param fid file id
+  //! @param target group or space name
+  //! @param size size of the file
+  //!
+  //! @return path of the entry, empty if the file can't be moved
+  //----------------------------------------------------------------------------
+  std::string GetConversionEntry(uint64_t fid, const std::string& target,
+                                 uint64_t& size);
+
+  //----------------------------------------------------------------------------
+  //! Publish the last plan in the space variables
+  //----------------------------------------------------------------------------
+  void Publish(const Settings& settings, const Plan& plan, size_t jobs);
+
+  AssistedThread mThread; ///< planner thread
+  std::string mSpaceName; ///< name of the space this planner serves
+  std::map<uint64_t, Transfer> mTransfers; ///< transfers in flight
+  FsSizeIndex mSizeIndex; ///< size bucketed samples of the files
+  time_t mLastPlan {0}; ///< time of the last plan
+};
+
+EOSMGMNAMESPACE_END
@@ -37,6 +37,7 @@ struct fsctlMapInit {
     fsctlCommandMap["chmod"] = FsctlCommand::chmod;
     fsctlCommandMap["chown"] = FsctlCommand::chown;
     fsctlCommandMap["commit"] = FsctlCommand::commit;
+    fsctlCommandMap["commitbatch"] = FsctlCommand::commitbatch;
     fsctlCommandMap["drop"] = FsctlCommand::drop;
     fsctlCommandMap["event"] = FsctlCommand::event;
     fsctlCommandMap["getfmd"] = FsctlCommand::getfmd;
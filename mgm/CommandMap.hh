@@ -38,6 +38,7 @@ enum class FsctlCommand {
   chmod,
   chown,
   commit,
+  commitbatch,
   drop,
   event,
   getfmd,
@@ -0,0 +1,173 @@
+//------------------------------------------------------------------------------
+//! @file ContainerPolicyCache.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/ContainerPolicyCache.hh"
+#include <algorithm>
+#include <cstdlib>
+
+EOSMGMNAMESPACE_BEGIN
+
+constexpr size_t ContainerPolicyCache::sNumShards;
+
+//------------------------------------------------------------------------------
+// Get the TTL of the entries
+//------------------------------------------------------------------------------
+std::chrono::milliseconds
+ContainerPolicyCache::GetTTL()
+{
+  static std::chrono::milliseconds sTTL = []() {
+    const char* ptr = getenv("EOS_MGM_POLICY_CACHE_TTL_MS");
+    long long ttl_ms = (ptr ? strtoll(ptr, nullptr, 10) : 0);
+    return std::chrono::milliseconds(ttl_ms > 0 ? ttl_ms : 0);
+  }();
+  return sTTL;
+}
+
+//------------------------------------------------------------------------------
+// Get the maximum number of entries
+//------------------------------------------------------------------------------
+size_t
+ContainerPolicyCache::GetMaxEntries()
+{
+  static size_t sMaxEntries = []() {
+    const char* ptr = getenv("EOS_MGM_POLICY_CACHE_SIZE");
+    long long max_entries = (ptr ? strtoll(ptr, nullptr, 10) : 10000);
+    return (size_t)(max_entries > 0 ? max_entries : 10000);
+  }();
+  return sMaxEntries;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ContainerPolicyCache::ContainerPolicyCache(std::chrono::milliseconds ttl,
+    size_t max_entries):
+  mTTL(ttl), mMaxPerShard(std::max(max_entries / sNumShards, (size_t) 1))
+{}
+
+//------------------------------------------------------------------------------
+// Get current steady clock time in nanoseconds
+//------------------------------------------------------------------------------
+int64_t
+ContainerPolicyCache::GetNowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+         (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------------
+// Get the cached item of a directory
+//------------------------------------------------------------------------------
+std::shared_ptr<const ContainerPolicyCache::Item>
+ContainerPolicyCache::Get(uint64_t cid, const Version& version)
+{
+  if (!IsEnabled()) {
+    return nullptr;
+  }
+
+  Shard& shard = GetShard(cid);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  auto it = shard.mEntries.find(cid);
+
+  if (it == shard.mEntries.end()) {
+    ++mMisses;
+    return nullptr;
+  }
+
+  if ((it->second.mExpiresNs <= GetNowNs()) ||
+      (it->second.mVersion != version)) {
+    shard.mLru.erase(it->second.mLru);
+    shard.mEntries.erase(it);
+    ++mMisses;
+    return nullptr;
+  }
+
+  shard.mLru.splice(shard.mLru.begin(), shard.mLru, it->second.mLru);
+  ++mHits;
+  return it->second.mItem;
+}
+
+//------------------------------------------------------------------------------
+// Store the item of a directory
+//------------------------------------------------------------------------------
+void
+ContainerPolicyCache::Put(uint64_t cid, const Version& version,
+                          const std::shared_ptr<const Item>& item)
+{
+  if (!IsEnabled() || !item) {
+    return;
+  }
+
+  Shard& shard = GetShard(cid);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  auto it = shard.mEntries.find(cid);
+
+  if (it == shard.mEntries.end()) {
+    while (shard.mEntries.size() >= mMaxPerShard) {
+      shard.mEntries.erase(shard.mLru.back());
+      shard.mLru.pop_back();
+    }
+
+    shard.mLru.push_front(cid);
+    it = shard.mEntries.emplace(cid, Entry()).first;
+    it->second.mLru = shard.mLru.begin();
+  } else {
+    shard.mLru.splice(shard.mLru.begin(), shard.mLru, it->second.mLru);
+  }
+
+  Entry& entry = it->second;
+  entry.mVersion = version;
+  entry.mExpiresNs = GetNowNs() +
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(mTTL).count();
+  entry.mItem = item;
+}
+
+//------------------------------------------------------------------------------
+// Drop all entries
+//------------------------------------------------------------------------------
+void
+ContainerPolicyCache::Clear()
+{
+  for (auto& shard : mShards) {
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    shard.mEntries.clear();
+    shard.mLru.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get number of entries
+//------------------------------------------------------------------------------
+size_t
+ContainerPolicyCache::Size()
+{
+  size_t size = 0;
+
+  for (auto& shard : mShards) {
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    size += shard.mEntries.size();
+  }
+
+  return size;
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,173 @@
+//------------------------------------------------------------------------------
+//! @file ContainerPolicyCache.hh
+//! @brief Cache of the attributes and parsed policies of the directories in
+//! which files are opened
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "mgm/Policy.hh"
+#include "namespace/interface/IContainerMD.hh"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Class ContainerPolicyCache - remembers per container id the
+//! attributes of the directory, linked ones included, together with the
+//! forced layout, space, checksum and placement settings parsed out of them.
+//! A bulk ingest into one directory then lists and parses the attributes
+//! only once instead of for every open.
+//!
+//! An entry is only used while it is younger than the TTL and the version of
+//! the directory - its ctime together with the ctime of the directory named
+//! by sys.attr.link - is the one it was taken with. Setting or removing an
+//! attribute bumps the ctime, the creation of files only the mtime. Entries
+//! are evicted in LRU order from a hash sharded by container id.
+//------------------------------------------------------------------------------
+class ContainerPolicyCache
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Version of a directory, any change invalidates the cached entry
+  //----------------------------------------------------------------------------
+  using Version = std::array<uint64_t, 4>;
+
+  //----------------------------------------------------------------------------
+  //! Attributes and parsed policy of a directory
+  //----------------------------------------------------------------------------
+  struct Item {
+    eos::IContainerMD::XAttrMap mAttrs; ///< attributes with the linked ones
+    Policy::DirPolicy mPolicy; ///< forced settings parsed out of mAttrs
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the TTL of the entries, configured through
+  //! EOS_MGM_POLICY_CACHE_TTL_MS - default 0 which disables the cache
+  //----------------------------------------------------------------------------
+  static std::chrono::milliseconds GetTTL();
+
+  //----------------------------------------------------------------------------
+  //! Get the maximum number of entries, configured through
+  //! EOS_MGM_POLICY_CACHE_SIZE - default 10000
+  //----------------------------------------------------------------------------
+  static size_t GetMaxEntries();
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param ttl maximum age of the entries, 0 disables the cache
+  //! @param max_entries maximum number of entries
+  //----------------------------------------------------------------------------
+  ContainerPolicyCache(std::chrono::milliseconds ttl = GetTTL(),
+                       size_t max_entries = GetMaxEntries());
+
+  //----------------------------------------------------------------------------
+  //! Check if the cache is enabled
+  //----------------------------------------------------------------------------
+  inline bool IsEnabled() const
+  {
+    return (mTTL.count() > 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the cached item of a directory
+  //!
+  //! @param cid container id
+  //! @param version current version of the directory
+  //!
+  //! @return item if found, otherwise nullptr
+  //----------------------------------------------------------------------------
+  std::shared_ptr<const Item> Get(uint64_t cid, const Version& version);
+
+  //----------------------------------------------------------------------------
+  //! Store the item of a directory
+  //----------------------------------------------------------------------------
+  void Put(uint64_t cid, const Version& version,
+           const std::shared_ptr<const Item>& item);
+
+  //----------------------------------------------------------------------------
+  //! Drop all entries
+  //----------------------------------------------------------------------------
+  void Clear();
+
+  //----------------------------------------------------------------------------
+  //! Get number of entries
+  //----------------------------------------------------------------------------
+  size_t Size();
+
+  //----------------------------------------------------------------------------
+  //! Get number of lookups which found a valid entry
+  //----------------------------------------------------------------------------
+  uint64_t GetHits() const
+  {
+    return mHits;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of lookups which found no valid entry
+  //----------------------------------------------------------------------------
+  uint64_t GetMisses() const
+  {
+    return mMisses;
+  }
+
+private:
+  struct Entry {
+    Version mVersion; ///< version of the directory
+    int64_t mExpiresNs {0}; ///< steady clock time of expiry
+    std::shared_ptr<const Item> mItem; ///< cached item
+    std::list<uint64_t>::iterator mLru; ///< position in the LRU of the shard
+  };
+
+  struct Shard {
+    std::mutex mMutex;
+    std::unordered_map<uint64_t, Entry> mEntries;
+    std::list<uint64_t> mLru; ///< most recently used first
+  };
+
+  static constexpr size_t sNumShards = 16;
+
+  //----------------------------------------------------------------------------
+  //! Get current steady clock time in nanoseconds
+  //----------------------------------------------------------------------------
+  static int64_t GetNowNs();
+
+  inline Shard& GetShard(uint64_t cid)
+  {
+    return mShards[cid % sNumShards];
+  }
+
+  const std::chrono::milliseconds mTTL; ///< maximum age of the entries
+  const size_t mMaxPerShard; ///< maximum number of entries per shard
+  std::array<Shard, sNumShards> mShards;
+  std::atomic<uint64_t> mHits {0};
+  std::atomic<uint64_t> mMisses {0};
+};
+
+EOSMGMNAMESPACE_END
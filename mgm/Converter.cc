@@ -59,10 +59,14 @@ std::map<std::string, Converter*> eos::mgm::Converter::gConverterMap;
 //------------------------------------------------------------------------------
 ConverterJob::ConverterJob(eos::common::FileId::fileid_t fid,
                            const char* conversionlayout,
-                           std::string& convertername):
+                           std::string& convertername,
+                           const std::string& srcgroup,
+                           const std::string& dstgroup):
   mFid(fid),
   mConversionLayout(conversionlayout),
-  mConverterName(convertername)
+  mConverterName(convertername),
+  mSrcGroup(srcgroup),
+  mDstGroup(dstgroup)
 {
   mProcPath = gOFS->MgmProcConversionPath.c_str();
   mProcPath += "/";
@@ -95,6 +99,7 @@ ConverterJob::DoIt()
   XrdOucString sourceChecksum;
   XrdOucString sourceAfterChecksum;
   XrdOucString sourceSize;
+  std::string errmsg;
   Converter* startConverter = 0;
   Converter* stopConverter = 0;
   {
@@ -145,6 +150,7 @@ ConverterJob::DoIt()
       }
     } catch (eos::MDException& e) {
       errno = e.getErrno();
+      errmsg = e.getMessage().str();
       eos_static_err("fid=%016x errno=%d msg=\"%s\"\n",
                      mFid, e.getErrno(), e.getMessage().str().c_str());
     }
@@ -211,7 +217,12 @@ ConverterJob::DoIt()
       XrdCl::XRootDStatus lTpcStatus = lCopyProcess.Run(0);
       eos_static_info("[tpc]: %s %d", lTpcStatus.ToStr().c_str(), lTpcStatus.IsOK());
       success = lTpcStatus.IsOK();
+
+      if (!success) {
+        errmsg = lTpcStatus.ToStr();
+      }
     } else {
+      errmsg = lTpcPrepareStatus.ToStr();
       success = false;
     }
   } else {
@@ -220,6 +231,11 @@ ConverterJob::DoIt()
     // -------------------------------------------------------------------------
     eos_static_err("msg=\"conversion layout definition wrong\" fxid=%016x layout=%s",
                    mFid, mConversionLayout.c_str());
+
+    if (errmsg.empty()) {
+      errmsg = "conversion layout definition wrong";
+    }
+
     success = false;
   }
 
@@ -240,6 +256,11 @@ ConverterJob::DoIt()
 
     if (sourceChecksum != sourceAfterChecksum) {
       eos_static_err("fid=%016x conversion failed since file was modified", mFid);
+
+      if (success) {
+        errmsg = "file was modified during the conversion";
+      }
+
       success = false;
     }
   }
@@ -257,29 +278,27 @@ ConverterJob::DoIt()
                        mProcPath.c_str(),
                        eos::common::LayoutId::GetStripeNumber(fmd->getLayoutId()) + 1,
                        fmd->getNumLocation());
+
+        if (success) {
+          errmsg = "wrong stripe number";
+        }
+
         success = false;
       }
     } catch (eos::MDException& e) {
       eos_static_err("path=%s errno=%d msg=\"%s\"\n",
                      mProcPath.c_str(), e.getErrno(), e.getMessage().str().c_str());
       errno = e.getErrno();
+
+      if (success) {
+        errmsg = e.getMessage().str();
+      }
+
       success = false;
     }
   }
   eos_static_info("msg=\"stop tpc job\" fxid=%016x layout=%s success=%d",
                   mFid, mConversionLayout.c_str(), success);
-  {
-    // We can only call-back to the Converter object if it wasn't destroyed/
-    // recreated in the mean-while.
-    XrdSysMutexHelper cLock(Converter::gConverterMapMutex);
-    stopConverter = Converter::gConverterMap[mConverterName];
-
-    if (startConverter && (startConverter == stopConverter)) {
-      stopConverter->GetSignal()->Signal();
-      stopConverter->DecActiveJobs();
-    }
-  }
-
   if (success) {
     // Merge the conversion entry
     if (!gOFS->merge(mProcPath.c_str(), mSourcePath.c_str(), error, rootvid)) {
@@ -290,6 +309,8 @@ ConverterJob::DoIt()
       eos_static_err("msg=\"failed to remove failed conversion job entry\" name=\"%s\"",
                      mConversionLayout.c_str());
       gOFS->MgmStats.Add("ConversionFailed", owner_uid, owner_gid, 1);
+      errmsg = "failed to merge the conversion entry";
+      success = false;
     }
   } else {
     // Set owner nobody to indicate that this is a failed/faulty entry
@@ -304,13 +325,32 @@ ConverterJob::DoIt()
     gOFS->MgmStats.Add("ConversionFailed", owner_uid, owner_gid, 1);
   }
 
+  {
+    // We can only call-back to the Converter object if it wasn't destroyed/
+    // recreated in the mean-while.
+    XrdSysMutexHelper cLock(Converter::gConverterMapMutex);
+    stopConverter = Converter::gConverterMap[mConverterName];
+
+    if (startConverter && (startConverter == stopConverter)) {
+      char xfid[20];
+      snprintf(xfid, sizeof(xfid), "%016llx", (long long) mFid);
+      std::string entry = xfid;
+      entry += ":";
+      entry += mConversionLayout.c_str();
+      stopConverter->JobDone(mSrcGroup, mDstGroup, entry, success, size, errmsg);
+      stopConverter->GetSignal()->Signal();
+      stopConverter->DecActiveJobs();
+    }
+  }
+
   delete this;
 }
 
 //------------------------------------------------------------------------------
 // Constructor by space name
 //------------------------------------------------------------------------------
-Converter::Converter(const char* spacename)
+Converter::Converter(const char* spacename):
+  mProgress(spacename), mLastPublish(time(NULL)), mLastBytes(0), mLastDone(0)
 {
   mSpaceName = spacename;
   XrdSysMutexHelper sLock(gSchedulerMutex);
@@ -367,15 +407,29 @@ Converter::Convert(ThreadAssistant& assistant) noexcept
     ResetJobs();
   }
 
+  // Continue the counters of a conversion campaign interrupted by a restart
+  if (mProgress.Load()) {
+    eos_static_info("msg=\"loaded converter progress\" space=%s done=%llu "
+                    "failed=%llu bytes=%llu", mSpaceName.c_str(),
+                    (unsigned long long) mProgress.mDone,
+                    (unsigned long long) mProgress.mFailed,
+                    (unsigned long long) mProgress.mBytes);
+  }
+
+  mLastPublish = time(NULL);
+  mLastBytes = mProgress.mBytes;
+  mLastDone = mProgress.mDone;
+
   // loop forever until cancelled
   // the conversion fid set points from file id to conversion attribute name in
   // the parent container of the fid
-  std::map<eos::common::FileId::fileid_t, std::string> lConversionFidMap;
+  std::map<eos::common::FileId::fileid_t, ConversionEntry> lConversionFidMap;
 
   while (!assistant.terminationRequested()) {
     bool IsSpaceConverter = true;
     bool IsMaster = true;
     int lSpaceTransfers = 0;
+    size_t lGroupTransfers = 0;
     {
       // Extract the current settings if conversion enabled and how many
       // conversion jobs should run.
@@ -403,6 +457,8 @@ Converter::Convert(ThreadAssistant& assistant) noexcept
 
       lSpaceTransfers = atoi(FsView::gFsView.mSpaceView[mSpaceName.c_str()]-> \
                              GetConfigMember("converter.ntx").c_str());
+      lGroupTransfers = strtoul(FsView::gFsView.mSpaceView[mSpaceName.c_str()]->
+                                GetConfigMember("converter.group.ntx").c_str(), 0, 10);
       FsView::gFsView.ViewMutex.UnLockRead();
     }
     IsMaster = gOFS->mMaster->IsMaster();
@@ -449,7 +505,7 @@ Converter::Convert(ThreadAssistant& assistant) noexcept
               if (conversionattribute.beginswith(mSpaceName.c_str())) {
                 // This is a valid entry like <fxid>:<attribute> and we add it
                 // to the set if <attribute> starts with our space name!
-                lConversionFidMap[eos::common::FileId::Hex2Fid(fxid.c_str())] =
+                lConversionFidMap[eos::common::FileId::Hex2Fid(fxid.c_str())].mLayout =
                   conversionattribute.c_str();
 
                 // We set owner admin to indicate that this is a scheduled entry
@@ -501,35 +557,202 @@ Converter::Convert(ThreadAssistant& assistant) noexcept
       }
     }
 
-    // Schedule some conversion jobs if any
+    // Schedule some conversion jobs if any, entries whose source or
+    // destination group has no free slot stay queued for the next round
     int nschedule = lSpaceTransfers - mActiveJobs;
+    size_t nscanned = 0;
+
+    for (auto it = lConversionFidMap.begin();
+         (nschedule > 0) && (it != lConversionFidMap.end()) &&
+         (nscanned < sMaxScan); ++nscanned) {
+      std::string srcgroup;
+      std::string dstgroup;
+
+      if (lGroupTransfers) {
+        if (!it->second.mResolved) {
+          ResolveGroups(it->first, it->second);
+        }
 
-    for (int i = 0; i < nschedule; i++) {
-      if (lConversionFidMap.size()) {
-        auto it = lConversionFidMap.begin();
-        ConverterJob* job = new ConverterJob(it->first,
-                                             it->second.c_str(),
-                                             mSpaceName);
+        if (!AcquireGroups(it->second.mSrcGroup, it->second.mDstGroup,
+                           lGroupTransfers)) {
+          ++it;
+          continue;
+        }
+
+        srcgroup = it->second.mSrcGroup;
+        dstgroup = it->second.mDstGroup;
+      }
+
+      ConverterJob* job = new ConverterJob(it->first,
+                                           it->second.mLayout.c_str(),
+                                           mSpaceName, srcgroup, dstgroup);
+      {
         // use the global shared scheduler
         XrdSysMutexHelper sLock(gSchedulerMutex);
         gScheduler->Schedule((XrdJob*) job);
-        IncActiveJobs();
-        // Remove the entry from the conversion map
-        lConversionFidMap.erase(lConversionFidMap.begin());
-      } else {
-        break;
       }
+      IncActiveJobs();
+      --nschedule;
+      // Remove the entry from the conversion map
+      it = lConversionFidMap.erase(it);
+    }
+
+    PublishThroughput();
+
+    // Wait for a job to finish, at most one second
+    mDoneSignal.Wait(1);
+
+    if (assistant.terminationRequested()) {
+      return;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Resolve the source and destination group of a conversion entry
+//------------------------------------------------------------------------------
+void
+Converter::ResolveGroups(eos::common::FileId::fileid_t fid,
+                         ConversionEntry& entry)
+{
+  entry.mResolved = true;
+  // A conversion to <space>.<index>#<layout> names its target group
+  std::string layout = entry.mLayout;
+  size_t pos = layout.find('#');
+
+  if (pos != std::string::npos) {
+    layout.erase(pos);
+
+    if (layout.find('.') != std::string::npos) {
+      entry.mDstGroup = layout;
+    }
+  }
+
+  eos::common::FileSystem::fsid_t fsid = 0;
+  {
+    eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, fid);
+    eos::common::RWMutexReadLock nsLock(gOFS->eosViewRWMutex);
+
+    try {
+      std::shared_ptr<eos::IFileMD> fmd = gOFS->eosFileService->getFileMD(fid);
+
+      if (fmd->getNumLocation()) {
+        fsid = fmd->getLocation(0);
+      }
+    } catch (eos::MDException& e) {
+      eos_static_debug("fid=%016x errno=%d msg=\"%s\"", fid, e.getErrno(),
+                       e.getMessage().str().c_str());
     }
+  }
 
-    // Let some time pass or wait for a notification
-    for (int i = 0; i < 10; i++) {
-      mDoneSignal.Wait(1);
+  if (fsid) {
+    eos::common::RWMutexReadLock viewLock(FsView::gFsView.ViewMutex);
+    auto it = FsView::gFsView.mIdView.find(fsid);
+
+    if (it != FsView::gFsView.mIdView.end()) {
+      entry.mSrcGroup = it->second->GetString("schedgroup");
+    }
+  }
+}
 
-      if (assistant.terminationRequested()) {
-        return;
+//------------------------------------------------------------------------------
+// Take a job slot of the source and destination group
+//------------------------------------------------------------------------------
+bool
+Converter::AcquireGroups(const std::string& srcgroup,
+                         const std::string& dstgroup, size_t limit)
+{
+  XrdSysMutexHelper gLock(mGroupJobsMutex);
+  std::string srckey = "src:" + srcgroup;
+  std::string dstkey = "dst:" + dstgroup;
+
+  if ((!srcgroup.empty() && (mGroupJobs[srckey] >= limit)) ||
+      (!dstgroup.empty() && (mGroupJobs[dstkey] >= limit))) {
+    return false;
+  }
+
+  if (!srcgroup.empty()) {
+    mGroupJobs[srckey]++;
+  }
+
+  if (!dstgroup.empty()) {
+    mGroupJobs[dstkey]++;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Account for a finished conversion job
+//------------------------------------------------------------------------------
+void
+Converter::JobDone(const std::string& srcgroup, const std::string& dstgroup,
+                   const std::string& entry, bool success, uint64_t bytes,
+                   const std::string& error)
+{
+  {
+    XrdSysMutexHelper gLock(mGroupJobsMutex);
+    auto release = [this](const std::string & key) {
+      auto it = mGroupJobs.find(key);
+
+      if ((it != mGroupJobs.end()) && !--it->second) {
+        mGroupJobs.erase(it);
       }
+    };
+
+    if (!srcgroup.empty()) {
+      release("src:" + srcgroup);
+    }
+
+    if (!dstgroup.empty()) {
+      release("dst:" + dstgroup);
     }
   }
+
+  if (success) {
+    mProgress.AddDone(entry, bytes);
+  } else {
+    mProgress.AddFailed(entry, error);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Publish the conversion counters and the throughput in the space view
+//------------------------------------------------------------------------------
+void
+Converter::PublishThroughput()
+{
+  time_t now = time(NULL);
+
+  if (now < mLastPublish + 10) {
+    return;
+  }
+
+  uint64_t bytes = mProgress.mBytes;
+  uint64_t done = mProgress.mDone;
+  uint64_t rate = (bytes - mLastBytes) / (now - mLastPublish);
+  eos_static_info("msg=\"converter throughput\" space=%s rate=%llu "
+                  "files=%llu done=%llu failed=%llu", mSpaceName.c_str(),
+                  (unsigned long long) rate, (unsigned long long)(done - mLastDone),
+                  (unsigned long long) done,
+                  (unsigned long long) mProgress.mFailed);
+  mLastPublish = now;
+  mLastBytes = bytes;
+  mLastDone = done;
+  eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+  auto it = FsView::gFsView.mSpaceView.find(mSpaceName);
+
+  if (it == FsView::gFsView.mSpaceView.end()) {
+    return;
+  }
+
+  it->second->SetConfigMember("stat.converter.rate", std::to_string(rate),
+                              true, "/eos/*/mgm", true);
+  it->second->SetConfigMember("stat.converter.done", std::to_string(done),
+                              true, "/eos/*/mgm", true);
+  it->second->SetConfigMember("stat.converter.failed",
+                              std::to_string((uint64_t) mProgress.mFailed),
+                              true, "/eos/*/mgm", true);
 }
 
 //------------------------------------------------------------------------------
@@ -28,10 +28,12 @@
 #include "common/Logging.hh"
 #include "common/FileId.hh"
 #include "common/AssistedThread.hh"
+#include "mgm/ConverterProgress.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include "Xrd/XrdJob.hh"
 #include <string>
 #include <cstring>
+#include <map>
 
 class XrdScheduler;
 
@@ -49,10 +51,14 @@ public:
   //! @param fid file id of the file to convert
   //! @param conversionlayout string describing the conversion layout to use
   //! @param convertername to be used
+  //! @param srcgroup scheduling group of the source file, can be empty
+  //! @param dstgroup target scheduling group of the conversion, can be empty
   //----------------------------------------------------------------------------
   ConverterJob(eos::common::FileId::fileid_t fid,
                const char* conversionlayout,
-               std::string& convertername);
+               std::string& convertername,
+               const std::string& srcgroup = "",
+               const std::string& dstgroup = "");
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -72,6 +78,8 @@ private:
   std::string mTargetCGI; ///< target CGI of the conversion job
   XrdOucString mConversionLayout; ///< layout name of the target file
   std::string mConverterName; ///< target space name of the conversion
+  std::string mSrcGroup; ///< group of the source replica
+  std::string mDstGroup; ///< group of the conversion target
 };
 
 //------------------------------------------------------------------------------
@@ -160,6 +168,20 @@ public:
   //----------------------------------------------------------------------------
   void ResetJobs();
 
+  //----------------------------------------------------------------------------
+  //! Account for a finished conversion job, called by the job
+  //!
+  //! @param srcgroup source group of the job
+  //! @param dstgroup destination group of the job
+  //! @param entry name of the conversion entry
+  //! @param success true if the conversion was merged
+  //! @param bytes size of the converted file
+  //! @param error error message if failed
+  //----------------------------------------------------------------------------
+  void JobDone(const std::string& srcgroup, const std::string& dstgroup,
+               const std::string& entry, bool success, uint64_t bytes,
+               const std::string& error);
+
   static XrdSysMutex gSchedulerMutex; ///< Used for scheduler singleton
   static XrdScheduler* gScheduler; ///< Scheduler singleton
   static XrdSysMutex gConverterMapMutex; ///< Mutex protecting converter map
@@ -167,10 +189,50 @@ public:
   static std::map<std::string, Converter*> gConverterMap;
 
 private:
+  //----------------------------------------------------------------------------
+  //! Queued conversion entry
+  //----------------------------------------------------------------------------
+  struct ConversionEntry {
+    std::string mLayout; ///< conversion attribute or layout
+    bool mResolved {false}; ///< source and destination group are resolved
+    std::string mSrcGroup; ///< group of the first replica
+    std::string mDstGroup; ///< target group if the conversion names one
+  };
+
+  //----------------------------------------------------------------------------
+  //! Resolve the source and destination group of a conversion entry
+  //----------------------------------------------------------------------------
+  void ResolveGroups(eos::common::FileId::fileid_t fid, ConversionEntry& entry);
+
+  //----------------------------------------------------------------------------
+  //! Take a job slot of the source and destination group
+  //!
+  //! @param limit max number of jobs per group, 0 is unlimited
+  //!
+  //! @return true if there was a free slot in both groups
+  //----------------------------------------------------------------------------
+  bool AcquireGroups(const std::string& srcgroup, const std::string& dstgroup,
+                     size_t limit);
+
+  //----------------------------------------------------------------------------
+  //! Publish the conversion counters and the throughput in the space view
+  //----------------------------------------------------------------------------
+  void PublishThroughput();
+
+  //! Max number of queued entries looked at per scheduling round
+  static constexpr size_t sMaxScan = 10000;
+
   AssistedThread mThread; ///< Thread id
   std::string mSpaceName; ///< name of the espace this converter serves
   size_t mActiveJobs; ///< All the queued jobs that didn't run yet
   XrdSysCondVar mDoneSignal; ///< Condition variable signalled when a job is done
+  XrdSysMutex mGroupJobsMutex; ///< Mutex protecting mGroupJobs
+  //! Running jobs per source ("src:<group>") and destination ("dst:<group>")
+  std::map<std::string, size_t> mGroupJobs;
+  ConverterProgress mProgress; ///< Conversion counters
+  time_t mLastPublish; ///< Time of the last throughput publication
+  uint64_t mLastBytes; ///< Converted bytes at the last publication
+  uint64_t mLastDone; ///< Done conversions at the last publication
 };
 
 EOSMGMNAMESPACE_END
@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------------
+// File: ConverterProgress.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/ConverterProgress.hh"
+#include "mgm/XrdMgmOfs.hh"
+#include "common/Logging.hh"
+#include "namespace/ns_quarkdb/BackendClient.hh"
+#include "namespace/ns_quarkdb/qclient/include/qclient/QHash.hh"
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ConverterProgress::ConverterProgress(const std::string& space):
+  mDone(0), mFailed(0), mBytes(0), mQcl(nullptr),
+  mStateKey("eos-converter-state:" + space),
+  mFailedKey("eos-converter-failed:" + space)
+{
+  if (!gOFS->mQdbCluster.empty()) {
+    mQcl = eos::BackendClient::getInstance(gOFS->mQdbContactDetails,
+                                           "converter");
+  }
+}
+
+//------------------------------------------------------------------------------
+// Load the counters of a previous run
+//------------------------------------------------------------------------------
+bool
+ConverterProgress::Load()
+{
+  if (!mQcl) {
+    return false;
+  }
+
+  bool found = false;
+
+  try {
+    qclient::QHash state(*mQcl, mStateKey);
+
+    for (auto it = state.getIterator(); it.valid(); it.next()) {
+      if (it.getKey() == "done") {
+        mDone = std::stoull(it.getValue());
+        found = true;
+      } else if (it.getKey() == "failed") {
+        mFailed = std::stoull(it.getValue());
+        found = true;
+      } else if (it.getKey() == "bytes") {
+        mBytes = std::stoull(it.getValue());
+        found = true;
+      }
+    }
+  } catch (const std::exception& e) {
+    eos_static_err("msg=\"failed to load converter progress\" key=%s err=\"%s\"",
+                   mStateKey.c_str(), e.what());
+    return false;
+  }
+
+  return found;
+}
+
+//------------------------------------------------------------------------------
+// Record a successful conversion
+//------------------------------------------------------------------------------
+void
+ConverterProgress::AddDone(const std::string& entry, uint64_t bytes)
+{
+  mDone++;
+  mBytes += bytes;
+
+  if (mQcl) {
+    mQcl->exec("hincrby", mStateKey, "done", "1");
+    mQcl->exec("hincrby", mStateKey, "bytes", std::to_string(bytes));
+    mQcl->exec("hdel", mFailedKey, entry);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Record a failed conversion
+//------------------------------------------------------------------------------
+void
+ConverterProgress::AddFailed(const std::string& entry, const std::string& error)
+{
+  mFailed++;
+
+  if (mQcl) {
+    mQcl->exec("hincrby", mStateKey, "failed", "1");
+    mQcl->exec("hset", mFailedKey, entry, error);
+  }
+}
+
+EOSMGMNAMESPACE_END
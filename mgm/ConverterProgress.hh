@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------------
+//! @file ConverterProgress.hh
+//! @brief Persistency of the conversion progress of a space in QuarkDB
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace qclient
+{
+class QClient;
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Class persisting the progress of the conversions of a space in
+//! QuarkDB
+//!
+//! The hash eos-converter-state:<space> holds the number of done and failed
+//! conversions and the number of converted bytes, the hash
+//! eos-converter-failed:<space> maps the conversion entries which failed to
+//! their error message. The counters are kept in memory and updated
+//! asynchronously, without a QuarkDB namespace nothing is persisted.
+//------------------------------------------------------------------------------
+class ConverterProgress
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param space space served by the converter
+  //----------------------------------------------------------------------------
+  ConverterProgress(const std::string& space);
+
+  //----------------------------------------------------------------------------
+  //! Load the counters of a previous run
+  //!
+  //! @return true if progress was found, otherwise false
+  //----------------------------------------------------------------------------
+  bool Load();
+
+  //----------------------------------------------------------------------------
+  //! Record a successful conversion
+  //!
+  //! @param entry name of the conversion entry
+  //! @param bytes size of the converted file
+  //----------------------------------------------------------------------------
+  void AddDone(const std::string& entry, uint64_t bytes);
+
+  //----------------------------------------------------------------------------
+  //! Record a failed conversion
+  //!
+  //! @param entry name of the conversion entry
+  //! @param error error message
+  //----------------------------------------------------------------------------
+  void AddFailed(const std::string& entry, const std::string& error);
+
+  std::atomic<uint64_t> mDone; ///< Number of done conversions
+  std::atomic<uint64_t> mFailed; ///< Number of failed conversions
+  std::atomic<uint64_t> mBytes; ///< Number of converted bytes
+
+private:
+  qclient::QClient* mQcl; ///< QuarkDB client, nullptr if not persisted
+  std::string mStateKey; ///< Key of the state hash
+  std::string mFailedKey; ///< Key of the failed entries hash
+};
+
+EOSMGMNAMESPACE_END
@@ -26,6 +26,7 @@
 #include "common/StringUtils.hh"
 #include "common/DBG.hh"
 #include <ldap.h>
+#include <cstdlib>
 #include <memory>
 
 //------------------------------------------------------------------------------
@@ -38,24 +39,68 @@ static void ldap_uninitialize(LDAP* ld)
   }
 }
 
+//------------------------------------------------------------------------------
+// Initialize an LDAP context, nullptr if not possible
+//------------------------------------------------------------------------------
+static std::unique_ptr<LDAP, decltype(ldap_uninitialize)*> ldap_connect()
+{
+  LDAP* ld = nullptr;
+  ldap_initialize(&ld, "ldap://xldap");
+  std::unique_ptr<LDAP, decltype(ldap_uninitialize)*> ldOwnership(
+    ld, ldap_uninitialize);
+
+  if (ld == nullptr) {
+    eos_static_crit("Could not initialize ldap context");
+    return ldOwnership;
+  }
+
+  int version = LDAP_VERSION3;
+
+  if (ldap_set_option(ld, LDAP_OPT_PROTOCOL_VERSION, &version) !=
+      LDAP_OPT_SUCCESS) {
+    eos_static_crit("Failure when calling ldap_set_option");
+    ldOwnership.reset();
+  }
+
+  return ldOwnership;
+}
+
 EOSMGMNAMESPACE_BEGIN
 
+constexpr uint64_t Egroup::kRefreshAheadHits;
+constexpr size_t Egroup::kMaxPending;
+
 //------------------------------------------------------------------------------
 // Constructor - launch asynchronous refresh thread
 //------------------------------------------------------------------------------
 Egroup::Egroup(common::SteadyClock* clock_) : clock(clock_)
 {
-  PendingQueue.setBlockingMode(true);
-  mThread.reset(&Egroup::Refresh, this);
+  static size_t sThreads = []() {
+    const char* ptr = getenv("EOS_MGM_EGROUP_REFRESH_THREADS");
+    long long val = (ptr ? strtoll(ptr, nullptr, 10) : 0);
+    return (val > 0 ? (size_t) val : 4);
+  }();
+  mThreads.resize(sThreads);
+
+  for (auto& thread : mThreads) {
+    thread.reset(&Egroup::Refresh, this);
+  }
 }
 
 //------------------------------------------------------------------------------
-// Destructor - join asynchronous refresh thread
+// Destructor - join asynchronous refresh threads
 //------------------------------------------------------------------------------
 Egroup::~Egroup()
 {
-  PendingQueue.setBlockingMode(false);
-  mThread.join();
+  {
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    mStop = true;
+  }
+  mPendingCv.notify_all();
+
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -63,7 +108,7 @@ Egroup::~Egroup()
 //----------------------------------------------------------------------------
 size_t Egroup::getPendingQueueSize() const
 {
-  return PendingQueue.size();
+  return mPendingCount;
 }
 
 //------------------------------------------------------------------------------
@@ -92,24 +137,11 @@ Egroup::Status Egroup::isMemberUncached(const std::string& username,
   }
 
   // run the LDAP query
-  LDAP* ld = nullptr;
-  //----------------------------------------------------------------------------
-  // Initialize the LDAP context.
-  //----------------------------------------------------------------------------
-  ldap_initialize(&ld, "ldap://xldap");
-  std::unique_ptr<LDAP, decltype(ldap_uninitialize)*> ldOwnership(
-    ld, ldap_uninitialize);
+  std::unique_ptr<LDAP, decltype(ldap_uninitialize)*> ldOwnership =
+    ldap_connect();
+  LDAP* ld = ldOwnership.get();
 
   if (ld == nullptr) {
-    eos_static_crit("Could not initialize ldap context");
-    return Status::kError;
-  }
-
-  int version = LDAP_VERSION3;
-
-  if (ldap_set_option(ld, LDAP_OPT_PROTOCOL_VERSION, &version) !=
-      LDAP_OPT_SUCCESS) {
-    eos_static_crit("Failure when calling ldap_set_option");
     return Status::kError;
   }
 
@@ -187,6 +219,95 @@ Egroup::Status Egroup::isMemberUncached(const std::string& username,
   return Status::kNotMember;
 }
 
+//------------------------------------------------------------------------------
+// LDAP lookup of all the members of an Egroup - bypasses the cache
+//------------------------------------------------------------------------------
+Egroup::Status Egroup::membersUncached(const std::string& egroupname,
+                                       std::set<std::string>& members)
+{
+  members.clear();
+
+  //----------------------------------------------------------------------------
+  // Serving real, or simulated data?
+  //----------------------------------------------------------------------------
+  if (!injections.empty()) {
+    auto it = injections.find(egroupname);
+
+    if (it != injections.end()) {
+      for (const auto& elem : it->second) {
+        if (elem.second == Status::kError) {
+          return Status::kError;
+        }
+
+        if (elem.second == Status::kMember) {
+          members.insert(elem.first);
+        }
+      }
+    }
+
+    return Status::kMember;
+  }
+
+  std::unique_ptr<LDAP, decltype(ldap_uninitialize)*> ldOwnership =
+    ldap_connect();
+  LDAP* ld = ldOwnership.get();
+
+  if (ld == nullptr) {
+    return Status::kError;
+  }
+
+  //----------------------------------------------------------------------------
+  // Same recursive membership filter as for a single user, but searching all
+  // the users instead of the entry of a given one
+  //----------------------------------------------------------------------------
+  std::string sbase = "OU=Users,Ou=Organic Units,DC=cern,DC=ch";
+  std::string attr = "cn";
+  std::string filter;
+  filter = "(memberOf:1.2.840.113556.1.4.1941:=CN=";
+  filter += egroupname;
+  filter += ",OU=e-groups,OU=Workgroups,DC=cern,DC=ch)";
+  char* attrs[2];
+  attrs[0] = (char*) attr.c_str();
+  attrs[1] = NULL;
+  LDAPMessage* res = nullptr;
+  struct timeval timeout;
+  timeout.tv_sec = 10;
+  timeout.tv_usec = 0;
+  eos_static_debug("base=%s attr=%s filter=%s\n", sbase.c_str(), attr.c_str(),
+                   filter.c_str());
+  int rc = ldap_search_ext_s(ld, sbase.c_str(), LDAP_SCOPE_SUBTREE,
+                             filter.c_str(),
+                             attrs, 0, NULL, NULL,
+                             &timeout, LDAP_NO_LIMIT, &res);
+  std::unique_ptr<LDAPMessage, decltype(ldap_msgfree)*> resOwnership(res,
+      ldap_msgfree);
+
+  // A truncated result (e.g. LDAP_SIZELIMIT_EXCEEDED) can not be used to
+  // decide that a user is not a member
+  if (res == nullptr || rc != LDAP_SUCCESS) {
+    eos_static_warning("msg=\"failed to list egroup members\" e-group=%s rc=%d",
+                       egroupname.c_str(), rc);
+    return Status::kError;
+  }
+
+  for (LDAPMessage* e = ldap_first_entry(ld, res); e != nullptr;
+       e = ldap_next_entry(ld, e)) {
+    struct berval** v = ldap_get_values_len(ld, e, attr.c_str());
+
+    if (v != nullptr) {
+      int n = ldap_count_values_len(v);
+
+      for (int j = 0; j < n; j++) {
+        members.insert(std::string(v[j]->bv_val, v[j]->bv_len));
+      }
+
+      ldap_value_free_len(v);
+    }
+  }
+
+  return Status::kMember;
+}
+
 //------------------------------------------------------------------------------
 // Store entry into the cache
 //------------------------------------------------------------------------------
@@ -195,14 +316,17 @@ void Egroup::storeIntoCache(const std::string& username,
                             std::chrono::steady_clock::time_point timestamp)
 {
   eos::common::RWMutexWriteLock wr_lock(mMutex);
-  cache[egroupname][username] = CachedEntry(isMember, timestamp);
+  CacheSlot& slot = cache[egroupname][username];
+  slot.entry = CachedEntry(isMember, timestamp);
+  slot.hits = 0;
 }
 
 //------------------------------------------------------------------------------
 // Fetch cached value. Returns false if there's no such cached value.
 //------------------------------------------------------------------------------
 bool Egroup::fetchCached(const std::string& username,
-                         const std::string& egroupname, Egroup::CachedEntry& out)
+                         const std::string& egroupname, Egroup::CachedEntry& out,
+                         uint64_t* hits)
 {
   eos::common::RWMutexReadLock rd_lock(mMutex);
   auto it = cache.find(egroupname);
@@ -217,7 +341,12 @@ bool Egroup::fetchCached(const std::string& username,
     return false;
   }
 
-  out = it2->second;
+  out = it2->second.entry;
+
+  if (hits) {
+    *hits = ++it2->second.hits;
+  }
+
   return true;
 }
 
@@ -255,13 +384,19 @@ Egroup::CachedEntry Egroup::query(const std::string& username,
                                   const std::string& egroupname)
 {
   CachedEntry entry;
+  uint64_t hits = 0;
 
-  if (fetchCached(username, egroupname, entry)) {
+  if (fetchCached(username, egroupname, entry, &hits)) {
     //--------------------------------------------------------------------------
-    // Cache hit - do we need to schedule an asynchronous refresh?
+    // Cache hit - do we need to schedule an asynchronous refresh? Frequently
+    // accessed entries are refreshed before they expire.
     //--------------------------------------------------------------------------
     if (isStale(entry)) {
       scheduleRefresh(username, egroupname);
+    } else if ((hits >= kRefreshAheadHits) &&
+               (entry.timestamp + kCacheDuration - kRefreshAhead <
+                common::SteadyClock::now(clock))) {
+      scheduleRefresh(username, egroupname);
     }
 
     return entry;
@@ -288,28 +423,61 @@ Egroup::CachedEntry Egroup::query(const std::string& username,
 //------------------------------------------------------------------------------
 // Asynchronous refresh loop.
 //
-// The looping thread takes Egroup requests and run's LDAP queries pushing
-// results into the Egroup membership map and updates the lifetime of the
-// resolved entry.
+// The looping threads take Egroup requests and run LDAP queries pushing
+// results into the Egroup membership map and update the lifetime of the
+// resolved entries. All the pending users of an egroup are taken at once and
+// resolved with a single query if there are several of them.
 //------------------------------------------------------------------------------
 void Egroup::Refresh(ThreadAssistant& assistant) noexcept
 {
   eos_static_info("msg=\"async egroup fetch thread started\"");
-  auto iterator = PendingQueue.begin();
 
-  while (!assistant.terminationRequested()) {
-    std::pair<std::string, std::string>* resolve = iterator.getItemBlockOrNull();
+  while (true) {
+    std::string egroupname;
+    std::set<std::string> usernames;
+    {
+      std::unique_lock<std::mutex> lock(mPendingMutex);
+      mPendingCv.wait(lock, [&]() {
+        return (mStop || !mPendingGroups.empty());
+      });
+
+      if (mStop) {
+        break;
+      }
 
-    if (!resolve) {
-      break;
+      egroupname = mPendingGroups.front();
+      mPendingGroups.pop_front();
+      auto it = mPendingUsers.find(egroupname);
+
+      if (it == mPendingUsers.end()) {
+        continue;
+      }
+
+      usernames.swap(it->second);
+      mPendingUsers.erase(it);
+      mInFlightUsers[egroupname].insert(usernames.begin(), usernames.end());
+    }
+
+    if (usernames.size() == 1) {
+      refresh(*usernames.begin(), egroupname);
+    } else {
+      refreshGroup(egroupname, usernames);
     }
 
-    if (!resolve->first.empty()) {
-      refresh(resolve->first, resolve->second);
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    auto it = mInFlightUsers.find(egroupname);
+
+    if (it != mInFlightUsers.end()) {
+      for (const auto& username : usernames) {
+        it->second.erase(username);
+      }
+
+      if (it->second.empty()) {
+        mInFlightUsers.erase(it);
+      }
     }
 
-    iterator.next();
-    PendingQueue.pop_front();
+    mPendingCount -= usernames.size();
   }
 }
 
@@ -319,7 +487,39 @@ void Egroup::Refresh(ThreadAssistant& assistant) noexcept
 void Egroup::scheduleRefresh(const std::string& username,
                              const std::string& egroupname)
 {
-  PendingQueue.emplace_back(std::make_pair(username, egroupname));
+  if (username.empty()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+
+    if (mPendingCount >= kMaxPending) {
+      // The stale entry keeps being served and is scheduled again later
+      return;
+    }
+
+    auto it = mInFlightUsers.find(egroupname);
+
+    if ((it != mInFlightUsers.end()) && it->second.count(username)) {
+      return;
+    }
+
+    auto it_pending = mPendingUsers.find(egroupname);
+
+    if (it_pending == mPendingUsers.end()) {
+      mPendingGroups.push_back(egroupname);
+      it_pending = mPendingUsers.emplace(egroupname,
+                                         std::set<std::string>()).first;
+    }
+
+    if (!it_pending->second.insert(username).second) {
+      return;
+    }
+
+    ++mPendingCount;
+  }
+  mPendingCv.notify_one();
 }
 
 //------------------------------------------------------------------------------
@@ -349,6 +549,31 @@ Egroup::CachedEntry Egroup::refresh(const std::string& username,
   return CachedEntry(isMember, now);
 }
 
+//------------------------------------------------------------------------------
+// Refresh several users of an Egroup with a single LDAP query
+//------------------------------------------------------------------------------
+void Egroup::refreshGroup(const std::string& egroupname,
+                          const std::set<std::string>& usernames)
+{
+  eos_static_info("msg=\"async-lookup\" e-group=\"%s\" users=%lu",
+                  egroupname.c_str(), (unsigned long) usernames.size());
+  std::set<std::string> members;
+
+  if (membersUncached(egroupname, members) == Status::kError) {
+    for (const auto& username : usernames) {
+      refresh(username, egroupname);
+    }
+
+    return;
+  }
+
+  std::chrono::steady_clock::time_point now = common::SteadyClock::now(clock);
+
+  for (const auto& username : usernames) {
+    storeIntoCache(username, egroupname, members.count(username) != 0, now);
+  }
+}
+
 //------------------------------------------------------------------------------
 // Return membership information as string.
 // @param username name of the user to dump Egroup membership
@@ -387,9 +612,9 @@ Egroup::DumpMembers()
     for (auto it2 = it->second.begin(); it2 != it->second.end(); it2++) {
       ss << "egroup=" << it->first;
       ss << " user=" << it2->first;
-      ss << " member=" << common::boolToString(it2->second.isMember);
+      ss << " member=" << common::boolToString(it2->second.entry.isMember);
       std::chrono::seconds lifetime = std::chrono::duration_cast <
-                                      std::chrono::seconds > ((it2->second.timestamp + kCacheDuration) - now);
+                                      std::chrono::seconds > ((it2->second.entry.timestamp + kCacheDuration) - now);
       ss << " lifetime=" << std::to_string(lifetime.count()) << std::endl;
     }
   }
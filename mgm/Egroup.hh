@@ -28,11 +28,16 @@
 #include "common/AssistedThread.hh"
 #include "common/SteadyClock.hh"
 #include "common/RWMutex.hh"
-#include <qclient/WaitableQueue.hh>
 #include "XrdSys/XrdSysPthread.hh"
 #include <sys/types.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <string>
 #include <map>
+#include <set>
+#include <vector>
 #include <chrono>
 
 /*----------------------------------------------------------------------------*/
@@ -58,12 +63,16 @@ EOSMGMNAMESPACE_BEGIN
 //! Provides functionality for checking egroup membership by username / egroup
 //! name.
 //!
-//! The Egroup object maintains a thread which is serving async Egroup
+//! The Egroup object maintains a pool of threads which is serving async Egroup
 //! membership update requests.
 //!
 //! The problem here is that the calling function in the MGM has a read lock
 //! during the Egroup::Member call and the refreshing of Egroup permissions
 //! should be done if possible asynchronously to avoid mutex starvation.
+//! Stale entries are therefore served while they are refreshed in the
+//! background, and entries accessed frequently are refreshed ahead of their
+//! expiration. Pending refreshes of several users of the same egroup are
+//! resolved with a single LDAP search listing the members of the egroup.
 //------------------------------------------------------------------------------
 class Egroup
 {
@@ -134,10 +143,12 @@ public:
 
   //----------------------------------------------------------------------------
   // Fetch cached value, and fills variable out if a result is found.
-  // Return false if item does not exist in cache.
+  // Return false if item does not exist in cache. If hits is given, the access
+  // is counted and the number of accesses since the last refresh returned.
   //----------------------------------------------------------------------------
   bool fetchCached(const std::string& username,
-                   const std::string& egroupname, CachedEntry& out);
+                   const std::string& egroupname, CachedEntry& out,
+                   uint64_t* hits = nullptr);
 
   //----------------------------------------------------------------------------
   // Inject item into the fake LDAP server. If injections are active, any time
@@ -161,13 +172,39 @@ public:
   CachedEntry refresh(const std::string& username,
                       const std::string& egroupname);
 
+  //----------------------------------------------------------------------------
+  //! Synchronous refresh of several users of an Egroup with a single LDAP
+  //! query listing the members of the Egroup. Falls back to one query per
+  //! user if the members can not be listed.
+  //----------------------------------------------------------------------------
+  void refreshGroup(const std::string& egroupname,
+                    const std::set<std::string>& usernames);
+
 private:
   const std::chrono::seconds kCacheDuration
   {
     1800
   };
+  //! Window before the expiration in which frequently accessed entries are
+  //! refreshed ahead
+  const std::chrono::seconds kRefreshAhead
+  {
+    180
+  };
+  //! Accesses since the last refresh making an entry frequently accessed
+  static constexpr uint64_t kRefreshAheadHits = 10;
+  //! Max number of pending refresh requests, further requests are dropped
+  static constexpr size_t kMaxPending = 10000;
   eos::common::SteadyClock* clock = nullptr;
 
+  //----------------------------------------------------------------------------
+  //! Cached entry and number of accesses since its last refresh
+  //----------------------------------------------------------------------------
+  struct CacheSlot {
+    CachedEntry entry;
+    std::atomic<uint64_t> hits {0};
+  };
+
   //----------------------------------------------------------------------------
   //! Store entry into the cache
   //----------------------------------------------------------------------------
@@ -175,8 +212,8 @@ private:
                       const std::string& egroupname, bool isMember,
                       std::chrono::steady_clock::time_point timestamp);
 
-  /// async refresh thread
-  AssistedThread mThread;
+  /// async refresh threads
+  std::vector<AssistedThread> mThreads;
 
   //----------------------------------------------------------------------------
   //! Check if cache entry is stale
@@ -192,10 +229,22 @@ private:
   eos::common::RWMutex mMutex;
 
   /// map indicating egroup memebership for egroup/username pairs
-  std::map<std::string, std::map<std::string, CachedEntry>> cache;
-
-  /// thred-safe queue keeping track of pending refresh requests
-  qclient::WaitableQueue<std::pair<std::string, std::string>, 500> PendingQueue;
+  std::map<std::string, std::map<std::string, CacheSlot>> cache;
+
+  /// mutex protecting the pending refresh requests
+  std::mutex mPendingMutex;
+  /// signalled when refresh requests are pending or on shutdown
+  std::condition_variable mPendingCv;
+  /// egroups with pending refresh requests in order of arrival
+  std::deque<std::string> mPendingGroups;
+  /// users with a pending refresh request per egroup
+  std::map<std::string, std::set<std::string>> mPendingUsers;
+  /// users being refreshed per egroup
+  std::map<std::string, std::set<std::string>> mInFlightUsers;
+  /// number of pending and in flight refresh requests
+  std::atomic<size_t> mPendingCount {0};
+  /// set on shutdown to stop the refresh threads
+  bool mStop = false;
 
   /// injections to simulate LDAP server responses - different than the cache
   std::map<std::string, std::map<std::string, Status>> injections;
@@ -206,6 +255,17 @@ private:
   Status isMemberUncached(const std::string& username,
                           const std::string& egroupname);
 
+  //----------------------------------------------------------------------------
+  //! LDAP lookup of all the members of an Egroup - bypasses the cache
+  //!
+  //! @param egroupname name of the Egroup
+  //! @param members output user names of the members
+  //!
+  //! @return kMember if the members were listed, otherwise kError
+  //----------------------------------------------------------------------------
+  Status membersUncached(const std::string& egroupname,
+                         std::set<std::string>& members);
+
 public:
 
 };
@@ -0,0 +1,267 @@
+//------------------------------------------------------------------------------
+//! @file FsSizeIndex.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/FsSizeIndex.hh"
+#include "mgm/XrdMgmOfs.hh"
+#include "common/Logging.hh"
+#include "common/RWMutex.hh"
+#include "namespace/interface/IFsView.hh"
+#include "namespace/interface/IView.hh"
+#include "namespace/Prefetcher.hh"
+#include <algorithm>
+
+EOSMGMNAMESPACE_BEGIN
+
+constexpr int FsSizeIndex::kNumBuckets;
+constexpr size_t FsSizeIndex::kMaxPerBucket;
+constexpr size_t FsSizeIndex::kRefreshSize;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FsSizeIndex::FsSizeIndex():
+  mGenerator(std::random_device()())
+{}
+
+//------------------------------------------------------------------------------
+// Add or update the sample of a file
+//------------------------------------------------------------------------------
+void
+FsSizeIndex::Add(eos::common::FileSystem::fsid_t fsid, uint64_t fid,
+                 uint64_t size)
+{
+  FsSamples& samples = mFs[fsid];
+  int bucket = GetBucket(size);
+  auto it = samples.mBucketOf.find(fid);
+
+  if (it != samples.mBucketOf.end()) {
+    if (it->second == bucket) {
+      for (auto& sample : samples.mBuckets[bucket]) {
+        if (sample.mFid == fid) {
+          sample.mSize = size;
+          break;
+        }
+      }
+
+      return;
+    }
+
+    Remove(fsid, fid);
+  }
+
+  std::vector<Sample>& samples_in_bucket = samples.mBuckets[bucket];
+
+  if (samples_in_bucket.size() < kMaxPerBucket) {
+    samples_in_bucket.push_back(Sample{fid, size});
+  } else {
+    // Replace the oldest sample of the bucket
+    size_t& next = samples.mNext[bucket];
+    samples.mBucketOf.erase(samples_in_bucket[next].mFid);
+    samples_in_bucket[next] = Sample{fid, size};
+    next = (next + 1) % kMaxPerBucket;
+  }
+
+  samples.mBucketOf[fid] = bucket;
+}
+
+//------------------------------------------------------------------------------
+// Remove the sample of a file
+//------------------------------------------------------------------------------
+void
+FsSizeIndex::Remove(eos::common::FileSystem::fsid_t fsid, uint64_t fid)
+{
+  auto it_fs = mFs.find(fsid);
+
+  if (it_fs == mFs.end()) {
+    return;
+  }
+
+  FsSamples& samples = it_fs->second;
+  auto it = samples.mBucketOf.find(fid);
+
+  if (it == samples.mBucketOf.end()) {
+    return;
+  }
+
+  std::vector<Sample>& samples_in_bucket = samples.mBuckets[it->second];
+  samples.mBucketOf.erase(it);
+
+  for (size_t i = 0; i < samples_in_bucket.size(); ++i) {
+    if (samples_in_bucket[i].mFid == fid) {
+      samples_in_bucket[i] = samples_in_bucket.back();
+      samples_in_bucket.pop_back();
+      break;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Pick a sampled file from the biggest bucket holding a size in the range
+//------------------------------------------------------------------------------
+bool
+FsSizeIndex::Pick(eos::common::FileSystem::fsid_t fsid, uint64_t min_size,
+                  uint64_t max_size, const std::function<bool(uint64_t)>& skip,
+                  uint64_t& fid, uint64_t& size)
+{
+  auto it_fs = mFs.find(fsid);
+
+  if ((it_fs == mFs.end()) || (max_size && (max_size < min_size))) {
+    return false;
+  }
+
+  int min_bucket = GetBucket(min_size);
+  int max_bucket = (max_size ? GetBucket(max_size) : kNumBuckets - 1);
+  std::vector<const Sample*> candidates;
+
+  for (int bucket = max_bucket; bucket >= min_bucket; --bucket) {
+    candidates.clear();
+
+    for (const auto& sample : it_fs->second.mBuckets[bucket]) {
+      if ((sample.mSize >= min_size) &&
+          (!max_size || (sample.mSize <= max_size)) &&
+          !(skip && skip(sample.mFid))) {
+        candidates.push_back(&sample);
+      }
+    }
+
+    if (!candidates.empty()) {
+      std::uniform_int_distribution<size_t> dist(0, candidates.size() - 1);
+      const Sample* sample = candidates[dist(mGenerator)];
+      fid = sample->mFid;
+      size = sample->mSize;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Sample the next page of the file list of a filesystem from the namespace
+//------------------------------------------------------------------------------
+void
+FsSizeIndex::Refresh(eos::common::FileSystem::fsid_t fsid, size_t num_files)
+{
+  FsSamples& samples = mFs[fsid];
+  std::vector<eos::IFileMD::id_t> fids;
+  {
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+    if (samples.mCursor.empty()) {
+      samples.mCursor = "0";
+    }
+
+    auto it_fid = gOFS->eosFsView->getPagedFileList(fsid, samples.mCursor,
+                  num_files);
+
+    if (!it_fid || !it_fid->valid()) {
+      // Start over with the first page once the whole list was sampled
+      samples.mCursor = "0";
+      return;
+    }
+
+    std::string page = it_fid->getCursor();
+
+    for (; it_fid->valid() && (it_fid->getCursor() == page); it_fid->next()) {
+      fids.push_back(it_fid->getElement());
+    }
+
+    samples.mCursor = (it_fid->valid() ? it_fid->getCursor() : "0");
+  }
+  eos::Prefetcher prefetcher(gOFS->eosView);
+  prefetcher.stageFileMDs(fids);
+  prefetcher.wait();
+  eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+  for (auto fid : fids) {
+    try {
+      std::shared_ptr<eos::IFileMD> fmd = gOFS->eosFileService->getFileMD(fid);
+
+      if (fmd->hasLocation(fsid)) {
+        Add(fsid, fid, fmd->getSize());
+        continue;
+      }
+    } catch (eos::MDException& e) {
+      eos_static_debug("msg=\"exception\" ec=%d emsg=\"%s\"", e.getErrno(),
+                       e.getMessage().str().c_str());
+    }
+
+    Remove(fsid, fid);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Refresh the samples of a filesystem and choose a file in the size range
+//------------------------------------------------------------------------------
+bool
+FsSizeIndex::Choose(eos::common::FileSystem::fsid_t fsid, uint64_t min_size,
+                    uint64_t max_size, const std::function<bool(uint64_t)>& skip,
+                    uint64_t& fid)
+{
+  Refresh(fsid);
+  uint64_t size = 0;
+
+  while (Pick(fsid, min_size, max_size, skip, fid, size)) {
+    eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, fid);
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+    // Stale samples are dropped or corrected and the next one is tried
+    Remove(fsid, fid);
+
+    try {
+      std::shared_ptr<eos::IFileMD> fmd = gOFS->eosFileService->getFileMD(fid);
+
+      if (fmd->hasLocation(fsid)) {
+        Add(fsid, fid, fmd->getSize());
+
+        if (fmd->getSize() == size) {
+          return true;
+        }
+      }
+    } catch (eos::MDException& e) {
+      eos_static_debug("msg=\"exception\" ec=%d emsg=\"%s\"", e.getErrno(),
+                       e.getMessage().str().c_str());
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Get the number of samples of a filesystem
+//------------------------------------------------------------------------------
+size_t
+FsSizeIndex::GetNumSamples(eos::common::FileSystem::fsid_t fsid) const
+{
+  auto it_fs = mFs.find(fsid);
+  return ((it_fs == mFs.end()) ? 0 : it_fs->second.mBucketOf.size());
+}
+
+//------------------------------------------------------------------------------
+// Get the bucket of a size
+//------------------------------------------------------------------------------
+int
+FsSizeIndex::GetBucket(uint64_t size)
+{
+  return (size ? 64 - __builtin_clzll(size) : 0);
+}
+
+EOSMGMNAMESPACE_END
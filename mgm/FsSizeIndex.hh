@@ -0,0 +1,155 @@
+//------------------------------------------------------------------------------
+//! @file FsSizeIndex.hh
+//! @brief Size bucketed samples of the files of the filesystems for balancing
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/FileSystem.hh"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Samples of the files of each filesystem, bucketed by their size in
+//! powers of two, used by the balancers to move the most bytes per transfer
+//!
+//! Every refresh adds the sizes of the next page of the filesystem file list,
+//! so the samples follow the filesystem contents incrementally without ever
+//! loading the whole list. Each bucket keeps at most kMaxPerBucket samples,
+//! the oldest one is replaced when a bucket is full. Samples may be stale,
+//! the chosen files are checked against the namespace before being returned.
+//! The index belongs to one balancer thread and is not thread-safe.
+//------------------------------------------------------------------------------
+class FsSizeIndex
+{
+public:
+  //! Number of size buckets, bucket b holds the sizes in [2^(b-1), 2^b)
+  static constexpr int kNumBuckets = 65;
+  //! Max number of samples per bucket and filesystem
+  static constexpr size_t kMaxPerBucket = 256;
+  //! Number of file ids sampled per refresh
+  static constexpr size_t kRefreshSize = 200;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  FsSizeIndex();
+
+  //----------------------------------------------------------------------------
+  //! Add or update the sample of a file
+  //!
+  //! @param fsid filesystem id
+  //! @param fid file id
+  //! @param size file size
+  //----------------------------------------------------------------------------
+  void Add(eos::common::FileSystem::fsid_t fsid, uint64_t fid, uint64_t size);
+
+  //----------------------------------------------------------------------------
+  //! Remove the sample of a file
+  //!
+  //! @param fsid filesystem id
+  //! @param fid file id
+  //----------------------------------------------------------------------------
+  void Remove(eos::common::FileSystem::fsid_t fsid, uint64_t fid);
+
+  //----------------------------------------------------------------------------
+  //! Pick a sampled file from the biggest bucket holding a size in the range
+  //!
+  //! @param fsid filesystem id
+  //! @param min_size min size of the file
+  //! @param max_size max size of the file, 0 for no limit
+  //! @param skip returns true for the files which can't be picked e.g.
+  //!        already scheduled
+  //! @param fid picked file id
+  //! @param size size of the picked file
+  //!
+  //! @return true if a file was picked
+  //----------------------------------------------------------------------------
+  bool Pick(eos::common::FileSystem::fsid_t fsid, uint64_t min_size,
+            uint64_t max_size, const std::function<bool(uint64_t)>& skip,
+            uint64_t& fid, uint64_t& size);
+
+  //----------------------------------------------------------------------------
+  //! Sample the next page of the file list of a filesystem from the namespace
+  //!
+  //! @param fsid filesystem id
+  //! @param num_files number of file ids to sample
+  //----------------------------------------------------------------------------
+  void Refresh(eos::common::FileSystem::fsid_t fsid,
+               size_t num_files = kRefreshSize);
+
+  //----------------------------------------------------------------------------
+  //! Refresh the samples of a filesystem and choose a file in the size range
+  //! which still has a replica on the filesystem
+  //!
+  //! @param fsid filesystem id
+  //! @param min_size min size of the file
+  //! @param max_size max size of the file, 0 for no limit
+  //! @param skip returns true for the files which can't be chosen
+  //! @param fid chosen file id
+  //!
+  //! @return true if a file was chosen
+  //----------------------------------------------------------------------------
+  bool Choose(eos::common::FileSystem::fsid_t fsid, uint64_t min_size,
+              uint64_t max_size, const std::function<bool(uint64_t)>& skip,
+              uint64_t& fid);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of samples of a filesystem
+  //----------------------------------------------------------------------------
+  size_t GetNumSamples(eos::common::FileSystem::fsid_t fsid) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the bucket of a size
+  //----------------------------------------------------------------------------
+  static int GetBucket(uint64_t size);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Sampled file
+  //----------------------------------------------------------------------------
+  struct Sample {
+    uint64_t mFid;
+    uint64_t mSize;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Samples of one filesystem
+  //----------------------------------------------------------------------------
+  struct FsSamples {
+    std::string mCursor; ///< cursor of the next file list page to sample
+    std::vector<Sample> mBuckets[kNumBuckets]; ///< samples per size bucket
+    size_t mNext[kNumBuckets] = {}; ///< next sample to replace per bucket
+    std::unordered_map<uint64_t, int> mBucketOf; ///< bucket of each file
+  };
+
+  std::map<eos::common::FileSystem::fsid_t, FsSamples> mFs; ///< per fs
+  std::mt19937 mGenerator; ///< picks among the candidates of a bucket
+};
+
+EOSMGMNAMESPACE_END
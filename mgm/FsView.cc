@@ -29,8 +29,10 @@
 #include "mgm/GeoBalancer.hh"
 #include "mgm/Balancer.hh"
 #include "mgm/GroupBalancer.hh"
+#include "mgm/BalancePlanner.hh"
 #include "mgm/Converter.hh"
 #include "mgm/GeoTreeEngine.hh"
+#include "mgm/Iostat.hh"
 #include "mgm/TableFormatter/TableFormatterBase.hh"
 #include "common/StringConversion.hh"
 
@@ -852,6 +854,7 @@ FsSpace::FsSpace(const char* name)
   mConverter = new Converter(name);
   mGroupBalancer = new GroupBalancer(name);
   mGeoBalancer = new GeoBalancer(name);
+  mBalancePlanner = new BalancePlanner(name);
 
   if (!gDisableDefaults) {
     // Set default balancing variables
@@ -963,6 +966,11 @@ FsSpace::FsSpace(const char* name)
       SetConfigMember("geobalancer.threshold", "5", true, "/eos/*/mgm");
     }
 
+    // Disable the balance planner by default
+    if (GetConfigMember("planner").empty()) {
+      SetConfigMember("planner", "off", true, "/eos/*/mgm");
+    }
+
     // Disable lru by default
     if (GetConfigMember("lru").empty()) {
       SetConfigMember("converter", "off", true, "/eos/*/mgm");
@@ -1022,10 +1030,15 @@ FsSpace::~FsSpace()
     delete mGeoBalancer;
   }
 
+  if (mBalancePlanner) {
+    delete mBalancePlanner;
+  }
+
   mBalancer = nullptr;
   mConverter = nullptr;
   mGroupBalancer = nullptr;
   mGeoBalancer = nullptr;
+  mBalancePlanner = nullptr;
 }
 
 //----------------------------------------------------------------------------
@@ -1048,6 +1061,10 @@ void FsSpace::Stop()
   if (mGeoBalancer) {
     mGeoBalancer->Stop();
   }
+
+  if (mBalancePlanner) {
+    mBalancePlanner->Stop();
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -1127,6 +1144,11 @@ FsView::GetNodeFormat(std::string option)
     format += "member=cfg.stat.sys.kernel:format=os|";
     format += "member=cfg.stat.sys.eos.start:format=os|";
     format += "member=cfg.stat.sys.uptime:format=os|";
+    format += "member=cfg.stat.connpool.conns:format=ol|";
+    format += "member=cfg.stat.connpool.inflight:format=ol|";
+    format += "member=cfg.stat.connpool.shared:format=ol|";
+    format += "member=cfg.stat.connpool.grown:format=ol|";
+    format += "member=cfg.stat.connpool.shrunk:format=ol|";
     format += "sum=stat.disk.iops?configstatus@rw:format=ol|";
     format += "sum=stat.disk.bw?configstatus@rw:format=ol|";
     format += "member=cfg.stat.geotag:format=os|";
@@ -1161,6 +1183,8 @@ FsView::GetNodeFormat(std::string option)
     format += "member=cfg.stat.sys.rss:width=12:format=+l:tag=rss|";
     format += "member=cfg.stat.sys.threads:width=12:format=+l:tag=threads|";
     format += "member=cfg.stat.sys.sockets:width=10:format=s:tag=sockets|";
+    format += "member=cfg.stat.connpool.conns:width=10:format=+l:tag=xrd-conns|";
+    format += "member=cfg.stat.connpool.inflight:width=12:format=+l:tag=xrd-inflight|";
     format += "member=cfg.stat.sys.eos.version:width=12:format=s:tag=eos|";
     format += "member=cfg.stat.sys.xrootd.version:width=12:format=s:tag=xrootd|";
     format += "member=cfg.stat.sys.kernel:width=30:format=s:tag=kernel version|";
@@ -1230,6 +1254,7 @@ FsView::GetFileSystemFormat(std::string option)
     format += "key=path:format=os|";
     format += "key=schedgroup:format=os|";
     format += "key=stat.boot:format=os|";
+    format += "key=stat.bootprogress:format=of|";
     format += "key=configstatus:format=os|";
     format += "key=headroom:format=os|";
     format += "key=stat.errc:format=os|";
@@ -1472,6 +1497,7 @@ FsView::GetSpaceFormat(std::string option)
     format += "member=cfg.converter:width=11:format=s:tag=converter|";
     format += "member=cfg.converter.ntx:width=6:format=+l:tag=ntx|";
     format += "member=cfg.stat.converter.active:width=8:format=+l:tag=active|";
+    format += "member=cfg.stat.converter.rate:width=12:format=+l:unit=B:tag=rate/s|";
     format += "member=cfg.wfe:width=11:format=s:tag=wfe|";
     format += "member=cfg.wfe.ntx:width=6:format=+l:tag=ntx|";
     format += "member=cfg.stat.wfe.active:width=8:format=+l:tag=active|";
@@ -2514,6 +2540,15 @@ FsNode::SetNodeConfigDefault()
     SetConfigMember("debug.level", "info", true, mName.c_str(), true);
   }
 
+  // Push the metrics to the Iostat UDP targets
+  if (gOFS->IoStats) {
+    std::string targets = gOFS->IoStats->GetUdpTargetList();
+
+    if (GetConfigMember("monitoring.targets") != targets) {
+      SetConfigMember("monitoring.targets", targets, true, mName.c_str(), true);
+    }
+  }
+
   // Set by default as no transfer gateway
   if ((GetConfigMember("txgw") != "on") && (GetConfigMember("txgw") != "off")) {
     SetConfigMember("txgw", "off", true, mName.c_str(), true);
@@ -3169,6 +3204,81 @@ FsView::BroadcastMasterId(const std::string master_id)
   }
 }
 
+//------------------------------------------------------------------------------
+// Broadcast the monitoring targets to all the FST nodes
+//------------------------------------------------------------------------------
+void
+FsView::BroadcastMonitoringTargets(const std::string& targets)
+{
+  eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+
+  for (auto it = FsView::gFsView.mNodeView.begin();
+       it != FsView::gFsView.mNodeView.end(); ++it) {
+    if (it->second->GetConfigMember("monitoring.targets") != targets) {
+      it->second->SetConfigMember("monitoring.targets", targets, true,
+                                  it->first, true);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the max age of the cached aggregates
+//------------------------------------------------------------------------------
+std::chrono::milliseconds
+BaseView::GetAggregateTTL()
+{
+  static std::chrono::milliseconds sTTL = []() {
+    const char* ptr = getenv("EOS_MGM_FSVIEW_AGGREGATE_TTL_MS");
+    long long ttl_ms = (ptr ? strtoll(ptr, nullptr, 10) : 1000);
+    return std::chrono::milliseconds(ttl_ms > 0 ? ttl_ms : 0);
+  }();
+  return sTTL;
+}
+
+//------------------------------------------------------------------------------
+// Get a cached aggregate which is still fresh
+//------------------------------------------------------------------------------
+bool
+BaseView::GetCachedAggregate(Aggregate kind, const char* param,
+                             AggregateEntry& entry)
+{
+  if (GetAggregateTTL().count() == 0) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mAggregateMutex);
+  auto it = mAggregates.find(std::make_pair(kind, std::string(param)));
+
+  // Any change of the members of the view makes the aggregate stale
+  if ((it == mAggregates.end()) || (it->second.mMembers != size()) ||
+      (std::chrono::steady_clock::now() - it->second.mTimestamp >
+       GetAggregateTTL())) {
+    return false;
+  }
+
+  entry = it->second;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Store an aggregate in the cache
+//------------------------------------------------------------------------------
+void
+BaseView::StoreAggregate(Aggregate kind, const char* param, long long ll,
+                         double dbl)
+{
+  if (GetAggregateTTL().count() == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mAggregateMutex);
+  AggregateEntry& entry = mAggregates[std::make_pair(kind, std::string(param))];
+  entry.mLongLong = ll;
+  entry.mDouble = dbl;
+  entry.mMembers = size();
+  entry.mTimestamp = std::chrono::steady_clock::now();
+}
+
 //------------------------------------------------------------------------------
 // Computes the sum for <param> as long
 // param="<param>[?<key>=<value] allows to select with matches
@@ -3181,6 +3291,33 @@ BaseView::SumLongLong(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
+  AggregateEntry entry;
+  long long sum = 0;
+
+  if (!subset && GetCachedAggregate(Aggregate::kSumLongLong, param, entry)) {
+    sum = entry.mLongLong;
+  } else {
+    sum = ComputeSumLongLong(param, subset);
+
+    if (!subset) {
+      StoreAggregate(Aggregate::kSumLongLong, param, sum, 0);
+    }
+  }
+
+  if (lock) {
+    FsView::gFsView.ViewMutex.UnLockRead();
+  }
+
+  return sum;
+}
+
+//------------------------------------------------------------------------------
+// Computes the sum for <param> as long without caching
+//------------------------------------------------------------------------------
+long long
+BaseView::ComputeSumLongLong(const char* param,
+                             const std::set<eos::common::FileSystem::fsid_t>* subset)
+{
   long long sum = 0;
   std::string sparam = param;
   size_t qpos = 0;
@@ -3288,10 +3425,6 @@ BaseView::SumLongLong(const char* param, bool lock,
     }
   }
 
-  if (lock) {
-    FsView::gFsView.ViewMutex.UnLockRead();
-  }
-
   return sum;
 }
 
@@ -3306,6 +3439,33 @@ BaseView::SumDouble(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
+  AggregateEntry entry;
+  double sum = 0;
+
+  if (!subset && GetCachedAggregate(Aggregate::kSumDouble, param, entry)) {
+    sum = entry.mDouble;
+  } else {
+    sum = ComputeSumDouble(param, subset);
+
+    if (!subset) {
+      StoreAggregate(Aggregate::kSumDouble, param, 0, sum);
+    }
+  }
+
+  if (lock) {
+    FsView::gFsView.ViewMutex.UnLockRead();
+  }
+
+  return sum;
+}
+
+//------------------------------------------------------------------------------
+// Computes the sum for <param> as double without caching
+//------------------------------------------------------------------------------
+double
+BaseView::ComputeSumDouble(const char* param,
+                           const std::set<eos::common::FileSystem::fsid_t>* subset)
+{
   double sum = 0;
 
   if (subset) {
@@ -3318,10 +3478,6 @@ BaseView::SumDouble(const char* param, bool lock,
     }
   }
 
-  if (lock) {
-    FsView::gFsView.ViewMutex.UnLockRead();
-  }
-
   return sum;
 }
 
@@ -3338,6 +3494,33 @@ BaseView::AverageDouble(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
+  AggregateEntry entry;
+  double avg = 0;
+
+  if (!subset && GetCachedAggregate(Aggregate::kAverageDouble, param, entry)) {
+    avg = entry.mDouble;
+  } else {
+    avg = ComputeAverageDouble(param, subset);
+
+    if (!subset) {
+      StoreAggregate(Aggregate::kAverageDouble, param, 0, avg);
+    }
+  }
+
+  if (lock) {
+    FsView::gFsView.ViewMutex.UnLockRead();
+  }
+
+  return avg;
+}
+
+//------------------------------------------------------------------------------
+// Computes the average for <param> without caching
+//------------------------------------------------------------------------------
+double
+BaseView::ComputeAverageDouble(const char* param,
+                               const std::set<eos::common::FileSystem::fsid_t>* subset)
+{
   double sum = 0;
   int cnt = 0;
 
@@ -3385,10 +3568,6 @@ BaseView::AverageDouble(const char* param, bool lock,
     }
   }
 
-  if (lock) {
-    FsView::gFsView.ViewMutex.UnLockRead();
-  }
-
   return (cnt) ? (double)(1.0 * sum / cnt) : 0;
 }
 
@@ -3620,6 +3799,33 @@ BaseView::SigmaDouble(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
+  AggregateEntry entry;
+  double sigma = 0;
+
+  if (!subset && GetCachedAggregate(Aggregate::kSigmaDouble, param, entry)) {
+    sigma = entry.mDouble;
+  } else {
+    sigma = ComputeSigmaDouble(param, subset);
+
+    if (!subset) {
+      StoreAggregate(Aggregate::kSigmaDouble, param, 0, sigma);
+    }
+  }
+
+  if (lock) {
+    FsView::gFsView.ViewMutex.UnLockRead();
+  }
+
+  return sigma;
+}
+
+//------------------------------------------------------------------------------
+// Computes the sigma for <param> without caching
+//------------------------------------------------------------------------------
+double
+BaseView::ComputeSigmaDouble(const char* param,
+                             const std::set<eos::common::FileSystem::fsid_t>* subset)
+{
   double avg = AverageDouble(param, false);
   double sumsquare = 0;
   int cnt = 0;
@@ -3670,10 +3876,6 @@ BaseView::SigmaDouble(const char* param, bool lock,
 
   sumsquare = (cnt) ? sqrt(sumsquare / cnt) : 0;
 
-  if (lock) {
-    FsView::gFsView.ViewMutex.UnLockRead();
-  }
-
   return sumsquare;
 }
 
@@ -38,6 +38,9 @@
 #include <sys/param.h>
 #include <sys/mount.h>
 #endif
+#include <chrono>
+#include <map>
+#include <mutex>
 
 //------------------------------------------------------------------------------
 //! @file FsView.hh
@@ -54,6 +57,7 @@ class TableFormatterBase;
 class Balancer;
 class GroupBalancer;
 class GeoBalancer;
+class BalancePlanner;
 class Converter;
 
 //------------------------------------------------------------------------------
@@ -504,6 +508,14 @@ public:
     mInQueue = iq;
   }
 
+  //----------------------------------------------------------------------------
+  //! Get the max age of the cached aggregates returned by SumLongLong,
+  //! SumDouble, AverageDouble and SigmaDouble for the whole view, configured
+  //! through EOS_MGM_FSVIEW_AGGREGATE_TTL_MS (default 1000) - 0 disables the
+  //! caching
+  //----------------------------------------------------------------------------
+  static std::chrono::milliseconds GetAggregateTTL();
+
   //----------------------------------------------------------------------------
   //! Calculate the sum of <param> as long long
   //----------------------------------------------------------------------------
@@ -555,10 +567,76 @@ public:
                 const std::set<eos::common::FileSystem::fsid_t>* subset);
 
 private:
+  //! Kind of aggregate computed over the view
+  enum class Aggregate {
+    kSumLongLong,
+    kSumDouble,
+    kAverageDouble,
+    kSigmaDouble
+  };
+
+  //----------------------------------------------------------------------------
+  //! Aggregate computed over all the file systems of the view
+  //----------------------------------------------------------------------------
+  struct AggregateEntry {
+    long long mLongLong; ///< Value of the integer aggregates
+    double mDouble; ///< Value of the floating point aggregates
+    size_t mMembers; ///< Number of file systems in the view at computation
+    std::chrono::steady_clock::time_point mTimestamp; ///< Computation time
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get a cached aggregate which is still fresh, the view mutex must be
+  //! read locked
+  //!
+  //! @param kind kind of aggregate
+  //! @param param parameter (and query) of the aggregate
+  //! @param entry filled with the cached aggregate
+  //!
+  //! @return true if a fresh aggregate was found, otherwise false
+  //----------------------------------------------------------------------------
+  bool GetCachedAggregate(Aggregate kind, const char* param,
+                          AggregateEntry& entry);
+
+  //----------------------------------------------------------------------------
+  //! Store an aggregate in the cache, the view mutex must be read locked
+  //!
+  //! @param kind kind of aggregate
+  //! @param param parameter (and query) of the aggregate
+  //! @param ll value of an integer aggregate
+  //! @param dbl value of a floating point aggregate
+  //----------------------------------------------------------------------------
+  void StoreAggregate(Aggregate kind, const char* param, long long ll,
+                      double dbl);
+
+  //----------------------------------------------------------------------------
+  //! Compute the aggregates without any caching, these are the
+  //! implementations behind SumLongLong, SumDouble, AverageDouble and
+  //! SigmaDouble
+  //----------------------------------------------------------------------------
+  long long
+  ComputeSumLongLong(const char* param,
+                     const std::set<eos::common::FileSystem::fsid_t>* subset);
+
+  double
+  ComputeSumDouble(const char* param,
+                   const std::set<eos::common::FileSystem::fsid_t>* subset);
+
+  double
+  ComputeAverageDouble(const char* param,
+                       const std::set<eos::common::FileSystem::fsid_t>* subset);
+
+  double
+  ComputeSigmaDouble(const char* param,
+                     const std::set<eos::common::FileSystem::fsid_t>* subset);
+
   time_t mHeartBeat; ///< Last heartbeat time
   std::string mStatus; ///< Status (meaning depends on inheritor)
   std::string mSize; ///< Size of base object (meaning depends on inheritor)
   size_t mInQueue; ///< Number of items in queue(meaning depends on inheritor)
+  std::mutex mAggregateMutex; ///< Mutex protecting the aggregate cache
+  //! Cached aggregates of the whole view indexed by kind and parameter
+  std::map<std::pair<Aggregate, std::string>, AggregateEntry> mAggregates;
 };
 
 //------------------------------------------------------------------------------
@@ -584,6 +662,7 @@ public:
   Converter* mConverter; ///< Threaded object running layout conversion jobs
   GroupBalancer* mGroupBalancer; ///< Threaded object running group balancing
   GeoBalancer* mGeoBalancer; ///< Threaded object running geotag balancing
+  BalancePlanner* mBalancePlanner; ///< Threaded object planning balancing
 
   //----------------------------------------------------------------------------
   //! Constructor
@@ -880,8 +959,9 @@ public:
   //----------------------------------------------------------------------------
   bool UnRegisterGroup(const char* groupname);
 
-  //! Mutex protecting all ...View variables
-  mutable eos::common::RWMutexR ViewMutex;
+  //! Mutex protecting all ...View variables - read-mostly, prefers readers
+  //! and uses per-thread reader slots
+  mutable eos::common::RWMutex ViewMutex {true, true};
 
   //! Map translating a space name to a set of group objects
   std::map<std::string, std::set<FsGroup*> > mSpaceGroupView;
@@ -1044,6 +1124,13 @@ public:
   //----------------------------------------------------------------------------
   void BroadcastMasterId(const std::string master_id);
 
+  //----------------------------------------------------------------------------
+  //! Broadcast the monitoring targets to all the FST nodes
+  //!
+  //! @param targets list of targets separated by '|'
+  //----------------------------------------------------------------------------
+  void BroadcastMonitoringTargets(const std::string& targets);
+
 private:
   AssistedThread mHeartBeatThread; ///< Thread monitoring heart-beats
   //! Next free filesystem ID if a new one has to be registered
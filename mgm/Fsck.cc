@@ -42,13 +42,15 @@ EOSMGMNAMESPACE_BEGIN
 
 const char* Fsck::gFsckEnabled = "fsck";
 const char* Fsck::gFsckInterval = "fsckinterval";
+const char* Fsck::gFsckRepair = "fsckrepair";
 
 
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 Fsck::Fsck():
-  mEnabled(false), mInterval(30), mRunning(false), eTimeStamp(0)
+  mEnabled(false), mInterval(30), mRunning(false), eTimeStamp(0),
+  mFeedCycles(0), mRepair(*this)
 {}
 
 //------------------------------------------------------------------------------
@@ -71,6 +73,8 @@ Fsck::Start(int interval)
   }
 
   if (!mRunning) {
+    // A restarted collection starts with the full inconsistency sets
+    mFeedSeq.clear();
     mThread.reset(&Fsck::Check, this);
     mRunning = true;
     mEnabled = "true";
@@ -193,7 +197,28 @@ Fsck::Check(ThreadAssistant& assistant) noexcept
     broadcastresponsequeue += bccount;
     XrdOucString broadcasttargetqueue = gOFS->MgmDefaultReceiverQueue;
     XrdOucString msgbody;
-    msgbody = "mgm.cmd=fsck&mgm.fsck.tags=*";
+    // Request only the changes since the last collection from FSTs with a
+    // known change feed, the full sets are requested in regular intervals
+    bool full_feed = (mFeedSeq.empty() || (mFeedCycles >= sFeedResyncCycles));
+    msgbody = "mgm.cmd=fsck&mgm.fsck.tags=*&mgm.fsck.incremental=1";
+
+    if (!full_feed) {
+      std::string since;
+
+      for (auto it = mFeedSeq.cbegin(); it != mFeedSeq.cend(); ++it) {
+        if (since.length()) {
+          since += ",";
+        }
+
+        since += it->first;
+        since += ":";
+        since += std::to_string(it->second);
+      }
+
+      msgbody += "&mgm.fsck.since=";
+      msgbody += since.c_str();
+    }
+
     XrdOucString stdOut = "";
     XrdOucString stdErr = "";
 
@@ -210,30 +235,8 @@ Fsck::Check(ThreadAssistant& assistant) noexcept
     // Convert into a lines-wise seperated array
     eos::common::StringConversion::StringToLineVector((char*) stdOut.c_str(),
         lines);
-
-    for (size_t nlines = 0; nlines < lines.size(); nlines++) {
-      std::set<unsigned long long> fids;
-      unsigned long fsid = 0;
-      std::string errortag;
-
-      if (eos::common::StringConversion::ParseStringIdSet((char*)
-          lines[nlines].c_str(), errortag, fsid, fids)) {
-        std::set<unsigned long long>::const_iterator it;
-
-        if (fsid) {
-          XrdSysMutexHelper lock(eMutex);
-
-          // Add the fids into the error maps
-          for (auto it = fids.cbegin(); it != fids.cend(); ++it) {
-            eFsMap[errortag][fsid].insert(*it);
-            eMap[errortag].insert(*it);
-            eCount[errortag]++;
-          }
-        }
-      } else {
-        eos_static_err("Can not parse fsck response: %s", lines[nlines].c_str());
-      }
-    }
+    ApplyFeed(lines, full_feed);
+    mFeedCycles = (full_feed ? 0 : mFeedCycles + 1);
 
     {
       // Grab all files which are damaged because filesystems are down
@@ -258,8 +261,6 @@ Fsck::Check(ThreadAssistant& assistant) noexcept
         } else {
           // Not ok and contributes to replica offline errors
           try {
-            eos::Prefetcher::prefetchFilesystemFileListAndWait(gOFS->eosView,
-                gOFS->eosFsView, fsid);
             XrdSysMutexHelper lock(eMutex);
             // Only need the view lock if we're in-memory
             eos::common::RWMutexReadLock nslock;
@@ -270,7 +271,8 @@ Fsck::Check(ThreadAssistant& assistant) noexcept
 
             std::deque<std::pair<FileIdentifier, folly::Future<bool>>> futs;
 
-            for (auto it_fid = gOFS->eosFsView->getFileList(fsid);
+            for (auto it_fid = gOFS->eosFsView->getPagedFileList(fsid, "0",
+                               eos::IFsView::kFileListPageSize);
                  (it_fid && it_fid->valid()); it_fid->next()) {
               eos::FileIdentifier fid(it_fid->getElement());
               futs.emplace_back(fid, gOFS->eosFileService->hasFileMD(fid));
@@ -469,6 +471,7 @@ Fsck::Check(ThreadAssistant& assistant) noexcept
       }
     }
 
+    ResumeRepairs();
     Log(false, "stopping check");
     Log(false, "=> next run in %d minutes", mInterval);
     // Wait for next FSCK round ...
@@ -492,8 +495,11 @@ Fsck::Check(ThreadAssistant& assistant) noexcept
 void
 Fsck::PrintOut(XrdOucString& out, XrdOucString option)
 {
-  XrdSysMutexHelper lock(mLogMutex);
-  out = mLog;
+  {
+    XrdSysMutexHelper lock(mLogMutex);
+    out = mLog;
+  }
+  mRepair.PrintOut(out);
 }
 
 //------------------------------------------------------------------------------
@@ -578,7 +584,7 @@ Fsck::Report(XrdOucString& out, XrdOucString& err, XrdOucString option,
 
         if (printlfn) {
           out += "    \"lfn\": [";
-          std::set <eos::common::FileId::fileid_t>::const_iterator fidit;
+          FidSet::const_iterator fidit;
 
           for (fidit = emapit->second.begin();
                fidit != emapit->second.end();
@@ -634,8 +640,7 @@ Fsck::Report(XrdOucString& out, XrdOucString& err, XrdOucString option,
         out += "\",\n";
         out += "    \"fsid\":";
         out += " {\n";
-        std::map < eos::common::FileSystem::fsid_t,
-            std::set < eos::common::FileId::fileid_t >> ::const_iterator efsmapit;
+        FsFidSet::const_iterator efsmapit;
 
         for (efsmapit = eFsMap[emapit->first].begin();
              efsmapit != eFsMap[emapit->first].end();
@@ -658,7 +663,7 @@ Fsck::Report(XrdOucString& out, XrdOucString& err, XrdOucString option,
 
           if (printfid) {
             out += "        \"fxid\": [";
-            std::set <eos::common::FileId::fileid_t>::const_iterator fidit;
+            FidSet::const_iterator fidit;
 
             for (fidit = efsmapit->second.begin();
                  fidit != efsmapit->second.end();
@@ -678,7 +683,7 @@ Fsck::Report(XrdOucString& out, XrdOucString& err, XrdOucString option,
 
           if (printlfn) {
             out += "        \"lfn\": [";
-            std::set <eos::common::FileId::fileid_t>::const_iterator fidit;
+            FidSet::const_iterator fidit;
 
             for (fidit = efsmapit->second.begin();
                  fidit != efsmapit->second.end();
@@ -922,8 +927,6 @@ Fsck::Report(XrdOucString& out, XrdOucString& err, XrdOucString option,
 bool
 Fsck::Repair(XrdOucString& out, XrdOucString& err, XrdOucString option)
 {
-  XrdSysMutexHelper lock(eMutex);
-
   // Check for a valid action in option
   if ((option != "checksum") &&
       (option != "checksum-commit") &&
@@ -941,578 +944,465 @@ Fsck::Repair(XrdOucString& out, XrdOucString& err, XrdOucString option)
     return false;
   }
 
-  if (option.beginswith("checksum")) {
-    out += "# repair checksum ------------------------------------------------"
-           "-------------------------\n";
-    std::map < eos::common::FileSystem::fsid_t,
-        std::set < eos::common::FileId::fileid_t >> fid2check;
-
-    // Loop over all filesystems
-    for (auto efsmapit = eFsMap["m_cx_diff"].cbegin();
-         efsmapit != eFsMap["m_cx_diff"].cend(); ++efsmapit) {
-      // Loop over all fids
-      for (auto it = efsmapit->second.cbegin();
-           it != efsmapit->second.cend(); ++it) {
-        fid2check[efsmapit->first].insert(*it);
-      }
-    }
-
-    // Loop over all filesystems
-    for (auto efsmapit = eFsMap["d_cx_diff"].cbegin();
-         efsmapit != eFsMap["d_cx_diff"].cend(); ++efsmapit) {
-      std::set <eos::common::FileId::fileid_t>::const_iterator it;
+  std::string action = option.c_str();
+  size_t submitted = SubmitRepair(action);
+  {
+    XrdSysMutexHelper lock(mRepairMutex);
 
-      // Loop over all fids
-      for (auto it = efsmapit->second.cbegin();
-           it != efsmapit->second.cend(); ++it) {
-        fid2check[efsmapit->first].insert(*it);
-      }
+    if (mRepairActions.insert(action).second) {
+      StoreRepairActions();
     }
+  }
+  char outline[1024];
+  snprintf(outline, sizeof(outline) - 1,
+           "success: submitted %lu repair jobs for %s, %lu pending - see "
+           "'fsck stat' for the progress\n", (unsigned long) submitted,
+           action.c_str(), (unsigned long) mRepair.Pending(action));
+  out += outline;
+  return true;
+}
 
-    // Loop over all filesystems
-    for (auto efsmapit = fid2check.cbegin();
-         efsmapit != fid2check.cend(); ++efsmapit) {
-      for (auto it = efsmapit->second.cbegin();
-           it != efsmapit->second.cend(); ++it) {
-        std::string path = "";
-        std::shared_ptr<eos::IFileMD> fmd;
-        eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, *it);
-        eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
-
-        try {
-          fmd = gOFS->eosFileService->getFileMD(*it);
-          path = gOFS->eosView->getUri(fmd.get());
-        } catch (eos::MDException& e) {}
+//------------------------------------------------------------------------------
+// Collect the fids of a repair action and submit them to the executor
+//------------------------------------------------------------------------------
+size_t
+Fsck::SubmitRepair(const std::string& action)
+{
+  std::map<eos::common::FileSystem::fsid_t,
+      std::vector<eos::common::FileId::fileid_t>> fids;
+  std::vector<std::string> tags;
+
+  if (action.compare(0, 8, "checksum") == 0) {
+    tags = {"m_cx_diff", "d_cx_diff"};
+  } else if (action == "unlink-unregistered") {
+    tags = {"unreg_n"};
+  } else if (action == "unlink-orphans") {
+    tags = {"orphans_n"};
+  } else if (action.compare(0, 15, "adjust-replicas") == 0) {
+    tags = {"rep_diff_n"};
+  } else if (action == "drop-missing-replicas") {
+    tags = {"rep_missing_n"};
+  } else if (action == "replace-damaged-replicas") {
+    tags = {"d_mem_sz_diff"};
+  }
 
-        // Issue verify operations on that particular filesystem
-        eos::common::Mapping::VirtualIdentity vid;
-        eos::common::Mapping::Root(vid);
-        XrdOucErrInfo error;
-        int lretc = 1;
-
-        if (path.length()) {
-          if (option == "checksum-commit") {
-            // Verify & commit
-            lretc = gOFS->_verifystripe(path.c_str(), error, vid, efsmapit->first,
-                                        "&mgm.verify.compute.checksum=1&"
-                                        "mgm.verify.commit.checksum=1&"
-                                        "mgm.verify.commit.size=1");
-          } else {
-            // Verify only
-            lretc = gOFS->_verifystripe(path.c_str(), error, vid, efsmapit->first,
-                                        "&mgm.verify.compute.checksum=1");
-          }
+  {
+    XrdSysMutexHelper lock(eMutex);
 
-          if (!lretc) {
-            out += "success: sending verify to fsid=";
-            out += (int) efsmapit->first;
-            out += " for path=";
-            out += path.c_str();
-            out += "\n";
-          } else {
-            out += "error: sending verify to fsid=";
-            out += (int) efsmapit->first;
-            out += " failed for path=";
-            out += path.c_str();
-            out += "\n";
-          }
+    if (action == "resync") {
+      for (auto emapit = eMap.cbegin(); emapit != eMap.cend(); ++emapit) {
+        // Don't sync offline replicas
+        if (emapit->first != "rep_offline") {
+          tags.push_back(emapit->first);
         }
       }
     }
 
-    return true;
-  }
+    if (action == "unlink-zero-replicas") {
+      // These we cannot break down by filesystem id
+      auto emapit = eMap.find("zero_replica");
+
+      if (emapit != eMap.end()) {
+        fids[0].assign(emapit->second.begin(), emapit->second.end());
+      }
+    }
 
-  if (option.beginswith("resync")) {
-    out += "# resync         ------------------------------------------------"
-           "-------------------------\n";
-    std::map < eos::common::FileSystem::fsid_t,
-        std::set < eos::common::FileId::fileid_t >> fid2check;
+    for (auto tag = tags.cbegin(); tag != tags.cend(); ++tag) {
+      auto tagit = eFsMap.find(*tag);
 
-    for (auto emapit = eMap.cbegin(); emapit != eMap.cend(); ++emapit) {
-      // Don't sync offline replicas
-      if (emapit->first == "rep_offline") {
+      if (tagit == eFsMap.end()) {
         continue;
       }
 
-      // Loop over all filesystems
-      for (auto efsmapit = eFsMap[emapit->first].cbegin();
-           efsmapit != eFsMap[emapit->first].cend(); ++efsmapit) {
-        // Loop over all fids
-        for (auto it = efsmapit->second.cbegin();
-             it != efsmapit->second.cend(); ++it) {
-          fid2check[efsmapit->first].insert(*it);
-        }
+      for (auto efsmapit = tagit->second.cbegin();
+           efsmapit != tagit->second.cend(); ++efsmapit) {
+        auto& vect = fids[efsmapit->first];
+        vect.insert(vect.end(), efsmapit->second.begin(), efsmapit->second.end());
       }
     }
+  }
 
-    // Loop over all filesystems
-    for (auto  efsmapit = fid2check.cbegin();
-         efsmapit != fid2check.cend(); ++efsmapit) {
-      for (auto it = efsmapit->second.cbegin();
-           it != efsmapit->second.cend(); ++it) {
-        std::string path = "";
-        std::shared_ptr<eos::IFileMD> fmd =
-          std::shared_ptr<eos::IFileMD>((eos::IFileMD*)0);
-        eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, *it);
-        eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+  // Jobs are identified by action, fsid and fid, fids reported under several
+  // tags end up as a single job
+  return mRepair.Submit(action, fids);
+}
 
-        try {
-          fmd = gOFS->eosFileService->getFileMD(*it);
-        } catch (eos::MDException& e) {}
+//------------------------------------------------------------------------------
+// Store the repair actions with pending jobs in the configuration engine
+//------------------------------------------------------------------------------
+void
+Fsck::StoreRepairActions()
+{
+  std::string actions;
 
-        if (fmd) {
-          int lretc = 0;
-          // Issue a resync command for a filesystem/fid pair
-          lretc = gOFS->SendResync(*it, efsmapit->first);
-
-          if (lretc) {
-            char outline[1024];
-            snprintf(outline, sizeof(outline) - 1,
-                     "success: sending resync to fsid=%u fxid=%llx\n",
-                     efsmapit->first, *it);
-            out += outline;
-          } else {
-            char outline[1024];
-            snprintf(outline, sizeof(outline) - 1,
-                     "error: sending resync to fsid=%u failed for fxid=%llx\n",
-                     efsmapit->first, *it);
-            out += outline;
-          }
-        } else {
-          char outline[1024];
-          snprintf(outline, sizeof(outline) - 1,
-                   "error: no file meta data for fsid=%u failed for fxid=%llx\n",
-                   efsmapit->first, *it);
-          out += outline;
-        }
-      }
+  for (auto it = mRepairActions.cbegin(); it != mRepairActions.cend(); ++it) {
+    if (actions.length()) {
+      actions += ",";
     }
 
-    return true;
+    actions += *it;
   }
 
-  if (option == "unlink-unregistered") {
-    out += "# unlink unregistered --------------------------------------------"
-           "-------------------------\n";
-    // Unlink all unregistered files
-    std::map < eos::common::FileSystem::fsid_t,
-        std::set < eos::common::FileId::fileid_t >> fid2check;
-    eos::common::Mapping::VirtualIdentity vid;
-    eos::common::Mapping::Root(vid);
-    XrdOucErrInfo error;
-
-    // Loop over all filesystems
-    for (auto efsmapit = eFsMap["unreg_n"].cbegin();
-         efsmapit != eFsMap["unreg_n"].cend(); ++efsmapit) {
-      // Loop over all fids
-      for (auto it = efsmapit->second.cbegin();
-           it != efsmapit->second.cend(); ++it) {
-        std::shared_ptr<eos::IFileMD> fmd;
-        bool haslocation = false;
-        std::string spath = "";
+  if (!FsView::gFsView.SetGlobalConfig(gFsckRepair, actions)) {
+    eos_static_err("msg=\"failed to store fsck repair actions\" actions=\"%s\"",
+                   actions.c_str());
+  }
+}
 
-        // Crosscheck if the location really is not attached
-        try {
-          eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, *it);
-          eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
-          fmd = gOFS->eosFileService->getFileMD(*it);
-          spath = gOFS->eosView->getUri(fmd.get());
+//------------------------------------------------------------------------------
+// Resubmit the repair actions of a previous master and forget finished ones
+//------------------------------------------------------------------------------
+void
+Fsck::ResumeRepairs()
+{
+  std::vector<std::string> actions;
+  eos::common::StringConversion::Tokenize(
+    FsView::gFsView.GetGlobalConfig(gFsckRepair), actions, ",");
+  XrdSysMutexHelper lock(mRepairMutex);
+  bool changed = false;
+
+  for (auto it = actions.cbegin(); it != actions.cend(); ++it) {
+    if (!mRepairActions.count(*it)) {
+      size_t submitted = SubmitRepair(*it);
+      mRepairActions.insert(*it);
+      Log(false, "resumed repair action %s with %lu jobs", it->c_str(),
+          (unsigned long) submitted);
+    }
+  }
 
-          if (fmd->hasLocation(efsmapit->first)) {
-            haslocation = true;
-          }
-        } catch (eos::MDException& e) {}
+  for (auto it = mRepairActions.begin(); it != mRepairActions.end();) {
+    if (!mRepair.Pending(*it)) {
+      it = mRepairActions.erase(it);
+      changed = true;
+    } else {
+      ++it;
+    }
+  }
 
-        // Send external deletion
-        if (gOFS->DeleteExternal(efsmapit->first, *it)) {
-          char outline[1024];
-          snprintf(outline, sizeof(outline) - 1,
-                   "success: send unlink to fsid=%u fxid=%llx\n",
-                   efsmapit->first, *it);
-          out += outline;
-        } else {
-          char errline[1024];
-          snprintf(errline, sizeof(errline) - 1,
-                   "err: unable to send unlink to fsid=%u fxid=%llx\n",
-                   efsmapit->first, *it);
-          out += errline;
-        }
+  if (changed || (mRepairActions.size() != actions.size())) {
+    StoreRepairActions();
+  }
+}
 
-        if (haslocation) {
-          // Drop from the namespace
-          if (gOFS->_dropstripe(spath.c_str(), *it, error, vid, efsmapit->first, false)) {
-            char outline[1024];
-            snprintf(outline, sizeof(outline) - 1,
-                     "error: unable to drop stripe on fsid=%u fxid=%llx\n",
-                     efsmapit->first, *it);
-            out += outline;
-          } else {
-            char outline[1024];
-            snprintf(outline, sizeof(outline) - 1,
-                     "success: send dropped stripe on fsid=%u fxid=%llx\n",
-                     efsmapit->first, *it);
-            out += outline;
-          }
-        }
-      }
+//------------------------------------------------------------------------------
+// Classify a repair job by the node of the filesystem and the number of
+// healthy replicas of the file
+//------------------------------------------------------------------------------
+void
+Fsck::ClassifyRepair(FsckRepair::Job& job)
+{
+  eos::IFileMD::LocationVector locations;
+  bool found = false;
+
+  try {
+    eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, job.fid);
+    eos::common::RWMutexReadLock nslock(gOFS->eosViewRWMutex);
+    auto fmd = gOFS->eosFileService->getFileMD(job.fid);
+    locations = fmd->getLocations();
+    found = true;
+  } catch (eos::MDException& e) {}
+
+  // Files without meta data are orphans which don't risk any data
+  job.priority = (found ? 0 : sRepairNoFilePriority);
+  eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
+
+  if (job.fsid && FsView::gFsView.mIdView.count(job.fsid) &&
+      FsView::gFsView.mIdView[job.fsid]) {
+    job.node = FsView::gFsView.mIdView[job.fsid]->GetString("hostport");
+  }
+
+  for (auto it = locations.cbegin(); it != locations.cend(); ++it) {
+    if (!FsView::gFsView.mIdView.count(*it) || !FsView::gFsView.mIdView[*it]) {
+      continue;
     }
 
-    return true;
-  }
+    FileSystem* fs = FsView::gFsView.mIdView[*it];
 
-  if (option == "unlink-orphans") {
-    out += "# unlink orphans  ------------------------------------------------"
-           "-------------------------\n";
-    // Unlink all orphaned files
-    std::map < eos::common::FileSystem::fsid_t,
-        std::set < eos::common::FileId::fileid_t >> fid2check;
-
-    // Loop over all filesystems
-    for (auto efsmapit = eFsMap["orphans_n"].cbegin();
-         efsmapit != eFsMap["orphans_n"].cend(); ++efsmapit) {
-      // Loop over all fids
-      for (auto it = efsmapit->second.cbegin();
-           it != efsmapit->second.cend(); ++it) {
-        std::shared_ptr<eos::IFileMD> fmd;
-        eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, *it);
-        eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
-        bool haslocation = false;
+    if ((fs->GetActiveStatus(true) != eos::common::FileSystem::kOffline) &&
+        (fs->GetStatus(true) == eos::common::FileSystem::kBooted) &&
+        (fs->GetConfigStatus() != eos::common::FileSystem::kDrainDead)) {
+      // Files with the fewest healthy replicas are repaired first
+      ++job.priority;
+    }
+  }
+}
 
-        // Crosscheck if the location really is not attached
-        try {
-          fmd = gOFS->eosFileService->getFileMD(*it);
+//------------------------------------------------------------------------------
+// Repair a single fid on a single filesystem
+//------------------------------------------------------------------------------
+bool
+Fsck::RepairFid(const FsckRepair::Job& job, std::string& msg)
+{
+  const std::string& option = job.action;
+  const eos::common::FileSystem::fsid_t fsid = job.fsid;
+  const eos::common::FileId::fileid_t fid = job.fid;
+  eos::common::Mapping::VirtualIdentity vid;
+  eos::common::Mapping::Root(vid);
+  XrdOucErrInfo error;
+  char outline[1024];
+  outline[0] = 0;
+  std::shared_ptr<eos::IFileMD> fmd;
+  std::string path;
+  bool haslocation = false;
+  eos::IFileMD::ctime_t ctime;
+  ctime.tv_sec = 0;
+  ctime.tv_nsec = 0;
+
+  try {
+    eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, fid);
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+    fmd = gOFS->eosFileService->getFileMD(fid);
+    path = gOFS->eosView->getUri(fmd.get());
+    haslocation = fmd->hasLocation(fsid);
+    fmd->getCTime(ctime);
+  } catch (eos::MDException& e) {}
+
+  // Execute an adjustreplica proc command
+  auto adjust_replica = [&](bool nodrop) {
+    XrdOucString out;
+    XrdOucString err;
+    ProcCommand Cmd;
+    XrdOucString info = "mgm.cmd=file&mgm.subcmd=adjustreplica&mgm.path=";
+    info += path.c_str();
+    info += "&mgm.format=fuse";
+
+    if (nodrop) {
+      info += "&mgm.file.option=nodrop";
+    }
 
-          if (fmd->hasLocation(efsmapit->first)) {
-            haslocation = true;
-          }
-        } catch (eos::MDException& e) {}
+    Cmd.open("/proc/user", info.c_str(), vid, &error);
+    Cmd.AddOutput(out, err);
+    int retc = Cmd.close();
 
-        if (!haslocation) {
-          if (gOFS->DeleteExternal(efsmapit->first, *it)) {
-            char outline[1024];
-            snprintf(outline, sizeof(outline) - 1,
-                     "success: send unlink to fsid=%u fxid=%llx\n",
-                     efsmapit->first, *it);
-            out += outline;
-          } else {
-            char errline[1024];
-            snprintf(errline, sizeof(errline) - 1,
-                     "err: unable to send unlink to fsid=%u fxid=%llx\n",
-                     efsmapit->first, *it);
-            out += errline;
-          }
-        } else {
-          char errline[1024];
-          snprintf(errline, sizeof(errline) - 1,
-                   "err: not sending unlink to fsid=%u fxid=%llx - location exists!\n",
-                   efsmapit->first, *it);
-          out += errline;
-        }
-      }
+    if (retc) {
+      snprintf(outline, sizeof(outline) - 1,
+               "error: adjust replica failed for fsid=%u fxid=%llx retc=%d %s",
+               fsid, fid, retc, err.c_str());
     }
 
-    return true;
-  }
+    return (retc == 0);
+  };
 
-  if (option.beginswith("adjust-replicas")) {
-    out += "# adjust replicas ------------------------------------------------"
-           "-------------------------\n";
-    // Adjust all layout errors e.g. missing replicas where possible
-    std::map < eos::common::FileSystem::fsid_t,
-        std::set < eos::common::FileId::fileid_t >> fid2check;
-
-    // Loop over all filesystems
-    for (auto efsmapit = eFsMap["rep_diff_n"].cbegin();
-         efsmapit != eFsMap["rep_diff_n"].cend(); ++efsmapit) {
-      // Loop over all fids
-      for (auto it = efsmapit->second.cbegin();
-           it != efsmapit->second.cend(); ++it) {
-        std::shared_ptr<eos::IFileMD> fmd;
-        std::string path = "";
+  if (option.compare(0, 8, "checksum") == 0) {
+    if (!path.length()) {
+      snprintf(outline, sizeof(outline) - 1,
+               "error: no file meta data for fsid=%u fxid=%llx", fsid, fid);
+      msg = outline;
+      return false;
+    }
 
-        try {
-          {
-            eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, *it);
-            eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
-            fmd = gOFS->eosFileService->getFileMD(*it);
-            path = gOFS->eosView->getUri(fmd.get());
-          }
-          // Execute adjust replica
-          eos::common::Mapping::VirtualIdentity vid;
-          eos::common::Mapping::Root(vid);
-          XrdOucErrInfo error;
-          ProcCommand Cmd;
-          XrdOucString info = "mgm.cmd=file&mgm.subcmd=adjustreplica&mgm.path=";
-          info += path.c_str();
-          info += "&mgm.format=fuse";
-
-          if (option == "adjust-replicas-nodrop") {
-            info += "&mgm.file.option=nodrop";
-          }
+    int lretc = 1;
+
+    // Issue verify operations on that particular filesystem, queued by the
+    // FST after the verifications requested by users
+    if (option == "checksum-commit") {
+      // Verify & commit
+      lretc = gOFS->_verifystripe(path.c_str(), error, vid, fsid,
+                                  "&mgm.verify.compute.checksum=1&"
+                                  "mgm.verify.commit.checksum=1&"
+                                  "mgm.verify.commit.size=1&"
+                                  "mgm.verify.background=1");
+    } else {
+      // Verify only
+      lretc = gOFS->_verifystripe(path.c_str(), error, vid, fsid,
+                                  "&mgm.verify.compute.checksum=1&"
+                                  "mgm.verify.background=1");
+    }
 
-          Cmd.open("/proc/user", info.c_str(), vid, &error);
-          Cmd.AddOutput(out, err);
+    if (lretc) {
+      snprintf(outline, sizeof(outline) - 1,
+               "error: sending verify to fsid=%u failed for path=%s", fsid,
+               path.c_str());
+      msg = outline;
+      return false;
+    }
 
-          if (!out.endswith("\n")) {
-            out += "\n";
-          }
+    return true;
+  }
 
-          if (!err.endswith("\n")) {
-            err += "\n";
-          }
+  if (option == "resync") {
+    if (!fmd) {
+      snprintf(outline, sizeof(outline) - 1,
+               "error: no file meta data for fsid=%u failed for fxid=%llx",
+               fsid, fid);
+      msg = outline;
+      return false;
+    }
 
-          Cmd.close();
-        } catch (eos::MDException& e) {
-        }
-      }
+    // Issue a resync command for a filesystem/fid pair
+    if (!gOFS->SendResync(fid, fsid)) {
+      snprintf(outline, sizeof(outline) - 1,
+               "error: sending resync to fsid=%u failed for fxid=%llx", fsid, fid);
+      msg = outline;
+      return false;
     }
 
     return true;
   }
 
-  if (option == "drop-missing-replicas") {
-    out += "# drop missing replicas ------------------------------------------"
-           "-------------------------\n";
-    // Unlink all orphaned files - drop replicas which are in the namespace but
-    // have no 'image' on disk
-    std::map < eos::common::FileSystem::fsid_t,
-        std::set < eos::common::FileId::fileid_t >> fid2check;
-    eos::common::Mapping::VirtualIdentity vid;
-    eos::common::Mapping::Root(vid);
-    XrdOucErrInfo error;
-
-    // Loop over all filesystems
-    for (auto efsmapit = eFsMap["rep_missing_n"].cbegin();
-         efsmapit != eFsMap["rep_missing_n"].cend(); ++efsmapit) {
-      // Loop over all fids
-      for (auto it = efsmapit->second.cbegin();
-           it != efsmapit->second.cend(); ++it) {
-        std::shared_ptr<eos::IFileMD> fmd;
-        bool haslocation = false;
-        std::string path = "";
+  if (option == "unlink-unregistered") {
+    bool ok = true;
 
-        // Crosscheck if the location really is not attached
-        try {
-          eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, *it);
-          eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
-          fmd = gOFS->eosFileService->getFileMD(*it);
-          path = gOFS->eosView->getUri(fmd.get());
+    // Send external deletion
+    if (!gOFS->DeleteExternal(fsid, fid)) {
+      snprintf(outline, sizeof(outline) - 1,
+               "err: unable to send unlink to fsid=%u fxid=%llx", fsid, fid);
+      ok = false;
+    }
 
-          if (fmd->hasLocation(efsmapit->first)) {
-            haslocation = true;
-          }
-        } catch (eos::MDException& e) {}
+    // Crosscheck if the location really is not attached, otherwise drop
+    // it from the namespace
+    if (haslocation &&
+        gOFS->_dropstripe(path.c_str(), fid, error, vid, fsid, false)) {
+      snprintf(outline, sizeof(outline) - 1,
+               "error: unable to drop stripe on fsid=%u fxid=%llx", fsid, fid);
+      ok = false;
+    }
 
-        if (!haslocation) {
-          if (gOFS->DeleteExternal(efsmapit->first, *it)) {
-            char outline[1024];
-            snprintf(outline, sizeof(outline) - 1,
-                     "success: send unlink to fsid=%u fxid=%llx\n",
-                     efsmapit->first, *it);
-            out += outline;
-          } else {
-            char errline[1024];
-            snprintf(errline, sizeof(errline) - 1,
-                     "err: unable to send unlink to fsid=%u fxid=%llx\n",
-                     efsmapit->first, *it);
-            out += errline;
-          }
-        } else {
-          // Drop from the namespace
-          if (gOFS->_dropstripe(path.c_str(), *it, error, vid,
-                                efsmapit->first, false)) {
-            char outline[1024];
-            snprintf(outline, sizeof(outline) - 1,
-                     "error: unable to drop stripe on fsid=%u fxid=%llx\n",
-                     efsmapit->first, *it);
-            out += outline;
-          } else {
-            char outline[1024];
-            snprintf(outline, sizeof(outline) - 1,
-                     "success: send dropped stripe on fsid=%u fxid=%llx\n",
-                     efsmapit->first, *it);
-            out += outline;
-          }
+    msg = outline;
+    return ok;
+  }
 
-          // Execute a proc command
-          ProcCommand Cmd;
-          XrdOucString info = "mgm.cmd=file&mgm.subcmd=adjustreplica&mgm.path=";
-          info += path.c_str();
-          info += "&mgm.format=fuse";
-          Cmd.open("/proc/user", info.c_str(), vid, &error);
-          Cmd.AddOutput(out, err);
+  if (option == "unlink-orphans") {
+    // Crosscheck if the location really is not attached
+    if (haslocation) {
+      snprintf(outline, sizeof(outline) - 1,
+               "err: not sending unlink to fsid=%u fxid=%llx - location exists!",
+               fsid, fid);
+    } else if (!gOFS->DeleteExternal(fsid, fid)) {
+      snprintf(outline, sizeof(outline) - 1,
+               "err: unable to send unlink to fsid=%u fxid=%llx", fsid, fid);
+    }
 
-          if (!out.endswith("\n")) {
-            out += "\n";
-          }
+    msg = outline;
+    return (outline[0] == 0);
+  }
 
-          if (!err.endswith("\n")) {
-            err += "\n";
-          }
+  if (option.compare(0, 15, "adjust-replicas") == 0) {
+    if (!fmd) {
+      snprintf(outline, sizeof(outline) - 1,
+               "error: no file meta data for fsid=%u fxid=%llx", fsid, fid);
+      msg = outline;
+      return false;
+    }
 
-          Cmd.close();
-        }
+    bool ok = adjust_replica(option == "adjust-replicas-nodrop");
+    msg = outline;
+    return ok;
+  }
+
+  if (option == "drop-missing-replicas") {
+    // Drop replicas which are in the namespace but have no 'image' on disk
+    if (!haslocation) {
+      if (!gOFS->DeleteExternal(fsid, fid)) {
+        snprintf(outline, sizeof(outline) - 1,
+                 "err: unable to send unlink to fsid=%u fxid=%llx", fsid, fid);
+        msg = outline;
+        return false;
       }
+
+      return true;
     }
 
-    return true;
+    // Drop from the namespace
+    if (gOFS->_dropstripe(path.c_str(), fid, error, vid, fsid, false)) {
+      snprintf(outline, sizeof(outline) - 1,
+               "error: unable to drop stripe on fsid=%u fxid=%llx", fsid, fid);
+      msg = outline;
+      return false;
+    }
+
+    bool ok = adjust_replica(false);
+    msg = outline;
+    return ok;
   }
 
   if (option == "unlink-zero-replicas") {
-    out += "# unlink zero replicas -------------------------------------------"
-           "-------------------------\n";
-    // Drop all namespace entries which are older than 48 hours and have no
-    // files attached. Loop over all fids ...
-    auto const& set_fids = eMap["zero_replica"];
-
-    for (auto it = set_fids.cbegin(); it != set_fids.cend(); ++it) {
-      std::shared_ptr<eos::IFileMD> fmd;
-      std::string path = "";
-      time_t now = time(NULL);
-      out += "progress: checking fid=";
-      out += (int) * it;
-      out += "\n";
-      eos::IFileMD::ctime_t ctime;
-      ctime.tv_sec = 0;
-      ctime.tv_nsec = 0;
+    if (!fmd) {
+      return true;
+    }
 
-      try {
-        eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, *it);
-        eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
-        fmd = gOFS->eosFileService->getFileMD(*it);
-        path = gOFS->eosView->getUri(fmd.get());
-        fmd->getCTime(ctime);
-      } catch (eos::MDException& e) {}
-
-      if (fmd) {
-        if ((ctime.tv_sec + (24 * 3600)) < now) {
-          // If the file is older than 48 hours, we do the cleanup
-          eos::common::Mapping::VirtualIdentity vid;
-          eos::common::Mapping::Root(vid);
-          XrdOucErrInfo error;
-
-          if (!gOFS->_rem(path.c_str(), error, vid)) {
-            char outline[1024];
-            snprintf(outline, sizeof(outline) - 1,
-                     "success: removed path=%s fxid=%llx\n",
-                     path.c_str(), *it);
-            out += outline;
-          } else {
-            char errline[1024];
-            snprintf(errline, sizeof(errline) - 1,
-                     "err: unable to remove path=%s fxid=%llx\n",
-                     path.c_str(), *it);
-            out += errline;
-          }
-        } else {
-          out += "skipping fid=";
-          out += (int) * it;
-          out += " - file is younger than 48 hours\n";
-        }
-      }
+    // Drop namespace entries which are older than 48 hours and have no
+    // files attached
+    if ((ctime.tv_sec + (24 * 3600)) >= time(NULL)) {
+      snprintf(outline, sizeof(outline) - 1,
+               "skipping fxid=%llx - file is younger than 48 hours", fid);
+      msg = outline;
+      return true;
+    }
+
+    if (gOFS->_rem(path.c_str(), error, vid)) {
+      snprintf(outline, sizeof(outline) - 1,
+               "err: unable to remove path=%s fxid=%llx", path.c_str(), fid);
+      msg = outline;
+      return false;
     }
 
     return true;
   }
 
   if (option == "replace-damaged-replicas") {
-    out += "# repairing replace-damaged-replicas -------------------------------------------"
-           "-------------------------\n";
-
-    // Loop over all filesystems
-    for (const auto& efsmapit : eFsMap["d_mem_sz_diff"]) {
-      // Loop over all fids
-      for (const auto& fid : efsmapit.second) {
-        std::string path;
-        std::shared_ptr<eos::IFileMD> fmd;
-        {
-          eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, fid);
-          eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
-
-          try {
-            fmd = gOFS->eosFileService->getFileMD(fid);
-            path = gOFS->eosView->getUri(fmd.get());
-          } catch (eos::MDException& e) {}
-        }
+    if (fmd == nullptr) {
+      snprintf(outline, sizeof(outline) - 1,
+               "error: unable to repair file fsid=%u fxid=%llx, could not get "
+               "meta data", fsid, fid);
+      msg = outline;
+      return false;
+    }
 
-        if (fmd == nullptr) {
-          char errline[1024];
-          snprintf(errline, sizeof(errline) - 1,
-                   "error: unable to repair file fsid=%u fxid=%llx, could not get meta data\n",
-                   efsmapit.first, fid);
-          out += errline;
-          break;
-        }
+    bool replicaAvailable = false;
+    {
+      XrdSysMutexHelper lock(eMutex);
+      eos::common::RWMutexReadLock fsViewLock(FsView::gFsView.ViewMutex);
+      auto damaged = eFsMap.find("d_mem_sz_diff");
 
-        bool replicaAvailable = false;
-        {
-          eos::common::RWMutexReadLock fsViewLock(FsView::gFsView.ViewMutex);
+      for (const auto& lfsid : fmd->getLocations()) {
+        if (fsid != lfsid) {
+          FileSystem* fileSystem = nullptr;
 
-          for (const auto& fsid : fmd->getLocations()) {
-            if (efsmapit.first != fsid) {
-              FileSystem* fileSystem = nullptr;
+          if (FsView::gFsView.mIdView.count(lfsid) != 0) {
+            fileSystem = FsView::gFsView.mIdView[lfsid];
+            bool inconsistent = false;
 
-              if (FsView::gFsView.mIdView.count(fsid) != 0) {
-                fileSystem = FsView::gFsView.mIdView[fsid];
-                const auto& inconsistentsOnFs = eFsMap["d_mem_sz_diff"][fsid];
-                auto found = inconsistentsOnFs.find(fid);
+            if (damaged != eFsMap.end()) {
+              auto fsit = damaged->second.find(lfsid);
+              inconsistent = ((fsit != damaged->second.end()) &&
+                              fsit->second.count(fid));
+            }
 
-                if (fileSystem != nullptr &&
-                    fileSystem->GetConfigStatus(false) > FileSystem::kRO &&
-                    found == inconsistentsOnFs.end()) {
-                  replicaAvailable = true;
-                  break;
-                }
-              }
+            if (fileSystem != nullptr &&
+                fileSystem->GetConfigStatus(false) > FileSystem::kRO &&
+                !inconsistent) {
+              replicaAvailable = true;
+              break;
             }
           }
         }
+      }
+    }
 
-        if (!replicaAvailable) {
-          char errline[1024];
-          snprintf(errline, sizeof(errline) - 1,
-                   "error: unable to repair file fsid=%u fxid=%llx, no available file systems and replicas to use\n",
-                   efsmapit.first, fid);
-          out += errline;
-          break;
-        }
-
-        eos::common::Mapping::VirtualIdentity vid;
-        eos::common::Mapping::Root(vid);
-        XrdOucErrInfo error;
-
-        if (gOFS->_dropstripe(path.c_str(), fid, error, vid, efsmapit.first, true)) {
-          char errline[1024];
-          snprintf(errline, sizeof(errline) - 1,
-                   "error: unable to repair file fsid=%u fxid=%llx, could not drop it\n",
-                   efsmapit.first, fid);
-          out += errline;
-        } else {
-          ProcCommand Cmd;
-          XrdOucString info = "mgm.cmd=file&mgm.subcmd=adjustreplica&mgm.path=";
-          info += path.c_str();
-          info += "&mgm.format=fuse";
-          Cmd.open("/proc/user", info.c_str(), vid, &error);
-          Cmd.AddOutput(out, err);
-
-          if (!out.endswith("\n")) {
-            out += "\n";
-          }
-
-          if (!err.endswith("\n")) {
-            err += "\n";
-          }
+    if (!replicaAvailable) {
+      snprintf(outline, sizeof(outline) - 1,
+               "error: unable to repair file fsid=%u fxid=%llx, no available "
+               "file systems and replicas to use", fsid, fid);
+      msg = outline;
+      return false;
+    }
 
-          Cmd.close();
-        }
-      }
+    if (gOFS->_dropstripe(path.c_str(), fid, error, vid, fsid, true)) {
+      snprintf(outline, sizeof(outline) - 1,
+               "error: unable to repair file fsid=%u fxid=%llx, could not drop it",
+               fsid, fid);
+      msg = outline;
+      return false;
     }
 
-    return true;
+    bool ok = adjust_replica(false);
+    msg = outline;
+    return ok;
   }
 
-  err = "error: unavailable option";
+  msg = "error: unavailable option " + option;
   return false;
 }
 
@@ -1570,7 +1460,7 @@ void
 Fsck::ResetErrorMaps()
 {
   XrdSysMutexHelper lock(eMutex);
-  eFsMap.clear();
+  eFsMap.erase("rep_offline");
   eMap.clear();
   eCount.clear();
   eFsUnavail.clear();
@@ -1578,4 +1468,141 @@ Fsck::ResetErrorMaps()
   eTimeStamp = time(NULL);
 }
 
+//------------------------------------------------------------------------------
+// Apply the fsck replies of the FSTs to the error maps
+//------------------------------------------------------------------------------
+void
+Fsck::ApplyFeed(std::vector<std::string>& lines, bool full)
+{
+  std::map<std::string, uint64_t> feed_seq;
+  std::set<eos::common::FileSystem::fsid_t> replace;
+  unsigned long long changes = 0;
+
+  // The header line of each FST lists the filesystems sent with the full
+  // sets, FSTs without change feed send plain lines without header
+  for (auto it = lines.cbegin(); it != lines.cend(); ++it) {
+    if (it->compare(0, 6, "#fsck ") == 0) {
+      std::vector<std::string> tokens;
+      eos::common::StringConversion::Tokenize(*it, tokens, " ");
+
+      if (tokens.size() < 3) {
+        eos_static_err("Can not parse fsck header: %s", it->c_str());
+        continue;
+      }
+
+      feed_seq[tokens[1]] = strtoull(tokens[2].c_str(), 0, 10);
+
+      if (tokens.size() > 3) {
+        std::vector<std::string> fsids;
+        eos::common::StringConversion::Tokenize(tokens[3], fsids, ",");
+
+        for (auto fsid = fsids.cbegin(); fsid != fsids.cend(); ++fsid) {
+          replace.insert(strtoul(fsid->c_str(), 0, 10));
+        }
+      }
+    } else if (it->length() && ((*it)[0] != '+') && ((*it)[0] != '-')) {
+      size_t pos = it->find('@');
+
+      if (pos != std::string::npos) {
+        replace.insert(strtoul(it->c_str() + pos + 1, 0, 10));
+      }
+    }
+  }
+
+  XrdSysMutexHelper lock(eMutex);
+
+  if (full) {
+    eFsMap.clear();
+  } else {
+    for (auto tagit = eFsMap.begin(); tagit != eFsMap.end(); ++tagit) {
+      for (auto fsid = replace.cbegin(); fsid != replace.cend(); ++fsid) {
+        tagit->second.erase(*fsid);
+      }
+    }
+  }
+
+  for (size_t nlines = 0; nlines < lines.size(); nlines++) {
+    char* line = (char*) lines[nlines].c_str();
+    bool remove = false;
+
+    if (line[0] == '#') {
+      continue;
+    }
+
+    if ((line[0] == '+') || (line[0] == '-')) {
+      remove = (line[0] == '-');
+      line++;
+    }
+
+    std::set<unsigned long long> fids;
+    unsigned long fsid = 0;
+    std::string errortag;
+
+    if (!eos::common::StringConversion::ParseStringIdSet(line, errortag, fsid,
+        fids)) {
+      eos_static_err("Can not parse fsck response: %s", lines[nlines].c_str());
+      continue;
+    }
+
+    if (!fsid || errortag.empty()) {
+      continue;
+    }
+
+    changes += fids.size();
+
+    if (remove) {
+      auto tagit = eFsMap.find(errortag);
+
+      if (tagit == eFsMap.end()) {
+        continue;
+      }
+
+      auto fsit = tagit->second.find(fsid);
+
+      if (fsit == tagit->second.end()) {
+        continue;
+      }
+
+      for (auto it = fids.cbegin(); it != fids.cend(); ++it) {
+        fsit->second.erase(*it);
+      }
+
+      if (fsit->second.empty()) {
+        tagit->second.erase(fsit);
+      }
+    } else {
+      eFsMap[errortag][fsid].insert(fids.begin(), fids.end());
+    }
+  }
+
+  {
+    // Drop the errors of filesystems which are no longer configured
+    eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
+
+    for (auto tagit = eFsMap.begin(); tagit != eFsMap.end(); ++tagit) {
+      for (auto fsit = tagit->second.begin(); fsit != tagit->second.end();) {
+        if (!FsView::gFsView.mIdView.count(fsit->first)) {
+          fsit = tagit->second.erase(fsit);
+        } else {
+          ++fsit;
+        }
+      }
+    }
+  }
+
+  // The summary is derived from the per filesystem sets
+  for (auto tagit = eFsMap.cbegin(); tagit != eFsMap.cend(); ++tagit) {
+    for (auto fsit = tagit->second.cbegin(); fsit != tagit->second.cend();
+         ++fsit) {
+      eMap[tagit->first].insert(fsit->second.begin(), fsit->second.end());
+      eCount[tagit->first] += fsit->second.size();
+    }
+  }
+
+  Log(false, "collected %s feed from %lu FSTs: %llu changes, %lu filesystems "
+      "replaced", full ? "full" : "incremental", feed_seq.size(), changes,
+      replace.size());
+  mFeedSeq.swap(feed_seq);
+}
+
 EOSMGMNAMESPACE_END
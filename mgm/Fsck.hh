@@ -25,6 +25,7 @@
 #define __EOSMGM_FSCK__HH__
 
 #include "mgm/Namespace.hh"
+#include "mgm/FsckRepair.hh"
 #include "common/FileSystem.hh"
 #include "common/FileId.hh"
 #include "common/AssistedThread.hh"
@@ -33,6 +34,8 @@
 #include <stdarg.h>
 #include <map>
 #include <set>
+#include <unordered_set>
+#include <vector>
 
 //------------------------------------------------------------------------------
 //! @file Fsck.hh
@@ -52,10 +55,18 @@ EOSMGMNAMESPACE_BEGIN
 class Fsck
 {
 public:
+  //! Compact set of fids of one error class
+  typedef std::unordered_set<eos::common::FileId::fileid_t> FidSet;
+  //! Fids of one error class per filesystem
+  typedef std::map<eos::common::FileSystem::fsid_t, FidSet> FsFidSet;
+
   //! Key used in the configuration engine to store the enable status
   static const char* gFsckEnabled;
   //! Key used in the configuration engine to store the check interval
   static const char* gFsckInterval;
+  //! Key used in the configuration engine to store the repair actions with
+  //! pending jobs
+  static const char* gFsckRepair;
 
   //----------------------------------------------------------------------------
   //! Constructor
@@ -96,7 +107,8 @@ public:
               XrdOucString selection = "");
 
   //----------------------------------------------------------------------------
-  //! Method ot issue a repair action
+  //! Method ot issue a repair action, the repair jobs are submitted to the
+  //! repair executor and their progress is shown by PrintOut
   //!
   //! @param out return of the action output
   //! @param err return of STDERR
@@ -104,6 +116,21 @@ public:
   //----------------------------------------------------------------------------
   bool Repair(XrdOucString& out, XrdOucString& err, XrdOucString option = "");
 
+  //----------------------------------------------------------------------------
+  //! Fill the node and priority of a repair job, called by the executor
+  //----------------------------------------------------------------------------
+  void ClassifyRepair(FsckRepair::Job& job);
+
+  //----------------------------------------------------------------------------
+  //! Repair a single fid on a single filesystem, called by the executor
+  //!
+  //! @param job repair job
+  //! @param msg message describing a failure
+  //!
+  //! @return true if successful
+  //----------------------------------------------------------------------------
+  bool RepairFid(const FsckRepair::Job& job, std::string& msg);
+
   //----------------------------------------------------------------------------
   //! Clear the in-memory log
   //----------------------------------------------------------------------------
@@ -140,12 +167,12 @@ private:
   AssistedThread mThread; ///< Collection thread id
   bool mRunning; ///< True if collection thread is currently running
   XrdSysMutex eMutex; ///< Mutex protecting all eX... map objects
-  //! Error detail map storing "<error-name>=><fsid>=>[fid1,fid2,fid3...]"
-  std::map<std::string,
-      std::map<eos::common::FileSystem::fsid_t,
-      std::set <eos::common::FileId::fileid_t> > > eFsMap;
+  //! Error detail map storing "<error-name>=><fsid>=>[fid1,fid2,fid3...]",
+  //! the errors reported by the FSTs are kept between collections and
+  //! updated from their change feeds
+  std::map<std::string, FsFidSet> eFsMap;
   //! Error summary map storing "<error-name>"=>[fid1,fid2,fid3...]"
-  std::map<std::string, std::set <eos::common::FileId::fileid_t> > eMap;
+  std::map<std::string, FidSet> eMap;
   std::map<std::string, unsigned long long > eCount;
   //! Unavailable filesystems map
   std::map<eos::common::FileSystem::fsid_t, unsigned long long > eFsUnavail;
@@ -153,11 +180,52 @@ private:
   //! in the filesystem view
   std::map<eos::common::FileSystem::fsid_t, unsigned long long > eFsDark;
   time_t eTimeStamp; ///< Timestamp of collection
+  //! Last sequence number of the change feed of each FST by its epoch, only
+  //! used by the collection thread
+  std::map<std::string, uint64_t> mFeedSeq;
+  //! Number of collections since the last full resynchronisation
+  int mFeedCycles;
+  //! Collections after which the full inconsistency sets are requested
+  static constexpr int sFeedResyncCycles = 16;
+  //! Priority of repair jobs of files without meta data
+  static constexpr int sRepairNoFilePriority = 1000;
+  FsckRepair mRepair; ///< Executor of the repair jobs
+  XrdSysMutex mRepairMutex; ///< Mutex protecting mRepairActions
+  //! Repair actions submitted to the executor of this MGM
+  std::set<std::string> mRepairActions;
+
+  //----------------------------------------------------------------------------
+  //! Reset all errors computed by the MGM, the errors reported by the FSTs
+  //! are kept and only updated by ApplyFeed
+  //----------------------------------------------------------------------------
+  void ResetErrorMaps();
 
   //----------------------------------------------------------------------------
-  //! Reset all collected errors in the error map
+  //! Apply the fsck replies of the FSTs to the error maps
+  //!
+  //! @param lines reply lines of all FSTs
+  //! @param full true if the full sets were requested from all FSTs
   //----------------------------------------------------------------------------
-  void ResetErrorMaps();
+  void ApplyFeed(std::vector<std::string>& lines, bool full);
+
+  //----------------------------------------------------------------------------
+  //! Collect the fids of a repair action from the error maps and submit them
+  //!
+  //! @return number of new repair jobs
+  //----------------------------------------------------------------------------
+  size_t SubmitRepair(const std::string& action);
+
+  //----------------------------------------------------------------------------
+  //! Store the repair actions with pending jobs in the configuration engine,
+  //! mRepairMutex has to be locked
+  //----------------------------------------------------------------------------
+  void StoreRepairActions();
+
+  //----------------------------------------------------------------------------
+  //! Submit the repair actions stored by a previous master and forget about
+  //! the actions without pending jobs
+  //----------------------------------------------------------------------------
+  void ResumeRepairs();
 };
 
 EOSMGMNAMESPACE_END
@@ -0,0 +1,296 @@
+//------------------------------------------------------------------------------
+// File: FsckRepair.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/FsckRepair.hh"
+#include "mgm/Fsck.hh"
+#include "mgm/XrdMgmOfs.hh"
+#include "mgm/Master.hh"
+#include "common/Logging.hh"
+#include <cstdlib>
+
+EOSMGMNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Read a positive limit from the environment
+//------------------------------------------------------------------------------
+unsigned int
+GetLimit(const char* name, unsigned int def)
+{
+  const char* ptr = getenv(name);
+  long val = (ptr ? strtol(ptr, nullptr, 10) : def);
+  return (val > 0 ? (unsigned int) val : def);
+}
+
+unsigned int
+GetThreads()
+{
+  static unsigned int sThreads = []() {
+    return GetLimit("EOS_MGM_FSCK_REPAIR_THREADS", 16);
+  }();
+  return sThreads;
+}
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FsckRepair::FsckRepair(Fsck& fsck):
+  mFsck(fsck), mThreads(GetThreads()),
+  mFsLimit(GetLimit("EOS_MGM_FSCK_REPAIR_FS_LIMIT", 2)),
+  mNodeLimit(GetLimit("EOS_MGM_FSCK_REPAIR_NODE_LIMIT", 8)),
+  mQueued(0), mRunning(0), mStarted(false),
+  mPool(GetThreads(), GetThreads(), 10, 6, 5, "fsck_repair")
+{}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+FsckRepair::~FsckRepair()
+{
+  mThread.join();
+  mPool.Stop();
+}
+
+//------------------------------------------------------------------------------
+// Key identifying a job
+//------------------------------------------------------------------------------
+std::string
+FsckRepair::Key(const Job& job)
+{
+  return job.action + ":" + std::to_string(job.fsid) + ":" +
+         std::to_string(job.fid);
+}
+
+//------------------------------------------------------------------------------
+// Submit repair jobs
+//------------------------------------------------------------------------------
+size_t
+FsckRepair::Submit(const std::string& action,
+                   const std::map<eos::common::FileSystem::fsid_t,
+                   std::vector<eos::common::FileId::fileid_t>>& fids)
+{
+  size_t added = 0;
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  for (auto fsit = fids.cbegin(); fsit != fids.cend(); ++fsit) {
+    for (auto it = fsit->second.cbegin(); it != fsit->second.cend(); ++it) {
+      Job job;
+      job.action = action;
+      job.fsid = fsit->first;
+      job.fid = *it;
+      job.priority = 0;
+
+      if (!mKnown.insert(Key(job)).second) {
+        continue;
+      }
+
+      mInbox.push_back(std::move(job));
+      ++added;
+    }
+  }
+
+  mProgress[action].submitted += added;
+  mPending[action] += added;
+
+  if (!mStarted) {
+    mStarted = true;
+    mThread.reset(&FsckRepair::Dispatch, this);
+  }
+
+  mCond.notify_all();
+  return added;
+}
+
+//------------------------------------------------------------------------------
+// Get the number of pending jobs of an action
+//------------------------------------------------------------------------------
+size_t
+FsckRepair::Pending(const std::string& action)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mPending.find(action);
+  return (it == mPending.end() ? 0 : it->second);
+}
+
+//------------------------------------------------------------------------------
+// Print the repair progress
+//------------------------------------------------------------------------------
+void
+FsckRepair::PrintOut(XrdOucString& out)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  char line[1024];
+  snprintf(line, sizeof(line), "repair threads=%u fs-limit=%u node-limit=%u "
+           "unclassified=%lu queued=%lu running=%lu\n", mThreads, mFsLimit,
+           mNodeLimit, (unsigned long) mInbox.size(), (unsigned long) mQueued,
+           (unsigned long) mRunning);
+  out += line;
+
+  for (auto it = mProgress.cbegin(); it != mProgress.cend(); ++it) {
+    snprintf(line, sizeof(line), "repair action=%s submitted=%llu done=%llu "
+             "failed=%llu pending=%lu\n", it->first.c_str(),
+             it->second.submitted, it->second.done, it->second.failed,
+             (unsigned long) mPending[it->first]);
+    out += line;
+  }
+
+  for (auto it = mErrors.cbegin(); it != mErrors.cend(); ++it) {
+    out += "repair error: ";
+    out += it->c_str();
+    out += "\n";
+  }
+}
+
+//------------------------------------------------------------------------------
+// Dispatcher thread classifying jobs and passing them to the pool
+//------------------------------------------------------------------------------
+void
+FsckRepair::Dispatch(ThreadAssistant& assistant) noexcept
+{
+  while (!assistant.terminationRequested()) {
+    std::vector<Job> batch;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+
+      while (batch.size() < sClassifyBatch && !mInbox.empty()) {
+        batch.push_back(std::move(mInbox.front()));
+        mInbox.pop_front();
+      }
+    }
+
+    // Classification looks up the file meta data, don't hold the mutex
+    for (auto it = batch.begin(); it != batch.end(); ++it) {
+      mFsck.ClassifyRepair(*it);
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    for (auto it = batch.begin(); it != batch.end(); ++it) {
+      mQueue[it->priority].push_back(std::move(*it));
+      ++mQueued;
+    }
+
+    // Only the master runs repairs, a slave keeps its jobs until it either
+    // becomes master again or the new master has repaired the files
+    if (gOFS->mMaster->IsMaster()) {
+      StartJobs();
+    }
+
+    if (mInbox.empty()) {
+      mCond.wait_for(lock, std::chrono::milliseconds(500));
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Start the jobs allowed by the limits
+//------------------------------------------------------------------------------
+void
+FsckRepair::StartJobs()
+{
+  size_t scanned = 0;
+
+  for (auto qit = mQueue.begin(); qit != mQueue.end();) {
+    for (auto it = qit->second.begin(); it != qit->second.end();) {
+      if (mRunning >= mThreads) {
+        return;
+      }
+
+      if ((it->fsid && (mRunningFs[it->fsid] >= mFsLimit)) ||
+          (it->node.length() && (mRunningNode[it->node] >= mNodeLimit))) {
+        if (++scanned >= sMaxScan) {
+          return;
+        }
+
+        ++it;
+        continue;
+      }
+
+      ++mRunning;
+      ++mRunningFs[it->fsid];
+      ++mRunningNode[it->node];
+      --mQueued;
+      Job job = std::move(*it);
+      it = qit->second.erase(it);
+      mPool.PushTask<void>([this, job]() {
+        Run(job);
+      });
+    }
+
+    if (qit->second.empty()) {
+      qit = mQueue.erase(qit);
+    } else {
+      ++qit;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Execute a job on the pool
+//------------------------------------------------------------------------------
+void
+FsckRepair::Run(Job job)
+{
+  std::string msg;
+  bool ok = mFsck.RepairFid(job, msg);
+
+  if (!ok) {
+    eos_static_err("msg=\"fsck repair failed\" action=%s fsid=%lu fxid=%08llx "
+                   "reason=\"%s\"", job.action.c_str(), (unsigned long) job.fsid,
+                   job.fid, msg.c_str());
+  } else {
+    eos_static_info("msg=\"fsck repair done\" action=%s fsid=%lu fxid=%08llx",
+                    job.action.c_str(), (unsigned long) job.fsid, job.fid);
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  --mRunning;
+
+  if (!--mRunningFs[job.fsid]) {
+    mRunningFs.erase(job.fsid);
+  }
+
+  if (!--mRunningNode[job.node]) {
+    mRunningNode.erase(job.node);
+  }
+
+  Progress& progress = mProgress[job.action];
+
+  if (ok) {
+    ++progress.done;
+  } else {
+    ++progress.failed;
+    mErrors.push_back(msg);
+
+    if (mErrors.size() > sMaxErrors) {
+      mErrors.pop_front();
+    }
+  }
+
+  --mPending[job.action];
+  mKnown.erase(Key(job));
+  mCond.notify_all();
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,164 @@
+//------------------------------------------------------------------------------
+//! @file FsckRepair.hh
+//! @brief Parallel and rate controlled executor of FSCK repair jobs
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/FileSystem.hh"
+#include "common/FileId.hh"
+#include "common/ThreadPool.hh"
+#include "common/AssistedThread.hh"
+#include "XrdOuc/XrdOucString.hh"
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+class Fsck;
+
+//------------------------------------------------------------------------------
+//! @brief Class executing FSCK repair jobs on a thread pool
+//!
+//! Every job repairs a single fid on a single filesystem. Submitted jobs are
+//! first classified by the Fsck object, which provides the node of the
+//! filesystem and the number of healthy replicas of the file. Jobs of files
+//! with the fewest healthy replicas are dispatched first, while the number of
+//! jobs running at the same time per filesystem and per node is limited.
+//!
+//! A job is identified by action, fsid and fid, submitting a job which is
+//! already pending is a no-op. The actions with pending jobs are stored in
+//! the configuration engine so a new master resubmits them from its own
+//! FSCK collection - all repair actions can safely be repeated.
+//------------------------------------------------------------------------------
+class FsckRepair
+{
+public:
+  //! Repair job of one fid on one filesystem
+  struct Job {
+    std::string action; ///< Repair action, see Fsck::Repair
+    eos::common::FileSystem::fsid_t fsid; ///< Filesystem, 0 if not specific
+    eos::common::FileId::fileid_t fid; ///< File id
+    std::string node; ///< Node of the filesystem
+    int priority; ///< Lower values are dispatched first
+  };
+
+  //! Progress of one repair action
+  struct Progress {
+    Progress(): submitted(0), done(0), failed(0) {}
+
+    unsigned long long submitted;
+    unsigned long long done;
+    unsigned long long failed;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param fsck object classifying and executing the jobs
+  //----------------------------------------------------------------------------
+  FsckRepair(Fsck& fsck);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~FsckRepair();
+
+  //----------------------------------------------------------------------------
+  //! Submit repair jobs
+  //!
+  //! @param action repair action
+  //! @param fids fids to repair per filesystem
+  //!
+  //! @return number of jobs which were not already pending
+  //----------------------------------------------------------------------------
+  size_t Submit(const std::string& action,
+                const std::map<eos::common::FileSystem::fsid_t,
+                std::vector<eos::common::FileId::fileid_t>>& fids);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of pending jobs of an action
+  //----------------------------------------------------------------------------
+  size_t Pending(const std::string& action);
+
+  //----------------------------------------------------------------------------
+  //! Print the repair progress
+  //!
+  //! @param out output string
+  //----------------------------------------------------------------------------
+  void PrintOut(XrdOucString& out);
+
+private:
+  //! Maximum number of jobs classified in one round of the dispatcher
+  static constexpr size_t sClassifyBatch = 1000;
+  //! Maximum number of blocked jobs skipped in one round of the dispatcher
+  static constexpr size_t sMaxScan = 10000;
+  //! Number of failure messages kept for the status output
+  static constexpr size_t sMaxErrors = 16;
+
+  Fsck& mFsck;
+  unsigned int mThreads; ///< Maximum number of running jobs
+  unsigned int mFsLimit; ///< Maximum number of running jobs per filesystem
+  unsigned int mNodeLimit; ///< Maximum number of running jobs per node
+  std::mutex mMutex; ///< Mutex protecting the members below
+  std::condition_variable mCond; ///< Signalled by new and finished jobs
+  std::unordered_set<std::string> mKnown; ///< Keys of all pending jobs
+  std::deque<Job> mInbox; ///< Jobs waiting for classification
+  std::map<int, std::list<Job>> mQueue; ///< Classified jobs by priority
+  size_t mQueued; ///< Number of classified jobs waiting
+  size_t mRunning; ///< Number of running jobs
+  std::map<eos::common::FileSystem::fsid_t, unsigned int> mRunningFs;
+  std::map<std::string, unsigned int> mRunningNode;
+  std::map<std::string, Progress> mProgress; ///< Progress per action
+  std::map<std::string, size_t> mPending; ///< Pending jobs per action
+  std::deque<std::string> mErrors; ///< Last failure messages
+  bool mStarted; ///< True if the dispatcher thread is running
+  eos::common::ThreadPool mPool; ///< Pool executing the jobs
+  AssistedThread mThread; ///< Dispatcher thread
+
+  //----------------------------------------------------------------------------
+  //! Key identifying a job
+  //----------------------------------------------------------------------------
+  static std::string Key(const Job& job);
+
+  //----------------------------------------------------------------------------
+  //! Dispatcher thread classifying jobs and passing them to the pool
+  //----------------------------------------------------------------------------
+  void Dispatch(ThreadAssistant& assistant) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Start the jobs allowed by the limits, mMutex has to be locked
+  //----------------------------------------------------------------------------
+  void StartJobs();
+
+  //----------------------------------------------------------------------------
+  //! Execute a job on the pool
+  //----------------------------------------------------------------------------
+  void Run(Job job);
+};
+
+EOSMGMNAMESPACE_END
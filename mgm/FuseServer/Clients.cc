@@ -24,6 +24,7 @@
 #include <string>
 #include <cstdlib>
 #include <thread>
+#include <set>
 
 #include "mgm/FuseServer/Clients.hh"
 #include "common/Logging.hh"
@@ -34,6 +35,22 @@
 
 EOSMGMNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+// Window in ms during which broadcast events to a client are coalesced,
+// 0 sends every event immediately
+//------------------------------------------------------------------------------
+static int BroadcastWindowMs()
+{
+  static int window = []() {
+    const char* ptr = getenv("EOS_MGM_FUSEX_BROADCAST_WINDOW_MS");
+    return ptr ? (int) strtol(ptr, 0, 10) : 10;
+  }();
+  return window;
+}
+
+// maximum number of events packed into a single batch frame
+static constexpr int kMaxBatchEvents = 1024;
+
 
 //------------------------------------------------------------------------------
 // Retrieve global eosxd client statistics
@@ -73,6 +90,7 @@ FuseServer::Clients::MonitorHeartBeat()
   while (true) {
     client_uuid_t evictmap;
     client_uuid_t evictversionmap;
+    FuseServer::Lock::lockwaiters_t lockwaiters;
     {
       eos::common::RWMutexWriteLock lLock(*this);
       struct timespec tsnow;
@@ -96,7 +114,8 @@ FuseServer::Clients::MonitorHeartBeat()
               } else {
                 // drop locks once
                 if (it->second.state() != Client::OFFLINE) {
-                  gOFS->zMQ->gFuseServer.Locks().dropLocks(it->second.heartbeat().uuid());
+                  gOFS->zMQ->gFuseServer.Locks().dropLocks(it->second.heartbeat().uuid(),
+                      &lockwaiters);
                 }
 
                 it->second.set_state(Client::OFFLINE);
@@ -123,10 +142,13 @@ FuseServer::Clients::MonitorHeartBeat()
       }
     }
 
+    // the waiters on the locks of offline clients retry
+    FuseServer::Lock::notifyWaiters(lockwaiters);
+
     // delete client ot be evicted because of a version mismatch
     for (auto it = evictversionmap.begin(); it != evictversionmap.end(); ++it) {
       std::string versionerror =
-        "Server supports PROTOCOLV4 and requires atleast PROTOCOLV2";
+        "Server supports PROTOCOLV5 and requires atleast PROTOCOLV2";
       std::string uuid = it->first;
       Evict(uuid, versionerror);
       mMap.erase(it->second);
@@ -218,6 +240,9 @@ FuseServer::Clients::Dispatch(const std::string identity,
     cfg.set_writesizeflush(true);
     cfg.set_appname(true);
     cfg.set_mdquery(true);
+    cfg.set_mdsince(true);
+    cfg.set_mdbatch(true);
+    cfg.set_locknotify(true);
     cfg.set_serverversion(std::string(VERSION) + std::string("::") + std::string(
                             RELEASE));
     BroadcastConfig(identity, cfg);
@@ -314,6 +339,11 @@ FuseServer::Clients::Print(std::string& out, std::string options)
       lockup = "vacant";
     }
 
+    size_t bc_queue = 0;
+    uint64_t bc_coalesced = 0;
+    uint64_t bc_frames = 0;
+    QueueStats(it->first, bc_queue, bc_coalesced, bc_frames);
+
     if (!options.length() || (options.find("l") != std::string::npos)) {
       snprintf(formatline, sizeof(formatline),
                "client : %-8s %32s %-8s %-8s %s %.02f %.02f %36s p=%u caps=%lu fds=%u %s %s %s mount=%s \n",
@@ -367,7 +397,10 @@ FuseServer::Clients::Print(std::string& out, std::string options)
                "......   ra-nobuf     : %lu\n"
                "......   wr-nobuf     : %lu\n"
                "......   idle         : %ld\n"
-	       "......   blockedms    : %.02f\n",
+	       "......   blockedms    : %.02f\n"
+               "......   bc-queue     : %lu\n"
+               "......   bc-coalesced : %lu\n"
+               "......   bc-frames    : %lu\n",
                it->second.statistics().inodes(),
                it->second.statistics().inodes_todelete(),
                it->second.statistics().inodes_backlog(),
@@ -395,7 +428,10 @@ FuseServer::Clients::Print(std::string& out, std::string options)
                it->second.statistics().ranobuf(),
                it->second.statistics().wrnobuf(),
                idletime,
-	       it->second.statistics().blockedms()
+	       it->second.statistics().blockedms(),
+               bc_queue,
+               bc_coalesced,
+               bc_frames
               );
       out += formatline;
     }
@@ -430,7 +466,10 @@ FuseServer::Clients::Print(std::string& out, std::string options)
 	       "ra-nobuf=%lu "
 	       "wr-nobuf=%lu "
 	       "idle=%ld "
-	       "blockedms=%f",
+	       "blockedms=%f "
+	       "bc-queue=%lu "
+	       "bc-coalesced=%lu "
+	       "bc-frames=%lu",
 	       it->second.heartbeat().name().c_str(),
 	       it->second.heartbeat().host().c_str(),
 	       it->second.heartbeat().version().c_str(),
@@ -473,7 +512,10 @@ FuseServer::Clients::Print(std::string& out, std::string options)
 	       it->second.statistics().ranobuf(),
 	       it->second.statistics().wrnobuf(),
 	       idletime,
-	       it->second.statistics().blockedms()
+	       it->second.statistics().blockedms(),
+	       bc_queue,
+	       bc_coalesced,
+	       bc_frames
 	       );
       out += formatline;
     }
@@ -751,8 +793,6 @@ FuseServer::Clients::ReleaseCAP(uint64_t md_ino,
   rsp.mutable_lease_()->set_type(eos::fusex::lease::RELEASECAP);
   rsp.mutable_lease_()->set_md_ino(md_ino);
   rsp.mutable_lease_()->set_clientid(clientid);
-  std::string rspstream;
-  rsp.SerializeToString(&rspstream);
   eos::common::RWMutexReadLock lLock(*this);
 
   if (!mUUIDView.count(uuid)) {
@@ -760,10 +800,11 @@ FuseServer::Clients::ReleaseCAP(uint64_t md_ino,
   }
 
   std::string id = mUUIDView[uuid];
+  bool batch = SupportsBatch(id);
   lLock.Release();
   eos_static_info("msg=\"asking cap release\" uuid=%s clientid=%s id=%lx",
                   uuid.c_str(), clientid.c_str(), md_ino);
-  gOFS->zMQ->mTask->reply(id, rspstream);
+  Send(id, batch, rsp, "l:" + std::to_string(md_ino) + ":" + clientid);
   EXEC_TIMING_END("Eosxd::int::ReleaseCap");
   return 0;
 }
@@ -787,8 +828,6 @@ FuseServer::Clients::DeleteEntry(uint64_t md_ino,
   rsp.mutable_dentry_()->set_name(name);
   rsp.mutable_dentry_()->set_md_ino(md_ino);
   rsp.mutable_dentry_()->set_clientid(clientid);
-  std::string rspstream;
-  rsp.SerializeToString(&rspstream);
   eos::common::RWMutexReadLock lLock(*this);
 
   if (!mUUIDView.count(uuid)) {
@@ -796,10 +835,12 @@ FuseServer::Clients::DeleteEntry(uint64_t md_ino,
   }
 
   std::string id = mUUIDView[uuid];
+  bool batch = SupportsBatch(id);
   lLock.Release();
   eos_static_info("msg=\"asking dentry deletion\" uuid=%s clientid=%s id=%lx name=%s",
                   uuid.c_str(), clientid.c_str(), md_ino, name.c_str());
-  gOFS->zMQ->mTask->reply(id, rspstream);
+  Send(id, batch, rsp, "d:" + std::to_string(md_ino) + ":" + clientid + ":" +
+       name);
   EXEC_TIMING_END("Eosxd::int::DeleteEntry");
   return 0;
 }
@@ -819,8 +860,6 @@ FuseServer::Clients::RefreshEntry(uint64_t md_ino,
   eos::fusex::response rsp;
   rsp.set_type(rsp.REFRESH);
   rsp.mutable_refresh_()->set_md_ino(md_ino);
-  std::string rspstream;
-  rsp.SerializeToString(&rspstream);
   eos::common::RWMutexReadLock lLock(*this);
 
   if (!mUUIDView.count(uuid)) {
@@ -835,17 +874,46 @@ FuseServer::Clients::RefreshEntry(uint64_t md_ino,
     eos_static_info("suppressing refresh to client '%s' version='%s'",
                     clientid.c_str(), map()[id].heartbeat().version().c_str());
   } else {
-    std::string id = mUUIDView[uuid];
+    bool batch = SupportsBatch(id);
     lLock.Release();
     eos_static_info("msg=\"asking dentry refresh\" uuid=%s clientid=%s id=%lx",
                     uuid.c_str(), clientid.c_str(), md_ino);
-    gOFS->zMQ->mTask->reply(id, rspstream);
+    Send(id, batch, rsp, "r:" + std::to_string(md_ino));
   }
 
   EXEC_TIMING_END("Eosxd::int::RefreshEntry");
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Notify a client that a lock it waits for was released
+//------------------------------------------------------------------------------
+int
+FuseServer::Clients::NotifyLockRelease(uint64_t md_ino,
+                                       const std::string& uuid)
+{
+  gOFS->MgmStats.Add("Eosxd::int::NotifyLock", 0, 0, 1);
+  EXEC_TIMING_BEGIN("Eosxd::int::NotifyLock");
+  eos::fusex::response rsp;
+  rsp.set_type(rsp.LOCK);
+  rsp.mutable_lock_()->set_type(eos::fusex::lock::UNLCK);
+  rsp.mutable_lock_()->set_md_ino(md_ino);
+  eos::common::RWMutexReadLock lLock(*this);
+
+  if (!mUUIDView.count(uuid)) {
+    return ENOENT;
+  }
+
+  std::string id = mUUIDView[uuid];
+  lLock.Release();
+  eos_static_info("msg=\"notify lock waiter\" uuid=%s id=%lx", uuid.c_str(),
+                  md_ino);
+  // not queued, the waiter retries as soon as possible
+  Send(id, false, rsp, "");
+  EXEC_TIMING_END("Eosxd::int::NotifyLock");
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 //
 //------------------------------------------------------------------------------
@@ -880,19 +948,19 @@ FuseServer::Clients::SendMD(const eos::fusex::md& md,
   }
 
   rsp.mutable_md_()->set_clock(clock);
-  std::string rspstream;
-  rsp.SerializeToString(&rspstream);
   eos::common::RWMutexReadLock lLock(*this);
 
   if (!mUUIDView.count(uuid)) {
     return ENOENT;
   }
 
-  lLock.Release();
   std::string id = mUUIDView[uuid];
+  bool batch = SupportsBatch(id);
+  lLock.Release();
   eos_static_info("msg=\"sending md update\" uuid=%s clientid=%s id=%lx",
                   uuid.c_str(), clientid.c_str(), md_ino);
-  gOFS->zMQ->mTask->reply(id, rspstream);
+  // a newer record of the same inode replaces a queued one
+  Send(id, batch, rsp, "m:" + std::to_string(md_ino) + ":" + clientid);
   EXEC_TIMING_END("Eosxd::int::SendMD");
   return 0;
 }
@@ -911,19 +979,18 @@ FuseServer::Clients::SendCAP(FuseServer::Caps::shared_cap cap)
   rsp.set_type(rsp.CAP);
   *(rsp.mutable_cap_()) = *cap;
   const std::string& uuid = cap->clientuuid();
-  std::string rspstream;
-  rsp.SerializeToString(&rspstream);
   eos::common::RWMutexReadLock lLock(*this);
 
   if (!mUUIDView.count(uuid)) {
     return ENOENT;
   }
 
-  const std::string& clientid = mUUIDView[uuid];
+  std::string clientid = mUUIDView[uuid];
+  bool batch = SupportsBatch(clientid);
   lLock.Release();
   eos_static_info("msg=\"sending cap update\" uuid=%s clientid=%s cap-id=%lx",
                   uuid.c_str(), clientid.c_str(), cap->id());
-  gOFS->zMQ->mTask->reply(clientid, rspstream);
+  Send(clientid, batch, rsp, "c:" + cap->authid());
   EXEC_TIMING_END("Eosxd::int::SendCAP");
   return 0;
 }
@@ -1003,6 +1070,9 @@ FuseServer::Clients::SetHeartbeatInterval(int interval)
       cfg.set_writesizeflush(true);
       cfg.set_appname(true);
       cfg.set_mdquery(true);
+      cfg.set_mdsince(true);
+      cfg.set_mdbatch(true);
+      cfg.set_locknotify(true);
       cfg.set_serverversion(std::string(VERSION) + std::string("::") + std::string(
                               RELEASE));
       BroadcastConfig(id, cfg);
@@ -1065,5 +1135,186 @@ FuseServer::Clients::BroadcastDropAllCaps(const std::string& identity,
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Check if a client understands batch frames
+//------------------------------------------------------------------------------
+bool
+FuseServer::Clients::SupportsBatch(const std::string& id)
+{
+  auto it = mMap.find(id);
+
+  if (it == mMap.end()) {
+    return false;
+  }
+
+  return (it->second.heartbeat().protversion() >=
+          eos::fusex::heartbeat::PROTOCOLV5);
+}
+
+//------------------------------------------------------------------------------
+// Send or queue an event for a client
+//------------------------------------------------------------------------------
+void
+FuseServer::Clients::Send(const std::string& id, bool batch,
+                          const eos::fusex::response& rsp, const std::string& key)
+{
+  if (batch && BroadcastWindowMs()) {
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    OutQueue& queue = mQueues[id];
+
+    if (key.length()) {
+      auto it = queue.mIndex.find(key);
+
+      if (it != queue.mIndex.end()) {
+        // the newer event replaces the queued one, keep the order of events
+        // by appending it
+        queue.mEvents[it->second].Clear();
+        queue.mEvents[it->second].set_type(eos::fusex::response::NONE);
+        queue.mCoalesced++;
+        gOFS->MgmStats.Add("Eosxd::int::Coalesced", 0, 0, 1);
+      }
+
+      queue.mIndex[key] = queue.mEvents.size();
+    }
+
+    queue.mEvents.push_back(rsp);
+    return;
+  }
+
+  std::string rspstream;
+  rsp.SerializeToString(&rspstream);
+  gOFS->zMQ->mTask->reply(id, rspstream);
+}
+
+//------------------------------------------------------------------------------
+// Send the queued events of all clients
+//------------------------------------------------------------------------------
+void
+FuseServer::Clients::FlushQueues()
+{
+  std::map<std::string, std::vector<eos::fusex::response>> out;
+  {
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+
+    for (auto it = mQueues.begin(); it != mQueues.end(); ++it) {
+      if (it->second.mEvents.size()) {
+        out[it->first].swap(it->second.mEvents);
+        it->second.mIndex.clear();
+      }
+    }
+  }
+  std::map<std::string, uint64_t> frames;
+
+  for (auto it = out.begin(); it != out.end(); ++it) {
+    eos::fusex::response frame;
+    frame.set_type(eos::fusex::response::BATCH);
+
+    for (size_t i = 0; i <= it->second.size(); ++i) {
+      if (i < it->second.size()) {
+        if (it->second[i].type() == eos::fusex::response::NONE) {
+          // replaced by a newer event
+          continue;
+        }
+
+        frame.add_batch()->Swap(&it->second[i]);
+
+        if (frame.batch_size() < kMaxBatchEvents) {
+          continue;
+        }
+      }
+
+      if (!frame.batch_size()) {
+        break;
+      }
+
+      std::string rspstream;
+
+      if (frame.batch_size() == 1) {
+        // a single event is sent as it is
+        frame.batch(0).SerializeToString(&rspstream);
+      } else {
+        frame.SerializeToString(&rspstream);
+        frames[it->first]++;
+        gOFS->MgmStats.Add("Eosxd::int::SendBatch", 0, 0, 1);
+      }
+
+      gOFS->zMQ->mTask->reply(it->first, rspstream);
+      frame.clear_batch();
+    }
+  }
+
+  if (frames.size()) {
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+
+    for (auto it = frames.begin(); it != frames.end(); ++it) {
+      mQueues[it->first].mFrames += it->second;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Flush the outbound queues every broadcast window
+//------------------------------------------------------------------------------
+void
+FuseServer::Clients::MonitorQueues()
+{
+  int window = BroadcastWindowMs();
+
+  if (!window) {
+    eos_static_info("msg=\"fusex broadcast coalescing disabled\"");
+    return;
+  }
+
+  eos_static_info("msg=\"starting fusex broadcast queue thread\" window=%dms",
+                  window);
+  size_t cnt = 0;
+
+  while (!should_terminate()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(window));
+    FlushQueues();
+
+    if (!(++cnt % (10000 / window + 1))) {
+      // remove the queues of clients which are gone
+      std::set<std::string> ids;
+      {
+        eos::common::RWMutexReadLock lLock(*this);
+
+        for (auto it = mMap.begin(); it != mMap.end(); ++it) {
+          ids.insert(it->first);
+        }
+      }
+      std::lock_guard<std::mutex> lock(mQueueMutex);
+
+      for (auto it = mQueues.begin(); it != mQueues.end();) {
+        if (!ids.count(it->first)) {
+          it = mQueues.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+  }
+
+  FlushQueues();
+}
+
+//------------------------------------------------------------------------------
+// Get the outbound queue statistics of a client
+//------------------------------------------------------------------------------
+void
+FuseServer::Clients::QueueStats(const std::string& id, size_t& depth,
+                                uint64_t& coalesced, uint64_t& frames)
+{
+  std::lock_guard<std::mutex> lock(mQueueMutex);
+  auto it = mQueues.find(id);
+  depth = coalesced = frames = 0;
+
+  if (it != mQueues.end()) {
+    depth = it->second.mEvents.size();
+    coalesced = it->second.mCoalesced;
+    frames = it->second.mFrames;
+  }
+}
+
 
 EOSMGMNAMESPACE_END
@@ -26,6 +26,8 @@
 
 #include <thread>
 #include <map>
+#include <mutex>
+#include <vector>
 
 #include "mgm/Namespace.hh"
 #include "mgm/FuseServer/Caps.hh"
@@ -185,6 +187,9 @@ EOSFUSESERVERNAMESPACE_BEGIN
                      const std::string& uuid,
                      const std::string& clientid);
 
+    // notify a client waiting for a lock on an inode to retry
+    int NotifyLockRelease(uint64_t id, const std::string& uuid);
+
     // send MD after update
     int SendMD(const eos::fusex::md& md,
                const std::string& uuid,
@@ -229,7 +234,34 @@ EOSFUSESERVERNAMESPACE_BEGIN
     // to defer an operation based on client versions
     bool DeferClient(std::string clienversion, std::string minimum_allowed_version);
 
+    // send an event to a client, events of clients supporting batches are
+    // queued and events with the same key replace older ones in the queue
+    void Send(const std::string& id, bool batch,
+              const eos::fusex::response& rsp, const std::string& key);
+
+    // send the queued events of all clients packed into batch frames
+    void FlushQueues();
+
+    // thread flushing the outbound queues every broadcast window
+    void MonitorQueues();
+
+    // get the outbound queue statistics of a client
+    void QueueStats(const std::string& id, size_t& depth, uint64_t& coalesced,
+                    uint64_t& frames);
+
   private:
+    // outbound event queue of a client
+    struct OutQueue {
+      OutQueue() : mCoalesced(0), mFrames(0) {}
+      std::vector<eos::fusex::response> mEvents; // queued events in order
+      std::map<std::string, size_t> mIndex; // coalescing key to event position
+      uint64_t mCoalesced; // events replaced by a newer one
+      uint64_t mFrames; // batch frames sent
+    };
+
+    // check if a client understands batch frames - needs a read lock
+    bool SupportsBatch(const std::string& id);
+
     // lookup client full id to heart beat
     client_map_t mMap;
     // lookup client uuid to full id
@@ -249,6 +281,10 @@ EOSFUSESERVERNAMESPACE_BEGIN
     int mQuotaCheckInterval;
 
     std::atomic<bool> terminate_;
+
+    // outbound queues by client full id
+    std::mutex mQueueMutex;
+    std::map<std::string, OutQueue> mQueues;
   };
 
 
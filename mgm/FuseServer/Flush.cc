@@ -22,7 +22,8 @@
  ************************************************************************/
 
 #include <string>
-#include <thread>
+#include <algorithm>
+#include <chrono>
 
 #include "mgm/FuseServer/Flush.hh"
 #include "common/Logging.hh"
@@ -32,6 +33,16 @@
 EOSMGMNAMESPACE_BEGIN
 
 
+constexpr size_t FuseServer::Flush::kShards;
+constexpr size_t FuseServer::Flush::kWheelSlots;
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+FuseServer::Flush::Flush() : wheeltime(time(NULL))
+{
+}
+
 //------------------------------------------------------------------------------
 //
 //------------------------------------------------------------------------------
@@ -39,9 +50,23 @@ void
 FuseServer::Flush::beginFlush(uint64_t id, std::string client)
 {
   eos_static_info("ino=%016x client=%s", id, client.c_str());
-  XrdSysMutexHelper lock(this);
+  shard_t& shard = getShard(id);
   flush_info_t finfo(client);
-  flushmap[id][client].Add(finfo);
+  {
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto& clients = shard.flushmap[id];
+
+    if (clients.empty()) {
+      shard.ninodes++;
+    }
+
+    clients[client].Add(finfo);
+  }
+  // schedule the expiry, an entry found in its slot after a later begin
+  // is scheduled again
+  std::lock_guard<std::mutex> lock(wheelmtx);
+  time_t due = std::max(finfo.ftime.tv_sec, wheeltime);
+  wheel[due % kWheelSlots].emplace_back(id, client);
 }
 
 //------------------------------------------------------------------------------
@@ -51,44 +76,64 @@ void
 FuseServer::Flush::endFlush(uint64_t id, std::string client)
 {
   eos_static_info("ino=%016x client=%s", id, client.c_str());
-  XrdSysMutexHelper lock(this);
+  shard_t& shard = getShard(id);
+  std::lock_guard<std::mutex> lock(shard.mtx);
   flush_info_t finfo(client);
+  auto it = shard.flushmap.find(id);
+
+  if (it == shard.flushmap.end()) {
+    return;
+  }
 
-  if (flushmap[id][client].Remove(finfo)) {
-    flushmap[id].erase(client);
+  auto fit = it->second.find(client);
 
-    if (!flushmap[id].size()) {
-      flushmap.erase(id);
-    }
+  if ((fit == it->second.end()) || fit->second.Remove(finfo)) {
+    eraseFlush(shard, it, client);
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+void
+FuseServer::Flush::eraseFlush(shard_t& shard, flushmap_t::iterator it,
+                              const std::string& client)
+{
+  it->second.erase(client);
+
+  if (it->second.empty()) {
+    shard.flushmap.erase(it);
+    shard.ninodes--;
   }
+
+  shard.cond.notify_all();
 }
 
 //------------------------------------------------------------------------------
 //
 //------------------------------------------------------------------------------
 bool
-FuseServer::Flush::hasFlush(uint64_t id)
+FuseServer::Flush::hasFlush(uint64_t id, int timeout_ms)
 {
-  // this function takes maximum 255ms and waits for a flush to be removed
-  // this function might block a client connection/thread for the given time
-  bool has = false;
-  size_t delay = 1;
-
-  for (size_t i = 0 ; i < 8; ++i) {
-    {
-      XrdSysMutexHelper lock(this);
-      has = validateFlush(id);
-    }
+  // this function waits at most timeout_ms for a flush to be removed, it
+  // might block a client connection/thread for the given time
+  shard_t& shard = getShard(id);
 
-    if (!has) {
-      return false;
-    }
+  if (!shard.ninodes) {
+    return false;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(timeout_ms);
+  std::unique_lock<std::mutex> lock(shard.mtx);
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(delay));
-    delay *= 2;
+  while (validateFlush(shard, id)) {
+    if (shard.cond.wait_until(lock, deadline) == std::cv_status::timeout) {
+      return validateFlush(shard, id);
+    }
   }
 
-  return true;
+  return false;
 }
 
 //------------------------------------------------------------------------------
@@ -97,24 +142,43 @@ FuseServer::Flush::hasFlush(uint64_t id)
 bool
 FuseServer::Flush::validateFlush(uint64_t id)
 {
-  bool has = false;
-
-  if (flushmap.count(id)) {
-    for (auto it = flushmap[id].begin(); it != flushmap[id].end();) {
-      if (eos::common::Timing::GetAgeInNs(&it->second.ftime) < 0) {
-        has = true;
-        ++it;
-      } else {
-        it = flushmap[id].erase(it);
-      }
-    }
+  shard_t& shard = getShard(id);
+  std::lock_guard<std::mutex> lock(shard.mtx);
+  return validateFlush(shard, id);
+}
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+bool
+FuseServer::Flush::validateFlush(shard_t& shard, uint64_t id)
+{
+  auto it = shard.flushmap.find(id);
+
+  if (it == shard.flushmap.end()) {
+    return false;
+  }
+
+  std::vector<std::string> expired;
 
-    if (!flushmap[id].size()) {
-      flushmap.erase(id);
+  for (auto fit = it->second.begin(); fit != it->second.end(); ++fit) {
+    if (eos::common::Timing::GetAgeInNs(&fit->second.ftime) >= 0) {
+      expired.push_back(fit->first);
     }
   }
 
-  return has;
+  if (expired.size() == it->second.size()) {
+    shard.flushmap.erase(it);
+    shard.ninodes--;
+    shard.cond.notify_all();
+    return false;
+  }
+
+  for (const auto& client : expired) {
+    it->second.erase(client);
+  }
+
+  return true;
 }
 
 //------------------------------------------------------------------------------
@@ -123,21 +187,53 @@ FuseServer::Flush::validateFlush(uint64_t id)
 void
 FuseServer::Flush::expireFlush()
 {
-  XrdSysMutexHelper lock(this);
-
-  for (auto it = flushmap.begin(); it != flushmap.end();) {
-    for (auto fit = it->second.begin(); fit != it->second.end();) {
-      if (eos::common::Timing::GetAgeInNs(&fit->second.ftime) < 0) {
-        ++fit;
-      } else {
-        fit = it->second.erase(fit);
-      }
+  time_t now = time(NULL);
+  std::vector<std::pair<uint64_t, std::string>> due;
+  {
+    std::lock_guard<std::mutex> lock(wheelmtx);
+
+    // a late call catches up with at most one turn of the wheel
+    if (now - wheeltime >= (time_t) kWheelSlots) {
+      wheeltime = now - kWheelSlots + 1;
+    }
+
+    for (; wheeltime <= now; ++wheeltime) {
+      auto& slot = wheel[wheeltime % kWheelSlots];
+      due.insert(due.end(), slot.begin(), slot.end());
+      slot.clear();
+    }
+  }
+  std::vector<std::pair<time_t, std::pair<uint64_t, std::string>>> later;
+
+  for (const auto& entry : due) {
+    shard_t& shard = getShard(entry.first);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.flushmap.find(entry.first);
+
+    if (it == shard.flushmap.end()) {
+      continue;
+    }
+
+    auto fit = it->second.find(entry.second);
+
+    if (fit == it->second.end()) {
+      continue;
     }
 
-    if (!it->second.size()) {
-      it = flushmap.erase(it);
+    if (eos::common::Timing::GetAgeInNs(&fit->second.ftime) < 0) {
+      // begun again since it was scheduled
+      later.emplace_back(fit->second.ftime.tv_sec, entry);
     } else {
-      ++it;
+      eraseFlush(shard, it, entry.second);
+    }
+  }
+
+  if (later.size()) {
+    std::lock_guard<std::mutex> lock(wheelmtx);
+
+    for (const auto& entry : later) {
+      time_t slot = std::max(entry.first, wheeltime);
+      wheel[slot % kWheelSlots].push_back(entry.second);
     }
   }
 }
@@ -148,18 +244,21 @@ FuseServer::Flush::expireFlush()
 void
 FuseServer::Flush::Print(std::string& out)
 {
-  XrdSysMutexHelper lock(this);
-
-  for (auto it = flushmap.begin(); it != flushmap.end(); ++it) {
-    for (auto fit = it->second.begin(); fit != it->second.end(); ++fit) {
-      long long valid = eos::common::Timing::GetAgeInNs(&fit->second.ftime);
-      char formatline[4096];
-      snprintf(formatline, sizeof(formatline),
-               "flush : ino : %016lx client : %-8s valid=%.02f sec\n",
-               it->first,
-               fit->first.c_str(),
-               1.0 * valid / 1000000000.0);
-      out += formatline;
+  for (size_t i = 0; i < kShards; ++i) {
+    std::lock_guard<std::mutex> lock(shards[i].mtx);
+    const flushmap_t& flushmap = shards[i].flushmap;
+
+    for (auto it = flushmap.begin(); it != flushmap.end(); ++it) {
+      for (auto fit = it->second.begin(); fit != it->second.end(); ++fit) {
+        long long valid = eos::common::Timing::GetAgeInNs(&fit->second.ftime);
+        char formatline[4096];
+        snprintf(formatline, sizeof(formatline),
+                 "flush : ino : %016lx client : %-8s valid=%.02f sec\n",
+                 it->first,
+                 fit->first.c_str(),
+                 1.0 * valid / 1000000000.0);
+        out += formatline;
+      }
     }
   }
 }
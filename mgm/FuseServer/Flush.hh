@@ -24,6 +24,10 @@
 #pragma once
 
 #include <map>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
 
 #include "mgm/Namespace.hh"
 #include "common/Timing.hh"
@@ -36,16 +40,28 @@ EOSFUSESERVERNAMESPACE_BEGIN
 
   //----------------------------------------------------------------------------
   //! Class Flush
+  //!
+  //! The flushes are spread over kShards tables by inode, each with its own
+  //! mutex and condition, so that stat and open calls checking an inode don't
+  //! serialize on one mutex. A table counts its flushing inodes atomically,
+  //! the common case of an inode without flush is answered without locking.
+  //! Callers of hasFlush block on the condition of the table until the flush
+  //! ends or the timeout expires instead of polling. Flushes which are never
+  //! ended expire cFlushWindow seconds after their last begin from a timer
+  //! wheel of one-second slots, expireFlush only looks at the slots which
+  //! came due instead of all entries.
   //----------------------------------------------------------------------------
 
-  class Flush : XrdSysMutex
+  class Flush
   {
     // essentially a map containing clients which currently flush a file
   public:
 
     static constexpr int cFlushWindow = 60;
+    static constexpr size_t kShards = 64;
+    static constexpr size_t kWheelSlots = 64; // > cFlushWindow
 
-    Flush() = default;
+    Flush();
 
     virtual ~Flush() = default;
 
@@ -53,7 +69,8 @@ EOSFUSESERVERNAMESPACE_BEGIN
 
     void endFlush(uint64_t id, std::string client);
 
-    bool hasFlush(uint64_t id);
+    // wait at most timeout_ms for the flushes of an inode to end
+    bool hasFlush(uint64_t id, int timeout_ms = 255);
 
     bool validateFlush(uint64_t id);
 
@@ -101,7 +118,32 @@ EOSFUSESERVERNAMESPACE_BEGIN
       ssize_t nref;
     } flush_info_t;
 
-    std::map<uint64_t, std::map<std::string, flush_info_t> > flushmap;
+    typedef std::map<uint64_t, std::map<std::string, flush_info_t> > flushmap_t;
+
+    struct shard_t {
+      std::mutex mtx;
+      std::condition_variable cond; // signalled when a flush ends or expires
+      std::atomic<size_t> ninodes {0}; // inodes with flushes
+      flushmap_t flushmap;
+    };
+
+    shard_t& getShard(uint64_t id)
+    {
+      return shards[id % kShards];
+    }
+
+    // drop the expired flushes of an inode, needs the shard mutex
+    bool validateFlush(shard_t& shard, uint64_t id);
+
+    // erase a flush entry, needs the shard mutex
+    void eraseFlush(shard_t& shard, flushmap_t::iterator it,
+                    const std::string& client);
+
+    shard_t shards[kShards];
+
+    std::mutex wheelmtx; // never taken together with a shard mutex
+    time_t wheeltime; // next second to expire
+    std::vector<std::pair<uint64_t, std::string>> wheel[kWheelSlots];
   };
 
 
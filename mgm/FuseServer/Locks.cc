@@ -27,24 +27,29 @@
 #include "mgm/FuseServer/Locks.hh"
 #include "common/Logging.hh"
 #include "mgm/fuse-locks/LockTracker.hh"
+#include "mgm/XrdMgmOfs.hh"
+#include "mgm/ZMQ.hh"
 
 EOSMGMNAMESPACE_BEGIN
 
 
+constexpr size_t FuseServer::Lock::kShards;
+
 //------------------------------------------------------------------------------
 //
 //------------------------------------------------------------------------------
 FuseServer::Lock::shared_locktracker
 FuseServer::Lock::getLocks(uint64_t id)
 {
-  XrdSysMutexHelper lock(this);
+  shard_t& shard = getShard(id);
+  XrdSysMutexHelper lock(shard);
+  shared_locktracker& tracker = shard.lockmap[id];
 
-  // make sure you have this object locked
-  if (!lockmap.count(id)) {
-    lockmap[id] = std::make_shared<LockTracker>();
+  if (!tracker) {
+    tracker = std::make_shared<LockTracker>();
   }
 
-  return lockmap[id];
+  return tracker;
 }
 
 //------------------------------------------------------------------------------
@@ -53,18 +58,26 @@ FuseServer::Lock::getLocks(uint64_t id)
 void
 FuseServer::Lock::purgeLocks()
 {
-  XrdSysMutexHelper lock(this);
-  std::set<uint64_t>purgeset;
+  for (size_t i = 0; i < kShards; ++i) {
+    purgeLocks(shards[i]);
+  }
+}
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+void
+FuseServer::Lock::purgeLocks(shard_t& shard)
+{
+  XrdSysMutexHelper lock(shard);
 
-  for (auto it = lockmap.begin(); it != lockmap.end(); ++it) {
+  for (auto it = shard.lockmap.begin(); it != shard.lockmap.end();) {
     if (!it->second->inuse()) {
-      purgeset.insert(it->first);
+      it = shard.lockmap.erase(it);
+    } else {
+      ++it;
     }
   }
-
-  for (auto it = purgeset.begin(); it != purgeset.end(); ++it) {
-    lockmap.erase(*it);
-  }
 }
 
 //------------------------------------------------------------------------------
@@ -76,17 +89,21 @@ FuseServer::Lock::dropLocks(uint64_t id, pid_t pid)
   eos_static_info("id=%llu pid=%u", id, pid);
   // drop locks for a given inode/pid pair
   int retc = 0;
+  lockwaiters_t wakeup;
+  shard_t& shard = getShard(id);
   {
-    XrdSysMutexHelper lock(this);
+    XrdSysMutexHelper lock(shard);
+    auto it = shard.lockmap.find(id);
 
-    if (lockmap.count(id)) {
-      lockmap[id]->removelk(pid);
+    if (it != shard.lockmap.end()) {
+      it->second->removelk(pid, &wakeup[id]);
       retc = 0;
     } else {
       retc = ENOENT;
     }
   }
-  purgeLocks();
+  purgeLocks(shard);
+  notifyWaiters(wakeup);
   return retc;
 }
 
@@ -94,7 +111,7 @@ FuseServer::Lock::dropLocks(uint64_t id, pid_t pid)
 //
 //------------------------------------------------------------------------------
 int
-FuseServer::Lock::dropLocks(const std::string& owner)
+FuseServer::Lock::dropLocks(const std::string& owner, lockwaiters_t* wakeup)
 {
   if (EOS_LOGS_DEBUG) {
     eos_static_debug("owner=%s", owner.c_str());
@@ -102,14 +119,33 @@ FuseServer::Lock::dropLocks(const std::string& owner)
 
   // drop locks for a given owner
   int retc = 0;
-  {
-    XrdSysMutexHelper lock(this);
+  lockwaiters_t waiters;
+
+  for (size_t i = 0; i < kShards; ++i) {
+    {
+      XrdSysMutexHelper lock(shards[i]);
 
-    for (auto it = lockmap.begin(); it != lockmap.end(); ++it) {
-      it->second->removelk(owner);
+      for (auto it = shards[i].lockmap.begin(); it != shards[i].lockmap.end();
+           ++it) {
+        std::set<std::string> owners;
+        it->second->removelk(owner, &owners);
+
+        if (owners.size()) {
+          waiters[it->first].insert(owners.begin(), owners.end());
+        }
+      }
     }
+    purgeLocks(shards[i]);
   }
-  purgeLocks();
+
+  if (wakeup) {
+    for (auto& it : waiters) {
+      (*wakeup)[it.first].insert(it.second.begin(), it.second.end());
+    }
+  } else {
+    notifyWaiters(waiters);
+  }
+
   return retc;
 }
 
@@ -122,17 +158,33 @@ FuseServer::Lock::lsLocks(const std::string& owner,
                           std::map<uint64_t, std::set < pid_t >>& wlocks)
 {
   int retc = 0;
-  {
-    XrdSysMutexHelper lock(this);
 
-    for (auto it = lockmap.begin(); it != lockmap.end(); ++it) {
+  for (size_t i = 0; i < kShards; ++i) {
+    XrdSysMutexHelper lock(shards[i]);
+
+    for (auto it = shards[i].lockmap.begin(); it != shards[i].lockmap.end();
+         ++it) {
       std::set<pid_t> rlk = it->second->getrlks(owner);
       std::set<pid_t> wlk = it->second->getwlks(owner);
       rlocks[it->first].insert(rlk.begin(), rlk.end());
       wlocks[it->first].insert(wlk.begin(), wlk.end());
     }
   }
+
   return retc;
 }
 
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+void
+FuseServer::Lock::notifyWaiters(const lockwaiters_t& wakeup)
+{
+  for (auto it = wakeup.begin(); it != wakeup.end(); ++it) {
+    for (auto owner = it->second.begin(); owner != it->second.end(); ++owner) {
+      gOFS->zMQ->gFuseServer.Client().NotifyLockRelease(it->first, *owner);
+    }
+  }
+}
+
 EOSMGMNAMESPACE_END
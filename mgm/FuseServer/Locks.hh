@@ -33,12 +33,17 @@ EOSFUSESERVERNAMESPACE_BEGIN
 
 //----------------------------------------------------------------------------
 //! Class Lock
+//!
+//! The lock trackers of the inodes are spread over kShards tables with their
+//! own mutex, so that lock calls on different inodes don't serialize.
 //----------------------------------------------------------------------------
 
-class Lock : XrdSysMutex
+class Lock
 {
 public:
 
+  static constexpr size_t kShards = 64;
+
   Lock() = default;
 
   virtual ~Lock() = default;
@@ -47,19 +52,39 @@ public:
 
   typedef std::map<uint64_t, shared_locktracker > lockmap_t;
 
+  // waiting owners to notify per inode
+  typedef std::map<uint64_t, std::set<std::string>> lockwaiters_t;
+
   shared_locktracker getLocks(uint64_t id);
 
   void purgeLocks();
 
   int dropLocks(uint64_t id, pid_t pid);
 
-  int dropLocks(const std::string& owner);
+  // if wakeup is given the waiters to notify are returned instead of being
+  // notified, for callers holding the client table lock
+  int dropLocks(const std::string& owner, lockwaiters_t* wakeup = nullptr);
 
   int lsLocks(const std::string& owner,
               std::map<uint64_t, std::set<pid_t>>&rlocks,
               std::map<uint64_t, std::set<pid_t>>&wlocks);
+
+  // tell the waiting owners over the client channel to retry their lock
+  static void notifyWaiters(const lockwaiters_t& wakeup);
+
 private:
-  lockmap_t lockmap;
+  struct shard_t : XrdSysMutex {
+    lockmap_t lockmap;
+  };
+
+  shard_t& getShard(uint64_t id)
+  {
+    return shards[id % kShards];
+  }
+
+  void purgeLocks(shard_t& shard);
+
+  shard_t shards[kShards];
 };
 
 
@@ -25,6 +25,7 @@
 #include <cstdlib>
 #include <thread>
 #include <regex>
+#include <future>
 
 #include <google/protobuf/util/json_util.h>
 
@@ -64,6 +65,10 @@ USE_EOSFUSESERVERNAMESPACE
 
         const char* Server::cident = "fxserver";
 
+constexpr size_t Server::cLsFrameSize;
+constexpr size_t Server::cLsParallel;
+constexpr size_t Server::cLsThreads;
+
 
 //------------------------------------------------------------------------------
 // Constructor
@@ -95,6 +100,9 @@ Server::start()
   std::thread monitorthread(&FuseServer::Clients::MonitorHeartBeat,
                             &(this->mClients));
   monitorthread.detach();
+  std::thread queuethread(&FuseServer::Clients::MonitorQueues,
+                          &(this->mClients));
+  queuethread.detach();
   std::thread capthread(&Server::MonitorCaps, this);
   capthread.detach();
 }
@@ -1086,6 +1094,46 @@ Server::OpEndFlush(const std::string& id,
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Fill the meta-data of a range of listing children
+//------------------------------------------------------------------------------
+
+void
+Server::FillChildrenMD(const eos::fusex::md& md,
+                       const std::vector<std::pair<std::string, uint64_t>>&
+                       children,
+                       std::vector<eos::fusex::md>& child_mds,
+                       size_t begin, size_t end,
+                       eos::common::Mapping::VirtualIdentity vid)
+{
+  size_t items_per_lock_cycle = 128;
+  eos::common::RWMutexReadLock rd_ns_lock(gOFS->eosViewRWMutex);
+
+  for (size_t i = begin; i < end; ++i) {
+    uint64_t ino = children[i].second;
+    eos::fusex::md& child_md = child_mds[i];
+    child_md.set_md_ino(ino);
+
+    if (!((i - begin + 1) % items_per_lock_cycle)) {
+      // after <n> entries release the lock and grab again
+      rd_ns_lock.Release();
+      rd_ns_lock.Grab(gOFS->eosViewRWMutex);
+    }
+
+    if (eos::common::FileId::IsFileInode(ino)) {
+      // this is a file
+      FillFileMD(ino, child_md, vid);
+    } else {
+      // we don't fill the LS information for the children, just the MD
+      child_md.set_operation(md.GET);
+      child_md.set_clientuuid(md.clientuuid());
+      child_md.set_clientid(md.clientid());
+      FillContainerMD(ino, child_md, vid);
+      child_md.clear_operation();
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 // Server a meta-data GET or LS operation
 //------------------------------------------------------------------------------
@@ -1125,14 +1173,35 @@ Server::OpGetLs(const std::string& id,
       gOFS->MgmStats.Add("Eosxd::ext::GET", vid.uid, vid.gid, 1);
     }
 
-    size_t n_attached = 1;
     int retc = 0;
+    size_t frame_size = 0;
+    // send the frame built so far in cont and start a new one for the same
+    // directory, the client applies the containers of a response in order
+    auto send_frame = [&]() {
+      std::string rspstream;
+      cont.SerializeToString(&rspstream);
+
+      if (!response) {
+        gOFS->zMQ->mTask->reply(id, rspstream);
+      } else {
+        *response += Header(rspstream);
+        response->append(rspstream.c_str(), rspstream.size());
+      }
+
+      cont.Clear();
+      cont.set_type(cont.MDMAP);
+      cont.set_ref_inode_(md.md_ino());
+      mdmap = cont.mutable_md_map_();
+      parent = mdmap->mutable_md_map_();
+      frame_size = 0;
+    };
 
     // retrieve directory meta data
     if (!(retc = FillContainerMD(md.md_ino(), (*parent)[md.md_ino()], vid))) {
       // refresh the cap with the same authid
       FillContainerCAP(md.md_ino(), (*parent)[md.md_ino()], vid,
                        md.authid());
+      (*parent)[md.md_ino()].clear_operation();
 
       // store clock
       if (clock) {
@@ -1141,64 +1210,74 @@ Server::OpGetLs(const std::string& id,
 
       if (md.operation() == md.LS) {
         // attach children
-        auto map = (*parent)[md.md_ino()].children();
-        auto it = map.begin();
-        size_t n_caps = 0;
-        size_t items_per_lock_cycle = 128;
-        size_t items_cycled = 1;
-
-        for (; it != map.end(); ++it) {
-          // this is a map by inode
-          (*parent)[it->second].set_md_ino(it->second);
-          auto child_md = &((*parent)[it->second]);
-          items_cycled++;
-
-          if (!(items_cycled % items_per_lock_cycle)) {
-            // after <n> entries release the lock and grab again
-            rd_ns_lock.Release();
-            rd_ns_lock.Grab(gOFS->eosViewRWMutex);
+        const auto& map = (*parent)[md.md_ino()].children();
+        std::vector<std::pair<std::string, uint64_t>> children(map.begin(),
+            map.end());
+        std::vector<eos::fusex::md> child_mds(children.size());
+        size_t n_threads = (children.size() >= cLsParallel) ? cLsThreads : 1;
+        frame_size = (*parent)[md.md_ino()].ByteSize();
+        // the fill threads take the namespace lock on their own
+        rd_ns_lock.Release();
+
+        if (n_threads == 1) {
+          FillChildrenMD(md, children, child_mds, 0, children.size(), vid);
+        } else {
+          std::vector<std::future<void>> fills;
+          size_t chunk = (children.size() + n_threads - 1) / n_threads;
+
+          for (size_t begin = 0; begin < children.size(); begin += chunk) {
+            size_t end = std::min(begin + chunk, children.size());
+            fills.push_back(std::async(std::launch::async,
+                                       &Server::FillChildrenMD, this,
+                                       std::cref(md), std::cref(children),
+                                       std::ref(child_mds), begin, end, vid));
           }
 
-          if (eos::common::FileId::IsFileInode(it->second)) {
-            // this is a file
-            FillFileMD(it->second, *child_md, vid);
-          } else {
-            // we don't fill the LS information for the children, just the MD
-            child_md->set_operation(md.GET);
-            child_md->set_clientuuid(md.clientuuid());
-            child_md->set_clientid(md.clientid());
-            FillContainerMD(it->second, *child_md, vid);
-
-            if (n_caps < 16) {
-              // skip hidden directories
-              if (it->first.substr(0, 1) == ".") {
-                // add maximum 16 caps for a listing
-                FillContainerCAP(it->second, *child_md, vid, "", true);
-                n_caps++;
-              }
+          for (auto& fill : fills) {
+            fill.get();
+          }
+        }
+
+        size_t n_caps = 0;
+        size_t n_unchanged = 0;
+        rd_ns_lock.Grab(gOFS->eosViewRWMutex);
+
+        for (size_t i = 0; i < children.size(); ++i) {
+          eos::fusex::md& child_md = child_mds[i];
+
+          if (!eos::common::FileId::IsFileInode(children[i].second) &&
+              (n_caps < 16)) {
+            // skip hidden directories
+            if (children[i].first.substr(0, 1) == ".") {
+              // add maximum 16 caps for a listing
+              FillContainerCAP(children[i].second, child_md, vid, "", true);
+              n_caps++;
             }
+          }
 
-            child_md->clear_operation();
+          if (md.clock() && child_md.clock() &&
+              (child_md.clock() <= md.clock()) && !child_md.has_capability()) {
+            // the client asked for the children changed since the given clock
+            n_unchanged++;
+            continue;
+          }
+
+          size_t child_size = child_md.ByteSize();
+
+          if (frame_size && (frame_size + child_size > cLsFrameSize)) {
+            // large listings go out in several frames
+            send_frame();
           }
+
+          (*parent)[children[i].second].Swap(&child_md);
+          frame_size += child_size;
         }
 
         rd_ns_lock.Release();
-        n_attached++;
-
-        if (n_attached >= 128) {
-          std::string rspstream;
-          cont.SerializeToString(&rspstream);
-
-          if (!response) {
-            // send parent + first 128 children
-            gOFS->zMQ->mTask->reply(id, rspstream);
-          } else {
-            *response += Header(rspstream);
-            response->append(rspstream.c_str(), rspstream.size());
-          }
 
-          n_attached = 0;
-          cont.Clear();
+        if (n_unchanged) {
+          gOFS->MgmStats.Add("Eosxd::ext::LS-Unchanged", vid.uid, vid.gid,
+                             n_unchanged);
         }
       }
 
@@ -1212,19 +1291,9 @@ Server::OpGetLs(const std::string& id,
       return retc;
     }
 
-    (*parent)[md.md_ino()].clear_operation();
-
-    if (n_attached) {
-      // send left-over children
-      std::string rspstream;
-      cont.SerializeToString(&rspstream);
-
-      if (!response) {
-        gOFS->zMQ->mTask->reply(id, rspstream);
-      } else {
-        *response += Header(rspstream);
-        response->append(rspstream.c_str(), rspstream.size());
-      }
+    if (!parent->empty()) {
+      // send the left-over children
+      send_frame();
     }
 
     EXEC_TIMING_END((md.operation() == md.LS) ? "Eosxd::ext::LS" :
@@ -1322,7 +1391,49 @@ Server::OpSet(const std::string& id,
   return EINVAL;
 }
 
+//------------------------------------------------------------------------------
+// Serve a batch of meta-data SET operations, the records are applied in order
+// and every record is answered by its own response in a BATCH response
+//------------------------------------------------------------------------------
 
+int
+Server::OpSetMany(const std::string& id,
+                  const eos::fusex::md& md,
+                  eos::common::Mapping::VirtualIdentity& vid,
+                  std::string* response,
+                  uint64_t * clock)
+{
+  gOFS->MgmStats.Add("Eosxd::ext::SETMANY", vid.uid, vid.gid, 1);
+  EXEC_TIMING_BEGIN("Eosxd::ext::SETMANY");
+  eos::fusex::response resp;
+  resp.set_type(resp.BATCH);
+
+  for (int i = 0; i < md.batch_size(); ++i) {
+    const eos::fusex::md& rec = md.batch(i);
+    eos::fusex::response* rrsp = resp.add_batch();
+    int rc = EINVAL;
+    std::string rrspstream;
+
+    if (rec.operation() == rec.SET) {
+      rc = OpSet(id, rec, vid, &rrspstream, clock);
+    }
+
+    if (rc) {
+      rrsp->set_type(rrsp->ACK);
+      rrsp->mutable_ack_()->set_code(rrsp->ack_().PERMANENT_FAILURE);
+      rrsp->mutable_ack_()->set_err_no(rc);
+      rrsp->mutable_ack_()->set_err_msg("batched set failed");
+      rrsp->mutable_ack_()->set_transactionid(rec.reqid());
+    } else if (rrspstream.empty() || !rrsp->ParseFromString(rrspstream)) {
+      rrsp->Clear();
+      rrsp->set_type(rrsp->NONE);
+    }
+  }
+
+  resp.SerializeToString(response);
+  EXEC_TIMING_END("Eosxd::ext::SETMANY");
+  return 0;
+}
 
 //------------------------------------------------------------------------------
 // Server a meta-data SET operation
@@ -2544,7 +2655,32 @@ Server::OpGetLock(const std::string& id,
   eos::fusex::response resp;
   resp.set_type(resp.LOCK);
   struct flock lock;
+  // the range and type the client asks about
+  lock.l_start = md.flock().start();
+  lock.l_len = md.flock().len() ? (off_t) md.flock().len() : -1;
+  lock.l_pid = md.flock().pid();
+
+  switch (md.flock().type()) {
+  case eos::fusex::lock::RDLCK:
+    lock.l_type = F_RDLCK;
+    break;
+
+  case eos::fusex::lock::WRLCK:
+    lock.l_type = F_WRLCK;
+    break;
+
+  default:
+    lock.l_type = F_UNLCK;
+    break;
+  }
+
   Locks().getLocks(md.md_ino())->getlk((pid_t) md.flock().pid(), &lock);
+
+  if (lock.l_len == -1) {
+    // the infinite lock is 0 for the client
+    lock.l_len = 0;
+  }
+
   resp.mutable_lock_()->set_len(lock.l_len);
   resp.mutable_lock_()->set_start(lock.l_start);
   resp.mutable_lock_()->set_pid(lock.l_pid);
@@ -2638,8 +2774,11 @@ Server::OpSetLock(const std::string& id,
            lock.l_pid,
            lock.l_type);
 
+  Lock::lockwaiters_t wakeup;
+
   if (Locks().getLocks(md.md_ino())->setlk(md.flock().pid(), &lock, sleep,
-                                           md.clientuuid())) {
+                                           md.clientuuid(),
+                                           &wakeup[md.md_ino()])) {
     // lock ok!
     resp.mutable_lock_()->set_err_no(0);
   } else {
@@ -2648,6 +2787,8 @@ Server::OpSetLock(const std::string& id,
     resp.mutable_lock_()->set_err_no(EAGAIN);
   }
 
+  // wake up the waiters on a released range instead of having them poll
+  Lock::notifyWaiters(wakeup);
   resp.SerializeToString(response);
   EXEC_TIMING_END((md.operation() == md.SETLKW) ? "Eosxd::ext::SETLKW" :
                   "Eosxd::ext::SETLK");
@@ -2688,6 +2829,8 @@ Server::HandleMD(const std::string& id,
     ops = "BEGINFLUSH";
   } else if (op_type == md.ENDFLUSH) {
     ops = "ENDFLUSH";
+  } else if (op_type == md.SETMANY) {
+    ops = "SETMANY";
   } else {
     ops = "UNKNOWN";
   }
@@ -2721,6 +2864,9 @@ Server::HandleMD(const std::string& id,
   case md.SET:
     return OpSet(id, md, vid, response, clock);
 
+  case md.SETMANY:
+    return OpSetMany(id, md, vid, response, clock);
+
   case md.DELETE:
     return OpDelete(id, md, vid, response, clock);
 
@@ -28,6 +28,8 @@
 
 #include <map>
 #include <atomic>
+#include <string>
+#include <vector>
 
 #include "mgm/fusex.pb.h"
 #include "mgm/fuse-locks/LockTracker.hh"
@@ -123,6 +125,12 @@ public:
             std::string* response = 0,
             uint64_t* clock = 0);
 
+  int OpSetMany(const std::string& identity,
+                const eos::fusex::md& md,
+                eos::common::Mapping::VirtualIdentity& vid,
+                std::string* response = 0,
+                uint64_t* clock = 0);
+
   int OpSetLink(const std::string& identity,
                 const eos::fusex::md& md,
                 eos::common::Mapping::VirtualIdentity& vid,
@@ -210,6 +218,12 @@ public:
 
   static const char* cident;
 
+  //! listing response size above which the children go out in more frames
+  static constexpr size_t cLsFrameSize = 1024 * 1024;
+  //! number of children from which a listing is filled by cLsThreads threads
+  static constexpr size_t cLsParallel = 4096;
+  static constexpr size_t cLsThreads = 4;
+
 protected:
   Clients mClients;
   Caps mCaps;
@@ -227,6 +241,24 @@ private:
   //----------------------------------------------------------------------------
   void replaceNonSysAttributes(const std::shared_ptr<eos::IFileMD>& fmd,
                                const eos::fusex::md& md);
+
+  //----------------------------------------------------------------------------
+  //! Fill the meta-data of a range of listing children, taking the namespace
+  //! read lock in cycles of 128 entries
+  //!
+  //! @param md listing request
+  //! @param children name and inode of all the children
+  //! @param child_mds meta-data of all the children, the range is filled
+  //! @param begin first child of the range
+  //! @param end end of the range
+  //! @param vid identity of the client
+  //----------------------------------------------------------------------------
+  void FillChildrenMD(const eos::fusex::md& md,
+                      const std::vector<std::pair<std::string, uint64_t>>&
+                      children,
+                      std::vector<eos::fusex::md>& child_mds,
+                      size_t begin, size_t end,
+                      eos::common::Mapping::VirtualIdentity vid);
 };
 
 
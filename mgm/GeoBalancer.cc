@@ -34,6 +34,7 @@
 #include "XrdSys/XrdSysError.hh"
 #include "XrdOuc/XrdOucTrace.hh"
 #include "Xrd/XrdScheduler.hh"
+#include <algorithm>
 #include <random>
 #include <cmath>
 
@@ -48,7 +49,8 @@ EOSMGMNAMESPACE_BEGIN
 /*----------------------------------------------------------------------------*/
 GeoBalancer::GeoBalancer(const char* spacename)
   : mThreshold(.5),
-    mAvgUsedSize(0)
+    mAvgUsedSize(0),
+    mMinFileSize(0)
     /*----------------------------------------------------------------------------*/
     /**
      * @brief Constructor by space name
@@ -423,11 +425,13 @@ GeoBalancer::scheduleTransfer(eos::common::FileId::fileid_t fid,
 
 /*----------------------------------------------------------------------------*/
 eos::common::FileId::fileid_t
-GeoBalancer::chooseFidFromGeotag(const std::string& geotag)
+GeoBalancer::chooseFidFromGeotag(const std::string& geotag, uint64_t max_size)
 /*----------------------------------------------------------------------------*/
 /**
- * @brief Chooses a random file ID from a random filesystem in the given geotag
+ * @brief Chooses the biggest file fitting the size limits from a random
+ *        filesystem in the given geotag
  * @param geotag the location's name from which the file id will be chosen
+ * @param max_size max size of the file, 0 for no limit
  * @return the chosen file ID
  */
 /*----------------------------------------------------------------------------*/
@@ -436,43 +440,44 @@ GeoBalancer::chooseFidFromGeotag(const std::string& geotag)
   bool found = false;
   uint64_t fsid_size = 0ull;
   eos::common::FileSystem::fsid_t fsid = 0;
-  eos::common::RWMutexReadLock vlock(FsView::gFsView.ViewMutex);
-  eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
-  std::vector<eos::common::FileSystem::fsid_t>& validFs = mGeotagFs[geotag];
-  // TODO(gbitzes): Add prefetching here.
-
-  while (validFs.size() > 0) {
-    rndIndex = getRandom(validFs.size() - 1);
-    fsid = validFs[rndIndex];
-    fsid_size = gOFS->eosFsView->getNumFilesOnFs(fsid);
-
-    if (fsid_size) {
-      found = true;
-      break;
-    }
+  {
+    eos::common::RWMutexReadLock vlock(FsView::gFsView.ViewMutex);
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+    std::vector<eos::common::FileSystem::fsid_t>& validFs = mGeotagFs[geotag];
 
-    validFs.erase(validFs.begin() + rndIndex);
-  }
+    while (validFs.size() > 0) {
+      rndIndex = getRandom(validFs.size() - 1);
+      fsid = validFs[rndIndex];
+      fsid_size = gOFS->eosFsView->getNumFilesOnFs(fsid);
 
-  if (validFs.size() == 0) {
-    mGeotagFs.erase(geotag);
-    mGeotagSizes.erase(geotag);
-    fillGeotagsByAvg();
+      if (fsid_size) {
+        found = true;
+        break;
+      }
+
+      validFs.erase(validFs.begin() + rndIndex);
+    }
+
+    if (validFs.size() == 0) {
+      mGeotagFs.erase(geotag);
+      mGeotagSizes.erase(geotag);
+      fillGeotagsByAvg();
+    }
   }
 
   if (!found) {
     return -1;
   }
 
-  int attempts = 10;
-
-  while (attempts-- > 0) {
-    eos::IFileMD::id_t randomPick;
+  auto is_scheduled = [this](uint64_t fid) {
+    return (mTransfers.count(fid) != 0);
+  };
+  uint64_t fid = 0;
 
-    if (gOFS->eosFsView->getApproximatelyRandomFileInFs(fsid, randomPick) &&
-        mTransfers.count(randomPick) == 0) {
-      return randomPick;
-    }
+  // Sample the next page of the file list of the filesystem and take the
+  // biggest sampled file so that every transfer moves as many bytes as possible
+  if (mSizeIndex.Choose(fsid, mMinFileSize, max_size, is_scheduled, fid)) {
+    return fid;
   }
 
   return -1;
@@ -498,9 +503,16 @@ GeoBalancer::prepareTransfer()
     int rndIndex = getRandom(mGeotagsOverAvg.size() - 1);
     std::vector<std::string>::const_iterator over_it = mGeotagsOverAvg.cbegin();
     std::advance(over_it, rndIndex);
-    // TODO: this loop should be improved not to request the file list too
-    // many times in a tight loop
-    eos::common::FileId::fileid_t fid = chooseFidFromGeotag(*over_it);
+    // Don't move more than the geotag has over the average
+    uint64_t max_size = 0;
+
+    if (mGeotagSizes.count(*over_it)) {
+      GeotagSize* size = mGeotagSizes[*over_it];
+      max_size = (uint64_t) std::max(1.0, (size->filled() - mAvgUsedSize) *
+                                     size->capacity());
+    }
+
+    eos::common::FileId::fileid_t fid = chooseFidFromGeotag(*over_it, max_size);
 
     if ((int) fid == -1) {
       eos_static_debug("Couldn't choose any FID to schedule: failedgeotag=%s",
@@ -595,10 +607,18 @@ GeoBalancer::GeoBalance(ThreadAssistant& assistant) noexcept
       }
 
       isSpaceGeoBalancer = space->GetConfigMember("geobalancer") == "on";
+
+      // The balance planner takes over the balancing of the space
+      if (space->GetConfigMember("planner") == "on") {
+        isSpaceGeoBalancer = false;
+      }
+
       nrTransfers = atoi(space->GetConfigMember("geobalancer.ntx").c_str());
       mThreshold =
         atof(space->GetConfigMember("geobalancer.threshold").c_str());
       mThreshold /= 100.0;
+      std::string minsize = space->GetConfigMember("geobalancer.file.minsize");
+      mMinFileSize = strtoull(minsize.c_str(), 0, 10);
       FsView::gFsView.ViewMutex.UnLockRead();
     }
     isMaster = gOFS->mMaster->IsMaster();
@@ -31,6 +31,7 @@
 
 /* -------------------------------------------------------------------------- */
 #include "mgm/Namespace.hh"
+#include "mgm/FsSizeIndex.hh"
 #include "common/Logging.hh"
 #include "common/FileId.hh"
 #include "common/FileSystem.hh"
@@ -131,10 +132,16 @@ private:
   /// transfers scheduled (maps files' ids with their path in proc)
   std::map<eos::common::FileId::fileid_t, std::string> mTransfers;
 
+  /// size bucketed samples of the files of the filesystems
+  FsSizeIndex mSizeIndex;
+  /// min size of the files to move
+  uint64_t mMinFileSize;
+
   std::string getFileProcTransferNameAndSize(eos::common::FileId::fileid_t fid,
       uint64_t* size);
 
-  eos::common::FileId::fileid_t chooseFidFromGeotag(const std::string& geotag);
+  eos::common::FileId::fileid_t chooseFidFromGeotag(const std::string& geotag,
+      uint64_t max_size);
 
   void populateGeotagsInfo(void);
 
@@ -208,18 +208,10 @@ bool GeoTreeEngine::insertFsIntoGroup(FileSystem* fs ,
 #ifdef EOS_GEOTREEENGINE_USE_INSTRUMENTED_MUTEX
 #ifdef EOS_INSTRUMENTED_RWMUTEX
       char buffer[64], buffer2[64];
-      sprintf(buffer, "GTE %s doublebuffer", group->mName.c_str());
-      sprintf(buffer2, "%s doublebuffer", group->mName.c_str());
-      mapEntry->doubleBufferMutex.SetDebugName(buffer2);
-      int retcode = eos::common::RWMutex::AddOrderRule(buffer,
-                    std::vector<eos::common::RWMutex*>(
-      { &pAddRmFsMutex, &pTreeMapMutex, &mapEntry->doubleBufferMutex}));
-      eos_info("creating RWMutex rule order %p, retcode is %d",
-               &mapEntry->doubleBufferMutex, retcode);
       sprintf(buffer, "GTE %s slowtree", group->mName.c_str());
       sprintf(buffer2, "%s slowtree", group->mName.c_str());
       mapEntry->slowTreeMutex.SetDebugName(buffer2);
-      retcode = eos::common::RWMutex::AddOrderRule(buffer,
+      int retcode = eos::common::RWMutex::AddOrderRule(buffer,
                 std::vector<eos::common::RWMutex*>(
       { &pAddRmFsMutex, &pTreeMapMutex, &mapEntry->slowTreeMutex}));
       eos_info("creating RWMutex rule order %p, retcode is %d",
@@ -415,6 +407,7 @@ bool GeoTreeEngine::insertFsIntoGroup(FileSystem* fs ,
               ss.str().c_str());
   }
 
+  pFsStatusGeneration++;
   return true;
 }
 
@@ -542,6 +535,7 @@ bool GeoTreeEngine::removeFsFromGroup(FileSystem* fs, FsGroup* group,
     mapEntry->slowTreeMutex.UnLockWrite();
     pTreeMapMutex.UnLockWrite();
   }
+  pFsStatusGeneration++;
   return true;
 }
 
@@ -887,28 +881,28 @@ void GeoTreeEngine::printInfo(std::string& info, bool dispTree, bool dispSnaps,
       if (optype.empty() || (optype == "plct")) {
         ostr << "### scheduling snapshot for scheduling group " <<
              it->second->group->mName << " and operation \'Placement\' :" << std::endl;
-        it->second->foregroundFastStruct->placementTree->recursiveDisplay(ostr,
+        it->second->getForegroundSnapshot()->placementTree->recursiveDisplay(ostr,
             useColors) << endl;
       }
 
       if (optype.empty() || (optype == "accsro")) {
         ostr << "### scheduling snapshot for scheduling group " <<
              it->second->group->mName << " and operation \'Access RO\' :" << std::endl;
-        it->second->foregroundFastStruct->rOAccessTree->recursiveDisplay(ostr,
+        it->second->getForegroundSnapshot()->rOAccessTree->recursiveDisplay(ostr,
             useColors) << endl;
       }
 
       if (optype.empty() || (optype == "accsrw")) {
         ostr << "### scheduling snapshot for scheduling group " <<
              it->second->group->mName << " and operation \'Access RW\' :" << std::endl;
-        it->second->foregroundFastStruct->rWAccessTree->recursiveDisplay(ostr,
+        it->second->getForegroundSnapshot()->rWAccessTree->recursiveDisplay(ostr,
             useColors) << endl;
       }
 
       if (optype.empty() || (optype == "accsdrain")) {
         ostr << "### scheduling snapshot for scheduling group " <<
              it->second->group->mName << " and operation \'Draining Access\' :" << std::endl;
-        it->second->foregroundFastStruct->drnAccessTree->recursiveDisplay(ostr,
+        it->second->getForegroundSnapshot()->drnAccessTree->recursiveDisplay(ostr,
             useColors) << endl;
       }
 
@@ -916,7 +910,7 @@ void GeoTreeEngine::printInfo(std::string& info, bool dispTree, bool dispSnaps,
         ostr << "### scheduling snapshot for scheduling group " <<
              it->second->group->mName << " and operation \'Draining Placement\' :" <<
              std::endl;
-        it->second->foregroundFastStruct->drnPlacementTree->recursiveDisplay(ostr,
+        it->second->getForegroundSnapshot()->drnPlacementTree->recursiveDisplay(ostr,
             useColors) << endl;
       }
 
@@ -924,7 +918,7 @@ void GeoTreeEngine::printInfo(std::string& info, bool dispTree, bool dispSnaps,
         ostr << "### scheduling snapshot for scheduling group " <<
              it->second->group->mName << " and operation \'Balancing Access\' :" <<
              std::endl;
-        it->second->foregroundFastStruct->blcAccessTree->recursiveDisplay(ostr,
+        it->second->getForegroundSnapshot()->blcAccessTree->recursiveDisplay(ostr,
             useColors) << endl;
       }
 
@@ -932,7 +926,7 @@ void GeoTreeEngine::printInfo(std::string& info, bool dispTree, bool dispSnaps,
         ostr << "### scheduling snapshot for scheduling group " <<
              it->second->group->mName << " and operation \'Balancing Placement\' :" <<
              std::endl;
-        it->second->foregroundFastStruct->blcPlacementTree->recursiveDisplay(ostr,
+        it->second->getForegroundSnapshot()->blcPlacementTree->recursiveDisplay(ostr,
             useColors) << endl;
       }
     }
@@ -956,7 +950,7 @@ void GeoTreeEngine::printInfo(std::string& info, bool dispTree, bool dispSnaps,
                       (schedgroup == it->first))) {
       ostr << "### scheduling snapshot for proxy group " << it->first << " :" <<
            std::endl;
-      it->second->foregroundFastStruct->proxyAccessTree->recursiveDisplay(ostr,
+      it->second->getForegroundSnapshot()->proxyAccessTree->recursiveDisplay(ostr,
           useColors) << endl;
     }
 
@@ -1011,7 +1005,6 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 {
   assert(nNewReplicas);
   assert(newReplicas);
-  std::vector<SchedTME*> entries;
   // find the entry in the map
   tlCurrentGroup = group;
   SchedTME* entry;
@@ -1026,8 +1019,87 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
     entry = pGroup2SchedTME[group];
     AtomicInc(entry->fastStructLockWaitersCount);
   }
-  // readlock the original fast structure
-  entry->doubleBufferMutex.LockRead();
+  // pin the current snapshot of the fast structures
+  std::shared_ptr<FastStructSched> snapshot = entry->getForegroundSnapshot();
+  bool success = placeNewReplicasPinned(entry, snapshot.get(), nNewReplicas,
+                                        newReplicas, inode, dataProxys,
+                                        firewallEntryPoint, type,
+                                        existingReplicas, fsidsgeotags,
+                                        bookingSize, startFromGeoTag,
+                                        clientGeoTag, nCollocatedReplicas,
+                                        excludeFs, excludeGeoTags,
+                                        forceGeoTags);
+  AtomicDec(entry->fastStructLockWaitersCount);
+  return success;
+}
+
+size_t
+GeoTreeEngine::placeNewReplicasOneGroupBatch(FsGroup* group,
+    const size_t& nNewReplicas,
+    std::vector<BatchPlacement>& requests,
+    size_t first, size_t count,
+    SchedType type,
+    unsigned long long bookingSize,
+    const std::string& startFromGeoTag,
+    const std::string& clientGeoTag,
+    const size_t& nCollocatedReplicas)
+{
+  assert(nNewReplicas);
+  // find the entry in the map only once for all the files
+  tlCurrentGroup = group;
+  SchedTME* entry;
+  {
+    RWMutexReadLock lock(this->pTreeMapMutex);
+
+    if (!pGroup2SchedTME.count(group)) {
+      eos_err("could not find the requested placement group in the map");
+      return 0;
+    }
+
+    entry = pGroup2SchedTME[group];
+    AtomicInc(entry->fastStructLockWaitersCount);
+  }
+  // all the files are placed on the same snapshot, the penalties applied after
+  // each placement are seen by the next one so the files are still spread
+  std::shared_ptr<FastStructSched> snapshot = entry->getForegroundSnapshot();
+  size_t placed = 0;
+  size_t last = std::min(first + count, requests.size());
+
+  for (size_t i = first; i < last; ++i, ++placed) {
+    BatchPlacement& req = requests[i];
+    assert(req.newReplicas);
+
+    if (!placeNewReplicasPinned(entry, snapshot.get(), nNewReplicas,
+                                req.newReplicas, req.inode, req.dataProxys,
+                                req.firewallEntryPoint, type, NULL, NULL,
+                                bookingSize, startFromGeoTag, clientGeoTag,
+                                nCollocatedReplicas, NULL, NULL, NULL)) {
+      break;
+    }
+  }
+
+  AtomicDec(entry->fastStructLockWaitersCount);
+  return placed;
+}
+
+bool
+GeoTreeEngine::placeNewReplicasPinned(SchedTME* entry,
+                                      FastStructSched* fgStruct,
+                                      const size_t& nNewReplicas, vector<FileSystem::fsid_t>* newReplicas,
+                                      ino64_t inode, std::vector<std::string>* dataProxys,
+                                      std::vector<std::string>* firewallEntryPoint,
+                                      SchedType type,
+                                      vector<FileSystem::fsid_t>* existingReplicas,
+                                      std::vector<std::string>* fsidsgeotags,
+                                      unsigned long long bookingSize,
+                                      const std::string& startFromGeoTag,
+                                      const std::string& clientGeoTag,
+                                      const size_t& nCollocatedReplicas,
+                                      vector<FileSystem::fsid_t>* excludeFs,
+                                      vector<string>* excludeGeoTags,
+                                      vector<string>* forceGeoTags)
+{
+  std::vector<FastStructSched*> fgStructs;
   // locate the existing replicas and the excluded fs in the tree
   vector<SchedTreeBase::tFastTreeIdx> newReplicasIdx(nNewReplicas),
          *existingReplicasIdx = NULL, *excludeFsIdx = NULL, *forceBrIdx = NULL;
@@ -1044,7 +1116,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
       const SchedTreeBase::tFastTreeIdx* idx =
         static_cast<const SchedTreeBase::tFastTreeIdx*>(0);
 
-      if (!entry->foregroundFastStruct->fs2TreeIdx->get(*it, idx) &&
+      if (!fgStruct->fs2TreeIdx->get(*it, idx) &&
           !(*fsidsgeotags)[count].empty()) {
         // the fs is not in that group.
         // this could happen because the former file scheduler
@@ -1052,11 +1124,11 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
         // with the new geoscheduler, it should not happen
         // in that case, we try to match a filesystem having the same geotag
         SchedTreeBase::tFastTreeIdx idx =
-          entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode((
+          fgStruct->tag2NodeIdx->getClosestFastTreeNode((
                 *fsidsgeotags)[count].c_str());
 
         if (idx &&
-            (*entry->foregroundFastStruct->treeInfo)[idx].nodeType ==
+            (*fgStruct->treeInfo)[idx].nodeType ==
             SchedTreeBase::TreeNodeInfo::fs) {
           if ((std::find(existingReplicasIdx->begin(), existingReplicasIdx->end(),
                          idx) == existingReplicasIdx->end())) {
@@ -1085,7 +1157,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
     for (auto it = excludeFs->begin(); it != excludeFs->end(); ++it) {
       const SchedTreeBase::tFastTreeIdx* idx;
 
-      if (!entry->foregroundFastStruct->fs2TreeIdx->get(*it, idx)) {
+      if (!fgStruct->fs2TreeIdx->get(*it, idx)) {
         // the excluded fs might belong to another group
         // so it's not an error condition
         // eos_warning("could not place excluded fs on the fast tree");
@@ -1104,7 +1176,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
     for (auto it = excludeGeoTags->begin(); it != excludeGeoTags->end(); ++it) {
       SchedTreeBase::tFastTreeIdx idx;
-      idx = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+      idx = fgStruct->tag2NodeIdx->getClosestFastTreeNode(
               it->c_str());
       excludeFsIdx->push_back(idx);
     }
@@ -1115,7 +1187,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
     for (auto it = forceGeoTags->begin(); it != forceGeoTags->end(); ++it) {
       SchedTreeBase::tFastTreeIdx idx;
-      idx = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+      idx = fgStruct->tag2NodeIdx->getClosestFastTreeNode(
               it->c_str());
       forceBrIdx->push_back(idx);
     }
@@ -1125,11 +1197,11 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
   if (!startFromGeoTag.empty()) {
     startFromNode =
-      entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+      fgStruct->tag2NodeIdx->getClosestFastTreeNode(
         startFromGeoTag.c_str());
   } else if (!clientGeoTag.empty()) {
     startFromNode =
-      entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+      fgStruct->tag2NodeIdx->getClosestFastTreeNode(
         clientGeoTag.c_str());
   }
 
@@ -1140,7 +1212,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
   case regularRO:
   case regularRW:
     success = placeNewReplicas(entry, nNewReplicas, &newReplicasIdx,
-                               entry->foregroundFastStruct->placementTree,
+                               fgStruct->placementTree,
                                existingReplicasIdx, bookingSize, startFromNode,
                                nCollocatedReplicas, excludeFsIdx, forceBrIdx,
                                pSkipSaturatedPlct);
@@ -1148,7 +1220,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
   case draining:
     success = placeNewReplicas(entry, nNewReplicas, &newReplicasIdx,
-                               entry->foregroundFastStruct->drnPlacementTree,
+                               fgStruct->drnPlacementTree,
                                existingReplicasIdx, bookingSize, startFromNode,
                                nCollocatedReplicas, excludeFsIdx, forceBrIdx,
                                pSkipSaturatedDrnPlct);
@@ -1156,7 +1228,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
   case balancing:
     success = placeNewReplicas(entry, nNewReplicas, &newReplicasIdx,
-                               entry->foregroundFastStruct->blcPlacementTree,
+                               fgStruct->blcPlacementTree,
                                existingReplicasIdx, bookingSize, startFromNode,
                                nCollocatedReplicas, excludeFsIdx, forceBrIdx,
                                pSkipSaturatedBlcPlct);
@@ -1176,9 +1248,9 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
   for (auto it = newReplicasIdx.begin(); it != newReplicasIdx.end(); ++it) {
     const SchedTreeBase::tFastTreeIdx* idx = NULL;
-    const unsigned int fsid = (*entry->foregroundFastStruct->treeInfo)[*it].fsId;
+    const unsigned int fsid = (*fgStruct->treeInfo)[*it].fsId;
 
-    if (!entry->foregroundFastStruct->fs2TreeIdx->get(fsid, idx)) {
+    if (!fgStruct->fs2TreeIdx->get(fsid, idx)) {
       eos_crit("inconsistency : cannot retrieve index of selected fs though "
                "it should be in the tree");
       success = false;
@@ -1186,30 +1258,30 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
     }
 
     const char netSpeedClass =
-      (*entry->foregroundFastStruct->treeInfo)[*idx].netSpeedClass;
+      (*fgStruct->treeInfo)[*idx].netSpeedClass;
     newReplicas->push_back(fsid);
 
     // Apply the penalties
-    if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.dlScore >
+    if (fgStruct->placementTree->pNodes[*idx].fsData.dlScore >
         0) {
-      applyDlScorePenalty(entry, *idx,
+      applyDlScorePenalty(fgStruct, *idx,
                           pPenaltySched.pPlctDlScorePenalty[netSpeedClass]);
     }
 
-    if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.ulScore >
+    if (fgStruct->placementTree->pNodes[*idx].fsData.ulScore >
         0) {
-      applyUlScorePenalty(entry, *idx,
+      applyUlScorePenalty(fgStruct, *idx,
                           pPenaltySched.pPlctUlScorePenalty[netSpeedClass]);
     }
   }
 
   if (dataProxys || firewallEntryPoint) {
-    entries.assign(newReplicasIdx.size(), entry);
+    fgStructs.assign(newReplicasIdx.size(), fgStruct);
   }
 
   // find proxy for filesticky scheduling
   if (dataProxys) {
-    if (!findProxy(newReplicasIdx, entries, inode, dataProxys, NULL,
+    if (!findProxy(newReplicasIdx, fgStructs, inode, dataProxys, NULL,
                    pProxyCloseToFs ? "" : clientGeoTag, filesticky)) {
       success = false;
       goto cleanup;
@@ -1225,10 +1297,10 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
       for (size_t i = 0; i < newReplicasIdx.size(); i++) {
         if (clientGeoTag.empty() ||
             accessReqFwEP((
-                            *entries[i]->foregroundFastStruct->treeInfo)[newReplicasIdx[i]].fullGeotag ,
+                            *fgStructs[i]->treeInfo)[newReplicasIdx[i]].fullGeotag ,
                           clientGeoTag)) {
           firewallProxyGroups[i] = accessGetProxygroup((
-                                     *entries[i]->foregroundFastStruct->treeInfo)[newReplicasIdx[i]].fullGeotag);
+                                     *fgStructs[i]->treeInfo)[newReplicasIdx[i]].fullGeotag);
         }
       }
 
@@ -1237,7 +1309,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
       *firewallEntryPoint = *dataProxys;
     }
 
-    if (!findProxy(newReplicasIdx, entries, inode, firewallEntryPoint,
+    if (!findProxy(newReplicasIdx, fgStructs, inode, firewallEntryPoint,
                    &firewallProxyGroups, pProxyCloseToFs ? "" : clientGeoTag, any)) {
       success = false;
       goto cleanup;
@@ -1253,23 +1325,20 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
       *dataProxys = *firewallEntryPoint;
     }
 
-    if (!findProxy(newReplicasIdx, entries, inode, dataProxys, NULL,
+    if (!findProxy(newReplicasIdx, fgStructs, inode, dataProxys, NULL,
                    pProxyCloseToFs ? "" : clientGeoTag, regular)) {
       success = false;
       goto cleanup;
     }
   }
 
-  // Unlock, cleanup
+  // cleanup
 cleanup:
 
   if (!success) {
     newReplicas->clear();
   }
 
-  entry->doubleBufferMutex.UnLockRead();
-  AtomicDec(entry->fastStructLockWaitersCount);
-
   if (existingReplicasIdx) {
     delete existingReplicasIdx;
   }
@@ -1302,7 +1371,7 @@ struct TreeInfoFsIdComparator {
 
 bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
                               fsIdxs,
-                              std::vector<SchedTME*> entries,
+                              const std::vector<FastStructSched*>& fgStructs,
                               ino64_t inode,
                               std::vector<std::string>* dataProxys,
                               std::vector<std::string>* proxyGroups,
@@ -1313,13 +1382,14 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
   dataProxys->resize(fsIdxs.size());
   const std::string* fsproxygroup = 0;
   DataProxyTME* pxyentry = NULL;
+  std::shared_ptr<FastStructProxy> pxySnapshot;
   FastGatewayAccessTree* tree = NULL;
   std::string sgeotag;
 
   for (size_t i = 0; i < fsIdxs.size(); i++) {
     const std::string* geotag = NULL;
     // get the proxygroup
-    // WARNING: entries[i]->doubleBufferMutex should be locked by the caller of findProxy
+    // WARNING: fgStructs[i] should be pinned by the caller of findProxy
 
     if (!(*dataProxys)[i].empty() && (*dataProxys)[i] != "<none>") {
       if (pPxyHost2DpTMEs.count((*dataProxys)[i])) {
@@ -1344,10 +1414,9 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
         {
           auto entry = (*TMEs.begin());
 
-          // we don't want to lock the pxyentry which is already locked
+          // we don't want to pin the pxyentry which is already pinned
           if (entry != pxyentry) {
             AtomicInc(entry->fastStructLockWaitersCount);
-            entry->doubleBufferMutex.LockRead();
           }
 
           // if they don't, take their geotag as a staring point
@@ -1356,7 +1425,6 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
           geotag = &sgeotag;
 
           if (entry != pxyentry) {
-            entry->doubleBufferMutex.UnLockRead();
             AtomicDec(entry->fastStructLockWaitersCount);
           }
         }
@@ -1367,7 +1435,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       fsproxygroup = &((*proxyGroups)[i]);
     } else {
       fsproxygroup = &
-                     (*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].proxygroup;
+                     (*fgStructs[i]->treeInfo)[fsIdxs[i]].proxygroup;
     }
 
     if (fsproxygroup->empty() ||
@@ -1383,7 +1451,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
 
     if (!geotag) {
       geotag = (clientgeotag.empty() ? &
-                ((*(entries[i]->foregroundFastStruct->treeInfo))[fsIdxs[i]].fullGeotag) :
+                ((*(fgStructs[i]->treeInfo))[fsIdxs[i]].fullGeotag) :
                 &clientgeotag);
     }
 
@@ -1401,15 +1469,14 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
 
     pxyentry = pPxyGrp2DpTME[*fsproxygroup];
     AtomicInc(pxyentry->fastStructLockWaitersCount);
-    // readlock the original fast structure
-    pxyentry->doubleBufferMutex.LockRead();
+    // pin the current snapshot of the fast structure
+    pxySnapshot = pxyentry->getForegroundSnapshot();
 
     // copy the fasttree
-    if (pxyentry->foregroundFastStruct->proxyAccessTree->copyToBuffer((
+    if (pxySnapshot->proxyAccessTree->copyToBuffer((
           char*)tlGeoBuffer, gGeoBufferSize)) {
       eos_crit("could not make a working copy of the fast tree for proxygroup %s",
                fsproxygroup->c_str());
-      pxyentry->doubleBufferMutex.UnLockRead();
       AtomicDec(pxyentry->fastStructLockWaitersCount);
       return false;
     }
@@ -1417,7 +1484,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
     tree = (FastGatewayAccessTree*)tlGeoBuffer;
     // get the closest node from the filesystem
     SchedTreeBase::tFastTreeIdx idx;
-    idx = pxyentry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+    idx = pxySnapshot->tag2NodeIdx->getClosestFastTreeNode(
             trimlastlevel ? std::string(*geotag, 0,
                                         geotag->rfind("::")).c_str() : geotag->c_str());
     bool schedsuccess = false;
@@ -1427,7 +1494,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       // scheduling should consistently go through the same (firewallentrypoint,proxy)
       // this is to do the caching of the file only on one proxy
       // serving a same file from two proxies is not optimal but it is not mendatory neither
-      if ((*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
+      if ((*fgStructs[i]->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
           < 0) {
         schedsuccess = true;
       }
@@ -1435,9 +1502,9 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       else {
         // then consider all the possible proxy in the same proxygroup
         // within the subtree starting at the best proxy and going uproot by
-        // (*pxyentry->foregroundFastStruct->treeInfo)[idx].fileStickyProxyDepth
+        // (*pxySnapshot->treeInfo)[idx].fileStickyProxyDepth
         // allocate a vectors to get the proxies
-        auto s = pxyentry->foregroundFastStruct->treeInfo->size();
+        auto s = pxySnapshot->treeInfo->size();
         std::vector<SchedTreeBase::tFastTreeIdx> proxiesIdxs(s), upRootLevels(s),
             upRootLevelsIdxs(s);
         SchedTreeBase::tFastTreeIdx upRootLevelsCount = 0;
@@ -1455,8 +1522,8 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
               ss << " all proxys are:";
 
               for (auto it = proxiesIdxs.begin(); it != proxiesIdxs.end(); it++) {
-                ss << (*pxyentry->foregroundFastStruct->treeInfo)[*it].hostport;
-                ss << "(" << (*pxyentry->foregroundFastStruct->treeInfo)[*it].fullGeotag << ")";
+                ss << (*pxySnapshot->treeInfo)[*it].hostport;
+                ss << "(" << (*pxySnapshot->treeInfo)[*it].fullGeotag << ")";
 
                 if (it != proxiesIdxs.end() - 1) {
                   ss << ",";
@@ -1493,7 +1560,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
             while (
               uprlev < upRootLevelsCount &&
               upRootLevels[uprlev] <=
-              (*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
+              (*fgStructs[i]->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
             ) {
               uprlev++;
             }
@@ -1511,24 +1578,24 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
               }
 
               // sort the proxies by fsid
-              TreeInfoFsIdComparator cmp(pxyentry->foregroundFastStruct->treeInfo);
+              TreeInfoFsIdComparator cmp(pxySnapshot->treeInfo);
               std::sort(proxiesIdxs.begin(), proxiesIdxs.end(), cmp);
               // take the proxy
               idx = proxiesIdxs[inode % proxiesIdxs.size()];
               // if it succeeds, feel the corresponding element of the return vector
-              (*dataProxys)[i] = (*pxyentry->foregroundFastStruct->treeInfo)[idx].hostport;
+              (*dataProxys)[i] = (*pxySnapshot->treeInfo)[idx].hostport;
 
               if (g_logging.gLogMask & LOG_MASK(LOG_DEBUG)) {
                 stringstream ss;
                 ss << "file sticky proxy scheduling fs:" <<
-                   (*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fsId;
+                   (*fgStructs[i]->treeInfo)[fsIdxs[i]].fsId;
                 ss << " | fileStickyProxyDepth:" << (int)(
-                     *entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fileStickyProxyDepth;
+                     *fgStructs[i]->treeInfo)[fsIdxs[i]].fileStickyProxyDepth;
                 ss << " | possible proxys are:";
 
                 for (auto it = proxiesIdxs.begin(); it != proxiesIdxs.end(); it++) {
-                  ss << (*pxyentry->foregroundFastStruct->treeInfo)[*it].hostport;
-                  ss << "(" << (*pxyentry->foregroundFastStruct->treeInfo)[*it].fullGeotag << ")";
+                  ss << (*pxySnapshot->treeInfo)[*it].hostport;
+                  ss << "(" << (*pxySnapshot->treeInfo)[*it].fullGeotag << ")";
 
                   if (it != proxiesIdxs.end() - 1) {
                     ss << ",";
@@ -1537,7 +1604,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
 
                 ss << " | inode:" << inode;
                 ss << " | selected host is:" <<
-                   (*pxyentry->foregroundFastStruct->treeInfo)[idx].hostport;
+                   (*pxySnapshot->treeInfo)[idx].hostport;
                 eos_debug("%s", ss.str().c_str());
               }
             }
@@ -1546,18 +1613,18 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       }
     } else {
       if (proxyschedtype == any
-          || ((*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
+          || ((*fgStructs[i]->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
               < 0 && proxyschedtype == regular)) {
         // get the proxy
         if (!(schedsuccess = tree->findFreeSlot(idx, idx,
                                                 true /*allow uproot if necessary*/, false, true /*skipSaturated*/))) {
-          (*dataProxys)[i] = (*pxyentry->foregroundFastStruct->treeInfo)[idx].hostport;
+          (*dataProxys)[i] = (*pxySnapshot->treeInfo)[idx].hostport;
         } else {
           if ((schedsuccess = tree->findFreeSlot(idx, idx,
                                                  true /*allow uproot if necessary*/, false, false /*skipSaturated*/)))
             // if it succeeds, feel the corresponding element of the return vector
           {
-            (*dataProxys)[i] = (*pxyentry->foregroundFastStruct->treeInfo)[idx].hostport;
+            (*dataProxys)[i] = (*pxySnapshot->treeInfo)[idx].hostport;
           }
         }
       } else {
@@ -1571,13 +1638,11 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       std::stringstream ss;
       ss << "tree is as follow\n" << (*tree);
       eos_err(ss.str().c_str());
-      pxyentry->doubleBufferMutex.UnLockRead();
       AtomicDec(pxyentry->fastStructLockWaitersCount);
       return false;
     }
 
     // unlock it for each new fs
-    pxyentry->doubleBufferMutex.UnLockRead();
     AtomicDec(pxyentry->fastStructLockWaitersCount);
   }
 
@@ -1626,8 +1691,9 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
     entry = pGroup2SchedTME[group];
     AtomicInc(entry->fastStructLockWaitersCount);
   }
-  // readlock the original fast structure
-  entry->doubleBufferMutex.LockRead();
+  // pin the current snapshot of the fast structures
+  std::shared_ptr<FastStructSched> snapshot = entry->getForegroundSnapshot();
+  FastStructSched* fgStruct = snapshot.get();
   // locate the existing replicas and the excluded fs in the tree
   vector<SchedTreeBase::tFastTreeIdx> accessedReplicasIdx(nAccessReplicas),
          *existingReplicasIdx = NULL, *excludeFsIdx = NULL, *forceBrIdx = NULL;
@@ -1639,7 +1705,7 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
   for (auto it = existingReplicas->begin(); it != existingReplicas->end(); ++it) {
     const SchedTreeBase::tFastTreeIdx* idx;
 
-    if (!entry->foregroundFastStruct->fs2TreeIdx->get(*it, idx)) {
+    if (!fgStruct->fs2TreeIdx->get(*it, idx)) {
       eos_warning("could not place preexisting replica on the fast tree");
       continue;
     }
@@ -1654,7 +1720,7 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
     for (auto it = excludeFs->begin(); it != excludeFs->end(); ++it) {
       const SchedTreeBase::tFastTreeIdx* idx;
 
-      if (!entry->foregroundFastStruct->fs2TreeIdx->get(*it, idx)) {
+      if (!fgStruct->fs2TreeIdx->get(*it, idx)) {
         eos_warning("could not place excluded fs on the fast tree");
         continue;
       }
@@ -1671,7 +1737,7 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
 
     for (auto it = excludeGeoTags->begin(); it != excludeGeoTags->end(); ++it) {
       SchedTreeBase::tFastTreeIdx idx;
-      idx = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+      idx = fgStruct->tag2NodeIdx->getClosestFastTreeNode(
               it->c_str());
       excludeFsIdx->push_back(idx);
     }
@@ -1682,7 +1748,7 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
 
     for (auto it = forceGeoTags->begin(); it != forceGeoTags->end(); ++it) {
       SchedTreeBase::tFastTreeIdx idx;
-      idx = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+      idx = fgStruct->tag2NodeIdx->getClosestFastTreeNode(
               it->c_str());
       forceBrIdx->push_back(idx);
     }
@@ -1690,7 +1756,7 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
 
   // find the closest tree node to the accesser
   SchedTreeBase::tFastTreeIdx accesserNode =
-    entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+    fgStruct->tag2NodeIdx->getClosestFastTreeNode(
       accesserGeotag.c_str());;
   // actually do the job
   unsigned char success = 0;
@@ -1699,28 +1765,28 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
   case regularRO:
     success = accessReplicas(entry, nAccessReplicas, &accessedReplicasIdx,
                              accesserNode, existingReplicasIdx,
-                             entry->foregroundFastStruct->rOAccessTree, excludeFsIdx,
+                             fgStruct->rOAccessTree, excludeFsIdx,
                              forceBrIdx, pSkipSaturatedAccess);
     break;
 
   case regularRW:
     success = accessReplicas(entry, nAccessReplicas, &accessedReplicasIdx,
                              accesserNode, existingReplicasIdx,
-                             entry->foregroundFastStruct->rWAccessTree, excludeFsIdx,
+                             fgStruct->rWAccessTree, excludeFsIdx,
                              forceBrIdx, pSkipSaturatedAccess);
     break;
 
   case draining:
     success = accessReplicas(entry, nAccessReplicas, &accessedReplicasIdx,
                              accesserNode, existingReplicasIdx,
-                             entry->foregroundFastStruct->drnAccessTree, excludeFsIdx,
+                             fgStruct->drnAccessTree, excludeFsIdx,
                              forceBrIdx, pSkipSaturatedDrnAccess);
     break;
 
   case balancing:
     success = accessReplicas(entry, nAccessReplicas, &accessedReplicasIdx,
                              accesserNode, existingReplicasIdx,
-                             entry->foregroundFastStruct->blcAccessTree, excludeFsIdx, forceBrIdx,
+                             fgStruct->blcAccessTree, excludeFsIdx, forceBrIdx,
                              pSkipSaturatedBlcAccess);
     break;
 
@@ -1739,9 +1805,9 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
   for (auto it = accessedReplicasIdx.begin(); it != accessedReplicasIdx.end();
        ++it) {
     const SchedTreeBase::tFastTreeIdx* idx = NULL;
-    const unsigned int fsid = (*entry->foregroundFastStruct->treeInfo)[*it].fsId;
+    const unsigned int fsid = (*fgStruct->treeInfo)[*it].fsId;
 
-    if (!entry->foregroundFastStruct->fs2TreeIdx->get(fsid, idx)) {
+    if (!fgStruct->fs2TreeIdx->get(fsid, idx)) {
       eos_crit("inconsistency : cannot retrieve index of selected fs though it "
                "should be in the tree");
       success = false;
@@ -1749,26 +1815,25 @@ bool GeoTreeEngine::accessReplicasOneGroup(FsGroup* group,
     }
 
     const char netSpeedClass =
-      (*entry->foregroundFastStruct->treeInfo)[*idx].netSpeedClass;
+      (*fgStruct->treeInfo)[*idx].netSpeedClass;
     accessedReplicas->push_back(fsid);
 
     // apply the penalties
-    if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.dlScore >=
+    if (fgStruct->placementTree->pNodes[*idx].fsData.dlScore >=
         pPenaltySched.pAccessDlScorePenalty[netSpeedClass]) {
-      applyDlScorePenalty(entry, *idx,
+      applyDlScorePenalty(fgStruct, *idx,
                           pPenaltySched.pAccessDlScorePenalty[netSpeedClass]);
     }
 
-    if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.ulScore >=
+    if (fgStruct->placementTree->pNodes[*idx].fsData.ulScore >=
         pPenaltySched.pAccessUlScorePenalty[netSpeedClass]) {
-      applyUlScorePenalty(entry, *idx,
+      applyUlScorePenalty(fgStruct, *idx,
                           pPenaltySched.pAccessUlScorePenalty[netSpeedClass]);
     }
   }
 
   // unlock, cleanup
 cleanup:
-  entry->doubleBufferMutex.UnLockRead();
   AtomicDec(entry->fastStructLockWaitersCount);
   delete existingReplicasIdx;
 
@@ -1823,8 +1888,10 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
   std::vector<eos::common::FileSystem::fsid_t>::iterator it;
   std::vector<SchedTreeBase::tFastTreeIdx> ERIdx;
   ERIdx.reserve(existingReplicas->size());
-  std::vector<SchedTME*> entries;
-  entries.reserve(existingReplicas->size());
+  std::vector<FastStructSched*> fgStructs;
+  fgStructs.reserve(existingReplicas->size());
+  // Snapshots of the fast structures pinned for each scheduling group
+  map<SchedTME*, std::shared_ptr<FastStructSched> > entry2Snapshot;
   // Maps tree maps entries (i.e. scheduling groups) to fs ids containing an
   // available replica and the corresponding fastTreeIndex
   map<SchedTME*, vector< pair<FileSystem::fsid_t, SchedTreeBase::tFastTreeIdx> > >
@@ -1847,21 +1914,25 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
 
       entry = mentry->second;
 
-      // lock the double buffering to make sure all the fast trees are not modified
-      if (!entry2FsId.count(entry)) {
-        // if the entry is already there, it was locked already
-        entry->doubleBufferMutex.LockRead();
+      // pin a snapshot of the fast structures, the same one is used for all
+      // the replicas in this scheduling group
+      bool pinned = false;
+
+      if (!entry2Snapshot.count(entry)) {
+        entry2Snapshot[entry] = entry->getForegroundSnapshot();
         // to prevent the destruction of the entry
         AtomicInc(entry->fastStructLockWaitersCount);
+        pinned = true;
       }
 
+      FastStructSched* ft = entry2Snapshot[entry].get();
       const SchedTreeBase::tFastTreeIdx* idx;
 
-      if (!entry->foregroundFastStruct->fs2TreeIdx->get(*exrepIt, idx)) {
+      if (!ft->fs2TreeIdx->get(*exrepIt, idx)) {
         eos_warning("cannot find fs in the scheduling group in the 2nd pass");
 
-        if (!entry2FsId.count(entry)) {
-          entry->doubleBufferMutex.UnLockRead();
+        if (pinned) {
+          entry2Snapshot.erase(entry);
           AtomicDec(entry->fastStructLockWaitersCount);
         }
 
@@ -1870,7 +1941,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
 
       // take the fastindex of each existing replica
       ERIdx.push_back(*idx);
-      entries.push_back(entry);
+      fgStructs.push_back(ft);
       // check if the fs is available
       bool isValid = false;
 
@@ -1878,23 +1949,23 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
                     *exrepIt) == unavailableFs->end()) {
         switch (type) {
         case regularRO:
-          isValid = entry->foregroundFastStruct->rOAccessTree->pBranchComp.isValidSlot(
-                      &entry->foregroundFastStruct->rOAccessTree->pNodes[*idx].fsData, &freeSlot);
+          isValid = ft->rOAccessTree->pBranchComp.isValidSlot(
+                      &ft->rOAccessTree->pNodes[*idx].fsData, &freeSlot);
           break;
 
         case regularRW:
-          isValid = entry->foregroundFastStruct->rWAccessTree->pBranchComp.isValidSlot(
-                      &entry->foregroundFastStruct->rWAccessTree->pNodes[*idx].fsData, &freeSlot);
+          isValid = ft->rWAccessTree->pBranchComp.isValidSlot(
+                      &ft->rWAccessTree->pNodes[*idx].fsData, &freeSlot);
           break;
 
         case draining:
-          isValid = entry->foregroundFastStruct->drnAccessTree->pBranchComp.isValidSlot(
-                      &entry->foregroundFastStruct->drnAccessTree->pNodes[*idx].fsData, &freeSlot);
+          isValid = ft->drnAccessTree->pBranchComp.isValidSlot(
+                      &ft->drnAccessTree->pNodes[*idx].fsData, &freeSlot);
           break;
 
         case balancing:
-          isValid = entry->foregroundFastStruct->blcAccessTree->pBranchComp.isValidSlot(
-                      &entry->foregroundFastStruct->blcAccessTree->pNodes[*idx].fsData, &freeSlot);
+          isValid = ft->blcAccessTree->pBranchComp.isValidSlot(
+                      &ft->blcAccessTree->pNodes[*idx].fsData, &freeSlot);
           break;
 
         default:
@@ -1936,6 +2007,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
   // available fsids (+things) having a replica
   {
     SchedTreeBase::tFastTreeIdx accesserNode = 0;
+    FastStructSched* fgStruct = NULL;
     FileSystem::fsid_t selectedFsId = 0;
     eos::common::Logging& g_logging = eos::common::Logging::GetInstance();
     {
@@ -1945,6 +2017,8 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
 
       for (auto entryIt = entry2FsId.begin(); entryIt != entry2FsId.end();
            entryIt ++) {
+        fgStruct = entry2Snapshot[entryIt->first].get();
+
         if (g_logging.gLogMask & LOG_MASK(LOG_DEBUG)) {
           char buffer[1024];
           buffer[0] = 0;
@@ -1960,7 +2034,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
 
           for (auto it = entryIt->second.begin(); it != entryIt->second.end(); ++it) {
             buf += sprintf(buf, "%s  ",
-                           (*entryIt->first->foregroundFastStruct->treeInfo)[it->second].fullGeotag.c_str());
+                           (*fgStruct->treeInfo)[it->second].fullGeotag.c_str());
           }
 
           eos_debug("existing replicas geotags in geotree -> %s", buffer);
@@ -1974,7 +2048,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
 
         entry = entryIt->first;
         // find the closest tree node to the accesser
-        accesserNode = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+        accesserNode = fgStruct->tag2NodeIdx->getClosestFastTreeNode(
                          accesserGeotag.c_str());;
         // fill a vector with the indices of the replicas
         vector<SchedTreeBase::tFastTreeIdx> existingReplicasIdx(entryIt->second.size());
@@ -1991,28 +2065,28 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
         case regularRO:
           retCode = accessReplicas(entryIt->first, 1, &accessedReplicasIdx,
                                    accesserNode, &existingReplicasIdx,
-                                   entry->foregroundFastStruct->rOAccessTree,
+                                   fgStruct->rOAccessTree,
                                    NULL, NULL, pSkipSaturatedAccess);
           break;
 
         case regularRW:
           retCode = accessReplicas(entryIt->first, 1, &accessedReplicasIdx,
                                    accesserNode, &existingReplicasIdx,
-                                   entry->foregroundFastStruct->rWAccessTree,
+                                   fgStruct->rWAccessTree,
                                    NULL, NULL, pSkipSaturatedAccess);
           break;
 
         case draining:
           retCode = accessReplicas(entryIt->first, 1, &accessedReplicasIdx,
                                    accesserNode, &existingReplicasIdx,
-                                   entry->foregroundFastStruct->drnAccessTree,
+                                   fgStruct->drnAccessTree,
                                    NULL, NULL, pSkipSaturatedDrnAccess);
           break;
 
         case balancing:
           retCode = accessReplicas(entryIt->first, 1, &accessedReplicasIdx,
                                    accesserNode, &existingReplicasIdx,
-                                   entry->foregroundFastStruct->blcAccessTree,
+                                   fgStruct->blcAccessTree,
                                    NULL, NULL, pSkipSaturatedBlcAccess);
           break;
 
@@ -2025,7 +2099,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
         }
 
         const string& fsGeotag =
-          (*entryIt->first->foregroundFastStruct->treeInfo)[*accessedReplicasIdx.begin()].fullGeotag;
+          (*fgStruct->treeInfo)[*accessedReplicasIdx.begin()].fullGeotag;
         unsigned geoScore = 0;
         size_t kmax = min(accesserGeotag.length(), fsGeotag.length());
 
@@ -2046,7 +2120,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
         }
 
         geoScore2Fs[geoScore].push_back(
-          (*entryIt->first->foregroundFastStruct->treeInfo)[*accessedReplicasIdx.begin()].fsId);
+          (*fgStruct->treeInfo)[*accessedReplicasIdx.begin()].fsId);
       }
 
       // randomly choose a fs among the highest scored ones
@@ -2080,10 +2154,10 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
 
       eos_debug("existing replicas fs id's -> %s", buffer);
 
-      if (entry) {
+      if (entry && fgStruct) {
         eos_debug("accesser closest node to %s index -> %d / %s",
                   accesserGeotag.c_str(), (int)accesserNode,
-                  (*entry->foregroundFastStruct->treeInfo)[accesserNode].fullGeotag.c_str());
+                  (*fgStruct->treeInfo)[accesserNode].fullGeotag.c_str());
       }
 
       eos_debug("selected FsId -> %d / idx %d", (int)selectedFsId, (int)fsIndex);
@@ -2108,25 +2182,31 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
         continue;
       }
 
-      entry = pFs2SchedTME[fs];
+      auto snapIt = entry2Snapshot.find(pFs2SchedTME[fs]);
+
+      if (snapIt == entry2Snapshot.end()) {
+        continue;
+      }
+
+      FastStructSched* ft = snapIt->second.get();
       const SchedTreeBase::tFastTreeIdx* idx;
 
-      if (entry->foregroundFastStruct->fs2TreeIdx->get(fs, idx)) {
+      if (ft->fs2TreeIdx->get(fs, idx)) {
         const char netSpeedClass =
-          (*entry->foregroundFastStruct->treeInfo)[*idx].netSpeedClass;
+          (*ft->treeInfo)[*idx].netSpeedClass;
 
         // every available box will push data
-        if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.ulScore >=
+        if (ft->placementTree->pNodes[*idx].fsData.ulScore >=
             pPenaltySched.pAccessUlScorePenalty[netSpeedClass]) {
-          applyUlScorePenalty(entry, *idx,
+          applyUlScorePenalty(ft, *idx,
                               pPenaltySched.pAccessUlScorePenalty[netSpeedClass]);
         }
 
         // every available box will have to pull data if it's a RW access (or if it's a gateway)
         if ((type == regularRW) || (j == fsIndex && nAccessReplicas > 1)) {
-          if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.dlScore >=
+          if (ft->placementTree->pNodes[*idx].fsData.dlScore >=
               pPenaltySched.pAccessDlScorePenalty[netSpeedClass]) {
-            applyDlScorePenalty(entry, *idx,
+            applyDlScorePenalty(ft, *idx,
                                 pPenaltySched.pAccessDlScorePenalty[netSpeedClass]);
           }
         }
@@ -2142,7 +2222,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
   }
 
   if (dataProxys) {
-    if (!findProxy(ERIdx, entries, inode, dataProxys, NULL,
+    if (!findProxy(ERIdx, fgStructs, inode, dataProxys, NULL,
                    pProxyCloseToFs ? "" : accesserGeotag, filesticky)) {
       returnCode = ENETUNREACH;
       goto cleanup;
@@ -2156,10 +2236,10 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
     if (pAccessGeotagMapping.inuse && pAccessProxygroup.inuse)
       for (size_t i = 0; i < ERIdx.size(); i++) {
         if (accesserGeotag.empty() ||
-            accessReqFwEP((*entries[i]->foregroundFastStruct->treeInfo)[ERIdx[i]].fullGeotag
+            accessReqFwEP((*fgStructs[i]->treeInfo)[ERIdx[i]].fullGeotag
                           , accesserGeotag)) {
           firewallProxyGroups[i] = accessGetProxygroup((
-                                     *entries[i]->foregroundFastStruct->treeInfo)[ERIdx[i]].fullGeotag);
+                                     *fgStructs[i]->treeInfo)[ERIdx[i]].fullGeotag);
         }
       }
 
@@ -2167,7 +2247,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
       *firewallEntryPoint = *dataProxys;
     }
 
-    if (!findProxy(ERIdx, entries, inode, firewallEntryPoint, &firewallProxyGroups,
+    if (!findProxy(ERIdx, fgStructs, inode, firewallEntryPoint, &firewallProxyGroups,
                    pProxyCloseToFs ? "" : accesserGeotag, any)) {
       returnCode = ENETUNREACH;
       goto cleanup;
@@ -2179,7 +2259,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
       *dataProxys = *firewallEntryPoint;
     }
 
-    if (!findProxy(ERIdx, entries, inode, dataProxys, NULL,
+    if (!findProxy(ERIdx, fgStructs, inode, dataProxys, NULL,
                    pProxyCloseToFs ? "" : accesserGeotag, regular)) {
       returnCode = ENETUNREACH;
       goto cleanup;
@@ -2191,8 +2271,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
   // cleanup and exit
 cleanup:
 
-  for (auto cit = entry2FsId.begin(); cit != entry2FsId.end(); cit++) {
-    cit->first->doubleBufferMutex.UnLockRead();
+  for (auto cit = entry2Snapshot.begin(); cit != entry2Snapshot.end(); cit++) {
     AtomicDec(cit->first->fastStructLockWaitersCount);
   }
 
@@ -3047,34 +3126,54 @@ bool GeoTreeEngine::updateTreeInfo(ProxyTMEBase* entry,
 bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
                                    const map<string, int>& updatesDp)
 {
-  // copy the foreground FastStructures to the BackGround FastStructures
-  // so that the penalties applied after the placement/access are kept by defaut
-  // (and overwritten if a new state is received from the fs)
+  // Tell the users of getFsStatusGeneration about status changes
+  const int status_keys = sfgBoot | sfgActive | sfgConfigstatus | sfgDrain |
+                          sfgErrc | sfgId | sfgHost | sfgGeotag;
+
+  for (auto it = updatesFs.begin(); it != updatesFs.end(); ++it) {
+    if (it->second & status_keys) {
+      pFsStatusGeneration++;
+      break;
+    }
+  }
+
+  for (auto it = updatesDp.begin(); it != updatesDp.end(); ++it) {
+    if (it->second & (sfgActive | sfgHost | sfgGeotag)) {
+      pFsStatusGeneration++;
+      break;
+    }
+  }
+
+  // The background FastStructures are copied from the foreground ones only
+  // when a group gets modified, so that the penalties applied after the
+  // placement/access are kept by defaut (and overwritten if a new state is
+  // received from the fs). The penalized nodes are updated along with the
+  // modified ones.
   // => SCHEDULING
   pTreeMapMutex.LockRead();
 
   for (auto it = pGroup2SchedTME.begin(); it != pGroup2SchedTME.end(); it++) {
     SchedTME* entry = it->second;
     RWMutexReadLock lock(entry->slowTreeMutex);
-
-    if (!entry->foregroundFastStruct->DeepCopyTo(entry->backgroundFastStruct)) {
-      eos_crit("error deep copying in double buffering");
-      pTreeMapMutex.UnLockRead();
-      return false;
-    }
-
+    std::shared_ptr<FastStructSched> fg = entry->getForegroundSnapshot();
+    entry->penalizedFastNodes.clear();
     // Copy the penalties of the last frame from each group and reset the
     // penalties counter in the fast trees.
     auto& pVec = pPenaltySched.pCircFrCnt2FsPenalties[pFrameCount % pCircSize];
 
-    for (auto it2 = entry->foregroundFastStruct->fs2TreeIdx->begin();
-         it2 != entry->foregroundFastStruct->fs2TreeIdx->end(); it2++) {
+    for (auto it2 = fg->fs2TreeIdx->begin();
+         it2 != fg->fs2TreeIdx->end(); it2++) {
       auto cur = *it2;
-      pVec[cur.first] = (*entry->foregroundFastStruct->penalties)[cur.second];
-      AtomicCAS((*entry->foregroundFastStruct->penalties)[cur.second].dlScorePenalty,
-                (*entry->foregroundFastStruct->penalties)[cur.second].dlScorePenalty, (char)0);
-      AtomicCAS((*entry->foregroundFastStruct->penalties)[cur.second].ulScorePenalty,
-                (*entry->foregroundFastStruct->penalties)[cur.second].ulScorePenalty, (char)0);
+      pVec[cur.first] = (*fg->penalties)[cur.second];
+
+      if (pVec[cur.first].dlScorePenalty || pVec[cur.first].ulScorePenalty) {
+        entry->penalizedFastNodes.push_back(cur.second);
+      }
+
+      AtomicCAS((*fg->penalties)[cur.second].dlScorePenalty,
+                (*fg->penalties)[cur.second].dlScorePenalty, (char)0);
+      AtomicCAS((*fg->penalties)[cur.second].ulScorePenalty,
+                (*fg->penalties)[cur.second].ulScorePenalty, (char)0);
     }
   }
 
@@ -3085,25 +3184,25 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
   for (auto it = pPxyGrp2DpTME.begin(); it != pPxyGrp2DpTME.end(); it++) {
     DataProxyTME* entry = it->second;
     RWMutexReadLock lock(entry->slowTreeMutex);
-
-    if (!entry->foregroundFastStruct->DeepCopyTo(entry->backgroundFastStruct)) {
-      eos_crit("error deep copying in double buffering");
-      pPxyTreeMapMutex.UnLockRead();
-      return false;
-    }
-
+    std::shared_ptr<FastStructProxy> fg = entry->getForegroundSnapshot();
+    entry->penalizedFastNodes.clear();
     // Copy the penalties of the last frame from each group and reset the
     // penalties counter in the fast trees.
     auto& pMap = pPenaltySched.pCircFrCnt2HostPenalties[pFrameCount % pCircSize];
 
-    for (auto it2 = entry->foregroundFastStruct->host2TreeIdx->begin();
-         it2 != entry->foregroundFastStruct->host2TreeIdx->end(); it2++) {
+    for (auto it2 = fg->host2TreeIdx->begin();
+         it2 != fg->host2TreeIdx->end(); it2++) {
       auto cur = *it2;
-      pMap[cur.first] = (*entry->foregroundFastStruct->penalties)[cur.second];
-      AtomicCAS((*entry->foregroundFastStruct->penalties)[cur.second].dlScorePenalty,
-                (*entry->foregroundFastStruct->penalties)[cur.second].dlScorePenalty, (char)0);
-      AtomicCAS((*entry->foregroundFastStruct->penalties)[cur.second].ulScorePenalty,
-                (*entry->foregroundFastStruct->penalties)[cur.second].ulScorePenalty, (char)0);
+      pMap[cur.first] = (*fg->penalties)[cur.second];
+
+      if (pMap[cur.first].dlScorePenalty || pMap[cur.first].ulScorePenalty) {
+        entry->penalizedFastNodes.push_back(cur.second);
+      }
+
+      AtomicCAS((*fg->penalties)[cur.second].dlScorePenalty,
+                (*fg->penalties)[cur.second].dlScorePenalty, (char)0);
+      AtomicCAS((*fg->penalties)[cur.second].ulScorePenalty,
+                (*fg->penalties)[cur.second].ulScorePenalty, (char)0);
     }
   }
 
@@ -3175,17 +3274,21 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
     // Update only the fast structures because even if a fast structure rebuild
     // is needed from the slow tree. Its information and state is updated from
     // the fast structures.
-    entry->doubleBufferMutex.LockRead();
     const SchedTreeBase::tFastTreeIdx* idx = NULL;
     SlowTreeNode* node = NULL;
 
+    if (!entry->refreshBackgroundFastStruct()) {
+      eos_crit("error deep copying the foreground snapshot");
+      AtomicDec(entry->fastStructLockWaitersCount);
+      return false;
+    }
+
     if (!entry->backgroundFastStruct->fs2TreeIdx->get(fsid, idx)) {
       auto nodeit = entry->fs2SlowTreeNode.find(fsid);
 
       if (nodeit == entry->fs2SlowTreeNode.end()) {
         eos_crit("Inconsistency : cannot locate an fs %lu supposed to be in "
                  "the fast structures", (unsigned long)fsid);
-        entry->doubleBufferMutex.UnLockRead();
         AtomicDec(entry->fastStructLockWaitersCount);
         return false;
       }
@@ -3200,7 +3303,7 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
     updateTreeInfo(entry, &fs, it->second, idx ? *idx : 0 , node);
 
     if (idx) {
-      entry->fastStructModified = true;
+      entry->modifiedFastNodes.push_back(*idx);
     }
 
     if (node) {
@@ -3208,7 +3311,6 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
     }
 
     // if we update the slowtree, then a fast tree generation is already pending
-    entry->doubleBufferMutex.UnLockRead();
     AtomicDec(entry->fastStructLockWaitersCount);
   }
 
@@ -3255,17 +3357,21 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
       // Update only the fast structures because even if a fast structure
       // rebuild is needed from the slow tree. Its information and state is
       // updated from the fast structures.
-      entry->doubleBufferMutex.LockRead();
       const SchedTreeBase::tFastTreeIdx* idx = NULL;
       SlowTreeNode* node = NULL;
 
+      if (!entry->refreshBackgroundFastStruct()) {
+        eos_crit("error deep copying the foreground snapshot");
+        AtomicDec(entry->fastStructLockWaitersCount);
+        return false;
+      }
+
       if (!entry->backgroundFastStruct->host2TreeIdx->get(host.c_str(), idx)) {
         auto nodeit = entry->host2SlowTreeNode.find(host);
 
         if (nodeit == entry->host2SlowTreeNode.end()) {
           eos_crit("Inconsistency : cannot locate an host: %s supposed to be "
                    "in the fast structures", host.c_str());
-          entry->doubleBufferMutex.UnLockRead();
           AtomicDec(entry->fastStructLockWaitersCount);
           return false;
         }
@@ -3280,7 +3386,7 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
       updateTreeInfo(entry, &hs, it->second, idx ? *idx : 0 , node);
 
       if (idx) {
-        entry->fastStructModified = true;
+        entry->modifiedFastNodes.push_back(*idx);
       }
 
       if (node) {
@@ -3288,18 +3394,17 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
       }
 
       // if we update the slowtree, then a fast tree generation is already pending
-      entry->doubleBufferMutex.UnLockRead();
       AtomicDec(entry->fastStructLockWaitersCount);
     }
   }
 
   // Update the atomic penalties
   updateAtomicPenalties();
-  // Update the trees that need to be updated (could maybe optimized by
-  // updating only the branch needing, might be worth it if only 1 or 2
-  // branches are updated). Self update for the fast structure if update
-  // from slow tree is not needed. If convert from slowtree is needed,
-  // update the slowtree from the fast for the info and for the state
+  // Update the trees that need to be updated. Self update for the fast
+  // structure if update from slow tree is not needed, only along the paths
+  // from the modified nodes to the root if nothing else changed. If convert
+  // from slowtree is needed, update the slowtree from the fast for the info
+  // and for the state
   // => SCHED
   pTreeMapMutex.LockRead();
 
@@ -3360,14 +3465,16 @@ bool GeoTreeEngine::getInfosFromFsIds(const std::vector<FileSystem::fsid_t>&
 
         if (fsgeotags || hosts) {
           const SchedTreeBase::tFastTreeIdx* idx = NULL;
+          std::shared_ptr<FastStructSched> fg =
+            pFs2SchedTME[*it]->getForegroundSnapshot();
 
-          if (pFs2SchedTME[*it]->foregroundFastStruct->fs2TreeIdx->get(*it, idx)) {
+          if (fg->fs2TreeIdx->get(*it, idx)) {
             if (fsgeotags) fsgeotags->push_back(
-                (*pFs2SchedTME[*it]->foregroundFastStruct->treeInfo)[*idx].fullGeotag
+                (*fg->treeInfo)[*idx].fullGeotag
               );
 
             if (hosts) hosts->push_back(
-                (*pFs2SchedTME[*it]->foregroundFastStruct->treeInfo)[*idx].host
+                (*fg->treeInfo)[*idx].host
               );
           } else {
             if (fsgeotags) {
@@ -3940,9 +4047,9 @@ void GeoTreeEngine::setConfigValue(const char* prefix,
 bool GeoTreeEngine::markPendingBranchDisablings(const std::string& group,
     const std::string& optype, const std::string& geotag)
 {
+  // the pAddRmFsMutex is write locked by the caller so the fast structures
+  // can not be rebuilt concurrently
   for (auto git = pGroup2SchedTME.begin(); git != pGroup2SchedTME.end(); git++) {
-    RWMutexReadLock lock(git->second->doubleBufferMutex);
-
     if (group == "*" || git->first->mName == group) {
       git->second->slowTreeModified = true;
     }
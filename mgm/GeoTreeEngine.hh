@@ -43,6 +43,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <atomic>
+#include <memory>
 
 /*----------------------------------------------------------------------------*/
 /**
@@ -406,6 +408,7 @@ class GeoTreeEngine : public eos::common::LogId
       }
 
       // copy the penalties
+      target->penalties->resize(penalties->size());
       std::copy(penalties->begin(), penalties->end(),
                 target->penalties->begin());
       // update the information in the FastTrees to point to the copy
@@ -439,6 +442,30 @@ class GeoTreeEngine : public eos::common::LogId
       drnPlacementTree->updateTree();
     }
 
+    //--------------------------------------------------------------------------
+    //! Update the trees after the state of some nodes changed. Only these
+    //! nodes and their ancestors are updated unless a large part of the tree
+    //! changed.
+    //--------------------------------------------------------------------------
+    void UpdateTreesFromNodes(const std::vector<SchedTreeBase::tFastTreeIdx>&
+                              nodes)
+    {
+      if (nodes.size() * 4 > placementTree->getNodeCount()) {
+        UpdateTrees();
+        return;
+      }
+
+      for (auto node : nodes) {
+        rOAccessTree->updateTreeFromNode(node);
+        rWAccessTree->updateTreeFromNode(node);
+        blcAccessTree->updateTreeFromNode(node);
+        drnAccessTree->updateTreeFromNode(node);
+        placementTree->updateTreeFromNode(node);
+        blcPlacementTree->updateTreeFromNode(node);
+        drnPlacementTree->updateTreeFromNode(node);
+      }
+    }
+
     void WriteSlowState(SlowTreeNode::TreeNodeStateFloat& slowState,
                         SchedTreeBase::tFastTreeIdx idx) const
     {
@@ -608,6 +635,7 @@ class GeoTreeEngine : public eos::common::LogId
       }
 
       // copy the penalties
+      target->penalties->resize(penalties->size());
       std::copy(penalties->begin(), penalties->end(),
                 target->penalties->begin());
       // update the information in the FastTrees to point to the copy
@@ -623,6 +651,22 @@ class GeoTreeEngine : public eos::common::LogId
       proxyAccessTree->updateTree();
     }
 
+    //--------------------------------------------------------------------------
+    //! Update the tree after the state of some nodes changed
+    //--------------------------------------------------------------------------
+    void UpdateTreesFromNodes(const std::vector<SchedTreeBase::tFastTreeIdx>&
+                              nodes)
+    {
+      if (nodes.size() * 4 > proxyAccessTree->getNodeCount()) {
+        UpdateTrees();
+        return;
+      }
+
+      for (auto node : nodes) {
+        proxyAccessTree->updateTreeFromNode(node);
+      }
+    }
+
     void WriteSlowState(SlowTreeNode::TreeNodeStateFloat& slowState,
                         SchedTreeBase::tFastTreeIdx idx) const
     {
@@ -709,29 +753,52 @@ class GeoTreeEngine : public eos::common::LogId
     eos::common::RWMutex slowTreeMutex;
     bool slowTreeModified;
 
-    // ===== Fast Structures Management and Double Buffering ====== //
-    FastStruct fastStructures[2];
-    // the pointed object is read only accessed by several thread
-    FastStruct* foregroundFastStruct;
-    // the pointed object is accessed in read /write only by the thread update
+    // ===== Fast Structures Management: RCU style snapshots ====== //
+    // the foreground snapshot is read by the scheduling threads without any
+    // lock. A reader pins it with getForegroundSnapshot and keeps working on
+    // the same snapshot until it drops the returned pointer. The layout of a
+    // published snapshot is never modified, only the scores are decremented
+    // atomically when applying the penalties.
+    std::shared_ptr<FastStruct> foregroundSnapshot;
+    // the background fast structure is accessed in read /write only by the
+    // thread building the next snapshot (the one holding pAddRmFsMutex)
+    std::shared_ptr<FastStruct> backgroundSnapshot;
     FastStruct* backgroundFastStruct;
-    // the two previous pointers are swapped once an update is done. To do so, we need a mutex and a counter (for deletion)
-    // every access to *mForegroundFastStruct for reading should be protected by a LockRead to mDoubleBufferMutex
-    // when swapping mForegroundFastStruct and mBackgroundFastStruct is needed a LockWrite is taken to mDoubleBufferMutex
-    eos::common::RWMutex doubleBufferMutex;
+    // snapshots published before, recycled as background once unpinned
+    std::vector<std::shared_ptr<FastStruct>> retiredSnapshots;
+    // number of threads using the entry, it can only be deleted when it is 0
     size_t fastStructLockWaitersCount;
+    // the layout or all the nodes changed, a full update of the trees is needed
     bool fastStructModified;
+    // nodes whose state changed in the background, only them and their
+    // ancestors are updated when nothing else is modified
+    std::vector<SchedTreeBase::tFastTreeIdx> modifiedFastNodes;
+    // nodes whose scores were penalized in the foreground, updated along with
+    // the modified ones
+    std::vector<SchedTreeBase::tFastTreeIdx> penalizedFastNodes;
+    // the background is an outdated snapshot and has to be copied from the
+    // foreground before being modified
+    bool backgroundStale;
+    // configuration parameters the foreground snapshot was sorted with
+    bool configParamSet;
+    char configParam[3];
+
+    //! max number of unpinned retired snapshots kept around for recycling
+    static constexpr size_t sMaxRetiredSnapshots = 2;
 
     TreeMapEntry(const std::string& groupName = "") :
       slowTreeModified(false),
-      foregroundFastStruct(fastStructures),
-      backgroundFastStruct(fastStructures + 1),
+      foregroundSnapshot(std::make_shared<FastStruct>()),
+      backgroundSnapshot(std::make_shared<FastStruct>()),
+      backgroundFastStruct(backgroundSnapshot.get()),
       fastStructLockWaitersCount(0),
-      fastStructModified(false)
+      fastStructModified(false),
+      backgroundStale(false),
+      configParamSet(false),
+      configParam{0, 0, 0}
     {
       slowTree = new SlowTree(groupName);
       slowTreeMutex.SetBlocking(true);
-      doubleBufferMutex.SetBlocking(true);
     }
 
     ~TreeMapEntry()
@@ -741,20 +808,130 @@ class GeoTreeEngine : public eos::common::LogId
       }
     }
 
+    //--------------------------------------------------------------------------
+    //! Pin the current foreground snapshot, it stays valid and consistent
+    //! until the returned pointer is released even if a new one is published
+    //--------------------------------------------------------------------------
+    std::shared_ptr<FastStruct> getForegroundSnapshot() const
+    {
+      return std::atomic_load(&foregroundSnapshot);
+    }
+
+    //--------------------------------------------------------------------------
+    //! Make sure no reader still pins the background fast structure before it
+    //! gets modified. If it is still in use, it is retired and replaced by an
+    //! unpinned retired snapshot or a new one, refreshed from the foreground.
+    //--------------------------------------------------------------------------
+    void reclaimBackgroundFastStruct()
+    {
+      if (backgroundSnapshot.use_count() == 1) {
+        return;
+      }
+
+      std::shared_ptr<FastStruct> reclaimed;
+
+      for (auto it = retiredSnapshots.begin(); it != retiredSnapshots.end(); ++it) {
+        if (it->use_count() == 1) {
+          reclaimed = *it;
+          retiredSnapshots.erase(it);
+          break;
+        }
+      }
+
+      if (!reclaimed) {
+        reclaimed = std::make_shared<FastStruct>();
+      }
+
+      retiredSnapshots.push_back(backgroundSnapshot);
+      size_t count = 0;
+
+      for (auto it = retiredSnapshots.begin(); it != retiredSnapshots.end();) {
+        if ((it->use_count() == 1) && (++count > sMaxRetiredSnapshots)) {
+          it = retiredSnapshots.erase(it);
+        } else {
+          ++it;
+        }
+      }
+
+      std::shared_ptr<FastStruct> fg = getForegroundSnapshot();
+
+      if (!fg->DeepCopyTo(reclaimed.get())) {
+        eos_static_crit("error deep copying the foreground to a reclaimed snapshot");
+      }
+
+      backgroundSnapshot = reclaimed;
+      backgroundFastStruct = reclaimed.get();
+    }
+
+    //--------------------------------------------------------------------------
+    //! Make the background an unpinned copy of the foreground before it gets
+    //! modified. The copy is done at most once per published snapshot.
+    //!
+    //! @return false if the copy failed
+    //--------------------------------------------------------------------------
+    bool refreshBackgroundFastStruct()
+    {
+      if (!backgroundStale) {
+        return true;
+      }
+
+      if (backgroundSnapshot.use_count() != 1) {
+        // replaced by a copy of the foreground
+        reclaimBackgroundFastStruct();
+      } else if (!getForegroundSnapshot()->DeepCopyTo(backgroundFastStruct)) {
+        return false;
+      }
+
+      // the scores penalized since the start of the frame changed as well
+      const auto& penalties = *backgroundFastStruct->penalties;
+
+      for (size_t idx = 0; idx < penalties.size(); ++idx) {
+        if (penalties[idx].dlScorePenalty || penalties[idx].ulScorePenalty) {
+          penalizedFastNodes.push_back(idx);
+        }
+      }
+
+      backgroundStale = false;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Publish the background fast structure as the new foreground snapshot.
+    //! The scheduling threads are never blocked, the ones still working on
+    //! the previous snapshot keep it alive until they are done.
+    //--------------------------------------------------------------------------
     void swapFastStructBuffers()
     {
-      eos::common::RWMutexWriteLock lock(doubleBufferMutex);
-      std::swap(foregroundFastStruct, backgroundFastStruct);
+      std::shared_ptr<FastStruct> previous =
+        std::atomic_exchange(&foregroundSnapshot, backgroundSnapshot);
+      backgroundSnapshot = previous;
+      backgroundFastStruct = previous.get();
+      backgroundStale = true;
+      modifiedFastNodes.clear();
+      penalizedFastNodes.clear();
     }
 
-    void updateBGFastStructuresConfigParam(
+    //--------------------------------------------------------------------------
+    //! Set the configuration parameters of the background fast structure
+    //!
+    //! @return true if they differ from the ones the foreground snapshot was
+    //!         sorted with, the trees then need a full update
+    //--------------------------------------------------------------------------
+    bool updateBGFastStructuresConfigParam(
       const char& fillRatioLimit,
       const char& fillRatioCompTol,
       const char& saturationThres)
     {
       backgroundFastStruct->setConfigParam(fillRatioLimit, fillRatioCompTol,
                                            saturationThres);
-      refreshBackGroundFastStructures();
+      bool changed = !configParamSet || (configParam[0] != fillRatioLimit) ||
+                     (configParam[1] != fillRatioCompTol) ||
+                     (configParam[2] != saturationThres);
+      configParamSet = true;
+      configParam[0] = fillRatioLimit;
+      configParam[1] = fillRatioCompTol;
+      configParam[2] = saturationThres;
+      return changed;
     }
 
     void refreshBackGroundFastStructures()
@@ -882,10 +1059,22 @@ class GeoTreeEngine : public eos::common::LogId
     eos::common::Logging& g_logging = eos::common::Logging::GetInstance();
 
     // if nothing is modified here move to the next group
-    if (!(entry->slowTreeModified || entry->fastStructModified)) {
+    if (!(entry->slowTreeModified || entry->fastStructModified ||
+          !entry->modifiedFastNodes.empty())) {
       return true;
     }
 
+    // the background must not be pinned by any reader while being rebuilt
+    if (!entry->refreshBackgroundFastStruct()) {
+      eos_crit("error deep copying the foreground snapshot");
+      return false;
+    }
+
+    // update the BackGroundFastStructures configuration parameters accordingly
+    // to the one present in the GeoTree
+    bool fullUpdate = entry->updateBGFastStructuresConfigParam(pFillRatioLimit,
+                      pFillRatioCompTol, pSaturationThres);
+
     if (entry->slowTreeModified) {
       entry->updateSlowTreeInfoFromBgFastStruct();
 
@@ -906,28 +1095,39 @@ class GeoTreeEngine : public eos::common::LogId
         eos_debug("fast structures updated successfully from slowtree : old SLOW tree was \n %s",
                   ss.str().c_str());
       }
+
+      fullUpdate = true;
     } else {
-      // the rebuild of the fast structures is not necessary
+      // the rebuild of the fast structures is not necessary, if only the
+      // state of some nodes changed just them and their ancestors are updated
+      fullUpdate = fullUpdate || entry->fastStructModified;
+
+      if (!fullUpdate) {
+        std::vector<SchedTreeBase::tFastTreeIdx>& nodes = entry->modifiedFastNodes;
+        nodes.insert(nodes.end(), entry->penalizedFastNodes.begin(),
+                     entry->penalizedFastNodes.end());
+        entry->backgroundFastStruct->UpdateTreesFromNodes(nodes);
+      }
+    }
+
+    if (fullUpdate) {
       entry->refreshBackGroundFastStructures();
+    }
 
-      if (g_logging.gLogMask & LOG_MASK(LOG_DEBUG)) {
-        stringstream ss;
-        ss << (*entry->backgroundFastStruct->placementTree);
-        eos_debug("fast structures updated successfully from fastree : new FASTtree is \n %s",
-                  ss.str().c_str());
-      }
+    if (!entry->slowTreeModified && (g_logging.gLogMask & LOG_MASK(LOG_DEBUG))) {
+      stringstream ss;
+      ss << (*entry->backgroundFastStruct->placementTree);
+      eos_debug("fast structures updated successfully from fastree : new FASTtree is \n %s",
+                ss.str().c_str());
     }
 
     // mark the entry as updated
     entry->slowTreeModified = false;
     entry->fastStructModified = false;
-    // update the BackGroundFastStructures configuration parameters accordingly to the one present in the GeoTree (and update the fast trees)
-    entry->updateBGFastStructuresConfigParam(pFillRatioLimit, pFillRatioCompTol,
-        pSaturationThres);
     // clear the penalties
     std::fill(entry->backgroundFastStruct->penalties->begin(),
               entry->backgroundFastStruct->penalties->end(), Penalties());
-    // swap the buffers (this is the only bit where the fast structures is not accessible for a placement/access operation)
+    // publish the new snapshot, the placement/access operations are never blocked
     entry->swapFastStructBuffers();
     return true;
   }
@@ -937,10 +1137,22 @@ class GeoTreeEngine : public eos::common::LogId
     eos::common::Logging& g_logging = eos::common::Logging::GetInstance();
 
     // if nothing is modified here move to the next group
-    if (!(entry->slowTreeModified || entry->fastStructModified)) {
+    if (!(entry->slowTreeModified || entry->fastStructModified ||
+          !entry->modifiedFastNodes.empty())) {
       return true;
     }
 
+    // the background must not be pinned by any reader while being rebuilt
+    if (!entry->refreshBackgroundFastStruct()) {
+      eos_crit("error deep copying the foreground snapshot");
+      return false;
+    }
+
+    // update the BackGroundFastStructures configuration parameters accordingly
+    // to the one present in the GeoTree
+    bool fullUpdate = entry->updateBGFastStructuresConfigParam(pFillRatioLimit,
+                      pFillRatioCompTol, pSaturationThres);
+
     if (entry->slowTreeModified) {
       entry->updateSlowTreeInfoFromBgFastStruct();
 
@@ -961,28 +1173,39 @@ class GeoTreeEngine : public eos::common::LogId
         eos_debug("fast structures updated successfully from slowtree : old SLOW tree was \n %s",
                   ss.str().c_str());
       }
+
+      fullUpdate = true;
     } else {
-      // the rebuild of the fast structures is not necessary
+      // the rebuild of the fast structures is not necessary, if only the
+      // state of some nodes changed just them and their ancestors are updated
+      fullUpdate = fullUpdate || entry->fastStructModified;
+
+      if (!fullUpdate) {
+        std::vector<SchedTreeBase::tFastTreeIdx>& nodes = entry->modifiedFastNodes;
+        nodes.insert(nodes.end(), entry->penalizedFastNodes.begin(),
+                     entry->penalizedFastNodes.end());
+        entry->backgroundFastStruct->UpdateTreesFromNodes(nodes);
+      }
+    }
+
+    if (fullUpdate) {
       entry->refreshBackGroundFastStructures();
+    }
 
-      if (g_logging.gLogMask & LOG_MASK(LOG_DEBUG)) {
-        stringstream ss;
-        ss << (*entry->backgroundFastStruct->proxyAccessTree);
-        eos_debug("fast structures updated successfully from fastree : new FASTtree is \n %s",
-                  ss.str().c_str());
-      }
+    if (!entry->slowTreeModified && (g_logging.gLogMask & LOG_MASK(LOG_DEBUG))) {
+      stringstream ss;
+      ss << (*entry->backgroundFastStruct->proxyAccessTree);
+      eos_debug("fast structures updated successfully from fastree : new FASTtree is \n %s",
+                ss.str().c_str());
     }
 
     // mark the entry as updated
     entry->slowTreeModified = false;
     entry->fastStructModified = false;
-    // update the BackGroundFastStructures configuration parameters accordingly to the one present in the GeoTree (and update the fast trees)
-    entry->updateBGFastStructuresConfigParam(pFillRatioLimit, pFillRatioCompTol,
-        pSaturationThres);
     // clear the penalties
     std::fill(entry->backgroundFastStruct->penalties->begin(),
               entry->backgroundFastStruct->penalties->end(), Penalties());
-    // swap the buffers (this is the only bit where the fast structures is not accessible for a placement/access operation)
+    // publish the new snapshot, the placement/access operations are never blocked
     entry->swapFastStructBuffers();
     return true;
   }
@@ -1169,6 +1392,8 @@ protected:
   //
   const size_t pCircSize;
   size_t pFrameCount;
+  /// Generation of the file system states, see getFsStatusGeneration
+  std::atomic<uint64_t> pFsStatusGeneration {0};
   struct PenaltySubSys {
     std::vector<tPenaltiesVec> pCircFrCnt2FsPenalties;
     std::vector<tPenaltiesMap> pCircFrCnt2HostPenalties;
@@ -1310,39 +1535,31 @@ protected:
   static void tlFree(void* arg);
   static char* tlAlloc(size_t size);
 
-  inline void applyDlScorePenalty(SchedTME* entry,
+  inline void applyDlScorePenalty(FastStructSched* ft,
                                   const SchedTreeBase::tFastTreeIdx& idx, const char& penalty,
                                   bool background = false)
   {
-    FastStructSched* ft = background ? entry->backgroundFastStruct :
-                          entry->foregroundFastStruct;
     ft->applyDlScorePenalty(idx, penalty, background);
   }
 
-  inline void applyDlScorePenalty(ProxyTMEBase* entry,
+  inline void applyDlScorePenalty(FastStructProxy* ft,
                                   const SchedTreeBase::tFastTreeIdx& idx, const char& penalty,
                                   bool background = false)
   {
-    FastStructProxy* ft = background ? entry->backgroundFastStruct :
-                          entry->foregroundFastStruct;
     ft->applyDlScorePenalty(idx, penalty, background);
   }
 
-  inline void applyUlScorePenalty(SchedTME* entry,
+  inline void applyUlScorePenalty(FastStructSched* ft,
                                   const SchedTreeBase::tFastTreeIdx& idx, const char& penalty,
                                   bool background = false)
   {
-    FastStructSched* ft = background ? entry->backgroundFastStruct :
-                          entry->foregroundFastStruct;
     ft->applyUlScorePenalty(idx, penalty, background);
   }
 
-  inline void applyUlScorePenalty(ProxyTMEBase* entry,
+  inline void applyUlScorePenalty(FastStructProxy* ft,
                                   const SchedTreeBase::tFastTreeIdx& idx, const char& penalty,
                                   bool background = false)
   {
-    FastStructProxy* ft = background ? entry->backgroundFastStruct :
-                          entry->foregroundFastStruct;
     ft->applyUlScorePenalty(idx, penalty, background);
   }
 
@@ -1351,6 +1568,7 @@ protected:
   {
     auto fsid = (*entry->backgroundFastStruct->treeInfo)[idx].fsId;
     tLatencyStats& lstat = pLatencySched.pFsId2LatencyStats[fsid];
+    std::shared_ptr<FastStructSched> fg = entry->getForegroundSnapshot();
     //auto mydata = entry->backgroundFastStruct->placementTree->pNodes[idx].fsData;
     int count = 0;
 
@@ -1359,14 +1577,14 @@ protected:
          (pLatencySched.pCircFrCnt2Timestamp[circIdx] > lstat.lastupdate -
           pPublishToPenaltyDelayMs);
          circIdx = ((pCircSize + circIdx - 1) % pCircSize)) {
-      if (entry->foregroundFastStruct->placementTree->pNodes[idx].fsData.dlScore > 0)
-        applyDlScorePenalty(entry, idx,
+      if (fg->placementTree->pNodes[idx].fsData.dlScore > 0)
+        applyDlScorePenalty(entry->backgroundFastStruct, idx,
                             pPenaltySched.pCircFrCnt2FsPenalties[circIdx][fsid].dlScorePenalty,
                             true
                            );
 
-      if (entry->foregroundFastStruct->placementTree->pNodes[idx].fsData.ulScore > 0)
-        applyUlScorePenalty(entry, idx,
+      if (fg->placementTree->pNodes[idx].fsData.ulScore > 0)
+        applyUlScorePenalty(entry->backgroundFastStruct, idx,
                             pPenaltySched.pCircFrCnt2FsPenalties[circIdx][fsid].ulScorePenalty,
                             true
                            );
@@ -1395,6 +1613,7 @@ protected:
   {
     auto host = (*entry->backgroundFastStruct->treeInfo)[idx].host;
     tLatencyStats& lstat = pLatencySched.pHost2LatencyStats[host];
+    std::shared_ptr<FastStructProxy> fg = entry->getForegroundSnapshot();
     int count = 0;
 
     for (size_t circIdx = pFrameCount % pCircSize;
@@ -1402,16 +1621,16 @@ protected:
          (pLatencySched.pCircFrCnt2Timestamp[circIdx] > lstat.lastupdate -
           pPublishToPenaltyDelayMs);
          circIdx = ((pCircSize + circIdx - 1) % pCircSize)) {
-      if (entry->foregroundFastStruct->proxyAccessTree->pNodes[idx].fsData.dlScore >
+      if (fg->proxyAccessTree->pNodes[idx].fsData.dlScore >
           0)
-        applyDlScorePenalty(entry, idx,
+        applyDlScorePenalty(entry->backgroundFastStruct, idx,
                             pPenaltySched.pCircFrCnt2HostPenalties[circIdx][host].dlScorePenalty,
                             true
                            );
 
-      if (entry->foregroundFastStruct->proxyAccessTree->pNodes[idx].fsData.ulScore >
+      if (fg->proxyAccessTree->pNodes[idx].fsData.ulScore >
           0)
-        applyUlScorePenalty(entry, idx,
+        applyUlScorePenalty(entry->backgroundFastStruct, idx,
                             pPenaltySched.pCircFrCnt2HostPenalties[circIdx][host].ulScorePenalty,
                             true
                            );
@@ -1809,8 +2028,29 @@ protected:
     regular,    // give priority to the closer and more idle proxy in a proxygroup
     any         // do the regular scheduling for all the filesystems
   } tProxySchedType;
+  // ---------------------------------------------------------------------------
+  //! Place several replicas in one scheduling group whose fast structures are
+  //! already pinned by the caller - see placeNewReplicasOneGroup
+  // ---------------------------------------------------------------------------
+  bool placeNewReplicasPinned(SchedTME* entry, FastStructSched* fgStruct,
+                              const size_t& nNewReplicas,
+                              std::vector<eos::common::FileSystem::fsid_t>* newReplicas,
+                              ino64_t inode,
+                              std::vector<std::string>* dataProxys,
+                              std::vector<std::string>* firewallEntryPoints,
+                              SchedType type,
+                              std::vector<eos::common::FileSystem::fsid_t>* existingReplicas,
+                              std::vector<std::string>* fsidsgeotags,
+                              unsigned long long bookingSize,
+                              const std::string& startFromGeoTag,
+                              const std::string& clientGeoTag,
+                              const size_t& nCollocatedReplicas,
+                              std::vector<eos::common::FileSystem::fsid_t>* excludeFs,
+                              std::vector<std::string>* excludeGeoTags,
+                              std::vector<std::string>* forceGeoTags);
+
   bool findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>& fsidxs,
-                 std::vector<SchedTME*> entries,
+                 const std::vector<FastStructSched*>& fgStructs,
                  ino64_t inode,
                  std::vector<std::string>* proxies,
                  std::vector<std::string>* proxyGroups = NULL,
@@ -1925,6 +2165,17 @@ public:
   // ---------------------------------------------------------------------------
   bool forceRefresh();
 
+  // ---------------------------------------------------------------------------
+  //! Get the generation of the file system states, incremented whenever a
+  //! file system is added or removed or changes its boot, active, config, drain
+  //! or error status. Lets callers caching scheduling decisions detect that
+  //! they may be stale.
+  // ---------------------------------------------------------------------------
+  inline uint64_t getFsStatusGeneration() const
+  {
+    return pFsStatusGeneration.load();
+  }
+
   // ---------------------------------------------------------------------------
   //! Insert a file system into the GeoTreeEngine
   // @param fs
@@ -2045,6 +2296,55 @@ public:
                                 std::vector<std::string>* excludeGeoTags = NULL,
                                 std::vector<std::string>* forceGeoTags = NULL);
 
+  // ---------------------------------------------------------------------------
+  //! Placement request of one file in a batch
+  // ---------------------------------------------------------------------------
+  struct BatchPlacement {
+    //! inode of the file to place, used for filesticky proxy scheduling
+    ino64_t inode;
+    //! fsids of the new replicas, cleared if the placement fails
+    std::vector<eos::common::FileSystem::fsid_t>* newReplicas;
+    //! if non NULL, the proxys are scheduled as in placeNewReplicasOneGroup
+    std::vector<std::string>* dataProxys;
+    //! if non NULL, the firewall entry points are scheduled as well
+    std::vector<std::string>* firewallEntryPoint;
+
+    BatchPlacement() :
+      inode(0), newReplicas(NULL), dataProxys(NULL), firewallEntryPoint(NULL)
+    {}
+  };
+
+  // ---------------------------------------------------------------------------
+  //! Place several new files with the same layout in one scheduling group.
+  //! The group is looked up and its fast structures are pinned only once for
+  //! all the files. The files are placed one after the other on the same
+  //! snapshot so the penalties of a placement are seen by the next one.
+  // @param group
+  //   the group to place the files in
+  // @param nNewReplicas
+  //   the number of replicas to be placed for each file
+  // @param requests
+  //   the placement requests
+  // @param first
+  //   index of the first request to place
+  // @param count
+  //   number of requests to place
+  // @param type, bookingSize, startFromGeoTag, clientGeoTag, nCollocatedReplicas
+  //   see placeNewReplicasOneGroup
+  // @return
+  //   number of requests placed starting from first. The placement stops at
+  //   the first file which can not be placed in the group.
+  // ---------------------------------------------------------------------------
+  size_t placeNewReplicasOneGroupBatch(FsGroup* group,
+                                       const size_t& nNewReplicas,
+                                       std::vector<BatchPlacement>& requests,
+                                       size_t first, size_t count,
+                                       SchedType type,
+                                       unsigned long long bookingSize = 0,
+                                       const std::string& startFromGeoTag = "",
+                                       const std::string& clientGeoTag = "",
+                                       const size_t& nCollocatedReplicas = 0);
+
   // ---------------------------------------------------------------------------
   //! Access several replicas in one scheduling group.
   // @param group
@@ -34,6 +34,7 @@
 #include "XrdSys/XrdSysError.hh"
 #include "XrdOuc/XrdOucTrace.hh"
 #include "Xrd/XrdScheduler.hh"
+#include <algorithm>
 #include <random>
 #include <cmath>
 
@@ -53,7 +54,8 @@ EOSMGMNAMESPACE_BEGIN
 /*----------------------------------------------------------------------------*/
 GroupBalancer::GroupBalancer(const char* spacename)
   : mThreshold(.5),
-    mAvgUsedSize(0)
+    mAvgUsedSize(0),
+    mMinFileSize(0)
 {
   mSpaceName = spacename;
   mLastCheck = 0;
@@ -437,63 +439,46 @@ GroupBalancer::scheduleTransfer(eos::common::FileId::fileid_t fid,
 
 /*----------------------------------------------------------------------------*/
 /**
- * @brief Chooses a random file ID from a random filesystem in the given group
+ * @brief Chooses the biggest file fitting the size limits from a random
+ *        filesystem in the given group
  * @param group the group from which the file id will be chosen
+ * @param max_size max size of the file, 0 for no limit
  * @return the chosen file ID
  */
 /*----------------------------------------------------------------------------*/
 eos::common::FileId::fileid_t
-GroupBalancer::chooseFidFromGroup(FsGroup* group)
+GroupBalancer::chooseFidFromGroup(FsGroup* group, uint64_t max_size)
 {
   int rndIndex;
-  bool found = false;
-  uint64_t fsid_size = 0ull;
-  eos::common::FileSystem::fsid_t fsid = 0;
-  eos::common::RWMutexReadLock vlock(FsView::gFsView.ViewMutex);
-  eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
-  // TODO(gbitzes): Add prefetching, make more efficient.
-  std::vector<int> validFsIndexes(group->size());
-
-  for (size_t i = 0; i < group->size(); i++) {
-    validFsIndexes[i] = (int) i;
-  }
-
-  eos::mgm::BaseView::const_iterator fs_it;
-
-  while (validFsIndexes.size() > 0) {
-    fs_it = group->begin();
-    fsid = *fs_it;
-    rndIndex = getRandom(validFsIndexes.size() - 1);
-    std::advance(fs_it, validFsIndexes[rndIndex]);
-
-    // Accept only active file systems
-    if (FsView::gFsView.mIdView[fsid]->GetActiveStatus() ==
-        eos::common::FileSystem::kOnline) {
-      fsid_size = gOFS->eosFsView->getNumFilesOnFs(fsid);
+  std::vector<eos::common::FileSystem::fsid_t> validFs;
+  {
+    eos::common::RWMutexReadLock vlock(FsView::gFsView.ViewMutex);
 
-      if (fsid_size) {
-        found = true;
-        break;
+    for (auto fs_it = group->begin(); fs_it != group->end(); ++fs_it) {
+      // Accept only active file systems
+      if (FsView::gFsView.mIdView[*fs_it]->GetActiveStatus() ==
+          eos::common::FileSystem::kOnline) {
+        validFs.push_back(*fs_it);
       }
     }
-
-    validFsIndexes.erase(validFsIndexes.begin() + rndIndex);
   }
-
-  // Check if we have any files to transfer
-  if (!found) {
-    return -1;
-  }
-
-  int attempts = 10;
-
-  while (attempts-- > 0) {
-    eos::IFileMD::id_t randomPick;
-
-    if (gOFS->eosFsView->getApproximatelyRandomFileInFs(fsid, randomPick) &&
-        mTransfers.count(randomPick) == 0) {
-      return randomPick;
+  auto is_scheduled = [this](uint64_t fid) {
+    return (mTransfers.count(fid) != 0);
+  };
+
+  while (validFs.size() > 0) {
+    rndIndex = getRandom(validFs.size() - 1);
+    eos::common::FileSystem::fsid_t fsid = validFs[rndIndex];
+    uint64_t fid = 0;
+
+    // Sample the next page of the file list of the filesystem and take the
+    // biggest sampled file so that every transfer moves as many bytes as
+    // possible
+    if (mSizeIndex.Choose(fsid, mMinFileSize, max_size, is_scheduled, fid)) {
+      return fid;
     }
+
+    validFs.erase(validFs.begin() + rndIndex);
   }
 
   return -1;
@@ -552,7 +537,19 @@ GroupBalancer::prepareTransfer()
     return;
   }
 
-  eos::common::FileId::fileid_t fid = chooseFidFromGroup(fromGroup);
+  // Don't move more than the source has over and the target has under the
+  // average
+  uint64_t max_size = 0;
+
+  if (mGroupSizes.count(fromGroup->mName) && mGroupSizes.count(toGroup->mName)) {
+    GroupSize* fromSize = mGroupSizes[fromGroup->mName];
+    GroupSize* toSize = mGroupSizes[toGroup->mName];
+    double over = (fromSize->filled() - mAvgUsedSize) * fromSize->capacity();
+    double under = (mAvgUsedSize - toSize->filled()) * toSize->capacity();
+    max_size = (uint64_t) std::max(1.0, std::min(over, under));
+  }
+
+  eos::common::FileId::fileid_t fid = chooseFidFromGroup(fromGroup, max_size);
 
   if ((int) fid == -1) {
     eos_static_info("Couldn't choose any FID to schedule: failedgroup=%s",
@@ -651,10 +648,18 @@ GroupBalancer::GroupBalance()
       }
 
       isSpaceGroupBalancer = space->GetConfigMember("groupbalancer") == "on";
+
+      // The balance planner takes over the balancing of the space
+      if (space->GetConfigMember("planner") == "on") {
+        isSpaceGroupBalancer = false;
+      }
+
       nrTransfers = atoi(space->GetConfigMember("groupbalancer.ntx").c_str());
       mThreshold =
         atof(space->GetConfigMember("groupbalancer.threshold").c_str());
       mThreshold /= 100.0;
+      std::string minsize = space->GetConfigMember("groupbalancer.file.minsize");
+      mMinFileSize = strtoull(minsize.c_str(), 0, 10);
       FsView::gFsView.ViewMutex.UnLockRead();
     }
     isMaster = gOFS->mMaster->IsMaster();
@@ -25,6 +25,7 @@
 #define __EOSMGM_GROUPBALANCER__
 
 #include "mgm/Namespace.hh"
+#include "mgm/FsSizeIndex.hh"
 #include "common/FileId.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include <vector>
@@ -113,11 +114,17 @@ private:
   /// transfers scheduled (maps files' ids with their path in proc)
   std::map<eos::common::FileId::fileid_t, std::string> mTransfers;
 
+  /// size bucketed samples of the files of the filesystems
+  FsSizeIndex mSizeIndex;
+  /// min size of the files to move
+  uint64_t mMinFileSize;
+
   std::string getFileProcTransferNameAndSize(eos::common::FileId::fileid_t fid,
       FsGroup* group,
       uint64_t* size);
 
-  eos::common::FileId::fileid_t chooseFidFromGroup(FsGroup* group);
+  eos::common::FileId::fileid_t chooseFidFromGroup(FsGroup* group,
+      uint64_t max_size);
 
   void populateGroupsInfo(void);
 
@@ -0,0 +1,583 @@
+//------------------------------------------------------------------------------
+// File: HotFileReplicator.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/HotFileReplicator.hh"
+#include "common/FileId.hh"
+#include "common/LayoutId.hh"
+#include "common/Logging.hh"
+#include "common/StringConversion.hh"
+#include "mgm/FsView.hh"
+#include "mgm/IMaster.hh"
+#include "mgm/XrdMgmOfs.hh"
+#include "mgm/XrdMgmOfsDirectory.hh"
+#include "mgm/proc/ProcCommand.hh"
+#include "namespace/Prefetcher.hh"
+#include "namespace/interface/IView.hh"
+#include <cstdlib>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+HotFileReplicator::HotFileReplicator()
+{
+  eos::common::Mapping::Root(mRootVid);
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+HotFileReplicator::~HotFileReplicator()
+{
+  Stop();
+}
+
+//------------------------------------------------------------------------------
+// Start the replicator thread
+//------------------------------------------------------------------------------
+bool
+HotFileReplicator::Start()
+{
+  mThread.reset(&HotFileReplicator::Run, this);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Stop the replicator thread
+//------------------------------------------------------------------------------
+void
+HotFileReplicator::Stop()
+{
+  mThread.join();
+}
+
+//------------------------------------------------------------------------------
+// Add the entries of a stat.ropen.hotio value
+//------------------------------------------------------------------------------
+void
+HotFileReplicator::ParseHotIo(const std::string& hotio,
+                              std::map<uint64_t, Heat>& heat)
+{
+  std::vector<std::string> entries;
+  eos::common::StringConversion::Tokenize(hotio, entries);
+
+  for (const auto& entry : entries) {
+    std::string rate, iops_hexfid, iops, hexfid;
+
+    if (!eos::common::StringConversion::SplitKeyValue(entry, rate, iops_hexfid) ||
+        !eos::common::StringConversion::SplitKeyValue(iops_hexfid, iops, hexfid)) {
+      continue;
+    }
+
+    uint64_t fid = eos::common::FileId::Hex2Fid(hexfid.c_str());
+
+    if (!fid) {
+      continue;
+    }
+
+    double value = strtod(rate.c_str(), nullptr);
+    Heat& file_heat = heat[fid];
+    file_heat.mTotalRate += value;
+
+    if (value > file_heat.mMaxRate) {
+      file_heat.mMaxRate = value;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add the entries of a stat.ropen.hotfiles value
+//------------------------------------------------------------------------------
+void
+HotFileReplicator::ParseHotFiles(const std::string& hotfiles,
+                                 std::map<uint64_t, Heat>& heat)
+{
+  std::vector<std::string> entries;
+  eos::common::StringConversion::Tokenize(hotfiles, entries);
+
+  for (const auto& entry : entries) {
+    std::string opens, hexfid;
+
+    if (!eos::common::StringConversion::SplitKeyValue(entry, opens, hexfid)) {
+      continue;
+    }
+
+    uint64_t fid = eos::common::FileId::Hex2Fid(hexfid.c_str());
+
+    if (!fid) {
+      continue;
+    }
+
+    uint64_t value = strtoull(opens.c_str(), nullptr, 10);
+    Heat& file_heat = heat[fid];
+    file_heat.mTotalOpens += value;
+
+    if (value > file_heat.mMaxOpens) {
+      file_heat.mMaxOpens = value;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check if a file is a hot spot on one of its filesystems
+//------------------------------------------------------------------------------
+bool
+HotFileReplicator::IsHot(const Heat& heat, const Settings& settings)
+{
+  return ((settings.mRate > 0) && (heat.mMaxRate >= settings.mRate)) ||
+         (settings.mOpens && (heat.mMaxOpens >= settings.mOpens));
+}
+
+//------------------------------------------------------------------------------
+// Decide which files get a replica more and which cool down
+//------------------------------------------------------------------------------
+void
+HotFileReplicator::Plan(const std::map<uint64_t, Heat>& heat,
+                        const Settings& settings, time_t now,
+                        std::set<uint64_t>& grow, std::set<uint64_t>& shrink)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (auto& elem : mPromoted) {
+    Promoted& promoted = elem.second;
+    auto it = heat.find(elem.first);
+
+    if (it != heat.end()) {
+      // Still loaded if the original replicas would still be hot spots
+      uint32_t orig = (promoted.mOrigStripes ? promoted.mOrigStripes : 1);
+      bool loaded = ((settings.mRate > 0) &&
+                     (it->second.mTotalRate / orig >= settings.mRate / 2)) ||
+                    (settings.mOpens &&
+                     (2 * it->second.mTotalOpens >= settings.mOpens * orig));
+
+      if (loaded) {
+        promoted.mLastHot = now;
+      }
+    }
+
+    if (!settings.mEnabled || (now - promoted.mLastHot >= settings.mCooldown)) {
+      shrink.insert(elem.first);
+    }
+  }
+
+  if (!settings.mEnabled) {
+    return;
+  }
+
+  for (const auto& elem : heat) {
+    if (!IsHot(elem.second, settings) || shrink.count(elem.first)) {
+      continue;
+    }
+
+    auto it = mPromoted.find(elem.first);
+
+    if (it == mPromoted.end()) {
+      grow.insert(elem.first);
+    } else if ((it->second.mStripes < it->second.mOrigStripes +
+                settings.mMaxExtra) &&
+               (now - it->second.mLastChange >= kSettleTime)) {
+      grow.insert(elem.first);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Record that a file has now the given number of replicas
+//------------------------------------------------------------------------------
+void
+HotFileReplicator::SetPromoted(uint64_t fid, uint32_t orig_stripes,
+                               uint32_t stripes, time_t now)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  Promoted& promoted = mPromoted[fid];
+  promoted.mOrigStripes = orig_stripes;
+  promoted.mStripes = stripes;
+  promoted.mLastHot = now;
+  promoted.mLastChange = now;
+}
+
+//------------------------------------------------------------------------------
+// Forget a promoted file
+//------------------------------------------------------------------------------
+void
+HotFileReplicator::Forget(uint64_t fid)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mPromoted.erase(fid);
+}
+
+//------------------------------------------------------------------------------
+// Get a copy of the promoted files
+//------------------------------------------------------------------------------
+std::map<uint64_t, HotFileReplicator::Promoted>
+HotFileReplicator::GetPromoted() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mPromoted;
+}
+
+//------------------------------------------------------------------------------
+// Replicator thread loop
+//------------------------------------------------------------------------------
+void
+HotFileReplicator::Run(ThreadAssistant& assistant) noexcept
+{
+  gOFS->WaitUntilNamespaceIsBooted(assistant);
+  eos_static_info("%s", "msg=\"hot file replicator started\"");
+
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(std::chrono::seconds(kIntervalSec));
+
+    if (assistant.terminationRequested()) {
+      break;
+    }
+
+    if (!gOFS->mMaster->IsMaster()) {
+      // A new master reloads the state from the proc directory
+      std::lock_guard<std::mutex> lock(mMutex);
+      mPromoted.clear();
+      mLoaded = false;
+      continue;
+    }
+
+    time_t now = time(NULL);
+
+    if (!mLoaded) {
+      LoadPromoted(now);
+      mLoaded = true;
+    }
+
+    Settings settings = GetSettings();
+
+    if (!settings.mEnabled && GetPromoted().empty()) {
+      continue;
+    }
+
+    std::map<uint64_t, Heat> heat;
+
+    if (settings.mEnabled) {
+      heat = CollectHeat();
+    }
+
+    std::set<uint64_t> grow;
+    std::set<uint64_t> shrink;
+    Plan(heat, settings, now, grow, shrink);
+
+    for (auto fid : shrink) {
+      Shrink(fid);
+    }
+
+    for (auto fid : grow) {
+      Grow(fid, settings, now);
+    }
+
+    eos_static_debug("msg=\"hot file replicator cycle\" hot=%lu grow=%lu "
+                     "shrink=%lu", heat.size(), grow.size(), shrink.size());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Read the configuration of the default space
+//------------------------------------------------------------------------------
+HotFileReplicator::Settings
+HotFileReplicator::GetSettings()
+{
+  Settings settings;
+  eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+  auto it = FsView::gFsView.mSpaceView.find("default");
+
+  if (it == FsView::gFsView.mSpaceView.end()) {
+    return settings;
+  }
+
+  FsSpace* space = it->second;
+  settings.mEnabled = (space->GetConfigMember("hotreplica") == "on");
+  settings.mRate = strtod(space->GetConfigMember("hotreplica.rate").c_str(),
+                          nullptr);
+  settings.mOpens = strtoull(space->GetConfigMember("hotreplica.opens").c_str(),
+                             nullptr, 10);
+  std::string value = space->GetConfigMember("hotreplica.max");
+
+  if (value.length()) {
+    settings.mMaxExtra = strtoul(value.c_str(), nullptr, 10);
+  }
+
+  value = space->GetConfigMember("hotreplica.cooldown");
+
+  if (value.length()) {
+    settings.mCooldown = strtoll(value.c_str(), nullptr, 10);
+  }
+
+  if ((settings.mRate <= 0) && !settings.mOpens) {
+    // Nothing would ever be hot
+    settings.mEnabled = false;
+  }
+
+  return settings;
+}
+
+//------------------------------------------------------------------------------
+// Collect the load of the hot files published by all filesystems
+//------------------------------------------------------------------------------
+std::map<uint64_t, HotFileReplicator::Heat>
+HotFileReplicator::CollectHeat()
+{
+  std::map<uint64_t, Heat> heat;
+  eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+
+  for (auto it = FsView::gFsView.mIdView.begin();
+       it != FsView::gFsView.mIdView.end(); ++it) {
+    FileSystem* fs = it->second;
+
+    // Only consider recent reports, like 'eos io ns -f'
+    if (fs->GetAge("stat.ropen.hotio") <= 60) {
+      ParseHotIo(fs->GetString("stat.ropen.hotio"), heat);
+    }
+
+    if (fs->GetAge("stat.ropen.hotfiles") <= 60) {
+      ParseHotFiles(fs->GetString("stat.ropen.hotfiles"), heat);
+    }
+  }
+
+  return heat;
+}
+
+//------------------------------------------------------------------------------
+// Reload the promoted files from the proc directory
+//------------------------------------------------------------------------------
+void
+HotFileReplicator::LoadPromoted(time_t now)
+{
+  XrdMgmOfsDirectory dir;
+
+  if (dir.open(gOFS->MgmProcHotReplicaPath.c_str(), mRootVid,
+               (const char*) 0) != SFS_OK) {
+    return;
+  }
+
+  const char* val;
+
+  while ((val = dir.nextEntry())) {
+    std::string entry = val;
+    std::string hexfid, stripes;
+
+    if ((entry == ".") || (entry == "..")) {
+      continue;
+    }
+
+    if (eos::common::StringConversion::SplitKeyValue(entry, hexfid, stripes) &&
+        (hexfid.length() == 16)) {
+      uint64_t fid = eos::common::FileId::Hex2Fid(hexfid.c_str());
+      uint32_t orig_stripes = strtoul(stripes.c_str(), nullptr, 10);
+
+      if (fid && orig_stripes) {
+        // The current number of replicas is only needed to grow further and
+        // that waits for the settle time anyway
+        SetPromoted(fid, orig_stripes, orig_stripes + 1, now);
+        continue;
+      }
+    }
+
+    eos_static_warning("msg=\"dropping invalid hot replica entry\" name=\"%s\"",
+                       val);
+    std::string path = gOFS->MgmProcHotReplicaPath.c_str();
+    path += "/";
+    path += entry;
+    gOFS->_rem(path.c_str(), mError, mRootVid, (const char*) 0);
+  }
+
+  dir.close();
+  eos_static_info("msg=\"loaded promoted hot files\" count=%lu",
+                  GetPromoted().size());
+}
+
+//------------------------------------------------------------------------------
+// Add a replica to a file
+//------------------------------------------------------------------------------
+void
+HotFileReplicator::Grow(uint64_t fid, const Settings& settings, time_t now)
+{
+  std::string path;
+  unsigned long lid = 0;
+
+  try {
+    eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, fid);
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+    std::shared_ptr<eos::IFileMD> fmd = gOFS->eosFileService->getFileMD(fid);
+    path = gOFS->eosView->getUri(fmd.get());
+    lid = fmd->getLayoutId();
+  } catch (eos::MDException& e) {
+    eos_static_debug("msg=\"hot file vanished\" fxid=%08llx", fid);
+    return;
+  }
+
+  if ((eos::common::LayoutId::GetLayoutType(lid) !=
+       eos::common::LayoutId::kReplica) &&
+      (eos::common::LayoutId::GetLayoutType(lid) !=
+       eos::common::LayoutId::kPlain)) {
+    return;
+  }
+
+  // Never touch the files of the proc tree, e.g. conversion temporaries
+  if (path.compare(0, gOFS->MgmProcPath.length(), gOFS->MgmProcPath.c_str()) ==
+      0) {
+    return;
+  }
+
+  uint32_t stripes = eos::common::LayoutId::GetStripeNumber(lid) + 1;
+  uint32_t orig_stripes = stripes;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mPromoted.find(fid);
+
+    if (it != mPromoted.end()) {
+      orig_stripes = it->second.mOrigStripes;
+    }
+  }
+
+  if ((stripes >= orig_stripes + settings.mMaxExtra) ||
+      (stripes > eos::common::LayoutId::kSixteenStripe)) {
+    return;
+  }
+
+  if (orig_stripes == stripes) {
+    // Record the promotion first so that the replicas are removed again even
+    // if the MGM restarts in between
+    if (gOFS->_touch(GetProcEntry(fid, orig_stripes).c_str(), mError, mRootVid,
+                     0)) {
+      eos_static_err("msg=\"cannot create hot replica entry\" fxid=%08llx",
+                     fid);
+      return;
+    }
+  }
+
+  if (!SetStripes(path, stripes + 1, true)) {
+    if (orig_stripes == stripes) {
+      gOFS->_rem(GetProcEntry(fid, orig_stripes).c_str(), mError, mRootVid,
+                 (const char*) 0);
+    }
+
+    return;
+  }
+
+  SetPromoted(fid, orig_stripes, stripes + 1, now);
+  eos_static_notice("msg=\"added hot file replica\" fxid=%08llx path=\"%s\" "
+                    "replicas=%u original=%u", fid, path.c_str(), stripes + 1,
+                    orig_stripes);
+}
+
+//------------------------------------------------------------------------------
+// Bring a file back to its original number of replicas
+//------------------------------------------------------------------------------
+void
+HotFileReplicator::Shrink(uint64_t fid)
+{
+  uint32_t orig_stripes = 0;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mPromoted.find(fid);
+
+    if (it == mPromoted.end()) {
+      return;
+    }
+
+    orig_stripes = it->second.mOrigStripes;
+  }
+  std::string path;
+
+  try {
+    eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, fid);
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+    path = gOFS->eosView->getUri(gOFS->eosFileService->getFileMD(fid).get());
+  } catch (eos::MDException& e) {
+    // Deleted meanwhile, nothing to restore
+  }
+
+  if (path.length() && !SetStripes(path, orig_stripes, false)) {
+    // Retry in the next cycle
+    return;
+  }
+
+  gOFS->_rem(GetProcEntry(fid, orig_stripes).c_str(), mError, mRootVid,
+             (const char*) 0);
+  Forget(fid);
+  eos_static_notice("msg=\"removed hot file replicas\" fxid=%08llx path=\"%s\" "
+                    "replicas=%u", fid, path.c_str(), orig_stripes);
+}
+
+//------------------------------------------------------------------------------
+// Change the number of replicas of a file and adjust its replicas
+//------------------------------------------------------------------------------
+bool
+HotFileReplicator::SetStripes(const std::string& path, uint32_t stripes,
+                              bool nodrop)
+{
+  auto run = [&](const std::string & info) {
+    XrdOucString out;
+    XrdOucString err;
+    ProcCommand cmd;
+    cmd.open("/proc/user", info.c_str(), mRootVid, &mError);
+    cmd.AddOutput(out, err);
+    int retc = cmd.close();
+
+    if (retc) {
+      eos_static_err("msg=\"hot file replica command failed\" cmd=\"%s\" "
+                     "retc=%d err=\"%s\"", info.c_str(), retc, err.c_str());
+    }
+
+    return (retc == 0);
+  };
+  std::string info = "mgm.cmd=file&mgm.subcmd=layout&mgm.path=";
+  info += path;
+  info += "&mgm.file.layout.stripes=";
+  info += std::to_string(stripes);
+
+  if (!run(info)) {
+    return false;
+  }
+
+  info = "mgm.cmd=file&mgm.subcmd=adjustreplica&mgm.path=";
+  info += path;
+  info += "&mgm.format=fuse";
+
+  if (nodrop) {
+    info += "&mgm.file.option=nodrop";
+  }
+
+  return run(info);
+}
+
+//------------------------------------------------------------------------------
+// Proc entry of a promoted file
+//------------------------------------------------------------------------------
+std::string
+HotFileReplicator::GetProcEntry(uint64_t fid, uint32_t orig_stripes)
+{
+  char entry[4096];
+  snprintf(entry, sizeof(entry), "%s/%016llx:%u",
+           gOFS->MgmProcHotReplicaPath.c_str(), (unsigned long long) fid,
+           orig_stripes);
+  return entry;
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,213 @@
+//------------------------------------------------------------------------------
+//! @file HotFileReplicator.hh
+//! @brief Temporary extra replicas for files read from a hot spot
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/AssistedThread.hh"
+#include "common/Mapping.hh"
+#include "XrdOuc/XrdOucErrInfo.hh"
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Service adding replicas to files which make one filesystem a hot
+//! spot and removing them once the files cooled down
+//!
+//! The FSTs publish per filesystem the files with the most open readers
+//! (stat.ropen.hotfiles) and with the highest read rate (stat.ropen.hotio).
+//! A replica layout file is hot when one of its filesystems serves it above
+//! the configured rate or number of readers. Hot files get one more stripe per
+//! cycle, up to a maximum of extra replicas, through 'file layout' and
+//! 'file adjustreplica' so that the new replicas are placed by the scheduler
+//! like any other. A file stays promoted as long as its total load spread over
+//! its original number of replicas is above half of the threshold; after the
+//! cool down period without load it goes back to its original number of
+//! replicas and the extra ones are dropped by adjustreplica. Promoted files
+//! are recorded as <fxid(016x)>:<stripes> entries in the proc hotreplica
+//! directory so that a restarted MGM cools them down too.
+//!
+//! Configured by the default space: hotreplica=on|off, hotreplica.rate
+//! (bytes/s), hotreplica.opens, hotreplica.max and hotreplica.cooldown (s).
+//------------------------------------------------------------------------------
+class HotFileReplicator
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Load of a file over all its filesystems
+  //----------------------------------------------------------------------------
+  struct Heat {
+    double mMaxRate {0}; ///< highest read rate on one filesystem in bytes/s
+    double mTotalRate {0}; ///< read rate summed over the filesystems
+    uint64_t mMaxOpens {0}; ///< most readers on one filesystem
+    uint64_t mTotalOpens {0}; ///< readers summed over the filesystems
+  };
+
+  //----------------------------------------------------------------------------
+  //! Configuration taken from the default space
+  //----------------------------------------------------------------------------
+  struct Settings {
+    bool mEnabled {false};
+    double mRate {0}; ///< per filesystem read rate making a file hot, 0 = off
+    uint64_t mOpens {0}; ///< per filesystem readers making a file hot, 0 = off
+    uint32_t mMaxExtra {2}; ///< maximum number of extra replicas
+    time_t mCooldown {3600}; ///< seconds without load before the extras go
+  };
+
+  //----------------------------------------------------------------------------
+  //! State of a promoted file
+  //----------------------------------------------------------------------------
+  struct Promoted {
+    uint32_t mOrigStripes {0}; ///< number of replicas before the promotion
+    uint32_t mStripes {0}; ///< current number of replicas
+    time_t mLastHot {0}; ///< last time the file was seen loaded
+    time_t mLastChange {0}; ///< last time a replica was added
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  HotFileReplicator();
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~HotFileReplicator();
+
+  //----------------------------------------------------------------------------
+  //! Start the replicator thread
+  //----------------------------------------------------------------------------
+  bool Start();
+
+  //----------------------------------------------------------------------------
+  //! Stop the replicator thread
+  //----------------------------------------------------------------------------
+  void Stop();
+
+  //----------------------------------------------------------------------------
+  //! Add the entries of a stat.ropen.hotio value, <bytes/s>:<iops>:<hexfid>
+  //----------------------------------------------------------------------------
+  static void ParseHotIo(const std::string& hotio,
+                         std::map<uint64_t, Heat>& heat);
+
+  //----------------------------------------------------------------------------
+  //! Add the entries of a stat.ropen.hotfiles value, <opens>:<hexfid>
+  //----------------------------------------------------------------------------
+  static void ParseHotFiles(const std::string& hotfiles,
+                            std::map<uint64_t, Heat>& heat);
+
+  //----------------------------------------------------------------------------
+  //! Check if a file is a hot spot on one of its filesystems
+  //----------------------------------------------------------------------------
+  static bool IsHot(const Heat& heat, const Settings& settings);
+
+  //----------------------------------------------------------------------------
+  //! Decide which files get a replica more and which go back to their
+  //! original number of replicas, refreshes the load time of promoted files
+  //!
+  //! @param heat load of the files which were published as hot
+  //! @param settings current configuration
+  //! @param now current time
+  //! @param grow files which need a replica more
+  //! @param shrink files which cooled down
+  //----------------------------------------------------------------------------
+  void Plan(const std::map<uint64_t, Heat>& heat, const Settings& settings,
+            time_t now, std::set<uint64_t>& grow, std::set<uint64_t>& shrink);
+
+  //----------------------------------------------------------------------------
+  //! Record that a file has now the given number of replicas
+  //----------------------------------------------------------------------------
+  void SetPromoted(uint64_t fid, uint32_t orig_stripes, uint32_t stripes,
+                   time_t now);
+
+  //----------------------------------------------------------------------------
+  //! Forget a promoted file
+  //----------------------------------------------------------------------------
+  void Forget(uint64_t fid);
+
+  //----------------------------------------------------------------------------
+  //! Get a copy of the promoted files
+  //----------------------------------------------------------------------------
+  std::map<uint64_t, Promoted> GetPromoted() const;
+
+private:
+  //! Minimum time between two replicas added to the same file, leaves time to
+  //! the new replica to be created and to take over part of the load
+  static constexpr time_t kSettleTime = 120;
+  //! Interval between two evaluations
+  static constexpr int kIntervalSec = 60;
+
+  //----------------------------------------------------------------------------
+  //! Replicator thread loop
+  //----------------------------------------------------------------------------
+  void Run(ThreadAssistant& assistant) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Read the configuration of the default space
+  //----------------------------------------------------------------------------
+  static Settings GetSettings();
+
+  //----------------------------------------------------------------------------
+  //! Collect the load of the hot files published by all filesystems
+  //----------------------------------------------------------------------------
+  static std::map<uint64_t, Heat> CollectHeat();
+
+  //----------------------------------------------------------------------------
+  //! Reload the promoted files from the proc directory
+  //----------------------------------------------------------------------------
+  void LoadPromoted(time_t now);
+
+  //----------------------------------------------------------------------------
+  //! Add a replica to a file
+  //----------------------------------------------------------------------------
+  void Grow(uint64_t fid, const Settings& settings, time_t now);
+
+  //----------------------------------------------------------------------------
+  //! Bring a file back to its original number of replicas
+  //----------------------------------------------------------------------------
+  void Shrink(uint64_t fid);
+
+  //----------------------------------------------------------------------------
+  //! Change the number of replicas of a file and adjust its replicas
+  //----------------------------------------------------------------------------
+  bool SetStripes(const std::string& path, uint32_t stripes, bool nodrop);
+
+  //----------------------------------------------------------------------------
+  //! Proc entry of a promoted file
+  //----------------------------------------------------------------------------
+  static std::string GetProcEntry(uint64_t fid, uint32_t orig_stripes);
+
+  AssistedThread mThread; ///< replicator thread
+  eos::common::Mapping::VirtualIdentity mRootVid; ///< we operate as root
+  XrdOucErrInfo mError; ///< error object of the namespace calls
+  mutable std::mutex mMutex; ///< protects mPromoted
+  std::map<uint64_t, Promoted> mPromoted; ///< files with extra replicas
+  bool mLoaded {false}; ///< proc entries were loaded
+};
+
+EOSMGMNAMESPACE_END
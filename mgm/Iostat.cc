@@ -43,9 +43,21 @@ const char* Iostat::gIostatReportNamespace = "iostat::reportnamespace";
 const char* Iostat::gIostatPopularity = "iostat::popularity";
 const char* Iostat::gIostatUdpTargetList = "iostat::udptargets";
 FILE* Iostat::gOpenReportFD = 0;
+const char* Iostat::gReportTags[Iostat::kReportTags] = {
+  "bytes_read", "bytes_written", "read_calls", "readv_calls", "write_calls",
+  "fwd_seeks", "bwd_seeks", "xl_fwd_seeks", "xl_bwd_seeks", "bytes_fwd_seek",
+  "bytes_bwd_wseek", "bytes_xl_fwd_seek", "bytes_xl_bwd_wseek",
+  "disk_time_read", "disk_time_write", "bytes_deleted", "files_deleted"
+};
 
 /* ------------------------------------------------------------------------- */
-Iostat::Iostat()
+constexpr size_t Iostat::kParseThreads;
+constexpr size_t Iostat::kMaxReportQueue;
+
+/* ------------------------------------------------------------------------- */
+Iostat::Iostat() : mDelta(kReportTags), mReportsReceived(0),
+  mReportBatches(0), mReportsDropped(0),
+  mParsePool(1, kParseThreads, 10, 6, 64, "iostat")
 {
   mRunning = false;
   mInit = false;
@@ -96,6 +108,7 @@ Iostat::StartCirculate()
   // We have to do after the name of the dump file was set, therefore the
   // StartCirculate is an extra call
   mCirculateThread.reset(&Iostat::Circulate, this);
+  mReportWriterThread.reset(&Iostat::WriteReports, this);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -133,7 +146,11 @@ Iostat::ApplyIostatConfig()
     for (size_t i = 0; i < hostlist.size(); i++) {
       AddUdpTarget(hostlist[i].c_str(), false);
     }
+
+    mMetricsPush.SetTargets(mUdpPopularityTargetList.c_str());
   }
+
+  FsView::gFsView.BroadcastMonitoringTargets(mMetricsPush.GetTargets());
 }
 
 /* ------------------------------------------------------------------------- */
@@ -201,262 +218,337 @@ Iostat::~Iostat()
 {
   (void) Stop();
   mCirculateThread.join();
+  mReportWriterThread.join();
+
+  if (gOpenReportFD) {
+    fclose(gOpenReportFD);
+    gOpenReportFD = 0;
+  }
 }
 
 /* ------------------------------------------------------------------------- */
 void
 Iostat::Receive(ThreadAssistant& assistant) noexcept
 {
+  // maximum number of messages parsed and applied as one batch
+  static const size_t kMaxBatch = 1024;
+  std::vector<std::string> bodies;
+  bodies.reserve(kMaxBatch);
+
   while (!assistant.terminationRequested()) {
     XrdMqMessage* newmessage = 0;
 
     while ((newmessage = mClient.RecvMessage(&assistant))) {
       if (assistant.terminationRequested()) {
+        delete newmessage;
         break;
       }
 
-      XrdOucString body = newmessage->GetBody();
-
-      while (body.replace("&&", "&")) {
-      }
-
-      XrdOucEnv ioreport(body.c_str());
-      eos::common::Report* report = new eos::common::Report(ioreport);
-      Add("bytes_read", report->uid, report->gid, report->rb, report->ots,
-          report->cts);
-      Add("bytes_read", report->uid, report->gid, report->rvb_sum, report->ots,
-          report->cts);
-      Add("bytes_written", report->uid, report->gid, report->wb, report->ots,
-          report->cts);
-      Add("read_calls", report->uid, report->gid, report->nrc, report->ots,
-          report->cts);
-      Add("readv_calls", report->uid, report->gid, report->rv_op, report->ots,
-          report->cts);
-      Add("write_calls", report->uid, report->gid, report->nwc, report->ots,
-          report->cts);
-      Add("fwd_seeks", report->uid, report->gid, report->nfwds, report->ots,
-          report->cts);
-      Add("bwd_seeks", report->uid, report->gid, report->nbwds, report->ots,
-          report->cts);
-      Add("xl_fwd_seeks", report->uid, report->gid, report->nxlfwds, report->ots,
-          report->cts);
-      Add("xl_bwd_seeks", report->uid, report->gid, report->nxlbwds, report->ots,
-          report->cts);
-      Add("bytes_fwd_seek", report->uid, report->gid, report->sfwdb, report->ots,
-          report->cts);
-      Add("bytes_bwd_wseek", report->uid, report->gid, report->sbwdb, report->ots,
-          report->cts);
-      Add("bytes_xl_fwd_seek", report->uid, report->gid, report->sxlfwdb, report->ots,
-          report->cts);
-      Add("bytes_xl_bwd_wseek", report->uid, report->gid, report->sxlbwdb,
-          report->ots, report->cts);
-      Add("disk_time_read", report->uid, report->gid, (unsigned long long) report->rt,
-          report->ots, report->cts);
-      Add("disk_time_write", report->uid, report->gid,
-          (unsigned long long) report->wt, report->ots, report->cts);
-      {
-        // track deletions
-        time_t now = time(NULL);
-        Add("bytes_deleted", 0, 0, report->dsize, now - 30, now);
-        Add("files_deleted", 0, 0, 1, now - 30, now);
-      }
-      // do the UDP broadcasting here
-      {
-        XrdSysMutexHelper mLock(BroadcastMutex);
+      bodies.emplace_back(newmessage->GetBody());
+      delete newmessage;
 
-        if (mUdpPopularityTarget.size()) {
-          UdpBroadCast(report);
-        }
+      if (bodies.size() == kMaxBatch) {
+        ProcessBatch(bodies);
       }
+    }
 
-      // do the domain accounting here
-      if (report->path.substr(0, 11) == "/replicate:") {
-        // check if this is a replication path
-        // push into the 'eos' domain
-        Mutex.Lock();
+    // the queue is drained, publish what was accumulated
+    ProcessBatch(bodies);
+    MergeDelta(true);
+    assistant.wait_for(std::chrono::seconds(1));
+  }
+}
 
-        if (report->rb) {
-          IostatAvgDomainIOrb["eos"].Add(report->rb, report->ots, report->cts);
-        }
+/* ------------------------------------------------------------------------- */
+void
+Iostat::ProcessBatch(std::vector<std::string>& bodies)
+{
+  if (bodies.empty()) {
+    return;
+  }
 
-        if (report->wb) {
-          IostatAvgDomainIOwb["eos"].Add(report->wb, report->ots, report->cts);
+  // parse the reports in slices on the parse pool, the results are applied
+  // in the order they were received
+  static const size_t kMinSlice = 64;
+  size_t nslices = std::min(kParseThreads, (bodies.size() + kMinSlice - 1) /
+                            kMinSlice);
+  size_t slice = (bodies.size() + nslices - 1) / nslices;
+  std::vector<std::future<std::vector<eos::common::Report>>> parsed;
+
+  for (size_t begin = 0; begin < bodies.size(); begin += slice) {
+    size_t end = std::min(begin + slice, bodies.size());
+    std::function<std::vector<eos::common::Report>()> parse =
+    [&bodies, begin, end]() {
+      std::vector<eos::common::Report> reports;
+      reports.reserve(end - begin);
+
+      for (size_t i = begin; i < end; ++i) {
+        XrdOucString body = bodies[i].c_str();
+
+        while (body.replace("&&", "&")) {
         }
 
-        Mutex.UnLock();
-      } else {
-        bool dfound = false;
-
-        if (mReportPopularity) {
-          // do the popularity accounting here for everything which is not replication!
-          AddToPopularity(report->path, report->rb, report->ots, report->cts);
-        }
+        bodies[i] = body.c_str();
+        XrdOucEnv ioreport(body.c_str());
+        reports.emplace_back(ioreport);
+      }
 
-        size_t pos = 0;
+      return reports;
+    };
 
-        if ((pos = report->sec_domain.rfind(".")) != std::string::npos) {
-          // we can sort in by domain
-          std::string sdomain = report->sec_domain.substr(pos);
+    if (nslices > 1) {
+      parsed.push_back(mParsePool.PushTask(parse));
+    } else {
+      std::promise<std::vector<eos::common::Report>> promise;
+      promise.set_value(parse());
+      parsed.push_back(promise.get_future());
+    }
+  }
 
-          if (IoDomains.find(sdomain) != IoDomains.end()) {
-            Mutex.Lock();
+  size_t i = 0;
 
-            if (report->rb) {
-              IostatAvgDomainIOrb[sdomain].Add(report->rb, report->ots, report->cts);
-            }
+  for (auto& future : parsed) {
+    std::vector<eos::common::Report> reports = future.get();
 
-            if (report->wb) {
-              IostatAvgDomainIOwb[sdomain].Add(report->wb, report->ots, report->cts);
-            }
+    for (auto& report : reports) {
+      ProcessReport(&report, bodies[i++]);
+    }
+  }
 
-            Mutex.UnLock();
-            dfound = true;
-          }
-        }
+  mReportsReceived += bodies.size();
+  mReportBatches++;
+  bodies.clear();
+  MergeDelta(false);
+}
 
-        // do the node accounting here - keep the node list small !!!
-        std::set<std::string>::const_iterator nit;
+/* ------------------------------------------------------------------------- */
+void
+Iostat::ProcessReport(eos::common::Report* report, const std::string& body)
+{
+  mDelta.Add(kBytesRead, report->uid, report->gid, report->rb, report->ots,
+             report->cts);
+  mDelta.Add(kBytesRead, report->uid, report->gid, report->rvb_sum,
+             report->ots, report->cts);
+  mDelta.Add(kBytesWritten, report->uid, report->gid, report->wb,
+             report->ots, report->cts);
+  mDelta.Add(kReadCalls, report->uid, report->gid, report->nrc, report->ots,
+             report->cts);
+  mDelta.Add(kReadvCalls, report->uid, report->gid, report->rv_op,
+             report->ots, report->cts);
+  mDelta.Add(kWriteCalls, report->uid, report->gid, report->nwc,
+             report->ots, report->cts);
+  mDelta.Add(kFwdSeeks, report->uid, report->gid, report->nfwds,
+             report->ots, report->cts);
+  mDelta.Add(kBwdSeeks, report->uid, report->gid, report->nbwds,
+             report->ots, report->cts);
+  mDelta.Add(kXlFwdSeeks, report->uid, report->gid, report->nxlfwds,
+             report->ots, report->cts);
+  mDelta.Add(kXlBwdSeeks, report->uid, report->gid, report->nxlbwds,
+             report->ots, report->cts);
+  mDelta.Add(kBytesFwdSeek, report->uid, report->gid, report->sfwdb,
+             report->ots, report->cts);
+  mDelta.Add(kBytesBwdSeek, report->uid, report->gid, report->sbwdb,
+             report->ots, report->cts);
+  mDelta.Add(kBytesXlFwdSeek, report->uid, report->gid, report->sxlfwdb,
+             report->ots, report->cts);
+  mDelta.Add(kBytesXlBwdSeek, report->uid, report->gid, report->sxlbwdb,
+             report->ots, report->cts);
+  mDelta.Add(kDiskTimeRead, report->uid, report->gid,
+             (unsigned long long) report->rt, report->ots, report->cts);
+  mDelta.Add(kDiskTimeWrite, report->uid, report->gid,
+             (unsigned long long) report->wt, report->ots, report->cts);
+  {
+    // track deletions
+    time_t now = time(NULL);
+    mDelta.Add(kBytesDeleted, 0, 0, report->dsize, now - 30, now);
+    mDelta.Add(kFilesDeleted, 0, 0, 1, now - 30, now);
+  }
+  // do the UDP broadcasting here
+  {
+    XrdSysMutexHelper mLock(BroadcastMutex);
 
-        for (nit = IoNodes.begin(); nit != IoNodes.end(); nit++) {
-          if (*nit == report->sec_host.substr(0, nit->length())) {
-            Mutex.Lock();
+    if (mUdpPopularityTarget.size()) {
+      UdpBroadCast(report);
+    }
+  }
 
-            if (report->rb) {
-              IostatAvgDomainIOrb[*nit].Add(report->rb, report->ots, report->cts);
-            }
+  // do the domain accounting here
+  if (report->path.substr(0, 11) == "/replicate:") {
+    // check if this is a replication path
+    // push into the 'eos' domain
+    mDelta.AddDomain("eos", report->rb, report->wb, report->ots, report->cts);
+  } else {
+    bool dfound = false;
 
-            if (report->wb) {
-              IostatAvgDomainIOwb[*nit].Add(report->wb, report->ots, report->cts);
-            }
+    if (mReportPopularity) {
+      // do the popularity accounting here for everything which is not replication!
+      AddToPopularity(report->path, report->rb, report->ots, report->cts);
+    }
 
-            Mutex.UnLock();
-            dfound = true;
-          }
-        }
+    size_t pos = 0;
 
-        if (!dfound) {
-          // push into the 'other' domain
-          Mutex.Lock();
+    if ((pos = report->sec_domain.rfind(".")) != std::string::npos) {
+      // we can sort in by domain
+      std::string sdomain = report->sec_domain.substr(pos);
 
-          if (report->rb) {
-            IostatAvgDomainIOrb["other"].Add(report->rb, report->ots, report->cts);
-          }
+      if (IoDomains.find(sdomain) != IoDomains.end()) {
+        mDelta.AddDomain(sdomain, report->rb, report->wb, report->ots,
+                         report->cts);
+        dfound = true;
+      }
+    }
 
-          if (report->wb) {
-            IostatAvgDomainIOwb["other"].Add(report->wb, report->ots, report->cts);
-          }
+    // do the node accounting here - keep the node list small !!!
+    std::set<std::string>::const_iterator nit;
 
-          Mutex.UnLock();
-        }
+    for (nit = IoNodes.begin(); nit != IoNodes.end(); nit++) {
+      if (*nit == report->sec_host.substr(0, nit->length())) {
+        mDelta.AddDomain(*nit, report->rb, report->wb, report->ots,
+                         report->cts);
+        dfound = true;
       }
+    }
 
-      // do the application accounting here
-      std::string apptag = "other";
+    if (!dfound) {
+      // push into the 'other' domain
+      mDelta.AddDomain("other", report->rb, report->wb, report->ots,
+                       report->cts);
+    }
+  }
 
-      if (report->sec_app.length()) {
-        apptag = report->sec_app;
-      }
+  // do the application accounting here
+  std::string apptag = "other";
 
-      // Push into app accounting
-      Mutex.Lock();
+  if (report->sec_app.length()) {
+    apptag = report->sec_app;
+  }
 
-      if (report->rb) {
-        IostatAvgAppIOrb[apptag].Add(report->rb, report->ots, report->cts);
-      }
+  // Push into app accounting
+  mDelta.AddApp(apptag, report->rb, report->wb, report->ots, report->cts);
 
-      if (report->wb) {
-        IostatAvgAppIOwb[apptag].Add(report->wb, report->ots, report->cts);
-      }
+  if (mReport) {
+    // add the record to a daily report log file
+    QueueReport(ReportRecord::kDaily, "", body);
+  }
 
-      Mutex.UnLock();
-
-      if (mReport) {
-        // add the record to a daily report log file
-        static XrdOucString openreportfile = "";
-        time_t now = time(NULL);
-        struct tm nowtm;
-        XrdOucString reportfile = "";
-
-        if (localtime_r(&now, &nowtm)) {
-          static char logfile[4096];
-          snprintf(logfile, sizeof(logfile) - 1, "%s/%04u/%02u/%04u%02u%02u.eosreport",
-                   gOFS->IoReportStorePath.c_str(),
-                   1900 + nowtm.tm_year,
-                   nowtm.tm_mon + 1,
-                   1900 + nowtm.tm_year,
-                   nowtm.tm_mon + 1,
-                   nowtm.tm_mday);
-          reportfile = logfile;
-
-          if (reportfile == openreportfile) {
-            // just add it here;
-            if (gOpenReportFD) {
-              fprintf(gOpenReportFD, "%s\n", body.c_str());
-              fflush(gOpenReportFD);
-            }
-          } else {
-            Mutex.Lock();
+  if (mReportNamespace) {
+    // add the record into the report namespace file
+    char path[4096];
+    snprintf(path, sizeof(path) - 1, "%s/%s", gOFS->IoReportStorePath.c_str(),
+             report->path.c_str());
+    QueueReport(ReportRecord::kNamespace, path, body);
+  }
+}
 
-            if (gOpenReportFD) {
-              fclose(gOpenReportFD);
-            }
+/* ------------------------------------------------------------------------- */
+void
+Iostat::QueueReport(ReportRecord::Type type, const std::string& path,
+                    const std::string& body)
+{
+  std::lock_guard<std::mutex> lock(mReportMutex);
 
-            eos::common::Path cPath(reportfile.c_str());
+  if (mReportQueue.size() >= kMaxReportQueue) {
+    // the writer does not keep up, the report log loses this record
+    mReportsDropped++;
+    return;
+  }
 
-            if (cPath.MakeParentPath(S_IRWXU | S_IRGRP | S_IXGRP)) {
-              gOpenReportFD = fopen(reportfile.c_str(), "a+");
+  mReportQueue.push_back(ReportRecord{type, path, body});
+  mReportCv.notify_one();
+}
 
-              if (gOpenReportFD) {
-                fprintf(gOpenReportFD, "%s\n", body.c_str());
-                fflush(gOpenReportFD);
-              }
+/* ------------------------------------------------------------------------- */
+void
+Iostat::WriteReports(ThreadAssistant& assistant) noexcept
+{
+  XrdOucString openreportfile = "";
+  std::deque<ReportRecord> records;
 
-              openreportfile = reportfile;
-            }
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mReportMutex);
 
-            Mutex.UnLock();
-          }
+      if (mReportQueue.empty()) {
+        if (assistant.terminationRequested()) {
+          break;
         }
+
+        mReportCv.wait_for(lock, std::chrono::milliseconds(500));
       }
 
-      if (mReportNamespace) {
-        // add the record into the report namespace file
-        char path[4096];
-        snprintf(path, sizeof(path) - 1, "%s/%s", gOFS->IoReportStorePath.c_str(),
-                 report->path.c_str());
-        eos::common::Path cPath(path);
+      records.swap(mReportQueue);
+    }
+
+    if (records.empty()) {
+      continue;
+    }
+
+    XrdOucString reportfile = "";
+    time_t now = time(NULL);
+    struct tm nowtm;
+
+    if (localtime_r(&now, &nowtm)) {
+      char logfile[4096];
+      snprintf(logfile, sizeof(logfile) - 1, "%s/%04u/%02u/%04u%02u%02u.eosreport",
+               gOFS->IoReportStorePath.c_str(),
+               1900 + nowtm.tm_year,
+               nowtm.tm_mon + 1,
+               1900 + nowtm.tm_year,
+               nowtm.tm_mon + 1,
+               nowtm.tm_mday);
+      reportfile = logfile;
+    }
+
+    for (auto it = records.begin(); it != records.end(); ++it) {
+      if (it->type == ReportRecord::kNamespace) {
+        eos::common::Path cPath(it->path.c_str());
 
         if (cPath.MakeParentPath(S_IRWXU | S_IRGRP | S_IXGRP)) {
-          FILE* freport = fopen(path, "a+");
+          FILE* freport = fopen(it->path.c_str(), "a+");
 
           if (freport) {
-            fprintf(freport, "%s\n", body.c_str());
+            fprintf(freport, "%s\n", it->body.c_str());
             fclose(freport);
           }
         }
+
+        continue;
       }
 
-      delete report;
-      delete newmessage;
+      if ((it->type == ReportRecord::kDaily) && reportfile.length() &&
+          (reportfile != openreportfile)) {
+        // a new day starts a new report file
+        if (gOpenReportFD) {
+          fclose(gOpenReportFD);
+          gOpenReportFD = 0;
+        }
+
+        eos::common::Path cPath(reportfile.c_str());
+
+        if (cPath.MakeParentPath(S_IRWXU | S_IRGRP | S_IXGRP)) {
+          gOpenReportFD = fopen(reportfile.c_str(), "a+");
+          openreportfile = reportfile;
+        }
+      }
+
+      if (gOpenReportFD) {
+        fprintf(gOpenReportFD, "%s\n", it->body.c_str());
+      }
     }
 
-    assistant.wait_for(std::chrono::seconds(1));
+    if (gOpenReportFD) {
+      fflush(gOpenReportFD);
+    }
+
+    records.clear();
   }
 }
 
-
 /* ------------------------------------------------------------------------- */
 void
 Iostat::WriteRecord(std::string& record)
 {
-  Mutex.Lock();
-
-  if (gOpenReportFD) {
-    fprintf(gOpenReportFD, "%s\n", record.c_str());
-    fflush(gOpenReportFD);
-  }
-
-  Mutex.UnLock();
+  QueueReport(ReportRecord::kRecord, "", record);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -548,7 +640,43 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
 
         table_udp.AddRows(table_data);
         out += table_udp.GenerateTable(HEADER).c_str();
+        table_data.clear();
+      }
+    }
+    //! Report ingestion
+    {
+      TableFormatterBase table_ingest;
+
+      if (!monitoring) {
+        table_ingest.SetHeader({
+          std::make_tuple("reports", 8, format_l),
+          std::make_tuple("batches", 8, format_l),
+          std::make_tuple("log-queue", 9, format_l),
+          std::make_tuple("log-dropped", 11, format_l)
+        });
+      } else {
+        table_ingest.SetHeader({
+          std::make_tuple("reports", 0, format_l),
+          std::make_tuple("batches", 0, format_l),
+          std::make_tuple("logqueue", 0, format_l),
+          std::make_tuple("logdropped", 0, format_l)
+        });
+      }
+
+      size_t depth = 0;
+      {
+        std::lock_guard<std::mutex> lock(mReportMutex);
+        depth = mReportQueue.size();
       }
+      table_data.emplace_back();
+      TableRow& row = table_data.back();
+      row.emplace_back((unsigned long long) mReportsReceived.load(), format_l);
+      row.emplace_back((unsigned long long) mReportBatches.load(), format_l);
+      row.emplace_back((unsigned long long) depth, format_l);
+      row.emplace_back((unsigned long long) mReportsDropped.load(), format_l);
+      table_ingest.AddRows(table_data);
+      out += table_ingest.GenerateTable(HEADER).c_str();
+      table_data.clear();
     }
   }
 
@@ -1096,6 +1224,54 @@ Iostat::PrintNs(XrdOucString& out, XrdOucString option)
                                        "hotfile", "write", key.c_str(), it->first, path.c_str(), val.c_str()));
       }
 
+      // Get the files with the highest IO rates as <bytes/s>:<iops>:<hexfid>
+      for (const char* access : {
+             "read", "write"
+           }) {
+        std::string hotio_key = (access[0] == 'r') ? "stat.ropen.hotio" :
+                                "stat.wopen.hotio";
+        std::string hotio = FsView::gFsView.mIdView[it->first]->GetString(
+                              hotio_key.c_str());
+
+        if ((hotio == " ") ||
+            (FsView::gFsView.mIdView[it->first]->GetAge(hotio_key.c_str()) > 60)) {
+          hotio = "";
+        }
+
+        std::vector<std::string> hotio_vector;
+        eos::common::StringConversion::Tokenize(hotio, hotio_vector);
+
+        for (size_t i = 0; i < hotio_vector.size(); i++) {
+          std::string rate, iops_hex, iops, hexfid;
+
+          if (!eos::common::StringConversion::SplitKeyValue(hotio_vector[i], rate,
+              iops_hex) ||
+              !eos::common::StringConversion::SplitKeyValue(iops_hex, iops, hexfid)) {
+            continue;
+          }
+
+          {
+            unsigned long fid = eos::common::FileId::Hex2Fid(hexfid.c_str());
+            eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, fid);
+            eos::common::RWMutexReadLock viewLock(gOFS->eosViewRWMutex);
+
+            try {
+              path = gOFS->eosView->getUri(gOFS->eosFileService->getFileMD(fid).get());
+            } catch (eos::MDException& e) {
+              path = "<undef>";
+            }
+          }
+
+          std::string readable;
+          eos::common::StringConversion::GetReadableSizeString(readable,
+              strtoull(rate.c_str(), 0, 10), "B/s");
+          data.emplace_back(std::make_tuple(std::string(access[0] == 'r' ? "rio" :
+                                            "wio"), readable, id, host, path));
+          data_monitoring.emplace_back(std::make_tuple(
+                                         "hotio", access, rate, it->first, path, hexfid));
+        }
+      }
+
       // Sort and output
       if (!monitoring) {
         std::sort(data.begin(), data.end());
@@ -1717,7 +1893,9 @@ Iostat::AddUdpTarget(const char* target, bool storeitandlock)
   }
 
   if (storeitandlock) {
+    mMetricsPush.SetTargets(mUdpPopularityTargetList.c_str());
     BroadcastMutex.UnLock();
+    FsView::gFsView.BroadcastMonitoringTargets(mMetricsPush.GetTargets());
   }
 
   return true;
@@ -1760,6 +1938,7 @@ Iostat::RemoveUdpTarget(const char* target)
         mUdpPopularityTargetList.erase(mUdpPopularityTargetList.length() - 1);
       }
 
+      mMetricsPush.SetTargets(mUdpPopularityTargetList.c_str());
       retc = true;
       store = true;
     }
@@ -1767,11 +1946,30 @@ Iostat::RemoveUdpTarget(const char* target)
 
   if (store) {
     retc &= StoreIostatConfig();
+    FsView::gFsView.BroadcastMonitoringTargets(mMetricsPush.GetTargets());
   }
 
   return retc;
 }
 
+//------------------------------------------------------------------------------
+// Start the push of the metrics registry to the UDP targets
+//------------------------------------------------------------------------------
+void
+Iostat::StartMetricsPush()
+{
+  mMetricsPush.Start("mgm", eos::common::MetricsPush::GetIntervalFromEnv());
+}
+
+//------------------------------------------------------------------------------
+// Get the UDP targets separated by '|'
+//------------------------------------------------------------------------------
+std::string
+Iostat::GetUdpTargetList()
+{
+  return mMetricsPush.GetTargets();
+}
+
 /* ------------------------------------------------------------------------- */
 void
 Iostat::UdpBroadCast(eos::common::Report* report)
@@ -2059,74 +2257,60 @@ Iostat::AddToPopularity(std::string path, unsigned long long rb,
 
 /* ------------------------------------------------------------------------- */
 void
-IostatAvg::Add(unsigned long val, time_t starttime, time_t stoptime)
+IostatAvg::AddBins(unsigned long* bins, size_t width, unsigned long val,
+                   time_t starttime, time_t stoptime, time_t now)
 {
-  time_t now = time(0);
   size_t tdiff = stoptime - starttime;
   size_t toff = now - stoptime;
 
-  if (toff < 86400) {
-    // if the measurements was done in the last 86400 seconds
-    unsigned int mbins = tdiff / 1440; // number of bins the measurement was hitting
-
-    if (mbins == 0) {
-      mbins = 1;
-    }
-
-    unsigned long norm_val = (1.0 * val / mbins);
-
-    for (size_t bins = 0; bins < mbins; bins++) {
-      unsigned int bin86400 = (((stoptime - (bins * 1440)) / 1440) % 60);
-      avg86400[bin86400] += norm_val;
-    }
+  if (toff >= (60 * width)) {
+    // the measurement ended before this window
+    return;
   }
 
-  if (toff < 3600) {
-    // if the measurements was done in the last 3600 seconds
-    unsigned int mbins = tdiff / 60; // number of bins the measurement was hitting
-
-    if (mbins == 0) {
-      mbins = 1;
-    }
-
-    unsigned long norm_val = 1.0 * val / mbins;
+  size_t mbins = tdiff / width; // number of bins the measurement was hitting
 
-    for (size_t bins = 0; bins < mbins; bins++) {
-      unsigned int bin3600 = (((stoptime - (bins * 60)) / 60) % 60);
-      avg3600[bin3600] += norm_val;
-    }
+  if (mbins == 0) {
+    mbins = 1;
   }
 
-  if (toff < 300) {
-    // if the measurements was done in the last 300 seconds
-    unsigned int mbins = tdiff / 5; // number of bins the measurement was hitting
-
-    if (mbins == 0) {
-      mbins = 1;
-    }
-
-    unsigned long norm_val = 1.0 * val / mbins;
+  unsigned long norm_val = 1.0 * val / mbins;
+  // bins older than the window would wrap around onto recent bins
+  size_t maxbins = 60 - (toff / width);
 
-    for (size_t bins = 0; bins < mbins; bins++) {
-      unsigned int bin300 = (((stoptime - (bins * 5)) / 5) % 60);
-      avg300[bin300] += norm_val;
-    }
+  if (mbins > maxbins) {
+    mbins = maxbins;
   }
 
-  if (toff < 60) {
-    // if the measurements was done in the last 60 seconds
-    unsigned int mbins = tdiff / 1; // number of bins the measurement was hitting
+  for (size_t bin = 0; bin < mbins; ++bin) {
+    bins[((stoptime - (bin * width)) / width) % 60] += norm_val;
+  }
+}
 
-    if (mbins == 0) {
-      mbins = 1;
-    }
+/* ------------------------------------------------------------------------- */
+void
+IostatAvg::Add(unsigned long val, time_t starttime, time_t stoptime)
+{
+  if (!val) {
+    return;
+  }
 
-    unsigned long norm_val = 1.0 * val / mbins;
+  time_t now = time(0);
+  AddBins(avg86400, 1440, val, starttime, stoptime, now);
+  AddBins(avg3600, 60, val, starttime, stoptime, now);
+  AddBins(avg300, 5, val, starttime, stoptime, now);
+  AddBins(avg60, 1, val, starttime, stoptime, now);
+}
 
-    for (size_t bins = 0; bins < mbins; ++bins) {
-      unsigned int bin60 = (((stoptime - (bins * 1)) / 1) % 60);
-      avg60[bin60] += norm_val;
-    }
+/* ------------------------------------------------------------------------- */
+void
+IostatAvg::Merge(const IostatAvg& other)
+{
+  for (size_t i = 0; i < 60; ++i) {
+    avg86400[i] += other.avg86400[i];
+    avg3600[i] += other.avg3600[i];
+    avg300[i] += other.avg300[i];
+    avg60[i] += other.avg60[i];
   }
 }
 
@@ -2191,4 +2375,141 @@ IostatAvg::GetAvg60()
   return sum;
 }
 
+/* ------------------------------------------------------------------------- */
+void
+IostatDelta::Add(size_t tag, uid_t uid, gid_t gid, unsigned long val,
+                 time_t starttime, time_t stoptime)
+{
+  if (!mSamples++) {
+    mStart = time(NULL);
+  }
+
+  Counter& ucounter = mUid[tag][uid];
+  ucounter.sum += val;
+  ucounter.avg.Add(val, starttime, stoptime);
+  Counter& gcounter = mGid[tag][gid];
+  gcounter.sum += val;
+  gcounter.avg.Add(val, starttime, stoptime);
+}
+
+/* ------------------------------------------------------------------------- */
+void
+IostatDelta::AddDomain(const std::string& domain, unsigned long long rb,
+                       unsigned long long wb, time_t starttime, time_t stoptime)
+{
+  if (rb) {
+    mDomainIOrb[domain].Add(rb, starttime, stoptime);
+  }
+
+  if (wb) {
+    mDomainIOwb[domain].Add(wb, starttime, stoptime);
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+void
+IostatDelta::AddApp(const std::string& app, unsigned long long rb,
+                    unsigned long long wb, time_t starttime, time_t stoptime)
+{
+  if (rb) {
+    mAppIOrb[app].Add(rb, starttime, stoptime);
+  }
+
+  if (wb) {
+    mAppIOwb[app].Add(wb, starttime, stoptime);
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+void
+IostatDelta::Clear()
+{
+  for (auto& tag : mUid) {
+    tag.clear();
+  }
+
+  for (auto& tag : mGid) {
+    tag.clear();
+  }
+
+  mDomainIOrb.clear();
+  mDomainIOwb.clear();
+  mAppIOrb.clear();
+  mAppIOwb.clear();
+  mSamples = 0;
+  mStart = 0;
+}
+
+/* ------------------------------------------------------------------------- */
+void
+Iostat::MergeDelta(bool force)
+{
+  if (!mDelta.Samples()) {
+    return;
+  }
+
+  time_t age = time(NULL) - mDelta.Start();
+
+  if (!force && !age && (mDelta.Samples() < 10000)) {
+    // merge at most once per second
+    return;
+  }
+
+  if (!Mutex.CondLock()) {
+    if (!force && (age < 5)) {
+      // a reader holds the tables, keep accumulating
+      return;
+    }
+
+    Mutex.Lock();
+  }
+
+  for (size_t tag = 0; tag < kReportTags; ++tag) {
+    if (mDelta.mUid[tag].size()) {
+      google::sparse_hash_map<uid_t, unsigned long long>& sums =
+        IostatUid[gReportTags[tag]];
+      google::sparse_hash_map<uid_t, IostatAvg>& avgs =
+        IostatAvgUid[gReportTags[tag]];
+
+      for (auto it = mDelta.mUid[tag].begin(); it != mDelta.mUid[tag].end(); ++it) {
+        sums[it->first] += it->second.sum;
+        avgs[it->first].Merge(it->second.avg);
+      }
+    }
+
+    if (mDelta.mGid[tag].size()) {
+      google::sparse_hash_map<gid_t, unsigned long long>& sums =
+        IostatGid[gReportTags[tag]];
+      google::sparse_hash_map<gid_t, IostatAvg>& avgs =
+        IostatAvgGid[gReportTags[tag]];
+
+      for (auto it = mDelta.mGid[tag].begin(); it != mDelta.mGid[tag].end(); ++it) {
+        sums[it->first] += it->second.sum;
+        avgs[it->first].Merge(it->second.avg);
+      }
+    }
+  }
+
+  for (auto it = mDelta.mDomainIOrb.begin(); it != mDelta.mDomainIOrb.end();
+       ++it) {
+    IostatAvgDomainIOrb[it->first].Merge(it->second);
+  }
+
+  for (auto it = mDelta.mDomainIOwb.begin(); it != mDelta.mDomainIOwb.end();
+       ++it) {
+    IostatAvgDomainIOwb[it->first].Merge(it->second);
+  }
+
+  for (auto it = mDelta.mAppIOrb.begin(); it != mDelta.mAppIOrb.end(); ++it) {
+    IostatAvgAppIOrb[it->first].Merge(it->second);
+  }
+
+  for (auto it = mDelta.mAppIOwb.begin(); it != mDelta.mAppIOwb.end(); ++it) {
+    IostatAvgAppIOwb[it->first].Merge(it->second);
+  }
+
+  Mutex.UnLock();
+  mDelta.Clear();
+}
+
 EOSMGMNAMESPACE_END
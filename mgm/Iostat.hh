@@ -28,12 +28,19 @@
 #include "mq/XrdMqClient.hh"
 #include "common/Logging.hh"
 #include "common/AssistedThread.hh"
+#include "common/ThreadPool.hh"
+#include "common/MetricsPush.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include <google/sparse_hash_map>
 #include <sys/types.h>
 #include <string>
 #include <set>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -73,6 +80,9 @@ public:
   void
   Add(unsigned long val, time_t starttime, time_t stoptime);
 
+  void
+  Merge(const IostatAvg& other);
+
   void
   StampZero();
 
@@ -87,6 +97,67 @@ public:
 
   double
   GetAvg60();
+
+private:
+  //----------------------------------------------------------------------------
+  //! Spread a measurement over the bins of one ring buffer, only the bins
+  //! still inside of the window are touched
+  //!
+  //! @param bins ring buffer of 60 bins
+  //! @param width width of a bin in seconds
+  //----------------------------------------------------------------------------
+  static void AddBins(unsigned long* bins, size_t width, unsigned long val,
+                      time_t starttime, time_t stoptime, time_t now);
+};
+
+//------------------------------------------------------------------------------
+//! Counters accumulated by the report receiver without holding the Iostat
+//! mutex. Samples of the same tag and id are summed up locally and merged
+//! into the shared tables with a single lock acquisition.
+//------------------------------------------------------------------------------
+class IostatDelta
+{
+public:
+  struct Counter {
+    Counter() : sum(0) { }
+    unsigned long long sum;
+    IostatAvg avg;
+  };
+
+  IostatDelta(size_t ntags) : mUid(ntags), mGid(ntags), mSamples(0),
+    mStart(0) { }
+
+  void Add(size_t tag, uid_t uid, gid_t gid, unsigned long val,
+           time_t starttime, time_t stoptime);
+
+  void AddDomain(const std::string& domain, unsigned long long rb,
+                 unsigned long long wb, time_t starttime, time_t stoptime);
+
+  void AddApp(const std::string& app, unsigned long long rb,
+              unsigned long long wb, time_t starttime, time_t stoptime);
+
+  void Clear();
+
+  size_t Samples() const
+  {
+    return mSamples;
+  }
+
+  time_t Start() const
+  {
+    return mStart;
+  }
+
+  std::vector<std::unordered_map<uid_t, Counter>> mUid; // by tag id
+  std::vector<std::unordered_map<gid_t, Counter>> mGid; // by tag id
+  std::unordered_map<std::string, IostatAvg> mDomainIOrb;
+  std::unordered_map<std::string, IostatAvg> mDomainIOwb;
+  std::unordered_map<std::string, IostatAvg> mAppIOrb;
+  std::unordered_map<std::string, IostatAvg> mAppIOwb;
+
+private:
+  size_t mSamples; // samples added since the last merge
+  time_t mStart; // time of the first sample since the last merge
 };
 
 class Iostat
@@ -177,6 +248,8 @@ private:
   mUdpPopularityTargetList; // contains the string describing the set above for the configuration store
   XrdOucString
   mStoreFileName; // file name where a dump is loaded/saved in Restore/Store
+  //! Push of the MGM metrics to the UDP targets, also used by the FSTs
+  eos::common::MetricsPush mMetricsPush;
 
 
 public:
@@ -188,6 +261,16 @@ public:
   static const char* gIostatUdpTargetList;
 
   static FILE* gOpenReportFD;
+
+  //! tags of the counters filled from the FST reports, names in gReportTags
+  enum ReportTag {
+    kBytesRead, kBytesWritten, kReadCalls, kReadvCalls, kWriteCalls,
+    kFwdSeeks, kBwdSeeks, kXlFwdSeeks, kXlBwdSeeks, kBytesFwdSeek,
+    kBytesBwdSeek, kBytesXlFwdSeek, kBytesXlBwdSeek, kDiskTimeRead,
+    kDiskTimeWrite, kBytesDeleted, kFilesDeleted, kReportTags
+  };
+
+  static const char* gReportTags[kReportTags];
   bool mRunning;
   bool mInit;
 
@@ -223,6 +306,18 @@ public:
   bool AddUdpTarget(const char* target, bool storeitandlock = true);
   bool RemoveUdpTarget(const char* target);
 
+  //----------------------------------------------------------------------------
+  //! Start the push of the metrics registry to the UDP targets, every
+  //! EOS_MONITORING_PUSH_INTERVAL seconds. The FSTs get the targets in
+  //! their monitoring.targets node config and push their own metrics.
+  //----------------------------------------------------------------------------
+  void StartMetricsPush();
+
+  //----------------------------------------------------------------------------
+  //! Get the UDP targets separated by '|'
+  //----------------------------------------------------------------------------
+  std::string GetUdpTargetList();
+
   void PrintOut(XrdOucString& out, bool summary, bool details, bool monitoring,
                 bool numerical = false, bool top = false, bool domain = false,
                 bool apps = false, XrdOucString option = "");
@@ -363,6 +458,64 @@ public:
   }
 
 private:
+  //----------------------------------------------------------------------------
+  //! Merge the counters accumulated by the receiver into the shared tables.
+  //! While a reader holds the mutex the receiver keeps accumulating, unless
+  //! the delta is older than a few seconds.
+  //!
+  //! @param force merge even if the delta is young, waiting for the mutex
+  //----------------------------------------------------------------------------
+  void MergeDelta(bool force);
+
+  //----------------------------------------------------------------------------
+  //! Parse a batch of report messages on the parse pool and apply them
+  //----------------------------------------------------------------------------
+  void ProcessBatch(std::vector<std::string>& bodies);
+
+  //----------------------------------------------------------------------------
+  //! Apply a single parsed report to the counters and the report logs
+  //----------------------------------------------------------------------------
+  void ProcessReport(eos::common::Report* report, const std::string& body);
+
+  //! record for the report log writer
+  struct ReportRecord {
+    enum Type {
+      kDaily, ///< report appended to the report file of the day
+      kRecord, ///< record appended to the currently open report file
+      kNamespace ///< report appended to the report namespace file in path
+    };
+
+    Type type;
+    std::string path;
+    std::string body;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Queue a record for the report log writer, the record is dropped if the
+  //! queue is full
+  //----------------------------------------------------------------------------
+  void QueueReport(ReportRecord::Type type, const std::string& path,
+                   const std::string& body);
+
+  //----------------------------------------------------------------------------
+  //! Method executed by the thread writing the report logs
+  //!
+  //! @param assistant reference to thread object
+  //----------------------------------------------------------------------------
+  void WriteReports(ThreadAssistant& assistant) noexcept;
+
+  static constexpr size_t kParseThreads = 4; ///< Threads parsing reports
+  static constexpr size_t kMaxReportQueue = 100000; ///< Max queued log records
+
+  IostatDelta mDelta; ///< Counters of the receiving thread not merged yet
+  std::mutex mReportMutex; ///< Protecting the report log queue
+  std::condition_variable mReportCv; ///< Signals records for the writer
+  std::deque<ReportRecord> mReportQueue; ///< Records for the report log
+  std::atomic<uint64_t> mReportsReceived; ///< Reports received
+  std::atomic<uint64_t> mReportBatches; ///< Batches of reports applied
+  std::atomic<uint64_t> mReportsDropped; ///< Log records dropped, queue full
+  eos::common::ThreadPool mParsePool; ///< Pool parsing report messages
+  AssistedThread mReportWriterThread; ///< Looping thread writing report logs
   AssistedThread mReceivingThread; ///< Looping thread receiving reports
   AssistedThread mCirculateThread; ///< Looping thread circulating reports
 };
@@ -30,13 +30,19 @@
 #include "mgm/LRU.hh"
 #include "mgm/Stat.hh"
 #include "mgm/Master.hh"
+#include "mgm/Policy.hh"
 #include "mgm/XrdMgmOfs.hh"
 #include "namespace/interface/IView.hh"
 #include "namespace/interface/ContainerIterators.hh"
 #include "namespace/Prefetcher.hh"
+#include <algorithm>
+#include <deque>
+#include <thread>
 
 //! Attribute name defining any LRU policy
 const char* LRU::gLRUPolicyPrefix = "sys.lru.*";
+//! Attribute name defining a tiering policy
+const char* LRU::gTierPolicyPrefix = "sys.tier.*";
 
 /*----------------------------------------------------------------------------*/
 
@@ -68,6 +74,110 @@ LRU::Stop()
   mThread.join();
 }
 
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief register the LRU indices for the namespace change notifications
+ */
+/*----------------------------------------------------------------------------*/
+void
+LRU::RegisterListeners(eos::IFileMDSvc* filesvc, eos::IContainerMDSvc* contsvc)
+{
+  filesvc->addChangeListener(&mVolumeIndex);
+  filesvc->addChangeListener(&mExpireIndex);
+  contsvc->addChangeListener(&mVolumeIndex);
+  contsvc->addChangeListener(&mExpireIndex);
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief get the container id of a directory
+ */
+/*----------------------------------------------------------------------------*/
+uint64_t
+LRU::GetContainerId(const char* dir)
+{
+  eos::Prefetcher::prefetchContainerMDAndWait(gOFS->eosView, dir);
+  RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+  try {
+    return gOFS->eosView->getContainer(dir)->getId();
+  } catch (eos::MDException& e) {
+    eos_static_err("msg=\"exception\" ec=%d emsg=\"%s\"",
+                   e.getErrno(), e.getMessage().str().c_str());
+  }
+
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief fill a tree of an index by walking the namespace
+ *
+ * Every container is listed under the namespace read lock, so that the
+ * change notifications of its files arriving during the walk are not lost.
+ */
+/*----------------------------------------------------------------------------*/
+bool
+LRU::FillIndex(LRUIndex& index, uint64_t cid)
+{
+  uint64_t generation = index.GetGeneration(cid);
+  std::deque<uint64_t> todo {cid};
+  unsigned long long nfiles = 0;
+  gOFS->MgmStats.Add("LRUFill", 0, 0, 1);
+  EXEC_TIMING_BEGIN("LRUFill");
+
+  while (!todo.empty()) {
+    uint64_t id = todo.front();
+    todo.pop_front();
+    eos::Prefetcher::prefetchContainerMDWithChildrenAndWait(gOFS->eosView, id);
+
+    if (mMs) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(GetMs()));
+    }
+
+    RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+    try {
+      std::shared_ptr<eos::IContainerMD> cmd =
+        gOFS->eosDirectoryService->getContainerMD(id);
+
+      for (auto it = eos::FileMapIterator(cmd); it.valid(); it.next()) {
+        try {
+          std::shared_ptr<eos::IFileMD> fmd =
+            gOFS->eosFileService->getFileMD(it.value());
+          eos::IFileMD::ctime_t ctime;
+          fmd->getCTime(ctime);
+          index.Upsert(fmd->getId(), id, ctime.tv_sec,
+                       Quota::MapSizeCB(fmd.get()));
+          ++nfiles;
+        } catch (eos::MDException& e) {
+          eos_static_debug("msg=\"exception\" ec=%d emsg=\"%s\"",
+                           e.getErrno(), e.getMessage().str().c_str());
+        }
+      }
+
+      for (auto it = eos::ContainerMapIterator(cmd); it.valid(); it.next()) {
+        if (index.AddContainer(it.value(), id)) {
+          todo.push_back(it.value());
+        }
+      }
+    } catch (eos::MDException& e) {
+      eos_static_err("msg=\"exception\" ec=%d emsg=\"%s\"",
+                     e.getErrno(), e.getMessage().str().c_str());
+
+      if (id == cid) {
+        return false;
+      }
+    }
+  }
+
+  index.SetReady(cid, generation);
+  EXEC_TIMING_END("LRUFill");
+  eos_static_info("msg=\"filled LRU index\" cid=%llu files=%llu",
+                  (unsigned long long) cid, nfiles);
+  return index.IsReady(cid);
+}
+
 /*----------------------------------------------------------------------------*/
 /**
  * @brief LRU method doing the actual policy scrubbing
@@ -131,6 +241,8 @@ LRU::LRUr(ThreadAssistant& assistant) noexcept
       }
 
       eos_static_info("msg=\"start LRU scan\" ndir=%llu ms=%u", ndirs, ms);
+      mVolumeTrees.clear();
+      mExpireTrees.clear();
       std::map<std::string, std::set<std::string> > lrudirs;
       XrdOucString stdErr;
       // Find all directories defining an LRU policy
@@ -192,11 +304,47 @@ LRU::LRUr(ThreadAssistant& assistant) noexcept
         if (assistant.terminationRequested()) {
           return;
         }
+
+        // Forget the trees whose policy was removed
+        mVolumeIndex.Retain(mVolumeTrees);
+        mExpireIndex.Retain(mExpireTrees);
+      }
+
+      // Find all directories defining a tiering policy
+      std::map<std::string, std::set<std::string> > tierdirs;
+
+      if (!gOFS->_find("/", mError, stdErr, mRootVid, tierdirs, gTierPolicyPrefix,
+                       "*", true, ms, false)) {
+        eos_static_info("msg=\"finished tier find\" tier-dirs=%llu",
+                        tierdirs.size());
+
+        for (auto it = tierdirs.begin(); it != tierdirs.end(); it++) {
+          eos::IContainerMD::XAttrMap map;
+
+          if (!gOFS->_attr_ls(it->first.c_str(), mError, mRootVid,
+                              (const char*) 0, map) &&
+              map.count("sys.tier.cold") && map.count("sys.tier.age")) {
+            // -----------------------------------------------------------------
+            // files older than the cool down age move to the cold space
+            // -----------------------------------------------------------------
+            TierMigrate(it->first.c_str(), map);
+          }
+
+          if (assistant.terminationRequested()) {
+            return;
+          }
+        }
       }
 
       EXEC_TIMING_END("LRUFind");
-      eos_static_info("msg=\"finished LRU application\" LRU-dirs=%llu",
-                      lrudirs.size());
+      eos_static_info("msg=\"finished LRU application\" LRU-dirs=%llu "
+                      "indexed-files=%llu", lrudirs.size(),
+                      (unsigned long long)(mVolumeIndex.GetNumFiles() +
+                          mExpireIndex.GetNumFiles()));
+    } else {
+      // The index is only maintained while it is used
+      mVolumeIndex.Clear();
+      mExpireIndex.Clear();
     }
 
     lStopTime = time(NULL);
@@ -315,51 +463,70 @@ LRU::AgeExpire(const char* dir,
     }
   }
 
-  std::vector<std::string> lDeleteList;
-  {
-    // Check the directory contents
-    std::shared_ptr<eos::IContainerMD> cmd;
-    eos::Prefetcher::prefetchContainerMDAndWait(gOFS->eosView, dir);
-    RWMutexReadLock lock(gOFS->eosViewRWMutex);
+  if (lMatchAgeMap.empty()) {
+    return;
+  }
 
-    try {
-      cmd = gOFS->eosView->getContainer(dir);
-      std::shared_ptr<eos::IFileMD> fmd;
+  uint64_t cid = GetContainerId(dir);
 
-      // Loop through all file names
-      for (auto it = eos::FileMapIterator(cmd); it.valid(); it.next()) {
-        fmd = cmd->findFile(it.key());
-        std::string fullpath = dir;
-        fullpath += fmd->getName();
-        eos_static_debug("%s", fullpath.c_str());
+  if (!cid) {
+    return;
+  }
 
-        // Loop over the match map
-        for (auto mit = lMatchAgeMap.begin(); mit != lMatchAgeMap.end(); mit++) {
-          XrdOucString fname = fmd->getName().c_str();
-          eos_static_debug("%s %d", mit->first.c_str(),
-                           fname.matches(mit->first.c_str()));
+  mExpireTrees.insert(cid);
+  mExpireIndex.Track(cid);
 
-          if (fname.matches(mit->first.c_str())) {
-            // Full match check the age policy
-            eos::IFileMD::ctime_t ctime;
-            fmd->getCTime(ctime);
-            time_t age = mit->second;
+  if (!mExpireIndex.IsReady(cid) && !FillIndex(mExpireIndex, cid)) {
+    return;
+  }
 
-            if ((ctime.tv_sec + age) < now) {
-              // This entry can be deleted
-              eos_static_notice("msg=\"delete expired file\" path=\"%s\" "
-                                "ctime=%u policy-age=%u age=%u",
-                                fullpath.c_str(), ctime.tv_sec, age,
-                                now - ctime.tv_sec);
-              lDeleteList.push_back(fullpath);
-              break;
-            }
+  // Only files older than the shortest policy age can match
+  time_t min_age = lMatchAgeMap.begin()->second;
+
+  for (auto it = lMatchAgeMap.begin(); it != lMatchAgeMap.end(); it++) {
+    min_age = std::min(min_age, it->second);
+  }
+
+  std::vector<LRUIndex::Entry> lCandidates;
+  mExpireIndex.GetOlderThan(cid, now - min_age, lCandidates);
+  std::vector<std::string> lDeleteList;
+
+  for (const auto& candidate : lCandidates) {
+    eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, candidate.mFid);
+    RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+    try {
+      std::shared_ptr<eos::IFileMD> fmd =
+        gOFS->eosFileService->getFileMD(candidate.mFid);
+      std::string fullpath = dir;
+      fullpath += fmd->getName();
+      eos_static_debug("%s", fullpath.c_str());
+
+      // Loop over the match map
+      for (auto mit = lMatchAgeMap.begin(); mit != lMatchAgeMap.end(); mit++) {
+        XrdOucString fname = fmd->getName().c_str();
+        eos_static_debug("%s %d", mit->first.c_str(),
+                         fname.matches(mit->first.c_str()));
+
+        if (fname.matches(mit->first.c_str())) {
+          // Full match check the age policy
+          eos::IFileMD::ctime_t ctime;
+          fmd->getCTime(ctime);
+          time_t age = mit->second;
+
+          if ((ctime.tv_sec + age) < now) {
+            // This entry can be deleted
+            eos_static_notice("msg=\"delete expired file\" path=\"%s\" "
+                              "ctime=%u policy-age=%u age=%u",
+                              fullpath.c_str(), ctime.tv_sec, age,
+                              now - ctime.tv_sec);
+            lDeleteList.push_back(fullpath);
+            break;
           }
         }
       }
     } catch (eos::MDException& e) {
       errno = e.getErrno();
-      cmd = std::shared_ptr<eos::IContainerMD>((eos::IContainerMD*)0);
       eos_static_err("msg=\"exception\" ec=%d emsg=\"%s\"",
                      e.getErrno(), e.getMessage().str().c_str());
     }
@@ -387,6 +554,13 @@ LRU::CacheExpire(const char* dir,
   eos_static_info("msg=\"applying volume deletion policy\" "
                   "dir=\"%s\" low-mark=\"%s\" high-mark=\"%s\"",
                   dir, lowmark.c_str(), highmark.c_str());
+  uint64_t cid = GetContainerId(dir);
+
+  if (!cid) {
+    return;
+  }
+
+  mVolumeTrees.insert(cid);
 
   // Update space quota, return if this is not a ns quota node
   if (!Quota::UpdateFromNsQuota(dir, 0, 0)) {
@@ -436,75 +610,34 @@ LRU::CacheExpire(const char* dir,
   eos_static_notice("low-mark=%.02f high-mark=%.02f current-mark=%.02f "
                     "deletion-bytes=%s", lwm, hwm,  cwm,
                     StringConversion::GetReadableSizeString(sizestring, bytes_to_free, "B"));
-  // Build the LRU list
-  std::map<std::string, std::set<std::string> > cachedirs;
-  XrdOucString stdErr;
-  time_t ms = 0;
-
-  if (mMs) {
-    // we have a forced setting
-    ms = GetMs();
+  // The tree is indexed the first time it reaches the high watermark
+  mVolumeIndex.Track(cid);
+
+  if (!mVolumeIndex.IsReady(cid) && !FillIndex(mVolumeIndex, cid)) {
+    return;
   }
 
-  // map with path/mtime pairs
-  std::set<lru_entry_t> lru_map;
-  unsigned long long lru_size = 0;
-
-  if (!gOFS->_find(dir, mError, stdErr, mRootVid, cachedirs, "", "", false, ms)) {
-    // Loop through the result and build an LRU list
-    // We just keep as many entries in the LRU list to have the required
-    // number of bytes to free available.
-    for (auto dit = cachedirs.begin(); dit != cachedirs.end(); dit++) {
-      eos_static_debug("path=%s", dit->first.c_str());
-
-      for (auto fit = dit->second.begin(); fit != dit->second.end(); fit++) {
-        // build the full path name
-        std::string fpath = dit->first;
-        fpath += *fit;
-        struct stat buf;
-        eos_static_debug("path=%s", fpath.c_str());
-
-        // get the current ctime & size information
-        if (!gOFS->_stat(fpath.c_str(), &buf, mError, mRootVid, "")) {
-          if (lru_map.size())
-            if ((lru_size > bytes_to_free) &&
-                lru_map.size() &&
-                ((--lru_map.end())->ctime < buf.st_ctime)) {
-              // this entry is newer than all the rest
-              continue;
-            }
+  // Get the oldest entries holding the required number of bytes to free
+  std::vector<LRUIndex::Entry> lOldest;
+  mVolumeIndex.GetOldest(cid, bytes_to_free, lOldest);
+  std::vector<lru_entry_t> lru_map;
 
-          // add LRU entry in front
-          lru_entry_t lru;
-          lru.path = fpath;
-          lru.ctime = buf.st_ctime;
-          lru.size = buf.st_blocks * buf.st_blksize;
-          lru_map.insert(lru);
-          lru_size += lru.size;
-          eos_static_debug("msg=\"adding\" file=\"%s\" "
-                           "bytes-free=\"%llu\" lru-size=\"%llu\"",
-                           fpath.c_str(),
-                           bytes_to_free,
-                           lru_size);
-
-          // check if we can shrink the LRU map
-          if (lru_map.size() && (lru_size > bytes_to_free)) {
-            while (lru_map.size() &&
-                   ((lru_size - (--lru_map.end())->size) > bytes_to_free)) {
-              // remove the last element  of the map
-              auto it = lru_map.end();
-              it--;
-              // subtract the size
-              lru_size -= it->size;
-              eos_static_info("msg=\"clean-up\" path=\"%s\"", it->path.c_str());
-              lru_map.erase(it);
-            }
-          }
-        }
-      }
+  for (const auto& entry : lOldest) {
+    eos::Prefetcher::prefetchFileMDWithParentsAndWait(gOFS->eosView, entry.mFid);
+    RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+    try {
+      std::shared_ptr<eos::IFileMD> fmd =
+        gOFS->eosFileService->getFileMD(entry.mFid);
+      lru_entry_t lru;
+      lru.path = gOFS->eosView->getUri(fmd.get());
+      lru.ctime = entry.mCTime;
+      lru.size = entry.mSize;
+      lru_map.push_back(lru);
+    } catch (eos::MDException& e) {
+      eos_static_debug("msg=\"exception\" ec=%d emsg=\"%s\"",
+                       e.getErrno(), e.getMessage().str().c_str());
     }
-  } else {
-    eos_static_err("msg=\"%s\"", stdErr.c_str());
   }
 
   eos_static_notice("msg=\"cleaning LRU cache\" files-to-delete=%llu",
@@ -769,5 +902,127 @@ LRU::ConvertMatch(const char* dir,
   }
 }
 
+//------------------------------------------------------------------------------
+//! Move the cooled down files of a tiering policy to the cold space
+//!
+//! A file written to the hot space (sys.tier.hot) is converted into the cold
+//! space (sys.tier.cold) once it is older than sys.tier.age, keeping its
+//! layout unless sys.tier.layout gives the hex layout id of the cold copy.
+//! The conversion job copies the file and merges the copy into the original
+//! entry only once it is complete, so the file is always read from either
+//! the hot or the cold replicas. The cold space needs its converter enabled.
+//!
+//! @param dir directory to process
+//! @param map storing the 'sys.tier.*' policy
+//------------------------------------------------------------------------------
+void
+LRU::TierMigrate(const char* dir, eos::IContainerMD::XAttrMap& map)
+{
+  std::string cold = map["sys.tier.cold"];
+  std::string hot = (map.count("sys.tier.hot") ? map["sys.tier.hot"] : "");
+  eos_static_info("msg=\"applying tiering policy\" dir=\"%s\" hot=\"%s\" "
+                  "cold=\"%s\" age=\"%s\"", dir, hot.c_str(), cold.c_str(),
+                  map["sys.tier.age"].c_str());
+
+  if (cold.empty() || (cold == hot)) {
+    eos_static_err("msg=\"tier cold space is illegal\" dir=\"%s\" "
+                   "cold=\"%s\"", dir, cold.c_str());
+    return;
+  }
+
+  time_t age = StringConversion::GetSizeFromString(map["sys.tier.age"].c_str());
+
+  if (errno) {
+    eos_static_err("msg=\"tier age is illegal\" dir=\"%s\" age=\"%s\"",
+                   dir, map["sys.tier.age"].c_str());
+    return;
+  }
+
+  unsigned long long tier_lid = 0;
+
+  if (map.count("sys.tier.layout")) {
+    errno = 0;
+    tier_lid = strtoull(map["sys.tier.layout"].c_str(), 0, 16);
+
+    if (errno || !tier_lid) {
+      eos_static_err("msg=\"tier layout is illegal\" dir=\"%s\" "
+                     "layout=\"%s\"", dir, map["sys.tier.layout"].c_str());
+      return;
+    }
+  }
+
+  struct tier_candidate_t {
+    FileId::fileid_t fid;
+    unsigned long long lid;
+    std::vector<eos::common::FileSystem::fsid_t> locations;
+  };
+
+  std::vector<tier_candidate_t> lCandidates;
+  time_t now = time(NULL);
+  {
+    eos::Prefetcher::prefetchContainerMDAndWait(gOFS->eosView, dir);
+    RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+    try {
+      std::shared_ptr<eos::IContainerMD> cmd = gOFS->eosView->getContainer(dir);
+
+      for (auto fit = eos::FileMapIterator(cmd); fit.valid(); fit.next()) {
+        std::shared_ptr<eos::IFileMD> fmd = cmd->findFile(fit.key());
+
+        if (!fmd || !fmd->getNumLocation()) {
+          continue;
+        }
+
+        eos::IFileMD::ctime_t ctime;
+        fmd->getCTime(ctime);
+
+        if ((ctime.tv_sec + age) >= now) {
+          continue;
+        }
+
+        tier_candidate_t candidate;
+        candidate.fid = fmd->getId();
+        candidate.lid = (tier_lid ? tier_lid : fmd->getLayoutId());
+
+        for (auto loc : fmd->getLocations()) {
+          candidate.locations.push_back(loc);
+        }
+
+        lCandidates.push_back(candidate);
+      }
+    } catch (eos::MDException& e) {
+      eos_static_err("msg=\"exception\" ec=%d emsg=\"%s\"",
+                     e.getErrno(), e.getMessage().str().c_str());
+      return;
+    }
+  }
+
+  for (const auto& candidate : lCandidates) {
+    std::vector<eos::common::FileSystem::fsid_t> in_cold;
+    Policy::GetLocationsInSpace(cold, candidate.locations, in_cold);
+
+    if (in_cold.size() == candidate.locations.size()) {
+      // Already moved to the cold space
+      continue;
+    }
+
+    char conversiontagfile[1024];
+    snprintf(conversiontagfile,
+             sizeof(conversiontagfile) - 1,
+             "%s/%016llx:%s#%08llx",
+             gOFS->MgmProcConversionPath.c_str(),
+             (unsigned long long) candidate.fid,
+             cold.c_str(),
+             candidate.lid);
+    eos_static_notice("msg=\"moving file to the cold tier\" fid=%llu "
+                      "tag-file=%s", (unsigned long long) candidate.fid,
+                      conversiontagfile);
+
+    if (gOFS->_touch(conversiontagfile, mError, mRootVid, 0)) {
+      eos_static_err("msg=\"unable to create conversion job\" "
+                     "job-file=\"%s\"", conversiontagfile);
+    }
+  }
+}
 
 EOSMGMNAMESPACE_END
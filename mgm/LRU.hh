@@ -25,11 +25,13 @@
 #define __EOSMGM_LRU__HH__
 
 #include "mgm/Namespace.hh"
+#include "mgm/LRUIndex.hh"
 #include "common/Mapping.hh"
 #include "common/AssistedThread.hh"
 #include "namespace/interface/IContainerMD.hh"
 #include "XrdOuc/XrdOucErrInfo.hh"
 #include <sys/types.h>
+#include <set>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -47,12 +49,31 @@ private:
   time_t mMs; //< forced sleep time used for find / scans
   eos::common::Mapping::VirtualIdentity mRootVid;//< we operate with the root vid
   XrdOucErrInfo mError; //< XRootD error object
+  LRUIndex mVolumeIndex; //< files of the trees with a watermark policy
+  LRUIndex mExpireIndex; //< files of the directories with an expire policy
+  std::set<uint64_t> mVolumeTrees; //< watermark trees seen in this cycle
+  std::set<uint64_t> mExpireTrees; //< expire directories seen in this cycle
+
+  /**
+   * @brief get the container id of a directory
+   * @param dir directory path
+   * @return container id or 0 if not found
+   */
+  uint64_t GetContainerId(const char* dir);
+
+  /**
+   * @brief fill a tree of an index by walking the namespace
+   * @param index index to fill
+   * @param cid container id of the tree
+   * @return true if the tree was filled
+   */
+  bool FillIndex(LRUIndex& index, uint64_t cid);
 
 public:
 
   /* Default Constructor - use it to run the LRU thread by calling Start
    */
-  LRU()
+  LRU(): mVolumeIndex(true), mExpireIndex(false)
   {
     mMs = 0;
     eos::common::Mapping::Root(mRootVid);
@@ -84,6 +105,14 @@ public:
    */
   void Stop();
 
+  /**
+   * @brief register the LRU indices for the namespace change notifications
+   * @param filesvc file metadata service
+   * @param contsvc container metadata service
+   */
+  void RegisterListeners(eos::IFileMDSvc* filesvc,
+                         eos::IContainerMDSvc* contsvc);
+
   /* LRU method doing the actual policy scrubbing
    */
   void LRUr(ThreadAssistant& assistant) noexcept;
@@ -114,7 +143,15 @@ public:
    */
   void ConvertMatch(const char* dir,  eos::IContainerMD::XAttrMap& map);
 
+  /**
+   * @brief move the cooled down files of a tiering policy to the cold space
+   * @param dir directory to process
+   * @param map storing the 'sys.tier.*' policy
+   */
+  void TierMigrate(const char* dir, eos::IContainerMD::XAttrMap& map);
+
   static const char* gLRUPolicyPrefix;
+  static const char* gTierPolicyPrefix;
 
   struct lru_entry {
     // compare operator to use struct in a map
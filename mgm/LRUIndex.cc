@@ -0,0 +1,455 @@
+//------------------------------------------------------------------------------
+// File: LRUIndex.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/LRUIndex.hh"
+#include "mgm/Quota.hh"
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+LRUIndex::LRUIndex(bool recursive):
+  mRecursive(recursive), mNumTrees(0)
+{}
+
+//------------------------------------------------------------------------------
+// Start indexing a directory
+//------------------------------------------------------------------------------
+bool
+LRUIndex::Track(uint64_t cid)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mTrees.count(cid)) {
+    return false;
+  }
+
+  uint64_t outer = 0;
+  auto it = mContainers.find(cid);
+
+  if (it != mContainers.end()) {
+    // The directory was part of another tree which has to be filled again
+    // without the new subtree
+    outer = it->second;
+    InvalidateLocked(outer);
+  }
+
+  Tree& tree = mTrees[cid];
+  tree.mOuter = outer;
+  tree.mContainers.insert(cid);
+  mContainers[cid] = cid;
+  mNumTrees = mTrees.size();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Drop all trees not in the given set
+//------------------------------------------------------------------------------
+void
+LRUIndex::Retain(const std::set<uint64_t>& cids)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::vector<uint64_t> drop;
+
+  for (const auto& elem : mTrees) {
+    if (!cids.count(elem.first)) {
+      drop.push_back(elem.first);
+    }
+  }
+
+  for (auto cid : drop) {
+    UntrackLocked(cid);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop all trees
+//------------------------------------------------------------------------------
+void
+LRUIndex::Clear()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mTrees.clear();
+  mContainers.clear();
+  mFiles.clear();
+  mNumTrees = 0;
+}
+
+//------------------------------------------------------------------------------
+// Get the fill generation of a tree
+//------------------------------------------------------------------------------
+uint64_t
+LRUIndex::GetGeneration(uint64_t cid)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mTrees.find(cid);
+  return ((it != mTrees.end()) ? it->second.mGeneration : 0);
+}
+
+//------------------------------------------------------------------------------
+// Mark a tree as filled
+//------------------------------------------------------------------------------
+void
+LRUIndex::SetReady(uint64_t cid, uint64_t generation)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mTrees.find(cid);
+
+  if ((it != mTrees.end()) && (it->second.mGeneration == generation)) {
+    it->second.mReady = true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check if a tree is indexed and filled
+//------------------------------------------------------------------------------
+bool
+LRUIndex::IsReady(uint64_t cid)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mTrees.find(cid);
+  return ((it != mTrees.end()) && it->second.mReady);
+}
+
+//------------------------------------------------------------------------------
+// Add a sub container to the tree of its parent
+//------------------------------------------------------------------------------
+bool
+LRUIndex::AddContainer(uint64_t cid, uint64_t parent)
+{
+  if (!mRecursive) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto pit = mContainers.find(parent);
+
+  if (pit == mContainers.end()) {
+    return false;
+  }
+
+  uint64_t tree = pit->second;
+  auto tit = mTrees.find(cid);
+
+  if (tit != mTrees.end()) {
+    // Nested tree, indexed on its own
+    tit->second.mOuter = tree;
+    return false;
+  }
+
+  auto cit = mContainers.find(cid);
+
+  if (cit != mContainers.end()) {
+    if (cit->second == tree) {
+      return false;
+    }
+
+    InvalidateLocked(cit->second);
+  }
+
+  mContainers[cid] = tree;
+  mTrees[tree].mContainers.insert(cid);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Add or update a file
+//------------------------------------------------------------------------------
+void
+LRUIndex::Upsert(uint64_t fid, uint64_t cid, time_t ctime, uint64_t size)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto cit = mContainers.find(cid);
+
+  if (cit == mContainers.end()) {
+    RemoveLocked(fid);
+    return;
+  }
+
+  uint64_t tree = cit->second;
+  auto fit = mFiles.find(fid);
+
+  if (fit != mFiles.end()) {
+    if ((fit->second.mTree == tree) && (fit->second.mCTime == ctime)) {
+      fit->second.mSize = size;
+      return;
+    }
+
+    RemoveLocked(fid);
+  }
+
+  mFiles[fid] = File {tree, ctime, size};
+  mTrees[tree].mOrder.emplace(ctime, fid);
+}
+
+//------------------------------------------------------------------------------
+// Remove a file
+//------------------------------------------------------------------------------
+void
+LRUIndex::Remove(uint64_t fid)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  RemoveLocked(fid);
+}
+
+//------------------------------------------------------------------------------
+// Get the oldest files of a tree
+//------------------------------------------------------------------------------
+bool
+LRUIndex::GetOldest(uint64_t cid, uint64_t bytes, std::vector<Entry>& entries)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto tit = mTrees.find(cid);
+
+  if ((tit == mTrees.end()) || !tit->second.mReady) {
+    return false;
+  }
+
+  uint64_t sum = 0;
+
+  for (auto it = tit->second.mOrder.begin();
+       (it != tit->second.mOrder.end()) && (sum < bytes); ++it) {
+    const File& file = mFiles[it->second];
+    entries.push_back(Entry {it->second, it->first, file.mSize});
+    sum += file.mSize;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the files of a tree created before a given time
+//------------------------------------------------------------------------------
+bool
+LRUIndex::GetOlderThan(uint64_t cid, time_t before,
+                       std::vector<Entry>& entries)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto tit = mTrees.find(cid);
+
+  if ((tit == mTrees.end()) || !tit->second.mReady) {
+    return false;
+  }
+
+  for (auto it = tit->second.mOrder.begin();
+       (it != tit->second.mOrder.end()) && (it->first < before); ++it) {
+    entries.push_back(Entry {it->second, it->first, mFiles[it->second].mSize});
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the number of indexed files
+//------------------------------------------------------------------------------
+size_t
+LRUIndex::GetNumFiles()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mFiles.size();
+}
+
+//------------------------------------------------------------------------------
+// File change notification
+//------------------------------------------------------------------------------
+void
+LRUIndex::fileMDChanged(IFileMDChangeListener::Event* event)
+{
+  if (!mNumTrees) {
+    return;
+  }
+
+  IFileMD* file = event->file;
+
+  switch (event->action) {
+  case IFileMDChangeListener::Deleted:
+    Remove(file->getId());
+    break;
+
+  case IFileMDChangeListener::Created:
+  case IFileMDChangeListener::Updated:
+  case IFileMDChangeListener::SizeChange: {
+    IFileMD::ctime_t ctime;
+    file->getCTime(ctime);
+    Upsert(file->getId(), file->getContainerId(), ctime.tv_sec,
+           Quota::MapSizeCB(file));
+    break;
+  }
+
+  default:
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Container change notification
+//------------------------------------------------------------------------------
+void
+LRUIndex::containerMDChanged(IContainerMD* obj,
+                             IContainerMDChangeListener::Action type)
+{
+  if (!mNumTrees) {
+    return;
+  }
+
+  uint64_t cid = obj->getId();
+
+  if (type == IContainerMDChangeListener::Deleted) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mTrees.count(cid)) {
+      UntrackLocked(cid);
+    } else {
+      auto it = mContainers.find(cid);
+
+      if (it != mContainers.end()) {
+        mTrees[it->second].mContainers.erase(cid);
+        mContainers.erase(it);
+      }
+    }
+
+    return;
+  }
+
+  // Only the update following an attach or a move can change the parent
+  if ((type != IContainerMDChangeListener::Updated) || !mRecursive) {
+    return;
+  }
+
+  uint64_t parent = obj->getParentId();
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto pit = mContainers.find(parent);
+  uint64_t to = ((pit != mContainers.end()) ? pit->second : 0);
+  auto tit = mTrees.find(cid);
+
+  if (tit != mTrees.end()) {
+    tit->second.mOuter = to;
+    return;
+  }
+
+  auto cit = mContainers.find(cid);
+  uint64_t from = ((cit != mContainers.end()) ? cit->second : 0);
+
+  if (from == to) {
+    return;
+  }
+
+  if (from) {
+    InvalidateLocked(from);
+  }
+
+  if (to) {
+    if (obj->getNumFiles() || obj->getNumContainers()) {
+      // Moved in with its contents, which are not known
+      InvalidateLocked(to);
+    } else {
+      mContainers[cid] = to;
+      mTrees[to].mContainers.insert(cid);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove a file
+//------------------------------------------------------------------------------
+void
+LRUIndex::RemoveLocked(uint64_t fid)
+{
+  auto fit = mFiles.find(fid);
+
+  if (fit == mFiles.end()) {
+    return;
+  }
+
+  auto tit = mTrees.find(fit->second.mTree);
+
+  if (tit != mTrees.end()) {
+    tit->second.mOrder.erase(std::make_pair(fit->second.mCTime, fid));
+  }
+
+  mFiles.erase(fit);
+}
+
+//------------------------------------------------------------------------------
+// Empty a tree so that it is filled again
+//------------------------------------------------------------------------------
+void
+LRUIndex::InvalidateLocked(uint64_t cid)
+{
+  auto tit = mTrees.find(cid);
+
+  if (tit == mTrees.end()) {
+    return;
+  }
+
+  Tree& tree = tit->second;
+
+  for (const auto& elem : tree.mOrder) {
+    mFiles.erase(elem.second);
+  }
+
+  for (auto id : tree.mContainers) {
+    if (id != cid) {
+      mContainers.erase(id);
+    }
+  }
+
+  tree.mOrder.clear();
+  tree.mContainers.clear();
+  tree.mContainers.insert(cid);
+  tree.mReady = false;
+  tree.mGeneration++;
+}
+
+//------------------------------------------------------------------------------
+// Drop a tree
+//------------------------------------------------------------------------------
+void
+LRUIndex::UntrackLocked(uint64_t cid)
+{
+  auto tit = mTrees.find(cid);
+
+  if (tit == mTrees.end()) {
+    return;
+  }
+
+  for (const auto& elem : tit->second.mOrder) {
+    mFiles.erase(elem.second);
+  }
+
+  for (auto id : tit->second.mContainers) {
+    mContainers.erase(id);
+  }
+
+  uint64_t outer = tit->second.mOuter;
+  mTrees.erase(tit);
+
+  // The outer tree has to index the subtree again
+  if (outer) {
+    InvalidateLocked(outer);
+  }
+
+  mNumTrees = mTrees.size();
+}
+
+EOSMGMNAMESPACE_END
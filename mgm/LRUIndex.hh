@@ -0,0 +1,217 @@
+//------------------------------------------------------------------------------
+//! @file LRUIndex.hh
+//! @brief Creation time ordered index of the files under LRU policies
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "namespace/interface/IContainerMDSvc.hh"
+#include "namespace/interface/IFileMDSvc.hh"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief In-memory index of the files of the directories with an LRU policy,
+//! ordered by creation time
+//!
+//! Every indexed directory (a tree) is identified by its container id. A
+//! recursive index covers the whole subtree of a tree, except the subtrees of
+//! other trees nested in it, a flat index only the files of the directory
+//! itself. Trees are filled once by the LRU engine walking the namespace and
+//! then kept up to date by the namespace change notifications, so the oldest
+//! files are found without scanning the directories again. Changes the
+//! notifications can't follow, like a directory moved in or out of a tree,
+//! invalidate the tree which is then filled again.
+//------------------------------------------------------------------------------
+class LRUIndex: public eos::IFileMDChangeListener,
+  public eos::IContainerMDChangeListener
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Indexed file
+  //----------------------------------------------------------------------------
+  struct Entry {
+    uint64_t mFid;
+    time_t mCTime;
+    uint64_t mSize; ///< physical size including the layout factor
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param recursive if true trees cover their subtree
+  //----------------------------------------------------------------------------
+  LRUIndex(bool recursive);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~LRUIndex() = default;
+
+  //----------------------------------------------------------------------------
+  //! Start indexing a directory
+  //!
+  //! @param cid container id of the directory
+  //!
+  //! @return true if the tree is new, false if it was already indexed
+  //----------------------------------------------------------------------------
+  bool Track(uint64_t cid);
+
+  //----------------------------------------------------------------------------
+  //! Drop all trees not in the given set
+  //----------------------------------------------------------------------------
+  void Retain(const std::set<uint64_t>& cids);
+
+  //----------------------------------------------------------------------------
+  //! Drop all trees
+  //----------------------------------------------------------------------------
+  void Clear();
+
+  //----------------------------------------------------------------------------
+  //! Get the fill generation of a tree, to be passed to SetReady once the
+  //! tree is filled
+  //----------------------------------------------------------------------------
+  uint64_t GetGeneration(uint64_t cid);
+
+  //----------------------------------------------------------------------------
+  //! Mark a tree as filled unless it was invalidated since GetGeneration
+  //----------------------------------------------------------------------------
+  void SetReady(uint64_t cid, uint64_t generation);
+
+  //----------------------------------------------------------------------------
+  //! Check if a tree is indexed and filled
+  //----------------------------------------------------------------------------
+  bool IsReady(uint64_t cid);
+
+  //----------------------------------------------------------------------------
+  //! Add a sub container to the tree of its parent
+  //!
+  //! @return true if the container was added and has to be walked, false if
+  //!         the parent is not indexed, the index is flat or the container
+  //!         is the top of another tree
+  //----------------------------------------------------------------------------
+  bool AddContainer(uint64_t cid, uint64_t parent);
+
+  //----------------------------------------------------------------------------
+  //! Add or update a file, the file is dropped if its container is not
+  //! indexed (anymore)
+  //----------------------------------------------------------------------------
+  void Upsert(uint64_t fid, uint64_t cid, time_t ctime, uint64_t size);
+
+  //----------------------------------------------------------------------------
+  //! Remove a file
+  //----------------------------------------------------------------------------
+  void Remove(uint64_t fid);
+
+  //----------------------------------------------------------------------------
+  //! Get the oldest files of a tree
+  //!
+  //! @param cid tree
+  //! @param bytes the returned files sum up to at least bytes, as long as the
+  //!        tree holds as much
+  //! @param entries output files, oldest first
+  //!
+  //! @return false if the tree is not filled
+  //----------------------------------------------------------------------------
+  bool GetOldest(uint64_t cid, uint64_t bytes, std::vector<Entry>& entries);
+
+  //----------------------------------------------------------------------------
+  //! Get the files of a tree created before a given time
+  //!
+  //! @param cid tree
+  //! @param before creation time limit
+  //! @param entries output files, oldest first
+  //!
+  //! @return false if the tree is not filled
+  //----------------------------------------------------------------------------
+  bool GetOlderThan(uint64_t cid, time_t before, std::vector<Entry>& entries);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of indexed files
+  //----------------------------------------------------------------------------
+  size_t GetNumFiles();
+
+  //----------------------------------------------------------------------------
+  //! IFileMDChangeListener interface
+  //----------------------------------------------------------------------------
+  void fileMDChanged(IFileMDChangeListener::Event* event) override;
+  void fileMDRead(IFileMD* obj) override {}
+  bool fileMDCheck(IFileMD* obj) override
+  {
+    return true;
+  }
+  void AddTree(IContainerMD* obj, int64_t dsize) override {}
+  void RemoveTree(IContainerMD* obj, int64_t dsize) override {}
+
+  //----------------------------------------------------------------------------
+  //! IContainerMDChangeListener interface
+  //----------------------------------------------------------------------------
+  void containerMDChanged(IContainerMD* obj,
+                          IContainerMDChangeListener::Action type) override;
+
+private:
+  struct Tree {
+    bool mReady {false}; ///< the tree was filled
+    uint64_t mGeneration {0}; ///< incremented on every invalidation
+    uint64_t mOuter {0}; ///< tree this one is nested in, 0 if none
+    std::unordered_set<uint64_t> mContainers; ///< containers of the tree
+    std::set<std::pair<time_t, uint64_t>> mOrder; ///< (ctime, fid)
+  };
+
+  struct File {
+    uint64_t mTree;
+    time_t mCTime;
+    uint64_t mSize;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Remove a file, mMutex has to be locked
+  //----------------------------------------------------------------------------
+  void RemoveLocked(uint64_t fid);
+
+  //----------------------------------------------------------------------------
+  //! Empty a tree so that it is filled again, mMutex has to be locked
+  //----------------------------------------------------------------------------
+  void InvalidateLocked(uint64_t cid);
+
+  //----------------------------------------------------------------------------
+  //! Drop a tree, mMutex has to be locked
+  //----------------------------------------------------------------------------
+  void UntrackLocked(uint64_t cid);
+
+  bool mRecursive; ///< trees cover their subtree
+  std::atomic<size_t> mNumTrees; ///< lets notifications return early
+  std::mutex mMutex; ///< protects the members below
+  std::map<uint64_t, Tree> mTrees; ///< trees by container id of their top
+  std::unordered_map<uint64_t, uint64_t> mContainers; ///< container -> tree
+  std::unordered_map<uint64_t, File> mFiles; ///< indexed files by fid
+};
+
+EOSMGMNAMESPACE_END
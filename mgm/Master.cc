@@ -27,6 +27,8 @@
 #include "mgm/Quota.hh"
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/Recycle.hh"
+#include "mgm/NsChangeStream.hh"
+#include "mgm/LRU.hh"
 #include "common/Statfs.hh"
 #include "common/ShellCmd.hh"
 #include "common/plugin_manager/PluginManager.hh"
@@ -598,6 +600,12 @@ void*
 Master::Compacting()
 {
   XrdSysThread::SetCancelDeferred();
+  time_t snapshotInterval = 0;
+  time_t nextSnapshot = 0;
+
+  if (getenv("EOS_NS_SNAPSHOT_INTERVAL")) {
+    snapshotInterval = strtol(getenv("EOS_NS_SNAPSHOT_INTERVAL"), 0, 10);
+  }
 
   do {
     time_t now = time(nullptr);
@@ -872,6 +880,47 @@ Master::Compacting()
       }
     }
 
+    // Write the boot snapshots of the changelogs, they are tied to the current
+    // changelog files hence a compaction triggers a new snapshot
+    now = time(nullptr);
+
+    if (runcompacting) {
+      nextSnapshot = 0;
+    }
+
+    if ((snapshotInterval > 0) && (now >= nextSnapshot) && IsMaster() &&
+        !IsCompactingBlocked()) {
+      void* snapData = nullptr;
+      void* snapDirData = nullptr;
+      {
+        // Require NS read lock
+        eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+        snapData = eos_chlog_filesvc->snapshotPrepare();
+        snapDirData = eos_chlog_dirsvc->snapshotPrepare();
+      }
+
+      // Does not require namespace lock, the snapshot data is released in any
+      // case
+      try {
+        eos_chlog_filesvc->snapshot(snapData);
+        MasterLog(eos_info("msg=\"file changelog snapshot written\""));
+      } catch (eos::MDException& e) {
+        MasterLog(eos_err("msg=\"failed to write file changelog snapshot\" "
+                          "ec=%d %s", e.getErrno(), e.getMessage().str().c_str()));
+      }
+
+      try {
+        eos_chlog_dirsvc->snapshot(snapDirData);
+        MasterLog(eos_info("msg=\"directory changelog snapshot written\" "
+                           "elapsed=%lu", time(nullptr) - now));
+      } catch (eos::MDException& e) {
+        MasterLog(eos_err("msg=\"failed to write directory changelog snapshot\" "
+                          "ec=%d %s", e.getErrno(), e.getMessage().str().c_str()));
+      }
+
+      nextSnapshot = now + snapshotInterval;
+    }
+
     // Check only once a minute
     XrdSysThread::CancelPoint();
     std::this_thread::sleep_for(std::chrono::seconds(60));
@@ -1849,6 +1898,14 @@ Master::BootNamespace()
       gOFS->eosFileService->addChangeListener(gOFS->eosContainerAccounting);
     }
 
+    if (gOFS->mNsChangeStream) {
+      gOFS->eosFileService->addChangeListener(gOFS->mNsChangeStream.get());
+      gOFS->eosDirectoryService->addChangeListener(gOFS->mNsChangeStream.get());
+    }
+
+    gOFS->LRUd.RegisterListeners(gOFS->eosFileService,
+                                 gOFS->eosDirectoryService);
+
     // This is only done for the ChangeLog implementation
     auto* eos_chlog_dirsvc =
       dynamic_cast<eos::IChLogContainerMDSvc*>(gOFS->eosDirectoryService);
@@ -0,0 +1,519 @@
+//------------------------------------------------------------------------------
+//! @file NsChangeStream.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/NsChangeStream.hh"
+#include "common/Logging.hh"
+#include "namespace/interface/IContainerMD.hh"
+#include "namespace/interface/IFileMD.hh"
+#include <chrono>
+#include <cstring>
+#include <zmq.hpp>
+
+EOSMGMNAMESPACE_BEGIN
+
+constexpr uint8_t NsChangeStream::sVersion;
+constexpr size_t NsChangeStream::sMaxReplayBatch;
+constexpr size_t NsChangeStream::sMaxPending;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+NsChangeStream::NsChangeStream(const std::string& pub_url,
+                               const std::string& replay_url,
+                               size_t retained, std::function<bool()> ready):
+  mPubUrl(pub_url), mReplayUrl(replay_url), mRetainedMax(retained),
+  mReady(ready)
+{
+  // Start numbering at the startup time so that a restart shows up as a gap
+  mSeq = std::chrono::duration_cast<std::chrono::microseconds>
+         (std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+NsChangeStream::~NsChangeStream()
+{
+  Stop();
+}
+
+//------------------------------------------------------------------------------
+// Start the publisher thread
+//------------------------------------------------------------------------------
+void
+NsChangeStream::Start()
+{
+  mThread.reset(&NsChangeStream::Run, this);
+}
+
+//------------------------------------------------------------------------------
+// Stop the publisher thread
+//------------------------------------------------------------------------------
+void
+NsChangeStream::Stop()
+{
+  mThread.join();
+}
+
+//------------------------------------------------------------------------------
+// File change notification
+//------------------------------------------------------------------------------
+void
+NsChangeStream::fileMDChanged(IFileMDChangeListener::Event* event)
+{
+  if (!mEnabled) {
+    return;
+  }
+
+  IFileMD* file = event->file;
+  char op;
+
+  switch (event->action) {
+  case IFileMDChangeListener::Created:
+    // A new file only gets its name and parent with the following update
+    if (!file->getContainerId()) {
+      std::lock_guard<std::mutex> lock(mMutex);
+
+      if (mCreated.size() >= sMaxPending) {
+        mCreated.clear();
+      }
+
+      mCreated.insert(file->getId());
+      return;
+    }
+
+    op = 'c';
+    break;
+
+  case IFileMDChangeListener::Updated: {
+    std::lock_guard<std::mutex> lock(mMutex);
+    op = mCreated.erase(file->getId()) ? 'c' : 'u';
+    break;
+  }
+
+  case IFileMDChangeListener::Deleted: {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // Never reported
+    if (mCreated.erase(file->getId())) {
+      return;
+    }
+
+    op = 'd';
+    break;
+  }
+
+  default:
+    // Replica and size changes are not part of the stream
+    return;
+  }
+
+  IFileMD::ctime_t mtime;
+  file->getMTime(mtime);
+  Push('f', op, file->getId(), file->getContainerId(), mtime.tv_sec,
+       mtime.tv_nsec, file->getName());
+}
+
+//------------------------------------------------------------------------------
+// Container change notification
+//------------------------------------------------------------------------------
+void
+NsChangeStream::containerMDChanged(IContainerMD* obj,
+                                   IContainerMDChangeListener::Action type)
+{
+  if (!mEnabled) {
+    return;
+  }
+
+  char op;
+
+  switch (type) {
+  case IContainerMDChangeListener::Created:
+    op = 'c';
+    break;
+
+  case IContainerMDChangeListener::Updated:
+    op = 'u';
+    break;
+
+  case IContainerMDChangeListener::Deleted:
+    op = 'd';
+    break;
+
+  default:
+    // The mtime propagation is not part of the stream
+    return;
+  }
+
+  // Like files, new containers are only complete with the first update
+  if (op == 'c' && !obj->getParentId() && (obj->getId() != 1)) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mCreatedContainers.size() >= sMaxPending) {
+      mCreatedContainers.clear();
+    }
+
+    mCreatedContainers.insert(obj->getId());
+    return;
+  } else if (op == 'u') {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mCreatedContainers.erase(obj->getId())) {
+      op = 'c';
+    }
+  } else if (op == 'd') {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mCreatedContainers.erase(obj->getId())) {
+      return;
+    }
+  }
+
+  IContainerMD::mtime_t mtime;
+  obj->getMTime(mtime);
+  Push('d', op, obj->getId(), obj->getParentId(), mtime.tv_sec, mtime.tv_nsec,
+       obj->getName());
+}
+
+//------------------------------------------------------------------------------
+// Queue a change
+//------------------------------------------------------------------------------
+void
+NsChangeStream::Push(char type, char op, uint64_t id, uint64_t parent,
+                     int64_t mtime_sec, uint32_t mtime_nsec,
+                     const std::string& name)
+{
+  Pending pending;
+  Record& rec = pending.mRec;
+  rec.mId = id;
+  rec.mParent = parent;
+  rec.mMtimeSec = mtime_sec;
+  rec.mMtimeNsec = mtime_nsec;
+  rec.mNameLen = (name.length() > UINT16_MAX) ? UINT16_MAX : name.length();
+  rec.mVersion = sVersion;
+  rec.mType = type;
+  rec.mOp = op;
+  pending.mName.assign(name, 0, rec.mNameLen);
+  std::lock_guard<std::mutex> lock(mMutex);
+  // The sequence number is consumed even if the event is dropped, the
+  // consumers detect the gap
+  rec.mSeq = ++mSeq;
+
+  if (mPending.size() >= sMaxPending) {
+    ++mDropped;
+    return;
+  }
+
+  mPending.push_back(std::move(pending));
+}
+
+//------------------------------------------------------------------------------
+// Encode, publish and retain the queued changes
+//------------------------------------------------------------------------------
+void
+NsChangeStream::Process()
+{
+  std::vector<Pending> pending;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    pending.swap(mPending);
+  }
+
+  if (pending.empty()) {
+    return;
+  }
+
+  std::vector<std::string> records(pending.size());
+
+  for (size_t i = 0; i < pending.size(); ++i) {
+    Encode(pending[i].mRec, pending[i].mName, records[i]);
+    Publish(pending[i].mRec.mType, records[i]);
+  }
+
+  mPublished += pending.size();
+  std::lock_guard<std::mutex> lock(mRetainedMutex);
+
+  for (size_t i = 0; i < pending.size(); ++i) {
+    uint64_t seq = pending[i].mRec.mSeq;
+
+    // Dropped events break the sequence, what came before can't be replayed
+    if (mRetained.empty() || (seq != mRetainedFirst + mRetained.size())) {
+      mRetained.clear();
+      mRetainedFirst = seq;
+    }
+
+    mRetained.push_back(std::move(records[i]));
+  }
+
+  while (mRetained.size() > mRetainedMax) {
+    mRetained.pop_front();
+    ++mRetainedFirst;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Collect retained records
+//------------------------------------------------------------------------------
+bool
+NsChangeStream::Replay(uint64_t from, size_t max,
+                       std::vector<std::string>& records)
+{
+  records.clear();
+  std::lock_guard<std::mutex> lock(mRetainedMutex);
+
+  if (mRetained.empty()) {
+    std::lock_guard<std::mutex> slock(mMutex);
+    // Nothing lost as long as nothing was published after from - 1
+    return (from > mSeq);
+  }
+
+  if (from < mRetainedFirst) {
+    return false;
+  }
+
+  for (uint64_t seq = from; (seq < mRetainedFirst + mRetained.size()) &&
+       (records.size() < max); ++seq) {
+    records.push_back(mRetained[seq - mRetainedFirst]);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Encode a record
+//------------------------------------------------------------------------------
+void
+NsChangeStream::Encode(const Record& rec, const std::string& name,
+                       std::string& out)
+{
+  out.resize(sizeof(Record) + rec.mNameLen);
+  memcpy(&out[0], &rec, sizeof(Record));
+  memcpy(&out[sizeof(Record)], name.data(), rec.mNameLen);
+}
+
+//------------------------------------------------------------------------------
+// Decode a record
+//------------------------------------------------------------------------------
+bool
+NsChangeStream::Decode(const std::string& data, Record& rec,
+                       std::string& name)
+{
+  if (data.length() < sizeof(Record)) {
+    return false;
+  }
+
+  memcpy(&rec, data.data(), sizeof(Record));
+
+  if ((rec.mVersion != sVersion) ||
+      (data.length() != sizeof(Record) + rec.mNameLen)) {
+    return false;
+  }
+
+  name.assign(data, sizeof(Record), rec.mNameLen);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the statistics
+//------------------------------------------------------------------------------
+NsChangeStream::Stats
+NsChangeStream::GetStats()
+{
+  Stats stats;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    stats.mLastSeq = mSeq;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mRetainedMutex);
+    stats.mRetained = mRetained.size();
+  }
+  stats.mPublished = mPublished;
+  stats.mDropped = mDropped;
+  stats.mReplayed = mReplayed;
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+// Publish one message
+//------------------------------------------------------------------------------
+void
+NsChangeStream::Publish(char topic, const std::string& data)
+{
+  if (!mPub) {
+    return;
+  }
+
+  // A PUB socket never blocks, messages beyond the high water mark of a slow
+  // subscriber are dropped and show up as a gap
+  zmq::message_t topic_msg(&topic, 1);
+  zmq::message_t data_msg(data.data(), data.size());
+
+  try {
+    mPub->send(topic_msg, ZMQ_SNDMORE | ZMQ_DONTWAIT);
+    mPub->send(data_msg, ZMQ_DONTWAIT);
+  } catch (const zmq::error_t& e) {
+    eos_static_err("msg=\"failed to publish namespace change\" errc=%d",
+                   e.num());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Answer the pending replay requests
+//------------------------------------------------------------------------------
+void
+NsChangeStream::ServeReplay()
+{
+  std::vector<std::string> records;
+
+  while (true) {
+    // Request from a REQ client: identity, empty delimiter, first sequence
+    zmq::message_t frames[3];
+    size_t nframes = 0;
+    int more = 1;
+
+    if (!mReplay->recv(&frames[0], ZMQ_DONTWAIT)) {
+      return;
+    }
+
+    ++nframes;
+
+    while (more) {
+      size_t more_size = sizeof(more);
+      mReplay->getsockopt(ZMQ_RCVMORE, &more, &more_size);
+
+      if (more) {
+        zmq::message_t extra;
+        mReplay->recv((nframes < 3) ? &frames[nframes] : &extra);
+        ++nframes;
+      }
+    }
+
+    if (nframes != 3) {
+      continue;
+    }
+
+    std::string request((const char*) frames[2].data(), frames[2].size());
+    uint64_t from = strtoull(request.c_str(), nullptr, 10);
+    std::string status;
+
+    if (Replay(from, sMaxReplayBatch, records)) {
+      status = "ok " + std::to_string(records.size());
+    } else {
+      std::lock_guard<std::mutex> lock(mRetainedMutex);
+      status = "gap " + std::to_string(mRetainedFirst);
+      records.clear();
+    }
+
+    zmq::message_t status_msg(status.data(), status.size());
+    mReplay->send(frames[0], ZMQ_SNDMORE);
+    mReplay->send(frames[1], ZMQ_SNDMORE);
+    mReplay->send(status_msg, records.empty() ? 0 : ZMQ_SNDMORE);
+
+    for (size_t i = 0; i < records.size(); ++i) {
+      zmq::message_t rec_msg(records[i].data(), records[i].size());
+      mReplay->send(rec_msg, (i + 1 < records.size()) ? ZMQ_SNDMORE : 0);
+    }
+
+    mReplayed += records.size();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Publisher thread loop
+//------------------------------------------------------------------------------
+void
+NsChangeStream::Run(ThreadAssistant& assistant) noexcept
+{
+  try {
+    mCtx.reset(new zmq::context_t(1));
+    mPub.reset(new zmq::socket_t(*mCtx, ZMQ_PUB));
+    mReplay.reset(new zmq::socket_t(*mCtx, ZMQ_ROUTER));
+    int linger = 0;
+    int hwm = 100000;
+    mPub->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+    mPub->setsockopt(ZMQ_SNDHWM, &hwm, sizeof(hwm));
+    mReplay->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+    mPub->bind(mPubUrl.c_str());
+    mReplay->bind(mReplayUrl.c_str());
+  } catch (const zmq::error_t& e) {
+    eos_static_crit("msg=\"failed to start namespace change stream\" "
+                    "pub=%s replay=%s errc=%d", mPubUrl.c_str(),
+                    mReplayUrl.c_str(), e.num());
+    mReplay.reset();
+    mPub.reset();
+    mCtx.reset();
+    return;
+  }
+
+  eos_static_notice("msg=\"namespace change stream started\" pub=%s "
+                    "replay=%s retained=%llu", mPubUrl.c_str(),
+                    mReplayUrl.c_str(), (unsigned long long) mRetainedMax);
+  auto last_beat = std::chrono::steady_clock::now();
+
+  while (!assistant.terminationRequested()) {
+    if (!mEnabled && mReady && mReady()) {
+      mEnabled = true;
+    }
+
+    zmq_pollitem_t items[] = {
+      {static_cast<void*>(*mReplay), 0, ZMQ_POLLIN, 0}
+    };
+
+    try {
+      zmq::poll(items, 1, 10);
+
+      if (items[0].revents & ZMQ_POLLIN) {
+        ServeReplay();
+      }
+
+      Process();
+      auto now = std::chrono::steady_clock::now();
+
+      if (now - last_beat >= std::chrono::seconds(1)) {
+        last_beat = now;
+        Record beat;
+        memset(&beat, 0, sizeof(beat));
+        {
+          std::lock_guard<std::mutex> lock(mMutex);
+          beat.mSeq = mSeq;
+        }
+        beat.mVersion = sVersion;
+        beat.mType = 'h';
+        beat.mOp = 'h';
+        std::string data;
+        Encode(beat, "", data);
+        Publish('h', data);
+      }
+    } catch (const zmq::error_t& e) {
+      eos_static_err("msg=\"namespace change stream error\" errc=%d", e.num());
+      assistant.wait_for(std::chrono::milliseconds(100));
+    }
+  }
+
+  mEnabled = false;
+  mReplay.reset();
+  mPub.reset();
+  mCtx.reset();
+}
+
+EOSMGMNAMESPACE_END
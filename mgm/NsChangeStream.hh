@@ -0,0 +1,236 @@
+//------------------------------------------------------------------------------
+//! @file NsChangeStream.hh
+//! @brief Publish/subscribe stream of the namespace changes over ZMQ
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/AssistedThread.hh"
+#include "namespace/interface/IContainerMDSvc.hh"
+#include "namespace/interface/IFileMDSvc.hh"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace zmq
+{
+class context_t;
+class socket_t;
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Change data capture stream of the namespace
+//!
+//! The stream listens to the file and container services and publishes one
+//! compact record per create, update and delete on a ZMQ PUB socket, so that
+//! external consumers (indexers, cache invalidators) don't have to poll the
+//! namespace. The listener callbacks only queue the event, the records are
+//! encoded and sent by a publisher thread.
+//!
+//! Every message has two frames: the topic ("f" file, "d" container,
+//! "h" heartbeat) and the record. Records carry consecutive sequence numbers,
+//! starting at the startup time in microseconds, so a consumer detects lost
+//! records and MGM restarts as a gap. The last records are kept in memory and
+//! can be requested on the ROUTER replay socket: a REQ client sends the first
+//! sequence number it misses and receives "ok <count>" followed by up to
+//! sMaxReplayBatch records, or "gap <oldest>" if the records are not retained
+//! anymore and a full resync is needed. The heartbeat, sent every second,
+//! holds the last published sequence number.
+//------------------------------------------------------------------------------
+class NsChangeStream: public eos::IFileMDChangeListener,
+  public eos::IContainerMDChangeListener
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Wire format of a record, little endian, followed by mNameLen bytes
+  //----------------------------------------------------------------------------
+  struct Record {
+    uint64_t mSeq;
+    uint64_t mId; ///< fid, cid or, for heartbeats, 0
+    uint64_t mParent; ///< id of the parent container
+    int64_t mMtimeSec;
+    uint32_t mMtimeNsec;
+    uint16_t mNameLen;
+    uint8_t mVersion;
+    char mType; ///< 'f' file, 'd' container, 'h' heartbeat
+    char mOp; ///< 'c' create, 'u' update, 'd' delete, 'h' heartbeat
+  } __attribute__((packed));
+
+  static constexpr uint8_t sVersion = 1;
+  //! Max number of records returned by one replay request
+  static constexpr size_t sMaxReplayBatch = 10000;
+  //! Max number of queued events, beyond that events are dropped
+  static constexpr size_t sMaxPending = 1000000;
+
+  //----------------------------------------------------------------------------
+  //! Statistics
+  //----------------------------------------------------------------------------
+  struct Stats {
+    uint64_t mLastSeq {0}; ///< last assigned sequence number
+    uint64_t mPublished {0}; ///< records published
+    uint64_t mDropped {0}; ///< events dropped because the queue was full
+    uint64_t mReplayed {0}; ///< records sent to replay clients
+    uint64_t mRetained {0}; ///< records available for replay
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param pub_url endpoint of the PUB socket e.g. tcp://*:1101
+  //! @param replay_url endpoint of the replay ROUTER socket
+  //! @param retained number of records kept for replay
+  //! @param ready returns true once events should be published, the events
+  //!        seen while booting the namespace are ignored
+  //----------------------------------------------------------------------------
+  NsChangeStream(const std::string& pub_url, const std::string& replay_url,
+                 size_t retained, std::function<bool()> ready);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~NsChangeStream();
+
+  //----------------------------------------------------------------------------
+  //! Start the publisher thread
+  //----------------------------------------------------------------------------
+  void Start();
+
+  //----------------------------------------------------------------------------
+  //! Stop the publisher thread
+  //----------------------------------------------------------------------------
+  void Stop();
+
+  //----------------------------------------------------------------------------
+  //! IFileMDChangeListener interface
+  //----------------------------------------------------------------------------
+  void fileMDChanged(IFileMDChangeListener::Event* event) override;
+  void fileMDRead(IFileMD* obj) override {}
+  bool fileMDCheck(IFileMD* obj) override
+  {
+    return true;
+  }
+  void AddTree(IContainerMD* obj, int64_t dsize) override {}
+  void RemoveTree(IContainerMD* obj, int64_t dsize) override {}
+
+  //----------------------------------------------------------------------------
+  //! IContainerMDChangeListener interface
+  //----------------------------------------------------------------------------
+  void containerMDChanged(IContainerMD* obj,
+                          IContainerMDChangeListener::Action type) override;
+
+  //----------------------------------------------------------------------------
+  //! Queue a change, called by the listeners
+  //!
+  //! @param type 'f' for files, 'd' for containers
+  //! @param op 'c', 'u' or 'd'
+  //----------------------------------------------------------------------------
+  void Push(char type, char op, uint64_t id, uint64_t parent,
+            int64_t mtime_sec, uint32_t mtime_nsec, const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Encode the queued changes, publish them if the PUB socket is open and
+  //! retain them for replay. Called by the publisher thread.
+  //----------------------------------------------------------------------------
+  void Process();
+
+  //----------------------------------------------------------------------------
+  //! Collect the retained records starting at a sequence number
+  //!
+  //! @param from first sequence number wanted
+  //! @param max max number of records
+  //! @param records output records
+  //!
+  //! @return false if records starting at from are not retained anymore
+  //----------------------------------------------------------------------------
+  bool Replay(uint64_t from, size_t max, std::vector<std::string>& records);
+
+  //----------------------------------------------------------------------------
+  //! Encode a record
+  //----------------------------------------------------------------------------
+  static void Encode(const Record& rec, const std::string& name,
+                     std::string& out);
+
+  //----------------------------------------------------------------------------
+  //! Decode a record
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool Decode(const std::string& data, Record& rec, std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Get the statistics
+  //----------------------------------------------------------------------------
+  Stats GetStats();
+
+private:
+  //----------------------------------------------------------------------------
+  //! Publisher thread loop
+  //----------------------------------------------------------------------------
+  void Run(ThreadAssistant& assistant) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Answer the pending replay requests
+  //----------------------------------------------------------------------------
+  void ServeReplay();
+
+  //----------------------------------------------------------------------------
+  //! Publish one message
+  //----------------------------------------------------------------------------
+  void Publish(char topic, const std::string& data);
+
+  struct Pending {
+    Record mRec;
+    std::string mName;
+  };
+
+  std::string mPubUrl;
+  std::string mReplayUrl;
+  size_t mRetainedMax; ///< max number of records kept for replay
+  std::function<bool()> mReady;
+  std::atomic<bool> mEnabled {false}; ///< events are accepted
+  std::mutex mMutex; ///< protects the queue, the sequence and mCreated*
+  std::vector<Pending> mPending;
+  uint64_t mSeq; ///< last assigned sequence number
+  //! Files and containers created but not attached yet, they are reported as
+  //! created with their first update
+  std::unordered_set<uint64_t> mCreated;
+  std::unordered_set<uint64_t> mCreatedContainers;
+  std::mutex mRetainedMutex; ///< protects the retained records
+  std::deque<std::string> mRetained; ///< encoded records in sequence order
+  uint64_t mRetainedFirst {0}; ///< sequence number of mRetained.front()
+  std::unique_ptr<zmq::context_t> mCtx;
+  std::unique_ptr<zmq::socket_t> mPub;
+  std::unique_ptr<zmq::socket_t> mReplay;
+  std::atomic<uint64_t> mPublished {0};
+  std::atomic<uint64_t> mDropped {0};
+  std::atomic<uint64_t> mReplayed {0};
+  AssistedThread mThread;
+};
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,248 @@
+//------------------------------------------------------------------------------
+//! @file OpenDecisionCache.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/OpenDecisionCache.hh"
+#include <algorithm>
+#include <cstdlib>
+
+EOSMGMNAMESPACE_BEGIN
+
+constexpr size_t OpenDecisionCache::sNumShards;
+
+//------------------------------------------------------------------------------
+// Get the TTL of the entries
+//------------------------------------------------------------------------------
+std::chrono::milliseconds
+OpenDecisionCache::GetTTL()
+{
+  static std::chrono::milliseconds sTTL = []() {
+    const char* ptr = getenv("EOS_MGM_OPEN_CACHE_TTL_MS");
+    long long ttl_ms = (ptr ? strtoll(ptr, nullptr, 10) : 0);
+    return std::chrono::milliseconds(ttl_ms > 0 ? ttl_ms : 0);
+  }();
+  return sTTL;
+}
+
+//------------------------------------------------------------------------------
+// Get the maximum number of entries
+//------------------------------------------------------------------------------
+size_t
+OpenDecisionCache::GetMaxEntries()
+{
+  static size_t sMaxEntries = []() {
+    const char* ptr = getenv("EOS_MGM_OPEN_CACHE_SIZE");
+    long long max_entries = (ptr ? strtoll(ptr, nullptr, 10) : 100000);
+    return (size_t)(max_entries > 0 ? max_entries : 100000);
+  }();
+  return sMaxEntries;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+OpenDecisionCache::OpenDecisionCache(std::chrono::milliseconds ttl,
+                                     size_t max_entries):
+  mTTL(ttl), mMaxPerShard(std::max(max_entries / sNumShards, (size_t) 1))
+{}
+
+//------------------------------------------------------------------------------
+// Get current steady clock time in nanoseconds
+//------------------------------------------------------------------------------
+int64_t
+OpenDecisionCache::GetNowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+         (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------------
+// Get the valid entry of a key, dropping a stale one
+//------------------------------------------------------------------------------
+OpenDecisionCache::Entry*
+OpenDecisionCache::FindLocked(Shard& shard, const Key& key,
+                              const Version& version)
+{
+  auto it = shard.mEntries.find(key);
+
+  if (it == shard.mEntries.end()) {
+    return nullptr;
+  }
+
+  if ((it->second.mExpiresNs <= GetNowNs()) ||
+      (it->second.mVersion != version)) {
+    shard.mLru.erase(it->second.mLru);
+    shard.mEntries.erase(it);
+    return nullptr;
+  }
+
+  shard.mLru.splice(shard.mLru.begin(), shard.mLru, it->second.mLru);
+  return &it->second;
+}
+
+//------------------------------------------------------------------------------
+// Get the cached permission evaluation
+//------------------------------------------------------------------------------
+bool
+OpenDecisionCache::GetAccess(const std::string& ident, uint64_t fid,
+                             const Version& version, Access& access)
+{
+  if (!IsEnabled()) {
+    return false;
+  }
+
+  Shard& shard = GetShard(fid);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  Entry* entry = FindLocked(shard, Key(fid, ident), version);
+
+  if (entry == nullptr) {
+    ++mMisses;
+    return false;
+  }
+
+  access = entry->mAccess;
+  ++mHits;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Store a permission evaluation
+//------------------------------------------------------------------------------
+void
+OpenDecisionCache::PutAccess(const std::string& ident, uint64_t fid,
+                             const Version& version, const Access& access)
+{
+  if (!IsEnabled()) {
+    return;
+  }
+
+  Key key(fid, ident);
+  Shard& shard = GetShard(fid);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  auto it = shard.mEntries.find(key);
+
+  if (it == shard.mEntries.end()) {
+    while (shard.mEntries.size() >= mMaxPerShard) {
+      shard.mEntries.erase(shard.mLru.back());
+      shard.mLru.pop_back();
+    }
+
+    shard.mLru.push_front(key);
+    it = shard.mEntries.emplace(key, Entry()).first;
+    it->second.mLru = shard.mLru.begin();
+  } else {
+    shard.mLru.splice(shard.mLru.begin(), shard.mLru, it->second.mLru);
+  }
+
+  // A new evaluation restarts the entry, the replicas are selected again
+  Entry& entry = it->second;
+  entry.mVersion = version;
+  entry.mExpiresNs = GetNowNs() +
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(mTTL).count();
+  entry.mAccess = access;
+  entry.mHasReplicas = false;
+  entry.mReplicas = Replicas();
+}
+
+//------------------------------------------------------------------------------
+// Get the cached replica selection
+//------------------------------------------------------------------------------
+bool
+OpenDecisionCache::GetReplicas(const std::string& ident, uint64_t fid,
+                               const Version& version, uint64_t fs_generation,
+                               const std::vector<unsigned int>& locations,
+                               Replicas& replicas)
+{
+  if (!IsEnabled()) {
+    return false;
+  }
+
+  Shard& shard = GetShard(fid);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  Entry* entry = FindLocked(shard, Key(fid, ident), version);
+
+  if ((entry == nullptr) || !entry->mHasReplicas ||
+      (entry->mFsGeneration != fs_generation) ||
+      (entry->mReplicas.mLocations != locations)) {
+    ++mMisses;
+    return false;
+  }
+
+  replicas = entry->mReplicas;
+  ++mHits;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Store a successful replica selection
+//------------------------------------------------------------------------------
+void
+OpenDecisionCache::PutReplicas(const std::string& ident, uint64_t fid,
+                               const Version& version, uint64_t fs_generation,
+                               const Replicas& replicas)
+{
+  if (!IsEnabled()) {
+    return;
+  }
+
+  Shard& shard = GetShard(fid);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  Entry* entry = FindLocked(shard, Key(fid, ident), version);
+
+  if (entry == nullptr) {
+    return;
+  }
+
+  entry->mHasReplicas = true;
+  entry->mFsGeneration = fs_generation;
+  entry->mReplicas = replicas;
+}
+
+//------------------------------------------------------------------------------
+// Drop all entries
+//------------------------------------------------------------------------------
+void
+OpenDecisionCache::Clear()
+{
+  for (auto& shard : mShards) {
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    shard.mEntries.clear();
+    shard.mLru.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get number of entries
+//------------------------------------------------------------------------------
+size_t
+OpenDecisionCache::Size()
+{
+  size_t size = 0;
+
+  for (auto& shard : mShards) {
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    size += shard.mEntries.size();
+  }
+
+  return size;
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,233 @@
+//------------------------------------------------------------------------------
+//! @file OpenDecisionCache.hh
+//! @brief Short-lived cache of the access and replica decisions of read opens
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Class OpenDecisionCache - remembers per (identity, file id) the
+//! outcome of the permission evaluation and of the replica selection of read
+//! opens, so that repeated opens of the same file by the same client skip the
+//! attribute listing, the ACL evaluation and the scheduler.
+//!
+//! An entry is only used while it is younger than the TTL and the version of
+//! the file - its mtime and ctime together with the mtime and ctime of its
+//! parent directory - is the one it was taken with. Attribute, mode and
+//! content changes bump these times. The replica selection is dropped in
+//! addition when the locations of the file differ or when the file system
+//! states changed, see GeoTreeEngine::getFsStatusGeneration. Entries are
+//! evicted in LRU order from a hash sharded by file id.
+//------------------------------------------------------------------------------
+class OpenDecisionCache
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Version of a file, any change invalidates the cached decisions
+  //----------------------------------------------------------------------------
+  using Version = std::array<uint64_t, 8>;
+
+  //----------------------------------------------------------------------------
+  //! Outcome of the permission evaluation
+  //----------------------------------------------------------------------------
+  struct Access {
+    uid_t mUid {0}; ///< uid to use after sys.owner.auth
+    gid_t mGid {0}; ///< gid to use after sys.owner.auth
+    std::map<std::string, std::string> mAttrs; ///< attributes of the directory
+  };
+
+  //----------------------------------------------------------------------------
+  //! Outcome of the replica selection
+  //----------------------------------------------------------------------------
+  struct Replicas {
+    std::vector<unsigned int> mLocations; ///< locations given to the scheduler
+    unsigned long mFsIndex {0}; ///< index of the selected replica
+    std::vector<unsigned int> mSelectedFs; ///< locations after the selection
+    std::vector<unsigned int> mUnavailFs; ///< unavailable locations
+    std::vector<std::string> mProxys; ///< data proxies
+    std::vector<std::string> mFirewallEps; ///< firewall entry points
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the TTL of the entries, configured through EOS_MGM_OPEN_CACHE_TTL_MS
+  //! - default 0 which disables the cache
+  //----------------------------------------------------------------------------
+  static std::chrono::milliseconds GetTTL();
+
+  //----------------------------------------------------------------------------
+  //! Get the maximum number of entries, configured through
+  //! EOS_MGM_OPEN_CACHE_SIZE - default 100000
+  //----------------------------------------------------------------------------
+  static size_t GetMaxEntries();
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param ttl maximum age of the entries, 0 disables the cache
+  //! @param max_entries maximum number of entries
+  //----------------------------------------------------------------------------
+  OpenDecisionCache(std::chrono::milliseconds ttl = GetTTL(),
+                    size_t max_entries = GetMaxEntries());
+
+  //----------------------------------------------------------------------------
+  //! Check if the cache is enabled
+  //----------------------------------------------------------------------------
+  inline bool IsEnabled() const
+  {
+    return (mTTL.count() > 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the cached permission evaluation
+  //!
+  //! @param ident identity of the client, see Mapping::VirtualIdentity
+  //! @param fid file id
+  //! @param version current version of the file
+  //! @param access filled if found
+  //!
+  //! @return true if found, otherwise false
+  //----------------------------------------------------------------------------
+  bool GetAccess(const std::string& ident, uint64_t fid,
+                 const Version& version, Access& access);
+
+  //----------------------------------------------------------------------------
+  //! Store a permission evaluation which granted the read
+  //----------------------------------------------------------------------------
+  void PutAccess(const std::string& ident, uint64_t fid,
+                 const Version& version, const Access& access);
+
+  //----------------------------------------------------------------------------
+  //! Get the cached replica selection
+  //!
+  //! @param ident identity of the client
+  //! @param fid file id
+  //! @param version current version of the file
+  //! @param fs_generation current file system status generation
+  //! @param locations current locations of the file
+  //! @param replicas filled if found
+  //!
+  //! @return true if found, otherwise false
+  //----------------------------------------------------------------------------
+  bool GetReplicas(const std::string& ident, uint64_t fid,
+                   const Version& version, uint64_t fs_generation,
+                   const std::vector<unsigned int>& locations,
+                   Replicas& replicas);
+
+  //----------------------------------------------------------------------------
+  //! Store a successful replica selection, the entry needs a cached access
+  //! with the same version
+  //----------------------------------------------------------------------------
+  void PutReplicas(const std::string& ident, uint64_t fid,
+                   const Version& version, uint64_t fs_generation,
+                   const Replicas& replicas);
+
+  //----------------------------------------------------------------------------
+  //! Drop all entries
+  //----------------------------------------------------------------------------
+  void Clear();
+
+  //----------------------------------------------------------------------------
+  //! Get number of entries
+  //----------------------------------------------------------------------------
+  size_t Size();
+
+  //----------------------------------------------------------------------------
+  //! Get number of lookups which found a valid entry
+  //----------------------------------------------------------------------------
+  uint64_t GetHits() const
+  {
+    return mHits;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of lookups which found no valid entry
+  //----------------------------------------------------------------------------
+  uint64_t GetMisses() const
+  {
+    return mMisses;
+  }
+
+private:
+  using Key = std::pair<uint64_t, std::string>;
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const
+    {
+      return std::hash<uint64_t>()(key.first) ^
+             (std::hash<std::string>()(key.second) << 1);
+    }
+  };
+
+  struct Entry {
+    Version mVersion; ///< version of the file
+    int64_t mExpiresNs {0}; ///< steady clock time of expiry
+    Access mAccess; ///< permission evaluation
+    bool mHasReplicas {false}; ///< mReplicas is filled
+    uint64_t mFsGeneration {0}; ///< file system generation of mReplicas
+    Replicas mReplicas; ///< replica selection
+    std::list<Key>::iterator mLru; ///< position in the LRU of the shard
+  };
+
+  struct Shard {
+    std::mutex mMutex;
+    std::unordered_map<Key, Entry, KeyHash> mEntries;
+    std::list<Key> mLru; ///< most recently used first
+  };
+
+  static constexpr size_t sNumShards = 16;
+
+  //----------------------------------------------------------------------------
+  //! Get current steady clock time in nanoseconds
+  //----------------------------------------------------------------------------
+  static int64_t GetNowNs();
+
+  //----------------------------------------------------------------------------
+  //! Get the valid entry of a key, dropping a stale one - needs the shard lock
+  //----------------------------------------------------------------------------
+  Entry* FindLocked(Shard& shard, const Key& key, const Version& version);
+
+  inline Shard& GetShard(uint64_t fid)
+  {
+    return mShards[fid % sNumShards];
+  }
+
+  const std::chrono::milliseconds mTTL; ///< maximum age of the entries
+  const size_t mMaxPerShard; ///< maximum number of entries per shard
+  std::array<Shard, sNumShards> mShards;
+  std::atomic<uint64_t> mHits {0};
+  std::atomic<uint64_t> mMisses {0};
+};
+
+EOSMGMNAMESPACE_END
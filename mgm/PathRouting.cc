@@ -21,13 +21,16 @@
  ************************************************************************/
 
 #include "mgm/PathRouting.hh"
-#include "common/Path.hh"
 #include "common/StringConversion.hh"
 #include "XrdCl/XrdClURL.hh"
+#include <cstring>
+#include <future>
 #include <sstream>
 
 EOSMGMNAMESPACE_BEGIN
 
+constexpr size_t PathRouting::kMaxParallelProbes;
+
 //------------------------------------------------------------------------------
 // Destructor
 //------------------------------------------------------------------------------
@@ -44,6 +47,9 @@ PathRouting::Clear()
 {
   eos::common::RWMutexWriteLock lock(mPathRouteMutex);
   mPathRoute.clear();
+  mRouteIndex.mChildren.clear();
+  mRouteIndex.mRoute = nullptr;
+  mNumRoutes = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -59,6 +65,8 @@ PathRouting::Add(const std::string& path, RouteEndpoint&& endpoint)
   if (it == mPathRoute.end()) {
     auto it_emplace = mPathRoute.emplace(path, std::list<RouteEndpoint>());
     it_emplace.first->second.emplace_back(std::move(endpoint));
+    IndexAdd(*it_emplace.first);
+    mNumRoutes = mPathRoute.size();
   } else {
     bool found = false;
 
@@ -93,10 +101,143 @@ PathRouting::Remove(const std::string& path)
     return false;
   }
 
+  IndexRemove(path);
   mPathRoute.erase(it);
+  mNumRoutes = mPathRoute.size();
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Add a route of the routing table to the index
+//------------------------------------------------------------------------------
+void
+PathRouting::IndexAdd(RouteMap::value_type& route)
+{
+  const std::string& path = route.first;
+
+  if (path.empty() || (path.front() != '/') || (path.back() != '/') ||
+      (path.find("//") != std::string::npos)) {
+    return;
+  }
+
+  RouteNode* node = &mRouteIndex;
+  size_t pos = 1;
+
+  while (pos < path.length()) {
+    size_t end = path.find('/', pos);
+    std::unique_ptr<RouteNode>& child =
+      node->mChildren[path.substr(pos, end - pos)];
+
+    if (!child) {
+      child.reset(new RouteNode());
+    }
+
+    node = child.get();
+    pos = end + 1;
+  }
+
+  node->mRoute = &route;
+}
+
+//------------------------------------------------------------------------------
+// Remove a route from the index
+//------------------------------------------------------------------------------
+void
+PathRouting::IndexRemove(const std::string& path)
+{
+  std::vector<RouteNode*> nodes {&mRouteIndex};
+  std::vector<std::string> names;
+  size_t pos = 1;
+
+  while (pos < path.length()) {
+    size_t end = path.find('/', pos);
+
+    if (end == std::string::npos) {
+      return;
+    }
+
+    names.push_back(path.substr(pos, end - pos));
+    auto it = nodes.back()->mChildren.find(names.back());
+
+    if (it == nodes.back()->mChildren.end()) {
+      return;
+    }
+
+    nodes.push_back(it->second.get());
+    pos = end + 1;
+  }
+
+  if (nodes.back()->mRoute && (nodes.back()->mRoute->first == path)) {
+    nodes.back()->mRoute = nullptr;
+  }
+
+  // Drop the nodes which don't lead to any route anymore
+  while ((nodes.size() > 1) && !nodes.back()->mRoute &&
+         nodes.back()->mChildren.empty()) {
+    nodes.pop_back();
+    nodes.back()->mChildren.erase(names.back());
+    names.pop_back();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Find the longest route matching a path
+//------------------------------------------------------------------------------
+PathRouting::RouteMap::value_type*
+PathRouting::FindRoute(const std::string& path)
+{
+  if (path.front() != '/') {
+    auto it = mPathRoute.find(path);
+    return ((it == mPathRoute.end()) ? nullptr : &(*it));
+  }
+
+  // Node of each path component, null once the path left the index
+  std::vector<const RouteNode*> nodes {&mRouteIndex};
+  std::string name;
+  size_t pos = 1;
+
+  while (pos < path.length()) {
+    size_t end = path.find('/', pos);
+
+    if (end == std::string::npos) {
+      end = path.length();
+    }
+
+    name.assign(path, pos, end - pos);
+    pos = end + 1;
+
+    if (name.empty() || (name == ".")) {
+      continue;
+    }
+
+    if (name == "..") {
+      if (nodes.size() > 1) {
+        nodes.pop_back();
+      }
+
+      continue;
+    }
+
+    const RouteNode* node = nodes.back();
+
+    if (node) {
+      auto it = node->mChildren.find(name);
+      node = ((it == node->mChildren.end()) ? nullptr : it->second.get());
+    }
+
+    nodes.push_back(node);
+  }
+
+  for (size_t i = nodes.size() - 1; i > 0; --i) {
+    if (nodes[i] && nodes[i]->mRoute) {
+      return nodes[i]->mRoute;
+    }
+  }
+
+  // The root route only serves the root path itself
+  return ((nodes.size() == 1) ? mRouteIndex.mRoute : nullptr);
+}
+
 //------------------------------------------------------------------------------
 // Route a path according to the configured routing table
 //------------------------------------------------------------------------------
@@ -106,24 +247,29 @@ PathRouting::Reroute(const char* inpath, const char* ininfo,
                      std::string& host, int& port, std::string& stat_info)
 {
   // Process and extract the path for which we need to do the routing
+  if (!mNumRoutes.load()) {
+    return Status::NOROUTING;
+  }
+
   std::string path = (inpath ? inpath : "");
-  std::string surl = path;
 
-  if (ininfo) {
+  // Only parse the CGI if it can carry the path to route
+  if (ininfo && (strstr(ininfo, "eos.route=") || strstr(ininfo, "mgm.path=") ||
+                 strstr(ininfo, "mgm.quota.space="))) {
+    std::string surl = path;
     surl += "?";
     surl += ininfo;
-  }
-
-  XrdCl::URL url(surl);
-  XrdCl::URL::ParamsMap param = url.GetParams();
-
-  // If there is a routing tag in the CGI, we use that one to map
-  if (param["eos.route"].length()) {
-    path = param["eos.route"];
-  } else if (param["mgm.path"].length()) {
-    path = param["mgm.path"];
-  } else if (param["mgm.quota.space"].length()) {
-    path = param["mgm.quota.space"];
+    XrdCl::URL url(surl);
+    XrdCl::URL::ParamsMap param = url.GetParams();
+
+    // If there is a routing tag in the CGI, we use that one to map
+    if (param["eos.route"].length()) {
+      path = param["eos.route"];
+    } else if (param["mgm.path"].length()) {
+      path = param["mgm.path"];
+    } else if (param["mgm.quota.space"].length()) {
+      path = param["mgm.quota.space"];
+    }
   }
 
   // Make sure path is not empty and is '/' terminated
@@ -145,47 +291,36 @@ PathRouting::Reroute(const char* inpath, const char* ininfo,
     return Status::NOROUTING;
   }
 
-  auto it = mPathRoute.find(path);
-
-  if (it == mPathRoute.end()) {
-    // Try to find the longest possible match
-    eos::common::Path cPath(path.c_str());
-
-    if (!cPath.GetSubPathSize()) {
-      eos_debug("path=%s has no subpath", path.c_str());
-      return Status::NOROUTING;
-    }
-
-    for (size_t i = cPath.GetSubPathSize() - 1; i > 0; i--) {
-      eos_debug("[route] %s => %s\n", path.c_str(), cPath.GetSubPath(i));
-      it = mPathRoute.find(cPath.GetSubPath(i));
-
-      if (it != mPathRoute.end()) {
-        break;
-      }
-    }
+  RouteMap::value_type* route = FindRoute(path);
 
-    // If no match found then return
-    if (it == mPathRoute.end()) {
-      return Status::NOROUTING;
-    }
+  if (!route) {
+    return Status::NOROUTING;
   }
 
   std::ostringstream oss;
   oss << "Rt:";
-  // Try to find the master endpoint, if none exists then just redirect to the
-  // first endpoint in the list if reachable
-  auto* master_ep = &it->second.front();
+  // Try to find the master endpoint, if none exists then redirect to the
+  // online endpoint with the lowest latency
+  const RouteEndpoint* master_ep = nullptr;
 
-  for (auto& endpoint : it->second) {
-    if (endpoint.mIsOnline.load() && endpoint.mIsMaster.load()) {
+  for (const auto& endpoint : route->second) {
+    if (!endpoint.mIsOnline.load()) {
+      continue;
+    }
+
+    if (endpoint.mIsMaster.load()) {
       master_ep = &endpoint;
       break;
     }
+
+    if (!master_ep ||
+        (endpoint.mLatencyUs.load() < master_ep->mLatencyUs.load())) {
+      master_ep = &endpoint;
+    }
   }
 
-  if (!master_ep->mIsOnline.load()) {
-    eos_warning("no online endpoints for route path=%s", it->first.c_str());
+  if (!master_ep) {
+    eos_warning("no online endpoints for route path=%s", route->first.c_str());
     return Status::STALL;
   }
 
@@ -203,7 +338,7 @@ PathRouting::Reroute(const char* inpath, const char* ininfo,
   oss << ":" << host;
   stat_info = oss.str();
   eos_debug("re-routing path=%s using match_path=%s to host=%s port=%d",
-            path.c_str(), it->first.c_str(), host.c_str(), port);
+            path.c_str(), route->first.c_str(), host.c_str(), port);
   return Status::REROUTE;
 }
 
@@ -273,7 +408,44 @@ void
 PathRouting::UpdateEndpointsStatus(ThreadAssistant& assistant) noexcept
 {
   while (!assistant.terminationRequested()) {
-    std::this_thread::sleep_for(mTimeout);
+    assistant.wait_for(mTimeout);
+
+    if (assistant.terminationRequested()) {
+      break;
+    }
+
+    // Copy each distinct endpoint to probe it without the lock
+    std::map<std::string, std::unique_ptr<RouteEndpoint>> probes;
+    {
+      eos::common::RWMutexReadLock route_rd_lock(mPathRouteMutex);
+
+      for (const auto& route : mPathRoute) {
+        for (const auto& endpoint : route.second) {
+          std::unique_ptr<RouteEndpoint>& probe = probes[endpoint.ToString()];
+
+          if (!probe) {
+            probe.reset(new RouteEndpoint(endpoint.GetHostname(),
+                                          endpoint.GetXrdPort(),
+                                          endpoint.GetHttpPort()));
+            probe->mLatencyUs.store(endpoint.mLatencyUs.load());
+          }
+        }
+      }
+    }
+    std::vector<std::future<void>> futures;
+
+    for (auto& probe : probes) {
+      futures.push_back(std::async(std::launch::async,
+                                   &RouteEndpoint::UpdateStatus,
+                                   probe.second.get()));
+
+      // Destroying the futures waits for the probes to finish
+      if (futures.size() == kMaxParallelProbes) {
+        futures.clear();
+      }
+    }
+
+    futures.clear();
     eos::common::RWMutexReadLock route_rd_lock(mPathRouteMutex);
 
     for (auto& route : mPathRoute) {
@@ -281,7 +453,13 @@ PathRouting::UpdateEndpointsStatus(ThreadAssistant& assistant) noexcept
       eos_debug("checking route='%s'", route.first.c_str());
 
       for (auto& endpoint : route.second) {
-        endpoint.UpdateStatus();
+        auto it = probes.find(endpoint.ToString());
+
+        if (it != probes.end()) {
+          endpoint.mIsOnline.store(it->second->mIsOnline.load());
+          endpoint.mIsMaster.store(it->second->mIsMaster.load());
+          endpoint.mLatencyUs.store(it->second->mLatencyUs.load());
+        }
 
         if (endpoint.mIsOnline.load() && endpoint.mIsMaster.load()) {
           ++num_masters;
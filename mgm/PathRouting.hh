@@ -26,8 +26,10 @@
 #include "common/Logging.hh"
 #include "common/AssistedThread.hh"
 #include "mgm/RouteEndpoint.hh"
-#include <map>
+#include <atomic>
 #include <list>
+#include <map>
+#include <memory>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -38,6 +40,9 @@ class PathRouting: public eos::common::LogId
 {
 public:
 
+  //! Max number of endpoints probed in parallel
+  static constexpr size_t kMaxParallelProbes = 32;
+
   //! Reroute response type
   enum class Status {
     REROUTE,   ///! Route was found and available
@@ -66,7 +71,10 @@ public:
   //----------------------------------------------------------------------------
   //! @brief Route a path according to the configured routing table. This
   //! function does the path translation according to the configured routing
-  //! table. It applies the 'longest' matching rule.
+  //! table. It applies the 'longest' matching rule using an index of the
+  //! routes by path component, so the cost only depends on the path length.
+  //! The master endpoint is used if there is one, otherwise the online
+  //! endpoint with the lowest ping latency.
   //!
   //! @param inpath path to route
   //! @param ininfo opaque information
@@ -117,16 +125,53 @@ public:
   bool GetListing(const std::string& path, std::string& out) const;
 
 private:
+  using RouteMap = std::map<std::string, std::list<RouteEndpoint>>;
+
+  //----------------------------------------------------------------------------
+  //! Node of the route index, one per path component
+  //----------------------------------------------------------------------------
+  struct RouteNode {
+    //! Nodes of the next path components
+    std::map<std::string, std::unique_ptr<RouteNode>> mChildren;
+    RouteMap::value_type* mRoute {nullptr}; ///< route ending at this node
+  };
 
   //----------------------------------------------------------------------------
   //! Method executed by an async thread which is updating the current master
-  //! endpoint for each routing
+  //! endpoint for each routing. Every distinct endpoint is probed once per
+  //! round, in parallel and without holding the routing table lock.
   //!
   //! @param assistant thread executing the method
   //----------------------------------------------------------------------------
   void UpdateEndpointsStatus(ThreadAssistant& assistant) noexcept;
 
-  std::map<std::string, std::list<RouteEndpoint>> mPathRoute;
+  //----------------------------------------------------------------------------
+  //! Add a route of the routing table to the index, only the routes given as
+  //! '/' terminated absolute paths are indexed as only those can match
+  //!
+  //! @param route entry of the routing table
+  //----------------------------------------------------------------------------
+  void IndexAdd(RouteMap::value_type& route);
+
+  //----------------------------------------------------------------------------
+  //! Remove a route from the index
+  //!
+  //! @param path routing path
+  //----------------------------------------------------------------------------
+  void IndexRemove(const std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Find the longest route matching a '/' terminated path
+  //!
+  //! @param path path to route
+  //!
+  //! @return matching entry of the routing table or nullptr
+  //----------------------------------------------------------------------------
+  RouteMap::value_type* FindRoute(const std::string& path);
+
+  RouteMap mPathRoute;
+  RouteNode mRouteIndex; ///< Index of the routes by path component
+  std::atomic<size_t> mNumRoutes {0}; ///< Number of routes in the table
   mutable eos::common::RWMutex mPathRouteMutex;
   AssistedThread mThread; ///< Thread updating the master endpoints
   std::chrono::seconds mTimeout; ///< Update timeout
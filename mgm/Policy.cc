@@ -26,6 +26,7 @@
 #include "common/LayoutId.hh"
 #include "common/Mapping.hh"
 #include "mgm/Policy.hh"
+#include "mgm/FsView.hh"
 /*----------------------------------------------------------------------------*/
 
 /*----------------------------------------------------------------------------*/
@@ -33,6 +34,106 @@
 
 EOSMGMNAMESPACE_BEGIN
 
+namespace
+{
+//------------------------------------------------------------------------------
+// Parse a forced layout parameter like the opaque tag of a client
+//------------------------------------------------------------------------------
+void
+ParseForced(const eos::IContainerMD::XAttrMap& map, const char* key,
+            const char* tag, unsigned long(*parser)(XrdOucEnv&),
+            Policy::DirPolicy::Forced<unsigned long>& forced)
+{
+  auto it = map.find(key);
+
+  if (it != map.end()) {
+    XrdOucString layoutstring = tag;
+    layoutstring += "=";
+    layoutstring += it->second.c_str();
+    XrdOucEnv layoutenv(layoutstring.c_str());
+    forced.Assign(parser(layoutenv));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check if an attribute is set to "1"
+//------------------------------------------------------------------------------
+bool
+IsEnabled(const eos::IContainerMD::XAttrMap& map, const char* key)
+{
+  auto it = map.find(key);
+  return ((it != map.end()) && (it->second == "1"));
+}
+}
+
+//------------------------------------------------------------------------------
+// Parse the forced settings out of the attributes of a directory
+//------------------------------------------------------------------------------
+void
+Policy::GetDirPolicy(const eos::IContainerMD::XAttrMap& map,
+                     DirPolicy& policy)
+{
+  using eos::common::LayoutId;
+  policy = DirPolicy();
+  auto it = map.find("sys.forced.space");
+
+  if (it != map.end()) {
+    policy.mSpace.Assign(it->second);
+  }
+
+  if ((it = map.find("sys.forced.group")) != map.end()) {
+    policy.mGroup.Assign(strtol(it->second.c_str(), 0, 10));
+  }
+
+  ParseForced(map, "sys.forced.layout", "eos.layout.type",
+              LayoutId::GetLayoutFromEnv, policy.mLayout);
+  ParseForced(map, "sys.forced.checksum", "eos.layout.checksum",
+              LayoutId::GetChecksumFromEnv, policy.mChecksum);
+  ParseForced(map, "sys.forced.blockchecksum", "eos.layout.blockchecksum",
+              LayoutId::GetBlockChecksumFromEnv, policy.mBlockChecksum);
+  ParseForced(map, "sys.forced.nstripes", "eos.layout.nstripes",
+              LayoutId::GetStripeNumberFromEnv, policy.mStripes);
+  ParseForced(map, "sys.forced.blocksize", "eos.layout.blocksize",
+              LayoutId::GetBlocksizeFromEnv, policy.mBlocksize);
+
+  // the user settings win over the sys ones unless the directory forbids them
+  if (!IsEnabled(map, "sys.forced.nouserlayout") &&
+      !IsEnabled(map, "user.forced.nouserlayout")) {
+    if ((it = map.find("user.forced.space")) != map.end()) {
+      policy.mSpace.Assign(it->second);
+    }
+
+    ParseForced(map, "user.forced.layout", "eos.layout.type",
+                LayoutId::GetLayoutFromEnv, policy.mLayout);
+    ParseForced(map, "user.forced.checksum", "eos.layout.checksum",
+                LayoutId::GetChecksumFromEnv, policy.mChecksum);
+    ParseForced(map, "user.forced.blockchecksum", "eos.layout.blockchecksum",
+                LayoutId::GetBlockChecksumFromEnv, policy.mBlockChecksum);
+    ParseForced(map, "user.forced.nstripes", "eos.layout.nstripes",
+                LayoutId::GetStripeNumberFromEnv, policy.mStripes);
+    ParseForced(map, "user.forced.blocksize", "eos.layout.blocksize",
+                LayoutId::GetBlocksizeFromEnv, policy.mBlocksize);
+  }
+
+  if ((it = map.find("sys.tier.hot")) != map.end()) {
+    // new files of a tiering policy always land in the hot space, they are
+    // moved to the cold space by the LRU engine once cooled down
+    policy.mSpace.Assign(it->second);
+  }
+
+  policy.mNoFsSelection = (IsEnabled(map, "sys.forced.nofsselection") ||
+                           IsEnabled(map, "user.forced.nofsselection"));
+
+  if ((it = map.find("sys.forced.placementpolicy")) != map.end()) {
+    // we force to use a certain placement policy even if the user wants something else
+    policy.mPlacement.Assign(it->second);
+  } else if (!IsEnabled(map, "sys.forced.nouserplacementpolicy") &&
+             !IsEnabled(map, "user.forced.nouserplacementpolicy") &&
+             ((it = map.find("user.forced.placementpolicy")) != map.end())) {
+    policy.mPlacement.Assign(it->second);
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 void
 Policy::GetLayoutAndSpace(const char* path,
@@ -43,6 +144,25 @@ Policy::GetLayoutAndSpace(const char* path,
                           unsigned long& forcedfsid,
                           long& forcedgroup)
 
+{
+  DirPolicy policy;
+  GetDirPolicy(attrmap, policy);
+  GetLayoutAndSpace(path, policy, vid, layoutId, space, env, forcedfsid,
+                    forcedgroup);
+}
+
+//------------------------------------------------------------------------------
+// Apply the forced settings of a directory to the layout requested by the
+// client
+//------------------------------------------------------------------------------
+void
+Policy::GetLayoutAndSpace(const char* path,
+                          const DirPolicy& policy,
+                          const eos::common::Mapping::VirtualIdentity& vid,
+                          unsigned long& layoutId, XrdOucString& space,
+                          XrdOucEnv& env,
+                          unsigned long& forcedfsid,
+                          long& forcedgroup)
 {
   // this is for the moment only defaulting or manual selection
   unsigned long layout = eos::common::LayoutId::GetLayoutFromEnv(env);
@@ -77,123 +197,36 @@ Policy::GetLayoutAndSpace(const char* path,
   if ((vid.uid == 0) && (val = env.Get("eos.layout.noforce"))) {
     // root can request not to apply any forced settings
   } else {
-    if (attrmap.count("sys.forced.space")) {
-      // we force to use a certain space in this directory even if the user wants something else
-      space = attrmap["sys.forced.space"].c_str();
-      eos_static_debug("sys.forced.space in %s", path);
+    // we force the settings of this directory even if the user wants something else
+    if (policy.mSpace.mSet) {
+      space = policy.mSpace.mValue.c_str();
     }
 
-    if (attrmap.count("sys.forced.group")) {
-      // we force to use a certain group in this directory even if the user wants something else
-      forcedgroup = strtol(attrmap["sys.forced.group"].c_str(), 0, 10);
-      eos_static_debug("sys.forced.group in %s", path);
+    if (policy.mGroup.mSet) {
+      forcedgroup = policy.mGroup.mValue;
     }
 
-    if (attrmap.count("sys.forced.layout")) {
-      XrdOucString layoutstring = "eos.layout.type=";
-      layoutstring += attrmap["sys.forced.layout"].c_str();
-      XrdOucEnv layoutenv(layoutstring.c_str());
-      // we force to use a specified layout in this directory even if the user wants something else
-      layout = eos::common::LayoutId::GetLayoutFromEnv(layoutenv);
-      eos_static_debug("sys.forced.layout in %s", path);
+    if (policy.mLayout.mSet) {
+      layout = policy.mLayout.mValue;
     }
 
-    if (attrmap.count("sys.forced.checksum") && (!noforcedchecksum)) {
-      XrdOucString layoutstring = "eos.layout.checksum=";
-      layoutstring += attrmap["sys.forced.checksum"].c_str();
-      XrdOucEnv layoutenv(layoutstring.c_str());
-      // we force to use a specified checksumming in this directory even if the user wants something else
-      xsum = eos::common::LayoutId::GetChecksumFromEnv(layoutenv);
-      eos_static_debug("sys.forced.checksum in %s", path);
+    if (policy.mChecksum.mSet && (!noforcedchecksum)) {
+      xsum = policy.mChecksum.mValue;
     }
 
-    if (attrmap.count("sys.forced.blockchecksum")) {
-      XrdOucString layoutstring = "eos.layout.blockchecksum=";
-      layoutstring += attrmap["sys.forced.blockchecksum"].c_str();
-      XrdOucEnv layoutenv(layoutstring.c_str());
-      // we force to use a specified checksumming in this directory even if the user wants something else
-      bxsum = eos::common::LayoutId::GetBlockChecksumFromEnv(layoutenv);
-      eos_static_debug("sys.forced.blockchecksum in %s %x", path, bxsum);
+    if (policy.mBlockChecksum.mSet) {
+      bxsum = policy.mBlockChecksum.mValue;
     }
 
-    if (attrmap.count("sys.forced.nstripes")) {
-      XrdOucString layoutstring = "eos.layout.nstripes=";
-      layoutstring += attrmap["sys.forced.nstripes"].c_str();
-      XrdOucEnv layoutenv(layoutstring.c_str());
-      // we force to use a specified stripe number in this directory even if the user wants something else
-      stripes = eos::common::LayoutId::GetStripeNumberFromEnv(layoutenv);
-      eos_static_debug("sys.forced.nstripes in %s", path);
+    if (policy.mStripes.mSet) {
+      stripes = policy.mStripes.mValue;
     }
 
-    if (attrmap.count("sys.forced.blocksize")) {
-      XrdOucString layoutstring = "eos.layout.blocksize=";
-      layoutstring += attrmap["sys.forced.blocksize"].c_str();
-      XrdOucEnv layoutenv(layoutstring.c_str());
-      // we force to use a specified stripe width in this directory even if the user wants something else
-      blocksize = eos::common::LayoutId::GetBlocksizeFromEnv(layoutenv);
-      eos_static_debug("sys.forced.blocksize in %s : %llu", path, blocksize);
+    if (policy.mBlocksize.mSet) {
+      blocksize = policy.mBlocksize.mValue;
     }
 
-    if (((!attrmap.count("sys.forced.nouserlayout")) ||
-         (attrmap["sys.forced.nouserlayout"] != "1")) &&
-        ((!attrmap.count("user.forced.nouserlayout")) ||
-         (attrmap["user.forced.nouserlayout"] != "1"))) {
-      if (attrmap.count("user.forced.space")) {
-        // we force to use a certain space in this directory even if the user wants something else
-        space = attrmap["user.forced.space"].c_str();
-        eos_static_debug("user.forced.space in %s", path);
-      }
-
-      if (attrmap.count("user.forced.layout")) {
-        XrdOucString layoutstring = "eos.layout.type=";
-        layoutstring += attrmap["user.forced.layout"].c_str();
-        XrdOucEnv layoutenv(layoutstring.c_str());
-        // we force to use a specified layout in this directory even if the user wants something else
-        layout = eos::common::LayoutId::GetLayoutFromEnv(layoutenv);
-        eos_static_debug("user.forced.layout in %s", path);
-      }
-
-      if (attrmap.count("user.forced.checksum") && (!noforcedchecksum)) {
-        XrdOucString layoutstring = "eos.layout.checksum=";
-        layoutstring += attrmap["user.forced.checksum"].c_str();
-        XrdOucEnv layoutenv(layoutstring.c_str());
-        // we force to use a specified checksumming in this directory even if the user wants something else
-        xsum = eos::common::LayoutId::GetChecksumFromEnv(layoutenv);
-        eos_static_debug("user.forced.checksum in %s", path);
-      }
-
-      if (attrmap.count("user.forced.blockchecksum")) {
-        XrdOucString layoutstring = "eos.layout.blockchecksum=";
-        layoutstring += attrmap["user.forced.blockchecksum"].c_str();
-        XrdOucEnv layoutenv(layoutstring.c_str());
-        // we force to use a specified checksumming in this directory even if the user wants something else
-        bxsum = eos::common::LayoutId::GetBlockChecksumFromEnv(layoutenv);
-        eos_static_debug("user.forced.blockchecksum in %s", path);
-      }
-
-      if (attrmap.count("user.forced.nstripes")) {
-        XrdOucString layoutstring = "eos.layout.nstripes=";
-        layoutstring += attrmap["user.forced.nstripes"].c_str();
-        XrdOucEnv layoutenv(layoutstring.c_str());
-        // we force to use a specified stripe number in this directory even if the user wants something else
-        stripes = eos::common::LayoutId::GetStripeNumberFromEnv(layoutenv);
-        eos_static_debug("user.forced.nstripes in %s", path);
-      }
-
-      if (attrmap.count("user.forced.blocksize")) {
-        XrdOucString layoutstring = "eos.layout.blocksize=";
-        layoutstring += attrmap["user.forced.blocksize"].c_str();
-        XrdOucEnv layoutenv(layoutstring.c_str());
-        // we force to use a specified stripe width in this directory even if the user wants something else
-        blocksize = eos::common::LayoutId::GetBlocksizeFromEnv(layoutenv);
-        eos_static_debug("user.forced.blocksize in %s", path);
-      }
-    }
-
-    if ((attrmap.count("sys.forced.nofsselection") &&
-         (attrmap["sys.forced.nofsselection"] == "1")) ||
-        (attrmap.count("user.forced.nofsselection") &&
-         (attrmap["user.forced.nofsselection"] == "1"))) {
+    if (policy.mNoFsSelection) {
       eos_static_debug("<sys|user>.forced.nofsselection in %s", path);
       forcedfsid = 0;
     } else {
@@ -203,6 +236,10 @@ Policy::GetLayoutAndSpace(const char* path,
         forcedfsid = 0;
       }
     }
+
+    eos_static_debug("forced settings in %s space=%s layout=%lx xs=%lx "
+                     "bxs=%lx stripes=%lu blocksize=%lu", path, space.c_str(),
+                     layout, xsum, bxsum, stripes, blocksize);
   }
 
   layoutId = eos::common::LayoutId::GetId(layout, xsum, stripes, blocksize,
@@ -218,6 +255,22 @@ Policy::GetPlctPolicy(const char* path,
                       XrdOucEnv& env,
                       eos::mgm::Scheduler::tPlctPolicy& plctpol,
                       std::string& targetgeotag)
+{
+  DirPolicy policy;
+  GetDirPolicy(attrmap, policy);
+  GetPlctPolicy(path, policy, vid, env, plctpol, targetgeotag);
+}
+
+//------------------------------------------------------------------------------
+// Apply the forced placement policy of a directory
+//------------------------------------------------------------------------------
+void
+Policy::GetPlctPolicy(const char* path,
+                      const DirPolicy& policy,
+                      const eos::common::Mapping::VirtualIdentity& vid,
+                      XrdOucEnv& env,
+                      eos::mgm::Scheduler::tPlctPolicy& plctpol,
+                      std::string& targetgeotag)
 {
   // default to save
   plctpol = eos::mgm::Scheduler::kScattered;
@@ -231,22 +284,9 @@ Policy::GetPlctPolicy(const char* path,
 
   if ((vid.uid == 0) && (val = env.Get("eos.placementpolicy.noforce"))) {
     // root can request not to apply any forced settings
-  } else if (attrmap.count("sys.forced.placementpolicy")) {
-    // we force to use a certain placement policy even if the user wants something else
-    policyString = attrmap["sys.forced.placementpolicy"].c_str();
-    eos_static_debug("sys.forced.placementpolicy in %s", path);
-  } else {
-    // check there are no user placement restrictions
-    if (((!attrmap.count("sys.forced.nouserplacementpolicy")) ||
-         (attrmap["sys.forced.nouserplacementpolicy"] != "1")) &&
-        ((!attrmap.count("user.forced.nouserplacementpolicy")) ||
-         (attrmap["user.forced.nouserplacementpolicy"] != "1"))) {
-      if (attrmap.count("user.forced.placementpolicy")) {
-        // we use the user defined placement policy
-        policyString = attrmap["user.forced.placementpolicy"].c_str();
-        eos_static_debug("user.forced.placementpolicy in %s", path);
-      }
-    }
+  } else if (policy.mPlacement.mSet) {
+    policyString = policy.mPlacement.mValue;
+    eos_static_debug("forced placement policy in %s", path);
   }
 
   if (policyString.empty() || policyString == "scattered") {
@@ -277,6 +317,34 @@ Policy::GetPlctPolicy(const char* path,
   return;
 }
 
+//------------------------------------------------------------------------------
+// Get the locations of a file which are in a given space
+//------------------------------------------------------------------------------
+void
+Policy::GetLocationsInSpace(const std::string& space,
+                            const std::vector<eos::common::FileSystem::fsid_t>&
+                            locations,
+                            std::vector<eos::common::FileSystem::fsid_t>& in_space)
+{
+  in_space.clear();
+  eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+
+  for (auto fsid : locations) {
+    auto it = FsView::gFsView.mIdView.find(fsid);
+
+    if (it == FsView::gFsView.mIdView.end()) {
+      continue;
+    }
+
+    // The scheduling group is <space>.<index>
+    std::string group = it->second->GetString("schedgroup");
+
+    if (group.substr(0, group.find('.')) == space) {
+      in_space.push_back(fsid);
+    }
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 bool
 Policy::Set(const char* value)
@@ -34,6 +34,8 @@
 #include "XrdOuc/XrdOucEnv.hh"
 /*----------------------------------------------------------------------------*/
 #include <sys/types.h>
+#include <string>
+#include <vector>
 
 /*----------------------------------------------------------------------------*/
 
@@ -43,10 +45,65 @@ class Policy
 {
 public:
 
+  //----------------------------------------------------------------------------
+  //! Settings forced by the attributes of a directory, parsed once so that
+  //! the creations in a directory only have to apply them
+  //----------------------------------------------------------------------------
+  struct DirPolicy {
+    //! Forced value, applied only if set
+    template<typename T>
+    struct Forced {
+      bool mSet {false};
+      T mValue {};
+
+      void Assign(const T& value)
+      {
+        mSet = true;
+        mValue = value;
+      }
+    };
+
+    Forced<std::string> mSpace; ///< sys|user.forced.space, sys.tier.hot
+    Forced<long> mGroup; ///< sys.forced.group
+    Forced<unsigned long> mLayout; ///< sys|user.forced.layout
+    Forced<unsigned long> mChecksum; ///< sys|user.forced.checksum
+    Forced<unsigned long> mBlockChecksum; ///< sys|user.forced.blockchecksum
+    Forced<unsigned long> mStripes; ///< sys|user.forced.nstripes
+    Forced<unsigned long> mBlocksize; ///< sys|user.forced.blocksize
+    bool mNoFsSelection {false}; ///< sys|user.forced.nofsselection
+    Forced<std::string> mPlacement; ///< sys|user.forced.placementpolicy
+  };
+
   Policy () { };
 
   ~Policy () { };
 
+  //----------------------------------------------------------------------------
+  //! Parse the forced settings out of the attributes of a directory, the
+  //! user.forced settings are only taken if the directory allows them
+  //!
+  //! @param map attributes of the directory
+  //! @param policy filled with the forced settings
+  //----------------------------------------------------------------------------
+  static void GetDirPolicy (const eos::IContainerMD::XAttrMap& map,
+                            DirPolicy& policy);
+
+  static void GetLayoutAndSpace (const char* path,
+                                 const DirPolicy& policy,
+                                 const eos::common::Mapping::VirtualIdentity &vid,
+                                 unsigned long &layoutId,
+                                 XrdOucString &space,
+                                 XrdOucEnv &env,
+                                 unsigned long &forcedfsid,
+                                 long &forcedgroup);
+
+  static void GetPlctPolicy (const char* path,
+                             const DirPolicy& policy,
+                             const eos::common::Mapping::VirtualIdentity &vid,
+                             XrdOucEnv &env,
+                             eos::mgm::Scheduler::tPlctPolicy &plctpo,
+                             std::string &targetgeotag);
+
   static void GetLayoutAndSpace (const char* path,
                                  eos::IContainerMD::XAttrMap &map,
                                  const eos::common::Mapping::VirtualIdentity &vid,
@@ -63,6 +120,18 @@ public:
                              eos::mgm::Scheduler::tPlctPolicy &plctpo,
                              std::string &targetgeotag);
 
+  //----------------------------------------------------------------------------
+  //! Get the locations of a file which are in a given space
+  //!
+  //! @param space space name
+  //! @param locations file system ids of the locations
+  //! @param in_space filled with the locations in the space
+  //----------------------------------------------------------------------------
+  static void GetLocationsInSpace(const std::string& space,
+                                  const std::vector<eos::common::FileSystem::fsid_t>&
+                                  locations,
+                                  std::vector<eos::common::FileSystem::fsid_t>& in_space);
+
   static bool Set (const char* value);
   static bool Set (XrdOucEnv &env, int &retc, XrdOucString &stdOut, XrdOucString &stdErr);
   static void Ls (XrdOucEnv &env, int &retc, XrdOucString &stdOut, XrdOucString &stdErr);
@@ -20,6 +20,8 @@
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/Quota.hh"
 #include "mgm/Access.hh"
+#include "mgm/NsChangeStream.hh"
+#include "mgm/LRU.hh"
 #include "mgm/WFE.hh"
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IFileMDSvc.hh"
@@ -29,11 +31,13 @@
 #include "namespace/ns_quarkdb/BackendClient.hh"
 #include "namespace/ns_quarkdb/Constants.hh"
 #include "common/plugin_manager/PluginManager.hh"
+#include <algorithm>
 
 EOSMGMNAMESPACE_BEGIN
 
 std::string QdbMaster::sLeaseKey {"master_lease"};
 std::chrono::milliseconds QdbMaster::sLeaseTimeout {10000};
+std::chrono::seconds QdbMaster::sWarmupSaveInterval {300};
 
 //------------------------------------------------------------------------------
 // Constructor
@@ -42,7 +46,7 @@ QdbMaster::QdbMaster(const eos::QdbContactDetails& qdb_info,
                      const std::string& host_port):
   mOneOff(true), mIdentity(host_port), mMasterIdentity(),
   mIsMaster(false),  mConfigLoaded(false),
-  mAcquireDelay(0)
+  mAcquireDelay(0), mLastWarmupSave(0), mLastWarmupLoad(0)
 {
   mQcl = eos::BackendClient::getInstance(qdb_info, "MGM_HA");
 }
@@ -53,6 +57,7 @@ QdbMaster::QdbMaster(const eos::QdbContactDetails& qdb_info,
 QdbMaster::~QdbMaster()
 {
   mThread.join();
+  mWarmupThread.join();
 }
 
 //------------------------------------------------------------------------------
@@ -116,6 +121,10 @@ QdbMaster::BootNamespace()
     fileSettings["qdb_cluster"] = gOFS->mQdbCluster;
     fileSettings["qdb_password"] = gOFS->mQdbPassword;
     fileSettings["qdb_flusher_md"] = instance_id.str() + "_md";
+
+    if (getenv("EOS_MGM_NS_PREFETCH_FS_LISTS")) {
+      fileSettings[fsview::sPrefetchFsLists] = "true";
+    }
   }
 
   time_t tstart = time(nullptr);
@@ -132,6 +141,15 @@ QdbMaster::BootNamespace()
     gOFS->eosFileService->addChangeListener(gOFS->eosFsView);
     gOFS->eosDirectoryService->addChangeListener(gOFS->eosSyncTimeAccounting);
     gOFS->eosFileService->addChangeListener(gOFS->eosContainerAccounting);
+
+    if (gOFS->mNsChangeStream) {
+      gOFS->eosFileService->addChangeListener(gOFS->mNsChangeStream.get());
+      gOFS->eosDirectoryService->addChangeListener(gOFS->mNsChangeStream.get());
+    }
+
+    gOFS->LRUd.RegisterListeners(gOFS->eosFileService,
+                                 gOFS->eosDirectoryService);
+
     gOFS->eosFileService->setQuotaStats(gOFS->eosView->getQuotaStats());
     gOFS->eosDirectoryService->setQuotaStats(gOFS->eosView->getQuotaStats());
     gOFS->eosDirectoryService->setContainerAccounting(gOFS->eosContainerAccounting);
@@ -259,6 +277,18 @@ QdbMaster::Supervisor(ThreadAssistant& assistant) noexcept
       }
     }
 
+    if (mIsMaster &&
+        (time(nullptr) - mLastWarmupSave >= sWarmupSaveInterval.count())) {
+      SaveNsWarmupList();
+    }
+
+    // A hot standby follows the working set of the master
+    if (!mIsMaster && IsHotStandby() && GetNumWarmupContainers() &&
+        (time(nullptr) - mLastWarmupLoad >= sWarmupSaveInterval.count())) {
+      mLastWarmupLoad = time(nullptr);
+      mWarmupThread.reset(&QdbMaster::WarmupNsCache, this);
+    }
+
     // If there is a master then wait a bit
     if (!GetMasterId().empty()) {
       std::chrono::milliseconds wait_ms(sLeaseTimeout.count() / 2);
@@ -300,6 +330,19 @@ QdbMaster::SlaveToMaster()
   stall_thread.detach();
   Quota::LoadNodes();
   EnableNsCaching();
+
+  // Catch up with the last modifications of the previous master, then
+  // publish ours for the standbys
+  if (IsHotStandby()) {
+    std::map<std::string, std::string> map_cfg;
+    map_cfg[constants::sCacheInvalidation] = "publish";
+    gOFS->eosFileService->configure(map_cfg);
+  }
+
+  if (GetNumWarmupContainers()) {
+    mWarmupThread.reset(&QdbMaster::WarmupNsCache, this);
+  }
+
   WFE::MoveFromRBackToQ();
   // Notify all the nodes about the new master identity
   FsView::gFsView.BroadcastMasterId(GetMasterId());
@@ -316,6 +359,13 @@ QdbMaster::MasterToSlave()
 {
   eos_info("%s", "msg=\"master to slave transition\"");
   RemoveStatusFile(EOSMGMMASTER_SUBSYS_RW_LOCKFILE);
+  mWarmupThread.join();
+
+  // Leave the current working set to the next master
+  if (mIsMaster) {
+    SaveNsWarmupList();
+  }
+
   mIsMaster = false;
   Access::StallInfo old_stall; // to be discarded
   Access::StallInfo new_stall("*", "5", "master->slave transition", true);
@@ -328,7 +378,20 @@ QdbMaster::MasterToSlave()
     new_master_id.clear();
   }
 
-  DisableNsCaching();
+  if (IsHotStandby()) {
+    // Keep caching, the entries modified by the master are dropped
+    std::map<std::string, std::string> map_cfg;
+    map_cfg[constants::sCacheInvalidation] = "follow";
+    gOFS->eosFileService->configure(map_cfg);
+    EnableNsCaching();
+    // Renames done by the master are not seen by the path cache
+    map_cfg.clear();
+    map_cfg[constants::sMaxNumCachePaths] = "0";
+    gOFS->eosDirectoryService->configure(map_cfg);
+  } else {
+    DisableNsCaching();
+  }
+
   Access::SetMasterToSlaveRules(new_master_id);
   gOFS->mDrainEngine.Stop();
 }
@@ -546,6 +609,7 @@ QdbMaster::DisableNsCaching()
   std::map<std::string, std::string> map_cfg;
   map_cfg[constants::sMaxNumCacheFiles] = "0";
   map_cfg[constants::sMaxNumCacheDirs] = "0";
+  map_cfg[constants::sMaxNumCachePaths] = "0";
   gOFS->eosFileService->configure(map_cfg);
   gOFS->eosDirectoryService->configure(map_cfg);
   // @todo(esindril): disabling caching and dropping all values can lead to
@@ -562,8 +626,95 @@ QdbMaster::EnableNsCaching()
   std::map<std::string, std::string> map_cfg;
   map_cfg[constants::sMaxNumCacheFiles] = std::to_string(3e7);
   map_cfg[constants::sMaxNumCacheDirs] = std::to_string(3e6);
+  map_cfg[constants::sMaxNumCachePaths] = std::to_string(1e5);
   gOFS->eosFileService->configure(map_cfg);
   gOFS->eosDirectoryService->configure(map_cfg);
 }
 
+//------------------------------------------------------------------------------
+// Check if the slave keeps its namespace cache warm and coherent
+//------------------------------------------------------------------------------
+bool
+QdbMaster::IsHotStandby()
+{
+  static const bool hot_standby = []() {
+    const char* ptr = getenv("EOS_MGM_NS_HOT_STANDBY");
+    return (ptr && (strtoll(ptr, nullptr, 10) != 0));
+  }();
+  return hot_standby;
+}
+
+//------------------------------------------------------------------------------
+// Get number of containers to warm up the cache with
+//------------------------------------------------------------------------------
+uint64_t
+QdbMaster::GetNumWarmupContainers()
+{
+  static const uint64_t num_containers = []() {
+    const char* ptr = getenv("EOS_MGM_NS_WARMUP_CONTAINERS");
+    long long val = (ptr ? strtoll(ptr, nullptr, 10) : 0);
+    return (uint64_t)(val > 0 ? val : 0);
+  }();
+  return num_containers;
+}
+
+//------------------------------------------------------------------------------
+// Persist the ids of the most recently used containers if enabled
+//------------------------------------------------------------------------------
+void
+QdbMaster::SaveNsWarmupList()
+{
+  mLastWarmupSave = time(nullptr);
+  uint64_t num_containers = GetNumWarmupContainers();
+
+  if (num_containers == 0) {
+    return;
+  }
+
+  try {
+    gOFS->eosDirectoryService->saveCacheWarmupList(num_containers);
+  } catch (const std::exception& e) {
+    eos_err("msg=\"failed to save cache warm-up list\" reason=\"%s\"",
+            e.what());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Method loading the containers persisted by the previous master into the
+// cache
+//------------------------------------------------------------------------------
+void
+QdbMaster::WarmupNsCache(ThreadAssistant& assistant) noexcept
+{
+  static constexpr size_t batch_size = 10000;
+  time_t tstart = time(nullptr);
+  size_t num_loaded = 0;
+
+  try {
+    std::vector<IContainerMD::id_t> ids =
+      gOFS->eosDirectoryService->loadCacheWarmupList();
+
+    if (ids.size() > GetNumWarmupContainers()) {
+      ids.resize(GetNumWarmupContainers());
+    }
+
+    // Batches bound the number of lookups in flight and allow to stop early
+    // if we lose the master role in the meantime
+    for (size_t pos = 0; (pos < ids.size()) &&
+         !assistant.terminationRequested(); pos += batch_size) {
+      std::vector<IContainerMD::id_t> batch(ids.begin() + pos, ids.begin() +
+                                            std::min(ids.size(), pos + batch_size));
+      gOFS->eosDirectoryService->prefetchContainers(batch);
+      num_loaded += batch.size();
+    }
+  } catch (const std::exception& e) {
+    eos_err("msg=\"failed to warm up namespace cache\" reason=\"%s\"",
+            e.what());
+  }
+
+  eos_notice("msg=\"namespace cache warm-up done\" containers=%llu "
+             "duration=%llus", (unsigned long long) num_loaded,
+             (unsigned long long)(time(nullptr) - tstart));
+}
+
 EOSMGMNAMESPACE_END
@@ -40,6 +40,8 @@ class QdbMaster: public IMaster
 public:
   static std::string sLeaseKey;
   static std::chrono::milliseconds sLeaseTimeout;
+  //! Interval at which the master persists its cache warm-up list
+  static std::chrono::seconds sWarmupSaveInterval;
 
   //----------------------------------------------------------------------------
   //! Constructor
@@ -224,6 +226,31 @@ private:
   //----------------------------------------------------------------------------
   void EnableNsCaching();
 
+  //----------------------------------------------------------------------------
+  //! Check if the slave keeps its namespace cache warm and coherent by
+  //! following the modifications published by the master
+  //----------------------------------------------------------------------------
+  static bool IsHotStandby();
+
+  //----------------------------------------------------------------------------
+  //! Get number of containers to warm up the cache with after a slave to
+  //! master transition, 0 if disabled
+  //----------------------------------------------------------------------------
+  static uint64_t GetNumWarmupContainers();
+
+  //----------------------------------------------------------------------------
+  //! Persist the ids of the most recently used containers if enabled
+  //----------------------------------------------------------------------------
+  void SaveNsWarmupList();
+
+  //----------------------------------------------------------------------------
+  //! Method loading the containers persisted by the previous master into the
+  //! cache
+  //!
+  //! @param assistant thread executing the method
+  //----------------------------------------------------------------------------
+  void WarmupNsCache(ThreadAssistant& assistant) noexcept;
+
   std::atomic<bool> mOneOff; ///< Flag to mark that supervisor ran once
   std::string mIdentity; ///< MGM identity hostname:port
   mutable std::mutex mMutexId; ///< Mutex for the master identity
@@ -234,6 +261,9 @@ private:
   ///! give the chance to other MGMs to become masters
   std::atomic<time_t> mAcquireDelay;
   AssistedThread mThread; ///< Supervisor thread updating master/slave state
+  AssistedThread mWarmupThread; ///< Thread warming up the namespace cache
+  time_t mLastWarmupSave; ///< Last time the warm-up list was persisted
+  time_t mLastWarmupLoad; ///< Last time a standby loaded the warm-up list
   qclient::QClient* mQcl; ///< qclient for talking to the QDB cluster
 };
 
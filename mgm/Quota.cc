@@ -26,13 +26,20 @@
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/TableFormatter/TableFormatterBase.hh"
 #include "namespace/interface/IView.hh"
+#include <algorithm>
+#include <chrono>
 #include <errno.h>
+#include <tuple>
 
 EOSMGMNAMESPACE_BEGIN
 
 std::map<std::string, SpaceQuota*> Quota::pMapQuota;
 std::map<eos::IContainerMD::id_t, SpaceQuota*> Quota::pMapInodeQuota;
-eos::common::RWMutex Quota::pMapMutex;
+eos::common::RWMutex Quota::pMapMutex(false, true);
+std::mutex Quota::pCacheMutex;
+std::unordered_map<eos::IContainerMD::id_t, eos::IContainerMD::id_t>
+Quota::pMapContainerQuota;
+constexpr size_t Quota::sMaxCachedContainers;
 gid_t Quota::gProjectId = 99;
 
 #ifdef __APPLE__
@@ -203,10 +210,8 @@ bool
 SpaceQuota::RmQuota(unsigned long tag, unsigned long id)
 {
   eos_debug("rm quota tag=%lu id=%lu", tag, id);
-  XrdSysMutexHelper scope_lock(mMutex);
 
-  if (mMapIdQuota.count(Index(tag, id))) {
-    mMapIdQuota.erase(Index(tag, id));
+  if (mMapIdQuota.Erase(Index(tag, id))) {
     mDirtyTarget = true;
     return true;
   }
@@ -220,8 +225,7 @@ SpaceQuota::RmQuota(unsigned long tag, unsigned long id)
 long long
 SpaceQuota::GetQuota(unsigned long tag, unsigned long id)
 {
-  XrdSysMutexHelper scope_lock(mMutex);
-  return static_cast<long long>(mMapIdQuota[Index(tag, id)]);
+  return static_cast<long long>(mMapIdQuota.Get(Index(tag, id)));
 }
 
 //------------------------------------------------------------------------------
@@ -232,8 +236,7 @@ SpaceQuota::SetQuota(unsigned long tag, unsigned long id,
                      unsigned long long value)
 {
   eos_debug("set quota tag=%lu id=%lu value=%llu", tag, id, value);
-  XrdSysMutexHelper scope_lock(mMutex);
-  mMapIdQuota[Index(tag, id)] = value;
+  mMapIdQuota.Set(Index(tag, id), value);
 
   if ((tag == kUserBytesTarget) ||
       (tag == kGroupBytesTarget) ||
@@ -251,7 +254,7 @@ SpaceQuota::SetQuota(unsigned long tag, unsigned long id,
 void
 SpaceQuota::ResetQuota(unsigned long tag, unsigned long id)
 {
-  mMapIdQuota[Index(tag, id)] = 0;
+  mMapIdQuota.Set(Index(tag, id), 0);
 
   if ((tag == kUserBytesTarget) ||
       (tag == kGroupBytesTarget) ||
@@ -272,12 +275,9 @@ SpaceQuota::AddQuota(unsigned long tag, unsigned long id, long long value)
   eos_debug("add quota tag=%lu id=%lu value=%llu", tag, id, value);
 
   // Avoid negative numbers
-  if (((long long) mMapIdQuota[Index(tag, id)] + value) >= 0) {
-    mMapIdQuota[Index(tag, id)] += value;
-  }
-
+  mMapIdQuota.Add(Index(tag, id), value);
   eos_debug("sum quota tag=%lu id=%lu value=%llu", tag, id,
-            mMapIdQuota[Index(tag, id)]);
+            mMapIdQuota.Get(Index(tag, id)));
 }
 
 //------------------------------------------------------------------------------
@@ -293,80 +293,78 @@ SpaceQuota::UpdateTargetSums()
   eos_debug("updating targets");
   XrdSysMutexHelper scope_lock(mMutex);
   mDirtyTarget = false;
-  mMapIdQuota[Index(kAllUserBytesTarget, 0)] = 0;
-  mMapIdQuota[Index(kAllUserFilesTarget, 0)] = 0;
-  mMapIdQuota[Index(kAllGroupBytesTarget, 0)] = 0;
-  mMapIdQuota[Index(kAllGroupFilesTarget, 0)] = 0;
-  mMapIdQuota[Index(kAllUserLogicalBytesTarget, 0)] = 0;
-  mMapIdQuota[Index(kAllGroupLogicalBytesTarget, 0)] = 0;
-
-  for (auto it = mMapIdQuota.begin(); it != mMapIdQuota.end(); it++) {
-    if ((UnIndex(it->first) == kUserBytesTarget)) {
-      AddQuota(kAllUserBytesTarget, 0, it->second);
-      AddQuota(kAllUserLogicalBytesTarget, 0, it->second / mLayoutSizeFactor);
+  // Sum up locally and publish the totals at once so that readers never see
+  // partial sums
+  long long user_bytes = 0, user_logical_bytes = 0, user_files = 0;
+  long long group_bytes = 0, group_logical_bytes = 0, group_files = 0;
+  mMapIdQuota.ForEach([&](uint64_t key, unsigned long long value) {
+    if ((UnIndex(key) == kUserBytesTarget)) {
+      user_bytes += value;
+      user_logical_bytes += (long long)(value / mLayoutSizeFactor);
     }
 
-    if ((UnIndex(it->first) == kUserFilesTarget)) {
-      AddQuota(kAllUserFilesTarget, 0, it->second);
+    if ((UnIndex(key) == kUserFilesTarget)) {
+      user_files += value;
     }
 
-    if ((UnIndex(it->first) == kGroupBytesTarget)) {
-      AddQuota(kAllGroupBytesTarget, 0, it->second);
-      AddQuota(kAllGroupLogicalBytesTarget, 0, it->second / mLayoutSizeFactor);
+    if ((UnIndex(key) == kGroupBytesTarget)) {
+      group_bytes += value;
+      group_logical_bytes += (long long)(value / mLayoutSizeFactor);
     }
 
-    if ((UnIndex(it->first) == kGroupFilesTarget)) {
-      AddQuota(kAllGroupFilesTarget, 0, it->second);
+    if ((UnIndex(key) == kGroupFilesTarget)) {
+      group_files += value;
     }
-  }
+  });
+  mMapIdQuota.Set(Index(kAllUserBytesTarget, 0), user_bytes);
+  mMapIdQuota.Set(Index(kAllUserLogicalBytesTarget, 0), user_logical_bytes);
+  mMapIdQuota.Set(Index(kAllUserFilesTarget, 0), user_files);
+  mMapIdQuota.Set(Index(kAllGroupBytesTarget, 0), group_bytes);
+  mMapIdQuota.Set(Index(kAllGroupLogicalBytesTarget, 0), group_logical_bytes);
+  mMapIdQuota.Set(Index(kAllGroupFilesTarget, 0), group_files);
 }
 
 //------------------------------------------------------------------------------
-//
+// Update current quota values
 //------------------------------------------------------------------------------
 void
 SpaceQuota::UpdateIsSums()
 {
   eos_debug("updating IS values");
   XrdSysMutexHelper scope_lock(mMutex);
-  mMapIdQuota[Index(kAllUserBytesIs, 0)] = 0;
-  mMapIdQuota[Index(kAllUserLogicalBytesIs, 0)] = 0;
-  mMapIdQuota[Index(kAllUserFilesIs, 0)] = 0;
-  mMapIdQuota[Index(kAllGroupBytesIs, 0)] = 0;
-  mMapIdQuota[Index(kAllGroupFilesIs, 0)] = 0;
-  mMapIdQuota[Index(kAllGroupLogicalBytesIs, 0)] = 0;
-  mMapIdQuota[Index(kAllUserBytesIs, 0)] = 0;
-  mMapIdQuota[Index(kAllUserLogicalBytesIs, 0)] = 0;
-  mMapIdQuota[Index(kAllUserFilesIs, 0)] = 0;
-  mMapIdQuota[Index(kAllGroupBytesIs, 0)] = 0;
-  mMapIdQuota[Index(kAllGroupFilesIs, 0)] = 0;
-  mMapIdQuota[Index(kAllGroupLogicalBytesIs, 0)] = 0;
-
-  for (auto it = mMapIdQuota.begin(); it != mMapIdQuota.end(); it++) {
-    if ((UnIndex(it->first) == kUserBytesIs)) {
-      AddQuota(kAllUserBytesIs, 0, it->second);
+  long long user_bytes = 0, user_logical_bytes = 0, user_files = 0;
+  long long group_bytes = 0, group_logical_bytes = 0, group_files = 0;
+  mMapIdQuota.ForEach([&](uint64_t key, unsigned long long value) {
+    if ((UnIndex(key) == kUserBytesIs)) {
+      user_bytes += value;
     }
 
-    if ((UnIndex(it->first) == kUserLogicalBytesIs)) {
-      AddQuota(kAllUserLogicalBytesIs, 0, it->second);
+    if ((UnIndex(key) == kUserLogicalBytesIs)) {
+      user_logical_bytes += value;
     }
 
-    if ((UnIndex(it->first) == kUserFilesIs)) {
-      AddQuota(kAllUserFilesIs, 0, it->second);
+    if ((UnIndex(key) == kUserFilesIs)) {
+      user_files += value;
     }
 
-    if ((UnIndex(it->first) == kGroupBytesIs)) {
-      AddQuota(kAllGroupBytesIs, 0, it->second);
+    if ((UnIndex(key) == kGroupBytesIs)) {
+      group_bytes += value;
     }
 
-    if ((UnIndex(it->first) == kGroupLogicalBytesIs)) {
-      AddQuota(kAllGroupLogicalBytesIs, 0, it->second);
+    if ((UnIndex(key) == kGroupLogicalBytesIs)) {
+      group_logical_bytes += value;
     }
 
-    if ((UnIndex(it->first) == kGroupFilesIs)) {
-      AddQuota(kAllGroupFilesIs, 0, it->second);
+    if ((UnIndex(key) == kGroupFilesIs)) {
+      group_files += value;
     }
-  }
+  });
+  mMapIdQuota.Set(Index(kAllUserBytesIs, 0), user_bytes);
+  mMapIdQuota.Set(Index(kAllUserLogicalBytesIs, 0), user_logical_bytes);
+  mMapIdQuota.Set(Index(kAllUserFilesIs, 0), user_files);
+  mMapIdQuota.Set(Index(kAllGroupBytesIs, 0), group_bytes);
+  mMapIdQuota.Set(Index(kAllGroupLogicalBytesIs, 0), group_logical_bytes);
+  mMapIdQuota.Set(Index(kAllGroupFilesIs, 0), group_files);
 }
 
 //------------------------------------------------------------------------------
@@ -376,24 +374,23 @@ void
 SpaceQuota::UpdateFromQuotaNode(uid_t uid, gid_t gid, bool upd_proj_quota)
 {
   eos_debug("updating uid/gid values from quota node");
-  XrdSysMutexHelper scope_lock(mMutex);
 
+  // The per identity counters are plain atomic stores, this runs for every
+  // write placement and does not take the mutex
   if (mQuotaNode) {
-    mMapIdQuota[Index(kUserBytesIs, uid)] = 0;
-    mMapIdQuota[Index(kUserLogicalBytesIs, uid)] = 0;
-    mMapIdQuota[Index(kUserFilesIs, uid)] = 0;
-    mMapIdQuota[Index(kGroupBytesIs, gid)] = 0;
-    mMapIdQuota[Index(kGroupFilesIs, gid)] = 0;
-    mMapIdQuota[Index(kGroupLogicalBytesIs, gid)] = 0;
-    AddQuota(kUserBytesIs, uid, mQuotaNode->getPhysicalSpaceByUser(uid));
-    AddQuota(kUserLogicalBytesIs, uid, mQuotaNode->getUsedSpaceByUser(uid));
-    AddQuota(kUserFilesIs, uid, mQuotaNode->getNumFilesByUser(uid));
-    AddQuota(kGroupBytesIs, gid, mQuotaNode->getPhysicalSpaceByGroup(gid));
-    AddQuota(kGroupLogicalBytesIs, gid, mQuotaNode->getUsedSpaceByGroup(gid));
-    AddQuota(kGroupFilesIs, gid, mQuotaNode->getNumFilesByGroup(gid));
-    mMapIdQuota[Index(kUserBytesIs, Quota::gProjectId)] = 0;
-    mMapIdQuota[Index(kUserLogicalBytesIs, Quota::gProjectId)] = 0;
-    mMapIdQuota[Index(kUserFilesIs, Quota::gProjectId)] = 0;
+    mMapIdQuota.Set(Index(kUserBytesIs, uid),
+                    mQuotaNode->getPhysicalSpaceByUser(uid));
+    mMapIdQuota.Set(Index(kUserLogicalBytesIs, uid),
+                    mQuotaNode->getUsedSpaceByUser(uid));
+    mMapIdQuota.Set(Index(kUserFilesIs, uid), mQuotaNode->getNumFilesByUser(uid));
+    mMapIdQuota.Set(Index(kGroupBytesIs, gid),
+                    mQuotaNode->getPhysicalSpaceByGroup(gid));
+    mMapIdQuota.Set(Index(kGroupLogicalBytesIs, gid),
+                    mQuotaNode->getUsedSpaceByGroup(gid));
+    mMapIdQuota.Set(Index(kGroupFilesIs, gid), mQuotaNode->getNumFilesByGroup(gid));
+    mMapIdQuota.Set(Index(kUserBytesIs, Quota::gProjectId), 0);
+    mMapIdQuota.Set(Index(kUserLogicalBytesIs, Quota::gProjectId), 0);
+    mMapIdQuota.Set(Index(kUserFilesIs, Quota::gProjectId), 0);
 
     if (upd_proj_quota) {
       // Recalculate the project quota only every 5 seconds to boost perf.
@@ -412,19 +409,21 @@ SpaceQuota::UpdateFromQuotaNode(uid_t uid, gid_t gid, bool upd_proj_quota)
       }
 
       if (docalc) {
-        mMapIdQuota[Index(kGroupBytesIs, Quota::gProjectId)] = 0;
-        mMapIdQuota[Index(kGroupFilesIs, Quota::gProjectId)] = 0;
-        mMapIdQuota[Index(kGroupLogicalBytesIs, Quota::gProjectId)] = 0;
+        XrdSysMutexHelper scope_lock(mMutex);
+        unsigned long long bytes = 0, logical_bytes = 0, files = 0;
         // Loop over users and fill project quota
         auto uids = mQuotaNode->getUids();
 
         for (auto itu = uids.begin(); itu != uids.end(); ++itu) {
-          AddQuota(kGroupBytesIs, Quota::gProjectId,
-                   mQuotaNode->getPhysicalSpaceByUser(*itu));
-          AddQuota(kGroupLogicalBytesIs, Quota::gProjectId,
-                   mQuotaNode->getUsedSpaceByUser(*itu));
-          AddQuota(kGroupFilesIs, Quota::gProjectId, mQuotaNode->getNumFilesByUser(*itu));
+          bytes += mQuotaNode->getPhysicalSpaceByUser(*itu);
+          logical_bytes += mQuotaNode->getUsedSpaceByUser(*itu);
+          files += mQuotaNode->getNumFilesByUser(*itu);
         }
+
+        mMapIdQuota.Set(Index(kGroupBytesIs, Quota::gProjectId), bytes);
+        mMapIdQuota.Set(Index(kGroupLogicalBytesIs, Quota::gProjectId),
+                        logical_bytes);
+        mMapIdQuota.Set(Index(kGroupFilesIs, Quota::gProjectId), files);
       }
     }
   }
@@ -453,17 +452,21 @@ SpaceQuota::PrintOut(XrdOucString& output, long long int uid_sel,
   // Make a map containing once all the defined uid's and gid's
   std::vector<std::pair<std::string, unsigned>> uids, gids;
   {
-    XrdSysMutexHelper scope_lock(mMutex);
+    std::vector<uint64_t> keys;
+    mMapIdQuota.ForEach([&](uint64_t key, unsigned long long value) {
+      keys.push_back(key);
+    });
+    std::sort(keys.begin(), keys.end());
 
     // For project space we just print the user/group entry gProjectId
-    if (mMapIdQuota[Index(kGroupBytesTarget, Quota::gProjectId)] > 0) {
+    if (GetQuota(kGroupBytesTarget, Quota::gProjectId) > 0) {
       gid_sel = Quota::gProjectId;
     }
 
-    for (auto it = mMapIdQuota.begin(); it != mMapIdQuota.end(); ++it) {
-      if ((UnIndex(it->first) >= kUserBytesIs) &&
-          (UnIndex(it->first) <= kUserFilesTarget)) {
-        long long int uid = (long long int)((it->first) & 0xffffffff);
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+      if ((UnIndex(*it) >= kUserBytesIs) &&
+          (UnIndex(*it) <= kUserFilesTarget)) {
+        long long int uid = (long long int)((*it) & 0xffffffff);
 
         // uid selection filter
         if ((uid_sel >= 0LL) && (uid != uid_sel)) {
@@ -490,9 +493,9 @@ SpaceQuota::PrintOut(XrdOucString& output, long long int uid_sel,
         uids.push_back(std::make_pair(name, uid));
       }
 
-      if ((UnIndex(it->first) >= kGroupBytesIs) &&
-          (UnIndex(it->first) <= kGroupFilesTarget)) {
-        long long int gid = (it->first) & 0xfffffff;
+      if ((UnIndex(*it) >= kGroupBytesIs) &&
+          (UnIndex(*it) <= kGroupFilesTarget)) {
+        long long int gid = (*it) & 0xfffffff;
 
         // uid selection filter
         if ((gid_sel >= 0LL) && (gid != gid_sel)) {
@@ -1017,31 +1020,30 @@ SpaceQuota::AccountNsToSpace()
 {
   if (UpdateQuotaNodeAddress()) {
     XrdSysMutexHelper scope_lock(mMutex);
-    // Insert current state of a single quota node into a SpaceQuota
-    ResetQuota(kGroupBytesIs, Quota::gProjectId);
-    ResetQuota(kGroupFilesIs, Quota::gProjectId);
-    ResetQuota(kGroupLogicalBytesIs, Quota::gProjectId);
+    // Insert current state of a single quota node into a SpaceQuota, the
+    // project totals are summed up locally and published at once
+    bool is_project = (GetQuota(kGroupBytesTarget, Quota::gProjectId) > 0);
+    unsigned long long proj_bytes = 0, proj_logical_bytes = 0, proj_files = 0;
     // Loop over users
     auto uids = mQuotaNode->getUids();
 
     for (auto itu = uids.begin(); itu != uids.end(); ++itu) {
-      ResetQuota(kUserBytesIs, *itu);
-      AddQuota(kUserBytesIs, *itu, mQuotaNode->getPhysicalSpaceByUser(*itu));
-      ResetQuota(kUserFilesIs, *itu);
-      AddQuota(kUserFilesIs, *itu, mQuotaNode->getNumFilesByUser(*itu));
-      ResetQuota(kUserLogicalBytesIs, *itu);
-      AddQuota(kUserLogicalBytesIs, *itu, mQuotaNode->getUsedSpaceByUser(*itu));
-
-      if (mMapIdQuota[Index(kGroupBytesTarget, Quota::gProjectId)] > 0) {
+      SetQuota(kUserBytesIs, *itu, mQuotaNode->getPhysicalSpaceByUser(*itu));
+      SetQuota(kUserFilesIs, *itu, mQuotaNode->getNumFilesByUser(*itu));
+      SetQuota(kUserLogicalBytesIs, *itu, mQuotaNode->getUsedSpaceByUser(*itu));
+
+      if (is_project) {
         // Only account in project quota nodes
-        AddQuota(kGroupBytesIs, Quota::gProjectId,
-                 mQuotaNode->getPhysicalSpaceByUser(*itu));
-        AddQuota(kGroupLogicalBytesIs, Quota::gProjectId,
-                 mQuotaNode->getUsedSpaceByUser(*itu));
-        AddQuota(kGroupFilesIs, Quota::gProjectId, mQuotaNode->getNumFilesByUser(*itu));
+        proj_bytes += mQuotaNode->getPhysicalSpaceByUser(*itu);
+        proj_logical_bytes += mQuotaNode->getUsedSpaceByUser(*itu);
+        proj_files += mQuotaNode->getNumFilesByUser(*itu);
       }
     }
 
+    SetQuota(kGroupBytesIs, Quota::gProjectId, proj_bytes);
+    SetQuota(kGroupLogicalBytesIs, Quota::gProjectId, proj_logical_bytes);
+    SetQuota(kGroupFilesIs, Quota::gProjectId, proj_files);
+
     auto gids = mQuotaNode->getGids();
 
     for (auto itg = gids.begin(); itg != gids.end(); ++itg) {
@@ -1050,12 +1052,9 @@ SpaceQuota::AccountNsToSpace()
         continue;
       }
 
-      ResetQuota(kGroupBytesIs, *itg);
-      AddQuota(kGroupBytesIs, *itg, mQuotaNode->getPhysicalSpaceByGroup(*itg));
-      ResetQuota(kGroupFilesIs, *itg);
-      AddQuota(kGroupFilesIs, *itg, mQuotaNode->getNumFilesByGroup(*itg));
-      ResetQuota(kGroupLogicalBytesIs, *itg);
-      AddQuota(kGroupLogicalBytesIs, *itg, mQuotaNode->getUsedSpaceByGroup(*itg));
+      SetQuota(kGroupBytesIs, *itg, mQuotaNode->getPhysicalSpaceByGroup(*itg));
+      SetQuota(kGroupFilesIs, *itg, mQuotaNode->getNumFilesByGroup(*itg));
+      SetQuota(kGroupLogicalBytesIs, *itg, mQuotaNode->getUsedSpaceByGroup(*itg));
     }
   }
 }
@@ -1314,6 +1313,125 @@ Quota::GetResponsibleSpaceQuota(const std::string& path)
   return squota;
 }
 
+//------------------------------------------------------------------------------
+// Resolve the quota node responsible for a container by walking up its
+// parents - the result is cached per container id
+//------------------------------------------------------------------------------
+bool
+Quota::ResolveResponsibleNode(eos::IContainerMD::id_t cid,
+                              eos::IContainerMD::id_t& qnode_id)
+{
+  {
+    std::lock_guard<std::mutex> cache_lock(pCacheMutex);
+    auto it = pMapContainerQuota.find(cid);
+
+    if (it != pMapContainerQuota.end()) {
+      qnode_id = it->second;
+      return true;
+    }
+  }
+
+  // The namespace and quota locks prevent concurrent moves of containers and
+  // changes of the quota nodes which would invalidate the result
+  eos::common::RWMutexReadLock rd_ns_lock(gOFS->eosViewRWMutex);
+  eos::common::RWMutexReadLock rd_quota_lock(pMapMutex);
+  std::vector<eos::IContainerMD::id_t> visited;
+  eos::IContainerMD::id_t id = cid;
+  bool done = false;
+  qnode_id = 0;
+
+  try {
+    // Bound the walk in case of a corrupted hierarchy
+    for (size_t depth = 0; depth < 1024; ++depth) {
+      if (pMapInodeQuota.count(id)) {
+        qnode_id = id;
+        done = true;
+        break;
+      }
+
+      {
+        std::lock_guard<std::mutex> cache_lock(pCacheMutex);
+        auto it = pMapContainerQuota.find(id);
+
+        if (it != pMapContainerQuota.end()) {
+          qnode_id = it->second;
+          done = true;
+          break;
+        }
+      }
+
+      visited.push_back(id);
+      std::shared_ptr<eos::IContainerMD> cont =
+        gOFS->eosDirectoryService->getContainerMD(id);
+      eos::IContainerMD::id_t pid = cont->getParentId();
+
+      // The root container is its own parent
+      if ((pid == id) || (pid == 0)) {
+        done = true;
+        break;
+      }
+
+      id = pid;
+    }
+  } catch (const eos::MDException& e) {
+    eos_static_debug("msg="failed to resolve quota node" cid=%llu emsg="%s"",
+                     (unsigned long long) cid, e.getMessage().str().c_str());
+    return false;
+  }
+
+  if (!done) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> cache_lock(pCacheMutex);
+
+  if (pMapContainerQuota.size() + visited.size() > sMaxCachedContainers) {
+    pMapContainerQuota.clear();
+  }
+
+  for (const auto& elem : visited) {
+    pMapContainerQuota[elem] = qnode_id;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get space quota object responsible for a placement - caller has to have a
+// read lock on pMapMutex.
+//------------------------------------------------------------------------------
+SpaceQuota*
+Quota::GetResponsibleSpaceQuota(const Scheduler::PlacementArguments* args,
+                                bool resolved, eos::IContainerMD::id_t qnode_id)
+{
+  if (!resolved) {
+    return GetResponsibleSpaceQuota(args->path);
+  }
+
+  if (qnode_id == 0) {
+    return nullptr;
+  }
+
+  auto it = pMapInodeQuota.find(qnode_id);
+
+  // The node might have been removed in the meantime
+  if (it == pMapInodeQuota.end()) {
+    return GetResponsibleSpaceQuota(args->path);
+  }
+
+  return it->second;
+}
+
+//------------------------------------------------------------------------------
+// Drop the cached responsible quota nodes of all containers
+//------------------------------------------------------------------------------
+void
+Quota::InvalidateResponsibleCache()
+{
+  std::lock_guard<std::mutex> cache_lock(pCacheMutex);
+  pMapContainerQuota.clear();
+}
+
 //----------------------------------------------------------------------------
 //  Get space quota node path
 //----------------------------------------------------------------------------
@@ -1678,6 +1796,7 @@ Quota::RmSpaceQuota(const std::string& qpath, std::string& msg, int& retc)
     pMapQuota.erase(path);
     // Delete also from the pMapInodeQuota
     (void) pMapInodeQuota.erase(squota->GetQuotaNode()->getId());
+    InvalidateResponsibleCache();
 
     // Remove ns quota node
     try {
@@ -1734,8 +1853,16 @@ Quota::MapSizeCB(const eos::IFileMD* file)
     return 0;
   }
 
+  // A quota recomputation maps the files of a tree which mostly share the
+  // same layout, so keep the last layout decoded by this thread
+  static thread_local eos::common::LayoutDescriptor last_layout;
   eos::IFileMD::layoutId_t lid = file->getLayoutId();
-  return (uint64_t) file->getSize() * eos::common::LayoutId::GetSizeFactor(lid);
+
+  if (last_layout.mLayoutId != lid) {
+    last_layout = eos::common::LayoutDescriptor(lid);
+  }
+
+  return (uint64_t) file->getSize() * last_layout.mSizeFactor;
 }
 
 //------------------------------------------------------------------------------
@@ -1790,6 +1917,41 @@ Quota::LoadNodes()
   }
 }
 
+//------------------------------------------------------------------------------
+// Loop periodically reconciling the space quota counters
+//------------------------------------------------------------------------------
+void
+Quota::Reconcile(ThreadAssistant& assistant) noexcept
+{
+  static int sInterval = []() {
+    const char* ptr = getenv("EOS_MGM_QUOTA_RECONCILE_INTERVAL");
+    long long val = (ptr ? strtoll(ptr, nullptr, 10) : 60);
+    return (val >= 0 ? (int) val : 60);
+  }();
+
+  if (sInterval == 0) {
+    eos_static_info("%s", "msg=\"quota reconciliation disabled\"");
+    return;
+  }
+
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(std::chrono::seconds(sInterval));
+
+    if (assistant.terminationRequested()) {
+      break;
+    }
+
+    // The counters are updated without locks by the writers, recompute them
+    // and their sums from the quota nodes to correct any drift
+    eos::common::RWMutexReadLock rd_ns_lock(gOFS->eosViewRWMutex);
+    eos::common::RWMutexReadLock rd_quota_lock(pMapMutex);
+
+    for (auto it = pMapQuota.begin(); it != pMapQuota.end(); ++it) {
+      it->second->Refresh();
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 // Print out quota information
 //------------------------------------------------------------------------------
@@ -1910,6 +2072,7 @@ Quota::CleanUp()
 
   pMapQuota.clear();
   pMapInodeQuota.clear();
+  InvalidateResponsibleCache();
 }
 
 //------------------------------------------------------------------------------
@@ -1929,8 +2092,11 @@ Quota::FilePlacement(Scheduler::PlacementArguments* args)
 
   // Check if quota enabled for current space
   if (FsView::gFsView.IsQuotaEnabled(*args->spacename)) {
+    eos::IContainerMD::id_t qnode_id = 0;
+    bool resolved = (args->parent_cid &&
+                     ResolveResponsibleNode(args->parent_cid, qnode_id));
     eos::common::RWMutexReadLock rd_quota_lock(pMapMutex);
-    SpaceQuota* squota = GetResponsibleSpaceQuota(args->path);
+    SpaceQuota* squota = GetResponsibleSpaceQuota(args, resolved, qnode_id);
 
     if (squota) {
       bool has_quota = false;
@@ -1960,6 +2126,135 @@ Quota::FilePlacement(Scheduler::PlacementArguments* args)
   return Scheduler::FilePlacement(args);
 }
 
+//------------------------------------------------------------------------------
+// Take the decision where to place a batch of new files in the system. The
+// quota is checked once for all the requests charged to the same quota node
+// and identity.
+//------------------------------------------------------------------------------
+int
+Quota::FilePlacement(const std::vector<Scheduler::PlacementArguments*>& batch,
+                     std::vector<int>* retc)
+{
+  std::vector<int> rcs(batch.size(), 0);
+  // Resolve the quota nodes by parent container before taking the quota lock
+  std::vector<eos::IContainerMD::id_t> qnode_ids(batch.size(), 0);
+  std::vector<bool> resolved(batch.size(), false);
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    eos::IContainerMD::id_t qnode_id = 0;
+
+    if (batch[i]->parent_cid &&
+        FsView::gFsView.IsQuotaEnabled(*batch[i]->spacename) &&
+        ResolveResponsibleNode(batch[i]->parent_cid, qnode_id)) {
+      resolved[i] = true;
+      qnode_ids[i] = qnode_id;
+    }
+  }
+
+  {
+    eos::common::RWMutexReadLock rd_quota_lock(pMapMutex);
+    // Requests grouped by quota node and identity - the quota node is null if
+    // quota is not enabled for the space
+    std::map<std::tuple<SpaceQuota*, uid_t, gid_t>, std::vector<size_t>> charges;
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+      Scheduler::PlacementArguments* args = batch[i];
+
+      if (!FsView::gFsView.mSpaceGroupView.count(*args->spacename)) {
+        eos_static_err("msg=\"no filesystem in space\" space=\"%s\"",
+                       args->spacename->c_str());
+        args->selected_filesystems->clear();
+        rcs[i] = ENOSPC;
+        continue;
+      }
+
+      SpaceQuota* squota = nullptr;
+
+      if (FsView::gFsView.IsQuotaEnabled(*args->spacename)) {
+        squota = GetResponsibleSpaceQuota(args, resolved[i], qnode_ids[i]);
+      }
+
+      charges[std::make_tuple(squota, args->vid->uid, args->vid->gid)].push_back(i);
+    }
+
+    for (auto& elem : charges) {
+      SpaceQuota* squota = std::get<0>(elem.first);
+      uid_t uid = std::get<1>(elem.first);
+      gid_t gid = std::get<2>(elem.first);
+      std::vector<size_t>& indexes = elem.second;
+
+      if (!squota) {
+        continue;
+      }
+
+      long long desired_vol = 0;
+
+      for (auto i : indexes) {
+        desired_vol += 1ll * (eos::common::LayoutId::GetStripeNumber(
+                                batch[i]->lid) + 1) * batch[i]->bookingsize;
+      }
+
+      if (squota->CheckWriteQuota(uid, gid, desired_vol, indexes.size())) {
+        continue;
+      }
+
+      // Not enough quota for all of them, check them one by one
+      eos_static_debug("uid=%u gid=%u batch=%lu has not enough quota left "
+                       "for the whole batch", uid, gid,
+                       (unsigned long) indexes.size());
+      desired_vol = 0;
+      unsigned int ninodes = 0;
+
+      for (auto i : indexes) {
+        long long vol = 1ll * (eos::common::LayoutId::GetStripeNumber(
+                                 batch[i]->lid) + 1) * batch[i]->bookingsize;
+
+        if (squota->CheckWriteQuota(uid, gid, desired_vol + vol, ninodes + 1)) {
+          desired_vol += vol;
+          ++ninodes;
+        } else {
+          batch[i]->selected_filesystems->clear();
+          rcs[i] = EDQUOT;
+        }
+      }
+    }
+  }
+
+  // Call the scheduler implementation for the requests within quota, keeping
+  // the order of the batch
+  std::vector<Scheduler::PlacementArguments*> to_place;
+  std::vector<size_t> to_place_idx;
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    if (!rcs[i]) {
+      to_place.push_back(batch[i]);
+      to_place_idx.push_back(i);
+    }
+  }
+
+  std::vector<int> sched_rcs;
+  Scheduler::FilePlacement(to_place, &sched_rcs);
+
+  for (size_t j = 0; j < to_place.size(); ++j) {
+    rcs[to_place_idx[j]] = sched_rcs[j];
+  }
+
+  int first_err = 0;
+
+  for (auto rc : rcs) {
+    if (rc) {
+      first_err = rc;
+      break;
+    }
+  }
+
+  if (retc) {
+    *retc = rcs;
+  }
+
+  return first_err;
+}
+
 //------------------------------------------------------------------------------
 // Take the decision from where to access a file. The core of the
 // implementation is in the Scheduler and GeoTreeEngine.
@@ -1989,6 +2284,7 @@ Quota::Create(const std::string& path)
       SpaceQuota* squota = new SpaceQuota(path.c_str());
       pMapQuota[path] = squota;
       pMapInodeQuota[squota->GetQuotaNode()->getId()] = squota;
+      InvalidateResponsibleCache();
     } catch (const eos::MDException& e) {
       eos_static_crit("Faile to create quota node %s", path.c_str());
       return false;
@@ -29,12 +29,17 @@
 #include <google/dense_hash_map>
 #include <google/sparsehash/densehashtable.h>
 #include "mgm/Scheduler.hh"
+#include "mgm/QuotaCounterTable.hh"
 #include "common/Logging.hh"
 #include "common/LayoutId.hh"
 #include "common/Mapping.hh"
 #include "common/RWMutex.hh"
+#include "common/AssistedThread.hh"
 #include "namespace/interface/IQuota.hh"
 #include "XrdOuc/XrdOucString.hh"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -148,8 +153,6 @@ private:
   //!
   //! @param tag quota type tag (eQuotaTag)
   //! @param uid uid/gid/project id
-  //!
-  //! @warning Caller needs to hold a lock on mMutex
   //----------------------------------------------------------------------------
   void ResetQuota(unsigned long tag, unsigned long id);
 
@@ -159,8 +162,6 @@ private:
   //! @param tag quota type tag (eQuotaTag)
   //! @param id user/group id
   //! @param value quota value to be added
-  //!
-  //! @warning Caller needs to hold a lock on mMutex.
   //----------------------------------------------------------------------------
   void AddQuota(unsigned long tag, unsigned long id, long long value);
 
@@ -303,13 +304,14 @@ private:
 
   std::string pPath; ///< quota node path
   eos::IQuotaNode* mQuotaNode; ///< corresponding ns quota node
-  XrdSysMutex mMutex; ///< mutex to protect access to mMapIdQuota
+  XrdSysMutex mMutex; ///< serializes the recomputation of the sums
   time_t mLastEnableCheck; ///< timestamp of the last check
   double mLayoutSizeFactor; ///< layout dependent size factor
-  bool mDirtyTarget; ///< mark to recompute target values
+  std::atomic<bool> mDirtyTarget; ///< mark to recompute target values
 
-  //! Map for user view, depending on eQuota and uid/gid
-  std::map<long long, unsigned long long> mMapIdQuota;
+  //! Counters for user view, depending on eQuota and uid/gid, accessed
+  //! without locking
+  QuotaCounterTable mMapIdQuota;
 };
 
 
@@ -514,6 +516,15 @@ public:
   //----------------------------------------------------------------------------
   static void LoadNodes();
 
+  //----------------------------------------------------------------------------
+  //! Loop periodically reconciling the space quota counters with the
+  //! namespace quota nodes. The interval is given in seconds by
+  //! EOS_MGM_QUOTA_RECONCILE_INTERVAL (default 60, 0 disables).
+  //!
+  //! @param assistant thread running the loop
+  //----------------------------------------------------------------------------
+  static void Reconcile(ThreadAssistant& assistant) noexcept;
+
   //----------------------------------------------------------------------------
   //! Clean-up all space quotas by deleting them and clearing the map
   //----------------------------------------------------------------------------
@@ -558,6 +569,22 @@ public:
   static
   int FilePlacement(Scheduler::PlacementArguments* args);
 
+  //----------------------------------------------------------------------------
+  //! Take the decision where to place a batch of new files. The quota is
+  //! checked once for all the requests charged to the same quota node and
+  //! identity, only if it is not enough the requests are checked one by one.
+  //!
+  //! @param batch placement requests
+  //! @param retc if not null, filled with the return code of each request
+  //!
+  //! @return 0 if all the placements are successful, otherwise the error of
+  //!         the first failed request - see FilePlacement for the values
+  //! @warning Must be called with a lock on the FsView::gFsView::ViewMutex
+  //----------------------------------------------------------------------------
+  static
+  int FilePlacement(const std::vector<Scheduler::PlacementArguments*>& batch,
+                    std::vector<int>* retc = nullptr);
+
   //----------------------------------------------------------------------------
   //! Take the decision from where to access a file. The core of the
   //! implementation is in the Scheduler and GeoTreeEngine.
@@ -637,6 +664,12 @@ public:
   //----------------------------------------------------------------------------
   static std::string GetResponsibleSpaceQuotaPath(const std::string& path);
 
+  //----------------------------------------------------------------------------
+  //! Drop the cached responsible quota nodes of all containers. To be called
+  //! whenever a container is moved to a different parent.
+  //----------------------------------------------------------------------------
+  static void InvalidateResponsibleCache();
+
   static gid_t gProjectId; ///< gid indicating project quota
   static eos::common::RWMutex pMapMutex; ///< Protect access to pMapQuota
 
@@ -676,6 +709,33 @@ private:
   //----------------------------------------------------------------------------
   static SpaceQuota* GetResponsibleSpaceQuota(const std::string& path);
 
+  //----------------------------------------------------------------------------
+  //! Resolve the quota node responsible for a container by walking up its
+  //! parents in the namespace. The result is cached per container id. Must
+  //! be called without holding the eosViewRWMutex or the pMapMutex.
+  //!
+  //! @param cid container id
+  //! @param qnode_id output container id of the responsible quota node, 0 if
+  //!        there is none
+  //!
+  //! @return true if successful, false if the container could not be resolved
+  //----------------------------------------------------------------------------
+  static bool ResolveResponsibleNode(eos::IContainerMD::id_t cid,
+                                     eos::IContainerMD::id_t& qnode_id);
+
+  //----------------------------------------------------------------------------
+  //! Get space quota object responsible for a placement, using the parent
+  //! container id if given - caller has to have a read lock on pMapMutex.
+  //!
+  //! @param args placement arguments
+  //! @param resolved true if the responsible node was resolved by id
+  //! @param qnode_id container id of the responsible quota node
+  //!
+  //! @return SpaceQuota object or nullptr
+  //----------------------------------------------------------------------------
+  static SpaceQuota* GetResponsibleSpaceQuota(const Scheduler::PlacementArguments*
+      args, bool resolved, eos::IContainerMD::id_t qnode_id);
+
 
   //----------------------------------------------------------------------------
   //! Make sure the path ends with a /
@@ -699,6 +759,14 @@ private:
   static std::map<std::string, SpaceQuota*> pMapQuota;
   //! Map from container id to SpaceQuota object
   static std::map<eos::IContainerMD::id_t, SpaceQuota*> pMapInodeQuota;
+  //! Mutex protecting the cache of responsible quota nodes
+  static std::mutex pCacheMutex;
+  //! Map from container id to the container id of its responsible quota
+  //! node, 0 if there is none
+  static std::unordered_map<eos::IContainerMD::id_t, eos::IContainerMD::id_t>
+  pMapContainerQuota;
+  //! Max number of containers in the cache before it is dropped
+  static constexpr size_t sMaxCachedContainers = 1024 * 1024;
 };
 
 EOSMGMNAMESPACE_END
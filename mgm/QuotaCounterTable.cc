@@ -0,0 +1,207 @@
+//------------------------------------------------------------------------------
+//! @file QuotaCounterTable.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/QuotaCounterTable.hh"
+#include <utility>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+constexpr size_t QuotaCounterTable::sDefaultCapacity;
+constexpr size_t QuotaCounterTable::sMaxProbes;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+QuotaCounterTable::QuotaCounterTable(size_t capacity):
+  mHasOverflow(false)
+{
+  size_t size = 1;
+
+  while (size < capacity) {
+    size <<= 1;
+  }
+
+  mSlots.reset(new Slot[size]);
+  mMask = size - 1;
+}
+
+//------------------------------------------------------------------------------
+// Find the slot of a key, claiming a free slot if requested
+//------------------------------------------------------------------------------
+QuotaCounterTable::Slot*
+QuotaCounterTable::Find(uint64_t key, bool claim) const
+{
+  // Spread the ids of the same tag over the table
+  uint64_t hash = key * 0x9e3779b97f4a7c15ull;
+  size_t pos = (hash ^ (hash >> 32)) & mMask;
+
+  for (size_t i = 0; i < sMaxProbes; ++i) {
+    Slot& slot = mSlots[(pos + i) & mMask];
+    uint64_t skey = slot.mKey.load(std::memory_order_acquire);
+
+    if (skey == key) {
+      return &slot;
+    }
+
+    if (skey == 0) {
+      if (!claim) {
+        return nullptr;
+      }
+
+      if (slot.mKey.compare_exchange_strong(skey, key,
+                                            std::memory_order_acq_rel) ||
+          (skey == key)) {
+        return &slot;
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Get value of a counter
+//------------------------------------------------------------------------------
+unsigned long long
+QuotaCounterTable::Get(uint64_t key) const
+{
+  Slot* slot = Find(key, false);
+
+  if (slot) {
+    return slot->mValue.load(std::memory_order_relaxed);
+  }
+
+  if (mHasOverflow.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(mOverflowMutex);
+    auto it = mOverflow.find(key);
+
+    if (it != mOverflow.end()) {
+      return it->second;
+    }
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Set value of a counter
+//------------------------------------------------------------------------------
+void
+QuotaCounterTable::Set(uint64_t key, unsigned long long value)
+{
+  Slot* slot = Find(key, true);
+
+  if (slot) {
+    slot->mValue.store(value, std::memory_order_relaxed);
+    slot->mUsed.store(true, std::memory_order_relaxed);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mOverflowMutex);
+  mOverflow[key] = value;
+  mHasOverflow.store(true, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+// Add to a counter unless the result would be negative
+//------------------------------------------------------------------------------
+void
+QuotaCounterTable::Add(uint64_t key, long long value)
+{
+  Slot* slot = Find(key, true);
+
+  if (slot) {
+    unsigned long long current = slot->mValue.load(std::memory_order_relaxed);
+
+    do {
+      if ((long long) current + value < 0) {
+        break;
+      }
+    } while (!slot->mValue.compare_exchange_weak(current, current + value,
+             std::memory_order_relaxed));
+
+    slot->mUsed.store(true, std::memory_order_relaxed);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mOverflowMutex);
+  unsigned long long& current = mOverflow[key];
+
+  if ((long long) current + value >= 0) {
+    current += value;
+  }
+
+  mHasOverflow.store(true, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+// Remove a counter
+//------------------------------------------------------------------------------
+bool
+QuotaCounterTable::Erase(uint64_t key)
+{
+  Slot* slot = Find(key, false);
+
+  if (slot) {
+    slot->mValue.store(0, std::memory_order_relaxed);
+    return slot->mUsed.exchange(false, std::memory_order_relaxed);
+  }
+
+  if (mHasOverflow.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(mOverflowMutex);
+    return (mOverflow.erase(key) != 0);
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Call the given function for every existing counter
+//------------------------------------------------------------------------------
+void
+QuotaCounterTable::ForEach(const
+                           std::function<void(uint64_t, unsigned long long)>& func) const
+{
+  for (size_t i = 0; i <= mMask; ++i) {
+    const Slot& slot = mSlots[i];
+    uint64_t key = slot.mKey.load(std::memory_order_acquire);
+
+    if (key && slot.mUsed.load(std::memory_order_relaxed)) {
+      func(key, slot.mValue.load(std::memory_order_relaxed));
+    }
+  }
+
+  if (mHasOverflow.load(std::memory_order_acquire)) {
+    std::vector<std::pair<uint64_t, unsigned long long>> entries;
+    {
+      std::lock_guard<std::mutex> lock(mOverflowMutex);
+      entries.assign(mOverflow.begin(), mOverflow.end());
+    }
+
+    for (const auto& elem : entries) {
+      func(elem.first, elem.second);
+    }
+  }
+}
+
+EOSMGMNAMESPACE_END
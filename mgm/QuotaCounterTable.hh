@@ -0,0 +1,113 @@
+//------------------------------------------------------------------------------
+//! @file QuotaCounterTable.hh
+//! @brief Lock-free table of the quota counters of a space quota
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Class QuotaCounterTable - fixed size open addressing map of atomic
+//! counters keyed by the SpaceQuota index (tag << 32 | id)
+//!
+//! The keys are claimed with a compare-and-swap and never move, so reads,
+//! stores and additions of the values are plain relaxed atomic operations
+//! without any lock. Removed entries keep their slot and are only flagged as
+//! unused. Keys which don't find a free slot within sMaxProbes go to an
+//! overflow map protected by a mutex.
+//------------------------------------------------------------------------------
+class QuotaCounterTable
+{
+public:
+  static constexpr size_t sDefaultCapacity = 4096;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param capacity number of slots, rounded up to a power of two
+  //----------------------------------------------------------------------------
+  QuotaCounterTable(size_t capacity = sDefaultCapacity);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~QuotaCounterTable() = default;
+
+  //----------------------------------------------------------------------------
+  //! Get value of a counter, 0 if it does not exist
+  //----------------------------------------------------------------------------
+  unsigned long long Get(uint64_t key) const;
+
+  //----------------------------------------------------------------------------
+  //! Set value of a counter
+  //----------------------------------------------------------------------------
+  void Set(uint64_t key, unsigned long long value);
+
+  //----------------------------------------------------------------------------
+  //! Add to a counter unless the result would be negative
+  //----------------------------------------------------------------------------
+  void Add(uint64_t key, long long value);
+
+  //----------------------------------------------------------------------------
+  //! Remove a counter
+  //!
+  //! @return true if the counter existed, otherwise false
+  //----------------------------------------------------------------------------
+  bool Erase(uint64_t key);
+
+  //----------------------------------------------------------------------------
+  //! Call the given function for every existing counter
+  //----------------------------------------------------------------------------
+  void ForEach(const std::function<void(uint64_t, unsigned long long)>& func)
+  const;
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> mKey {0}; ///< 0 if the slot is free
+    std::atomic<unsigned long long> mValue {0};
+    std::atomic<bool> mUsed {false}; ///< false if the counter was removed
+  };
+
+  static constexpr size_t sMaxProbes = 32;
+
+  //----------------------------------------------------------------------------
+  //! Find the slot of a key, claiming a free slot if requested
+  //!
+  //! @return slot or nullptr if the key is not in the table
+  //----------------------------------------------------------------------------
+  Slot* Find(uint64_t key, bool claim) const;
+
+  std::unique_ptr<Slot[]> mSlots;
+  size_t mMask; ///< Number of slots - 1
+  mutable std::mutex mOverflowMutex;
+  std::map<uint64_t, unsigned long long> mOverflow; ///< Keys without a slot
+  std::atomic<bool> mHasOverflow; ///< Quick check if mOverflow is empty
+};
+
+EOSMGMNAMESPACE_END
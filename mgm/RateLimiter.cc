@@ -0,0 +1,265 @@
+//------------------------------------------------------------------------------
+//! @file RateLimiter.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/RateLimiter.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+EOSMGMNAMESPACE_BEGIN
+
+constexpr double RateLimiter::sBurstSeconds;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+RateLimiter::RateLimiter():
+  mConfig(std::make_shared<const Config>())
+{}
+
+//------------------------------------------------------------------------------
+// Get current steady clock time in nanoseconds
+//------------------------------------------------------------------------------
+int64_t
+RateLimiter::GetNowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+         (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------------
+// Apply the rate rules among the given stall rules
+//------------------------------------------------------------------------------
+void
+RateLimiter::Configure(const std::map<std::string, std::string>& rules)
+{
+  static std::atomic<uint64_t> sGeneration {0};
+  std::shared_ptr<Config> config = std::make_shared<Config>();
+
+  for (auto it = rules.lower_bound("rate:");
+       (it != rules.end()) && (it->first.find("rate:") == 0); ++it) {
+    config->mRules.insert(*it);
+  }
+
+  // Keep the buckets if the rate rules did not change
+  if (config->mRules == std::atomic_load(&mConfig)->mRules) {
+    return;
+  }
+
+  config->mGeneration = ++sGeneration;
+
+  for (const auto& elem : config->mRules) {
+    // Rules are rate:user:<uid>:<op> or rate:group:<gid>:<op>
+    const std::string& key = elem.first;
+    bool is_group;
+    size_t pos;
+
+    if (key.find("rate:user:") == 0) {
+      is_group = false;
+      pos = strlen("rate:user:");
+    } else if (key.find("rate:group:") == 0) {
+      is_group = true;
+      pos = strlen("rate:group:");
+    } else {
+      continue;
+    }
+
+    size_t op_pos = key.rfind(':');
+
+    if (op_pos < pos) {
+      continue;
+    }
+
+    std::string id = key.substr(pos, op_pos - pos);
+    std::string op = key.substr(op_pos + 1);
+    double rate = strtod(elem.second.c_str(), 0);
+
+    // The find limits are not rates but the max number of entries returned
+    if (id.empty() || op.empty() || (rate <= 0) ||
+        (op == "FindFiles") || (op == "FindDirs")) {
+      continue;
+    }
+
+    Rule* rule = nullptr;
+    OpRules& op_rules = config->mOps[op];
+
+    if (id == "*") {
+      rule = (is_group ? &op_rules.mAllGroups : &op_rules.mAllUsers);
+    } else {
+      char* end = nullptr;
+      unsigned long num_id = strtoul(id.c_str(), &end, 10);
+
+      if (*end) {
+        continue;
+      }
+
+      rule = (is_group ? &op_rules.mGroups[num_id] : &op_rules.mUsers[num_id]);
+    }
+
+    rule->mKey = key;
+    rule->mRate = rate;
+    rule->mIndex = config->mNumRules++;
+  }
+
+  std::atomic_store(&mConfig, std::shared_ptr<const Config>(config));
+
+  // Drop all the buckets of the previous configuration
+  for (auto& shard : mShards) {
+    std::lock_guard<std::mutex> lock(shard.mMutex);
+    shard.mIdentities.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Account operations of a client
+//------------------------------------------------------------------------------
+void
+RateLimiter::Consume(const char* op, uid_t uid, gid_t gid, uint64_t count)
+{
+  std::shared_ptr<const Config> config = std::atomic_load(&mConfig);
+
+  if (config->mOps.empty()) {
+    return;
+  }
+
+  auto it_op = config->mOps.find(op);
+
+  if (it_op == config->mOps.end()) {
+    return;
+  }
+
+  const OpRules& op_rules = it_op->second;
+  int64_t now_ns = GetNowNs();
+  // A rule for a given user or group overrides the wildcard rule
+  auto it_user = op_rules.mUsers.find(uid);
+  const Rule& user_rule = ((it_user != op_rules.mUsers.end()) ?
+                           it_user->second : op_rules.mAllUsers);
+
+  if (user_rule.mRate > 0) {
+    ConsumeRule(*config, user_rule, GetKey(false, uid), count, now_ns);
+  }
+
+  auto it_group = op_rules.mGroups.find(gid);
+  const Rule& group_rule = ((it_group != op_rules.mGroups.end()) ?
+                            it_group->second : op_rules.mAllGroups);
+
+  if (group_rule.mRate > 0) {
+    ConsumeRule(*config, group_rule, GetKey(true, gid), count, now_ns);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Consume tokens from the bucket of a rule
+//------------------------------------------------------------------------------
+void
+RateLimiter::ConsumeRule(const Config& config, const Rule& rule, uint64_t key,
+                         uint64_t count, int64_t now_ns)
+{
+  Shard& shard = GetShard(key);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  Identity& identity = shard.mIdentities[key];
+
+  if (identity.mGeneration != config.mGeneration) {
+    identity = Identity();
+    identity.mGeneration = config.mGeneration;
+    identity.mBuckets.resize(config.mNumRules);
+  }
+
+  const double capacity = std::max(1.0, rule.mRate * sBurstSeconds);
+  Bucket& bucket = identity.mBuckets[rule.mIndex];
+
+  if (bucket.mLastNs == 0) {
+    bucket.mTokens = capacity;
+  } else {
+    bucket.mTokens = std::min(capacity, bucket.mTokens +
+                              (now_ns - bucket.mLastNs) * rule.mRate / 1e9);
+  }
+
+  bucket.mLastNs = now_ns;
+  bucket.mTokens -= count;
+
+  if (bucket.mTokens < 0) {
+    // Hold the identity until the deficit is refilled
+    int64_t until_ns = now_ns + (int64_t)(-bucket.mTokens / rule.mRate * 1e9);
+
+    if (until_ns > identity.mStallUntilNs) {
+      identity.mStallUntilNs = until_ns;
+      identity.mStallRule = rule.mKey;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get remaining hold time of an identity in nanoseconds
+//------------------------------------------------------------------------------
+int64_t
+RateLimiter::GetHoldNs(const Config& config, uint64_t key, int64_t now_ns,
+                       std::string& rule)
+{
+  Shard& shard = GetShard(key);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  auto it = shard.mIdentities.find(key);
+
+  if ((it == shard.mIdentities.end()) ||
+      (it->second.mGeneration != config.mGeneration) ||
+      (it->second.mStallUntilNs <= now_ns)) {
+    return 0;
+  }
+
+  rule = it->second.mStallRule;
+  return (it->second.mStallUntilNs - now_ns);
+}
+
+//------------------------------------------------------------------------------
+// Get the time a client has to be stalled
+//------------------------------------------------------------------------------
+int
+RateLimiter::GetStallTime(uid_t uid, gid_t gid, std::string& rule)
+{
+  std::shared_ptr<const Config> config = std::atomic_load(&mConfig);
+
+  if (config->mOps.empty()) {
+    return 0;
+  }
+
+  int64_t now_ns = GetNowNs();
+  std::string group_rule;
+  int64_t hold_ns = GetHoldNs(*config, GetKey(false, uid), now_ns, rule);
+  int64_t group_hold_ns = GetHoldNs(*config, GetKey(true, gid), now_ns,
+                                    group_rule);
+
+  if (group_hold_ns > hold_ns) {
+    hold_ns = group_hold_ns;
+    rule = group_rule;
+  }
+
+  if (hold_ns <= 0) {
+    return 0;
+  }
+
+  // Round up to full seconds
+  return (int)((hold_ns + 999999999) / 1000000000);
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,184 @@
+//------------------------------------------------------------------------------
+//! @file RateLimiter.hh
+//! @brief Token bucket rate limiter for the user and group rate stall rules
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Class RateLimiter - enforces the rate:user:<uid>:<op> and
+//! rate:group:<gid>:<op> stall rules with token buckets
+//!
+//! Every (identity, rule) pair has a bucket refilled with the rate of the
+//! rule and holding at most sBurstSeconds worth of tokens. The operations
+//! accounted in the MGM statistics consume tokens and a bucket running into
+//! deficit puts its identity on hold until the deficit is paid back. The
+//! check done at request entry is then a single hash lookup of the uid and
+//! gid. The buckets live in a hash sharded by identity so that concurrent
+//! requests of different users don't contend on the same mutex.
+//------------------------------------------------------------------------------
+class RateLimiter
+{
+public:
+  //! Number of seconds worth of tokens a bucket can accumulate
+  static constexpr double sBurstSeconds = 5.0;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  RateLimiter();
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~RateLimiter() = default;
+
+  //----------------------------------------------------------------------------
+  //! Apply the rate rules among the given stall rules, resetting all the
+  //! buckets if the rate rules changed
+  //!
+  //! @param rules stall rules i.e. Access::gStallRules
+  //----------------------------------------------------------------------------
+  void Configure(const std::map<std::string, std::string>& rules);
+
+  //----------------------------------------------------------------------------
+  //! Account operations of a client
+  //!
+  //! @param op operation tag as used in the MGM statistics
+  //! @param uid user id of the client
+  //! @param gid group id of the client
+  //! @param count number of operations
+  //----------------------------------------------------------------------------
+  void Consume(const char* op, uid_t uid, gid_t gid, uint64_t count);
+
+  //----------------------------------------------------------------------------
+  //! Get the time a client has to be stalled
+  //!
+  //! @param uid user id of the client
+  //! @param gid group id of the client
+  //! @param rule output key of the rule which was exceeded
+  //!
+  //! @return stall time in seconds, 0 if the client is within its rates
+  //----------------------------------------------------------------------------
+  int GetStallTime(uid_t uid, gid_t gid, std::string& rule);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Rate rule
+  //----------------------------------------------------------------------------
+  struct Rule {
+    std::string mKey; ///< Stall rule key e.g. rate:user:*:Stat
+    double mRate = 0; ///< Operations per second, 0 if undefined
+    size_t mIndex = 0; ///< Index of the bucket of the rule
+  };
+
+  //----------------------------------------------------------------------------
+  //! Rate rules of one operation
+  //----------------------------------------------------------------------------
+  struct OpRules {
+    Rule mAllUsers;
+    std::unordered_map<uid_t, Rule> mUsers;
+    Rule mAllGroups;
+    std::unordered_map<gid_t, Rule> mGroups;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Immutable configuration replaced as a whole by Configure
+  //----------------------------------------------------------------------------
+  struct Config {
+    std::map<std::string, std::string> mRules; ///< Rate rules as configured
+    std::unordered_map<std::string, OpRules> mOps;
+    size_t mNumRules = 0;
+    uint64_t mGeneration = 0;
+  };
+
+  struct Bucket {
+    double mTokens = 0;
+    int64_t mLastNs = 0; ///< Time of the last refill, 0 if never used
+  };
+
+  //----------------------------------------------------------------------------
+  //! Buckets and hold state of one user or group
+  //----------------------------------------------------------------------------
+  struct Identity {
+    uint64_t mGeneration = 0; ///< Configuration the buckets belong to
+    std::vector<Bucket> mBuckets;
+    int64_t mStallUntilNs = 0;
+    std::string mStallRule;
+  };
+
+  struct Shard {
+    std::mutex mMutex;
+    std::unordered_map<uint64_t, Identity> mIdentities;
+  };
+
+  static constexpr size_t sNumShards = 32;
+
+  //----------------------------------------------------------------------------
+  //! Get key of a user or group in the sharded hash
+  //----------------------------------------------------------------------------
+  static inline uint64_t GetKey(bool is_group, uint32_t id)
+  {
+    return ((is_group ? (1ull << 32) : 0ull) | id);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get shard holding the given key
+  //----------------------------------------------------------------------------
+  inline Shard& GetShard(uint64_t key)
+  {
+    return mShards[(key ^ (key >> 32)) % sNumShards];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get current steady clock time in nanoseconds
+  //----------------------------------------------------------------------------
+  static int64_t GetNowNs();
+
+  //----------------------------------------------------------------------------
+  //! Consume tokens from the bucket of a rule
+  //----------------------------------------------------------------------------
+  void ConsumeRule(const Config& config, const Rule& rule, uint64_t key,
+                   uint64_t count, int64_t now_ns);
+
+  //----------------------------------------------------------------------------
+  //! Get remaining hold time of an identity in nanoseconds
+  //----------------------------------------------------------------------------
+  int64_t GetHoldNs(const Config& config, uint64_t key, int64_t now_ns,
+                    std::string& rule);
+
+  std::shared_ptr<const Config> mConfig; ///< Accessed with atomic_load/store
+  std::array<Shard, sNumShards> mShards;
+};
+
+EOSMGMNAMESPACE_END
@@ -22,6 +22,7 @@
  ************************************************************************/
 
 #include "common/Logging.hh"
+#include "common/FileId.hh"
 #include "common/LayoutId.hh"
 #include "common/Mapping.hh"
 #include "common/RWMutex.hh"
@@ -46,6 +47,201 @@ int Recycle::gRecyclingPollTime = 30;
 
 EOSMGMNAMESPACE_BEGIN
 
+//! Max number of entries taken from the recycle bin index per round
+static constexpr size_t sMaxIndexedDeletions = 100000;
+
+//------------------------------------------------------------------------------
+// Build the index entry of a path in the recycle bin from its stat info
+//------------------------------------------------------------------------------
+static RecycleIndex::Entry
+GetIndexEntry(const std::string& path, const struct stat& buf)
+{
+  RecycleIndex::Entry entry;
+  eos::common::Path cPath(path.c_str());
+  entry.mPath = cPath.GetPath();
+  entry.mDeletionTime = buf.st_ctime;
+  entry.mIsDir = S_ISDIR(buf.st_mode);
+  entry.mId = (entry.mIsDir ? buf.st_ino :
+               eos::common::FileId::InodeToFid(buf.st_ino));
+  entry.mUid = buf.st_uid;
+  entry.mGid = buf.st_gid;
+  entry.mSize = buf.st_size;
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+// Check if an entry of the recycle bin is below the given date directory
+// i.e. <year> or <year>/<month> or <year>/<month>/<day>
+//------------------------------------------------------------------------------
+static bool
+MatchesDate(const RecycleIndex::Entry& entry, const std::string& date)
+{
+  if (date.empty()) {
+    return true;
+  }
+
+  eos::common::Path cPath(SSTR(Recycle::gRecyclingPrefix << "/uid:"
+                               << entry.mUid << "/" << date).c_str());
+  std::string prefix = cPath.GetPath();
+  prefix += "/";
+  return (entry.mPath.compare(0, prefix.length(), prefix) == 0);
+}
+
+//------------------------------------------------------------------------------
+// Print an entry of the recycle bin
+//------------------------------------------------------------------------------
+static void
+PrintEntry(std::ostringstream& oss_out, const RecycleIndex::Entry& entry,
+           bool monitoring, bool translateids, bool header)
+{
+  XrdOucString uids;
+  XrdOucString gids;
+
+  if (translateids) {
+    int errc = 0;
+    uids = eos::common::Mapping::UidToUserName(entry.mUid, errc).c_str();
+
+    if (errc) {
+      uids = eos::common::Mapping::UidAsString(entry.mUid).c_str();
+    }
+
+    gids = eos::common::Mapping::GidToGroupName(entry.mGid, errc).c_str();
+
+    if (errc) {
+      gids = eos::common::Mapping::GidAsString(entry.mGid).c_str();
+    }
+  } else {
+    uids = eos::common::Mapping::UidAsString(entry.mUid).c_str();
+    gids = eos::common::Mapping::GidAsString(entry.mGid).c_str();
+  }
+
+  // demangle the original pathname
+  eos::common::Path cPath(entry.mPath.c_str());
+  XrdOucString origpath = cPath.GetName();
+
+  while (origpath.replace("#:#", "/")) {
+  }
+
+  XrdOucString type = "file";
+
+  if (origpath.endswith(Recycle::gRecyclingPostFix.c_str())) {
+    type = "recursive-dir";
+    origpath.erase(origpath.length() - Recycle::gRecyclingPostFix.length());
+  }
+
+  XrdOucString originode = origpath;
+  originode.erase(0, origpath.length() - 16);
+  origpath.erase(origpath.length() - 17);
+
+  if (monitoring) {
+    oss_out << "recycle=ls recycle-bin=" << Recycle::gRecyclingPrefix
+            << " uid=" << uids.c_str() << " gid=" << gids.c_str()
+            << " size=" << std::to_string(entry.mSize)
+            << " deletion-time=" << std::to_string(entry.mDeletionTime)
+            << " type=" << type.c_str()
+            << " keylength.restore-path=" << origpath.length()
+            << " restore-path=" << origpath.c_str()
+            << " restore-key=" << originode.c_str()
+            << std::endl;
+  } else {
+    char sline[4096];
+    XrdOucString sizestring;
+
+    if (header) {
+      snprintf(sline, sizeof(sline) - 1,
+               "# %-24s %-8s %-8s %-12s %-13s %-16s %-64s\n", "Deletion Time", "UID", "GID",
+               "SIZE", "TYPE", "RESTORE-KEY", "RESTORE-PATH");
+      oss_out << sline
+              << "# ================================================"
+              << "=================================================="
+              << "============================" << std::endl;
+    }
+
+    char tdeltime[4096];
+    time_t deletion_time = entry.mDeletionTime;
+    std::string deltime = ctime_r(&deletion_time, tdeltime);
+    deltime.erase(deltime.length() - 1);
+    snprintf(sline, sizeof(sline) - 1, "%-26s %-8s %-8s %-12s %-13s %-16s %-64s",
+             deltime.c_str(), uids.c_str(), gids.c_str(),
+             eos::common::StringConversion::GetSizeString(sizestring,
+                 (unsigned long long) entry.mSize), type.c_str(), originode.c_str(),
+             origpath.c_str());
+    oss_out << sline << std::endl;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove an entry of the recycle bin by running the rm command
+//------------------------------------------------------------------------------
+static int
+PurgeEntry(const std::string& pathname, bool isdir, std::string& std_out,
+           std::string& std_err)
+{
+  eos::common::Mapping::VirtualIdentity rootvid;
+  eos::common::Mapping::Root(rootvid);
+  XrdOucErrInfo lError;
+  // execute a proc command
+  ProcCommand Cmd;
+  XrdOucString info;
+
+  if (isdir) {
+    // we need recursive deletion
+    info = "mgm.cmd=rm&mgm.option=r&mgm.path=";
+  } else {
+    info = "mgm.cmd=rm&mgm.path=";
+  }
+
+  info += pathname.c_str();
+  int result = Cmd.open("/proc/user", info.c_str(), rootvid, &lError);
+  Cmd.AddOutput(std_out, std_err);
+
+  if (*std_out.rbegin() != '\n') {
+    std_out += "\n";
+  }
+
+  if (*std_err.rbegin() != '\n') {
+    std_err += "\n";
+  }
+
+  Cmd.close();
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// Drop the index entry of a path handled by the recycler, removing it from
+// the index once the path is gone
+//------------------------------------------------------------------------------
+static void
+DropIndexEntry(std::map<std::string, RecycleIndex::Entry>& entries,
+               const std::string& path)
+{
+  auto it = entries.find(path);
+
+  if (it == entries.end()) {
+    return;
+  }
+
+  eos::common::Mapping::VirtualIdentity rootvid;
+  eos::common::Mapping::Root(rootvid);
+  XrdOucErrInfo lError;
+  struct stat buf;
+
+  if (gOFS->_stat(path.c_str(), &buf, lError, rootvid, "", 0, false)) {
+    Recycle::GetIndex().Remove(it->second);
+  }
+
+  entries.erase(it);
+}
+
+//------------------------------------------------------------------------------
+// Get the index of the recycle bin persisted in QuarkDB
+//------------------------------------------------------------------------------
+RecycleIndex&
+Recycle::GetIndex()
+{
+  static RecycleIndex index;
+  return index;
+}
 
 //------------------------------------------------------------------------------
 // Run asynchronous recyling thread
@@ -82,6 +278,8 @@ Recycle::Recycler(ThreadAssistant& assistant) noexcept
   time_t lKeepTime = 0;
   double lSpaceKeepRatio = 0;
   std::multimap<time_t, std::string> lDeletionMap;
+  // Index entries of the paths in the deletion map
+  std::map<std::string, RecycleIndex::Entry> lIndexEntries;
   time_t snoozetime = 10;
   unsigned long long lLowInodesWatermark = 0;
   unsigned long long lLowSpaceWatermark = 0;
@@ -264,15 +462,43 @@ Recycle::Recycler(ThreadAssistant& assistant) noexcept
               }
 
               // the new recycle bin
-              {
+              if (GetIndex().IsReady()) {
+                // Take the entries in deletion time order from the index up
+                // to the first one which has to be kept
+                std::string cursor = "0";
+                std::vector<RecycleIndex::Entry> entries;
+                time_t now = time(NULL);
+                bool done = false;
+
+                do {
+                  if (!GetIndex().List(0, true, cursor, RecycleIndex::sPageSize,
+                                       entries)) {
+                    break;
+                  }
+
+                  for (const auto& entry : entries) {
+                    lDeletionMap.insert(std::make_pair(entry.mDeletionTime,
+                                                       entry.mPath));
+                    lIndexEntries[entry.mPath] = entry;
+
+                    if (((entry.mDeletionTime + lKeepTime) >= now) ||
+                        (lIndexEntries.size() >= sMaxIndexedDeletions)) {
+                      done = true;
+                      break;
+                    }
+                  }
+                } while (!done && (cursor != "0"));
+              } else {
+                // Walk the recycle bin, building the index on the way
+                bool build_index = GetIndex().IsEnabled();
                 std::map<std::string, std::set < std::string>> findmap;
                 char sdir[4096];
                 snprintf(sdir, sizeof(sdir) - 1, "%s/", Recycle::gRecyclingPrefix.c_str());
                 XrdOucErrInfo lError;
                 int depth = 6;
                 XrdOucString err_msg;
-                (void) gOFS->_find(sdir, lError, err_msg, rootvid, findmap,
-                                   0, 0, false, 0, true, depth);
+                int retc = gOFS->_find(sdir, lError, err_msg, rootvid, findmap,
+                                       0, 0, false, 0, true, depth);
 
                 for (auto dirit = findmap.begin(); dirit != findmap.end(); ++dirit) {
                   XrdOucString dirname = dirit->first.c_str();
@@ -309,9 +535,21 @@ Recycle::Recycler(ThreadAssistant& assistant) noexcept
                       lDeletionMap.insert(std::pair<time_t, std::string > (buf.st_ctime,
                                           fullpath.c_str()));
                       eos_static_debug("new-bin: adding to deletionmap : %s", fullpath.c_str());
+
+                      if (build_index) {
+                        RecycleIndex::Entry entry = GetIndexEntry(fullpath, buf);
+                        GetIndex().Add(entry);
+                        lIndexEntries[fullpath] = entry;
+                      }
                     }
                   }
                 }
+
+                if (build_index && (!retc || (errno == ENOENT))) {
+                  eos_static_info("msg=\"built recycle bin index\" entries=%llu",
+                                  (unsigned long long) lIndexEntries.size());
+                  GetIndex().SetReady();
+                }
               }
             }
           } else {
@@ -411,6 +649,7 @@ Recycle::Recycler(ThreadAssistant& assistant) noexcept
                     }
                   }
 
+                  DropIndexEntry(lIndexEntries, it->second);
                   lDeletionMap.erase(it);
                   it = lDeletionMap.begin();
                 } else {
@@ -421,6 +660,7 @@ Recycle::Recycler(ThreadAssistant& assistant) noexcept
                     eos_static_err("msg=\"unable to remove file\" path=%s", it->second.c_str());
                   }
 
+                  DropIndexEntry(lIndexEntries, it->second);
                   lDeletionMap.erase(it);
                   it = lDeletionMap.begin();
                 }
@@ -526,6 +766,15 @@ Recycle::ToGarbage(const char* epname, XrdOucErrInfo& error)
     return gOFS->Emsg(epname, error, EIO, "rename file/directory", srecyclepath);
   }
 
+  if (GetIndex().IsEnabled()) {
+    struct stat buf;
+    XrdOucErrInfo lError;
+
+    if (!gOFS->_stat(srecyclepath, &buf, lError, rootvid, "", 0, false)) {
+      GetIndex().Add(GetIndexEntry(srecyclepath, buf));
+    }
+  }
+
   // store the recycle path in the error object
   error.setErrInfo(0, srecyclepath);
   return SFS_OK;
@@ -537,16 +786,17 @@ Recycle::Print(std::string& std_out, std::string& std_err,
                eos::common::Mapping::VirtualIdentity_t& vid, bool monitoring,
                bool translateids, bool details, std::string date, bool global)
 {
-  XrdOucString uids;
-  XrdOucString gids;
   std::map<uid_t, bool> printmap;
   eos::common::Mapping::VirtualIdentity rootvid;
   eos::common::Mapping::Root(rootvid);
   std::ostringstream oss_out;
 
-  if (global && ((!vid.uid) ||
-                 (eos::common::Mapping::HasUid(3, vid.uid_list)) ||
-                 (eos::common::Mapping::HasGid(4, vid.gid_list)))) {
+  const bool all_users = (global && ((!vid.uid) ||
+                                     (eos::common::Mapping::HasUid(3, vid.uid_list)) ||
+                                     (eos::common::Mapping::HasGid(4, vid.gid_list))));
+  const bool use_index = (details && GetIndex().IsReady());
+
+  if (all_users && !use_index) {
     // add everything found in the recycle directory structure to the printmap
     std::string subdirs;
     XrdMgmOfsDirectory dirl;
@@ -582,7 +832,43 @@ Recycle::Print(std::string& std_out, std::string& std_err,
 
   eos::common::Path dPath(std::string("/") + date);
 
-  if (details) {
+  if (use_index) {
+    // Page through the entries sorted by deletion time
+    size_t count = 0;
+    std::string cursor = "0";
+    std::vector<RecycleIndex::Entry> entries;
+
+    do {
+      if (!GetIndex().List(vid.uid, all_users, cursor, RecycleIndex::sPageSize,
+                           entries)) {
+        std_err += "error: failed to list the recycle bin index\n";
+        break;
+      }
+
+      for (const auto& entry : entries) {
+        if (!MatchesDate(entry, date)) {
+          continue;
+        }
+
+        if (!monitoring && (oss_out.tellp() > 1 * 1024 * 1024 * 1024)) {
+          oss_out << "... (truncated after 1G of output)" << std::endl;
+          std_out += oss_out.str();
+          std_err += "warning: list too long - truncated after 1GB of output!\n";
+          return;
+        }
+
+        PrintEntry(oss_out, entry, monitoring, translateids, (count == 0));
+        count++;
+
+        if ((vid.uid) && (!vid.sudoer) && (count > 100000)) {
+          oss_out << "... (truncated)" << std::endl;
+          std_out += oss_out.str();
+          std_err += "warning: list too long - truncated after 100000 entries!\n";
+          return;
+        }
+      }
+    } while (cursor != "0");
+  } else if (details) {
     size_t count = 0;
 
     for (auto ituid = printmap.begin(); ituid != printmap.end(); ituid++) {
@@ -625,7 +911,6 @@ Recycle::Print(std::string& std_out, std::string& std_err,
              ++fileit) {
           std::string fullpath = dirname.c_str();
           fullpath += *fileit;
-          XrdOucString originode;
           XrdOucString origpath = fileit->c_str();
           eos_static_debug("file=%s", fileit->c_str());
 
@@ -633,87 +918,20 @@ Recycle::Print(std::string& std_out, std::string& std_err,
             continue;
           }
 
-          // demangle the original pathname
-          while (origpath.replace("#:#", "/")) {
-          }
-
-          XrdOucString type = "file";
           struct stat buf;
           XrdOucErrInfo error;
 
           if (!gOFS->_stat(fullpath.c_str(), &buf, error, vid, "")) {
-            if (translateids) {
-              int errc = 0;
-              uids = eos::common::Mapping::UidToUserName(buf.st_uid, errc).c_str();
-
-              if (errc) {
-                uids = eos::common::Mapping::UidAsString(buf.st_uid).c_str();
-              }
-
-              gids = eos::common::Mapping::GidToGroupName(buf.st_gid, errc).c_str();
-
-              if (errc) {
-                gids = eos::common::Mapping::GidAsString(buf.st_gid).c_str();
-              }
-            } else {
-              uids = eos::common::Mapping::UidAsString(buf.st_uid).c_str();
-              gids = eos::common::Mapping::GidAsString(buf.st_gid).c_str();
-            }
-
-            if (origpath.endswith(Recycle::gRecyclingPostFix.c_str())) {
-              type = "recursive-dir";
-              origpath.erase(origpath.length() - Recycle::gRecyclingPostFix.length());
-            }
-
-            originode = origpath;
-            originode.erase(0, origpath.length() - 16);
-            origpath.erase(origpath.length() - 17);
-
-            if (monitoring) {
-              oss_out << "recycle=ls recycle-bin=" << Recycle::gRecyclingPrefix
-                      << " uid=" << uids.c_str() << " gid=" << gids.c_str()
-                      << " size=" << std::to_string(buf.st_size)
-                      << " deletion-time=" << std::to_string(buf.st_ctime)
-                      << " type=" << type.c_str()
-                      << " keylength.restore-path=" << origpath.length()
-                      << " restore-path=" << origpath.c_str()
-                      << " restore-key=" << originode.c_str()
-                      << std::endl;
-            } else {
-              char sline[4096];
-              XrdOucString sizestring;
-
-              if (count == 0) {
-                // print a header
-                snprintf(sline, sizeof(sline) - 1,
-                         "# %-24s %-8s %-8s %-12s %-13s %-16s %-64s\n", "Deletion Time", "UID", "GID",
-                         "SIZE", "TYPE", "RESTORE-KEY", "RESTORE-PATH");
-                oss_out << sline
-                        << "# ================================================"
-                        << "=================================================="
-                        << "============================" << std::endl;
-              }
-
-              char tdeltime[4096];
-              std::string deltime = ctime_r(&buf.st_ctime, tdeltime);
-              deltime.erase(deltime.length() - 1);
-              snprintf(sline, sizeof(sline) - 1, "%-26s %-8s %-8s %-12s %-13s %-16s %-64s",
-                       deltime.c_str(), uids.c_str(), gids.c_str(),
-                       eos::common::StringConversion::GetSizeString(sizestring,
-                           (unsigned long long) buf.st_size), type.c_str(), originode.c_str(),
-                       origpath.c_str());
-
-              if (oss_out.tellp() > 1 * 1024 * 1024 * 1024) {
-                retc = E2BIG;
-                oss_out << "... (truncated after 1G of output)" << std::endl;
-                std_out += oss_out.str();
-                std_err += "warning: list too long - truncated after 1GB of output!\n";
-                return;
-              }
-
-              oss_out << sline << std::endl;
+            if (!monitoring && (oss_out.tellp() > 1 * 1024 * 1024 * 1024)) {
+              retc = E2BIG;
+              oss_out << "... (truncated after 1G of output)" << std::endl;
+              std_out += oss_out.str();
+              std_err += "warning: list too long - truncated after 1GB of output!\n";
+              return;
             }
 
+            PrintEntry(oss_out, GetIndexEntry(fullpath, buf), monitoring,
+                       translateids, (count == 0));
             count++;
 
             if ((vid.uid) && (!vid.sudoer) && (count > 100000)) {
@@ -1181,6 +1399,16 @@ Recycle::Restore(std::string& std_out, std::string& std_err,
     std_out += "\n";
   }
 
+  if (GetIndex().IsEnabled()) {
+    RecycleIndex::Entry entry;
+    entry.mId = fid;
+    entry.mIsDir = (cmd != nullptr);
+
+    if (GetIndex().Lookup(entry.GetKey(), entry)) {
+      GetIndex().Remove(entry);
+    }
+  }
+
   if (restore_versions == false) {
     // don't restore old versions
     return 0;
@@ -1308,88 +1536,98 @@ Recycle::Purge(std::string& std_out, std::string& std_err,
     return EPERM;
   }
 
-  if (!global || (global && vid.uid)) {
-    snprintf(sdir, sizeof(sdir) - 1, "%s/uid:%u/%s",
-             Recycle::gRecyclingPrefix.c_str(),
-             (unsigned int) vid.uid,
-             date.c_str());
-  } else {
-    snprintf(sdir, sizeof(sdir) - 1, "%s/", Recycle::gRecyclingPrefix.c_str());
-  }
+  if (GetIndex().IsReady()) {
+    // Page through the index instead of walking the recycle bin
+    const bool all_users = (global && !vid.uid);
+    std::string cursor = "0";
+    std::vector<RecycleIndex::Entry> entries;
 
-  std::map<std::string, std::set < std::string>> findmap;
-  int depth = 5 + (int) global;
-  eos::common::Path dPath(std::string("/") + date);
+    do {
+      if (!GetIndex().List(vid.uid, all_users, cursor, RecycleIndex::sPageSize,
+                           entries)) {
+        std_err += "error: failed to list the recycle bin index\n";
+        return EIO;
+      }
 
-  if (dPath.GetSubPathSize()) {
-    if (depth > (int) dPath.GetSubPathSize()) {
-      depth -= dPath.GetSubPathSize();
-    }
-  }
+      for (const auto& entry : entries) {
+        if (!MatchesDate(entry, date)) {
+          continue;
+        }
 
-  XrdOucString err_msg;
-  int retc = gOFS->_find(sdir, lError, err_msg, rootvid, findmap,
-                         0, 0, false, 0, true, depth);
+        if (!PurgeEntry(entry.mPath, entry.mIsDir, std_out, std_err)) {
+          GetIndex().Remove(entry);
 
-  if (retc && errno != ENOENT) {
-    std_err = err_msg.c_str();
-    eos_static_err("msg=\"find command failed\" dir=\"%s\"", sdir);
-  }
+          if (entry.mIsDir) {
+            nbulk_deleted++;
+          } else {
+            nfiles_deleted++;
+          }
+        }
+      }
+    } while (cursor != "0");
+  } else {
+    if (!global || (global && vid.uid)) {
+      snprintf(sdir, sizeof(sdir) - 1, "%s/uid:%u/%s",
+               Recycle::gRecyclingPrefix.c_str(),
+               (unsigned int) vid.uid,
+               date.c_str());
+    } else {
+      snprintf(sdir, sizeof(sdir) - 1, "%s/", Recycle::gRecyclingPrefix.c_str());
+    }
 
-  for (auto dirit = findmap.begin(); dirit != findmap.end(); ++dirit) {
-    eos_static_debug("dir=%s", dirit->first.c_str());
-    XrdOucString dirname = dirit->first.c_str();
+    std::map<std::string, std::set < std::string>> findmap;
+    int depth = 5 + (int) global;
+    eos::common::Path dPath(std::string("/") + date);
 
-    if (dirname.endswith(".d/")) {
-      dirname.erase(dirname.length() - 1);
-      eos::common::Path cpath(dirname.c_str());
-      dirname = cpath.GetParentPath();
-      dirit->second.insert(cpath.GetName());
+    if (dPath.GetSubPathSize()) {
+      if (depth > (int) dPath.GetSubPathSize()) {
+        depth -= dPath.GetSubPathSize();
+      }
     }
 
-    for (auto fileit = dirit->second.begin(); fileit != dirit->second.end();
-         ++fileit) {
-      XrdOucString fname = fileit->c_str();
-      std::string pathname = dirname.c_str();
-      pathname += *fileit;
-      struct stat buf;
-      XrdOucErrInfo lError;
+    XrdOucString err_msg;
+    int retc = gOFS->_find(sdir, lError, err_msg, rootvid, findmap,
+                           0, 0, false, 0, true, depth);
 
-      if ((fname != "/") && !fname.beginswith("#")) {
-        continue;
-      }
+    if (retc && errno != ENOENT) {
+      std_err = err_msg.c_str();
+      eos_static_err("msg=\"find command failed\" dir=\"%s\"", sdir);
+    }
 
-      if (!gOFS->_stat(pathname.c_str(), &buf, lError, rootvid, "")) {
-        // execute a proc command
-        ProcCommand Cmd;
-        XrdOucString info;
+    for (auto dirit = findmap.begin(); dirit != findmap.end(); ++dirit) {
+      eos_static_debug("dir=%s", dirit->first.c_str());
+      XrdOucString dirname = dirit->first.c_str();
 
-        if (S_ISDIR(buf.st_mode)) {
-          // we need recursive deletion
-          info = "mgm.cmd=rm&mgm.option=r&mgm.path=";
-        } else {
-          info = "mgm.cmd=rm&mgm.path=";
-        }
+      if (dirname.endswith(".d/")) {
+        dirname.erase(dirname.length() - 1);
+        eos::common::Path cpath(dirname.c_str());
+        dirname = cpath.GetParentPath();
+        dirit->second.insert(cpath.GetName());
+      }
 
-        info += pathname.c_str();
-        int result = Cmd.open("/proc/user", info.c_str(), rootvid, &lError);
-        Cmd.AddOutput(std_out, std_err);
+      for (auto fileit = dirit->second.begin(); fileit != dirit->second.end();
+           ++fileit) {
+        XrdOucString fname = fileit->c_str();
+        std::string pathname = dirname.c_str();
+        pathname += *fileit;
+        struct stat buf;
+        XrdOucErrInfo lError;
 
-        if (*std_out.rbegin() != '\n') {
-          std_out += "\n";
+        if ((fname != "/") && !fname.beginswith("#")) {
+          continue;
         }
 
-        if (*std_err.rbegin() != '\n') {
-          std_err += "\n";
-        }
+        if (!gOFS->_stat(pathname.c_str(), &buf, lError, rootvid, "")) {
+          int result = PurgeEntry(pathname, S_ISDIR(buf.st_mode), std_out, std_err);
 
-        Cmd.close();
+          if (!result) {
+            GetIndex().Remove(GetIndexEntry(pathname, buf));
 
-        if (!result) {
-          if (S_ISDIR(buf.st_mode)) {
-            nbulk_deleted++;
-          } else {
-            nfiles_deleted++;
+            if (S_ISDIR(buf.st_mode)) {
+              nbulk_deleted++;
+            } else {
+              nfiles_deleted++;
+            }
           }
         }
       }
@@ -25,6 +25,7 @@
 #define __EOSMGM_RECYCLE__HH__
 
 #include "mgm/Namespace.hh"
+#include "mgm/RecycleIndex.hh"
 #include "common/AssistedThread.hh"
 #include "XrdOuc/XrdOucString.hh"
 #include <sys/types.h>
@@ -209,6 +210,11 @@ public:
                     eos::common::Mapping::VirtualIdentity_t& vid,
                     const std::string& key, const std::string& value);
 
+  //----------------------------------------------------------------------------
+  //! Get the index of the recycle bin persisted in QuarkDB
+  //----------------------------------------------------------------------------
+  static RecycleIndex& GetIndex();
+
   /**
    * set the wake-up flag in the recycle thread to look at modified recycle bin settings
    */
@@ -0,0 +1,242 @@
+//------------------------------------------------------------------------------
+// File: RecycleIndex.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/RecycleIndex.hh"
+#include "mgm/XrdMgmOfs.hh"
+#include "common/Logging.hh"
+#include "namespace/ns_quarkdb/BackendClient.hh"
+#include "namespace/ns_quarkdb/qclient/include/qclient/QClient.hh"
+#include "namespace/ns_quarkdb/qclient/include/qclient/QHash.hh"
+#include <iomanip>
+#include <sstream>
+
+EOSMGMNAMESPACE_BEGIN
+
+static const std::string sIndexKey = "eos-recycle-index";
+static const std::string sKeysKey = "eos-recycle-index-keys";
+static const std::string sStateKey = "eos-recycle-index-state";
+
+//------------------------------------------------------------------------------
+// Get key of the per user hash
+//------------------------------------------------------------------------------
+static std::string
+GetUserKey(uid_t uid)
+{
+  return SSTR(sIndexKey << ":" << uid);
+}
+
+//------------------------------------------------------------------------------
+// Get recycle key of the entry
+//------------------------------------------------------------------------------
+std::string
+RecycleIndex::Entry::GetKey() const
+{
+  std::ostringstream oss;
+  oss << (mIsDir ? "pxid:" : "fxid:") << std::hex << std::setfill('0')
+      << std::setw(16) << mId;
+  return oss.str();
+}
+
+//------------------------------------------------------------------------------
+// Get field of the entry in the time ordered hashes
+//------------------------------------------------------------------------------
+std::string
+RecycleIndex::Entry::GetField() const
+{
+  std::ostringstream oss;
+  oss << std::setfill('0') << std::setw(20) << (uint64_t) mDeletionTime
+      << ":" << GetKey();
+  return oss.str();
+}
+
+//------------------------------------------------------------------------------
+// Serialize the entry, the path goes last as it may contain any character
+//------------------------------------------------------------------------------
+std::string
+RecycleIndex::Entry::Serialize() const
+{
+  std::ostringstream oss;
+  oss << mDeletionTime << " " << mId << " " << (mIsDir ? "d" : "f") << " "
+      << mUid << " " << mGid << " " << mSize << " " << mPath;
+  return oss.str();
+}
+
+//------------------------------------------------------------------------------
+// Deserialize an entry
+//------------------------------------------------------------------------------
+bool
+RecycleIndex::Entry::Deserialize(const std::string& data, Entry& entry)
+{
+  std::istringstream iss(data);
+  std::string type;
+  uint64_t deletion_time;
+
+  if (!(iss >> deletion_time >> entry.mId >> type >> entry.mUid >> entry.mGid
+        >> entry.mSize)) {
+    return false;
+  }
+
+  if ((type != "d") && (type != "f")) {
+    return false;
+  }
+
+  entry.mDeletionTime = deletion_time;
+  entry.mIsDir = (type == "d");
+  entry.mPath.clear();
+  iss.get();
+  return (std::getline(iss, entry.mPath) && !entry.mPath.empty());
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+RecycleIndex::RecycleIndex():
+  mQcl(nullptr), mReady(false)
+{
+  if (!gOFS->mQdbCluster.empty()) {
+    mQcl = eos::BackendClient::getInstance(gOFS->mQdbContactDetails, "recycle");
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check if the index was built
+//------------------------------------------------------------------------------
+bool
+RecycleIndex::IsReady()
+{
+  if (!mQcl) {
+    return false;
+  }
+
+  if (!mReady) {
+    qclient::redisReplyPtr reply = mQcl->exec("GET", sStateKey).get();
+
+    if (reply && (reply->type == REDIS_REPLY_STRING) &&
+        (std::string(reply->str, reply->len) == "ready")) {
+      mReady = true;
+    }
+  }
+
+  return mReady;
+}
+
+//------------------------------------------------------------------------------
+// Mark the index as built
+//------------------------------------------------------------------------------
+void
+RecycleIndex::SetReady()
+{
+  if (mQcl) {
+    mQcl->exec("SET", sStateKey, "ready");
+    mReady = true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add an entry
+//------------------------------------------------------------------------------
+void
+RecycleIndex::Add(const Entry& entry)
+{
+  if (mQcl) {
+    const std::string field = entry.GetField();
+    const std::string value = entry.Serialize();
+    mQcl->exec("HSET", sIndexKey, field, value);
+    mQcl->exec("HSET", GetUserKey(entry.mUid), field, value);
+    mQcl->exec("HSET", sKeysKey, entry.GetKey(), value);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove an entry
+//------------------------------------------------------------------------------
+void
+RecycleIndex::Remove(const Entry& entry)
+{
+  if (mQcl) {
+    const std::string field = entry.GetField();
+    mQcl->exec("HDEL", sIndexKey, field);
+    mQcl->exec("HDEL", GetUserKey(entry.mUid), field);
+    mQcl->exec("HDEL", sKeysKey, entry.GetKey());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Look up an entry by its recycle key
+//------------------------------------------------------------------------------
+bool
+RecycleIndex::Lookup(const std::string& key, Entry& entry)
+{
+  if (!mQcl) {
+    return false;
+  }
+
+  qclient::redisReplyPtr reply = mQcl->exec("HGET", sKeysKey, key).get();
+
+  if (!reply || (reply->type != REDIS_REPLY_STRING)) {
+    return false;
+  }
+
+  return Entry::Deserialize(std::string(reply->str, reply->len), entry);
+}
+
+//------------------------------------------------------------------------------
+// Get the next page of entries sorted by deletion time
+//------------------------------------------------------------------------------
+bool
+RecycleIndex::List(uid_t uid, bool global, std::string& cursor, size_t count,
+                   std::vector<Entry>& entries)
+{
+  entries.clear();
+
+  if (!mQcl) {
+    return false;
+  }
+
+  qclient::QHash hash(*mQcl, global ? sIndexKey : GetUserKey(uid));
+  std::pair<std::string, std::map<std::string, std::string>> reply;
+
+  try {
+    reply = hash.hscan(cursor, count);
+  } catch (const std::exception& e) {
+    eos_static_err("msg=\"failed to list recycle index\" cursor=%s err=\"%s\"",
+                   cursor.c_str(), e.what());
+    return false;
+  }
+
+  cursor = reply.first;
+
+  for (const auto& elem : reply.second) {
+    Entry entry;
+
+    if (Entry::Deserialize(elem.second, entry)) {
+      entries.push_back(std::move(entry));
+    } else {
+      eos_static_err("msg=\"malformed recycle index entry\" field=%s",
+                     elem.first.c_str());
+    }
+  }
+
+  return true;
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,163 @@
+//------------------------------------------------------------------------------
+//! @file RecycleIndex.hh
+//! @brief Index of the recycle bin entries persisted in QuarkDB
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace qclient
+{
+class QClient;
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Class maintaining a secondary index of the recycle bin in QuarkDB
+//!
+//! Every entry of the new style recycle bin (<prefix>/uid:<uid>/<date>/...)
+//! is stored in the hash eos-recycle-index and in the per user hash
+//! eos-recycle-index:<uid>. The fields are <deletion time>:<recycle key>
+//! with the deletion time zero padded, so that scanning a hash returns the
+//! entries sorted by deletion time. The hash eos-recycle-index-keys maps the
+//! recycle keys to their entries to remove them on restore. The index is
+//! built once by the recycler from the namespace, which is recorded in the
+//! string eos-recycle-index-state. Without a QuarkDB namespace the index is
+//! disabled and the recycle bin has to be walked through the namespace.
+//------------------------------------------------------------------------------
+class RecycleIndex
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Entry of the recycle bin
+  //----------------------------------------------------------------------------
+  struct Entry {
+    time_t mDeletionTime = 0;
+    uint64_t mId = 0; ///< File or container id
+    bool mIsDir = false; ///< Recursive directory deletion
+    uid_t mUid = 0;
+    gid_t mGid = 0;
+    uint64_t mSize = 0;
+    std::string mPath; ///< Path in the recycle bin
+
+    //--------------------------------------------------------------------------
+    //! Get recycle key of the entry i.e. fxid:<hex> or pxid:<hex>
+    //--------------------------------------------------------------------------
+    std::string GetKey() const;
+
+    //--------------------------------------------------------------------------
+    //! Get field of the entry in the time ordered hashes
+    //--------------------------------------------------------------------------
+    std::string GetField() const;
+
+    //--------------------------------------------------------------------------
+    //! Serialize the entry
+    //--------------------------------------------------------------------------
+    std::string Serialize() const;
+
+    //--------------------------------------------------------------------------
+    //! Deserialize an entry
+    //!
+    //! @param data serialized entry
+    //! @param entry output entry
+    //!
+    //! @return true if successful, otherwise false
+    //--------------------------------------------------------------------------
+    static bool Deserialize(const std::string& data, Entry& entry);
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  RecycleIndex();
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~RecycleIndex() = default;
+
+  //----------------------------------------------------------------------------
+  //! Check if the index is persisted i.e. there is a QuarkDB namespace
+  //----------------------------------------------------------------------------
+  inline bool IsEnabled() const
+  {
+    return (mQcl != nullptr);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if the index was built and can be used instead of the namespace
+  //----------------------------------------------------------------------------
+  bool IsReady();
+
+  //----------------------------------------------------------------------------
+  //! Mark the index as built
+  //----------------------------------------------------------------------------
+  void SetReady();
+
+  //----------------------------------------------------------------------------
+  //! Add an entry asynchronously
+  //----------------------------------------------------------------------------
+  void Add(const Entry& entry);
+
+  //----------------------------------------------------------------------------
+  //! Remove an entry asynchronously
+  //----------------------------------------------------------------------------
+  void Remove(const Entry& entry);
+
+  //----------------------------------------------------------------------------
+  //! Look up an entry by its recycle key
+  //!
+  //! @param key recycle key i.e. fxid:<hex> or pxid:<hex>
+  //! @param entry output entry
+  //!
+  //! @return true if found, otherwise false
+  //----------------------------------------------------------------------------
+  bool Lookup(const std::string& key, Entry& entry);
+
+  //----------------------------------------------------------------------------
+  //! Get the next page of entries sorted by deletion time
+  //!
+  //! @param uid user whose entries to list
+  //! @param global if true list the entries of all users, uid is ignored
+  //! @param cursor scan cursor, "0" to start, updated to the cursor of the
+  //!        next page, "0" once all entries were listed
+  //! @param count max number of entries to return
+  //! @param entries output entries
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool List(uid_t uid, bool global, std::string& cursor, size_t count,
+            std::vector<Entry>& entries);
+
+  static constexpr size_t sPageSize = 1000; ///< Default page size
+
+private:
+  qclient::QClient* mQcl; ///< QuarkDB client, nullptr if not persisted
+  std::atomic<bool> mReady; ///< Cached readiness of the index
+};
+
+EOSMGMNAMESPACE_END
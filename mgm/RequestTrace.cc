@@ -0,0 +1,330 @@
+//------------------------------------------------------------------------------
+// File: RequestTrace.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/RequestTrace.hh"
+#include "common/Logging.hh"
+#include "XrdSys/XrdSysDNS.hh"
+#include <arpa/inet.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <netinet/in.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+EOSMGMNAMESPACE_BEGIN
+
+std::atomic<uint64_t> RequestTrace::sThresholdNs {0};
+std::atomic<uint32_t> RequestTrace::sModulo {1};
+
+namespace
+{
+//------------------------------------------------------------------------------
+//! UDP destination of the slow request reports
+//------------------------------------------------------------------------------
+struct UdpTarget {
+  std::mutex mMutex;
+  int mSocket {-1};
+  struct sockaddr_in mAddr;
+};
+
+UdpTarget&
+GetUdpTarget()
+{
+  static UdpTarget* target = new UdpTarget();
+  return *target;
+}
+
+//------------------------------------------------------------------------------
+//! Escape a string for a JSON value
+//------------------------------------------------------------------------------
+std::string
+JsonEscape(const std::string& in)
+{
+  std::string out;
+  out.reserve(in.size());
+
+  for (char c : in) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if ((unsigned char) c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out += c;
+    }
+  }
+
+  return out;
+}
+}
+
+//------------------------------------------------------------------------------
+// Configure the tracing
+//------------------------------------------------------------------------------
+void
+RequestTrace::Configure(uint64_t threshold_ms, double sampling)
+{
+  uint32_t modulo = 1;
+
+  if (sampling > 0 && sampling < 1.0) {
+    modulo = (uint32_t) std::lround(1.0 / sampling);
+  } else if (sampling <= 0) {
+    threshold_ms = 0;
+  }
+
+  sModulo = modulo;
+  sThresholdNs = threshold_ms * 1000000ull;
+}
+
+//------------------------------------------------------------------------------
+// Configure the tracing from the environment
+//------------------------------------------------------------------------------
+void
+RequestTrace::ConfigureFromEnv()
+{
+  uint64_t threshold_ms = 0;
+  double sampling = 1.0;
+
+  if (getenv("EOS_MGM_TRACE_SLOW_MS")) {
+    threshold_ms = strtoull(getenv("EOS_MGM_TRACE_SLOW_MS"), nullptr, 10);
+  }
+
+  if (getenv("EOS_MGM_TRACE_SAMPLING")) {
+    sampling = strtod(getenv("EOS_MGM_TRACE_SAMPLING"), nullptr);
+  }
+
+  Configure(threshold_ms, sampling);
+
+  if (getenv("EOS_MGM_TRACE_UDP")) {
+    if (!SetUdpTarget(getenv("EOS_MGM_TRACE_UDP"))) {
+      eos_static_err("msg=\"failed to set trace udp target\" target=%s",
+                     getenv("EOS_MGM_TRACE_UDP"));
+    }
+  }
+
+  if (threshold_ms) {
+    eos_static_info("msg=\"request tracing enabled\" slow_ms=%llu "
+                    "sampling=%.4f", (unsigned long long) threshold_ms,
+                    1.0 / sModulo.load());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Send the slow requests also to a UDP target
+//------------------------------------------------------------------------------
+bool
+RequestTrace::SetUdpTarget(const std::string& target)
+{
+  UdpTarget& udp = GetUdpTarget();
+  std::lock_guard<std::mutex> lock(udp.mMutex);
+
+  if (udp.mSocket >= 0) {
+    close(udp.mSocket);
+    udp.mSocket = -1;
+  }
+
+  if (target.empty()) {
+    return true;
+  }
+
+  std::string host = target;
+  int port = 31000;
+  size_t pos = target.rfind(':');
+
+  if (pos != std::string::npos) {
+    host = target.substr(0, pos);
+    port = atoi(target.c_str() + pos + 1);
+  }
+
+  if (host.empty() || (port <= 0) || (port > 65535)) {
+    return false;
+  }
+
+  memset(&udp.mAddr, 0, sizeof(udp.mAddr));
+
+  if (!XrdSysDNS::getHostAddr(host.c_str(), (struct sockaddr*) &udp.mAddr)) {
+    return false;
+  }
+
+  udp.mAddr.sin_family = AF_INET;
+  udp.mAddr.sin_port = htons(port);
+  udp.mSocket = socket(AF_INET, SOCK_DGRAM, 0);
+  return (udp.mSocket >= 0);
+}
+
+//------------------------------------------------------------------------------
+// Decide if the next request of the calling thread is traced
+//------------------------------------------------------------------------------
+bool
+RequestTrace::Sample()
+{
+  static thread_local uint32_t counter = 0;
+  uint32_t modulo = sModulo.load(std::memory_order_relaxed);
+
+  if (++counter < modulo) {
+    return false;
+  }
+
+  counter = 0;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+RequestTrace::RequestTrace(const char* op, const char* log_id):
+  mActive(false), mOp(op)
+{
+  if (sThresholdNs.load(std::memory_order_relaxed) && Sample()) {
+    mActive = true;
+    snprintf(mLogId, sizeof(mLogId), "%s", log_id ? log_id : "");
+    mStart = mLast = Clock::now();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+RequestTrace::~RequestTrace()
+{
+  if (!mActive) {
+    return;
+  }
+
+  DoMark("finish");
+  uint64_t threshold = sThresholdNs.load(std::memory_order_relaxed);
+
+  if (!threshold || (GetElapsedNs() < threshold)) {
+    return;
+  }
+
+  eos_static_warning("%s", Report(false).c_str());
+  UdpTarget& udp = GetUdpTarget();
+  std::lock_guard<std::mutex> lock(udp.mMutex);
+
+  if (udp.mSocket >= 0) {
+    std::string msg = Report(true);
+
+    if (sendto(udp.mSocket, msg.c_str(), msg.length(), 0,
+               (struct sockaddr*) &udp.mAddr, sizeof(udp.mAddr)) < 0) {
+      eos_static_debug("msg=\"failed to send trace udp message\" errno=%d",
+                       errno);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Attach the path and the identity of the request to the report
+//------------------------------------------------------------------------------
+void
+RequestTrace::SetInfo(const char* path, uid_t uid, gid_t gid)
+{
+  if (mActive) {
+    mPath = (path ? path : "");
+    mUid = uid;
+    mGid = gid;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Account the time since the previous mark to a stage
+//------------------------------------------------------------------------------
+void
+RequestTrace::DoMark(const char* stage)
+{
+  Clock::time_point now = Clock::now();
+  uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>
+                (now - mLast).count();
+  mLast = now;
+
+  for (size_t i = 0; i < mNumStages; ++i) {
+    if (mStages[i].mName == stage) {
+      mStages[i].mNs += ns;
+      return;
+    }
+  }
+
+  if (mNumStages < kMaxStages) {
+    mStages[mNumStages++] = {stage, ns};
+  } else {
+    // Out of slots, account to the last stage so that the sum still holds
+    mStages[kMaxStages - 1].mNs += ns;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Total time since the trace was started
+//------------------------------------------------------------------------------
+uint64_t
+RequestTrace::GetElapsedNs() const
+{
+  if (!mActive) {
+    return 0;
+  }
+
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+         (mLast - mStart).count();
+}
+
+//------------------------------------------------------------------------------
+// Build the report of the request
+//------------------------------------------------------------------------------
+std::string
+RequestTrace::Report(bool json) const
+{
+  std::ostringstream oss;
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.3f", GetElapsedNs() / 1e6);
+
+  if (json) {
+    oss << "{\"op\": \"" << mOp << "\", \"logid\": \"" << mLogId
+        << "\", \"path\": \"" << JsonEscape(mPath) << "\", \"uid\": " << mUid
+        << ", \"gid\": " << mGid << ", \"total_ms\": " << buf
+        << ", \"stages_ms\": {";
+
+    for (size_t i = 0; i < mNumStages; ++i) {
+      snprintf(buf, sizeof(buf), "%.3f", mStages[i].mNs / 1e6);
+      oss << (i ? ", " : "") << "\"" << mStages[i].mName << "\": " << buf;
+    }
+
+    oss << "}}";
+  } else {
+    oss << "msg=\"slow request\" op=" << mOp << " logid=" << mLogId
+        << " path=\"" << mPath << "\" uid=" << mUid << " gid=" << mGid
+        << " total_ms=" << buf;
+
+    for (size_t i = 0; i < mNumStages; ++i) {
+      snprintf(buf, sizeof(buf), "%.3f", mStages[i].mNs / 1e6);
+      oss << " " << mStages[i].mName << "_ms=" << buf;
+    }
+  }
+
+  return oss.str();
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,164 @@
+//------------------------------------------------------------------------------
+//! @file RequestTrace.hh
+//! @brief Per-request stage timing of MGM operations with slow request log
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Span of one request, split into stages at fixed instrumentation
+//! points
+//!
+//! The trace is a stack object living for the whole request. Every Mark call
+//! accounts the time elapsed since the previous one to the given stage, so the
+//! stages always add up to the total. Marks with the same stage name (string
+//! literal) accumulate. When the trace goes out of scope, requests slower than
+//! the threshold are written with their log id to the RequestTrace.log fan-out
+//! and optionally sent as JSON to a UDP target. Requests not sampled cost one
+//! relaxed load, sampled ones one clock read per mark and the copy of the path.
+//------------------------------------------------------------------------------
+class RequestTrace
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Configure the tracing
+  //!
+  //! @param threshold_ms requests slower than this are reported, 0 disables
+  //!        the tracing
+  //! @param sampling fraction of the requests to trace
+  //----------------------------------------------------------------------------
+  static void Configure(uint64_t threshold_ms, double sampling = 1.0);
+
+  //----------------------------------------------------------------------------
+  //! Configure the tracing from EOS_MGM_TRACE_SLOW_MS, EOS_MGM_TRACE_SAMPLING
+  //! and EOS_MGM_TRACE_UDP
+  //----------------------------------------------------------------------------
+  static void ConfigureFromEnv();
+
+  //----------------------------------------------------------------------------
+  //! Send the slow requests also to a UDP target
+  //!
+  //! @param target <host>[:<port>], empty to disable. Default port is 31000
+  //!        like for the Iostat UDP targets.
+  //!
+  //! @return true if successful
+  //----------------------------------------------------------------------------
+  static bool SetUdpTarget(const std::string& target);
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param op operation name, string literal
+  //! @param log_id log id of the request, used as span id
+  //----------------------------------------------------------------------------
+  RequestTrace(const char* op, const char* log_id);
+
+  //----------------------------------------------------------------------------
+  //! Destructor - reports the request if slow
+  //----------------------------------------------------------------------------
+  ~RequestTrace();
+
+  //----------------------------------------------------------------------------
+  //! Copy constructor and assignment
+  //----------------------------------------------------------------------------
+  RequestTrace(const RequestTrace&) = delete;
+  RequestTrace& operator=(const RequestTrace&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Check if this request is traced
+  //----------------------------------------------------------------------------
+  inline bool IsActive() const
+  {
+    return mActive;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Account the time since the previous mark to a stage
+  //!
+  //! @param stage stage name, string literal
+  //----------------------------------------------------------------------------
+  inline void Mark(const char* stage)
+  {
+    if (mActive) {
+      DoMark(stage);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Attach the path and the identity of the request to the report
+  //----------------------------------------------------------------------------
+  void SetInfo(const char* path, uid_t uid, gid_t gid);
+
+  //----------------------------------------------------------------------------
+  //! Build the report of the request
+  //!
+  //! @param json if true JSON format, otherwise key=value
+  //----------------------------------------------------------------------------
+  std::string Report(bool json) const;
+
+  //----------------------------------------------------------------------------
+  //! Total time since the trace was started
+  //----------------------------------------------------------------------------
+  uint64_t GetElapsedNs() const;
+
+private:
+  static constexpr size_t kMaxStages = 16;
+  typedef std::chrono::steady_clock Clock;
+
+  //----------------------------------------------------------------------------
+  //! Account the time since the previous mark to a stage
+  //----------------------------------------------------------------------------
+  void DoMark(const char* stage);
+
+  //----------------------------------------------------------------------------
+  //! Decide if the next request of the calling thread is traced
+  //----------------------------------------------------------------------------
+  static bool Sample();
+
+  struct Stage {
+    const char* mName;
+    uint64_t mNs;
+  };
+
+  bool mActive;
+  const char* mOp;
+  char mLogId[40];
+  std::string mPath;
+  uid_t mUid {0};
+  gid_t mGid {0};
+  Clock::time_point mStart;
+  Clock::time_point mLast;
+  size_t mNumStages {0};
+  Stage mStages[kMaxStages];
+
+  static std::atomic<uint64_t> sThresholdNs; ///< 0 if tracing is disabled
+  static std::atomic<uint32_t> sModulo; ///< trace 1 out of sModulo requests
+};
+
+EOSMGMNAMESPACE_END
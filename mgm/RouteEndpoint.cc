@@ -24,6 +24,7 @@
 #include "common/StringConversion.hh"
 #include "XrdCl/XrdClURL.hh"
 #include "XrdCl/XrdClFileSystem.hh"
+#include <chrono>
 #include <sstream>
 
 EOSMGMNAMESPACE_BEGIN
@@ -40,6 +41,7 @@ RouteEndpoint::operator =(RouteEndpoint&& other) noexcept
     mHttpPort = other.mHttpPort;
     mIsOnline.store(other.mIsOnline.load());
     mIsMaster.store(other.mIsMaster.load());
+    mLatencyUs.store(other.mLatencyUs.load());
   }
 
   return *this;
@@ -100,6 +102,7 @@ RouteEndpoint::UpdateStatus()
 
   // Check if node is online
   XrdCl::FileSystem fs(url);
+  auto start = std::chrono::steady_clock::now();
   XrdCl::XRootDStatus st = fs.Ping(1);
 
   if (!st.IsOK()) {
@@ -109,6 +112,11 @@ RouteEndpoint::UpdateStatus()
     return;
   }
 
+  uint64_t latency = std::chrono::duration_cast<std::chrono::microseconds>
+                     (std::chrono::steady_clock::now() - start).count();
+  uint64_t old_latency = mLatencyUs.load();
+  // Exponentially weighted average over the last pings
+  mLatencyUs.store(old_latency ? (7 * old_latency + latency) / 8 : latency);
   mIsOnline.store(true);
   /* TODO: review if we want to have this policy by hostname or not ... currently disabled
   // If the host names is not starting with eos, we assume that is just a plain XrootD service
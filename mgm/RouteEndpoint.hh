@@ -23,6 +23,7 @@
 #pragma once
 #include "mgm/Namespace.hh"
 #include "common/Logging.hh"
+#include <atomic>
 #include <string>
 #include <stdint.h>
 
@@ -38,7 +39,8 @@ public:
   //! Constructor
   //----------------------------------------------------------------------------
   RouteEndpoint():
-    mIsOnline(false), mIsMaster(false), mXrdPort(0), mHttpPort(0)
+    mIsOnline(false), mIsMaster(false), mLatencyUs(0), mXrdPort(0),
+    mHttpPort(0)
   {}
 
   //----------------------------------------------------------------------------
@@ -49,8 +51,8 @@ public:
   //! @param http_port http redirection port
   //----------------------------------------------------------------------------
   RouteEndpoint(const std::string& fqdn, uint32_t xrd_port, uint32_t http_port):
-    mIsOnline(false), mIsMaster(false), mFqdn(fqdn), mXrdPort(xrd_port),
-    mHttpPort(http_port)
+    mIsOnline(false), mIsMaster(false), mLatencyUs(0), mFqdn(fqdn),
+    mXrdPort(xrd_port), mHttpPort(http_port)
   {}
 
   //----------------------------------------------------------------------------
@@ -112,7 +114,8 @@ public:
   }
 
   //----------------------------------------------------------------------------
-  //! Update status - both the online and master status
+  //! Update status - both the online and master status and the smoothed
+  //! latency of the ping
   //------------------------------------------------------------------------------
   void UpdateStatus();
 
@@ -136,6 +139,7 @@ public:
 
   std::atomic<bool> mIsOnline; ///< Mark if node is online
   std::atomic<bool> mIsMaster; ///< Mark if node is master
+  std::atomic<uint64_t> mLatencyUs; ///< Smoothed ping latency in microseconds
 
 private:
   std::string mFqdn; ///< Redirection host fqdn
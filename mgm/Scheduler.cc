@@ -24,6 +24,7 @@
 #include "mgm/Scheduler.hh"
 #include "mgm/Quota.hh"
 #include "GeoTreeEngine.hh"
+#include <cstring>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -42,21 +43,12 @@ Scheduler::Scheduler() { }
 Scheduler::~Scheduler() { }
 
 //------------------------------------------------------------------------------
-// Write placement routine - the caller routine has to lock via =>
-// eos::common::RWMutexReadLock(FsView::gFsView.ViewMutex)
+// Get the number of collocated filesystems for the placement policy
 //------------------------------------------------------------------------------
-int
-Scheduler::FilePlacement(PlacementArguments* args)
+unsigned int
+Scheduler::GetCollocatedFs(const PlacementArguments* args,
+                           unsigned int nfilesystems)
 {
-  eos_static_debug("requesting file placement from geolocation %s",
-                   args->vid->geolocation.c_str());
-  // the caller routine has to lock via => eos::common::RWMutexReadLock(FsView::gFsView.ViewMutex)
-  std::map<eos::common::FileSystem::fsid_t, float> availablefs;
-  std::map<eos::common::FileSystem::fsid_t, std::string> availablefsgeolocation;
-  std::list<eos::common::FileSystem::fsid_t> availablevector;
-  // fill the avoid list from the selected_filesystems input vector
-  unsigned int nfilesystems = eos::common::LayoutId::GetStripeNumber(
-                                args->lid) + 1;
   unsigned int ncollocatedfs = 0;
 
   switch (args->plctpolicy) {
@@ -92,22 +84,49 @@ Scheduler::FilePlacement(PlacementArguments* args)
     ncollocatedfs = nfilesystems;
   }
 
-  eos_static_debug("checking placement policy : policy is %d, nfilesystems is"
-                   " %d and ncollocated is %d", (int)args->plctpolicy, (int)nfilesystems,
-                   (int)ncollocatedfs);
-  uid_t uid = args->vid->uid;
-  gid_t gid = args->vid->gid;
+  return ncollocatedfs;
+}
+
+//------------------------------------------------------------------------------
+// Get the tag used to remember the last scheduling group
+//------------------------------------------------------------------------------
+std::string
+Scheduler::GetIndexTag(const PlacementArguments* args)
+{
   XrdOucString lindextag = "";
 
   if (args->grouptag) {
     lindextag = args->grouptag;
   } else {
-    lindextag += (int) uid;
+    lindextag += (int) args->vid->uid;
     lindextag += ":";
-    lindextag += (int) gid;
+    lindextag += (int) args->vid->gid;
   }
 
-  std::string indextag = lindextag.c_str();
+  return lindextag.c_str();
+}
+
+//------------------------------------------------------------------------------
+// Write placement routine - the caller routine has to lock via =>
+// eos::common::RWMutexReadLock(FsView::gFsView.ViewMutex)
+//------------------------------------------------------------------------------
+int
+Scheduler::FilePlacement(PlacementArguments* args)
+{
+  eos_static_debug("requesting file placement from geolocation %s",
+                   args->vid->geolocation.c_str());
+  // the caller routine has to lock via => eos::common::RWMutexReadLock(FsView::gFsView.ViewMutex)
+  std::map<eos::common::FileSystem::fsid_t, float> availablefs;
+  std::map<eos::common::FileSystem::fsid_t, std::string> availablefsgeolocation;
+  std::list<eos::common::FileSystem::fsid_t> availablevector;
+  // fill the avoid list from the selected_filesystems input vector
+  unsigned int nfilesystems = eos::common::LayoutId::GetStripeNumber(
+                                args->lid) + 1;
+  unsigned int ncollocatedfs = GetCollocatedFs(args, nfilesystems);
+  eos_static_debug("checking placement policy : policy is %d, nfilesystems is"
+                   " %d and ncollocated is %d", (int)args->plctpolicy, (int)nfilesystems,
+                   (int)ncollocatedfs);
+  std::string indextag = GetIndexTag(args);
   std::set<FsGroup*>::const_iterator git;
   std::vector<std::string> fsidsgeotags;
   std::vector<FsGroup*> groupsToTry;
@@ -240,14 +259,173 @@ Scheduler::FilePlacement(PlacementArguments* args)
   return ENOSPC;
 }
 
+//------------------------------------------------------------------------------
+// Check if a placement can be part of a batch started by the reference one
+//------------------------------------------------------------------------------
+static bool
+IsSameBatch(const Scheduler::PlacementArguments* ref,
+            const Scheduler::PlacementArguments* args)
+{
+  auto same_str = [](const char* a, const char* b) {
+    return ((!a && !b) || (a && b && !strcmp(a, b)));
+  };
+  auto same_geotag = [](const std::string * a, const std::string * b) {
+    return ((a ? *a : "") == (b ? *b : ""));
+  };
+  return (args->isValid() &&
+          (args->lid == ref->lid) &&
+          (*args->spacename == *ref->spacename) &&
+          same_str(args->grouptag, ref->grouptag) &&
+          (args->plctpolicy == ref->plctpolicy) &&
+          same_geotag(args->plctTrgGeotag, ref->plctTrgGeotag) &&
+          (args->bookingsize == ref->bookingsize) &&
+          (args->forced_scheduling_group_index < 0) &&
+          args->alreadyused_filesystems->empty() &&
+          (args->vid->uid == ref->vid->uid) &&
+          (args->vid->gid == ref->vid->gid) &&
+          (args->vid->geolocation == ref->vid->geolocation));
+}
+
+//------------------------------------------------------------------------------
+// Write placement routine for a batch of files - the caller routine has to
+// lock via => eos::common::RWMutexReadLock(FsView::gFsView.ViewMutex)
+//------------------------------------------------------------------------------
+int
+Scheduler::FilePlacement(const std::vector<PlacementArguments*>& batch,
+                         std::vector<int>* retc)
+{
+  if (retc) {
+    retc->assign(batch.size(), 0);
+  }
+
+  if (batch.empty()) {
+    return 0;
+  }
+
+  const PlacementArguments* ref = batch.front();
+  bool same_batch = ref->isValid() &&
+                    (ref->forced_scheduling_group_index < 0) &&
+                    ref->alreadyused_filesystems->empty();
+
+  for (size_t i = 1; same_batch && (i < batch.size()); ++i) {
+    same_batch = IsSameBatch(ref, batch[i]);
+  }
+
+  if (!same_batch) {
+    // Requests which can not be amortized are placed one by one
+    int first_err = 0;
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+      int rc = FilePlacement(batch[i]);
+
+      if (retc) {
+        (*retc)[i] = rc;
+      }
+
+      if (rc && !first_err) {
+        first_err = rc;
+      }
+    }
+
+    return first_err;
+  }
+
+  unsigned int nfilesystems = eos::common::LayoutId::GetStripeNumber(
+                                ref->lid) + 1;
+  unsigned int ncollocatedfs = GetCollocatedFs(ref, nfilesystems);
+  std::string indextag = GetIndexTag(ref);
+  auto it_space = FsView::gFsView.mSpaceGroupView.find(*ref->spacename);
+
+  if (it_space == FsView::gFsView.mSpaceGroupView.end()) {
+    for (size_t i = 0; i < batch.size(); ++i) {
+      batch[i]->selected_filesystems->clear();
+
+      if (retc) {
+        (*retc)[i] = ENOSPC;
+      }
+    }
+
+    return ENOSPC;
+  }
+
+  const std::set<FsGroup*>& groups = it_space->second;
+  std::vector<GeoTreeEngine::BatchPlacement> requests(batch.size());
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    requests[i].inode = batch[i]->inode;
+    requests[i].newReplicas = batch[i]->selected_filesystems;
+    requests[i].dataProxys = batch[i]->dataproxys;
+    requests[i].firewallEntryPoint = batch[i]->firewallentpts;
+  }
+
+  size_t next = 0;
+
+  if (!groups.empty()) {
+    std::set<FsGroup*>::const_iterator git;
+    {
+      XrdSysMutexHelper scope_lock(pMapMutex);
+      git = (schedulingGroup.count(indextag) ?
+             groups.find(schedulingGroup[indextag]) : groups.begin());
+
+      if (git == groups.end()) {
+        git = groups.begin();
+      }
+    }
+    // Every group gets a chunk of consecutive files so that the group lookup
+    // is amortized while the batch is still spread over all the groups
+    size_t chunk = (batch.size() + groups.size() - 1) / groups.size();
+    size_t no_progress = 0;
+
+    while ((next < batch.size()) && (no_progress < groups.size())) {
+      FsGroup* group = *git;
+      size_t placed = gGeoTreeEngine.placeNewReplicasOneGroupBatch(
+                        group, nfilesystems, requests, next, chunk,
+                        GeoTreeEngine::regularRW, ref->bookingsize,
+                        ref->plctTrgGeotag ? *ref->plctTrgGeotag : "",
+                        ref->vid->geolocation, ncollocatedfs);
+      eos_static_debug("msg=\"batch placement\" group=%s placed=%lu "
+                       "requested=%lu", group->mName.c_str(),
+                       (unsigned long) placed, (unsigned long) chunk);
+      next += placed;
+      no_progress = (placed ? 0 : no_progress + 1);
+
+      if (++git == groups.end()) {
+        git = groups.begin();
+      }
+    }
+
+    // remember the last group for that indextag
+    XrdSysMutexHelper scope_lock(pMapMutex);
+    schedulingGroup[indextag] = *git;
+  }
+
+  if (next == batch.size()) {
+    return 0;
+  }
+
+  eos_static_debug("msg=\"could not place all the files of the batch\" "
+                   "placed=%lu total=%lu", (unsigned long) next,
+                   (unsigned long) batch.size());
+
+  for (size_t i = next; i < batch.size(); ++i) {
+    batch[i]->selected_filesystems->clear();
+
+    if (retc) {
+      (*retc)[i] = ENOSPC;
+    }
+  }
+
+  return ENOSPC;
+}
+
 //------------------------------------------------------------------------------
 // File access method
 //------------------------------------------------------------------------------
 int Scheduler::FileAccess(AccessArguments* args)
 {
-  size_t nReqStripes = (args->isRW ?
-                        eos::common::LayoutId::GetOnlineStripeNumber(args->lid) :
-                        eos::common::LayoutId::GetMinOnlineReplica(args->lid));
+  const eos::common::LayoutDescriptor layout(args->lid);
+  size_t nReqStripes = (args->isRW ? layout.mOnlineStripes :
+                        layout.mMinOnlineReplica);
   eos_static_debug("requesting file access from geolocation %s",
                    args->vid->geolocation.c_str());
   GeoTreeEngine::SchedType st = GeoTreeEngine::regularRO;
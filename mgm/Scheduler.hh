@@ -73,6 +73,8 @@ public:
     unsigned long lid;
     //! file inode
     ino64_t inode;
+    //! container id of the parent directory, 0 if unknown
+    uint64_t parent_cid;
     //! indicates if placement should be local/spread/hybrid
     tPlctPolicy plctpolicy;
     //! indicates close to which Geotag collocated stripes should be placed
@@ -103,6 +105,7 @@ public:
       grouptag(0),
       lid(0),
       inode(0),
+      parent_cid(0),
       plctpolicy(kScattered),
       plctTrgGeotag(),
       truncate(false),
@@ -140,6 +143,26 @@ public:
   //----------------------------------------------------------------------------
   static int FilePlacement(PlacementArguments* args);
 
+  //----------------------------------------------------------------------------
+  //! Take the decision where to place a batch of new files e.g. bulk
+  //! transfers creating many files in the same directory. If all the
+  //! requests have the same layout, space, group tag, geotag, booking size
+  //! and identity and no filesystem to avoid, the group selection is done
+  //! once for the batch and each scheduling group places a chunk of files
+  //! on a single snapshot of its fast structures. Otherwise the requests are
+  //! placed one by one.
+  //!
+  //! @param batch placement requests
+  //! @param retc if not null, filled with the return code of each request
+  //!
+  //! @return 0 if all the placements are successful, otherwise the error of
+  //!         the first failed request whose selected_filesystems are empty
+  //!
+  //! NOTE: Has to be called with a lock on the FsView::gFsView::ViewMutex
+  //----------------------------------------------------------------------------
+  static int FilePlacement(const std::vector<PlacementArguments*>& batch,
+                           std::vector<int>* retc = nullptr);
+
   struct AccessArguments {
     /// INPUT
     //! forced filesystem for access
@@ -219,6 +242,20 @@ public:
   static int FileAccess(AccessArguments* args);
 
 protected:
+  //----------------------------------------------------------------------------
+  //! Get the number of collocated filesystems for the placement policy
+  //!
+  //! @param args placement arguments
+  //! @param nfilesystems number of filesystems to place
+  //----------------------------------------------------------------------------
+  static unsigned int GetCollocatedFs(const PlacementArguments* args,
+                                      unsigned int nfilesystems);
+
+  //----------------------------------------------------------------------------
+  //! Get the tag used to remember the last scheduling group i.e. the group
+  //! tag or <uid>:<gid>
+  //----------------------------------------------------------------------------
+  static std::string GetIndexTag(const PlacementArguments* args);
 
   static XrdSysMutex pMapMutex; //< protect the following scheduling state maps
 
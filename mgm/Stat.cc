@@ -24,6 +24,7 @@
 #include "common/Mapping.hh"
 #include "mgm/TableFormatter/TableFormatterBase.hh"
 #include "mgm/Stat.hh"
+#include "mgm/Access.hh"
 #include "mgm/FsView.hh"
 #include "mgm/XrdMgmOfs.hh"
 #include "mq/XrdMqSharedObject.hh"
@@ -32,6 +33,166 @@
 
 EOSMGMNAMESPACE_BEGIN
 
+constexpr uint32_t StatHisto::kSubBuckets;
+constexpr uint32_t StatHisto::kLinearMax;
+constexpr uint32_t StatHisto::kMaxExp;
+constexpr uint32_t StatHisto::kNumBuckets;
+constexpr uint32_t StatHisto::kNumSlots;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+StatHisto::StatHisto()
+{
+  Clear();
+}
+
+//------------------------------------------------------------------------------
+// Get the bucket index of the given value
+//------------------------------------------------------------------------------
+uint32_t
+StatHisto::GetBucket(uint64_t usec)
+{
+  if (usec < kLinearMax) {
+    return (uint32_t) usec;
+  }
+
+  uint32_t msb = 63 - __builtin_clzll(usec);
+
+  if (msb >= kMaxExp) {
+    return kNumBuckets - 1;
+  }
+
+  return kLinearMax + (msb - 4) * kSubBuckets +
+         ((usec >> (msb - 3)) & (kSubBuckets - 1));
+}
+
+//------------------------------------------------------------------------------
+// Get the value representing the given bucket
+//------------------------------------------------------------------------------
+double
+StatHisto::GetBucketValue(uint32_t bucket)
+{
+  if (bucket < kLinearMax) {
+    return bucket;
+  }
+
+  uint32_t msb = 4 + (bucket - kLinearMax) / kSubBuckets;
+  uint32_t sub = (bucket - kLinearMax) % kSubBuckets;
+  double width = (double)(1ull << (msb - 3));
+  return (kSubBuckets + sub) * width + width / 2;
+}
+
+//------------------------------------------------------------------------------
+// Get the slot for the given period
+//------------------------------------------------------------------------------
+StatHisto::Slot&
+StatHisto::GetSlot(Slot* ring, int64_t period)
+{
+  Slot& slot = ring[period % kNumSlots];
+  int64_t stamp = slot.mStamp.load(std::memory_order_acquire);
+
+  // Only the thread moving the stamp resets the counters, samples recorded
+  // concurrently by other threads during the reset might be lost
+  if ((stamp < period) &&
+      slot.mStamp.compare_exchange_strong(stamp, period)) {
+    for (uint32_t i = 0; i < kNumBuckets; ++i) {
+      slot.mCount[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  return slot;
+}
+
+//------------------------------------------------------------------------------
+// Record a sample
+//------------------------------------------------------------------------------
+void
+StatHisto::Record(uint64_t usec, time_t now)
+{
+  uint32_t bucket = GetBucket(usec);
+  GetSlot(mSeconds, now).mCount[bucket].fetch_add(1, std::memory_order_relaxed);
+  GetSlot(mMinutes, now / 60).mCount[bucket].fetch_add(1,
+      std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+// Get the percentiles of the samples recorded in the given window
+//------------------------------------------------------------------------------
+uint64_t
+StatHisto::GetPercentiles(uint32_t window, const std::vector<double>& quantiles,
+                          std::vector<double>& values, time_t now)
+{
+  // Short windows are served by the per second slots, the others by the per
+  // minute slots, including the current minute
+  bool use_seconds = (window <= kNumSlots);
+  const Slot* ring = (use_seconds ? mSeconds : mMinutes);
+  int64_t last = (use_seconds ? now : now / 60);
+  int64_t first = last - (use_seconds ? window : window / 60) + 1;
+  std::vector<uint64_t> merged(kNumBuckets, 0);
+  uint64_t total = 0;
+
+  for (uint32_t i = 0; i < kNumSlots; ++i) {
+    int64_t stamp = ring[i].mStamp.load(std::memory_order_acquire);
+
+    if ((stamp < first) || (stamp > last)) {
+      continue;
+    }
+
+    for (uint32_t j = 0; j < kNumBuckets; ++j) {
+      uint32_t cnt = ring[i].mCount[j].load(std::memory_order_relaxed);
+      merged[j] += cnt;
+      total += cnt;
+    }
+  }
+
+  values.assign(quantiles.size(), 0.0);
+
+  if (total == 0) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < quantiles.size(); ++i) {
+    // Rank of the sample holding the requested quantile, starting from 1
+    uint64_t rank = (uint64_t) ceil(quantiles[i] * total);
+    uint64_t seen = 0;
+
+    if (rank == 0) {
+      rank = 1;
+    }
+
+    for (uint32_t j = 0; j < kNumBuckets; ++j) {
+      seen += merged[j];
+
+      if (seen >= rank) {
+        values[i] = GetBucketValue(j);
+        break;
+      }
+    }
+  }
+
+  return total;
+}
+
+//------------------------------------------------------------------------------
+// Drop all the samples
+//------------------------------------------------------------------------------
+void
+StatHisto::Clear()
+{
+  Slot* rings[] = {mSeconds, mMinutes};
+
+  for (Slot* ring : rings) {
+    for (uint32_t i = 0; i < kNumSlots; ++i) {
+      ring[i].mStamp.store(-1, std::memory_order_relaxed);
+
+      for (uint32_t j = 0; j < kNumBuckets; ++j) {
+        ring[i].mCount[j].store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 void
 Stat::Add(const char* tag, uid_t uid, gid_t gid, unsigned long val)
@@ -41,6 +202,16 @@ Stat::Add(const char* tag, uid_t uid, gid_t gid, unsigned long val)
   StatsGid[tag][gid] += val;
   StatAvgUid[tag][uid].Add(val);
   StatAvgGid[tag][gid].Add(val);
+  eos::common::MetricCounter*& counter = mOpsMetrics[tag];
+
+  if (!counter) {
+    counter = &eos::common::MetricsRegistry::Instance().GetCounter(
+                "eos_mgm_ops_total", "MGM operations by tag", {{"op", tag}});
+  }
+
+  lock.UnLock();
+  counter->Inc(val);
+  Access::gRateLimiter.Consume(tag, uid, gid, val);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -57,13 +228,36 @@ Stat::AddExt(const char* tag, uid_t uid, gid_t gid, unsigned long nsample,
 void
 Stat::AddExec(const char* tag, float exectime)
 {
-  XrdSysMutexHelper lock(mMutex);
-  StatExec[tag].push_back(exectime);
+  StatHisto* histo = nullptr;
+  eos::common::MetricHistogram* metric = nullptr;
+  {
+    XrdSysMutexHelper lock(mMutex);
+    StatExec[tag].push_back(exectime);
+
+    // we average over 100 entries
+    if (StatExec[tag].size() > 100) {
+      StatExec[tag].pop_front();
+    }
+
+    std::unique_ptr<StatHisto>& entry = StatHistoExec[tag];
 
-  // we average over 100 entries
-  if (StatExec[tag].size() > 100) {
-    StatExec[tag].pop_front();
+    if (!entry) {
+      entry.reset(new StatHisto());
+    }
+
+    histo = entry.get();
+    metric = mExecMetrics[tag];
+
+    if (!metric) {
+      metric = &eos::common::MetricsRegistry::Instance().GetHistogram(
+                 "eos_mgm_exec_duration_seconds", "MGM execution time by tag",
+                 eos::common::MetricHistogram::LatencyBounds(), {{"op", tag}});
+      mExecMetrics[tag] = metric;
+    }
   }
+  // The histogram counters are atomic, record outside the lock
+  histo->Record((exectime > 0) ? (uint64_t)(exectime * 1000.0) : 0);
+  metric->Observe((exectime > 0) ? exectime / 1000.0 : 0);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -604,6 +798,30 @@ Stat::GetTotalExec(double& deviation)
   return avg;
 }
 
+//------------------------------------------------------------------------------
+// Get the execution time percentiles of a tag in milliseconds
+//------------------------------------------------------------------------------
+uint64_t
+Stat::GetExecPercentiles(const char* tag, uint32_t window,
+                         const std::vector<double>& quantiles,
+                         std::vector<double>& values)
+{
+  auto it = StatHistoExec.find(tag);
+
+  if (it == StatHistoExec.end()) {
+    values.assign(quantiles.size(), 0.0);
+    return 0;
+  }
+
+  uint64_t samples = it->second->GetPercentiles(window, quantiles, values);
+
+  for (auto& val : values) {
+    val /= 1000.0;
+  }
+
+  return samples;
+}
+
 /*----------------------------------------------------------------------------*/
 void
 Stat::Clear()
@@ -622,6 +840,10 @@ Stat::Clear()
     StatExec[ittag->first].clear();
     StatExec[ittag->first].resize(1000);
   }
+
+  for (auto& elem : StatHistoExec) {
+    elem.second->Clear();
+  }
 }
 
 /*----------------------------------------------------------------------------*/
@@ -821,6 +1043,79 @@ Stat::PrintOutTotal(XrdOucString& out, bool details, bool monitoring,
   }
 
   out += table_all.GenerateTable(HEADER).c_str();
+  // Execution time percentiles per tag and window
+  TableFormatterBase table_lat;
+
+  if (!monitoring) {
+    table_lat.SetHeader({
+      std::make_tuple("who", 3, format_ss),
+      std::make_tuple("command", 24, format_cmd),
+      std::make_tuple("window", 6, format_s),
+      std::make_tuple("samples", 8, format_l),
+      std::make_tuple("p50(ms)", 8, format_f),
+      std::make_tuple("p90(ms)", 8, format_f),
+      std::make_tuple("p99(ms)", 8, format_f),
+      std::make_tuple("p999(ms)", 8, format_f)
+    });
+  } else {
+    table_lat.SetHeader({
+      std::make_tuple("uid", 0, format_ss),
+      std::make_tuple("gid", 0, format_s),
+      std::make_tuple("cmd", 0, format_s),
+      std::make_tuple("window", 0, format_l),
+      std::make_tuple("samples", 0, format_l),
+      std::make_tuple("p50", 0, format_f),
+      std::make_tuple("p90", 0, format_f),
+      std::make_tuple("p99", 0, format_f),
+      std::make_tuple("p999", 0, format_f)
+    });
+  }
+
+  const std::vector<double> quantiles {0.5, 0.9, 0.99, 0.999};
+  const std::vector<std::pair<uint32_t, std::string>> windows {
+    {5, "5s"}, {60, "1min"}, {300, "5min"}, {3600, "1h"}
+  };
+  bool has_lat = false;
+
+  for (const auto& elem : StatHistoExec) {
+    for (const auto& window : windows) {
+      std::vector<double> values;
+      uint64_t samples = GetExecPercentiles(elem.first.c_str(), window.first,
+                                            quantiles, values);
+
+      if (!samples) {
+        continue;
+      }
+
+      TableData table_data;
+      table_data.emplace_back();
+      table_data.back().push_back(TableCell("all", format_ss));
+
+      if (monitoring) {
+        table_data.back().push_back(TableCell("all", format_s));
+        table_data.back().push_back(TableCell(elem.first, format_s));
+        table_data.back().push_back(TableCell((unsigned long long) window.first,
+                                              format_l));
+      } else {
+        table_data.back().push_back(TableCell(elem.first, format_cmd));
+        table_data.back().push_back(TableCell(window.second, format_s));
+      }
+
+      table_data.back().push_back(TableCell((unsigned long long) samples,
+                                            format_l));
+
+      for (auto val : values) {
+        table_data.back().push_back(TableCell(val, format_f));
+      }
+
+      table_lat.AddRows(table_data);
+      has_lat = true;
+    }
+  }
+
+  if (has_lat) {
+    out += table_lat.GenerateTable(HEADER).c_str();
+  }
 
   if (details) {
     google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, StatAvg > >::iterator
@@ -26,6 +26,7 @@
 
 /*----------------------------------------------------------------------------*/
 #include "mgm/Namespace.hh"
+#include "common/Metrics.hh"
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucString.hh"
 /*----------------------------------------------------------------------------*/
@@ -35,6 +36,9 @@
 #include <map>
 #include <string>
 #include <deque>
+#include <atomic>
+#include <memory>
+#include <ctime>
 #include <math.h>
 
 EOSMGMNAMESPACE_BEGIN
@@ -484,6 +488,90 @@ public:
 };
 
 
+//------------------------------------------------------------------------------
+//! Class StatHisto - log-linear latency histogram over the last 5s, 60s, 300s
+//! and 3600s. Values below 16 us have their own bucket, larger values are
+//! grouped per power of two in 8 linear sub-buckets, which bounds the relative
+//! error of the reported percentiles to 1/8. Samples are recorded in per
+//! second slots, covering the last minute, and per minute slots, covering the
+//! last hour. Counters are atomic so that recording does not need any lock,
+//! the slots of a window are merged when a percentile is requested.
+//------------------------------------------------------------------------------
+class StatHisto
+{
+public:
+  //! Number of sub-buckets per power of two
+  static constexpr uint32_t kSubBuckets = 8;
+  //! Values below this threshold (in us) have their own bucket
+  static constexpr uint32_t kLinearMax = 16;
+  //! Largest tracked power of two, larger values go in the last bucket
+  static constexpr uint32_t kMaxExp = 36;
+  //! Total number of buckets
+  static constexpr uint32_t kNumBuckets = kLinearMax + (kMaxExp - 4) *
+                                          kSubBuckets;
+  //! Number of slots per ring
+  static constexpr uint32_t kNumSlots = 60;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  StatHisto();
+
+  //----------------------------------------------------------------------------
+  //! Record a sample
+  //!
+  //! @param usec value in microseconds
+  //! @param now current time
+  //----------------------------------------------------------------------------
+  void Record(uint64_t usec, time_t now = time(0));
+
+  //----------------------------------------------------------------------------
+  //! Get the percentiles of the samples recorded in the given window
+  //!
+  //! @param window window length in seconds, one of 5, 60, 300 or 3600
+  //! @param quantiles requested quantiles in [0, 1]
+  //! @param values output values in microseconds, same order as quantiles
+  //! @param now current time
+  //!
+  //! @return number of samples in the window
+  //----------------------------------------------------------------------------
+  uint64_t GetPercentiles(uint32_t window, const std::vector<double>& quantiles,
+                          std::vector<double>& values, time_t now = time(0));
+
+  //----------------------------------------------------------------------------
+  //! Drop all the samples
+  //----------------------------------------------------------------------------
+  void Clear();
+
+  //----------------------------------------------------------------------------
+  //! Get the bucket index of the given value
+  //----------------------------------------------------------------------------
+  static uint32_t GetBucket(uint64_t usec);
+
+  //----------------------------------------------------------------------------
+  //! Get the value representing the given bucket i.e. its middle
+  //----------------------------------------------------------------------------
+  static double GetBucketValue(uint32_t bucket);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Samples recorded during one period (second or minute)
+  //----------------------------------------------------------------------------
+  struct Slot {
+    std::atomic<int64_t> mStamp; ///< Period the counters belong to
+    std::atomic<uint32_t> mCount[kNumBuckets]; ///< Samples per bucket
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the slot for the given period, reset it if it holds an older one
+  //----------------------------------------------------------------------------
+  static Slot& GetSlot(Slot* ring, int64_t period);
+
+  Slot mSeconds[kNumSlots]; ///< Per second slots
+  Slot mMinutes[kNumSlots]; ///< Per minute slots
+};
+
+
 #define EXEC_TIMING_BEGIN(__ID__)               \
   struct timeval start__ID__;                   \
   struct timeval stop__ID__;                    \
@@ -513,6 +601,12 @@ public:
   google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, StatExt> >
   StatExtGid;
   google::sparse_hash_map<std::string, std::deque<float> > StatExec;
+  //! Latency histograms per tag, never erased so that they can be updated
+  //! without holding the mutex
+  std::map<std::string, std::unique_ptr<StatHisto>> StatHistoExec;
+  //! Metrics registry series per tag, cached to register them only once
+  std::map<std::string, eos::common::MetricCounter*> mOpsMetrics;
+  std::map<std::string, eos::common::MetricHistogram*> mExecMetrics;
 
   void Add(const char* tag, uid_t uid, gid_t gid, unsigned long val);
 
@@ -557,6 +651,21 @@ public:
   // warning: you have to lock the mutex if directly used
   double GetTotalExec(double& deviation);
 
+  //----------------------------------------------------------------------------
+  //! Get the execution time percentiles of a tag in milliseconds, warning:
+  //! you have to lock the mutex if directly used
+  //!
+  //! @param tag tag name
+  //! @param window window length in seconds, one of 5, 60, 300 or 3600
+  //! @param quantiles requested quantiles in [0, 1]
+  //! @param values output values in milliseconds
+  //!
+  //! @return number of samples in the window
+  //----------------------------------------------------------------------------
+  uint64_t GetExecPercentiles(const char* tag, uint32_t window,
+                              const std::vector<double>& quantiles,
+                              std::vector<double>& values);
+
   void Clear();
 
   void PrintOutTotal(XrdOucString& out, bool details = false,
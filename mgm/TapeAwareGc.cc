@@ -25,26 +25,45 @@
 #include "mgm/proc/admin/StagerRmCmd.hh"
 #include "mgm/TapeAwareGc.hh"
 #include "mgm/XrdMgmOfs.hh"
+#include "mgm/Quota.hh"
 #include "namespace/interface/IFileMDSvc.hh"
+#include "namespace/ns_quarkdb/BackendClient.hh"
+#include "namespace/ns_quarkdb/explorer/ParallelNamespaceExplorer.hh"
 #include "namespace/Prefetcher.hh"
 
+#include <algorithm>
 #include <functional>
 #include <ios>
 #include <sstream>
 #include <time.h>
+#include <tuple>
+#include <vector>
 
 EOSMGMNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+// SpaceGc constructor
+//------------------------------------------------------------------------------
+TapeAwareGc::SpaceGc::SpaceGc(const std::string &spaceName):
+  name(spaceName),
+  cachedMinFreeBytes(
+    0, // Initial value
+    [spaceName]{return TapeAwareGc::getSpaceConfigMinNbFreeBytes(spaceName);},
+    10), // Maximum age of cached value in seconds
+  nbGarbageCollectedFiles(0),
+  nbGarbageCollectedBytes(0),
+  lastPublishTime(time(nullptr)),
+  lastPublishNbFiles(0)
+{
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 TapeAwareGc::TapeAwareGc():
   m_enabled(false),
-  m_cachedDefaultSpaceMinFreeBytes(
-    0, // Initial value
-    TapeAwareGc::getDefaultSpaceMinNbFreeBytes, // Value getter
-    10), // Maximum age of cached value in seconds
-  m_nbGarbageCollectedFiles(0)
+  m_fsidToSpace(std::make_shared<FsidToSpace>()),
+  m_fsidToSpaceTimestamp(0)
 {
 }
 
@@ -54,10 +73,16 @@ TapeAwareGc::TapeAwareGc():
 TapeAwareGc::~TapeAwareGc()
 {
   try {
-    // m_enabled is an std::atomic and is set within enable() after m_worker
-    if(m_enabled && m_worker) {
+    // m_enabled is an std::atomic and is set within enable() after m_spaces
+    // has been filled
+    if(m_enabled) {
       m_stop.setToTrue();
-      m_worker->join();
+
+      for(auto &space: m_spaces) {
+        if(space.second->worker) space.second->worker->join();
+      }
+
+      if(m_lruRebuilder) m_lruRebuilder->join();
     }
   } catch(std::exception &ex) {
     eos_static_err("msg=\"%s\"", ex.what());
@@ -70,16 +95,30 @@ TapeAwareGc::~TapeAwareGc()
 // Enable the GC
 //------------------------------------------------------------------------------
 void
-TapeAwareGc::enable() noexcept
+TapeAwareGc::enable(const std::set<std::string> &spaces) noexcept
 {
   try {
     // Do nothing if the calling thread is not the first to call start()
     if (m_enabledMethodCalled.test_and_set()) return;
 
+    if (spaces.empty()) return;
+
+    for(const auto &name: spaces) {
+      m_spaces[name].reset(new SpaceGc(name));
+    }
+
     m_enabled = true;
 
-    std::function<void()> entryPoint = std::bind(&TapeAwareGc::workerThreadEntryPoint, this);
-    m_worker.reset(new std::thread(entryPoint));
+    for(auto &space: m_spaces) {
+      SpaceGc &spaceGc = *space.second;
+      std::function<void()> entryPoint =
+        std::bind(&TapeAwareGc::workerThreadEntryPoint, this, std::ref(spaceGc));
+      spaceGc.worker.reset(new std::thread(entryPoint));
+    }
+
+    std::function<void()> rebuilderEntryPoint =
+      std::bind(&TapeAwareGc::lruRebuilderThreadEntryPoint, this);
+    m_lruRebuilder.reset(new std::thread(rebuilderEntryPoint));
   } catch(std::exception &ex) {
     eos_static_err("msg=\"%s\"", ex.what());
   } catch(...) {
@@ -88,23 +127,115 @@ TapeAwareGc::enable() noexcept
 }
 
 //------------------------------------------------------------------------------
-// Entry point for the GC worker thread
+// Entry point for the GC worker thread of a space
 //------------------------------------------------------------------------------
 void
-TapeAwareGc::workerThreadEntryPoint() noexcept
+TapeAwareGc::workerThreadEntryPoint(SpaceGc &space) noexcept
 {
   try {
-    eos_static_info("msg=\"TapeAwareGc worker thread started\"");
+    eos_static_info("msg=\"TapeAwareGc worker thread started\" space=\"%s\"",
+      space.name.c_str());
   } catch(...) {
   }
 
   do {
-    while(!m_stop && tryToGarbageCollectASingleFile()) {
-      m_nbGarbageCollectedFiles++;
-    };
+    refreshFsidToSpace();
+
+    while(!m_stop && tryToGarbageCollectABatchOfFiles(space)) {
+      publishMetrics(space);
+    }
+
+    publishMetrics(space);
   } while(!m_stop.waitForTrue(std::chrono::seconds(10)));
 }
 
+//------------------------------------------------------------------------------
+// Entry point for the thread rebuilding the LRU queues from QuarkDB
+//------------------------------------------------------------------------------
+void
+TapeAwareGc::lruRebuilderThreadEntryPoint() noexcept
+{
+  try {
+    // The queues can only be rebuilt by scanning a QuarkDB namespace
+    while(!gOFS->IsNsBooted()) {
+      if(m_stop.waitForTrue(std::chrono::seconds(5))) return;
+    }
+
+    if(!gOFS->NsInQDB || gOFS->mQdbCluster.empty()) return;
+
+    eos_static_info("msg=\"TapeAwareGc rebuilding LRU queues from the "
+      "namespace\"");
+    refreshFsidToSpace(true);
+
+    // (mtime, fid) of the files with a tape copy, per space
+    typedef std::pair<time_t, IFileMD::id_t> MtimeAndFid;
+    std::map<SpaceGc*, std::vector<MtimeAndFid>> discovered;
+    const time_t startTime = time(nullptr);
+    uint64_t nbScannedFiles = 0;
+    {
+      ParallelExplorationOptions options;
+      options.view = gOFS->eosView;
+      options.threads = 16;
+      qclient::QClient *qcl =
+        eos::BackendClient::getInstance(gOFS->mQdbContactDetails, "tape-gc");
+      ParallelNamespaceExplorer explorer("/", options, *qcl);
+      std::vector<NamespaceItem> chunk;
+
+      while(!m_stop && explorer.fetch(chunk)) {
+        for(const auto &item: chunk) {
+          if(!item.isFile) continue;
+
+          nbScannedFiles++;
+          const auto &md = item.fileMd;
+
+          if(0 == md.locations_size()) continue;
+          if(md.xattrs().end() == md.xattrs().find("CTA_ArchiveFileId")) {
+            continue;
+          }
+
+          SpaceGc *const space = getSpaceOfFsid(md.locations(0));
+          if(nullptr == space) continue;
+
+          IFileMD::ctime_t mtime{};
+          (void)memcpy(&mtime, md.mtime().data(),
+            std::min(md.mtime().size(), sizeof(mtime)));
+          discovered[space].emplace_back(mtime.tv_sec, md.id());
+        }
+      }
+    }
+
+    if(m_stop) return;
+
+    for(auto &spaceAndFiles: discovered) {
+      SpaceGc &space = *spaceAndFiles.first;
+      auto &files = spaceAndFiles.second;
+
+      // The queue is filled from its most recently used end
+      std::sort(files.begin(), files.end(), std::greater<MtimeAndFid>());
+
+      std::lock_guard<std::mutex> lruQueueLock(space.lruQueueMutex);
+      for(const auto &file: files) {
+        space.lruQueue.oldFileDiscovered(file.second);
+      }
+
+      std::ostringstream msg;
+      msg << "msg=\"TapeAwareGc rebuilt LRU queue\" space=\"" << space.name
+        << "\" nbFiles=" << files.size() << " queueSize="
+        << space.lruQueue.size();
+      eos_static_info(msg.str().c_str());
+    }
+
+    std::ostringstream msg;
+    msg << "msg=\"TapeAwareGc finished rebuilding LRU queues\" nbScannedFiles="
+      << nbScannedFiles << " durationSecs=" << (time(nullptr) - startTime);
+    eos_static_info(msg.str().c_str());
+  } catch(std::exception &ex) {
+    eos_static_err("msg=\"%s\"", ex.what());
+  } catch(...) {
+    eos_static_err("msg=\"Caught an unknown exception\"");
+  }
+}
+
 //------------------------------------------------------------------------------
 // Notify GC the specified file has been opened
 //------------------------------------------------------------------------------
@@ -119,19 +250,7 @@ TapeAwareGc::fileOpened(const std::string &path, const IFileMD &fmd) noexcept
     // tape storage
     if(!fmd.hasAttribute("CTA_ArchiveFileId")) return;
 
-    const auto fid = fmd.getId();
-    const std::string preamble = createLogPreamble(path, fid);
-    eos_static_info(preamble.c_str());
-
-    std::lock_guard<std::mutex> lruQueueLock(m_lruQueueMutex);
-    const bool exceededBefore = m_lruQueue.maxQueueSizeExceeded();
-    m_lruQueue.fileAccessed(fid);
-
-    // Only log crossing the max queue size threshold - don't log each access
-    if(!exceededBefore && m_lruQueue.maxQueueSizeExceeded()) {
-      eos_static_warning("%s msg=\"Tape aware max queue size has been passed - "
-        "new files will be ignored\"", preamble.c_str());
-    }
+    fileAccessed(createLogPreamble(path, fmd.getId()), fmd);
   } catch(std::exception &ex) {
     eos_static_err("msg=\"%s\"", ex.what());
   } catch(...) {
@@ -148,19 +267,7 @@ TapeAwareGc::fileReplicaCommitted(const std::string &path, const IFileMD &fmd) n
   if(!m_enabled) return;
 
   try {
-    const auto fid = fmd.getId();
-    const std::string preamble = createLogPreamble(path, fid);
-    eos_static_info(preamble.c_str());
-
-    std::lock_guard<std::mutex> lruQueueLock(m_lruQueueMutex);
-    const bool exceededBefore = m_lruQueue.maxQueueSizeExceeded();
-    m_lruQueue.fileAccessed(fid);
-
-    // Only log crossing the max queue size threshold - don't log each access
-    if(!exceededBefore && m_lruQueue.maxQueueSizeExceeded()) {
-      eos_static_warning("%s msg=\"Tape aware max queue size has been passed - "
-        "new files will be ignored\"", preamble.c_str());
-    }
+    fileAccessed(createLogPreamble(path, fmd.getId()), fmd);
   } catch(std::exception &ex) {
     eos_static_err("msg=\"%s\"", ex.what());
   } catch(...) {
@@ -169,18 +276,85 @@ TapeAwareGc::fileReplicaCommitted(const std::string &path, const IFileMD &fmd) n
 }
 
 //------------------------------------------------------------------------------
-// Return the minimum number of free bytes the default space should have
-// as set in the configuration variables of the space.  If the minimum
-// number of free bytes cannot be determined for whatever reason then 0 is
-// returned.
+// Notify the LRU queue of the space of a file that the file was accessed
 //------------------------------------------------------------------------------
-uint64_t
-TapeAwareGc::getDefaultSpaceMinNbFreeBytes() noexcept
+void
+TapeAwareGc::fileAccessed(const std::string &preamble, const IFileMD &fmd)
+{
+  eos_static_info(preamble.c_str());
+
+  SpaceGc *space = nullptr;
+  if(1 == m_spaces.size()) {
+    space = m_spaces.begin()->second.get();
+  } else {
+    const auto locations = fmd.getLocations();
+    if(!locations.empty()) space = getSpaceOfFsid(locations.front());
+  }
+
+  if(nullptr == space) return;
+
+  std::lock_guard<std::mutex> lruQueueLock(space->lruQueueMutex);
+  const bool exceededBefore = space->lruQueue.maxQueueSizeExceeded();
+  space->lruQueue.fileAccessed(fmd.getId());
+
+  // Only log crossing the max queue size threshold - don't log each access
+  if(!exceededBefore && space->lruQueue.maxQueueSizeExceeded()) {
+    eos_static_warning("%s space=\"%s\" msg=\"Tape aware max queue size has "
+      "been passed - new files will be ignored\"", preamble.c_str(),
+      space->name.c_str());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Return the managed space the specified file system belongs to
+//------------------------------------------------------------------------------
+TapeAwareGc::SpaceGc *
+TapeAwareGc::getSpaceOfFsid(const uint32_t fsid)
+{
+  std::shared_ptr<const FsidToSpace> fsidToSpace;
+  {
+    std::lock_guard<std::mutex> lock(m_fsidToSpaceMutex);
+    fsidToSpace = m_fsidToSpace;
+  }
+
+  const auto itor = fsidToSpace->find(fsid);
+  return fsidToSpace->end() == itor ? nullptr : itor->second;
+}
+
+//------------------------------------------------------------------------------
+// Rebuild the map from file system identifier to managed space if too old
+//------------------------------------------------------------------------------
+void
+TapeAwareGc::refreshFsidToSpace(const bool force)
 {
   try {
-    return getSpaceConfigMinNbFreeBytes("default");
+    const time_t now = time(nullptr);
+    if(!force && now - m_fsidToSpaceTimestamp < s_fsidToSpaceMaxAgeSecs) return;
+    m_fsidToSpaceTimestamp = now;
+
+    std::shared_ptr<FsidToSpace> fsidToSpace = std::make_shared<FsidToSpace>();
+    {
+      eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+
+      for(const auto &idAndFs: FsView::gFsView.mIdView) {
+        if(nullptr == idAndFs.second) continue;
+
+        std::string spaceName = idAndFs.second->GetString("schedgroup");
+        spaceName = spaceName.substr(0, spaceName.find('.'));
+        const auto spaceItor = m_spaces.find(spaceName);
+
+        if(m_spaces.end() != spaceItor) {
+          (*fsidToSpace)[idAndFs.first] = spaceItor->second.get();
+        }
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(m_fsidToSpaceMutex);
+    m_fsidToSpace = fsidToSpace;
+  } catch(std::exception &ex) {
+    eos_static_err("msg=\"%s\"", ex.what());
   } catch(...) {
-    return 0;
+    eos_static_err("msg=\"Caught an unknown exception\"");
   }
 }
 
@@ -251,77 +425,76 @@ TapeAwareGc::getSpaceNbFreeBytes(const std::string &name)
 }
 
 //------------------------------------------------------------------------------
-// Try to garage collect a single file if necessary and possible
+// Try to garbage collect a batch of files if necessary and possible
 //------------------------------------------------------------------------------
 bool
-TapeAwareGc::tryToGarbageCollectASingleFile() noexcept
+TapeAwareGc::tryToGarbageCollectABatchOfFiles(SpaceGc &space) noexcept
 {
   try {
-    bool defaultSpaceMinFreeBytesHasChanged = false;
-    const auto defaultSpaceMinFreeBytes =
-      m_cachedDefaultSpaceMinFreeBytes.get(defaultSpaceMinFreeBytesHasChanged);
-    if(defaultSpaceMinFreeBytesHasChanged) {
+    bool minFreeBytesHasChanged = false;
+    const auto minFreeBytes = space.cachedMinFreeBytes.get(minFreeBytesHasChanged);
+    if(minFreeBytesHasChanged) {
       std::ostringstream msg;
-      msg << "msg=\"defaultSpaceMinFreeBytes has been changed to " << defaultSpaceMinFreeBytes << "\"";
+      msg << "msg=\"minFreeBytes has been changed to " << minFreeBytes
+        << "\" space=\"" << space.name << "\"";
       eos_static_info(msg.str().c_str());
     }
 
+    uint64_t nbFreeBytes = 0;
     try {
-      // Return no file was garbage collected if there is still enough free space
-      const auto actualDefaultSpaceNbFreeBytes = getSpaceNbFreeBytes("default");
-      if(actualDefaultSpaceNbFreeBytes >= defaultSpaceMinFreeBytes) return false;
-    } catch(SpaceNotFound) {
+      nbFreeBytes = getSpaceNbFreeBytes(space.name);
+    } catch(SpaceNotFound&) {
       // Return no file was garbage collected if the space was not found
       return false;
     }
 
-    IFileMD::id_t fid;
-
-    {
-      std::lock_guard<std::mutex> lruQueueLock(m_lruQueueMutex);
-      if (m_lruQueue.empty()) return false; // No file was garbage collected
-      fid = m_lruQueue.getAndPopFidOfLeastUsedFile();
+    // The statistics of the file systems are only updated periodically, count
+    // the bytes freed recently as free to avoid evicting them twice
+    const time_t now = time(nullptr);
+    while(!space.recentlyFreedBytes.empty() &&
+      now - space.recentlyFreedBytes.front().first > s_freedBytesLagSecs) {
+      space.recentlyFreedBytes.pop_front();
+    }
+    for(const auto &timeAndBytes: space.recentlyFreedBytes) {
+      nbFreeBytes += timeAndBytes.second;
     }
 
-    const auto result = stagerrmAsRoot(fid);
+    // Return no file was garbage collected if there is still enough free space
+    if(nbFreeBytes >= minFreeBytes) return false;
 
-    std::ostringstream preamble;
-    preamble << "fxid=" << std::hex << fid;
+    const uint64_t nbBytesToFree = minFreeBytes - nbFreeBytes;
+    uint64_t nbFreedBytes = 0;
+    uint64_t nbFreedFiles = 0;
+
+    for(size_t i = 0; i < s_maxBatchSize && nbFreedBytes < nbBytesToFree &&
+      !m_stop; i++) {
+      IFileMD::id_t fid;
 
-    if(0 == result.retc()) {
-      std::ostringstream msg;
-      msg << preamble.str() << " msg=\"Garbage collected file using stagerrm\"";
-      eos_static_info(msg.str().c_str());
-      return true; // A file was garbage collected
-    } else {
       {
-        std::ostringstream msg;
-        msg << preamble.str() << " msg=\"Unable to stagerrm file at this time: "
-          << result.std_err() << "\"";
-        eos_static_info(msg.str().c_str());
+        std::lock_guard<std::mutex> lruQueueLock(space.lruQueueMutex);
+        if (space.lruQueue.empty()) break;
+        fid = space.lruQueue.getAndPopFidOfLeastUsedFile();
       }
 
-      // Prefetch before taking lock because metadata may not be in memory
-      Prefetcher::prefetchFileMDAndWait(gOFS->eosView, fid);
-      common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
-      const auto fmd = gOFS->eosFileService->getFileMD(fid);
-
-      if(nullptr != fmd && 0 != fmd->getContainerId()) {
-        std::ostringstream msg;
-        msg << preamble.str() << " msg=\"Putting file back in GC queue"
-          " because it is still in the namespace\"";
-        eos_static_info(msg.str().c_str());
-
-        std::lock_guard<std::mutex> lruQueueLock(m_lruQueueMutex);
-        m_lruQueue.fileAccessed(fid);
-      } else {
-        std::ostringstream msg;
-        msg << preamble.str() << " msg=\"Not returning file to GC queue"
-          " because it is not in the namespace\"";
-        eos_static_info(msg.str().c_str());
+      uint64_t fileFreedBytes = 0;
+      if(garbageCollectFile(space, fid, fileFreedBytes)) {
+        nbFreedFiles++;
+        nbFreedBytes += fileFreedBytes;
       }
     }
 
+    if(0 == nbFreedFiles) return false;
+
+    space.recentlyFreedBytes.emplace_back(now, nbFreedBytes);
+    space.nbGarbageCollectedFiles += nbFreedFiles;
+    space.nbGarbageCollectedBytes += nbFreedBytes;
+
+    std::ostringstream msg;
+    msg << "msg=\"Garbage collected a batch of files\" space=\"" << space.name
+      << "\" nbFiles=" << nbFreedFiles << " nbBytes=" << nbFreedBytes
+      << " nbBytesToFree=" << nbBytesToFree;
+    eos_static_info(msg.str().c_str());
+    return true; // At least one file was garbage collected
   } catch(std::exception &ex) {
     eos_static_err("msg=\"%s\"", ex.what());
   } catch(...) {
@@ -331,6 +504,112 @@ TapeAwareGc::tryToGarbageCollectASingleFile() noexcept
   return false; // No file was garbage collected
 }
 
+//------------------------------------------------------------------------------
+// Garbage collect a single file
+//------------------------------------------------------------------------------
+bool
+TapeAwareGc::garbageCollectFile(SpaceGc &space, const IFileMD::id_t fid,
+  uint64_t &freedBytes)
+{
+  std::ostringstream preamble;
+  preamble << "fxid=" << std::hex << fid << std::dec << " space=\""
+    << space.name << "\"";
+
+  // Prefetch before taking lock because metadata may not be in memory
+  Prefetcher::prefetchFileMDAndWait(gOFS->eosView, fid);
+  {
+    common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+    const auto fmd = gOFS->eosFileService->getFileMD(fid);
+
+    // Nothing to free if the file has no disk replica
+    if(nullptr == fmd || 0 == fmd->getNumLocation()) return false;
+
+    freedBytes = Quota::MapSizeCB(fmd.get());
+  }
+
+  const auto result = stagerrmAsRoot(fid);
+
+  if(0 == result.retc()) {
+    std::ostringstream msg;
+    msg << preamble.str() << " msg=\"Garbage collected file using stagerrm\"";
+    eos_static_info(msg.str().c_str());
+    return true; // The file was garbage collected
+  }
+
+  {
+    std::ostringstream msg;
+    msg << preamble.str() << " msg=\"Unable to stagerrm file at this time: "
+      << result.std_err() << "\"";
+    eos_static_info(msg.str().c_str());
+  }
+
+  Prefetcher::prefetchFileMDAndWait(gOFS->eosView, fid);
+  common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+  const auto fmd = gOFS->eosFileService->getFileMD(fid);
+
+  if(nullptr != fmd && 0 != fmd->getContainerId()) {
+    std::ostringstream msg;
+    msg << preamble.str() << " msg=\"Putting file back in GC queue"
+      " because it is still in the namespace\"";
+    eos_static_info(msg.str().c_str());
+
+    std::lock_guard<std::mutex> lruQueueLock(space.lruQueueMutex);
+    space.lruQueue.fileAccessed(fid);
+  } else {
+    std::ostringstream msg;
+    msg << preamble.str() << " msg=\"Not returning file to GC queue"
+      " because it is not in the namespace\"";
+    eos_static_info(msg.str().c_str());
+  }
+
+  return false; // The file was not garbage collected
+}
+
+//------------------------------------------------------------------------------
+// Publish the queue size and eviction metrics of a space
+//------------------------------------------------------------------------------
+void
+TapeAwareGc::publishMetrics(SpaceGc &space) noexcept
+{
+  try {
+    uint64_t queueSize = 0;
+    {
+      std::lock_guard<std::mutex> lruQueueLock(space.lruQueueMutex);
+      queueSize = space.lruQueue.size();
+    }
+
+    const time_t now = time(nullptr);
+    const uint64_t nbFiles = space.nbGarbageCollectedFiles;
+    const uint64_t nbBytes = space.nbGarbageCollectedBytes;
+    const time_t elapsed = now - space.lastPublishTime;
+    const double rate = 0 < elapsed ?
+      (double)(nbFiles - space.lastPublishNbFiles) / elapsed : 0.0;
+    space.lastPublishTime = now;
+    space.lastPublishNbFiles = nbFiles;
+
+    eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+    const auto spaceItor = FsView::gFsView.mSpaceView.find(space.name);
+    if(FsView::gFsView.mSpaceView.end() == spaceItor) return;
+    if(nullptr == spaceItor->second) return;
+    auto &fsSpace = *(spaceItor->second);
+
+    char rateStr[32];
+    snprintf(rateStr, sizeof(rateStr), "%.02f", rate);
+    fsSpace.SetConfigMember("stat.tapeawaregc.queuesize",
+      std::to_string(queueSize), true, "/eos/*/mgm", true);
+    fsSpace.SetConfigMember("stat.tapeawaregc.evictedfiles",
+      std::to_string(nbFiles), true, "/eos/*/mgm", true);
+    fsSpace.SetConfigMember("stat.tapeawaregc.evictedbytes",
+      std::to_string(nbBytes), true, "/eos/*/mgm", true);
+    fsSpace.SetConfigMember("stat.tapeawaregc.rate", rateStr, true,
+      "/eos/*/mgm", true);
+  } catch(std::exception &ex) {
+    eos_static_err("msg=\"%s\"", ex.what());
+  } catch(...) {
+    eos_static_err("msg=\"Caught an unknown exception\"");
+  }
+}
+
 //----------------------------------------------------------------------------
 // Execute stagerrm as user root
 //----------------------------------------------------------------------------
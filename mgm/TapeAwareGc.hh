@@ -33,10 +33,15 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <stdexcept>
 #include <stdint.h>
 #include <thread>
+#include <unordered_map>
 
 /*----------------------------------------------------------------------------*/
 /**
@@ -50,6 +55,14 @@ EOSMGMNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
 //! A tape aware garbage collector
+//!
+//! Every managed EOS space has its own LRU queue of the files with a tape
+//! copy and its own worker thread.  A file is queued in the space of its first
+//! replica.  When the number of free bytes of a space goes below the
+//! tapeawaregc.minfreebytes space variable, the worker evicts the disk
+//! replicas of the least used files, as many as needed to go back above the
+//! threshold.  With a QuarkDB namespace the queues are rebuilt at startup by a
+//! parallel scan of the namespace, ordered by modification time.
 //------------------------------------------------------------------------------
 class TapeAwareGc
 {
@@ -76,8 +89,10 @@ public:
 
   //----------------------------------------------------------------------------
   //! Enable the GC
+  //!
+  //! @param spaces names of the EOS spaces to garbage collect
   //----------------------------------------------------------------------------
-  void enable() noexcept;
+  void enable(const std::set<std::string> &spaces) noexcept;
 
   //----------------------------------------------------------------------------
   //! Notify GC the specified file has been opened
@@ -171,42 +186,126 @@ private:
   }; // class BlockingFlag
 
 
-  /// Used to ensure the enable() method only starts the worker thread once
+  //----------------------------------------------------------------------------
+  //! Garbage collection state of one EOS space
+  //----------------------------------------------------------------------------
+  struct SpaceGc {
+    //--------------------------------------------------------------------------
+    //! Constructor
+    //!
+    //! @param spaceName The name of the space
+    //--------------------------------------------------------------------------
+    SpaceGc(const std::string &spaceName);
+
+    /// The name of the space
+    const std::string name;
+
+    /// Mutex protecting lruQueue
+    std::mutex lruQueueMutex;
+
+    /// Queue of Least Recently Used (LRU) files of the space
+    TapeAwareGcLru lruQueue;
+
+    /// Cached value for the minimum number of free bytes of the space
+    TapeAwareGcCachedValue<uint64_t> cachedMinFreeBytes;
+
+    /// The GC worker thread of the space
+    std::unique_ptr<std::thread> worker;
+
+    /// Number of files garbage collected
+    std::atomic<uint64_t> nbGarbageCollectedFiles;
+
+    /// Number of bytes garbage collected
+    std::atomic<uint64_t> nbGarbageCollectedBytes;
+
+    /// Bytes freed recently, not yet seen in the statistics of the space, as
+    /// (time, bytes) pairs.  Only used by the worker thread.
+    std::deque<std::pair<time_t, uint64_t>> recentlyFreedBytes;
+
+    /// Time and number of garbage collected files when the metrics were last
+    /// published.  Only used by the worker thread.
+    time_t lastPublishTime;
+    uint64_t lastPublishNbFiles;
+  };
+
+  /// Used to ensure the enable() method only starts the worker threads once
   std::atomic_flag m_enabledMethodCalled = ATOMIC_FLAG_INIT;
 
   /// True if the GC has been enabled
   std::atomic<bool> m_enabled;
 
-  /// True if the worker thread should stop
+  /// True if the worker threads should stop
   BlockingFlag m_stop;
 
-  /// The one and only GC worker thread
-  std::unique_ptr<std::thread> m_worker;
+  /// The managed spaces, only modified by enable() before m_enabled is set
+  std::map<std::string, std::unique_ptr<SpaceGc>> m_spaces;
+
+  /// Map from file system identifier to managed space
+  typedef std::unordered_map<uint32_t, SpaceGc*> FsidToSpace;
+
+  /// Mutex protecting m_fsidToSpace
+  std::mutex m_fsidToSpaceMutex;
+
+  /// Current map from file system identifier to managed space
+  std::shared_ptr<const FsidToSpace> m_fsidToSpace;
+
+  /// Time when m_fsidToSpace was last refreshed
+  std::atomic<time_t> m_fsidToSpaceTimestamp;
+
+  /// Thread rebuilding the LRU queues at startup
+  std::unique_ptr<std::thread> m_lruRebuilder;
+
+  /// Maximum number of files garbage collected between two checks of the
+  /// free space
+  static constexpr size_t s_maxBatchSize = 1000;
+
+  /// Number of seconds freed bytes are assumed not to be visible yet in the
+  /// free space statistics of the space
+  static constexpr time_t s_freedBytesLagSecs = 60;
+
+  /// Number of seconds after which m_fsidToSpace is refreshed
+  static constexpr time_t s_fsidToSpaceMaxAgeSecs = 60;
+
+  //----------------------------------------------------------------------------
+  //! Entry point for the GC worker thread of a space
+  //!
+  //! @param space The space to garbage collect
+  //----------------------------------------------------------------------------
+  void workerThreadEntryPoint(SpaceGc &space) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Entry point for the thread rebuilding the LRU queues from QuarkDB
+  //----------------------------------------------------------------------------
+  void lruRebuilderThreadEntryPoint() noexcept;
 
-  /// Mutex protecting mLruQueue
-  std::mutex m_lruQueueMutex;
+  //----------------------------------------------------------------------------
+  //! Notify the LRU queue of the space of a file that the file was accessed
+  //!
+  //! @param preamble log preamble
+  //! @param fmd file metadata
+  //----------------------------------------------------------------------------
+  void fileAccessed(const std::string &preamble, const IFileMD &fmd);
 
-  /// Queue of Least Recently Used (LRU) files
-  TapeAwareGcLru m_lruQueue;
+  //----------------------------------------------------------------------------
+  //! @return The managed space the specified file system belongs to or nullptr
+  //!
+  //! @param fsid The file system identifier
+  //----------------------------------------------------------------------------
+  SpaceGc *getSpaceOfFsid(uint32_t fsid);
 
   //----------------------------------------------------------------------------
-  //! Entry point for the GC worker thread
+  //! Rebuild the map from file system identifier to managed space if it is
+  //! too old
+  //!
+  //! @param force Rebuild even if the map is recent
   //----------------------------------------------------------------------------
-  void workerThreadEntryPoint() noexcept;
+  void refreshFsidToSpace(bool force = false);
 
   /// Thrown when a given space cannot be found
   struct SpaceNotFound: public std::runtime_error {
     SpaceNotFound(const std::string &msg): std::runtime_error(msg) {}
   };
 
-  //----------------------------------------------------------------------------
-  //! @return The minimum number of free bytes the default space should have
-  //! as set in the configuration variables of the space.  If the minimum
-  //! number of free bytes cannot be determined for whatever reason then 0 is
-  //! returned.
-  //----------------------------------------------------------------------------
-  static uint64_t getDefaultSpaceMinNbFreeBytes() noexcept;
-
   //----------------------------------------------------------------------------
   //! @return The minimum number of free bytes the specified space should have
   //! as set in the configuration variables of the space.  If the minimum
@@ -226,11 +325,33 @@ private:
   static uint64_t getSpaceNbFreeBytes(const std::string &name);
 
   //----------------------------------------------------------------------------
-  //! Try to garbage collect a single file if necessary and possible
+  //! Garbage collect a batch of files of the specified space if necessary
+  //! and possible.  The batch holds enough files to free the bytes missing to
+  //! reach the minimum number of free bytes of the space.
   //!
-  //! \return True if a file was garbage collected
+  //! \param space The space to garbage collect
+  //! \return True if at least one file was garbage collected
   //----------------------------------------------------------------------------
-  bool tryToGarbageCollectASingleFile() noexcept;
+  bool tryToGarbageCollectABatchOfFiles(SpaceGc &space) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Garbage collect a single file
+  //!
+  //! \param space The space of the file
+  //! \param fid The file identifier
+  //! \param freedBytes out parameter set to the number of bytes freed
+  //! \return True if the file was garbage collected
+  //----------------------------------------------------------------------------
+  bool garbageCollectFile(SpaceGc &space, const IFileMD::id_t fid,
+    uint64_t &freedBytes);
+
+  //----------------------------------------------------------------------------
+  //! Publish the queue size and eviction metrics of a space as space
+  //! variables
+  //!
+  //! \param space The space
+  //----------------------------------------------------------------------------
+  void publishMetrics(SpaceGc &space) noexcept;
 
   //----------------------------------------------------------------------------
   //! Execute stagerrm as user root
@@ -257,20 +378,6 @@ private:
   //! @return the integer representation of the specified string
   //----------------------------------------------------------------------------
   static uint64_t toUint64(const std::string &str) noexcept;
-
-  //----------------------------------------------------------------------------
-  //! Cached value for the minum number of free bytes to be available in the
-  //! default EOS space.  If the actual number of free bytes is less than this
-  //! value then the garbage collector will try to free up space by garbage
-  //! collecting disk replicas.
-  //----------------------------------------------------------------------------
-  TapeAwareGcCachedValue<uint64_t> m_cachedDefaultSpaceMinFreeBytes;
-
-  //----------------------------------------------------------------------------
-  //! Counter that is incremented each time a file is successfully garabage
-  //! collected.
-  //----------------------------------------------------------------------------
-  uint64_t m_nbGarbageCollectedFiles;
 };
 
 EOSMGMNAMESPACE_END
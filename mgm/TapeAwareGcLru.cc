@@ -31,6 +31,22 @@ void TapeAwareGcLru::fileAccessed(const IFileMD::id_t fid)
   }
 }
 
+//------------------------------------------------------------------------------
+// Notify the queue of a file which was accessed before all of the queued files
+//------------------------------------------------------------------------------
+void TapeAwareGcLru::oldFileDiscovered(const IFileMD::id_t fid)
+{
+  if(mFidToQueueEntry.end() != mFidToQueueEntry.find(fid)) return;
+
+  if(mFidToQueueEntry.size() == mMaxQueueSize) {
+    mMaxQueueSizeExceeded = true;
+  } else {
+    // Add file to the back of the LRU queue
+    mQueue.push_back(fid);
+    mFidToQueueEntry[fid] = --mQueue.end();
+  }
+}
+
 //------------------------------------------------------------------------------
 // Handle the fact a new file has been accessed
 //------------------------------------------------------------------------------
@@ -78,6 +78,15 @@ public:
   //----------------------------------------------------------------------------
   void fileAccessed(const IFileMD::id_t fid);
 
+  //----------------------------------------------------------------------------
+  //! Notify the queue of a file which was accessed before all of the queued
+  //! files, e.g. when rebuilding the queue.  The file is added to the least
+  //! used end of the queue.  Nothing is done if the file is already queued.
+  //!
+  //! @param fid The file identifier
+  //----------------------------------------------------------------------------
+  void oldFileDiscovered(const IFileMD::id_t fid);
+
   //----------------------------------------------------------------------------
   //! @return true if the queue is empty
   //----------------------------------------------------------------------------
@@ -37,6 +37,7 @@ bool
 Vid::Set(const char* value, bool storeConfig)
 {
   eos::common::RWMutexWriteLock lock(eos::common::Mapping::gMapMutex);
+  eos::common::Mapping::gVidCache.Invalidate();
   XrdOucEnv env(value);
   XrdOucString skey = env.Get("mgm.vid.key");
   XrdOucString svalue = value;
@@ -318,6 +319,7 @@ Vid::Rm(XrdOucEnv& env,
         bool storeConfig)
 {
   eos::common::RWMutexWriteLock lock(eos::common::Mapping::gMapMutex);
+  eos::common::Mapping::gVidCache.Invalidate();
   XrdOucString skey = env.Get("mgm.vid.key");
   XrdOucString vidcmd = env.Get("mgm.vid.cmd");
   int envlen = 0;
@@ -98,16 +98,22 @@ WFE::Stop()
 //------------------------------------------------------------------------------
 // @brief WFE method doing the actual workflow
 //
-// This thread method loops in regular intervals over all workflow jobs in the
-// workflow directory /eos/<instance>/proc/workflow/
+// The asynchronous jobs are queued in memory when they are stored in the 'q'
+// or 'e' queue of the workflow directory /eos/<instance>/proc/workflow/ and
+// are scheduled as soon as they are due. The workflow directory is only
+// scanned to recover the queued jobs when the engine is enabled or becomes
+// master.
 //------------------------------------------------------------------------------/
 void
 WFE::WFEr(ThreadAssistant& assistant) noexcept
 {
-  // Eternal thread doing WFE scans
-  time_t snoozetime = 10;
-  size_t lWFEntx = 0;
   time_t cleanuptime = 0;
+  time_t configtime = 0;
+  bool IsEnabledWFE = false;
+  bool IsRecovered = false;
+  size_t lWFEntx = 0;
+  size_t lWFEntxWorkflow = 0;
+  time_t lKeepTime = 7 * 86400;
   gOFS->WaitUntilNamespaceIsBooted(assistant);
 
   if (assistant.terminationRequested()) {
@@ -118,14 +124,11 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
   eos_static_info("msg=\"async WFE thread started\"");
 
   while (!assistant.terminationRequested()) {
-    bool IsEnabledWFE;
-    time_t lWFEInterval;
-    time_t lStartTime = time(NULL);
-    time_t lStopTime;
-    time_t lKeepTime = 7 * 86400;
-    std::map<std::string, std::set<std::string> > wfedirs;
-    XrdOucString stdErr;
-    {
+    time_t now = time(NULL);
+
+    if (configtime != now) {
+      // refresh the configuration at most once per second
+      configtime = now;
       eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
 
       if (FsView::gFsView.mSpaceView.count("default") &&
@@ -136,10 +139,10 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
       }
 
       if (FsView::gFsView.mSpaceView.count("default")) {
-        lWFEInterval =
-          atoi(FsView::gFsView.mSpaceView["default"]->GetConfigMember("wfe.interval").c_str());
         lWFEntx =
           atoi(FsView::gFsView.mSpaceView["default"]->GetConfigMember("wfe.ntx").c_str());
+        lWFEntxWorkflow = atoi(FsView::gFsView.mSpaceView["default"]->GetConfigMember(
+                                 "wfe.ntx.workflow").c_str());
         lKeepTime = atoi(
                       FsView::gFsView.mSpaceView["default"]->GetConfigMember("wfe.keepTIME").c_str());
 
@@ -147,153 +150,46 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
           lKeepTime = 7 * 86400;
         }
       } else {
-        lWFEInterval = 0;
         lWFEntx = 0;
+        lWFEntxWorkflow = 0;
       }
     }
 
+    time_t nextdue = 0;
+
     // Only a master needs to run WFE
     if (gOFS->mMaster->IsMaster() && IsEnabledWFE) {
-      eos_static_debug("msg=\"start WFE scan\"");
-      // Find all directories defining an WFE policy
-      gOFS->MgmStats.Add("WFEFind", 0, 0, 1);
-      EXEC_TIMING_BEGIN("WFEFind");
-      // prepare four queries today, yesterday for queued and error jobs
-      std::string queries[4];
-
-      for (size_t i = 0; i < 4; ++i) {
-        queries[i] = gOFS->MgmProcWorkflowPath.c_str();
-        queries[i] += "/";
-      }
-
+      bool overflow = false;
       {
-        // today
-        time_t when = time(NULL);
-        std::string day = eos::common::Timing::UnixTimstamp_to_Day(when);
-        queries[0] += day;
-        queries[0] += "/q/";
-        queries[1] += day;
-        queries[1] += "/e/";
-        //yesterday
-        when -= (24 * 3600);
-        day = eos::common::Timing::UnixTimstamp_to_Day(when);
-        queries[2] += day;
-        queries[2] += "/q/";
-        queries[3] += day;
-        queries[3] += "/e/";
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        overflow = mOverflow && (mPendingJobs.size() < sMaxPendingJobs / 2);
       }
 
-      for (size_t i = 0; i < 4; ++i) {
-        eos_static_debug("query-path=%s", queries[i].c_str());
-        gOFS->_find(queries[i].c_str(), mError, stdErr, mRootVid, wfedirs, 0,
-                    0, false, 0, false, 0);
+      if (!IsRecovered || overflow) {
+        Recover();
+        IsRecovered = true;
       }
 
-      {
-        eos_static_debug("msg=\"finished WFE find\" WFE-dirs=%llu %s",
-                         wfedirs.size(), stdErr.c_str()
-                        );
-        time_t now = time(NULL);
-
-        for (auto it = wfedirs.begin(); it != wfedirs.end(); it++) {
-          // -------------------------------------------------------------------
-          // get workflows
-          // -------------------------------------------------------------------
-          if (it->second.size()) {
-            for (auto wit = it->second.begin(); wit != it->second.end(); ++wit) {
-              eos_static_debug("wfe-dir=\"%s\" wfe-job=\"%s\"", it->first.c_str(),
-                               wit->c_str());
-              std::string f = it->first;
-              f += *wit;
-              Job* job = new Job();
-
-              if (!job || job->Load(f)) {
-                eos_static_err("msg=\"cannot load workflow entry\" value=\"%s\"", f.c_str());
-
-                if (job) {
-                  delete job;
-                }
-              } else {
-                // don't schedule jobs for the future
-                if ((!job->mActions.size()) || (now < job->mActions[0].mTime)) {
-                  delete job;
-                  continue;
-                }
-
-                // stop scheduling if there are too many jobs running
-                if (lWFEntx <= GetActiveJobs()) {
-                  if (lWFEntx > 0) {
-                    mDoneSignal.WaitMS(100);
-
-                    if (lWFEntx <= GetActiveJobs()) {
-                      delete job;
-                      break;
-                    }
-                  }
-                }
-
-                if (!job->IsSync()) {
-                  // use the shared scheduler for asynchronous jobs
-                  XrdSysMutexHelper sLock(gSchedulerMutex);
-                  time_t storetime = 0;
-                  // move job into the scheduled queue
-                  job->Move(job->mActions[0].mQueue, "r", storetime);
-                  job->mActions[0].mQueue = "r";
-                  job->mActions[0].mTime = storetime;
-                  XrdOucString tst;
-                  job->mActions[0].mWhen = eos::common::StringConversion::GetSizeString(tst,
-                                           (unsigned long long) storetime);
-                  gScheduler->Schedule((XrdJob*) job);
-                  IncActiveJobs();
-                  eos_static_info("msg=\"scheduled workflow\" job=\"%s\"",
-                                  job->mDescription.c_str());
-                } else {
-                  delete job;
-                }
-              }
-            }
-          }
-        }
-      }
-
-      EXEC_TIMING_END("WFEFind");
-      eos_static_debug("msg=\"finished WFE application\" WFE-dirs=%llu",
-                       wfedirs.size());
-    }
-
-    lStopTime = time(NULL);
-
-    if ((lStopTime - lStartTime) < lWFEInterval) {
-      snoozetime = lWFEInterval - (lStopTime - lStartTime);
-    }
-
-    if (!IsEnabledWFE) {
-      snoozetime = 6000;
+      nextdue = Dispatch(lWFEntx, lWFEntxWorkflow);
+    } else {
+      // recover the queues again once we run
+      IsRecovered = false;
     }
 
-    eos_static_debug("snooze-time=%llu enabled=%d", snoozetime, IsEnabledWFE);
-    size_t snoozeloop = snoozetime * 10;
-
-    for (size_t i = 0; i < snoozeloop; i++) {
-      assistant.wait_for(std::chrono::milliseconds(100));
+    {
+      // wait for new or finished jobs, the next due job or at most a second
+      std::unique_lock<std::mutex> lock(mPendingMutex);
+      std::chrono::milliseconds timeout(1000);
 
-      if (assistant.terminationRequested()) {
-        break;
+      if (nextdue && (nextdue <= time(NULL))) {
+        // due jobs are left because of the concurrency limits
+        timeout = std::chrono::milliseconds(100);
       }
 
-      // Check if the setting changed
-      eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
-
-      if (FsView::gFsView.mSpaceView.count("default") &&
-          (FsView::gFsView.mSpaceView["default"]->GetConfigMember("wfe") == "on")) {
-        if (!IsEnabledWFE) {
-          break;
-        }
-      } else {
-        if (IsEnabledWFE) {
-          break;
-        }
-      }
+      mPendingCond.wait_for(lock, timeout, [this]() {
+        return mWakeup;
+      });
+      mWakeup = false;
     }
 
     if (gOFS->mMaster->IsMaster() &&
@@ -304,6 +200,7 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
 
       if (dir.open(gOFS->MgmProcWorkflowPath.c_str(), mRootVid, "") != SFS_OK) {
         eos_static_err("msg=\"failed to open proc workflow directory\"");
+        cleanuptime = now + 3600;
         continue;
       }
 
@@ -347,6 +244,234 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
   }
 }
 
+//------------------------------------------------------------------------------
+// Load the queued jobs from the namespace
+//------------------------------------------------------------------------------
+void
+WFE::Recover()
+{
+  gOFS->MgmStats.Add("WFEFind", 0, 0, 1);
+  EXEC_TIMING_BEGIN("WFEFind");
+  std::map<std::string, std::set<std::string> > wfedirs;
+  XrdOucString stdErr;
+  // prepare four queries today, yesterday for queued and error jobs
+  std::string queries[4];
+
+  for (size_t i = 0; i < 4; ++i) {
+    queries[i] = gOFS->MgmProcWorkflowPath.c_str();
+    queries[i] += "/";
+  }
+
+  {
+    // today
+    time_t when = time(NULL);
+    std::string day = eos::common::Timing::UnixTimstamp_to_Day(when);
+    queries[0] += day;
+    queries[0] += "/q/";
+    queries[1] += day;
+    queries[1] += "/e/";
+    //yesterday
+    when -= (24 * 3600);
+    day = eos::common::Timing::UnixTimstamp_to_Day(when);
+    queries[2] += day;
+    queries[2] += "/q/";
+    queries[3] += day;
+    queries[3] += "/e/";
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    mOverflow = false;
+  }
+
+  for (size_t i = 0; i < 4; ++i) {
+    eos_static_debug("query-path=%s", queries[i].c_str());
+    gOFS->_find(queries[i].c_str(), mError, stdErr, mRootVid, wfedirs, 0,
+                0, false, 0, false, 0);
+  }
+
+  size_t nloaded = 0;
+
+  for (auto it = wfedirs.begin(); it != wfedirs.end(); it++) {
+    for (auto wit = it->second.begin(); wit != it->second.end(); ++wit) {
+      std::string f = it->first;
+      f += *wit;
+      {
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+
+        if (mPendingJobs.count(f)) {
+          continue;
+        }
+      }
+      Job* job = new Job();
+
+      if (job->Load(f)) {
+        eos_static_err("msg=\"cannot load workflow entry\" value=\"%s\"", f.c_str());
+        delete job;
+        continue;
+      }
+
+      if (!job->mActions.size() || job->IsSync()) {
+        delete job;
+        continue;
+      }
+
+      Enqueue(job);
+      nloaded++;
+    }
+  }
+
+  EXEC_TIMING_END("WFEFind");
+  eos_static_info("msg=\"recovered WFE jobs\" WFE-dirs=%llu loaded=%llu %s",
+                  wfedirs.size(), nloaded, stdErr.c_str());
+}
+
+//------------------------------------------------------------------------------
+// Schedule the due pending jobs
+//------------------------------------------------------------------------------
+time_t
+WFE::Dispatch(size_t ntx, size_t ntx_workflow)
+{
+  while (true) {
+    // stop scheduling if there are too many jobs running
+    if (ntx && (ntx <= GetActiveJobs())) {
+      return 0;
+    }
+
+    time_t now = time(NULL);
+    time_t nextdue = 0;
+    Job* job = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mPendingMutex);
+      auto next = mQueues.end();
+
+      // pick the earliest job of the workflows below their concurrency limit
+      for (auto it = mQueues.begin(); it != mQueues.end(); ++it) {
+        if (it->second.mDue.empty() ||
+            (ntx_workflow && (it->second.mRunning >= ntx_workflow))) {
+          continue;
+        }
+
+        if ((next == mQueues.end()) ||
+            (it->second.mDue.begin()->first < next->second.mDue.begin()->first)) {
+          next = it;
+        }
+      }
+
+      if (next == mQueues.end()) {
+        return 0;
+      }
+
+      auto due = next->second.mDue.begin();
+
+      // don't schedule jobs for the future
+      if (due->first > now) {
+        nextdue = due->first;
+      } else {
+        auto pending = mPendingJobs.find(due->second);
+
+        if (pending != mPendingJobs.end()) {
+          job = pending->second;
+          mPendingJobs.erase(pending);
+          next->second.mRunning++;
+        }
+
+        next->second.mDue.erase(due);
+      }
+    }
+
+    if (nextdue) {
+      return nextdue;
+    }
+
+    if (!job) {
+      continue;
+    }
+
+    // the entry may have been removed from the namespace meanwhile
+    struct stat buf;
+    XrdOucErrInfo lError;
+
+    if (gOFS->_stat(job->mWorkflowPath.c_str(), &buf, lError, mRootVid, "")) {
+      eos_static_info("msg=\"skip removed workflow entry\" path=\"%s\"",
+                      job->mWorkflowPath.c_str());
+      std::lock_guard<std::mutex> lock(mPendingMutex);
+      auto queue = mQueues.find(job->mActions[0].mWorkflow);
+
+      if ((queue != mQueues.end()) && queue->second.mRunning) {
+        queue->second.mRunning--;
+      }
+
+      delete job;
+      continue;
+    }
+
+    // use the shared scheduler for asynchronous jobs
+    XrdSysMutexHelper sLock(gSchedulerMutex);
+    time_t storetime = 0;
+    // move job into the scheduled queue
+    job->Move(job->mActions[0].mQueue, "r", storetime);
+    job->mActions[0].mQueue = "r";
+    job->mActions[0].mTime = storetime;
+    XrdOucString tst;
+    job->mActions[0].mWhen = eos::common::StringConversion::GetSizeString(tst,
+                             (unsigned long long) storetime);
+    gScheduler->Schedule((XrdJob*) job);
+    IncActiveJobs();
+    eos_static_info("msg=\"scheduled workflow\" job=\"%s\"",
+                    job->mDescription.c_str());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add a pending job
+//------------------------------------------------------------------------------
+void
+WFE::Enqueue(Job* job)
+{
+  const Job::Action& action = job->mActions[0];
+  std::lock_guard<std::mutex> lock(mPendingMutex);
+  auto it = mPendingJobs.find(job->mWorkflowPath);
+
+  if (it != mPendingJobs.end()) {
+    mQueues[it->second->mActions[0].mWorkflow].mDue.erase(std::make_pair(
+          it->second->mActions[0].mTime, it->first));
+    delete it->second;
+    mPendingJobs.erase(it);
+  } else if (mPendingJobs.size() >= sMaxPendingJobs) {
+    // the job stays in the namespace and is recovered later
+    mOverflow = true;
+    delete job;
+    return;
+  }
+
+  mQueues[action.mWorkflow].mDue.insert(std::make_pair(action.mTime,
+                                        job->mWorkflowPath));
+  mPendingJobs[job->mWorkflowPath] = job;
+  mWakeup = true;
+  mPendingCond.notify_one();
+}
+
+//------------------------------------------------------------------------------
+// Account for a finished job of a workflow
+//------------------------------------------------------------------------------
+void
+WFE::DecActiveJobs(const std::string& workflow)
+{
+  {
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    auto it = mQueues.find(workflow);
+
+    if ((it != mQueues.end()) && it->second.mRunning) {
+      it->second.mRunning--;
+    }
+
+    mWakeup = true;
+    mPendingCond.notify_one();
+  }
+  DecActiveJobs();
+}
+
 /*----------------------------------------------------------------------------*/
 /**
  * @brief store a workflow jobs in the workflow queue
@@ -449,6 +574,19 @@ WFE::Job::Save(std::string queue, time_t& when, int action, int retry)
     return -1;
   }
 
+  if (((queue == "q") || (queue == "e")) && !IsSync()) {
+    // hand a copy of the stored job to the dispatcher
+    Job* job = new Job(*this);
+    eos::common::Mapping::Copy(mVid, job->mVid);
+    job->mRetry = retry;
+    job->mWorkflowPath = workflowpath;
+    job->mActions[0] = mActions[action];
+    job->mActions[0].mQueue = queue;
+    job->mActions[0].mTime = when;
+    job->mActions[0].mWhen = tst.c_str();
+    gOFS->WFEd.Enqueue(job);
+  }
+
   return SFS_OK;
 }
 
@@ -708,7 +846,7 @@ WFE::Job::DoIt(bool issync, std::string& errorMsg, const char * const ininfo)
   // RAII: Async jobs reduce counter on all paths
   auto decrementJobs = [this](void*) {
     if (!IsSync()) {
-      gOFS->WFEd.DecActiveJobs();
+      gOFS->WFEd.DecActiveJobs(mActions[0].mWorkflow);
       gOFS->WFEd.GetSignal()->Signal();
     }
   };
@@ -34,6 +34,10 @@
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdOuc/XrdOucErrInfo.hh"
 #include "Xrd/XrdJob.hh"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
 #include <sys/types.h>
 
 //! Forward declaration
@@ -109,6 +113,10 @@ public:
   ~WFE()
   {
     Stop();
+
+    for (auto it = mPendingJobs.begin(); it != mPendingJobs.end(); ++it) {
+      delete it->second;
+    }
     std::cerr << __FUNCTION__ << ":: end of destructor" << std::endl;
   }
 
@@ -358,6 +366,27 @@ public:
     PublishActiveJobs();
   }
 
+  // ---------------------------------------------------------------------------
+  //! Decrement the number of active jobs of a workflow and wake up the
+  //! dispatcher
+  // ---------------------------------------------------------------------------
+  void DecActiveJobs(const std::string& workflow);
+
+  // ---------------------------------------------------------------------------
+  //! Add an asynchronous job stored in a queue to the pending jobs, takes the
+  //! ownership of the job. Jobs already pending are replaced.
+  // ---------------------------------------------------------------------------
+  void Enqueue(Job* job);
+
+  // ---------------------------------------------------------------------------
+  //! Return the number of pending jobs
+  // ---------------------------------------------------------------------------
+  size_t GetPendingJobs()
+  {
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    return mPendingJobs.size();
+  }
+
   // ---------------------------------------------------------------------------
   //! Publish the number of active jobs in the workflow engine
   // ---------------------------------------------------------------------------
@@ -386,6 +415,42 @@ public:
 
   /// singleton object of a scheduler
   static XrdScheduler* gScheduler;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Pending asynchronous jobs of one workflow, ordered by due time
+  //----------------------------------------------------------------------------
+  struct WorkflowQueue {
+    std::set<std::pair<time_t, std::string> > mDue; ///< (when, entry path)
+    size_t mRunning {0}; ///< jobs of this workflow scheduled and not done
+  };
+
+  /// max number of pending jobs kept in memory, beyond that the namespace
+  /// queues are scanned again once the backlog went down
+  static constexpr size_t sMaxPendingJobs = 1000000;
+
+  std::mutex mPendingMutex; ///< protects the pending jobs and queues
+  std::condition_variable mPendingCond; ///< signalled on new or done jobs
+  bool mWakeup {false};
+  bool mOverflow {false}; ///< pending jobs have been dropped
+  std::map<std::string, Job*> mPendingJobs; ///< entry path to job
+  std::map<std::string, WorkflowQueue> mQueues; ///< workflow to queue
+
+  //----------------------------------------------------------------------------
+  //! Load the queued and retried jobs of today and yesterday from the
+  //! namespace into the pending queues
+  //----------------------------------------------------------------------------
+  void Recover();
+
+  //----------------------------------------------------------------------------
+  //! Schedule the due pending jobs
+  //!
+  //! @param ntx max number of active jobs, 0 is unlimited
+  //! @param ntx_workflow max number of active jobs per workflow, 0 is unlimited
+  //!
+  //! @return due time of the next pending job or 0 if none
+  //----------------------------------------------------------------------------
+  time_t Dispatch(size_t ntx, size_t ntx_workflow);
 };
 
 EOSMGMNAMESPACE_END
@@ -63,8 +63,10 @@
 #include "mgm/Egroup.hh"
 #include "mgm/http/HttpServer.hh"
 #include "mgm/ZMQ.hh"
+#include "mgm/NsChangeStream.hh"
 #include "mgm/Iostat.hh"
 #include "mgm/LRU.hh"
+#include "mgm/HotFileReplicator.hh"
 #include "mgm/WFE.hh"
 #include "mgm/Fsck.hh"
 #include "mgm/Master.hh"
@@ -278,6 +280,12 @@ XrdMgmOfs::OrderlyShutdown()
     zMQ = nullptr;
   }
 
+  // The stream stays registered with the namespace, it only stops publishing
+  if (mNsChangeStream) {
+    eos_warning("%s", "msg=\"stopping namespace change stream\"");
+    mNsChangeStream->Stop();
+  }
+
   eos_warning("%s", "msg=\"stopping FSCK service\"");
 
   if (FsckPtr) {
@@ -306,6 +314,11 @@ XrdMgmOfs::OrderlyShutdown()
     LRUPtr.reset();
   }
 
+  if (mHotFileReplicator) {
+    eos_warning("%s", "msg=\"stopping and deleting the hot file replicator\"");
+    mHotFileReplicator.reset();
+  }
+
   if (EgroupRefresh) {
     eos_warning("%s", "msg=\"stopping and deleting egroup refresh thread\"");
     EgroupRefresh.reset();
@@ -342,6 +355,8 @@ XrdMgmOfs::OrderlyShutdown()
   stop_fsconfiglistener.join();
   eos_warning("%s", "msg=\"stopping the shared object notifier thread\"");
   ObjectNotifier.Stop();
+  eos_warning("%s", "msg=\"stopping quota reconciliation thread\"");
+  mQuotaReconcileTid.join();
   eos_warning("%s", "msg=\"cleanup quota information\"");
   (void) Quota::CleanUp();
   eos_warning("%s", "msg=\"graceful shutdown of the FsView\"");
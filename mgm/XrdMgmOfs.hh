@@ -110,12 +110,15 @@
 #include "mgm/proc/ProcCommand.hh"
 #include "mgm/drain/Drainer.hh"
 #include "mgm/TapeAwareGc.hh"
+#include "mgm/OpenDecisionCache.hh"
+#include "mgm/ContainerPolicyCache.hh"
 #include "mgm/auth/AccessChecker.hh"
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
 #include "mgm/FuseNotificationGuard.hh"
 #include <google/sparse_hash_map>
 #include <chrono>
+#include <deque>
 #include <mutex>
 
 USE_EOSMGMNAMESPACE
@@ -156,11 +159,13 @@ class HttpServer;
 class Egroup;
 class GeoTreeEngine;
 class ZMQ;
+class NsChangeStream;
 class Recycle;
 class Iostat;
 class Stat;
 class WFE;
 class LRU;
+class HotFileReplicator;
 class Fsck;
 class IMaster;
 class Messaging;
@@ -1234,6 +1239,41 @@ public:
   // ---------------------------------------------------------------------------
   void FsConfigListener(ThreadAssistant& assistant) noexcept;
 
+  //----------------------------------------------------------------------------
+  //! Apply a batch of shared object notifications taken by the listener.
+  //! Repeated modifications of the same (queue, key) are applied once and the
+  //! changes of a kind are applied together, taking the hash and view locks
+  //! once per batch instead of once per notification.
+  //!
+  //! @param batch notifications in the order they were received
+  //----------------------------------------------------------------------------
+  void ProcessFsConfigBatch(const
+                            std::deque<XrdMqSharedObjectManager::Notification>& batch);
+
+  //----------------------------------------------------------------------------
+  //! Apply MGM configuration keys broadcasted by the master, fs: keys are
+  //! applied under a single view write lock
+  //----------------------------------------------------------------------------
+  void ApplyRemoteConfigBatch(const std::vector<std::string>& keys);
+
+  //----------------------------------------------------------------------------
+  //! Move the file systems of the given queues whose geotag changed in the
+  //! node, group and space trees
+  //----------------------------------------------------------------------------
+  void ApplyGeotagBatch(const std::vector<std::string>& queues);
+
+  //----------------------------------------------------------------------------
+  //! Update the proxygroups of the nodes of the given queues in the
+  //! GeoTreeEngine
+  //----------------------------------------------------------------------------
+  void ApplyProxyGroupBatch(const std::vector<std::string>& queues);
+
+  //----------------------------------------------------------------------------
+  //! Start or stop draining the file systems of the given queues depending
+  //! on their error code
+  //----------------------------------------------------------------------------
+  void ApplyFsErrorBatch(const std::vector<std::string>& queues);
+
   //------------------------------------------------------------------------------
   //! Add backup job to the queue to be picked up by the archive/backup submitter
   //! thread.
@@ -1336,6 +1376,8 @@ public:
   XrdOucString MgmProcWorkflowPath; ///< Directory with worflows
   XrdOucString MgmProcLockPath; ///< Directory with client locks
   XrdOucString MgmProcDelegationPath; ///< Directory with client delegations
+  //! Directory with the files which got extra replicas because they are hot
+  XrdOucString MgmProcHotReplicaPath;
   //! Full path to the master indication proc file
   XrdOucString MgmProcMasterPath;
   XrdOucString MgmProcArchivePath; ///< EOS directory where archive dir inodes
@@ -1393,6 +1435,10 @@ public:
   bool Shutdown; ///< true if the shutdown function was called => avoid to join some threads
   //! Const strings to print the namespace boot state as in eNamespace
   static const char* gNameSpaceState[];
+  //! Maximum length of the opaque of an FSctl call
+  static constexpr size_t kMaxFsctlOpaqueLen = 1024 * 1024;
+  //! Maximum number of entries of a commit batch
+  static constexpr size_t kMaxCommitBatch = 256;
 
   //----------------------------------------------------------------------------
   // State variables
@@ -1432,6 +1478,7 @@ public:
   pthread_t mStatsTid; ///< Thread Id of the stats thread
   AssistedThread mFsConfigTid; ///< Fs listener/config change thread
   AssistedThread mAuthMasterTid; ///< Thread Id of the authentication thread
+  AssistedThread mQuotaReconcileTid; ///< Quota counter reconciliation thread
   std::vector<pthread_t> mVectTid; ///< vector of auth worker threads ids
 
   //----------------------------------------------------------------------------
@@ -1442,6 +1489,8 @@ public:
   unsigned int mNumAuthThreads; ///< max number of auth worker threads
   zmq::context_t* mZmqContext; ///< ZMQ context for all the sockets
   ZMQ* zMQ; ///< ZMQ processor
+  //! Namespace change stream, only if EOS_MGM_NS_CHANGE_STREAM_PORT is set
+  std::unique_ptr<NsChangeStream> mNsChangeStream;
 
   //! Autentication response time statistics
   struct AuthStats {
@@ -1594,6 +1643,15 @@ public:
   std::unique_ptr<LRU> LRUPtr;
   LRU& LRUd;
 
+  //! Service adding temporary replicas to hot files
+  std::unique_ptr<HotFileReplicator> mHotFileReplicator;
+
+  //! Access and replica decisions of recent read opens
+  OpenDecisionCache mOpenDecisionCache;
+
+  //! Attributes and parsed policies of the directories of recent opens
+  ContainerPolicyCache mContainerPolicyCache;
+
   //! WFE object running the WFE engine
   std::unique_ptr<WFE> WFEPtr;
   WFE& WFEd;
@@ -1613,6 +1671,7 @@ public:
   int mHttpdPort; ///< port of the http server, default 8000
   int mFusexPort; ///< port of the FUSEX brocasz MQZ, default 1100
   bool mTapeAwareGcDefaultSpaceEnable; ///< Flag to mark if tape aware garbage collection should be enabled
+  std::set<std::string> mTapeAwareGcSpaces; ///< Spaces garbage collected by the tape aware GC
   eos::common::XrdConnPool mXrdConnPool; ///< XRD connection pool
   TapeAwareGc mTapeAwareGc; ///< Tape aware garbage collector
 
@@ -1744,6 +1803,20 @@ private:
              eos::common::Mapping::VirtualIdentity& vid,
              const XrdSecEntity* client);
 
+  //----------------------------------------------------------------------------
+  //! Commit a batch of replicas sent by an FST as mgm.batch.n=<n> and the
+  //! sealed commit opaques mgm.batch.<i>. All entries are applied under one
+  //! namespace lock; the response is "OK" followed by one line per entry
+  //! with its errno (0 if successful) and error message.
+  //----------------------------------------------------------------------------
+  int CommitBatch(const char* path,
+                  const char* ininfo,
+                  XrdOucEnv& env,
+                  XrdOucErrInfo& error,
+                  eos::common::LogId& ThreadLogId,
+                  eos::common::Mapping::VirtualIdentity& vid,
+                  const XrdSecEntity* client);
+
   //----------------------------------------------------------------------------
   //! Drop a replica
   //----------------------------------------------------------------------------
@@ -512,6 +512,12 @@ XrdMgmOfs::_attr_rem(const char* path, XrdOucErrInfo& error,
       } else {
         if (dh->hasAttribute(key)) {
           dh->removeAttribute(key);
+
+          if (Key != "sys.tmp.etag") {
+            // like a change, the removal invalidates the cached policies
+            dh->setCTimeNow();
+          }
+
           eosView->updateContainerStore(dh.get());
           eos::ContainerIdentifier d_id = dh->getIdentifier();
           eos::ContainerIdentifier d_pid = dh->getParentIdentifier();
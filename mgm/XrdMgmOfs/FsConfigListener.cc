@@ -38,6 +38,9 @@
  * is removing the error code it also run's a stop drain job routine.
  * Additionally it applies changes in the MGM configuration which have been
  * broadcasted by a remote master MGM.
+ *
+ * All the pending notifications are taken at once and handled as a batch,
+ * see ProcessFsConfigBatch.
  */
 /*----------------------------------------------------------------------------*/
 void
@@ -81,6 +84,8 @@ XrdMgmOfs::FsConfigListener(ThreadAssistant& assistant) noexcept
     eos_crit("error starting shared objects change notifications");
   }
 
+  std::deque<XrdMqSharedObjectManager::Notification> batch;
+
   // Thread listening on filesystem errors and configuration changes
   while (!assistant.terminationRequested()) {
     gOFS->ObjectNotifier.tlSubscriber->mSubjSem.Wait();
@@ -89,297 +94,452 @@ XrdMgmOfs::FsConfigListener(ThreadAssistant& assistant) noexcept
       break;
     }
 
-    // we always take a lock to take something from the queue and then release it
+    // Take everything queued so far, the notifications keep coming in while
+    // the batch is applied and make up the next one
     gOFS->ObjectNotifier.tlSubscriber->mSubjMtx.Lock();
+    batch.swap(gOFS->ObjectNotifier.tlSubscriber->NotificationSubjects);
+    gOFS->ObjectNotifier.tlSubscriber->mSubjMtx.UnLock();
 
-    // Listens for modifications on filesystem objects
-    while (gOFS->ObjectNotifier.tlSubscriber->NotificationSubjects.size()) {
-      XrdMqSharedObjectManager::Notification event;
-      event = gOFS->ObjectNotifier.tlSubscriber->NotificationSubjects.front();
-      gOFS->ObjectNotifier.tlSubscriber->NotificationSubjects.pop_front();
-      gOFS->ObjectNotifier.tlSubscriber->mSubjMtx.UnLock();
-      eos_static_debug("MGM shared object notification subject is %s",
-                       event.mSubject.c_str());
-      std::string newsubject = event.mSubject.c_str();
-
-      // Handle subject creation
-      if (event.mType == XrdMqSharedObjectManager::kMqSubjectCreation) {
-        eos_static_debug("received creation on subject %s\n", newsubject.c_str());
-        gOFS->ObjectNotifier.tlSubscriber->mSubjMtx.Lock();
-        continue;
-      }
+    if (!batch.empty()) {
+      ProcessFsConfigBatch(batch);
+      batch.clear();
+    }
+  }
+}
 
-      // Handle subject deletion
-      if (event.mType == XrdMqSharedObjectManager::kMqSubjectDeletion) {
-        eos_static_debug("received deletion on subject %s\n", newsubject.c_str());
-        gOFS->ObjectNotifier.tlSubscriber->mSubjMtx.Lock();
-        continue;
-      }
+//------------------------------------------------------------------------------
+// Apply a batch of shared object notifications
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::ProcessFsConfigBatch(const
+                                std::deque<XrdMqSharedObjectManager::Notification>& batch)
+{
+  // The handlers read the current value from the shared hash, so only the
+  // last modification of a (queue, key) is needed. A key deletion keeps the
+  // modifications before it, the configuration changes are applied in order.
+  std::vector<bool> skip(batch.size(), false);
+  {
+    std::set<std::string> seen;
+
+    for (size_t i = batch.size(); i-- > 0;) {
+      const auto& event = batch[i];
 
-      // Handle subject modification
       if (event.mType == XrdMqSharedObjectManager::kMqSubjectModification) {
-        eos_static_debug("received modification on subject %s", newsubject.c_str());
-        // if this is an error status on a file system, check if the filesystem
-        // is > drained state and in this case launch a drain job with
-        // the opserror flag by calling StartDrainJob
-        // We use directly the ObjectManager Interface because it is more handy
-        // with the available information we have at this point
-        std::string key = newsubject;
-        std::string queue = newsubject;
-        size_t dpos = 0;
-
-        if ((dpos = queue.find(";")) != std::string::npos) {
-          key.erase(0, dpos + 1);
-          queue.erase(dpos);
-        }
+        skip[i] = !seen.insert(event.mSubject).second;
+      } else if (event.mType == XrdMqSharedObjectManager::kMqSubjectKeyDeletion) {
+        seen.erase(event.mSubject);
+      }
+    }
+  }
+  std::vector<std::string> config_keys;
+  std::vector<std::string> geotag_queues;
+  std::vector<std::string> proxygroup_queues;
+  std::vector<std::string> errc_queues;
+  size_t num_skipped = 0;
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    const auto& event = batch[i];
+    const std::string& newsubject = event.mSubject;
+
+    if (skip[i]) {
+      ++num_skipped;
+      continue;
+    }
 
-        if (queue == MgmConfigQueue.c_str()) {
-          // This is an MGM configuration modification
-          if (!gOFS->mMaster->IsMaster()) {
-            // only an MGM slave needs to apply this
-            gOFS->ObjectManager.HashMutex.LockRead();
-            XrdMqSharedHash* hash = gOFS->ObjectManager.GetObject(queue.c_str(), "hash");
-
-            if (hash) {
-              XrdOucString err;
-              XrdOucString value = hash->Get(key.c_str()).c_str();
-              gOFS->ObjectManager.HashMutex.UnLockRead();
-
-              if (value.c_str()) {
-                // Here we might get a change without the namespace, in this
-                // case we add the global namespace
-                if ((key.substr(0, 4) != "map:") &&
-                    (key.substr(0, 3) != "fs:") &&
-                    (key.substr(0, 6) != "quota:") &&
-                    (key.substr(0, 4) != "vid:") &&
-                    (key.substr(0, 7) != "policy:")) {
-                  XrdOucString skey = key.c_str();
-                  eos_info("Calling Apply for %s %s", key.c_str(), value.c_str());
-                  Access::ApplyAccessConfig(false);
-
-                  if (skey.beginswith("iostat:")) {
-                    gOFS->IoStats->ApplyIostatConfig();
-                  }
-
-                  if (skey.beginswith("fsck")) {
-                    gOFS->FsCheck.ApplyFsckConfig();
-                  }
-                } else {
-                  eos_info("Call SetConfig %s %s", key.c_str(), value.c_str());
-                  gOFS->ConfEngine->SetConfigValue(0, key.c_str(),
-                                                   value.c_str(), false);
-
-                  // For file system modification we need to take the
-                  // FsView::ViewMutex for write
-                  if (key.find("fs:") == 0) {
-                    eos::common::RWMutexWriteLock wr_view_lock(FsView::gFsView.ViewMutex);
-                    gOFS->ConfEngine->ApplyEachConfig(key.c_str(), &value, (void*) &err);
-                  } else {
-                    gOFS->ConfEngine->ApplyEachConfig(key.c_str(), &value, (void*) &err);
-                  }
-                }
-              }
-            } else {
-              gOFS->ObjectManager.HashMutex.UnLockRead();
-            }
-          }
-        } else if (key == watch_geotag) {
-          // Geotag update
-          eos::common::FileSystem::fsid_t fsid = 0;
-          std::string newgeotag, oldgeotag;
-          {
-            // Read the id from the hash and the new geotag
-            eos::common::RWMutexReadLock hash_rd_lock(gOFS->ObjectManager.HashMutex);
-            XrdMqSharedHash* hash = gOFS->ObjectManager.GetObject(queue.c_str(), "hash");
-
-            if (hash) {
-              fsid = (eos::common::FileSystem::fsid_t) hash->GetLongLong("id");
-              oldgeotag = newgeotag = hash->Get("stat.geotag");
-            }
-          }
-
-          if (fsid == 0) {
-            eos_debug("Received a geotag modification (might be no change) for "
-                      "queue %s which is not registered ", queue.c_str());
-          } else {
-            FsView::gFsView.ViewMutex.LockRead();
-            auto it_fs = FsView::gFsView.mIdView.find(fsid);
-
-            if (it_fs != FsView::gFsView.mIdView.end()) {
-              FileSystem* fs = it_fs->second;
-
-              if (fs && FsView::gFsView.mNodeView.count(fs->GetQueue())) {
-                // check if the change notification is an actual change in the geotag
-                FsNode* node = FsView::gFsView.mNodeView[fs->GetQueue()];
-                static_cast<GeoTree*>(node)->getGeoTagInTree(fsid , oldgeotag);
-                oldgeotag.erase(0, 8); // to get rid of the "<ROOT>::" prefix
-              }
-
-              if (fs && (oldgeotag != newgeotag)) {
-                eos_warning("Received a geotag change for fsid %lu new geotag is "
-                            "%s, old geotag was %s ", (unsigned long)fsid,
-                            newgeotag.c_str(), oldgeotag.c_str());
-                FsView::gFsView.ViewMutex.UnLockRead();
-                eos::common::RWMutexWriteLock fs_rw_lock(FsView::gFsView.ViewMutex);
-                eos::common::FileSystem::fs_snapshot snapshot;
-                fs->SnapShotFileSystem(snapshot);
-
-                // Update node view tree structure
-                if (FsView::gFsView.mNodeView.count(snapshot.mQueue)) {
-                  FsNode* node = FsView::gFsView.mNodeView[snapshot.mQueue];
-                  eos_static_info("updating geotag of fsid %lu in node %s",
-                                  (unsigned long)fsid, node->mName.c_str());
-
-                  if (!static_cast<GeoTree*>(node)->erase(fsid)) {
-                    eos_static_err("error removing fsid %lu from node %s",
-                                   (unsigned long)fsid, node->mName.c_str());
-                  }
-
-                  if (!static_cast<GeoTree*>(node)->insert(fsid)) {
-                    eos_static_err("error inserting fsid %lu into node %s",
-                                   (unsigned long)fsid, node->mName.c_str());
-                  }
-                }
-
-                // Update group view tree structure
-                if (FsView::gFsView.mGroupView.count(snapshot.mGroup)) {
-                  FsGroup* group = FsView::gFsView.mGroupView[snapshot.mGroup];
-                  eos_static_info("updating geotag of fsid %lu in group %s",
-                                  (unsigned long)fsid, group->mName.c_str());
-
-                  if (!static_cast<GeoTree*>(group)->erase(fsid)) {
-                    eos_static_err("error removing fsid %lu from group %s",
-                                   (unsigned long)fsid, group->mName.c_str());
-                  }
-
-                  if (!static_cast<GeoTree*>(group)->insert(fsid)) {
-                    eos_static_err("error inserting fsid %lu into group %s",
-                                   (unsigned long)fsid, group->mName.c_str());
-                  }
-                }
-
-                // Update space view tree structure
-                if (FsView::gFsView.mSpaceView.count(snapshot.mSpace)) {
-                  FsSpace* space = FsView::gFsView.mSpaceView[snapshot.mSpace];
-                  eos_static_info("updating geotag of fsid %lu in space %s",
-                                  (unsigned long)fsid, space->mName.c_str());
-
-                  if (!static_cast<GeoTree*>(space)->erase(fsid)) {
-                    eos_static_err("error removing fsid %lu from space %s",
-                                   (unsigned long)fsid, space->mName.c_str());
-                  }
-
-                  if (!static_cast<GeoTree*>(space)->insert(fsid)) {
-                    eos_static_err("error inserting fsid %lu into space %s",
-                                   (unsigned long)fsid, space->mName.c_str());
-                  }
-                }
-              } else {
-                FsView::gFsView.ViewMutex.UnLockRead();
-              }
-            } else {
-              FsView::gFsView.ViewMutex.UnLockRead();
-            }
-          }
-        } else if (key == watch_proxygroups) {
-          // This is a dataproxy / dataep status update
-          std::string status;
-          {
-            // Read the proxygrouplist
-            eos::common::RWMutexReadLock hash_rd_lock(gOFS->ObjectManager.HashMutex);
-            XrdMqSharedHash* hash = gOFS->ObjectManager.GetObject(queue.c_str(), "hash");
-
-            if (hash) {
-              status = hash->Get("proxygroups");
-            }
-          }
-          std::string hostport = "/eos/" + queue.substr(queue.rfind('/') + 1) + "/fst";
-          eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
-
-          if (eos::mgm::FsView::gFsView.mNodeView.count(hostport)) {
-            eos::mgm::FsNode* node = eos::mgm::FsView::gFsView.mNodeView[hostport];
-            eos::mgm::gGeoTreeEngine.matchHostPxyGr(node, status, false, false);
-          } else {
-            eos_err("could not find the FsNode object associated with queue %s  and  hostport %s",
-                    queue.c_str(), hostport.c_str());
-          }
-        } else {
-          // This is a filesystem status error
-          if (gOFS->mMaster->IsMaster()) {
-            // only an MGM master needs to initiate draining
-            eos::common::FileSystem::fsid_t fsid = 0;
-            long long errc = 0;
-            std::string configstatus = "";
-            std::string bootstatus = "";
-            int cfgstatus = 0;
-            int bstatus = 0;
-            // read the id from the hash and the current error value
-            gOFS->ObjectManager.HashMutex.LockRead();
-            XrdMqSharedHash* hash = gOFS->ObjectManager.GetObject(queue.c_str(), "hash");
-
-            if (hash) {
-              fsid = (eos::common::FileSystem::fsid_t) hash->GetLongLong("id");
-              errc = (int) hash->GetLongLong("stat.errc");
-              configstatus = hash->Get("configstatus");
-              bootstatus = hash->Get("stat.boot");
-              cfgstatus = eos::common::FileSystem::GetConfigStatusFromString(
-                            configstatus.c_str());
-              bstatus = eos::common::FileSystem::GetStatusFromString(bootstatus.c_str());
-            }
-
-            gOFS->ObjectManager.HashMutex.UnLockRead();
-
-            if (fsid && errc && (cfgstatus >= eos::common::FileSystem::kRO) &&
-                (bstatus == eos::common::FileSystem::kOpsError)) {
-              // Case when we take action and explicitly ask to start a drain job
-              eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
-              auto it_fs = FsView::gFsView.mIdView.find(fsid);
-
-              if (it_fs != FsView::gFsView.mIdView.end()) {
-                it_fs->second->SetConfigStatus(eos::common::FileSystem::kDrain);
-              }
-            }
-
-            if (fsid && (!errc)) {
-              // Make sure there is no drain job triggered by a previous filesystem errc!=0
-              eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
-              auto it_fs = FsView::gFsView.mIdView.find(fsid);
-
-              if (it_fs != FsView::gFsView.mIdView.end()) {
-                it_fs->second->StopDrainJob();
-              }
-            }
-          }
+    eos_static_debug("MGM shared object notification subject is %s",
+                     newsubject.c_str());
+
+    // Handle subject creation
+    if (event.mType == XrdMqSharedObjectManager::kMqSubjectCreation) {
+      eos_static_debug("received creation on subject %s\n", newsubject.c_str());
+      continue;
+    }
+
+    // Handle subject deletion
+    if (event.mType == XrdMqSharedObjectManager::kMqSubjectDeletion) {
+      eos_static_debug("received deletion on subject %s\n", newsubject.c_str());
+      continue;
+    }
+
+    std::string key = newsubject;
+    std::string queue = newsubject;
+    size_t dpos = 0;
+
+    if ((dpos = queue.find(";")) != std::string::npos) {
+      key.erase(0, dpos + 1);
+      queue.erase(dpos);
+    }
+
+    // Handle subject modification
+    if (event.mType == XrdMqSharedObjectManager::kMqSubjectModification) {
+      eos_static_debug("received modification on subject %s", newsubject.c_str());
+
+      if (queue == MgmConfigQueue.c_str()) {
+        // This is an MGM configuration modification, only an MGM slave needs
+        // to apply it
+        if (!gOFS->mMaster->IsMaster()) {
+          config_keys.push_back(key);
         }
+      } else if (key == "stat.geotag") {
+        geotag_queues.push_back(queue);
+      } else if (key == "proxygroups") {
+        proxygroup_queues.push_back(queue);
+      } else if (gOFS->mMaster->IsMaster()) {
+        // This is a filesystem status error, only an MGM master needs to
+        // initiate draining
+        errc_queues.push_back(queue);
+      }
+
+      continue;
+    }
+
+    // Handle subject key deletion
+    if (event.mType == XrdMqSharedObjectManager::kMqSubjectKeyDeletion) {
+      eos_static_info("received deletion on subject %s\n", newsubject.c_str());
+      // The modifications queued before the deletion go first
+      ApplyRemoteConfigBatch(config_keys);
+      config_keys.clear();
+      gOFS->ConfEngine->DeleteConfigValue(0, key.c_str(), false);
+      gOFS->ConfEngine->ApplyKeyDeletion(key.c_str());
+      continue;
+    }
+
+    eos_static_warning("msg=\"don't know what to do with subject\" subject=%s",
+                       newsubject.c_str());
+  }
+
+  ApplyRemoteConfigBatch(config_keys);
+  ApplyGeotagBatch(geotag_queues);
+  ApplyProxyGroupBatch(proxygroup_queues);
+  ApplyFsErrorBatch(errc_queues);
+
+  if (batch.size() > 1) {
+    eos_static_debug("msg=\"applied shared object notifications\" num=%lu "
+                     "duplicates=%lu", (unsigned long) batch.size(),
+                     (unsigned long) num_skipped);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Apply configuration changes broadcasted by the master
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::ApplyRemoteConfigBatch(const std::vector<std::string>& keys)
+{
+  if (keys.empty()) {
+    return;
+  }
+
+  std::vector<std::pair<std::string, XrdOucString>> values;
+  {
+    eos::common::RWMutexReadLock hash_rd_lock(gOFS->ObjectManager.HashMutex);
+    XrdMqSharedHash* hash = gOFS->ObjectManager.GetObject(MgmConfigQueue.c_str(),
+                            "hash");
+
+    if (!hash) {
+      return;
+    }
+
+    for (const auto& key : keys) {
+      values.emplace_back(key, XrdOucString(hash->Get(key.c_str()).c_str()));
+    }
+  }
+  bool apply_access = false;
+  bool apply_iostat = false;
+  bool apply_fsck = false;
+  std::vector<std::pair<std::string, XrdOucString>*> fs_values;
+
+  for (auto& entry : values) {
+    const std::string& key = entry.first;
+    XrdOucString& value = entry.second;
+
+    if (!value.c_str()) {
+      continue;
+    }
+
+    // Here we might get a change without the namespace, in this case we add
+    // the global namespace
+    if ((key.substr(0, 4) != "map:") &&
+        (key.substr(0, 3) != "fs:") &&
+        (key.substr(0, 6) != "quota:") &&
+        (key.substr(0, 4) != "vid:") &&
+        (key.substr(0, 7) != "policy:")) {
+      eos_info("Calling Apply for %s %s", key.c_str(), value.c_str());
+      // The whole access, iostat and fsck configuration is reapplied, once
+      // per batch is enough
+      apply_access = true;
+      apply_iostat |= (key.find("iostat:") == 0);
+      apply_fsck |= (key.find("fsck") == 0);
+    } else {
+      eos_info("Call SetConfig %s %s", key.c_str(), value.c_str());
+      gOFS->ConfEngine->SetConfigValue(0, key.c_str(), value.c_str(), false);
+
+      if (key.find("fs:") == 0) {
+        fs_values.push_back(&entry);
+      } else {
+        XrdOucString err;
+        gOFS->ConfEngine->ApplyEachConfig(key.c_str(), &value, (void*) &err);
+      }
+    }
+  }
+
+  if (apply_access) {
+    Access::ApplyAccessConfig(false);
+  }
+
+  if (apply_iostat) {
+    gOFS->IoStats->ApplyIostatConfig();
+  }
+
+  if (apply_fsck) {
+    gOFS->FsCheck.ApplyFsckConfig();
+  }
+
+  // For file system modifications we need to take the FsView::ViewMutex for
+  // write, once for all of them
+  if (!fs_values.empty()) {
+    eos::common::RWMutexWriteLock wr_view_lock(FsView::gFsView.ViewMutex);
+
+    for (auto entry : fs_values) {
+      XrdOucString err;
+      gOFS->ConfEngine->ApplyEachConfig(entry->first.c_str(), &entry->second,
+                                        (void*) &err);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Move the file systems whose geotag changed in the view trees
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::ApplyGeotagBatch(const std::vector<std::string>& queues)
+{
+  if (queues.empty()) {
+    return;
+  }
 
-        gOFS->ObjectNotifier.tlSubscriber->mSubjMtx.Lock();
+  std::map<eos::common::FileSystem::fsid_t, std::string> new_geotags;
+  {
+    // Read the ids from the hashes and the new geotags
+    eos::common::RWMutexReadLock hash_rd_lock(gOFS->ObjectManager.HashMutex);
+
+    for (const auto& queue : queues) {
+      XrdMqSharedHash* hash = gOFS->ObjectManager.GetObject(queue.c_str(), "hash");
+      eos::common::FileSystem::fsid_t fsid = 0;
+
+      if (hash) {
+        fsid = (eos::common::FileSystem::fsid_t) hash->GetLongLong("id");
+      }
+
+      if (fsid == 0) {
+        eos_debug("Received a geotag modification (might be no change) for "
+                  "queue %s which is not registered ", queue.c_str());
         continue;
       }
 
-      // Handle subject key deletion
-      if (event.mType == XrdMqSharedObjectManager::kMqSubjectKeyDeletion) {
-        eos_static_info("received deletion on subject %s\n", newsubject.c_str());
-        std::string key = newsubject;
-        std::string queue = newsubject;
-        size_t dpos = 0;
+      new_geotags[fsid] = hash->Get("stat.geotag");
+    }
+  }
+  // Check which notifications are actual changes of the geotag
+  std::vector<eos::common::FileSystem::fsid_t> changed;
+  {
+    eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
 
-        if ((dpos = queue.find(";")) != std::string::npos) {
-          key.erase(0, dpos + 1);
-          queue.erase(dpos);
-        }
+    for (const auto& elem : new_geotags) {
+      auto it_fs = FsView::gFsView.mIdView.find(elem.first);
 
-        gOFS->ConfEngine->DeleteConfigValue(0, key.c_str(), false);
-        gOFS->ConfEngine->ApplyKeyDeletion(key.c_str());
-        gOFS->ObjectNotifier.tlSubscriber->mSubjMtx.Lock();
+      if ((it_fs == FsView::gFsView.mIdView.end()) || !it_fs->second) {
         continue;
       }
 
-      eos_static_warning("msg=\"don't know what to do with subject\" subject=%s",
-                         newsubject.c_str());
-      gOFS->ObjectNotifier.tlSubscriber->mSubjMtx.Lock();
+      FileSystem* fs = it_fs->second;
+      std::string oldgeotag = elem.second;
+
+      if (FsView::gFsView.mNodeView.count(fs->GetQueue())) {
+        FsNode* node = FsView::gFsView.mNodeView[fs->GetQueue()];
+        static_cast<GeoTree*>(node)->getGeoTagInTree(elem.first, oldgeotag);
+        oldgeotag.erase(0, 8); // to get rid of the "<ROOT>::" prefix
+      }
+
+      if (oldgeotag != elem.second) {
+        eos_warning("Received a geotag change for fsid %lu new geotag is "
+                    "%s, old geotag was %s ", (unsigned long) elem.first,
+                    elem.second.c_str(), oldgeotag.c_str());
+        changed.push_back(elem.first);
+      }
+    }
+  }
+
+  if (changed.empty()) {
+    return;
+  }
+
+  // Update the tree structures of all the changed file systems at once
+  eos::common::RWMutexWriteLock fs_rw_lock(FsView::gFsView.ViewMutex);
+
+  for (const auto fsid : changed) {
+    auto it_fs = FsView::gFsView.mIdView.find(fsid);
+
+    if ((it_fs == FsView::gFsView.mIdView.end()) || !it_fs->second) {
       continue;
     }
 
-    gOFS->ObjectNotifier.tlSubscriber->mSubjMtx.UnLock();
+    eos::common::FileSystem::fs_snapshot snapshot;
+    it_fs->second->SnapShotFileSystem(snapshot);
+
+    // Update node view tree structure
+    if (FsView::gFsView.mNodeView.count(snapshot.mQueue)) {
+      FsNode* node = FsView::gFsView.mNodeView[snapshot.mQueue];
+      eos_static_info("updating geotag of fsid %lu in node %s",
+                      (unsigned long)fsid, node->mName.c_str());
+
+      if (!static_cast<GeoTree*>(node)->erase(fsid)) {
+        eos_static_err("error removing fsid %lu from node %s",
+                       (unsigned long)fsid, node->mName.c_str());
+      }
+
+      if (!static_cast<GeoTree*>(node)->insert(fsid)) {
+        eos_static_err("error inserting fsid %lu into node %s",
+                       (unsigned long)fsid, node->mName.c_str());
+      }
+    }
+
+    // Update group view tree structure
+    if (FsView::gFsView.mGroupView.count(snapshot.mGroup)) {
+      FsGroup* group = FsView::gFsView.mGroupView[snapshot.mGroup];
+      eos_static_info("updating geotag of fsid %lu in group %s",
+                      (unsigned long)fsid, group->mName.c_str());
+
+      if (!static_cast<GeoTree*>(group)->erase(fsid)) {
+        eos_static_err("error removing fsid %lu from group %s",
+                       (unsigned long)fsid, group->mName.c_str());
+      }
+
+      if (!static_cast<GeoTree*>(group)->insert(fsid)) {
+        eos_static_err("error inserting fsid %lu into group %s",
+                       (unsigned long)fsid, group->mName.c_str());
+      }
+    }
+
+    // Update space view tree structure
+    if (FsView::gFsView.mSpaceView.count(snapshot.mSpace)) {
+      FsSpace* space = FsView::gFsView.mSpaceView[snapshot.mSpace];
+      eos_static_info("updating geotag of fsid %lu in space %s",
+                      (unsigned long)fsid, space->mName.c_str());
+
+      if (!static_cast<GeoTree*>(space)->erase(fsid)) {
+        eos_static_err("error removing fsid %lu from space %s",
+                       (unsigned long)fsid, space->mName.c_str());
+      }
+
+      if (!static_cast<GeoTree*>(space)->insert(fsid)) {
+        eos_static_err("error inserting fsid %lu into space %s",
+                       (unsigned long)fsid, space->mName.c_str());
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Make the GeoTreeEngine proxy trees match the proxygroups of the nodes
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::ApplyProxyGroupBatch(const std::vector<std::string>& queues)
+{
+  if (queues.empty()) {
+    return;
+  }
+
+  // This is a dataproxy / dataep status update, read the proxygroup lists
+  std::map<std::string, std::string> statuses;
+  {
+    eos::common::RWMutexReadLock hash_rd_lock(gOFS->ObjectManager.HashMutex);
+
+    for (const auto& queue : queues) {
+      XrdMqSharedHash* hash = gOFS->ObjectManager.GetObject(queue.c_str(), "hash");
+      std::string hostport = "/eos/" + queue.substr(queue.rfind('/') + 1) + "/fst";
+      statuses[hostport] = (hash ? hash->Get("proxygroups") : std::string());
+    }
+  }
+  // The fast structures are rebuilt by the GeoTreeEngine updater, once for
+  // all the nodes of the batch
+  eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
+
+  for (const auto& elem : statuses) {
+    if (eos::mgm::FsView::gFsView.mNodeView.count(elem.first)) {
+      eos::mgm::FsNode* node = eos::mgm::FsView::gFsView.mNodeView[elem.first];
+      eos::mgm::gGeoTreeEngine.matchHostPxyGr(node, elem.second, false, false);
+    } else {
+      eos_err("could not find the FsNode object associated with hostport %s",
+              elem.first.c_str());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Start or stop the drain of the file systems whose error changed
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::ApplyFsErrorBatch(const std::vector<std::string>& queues)
+{
+  if (queues.empty()) {
+    return;
+  }
+
+  std::vector<eos::common::FileSystem::fsid_t> to_drain;
+  std::vector<eos::common::FileSystem::fsid_t> to_stop;
+  {
+    // read the ids from the hashes and the current error values
+    eos::common::RWMutexReadLock hash_rd_lock(gOFS->ObjectManager.HashMutex);
+
+    for (const auto& queue : queues) {
+      XrdMqSharedHash* hash = gOFS->ObjectManager.GetObject(queue.c_str(), "hash");
+
+      if (!hash) {
+        continue;
+      }
+
+      eos::common::FileSystem::fsid_t fsid =
+        (eos::common::FileSystem::fsid_t) hash->GetLongLong("id");
+      long long errc = (int) hash->GetLongLong("stat.errc");
+      int cfgstatus = eos::common::FileSystem::GetConfigStatusFromString(
+                        hash->Get("configstatus").c_str());
+      int bstatus = eos::common::FileSystem::GetStatusFromString(
+                      hash->Get("stat.boot").c_str());
+
+      if (fsid && errc && (cfgstatus >= eos::common::FileSystem::kRO) &&
+          (bstatus == eos::common::FileSystem::kOpsError)) {
+        // Case when we take action and explicitly ask to start a drain job
+        to_drain.push_back(fsid);
+      }
+
+      if (fsid && (!errc)) {
+        // Make sure there is no drain job triggered by a previous filesystem
+        // errc!=0
+        to_stop.push_back(fsid);
+      }
+    }
+  }
+
+  if (to_drain.empty() && to_stop.empty()) {
+    return;
+  }
+
+  eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+
+  for (const auto fsid : to_drain) {
+    auto it_fs = FsView::gFsView.mIdView.find(fsid);
+
+    if (it_fs != FsView::gFsView.mIdView.end()) {
+      it_fs->second->SetConfigStatus(eos::common::FileSystem::kDrain);
+    }
+  }
+
+  for (const auto fsid : to_stop) {
+    auto it_fs = FsView::gFsView.mIdView.find(fsid);
+
+    if (it_fs != FsView::gFsView.mIdView.end()) {
+      it_fs->second->StopDrainJob();
+    }
   }
 }
@@ -134,7 +134,8 @@ XrdMgmOfs::FSctl(const int cmd,
                  const XrdSecEntity* client)
 {
   char ipath[16384];
-  char iopaque[16384];
+  // The opaque can carry a batch of commits, see CommitBatch
+  std::string iopaque;
   static const char* epname = "FSctl";
   const char* tident = error.getErrUser();
 
@@ -163,19 +164,16 @@ XrdMgmOfs::FSctl(const int cmd,
   }
 
   if (!fusexset && args.Arg2Len) {
-    if (args.Arg2Len < 16384) {
-      strncpy(iopaque, args.Arg2, args.Arg2Len);
-      iopaque[args.Arg2Len] = 0;
+    if (args.Arg2Len < kMaxFsctlOpaqueLen) {
+      iopaque.assign(args.Arg2, strnlen(args.Arg2, args.Arg2Len));
     } else {
       return gOFS->Emsg(epname, error, EINVAL,
                         "convert opaque argument - string too long", "");
     }
-  } else {
-    iopaque[0] = 0;
   }
 
   const char* inpath = ipath;
-  const char* ininfo = iopaque;
+  const char* ininfo = iopaque.c_str();
   // Do the id mapping with the opaque information
   eos::common::Mapping::VirtualIdentity vid;
   EXEC_TIMING_BEGIN("IdMap");
@@ -191,7 +189,7 @@ XrdMgmOfs::FSctl(const int cmd,
   // from here on we can deal with XrdOucString which is more 'comfortable'
   // ---------------------------------------------------------------------------
   XrdOucString spath = path;
-  XrdOucString opaque = iopaque;
+  XrdOucString opaque = iopaque.c_str();
   XrdOucString result = "";
   XrdOucEnv env(opaque.c_str());
   const char* scmd = env.Get("mgm.pcmd");
@@ -278,6 +276,10 @@ XrdMgmOfs::FSctl(const int cmd,
         return XrdMgmOfs::Commit(path, ininfo, env, error, ThreadLogId, vid,
                                client);
       }
+      case FsctlCommand::commitbatch: {
+        return XrdMgmOfs::CommitBatch(path, ininfo, env, error, ThreadLogId,
+                                      vid, client);
+      }
       case FsctlCommand::drop: {
         return XrdMgmOfs::Drop(path, ininfo, env, error, ThreadLogId, vid,
                              client);
@@ -660,6 +660,8 @@ XrdMgmOfs::_rename(const char* old_name,
               gOFS->FuseXCastContainer(newdir->getIdentifier());
               gOFS->FuseXCastRefresh(newdir->getIdentifier(), newdir->getParentIdentifier());
             }
+            // The subtree may now belong to a different quota node
+            Quota::InvalidateResponsibleCache();
           }
         }
 
@@ -104,58 +104,15 @@ XrdMgmOfs::ShouldStall(const char* function,
         stalltime = atoi(Access::gStallRules[std::string("w:*")].c_str());
         smsg = Access::gStallComment[std::string("w:*")];
       } else if (Access::gStallUserGroup) {
-        std::string usermatch = "rate:user:";
-        usermatch += vid.uid_string;
-        std::string groupmatch = "rate:group:";
-        groupmatch += vid.gid_string;
-        std::string userwildcardmatch = "rate:user:*";
-        std::string groupwildcardmatch = "rate:group:*";
-        std::map<std::string, std::string>::const_iterator it;
-
-        for (it = Access::gStallRules.begin();
-             it != Access::gStallRules.end();
-             it++) {
-          std::string cmd = it->first.substr(it->first.rfind(":") + 1);
-          double cutoff = strtod(it->second.c_str(), 0) * 1.33;
-
-          if ((it->first.find(userwildcardmatch) == 0)) {
-            // catch all rule = global user rate cut
-            XrdSysMutexHelper statLock(gOFS->MgmStats.mMutex);
-
-            if (gOFS->MgmStats.StatAvgUid.count(cmd) &&
-                gOFS->MgmStats.StatAvgUid[cmd].count(vid.uid) &&
-                (gOFS->MgmStats.StatAvgUid[cmd][vid.uid].GetAvg5() > cutoff)) {
-              stalltime = 5;
-              smsg = Access::gStallComment[it->first];
-            }
-          } else if ((it->first.find(groupwildcardmatch) == 0)) {
-            // catch all rule = global user rate cut
-            XrdSysMutexHelper statLock(gOFS->MgmStats.mMutex);
-
-            if (gOFS->MgmStats.StatAvgGid.count(cmd) &&
-                gOFS->MgmStats.StatAvgGid[cmd].count(vid.gid) &&
-                (gOFS->MgmStats.StatAvgGid[cmd][vid.gid].GetAvg5() > cutoff)) {
-              stalltime = 5;
-              smsg = Access::gStallComment[it->first];
-            }
-          } else if ((it->first.find(usermatch) == 0)) {
-            // check user rule
-            if (gOFS->MgmStats.StatAvgUid.count(cmd) &&
-                gOFS->MgmStats.StatAvgUid[cmd].count(vid.uid) &&
-                (gOFS->MgmStats.StatAvgUid[cmd][vid.uid].GetAvg5() > cutoff)) {
-              // rate exceeded
-              stalltime = 5;
-              smsg = Access::gStallComment[it->first];
-            }
-          } else if ((it->first.find(groupmatch) == 0)) {
-            // check group rule
-            if (gOFS->MgmStats.StatAvgGid.count(cmd) &&
-                gOFS->MgmStats.StatAvgGid[cmd].count(vid.gid) &&
-                (gOFS->MgmStats.StatAvgGid[cmd][vid.gid].GetAvg5() > cutoff)) {
-              // rate exceeded
-              stalltime = 5;
-              smsg = Access::gStallComment[it->first];
-            }
+        // RATE STALL - the stall time is given by the bucket deficit
+        std::string rule;
+        stalltime = Access::gRateLimiter.GetStallTime(vid.uid, vid.gid, rule);
+
+        if (stalltime) {
+          auto it = Access::gStallComment.find(rule);
+
+          if (it != Access::gStallComment.end()) {
+            smsg = it->second;
           }
         }
       }
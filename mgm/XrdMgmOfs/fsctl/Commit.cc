@@ -23,6 +23,7 @@
 
 #include "common/Logging.hh"
 #include "common/LayoutId.hh"
+#include "common/StringConversion.hh"
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/interface/IFileMDSvc.hh"
 #include "mgm/Stat.hh"
@@ -32,318 +33,389 @@
 #include "mgm/XrdMgmOfs/fsctl/CommitHelper.hh"
 
 #include <XrdOuc/XrdOucEnv.hh>
+#include <XrdOuc/XrdOucBuffer.hh>
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 //----------------------------------------------------------------------------
-// Commit a replica
+//! State of a replica commit between its stages
 //----------------------------------------------------------------------------
-int
-XrdMgmOfs::Commit(const char* path,
-                  const char* ininfo,
-                  XrdOucEnv& env,
-                  XrdOucErrInfo& error,
-                  eos::common::LogId& ThreadLogId,
-                  eos::common::Mapping::VirtualIdentity& vid,
-                  const XrdSecEntity* client)
+struct CommitState {
+  CommitHelper::cgi_t cgi;
+  CommitHelper::param_t params;
+  CommitHelper::option_t option;
+  CommitHelper::path_t paths;
+  char binchecksum[SHA_DIGEST_LENGTH] = {0};
+  unsigned long long size {0};
+  unsigned long long fid {0};
+  unsigned long fsid {0};
+  unsigned long mtime {0};
+  unsigned long mtimens {0};
+  std::string fmdname;
+};
+
+//----------------------------------------------------------------------------
+//! Parse and check a commit request, done before taking the namespace lock
+//!
+//! @return SFS_OK if the commit can be applied, otherwise SFS_ERROR
+//----------------------------------------------------------------------------
+static int
+CommitPrepare(XrdOucEnv& env, XrdOucErrInfo& error,
+              eos::common::LogId& ThreadLogId,
+              eos::common::Mapping::VirtualIdentity& vid, CommitState& st)
 {
   static const char* epname = "Commit";
-
-  REQUIRE_SSS_OR_LOCAL_AUTH;
-  ACCESSMODE_W;
-  MAYSTALL;
-  MAYREDIRECT;
-
-  EXEC_TIMING_BEGIN("Commit");
-
-  // Checksum string
-  char binchecksum[SHA_DIGEST_LENGTH];
-
   // Process CGI parameters
-  CommitHelper::cgi_t cgi;
-  CommitHelper::grab_cgi(env, cgi);
+  CommitHelper::grab_cgi(env, st.cgi);
 
   // Initialize logging
-  if (cgi.count("logid")) {
-    ThreadLogId.SetLogId(cgi["logid"].c_str(), error.getErrUser());
+  if (st.cgi.count("logid")) {
+    ThreadLogId.SetLogId(st.cgi["logid"].c_str(), error.getErrUser());
   }
 
   // OC parameters
-  CommitHelper::param_t params;
-  params["oc_n"] = 0;
-  params["oc_max"] = 0;
-
+  st.params["oc_n"] = 0;
+  st.params["oc_max"] = 0;
   // Selected options
-  CommitHelper::option_t option;
-  CommitHelper::set_options(option, cgi);
-
+  CommitHelper::set_options(st.option, st.cgi);
   // Check 'path' parameter
-  CommitHelper::path_t paths;
-  paths["atomic"] = std::string("");
+  st.paths["atomic"] = std::string("");
 
-  if (cgi.count("path")) {
-    paths["commit"] = cgi["path"];
+  if (st.cgi.count("path")) {
+    st.paths["commit"] = st.cgi["path"];
   }
 
   // Extract all OC upload relevant parameters
-  CommitHelper::init_oc(env, cgi, option, params);
+  CommitHelper::init_oc(env, st.cgi, st.option, st.params);
 
-  if (CommitHelper::is_reconstruction(option)) {
+  if (CommitHelper::is_reconstruction(st.option)) {
     // Remove checksum in case of a chunk reconstruction
     // (they have to be ignored)
-    cgi["checksum"] = "";
+    st.cgi["checksum"] = "";
   }
 
-  if (cgi["checksum"].length()) {
+  if (st.cgi["checksum"].length()) {
     // Compute binary checksum
-    CommitHelper::hex2bin_checksum(cgi["checksum"], binchecksum);
+    CommitHelper::hex2bin_checksum(st.cgi["checksum"], st.binchecksum);
   }
 
   // Check all commit required parameters are defined
-  if (CommitHelper::check_commit_params(cgi))
-  {
-    // Convert the main CGI parameters into numbers
-    unsigned long long size = std::stoull(cgi["size"]);
-    unsigned long long fid = strtoull(cgi["fid"].c_str(), 0, 16);
-    unsigned long fsid = std::stoul(cgi["fsid"]);
-    unsigned long mtime = std::stoul(cgi["mtime"]);
-    unsigned long mtimens = std::stoul(cgi["mtimensec"]);
-    std::string emsg;
-
-    CommitHelper::log_info(vid, ThreadLogId, cgi, option, params);
-
-    int rc = CommitHelper::check_filesystem(vid, ThreadLogId, fsid, cgi,
-                                            option, params, emsg);
+  if (!CommitHelper::check_commit_params(st.cgi)) {
+    int envlen = 0;
+    eos_thread_err("commit message does not contain all meta information: %s",
+                   env.Env(envlen));
+    gOFS->MgmStats.Add("CommitFailedParameters", 0, 0, 1);
+    const char* errtarget = "unknown";
+    const char* errmsg = "commit filesize change - size, fid, fsid, mtime, path not complete";
 
-    if (rc) {
-      return Emsg(epname, error, rc, emsg.c_str(), "");
+    if (st.cgi.count("path")) {
+      errmsg = "commit filesize change - size, fid, fsid, mtime not complete";
+      errtarget = st.cgi["path"].c_str();
     }
 
-    // Create a checksum buffer object
-    eos::Buffer checksumbuffer;
-    checksumbuffer.putData(binchecksum, SHA_DIGEST_LENGTH);
-
-    // Attempt file meta data retrieval
-    std::shared_ptr<eos::IFileMD> fmd;
-    eos::IContainerMD::id_t cid = 0;
-    std::string fmdname;
-    {
-      // Keep the lock order View => Namespace => Quota
-      eos::common::RWMutexWriteLock nslock(gOFS->eosViewRWMutex);
-      errno = 0;
-
-      try {
-        fmd = gOFS->eosFileService->getFileMD(fid);
-      } catch (eos::MDException& e) {
-        errno = e.getErrno();
-        eos_thread_debug("msg=\"exception\" ec=%d emsg=\"%s\"",
-                         e.getErrno(), e.getMessage().str().c_str());
-        emsg = "retc=";
-        emsg += e.getErrno();
-        emsg += " msg=";
-        emsg += e.getMessage().str().c_str();
-      }
+    return gOFS->Emsg(epname, error, EINVAL, errmsg, errtarget);
+  }
 
-      if (!fmd) {
-        if (errno == ENOENT) {
-          return Emsg(epname, error, ENOENT,
-                      "commit filesize change - file is already removed [EIDRM]", "");
-        }
+  // Convert the main CGI parameters into numbers
+  st.size = std::stoull(st.cgi["size"]);
+  st.fid = strtoull(st.cgi["fid"].c_str(), 0, 16);
+  st.fsid = std::stoul(st.cgi["fsid"]);
+  st.mtime = std::stoul(st.cgi["mtime"]);
+  st.mtimens = std::stoul(st.cgi["mtimensec"]);
+  std::string emsg;
+  CommitHelper::log_info(vid, ThreadLogId, st.cgi, st.option, st.params);
+  int rc = CommitHelper::check_filesystem(vid, ThreadLogId, st.fsid, st.cgi,
+                                          st.option, st.params, emsg);
+
+  if (rc) {
+    return gOFS->Emsg(epname, error, rc, emsg.c_str(), "");
+  }
 
-        emsg.insert(0, "commit filesize change [EIO]");
-        return Emsg(epname, error, errno, emsg.c_str(), cgi["path"].c_str());
-      }
+  return SFS_OK;
+}
 
-      unsigned long lid = fmd->getLayoutId();
+//----------------------------------------------------------------------------
+//! Apply a commit to the file metadata, the caller holds the namespace write
+//! lock
+//!
+//! @return SFS_OK if successful, otherwise SFS_ERROR
+//----------------------------------------------------------------------------
+static int
+CommitApply(XrdOucErrInfo& error, eos::common::LogId& ThreadLogId,
+            eos::common::Mapping::VirtualIdentity& vid, CommitState& st)
+{
+  static const char* epname = "Commit";
+  CommitHelper::cgi_t& cgi = st.cgi;
+  CommitHelper::option_t& option = st.option;
+  const unsigned long long fid = st.fid;
+  const unsigned long fsid = st.fsid;
+  const unsigned long long size = st.size;
+  // Create a checksum buffer object
+  eos::Buffer checksumbuffer;
+  checksumbuffer.putData(st.binchecksum, SHA_DIGEST_LENGTH);
+  // Attempt file meta data retrieval
+  std::shared_ptr<eos::IFileMD> fmd;
+  eos::IContainerMD::id_t cid = 0;
+  std::string emsg;
+  errno = 0;
+
+  try {
+    fmd = gOFS->eosFileService->getFileMD(fid);
+  } catch (eos::MDException& e) {
+    errno = e.getErrno();
+    eos_thread_debug("msg=\"exception\" ec=%d emsg=\"%s\"",
+                     e.getErrno(), e.getMessage().str().c_str());
+    emsg = "retc=";
+    emsg += e.getErrno();
+    emsg += " msg=";
+    emsg += e.getMessage().str().c_str();
+  }
 
-      // Check if fsid and fid are ok
-      if (fmd->getId() != fid) {
-        eos_thread_notice("commit for fid=%llu != fmd_fid=%llu",
-                          fid, fmd->getId());
+  if (!fmd) {
+    if (errno == ENOENT) {
+      return gOFS->Emsg(epname, error, ENOENT,
+                        "commit filesize change - file is already removed [EIDRM]", "");
+    }
 
-        gOFS->MgmStats.Add("CommitFailedFid", 0, 0, 1);
-        return Emsg(epname, error, EINVAL,
-                    "commit filesize change - file id is wrong [EINVAL]",
-                    cgi["path"].c_str());
-      }
+    emsg.insert(0, "commit filesize change [EIO]");
+    return gOFS->Emsg(epname, error, errno, emsg.c_str(), cgi["path"].c_str());
+  }
 
-      // Check if file is already unlinked from the visible namespace
-      if (!(cid = fmd->getContainerId())) {
-        eos_thread_debug("commit for fid=%llu but file is disconnected "
-                         "from any container", fmd->getId());
+  unsigned long lid = fmd->getLayoutId();
 
-        gOFS->MgmStats.Add("CommitFailedUnlinked", 0, 0, 1);
-        return Emsg(epname, error, EIDRM,
-                    "commit filesize change - file is already removed [EIDRM]", "");
-      }
+  // Check if fsid and fid are ok
+  if (fmd->getId() != fid) {
+    eos_thread_notice("commit for fid=%llu != fmd_fid=%llu",
+                      fid, fmd->getId());
+    gOFS->MgmStats.Add("CommitFailedFid", 0, 0, 1);
+    return gOFS->Emsg(epname, error, EINVAL,
+                      "commit filesize change - file id is wrong [EINVAL]",
+                      cgi["path"].c_str());
+  }
 
-      // Check if commit comes from a replication procedure
-      // and if the size/checksum is ok
-      if (option["replication"]) {
-        CommitHelper::remove_scheduler(fid);
-
-        // Check if we have this replica in the unlink list
-        if (option["fusex"] && fmd->hasUnlinkedLocation((unsigned int) fsid)) {
-          eos_thread_err("suppressing possible recovery replica for fid=%llu "
-                         "on unlinked fsid=%llu - rejecting replica",
-                         fmd->getId(), fsid);
-
-          // This happens when a FUSEX recovery has been triggered.
-          // To avoid to reattach replicas, we clean them up here
-          return Emsg(epname, error, EBADE,
-                      "commit replica - file size is wrong [EBADE] "
-                      "- suppressing recovery replica", "");
-        }
-
-        if (eos::common::LayoutId::GetLayoutType(lid) ==
-            eos::common::LayoutId::kReplica) {
-          // We check filesize and the checksum only for replica layouts
-          eos_thread_debug("fmd_size=%llu, size=%lli", fmd->getSize(), size);
-
-          // Validate size parameters
-          if (!CommitHelper::validate_size(vid, ThreadLogId, fmd, fsid, size)) {
-            return Emsg(epname, error, EBADE,
-                        "commit replica - file size is wrong [EBADE]", "");
-          }
-
-          // Validate checksum parameters
-          if (option["verifychecksum"] &&
-              !CommitHelper::validate_checksum(vid, ThreadLogId, fmd,
-                                               checksumbuffer, fsid)) {
-            return Emsg(epname, error, EBADR,
-                        "commit replica - file checksum is wrong [EBADR]", "");
-          }
-        }
-      }
+  // Check if file is already unlinked from the visible namespace
+  if (!(cid = fmd->getContainerId())) {
+    eos_thread_debug("commit for fid=%llu but file is disconnected "
+                     "from any container", fmd->getId());
+    gOFS->MgmStats.Add("CommitFailedUnlinked", 0, 0, 1);
+    return gOFS->Emsg(epname, error, EIDRM,
+                      "commit filesize change - file is already removed [EIDRM]", "");
+  }
 
-      if (option["verifysize"]) {
-        // Check if a file size change was detected
-        if (fmd->getSize() != size) {
-          eos_thread_err("commit for fid=%llu gave a file size change after "
-                         "verification on fsid=%llu", fmd->getId(), fsid);
-        }
-      }
+  // Check if commit comes from a replication procedure
+  // and if the size/checksum is ok
+  if (option["replication"]) {
+    CommitHelper::remove_scheduler(fid);
+
+    // Check if we have this replica in the unlink list
+    if (option["fusex"] && fmd->hasUnlinkedLocation((unsigned int) fsid)) {
+      eos_thread_err("suppressing possible recovery replica for fid=%llu "
+                     "on unlinked fsid=%llu - rejecting replica",
+                     fmd->getId(), fsid);
+      // This happens when a FUSEX recovery has been triggered.
+      // To avoid to reattach replicas, we clean them up here
+      return gOFS->Emsg(epname, error, EBADE,
+                        "commit replica - file size is wrong [EBADE] "
+                        "- suppressing recovery replica", "");
+    }
 
-      if (option["verifychecksum"]) {
-        CommitHelper::log_verifychecksum(vid, ThreadLogId, fmd, checksumbuffer,
-                                         fsid, cgi, option);
-      }
+    if (eos::common::LayoutId::GetLayoutType(lid) ==
+        eos::common::LayoutId::kReplica) {
+      // We check filesize and the checksum only for replica layouts
+      eos_thread_debug("fmd_size=%llu, size=%lli", fmd->getSize(), size);
 
-      if (!CommitHelper::handle_location(vid, ThreadLogId, cid, fmd, fsid, size,
-                                         cgi, option)) {
-        return Emsg(epname, error, EIDRM,
-                    "commit file, parent container removed [EIDRM]", "");
+      // Validate size parameters
+      if (!CommitHelper::validate_size(vid, ThreadLogId, fmd, fsid, size)) {
+        return gOFS->Emsg(epname, error, EBADE,
+                          "commit replica - file size is wrong [EBADE]", "");
       }
 
-      // Advance oc upload parameters if concerned
-      CommitHelper::handle_occhunk(vid, ThreadLogId, fmd, option, params);
-
-      // Set checksum if concerned
-      CommitHelper::handle_checksum(vid, ThreadLogId, fmd, option, checksumbuffer);
-
-      fmdname = fmd->getName();
-      paths["atomic"].Init(fmdname.c_str());
-      paths["atomic"].DecodeAtomicPath(option["versioning"]);
-      option["atomic"] = (paths["atomic"].GetName() != fmdname);
-
-      if (option["update"] && mtime) {
-        // Update the modification time only if the file contents changed and
-        // mtime != 0
-        // - FUSE clients will commit mtime=0 to indicate they call utimes anyway
-        // - OC clients set the mtime during a commit
-        if (!option["atomic"] || option["occhunk"]) {
-          eos::IFileMD::ctime_t mt;
-          mt.tv_sec = mtime;
-          mt.tv_nsec = mtimens;
-          fmd->setMTime(mt);
-        }
+      // Validate checksum parameters
+      if (option["verifychecksum"] &&
+          !CommitHelper::validate_checksum(vid, ThreadLogId, fmd,
+                                           checksumbuffer, fsid)) {
+        return gOFS->Emsg(epname, error, EBADR,
+                          "commit replica - file checksum is wrong [EBADR]", "");
       }
+    }
+  }
+
+  if (option["verifysize"]) {
+    // Check if a file size change was detected
+    if (fmd->getSize() != size) {
+      eos_thread_err("commit for fid=%llu gave a file size change after "
+                     "verification on fsid=%llu", fmd->getId(), fsid);
+    }
+  }
 
-      eos_thread_debug("commit: setting size to %llu", fmd->getSize());
+  if (option["verifychecksum"]) {
+    CommitHelper::log_verifychecksum(vid, ThreadLogId, fmd, checksumbuffer,
+                                     fsid, cgi, option);
+  }
 
-      if (!CommitHelper::commit_fmd(vid, ThreadLogId, cid, fmd, option, emsg)) {
-        return Emsg(epname, error, errno, "commit filesize change", emsg.c_str());
-      }
+  if (!CommitHelper::handle_location(vid, ThreadLogId, cid, fmd, fsid, size,
+                                     cgi, option)) {
+    return gOFS->Emsg(epname, error, EIDRM,
+                      "commit file, parent container removed [EIDRM]", "");
+  }
 
-      gOFS->mTapeAwareGc.fileReplicaCommitted(cgi["path"], *fmd);
+  // Advance oc upload parameters if concerned
+  CommitHelper::handle_occhunk(vid, ThreadLogId, fmd, option, st.params);
+  // Set checksum if concerned
+  CommitHelper::handle_checksum(vid, ThreadLogId, fmd, option, checksumbuffer);
+  st.fmdname = fmd->getName();
+  st.paths["atomic"].Init(st.fmdname.c_str());
+  st.paths["atomic"].DecodeAtomicPath(option["versioning"]);
+  option["atomic"] = (st.paths["atomic"].GetName() != st.fmdname);
+
+  if (option["update"] && st.mtime) {
+    // Update the modification time only if the file contents changed and
+    // mtime != 0
+    // - FUSE clients will commit mtime=0 to indicate they call utimes anyway
+    // - OC clients set the mtime during a commit
+    if (!option["atomic"] || option["occhunk"]) {
+      eos::IFileMD::ctime_t mt;
+      mt.tv_sec = st.mtime;
+      mt.tv_nsec = st.mtimens;
+      fmd->setMTime(mt);
     }
+  }
 
-    {
-      eos::common::Mapping::VirtualIdentity rootvid;
-      eos::common::Mapping::Root(rootvid);
-
-      // Path of a previous version existing before an atomic/versioning upload
-      std::string delete_path = "";
-      eos_thread_info("commitsize=%d n1=%s n2=%s occhunk=%d ocdone=%d",
-                      option["commitsize"],
-                      fmdname.c_str(), paths["atomic"].GetName(),
-                      option["occhunk"], option["ocdone"]);
-
-      // -----------------------------------------------------------------------
-      // We are asked to commit the size and this commit changes the current
-      // atomic name to the final name and we are not an OC upload
-      // -----------------------------------------------------------------------
-      if ((option["commitsize"]) && (fmdname != paths["atomic"].GetName()) &&
-          (!option["occhunk"] || option["ocdone"])) {
-        eos_thread_info("commit: de-atomize file %s => %s",
-                        fmdname.c_str(), paths["atomic"].GetName());
-
-        unsigned long long vfid =
-            CommitHelper::get_version_fid(vid, ThreadLogId, fid, paths, option);
-
-        // Check for versioning request
-        if (option["versioning"]) {
-          eos_static_info("checked %s%s vfid=%llu",
-                          paths["versiondir"].GetParentPath(),
-                          paths["atomic"].GetPath(),
-                          vfid);
-
-          // We purged the versions before during open, so we just simulate
-          // a new one and do the final rename in a transaction
-          if (vfid) {
-            XrdOucString versionedname = "";
-
-            gOFS->Version(vfid, error, rootvid, 0xffff, &versionedname, true);
-            paths["version"].Init(versionedname.c_str());
-          }
-        }
-
-        CommitHelper::handle_versioning(vid, ThreadLogId, fid, paths,
-                                        option, delete_path);
-      }
+  eos_thread_debug("commit: setting size to %llu", fmd->getSize());
 
-      // -----------------------------------------------------------------------
-      // If there was a previous target file we have to delete the renamed
-      // atomic left-over
-      // -----------------------------------------------------------------------
-      if (delete_path.length()) {
-        delete_path.insert(0, paths["versiondir"].GetParentPath());
-        eos_thread_info("msg=\"delete path\" path=%s", delete_path.c_str());
-
-        if (gOFS->_rem(delete_path.c_str(), error, rootvid, "")) {
-          eos_thread_err("msg=\"failed to remove atomic left-over\" path=%s",
-                         delete_path.c_str());
-        }
-      }
+  if (!CommitHelper::commit_fmd(vid, ThreadLogId, cid, fmd, option, emsg)) {
+    return gOFS->Emsg(epname, error, errno, "commit filesize change",
+                      emsg.c_str());
+  }
+
+  gOFS->mTapeAwareGc.fileReplicaCommitted(cgi["path"], *fmd);
+  return SFS_OK;
+}
 
-      if (option["abort"]) {
-        return Emsg(epname, error, EREMCHG, "commit replica - overlapping "
-                    "atomic upload - discarding atomic upload [EREMCHG]", "");
+//----------------------------------------------------------------------------
+//! Finish a commit after the namespace lock was released: de-atomize the
+//! file and take care of the versions
+//!
+//! @return SFS_OK if successful, otherwise SFS_ERROR
+//----------------------------------------------------------------------------
+static int
+CommitFinish(XrdOucErrInfo& error, eos::common::LogId& ThreadLogId,
+             eos::common::Mapping::VirtualIdentity& vid, CommitState& st)
+{
+  static const char* epname = "Commit";
+  CommitHelper::option_t& option = st.option;
+  CommitHelper::path_t& paths = st.paths;
+  eos::common::Mapping::VirtualIdentity rootvid;
+  eos::common::Mapping::Root(rootvid);
+  // Path of a previous version existing before an atomic/versioning upload
+  std::string delete_path = "";
+  eos_thread_info("commitsize=%d n1=%s n2=%s occhunk=%d ocdone=%d",
+                  option["commitsize"],
+                  st.fmdname.c_str(), paths["atomic"].GetName(),
+                  option["occhunk"], option["ocdone"]);
+
+  // -------------------------------------------------------------------------
+  // We are asked to commit the size and this commit changes the current
+  // atomic name to the final name and we are not an OC upload
+  // -------------------------------------------------------------------------
+  if ((option["commitsize"]) && (st.fmdname != paths["atomic"].GetName()) &&
+      (!option["occhunk"] || option["ocdone"])) {
+    eos_thread_info("commit: de-atomize file %s => %s",
+                    st.fmdname.c_str(), paths["atomic"].GetName());
+    unsigned long long vfid =
+      CommitHelper::get_version_fid(vid, ThreadLogId, st.fid, paths, option);
+
+    // Check for versioning request
+    if (option["versioning"]) {
+      eos_static_info("checked %s%s vfid=%llu",
+                      paths["versiondir"].GetParentPath(),
+                      paths["atomic"].GetPath(),
+                      vfid);
+
+      // We purged the versions before during open, so we just simulate
+      // a new one and do the final rename in a transaction
+      if (vfid) {
+        XrdOucString versionedname = "";
+        gOFS->Version(vfid, error, rootvid, 0xffff, &versionedname, true);
+        paths["version"].Init(versionedname.c_str());
       }
     }
-  } else
-  {
-    int envlen = 0;
-    eos_thread_err("commit message does not contain all meta information: %s",
-                   env.Env(envlen));
-    gOFS->MgmStats.Add("CommitFailedParameters", 0, 0, 1);
 
-    const char* errtarget = "unknown";
-    const char* errmsg = "commit filesize change - size, fid, fsid, mtime, path not complete";
-    if (cgi.count("path")) {
-      errmsg = "commit filesize change - size, fid, fsid, mtime not complete";
-      errtarget = cgi["path"].c_str();
+    CommitHelper::handle_versioning(vid, ThreadLogId, st.fid, paths,
+                                    option, delete_path);
+  }
+
+  // -------------------------------------------------------------------------
+  // If there was a previous target file we have to delete the renamed
+  // atomic left-over
+  // -------------------------------------------------------------------------
+  if (delete_path.length()) {
+    delete_path.insert(0, paths["versiondir"].GetParentPath());
+    eos_thread_info("msg=\"delete path\" path=%s", delete_path.c_str());
+
+    if (gOFS->_rem(delete_path.c_str(), error, rootvid, "")) {
+      eos_thread_err("msg=\"failed to remove atomic left-over\" path=%s",
+                     delete_path.c_str());
     }
+  }
 
-    return Emsg(epname, error, EINVAL, errmsg, errtarget);
+  if (option["abort"]) {
+    return gOFS->Emsg(epname, error, EREMCHG, "commit replica - overlapping "
+                      "atomic upload - discarding atomic upload [EREMCHG]", "");
+  }
+
+  return SFS_OK;
+}
+
+//----------------------------------------------------------------------------
+//! Handle a failed commit. A fusex client closing the file asynchronously did
+//! not wait for the commit, release the caps of the file so that the clients
+//! drop their cached meta data and see the state of the namespace.
+//----------------------------------------------------------------------------
+static void
+CommitFailed(CommitState& st)
+{
+  if (st.option["fusexasync"] && st.fid) {
+    gOFS->FuseXCastFile(eos::FileIdentifier(st.fid));
+  }
+}
+
+//----------------------------------------------------------------------------
+// Commit a replica
+//----------------------------------------------------------------------------
+int
+XrdMgmOfs::Commit(const char* path,
+                  const char* ininfo,
+                  XrdOucEnv& env,
+                  XrdOucErrInfo& error,
+                  eos::common::LogId& ThreadLogId,
+                  eos::common::Mapping::VirtualIdentity& vid,
+                  const XrdSecEntity* client)
+{
+  REQUIRE_SSS_OR_LOCAL_AUTH;
+  ACCESSMODE_W;
+  MAYSTALL;
+  MAYREDIRECT;
+
+  EXEC_TIMING_BEGIN("Commit");
+  CommitState st;
+
+  if (CommitPrepare(env, error, ThreadLogId, vid, st)) {
+    CommitFailed(st);
+    return SFS_ERROR;
+  }
+
+  int rc = SFS_OK;
+  {
+    // Keep the lock order View => Namespace => Quota
+    eos::common::RWMutexWriteLock nslock(gOFS->eosViewRWMutex);
+    rc = CommitApply(error, ThreadLogId, vid, st);
+  }
+
+  if (rc || CommitFinish(error, ThreadLogId, vid, st)) {
+    CommitFailed(st);
+    return SFS_ERROR;
   }
 
   gOFS->MgmStats.Add("Commit", 0, 0, 1);
@@ -352,3 +424,100 @@ XrdMgmOfs::Commit(const char* path,
   EXEC_TIMING_END("Commit");
   return SFS_DATA;
 }
+
+//----------------------------------------------------------------------------
+// Commit a batch of replicas
+//----------------------------------------------------------------------------
+int
+XrdMgmOfs::CommitBatch(const char* path,
+                       const char* ininfo,
+                       XrdOucEnv& env,
+                       XrdOucErrInfo& error,
+                       eos::common::LogId& ThreadLogId,
+                       eos::common::Mapping::VirtualIdentity& vid,
+                       const XrdSecEntity* client)
+{
+  static const char* epname = "CommitBatch";
+
+  REQUIRE_SSS_OR_LOCAL_AUTH;
+  ACCESSMODE_W;
+  MAYSTALL;
+  MAYREDIRECT;
+
+  EXEC_TIMING_BEGIN("CommitBatch");
+  const char* snum = env.Get("mgm.batch.n");
+  size_t num = (snum ? strtoul(snum, 0, 10) : 0);
+
+  if ((num == 0) || (num > kMaxCommitBatch)) {
+    return Emsg(epname, error, EINVAL, "commit batch - wrong number of "
+                "entries [EINVAL]", "");
+  }
+
+  std::vector<CommitState> states(num);
+  std::vector<std::unique_ptr<XrdOucErrInfo>> errors;
+  std::vector<int> rcs(num, SFS_OK);
+
+  for (size_t i = 0; i < num; ++i) {
+    errors.emplace_back(new XrdOucErrInfo(error.getErrUser()));
+    std::string key = "mgm.batch." + std::to_string(i);
+    const char* sealed = env.Get(key.c_str());
+
+    if (sealed == nullptr) {
+      rcs[i] = Emsg("Commit", *errors[i], EINVAL, "commit batch - missing "
+                    "entry [EINVAL]", "");
+      continue;
+    }
+
+    std::string entry = eos::common::StringConversion::UnsealXrdOpaque(sealed);
+    XrdOucEnv entry_env(entry.c_str());
+    rcs[i] = CommitPrepare(entry_env, *errors[i], ThreadLogId, vid, states[i]);
+  }
+
+  {
+    // One namespace lock acquisition for the whole batch, keep the lock
+    // order View => Namespace => Quota
+    eos::common::RWMutexWriteLock nslock(gOFS->eosViewRWMutex);
+
+    for (size_t i = 0; i < num; ++i) {
+      if (rcs[i] == SFS_OK) {
+        rcs[i] = CommitApply(*errors[i], ThreadLogId, vid, states[i]);
+      }
+    }
+  }
+
+  // One line per entry: <errno> [<error message>]
+  std::string response = "OK";
+
+  for (size_t i = 0; i < num; ++i) {
+    if (rcs[i] == SFS_OK) {
+      rcs[i] = CommitFinish(*errors[i], ThreadLogId, vid, states[i]);
+    }
+
+    if (rcs[i] == SFS_OK) {
+      gOFS->MgmStats.Add("Commit", 0, 0, 1);
+      response += "\n0";
+    } else {
+      CommitFailed(states[i]);
+      std::string msg = errors[i]->getErrText();
+      std::replace(msg.begin(), msg.end(), '\n', ' ');
+      response += "\n";
+      response += std::to_string(errors[i]->getErrInfo() ?
+                                 errors[i]->getErrInfo() : EIO);
+      response += " ";
+      response += msg;
+    }
+  }
+
+  gOFS->MgmStats.Add("CommitBatch", 0, 0, 1);
+  char* buffer = (char*) malloc(response.length() + 1);
+
+  if (buffer == nullptr) {
+    return Emsg(epname, error, ENOMEM, "commit batch - out of memory", "");
+  }
+
+  memcpy(buffer, response.c_str(), response.length() + 1);
+  XrdOucBuffer* buff = new XrdOucBuffer(buffer, response.length() + 1);
+  error.setErrInfo(response.length() + 1, buff);
+  EXEC_TIMING_END("CommitBatch");
+  return SFS_DATA;
+}
@@ -169,6 +169,10 @@ CommitHelper::grab_cgi(XrdOucEnv& env, CommitHelper::cgi_t& cgi)
     cgi["fusex"] = env.Get("mgm.fusex");
   }
 
+  if (env.Get("mgm.fusex.async")) {
+    cgi["fusexasync"] = env.Get("mgm.fusex.async");
+  }
+
   if (env.Get("mgm.checksum")) {
     cgi["checksum"] = env.Get("mgm.checksum");
   }
@@ -235,6 +239,7 @@ CommitHelper::set_options(CommitHelper::option_t& option,
   option["reconstruction"] = (cgi["reconstruction"] == "1");
   option["modified"] = (cgi["ismodified"] == "1");
   option["fusex"] = (cgi["fusex"] == "1");
+  option["fusexasync"] = (cgi["fusexasync"] == "1");
   option["abort"] = false; // indicate to abort a commit
   option["versioning"] = false; // indicate versioning
   option["atomic"] = false; // indicate an atomic upload
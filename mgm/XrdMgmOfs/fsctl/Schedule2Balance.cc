@@ -36,11 +36,19 @@
 #include "mgm/FsView.hh"
 
 #include <XrdOuc/XrdOucEnv.hh>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 //----------------------------------------------------------------------------
 // Utility functions to help with file balance scheduling
 //----------------------------------------------------------------------------
 namespace {
+  // Max number of jobs scheduled by one request
+  constexpr unsigned long kMaxBatchJobs = 256;
+  // Max number of seconds a request waits for a job to become available
+  constexpr long kMaxWaitSec = 30;
+
   // Build general transfer capability string
   XrdOucString constructCapability(unsigned long lid, unsigned long long cid,
                                    const char* path, unsigned long long fid,
@@ -215,6 +223,16 @@ XrdMgmOfs::Schedule2Balance(const char* path,
   char* simulate = env.Get("mgm.simulate"); // Used to test the routing
   char* afsid = env.Get("mgm.target.fsid");
   char* afreebytes = env.Get("mgm.target.freebytes");
+  // A batching FST asks for up to mgm.njobs jobs and waits up to mgm.wait
+  // seconds for the first one, the old FSTs get a single job per request
+  char* anjobs = env.Get("mgm.njobs");
+  char* await = env.Get("mgm.wait");
+  unsigned long njobs = (anjobs ? strtoul(anjobs, 0, 10) : 1);
+  long wait_sec = (await ? strtol(await, 0, 10) : 0);
+  njobs = std::min(std::max(njobs, 1ul), kMaxBatchJobs);
+  time_t deadline = time(NULL) + std::min(std::max(wait_sec, 0l), kMaxWaitSec);
+  unsigned long nsubmitted = 0;
+  bool retry = false;
 
   if (alogid) {
     ThreadLogId.SetLogId(alogid, error.getErrUser());
@@ -238,13 +256,19 @@ XrdMgmOfs::Schedule2Balance(const char* path,
 
   unsigned long long freebytes = strtoull(afreebytes, 0, 10);
 
-  eos_thread_info("cmd=schedule2balance fsid=%u freebytes=%llu logid=%s",
-                  target_fsid, freebytes, alogid ? alogid : "");
+  eos_thread_info("cmd=schedule2balance fsid=%u freebytes=%llu njobs=%lu "
+                  "wait=%li logid=%s", target_fsid, freebytes, njobs, wait_sec,
+                  alogid ? alogid : "");
 
-  // Lock the view and get the filesystem information
-  // for the target where we balance to
+  // Lock the view and get the filesystem information for the target where
+  // we balance to, retry every second until a job is found or the wait is over
   while (1)
   {
+    if (retry) {
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    retry = true;
     eos::common::RWMutexReadLock vlock(FsView::gFsView.ViewMutex);
     eos::common::FileSystem* target_fs = 0;
 
@@ -345,6 +369,10 @@ XrdMgmOfs::Schedule2Balance(const char* path,
     }
 
     if (!source_fs) {
+      if ((time(NULL) < deadline) && !gOFS->Shutdown) {
+        continue;
+      }
+
       eos_thread_debug("no source available");
       gOFS->MgmStats.Add("SchedulingFailedBalance", 0, 0, 1);
       error.setErrInfo(0, "");
@@ -493,6 +521,13 @@ XrdMgmOfs::Schedule2Balance(const char* path,
                                    target_snapshot.mHostPort.c_str(),
                                    fid, full_capability, capError);
       if (rc) {
+        if (nsubmitted) {
+          // Return the jobs of the batch which are already queued
+          eos_thread_err("unable to create %s capability - ec=%d",
+                         capError.getErrText(), capError.getErrInfo());
+          break;
+        }
+
         std::ostringstream errstream;
         errstream << "create " << capError.getErrText()
                   << " capability [EADV]";
@@ -504,8 +539,6 @@ XrdMgmOfs::Schedule2Balance(const char* path,
       }
 
       ScheduledToBalanceFid[fid] = time(NULL) + 3600;
-      XrdOucString response = "submitted";
-      error.setErrInfo(response.length() + 1, response.c_str());
 
       if (!simulate) {
         std::unique_ptr<eos::common::TransferJob>
@@ -518,16 +551,35 @@ XrdMgmOfs::Schedule2Balance(const char* path,
         } else {
           eos_thread_err("cmd=schedule2balance msg=\"failed to submit job\""
                          " job=%s", full_capability.c_str());
-          error.setErrInfo(0, "");
+          continue;
         }
       }
 
-      gOFS->MgmStats.Add("Scheduled2Balance", 0, 0, 1);
-      EXEC_TIMING_END("Scheduled2Balance");
-      return SFS_DATA;
+      // The rest of the batch has to fit in the free space as well
+      freebytes -= size;
+
+      if (++nsubmitted == njobs) {
+        break;
+      }
+    }
+
+    if (nsubmitted || (time(NULL) >= deadline) || gOFS->Shutdown) {
+      break;
+    }
+  }
+
+  if (nsubmitted) {
+    XrdOucString response = "submitted";
+
+    if (anjobs) {
+      response += ":";
+      response += (int) nsubmitted;
     }
 
-    break;
+    error.setErrInfo(response.length() + 1, response.c_str());
+    gOFS->MgmStats.Add("Scheduled2Balance", 0, 0, nsubmitted);
+    EXEC_TIMING_END("Scheduled2Balance");
+    return SFS_DATA;
   }
 
   gOFS->MgmStats.Add("SchedulingFailedBalance", 0, 0, 1);
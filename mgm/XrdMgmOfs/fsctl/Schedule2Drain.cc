@@ -39,11 +39,19 @@
 #include "mgm/Quota.hh"
 
 #include <XrdOuc/XrdOucEnv.hh>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 //----------------------------------------------------------------------------
 // Utility functions to help with file drain scheduling
 //----------------------------------------------------------------------------
 namespace {
+  // Max number of jobs scheduled by one request
+  constexpr unsigned long kMaxBatchJobs = 256;
+  // Max number of seconds a request waits for a job to become available
+  constexpr long kMaxWaitSec = 30;
+
   // Build general transfer capability string
   XrdOucString constructCapability(unsigned long lid, unsigned long long cid,
                                   const char* path, unsigned long long fid,
@@ -338,6 +346,16 @@ XrdMgmOfs::Schedule2Drain(const char* path,
 
   const char* afsid = env.Get("mgm.target.fsid");
   const char* afreebytes = env.Get("mgm.target.freebytes");
+  // A batching FST asks for up to mgm.njobs jobs and waits up to mgm.wait
+  // seconds for the first one, the old FSTs get a single job per request
+  const char* anjobs = env.Get("mgm.njobs");
+  const char* await = env.Get("mgm.wait");
+  unsigned long njobs = (anjobs ? strtoul(anjobs, 0, 10) : 1);
+  long wait_sec = (await ? strtol(await, 0, 10) : 0);
+  njobs = std::min(std::max(njobs, 1ul), kMaxBatchJobs);
+  time_t deadline = time(NULL) + std::min(std::max(wait_sec, 0l), kMaxWaitSec);
+  unsigned long nsubmitted = 0;
+  bool retry = false;
 
   if (!afsid || !afreebytes) {
     int envlen;
@@ -359,366 +377,414 @@ XrdMgmOfs::Schedule2Drain(const char* path,
 
   unsigned long long freebytes = strtoull(afreebytes, 0, 10);
 
-  eos_thread_info("cmd=schedule2drain fsid=%u freebytes=%llu logid=%s",
-                  target_fsid, freebytes, alogid ? alogid : "");
+  eos_thread_info("cmd=schedule2drain fsid=%u freebytes=%llu njobs=%lu "
+                  "wait=%li logid=%s", target_fsid, freebytes, njobs, wait_sec,
+                  alogid ? alogid : "");
 
-  // Retrieve filesystem information about the drain target
-  eos::common::RWMutexReadLock vlock(FsView::gFsView.ViewMutex);
-  target_fs = FsView::gFsView.mIdView[target_fsid];
+  // Retrieve filesystem information about the drain target, retry every
+  // second until a job is found or the wait is over
+  while (1) {
+    if (retry) {
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
 
-  if (!target_fs) {
-    eos_thread_err("fsid=%u is not in filesystem view", target_fsid);
-    gOFS->MgmStats.Add("SchedulingFailedDrain", 0, 0, 1);
-    return Emsg(epname, error, EINVAL,
-                "schedule - filesystem ID is not known [EINVAL]");
-  }
+    retry = true;
+    eos::common::RWMutexReadLock vlock(FsView::gFsView.ViewMutex);
+    target_fs = FsView::gFsView.mIdView[target_fsid];
 
-  target_fs->SnapShotFileSystem(target_snapshot);
-  FsGroup* group = FsView::gFsView.mGroupView[target_snapshot.mGroup];
+    if (!target_fs) {
+      eos_thread_err("fsid=%u is not in filesystem view", target_fsid);
+      gOFS->MgmStats.Add("SchedulingFailedDrain", 0, 0, 1);
+      return Emsg(epname, error, EINVAL,
+                  "schedule - filesystem ID is not known [EINVAL]");
+    }
 
-  if (!group) {
-    eos_thread_err("group=%s is not in group view",
-                   target_snapshot.mGroup.c_str());
-    gOFS->MgmStats.Add("SchedulingFailedDrain", 0, 0, 1);
-    return Emsg(epname, error, EINVAL, "schedule - group is not known [EINVAL]",
-                target_snapshot.mGroup.c_str());
-  }
+    target_fs->SnapShotFileSystem(target_snapshot);
+    FsGroup* group = FsView::gFsView.mGroupView[target_snapshot.mGroup];
 
-  // Select the next fs in the group to get a file to move
-  size_t gposition = 0;
-  {
-    XrdSysMutexHelper sLock(sGroupCycleMutex);
+    if (!group) {
+      eos_thread_err("group=%s is not in group view",
+                     target_snapshot.mGroup.c_str());
+      gOFS->MgmStats.Add("SchedulingFailedDrain", 0, 0, 1);
+      return Emsg(epname, error, EINVAL,
+                  "schedule - group is not known [EINVAL]",
+                  target_snapshot.mGroup.c_str());
+    }
+
+    // Select the next fs in the group to get a file to move
+    size_t gposition = 0;
+    {
+      XrdSysMutexHelper sLock(sGroupCycleMutex);
 
-    if (sGroupCycle.count(target_snapshot.mGroup)) {
-      gposition = sGroupCycle[target_snapshot.mGroup] % group->size();
-    } else {
-      gposition = 0;
-      sGroupCycle[target_snapshot.mGroup] = 0;
+      if (sGroupCycle.count(target_snapshot.mGroup)) {
+        gposition = sGroupCycle[target_snapshot.mGroup] % group->size();
+      } else {
+        gposition = 0;
+        sGroupCycle[target_snapshot.mGroup] = 0;
+      }
+
+      // Shift the iterator for the next schedule call
+      // to the following filesystem in the group
+      sGroupCycle[target_snapshot.mGroup]++;
+      sGroupCycle[target_snapshot.mGroup] %= group->size();
     }
 
-    // Shift the iterator for the next schedule call
-    // to the following filesystem in the group
-    sGroupCycle[target_snapshot.mGroup]++;
-    sGroupCycle[target_snapshot.mGroup] %= group->size();
-  }
+    eos_thread_debug("group=%s cycle=%lu",
+                     target_snapshot.mGroup.c_str(), gposition);
 
-  eos_thread_debug("group=%s cycle=%lu",
-                   target_snapshot.mGroup.c_str(), gposition);
+    // Try to find a file which is smaller than the free bytes and has no
+    // replica on the target filesystem. We start at a random position not
+    // to move data of the same period to a single disk
+    FsGroup::const_iterator group_iterator = group->begin();
+    std::advance(group_iterator, gposition);
+    eos::common::FileSystem* source_fs = 0;
 
-  // Try to find a file which is smaller than the free bytes and has no
-  // replica on the target filesystem. We start at a random position not
-  // to move data of the same period to a single disk
-  FsGroup::const_iterator group_iterator = group->begin();
-  std::advance(group_iterator, gposition);
-  eos::common::FileSystem* source_fs = 0;
+    for (size_t n = 0; n < group->size(); n++) {
+      // Look for a filesystem in drain mode
+      int32_t drain_status =
+          FsView::gFsView.mIdView[*group_iterator]->GetDrainStatus();
 
-  for (size_t n = 0; n < group->size(); n++) {
-    // Look for a filesystem in drain mode
-    int32_t drain_status =
-        FsView::gFsView.mIdView[*group_iterator]->GetDrainStatus();
+      if ((drain_status != eos::common::FileSystem::kDraining) &&
+          (drain_status != eos::common::FileSystem::kDrainStalling)) {
+        source_fs = 0;
 
-    if ((drain_status != eos::common::FileSystem::kDraining) &&
-        (drain_status != eos::common::FileSystem::kDrainStalling)) {
-      source_fs = 0;
+        if (++group_iterator == group->end()) {
+          group_iterator = group->begin();
+        }
 
-      if (++group_iterator == group->end()) {
-        group_iterator = group->begin();
+        continue;
       }
 
-      continue;
-    }
-
-    source_fs = FsView::gFsView.mIdView[*group_iterator];
+      source_fs = FsView::gFsView.mIdView[*group_iterator];
 
-    if (source_fs) { break; }
+      if (source_fs) { break; }
 
-    if (++group_iterator == group->end()) {
-      group_iterator = group->begin();
+      if (++group_iterator == group->end()) {
+        group_iterator = group->begin();
+      }
     }
-  }
 
-  if (!source_fs) {
-    eos_thread_debug("no source available");
-    gOFS->MgmStats.Add("SchedulingFailedDrain", 0, 0, 1);
-    error.setErrInfo(0, "");
-    return SFS_DATA;
-  }
+    if (!source_fs) {
+      if ((time(NULL) < deadline) && !gOFS->Shutdown) {
+        continue;
+      }
 
-  source_fs->SnapShotFileSystem(source_snapshot);
-  source_fsid = *group_iterator;
-
-  if (!gOFS->eosView->inMemory()) {
-    eos_thread_crit("msg=\"old style draining enabled for QDB namespace. "
-                    "Prefetching entire filesystem to minimize impact "
-                    "on performance.\"");
-    eos::Prefetcher::prefetchFilesystemFileListWithFileMDsAndParentsAndWait(
-        gOFS->eosView, gOFS->eosFsView, source_fsid);
-    eos::Prefetcher::prefetchFilesystemFileListAndWait(gOFS->eosView,
-                                                       gOFS->eosFsView,
-                                                       target_fsid);
-  }
+      eos_thread_debug("no source available");
+      gOFS->MgmStats.Add("SchedulingFailedDrain", 0, 0, 1);
+      error.setErrInfo(0, "");
+      return SFS_DATA;
+    }
 
-  // Lock namespace view here to avoid deadlock with the Commit.cc code on
-  // the ScheduledToDrainFidMutex
-  eos::common::RWMutexReadLock nsLock(gOFS->eosViewRWMutex);
-  unsigned long long nfids = gOFS->eosFsView->getNumFilesOnFs(source_fsid);
-  eos_thread_debug("group=%s cycle=%lu source_fsid=%u target_fsid=%u "
-                   "n_source_fids=%llu", target_snapshot.mGroup.c_str(),
-                   gposition, source_fsid, target_fsid, nfids);
-
-  for (auto it_fid = gOFS->eosFsView->getFileList(source_fsid);
-       (it_fid && it_fid->valid()); it_fid->next()) {
-    eos::IFileMD::id_t fid = it_fid->getElement();
-    eos_thread_debug("checking fxid=%llx", fid);
-
-    // Check that the target does not have this file
-    if (gOFS->eosFsView->hasFileId(fid, target_fsid)) {
-      // Ignore file and move to the next
-      eos_static_debug("skip fxid=%llx - file exists on target fsid=%u",
-                       fid, target_fsid);
-      continue;
+    source_fs->SnapShotFileSystem(source_snapshot);
+    source_fsid = *group_iterator;
+
+    if (!gOFS->eosView->inMemory()) {
+      eos_thread_crit("msg=\"old style draining enabled for QDB namespace. "
+                      "Prefetching entire filesystem to minimize impact "
+                      "on performance.\"");
+      eos::Prefetcher::prefetchFilesystemFileListWithFileMDsAndParentsAndWait(
+          gOFS->eosView, gOFS->eosFsView, source_fsid);
+      eos::Prefetcher::prefetchFilesystemFileListAndWait(gOFS->eosView,
+                                                         gOFS->eosFsView,
+                                                         target_fsid);
     }
 
-    // Update scheduled files mapping
-    time_t now = time(NULL);
-    XrdSysMutexHelper sLock(ScheduledToDrainFidMutex);
+    // Lock namespace view here to avoid deadlock with the Commit.cc code on
+    // the ScheduledToDrainFidMutex
+    eos::common::RWMutexReadLock nsLock(gOFS->eosViewRWMutex);
+    unsigned long long nfids = gOFS->eosFsView->getNumFilesOnFs(source_fsid);
+    eos_thread_debug("group=%s cycle=%lu source_fsid=%u target_fsid=%u "
+                     "n_source_fids=%llu", target_snapshot.mGroup.c_str(),
+                     gposition, source_fsid, target_fsid, nfids);
+
+    for (auto it_fid = gOFS->eosFsView->getFileList(source_fsid);
+         (it_fid && it_fid->valid()); it_fid->next()) {
+      eos::IFileMD::id_t fid = it_fid->getElement();
+      eos_thread_debug("checking fxid=%llx", fid);
+
+      // Check that the target does not have this file
+      if (gOFS->eosFsView->hasFileId(fid, target_fsid)) {
+        // Ignore file and move to the next
+        eos_static_debug("skip fxid=%llx - file exists on target fsid=%u",
+                         fid, target_fsid);
+        continue;
+      }
+
+      // Update scheduled files mapping
+      time_t now = time(NULL);
+      XrdSysMutexHelper sLock(ScheduledToDrainFidMutex);
 
-    if (sScheduledFidCleanupTime < now) {
-      // Next clean-up in 10 minutes
-      sScheduledFidCleanupTime = now + 600;
+      if (sScheduledFidCleanupTime < now) {
+        // Next clean-up in 10 minutes
+        sScheduledFidCleanupTime = now + 600;
 
-      std::map<eos::common::FileId::fileid_t, time_t>::iterator it1;
-      std::map<eos::common::FileId::fileid_t, time_t>::iterator it2;
-      it2 = ScheduledToDrainFid.begin();
+        std::map<eos::common::FileId::fileid_t, time_t>::iterator it1;
+        std::map<eos::common::FileId::fileid_t, time_t>::iterator it2;
+        it2 = ScheduledToDrainFid.begin();
 
-      while (it2 != ScheduledToDrainFid.end()) {
-        it1 = it2;
-        it2++;
+        while (it2 != ScheduledToDrainFid.end()) {
+          it1 = it2;
+          it2++;
 
-        if (it1->second < now) {
-          ScheduledToDrainFid.erase(it1);
+          if (it1->second < now) {
+            ScheduledToDrainFid.erase(it1);
+          }
         }
       }
-    }
 
-    // Check that this file has not been scheduled during the 1h period
-    if (ScheduledToDrainFid.count(fid)
-        && (ScheduledToDrainFid[fid] > (now))) {
-      // File has been scheduled in the last hour. Move to the next
-      eos_thread_debug("skip fxid=%llx - scheduled during last hour at %lu",
-                       fid, ScheduledToDrainFid[fid]);
-      continue;
-    }
+      // Check that this file has not been scheduled during the 1h period
+      if (ScheduledToDrainFid.count(fid)
+          && (ScheduledToDrainFid[fid] > (now))) {
+        // File has been scheduled in the last hour. Move to the next
+        eos_thread_debug("skip fxid=%llx - scheduled during last hour at %lu",
+                         fid, ScheduledToDrainFid[fid]);
+        continue;
+      }
 
-    //-----------------------------------------------------------------------
-    // Grab file metadata object
-    //-----------------------------------------------------------------------
-
-    std::shared_ptr<eos::IFileMD> fmd;
-    eos::IFileMD::LocationVector locations;
-    unsigned long long cid = 0;
-    unsigned long long size = 0;
-    long unsigned int lid = 0;
-    uid_t uid = 0;
-    gid_t gid = 0;
-    std::string fullpath = "";
-
-    try {
-      fmd = gOFS->eosFileService->getFileMD(fid);
-      fullpath = gOFS->eosView->getUri(fmd.get());
-      XrdOucString savepath = fullpath.c_str();
-
-      while (savepath.replace("&", "#AND#")) {}
-
-      fullpath = savepath.c_str();
-      lid = fmd->getLayoutId();
-      cid = fmd->getContainerId();
-      size = fmd->getSize();
-      uid = fmd->getCUid();
-      gid = fmd->getCGid();
-      locations = fmd->getLocations();
-    } catch (eos::MDException& e) {
-      fmd.reset();
-    }
+      //-----------------------------------------------------------------------
+      // Grab file metadata object
+      //-----------------------------------------------------------------------
 
-    if (!fmd) {
-      eos_thread_debug("skip fxid=%llx - cannot get fmd record", fid);
-      continue;
-    }
+      std::shared_ptr<eos::IFileMD> fmd;
+      eos::IFileMD::LocationVector locations;
+      unsigned long long cid = 0;
+      unsigned long long size = 0;
+      long unsigned int lid = 0;
+      uid_t uid = 0;
+      gid_t gid = 0;
+      std::string fullpath = "";
 
-    if (!size) {
-      // This is a zero size file
-      // We move the location by adding it to the static move map
-      eos_thread_info("cmd=schedule2drain msg=zero-move fid=%llx source_fs=%u "
-                      "target_fs=%u", fid, source_fsid, target_fsid);
+      try {
+        fmd = gOFS->eosFileService->getFileMD(fid);
+        fullpath = gOFS->eosView->getUri(fmd.get());
+        XrdOucString savepath = fullpath.c_str();
+
+        while (savepath.replace("&", "#AND#")) {}
+
+        fullpath = savepath.c_str();
+        lid = fmd->getLayoutId();
+        cid = fmd->getContainerId();
+        size = fmd->getSize();
+        uid = fmd->getCUid();
+        gid = fmd->getCGid();
+        locations = fmd->getLocations();
+      } catch (eos::MDException& e) {
+        fmd.reset();
+      }
 
-      XrdSysMutexHelper zLock(sZeroMoveMutex);
-      sZeroMove[fid] = std::make_pair(source_fsid, target_fsid);
-      continue;
-    }
+      if (!fmd) {
+        eos_thread_debug("skip fxid=%llx - cannot get fmd record", fid);
+        continue;
+      }
 
-    if (fullpath.find(EOS_COMMON_PATH_ATOMIC_FILE_PREFIX) != std::string::npos) {
-      // Drop a left-over atomic file instead of draining
-      eos_thread_info("cmd=schedule2drain msg=zero-move fid=%llx source_fs=%u "
-                      "target_fs=%u", fid, source_fsid, target_fsid);
+      if (!size) {
+        // This is a zero size file
+        // We move the location by adding it to the static move map
+        eos_thread_info("cmd=schedule2drain msg=zero-move fid=%llx "
+                        "source_fs=%u target_fs=%u", fid, source_fsid,
+                        target_fsid);
 
-      XrdSysMutexHelper zLock(sZeroMoveMutex);
-      sZeroMove[fid] = std::make_pair(source_fsid, target_fsid);
-      continue;
-    }
+        XrdSysMutexHelper zLock(sZeroMoveMutex);
+        sZeroMove[fid] = std::make_pair(source_fsid, target_fsid);
+        continue;
+      }
+
+      if (fullpath.find(EOS_COMMON_PATH_ATOMIC_FILE_PREFIX) !=
+          std::string::npos) {
+        // Drop a left-over atomic file instead of draining
+        eos_thread_info("cmd=schedule2drain msg=zero-move fid=%llx "
+                        "source_fs=%u target_fs=%u", fid, source_fsid,
+                        target_fsid);
+
+        XrdSysMutexHelper zLock(sZeroMoveMutex);
+        sZeroMove[fid] = std::make_pair(source_fsid, target_fsid);
+        continue;
+      }
 
-    //-----------------------------------------------------------------------
-    // Prepare file transfer parameters
-    //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      // Prepare file transfer parameters
+      //-----------------------------------------------------------------------
 
-    using eos::common::LayoutId;
-    std::vector<unsigned int> locationfs;
+      using eos::common::LayoutId;
+      std::vector<unsigned int> locationfs;
 
-    for (auto& location: locations) {
-      // Ignore filesystem id 0
-      if (!location) { continue; }
+      for (auto& location: locations) {
+        // Ignore filesystem id 0
+        if (!location) { continue; }
 
-      if (source_snapshot.mId == location) {
-        if (source_snapshot.mConfigStatus == eos::common::FileSystem::kDrain) {
-          // Only add filesystems which are not in drain dead to the
-          // list of possible locations
+        if (source_snapshot.mId == location) {
+          if (source_snapshot.mConfigStatus ==
+              eos::common::FileSystem::kDrain) {
+            // Only add filesystems which are not in drain dead to the
+            // list of possible locations
+            locationfs.push_back(location);
+          }
+        } else {
           locationfs.push_back(location);
         }
-      } else {
-        locationfs.push_back(location);
       }
-    }
 
-    XrdOucString full_capability = "";
-
-    if ((LayoutId::GetLayoutType(lid) == LayoutId::kRaidDP ||
-         LayoutId::GetLayoutType(lid) == LayoutId::kArchive ||
-         LayoutId::GetLayoutType(lid) == LayoutId::kRaid6) &&
-        source_snapshot.mConfigStatus == eos::common::FileSystem::kDrainDead) {
-      //------------------------------------------------------------------
-      // RAIN layouts (not replica) drain by running a reconstruction
-      // 'eoscp -c' ... if they are in draindead
-      // They are easy to configure, they just call an open with
-      // reconstruction/replacement option and the real scheduling
-      // is done when 'eoscp' is executed.
-      //------------------------------------------------------------------
-      eos_thread_info("msg=\"creating RAIN reconstruction job\" path=%s",
-                      fullpath.c_str());
-
-      full_capability = RAINFullCapability(fullpath.c_str(), source_snapshot.mId);
-    } else {
-      // Plain/replica layouts get source/target scheduled here
-      // Schedule access to that file with the original layout
-      long unsigned int fsindex = 0;
-
-      // Exclude another scheduling for RAIN files
-      // There is no alternative location here
-      if (LayoutId::GetLayoutType(lid) == LayoutId::kRaidDP ||
-          LayoutId::GetLayoutType(lid) == LayoutId::kArchive ||
-          LayoutId::GetLayoutType(lid) == LayoutId::kRaid6) {
-        // Point to the stripe which is accessible but should be drained
-        locationfs.clear();
-        locationfs.push_back(source_fsid);
-        fsindex = 0;
+      XrdOucString full_capability = "";
+
+      if ((LayoutId::GetLayoutType(lid) == LayoutId::kRaidDP ||
+           LayoutId::GetLayoutType(lid) == LayoutId::kArchive ||
+           LayoutId::GetLayoutType(lid) == LayoutId::kRaid6) &&
+          (source_snapshot.mConfigStatus ==
+           eos::common::FileSystem::kDrainDead)) {
+        //------------------------------------------------------------------
+        // RAIN layouts (not replica) drain by running a reconstruction
+        // 'eoscp -c' ... if they are in draindead
+        // They are easy to configure, they just call an open with
+        // reconstruction/replacement option and the real scheduling
+        // is done when 'eoscp' is executed.
+        //------------------------------------------------------------------
+        eos_thread_info("msg=\"creating RAIN reconstruction job\" path=%s",
+                        fullpath.c_str());
+
+        full_capability = RAINFullCapability(fullpath.c_str(),
+                                             source_snapshot.mId);
       } else {
-        // Check file access of drain file
-        XrdOucErrInfo accError;
-        int rc = checkFileAccess(lid, fsindex, locationfs, accError);
+        // Plain/replica layouts get source/target scheduled here
+        // Schedule access to that file with the original layout
+        long unsigned int fsindex = 0;
+
+        // Exclude another scheduling for RAIN files
+        // There is no alternative location here
+        if (LayoutId::GetLayoutType(lid) == LayoutId::kRaidDP ||
+            LayoutId::GetLayoutType(lid) == LayoutId::kArchive ||
+            LayoutId::GetLayoutType(lid) == LayoutId::kRaid6) {
+          // Point to the stripe which is accessible but should be drained
+          locationfs.clear();
+          locationfs.push_back(source_fsid);
+          fsindex = 0;
+        } else {
+          // Check file access of drain file
+          XrdOucErrInfo accError;
+          int rc = checkFileAccess(lid, fsindex, locationfs, accError);
+
+          if (rc) {
+            // We schedule to retry the file after 60 seconds
+            eos_thread_err("cmd=schedule2drain msg=\"%s\" fxid=%llx retc=%d",
+                           accError.getErrText(), fid, rc);
+            ScheduledToDrainFid[fid] = time(NULL) + 60;
+            continue;
+          }
+        }
 
-        if (rc) {
-          // We schedule to retry the file after 60 seconds
-          eos_thread_err("cmd=schedule2drain msg=\"%s\" fxid=%llx retc=%d",
-                         accError.getErrText(), fid, rc);
-          ScheduledToDrainFid[fid] = time(NULL) + 60;
+        if (size >= freebytes) {
+          eos_thread_warning("skip fxid=%llx - file size >= free bytes "
+                             "fsize=%llu free_bytes=%llu", fid, size,
+                             freebytes);
           continue;
         }
-      }
 
-      if (size >= freebytes) {
-        eos_thread_warning("skip fxid=%llx - file size >= free bytes "
-                           "fsize=%llu free_bytes=%llu", fid, size, freebytes);
-        continue;
-      }
+        // We schedule fid from replica_source => target_fs
+        eos::common::FileSystem* replica_source_fs = 0;
+        unsigned int replica_fsid = locationfs[fsindex];
+
+        if ((!FsView::gFsView.mIdView.count(replica_fsid)) ||
+            (replica_source_fs = FsView::gFsView.mIdView[replica_fsid]) == 0) {
+          continue;
+        }
 
-      // We schedule fid from replica_source => target_fs
-      eos::common::FileSystem* replica_source_fs = 0;
-      unsigned int replica_fsid = locationfs[fsindex];
+        replica_source_fs->SnapShotFileSystem(replica_source_snapshot);
 
-      if ((!FsView::gFsView.mIdView.count(replica_fsid)) ||
-          (replica_source_fs = FsView::gFsView.mIdView[replica_fsid]) == 0) {
-        continue;
-      }
+        eos_thread_info("subcmd=scheduling fid=%llx "
+                        "drain_fsid=%u replica_source_fsid=%u target_fsid=%u",
+                        fid, source_fsid, replica_fsid, target_fsid);
 
-      replica_source_fs->SnapShotFileSystem(replica_source_snapshot);
+        unsigned long target_lid = LayoutId::SetLayoutType(lid,
+                                   LayoutId::kPlain);
 
-      eos_thread_info("subcmd=scheduling fid=%llx "
-                      "drain_fsid=%u replica_source_fsid=%u target_fsid=%u",
-                      fid, source_fsid, replica_fsid, target_fsid);
+        // Mask block checksums (set to kNone) for replica layouts
+        if (LayoutId::GetLayoutType(lid) == LayoutId::kReplica) {
+          target_lid = LayoutId::SetBlockChecksum(target_lid, LayoutId::kNone);
+        }
 
-      unsigned long target_lid = LayoutId::SetLayoutType(lid, LayoutId::kPlain);
+        // Construct capability strings
+        XrdOucString replica_source_capability =
+            constructSourceCapability(target_lid, cid, fullpath.c_str(),
+                                      fid, source_fsid,
+                                      replica_source_snapshot.mPath.c_str(),
+                                      replica_source_snapshot.mId,
+                                      replica_source_snapshot.mHostPort.c_str());
+
+        XrdOucString target_capability =
+            constructTargetCapability(target_lid, cid, fullpath.c_str(), fid,
+                                      source_fsid,
+                                      target_snapshot.mPath.c_str(),
+                                      target_snapshot.mId,
+                                      target_snapshot.mHostPort.c_str(),
+                                      size, lid, uid, gid);
+
+        // Issue full capability string
+        XrdOucErrInfo capError;
+        int rc = issueFullCapability(replica_source_capability,
+                                     target_capability,
+                                     mCapabilityValidity,
+                                     replica_source_snapshot.mHostPort.c_str(),
+                                     target_snapshot.mHostPort.c_str(),
+                                     fid, full_capability, capError);
 
-      // Mask block checksums (set to kNone) for replica layouts
-      if (LayoutId::GetLayoutType(lid) == LayoutId::kReplica) {
-        target_lid = LayoutId::SetBlockChecksum(target_lid, LayoutId::kNone);
-      }
+        if (rc) {
+          if (nsubmitted) {
+            // Return the jobs of the batch which are already queued
+            eos_thread_err("unable to create %s capability - ec=%d",
+                           capError.getErrText(), capError.getErrInfo());
+            break;
+          }
+
+          std::ostringstream errstream;
+          errstream << "create " << capError.getErrText()
+                    << " capability [EADV]";
 
-      // Construct capability strings
-      XrdOucString replica_source_capability =
-          constructSourceCapability(target_lid, cid, fullpath.c_str(),
-                                    fid, source_fsid,
-                                    replica_source_snapshot.mPath.c_str(),
-                                    replica_source_snapshot.mId,
-                                    replica_source_snapshot.mHostPort.c_str());
-
-      XrdOucString target_capability =
-          constructTargetCapability(target_lid, cid, fullpath.c_str(), fid,
-                                    source_fsid, target_snapshot.mPath.c_str(),
-                                    target_snapshot.mId,
-                                    target_snapshot.mHostPort.c_str(),
-                                    size, lid, uid, gid);
-
-      // Issue full capability string
-      XrdOucErrInfo capError;
-      int rc = issueFullCapability(replica_source_capability, target_capability,
-                                   mCapabilityValidity,
-                                   replica_source_snapshot.mHostPort.c_str(),
-                                   target_snapshot.mHostPort.c_str(),
-                                   fid, full_capability, capError);
-
-      if (rc) {
-        std::ostringstream errstream;
-        errstream << "create " << capError.getErrText()
-                  << " capability [EADV]";
-
-        eos_thread_err("unable to create %s capability - ec=%d",
-                       capError.getErrText(), capError.getErrInfo());
-        gOFS->MgmStats.Add("SchedulingFailedBalance", 0, 0, 1);
-        return Emsg(epname, error, rc, errstream.str().c_str());
+          eos_thread_err("unable to create %s capability - ec=%d",
+                         capError.getErrText(), capError.getErrInfo());
+          gOFS->MgmStats.Add("SchedulingFailedBalance", 0, 0, 1);
+          return Emsg(epname, error, rc, errstream.str().c_str());
+        }
       }
-    }
 
-    //-----------------------------------------------------------------------
-    // Schedule file transfer
-    //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      // Schedule file transfer
+      //-----------------------------------------------------------------------
+
+      std::unique_ptr<eos::common::TransferJob>
+          txjob(new eos::common::TransferJob(full_capability.c_str()));
 
-    std::unique_ptr<eos::common::TransferJob>
-        txjob(new eos::common::TransferJob(full_capability.c_str()));
+      if (!target_fs->GetDrainQueue()->Add(txjob.get())) {
+        eos_thread_err("cmd=schedule2drain msg=\"failed to submit job\" "
+                       "job=%s", full_capability.c_str());
+        continue;
+      }
 
-    if (target_fs->GetDrainQueue()->Add(txjob.get())) {
       eos_thread_info("cmd=schedule2drain msg=queued fid=%llx source_fs=%u "
                       "target_fs=%u", fid, source_fsid, target_fsid);
       eos_thread_debug("cmd=schedule2drain job=%s", full_capability.c_str());
-
       ScheduledToDrainFid[fid] = time(NULL) + 3600;
-      XrdOucString response = "submitted";
-      error.setErrInfo(response.length() + 1, response.c_str());
-    } else {
-      eos_thread_err("cmd=schedule2drain msg=\"failed to submit job\" "
-                     "job=%s", full_capability.c_str());
-      error.setErrInfo(0, "");
+      // The rest of the batch has to fit in the free space as well
+      freebytes -= std::min(size, freebytes);
+
+      if (++nsubmitted == njobs) {
+        break;
+      }
+    }
+
+    if (nsubmitted || (time(NULL) >= deadline) || gOFS->Shutdown) {
+      break;
+    }
+  }
+
+  if (nsubmitted) {
+    XrdOucString response = "submitted";
+
+    if (anjobs) {
+      response += ":";
+      response += (int) nsubmitted;
     }
 
-    gOFS->MgmStats.Add("Scheduled2Drain", 0, 0, 1);
+    error.setErrInfo(response.length() + 1, response.c_str());
+    gOFS->MgmStats.Add("Scheduled2Drain", 0, 0, nsubmitted);
     EXEC_TIMING_END("Scheduled2Drain");
     return SFS_DATA;
   }
@@ -43,8 +43,11 @@
 #include "mgm/GeoTreeEngine.hh"
 #include "mgm/http/HttpServer.hh"
 #include "mgm/ZMQ.hh"
+#include "mgm/NsChangeStream.hh"
 #include "mgm/Iostat.hh"
+#include "mgm/RequestTrace.hh"
 #include "mgm/LRU.hh"
+#include "mgm/HotFileReplicator.hh"
 #include "mgm/WFE.hh"
 #include "mgm/Master.hh"
 #include "mgm/QdbMaster.hh"
@@ -640,6 +643,18 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
                      mTapeAwareGcDefaultSpaceEnable ? "true" : "false");
         }
 
+        if (!strcmp("tapeawaregc.spaces", var)) {
+          std::string spaces;
+
+          while ((val = Config.GetWord())) {
+            mTapeAwareGcSpaces.insert(val);
+            spaces += val;
+            spaces += " ";
+          }
+
+          Eroute.Say("=====> mgmofs.tapeawaregc.spaces : ", spaces.c_str());
+        }
+
         if (!strcmp("authorize", var)) {
           if ((!(val = Config.GetWord())) ||
               (strcmp("true", val) && strcmp("false", val) &&
@@ -1105,7 +1120,7 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
   std::vector<std::string> lFanOutTags {
     "Balancer", "Converter", "DrainJob", "ZMQ", "MetadataFlusher", "Http",
     "Master", "Recycle", "LRU", "WFE", "WFE::Job", "GroupBalancer",
-    "GeoBalancer", "GeoTreeEngine", "#"};
+    "GeoBalancer", "GeoTreeEngine", "RequestTrace", "BalancePlanner", "#"};
   // Get the XRootD log directory
   char* logdir = 0;
   XrdOucEnv::Import("XRDLOGDIR", logdir);
@@ -1305,6 +1320,16 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
     Eroute.Say("=====> mgmofs.alias: ", MgmOfsAlias.c_str());
   }
 
+  // Build binary capabilities if all FSTs are known to accept them
+  if (getenv("EOS_MGM_CAPABILITY_FORMAT") &&
+      !strcmp(getenv("EOS_MGM_CAPABILITY_FORMAT"), "binary")) {
+    XrdCapability::SetBinaryFormat(true);
+    Eroute.Say("=====> mgmofs.capability.format: binary");
+  }
+
+  // Stage timing of slow requests, see RequestTrace
+  RequestTrace::ConfigureFromEnv();
+
   // Build the adler & sha1 checksum of the default keytab file
   XrdOucString keytabcks = "unaccessible";
   int fd = ::open("/etc/eos.keytab", O_RDONLY);
@@ -1401,6 +1426,8 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
   MgmProcLockPath += "/lock";
   MgmProcDelegationPath = MgmProcPath;
   MgmProcDelegationPath += "/delegation";
+  MgmProcHotReplicaPath = MgmProcPath;
+  MgmProcHotReplicaPath += "/hotreplica";
   Recycle::gRecyclingPrefix.insert(0, MgmProcPath.c_str());
   instancepath += subpath;
   // Initialize user mapping
@@ -1417,6 +1444,31 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
     mMaster.reset(new eos::mgm::Master());
   }
 
+  // Create the namespace change stream, it gets registered as listener when
+  // booting the namespace and publishes once the boot is done
+  if (getenv("EOS_MGM_NS_CHANGE_STREAM_PORT")) {
+    int port = atoi(getenv("EOS_MGM_NS_CHANGE_STREAM_PORT"));
+    size_t retained = 100000;
+
+    if (getenv("EOS_MGM_NS_CHANGE_STREAM_RETAINED")) {
+      retained = strtoull(getenv("EOS_MGM_NS_CHANGE_STREAM_RETAINED"), 0, 10);
+    }
+
+    if ((port <= 0) || (port >= 65535)) {
+      Eroute.Emsg("Config", "invalid EOS_MGM_NS_CHANGE_STREAM_PORT");
+      return 1;
+    }
+
+    mNsChangeStream.reset
+    (new NsChangeStream(SSTR("tcp://*:" << port), SSTR("tcp://*:" << port + 1),
+                        retained, []() {
+      return (gOFS->mInitialized == XrdMgmOfs::kBooted);
+    }));
+    mNsChangeStream->Start();
+    Eroute.Say("=====> mgmofs.ns.changestream.port: ",
+               std::to_string(port).c_str());
+  }
+
   // Initialize the master/slave class
   if (!mMaster->Init()) {
     return 1;
@@ -1669,6 +1721,27 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
       }
     }
 
+    // Create directory of the files with extra replicas because they are hot
+    try {
+      eosmd = gOFS->eosView->getContainer(MgmProcHotReplicaPath.c_str());
+    } catch (const eos::MDException& e) {
+      eosmd = nullptr;
+    }
+
+    if (!eosmd) {
+      try {
+        eosmd = gOFS->eosView->createContainer(MgmProcHotReplicaPath.c_str(), true);
+        eosmd->setMode(S_IFDIR | S_IRWXU);
+        eosmd->setCUid(2); // hotreplica directory is owned by daemon
+        gOFS->eosView->updateContainerStore(eosmd.get());
+      } catch (const eos::MDException& e) {
+        Eroute.Emsg("Config", "cannot set the /eos/../proc/hotreplica directory"
+                    " mode to inital mode");
+        eos_crit("cannot set the /eos/../proc/hotreplica directory mode to 700");
+        return 1;
+      }
+    }
+
     if (NsInQDB) {
       SetupProcFiles();
     }
@@ -1785,6 +1858,8 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
 
   eos_info("%s", "msg=\"starting archive submitter thread\"");
   mSubmitterTid.reset(&XrdMgmOfs::StartArchiveSubmitter, this);
+  eos_info("%s", "msg=\"starting quota reconciliation thread\"");
+  mQuotaReconcileTid.reset(&Quota::Reconcile);
 
   if (!MgmRedirector) {
     eos_info("%s", "msg=\"starting fs listener thread\"");
@@ -1817,6 +1892,13 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
     eos_warning("msg=\"cannot start LRU thread\"");
   }
 
+  // start the hot file replicator
+  mHotFileReplicator.reset(new HotFileReplicator());
+
+  if (!mHotFileReplicator->Start()) {
+    eos_warning("msg=\"cannot start hot file replicator thread\"");
+  }
+
   // start the WFE daemon
   if (!gOFS->WFEd.Start()) {
     eos_warning("msg=\"cannot start WFE thread\"");
@@ -1852,6 +1934,8 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
 
   // Start IO ciruclate thread
   IoStats->StartCirculate();
+  // Start the push of the metrics to the monitoring
+  IoStats->StartMetricsPush();
 
   if (!MgmRedirector) {
     ObjectManager.HashMutex.LockRead();
@@ -1920,7 +2004,11 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
 
   // Only if configured to do so, enable the tape aware garbage collector
   if (mTapeAwareGcDefaultSpaceEnable) {
-    mTapeAwareGc.enable();
+    mTapeAwareGcSpaces.insert("default");
+  }
+
+  if (!mTapeAwareGcSpaces.empty()) {
+    mTapeAwareGc.enable(mTapeAwareGcSpaces);
   }
 
   return NoGo;
@@ -1966,7 +2054,9 @@ XrdMgmOfs::InitStats()
   MgmStats.Add("Eosxd::ext::0-QUERY", 0, 0, 0);
   MgmStats.Add("Eosxd::ext::GET", 0, 0, 0);
   MgmStats.Add("Eosxd::ext::SET", 0, 0, 0);
+  MgmStats.Add("Eosxd::ext::SETMANY", 0, 0, 0);
   MgmStats.Add("Eosxd::ext::LS", 0, 0, 0);
+  MgmStats.Add("Eosxd::ext::LS-Unchanged", 0, 0, 0);
   MgmStats.Add("Eosxd::ext::CREATE", 0, 0, 0);
   MgmStats.Add("Eosxd::ext::UPDATE", 0, 0, 0);
   MgmStats.Add("Eosxd::ext::MKDIR", 0, 0, 0);
@@ -1992,6 +2082,7 @@ XrdMgmOfs::InitStats()
   MgmStats.Add("Eosxd::int::BcReleaseExt", 0, 0, 0);
   MgmStats.Add("Eosxd::int::BcDeletion", 0, 0, 0);
   MgmStats.Add("Eosxd::int::BcDeletionExt", 0, 0, 0);
+  MgmStats.Add("Eosxd::int::Coalesced", 0, 0, 0);
   MgmStats.Add("Eosxd::int::DeleteEntry", 0, 0, 0);
   MgmStats.Add("Eosxd::int::FillContainerCAP", 0, 0, 0);
   MgmStats.Add("Eosxd::int::FillContainerMD", 0, 0, 0);
@@ -2000,6 +2091,7 @@ XrdMgmOfs::InitStats()
   MgmStats.Add("Eosxd::int::MonitorCaps", 0, 0, 0);
   MgmStats.Add("Eosxd::int::RefreshEntry", 0, 0, 0);
   MgmStats.Add("Eosxd::int::ReleaseCap", 0, 0, 0);
+  MgmStats.Add("Eosxd::int::SendBatch", 0, 0, 0);
   MgmStats.Add("Eosxd::int::SendCAP", 0, 0, 0);
   MgmStats.Add("Eosxd::int::SendMD", 0, 0, 0);
   MgmStats.Add("Eosxd::int::Store", 0, 0, 0);
@@ -2038,11 +2130,14 @@ XrdMgmOfs::InitStats()
   MgmStats.Add("IdMap", 0, 0, 0);
   MgmStats.Add("Ls", 0, 0, 0);
   MgmStats.Add("LRUFind", 0, 0, 0);
+  MgmStats.Add("LRUFill", 0, 0, 0);
   MgmStats.Add("MarkDirty", 0, 0, 0);
   MgmStats.Add("MarkClean", 0, 0, 0);
   MgmStats.Add("Mkdir", 0, 0, 0);
   MgmStats.Add("Motd", 0, 0, 0);
   MgmStats.Add("MoveStripe", 0, 0, 0);
+  MgmStats.Add("OpenCacheHit", 0, 0, 0);
+  MgmStats.Add("PolicyCacheHit", 0, 0, 0);
   MgmStats.Add("OpenDir", 0, 0, 0);
   MgmStats.Add("OpenDir-Entry", 0, 0, 0);
   MgmStats.Add("OpenFailedCreate", 0, 0, 0);
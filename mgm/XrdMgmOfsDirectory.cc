@@ -34,6 +34,7 @@
 #include "namespace/interface/IView.hh"
 #include "namespace/Prefetcher.hh"
 #include "namespace/interface/ContainerIterators.hh"
+#include <algorithm>
 
 #ifdef __APPLE__
 #define ECOMM 70
@@ -48,6 +49,15 @@
 //! MGM Directory Interface
 //------------------------------------------------------------------------------
 
+std::map<uint64_t, std::weak_ptr<XrdMgmOfsDirectory::Listing>>
+XrdMgmOfsDirectory::sListings;
+std::deque<std::pair<time_t, std::shared_ptr<XrdMgmOfsDirectory::Listing>>>
+    XrdMgmOfsDirectory::sKept;
+size_t XrdMgmOfsDirectory::sKeptNames = 0;
+std::mutex XrdMgmOfsDirectory::sListingsMutex;
+constexpr time_t XrdMgmOfsDirectory::kKeepSec;
+constexpr size_t XrdMgmOfsDirectory::kMaxKeptNames;
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -155,30 +165,17 @@ XrdMgmOfsDirectory::_open(const char* dir_path,
     }
 
     if (permok) {
-      // Add all the files and subdirectories
       gOFS->MgmStats.Add("OpenDir-Entry", vid.uid, vid.gid,
                          dh->getNumContainers() + dh->getNumFiles());
+      uint64_t version = dh->getChildrenVersion();
+      // The names are collected without the namespace lock
+      lock.Release();
+      std::shared_ptr<Listing> listing = GetListing(dh, version);
       std::unique_lock<std::mutex> scope_lock(mDirLsMutex);
-      dh_list.clear();
-
-      // Collect all file names
-      for (auto it = eos::FileMapIterator(dh); it.valid(); it.next()) {
-        dh_list.insert(it.key());
-      }
-
-      // Collect all subcontainers
-      for (auto it = eos::ContainerMapIterator(dh); it.valid(); it.next()) {
-        dh_list.insert(it.key());
-      }
-
-      dh_list.insert(".");
-
+      mListing = listing;
+      mPos = 0;
       // The root dir has no .. entry
-      if (strcmp(dir_path, "/")) {
-        dh_list.insert("..");
-      }
-
-      dh_it = dh_list.begin();
+      mNumDots = (strcmp(dir_path, "/") ? 2 : 1);
     }
   } catch (eos::MDException& e) {
     dh.reset();
@@ -215,14 +212,35 @@ XrdMgmOfsDirectory::nextEntry()
 {
   std::unique_lock<std::mutex> scope_lock(mDirLsMutex);
 
-  if (dh_list.empty() || dh_it == dh_list.end()) {
+  if (!mListing || (mPos >= mNumDots + mListing->mNames.size())) {
     // No more entries
     return (const char*) 0;
   }
 
-  const char* name = dh_it->c_str();
-  ++dh_it;
-  return name;
+  size_t pos = mPos++;
+
+  if (pos < mNumDots) {
+    return (pos ? ".." : ".");
+  }
+
+  return mListing->mNames[pos - mNumDots].c_str();
+}
+
+//------------------------------------------------------------------------------
+// Position the listing after an entry
+//------------------------------------------------------------------------------
+void
+XrdMgmOfsDirectory::seekAfter(const std::string& name)
+{
+  std::unique_lock<std::mutex> scope_lock(mDirLsMutex);
+
+  if (!mListing) {
+    return;
+  }
+
+  const std::vector<std::string>& names = mListing->mNames;
+  auto it = std::upper_bound(names.begin(), names.end(), name);
+  mPos = mNumDots + (it - names.begin());
 }
 
 //------------------------------------------------------------------------------
@@ -231,11 +249,115 @@ XrdMgmOfsDirectory::nextEntry()
 int
 XrdMgmOfsDirectory::close()
 {
-  std::unique_lock<std::mutex> scope_lock(mDirLsMutex);
-  dh_list.clear();
+  std::shared_ptr<Listing> listing;
+  {
+    std::unique_lock<std::mutex> scope_lock(mDirLsMutex);
+    listing.swap(mListing);
+    mPos = 0;
+  }
+
+  if (listing) {
+    KeepListing(std::move(listing));
+  }
+
   return SFS_OK;
 }
 
+//------------------------------------------------------------------------------
+// Keep a closed listing alive for a while
+//------------------------------------------------------------------------------
+void
+XrdMgmOfsDirectory::KeepListing(std::shared_ptr<Listing> listing)
+{
+  if (!listing->mDone || (listing->mNames.size() > kMaxKeptNames)) {
+    return;
+  }
+
+  time_t now = time(NULL);
+  // The dropped listings are freed outside of the lock
+  std::vector<std::shared_ptr<Listing>> dropped;
+  std::unique_lock<std::mutex> scope_lock(sListingsMutex);
+
+  for (auto it = sKept.begin(); it != sKept.end(); ++it) {
+    if (it->second == listing) {
+      sKeptNames -= listing->mNames.size();
+      sKept.erase(it);
+      break;
+    }
+  }
+
+  sKeptNames += listing->mNames.size();
+  sKept.emplace_back(now, std::move(listing));
+
+  // Drop the oldest listings once expired or above the size limit
+  while (!sKept.empty() && ((sKept.front().first + kKeepSec < now) ||
+                            (sKeptNames > kMaxKeptNames))) {
+    sKeptNames -= sKept.front().second->mNames.size();
+    dropped.push_back(std::move(sKept.front().second));
+    sKept.pop_front();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the listing of a container for a version of its children
+//------------------------------------------------------------------------------
+std::shared_ptr<XrdMgmOfsDirectory::Listing>
+XrdMgmOfsDirectory::GetListing(const std::shared_ptr<eos::IContainerMD>& cmd,
+                               uint64_t version)
+{
+  std::shared_ptr<Listing> listing;
+  {
+    std::unique_lock<std::mutex> scope_lock(sListingsMutex);
+    std::weak_ptr<Listing>& entry = sListings[cmd->getId()];
+    listing = entry.lock();
+
+    if (!listing || (listing->mVersion != version)) {
+      listing = std::make_shared<Listing>();
+      listing->mVersion = version;
+      entry = listing;
+
+      // Forget the listings which are not used anymore
+      for (auto it = sListings.begin(); it != sListings.end();) {
+        if (it->second.expired()) {
+          it = sListings.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+  }
+  std::unique_lock<std::mutex> build_lock(listing->mMutex);
+
+  if (listing->mDone) {
+    return listing;
+  }
+
+  // The in-memory namespace changes the containers under the namespace lock
+  // only, the other ones hold the lock of the container while iterating it
+  eos::common::RWMutexReadLock ns_lock;
+
+  if (gOFS->eosView->inMemory()) {
+    ns_lock.Grab(gOFS->eosViewRWMutex);
+  }
+
+  std::vector<std::string>& names = listing->mNames;
+  names.clear();
+  names.reserve(cmd->getNumFiles() + cmd->getNumContainers());
+
+  for (auto it = eos::FileMapIterator(cmd); it.valid(); it.next()) {
+    names.push_back(it.key());
+  }
+
+  for (auto it = eos::ContainerMapIterator(cmd); it.valid(); it.next()) {
+    names.push_back(it.key());
+  }
+
+  ns_lock.Release();
+  std::sort(names.begin(), names.end());
+  listing->mDone = true;
+  return listing;
+}
+
 /*----------------------------------------------------------------------------*/
 int
 XrdMgmOfsDirectory::Emsg(const char* pfx,
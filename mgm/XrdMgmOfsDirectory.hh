@@ -29,9 +29,15 @@
 #include "XrdSec/XrdSecEntity.hh"
 #include "XrdSfs/XrdSfsInterface.hh"
 #include <dirent.h>
-#include <string>
-#include <set>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <string>
+#include <vector>
 
 //! Forward declaration
 namespace eos
@@ -64,8 +70,9 @@ public:
   //!
   //! @return SFS_OK otherwise SFS_ERROR
   //!
-  //! @note We create during the open the full directory listing which then is
-  //! retrieved via nextEntry() and cleaned up with close().
+  //! @note The names of the directory are collected once per version of its
+  //! children without the namespace lock, shared by the concurrent listers of
+  //! the same version, retrieved via nextEntry() and released with close().
   //----------------------------------------------------------------------------
   int open(const char* dirName, const XrdSecClientName* client = 0,
            const char* opaque = 0);
@@ -95,6 +102,14 @@ public:
   // ---------------------------------------------------------------------------
   const char* nextEntry();
 
+  //----------------------------------------------------------------------------
+  //! Position the listing after an entry, the next entry returned is the
+  //! first name sorting after it. Used to resume a paginated listing.
+  //!
+  //! @param name last entry of the previous page
+  //----------------------------------------------------------------------------
+  void seekAfter(const std::string& name);
+
   //----------------------------------------------------------------------------
   //! Create an error message
   //!
@@ -132,9 +147,52 @@ public:
   }
 
 private:
+  //----------------------------------------------------------------------------
+  //! Names of the children of a container at one version of its children
+  //----------------------------------------------------------------------------
+  struct Listing {
+    uint64_t mVersion {0}; ///< children version of the container
+    std::mutex mMutex; ///< held while the names are collected
+    bool mDone {false}; ///< true once the names are collected
+    std::vector<std::string> mNames; ///< sorted names of the children
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the listing of a container for a version of its children, shared
+  //! with the other listers of the same version. The first lister collects
+  //! the names, the concurrent ones wait for it.
+  //!
+  //! @param cmd container to list
+  //! @param version children version seen at the permission check
+  //!
+  //! @return listing with the collected names
+  //----------------------------------------------------------------------------
+  static std::shared_ptr<Listing>
+  GetListing(const std::shared_ptr<eos::IContainerMD>& cmd, uint64_t version);
+
+  //----------------------------------------------------------------------------
+  //! Keep a closed listing alive for a while so that the next page requests
+  //! of a paginated listing find it again
+  //!
+  //! @param listing listing released by close()
+  //----------------------------------------------------------------------------
+  static void KeepListing(std::shared_ptr<Listing> listing);
+
+  //! Seconds a closed listing is kept
+  static constexpr time_t kKeepSec = 60;
+  //! Max number of names of all the kept listings
+  static constexpr size_t kMaxKeptNames = 4 * 1024 * 1024;
+
   std::string dirName;
   eos::common::Mapping::VirtualIdentity vid;
-  std::set<std::string> dh_list;
-  std::set<std::string>::const_iterator dh_it;
-  std::mutex mDirLsMutex; ///< Mutex protecting access to dh_list
+  std::shared_ptr<Listing> mListing; ///< listing of the open directory
+  size_t mNumDots {0}; ///< number of . and .. entries of the listing
+  size_t mPos {0}; ///< position of the next entry, dot entries first
+  std::mutex mDirLsMutex; ///< Mutex protecting access to the listing
+  //! Listings in use per container id
+  static std::map<uint64_t, std::weak_ptr<Listing>> sListings;
+  //! Recently closed listings with the time they were closed
+  static std::deque<std::pair<time_t, std::shared_ptr<Listing>>> sKept;
+  static size_t sKeptNames; ///< number of names of the kept listings
+  static std::mutex sListingsMutex; ///< Mutex protecting sListings and sKept
 };
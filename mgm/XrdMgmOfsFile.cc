@@ -44,8 +44,11 @@
 #include "mgm/Macros.hh"
 #include "mgm/ZMQ.hh"
 #include "mgm/Master.hh"
+#include "mgm/GeoTreeEngine.hh"
+#include "mgm/RequestTrace.hh"
 #include "namespace/Prefetcher.hh"
 #include "namespace/Resolver.hh"
+#include "namespace/utils/Attributes.hh"
 #include "authz/XrdCapability.hh"
 #include "XrdOss/XrdOss.hh"
 #include "XrdSec/XrdSecInterface.hh"
@@ -60,6 +63,76 @@
 #define S_IAMB  0x1FF
 #endif
 
+//------------------------------------------------------------------------------
+// Key of a client identity in the open decision cache, made of everything the
+// permission evaluation and the replica selection depend on
+//------------------------------------------------------------------------------
+static std::string
+OpenCacheIdentity(const eos::common::Mapping::VirtualIdentity& vid)
+{
+  std::string ident = std::to_string(vid.uid) + ":" + std::to_string(vid.gid) +
+                      ":" + (vid.sudoer ? "1" : "0") + ":" + vid.prot.c_str() +
+                      ":" + vid.uid_string + ":" + vid.dn + ":" + vid.host + ":" +
+                      vid.geolocation;
+
+  for (const auto& gid : vid.gid_list) {
+    ident += ",";
+    ident += std::to_string(gid);
+  }
+
+  return ident;
+}
+
+//------------------------------------------------------------------------------
+// Version of a file in the open decision cache, attribute and permission
+// changes of the file and of its parent bump their ctime
+//------------------------------------------------------------------------------
+static eos::mgm::OpenDecisionCache::Version
+OpenCacheVersion(const eos::IFileMD* fmd, const eos::IContainerMD* dmd)
+{
+  eos::IFileMD::ctime_t fmtime, fctime;
+  eos::IContainerMD::mtime_t dmtime;
+  eos::IContainerMD::ctime_t dctime;
+  fmd->getMTime(fmtime);
+  fmd->getCTime(fctime);
+  dmd->getMTime(dmtime);
+  dmd->getCTime(dctime);
+  return {{
+      (uint64_t) fmtime.tv_sec, (uint64_t) fmtime.tv_nsec,
+      (uint64_t) fctime.tv_sec, (uint64_t) fctime.tv_nsec,
+      (uint64_t) dmtime.tv_sec, (uint64_t) dmtime.tv_nsec,
+      (uint64_t) dctime.tv_sec, (uint64_t) dctime.tv_nsec
+    }
+  };
+}
+
+//------------------------------------------------------------------------------
+// Version of a directory in the container policy cache, setting or removing
+// an attribute of the directory or of its linked directory bumps their ctime
+//------------------------------------------------------------------------------
+static eos::mgm::ContainerPolicyCache::Version
+PolicyCacheVersion(const eos::IContainerMD* dmd)
+{
+  eos::IContainerMD::ctime_t dctime;
+  eos::IContainerMD::ctime_t lctime {0, 0};
+  dmd->getCTime(dctime);
+
+  if (dmd->hasAttribute(eos::kAttrLinkKey)) {
+    try {
+      gOFS->eosView->getContainer(dmd->getAttribute(eos::kAttrLinkKey))->getCTime(
+        lctime);
+    } catch (eos::MDException& e) {
+      // a missing linked directory is listed as not found
+    }
+  }
+
+  return {{
+      (uint64_t) dctime.tv_sec, (uint64_t) dctime.tv_nsec,
+      (uint64_t) lctime.tv_sec, (uint64_t) lctime.tv_nsec
+    }
+  };
+}
+
 
 /******************************************************************************/
 /* MGM File Interface                                                         */
@@ -94,16 +167,19 @@ XrdMgmOfsFile::open(const char* inpath,
   errno = 0;
   EXEC_TIMING_BEGIN("Open");
   SetLogId(logId, tident);
+  RequestTrace trace("open", logId);
   {
     EXEC_TIMING_BEGIN("IdMap");
     eos::common::Mapping::IdMap(client, ininfo, tident, vid);
     EXEC_TIMING_END("IdMap");
   }
+  trace.Mark("idmap");
   gOFS->MgmStats.Add("IdMap", vid.uid, vid.gid, 1);
   SetLogId(logId, vid, tident);
   NAMESPACEMAP;
   BOUNCE_ILLEGAL_NAMES;
   BOUNCE_NOT_ALLOWED;
+  trace.SetInfo(path, vid.uid, vid.gid);
   XrdOucString spath = path;
   int open_flag = 0;
   int isRW = 0;
@@ -237,21 +313,13 @@ XrdMgmOfsFile::open(const char* inpath,
     const char* val = 0;
 
     if ((val = openOpaque->Get("eos.app"))) {
-      XrdOucString application = val;
-
-      if (application == "fuse") {
-        isFuse = true;
-      }
-
-      if (application.beginswith("fuse::")) {
+      if (!strcmp(val, "fuse") || !strncmp(val, "fuse::", 6)) {
         isFuse = true;
       }
     }
 
     if ((val = openOpaque->Get("xrd.appname"))) {
-      XrdOucString application = val;
-
-      if (application == "xrootdfs") {
+      if (!strcmp(val, "xrootdfs")) {
         isFuse = true;
       }
     }
@@ -463,6 +531,8 @@ XrdMgmOfsFile::open(const char* inpath,
   // Get the directory meta data if it exists
   std::shared_ptr<eos::IContainerMD> dmd = nullptr;
   eos::IContainerMD::XAttrMap attrmap;
+  // parsed policy of the parent directory if it went through the cache
+  std::shared_ptr<const eos::mgm::ContainerPolicyCache::Item> dirItem;
   Acl acl;
   Workflow workflow;
   bool stdpermcheck = false;
@@ -470,14 +540,65 @@ XrdMgmOfsFile::open(const char* inpath,
   uid_t d_uid = vid.uid;
   gid_t d_gid = vid.gid;
   std::string creation_path = path;
-  {
+  // Repeated read opens of an existing file by the same client can reuse the
+  // permission evaluation and the replica selection, see OpenDecisionCache
+  bool useOpenCache = gOFS->mOpenDecisionCache.IsEnabled() && !isRW &&
+                      !isSharedFile && !isPioReconstruct && !ocUploadUuid.length();
+  bool openCacheHit = false;
+  std::string openCacheIdent;
+  eos::mgm::OpenDecisionCache::Version openCacheVersion {{0}};
+  eos::IContainerMD::id_t openCacheCid = 0;
+
+  if (useOpenCache) {
+    openCacheIdent = OpenCacheIdentity(vid);
+
+    if (!byfid) {
+      eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, cPath.GetPath());
+    }
+
+    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
+
+    try {
+      std::shared_ptr<eos::IFileMD> cfmd = gOFS->eosView->getFile(cPath.GetPath());
+      std::shared_ptr<eos::IContainerMD> cdmd =
+        gOFS->eosDirectoryService->getContainerMD(cfmd->getContainerId());
+      eos::mgm::OpenDecisionCache::Access access;
+      openCacheVersion = OpenCacheVersion(cfmd.get(), cdmd.get());
+
+      if (gOFS->mOpenDecisionCache.GetAccess(openCacheIdent, cfmd->getId(),
+                                             openCacheVersion, access)) {
+        fmd = cfmd;
+        dmd = cdmd;
+        attrmap = access.mAttrs;
+        workflow.Init(&attrmap);
+        vid.uid = access.mUid;
+        vid.gid = access.mGid;
+        fileId = fmd->getId();
+        fmdlid = fmd->getLayoutId();
+        cid = fmd->getContainerId();
+        fmdsize = fmd->getSize();
+        d_uid = dmd->getCUid();
+        d_gid = dmd->getCGid();
+        openCacheHit = true;
+        gOFS->MgmStats.Add("OpenCacheHit", vid.uid, vid.gid, 1);
+      }
+    } catch (eos::MDException& e) {
+      // resolved again and reported by the full lookup below
+    }
+  }
+
+  if (!openCacheHit) {
     // This is probably one of the hottest code paths in the MGM, we definitely
     // want prefetching here.
+    trace.Mark("parse");
+
     if (!byfid) {
       eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, cPath.GetPath());
     }
 
+    trace.Mark("prefetch");
     eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex);
+    trace.Mark("ns_lock_wait");
 
     try {
       if (byfid) {
@@ -486,13 +607,34 @@ XrdMgmOfsFile::open(const char* inpath,
         dmd = gOFS->eosView->getContainer(cPath.GetParentPath());
       }
 
-      // get the attributes out
-      gOFS->_attr_ls(gOFS->eosView->getUri(dmd.get()).c_str(), error, vid, 0,
-                     attrmap, false);
+      // get the attributes out, repeated opens in the same directory take
+      // them together with their parsed policy from the cache
+      if (dmd && gOFS->mContainerPolicyCache.IsEnabled()) {
+        eos::mgm::ContainerPolicyCache::Version version = PolicyCacheVersion(
+              dmd.get());
+        dirItem = gOFS->mContainerPolicyCache.Get(dmd->getId(), version);
+
+        if (dirItem) {
+          gOFS->MgmStats.Add("PolicyCacheHit", vid.uid, vid.gid, 1);
+        } else {
+          auto item = std::make_shared<eos::mgm::ContainerPolicyCache::Item>();
+          eos::listAttributes(gOFS->eosView, dmd.get(), item->mAttrs, false);
+          Policy::GetDirPolicy(item->mAttrs, item->mPolicy);
+          gOFS->mContainerPolicyCache.Put(dmd->getId(), version, item);
+          dirItem = item;
+        }
+
+        attrmap = dirItem->mAttrs;
+      } else {
+        gOFS->_attr_ls(gOFS->eosView->getUri(dmd.get()).c_str(), error, vid, 0,
+                       attrmap, false);
+      }
+
       // extract workflows
       workflow.Init(&attrmap);
 
       if (dmd) {
+        openCacheCid = dmd->getId();
         try {
           if (ocUploadUuid.length()) {
             eos::common::Path aPath(cPath.GetAtomicPath(attrmap.count("sys.versioning"),
@@ -635,7 +777,12 @@ XrdMgmOfsFile::open(const char* inpath,
     // ACL and permission check
     // -------------------------------------------------------------------------
     eos::IFileMD::XAttrMap attrmapF;
-    gOFS->_attr_ls(cPath.GetPath(), error, vid, 0, attrmapF, false);
+
+    if (fmd || ocUploadUuid.length()) {
+      // a creation has no file attributes to list
+      gOFS->_attr_ls(cPath.GetPath(), error, vid, 0, attrmapF, false);
+    }
+
     acl.SetFromAttrMap(attrmap, vid, &attrmapF);
     eos_info("acl=%d r=%d w=%d wo=%d egroup=%d shared=%d mutable=%d",
              acl.HasAcl(), acl.CanRead(), acl.CanWrite(), acl.CanWriteOnce(),
@@ -701,8 +848,22 @@ XrdMgmOfsFile::open(const char* inpath,
       return open("/proc/user/", open_mode, Mode, client,
                   fmd->getAttribute("sys.proc").c_str());
     }
+
+    // Files reached through a symbolic link take the attributes of another
+    // directory than their parent, these are not cached
+    if (useOpenCache && fmd && (fmd->getContainerId() == openCacheCid)) {
+      eos::mgm::OpenDecisionCache::Access access;
+      access.mUid = vid.uid;
+      access.mGid = vid.gid;
+      access.mAttrs = attrmap;
+      openCacheVersion = OpenCacheVersion(fmd.get(), dmd.get());
+      gOFS->mOpenDecisionCache.PutAccess(openCacheIdent, fmd->getId(),
+                                         openCacheVersion, access);
+    }
   }
 
+  trace.Mark("namespace");
+
   // Set the versioning depth if it is defined
   if (attrmap.count("sys.versioning")) {
     versioning = atoi(attrmap["sys.versioning"].c_str());
@@ -751,12 +912,7 @@ XrdMgmOfsFile::open(const char* inpath,
     // FUSE mount with lazy-open mode enabled.
     if (!getenv("EOS_ALLOW_RAIN_RWM") && isRewrite && (vid.uid > 3) &&
         (fmdsize != 0) &&
-        ((eos::common::LayoutId::GetLayoutType(fmdlid) ==
-          eos::common::LayoutId::kRaidDP) ||
-         (eos::common::LayoutId::GetLayoutType(fmdlid) ==
-          eos::common::LayoutId::kArchive) ||
-         (eos::common::LayoutId::GetLayoutType(fmdlid) ==
-          eos::common::LayoutId::kRaid6))) {
+        eos::common::LayoutDescriptor(fmdlid).IsRain()) {
       // Unpriviledged users are not allowed to open RAIN files for update
       gOFS->MgmStats.Add("OpenFailedNoUpdate", vid.uid, vid.gid, 1);
       return Emsg(epname, error, EPERM, "update RAIN layout file - "
@@ -840,7 +996,9 @@ XrdMgmOfsFile::open(const char* inpath,
         // creation of a new file or isOcUpload
         {
           // -------------------------------------------------------------------
+          trace.Mark("acl");
           eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+          trace.Mark("ns_lock_wait");
           std::shared_ptr<eos::IFileMD> ref_fmd;
 
           try {
@@ -1009,14 +1167,26 @@ XrdMgmOfsFile::open(const char* inpath,
   unsigned long fsIndex = 0;
   XrdOucString space = "default";
   unsigned long new_lid = 0;
+  trace.Mark("namespace");
   // select space and layout according to policies
-  Policy::GetLayoutAndSpace(path, attrmap, vid, new_lid, space, *openOpaque,
+  Policy::DirPolicy parsedPolicy;
+
+  if (!dirItem) {
+    Policy::GetDirPolicy(attrmap, parsedPolicy);
+  }
+
+  const Policy::DirPolicy& dirPolicy = (dirItem ? dirItem->mPolicy :
+                                        parsedPolicy);
+  Policy::GetLayoutAndSpace(path, dirPolicy, vid, new_lid, space, *openOpaque,
                             forcedFsId, forcedGroup);
   eos::mgm::Scheduler::tPlctPolicy plctplcy;
   std::string targetgeotag;
   // get placement policy
-  Policy::GetPlctPolicy(path, attrmap, vid, *openOpaque, plctplcy, targetgeotag);
+  Policy::GetPlctPolicy(path, dirPolicy, vid, *openOpaque, plctplcy,
+                        targetgeotag);
+  trace.Mark("policy");
   eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
+  trace.Mark("fsview_lock_wait");
   unsigned long long ext_mtime_sec = 0;
   unsigned long long ext_mtime_nsec = 0;
   unsigned long long ext_ctime_sec = 0;
@@ -1076,7 +1246,9 @@ XrdMgmOfsFile::open(const char* inpath,
     layoutId = new_lid;
     {
       std::shared_ptr<eos::IFileMD> fmdnew;
+      trace.Mark("capability");
       eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+      trace.Mark("ns_lock_wait");
 
       if (!byfid) {
         try {
@@ -1275,6 +1447,7 @@ XrdMgmOfsFile::open(const char* inpath,
     plctargs.grouptag = containertag;
     plctargs.lid = layoutId;
     plctargs.inode = (ino64_t) fmd->getId();
+    plctargs.parent_cid = cid;
     plctargs.path = path;
     plctargs.plctTrgGeotag = &targetgeotag;
     plctargs.plctpolicy = plctplcy;
@@ -1289,7 +1462,9 @@ XrdMgmOfsFile::open(const char* inpath,
       return Emsg(epname, error, EINVAL, "open - invalid placement argument", path);
     }
 
+    trace.Mark("capability");
     retc = Quota::FilePlacement(&plctargs);
+    trace.Mark("placement");
 
     // reshuffle the selectedfs by returning as first entry the lowest if the sum of the fsid is odd
     // the highest if the sum is even
@@ -1362,7 +1537,78 @@ XrdMgmOfsFile::open(const char* inpath,
       return Emsg(epname, error, EINVAL, "open - invalid access argument", path);
     }
 
-    retc = Quota::FileAccess(&acsargs);
+    // A selection is only reused for the same locations and filesystem states
+    // and never when the client excludes or forces filesystems or a space
+    bool useReplicaCache = useOpenCache && !isRepair && !isRepairRead &&
+                           tried_cgi.empty() && !forcedFsId &&
+                           !openOpaque->Get("eos.space");
+    bool replicaCacheHit = false;
+    uint64_t fsGeneration = 0;
+    std::vector<unsigned int> locations;
+
+    if (useReplicaCache) {
+      eos::mgm::OpenDecisionCache::Replicas replicas;
+      fsGeneration = gGeoTreeEngine.getFsStatusGeneration();
+      locations = selectedfs;
+
+      if (gOFS->mOpenDecisionCache.GetReplicas(openCacheIdent, fmd->getId(),
+          openCacheVersion, fsGeneration, locations, replicas)) {
+        fsIndex = replicas.mFsIndex;
+        selectedfs = replicas.mSelectedFs;
+        unavailfs = replicas.mUnavailFs;
+        proxys = replicas.mProxys;
+        firewalleps = replicas.mFirewallEps;
+        replicaCacheHit = true;
+        retc = 0;
+      }
+    }
+
+    trace.Mark("capability");
+
+    if (!replicaCacheHit) {
+      std::vector<unsigned int> hotfs;
+      unsigned long ltype = eos::common::LayoutId::GetLayoutType(layoutId);
+
+      if (!acsargs.isRW && !forcedFsId && attrmap.count("sys.tier.hot") &&
+          ((ltype == eos::common::LayoutId::kPlain) ||
+           (ltype == eos::common::LayoutId::kReplica))) {
+        Policy::GetLocationsInSpace(attrmap["sys.tier.hot"], selectedfs, hotfs);
+      }
+
+      retc = ENODATA;
+
+      if (!hotfs.empty() && (hotfs.size() < selectedfs.size())) {
+        // Reads prefer the replicas in the hot space while they exist
+        std::vector<unsigned int> allfs = selectedfs;
+        std::vector<unsigned int> allunavailfs = unavailfs;
+        selectedfs = hotfs;
+        retc = Quota::FileAccess(&acsargs);
+
+        if (retc) {
+          selectedfs = allfs;
+          unavailfs = allunavailfs;
+        }
+      }
+
+      if (retc) {
+        retc = Quota::FileAccess(&acsargs);
+      }
+
+      if (useReplicaCache && (retc == 0)) {
+        eos::mgm::OpenDecisionCache::Replicas replicas;
+        replicas.mLocations = locations;
+        replicas.mFsIndex = fsIndex;
+        replicas.mSelectedFs = selectedfs;
+        replicas.mUnavailFs = unavailfs;
+        replicas.mProxys = proxys;
+        replicas.mFirewallEps = firewalleps;
+        gOFS->mOpenDecisionCache.PutReplicas(openCacheIdent, fmd->getId(),
+                                             openCacheVersion, fsGeneration,
+                                             replicas);
+      }
+    }
+
+    trace.Mark("placement");
 
     if (acsargs.isRW) {
       // if this is an update, we don't have to send the client to cgi excluded locations,
@@ -1401,6 +1647,7 @@ XrdMgmOfsFile::open(const char* inpath,
         plctargs.grouptag = containertag;
         plctargs.lid = layoutId;
         plctargs.inode = (ino64_t) fmd->getId();
+        plctargs.parent_cid = cid;
         plctargs.path = path;
         plctargs.plctTrgGeotag = &targetgeotag;
         plctargs.plctpolicy = plctplcy;
@@ -1860,6 +2107,7 @@ XrdMgmOfsFile::open(const char* inpath,
   // For 'pio' mode we hand out plain layouts to the client and add the IO
   // layout as an extra field
   // ---------------------------------------------------------------------------
+  const eos::common::LayoutDescriptor layout(layoutId);
   std::set<unsigned long> ufs;
   {
     // get the unique number of filesystems
@@ -1872,23 +2120,16 @@ XrdMgmOfsFile::open(const char* inpath,
     }
   }
   new_lid = eos::common::LayoutId::GetId(
-              isPio ? eos::common::LayoutId::kPlain :
-              eos::common::LayoutId::GetLayoutType(layoutId),
-              (isPio ? eos::common::LayoutId::kNone :
-               eos::common::LayoutId::GetChecksum(layoutId)),
+              isPio ? eos::common::LayoutId::kPlain : layout.mType,
+              (isPio ? eos::common::LayoutId::kNone : layout.mChecksum),
               isPioReconstruct ? static_cast<int>(ufs.size()) : static_cast<int>
               (selectedfs.size()),
-              eos::common::LayoutId::GetBlocksizeType(layoutId),
-              eos::common::LayoutId::GetBlockChecksum(layoutId));
-  unsigned long orig_type = eos::common::LayoutId::GetLayoutType(layoutId);
+              layout.mBlocksizeType, layout.mBlockChecksum);
 
   // For RAIN layouts we need to keep the original number of stripes since this
   // is used to compute the different groups and block sizes in the FSTs
-  if ((orig_type == eos::common::LayoutId::kRaidDP) ||
-      (orig_type == eos::common::LayoutId::kRaid6) ||
-      (orig_type == eos::common::LayoutId::kArchive)) {
-    eos::common::LayoutId::SetStripeNumber(new_lid,
-                                           eos::common::LayoutId::GetStripeNumber(layoutId));
+  if (layout.IsRain()) {
+    eos::common::LayoutId::SetStripeNumber(new_lid, layout.mStripes - 1);
   }
 
   capability += "&mgm.lid=";
@@ -1917,8 +2158,7 @@ XrdMgmOfsFile::open(const char* inpath,
                   targetsize);
   }
 
-  if (eos::common::LayoutId::GetLayoutType(layoutId) ==
-      eos::common::LayoutId::kPlain) {
+  if (layout.mType == eos::common::LayoutId::kPlain) {
     capability += "&mgm.fsid=";
     capability += (int) filesystem->GetId();
   }
@@ -1943,14 +2183,7 @@ XrdMgmOfsFile::open(const char* inpath,
   XrdOucString infolog = "";
   XrdOucString piolist = "";
 
-  if ((eos::common::LayoutId::GetLayoutType(layoutId) ==
-       eos::common::LayoutId::kReplica) ||
-      (eos::common::LayoutId::GetLayoutType(layoutId) ==
-       eos::common::LayoutId::kRaidDP) ||
-      (eos::common::LayoutId::GetLayoutType(layoutId) ==
-       eos::common::LayoutId::kArchive) ||
-      (eos::common::LayoutId::GetLayoutType(layoutId) ==
-       eos::common::LayoutId::kRaid6)) {
+  if ((layout.mType == eos::common::LayoutId::kReplica) || layout.IsRain()) {
     capability += "&mgm.fsid=";
     capability += (int) filesystem->GetId();
     eos::mgm::FileSystem* repfilesystem = 0;
@@ -2024,8 +2257,7 @@ XrdMgmOfsFile::open(const char* inpath,
       // compute the size of the stripes to be placed
       // -----------------------------------------------------------------------
       unsigned long long plainBookingSize =
-        fmd->getSize() /
-        (eos::common::LayoutId::GetStripeNumber(layoutId) + 1);
+        fmd->getSize() / layout.mStripes;
       plainBookingSize += 4096;
       plainBookingSize *= PioReconstructFsList.size();
       eos::common::Mapping::VirtualIdentity rootvid;
@@ -2320,12 +2552,15 @@ XrdMgmOfsFile::open(const char* inpath,
   eos_debug("capability=%s\n", capability.c_str());
   int caprc = 0;
   XrdOucEnv* capabilityenvRaw = nullptr;
+  trace.Mark("capability");
 
   if ((caprc = gCapabilityEngine.Create(&incapability, capabilityenvRaw, symkey,
                                         gOFS->mCapabilityValidity))) {
     return Emsg(epname, error, caprc, "sign capability", path);
   }
 
+  trace.Mark("cap_sign");
+
   std::unique_ptr<XrdOucEnv> capabilityenv(capabilityenvRaw);
   int caplen = 0;
 
@@ -2345,8 +2580,7 @@ XrdMgmOfsFile::open(const char* inpath,
       redirectionhost += "&mgm.blockchecksum=";
       redirectionhost += openOpaque->Get("eos.blockchecksum");
     } else {
-      if ((!isRW) && (eos::common::LayoutId::GetLayoutType(layoutId) ==
-                      eos::common::LayoutId::kReplica)) {
+      if ((!isRW) && (layout.mType == eos::common::LayoutId::kReplica)) {
         redirectionhost += "&mgm.blockchecksum=ignore";
       }
     }
@@ -2552,6 +2786,7 @@ XrdMgmOfsFile::close()
 
   if (mProcCmd) {
     mProcCmd->close();
+    ProcInterface::DropCmd(std::move(mProcCmd));
     return SFS_OK;
   }
 
@@ -2762,6 +2997,11 @@ XrdMgmOfsFile::~XrdMgmOfsFile()
     close();
   }
 
+  if (mProcCmd) {
+    mProcCmd->close();
+    ProcInterface::DropCmd(std::move(mProcCmd));
+  }
+
   if (openOpaque) {
     delete openOpaque;
     openOpaque = 0;
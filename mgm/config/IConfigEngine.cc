@@ -231,6 +231,7 @@ IConfigEngine::ApplyConfig(XrdOucString& err, bool apply_stall_redirect)
   (void) Quota::CleanUp();
   {
     eos::common::RWMutexWriteLock wr_lock(eos::common::Mapping::gMapMutex);
+    eos::common::Mapping::gVidCache.Invalidate();
     eos::common::Mapping::gUserRoleVector.clear();
     eos::common::Mapping::gGroupRoleVector.clear();
     eos::common::Mapping::gVirtualUidMap.clear();
@@ -503,6 +504,7 @@ IConfigEngine::ResetConfig(bool apply_stall_redirect)
   (void) Quota::CleanUp();
   {
     eos::common::RWMutexWriteLock wr_lock(eos::common::Mapping::gMapMutex);
+    eos::common::Mapping::gVidCache.Invalidate();
     eos::common::Mapping::gUserRoleVector.clear();
     eos::common::Mapping::gGroupRoleVector.clear();
     eos::common::Mapping::gVirtualUidMap.clear();
@@ -30,9 +30,13 @@
 #include "common/GlobalConfig.hh"
 #include "qclient/QScanner.hh"
 #include <ctime>
+#include <cstdlib>
 
 EOSMGMNAMESPACE_BEGIN
 
+constexpr size_t QuarkDBCfgEngineChangelog::sMaxQueuedEntries;
+constexpr std::chrono::seconds QuarkDBConfigEngine::sBackupInterval;
+
 //------------------------------------------------------------------------------
 //                   **** QuarkDBCfgEngineChangelog class ****
 //------------------------------------------------------------------------------
@@ -44,12 +48,19 @@ QuarkDBCfgEngineChangelog::QuarkDBCfgEngineChangelog(qclient::QClient* client)
   : mQcl(*client) {}
 
 //------------------------------------------------------------------------------
-// Add entry to the changelog
+// Destructor
+//------------------------------------------------------------------------------
+QuarkDBCfgEngineChangelog::~QuarkDBCfgEngineChangelog()
+{
+  Flush();
+}
+
+//------------------------------------------------------------------------------
+// Queue entry for the changelog
 //------------------------------------------------------------------------------
 void QuarkDBCfgEngineChangelog::AddEntry(const std::string& action,
     const std::string& key, const std::string& value)
 {
-  // Add entry to the set
   std::ostringstream oss;
   oss << std::time(NULL) << ": " << action;
 
@@ -57,11 +68,41 @@ void QuarkDBCfgEngineChangelog::AddEntry(const std::string& action,
     oss << " " << key.c_str() << " => " << value.c_str();
   }
 
-  std::time_t now = std::time(NULL);
-  std::stringstream ss;
-  ss << now;
-  std::string timestamp = ss.str();
-  mQcl.exec("deque-push-back", kChangelogKey, oss.str());
+  bool flush = false;
+  {
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    mQueue.push_back(oss.str());
+    flush = (mQueue.size() >= sMaxQueuedEntries);
+  }
+
+  if (flush) {
+    Flush();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Append the queued entries to QuarkDB
+//------------------------------------------------------------------------------
+void QuarkDBCfgEngineChangelog::Flush()
+{
+  // Keep the lock while sending so that batches reach QuarkDB in order
+  std::lock_guard<std::mutex> lock(mQueueMutex);
+
+  if (mQueue.empty()) {
+    return;
+  }
+
+  std::vector<std::string> cmd;
+  cmd.reserve(mQueue.size() + 2);
+  cmd.push_back("deque-push-back");
+  cmd.push_back(kChangelogKey);
+
+  for (auto& entry : mQueue) {
+    cmd.push_back(std::move(entry));
+  }
+
+  mQueue.clear();
+  mQcl.execute(cmd);
   mQcl.exec("deque-trim-front", kChangelogKey, "500000");
 }
 
@@ -70,6 +111,7 @@ void QuarkDBCfgEngineChangelog::AddEntry(const std::string& action,
 //------------------------------------------------------------------------------
 bool QuarkDBCfgEngineChangelog::Tail(unsigned int nlines, XrdOucString& tail)
 {
+  Flush();
   qclient::redisReplyPtr reply = mQcl.exec("deque-scan-back", kChangelogKey, "0",
                                  "COUNT", SSTR(nlines)).get();
 
@@ -126,7 +168,100 @@ QuarkDBConfigEngine::QuarkDBConfigEngine(const QdbContactDetails&
 {
   mQdbContactDetails = contactDetails;
   mQcl = BackendClient::getInstance(mQdbContactDetails, "config");
-  mChangelog.reset(new QuarkDBCfgEngineChangelog(mQcl));
+  mQdbChangelog = new QuarkDBCfgEngineChangelog(mQcl);
+  mChangelog.reset(mQdbChangelog);
+  mFlushThread.reset(&QuarkDBConfigEngine::FlushLoop, this);
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+QuarkDBConfigEngine::~QuarkDBConfigEngine()
+{
+  mFlushThread.join();
+  FlushPending();
+}
+
+//------------------------------------------------------------------------------
+// Get interval between two flushes
+//------------------------------------------------------------------------------
+std::chrono::milliseconds
+QuarkDBConfigEngine::GetFlushInterval()
+{
+  static const std::chrono::milliseconds interval = []() {
+    long long ms = 500;
+    const char* ptr = getenv("EOS_MGM_CONFIG_FLUSH_MS");
+
+    if (ptr) {
+      long long val = strtoll(ptr, nullptr, 10);
+
+      if (val > 0) {
+        ms = val;
+      }
+    }
+
+    return std::chrono::milliseconds(ms);
+  }();
+  return interval;
+}
+
+//------------------------------------------------------------------------------
+// Loop flushing the pending changes
+//------------------------------------------------------------------------------
+void
+QuarkDBConfigEngine::FlushLoop(ThreadAssistant& assistant) noexcept
+{
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(GetFlushInterval());
+    FlushPending();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Mark the current configuration as having pending changes
+//------------------------------------------------------------------------------
+void
+QuarkDBConfigEngine::ScheduleFlush()
+{
+  std::lock_guard<std::mutex> lock(mPendingMutex);
+  mPendingName = mConfigFile.c_str();
+}
+
+//------------------------------------------------------------------------------
+// Write the pending changes to QuarkDB
+//------------------------------------------------------------------------------
+bool
+QuarkDBConfigEngine::FlushPending()
+{
+  mQdbChangelog->Flush();
+  std::lock_guard<std::mutex> flush_lock(mFlushMutex);
+  std::string name;
+  {
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    name.swap(mPendingName);
+  }
+
+  if (name.empty()) {
+    return true;
+  }
+
+  if (name != mStoredName) {
+    storeIntoQuarkDB(name);
+    return true;
+  }
+
+  if (!storeDeltasIntoQuarkDB(name)) {
+    // Retry with the next flush unless there are newer changes
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+
+    if (mPendingName.empty()) {
+      mPendingName = name;
+    }
+
+    return false;
+  }
+
+  return true;
 }
 
 //------------------------------------------------------------------------------
@@ -144,6 +279,8 @@ QuarkDBConfigEngine::LoadConfig(XrdOucEnv& env, XrdOucString& err,
     return false;
   }
 
+  // Don't lose the changes pending for the current configuration
+  FlushPending();
   ResetConfig(apply_stall_redirect);
   std::string hash_key = formConfigHashKey(name);
   eos_notice("HASH KEY NAME => %s", hash_key.c_str());
@@ -153,6 +290,14 @@ QuarkDBConfigEngine::LoadConfig(XrdOucEnv& env, XrdOucString& err,
     return false;
   }
 
+  {
+    // What was just pulled is the base for the deltas
+    std::lock_guard<std::mutex> flush_lock(mFlushMutex);
+    XrdSysMutexHelper lock(mMutex);
+    mStored = sConfigDefinitions;
+    mStoredName = name;
+  }
+
   if (!ApplyConfig(err, apply_stall_redirect))   {
     mChangelog->AddEntry("loaded config", name, SSTR("with failure : " << err));
     return false;
@@ -187,6 +332,7 @@ QuarkDBConfigEngine::SaveConfig(XrdOucEnv& env, XrdOucString& err)
     }
   }
 
+  FlushPending();
   InsertComment(comment);
   // Store a new hash
   std::string hash_key = formConfigHashKey(name);
@@ -200,7 +346,10 @@ QuarkDBConfigEngine::SaveConfig(XrdOucEnv& env, XrdOucString& err)
     return false;
   }
 
-  storeIntoQuarkDB(name);
+  {
+    std::lock_guard<std::mutex> flush_lock(mFlushMutex);
+    storeIntoQuarkDB(name);
+  }
   std::ostringstream changeLogValue;
 
   if (force) {
@@ -229,6 +378,7 @@ bool
 QuarkDBConfigEngine::ListConfigs(XrdOucString& configlist, bool showbackup)
 
 {
+  FlushPending();
   configlist = "Existing Configurations on QuarkDB\n";
   configlist += "================================\n";
   // Get the set from quarkdb with the available configurations
@@ -329,6 +479,7 @@ QuarkDBConfigEngine::FilterConfig(PrintInfo& pinfo, XrdOucString& out,
                                   const char* configName)
 
 {
+  FlushPending();
   qclient::QHash q_hash(*mQcl, formConfigHashKey(configName));
 
   for (auto it = q_hash.getIterator(); it.valid(); it.next()) {
@@ -349,14 +500,11 @@ bool
 QuarkDBConfigEngine::AutoSave()
 {
   if (gOFS->mMaster->IsMaster() && mAutosave && mConfigFile.length()) {
-    XrdOucString envstring = "mgm.config.file=";
-    envstring += mConfigFile;
-    envstring += "&mgm.config.force=1";
-    XrdOucEnv env(envstring.c_str());
-    XrdOucString err = "";
-
-    if (!SaveConfig(env, err)) {
-      eos_static_err("%s\n", err.c_str());
+    ScheduleFlush();
+
+    if (!FlushPending()) {
+      eos_static_err("msg=\"failed to autosave config\" name=\"%s\"",
+                     mConfigFile.c_str());
       return false;
     }
 
@@ -404,17 +552,10 @@ QuarkDBConfigEngine::SetConfigValue(const char* prefix, const char* key,
     mChangelog->AddEntry("set config", formFullKey(prefix, key), val);
   }
 
-  // If the change is not coming from a broacast we can can save it
+  // If the change is not coming from a broacast we can can save it, this is
+  // done in the background by the flush thread
   if (not_bcast && mConfigFile.length()) {
-    XrdOucString envstring = "mgm.config.file=";
-    envstring += mConfigFile;
-    envstring += "&mgm.config.force=1";
-    XrdOucEnv env(envstring.c_str());
-    XrdOucString err = "";
-
-    if (!SaveConfig(env, err)) {
-      eos_static_err("%s\n", err.c_str());
-    }
+    ScheduleFlush();
   }
 }
 
@@ -452,17 +593,10 @@ QuarkDBConfigEngine::DeleteConfigValue(const char* prefix, const char* key,
     mChangelog->AddEntry("del config", formFullKey(prefix, key), "");
   }
 
-  // If the change is not coming from a broacast we can can save it
+  // If the change is not coming from a broacast we can can save it, this is
+  // done in the background by the flush thread
   if (not_bcast && mConfigFile.length()) {
-    XrdOucString envstring = "mgm.config.file=";
-    envstring += mConfigFile;
-    envstring += "&mgm.config.force=1";
-    XrdOucEnv env(envstring.c_str());
-    XrdOucString err = "";
-
-    if (!SaveConfig(env, err)) {
-      eos_static_err("%s\n", err.c_str());
-    }
+    ScheduleFlush();
   }
 
   eos_static_debug("%s", key);
@@ -503,6 +637,7 @@ QuarkDBConfigEngine::PushToQuarkDB(XrdOucEnv& env, XrdOucString& err)
     return false;
   }
 
+  FlushPending();
   ResetConfig();
   ifstream infile(fullpath.c_str());
   std::string s;
@@ -544,7 +679,11 @@ QuarkDBConfigEngine::PushToQuarkDB(XrdOucEnv& env, XrdOucString& err)
         return false;
       }
 
-      storeIntoQuarkDB(name);
+      {
+        std::lock_guard<std::mutex> flush_lock(mFlushMutex);
+        storeIntoQuarkDB(name);
+      }
+
       mChangelog->AddEntry("exported config", name.c_str(), "successfully");
       mConfigFile = name.c_str();
       return true;
@@ -582,6 +721,10 @@ void QuarkDBConfigEngine::storeIntoQuarkDB(const std::string &name) {
   XrdOucString stime;
   getTimeStamp(stime);
   multiBuilder.emplace_back("hset", keyname, "timestamp", std::string(stime.c_str()));
+  // The deltas of the following flushes are computed against this content
+  mStored = sConfigDefinitions;
+  mStoredName = name;
+  mLastBackup = std::chrono::steady_clock::now();
 
   qclient::redisReplyPtr reply = mQcl->execute(multiBuilder.getDeque()).get();
 
@@ -620,6 +763,98 @@ void QuarkDBConfigEngine::storeIntoQuarkDB(const std::string &name) {
   }
 }
 
+//------------------------------------------------------------------------------
+// Store the changes since the last store into given name
+//------------------------------------------------------------------------------
+bool
+QuarkDBConfigEngine::storeDeltasIntoQuarkDB(const std::string& name)
+{
+  std::map<std::string, std::string> current;
+  {
+    XrdSysMutexHelper lock(mMutex);
+    current = sConfigDefinitions;
+  }
+  std::string keyname = formConfigHashKey(name);
+  qclient::MultiBuilder multiBuilder;
+  auto now = std::chrono::steady_clock::now();
+  bool backup = (now - mLastBackup >= sBackupInterval);
+
+  size_t first_change = 0;
+  size_t num_changes = 0;
+
+  if (backup) {
+    multiBuilder.emplace_back("hclone", keyname,
+                              formBackupConfigHashKey(name, time(NULL)));
+    first_change = 1;
+  }
+
+  // Both maps are sorted, walk them in parallel
+  auto it_old = mStored.begin();
+  auto it_new = current.begin();
+
+  while ((it_old != mStored.end()) || (it_new != current.end())) {
+    if ((it_new == current.end()) ||
+        ((it_old != mStored.end()) && (it_old->first < it_new->first))) {
+      multiBuilder.emplace_back("hdel", keyname, it_old->first);
+      ++num_changes;
+      ++it_old;
+    } else if ((it_old == mStored.end()) || (it_new->first < it_old->first)) {
+      multiBuilder.emplace_back("hset", keyname, it_new->first, it_new->second);
+      ++num_changes;
+      ++it_new;
+    } else {
+      if (it_old->second != it_new->second) {
+        multiBuilder.emplace_back("hset", keyname, it_new->first,
+                                  it_new->second);
+        ++num_changes;
+      }
+
+      ++it_old;
+      ++it_new;
+    }
+  }
+
+  if (num_changes == 0) {
+    return true;
+  }
+
+  XrdOucString stime;
+  getTimeStamp(stime);
+  multiBuilder.emplace_back("hset", keyname, "timestamp",
+                            std::string(stime.c_str()));
+  qclient::redisReplyPtr reply = mQcl->execute(multiBuilder.getDeque()).get();
+
+  if (!reply || (reply->type != REDIS_REPLY_ARRAY) ||
+      (reply->elements != first_change + num_changes + 1)) {
+    eos_static_crit("msg=\"unexpected response from QDB when storing "
+                    "configuration changes\" reply=\"%s\"",
+                    qclient::describeRedisReply(reply).c_str());
+    return false;
+  }
+
+  for (size_t i = first_change; i < reply->elements; i++) {
+    qclient::IntegerParser parser(reply->element[i]);
+
+    if (!parser.ok()) {
+      eos_static_crit("msg=\"unexpected response from QDB when storing "
+                      "configuration changes\" err=\"%s\"",
+                      parser.err().c_str());
+      return false;
+    }
+  }
+
+  mStored = std::move(current);
+
+  if (backup) {
+    mLastBackup = now;
+  }
+
+  eos_static_debug("msg=\"stored configuration changes\" name=\"%s\" "
+                   "num_changes=%llu", name.c_str(),
+                   (unsigned long long) num_changes);
+  return true;
+}
+
 //------------------------------------------------------------------------------
 // Get current timestamp
 //------------------------------------------------------------------------------
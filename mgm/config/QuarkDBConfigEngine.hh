@@ -31,15 +31,27 @@
 #include "namespace/ns_quarkdb/qclient/include/qclient/AsyncHandler.hh"
 #include "namespace/ns_quarkdb/qclient/include/qclient/QClient.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
+#include "common/AssistedThread.hh"
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
 
 EOSMGMNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
 //! Class QuarkDBCfgEngineChangelog
+//!
+//! The entries are queued and appended to QuarkDB in batches by Flush, which
+//! the config engine calls periodically. Tail flushes the queue first.
 //------------------------------------------------------------------------------
 class QuarkDBCfgEngineChangelog : public ICfgEngineChangelog
 {
 public:
+  //! Number of queued entries which triggers a flush from AddEntry
+  static constexpr size_t sMaxQueuedEntries = 10000;
+
   //----------------------------------------------------------------------------
   //! Constructor
   //!
@@ -50,10 +62,10 @@ public:
   //----------------------------------------------------------------------------
   //! Destructor
   //----------------------------------------------------------------------------
-  virtual ~QuarkDBCfgEngineChangelog() = default;
+  virtual ~QuarkDBCfgEngineChangelog();
 
   //----------------------------------------------------------------------------
-  //! Add entry to the changelog
+  //! Queue entry for the changelog
   //!
   //! @param key      entry action
   //! @param value    entry key
@@ -72,18 +84,37 @@ public:
   //----------------------------------------------------------------------------
   bool Tail(unsigned int nlines, XrdOucString& tail);
 
+  //----------------------------------------------------------------------------
+  //! Append the queued entries to QuarkDB with a single push and trim,
+  //! without waiting for the reply
+  //----------------------------------------------------------------------------
+  void Flush();
+
 private:
   const std::string kChangelogKey = "eos-config-changelog"; ///< Changelog key
   qclient::QClient& mQcl;
+  std::mutex mQueueMutex; ///< Protects the queue and orders the flushes
+  std::vector<std::string> mQueue; ///< Entries not yet sent to QuarkDB
 };
 
 
 //------------------------------------------------------------------------------
 //! Class QuarkDBConfigEngine
+//!
+//! Configuration changes are written behind: Set/DeleteConfigValue only mark
+//! the current configuration as dirty and a background thread writes the
+//! difference to what was last stored as one pipelined transaction of HSET
+//! and HDEL commands. AutoSave and every operation reading the configuration
+//! back from QuarkDB first flush the pending changes. Full dumps, together
+//! with a backup, are only done by an explicit save or push and at most once
+//! per sBackupInterval by the incremental flushes.
 //------------------------------------------------------------------------------
 class QuarkDBConfigEngine : public IConfigEngine
 {
 public:
+  //! Min time between two backups of the configuration done by the flushes
+  static constexpr std::chrono::seconds sBackupInterval {3600};
+
   //----------------------------------------------------------------------------
   //! Constructor
   //!
@@ -95,7 +126,7 @@ public:
   //----------------------------------------------------------------------------
   //! Destructor
   //----------------------------------------------------------------------------
-  virtual ~QuarkDBConfigEngine() = default;
+  virtual ~QuarkDBConfigEngine();
 
   //----------------------------------------------------------------------------
   //! Load a given configuratino file
@@ -133,10 +164,19 @@ public:
 
 
   //----------------------------------------------------------------------------
-  //! Do an autosave
+  //! Do an autosave i.e. write the pending changes to the current
+  //! configuration and wait for them to be stored
   //----------------------------------------------------------------------------
   bool AutoSave();
 
+  //----------------------------------------------------------------------------
+  //! Write the pending changes of the configuration and of the changelog to
+  //! QuarkDB and wait for the configuration changes to be stored
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool FlushPending();
+
   //----------------------------------------------------------------------------
   //! Set a configuration value
   //!
@@ -196,12 +236,48 @@ public:
 
 private:
   //----------------------------------------------------------------------------
-  // Store configuration into given name
+  //! Store the whole configuration into given name, after taking a backup
+  //!
+  //! @note must be called with mFlushMutex locked
   //----------------------------------------------------------------------------
   void storeIntoQuarkDB(const std::string &name);
 
+  //----------------------------------------------------------------------------
+  //! Store the changes since the last store into given name
+  //!
+  //! @note must be called with mFlushMutex locked
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool storeDeltasIntoQuarkDB(const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Mark the current configuration as having pending changes
+  //----------------------------------------------------------------------------
+  void ScheduleFlush();
+
+  //----------------------------------------------------------------------------
+  //! Loop flushing the pending changes
+  //----------------------------------------------------------------------------
+  void FlushLoop(ThreadAssistant& assistant) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Get interval between two flushes, from EOS_MGM_CONFIG_FLUSH_MS
+  //----------------------------------------------------------------------------
+  static std::chrono::milliseconds GetFlushInterval();
+
   QdbContactDetails mQdbContactDetails;
   qclient::QClient* mQcl;
+  QuarkDBCfgEngineChangelog* mQdbChangelog; ///< Same object as mChangelog
+  std::mutex mPendingMutex; ///< Protects mPendingName
+  //! Configuration with pending changes, empty if there are none
+  std::string mPendingName;
+  std::mutex mFlushMutex; ///< Serializes the stores into QuarkDB
+  //! Configuration last stored and its content, used to compute the deltas
+  std::string mStoredName;
+  std::map<std::string, std::string> mStored;
+  std::chrono::steady_clock::time_point mLastBackup; ///< Time of last backup
+  AssistedThread mFlushThread; ///< Thread writing the pending changes
   const std::string kConfigurationHashKeyPrefix = "eos-config";
   const std::string kConfigurationBackupHashKeyPrefix = "eos-config-backup";
 
@@ -35,20 +35,24 @@ using namespace std::chrono;
 
 constexpr std::chrono::seconds DrainFs::sRefreshTimeout;
 constexpr std::chrono::seconds DrainFs::sStallTimeout;
+constexpr std::chrono::seconds DrainFs::sStoreInterval;
 
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-DrainFs::DrainFs(eos::common::ThreadPool& thread_pool, eos::IFsView* fs_view,
+DrainFs::DrainFs(eos::common::ThreadPool& thread_pool,
+                 DrainScheduler& scheduler, eos::IFsView* fs_view,
                  eos::common::FileSystem::fsid_t src_fsid,
                  eos::common::FileSystem::fsid_t dst_fsid):
   mNsFsView(fs_view), mFsId(src_fsid), mTargetFsId(dst_fsid),
   mStatus(eos::common::FileSystem::kNoDrain),
-  mDrainStop(false), mMaxRetries(1), mMaxJobs(10),
-  mDrainPeriod(0), mThreadPool(thread_pool), mTotalFiles(0ull),
+  mDrainStop(false), mKeepProgress(false), mMaxRetries(1), mMaxJobs(10),
+  mDrainPeriod(0), mThreadPool(thread_pool), mScheduler(scheduler),
+  mTotalFiles(0ull),
   mPending(0ull), mLastPending(0ull),
   mLastProgressTime(steady_clock::now()),
-  mLastUpdateTime(steady_clock::now()), mSpace()
+  mLastUpdateTime(steady_clock::now()), mSpace(), mHostPort(),
+  mProgress(src_fsid), mLastStoreTime(steady_clock::now())
 {}
 
 //------------------------------------------------------------------------------
@@ -100,6 +104,10 @@ DrainFs::DoIt()
   eos_notice("msg=\"start draining\" fsid=%d", mFsId);
 
   if (!PrepareFs()) {
+    if (mDrainStop && !mKeepProgress) {
+      mProgress.Clear();
+    }
+
     return State::Failed;
   }
 
@@ -107,6 +115,7 @@ DrainFs::DoIt()
   mPending = mTotalFiles;
 
   if (mTotalFiles == 0) {
+    mProgress.Clear();
     SuccessfulDrain();
     return State::Done;
   }
@@ -115,26 +124,103 @@ DrainFs::DoIt()
     return State::Failed;
   }
 
+  // Resume the drain of a previous run of the MGM. The first pass skips the
+  // files up to the cursor, the ones still on the file system afterwards are
+  // handled by a rerun pass which belongs to the same attempt.
+  bool resume = mProgress.Load();
+
+  if (resume) {
+    eos_notice("msg=\"resume draining\" fsid=%d attempt=%u cursor=%s "
+               "failed=%lu", mFsId, mProgress.mAttempt, mProgress.mCursor.c_str(),
+               (unsigned long) mProgress.mFailed.size());
+    ntried = mProgress.mAttempt - 1;
+    // Keep the deadline of the original drain
+    time_t elapsed = time(NULL) - mProgress.mStartTime;
+
+    if (mProgress.mStartTime && (elapsed > 0)) {
+      mDrainStart -= seconds(elapsed);
+      mDrainEnd = mDrainStart + mDrainPeriod;
+    }
+
+    for (const auto& elem : mProgress.mFailed) {
+      std::shared_ptr<DrainTransferJob> job {
+        new DrainTransferJob(elem.first, mFsId, mTargetFsId)};
+      job->SetStatus(DrainTransferJob::Status::Failed);
+      job->SetErrorString(elem.second);
+      mJobsFailed.push_back(job);
+    }
+  } else {
+    mProgress.Clear();
+    mProgress.mStartTime = time(NULL);
+  }
+
+  mScheduler.Register(mHostPort, mFsId);
+
   do { // Loop to drain the files
+    bool skip_handled = resume;
+
     // If this is not the first attempt then reset the counters
-    if (++ntried != 1) {
+    if (!resume && (++ntried != 1)) {
       mTotalFiles = mNsFsView->getNumFilesOnFs(mFsId);
       mPending = mTotalFiles;
     }
 
-    eos_info("msg=\"drain attempt %i\\%i\" fsid=%llu", ntried,
+    if (!resume) {
+      mProgress.mCursor.clear();
+      mProgress.mScanCursor = "0";
+    }
+
+    resume = false;
+    mProgress.mAttempt = (skip_handled ? ntried + 1 : ntried);
+    mProgress.Store();
+    mLastStoreTime = steady_clock::now();
+    eos_info("msg=\"drain attempt %i\\%i\" fsid=%llu", mProgress.mAttempt,
              mMaxRetries.load(), mFsId);
 
-    for (auto it_fids = mNsFsView->getStreamingFileList(mFsId);
-         it_fids && it_fids->valid(); /* no progress */) {
-      if (mJobsRunning.size() <= mMaxJobs) {
-        std::shared_ptr<DrainTransferJob> job {
-          new DrainTransferJob(it_fids->getElement(), mFsId, mTargetFsId)};
-        mJobsRunning.push_back(job);
-        mThreadPool.PushTask<void>([job] {return job->DoIt();});
-        // Advance to the next file id to be drained
+    // Page through the file list with bounded memory, a resumed drain starts
+    // with the page holding the cursor
+    auto it_fids = mNsFsView->getPagedFileList(mFsId, skip_handled ?
+                   mProgress.mScanCursor : "0",
+                   eos::IFsView::kFileListPageSize);
+
+    while (it_fids && it_fids->valid()) {
+      // Files up to the cursor were handled by the previous run
+      if (skip_handled && mProgress.IsBeforeCursor(it_fids->getElement())) {
         it_fids->next();
-        --mPending;
+
+        if (mPending) {
+          --mPending;
+        }
+
+        continue;
+      }
+
+      if (mJobsRunning.size() <= mMaxJobs) {
+        // The scheduler delays the job if the node has no bandwidth left or
+        // other drains of the node are behind
+        auto ticket = mScheduler.Admit(mHostPort, mFsId);
+
+        if (ticket) {
+          std::shared_ptr<DrainTransferJob> job {
+            new DrainTransferJob(it_fids->getElement(), mFsId, mTargetFsId)};
+          job->SetTicket(std::move(ticket));
+          mJobsRunning.push_back(job);
+          mThreadPool.PushTask<void>([job] {return job->DoIt();});
+
+          if (mProgress.IsEnabled()) {
+            mProgress.mCursor = std::to_string(job->GetFileId());
+            mProgress.mScanCursor = it_fids->getCursor();
+
+            if (steady_clock::now() - mLastStoreTime > sStoreInterval) {
+              mProgress.Store();
+              mLastStoreTime = steady_clock::now();
+            }
+          }
+
+          // Advance to the next file id to be drained
+          it_fids->next();
+          --mPending;
+        }
       }
 
       HandleRunningJobs();
@@ -145,6 +231,12 @@ DrainFs::DoIt()
       }
     }
 
+    // All files listed were handed out, including the ones skipped in pages
+    // before the scan cursor. New files are picked up by a rerun.
+    if (!mDrainStop && !(it_fids && it_fids->valid())) {
+      mPending = 0;
+    }
+
     do {
       HandleRunningJobs();
       state = UpdateProgress();
@@ -162,11 +254,19 @@ DrainFs::DoIt()
     state = State::Stopped;
   }
 
+  if (state == State::Stopped && mKeepProgress) {
+    mProgress.Store();
+  } else {
+    mProgress.Clear();
+  }
+
   if (state == State::Rerun) {
     DrainFs::FailedDrain();
     state = State::Failed;
   }
 
+  mScheduler.Unregister(mHostPort, mFsId);
+
   eos_notice("msg=\"finished draining\" fsid=%d state=%i", mFsId, state);
   return state;
 }
@@ -182,6 +282,7 @@ DrainFs::HandleRunningJobs()
     if ((*it)->GetStatus() == DrainTransferJob::Status::OK) {
       it = mJobsRunning.erase(it);
     } else if ((*it)->GetStatus() == DrainTransferJob::Status::Failed) {
+      mProgress.AddFailed((*it)->GetFileId(), (*it)->GetErrorString());
       mJobsFailed.push_back(*it);
       it = mJobsRunning.erase(it);
     } else {
@@ -198,8 +299,9 @@ DrainFs::HandleRunningJobs()
 // Signal the stop of the file system drain
 //---------------------------------------------------------------------------
 void
-DrainFs::SignalStop()
+DrainFs::SignalStop(bool keep_progress)
 {
+  mKeepProgress.store(keep_progress);
   mDrainStop.store(true);
 }
 
@@ -313,6 +415,7 @@ DrainFs::PrepareFs()
     eos::common::FileSystem::fs_snapshot_t drain_snapshot;
     fs->SnapShotFileSystem(drain_snapshot, false);
     mSpace = drain_snapshot.mSpace;
+    mHostPort = drain_snapshot.mHostPort;
   }
   mDrainStart = steady_clock::now();
   mDrainEnd = mDrainStart + mDrainPeriod;
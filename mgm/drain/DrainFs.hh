@@ -25,6 +25,8 @@
 #include "mgm/Namespace.hh"
 #include "mgm/FileSystem.hh"
 #include "mgm/drain/DrainTransferJob.hh"
+#include "mgm/drain/DrainScheduler.hh"
+#include "mgm/drain/DrainProgress.hh"
 #include "namespace/interface/IFsView.hh"
 #include "common/Logging.hh"
 #include <thread>
@@ -56,11 +58,13 @@ public:
   //! Constructor
   //!
   //! @param thread_pool drain thread pool to use for jobs
+  //! @param scheduler drain scheduler admitting the jobs
   //! @param fs_view file system view
   //! @param src_fsid filesystem id to drain
   //! @param dst_fsid file system where to drain
   //----------------------------------------------------------------------------
-  DrainFs(eos::common::ThreadPool& thread_pool, eos::IFsView* fs_view,
+  DrainFs(eos::common::ThreadPool& thread_pool, DrainScheduler& scheduler,
+          eos::IFsView* fs_view,
           eos::common::FileSystem::fsid_t src_fsid,
           eos::common::FileSystem::fsid_t dst_fsid = 0);
 
@@ -71,8 +75,12 @@ public:
 
   //----------------------------------------------------------------------------
   //! Signal the stop of the file system drain
+  //!
+  //! @param keep_progress if true the persisted progress is kept so that the
+  //!        drain resumes from there the next time it is started e.g. after
+  //!        a restart or failover of the MGM
   //---------------------------------------------------------------------------
-  void SignalStop();
+  void SignalStop(bool keep_progress = false);
 
   //----------------------------------------------------------------------------
   //! Get the list of failed drain jobs
@@ -194,11 +202,14 @@ private:
 
   constexpr static std::chrono::seconds sRefreshTimeout {60};
   constexpr static std::chrono::seconds sStallTimeout {600};
+  //! Interval between updates of the persisted drain progress
+  constexpr static std::chrono::seconds sStoreInterval {10};
   eos::IFsView* mNsFsView; ///< File system view
   eos::common::FileSystem::fsid_t mFsId; ///< Drain source fsid
   eos::common::FileSystem::fsid_t mTargetFsId; /// Drain target fsid
   eos::common::FileSystem::eDrainStatus mStatus;
   std::atomic<bool> mDrainStop; ///< Flag to cancel an ongoing draining
+  std::atomic<bool> mKeepProgress; ///< Keep the persisted progress on stop
   std::atomic<std::uint32_t> mMaxRetries; ///< Max number of retries
   std::atomic<std::uint32_t> mMaxJobs; ///< Max number of drain jobs
   std::chrono::seconds mDrainPeriod; ///< Allowed time for file system to drain
@@ -211,6 +222,7 @@ private:
   //! Collection of running drain jobs
   std::list<std::shared_ptr<DrainTransferJob>> mJobsRunning;
   eos::common::ThreadPool& mThreadPool;
+  DrainScheduler& mScheduler; ///< Scheduler admitting the drain jobs
   std::future<State> mFuture;
   uint64_t mTotalFiles; ///< Total number of files to drain
   uint64_t mPending; ///< Current num. of pending files to drain
@@ -220,6 +232,10 @@ private:
   //! Last timestamp when drain status was updated
   std::chrono::time_point<std::chrono::steady_clock> mLastUpdateTime;
   std::string mSpace; ///< Space name to which fs is attached
+  std::string mHostPort; ///< Node of the file system
+  DrainProgress mProgress; ///< Progress persisted in QuarkDB
+  //! Last timestamp when the drain progress was persisted
+  std::chrono::time_point<std::chrono::steady_clock> mLastStoreTime;
 };
 
 EOSMGMNAMESPACE_END
@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------------
+// File: DrainProgress.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/drain/DrainProgress.hh"
+#include "mgm/XrdMgmOfs.hh"
+#include "common/Logging.hh"
+#include "namespace/ns_quarkdb/BackendClient.hh"
+#include "namespace/ns_quarkdb/qclient/include/qclient/QHash.hh"
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+DrainProgress::DrainProgress(fsid_t fsid):
+  mScanCursor("0"), mAttempt(0), mStartTime(0), mQcl(nullptr),
+  mStateKey(SSTR("eos-drain-state:" << fsid)),
+  mFailedKey(SSTR("eos-drain-failed:" << fsid))
+{
+  if (!gOFS->mQdbCluster.empty()) {
+    mQcl = eos::BackendClient::getInstance(gOFS->mQdbContactDetails, "drain");
+  }
+}
+
+//------------------------------------------------------------------------------
+// Load the progress of a previous drain run
+//------------------------------------------------------------------------------
+bool
+DrainProgress::Load()
+{
+  mCursor.clear();
+  mScanCursor = "0";
+  mAttempt = 0;
+  mStartTime = 0;
+  mFailed.clear();
+
+  if (!mQcl) {
+    return false;
+  }
+
+  try {
+    qclient::QHash state(*mQcl, mStateKey);
+
+    for (auto it = state.getIterator(); it.valid(); it.next()) {
+      if (it.getKey() == "cursor") {
+        mCursor = it.getValue();
+      } else if (it.getKey() == "scan") {
+        mScanCursor = it.getValue();
+      } else if (it.getKey() == "attempt") {
+        mAttempt = std::stoul(it.getValue());
+      } else if (it.getKey() == "start") {
+        mStartTime = std::stoll(it.getValue());
+      }
+    }
+
+    if (mAttempt == 0) {
+      return false;
+    }
+
+    qclient::QHash failed(*mQcl, mFailedKey);
+
+    for (auto it = failed.getIterator(); it.valid(); it.next()) {
+      mFailed[std::stoull(it.getKey())] = it.getValue();
+    }
+  } catch (const std::exception& e) {
+    eos_static_err("msg=\"failed to load drain progress\" key=%s err=\"%s\"",
+                   mStateKey.c_str(), e.what());
+    mCursor.clear();
+    mScanCursor = "0";
+    mAttempt = 0;
+    mFailed.clear();
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Store the cursors, attempt and start time
+//------------------------------------------------------------------------------
+void
+DrainProgress::Store()
+{
+  if (mQcl) {
+    mQcl->exec("hmset", mStateKey, "cursor", mCursor, "scan", mScanCursor,
+               "attempt", std::to_string(mAttempt),
+               "start", std::to_string(mStartTime));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Record a failed drain job
+//------------------------------------------------------------------------------
+void
+DrainProgress::AddFailed(fileid_t fid, const std::string& error)
+{
+  if (mQcl) {
+    mQcl->exec("hset", mFailedKey, std::to_string(fid), error);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove the persisted progress
+//------------------------------------------------------------------------------
+void
+DrainProgress::Clear()
+{
+  mCursor.clear();
+  mScanCursor = "0";
+  mAttempt = 0;
+  mStartTime = 0;
+  mFailed.clear();
+
+  if (mQcl) {
+    mQcl->exec("del", mStateKey, mFailedKey);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check if a file id was already handled before the cursor
+//------------------------------------------------------------------------------
+bool
+DrainProgress::IsBeforeCursor(fileid_t fid) const
+{
+  return (!mCursor.empty() && (std::to_string(fid) <= mCursor));
+}
+
+EOSMGMNAMESPACE_END
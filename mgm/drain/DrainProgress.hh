@@ -0,0 +1,118 @@
+//------------------------------------------------------------------------------
+//! @file DrainProgress.hh
+//! @brief Persistency of the drain progress of a file system in QuarkDB
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/FileId.hh"
+#include "common/FileSystem.hh"
+#include <map>
+#include <string>
+
+namespace qclient
+{
+class QClient;
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Class persisting the progress of a file system drain in QuarkDB
+//!
+//! The state hash eos-drain-state:<fsid> holds the cursor, i.e. the last file
+//! id handed out from the streaming file list of the file system, the drain
+//! attempt, the start time of the drain and the scan cursor of the page of
+//! the file list holding the cursor. The hash eos-drain-failed:<fsid>
+//! maps the file ids of the failed drain jobs to their error message. The
+//! streaming file list of the QuarkDB namespace returns the file ids in the
+//! lexicographic order of their decimal representation, so all file ids up
+//! to the cursor were already handled by the previous drain run. Without a
+//! QuarkDB namespace nothing is persisted. A resumed drain starts paging
+//! through the file list at the scan cursor and skips the file ids up to
+//! the cursor within that page.
+//------------------------------------------------------------------------------
+class DrainProgress
+{
+public:
+  using fsid_t = eos::common::FileSystem::fsid_t;
+  using fileid_t = eos::common::FileId::fileid_t;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param fsid file system under drain
+  //----------------------------------------------------------------------------
+  DrainProgress(fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Load the progress of a previous drain run
+  //!
+  //! @return true if progress was found, otherwise false
+  //----------------------------------------------------------------------------
+  bool Load();
+
+  //----------------------------------------------------------------------------
+  //! Store the cursors, attempt and start time asynchronously
+  //----------------------------------------------------------------------------
+  void Store();
+
+  //----------------------------------------------------------------------------
+  //! Record a failed drain job asynchronously
+  //!
+  //! @param fid file id
+  //! @param error error message of the job
+  //----------------------------------------------------------------------------
+  void AddFailed(fileid_t fid, const std::string& error);
+
+  //----------------------------------------------------------------------------
+  //! Remove the persisted progress
+  //----------------------------------------------------------------------------
+  void Clear();
+
+  //----------------------------------------------------------------------------
+  //! Check if a file id was already handled before the cursor
+  //!
+  //! @param fid file id from the streaming file list
+  //----------------------------------------------------------------------------
+  bool IsBeforeCursor(fileid_t fid) const;
+
+  //----------------------------------------------------------------------------
+  //! Check if progress is persisted
+  //----------------------------------------------------------------------------
+  inline bool IsEnabled() const
+  {
+    return (mQcl != nullptr);
+  }
+
+  std::string mCursor; ///< Last file id handed out, empty if none
+  std::string mScanCursor; ///< Cursor of the file list page holding mCursor
+  uint32_t mAttempt; ///< Drain attempt, 0 if no previous run
+  time_t mStartTime; ///< Start of the drain
+  std::map<fileid_t, std::string> mFailed; ///< Failed jobs of the last run
+
+private:
+  qclient::QClient* mQcl; ///< QuarkDB client, nullptr if not persisted
+  std::string mStateKey; ///< Key of the state hash
+  std::string mFailedKey; ///< Key of the failed jobs hash
+};
+
+EOSMGMNAMESPACE_END
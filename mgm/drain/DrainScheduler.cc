@@ -0,0 +1,362 @@
+//------------------------------------------------------------------------------
+// File: DrainScheduler.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/drain/DrainScheduler.hh"
+#include "mgm/FsView.hh"
+#include <algorithm>
+#include <cstdlib>
+
+EOSMGMNAMESPACE_BEGIN
+
+using namespace std::chrono;
+
+constexpr uint64_t DrainScheduler::sDefaultEstimate;
+constexpr double DrainScheduler::sBurstSeconds;
+constexpr std::chrono::seconds DrainScheduler::sRefreshInterval;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Read a non-negative value from the environment
+//------------------------------------------------------------------------------
+uint64_t
+GetEnvValue(const char* name, uint64_t def)
+{
+  const char* ptr = getenv(name);
+
+  if (!ptr) {
+    return def;
+  }
+
+  long long val = strtoll(ptr, nullptr, 10);
+  return (val >= 0 ? (uint64_t) val : def);
+}
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+DrainScheduler::DrainScheduler():
+  mFsInflightLimit(GetEnvValue("EOS_MGM_DRAIN_FS_INFLIGHT_MB", 4096) *
+                   1024 * 1024),
+  mNodeShare(std::min<uint64_t>(GetEnvValue("EOS_MGM_DRAIN_NODE_BW_PERCENT",
+                                50), 100) / 100.0),
+  mLastRefresh(0)
+{}
+
+//------------------------------------------------------------------------------
+// Register a draining file system
+//------------------------------------------------------------------------------
+void
+DrainScheduler::Register(const std::string& node, fsid_t fsid)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mNodes[node].mDrains.emplace(fsid, 0);
+  // Pick up the bandwidth of a new node with the next admission
+  mLastRefresh = 0;
+}
+
+//------------------------------------------------------------------------------
+// Unregister a draining file system
+//------------------------------------------------------------------------------
+void
+DrainScheduler::Unregister(const std::string& node, fsid_t fsid)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mNodes.find(node);
+
+  if (it == mNodes.end()) {
+    return;
+  }
+
+  it->second.mDrains.erase(fsid);
+
+  if (it->second.mDrains.empty() && (it->second.mInflight == 0)) {
+    mNodes.erase(it);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Refill the bucket of a node
+//------------------------------------------------------------------------------
+void
+DrainScheduler::Refill(Node& node, time_point now)
+{
+  if (node.mRate > 0) {
+    double elapsed = duration<double>(now - node.mLast).count();
+
+    if (elapsed > 0) {
+      node.mTokens = std::min(node.mTokens + elapsed * node.mRate,
+                              node.mRate * sBurstSeconds);
+    }
+  }
+
+  node.mLast = now;
+}
+
+//------------------------------------------------------------------------------
+// Try to admit a new job, refreshing the node bandwidth if due
+//------------------------------------------------------------------------------
+std::unique_ptr<DrainScheduler::Ticket>
+DrainScheduler::Admit(const std::string& node, fsid_t fsid)
+{
+  int64_t now_sec = duration_cast<seconds>
+                    (steady_clock::now().time_since_epoch()).count();
+  int64_t last = mLastRefresh.load();
+
+  if ((now_sec - last >= sRefreshInterval.count()) &&
+      mLastRefresh.compare_exchange_strong(last, now_sec)) {
+    RefreshRates();
+  }
+
+  return Admit(node, fsid, steady_clock::now());
+}
+
+//------------------------------------------------------------------------------
+// Try to admit a new job at a given time
+//------------------------------------------------------------------------------
+std::unique_ptr<DrainScheduler::Ticket>
+DrainScheduler::Admit(const std::string& node, fsid_t fsid, time_point now)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  Node& snode = mNodes[node];
+  Refill(snode, now);
+
+  if ((snode.mRate > 0) && (snode.mTokens <= 0)) {
+    return nullptr;
+  }
+
+  auto it = snode.mDrains.emplace(fsid, 0).first;
+
+  // Don't let a drain get ahead of the other drains of the same node
+  if ((snode.mDrains.size() > 1) &&
+      (it->second * snode.mDrains.size() > snode.mInflight)) {
+    return nullptr;
+  }
+
+  uint64_t bytes = snode.mEstimate;
+
+  if (snode.mRate > 0) {
+    snode.mTokens -= bytes;
+  }
+
+  snode.mInflight += bytes;
+  it->second += bytes;
+  return std::unique_ptr<Ticket>(new Ticket(*this, node, fsid, bytes));
+}
+
+//------------------------------------------------------------------------------
+// Account the size and destination of an admitted job
+//------------------------------------------------------------------------------
+void
+DrainScheduler::Start(Ticket& ticket, fsid_t dst_fsid, uint64_t size)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mNodes.find(ticket.mNode);
+
+  if (it != mNodes.end()) {
+    Node& snode = it->second;
+
+    if (snode.mRate > 0) {
+      snode.mTokens -= ((double) size - (double) ticket.mBytes);
+    }
+
+    snode.mInflight = snode.mInflight - ticket.mBytes + size;
+    auto it_drain = snode.mDrains.find(ticket.mSrcFsId);
+
+    if (it_drain != snode.mDrains.end()) {
+      it_drain->second = it_drain->second - ticket.mBytes + size;
+    }
+
+    snode.mEstimate = (snode.mEstimate * 7 + size) / 8;
+  }
+
+  if (ticket.mDstFsId) {
+    mDstInflight[ticket.mDstFsId] -= ticket.mBytes;
+  }
+
+  ticket.mBytes = size;
+  ticket.mDstFsId = dst_fsid;
+
+  if (dst_fsid) {
+    mDstInflight[dst_fsid] += size;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Release the bytes accounted for a job
+//------------------------------------------------------------------------------
+void
+DrainScheduler::Release(Ticket& ticket)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mNodes.find(ticket.mNode);
+
+  if (it != mNodes.end()) {
+    Node& snode = it->second;
+    snode.mInflight -= ticket.mBytes;
+    auto it_drain = snode.mDrains.find(ticket.mSrcFsId);
+
+    if (it_drain != snode.mDrains.end()) {
+      it_drain->second -= ticket.mBytes;
+    }
+
+    if (snode.mDrains.empty() && (snode.mInflight == 0)) {
+      mNodes.erase(it);
+    }
+  }
+
+  if (ticket.mDstFsId) {
+    auto it_dst = mDstInflight.find(ticket.mDstFsId);
+
+    if ((it_dst != mDstInflight.end()) && !(it_dst->second -= ticket.mBytes)) {
+      mDstInflight.erase(it_dst);
+    }
+  }
+
+  ticket.mBytes = 0;
+  ticket.mDstFsId = 0;
+}
+
+//------------------------------------------------------------------------------
+// Set the drain bandwidth of a node
+//------------------------------------------------------------------------------
+void
+DrainScheduler::SetNodeRate(const std::string& node, double rate)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mNodes.find(node);
+
+  if (it == mNodes.end()) {
+    return;
+  }
+
+  Node& snode = it->second;
+  auto now = steady_clock::now();
+  Refill(snode, now);
+
+  // A node which becomes rate limited starts with a full bucket
+  if ((snode.mRate <= 0) && (rate > 0)) {
+    snode.mTokens = rate * sBurstSeconds;
+  }
+
+  snode.mRate = rate;
+}
+
+//------------------------------------------------------------------------------
+// Update the NIC bandwidth of the registered nodes from the FsView
+//------------------------------------------------------------------------------
+void
+DrainScheduler::RefreshRates()
+{
+  // All file systems of a node publish the NIC rate of the node, one of the
+  // draining file systems is enough
+  std::map<std::string, fsid_t> nodes;
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    for (const auto& elem : mNodes) {
+      if (!elem.second.mDrains.empty()) {
+        nodes[elem.first] = elem.second.mDrains.begin()->first;
+      }
+    }
+  }
+  std::map<std::string, double> rates;
+  {
+    eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
+
+    for (const auto& elem : nodes) {
+      auto it = FsView::gFsView.mIdView.find(elem.second);
+
+      if ((it != FsView::gFsView.mIdView.end()) && it->second) {
+        rates[elem.first] = it->second->GetDouble("stat.net.ethratemib") *
+                            1024 * 1024 * mNodeShare;
+      }
+    }
+  }
+
+  for (const auto& elem : rates) {
+    SetNodeRate(elem.first, elem.second);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the destination file systems which reached the in-flight limit
+//------------------------------------------------------------------------------
+void
+DrainScheduler::GetSaturatedFs(std::vector<fsid_t>& fsids)
+{
+  uint64_t limit = mFsInflightLimit;
+
+  if (limit == 0) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  for (const auto& elem : mDstInflight) {
+    if (elem.second >= limit) {
+      fsids.push_back(elem.first);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the bytes in flight of a node
+//------------------------------------------------------------------------------
+uint64_t
+DrainScheduler::GetNodeInflight(const std::string& node)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mNodes.find(node);
+  return (it == mNodes.end() ? 0 : it->second.mInflight);
+}
+
+//------------------------------------------------------------------------------
+// Get the bytes in flight of a draining file system
+//------------------------------------------------------------------------------
+uint64_t
+DrainScheduler::GetDrainInflight(const std::string& node, fsid_t fsid)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mNodes.find(node);
+
+  if (it == mNodes.end()) {
+    return 0;
+  }
+
+  auto it_drain = it->second.mDrains.find(fsid);
+  return (it_drain == it->second.mDrains.end() ? 0 : it_drain->second);
+}
+
+//------------------------------------------------------------------------------
+// Get the bytes in flight towards a destination file system
+//------------------------------------------------------------------------------
+uint64_t
+DrainScheduler::GetFsInflight(fsid_t fsid)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mDstInflight.find(fsid);
+  return (it == mDstInflight.end() ? 0 : it->second);
+}
+
+EOSMGMNAMESPACE_END
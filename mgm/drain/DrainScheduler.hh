@@ -0,0 +1,232 @@
+//------------------------------------------------------------------------------
+//! @file DrainScheduler.hh
+//! @brief Bandwidth aware admission of drain transfer jobs
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/FileSystem.hh"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Class admitting drain transfer jobs depending on the bandwidth of
+//! the source node and the load of the destination file systems
+//!
+//! Every source node has a token bucket filled with a configurable fraction
+//! of its NIC bandwidth as published in the FsView. An admitted job takes
+//! the expected size of its file from the bucket, once the real size is
+//! known the difference is taken as well - the bucket may go into debt which
+//! is paid back before the next job of the node is admitted. Nodes without
+//! NIC information are not rate limited.
+//!
+//! The bytes in flight are tracked per source node, per draining file system
+//! and per destination file system. A draining file system is only admitted
+//! while it has no more than its fair share of the bytes in flight of its
+//! node, so concurrent drains of one node are interleaved. Destination file
+//! systems above the in-flight limit are excluded from the placement.
+//------------------------------------------------------------------------------
+class DrainScheduler
+{
+public:
+  using fsid_t = eos::common::FileSystem::fsid_t;
+  using time_point = std::chrono::steady_clock::time_point;
+
+  //----------------------------------------------------------------------------
+  //! Reservation of an admitted job, released when destroyed
+  //----------------------------------------------------------------------------
+  class Ticket
+  {
+    friend class DrainScheduler;
+
+  public:
+    //--------------------------------------------------------------------------
+    //! Destructor
+    //--------------------------------------------------------------------------
+    ~Ticket()
+    {
+      mScheduler.Release(*this);
+    }
+
+    //--------------------------------------------------------------------------
+    //! Account the transfer once its destination and size are known
+    //!
+    //! @param dst_fsid destination file system
+    //! @param size file size
+    //--------------------------------------------------------------------------
+    void Start(fsid_t dst_fsid, uint64_t size)
+    {
+      mScheduler.Start(*this, dst_fsid, size);
+    }
+
+    //--------------------------------------------------------------------------
+    //! Get the scheduler which issued the ticket
+    //--------------------------------------------------------------------------
+    DrainScheduler& GetScheduler() const
+    {
+      return mScheduler;
+    }
+
+  private:
+    Ticket(DrainScheduler& scheduler, const std::string& node, fsid_t fsid,
+           uint64_t bytes):
+      mScheduler(scheduler), mNode(node), mSrcFsId(fsid), mDstFsId(0),
+      mBytes(bytes) {}
+
+    DrainScheduler& mScheduler;
+    std::string mNode; ///< Source node
+    fsid_t mSrcFsId; ///< Draining file system
+    fsid_t mDstFsId; ///< Destination file system, 0 if not yet known
+    uint64_t mBytes; ///< Bytes accounted for the job
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  DrainScheduler();
+
+  //----------------------------------------------------------------------------
+  //! Register a draining file system
+  //!
+  //! @param node source node
+  //! @param fsid draining file system
+  //----------------------------------------------------------------------------
+  void Register(const std::string& node, fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Unregister a draining file system
+  //----------------------------------------------------------------------------
+  void Unregister(const std::string& node, fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Try to admit a new job of a draining file system, the NIC bandwidth of
+  //! the nodes is refreshed from the FsView if due
+  //!
+  //! @param node source node
+  //! @param fsid draining file system
+  //!
+  //! @return ticket of the job or nullptr if the job has to wait
+  //----------------------------------------------------------------------------
+  std::unique_ptr<Ticket> Admit(const std::string& node, fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Try to admit a new job at a given time
+  //----------------------------------------------------------------------------
+  std::unique_ptr<Ticket> Admit(const std::string& node, fsid_t fsid,
+                                time_point now);
+
+  //----------------------------------------------------------------------------
+  //! Set the drain bandwidth of a node
+  //!
+  //! @param node node name
+  //! @param rate bytes per second, 0 disables the rate limit
+  //----------------------------------------------------------------------------
+  void SetNodeRate(const std::string& node, double rate);
+
+  //----------------------------------------------------------------------------
+  //! Get the destination file systems which reached the in-flight limit
+  //!
+  //! @param fsids output list of file systems
+  //----------------------------------------------------------------------------
+  void GetSaturatedFs(std::vector<fsid_t>& fsids);
+
+  //----------------------------------------------------------------------------
+  //! Get the bytes in flight of a node
+  //----------------------------------------------------------------------------
+  uint64_t GetNodeInflight(const std::string& node);
+
+  //----------------------------------------------------------------------------
+  //! Get the bytes in flight of a draining file system
+  //----------------------------------------------------------------------------
+  uint64_t GetDrainInflight(const std::string& node, fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Get the bytes in flight towards a destination file system
+  //----------------------------------------------------------------------------
+  uint64_t GetFsInflight(fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Set the in-flight limit of the destination file systems
+  //!
+  //! @param bytes limit, 0 disables it
+  //----------------------------------------------------------------------------
+  void SetFsInflightLimit(uint64_t bytes)
+  {
+    mFsInflightLimit = bytes;
+  }
+
+private:
+  //! Size accounted for a job as long as no file size was seen on its node
+  static constexpr uint64_t sDefaultEstimate = 64 * 1024 * 1024;
+  //! Seconds of bandwidth a node can accumulate in its bucket
+  static constexpr double sBurstSeconds = 2.0;
+  //! Interval between refreshes of the NIC bandwidth from the FsView
+  static constexpr std::chrono::seconds sRefreshInterval {10};
+
+  //! State of a source node
+  struct Node {
+    Node(): mRate(0), mTokens(0), mInflight(0),
+      mEstimate(sDefaultEstimate) {}
+
+    double mRate; ///< Bytes per second, 0 if not limited
+    double mTokens; ///< Bytes which can be admitted, negative if in debt
+    time_point mLast; ///< Last refill of the bucket
+    uint64_t mInflight; ///< Bytes in flight
+    uint64_t mEstimate; ///< Average size of the files of the node
+    std::map<fsid_t, uint64_t> mDrains; ///< Bytes in flight per draining fs
+  };
+
+  std::mutex mMutex; ///< Mutex protecting the members below
+  std::map<std::string, Node> mNodes; ///< Source nodes
+  std::map<fsid_t, uint64_t> mDstInflight; ///< Bytes in flight per dst fs
+  std::atomic<uint64_t> mFsInflightLimit; ///< In-flight limit of dst fs
+  double mNodeShare; ///< Fraction of the NIC bandwidth used for draining
+  std::atomic<int64_t> mLastRefresh; ///< Last refresh in steady clock seconds
+
+  //----------------------------------------------------------------------------
+  //! Refill the bucket of a node, mMutex has to be locked
+  //----------------------------------------------------------------------------
+  static void Refill(Node& node, time_point now);
+
+  //----------------------------------------------------------------------------
+  //! Update the NIC bandwidth of the registered nodes from the FsView
+  //----------------------------------------------------------------------------
+  void RefreshRates();
+
+  //----------------------------------------------------------------------------
+  //! Account the size and destination of an admitted job
+  //----------------------------------------------------------------------------
+  void Start(Ticket& ticket, fsid_t dst_fsid, uint64_t size);
+
+  //----------------------------------------------------------------------------
+  //! Release the bytes accounted for a job
+  //----------------------------------------------------------------------------
+  void Release(Ticket& ticket);
+};
+
+EOSMGMNAMESPACE_END
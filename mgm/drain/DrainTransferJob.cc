@@ -47,10 +47,20 @@ void DrainTransferJob::ReportError(const std::string& error)
 }
 
 //------------------------------------------------------------------------------
-// Execute a thrid-party transfer
+// Execute a third-party transfer and release the scheduler ticket
 //------------------------------------------------------------------------------
 void
 DrainTransferJob::DoIt()
+{
+  DoTransfer();
+  mTicket.reset();
+}
+
+//------------------------------------------------------------------------------
+// Execute a thrid-party transfer
+//------------------------------------------------------------------------------
+void
+DrainTransferJob::DoTransfer()
 {
   using eos::common::LayoutId;
   gOFS->MgmStats.Add("DrainCentralStarted", 0, 0, 1);
@@ -73,6 +83,10 @@ DrainTransferJob::DoIt()
     return;
   }
 
+  if (mTicket) {
+    mTicket->Start(mFsIdTarget, fdrain.mProto.size());
+  }
+
   // Special case when deadling with 0-size replica files
   if ((fdrain.mProto.size() == 0) &&
       (LayoutId::GetLayoutType(fdrain.mProto.layout_id()) ==
@@ -484,6 +498,13 @@ DrainTransferJob::SelectDstFs(const FileDrainInfo& fdrain)
   unsigned int nfilesystems = 1;
   unsigned int ncollocatedfs = 0;
   std::vector<FileSystem::fsid_t> new_repl;
+  // Avoid destinations which already receive too many drain transfers
+  std::vector<FileSystem::fsid_t> exclude_fs;
+
+  if (mTicket) {
+    mTicket->GetScheduler().GetSaturatedFs(exclude_fs);
+  }
+
   eos::common::FileSystem::fs_snapshot source_snapshot;
   eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
   eos::common::FileSystem* source_fs = FsView::gFsView.mIdView[mFsIdSource];
@@ -521,7 +542,7 @@ DrainTransferJob::SelectDstFs(const FileDrainInfo& fdrain)
                "",// start from geotag
                "",// client geo tag
                ncollocatedfs,
-               NULL, // excludeFS
+               exclude_fs.empty() ? NULL : &exclude_fs, // excludeFS
                &fsid_geotags, // excludeGeoTags
                NULL);
 
@@ -22,6 +22,7 @@
 
 #pragma once
 #include "mgm/Namespace.hh"
+#include "mgm/drain/DrainScheduler.hh"
 #include "common/FileId.hh"
 #include "common/Logging.hh"
 #include "common/FileSystem.hh"
@@ -58,10 +59,18 @@ public:
   ~DrainTransferJob() = default;
 
   //----------------------------------------------------------------------------
-  //! Execute a third-party transfer
+  //! Execute a third-party transfer and release the scheduler ticket
   //----------------------------------------------------------------------------
   void DoIt();
 
+  //----------------------------------------------------------------------------
+  //! Set the ticket with which the drain scheduler admitted the job
+  //----------------------------------------------------------------------------
+  inline void SetTicket(std::unique_ptr<DrainScheduler::Ticket>&& ticket)
+  {
+    mTicket = std::move(ticket);
+  }
+
   //----------------------------------------------------------------------------
   //! Log error message and save it
   //!
@@ -102,6 +111,11 @@ public:
     return mFsIdTarget;
   }
 
+  inline void SetErrorString(const std::string& error)
+  {
+    mErrorString = error;
+  }
+
   inline const std::string& GetErrorString() const
   {
     return mErrorString;
@@ -148,6 +162,11 @@ private:
   XrdCl::URL BuildTpcDst(const FileDrainInfo& fdrain,
                          const std::string& log_id);
 
+  //----------------------------------------------------------------------------
+  //! Execute a third-party transfer
+  //----------------------------------------------------------------------------
+  void DoTransfer();
+
   //----------------------------------------------------------------------------
   //! Select destiantion file system for current transfer
   //!
@@ -173,6 +192,8 @@ private:
   std::atomic<Status> mStatus; ///< Status of the drain job
   std::set<eos::common::FileSystem::fsid_t> mTriedSrcs; ///< Tried src
   bool mRainReconstruct; ///< Flag to mark a rain reconstruction
+  //! Reservation of the drain scheduler, released when the job is done
+  std::unique_ptr<DrainScheduler::Ticket> mTicket;
 };
 
 EOSMGMNAMESPACE_END
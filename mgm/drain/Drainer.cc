@@ -145,8 +145,8 @@ Drainer::StartFsDrain(eos::mgm::FileSystem* fs,
   }
 
   // Start the drain
-  std::shared_ptr<DrainFs> dfs(new DrainFs(mThreadPool, gOFS->eosFsView,
-                               src_fsid, dst_fsid));
+  std::shared_ptr<DrainFs> dfs(new DrainFs(mThreadPool, mScheduler,
+                               gOFS->eosFsView, src_fsid, dst_fsid));
   auto future = std::async(std::launch::async, &DrainFs::DoIt, dfs);
   dfs->SetFuture(std::move(future));
   mDrainFs[src_snapshot.mHostPort].emplace(dfs);
@@ -429,8 +429,9 @@ Drainer::StopDrainFs()
   XrdSysMutexHelper scope_lock(mDrainMutex);
 
   for (auto& node_elem : mDrainFs) {
+    // Keep the progress, the drains resume once the MGM is master again
     for (const auto& fs_elem : node_elem.second) {
-      fs_elem->SignalStop();
+      fs_elem->SignalStop(true);
     }
 
     for (const auto& fs_elem : node_elem.second) {
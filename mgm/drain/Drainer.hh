@@ -27,6 +27,7 @@
 #include "common/ThreadPool.hh"
 #include "common/AssistedThread.hh"
 #include "mgm/drain/DrainFs.hh"
+#include "mgm/drain/DrainScheduler.hh"
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -115,6 +116,14 @@ public:
     return mThreadPool.GetInfo();
   }
 
+  //----------------------------------------------------------------------------
+  //! Get the scheduler admitting the drain jobs
+  //----------------------------------------------------------------------------
+  DrainScheduler& GetScheduler()
+  {
+    return mScheduler;
+  }
+
   // @todo (esindril): to review
 
   //----------------------------------------------------------------------------
@@ -167,6 +176,8 @@ private:
   AssistedThread mThread; ///< Thread updating the drain configuration
   //! Contains per space the max allowed fs draining per node
   std::map<std::string, int> mCfgMap;
+  //! Scheduler admitting the drain jobs, outlives the drains and the jobs
+  DrainScheduler mScheduler;
   DrainMap mDrainFs; ///< Map of nodes to file systems draining
   XrdSysMutex mDrainMutex; ///< Mutex protecting the drain map
   XrdSysMutex mCfgMutex; ///< Mutex for drain config updates
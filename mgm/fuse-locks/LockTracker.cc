@@ -25,7 +25,7 @@
 #include "LockTracker.hh"
 #include <fcntl.h>
 #include <unistd.h>
-#include <thread>
+#include <algorithm>
 
 EOSMGMNAMESPACE_BEGIN
 USE_EOSMGMNAMESPACE
@@ -45,137 +45,190 @@ std::ostream& operator<< (std::ostream& os, const Lock& lock)
 }
 
 /*----------------------------------------------------------------------------*/
-void
+template<typename F>
+bool
 /*----------------------------------------------------------------------------*/
-LockSet::add(const Lock& l)
+LockSet::scan(const ByteRange& r, F f) const
 /*----------------------------------------------------------------------------*/
 {
-  Lock newlock(l);
-  // Absorb any overlapping ranges, removing the old ones
-  auto it = locks.begin();
+  // the locks starting at or before the end of the range
+  auto it = std::upper_bound(locks.begin(), locks.end(), r.end(),
+  [](Offset end, const Lock & lock) {
+    return end < lock.range().start();
+  });
+
+  for (size_t i = it - locks.begin(); i-- > 0;) {
+    // no lock before this one reaches the range
+    if (maxend[i] < r.start()) {
+      break;
+    }
 
-  while (it != locks.end()) {
-    if (newlock.absorb(*it)) {
-      it = locks.erase(it);
-    } else {
-      it++;
+    if (f(i)) {
+      return true;
     }
   }
 
-  // Append the consolidated superlock
-  locks.push_back(newlock);
+  return false;
 }
 
 /*----------------------------------------------------------------------------*/
-bool
+void
 /*----------------------------------------------------------------------------*/
-LockSet::conflict(const Lock& l) const
+LockSet::insert(const Lock& l)
 /*----------------------------------------------------------------------------*/
 {
-  auto it = locks.begin();
+  auto it = std::upper_bound(locks.begin(), locks.end(), l.range().start(),
+  [](Offset start, const Lock & lock) {
+    return start < lock.range().start();
+  });
+  size_t pos = it - locks.begin();
+  locks.insert(it, l);
+  maxend.insert(maxend.begin() + pos, 0);
+  reindex(pos);
+}
 
-  while (it != locks.end()) {
-    if (it->pid() != l.pid() && l.range().overlap(it->range())) {
-      return true;
-    }
+/*----------------------------------------------------------------------------*/
+void
+/*----------------------------------------------------------------------------*/
+LockSet::reindex(size_t from)
+/*----------------------------------------------------------------------------*/
+{
+  maxend.resize(locks.size());
 
-    it++;
-  }
+  for (size_t i = from; i < locks.size(); ++i) {
+    maxend[i] = locks[i].range().end();
 
-  return false;
+    if (i && maxend[i - 1] > maxend[i]) {
+      maxend[i] = maxend[i - 1];
+    }
+  }
 }
 
 /*----------------------------------------------------------------------------*/
-bool
+void
 /*----------------------------------------------------------------------------*/
-LockSet::getconflict(Lock& l)
+LockSet::add(const Lock& l)
 /*----------------------------------------------------------------------------*/
 {
-  auto it = locks.begin();
-
-  while (it != locks.end()) {
-    if (it->pid() != l.pid() && l.range().overlap(it->range())) {
-      l = *it;
-      return true;
+  Lock newlock(l);
+  std::vector<size_t> absorbed;
+  // Absorb any overlapping ranges, removing the old ones. Locks of the same
+  // pid never overlap or touch, so the ones touching the new lock are all
+  // there is to absorb.
+  scan(l.range(), [&](size_t i) {
+    if (newlock.absorb(locks[i])) {
+      absorbed.push_back(i);
     }
 
-    it++;
+    return false;
+  });
+
+  // the indices are descending
+  for (auto i : absorbed) {
+    locks.erase(locks.begin() + i);
   }
 
-  return false;
+  if (absorbed.size()) {
+    reindex(absorbed.back());
+  }
+
+  // Insert the consolidated superlock
+  insert(newlock);
 }
 
 /*----------------------------------------------------------------------------*/
 bool
 /*----------------------------------------------------------------------------*/
-LockSet::overlap(const Lock& l) const
+LockSet::conflict(const Lock& l) const
 /*----------------------------------------------------------------------------*/
 {
-  auto it = locks.begin();
+  return scan(l.range(), [&](size_t i) {
+    return (locks[i].pid() != l.pid()) && l.range().overlap(locks[i].range());
+  });
+}
 
-  while (it != locks.end()) {
-    if (l.overlap(*it)) {
+/*----------------------------------------------------------------------------*/
+bool
+/*----------------------------------------------------------------------------*/
+LockSet::getconflict(Lock& l)
+/*----------------------------------------------------------------------------*/
+{
+  size_t found = locks.size();
+  scan(l.range(), [&](size_t i) {
+    if ((locks[i].pid() != l.pid()) && l.range().overlap(locks[i].range())) {
+      found = i;
       return true;
     }
 
-    it++;
+    return false;
+  });
+
+  if (found == locks.size()) {
+    return false;
   }
 
-  return false;
+  l = locks[found];
+  return true;
 }
 
 /*----------------------------------------------------------------------------*/
 bool
 /*----------------------------------------------------------------------------*/
-LockSet::overlap(const ByteRange& br) const
+LockSet::overlap(const Lock& l) const
 /*----------------------------------------------------------------------------*/
 {
-  auto it = locks.begin();
-
-  while (it != locks.end()) {
-    if (br.overlap(it->range())) {
-      return true;
-    }
-
-    it++;
-  }
+  return scan(l.range(), [&](size_t i) {
+    return l.overlap(locks[i]);
+  });
+}
 
-  return false;
+/*----------------------------------------------------------------------------*/
+bool
+/*----------------------------------------------------------------------------*/
+LockSet::overlap(const ByteRange& br) const
+/*----------------------------------------------------------------------------*/
+{
+  return scan(br, [&](size_t i) {
+    return br.overlap(locks[i].range());
+  });
 }
 
 /*----------------------------------------------------------------------------*/
-void
+bool
 /*----------------------------------------------------------------------------*/
 LockSet::remove(const Lock& l)
 /*----------------------------------------------------------------------------*/
 {
-  std::vector<Lock> queued;
-  auto it = locks.begin();
-
-  while (it != locks.end()) {
-    std::vector<Lock> newlocks = it->minus(l);
-
-    if (newlocks.size() == 0) {
-      it = locks.erase(it);
-      continue;
+  std::vector<size_t> shrunk;
+  scan(l.range(), [&](size_t i) {
+    if (l.overlap(locks[i])) {
+      shrunk.push_back(i);
     }
 
-    if (newlocks.size() >= 1) {
-      *it = newlocks[0];
-    }
+    return false;
+  });
 
-    if (newlocks.size() == 2) {
-      queued.push_back(newlocks[1]);
-    }
+  if (shrunk.empty()) {
+    return false;
+  }
 
-    it++;
+  // Cannot add the remainders while iterating, as it would shift the
+  // indices. Store them and add them later.
+  std::vector<Lock> queued;
+
+  for (auto i : shrunk) {
+    std::vector<Lock> newlocks = locks[i].minus(l);
+    queued.insert(queued.end(), newlocks.begin(), newlocks.end());
+    locks.erase(locks.begin() + i);
   }
 
-  // Cannot add new items to vector while iterating, as it invalides the iterators.
-  // Store the items in a queue and add them later.
+  reindex(shrunk.back());
+
   for (size_t i = 0; i < queued.size(); i++) {
-    locks.push_back(queued[i]);
+    insert(queued[i]);
   }
+
+  return true;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -210,33 +263,39 @@ LockSet::nlocks(pid_t pid)
 /*----------------------------------------------------------------------------*/
 void
 /*----------------------------------------------------------------------------*/
-LockSet::remove(pid_t pid)
+LockSet::remove(pid_t pid, std::vector<ByteRange>* removed)
 {
   std::vector<Lock> survivinglocks;
 
   for (auto it = locks.begin(); it != locks.end(); ++it) {
     if (it->pid() != pid) {
       survivinglocks.push_back(*it);
+    } else if (removed) {
+      removed->push_back(it->range());
     }
   }
 
   locks = survivinglocks;
+  reindex();
 }
 
 /*----------------------------------------------------------------------------*/
 void
 /*----------------------------------------------------------------------------*/
-LockSet::remove(const std::string& owner)
+LockSet::remove(const std::string& owner, std::vector<ByteRange>* removed)
 {
   std::vector<Lock> survivinglocks;
 
   for (auto it = locks.begin(); it != locks.end(); ++it) {
     if (it->owner() != owner) {
       survivinglocks.push_back(*it);
+    } else if (removed) {
+      removed->push_back(it->range());
     }
   }
 
   locks = survivinglocks;
+  reindex();
 }
 
 /*----------------------------------------------------------------------------*/
@@ -287,26 +346,23 @@ LockTracker::getlk(pid_t pid, struct flock* lock)
 int
 /*----------------------------------------------------------------------------*/
 LockTracker::setlk(pid_t pid, struct flock* lock, int sleep,
-                   const std::string& owner)
+                   const std::string& owner, std::set<std::string>* wakeup)
 /*----------------------------------------------------------------------------*/
 {
-  if (!sleep) {
-    return addLock(pid, lock, owner);
-  }
-
-  size_t cnt = 0;
-
-  while (!addLock(pid, lock, owner)) {
-    cnt++;
-    // TODO wait on condition variable?
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  std::lock_guard<std::mutex> guard(mtx);
+  std::vector<ByteRange> released;
 
-    if (cnt > 10) {
-      // we give up after 10ms
-      return 0;
+  if (!addLock(pid, lock, owner, released)) {
+    // the client retries once it is woken up or its back-off expired
+    if (sleep) {
+      addWaiter(pid, ByteRange(lock->l_start, lock->l_len), owner);
     }
+
+    return 0;
   }
 
+  removeWaiter(pid, owner);
+  wakeWaiters(released, wakeup);
   return 1;
 }
 
@@ -324,37 +380,46 @@ LockTracker::canLock(pid_t pid, struct flock* f_lock)
   }
 
   // Are there any exclusive locks right now?
-  if (wlocks.getconflict(lock)) {
-    return false;
-  }
+  bool conflict = wlocks.getconflict(lock);
 
-  // If this is a read lock, we can lock
-  if (f_lock->l_type == F_RDLCK) {
-    return true;
+  if (conflict) {
+    f_lock->l_type = F_WRLCK;
+  } else if (f_lock->l_type == F_WRLCK) {
+    // If this is a write lock, we can lock only if there are no read locks
+    conflict = rlocks.getconflict(lock);
+
+    if (conflict) {
+      f_lock->l_type = F_RDLCK;
+    }
   }
 
-  // If this is a write lock, we can lock only if there are no read locks
-  if (f_lock->l_type == F_WRLCK) {
-    return rlocks.getconflict(lock);
+  if (conflict) {
+    // Fill the blocking lock
+    f_lock->l_start = lock.range().start();
+    f_lock->l_len = lock.range().len();
+    f_lock->l_pid = lock.pid();
+    return false;
   }
 
-  // TODO raise warning, should never reach this point
-  return false;
+  return (f_lock->l_type == F_RDLCK) || (f_lock->l_type == F_WRLCK);
 }
 
 /*----------------------------------------------------------------------------*/
 bool
 /*----------------------------------------------------------------------------*/
-LockTracker::addLock(pid_t pid, struct flock* f_lock, const std::string& owner)
+LockTracker::addLock(pid_t pid, struct flock* f_lock, const std::string& owner,
+                     std::vector<ByteRange>& released)
 /*----------------------------------------------------------------------------*/
 {
-  std::lock_guard<std::mutex> guard(mtx);
   Lock lock(ByteRange(f_lock->l_start, f_lock->l_len), pid, owner);
 
   // Unlock?
   if (f_lock->l_type == F_UNLCK) {
-    rlocks.remove(lock);
-    wlocks.remove(lock);
+    // not a short-circuit, both sets are unlocked
+    if (rlocks.remove(lock) | wlocks.remove(lock)) {
+      released.push_back(lock.range());
+    }
+
     return true;
   }
 
@@ -387,9 +452,13 @@ LockTracker::addLock(pid_t pid, struct flock* f_lock, const std::string& owner)
 
     // Add read lock
     rlocks.add(lock);
+
     // It could be that the process is converting a write lock into a read.
-    // Remove any write locks on the same region.
-    wlocks.remove(lock);
+    // Remove any write locks on the same region, other readers may go on.
+    if (wlocks.remove(lock)) {
+      released.push_back(lock.range());
+    }
+
     return true;
   }
 
@@ -398,28 +467,126 @@ LockTracker::addLock(pid_t pid, struct flock* f_lock, const std::string& owner)
   return false;
 }
 
+/*----------------------------------------------------------------------------*/
+void
+/*----------------------------------------------------------------------------*/
+LockTracker::addWaiter(pid_t pid, const ByteRange& range,
+                       const std::string& owner)
+/*----------------------------------------------------------------------------*/
+{
+  time_t now = time(NULL);
+  auto it = waiters.begin();
+
+  while (it != waiters.end()) {
+    // waiters which gave up are not woken up forever
+    if ((it->since + kWaiterTimeout < now) ||
+        ((it->pid == pid) && (it->owner == owner))) {
+      it = waiters.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  waiters.emplace_back(owner, pid, range, now);
+}
+
+/*----------------------------------------------------------------------------*/
+void
+/*----------------------------------------------------------------------------*/
+LockTracker::removeWaiter(pid_t pid, const std::string& owner)
+/*----------------------------------------------------------------------------*/
+{
+  auto it = waiters.begin();
+
+  while (it != waiters.end()) {
+    if ((it->pid == pid) && (it->owner == owner)) {
+      it = waiters.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+void
+/*----------------------------------------------------------------------------*/
+LockTracker::wakeWaiters(const std::vector<ByteRange>& released,
+                         std::set<std::string>* wakeup)
+/*----------------------------------------------------------------------------*/
+{
+  if (!wakeup || released.empty()) {
+    return;
+  }
+
+  auto it = waiters.begin();
+
+  while (it != waiters.end()) {
+    bool wake = false;
+
+    for (const auto& range : released) {
+      if (range.overlap(it->range)) {
+        wake = true;
+        break;
+      }
+    }
+
+    // a woken up waiter registers again if its retry fails
+    if (wake) {
+      wakeup->insert(it->owner);
+      it = waiters.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 int
 /*----------------------------------------------------------------------------*/
-LockTracker::removelk(pid_t pid)
+LockTracker::removelk(pid_t pid, std::set<std::string>* wakeup)
 {
   std::lock_guard<std::mutex> guard(mtx);
-  rlocks.remove(pid);
-  wlocks.remove(pid);
+  std::vector<ByteRange> released;
+  rlocks.remove(pid, &released);
+  wlocks.remove(pid, &released);
+  wakeWaiters(released, wakeup);
   return 1;
 }
 
 /*----------------------------------------------------------------------------*/
 int
 /*----------------------------------------------------------------------------*/
-LockTracker::removelk(const std::string& owner)
+LockTracker::removelk(const std::string& owner, std::set<std::string>* wakeup)
 {
   std::lock_guard<std::mutex> guard(mtx);
-  rlocks.remove(owner);
-  wlocks.remove(owner);
+  std::vector<ByteRange> released;
+  rlocks.remove(owner, &released);
+  wlocks.remove(owner, &released);
+  auto it = waiters.begin();
+
+  // the owner is gone, so are its waiters
+  while (it != waiters.end()) {
+    if (it->owner == owner) {
+      it = waiters.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  wakeWaiters(released, wakeup);
   return 1;
 }
 
+/*----------------------------------------------------------------------------*/
+size_t
+/*----------------------------------------------------------------------------*/
+LockTracker::nwaiters()
+/*----------------------------------------------------------------------------*/
+{
+  std::lock_guard<std::mutex> guard(mtx);
+  return waiters.size();
+}
+
 /*----------------------------------------------------------------------------*/
 bool
 /*----------------------------------------------------------------------------*/
@@ -33,6 +33,7 @@
 #include <limits>
 #include <iostream>
 #include <mutex>
+#include <ctime>
 #include <fcntl.h>
 #include "mgm/Namespace.hh"
 
@@ -282,7 +283,7 @@ public:
     std::vector<Lock> locks;
 
     for (size_t i = 0; i < ranges.size(); i++) {
-      locks.emplace_back(ranges[i], pid());
+      locks.emplace_back(ranges[i], pid(), owner_);
     }
 
     return locks;
@@ -299,6 +300,14 @@ private:
   std::string owner_;
 } ;
 
+//------------------------------------------------------------------------------
+//! Locks of one kind on an inode
+//!
+//! The locks are kept sorted by their start together with the running maximum
+//! of their ends, an implicit interval tree: the locks overlapping a range are
+//! found by a binary search for the last lock starting before its end and a
+//! backward scan which stops as soon as no earlier lock reaches its start.
+//------------------------------------------------------------------------------
 class LockSet
 {
 public:
@@ -307,10 +316,14 @@ public:
   const; // check if overlaps with locks from the *same* process
   bool overlap(const ByteRange& r)
   const; // check if overlaps with locks from *any* process
-  void remove(const Lock&
-              l); // remove any contained locks, shrink any overlapping
-  void remove(const pid_t pid); // remove all locks for a given pid
-  void remove(const std::string& owner); // remove all locks for a given owner
+  // remove any contained locks, shrink any overlapping, returns true if
+  // anything was unlocked
+  bool remove(const Lock& l);
+  // remove all locks for a given pid, the removed ranges are appended
+  void remove(const pid_t pid, std::vector<ByteRange>* removed = nullptr);
+  // remove all locks for a given owner, the removed ranges are appended
+  void remove(const std::string& owner,
+              std::vector<ByteRange>* removed = nullptr);
 
   // check if there's a conflict between this lock and any other in the set.
   // If two locks overlap, but have the same PID, this is not a conflict!
@@ -326,29 +339,76 @@ public:
                           owner); // return all pids belonging to owner
 
 private:
-  std::vector<Lock> locks;
+  // call f(i) for the locks which may overlap or touch the range, from the
+  // last one backwards, until f returns true
+  template<typename F>
+  bool scan(const ByteRange& r, F f) const;
+  // insert a lock at its position
+  void insert(const Lock& l);
+  // recompute the running max of the ends from a position on
+  void reindex(size_t from = 0);
+
+  std::vector<Lock> locks; // sorted by start
+  std::vector<Offset> maxend; // max end of locks[0..i]
 } ;
 
 class LockTracker
 {
 public:
+  //! How long a waiter which was never woken up is kept
+  static constexpr time_t kWaiterTimeout = 60;
+
   int getlk(pid_t pid, struct flock* lock);
-  int setlk(pid_t pid, struct flock* lock, int sleep, const std::string& owner);
+
+  //----------------------------------------------------------------------------
+  //! Set or release a lock
+  //!
+  //! A blocking lock which can't be taken registers the owner as a waiter on
+  //! the range. Unlocking or downgrading a range hands the waiters whose
+  //! range overlaps it to the caller, which notifies them to retry, instead
+  //! of having them poll.
+  //!
+  //! @param wakeup if given, filled with the owners to notify
+  //----------------------------------------------------------------------------
+  int setlk(pid_t pid, struct flock* lock, int sleep, const std::string& owner,
+            std::set<std::string>* wakeup = nullptr);
 
   std::set<pid_t> getrlks(const std::string& owner);
   std::set<pid_t> getwlks(const std::string& owner);
 
-  int removelk(pid_t pid);
-  int removelk(const std::string& owner);
+  int removelk(pid_t pid, std::set<std::string>* wakeup = nullptr);
+  int removelk(const std::string& owner,
+               std::set<std::string>* wakeup = nullptr);
   bool inuse();
 
+  size_t nwaiters();
+
 private:
+  //----------------------------------------------------------------------------
+  //! Owner waiting for a range to become free
+  //----------------------------------------------------------------------------
+  struct Waiter {
+    Waiter(const std::string& owner, pid_t pid, const ByteRange& range,
+           time_t since) : owner(owner), pid(pid), range(range), since(since) { }
+
+    std::string owner;
+    pid_t pid;
+    ByteRange range;
+    time_t since;
+  };
+
   std::mutex mtx;
-  bool addLock(pid_t pid, struct flock* lock, const std::string& owner);
+  bool addLock(pid_t pid, struct flock* lock, const std::string& owner,
+               std::vector<ByteRange>& released);
   bool canLock(pid_t pid, struct flock* lock);
+  void addWaiter(pid_t pid, const ByteRange& range, const std::string& owner);
+  void removeWaiter(pid_t pid, const std::string& owner);
+  void wakeWaiters(const std::vector<ByteRange>& released,
+                   std::set<std::string>* wakeup);
 
   LockSet rlocks;
   LockSet wlocks;
+  std::vector<Waiter> waiters;
 } ;
 
 EOSMGMNAMESPACE_END
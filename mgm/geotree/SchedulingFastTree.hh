@@ -35,6 +35,9 @@
 #include <iomanip>
 #include <algorithm>
 #include <limits>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
 #define __EOSMGM_FASTTREE__H__
 
 #define DEFINE_TREECOMMON_MACRO
@@ -1111,6 +1114,7 @@ public:
   friend struct TreeEntryMap;
   friend struct FastStructures;
   friend struct FsComparator;
+  friend class FastLeafArray;
 
   typedef FastTreeBranch Branch;
 
@@ -1771,6 +1775,41 @@ public:
     checkConsistency(node, true);
   }
 
+  // Update a node whose state changed and then only its ancestors up to the
+  // root. Calling it for each node changed since the last update gives the
+  // same result as updateTree().
+  inline void
+  updateTreeFromNode(tFastTreeIdx node)
+  {
+    while (true) {
+      const tFastTreeIdx& nbChildren = pNodes[node].treeData.childrenCount;
+
+      if (nbChildren < 2) {
+        pNodes[node].fileData.lastHighestPriorityOffset = 0;
+      }
+
+      if (nbChildren) {
+        sortBranchesAtNode(node, false);
+        aggregateFsData(node);
+        aggregateFileData(node);
+      }
+
+      pNodes[node].fileData.maxUlScore = pNodes[node].fsData.ulScore;
+      pNodes[node].fileData.maxDlScore = pNodes[node].fsData.dlScore;
+      pNodes[node].fileData.avgUlScore = pNodes[node].fsData.ulScore;
+      pNodes[node].fileData.avgDlScore = pNodes[node].fsData.dlScore;
+
+      if (pNodes[node].treeData.fatherIdx == node) {
+        break;
+      }
+
+      node = pNodes[node].treeData.fatherIdx;
+    }
+
+    __EOSMGM_TREECOMMON_CHK3__
+    checkConsistency(0, true);
+  }
+
   inline tFastTreeIdx
   getMaxNodeCount() const
   {
@@ -2589,6 +2628,239 @@ struct FastTreeBranchComparatorInv {
 #pragma pack(pop)
 #endif
 
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Structure-of-arrays copy of the leaves (i.e. the file systems) of a
+ *        FastTree.
+ *
+ * In a FastTree every node holds its state and its slots next to each other
+ * (array-of-structs) and the selection is done branch by branch. For groups
+ * with several hundreds of file systems, it is much cheaper to evaluate the
+ * candidates over contiguous arrays, one per attribute.
+ * The filters and the argmax use SSE4.1 when available (the build uses
+ * -msse4.2) and fall back to plain loops otherwise. The leaves are taken in
+ * node order so that the result does not depend on the order of the branches.
+ *
+ */
+/*----------------------------------------------------------------------------*/
+class FastLeafArray
+{
+public:
+  typedef SchedTreeBase::tFastTreeIdx tFastTreeIdx;
+
+  /**
+   * @brief Copy the leaves of a FastTree into the arrays
+   * @param tree the tree to copy the leaves from
+   */
+  template<typename T1, typename T2, typename T3>
+  void build(const FastTree<T1, T2, T3>& tree)
+  {
+    size_t nleaves = 0;
+
+    for (tFastTreeIdx i = 0; i < tree.pNodeCount; i++) {
+      nleaves += (tree.pNodes[i].treeData.childrenCount == 0);
+    }
+
+    resize(nleaves);
+    size_t pos = 0;
+
+    for (tFastTreeIdx i = 0; i < tree.pNodeCount; i++) {
+      const typename FastTree<T1, T2, T3>::FastTreeNode& node = tree.pNodes[i];
+
+      if (node.treeData.childrenCount) {
+        continue;
+      }
+
+      pNodeIdx[pos] = i;
+      pStatus[pos] = node.fsData.mStatus;
+      pDlScore[pos] = node.fsData.dlScore;
+      pUlScore[pos] = node.fsData.ulScore;
+      pFillRatio[pos] = node.fsData.fillRatio;
+      pFreeSlots[pos] = node.fileData.freeSlotsCount;
+      pos++;
+    }
+  }
+
+  /**
+   * @brief Flag the leaves which are valid for a placement i.e. available,
+   *        writable, not disabled, with a free slot, not saturated and with a
+   *        fill ratio not above the limit
+   * @param saturationThresh leaves with a lower download score are saturated
+   * @param maxFillRatio max fill ratio of a selected leaf
+   * @param statusMask status bits that must all be set
+   * @return the number of leaves selected
+   */
+  size_t filterPlacement(char saturationThresh, char maxFillRatio = 100,
+                         int16_t statusMask = SchedTreeBase::Available |
+                             SchedTreeBase::Writable)
+  {
+    const size_t n = pNodeIdx.size();
+    size_t i = 0;
+    size_t count = 0;
+#ifdef __SSE4_1__
+    // 16 leaves per iteration, the status being 16 bits wide takes 2 loads
+    const __m128i vStatusMask = _mm_set1_epi16(statusMask);
+    const __m128i vDisabled = _mm_set1_epi16(SchedTreeBase::Disabled);
+    const __m128i vZero = _mm_setzero_si128();
+    const __m128i vOne = _mm_set1_epi8(1);
+    const __m128i vSatThresh = _mm_set1_epi8(saturationThresh);
+    const __m128i vMaxFill = _mm_set1_epi8(maxFillRatio);
+
+    for (; i + 16 <= n; i += 16) {
+      __m128i st0 = _mm_loadu_si128((const __m128i*) &pStatus[i]);
+      __m128i st1 = _mm_loadu_si128((const __m128i*) &pStatus[i + 8]);
+      __m128i ok0 = _mm_andnot_si128(
+                      _mm_cmpeq_epi16(_mm_and_si128(st0, vDisabled), vDisabled),
+                      _mm_cmpeq_epi16(_mm_and_si128(st0, vStatusMask), vStatusMask));
+      __m128i ok1 = _mm_andnot_si128(
+                      _mm_cmpeq_epi16(_mm_and_si128(st1, vDisabled), vDisabled),
+                      _mm_cmpeq_epi16(_mm_and_si128(st1, vStatusMask), vStatusMask));
+      __m128i ok = _mm_packs_epi16(ok0, ok1);
+      __m128i dl = _mm_loadu_si128((const __m128i*) &pDlScore[i]);
+      __m128i fill = _mm_loadu_si128((const __m128i*) &pFillRatio[i]);
+      __m128i slots = _mm_loadu_si128((const __m128i*) &pFreeSlots[i]);
+      // the scores are signed, the free slots count is not
+      ok = _mm_andnot_si128(_mm_cmpgt_epi8(vSatThresh, dl), ok);
+      ok = _mm_andnot_si128(_mm_cmpgt_epi8(fill, vMaxFill), ok);
+      ok = _mm_andnot_si128(_mm_cmpeq_epi8(slots, vZero), ok);
+      _mm_storeu_si128((__m128i*) &pMask[i], _mm_and_si128(ok, vOne));
+      count += __builtin_popcount(_mm_movemask_epi8(ok));
+    }
+
+#endif
+
+    for (; i < n; i++) {
+      pMask[i] = (((pStatus[i] & statusMask) == statusMask) &&
+                  !(pStatus[i] & SchedTreeBase::Disabled) &&
+                  (pFreeSlots[i] > 0) && (pDlScore[i] >= saturationThresh) &&
+                  (pFillRatio[i] <= maxFillRatio));
+      count += pMask[i];
+    }
+
+    return count;
+  }
+
+  /**
+   * @brief Find the selected leaf with the highest weighted score
+   *        dlWeight*dlScore + ulWeight*ulScore - fillWeight*fillRatio
+   *        the first one wins in case of a tie
+   * @param dlWeight weight of the download score
+   * @param ulWeight weight of the upload score
+   * @param fillWeight weight of the fill ratio
+   * @return the position of the best leaf in the arrays or -1 if no leaf is
+   *         selected
+   */
+  long argmaxScore(int dlWeight = 1, int ulWeight = 0, int fillWeight = 0)
+  {
+    const size_t n = pNodeIdx.size();
+    // the masked out leaves get a score lower than any reachable score
+    const int32_t lowest = std::numeric_limits<int32_t>::min();
+    int32_t best = lowest;
+    size_t i = 0;
+#ifdef __SSE4_1__
+    // 4 leaves per iteration, the scores are computed on 32 bits
+    const __m128i vDlWeight = _mm_set1_epi32(dlWeight);
+    const __m128i vUlWeight = _mm_set1_epi32(ulWeight);
+    const __m128i vFillWeight = _mm_set1_epi32(fillWeight);
+    const __m128i vLowest = _mm_set1_epi32(lowest);
+    __m128i vBest = vLowest;
+
+    for (; i + 4 <= n; i += 4) {
+      __m128i dl = _mm_cvtepi8_epi32(load4(&pDlScore[i]));
+      __m128i ul = _mm_cvtepi8_epi32(load4(&pUlScore[i]));
+      __m128i fill = _mm_cvtepi8_epi32(load4(&pFillRatio[i]));
+      __m128i sel = _mm_sub_epi32(_mm_setzero_si128(),
+                                  _mm_cvtepu8_epi32(load4(&pMask[i])));
+      __m128i score = _mm_sub_epi32(
+                        _mm_add_epi32(_mm_mullo_epi32(dl, vDlWeight),
+                                      _mm_mullo_epi32(ul, vUlWeight)),
+                        _mm_mullo_epi32(fill, vFillWeight));
+      score = _mm_blendv_epi8(vLowest, score, sel);
+      _mm_storeu_si128((__m128i*) &pScores[i], score);
+      vBest = _mm_max_epi32(vBest, score);
+    }
+
+    vBest = _mm_max_epi32(vBest, _mm_shuffle_epi32(vBest, _MM_SHUFFLE(1, 0, 3,
+                          2)));
+    vBest = _mm_max_epi32(vBest, _mm_shuffle_epi32(vBest, _MM_SHUFFLE(2, 3, 0,
+                          1)));
+    best = _mm_cvtsi128_si32(vBest);
+#endif
+
+    for (; i < n; i++) {
+      pScores[i] = (pMask[i] ? (dlWeight * pDlScore[i] + ulWeight * pUlScore[i] -
+                                fillWeight * pFillRatio[i]) : lowest);
+      best = std::max(best, pScores[i]);
+    }
+
+    for (i = 0; i < n; i++) {
+      if (pMask[i] && (pScores[i] == best)) {
+        return (long) i;
+      }
+    }
+
+    return -1;
+  }
+
+  inline size_t size() const
+  {
+    return pNodeIdx.size();
+  }
+
+  inline tFastTreeIdx getNodeIdx(size_t pos) const
+  {
+    return pNodeIdx[pos];
+  }
+
+  inline bool isSelected(size_t pos) const
+  {
+    return pMask[pos];
+  }
+
+  /**
+   * @brief Account a replica placed on a leaf so that the arrays can be
+   *        reused for the next replica without rebuilding them
+   * @param pos position of the leaf in the arrays
+   */
+  inline void decrementFreeSlot(size_t pos)
+  {
+    if (pFreeSlots[pos]) {
+      pFreeSlots[pos]--;
+    }
+  }
+
+protected:
+#ifdef __SSE4_1__
+  static inline __m128i load4(const void* ptr)
+  {
+    int32_t val;
+    memcpy(&val, ptr, sizeof(val));
+    return _mm_cvtsi32_si128(val);
+  }
+#endif
+
+  void resize(size_t n)
+  {
+    pNodeIdx.resize(n);
+    pStatus.resize(n);
+    pDlScore.resize(n);
+    pUlScore.resize(n);
+    pFillRatio.resize(n);
+    pFreeSlots.resize(n);
+    pMask.assign(n, 0);
+    pScores.resize(n);
+  }
+
+  std::vector<tFastTreeIdx> pNodeIdx;
+  std::vector<int16_t> pStatus;
+  std::vector<char> pDlScore;
+  std::vector<char> pUlScore;
+  std::vector<char> pFillRatio;
+  std::vector<unsigned char> pFreeSlots;
+  std::vector<unsigned char> pMask;
+  std::vector<int32_t> pScores;
+};
+
 /*----------------------------------------------------------------------------*/
 /**
  * @brief FastTree instantiation for replica placement.
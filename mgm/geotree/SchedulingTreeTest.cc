@@ -312,6 +312,127 @@ bool testAccess(const std::string& toAccess, const std::string& accessible)
   return false;
 }
 
+//------------------------------------------------------------------------------
+// Check the structure-of-arrays leaf selection against the per node one and
+// compare their speed on a group with many file systems
+//------------------------------------------------------------------------------
+void benchmarkLeafArray(size_t nFs, size_t nLoops)
+{
+  SlowTree st("bench");
+  SchedTreeBase::TreeNodeInfo info;
+  SchedTreeBase::TreeNodeStateFloat state;
+  srand(0);
+
+  for (size_t i = 0; i < nFs; i++) {
+    ostringstream oss;
+    oss << "site" << i % 2 << "::rack" << i % 20;
+    info.geotag = oss.str();
+    oss << "::host" << i / 20;
+    info.host = oss.str();
+    info.fsId = i + 1;
+    state.dlScore = rand() % 100;
+    state.ulScore = rand() % 100;
+    state.fillRatio = rand() % 100;
+    state.totalSpace = 2e12;
+    state.mStatus = SchedTreeBase::Available | SchedTreeBase::Writable |
+                    SchedTreeBase::Readable;
+
+    if (!(rand() % 16)) {
+      state.mStatus = (SchedTreeBase::tStatus)(state.mStatus |
+                      SchedTreeBase::Disabled);
+    } else if (!(rand() % 16)) {
+      state.mStatus = (SchedTreeBase::tStatus)(state.mStatus &
+                      ~SchedTreeBase::Writable);
+    }
+
+    assert(st.insert(&info, &state) != NULL);
+  }
+
+  FastPlacementTree fpt;
+  FastROAccessTree froat;
+  FastRWAccessTree frwat;
+  FastBalancingPlacementTree fbpt;
+  FastBalancingAccessTree fbat;
+  FastDrainingPlacementTree fdpt;
+  FastDrainingAccessTree fdat;
+  SchedTreeBase::FastTreeInfo ftinfo;
+  Fs2TreeIdxMap ftmap;
+  GeoTag2NodeIdxMap geomap;
+  fpt.selfAllocate(st.getNodeCount());
+  froat.selfAllocate(st.getNodeCount());
+  frwat.selfAllocate(st.getNodeCount());
+  fbpt.selfAllocate(st.getNodeCount());
+  fbat.selfAllocate(st.getNodeCount());
+  fdpt.selfAllocate(st.getNodeCount());
+  fdat.selfAllocate(st.getNodeCount());
+  assert(st.buildFastStrcturesSched(&fpt, &froat, &frwat, &fbpt, &fbat, &fdpt,
+                                    &fdat, &ftinfo, &ftmap, &geomap));
+  const char saturationThresh = 20;
+  fpt.setSaturationThreshold(saturationThresh);
+  FastLeafArray leaves;
+  leaves.build(fpt);
+  assert(leaves.size() == nFs);
+  // the fill ratio limit does not exclude anything to match the tree
+  size_t nSelected = leaves.filterPlacement(saturationThresh, 100);
+  size_t nRefSelected = 0;
+
+  for (size_t pos = 0; pos < leaves.size(); pos++) {
+    SchedTreeBase::tFastTreeIdx node = leaves.getNodeIdx(pos);
+    bool ref = fpt.isValidSlotNode(node) && !fpt.isSaturatedSlotNode(node);
+    assert(ref == leaves.isSelected(pos));
+    nRefSelected += ref;
+  }
+
+  assert(nSelected == nRefSelected);
+  // the best download score is the highest saturation threshold that still
+  // selects a leaf
+  long best = leaves.argmaxScore(1, 0, 0);
+  assert(best >= 0 && leaves.isSelected(best));
+  char bestScore = saturationThresh;
+
+  while (leaves.filterPlacement(bestScore + 1, 100)) {
+    bestScore++;
+  }
+
+  leaves.filterPlacement(bestScore, 100);
+  assert(best == leaves.argmaxScore(1, 0, 0));
+  // compare the speed of the per node and structure-of-arrays filters
+  size_t count = 0;
+  clock_t begin = clock();
+
+  for (size_t loop = 0; loop < nLoops; loop++) {
+    for (size_t pos = 0; pos < leaves.size(); pos++) {
+      SchedTreeBase::tFastTreeIdx node = leaves.getNodeIdx(pos);
+      count += (fpt.isValidSlotNode(node) && !fpt.isSaturatedSlotNode(node));
+    }
+  }
+
+  clock_t elapsed = clock() - begin;
+  cout << "per node filter of " << nFs << " fs            : " << std::setw(10)
+       << (double) elapsed / CLOCKS_PER_SEC / nLoops * 1e9 << " ns" << endl;
+  begin = clock();
+
+  for (size_t loop = 0; loop < nLoops; loop++) {
+    count += leaves.filterPlacement(saturationThresh, 100);
+  }
+
+  elapsed = clock() - begin;
+  cout << "structure-of-arrays filter of " << nFs << " fs : " << std::setw(10)
+       << (double) elapsed / CLOCKS_PER_SEC / nLoops * 1e9 << " ns" << endl;
+  begin = clock();
+
+  for (size_t loop = 0; loop < nLoops; loop++) {
+    leaves.build(fpt);
+    leaves.filterPlacement(saturationThresh, 80);
+    count += leaves.argmaxScore(2, 1, 1);
+  }
+
+  elapsed = clock() - begin;
+  cout << "structure-of-arrays build+filter+argmax of " << nFs << " fs : " <<
+       std::setw(10) << (double) elapsed / CLOCKS_PER_SEC / nLoops * 1e9 <<
+       " ns (" << count << ")" << endl;
+}
+
 int main()
 {
   SlowTree* st = new SlowTree("pg1");
@@ -391,6 +512,7 @@ int main()
   delete fti;
   delete ftmap;
   delete geomap;
+  benchmarkLeafArray(600, 10000);
   return 0;
 }
 
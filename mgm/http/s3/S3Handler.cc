@@ -138,6 +138,10 @@ S3Handler::HandleRequest(eos::common::HttpRequest* request)
       response = Delete(request);
       break;
 
+    case POST:
+      response = Post(request);
+      break;
+
     default:
       response = new eos::common::PlainHttpResponse();
       response->SetResponseCode(eos::common::HttpResponse::NOT_IMPLEMENTED);
@@ -254,8 +258,16 @@ eos::common::HttpResponse*
 S3Handler::Put(eos::common::HttpRequest* request)
 {
   eos::common::HttpResponse* response = 0;
-  response = mS3Store->PutObject(request, GetId(), GetBucket(), GetPath(),
-                                 GetQuery());
+
+  if (mSubResourceMap.count("uploadId") && mSubResourceMap.count("partNumber")) {
+    response = mS3Store->UploadPart(request, GetId(), GetBucket(), GetPath(),
+                                    mSubResourceMap["uploadId"],
+                                    atoi(mSubResourceMap["partNumber"].c_str()));
+  } else {
+    response = mS3Store->PutObject(request, GetId(), GetBucket(), GetPath(),
+                                   GetQuery());
+  }
+
   return response;
 }
 
@@ -264,7 +276,34 @@ eos::common::HttpResponse*
 S3Handler::Delete(eos::common::HttpRequest* request)
 {
   eos::common::HttpResponse* response = 0;
-  response = mS3Store->DeleteObject(request, GetId(), GetBucket(), GetPath());
+
+  if (mSubResourceMap.count("uploadId")) {
+    response = mS3Store->AbortMultipartUpload(GetId(), GetBucket(), GetPath(),
+                                              mSubResourceMap["uploadId"]);
+  } else {
+    response = mS3Store->DeleteObject(request, GetId(), GetBucket(), GetPath());
+  }
+
+  return response;
+}
+
+/*----------------------------------------------------------------------------*/
+eos::common::HttpResponse*
+S3Handler::Post(eos::common::HttpRequest* request)
+{
+  eos::common::HttpResponse* response = 0;
+
+  if (mSubResourceMap.count("uploads")) {
+    response = mS3Store->InitiateMultipartUpload(GetId(), GetBucket(),
+               GetPath());
+  } else if (mSubResourceMap.count("uploadId")) {
+    response = mS3Store->CompleteMultipartUpload(request, GetId(), GetBucket(),
+               GetPath(), mSubResourceMap["uploadId"]);
+  } else {
+    response = new eos::common::PlainHttpResponse();
+    response->SetResponseCode(eos::common::HttpResponse::NOT_IMPLEMENTED);
+  }
+
   return response;
 }
 
@@ -134,7 +134,17 @@ public:
    */
   eos::common::HttpResponse*
   Delete (eos::common::HttpRequest *request);
-  
+
+  /**
+   * Handle an S3 POST request (initiate and complete multipart uploads).
+   *
+   * @param request  the client request object
+   *
+   * @return an HTTP response object
+   */
+  eos::common::HttpResponse*
+  Post (eos::common::HttpRequest *request);
+
   /**
    * Encode an URI
    * 
@@ -28,11 +28,14 @@
 #include "mgm/XrdMgmOfsDirectory.hh"
 #include "namespace/interface/IView.hh"
 #include "namespace/utils/Checksum.hh"
+#include "namespace/Prefetcher.hh"
 #include "common/http/PlainHttpResponse.hh"
 #include "common/Logging.hh"
 #include "common/LayoutId.hh"
 #include "common/FileId.hh"
 #include "common/Timing.hh"
+#include "common/StringConversion.hh"
+#include <openssl/md5.h>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -995,4 +998,511 @@ S3Store::DeleteObject(eos::common::HttpRequest* request,
   return response;
 }
 
+/*----------------------------------------------------------------------------*/
+std::string
+S3Store::ObjectPath(const std::string& bucket, const std::string& path)
+{
+  std::string objectpath = mS3ContainerPath[bucket];
+
+  if (objectpath.length() && (objectpath[objectpath.length() - 1] == '/')) {
+    objectpath.erase(objectpath.length() - 1);
+  }
+
+  objectpath += path;
+  return objectpath;
+}
+
+/*----------------------------------------------------------------------------*/
+eos::common::HttpResponse*
+S3Store::InitiateMultipartUpload(const std::string& id,
+                                 const std::string& bucket,
+                                 const std::string& path)
+{
+  using namespace eos::common;
+  int errc = 0;
+  std::string username = id;
+  Mapping::UserNameToUid(username, errc);
+
+  if (errc) {
+    // error mapping the s3 id to unix id
+    return S3Handler::RestErrorResponse(eos::common::HttpResponse::BAD_REQUEST,
+                                        "InvalidArgument",
+                                        "Unable to map bucket id to virtual id",
+                                        id.c_str(), "");
+  }
+
+  std::string objectpath = ObjectPath(bucket, path);
+
+  if (objectpath.empty() || (objectpath[objectpath.length() - 1] == '/')) {
+    return S3Handler::RestErrorResponse(eos::common::HttpResponse::BAD_REQUEST,
+                                        "InvalidArgument",
+                                        "Multipart uploads need an object key",
+                                        path, "");
+  }
+
+  // the parts are staged in a hidden file next to the object, such that the
+  // completion is a rename in the same directory
+  std::string uploadId = StringConversion::random_uuidstring();
+  MultipartUpload upload;
+  upload.mId = id;
+  upload.mObjectPath = objectpath;
+  upload.mStagingPath = objectpath.substr(0, objectpath.rfind('/') + 1);
+  upload.mStagingPath += ".sys.s3.upload.";
+  upload.mStagingPath += uploadId;
+  upload.mPartSize = 0;
+  upload.mCreated = false;
+  {
+    std::lock_guard<std::mutex> lock(mUploadsMutex);
+    mUploads[uploadId] = upload;
+  }
+  eos_static_info("msg=\"initiated multipart upload\" id=%s path=%s "
+                  "upload-id=%s", id.c_str(), objectpath.c_str(),
+                  uploadId.c_str());
+  std::string result = XML_V1_UTF8;
+  result += "<InitiateMultipartUploadResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">";
+  result += "<Bucket>";
+  result += bucket;
+  result += "</Bucket>";
+  result += "<Key>";
+  result += (path.length() && (path[0] == '/')) ? path.substr(1) : path;
+  result += "</Key>";
+  result += "<UploadId>";
+  result += uploadId;
+  result += "</UploadId>";
+  result += "</InitiateMultipartUploadResult>";
+  HttpResponse* response = new eos::common::PlainHttpResponse();
+  response->AddHeader("Content-Type", "application/xml");
+  response->AddHeader("x-amz-id-2", "unknown");
+  response->AddHeader("x-amz-request-id", "unknown");
+  response->SetBody(result);
+  return response;
+}
+
+/*----------------------------------------------------------------------------*/
+eos::common::HttpResponse*
+S3Store::UploadPart(eos::common::HttpRequest* request,
+                    const std::string& id,
+                    const std::string& bucket,
+                    const std::string& path,
+                    const std::string& uploadId,
+                    int part)
+{
+  using namespace eos::common;
+  HttpResponse* response = 0;
+  int errc = 0;
+  std::string username = id;
+  Mapping::UserNameToUid(username, errc);
+
+  if (errc) {
+    // error mapping the s3 id to unix id
+    return S3Handler::RestErrorResponse(eos::common::HttpResponse::BAD_REQUEST,
+                                        "InvalidArgument",
+                                        "Unable to map bucket id to virtual id",
+                                        id.c_str(), "");
+  }
+
+  if ((part < 1) || (part > 10000)) {
+    return S3Handler::RestErrorResponse(eos::common::HttpResponse::BAD_REQUEST,
+                                        "InvalidArgument",
+                                        "Part number must be an integer between "
+                                        "1 and 10000", path, "");
+  }
+
+  std::string objectpath = ObjectPath(bucket, path);
+  std::string lengthHeader = request->GetHeaders()["content-length"];
+  uint64_t size = strtoull(lengthHeader.c_str(), 0, 10);
+  std::string stagingpath;
+  uint64_t offset = 0;
+  bool create = false;
+  {
+    // all parts but the last one have the same size, part n is placed at
+    // (n-1)*partsize in the staging file
+    std::lock_guard<std::mutex> lock(mUploadsMutex);
+    auto it = mUploads.find(uploadId);
+
+    if ((it == mUploads.end()) || (it->second.mId != id) ||
+        (it->second.mObjectPath != objectpath)) {
+      return S3Handler::RestErrorResponse(eos::common::HttpResponse::NOT_FOUND,
+                                          "NoSuchUpload",
+                                          "The specified upload does not exist",
+                                          path, "");
+    }
+
+    MultipartUpload& upload = it->second;
+
+    if (!upload.mPartSize) {
+      upload.mPartSize = size;
+    }
+
+    if (part > 1) {
+      if (!upload.mPartSize || (size > upload.mPartSize)) {
+        return S3Handler::RestErrorResponse(eos::common::HttpResponse::BAD_REQUEST,
+                                            "InvalidPart",
+                                            "All parts but the last one must "
+                                            "have the same size", path, "");
+      }
+
+      offset = (part - 1) * upload.mPartSize;
+    }
+
+    upload.mParts[part] = std::make_pair(offset, size);
+    stagingpath = upload.mStagingPath;
+    create = !upload.mCreated;
+    upload.mCreated = true;
+  }
+  // force MD5 checksums for S3 file creation
+  std::string newquery = "&eos.checksum.noforce=1&eos.layout.checksum=md5";
+  XrdSecEntity client("unix");
+  client.name = strdup(id.c_str());
+  client.host = strdup(request->GetHeaders()["host"].c_str());
+  client.tident = strdup("http");
+  snprintf(client.prot, sizeof(client.prot) - 1, "https");
+  int rc = SFS_ERROR;
+  XrdSfsFile* file = 0;
+
+  // the first part creates the staging file, the others update it - a part
+  // racing with the creation falls back to an update
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    delete file;
+    file = gOFS->newFile((char*) id.c_str());
+
+    if (!file) {
+      break;
+    }
+
+    rc = file->open(stagingpath.c_str(), create ? SFS_O_CREAT : SFS_O_RDWR,
+                    SFS_O_MKPTH, &client, newquery.c_str());
+
+    if ((rc == SFS_ERROR) && create && (file->error.getErrInfo() == EEXIST)) {
+      create = false;
+      continue;
+    }
+
+    break;
+  }
+
+  if (file) {
+    if (rc == SFS_REDIRECT) {
+      // tell the FST where to place the part in the staging file
+      std::string hostcgi = file->error.getErrText();
+      hostcgi += "&s3.part.offset=";
+      hostcgi += std::to_string(offset);
+      // the embedded server on FSTs is hardcoded to run on port 8001
+      response = HttpServer::HttpRedirect(stagingpath, hostcgi, 8001, false);
+      response->AddHeader("x-amz-website-redirect-location",
+                          response->GetHeaders()["Location"]);
+      std::string body = XML_V1_UTF8;
+      body += "<Error>"
+              "<Code>TemporaryRedirect</Code>"
+              "<Message>Please re-send this request to the specified temporary "
+              "endpoint. Continue to use the original request endpoint for "
+              "future requests.</Message>"
+              "<Endpoint>";
+      body += response->GetHeaders()["Location"];
+      body += "</Endpoint>"
+              "</Error>";
+      response->SetBody(body);
+    } else if ((rc == SFS_ERROR) && (file->error.getErrInfo() == EPERM)) {
+      response = S3Handler::RestErrorResponse(eos::common::HttpResponse::FORBIDDEN,
+                                              "AccessDenied",
+                                              "Access Denied",
+                                              path, "");
+    } else {
+      response = S3Handler::RestErrorResponse(
+                   eos::common::HttpResponse::INTERNAL_SERVER_ERROR,
+                   "Internal Error",
+                   "Part upload currently unavailable",
+                   path, "");
+    }
+
+    // clean up the object
+    delete file;
+  }
+
+  return response;
+}
+
+/*----------------------------------------------------------------------------*/
+eos::common::HttpResponse*
+S3Store::CompleteMultipartUpload(eos::common::HttpRequest* request,
+                                 const std::string& id,
+                                 const std::string& bucket,
+                                 const std::string& path,
+                                 const std::string& uploadId)
+{
+  using namespace eos::common;
+  XrdOucErrInfo error;
+  Mapping::VirtualIdentity vid;
+  Mapping::Nobody(vid);
+  int errc = 0;
+  std::string username = id;
+  uid_t uid = Mapping::UserNameToUid(username, errc);
+
+  if (errc) {
+    // error mapping the s3 id to unix id
+    return S3Handler::RestErrorResponse(eos::common::HttpResponse::BAD_REQUEST,
+                                        "InvalidArgument",
+                                        "Unable to map bucket id to virtual id",
+                                        id.c_str(), "");
+  }
+
+  // set the bucket id as vid
+  vid.uid = uid;
+  vid.uid_list.push_back(uid);
+  std::string objectpath = ObjectPath(bucket, path);
+  // parse the list of <Part><PartNumber>n</PartNumber><ETag>x</ETag></Part>
+  const std::string& body = request->GetBody();
+  std::vector<std::pair<int, std::string>> parts;
+  size_t pos = 0;
+
+  while ((pos = body.find("<Part>", pos)) != std::string::npos) {
+    size_t end = body.find("</Part>", pos);
+
+    if (end == std::string::npos) {
+      break;
+    }
+
+    std::string entry = body.substr(pos, end - pos);
+    pos = end;
+    size_t nstart = entry.find("<PartNumber>");
+    size_t nend = entry.find("</PartNumber>");
+    size_t estart = entry.find("<ETag>");
+    size_t eend = entry.find("</ETag>");
+
+    if ((nstart == std::string::npos) || (nend == std::string::npos)) {
+      return S3Handler::RestErrorResponse(eos::common::HttpResponse::BAD_REQUEST,
+                                          "MalformedXML",
+                                          "The XML you provided was not "
+                                          "well-formed", path, "");
+    }
+
+    nstart += strlen("<PartNumber>");
+    std::string etag;
+
+    if ((estart != std::string::npos) && (eend != std::string::npos)) {
+      estart += strlen("<ETag>");
+      etag = entry.substr(estart, eend - estart);
+      // the quotes may be escaped or not
+      StringConversion::ReplaceStringInPlace(etag, "&quot;", "");
+      StringConversion::ReplaceStringInPlace(etag, "\"", "");
+    }
+
+    parts.push_back(std::make_pair(atoi(entry.substr(nstart,
+                                        nend - nstart).c_str()), etag));
+  }
+
+  if (parts.empty()) {
+    return S3Handler::RestErrorResponse(eos::common::HttpResponse::BAD_REQUEST,
+                                        "MalformedXML",
+                                        "The XML you provided was not "
+                                        "well-formed", path, "");
+  }
+
+  std::string stagingpath;
+  uint64_t totalsize = 0;
+  {
+    std::lock_guard<std::mutex> lock(mUploadsMutex);
+    auto it = mUploads.find(uploadId);
+
+    if ((it == mUploads.end()) || (it->second.mId != id) ||
+        (it->second.mObjectPath != objectpath)) {
+      return S3Handler::RestErrorResponse(eos::common::HttpResponse::NOT_FOUND,
+                                          "NoSuchUpload",
+                                          "The specified upload does not exist",
+                                          path, "");
+    }
+
+    MultipartUpload& upload = it->second;
+
+    // the parts have been written in place, they have to cover the staging
+    // file without holes: 1..n, each but the last one of the part size
+    for (size_t i = 0; i < parts.size(); ++i) {
+      auto part = upload.mParts.find(parts[i].first);
+
+      if ((parts[i].first != (int)(i + 1)) || (part == upload.mParts.end()) ||
+          (part->second.first != totalsize) ||
+          (((i + 1) < parts.size()) &&
+           (part->second.second != upload.mPartSize))) {
+        return S3Handler::RestErrorResponse(eos::common::HttpResponse::BAD_REQUEST,
+                                            "InvalidPart",
+                                            "The parts must be numbered from 1 "
+                                            "and all but the last one have the "
+                                            "same size", path, "");
+      }
+
+      totalsize += part->second.second;
+    }
+
+    if (upload.mParts.rbegin()->first != parts.back().first) {
+      return S3Handler::RestErrorResponse(eos::common::HttpResponse::BAD_REQUEST,
+                                          "InvalidPart",
+                                          "All uploaded parts have to be part "
+                                          "of the object", path, "");
+    }
+
+    stagingpath = upload.mStagingPath;
+  }
+
+  // metadata-only commit: the staging file becomes the object
+  if (gOFS->_rename(stagingpath.c_str(), objectpath.c_str(), error, vid,
+                    0, 0, true, false, true)) {
+    if (error.getErrInfo() == EPERM) {
+      return S3Handler::RestErrorResponse(eos::common::HttpResponse::FORBIDDEN,
+                                          "AccessDenied",
+                                          "Access Denied",
+                                          path, "");
+    }
+
+    return S3Handler::RestErrorResponse(
+             eos::common::HttpResponse::INTERNAL_SERVER_ERROR,
+             "Internal Error",
+             "Unable to assemble the object", path, "");
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mUploadsMutex);
+    mUploads.erase(uploadId);
+  }
+
+  // the parts have been stored without checksum, let the FSTs compute the
+  // checksum and commit it together with the size of the assembled object
+  eos::IFileMD::LocationVector locations;
+
+  try {
+    eos::Prefetcher::prefetchFileMDAndWait(gOFS->eosView, objectpath);
+    eos::common::RWMutexReadLock nslock(gOFS->eosViewRWMutex);
+    locations = gOFS->eosView->getFile(objectpath)->getLocations();
+  } catch (eos::MDException& e) {
+    eos_static_err("msg=\"cannot find assembled object\" path=%s",
+                   objectpath.c_str());
+  }
+
+  Mapping::VirtualIdentity rootvid;
+  Mapping::Root(rootvid);
+
+  for (auto fsid : locations) {
+    XrdOucErrInfo verror;
+
+    if (gOFS->_verifystripe(objectpath.c_str(), verror, rootvid, fsid,
+                            "&mgm.verify.compute.checksum=1&"
+                            "mgm.verify.commit.checksum=1&"
+                            "mgm.verify.commit.size=1")) {
+      eos_static_err("msg=\"failed to verify assembled object\" path=%s "
+                     "fsid=%u", objectpath.c_str(), fsid);
+    }
+  }
+
+  // the S3 ETag of a multipart object is the MD5 of the MD5s of the parts
+  MD5_CTX ctx;
+  MD5_Init(&ctx);
+
+  for (const auto& part : parts) {
+    unsigned char digest[MD5_DIGEST_LENGTH];
+    memset(digest, 0, sizeof(digest));
+
+    for (size_t i = 0; (i < MD5_DIGEST_LENGTH) &&
+         ((2 * i + 1) < part.second.length()); ++i) {
+      digest[i] = strtoul(part.second.substr(2 * i, 2).c_str(), 0, 16);
+    }
+
+    MD5_Update(&ctx, digest, MD5_DIGEST_LENGTH);
+  }
+
+  unsigned char md5[MD5_DIGEST_LENGTH];
+  MD5_Final(md5, &ctx);
+  std::string etag;
+  char hexs[3];
+
+  for (int i = 0; i < MD5_DIGEST_LENGTH; ++i) {
+    snprintf(hexs, sizeof(hexs), "%02x", md5[i]);
+    etag += hexs;
+  }
+
+  etag += "-";
+  etag += std::to_string(parts.size());
+  eos_static_info("msg=\"completed multipart upload\" id=%s path=%s "
+                  "upload-id=%s parts=%zu size=%llu", id.c_str(),
+                  objectpath.c_str(), uploadId.c_str(), parts.size(),
+                  (unsigned long long) totalsize);
+  std::string result = XML_V1_UTF8;
+  result += "<CompleteMultipartUploadResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">";
+  result += "<Location>";
+  result += path;
+  result += "</Location>";
+  result += "<Bucket>";
+  result += bucket;
+  result += "</Bucket>";
+  result += "<Key>";
+  result += (path.length() && (path[0] == '/')) ? path.substr(1) : path;
+  result += "</Key>";
+  result += "<ETag>\"";
+  result += etag;
+  result += "\"</ETag>";
+  result += "</CompleteMultipartUploadResult>";
+  HttpResponse* response = new eos::common::PlainHttpResponse();
+  response->AddHeader("Content-Type", "application/xml");
+  response->AddHeader("x-amz-id-2", "unknown");
+  response->AddHeader("x-amz-request-id", "unknown");
+  response->SetBody(result);
+  return response;
+}
+
+/*----------------------------------------------------------------------------*/
+eos::common::HttpResponse*
+S3Store::AbortMultipartUpload(const std::string& id,
+                              const std::string& bucket,
+                              const std::string& path,
+                              const std::string& uploadId)
+{
+  using namespace eos::common;
+  XrdOucErrInfo error;
+  Mapping::VirtualIdentity vid;
+  Mapping::Nobody(vid);
+  int errc = 0;
+  std::string username = id;
+  uid_t uid = Mapping::UserNameToUid(username, errc);
+
+  if (errc) {
+    // error mapping the s3 id to unix id
+    return S3Handler::RestErrorResponse(eos::common::HttpResponse::BAD_REQUEST,
+                                        "InvalidArgument",
+                                        "Unable to map bucket id to virtual id",
+                                        id.c_str(), "");
+  }
+
+  // set the bucket id as vid
+  vid.uid = uid;
+  vid.uid_list.push_back(uid);
+  std::string objectpath = ObjectPath(bucket, path);
+  MultipartUpload upload;
+  {
+    std::lock_guard<std::mutex> lock(mUploadsMutex);
+    auto it = mUploads.find(uploadId);
+
+    if ((it == mUploads.end()) || (it->second.mId != id) ||
+        (it->second.mObjectPath != objectpath)) {
+      return S3Handler::RestErrorResponse(eos::common::HttpResponse::NOT_FOUND,
+                                          "NoSuchUpload",
+                                          "The specified upload does not exist",
+                                          path, "");
+    }
+
+    upload = it->second;
+    mUploads.erase(it);
+  }
+
+  if (upload.mCreated &&
+      gOFS->_rem(upload.mStagingPath.c_str(), error, vid, (const char*) 0) &&
+      (error.getErrInfo() != ENOENT)) {
+    eos_static_err("msg=\"failed to remove staging file\" path=%s errno=%d",
+                   upload.mStagingPath.c_str(), error.getErrInfo());
+  }
+
+  HttpResponse* response = new eos::common::PlainHttpResponse();
+  response->AddHeader("Connection", "close");
+  response->AddHeader("Server", gOFS->HostName);
+  response->SetResponseCode(response->NO_CONTENT);
+  return response;
+}
+
 EOSMGMNAMESPACE_END
@@ -38,6 +38,7 @@
 /*----------------------------------------------------------------------------*/
 /*----------------------------------------------------------------------------*/
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
 /*----------------------------------------------------------------------------*/
@@ -56,6 +57,33 @@ private:
   std::map<std::string, std::string>           mS3ContainerPath;       //< map pointing from container name to path
   std::string                                  mS3DefContainer;        //< path where all s3 objects are defined
 
+  /**
+   * State of a multipart upload. The parts are written in parallel straight
+   * into a staging file next to the object, part n at offset (n-1)*partsize
+   */
+  struct MultipartUpload {
+    std::string                               mId;          //< S3 id of the client who started the upload
+    std::string                               mObjectPath;  //< path of the object
+    std::string                               mStagingPath; //< path of the file receiving the parts
+    uint64_t                                  mPartSize;    //< size of all the parts but the last one
+    bool                                      mCreated;     //< staging file was created
+    std::map<int, std::pair<uint64_t, uint64_t>> mParts;    //< part number to offset and size
+  };
+
+  std::mutex                                   mUploadsMutex;          //< mutex protecting mUploads
+  std::map<std::string, MultipartUpload>       mUploads;               //< map pointing from upload id to upload
+
+  /**
+   * Build the namespace path of an object
+   *
+   * @param bucket  the name of the bucket
+   * @param path    the request path
+   *
+   * @return path in the namespace
+   */
+  std::string
+  ObjectPath (const std::string &bucket, const std::string &path);
+
 public:
 
   /**
@@ -184,6 +212,78 @@ public:
                 const std::string        &bucket,
                 const std::string        &path);
 
+  /**
+   * Start a multipart upload (POST ?uploads)
+   *
+   * @param id      the S3 id of the client
+   * @param bucket  the name of the bucket
+   * @param path    the request path
+   *
+   * @return S3 HTTP response object with the upload id
+   */
+  eos::common::HttpResponse*
+  InitiateMultipartUpload (const std::string &id,
+                           const std::string &bucket,
+                           const std::string &path);
+
+  /**
+   * Upload one part (PUT ?partNumber=n&uploadId=x). The client is redirected
+   * to the FST which writes the part at its offset in the staging file, so
+   * that the parts are transferred in parallel.
+   *
+   * @param request   the client request object
+   * @param id        the S3 id of the client
+   * @param bucket    the name of the bucket
+   * @param path      the request path
+   * @param uploadId  the id of the upload
+   * @param part      the part number (1-10000)
+   *
+   * @return S3 HTTP response object (redirection)
+   */
+  eos::common::HttpResponse*
+  UploadPart (eos::common::HttpRequest *request,
+              const std::string        &id,
+              const std::string        &bucket,
+              const std::string        &path,
+              const std::string        &uploadId,
+              int                       part);
+
+  /**
+   * Complete a multipart upload (POST ?uploadId=x). The parts are already in
+   * place, the staging file is renamed to the object and its checksum and
+   * size are verified by the FSTs in the background.
+   *
+   * @param request   the client request object holding the list of parts
+   * @param id        the S3 id of the client
+   * @param bucket    the name of the bucket
+   * @param path      the request path
+   * @param uploadId  the id of the upload
+   *
+   * @return S3 HTTP response object
+   */
+  eos::common::HttpResponse*
+  CompleteMultipartUpload (eos::common::HttpRequest *request,
+                           const std::string        &id,
+                           const std::string        &bucket,
+                           const std::string        &path,
+                           const std::string        &uploadId);
+
+  /**
+   * Abort a multipart upload (DELETE ?uploadId=x)
+   *
+   * @param id        the S3 id of the client
+   * @param bucket    the name of the bucket
+   * @param path      the request path
+   * @param uploadId  the id of the upload
+   *
+   * @return S3 HTTP response object
+   */
+  eos::common::HttpResponse*
+  AbortMultipartUpload (const std::string &id,
+                        const std::string &bucket,
+                        const std::string &path,
+                        const std::string &uploadId);
+
 };
 
 /*----------------------------------------------------------------------------*/
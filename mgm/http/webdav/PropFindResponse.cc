@@ -31,11 +31,19 @@
 #include "common/Logging.hh"
 #include "common/Timing.hh"
 #include "common/Path.hh"
+#include "common/FileId.hh"
 #include "common/http/OwnCloud.hh"
+#include "namespace/utils/Etag.hh"
+#include "namespace/utils/Stat.hh"
 #include "XrdOuc/XrdOucErrInfo.hh"
+#include <algorithm>
+#include <vector>
 
 EOSMGMNAMESPACE_BEGIN
 
+//! Number of children whose metadata is read under one namespace lock
+static const size_t sPropFindBatchSize = 1024;
+
 /*----------------------------------------------------------------------------*/
 char dav_rfc3986[256] = {0};
 char dav_html5[256] = {0};
@@ -124,19 +132,14 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
     }
   }
 
-  // Build the response
-  // xml declaration
-  xml_node<>* decl = mXMLResponseDocument.allocate_node(node_declaration);
-  decl->append_attribute(AllocateAttribute("version", "1.0"));
-  decl->append_attribute(AllocateAttribute("encoding", "utf-8"));
-  mXMLResponseDocument.append_node(decl);
-  // <multistatus/> node
-  xml_node<>* multistatusNode = AllocateNode("d:multistatus");
-  multistatusNode->append_attribute(AllocateAttribute("xmlns:d", "DAV:"));
-  multistatusNode->append_attribute(
-    AllocateAttribute(eos::common::OwnCloud::OwnCloudNs(),
-                      eos::common::OwnCloud::OwnCloudNsUrl()));
-  mXMLResponseDocument.append_node(multistatusNode);
+  // Build the response. The multistatus document is serialized incrementally,
+  // the DOM only ever holds the response node of a single entry
+  std::string responseString = "<?xml version=\"1.0\" encoding=\"utf-8\"?>";
+  responseString += "<d:multistatus xmlns:d=\"DAV:\" ";
+  responseString += eos::common::OwnCloud::OwnCloudNs();
+  responseString += "=\"";
+  responseString += eos::common::OwnCloud::OwnCloudNsUrl();
+  responseString += "\">";
   // Is the requested resource a file or directory?
   XrdOucErrInfo error;
   struct stat statInfo;
@@ -164,12 +167,13 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
     responseNode = BuildResponseNode(request->GetUrl(), request->GetUrl(true));
 
     if (responseNode) {
-      multistatusNode->append_node(responseNode);
+      AppendResponseNode(responseString, responseNode);
     } else {
       return this;
     }
   } else if (depth == "1") {
-    // Stat the resource and all child resources
+    // Stat the resource and all child resources, opening the directory
+    // prefetches the metadata of all the children in parallel
     XrdMgmOfsDirectory directory;
     int listrc = directory.open(request->GetUrl().c_str(), *mVirtualIdentity,
                                 (const char*) 0);
@@ -177,11 +181,12 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
                                      request->GetUrl(true).c_str());
 
     if (responseNode) {
-      multistatusNode->append_node(responseNode);
+      AppendResponseNode(responseString, responseNode);
     }
 
     if (!listrc) {
       const char* val;
+      std::vector<std::string> names;
 
       while ((val = directory.nextEntry())) {
         XrdOucString entryname = val;
@@ -196,19 +201,35 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
           continue;
         }
 
-        // one response node for each file...
-        eos::common::Path path((request->GetUrl() + std::string("/") + std::string(
-                                  val)).c_str());
-        eos::common::Path refpath((request->GetUrl(true) + std::string("/") +
-                                   std::string(val)).c_str());
-        responseNode = BuildResponseNode(path.GetPath(), refpath.GetPath());
-
-        if (responseNode) {
-          multistatusNode->append_node(responseNode);
-        } else {
-          // We might have a failed stat in the BuildResponseNode if there are
-          // symlinks present
-          SetResponseCode(HttpResponse::OK);
+        names.push_back(val);
+      }
+
+      eos::common::Path dirpath(request->GetUrl().c_str());
+
+      for (size_t first = 0; first < names.size(); first += sPropFindBatchSize) {
+        size_t last = std::min(names.size(), first + sPropFindBatchSize);
+        std::vector<EntryStat> stats(last - first);
+        // Read the cached metadata of a batch of children under one lock
+        // instead of resolving the full path of every child
+        StatEntries(dirpath.GetPath(), names, first, stats);
+
+        for (size_t i = first; i < last; ++i) {
+          // one response node for each file...
+          eos::common::Path path((request->GetUrl() + std::string("/") +
+                                  names[i]).c_str());
+          eos::common::Path refpath((request->GetUrl(true) + std::string("/") +
+                                     names[i]).c_str());
+          EntryStat& entry = stats[i - first];
+          responseNode = BuildResponseNode(path.GetPath(), refpath.GetPath(),
+                                           entry.mValid ? &entry : 0);
+
+          if (responseNode) {
+            AppendResponseNode(responseString, responseNode);
+          } else {
+            // We might have a failed stat in the BuildResponseNode if there are
+            // symlinks present
+            SetResponseCode(HttpResponse::OK);
+          }
         }
       }
     } else {
@@ -226,10 +247,7 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
     return this;
   }
 
-  std::string responseString;
-  rapidxml::print(std::back_inserter(responseString), mXMLResponseDocument,
-                  rapidxml::print_no_indenting);
-  mXMLResponseDocument.clear();
+  responseString += "</d:multistatus>";
   SetResponseCode(HttpResponse::MULTI_STATUS);
   AddHeader("Content-Length", std::to_string((long long) responseString.size()));
   AddHeader("Content-Type", "application/xml; charset=utf-8");
@@ -237,6 +255,88 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
   return this;
 }
 
+/*----------------------------------------------------------------------------*/
+void
+PropFindResponse::AppendResponseNode(std::string& out,
+                                     rapidxml::xml_node<>* node)
+{
+  rapidxml::print(std::back_inserter(out), *node, rapidxml::print_no_indenting);
+  // release the memory of the serialized node
+  mXMLResponseDocument.clear();
+}
+
+/*----------------------------------------------------------------------------*/
+void
+PropFindResponse::StatEntries(const std::string& dir,
+                              const std::vector<std::string>& names,
+                              size_t first,
+                              std::vector<EntryStat>& stats)
+{
+  eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+  std::shared_ptr<eos::IContainerMD> cmd;
+
+  try {
+    cmd = gOFS->eosView->getContainer(dir);
+  } catch (eos::MDException& e) {
+    eos_static_debug("msg=\"exception\" ec=%d emsg=\"%s\"", e.getErrno(),
+                     e.getMessage().str().c_str());
+    return;
+  }
+
+  for (size_t i = 0; i < stats.size(); ++i) {
+    EntryStat& entry = stats[i];
+    struct stat& buf = entry.mStat;
+    memset(&buf, 0, sizeof(struct stat));
+
+    try {
+      std::shared_ptr<eos::IFileMD> fmd = cmd->findFile(names[first + i]);
+
+      if (fmd) {
+        // symbolic links are resolved by the regular stat
+        if (fmd->isLink()) {
+          continue;
+        }
+
+        eos::IFileMD::ctime_t ts;
+        buf.st_ino = eos::common::FileId::FidToInode(fmd->getId());
+        buf.st_mode = eos::modeFromMetadataEntry(fmd);
+        buf.st_size = fmd->getSize();
+        fmd->getCTime(ts);
+        buf.st_ctim.tv_sec = ts.tv_sec;
+        buf.st_ctim.tv_nsec = ts.tv_nsec;
+        fmd->getMTime(ts);
+        buf.st_mtim.tv_sec = ts.tv_sec;
+        buf.st_mtim.tv_nsec = ts.tv_nsec;
+        eos::calculateEtag(fmd.get(), entry.mEtag);
+        entry.mValid = true;
+        continue;
+      }
+
+      std::shared_ptr<eos::IContainerMD> ccmd =
+        cmd->findContainer(names[first + i]);
+
+      if (ccmd) {
+        eos::IContainerMD::ctime_t ts;
+        buf.st_ino = ccmd->getId();
+        buf.st_mode = eos::modeFromMetadataEntry(ccmd);
+        buf.st_size = ccmd->getTreeSize();
+        ccmd->getCTime(ts);
+        buf.st_ctim.tv_sec = ts.tv_sec;
+        buf.st_ctim.tv_nsec = ts.tv_nsec;
+        ccmd->getMTime(ts);
+        buf.st_mtim.tv_sec = ts.tv_sec;
+        buf.st_mtim.tv_nsec = ts.tv_nsec;
+        eos::calculateEtag(ccmd.get(), entry.mEtag);
+        entry.mValid = true;
+      }
+    } catch (eos::MDException& e) {
+      // the entry gets another chance with the regular stat
+      eos_static_debug("msg=\"exception\" ec=%d emsg=\"%s\"", e.getErrno(),
+                       e.getMessage().str().c_str());
+    }
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 void
 PropFindResponse::ParseRequestPropertyTypes(rapidxml::xml_node<>* node)
@@ -307,7 +407,8 @@ PropFindResponse::ParseRequestPropertyTypes(rapidxml::xml_node<>* node)
 /*----------------------------------------------------------------------------*/
 rapidxml::xml_node<>*
 PropFindResponse::BuildResponseNode(const std::string& url,
-                                    const std::string& hrefurl)
+                                    const std::string& hrefurl,
+                                    const EntryStat* entry)
 {
   using namespace rapidxml;
   XrdOucErrInfo error;
@@ -327,8 +428,11 @@ PropFindResponse::BuildResponseNode(const std::string& url,
   // Is the requested resource a file or directory?
   eos_static_debug("url=%s", urlp.c_str());
 
-  if (gOFS->_stat(urlp.c_str(), &statInfo, error, *mVirtualIdentity,
-                  (const char*) 0, &etag)) {
+  if (entry) {
+    statInfo = entry->mStat;
+    etag = entry->mEtag;
+  } else if (gOFS->_stat(urlp.c_str(), &statInfo, error, *mVirtualIdentity,
+                         (const char*) 0, &etag)) {
     eos_static_err("msg=\"error stating %s: %s\"", urlp.c_str(),
                    error.getErrText());
     SetResponseCode(ResponseCodes::NOT_FOUND);
@@ -43,6 +43,10 @@
 /*----------------------------------------------------------------------------*/
 #include "XrdOuc/XrdOucErrInfo.hh"
 /*----------------------------------------------------------------------------*/
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+/*----------------------------------------------------------------------------*/
 
 EOSMGMNAMESPACE_BEGIN;
 
@@ -81,6 +85,16 @@ public:
     ALLPROP_MARKER = 0xf000
   };
 
+  /**
+   * Metadata of a listed entry read in a batch
+   */
+  struct EntryStat {
+    EntryStat () : mValid (false) {}
+    bool mValid;        //!< the entry was found among the cached children
+    struct stat mStat;  //!< stat information of the entry
+    std::string mEtag;  //!< ETag of the entry
+  };
+
 protected:
   int mRequestPropertyTypes; //!< properties that were requested
   eos::common::Mapping::VirtualIdentity *mVirtualIdentity; //!< virtual identity for this client
@@ -144,12 +158,39 @@ public:
    * Build a response XML <response/> node containing the properties that were
    * requested, whether they were found or not, etc (see RFC)
    *
-   * @param url  the URL of the resource to build a response node for
+   * @param url    the URL of the resource to build a response node for
+   * @param entry  the metadata of the resource if already known, otherwise
+   *               the resource is stat'ed
    *
    * @return the newly build response node
    */
   rapidxml::xml_node<>*
-  BuildResponseNode (const std::string &url, const std::string &hrefurl);
+  BuildResponseNode (const std::string &url, const std::string &hrefurl,
+                     const EntryStat *entry = 0);
+
+  /**
+   * Serialize a response node and release the memory of the response
+   * document.
+   *
+   * @param out   the string the node is appended to
+   * @param node  the node to serialize
+   */
+  void
+  AppendResponseNode (std::string &out, rapidxml::xml_node<> *node);
+
+  /**
+   * Read the metadata of a batch of directory entries under a single
+   * namespace lock from the already cached children of the directory. The
+   * entries which are not found (or are symbolic links) are left invalid.
+   *
+   * @param dir    the path of the directory
+   * @param names  the names of the entries in the directory
+   * @param first  the index of the first entry of the batch
+   * @param stats  the metadata of the batch, sized to the batch length
+   */
+  void
+  StatEntries (const std::string &dir, const std::vector<std::string> &names,
+               size_t first, std::vector<EntryStat> &stats);
 
   /**
    * Convert the given property type string into its integer constant
@@ -51,6 +51,12 @@ IProcCommand::open(const char* path, const char* info,
 
   if (!mExecRequest) {
     if (HasSlot()) {
+      // Stream the output of long running commands instead of buffering it
+      if (mStreamable && mDoAsync &&
+          (mReqProto.format() == eos::console::RequestProto::DEFAULT)) {
+        mPipe.reset(new ProcOutputPipe(sStreamPipeSize));
+      }
+
       LaunchJob();
       mExecRequest = true;
     } else {
@@ -60,6 +66,10 @@ IProcCommand::open(const char* path, const char* info,
     }
   }
 
+  if (mPipe) {
+    return SFS_OK;
+  }
+
   if (mFuture.wait_for(std::chrono::seconds(delay)) !=
       std::future_status::ready) {
     // Stall the client
@@ -102,25 +112,34 @@ IProcCommand::open(const char* path, const char* info,
       mTmpResp = oss.str();
     }
 
-    // Store the client's command comment in the comments logbook
-    if ((vid.uid <= 2) || (vid.sudoer)) {
-      // Only instance users or sudoers can add to the logbook
-      if (mComment.length() && gOFS->mCommentLog) {
-        std::string argsJson;
-        (void) google::protobuf::util::MessageToJsonString(mReqProto, &argsJson);
-
-        if (!gOFS->mCommentLog->Add(mTimestamp, "", "", argsJson.c_str(),
-                                    mComment.c_str(), stdErr.c_str(),
-                                    reply.retc())) {
-          eos_err("failed to log to comments logbook");
-        }
-      }
-    }
+    StoreComment(vid, reply);
   }
 
   return SFS_OK;
 }
 
+//------------------------------------------------------------------------------
+// Store the client's command comment in the comments logbook
+//------------------------------------------------------------------------------
+void
+IProcCommand::StoreComment(const eos::common::Mapping::VirtualIdentity& vid,
+                           const eos::console::ReplyProto& reply)
+{
+  if ((vid.uid <= 2) || (vid.sudoer)) {
+    // Only instance users or sudoers can add to the logbook
+    if (mComment.length() && gOFS->mCommentLog) {
+      std::string argsJson;
+      (void) google::protobuf::util::MessageToJsonString(mReqProto, &argsJson);
+
+      if (!gOFS->mCommentLog->Add(mTimestamp, "", "", argsJson.c_str(),
+                                  mComment.c_str(), stdErr.c_str(),
+                                  reply.retc())) {
+        eos_err("failed to log to comments logbook");
+      }
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 // Read a part of the result stream created during open
 //------------------------------------------------------------------------------
@@ -129,7 +148,9 @@ IProcCommand::read(XrdSfsFileOffset offset, char* buff, XrdSfsXferSize blen)
 {
   size_t cpy_len = 0;
 
-  if (readStdOutStream && ifstdoutStream.is_open() && ifstderrStream.is_open()) {
+  if (mPipe) {
+    cpy_len = mPipe->Read(buff, blen);
+  } else if (readStdOutStream && ifstdoutStream.is_open() && ifstderrStream.is_open()) {
     ifstdoutStream.read(buff, blen);
     cpy_len = (size_t)ifstdoutStream.gcount();
 
@@ -173,7 +194,13 @@ IProcCommand::LaunchJob()
   if (mDoAsync) {
     mFuture = ProcInterface::sProcThreads.PushTask<eos::console::ReplyProto>
     ([this]() -> eos::console::ReplyProto {
-      return ProcessRequest();
+      eos::console::ReplyProto reply = ProcessRequest();
+
+      if (mPipe) {
+        CloseStreamingOutput(reply);
+      }
+
+      return reply;
     });
 
     if (EOS_LOGS_DEBUG) {
@@ -198,6 +225,11 @@ IProcCommand::KillJob()
   if (mDoAsync) {
     mForceKill.store(true);
 
+    // Unblock the command if waiting for the client to consume its output
+    if (mPipe) {
+      mPipe->CloseRead();
+    }
+
     if (mFuture.valid()) {
       is_killed = (mFuture.wait_for(std::chrono::seconds(0)) ==
                    std::future_status::ready);
@@ -213,6 +245,10 @@ IProcCommand::KillJob()
 bool
 IProcCommand::OpenTemporaryOutputFiles()
 {
+  if (mPipe) {
+    return (OpenStreamingOutput() != nullptr);
+  }
+
   ostringstream tmpdir;
   tmpdir << "/tmp/eos.mgm/";
   tmpdir << uuid++;
@@ -260,11 +296,75 @@ IProcCommand::OpenTemporaryOutputFiles()
 bool
 IProcCommand::CloseTemporaryOutputFiles()
 {
+  if (mPipe) {
+    mPipe->GetStream().flush();
+    return true;
+  }
+
   ofstdoutStream.close();
   ofstderrStream.close();
   return !(ofstdoutStream.is_open() || ofstderrStream.is_open());
 }
 
+//------------------------------------------------------------------------------
+// Start streaming the output of the command to the client
+//------------------------------------------------------------------------------
+std::ostream*
+IProcCommand::OpenStreamingOutput()
+{
+  if (!mPipe) {
+    return nullptr;
+  }
+
+  if (!mStreamStarted) {
+    mPipe->GetStream() << "mgm.proc.stdout=";
+    mStreamStarted = true;
+  }
+
+  return &mPipe->GetStream();
+}
+
+//------------------------------------------------------------------------------
+// Get stream for the output of commands using the temporary output files
+//------------------------------------------------------------------------------
+std::ostream&
+IProcCommand::StdOutStream()
+{
+  if (mPipe) {
+    return mPipe->GetStream();
+  }
+
+  return ofstdoutStream;
+}
+
+//------------------------------------------------------------------------------
+// Get stream for the errors of commands using the temporary output files
+//------------------------------------------------------------------------------
+std::ostream&
+IProcCommand::StdErrStream()
+{
+  if (mPipe) {
+    return mStreamErr;
+  }
+
+  return ofstderrStream;
+}
+
+//------------------------------------------------------------------------------
+// Write the remaining output, the errors and the return code of the command
+// to the output pipe and close it
+//------------------------------------------------------------------------------
+void
+IProcCommand::CloseStreamingOutput(const eos::console::ReplyProto& reply)
+{
+  std::ostream& out = *OpenStreamingOutput();
+  out << reply.std_out()
+      << "&mgm.proc.stderr=" << mStreamErr.str() << reply.std_err()
+      << "&mgm.proc.retc=" << reply.retc();
+  mPipe->CloseWrite();
+  StoreComment(mVid, reply);
+}
+
 //------------------------------------------------------------------------------
 // Format console output string as json
 //------------------------------------------------------------------------------
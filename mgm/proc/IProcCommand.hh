@@ -22,6 +22,7 @@
 
 #pragma once
 #include "mgm/Namespace.hh"
+#include "mgm/proc/ProcOutputPipe.hh"
 #include "common/Mapping.hh"
 #include "common/Logging.hh"
 #include "proto/ConsoleReply.pb.h"
@@ -29,6 +30,7 @@
 #include "XrdSfs/XrdSfsInterface.hh"
 #include "json/json.h"
 #include <future>
+#include <memory>
 #include <sstream>
 
 //! Forward declarations
@@ -49,7 +51,7 @@ public:
   IProcCommand():
     mHasSlot(false), mExecRequest(false), mReqProto(), mDoAsync(false),
     mForceKill(false), mVid(), mComment(), stdOut(), stdErr(), stdJson(),
-    retc(0), mTmpResp()
+    retc(0), mTmpResp(), mStreamable(false), mStreamStarted(false)
   {
     mTimestamp = time(NULL);
   }
@@ -98,7 +100,9 @@ public:
   //----------------------------------------------------------------------------
   //! Open a proc command e.g. call the appropriate user or admin command and
   //! store the output in a resultstream of in case of find in temporary output
-  //! files.
+  //! files. Commands supporting streaming return right after being launched
+  //! and their output is handed to the client through a bounded pipe while
+  //! they are executing.
   //!
   //! @param inpath path indicating user or admin command
   //! @param info CGI describing the proc command
@@ -112,7 +116,9 @@ public:
                    XrdOucErrInfo* error);
 
   //----------------------------------------------------------------------------
-  //! Read a part of the result stream created during open
+  //! Read a part of the result stream created during open. In streaming mode
+  //! this blocks until output is available and the offset is ignored, as the
+  //! result stream can only be consumed sequentially.
   //!
   //! @param boff offset where to start
   //! @param buff buffer to store stream
@@ -123,7 +129,8 @@ public:
   virtual size_t read(XrdSfsFileOffset offset, char* buff, XrdSfsXferSize blen);
 
   //----------------------------------------------------------------------------
-  //! Get the size of the result stream
+  //! Get the size of the result stream, unknown and reported as 0 in
+  //! streaming mode
   //!
   //! @param buf stat structure to fill
   //!
@@ -143,7 +150,7 @@ public:
       iretcStream.seekg(0, iretcStream.end);
       size += iretcStream.tellg();
       iretcStream.seekg(0, iretcStream.beg);
-    } else {
+    } else if (!mPipe) {
       size = mTmpResp.length();
     }
 
@@ -159,6 +166,10 @@ public:
   //----------------------------------------------------------------------------
   virtual int close()
   {
+    if (mPipe) {
+      mPipe->CloseRead();
+    }
+
     if (ifstdoutStream.is_open()) {
       ifstdoutStream.close();
     }
@@ -190,9 +201,34 @@ public:
   virtual bool KillJob() final;
 
 protected:
+  //! Max number of output bytes buffered in streaming mode
+  static constexpr size_t sStreamPipeSize = 4 * 1024 * 1024;
+
   virtual bool OpenTemporaryOutputFiles();
   virtual bool CloseTemporaryOutputFiles();
 
+  //----------------------------------------------------------------------------
+  //! Start streaming the output of the command to the client. Whatever is
+  //! written to the returned stream is handed to the client right away,
+  //! blocking while the client is not keeping up. The std_out of the reply
+  //! is streamed after it once the command is done.
+  //!
+  //! @return stream to write the output to, nullptr if not in streaming mode
+  //----------------------------------------------------------------------------
+  std::ostream* OpenStreamingOutput();
+
+  //----------------------------------------------------------------------------
+  //! Get stream for the output of commands using the temporary output files,
+  //! which is the output pipe in streaming mode
+  //----------------------------------------------------------------------------
+  std::ostream& StdOutStream();
+
+  //----------------------------------------------------------------------------
+  //! Get stream for the errors of commands using the temporary output files.
+  //! In streaming mode the errors are collected and sent at the end.
+  //----------------------------------------------------------------------------
+  std::ostream& StdErrStream();
+
   //----------------------------------------------------------------------------
   //! Get a file's full path using the fid information stored in the opaque
   //! data.
@@ -271,6 +307,29 @@ protected:
   bool readStdOutStream {false};
   bool readStdErrStream {false};
   bool readRetcStream {false};
+  //! Set by commands able to stream their output
+  bool mStreamable;
+  std::unique_ptr<ProcOutputPipe> mPipe; ///< Output pipe in streaming mode
+  bool mStreamStarted; ///< Output header written to the pipe
+  std::ostringstream mStreamErr; ///< Errors collected in streaming mode
+
+private:
+  //----------------------------------------------------------------------------
+  //! Write the remaining output, the errors and the return code of the
+  //! command to the output pipe and close it
+  //!
+  //! @param reply reply of the command
+  //----------------------------------------------------------------------------
+  void CloseStreamingOutput(const eos::console::ReplyProto& reply);
+
+  //----------------------------------------------------------------------------
+  //! Store the client's command comment in the comments logbook
+  //!
+  //! @param vid client virtual identity
+  //! @param reply reply of the command
+  //----------------------------------------------------------------------------
+  void StoreComment(const eos::common::Mapping::VirtualIdentity& vid,
+                    const eos::console::ReplyProto& reply);
 };
 
 EOSMGMNAMESPACE_END
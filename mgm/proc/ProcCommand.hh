@@ -25,6 +25,12 @@
 #include "IProcCommand.hh"
 #include <iomanip>
 #include <json/json.h>
+#include <memory>
+
+namespace eos
+{
+class ExpansionDecider;
+}
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -59,6 +65,18 @@ public:
   //! @return true if entry should be filtered out, otherwise false
   //----------------------------------------------------------------------------
   virtual bool FilterOutDir(const std::string& path) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Get the decider used to prune whole subtrees while exploring the
+  //! QuarkDB namespace, the entries below a pruned directory are neither
+  //! listed nor passed to the filter
+  //!
+  //! @return decider or nullptr if every directory has to be explored
+  //----------------------------------------------------------------------------
+  virtual std::shared_ptr<eos::ExpansionDecider> GetExpansionDecider()
+  {
+    return nullptr;
+  }
 };
 
 //------------------------------------------------------------------------------
@@ -376,7 +394,8 @@ private:
   //! Get fileinfo for all files/dirs in the subtree and add it to the
   //! archive i.e.  do
   //! "find -d --fileinfo /dir/" for directories or
-  //! "find -f --fileinfo /dir/ for files.
+  //! "find -f --fileinfo /dir/ for files. With the namespace in QuarkDB the
+  //! entries are taken from a parallel exploration of the subtree instead.
   //!
   //! @param arch_dir EOS directory being archived
   //! @param arch_ofs local archive file stream object
@@ -390,6 +409,27 @@ private:
   int ArchiveAddEntries(const std::string& arch_dir, std::fstream& arch_ofs,
                         int& num, bool is_file, IFilter* filter = NULL);
 
+  //----------------------------------------------------------------------------
+  //! Add the file or dir entries of the subtree to the archive exploring the
+  //! QuarkDB namespace with the ParallelNamespaceExplorer. The files are
+  //! written as they are discovered, the dirs sorted by path once the
+  //! exploration is done so that parents come first. The number of threads
+  //! is taken from EOS_MGM_ARCHIVE_THREADS (default 16). The subtrees pruned
+  //! by the expansion decider of the filter are not explored.
+  //!
+  //! @param arch_dir EOS directory being archived
+  //! @param arch_ofs local archive file stream object
+  //! @param num number of entries added
+  //! @param is_file if true add file entries to the archive, otherwise
+  //!                directories
+  //! @param filter filter to be applied to the entries
+  //!
+  //! @return 0 if successful, otherwise errno
+  //----------------------------------------------------------------------------
+  int ArchiveAddEntriesQdb(const std::string& arch_dir,
+                           std::fstream& arch_ofs, int& num, bool is_file,
+                           IFilter* filter);
+
   //----------------------------------------------------------------------------
   //! Make EOS sub-tree immutable by adding the sys.acl=z:i rule to all of the
   //! directories in the sub-tree.
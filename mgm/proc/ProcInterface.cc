@@ -141,6 +141,20 @@ ProcInterface::DropSubmittedCmd(const char* tident)
   }
 }
 
+//------------------------------------------------------------------------------
+// Drop a command object whose client is done with it
+//------------------------------------------------------------------------------
+void
+ProcInterface::DropCmd(std::unique_ptr<IProcCommand>&& pcmd)
+{
+  if (pcmd && !pcmd->KillJob()) {
+    std::lock_guard<std::mutex> lock(mMutexCmds);
+    mCmdToDel.push_back(std::move(pcmd));
+  }
+
+  pcmd.reset();
+}
+
 //----------------------------------------------------------------------------
 // Handle protobuf request
 //----------------------------------------------------------------------------
@@ -304,13 +318,14 @@ ProcInterface::IsProcAccess(const char* path)
 bool
 ProcInterface::IsWriteAccess(const char* path, const char* info)
 {
-  XrdOucString inpath = (path ? path : "");
-  XrdOucString ininfo = (info ? info : "");
-
-  if (!inpath.beginswith("/proc/")) {
+  // Most calls come from regular opens, skip them before copying anything
+  if (!path || strncmp(path, "/proc/", 6)) {
     return false;
   }
 
+  XrdOucString inpath = path;
+  XrdOucString ininfo = (info ? info : "");
+
   XrdOucEnv procEnv(ininfo.c_str());
 
   // Filter protobuf requests
@@ -143,6 +143,15 @@ public:
   //----------------------------------------------------------------------------
   static void DropSubmittedCmd(const char* tident);
 
+  //----------------------------------------------------------------------------
+  //! Drop a command object whose client is done with it. The deletion is
+  //! deferred if the command is still executing e.g. while streaming its
+  //! output.
+  //!
+  //! @param pcmd proc command object
+  //----------------------------------------------------------------------------
+  static void DropCmd(std::unique_ptr<IProcCommand>&& pcmd);
+
   ///! Pool of threads executing asynchronously long-running client commands
   static eos::common::ThreadPool sProcThreads;
 
@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------------
+//! @file ProcOutputPipe.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/proc/ProcOutputPipe.hh"
+#include <algorithm>
+#include <cstring>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ProcOutputPipe::ProcOutputPipe(size_t max_size):
+  mMaxSize(max_size), mOffset(0), mSize(0), mWriteClosed(false),
+  mReadClosed(false), mStreamBuf(*this), mStream(&mStreamBuf)
+{}
+
+//------------------------------------------------------------------------------
+// Write data into the pipe, blocking while the pipe is full
+//------------------------------------------------------------------------------
+bool
+ProcOutputPipe::Write(const char* data, size_t len)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mSpaceCv.wait(lock, [&] {return (mSize < mMaxSize) || mReadClosed;});
+
+  if (mReadClosed || mWriteClosed) {
+    return false;
+  }
+
+  if (len) {
+    mChunks.emplace_back(data, len);
+    mSize += len;
+    mDataCv.notify_one();
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Read data from the pipe, blocking until some data is available
+//------------------------------------------------------------------------------
+size_t
+ProcOutputPipe::Read(char* buff, size_t len)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mDataCv.wait(lock, [&] {return mSize || mWriteClosed || mReadClosed;});
+  size_t cpy_len = 0;
+
+  while ((cpy_len < len) && !mChunks.empty()) {
+    const std::string& chunk = mChunks.front();
+    size_t sz = std::min(len - cpy_len, chunk.size() - mOffset);
+    memcpy(buff + cpy_len, chunk.data() + mOffset, sz);
+    cpy_len += sz;
+    mOffset += sz;
+
+    if (mOffset == chunk.size()) {
+      mChunks.pop_front();
+      mOffset = 0;
+    }
+  }
+
+  mSize -= cpy_len;
+
+  if (cpy_len) {
+    mSpaceCv.notify_one();
+  }
+
+  return cpy_len;
+}
+
+//------------------------------------------------------------------------------
+// Close the producer end of the pipe
+//------------------------------------------------------------------------------
+void
+ProcOutputPipe::CloseWrite()
+{
+  mStream.flush();
+  std::unique_lock<std::mutex> lock(mMutex);
+  mWriteClosed = true;
+  mDataCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Close the consumer end of the pipe
+//------------------------------------------------------------------------------
+void
+ProcOutputPipe::CloseRead()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mReadClosed = true;
+  mChunks.clear();
+  mOffset = 0;
+  mSize = 0;
+  mSpaceCv.notify_all();
+  mDataCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Get number of bytes buffered in the pipe
+//------------------------------------------------------------------------------
+size_t
+ProcOutputPipe::GetSize()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mSize;
+}
+
+//------------------------------------------------------------------------------
+// Stream buffer constructor
+//------------------------------------------------------------------------------
+ProcOutputPipe::StreamBuf::StreamBuf(ProcOutputPipe& pipe):
+  mPipe(pipe)
+{
+  mBuffer.resize(sBufferSize);
+  setp(&mBuffer[0], &mBuffer[0] + mBuffer.size());
+}
+
+//------------------------------------------------------------------------------
+// Push the buffered data into the pipe and store the pending character
+//------------------------------------------------------------------------------
+ProcOutputPipe::StreamBuf::int_type
+ProcOutputPipe::StreamBuf::overflow(int_type ch)
+{
+  if (sync()) {
+    return traits_type::eof();
+  }
+
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+
+  return traits_type::not_eof(ch);
+}
+
+//------------------------------------------------------------------------------
+// Push the buffered data into the pipe
+//------------------------------------------------------------------------------
+int
+ProcOutputPipe::StreamBuf::sync()
+{
+  size_t len = pptr() - pbase();
+  setp(&mBuffer[0], &mBuffer[0] + mBuffer.size());
+
+  if (len && !mPipe.Write(pbase(), len)) {
+    return -1;
+  }
+
+  return 0;
+}
+
+EOSMGMNAMESPACE_END
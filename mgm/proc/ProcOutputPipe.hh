@@ -0,0 +1,139 @@
+//------------------------------------------------------------------------------
+//! @file ProcOutputPipe.hh
+//! @brief Bounded pipe streaming the output of a proc command to the client
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! @brief Class ProcOutputPipe - bounded byte pipe between the thread
+//! executing a proc command and the client reading its output
+//!
+//! The producer blocks while the pipe holds more than the maximum size so
+//! that a slow client throttles the command instead of having the MGM buffer
+//! the whole output. The consumer blocks until data is available or the
+//! producer closed its end. Once the consumer closed its end all the writes
+//! fail, which makes the output stream go bad, so that the producer can
+//! bail out.
+//------------------------------------------------------------------------------
+class ProcOutputPipe
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param max_size max number of bytes buffered before the producer blocks
+  //----------------------------------------------------------------------------
+  ProcOutputPipe(size_t max_size);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~ProcOutputPipe() = default;
+
+  //----------------------------------------------------------------------------
+  //! Write data into the pipe, blocking while the pipe is full
+  //!
+  //! @param data data to write
+  //! @param len length of the data
+  //!
+  //! @return true if successful, false if the consumer closed its end
+  //----------------------------------------------------------------------------
+  bool Write(const char* data, size_t len);
+
+  //----------------------------------------------------------------------------
+  //! Read data from the pipe, blocking until some data is available
+  //!
+  //! @param buff buffer to fill
+  //! @param len size of the buffer
+  //!
+  //! @return number of bytes read, 0 once the producer closed its end and
+  //!         all the data was consumed
+  //----------------------------------------------------------------------------
+  size_t Read(char* buff, size_t len);
+
+  //----------------------------------------------------------------------------
+  //! Close the producer end of the pipe, flushing the output stream
+  //----------------------------------------------------------------------------
+  void CloseWrite();
+
+  //----------------------------------------------------------------------------
+  //! Close the consumer end of the pipe, dropping the buffered data and
+  //! unblocking the producer
+  //----------------------------------------------------------------------------
+  void CloseRead();
+
+  //----------------------------------------------------------------------------
+  //! Get output stream writing into the pipe. Only to be used by the
+  //! producer.
+  //----------------------------------------------------------------------------
+  inline std::ostream& GetStream()
+  {
+    return mStream;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of bytes buffered in the pipe
+  //----------------------------------------------------------------------------
+  size_t GetSize();
+
+private:
+  //----------------------------------------------------------------------------
+  //! Stream buffer collecting small writes before pushing them into the pipe
+  //----------------------------------------------------------------------------
+  class StreamBuf: public std::streambuf
+  {
+  public:
+    StreamBuf(ProcOutputPipe& pipe);
+
+  protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+
+  private:
+    static constexpr size_t sBufferSize = 64 * 1024;
+    ProcOutputPipe& mPipe;
+    std::string mBuffer;
+  };
+
+  size_t mMaxSize; ///< Max number of bytes buffered
+  std::mutex mMutex; ///< Mutex protecting the members below
+  std::condition_variable mDataCv; ///< Signaled when data is added or closed
+  std::condition_variable mSpaceCv; ///< Signaled when data is consumed
+  std::deque<std::string> mChunks; ///< Buffered data
+  size_t mOffset; ///< Offset of the unread data in the first chunk
+  size_t mSize; ///< Number of unread bytes
+  bool mWriteClosed; ///< Producer end closed
+  bool mReadClosed; ///< Consumer end closed
+  StreamBuf mStreamBuf;
+  std::ostream mStream;
+};
+
+EOSMGMNAMESPACE_END
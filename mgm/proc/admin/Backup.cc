@@ -29,9 +29,48 @@
 #include <string>
 #include <iomanip>
 #include <fstream>
+#include <cstring>
 
 EOSMGMNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+//                            *** SyncTimePruner ***
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Decide if the container has to be explored
+//------------------------------------------------------------------------------
+bool
+SyncTimePruner::shouldExpandContainer(const eos::ns::ContainerMdProto&
+                                      containerMd,
+                                      const eos::IContainerMD::XAttrMap& linkedAttrs)
+{
+  if (containerMd.xattrs().find("sys.mtime.propagation") ==
+      containerMd.xattrs().end()) {
+    return true;
+  }
+
+  eos::IContainerMD::tmtime_t stime;
+
+  if (containerMd.stime().size() != sizeof(stime)) {
+    return true;
+  }
+
+  (void) memcpy(&stime, containerMd.stime().data(), sizeof(stime));
+
+  if ((stime.tv_sec == 0) && (stime.tv_nsec == 0)) {
+    return true;
+  }
+
+  // A whole second older so that fractions of the reference do not matter
+  if (stime.tv_sec + 1 > mRefTime) {
+    return true;
+  }
+
+  ++mPruned;
+  return false;
+}
+
 //------------------------------------------------------------------------------
 //                            *** TwindowFilter ***
 //------------------------------------------------------------------------------
@@ -112,6 +151,35 @@ TwindowFilter::FilterOutDir(const std::string& path)
   return true;
 }
 
+//----------------------------------------------------------------------------
+// Get the decider pruning the unchanged subtrees
+//----------------------------------------------------------------------------
+std::shared_ptr<eos::ExpansionDecider>
+TwindowFilter::GetExpansionDecider()
+{
+  static bool enabled = []() {
+    const char* ptr = getenv("EOS_MGM_BACKUP_STIME_PRUNE");
+    return !(ptr && (strcmp(ptr, "0") == 0));
+  }();
+
+  if (!enabled || (mTwindowType != "mtime") || mTwindowVal.empty()) {
+    return nullptr;
+  }
+
+  if (!mPruner) {
+    char* end;
+    long long ref_time = strtoll(mTwindowVal.c_str(), &end, 10);
+
+    if ((ref_time <= 0) || (end == mTwindowVal.c_str())) {
+      return nullptr;
+    }
+
+    mPruner = std::make_shared<SyncTimePruner>((time_t) ref_time);
+  }
+
+  return mPruner;
+}
+
 //------------------------------------------------------------------------------
 //                            *** ProcCommand ***
 //------------------------------------------------------------------------------
@@ -293,7 +361,8 @@ ProcCommand::BackupCreate(const std::string& src_surl,
   }
 
   // Create filter
-  std::unique_ptr<IFilter> filter(new TwindowFilter(twindow_type, twindow_val));
+  std::unique_ptr<TwindowFilter> filter(new TwindowFilter(twindow_type,
+                                       twindow_val));
 
   // Add files info
   if (ArchiveAddEntries(src_url.GetPath(), files_ofs, num_files,
@@ -341,6 +410,9 @@ ProcCommand::BackupCreate(const std::string& src_surl,
     return retc;
   }
 
+  eos_info("msg=\"backup discovery done\" dir=%s files=%i dirs=%i "
+           "pruned_subtrees=%llu", src_url.GetPath().c_str(), num_files, num_dirs,
+           (unsigned long long) filter->GetPruned());
   // Create the final backup file, write JSON header, append dir and file info
   std::fstream backup_ofs(backup_fn.c_str(), std::fstream::out);
 
@@ -25,10 +25,56 @@
 #define __EOSMGM_BACKUP_HH__
 
 #include "mgm/proc/ProcCommand.hh"
+#include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
+#include <atomic>
 #include <set>
 
 EOSMGMNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+//! Expansion decider pruning the subtrees not modified since a reference
+//! time. The sync time (stime) of a container with sys.mtime.propagation is
+//! kept by the QuarkSyncTimeAccounting at least as recent as the mtime of
+//! everything below it, so if it is older than the reference time none of
+//! the files of the subtree can be inside an mtime window starting there.
+//!
+//! Containers without sys.mtime.propagation or which never got an stime are
+//! always explored. The stime follows the changes with the delay of the
+//! propagation interval, the time window of consecutive incremental backups
+//! should overlap by at least that much.
+//------------------------------------------------------------------------------
+class SyncTimePruner: public eos::ExpansionDecider
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param ref_time subtrees with an stime older than this are pruned
+  //----------------------------------------------------------------------------
+  explicit SyncTimePruner(time_t ref_time):
+    mRefTime(ref_time), mPruned(0) {}
+
+  //----------------------------------------------------------------------------
+  //! Decide if the container has to be explored, called concurrently by the
+  //! exploring threads
+  //----------------------------------------------------------------------------
+  bool shouldExpandContainer(const eos::ns::ContainerMdProto& containerMd,
+                             const eos::IContainerMD::XAttrMap& linkedAttrs)
+  override;
+
+  //----------------------------------------------------------------------------
+  //! Get number of pruned containers
+  //----------------------------------------------------------------------------
+  uint64_t GetPruned() const
+  {
+    return mPruned;
+  }
+
+private:
+  const time_t mRefTime;
+  std::atomic<uint64_t> mPruned;
+};
+
 //------------------------------------------------------------------------------
 //! Class TwindowFilter to exclude older entries
 //------------------------------------------------------------------------------
@@ -67,10 +113,27 @@ public:
   //----------------------------------------------------------------------------
   bool FilterOutDir(const std::string& path);
 
+  //----------------------------------------------------------------------------
+  //! Get the decider pruning the unchanged subtrees, only for an mtime
+  //! window and unless disabled by EOS_MGM_BACKUP_STIME_PRUNE=0
+  //!
+  //! @return decider or nullptr if every directory has to be explored
+  //----------------------------------------------------------------------------
+  std::shared_ptr<eos::ExpansionDecider> GetExpansionDecider() override;
+
+  //----------------------------------------------------------------------------
+  //! Get number of containers pruned so far
+  //----------------------------------------------------------------------------
+  uint64_t GetPruned() const
+  {
+    return (mPruner ? mPruner->GetPruned() : 0);
+  }
+
 private:
   std::string mTwindowType; ///< Time window type
   std::string mTwindowVal; ///< Time window value
   std::set<std::string> mSetDirs; ///< Set of directories to keep
+  std::shared_ptr<SyncTimePruner> mPruner; ///< Created on first use
 };
 
 EOSMGMNAMESPACE_END
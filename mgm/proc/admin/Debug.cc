@@ -24,13 +24,118 @@
 #include "mgm/proc/ProcInterface.hh"
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/Messaging.hh"
+#include "common/JeMallocHandler.hh"
+#include "common/StringConversion.hh"
 
 EOSMGMNAMESPACE_BEGIN
 
+namespace
+{
+//------------------------------------------------------------------------------
+// Heap profiling and allocator statistics of this MGM
+//------------------------------------------------------------------------------
+int
+DebugHeap(eos::common::JeMallocHandler& jemalloc, const XrdOucString& action,
+          const XrdOucString& arg, XrdOucString& out, XrdOucString& err)
+{
+  if (!jemalloc.JeMallocLoaded()) {
+    err = "error: jemalloc is not loaded, preload libjemalloc to use heap reports";
+    return ENOTSUP;
+  }
+
+  if (action == "stats") {
+    uint64_t allocated = 0, active = 0, resident = 0;
+    std::string report;
+
+    if (jemalloc.GetCounters(allocated, active, resident)) {
+      std::string sizestring;
+      out = "allocated=";
+      out += eos::common::StringConversion::GetReadableSizeString(sizestring,
+             allocated, "B");
+      out += " active=";
+      out += eos::common::StringConversion::GetReadableSizeString(sizestring,
+             active, "B");
+      out += " resident=";
+      out += eos::common::StringConversion::GetReadableSizeString(sizestring,
+             resident, "B");
+      out += "\n";
+    }
+
+    if (jemalloc.GetStats(report, arg == "--arenas")) {
+      out += report.c_str();
+    }
+
+    return 0;
+  }
+
+  if (!jemalloc.CanProfile()) {
+    err = "error: jemalloc heap profiling is not enabled, start the MGM with "
+          "MALLOC_CONF=prof:true";
+    return ENOTSUP;
+  }
+
+  if (action == "start") {
+    if (!jemalloc.StartProfiling()) {
+      err = "error: failed to start heap profiling";
+      return EIO;
+    }
+
+    eos_static_notice("%s", "msg=\"started jemalloc heap profiling\"");
+    out = "success: heap profiling is running";
+    return 0;
+  }
+
+  if (action == "stop") {
+    if (!jemalloc.StopProfiling()) {
+      err = "error: failed to stop heap profiling";
+      return EIO;
+    }
+
+    eos_static_notice("%s", "msg=\"stopped jemalloc heap profiling\"");
+    out = "success: heap profiling is stopped";
+    return 0;
+  }
+
+  if (action == "dump") {
+    if (!jemalloc.ProfRunning()) {
+      err = "error: heap profiling is not running, use 'debug heap start' first";
+      return EINVAL;
+    }
+
+    if (!jemalloc.DumpProfile(arg.c_str())) {
+      err = "error: failed to dump the heap profile";
+      return EIO;
+    }
+
+    eos_static_notice("msg=\"dumped jemalloc heap profile\" file=\"%s\"",
+                      arg.c_str());
+    out = "success: dumped the heap profile";
+
+    if (arg.length()) {
+      out += " to ";
+      out += arg;
+    } else {
+      out += " into the prof_prefix location";
+    }
+
+    return 0;
+  }
+
+  err = "error: unknown heap action, use stats|start|stop|dump";
+  return EINVAL;
+}
+}
+
 int
 ProcCommand::Debug()
 {
   if (pVid->uid == 0) {
+    if (XrdOucString(pOpaque->Get("mgm.subcmd")) == "heap") {
+      retc = DebugHeap(*gOFS->mJeMallocHandler, pOpaque->Get("mgm.heap.action"),
+                       pOpaque->Get("mgm.heap.arg"), stdOut, stdErr);
+      return SFS_OK;
+    }
+
     XrdOucString debugnode = pOpaque->Get("mgm.nodename");
     XrdOucString debuglevel = pOpaque->Get("mgm.debuglevel");
     XrdOucString filterlist = pOpaque->Get("mgm.filter");
@@ -329,7 +329,8 @@ FsCmd::DumpMd(const eos::console::FsProto::DumpMdProto& dumpmdProto)
     XrdOucString ds = dumpmdProto.showsize() ? "1" : "0";
     size_t entries = 0;
     retc = SemaphoreProtectedProcDumpmd(sfsid, option, dp, df, ds, outLocal,
-                                        errLocal, entries);
+                                        errLocal, entries,
+                                        OpenStreamingOutput());
 
     if (!retc) {
       gOFS->MgmStats.Add("DumpMd", mVid.uid, mVid.gid, entries);
@@ -788,7 +789,8 @@ int
 FsCmd::SemaphoreProtectedProcDumpmd(std::string& fsid, XrdOucString& option,
                                     XrdOucString& dp, XrdOucString& df,
                                     XrdOucString& ds, XrdOucString& out,
-                                    XrdOucString& err, size_t& entries)
+                                    XrdOucString& err, size_t& entries,
+                                    std::ostream* sink)
 {
   try {
     mSemaphore.Wait();
@@ -798,7 +800,7 @@ FsCmd::SemaphoreProtectedProcDumpmd(std::string& fsid, XrdOucString& option,
   }
 
   retc = proc_fs_dumpmd(fsid, option, dp, df, ds, out, err,
-                        mVid, entries);
+                        mVid, entries, sink);
 
   try {
     mSemaphore.Post();
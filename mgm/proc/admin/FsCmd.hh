@@ -42,7 +42,12 @@ public:
   //----------------------------------------------------------------------------
   FsCmd(eos::console::RequestProto&& req,
         eos::common::Mapping::VirtualIdentity& vid):
-    IProcCommand(std::move(req), vid, true) {}
+    IProcCommand(std::move(req), vid, true)
+  {
+    // The dumpmd output can be huge, stream it to the client
+    mStreamable = (mReqProto.fs().subcmd_case() ==
+                   eos::console::FsProto::SubcmdCase::kDumpmd);
+  }
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -89,7 +94,8 @@ private:
   int SemaphoreProtectedProcDumpmd(std::string& fsid, XrdOucString& option,
                                    XrdOucString& dp,
                                    XrdOucString& df, XrdOucString& ds, XrdOucString& out,
-                                   XrdOucString& err, size_t& entries);
+                                   XrdOucString& err, size_t& entries,
+                                   std::ostream* sink = nullptr);
 
   template <class T, std::size_t N>
   static constexpr std::size_t SizeOfArray(const T(&array)[N]) noexcept
@@ -24,12 +24,14 @@
 #include "common/LinuxMemConsumption.hh"
 #include "common/LinuxStat.hh"
 #include "common/LinuxFds.hh"
+#include "common/MutexContentionProfiler.hh"
 #include "namespace/interface/IChLogFileMDSvc.hh"
 #include "namespace/interface/IChLogContainerMDSvc.hh"
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IFileMDSvc.hh"
 #include "namespace/interface/IView.hh"
 #include "namespace/interface/ContainerIterators.hh"
+#include "namespace/utils/TreeHash.hh"
 #include "namespace/ns_quarkdb/Constants.hh"
 #include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
@@ -93,7 +95,8 @@ NsCmd::MutexSubcmd(const eos::console::NsProto_MutexProto& mutex,
 
     if (mutex.sample_rate1() || mutex.sample_rate10() ||
         mutex.sample_rate100() || mutex.toggle_timing() ||
-        mutex.toggle_order()) {
+        mutex.toggle_order() || mutex.contention_set() ||
+        mutex.contention_top() || mutex.contention_reset()) {
       no_option = false;
     }
 
@@ -138,9 +141,34 @@ NsCmd::MutexSubcmd(const eos::console::NsProto_MutexProto& mutex,
             << "% of the mutex lock/unlock cycle duration)";
       }
 
+      oss << std::endl
+          << "contention profiling is : ";
+      double crate = eos::common::MutexContentionProfiler::GetSampling();
+
+      if (crate > 0) {
+        oss << "on (sampling rate " << crate << ")";
+      } else {
+        oss << "off";
+      }
+
       oss << std::endl;
     }
 
+    if (mutex.contention_set()) {
+      eos::common::MutexContentionProfiler::SetSampling(mutex.contention_rate());
+      oss << "mutex contention profiling is "
+          << (mutex.contention_rate() > 0 ? "on" : "off") << std::endl;
+    }
+
+    if (mutex.contention_reset()) {
+      eos::common::MutexContentionProfiler::Reset();
+      oss << "mutex contention samples have been reset" << std::endl;
+    }
+
+    if (mutex.contention_top()) {
+      oss << eos::common::MutexContentionProfiler::Dump(mutex.contention_top());
+    }
+
     if (mutex.toggle_timing()) {
       if (fs_mtx->GetTiming()) {
         fs_mtx->SetTiming(false);
@@ -278,6 +306,7 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat)
   }
 
   int64_t latencyf = 0, latencyd = 0, latencyp = 0;
+  uint64_t lagf = 0, lagd = 0;
   auto chlog_file_svc = dynamic_cast<eos::IChLogFileMDSvc*>(gOFS->eosFileService);
   auto chlog_dir_svc = dynamic_cast<eos::IChLogContainerMDSvc*>
                        (gOFS->eosDirectoryService);
@@ -286,6 +315,8 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat)
     latencyf = statf.st_size - chlog_file_svc->getFollowOffset();
     latencyd = statd.st_size - chlog_dir_svc->getFollowOffset();
     latencyp = chlog_file_svc->getFollowPending();
+    lagf = chlog_file_svc->getFollowLag();
+    lagd = chlog_dir_svc->getFollowLag();
   }
 
   std::string master_status = gOFS->mMaster->PrintOut();
@@ -330,6 +361,8 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat)
         << "uid=all gid=all ns.latency.files=" << latencyf << std::endl
         << "uid=all gid=all ns.latency.dirs=" << latencyd << std::endl
         << "uid=all gid=all ns.latency.pending.updates=" << latencyp << std::endl
+        << "uid=all gid=all ns.latency.files.seconds=" << lagf << std::endl
+        << "uid=all gid=all ns.latency.dirs.seconds=" << lagd << std::endl
         << "uid=all gid=all " << master_status.c_str() << std::endl
         << "uid=all gid=all ns.memory.virtual=" << mem.vmsize << std::endl
         << "uid=all gid=all ns.memory.resident=" << mem.resident << std::endl
@@ -383,7 +416,9 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat)
     if (!gOFS->NsInQDB && !gOFS->mMaster->IsMaster()) {
       oss << "ALL      Namespace Latency Files          " << latencyf << std::endl
           << "ALL      Namespace Latency Directories    " << latencyd << std::endl
-          << "ALL      Namespace Pending Updates        " << latencyp << std::endl;
+          << "ALL      Namespace Pending Updates        " << latencyp << std::endl
+          << "ALL      Namespace Lag Files              " << lagf << " s" << std::endl
+          << "ALL      Namespace Lag Directories        " << lagd << " s" << std::endl;
     }
 
     oss << line << std::endl;
@@ -672,7 +707,7 @@ NsCmd::QuotaSizeSubcmd(const eos::console::NsProto_QuotaSizeProto& tree,
     eos::BackendClient::getInstance(gOFS->mQdbContactDetails, "quota-recomputation"));
 
   QuotaNodeCore qnc;
-  eos::MDStatus status = recomputer.recompute(cont, qnc);
+  eos::MDStatus status = recomputer.recompute(cont, qnc, tree.incremental());
 
   if(!status.ok()) {
     reply.set_std_err(status.getError());
@@ -697,7 +732,8 @@ NsCmd::QuotaSizeSubcmd(const eos::console::NsProto_QuotaSizeProto& tree,
 //------------------------------------------------------------------------------
 // Recompute and update tree size of the given container assumming its
 // subcontainers tree size values are correct and adding the size of files
-// attached directly to the current container
+// attached directly to the current container, the tree hash is recomputed the
+// same way if enabled
 //------------------------------------------------------------------------------
 void
 NsCmd::UpdateTreeSize(eos::IContainerMDPtr cont) const
@@ -706,6 +742,7 @@ NsCmd::UpdateTreeSize(eos::IContainerMDPtr cont) const
   std::shared_ptr<eos::IFileMD> tmp_fmd {nullptr};
   std::shared_ptr<eos::IContainerMD> tmp_cont {nullptr};
   uint64_t tree_size = 0u;
+  uint64_t tree_hash = 0u;
 
   for (auto fit = FileMapIterator(cont); fit.valid(); fit.next()) {
     try {
@@ -716,6 +753,7 @@ NsCmd::UpdateTreeSize(eos::IContainerMDPtr cont) const
     }
 
     tree_size += tmp_fmd->getSize();
+    tree_hash += eos::TreeHash::FileEntry(tmp_fmd.get());
   }
 
   for (auto cit = ContainerMapIterator(cont); cit.valid(); cit.next()) {
@@ -727,9 +765,15 @@ NsCmd::UpdateTreeSize(eos::IContainerMDPtr cont) const
     }
 
     tree_size += tmp_cont->getTreeSize();
+    tree_hash += eos::TreeHash::ContainerEntry(cit.key(),
+                 tmp_cont->getTreeHash());
   }
 
   cont->setTreeSize(tree_size);
+
+  if (eos::TreeHash::IsEnabled()) {
+    cont->setTreeHash(tree_hash);
+  }
   gOFS->eosDirectoryService->updateStore(cont.get());
   gOFS->FuseXCastContainer(cont->getIdentifier());
 }
@@ -484,17 +484,33 @@ ProcCommand::Space()
                 (key == "converter") ||
                 (key == "lru") ||
                 (key == "lru.interval") ||
+                (key == "hotreplica") ||
+                (key == "hotreplica.rate") ||
+                (key == "hotreplica.opens") ||
+                (key == "hotreplica.max") ||
+                (key == "hotreplica.cooldown") ||
                 (key == "wfe") ||
                 (key == "wfe.interval") ||
                 (key == "wfe.ntx") ||
+                (key == "wfe.ntx.workflow") ||
                 (key == "converter.ntx") ||
+                (key == "converter.group.ntx") ||
                 (key == "autorepair") ||
                 (key == "groupbalancer") ||
                 (key == "groupbalancer.ntx") ||
                 (key == "groupbalancer.threshold") ||
+                (key == "groupbalancer.file.minsize") ||
                 (key == "geobalancer") ||
                 (key == "geobalancer.ntx") ||
                 (key == "geobalancer.threshold") ||
+                (key == "geobalancer.file.minsize") ||
+                (key == "planner") ||
+                (key == "planner.scope") ||
+                (key == "planner.tolerance") ||
+                (key == "planner.interval") ||
+                (key == "planner.node.bw") ||
+                (key == "planner.ntx") ||
+                (key == "planner.file.minsize") ||
                 (key == "geo.access.policy.read.exact") ||
                 (key == "geo.access.policy.write.exact") ||
                 (key == "filearchivedgc") ||
@@ -502,6 +518,7 @@ ProcCommand::Space()
                 (key == "balancer.threshold")) {
               if ((key == "balancer") || (key == "converter") ||
                   (key == "autorepair") || (key == "lru") ||
+                  (key == "hotreplica") ||
                   (key == "groupbalancer") || (key == "geobalancer") ||
                   (key == "geo.access.policy.read.exact") ||
                   (key == "geo.access.policy.write.exact") ||
@@ -531,6 +548,14 @@ ProcCommand::Space()
                       }
                     }
 
+                    if (key == "hotreplica") {
+                      if (value == "on") {
+                        stdOut += "success: hot file replicator is enabled!";
+                      } else {
+                        stdOut += "success: hot file replicator is disabled!";
+                      }
+                    }
+
                     if (key == "autorepair") {
                       if (value == "on") {
                         stdOut += "success: auto-repair is enabled!";
@@ -588,6 +613,34 @@ ProcCommand::Space()
                     }
                   }
                 }
+              } else if (key == "planner") {
+                if ((value != "on") && (value != "off") && (value != "dryrun")) {
+                  retc = EINVAL;
+                  stdErr = "error: value has to either on, dryrun or off";
+                } else {
+                  if (!FsView::gFsView.mSpaceView[identifier]->SetConfigMember(key, value, true,
+                      "/eos/*/mgm")) {
+                    retc = EIO;
+                    stdErr = "error: cannot set space config value";
+                  } else if (value == "on") {
+                    stdOut += "success: balance planner is enabled!";
+                  } else if (value == "dryrun") {
+                    stdOut += "success: balance planner is in dry-run mode!";
+                  } else {
+                    stdOut += "success: balance planner is disabled!";
+                  }
+                }
+              } else if (key == "planner.scope") {
+                if ((value != "group") && (value != "geotag")) {
+                  retc = EINVAL;
+                  stdErr = "error: value has to either group or geotag";
+                } else {
+                  if (!FsView::gFsView.mSpaceView[identifier]->SetConfigMember(key, value, true,
+                      "/eos/*/mgm")) {
+                    retc = EIO;
+                    stdErr = "error: cannot set space config value";
+                  }
+                }
               } else if (key == "wfe") {
                 if ((value != "on") && (value != "off") && (value != "paused")) {
                   retc = EINVAL;
@@ -607,7 +660,8 @@ ProcCommand::Space()
                 if (!errno) {
                   if ((key != "balancer.threshold") &&
                       (key != "groupbalancer.threshold") &&
-                      (key != "geobalancer.threshold")) {
+                      (key != "geobalancer.threshold") &&
+                      (key != "planner.tolerance")) {
                     // the threshold is allowed to be decimal!
                     char ssize[1024];
                     snprintf(ssize, sizeof(ssize) - 1, "%llu", size);
@@ -121,7 +121,8 @@ int
 proc_fs_dumpmd(std::string& sfsid, XrdOucString& option, XrdOucString& dp,
                XrdOucString& df, XrdOucString& ds, XrdOucString& stdOut,
                XrdOucString& stdErr,
-               eos::common::Mapping::VirtualIdentity& vid_in, size_t& entries)
+               eos::common::Mapping::VirtualIdentity& vid_in, size_t& entries,
+               std::ostream* sink)
 {
   entries = 0;
   int retc = 0;
@@ -151,99 +152,136 @@ proc_fs_dumpmd(std::string& sfsid, XrdOucString& option, XrdOucString& dp,
     retc = EINVAL;
   } else {
     int fsid = atoi(sfsid.c_str());
-    eos::Prefetcher::prefetchFilesystemFileListWithFileMDsAndParentsAndWait(
-      gOFS->eosView, gOFS->eosFsView, fsid);
+    const bool in_memory = gOFS->eosView->inMemory();
+    std::vector<eos::IFileMD::id_t> fids;
+    eos::common::RWMutexReadLock ns_rd_lock;
 
-    if (monitor) {
-      eos::Prefetcher::prefetchFilesystemUnlinkedFileListWithFileMDsAndWait(
-        gOFS->eosView, gOFS->eosFsView, fsid);
+    // The in-memory file list is only valid under the namespace lock
+    if (in_memory) {
+      ns_rd_lock.Grab(gOFS->eosViewRWMutex);
     }
 
-    eos::common::RWMutexReadLock ns_rd_lock;
-    ns_rd_lock.Grab(gOFS->eosViewRWMutex);
+    // Go through the file list page by page, prefetching the metadata of
+    // each page without holding the namespace lock
+    auto it_fids = gOFS->eosFsView->getPagedFileList(fsid, "0",
+                  eos::IFsView::kFileListPageSize);
 
-    for (auto it_fid = gOFS->eosFsView->getFileList(fsid);
-         (it_fid && it_fid->valid()); it_fid->next()) {
-      std::shared_ptr<eos::IFileMD> fmd;
+    while (it_fids && it_fids->valid()) {
+      fids.clear();
+      std::string page = it_fids->getCursor();
 
-      try {
-        fmd = gOFS->eosFileService->getFileMD(it_fid->getElement());
+      for (; it_fids->valid() && (it_fids->getCursor() == page); it_fids->next()) {
+        fids.push_back(it_fids->getElement());
+      }
 
-        if (fmd) {
-          entries++;
+      if (!in_memory) {
+        eos::Prefetcher::prefetchFileMDsWithParentsAndWait(gOFS->eosView, fids);
+        ns_rd_lock.Grab(gOFS->eosViewRWMutex);
+      }
 
-          if ((!dumppath) && (!dumpfid) && (!dumpsize)) {
-            std::string env;
-            fmd->getEnv(env, true);
-            XrdOucString senv = env.c_str();
+      for (const auto fid : fids) {
+        std::shared_ptr<eos::IFileMD> fmd;
 
-            if (senv.endswith("checksum=")) {
-              senv.replace("checksum=", "checksum=none");
-            }
+        try {
+          fmd = gOFS->eosFileService->getFileMD(fid);
 
-            stdOut += senv.c_str();
+          if (fmd) {
+            entries++;
 
-            if (monitor) {
-              std::string fullpath = gOFS->eosView->getUri(fmd.get());
-              eos::common::Path cPath(fullpath.c_str());
-              stdOut += "&container=";
-              XrdOucString safepath = cPath.GetParentPath();
+            if ((!dumppath) && (!dumpfid) && (!dumpsize)) {
+              std::string env;
+              fmd->getEnv(env, true);
+              XrdOucString senv = env.c_str();
 
-              while (safepath.replace("&", "#AND#")) {}
+              if (senv.endswith("checksum=")) {
+                senv.replace("checksum=", "checksum=none");
+              }
 
-              stdOut += safepath;
-            }
+              stdOut += senv.c_str();
 
-            stdOut += "\n";
-          } else {
-            if (dumppath) {
-              std::string fullpath = gOFS->eosView->getUri(fmd.get());
-              XrdOucString safepath = fullpath.c_str();
+              if (monitor) {
+                std::string fullpath = gOFS->eosView->getUri(fmd.get());
+                eos::common::Path cPath(fullpath.c_str());
+                stdOut += "&container=";
+                XrdOucString safepath = cPath.GetParentPath();
 
-              while (safepath.replace("&", "#AND#")) {}
+                while (safepath.replace("&", "#AND#")) {}
 
-              stdOut += "path=";
-              stdOut += safepath.c_str();
-            }
+                stdOut += safepath;
+              }
 
-            if (dumpfid) {
+              stdOut += "\n";
+            } else {
               if (dumppath) {
-                stdOut += " ";
+                std::string fullpath = gOFS->eosView->getUri(fmd.get());
+                XrdOucString safepath = fullpath.c_str();
+
+                while (safepath.replace("&", "#AND#")) {}
+
+                stdOut += "path=";
+                stdOut += safepath.c_str();
               }
 
-              char sfid[40];
-              snprintf(sfid, 40, "fid=%llu", (unsigned long long) fmd->getId());
-              stdOut += sfid;
-            }
+              if (dumpfid) {
+                if (dumppath) {
+                  stdOut += " ";
+                }
 
-            if (dumpsize) {
-              if (dumppath || dumpfid) {
-                stdOut += " ";
+                char sfid[40];
+                snprintf(sfid, 40, "fid=%llu", (unsigned long long) fmd->getId());
+                stdOut += sfid;
               }
 
-              char ssize[40];
-              snprintf(ssize, 40, "size=%llu", (unsigned long long) fmd->getSize());
-              stdOut += ssize;
-            }
+              if (dumpsize) {
+                if (dumppath || dumpfid) {
+                  stdOut += " ";
+                }
 
-            stdOut += "\n";
+                char ssize[40];
+                snprintf(ssize, 40, "size=%llu", (unsigned long long) fmd->getSize());
+                stdOut += ssize;
+              }
+
+              stdOut += "\n";
+            }
           }
+        } catch (eos::MDException& e) {
+          errno = e.getErrno();
+          eos_static_err("Couldn't retrieve meta data for file id: %u. Error "
+                         "code: %d, message: %s", fid,
+                         e.getErrno(), e.getMessage().str().c_str());
+        }
+
+        if (!fmd) {
+          char sfid[1024];
+          snprintf(sfid, 1024, "# warning: ghost entry fid=%llu\n",
+                   (unsigned long long) fid);
+          stdOut += sfid;
         }
-      } catch (eos::MDException& e) {
-        errno = e.getErrno();
-        eos_static_err("Couldn't retrieve meta data for file id: %u. Error "
-                       "code: %d, message: %s", it_fid->getElement(),
-                       e.getErrno(), e.getMessage().str().c_str());
       }
 
-      if (!fmd) {
-        char sfid[1024];
-        snprintf(sfid, 1024, "# warning: ghost entry fid=%llu\n",
-                 (unsigned long long) it_fid->getElement());
-        stdOut += sfid;
+      if (!in_memory) {
+        ns_rd_lock.Release();
+
+        // Hand over the page, this blocks while the client is not keeping up
+        if (sink && stdOut.length()) {
+          *sink << stdOut.c_str();
+          stdOut = "";
+
+          if (!*sink) {
+            stdErr = "error: output stream closed";
+            return ECANCELED;
+          }
+        }
       }
     }
 
+    if (monitor && !in_memory) {
+      eos::Prefetcher::prefetchFilesystemUnlinkedFileListWithFileMDsAndWait(
+        gOFS->eosView, gOFS->eosFsView, fsid);
+      ns_rd_lock.Grab(gOFS->eosViewRWMutex);
+    }
+
     if (monitor) {
       // Also add files which have yet to be unlinked
       for (auto it_fid = gOFS->eosFsView->getUnlinkedFileList(fsid);
@@ -347,11 +385,15 @@ proc_fs_config(std::string& identifier, std::string& key, std::string& value,
       if (((key == "configstatus") &&
            (eos::common::FileSystem::GetConfigStatusFromString(value.c_str()) !=
             eos::common::FileSystem::kUnknown)) ||
+          ((key == "fmdcommit") && ((value == "direct") || (value == "batch") ||
+                                    (value == "batchsync"))) ||
+          ((key == "fmdstore") && ((value == "leveldb") || (value == "slot"))) ||
           (((key == "headroom") || (key == "scaninterval") ||
             (key == "scanrate") || (key == "graceperiod") ||
             (key == "drainperiod") || (key == "proxygroup") ||
             (key == "filestickyproxydepth") || (key == "forcegeotag") ||
-            (key == "s3credentials")))) {
+            (key == "s3credentials") || (key == "iobw.scrub") ||
+            (key == "iobw.balance") || (key == "iobw.drain")))) {
         // Check permissions
         size_t dpos = 0;
         std::string nodename = fs->GetString("host");
@@ -388,7 +430,8 @@ proc_fs_config(std::string& identifier, std::string& key, std::string& value,
 
         if ((key == "headroom") || (key == "scaninterval") ||
             (key == "scanrate") || (key == "graceperiod") ||
-            (key == "drainperiod")) {
+            (key == "drainperiod") || (key == "iobw.scrub") ||
+            (key == "iobw.balance") || (key == "iobw.drain")) {
           fs->SetLongLong(key.c_str(),
                           eos::common::StringConversion::GetSizeFromString(value.c_str()));
           FsView::gFsView.StoreFsConfig(fs);
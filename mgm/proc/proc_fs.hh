@@ -30,6 +30,7 @@
 #include "mgm/FileSystem.hh"
 #include "mgm/FsView.hh"
 #include "XrdSec/XrdSecEntity.hh"
+#include <ostream>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -62,13 +63,15 @@ enum class MvOpType {
 //! @param stdErr error output string
 //! @param vid_in virtual identity of the client
 //! @param entries counts the number of entries
+//! @param sink if given, the output of every page of the file list is moved
+//!        from stdOut to this stream once the namespace lock is released
 //!
 //! @return 0 if successful, otherwise error code value
 //------------------------------------------------------------------------------
 int proc_fs_dumpmd(std::string& sfsid, XrdOucString& option, XrdOucString& dp,
                    XrdOucString& df, XrdOucString& ds, XrdOucString& stdOut,
                    XrdOucString& stdErr, eos::common::Mapping::VirtualIdentity& vid_in,
-                   size_t& entries);
+                   size_t& entries, std::ostream* sink = nullptr);
 
 //------------------------------------------------------------------------------
 //! Set filesystem configuration parameter
@@ -33,8 +33,11 @@ EOSMGMNAMESPACE_BEGIN
 int
 ProcCommand::Accounting()
 {
+  // the report is generated in the background, a client waits for the first
+  // one at most 30 seconds
   static eos::common::ExpiryCache<std::string> accountingCache(
-    std::chrono::seconds(600));
+    std::chrono::seconds(600), std::chrono::seconds::max(),
+    std::chrono::seconds(30));
   static const auto generateAccountingJson = [this](
   eos::common::Mapping::VirtualIdentity & vid) {
     static const auto processAccountingAttribute = [](
@@ -188,8 +191,9 @@ ProcCommand::Accounting()
     bool forceUpdate = options.find('f') != std::string::npos;
 
     try {
+      // the identity is copied, the update can outlive this request
       auto json = accountingCache.getCachedObject(forceUpdate, generateAccountingJson,
-                  std::ref(*pVid));
+                  *pVid);
       stdOut += json.c_str();
     } catch (eos::common::UpdateException& err) {
       stdErr += err.what();
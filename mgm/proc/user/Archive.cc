@@ -29,11 +29,19 @@
 #include "mgm/Acl.hh"
 #include "common/SymKeys.hh"
 #include "common/Path.hh"
+#include "common/LayoutId.hh"
+#include "common/StringConversion.hh"
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IView.hh"
+#include "namespace/utils/Checksum.hh"
+#include "namespace/ns_quarkdb/BackendClient.hh"
+#include "namespace/ns_quarkdb/ContainerMD.hh"
+#include "namespace/ns_quarkdb/FileMD.hh"
+#include "namespace/ns_quarkdb/explorer/ParallelNamespaceExplorer.hh"
 #include "mgm/ZMQ.hh"
 #include "XrdCl/XrdClCopyProcess.hh"
 #include "XrdOuc/XrdOucEnv.hh"
+#include <algorithm>
 #include <iomanip>
 
 EOSMGMNAMESPACE_BEGIN
@@ -312,10 +320,18 @@ ProcCommand::Archive()
         }
       }
 
+      // Number of parallel copy jobs requested for this transfer
+      int threads = (pOpaque->Get("mgm.archive.threads") ?
+                     atoi(pOpaque->Get("mgm.archive.threads")) : 0);
       cmd_json << "{\"cmd\": " << "\"" << mSubCmd.c_str() << "\", "
                << "\"src\": " << "\"" << arch_url << "\", "
-               << "\"opt\": " << "\"" << option  << "\", "
-               << "\"uid\": " << "\"" << pVid->uid << "\", "
+               << "\"opt\": " << "\"" << option  << "\", ";
+
+      if ((threads > 0) && ((mSubCmd == "put") || (mSubCmd == "get"))) {
+        cmd_json << "\"threads\": " << "\"" << threads << "\", ";
+      }
+
+      cmd_json << "\"uid\": " << "\"" << pVid->uid << "\", "
                << "\"gid\": " << "\"" << pVid->gid << "\" "
                << "}";
     } else {
@@ -1076,6 +1092,49 @@ ProcCommand::MakeSubTreeMutable(const std::string& arch_dir)
 }
 
 
+//------------------------------------------------------------------------------
+// Write one file or directory entry to the archive, the keys of the info map
+// match the ones in the header dictionary
+//------------------------------------------------------------------------------
+static void
+WriteArchiveEntry(std::fstream& ofs,
+                  std::map<std::string, std::string>& info_map,
+                  const std::map<std::string, std::string>& attr_map,
+                  bool is_file)
+{
+  // TODO(esindril): The file path should be base64 encoded to avoid any surprises
+  if (is_file) {
+    ofs << "[\"f\", \"" << info_map["file"] << "\", "
+        << "\"" << info_map["size"] << "\", "
+        << "\"" << info_map["mtime"] << "\", "
+        << "\"" << info_map["ctime"] << "\", "
+        << "\"" << info_map["uid"] << "\", "
+        << "\"" << info_map["gid"] << "\", "
+        << "\"" << info_map["mode"] << "\", "
+        << "\"" << info_map["xstype"] << "\", "
+        << "\"" << info_map["xs"] << "\"]"
+        << std::endl;
+    return;
+  }
+
+  ofs << "[\"d\", \"" << info_map["file"] << "\", "
+      << "\"" << info_map["uid"] << "\", "
+      << "\"" << info_map["gid"] << "\", "
+      << "\"" << info_map["mode"] << "\", "
+      << "{";
+
+  for (auto it = attr_map.begin(); it != attr_map.end(); /*empty*/) {
+    ofs << "\"" << it->first << "\": \"" << it->second << "\"";
+    ++it;
+
+    if (it != attr_map.end()) {
+      ofs << ", ";
+    }
+  }
+
+  ofs << "}]" << std::endl;
+}
+
 //------------------------------------------------------------------------------
 // Get fileinfo for all files/dirs in the subtree and add it to the archive
 //------------------------------------------------------------------------------
@@ -1084,6 +1143,10 @@ ProcCommand::ArchiveAddEntries(const std::string& arch_dir,
                                std::fstream& ofs, int& num, bool is_file,
                                IFilter* filter)
 {
+  if (gOFS->NsInQDB) {
+    return ArchiveAddEntriesQdb(arch_dir, ofs, num, is_file, filter);
+  }
+
   num = 0;
   std::map<std::string, std::string> info_map;
   std::map<std::string, std::string> attr_map; // only for dirs
@@ -1230,54 +1293,158 @@ ProcCommand::ArchiveAddEntries(const std::string& arch_dir,
     }
 
     info_map["file"] = rel_path;
-    // TODO(esindril): The file path should be base64 encoded to avoid any surprises
 
-    if (is_file) {
-      // Filter out file entries if necessary
-      if (filter && filter->FilterOutFile(info_map)) {
+    // Filter out entries if necessary
+    if (filter && (is_file ? filter->FilterOutFile(info_map) :
+                   filter->FilterOutDir(info_map["file"]))) {
+      attr_map.clear();
+      continue;
+    }
+
+    WriteArchiveEntry(ofs, info_map, attr_map, is_file);
+    attr_map.clear();
+    num++;
+  }
+
+  delete[] tmp_buff;
+  delete cmd_find;
+  return retc;
+}
+
+//------------------------------------------------------------------------------
+// Explore the subtree from QuarkDB in parallel and add the file or dir
+// entries to the archive as they are discovered
+//------------------------------------------------------------------------------
+int
+ProcCommand::ArchiveAddEntriesQdb(const std::string& arch_dir,
+                                  std::fstream& ofs, int& num, bool is_file,
+                                  IFilter* filter)
+{
+  using eos::common::LayoutId;
+  using eos::common::StringConversion;
+  static size_t sThreads = []() {
+    const char* ptr = getenv("EOS_MGM_ARCHIVE_THREADS");
+    long long val = (ptr ? strtoll(ptr, nullptr, 10) : 0);
+    return (val > 0 ? (size_t) val : 16);
+  }();
+  num = 0;
+  ParallelExplorationOptions options;
+  options.view = gOFS->eosView;
+  options.threads = sThreads;
+
+  if (!is_file) {
+    // Only the containers are needed, the exploring threads drop the files
+    options.fileFilter = std::make_shared<eos::FileFilter>();
+    options.fileFilter->minSize = 1;
+    options.fileFilter->maxSize = 0;
+  }
+
+  if (filter) {
+    // Containers are only listed once the decider kept them, a pruned
+    // subtree then costs a single metadata fetch
+    options.expansionDecider = filter->GetExpansionDecider();
+    options.listAfterDecision = (options.expansionDecider != nullptr);
+  }
+
+  std::unique_ptr<ParallelNamespaceExplorer> explorer;
+
+  try {
+    explorer.reset(new ParallelNamespaceExplorer(arch_dir, options,
+                   *eos::BackendClient::getInstance(gOFS->mQdbContactDetails,
+                       "archive")));
+  } catch (const eos::MDException& e) {
+    eos_err("msg=\"failed to explore\" dir=%s emsg=\"%s\"",
+            arch_dir.c_str(), e.what());
+    stdErr = "error: failed to list archive directory";
+    retc = e.getErrno();
+    return retc;
+  }
+
+  std::map<std::string, std::string> info_map;
+  std::map<std::string, std::string> attr_map;
+  // The items come in no particular order but the directories must be
+  // written parents first, as the find output they are sorted by path
+  std::map<std::string, std::unique_ptr<eos::QuarkContainerMD>> dirs;
+  std::vector<NamespaceItem> chunk;
+
+  while (explorer->fetch(chunk)) {
+    for (auto& item : chunk) {
+      if (item.isFile != is_file) {
         continue;
       }
 
-      ofs << "[\"f\", \"" << info_map["file"] << "\", "
-          << "\"" << info_map["size"] << "\", "
-          << "\"" << info_map["mtime"] << "\", "
-          << "\"" << info_map["ctime"] << "\", "
-          << "\"" << info_map["uid"] << "\", "
-          << "\"" << info_map["gid"] << "\", "
-          << "\"" << info_map["mode"] << "\", "
-          << "\"" << info_map["xstype"] << "\", "
-          << "\"" << info_map["xs"] << "\"]"
-          << std::endl;
-    } else {
-      // Filter out directory entries if necessary
-      if (filter && filter->FilterOutDir(info_map["file"])) {
+      if (!is_file) {
+        std::unique_ptr<eos::QuarkContainerMD> cmd(new eos::QuarkContainerMD());
+        cmd->initializeWithoutChildren(std::move(item.containerMd));
+        dirs[item.fullPath] = std::move(cmd);
         continue;
       }
 
-      ofs << "[\"d\", \"" << info_map["file"] << "\", "
-          << "\"" << info_map["uid"] << "\", "
-          << "\"" << info_map["gid"] << "\", "
-          << "\"" << info_map["mode"] << "\", "
-          << "{";
+      // Files are streamed to the archive, same values as fileinfo -m
+      eos::QuarkFileMD fmd;
+      fmd.initialize(std::move(item.fileMd));
+      eos::IFileMD::ctime_t mtime;
+      eos::IFileMD::ctime_t ctime;
+      fmd.getMTime(mtime);
+      fmd.getCTime(ctime);
+      std::string xs;
+
+      if (LayoutId::GetChecksumLen(fmd.getLayoutId())) {
+        eos::appendChecksumOnStringAsHex(&fmd, xs);
+      } else {
+        xs = "0";
+      }
 
-      for (auto it = attr_map.begin(); it != attr_map.end(); /*empty*/) {
-        ofs << "\"" << it->first << "\": \"" << it->second << "\"";
-        ++it;
+      info_map["file"] = item.fullPath.substr(arch_dir.length());
+      info_map["size"] = std::to_string(fmd.getSize());
+      info_map["mtime"] = std::to_string(mtime.tv_sec) + "." +
+                          std::to_string(mtime.tv_nsec);
+      info_map["ctime"] = std::to_string(ctime.tv_sec) + "." +
+                          std::to_string(ctime.tv_nsec);
+      info_map["uid"] = std::to_string(fmd.getCUid());
+      info_map["gid"] = std::to_string(fmd.getCGid());
+      info_map["mode"] = StringConversion::IntToOctal((int) fmd.getFlags(), 4);
+      info_map["xstype"] = LayoutId::GetChecksumString(fmd.getLayoutId());
+      info_map["xs"] = xs;
 
-        if (it != attr_map.end()) {
-          ofs << ", ";
-        }
+      if (filter && filter->FilterOutFile(info_map)) {
+        continue;
       }
 
-      ofs << "}]" << std::endl;
-      attr_map.clear();
+      WriteArchiveEntry(ofs, info_map, attr_map, true);
+      num++;
+    }
+  }
+
+  for (const auto& elem : dirs) {
+    std::string rel_path = elem.first.substr(std::min(arch_dir.length(),
+                           elem.first.length()));
+
+    if (rel_path.empty()) {
+      rel_path = "./";
     }
 
+    if (filter && filter->FilterOutDir(rel_path)) {
+      continue;
+    }
+
+    info_map["file"] = rel_path;
+    info_map["uid"] = std::to_string(elem.second->getCUid());
+    info_map["gid"] = std::to_string(elem.second->getCGid());
+    info_map["mode"] = StringConversion::IntToOctal((int)
+                       elem.second->getMode(), 4);
+    eos::IContainerMD::XAttrMap xattrs = elem.second->getAttributes();
+    attr_map.clear();
+    attr_map.insert(xattrs.begin(), xattrs.end());
+    WriteArchiveEntry(ofs, info_map, attr_map, false);
     num++;
   }
 
-  delete[] tmp_buff;
-  delete cmd_find;
+  if (explorer->getErrors()) {
+    eos_warning("msg=\"entries removed while listing\" dir=%s count=%llu",
+                arch_dir.c_str(), (unsigned long long) explorer->getErrors());
+  }
+
   return retc;
 }
 
@@ -37,6 +37,7 @@
 #include "namespace/Resolver.hh"
 #include "namespace/utils/Etag.hh"
 #include "namespace/utils/Checksum.hh"
+#include "namespace/utils/TreeHash.hh"
 #include <json/json.h>
 
 EOSMGMNAMESPACE_BEGIN
@@ -625,7 +626,13 @@ ProcCommand::DirInfo(const char* path)
 
         if (!Monitoring) {
           out << "  Directory: '" << spath << "'"
-              << "  Treesize: " << dmd_copy->getTreeSize() << std::endl;
+              << "  Treesize: " << dmd_copy->getTreeSize();
+
+          if (dmd_copy->getTreeHash()) {
+            out << "  Treehash: " << eos::TreeHash::ToHex(dmd_copy->getTreeHash());
+          }
+
+          out << std::endl;
           out << "  Container: " << num_containers
               << "  Files: " << num_files
               << "  Flags: " << StringConversion::IntToOctal(dmd_copy->getMode(), 4);
@@ -660,6 +667,7 @@ ProcCommand::DirInfo(const char* path)
           out << "keylength.file=" << spath.length()
               << " file=" << spath
               << " treesize=" << dmd_copy->getTreeSize()
+              << " treehash=" << eos::TreeHash::ToHex(dmd_copy->getTreeHash())
               << " container=" << num_containers
               << " files=" << num_files
               << " mtime=" << mtime.tv_sec << "." << mtime.tv_nsec
@@ -856,6 +864,7 @@ ProcCommand::DirJSON(uint64_t fid, Json::Value* ret_json, bool dolock)
     json["tmtime"] = (Json::Value::UInt64) tmtime.tv_sec;
     json["tmtime_ns"] = (Json::Value::UInt64) tmtime.tv_nsec;
     json["treesize"] = (Json::Value::UInt64) cmd->getTreeSize();
+    json["treehash"] = eos::TreeHash::ToHex(cmd->getTreeHash());
     json["uid"] = cmd->getCUid();
     json["gid"] = cmd->getCGid();
     json["mode"] = cmd->getFlags();
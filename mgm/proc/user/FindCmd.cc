@@ -34,6 +34,7 @@
 #include "namespace/utils/BalanceCalculator.hh"
 #include "namespace/utils/Checksum.hh"
 #include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
+#include "namespace/ns_quarkdb/explorer/ParallelNamespaceExplorer.hh"
 #include "namespace/ns_quarkdb/ContainerMD.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
 
@@ -70,7 +71,7 @@ static bool eliminateBasedOnUidGid(const eos::console::FindProto& req,
 //------------------------------------------------------------------------------
 // Print hex checksum of given fmd, if requested by req.
 //------------------------------------------------------------------------------
-static void printChecksum(std::ofstream& ss, const eos::console::FindProto& req,
+static void printChecksum(std::ostream& ss, const eos::console::FindProto& req,
                           const std::shared_ptr<eos::IFileMD>& fmd)
 {
   if (req.checksum()) {
@@ -84,7 +85,7 @@ static void printChecksum(std::ofstream& ss, const eos::console::FindProto& req,
 //------------------------------------------------------------------------------
 // Print replica location of an fmd.
 //------------------------------------------------------------------------------
-static void printReplicas(std::ofstream& ss,
+static void printReplicas(std::ostream& ss,
                           const std::shared_ptr<eos::IFileMD>& fmd, bool onlyhost, bool selectonline)
 {
   if (onlyhost) {
@@ -223,7 +224,7 @@ static bool eliminateBasedOnTime(const eos::console::FindProto& req,
 // Print uid / gid of a FileMD or ContainerMD, if requested by req.
 //------------------------------------------------------------------------------
 template<typename T>
-static void printUidGid(std::ofstream& ss, const eos::console::FindProto& req,
+static void printUidGid(std::ostream& ss, const eos::console::FindProto& req,
                         const T& md)
 {
   if (req.printuid()) {
@@ -238,7 +239,7 @@ static void printUidGid(std::ofstream& ss, const eos::console::FindProto& req,
 //------------------------------------------------------------------------------
 // Print fs of a FileMD.
 //------------------------------------------------------------------------------
-static void printFs(std::ofstream& ss, const std::shared_ptr<eos::IFileMD>& fmd)
+static void printFs(std::ostream& ss, const std::shared_ptr<eos::IFileMD>& fmd)
 {
   ss << " fsid=";
   eos::IFileMD::LocationVector loc_vect = fmd->getLocations();
@@ -256,7 +257,7 @@ static void printFs(std::ofstream& ss, const std::shared_ptr<eos::IFileMD>& fmd)
 //------------------------------------------------------------------------------
 // Print a selected FileMD, according to formatting settings in req.
 //------------------------------------------------------------------------------
-static void printFMD(std::ofstream& ss, const eos::console::FindProto& req,
+static void printFMD(std::ostream& ss, const eos::console::FindProto& req,
                      const std::shared_ptr<eos::IFileMD>& fmd)
 {
   if (req.size()) {
@@ -369,12 +370,13 @@ FindCmd::FindCmd(eos::console::RequestProto&& req,
                  eos::common::Mapping::VirtualIdentity& vid) :
   IProcCommand(std::move(req), vid, true)
 {
+  mStreamable = true;
 }
 
 //------------------------------------------------------------------------------
 // Purge atomic files
 //------------------------------------------------------------------------------
-void FindCmd::ProcessAtomicFilePurge(std::ofstream& ss,
+void FindCmd::ProcessAtomicFilePurge(std::ostream& ss,
                                      const std::string& fspath,
                                      eos::IFileMD& fmd)
 {
@@ -419,7 +421,7 @@ void FindCmd::ProcessAtomicFilePurge(std::ofstream& ss,
 // Modify layout stripes
 //------------------------------------------------------------------------------
 void
-eos::mgm::FindCmd::ModifyLayoutStripes(std::ofstream& ss,
+eos::mgm::FindCmd::ModifyLayoutStripes(std::ostream& ss,
                                        const eos::console::FindProto& req,
                                        const std::string& fspath)
 {
@@ -452,10 +454,10 @@ eos::mgm::FindCmd::ModifyLayoutStripes(std::ofstream& ss,
 
     if (std::stoi(env.Get("mgm.proc.retc")) == 0) {
       if (!req.silent()) {
-        ofstdoutStream << env.Get("mgm.proc.stdout") << std::endl;
+        StdOutStream() << env.Get("mgm.proc.stdout") << std::endl;
       }
     } else {
-      ofstderrStream << env.Get("mgm.proc.stderr") << std::endl;
+      StdErrStream() << env.Get("mgm.proc.stderr") << std::endl;
     }
   }
 }
@@ -487,7 +489,7 @@ static bool hasFaultyAcl(std::shared_ptr<IContainerMD>& cmd)
 // Purge version directory.
 //------------------------------------------------------------------------------
 void
-eos::mgm::FindCmd::PurgeVersions(std::ofstream& ss, int64_t maxVersion,
+eos::mgm::FindCmd::PurgeVersions(std::ostream& ss, int64_t maxVersion,
                                  const std::string& dirpath)
 {
   if (dirpath.find(EOS_COMMON_PATH_VERSION_PREFIX) == std::string::npos) {
@@ -509,7 +511,7 @@ eos::mgm::FindCmd::PurgeVersions(std::ofstream& ss, int64_t maxVersion,
 // Print path.
 //------------------------------------------------------------------------------
 void
-eos::mgm::FindCmd::printPath(std::ofstream& ss, const std::string& path,
+eos::mgm::FindCmd::printPath(std::ostream& ss, const std::string& path,
                              bool url)
 {
   if (url) {
@@ -593,18 +595,27 @@ class FindResultProvider
 public:
 
   //----------------------------------------------------------------------------
-  // QDB: Initialize NamespaceExplorer
+  // QDB: Initialize ParallelNamespaceExplorer
   //----------------------------------------------------------------------------
   FindResultProvider(qclient::QClient* qc, const std::string& target,
-    const eos::common::Mapping::VirtualIdentity &v)
+    const eos::common::Mapping::VirtualIdentity &v,
+    std::shared_ptr<FileFilter> filter, uint64_t maxdepth)
     : qcl(qc), path(target), vid(v)
   {
-    ExplorationOptions options;
+    static size_t sThreads = []() {
+      const char* ptr = getenv("EOS_MGM_FIND_THREADS");
+      long long val = (ptr ? strtoll(ptr, nullptr, 10) : 0);
+      return (val > 0 ? (size_t) val : 16);
+    }();
+    ParallelExplorationOptions options;
     options.populateLinkedAttributes = true;
     options.expansionDecider.reset(new PermissionFilter(vid));
     options.view = gOFS->eosView;
+    options.threads = sThreads;
+    options.depthLimit = maxdepth;
+    options.fileFilter = filter;
 
-    explorer.reset(new NamespaceExplorer(path, options, *qcl));
+    explorer.reset(new ParallelNamespaceExplorer(path, options, *qcl));
   }
 
   //----------------------------------------------------------------------------
@@ -690,13 +701,18 @@ public:
 
   bool nextInQDB(FindResult& res)
   {
-    // Just copy the result given by namespace explorer
-    NamespaceItem item;
+    // Just copy the result given by namespace explorer, which hands out the
+    // items in chunks
+    if (chunkPos >= chunk.size()) {
+      chunkPos = 0;
 
-    if (!explorer->fetch(item)) {
-      return false;
+      if (!explorer->fetch(chunk)) {
+        return false;
+      }
     }
 
+    NamespaceItem& item = chunk[chunkPos++];
+
     res.path = item.fullPath;
     res.isdir = !item.isFile;
     res.expansionFilteredOut = item.expansionFilteredOut;
@@ -739,11 +755,13 @@ private:
   std::set<std::string>::iterator fileIterator;
 
   //----------------------------------------------------------------------------
-  // QDB: NamespaceExplorer and QClient
+  // QDB: ParallelNamespaceExplorer and QClient
   //----------------------------------------------------------------------------
   qclient::QClient* qcl = nullptr;
   std::string path;
-  std::unique_ptr<NamespaceExplorer> explorer;
+  std::unique_ptr<ParallelNamespaceExplorer> explorer;
+  std::vector<NamespaceItem> chunk;
+  size_t chunkPos = 0;
   eos::common::Mapping::VirtualIdentity vid;
 };
 
@@ -810,7 +828,7 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
   XrdSfsFileExistence file_exists;
 
   if ((gOFS->_exists(spath.c_str(), file_exists, errInfo, mVid, nullptr))) {
-    ofstderrStream << "error: failed to run exists on '" << spath << "'" << std::endl;
+    StdErrStream() << "error: failed to run exists on '" << spath << "'" << std::endl;
     reply.set_retc(errno);
     return reply;
   } else {
@@ -820,7 +838,7 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
     }
 
     if (file_exists == XrdSfsFileExistNo) {
-      ofstderrStream << "error: no such file or directory" << std::endl;
+      StdErrStream() << "error: no such file or directory" << std::endl;
       reply.set_retc(ENOENT);
       return reply;
     }
@@ -839,21 +857,55 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
                     attributevalue.length() ? attributevalue.c_str() : nullptr,
                     nofiles, 0, true, finddepth,
                     filematch.length() ? filematch.c_str() : nullptr)) {
-      ofstderrStream << "error: unable to run find in directory" << std::endl;
+      StdErrStream() << "error: unable to run find in directory" << std::endl;
       reply.set_retc(errno);
       return reply;
     } else {
       if (stdErr.length()) {
-        ofstderrStream << stdErr;
+        StdErrStream() << stdErr;
         reply.set_retc(E2BIG);
       }
     }
   } else {
-    findResultProvider.reset(new FindResultProvider(
-                               eos::BackendClient::getInstance(gOFS->mQdbContactDetails, "find"),
-                               findRequest.path(),
-                               mVid
-                             ));
+    // Evaluate the selection on file metadata while exploring, the balance
+    // calculation accounts all files
+    std::shared_ptr<FileFilter> filter;
+
+    if (!calcbalance) {
+      filter = std::make_shared<FileFilter>();
+
+      if (findzero) {
+        filter->maxSize = 0;
+      }
+
+      filter->useCtime = findRequest.ctime();
+      filter->olderThan = (time_t) findRequest.olderthan();
+      filter->youngerThan = (time_t) findRequest.youngerthan();
+
+      if (findRequest.onehourold()) {
+        time_t limit = time(nullptr) - 3600;
+
+        if (!filter->olderThan || (filter->olderThan > limit)) {
+          filter->olderThan = limit;
+        }
+      }
+
+      if (!attributekey.empty() && !attributevalue.empty()) {
+        filter->attrKey = attributekey;
+        filter->attrValue = attributevalue;
+      }
+    }
+
+    try {
+      findResultProvider.reset(new FindResultProvider(
+                                 eos::BackendClient::getInstance(gOFS->mQdbContactDetails, "find"),
+                                 findRequest.path(), mVid, filter, finddepth));
+    } catch (const eos::MDException& e) {
+      StdErrStream() << "error: unable to run find in directory: "
+                     << e.what() << std::endl;
+      reply.set_retc(e.getErrno());
+      return reply;
+    }
   }
 
   unsigned int cnt = 0;
@@ -863,18 +915,18 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
   if (findRequest.files() || !nodirs) {
     FindResult findResult;
 
-    while (findResultProvider->next(findResult)) {
+    while (!mForceKill && findResultProvider->next(findResult)) {
       if (findResult.isdir) {
 
         if(findResult.expansionFilteredOut) {
-          ofstderrStream << "error: no permissions to read directory ";
-          ofstderrStream << findResult.path << std::endl;
+          StdErrStream() << "error: no permissions to read directory ";
+          StdErrStream() << findResult.path << std::endl;
         }
 
         if (!findRequest.files() && !nodirs) {
           if (!printcounter) {
-            printPath(ofstdoutStream, findResult.path, printxurl);
-            ofstdoutStream << std::endl;
+            printPath(StdOutStream(), findResult.path, printxurl);
+            StdOutStream() << std::endl;
           }
 
           dircounter++;
@@ -941,13 +993,13 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
 
         // Purge atomic files?
         if (purge_atomic) {
-          this->ProcessAtomicFilePurge(ofstdoutStream, fspath, *fmd.get());
+          this->ProcessAtomicFilePurge(StdOutStream(), fspath, *fmd.get());
           continue;
         }
 
         // Modify layout stripes?
         if (layoutstripes) {
-          this->ModifyLayoutStripes(ofstdoutStream, findRequest, fspath);
+          this->ModifyLayoutStripes(StdOutStream(), findRequest, fspath);
           continue;
         }
 
@@ -959,16 +1011,16 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
 
         // Print simple?
         if (printSimple) {
-          printPath(ofstdoutStream, fspath, printxurl);
-          ofstdoutStream << std::endl;
+          printPath(StdOutStream(), fspath, printxurl);
+          StdOutStream() << std::endl;
           continue;
         }
 
         // Nope, print fancy
-        ofstdoutStream << "path=";
-        printPath(ofstdoutStream, fspath, printxurl);
-        printFMD(ofstdoutStream, findRequest, fmd);
-        ofstdoutStream << std::endl;
+        StdOutStream() << "path=";
+        printPath(StdOutStream(), fspath, printxurl);
+        printFMD(StdOutStream(), findRequest, fmd);
+        StdOutStream() << std::endl;
       }
     }
 
@@ -980,7 +1032,7 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
   if (dirs) {
     FindResult findResult;
 
-    while (findResultProvider->next(findResult)) {
+    while (!mForceKill && findResultProvider->next(findResult)) {
       // Only interested in directories here.
       if (!findResult.isdir) {
         continue;
@@ -1028,14 +1080,14 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
         unsigned long long childdirs = 0;
         childfiles = mCmd->getNumFiles();
         childdirs = mCmd->getNumContainers();
-        ofstdoutStream << findResult.path << " ndir=" << childdirs <<
+        StdOutStream() << findResult.path << " ndir=" << childdirs <<
                        " nfiles=" << childfiles << std::endl;
         continue;
       }
 
       // Purge version directory?
       if (purge) {
-        this->PurgeVersions(ofstdoutStream, max_version, findResult.path);
+        this->PurgeVersions(StdOutStream(), max_version, findResult.path);
         continue;
       }
 
@@ -1054,24 +1106,24 @@ eos::mgm::FindCmd::ProcessRequest() noexcept
           attr = "undef";
         }
 
-        ofstdoutStream << printkey << "=" << std::left << std::setw(
+        StdOutStream() << printkey << "=" << std::left << std::setw(
                          32) << attr << " path=";
       }
 
       // Print the rest.
-      printPath(ofstdoutStream, findResult.path, printxurl);
-      printUidGid(ofstdoutStream, findRequest, mCmd);
-      ofstdoutStream << std::endl;
+      printPath(StdOutStream(), findResult.path, printxurl);
+      printUidGid(StdOutStream(), findRequest, mCmd);
+      StdOutStream() << std::endl;
     }
   }
 
   if (printcounter) {
-    ofstdoutStream << "nfiles=" << filecounter << " ndirectories=" << dircounter <<
+    StdOutStream() << "nfiles=" << filecounter << " ndirectories=" << dircounter <<
                    std::endl;
   }
 
   if (calcbalance) {
-    balanceCalculator.printSummary(ofstdoutStream);
+    balanceCalculator.printSummary(StdOutStream());
   }
 
   if (!CloseTemporaryOutputFiles()) {
@@ -1101,11 +1153,11 @@ void FindCmd::PrintFileInfoMinusM(const std::string& path,
   Cmd.AddOutput(lStdOut, lStdErr);
 
   if (lStdOut.length()) {
-    ofstdoutStream << lStdOut;
+    StdOutStream() << lStdOut;
   }
 
   if (lStdErr.length()) {
-    ofstderrStream << lStdErr;
+    StdErrStream() << lStdErr;
   }
 
   Cmd.close();
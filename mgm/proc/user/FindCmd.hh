@@ -52,16 +52,16 @@ public:
 
   eos::console::ReplyProto ProcessRequest() noexcept override;
   void PrintFileInfoMinusM(const std::string& path, XrdOucErrInfo& errInfo);
-  void ProcessAtomicFilePurge(std::ofstream& ss, const std::string& fspath,
+  void ProcessAtomicFilePurge(std::ostream& ss, const std::string& fspath,
                               eos::IFileMD& fmd);
 
-  void ModifyLayoutStripes(std::ofstream& ss,
+  void ModifyLayoutStripes(std::ostream& ss,
                            const eos::console::FindProto& req, const std::string& fspath);
 
-  void PurgeVersions(std::ofstream& ss, int64_t maxVersion,
+  void PurgeVersions(std::ostream& ss, int64_t maxVersion,
                      const std::string& dirpath);
 
-  void printPath(std::ofstream& ss, const std::string& path, bool url);
+  void printPath(std::ostream& ss, const std::string& path, bool url);
 };
 
 EOSMGMNAMESPACE_END
@@ -45,6 +45,8 @@ ProcCommand::FuseX()
   // This function returns meta data by inode or if provided first translates a path into an inode.
   // The client can provide the meta-data clock. If it is equivalent to the stored clock, this function
   // return EEXIST and no result stream.
+  // For a listing the client can provide a 'since' clock, in that case only the children with a newer
+  // clock are returned together with the complete name to inode map of the directory.
   // If a path cannot be translated the function returns ENOENT or a relevant errno for namespace failures.
   // If mgm.op is equal to 'GETCAP' it does not return meta data but a capability.
   // -------------------------------------------------------------------------------------------------------
@@ -52,6 +54,8 @@ ProcCommand::FuseX()
                         "0";
   XrdOucString sclock = pOpaque->Get("mgm.clock") ? pOpaque->Get("mgm.clock") :
                         "0";
+  XrdOucString ssince = pOpaque->Get("mgm.since") ? pOpaque->Get("mgm.since") :
+                        "0";
   XrdOucString spath  = pOpaque->Get("mgm.path") ? pOpaque->Get("mgm.path") : "";
   XrdOucString schild = pOpaque->Get("mgm.child") ? pOpaque->Get("mgm.child") :
                         "";
@@ -70,6 +74,7 @@ ProcCommand::FuseX()
   const char* inpath = spath.length() ? spath.c_str() : sinode.c_str();
   uint64_t inode = strtoull(sinode.c_str(), 0, 16);
   uint64_t clock = strtoull(sclock.c_str(), 0, 10);
+  uint64_t since = strtoull(ssince.c_str(), 0, 10);
   uint64_t parentinode = 0;
 
   if (EOS_LOGS_DEBUG) {
@@ -194,6 +199,12 @@ ProcCommand::FuseX()
 
     if (sop == "LS") {
       md.set_operation(md.LS);
+
+      if (since) {
+        // a listing 'changed since' only returns the children modified after
+        // the given clock, the client has the others from a previous listing
+        md.set_clock(since);
+      }
     }
 
     if (sop == "GETCAP") {
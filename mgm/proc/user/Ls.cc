@@ -30,10 +30,182 @@
 #include "common/Path.hh"
 #include "common/StringUtils.hh"
 #include "common/Timing.hh"
+#include "namespace/interface/IView.hh"
+#include "namespace/Prefetcher.hh"
 #include "namespace/utils/Mode.hh"
+#include "namespace/utils/Stat.hh"
+#include <json/json.h>
 
 EOSMGMNAMESPACE_BEGIN
 
+namespace
+{
+//! Max number of entries of one page of a paginated listing
+constexpr size_t kMaxPageEntries = 10000;
+
+//------------------------------------------------------------------------------
+// Fill the stat information of a page entry from the metadata of the child
+//------------------------------------------------------------------------------
+void
+FillPageEntry(const eos::FileOrContainerMD& item, bool translateids,
+              Json::Value& entry)
+{
+  uid_t uid;
+  gid_t gid;
+  eos::IFileMD::ctime_t ctime;
+  eos::IFileMD::ctime_t mtime;
+
+  if (item.file) {
+    const std::shared_ptr<eos::IFileMD>& fmd = item.file;
+    entry["ino"] = (Json::UInt64) eos::common::FileId::FidToInode(fmd->getId());
+    entry["mode"] = (Json::UInt) eos::modeFromMetadataEntry(fmd);
+    entry["nlink"] = (Json::UInt)(fmd->isLink() ? 1 : fmd->getNumLocation());
+    entry["size"] = (Json::UInt64) fmd->getSize();
+    uid = fmd->getCUid();
+    gid = fmd->getCGid();
+    fmd->getCTime(ctime);
+    fmd->getMTime(mtime);
+
+    if (fmd->isLink()) {
+      entry["link"] = fmd->getLink();
+    }
+  } else {
+    const std::shared_ptr<eos::IContainerMD>& cmd = item.container;
+    entry["ino"] = (Json::UInt64) cmd->getId();
+    entry["mode"] = (Json::UInt) eos::modeFromMetadataEntry(cmd);
+    entry["nlink"] = 1;
+    entry["size"] = (Json::UInt64) cmd->getTreeSize();
+    uid = cmd->getCUid();
+    gid = cmd->getCGid();
+    cmd->getCTime(ctime);
+    cmd->getMTime(mtime);
+  }
+
+  entry["uid"] = (Json::UInt) uid;
+  entry["gid"] = (Json::UInt) gid;
+  entry["ctime"] = (Json::UInt64) ctime.tv_sec;
+  entry["ctime_ns"] = (Json::UInt64) ctime.tv_nsec;
+  entry["mtime"] = (Json::UInt64) mtime.tv_sec;
+  entry["mtime_ns"] = (Json::UInt64) mtime.tv_nsec;
+
+  if (translateids) {
+    int errc = 0;
+    std::string name = eos::common::Mapping::UidToUserName(uid, errc);
+
+    if (!errc) {
+      entry["user"] = name;
+    }
+
+    errc = 0;
+    name = eos::common::Mapping::GidToGroupName(gid, errc);
+
+    if (!errc) {
+      entry["group"] = name;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// List one page of a directory or a single file with the stat information
+// taken from the metadata of the children, without one _stat per entry
+//
+// @param dir open directory, not used when listing a single file
+// @param ls_file name of the single file to list, empty to list the directory
+// @param dpath directory path
+// @param option ls options
+// @param filter glob filter of the names
+// @param token last name of the previous page, empty for the first page
+// @param limit max number of entries of the page
+// @param page json page with the entries and the next token
+// @param emsg error message
+//
+// @return 0 if successful, otherwise errno
+//------------------------------------------------------------------------------
+int
+ListPage(XrdMgmOfsDirectory& dir, const std::string& ls_file,
+         std::string dpath, const XrdOucString& option,
+         const XrdOucString& filter, const std::string& token, size_t limit,
+         Json::Value& page, std::string& emsg)
+{
+  bool all = (option.find("a") != STR_NPOS);
+  bool translateids = (option.find("n") == STR_NPOS);
+  std::vector<std::string> names;
+  std::string next;
+
+  if (dpath.empty() || (*dpath.rbegin() != '/')) {
+    dpath += "/";
+  }
+
+  if (ls_file.length()) {
+    if (all || (ls_file[0] != '.')) {
+      names.push_back(ls_file);
+    }
+  } else {
+    if (token.length()) {
+      dir.seekAfter(token);
+    }
+
+    const char* val;
+
+    while ((val = dir.nextEntry())) {
+      XrdOucString entryname = val;
+
+      if ((entryname == ".") || (entryname == "..") ||
+          (!all && entryname.beginswith(".")) ||
+          (filter.length() && !entryname.matches(filter.c_str()))) {
+        continue;
+      }
+
+      if (names.size() == limit) {
+        // There is at least one more entry after this page
+        next = names.back();
+        break;
+      }
+
+      names.push_back(val);
+    }
+  }
+
+  eos::Prefetcher prefetcher(gOFS->eosView);
+
+  for (const auto& name : names) {
+    prefetcher.stageItem(dpath + name, false);
+  }
+
+  prefetcher.wait();
+  Json::Value entries(Json::arrayValue);
+
+  try {
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+    std::shared_ptr<eos::IContainerMD> cmd = gOFS->eosView->getContainer(dpath);
+
+    for (const auto& name : names) {
+      eos::FileOrContainerMD item = cmd->findItem(name).get();
+
+      if (!item.file && !item.container) {
+        // Removed since the listing was taken
+        continue;
+      }
+
+      Json::Value entry;
+      entry["name"] = name;
+      FillPageEntry(item, translateids, entry);
+      entries.append(entry);
+    }
+  } catch (eos::MDException& e) {
+    emsg = "error: unable to list directory ";
+    emsg += dpath;
+    return e.getErrno();
+  }
+
+  page["path"] = dpath;
+  page["entries"] = entries;
+  page["token"] = next;
+  page["retc"] = "0";
+  return 0;
+}
+}
+
 
 int
 ProcCommand::Ls()
@@ -126,6 +298,52 @@ ProcCommand::Ls()
         option += "l";
       }
 
+      if (!listrc && pOpaque->Get("mgm.ls.limit")) {
+        // Paginated listing returning the entries with their stat information
+        std::string token = pOpaque->Get("mgm.ls.token") ?
+                            eos::common::StringConversion::curl_unescaped(
+                              pOpaque->Get("mgm.ls.token")) : "";
+        size_t limit = strtoull(pOpaque->Get("mgm.ls.limit"), 0, 10);
+
+        if (!limit || (limit > kMaxPageEntries)) {
+          limit = kMaxPageEntries;
+        }
+
+        Json::Value page;
+        std::string emsg;
+        int rc = ListPage(dir, ls_file.c_str(), spath.c_str(), option, filter,
+                          token, limit, page, emsg);
+
+        if (!ls_file.length()) {
+          dir.close();
+        }
+
+        mJsonFormat = true;
+
+        if (rc) {
+          stdErr = emsg.c_str();
+          retc = rc;
+        } else {
+          Json::FastWriter writer;
+          std::string out = writer.write(page);
+          // Keep the reply parsable as opaque information
+          std::string escaped;
+          escaped.reserve(out.size());
+
+          for (char c : out) {
+            if (c == '&') {
+              escaped += "\\u0026";
+            } else if (c != '\n') {
+              escaped += c;
+            }
+          }
+
+          stdJson = escaped.c_str();
+        }
+
+        return SFS_OK;
+      }
+
       if (!listrc) {
         const char* val;
 
@@ -30,6 +30,7 @@
 /*----------------------------------------------------------------------------*/
 /*----------------------------------------------------------------------------*/
 #include <string>
+#include <vector>
 /*----------------------------------------------------------------------------*/
 
 EOSMGMNAMESPACE_BEGIN
@@ -40,6 +41,18 @@ public:
 
   typedef std::map< std::string, std::string > transfer_t;
 
+  //! Update of a transfer row, unset fields keep their value
+  struct Update {
+    long long mId {0};
+    int mState {-1}; ///< new state or -1
+    float mProgress {-1}; ///< new progress or -1
+    time_t mExpires {0}; ///< new expiration time or 0
+    bool mHasExecHost {false};
+    std::string mExecHost;
+    bool mHasLog {false};
+    std::string mLog;
+  };
+
   TransferDB() {};
   virtual ~TransferDB() {};
   virtual bool Init(const char* dbspec="/var/eos/tx/") = 0;
@@ -59,6 +72,15 @@ public:
   virtual std::vector<long long> QueryByUid(uid_t uid) = 0;
   virtual transfer_t GetNextTransfer(int status) = 0;
   virtual transfer_t GetTransfer(long long id, bool nolock=false) = 0;
+  virtual bool Exists(long long id) = 0;
+
+  //! Select up to max transfers in state status ordered by id and move them
+  //! to state claimed in one transaction
+  virtual std::vector<transfer_t> ClaimTransfers(int status, int claimed, size_t max) = 0;
+
+  //! Apply a batch of updates in one transaction, returns the number of
+  //! updated transfers
+  virtual size_t ApplyUpdates(const std::vector<Update>& updates) = 0;
 
 };
 
@@ -25,15 +25,20 @@
 #include "mgm/txengine/TransferFsDB.hh"
 #include "mgm/FsView.hh"
 #include "common/StringConversion.hh"
+#include <memory>
+#include <set>
 
 EOSMGMNAMESPACE_BEGIN
 
 TransferEngine gTransferEngine;
 const char* TransferEngine::gConfigSchedule = "transfer.schedule";
+constexpr size_t TransferEngine::sDispatchBatch;
+constexpr size_t TransferEngine::sGwQueueLimit;
+constexpr size_t TransferEngine::sMaxPendingUpdates;
 
 /*----------------------------------------------------------------------------*/
 TransferEngine::TransferEngine():
-  mRunning(false)
+  mRunning(false), mGeneration(0)
 {
   xDB = (TransferDB*) new TransferFsDB();
 }
@@ -71,6 +76,7 @@ int TransferEngine::Run(bool store)
 
     mSchedulerThread.reset(&TransferEngine::Scheduler, this);
     mWatchThread.reset(&TransferEngine::Watch, this);
+    mFlushThread.reset(&TransferEngine::Flusher, this);
     return 0;
   }
 
@@ -83,6 +89,8 @@ TransferEngine::Stop(bool store)
 {
   mWatchThread.join();
   mSchedulerThread.join();
+  mFlushThread.join();
+  FlushUpdates();
 
   if (store) {
     FsView::gFsView.SetGlobalConfig(TransferEngine::gConfigSchedule, "false");
@@ -111,6 +119,147 @@ TransferEngine::ApplyTransferEngineConfig()
   return retc;
 }
 
+/*----------------------------------------------------------------------------*/
+bool
+TransferEngine::SetState(long long id, int status)
+{
+  if (id == 0) {
+    // applies to all transfers
+    FlushUpdates();
+    return xDB->SetState(id, status);
+  }
+
+  if (!xDB->Exists(id)) {
+    return false;
+  }
+
+  TransferDB::Update update;
+  update.mId = id;
+  update.mState = status;
+
+  if (status == kInserted) {
+    // we update the expiration time to 1 day
+    update.mProgress = 0.0;
+    update.mExpires = time(NULL) + 86400;
+  } else if (status == kDone) {
+    update.mProgress = 100.0;
+  }
+
+  QueueUpdate(update);
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+TransferEngine::SetProgress(long long id, float progress)
+{
+  if (!xDB->Exists(id)) {
+    return false;
+  }
+
+  TransferDB::Update update;
+  update.mId = id;
+  update.mProgress = (progress < 0) ? 0 : progress;
+  QueueUpdate(update);
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+TransferEngine::SetExecutionHost(long long id, std::string& exechost)
+{
+  if (id == 0) {
+    FlushUpdates();
+    return xDB->SetExecutionHost(id, exechost);
+  }
+
+  TransferDB::Update update;
+  update.mId = id;
+  update.mHasExecHost = true;
+  update.mExecHost = exechost;
+  QueueUpdate(update);
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+TransferEngine::SetLog(long long id, std::string log)
+{
+  TransferDB::Update update;
+  update.mId = id;
+  update.mHasLog = true;
+  update.mLog = log;
+  QueueUpdate(update);
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+void
+TransferEngine::QueueUpdate(const TransferDB::Update& update)
+{
+  bool flush = false;
+  {
+    std::lock_guard<std::mutex> lock(mUpdateMutex);
+    TransferDB::Update& pending = mPendingUpdates[update.mId];
+    pending.mId = update.mId;
+
+    if (update.mState >= 0) {
+      pending.mState = update.mState;
+    }
+
+    if (update.mProgress >= 0) {
+      pending.mProgress = update.mProgress;
+    }
+
+    if (update.mExpires) {
+      pending.mExpires = update.mExpires;
+    }
+
+    if (update.mHasExecHost) {
+      pending.mHasExecHost = true;
+      pending.mExecHost = update.mExecHost;
+    }
+
+    if (update.mHasLog) {
+      pending.mHasLog = true;
+      pending.mLog = update.mLog;
+    }
+
+    flush = (mPendingUpdates.size() >= sMaxPendingUpdates);
+  }
+
+  if (flush) {
+    // don't let the pending updates grow without bounds if the flusher lags
+    FlushUpdates();
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+void
+TransferEngine::FlushUpdates()
+{
+  std::lock_guard<std::mutex> flush_lock(mFlushMutex);
+  std::vector<TransferDB::Update> updates;
+  {
+    std::lock_guard<std::mutex> lock(mUpdateMutex);
+
+    if (mPendingUpdates.empty()) {
+      return;
+    }
+
+    updates.reserve(mPendingUpdates.size());
+
+    for (auto it = mPendingUpdates.begin(); it != mPendingUpdates.end(); ++it) {
+      updates.push_back(std::move(it->second));
+    }
+
+    mPendingUpdates.clear();
+  }
+  size_t n = xDB->ApplyUpdates(updates);
+  eos_static_debug("msg=\"flushed transfer updates\" queued=%lu applied=%lu",
+                   updates.size(), n);
+}
+
 /*----------------------------------------------------------------------------*/
 int
 TransferEngine::Submit(XrdOucString& src, XrdOucString& dst, XrdOucString& rate,
@@ -172,6 +321,7 @@ TransferEngine::Ls(XrdOucString& id, XrdOucString& option, XrdOucString& group,
                    XrdOucString& stdOut, XrdOucString& stdErr,
                    eos::common::Mapping::VirtualIdentity& vid)
 {
+  FlushUpdates();
   // forbid the 'a' option for non root
   if ((vid.uid) && (option.find("a") != STR_NPOS)) {
     stdErr += "error: you have to be root to query transfers of all users\n";
@@ -187,6 +337,7 @@ TransferEngine::Cancel(XrdOucString& sid, XrdOucString& group,
                        XrdOucString& stdOut, XrdOucString& stdErr,
                        eos::common::Mapping::VirtualIdentity& vid)
 {
+  FlushUpdates();
   long long id = strtoll(sid.c_str(), 0, 10);
 
   if (id) {
@@ -207,7 +358,9 @@ TransferEngine::Cancel(XrdOucString& sid, XrdOucString& group,
       }
     }
 
-    return xDB->Cancel(id, stdOut, stdErr);
+    int retc = xDB->Cancel(id, stdOut, stdErr);
+    mGeneration++;
+    return retc;
   } else {
     // cancel by group
     // query all transfers in a group
@@ -225,6 +378,7 @@ TransferEngine::Cancel(XrdOucString& sid, XrdOucString& group,
       }
     }
 
+    mGeneration++;
     return 0;
   }
 }
@@ -245,6 +399,7 @@ TransferEngine::Log(XrdOucString& sid, XrdOucString& group,
                     XrdOucString& stdOut, XrdOucString& stdErr,
                     eos::common::Mapping::VirtualIdentity& vid)
 {
+  FlushUpdates();
   long long id = strtoll(sid.c_str(), 0, 10);
   TransferDB::transfer_t transfer = xDB->GetTransfer(id);
 
@@ -273,6 +428,7 @@ TransferEngine::Purge(XrdOucString& option, XrdOucString& sid,
                       XrdOucString& group, XrdOucString& stdOut, XrdOucString& stdErr,
                       eos::common::Mapping::VirtualIdentity& vid)
 {
+  FlushUpdates();
   long long id = strtoll(sid.c_str(), 0, 10);
   XrdOucString state = "failed";
   std::vector<long long> ids;
@@ -298,6 +454,7 @@ TransferEngine::Purge(XrdOucString& option, XrdOucString& sid,
         if ((!id) || (id == strtoll(transfer["id"].c_str(), 0, 10))) {
           // purge all by the user or by explicit id
           if (xDB->Archive(ids[i], stdOut, stdErr)) {
+            mGeneration++;
             return -1;
           } else {
             xDB->Cancel(ids[i], stdOut, stdErr);
@@ -314,6 +471,7 @@ TransferEngine::Purge(XrdOucString& option, XrdOucString& sid,
     }
   }
 
+  mGeneration++;
   return 0;
 }
 
@@ -323,6 +481,7 @@ TransferEngine::Resubmit(XrdOucString& sid, XrdOucString& group,
                          XrdOucString& stdOut, XrdOucString& stdErr,
                          eos::common::Mapping::VirtualIdentity& vid)
 {
+  FlushUpdates();
   long long id = strtoll(sid.c_str(), 0, 10);
   std::vector<long long> ids;
 
@@ -368,6 +527,7 @@ TransferEngine::Resubmit(XrdOucString& sid, XrdOucString& group,
     }
   }
 
+  FlushUpdates();
   return 0;
 }
 
@@ -377,11 +537,13 @@ TransferEngine::Reset(XrdOucString& option, XrdOucString& sid,
                       XrdOucString& group, XrdOucString& stdOut, XrdOucString& stdErr,
                       eos::common::Mapping::VirtualIdentity& vid)
 {
+  FlushUpdates();
   long long id = strtoll(sid.c_str(), 0, 10);
 
   if ((!id) && (!group.length()) && (vid.uid == 0)) {
     // simplest case: reset all as 'root'
     SetState(0, kInserted);
+    mGeneration++;
     stdOut += "success: all transfers have been reset\n";
     return 0;
   }
@@ -417,6 +579,9 @@ TransferEngine::Reset(XrdOucString& option, XrdOucString& sid,
     }
   }
 
+  // the transfers claimed by the scheduler are reset as well
+  FlushUpdates();
+  mGeneration++;
   return 0;
 }
 
@@ -426,7 +591,9 @@ TransferEngine::Clear(XrdOucString& stdOut, XrdOucString& stdErr,
                       eos::common::Mapping::VirtualIdentity& vid)
 {
   if (vid.uid == 0) {
+    FlushUpdates();
     xDB->Clear(stdOut, stdErr);
+    mGeneration++;
     return 0;
   } else {
     stdErr += "error: you have to be 'root' to clear transfers\n";
@@ -434,6 +601,94 @@ TransferEngine::Clear(XrdOucString& stdOut, XrdOucString& stdErr,
   }
 }
 
+/*----------------------------------------------------------------------------*/
+bool
+TransferEngine::AssembleJob(TransferDB::transfer_t& transfer,
+                            XrdOucString& transferjob)
+{
+  std::vector<std::string> src_tok;
+  std::vector<std::string> dst_tok;
+  eos::common::StringConversion::EmptyTokenize(transfer["src"], src_tok, "?");
+  eos::common::StringConversion::EmptyTokenize(transfer["dst"], dst_tok, "?");
+
+  if (!src_tok.size() || !dst_tok.size()) {
+    return false;
+  }
+
+  transferjob    = "source.url=";
+  transferjob += src_tok[0].c_str();
+
+  if (src_tok.size() == 2) {
+    // the opaque information has to be sealead against the use of '& '
+    XrdOucString env = src_tok[1].c_str();
+    transferjob += "&source.env=";
+    transferjob += XrdMqMessage::Seal(env, "_AND_");
+  }
+
+  transferjob  += "&target.url=";
+  transferjob += dst_tok[0].c_str();
+
+  if (dst_tok.size() == 2) {
+    // the opaque information has to be sealead against the use of '&'
+    XrdOucString env = dst_tok[1].c_str();
+    transferjob += "&target.env=";
+    transferjob += XrdMqMessage::Seal(env, "_AND_");
+  }
+
+  transferjob  += "&tx.id=";
+  transferjob += transfer["id"].c_str();
+  transferjob  += "&tx.streams=";
+  transferjob += transfer["streams"].c_str();
+  transferjob  += "&tx.rate=";
+  transferjob += transfer["rate"].c_str();
+  transferjob  += "&tx.exp=";
+  transferjob += transfer["expires"].c_str();
+  transferjob  += "&tx.uid=";
+  transferjob += transfer["uid"].c_str();
+  transferjob  += "&tx.gid=";
+  transferjob += transfer["gid"].c_str();
+  transferjob  += "&tx.noauth=";
+  transferjob += transfer["noauth"].c_str();
+  eos_static_debug("transfer job %s", transferjob.c_str());
+  // now encrypt the security credential
+  XrdOucString credential = transfer["credential"].c_str();
+  XrdOucString enccredential;
+  eos::common::SymKey* symkey = eos::common::gSymKeyStore.GetCurrentKey();
+
+  if (credential.length() && symkey &&
+      XrdMqMessage::SymmetricStringEncrypt(credential, enccredential,
+          (char*)symkey->GetKey())) {
+    transferjob += "&tx.auth.cred=";
+    transferjob += enccredential;
+    transferjob += "&tx.auth.digest=";
+    transferjob += symkey->GetDigest64();
+  }
+
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+void
+TransferEngine::Unclaim(ready_queues_t& ready,
+                        std::deque<TransferDB::transfer_t>& unassigned)
+{
+  for (auto it = ready.begin(); it != ready.end(); ++it) {
+    unassigned.insert(unassigned.end(), it->second.begin(), it->second.end());
+  }
+
+  ready.clear();
+
+  for (auto it = unassigned.begin(); it != unassigned.end(); ++it) {
+    TransferDB::Update update;
+    update.mId = strtoll((*it)["id"].c_str(), 0, 10);
+    update.mState = kInserted;
+    QueueUpdate(update);
+  }
+
+  unassigned.clear();
+  FlushUpdates();
+}
+
 /*----------------------------------------------------------------------------*/
 void
 TransferEngine::Scheduler(ThreadAssistant& assistant) noexcept
@@ -443,195 +698,230 @@ TransferEngine::Scheduler(ThreadAssistant& assistant) noexcept
   assistant.wait_for(std::chrono::seconds(10));
   size_t gwpos = 0;
   double pacifier = 1;
+  uint64_t generation = mGeneration;
+  // transfers claimed from the DB (state 'validated') waiting for a slot on
+  // the gateway they are assigned to
+  ready_queues_t ready;
+  std::deque<TransferDB::transfer_t> unassigned;
+  std::set<long long> claimed;
+  {
+    // resume the transfers claimed but not dispatched before a restart
+    XrdOucString state = GetTransferState(kValidated);
+    std::vector<long long> ids = xDB->QueryByState(state);
+
+    for (size_t i = 0; i < ids.size(); i++) {
+      TransferDB::Update update;
+      update.mId = ids[i];
+      update.mState = kInserted;
+      QueueUpdate(update);
+    }
+
+    FlushUpdates();
+
+    if (ids.size()) {
+      eos_static_info("msg=\"resumed claimed transfers\" n=%lu", ids.size());
+    }
+  }
 
   while (!assistant.terminationRequested()) {
-    // schedule here
+    size_t dispatched = 0;
+
+    if (generation != mGeneration) {
+      // transfers have been canceled or reset - claim them again
+      generation = mGeneration;
+      Unclaim(ready, unassigned);
+      claimed.clear();
+    }
+
+    // free queue slots of the usable gateways
+    std::map<std::string, size_t> slots;
+    bool no_gw = false;
     {
-      eos_static_debug("getting next transfer");
-      TransferDB::transfer_t transfer = GetNextTransfer(kInserted);
+      eos::common::RWMutexReadLock viewlock(FsView::gFsView.ViewMutex);
+      eos::common::RWMutexReadLock gwlock(FsView::gFsView.GwMutex);
+      no_gw = FsView::gFsView.mGwNodes.empty();
 
-      if (transfer.count("error")) {
-        eos_static_debug("GetNextTransfer(kInserted) returned %s",
-                         transfer["error"].c_str());
-      } else {
-        if (transfer.count("id")) {
-          pacifier = 1; // reset the self pacing algorithm
-          long long id = strtoll(transfer["id"].c_str(), 0, 10);
-          eos_static_info("received transfer id=%lld", id);
-          // SetState(id, kValidated);
-          // ------------------------------------------------------------
-          // trivial scheduling engine
-          // ------------------------------------------------------------
-          bool no_gw = true;
-
-          while (no_gw) {
-            {
-              eos::common::RWMutexReadLock viewlock(FsView::gFsView.ViewMutex);
-              eos::common::RWMutexReadLock gwlock(FsView::gFsView.GwMutex);
-
-              if (FsView::gFsView.mGwNodes.size()) {
-                no_gw = false;
-              }
-            }
+      for (auto it = FsView::gFsView.mGwNodes.begin();
+           it != FsView::gFsView.mGwNodes.end(); ++it) {
+        auto node = FsView::gFsView.mNodeView.find(*it);
+
+        if (node == FsView::gFsView.mNodeView.end()) {
+          continue;
+        }
 
-            if (no_gw) {
-              eos_static_info("msg=\"no gw available to run transfer\"");
+        // the node should have heartbeat and status on
+        if (((time(NULL) - node->second->GetHeartBeat()) < 10) &&
+            (node->second->GetStatus() == "online")) {
+          size_t size = node->second->mGwQueue->Size();
+          slots[*it] = (size < sGwQueueLimit) ? (sGwQueueLimit - size) : 0;
+        }
+      }
+    }
 
-              for (size_t i = 0; i < 60; i++) {
-                assistant.wait_for(std::chrono::seconds(1));
+    if (no_gw) {
+      eos_static_info("msg=\"no gw available to run transfer\"");
 
-                if (assistant.terminationRequested()) {
-                  return;
-                }
-              }
-            }
-          }
+      for (size_t i = 0; i < 60; i++) {
+        assistant.wait_for(std::chrono::seconds(1));
 
-          // Select round-robin a gw to deal with it
-          eos::common::RWMutexReadLock viewlock(FsView::gFsView.ViewMutex);
-          eos::common::RWMutexReadLock gwlock(FsView::gFsView.GwMutex);
-          gwpos++;
-          size_t gwnpos = gwpos % (FsView::gFsView.mGwNodes.size() ?
-                                   FsView::gFsView.mGwNodes.size() : 1);
-          std::set<std::string>::const_iterator it =
-            FsView::gFsView.mGwNodes.begin();
-          std::advance(it, gwnpos);
-
-          if (it != FsView::gFsView.mGwNodes.end()) {
-            eos_static_info("selected gw: %s", it->c_str());
-          } else {
-            continue;
+        if (assistant.terminationRequested()) {
+          break;
+        }
+      }
+
+      continue;
+    }
+
+    if (slots.size()) {
+      // transfers of gateways which went away have to be assigned again
+      size_t nready = unassigned.size();
+
+      for (auto it = ready.begin(); it != ready.end();) {
+        if (!slots.count(it->first)) {
+          unassigned.insert(unassigned.end(), it->second.begin(), it->second.end());
+          it = ready.erase(it);
+        } else {
+          nready += it->second.size();
+          ++it;
+        }
+      }
+
+      // claim a new batch of transfers in one transaction
+      if (nready < sDispatchBatch) {
+        std::vector<TransferDB::transfer_t> batch =
+          xDB->ClaimTransfers(kInserted, kValidated, sDispatchBatch - nready);
+
+        for (size_t i = 0; i < batch.size(); i++) {
+          long long id = strtoll(batch[i]["id"].c_str(), 0, 10);
+
+          if (claimed.insert(id).second) {
+            unassigned.push_back(batch[i]);
           }
+        }
 
-          // Assemble a transfer job
-          XrdOucString transferjob = "";
-          TransferDB::transfer_t transfer = GetTransfer(id);
-
-          if (transfer.count("id")) {
-            std::vector<std::string> src_tok;
-            std::vector<std::string> dst_tok;
-            eos::common::StringConversion::EmptyTokenize(transfer["src"], src_tok, "?");
-            eos::common::StringConversion::EmptyTokenize(transfer["dst"], dst_tok, "?");
-
-            if (src_tok.size() && dst_tok.size()) {
-              transferjob    = "source.url=";
-              transferjob += src_tok[0].c_str();
-
-              if (src_tok.size() == 2) {
-                // the opaque information has to be sealead against the use of '& '
-                XrdOucString env = src_tok[1].c_str();
-                transferjob += "&source.env=";
-                transferjob += XrdMqMessage::Seal(env, "_AND_");
-              }
+        if (batch.size()) {
+          eos_static_info("msg=\"claimed transfers\" n=%lu", batch.size());
+        }
+      }
 
-              transferjob  += "&target.url=";
-              transferjob += dst_tok[0].c_str();
+      // assign them round-robin to the gateways
+      while (unassigned.size()) {
+        auto it = slots.begin();
+        std::advance(it, gwpos++ % slots.size());
+        ready[it->first].push_back(unassigned.front());
+        unassigned.pop_front();
+      }
 
-              if (dst_tok.size() == 2) {
-                // the opaque information has to be sealead against the use of '&'
-                XrdOucString env = dst_tok[1].c_str();
-                transferjob += "&target.env=";
-                transferjob += XrdMqMessage::Seal(env, "_AND_");
-              }
+      // fill the free slots, a gateway with an empty ready queue takes over
+      // transfers from the longest one
+      eos::common::RWMutexReadLock viewlock(FsView::gFsView.ViewMutex);
+      eos::common::RWMutexReadLock gwlock(FsView::gFsView.GwMutex);
 
-              transferjob  += "&tx.id=";
-              transferjob += transfer["id"].c_str();
-              transferjob  += "&tx.streams=";
-              transferjob += transfer["streams"].c_str();
-              transferjob  += "&tx.rate=";
-              transferjob += transfer["rate"].c_str();
-              transferjob  += "&tx.exp=";
-              transferjob += transfer["expires"].c_str();
-              transferjob  += "&tx.uid=";
-              transferjob += transfer["uid"].c_str();
-              transferjob  += "&tx.gid=";
-              transferjob += transfer["gid"].c_str();
-              transferjob  += "&tx.noauth=";
-              transferjob += transfer["noauth"].c_str();
-              fprintf(stderr, "%s\n", transferjob.c_str());
-              // now encrypt the security credential
-              XrdOucString credential = transfer["credential"].c_str();
-              XrdOucString enccredential;
-              eos::common::SymKey* symkey = eos::common::gSymKeyStore.GetCurrentKey();
-
-              if (credential.length() && symkey &&
-                  XrdMqMessage::SymmetricStringEncrypt(credential, enccredential,
-                      (char*)symkey->GetKey())) {
-                transferjob += "&tx.auth.cred=";
-                transferjob += enccredential;
-                transferjob += "&tx.auth.digest=";
-                transferjob += symkey->GetDigest64();
-              }
+      for (auto it = slots.begin(); it != slots.end(); ++it) {
+        auto node = FsView::gFsView.mNodeView.find(it->first);
 
-              // Do one full loop over the nodes and take the first one which
-              // does not exceed the queue limit of 20 transfers
-              eos::common::TransferJob* txjob = 0;
-
-              for (size_t n = 0; n < FsView::gFsView.mGwNodes.size(); n++) {
-                if (FsView::gFsView.mNodeView.count(*it)) {
-                  std::string status = FsView::gFsView.mNodeView[*it]->GetStatus();
-
-                  // the node should not have the queue filled, have heartbeat and status on
-                  if ((FsView::gFsView.mNodeView[*it]->mGwQueue->Size() < 20) &&
-                      ((time(NULL) - FsView::gFsView.mNodeView[*it]->GetHeartBeat()) < 10) &&
-                      (status == "online")) {
-                    if (txjob) {
-                      delete txjob;
-                    }
-
-                    txjob = new eos::common::TransferJob(transferjob.c_str());
-
-                    if (txjob && FsView::gFsView.mNodeView[*it]->mGwQueue->Add(txjob)) {
-                      eos_static_info("msg=submitted id=%lld node=%s\n", id, it->c_str());
-                      SetState(id, kScheduled);
-                      std::string exechost = it->c_str();
-                      SetExecutionHost(id, exechost);
-                      break;
-                    }
-                  } else {
-                    gwpos++;
-                    it++;
-
-                    if (it == FsView::gFsView.mGwNodes.end()) {
-                      it = FsView::gFsView.mGwNodes.begin();
-                    }
-                  }
-                }
-              }
+        if ((node == FsView::gFsView.mNodeView.end()) ||
+            !FsView::gFsView.mGwNodes.count(it->first)) {
+          continue;
+        }
+
+        std::deque<TransferDB::transfer_t>& queue = ready[it->first];
 
-              if (txjob) {
-                delete txjob;
-                continue;
-              } else {
-                pacifier *= (1.2);
+        while (it->second) {
+          if (queue.empty()) {
+            auto longest = ready.end();
 
-                if (pacifier > 10) {
-                  pacifier = 10.0;
-                }
+            for (auto rit = ready.begin(); rit != ready.end(); ++rit) {
+              if (rit->second.size() && ((longest == ready.end()) ||
+                                         (rit->second.size() > longest->second.size()))) {
+                longest = rit;
               }
             }
-          } else {
-            eos_static_err("GetTransfer(id) failed");
+
+            if (longest == ready.end()) {
+              break;
+            }
+
+            queue.push_back(longest->second.back());
+            longest->second.pop_back();
           }
-        } else {
-          eos_static_debug("GetNextTransfer(kInserted) returnd no id");
-          pacifier *= (1.2);
 
-          if (pacifier > 10) {
-            pacifier = 10.0;
+          TransferDB::transfer_t& transfer = queue.front();
+          long long id = strtoll(transfer["id"].c_str(), 0, 10);
+          XrdOucString transferjob;
+
+          if (!AssembleJob(transfer, transferjob)) {
+            eos_static_err("msg=\"invalid transfer\" id=%lld", id);
+            TransferDB::Update update;
+            update.mId = id;
+            update.mState = kFailed;
+            QueueUpdate(update);
+            claimed.erase(id);
+            queue.pop_front();
+            continue;
+          }
+
+          std::unique_ptr<eos::common::TransferJob> txjob(new
+              eos::common::TransferJob(transferjob.c_str()));
+
+          if (!node->second->mGwQueue->Add(txjob.get())) {
+            eos_static_err("msg=\"failed to queue transfer\" id=%lld node=%s", id,
+                           it->first.c_str());
+            break;
           }
+
+          eos_static_info("msg=submitted id=%lld node=%s", id, it->first.c_str());
+          TransferDB::Update update;
+          update.mId = id;
+          update.mState = kScheduled;
+          update.mHasExecHost = true;
+          update.mExecHost = it->first;
+          QueueUpdate(update);
+          claimed.erase(id);
+          queue.pop_front();
+          it->second--;
+          dispatched++;
         }
       }
+    } else {
+      eos_static_debug("msg=\"no gw online to run transfers\"");
+    }
+
+    if (dispatched) {
+      // the scheduled states are written in one transaction
+      FlushUpdates();
+      pacifier = 1; // reset the self pacing algorithm
+    } else {
+      pacifier *= (1.2);
+
+      if (pacifier > 10) {
+        pacifier = 10.0;
+      }
     }
 
     for (size_t i = 0; i < pacifier * loopsleep / 100000; i++) {
       assistant.wait_for(std::chrono::milliseconds(100));
 
       if (assistant.terminationRequested()) {
-        return;
+        break;
       }
     }
   }
+
+  // the transfers not dispatched yet are taken by the next run
+  Unclaim(ready, unassigned);
+}
+
+/*----------------------------------------------------------------------------*/
+void
+TransferEngine::Flusher(ThreadAssistant& assistant) noexcept
+{
+  eos_static_info("running transfer update flusher");
+
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(std::chrono::seconds(1));
+    FlushUpdates();
+  }
 }
 
 /*----------------------------------------------------------------------------*/
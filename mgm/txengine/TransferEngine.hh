@@ -28,6 +28,10 @@
 #include "mgm/txengine/TransferDB.hh"
 #include "common/Mapping.hh"
 #include "common/AssistedThread.hh"
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <string>
 
 EOSMGMNAMESPACE_BEGIN
@@ -42,8 +46,45 @@ private:
   TransferDB* xDB;
   AssistedThread mSchedulerThread;
   AssistedThread mWatchThread;
+  AssistedThread mFlushThread;
   std::atomic<bool> mRunning;
+  //! Coalesced updates waiting to be written in one transaction
+  std::map<long long, TransferDB::Update> mPendingUpdates;
+  std::mutex mUpdateMutex; ///< protects mPendingUpdates
+  std::mutex mFlushMutex; ///< serializes the flushes to keep updates in order
+  //! Incremented when transfers are canceled or reset, the scheduler then
+  //! drops the transfers it claimed and claims them again
+  std::atomic<uint64_t> mGeneration;
+
+  typedef std::map<std::string, std::deque<TransferDB::transfer_t> >
+  ready_queues_t;
+
+  //----------------------------------------------------------------------------
+  //! Queue an update, it is merged with the pending update of the same id
+  //----------------------------------------------------------------------------
+  void QueueUpdate(const TransferDB::Update& update);
+
+  //----------------------------------------------------------------------------
+  //! Put the claimed transfers back into the inserted state
+  //----------------------------------------------------------------------------
+  void Unclaim(ready_queues_t& ready,
+               std::deque<TransferDB::transfer_t>& unassigned);
+
+  //----------------------------------------------------------------------------
+  //! Build the gateway job description of a transfer
+  //!
+  //! @return false if the transfer has no valid source or destination
+  //----------------------------------------------------------------------------
+  static bool AssembleJob(TransferDB::transfer_t& transfer, XrdOucString& job);
+
 public:
+  //! Max number of transfers claimed from the DB and kept in the ready queues
+  static constexpr size_t sDispatchBatch = 1000;
+  //! Max number of transfers queued on a gateway
+  static constexpr size_t sGwQueueLimit = 20;
+  //! Number of pending updates forcing a synchronous flush
+  static constexpr size_t sMaxPendingUpdates = 10000;
+
   //! Global configuration tag if scheduling is enabled
   static const char* gConfigSchedule;
 
@@ -111,6 +152,13 @@ public:
 
   void Watch(ThreadAssistant& assistant) noexcept;
 
+  void Flusher(ThreadAssistant& assistant) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Write the pending updates to the DB in one transaction
+  //----------------------------------------------------------------------------
+  void FlushUpdates();
+
   int ApplyTransferEngineConfig();
 
   int Submit(XrdOucString& src, XrdOucString& dst, XrdOucString& rate,
@@ -146,30 +194,23 @@ public:
             XrdOucString& stdOut, XrdOucString& stdErr,
             eos::common::Mapping::VirtualIdentity& vid);
 
-  bool SetState(long long id, int status)
-  {
-    return xDB->SetState(id, status);
-  }
+  //----------------------------------------------------------------------------
+  //! State, progress, execution host and log updates are coalesced per
+  //! transfer and written in batches by the flusher thread. SetState and
+  //! SetProgress return false if the transfer does not exist (anymore).
+  //----------------------------------------------------------------------------
+  bool SetState(long long id, int status);
 
-  bool SetProgress(long long id, float progress)
-  {
-    return xDB->SetProgress(id, progress);
-  }
+  bool SetProgress(long long id, float progress);
 
-  bool SetExecutionHost(long long id, std::string& exechost)
-  {
-    return xDB->SetExecutionHost(id, exechost);
-  }
+  bool SetExecutionHost(long long id, std::string& exechost);
 
   bool SetCredential(long long id, std::string credential, time_t exptime)
   {
     return xDB->SetCredential(id, credential, exptime);
   }
 
-  bool SetLog(long long id, std::string log)
-  {
-    return xDB->SetLog(id, log);
-  }
+  bool SetLog(long long id, std::string log);
 
   TransferDB::transfer_t GetNextTransfer(int status)
   {
@@ -178,6 +219,7 @@ public:
 
   TransferDB::transfer_t GetTransfer(long long id)
   {
+    FlushUpdates();
     return xDB->GetTransfer(id);
   }
 };
@@ -32,7 +32,7 @@ EOSMGMNAMESPACE_BEGIN
 
 /*----------------------------------------------------------------------------*/
 TransferFsDB::TransferFsDB():
-  DB(0), fdArchive(0), ErrMsg(0)
+  DB(0), fdArchive(0), ErrMsg(0), SelectStmt(0), UpdateStmt(0), SyncStmt(0)
 {
   SetLogId("TransferDB", "<service>");
 }
@@ -104,6 +104,29 @@ TransferFsDB::Init(const char* dbpath)
       return false;
     }
 
+    // the scheduler selects by state
+    if ((sqlite3_exec(DB,
+                      "CREATE INDEX if not exists transfers_status on transfers (status, id)",
+                      CallBack, this, &ErrMsg))) {
+      eos_err("unable to create <transfers_status> index - msg=%s\n", ErrMsg);
+      return false;
+    }
+
+    // prepared statements used by the batched scheduling and updates
+    if ((sqlite3_prepare_v2(DB,
+                            "select * from transfers where status=?1 order by id limit ?2",
+                            -1, &SelectStmt, 0) != SQLITE_OK) ||
+        (sqlite3_prepare_v2(DB,
+                            "update transfers set status=coalesce(?1,status), "
+                            "progress=coalesce(?2,progress), expires=coalesce(?3,expires), "
+                            "exechost=coalesce(?4,exechost), log=coalesce(?5,log) where id=?6",
+                            -1, &UpdateStmt, 0) != SQLITE_OK) ||
+        (sqlite3_prepare_v2(DB, "select sync from transfers where id=?1",
+                            -1, &SyncStmt, 0) != SQLITE_OK)) {
+      eos_err("unable to prepare statements - msg=%s\n", sqlite3_errmsg(DB));
+      return false;
+    }
+
     return true;
   } else {
     eos_err("failed to open sqlite3 database file %s - msg=%s\n", dpath.c_str(),
@@ -115,9 +138,197 @@ TransferFsDB::Init(const char* dbpath)
 /*----------------------------------------------------------------------------*/
 TransferFsDB::~TransferFsDB()
 {
+  sqlite3_finalize(SelectStmt);
+  sqlite3_finalize(UpdateStmt);
+  sqlite3_finalize(SyncStmt);
   sqlite3_close(DB);
 }
 
+/*----------------------------------------------------------------------------*/
+bool
+TransferFsDB::Exec(const char* sql)
+{
+  char* errmsg = 0;
+
+  if ((sqlite3_exec(DB, sql, 0, 0, &errmsg))) {
+    eos_err("unable to execute '%s' - msg=%s\n", sql, errmsg ? errmsg : "<none>");
+    sqlite3_free(errmsg);
+    return false;
+  }
+
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+int
+TransferFsDB::GetSyncFlag(long long id)
+{
+  // returns -1 if the transfer does not exist, has to be called with the lock
+  int sync = -1;
+  sqlite3_reset(SyncStmt);
+  sqlite3_bind_int64(SyncStmt, 1, id);
+
+  if (sqlite3_step(SyncStmt) == SQLITE_ROW) {
+    sync = (sqlite3_column_int(SyncStmt, 0) == 1) ? 1 : 0;
+  }
+
+  sqlite3_reset(SyncStmt);
+  return sync;
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+TransferFsDB::Exists(long long id)
+{
+  XrdSysMutexHelper lock(Lock);
+
+  if (!DB) {
+    return false;
+  }
+
+  return (GetSyncFlag(id) >= 0);
+}
+
+/*----------------------------------------------------------------------------*/
+std::vector<TransferDB::transfer_t>
+TransferFsDB::ClaimTransfers(int status, int claimed, size_t max)
+{
+  XrdSysMutexHelper lock(Lock);
+  std::vector<transfer_t> transfers;
+
+  if (!DB || !max || !Exec("BEGIN")) {
+    return transfers;
+  }
+
+  sqlite3_reset(SelectStmt);
+  sqlite3_bind_text(SelectStmt, 1, TransferEngine::GetTransferState(status), -1,
+                    SQLITE_STATIC);
+  sqlite3_bind_int64(SelectStmt, 2, (sqlite3_int64) max);
+  int rc;
+
+  while ((rc = sqlite3_step(SelectStmt)) == SQLITE_ROW) {
+    transfer_t transfer;
+
+    for (int k = 0; k < sqlite3_column_count(SelectStmt); k++) {
+      const unsigned char* value = sqlite3_column_text(SelectStmt, k);
+      transfer[sqlite3_column_name(SelectStmt, k)] = value ? (const char*) value : "";
+    }
+
+    transfers.push_back(transfer);
+  }
+
+  sqlite3_reset(SelectStmt);
+
+  if (rc != SQLITE_DONE) {
+    eos_err("unable to select transfers - msg=%s\n", sqlite3_errmsg(DB));
+    Exec("ROLLBACK");
+    transfers.clear();
+    return transfers;
+  }
+
+  const char* sclaimed = TransferEngine::GetTransferState(claimed);
+
+  for (auto it = transfers.begin(); it != transfers.end(); ++it) {
+    sqlite3_reset(UpdateStmt);
+    sqlite3_clear_bindings(UpdateStmt);
+    sqlite3_bind_text(UpdateStmt, 1, sclaimed, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(UpdateStmt, 6, strtoll((*it)["id"].c_str(), 0, 10));
+
+    if (sqlite3_step(UpdateStmt) != SQLITE_DONE) {
+      eos_err("unable to claim transfers - msg=%s\n", sqlite3_errmsg(DB));
+      sqlite3_reset(UpdateStmt);
+      Exec("ROLLBACK");
+      transfers.clear();
+      return transfers;
+    }
+
+    (*it)["status"] = sclaimed;
+  }
+
+  sqlite3_reset(UpdateStmt);
+
+  if (!Exec("COMMIT")) {
+    Exec("ROLLBACK");
+    transfers.clear();
+  }
+
+  return transfers;
+}
+
+/*----------------------------------------------------------------------------*/
+size_t
+TransferFsDB::ApplyUpdates(const std::vector<Update>& updates)
+{
+  XrdSysMutexHelper lock(Lock);
+  size_t n = 0;
+  std::vector<long long> done;
+
+  if (!DB || updates.empty() || !Exec("BEGIN")) {
+    return 0;
+  }
+
+  for (auto it = updates.begin(); it != updates.end(); ++it) {
+    sqlite3_reset(UpdateStmt);
+    sqlite3_clear_bindings(UpdateStmt);
+
+    if (it->mState >= 0) {
+      sqlite3_bind_text(UpdateStmt, 1, TransferEngine::GetTransferState(it->mState),
+                        -1, SQLITE_STATIC);
+    }
+
+    if (it->mProgress >= 0) {
+      sqlite3_bind_double(UpdateStmt, 2, it->mProgress);
+    }
+
+    if (it->mExpires) {
+      sqlite3_bind_int64(UpdateStmt, 3, (sqlite3_int64) it->mExpires);
+    }
+
+    if (it->mHasExecHost) {
+      sqlite3_bind_text(UpdateStmt, 4, it->mExecHost.c_str(), -1, SQLITE_STATIC);
+    }
+
+    if (it->mHasLog) {
+      sqlite3_bind_text(UpdateStmt, 5, it->mLog.c_str(), -1, SQLITE_STATIC);
+    }
+
+    sqlite3_bind_int64(UpdateStmt, 6, it->mId);
+
+    if (sqlite3_step(UpdateStmt) != SQLITE_DONE) {
+      eos_err("unable to update id=%lld - msg=%s\n", it->mId, sqlite3_errmsg(DB));
+      continue;
+    }
+
+    if (sqlite3_changes(DB)) {
+      n++;
+
+      if (it->mState == TransferEngine::kDone) {
+        done.push_back(it->mId);
+      }
+    }
+  }
+
+  sqlite3_reset(UpdateStmt);
+
+  // auto archive the asynchronous transfers which are done
+  for (auto it = done.begin(); it != done.end(); ++it) {
+    if (GetSyncFlag(*it) == 0) {
+      XrdOucString out, err;
+
+      if (Archive(*it, out, err, true) || Cancel(*it, out, err, true)) {
+        eos_err("failed to auto-archive id=%lld after <done> state", *it);
+      }
+    }
+  }
+
+  if (!Exec("COMMIT")) {
+    Exec("ROLLBACK");
+    return 0;
+  }
+
+  return n;
+}
+
 /*----------------------------------------------------------------------------*/
 int
 TransferFsDB::Ls(XrdOucString& sid, XrdOucString& option, XrdOucString& group,
@@ -31,6 +31,7 @@
 #include <string>
 
 class sqlite3;
+struct sqlite3_stmt;
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -43,6 +44,12 @@ private:
   qr_result_t Qr;
   char* ErrMsg;
   XrdSysMutex Lock;
+  sqlite3_stmt* SelectStmt; ///< select transfers by state ordered by id
+  sqlite3_stmt* UpdateStmt; ///< update any subset of the mutable columns
+  sqlite3_stmt* SyncStmt; ///< select the sync flag of a transfer
+
+  bool Exec(const char* sql);
+  int GetSyncFlag(long long id);
 
 public:
   static int CallBack(void* NotUsed, int argc, char** argv, char** ColName);
@@ -75,6 +82,10 @@ public:
   virtual bool SetLog(long long id, std::string log);
   virtual transfer_t GetNextTransfer(int status);
   virtual transfer_t GetTransfer(long long id, bool nolock = false);
+  virtual bool Exists(long long id);
+  virtual std::vector<transfer_t> ClaimTransfers(int status, int claimed,
+      size_t max);
+  virtual size_t ApplyUpdates(const std::vector<Update>& updates);
 };
 
 EOSMGMNAMESPACE_END
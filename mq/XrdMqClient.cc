@@ -63,6 +63,9 @@ XrdMqClient::XrdMqClient(const char* clientid, const char* brokerurl,
   kMessageBuffer = "";
   kRecvBuffer = nullptr;
   kRecvBufferAlloc = 0;
+  kCompressionThreshold = (getenv("EOS_MQ_COMPRESSION_THRESHOLD") ?
+                           strtoul(getenv("EOS_MQ_COMPRESSION_THRESHOLD"), 0, 10) :
+                           0);
   // Install sigbus signal handler
   struct sigaction act;
   memset(&act, 0, sizeof(act));
@@ -233,6 +236,9 @@ XrdMqClient::SendMessage(XrdMqMessage& msg, const char* receiverid, bool sign,
     msg.kMessageHeader.kReceiverQueue = receiverid;
   }
 
+  // Compress large bodies before they get signed or encrypted
+  msg.Compress(kCompressionThreshold);
+
   if (encrypt) {
     msg.Sign(true);
   } else {
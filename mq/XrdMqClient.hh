@@ -119,6 +119,18 @@ public:
     return kDefaultReceiverQueue;
   }
 
+  //----------------------------------------------------------------------------
+  //! Set the minimum body length of the messages sent compressed
+  //!
+  //! @param threshold body length in bytes, 0 disables the compression. Only
+  //!        enable it if the brokers and the receivers decode compressed
+  //!        message bodies.
+  //----------------------------------------------------------------------------
+  inline void SetCompressionThreshold(size_t threshold)
+  {
+    kCompressionThreshold = threshold;
+  }
+
   //----------------------------------------------------------------------------
   //! Set client id
   //!
@@ -222,6 +234,7 @@ private:
   int kRecvBufferAlloc;
   size_t kInternalBufferPosition;
   bool kInitOK;
+  size_t kCompressionThreshold; ///< min body length sent compressed
 };
 
 
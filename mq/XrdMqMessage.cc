@@ -30,6 +30,8 @@
 #include <stdint.h>
 #include <iostream>
 #include <sstream>
+#include <vector>
+#include <zlib.h>
 #include <openssl/rsa.h>
 #include <openssl/objects.h>
 #include <openssl/x509.h>
@@ -59,6 +61,7 @@ XrdMqMessageHeader::XrdMqMessageHeader():
   kSenderTime_sec(0), kSenderTime_nsec(0), kBrokerTime_sec(0),
   kBrokerTime_nsec(0), kReceiverTime_sec(0), kReceiverTime_nsec(0),
   kMessageSignature(""), kMessageDigest(""), kEncrypted(false), kType(0),
+  kCompressed(0),
   mMsgHdrBuffer(""), kCertificateHash("")
 {
 }
@@ -112,6 +115,12 @@ XrdMqMessageHeader::Encode()
   oss << buff << sep;
   oss << kCertificateHash << sep << kMessageSignature << sep
       << kMessageDigest << sep << kEncrypted << sep << kType << sep;
+
+  // Appended last, so that older decoders ignore it
+  if (kCompressed) {
+    oss << kCompressed << sep;
+  }
+
   mMsgHdrBuffer = oss.str().c_str();
 }
 
@@ -221,6 +230,13 @@ XrdMqMessageHeader::Decode(const char* str_header)
                                       tmpstring.assign(mMsgHdrBuffer, pos, ppos - 1);
                                       pos = ppos + 1;
                                       kType = atoi(tmpstring.c_str());
+                                      kCompressed = 0;
+
+                                      if ((ppos = mMsgHdrBuffer.find(sep, pos)) != STR_NPOS) {
+                                        tmpstring.assign(mMsgHdrBuffer, pos, ppos - 1);
+                                        kCompressed = strtoul(tmpstring.c_str(), 0, 10);
+                                      }
+
                                       return true;
                                     }
                                   }
@@ -270,6 +286,7 @@ XrdMqMessageHeader::Print()
   std::cerr << "kMessageDigest     : " << kMessageDigest << std::endl;
   std::cerr << "kEncrypted         : " << kEncrypted << std::endl;
   std::cerr << "kType              : " << kType << std::endl;
+  std::cerr << "kCompressed        : " << kCompressed << std::endl;
   std::cerr << "mMsgHdrBuffer      : " << mMsgHdrBuffer << std::endl;
   std::cerr << "---------------------------------------------------------------";
   std::cerr << std::endl;
@@ -531,9 +548,93 @@ bool XrdMqMessage::Decode()
   const char* hp = decenv.Get(XMQBODY);
   kMessageBody = (hp ? hp : "");
   kMonitor = (decenv.Get(XMQMONITOR) ? true : false);
+
+  // Signed messages are decompressed by Verify once the signature is checked
+  if (decode_hdr && kMessageHeader.kCompressed &&
+      !kMessageHeader.kEncrypted && !kMessageHeader.kMessageSignature.length()) {
+    return Decompress();
+  }
+
   return decode_hdr;
 }
 
+//------------------------------------------------------------------------------
+// Compress the message body
+//------------------------------------------------------------------------------
+bool
+XrdMqMessage::Compress(size_t threshold)
+{
+  if (!threshold || kMessageHeader.kCompressed ||
+      ((size_t) kMessageBody.length() < threshold)) {
+    return false;
+  }
+
+  // Buffers are reused by the sending thread
+  thread_local std::vector<char> zbuffer;
+  thread_local std::string zbody;
+  uLongf zlen = compressBound(kMessageBody.length());
+
+  if (zbuffer.size() < zlen) {
+    zbuffer.resize(zlen);
+  }
+
+  if (compress2((Bytef*) zbuffer.data(), &zlen,
+                (const Bytef*) kMessageBody.c_str(), kMessageBody.length(),
+                Z_BEST_SPEED) != Z_OK) {
+    return false;
+  }
+
+  if (!Base64Encode(zbuffer.data(), zlen, zbody) ||
+      (zbody.length() >= (size_t) kMessageBody.length())) {
+    return false;
+  }
+
+  kMessageHeader.kCompressed = kMessageBody.length();
+  kMessageBody = zbody.c_str();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Decompress the message body
+//------------------------------------------------------------------------------
+bool
+XrdMqMessage::Decompress()
+{
+  if (!kMessageHeader.kCompressed) {
+    return true;
+  }
+
+  char* zdata = 0;
+  ssize_t zlen = 0;
+
+  if (!Base64Decode(kMessageBody.c_str(), zdata, zlen)) {
+    Eroute.Emsg(__FUNCTION__, EINVAL, "base64 decode compressed message body");
+    free(zdata);
+    return false;
+  }
+
+  // Buffer is reused by the receiving thread
+  thread_local std::vector<char> buffer;
+  uLongf len = kMessageHeader.kCompressed;
+
+  if (buffer.size() <= len) {
+    buffer.resize(len + 1);
+  }
+
+  int rc = uncompress((Bytef*) buffer.data(), &len, (const Bytef*) zdata, zlen);
+  free(zdata);
+
+  if ((rc != Z_OK) || (len != kMessageHeader.kCompressed)) {
+    Eroute.Emsg(__FUNCTION__, EINVAL, "uncompress message body");
+    return false;
+  }
+
+  buffer[len] = 0;
+  kMessageBody = buffer.data();
+  kMessageHeader.kCompressed = 0;
+  return true;
+}
+
 //------------------------------------------------------------------------------
 // Base64 encoding
 //------------------------------------------------------------------------------
@@ -1126,6 +1227,11 @@ bool XrdMqMessage::Verify()
   }
 
   free(sig);
+
+  if (!Decompress()) {
+    return false;
+  }
+
   kMessageBuffer = "";
   kMessageHeader.kMessageSignature = "";
   kMessageHeader.kMessageDigest = "";
@@ -1604,6 +1710,11 @@ bool XrdMqMessage::Verify()
   }
 
   free(sig);
+
+  if (!Decompress()) {
+    return false;
+  }
+
   kMessageBuffer = "";
   kMessageHeader.kMessageSignature = "";
   kMessageHeader.kMessageDigest = "";
@@ -151,6 +151,7 @@ public:
   XrdOucString kMessageDigest; ///< hash of the message body
   bool kEncrypted;///< encrypted with private key or not
   int kType; ///< type of message
+  size_t kCompressed; ///< length of the body before compression, 0 if plain
 
 private:
   XrdOucString mMsgHdrBuffer; ///< message header buffer
@@ -312,6 +313,24 @@ public:
   static bool RSADecrypt(char* encrypted_data, ssize_t encrypted_length,
                          char*& data, ssize_t& data_length, XrdOucString& key_hash);
 
+  //----------------------------------------------------------------------------
+  //! Compress the message body with zlib if it is at least threshold bytes
+  //! long and the compressed and base64 encoded body is shorter. Has to be
+  //! called before Sign or Encode.
+  //!
+  //! @param threshold minimum body length, 0 disables the compression
+  //!
+  //! @return true if the body was compressed, otherwise false
+  //----------------------------------------------------------------------------
+  bool Compress(size_t threshold);
+
+  //----------------------------------------------------------------------------
+  //! Decompress the message body if the header flags it as compressed
+  //!
+  //! @return true if successful or the body is not compressed, otherwise false
+  //----------------------------------------------------------------------------
+  bool Decompress();
+
   //----------------------------------------------------------------------------
   //! Sign message object
   //!
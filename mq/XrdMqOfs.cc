@@ -36,6 +36,7 @@
 #include "mq/XrdMqOfsTrace.hh"
 #include "common/PasswordHandler.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
+#include <algorithm>
 #include <pwd.h>
 #include <grp.h>
 #include <signal.h>
@@ -203,19 +204,8 @@ XrdMqOfsFile::read(XrdSfsFileOffset fileOffset, char* buffer,
   ZTRACE(read, "read");
 
   if (mMsgOut) {
-    unsigned int mlen = mMsgOut->mMsgBuffer.length();
     ZTRACE(read, "reading size:" << buffer_size);
-
-    if ((unsigned long) buffer_size < mlen) {
-      memcpy(buffer, mMsgOut->mMsgBuffer.c_str(), buffer_size);
-      mMsgOut->mMsgBuffer.erase(0, buffer_size);
-      return buffer_size;
-    } else {
-      memcpy(buffer, mMsgOut->mMsgBuffer.c_str(), mlen);
-      mMsgOut->mMsgBuffer.clear();
-      mMsgOut->mMsgBuffer.reserve(0);
-      return mlen;
-    }
+    return mMsgOut->ReadBuffer(buffer, (buffer_size > 0 ? buffer_size : 0));
   }
 
   error.setErrInfo(-1, "");
@@ -307,9 +297,12 @@ XrdSfsFileSystem* XrdSfsGetFileSystem(XrdSfsFileSystem* native_fs,
 // Constructor
 //------------------------------------------------------------------------------
 XrdMqOfs::XrdMqOfs(XrdSysError* ep):
-  myPort(1097), mDeliveredMessages(0ull), mFanOutMessages(0ull),
+  myPort(1097), mMessageBytes(0ull), mDeliveredMessages(0ull),
+  mFanOutMessages(0ull),
   mMaxQueueBacklog(MQOFSMAXQUEUEBACKLOG),
-  mRejectQueueBacklog(MQOFSREJECTQUEUEBACKLOG), mQdbCluster(), mQdbPassword(),
+  mRejectQueueBacklog(MQOFSREJECTQUEUEBACKLOG),
+  mMaxMessageBytes(MQOFSMAXMESSAGEBYTES),
+  mRejectQueueBytes(MQOFSREJECTQUEUEBYTES), mQdbCluster(), mQdbPassword(),
   mQdbContactDetails(), mQcl(nullptr), mMasterId(), mMgmId()
 {
   ConfigFN  = 0;
@@ -429,6 +422,22 @@ int XrdMqOfs::Configure(XrdSysError& Eroute)
           }
         }
 
+        if (!strcmp("maxmessagebytes", var)) {
+          if ((val = Config.GetWord())) {
+            uint64_t tmp_val {0};
+            (void) sscanf(val, "%lu", &tmp_val);
+            mMaxMessageBytes = tmp_val;
+          }
+        }
+
+        if (!strcmp("rejectqueuebytes", var)) {
+          if ((val = Config.GetWord())) {
+            uint64_t tmp_val {0};
+            (void) sscanf(val, "%lu", &tmp_val);
+            mRejectQueueBytes = tmp_val;
+          }
+        }
+
         if (!strcmp("trace", var)) {
           if ((val = Config.GetWord())) {
             auto& g_logging = eos::common::Logging::GetInstance();
@@ -713,6 +722,8 @@ XrdMqOfs::Statistics()
       rc = write(fd, line, strlen(line));
       sprintf(line, "mq.queued                 %d\n", (int)Messages.size());
       rc = write(fd, line, strlen(line));
+      sprintf(line, "mq.queued_bytes           %lu\n", mMessageBytes.load());
+      rc = write(fd, line, strlen(line));
       sprintf(line, "mq.nqueues                %d\n", (int)mQueueOut.size());
       rc = write(fd, line, strlen(line));
       sprintf(line, "mq.backloghits            %lld\n", QueueBacklogHits);
@@ -1095,7 +1106,8 @@ XrdMqOfs::FSctl(const int cmd, XrdSfsFSctl& args, XrdOucErrInfo& error,
   }
 
   // check for backlog
-  if ((long long)Messages.size() > MaxMessageBacklog) {
+  if (((long long)Messages.size() > MaxMessageBacklog) ||
+      (mMaxMessageBytes && (mMessageBytes > mMaxMessageBytes))) {
     // this is not absolutely threadsafe .... better would lock
     BacklogDeferred++;
     gMqFS->Emsg(epname, error, ENOMEM, "accept message - too many pending messages",
@@ -1127,19 +1139,11 @@ XrdMqOfs::FSctl(const int cmd, XrdSfsFSctl& args, XrdOucErrInfo& error,
 
   ZTRACE(fsctl, path.c_str());
   ZTRACE(fsctl, opaque.c_str());
-  XrdSmartOucEnv* env = new XrdSmartOucEnv(opaque.c_str());
-
-  if (!env) {
-    gMqFS->Emsg(epname, error, ENOMEM, "allocate memory", "");
-    return SFS_ERROR;
-  }
-
   // look into the header
   XrdMqMessageHeader mh;
 
   if (!mh.Decode(opaque.c_str())) {
     gMqFS->Emsg(epname, error, EINVAL, "decode message header", "");
-    delete env;
     return SFS_ERROR;
   }
 
@@ -1151,15 +1155,13 @@ XrdMqOfs::FSctl(const int cmd, XrdSfsFSctl& args, XrdOucErrInfo& error,
   //mh.Print();
   // encode the new values
   mh.Encode();
-  // replace the old header with the new one .... that's ugly :-(
-  int envlen;
-  XrdOucString envstring = env->Env(envlen);
-  int p1 = envstring.find(XMQHEADER);
-  int p2 = envstring.find("&", p1 + 1);
-  envstring.erase(p1, p2 - 1);
-  envstring.insert(mh.GetHeaderBuffer(), p1);
-  delete env;
-  env = new XrdSmartOucEnv(envstring.c_str());
+  // replace the old header with the new one and parse the message only once,
+  // the resulting object is shared by all the receiver queues
+  int p1 = opaque.find(XMQHEADER);
+  int p2 = opaque.find("&", p1 + 1);
+  opaque.erase(p1, p2 - 1);
+  opaque.insert(mh.GetHeaderBuffer(), p1);
+  XrdSmartOucEnv* env = new XrdSmartOucEnv(opaque.c_str());
   XrdMqOfsMatches matches(mh.kReceiverQueue.c_str(), env, tident, mh.kType,
                           mh.kSenderId.c_str());
   Deliver(matches);
@@ -1329,6 +1331,7 @@ XrdMqOfs::Deliver(XrdMqOfsMatches& Matches)
   if (matched_out_queues.size()) {
     Matches.backlog = false;
     Matches.backlogrejected = false;
+    uint64_t msg_size = 0;
 
     // Lock all matched queues at once
     for (auto msg_out : matched_out_queues) {
@@ -1362,7 +1365,8 @@ XrdMqOfs::Deliver(XrdMqOfsMatches& Matches)
         }
       }
 
-      if (msg_out->mMsgQueue.size() > mRejectQueueBacklog) {
+      if ((msg_out->mMsgQueue.size() > mRejectQueueBacklog) ||
+          (mRejectQueueBytes && (msg_out->mQueuedBytes > mRejectQueueBytes))) {
         // Only set the reject flag if the queue has not set the advisory
         // flush back log flag
         if (!msg_out->AdvisoryFlushBackLog) {
@@ -1392,14 +1396,19 @@ XrdMqOfs::Deliver(XrdMqOfsMatches& Matches)
 
           if (Matches.matches == 1) {
             // add to the message hash
+            msg_size = Matches.message->Size();
             std::string messageid = Matches.message->Get(XMQHEADER);
             XrdSysMutexHelper scope_lock(gMqFS->mMsgsMutex);
-            gMqFS->Messages.insert(std::pair<std::string, XrdSmartOucEnv*> (messageid,
-                                   Matches.message));
+
+            if (gMqFS->Messages.insert(std::pair<std::string, XrdSmartOucEnv*>
+                                       (messageid, Matches.message)).second) {
+              gMqFS->mMessageBytes += msg_size;
+            }
           }
 
           ZTRACE(fsctl, "Adding Message to Queuename: " << msg_out->QueueName.c_str());
           msg_out->mMsgQueue.push_back(Matches.message);
+          msg_out->mQueuedBytes += msg_size;
           Matches.message->AddRefs(1);
         }
       }
@@ -1430,6 +1439,12 @@ XrdMqMessageOut::RetrieveMessages()
   XrdSmartOucEnv* message {nullptr};
   XrdSysMutexHelper scope_lock(mMutex);
 
+  // Drop the part already read by the client before appending new data
+  if (mReadOffset) {
+    mMsgBuffer.erase(0, mReadOffset);
+    mReadOffset = 0;
+  }
+
   while (mMsgQueue.size()) {
     message = mMsgQueue.front();
     mMsgQueue.pop_front();
@@ -1446,7 +1461,10 @@ XrdMqMessageOut::RetrieveMessages()
       std::string msg_id = message->Get(XMQHEADER);
       {
         XrdSysMutexHelper scope_lock(gMqFS->mMsgsMutex);
-        gMqFS->Messages.erase(msg_id.c_str());
+
+        if (gMqFS->Messages.erase(msg_id.c_str())) {
+          gMqFS->mMessageBytes -= (len > 0 ? len : 0);
+        }
       }
       message->procmutex.UnLock();
       // fprintf(stderr,"%s delete %llu \n", QueueName.c_str(),
@@ -1458,5 +1476,27 @@ XrdMqMessageOut::RetrieveMessages()
     }
   }
 
+  mQueuedBytes = 0;
   return mMsgBuffer.length();
 }
+
+//------------------------------------------------------------------------------
+// Copy data not yet read from the internal buffer
+//------------------------------------------------------------------------------
+size_t
+XrdMqMessageOut::ReadBuffer(char* buffer, size_t length)
+{
+  XrdSysMutexHelper scope_lock(mMutex);
+  size_t avail = mMsgBuffer.length() - mReadOffset;
+  size_t nread = std::min(length, avail);
+  memcpy(buffer, mMsgBuffer.c_str() + mReadOffset, nread);
+  mReadOffset += nread;
+
+  if (mReadOffset == mMsgBuffer.length()) {
+    mMsgBuffer.clear();
+    mMsgBuffer.shrink_to_fit();
+    mReadOffset = 0;
+  }
+
+  return nread;
+}
@@ -49,6 +49,8 @@
 #define MQOFSMAXMESSAGEBACKLOG 100000
 #define MQOFSMAXQUEUEBACKLOG 50000
 #define MQOFSREJECTQUEUEBACKLOG 100000
+#define MQOFSMAXMESSAGEBYTES (8ull * 1024 * 1024 * 1024)
+#define MQOFSREJECTQUEUEBYTES (1ull * 1024 * 1024 * 1024)
 
 #define MAYREDIRECT {                                         \
     int port=0;                                               \
@@ -95,6 +97,16 @@ public:
     nref += nrefs;
   }
 
+  //----------------------------------------------------------------------------
+  //! Get the size of the message payload
+  //----------------------------------------------------------------------------
+  uint64_t Size()
+  {
+    int len = 0;
+    (void) Env(len);
+    return (len > 0 ? len : 0);
+  }
+
   XrdSysMutex procmutex;
 
 private:
@@ -144,7 +156,8 @@ public:
   //----------------------------------------------------------------------------
   XrdMqMessageOut(const char* queuename):
     AdvisoryStatus(false), AdvisoryQuery(false), AdvisoryFlushBackLog(false),
-    BrokenByFlush(false), QueueName(queuename), mMsgBuffer("")
+    BrokenByFlush(false), QueueName(queuename), mMsgBuffer(""),
+    mReadOffset(0), mQueuedBytes(0)
   {
     mMsgQueue.clear();
   }
@@ -177,18 +190,30 @@ public:
   //! Collect all messages from the queue and append them to the internal
   //! buffer. Also delete messages if this was the last reference towards them.
   //!
-  //! @return size of the internal buffer
+  //! @return size of the data not yet read from the internal buffer
   //----------------------------------------------------------------------------
   size_t RetrieveMessages();
 
+  //----------------------------------------------------------------------------
+  //! Copy data not yet read from the internal buffer
+  //!
+  //! @param buffer output buffer
+  //! @param length size of the output buffer
+  //!
+  //! @return number of bytes copied
+  //----------------------------------------------------------------------------
+  size_t ReadBuffer(char* buffer, size_t length);
+
   bool AdvisoryStatus;
   bool AdvisoryQuery;
   bool AdvisoryFlushBackLog;
   bool BrokenByFlush;
   XrdOucString QueueName;
   std::string mMsgBuffer;
+  size_t mReadOffset; ///< Part of mMsgBuffer already read by the client
   XrdSysSemWait DeletionSem;
   std::deque<XrdSmartOucEnv*> mMsgQueue;
+  uint64_t mQueuedBytes; ///< Payload size of the messages in mMsgQueue
 
 private:
   mutable XrdSysMutex mMutex; ///< Mutex protecting access to the msg queue
@@ -382,6 +407,7 @@ public:
   XrdOucString QueueAdvisory; ///< "<queueprefix>/*" for advisory message matches
   XrdOucString BrokerId; ///< Manger id + queue name as path
   std::map<std::string, XrdSmartOucEnv*> Messages; ///< Hash with all messages
+  std::atomic<uint64_t> mMessageBytes; ///< Payload size of all messages
   XrdSysMutex mMsgsMutex;  ///< Mutex protecting the message hash
 
   XrdSysMutex  StatLock;
@@ -399,6 +425,8 @@ public:
   long long    MaxMessageBacklog;
   uint64_t     mMaxQueueBacklog;
   uint64_t     mRejectQueueBacklog;
+  uint64_t     mMaxMessageBytes; ///< Max payload size of all pending messages
+  uint64_t     mRejectQueueBytes; ///< Max payload size pending on one queue
   void         Statistics();
   XrdOucString StatisticsFile;
   char*         ConfigFN;
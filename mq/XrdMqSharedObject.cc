@@ -30,6 +30,8 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 #include <curl/curl.h>
 
 using eos::common::RWMutexReadLock;
@@ -51,6 +53,7 @@ XrdMqSharedObjectChangeNotifier::tlSubscriber = NULL;
 #define _NotifierMapUpdate(map,key,subscriber)     \
   {                                                \
   auto entry = map.find(key);                      \
+  mRegexItemsDirty = true;                         \
   if( entry != map.end() ) {                       \
     entry->second.mSubscribers.erase(subscriber);  \
     if(entry->second.mSubscribers.empty()) {       \
@@ -176,6 +179,142 @@ XrdMqSharedHashEntry::Dump(XrdOucString& out)
 //                 * * * Class XrdMqSharedObjectHash * * *
 //------------------------------------------------------------------------------
 
+//------------------------------------------------------------------------------
+// Append a varint to the output
+//------------------------------------------------------------------------------
+static void
+AppendVarint(std::string& out, unsigned long long val)
+{
+  while (val >= 0x80) {
+    out += (char)((val & 0x7f) | 0x80);
+    val >>= 7;
+  }
+
+  out += (char) val;
+}
+
+//------------------------------------------------------------------------------
+// Read a varint from the input, returns false if the input is truncated
+//------------------------------------------------------------------------------
+static bool
+ReadVarint(const char*& ptr, const char* end, unsigned long long& val)
+{
+  val = 0;
+
+  for (int shift = 0; (ptr < end) && (shift < 64); shift += 7) {
+    unsigned char byte = (unsigned char) * ptr++;
+    val |= ((unsigned long long)(byte & 0x7f)) << shift;
+
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Check if the binary encoding of the updates is enabled
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedHash::IsBinaryEncodingEnabled()
+{
+  static bool sEnabled = []() {
+    const char* ptr = getenv("EOS_MQ_SHAREDHASH_BINARY");
+    return (!ptr || (strtol(ptr, nullptr, 10) != 0));
+  }();
+  return sEnabled;
+}
+
+//------------------------------------------------------------------------------
+// Encode pairs in the binary format
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHash::EncodeBinaryPairs(const std::vector<Pair>& pairs,
+                                   std::string& out)
+{
+  static constexpr char sVersion = 1;
+  const std::string* prev = nullptr;
+  out += sVersion;
+  AppendVarint(out, pairs.size());
+
+  for (const auto& pair : pairs) {
+    size_t common = 0;
+
+    if (prev) {
+      size_t max_common = std::min(prev->length(), pair.mKey.length());
+
+      while ((common < max_common) && ((*prev)[common] == pair.mKey[common])) {
+        ++common;
+      }
+    }
+
+    AppendVarint(out, common);
+    AppendVarint(out, pair.mKey.length() - common);
+    out.append(pair.mKey, common, std::string::npos);
+    AppendVarint(out, pair.mValue.length());
+    out += pair.mValue;
+    AppendVarint(out, pair.mChangeId);
+    prev = &pair.mKey;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Decode pairs in binary format
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedHash::DecodeBinaryPairs(const char* in, size_t len,
+                                   std::vector<Pair>& pairs)
+{
+  const char* ptr = in;
+  const char* end = in + len;
+  unsigned long long count = 0;
+  pairs.clear();
+
+  if ((ptr == end) || (*ptr++ != 1) || !ReadVarint(ptr, end, count)) {
+    return false;
+  }
+
+  // Every pair takes at least 4 bytes, don't trust the count blindly
+  if (count > len) {
+    return false;
+  }
+
+  pairs.resize(count);
+
+  for (size_t i = 0; i < count; ++i) {
+    unsigned long long common, key_len, value_len;
+
+    if (!ReadVarint(ptr, end, common) ||
+        (common > (i ? pairs[i - 1].mKey.length() : 0)) ||
+        !ReadVarint(ptr, end, key_len) ||
+        (key_len > (unsigned long long)(end - ptr))) {
+      return false;
+    }
+
+    if (common) {
+      pairs[i].mKey.assign(pairs[i - 1].mKey, 0, common);
+    }
+
+    pairs[i].mKey.append(ptr, key_len);
+    ptr += key_len;
+
+    if (!ReadVarint(ptr, end, value_len) ||
+        (value_len > (unsigned long long)(end - ptr))) {
+      return false;
+    }
+
+    pairs[i].mValue.assign(ptr, value_len);
+    ptr += value_len;
+
+    if (!ReadVarint(ptr, end, pairs[i].mChangeId)) {
+      return false;
+    }
+  }
+
+  return (ptr == end);
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -213,6 +352,8 @@ XrdMqSharedHash::operator=(XrdMqSharedHash&& other)
     std::swap(mStore, other.mStore);
     std::swap(mDeletions, other.mDeletions);
     std::swap(mTransactions, other.mTransactions);
+    std::swap(mBinaryPeers, other.mBinaryPeers);
+    std::swap(mEnvPeers, other.mEnvPeers);
     std::swap(mTransactMutex, other.mTransactMutex);
     std::swap(mStoreMutex, other.mStoreMutex);
   }
@@ -409,7 +550,7 @@ XrdMqSharedHash::CloseTransaction()
   if (mSOM->mBroadcast && mTransactions.size()) {
     XrdOucString txmessage = "";
     MakeUpdateEnvHeader(txmessage);
-    AddTransactionsToEnvString(txmessage, false);
+    AddTransactionsToEnvString(txmessage, false, UseBinaryEncoding());
 
     if (txmessage.length() > (2 * 1000 * 1000)) {
       // Set the message size limit to 2M, if the message is bigger then just
@@ -537,11 +678,24 @@ XrdMqSharedHash::MakeRemoveEnvHeader(XrdOucString& out)
 // Broadcast hash as env string
 //-------------------------------------------------------------------------------
 bool
-XrdMqSharedHash::BroadCastEnvString(const char* receiver)
+XrdMqSharedHash::BroadCastEnvString(const char* receiver, bool binary)
 {
   XrdOucString txmessage = "";
+  binary = (binary && IsBinaryEncodingEnabled());
   {
     XrdSysMutexHelper lock(*mTransactMutex);
+
+    if (receiver && strlen(receiver)) {
+      // Remember how the peer wants the updates to be encoded
+      if (binary) {
+        mEnvPeers.erase(receiver);
+        mBinaryPeers.insert(receiver);
+      } else {
+        mBinaryPeers.erase(receiver);
+        mEnvPeers.insert(receiver);
+      }
+    }
+
     mTransactions.clear();
     mIsTransaction = true;
     {
@@ -553,7 +707,7 @@ XrdMqSharedHash::BroadCastEnvString(const char* receiver)
     }
     MakeBroadCastEnvHeader(txmessage);
     // This will also clear the mTransactions set
-    AddTransactionsToEnvString(txmessage);
+    AddTransactionsToEnvString(txmessage, true, binary);
     mIsTransaction = false;
   }
 
@@ -579,8 +733,42 @@ XrdMqSharedHash::BroadCastEnvString(const char* receiver)
 // mTransactMutex locked.
 //-------------------------------------------------------------------------------
 void
-XrdMqSharedHash::AddTransactionsToEnvString(XrdOucString& out, bool clear_after)
+XrdMqSharedHash::AddTransactionsToEnvString(XrdOucString& out, bool clear_after,
+    bool binary)
 {
+  if (binary) {
+    // Encode transactions as "mqsh.bpairs=<base64 of the binary pairs>"
+    std::vector<Pair> pairs;
+    pairs.reserve(mTransactions.size());
+    {
+      RWMutexReadLock rd_lock(*mStoreMutex);
+
+      for (auto it = mTransactions.begin(); it != mTransactions.end(); ++it) {
+        auto it_store = mStore.find(*it);
+
+        if (it_store != mStore.end()) {
+          pairs.push_back(Pair{*it, it_store->second.GetValue(),
+                               it_store->second.GetChangeId()});
+        }
+      }
+    }
+    std::string bin, b64;
+    EncodeBinaryPairs(pairs, bin);
+
+    if (XrdMqMessage::Base64Encode(bin.c_str(), bin.length(), b64)) {
+      out += "&";
+      out += XRDMQSHAREDHASH_BPAIRS;
+      out += "=";
+      out += b64.c_str();
+
+      if (clear_after) {
+        mTransactions.clear();
+      }
+
+      return;
+    }
+  }
+
   // Encode transactions as
   // "mysh.pairs=|<key1>~<value1>%<changeid1>|<key2>~<value2>%<changeid2 ..."
   out += "&";
@@ -606,6 +794,16 @@ XrdMqSharedHash::AddTransactionsToEnvString(XrdOucString& out, bool clear_after)
   }
 }
 
+//-------------------------------------------------------------------------------
+// Check if the updates sent to the broadcast queue can use the binary encoding
+//-------------------------------------------------------------------------------
+bool
+XrdMqSharedHash::UseBinaryEncoding() const
+{
+  return (IsBinaryEncodingEnabled() && !mBinaryPeers.empty() &&
+          mEnvPeers.empty());
+}
+
 //-------------------------------------------------------------------------------
 // Encode deletions as env string - this must be called with the mTransactMutex
 // locked.
@@ -647,6 +845,13 @@ XrdMqSharedHash::BroadcastRequest(const char* req_target)
   out += XRDMQSHAREDHASH_TYPE;
   out += "=";
   out += mType.c_str();
+
+  if (IsBinaryEncodingEnabled()) {
+    out += "&";
+    out += XRDMQSHAREDHASH_ENCODING;
+    out += "=binary";
+  }
+
   message.SetBody(out.c_str());
   message.MarkAsMonitor();
   return XrdMqMessaging::gMessageClient.SendMessage(message, req_target, false,
@@ -1610,6 +1815,7 @@ XrdMqSharedObjectChangeNotifier::StartNotifyKeyRegex(Subscriber* subscriber,
     XrdMqSharedObjectChangeNotifier::notification_t type)
 {
   XrdSysMutexHelper lock(WatchMutex);
+  mRegexItemsDirty = true;
   bool res = (WatchKeys2Subscribers[type][key].mSubscribers.insert(
                 subscriber)).second;
 
@@ -1668,6 +1874,7 @@ XrdMqSharedObjectChangeNotifier::StartNotifySubjectRegex(Subscriber* subscriber,
     XrdMqSharedObjectChangeNotifier::notification_t type)
 {
   XrdSysMutexHelper lock(WatchMutex);
+  mRegexItemsDirty = true;
   bool res = (WatchSubjects2Subscribers[type][subject].mSubscribers.insert(
                 subscriber)).second;
 
@@ -2028,6 +2235,7 @@ XrdMqSharedObjectChangeNotifier::StartNotifyCurrentThread()
     XrdSysMutexHelper lock1(tlSubscriber->WatchMutex);
     {
       XrdSysMutexHelper lock2(WatchMutex);
+      mRegexItemsDirty = true;
 
       for (int type = 0; type < 5; type++) {
         for (auto it = tlSubscriber->WatchKeys[type].begin();
@@ -2161,6 +2369,32 @@ XrdMqSharedObjectChangeNotifier::StopNotifyCurrentThread()
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Rebuild the list of regex watch items
+//------------------------------------------------------------------------------
+void
+XrdMqSharedObjectChangeNotifier::RebuildRegexItems()
+{
+  for (int type = 0; type < 5; ++type) {
+    mKeyRegexItems[type].clear();
+    mSubjectRegexItems[type].clear();
+
+    for (auto& elem : WatchKeys2Subscribers[type]) {
+      if (elem.second.mRegex) {
+        mKeyRegexItems[type].push_back(&elem.second);
+      }
+    }
+
+    for (auto& elem : WatchSubjects2Subscribers[type]) {
+      if (elem.second.mRegex) {
+        mSubjectRegexItems[type].push_back(&elem.second);
+      }
+    }
+  }
+
+  mRegexItemsDirty = false;
+}
+
 /*----------------------------------------------------------------------------*/
 void
 XrdMqSharedObjectChangeNotifier::SomListener(ThreadAssistant& assistant)
@@ -2168,6 +2402,10 @@ noexcept
 {
   // thread listening on filesystem errors and configuration changes
   eos_static_info("%s", "mgm=\"starting SOM listener\"");
+  std::deque<XrdMqSharedObjectManager::Notification> events;
+  std::unordered_set<std::string> modified;
+  std::unordered_map<Subscriber*,
+      std::vector<XrdMqSharedObjectManager::Notification>> pending;
 
   while (!assistant.terminationRequested()) {
     SOM->SubjectsSem.Wait();
@@ -2177,20 +2415,43 @@ noexcept
       break;
     }
 
-    // we always take a lock to take something from the queue and then release it
-    WatchMutex.Lock();
+    // Take all the queued notifications at once
     SOM->mSubjectsMutex.Lock();
-    std::set<Subscriber*> notifiedSubscribers;
-
-    while (SOM->NotificationSubjects.size()) {
-      XrdMqSharedObjectManager::Notification event;
-      event = SOM->NotificationSubjects.front();
-      SOM->NotificationSubjects.pop_front();
-      SOM->mSubjectsMutex.UnLock();
-      std::string newsubject = event.mSubject;
-      //eos_static_debug("SOM Listener new notification %d on %s",
-      // event.mType,event.mSubject.c_str());
+    events.swap(SOM->NotificationSubjects);
+    SOM->mSubjectsMutex.UnLock();
+
+    if (events.empty()) {
+      continue;
+    }
+
+    XrdSysMutexHelper lock(WatchMutex);
+
+    if (mRegexItemsDirty) {
+      RebuildRegexItems();
+    }
+
+    modified.clear();
+    unsigned long long coalesced = 0;
+
+    for (auto& event : events) {
+      // Repeated modifications of the same key are delivered only once per
+      // batch, the subscribers read the current value anyway
+      if (event.mType == XrdMqSharedObjectManager::kMqSubjectModification) {
+        if (!modified.insert(event.mSubject).second) {
+          ++coalesced;
+          continue;
+        }
+      } else {
+        modified.clear();
+      }
+
+      const std::string& newsubject = event.mSubject;
       int type = static_cast<int>(event.mType);
+
+      if ((type < 0) || (type > 3)) {
+        continue;
+      }
+
       std::set<Subscriber*> notifiedSubscribersForCurrentEvent;
       std::string key = newsubject;
       std::string queue = newsubject;
@@ -2205,155 +2466,77 @@ noexcept
       std::string newVal;
       bool newValAsserted = false;
       bool isNewVal = false;
+      // Check if the value really changed, only used for strict modifications
+      auto is_strict_change = [&]() {
+        if (!newValAsserted) {
+          SOM->HashMutex.LockRead();
+          XrdMqSharedHash* hash = SOM->GetObject(queue.c_str(), "hash");
+          SOM->HashMutex.UnLockRead();
+
+          if (!hash) {
+            return false;
+          }
+
+          newVal = hash->Get(key.c_str());
+          auto lvIt = LastValues.find(newsubject);
+          isNewVal = ((lvIt == LastValues.end()) || (lvIt->second != newVal));
+          newValAsserted = true;
+
+          if (isNewVal) {
+            LastValues[newsubject] = newVal;
+          }
+        }
+
+        return isNewVal;
+      };
+      // Queue the event for the subscribers, at most once per subscriber
+      auto notify = [&](const std::set<Subscriber*>& subscribers) {
+        for (auto subscriber : subscribers) {
+          if (notifiedSubscribersForCurrentEvent.insert(subscriber).second) {
+            pending[subscriber].push_back(event);
+          }
+        }
+      };
 
       do {
-        // Check if there is a matching key
-        for (auto it = WatchKeys2Subscribers[type].begin();
-             it != WatchKeys2Subscribers[type].end(); ++it) {
-          if (((it->second.mRegex == NULL) && (key == it->first)) ||
-              ((it->second.mRegex != NULL) &&
-               !regexec(it->second.mRegex, key.c_str(), 0, NULL, 0))) {
-            if (type == 4) {
-              if (!newValAsserted) {
-                auto lvIt = LastValues.find(newsubject);
-                SOM->HashMutex.LockRead();
-                XrdMqSharedHash* hash = SOM->GetObject(queue.c_str(), "hash");
-                SOM->HashMutex.UnLockRead();
-
-                if (hash) {
-                  newVal = hash->Get(key.c_str());
-
-                  if (lvIt == LastValues.end() || lvIt->second != newVal) {
-                    isNewVal = true;
-                  }
-
-                  newValAsserted = true;
-                } else {
-                  continue;
-                }
-              }
+        // Check if there is a matching key, exact ones first
+        auto it_key = WatchKeys2Subscribers[type].find(key);
 
-              if (isNewVal) {
-                // eos_static_debug("notification on %s : new value %s IS a"
-                // "strict change",newsubject.c_str(),newVal.c_str());
-                LastValues[newsubject] = newVal;
-              } else {
-                //eos_static_debug("notification on %s : new value %s IS NOT"
-                //" a strict change",newsubject.c_str(),newVal.c_str());
-                continue;
-              }
-            }
+        if ((it_key != WatchKeys2Subscribers[type].end()) &&
+            (it_key->second.mRegex == NULL) &&
+            ((type != 4) || is_strict_change())) {
+          notify(it_key->second.mSubscribers);
+        }
 
-            for (auto it2 = it->second.mSubscribers.begin();
-                 it2 != it->second.mSubscribers.end(); ++it2) {
-              (*it2)->mSubjMtx.Lock();
-              (*it2)->NotificationSubjects.push_back(event);
-              (*it2)->mSubjMtx.UnLock();
-              notifiedSubscribersForCurrentEvent.insert(*it2);
-              notifiedSubscribers.insert(*it2);
-            }
+        for (auto item : mKeyRegexItems[type]) {
+          if (!regexec(item->mRegex, key.c_str(), 0, NULL, 0) &&
+              ((type != 4) || is_strict_change())) {
+            notify(item->mSubscribers);
           }
         }
 
         // Check if there is a matching subject
-        for (auto it = WatchSubjects2Subscribers[type].begin();
-             it != WatchSubjects2Subscribers[type].end(); ++it) {
-          if (((it->second.mRegex == NULL) && (queue == it->first)) ||
-              ((it->second.mRegex != NULL) &&
-               !regexec(it->second.mRegex, queue.c_str(), 0, NULL, 0))) {
-            if (type == 4) {
-              if (!newValAsserted) {
-                auto lvIt = LastValues.find(newsubject);
-                SOM->HashMutex.LockRead();
-                XrdMqSharedHash* hash = SOM->GetObject(queue.c_str(), "hash");
-                SOM->HashMutex.UnLockRead();
-
-                if (hash) {
-                  newVal = hash->Get(key.c_str());
-
-                  if (lvIt == LastValues.end() || lvIt->second != newVal) {
-                    isNewVal = true;
-                  }
-
-                  newValAsserted = true;
-                }
-              }
+        auto it_subj = WatchSubjects2Subscribers[type].find(queue);
 
-              if (isNewVal) {
-                // eos_static_debug("notification on %s : new value %s IS a "
-                // "strict change",newsubject.c_str(),newVal.c_str());
-                LastValues[newsubject] = newVal;
-              } else {
-                //eos_static_debug("notification on %s : new value %s IS NOT "
-                // "a strict change",newsubject.c_str(),newVal.c_str());
-                continue;
-              }
-            }
+        if ((it_subj != WatchSubjects2Subscribers[type].end()) &&
+            (it_subj->second.mRegex == NULL) &&
+            ((type != 4) || is_strict_change())) {
+          notify(it_subj->second.mSubscribers);
+        }
 
-            for (auto it2 = it->second.mSubscribers.begin();
-                 it2 != it->second.mSubscribers.end(); ++it2) {
-              if (notifiedSubscribersForCurrentEvent.count(*it2) == 0) {
-                // Don't notify twice for the same event
-                (*it2)->mSubjMtx.Lock();
-                (*it2)->NotificationSubjects.push_back(event);
-                (*it2)->mSubjMtx.UnLock();
-                notifiedSubscribersForCurrentEvent.insert(*it2);
-                notifiedSubscribers.insert(*it2);
-              }
-            }
-          } else {
-            // eos_static_info("regex %s DID NOT MATCH %s",it->first.c_str(),
-            // queue.c_str());
+        for (auto item : mSubjectRegexItems[type]) {
+          if (!regexec(item->mRegex, queue.c_str(), 0, NULL, 0) &&
+              ((type != 4) || is_strict_change())) {
+            notify(item->mSubscribers);
           }
         }
 
         // Check if there is a matching subjectXkey
         for (auto it = WatchSubjectsXKeys2Subscribers[type].begin();
              it != WatchSubjectsXKeys2Subscribers[type].end(); ++it) {
-          if (it->first.first.count(queue) && it->first.second.count(key)) {
-            if (type == 4) {
-              if (!newValAsserted) {
-                auto lvIt = LastValues.find(newsubject);
-                SOM->HashMutex.LockRead();
-                XrdMqSharedHash* hash = SOM->GetObject(queue.c_str(), "hash");
-                SOM->HashMutex.UnLockRead();
-
-                if (hash) {
-                  newVal = hash->Get(key.c_str());
-
-                  if (lvIt == LastValues.end() || lvIt->second != newVal) {
-                    isNewVal = true;
-                  }
-
-                  newValAsserted = true;
-                } else {
-                  continue;
-                }
-              }
-
-              if (isNewVal) {
-                //if(key=="id") {
-                // eos_static_warning("WARNING ID CHANGE in queue %s FROM %s "
-                // "to %s",queue.c_str(),LastValues[newsubject].c_str(),newVal.c_str());
-                //}
-                LastValues[newsubject] = newVal;
-              } else {
-                // eos_static_info("notification on %s : new value %s IS NOT "
-                // "a strict change",newsubject.c_str(),newVal.c_str());
-                continue;
-              }
-            }
-
-            for (auto it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
-              if (notifiedSubscribersForCurrentEvent.count(*it2) == 0) {
-                // Don't notify twice for the same event
-                (*it2)->mSubjMtx.Lock();
-                (*it2)->NotificationSubjects.push_back(event);
-                (*it2)->mSubjMtx.UnLock();
-                notifiedSubscribersForCurrentEvent.insert(*it2);
-                notifiedSubscribers.insert(*it2);
-              }
-            }
+          if (it->first.first.count(queue) && it->first.second.count(key) &&
+              ((type != 4) || is_strict_change())) {
+            notify(it->second);
           }
         }
 
@@ -2364,18 +2547,30 @@ noexcept
           break;
         }
       } while (true);
+    }
+
+    events.clear();
 
-      SOM->mSubjectsMutex.Lock();
+    if (coalesced) {
+      eos_static_debug("msg=\"coalesced notifications\" count=%llu", coalesced);
     }
 
+    // Hand over the notifications taking each subscriber lock only once and
     // wake up all subscriber threads
-    for (auto it = notifiedSubscribers.begin();
-         it != notifiedSubscribers.end(); ++it) {
-      (*it)->mSubjSem.Post();
-    }
+    for (auto& elem : pending) {
+      if (elem.second.empty()) {
+        continue;
+      }
 
-    SOM->mSubjectsMutex.UnLock();
-    WatchMutex.UnLock();
+      elem.first->mSubjMtx.Lock();
+      elem.first->NotificationSubjects.insert(
+        elem.first->NotificationSubjects.end(),
+        std::make_move_iterator(elem.second.begin()),
+        std::make_move_iterator(elem.second.end()));
+      elem.first->mSubjMtx.UnLock();
+      elem.first->mSubjSem.Post();
+      elem.second.clear();
+    }
   }
 }
 
@@ -2967,8 +3162,9 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
       if ((ftag == XRDMQSHAREDHASH_UPDATE) || (ftag == XRDMQSHAREDHASH_BCREPLY)) {
         std::string val = (env.Get(XRDMQSHAREDHASH_PAIRS) ? env.Get(
                              XRDMQSHAREDHASH_PAIRS) : "");
+        const char* bpairs = env.Get(XRDMQSHAREDHASH_BPAIRS);
 
-        if (val.length() == 0) {
+        if ((val.length() == 0) && !bpairs) {
           error = "no pairs in message body";
           return false;
         }
@@ -2978,35 +3174,66 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
           sh->Clear(false);
         }
 
-        std::string key;
-        std::string value;
-        std::string cid;
-        std::vector<int> keystart;
-        std::vector<int> valuestart;
-        std::vector<int> cidstart;
+        std::vector<XrdMqSharedHash::Pair> pairs;
 
-        for (unsigned int i = 0; i < val.length(); i++) {
-          if (val.c_str()[i] == '|') {
-            keystart.push_back(i);
+        if (val.length() == 0) {
+          char* bin = nullptr;
+          ssize_t bin_len = 0;
+
+          if (!XrdMqMessage::Base64Decode(bpairs, bin, bin_len) || (bin_len < 0) ||
+              !XrdMqSharedHash::DecodeBinaryPairs(bin, bin_len, pairs)) {
+            free(bin);
+            error = "update: parsing error in binary pairs tag";
+            return false;
           }
 
-          if (val.c_str()[i] == '~') {
-            valuestart.push_back(i);
+          free(bin);
+        } else {
+          std::vector<int> keystart;
+          std::vector<int> valuestart;
+          std::vector<int> cidstart;
+
+          for (unsigned int i = 0; i < val.length(); i++) {
+            if (val.c_str()[i] == '|') {
+              keystart.push_back(i);
+            }
+
+            if (val.c_str()[i] == '~') {
+              valuestart.push_back(i);
+            }
+
+            if (val.c_str()[i] == '%') {
+              cidstart.push_back(i);
+            }
           }
 
-          if (val.c_str()[i] == '%') {
-            cidstart.push_back(i);
+          if (keystart.size() != valuestart.size()) {
+            error = "update: parsing error in pairs tag";
+            return false;
           }
-        }
 
-        if (keystart.size() != valuestart.size()) {
-          error = "update: parsing error in pairs tag";
-          return false;
-        }
+          if (keystart.size() != cidstart.size()) {
+            error = "update: parsing error in pairs tag";
+            return false;
+          }
 
-        if (keystart.size() != cidstart.size()) {
-          error = "update: parsing error in pairs tag";
-          return false;
+          pairs.resize(keystart.size());
+
+          for (unsigned int i = 0; i < keystart.size(); i++) {
+            std::string cid;
+            pairs[i].mKey.assign(val, keystart[i] + 1,
+                                 valuestart[i] - 1 - (keystart[i]));
+            pairs[i].mValue.assign(val, valuestart[i] + 1,
+                                   cidstart[i] - 1 - (valuestart[i]));
+
+            if (i == (keystart.size() - 1)) {
+              cid.assign(val, cidstart[i] + 1, val.length() - cidstart[i] - 1);
+            } else {
+              cid.assign(val, cidstart[i] + 1, keystart[i + 1] - 1 - (cidstart[i]));
+            }
+
+            pairs[i].mChangeId = strtoull(cid.c_str(), nullptr, 10);
+          }
         }
 
         int parseindex = 0;
@@ -3021,17 +3248,9 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
             return false;
           }
 
-          std::string sstr;
-
-          for (unsigned int i = parseindex; i < keystart.size(); i++) {
-            key.assign(val, keystart[i] + 1, valuestart[i] - 1 - (keystart[i]));
-            value.assign(val, valuestart[i] + 1, cidstart[i] - 1 - (valuestart[i]));
-
-            if (i == (keystart.size() - 1)) {
-              cid.assign(val, cidstart[i] + 1, val.length() - cidstart[i] - 1);
-            } else {
-              cid.assign(val, cidstart[i] + 1, keystart[i + 1] - 1 - (cidstart[i]));
-            }
+          for (unsigned int i = parseindex; i < pairs.size(); i++) {
+            std::string& key = pairs[i].mKey;
+            const std::string& value = pairs[i].mValue;
 
             if (sDebug) {
               fprintf(stderr,
@@ -3077,6 +3296,8 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
 
       if (ftag == XRDMQSHAREDHASH_BCREQUEST) {
         bool success = true;
+        const char* encoding = env.Get(XRDMQSHAREDHASH_ENCODING);
+        bool binary = (encoding && !strcmp(encoding, "binary"));
 
         for (unsigned int l = 0; l < subjectlist.size(); l++) {
           // try 'queue' and 'hash' to have wildcard broadcasts for both
@@ -3087,7 +3308,7 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
           }
 
           if (sh) {
-            success *= sh->BroadCastEnvString(reply.c_str());
+            success *= sh->BroadCastEnvString(reply.c_str(), binary);
           }
         }
 
@@ -51,6 +51,8 @@
 #define XRDMQSHAREDHASH_KEYS      "mqsh.keys"
 #define XRDMQSHAREDHASH_REPLY     "mqsh.reply"
 #define XRDMQSHAREDHASH_TYPE      "mqsh.type"
+#define XRDMQSHAREDHASH_BPAIRS    "mqsh.bpairs"
+#define XRDMQSHAREDHASH_ENCODING  "mqsh.encoding"
 
 //! Forward declaration
 class XrdMqSharedObjectManager;
@@ -186,6 +188,48 @@ public:
   static std::atomic<unsigned long long>
   sGetCounter; ///< Counter for get operations
 
+  //----------------------------------------------------------------------------
+  //! Entry carried by an update message
+  //----------------------------------------------------------------------------
+  struct Pair {
+    std::string mKey;
+    std::string mValue;
+    unsigned long long mChangeId;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Check if the binary encoding of the updates is enabled, configured
+  //! through EOS_MQ_SHAREDHASH_BINARY (default 1). When enabled, the
+  //! broadcast requests advertise it and the updates are binary encoded for
+  //! the peers which advertised it.
+  //----------------------------------------------------------------------------
+  static bool IsBinaryEncodingEnabled();
+
+  //----------------------------------------------------------------------------
+  //! Encode pairs in the binary format: a version byte, the number of pairs
+  //! and for each pair the length of the prefix shared with the previous key,
+  //! the rest of the key, the value and the change id. Numbers are varints
+  //! and strings are prefixed by their varint length. Sorted keys share long
+  //! prefixes e.g. stat.statfs.*
+  //!
+  //! @param pairs pairs to encode
+  //! @param out binary output
+  //----------------------------------------------------------------------------
+  static void EncodeBinaryPairs(const std::vector<Pair>& pairs,
+                                std::string& out);
+
+  //----------------------------------------------------------------------------
+  //! Decode pairs in binary format
+  //!
+  //! @param in binary input
+  //! @param len length of the input
+  //! @param pairs decoded pairs
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool DecodeBinaryPairs(const char* in, size_t len,
+                                std::vector<Pair>& pairs);
+
   //----------------------------------------------------------------------------
   //! Constructor
   //!
@@ -452,7 +496,11 @@ private:
   std::string mBroadcastQueue; ///< Name of the broadcast queue
   std::set<std::string> mDeletions; ///< Set of deletions
   std::set<std::string> mTransactions; ///< Set of transactions
-  //1 Mutex protecting the set of transactions
+  //! Peers which requested a broadcast and support the binary encoding
+  std::set<std::string> mBinaryPeers;
+  //! Peers which requested a broadcast and support only the env encoding
+  std::set<std::string> mEnvPeers;
+  //1 Mutex protecting the set of transactions and the set of peers
   std::unique_ptr<XrdSysMutex> mTransactMutex;
   //! RW Mutex protecting the mStore object
   std::unique_ptr<eos::common::RWMutex> mStoreMutex;
@@ -490,8 +538,17 @@ private:
   //!
   //! @param out output string
   //! @param clear_after if true clear transactions afterward, otherwise not
+  //! @param binary if true use the binary encoding of the pairs
   //----------------------------------------------------------------------------
-  void AddTransactionsToEnvString(XrdOucString& out, bool clearafter = true);
+  void AddTransactionsToEnvString(XrdOucString& out, bool clearafter = true,
+                                  bool binary = false);
+
+  //----------------------------------------------------------------------------
+  //! Check if the updates sent to the broadcast queue can use the binary
+  //! encoding i.e. all the peers that requested a broadcast support it. This
+  //! must be called with the mTransactMutex locked.
+  //----------------------------------------------------------------------------
+  bool UseBinaryEncoding() const;
 
   //----------------------------------------------------------------------------
   //! Encode deletions as env string
@@ -504,10 +561,11 @@ private:
   //! Broadcast hash as env string
   //!
   //! @param receiver target of the broadcast message
+  //! @param binary if true the receiver supports the binary encoding
   //!
   //! @return true if message sent successful, otherwise false
   //----------------------------------------------------------------------------
-  bool BroadCastEnvString(const char* receiver);
+  bool BroadCastEnvString(const char* receiver, bool binary = false);
 };
 
 
@@ -951,7 +1009,7 @@ public:
   //! Constructor
   //----------------------------------------------------------------------------
   XrdMqSharedObjectChangeNotifier():
-    SOM(nullptr) {}
+    SOM(nullptr), mRegexItemsDirty(true) {}
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -1052,6 +1110,10 @@ private:
   WatchSubjectsXKeys2Subscribers[5];
   //!  listof((Subjects,Keys),Subscribers)
   std::map<std::string, std::string> LastValues;
+  //! Regex watch items of the maps above, exact items are looked up directly
+  std::vector<WatchItemInfo*> mKeyRegexItems[5];
+  std::vector<WatchItemInfo*> mSubjectRegexItems[5];
+  bool mRegexItemsDirty; ///< Regex items need a rebuild, protected by WatchMutex
 
   AssistedThread mDispatchThread; ///< Dispatching change thread
 
@@ -1062,6 +1124,11 @@ private:
   //----------------------------------------------------------------------------
   void SomListener(ThreadAssistant& assistant) noexcept;
 
+  //----------------------------------------------------------------------------
+  //! Rebuild the list of regex watch items, WatchMutex must be locked
+  //----------------------------------------------------------------------------
+  void RebuildRegexItems();
+
   std::map<std::string, Subscriber*> pSubscribersCatalog;
   XrdSysMutex pCatalogMutex;
 
@@ -28,9 +28,13 @@
 #include "namespace/interface/ContainerIterators.hh"
 #include "namespace/Prefetcher.hh"
 #include "common/FileId.hh"
+#include <algorithm>
 
 EOSNSNAMESPACE_BEGIN
 
+// Definition of class static member
+constexpr size_t Prefetcher::kBatchSize;
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -53,6 +57,58 @@ void Prefetcher::stageFileMD(IFileMD::id_t id)
   mFileMDs.emplace_back(pFileMDSvc->getFileMDFut(id));
 }
 
+//------------------------------------------------------------------------------
+// Declare an intent to access a batch of ContainerMDs with the given ids soon
+//------------------------------------------------------------------------------
+void Prefetcher::stageContainerMDs(const std::vector<IContainerMD::id_t>& ids)
+{
+  if (pView->inMemory() || ids.empty()) {
+    return;
+  }
+
+  mBatches.emplace_back(pContainerMDSvc->getContainerMDsFut(ids).then(
+  [](std::vector<folly::Try<IContainerMDPtr>>) {}));
+}
+
+//------------------------------------------------------------------------------
+// Declare an intent to access a batch of FileMDs with the given ids soon
+//------------------------------------------------------------------------------
+void Prefetcher::stageFileMDs(const std::vector<IFileMD::id_t>& ids)
+{
+  if (pView->inMemory() || ids.empty()) {
+    return;
+  }
+
+  mBatches.emplace_back(pFileMDSvc->getFileMDsFut(ids).then(
+  [](std::vector<folly::Try<IFileMDPtr>>) {}));
+}
+
+//------------------------------------------------------------------------------
+// Declare an intent to access a batch of FileMDs with the given ids soon,
+// along with their parents
+//------------------------------------------------------------------------------
+void Prefetcher::stageFileMDsWithParents(const std::vector<IFileMD::id_t>&
+    ids)
+{
+  if (pView->inMemory() || ids.empty()) {
+    return;
+  }
+
+  mBatches.emplace_back(pFileMDSvc->getFileMDsFut(ids).then(
+  [this](std::vector<folly::Try<IFileMDPtr>> results) {
+    std::vector<folly::Future<std::string>> uris;
+
+    for (auto& result : results) {
+      if (result.hasValue() && result.value()) {
+        uris.emplace_back(this->pView->getUriFut(result.value()->getIdentifier()));
+      }
+    }
+
+    return folly::collectAll(uris.begin(), uris.end())
+    .then([](std::vector<folly::Try<std::string>>) {});
+  }));
+}
+
 //------------------------------------------------------------------------------
 // Declare an intent to access FileMD with the given id soon, along with
 // its parents
@@ -162,6 +218,10 @@ void Prefetcher::wait()
   for (size_t i = 0; i < mUris.size(); i++) {
     mUris[i].wait();
   }
+
+  for (size_t i = 0; i < mBatches.size(); i++) {
+    mBatches[i].wait();
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -317,16 +377,32 @@ void Prefetcher::prefetchContainerMDWithChildrenAndWait(IView* view,
 
   IContainerMDPtr cmd = fut.get();
   Prefetcher prefetcher(view);
-  std::vector<std::string> paths;
+  std::vector<IContainerMD::id_t> cids;
+  cids.reserve(std::min((size_t)cmd->getNumContainers(), kBatchSize));
 
   for (auto dit = eos::ContainerMapIterator(cmd); dit.valid(); dit.next()) {
-    prefetcher.stageContainerMD(dit.value());
+    cids.push_back(dit.value());
+
+    if (cids.size() >= kBatchSize) {
+      prefetcher.stageContainerMDs(cids);
+      cids.clear();
+    }
   }
 
+  prefetcher.stageContainerMDs(cids);
+  std::vector<IFileMD::id_t> ids;
+  ids.reserve(std::min((size_t)cmd->getNumFiles(), kBatchSize));
+
   for (auto dit = eos::FileMapIterator(cmd); dit.valid(); dit.next()) {
-    prefetcher.stageFileMD(dit.value());
+    ids.push_back(dit.value());
+
+    if (ids.size() >= kBatchSize) {
+      prefetcher.stageFileMDs(ids);
+      ids.clear();
+    }
   }
 
+  prefetcher.stageFileMDs(ids);
   prefetcher.wait();
 }
 
@@ -345,6 +421,21 @@ void Prefetcher::prefetchFileMDWithParentsAndWait(IView* view,
   prefetcher.wait();
 }
 
+//------------------------------------------------------------------------------
+// Prefetch a batch of FileMD inodes, along with all their parents, and wait
+//------------------------------------------------------------------------------
+void Prefetcher::prefetchFileMDsWithParentsAndWait(IView* view,
+    const std::vector<IFileMD::id_t>& ids)
+{
+  if (view->inMemory()) {
+    return;
+  }
+
+  Prefetcher prefetcher(view);
+  prefetcher.stageFileMDsWithParents(ids);
+  prefetcher.wait();
+}
+
 //------------------------------------------------------------------------------
 // Prefetch ContainerMD inode, along with all its parents, and wait
 //------------------------------------------------------------------------------
@@ -398,12 +489,19 @@ void Prefetcher::prefetchFilesystemUnlinkedFileListWithFileMDsAndWait(
   }
 
   Prefetcher prefetcher(view);
+  std::vector<IFileMD::id_t> ids;
 
   for (auto it = fsview->getUnlinkedFileList(location); it &&
        it->valid(); it->next()) {
-    prefetcher.stageFileMD(it->getElement());
+    ids.push_back(it->getElement());
+
+    if (ids.size() >= kBatchSize) {
+      prefetcher.stageFileMDs(ids);
+      ids.clear();
+    }
   }
 
+  prefetcher.stageFileMDs(ids);
   prefetcher.wait();
 }
 
@@ -419,11 +517,20 @@ void Prefetcher::prefetchFilesystemFileListWithFileMDsAndWait(IView* view,
   }
 
   Prefetcher prefetcher(view);
+  std::vector<IFileMD::id_t> ids;
+
+  // Page through the file list, there is no need to load it into the cache
+  for (auto it = fsview->getPagedFileList(location, "0", kBatchSize);
+       it && it->valid(); it->next()) {
+    ids.push_back(it->getElement());
 
-  for (auto it = fsview->getFileList(location); it && it->valid(); it->next()) {
-    prefetcher.stageFileMD(it->getElement());
+    if (ids.size() >= kBatchSize) {
+      prefetcher.stageFileMDs(ids);
+      ids.clear();
+    }
   }
 
+  prefetcher.stageFileMDs(ids);
   prefetcher.wait();
 }
 
@@ -439,11 +546,20 @@ void Prefetcher::prefetchFilesystemFileListWithFileMDsAndParentsAndWait(
   }
 
   Prefetcher prefetcher(view);
+  std::vector<IFileMD::id_t> ids;
+
+  // Page through the file list, there is no need to load it into the cache
+  for (auto it = fsview->getPagedFileList(location, "0", kBatchSize);
+       it && it->valid(); it->next()) {
+    ids.push_back(it->getElement());
 
-  for (auto it = fsview->getFileList(location); it && it->valid(); it->next()) {
-    prefetcher.stageFileMDWithParents(it->getElement());
+    if (ids.size() >= kBatchSize) {
+      prefetcher.stageFileMDsWithParents(ids);
+      ids.clear();
+    }
   }
 
+  prefetcher.stageFileMDsWithParents(ids);
   prefetcher.wait();
 }
 
@@ -46,6 +46,23 @@ public:
   //----------------------------------------------------------------------------
   void stageFileMD(IFileMD::id_t id);
 
+  //----------------------------------------------------------------------------
+  //! Declare an intent to access a batch of ContainerMDs with the given ids
+  //! soon
+  //----------------------------------------------------------------------------
+  void stageContainerMDs(const std::vector<IContainerMD::id_t>& ids);
+
+  //----------------------------------------------------------------------------
+  //! Declare an intent to access a batch of FileMDs with the given ids soon
+  //----------------------------------------------------------------------------
+  void stageFileMDs(const std::vector<IFileMD::id_t>& ids);
+
+  //----------------------------------------------------------------------------
+  //! Declare an intent to access a batch of FileMDs with the given ids soon,
+  //! along with their parents
+  //----------------------------------------------------------------------------
+  void stageFileMDsWithParents(const std::vector<IFileMD::id_t>& ids);
+
   //----------------------------------------------------------------------------
   //! Declare an intent to access FileMD with the given id soon, along with
   //! its parents
@@ -118,6 +135,12 @@ public:
   //----------------------------------------------------------------------------
   static void prefetchFileMDWithParentsAndWait(IView* view, IFileMD::id_t id);
 
+  //----------------------------------------------------------------------------
+  //! Prefetch a batch of FileMD inodes, along with all their parents, and wait
+  //----------------------------------------------------------------------------
+  static void prefetchFileMDsWithParentsAndWait(IView* view,
+      const std::vector<IFileMD::id_t>& ids);
+
   //----------------------------------------------------------------------------
   //! Prefetch ContainerMD inode, along with all its parents, and wait
   //----------------------------------------------------------------------------
@@ -136,7 +159,9 @@ public:
   static void prefetchInodeWithChildrenAndWait(IView* view, uint64_t ino);
 
   //----------------------------------------------------------------------------
-  //! Prefetch FileList for the given filesystem ID
+  //! Prefetch FileList for the given filesystem ID into the cache. Callers
+  //! which only iterate through the list should use IFsView::getPagedFileList
+  //! instead.
   //----------------------------------------------------------------------------
   static void prefetchFilesystemFileListAndWait(IView* view, IFsView* fsview,
       IFileMD::location_t location);
@@ -177,6 +202,10 @@ private:
   std::vector<folly::Future<IContainerMDPtr>> mContainerMDs;
   std::vector<folly::Future<FileOrContainerMD>> mItems;
   std::vector<folly::Future<std::string>> mUris;
+  std::vector<folly::Future<folly::Unit>> mBatches;
+
+  //! Max number of ids staged together as one batch request
+  static constexpr size_t kBatchSize = 10000;
 };
 
 EOSNSNAMESPACE_END
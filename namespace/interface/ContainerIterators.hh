@@ -32,32 +32,69 @@ EOSNSNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
 //! Class FileMapIterator
+//!
+//! Containers with paged files are iterated page by page without holding the
+//! container lock, like a scan the iteration may or may not see concurrent
+//! changes.
 //------------------------------------------------------------------------------
 class FileMapIterator {
 public:
   FileMapIterator(IContainerMDPtr cont)
-  : container(cont), lock(cont->mMutex), iter(cont->filesBegin()) { }
+  : container(cont), paged(cont->hasPagedFiles()) {
+    if (paged) {
+      fetchPage();
+    } else {
+      lock = std::shared_lock<std::shared_timed_mutex>(cont->mMutex);
+      iter = cont->filesBegin();
+    }
+  }
 
   bool valid() const {
+    if (paged) {
+      return pos < page.size();
+    }
+
     return iter != container->filesEnd();
   }
 
   void next() {
-    iter++;
+    if (paged) {
+      if ((++pos >= page.size()) && more) {
+        fetchPage();
+      }
+    } else {
+      iter++;
+    }
   }
 
   std::string key() const {
-    return iter->first;
+    return (paged ? page[pos].first : iter->first);
   }
 
   IFileMD::id_t value() const {
-    return iter->second;
+    return (paged ? page[pos].second : iter->second);
   }
 
 private:
+  //----------------------------------------------------------------------------
+  //! Fetch the next non-empty page, if any
+  //----------------------------------------------------------------------------
+  void fetchPage() {
+    do {
+      page.clear();
+      pos = 0;
+      more = container->getFilesPage(cursor, page);
+    } while (page.empty() && more);
+  }
+
   IContainerMDPtr container;
   std::shared_lock<std::shared_timed_mutex> lock;
   eos::IContainerMD::FileMap::const_iterator iter;
+  bool paged;
+  bool more = false;
+  std::string cursor;
+  eos::IContainerMD::FilePage page;
+  size_t pos = 0;
 };
 
 //------------------------------------------------------------------------------
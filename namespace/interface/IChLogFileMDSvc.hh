@@ -91,6 +91,26 @@ public:
   //----------------------------------------------------------------------------
   virtual void compactCommit(void* comp_data, bool autorepair = false) = 0;
 
+  //----------------------------------------------------------------------------
+  //! Prepare a boot snapshot of the changelog.
+  //!
+  //! No external metadata mutation may occur while the method is running.
+  //!
+  //! @return snapshot information that needs to be passed to snapshot
+  //----------------------------------------------------------------------------
+  virtual void* snapshotPrepare() = 0;
+
+  //----------------------------------------------------------------------------
+  //! Write the boot snapshot.
+  //!
+  //! This does not access any of the in-memory structures so any external
+  //! metadata operations may happen while it is running.
+  //!
+  //! @param snapshotData state information returned by snapshotPrepare, it
+  //!                     is released and reset
+  //----------------------------------------------------------------------------
+  virtual void snapshot(void*& snapshotData) = 0;
+
   //----------------------------------------------------------------------------
   //! Make transition from slave to master
   //!
@@ -135,6 +155,14 @@ public:
   //----------------------------------------------------------------------------
   virtual uint64_t getFollowPending() = 0;
 
+  //----------------------------------------------------------------------------
+  //! Get the follower lag, the time since the follower last applied all the
+  //! records of the changelog
+  //!
+  //! @return lag in seconds, 0 if not following
+  //----------------------------------------------------------------------------
+  virtual uint64_t getFollowLag() = 0;
+
   //------------------------------------------------------------------------
   //! Resize container service map
   //------------------------------------------------------------------------
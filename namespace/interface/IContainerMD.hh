@@ -32,8 +32,11 @@
 #include "common/Murmur3.hh"
 #include <stdint.h>
 #include <unistd.h>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 #include <map>
 #include <set>
 #include <shared_mutex>
@@ -84,11 +87,14 @@ public:
   typedef google::dense_hash_map <
   std::string, IContainerMD::id_t,
       Murmur3::MurmurHasher<std::string> > FileMap;
+  typedef std::vector<std::pair<std::string, IContainerMD::id_t>> FilePage;
 
   //----------------------------------------------------------------------------
   //! Constructor
   //----------------------------------------------------------------------------
-  IContainerMD(): mIsDeleted(false) {}
+  IContainerMD(): mIsDeleted(false), mChildrenVersion(
+      std::chrono::steady_clock::now().time_since_epoch().count())
+  {}
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -262,6 +268,16 @@ public:
   //----------------------------------------------------------------------------
   virtual uint64_t updateTreeSize(int64_t delta) = 0;
 
+  //----------------------------------------------------------------------------
+  //! Get tree hash, see TreeHash
+  //----------------------------------------------------------------------------
+  virtual uint64_t getTreeHash() const = 0;
+
+  //----------------------------------------------------------------------------
+  //! Set tree hash
+  //----------------------------------------------------------------------------
+  virtual void setTreeHash(uint64_t tree_hash) = 0;
+
   //----------------------------------------------------------------------------
   //! Get creation time
   //----------------------------------------------------------------------------
@@ -363,6 +379,16 @@ public:
     return 0;
   }
 
+  //----------------------------------------------------------------------------
+  //! Get value changing whenever a file or subcontainer is added or removed.
+  //! It starts from a fresh value every time the object is created or loaded,
+  //! so it can be compared across evictions from the metadata cache.
+  //----------------------------------------------------------------------------
+  uint64_t getChildrenVersion() const
+  {
+    return mChildrenVersion;
+  }
+
   //----------------------------------------------------------------------------
   //! Get env representation of the container object
   //!
@@ -409,8 +435,17 @@ private:
   IContainerMD& operator=(const IContainerMD& other) = delete;
 
   bool mIsDeleted; ///< Mark if object is still in cache but it was deleted
+  std::atomic<uint64_t> mChildrenVersion; ///< Changes with the children
 
 protected:
+  //----------------------------------------------------------------------------
+  //! Mark a change of the files or subcontainers of the container
+  //----------------------------------------------------------------------------
+  void bumpChildrenVersion()
+  {
+    ++mChildrenVersion;
+  }
+
   //----------------------------------------------------------------------------
   //! Get iterator to the begining of the subcontainers map
   //----------------------------------------------------------------------------
@@ -435,6 +470,29 @@ protected:
   virtual eos::IContainerMD::FileMap::const_iterator
   filesEnd() = 0;
 
+  //----------------------------------------------------------------------------
+  //! Check if the files are not held in memory, in which case they are
+  //! iterated page by page through getFilesPage instead of the files map
+  //----------------------------------------------------------------------------
+  virtual bool hasPagedFiles() const
+  {
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the next page of files of a container with paged files. No lock
+  //! needs to be held by the caller.
+  //!
+  //! @param cursor position of the scan, empty to start from the beginning
+  //! @param page filled with the files of the page, possibly empty
+  //!
+  //! @return true if more pages follow, false if this was the last one
+  //----------------------------------------------------------------------------
+  virtual bool getFilesPage(std::string& cursor, FilePage& page)
+  {
+    return false;
+  }
+
   mutable std::shared_timed_mutex mMutex;
 };
 
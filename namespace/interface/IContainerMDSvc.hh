@@ -28,6 +28,7 @@
 #include "namespace/interface/IFileMDSvc.hh"
 #include "namespace/MDException.hh"
 #include <map>
+#include <vector>
 #include <string>
 
 EOSNSNAMESPACE_BEGIN
@@ -87,6 +88,24 @@ public:
   //----------------------------------------------------------------------------
   virtual folly::Future<IContainerMDPtr> getContainerMDFut(IContainerMD::id_t id) = 0;
 
+  //----------------------------------------------------------------------------
+  //! Asynchronously get the container metadata information for a batch of
+  //! IDs. The result holds one entry per requested ID, in the same order.
+  //! The default issues one request per ID.
+  //----------------------------------------------------------------------------
+  virtual folly::Future<std::vector<folly::Try<IContainerMDPtr>>>
+      getContainerMDsFut(const std::vector<IContainerMD::id_t>& ids)
+  {
+    std::vector<folly::Future<IContainerMDPtr>> futs;
+    futs.reserve(ids.size());
+
+    for (const auto id : ids) {
+      futs.emplace_back(getContainerMDFut(id));
+    }
+
+    return folly::collectAll(futs.begin(), futs.end());
+  }
+
   //------------------------------------------------------------------------
   //! Get the container metadata information for the given ID
   //------------------------------------------------------------------------
@@ -172,6 +191,30 @@ public:
   //! Retrieve file metadata cache statistics
   //----------------------------------------------------------------------------
   virtual CacheStatistics getCacheStatistics() = 0;
+
+  //----------------------------------------------------------------------------
+  //! Persist the ids of the most recently used containers so that a new
+  //! master can warm up its cache with them - no-op by default
+  //!
+  //! @param max_num maximum number of ids to persist
+  //----------------------------------------------------------------------------
+  virtual void saveCacheWarmupList(uint64_t max_num) {}
+
+  //----------------------------------------------------------------------------
+  //! Get the ids persisted by saveCacheWarmupList - empty by default
+  //----------------------------------------------------------------------------
+  virtual std::vector<IContainerMD::id_t> loadCacheWarmupList()
+  {
+    return {};
+  }
+
+  //----------------------------------------------------------------------------
+  //! Load the given containers into the cache - no-op by default
+  //!
+  //! @param ids list of container ids, missing ones are ignored
+  //----------------------------------------------------------------------------
+  virtual void prefetchContainers(const std::vector<IContainerMD::id_t>& ids)
+  {}
 };
 
 EOSNSNAMESPACE_END
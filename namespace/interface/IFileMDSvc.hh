@@ -32,6 +32,7 @@
 #include <folly/futures/Future.h>
 #include <map>
 #include <string>
+#include <vector>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -127,6 +128,25 @@ public:
   //------------------------------------------------------------------------
   virtual folly::Future<IFileMDPtr> getFileMDFut(IFileMD::id_t id) = 0;
 
+  //------------------------------------------------------------------------
+  //! Asynchronously get the file metadata information for a batch of file
+  //! IDs. The result holds one entry per requested ID, in the same order.
+  //! Implementations backed by a remote store should override this to
+  //! batch the round-trips, the default issues one request per ID.
+  //------------------------------------------------------------------------
+  virtual folly::Future<std::vector<folly::Try<IFileMDPtr>>>
+      getFileMDsFut(const std::vector<IFileMD::id_t>& ids)
+  {
+    std::vector<folly::Future<IFileMDPtr>> futs;
+    futs.reserve(ids.size());
+
+    for (const auto id : ids) {
+      futs.emplace_back(getFileMDFut(id));
+    }
+
+    return folly::collectAll(futs.begin(), futs.end());
+  }
+
   //------------------------------------------------------------------------
   //! Get the file metadata information for the given file ID
   //------------------------------------------------------------------------
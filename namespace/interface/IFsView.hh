@@ -27,8 +27,11 @@
 #include "namespace/Namespace.hh"
 #include "namespace/MDException.hh"
 #include "namespace/interface/IFileMDSvc.hh"
+#include "namespace/utils/FileBitmap.hh"
 #include <google/dense_hash_set>
 #include <set>
+#include <string>
+#include <cstdlib>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -65,6 +68,71 @@ public:
   virtual void next() = 0;
 };
 
+//------------------------------------------------------------------------------
+//! Collection iterator going through its elements page by page, which can be
+//! resumed from a cursor
+//------------------------------------------------------------------------------
+template<typename T>
+class ICursorIterator: public ICollectionIterator<T>
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Get the cursor of the page holding the current element. An iterator
+  //! created with this cursor starts again at the beginning of this page, so
+  //! elements of the page may be returned once more. The cursor of the first
+  //! page is "0".
+  //----------------------------------------------------------------------------
+  virtual std::string getCursor() = 0;
+};
+
+//------------------------------------------------------------------------------
+//! Iterator owning a snapshot of file ids, e.g. the result of a set
+//! operation between the file lists of two filesystems
+//------------------------------------------------------------------------------
+class FileBitmapIterator: public ICollectionIterator<IFileMD::id_t>
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  explicit FileBitmapIterator(FileBitmap&& bitmap):
+    mBitmap(std::move(bitmap)), mIt(mBitmap.begin()) {}
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~FileBitmapIterator() = default;
+
+  IFileMD::id_t getElement() override
+  {
+    return *mIt;
+  }
+
+  bool valid() override
+  {
+    return (mIt != mBitmap.end());
+  }
+
+  void next() override
+  {
+    if (valid()) {
+      ++mIt;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of file ids of the snapshot
+  //----------------------------------------------------------------------------
+  uint64_t size() const
+  {
+    return mBitmap.size();
+  }
+
+private:
+  FileBitmap mBitmap;
+  FileBitmap::const_iterator mIt;
+};
+
 //------------------------------------------------------------------------------
 //! File System view abtract class
 //------------------------------------------------------------------------------
@@ -83,6 +151,9 @@ public:
   typedef google::dense_hash_set <IFileMD::id_t,
           Murmur3::MurmurHasher<uint64_t> > FileList;
 
+  //! Default number of file ids per page of a paged file list
+  static constexpr size_t kFileListPageSize = 1000;
+
   //----------------------------------------------------------------------------
   //! Contructor
   //----------------------------------------------------------------------------
@@ -132,6 +203,22 @@ public:
   virtual std::shared_ptr<ICollectionIterator<IFileMD::id_t>>
       getStreamingFileList(IFileMD::location_t location) = 0;
 
+  //----------------------------------------------------------------------------
+  //! Get cursor based streaming iterator to list of files on a particular
+  //! file system. Only the current page of file ids is kept in memory and
+  //! the file list of the file system is not loaded into the cache. Elements
+  //! which are added or deleted while iterating may or may not be returned.
+  //!
+  //! @param location file system id
+  //! @param cursor cursor to resume from, "0" to start from the beginning
+  //! @param page_size number of file ids fetched at once
+  //!
+  //! @return shared ptr to cursor iterator
+  //----------------------------------------------------------------------------
+  virtual std::shared_ptr<ICursorIterator<IFileMD::id_t>>
+      getPagedFileList(IFileMD::location_t location, const std::string& cursor,
+                       size_t page_size) = 0;
+
   //----------------------------------------------------------------------------
   //! Erase an entry from all filesystem view collections
   //!
@@ -227,6 +314,36 @@ public:
   //----------------------------------------------------------------------------
   virtual bool hasFileId(IFileMD::id_t fid, IFileMD::location_t fs_id) = 0;
 
+  //----------------------------------------------------------------------------
+  //! Get the files which are on both file systems, as a snapshot in ascending
+  //! order of file id
+  //!
+  //! @param fs_a first file system id
+  //! @param fs_b second file system id
+  //!
+  //! @return shared ptr to collection iterator, empty if none
+  //----------------------------------------------------------------------------
+  virtual std::shared_ptr<FileBitmapIterator>
+  getFileListIntersection(IFileMD::location_t fs_a, IFileMD::location_t fs_b)
+  {
+    return combineFileLists(fs_a, fs_b, false);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the files which are on fs_a but not on fs_b, as a snapshot in
+  //! ascending order of file id
+  //!
+  //! @param fs_a file system id whose files are returned
+  //! @param fs_b file system id whose files are left out
+  //!
+  //! @return shared ptr to collection iterator, empty if none
+  //----------------------------------------------------------------------------
+  virtual std::shared_ptr<FileBitmapIterator>
+  getFileListDifference(IFileMD::location_t fs_a, IFileMD::location_t fs_b)
+  {
+    return combineFileLists(fs_a, fs_b, true);
+  }
+
   //----------------------------------------------------------------------------
   //! Finalize
   //----------------------------------------------------------------------------
@@ -236,6 +353,92 @@ public:
   //! Shrink maps
   //----------------------------------------------------------------------------
   virtual void shrink() = 0;
+
+protected:
+  //----------------------------------------------------------------------------
+  //! Generic intersection or difference of two file lists going through the
+  //! files of fs_a and looking each one up on fs_b
+  //----------------------------------------------------------------------------
+  std::shared_ptr<FileBitmapIterator>
+  combineFileLists(IFileMD::location_t fs_a, IFileMD::location_t fs_b,
+                   bool difference)
+  {
+    // Only one file list is locked at a time
+    FileBitmap files;
+    auto it = getFileList(fs_a);
+
+    for (; it && it->valid(); it->next()) {
+      files.insert(it->getElement());
+    }
+
+    it.reset();
+    FileBitmap result;
+    files.forEach([&](IFileMD::id_t fid) {
+      if (hasFileId(fid, fs_b) != difference) {
+        result.insert(fid);
+      }
+    });
+    return std::make_shared<FileBitmapIterator>(std::move(result));
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Cursor iterator on top of a collection iterator for file lists which are
+//! kept in memory. The cursor is the index of the first element of a page.
+//------------------------------------------------------------------------------
+class IndexedFileListIterator: public ICursorIterator<IFileMD::id_t>
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param it iterator of the file list, may be nullptr
+  //! @param cursor index to start from
+  //! @param page_size number of elements per page
+  //----------------------------------------------------------------------------
+  IndexedFileListIterator(std::shared_ptr<ICollectionIterator<IFileMD::id_t>>
+                          it, const std::string& cursor, size_t page_size):
+    mIt(it), mIndex(0), mPageSize(page_size ? page_size : 1)
+  {
+    uint64_t start = strtoull(cursor.c_str(), nullptr, 10);
+
+    while (valid() && (mIndex < start)) {
+      next();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~IndexedFileListIterator() = default;
+
+  IFileMD::id_t getElement() override
+  {
+    return mIt->getElement();
+  }
+
+  bool valid() override
+  {
+    return (mIt && mIt->valid());
+  }
+
+  void next() override
+  {
+    if (valid()) {
+      mIt->next();
+      ++mIndex;
+    }
+  }
+
+  std::string getCursor() override
+  {
+    return std::to_string(mIndex - (mIndex % mPageSize));
+  }
+
+private:
+  std::shared_ptr<ICollectionIterator<IFileMD::id_t>> mIt;
+  uint64_t mIndex; ///< Index of the current element
+  uint64_t mPageSize; ///< Number of elements per page
 };
 
 //------------------------------------------------------------------------------
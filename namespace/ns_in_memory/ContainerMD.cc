@@ -51,6 +51,7 @@ ContainerMD::ContainerMD(ContainerMD::id_t id, IFileMDSvc* file_svc,
   pTMTime.tv_sec = 0;
   pTMTime.tv_nsec = 0;
   setTreeSize(0);
+  setTreeHash(0);
 }
 
 //------------------------------------------------------------------------------
@@ -105,7 +106,8 @@ ContainerMD& ContainerMD::operator= (const ContainerMD& other)
   this->pTMTime_atomic = other.pTMTime_atomic;
 #endif
   pTreeSize = 0;
-  // Note: mFiles, mSubcontainers, pTreeSize are not copied here
+  pTreeHash = 0;
+  // Note: mFiles, mSubcontainers, pTreeSize, pTreeHash are not copied here
   return *this;
 }
 
@@ -119,6 +121,7 @@ ContainerMD::InheritChildren(const IContainerMD& other)
   mFiles = otherContainer.mFiles;
   mSubcontainers = otherContainer.mSubcontainers;
   setTreeSize(otherContainer.getTreeSize());
+  setTreeHash(otherContainer.getTreeHash());
 }
 
 //------------------------------------------------------------------------------
@@ -173,6 +176,7 @@ ContainerMD::removeContainer(const std::string& name)
 {
   mSubcontainers.erase(name);
   mSubcontainers.resize(0);
+  bumpChildrenVersion();
 }
 
 //------------------------------------------------------------------------------
@@ -183,6 +187,7 @@ ContainerMD::addContainer(IContainerMD* container)
 {
   container->setParentId(pId);
   mSubcontainers[container->getName()] = container->getId();
+  bumpChildrenVersion();
 }
 
 //------------------------------------------------------------------------------
@@ -217,6 +222,7 @@ ContainerMD::addFile(IFileMD* file)
 {
   file->setContainerId(pId);
   mFiles[file->getName()] = file->getId();
+  bumpChildrenVersion();
   IFileMDChangeListener::Event e(file, IFileMDChangeListener::SizeChange,
                                  0, file->getSize());
   file->getFileMDSvc()->notifyListeners(&e);
@@ -235,6 +241,7 @@ ContainerMD::removeFile(const std::string& name)
     file->getFileMDSvc()->notifyListeners(&e);
     mFiles.erase(name);
     mFiles.resize(0);
+    bumpChildrenVersion();
   }
 }
 
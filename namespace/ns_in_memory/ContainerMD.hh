@@ -389,6 +389,22 @@ public:
     return getTreeSize();
   }
 
+  //----------------------------------------------------------------------------
+  //! Get tree hash, only maintained by the QuarkDB namespace
+  //----------------------------------------------------------------------------
+  uint64_t getTreeHash() const override
+  {
+    return pTreeHash;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Set tree hash
+  //----------------------------------------------------------------------------
+  void setTreeHash(uint64_t tree_hash) override
+  {
+    pTreeHash = tree_hash;
+  }
+
   //----------------------------------------------------------------------------
   //! Get name
   //----------------------------------------------------------------------------
@@ -560,6 +576,7 @@ protected:
 #else
   uint64_t     pTreeSize;
 #endif
+  uint64_t            pTreeHash;
 
 protected:
   ContainerMap mSubcontainers; //! Directory name to id map
@@ -103,6 +103,23 @@ public:
     return getFileList(location);
   }
 
+  //----------------------------------------------------------------------------
+  //! Get cursor based streaming iterator to list of files on a particular
+  //! file system
+  //!
+  //! @param location file system id
+  //! @param cursor cursor to resume from, "0" to start from the beginning
+  //! @param page_size number of file ids per page
+  //!
+  //! @return shared ptr to cursor iterator
+  //----------------------------------------------------------------------------
+  std::shared_ptr<ICursorIterator<IFileMD::id_t>>
+      getPagedFileList(IFileMD::location_t location, const std::string& cursor,
+                       size_t page_size) override {
+    return std::make_shared<IndexedFileListIterator>(getFileList(location),
+           cursor, page_size);
+  }
+
   //----------------------------------------------------------------------------
   //! Get an approximately random file residing within the given filesystem.
   //!
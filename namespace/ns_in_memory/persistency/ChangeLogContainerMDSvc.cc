@@ -32,7 +32,10 @@
 #include "namespace/ns_in_memory/accounting/ContainerAccounting.hh"
 #include "namespace/ns_in_memory/persistency/ChangeLogContainerMDSvc.hh"
 #include "namespace/ns_in_memory/persistency/ChangeLogConstants.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogSnapshot.hh"
 #include "common/Parallel.hh"
+#include <algorithm>
+#include <atomic>
 #include <memory>
 
 //------------------------------------------------------------------------------
@@ -410,6 +413,14 @@ private:
 };
 }
 
+namespace
+{
+//------------------------------------------------------------------------------
+// Maximum number of records applied under one slave lock acquisition
+//------------------------------------------------------------------------------
+const uint64_t sFollowBatchRecords = 100000;
+}
+
 extern "C"
 {
   //----------------------------------------------------------------------------
@@ -427,12 +438,23 @@ extern "C"
     pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, 0);
 
     while (1) {
+      // The records are decoded without a lock and applied in batches, see
+      // the file follower
+      bool atEnd = false;
       pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, 0);
-      offset = file->follow(&f, offset);
+      offset = file->follow(&f, offset, sFollowBatchRecords, &atEnd);
       f.commit();
       contSvc->setFollowOffset(offset);
+
+      if (atEnd) {
+        contSvc->setFollowCaughtUp(time(0));
+      }
+
       pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, 0);
-      file->wait(pollInt);
+
+      if (atEnd) {
+        file->wait(pollInt);
+      }
     }
 
     return 0;
@@ -574,8 +596,18 @@ void ChangeLogContainerMDSvc::initialize()
   if (!pSlaveMode || logIsCompacted) {
     ContainerMDScanner scanner(pIdMap, pSlaveMode);
     pChangeLog->mmap();
-    pFollowStart = pChangeLog->scanAllRecords(&scanner , pAutoRepair);
-    pFirstFreeId = scanner.getLargestId() + 1;
+    uint64_t scanOffset = pChangeLog->getFirstOffset();
+    uint64_t snapshotLargestId = 0;
+
+    // In the master mode the records covered by the snapshot are taken
+    // from its index and only the tail of the changelog is scanned
+    if (!pSlaveMode && ChangeLogSnapshot::isEnabled()) {
+      scanOffset = loadSnapshot(snapshotLargestId);
+    }
+
+    pFollowStart = pChangeLog->scanAllRecordsAtOffset(&scanner, scanOffset,
+                   pAutoRepair);
+    pFirstFreeId = std::max(scanner.getLargestId(), snapshotLargestId) + 1;
     // Recreate the container structure
     IdMap::iterator it;
     ContainerList   orphans;
@@ -878,6 +910,7 @@ std::shared_ptr<IContainerMD> ChangeLogContainerMDSvc::createContainer()
   std::shared_ptr<IContainerMD> cont = std::make_shared<ContainerMD>
                                        (pFirstFreeId++, pFileSvc, this);
   pIdMap.insert(std::make_pair(cont->getId(), DataInfo(0, cont)));
+  notifyListeners(cont.get(), IContainerMDChangeListener::Created);
   return cont;
 }
 
@@ -1092,6 +1125,113 @@ ChangeLogContainerMDSvc::compactCommit(void* compactingData, bool autorepair)
   delete data;
 }
 
+//----------------------------------------------------------------------------
+// Prepare a boot snapshot of the changelog
+//----------------------------------------------------------------------------
+void*
+ChangeLogContainerMDSvc::snapshotPrepare()
+{
+  ChangeLogSnapshot::Data* data = new ChangeLogSnapshot::Data();
+  data->changeLogPath = pChangeLogPath;
+  data->contentFlag   = CONTAINER_LOG_MAGIC;
+  data->nextOffset    = pChangeLog->getNextOffset();
+  data->largestId     = pFirstFreeId - 1;
+  data->entries.reserve(pIdMap.size());
+
+  for (auto it = pIdMap.begin(); it != pIdMap.end(); ++it) {
+    if (it->second.logOffset) {
+      data->entries.push_back(ChangeLogSnapshot::Entry{it->first,
+                              it->second.logOffset});
+    }
+  }
+
+  return data;
+}
+
+//----------------------------------------------------------------------------
+// Write the boot snapshot
+//----------------------------------------------------------------------------
+void
+ChangeLogContainerMDSvc::snapshot(void*& snapshotData)
+{
+  ChangeLogSnapshot::Data* data = (ChangeLogSnapshot::Data*)snapshotData;
+
+  if (!data) {
+    MDException e(EINVAL);
+    e.getMessage() << "Snapshot data incorrect";
+    throw e;
+  }
+
+  snapshotData = 0;
+  std::unique_ptr<ChangeLogSnapshot::Data> holder(data);
+  ChangeLogSnapshot::write(*data);
+}
+
+//----------------------------------------------------------------------------
+// Fill the id map from the boot snapshot
+//----------------------------------------------------------------------------
+uint64_t
+ChangeLogContainerMDSvc::loadSnapshot(uint64_t& largestId)
+{
+  ChangeLogSnapshot snapshot;
+
+  if (!snapshot.load(pChangeLogPath, CONTAINER_LOG_MAGIC)) {
+    return pChangeLog->getFirstOffset();
+  }
+
+  time_t start_time = time(0);
+  const ChangeLogSnapshot::Entry* entries = snapshot.getEntries();
+  uint64_t num = snapshot.getNumEntries();
+  // The containers are recreated from the changelog records later on, here
+  // we only make sure that the index still matches the changelog
+  std::atomic<bool> error(false);
+
+  if (num) {
+    // Every thread reads into its own buffer, nothing to combine
+    eos::common::Parallel::For((uint64_t) 0, num, Buffer(),
+    [&](uint64_t n, Buffer & buffer) {
+      if (error) {
+        return;
+      }
+
+      try {
+        IContainerMD::id_t id = 0;
+
+        if (pChangeLog->readRecord(entries[n].logOffset, buffer) !=
+            UPDATE_RECORD_MAGIC) {
+          error = true;
+          return;
+        }
+
+        buffer.grabData(0, &id, sizeof(IContainerMD::id_t));
+
+        if (id != entries[n].id) {
+          error = true;
+        }
+      } catch (MDException& e) {
+        error = true;
+      }
+    }, [](Buffer&, Buffer&) { });
+  }
+
+  if (error) {
+    fprintf(stderr, "WARNING  [ snapshot does not match the directory changelog "
+            "- doing full scan ]\n");
+    return pChangeLog->getFirstOffset();
+  }
+
+  pIdMap.reserve(num);
+
+  for (uint64_t n = 0; n < num; ++n) {
+    pIdMap[entries[n].id] = DataInfo(entries[n].logOffset, nullptr);
+  }
+
+  fprintf(stderr, "INFO     [ loaded %lu directory records from snapshot in "
+          "%lus ]\n", num, time(0) - start_time);
+  largestId = snapshot.getLargestId();
+  return snapshot.getNextOffset();
+}
+
 //----------------------------------------------------------------------------
 // Start the slave
 //----------------------------------------------------------------------------
@@ -1103,6 +1243,9 @@ void ChangeLogContainerMDSvc::startSlave()
     throw e;
   }
 
+  // The lag counts from the start until the follower first catches up
+  setFollowCaughtUp(time(0));
+
   if (pthread_create(&pFollowerThread, 0, followerThread, this) != 0) {
     MDException e(errno);
     e.getMessage() << "ContainerMDSvc: unable to start the slave follower: ";
@@ -1147,6 +1290,7 @@ void ChangeLogContainerMDSvc::stopSlave()
   pSlaveStarted = false;
   pSlaveMode = false;
   pFollowerThread = 0;
+  setFollowCaughtUp(0);
   pFollowerDeletions.clear();
 }
 
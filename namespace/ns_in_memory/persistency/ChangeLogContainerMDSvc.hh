@@ -62,8 +62,9 @@ public:
   //--------------------------------------------------------------------------
   ChangeLogContainerMDSvc():
     pFirstFreeId(1), pFollowerThread(0), pSlaveLock(0), pSlaveMode(false),
-    pSlaveStarted(false), pSlavePoll(1000), pFollowStart(0), pQuotaStats(0),
-    pFileSvc(NULL), pAutoRepair(0), pResSize(1000000), pContainerAccounting(0)
+    pSlaveStarted(false), pSlavePoll(1000), pFollowStart(0), pFollowCaughtUp(0),
+    pQuotaStats(0), pFileSvc(NULL), pAutoRepair(0), pResSize(1000000),
+    pContainerAccounting(0)
   {
     pChangeLog = new ChangeLogFile();
     pthread_mutex_init(&pFollowStartMutex, 0);
@@ -198,6 +199,21 @@ public:
   //--------------------------------------------------------------------------
   void compactCommit(void* compactingData, bool autorepair = false) override;
 
+  //----------------------------------------------------------------------------
+  //! Prepare a boot snapshot of the changelog, needs at least a read lock on
+  //! the namespace
+  //!
+  //! @return snapshot information that needs to be passed to snapshot
+  //----------------------------------------------------------------------------
+  void* snapshotPrepare() override;
+
+  //----------------------------------------------------------------------------
+  //! Write the boot snapshot, does not need the namespace lock
+  //!
+  //! @param snapshotData state information returned by snapshotPrepare
+  //----------------------------------------------------------------------------
+  void snapshot(void*& snapshotData) override;
+
   //--------------------------------------------------------------------------
   //! Make a transition from slave to master
   // -----------------------------------------------------------------------
@@ -289,6 +305,30 @@ public:
     pthread_mutex_unlock(&pFollowStartMutex);
   }
 
+  //--------------------------------------------------------------------------
+  //! Get the follower lag in seconds
+  //--------------------------------------------------------------------------
+  uint64_t getFollowLag() override
+  {
+    time_t caughtUp;
+    pthread_mutex_lock(&pFollowStartMutex);
+    caughtUp = pFollowCaughtUp;
+    pthread_mutex_unlock(&pFollowStartMutex);
+    time_t now = time(0);
+    return (caughtUp && (now > caughtUp)) ? (uint64_t)(now - caughtUp) : 0;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Set the time at which the follower applied all the records, 0 when not
+  //! following
+  //--------------------------------------------------------------------------
+  void setFollowCaughtUp(time_t caughtUp)
+  {
+    pthread_mutex_lock(&pFollowStartMutex);
+    pFollowCaughtUp = caughtUp;
+    pthread_mutex_unlock(&pFollowStartMutex);
+  }
+
   //--------------------------------------------------------------------------
   //! Get the following poll interval
   //--------------------------------------------------------------------------
@@ -424,6 +464,15 @@ private:
   //--------------------------------------------------------------------------
   void attachBroken(IContainerMD* parent, ContainerList& broken);
 
+  //--------------------------------------------------------------------------
+  // Fill the id map from the boot snapshot
+  //
+  // @param largestId largest id recorded in the snapshot
+  //
+  // @return changelog offset from which the records have to be scanned
+  //--------------------------------------------------------------------------
+  uint64_t loadSnapshot(uint64_t& largestId);
+
   //--------------------------------------------------------------------------
   // Data members
   //--------------------------------------------------------------------------
@@ -440,6 +489,7 @@ private:
   int32_t            pSlavePoll;
   pthread_mutex_t    pFollowStartMutex;
   uint64_t           pFollowStart;
+  time_t             pFollowCaughtUp;
   IQuotaStats*       pQuotaStats;
   IFileMDSvc*        pFileSvc;
   bool               pAutoRepair;
@@ -42,6 +42,7 @@
 #include <cerrno>
 #include <cstring>
 #include <iomanip>
+#include <vector>
 #include <stdio.h>
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -726,7 +727,9 @@ uint64_t ChangeLogFile::scanAllRecordsAtOffset(ILogRecordScanner* scanner,
 // Follow a file
 //----------------------------------------------------------------------------
 uint64_t ChangeLogFile::follow(ILogRecordScanner* scanner,
-                               uint64_t           startOffset)
+                               uint64_t           startOffset,
+                               uint64_t           maxRecords,
+                               bool*              reachedEnd)
 {
   //--------------------------------------------------------------------------
   // Check if the file is open
@@ -737,49 +740,78 @@ uint64_t ChangeLogFile::follow(ILogRecordScanner* scanner,
     throw ex;
   }
 
+  if (reachedEnd) {
+    *reachedEnd = false;
+  }
+
   //--------------------------------------------------------------------------
-  // Off we go - we only exit if an error occurs
+  // The records are read ahead in blocks, one read per block instead of two
+  // per record, the block always holds a complete record of maximum size
   //--------------------------------------------------------------------------
+  static const unsigned blockSize = 1024 * 1024;
   Descriptor   fd(pFd);
   off_t        offset = startOffset;
-  uint16_t*    magic;
-  uint16_t*    size;
-  uint32_t*    chkSum1;
-//    uint64_t    *seq;
+  uint16_t     magic;
+  uint16_t     size;
+  uint32_t     chkSum1;
   uint32_t     chkSum2;
-  uint8_t*     type;
-  char         buffer[20];
+  uint8_t      type;
   Buffer       record;
-
-  while (1) {
-    //------------------------------------------------------------------------
-    // Read the header
-    //------------------------------------------------------------------------
-    unsigned bytesRead = 0;
+  std::vector<char> block(blockSize);
+  off_t        blockOffset = offset;
+  unsigned     blockFill = 0;
+  uint64_t     numRecords = 0;
+  //--------------------------------------------------------------------------
+  // Make sure the len bytes at offset are in the block, false if they are
+  // not in the file yet
+  //--------------------------------------------------------------------------
+  auto available = [&](unsigned len, const char * what) -> bool {
+    if ((offset >= blockOffset) &&
+        (offset + len <= blockOffset + (off_t) blockFill))
+    {
+      return true;
+    }
 
     try {
-      bytesRead = fd.tryRead(buffer, 20, offset);
-    } catch (DescriptorException& e) {
+      blockFill = fd.tryRead(block.data(), blockSize, offset);
+      blockOffset = offset;
+    } catch (DescriptorException& e)
+    {
       MDException ex(errno);
-      ex.getMessage() << "Follow: Error reading at offset: " << offset << ": ";
-      ex.getMessage() << e.getMessage().str();
+      ex.getMessage() << "Follow: Error reading " << what << " at offset: "
+                      << offset << ": " << e.getMessage().str();
       throw ex;
     }
 
-    if (bytesRead != 20) {
+    return (len <= blockFill);
+  };
+
+  while (1) {
+    if (maxRecords && (numRecords >= maxRecords)) {
+      return offset;
+    }
+
+    //------------------------------------------------------------------------
+    // Read the header
+    //------------------------------------------------------------------------
+    if (!available(20, "header")) {
+      if (reachedEnd) {
+        *reachedEnd = true;
+      }
+
       return offset;
     }
 
-    magic   = (uint16_t*)(buffer);
-    size    = (uint16_t*)(buffer + 2);
-    chkSum1 = (uint32_t*)(buffer + 4);
-//        seq     = (uint64_t*)(buffer+8);
-    type    = (uint8_t*)(buffer + 16);
+    const char* header = block.data() + (offset - blockOffset);
+    memcpy(&magic, header, 2);
+    memcpy(&size, header + 2, 2);
+    memcpy(&chkSum1, header + 4, 4);
+    memcpy(&type, header + 16, 1);
 
     //------------------------------------------------------------------------
     // Check the consistency
     //------------------------------------------------------------------------
-    if (*magic != RECORD_MAGIC) {
+    if (magic != RECORD_MAGIC) {
       MDException ex(EFAULT);
       ex.getMessage() << "Follow: Record's magic number is wrong at offset: "
                       << offset;
@@ -787,31 +819,23 @@ uint64_t ChangeLogFile::follow(ILogRecordScanner* scanner,
     }
 
     //------------------------------------------------------------------------
-    // Read the second part of the buffer
+    // Get the second part of the record
     //------------------------------------------------------------------------
-    record.resize(*size + 4, 0);
-    bytesRead = 0;
-
-    try {
-      bytesRead = fd.tryRead(record.getDataPtr(), *size + 4, offset + 20);
-    } catch (DescriptorException& e) {
-      MDException ex(errno);
-      ex.getMessage() << "Follow: Error reading at offset: " << offset + 9;
-      ex.getMessage() << ": " << e.getMessage().str();
-      throw ex;
-    }
+    if (!available(20 + size + 4, "record")) {
+      if (reachedEnd) {
+        *reachedEnd = true;
+      }
 
-    if ((ssize_t)bytesRead != (*size + 4)) {
       return offset;
     }
 
-    record.grabData(record.size() - 4, &chkSum2, 4);
-    record.resize(*size);
+    const char* data = block.data() + (offset - blockOffset) + 20;
+    memcpy(&chkSum2, data + size, 4);
 
     //------------------------------------------------------------------------
     // Check the checksum
     //------------------------------------------------------------------------
-    if (*chkSum1 != chkSum2) {
+    if (chkSum1 != chkSum2) {
       // evt. try to skip this record
       off_t newOffset = ChangeLogFile::findRecordMagic(pFd, offset + 4, (off_t)0);
 
@@ -841,11 +865,13 @@ uint64_t ChangeLogFile::follow(ILogRecordScanner* scanner,
     //------------------------------------------------------------------------
     // Call the listener and clean up
     //------------------------------------------------------------------------
-    scanner->processRecord(offset, *type, record);
-    offset += record.size();
+    record.clear();
+    record.putData(data, size);
+    scanner->processRecord(offset, type, record);
+    offset += size;
     offset += 24;
     scanner->publishOffset(offset);
-    record.clear();
+    ++numRecords;
   }
 }
 
@@ -214,9 +214,14 @@ public:
   //!
   //! @param scanner     a listener to be notified about a new record
   //! @param startOffset offset to start at
+  //! @param maxRecords  return after this number of records, so that the
+  //!                    caller can apply them while the file keeps growing,
+  //!                    0 for no limit
+  //! @param reachedEnd  set to true if all the complete records were scanned
   //! @return offset after the last successfully scanned record
   //------------------------------------------------------------------------
-  uint64_t follow(ILogRecordScanner* scanner, uint64_t startOffset);
+  uint64_t follow(ILogRecordScanner* scanner, uint64_t startOffset,
+                  uint64_t maxRecords = 0, bool* reachedEnd = 0);
 
   //------------------------------------------------------------------------
   //! Wait for a change in the changelog file using INOTIFY,
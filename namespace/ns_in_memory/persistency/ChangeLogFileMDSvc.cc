@@ -24,6 +24,7 @@
 #include "ChangeLogFileMDSvc.hh"
 #include "ChangeLogContainerMDSvc.hh"
 #include "ChangeLogConstants.hh"
+#include "ChangeLogSnapshot.hh"
 #include "common/ShellCmd.hh"
 #include "common/Parallel.hh"
 #include "namespace/Constants.hh"
@@ -34,6 +35,7 @@
 #include "XrdSys/XrdSysTimer.hh"
 
 #include <algorithm>
+#include <memory>
 #include <utility>
 #include <set>
 #include <features.h>
@@ -575,6 +577,14 @@ private:
 };
 }
 
+namespace
+{
+//------------------------------------------------------------------------------
+// Maximum number of records applied under one slave lock acquisition
+//------------------------------------------------------------------------------
+const uint64_t sFollowBatchRecords = 100000;
+}
+
 extern "C"
 {
   //----------------------------------------------------------------------------
@@ -592,13 +602,25 @@ extern "C"
     pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, 0);
 
     while (1) {
+      // The records are decoded without a lock and applied in batches, a
+      // slave far behind the master applies what it has read regularly
+      // instead of reading up to the end of a growing changelog first
+      bool atEnd = false;
       pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, 0);
-      offset = file->follow(&f, offset);
+      offset = file->follow(&f, offset, sFollowBatchRecords, &atEnd);
       fileSvc->setFollowOffset(offset);
       f.commit();
       fileSvc->setFollowOffset(offset);
+
+      if (atEnd) {
+        fileSvc->setFollowCaughtUp(time(0));
+      }
+
       pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, 0);
-      file->wait(pollInt);
+
+      if (atEnd) {
+        file->wait(pollInt);
+      }
     }
 
     return 0;
@@ -743,8 +765,17 @@ void ChangeLogFileMDSvc::initialize()
   if (!pSlaveMode || logIsCompacted) {
     FileMDScanner scanner(pIdMap, pSlaveMode);
     pChangeLog->mmap();
-    pFollowStart = pChangeLog->scanAllRecords(&scanner);
-    pFirstFreeId = scanner.getLargestId() + 1;
+    uint64_t scanOffset = pChangeLog->getFirstOffset();
+    uint64_t snapshotLargestId = 0;
+
+    // In the master mode the records covered by the snapshot are read
+    // directly and only the tail of the changelog is scanned
+    if (!pSlaveMode && ChangeLogSnapshot::isEnabled()) {
+      scanOffset = loadSnapshot(snapshotLargestId);
+    }
+
+    pFollowStart = pChangeLog->scanAllRecordsAtOffset(&scanner, scanOffset);
+    pFirstFreeId = std::max(scanner.getLargestId(), snapshotLargestId) + 1;
     time_t start_time = time(0);
     time_t now = start_time;
     uint64_t end = pIdMap.size();
@@ -1452,6 +1483,124 @@ void ChangeLogFileMDSvc::compactCommit(void* compactingData, bool autorepair)
   delete data;
 }
 
+//------------------------------------------------------------------------------
+// Prepare a boot snapshot of the changelog
+//------------------------------------------------------------------------------
+void* ChangeLogFileMDSvc::snapshotPrepare()
+{
+  ChangeLogSnapshot::Data* data = new ChangeLogSnapshot::Data();
+  data->changeLogPath = pChangeLogPath;
+  data->contentFlag   = FILE_LOG_MAGIC;
+  data->nextOffset    = pChangeLog->getNextOffset();
+  data->largestId     = pFirstFreeId - 1;
+  data->entries.reserve(pIdMap.size());
+
+  for (auto it = pIdMap.begin(); it != pIdMap.end(); ++it) {
+    if (it->second.logOffset) {
+      data->entries.push_back(ChangeLogSnapshot::Entry{it->first,
+                              it->second.logOffset});
+    }
+  }
+
+  return data;
+}
+
+//------------------------------------------------------------------------------
+// Write the boot snapshot
+//------------------------------------------------------------------------------
+void ChangeLogFileMDSvc::snapshot(void*& snapshotData)
+{
+  ChangeLogSnapshot::Data* data = (ChangeLogSnapshot::Data*)snapshotData;
+
+  if (!data) {
+    MDException e(EINVAL);
+    e.getMessage() << "Snapshot data incorrect" ;
+    throw e;
+  }
+
+  snapshotData = 0;
+  std::unique_ptr<ChangeLogSnapshot::Data> holder(data);
+  ChangeLogSnapshot::write(*data);
+}
+
+//------------------------------------------------------------------------------
+// Fill the id map from the boot snapshot
+//------------------------------------------------------------------------------
+uint64_t ChangeLogFileMDSvc::loadSnapshot(uint64_t& largestId)
+{
+  ChangeLogSnapshot snapshot;
+
+  if (!snapshot.load(pChangeLogPath, FILE_LOG_MAGIC)) {
+    return pChangeLog->getFirstOffset();
+  }
+
+  time_t start_time = time(0);
+  const ChangeLogSnapshot::Entry* entries = snapshot.getEntries();
+  uint64_t num = snapshot.getNumEntries();
+  std::vector<Buffer*> buffers(num, nullptr);
+  bool failed = false;
+  pIdMap.reserve(num);
+
+  for (uint64_t n = 0; n < num; ++n) {
+    DataInfo& d = pIdMap[entries[n].id];
+
+    if (d.buffer) {
+      failed = true;
+      break;
+    }
+
+    d.logOffset = entries[n].logOffset;
+    d.buffer = new Buffer(0);
+    buffers[n] = d.buffer;
+  }
+
+  // Read the records in parallel, pread on the changelog is thread safe
+  std::atomic<bool> error(failed);
+
+  if (!failed && num) {
+    eos::common::Parallel::For((uint64_t) 0, num, [&](uint64_t n) {
+      if (error) {
+        return;
+      }
+
+      try {
+        IFileMD::id_t id = 0;
+
+        if (pChangeLog->readRecord(entries[n].logOffset, *buffers[n]) !=
+            UPDATE_RECORD_MAGIC) {
+          error = true;
+          return;
+        }
+
+        buffers[n]->grabData(0, &id, sizeof(IFileMD::id_t));
+
+        if (id != entries[n].id) {
+          error = true;
+        }
+      } catch (MDException& e) {
+        error = true;
+      }
+    });
+  }
+
+  if (error) {
+    fprintf(stderr, "WARNING  [ snapshot does not match the file changelog - "
+            "doing full scan ]\n");
+
+    for (auto it = pIdMap.begin(); it != pIdMap.end(); ++it) {
+      delete it->second.buffer;
+    }
+
+    pIdMap.clear();
+    return pChangeLog->getFirstOffset();
+  }
+
+  fprintf(stderr, "INFO     [ loaded %lu file records from snapshot in %lus ]\n",
+          num, time(0) - start_time);
+  largestId = snapshot.getLargestId();
+  return snapshot.getNextOffset();
+}
+
 //------------------------------------------------------------------------------
 // Start the slave
 //------------------------------------------------------------------------------
@@ -1463,6 +1612,9 @@ void ChangeLogFileMDSvc::startSlave()
     throw e;
   }
 
+  // The lag counts from the start until the follower first catches up
+  setFollowCaughtUp(time(0));
+
   if (pthread_create(&pFollowerThread, 0, followerThread, this) != 0) {
     MDException e(errno);
     e.getMessage() << "ContainerMDSvc: unable to start the slave follower: ";
@@ -1507,6 +1659,7 @@ void ChangeLogFileMDSvc::stopSlave()
   pSlaveStarted = false;
   pSlaveMode = false;
   pFollowerThread = 0;
+  setFollowCaughtUp(0);
 }
 
 //------------------------------------------------------------------------------
@@ -57,8 +57,8 @@ public:
   ChangeLogFileMDSvc():
     pFirstFreeId(1), pChangeLog(0), pFollowerThread(0), pSlaveLock(0),
     pSlaveMode(false), pSlaveStarted(false), pSlavePoll(1000),
-    pFollowStart(0), pFollowPending(0), pContSvc(0), pQuotaStats(0),
-    pAutoRepair(0), pResSize(1000000)
+    pFollowStart(0), pFollowPending(0), pFollowCaughtUp(0), pContSvc(0),
+    pQuotaStats(0), pAutoRepair(0), pResSize(1000000)
   {
     pChangeLog = new ChangeLogFile;
     pthread_mutex_init(&pFollowStartMutex, 0);
@@ -210,6 +210,21 @@ public:
   //----------------------------------------------------------------------------
   void compactCommit(void* compactingData, bool autorepair = false) override;
 
+  //----------------------------------------------------------------------------
+  //! Prepare a boot snapshot of the changelog, needs at least a read lock on
+  //! the namespace
+  //!
+  //! @return snapshot information that needs to be passed to snapshot
+  //----------------------------------------------------------------------------
+  void* snapshotPrepare() override;
+
+  //----------------------------------------------------------------------------
+  //! Write the boot snapshot, does not need the namespace lock
+  //!
+  //! @param snapshotData state information returned by snapshotPrepare
+  //----------------------------------------------------------------------------
+  void snapshot(void*& snapshotData) override;
+
   //----------------------------------------------------------------------------
   //! Register slave lock
   //----------------------------------------------------------------------------
@@ -303,6 +318,30 @@ public:
     pthread_mutex_unlock(&pFollowStartMutex);
   }
 
+  //----------------------------------------------------------------------------
+  //! Get the follower lag in seconds
+  //----------------------------------------------------------------------------
+  uint64_t getFollowLag() override
+  {
+    time_t caughtUp;
+    pthread_mutex_lock(&pFollowStartMutex);
+    caughtUp = pFollowCaughtUp;
+    pthread_mutex_unlock(&pFollowStartMutex);
+    time_t now = time(0);
+    return (caughtUp && (now > caughtUp)) ? (uint64_t)(now - caughtUp) : 0;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Set the time at which the follower applied all the records, 0 when not
+  //! following
+  //----------------------------------------------------------------------------
+  void setFollowCaughtUp(time_t caughtUp)
+  {
+    pthread_mutex_lock(&pFollowStartMutex);
+    pFollowCaughtUp = caughtUp;
+    pthread_mutex_unlock(&pFollowStartMutex);
+  }
+
   //----------------------------------------------------------------------------
   //! Set the QuotaStats object for the follower
   //!
@@ -403,6 +442,15 @@ private:
   //----------------------------------------------------------------------------
   void attachBroken(const std::string& parent, IFileMD* file);
 
+  //----------------------------------------------------------------------------
+  // Fill the id map from the boot snapshot
+  //
+  // @param largestId largest id recorded in the snapshot
+  //
+  // @return changelog offset from which the records have to be scanned
+  //----------------------------------------------------------------------------
+  uint64_t loadSnapshot(uint64_t& largestId);
+
   //----------------------------------------------------------------------------
   // Data
   //----------------------------------------------------------------------------
@@ -419,6 +467,7 @@ private:
   pthread_mutex_t    pFollowStartMutex;
   uint64_t           pFollowStart;
   uint64_t           pFollowPending;
+  time_t             pFollowCaughtUp;
   ChangeLogContainerMDSvc* pContSvc;
   IQuotaStats*       pQuotaStats;
   bool               pAutoRepair;
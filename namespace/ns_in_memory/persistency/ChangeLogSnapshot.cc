@@ -0,0 +1,329 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+// desc:   Index snapshot of a changelog file used to speed up the boot
+//------------------------------------------------------------------------------
+
+#include "namespace/ns_in_memory/persistency/ChangeLogSnapshot.hh"
+#include "namespace/utils/DataHelper.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <vector>
+
+#define SNAPSHOT_MAGIC   "EOSNSSNP"
+#define SNAPSHOT_VERSION 1
+
+namespace
+{
+//----------------------------------------------------------------------------
+// Snapshot file header
+//----------------------------------------------------------------------------
+struct SnapshotHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t contentFlag;
+  uint64_t logDevice;
+  uint64_t logInode;
+  uint64_t nextOffset;
+  uint64_t largestId;
+  uint64_t numEntries;
+  uint32_t crc;
+  uint32_t logFingerprint;
+};
+
+//----------------------------------------------------------------------------
+// Compute the checksum of the entries, in chunks since the crc helpers take
+// 32 bit lengths
+//----------------------------------------------------------------------------
+uint32_t computeEntriesCRC32(const eos::ChangeLogSnapshot::Entry* entries,
+                             uint64_t num)
+{
+  const uint64_t chunk = 64 * 1024 * 1024;
+  char* ptr = (char*)entries;
+  uint64_t left = num * sizeof(eos::ChangeLogSnapshot::Entry);
+  uint32_t crc = eos::DataHelper::computeCRC32(ptr, 0);
+
+  while (left) {
+    uint64_t len = std::min(left, chunk);
+    crc = eos::DataHelper::updateCRC32(crc, ptr, len);
+    ptr += len;
+    left -= len;
+  }
+
+  return crc;
+}
+
+//----------------------------------------------------------------------------
+// Checksum of the beginning of the changelog, protects against a reused
+// inode number of a recreated changelog
+//----------------------------------------------------------------------------
+bool computeLogFingerprint(const std::string& path, uint64_t nextOffset,
+                           uint32_t& fingerprint)
+{
+  std::vector<char> buffer(std::min(nextOffset, (uint64_t)64 * 1024));
+  int fd = ::open(path.c_str(), O_RDONLY);
+
+  if (fd == -1) {
+    return false;
+  }
+
+  ssize_t nread = ::pread(fd, buffer.data(), buffer.size(), 0);
+  ::close(fd);
+
+  if ((nread < 0) || ((size_t)nread != buffer.size())) {
+    return false;
+  }
+
+  fingerprint = eos::DataHelper::computeCRC32(buffer.data(), buffer.size());
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Write the whole buffer
+//----------------------------------------------------------------------------
+bool writeAll(int fd, const char* buffer, uint64_t len)
+{
+  while (len) {
+    ssize_t nwrite = ::write(fd, buffer, len);
+
+    if (nwrite < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return false;
+    }
+
+    buffer += nwrite;
+    len -= nwrite;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Compare the entries by offset
+//----------------------------------------------------------------------------
+struct OffsetComparator {
+  bool operator()(const eos::ChangeLogSnapshot::Entry& a,
+                  const eos::ChangeLogSnapshot::Entry& b) const
+  {
+    return a.logOffset < b.logOffset;
+  }
+};
+}
+
+namespace eos
+{
+//----------------------------------------------------------------------------
+// Check if booting from snapshots is enabled
+//----------------------------------------------------------------------------
+bool ChangeLogSnapshot::isEnabled()
+{
+  return (getenv("EOS_NS_NO_SNAPSHOT") == 0);
+}
+
+//----------------------------------------------------------------------------
+// Write the snapshot
+//----------------------------------------------------------------------------
+void ChangeLogSnapshot::write(Data& data)
+{
+  struct stat info;
+
+  if (::stat(data.changeLogPath.c_str(), &info)) {
+    MDException ex(errno);
+    ex.getMessage() << "Snapshot: Unable to stat changelog "
+                    << data.changeLogPath;
+    throw ex;
+  }
+
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+
+  if (!computeLogFingerprint(data.changeLogPath, data.nextOffset,
+                             header.logFingerprint)) {
+    MDException ex(EIO);
+    ex.getMessage() << "Snapshot: Unable to read changelog "
+                    << data.changeLogPath;
+    throw ex;
+  }
+
+  std::sort(data.entries.begin(), data.entries.end(), ::OffsetComparator());
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version     = SNAPSHOT_VERSION;
+  header.contentFlag = data.contentFlag;
+  header.logDevice   = info.st_dev;
+  header.logInode    = info.st_ino;
+  header.nextOffset  = data.nextOffset;
+  header.largestId   = data.largestId;
+  header.numEntries  = data.entries.size();
+  header.crc         = computeEntriesCRC32(data.entries.data(),
+                       data.entries.size());
+  std::string path = getPath(data.changeLogPath);
+  std::string tmpPath = path + ".tmp";
+  int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if (fd == -1) {
+    MDException ex(errno);
+    ex.getMessage() << "Snapshot: Unable to create " << tmpPath;
+    throw ex;
+  }
+
+  if (!writeAll(fd, (const char*)&header, sizeof(header)) ||
+      !writeAll(fd, (const char*)data.entries.data(),
+                data.entries.size() * sizeof(Entry)) ||
+      fsync(fd)) {
+    MDException ex(errno);
+    ex.getMessage() << "Snapshot: Unable to write " << tmpPath;
+    ::close(fd);
+    ::unlink(tmpPath.c_str());
+    throw ex;
+  }
+
+  ::close(fd);
+
+  if (::rename(tmpPath.c_str(), path.c_str())) {
+    MDException ex(errno);
+    ex.getMessage() << "Snapshot: Unable to rename " << tmpPath << " to "
+                    << path;
+    ::unlink(tmpPath.c_str());
+    throw ex;
+  }
+}
+
+//----------------------------------------------------------------------------
+// Map the snapshot of the given changelog
+//----------------------------------------------------------------------------
+bool ChangeLogSnapshot::load(const std::string& changeLogPath,
+                             uint16_t contentFlag)
+{
+  close();
+  std::string path = getPath(changeLogPath);
+  struct stat logInfo;
+  struct stat info;
+
+  if (::stat(changeLogPath.c_str(), &logInfo)) {
+    return false;
+  }
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+
+  if (fd == -1) {
+    if (errno != ENOENT) {
+      fprintf(stderr, "WARNING  [ unable to open snapshot %s errno=%d ]\n",
+              path.c_str(), errno);
+    }
+
+    return false;
+  }
+
+  SnapshotHeader header;
+
+  if ((fstat(fd, &info)) ||
+      (::pread(fd, &header, sizeof(header), 0) != sizeof(header))) {
+    fprintf(stderr, "WARNING  [ unable to read snapshot %s ]\n", path.c_str());
+    ::close(fd);
+    return false;
+  }
+
+  const char* reason = 0;
+
+  if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) ||
+      (header.version != SNAPSHOT_VERSION) ||
+      (header.contentFlag != contentFlag)) {
+    reason = "wrong snapshot format";
+  } else if ((header.logDevice != (uint64_t)logInfo.st_dev) ||
+             (header.logInode != (uint64_t)logInfo.st_ino)) {
+    reason = "snapshot belongs to a different changelog";
+  } else if (header.nextOffset > (uint64_t)logInfo.st_size) {
+    reason = "changelog is shorter than the snapshot";
+  } else if ((uint64_t)info.st_size != sizeof(header) + header.numEntries *
+             sizeof(Entry)) {
+    reason = "snapshot is truncated";
+  } else {
+    uint32_t fingerprint = 0;
+
+    if (!computeLogFingerprint(changeLogPath, header.nextOffset, fingerprint) ||
+        (fingerprint != header.logFingerprint)) {
+      reason = "snapshot belongs to a different changelog";
+    }
+  }
+
+  if (reason) {
+    fprintf(stderr, "WARNING  [ ignoring snapshot %s: %s ]\n", path.c_str(),
+            reason);
+    ::close(fd);
+    return false;
+  }
+
+  pDataLen = info.st_size;
+  pData = (char*)::mmap(0, pDataLen, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+
+  if (pData == MAP_FAILED) {
+    fprintf(stderr, "WARNING  [ unable to mmap snapshot %s errno=%d ]\n",
+            path.c_str(), errno);
+    pData = 0;
+    pDataLen = 0;
+    return false;
+  }
+
+  pEntries = (const Entry*)(pData + sizeof(header));
+
+  if (computeEntriesCRC32(pEntries, header.numEntries) != header.crc) {
+    fprintf(stderr, "WARNING  [ ignoring snapshot %s: checksum mismatch ]\n",
+            path.c_str());
+    close();
+    return false;
+  }
+
+  pNumEntries = header.numEntries;
+  pNextOffset = header.nextOffset;
+  pLargestId  = header.largestId;
+  fprintf(stderr, "INFO     [ found snapshot %s entries=%lu next-offset=%lu ]\n",
+          path.c_str(), pNumEntries, pNextOffset);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Unmap the snapshot
+//----------------------------------------------------------------------------
+void ChangeLogSnapshot::close()
+{
+  if (pData) {
+    ::munmap(pData, pDataLen);
+  }
+
+  pData = 0;
+  pDataLen = 0;
+  pEntries = 0;
+  pNumEntries = 0;
+  pNextOffset = 0;
+  pLargestId = 0;
+}
+}
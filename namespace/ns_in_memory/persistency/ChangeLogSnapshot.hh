@@ -0,0 +1,160 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+// desc:   Index snapshot of a changelog file used to speed up the boot
+//------------------------------------------------------------------------------
+
+#ifndef EOS_NS_CHANGE_LOG_SNAPSHOT_HH
+#define EOS_NS_CHANGE_LOG_SNAPSHOT_HH
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "namespace/MDException.hh"
+
+namespace eos
+{
+//----------------------------------------------------------------------------
+//! Snapshot of the live records of a changelog file.
+//!
+//! The snapshot is stored next to the changelog as <changelog>.snapshot and
+//! holds a fixed size header followed by an array of (id, record offset)
+//! entries sorted by offset, so that it can be memory mapped as is. At boot
+//! the records listed in the snapshot are read directly from the changelog
+//! and only the tail starting at the recorded next offset is scanned. The
+//! snapshot is bound to the device, inode and a checksum of the beginning of
+//! the changelog, a compacted (renamed) changelog invalidates it.
+//----------------------------------------------------------------------------
+class ChangeLogSnapshot
+{
+public:
+  //------------------------------------------------------------------------
+  //! Index entry
+  //------------------------------------------------------------------------
+  struct Entry {
+    uint64_t id;
+    uint64_t logOffset;
+  };
+
+  //------------------------------------------------------------------------
+  //! State collected under the namespace lock and written without it
+  //------------------------------------------------------------------------
+  struct Data {
+    std::string changeLogPath;
+    uint16_t contentFlag;
+    uint64_t nextOffset;
+    uint64_t largestId;
+    std::vector<Entry> entries;
+  };
+
+  //------------------------------------------------------------------------
+  //! Constructor
+  //------------------------------------------------------------------------
+  ChangeLogSnapshot():
+    pData(0), pDataLen(0), pEntries(0), pNumEntries(0), pNextOffset(0),
+    pLargestId(0) {}
+
+  //------------------------------------------------------------------------
+  //! Destructor
+  //------------------------------------------------------------------------
+  ~ChangeLogSnapshot()
+  {
+    close();
+  }
+
+  //------------------------------------------------------------------------
+  //! Get the snapshot path belonging to a changelog file
+  //------------------------------------------------------------------------
+  static std::string getPath(const std::string& changeLogPath)
+  {
+    return changeLogPath + ".snapshot";
+  }
+
+  //------------------------------------------------------------------------
+  //! Check if booting from snapshots is enabled, EOS_NS_NO_SNAPSHOT
+  //! disables it
+  //------------------------------------------------------------------------
+  static bool isEnabled();
+
+  //------------------------------------------------------------------------
+  //! Write the snapshot atomically, the entries get sorted by offset
+  //!
+  //! @param data snapshot state obtained under the namespace lock
+  //------------------------------------------------------------------------
+  static void write(Data& data);
+
+  //------------------------------------------------------------------------
+  //! Map the snapshot of the given changelog
+  //!
+  //! @param changeLogPath path of the changelog file
+  //! @param contentFlag   content flag of the changelog
+  //!
+  //! @return true if a valid snapshot matching the changelog was found
+  //------------------------------------------------------------------------
+  bool load(const std::string& changeLogPath, uint16_t contentFlag);
+
+  //------------------------------------------------------------------------
+  //! Unmap the snapshot
+  //------------------------------------------------------------------------
+  void close();
+
+  //------------------------------------------------------------------------
+  //! Get the entries
+  //------------------------------------------------------------------------
+  const Entry* getEntries() const
+  {
+    return pEntries;
+  }
+
+  //------------------------------------------------------------------------
+  //! Get number of entries
+  //------------------------------------------------------------------------
+  uint64_t getNumEntries() const
+  {
+    return pNumEntries;
+  }
+
+  //------------------------------------------------------------------------
+  //! Get offset of the first changelog record not covered by the snapshot
+  //------------------------------------------------------------------------
+  uint64_t getNextOffset() const
+  {
+    return pNextOffset;
+  }
+
+  //------------------------------------------------------------------------
+  //! Get the largest id known when the snapshot was taken
+  //------------------------------------------------------------------------
+  uint64_t getLargestId() const
+  {
+    return pLargestId;
+  }
+
+private:
+  char*       pData; ///< mmap pointer
+  size_t      pDataLen; ///< mmap length
+  const Entry* pEntries;
+  uint64_t    pNumEntries;
+  uint64_t    pNextOffset;
+  uint64_t    pLargestId;
+};
+}
+
+#endif // EOS_NS_CHANGE_LOG_SNAPSHOT_HH
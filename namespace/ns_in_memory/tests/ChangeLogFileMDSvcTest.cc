@@ -28,6 +28,7 @@
 #include "namespace/utils/TestHelpers.hh"
 #include "namespace/ns_in_memory/persistency/ChangeLogFileMDSvc.hh"
 #include "namespace/ns_in_memory/persistency/ChangeLogContainerMDSvc.hh"
+#include "namespace/ns_in_memory/persistency/ChangeLogSnapshot.hh"
 
 
 //------------------------------------------------------------------------------
@@ -38,9 +39,11 @@ class ChangeLogFileMDSvcTest: public CppUnit::TestCase
   public:
     CPPUNIT_TEST_SUITE( ChangeLogFileMDSvcTest );
     CPPUNIT_TEST( reloadTest );
+    CPPUNIT_TEST( snapshotReloadTest );
     CPPUNIT_TEST_SUITE_END();
 
     void reloadTest();
+    void snapshotReloadTest();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( ChangeLogFileMDSvcTest );
@@ -115,3 +118,84 @@ void ChangeLogFileMDSvcTest::reloadTest()
   delete fileSvc;
   unlink( fileName.c_str() );
 }
+
+//------------------------------------------------------------------------------
+// Reload from a snapshot with records appended after it was taken
+//------------------------------------------------------------------------------
+void ChangeLogFileMDSvcTest::snapshotReloadTest()
+{
+  eos::ChangeLogContainerMDSvc *contSvc = new eos::ChangeLogContainerMDSvc;
+  eos::ChangeLogFileMDSvc      *fileSvc = new eos::ChangeLogFileMDSvc;
+  fileSvc->setContMDService( contSvc );
+
+  std::map<std::string, std::string> config;
+  std::string fileName = getTempName( "/tmp", "eosns" );
+  std::string snapName = eos::ChangeLogSnapshot::getPath( fileName );
+  config["changelog_path"] = fileName;
+  fileSvc->configure( config );
+  CPPUNIT_ASSERT_NO_THROW( fileSvc->initialize() );
+
+  std::shared_ptr<eos::IFileMD> file1 = fileSvc->createFile();
+  std::shared_ptr<eos::IFileMD> file2 = fileSvc->createFile();
+  std::shared_ptr<eos::IFileMD> file3 = fileSvc->createFile();
+  file1->setName( "file1" );
+  file2->setName( "file2" );
+  file3->setName( "file3" );
+  eos::IFileMD::id_t id1 = file1->getId();
+  eos::IFileMD::id_t id2 = file2->getId();
+  eos::IFileMD::id_t id3 = file3->getId();
+  fileSvc->updateStore( file1.get() );
+  fileSvc->updateStore( file2.get() );
+  fileSvc->updateStore( file3.get() );
+
+  void* snapData = fileSvc->snapshotPrepare();
+  CPPUNIT_ASSERT( snapData != 0 );
+  CPPUNIT_ASSERT_NO_THROW( fileSvc->snapshot( snapData ) );
+  CPPUNIT_ASSERT( snapData == 0 );
+  CPPUNIT_ASSERT( access( snapName.c_str(), R_OK ) == 0 );
+
+  //----------------------------------------------------------------------------
+  // Records in the tail of the changelog
+  //----------------------------------------------------------------------------
+  file1->setName( "file1_renamed" );
+  fileSvc->updateStore( file1.get() );
+  fileSvc->removeFile( file2.get() );
+  std::shared_ptr<eos::IFileMD> file4 = fileSvc->createFile();
+  file4->setName( "file4" );
+  eos::IFileMD::id_t id4 = file4->getId();
+  fileSvc->updateStore( file4.get() );
+  fileSvc->finalize();
+
+  CPPUNIT_ASSERT_NO_THROW( fileSvc->initialize() );
+  std::shared_ptr<eos::IFileMD> fileRec1 = fileSvc->getFileMD( id1 );
+  std::shared_ptr<eos::IFileMD> fileRec3 = fileSvc->getFileMD( id3 );
+  std::shared_ptr<eos::IFileMD> fileRec4 = fileSvc->getFileMD( id4 );
+  CPPUNIT_ASSERT( fileRec1->getName() == "file1_renamed" );
+  CPPUNIT_ASSERT( fileRec3->getName() == "file3" );
+  CPPUNIT_ASSERT( fileRec4->getName() == "file4" );
+  CPPUNIT_ASSERT_THROW( fileSvc->getFileMD( id2 ), eos::MDException );
+
+  std::shared_ptr<eos::IFileMD> file5 = fileSvc->createFile();
+  CPPUNIT_ASSERT( file5->getId() > id4 );
+  fileSvc->finalize();
+
+  //----------------------------------------------------------------------------
+  // A corrupted snapshot is ignored and the full changelog is scanned
+  //----------------------------------------------------------------------------
+  FILE* snap = fopen( snapName.c_str(), "r+" );
+  CPPUNIT_ASSERT( snap != 0 );
+  fseek( snap, -1, SEEK_END );
+  fputc( 0xff, snap );
+  fclose( snap );
+
+  CPPUNIT_ASSERT_NO_THROW( fileSvc->initialize() );
+  CPPUNIT_ASSERT( fileSvc->getFileMD( id1 )->getName() == "file1_renamed" );
+  CPPUNIT_ASSERT( fileSvc->getFileMD( id3 )->getName() == "file3" );
+  CPPUNIT_ASSERT_THROW( fileSvc->getFileMD( id2 ), eos::MDException );
+  fileSvc->finalize();
+
+  delete fileSvc;
+  delete contSvc;
+  unlink( fileName.c_str() );
+  unlink( snapName.c_str() );
+}
@@ -308,8 +308,13 @@ void* followerThread(void* data)
   uint64_t offset = file.getFirstOffset();
 
   while (1) {
-    offset = file.follow(&f, offset);
-    file.wait(1);
+    // small batches like a slave applying what it read
+    bool atEnd = false;
+    offset = file.follow(&f, offset, 7, &atEnd);
+
+    if (atEnd) {
+      file.wait(1);
+    }
   }
 
   return 0;
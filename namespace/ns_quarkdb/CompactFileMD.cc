@@ -0,0 +1,345 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/CompactFileMD.hh"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+
+EOSNSNAMESPACE_BEGIN
+
+constexpr size_t CompactXAttrs::sMaxInternedKeys;
+constexpr uint8_t CompactFileMD::kHasCTime;
+constexpr uint8_t CompactFileMD::kHasMTime;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Table of the interned attribute names, never shrinks so that the pointers
+// handed out stay valid
+//------------------------------------------------------------------------------
+struct InternTable {
+  std::shared_timed_mutex mMutex;
+  std::unordered_set<std::string> mKeys;
+};
+
+InternTable& getInternTable()
+{
+  static InternTable* table = new InternTable();
+  return *table;
+}
+}
+
+//------------------------------------------------------------------------------
+// Get the interned copy of a name
+//------------------------------------------------------------------------------
+const std::string*
+CompactXAttrs::intern(const std::string& key)
+{
+  InternTable& table = getInternTable();
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(table.mMutex);
+    auto it = table.mKeys.find(key);
+
+    if (it != table.mKeys.end()) {
+      return &(*it);
+    }
+  }
+  std::unique_lock<std::shared_timed_mutex> lock(table.mMutex);
+
+  if (table.mKeys.size() >= sMaxInternedKeys) {
+    auto it = table.mKeys.find(key);
+    return (it != table.mKeys.end()) ? &(*it) : nullptr;
+  }
+
+  return &(*table.mKeys.insert(key).first);
+}
+
+//------------------------------------------------------------------------------
+// Get number of distinct interned attribute names
+//------------------------------------------------------------------------------
+size_t
+CompactXAttrs::getNumInternedKeys()
+{
+  InternTable& table = getInternTable();
+  std::shared_lock<std::shared_timed_mutex> lock(table.mMutex);
+  return table.mKeys.size();
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+CompactXAttrs::~CompactXAttrs()
+{
+  releaseOwnedKeys();
+}
+
+//------------------------------------------------------------------------------
+// Copy constructor
+//------------------------------------------------------------------------------
+CompactXAttrs::CompactXAttrs(const CompactXAttrs& other)
+{
+  *this = other;
+}
+
+//------------------------------------------------------------------------------
+// Assignment operator
+//------------------------------------------------------------------------------
+CompactXAttrs&
+CompactXAttrs::operator=(const CompactXAttrs& other)
+{
+  if (this == &other) {
+    return *this;
+  }
+
+  releaseOwnedKeys();
+  mEntries = other.mEntries;
+
+  for (auto& entry : mEntries) {
+    if (entry.mOwnedKey) {
+      entry.mKey = new std::string(*entry.mKey);
+    }
+  }
+
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+// Release the names owned by the entries
+//------------------------------------------------------------------------------
+void
+CompactXAttrs::releaseOwnedKeys()
+{
+  for (auto& entry : mEntries) {
+    if (entry.mOwnedKey) {
+      delete entry.mKey;
+      entry.mOwnedKey = false;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get value of an attribute
+//------------------------------------------------------------------------------
+const std::string*
+CompactXAttrs::get(const std::string& key) const
+{
+  for (const auto& entry : mEntries) {
+    if (*entry.mKey == key) {
+      return &entry.mValue;
+    }
+  }
+
+  return nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Set value of an attribute
+//------------------------------------------------------------------------------
+void
+CompactXAttrs::set(const std::string& key, const std::string& value)
+{
+  for (auto& entry : mEntries) {
+    if (*entry.mKey == key) {
+      entry.mValue = value;
+      return;
+    }
+  }
+
+  const std::string* interned = intern(key);
+
+  if (interned) {
+    mEntries.push_back(Entry{interned, value, false});
+  } else {
+    mEntries.push_back(Entry{new std::string(key), value, true});
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove attribute
+//------------------------------------------------------------------------------
+void
+CompactXAttrs::erase(const std::string& key)
+{
+  for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+    if (*it->mKey == key) {
+      if (it->mOwnedKey) {
+        delete it->mKey;
+      }
+
+      mEntries.erase(it);
+      return;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove all attributes
+//------------------------------------------------------------------------------
+void
+CompactXAttrs::clear()
+{
+  releaseOwnedKeys();
+  mEntries.clear();
+  mEntries.shrink_to_fit();
+}
+
+//------------------------------------------------------------------------------
+// Copy constructor
+//------------------------------------------------------------------------------
+CompactFileMD::CompactFileMD(const CompactFileMD& other)
+{
+  *this = other;
+}
+
+//------------------------------------------------------------------------------
+// Assignment operator
+//------------------------------------------------------------------------------
+CompactFileMD&
+CompactFileMD::operator=(const CompactFileMD& other)
+{
+  if (this == &other) {
+    return *this;
+  }
+
+  mId = other.mId;
+  mContId = other.mContId;
+  mSize = other.mSize;
+  mUid = other.mUid;
+  mGid = other.mGid;
+  mLayoutId = other.mLayoutId;
+  mFlags = other.mFlags;
+  mPresent = other.mPresent;
+  mCTime = other.mCTime;
+  mMTime = other.mMTime;
+  mName = other.mName;
+  mLinkName.reset(other.mLinkName ? new std::string(*other.mLinkName) :
+                  nullptr);
+  mChecksum = other.mChecksum;
+  mLocations = other.mLocations;
+  mUnlinkedLocations = other.mUnlinkedLocations;
+  mXAttrs = other.mXAttrs;
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+// Set symbolic link
+//------------------------------------------------------------------------------
+void
+CompactFileMD::setLinkName(const std::string& link_name)
+{
+  if (link_name.empty()) {
+    mLinkName.reset();
+  } else {
+    mLinkName.reset(new std::string(link_name));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Fill from protobuf object
+//------------------------------------------------------------------------------
+void
+CompactFileMD::fromProto(const eos::ns::FileMdProto& proto)
+{
+  mId = proto.id();
+  mContId = proto.cont_id();
+  mSize = proto.size();
+  mUid = proto.uid();
+  mGid = proto.gid();
+  mLayoutId = proto.layout_id();
+  mFlags = proto.flags();
+  mPresent = 0;
+  mCTime = {0, 0};
+  mMTime = {0, 0};
+
+  if (proto.ctime().size() == sizeof(mCTime)) {
+    (void) memcpy(&mCTime, proto.ctime().data(), sizeof(mCTime));
+    mPresent |= kHasCTime;
+  }
+
+  if (proto.mtime().size() == sizeof(mMTime)) {
+    (void) memcpy(&mMTime, proto.mtime().data(), sizeof(mMTime));
+    mPresent |= kHasMTime;
+  }
+
+  mName = proto.name();
+  mName.shrink_to_fit();
+  setLinkName(proto.link_name());
+  mChecksum.assign((const unsigned char*) proto.checksum().data(),
+                   proto.checksum().size());
+  mLocations.assign(proto.locations().data(), proto.locations_size());
+  mUnlinkedLocations.assign(proto.unlink_locations().data(),
+                            proto.unlink_locations_size());
+  mXAttrs.clear();
+
+  for (const auto& elem : proto.xattrs()) {
+    mXAttrs.set(elem.first, elem.second);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Fill protobuf object
+//------------------------------------------------------------------------------
+void
+CompactFileMD::toProto(eos::ns::FileMdProto& proto) const
+{
+  proto.Clear();
+  proto.set_id(mId);
+  proto.set_cont_id(mContId);
+  proto.set_uid(mUid);
+  proto.set_gid(mGid);
+  proto.set_size(mSize);
+  proto.set_layout_id(mLayoutId);
+  proto.set_flags(mFlags);
+  proto.set_name(mName);
+
+  if (mLinkName) {
+    proto.set_link_name(*mLinkName);
+  }
+
+  if (mPresent & kHasCTime) {
+    proto.set_ctime(&mCTime, sizeof(mCTime));
+  }
+
+  if (mPresent & kHasMTime) {
+    proto.set_mtime(&mMTime, sizeof(mMTime));
+  }
+
+  if (!mChecksum.empty()) {
+    proto.set_checksum(mChecksum.data(), mChecksum.size());
+  }
+
+  proto.mutable_locations()->Reserve(mLocations.size());
+
+  for (const auto& loc : mLocations) {
+    proto.add_locations(loc);
+  }
+
+  proto.mutable_unlink_locations()->Reserve(mUnlinkedLocations.size());
+
+  for (const auto& loc : mUnlinkedLocations) {
+    proto.add_unlink_locations(loc);
+  }
+
+  auto* xattrs = proto.mutable_xattrs();
+  mXAttrs.forEach([xattrs](const std::string & key, const std::string & value) {
+    (*xattrs)[key] = value;
+  });
+}
+
+EOSNSNAMESPACE_END
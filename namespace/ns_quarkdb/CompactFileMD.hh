@@ -0,0 +1,327 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Compact in-memory representation of the file metadata
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include "proto/FileMd.pb.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <time.h>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Vector of trivially copyable elements keeping up to N of them inline,
+//! without any heap allocation. N should be chosen such that the inline
+//! elements take no more space than the heap pointer.
+//------------------------------------------------------------------------------
+template <typename T, uint32_t N>
+class InlineVector
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+                "InlineVector only supports trivially copyable types");
+
+public:
+  InlineVector(): mSize(0), mCapacity(N) {}
+
+  ~InlineVector()
+  {
+    if (isHeap()) {
+      delete[] mHeap;
+    }
+  }
+
+  InlineVector(const InlineVector& other): mSize(0), mCapacity(N)
+  {
+    assign(other.data(), other.size());
+  }
+
+  InlineVector& operator=(const InlineVector& other)
+  {
+    if (this != &other) {
+      mSize = 0;
+      assign(other.data(), other.size());
+    }
+
+    return *this;
+  }
+
+  inline uint32_t size() const
+  {
+    return mSize;
+  }
+
+  inline bool empty() const
+  {
+    return (mSize == 0);
+  }
+
+  inline T* data()
+  {
+    return isHeap() ? mHeap : mInline;
+  }
+
+  inline const T* data() const
+  {
+    return isHeap() ? mHeap : mInline;
+  }
+
+  inline const T* begin() const
+  {
+    return data();
+  }
+
+  inline const T* end() const
+  {
+    return data() + mSize;
+  }
+
+  inline const T& operator[](uint32_t index) const
+  {
+    return data()[index];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Replace the contents with the given elements
+  //----------------------------------------------------------------------------
+  void assign(const T* elems, uint32_t num)
+  {
+    reserve(num);
+
+    if (num) {
+      memcpy(data(), elems, num * sizeof(T));
+    }
+
+    mSize = num;
+  }
+
+  void push_back(const T& elem)
+  {
+    if (mSize == mCapacity) {
+      reserve(mCapacity * 2);
+    }
+
+    data()[mSize++] = elem;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove element at given position, keeping the order of the others
+  //----------------------------------------------------------------------------
+  void erase(uint32_t index)
+  {
+    T* elems = data();
+    memmove(elems + index, elems + index + 1,
+            (mSize - index - 1) * sizeof(T));
+    --mSize;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove all elements and release the heap storage
+  //----------------------------------------------------------------------------
+  void clear()
+  {
+    if (isHeap()) {
+      delete[] mHeap;
+    }
+
+    mSize = 0;
+    mCapacity = N;
+  }
+
+private:
+  inline bool isHeap() const
+  {
+    return (mCapacity > N);
+  }
+
+  void reserve(uint32_t capacity)
+  {
+    if (capacity <= mCapacity) {
+      return;
+    }
+
+    T* elems = new T[capacity];
+
+    if (mSize) {
+      memcpy(elems, data(), mSize * sizeof(T));
+    }
+
+    if (isHeap()) {
+      delete[] mHeap;
+    }
+
+    mHeap = elems;
+    mCapacity = capacity;
+  }
+
+  uint32_t mSize;
+  uint32_t mCapacity; ///< N while the elements are inline
+  union {
+    T mInline[N];
+    T* mHeap;
+  };
+};
+
+//------------------------------------------------------------------------------
+//! Extended attributes of a file stored as a vector with interned keys. The
+//! few distinct attribute names are shared by all the files, the values are
+//! owned by the entries.
+//------------------------------------------------------------------------------
+class CompactXAttrs
+{
+public:
+  //! Max number of distinct interned attribute names, beyond that the names
+  //! are allocated per entry
+  static constexpr size_t sMaxInternedKeys = 65536;
+
+  CompactXAttrs() = default;
+  ~CompactXAttrs();
+  CompactXAttrs(const CompactXAttrs& other);
+  CompactXAttrs& operator=(const CompactXAttrs& other);
+
+  //----------------------------------------------------------------------------
+  //! Get value of an attribute
+  //!
+  //! @return pointer to the value or nullptr if not found
+  //----------------------------------------------------------------------------
+  const std::string* get(const std::string& key) const;
+
+  //----------------------------------------------------------------------------
+  //! Set value of an attribute
+  //----------------------------------------------------------------------------
+  void set(const std::string& key, const std::string& value);
+
+  //----------------------------------------------------------------------------
+  //! Remove attribute
+  //----------------------------------------------------------------------------
+  void erase(const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Remove all attributes
+  //----------------------------------------------------------------------------
+  void clear();
+
+  inline size_t size() const
+  {
+    return mEntries.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Call the given function for every attribute
+  //----------------------------------------------------------------------------
+  template <typename Func>
+  void forEach(Func func) const
+  {
+    for (const auto& entry : mEntries) {
+      func(*entry.mKey, entry.mValue);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of distinct interned attribute names
+  //----------------------------------------------------------------------------
+  static size_t getNumInternedKeys();
+
+private:
+  struct Entry {
+    const std::string* mKey; ///< Interned, or owned if mOwnedKey is set
+    std::string mValue;
+    bool mOwnedKey;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the interned copy of a name
+  //!
+  //! @return interned name or nullptr if the table is full
+  //----------------------------------------------------------------------------
+  static const std::string* intern(const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Release the names owned by the entries
+  //----------------------------------------------------------------------------
+  void releaseOwnedKeys();
+
+  std::vector<Entry> mEntries;
+};
+
+//------------------------------------------------------------------------------
+//! Compact representation of eos::ns::FileMdProto: packed fixed size fields,
+//! locations and checksum stored inline for the common sizes, interned
+//! attribute names and the rarely used symbolic link kept out of line. The
+//! protobuf object is only built to serialize the file.
+//------------------------------------------------------------------------------
+struct CompactFileMD {
+  //! Mask values for mPresent, the proto3 bytes fields may be empty
+  static constexpr uint8_t kHasCTime = 0x1;
+  static constexpr uint8_t kHasMTime = 0x2;
+
+  uint64_t mId = 0;
+  uint64_t mContId = 0;
+  uint64_t mSize = 0;
+  uint32_t mUid = 0;
+  uint32_t mGid = 0;
+  uint32_t mLayoutId = 0;
+  uint16_t mFlags = 0;
+  uint8_t mPresent = 0;
+  struct timespec mCTime {0, 0};
+  struct timespec mMTime {0, 0};
+  std::string mName;
+  std::unique_ptr<std::string> mLinkName; ///< nullptr if not a link
+  InlineVector<unsigned char, 8> mChecksum; ///< Raw checksum bytes
+  InlineVector<uint32_t, 2> mLocations;
+  InlineVector<uint32_t, 2> mUnlinkedLocations;
+  CompactXAttrs mXAttrs;
+
+  CompactFileMD() = default;
+  CompactFileMD(const CompactFileMD& other);
+  CompactFileMD& operator=(const CompactFileMD& other);
+
+  //----------------------------------------------------------------------------
+  //! Fill from protobuf object
+  //----------------------------------------------------------------------------
+  void fromProto(const eos::ns::FileMdProto& proto);
+
+  //----------------------------------------------------------------------------
+  //! Fill protobuf object
+  //----------------------------------------------------------------------------
+  void toProto(eos::ns::FileMdProto& proto) const;
+
+  //----------------------------------------------------------------------------
+  //! Get symbolic link, empty if not a link
+  //----------------------------------------------------------------------------
+  inline const std::string& getLinkName() const
+  {
+    static const std::string empty;
+    return mLinkName ? *mLinkName : empty;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Set symbolic link
+  //----------------------------------------------------------------------------
+  void setLinkName(const std::string& link_name);
+};
+
+EOSNSNAMESPACE_END
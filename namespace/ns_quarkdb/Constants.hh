@@ -65,6 +65,24 @@ static const std::string sMaxSizeCacheFiles {"max_size_cache_files"};
 static const std::string sMaxNumCacheDirs {"max_num_cache_dirs"};
 //! Tag for max size (bytes) of dir/container entries cached at the MGM
 static const std::string sMaxSizeCacheDirs {"max_size_cache_dirs"};
+//! Tag for max num of negative (not found) lookups cached at the MGM
+static const std::string sMaxNumCacheNegative {"max_num_cache_negative"};
+//! Tag for max num of directory paths cached at the MGM for path lookups
+static const std::string sMaxNumCachePaths {"max_num_cache_paths"};
+//! Tag for number of files above which a container does not load its file map
+static const std::string sPagedFilesThreshold {"paged_files_threshold"};
+//! Tag for eviction policy (lru|clock) of the file cache at the MGM
+static const std::string sCachePolicyFiles {"cache_policy_files"};
+//! Tag for eviction policy (lru|clock) of the dir/container cache at the MGM
+static const std::string sCachePolicyDirs {"cache_policy_dirs"};
+//! Key holding the ids of the most recently used containers of the master
+static const std::string sCacheWarmupKey {"eos-container-md-warmup"};
+//! Key of the hash holding the batches of ids modified by the master
+static const std::string sCacheInvalidationKey {"eos-md-cache-invalidation"};
+//! Key holding the last invalidation batch number and publisher heartbeat
+static const std::string sCacheInvalidationSeqKey {"eos-md-cache-invalidation-seq"};
+//! Tag for the cache invalidation mode (off|publish|follow) at the MGM
+static const std::string sCacheInvalidation {"cache_invalidation"};
 }
 
 //! Variable associated with the QuotaView
@@ -98,6 +116,8 @@ static const std::string sFilesSuffix = "files";
 static const std::string sUnlinkedSuffix = "unlinked";
 //! Set suffix for file ids with no replicas
 static const std::string sNoReplicaPrefix = "fsview_noreplicas";
+//! Tag to load all the filesystem file lists in parallel when booting
+static const std::string sPrefetchFsLists = "prefetch_fs_lists";
 }
 
 EOSNSNAMESPACE_END
@@ -85,6 +85,7 @@ void QuarkContainerMD::setServices(IFileMDSvc* file_svc,
 
   pQcl = impl_cont_svc->pQcl;
   pFlusher = impl_cont_svc->pFlusher;
+  pNegativeCache = impl_cont_svc->getNegativeLookupCache();
 }
 
 //------------------------------------------------------------------------------
@@ -115,6 +116,7 @@ QuarkContainerMD& QuarkContainerMD::operator= (const QuarkContainerMD& other)
   pQcl     = other.pQcl;
   mClock   = other.mClock;
   pFlusher = other.pFlusher;
+  pNegativeCache = other.pNegativeCache;
   pDirsKey = other.pDirsKey;
   pFilesKey = other.pFilesKey;
   return *this;
@@ -130,7 +132,9 @@ QuarkContainerMD::InheritChildren(const IContainerMD& other)
     dynamic_cast<QuarkContainerMD&>(const_cast<IContainerMD&>(other));
   mFiles.get() = otherContainer.mFiles.get();
   mSubcontainers.get() = otherContainer.mSubcontainers.get();
+  mPagedFiles = otherContainer.mPagedFiles;
   setTreeSize(otherContainer.getTreeSize());
+  setTreeHash(otherContainer.getTreeHash());
 }
 
 //------------------------------------------------------------------------------
@@ -195,6 +199,11 @@ QuarkContainerMD::findItem(const std::string& name)
   }
 
   // This is not a ContainerMD.. maybe it's a FileMD?
+  if (mPagedFiles) {
+    lock.unlock();
+    return findPagedFile(name);
+  }
+
   auto iter2 = mFiles->find(name);
 
   if (iter2 != mFiles->end()) {
@@ -219,6 +228,149 @@ QuarkContainerMD::findItem(const std::string& name)
   return FileOrContainerMD {};
 }
 
+//------------------------------------------------------------------------------
+// Parse the reply of a HGET on the file map, 0 if the name does not exist
+//------------------------------------------------------------------------------
+static IFileMD::id_t parseFileIdReply(redisReplyPtr reply,
+                                      const std::string& name)
+{
+  if (!reply || (reply->type == REDIS_REPLY_NIL)) {
+    return 0;
+  }
+
+  if (reply->type != REDIS_REPLY_STRING) {
+    throw_mdexception(EFAULT, "Unexpected reply type while looking up file "
+                      << name << " in QDB");
+  }
+
+  int64_t id = 0;
+  Serialization::deserialize(reply->str, reply->len, id)
+  .throwIfNotOk(SSTR("Error while looking up file " << name << " in QDB: "));
+  return id;
+}
+
+//------------------------------------------------------------------------------
+// Find a file of a container whose file map is paged
+//------------------------------------------------------------------------------
+folly::Future<FileOrContainerMD>
+QuarkContainerMD::findPagedFile(const std::string& name)
+{
+  std::shared_ptr<PagedFileMap> paged = mPagedFiles;
+  IFileMD::id_t id = 0;
+  uint64_t generation = 0;
+  auto fetchFile = [this, name](IFileMD::id_t fid) {
+    if (fid == 0) {
+      return folly::makeFuture<FileOrContainerMD>(FileOrContainerMD {});
+    }
+
+    return pFileSvc->getFileMDFut(fid)
+           .then(wrapFileMD)
+    .onError([this, name](const folly::exception_wrapper & e) {
+      // Should not happen...
+      eos_static_crit("Exception occurred while looking up file with name %s "
+                      "in subcontainer with id %llu: %s", name.c_str(), getId(),
+                      e.what());
+      return FileOrContainerMD {};
+    });
+  };
+
+  switch (paged->find(name, id, generation)) {
+  case PagedFileMap::Lookup::kFound:
+    return fetchFile(id);
+
+  case PagedFileMap::Lookup::kMissing:
+    return FileOrContainerMD {};
+
+  default:
+    break;
+  }
+
+  return pQcl->follyExec("HGET", pFilesKey, name)
+  .then([paged, name, generation](redisReplyPtr reply) {
+    IFileMD::id_t fid = parseFileIdReply(reply, name);
+    paged->cache(name, fid, generation);
+    return fid;
+  })
+  .then(fetchFile)
+  .onError([this, name](const folly::exception_wrapper & e) {
+    eos_static_crit("Exception occurred while looking up file with name %s "
+                    "in paged container with id %llu: %s", name.c_str(),
+                    getId(), e.what());
+    return FileOrContainerMD {};
+  });
+}
+
+//------------------------------------------------------------------------------
+// Find the id of a file of a paged container, blocking, the caller holds the
+// container lock so that no other change can happen in between
+//------------------------------------------------------------------------------
+IContainerMD::id_t
+QuarkContainerMD::findPagedFileNoLock(const std::string& name)
+{
+  IFileMD::id_t id = 0;
+  uint64_t generation = 0;
+
+  if (mPagedFiles->find(name, id, generation) != PagedFileMap::Lookup::kUnknown) {
+    return id;
+  }
+
+  id = parseFileIdReply(pQcl->exec("HGET", pFilesKey, name).get(), name);
+  mPagedFiles->cache(name, id, generation);
+  return id;
+}
+
+//------------------------------------------------------------------------------
+// Wait for the pending changes of a paged container to reach QuarkDB so that
+// they can be dropped from memory
+//------------------------------------------------------------------------------
+void
+QuarkContainerMD::syncPagedFiles()
+{
+  std::shared_ptr<PagedFileMap> paged = mPagedFiles;
+
+  if (paged) {
+    uint64_t seq = paged->getChangeSeq();
+    pFlusher->synchronize();
+    paged->synchronized(seq);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get a page of the files of a paged container
+//------------------------------------------------------------------------------
+bool
+QuarkContainerMD::getFilesPage(std::string& cursor, FilePage& page)
+{
+  std::shared_ptr<PagedFileMap> paged = mPagedFiles;
+
+  if (!paged) {
+    return false;
+  }
+
+  MetadataFetcher::FileMapPage qdb_page;
+
+  try {
+    qdb_page = MetadataFetcher::getFilesPage(*pQcl, getIdentifier(),
+               (cursor.empty() ? "0" : cursor), kFilesPageSize).get();
+  } catch (const std::exception& e) {
+    eos_static_crit("Failed to scan the files of container id %llu: %s",
+                    getId(), e.what());
+    return false;
+  }
+
+  paged->filterPage(qdb_page.mFiles);
+  page = std::move(qdb_page.mFiles);
+
+  if (qdb_page.mCursor == "0") {
+    // Last page, the pending changes were filtered out of all pages
+    paged->getAddedFiles(page);
+    return false;
+  }
+
+  cursor = qdb_page.mCursor;
+  return true;
+}
+
 //------------------------------------------------------------------------------
 // Remove container
 //------------------------------------------------------------------------------
@@ -236,6 +388,7 @@ QuarkContainerMD::removeContainer(const std::string& name)
 
   mSubcontainers->erase(it);
   mSubcontainers->resize(0);
+  bumpChildrenVersion();
   // Delete container also from KV backend
   pFlusher->hdel(pDirsKey, name);
 }
@@ -265,9 +418,11 @@ QuarkContainerMD::addContainer(IContainerMD* container)
                       << " while a different subcontainer exists already there.");
   }
 
-  auto fileConflict = mFiles->find(container->getName());
+  bool fileConflict = (mPagedFiles ?
+                       (findPagedFileNoLock(container->getName()) != 0) :
+                       (mFiles->find(container->getName()) != mFiles->end()));
 
-  if (fileConflict != mFiles->end()) {
+  if (fileConflict) {
     eos_static_crit(eos::common::getStacktrace().c_str());
     throw_mdexception(EEXIST, "Attempted to add container with name "
                       << container->getName()
@@ -277,8 +432,13 @@ QuarkContainerMD::addContainer(IContainerMD* container)
   container->setParentId(mCont.id());
   (void) mSubcontainers->insert(std::make_pair(container->getName(),
                                 container->getId()));
+  bumpChildrenVersion();
   // Add to new container to KV backend
   pFlusher->hset(pDirsKey, container->getName(), stringify(container->getId()));
+
+  if (pNegativeCache) {
+    pNegativeCache->invalidate(getIdentifier(), container->getName());
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -341,20 +501,47 @@ QuarkContainerMD::addFile(IFileMD* file)
                       " while a subcontainer exists already there.");
   }
 
-  auto fileConflict = mFiles->find(file->getName());
+  IFileMD::id_t existing = 0;
 
-  if (fileConflict != mFiles->end() && fileConflict->second != file->getId()) {
+  if (mPagedFiles) {
+    existing = findPagedFileNoLock(file->getName());
+  } else {
+    auto fileConflict = mFiles->find(file->getName());
+
+    if (fileConflict != mFiles->end()) {
+      existing = fileConflict->second;
+    }
+  }
+
+  if (existing && existing != file->getId()) {
     eos_static_crit(eos::common::getStacktrace().c_str());
     throw_mdexception(EEXIST,
                       "Attempted to add file with name " << file->getName() <<
                       " while a different file exists already there.");
   }
 
+  bool sync = false;
   file->setContainerId(mCont.id());
-  (void)mFiles->insert(std::make_pair(file->getName(), file->getId()));
+
+  if (mPagedFiles) {
+    sync = mPagedFiles->insert(file->getName(), file->getId(), existing == 0);
+  } else {
+    (void)mFiles->insert(std::make_pair(file->getName(), file->getId()));
+  }
+
+  bumpChildrenVersion();
   pFlusher->hset(pFilesKey, file->getName(), std::to_string(file->getId()));
+
+  if (pNegativeCache) {
+    pNegativeCache->invalidate(getIdentifier(), file->getName());
+  }
+
   lock.unlock();
 
+  if (sync) {
+    syncPagedFiles();
+  }
+
   if (file->getSize() != 0u) {
     IFileMDChangeListener::Event e(file, IFileMDChangeListener::SizeChange, 0,
                                    file->getSize());
@@ -369,16 +556,35 @@ void
 QuarkContainerMD::removeFile(const std::string& name)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  auto iter = mFiles->find(name);
+  IFileMD::id_t id = 0;
+  bool sync = false;
+
+  if (mPagedFiles) {
+    id = findPagedFileNoLock(name);
 
-  if (iter != mFiles->end()) {
-    IFileMD::id_t id = iter->second;
-    mFiles->erase(iter);
-    mFiles->resize(0);
+    if (id) {
+      sync = mPagedFiles->erase(name);
+    }
+  } else {
+    auto iter = mFiles->find(name);
+
+    if (iter != mFiles->end()) {
+      id = iter->second;
+      mFiles->erase(iter);
+      mFiles->resize(0);
+    }
+  }
+
+  if (id) {
+    bumpChildrenVersion();
     pFlusher->hdel(pFilesKey, name);
+    lock.unlock();
+
+    if (sync) {
+      syncPagedFiles();
+    }
 
     try {
-      lock.unlock();
       std::shared_ptr<IFileMD> file = pFileSvc->getFileMD(id);
       // NOTE: This is an ugly hack. The file object has no reference to the
       // container id, therefore we hijack the "location" member of the Event
@@ -399,6 +605,11 @@ size_t
 QuarkContainerMD::getNumFiles()
 {
   std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+
+  if (mPagedFiles) {
+    return mPagedFiles->size();
+  }
+
   return mFiles->size();
 }
 
@@ -775,6 +986,23 @@ QuarkContainerMD::initialize(eos::ns::ContainerMdProto&& proto,
   pDirsKey = stringify(mCont.id()) + constants::sMapDirsSuffix;
 }
 
+//------------------------------------------------------------------------------
+// Initialize a container whose files are not loaded
+//------------------------------------------------------------------------------
+void
+QuarkContainerMD::initializePagedFiles(eos::ns::ContainerMdProto&& proto,
+                                       uint64_t num_files,
+                                       IContainerMD::ContainerMap&& containerMap)
+{
+  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+  mCont = std::move(proto);
+  mPagedFiles = std::make_shared<PagedFileMap>(num_files);
+  mSubcontainers.get() = std::move(containerMap);
+  // Rebuild the file and subcontainer keys
+  pFilesKey = stringify(mCont.id()) + constants::sMapFilesSuffix;
+  pDirsKey = stringify(mCont.id()) + constants::sMapDirsSuffix;
+}
+
 //------------------------------------------------------------------------------
 // Initialize from a ContainerMdProto object, without loading children maps.
 //------------------------------------------------------------------------------
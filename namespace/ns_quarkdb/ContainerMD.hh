@@ -28,6 +28,8 @@
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
+#include "namespace/ns_quarkdb/NegativeLookupCache.hh"
+#include "namespace/ns_quarkdb/PagedFileMap.hh"
 #include "proto/ContainerMd.pb.h"
 #include "common/FutureWrapper.hh"
 #include <sys/time.h>
@@ -278,6 +280,26 @@ public:
   //----------------------------------------------------------------------------
   uint64_t updateTreeSize(int64_t delta) override;
 
+  //----------------------------------------------------------------------------
+  //! Get tree hash
+  //----------------------------------------------------------------------------
+  inline uint64_t
+  getTreeHash() const override
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+    return mCont.tree_hash();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Set tree hash
+  //----------------------------------------------------------------------------
+  inline void
+  setTreeHash(uint64_t tree_hash) override
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    mCont.set_tree_hash(tree_hash);
+  }
+
   //----------------------------------------------------------------------------
   //! Get name
   //----------------------------------------------------------------------------
@@ -433,6 +455,18 @@ public:
   //----------------------------------------------------------------------------
   void initializeWithoutChildren(eos::ns::ContainerMdProto&& proto);
 
+  //----------------------------------------------------------------------------
+  //! Initialize a container with too many files to load them, the files are
+  //! looked up and iterated in QuarkDB
+  //!
+  //! @param proto container protobuf
+  //! @param num_files number of files of the container
+  //! @param containerMap subcontainers
+  //----------------------------------------------------------------------------
+  void initializePagedFiles(eos::ns::ContainerMdProto&& proto,
+                            uint64_t num_files,
+                            IContainerMD::ContainerMap&& containerMap);
+
   //----------------------------------------------------------------------------
   //! Get value tracking changes to the metadata object
   //----------------------------------------------------------------------------
@@ -508,17 +542,54 @@ private:
     return mFiles->end();
   }
 
+  //! Number of files asked to QuarkDB per page of a paged container
+  static constexpr size_t kFilesPageSize = 10000;
+
+  //----------------------------------------------------------------------------
+  //! Check if the files are not loaded in memory
+  //----------------------------------------------------------------------------
+  bool hasPagedFiles() const override
+  {
+    return (mPagedFiles != nullptr);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the next page of files of a container with paged files
+  //----------------------------------------------------------------------------
+  bool getFilesPage(std::string& cursor, FilePage& page) override;
+
+  //----------------------------------------------------------------------------
+  //! Look up a file of a container with paged files, asynchronously
+  //----------------------------------------------------------------------------
+  folly::Future<FileOrContainerMD> findPagedFile(const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Look up the id of a file of a container with paged files, blocking on
+  //! QuarkDB if the name is not known locally. Requires the lock.
+  //!
+  //! @return file id, 0 if there is no such file
+  //----------------------------------------------------------------------------
+  IContainerMD::id_t findPagedFileNoLock(const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Wait for the flusher so that the pending file changes can be dropped
+  //----------------------------------------------------------------------------
+  void syncPagedFiles();
+
   eos::ns::ContainerMdProto mCont;      ///< Protobuf container representation
   IContainerMDSvc* pContSvc = nullptr;  ///< Container metadata service
   IFileMDSvc* pFileSvc = nullptr;       ///< File metadata service
   std::shared_ptr<MetadataFlusher> pFlusher; ///< Metadata flusher object
   qclient::QClient* pQcl;               ///< QClient object
+  NegativeLookupCache* pNegativeCache = nullptr; ///< Cache of failed lookups
   std::string pFilesKey;                ///< Map files key
   std::string pDirsKey;                 ///< Map dir key
   uint64_t mClock;                      ///< Value tracking changes
 
   common::FutureWrapper<ContainerMap> mSubcontainers;
   common::FutureWrapper<FileMap> mFiles;
+  //! Set instead of mFiles if the container has too many files to load them
+  std::shared_ptr<PagedFileMap> mPagedFiles;
 };
 
 EOSNSNAMESPACE_END
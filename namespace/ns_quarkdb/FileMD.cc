@@ -45,7 +45,7 @@ QuarkFileMD::QuarkFileMD()
 QuarkFileMD::QuarkFileMD(IFileMD::id_t id, IFileMDSvc* fileMDSvc):
   pFileMDSvc(fileMDSvc)
 {
-  mFile.set_id(id);
+  mFile.mId = id;
   mClock = std::chrono::high_resolution_clock::now().time_since_epoch().count();
 }
 
@@ -91,7 +91,7 @@ void QuarkFileMD::setName(const std::string& name)
   }
 
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_name(name);
+  mFile.mName = name;
 }
 
 //------------------------------------------------------------------------------
@@ -106,7 +106,7 @@ QuarkFileMD::addLocation(location_t location)
     return;
   }
 
-  mFile.add_locations(location);
+  mFile.mLocations.push_back(location);
   lock.unlock();
   IFileMDChangeListener::Event e(this, IFileMDChangeListener::LocationAdded,
                                  location);
@@ -121,10 +121,9 @@ QuarkFileMD::removeLocation(location_t location)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
 
-  for (auto it = mFile.mutable_unlink_locations()->cbegin();
-       it != mFile.mutable_unlink_locations()->cend(); ++it) {
-    if (*it == location) {
-      it = mFile.mutable_unlink_locations()->erase(it);
+  for (uint32_t i = 0; i < mFile.mUnlinkedLocations.size(); ++i) {
+    if (mFile.mUnlinkedLocations[i] == location) {
+      mFile.mUnlinkedLocations.erase(i);
       lock.unlock();
       IFileMDChangeListener::Event
       e(this, IFileMDChangeListener::LocationRemoved, location);
@@ -142,13 +141,11 @@ QuarkFileMD::removeAllLocations()
 {
   while (true) {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.unlink_locations().cbegin();
-
-    if (it == mFile.unlink_locations().cend()) {
+    if (mFile.mUnlinkedLocations.empty()) {
       return;
     }
 
-    location_t location = *it;
+    location_t location = mFile.mUnlinkedLocations[0];
     lock.unlock();
     removeLocation(location);
   }
@@ -162,11 +159,10 @@ QuarkFileMD::unlinkLocation(location_t location)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
 
-  for (auto it = mFile.mutable_locations()->cbegin();
-       it != mFile.mutable_locations()->cend(); ++it) {
-    if (*it == location) {
-      mFile.add_unlink_locations(*it);
-      it = mFile.mutable_locations()->erase(it);
+  for (uint32_t i = 0; i < mFile.mLocations.size(); ++i) {
+    if (mFile.mLocations[i] == location) {
+      mFile.mUnlinkedLocations.push_back(location);
+      mFile.mLocations.erase(i);
       lock.unlock();
       IFileMDChangeListener::Event
       e(this, IFileMDChangeListener::LocationUnlinked, location);
@@ -184,13 +180,11 @@ QuarkFileMD::unlinkAllLocations()
 {
   while (true) {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.locations().cbegin();
-
-    if (it == mFile.locations().cend()) {
+    if (mFile.mLocations.empty()) {
       return;
     }
 
-    location_t location = *it;
+    location_t location = mFile.mLocations[0];
     lock.unlock();
     unlinkLocation(location);
   }
@@ -205,7 +199,7 @@ QuarkFileMD::getEnv(std::string& env, bool escapeAnd)
   std::shared_lock<std::shared_timed_mutex> lock(mMutex);
   env = "";
   std::ostringstream oss;
-  std::string saveName = mFile.name();
+  std::string saveName = mFile.mName;
 
   if (escapeAnd) {
     if (!saveName.empty()) {
@@ -225,37 +219,36 @@ QuarkFileMD::getEnv(std::string& env, bool escapeAnd)
   ctime_t mtime;
   (void) getCTimeNoLock(ctime);
   (void) getMTimeNoLock(mtime);
-  oss << "name=" << saveName << "&id=" << mFile.id()
+  oss << "name=" << saveName << "&id=" << mFile.mId
       << "&ctime=" << ctime.tv_sec << "&ctime_ns=" << ctime.tv_nsec
       << "&mtime=" << mtime.tv_sec << "&mtime_ns=" << mtime.tv_nsec
-      << "&size=" << mFile.size() << "&cid=" << mFile.cont_id()
-      << "&uid=" << mFile.uid() << "&gid=" << mFile.gid()
-      << "&lid=" << mFile.layout_id() << "&flags=" << mFile.flags()
-      << "&link=" << mFile.link_name();
+      << "&size=" << mFile.mSize << "&cid=" << mFile.mContId
+      << "&uid=" << mFile.mUid << "&gid=" << mFile.mGid
+      << "&lid=" << mFile.mLayoutId << "&flags=" << mFile.mFlags
+      << "&link=" << mFile.getLinkName();
   env += oss.str();
   env += "&location=";
   char locs[16];
 
-  for (const auto& elem : mFile.locations()) {
+  for (const auto& elem : mFile.mLocations) {
     snprintf(static_cast<char*>(locs), sizeof(locs), "%u", elem);
     env += static_cast<char*>(locs);
     env += ",";
   }
 
-  for (const auto& elem : mFile.unlink_locations()) {
+  for (const auto& elem : mFile.mUnlinkedLocations) {
     snprintf(static_cast<char*>(locs), sizeof(locs), "!%u", elem);
     env += static_cast<char*>(locs);
     env += ",";
   }
 
   env += "&checksum=";
-  uint8_t size = mFile.checksum().size();
+  uint8_t size = mFile.mChecksum.size();
 
   for (uint8_t i = 0; i < size; i++) {
     char hx[3];
     hx[0] = 0;
-    snprintf(static_cast<char*>(hx), sizeof(hx), "%02x",
-             *(unsigned char*)(mFile.checksum().data() + i));
+    snprintf(static_cast<char*>(hx), sizeof(hx), "%02x", mFile.mChecksum[i]);
     env += static_cast<char*>(hx);
   }
 }
@@ -276,8 +269,10 @@ QuarkFileMD::serialize(eos::Buffer& buffer)
 
   // Increase clock to mark that metadata file has suffered updates
   mClock = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+  eos::ns::FileMdProto proto;
+  mFile.toProto(proto);
   // Align the buffer to 4 bytes to efficiently compute the checksum
-  size_t obj_size = mFile.ByteSizeLong();
+  size_t obj_size = proto.ByteSizeLong();
   uint32_t align_size = (obj_size + 3) >> 2 << 2;
   size_t sz = sizeof(align_size);
   size_t msg_size = align_size + 2 * sz;
@@ -287,7 +282,7 @@ QuarkFileMD::serialize(eos::Buffer& buffer)
   const char* ptr = buffer.getDataPtr() + 2 * sz;
   google::protobuf::io::ArrayOutputStream aos((void*)ptr, align_size);
 
-  if (!mFile.SerializeToZeroCopyStream(&aos)) {
+  if (!proto.SerializeToZeroCopyStream(&aos)) {
     MDException ex(EIO);
     ex.getMessage() << "Failed while serializing buffer";
     throw ex;
@@ -310,7 +305,7 @@ void
 QuarkFileMD::initialize(eos::ns::FileMdProto&& proto)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile = std::move(proto);
+  mFile.fromProto(proto);
 }
 
 //------------------------------------------------------------------------------
@@ -319,8 +314,10 @@ QuarkFileMD::initialize(eos::ns::FileMdProto&& proto)
 void
 QuarkFileMD::deserialize(const eos::Buffer& buffer)
 {
+  eos::ns::FileMdProto proto;
+  Serialization::deserializeFile(buffer, proto);
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  Serialization::deserializeFile(buffer, mFile);
+  mFile.fromProto(proto);
 }
 
 //------------------------------------------------------------------------------
@@ -330,8 +327,8 @@ void
 QuarkFileMD::setSize(uint64_t size)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  int64_t sizeChange = (size & 0x0000ffffffffffff) - mFile.size();
-  mFile.set_size(size & 0x0000ffffffffffff);
+  int64_t sizeChange = (size & 0x0000ffffffffffff) - mFile.mSize;
+  mFile.mSize = (size & 0x0000ffffffffffff);
   lock.unlock();
   IFileMDChangeListener::Event e(this, IFileMDChangeListener::SizeChange, 0,
                                  sizeChange);
@@ -344,7 +341,7 @@ QuarkFileMD::setSize(uint64_t size)
 void
 QuarkFileMD::getCTimeNoLock(ctime_t& ctime) const
 {
-  (void) memcpy(&ctime, mFile.ctime().data(), sizeof(ctime_t));
+  ctime = mFile.mCTime;
 }
 
 //------------------------------------------------------------------------------
@@ -364,7 +361,8 @@ void
 QuarkFileMD::setCTime(ctime_t ctime)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_ctime(&ctime, sizeof(ctime));
+  mFile.mCTime = ctime;
+  mFile.mPresent |= CompactFileMD::kHasCTime;
 }
 
 //----------------------------------------------------------------------------
@@ -391,7 +389,7 @@ QuarkFileMD::setCTimeNow()
 void
 QuarkFileMD::getMTimeNoLock(ctime_t& mtime) const
 {
-  (void) memcpy(&mtime, mFile.mtime().data(), sizeof(ctime_t));
+  mtime = mFile.mMTime;
 }
 
 //------------------------------------------------------------------------------
@@ -411,7 +409,8 @@ void
 QuarkFileMD::setMTime(ctime_t mtime)
 {
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_mtime(&mtime, sizeof(mtime));
+  mFile.mMTime = mtime;
+  mFile.mPresent |= CompactFileMD::kHasMTime;
 }
 
 //------------------------------------------------------------------------------
@@ -441,9 +440,10 @@ QuarkFileMD::getAttributes() const
   std::shared_lock<std::shared_timed_mutex> lock(mMutex);
   std::map<std::string, std::string> xattrs;
 
-  for (const auto& elem : mFile.xattrs()) {
-    xattrs.insert(elem);
-  }
+  mFile.mXAttrs.forEach([&xattrs](const std::string & key,
+  const std::string & value) {
+    xattrs.emplace(key, value);
+  });
 
   return xattrs;
 }
@@ -453,8 +453,8 @@ QuarkFileMD::hasUnlinkedLocation(IFileMD::location_t location)
 {
   std::shared_lock<std::shared_timed_mutex> lock(mMutex);
 
-  for (int i = 0; i < mFile.unlink_locations_size(); ++i) {
-    if (mFile.unlink_locations()[i] == location) {
+  for (const auto& loc : mFile.mUnlinkedLocations) {
+    if (loc == location) {
       return true;
     }
   }
@@ -26,6 +26,7 @@
 
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
+#include "namespace/ns_quarkdb/CompactFileMD.hh"
 #include "proto/FileMd.pb.h"
 #include <cstdint>
 #include <sys/time.h>
@@ -115,7 +116,7 @@ public:
   getId() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.id();
+    return mFile.mId;
   }
 
   //----------------------------------------------------------------------------
@@ -124,7 +125,7 @@ public:
   inline FileIdentifier getIdentifier() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return FileIdentifier(mFile.id());
+    return FileIdentifier(mFile.mId);
   }
 
   //----------------------------------------------------------------------------
@@ -134,7 +135,7 @@ public:
   getSize() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.size();
+    return mFile.mSize;
   }
 
   //----------------------------------------------------------------------------
@@ -149,7 +150,7 @@ public:
   getContainerId() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.cont_id();
+    return mFile.mContId;
   }
 
   //----------------------------------------------------------------------------
@@ -159,7 +160,7 @@ public:
   setContainerId(IContainerMD::id_t containerId) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_cont_id(containerId);
+    mFile.mContId = containerId;
   }
 
   //----------------------------------------------------------------------------
@@ -169,8 +170,8 @@ public:
   getChecksum() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    Buffer buff(mFile.checksum().size());
-    buff.putData((void*)mFile.checksum().data(), mFile.checksum().size());
+    Buffer buff(mFile.mChecksum.size());
+    buff.putData((void*)mFile.mChecksum.data(), mFile.mChecksum.size());
     return buff;
   }
 
@@ -181,7 +182,8 @@ public:
   setChecksum(const Buffer& checksum) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_checksum(checksum.getDataPtr(), checksum.getSize());
+    mFile.mChecksum.assign((const unsigned char*) checksum.getDataPtr(),
+                          checksum.getSize());
   }
 
   //----------------------------------------------------------------------------
@@ -191,7 +193,7 @@ public:
   clearChecksum(uint8_t size = 20) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_checksum();
+    mFile.mChecksum.clear();
   }
 
   //----------------------------------------------------------------------------
@@ -204,7 +206,7 @@ public:
   setChecksum(const void* checksum, uint8_t size) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_checksum(checksum, size);
+    mFile.mChecksum.assign((const unsigned char*) checksum, size);
   }
 
   //----------------------------------------------------------------------------
@@ -214,7 +216,7 @@ public:
   getName() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.name();
+    return mFile.mName;
   }
 
   //----------------------------------------------------------------------------
@@ -233,7 +235,8 @@ public:
   inline LocationVector getLocations() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    LocationVector locations(mFile.locations().begin(), mFile.locations().end());
+    LocationVector locations(mFile.mLocations.begin(),
+                             mFile.mLocations.end());
     return locations;
   }
 
@@ -245,8 +248,8 @@ public:
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
 
-    if (index < (unsigned int)mFile.locations_size()) {
-      return mFile.locations(index);
+    if (index < mFile.mLocations.size()) {
+      return mFile.mLocations[index];
     }
 
     return 0;
@@ -269,7 +272,7 @@ public:
   clearLocations() override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_locations();
+    mFile.mLocations.clear();
   }
 
   //----------------------------------------------------------------------------
@@ -278,8 +281,8 @@ public:
   bool
   hasLocationNoLock(location_t location)
   {
-    for (int i = 0; i < mFile.locations_size(); i++) {
-      if (mFile.locations(i) == location) {
+    for (const auto& loc : mFile.mLocations) {
+      if (loc == location) {
         return true;
       }
     }
@@ -304,7 +307,7 @@ public:
   getNumLocation() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.locations_size();
+    return mFile.mLocations.size();
   }
 
   //----------------------------------------------------------------------------
@@ -313,8 +316,8 @@ public:
   inline LocationVector getUnlinkedLocations() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    LocationVector unlinked_locations(mFile.unlink_locations().begin(),
-                                      mFile.unlink_locations().end());
+    LocationVector unlinked_locations(mFile.mUnlinkedLocations.begin(),
+                                      mFile.mUnlinkedLocations.end());
     return unlinked_locations;
   }
 
@@ -335,7 +338,7 @@ public:
   clearUnlinkedLocations() override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_unlink_locations();
+    mFile.mUnlinkedLocations.clear();
   }
 
   //----------------------------------------------------------------------------
@@ -351,7 +354,7 @@ public:
   getNumUnlinkedLocation() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.unlink_locations_size();
+    return mFile.mUnlinkedLocations.size();
   }
 
   //----------------------------------------------------------------------------
@@ -361,7 +364,7 @@ public:
   getCUid() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.uid();
+    return mFile.mUid;
   }
 
   //----------------------------------------------------------------------------
@@ -371,7 +374,7 @@ public:
   setCUid(uid_t uid) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_uid(uid);
+    mFile.mUid = uid;
   }
 
   //----------------------------------------------------------------------------
@@ -381,7 +384,7 @@ public:
   getCGid() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.gid();
+    return mFile.mGid;
   }
 
   //----------------------------------------------------------------------------
@@ -391,7 +394,7 @@ public:
   setCGid(gid_t gid) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_gid(gid);
+    mFile.mGid = gid;
   }
 
   //----------------------------------------------------------------------------
@@ -401,7 +404,7 @@ public:
   getLayoutId() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.layout_id();
+    return mFile.mLayoutId;
   }
 
   //----------------------------------------------------------------------------
@@ -411,7 +414,7 @@ public:
   setLayoutId(layoutId_t layoutId) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_layout_id(layoutId);
+    mFile.mLayoutId = layoutId;
   }
 
   //----------------------------------------------------------------------------
@@ -421,7 +424,7 @@ public:
   getFlags() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.flags();
+    return mFile.mFlags;
   }
 
   //----------------------------------------------------------------------------
@@ -431,7 +434,7 @@ public:
   getFlag(uint8_t n) override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return (bool)(mFile.flags() & (0x0001 << n));
+    return (bool)(mFile.mFlags & (0x0001 << n));
   }
 
   //----------------------------------------------------------------------------
@@ -441,7 +444,7 @@ public:
   setFlags(uint16_t flags) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_flags(flags);
+    mFile.mFlags = flags;
   }
 
   //----------------------------------------------------------------------------
@@ -453,9 +456,9 @@ public:
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
 
     if (flag) {
-      mFile.set_flags(mFile.flags() | (1 << n));
+      mFile.mFlags |= (1 << n);
     } else {
-      mFile.set_flags(mFile.flags() & (~(1 << n)));
+      mFile.mFlags &= (~(1 << n));
     }
   }
 
@@ -491,7 +494,7 @@ public:
   getLink() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.link_name();
+    return mFile.getLinkName();
   }
 
   //----------------------------------------------------------------------------
@@ -501,7 +504,7 @@ public:
   setLink(std::string link_name) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_link_name(link_name);
+    mFile.setLinkName(link_name);
   }
 
   //----------------------------------------------------------------------------
@@ -511,7 +514,7 @@ public:
   isLink() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return !mFile.link_name().empty();
+    return (mFile.mLinkName != nullptr);
   }
 
   //----------------------------------------------------------------------------
@@ -521,7 +524,7 @@ public:
   setAttribute(const std::string& name, const std::string& value) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    (*mFile.mutable_xattrs())[name] = value;
+    mFile.mXAttrs.set(name, value);
   }
 
   //----------------------------------------------------------------------------
@@ -531,11 +534,7 @@ public:
   removeAttribute(const std::string& name) override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.xattrs().find(name);
-
-    if (it != mFile.xattrs().end()) {
-      mFile.mutable_xattrs()->erase(it->first);
-    }
+    mFile.mXAttrs.erase(name);
   }
 
   //----------------------------------------------------------------------------
@@ -544,7 +543,7 @@ public:
   void clearAttributes() override
   {
     std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_xattrs();
+    mFile.mXAttrs.clear();
   }
 
   //----------------------------------------------------------------------------
@@ -554,7 +553,7 @@ public:
   hasAttribute(const std::string& name) const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return (mFile.xattrs().find(name) != mFile.xattrs().end());
+    return (mFile.mXAttrs.get(name) != nullptr);
   }
 
   //----------------------------------------------------------------------------
@@ -564,7 +563,7 @@ public:
   numAttributes() const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.xattrs().size();
+    return mFile.mXAttrs.size();
   }
 
   //----------------------------------------------------------------------------
@@ -574,15 +573,15 @@ public:
   getAttribute(const std::string& name) const override
   {
     std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.xattrs().find(name);
+    const std::string* value = mFile.mXAttrs.get(name);
 
-    if (it == mFile.xattrs().end()) {
+    if (value == nullptr) {
       MDException e(ENOENT);
       e.getMessage() << "Attribute: " << name << " not found";
       throw e;
     }
 
-    return it->second;
+    return *value;
   }
 
   //----------------------------------------------------------------------------
@@ -633,7 +632,9 @@ private:
   void getCTimeNoLock(ctime_t& ctime) const;
 
   mutable std::shared_timed_mutex mMutex;
-  eos::ns::FileMdProto mFile; ///< Protobuf file representation
+  //! Compact file representation, the protobuf object is only built when
+  //! serializing the file
+  CompactFileMD mFile;
   uint64_t mClock; ///< Value tracking metadata changes
 };
 
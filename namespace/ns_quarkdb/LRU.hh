@@ -20,6 +20,9 @@
 //! @author Elvin-Alin Sindrilaru <esindril@cern.ch>
 //! @brief LRU cache for namespace objects making sure we never evict an entry
 //!        which is still referenced in other parts of the program.
+//!        Besides the strict LRU eviction the cache also supports a CLOCK
+//!        (second chance) policy where a cache hit only sets an access bit
+//!        on the entry and therefore requires just a shared lock.
 //------------------------------------------------------------------------------
 
 #ifndef __EOS_NS_LRU_HH__
@@ -31,11 +34,15 @@
 #include "common/Murmur3.hh"
 #include "namespace/Namespace.hh"
 #include <google/dense_hash_map>
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -64,6 +71,40 @@ struct hasGetId {
   static constexpr bool value = test<EntryT>(int());
 };
 
+//------------------------------------------------------------------------------
+//! Eviction policy used by the namespace cache
+//------------------------------------------------------------------------------
+enum class CachePolicy {
+  //! Strict LRU - every hit moves the entry to the end of the list and needs
+  //! exclusive access to the cache
+  kLRU,
+  //! CLOCK (second chance) - a hit only marks the entry as referenced and
+  //! needs shared access to the cache, eviction is done by a sweeping hand
+  kClock
+};
+
+//------------------------------------------------------------------------------
+//! Convert string to cache policy
+//!
+//! @param value string representation i.e. "lru" or "clock"
+//! @param policy parsed policy
+//!
+//! @return true if value is a known policy, otherwise false
+//------------------------------------------------------------------------------
+inline bool
+ParseCachePolicy(const std::string& value, CachePolicy& policy)
+{
+  if (value == "lru") {
+    policy = CachePolicy::kLRU;
+  } else if (value == "clock") {
+    policy = CachePolicy::kClock;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
 //------------------------------------------------------------------------------
 //! LRU cache for namespace entries
 //------------------------------------------------------------------------------
@@ -75,8 +116,9 @@ public:
   //! Constructor
   //!
   //! @param maxSize maximum number of entries in the cache
+  //! @param policy eviction policy
   //----------------------------------------------------------------------------
-  LRU(std::uint64_t maxSize);
+  LRU(std::uint64_t maxSize, CachePolicy policy = CachePolicy::kLRU);
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -115,6 +157,12 @@ public:
   //----------------------------------------------------------------------------
   bool remove(IdT id);
 
+  //----------------------------------------------------------------------------
+  //! Remove all entries from the cache, including the ones which are still
+  //! referenced somewhere else in the program
+  //----------------------------------------------------------------------------
+  void clear();
+
   //----------------------------------------------------------------------------
   //! Get cache size
   //!
@@ -123,7 +171,7 @@ public:
   inline std::uint64_t
   size() const
   {
-    eos::common::RWMutexWriteLock lock_w(mMutex);
+    eos::common::RWMutexReadLock lock_r(mMutex);
     return mMap.size();
   }
 
@@ -135,7 +183,7 @@ public:
   inline std::uint64_t
   get_max_num() const
   {
-    eos::common::RWMutexWriteLock lock_w(mMutex);
+    eos::common::RWMutexReadLock lock_r(mMutex);
     return mMaxNum;
   }
 
@@ -161,6 +209,39 @@ public:
     }
   }
 
+  //----------------------------------------------------------------------------
+  //! Get eviction policy
+  //----------------------------------------------------------------------------
+  inline CachePolicy
+  get_policy() const
+  {
+    return mPolicy.load();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Set eviction policy. The entries already in the cache are kept, their
+  //! current position in the list is used as starting point for the new
+  //! policy.
+  //!
+  //! @param policy new eviction policy
+  //----------------------------------------------------------------------------
+  inline void
+  set_policy(CachePolicy policy)
+  {
+    eos::common::RWMutexWriteLock lock_w(mMutex);
+    mPolicy = policy;
+    mHand = mList.begin();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently inserted or used entries
+  //!
+  //! @param max_num maximum number of ids to return
+  //!
+  //! @return ids ordered from the most to the least recent one
+  //----------------------------------------------------------------------------
+  std::vector<IdT> getMostRecent(std::uint64_t max_num) const;
+
   //----------------------------------------------------------------------------
   //! Forbid copying or moving LRU objects
   //----------------------------------------------------------------------------
@@ -186,16 +267,38 @@ private:
   //----------------------------------------------------------------------------
   void Purge(double stop_ratio);
 
+  //----------------------------------------------------------------------------
+  //! Purge entries using the CLOCK hand until stop ratio is achieved
+  //!
+  //! @param stop_ratio stop purge ratio
+  //! @note This method must be called with the mutex protecting the map and
+  //! the list locked.
+  //----------------------------------------------------------------------------
+  void PurgeClock(double stop_ratio);
+
+  //----------------------------------------------------------------------------
+  //! Cache node holding the object and its access bit used by CLOCK
+  //----------------------------------------------------------------------------
+  struct Node {
+    explicit Node(const std::shared_ptr<EntryT>& obj):
+      mObj(obj), mReferenced(false)
+    {}
+
+    std::shared_ptr<EntryT> mObj;
+    mutable std::atomic<bool> mReferenced;
+  };
+
   //! Percentage at which the cache purging stops
   static constexpr double sPurgeStopRatio = 0.9;
-  using ListT = std::list<std::shared_ptr<EntryT>>;
-  typename std::list<std::shared_ptr<EntryT>>::iterator ListIterT;
-  //using MapT = std::map<IdT, decltype(ListIterT)>;
-  using MapT = google::dense_hash_map<IdT, decltype(ListIterT),
+  using ListT = std::list<Node>;
+  using ListIterT = typename ListT::iterator;
+  using MapT = google::dense_hash_map<IdT, ListIterT,
         Murmur3::MurmurHasher<IdT>>;
   MapT mMap;   ///< Internal map pointing to obj in list
   ListT mList; ///< Internal list of objects where new/used objects are at the
-  ///< end of the list
+  ///< end of the list (LRU) or right behind the hand (CLOCK)
+  ListIterT mHand; ///< CLOCK hand pointing to the next eviction candidate
+  std::atomic<CachePolicy> mPolicy; ///< Eviction policy
   //! Mutext to protect access to the map and list which is set to blocking
   //! mutable eos::common::RWMutex mMutex;
   mutable eos::common::RWMutex mMutex;
@@ -212,8 +315,9 @@ constexpr double LRU<IdT, EntryT>::sPurgeStopRatio;
 // Constructor
 //------------------------------------------------------------------------------
 template <typename IdT, typename EntryT>
-LRU<IdT, EntryT>::LRU(std::uint64_t max_num) :
-  mMap(), mList(), mMutex(), mMaxNum(max_num), mToDelete()
+LRU<IdT, EntryT>::LRU(std::uint64_t max_num, CachePolicy policy) :
+  mMap(), mList(), mHand(mList.end()), mPolicy(policy), mMutex(),
+  mMaxNum(max_num), mToDelete()
 {
   mMap.set_empty_key(IdT(UINT64_MAX - 1));
   mMap.set_deleted_key(IdT(UINT64_MAX));
@@ -243,6 +347,22 @@ template <typename IdT, typename EntryT>
 std::shared_ptr<EntryT>
 LRU<IdT, EntryT>::get(IdT id)
 {
+  if (mPolicy == CachePolicy::kClock) {
+    eos::common::RWMutexReadLock lock_r(mMutex);
+    auto iter_map = mMap.find(id);
+
+    if (iter_map == mMap.end()) {
+      return nullptr;
+    }
+
+    // Avoid dirtying the cache line if the bit is already set
+    if (!iter_map->second->mReferenced.load(std::memory_order_relaxed)) {
+      iter_map->second->mReferenced.store(true, std::memory_order_relaxed);
+    }
+
+    return iter_map->second->mObj;
+  }
+
   eos::common::RWMutexWriteLock lock_w(mMutex);
   auto iter_map = mMap.find(id);
 
@@ -250,11 +370,10 @@ LRU<IdT, EntryT>::get(IdT id)
     return nullptr;
   }
 
-  // Move object to the end of the list i.e. recently accessed
-  auto iter_new = mList.insert(mList.end(), *iter_map->second);
-  mList.erase(iter_map->second);
-  mMap[id] = iter_new;
-  return *iter_new;
+  // Move object to the end of the list i.e. recently accessed, splice keeps
+  // the iterator stored in the map valid.
+  mList.splice(mList.end(), mList, iter_map->second);
+  return iter_map->second->mObj;
 }
 
 //------------------------------------------------------------------------------
@@ -273,18 +392,25 @@ typename std::enable_if<hasGetId<EntryT>::value, std::shared_ptr<EntryT>>::type
   auto iter_map = mMap.find(id);
 
   if (iter_map != mMap.end()) {
-    return *(iter_map->second);
+    return iter_map->second->mObj;
   }
 
   // Check if map full and purge some entries if necessary 10% of max size
   if (mMap.size() >= mMaxNum) {
-    Purge(sPurgeStopRatio);
+    if (mPolicy == CachePolicy::kClock) {
+      PurgeClock(sPurgeStopRatio);
+    } else {
+      Purge(sPurgeStopRatio);
+    }
   }
 
   // @todo (esindril): add time based and for a fixed number of entries purging
-  auto iter = mList.insert(mList.end(), obj);
+  // For CLOCK new entries go right behind the hand so that they are the last
+  // ones to be inspected during the next sweep.
+  auto iter = mList.emplace((mPolicy == CachePolicy::kClock) ?
+                            mHand : mList.end(), obj);
   mMap[id] = iter;
-  return *iter;
+  return iter->mObj;
 }
 
 //------------------------------------------------------------------------------
@@ -301,11 +427,65 @@ LRU<IdT, EntryT>::remove(IdT id)
     return false;
   }
 
+  if (mHand == iter_map->second) {
+    ++mHand;
+  }
+
   (void)mList.erase(iter_map->second);
   mMap.erase(iter_map);
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Get ids of the most recently inserted or used entries
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+std::vector<IdT>
+LRU<IdT, EntryT>::getMostRecent(std::uint64_t max_num) const
+{
+  std::vector<IdT> ids;
+  eos::common::RWMutexReadLock lock_r(mMutex);
+
+  if (mList.empty()) {
+    return ids;
+  }
+
+  // The most recent entries are at the end of the list for LRU and right
+  // behind the hand for CLOCK, walk backwards from there wrapping around
+  auto iter = ((mPolicy == CachePolicy::kClock) ?
+               typename ListT::const_iterator(mHand) : mList.cend());
+  ids.reserve(std::min(max_num, (std::uint64_t) mMap.size()));
+
+  while (ids.size() < std::min(max_num, (std::uint64_t) mMap.size())) {
+    if (iter == mList.cbegin()) {
+      iter = mList.cend();
+    }
+
+    --iter;
+    ids.push_back(IdT(iter->mObj->getId()));
+  }
+
+  return ids;
+}
+
+//------------------------------------------------------------------------------
+// Remove all entries from the cache
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+void
+LRU<IdT, EntryT>::clear()
+{
+  eos::common::RWMutexWriteLock lock_w(mMutex);
+
+  for (auto& node : mList) {
+    mToDelete.push(node.mObj);
+  }
+
+  mMap.clear();
+  mList.clear();
+  mHand = mList.end();
+}
+
 //----------------------------------------------------------------------------
 // Cleaner job taking care of deallocating entries that are passed through
 // the queue to delete
@@ -341,19 +521,61 @@ LRU<IdT, EntryT>::Purge(double stop_ratio)
   while ((iter != mList.end()) &&
          (mMap.size() > stop_ratio * mMaxNum)) {
     // If object is referenced also by someone else then skip it
-    if (iter->use_count() > 1) {
+    if (iter->mObj.use_count() > 1) {
       ++iter;
       continue;
     }
 
-    mMap.erase(IdT((*iter)->getId()));
-    mToDelete.push(*iter);
+    if (mHand == iter) {
+      ++mHand;
+    }
+
+    mMap.erase(IdT(iter->mObj->getId()));
+    mToDelete.push(iter->mObj);
     iter = mList.erase(iter);
   }
 
   mMap.resize(0); // compact after deletion
 }
 
+//------------------------------------------------------------------------------
+// Purge entries using the CLOCK hand until stop ratio is achieved
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+void
+LRU<IdT, EntryT>::PurgeClock(double stop_ratio)
+{
+  // Every entry gets at most two visits: one to clear the access bit and one
+  // to evict it. Entries still referenced elsewhere are never evicted.
+  std::uint64_t max_steps = 2 * mList.size();
+
+  while (!mList.empty() && max_steps &&
+         (mMap.size() > stop_ratio * mMaxNum)) {
+    --max_steps;
+
+    if (mHand == mList.end()) {
+      mHand = mList.begin();
+    }
+
+    if (mHand->mReferenced.load(std::memory_order_relaxed)) {
+      mHand->mReferenced.store(false, std::memory_order_relaxed);
+      ++mHand;
+      continue;
+    }
+
+    if (mHand->mObj.use_count() > 1) {
+      ++mHand;
+      continue;
+    }
+
+    mMap.erase(IdT(mHand->mObj->getId()));
+    mToDelete.push(mHand->mObj);
+    mHand = mList.erase(mHand);
+  }
+
+  mMap.resize(0); // compact after deletion
+}
+
 EOSNSNAMESPACE_END
 
 #endif // __EOS_NS_LRU_HH__
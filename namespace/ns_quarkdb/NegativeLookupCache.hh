@@ -0,0 +1,204 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Bounded cache of (parent container id, name) pairs known not to
+//!        exist in the namespace.
+//------------------------------------------------------------------------------
+
+#ifndef __EOS_NS_NEGATIVE_LOOKUP_CACHE_HH__
+#define __EOS_NS_NEGATIVE_LOOKUP_CACHE_HH__
+
+#include "namespace/Namespace.hh"
+#include "namespace/interface/Identifiers.hh"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Negative lookup cache - remembers names which were looked up in a given
+//! container and not found. Entries are evicted in FIFO order once the
+//! maximum number of entries is reached, and must be invalidated whenever a
+//! child with the same name is added to the container.
+//------------------------------------------------------------------------------
+class NegativeLookupCache
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param max_num maximum number of entries, 0 disables the cache
+  //----------------------------------------------------------------------------
+  NegativeLookupCache(std::uint64_t max_num = 1e6):
+    mMaxNum(max_num), mHits(0), mMisses(0)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Check if the given name is known not to exist in the parent container
+  //!
+  //! @param parent parent container id
+  //! @param name child name
+  //!
+  //! @return true if entry is known to be missing, otherwise false
+  //----------------------------------------------------------------------------
+  bool contains(ContainerIdentifier parent, const std::string& name)
+  {
+    if (mMaxNum == 0ull) {
+      return false;
+    }
+
+    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+
+    if (mEntries.find(KeyT(parent.getUnderlyingUInt64(), name)) ==
+        mEntries.end()) {
+      ++mMisses;
+      return false;
+    }
+
+    ++mHits;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Record that the given name does not exist in the parent container
+  //!
+  //! @param parent parent container id
+  //! @param name child name
+  //----------------------------------------------------------------------------
+  void insert(ContainerIdentifier parent, const std::string& name)
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+
+    if (mMaxNum == 0ull) {
+      return;
+    }
+
+    KeyT key(parent.getUnderlyingUInt64(), name);
+
+    if (!mEntries.insert(key).second) {
+      return;
+    }
+
+    // Invalidated entries stay in the FIFO until they reach the front, so
+    // bound the FIFO rather than the set.
+    while (mFifo.size() >= mMaxNum) {
+      mEntries.erase(mFifo.front());
+      mFifo.pop_front();
+    }
+
+    mFifo.push_back(std::move(key));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop entry for the given name in the parent container, if any
+  //!
+  //! @param parent parent container id
+  //! @param name child name
+  //----------------------------------------------------------------------------
+  void invalidate(ContainerIdentifier parent, const std::string& name)
+  {
+    if (mMaxNum == 0ull) {
+      return;
+    }
+
+    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    (void) mEntries.erase(KeyT(parent.getUnderlyingUInt64(), name));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Set max num entries
+  //!
+  //! @param max_num new maximum number of entries, 0 disables the cache
+  //----------------------------------------------------------------------------
+  void set_max_num(std::uint64_t max_num)
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    mMaxNum = max_num;
+
+    while (mFifo.size() > mMaxNum) {
+      mEntries.erase(mFifo.front());
+      mFifo.pop_front();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get maximum number of entries
+  //----------------------------------------------------------------------------
+  std::uint64_t get_max_num() const
+  {
+    return mMaxNum;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of entries
+  //----------------------------------------------------------------------------
+  std::uint64_t size() const
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+    return mEntries.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of lookups answered by the cache
+  //----------------------------------------------------------------------------
+  std::uint64_t get_hits() const
+  {
+    return mHits;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of lookups not answered by the cache
+  //----------------------------------------------------------------------------
+  std::uint64_t get_misses() const
+  {
+    return mMisses;
+  }
+
+private:
+  using KeyT = std::pair<std::uint64_t, std::string>;
+
+  //----------------------------------------------------------------------------
+  //! Hasher for the (parent id, name) pair
+  //----------------------------------------------------------------------------
+  struct KeyHasher {
+    std::size_t operator()(const KeyT& key) const
+    {
+      return std::hash<std::string>()(key.second) ^
+             (std::hash<std::uint64_t>()(key.first) * 0x9e3779b97f4a7c15ull);
+    }
+  };
+
+  mutable std::shared_timed_mutex mMutex; ///< Mutex protecting the set and fifo
+  std::unordered_set<KeyT, KeyHasher> mEntries; ///< Known missing entries
+  std::deque<KeyT> mFifo; ///< Insertion order used for eviction
+  std::atomic<std::uint64_t> mMaxNum; ///< Maximum number of entries
+  std::atomic<std::uint64_t> mHits; ///< Number of cache hits
+  std::atomic<std::uint64_t> mMisses; ///< Number of cache misses
+};
+
+EOSNSNAMESPACE_END
+
+#endif // __EOS_NS_NEGATIVE_LOOKUP_CACHE_HH__
@@ -0,0 +1,294 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief In-memory part of the file map of a container too large to be
+//!        loaded, the full map only lives in QuarkDB.
+//------------------------------------------------------------------------------
+
+#ifndef __EOS_NS_PAGED_FILE_MAP_HH__
+#define __EOS_NS_PAGED_FILE_MAP_HH__
+
+#include "namespace/Namespace.hh"
+#include "namespace/interface/IContainerMD.hh"
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <utility>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Paged file map - keeps the number of files of the container, a bounded LRU
+//! of names looked up in QuarkDB and the changes done through this object
+//! which might not be flushed to QuarkDB yet.
+//!
+//! Lookups check the changes first, then the LRU, and only then go to
+//! QuarkDB. The answers from QuarkDB are cached unless a change to the same
+//! name happened in the meantime. Changes are kept until the flusher has been
+//! synchronized past them; they then move to the LRU. Id 0 stands for a name
+//! which does not exist. Thread-safe, the owner only needs its own lock to
+//! keep the count coherent with the changes.
+//------------------------------------------------------------------------------
+class PagedFileMap
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Result of a local lookup
+  //----------------------------------------------------------------------------
+  enum class Lookup { kFound, kMissing, kUnknown };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param num_files number of files in QuarkDB
+  //! @param max_names maximum number of names in the LRU
+  //! @param max_changes number of changes after which the owner is asked to
+  //!        synchronize the flusher
+  //----------------------------------------------------------------------------
+  PagedFileMap(uint64_t num_files, size_t max_names = 10000,
+               size_t max_changes = 10000):
+    mNumFiles(num_files), mMaxNames(max_names), mMaxChanges(max_changes)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Look up a name locally
+  //!
+  //! @param name file name
+  //! @param id set to the file id if found
+  //! @param generation set to the value to pass to cache() with the answer
+  //!        from QuarkDB if unknown
+  //----------------------------------------------------------------------------
+  Lookup find(const std::string& name, IContainerMD::id_t& id,
+              uint64_t& generation)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    generation = mGeneration;
+    auto change = mChanges.find(name);
+
+    if (change != mChanges.end()) {
+      id = change->second.first;
+      return (id ? Lookup::kFound : Lookup::kMissing);
+    }
+
+    auto it = mIndex.find(name);
+
+    if (it == mIndex.end()) {
+      return Lookup::kUnknown;
+    }
+
+    mNames.splice(mNames.begin(), mNames, it->second);
+    id = it->second->second;
+    return (id ? Lookup::kFound : Lookup::kMissing);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Cache the answer from QuarkDB for a name
+  //!
+  //! @param name file name
+  //! @param id file id, 0 if the name does not exist
+  //! @param generation value returned by find() before querying QuarkDB
+  //----------------------------------------------------------------------------
+  void cache(const std::string& name, IContainerMD::id_t id,
+             uint64_t generation)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // A change since the query makes the answer stale
+    if ((generation != mGeneration) || mChanges.count(name)) {
+      return;
+    }
+
+    putLocked(name, id);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Record a file added to the container
+  //!
+  //! @param name file name
+  //! @param id file id
+  //! @param is_new true if the name did not exist before
+  //!
+  //! @return true if the owner should synchronize the flusher
+  //----------------------------------------------------------------------------
+  bool insert(const std::string& name, IContainerMD::id_t id, bool is_new)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (is_new) {
+      ++mNumFiles;
+    }
+
+    return changeLocked(name, id);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Record a file removed from the container
+  //!
+  //! @param name file name
+  //!
+  //! @return true if the owner should synchronize the flusher
+  //----------------------------------------------------------------------------
+  bool erase(const std::string& name)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mNumFiles) {
+      --mNumFiles;
+    }
+
+    return changeLocked(name, 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the sequence number of the last change, to be taken before
+  //! synchronizing the flusher and passed to synchronized()
+  //----------------------------------------------------------------------------
+  uint64_t getChangeSeq() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mChangeSeq;
+  }
+
+  //----------------------------------------------------------------------------
+  //! The flusher was synchronized, the changes up to the given sequence
+  //! number are in QuarkDB and move to the LRU
+  //----------------------------------------------------------------------------
+  void synchronized(uint64_t seq)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    ++mGeneration;
+
+    for (auto it = mChanges.begin(); it != mChanges.end();) {
+      if (it->second.second <= seq) {
+        putLocked(it->first, it->second.first);
+        it = mChanges.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop from a page scanned in QuarkDB the names with a pending change,
+  //! these are reported by getAddedFiles
+  //----------------------------------------------------------------------------
+  void filterPage(IContainerMD::FilePage& page) const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mChanges.empty()) {
+      return;
+    }
+
+    page.erase(std::remove_if(page.begin(), page.end(),
+    [this](const std::pair<std::string, IContainerMD::id_t>& elem) {
+      return (mChanges.find(elem.first) != mChanges.end());
+    }), page.end());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the files added by the pending changes
+  //----------------------------------------------------------------------------
+  void getAddedFiles(IContainerMD::FilePage& out) const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (const auto& elem : mChanges) {
+      if (elem.second.first) {
+        out.emplace_back(elem.first, elem.second.first);
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of files
+  //----------------------------------------------------------------------------
+  uint64_t size() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNumFiles;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of names in the LRU
+  //----------------------------------------------------------------------------
+  size_t getNumCachedNames() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNames.size();
+  }
+
+private:
+  using NameList = std::list<std::pair<std::string, IContainerMD::id_t>>;
+
+  //----------------------------------------------------------------------------
+  //! Put a name in front of the LRU - needs mMutex
+  //----------------------------------------------------------------------------
+  void putLocked(const std::string& name, IContainerMD::id_t id)
+  {
+    auto it = mIndex.find(name);
+
+    if (it != mIndex.end()) {
+      it->second->second = id;
+      mNames.splice(mNames.begin(), mNames, it->second);
+      return;
+    }
+
+    if (mMaxNames == 0) {
+      return;
+    }
+
+    while (mNames.size() >= mMaxNames) {
+      mIndex.erase(mNames.back().first);
+      mNames.pop_back();
+    }
+
+    mNames.emplace_front(name, id);
+    mIndex[name] = mNames.begin();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Record a change - needs mMutex
+  //----------------------------------------------------------------------------
+  bool changeLocked(const std::string& name, IContainerMD::id_t id)
+  {
+    mChanges[name] = std::make_pair(id, ++mChangeSeq);
+    return (mChanges.size() >= mMaxChanges);
+  }
+
+  mutable std::mutex mMutex; ///< Mutex protecting all members
+  uint64_t mNumFiles; ///< Number of files in the container
+  size_t mMaxNames; ///< Maximum number of names in the LRU
+  size_t mMaxChanges; ///< Changes triggering a flusher synchronization
+  NameList mNames; ///< LRU of names, most recent first
+  std::unordered_map<std::string, NameList::iterator> mIndex; ///< Name to LRU
+  //! Changes not known to be flushed, name to (id, sequence number)
+  std::unordered_map<std::string, std::pair<IContainerMD::id_t, uint64_t>>
+      mChanges;
+  uint64_t mChangeSeq {0}; ///< Sequence number of the last change
+  uint64_t mGeneration {0}; ///< Incremented when changes move to the LRU
+};
+
+EOSNSNAMESPACE_END
+
+#endif // __EOS_NS_PAGED_FILE_MAP_HH__
@@ -0,0 +1,380 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Bounded cache mapping directory paths to container ids, used to
+//!        start path lookups from the longest known prefix.
+//------------------------------------------------------------------------------
+
+#ifndef __EOS_NS_PATH_LOOKUP_CACHE_HH__
+#define __EOS_NS_PATH_LOOKUP_CACHE_HH__
+
+#include "namespace/Namespace.hh"
+#include "namespace/interface/IContainerMD.hh"
+#include "namespace/interface/IContainerMDSvc.hh"
+#include "namespace/interface/Identifiers.hh"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Path lookup cache - remembers the container id of directory paths which
+//! were resolved without going through "." , ".." or symbolic links.
+//!
+//! A path is only cached together with all its parent paths, and dropping a
+//! path drops everything cached below it, so a lookup can trust the longest
+//! cached prefix. Entries are evicted in FIFO order once the maximum number of
+//! entries is reached. The cache listens to the container changes: a container
+//! which is deleted, renamed or moved to another parent is dropped together
+//! with its cached subtree.
+//------------------------------------------------------------------------------
+class PathLookupCache : public IContainerMDChangeListener
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param max_num maximum number of entries, 0 disables the cache
+  //----------------------------------------------------------------------------
+  PathLookupCache(std::uint64_t max_num = 1e5):
+    mMaxNum(max_num), mHits(0), mMisses(0)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Find the longest cached prefix of the given path. Only the chunks before
+  //! the first "." or ".." are considered.
+  //!
+  //! @param chunks path chunks
+  //! @param depth number of chunks resolved by the cached prefix
+  //! @param id container id of the cached prefix
+  //!
+  //! @return true if a prefix was found, otherwise false
+  //----------------------------------------------------------------------------
+  bool lookup(const std::deque<std::string>& chunks, size_t& depth,
+              ContainerIdentifier& id)
+  {
+    if (mMaxNum == 0ull) {
+      return false;
+    }
+
+    std::vector<std::string> prefixes;
+    std::string path;
+
+    for (const auto& chunk : chunks) {
+      if (chunk == "." || chunk == "..") {
+        break;
+      }
+
+      path += "/";
+      path += chunk;
+      prefixes.push_back(path);
+    }
+
+    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+
+    for (size_t i = prefixes.size(); i > 0; --i) {
+      auto it = mEntries.find(prefixes[i - 1]);
+
+      if (it != mEntries.end()) {
+        depth = i;
+        id = ContainerIdentifier(it->second.mId);
+        ++mHits;
+        return true;
+      }
+    }
+
+    ++mMisses;
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Record the containers resolving consecutive chunks of a path. Every
+  //! container is checked against the chunk name and against the container
+  //! recorded for the parent path, insertion stops at the first mismatch.
+  //!
+  //! @param chunks path chunks
+  //! @param first index of the chunk resolved by conts[0], the path made of
+  //!        the chunks before it has to be cached already, unless first is 0
+  //! @param conts containers resolving chunks[first], chunks[first + 1], ...
+  //!
+  //! @return number of containers recorded
+  //----------------------------------------------------------------------------
+  size_t insert(const std::deque<std::string>& chunks, size_t first,
+                const std::vector<IContainerMDPtr>& conts)
+  {
+    if ((mMaxNum == 0ull) || conts.empty() ||
+        (first + conts.size() > chunks.size())) {
+      return 0;
+    }
+
+    std::string path;
+
+    for (size_t i = 0; i < first; ++i) {
+      path += "/";
+      path += chunks[i];
+    }
+
+    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    IContainerMD::id_t parent = 1;
+
+    if (first) {
+      auto it = mEntries.find(path);
+
+      if (it == mEntries.end()) {
+        return 0;
+      }
+
+      parent = it->second.mId;
+    }
+
+    size_t num = 0;
+
+    for (const auto& cont : conts) {
+      const std::string& name = chunks[first + num];
+
+      if (!cont || cont->isDeleted() || (cont->getName() != name) ||
+          (cont->getParentId() != parent) || (cont->getId() == parent)) {
+        break;
+      }
+
+      path += "/";
+      path += name;
+      parent = cont->getId();
+      ++num;
+      auto it = mEntries.find(path);
+
+      if (it != mEntries.end()) {
+        if (it->second.mId == parent) {
+          continue;
+        }
+
+        removeSubtree(path);
+      }
+
+      auto rev = mPaths.find(parent);
+
+      if (rev != mPaths.end()) {
+        // Same container cached under another path, the old one is stale
+        removeSubtree(std::string(rev->second));
+      }
+
+      // Invalidated entries stay in the FIFO until they reach the front, so
+      // bound the FIFO rather than the map.
+      while (mFifo.size() >= mMaxNum) {
+        evictFront();
+      }
+
+      // Eviction may have dropped the parent path we are building on
+      if (path.length() > name.length() + 1) {
+        std::string parent_path = path.substr(0, path.length() - name.length() - 1);
+        auto pit = mEntries.find(parent_path);
+
+        if ((pit == mEntries.end()) || (pit->second.mId != cont->getParentId())) {
+          --num;
+          break;
+        }
+      }
+
+      mEntries[path] = Entry {parent, cont->getParentId()};
+      mPaths[parent] = path;
+      mFifo.push_back(std::make_pair(path, parent));
+    }
+
+    return num;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop the given container and everything cached below it, if any
+  //!
+  //! @param id container id
+  //----------------------------------------------------------------------------
+  void invalidate(ContainerIdentifier id)
+  {
+    if (mMaxNum == 0ull) {
+      return;
+    }
+
+    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    auto it = mPaths.find(id.getUnderlyingUInt64());
+
+    if (it != mPaths.end()) {
+      removeSubtree(std::string(it->second));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Container change notification - drops deleted containers and containers
+  //! whose name or parent do not match the cached path any more
+  //----------------------------------------------------------------------------
+  void containerMDChanged(IContainerMD* obj, Action type) override
+  {
+    if ((mMaxNum == 0ull) || (obj == nullptr) ||
+        ((type != Updated) && (type != Deleted))) {
+      return;
+    }
+
+    {
+      std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+      auto it = mPaths.find(obj->getId());
+
+      if (it == mPaths.end()) {
+        return;
+      }
+
+      if (type == Updated) {
+        auto entry = mEntries.find(it->second);
+        const std::string& path = it->second;
+        size_t pos = path.rfind('/');
+
+        if ((entry != mEntries.end()) &&
+            (entry->second.mParentId == obj->getParentId()) &&
+            (path.compare(pos + 1, std::string::npos, obj->getName()) == 0)) {
+          return;
+        }
+      }
+    }
+
+    invalidate(obj->getIdentifier());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop all entries
+  //----------------------------------------------------------------------------
+  void clear()
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    mEntries.clear();
+    mPaths.clear();
+    mFifo.clear();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Set max num entries
+  //!
+  //! @param max_num new maximum number of entries, 0 disables the cache
+  //----------------------------------------------------------------------------
+  void set_max_num(std::uint64_t max_num)
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    mMaxNum = max_num;
+
+    while (mFifo.size() > mMaxNum) {
+      evictFront();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get maximum number of entries
+  //----------------------------------------------------------------------------
+  std::uint64_t get_max_num() const
+  {
+    return mMaxNum;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of entries
+  //----------------------------------------------------------------------------
+  std::uint64_t size() const
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+    return mEntries.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of lookups which found a cached prefix
+  //----------------------------------------------------------------------------
+  std::uint64_t get_hits() const
+  {
+    return mHits;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of lookups which found no cached prefix
+  //----------------------------------------------------------------------------
+  std::uint64_t get_misses() const
+  {
+    return mMisses;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Cached path
+  //----------------------------------------------------------------------------
+  struct Entry {
+    IContainerMD::id_t mId; ///< Container id
+    IContainerMD::id_t mParentId; ///< Parent container id when cached
+  };
+
+  //----------------------------------------------------------------------------
+  //! Drop a path and all the paths below it. Needs the unique lock.
+  //----------------------------------------------------------------------------
+  void removeSubtree(const std::string& path)
+  {
+    auto it = mEntries.find(path);
+
+    if (it != mEntries.end()) {
+      mPaths.erase(it->second.mId);
+      mEntries.erase(it);
+    }
+
+    const std::string prefix = path + "/";
+
+    for (it = mEntries.lower_bound(prefix);
+         (it != mEntries.end()) &&
+         (it->first.compare(0, prefix.length(), prefix) == 0);) {
+      mPaths.erase(it->second.mId);
+      it = mEntries.erase(it);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Evict the oldest FIFO entry, if it is still cached. Needs the unique lock.
+  //----------------------------------------------------------------------------
+  void evictFront()
+  {
+    auto it = mEntries.find(mFifo.front().first);
+
+    if ((it != mEntries.end()) && (it->second.mId == mFifo.front().second)) {
+      removeSubtree(mFifo.front().first);
+    }
+
+    mFifo.pop_front();
+  }
+
+  mutable std::shared_timed_mutex mMutex; ///< Mutex protecting the containers
+  std::map<std::string, Entry> mEntries; ///< Sorted so that subtrees are ranges
+  std::unordered_map<IContainerMD::id_t, std::string> mPaths; ///< Id to path
+  //! Insertion order used for eviction
+  std::deque<std::pair<std::string, IContainerMD::id_t>> mFifo;
+  std::atomic<std::uint64_t> mMaxNum; ///< Maximum number of entries
+  std::atomic<std::uint64_t> mHits; ///< Number of lookups with a prefix
+  std::atomic<std::uint64_t> mMisses; ///< Number of lookups without a prefix
+};
+
+EOSNSNAMESPACE_END
+
+#endif // __EOS_NS_PATH_LOOKUP_CACHE_HH__
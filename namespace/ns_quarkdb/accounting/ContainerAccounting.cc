@@ -17,6 +17,10 @@
  ************************************************************************/
 
 #include "namespace/ns_quarkdb/accounting/ContainerAccounting.hh"
+#include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
+#include "namespace/utils/TreeHash.hh"
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <chrono>
 
@@ -29,9 +33,27 @@ QuarkContainerAccounting::QuarkContainerAccounting(IContainerMDSvc* svc,
     eos::common::RWMutex* ns_mutex, int32_t update_interval)
   : mAccumulateIndx(0), mCommitIndx(1), mShutdown(false),
     mUpdateIntervalSec(update_interval), mContainerMDSvc(svc),
-    gNsRwMutex(ns_mutex)
+    mTreeHash(TreeHash::IsEnabled()), gNsRwMutex(ns_mutex),
+    mContainerLocks(nullptr),
+    mPropagationTime(eos::common::MetricsRegistry::Instance().GetHistogram(
+                       "eos_ns_tree_size_propagation_seconds",
+                       "Duration of the tree size propagation cycles")),
+    mBatchSize(eos::common::MetricsRegistry::Instance().GetGauge(
+                 "eos_ns_tree_size_batch_containers",
+                 "Containers with a size change in the last propagated batch")),
+    mBatchUpdates(eos::common::MetricsRegistry::Instance().GetGauge(
+                    "eos_ns_tree_size_batch_updates",
+                    "Containers updated by the last propagated batch")),
+    mHashUpdates(eos::common::MetricsRegistry::Instance().GetGauge(
+                   "eos_ns_tree_hash_batch_updates",
+                   "Containers whose tree hash changed in the last batch"))
 {
   mBatch.resize(2);
+  QuarkContainerMDSvc* quark_svc = dynamic_cast<QuarkContainerMDSvc*>(svc);
+
+  if (quark_svc) {
+    mContainerLocks = quark_svc->getContainerLocks();
+  }
 
   // If update interval is 0 then we disable async updates
   if (mUpdateIntervalSec) {
@@ -58,19 +80,28 @@ void
 QuarkContainerAccounting::fileMDChanged(IFileMDChangeListener::Event* e)
 {
   switch (e->action) {
-  // We are only interested in SizeChange events
+  // The sizes only need the SizeChange events
   case IFileMDChangeListener::SizeChange:
     if (e->file->getContainerId() == 0) {
       // NOTE: This is an ugly hack. The file object has not reference to the
       // container id, therefore we hijack the "location" member of the Event
       // class to pass in the container id.
       QueueForUpdate(e->location, e->sizeChange);
+      QueueForRehash(e->location);
     } else {
       QueueForUpdate(e->file->getContainerId(), e->sizeChange);
+      QueueForRehash(e->file->getContainerId());
     }
 
     break;
 
+  // The hashes also cover the mtime and checksum, set through updates
+  case IFileMDChangeListener::Created:
+  case IFileMDChangeListener::Updated:
+  case IFileMDChangeListener::Deleted:
+    QueueForRehash(e->file->getContainerId());
+    break;
+
   default:
     break;
   }
@@ -83,6 +114,7 @@ void
 QuarkContainerAccounting::AddTree(IContainerMD* obj, int64_t dsize)
 {
   QueueForUpdate(obj->getId(), dsize);
+  QueueForRehash(obj->getId());
 }
 
 //-------------------------------------------------------------------------------
@@ -92,6 +124,7 @@ void
 QuarkContainerAccounting::RemoveTree(IContainerMD* obj, int64_t dsize)
 {
   QueueForUpdate(obj->getId(), -dsize);
+  QueueForRehash(obj->getId());
 }
 
 //------------------------------------------------------------------------------
@@ -100,30 +133,217 @@ QuarkContainerAccounting::RemoveTree(IContainerMD* obj, int64_t dsize)
 void
 QuarkContainerAccounting::QueueForUpdate(IContainerMD::id_t id, int64_t dsize)
 {
-  uint16_t deepness = 0;
-  std::shared_ptr<IContainerMD> cont;
+  // The root container is not accounted
+  if (id <= 1) {
+    return;
+  }
+
   std::lock_guard<std::mutex> scope_lock(mMutexBatch);
-  auto& batch = mBatch[mAccumulateIndx];
+  mBatch[mAccumulateIndx].mMap[id] += dsize;
+}
 
-  while ((id > 1) && (deepness < 255)) {
-    try {
-      cont = mContainerMDSvc->getContainerMD(id);
-    } catch (const MDException& e) {
-      // TODO (esindril): error message using default logging
-      break;
+//------------------------------------------------------------------------------
+// Queue container for rehashing
+//------------------------------------------------------------------------------
+void
+QuarkContainerAccounting::QueueForRehash(IContainerMD::id_t id)
+{
+  // Unlike the sizes the root is hashed, it covers the whole namespace
+  if (!mTreeHash || (id == 0)) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> scope_lock(mMutexBatch);
+  mBatch[mAccumulateIndx].mRehash.insert(id);
+}
+
+//------------------------------------------------------------------------------
+// Merge the updates of a batch into a tree of deltas
+//------------------------------------------------------------------------------
+void
+QuarkContainerAccounting::BuildDeltaTree(
+  const std::unordered_map<IContainerMD::id_t, int64_t>& updates,
+  std::unordered_map<IContainerMD::id_t, DeltaNode>& tree,
+  std::vector<IContainerMD::id_t>& order)
+{
+  std::unordered_map<IContainerMD::id_t, std::vector<IContainerMD::id_t>>
+      subtrees;
+  std::vector<IContainerMD::id_t> added;
+
+  for (const auto& update : updates) {
+    IContainerMD::id_t id = update.first;
+    IContainerMD::id_t top = 0;
+    uint16_t deepness = 0;
+    added.clear();
+
+    // Every container is looked up once per batch, walks reaching a known
+    // container continue along the recorded parents.
+    while ((id > 1) && (deepness < 255)) {
+      auto it = tree.find(id);
+
+      if (it == tree.end()) {
+        std::shared_ptr<IContainerMD> cont;
+
+        try {
+          cont = mContainerMDSvc->getContainerMD(id);
+        } catch (const MDException& e) {
+          // TODO (esindril): error message using default logging
+          break;
+        }
+
+        it = tree.emplace(id, DeltaNode {cont->getParentId(), 0, 0}).first;
+        added.push_back(id);
+      }
+
+      it->second.mDelta += update.second;
+      top = id;
+      id = it->second.mParentId;
+      ++deepness;
+    }
+
+    for (const auto& new_id : added) {
+      tree[new_id].mTopId = top;
+      subtrees[top].push_back(new_id);
+    }
+  }
+
+  order.reserve(tree.size());
+
+  for (const auto& subtree : subtrees) {
+    order.insert(order.end(), subtree.second.begin(), subtree.second.end());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Update the tree hashes of the containers of a batch and their ancestors
+//------------------------------------------------------------------------------
+size_t
+QuarkContainerAccounting::PropagateHashes(
+  const std::unordered_set<IContainerMD::id_t>& rehash)
+{
+  // The file service is attached to the container service after the
+  // accounting is created
+  QuarkContainerMDSvc* quark_svc = dynamic_cast<QuarkContainerMDSvc*>
+                                   (mContainerMDSvc);
+  IFileMDSvc* file_svc = (quark_svc ? quark_svc->getFileMDService() : nullptr);
+
+  if (file_svc == nullptr) {
+    return 0;
+  }
+
+  std::unordered_map<IContainerMD::id_t, HashNode> tree;
+  std::vector<std::pair<uint16_t, IContainerMD::id_t>> order;
+  {
+    eos::common::RWMutexReadLock rd_lock(*gNsRwMutex);
+    std::vector<IContainerMD::id_t> chain;
+
+    for (const auto& rehash_id : rehash) {
+      IContainerMD::id_t id = rehash_id;
+      uint16_t depth = 0;
+      chain.clear();
+
+      // Walk up to the root or to a container reached by a previous walk
+      while ((id != 0) && (chain.size() < 255)) {
+        auto it = tree.find(id);
+
+        if (it != tree.end()) {
+          depth = it->second.mDepth;
+          break;
+        }
+
+        std::shared_ptr<IContainerMD> cont;
+
+        try {
+          cont = mContainerMDSvc->getContainerMD(id);
+        } catch (const MDException& e) {
+          break;
+        }
+
+        // The root is its own parent
+        IContainerMD::id_t parent_id = ((id == 1) ? 0 : cont->getParentId());
+        tree.emplace(id, HashNode {parent_id, 0, false, 0});
+        chain.push_back(id);
+        id = parent_id;
+      }
+
+      for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        tree[*it].mDepth = ++depth;
+      }
+
+      auto it = tree.find(rehash_id);
+
+      if (it != tree.end()) {
+        it->second.mRehash = true;
+      }
     }
+  }
+  order.reserve(tree.size());
 
-    auto it_map = batch.mMap.find(id);
+  for (const auto& node : tree) {
+    order.emplace_back(node.second.mDepth, node.first);
+  }
+
+  // Deepest first, a container is done once all its changed children are
+  std::sort(order.begin(), order.end(),
+            std::greater<std::pair<uint16_t, IContainerMD::id_t>>());
+  std::shared_ptr<IContainerMD> cont;
+  size_t num_changed = 0;
+  size_t pos = 0;
+
+  while (pos < order.size()) {
+    eos::common::RWMutexReadLock rd_lock;
+    eos::common::RWMutexWriteLock wr_lock;
 
-    if (it_map != batch.mMap.end()) {
-      it_map->second += dsize;
+    if (mContainerLocks) {
+      rd_lock.Grab(*gNsRwMutex);
     } else {
-      batch.mMap.emplace(id, dsize);
+      wr_lock.Grab(*gNsRwMutex);
     }
 
-    id = cont->getParentId();
-    ++deepness;
+    for (size_t num = 0; (pos < order.size()) && (num < kMaxUpdatesPerLock);
+         ++pos, ++num) {
+      const IContainerMD::id_t id = order[pos].second;
+      const HashNode& node = tree[id];
+
+      if (!node.mRehash && (node.mDelta == 0)) {
+        continue;
+      }
+
+      uint64_t old_hash = 0;
+      uint64_t new_hash = 0;
+      std::string name;
+      {
+        eos::common::StripedWriteLock cont_lock(mContainerLocks, {id});
+
+        try {
+          cont = mContainerMDSvc->getContainerMD(id);
+          old_hash = cont->getTreeHash();
+          new_hash = (node.mRehash ?
+                      TreeHash::Compute(cont, file_svc, mContainerMDSvc) :
+                      old_hash + node.mDelta);
+
+          if (new_hash == old_hash) {
+            continue;
+          }
+
+          cont->setTreeHash(new_hash);
+          mContainerMDSvc->updateStore(cont.get());
+          name = cont->getName();
+        } catch (const MDException& e) {
+          continue;
+        }
+      }
+      ++num_changed;
+      auto it = tree.find(node.mParentId);
+
+      if (it != tree.end()) {
+        it->second.mDelta += TreeHash::ContainerEntry(name, new_hash) -
+                             TreeHash::ContainerEntry(name, old_hash);
+      }
+    }
   }
+
+  return num_changed;
 }
 
 //------------------------------------------------------------------------------
@@ -156,23 +376,70 @@ QuarkContainerAccounting::PropagateUpdates(ThreadAssistant* assistant)
     }
 
     auto& batch = mBatch[mCommitIndx];
-    {
-      // Need to lock the namespace
-      eos::common::RWMutexWriteLock wr_lock(*gNsRwMutex);
+
+    if (!batch.mMap.empty()) {
+      auto start = std::chrono::steady_clock::now();
+      std::unordered_map<IContainerMD::id_t, DeltaNode> tree;
+      std::vector<IContainerMD::id_t> order;
+      {
+        eos::common::RWMutexReadLock rd_lock(*gNsRwMutex);
+        BuildDeltaTree(batch.mMap, tree, order);
+      }
+      // Apply the merged deltas one subtree at a time so that the namespace
+      // lock is released in between, each container is written once.
       std::shared_ptr<IContainerMD> cont;
+      size_t pos = 0;
 
-      for (auto const& elem : batch.mMap) {
-        try {
-          cont = mContainerMDSvc->getContainerMD(elem.first);
-          cont->updateTreeSize(elem.second);
-          mContainerMDSvc->updateStore(cont.get());
-        } catch (const MDException& e) {
-          // TODO: (esindril) error message using default logging
-          continue;
+      while (pos < order.size()) {
+        // Need to lock the namespace - if per-container locks are available
+        // then the global lock is only taken in read mode so that lookups
+        // can proceed while the tree sizes are updated.
+        eos::common::RWMutexReadLock rd_lock;
+        eos::common::RWMutexWriteLock wr_lock;
+
+        if (mContainerLocks) {
+          rd_lock.Grab(*gNsRwMutex);
+        } else {
+          wr_lock.Grab(*gNsRwMutex);
+        }
+
+        const IContainerMD::id_t top = tree[order[pos]].mTopId;
+
+        for (size_t num = 0; (pos < order.size()) &&
+             (tree[order[pos]].mTopId == top) && (num < kMaxUpdatesPerLock);
+             ++pos, ++num) {
+          const IContainerMD::id_t id = order[pos];
+          int64_t delta = tree[id].mDelta;
+
+          if (delta == 0) {
+            continue;
+          }
+
+          eos::common::StripedWriteLock cont_lock(mContainerLocks, {id});
+
+          try {
+            cont = mContainerMDSvc->getContainerMD(id);
+            cont->updateTreeSize(delta);
+            mContainerMDSvc->updateStore(cont.get());
+          } catch (const MDException& e) {
+            // TODO: (esindril) error message using default logging
+            continue;
+          }
         }
       }
+
+      mBatchSize.Set(batch.mMap.size());
+      mBatchUpdates.Set(tree.size());
+      mPropagationTime.Observe(std::chrono::duration<double>
+                               (std::chrono::steady_clock::now() - start).count());
     }
+
+    if (!batch.mRehash.empty()) {
+      mHashUpdates.Set(PropagateHashes(batch.mRehash));
+    }
+
     batch.mMap.clear();
+    batch.mRehash.clear();
 
     if (mUpdateIntervalSec) {
       if (assistant) {
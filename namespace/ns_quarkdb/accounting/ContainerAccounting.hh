@@ -26,18 +26,26 @@
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IFileMDSvc.hh"
 #include "common/RWMutex.hh"
+#include "common/StripedRWMutex.hh"
 #include "common/AssistedThread.hh"
+#include "common/Metrics.hh"
 #include <mutex>
 #include <thread>
 #include <vector>
 #include <utility>
 #include <unordered_map>
+#include <unordered_set>
 #include <atomic>
 
 EOSNSNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
 //! Container subtree accounting listener
+//!
+//! Propagates the tree sizes and, if TreeHash::IsEnabled(), the tree hashes.
+//! A container whose files or subcontainers changed is rehashed from its
+//! direct children, its ancestors get the old entry of the changed child
+//! swapped for the new one.
 //------------------------------------------------------------------------------
 class QuarkContainerAccounting : public IFileMDChangeListener
 {
@@ -108,13 +116,22 @@ public:
   void RemoveTree(IContainerMD* obj, int64_t dsize);
 
   //----------------------------------------------------------------------------
-  //! Queue info for update
+  //! Queue info for update, only the container itself is recorded - the
+  //! ancestors are resolved once per batch when propagating
   //!
   //! @param pid container id
   //! @param dsize size change
   //----------------------------------------------------------------------------
   void QueueForUpdate(IContainerMD::id_t pid, int64_t dsize);
 
+  //----------------------------------------------------------------------------
+  //! Queue a container whose direct children changed for rehashing, nothing
+  //! is done if the tree hashes are disabled
+  //!
+  //! @param id container id
+  //----------------------------------------------------------------------------
+  void QueueForRehash(IContainerMD::id_t id);
+
   //----------------------------------------------------------------------------
   //! Propagate updates in the hierarchical structure
   //!
@@ -133,11 +150,55 @@ private:
   //----------------------------------------------------------------------------
   void AssistedPropagateUpdates(ThreadAssistant& assistant) noexcept;
 
+  //! Node of the tree of deltas built from a batch
+  struct DeltaNode {
+    IContainerMD::id_t mParentId; ///< Parent container id
+    IContainerMD::id_t mTopId; ///< Topmost ancestor below the root
+    int64_t mDelta; ///< Aggregated size change of the subtree
+  };
+
+  //----------------------------------------------------------------------------
+  //! Merge the per-container updates of a batch into a tree of deltas, every
+  //! container appears once with the sum of the updates below it
+  //!
+  //! @param updates per-container size changes
+  //! @param tree filled with the merged deltas
+  //! @param order filled with the containers of the tree, those with the same
+  //!        topmost ancestor below the root being adjacent
+  //----------------------------------------------------------------------------
+  void BuildDeltaTree(const std::unordered_map<IContainerMD::id_t, int64_t>&
+                      updates,
+                      std::unordered_map<IContainerMD::id_t, DeltaNode>& tree,
+                      std::vector<IContainerMD::id_t>& order);
+
+  //! Node of the tree of containers whose tree hash has to be updated
+  struct HashNode {
+    IContainerMD::id_t mParentId; ///< Parent container id, 0 for the root
+    uint16_t mDepth; ///< Depth below the root, the root being 1
+    bool mRehash; ///< If true recompute from the children
+    uint64_t mDelta; ///< Sum of the entry changes of the children
+  };
+
+  //----------------------------------------------------------------------------
+  //! Update the tree hashes of the containers of a batch and of all their
+  //! ancestors, deepest first so that every container is written once
+  //!
+  //! @param rehash containers to recompute from their children
+  //!
+  //! @return number of containers whose tree hash changed
+  //----------------------------------------------------------------------------
+  size_t PropagateHashes(const std::unordered_set<IContainerMD::id_t>& rehash);
+
+  //! Maximum number of containers updated without releasing the namespace
+  //! lock, large subtrees are applied in several steps
+  static constexpr size_t kMaxUpdatesPerLock = 1000;
+
   //! Update structure containing the nodes that need an update. We try to
   //! optimise the number of updates to the backend by computing the final
   //! size deltas from a number of individual updates.
   struct UpdateT {
     std::unordered_map<IContainerMD::id_t, int64_t> mMap; ///< Map updates
+    std::unordered_set<IContainerMD::id_t> mRehash; ///< Containers to rehash
   };
 
   //! Vector of two elements containing the batch which is currently being
@@ -151,7 +212,18 @@ private:
   std::atomic<bool> mShutdown; ///< Flag to shutdown the async thread
   uint32_t mUpdateIntervalSec; ///< Interval in seconds when updates are pushed
   IContainerMDSvc* mContainerMDSvc; ///< container MD service
+  const bool mTreeHash; ///< If true the tree hashes are maintained
   eos::common::RWMutex* gNsRwMutex; ///< Global (MGM) name RW mutex
+  //! Per-container lock stripes, null if not provided by the service
+  eos::common::StripedRWMutex* mContainerLocks;
+  //! Duration of the propagation cycles
+  eos::common::MetricHistogram& mPropagationTime;
+  //! Number of containers queued in the last batch
+  eos::common::MetricGauge& mBatchSize;
+  //! Number of containers updated by the last batch, ancestors included
+  eos::common::MetricGauge& mBatchUpdates;
+  //! Number of containers whose tree hash changed in the last batch
+  eos::common::MetricGauge& mHashUpdates;
 };
 
 EOSNSNAMESPACE_END
@@ -22,6 +22,8 @@
 #include "namespace/utils/FileListRandomPicker.hh"
 #include "common/Assert.hh"
 #include "qclient/QSet.hh"
+#include <cstdlib>
+#include <cstring>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -32,7 +34,8 @@ FileSystemHandler::FileSystemHandler(IFileMD::location_t loc,
                                      folly::Executor* executor,
                                      qclient::QClient* qcl, std::shared_ptr<MetadataFlusher>
                                      flusher, bool unlinked)
-  : location(loc), pExecutor(executor), pQcl(qcl), pFlusher(flusher)
+  : location(loc), pExecutor(executor), pQcl(qcl), pFlusher(flusher),
+    mUseBitmap(useBitmaps())
 {
   if (unlinked) {
     target = Target::kUnlinked;
@@ -51,7 +54,8 @@ FileSystemHandler::FileSystemHandler(folly::Executor* executor,
                                      qclient::QClient* qcl,
                                      std::shared_ptr<MetadataFlusher> flusher,
                                      IsNoReplicaListTag tag)
-  : location(0), pExecutor(executor), pQcl(qcl), pFlusher(flusher)
+  : location(0), pExecutor(executor), pQcl(qcl), pFlusher(flusher),
+    mUseBitmap(useBitmaps())
 {
   target = Target::kNoReplicaList;
   mContents.set_deleted_key(0);
@@ -112,6 +116,24 @@ std::string FileSystemHandler::getRedisKey() const
 FileSystemHandler* FileSystemHandler::triggerCacheLoad()
 {
   pFlusher->synchronize();
+
+  if (mUseBitmap) {
+    FileBitmap temporaryBitmap;
+
+    for (auto it = getStreamingFileList(); it->valid(); it->next()) {
+      temporaryBitmap.insert(it->getElement());
+    }
+
+    temporaryBitmap.shrink();
+    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    eos_assert(mCacheStatus == CacheStatus::kInFlight);
+    mBitmap = std::move(temporaryBitmap);
+    mChangeList.apply(mBitmap);
+    mChangeList.clear();
+    mCacheStatus = CacheStatus::kLoaded;
+    return this;
+  }
+
   IFsView::FileList temporaryContents;
   temporaryContents.set_deleted_key(0);
   temporaryContents.set_empty_key(0xffffffffffffffffll);
@@ -147,8 +169,12 @@ void FileSystemHandler::insert(FileIdentifier identifier)
     mChangeList.push_back(identifier.getUnderlyingUInt64());
   } else {
     eos_assert(mCacheStatus == CacheStatus::kLoaded);
-    // Write directly into mContents
-    mContents.insert(identifier.getUnderlyingUInt64());
+    // Write directly into the contents
+    if (mUseBitmap) {
+      mBitmap.insert(identifier.getUnderlyingUInt64());
+    } else {
+      mContents.insert(identifier.getUnderlyingUInt64());
+    }
   }
 
   lock.unlock();
@@ -171,8 +197,12 @@ void FileSystemHandler::erase(FileIdentifier identifier)
     mChangeList.erase(identifier.getUnderlyingUInt64());
   } else {
     eos_assert(mCacheStatus == CacheStatus::kLoaded);
-    // Write directly into mContents
-    mContents.erase(identifier.getUnderlyingUInt64());
+    // Write directly into the contents
+    if (mUseBitmap) {
+      mBitmap.erase(identifier.getUnderlyingUInt64());
+    } else {
+      mContents.erase(identifier.getUnderlyingUInt64());
+    }
   }
 
   lock.unlock();
@@ -187,7 +217,7 @@ uint64_t FileSystemHandler::size()
 {
   ensureContentsLoaded();
   std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-  return mContents.size();
+  return (mUseBitmap ? mBitmap.size() : mContents.size());
 }
 
 //------------------------------------------------------------------------------
@@ -197,6 +227,12 @@ std::shared_ptr<ICollectionIterator<IFileMD::id_t>>
     FileSystemHandler::getFileList()
 {
   ensureContentsLoaded();
+
+  if (mUseBitmap) {
+    return std::shared_ptr<ICollectionIterator<IFileMD::id_t>>
+           (new eos::BitmapFileListIterator(mBitmap, mMutex));
+  }
+
   return std::shared_ptr<ICollectionIterator<IFileMD::id_t>>
          (new eos::FileListIterator(mContents, mMutex));
 }
@@ -211,6 +247,18 @@ std::shared_ptr<ICollectionIterator<IFileMD::id_t>>
          (new eos::StreamingFileListIterator(*pQcl, getRedisKey()));
 }
 
+//------------------------------------------------------------------------------
+// Return cursor based streaming iterator for this file system.
+//------------------------------------------------------------------------------
+std::shared_ptr<ICursorIterator<IFileMD::id_t>>
+    FileSystemHandler::getPagedFileList(const std::string& cursor,
+                                        size_t page_size)
+{
+  return std::shared_ptr<ICursorIterator<IFileMD::id_t>>
+         (new eos::PagedFileListIterator(*pQcl, getRedisKey(), cursor,
+                                         page_size));
+}
+
 //------------------------------------------------------------------------------
 // Delete the entire filelist.
 //------------------------------------------------------------------------------
@@ -219,6 +267,7 @@ void FileSystemHandler::nuke()
   std::unique_lock<std::shared_timed_mutex> lock(mMutex);
   mContents.clear();
   mContents.resize(0);
+  mBitmap.clear();
   pFlusher->del(getRedisKey());
 }
 
@@ -229,7 +278,8 @@ bool FileSystemHandler::getApproximatelyRandomFile(IFileMD::id_t& res)
 {
   ensureContentsLoaded();
   std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-  return pickRandomFile(mContents, res);
+  return (mUseBitmap ? pickRandomFile(mBitmap, res) :
+          pickRandomFile(mContents, res));
 }
 
 //----------------------------------------------------------------------------
@@ -239,7 +289,138 @@ bool FileSystemHandler::hasFileId(IFileMD::id_t file)
 {
   ensureContentsLoaded();
   std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+
+  if (mUseBitmap) {
+    return mBitmap.contains(file);
+  }
+
   return mContents.find(file) != mContents.end();
 }
 
+//----------------------------------------------------------------------------
+// Intersection or difference with the filelist of another handler
+//----------------------------------------------------------------------------
+FileBitmap FileSystemHandler::combine(FileSystemHandler& other,
+                                      bool difference)
+{
+  ensureContentsLoaded();
+  other.ensureContentsLoaded();
+  FileBitmap result;
+
+  if (&other == this) {
+    // Taking the same read lock twice could deadlock behind a writer
+    if (!difference) {
+      std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+
+      if (mUseBitmap) {
+        result = mBitmap;
+      } else {
+        for (auto fid : mContents) {
+          result.insert(fid);
+        }
+      }
+    }
+
+    return result;
+  }
+
+  // Both read locks are taken in address order, a writer waiting on one of
+  // them then can not close a cycle between two concurrent combines
+  std::shared_lock<std::shared_timed_mutex> lock(mMutex, std::defer_lock);
+  std::shared_lock<std::shared_timed_mutex> other_lock(other.mMutex,
+      std::defer_lock);
+
+  if (this < &other) {
+    lock.lock();
+    other_lock.lock();
+  } else {
+    other_lock.lock();
+    lock.lock();
+  }
+
+  if (mUseBitmap && other.mUseBitmap) {
+    return (difference ? FileBitmap::difference(mBitmap, other.mBitmap) :
+            FileBitmap::intersect(mBitmap, other.mBitmap));
+  }
+
+  auto keep = [&](IFileMD::id_t fid) {
+    const bool present = (other.mUseBitmap ? other.mBitmap.contains(fid) :
+                          (other.mContents.find(fid) != other.mContents.end()));
+
+    if (present != difference) {
+      result.insert(fid);
+    }
+  };
+
+  if (mUseBitmap) {
+    mBitmap.forEach(keep);
+  } else {
+    for (auto fid : mContents) {
+      keep(fid);
+    }
+  }
+
+  return result;
+}
+
+//----------------------------------------------------------------------------
+// Check if the filelists are kept as compressed bitmaps
+//----------------------------------------------------------------------------
+bool FileSystemHandler::useBitmaps()
+{
+  static bool enabled = []() {
+    const char* ptr = getenv("EOS_NS_FS_VIEW_BITMAPS");
+    return (ptr && strlen(ptr) && strcmp(ptr, "0"));
+  }();
+  return enabled;
+}
+
+//------------------------------------------------------------------------------
+// PagedFileListIterator constructor
+//------------------------------------------------------------------------------
+PagedFileListIterator::PagedFileListIterator(qclient::QClient& qcl,
+    const std::string& key, const std::string& cursor, size_t page_size)
+  : mQSet(qcl, key), mPageSize(page_size ? page_size : 1),
+    mPageCursor(cursor.empty() ? "0" : cursor), mNextCursor(mPageCursor),
+    mScanDone(false), mPos(0)
+{
+  fetchPage();
+}
+
+//------------------------------------------------------------------------------
+// Progress iterator, fetching the next page once the current one is consumed
+//------------------------------------------------------------------------------
+void PagedFileListIterator::next()
+{
+  if (++mPos >= mPage.size()) {
+    fetchPage();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Fetch pages until a non-empty one is found or the scan is complete
+//------------------------------------------------------------------------------
+void PagedFileListIterator::fetchPage()
+{
+  mPage.clear();
+  mPos = 0;
+
+  while (mPage.empty() && !mScanDone) {
+    mPageCursor = mNextCursor;
+
+    try {
+      auto reply = mQSet.sscan(mPageCursor, mPageSize);
+      mNextCursor = reply.first;
+      mPage = std::move(reply.second);
+    } catch (const std::runtime_error&) {
+      // Treat backend errors as the end of the list
+      mPage.clear();
+      mScanDone = true;
+      break;
+    }
+
+    mScanDone = (mNextCursor == "0");
+  }
+}
+
 EOSNSNAMESPACE_END
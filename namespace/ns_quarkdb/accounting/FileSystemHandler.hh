@@ -27,6 +27,7 @@
 #include "namespace/Namespace.hh"
 #include "namespace/interface/IFsView.hh"
 #include "namespace/interface/IFileMD.hh"
+#include "namespace/utils/FileBitmap.hh"
 #include "namespace/ns_quarkdb/accounting/SetChangeList.hh"
 #include "qclient/QSet.hh"
 #include <folly/futures/FutureSplitter.h>
@@ -96,6 +97,58 @@ private:
   IFsView::FileList::const_iterator mIterator;
 };
 
+//------------------------------------------------------------------------------
+//! Iterator to go through the contents of a FileSystemHandler kept as a
+//! bitmap. Keeps the corresponding list read-locked during its lifetime.
+//------------------------------------------------------------------------------
+class BitmapFileListIterator : public ICollectionIterator<IFileMD::id_t>
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor.
+  //----------------------------------------------------------------------------
+  BitmapFileListIterator(const FileBitmap& bitmap,
+                         std::shared_timed_mutex& mtx)
+    : pBitmap(bitmap), mLock(mtx)
+  {
+    mIterator = pBitmap.begin();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Destructor.
+  //----------------------------------------------------------------------------
+  virtual ~BitmapFileListIterator() {}
+
+  //----------------------------------------------------------------------------
+  //! Check whether the iterator is still valid.
+  //----------------------------------------------------------------------------
+  virtual bool valid() override
+  {
+    return mIterator != pBitmap.end();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get current element.
+  //----------------------------------------------------------------------------
+  virtual IFileMD::id_t getElement() override
+  {
+    return *mIterator;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Progress iterator.
+  //----------------------------------------------------------------------------
+  virtual void next() override
+  {
+    ++mIterator;
+  }
+
+private:
+  const FileBitmap& pBitmap;
+  std::shared_lock<std::shared_timed_mutex> mLock;
+  FileBitmap::const_iterator mIterator;
+};
+
 //------------------------------------------------------------------------------
 //! Streaming iterator to go through the contents of a FileSystemHandler.
 //!
@@ -149,6 +202,75 @@ private:
   qclient::QSet::Iterator it;
 };
 
+//------------------------------------------------------------------------------
+//! Cursor based streaming iterator paging through the contents of a
+//! FileSystemHandler with SSCAN. Only the current page is kept in memory.
+//!
+//! Same consistency caveats as for the StreamingFileListIterator apply.
+//------------------------------------------------------------------------------
+class PagedFileListIterator : public ICursorIterator<IFileMD::id_t>
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor.
+  //!
+  //! @param qcl QClient object
+  //! @param key set holding the file list
+  //! @param cursor SSCAN cursor to start from, "0" for the beginning
+  //! @param page_size number of elements requested per SSCAN
+  //----------------------------------------------------------------------------
+  PagedFileListIterator(qclient::QClient& qcl, const std::string& key,
+                        const std::string& cursor, size_t page_size);
+
+  //----------------------------------------------------------------------------
+  //! Destructor.
+  //----------------------------------------------------------------------------
+  virtual ~PagedFileListIterator() {}
+
+  //----------------------------------------------------------------------------
+  //! Check whether the iterator is still valid.
+  //----------------------------------------------------------------------------
+  virtual bool valid() override
+  {
+    return (mPos < mPage.size());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get current element.
+  //----------------------------------------------------------------------------
+  virtual IFileMD::id_t getElement() override
+  {
+    return std::stoull(mPage[mPos]);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Progress iterator.
+  //----------------------------------------------------------------------------
+  virtual void next() override;
+
+  //----------------------------------------------------------------------------
+  //! Get the cursor of the page holding the current element.
+  //----------------------------------------------------------------------------
+  virtual std::string getCursor() override
+  {
+    return mPageCursor;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Fetch pages until a non-empty one is found or the scan is complete.
+  //----------------------------------------------------------------------------
+  void fetchPage();
+
+  qclient::QSet mQSet;
+  size_t mPageSize; ///< Number of elements requested per SSCAN
+  std::string mPageCursor; ///< Cursor of the current page
+  std::string mNextCursor; ///< Cursor of the next page
+  bool mScanDone; ///< No more pages to fetch
+  std::vector<std::string> mPage; ///< Current page
+  size_t mPos; ///< Position in current page
+};
+
 
 class FileSystemHandler
 {
@@ -229,6 +351,16 @@ public:
   std::shared_ptr<ICollectionIterator<IFileMD::id_t>>
       getStreamingFileList();
 
+  //----------------------------------------------------------------------------
+  //! Retrieve cursor based streaming iterator paging through the contents of
+  //! a FileSystemHandler, without loading them into the cache.
+  //!
+  //! @param cursor cursor to resume from, "0" for the beginning
+  //! @param page_size number of elements fetched at once
+  //----------------------------------------------------------------------------
+  std::shared_ptr<ICursorIterator<IFileMD::id_t>>
+      getPagedFileList(const std::string& cursor, size_t page_size);
+
   //----------------------------------------------------------------------------
   //! Delete the entire filelist.
   //----------------------------------------------------------------------------
@@ -244,6 +376,25 @@ public:
   //----------------------------------------------------------------------------
   bool hasFileId(IFileMD::id_t file);
 
+  //----------------------------------------------------------------------------
+  //! Intersection or difference with the filelist of another handler. With
+  //! bitmaps both lists are combined a chunk at a time under their read
+  //! locks, otherwise the ids of this list are looked up in the other one.
+  //!
+  //! @param other other filelist
+  //! @param difference if true keep the ids missing from other, otherwise the
+  //!        ids present in both
+  //!
+  //! @return snapshot of the result
+  //----------------------------------------------------------------------------
+  FileBitmap combine(FileSystemHandler& other, bool difference);
+
+  //----------------------------------------------------------------------------
+  //! Check if the filelists are kept as compressed bitmaps instead of hash
+  //! sets, set by EOS_NS_FS_VIEW_BITMAPS
+  //----------------------------------------------------------------------------
+  static bool useBitmaps();
+
 private:
   //----------------------------------------------------------------------------
   //! Trigger cache load. Must only be called once.
@@ -273,6 +424,8 @@ private:
   std::shared_timed_mutex mMutex;           ///< Object mutex
   IFsView::FileList
   mContents;              ///< Actual contents. May be incomplete if mCacheStatus != kLoaded.
+  const bool mUseBitmap;                    ///< Contents kept in mBitmap instead of mContents
+  FileBitmap mBitmap;                       ///< Contents if mUseBitmap.
   SetChangeList<IFileMD::id_t>
   mChangeList; ///< ChangeList for what happens when cache loading is in progress.
 
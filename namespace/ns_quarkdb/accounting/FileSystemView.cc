@@ -27,6 +27,7 @@
 #include "common/StringTokenizer.hh"
 #include "common/Logging.hh"
 #include "qclient/QScanner.hh"
+#include <ctime>
 #include <iostream>
 #include <folly/executors/IOThreadPoolExecutor.h>
 
@@ -36,7 +37,8 @@ EOSNSNAMESPACE_BEGIN
 // Constructor
 //------------------------------------------------------------------------------
 QuarkFileSystemView::QuarkFileSystemView():
-  mExecutor(new folly::IOThreadPoolExecutor(8)), pFlusher(nullptr), pQcl(nullptr)
+  mExecutor(new folly::IOThreadPoolExecutor(sNumFilelistClients)),
+  pFlusher(nullptr), pQcl(nullptr), mPrefetchFsLists(false)
 { }
 
 //------------------------------------------------------------------------------
@@ -61,6 +63,17 @@ QuarkFileSystemView::configure(const std::map<std::string, std::string>& config)
     std::string qdb_flusher_id = config.at(key_flusher);
     pQcl = BackendClient::getInstance(contactDetails);
     pFlusher = MetadataFlusherFactory::getInstance(qdb_flusher_id, contactDetails);
+
+    // Separate connections so that loading several file lists concurrently
+    // does not serialize on a single one
+    for (size_t i = 0; i < sNumFilelistClients; ++i) {
+      mFilelistQcl.push_back(BackendClient::getInstance(contactDetails,
+                             "fsview-" + std::to_string(i)));
+    }
+  }
+
+  if (config.find(fsview::sPrefetchFsLists) != config.end()) {
+    mPrefetchFsLists = (config.at(fsview::sPrefetchFsLists) == "true");
   }
 
   auto start = std::time(nullptr);
@@ -258,6 +271,24 @@ std::shared_ptr<ICollectionIterator<IFileMD::id_t>>
   return nullptr;
 }
 
+//------------------------------------------------------------------------------
+// Get cursor based streaming iterator to list of files on a particular
+// file system
+//------------------------------------------------------------------------------
+std::shared_ptr<ICursorIterator<IFileMD::id_t>>
+    QuarkFileSystemView::getPagedFileList(IFileMD::location_t location,
+                                          const std::string& cursor,
+                                          size_t page_size)
+{
+  FileSystemHandler* handler = fetchRegularFilelistIfExists(location);
+
+  if (handler) {
+    return handler->getPagedFileList(cursor, page_size);
+  }
+
+  return nullptr;
+}
+
 //------------------------------------------------------------------------------
 // Erase an entry from all filesystem view collections
 //------------------------------------------------------------------------------
@@ -381,6 +412,49 @@ QuarkFileSystemView::hasFileId(IFileMD::id_t fid, IFileMD::location_t fs_id)
   return false;
 }
 
+//------------------------------------------------------------------------------
+// Get the files which are on both file systems
+//------------------------------------------------------------------------------
+std::shared_ptr<FileBitmapIterator>
+QuarkFileSystemView::getFileListIntersection(IFileMD::location_t fs_a,
+    IFileMD::location_t fs_b)
+{
+  FileSystemHandler* handler_a = fetchRegularFilelistIfExists(fs_a);
+  FileSystemHandler* handler_b = fetchRegularFilelistIfExists(fs_b);
+
+  if (!handler_a || !handler_b) {
+    return std::make_shared<FileBitmapIterator>(FileBitmap());
+  }
+
+  return std::make_shared<FileBitmapIterator>(handler_a->combine(*handler_b,
+         false));
+}
+
+//------------------------------------------------------------------------------
+// Get the files which are on fs_a but not on fs_b
+//------------------------------------------------------------------------------
+std::shared_ptr<FileBitmapIterator>
+QuarkFileSystemView::getFileListDifference(IFileMD::location_t fs_a,
+    IFileMD::location_t fs_b)
+{
+  FileSystemHandler* handler_a = fetchRegularFilelistIfExists(fs_a);
+
+  if (!handler_a) {
+    return std::make_shared<FileBitmapIterator>(FileBitmap());
+  }
+
+  FileSystemHandler* handler_b = fetchRegularFilelistIfExists(fs_b);
+
+  if (!handler_b) {
+    // Nothing to leave out, the other list is empty
+    return std::make_shared<FileBitmapIterator>(handler_a->combine(*handler_a,
+           false));
+  }
+
+  return std::make_shared<FileBitmapIterator>(handler_a->combine(*handler_b,
+         true));
+}
+
 //------------------------------------------------------------------------------
 // Clear unlinked files for filesystem
 //------------------------------------------------------------------------------
@@ -485,6 +559,43 @@ QuarkFileSystemView::loadFromBackend()
       }
     }
   }
+
+  if (!mPrefetchFsLists) {
+    return;
+  }
+
+  // Load the contents of all the file lists concurrently, spread over the
+  // executor threads and the file list connections
+  std::vector<folly::Future<FileSystemHandler*>> futs;
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    for (auto* fs_map : {
+           &mFiles, &mUnlinkedFiles
+         }) {
+      for (auto& elem : *fs_map) {
+        futs.emplace_back(elem.second->ensureContentsLoadedAsync());
+      }
+    }
+  }
+  auto start = std::time(nullptr);
+  folly::collectAll(futs.begin(), futs.end()).wait();
+  eos_static_info("msg="prefetched filesystem file lists" count=%llu "
+                  "duration=%llus", (unsigned long long) futs.size(),
+                  (unsigned long long)(std::time(nullptr) - start));
+}
+
+//------------------------------------------------------------------------------
+// Get the qclient used to load the file list of the given filesystem
+//------------------------------------------------------------------------------
+qclient::QClient*
+QuarkFileSystemView::getFilelistClient(IFileMD::location_t fsid) const
+{
+  if (mFilelistQcl.empty()) {
+    return pQcl;
+  }
+
+  return mFilelistQcl[fsid % mFilelistQcl.size()];
 }
 
 //------------------------------------------------------------------------------
@@ -506,8 +617,8 @@ FileSystemHandler* QuarkFileSystemView::initializeRegularFilelist(
     return iter->second.get();
   }
 
-  mFiles[fsid].reset(new FileSystemHandler(fsid, mExecutor.get(), pQcl, pFlusher,
-                     false));
+  mFiles[fsid].reset(new FileSystemHandler(fsid, mExecutor.get(),
+                     getFilelistClient(fsid), pFlusher, false));
   return mFiles[fsid].get();
 }
 
@@ -549,8 +660,8 @@ FileSystemHandler* QuarkFileSystemView::initializeUnlinkedFilelist(
     return iter->second.get();
   }
 
-  mUnlinkedFiles[fsid].reset(new FileSystemHandler(fsid, mExecutor.get(), pQcl,
-                             pFlusher, true));
+  mUnlinkedFiles[fsid].reset(new FileSystemHandler(fsid, mExecutor.get(),
+                             getFilelistClient(fsid), pFlusher, true));
   return mUnlinkedFiles[fsid].get();
 }
 
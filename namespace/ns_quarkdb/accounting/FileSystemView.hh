@@ -33,6 +33,7 @@
 #include "qclient/QClient.hh"
 #include "qclient/QSet.hh"
 #include <utility>
+#include <vector>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -231,6 +232,20 @@ public:
   std::shared_ptr<ICollectionIterator<IFileMD::id_t>>
       getStreamingFileList(IFileMD::location_t location) override;
 
+  //----------------------------------------------------------------------------
+  //! Get cursor based streaming iterator to list of files on a particular
+  //! file system, paging through the QuarkDB set with bounded memory
+  //!
+  //! @param location file system id
+  //! @param cursor SSCAN cursor to resume from, "0" for the beginning
+  //! @param page_size number of file ids fetched at once
+  //!
+  //! @return shared ptr to cursor iterator, nullptr if no such file list
+  //----------------------------------------------------------------------------
+  std::shared_ptr<ICursorIterator<IFileMD::id_t>>
+      getPagedFileList(IFileMD::location_t location, const std::string& cursor,
+                       size_t page_size) override;
+
   //----------------------------------------------------------------------------
   //! Get an approximately random file residing within the given filesystem.
   //!
@@ -316,6 +331,32 @@ public:
   //----------------------------------------------------------------------------
   bool hasFileId(IFileMD::id_t fid, IFileMD::location_t fs_id) override;
 
+  //----------------------------------------------------------------------------
+  //! Get the files which are on both file systems, combining the two cached
+  //! file lists directly
+  //!
+  //! @param fs_a first file system id
+  //! @param fs_b second file system id
+  //!
+  //! @return shared ptr to collection iterator, empty if none
+  //----------------------------------------------------------------------------
+  std::shared_ptr<FileBitmapIterator>
+  getFileListIntersection(IFileMD::location_t fs_a,
+                          IFileMD::location_t fs_b) override;
+
+  //----------------------------------------------------------------------------
+  //! Get the files which are on fs_a but not on fs_b, combining the two
+  //! cached file lists directly
+  //!
+  //! @param fs_a file system id whose files are returned
+  //! @param fs_b file system id whose files are left out
+  //!
+  //! @return shared ptr to collection iterator, empty if none
+  //----------------------------------------------------------------------------
+  std::shared_ptr<FileBitmapIterator>
+  getFileListDifference(IFileMD::location_t fs_a,
+                        IFileMD::location_t fs_b) override;
+
   //----------------------------------------------------------------------------
   //! Configure
   //!
@@ -393,12 +434,23 @@ private:
   //----------------------------------------------------------------------------
   FileSystemHandler* fetchUnlinkedFilelistIfExists(IFileMD::location_t fsid);
 
+  //----------------------------------------------------------------------------
+  //! Get the qclient used to load the file list of the given filesystem
+  //----------------------------------------------------------------------------
+  qclient::QClient* getFilelistClient(IFileMD::location_t fsid) const;
+
+  //! Number of connections the file lists are loaded through
+  static constexpr size_t sNumFilelistClients = 8;
   ///! Folly executor
   std::unique_ptr<folly::Executor> mExecutor;
   ///! Metadata flusher object
   std::shared_ptr<MetadataFlusher> pFlusher;
   ///! QClient object
   qclient::QClient* pQcl;
+  ///! QClient objects the file lists are spread over
+  std::vector<qclient::QClient*> mFilelistQcl;
+  ///! Load all the file lists when loading the view from the backend
+  bool mPrefetchFsLists;
 
   ///! No replicas handler
   std::unique_ptr<FileSystemHandler> mNoReplicas;
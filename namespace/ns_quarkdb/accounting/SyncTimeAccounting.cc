@@ -17,6 +17,7 @@
  ************************************************************************/
 
 #include "namespace/ns_quarkdb/accounting/SyncTimeAccounting.hh"
+#include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
 #include <iostream>
 #include <chrono>
 
@@ -30,9 +31,14 @@ QuarkSyncTimeAccounting::QuarkSyncTimeAccounting(IContainerMDSvc* svc,
     uint32_t update_interval):
   mAccumulateIndx(0), mCommitIndx(1), mShutdown(false),
   mUpdateIntervalSec(update_interval), mContainerMDSvc(svc),
-  gNsRwMutex(ns_mutex)
+  gNsRwMutex(ns_mutex), mContainerLocks(nullptr)
 {
   mBatch.resize(2);
+  QuarkContainerMDSvc* quark_svc = dynamic_cast<QuarkContainerMDSvc*>(svc);
+
+  if (quark_svc) {
+    mContainerLocks = quark_svc->getContainerLocks();
+  }
 
   // Enable updates if update interval is not 0
   if (mUpdateIntervalSec) {
@@ -99,6 +105,75 @@ noexcept
   PropagateUpdates(&assistant);
 }
 
+//------------------------------------------------------------------------------
+// Check if a timestamp is more recent than another one
+//------------------------------------------------------------------------------
+static bool
+IsNewer(const IContainerMD::tmtime_t& lhs, const IContainerMD::tmtime_t& rhs)
+{
+  return ((lhs.tv_sec > rhs.tv_sec) ||
+          ((lhs.tv_sec == rhs.tv_sec) && (lhs.tv_nsec > rhs.tv_nsec)));
+}
+
+//------------------------------------------------------------------------------
+// Collect the containers to update along with their propagated mtime
+//------------------------------------------------------------------------------
+void
+QuarkSyncTimeAccounting::CollectTargets(
+  const std::vector<IContainerMD::id_t>& ids,
+  std::unordered_map<IContainerMD::id_t, IContainerMD::tmtime_t>& targets)
+{
+  for (const auto& leaf : ids) {
+    uint16_t deepness = 0;
+    IContainerMD::id_t id = leaf;
+    IContainerMD::tmtime_t mtime {0};
+
+    while ((id > 1) && (deepness < 255)) {
+      auto it = targets.find(id);
+
+      // A more recent time is already propagated from this node upwards
+      if (deepness && (it != targets.end()) && !IsNewer(mtime, it->second)) {
+        break;
+      }
+
+      std::shared_ptr<IContainerMD> cont;
+
+      try {
+        cont = mContainerMDSvc->getContainerMD(id);
+      } catch (MDException& e) {
+        break;
+      }
+
+      // Only traverse if there there is an attribute saying so
+      if (!cont->hasAttribute("sys.mtime.propagation")) {
+        break;
+      }
+
+      if (deepness == 0u) {
+        cont->getMTime(mtime);
+
+        if ((it != targets.end()) && !IsNewer(mtime, it->second)) {
+          break;
+        }
+      }
+
+      targets[id] = mtime;
+      // Stop once the propagated time is already older than the present one,
+      // the node itself is still visited to drop its temporary etag.
+      IContainerMD::tmtime_t tmtime;
+      cont->getTMTime(tmtime);
+
+      if (deepness && ((tmtime.tv_sec != 0) || (tmtime.tv_nsec != 0)) &&
+          !IsNewer(mtime, tmtime)) {
+        break;
+      }
+
+      id = cont->getParentId();
+      ++deepness;
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 // Propagate the sync time
 //------------------------------------------------------------------------------
@@ -117,65 +192,74 @@ QuarkSyncTimeAccounting::PropagateUpdates(ThreadAssistant* assistant)
       std::swap(mAccumulateIndx, mCommitIndx);
     }
 
-    uint16_t deepness = 0;
-    IContainerMD::id_t id = 0;
-    std::set<IContainerMD::id_t> upd_nodes;
+    // Deduplicate the ancestors of all the queued containers first, so that
+    // every container is written once per cycle with the most recent time.
+    std::unordered_map<IContainerMD::id_t, IContainerMD::tmtime_t> targets;
+    std::vector<IContainerMD::id_t> ids;
     auto& lst = mBatch[mCommitIndx].mLstUpd;
 
-    // Start updating form the last node (most recent) and also collect the
-    // nodes that we've updated so that older updates don't propagate further
-    // up than strictly necessary.
-    for (auto it_id = lst.rbegin(); it_id != lst.rend(); ++it_id) {
-      deepness = 0;
-      id = *it_id;
+    for (auto it_id = lst.rbegin(); it_id != lst.rend();) {
+      ids.clear();
 
-      if (id == 0u) {
-        continue;
+      for (; (it_id != lst.rend()) && (ids.size() < kMaxUpdatesPerLock);
+           ++it_id) {
+        if (*it_id != 0u) {
+          ids.push_back(*it_id);
+        }
       }
 
-      eos_debug("Container_id=%lu sync time", id);
-      IContainerMD::ctime_t mtime {0};
-      eos::common::RWMutexWriteLock wr_lock(*gNsRwMutex);
+      eos::common::RWMutexReadLock rd_lock(*gNsRwMutex);
+      CollectTargets(ids, targets);
+    }
 
-      while ((id > 1) && (deepness < 255)) {
-        std::shared_ptr<IContainerMD> cont;
+    std::vector<std::pair<IContainerMD::id_t, IContainerMD::tmtime_t>>
+        updates(targets.begin(), targets.end());
+    targets.clear();
 
-        // If node is already in the set of updates then don't bother
-        // propagating this update
-        if (upd_nodes.count(id)) {
-          break;
-        }
+    // Apply them in bounded batches, releasing the namespace lock in between
+    for (size_t pos = 0; pos < updates.size();) {
+      // If per-container locks are available then the global lock is only
+      // taken in read mode and each container is locked while updated
+      eos::common::RWMutexReadLock rd_lock;
+      eos::common::RWMutexWriteLock wr_lock;
+
+      if (mContainerLocks) {
+        rd_lock.Grab(*gNsRwMutex);
+      } else {
+        wr_lock.Grab(*gNsRwMutex);
+      }
+
+      for (size_t num = 0; (pos < updates.size()) && (num < kMaxUpdatesPerLock);
+           ++pos, ++num) {
+        const IContainerMD::id_t id = updates[pos].first;
+        eos_debug("Container_id=%lu sync time", id);
+        eos::common::StripedWriteLock cont_lock(mContainerLocks, {id});
 
         try {
-          cont = mContainerMDSvc->getContainerMD(id);
+          std::shared_ptr<IContainerMD> cont = mContainerMDSvc->getContainerMD(id);
 
-          // Only traverse if there there is an attribute saying so
           if (!cont->hasAttribute("sys.mtime.propagation")) {
-            break;
+            continue;
           }
 
+          bool changed = false;
+
           // If there was a temporary ETAG this has not to be removed
           if (cont->hasAttribute("sys.tmp.etag")) {
             cont->removeAttribute("sys.tmp.etag");
+            changed = true;
           }
 
-          if (deepness == 0u) {
-            cont->getMTime(mtime);
+          if (cont->setTMTime(updates[pos].second)) {
+            changed = true;
           }
 
-          if (!cont->setTMTime(mtime) && deepness) {
-            break;
+          if (changed) {
+            mContainerMDSvc->updateStore(cont.get());
           }
-
-          (void) upd_nodes.insert(id);
-          mContainerMDSvc->updateStore(cont.get());
         } catch (MDException& e) {
-          cont = nullptr;
-          break;
+          continue;
         }
-
-        id = cont->getParentId();
-        ++deepness;
       }
     }
 
@@ -27,10 +27,12 @@
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "common/Logging.hh"
 #include "common/RWMutex.hh"
+#include "common/StripedRWMutex.hh"
 #include "common/AssistedThread.hh"
 #include <mutex>
 #include <list>
 #include <unordered_map>
+#include <vector>
 #include <atomic>
 
 EOSNSNAMESPACE_BEGIN
@@ -99,6 +101,21 @@ private:
   //----------------------------------------------------------------------------
   void AssistedPropagateUpdates(ThreadAssistant& assistant) noexcept;
 
+  //----------------------------------------------------------------------------
+  //! Collect the containers to update for the given queued containers, each
+  //! one with the most recent modification time to propagate to it
+  //!
+  //! @param ids queued container ids
+  //! @param targets filled with container id to propagated mtime
+  //----------------------------------------------------------------------------
+  void CollectTargets(const std::vector<IContainerMD::id_t>& ids,
+                      std::unordered_map<IContainerMD::id_t,
+                      IContainerMD::tmtime_t>& targets);
+
+  //! Maximum number of containers handled without releasing the namespace
+  //! lock
+  static constexpr size_t kMaxUpdatesPerLock = 1000;
+
   //! Update structure containing a list of the nodes that need an update in
   //! the order that the updates need to be applied and also a map used for
   //! filtering out multiple updates to the same container ID. Try to optimise
@@ -128,6 +145,8 @@ private:
   uint32_t mUpdateIntervalSec; ///< Interval in seconds when updates are pushed
   IContainerMDSvc* mContainerMDSvc; ///< Container meta-data service
   eos::common::RWMutex* gNsRwMutex; ///< Global(MGM) namespace RW mutex
+  //! Per-container lock stripes, null if not provided by the service
+  eos::common::StripedRWMutex* mContainerLocks;
 };
 
 EOSNSNAMESPACE_END
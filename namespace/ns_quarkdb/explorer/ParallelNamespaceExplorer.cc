@@ -0,0 +1,468 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/explorer/ParallelNamespaceExplorer.hh"
+#include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
+#include "namespace/interface/IView.hh"
+#include "namespace/utils/PathProcessor.hh"
+#include "namespace/utils/Attributes.hh"
+#include <cstring>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Check if the given file item passes the filter
+//------------------------------------------------------------------------------
+bool FileFilter::accept(const NamespaceItem& item) const
+{
+  const eos::ns::FileMdProto& md = item.fileMd;
+
+  if ((md.size() < minSize) || (md.size() > maxSize)) {
+    return false;
+  }
+
+  if (youngerThan || olderThan) {
+    IFileMD::ctime_t xtime {0, 0};
+    const std::string& raw = (useCtime ? md.ctime() : md.mtime());
+
+    if (raw.size() >= sizeof(xtime)) {
+      (void) memcpy(&xtime, raw.data(), sizeof(xtime));
+    }
+
+    if (youngerThan && (xtime.tv_sec < youngerThan)) {
+      return false;
+    }
+
+    if (olderThan && (xtime.tv_sec > olderThan)) {
+      return false;
+    }
+  }
+
+  if (matchLayout && (md.layout_id() != layoutId)) {
+    return false;
+  }
+
+  if (!attrKey.empty()) {
+    if (!item.attrs.empty()) {
+      auto it = item.attrs.find(attrKey);
+
+      if ((it == item.attrs.end()) || (it->second != attrValue)) {
+        return false;
+      }
+    } else {
+      auto it = md.xattrs().find(attrKey);
+
+      if ((it == md.xattrs().end()) || (it->second != attrValue)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ParallelNamespaceExplorer::ParallelNamespaceExplorer(const std::string& path,
+    const ParallelExplorationOptions& options, qclient::QClient& qcl)
+  : mPath(path), mOptions(options), mQcl(qcl), mPending(0), mQueued(0),
+    mStop(false), mErrors(0), mRunning(0)
+{
+  if (mOptions.populateLinkedAttributes && !mOptions.view) {
+    throw_mdexception(EINVAL, "ParallelNamespaceExplorer: asked to populate "
+                      "linked attrs, but view not provided");
+  }
+
+  if (mOptions.threads == 0) {
+    mOptions.threads = 1;
+  }
+
+  if (mOptions.chunkSize == 0) {
+    mOptions.chunkSize = 1;
+  }
+
+  if (mOptions.maxChunks == 0) {
+    mOptions.maxChunks = 1;
+  }
+
+  if (mOptions.fileWindow == 0) {
+    mOptions.fileWindow = 1;
+  }
+
+  // Resolving the path is synchronous by necessity
+  std::vector<std::string> pathParts;
+  eos::PathProcessor::splitPath(pathParts, mPath);
+  ContainerIdentifier id(1);
+  std::string fullPath = "/";
+
+  for (size_t i = 0; i < pathParts.size(); i++) {
+    try {
+      id = MetadataFetcher::getContainerIDFromName(mQcl, id, pathParts[i]).get();
+    } catch (const MDException& exc) {
+      // The last chunk could be a file
+      if ((i != pathParts.size() - 1) || (exc.getErrno() != ENOENT)) {
+        throw;
+      }
+
+      // This may throw again, propagate to caller if so
+      FileIdentifier fid = MetadataFetcher::getFileIDFromName(mQcl, id,
+                           pathParts[i]).get();
+      NamespaceItem item;
+      item.isFile = true;
+      item.expansionFilteredOut = false;
+      item.fileMd = MetadataFetcher::getFileFromId(mQcl, fid).get();
+      item.fullPath = fullPath + pathParts[i];
+      handleLinkedAttrs(item);
+
+      if (!mOptions.fileFilter || mOptions.fileFilter->accept(item)) {
+        mResults.emplace_back();
+        mResults.back().push_back(std::move(item));
+      }
+
+      return;
+    }
+
+    fullPath += pathParts[i];
+    fullPath += "/";
+  }
+
+  for (size_t i = 0; i < mOptions.threads; i++) {
+    mQueues.emplace_back(new WorkQueue());
+  }
+
+  pushTask(0, Task {id, fullPath, 0});
+  mRunning = mOptions.threads;
+
+  for (size_t i = 0; i < mOptions.threads; i++) {
+    mThreads.emplace_back(&ParallelNamespaceExplorer::workerLoop, this, i);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+ParallelNamespaceExplorer::~ParallelNamespaceExplorer()
+{
+  {
+    // Set the flag under both locks so that no waiting thread misses it
+    std::unique_lock<std::mutex> idle_lock(mIdleMutex);
+    std::unique_lock<std::mutex> result_lock(mResultMutex);
+    mStop = true;
+  }
+  mIdleCv.notify_all();
+  mSpaceCv.notify_all();
+
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Fetch the next chunk of items
+//------------------------------------------------------------------------------
+bool ParallelNamespaceExplorer::fetch(std::vector<NamespaceItem>& chunk)
+{
+  std::unique_lock<std::mutex> lock(mResultMutex);
+  mResultCv.wait(lock, [this] {
+    return !mResults.empty() || (mRunning == 0);
+  });
+
+  if (mResults.empty()) {
+    chunk.clear();
+    return false;
+  }
+
+  chunk = std::move(mResults.front());
+  mResults.pop_front();
+  lock.unlock();
+  mSpaceCv.notify_one();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Loop of an exploring thread
+//------------------------------------------------------------------------------
+void ParallelNamespaceExplorer::workerLoop(size_t index)
+{
+  std::vector<NamespaceItem> chunk;
+  Task task;
+
+  while (getTask(index, task, chunk)) {
+    try {
+      explore(index, task, chunk);
+    } catch (const std::exception&) {
+      // Container removed while exploring, or backend error
+      mErrors++;
+    }
+
+    if (--mPending == 0) {
+      std::unique_lock<std::mutex> lock(mIdleMutex);
+      mIdleCv.notify_all();
+    }
+  }
+
+  flush(chunk);
+  {
+    std::unique_lock<std::mutex> lock(mResultMutex);
+    --mRunning;
+  }
+  mResultCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Get the next container to explore for a thread
+//------------------------------------------------------------------------------
+bool ParallelNamespaceExplorer::getTask(size_t index, Task& task,
+                                        std::vector<NamespaceItem>& chunk)
+{
+  const size_t nqueues = mQueues.size();
+
+  while (!mStop) {
+    // Own deque first, newest container first
+    {
+      WorkQueue& own = *mQueues[index];
+      std::unique_lock<std::mutex> lock(own.mutex);
+
+      if (!own.tasks.empty()) {
+        task = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        --mQueued;
+        return true;
+      }
+    }
+
+    // Steal the oldest container of another thread
+    for (size_t i = 1; i < nqueues; i++) {
+      WorkQueue& other = *mQueues[(index + i) % nqueues];
+      std::unique_lock<std::mutex> lock(other.mutex);
+
+      if (!other.tasks.empty()) {
+        task = std::move(other.tasks.front());
+        other.tasks.pop_front();
+        --mQueued;
+        return true;
+      }
+    }
+
+    if (mPending == 0) {
+      return false;
+    }
+
+    // Don't keep results back while idle
+    flush(chunk);
+    std::unique_lock<std::mutex> lock(mIdleMutex);
+    mIdleCv.wait_for(lock, std::chrono::milliseconds(10), [this] {
+      return mStop || (mPending == 0) || (mQueued > 0);
+    });
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Queue a container to explore
+//------------------------------------------------------------------------------
+void ParallelNamespaceExplorer::pushTask(size_t index, Task&& task)
+{
+  ++mPending;
+  {
+    WorkQueue& own = *mQueues[index];
+    std::unique_lock<std::mutex> lock(own.mutex);
+    own.tasks.push_back(std::move(task));
+    ++mQueued;
+  }
+  mIdleCv.notify_one();
+}
+
+//------------------------------------------------------------------------------
+// Explore one container
+//------------------------------------------------------------------------------
+void ParallelNamespaceExplorer::explore(size_t index, Task& task,
+                                        std::vector<NamespaceItem>& chunk)
+{
+  // Issue all requests of the first round at once, unless the listings
+  // have to wait for the expansion decider
+  ExpansionDecider* decider = mOptions.expansionDecider.get();
+  const bool deferred = (decider && mOptions.listAfterDecision);
+  folly::Future<eos::ns::ContainerMdProto> containerMd =
+    MetadataFetcher::getContainerFromId(mQcl, task.id);
+  folly::Future<IContainerMD::FileMap> fileMap = (deferred ?
+      folly::makeFuture(IContainerMD::FileMap()) :
+      MetadataFetcher::getFilesInContainer(mQcl, task.id));
+  folly::Future<IContainerMD::ContainerMap> containerMap = (deferred ?
+      folly::makeFuture(IContainerMD::ContainerMap()) :
+      MetadataFetcher::getSubContainers(mQcl, task.id));
+
+  NamespaceItem item;
+  item.isFile = false;
+  item.fullPath = task.path;
+  item.containerMd = containerMd.get();
+  handleLinkedAttrs(item);
+  item.expansionFilteredOut = (decider &&
+                               !decider->shouldExpandContainer(item.containerMd, item.attrs));
+  const bool expand = !item.expansionFilteredOut;
+  emit(std::move(item), chunk);
+
+  if (!expand) {
+    return;
+  }
+
+  if (deferred) {
+    fileMap = MetadataFetcher::getFilesInContainer(mQcl, task.id);
+    containerMap = MetadataFetcher::getSubContainers(mQcl, task.id);
+  }
+
+  // Queue the subcontainers first so that idle threads can steal them while
+  // the files of this container are fetched
+  if ((mOptions.depthLimit <= 0) ||
+      (task.depth < (uint64_t) mOptions.depthLimit)) {
+    IContainerMD::ContainerMap subcontainers = containerMap.get();
+
+    for (auto it = subcontainers.begin(); it != subcontainers.end(); ++it) {
+      pushTask(index, Task {ContainerIdentifier(it->second),
+                            task.path + it->first + "/", task.depth + 1});
+    }
+  }
+
+  // Keep a bounded window of file fetches in flight
+  IContainerMD::FileMap files = fileMap.get();
+  std::deque<folly::Future<eos::ns::FileMdProto>> pending;
+  auto emitFile = [&](folly::Future<eos::ns::FileMdProto>& fut) {
+    NamespaceItem fitem;
+
+    try {
+      fitem.fileMd = fut.get();
+    } catch (const std::exception&) {
+      // File removed while exploring
+      mErrors++;
+      return;
+    }
+
+    fitem.isFile = true;
+    fitem.expansionFilteredOut = false;
+    fitem.fullPath = task.path + fitem.fileMd.name();
+    handleLinkedAttrs(fitem);
+
+    if (!mOptions.fileFilter || mOptions.fileFilter->accept(fitem)) {
+      emit(std::move(fitem), chunk);
+    }
+  };
+
+  for (auto it = files.begin(); (it != files.end()) && !mStop; ++it) {
+    pending.push_back(MetadataFetcher::getFileFromId(mQcl,
+                      FileIdentifier(it->second)));
+
+    if (pending.size() >= mOptions.fileWindow) {
+      emitFile(pending.front());
+      pending.pop_front();
+    }
+  }
+
+  while (!pending.empty() && !mStop) {
+    emitFile(pending.front());
+    pending.pop_front();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add an item to the chunk of a thread
+//------------------------------------------------------------------------------
+void ParallelNamespaceExplorer::emit(NamespaceItem&& item,
+                                     std::vector<NamespaceItem>& chunk)
+{
+  chunk.push_back(std::move(item));
+
+  if (chunk.size() >= mOptions.chunkSize) {
+    flush(chunk);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Hand a chunk to the consumer, blocking while the queue is full
+//------------------------------------------------------------------------------
+void ParallelNamespaceExplorer::flush(std::vector<NamespaceItem>& chunk)
+{
+  if (chunk.empty()) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mResultMutex);
+  mSpaceCv.wait(lock, [this] {
+    return mStop || (mResults.size() < mOptions.maxChunks);
+  });
+
+  if (!mStop) {
+    mResults.push_back(std::move(chunk));
+  }
+
+  chunk.clear();
+  lock.unlock();
+  mResultCv.notify_one();
+}
+
+//------------------------------------------------------------------------------
+// Populate the linked attributes of an item
+//------------------------------------------------------------------------------
+void ParallelNamespaceExplorer::handleLinkedAttrs(NamespaceItem& item)
+{
+  item.attrs.clear();
+
+  if (!mOptions.populateLinkedAttributes) {
+    return;
+  }
+
+  const google::protobuf::Map<std::string, std::string>& attrMap =
+    (item.isFile ? item.fileMd.xattrs() : item.containerMd.xattrs());
+  auto link = attrMap.find("sys.attr.link");
+
+  if (link == attrMap.end()) {
+    return;
+  }
+
+  item.attrs = {attrMap.begin(), attrMap.end()};
+  {
+    std::unique_lock<std::mutex> lock(mAttrMutex);
+    auto cached = mCachedAttrs.find(link->second);
+
+    if (cached != mCachedAttrs.end()) {
+      populateLinkedAttributes(cached->second, item.attrs, mOptions.prefixLinks);
+      return;
+    }
+  }
+  // Cache miss, fetch without holding the lock
+  eos::IContainerMD::XAttrMap linked;
+
+  try {
+    FileOrContainerMD target = mOptions.view->getItem(link->second, true).get();
+
+    if (target.file) {
+      linked = target.file->getAttributes();
+    } else if (target.container) {
+      linked = target.container->getAttributes();
+    }
+  } catch (const eos::MDException&) {
+    // linked remains empty
+  }
+
+  populateLinkedAttributes(linked, item.attrs, mOptions.prefixLinks);
+  std::unique_lock<std::mutex> lock(mAttrMutex);
+  mCachedAttrs.emplace(link->second, std::move(linked));
+}
+
+EOSNSNAMESPACE_END
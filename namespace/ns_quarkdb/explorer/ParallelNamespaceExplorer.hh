@@ -0,0 +1,212 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Class for exploring the namespace with multiple threads
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include "namespace/Namespace.hh"
+#include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Predicates on file metadata, evaluated by the exploring threads so that
+//! only the matching files are handed to the consumer. Containers are always
+//! returned.
+//------------------------------------------------------------------------------
+struct FileFilter {
+  uint64_t minSize = 0;
+  uint64_t maxSize = std::numeric_limits<uint64_t>::max();
+  time_t youngerThan = 0; ///< Keep files with time >= youngerThan, 0 to ignore
+  time_t olderThan = 0; ///< Keep files with time <= olderThan, 0 to ignore
+  bool useCtime = false; ///< Compare ctime instead of mtime
+  bool matchLayout = false;
+  uint32_t layoutId = 0;
+  std::string attrKey; ///< Attribute which has to match, empty to ignore
+  std::string attrValue;
+
+  //----------------------------------------------------------------------------
+  //! Check if the given file item passes the filter. The attributes are taken
+  //! from item.attrs if populated, otherwise from the file metadata.
+  //----------------------------------------------------------------------------
+  bool accept(const NamespaceItem& item) const;
+};
+
+//------------------------------------------------------------------------------
+//! Options of the parallel exploration
+//------------------------------------------------------------------------------
+struct ParallelExplorationOptions : public ExplorationOptions {
+  size_t threads = 16; ///< Number of exploring threads
+  size_t chunkSize = 1000; ///< Number of items per result chunk
+  size_t maxChunks = 32; ///< Max number of chunks queued for the consumer
+  size_t fileWindow = 1000; ///< Max number of file fetches in flight per thread
+  std::shared_ptr<FileFilter> fileFilter; ///< Optional file predicates
+  //! Fetch the file and container maps of a container only after the
+  //! expansion decider kept it instead of together with its metadata, for
+  //! deciders pruning large parts of the tree
+  bool listAfterDecision = false;
+
+  ParallelExplorationOptions()
+  {
+    depthLimit = 0;
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Class to explore the QuarkDB namespace starting from some path with a
+//! bounded number of threads. Same consistency guarantees as for the
+//! NamespaceExplorer apply, but the items are returned in no particular
+//! order: a container is returned by the thread which explored it, followed
+//! by its files, but items of different containers are interleaved.
+//!
+//! Every thread owns a deque of containers to explore. A thread pushes the
+//! subcontainers it discovers to the back of its own deque and takes work
+//! from the back as well, so it goes depth first. An idle thread steals from
+//! the front of the deques of the other threads, i.e. the containers closest
+//! to the top of the tree. The fetches of the metadata of the files of a
+//! container and of its subcontainers are pipelined.
+//!
+//! The items are handed to the consumer in chunks through a bounded queue,
+//! the threads block while the queue is full.
+//------------------------------------------------------------------------------
+class ParallelNamespaceExplorer
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor, resolving the path synchronously and starting the threads.
+  //! Throws MDException if the path does not exist. No ownership of the
+  //! QClient object.
+  //----------------------------------------------------------------------------
+  ParallelNamespaceExplorer(const std::string& path,
+                            const ParallelExplorationOptions& options,
+                            qclient::QClient& qcl);
+
+  //----------------------------------------------------------------------------
+  //! Destructor, stopping the exploration if not finished
+  //----------------------------------------------------------------------------
+  ~ParallelNamespaceExplorer();
+
+  //----------------------------------------------------------------------------
+  //! Fetch the next chunk of items, blocking until one is available
+  //!
+  //! @param chunk output chunk, replaced with the next one
+  //!
+  //! @return false if the exploration is over, otherwise true
+  //----------------------------------------------------------------------------
+  bool fetch(std::vector<NamespaceItem>& chunk);
+
+  //----------------------------------------------------------------------------
+  //! Get number of containers which could not be explored, e.g. because they
+  //! were deleted while exploring
+  //----------------------------------------------------------------------------
+  uint64_t getErrors() const
+  {
+    return mErrors;
+  }
+
+private:
+  //! Container to explore
+  struct Task {
+    ContainerIdentifier id;
+    std::string path; ///< Full path ending with "/"
+    uint64_t depth; ///< Depth below the start path
+  };
+
+  //! Deque of containers owned by one thread
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::string mPath;
+  ParallelExplorationOptions mOptions;
+  qclient::QClient& mQcl;
+  std::vector<std::unique_ptr<WorkQueue>> mQueues;
+  std::vector<std::thread> mThreads;
+  //! Containers queued or being explored, the exploration is over at 0
+  std::atomic<uint64_t> mPending;
+  std::atomic<uint64_t> mQueued; ///< Containers queued in the deques
+  std::atomic<bool> mStop;
+  std::atomic<uint64_t> mErrors;
+  std::mutex mIdleMutex; ///< Mutex for idle threads waiting for work
+  std::condition_variable mIdleCv;
+
+  std::mutex mResultMutex; ///< Mutex protecting the result queue
+  std::condition_variable mResultCv; ///< Signaled when a chunk is queued
+  std::condition_variable mSpaceCv; ///< Signaled when a chunk is consumed
+  std::deque<std::vector<NamespaceItem>> mResults;
+  size_t mRunning; ///< Threads still running, protected by mResultMutex
+
+  std::mutex mAttrMutex; ///< Mutex protecting mCachedAttrs
+  std::map<std::string, eos::IContainerMD::XAttrMap> mCachedAttrs;
+
+  //----------------------------------------------------------------------------
+  //! Loop of an exploring thread
+  //----------------------------------------------------------------------------
+  void workerLoop(size_t index);
+
+  //----------------------------------------------------------------------------
+  //! Get the next container to explore for a thread, stealing from the
+  //! other threads if its own deque is empty. The partial chunk of the
+  //! thread is handed to the consumer before waiting for work.
+  //!
+  //! @return true if a task was found, false if the exploration is over
+  //----------------------------------------------------------------------------
+  bool getTask(size_t index, Task& task, std::vector<NamespaceItem>& chunk);
+
+  //----------------------------------------------------------------------------
+  //! Queue a container to explore in a thread's own deque
+  //----------------------------------------------------------------------------
+  void pushTask(size_t index, Task&& task);
+
+  //----------------------------------------------------------------------------
+  //! Explore one container, queueing its subcontainers
+  //----------------------------------------------------------------------------
+  void explore(size_t index, Task& task, std::vector<NamespaceItem>& chunk);
+
+  //----------------------------------------------------------------------------
+  //! Add an item to the chunk of a thread, handing the chunk to the consumer
+  //! once full
+  //----------------------------------------------------------------------------
+  void emit(NamespaceItem&& item, std::vector<NamespaceItem>& chunk);
+
+  //----------------------------------------------------------------------------
+  //! Hand a chunk to the consumer, blocking while the queue is full
+  //----------------------------------------------------------------------------
+  void flush(std::vector<NamespaceItem>& chunk);
+
+  //----------------------------------------------------------------------------
+  //! Populate the linked attributes of an item, see NamespaceExplorer
+  //----------------------------------------------------------------------------
+  void handleLinkedAttrs(NamespaceItem& item);
+};
+
+EOSNSNAMESPACE_END
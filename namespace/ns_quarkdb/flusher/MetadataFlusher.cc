@@ -28,10 +28,12 @@
 #include "common/Logging.hh"
 #include <iostream>
 #include <chrono>
+#include <algorithm>
 #include <qclient/AssistedThread.hh>
 
 #define __PRI64_PREFIX "l"
 #define PRId64         __PRI64_PREFIX "d"
+#define PRIu64         __PRI64_PREFIX "u"
 
 EOSNSNAMESPACE_BEGIN
 
@@ -44,7 +46,10 @@ MetadataFlusher::MetadataFlusher(const std::string& path,
   notifier(*this),
   backgroundFlusher(contactDetails.members, contactDetails.constructOptions(),
                     notifier, new qclient::RocksDBPersistency(path)),
-  sizePrinter(&MetadataFlusher::queueSizeMonitoring, this)
+  mStagedOps(0), mCoalesceThreshold(10000), mCoalesceMaxOps(256),
+  mCoalesceWindowMs(50), mNumReceived(0), mNumMerged(0),
+  sizePrinter(&MetadataFlusher::queueSizeMonitoring, this),
+  stagedFlusher(&MetadataFlusher::stagedFlushing, this)
 {
   synchronize();
 }
@@ -54,6 +59,7 @@ MetadataFlusher::MetadataFlusher(const std::string& path,
 //------------------------------------------------------------------------------
 MetadataFlusher::~MetadataFlusher()
 {
+  stagedFlusher.join();
   sizePrinter.join();
   synchronize();
 }
@@ -65,24 +71,143 @@ void MetadataFlusher::queueSizeMonitoring(qclient::ThreadAssistant& assistant)
 {
   while (!assistant.terminationRequested()) {
     if (backgroundFlusher.size()) {
+      uint64_t received, merged;
+      getCoalescingStatsAndClear(received, merged);
       eos_static_info("id=%s total-pending=%" PRId64 " enqueued=%" PRId64
-                      " acknowledged=%" PRId64,
+                      " acknowledged=%" PRId64 " received=%" PRIu64
+                      " merged=%" PRIu64 " merge-ratio=%.3f",
                       id.c_str(), backgroundFlusher.size(),
                       backgroundFlusher.getEnqueuedAndClear(),
-                      backgroundFlusher.getAcknowledgedAndClear());
+                      backgroundFlusher.getAcknowledgedAndClear(),
+                      received, merged,
+                      (received ? (double) merged / received : 0.0));
     }
 
     assistant.wait_for(std::chrono::seconds(10));
   }
 }
 
+//------------------------------------------------------------------------------
+// Flush staged requests which have been waiting longer than the window
+//------------------------------------------------------------------------------
+void MetadataFlusher::stagedFlushing(qclient::ThreadAssistant& assistant)
+{
+  while (!assistant.terminationRequested()) {
+    std::chrono::milliseconds window(mCoalesceWindowMs.load());
+    {
+      std::lock_guard<std::mutex> lock(mStagingMutex);
+
+      if (!mStaged.empty() &&
+          (std::chrono::steady_clock::now() - mStagedSince >= window)) {
+        flushStagedLocked();
+      }
+    }
+    assistant.wait_for(std::max(window, std::chrono::milliseconds(1)));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Configure the coalescing of consecutive requests
+//------------------------------------------------------------------------------
+void MetadataFlusher::setCoalescing(uint64_t queue_threshold, uint64_t max_ops,
+                                    std::chrono::milliseconds window)
+{
+  mCoalesceThreshold = queue_threshold;
+  mCoalesceMaxOps = max_ops;
+  mCoalesceWindowMs = window.count();
+}
+
+//------------------------------------------------------------------------------
+// Get coalescing statistics and reset them
+//------------------------------------------------------------------------------
+void MetadataFlusher::getCoalescingStatsAndClear(uint64_t& received,
+    uint64_t& merged)
+{
+  received = mNumReceived.exchange(0);
+  merged = mNumMerged.exchange(0);
+}
+
+//------------------------------------------------------------------------------
+// Push request towards the background flusher
+//------------------------------------------------------------------------------
+void MetadataFlusher::pushRequest(std::vector<std::string>&& req)
+{
+  std::lock_guard<std::mutex> lock(mStagingMutex);
+  ++mNumReceived;
+
+  if (!mStaged.empty()) {
+    if (mergeIntoStagedLocked(req)) {
+      ++mNumMerged;
+      return;
+    }
+
+    flushStagedLocked();
+  }
+
+  // Only hash and set updates are candidates for merging, and only while
+  // the backend is not keeping up with the queue.
+  if ((req.size() >= 3) && (mCoalesceMaxOps > 1) &&
+      (req[0] == "HSET" || req[0] == "HINCRBY" ||
+       req[0] == "SADD" || req[0] == "SREM") &&
+      ((uint64_t)backgroundFlusher.size() >= mCoalesceThreshold)) {
+    mStaged = std::move(req);
+    mStagedOps = 1;
+    mStagedSince = std::chrono::steady_clock::now();
+    return;
+  }
+
+  backgroundFlusher.pushRequest(req);
+}
+
+//------------------------------------------------------------------------------
+// Try to merge request into the staged one
+//------------------------------------------------------------------------------
+bool MetadataFlusher::mergeIntoStagedLocked(const std::vector<std::string>& req)
+{
+  if ((req.size() < 3) || (req[1] != mStaged[1]) ||
+      (mStagedOps >= mCoalesceMaxOps)) {
+    return false;
+  }
+
+  if ((req[0] == "HSET") && (req.size() == 4) &&
+      (mStaged[0] == "HSET" || mStaged[0] == "HMSET")) {
+    // Fields are applied in order, a repeated field keeps the last value
+    mStaged[0] = "HMSET";
+    mStaged.push_back(req[2]);
+    mStaged.push_back(req[3]);
+  } else if ((req[0] == "HINCRBY") && (mStaged[0] == "HINCRBY") &&
+             (req[2] == mStaged[2])) {
+    mStaged[3] = std::to_string(std::stoll(mStaged[3]) + std::stoll(req[3]));
+  } else if (((req[0] == "SADD") || (req[0] == "SREM")) &&
+             (req[0] == mStaged[0])) {
+    mStaged.insert(mStaged.end(), req.begin() + 2, req.end());
+  } else {
+    return false;
+  }
+
+  ++mStagedOps;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Hand over the staged request to the background flusher
+//------------------------------------------------------------------------------
+void MetadataFlusher::flushStagedLocked()
+{
+  if (!mStaged.empty()) {
+    backgroundFlusher.pushRequest(mStaged);
+    mStaged.clear();
+    mStagedOps = 0;
+  }
+}
+
 //------------------------------------------------------------------------------
 // Queue an hset command
 //------------------------------------------------------------------------------
 void MetadataFlusher::hset(const std::string& key, const std::string& field,
                            const std::string& value)
 {
-  backgroundFlusher.pushRequest({"HSET", key, field, value});
+  pushRequest({"HSET", key, field, value});
 }
 
 //------------------------------------------------------------------------------
@@ -91,7 +216,7 @@ void MetadataFlusher::hset(const std::string& key, const std::string& field,
 void MetadataFlusher::hincrby(const std::string& key, const std::string& field,
                               int64_t value)
 {
-  backgroundFlusher.pushRequest({"HINCRBY", key, field, std::to_string(value)});
+  pushRequest({"HINCRBY", key, field, std::to_string(value)});
 }
 
 //------------------------------------------------------------------------------
@@ -99,7 +224,7 @@ void MetadataFlusher::hincrby(const std::string& key, const std::string& field,
 //------------------------------------------------------------------------------
 void MetadataFlusher::del(const std::string& key)
 {
-  backgroundFlusher.pushRequest({"DEL", key});
+  pushRequest({"DEL", key});
 }
 
 //------------------------------------------------------------------------------
@@ -107,7 +232,7 @@ void MetadataFlusher::del(const std::string& key)
 //------------------------------------------------------------------------------
 void MetadataFlusher::hdel(const std::string& key, const std::string& field)
 {
-  backgroundFlusher.pushRequest({"HDEL", key, field});
+  pushRequest({"HDEL", key, field});
 }
 
 //------------------------------------------------------------------------------
@@ -115,7 +240,7 @@ void MetadataFlusher::hdel(const std::string& key, const std::string& field)
 //------------------------------------------------------------------------------
 void MetadataFlusher::sadd(const std::string& key, const std::string& field)
 {
-  backgroundFlusher.pushRequest({"SADD", key, field});
+  pushRequest({"SADD", key, field});
 }
 
 //------------------------------------------------------------------------------
@@ -123,7 +248,7 @@ void MetadataFlusher::sadd(const std::string& key, const std::string& field)
 //------------------------------------------------------------------------------
 void MetadataFlusher::srem(const std::string& key, const std::string& field)
 {
-  backgroundFlusher.pushRequest({"SREM", key, field});
+  pushRequest({"SREM", key, field});
 }
 
 //------------------------------------------------------------------------------
@@ -138,7 +263,7 @@ void MetadataFlusher::srem(const std::string& key,
     req.emplace_back(*it);
   }
 
-  backgroundFlusher.pushRequest(req);
+  pushRequest(std::move(req));
 }
 
 //------------------------------------------------------------------------------
@@ -146,6 +271,12 @@ void MetadataFlusher::srem(const std::string& key,
 //------------------------------------------------------------------------------
 void MetadataFlusher::synchronize(ItemIndex targetIndex)
 {
+  {
+    // Anything staged for coalescing must be part of what we wait for
+    std::lock_guard<std::mutex> lock(mStagingMutex);
+    flushStagedLocked();
+  }
+
   if (targetIndex < 0) {
     targetIndex = backgroundFlusher.getEndingIndex() - 1;
   }
@@ -28,8 +28,11 @@
 #include "namespace/ns_quarkdb/LRU.hh"
 #include "qclient/BackgroundFlusher.hh"
 #include "qclient/AssistedThread.hh"
+#include <atomic>
+#include <chrono>
 #include <list>
 #include <map>
+#include <mutex>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -73,7 +76,7 @@ public:
   template<typename... Args>
   void exec(const Args... args)
   {
-    backgroundFlusher.pushRequest(std::vector<std::string> {args...});
+    pushRequest(std::vector<std::string> {args...});
   }
 
   void del(const std::string& key);
@@ -88,7 +91,7 @@ public:
 
   void execute(const std::vector<std::string>& req)
   {
-    backgroundFlusher.pushRequest(req);
+    pushRequest(std::vector<std::string>(req));
   }
 
   //----------------------------------------------------------------------------
@@ -100,13 +103,71 @@ public:
   //----------------------------------------------------------------------------
   void synchronize(ItemIndex targetIndex = -1);
 
+  //----------------------------------------------------------------------------
+  //! Configure the coalescing of consecutive requests targeting the same key.
+  //! Coalescing kicks in only once the backlog of the background flusher
+  //! reaches the given threshold, so that an idle queue adds no latency.
+  //!
+  //! @param queue_threshold min number of pending items to start coalescing,
+  //!        0 means always coalesce and UINT64_MAX disables it
+  //! @param max_ops max number of requests merged into one
+  //! @param window max time a request is held back waiting to be merged
+  //----------------------------------------------------------------------------
+  void setCoalescing(uint64_t queue_threshold, uint64_t max_ops,
+                     std::chrono::milliseconds window);
+
+  //----------------------------------------------------------------------------
+  //! Get number of requests received and number of requests merged into
+  //! others since the last call
+  //----------------------------------------------------------------------------
+  void getCoalescingStatsAndClear(uint64_t& received, uint64_t& merged);
+
 private:
+  //----------------------------------------------------------------------------
+  //! Push request towards the background flusher, possibly merging it with
+  //! the currently staged request
+  //----------------------------------------------------------------------------
+  void pushRequest(std::vector<std::string>&& req);
+
+  //----------------------------------------------------------------------------
+  //! Try to merge request into the staged one - must be called with the
+  //! staging mutex locked.
+  //!
+  //! @return true if merged, otherwise false
+  //----------------------------------------------------------------------------
+  bool mergeIntoStagedLocked(const std::vector<std::string>& req);
+
+  //----------------------------------------------------------------------------
+  //! Hand over the staged request to the background flusher - must be called
+  //! with the staging mutex locked.
+  //----------------------------------------------------------------------------
+  void flushStagedLocked();
+
+  //----------------------------------------------------------------------------
+  //! Flush staged requests which have been waiting longer than the window
+  //----------------------------------------------------------------------------
+  void stagedFlushing(qclient::ThreadAssistant& assistant);
+
   void queueSizeMonitoring(qclient::ThreadAssistant& assistant);
   std::string id;
 
   FlusherNotifier notifier;
   qclient::BackgroundFlusher backgroundFlusher;
+  //! Mutex protecting the staged request
+  std::mutex mStagingMutex;
+  //! Request waiting to be merged with the subsequent ones
+  std::vector<std::string> mStaged;
+  //! Number of requests merged into the staged one
+  uint64_t mStagedOps;
+  //! Time when the staged request was created
+  std::chrono::steady_clock::time_point mStagedSince;
+  std::atomic<uint64_t> mCoalesceThreshold; ///< Backlog to start coalescing
+  std::atomic<uint64_t> mCoalesceMaxOps; ///< Max requests merged into one
+  std::atomic<int64_t> mCoalesceWindowMs; ///< Max time a request is staged
+  std::atomic<uint64_t> mNumReceived; ///< Number of requests received
+  std::atomic<uint64_t> mNumMerged; ///< Number of requests merged
   qclient::AssistedThread sizePrinter;
+  qclient::AssistedThread stagedFlusher;
 };
 
 class MetadataFlusherFactory
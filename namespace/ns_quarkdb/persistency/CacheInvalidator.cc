@@ -0,0 +1,427 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/persistency/CacheInvalidator.hh"
+#include "namespace/ns_quarkdb/persistency/MetadataProvider.hh"
+#include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
+#include "namespace/ns_quarkdb/Constants.hh"
+#include "common/Logging.hh"
+#include <qclient/QClient.hh>
+#include <cstdlib>
+#include <future>
+
+EOSNSNAMESPACE_BEGIN
+
+constexpr uint64_t CacheInvalidator::sRetainedBatches;
+constexpr std::chrono::seconds CacheInvalidator::sHeartbeatTimeout;
+constexpr size_t CacheInvalidator::sMaxBatchEntries;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+CacheInvalidator::CacheInvalidator(MetadataProvider* provider,
+                                   qclient::QClient* qcl,
+                                   MetadataFlusher* flusher):
+  mProvider(provider), mQcl(qcl), mFlusher(flusher), mMode(Mode::kOff),
+  mPendingDropAll(false), mSeq(0), mBeat(0), mPrevDropAll(false),
+  mStale(false)
+{
+  mThread.reset(&CacheInvalidator::run, this);
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+CacheInvalidator::~CacheInvalidator()
+{
+  mThread.join();
+  std::lock_guard<std::mutex> lock(mRoundMutex);
+
+  if (mMode == Mode::kPublish) {
+    publishRound();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Parse mode from its string representation
+//------------------------------------------------------------------------------
+bool
+CacheInvalidator::ParseMode(const std::string& value, Mode& mode)
+{
+  if (value == "off") {
+    mode = Mode::kOff;
+  } else if (value == "publish") {
+    mode = Mode::kPublish;
+  } else if (value == "follow") {
+    mode = Mode::kFollow;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Change mode
+//------------------------------------------------------------------------------
+void
+CacheInvalidator::setMode(Mode mode)
+{
+  std::lock_guard<std::mutex> lock(mRoundMutex);
+
+  if (mMode == mode) {
+    return;
+  }
+
+  // Leave nothing behind from the current mode
+  try {
+    if (mMode == Mode::kPublish) {
+      publishRound();
+    } else if (mMode == Mode::kFollow) {
+      followRound();
+    }
+  } catch (const std::exception& e) {
+    eos_static_err("msg=\"failed cache invalidation round\" reason=\"%s\"",
+                   e.what());
+  }
+
+  mMode = mode;
+
+  if (mode == Mode::kPublish) {
+    startPublishing();
+  } else if (mode == Mode::kFollow) {
+    startFollowing();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Record modification of a file
+//------------------------------------------------------------------------------
+void
+CacheInvalidator::fileModified(FileIdentifier id, ContainerIdentifier parent)
+{
+  if (mMode != Mode::kPublish) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mPendingMutex);
+
+  if (mPendingDropAll) {
+    return;
+  }
+
+  mPendingFiles.insert(id.getUnderlyingUInt64());
+
+  // The parent container caches the name of the file
+  if (parent.getUnderlyingUInt64()) {
+    mPendingContainers.insert(parent.getUnderlyingUInt64());
+  }
+
+  if (mPendingFiles.size() + mPendingContainers.size() > sMaxBatchEntries) {
+    mPendingDropAll = true;
+    mPendingFiles.clear();
+    mPendingContainers.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Record modification of a container
+//------------------------------------------------------------------------------
+void
+CacheInvalidator::containerModified(ContainerIdentifier id,
+                                    ContainerIdentifier parent)
+{
+  if (mMode != Mode::kPublish) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mPendingMutex);
+
+  if (mPendingDropAll) {
+    return;
+  }
+
+  mPendingContainers.insert(id.getUnderlyingUInt64());
+
+  if (parent.getUnderlyingUInt64()) {
+    mPendingContainers.insert(parent.getUnderlyingUInt64());
+  }
+
+  if (mPendingFiles.size() + mPendingContainers.size() > sMaxBatchEntries) {
+    mPendingDropAll = true;
+    mPendingFiles.clear();
+    mPendingContainers.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Loop publishing or following the invalidations
+//------------------------------------------------------------------------------
+void
+CacheInvalidator::run(ThreadAssistant& assistant) noexcept
+{
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(std::chrono::seconds(1));
+    std::lock_guard<std::mutex> lock(mRoundMutex);
+
+    try {
+      if (mMode == Mode::kPublish) {
+        publishRound();
+      } else if (mMode == Mode::kFollow) {
+        followRound();
+      }
+    } catch (const std::exception& e) {
+      eos_static_err("msg=\"failed cache invalidation round\" reason=\"%s\"",
+                     e.what());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Read the last batch number and the heartbeat of the publisher
+//------------------------------------------------------------------------------
+bool
+CacheInvalidator::readSeq(uint64_t& seq, std::string& value)
+{
+  qclient::redisReplyPtr reply =
+    mQcl->exec("GET", constants::sCacheInvalidationSeqKey).get();
+
+  if (!reply) {
+    return false;
+  }
+
+  // No publisher so far
+  if (reply->type == REDIS_REPLY_NIL) {
+    seq = 0;
+    value.clear();
+    return true;
+  }
+
+  if (reply->type != REDIS_REPLY_STRING) {
+    return false;
+  }
+
+  // Format is <seq>:<heartbeat>
+  value.assign(reply->str, reply->len);
+  seq = strtoull(value.c_str(), nullptr, 10);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Start publishing
+//------------------------------------------------------------------------------
+void
+CacheInvalidator::startPublishing()
+{
+  uint64_t seq = 0;
+  std::string value;
+
+  if (!readSeq(seq, value)) {
+    eos_static_warning("%s", "msg=\"failed to read cache invalidation "
+                       "sequence, starting from scratch\"");
+  }
+
+  // The previous publisher may still have batches queued in its flusher, so
+  // continue well after them. Followers detect the gap and drop their cache.
+  mSeq = seq + sRetainedBatches;
+  mBeat = 0;
+  mFlusher->del(constants::sCacheInvalidationKey);
+  mFlusher->exec("SET", constants::sCacheInvalidationSeqKey,
+                 std::to_string(mSeq) + ":" + std::to_string(mBeat));
+}
+
+//------------------------------------------------------------------------------
+// Publish the pending invalidations and the heartbeat
+//------------------------------------------------------------------------------
+void
+CacheInvalidator::publishRound()
+{
+  std::unordered_set<uint64_t> files;
+  std::unordered_set<uint64_t> containers;
+  bool drop_all = false;
+  {
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    std::swap(files, mPendingFiles);
+    std::swap(containers, mPendingContainers);
+    std::swap(drop_all, mPendingDropAll);
+  }
+
+  if (drop_all || !files.empty() || !containers.empty()) {
+    std::string batch;
+
+    if (drop_all) {
+      batch = "*";
+    } else {
+      batch.reserve((files.size() + containers.size()) * 8);
+
+      for (const auto& id : files) {
+        batch += 'f';
+        batch += std::to_string(id);
+        batch += ',';
+      }
+
+      for (const auto& id : containers) {
+        batch += 'c';
+        batch += std::to_string(id);
+        batch += ',';
+      }
+
+      batch.pop_back();
+    }
+
+    ++mSeq;
+    mFlusher->hset(constants::sCacheInvalidationKey, std::to_string(mSeq),
+                   batch);
+
+    if (mSeq > sRetainedBatches) {
+      mFlusher->hdel(constants::sCacheInvalidationKey,
+                     std::to_string(mSeq - sRetainedBatches));
+    }
+  }
+
+  ++mBeat;
+  mFlusher->exec("SET", constants::sCacheInvalidationSeqKey,
+                 std::to_string(mSeq) + ":" + std::to_string(mBeat));
+}
+
+//------------------------------------------------------------------------------
+// Start following from the last published batch
+//------------------------------------------------------------------------------
+void
+CacheInvalidator::startFollowing()
+{
+  if (!readSeq(mSeq, mLastSeqValue)) {
+    mSeq = 0;
+    mLastSeqValue.clear();
+  }
+
+  mLastSeqChange = std::chrono::steady_clock::now();
+  mStale = false;
+  // Whatever is in the cache may predate the last published batch
+  mProvider->dropAll();
+  mPrevBatches.clear();
+  mPrevDropAll = true;
+}
+
+//------------------------------------------------------------------------------
+// Apply the batches published since the last round
+//------------------------------------------------------------------------------
+void
+CacheInvalidator::followRound()
+{
+  uint64_t seq = 0;
+  std::string value;
+  std::vector<std::string> batches;
+  bool drop_all = false;
+
+  if (readSeq(seq, value)) {
+    auto now = std::chrono::steady_clock::now();
+
+    if (value != mLastSeqValue) {
+      mLastSeqValue = value;
+      mLastSeqChange = now;
+    }
+
+    bool stale = (now - mLastSeqChange > sHeartbeatTimeout);
+
+    if (stale != mStale) {
+      mStale = stale;
+
+      if (stale) {
+        eos_static_warning("%s", "msg=\"no cache invalidation heartbeat from "
+                           "the master, not keeping the cache\"");
+      } else {
+        eos_static_info("%s", "msg=\"cache invalidation heartbeat resumed\"");
+      }
+    }
+
+    if (stale || (seq < mSeq) || (seq - mSeq > sRetainedBatches)) {
+      drop_all = true;
+    } else if (seq > mSeq) {
+      std::vector<std::future<qclient::redisReplyPtr>> futs;
+
+      for (uint64_t s = mSeq + 1; s <= seq; ++s) {
+        futs.emplace_back(mQcl->exec("HGET", constants::sCacheInvalidationKey,
+                                     std::to_string(s)));
+      }
+
+      for (auto& fut : futs) {
+        qclient::redisReplyPtr reply = fut.get();
+
+        // Batch already trimmed or lost
+        if (!reply || (reply->type != REDIS_REPLY_STRING)) {
+          drop_all = true;
+          break;
+        }
+
+        batches.emplace_back(reply->str, reply->len);
+      }
+    }
+
+    mSeq = seq;
+  }
+
+  // Apply the previous round a second time for entries fetched concurrently
+  // with the modification
+  if (drop_all || mPrevDropAll) {
+    mProvider->dropAll();
+  } else {
+    for (const auto& batch : mPrevBatches) {
+      applyBatch(batch);
+    }
+
+    for (const auto& batch : batches) {
+      applyBatch(batch);
+    }
+  }
+
+  mPrevBatches = std::move(batches);
+  mPrevDropAll = drop_all;
+}
+
+//------------------------------------------------------------------------------
+// Drop the entries listed in a batch from the cache
+//------------------------------------------------------------------------------
+void
+CacheInvalidator::applyBatch(const std::string& batch)
+{
+  size_t pos = 0;
+
+  while (pos < batch.length()) {
+    size_t end = batch.find(',', pos);
+
+    if (end == std::string::npos) {
+      end = batch.length();
+    }
+
+    uint64_t id = strtoull(batch.c_str() + pos + 1, nullptr, 10);
+
+    if (batch[pos] == 'f') {
+      mProvider->dropFileMD(FileIdentifier(id));
+    } else if (batch[pos] == 'c') {
+      mProvider->dropContainerMD(ContainerIdentifier(id));
+    } else if (batch[pos] == '*') {
+      mProvider->dropAll();
+      return;
+    }
+
+    pos = end + 1;
+  }
+}
+
+EOSNSNAMESPACE_END
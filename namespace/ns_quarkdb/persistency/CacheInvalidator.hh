@@ -0,0 +1,199 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Keeps the metadata cache of a standby MGM coherent with the master
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include "namespace/interface/Identifiers.hh"
+#include "common/AssistedThread.hh"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace qclient
+{
+class QClient;
+}
+
+EOSNSNAMESPACE_BEGIN
+
+class MetadataFlusher;
+class MetadataProvider;
+
+//------------------------------------------------------------------------------
+//! Class CacheInvalidator
+//!
+//! The master records the ids of the files and containers it modifies and
+//! publishes them once per second as a numbered batch in the hash
+//! eos-md-cache-invalidation. The batches go through the metadata flusher, so
+//! they reach QuarkDB after the modifications they refer to. The batch number
+//! and a heartbeat are kept in eos-md-cache-invalidation-seq.
+//!
+//! A standby MGM follows the batches and drops the listed entries from its
+//! cache, which allows it to keep caching enabled while the master is active.
+//! Every batch is applied a second time one round later, to also drop entries
+//! fetched concurrently with the modification. If the standby falls behind
+//! the retained batches or the publisher heartbeat stops, the whole cache is
+//! dropped.
+//------------------------------------------------------------------------------
+class CacheInvalidator
+{
+public:
+  enum class Mode {
+    kOff, ///< Neither publish nor follow invalidations
+    kPublish, ///< Master publishing the entries it modifies
+    kFollow ///< Standby dropping the entries modified by the master
+  };
+
+  //! Number of batches kept in QuarkDB
+  static constexpr uint64_t sRetainedBatches = 600;
+  //! Time without publisher heartbeat after which the cache is dropped
+  static constexpr std::chrono::seconds sHeartbeatTimeout {30};
+  //! Max number of entries in a batch, beyond that the whole cache is dropped
+  static constexpr size_t sMaxBatchEntries = 100000;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param provider metadata provider holding the cache
+  //! @param qcl qclient used by the follower
+  //! @param flusher metadata flusher used by the publisher
+  //----------------------------------------------------------------------------
+  CacheInvalidator(MetadataProvider* provider, qclient::QClient* qcl,
+                   MetadataFlusher* flusher);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~CacheInvalidator();
+
+  //----------------------------------------------------------------------------
+  //! Parse mode from its string representation
+  //!
+  //! @param value off, publish or follow
+  //! @param mode output mode
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool ParseMode(const std::string& value, Mode& mode);
+
+  //----------------------------------------------------------------------------
+  //! Change mode. Pending invalidations are published or applied before
+  //! leaving the current mode.
+  //----------------------------------------------------------------------------
+  void setMode(Mode mode);
+
+  //----------------------------------------------------------------------------
+  //! Get current mode
+  //----------------------------------------------------------------------------
+  inline Mode getMode() const
+  {
+    return mMode.load();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Record modification of a file, no-op unless publishing
+  //!
+  //! @param id file id
+  //! @param parent id of the container holding the file
+  //----------------------------------------------------------------------------
+  void fileModified(FileIdentifier id, ContainerIdentifier parent);
+
+  //----------------------------------------------------------------------------
+  //! Record modification of a container, no-op unless publishing
+  //!
+  //! @param id container id
+  //! @param parent id of the parent container
+  //----------------------------------------------------------------------------
+  void containerModified(ContainerIdentifier id, ContainerIdentifier parent);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Loop publishing or following the invalidations
+  //----------------------------------------------------------------------------
+  void run(ThreadAssistant& assistant) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Start publishing, skipping the batch numbers which may still be in use
+  //! by the previous publisher
+  //!
+  //! @note must be called with mRoundMutex locked
+  //----------------------------------------------------------------------------
+  void startPublishing();
+
+  //----------------------------------------------------------------------------
+  //! Publish the pending invalidations and the heartbeat
+  //!
+  //! @note must be called with mRoundMutex locked
+  //----------------------------------------------------------------------------
+  void publishRound();
+
+  //----------------------------------------------------------------------------
+  //! Start following from the last published batch
+  //!
+  //! @note must be called with mRoundMutex locked
+  //----------------------------------------------------------------------------
+  void startFollowing();
+
+  //----------------------------------------------------------------------------
+  //! Apply the batches published since the last round
+  //!
+  //! @note must be called with mRoundMutex locked
+  //----------------------------------------------------------------------------
+  void followRound();
+
+  //----------------------------------------------------------------------------
+  //! Drop the entries listed in a batch from the cache
+  //----------------------------------------------------------------------------
+  void applyBatch(const std::string& batch);
+
+  //----------------------------------------------------------------------------
+  //! Read the last batch number and the heartbeat of the publisher
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool readSeq(uint64_t& seq, std::string& value);
+
+  MetadataProvider* mProvider; ///< Provider holding the cached entries
+  qclient::QClient* mQcl; ///< Client used to read the batches
+  MetadataFlusher* mFlusher; ///< Flusher used to write the batches
+  std::atomic<Mode> mMode; ///< Current mode
+  std::mutex mPendingMutex; ///< Mutex protecting the pending entries
+  ///! Files and containers modified since the last published batch
+  std::unordered_set<uint64_t> mPendingFiles;
+  std::unordered_set<uint64_t> mPendingContainers;
+  bool mPendingDropAll; ///< Too many modifications, drop the whole cache
+  std::mutex mRoundMutex; ///< Serializes the rounds and the mode changes
+  uint64_t mSeq; ///< Last published or applied batch number
+  uint64_t mBeat; ///< Heartbeat of the publisher
+  std::string mLastSeqValue; ///< Last seen value of the batch number key
+  std::chrono::steady_clock::time_point mLastSeqChange; ///< When it changed
+  std::vector<std::string> mPrevBatches; ///< Batches applied in last round
+  bool mPrevDropAll; ///< The whole cache was dropped in the last round
+  bool mStale; ///< The publisher heartbeat stopped
+  AssistedThread mThread; ///< Thread running the rounds
+};
+
+EOSNSNAMESPACE_END
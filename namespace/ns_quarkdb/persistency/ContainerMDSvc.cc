@@ -23,6 +23,7 @@
 #include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
 #include "namespace/ns_quarkdb/persistency/MetadataProvider.hh"
+#include "namespace/ns_quarkdb/persistency/CacheInvalidator.hh"
 #include "namespace/utils/StringConvertion.hh"
 #include "namespace/ns_quarkdb/persistency/RequestBuilder.hh"
 #include "namespace/ns_quarkdb/ConfigurationParser.hh"
@@ -38,7 +39,11 @@ EOSNSNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 QuarkContainerMDSvc::QuarkContainerMDSvc()
   : pQuotaStats(nullptr), pFileSvc(nullptr), pQcl(nullptr), pFlusher(nullptr),
-    mMetaMap(), mNumConts(0ull) {}
+    mMetaMap(), mCacheInvalidator(nullptr), mNumConts(0ull)
+{
+  // Renamed, moved and deleted containers drop out of the path cache
+  pListeners.push_back(&mPathCache);
+}
 
 //------------------------------------------------------------------------------
 // Destructor
@@ -84,6 +89,37 @@ QuarkContainerMDSvc::configure(const std::map<std::string, std::string>& config)
       mMetadataProvider->setContainerMDCacheNum(std::stoull(mCacheNum));
     }
   }
+
+  if (config.find(constants::sMaxNumCacheNegative) != config.end()) {
+    mNegativeCache.set_max_num(std::stoull(
+                                 config.at(constants::sMaxNumCacheNegative)));
+  }
+
+  if (config.find(constants::sPagedFilesThreshold) != config.end()) {
+    mPagedFilesThreshold = config.at(constants::sPagedFilesThreshold);
+
+    if (mMetadataProvider) {
+      mMetadataProvider->setPagedFilesThreshold(std::stoull(mPagedFilesThreshold));
+    }
+  }
+
+  if (config.find(constants::sMaxNumCachePaths) != config.end()) {
+    mPathCache.set_max_num(std::stoull(config.at(constants::sMaxNumCachePaths)));
+  }
+
+  if (config.find(constants::sCachePolicyDirs) != config.end()) {
+    CachePolicy policy;
+    mCachePolicy = config.at(constants::sCachePolicyDirs);
+
+    if (!ParseCachePolicy(mCachePolicy, policy)) {
+      throw_mdexception(EINVAL, __FUNCTION__ << " Unknown container cache "
+                        << "policy: " << mCachePolicy);
+    }
+
+    if (mMetadataProvider) {
+      mMetadataProvider->setContainerMDCachePolicy(policy);
+    }
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -124,6 +160,16 @@ QuarkContainerMDSvc::initialize()
     mMetadataProvider->setContainerMDCacheNum(std::stoull(mCacheNum));
   }
 
+  if (!mPagedFilesThreshold.empty()) {
+    mMetadataProvider->setPagedFilesThreshold(std::stoull(mPagedFilesThreshold));
+  }
+
+  CachePolicy policy;
+
+  if (!mCachePolicy.empty() && ParseCachePolicy(mCachePolicy, policy)) {
+    mMetadataProvider->setContainerMDCachePolicy(policy);
+  }
+
   SafetyCheck();
   mNumConts.store(pQcl->execute(RequestBuilder::getNumberOfContainers())
                   .get()->integer);
@@ -184,6 +230,23 @@ QuarkContainerMDSvc::getContainerMDFut(IContainerMD::id_t id)
   return mMetadataProvider->retrieveContainerMD(ContainerIdentifier(id));
 }
 
+//------------------------------------------------------------------------------
+// Asynchronously get the container metadata information for a batch of IDs
+//------------------------------------------------------------------------------
+folly::Future<std::vector<folly::Try<IContainerMDPtr>>>
+    QuarkContainerMDSvc::getContainerMDsFut(const
+        std::vector<IContainerMD::id_t>& ids)
+{
+  std::vector<ContainerIdentifier> cids;
+  cids.reserve(ids.size());
+
+  for (const auto id : ids) {
+    cids.emplace_back(id);
+  }
+
+  return mMetadataProvider->retrieveContainerMDs(cids);
+}
+
 //------------------------------------------------------------------------------
 // Get the container metadata information
 //------------------------------------------------------------------------------
@@ -210,6 +273,7 @@ QuarkContainerMDSvc::createContainer()
   (new QuarkContainerMD(free_id, pFileSvc, static_cast<IContainerMDSvc*>(this)));
   ++mNumConts;
   mMetadataProvider->insertContainerMD(cont->getIdentifier(), cont);
+  notifyListeners(cont.get(), IContainerMDChangeListener::Created);
   return cont;
 }
 
@@ -220,6 +284,13 @@ void
 QuarkContainerMDSvc::updateStore(IContainerMD* obj)
 {
   pFlusher->execute(RequestBuilder::writeContainerProto(obj));
+
+  if (mCacheInvalidator) {
+    mCacheInvalidator->containerModified(obj->getIdentifier(),
+                                         ContainerIdentifier(obj->getParentId()));
+  }
+
+  notifyListeners(obj, IContainerMDChangeListener::Updated);
 }
 
 //----------------------------------------------------------------------------
@@ -245,6 +316,12 @@ QuarkContainerMDSvc::removeContainer(IContainerMD* obj)
     pFlusher->del(constants::sMapMetaInfoKey);
   }
 
+  if (mCacheInvalidator) {
+    mCacheInvalidator->containerModified(obj->getIdentifier(),
+                                         ContainerIdentifier(obj->getParentId()));
+  }
+
+  notifyListeners(obj, IContainerMDChangeListener::Deleted);
   obj->setDeleted();
 
   if (mNumConts) {
@@ -362,4 +439,84 @@ QuarkContainerMDSvc::getCacheStatistics()
   return mMetadataProvider->getContainerMDCacheStats();
 }
 
+//------------------------------------------------------------------------------
+// Persist the ids of the most recently used containers
+//------------------------------------------------------------------------------
+void
+QuarkContainerMDSvc::saveCacheWarmupList(uint64_t max_num)
+{
+  std::vector<ContainerIdentifier> ids =
+    mMetadataProvider->getRecentContainerIds(max_num);
+
+  if (ids.empty()) {
+    return;
+  }
+
+  std::string value;
+  value.reserve(ids.size() * 8);
+
+  for (const auto& id : ids) {
+    if (!value.empty()) {
+      value += ',';
+    }
+
+    value += std::to_string(id.getUnderlyingUInt64());
+  }
+
+  pQcl->exec("SET", constants::sCacheWarmupKey, value);
+}
+
+//------------------------------------------------------------------------------
+// Get the ids persisted by saveCacheWarmupList
+//------------------------------------------------------------------------------
+std::vector<IContainerMD::id_t>
+QuarkContainerMDSvc::loadCacheWarmupList()
+{
+  std::vector<IContainerMD::id_t> ids;
+  qclient::redisReplyPtr reply =
+    pQcl->exec("GET", constants::sCacheWarmupKey).get();
+
+  if (!reply || (reply->type != REDIS_REPLY_STRING)) {
+    return ids;
+  }
+
+  std::string value(reply->str, reply->len);
+  size_t pos = 0;
+
+  while (pos < value.length()) {
+    size_t end = value.find(',', pos);
+
+    if (end == std::string::npos) {
+      end = value.length();
+    }
+
+    IContainerMD::id_t id = strtoull(value.c_str() + pos, nullptr, 10);
+
+    if (id) {
+      ids.push_back(id);
+    }
+
+    pos = end + 1;
+  }
+
+  return ids;
+}
+
+//------------------------------------------------------------------------------
+// Load the given containers into the cache
+//------------------------------------------------------------------------------
+void
+QuarkContainerMDSvc::prefetchContainers(const std::vector<IContainerMD::id_t>&
+                                        ids)
+{
+  std::vector<ContainerIdentifier> cids;
+  cids.reserve(ids.size());
+
+  for (const auto& id : ids) {
+    cids.emplace_back(id);
+  }
+
+  mMetadataProvider->prefetchContainerMDs(cids).wait();
+}
+
 EOSNSNAMESPACE_END
@@ -28,10 +28,13 @@
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/ns_quarkdb/Constants.hh"
 #include "namespace/ns_quarkdb/LRU.hh"
+#include "namespace/ns_quarkdb/NegativeLookupCache.hh"
+#include "namespace/ns_quarkdb/PathLookupCache.hh"
 #include "namespace/ns_quarkdb/persistency/NextInodeProvider.hh"
 #include "namespace/ns_quarkdb/persistency/UnifiedInodeProvider.hh"
 #include "namespace/ns_quarkdb/accounting/QuotaStats.hh"
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
+#include "common/StripedRWMutex.hh"
 #include "qclient/QHash.hh"
 #include <list>
 #include <map>
@@ -40,6 +43,7 @@ EOSNSNAMESPACE_BEGIN
 
 class QuarkContainerMD;
 class MetadataProvider;
+class CacheInvalidator;
 
 //------------------------------------------------------------------------------
 //! Container metadata service based on Redis
@@ -81,6 +85,13 @@ public:
   virtual folly::Future<IContainerMDPtr> getContainerMDFut(
     IContainerMD::id_t id) override;
 
+  //----------------------------------------------------------------------------
+  //! Get the container metadata information for a batch of IDs -
+  //! asynchronous API. Requests are grouped per metadata provider shard.
+  //----------------------------------------------------------------------------
+  virtual folly::Future<std::vector<folly::Try<IContainerMDPtr>>>
+      getContainerMDsFut(const std::vector<IContainerMD::id_t>& ids) override;
+
   //----------------------------------------------------------------------------
   //! Get the container metadata information for the given container ID
   //----------------------------------------------------------------------------
@@ -159,6 +170,15 @@ public:
     mMetadataProvider = provider;
   }
 
+  //----------------------------------------------------------------------------
+  //! Set cache invalidator publishing the modified containers
+  //----------------------------------------------------------------------------
+  void
+  setCacheInvalidator(CacheInvalidator* invalidator)
+  {
+    mCacheInvalidator = invalidator;
+  }
+
   //----------------------------------------------------------------------------
   //! Set inode provider
   //----------------------------------------------------------------------------
@@ -187,6 +207,58 @@ public:
   //----------------------------------------------------------------------------
   virtual CacheStatistics getCacheStatistics() override;
 
+  //----------------------------------------------------------------------------
+  //! Persist the ids of the most recently used containers
+  //----------------------------------------------------------------------------
+  void saveCacheWarmupList(uint64_t max_num) override;
+
+  //----------------------------------------------------------------------------
+  //! Get the ids persisted by saveCacheWarmupList
+  //----------------------------------------------------------------------------
+  std::vector<IContainerMD::id_t> loadCacheWarmupList() override;
+
+  //----------------------------------------------------------------------------
+  //! Load the given containers into the cache
+  //----------------------------------------------------------------------------
+  void prefetchContainers(const std::vector<IContainerMD::id_t>& ids) override;
+
+  //----------------------------------------------------------------------------
+  //! Get cache of names known not to exist in their parent container
+  //----------------------------------------------------------------------------
+  NegativeLookupCache*
+  getNegativeLookupCache()
+  {
+    return &mNegativeCache;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get cache of directory paths resolved to container ids
+  //----------------------------------------------------------------------------
+  PathLookupCache*
+  getPathLookupCache()
+  {
+    return &mPathCache;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get per-container lock stripes used by operations which only touch a
+  //! few containers and can run under the global namespace read lock
+  //----------------------------------------------------------------------------
+  eos::common::StripedRWMutex*
+  getContainerLocks()
+  {
+    return &mContainerLocks;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the file metadata service
+  //----------------------------------------------------------------------------
+  IFileMDSvc*
+  getFileMDService()
+  {
+    return pFileSvc;
+  }
+
 private:
   typedef std::list<IContainerMDChangeListener*> ListenerList;
 
@@ -221,10 +293,16 @@ private:
   //! Map holding metainfo about the namespace
   qclient::QHash mMetaMap;
   MetadataProvider* mMetadataProvider;  ///< Provider namespace metadata
+  CacheInvalidator* mCacheInvalidator;  ///< Publisher of modified containers
   UnifiedInodeProvider* mUnifiedInodeProvider; ///< Provide next free inode
   std::atomic<uint64_t> mNumConts;      ///< Total number of containers
   std::string
   mCacheNum;                ///< Temporary workaround to store cache size
+  std::string mCachePolicy; ///< Temporary workaround to store cache policy
+  std::string mPagedFilesThreshold; ///< Stored until the provider exists
+  NegativeLookupCache mNegativeCache; ///< Cache of failed lookups
+  PathLookupCache mPathCache; ///< Cache of resolved directory paths
+  eos::common::StripedRWMutex mContainerLocks; ///< Per-container lock stripes
 };
 
 EOSNSNAMESPACE_END
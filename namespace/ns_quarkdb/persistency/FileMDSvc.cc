@@ -25,6 +25,7 @@
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
 #include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
 #include "namespace/ns_quarkdb/persistency/MetadataProvider.hh"
+#include "namespace/ns_quarkdb/persistency/CacheInvalidator.hh"
 #include "namespace/ns_quarkdb/persistency/RequestBuilder.hh"
 #include "namespace/ns_quarkdb/ConfigurationParser.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
@@ -80,6 +81,10 @@ QuarkFileMDSvc::configure(const std::map<std::string, std::string>& config)
     mMetadataProvider.reset(new MetadataProvider(contactDetails, pContSvc, this));
     static_cast<QuarkContainerMDSvc*>(pContSvc)->setMetadataProvider
     (mMetadataProvider.get());
+    mCacheInvalidator.reset(new CacheInvalidator(mMetadataProvider.get(), pQcl,
+                            pFlusher.get()));
+    static_cast<QuarkContainerMDSvc*>(pContSvc)->setCacheInvalidator
+    (mCacheInvalidator.get());
     static_cast<QuarkContainerMDSvc*>(pContSvc)->setInodeProvider
     (&mUnifiedInodeProvider);
   }
@@ -88,6 +93,30 @@ QuarkFileMDSvc::configure(const std::map<std::string, std::string>& config)
     std::string val = config.at(constants::sMaxNumCacheFiles);
     mMetadataProvider->setFileMDCacheNum(std::stoull(val));
   }
+
+  if (config.find(constants::sCachePolicyFiles) != config.end()) {
+    CachePolicy policy;
+    std::string val = config.at(constants::sCachePolicyFiles);
+
+    if (!ParseCachePolicy(val, policy)) {
+      throw_mdexception(EINVAL, __FUNCTION__ << " Unknown file cache policy: "
+                        << val);
+    }
+
+    mMetadataProvider->setFileMDCachePolicy(policy);
+  }
+
+  if (config.find(constants::sCacheInvalidation) != config.end()) {
+    CacheInvalidator::Mode mode;
+    std::string val = config.at(constants::sCacheInvalidation);
+
+    if (!CacheInvalidator::ParseMode(val, mode)) {
+      throw_mdexception(EINVAL, __FUNCTION__ << " Unknown cache invalidation "
+                        << "mode: " << val);
+    }
+
+    mCacheInvalidator->setMode(mode);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -158,6 +187,23 @@ QuarkFileMDSvc::getFileMDFut(IFileMD::id_t id)
   return mMetadataProvider->retrieveFileMD(FileIdentifier(id));
 }
 
+//------------------------------------------------------------------------------
+// Get the file metadata information for a batch of file ids - asynchronous
+// API.
+//------------------------------------------------------------------------------
+folly::Future<std::vector<folly::Try<IFileMDPtr>>>
+    QuarkFileMDSvc::getFileMDsFut(const std::vector<IFileMD::id_t>& ids)
+{
+  std::vector<FileIdentifier> fids;
+  fids.reserve(ids.size());
+
+  for (const auto id : ids) {
+    fids.emplace_back(id);
+  }
+
+  return mMetadataProvider->retrieveFileMDs(fids);
+}
+
 //------------------------------------------------------------------------------
 // Get the file metadata information for the given file id
 //------------------------------------------------------------------------------
@@ -209,6 +255,11 @@ QuarkFileMDSvc::updateStore(IFileMD* obj)
   if (obj->getContainerId() == 0) {
     pFlusher->sadd(constants::sOrphanFiles, stringify(obj->getId()));
   }
+
+  mCacheInvalidator->fileModified(obj->getIdentifier(),
+                                  ContainerIdentifier(obj->getContainerId()));
+  IFileMDChangeListener::Event e(obj, IFileMDChangeListener::Updated);
+  notifyListeners(&e);
 }
 
 //------------------------------------------------------------------------------
@@ -221,6 +272,8 @@ QuarkFileMDSvc::removeFile(IFileMD* obj)
   pFlusher->execute(RequestBuilder::deleteFileProto(FileIdentifier(
                       obj->getId())));
   pFlusher->srem(constants::sOrphanFiles, sid);
+  mCacheInvalidator->fileModified(obj->getIdentifier(),
+                                  ContainerIdentifier(obj->getContainerId()));
   IFileMDChangeListener::Event e(obj, IFileMDChangeListener::Deleted);
   notifyListeners(&e);
   obj->setDeleted();
@@ -36,6 +36,7 @@ EOSNSNAMESPACE_BEGIN
 class IQuotaStats;
 class MetadataFlusher;
 class MetadataProvider;
+class CacheInvalidator;
 
 //------------------------------------------------------------------------------
 //! FileMDSvc based on Redis
@@ -77,6 +78,13 @@ public:
   //----------------------------------------------------------------------------
   virtual folly::Future<IFileMDPtr> getFileMDFut(IFileMD::id_t id) override;
 
+  //----------------------------------------------------------------------------
+  //! Get the file metadata information for a batch of file IDs -
+  //! asynchronous API. Requests are grouped per metadata provider shard.
+  //----------------------------------------------------------------------------
+  virtual folly::Future<std::vector<folly::Try<IFileMDPtr>>>
+      getFileMDsFut(const std::vector<IFileMD::id_t>& ids) override;
+
   //----------------------------------------------------------------------------
   //! Get the file metadata information for the given file ID
   //!
@@ -189,6 +197,9 @@ private:
   std::atomic<uint64_t> mNumFiles; ///< Total number of fileso
   std::unique_ptr<MetadataProvider>
   mMetadataProvider; ///< Provides metadata from backend
+  //! Publishes or follows the cache invalidations, destroyed before the
+  //! metadata provider
+  std::unique_ptr<CacheInvalidator> mCacheInvalidator;
   UnifiedInodeProvider mUnifiedInodeProvider; ///< Provides next free inode
 };
 
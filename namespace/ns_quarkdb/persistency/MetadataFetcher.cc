@@ -21,6 +21,7 @@
 //! @brief Class to retrieve metadata from the backend - no caching!
 //------------------------------------------------------------------------------
 
+#include <algorithm>
 #include <functional>
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
@@ -89,6 +90,60 @@ struct MapFetcherContainerTrait {
 };
 
 
+//------------------------------------------------------------------------------
+//! Parse one page of a HSCAN reply over a file or container map
+//!
+//! @param reply redis reply
+//! @param cursor set to the cursor of the next page, "0" after the last one
+//! @param add called with the name and the id of every entry
+//------------------------------------------------------------------------------
+template<typename Adder>
+static MDStatus
+parseScanPage(redisReplyPtr& reply, std::string& cursor, Adder add)
+{
+  if (!reply) {
+    return MDStatus(EFAULT, "QuarkDB backend not available!");
+  }
+
+  if (reply->type != REDIS_REPLY_ARRAY || reply->elements != 2 ||
+      (reply->element[0]->type != REDIS_REPLY_STRING) ||
+      (reply->element[1]->type != REDIS_REPLY_ARRAY) ||
+      ((reply->element[1]->elements % 2) != 0)) {
+    return MDStatus(EFAULT, SSTR("Received unexpected response: "
+                                 << qclient::describeRedisReply(reply)));
+  }
+
+  cursor = std::string(reply->element[0]->str, reply->element[0]->len);
+
+  for (size_t i = 0; i < reply->element[1]->elements; i += 2) {
+    redisReply* element = reply->element[1]->element[i];
+
+    if (element->type != REDIS_REPLY_STRING) {
+      return MDStatus(EFAULT, SSTR("Received unexpected response: "
+                                   << qclient::describeRedisReply(reply)));
+    }
+
+    std::string filename = std::string(element->str, element->len);
+    element = reply->element[1]->element[i + 1];
+
+    if (element->type != REDIS_REPLY_STRING) {
+      return MDStatus(EFAULT, SSTR("Received unexpected response: "
+                                   << qclient::describeRedisReply(reply)));
+    }
+
+    int64_t value;
+    MDStatus st = Serialization::deserialize(element->str, element->len, value);
+
+    if (!st.ok()) {
+      return st;
+    }
+
+    add(std::move(filename), value);
+  }
+
+  return MDStatus();
+}
+
 //------------------------------------------------------------------------------
 //! Class MapFetcher - fetches maps (ContainerMap, FileMap) of a particular
 //! container.
@@ -101,8 +156,16 @@ public:
   static constexpr size_t kCount = 250000;
   //----------------------------------------------------------------------------
   //! Constructor
+  //!
+  //! @param max_num if non-zero and the map has more entries, the map is not
+  //!        fetched: the result is empty and num_entries is set to its size
+  //! @param num_entries see max_num
   //----------------------------------------------------------------------------
-  MapFetcher() = default;
+  MapFetcher(uint64_t max_num = 0,
+             std::shared_ptr<uint64_t> num_entries = nullptr):
+    mMaxNum(max_num), mNumEntries(num_entries),
+    mCount((max_num && (max_num < kCount)) ? max_num + 1 : kCount)
+  {}
 
   //----------------------------------------------------------------------------
   //! Initialize
@@ -124,7 +187,7 @@ public:
     // Not safe to access member variables after execCB, so we fetch the future
     // beforehand.
     mQcl->execCB(this, "HSCAN", Trait::getKey(mTarget.getUnderlyingUInt64()), "0",
-                 "COUNT", SSTR(kCount));
+                 "COUNT", SSTR(mCount));
     // fut is a stack object, safe to access.
     return fut;
   }
@@ -136,45 +199,26 @@ public:
   //----------------------------------------------------------------------------
   virtual void handleResponse(redisReplyPtr&& reply) override
   {
-    if (!reply) {
-      return set_exception(EFAULT, "QuarkDB backend not available!");
-    }
-
-    if (reply->type != REDIS_REPLY_ARRAY || reply->elements != 2 ||
-        (reply->element[0]->type != REDIS_REPLY_STRING) ||
-        (reply->element[1]->type != REDIS_REPLY_ARRAY) ||
-        ((reply->element[1]->elements % 2) != 0)) {
-      return set_exception(EFAULT, SSTR("Received unexpected response: "
-                                        << qclient::describeRedisReply(reply)));
-    }
-
-    std::string cursor = std::string(reply->element[0]->str,
-                                     reply->element[0]->len);
-
-    for (size_t i = 0; i < reply->element[1]->elements; i += 2) {
-      redisReply* element = reply->element[1]->element[i];
-
-      if (element->type != REDIS_REPLY_STRING) {
-        return set_exception(EFAULT, SSTR("Received unexpected response: "
-                                          << qclient::describeRedisReply(reply)));
-      }
-
-      std::string filename = std::string(element->str, element->len);
-      element = reply->element[1]->element[i + 1];
-
-      if (element->type != REDIS_REPLY_STRING) {
+    if (mCounting) {
+      if (!reply || (reply->type != REDIS_REPLY_INTEGER)) {
         return set_exception(EFAULT, SSTR("Received unexpected response: "
                                           << qclient::describeRedisReply(reply)));
       }
 
-      int64_t value;
-      MDStatus st = Serialization::deserialize(element->str, element->len, value);
+      *mNumEntries = std::max<uint64_t>(reply->integer, mMaxNum + 1);
+      mPromise.setValue(std::move(mContents));
+      delete this;
+      return;
+    }
 
-      if (!st.ok()) {
-        return set_exception(st);
-      }
+    std::string cursor;
+    MDStatus st = parseScanPage(reply, cursor,
+    [this](std::string && name, int64_t value) {
+      mContents[name] = value;
+    });
 
-      mContents[filename] = value;
+    if (!st.ok()) {
+      return set_exception(st);
     }
 
     // Fire off next request?
@@ -184,9 +228,17 @@ public:
       return;
     }
 
+    if (mMaxNum && (mContents.size() > mMaxNum)) {
+      // Too many entries to be loaded, only their number is needed
+      mContents.clear();
+      mCounting = true;
+      mQcl->execCB(this, "HLEN", Trait::getKey(mTarget.getUnderlyingUInt64()));
+      return;
+    }
+
     mQcl->execCB(this, "HSCAN", Trait::getKey(mTarget.getUnderlyingUInt64()),
                  cursor, "COUNT",
-                 SSTR(kCount));
+                 SSTR(mCount));
   }
 
 private:
@@ -218,6 +270,10 @@ private:
   ContainerIdentifier mTarget;
   ContainerType mContents;
   folly::Promise<ContainerType> mPromise;
+  uint64_t mMaxNum; ///< Max number of entries to load, 0 for no limit
+  std::shared_ptr<uint64_t> mNumEntries; ///< Number of entries if above limit
+  size_t mCount; ///< Number of entries requested per page
+  bool mCounting = false; ///< Waiting for the number of entries
 };
 
 //------------------------------------------------------------------------------
@@ -225,16 +281,26 @@ private:
 //------------------------------------------------------------------------------
 static eos::ns::FileMdProto
 parseFileMdProtoResponse(redisReplyPtr reply, FileIdentifier id)
+{
+  eos::ns::FileMdProto proto;
+  MetadataFetcher::parseFileMdProto(reply, id, proto);
+  return std::move(proto);
+}
+
+//------------------------------------------------------------------------------
+// Parse the reply holding a FileMD protobuf
+//------------------------------------------------------------------------------
+void
+MetadataFetcher::parseFileMdProto(redisReplyPtr& reply, FileIdentifier id,
+                                  eos::ns::FileMdProto& proto)
 {
   ensureStringReply(reply).throwIfNotOk(SSTR("Error while fetching FileMD #"
                                         << id.getUnderlyingUInt64()
                                         << " protobuf from QDB: "));
-  eos::ns::FileMdProto proto;
   Serialization::deserialize(reply->str, reply->len, proto)
   .throwIfNotOk(SSTR("Error while deserializing FileMD #"
                      << id.getUnderlyingUInt64()
                      << " protobuf: "));
-  return std::move(proto);
 }
 
 //------------------------------------------------------------------------------
@@ -347,6 +413,53 @@ MetadataFetcher::getSubContainers(qclient::QClient& qcl,
   return fetcher->initialize(qcl, container);
 }
 
+//------------------------------------------------------------------------------
+// Fetch all files for current id unless there are more than max_num
+//------------------------------------------------------------------------------
+folly::Future<MetadataFetcher::BoundedFileMap>
+MetadataFetcher::getFilesInContainerBounded(qclient::QClient& qcl,
+    ContainerIdentifier container, uint64_t max_num)
+{
+  std::shared_ptr<uint64_t> num_files = std::make_shared<uint64_t>(0);
+  MapFetcher<MapFetcherFileTrait>* fetcher =
+    new MapFetcher<MapFetcherFileTrait>(max_num, num_files);
+  return fetcher->initialize(qcl, container)
+  .then([num_files](IContainerMD::FileMap && files) {
+    BoundedFileMap result;
+    result.mFiles = std::move(files);
+    result.mNumFiles = *num_files;
+    return result;
+  });
+}
+
+//------------------------------------------------------------------------------
+// Parse a page of a file map scan, throw on error
+//------------------------------------------------------------------------------
+static MetadataFetcher::FileMapPage
+parseFileMapPage(redisReplyPtr reply, ContainerIdentifier id)
+{
+  MetadataFetcher::FileMapPage page;
+  parseScanPage(reply, page.mCursor,
+  [&page](std::string && name, int64_t value) {
+    page.mFiles.emplace_back(std::move(name), value);
+  }).throwIfNotOk(SSTR("Error while scanning the file map of container #"
+                       << id.getUnderlyingUInt64() << " in QDB: "));
+  return page;
+}
+
+//------------------------------------------------------------------------------
+// Fetch one page of the files of a container
+//------------------------------------------------------------------------------
+folly::Future<MetadataFetcher::FileMapPage>
+MetadataFetcher::getFilesPage(qclient::QClient& qcl,
+                              ContainerIdentifier container,
+                              const std::string& cursor, size_t count)
+{
+  return qcl.follyExec("HSCAN", keySubFiles(container.getUnderlyingUInt64()),
+                       cursor, "COUNT", SSTR(count))
+         .then(std::bind(parseFileMapPage, _1, container));
+}
+
 //------------------------------------------------------------------------------
 // Parse response when looking up a ContainerID / FileID from (parent id, name)
 //------------------------------------------------------------------------------
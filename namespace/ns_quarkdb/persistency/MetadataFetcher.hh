@@ -29,15 +29,10 @@
 #include "namespace/Namespace.hh"
 #include "proto/FileMd.pb.h"
 #include "proto/ContainerMd.pb.h"
+#include <qclient/QClient.hh>
 #include <future>
 #include <folly/futures/Future.h>
 
-//! Forward declaration
-namespace qclient
-{
-class QClient;
-}
-
 EOSNSNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
@@ -46,6 +41,22 @@ EOSNSNAMESPACE_BEGIN
 class MetadataFetcher
 {
 public:
+  //----------------------------------------------------------------------------
+  //! File map of a container, left empty if the container has too many files
+  //----------------------------------------------------------------------------
+  struct BoundedFileMap {
+    IContainerMD::FileMap mFiles; ///< Files, unless too many
+    uint64_t mNumFiles = 0; ///< Number of files if too many, otherwise 0
+  };
+
+  //----------------------------------------------------------------------------
+  //! One page of a file map scan
+  //----------------------------------------------------------------------------
+  struct FileMapPage {
+    std::string mCursor; ///< Cursor of the next page, "0" after the last one
+    IContainerMD::FilePage mFiles; ///< Files of the page
+  };
+
   //----------------------------------------------------------------------------
   //! Fetch file metadata info for current id
   //!
@@ -57,6 +68,16 @@ public:
   static folly::Future<eos::ns::FileMdProto>
   getFileFromId(qclient::QClient& qcl, FileIdentifier id);
 
+  //----------------------------------------------------------------------------
+  //! Parse the reply to RequestBuilder::readFileProto, throws on error
+  //!
+  //! @param reply reply from QuarkDB
+  //! @param id file id
+  //! @param proto output object, may live on an arena
+  //----------------------------------------------------------------------------
+  static void parseFileMdProto(qclient::redisReplyPtr& reply, FileIdentifier id,
+                               eos::ns::FileMdProto& proto);
+
   //----------------------------------------------------------------------------
   //! Fetch container metadata info for current id
   //!
@@ -90,6 +111,34 @@ public:
   static folly::Future<IContainerMD::FileMap>
   getFilesInContainer(qclient::QClient& qcl, ContainerIdentifier container);
 
+  //----------------------------------------------------------------------------
+  //! Fetch file map for a container id, unless it holds more than the given
+  //! number of files in which case only their number is retrieved
+  //!
+  //! @param qcl qclient object
+  //! @param id container id
+  //! @param max_num max number of files to load
+  //!
+  //! @return future holding the map of files or their number
+  //----------------------------------------------------------------------------
+  static folly::Future<BoundedFileMap>
+  getFilesInContainerBounded(qclient::QClient& qcl,
+                             ContainerIdentifier container, uint64_t max_num);
+
+  //----------------------------------------------------------------------------
+  //! Fetch one page of the file map of a container
+  //!
+  //! @param qcl qclient object
+  //! @param id container id
+  //! @param cursor scan cursor, "0" for the first page
+  //! @param count number of entries to request
+  //!
+  //! @return future holding the page and the cursor of the next one
+  //----------------------------------------------------------------------------
+  static folly::Future<FileMapPage>
+  getFilesPage(qclient::QClient& qcl, ContainerIdentifier container,
+               const std::string& cursor, size_t count);
+
   //----------------------------------------------------------------------------
   //! Fetch subcontainers map for a container id
   //!
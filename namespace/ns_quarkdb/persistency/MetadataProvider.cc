@@ -60,6 +60,73 @@ MetadataProvider::retrieveFileMD(FileIdentifier id)
   return pickShard(id)->retrieveFileMD(id);
 }
 
+//------------------------------------------------------------------------------
+// Retrieve a batch of ContainerMDs by ID.
+//------------------------------------------------------------------------------
+folly::Future<std::vector<folly::Try<IContainerMDPtr>>>
+    MetadataProvider::retrieveContainerMDs(const
+        std::vector<ContainerIdentifier>& ids)
+{
+  std::vector<std::vector<ContainerIdentifier>> shard_ids(kShards);
+
+  for (const auto& id : ids) {
+    shard_ids[id.getUnderlyingUInt64() % kShards].push_back(id);
+  }
+
+  std::vector<std::vector<folly::Future<IContainerMDPtr>>> shard_futs(kShards);
+
+  for (size_t i = 0; i < kShards; i++) {
+    if (!shard_ids[i].empty()) {
+      shard_futs[i] = mShards[i]->retrieveContainerMDs(shard_ids[i]);
+    }
+  }
+
+  // Put the results back in the order of the request
+  std::vector<size_t> cursor(kShards, 0);
+  std::vector<folly::Future<IContainerMDPtr>> futs;
+  futs.reserve(ids.size());
+
+  for (const auto& id : ids) {
+    size_t shard = id.getUnderlyingUInt64() % kShards;
+    futs.emplace_back(std::move(shard_futs[shard][cursor[shard]++]));
+  }
+
+  return folly::collectAll(futs.begin(), futs.end());
+}
+
+//------------------------------------------------------------------------------
+// Retrieve a batch of FileMDs by ID.
+//------------------------------------------------------------------------------
+folly::Future<std::vector<folly::Try<IFileMDPtr>>>
+    MetadataProvider::retrieveFileMDs(const std::vector<FileIdentifier>& ids)
+{
+  std::vector<std::vector<FileIdentifier>> shard_ids(kShards);
+
+  for (const auto& id : ids) {
+    shard_ids[id.getUnderlyingUInt64() % kShards].push_back(id);
+  }
+
+  std::vector<std::vector<folly::Future<IFileMDPtr>>> shard_futs(kShards);
+
+  for (size_t i = 0; i < kShards; i++) {
+    if (!shard_ids[i].empty()) {
+      shard_futs[i] = mShards[i]->retrieveFileMDs(shard_ids[i]);
+    }
+  }
+
+  // Put the results back in the order of the request
+  std::vector<size_t> cursor(kShards, 0);
+  std::vector<folly::Future<IFileMDPtr>> futs;
+  futs.reserve(ids.size());
+
+  for (const auto& id : ids) {
+    size_t shard = id.getUnderlyingUInt64() % kShards;
+    futs.emplace_back(std::move(shard_futs[shard][cursor[shard]++]));
+  }
+
+  return folly::collectAll(futs.begin(), futs.end());
+}
+
 //----------------------------------------------------------------------------
 // Check if a FileMD exists with the given id
 //----------------------------------------------------------------------------
@@ -110,6 +177,36 @@ void MetadataProvider::setContainerMDCacheNum(uint64_t max_num)
   }
 }
 
+//------------------------------------------------------------------------------
+// Change number of files above which a container does not load them.
+//------------------------------------------------------------------------------
+void MetadataProvider::setPagedFilesThreshold(uint64_t max_num)
+{
+  for(size_t i = 0; i < mShards.size(); i++) {
+    mShards[i]->setPagedFilesThreshold(max_num);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Change file cache eviction policy.
+//------------------------------------------------------------------------------
+void MetadataProvider::setFileMDCachePolicy(CachePolicy policy)
+{
+  for(size_t i = 0; i < mShards.size(); i++) {
+    mShards[i]->setFileMDCachePolicy(policy);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Change container cache eviction policy.
+//------------------------------------------------------------------------------
+void MetadataProvider::setContainerMDCachePolicy(CachePolicy policy)
+{
+  for(size_t i = 0; i < mShards.size(); i++) {
+    mShards[i]->setContainerMDCachePolicy(policy);
+  }
+}
+
 //------------------------------------------------------------------------------
 // Add a CacheStatistics object into another
 //------------------------------------------------------------------------------
@@ -149,6 +246,64 @@ CacheStatistics MetadataProvider::getContainerMDCacheStats()
   return globalStats;
 }
 
+//------------------------------------------------------------------------------
+// Get ids of the most recently used containers in the cache
+//------------------------------------------------------------------------------
+std::vector<ContainerIdentifier>
+MetadataProvider::getRecentContainerIds(uint64_t max_num)
+{
+  std::vector<ContainerIdentifier> ids;
+  uint64_t max_num_per_shard = (max_num + kShards - 1) / kShards;
+
+  for (size_t i = 0; i < mShards.size(); i++) {
+    std::vector<ContainerIdentifier> shard_ids =
+      mShards[i]->getRecentContainerIds(max_num_per_shard);
+    ids.insert(ids.end(), shard_ids.begin(), shard_ids.end());
+  }
+
+  return ids;
+}
+
+//------------------------------------------------------------------------------
+// Load the given containers into the cache
+//------------------------------------------------------------------------------
+folly::Future<folly::Unit>
+MetadataProvider::prefetchContainerMDs(const std::vector<ContainerIdentifier>&
+                                       ids)
+{
+  return retrieveContainerMDs(ids).then(
+  [](const std::vector<folly::Try<IContainerMDPtr>>&) {});
+}
+
+//------------------------------------------------------------------------------
+// Drop FileMD from the cache
+//------------------------------------------------------------------------------
+void
+MetadataProvider::dropFileMD(FileIdentifier id)
+{
+  pickShard(id)->dropFileMD(id);
+}
+
+//------------------------------------------------------------------------------
+// Drop ContainerMD from the cache
+//------------------------------------------------------------------------------
+void
+MetadataProvider::dropContainerMD(ContainerIdentifier id)
+{
+  pickShard(id)->dropContainerMD(id);
+}
+
+//------------------------------------------------------------------------------
+// Drop all the cached entries
+//------------------------------------------------------------------------------
+void
+MetadataProvider::dropAll()
+{
+  for (size_t i = 0; i < mShards.size(); i++) {
+    mShards[i]->dropAll();
+  }
+}
+
 //------------------------------------------------------------------------------
 //! Pick shard based on FileIdentifier
 //------------------------------------------------------------------------------
@@ -63,6 +63,29 @@ public:
   //----------------------------------------------------------------------------
   folly::Future<IFileMDPtr> retrieveFileMD(FileIdentifier id);
 
+  //----------------------------------------------------------------------------
+  //! Retrieve a batch of ContainerMDs by ID, grouped per shard like
+  //! retrieveFileMDs
+  //!
+  //! @param ids list of container identifiers
+  //!
+  //! @return future holding one result per requested id, in the same order
+  //----------------------------------------------------------------------------
+  folly::Future<std::vector<folly::Try<IContainerMDPtr>>>
+      retrieveContainerMDs(const std::vector<ContainerIdentifier>& ids);
+
+  //----------------------------------------------------------------------------
+  //! Retrieve a batch of FileMDs by ID. The lookups are grouped per shard
+  //! and the cache misses of each shard are pipelined to the backend in
+  //! one go.
+  //!
+  //! @param ids list of file identifiers
+  //!
+  //! @return future holding one result per requested id, in the same order
+  //----------------------------------------------------------------------------
+  folly::Future<std::vector<folly::Try<IFileMDPtr>>>
+      retrieveFileMDs(const std::vector<FileIdentifier>& ids);
+
   //----------------------------------------------------------------------------
   //! Check if a FileMD exists with the given id
   //----------------------------------------------------------------------------
@@ -88,6 +111,22 @@ public:
   //----------------------------------------------------------------------------
   void setContainerMDCacheNum(uint64_t max_num);
 
+  //----------------------------------------------------------------------------
+  //! Change number of files above which a container does not load its file
+  //! map, 0 to always load it
+  //----------------------------------------------------------------------------
+  void setPagedFilesThreshold(uint64_t max_num);
+
+  //----------------------------------------------------------------------------
+  //! Change file cache eviction policy
+  //----------------------------------------------------------------------------
+  void setFileMDCachePolicy(CachePolicy policy);
+
+  //----------------------------------------------------------------------------
+  //! Change container cache eviction policy
+  //----------------------------------------------------------------------------
+  void setContainerMDCachePolicy(CachePolicy policy);
+
   //----------------------------------------------------------------------------
   //! Get file cache statistics
   //----------------------------------------------------------------------------
@@ -98,6 +137,39 @@ public:
   //----------------------------------------------------------------------------
   CacheStatistics getContainerMDCacheStats();
 
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently used containers in the cache
+  //!
+  //! @param max_num maximum number of ids, spread evenly over the shards
+  //----------------------------------------------------------------------------
+  std::vector<ContainerIdentifier> getRecentContainerIds(uint64_t max_num);
+
+  //----------------------------------------------------------------------------
+  //! Load the given containers into the cache. The lookups are issued on all
+  //! the shard connections at once and missing containers are ignored.
+  //!
+  //! @param ids list of container identifiers
+  //!
+  //! @return future fulfilled once all the lookups finished
+  //----------------------------------------------------------------------------
+  folly::Future<folly::Unit>
+  prefetchContainerMDs(const std::vector<ContainerIdentifier>& ids);
+
+  //----------------------------------------------------------------------------
+  //! Drop FileMD from the cache
+  //----------------------------------------------------------------------------
+  void dropFileMD(FileIdentifier id);
+
+  //----------------------------------------------------------------------------
+  //! Drop ContainerMD from the cache
+  //----------------------------------------------------------------------------
+  void dropContainerMD(ContainerIdentifier id);
+
+  //----------------------------------------------------------------------------
+  //! Drop all the cached entries
+  //----------------------------------------------------------------------------
+  void dropAll();
+
 private:
   //----------------------------------------------------------------------------
   //! Pick shard based on FileIdentifier
@@ -28,6 +28,8 @@
 #include "namespace/ns_quarkdb/ContainerMD.hh"
 #include "namespace/MDException.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
+#include "namespace/ns_quarkdb/persistency/ProtoArena.hh"
+#include "namespace/ns_quarkdb/persistency/RequestBuilder.hh"
 #include "common/Assert.hh"
 #include <functional>
 
@@ -52,7 +54,42 @@ MetadataProviderShard::MetadataProviderShard(qclient::QClient *qcl,
 folly::Future<IContainerMDPtr>
 MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
 {
-  std::unique_lock<std::mutex> lock(mMutex);
+  // Fast path: entries present in the long-lived cache are never in-flight,
+  // so a cache hit can be served without taking the shard mutex.
+  IContainerMDPtr result = mContainerCache.get(id);
+
+  if (result) {
+    return makeContainerMDFuture(id, std::move(result));
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  return retrieveContainerMDLocked(id);
+}
+
+//------------------------------------------------------------------------------
+// Retrieve a batch of ContainerMDs by ID.
+//------------------------------------------------------------------------------
+std::vector<folly::Future<IContainerMDPtr>>
+MetadataProviderShard::retrieveContainerMDs(const
+    std::vector<ContainerIdentifier>& ids)
+{
+  std::vector<folly::Future<IContainerMDPtr>> futs;
+  futs.reserve(ids.size());
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (const auto& id : ids) {
+    futs.emplace_back(retrieveContainerMDLocked(id));
+  }
+
+  return futs;
+}
+
+//------------------------------------------------------------------------------
+// Retrieve ContainerMD by ID - must be called with mMutex locked
+//------------------------------------------------------------------------------
+folly::Future<IContainerMDPtr>
+MetadataProviderShard::retrieveContainerMDLocked(ContainerIdentifier id)
+{
   // A ContainerMD can be in three states: Not in cache, inside in-flight cache,
   // and cached. Is it inside in-flight cache?
   auto it = mInFlightContainers.find(id);
@@ -64,28 +101,22 @@ MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
     return it->second.getFuture();
   }
 
-  // Nope.. is it inside the long-lived cache?
+  // Nope.. is it inside the long-lived cache? It might have been inserted
+  // in the meantime.
   IContainerMDPtr result = mContainerCache.get(id);
 
   if (result) {
-    lock.unlock();
-
-    // Handle special case where we're dealing with a tombstone.
-    if (result->isDeleted()) {
-      return folly::makeFuture<IContainerMDPtr>
-             (make_mdexception(ENOENT, "Container #" << id.getUnderlyingUInt64()
-                               << " does not exist (found deletion tombstone)"));
-    }
-
-    return folly::makeFuture<IContainerMDPtr>(std::move(result));
+    return makeContainerMDFuture(id, std::move(result));
   }
 
   // Nope, need to fetch, and insert into the in-flight staging area. Merge
   // three asynchronous operations into one.
   folly::Future<eos::ns::ContainerMdProto> protoFut =
     MetadataFetcher::getContainerFromId(*mQcl, id);
-  folly::Future<IContainerMD::FileMap> fileMapFut =
-    MetadataFetcher::getFilesInContainer(*mQcl, id);
+  // Containers with too many files keep them in QuarkDB, see PagedFileMap
+  folly::Future<MetadataFetcher::BoundedFileMap> fileMapFut =
+    MetadataFetcher::getFilesInContainerBounded(*mQcl, id,
+        mPagedFilesThreshold.load());
   folly::Future<IContainerMD::ContainerMap> containerMapFut =
     MetadataFetcher::getSubContainers(*mQcl, id);
   folly::Future<IContainerMDPtr> fut =
@@ -109,7 +140,41 @@ MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
 folly::Future<IFileMDPtr>
 MetadataProviderShard::retrieveFileMD(FileIdentifier id)
 {
-  std::unique_lock<std::mutex> lock(mMutex);
+  // Fast path: entries present in the long-lived cache are never in-flight,
+  // so a cache hit can be served without taking the shard mutex.
+  IFileMDPtr result = mFileCache.get(id);
+
+  if (result) {
+    return makeFileMDFuture(id, std::move(result));
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  return retrieveFileMDLocked(id);
+}
+
+//------------------------------------------------------------------------------
+// Retrieve a batch of FileMDs by ID.
+//------------------------------------------------------------------------------
+std::vector<folly::Future<IFileMDPtr>>
+MetadataProviderShard::retrieveFileMDs(const std::vector<FileIdentifier>& ids)
+{
+  std::vector<folly::Future<IFileMDPtr>> futs;
+  futs.reserve(ids.size());
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (const auto& id : ids) {
+    futs.emplace_back(retrieveFileMDLocked(id));
+  }
+
+  return futs;
+}
+
+//------------------------------------------------------------------------------
+// Retrieve FileMD by ID - must be called with mMutex locked
+//------------------------------------------------------------------------------
+folly::Future<IFileMDPtr>
+MetadataProviderShard::retrieveFileMDLocked(FileIdentifier id)
+{
   // A FileMD can be in three states: Not in cache, inside in-flight cache,
   // and cached. Is it inside in-flight cache?
   auto it = mInFlightFiles.find(id);
@@ -121,26 +186,19 @@ MetadataProviderShard::retrieveFileMD(FileIdentifier id)
     return it->second.getFuture();
   }
 
-  // Nope.. is it inside the long-lived cache?
+  // Nope.. is it inside the long-lived cache? It might have been inserted
+  // in the meantime.
   IFileMDPtr result = mFileCache.get(id);
 
   if (result) {
-    lock.unlock();
-
-    // Handle special case where we're dealing with a tombstone.
-    if (result->isDeleted()) {
-      return folly::makeFuture<IFileMDPtr>
-             (make_mdexception(ENOENT, "File #" << id.getUnderlyingUInt64()
-                               << " does not exist (found deletion tombstone)"));
-    }
-
-    return folly::makeFuture<IFileMDPtr>(std::move(result));
+    return makeFileMDFuture(id, std::move(result));
   }
 
   // Nope, need to fetch, and insert into the in-flight staging area.
-  folly::Future<IFileMDPtr> fut = MetadataFetcher::getFileFromId(*mQcl, id)
+  // Parse the reply on the executor, not on the qclient event loop
+  folly::Future<IFileMDPtr> fut = mQcl->follyExec(RequestBuilder::readFileProto(id))
                                   .via(mExecutor)
-                                  .then(std::bind(&MetadataProviderShard::processIncomingFileMdProto, this, id, _1))
+                                  .then(std::bind(&MetadataProviderShard::processIncomingFileMdReply, this, id, _1))
   .onError([this, id](const folly::exception_wrapper & e) {
     // If the operation failed, clear the in-flight cache.
     std::lock_guard<std::mutex> lock(mMutex);
@@ -151,6 +209,39 @@ MetadataProviderShard::retrieveFileMD(FileIdentifier id)
   return mInFlightFiles[id].getFuture();
 }
 
+//------------------------------------------------------------------------------
+// Build ready future out of a cached ContainerMD, taking care of tombstones
+//------------------------------------------------------------------------------
+folly::Future<IContainerMDPtr>
+MetadataProviderShard::makeContainerMDFuture(ContainerIdentifier id,
+    IContainerMDPtr&& item)
+{
+  // Handle special case where we're dealing with a tombstone.
+  if (item->isDeleted()) {
+    return folly::makeFuture<IContainerMDPtr>
+           (make_mdexception(ENOENT, "Container #" << id.getUnderlyingUInt64()
+                             << " does not exist (found deletion tombstone)"));
+  }
+
+  return folly::makeFuture<IContainerMDPtr>(std::move(item));
+}
+
+//------------------------------------------------------------------------------
+// Build ready future out of a cached FileMD, taking care of tombstones
+//------------------------------------------------------------------------------
+folly::Future<IFileMDPtr>
+MetadataProviderShard::makeFileMDFuture(FileIdentifier id, IFileMDPtr&& item)
+{
+  // Handle special case where we're dealing with a tombstone.
+  if (item->isDeleted()) {
+    return folly::makeFuture<IFileMDPtr>
+           (make_mdexception(ENOENT, "File #" << id.getUnderlyingUInt64()
+                             << " does not exist (found deletion tombstone)"));
+  }
+
+  return folly::makeFuture<IFileMDPtr>(std::move(item));
+}
+
 //----------------------------------------------------------------------------
 // Check if a FileMD exists with the given id
 //----------------------------------------------------------------------------
@@ -199,6 +290,32 @@ void MetadataProviderShard::setContainerMDCacheNum(uint64_t max_num)
   mContainerCache.set_max_num(max_num);
 }
 
+//------------------------------------------------------------------------------
+// Change number of files above which a container does not load them.
+//------------------------------------------------------------------------------
+void MetadataProviderShard::setPagedFilesThreshold(uint64_t max_num)
+{
+  mPagedFilesThreshold = max_num;
+}
+
+//------------------------------------------------------------------------------
+// Change file cache eviction policy.
+//------------------------------------------------------------------------------
+void MetadataProviderShard::setFileMDCachePolicy(CachePolicy policy)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mFileCache.set_policy(policy);
+}
+
+//------------------------------------------------------------------------------
+// Change container cache eviction policy.
+//------------------------------------------------------------------------------
+void MetadataProviderShard::setContainerMDCachePolicy(CachePolicy policy)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mContainerCache.set_policy(policy);
+}
+
 //------------------------------------------------------------------------------
 // Turn a (ContainerMDProto, FileMap, ContainerMap) triplet into a
 // ContainerMDPtr, and insert into the cache.
@@ -207,21 +324,28 @@ IContainerMDPtr
 MetadataProviderShard::processIncomingContainerMD(ContainerIdentifier id,
     std::tuple <
     eos::ns::ContainerMdProto,
-    IContainerMD::FileMap,
+    MetadataFetcher::BoundedFileMap,
     IContainerMD::ContainerMap
     > tup)
 {
   std::lock_guard<std::mutex> lock(mMutex);
   // Unpack tuple. (sigh)
   eos::ns::ContainerMdProto& proto = std::get<0>(tup);
-  IContainerMD::FileMap& fileMap = std::get<1>(tup);
+  MetadataFetcher::BoundedFileMap& fileMap = std::get<1>(tup);
   IContainerMD::ContainerMap& containerMap = std::get<2>(tup);
   // Things look sane?
   eos_assert(proto.id() == id.getUnderlyingUInt64());
   // Yep, construct ContainerMD object..
   QuarkContainerMD* containerMD = new QuarkContainerMD(0, mFileSvc, mContSvc);
-  containerMD->initialize(std::move(proto), std::move(fileMap),
-                          std::move(containerMap));
+
+  if (fileMap.mNumFiles) {
+    containerMD->initializePagedFiles(std::move(proto), fileMap.mNumFiles,
+                                      std::move(containerMap));
+  } else {
+    containerMD->initialize(std::move(proto), std::move(fileMap.mFiles),
+                            std::move(containerMap));
+  }
+
   // Drop inFlightContainers future..
   auto it = mInFlightContainers.find(id);
   eos_assert(it != mInFlightContainers.end());
@@ -233,25 +357,32 @@ MetadataProviderShard::processIncomingContainerMD(ContainerIdentifier id,
 }
 
 //------------------------------------------------------------------------------
-// Turn an incoming FileMDProto into FileMD, removing from the inFlight
+// Parse an incoming FileMD reply into a FileMD, removing from the inFlight
 // staging area, and inserting into the cache.
 //------------------------------------------------------------------------------
 IFileMDPtr
-MetadataProviderShard::processIncomingFileMdProto(FileIdentifier id,
-    eos::ns::FileMdProto proto)
+MetadataProviderShard::processIncomingFileMdReply(FileIdentifier id,
+    qclient::redisReplyPtr reply)
 {
+  std::unique_ptr<QuarkFileMD> fileMD(new QuarkFileMD(0, mFileSvc));
+  {
+    // The protobuf object only lives until copied into the FileMD, keep all
+    // its allocations on a short-lived arena
+    ScopedProtoArena arena;
+    eos::ns::FileMdProto* proto = arena.create<eos::ns::FileMdProto>();
+    MetadataFetcher::parseFileMdProto(reply, id, *proto);
+    // Things look sane?
+    eos_assert(proto->id() == id.getUnderlyingUInt64());
+    // Yep, construct FileMD object..
+    fileMD->initialize(std::move(*proto));
+  }
   std::lock_guard<std::mutex> lock(mMutex);
-  // Things look sane?
-  eos_assert(proto.id() == id.getUnderlyingUInt64());
-  // Yep, construct FileMD object..
-  QuarkFileMD* fileMD = new QuarkFileMD(0, mFileSvc);
-  fileMD->initialize(std::move(proto));
   // Drop inFlightFiles future..
   auto it = mInFlightFiles.find(id);
   eos_assert(it != mInFlightFiles.end());
   mInFlightFiles.erase(it);
   // Insert into the cache ...
-  IFileMDPtr item { fileMD };
+  IFileMDPtr item { fileMD.release() };
   mFileCache.put(id, item);
   return item;
 }
@@ -286,4 +417,41 @@ CacheStatistics MetadataProviderShard::getContainerMDCacheStats()
   return stats;
 }
 
+//------------------------------------------------------------------------------
+// Get ids of the most recently used containers in the cache
+//------------------------------------------------------------------------------
+std::vector<ContainerIdentifier>
+MetadataProviderShard::getRecentContainerIds(uint64_t max_num)
+{
+  return mContainerCache.getMostRecent(max_num);
+}
+
+//------------------------------------------------------------------------------
+// Drop FileMD from the cache
+//------------------------------------------------------------------------------
+void
+MetadataProviderShard::dropFileMD(FileIdentifier id)
+{
+  (void) mFileCache.remove(id);
+}
+
+//------------------------------------------------------------------------------
+// Drop ContainerMD from the cache
+//------------------------------------------------------------------------------
+void
+MetadataProviderShard::dropContainerMD(ContainerIdentifier id)
+{
+  (void) mContainerCache.remove(id);
+}
+
+//------------------------------------------------------------------------------
+// Drop all the cached entries
+//------------------------------------------------------------------------------
+void
+MetadataProviderShard::dropAll()
+{
+  mFileCache.clear();
+  mContainerCache.clear();
+}
+
 EOSNSNAMESPACE_END
@@ -30,9 +30,11 @@
 #include "namespace/interface/Misc.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/ContainerMD.hh"
+#include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
 #include <qclient/QClient.hh>
 #include <folly/futures/Future.h>
 #include <folly/futures/FutureSplitter.h>
+#include <atomic>
 
 namespace folly
 {
@@ -67,6 +69,29 @@ public:
   //----------------------------------------------------------------------------
   folly::Future<IFileMDPtr> retrieveFileMD(FileIdentifier id);
 
+  //----------------------------------------------------------------------------
+  //! Retrieve a batch of ContainerMDs by ID, the shard mutex is taken only
+  //! once and all cache misses are pipelined to the backend
+  //!
+  //! @param ids list of container identifiers belonging to this shard
+  //!
+  //! @return one future per requested id, in the same order
+  //----------------------------------------------------------------------------
+  std::vector<folly::Future<IContainerMDPtr>>
+  retrieveContainerMDs(const std::vector<ContainerIdentifier>& ids);
+
+  //----------------------------------------------------------------------------
+  //! Retrieve a batch of FileMDs by ID. The shard mutex is taken only once
+  //! and all cache misses are sent to the backend back-to-back, so that they
+  //! are pipelined over the same connection.
+  //!
+  //! @param ids list of file identifiers belonging to this shard
+  //!
+  //! @return one future per requested id, in the same order
+  //----------------------------------------------------------------------------
+  std::vector<folly::Future<IFileMDPtr>>
+  retrieveFileMDs(const std::vector<FileIdentifier>& ids);
+
   //----------------------------------------------------------------------------
   //! Check if a FileMD exists with the given id
   //----------------------------------------------------------------------------
@@ -92,6 +117,22 @@ public:
   //----------------------------------------------------------------------------
   void setContainerMDCacheNum(uint64_t max_num);
 
+  //----------------------------------------------------------------------------
+  //! Change number of files above which a container does not load its file
+  //! map, 0 to always load it
+  //----------------------------------------------------------------------------
+  void setPagedFilesThreshold(uint64_t max_num);
+
+  //----------------------------------------------------------------------------
+  //! Change file cache eviction policy
+  //----------------------------------------------------------------------------
+  void setFileMDCachePolicy(CachePolicy policy);
+
+  //----------------------------------------------------------------------------
+  //! Change container cache eviction policy
+  //----------------------------------------------------------------------------
+  void setContainerMDCachePolicy(CachePolicy policy);
+
   //----------------------------------------------------------------------------
   //! Get file cache statistics
   //----------------------------------------------------------------------------
@@ -102,13 +143,57 @@ public:
   //----------------------------------------------------------------------------
   CacheStatistics getContainerMDCacheStats();
 
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently used containers in the cache
+  //----------------------------------------------------------------------------
+  std::vector<ContainerIdentifier> getRecentContainerIds(uint64_t max_num);
+
+  //----------------------------------------------------------------------------
+  //! Drop FileMD from the cache
+  //----------------------------------------------------------------------------
+  void dropFileMD(FileIdentifier id);
+
+  //----------------------------------------------------------------------------
+  //! Drop ContainerMD from the cache
+  //----------------------------------------------------------------------------
+  void dropContainerMD(ContainerIdentifier id);
+
+  //----------------------------------------------------------------------------
+  //! Drop all the cached entries
+  //----------------------------------------------------------------------------
+  void dropAll();
+
 private:
   //----------------------------------------------------------------------------
-  //! Turn an incoming FileMDProto into FileMD, removing from the inFlight
-  //! staging area, and inserting into the cache
+  //! Build ready future out of a cached ContainerMD, taking care of tombstones
+  //----------------------------------------------------------------------------
+  folly::Future<IContainerMDPtr>
+  makeContainerMDFuture(ContainerIdentifier id, IContainerMDPtr&& item);
+
+  //----------------------------------------------------------------------------
+  //! Build ready future out of a cached FileMD, taking care of tombstones
+  //----------------------------------------------------------------------------
+  folly::Future<IFileMDPtr>
+  makeFileMDFuture(FileIdentifier id, IFileMDPtr&& item);
+
+  //----------------------------------------------------------------------------
+  //! Retrieve ContainerMD by ID - must be called with mMutex locked
+  //----------------------------------------------------------------------------
+  folly::Future<IContainerMDPtr>
+  retrieveContainerMDLocked(ContainerIdentifier id);
+
+  //----------------------------------------------------------------------------
+  //! Retrieve FileMD by ID - must be called with mMutex locked
+  //----------------------------------------------------------------------------
+  folly::Future<IFileMDPtr> retrieveFileMDLocked(FileIdentifier id);
+
+  //----------------------------------------------------------------------------
+  //! Parse an incoming FileMD reply into a FileMD, removing from the
+  //! inFlight staging area, and inserting into the cache. The protobuf
+  //! object is allocated on a short-lived arena and parsed outside mMutex.
   //----------------------------------------------------------------------------
-  IFileMDPtr processIncomingFileMdProto(FileIdentifier id,
-                                        eos::ns::FileMdProto proto);
+  IFileMDPtr processIncomingFileMdReply(FileIdentifier id,
+                                        qclient::redisReplyPtr reply);
 
   //----------------------------------------------------------------------------
   //! Turn a (ContainerMDProto, FileMap, ContainerMap) triplet into a
@@ -117,7 +202,7 @@ private:
   IContainerMDPtr processIncomingContainerMD(ContainerIdentifier id,
       std::tuple <
       eos::ns::ContainerMdProto,
-      IContainerMD::FileMap,
+      MetadataFetcher::BoundedFileMap,
       IContainerMD::ContainerMap
       > tup);
 
@@ -131,6 +216,7 @@ private:
   LRU<ContainerIdentifier, IContainerMD> mContainerCache;
   LRU<FileIdentifier, IFileMD> mFileCache;
   folly::Executor *mExecutor; // no ownership
+  std::atomic<uint64_t> mPagedFilesThreshold {0}; ///< 0 means always load
 };
 
 EOSNSNAMESPACE_END
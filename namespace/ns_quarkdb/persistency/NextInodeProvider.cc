@@ -20,6 +20,7 @@
 #include "namespace/ns_quarkdb/persistency/NextInodeProvider.hh"
 #include "namespace/interface/IFileMD.hh"
 #include "qclient/QHash.hh"
+#include <algorithm>
 #include <memory>
 #include <numeric>
 
@@ -29,29 +30,50 @@ EOSNSNAMESPACE_BEGIN
 // Constructor
 //------------------------------------------------------------------------------
 NextInodeProvider::NextInodeProvider()
-  : pHash(nullptr), pField(""), mNextId(0), mBlockEnd(-1), mStepIncrease(1)
+  : pHash(nullptr), pField(""), mNextId(0), mBlockEnd(-1), mPrefetchId(-1),
+    mStepIncrease(1), mLastRequestId(-1), mInFlightStep(0), mPendingStart(-1),
+    mPendingEnd(-1)
 {
 }
 
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+NextInodeProvider::~NextInodeProvider()
+{
+  std::lock_guard<std::mutex> lock(mMtx);
+
+  if (mInFlight.valid()) {
+    mInFlight.wait();
+  }
+}
+
 //------------------------------------------------------------------------------
 // Get first free id
 //------------------------------------------------------------------------------
 int64_t NextInodeProvider::getFirstFreeId()
 {
   std::lock_guard<std::mutex> lock(mMtx);
+  int64_t next = mNextId.load();
 
-  if (mBlockEnd < mNextId) {
-    IFileMD::id_t id = 0;
-    std::string sval = pHash->hget(pField);
+  if (next <= mBlockEnd.load()) {
+    return next;
+  }
 
-    if (!sval.empty()) {
-      id = std::stoull(sval);
-    }
+  collectLocked();
 
-    return id + 1;
+  if (mPendingStart >= 0) {
+    return mPendingStart;
   }
 
-  return mNextId;
+  IFileMD::id_t id = 0;
+  std::string sval = pHash->hget(pField);
+
+  if (!sval.empty()) {
+    id = std::stoull(sval);
+  }
+
+  return id + 1;
 }
 
 //------------------------------------------------------------------------------
@@ -59,23 +81,120 @@ int64_t NextInodeProvider::getFirstFreeId()
 // To obtain the next free one, we increment that counter and return its value.
 // We reserve inodes by blocks to avoid roundtrips to the db, increasing the
 // block-size slowly up to 5000 so as to avoid wasting lots of inodes if the MGM
-// is unstable and restarts often.
+// is unstable and restarts often - unless the allocation rate asks for more.
 //------------------------------------------------------------------------------
 int64_t NextInodeProvider::reserve()
+{
+  while (true) {
+    int64_t id = tryReserve();
+
+    if (id >= 0) {
+      return id;
+    }
+
+    refill();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Take an id from the current block without locking
+//------------------------------------------------------------------------------
+int64_t NextInodeProvider::tryReserve()
+{
+  int64_t id = mNextId.load();
+
+  // mNextId never goes past mBlockEnd + 1, it only jumps under mMtx when a new
+  // block is installed - a stale id then simply fails the exchange.
+  while (id <= mBlockEnd.load()) {
+    if (mNextId.compare_exchange_weak(id, id + 1)) {
+      if (id == mPrefetchId.load()) {
+        std::lock_guard<std::mutex> lock(mMtx);
+        prefetchLocked();
+      }
+
+      return id;
+    }
+  }
+
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+// Switch to the next block if the current one is used up
+//------------------------------------------------------------------------------
+void NextInodeProvider::refill()
 {
   std::lock_guard<std::mutex> lock(mMtx);
 
-  if (mBlockEnd < mNextId) {
-    mBlockEnd = pHash->hincrby(pField, mStepIncrease);
-    mNextId = mBlockEnd - mStepIncrease + 1;
+  if (mNextId.load() <= mBlockEnd.load()) {
+    return; // another thread was faster
+  }
+
+  if (mPendingStart < 0) {
+    prefetchLocked();
+    collectLocked();
+  }
+
+  int64_t start = mPendingStart;
+  int64_t end = mPendingEnd;
+  mPendingStart = -1;
+  // Publish the block end last, ids of the new block can only be taken once
+  // it is visible.
+  mPrefetchId.store(start + (end - start) / 2);
+  mNextId.store(start);
+  mBlockEnd.store(end);
+}
+
+//------------------------------------------------------------------------------
+// Start reserving the next block in the background
+//------------------------------------------------------------------------------
+void NextInodeProvider::prefetchLocked()
+{
+  if (mInFlight.valid() || (mPendingStart >= 0)) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  int64_t next = mNextId.load();
+  int64_t step = mStepIncrease;
+
+  if (mLastRequestId >= 0) {
+    double elapsed = std::chrono::duration<double>(now - mLastRequest).count();
 
-    // Increase step for next round
-    if (mStepIncrease <= 5000) {
-      mStepIncrease++;
+    if (elapsed > 0) {
+      double wanted = (next - mLastRequestId) / elapsed * kBlockSeconds;
+      step = std::max(step, (int64_t) std::min(wanted, (double) kMaxStep));
     }
   }
 
-  return mNextId++;
+  // Increase step for next round
+  if (mStepIncrease <= 5000) {
+    mStepIncrease++;
+  }
+
+  mLastRequest = now;
+  mLastRequestId = next;
+  mInFlightStep = step;
+  qclient::QHash* hash = pHash;
+  std::string field = pField;
+  mInFlight = std::async(std::launch::async, [hash, field, step]() -> int64_t {
+    return hash->hincrby(field, step);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Wait for the reservation in flight and record it as the next block
+//------------------------------------------------------------------------------
+void NextInodeProvider::collectLocked()
+{
+  if (!mInFlight.valid()) {
+    return;
+  }
+
+  // The future is released even if get() throws, the next call retries
+  int64_t end = mInFlight.get();
+  mPendingStart = end - mInFlightStep + 1;
+  mPendingEnd = end;
 }
 
 //------------------------------------------------------------------------------
@@ -23,7 +23,11 @@
 
 #pragma once
 #include "namespace/Namespace.hh"
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <mutex>
+#include <string>
 
 namespace qclient {
   class QHash;
@@ -33,6 +37,13 @@ EOSNSNAMESPACE_BEGIN
 
 //------------------------------------------------------------------------------
 //! Class NextInodeProvider
+//!
+//! Ids are handed out from a block reserved in QuarkDB. Taking an id from the
+//! current block is a compare-and-swap, the mutex is only taken to switch
+//! blocks. Once half of the current block is used, the next one is reserved
+//! in the background so that creators only wait for QuarkDB if they drain a
+//! block faster than the round trip. The block size follows the allocation
+//! rate to last about kBlockSeconds, within [mStepIncrease, kMaxStep].
 //------------------------------------------------------------------------------
 class NextInodeProvider
 {
@@ -43,6 +54,11 @@ public:
   //----------------------------------------------------------------------------
   NextInodeProvider();
 
+  //----------------------------------------------------------------------------
+  //! Destructor - waits for a reservation in flight
+  //----------------------------------------------------------------------------
+  ~NextInodeProvider();
+
   //----------------------------------------------------------------------------
   //! Configuration method
   //!
@@ -62,12 +78,50 @@ public:
   int64_t reserve();
 
 private:
-  std::mutex mMtx;
+  //! Maximum block size, bounds the ids lost when the MGM restarts
+  static constexpr int64_t kMaxStep = 50000;
+  //! Time a block should last at the recent allocation rate
+  static constexpr double kBlockSeconds = 1.0;
+
+  //----------------------------------------------------------------------------
+  //! Take an id from the current block without locking
+  //!
+  //! @return id or -1 if the block is used up
+  //----------------------------------------------------------------------------
+  int64_t tryReserve();
+
+  //----------------------------------------------------------------------------
+  //! Switch to the next block if the current one is used up
+  //----------------------------------------------------------------------------
+  void refill();
+
+  //----------------------------------------------------------------------------
+  //! Start reserving the next block in the background, if not done yet.
+  //! Requires mMtx.
+  //----------------------------------------------------------------------------
+  void prefetchLocked();
+
+  //----------------------------------------------------------------------------
+  //! Wait for the reservation in flight, if any, and record it as the next
+  //! block. Requires mMtx.
+  //!
+  //! @throws the exception of the failed reservation
+  //----------------------------------------------------------------------------
+  void collectLocked();
+
+  std::mutex mMtx; ///< Protects everything but the atomics
   qclient::QHash* pHash; ///< qclient hash - no ownership
   std::string pField;
-  int64_t mNextId;
-  int64_t mBlockEnd;
-  int64_t mStepIncrease;
+  std::atomic<int64_t> mNextId; ///< Next id to hand out
+  std::atomic<int64_t> mBlockEnd; ///< Last id of the current block
+  std::atomic<int64_t> mPrefetchId; ///< Id whose reservation prefetches
+  int64_t mStepIncrease; ///< Minimum block size, ramping up to 5000
+  int64_t mLastRequestId; ///< mNextId at the last request, -1 if none
+  std::chrono::steady_clock::time_point mLastRequest; ///< Time of the request
+  std::future<int64_t> mInFlight; ///< Reservation in flight, new counter value
+  int64_t mInFlightStep; ///< Size of the block in flight
+  int64_t mPendingStart; ///< First id of the next block, -1 if none
+  int64_t mPendingEnd; ///< Last id of the next block
 };
 
 EOSNSNAMESPACE_END
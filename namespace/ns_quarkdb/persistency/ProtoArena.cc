@@ -0,0 +1,88 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/persistency/ProtoArena.hh"
+#include <memory>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+constexpr size_t ScopedProtoArena::sBlockSize;
+constexpr size_t ScopedProtoArena::sMaxPooledBlocks;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Pool of initial arena blocks of the current thread
+//------------------------------------------------------------------------------
+std::vector<std::unique_ptr<char[]>>& getBlockPool()
+{
+  static thread_local std::vector<std::unique_ptr<char[]>> pool;
+  return pool;
+}
+}
+
+//------------------------------------------------------------------------------
+// Take a block from the pool of the thread, or allocate a new one
+//------------------------------------------------------------------------------
+ScopedProtoArena::Block::Block()
+{
+  auto& pool = getBlockPool();
+
+  if (pool.empty()) {
+    mData = new char[sBlockSize];
+  } else {
+    mData = pool.back().release();
+    pool.pop_back();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Give the block back to the pool of the thread
+//------------------------------------------------------------------------------
+ScopedProtoArena::Block::~Block()
+{
+  auto& pool = getBlockPool();
+
+  if (pool.size() < sMaxPooledBlocks) {
+    pool.emplace_back(mData);
+  } else {
+    delete[] mData;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ScopedProtoArena::ScopedProtoArena():
+  mArena(makeOptions(mBlock.mData))
+{}
+
+//------------------------------------------------------------------------------
+// Build the arena options using the given initial block
+//------------------------------------------------------------------------------
+google::protobuf::ArenaOptions
+ScopedProtoArena::makeOptions(char* block)
+{
+  google::protobuf::ArenaOptions options;
+  options.initial_block = block;
+  options.initial_block_size = sBlockSize;
+  return options;
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,100 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Short-lived protobuf arena for the deserialization of metadata
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <google/protobuf/arena.h>
+#include <cstddef>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class ScopedProtoArena
+//!
+//! Protobuf arena meant for the messages which only live while their contents
+//! are copied into the in-memory metadata objects. All the sub-objects of the
+//! messages (strings, repeated fields, maps) are bump allocated from one
+//! block and released together when the arena goes out of scope, instead of
+//! one malloc/free pair each.
+//!
+//! The initial block is taken from a small per-thread pool and returned to it
+//! afterwards, so that in the steady state parsing a message does no heap
+//! allocation at all. Messages larger than the block spill over into blocks
+//! allocated by the arena itself.
+//------------------------------------------------------------------------------
+class ScopedProtoArena
+{
+public:
+  //! Size of the initial block, fits a file with a handful of attributes
+  static constexpr size_t sBlockSize = 16 * 1024;
+  //! Max number of blocks kept in the pool of each thread
+  static constexpr size_t sMaxPooledBlocks = 4;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  ScopedProtoArena();
+
+  ScopedProtoArena(const ScopedProtoArena&) = delete;
+  ScopedProtoArena& operator=(const ScopedProtoArena&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Create a message on the arena, destroyed together with the arena
+  //----------------------------------------------------------------------------
+  template <typename T>
+  T* create()
+  {
+    return google::protobuf::Arena::CreateMessage<T>(&mArena);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of bytes handed out by the arena so far
+  //----------------------------------------------------------------------------
+  inline size_t getSpaceUsed() const
+  {
+    return mArena.SpaceUsed();
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Initial block of the arena, returned to the pool of the thread once the
+  //! arena, declared after it, is destroyed
+  //----------------------------------------------------------------------------
+  class Block
+  {
+  public:
+    Block();
+    ~Block();
+
+    char* mData;
+  };
+
+  Block mBlock;
+  google::protobuf::Arena mArena;
+
+  //----------------------------------------------------------------------------
+  //! Build the arena options using the given initial block
+  //----------------------------------------------------------------------------
+  static google::protobuf::ArenaOptions makeOptions(char* block);
+};
+
+EOSNSNAMESPACE_END
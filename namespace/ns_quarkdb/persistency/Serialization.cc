@@ -31,29 +31,49 @@
 
 EOSNSNAMESPACE_BEGIN
 
-MDStatus
-Serialization::deserializeNoThrow(const Buffer& buffer, eos::ns::FileMdProto &proto)
+namespace
+{
+//------------------------------------------------------------------------------
+// Verify the checksum header of a serialized object and locate the payload
+//------------------------------------------------------------------------------
+bool
+locatePayload(const char*& ptr, size_t len, uint32_t& obj_size)
 {
   uint32_t cksum_expected = 0;
-  uint32_t obj_size = 0;
   size_t sz = sizeof(cksum_expected);
-  const char* ptr = buffer.getDataPtr();
+
+  if (len < 2 * sz) {
+    return false;
+  }
+
   (void) memcpy(&cksum_expected, ptr, sz);
   ptr += sz;
   (void) memcpy(&obj_size, ptr, sz);
-  size_t msg_size = buffer.getSize();
-  uint32_t align_size = msg_size - 2 * sz;
   ptr += sz; // now pointing to the serialized object
+  uint32_t align_size = len - 2 * sz;
+
+  if (obj_size > align_size) {
+    return false;
+  }
+
   uint32_t cksum_computed = DataHelper::computeCRC32C((void*)ptr, align_size);
   cksum_computed = DataHelper::finalizeCRC32C(cksum_computed);
+  return (cksum_expected == cksum_computed);
+}
+}
 
-  if (cksum_expected != cksum_computed) {
+MDStatus
+Serialization::deserializeNoThrow(const char* ptr, size_t len,
+                                  eos::ns::FileMdProto& proto)
+{
+  uint32_t obj_size = 0;
+
+  if (!locatePayload(ptr, len, obj_size)) {
     return MDStatus(EIO, "FileMD object checksum mismatch");
   }
 
-  google::protobuf::io::ArrayInputStream ais(ptr, obj_size);
-
-  if (!proto.ParseFromZeroCopyStream(&ais)) {
+  // Parse straight from the reply buffer, no intermediate copy
+  if (!proto.ParseFromArray(ptr, obj_size)) {
     return MDStatus(EIO, "Failed while deserializing FileMD buffer");
   }
 
@@ -61,28 +81,16 @@ Serialization::deserializeNoThrow(const Buffer& buffer, eos::ns::FileMdProto &pr
 }
 
 MDStatus
-Serialization::deserializeNoThrow(const Buffer& buffer, eos::ns::ContainerMdProto &proto)
+Serialization::deserializeNoThrow(const char* ptr, size_t len,
+                                  eos::ns::ContainerMdProto& proto)
 {
-  uint32_t cksum_expected = 0;
   uint32_t obj_size = 0;
-  size_t sz = sizeof(cksum_expected);
-  const char* ptr = buffer.getDataPtr();
-  (void) memcpy(&cksum_expected, ptr, sz);
-  ptr += sz;
-  (void) memcpy(&obj_size, ptr, sz);
-  size_t msg_size = buffer.getSize();
-  uint32_t align_size = msg_size - 2 * sz;
-  ptr += sz; // now pointing to the serialized object
-  uint32_t cksum_computed = DataHelper::computeCRC32C((void*)ptr, align_size);
-  cksum_computed = DataHelper::finalizeCRC32C(cksum_computed);
 
-  if (cksum_expected != cksum_computed) {
+  if (!locatePayload(ptr, len, obj_size)) {
     return MDStatus(EIO, "ContainerMD object checksum mismatch");
   }
 
-  google::protobuf::io::ArrayInputStream ais(ptr, obj_size);
-
-  if (!proto.ParseFromZeroCopyStream(&ais)) {
+  if (!proto.ParseFromArray(ptr, obj_size)) {
     return MDStatus(EIO, "Failed while deserializing ContainerMD buffer");
   }
 
@@ -90,9 +98,10 @@ Serialization::deserializeNoThrow(const Buffer& buffer, eos::ns::ContainerMdProt
 }
 
 MDStatus
-Serialization::deserializeNoThrow(const Buffer& buffer, int64_t &ret) {
+Serialization::deserializeNoThrow(const char* ptr, size_t len, int64_t& ret)
+{
   // Ensure there's a terminating null byte for strtoll.. :(
-  std::string str(buffer.getDataPtr(), buffer.getSize());
+  std::string str(ptr, len);
 
   char *endptr = NULL;
   ret = strtoll(str.c_str(), &endptr, 10);
@@ -102,7 +111,22 @@ Serialization::deserializeNoThrow(const Buffer& buffer, int64_t &ret) {
   return {};
 }
 
+MDStatus
+Serialization::deserializeNoThrow(const Buffer& buffer, eos::ns::FileMdProto &proto)
+{
+  return deserializeNoThrow(buffer.getDataPtr(), buffer.getSize(), proto);
+}
+
+MDStatus
+Serialization::deserializeNoThrow(const Buffer& buffer, eos::ns::ContainerMdProto &proto)
+{
+  return deserializeNoThrow(buffer.getDataPtr(), buffer.getSize(), proto);
+}
 
+MDStatus
+Serialization::deserializeNoThrow(const Buffer& buffer, int64_t &ret) {
+  return deserializeNoThrow(buffer.getDataPtr(), buffer.getSize(), ret);
+}
 
 void Serialization::deserializeFile(const Buffer& buffer, eos::ns::FileMdProto &proto) {
   MDStatus status = deserializeNoThrow(buffer, proto);
@@ -64,16 +64,23 @@ public:
   //----------------------------------------------------------------------------
   static MDStatus deserializeNoThrow(const Buffer& buffer, int64_t& val);
 
+  //----------------------------------------------------------------------------
+  //! Deserialize from a raw buffer, e.g. a redis reply, without copying it
+  //----------------------------------------------------------------------------
+  static MDStatus deserializeNoThrow(const char* ptr, size_t len,
+                                     eos::ns::FileMdProto& proto);
+  static MDStatus deserializeNoThrow(const char* ptr, size_t len,
+                                     eos::ns::ContainerMdProto& proto);
+  static MDStatus deserializeNoThrow(const char* ptr, size_t len, int64_t& val);
+
   //----------------------------------------------------------------------------
   //! Deserialize any supported type.
   //----------------------------------------------------------------------------
   template<typename T>
   static MDStatus deserialize(const char* str, size_t len, T& output)
   {
-    eos::Buffer ebuff;
-    ebuff.putData(str, len);
     // Dispatch to appropriate overload
-    return Serialization::deserializeNoThrow(ebuff, output);
+    return Serialization::deserializeNoThrow(str, len, output);
   }
 };
 
@@ -125,3 +125,23 @@ TEST_F(ContainerMDSvcF, BasicSanity)
   mdFlusher()->synchronize();
   ASSERT_EQ((uint64_t)0, containerSvc()->getNumContainers());
 }
+
+TEST_F(ContainerMDSvcF, ChildrenVersion)
+{
+  std::shared_ptr<eos::IContainerMD> parent = containerSvc()->createContainer();
+  std::shared_ptr<eos::IContainerMD> child = containerSvc()->createContainer();
+  parent->setName("parent");
+  child->setName("child");
+  uint64_t version = parent->getChildrenVersion();
+  parent->addContainer(child.get());
+  ASSERT_NE(version, parent->getChildrenVersion());
+  version = parent->getChildrenVersion();
+  // Only the changes of the children change the version
+  parent->setAttribute("key", "value");
+  ASSERT_EQ(version, parent->getChildrenVersion());
+  parent->removeContainer("child");
+  ASSERT_NE(version, parent->getChildrenVersion());
+  containerSvc()->removeContainer(child.get());
+  containerSvc()->removeContainer(parent.get());
+  mdFlusher()->synchronize();
+}
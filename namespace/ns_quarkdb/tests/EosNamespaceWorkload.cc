@@ -0,0 +1,783 @@
+//------------------------------------------------------------------------------
+//! @file EosNamespaceWorkload.cc
+//! @brief Benchmark replaying a configurable mix of namespace operations
+//!        against the QuarkDB namespace
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/LinuxMemConsumption.hh"
+#include "common/RWMutex.hh"
+#include "namespace/interface/ContainerIterators.hh"
+#include "namespace/ns_quarkdb/Constants.hh"
+#include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
+#include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
+#include "namespace/ns_quarkdb/views/HierarchicalView.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Benchmarked operations
+//------------------------------------------------------------------------------
+enum Op { kStat = 0, kLookup, kMkdir, kCreate, kRename, kUnlink, kList,
+          kNumOps
+        };
+
+static const char* sOpNames[kNumOps] = {
+  "stat", "lookup", "mkdir", "create", "rename", "unlink", "list"
+};
+
+//------------------------------------------------------------------------------
+//! Benchmark configuration
+//------------------------------------------------------------------------------
+struct Options {
+  std::map<std::string, std::string> mNsConfig;
+  std::string mPrefix {"/eos/nsworkload"};
+  std::string mMix {"stat:40,lookup:25,list:10,create:10,rename:5,unlink:5,"
+                    "mkdir:5"};
+  std::vector<double> mWeights;
+  size_t mThreads {8};
+  size_t mOps {10000}; ///< operations per thread, 0 means unlimited
+  size_t mDuration {0}; ///< max duration in seconds, 0 means unlimited
+  size_t mDepth {2};
+  size_t mFanout {16};
+  size_t mFilesPerDir {100};
+  bool mReuse {false}; ///< the tree exists already, skip the setup
+  bool mLock {true}; ///< serialize like the MGM namespace lock
+  uint64_t mSeed {0};
+  std::string mOutput; ///< JSON output file, stdout if empty
+};
+
+//------------------------------------------------------------------------------
+//! Per thread results
+//------------------------------------------------------------------------------
+struct Result {
+  std::vector<uint64_t> mLatency[kNumOps]; ///< nanoseconds
+  uint64_t mErrors[kNumOps] = {0};
+};
+
+eos::common::RWMutex nslock;
+
+//------------------------------------------------------------------------------
+// File size mapping function
+//------------------------------------------------------------------------------
+static uint64_t
+mapSize(const eos::IFileMD* /*file*/)
+{
+  return 0u;
+}
+
+//------------------------------------------------------------------------------
+// Boot the namespace
+//------------------------------------------------------------------------------
+static eos::IView*
+bootNamespace(const std::map<std::string, std::string>& config)
+{
+  eos::IContainerMDSvc* contSvc = new eos::QuarkContainerMDSvc();
+  eos::IFileMDSvc* fileSvc = new eos::QuarkFileMDSvc();
+  eos::IView* view = new eos::QuarkHierarchicalView();
+  fileSvc->setContMDService(contSvc);
+  contSvc->setFileMDService(fileSvc);
+  fileSvc->configure(config);
+  contSvc->configure(config);
+  view->setContainerMDSvc(contSvc);
+  view->setFileMDSvc(fileSvc);
+  view->configure(config);
+  view->getQuotaStats()->registerSizeMapper(mapSize);
+  view->initialize();
+  return view;
+}
+
+//------------------------------------------------------------------------------
+// Close the namespace, flushing all pending updates
+//------------------------------------------------------------------------------
+static void
+closeNamespace(eos::IView* view)
+{
+  eos::IContainerMDSvc* contSvc = view->getContainerMDSvc();
+  eos::IFileMDSvc* fileSvc = view->getFileMDSvc();
+  view->finalize();
+  delete view;
+  delete contSvc;
+  delete fileSvc;
+}
+
+//------------------------------------------------------------------------------
+// Path of a leaf directory of the tree
+//------------------------------------------------------------------------------
+static std::string
+leafPath(const Options& opts, size_t leaf)
+{
+  std::string path = opts.mPrefix + "/tree";
+  std::vector<size_t> digits(opts.mDepth);
+
+  for (size_t level = opts.mDepth; level > 0; --level) {
+    digits[level - 1] = leaf % opts.mFanout;
+    leaf /= opts.mFanout;
+  }
+
+  char name[32];
+
+  for (auto digit : digits) {
+    snprintf(name, sizeof(name), "/d%06zu", digit);
+    path += name;
+  }
+
+  return path;
+}
+
+//------------------------------------------------------------------------------
+// Path of a file of the tree
+//------------------------------------------------------------------------------
+static std::string
+filePath(const Options& opts, size_t leaf, size_t file)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "/f%08zu", file);
+  return leafPath(opts, leaf) + name;
+}
+
+//------------------------------------------------------------------------------
+// Number of leaf directories of the tree
+//------------------------------------------------------------------------------
+static size_t
+numLeaves(const Options& opts)
+{
+  size_t n = 1;
+
+  for (size_t level = 0; level < opts.mDepth; ++level) {
+    n *= opts.mFanout;
+  }
+
+  return n;
+}
+
+//------------------------------------------------------------------------------
+// Parse the operation mix e.g. "stat:50,create:50"
+//------------------------------------------------------------------------------
+static bool
+parseMix(const std::string& mix, std::vector<double>& weights)
+{
+  weights.assign(kNumOps, 0.0);
+  std::istringstream iss(mix);
+  std::string item;
+  double sum = 0;
+
+  while (std::getline(iss, item, ',')) {
+    size_t pos = item.find(':');
+
+    if (pos == std::string::npos) {
+      return false;
+    }
+
+    std::string name = item.substr(0, pos);
+    auto it = std::find_if(std::begin(sOpNames), std::end(sOpNames),
+    [&](const char* op) {
+      return name == op;
+    });
+
+    if (it == std::end(sOpNames)) {
+      return false;
+    }
+
+    try {
+      weights[it - std::begin(sOpNames)] = std::stod(item.substr(pos + 1));
+    } catch (...) {
+      return false;
+    }
+
+    sum += weights[it - std::begin(sOpNames)];
+  }
+
+  return (sum > 0);
+}
+
+//------------------------------------------------------------------------------
+// Create the directory tree and its files
+//------------------------------------------------------------------------------
+static void
+setupTree(eos::IView* view, const Options& opts, size_t& ncontainers,
+          size_t& nfiles)
+{
+  size_t leaves = numLeaves(opts);
+
+  for (size_t leaf = 0; leaf < leaves; ++leaf) {
+    std::shared_ptr<eos::IContainerMD> cont =
+      view->createContainer(leafPath(opts, leaf), true);
+    cont->setAttribute("sys.forced.checksum", "adler");
+    cont->setAttribute("sys.forced.layout", "replica");
+    cont->setAttribute("sys.forced.nstripes", "2");
+    view->updateContainerStore(cont.get());
+    ++ncontainers;
+
+    for (size_t n = 0; n < opts.mFilesPerDir; ++n) {
+      std::shared_ptr<eos::IFileMD> fmd =
+        view->createFile(filePath(opts, leaf, n), 0, 0);
+      fmd->setLayoutId(10);
+      fmd->setSize(n * 1024);
+      view->updateFileStore(fmd.get());
+      ++nfiles;
+    }
+
+    if ((leaf + 1) % 1000 == 0) {
+      std::cerr << "[i] Created " << leaf + 1 << "/" << leaves
+                << " directories" << std::endl;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Collect the ids of the files of the tree, used by the stat operation
+//------------------------------------------------------------------------------
+static std::vector<eos::IFileMD::id_t>
+collectFileIds(eos::IView* view, const Options& opts)
+{
+  std::vector<eos::IFileMD::id_t> ids;
+  size_t leaves = numLeaves(opts);
+
+  for (size_t leaf = 0; leaf < leaves; ++leaf) {
+    try {
+      std::shared_ptr<eos::IContainerMD> cont =
+        view->getContainer(leafPath(opts, leaf));
+
+      for (auto it = eos::FileMapIterator(cont); it.valid(); it.next()) {
+        ids.push_back(it.value());
+      }
+    } catch (eos::MDException& e) {
+      // Missing directory, the lookups will count the errors
+    }
+  }
+
+  return ids;
+}
+
+//------------------------------------------------------------------------------
+//! Benchmark worker replaying the operation mix
+//------------------------------------------------------------------------------
+class Worker
+{
+public:
+  Worker(eos::IView* view, const Options& opts,
+         const std::vector<eos::IFileMD::id_t>& ids, size_t index,
+         const std::string& run_tag, const std::atomic<bool>& stop,
+         Result& result):
+    mView(view), mOpts(opts), mIds(ids), mStop(stop), mResult(result),
+    mRandom(opts.mSeed + index),
+    mPick(opts.mWeights.begin(), opts.mWeights.end()),
+    mLeaves(numLeaves(opts)), mCounter(0)
+  {
+    mScratch = opts.mPrefix + "/scratch/" + run_tag + "/t" +
+               std::to_string(index);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Run the operations
+  //----------------------------------------------------------------------------
+  void Run()
+  {
+    {
+      eos::common::RWMutexWriteLock lock;
+
+      if (mOpts.mLock) {
+        lock.Grab(nslock);
+      }
+
+      mView->createContainer(mScratch, true);
+    }
+
+    for (size_t i = 0; (!mOpts.mOps || (i < mOpts.mOps)) && !mStop; ++i) {
+      Op op = static_cast<Op>(mPick(mRandom));
+
+      // Rename and unlink need a file created by this worker
+      if (((op == kRename) || (op == kUnlink)) && mFiles.empty()) {
+        op = kCreate;
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      bool ok = Execute(op);
+      auto elapsed = std::chrono::steady_clock::now() - start;
+
+      if (ok) {
+        mResult.mLatency[op].push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+      } else {
+        mResult.mErrors[op]++;
+      }
+    }
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Execute one operation taking the namespace lock like the MGM does
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Execute(Op op)
+  {
+    bool write = ((op == kMkdir) || (op == kCreate) || (op == kRename) ||
+                  (op == kUnlink));
+    eos::common::RWMutexReadLock rd_lock;
+    eos::common::RWMutexWriteLock wr_lock;
+
+    if (mOpts.mLock) {
+      if (write) {
+        wr_lock.Grab(nslock);
+      } else {
+        rd_lock.Grab(nslock);
+      }
+    }
+
+    try {
+      switch (op) {
+      case kStat: {
+        if (mIds.empty()) {
+          return false;
+        }
+
+        std::shared_ptr<eos::IFileMD> fmd =
+          mView->getFileMDSvc()->getFileMD(mIds[mRandom() % mIds.size()]);
+        eos::IFileMD::ctime_t ctime;
+        fmd->getCTime(ctime);
+        (void) fmd->getSize();
+        break;
+      }
+
+      case kLookup: {
+        size_t leaf = mRandom() % mLeaves;
+        size_t file = (mOpts.mFilesPerDir ? mRandom() % mOpts.mFilesPerDir : 0);
+        std::shared_ptr<eos::IFileMD> fmd =
+          mView->getFile(filePath(mOpts, leaf, file));
+        (void) fmd->getSize();
+        break;
+      }
+
+      case kList: {
+        std::shared_ptr<eos::IContainerMD> cont =
+          mView->getContainer(leafPath(mOpts, mRandom() % mLeaves));
+        size_t entries = 0;
+
+        for (auto it = eos::FileMapIterator(cont); it.valid(); it.next()) {
+          ++entries;
+        }
+
+        for (auto it = eos::ContainerMapIterator(cont); it.valid(); it.next()) {
+          ++entries;
+        }
+
+        (void) entries;
+        break;
+      }
+
+      case kMkdir: {
+        std::shared_ptr<eos::IContainerMD> cont =
+          mView->createContainer(mScratch + "/d" + std::to_string(mCounter++),
+                                 false);
+        cont->setAttribute("sys.forced.layout", "replica");
+        mView->updateContainerStore(cont.get());
+        break;
+      }
+
+      case kCreate: {
+        std::string path = mScratch + "/f" + std::to_string(mCounter++);
+        std::shared_ptr<eos::IFileMD> fmd = mView->createFile(path, 0, 0);
+        fmd->setLayoutId(10);
+        mView->updateFileStore(fmd.get());
+        mFiles.push_back(path);
+        break;
+      }
+
+      case kRename: {
+        size_t pos = mRandom() % mFiles.size();
+        std::string name = "r" + std::to_string(mCounter++);
+        std::shared_ptr<eos::IFileMD> fmd = mView->getFile(mFiles[pos]);
+        mView->renameFile(fmd.get(), name);
+        mFiles[pos] = mScratch + "/" + name;
+        break;
+      }
+
+      case kUnlink: {
+        size_t pos = mRandom() % mFiles.size();
+        std::string path = mFiles[pos];
+        mFiles[pos] = mFiles.back();
+        mFiles.pop_back();
+        std::shared_ptr<eos::IFileMD> fmd = mView->getFile(path);
+        mView->unlinkFile(fmd.get());
+        mView->removeFile(fmd.get());
+        break;
+      }
+
+      default:
+        return false;
+      }
+    } catch (eos::MDException& e) {
+      return false;
+    }
+
+    return true;
+  }
+
+  eos::IView* mView;
+  const Options& mOpts;
+  const std::vector<eos::IFileMD::id_t>& mIds;
+  const std::atomic<bool>& mStop;
+  Result& mResult;
+  std::mt19937_64 mRandom;
+  std::discrete_distribution<int> mPick;
+  size_t mLeaves;
+  uint64_t mCounter;
+  std::string mScratch; ///< directory of the files created by this worker
+  std::vector<std::string> mFiles; ///< files created and not unlinked yet
+};
+
+//------------------------------------------------------------------------------
+// Percentile of sorted samples
+//------------------------------------------------------------------------------
+static double
+percentile(const std::vector<uint64_t>& sorted, double pct)
+{
+  if (sorted.empty()) {
+    return 0;
+  }
+
+  size_t pos = static_cast<size_t>(pct / 100.0 * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(pos, sorted.size() - 1)] / 1000.0;
+}
+
+//------------------------------------------------------------------------------
+// Print usage
+//------------------------------------------------------------------------------
+static void
+usage(const char* prog)
+{
+  std::cerr << "Usage: " << prog << " --cluster <host:port,...> [options]\n"
+            << "  --password <pw>        QuarkDB password\n"
+            << "  --prefix <path>        namespace prefix (/eos/nsworkload)\n"
+            << "  --mix <op:w,...>       weights of stat, lookup, mkdir, "
+            "create, rename, unlink, list\n"
+            << "                         (" << Options().mMix << ")\n"
+            << "  --threads <n>          worker threads (8)\n"
+            << "  --ops <n>              operations per thread, 0 unlimited "
+            "(10000)\n"
+            << "  --duration <sec>       max duration, 0 unlimited (0)\n"
+            << "  --depth <n>            directory levels of the tree (2)\n"
+            << "  --fanout <n>           sub directories per level (16)\n"
+            << "  --files <n>            files per leaf directory (100)\n"
+            << "  --file-cache <n>       max number of cached files\n"
+            << "  --dir-cache <n>        max number of cached directories\n"
+            << "  --reuse                tree exists, skip its creation\n"
+            << "  --no-lock              don't serialize through a namespace "
+            "lock\n"
+            << "  --seed <n>             random seed (0)\n"
+            << "  --output <file>        JSON report file (stdout)\n";
+}
+
+//------------------------------------------------------------------------------
+// Main function
+//------------------------------------------------------------------------------
+int
+main(int argc, char** argv)
+{
+  Options opts;
+  opts.mNsConfig = {
+    {"qdb_flusher_md", "nsworkload_md"},
+    {"qdb_flusher_quota", "nsworkload_quota"}
+  };
+  static struct option long_opts[] = {
+    {"cluster", required_argument, nullptr, 'c'},
+    {"password", required_argument, nullptr, 'p'},
+    {"prefix", required_argument, nullptr, 'P'},
+    {"mix", required_argument, nullptr, 'm'},
+    {"threads", required_argument, nullptr, 't'},
+    {"ops", required_argument, nullptr, 'n'},
+    {"duration", required_argument, nullptr, 'd'},
+    {"depth", required_argument, nullptr, 'D'},
+    {"fanout", required_argument, nullptr, 'F'},
+    {"files", required_argument, nullptr, 'f'},
+    {"file-cache", required_argument, nullptr, 'C'},
+    {"dir-cache", required_argument, nullptr, 'K'},
+    {"reuse", no_argument, nullptr, 'r'},
+    {"no-lock", no_argument, nullptr, 'L'},
+    {"seed", required_argument, nullptr, 's'},
+    {"output", required_argument, nullptr, 'o'},
+    {"help", no_argument, nullptr, 'h'},
+    {nullptr, 0, nullptr, 0}
+  };
+  int c;
+
+  try {
+    while ((c = getopt_long(argc, argv, "", long_opts, nullptr)) != -1) {
+      switch (c) {
+      case 'c':
+        opts.mNsConfig["qdb_cluster"] = optarg;
+        break;
+
+      case 'p':
+        opts.mNsConfig["qdb_password"] = optarg;
+        break;
+
+      case 'P':
+        opts.mPrefix = optarg;
+        break;
+
+      case 'm':
+        opts.mMix = optarg;
+        break;
+
+      case 't':
+        opts.mThreads = std::stoul(optarg);
+        break;
+
+      case 'n':
+        opts.mOps = std::stoul(optarg);
+        break;
+
+      case 'd':
+        opts.mDuration = std::stoul(optarg);
+        break;
+
+      case 'D':
+        opts.mDepth = std::stoul(optarg);
+        break;
+
+      case 'F':
+        opts.mFanout = std::stoul(optarg);
+        break;
+
+      case 'f':
+        opts.mFilesPerDir = std::stoul(optarg);
+        break;
+
+      case 'C':
+        opts.mNsConfig[eos::constants::sMaxNumCacheFiles] =
+          std::to_string(std::stoull(optarg));
+        break;
+
+      case 'K':
+        opts.mNsConfig[eos::constants::sMaxNumCacheDirs] =
+          std::to_string(std::stoull(optarg));
+        break;
+
+      case 'r':
+        opts.mReuse = true;
+        break;
+
+      case 'L':
+        opts.mLock = false;
+        break;
+
+      case 's':
+        opts.mSeed = std::stoull(optarg);
+        break;
+
+      case 'o':
+        opts.mOutput = optarg;
+        break;
+
+      default:
+        usage(argv[0]);
+        return 1;
+      }
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "[!] Error: invalid numeric argument" << std::endl;
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (!opts.mNsConfig.count("qdb_cluster") || !opts.mThreads ||
+      !opts.mFanout || (!opts.mOps && !opts.mDuration)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (!parseMix(opts.mMix, opts.mWeights)) {
+    std::cerr << "[!] Error: invalid operation mix: " << opts.mMix << std::endl;
+    return 1;
+  }
+
+  eos::IView* view = nullptr;
+  size_t ncontainers = 0;
+  size_t nfiles = 0;
+  double setup_sec = 0;
+  std::vector<eos::IFileMD::id_t> ids;
+
+  try {
+    view = bootNamespace(opts.mNsConfig);
+    auto start = std::chrono::steady_clock::now();
+
+    if (!opts.mReuse) {
+      std::cerr << "[i] Creating " << numLeaves(opts) << " directories with "
+                << opts.mFilesPerDir << " files each ..." << std::endl;
+      setupTree(view, opts, ncontainers, nfiles);
+    }
+
+    ids = collectFileIds(view, opts);
+    setup_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                start).count();
+  } catch (eos::MDException& e) {
+    std::cerr << "[!] Error: " << e.getMessage().str()
+              << " (use --reuse or another --prefix if the tree exists)"
+              << std::endl;
+    return 2;
+  }
+
+  std::cerr << "[i] Running " << opts.mThreads << " threads ..." << std::endl;
+  std::string run_tag = std::to_string(std::chrono::duration_cast
+                                       <std::chrono::seconds>
+                                       (std::chrono::system_clock::now().time_since_epoch()).count());
+  std::atomic<bool> stop {false};
+  std::vector<Result> results(opts.mThreads);
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < opts.mThreads; ++i) {
+    threads.emplace_back([&, i]() {
+      try {
+        Worker(view, opts, ids, i, run_tag, stop, results[i]).Run();
+      } catch (eos::MDException& e) {
+        std::cerr << "[!] Error: thread " << i << ": " << e.getMessage().str()
+                  << std::endl;
+      }
+    });
+  }
+
+  if (opts.mDuration) {
+    auto deadline = start + std::chrono::seconds(opts.mDuration);
+    std::thread timer([&]() {
+      while (!stop && (std::chrono::steady_clock::now() < deadline)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+
+      stop = true;
+    });
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    stop = true;
+    timer.join();
+  } else {
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  double run_sec = std::chrono::duration<double>
+                   (std::chrono::steady_clock::now() - start).count();
+  eos::common::LinuxMemConsumption::linux_mem_t mem;
+  eos::common::LinuxMemConsumption::GetMemoryFootprint(mem);
+  // Build the report
+  std::ostringstream json;
+  json << "{\n  \"config\": {\"prefix\": \"" << opts.mPrefix << "\", \"mix\": \""
+       << opts.mMix << "\", \"threads\": " << opts.mThreads
+       << ", \"ops_per_thread\": " << opts.mOps
+       << ", \"duration\": " << opts.mDuration
+       << ", \"depth\": " << opts.mDepth
+       << ", \"fanout\": " << opts.mFanout
+       << ", \"files_per_dir\": " << opts.mFilesPerDir
+       << ", \"file_cache\": \""
+       << (opts.mNsConfig.count(eos::constants::sMaxNumCacheFiles) ?
+           opts.mNsConfig[eos::constants::sMaxNumCacheFiles] : "default")
+       << "\", \"dir_cache\": \""
+       << (opts.mNsConfig.count(eos::constants::sMaxNumCacheDirs) ?
+           opts.mNsConfig[eos::constants::sMaxNumCacheDirs] : "default")
+       << "\", \"lock\": " << (opts.mLock ? "true" : "false")
+       << ", \"seed\": " << opts.mSeed << "},\n";
+  json << "  \"setup\": {\"seconds\": " << setup_sec
+       << ", \"containers\": " << ncontainers << ", \"files\": " << nfiles
+       << ", \"indexed_files\": " << ids.size() << "},\n";
+  json << "  \"ops\": {";
+  uint64_t total = 0;
+  uint64_t total_errors = 0;
+
+  for (int op = 0; op < kNumOps; ++op) {
+    std::vector<uint64_t> samples;
+    uint64_t errors = 0;
+
+    for (auto& result : results) {
+      samples.insert(samples.end(), result.mLatency[op].begin(),
+                     result.mLatency[op].end());
+      std::vector<uint64_t>().swap(result.mLatency[op]);
+      errors += result.mErrors[op];
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+
+    for (auto sample : samples) {
+      sum += sample;
+    }
+
+    total += samples.size();
+    total_errors += errors;
+    json << (op ? ",\n" : "\n") << "    \"" << sOpNames[op] << "\": {"
+         << "\"count\": " << samples.size() << ", \"errors\": " << errors
+         << ", \"throughput\": " << (run_sec > 0 ? samples.size() / run_sec : 0)
+         << ", \"latency_us\": {\"mean\": "
+         << (samples.empty() ? 0 : sum / samples.size() / 1000.0)
+         << ", \"p50\": " << percentile(samples, 50)
+         << ", \"p90\": " << percentile(samples, 90)
+         << ", \"p99\": " << percentile(samples, 99)
+         << ", \"p999\": " << percentile(samples, 99.9)
+         << ", \"max\": " << (samples.empty() ? 0 : samples.back() / 1000.0)
+         << "}}";
+  }
+
+  json << "\n  },\n";
+  json << "  \"total\": {\"ops\": " << total << ", \"errors\": " << total_errors
+       << ", \"seconds\": " << run_sec << ", \"throughput\": "
+       << (run_sec > 0 ? total / run_sec : 0) << "},\n";
+  json << "  \"memory\": {\"vmsize\": " << mem.vmsize << ", \"resident\": "
+       << mem.resident << "}\n}\n";
+
+  if (opts.mOutput.empty()) {
+    std::cout << json.str();
+  } else {
+    std::ofstream out(opts.mOutput);
+    out << json.str();
+
+    if (!out) {
+      std::cerr << "[!] Error: failed to write " << opts.mOutput << std::endl;
+      return 2;
+    }
+  }
+
+  std::cerr << "[i] Flushing the namespace ..." << std::endl;
+
+  try {
+    closeNamespace(view);
+  } catch (eos::MDException& e) {
+    std::cerr << "[!] Error: " << e.getMessage().str() << std::endl;
+    return 2;
+  }
+
+  return 0;
+}
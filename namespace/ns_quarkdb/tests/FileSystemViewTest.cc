@@ -392,6 +392,15 @@ TEST_F(FileSystemViewF, FileListIterator) {
   ASSERT_TRUE(eos::ns::testing::verifyContents(fsview()->getStreamingFileList(3), std::set<eos::IFileMD::id_t> { 1, 3 } ));
   ASSERT_FALSE(eos::ns::testing::verifyContents(fsview()->getStreamingFileList(3), std::set<eos::IFileMD::id_t> { 1, 2, 3 } ));
   ASSERT_TRUE(eos::ns::testing::verifyContents(fsview()->getStreamingFileList(4), std::set<eos::IFileMD::id_t> { 4 } ));
+
+  ASSERT_TRUE(eos::ns::testing::verifyContents(fsview()->getFileListIntersection(2, 3), std::set<eos::IFileMD::id_t> { 1, 3 } ));
+  ASSERT_TRUE(eos::ns::testing::verifyContents(fsview()->getFileListIntersection(2, 2), std::set<eos::IFileMD::id_t> { 1, 2, 3 } ));
+  ASSERT_TRUE(eos::ns::testing::verifyContents(fsview()->getFileListIntersection(2, 4), std::set<eos::IFileMD::id_t> { } ));
+  ASSERT_TRUE(eos::ns::testing::verifyContents(fsview()->getFileListIntersection(2, 99), std::set<eos::IFileMD::id_t> { } ));
+  ASSERT_TRUE(eos::ns::testing::verifyContents(fsview()->getFileListDifference(2, 3), std::set<eos::IFileMD::id_t> { 2 } ));
+  ASSERT_TRUE(eos::ns::testing::verifyContents(fsview()->getFileListDifference(3, 2), std::set<eos::IFileMD::id_t> { } ));
+  ASSERT_TRUE(eos::ns::testing::verifyContents(fsview()->getFileListDifference(2, 99), std::set<eos::IFileMD::id_t> { 1, 2, 3 } ));
+  ASSERT_TRUE(eos::ns::testing::verifyContents(fsview()->getFileListDifference(99, 2), std::set<eos::IFileMD::id_t> { } ));
 }
 
 //------------------------------------------------------------------------------
@@ -469,6 +478,28 @@ TEST_F(FileSystemViewF, FileSystemHandler) {
 
     // Try streaming iterator
     ASSERT_TRUE(eos::ns::testing::verifyContents(fs1.getStreamingFileList(), std::set<eos::IFileMD::id_t> {1, 8, 10, 20, 99} ));
+
+    // Try paged iterator, as well as resuming from the cursor of a page
+    ASSERT_TRUE(eos::ns::testing::verifyContents(fs1.getPagedFileList("0", 2), std::set<eos::IFileMD::id_t> {1, 8, 10, 20, 99} ));
+    ASSERT_TRUE(eos::ns::testing::verifyContents(fs1.getPagedFileList("0", 1000), std::set<eos::IFileMD::id_t> {1, 8, 10, 20, 99} ));
+
+    std::set<eos::IFileMD::id_t> seen;
+    auto it = fs1.getPagedFileList("0", 2);
+    ASSERT_EQ(it->getCursor(), "0");
+
+    while (it->valid() && (it->getCursor() == "0")) {
+      seen.insert(it->getElement());
+      it->next();
+    }
+
+    ASSERT_TRUE(it->valid());
+    ASSERT_FALSE(seen.empty());
+
+    for (auto it2 = fs1.getPagedFileList(it->getCursor(), 2); it2->valid(); it2->next()) {
+      seen.insert(it2->getElement());
+    }
+
+    ASSERT_EQ(seen, (std::set<eos::IFileMD::id_t> {1, 8, 10, 20, 99}));
   }
 
   shut_down_everything();
@@ -762,3 +762,64 @@ TEST_F(HierarchicalViewF, QuotaRecomputation)
   ASSERT_EQ(qnc.getPhysicalSpaceByGroup(200), 0);
   ASSERT_EQ(qnc.getNumFilesByGroup(200), 0);
 }
+
+TEST_F(HierarchicalViewF, IncrementalQuotaRecomputation)
+{
+  eos::IContainerMDPtr quota = view()->createContainer("/quota4", true);
+  eos::IContainerMDPtr dir1 = view()->createContainer("/quota4/d1", true);
+  eos::IContainerMDPtr dir2 = view()->createContainer("/quota4/d2", true);
+  unsigned long layoutId = eos::common::LayoutId::GetId(
+    eos::common::LayoutId::kReplica,
+    eos::common::LayoutId::kMD5,
+    2,
+    eos::common::LayoutId::k4k);
+  auto createFile = [&](const std::string & path, uid_t uid) {
+    eos::IFileMDPtr file = view()->createFile(path, true);
+    file->setSize(100);
+    file->setLayoutId(layoutId);
+    file->setCUid(uid);
+    file->setCGid(10);
+    fileSvc()->updateStore(file.get());
+  };
+
+  for (size_t i = 0; i < 5; i++) {
+    createFile(SSTR("/quota4/f" << i), 1);
+    createFile(SSTR("/quota4/d1/f" << i), 2);
+    createFile(SSTR("/quota4/d2/f" << i), 3);
+  }
+
+  dir1->setTreeSize(500);
+  dir2->setTreeSize(500);
+  containerSvc()->updateStore(dir1.get());
+  containerSvc()->updateStore(dir2.get());
+  ASSERT_NE(view()->registerQuotaNode(quota.get()), nullptr);
+  mdFlusher()->synchronize();
+  eos::QuotaNodeCore qnc;
+  eos::QuotaRecomputer recomputer(view(), &(qcl()), 4);
+  ASSERT_TRUE(recomputer.recompute(quota, qnc).ok());
+
+  for (uid_t uid = 1; uid <= 3; uid++) {
+    ASSERT_EQ(qnc.getUsedSpaceByUser(uid), 500);
+    ASSERT_EQ(qnc.getPhysicalSpaceByUser(uid), 1000);
+    ASSERT_EQ(qnc.getNumFilesByUser(uid), 5);
+  }
+
+  ASSERT_EQ(qnc.getNumFilesByGroup(10), 15);
+  // New files everywhere, but only the tree size of d1 changes: the usage of
+  // d2 is taken from the last run while the quotanode files are rescanned
+  createFile("/quota4/f5", 1);
+  createFile("/quota4/d1/f5", 2);
+  createFile("/quota4/d2/f5", 3);
+  dir1->setTreeSize(600);
+  containerSvc()->updateStore(dir1.get());
+  mdFlusher()->synchronize();
+  ASSERT_TRUE(recomputer.recompute(quota, qnc, true).ok());
+  ASSERT_EQ(qnc.getNumFilesByUser(1), 6);
+  ASSERT_EQ(qnc.getNumFilesByUser(2), 6);
+  ASSERT_EQ(qnc.getNumFilesByUser(3), 5);
+  // A full recompute sees everything
+  ASSERT_TRUE(recomputer.recompute(quota, qnc).ok());
+  ASSERT_EQ(qnc.getNumFilesByUser(3), 6);
+  ASSERT_EQ(qnc.getUsedSpaceByUser(3), 600);
+  ASSERT_EQ(qnc.getNumFilesByGroup(10), 18);
+}
@@ -25,6 +25,8 @@
 #include "qclient/QHash.hh"
 #include "Namespace.hh"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>
 #include <vector>
 
 EOSNSTESTING_BEGIN
@@ -66,4 +68,48 @@ TEST_F(NextInodeProviderTest, BasicSanity)
   qcl->del("ns-tests-next-inode-provider");
 }
 
+TEST_F(NextInodeProviderTest, ConcurrentReservations)
+{
+  std::unique_ptr<qclient::QClient> qcl = createQClient();
+  qclient::QHash myhash;
+  myhash.setKey("ns-tests-next-inode-provider");
+  myhash.setClient(*qcl.get());
+  myhash.hdel("counter");
+  constexpr size_t numThreads = 8;
+  constexpr size_t perThread = 20000;
+  NextInodeProvider inodeProvider;
+  inodeProvider.configure(myhash, "counter");
+  std::vector<std::vector<int64_t>> reserved(numThreads);
+  std::vector<std::thread> threads;
+
+  for (size_t i = 0; i < numThreads; i++) {
+    threads.emplace_back([&inodeProvider, &reserved, i]() {
+      for (size_t j = 0; j < perThread; j++) {
+        reserved[i].push_back(inodeProvider.reserve());
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Every id is handed out exactly once and blocks are contiguous
+  std::vector<int64_t> all;
+
+  for (const auto& ids : reserved) {
+    ASSERT_TRUE(std::is_sorted(ids.begin(), ids.end()));
+    all.insert(all.end(), ids.begin(), ids.end());
+  }
+
+  std::sort(all.begin(), all.end());
+
+  for (size_t i = 0; i < all.size(); i++) {
+    ASSERT_EQ(all[i], (int64_t)(i + 1));
+  }
+
+  ASSERT_EQ(inodeProvider.getFirstFreeId(), (int64_t)(all.size() + 1));
+  qcl->del("ns-tests-next-inode-provider");
+}
+
 EOSNSTESTING_END
@@ -22,13 +22,27 @@
 //------------------------------------------------------------------------------
 
 #include <vector>
+#include "namespace/ns_quarkdb/CompactFileMD.hh"
 #include "namespace/ns_quarkdb/ConfigurationParser.hh"
+#include "namespace/ns_quarkdb/ContainerMD.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
 #include "namespace/ns_quarkdb/LRU.hh"
+#include "namespace/ns_quarkdb/NegativeLookupCache.hh"
+#include "namespace/ns_quarkdb/PagedFileMap.hh"
+#include "namespace/ns_quarkdb/PathLookupCache.hh"
+#include "namespace/ns_quarkdb/persistency/ProtoArena.hh"
+#include "namespace/ns_quarkdb/persistency/Serialization.hh"
+#include "namespace/ns_quarkdb/tools/NsDumpFormat.hh"
+#include "namespace/utils/DataHelper.hh"
+#include "namespace/utils/FileBitmap.hh"
 #include "namespace/utils/PathProcessor.hh"
 #include "namespace/utils/TestHelpers.hh"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <set>
 #include <sstream>
+#include <unistd.h>
 
 //------------------------------------------------------------------------------
 // Check the path
@@ -128,6 +142,414 @@ TEST(LRU, BasicSanity)
   ASSERT_TRUE(!cache.get(100));
 }
 
+TEST(LRU, ClockPolicy)
+{
+  struct Entry {
+    explicit Entry(std::uint64_t id) : id_(id) {}
+
+    ~Entry() = default;
+
+    std::uint64_t
+    getId() const
+    {
+      return id_;
+    }
+
+    std::uint64_t id_;
+  };
+  std::uint64_t max_size = 1000;
+  eos::LRU<std::uint64_t, Entry> cache{max_size, eos::CachePolicy::kClock};
+  ASSERT_TRUE(cache.get_policy() == eos::CachePolicy::kClock);
+
+  for (std::uint64_t id = 0; id < max_size; ++id) {
+    ASSERT_TRUE(cache.put(id, std::make_shared<Entry>(id)));
+  }
+
+  ASSERT_EQ(max_size, cache.size());
+
+  // Mark only the second half as referenced
+  for (std::uint64_t id = max_size / 2; id < max_size; ++id) {
+    ASSERT_TRUE(cache.get(id)->getId() == id);
+  }
+
+  // This triggers a purge which must evict unreferenced entries first
+  ASSERT_TRUE(cache.put(max_size, std::make_shared<Entry>(max_size)));
+  ASSERT_EQ((std::uint64_t)901, cache.size());
+  ASSERT_FALSE(cache.get(0));
+  ASSERT_FALSE(cache.get(99));
+  ASSERT_TRUE(cache.get(100));
+  ASSERT_TRUE(cache.get(max_size - 1));
+  // Entries referenced elsewhere are never evicted
+  std::shared_ptr<Entry> elem = cache.get(101);
+  ASSERT_TRUE(elem);
+
+  for (std::uint64_t id = 2 * max_size; id < 3 * max_size; ++id) {
+    ASSERT_TRUE(cache.put(id, std::make_shared<Entry>(id)));
+  }
+
+  ASSERT_TRUE(cache.get(101));
+  ASSERT_TRUE(cache.remove(101));
+  ASSERT_FALSE(cache.get(101));
+  // Switching policy keeps the cached entries
+  std::uint64_t sz = cache.size();
+  cache.set_policy(eos::CachePolicy::kLRU);
+  ASSERT_EQ(sz, cache.size());
+}
+
+TEST(LRU, MostRecent)
+{
+  struct Entry {
+    explicit Entry(std::uint64_t id) : id_(id) {}
+
+    std::uint64_t
+    getId() const
+    {
+      return id_;
+    }
+
+    std::uint64_t id_;
+  };
+  eos::LRU<std::uint64_t, Entry> cache{100};
+  ASSERT_TRUE(cache.getMostRecent(10).empty());
+
+  for (std::uint64_t id = 0; id < 50; ++id) {
+    ASSERT_TRUE(cache.put(id, std::make_shared<Entry>(id)));
+  }
+
+  // Accessing an entry makes it the most recent one
+  ASSERT_TRUE(cache.get(10));
+  std::vector<std::uint64_t> ids = cache.getMostRecent(3);
+  ASSERT_EQ((std::vector<std::uint64_t> {10, 49, 48}), ids);
+  ASSERT_EQ(50u, cache.getMostRecent(1000).size());
+  // With CLOCK the most recent entries are the ones behind the hand
+  eos::LRU<std::uint64_t, Entry> clock_cache{100, eos::CachePolicy::kClock};
+
+  for (std::uint64_t id = 0; id < 50; ++id) {
+    ASSERT_TRUE(clock_cache.put(id, std::make_shared<Entry>(id)));
+  }
+
+  ids = clock_cache.getMostRecent(2);
+  ASSERT_EQ((std::vector<std::uint64_t> {49, 48}), ids);
+  ASSERT_EQ(50u, clock_cache.getMostRecent(50).size());
+}
+
+TEST(CompactFileMD, ProtoRoundTrip)
+{
+  eos::ns::FileMdProto proto;
+  proto.set_id(12);
+  proto.set_cont_id(34);
+  proto.set_uid(5);
+  proto.set_gid(6);
+  proto.set_size(1ull << 40);
+  proto.set_layout_id(0x100112);
+  proto.set_flags(0x81);
+  proto.set_name("a-file-name-longer-than-the-inline-string-buffer");
+  struct timespec ts {123, 456};
+  proto.set_ctime(&ts, sizeof(ts));
+  proto.set_checksum(std::string(20, 'c'));
+
+  for (uint32_t i = 1; i <= 5; ++i) {
+    proto.add_locations(i);
+  }
+
+  proto.add_unlink_locations(9);
+  (*proto.mutable_xattrs())["sys.eos.btime"] = "1.2";
+  (*proto.mutable_xattrs())["user.bin"] = std::string("a\0b", 3);
+  eos::CompactFileMD compact;
+  compact.fromProto(proto);
+  ASSERT_EQ(compact.mLocations.size(), 5u);
+  ASSERT_EQ(compact.mChecksum.size(), 20u);
+  ASSERT_EQ(compact.mLinkName, nullptr);
+  ASSERT_FALSE(compact.mPresent & eos::CompactFileMD::kHasMTime);
+  // Copies are independent
+  eos::CompactFileMD copy(compact);
+  copy.mLocations.erase(0);
+  copy.mXAttrs.set("sys.eos.btime", "3");
+  ASSERT_EQ(compact.mLocations[0], 1u);
+  ASSERT_EQ(*compact.mXAttrs.get("sys.eos.btime"), "1.2");
+  ASSERT_EQ(*copy.mXAttrs.get("sys.eos.btime"), "3");
+  eos::ns::FileMdProto out;
+  compact.toProto(out);
+  ASSERT_EQ(out.xattrs().size(), 2u);
+  ASSERT_EQ(out.xattrs().at("user.bin"), std::string("a\0b", 3));
+  ASSERT_TRUE(out.mtime().empty());
+  // The map serialization order is unspecified, compare the rest
+  proto.clear_xattrs();
+  out.clear_xattrs();
+  ASSERT_EQ(out.SerializeAsString(), proto.SerializeAsString());
+}
+
+TEST(CompactFileMD, InlineVector)
+{
+  eos::InlineVector<uint32_t, 2> vec;
+  ASSERT_TRUE(vec.empty());
+
+  for (uint32_t i = 0; i < 5; ++i) {
+    vec.push_back(i);
+  }
+
+  vec.erase(0);
+  vec.erase(3);
+  ASSERT_EQ(std::vector<uint32_t>(vec.begin(), vec.end()),
+            std::vector<uint32_t>({1, 2, 3}));
+  eos::InlineVector<uint32_t, 2> other;
+  other.push_back(7);
+  other = vec;
+  ASSERT_EQ(other.size(), 3u);
+  vec.clear();
+  vec.push_back(8);
+  ASSERT_EQ(vec.size(), 1u);
+  ASSERT_EQ(vec[0], 8u);
+  ASSERT_EQ(other[2], 3u);
+}
+
+TEST(ProtoArena, Deserialize)
+{
+  eos::ns::FileMdProto proto;
+  proto.set_id(77);
+  proto.set_name("file-on-arena");
+  proto.add_locations(3);
+  (*proto.mutable_xattrs())["sys.eos.btime"] = "1.2";
+  // Same layout as QuarkFileMD::serialize
+  std::string payload = proto.SerializeAsString();
+  uint32_t obj_size = payload.size();
+  payload.resize((obj_size + 3) >> 2 << 2, '\0');
+  uint32_t cksum = eos::DataHelper::computeCRC32C((void*) payload.data(),
+                   payload.size());
+  cksum = eos::DataHelper::finalizeCRC32C(cksum);
+  std::string buffer((const char*) &cksum, sizeof(cksum));
+  buffer.append((const char*) &obj_size, sizeof(obj_size));
+  buffer += payload;
+
+  for (int i = 0; i < 3; ++i) {
+    eos::ScopedProtoArena arena;
+    eos::ns::FileMdProto* out = arena.create<eos::ns::FileMdProto>();
+    ASSERT_TRUE(eos::Serialization::deserialize(buffer.data(), buffer.size(),
+                *out).ok());
+    ASSERT_NE(out->GetArena(), nullptr);
+    ASSERT_EQ(out->id(), 77u);
+    ASSERT_EQ(out->name(), "file-on-arena");
+    ASSERT_EQ(out->xattrs().at("sys.eos.btime"), "1.2");
+    ASSERT_GT(arena.getSpaceUsed(), 0u);
+  }
+
+  eos::ns::FileMdProto out;
+  ASSERT_FALSE(eos::Serialization::deserialize(buffer.data(), 5, out).ok());
+  buffer[buffer.size() - 1] ^= 0x1;
+  ASSERT_FALSE(eos::Serialization::deserialize(buffer.data(), buffer.size(),
+               out).ok());
+}
+
+TEST(NegativeLookupCache, BasicSanity)
+{
+  eos::NegativeLookupCache cache(100);
+  eos::ContainerIdentifier parent(5);
+  ASSERT_FALSE(cache.contains(parent, "missing"));
+  cache.insert(parent, "missing");
+  ASSERT_TRUE(cache.contains(parent, "missing"));
+  ASSERT_FALSE(cache.contains(eos::ContainerIdentifier(6), "missing"));
+  cache.invalidate(parent, "missing");
+  ASSERT_FALSE(cache.contains(parent, "missing"));
+
+  // Oldest entries are evicted once the cache is full
+  for (int i = 0; i < 150; ++i) {
+    cache.insert(parent, std::to_string(i));
+  }
+
+  ASSERT_EQ(100u, cache.size());
+  ASSERT_FALSE(cache.contains(parent, "0"));
+  ASSERT_TRUE(cache.contains(parent, "149"));
+  // Disabled cache never answers
+  cache.set_max_num(0);
+  ASSERT_EQ(0u, cache.size());
+  cache.insert(parent, "missing");
+  ASSERT_FALSE(cache.contains(parent, "missing"));
+}
+
+TEST(PathLookupCache, BasicSanity)
+{
+  auto makeContainer = [](uint64_t id, uint64_t parent, const std::string & name) {
+    std::shared_ptr<eos::QuarkContainerMD> cont =
+      std::make_shared<eos::QuarkContainerMD>(id, nullptr, nullptr);
+    cont->setName(name);
+    cont->setParentId(parent);
+    return cont;
+  };
+  std::deque<std::string> chunks;
+  eos::PathProcessor::insertChunksIntoDeque(chunks, "/eos/user/a/file");
+  auto eos = makeContainer(2, 1, "eos");
+  auto user = makeContainer(3, 2, "user");
+  auto a = makeContainer(4, 3, "a");
+  eos::PathLookupCache cache(100);
+  size_t depth = 0;
+  eos::ContainerIdentifier id;
+  ASSERT_FALSE(cache.lookup(chunks, depth, id));
+  // Paths are only cached on top of their cached parent
+  ASSERT_EQ(0u, cache.insert(chunks, 1, {user, a}));
+  // Insertion stops at the first container not matching the path
+  ASSERT_EQ(2u, cache.insert(chunks, 0, {eos, user, makeContainer(5, 2, "a")}));
+  ASSERT_EQ(2u, cache.size());
+  ASSERT_TRUE(cache.lookup(chunks, depth, id));
+  ASSERT_EQ(2u, depth);
+  ASSERT_EQ(3u, id.getUnderlyingUInt64());
+  ASSERT_EQ(1u, cache.insert(chunks, 2, {a}));
+  ASSERT_TRUE(cache.lookup(chunks, depth, id));
+  ASSERT_EQ(3u, depth);
+  ASSERT_EQ(4u, id.getUnderlyingUInt64());
+  // Prefixes stop at "." and ".."
+  std::deque<std::string> dots;
+  eos::PathProcessor::insertChunksIntoDeque(dots, "/eos/../eos/user/a");
+  ASSERT_TRUE(cache.lookup(dots, depth, id));
+  ASSERT_EQ(1u, depth);
+  // Updates not changing the name or the parent keep the entries
+  cache.containerMDChanged(user.get(), eos::IContainerMDChangeListener::Updated);
+  ASSERT_EQ(3u, cache.size());
+  // A rename drops the container and everything below it
+  user->setName("people");
+  cache.containerMDChanged(user.get(), eos::IContainerMDChangeListener::Updated);
+  ASSERT_EQ(1u, cache.size());
+  ASSERT_TRUE(cache.lookup(chunks, depth, id));
+  ASSERT_EQ(1u, depth);
+  user->setName("user");
+  ASSERT_EQ(2u, cache.insert(chunks, 1, {user, a}));
+  // So does a move to another parent or a deletion
+  a->setParentId(2);
+  cache.containerMDChanged(a.get(), eos::IContainerMDChangeListener::Updated);
+  ASSERT_EQ(2u, cache.size());
+  cache.containerMDChanged(eos.get(), eos::IContainerMDChangeListener::Deleted);
+  ASSERT_EQ(0u, cache.size());
+  ASSERT_FALSE(cache.lookup(chunks, depth, id));
+  // Evicting a path evicts its subtree as well
+  a->setParentId(3);
+  eos::PathLookupCache small(2);
+  ASSERT_EQ(2u, small.insert(chunks, 0, {eos, user}));
+  ASSERT_EQ(0u, small.insert(chunks, 2, {a}));
+  ASSERT_EQ(0u, small.size());
+  // Disabled cache never answers
+  cache.set_max_num(0);
+  ASSERT_EQ(0u, cache.insert(chunks, 0, {eos}));
+  ASSERT_FALSE(cache.lookup(chunks, depth, id));
+}
+
+TEST(PagedFileMap, BasicSanity)
+{
+  eos::PagedFileMap paged(100, 2, 3);
+  eos::IContainerMD::id_t id = 0;
+  uint64_t generation = 0;
+  ASSERT_EQ(100u, paged.size());
+  ASSERT_EQ(eos::PagedFileMap::Lookup::kUnknown,
+            paged.find("f1", id, generation));
+  paged.cache("f1", 11, generation);
+  paged.cache("f2", 0, generation);
+  ASSERT_EQ(eos::PagedFileMap::Lookup::kFound, paged.find("f1", id, generation));
+  ASSERT_EQ(11u, id);
+  ASSERT_EQ(eos::PagedFileMap::Lookup::kMissing,
+            paged.find("f2", id, generation));
+  // LRU bound, f1 was used less recently than f2
+  paged.cache("f3", 13, generation);
+  ASSERT_EQ(2u, paged.getNumCachedNames());
+  ASSERT_EQ(eos::PagedFileMap::Lookup::kUnknown,
+            paged.find("f1", id, generation));
+  // Changes take precedence and make concurrent answers stale
+  uint64_t old_generation = generation;
+  ASSERT_FALSE(paged.insert("f4", 14, true));
+  ASSERT_FALSE(paged.erase("f3"));
+  ASSERT_EQ(100u, paged.size());
+  paged.cache("f4", 0, old_generation);
+  ASSERT_EQ(eos::PagedFileMap::Lookup::kFound, paged.find("f4", id, generation));
+  ASSERT_EQ(14u, id);
+  ASSERT_EQ(eos::PagedFileMap::Lookup::kMissing,
+            paged.find("f3", id, generation));
+  // Pages from QuarkDB do not contain the changed names twice
+  eos::IContainerMD::FilePage page {{"f3", 13}, {"f4", 14}, {"f5", 15}};
+  paged.filterPage(page);
+  ASSERT_EQ(1u, page.size());
+  ASSERT_EQ("f5", page[0].first);
+  paged.getAddedFiles(page);
+  ASSERT_EQ(2u, page.size());
+  ASSERT_EQ("f4", page[1].first);
+  // Only the changes before the synchronization move to the LRU
+  uint64_t seq = paged.getChangeSeq();
+  ASSERT_TRUE(paged.insert("f6", 16, true));
+  ASSERT_EQ(eos::PagedFileMap::Lookup::kUnknown,
+            paged.find("f1", id, old_generation));
+  paged.synchronized(seq);
+  paged.cache("f1", 11, old_generation);
+  ASSERT_EQ(eos::PagedFileMap::Lookup::kUnknown,
+            paged.find("f1", id, generation));
+  page = {{"f4", 14}, {"f5", 15}};
+  paged.filterPage(page);
+  ASSERT_EQ(2u, page.size());
+  page.clear();
+  paged.getAddedFiles(page);
+  ASSERT_EQ(1u, page.size());
+  ASSERT_EQ("f6", page[0].first);
+  ASSERT_EQ(eos::PagedFileMap::Lookup::kFound, paged.find("f4", id, generation));
+  ASSERT_EQ(14u, id);
+  ASSERT_EQ(101u, paged.size());
+}
+
+TEST(NsDumpFormat, RoundTrip)
+{
+  for (bool compress : {
+         false, true
+       }) {
+    char tmpl[] = "/tmp/eos-ns-dump-test.XXXXXX";
+    int fd = mkstemp(tmpl);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    std::string big(3 * 1024 * 1024, 'x');
+    {
+      eos::NsDumpWriter writer;
+      ASSERT_TRUE(writer.open(tmpl, compress));
+      eos::NsDumpBlock conts(eos::NsDump::kContainer);
+      conts.add("c1", 2);
+      eos::NsDumpBlock files(eos::NsDump::kFile);
+      files.add("", 0);
+      files.add(big.data(), big.size());
+      ASSERT_FALSE(files.full());
+      files.add(big.data(), big.size());
+      files.add(big.data(), big.size());
+      ASSERT_TRUE(files.full());
+      ASSERT_TRUE(writer.writeBlock(conts));
+      ASSERT_TRUE(writer.writeBlock(files));
+      files.clear();
+      ASSERT_TRUE(writer.writeBlock(files));
+      ASSERT_TRUE(writer.close());
+    }
+    eos::NsDumpReader reader;
+    ASSERT_TRUE(reader.open(tmpl));
+    eos::NsDump::Kind kind;
+    std::string record;
+    ASSERT_TRUE(reader.next(kind, record));
+    ASSERT_EQ(eos::NsDump::kContainer, kind);
+    ASSERT_EQ("c1", record);
+    ASSERT_TRUE(reader.next(kind, record));
+    ASSERT_EQ(eos::NsDump::kFile, kind);
+    ASSERT_TRUE(record.empty());
+
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(reader.next(kind, record));
+      ASSERT_EQ(eos::NsDump::kFile, kind);
+      ASSERT_EQ(big, record);
+    }
+
+    ASSERT_FALSE(reader.next(kind, record));
+    ASSERT_FALSE(reader.isCorrupted());
+    // A truncated file is reported as corrupted
+    ASSERT_EQ(0, truncate(tmpl, 40));
+    eos::NsDumpReader truncated;
+    ASSERT_TRUE(truncated.open(tmpl));
+
+    while (truncated.next(kind, record)) {
+      ASSERT_EQ("c1", record);
+    }
+
+    ASSERT_TRUE(truncated.isCorrupted());
+    unlink(tmpl);
+  }
+}
+
 TEST(PathProcessor, AbsPathTest)
 {
   std::string path = "/a/b/c/d/";
@@ -168,3 +590,105 @@ TEST(QdbContactDetails, BasicSanity)
   ASSERT_EQ(cd.members.toString(), "example1.cern.ch:1234,example2.cern.ch:2345,example3.cern.ch:3456");
   ASSERT_EQ(cd.password, "turtles_turtles_etc");
 }
+
+TEST(FileBitmap, BasicSanity)
+{
+  eos::FileBitmap bitmap;
+  ASSERT_TRUE(bitmap.empty());
+  ASSERT_TRUE(bitmap.begin() == bitmap.end());
+  ASSERT_TRUE(bitmap.insert(5));
+  ASSERT_FALSE(bitmap.insert(5));
+  ASSERT_TRUE(bitmap.insert(1ull << 40));
+  ASSERT_TRUE(bitmap.insert(3));
+  ASSERT_EQ(bitmap.size(), 3u);
+  ASSERT_TRUE(bitmap.contains(5));
+  ASSERT_FALSE(bitmap.contains(4));
+  std::vector<uint64_t> ids(bitmap.begin(), bitmap.end());
+  ASSERT_EQ(ids, std::vector<uint64_t>({3, 5, 1ull << 40}));
+  uint64_t id = 0;
+  ASSERT_TRUE(bitmap.select(2, id));
+  ASSERT_EQ(id, 1ull << 40);
+  ASSERT_FALSE(bitmap.select(3, id));
+  ASSERT_TRUE(bitmap.erase(5));
+  ASSERT_FALSE(bitmap.erase(5));
+  ASSERT_EQ(bitmap.size(), 2u);
+  bitmap.clear();
+  ASSERT_TRUE(bitmap.empty());
+  ASSERT_TRUE(bitmap.begin() == bitmap.end());
+}
+
+TEST(FileBitmap, SameAsSet)
+{
+  // Sparse and dense ids so that chunks switch between array and bitmap
+  std::mt19937_64 gen(42);
+  eos::FileBitmap a, b;
+  std::set<uint64_t> sa, sb;
+
+  for (int i = 0; i < 50000; ++i) {
+    uint64_t x = gen() % 10000000;
+    uint64_t y = gen() % 10000000;
+    ASSERT_EQ(a.insert(x), sa.insert(x).second);
+    ASSERT_EQ(b.insert(y), sb.insert(y).second);
+  }
+
+  for (uint64_t x = 200000; x < 230000; ++x) {
+    a.insert(x);
+    sa.insert(x);
+
+    if (x % 3) {
+      b.insert(x);
+      sb.insert(x);
+    }
+  }
+
+  for (int i = 0; i < 20000; ++i) {
+    uint64_t x = gen() % 10000000;
+    ASSERT_EQ(a.erase(x), sa.erase(x) > 0);
+  }
+
+  for (uint64_t x = 200000; x < 229000; ++x) {
+    if (x % 5) {
+      ASSERT_EQ(a.erase(x), sa.erase(x) > 0);
+    }
+  }
+
+  ASSERT_EQ(a.size(), sa.size());
+  ASSERT_EQ(std::vector<uint64_t>(a.begin(), a.end()),
+            std::vector<uint64_t>(sa.begin(), sa.end()));
+  std::vector<uint64_t> visited;
+  a.forEach([&](uint64_t x) {
+    visited.push_back(x);
+  });
+  ASSERT_EQ(visited, std::vector<uint64_t>(sa.begin(), sa.end()));
+
+  for (int i = 0; i < 10000; ++i) {
+    uint64_t x = gen() % 10000000;
+    ASSERT_EQ(a.contains(x), sa.count(x) > 0);
+  }
+
+  std::vector<uint64_t> both, only_a;
+  std::set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(),
+                        std::back_inserter(both));
+  std::set_difference(sa.begin(), sa.end(), sb.begin(), sb.end(),
+                      std::back_inserter(only_a));
+  eos::FileBitmap inter = eos::FileBitmap::intersect(a, b);
+  eos::FileBitmap diff = eos::FileBitmap::difference(a, b);
+  ASSERT_EQ(std::vector<uint64_t>(inter.begin(), inter.end()), both);
+  ASSERT_EQ(inter.size(), both.size());
+  ASSERT_EQ(std::vector<uint64_t>(diff.begin(), diff.end()), only_a);
+  ASSERT_EQ(diff.size(), only_a.size());
+  ASSERT_EQ(eos::FileBitmap::intersectionSize(a, b), both.size());
+}
+
+TEST(FileBitmap, Compression)
+{
+  // One replica out of four on this filesystem
+  eos::FileBitmap bitmap;
+
+  for (uint64_t fid = 1; fid < 4000000; fid += 4) {
+    bitmap.insert(fid);
+  }
+
+  ASSERT_EQ(bitmap.size(), 1000000u);
+  ASSERT_LT(bitmap.getMemoryUsage(), 1000000u);
+}
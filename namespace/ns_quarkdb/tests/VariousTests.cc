@@ -25,6 +25,7 @@
 #include <gtest/gtest.h>
 
 #include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
+#include "namespace/ns_quarkdb/explorer/ParallelNamespaceExplorer.hh"
 #include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
 #include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
 #include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
@@ -32,16 +33,19 @@
 #include "namespace/ns_quarkdb/views/HierarchicalView.hh"
 #include "namespace/ns_quarkdb/accounting/FileSystemView.hh"
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
+#include "namespace/ns_quarkdb/Constants.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
 #include "namespace/ns_quarkdb/ContainerMD.hh"
 #include "namespace/common/QuotaNodeCore.hh"
 #include "namespace/utils/Checksum.hh"
 #include "namespace/utils/Etag.hh"
+#include "namespace/utils/TreeHash.hh"
 #include "namespace/utils/Attributes.hh"
 #include "namespace/PermissionHandler.hh"
 #include "namespace/Resolver.hh"
 #include "TestUtils.hh"
 #include <folly/futures/Future.h>
+#include <thread>
 
 using namespace eos;
 
@@ -358,6 +362,41 @@ TEST_F(VariousTests, createFile) {
   ASSERT_THROW(view()->createFile("/eos/dev/user/my-file/aaaa"), eos::MDException);
 }
 
+TEST_F(VariousTests, CacheInvalidationPublish) {
+  fileSvc()->configure({{constants::sCacheInvalidation, "publish"}});
+  ASSERT_THROW(fileSvc()->configure({{constants::sCacheInvalidation, "bogus"}}),
+               eos::MDException);
+
+  IContainerMDPtr cont = view()->createContainer("/eos/dev/user", true);
+  containerSvc()->updateStore(cont.get());
+  IFileMDPtr myFile = view()->createFile("/eos/dev/user/my-file");
+  fileSvc()->updateStore(myFile.get());
+
+  // Wait for one publishing round to go through the flusher
+  std::this_thread::sleep_for(std::chrono::seconds(2));
+  mdFlusher()->synchronize();
+
+  qclient::redisReplyPtr reply = qcl().exec("GET",
+                                 constants::sCacheInvalidationSeqKey).get();
+  ASSERT_EQ(reply->type, REDIS_REPLY_STRING);
+  std::string seq(reply->str, reply->len);
+  seq = seq.substr(0, seq.find(':'));
+
+  std::string batches;
+  for (int i = 0; i < 2; i++) {
+    reply = qcl().exec("HGET", constants::sCacheInvalidationKey,
+                       std::to_string(std::stoull(seq) - i)).get();
+
+    if (reply->type == REDIS_REPLY_STRING) {
+      batches += std::string(reply->str, reply->len) + ",";
+    }
+  }
+
+  ASSERT_NE(batches.find(SSTR("f" << myFile->getId() << ",")), std::string::npos);
+  ASSERT_NE(batches.find(SSTR("c" << cont->getId() << ",")), std::string::npos);
+  fileSvc()->configure({{constants::sCacheInvalidation, "off"}});
+}
+
 TEST_F(VariousTests, createContainerMadness) {
   containerSvc()->updateStore(view()->createContainer("/eos/dev/../dev/", true).get());
   containerSvc()->updateStore(view()->createContainer(
@@ -473,7 +512,7 @@ TEST_F(VariousTests, EtagFormatting) {
   file1->setCTime(mtime);
 
   eos::QuarkFileMD *file1f = reinterpret_cast<QuarkFileMD*>(file1.get());
-  file1f->mFile.set_id(4697755903ull);
+  file1f->mFile.mId = 4697755903ull;
 
   // File has no checksum, using inode + modification time.
   std::string outcome;
@@ -492,7 +531,7 @@ TEST_F(VariousTests, EtagFormatting) {
   char buff[4];
   buff[0] = 0xa7; buff[1] = 0x25; buff[2] = 0x99; buff[3] = 0x97;
   file1->setChecksum(buff, 4);
-  file1f->mFile.set_id(4697755939ull);
+  file1f->mFile.mId = 4697755939ull;
 
   unsigned long layout = eos::common::LayoutId::GetId(
     eos::common::LayoutId::kReplica,
@@ -555,6 +594,47 @@ TEST_F(VariousTests, EtagFormattingContainer) {
 
 }
 
+TEST_F(VariousTests, TreeHash) {
+  std::shared_ptr<eos::IContainerMD> dir = view()->createContainer("/dir/", true);
+  std::shared_ptr<eos::IContainerMD> sub = view()->createContainer("/dir/sub/", true);
+  std::shared_ptr<eos::IFileMD> file1 = view()->createFile("/dir/file1", true);
+  std::shared_ptr<eos::IFileMD> file2 = view()->createFile("/dir/file2", true);
+  file1->setSize(10);
+  file2->setSize(20);
+  sub->setTreeHash(1234);
+
+  uint64_t hash = eos::TreeHash::Compute(dir, fileSvc(), containerSvc());
+  ASSERT_EQ(hash, eos::TreeHash::FileEntry(file1.get()) +
+            eos::TreeHash::FileEntry(file2.get()) +
+            eos::TreeHash::ContainerEntry("sub", 1234));
+
+  // Every attribute covered changes the entry of a file
+  uint64_t entry = eos::TreeHash::FileEntry(file1.get());
+  file1->setSize(11);
+  ASSERT_NE(entry, eos::TreeHash::FileEntry(file1.get()));
+  entry = eos::TreeHash::FileEntry(file1.get());
+
+  eos::IFileMD::ctime_t mtime;
+  mtime.tv_sec = 1537360812;
+  mtime.tv_nsec = 0;
+  file1->setMTime(mtime);
+  ASSERT_NE(entry, eos::TreeHash::FileEntry(file1.get()));
+  entry = eos::TreeHash::FileEntry(file1.get());
+
+  char buff[4] = { 0x01, 0x02, 0x03, 0x04 };
+  file1->setChecksum(buff, 4);
+  ASSERT_NE(entry, eos::TreeHash::FileEntry(file1.get()));
+
+  // A change of one child is applied by swapping its entry
+  hash = eos::TreeHash::Compute(dir, fileSvc(), containerSvc());
+  uint64_t old_entry = eos::TreeHash::ContainerEntry("sub", 1234);
+  sub->setTreeHash(5678);
+  ASSERT_EQ(eos::TreeHash::Compute(dir, fileSvc(), containerSvc()),
+            hash - old_entry + eos::TreeHash::ContainerEntry("sub", 5678));
+
+  ASSERT_EQ(eos::TreeHash::ToHex(0xabc), "0000000000000abc");
+}
+
 TEST_F(FileMDFetching, ExistenceTest) {
   std::shared_ptr<eos::IContainerMD> root = view()->getContainer("/");
   ASSERT_EQ(root->getId(), 1);
@@ -812,6 +892,93 @@ TEST_F(NamespaceExplorerF, ExpansionDecider) {
   ASSERT_FALSE(explorer.fetch(item));
 }
 
+//------------------------------------------------------------------------------
+// Collect all paths found by the parallel explorer, marking directories
+//------------------------------------------------------------------------------
+static std::set<std::string> exploreParallel(const std::string& path,
+  const ParallelExplorationOptions& options, qclient::QClient& qcl)
+{
+  std::set<std::string> paths;
+  ParallelNamespaceExplorer explorer(path, options, qcl);
+  std::vector<NamespaceItem> chunk;
+
+  while (explorer.fetch(chunk)) {
+    EXPECT_FALSE(chunk.empty());
+    EXPECT_LE(chunk.size(), options.chunkSize);
+
+    for (const auto& item : chunk) {
+      EXPECT_TRUE(paths.insert(item.fullPath).second);
+    }
+  }
+
+  return paths;
+}
+
+TEST_F(NamespaceExplorerF, Parallel) {
+  populateDummyData1();
+
+  ExplorationOptions options;
+  options.depthLimit = 999;
+  std::set<std::string> expected;
+  NamespaceExplorer explorer("/eos", options, qcl());
+  NamespaceItem item;
+
+  while (explorer.fetch(item)) {
+    expected.insert(item.fullPath);
+  }
+
+  ParallelExplorationOptions poptions;
+  poptions.threads = 4;
+  poptions.chunkSize = 3;
+  poptions.maxChunks = 2;
+  poptions.fileWindow = 2;
+  ASSERT_EQ(exploreParallel("/eos", poptions, qcl()), expected);
+
+  // Find on single file
+  ASSERT_EQ(exploreParallel("/eos/d2/d3-2/my-file", poptions, qcl()),
+            std::set<std::string> {"/eos/d2/d3-2/my-file"});
+
+  // Invalid path
+  ASSERT_THROW(eos::ParallelNamespaceExplorer("/eos/invalid/path", poptions, qcl()), eos::MDException);
+
+  // Depth limit
+  poptions.depthLimit = 1;
+  std::set<std::string> predicted {"/eos/d2/", "/eos/d2/asdf1",
+    "/eos/d2/asdf2", "/eos/d2/asdf3", "/eos/d2/b", "/eos/d2/zzzzz1",
+    "/eos/d2/zzzzz2", "/eos/d2/zzzzz3", "/eos/d2/zzzzz4", "/eos/d2/zzzzz5",
+    "/eos/d2/zzzzz6", "/eos/d2/d3-1/", "/eos/d2/d3-2/", "/eos/d2/d4/"};
+  ASSERT_EQ(exploreParallel("/eos/d2", poptions, qcl()), predicted);
+
+  // Server-side file predicates, containers are always returned
+  poptions.depthLimit = 0;
+  poptions.fileFilter.reset(new FileFilter());
+  poptions.fileFilter->attrKey = "user.not-there";
+  poptions.fileFilter->attrValue = "x";
+  ASSERT_EQ(exploreParallel("/eos/d2/d4", poptions, qcl()),
+            (std::set<std::string> {"/eos/d2/d4/", "/eos/d2/d4/1/", "/eos/d2/d4/1/2/",
+              "/eos/d2/d4/1/2/3/", "/eos/d2/d4/1/2/3/4/", "/eos/d2/d4/1/2/3/4/5/",
+              "/eos/d2/d4/1/2/3/4/5/6/", "/eos/d2/d4/1/2/3/4/5/6/7/"}));
+
+  poptions.fileFilter.reset(new FileFilter());
+  poptions.fileFilter->minSize = 1;
+  ASSERT_EQ(exploreParallel("/eos/d2/d3-2", poptions, qcl()),
+            std::set<std::string> {"/eos/d2/d3-2/"});
+  poptions.fileFilter->minSize = 0;
+  poptions.fileFilter->maxSize = 0;
+  ASSERT_EQ(exploreParallel("/eos/d2/d3-2", poptions, qcl()),
+            (std::set<std::string> {"/eos/d2/d3-2/", "/eos/d2/d3-2/my-file"}));
+
+  // Destroying the explorer before consuming must not hang
+  poptions.fileFilter.reset();
+  poptions.maxChunks = 1;
+  poptions.chunkSize = 1;
+  {
+    ParallelNamespaceExplorer pexplorer("/eos", poptions, qcl());
+    std::vector<NamespaceItem> chunk;
+    ASSERT_TRUE(pexplorer.fetch(chunk));
+  }
+}
+
 TEST_F(VariousTests, LinkedExtendedAttributes) {
   IContainerMDPtr cont1 = view()->createContainer("/eos/dir1", true);
   IContainerMDPtr cont2 = view()->createContainer("/eos/dir1/dir2", true);
@@ -27,17 +27,113 @@
 #include "namespace/utils/StringConvertion.hh"
 #include "namespace/utils/DataHelper.hh"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
+#include <atomic>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
 
 // Static global variable
 static std::string sBkndHost;
 static std::int32_t sBkndPort;
-static long long int sAsyncBatch = 1023;
+static long long int sAsyncBatch = 4095;
 static qclient::QClient* sQcl;
 static qclient::AsyncHandler sAh;
 static size_t sThreads = 1;
+static eos::ConvertCheckpoint sCheckpoint;
 
 EOSNSNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+//           ************* ConvertCheckpoint Class ************
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+ConvertCheckpoint::~ConvertCheckpoint()
+{
+  if (mFd != -1) {
+    (void) close(mFd);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Open the checkpoint file
+//------------------------------------------------------------------------------
+bool
+ConvertCheckpoint::Open(const std::string& path, const std::string& signature)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::ifstream in(path);
+  std::string line;
+
+  if (in.good() && std::getline(in, line) && (line == signature)) {
+    // Skip a last line without newline, its write was interrupted
+    while (std::getline(in, line) && !in.eof()) {
+      if (!line.empty()) {
+        mDone.insert(line);
+      }
+    }
+  }
+
+  in.close();
+  mNumResumed = mDone.size();
+  // Rewrite the file so that new entries never follow a partial line
+  std::string content = signature + "\n";
+
+  for (const auto& step : mDone) {
+    content += step;
+    content += "\n";
+  }
+
+  mFd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+
+  if (mFd == -1) {
+    return false;
+  }
+
+  if ((write(mFd, content.c_str(), content.length()) !=
+       (ssize_t)content.length()) || fsync(mFd)) {
+    (void) close(mFd);
+    mFd = -1;
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Check if a step was completed by a previous run
+//------------------------------------------------------------------------------
+bool
+ConvertCheckpoint::IsDone(const std::string& step) const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return (mDone.find(step) != mDone.end());
+}
+
+//------------------------------------------------------------------------------
+// Record a completed step
+//------------------------------------------------------------------------------
+void
+ConvertCheckpoint::MarkDone(const std::string& step)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (!mDone.insert(step).second || (mFd == -1)) {
+    return;
+  }
+
+  std::string entry = step + "\n";
+
+  // A lost entry only means the step is redone by the next run
+  if ((write(mFd, entry.c_str(), entry.length()) != (ssize_t)entry.length()) ||
+      fsync(mFd)) {
+    std::cerr << "WARNING: failed to record checkpoint step " << step
+              << std::endl;
+  }
+}
+
 //------------------------------------------------------------------------------
 //           ************* ConvertFileMD Class ************
 //------------------------------------------------------------------------------
@@ -207,7 +303,7 @@ ConvertContainerMD::commitSubcontainers(qclient::AsyncHandler& ah,
 {
   uint32_t num_batches = 0u;
   uint32_t max_batches = 10u;
-  uint32_t max_per_batch = 100u;
+  uint32_t max_per_batch = 1000u;
   uint32_t count = 0u;
   std::vector<std::string> cmd;
   cmd.reserve(max_per_batch * 2 + 2);
@@ -254,7 +350,7 @@ ConvertContainerMD::commitFiles(qclient::AsyncHandler& ah,
 {
   uint32_t num_batches = 0u;
   uint32_t max_batches = 10u;
-  uint32_t max_per_batch = 100u;
+  uint32_t max_per_batch = 1000u;
   uint32_t count = 0u;
   std::vector<std::string> cmd;
   cmd.reserve(max_per_batch * 2 + 2);
@@ -473,6 +569,14 @@ ConvertContainerMDSvc::commitToBackend()
   int last_chunk = chunk + total - (chunk * nthreads);
   // Parallel loop
   eos::common::Parallel::For(0, nthreads, [&](int i) {
+    const std::string ckpt_step =
+      ConvertCheckpoint::ShardStep("containers", i, nthreads);
+
+    if (sCheckpoint.IsDone(ckpt_step)) {
+      std::cout << "Skipping committed step " << ckpt_step << std::endl;
+      return;
+    }
+
     std::int64_t count = 0;
     qclient::AsyncHandler ah;
     eos::ConvertContainerMD* conv_cont = nullptr;
@@ -542,6 +646,8 @@ ConvertContainerMDSvc::commitToBackend()
                 << "ERROR: Failed to commit to backend" << std::endl;
       std::terminate();
     }
+
+    sCheckpoint.MarkDone(ckpt_step);
   });
 }
 
@@ -604,6 +710,11 @@ ConvertFileMDSvc::initialize()
   mFirstFreeId = scanner.getLargestId() + 1;
   // Recreate the files
   eos::common::Parallel::For(0, nthreads, [&](int i) noexcept {
+    // The files are always loaded to rebuild the in-memory namespace, the
+    // writes are skipped if the shard was committed by a previous run
+    const std::string ckpt_step =
+      ConvertCheckpoint::ShardStep("files", i, nthreads);
+    const bool commit = !sCheckpoint.IsDone(ckpt_step);
     std::int64_t count = 0;
     IdMap::iterator it = pIdMap.begin();
     std::advance(it, i * chunk);
@@ -653,6 +764,7 @@ ConvertFileMDSvc::initialize()
       if (!cont || (file->getContainerId() == 0)) {
         std::lock_guard<std::mutex> lock(mutex_lost_found);
         attachBroken("orphans", file.get());
+        // Always written, the lost+found container may differ between runs
         addFileToQdb((ConvertFileMD*)file.get(), ah, qclient);
         continue;
       }
@@ -671,7 +783,11 @@ ConvertFileMDSvc::initialize()
       } else {
         cont->addFile(file.get());
         mtx->unlock();
-        addFileToQdb((ConvertFileMD*)file.get(), ah, qclient);
+
+        if (commit) {
+          addFileToQdb((ConvertFileMD*)file.get(), ah, qclient);
+        }
+
         // Populate the FileSystemView and QuotaView
         mConvQView->addQuotaInfo(file.get());
         mConvFsView->addFileInfo(file.get());
@@ -695,6 +811,10 @@ ConvertFileMDSvc::initialize()
       std::cerr << "ERROR: Failed to commit to backend" << std::endl;
       std::terminate();
     }
+
+    if (commit) {
+      sCheckpoint.MarkDone(ckpt_step);
+    }
   });
   // Propagate any remaining updates
   mSyncTimeAcc->PropagateUpdates();
@@ -826,57 +946,83 @@ ConvertQuotaView::addQuotaInfo(IFileMD* file)
 void
 ConvertQuotaView::commitToBackend()
 {
-  qclient::AsyncHandler ah;
-  qclient::Options opts;
-  opts.transparentRedirects = true;
-  opts.retryStrategy = qclient::RetryStrategy::NoRetries();
-  qclient::QClient qcl(sBkndHost, sBkndPort, std::move(opts));
-  std::string uid_key, gid_key;
-  std::uint64_t count = 0u;
-  std::uint64_t max_count = 100;
-
-  for (auto it = mQuotaMap.begin(); it != mQuotaMap.end(); ++it) {
-    ++count;
-    uid_key = KeyQuotaUidMap(it->first);
-    gid_key = KeyQuotaGidMap(it->first);
-    QuotaNodeMapT& uid_map = it->second.first;
-    QuotaNodeMapT& gid_map = it->second.second;
-    qclient::QHash quota_map(*sQcl, uid_key);
-
-    for (auto& elem : uid_map) {
-      eos::QuotaNodeCore::UsageInfo& info = elem.second;
-      std::string field = elem.first + quota::sPhysicalSize;
-      quota_map.hset_async(field, info.physicalSpace, &ah);
-      field = elem.first + quota::sLogicalSize;
-      quota_map.hset_async(field, info.space, &ah);
-      field = elem.first + quota::sNumFiles;
-      quota_map.hset_async(field, info.files, &ah);
+  std::uint64_t total = mQuotaMap.size();
+  int nthreads = sThreads;
+  int chunk = total / nthreads;
+  int last_chunk = chunk + total - (chunk * nthreads);
+  std::atomic<bool> failed {false};
+  // Parallel loop over the quota nodes, one connection per thread
+  eos::common::Parallel::For(0, nthreads, [&](int i) {
+    const std::string ckpt_step =
+      ConvertCheckpoint::ShardStep("quota", i, nthreads);
+
+    if (sCheckpoint.IsDone(ckpt_step)) {
+      std::cout << "Skipping committed step " << ckpt_step << std::endl;
+      return;
     }
 
-    quota_map.setKey(gid_key);
+    qclient::AsyncHandler ah;
+    qclient::Options opts;
+    opts.transparentRedirects = true;
+    opts.retryStrategy = qclient::RetryStrategy::NoRetries();
+    qclient::QClient qcl(sBkndHost, sBkndPort, std::move(opts));
+    qclient::QHash quota_map(qcl, "");
+    std::string uid_key, gid_key;
+    std::uint64_t num_requests = 0u;
+    int max_elem = (i == (nthreads - 1) ? last_chunk : chunk);
+    auto it = mQuotaMap.begin();
+    std::advance(it, i * chunk);
 
-    for (auto& elem : gid_map) {
-      eos::QuotaNodeCore::UsageInfo& info = elem.second;
-      std::string field = elem.first + quota::sPhysicalSize;
-      quota_map.hset_async(field, info.physicalSpace, &ah);
-      field = elem.first + quota::sLogicalSize;
-      quota_map.hset_async(field, info.space, &ah);
-      field = elem.first + quota::sNumFiles;
-      quota_map.hset_async(field, info.files, &ah);
-    }
+    for (int n = 0; n < max_elem; ++n, ++it) {
+      uid_key = KeyQuotaUidMap(it->first);
+      gid_key = KeyQuotaGidMap(it->first);
+      QuotaNodeMapT& uid_map = it->second.first;
+      QuotaNodeMapT& gid_map = it->second.second;
+      quota_map.setKey(uid_key);
+
+      for (auto& elem : uid_map) {
+        eos::QuotaNodeCore::UsageInfo& info = elem.second;
+        std::string field = elem.first + quota::sPhysicalSize;
+        quota_map.hset_async(field, info.physicalSpace, &ah);
+        field = elem.first + quota::sLogicalSize;
+        quota_map.hset_async(field, info.space, &ah);
+        field = elem.first + quota::sNumFiles;
+        quota_map.hset_async(field, info.files, &ah);
+      }
 
-    if (count >= max_count) {
-      count = 0u;
+      quota_map.setKey(gid_key);
 
-      if (!ah.Wait()) {
-        std::cerr << __FUNCTION__ << " Got error response from the backend "
-                  << "while exporting the quota view" << std::endl;
-        std::terminate();
+      for (auto& elem : gid_map) {
+        eos::QuotaNodeCore::UsageInfo& info = elem.second;
+        std::string field = elem.first + quota::sPhysicalSize;
+        quota_map.hset_async(field, info.physicalSpace, &ah);
+        field = elem.first + quota::sLogicalSize;
+        quota_map.hset_async(field, info.space, &ah);
+        field = elem.first + quota::sNumFiles;
+        quota_map.hset_async(field, info.files, &ah);
+      }
+
+      num_requests += 3 * (uid_map.size() + gid_map.size());
+
+      if (num_requests > (std::uint64_t)sAsyncBatch) {
+        num_requests = 0u;
+
+        if (!ah.Wait()) {
+          failed = true;
+          return;
+        }
       }
     }
-  }
 
-  if (!ah.Wait()) {
+    if (!ah.Wait()) {
+      failed = true;
+      return;
+    }
+
+    sCheckpoint.MarkDone(ckpt_step);
+  });
+
+  if (failed) {
     std::cerr << __FUNCTION__ << " Got error response from the backend "
               << "while exporting the quota view" << std::endl;
     std::terminate();
@@ -934,6 +1080,14 @@ ConvertFsView::commitToBackend()
   int max_sadd_size = 1000;
   // Parallel loop
   eos::common::Parallel::For(0, nthreads, [&](int i) {
+    const std::string ckpt_step =
+      ConvertCheckpoint::ShardStep("fsview", i, nthreads);
+
+    if (sCheckpoint.IsDone(ckpt_step)) {
+      std::cout << "Skipping committed step " << ckpt_step << std::endl;
+      return;
+    }
+
     std::uint64_t count = 0u;
     std::string key, val;
     qclient::AsyncHandler ah;
@@ -1055,6 +1209,8 @@ ConvertFsView::commitToBackend()
                 << std::endl;
       std::terminate();
     }
+
+    sCheckpoint.MarkDone(ckpt_step);
   });
 }
 
@@ -1072,7 +1228,15 @@ usage()
             << "    dir_chlog  - directory changelog              " << std::endl
             << "    bknd_host  - Backend host destination         " << std::endl
             << "    bknd_port  - Backend port destination         " << std::endl
-            << std::endl;
+            << std::endl
+            << "Environment:                                      " << std::endl
+            << "    CONVERSION_THREADS    - number of threads and backend "
+            << "connections, default the number of cores" << std::endl
+            << "    CONVERSION_BATCH      - requests in flight per connection "
+            << "(rounded to a power of two), default 4096" << std::endl
+            << "    CONVERSION_CHECKPOINT - checkpoint file used to resume an "
+            << "interrupted conversion, default <file_chlog>.convert.checkpoint"
+            << std::endl << std::endl;
 }
 //------------------------------------------------------------------------------
 // Main function
@@ -1087,8 +1251,23 @@ main(int argc, char* argv[])
     sThreads = atoi(conversionThreads);
   }
 
-  std::cerr << "Using " << sThreads << " parallel threads for conversion" <<
-            std::endl;
+  const char* conversionBatch = getenv("CONVERSION_BATCH");
+
+  if (conversionBatch) {
+    // Used as a mask to decide when to wait for the replies
+    long long int batch = std::max(2ll, atoll(conversionBatch));
+    sAsyncBatch = 1;
+
+    while (sAsyncBatch < batch) {
+      sAsyncBatch <<= 1;
+    }
+
+    --sAsyncBatch;
+  }
+
+  std::cerr << "Using " << sThreads << " parallel threads for conversion "
+            << "with " << sAsyncBatch + 1 << " requests in flight per thread"
+            << std::endl;
 
   if (argc != 5) {
     usage();
@@ -1126,6 +1305,9 @@ main(int argc, char* argv[])
     struct stat info = {0};
     std::list<std::string> lst_files {file_chlog, dir_chlog};
 
+    std::ostringstream signature;
+    signature << "backend=" << sBkndHost << ":" << sBkndPort;
+
     for (auto& fn : lst_files) {
       int ret = stat(fn.c_str(), &info);
 
@@ -1133,6 +1315,25 @@ main(int argc, char* argv[])
         std::cerr << "Unable to access file: " << fn << std::endl;
         return EIO;
       }
+
+      signature << " " << fn << "=" << info.st_size << ":" << info.st_mtime;
+    }
+
+    const char* checkpoint_env = getenv("CONVERSION_CHECKPOINT");
+    std::string checkpoint_path = (checkpoint_env ? checkpoint_env :
+                                   file_chlog + ".convert.checkpoint");
+
+    if (!sCheckpoint.Open(checkpoint_path, signature.str())) {
+      std::cerr << "WARNING: failed to open checkpoint file " << checkpoint_path
+                << ", an interrupted conversion will have to restart" << std::endl;
+    } else if (sCheckpoint.IsDone("finalize")) {
+      std::cout << "Conversion already completed according to checkpoint "
+                << checkpoint_path << std::endl;
+      return 0;
+    } else if (sCheckpoint.GetNumResumed()) {
+      std::cout << "Resuming conversion, " << sCheckpoint.GetNumResumed()
+                << " steps already committed according to checkpoint "
+                << checkpoint_path << std::endl;
     }
 
     std::time_t start = std::time(nullptr);
@@ -1226,6 +1427,7 @@ main(int argc, char* argv[])
     // QuarkDB bulkload finalization (triggers manual compaction in rocksdb)
     std::time_t finalizeStart = std::time(nullptr);
     sQcl->exec("quarkdb_bulkload_finalize").get();
+    sCheckpoint.MarkDone("finalize");
     std::time_t finalizeEnd = std::time(nullptr);
     std::cout << "QuarkDB bulkload finalization: " << finalizeEnd - finalizeStart <<
               " seconds" << std::endl;
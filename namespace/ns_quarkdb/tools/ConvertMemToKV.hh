@@ -35,11 +35,78 @@
 #include "proto/ContainerMd.pb.h"
 #include "proto/FileMd.pb.h"
 #include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
 
 EOSNSNAMESPACE_BEGIN
 
 using QuotaNodeMapT = std::map<std::string, eos::QuotaNodeCore::UsageInfo>;
 
+//------------------------------------------------------------------------------
+//! Class ConvertCheckpoint - records in a local file the conversion steps
+//! which were fully acknowledged by the backend, so that an interrupted
+//! conversion only redoes the missing ones. The in-memory namespace still has
+//! to be rebuilt on every run, only the writes to the backend are skipped.
+//! All written commands are idempotent so redoing a step is always safe.
+//!
+//! The first line of the file is a signature of the conversion (backend and
+//! changelogs), a checkpoint with another signature is discarded.
+//------------------------------------------------------------------------------
+class ConvertCheckpoint
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~ConvertCheckpoint();
+
+  //----------------------------------------------------------------------------
+  //! Open the checkpoint file, loading the completed steps if the signature
+  //! matches otherwise starting a new checkpoint
+  //!
+  //! @param path checkpoint file path
+  //! @param signature signature of the conversion
+  //!
+  //! @return true if new steps can be recorded, otherwise false
+  //----------------------------------------------------------------------------
+  bool Open(const std::string& path, const std::string& signature);
+
+  //----------------------------------------------------------------------------
+  //! Check if a step was completed by a previous run
+  //----------------------------------------------------------------------------
+  bool IsDone(const std::string& step) const;
+
+  //----------------------------------------------------------------------------
+  //! Record a completed step, synced to disk before returning
+  //----------------------------------------------------------------------------
+  void MarkDone(const std::string& step);
+
+  //----------------------------------------------------------------------------
+  //! Get number of steps completed by previous runs
+  //----------------------------------------------------------------------------
+  size_t GetNumResumed() const
+  {
+    return mNumResumed;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the step name of a shard e.g. files:3/16
+  //----------------------------------------------------------------------------
+  static std::string ShardStep(const std::string& phase, int shard,
+                               int num_shards)
+  {
+    return phase + ":" + std::to_string(shard) + "/" +
+           std::to_string(num_shards);
+  }
+
+private:
+  mutable std::mutex mMutex; ///< Mutex protecting the members
+  std::set<std::string> mDone; ///< Completed steps
+  size_t mNumResumed {0}; ///< Steps loaded from the file
+  int mFd {-1}; ///< Checkpoint file descriptor, -1 if checkpointing is off
+};
+
 //------------------------------------------------------------------------------
 //! Class ConvertQuotaView
 //------------------------------------------------------------------------------
@@ -376,6 +443,7 @@ private:
   //------------------------------------------------------------------------------
   void addFileToQdb(ConvertFileMD* file, qclient::AsyncHandler& ah,
                     qclient::QClient& qclient) const;
+  }
 
   IFileMD::id_t mFirstFreeId; ///< First free file id
   ConvertQuotaView* mConvQView; ///< Quota view object
@@ -17,6 +17,7 @@
  ************************************************************************/
 
 #include "EosDumpProtoMd.hh"
+#include "NsDumpFormat.hh"
 #include "proto/ContainerMd.pb.h"
 #include "proto/FileMd.pb.h"
 #include "namespace/ns_quarkdb/FileMD.hh"
@@ -26,8 +27,16 @@
 #include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
 #include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
+#include "namespace/ns_quarkdb/persistency/RequestBuilder.hh"
 #include "common/StringTokenizer.hh"
 #include <getopt.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
 
 int main(int argc, char* argv[])
 {
@@ -36,6 +45,10 @@ int main(int argc, char* argv[])
   uint64_t id {0};
   bool is_file = true;
   int print_help = 0;
+  int compress = 0;
+  int buckets = 0;
+  std::string export_path;
+  uint32_t num_threads = std::max(1u, std::thread::hardware_concurrency());
 
   while (true) {
     static struct option long_options[] = {
@@ -44,11 +57,15 @@ int main(int argc, char* argv[])
       {"cid", required_argument, 0, 'c'},
       {"host", required_argument, 0, 'h'},
       {"port", required_argument, 0, 'p'},
+      {"export", required_argument, 0, 'e'},
+      {"threads", required_argument, 0, 't'},
+      {"compress", no_argument, &compress, 1},
+      {"buckets", no_argument, &buckets, 1},
       {0, 0, 0, 0}
     };
     // getopt_long stores the option index there
     int option_index = 0;
-    int c = getopt_long(argc, argv, "f:c:h:p:", long_options, &option_index);
+    int c = getopt_long(argc, argv, "f:c:h:p:e:t:", long_options, &option_index);
     std::string soptarg;
 
     // Detect end of the options
@@ -111,16 +128,44 @@ int main(int argc, char* argv[])
       break;
     }
 
+    case 'e': {
+      export_path = optarg;
+      break;
+    }
+
+    case 't': {
+      soptarg = optarg;
+
+      try {
+        num_threads = std::stoul(soptarg);
+      } catch (const std::exception& e) {
+        num_threads = 0;
+      }
+
+      if (num_threads == 0) {
+        std::cerr << "error: threads must be a positive numeric value"
+                  << std::endl;
+        return usage_help();
+      }
+
+      break;
+    }
+
     default:
       std::cerr << "Unknown option: " << (char) c << std::endl;
       return usage_help();
     }
   }
 
-  if (print_help || !id) {
+  if (print_help || (!id && export_path.empty())) {
     return usage_help();
   }
 
+  if (!export_path.empty()) {
+    return ExportNamespace(qdb_host, qdb_port, export_path, num_threads,
+                           compress, buckets);
+  }
+
   qclient::QClient* qcl = eos::BackendClient::getInstance(eos::QdbContactDetails(qclient::Members(qdb_host, qdb_port), ""));
 
   try {
@@ -155,6 +200,257 @@ std::string DumpProto(qclient::QClient* qcl, uint64_t id, bool is_file)
   return output;
 }
 
+//------------------------------------------------------------------------------
+//! Counters of an export
+//------------------------------------------------------------------------------
+struct ExportStats {
+  std::atomic<uint64_t> mRecords {0};
+  std::atomic<uint64_t> mErrors {0};
+};
+
+//------------------------------------------------------------------------------
+//! Create the connection of an export thread
+//------------------------------------------------------------------------------
+static std::unique_ptr<qclient::QClient>
+MakeExportClient(const std::string& qdb_host, uint32_t qdb_port)
+{
+  qclient::Options opts;
+  opts.transparentRedirects = true;
+  opts.retryStrategy = qclient::RetryStrategy::WithTimeout(
+                         std::chrono::seconds(60));
+  return std::unique_ptr<qclient::QClient>(new qclient::QClient(
+           qclient::Members(qdb_host, qdb_port), std::move(opts)));
+}
+
+//------------------------------------------------------------------------------
+//! Add a serialized protobuf to the block, writing out the block once full
+//------------------------------------------------------------------------------
+static void
+AddRecord(eos::NsDumpWriter& writer, eos::NsDumpBlock& block,
+          ExportStats& stats, const char* data, size_t len)
+{
+  block.add(data, len);
+  ++stats.mRecords;
+
+  if (block.full()) {
+    if (!writer.writeBlock(block)) {
+      ++stats.mErrors;
+    }
+
+    block.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+//! Export thread for the locality hash layout - takes ranges of ids and
+//! pipelines the lookups of a whole range on its connection
+//------------------------------------------------------------------------------
+static void
+ExportIdRanges(qclient::QClient& qcl, const std::string& key,
+               eos::NsDump::Kind kind, uint64_t last_id,
+               std::atomic<uint64_t>& next_id, eos::NsDumpWriter& writer,
+               ExportStats& stats)
+{
+  static constexpr uint64_t kIdsPerRange = 10000;
+  eos::NsDumpBlock block(kind);
+  std::vector<std::future<qclient::redisReplyPtr>> replies;
+  replies.reserve(kIdsPerRange);
+
+  while (true) {
+    uint64_t first = next_id.fetch_add(kIdsPerRange);
+
+    if (first > last_id) {
+      break;
+    }
+
+    uint64_t end = std::min(first + kIdsPerRange, last_id + 1);
+    replies.clear();
+
+    for (uint64_t id = first; id < end; ++id) {
+      replies.emplace_back(qcl.exec("LHGET", key, std::to_string(id)));
+    }
+
+    for (auto& fut : replies) {
+      qclient::redisReplyPtr reply = fut.get();
+
+      if (reply && (reply->type == REDIS_REPLY_NIL)) {
+        continue;
+      }
+
+      if (!reply || (reply->type != REDIS_REPLY_STRING)) {
+        ++stats.mErrors;
+        continue;
+      }
+
+      AddRecord(writer, block, stats, reply->str, reply->len);
+    }
+  }
+
+  if (!writer.writeBlock(block)) {
+    ++stats.mErrors;
+  }
+}
+
+//------------------------------------------------------------------------------
+//! Export thread for the hash bucket layout - takes buckets and scans them
+//! in large pages
+//------------------------------------------------------------------------------
+static void
+ExportBuckets(qclient::QClient& qcl, const std::string& suffix,
+              eos::NsDump::Kind kind, uint64_t num_buckets,
+              std::atomic<uint64_t>& next_bucket, eos::NsDumpWriter& writer,
+              ExportStats& stats)
+{
+  eos::NsDumpBlock block(kind);
+  uint64_t bucket;
+
+  while ((bucket = next_bucket++) < num_buckets) {
+    const std::string key = std::to_string(bucket) + suffix;
+    std::string cursor = "0";
+
+    do {
+      qclient::redisReplyPtr reply =
+        qcl.exec("HSCAN", key, cursor, "COUNT", "10000").get();
+
+      if (!reply || (reply->type != REDIS_REPLY_ARRAY) ||
+          (reply->elements != 2) ||
+          (reply->element[0]->type != REDIS_REPLY_STRING) ||
+          (reply->element[1]->type != REDIS_REPLY_ARRAY)) {
+        std::cerr << "error: unexpected response while scanning " << key
+                  << ": " << qclient::describeRedisReply(reply) << std::endl;
+        ++stats.mErrors;
+        break;
+      }
+
+      cursor = std::string(reply->element[0]->str, reply->element[0]->len);
+      redisReply* page = reply->element[1];
+
+      for (size_t i = 1; i < page->elements; i += 2) {
+        if (page->element[i]->type != REDIS_REPLY_STRING) {
+          ++stats.mErrors;
+          continue;
+        }
+
+        AddRecord(writer, block, stats, page->element[i]->str,
+                  page->element[i]->len);
+      }
+    } while (cursor != "0");
+  }
+
+  if (!writer.writeBlock(block)) {
+    ++stats.mErrors;
+  }
+}
+
+//------------------------------------------------------------------------------
+//! Get the last used file or container id from the meta map
+//------------------------------------------------------------------------------
+static uint64_t
+GetLastUsedId(qclient::QClient& qcl, const std::string& field)
+{
+  qclient::redisReplyPtr reply =
+    qcl.exec("HGET", eos::constants::sMapMetaInfoKey, field).get();
+
+  if (!reply) {
+    throw std::runtime_error("QuarkDB backend not available");
+  }
+
+  if (reply->type == REDIS_REPLY_NIL) {
+    return 0;
+  }
+
+  if (reply->type != REDIS_REPLY_STRING) {
+    throw std::runtime_error("unexpected response for " + field + ": " +
+                             qclient::describeRedisReply(reply));
+  }
+
+  return std::stoull(std::string(reply->str, reply->len));
+}
+
+//------------------------------------------------------------------------------
+// Export all file and container metadata to a binary dump file
+//------------------------------------------------------------------------------
+int ExportNamespace(const std::string& qdb_host, uint32_t qdb_port,
+                    const std::string& path, uint32_t num_threads,
+                    bool compress, bool buckets)
+{
+  eos::NsDumpWriter writer;
+
+  if (!writer.open(path, compress)) {
+    std::cerr << "error: failed to create " << path << std::endl;
+    return EIO;
+  }
+
+  std::vector<std::unique_ptr<qclient::QClient>> clients;
+
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    clients.emplace_back(MakeExportClient(qdb_host, qdb_port));
+  }
+
+  ExportStats stats;
+  auto start = std::chrono::steady_clock::now();
+
+  for (auto kind : {
+         eos::NsDump::kContainer, eos::NsDump::kFile
+       }) {
+    const bool is_file = (kind == eos::NsDump::kFile);
+    std::atomic<uint64_t> next {buckets ? 0ull : 1ull};
+    uint64_t limit = 0;
+
+    if (buckets) {
+      limit = (is_file ? eos::RequestBuilder::sNumFileBuckets :
+               eos::RequestBuilder::sNumContBuckets);
+    } else {
+      try {
+        limit = GetLastUsedId(*clients[0], is_file ?
+                              eos::constants::sLastUsedFid :
+                              eos::constants::sLastUsedCid);
+      } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return EIO;
+      }
+    }
+
+    std::vector<std::thread> threads;
+
+    for (uint32_t i = 0; i < num_threads; ++i) {
+      qclient::QClient* qcl = clients[i].get();
+
+      if (buckets) {
+        threads.emplace_back([&, qcl, kind, limit] {
+          ExportBuckets(*qcl, is_file ? eos::constants::sFileKeySuffix :
+                        eos::constants::sContKeySuffix, kind, limit, next,
+                        writer, stats);
+        });
+      } else {
+        threads.emplace_back([&, qcl, kind, limit] {
+          ExportIdRanges(*qcl, is_file ? eos::constants::sFileKey :
+                         eos::constants::sContainerKey, kind, limit, next,
+                         writer, stats);
+        });
+      }
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    std::cout << "Exported " << (is_file ? "files" : "containers")
+              << ", total records " << stats.mRecords << std::endl;
+  }
+
+  if (!writer.close()) {
+    ++stats.mErrors;
+  }
+
+  std::chrono::duration<double> duration =
+    std::chrono::steady_clock::now() - start;
+  std::cout << "Exported " << stats.mRecords << " records to " << path
+            << " in " << duration.count() << " seconds, errors: "
+            << stats.mErrors << std::endl;
+  return (stats.mErrors ? EIO : 0);
+}
+
 //------------------------------------------------------------------------------
 // Pretty print metadata object
 //------------------------------------------------------------------------------
@@ -203,8 +499,19 @@ int usage_help()
   std::cerr << "Usage: eos-dump-proto-md "
             "--fid|--cid <val> [-h|--host <qdb_host>] [-p|--port <qdb_port>] "
             "[--help]" << std::endl
+            << "       eos-dump-proto-md --export <file> [-t|--threads <num>] "
+            "[--compress] [--buckets] [-h|--host <qdb_host>] "
+            "[-p|--port <qdb_port>]" << std::endl
             << "     --fid : decimal file id" << std::endl
             << "     --cid : decimal container id" << std::endl
+            << "  --export : write all file and container protobufs to a "
+            "binary dump file" << std::endl
+            << "-t|--threads : number of export threads and connections, "
+            "default the number of cores" << std::endl
+            << "--compress : zlib compress the blocks of the dump file"
+            << std::endl
+            << " --buckets : scan the hash buckets of the old namespace layout"
+            << std::endl
             << " -h|--host : QuarkDB host, default localhost" << std::endl
             << " -p|--port : QuarkDb port, default 7777" << std::endl
             << "    --help : print help message" << std::endl;
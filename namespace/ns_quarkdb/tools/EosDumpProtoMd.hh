@@ -19,6 +19,7 @@
 #pragma once
 #include "namespace/ns_quarkdb/BackendClient.hh"
 #include <iostream>
+#include <string>
 
 //------------------------------------------------------------------------------
 //! Print command usage info
@@ -44,3 +45,23 @@ std::string DumpProto(qclient::QClient* qcl, uint64_t id, bool is_file);
 //! @param senv string representing info & separator
 //------------------------------------------------------------------------------
 void PrettyPrint(const std::string& senv);
+
+//------------------------------------------------------------------------------
+//! Export all file and container metadata to a binary dump file, see
+//! NsDumpFormat.hh. Every thread uses its own connection and pipelines the
+//! lookups of ranges of ids, or scans whole buckets for the old hash bucket
+//! layout, so that there is no round-trip per entry.
+//!
+//! @param qdb_host QuarkDB host
+//! @param qdb_port QuarkDB port
+//! @param path output file
+//! @param num_threads number of threads and connections
+//! @param compress if true compress the blocks with zlib
+//! @param buckets if true scan the hash buckets of the old layout instead of
+//!        the locality hashes
+//!
+//! @return 0 if successful, otherwise an errno
+//------------------------------------------------------------------------------
+int ExportNamespace(const std::string& qdb_host, uint32_t qdb_port,
+                    const std::string& path, uint32_t num_threads,
+                    bool compress, bool buckets);
@@ -0,0 +1,398 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Binary namespace dump format written by eos-dump-proto-md --export
+//!
+//! File layout, all integers are little endian:
+//!   header: "EOSNSDMP" | u32 version | u32 flags (bit 0: zlib blocks)
+//!   blocks: u32 kind | u32 num records | u32 raw size | u32 stored size |
+//!           stored size bytes of payload
+//! The raw payload of a block is a sequence of u32 length | serialized
+//! FileMdProto or ContainerMdProto, all of the kind of the block. With the
+//! zlib flag the payload is compressed per block, so that blocks can be
+//! decoded in parallel.
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <zlib.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Constants of the dump format
+//------------------------------------------------------------------------------
+struct NsDump {
+  static constexpr const char* kMagic = "EOSNSDMP";
+  static constexpr size_t kMagicLen = 8;
+  static constexpr uint32_t kVersion = 1;
+  static constexpr uint32_t kFlagZlib = 0x1;
+  static constexpr size_t kHeaderLen = kMagicLen + 8;
+  static constexpr size_t kBlockHeaderLen = 16;
+  //! Blocks are flushed once their raw payload reaches this size
+  static constexpr size_t kBlockSize = 8 * 1024 * 1024;
+
+  //! Kind of the records of a block
+  enum Kind : uint32_t { kFile = 1, kContainer = 2 };
+
+  //----------------------------------------------------------------------------
+  //! Append a little endian u32
+  //----------------------------------------------------------------------------
+  static void putU32(std::string& out, uint32_t value)
+  {
+    char buf[4];
+
+    for (int i = 0; i < 4; ++i) {
+      buf[i] = (char)((value >> (8 * i)) & 0xff);
+    }
+
+    out.append(buf, 4);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Read a little endian u32
+  //----------------------------------------------------------------------------
+  static uint32_t getU32(const char* in)
+  {
+    uint32_t value = 0;
+
+    for (int i = 0; i < 4; ++i) {
+      value |= ((uint32_t)(unsigned char)in[i]) << (8 * i);
+    }
+
+    return value;
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Block of records of one kind, filled by one thread
+//------------------------------------------------------------------------------
+class NsDumpBlock
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  NsDumpBlock(NsDump::Kind kind): mKind(kind)
+  {
+    mRaw.reserve(NsDump::kBlockSize + 1024 * 1024);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Add a serialized protobuf record
+  //----------------------------------------------------------------------------
+  void add(const char* data, size_t len)
+  {
+    NsDump::putU32(mRaw, (uint32_t)len);
+    mRaw.append(data, len);
+    ++mNumRecords;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if the block should be flushed
+  //----------------------------------------------------------------------------
+  bool full() const
+  {
+    return (mRaw.size() >= NsDump::kBlockSize);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop the records, the kind is kept
+  //----------------------------------------------------------------------------
+  void clear()
+  {
+    mRaw.clear();
+    mNumRecords = 0;
+  }
+
+  NsDump::Kind getKind() const
+  {
+    return mKind;
+  }
+
+  uint32_t getNumRecords() const
+  {
+    return mNumRecords;
+  }
+
+  const std::string& getRaw() const
+  {
+    return mRaw;
+  }
+
+private:
+  NsDump::Kind mKind; ///< Kind of the records
+  uint32_t mNumRecords {0}; ///< Number of records
+  std::string mRaw; ///< Uncompressed payload
+};
+
+//------------------------------------------------------------------------------
+//! Writer of a dump file, blocks can be written concurrently
+//------------------------------------------------------------------------------
+class NsDumpWriter
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~NsDumpWriter()
+  {
+    (void) close();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Create the dump file and write its header
+  //!
+  //! @param path output file
+  //! @param compress if true compress the blocks with zlib
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool open(const std::string& path, bool compress)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCompress = compress;
+    mFile = fopen(path.c_str(), "w");
+
+    if (mFile == nullptr) {
+      return false;
+    }
+
+    std::string header(NsDump::kMagic, NsDump::kMagicLen);
+    NsDump::putU32(header, NsDump::kVersion);
+    NsDump::putU32(header, compress ? NsDump::kFlagZlib : 0);
+    return writeLocked(header);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Write a block, compression happens without holding the writer lock
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool writeBlock(const NsDumpBlock& block)
+  {
+    if (block.getNumRecords() == 0) {
+      return true;
+    }
+
+    const std::string& raw = block.getRaw();
+    std::string stored;
+
+    if (mCompress) {
+      uLongf len = compressBound(raw.size());
+      stored.resize(len);
+
+      if (compress2((Bytef*)&stored[0], &len, (const Bytef*)raw.data(),
+                    raw.size(), Z_BEST_SPEED) != Z_OK) {
+        return false;
+      }
+
+      stored.resize(len);
+    }
+
+    const std::string& payload = (mCompress ? stored : raw);
+    std::string header;
+    NsDump::putU32(header, block.getKind());
+    NsDump::putU32(header, block.getNumRecords());
+    NsDump::putU32(header, (uint32_t)raw.size());
+    NsDump::putU32(header, (uint32_t)payload.size());
+    std::lock_guard<std::mutex> lock(mMutex);
+    return (writeLocked(header) && writeLocked(payload));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Flush and close the dump file
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool close()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mFile == nullptr) {
+      return mOk;
+    }
+
+    mOk = (fclose(mFile) == 0) && mOk;
+    mFile = nullptr;
+    return mOk;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Write bytes to the file - needs mMutex
+  //----------------------------------------------------------------------------
+  bool writeLocked(const std::string& data)
+  {
+    if ((mFile == nullptr) ||
+        (fwrite(data.data(), 1, data.size(), mFile) != data.size())) {
+      mOk = false;
+    }
+
+    return mOk;
+  }
+
+  std::mutex mMutex; ///< Mutex serializing the writes
+  FILE* mFile {nullptr}; ///< Output file
+  bool mCompress {false}; ///< Blocks are zlib compressed
+  bool mOk {true}; ///< False after the first failed write
+};
+
+//------------------------------------------------------------------------------
+//! Sequential reader of a dump file
+//------------------------------------------------------------------------------
+class NsDumpReader
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~NsDumpReader()
+  {
+    if (mFile) {
+      fclose(mFile);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Open a dump file and check its header
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool open(const std::string& path)
+  {
+    mFile = fopen(path.c_str(), "r");
+
+    if (mFile == nullptr) {
+      return false;
+    }
+
+    char header[NsDump::kHeaderLen];
+
+    if ((fread(header, 1, sizeof(header), mFile) != sizeof(header)) ||
+        (memcmp(header, NsDump::kMagic, NsDump::kMagicLen) != 0) ||
+        (NsDump::getU32(header + NsDump::kMagicLen) != NsDump::kVersion)) {
+      return false;
+    }
+
+    mCompressed = (NsDump::getU32(header + NsDump::kMagicLen + 4) &
+                   NsDump::kFlagZlib);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the next record
+  //!
+  //! @param kind set to the kind of the record
+  //! @param record set to the serialized protobuf
+  //!
+  //! @return true if a record was read, false at the end of the file or if
+  //!         the file is corrupted, see isCorrupted
+  //----------------------------------------------------------------------------
+  bool next(NsDump::Kind& kind, std::string& record)
+  {
+    while (mPos >= mRaw.size()) {
+      if (!readBlock()) {
+        return false;
+      }
+    }
+
+    if (mRaw.size() - mPos < 4) {
+      mCorrupted = true;
+      return false;
+    }
+
+    uint32_t len = NsDump::getU32(mRaw.data() + mPos);
+    mPos += 4;
+
+    if (mRaw.size() - mPos < len) {
+      mCorrupted = true;
+      return false;
+    }
+
+    kind = mKind;
+    record.assign(mRaw.data() + mPos, len);
+    mPos += len;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if the reading stopped on a corrupted block
+  //----------------------------------------------------------------------------
+  bool isCorrupted() const
+  {
+    return mCorrupted;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Read and decompress the next block
+  //----------------------------------------------------------------------------
+  bool readBlock()
+  {
+    char header[NsDump::kBlockHeaderLen];
+    size_t nread = (mFile ? fread(header, 1, sizeof(header), mFile) : 0);
+
+    if (nread != sizeof(header)) {
+      mCorrupted = (nread != 0);
+      return false;
+    }
+
+    mKind = (NsDump::Kind) NsDump::getU32(header);
+    uint32_t raw_size = NsDump::getU32(header + 8);
+    uint32_t stored_size = NsDump::getU32(header + 12);
+    std::string stored(stored_size, '\0');
+
+    if (stored_size &&
+        (fread(&stored[0], 1, stored_size, mFile) != stored_size)) {
+      mCorrupted = true;
+      return false;
+    }
+
+    if (mCompressed) {
+      uLongf len = raw_size;
+      mRaw.resize(raw_size);
+
+      if ((uncompress((Bytef*)&mRaw[0], &len, (const Bytef*)stored.data(),
+                      stored.size()) != Z_OK) || (len != raw_size)) {
+        mCorrupted = true;
+        return false;
+      }
+    } else {
+      mRaw.swap(stored);
+    }
+
+    mPos = 0;
+    return true;
+  }
+
+  FILE* mFile {nullptr}; ///< Input file
+  bool mCompressed {false}; ///< Blocks are zlib compressed
+  bool mCorrupted {false}; ///< Reading stopped on a corrupted block
+  NsDump::Kind mKind {NsDump::kFile}; ///< Kind of the current block
+  std::string mRaw; ///< Payload of the current block
+  size_t mPos {0}; ///< Position of the next record in mRaw
+};
+
+EOSNSNAMESPACE_END
@@ -24,25 +24,36 @@
 #include "namespace/ns_quarkdb/utils/QuotaRecomputer.hh"
 #include "namespace/ns_quarkdb/views/HierarchicalView.hh"
 #include "namespace/Constants.hh"
-#include "namespace/ns_quarkdb/explorer/NamespaceExplorer.hh"
+#include "namespace/ns_quarkdb/explorer/ParallelNamespaceExplorer.hh"
+#include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
 #include "common/LayoutId.hh"
+#include <set>
+#include <thread>
+#include <vector>
 
 EOSNSNAMESPACE_BEGIN
 
+std::mutex QuotaRecomputer::sSnapshotMutex;
+std::map<IContainerMD::id_t, QuotaRecomputer::SubtreeMap>
+QuotaRecomputer::sSnapshots;
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-QuotaRecomputer::QuotaRecomputer(IView *view, qclient::QClient *qcl)
-: mView(view), mQcl(qcl) {}
+QuotaRecomputer::QuotaRecomputer(IView *view, qclient::QClient *qcl,
+                                 size_t threads)
+: mView(view), mQcl(qcl), mThreads(threads) {}
 
 //------------------------------------------------------------------------------
-// Filtering class for NamespaceExplorer to ignore sub-quotanodes when
-// recomputing a quotanode.
+// Filtering class for the explorer to ignore sub-quotanodes when
+// recomputing a quotanode, as well as the subcontainers whose usage is
+// reused from the last run.
 //------------------------------------------------------------------------------
 class QuotaNodeFilter : public ExpansionDecider
 {
 public:
-  QuotaNodeFilter(uint64_t root) : rootContainer(root) {}
+  QuotaNodeFilter(uint64_t root, std::set<uint64_t>&& skip)
+    : rootContainer(root), skipContainers(std::move(skip)) {}
 
   virtual bool shouldExpandContainer(const eos::ns::ContainerMdProto& proto,
                                      const eos::IContainerMD::XAttrMap& attrs) override
@@ -51,6 +62,10 @@ public:
       return true; // always expand root, no matter what
     }
 
+    if (skipContainers.count(proto.id())) {
+      return false; // usage known from the last run
+    }
+
     if ((proto.flags() & eos::QUOTA_NODE_FLAG) == 0) {
       return true; // not a quota node, continue
     }
@@ -60,13 +75,15 @@ public:
 
 private:
   uint64_t rootContainer;
+  std::set<uint64_t> skipContainers; ///< Read-only once exploring
 };
 
 //------------------------------------------------------------------------------
 // Given a quotanode, re-calculate the quota values,
 // store into QuotaNodeCore.
 //------------------------------------------------------------------------------
-MDStatus QuotaRecomputer::recompute(IContainerMDPtr quotanode, QuotaNodeCore &qnc) {
+MDStatus QuotaRecomputer::recompute(IContainerMDPtr quotanode,
+                                    QuotaNodeCore &qnc, bool incremental) {
   // Reset qnc contents
   qnc = {};
 
@@ -82,30 +99,147 @@ MDStatus QuotaRecomputer::recompute(IContainerMDPtr quotanode, QuotaNodeCore &qn
     return MDStatus(EINVAL, "Quota recomputation is only availbale for QDB namespace");
   }
 
-  ExplorationOptions options;
+  const IContainerMD::id_t rootId = quotanode->getId();
+  // Subcontainers of the quotanode and their tree size, read before exploring
+  // so that a change during the exploration is seen by the next run.
+  std::map<std::string, eos::ns::ContainerMdProto> children;
+  SubtreeMap snapshot;
+  std::set<uint64_t> skip;
+
+  try {
+    IContainerMD::ContainerMap subcontainers =
+      MetadataFetcher::getSubContainers(*mQcl, ContainerIdentifier(rootId)).get();
+    std::vector<std::pair<std::string,
+        folly::Future<eos::ns::ContainerMdProto>>> protos;
+
+    for (auto it = subcontainers.begin(); it != subcontainers.end(); ++it) {
+      protos.emplace_back(it->first, MetadataFetcher::getContainerFromId(*mQcl,
+                          ContainerIdentifier(it->second)));
+    }
+
+    for (auto& elem : protos) {
+      eos::ns::ContainerMdProto proto = elem.second.get();
+
+      if ((proto.flags() & eos::QUOTA_NODE_FLAG) == 0) {
+        children.emplace(elem.first, std::move(proto));
+      }
+    }
+  } catch (const MDException& e) {
+    return MDStatus(e.getErrno(), e.what());
+  }
+
+  if (incremental) {
+    std::lock_guard<std::mutex> lock(sSnapshotMutex);
+    auto it = sSnapshots.find(rootId);
+
+    if (it != sSnapshots.end()) {
+      for (const auto& child : children) {
+        auto usage = it->second.find(child.second.id());
+
+        if ((usage != it->second.end()) &&
+            (usage->second.treeSize == child.second.tree_size())) {
+          SubtreeUsage& reused = snapshot[child.second.id()];
+          reused.treeSize = usage->second.treeSize;
+          reused.core = usage->second.core;
+          skip.insert(child.second.id());
+        }
+      }
+    }
+  }
+
+  ParallelExplorationOptions options;
   options.depthLimit = 2048;
-  options.expansionDecider.reset(new QuotaNodeFilter(quotanode->getId()));
-  NamespaceExplorer explorer(mView->getUri(quotanode.get()),
-                             options,
-                             *mQcl);
-  NamespaceItem item;
-
-  while (explorer.fetch(item)) {
-    if (item.isFile) {
-      // Calculate physical size
-      uint64_t logicalSize = item.fileMd.size();
-      uint64_t physicalSize = item.fileMd.size() *
-                              eos::common::LayoutId::GetSizeFactor(item.fileMd.layout_id());
-      // Account file.
-      qnc.addFile(
-        item.fileMd.uid(),
-        item.fileMd.gid(),
-        logicalSize,
-        physicalSize
-      );
+  options.threads = mThreads;
+  options.expansionDecider.reset(new QuotaNodeFilter(rootId, std::move(skip)));
+  const std::string rootPath = mView->getUri(quotanode.get());
+  std::unique_ptr<ParallelNamespaceExplorer> explorer;
+
+  try {
+    explorer.reset(new ParallelNamespaceExplorer(rootPath, options, *mQcl));
+  } catch (const MDException& e) {
+    return MDStatus(e.getErrno(), e.what());
+  }
+
+  // Every accounting thread sums the files per direct subcontainer of the
+  // quotanode, files directly in the quotanode go under the empty name.
+  std::vector<std::map<std::string, QuotaNodeCore>> partial(kAccountingThreads);
+  std::vector<std::thread> threads;
+
+  for (size_t i = 0; i < kAccountingThreads; ++i) {
+    threads.emplace_back([&explorer, &rootPath](std::map<std::string,
+    QuotaNodeCore>& sums) {
+      std::vector<NamespaceItem> chunk;
+
+      while (explorer->fetch(chunk)) {
+        for (const auto& item : chunk) {
+          if (!item.isFile) {
+            continue;
+          }
+
+          // Calculate physical size
+          uint64_t logicalSize = item.fileMd.size();
+          uint64_t physicalSize = item.fileMd.size() *
+                                  eos::common::LayoutId::GetSizeFactor(item.fileMd.layout_id());
+          size_t pos = item.fullPath.find('/', rootPath.length());
+          std::string child = (pos == std::string::npos) ? "" :
+                              item.fullPath.substr(rootPath.length(),
+                                                   pos - rootPath.length());
+          // Account file.
+          sums[child].addFile(
+            item.fileMd.uid(),
+            item.fileMd.gid(),
+            logicalSize,
+            physicalSize
+          );
+        }
+      }
+    }, std::ref(partial[i]));
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::map<std::string, QuotaNodeCore> merged;
+
+  for (const auto& sums : partial) {
+    for (const auto& elem : sums) {
+      merged[elem.first].meld(elem.second);
     }
   }
 
+  for (const auto& elem : merged) {
+    qnc.meld(elem.second);
+  }
+
+  for (const auto& elem : snapshot) {
+    qnc.meld(elem.second.core);
+  }
+
+  // Remember the usage of the explored subcontainers for the next run, a
+  // partial exploration forces the next run to explore everything again.
+  std::lock_guard<std::mutex> lock(sSnapshotMutex);
+
+  if (explorer->getErrors()) {
+    sSnapshots.erase(rootId);
+  } else {
+    for (const auto& child : children) {
+      if (snapshot.count(child.second.id())) {
+        continue;
+      }
+
+      SubtreeUsage& usage = snapshot[child.second.id()];
+      usage.treeSize = child.second.tree_size();
+      auto it = merged.find(child.first);
+
+      if (it != merged.end()) {
+        usage.core = it->second;
+      }
+    }
+
+    sSnapshots[rootId].swap(snapshot);
+  }
+
   return MDStatus(); // OK
 }
 
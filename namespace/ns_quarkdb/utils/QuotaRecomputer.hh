@@ -26,6 +26,9 @@
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/Namespace.hh"
 #include "namespace/MDException.hh"
+#include "namespace/common/QuotaNodeCore.hh"
+#include <map>
+#include <mutex>
 
 namespace qclient {
   class QClient;
@@ -33,29 +36,63 @@ namespace qclient {
 
 EOSNSNAMESPACE_BEGIN
 
-class QuotaNodeCore;
 class IView;
 
 //------------------------------------------------------------------------------
 //! Utility class to recompute a quotanode
+//!
+//! The subtree is explored with the ParallelNamespaceExplorer and the files
+//! are accounted by several threads into partial sums merged at the end. The
+//! usage of every direct subcontainer of the quotanode is remembered together
+//! with its tree size, so that an incremental recompute only explores the
+//! subcontainers whose tree size changed since the last run, plus the files
+//! directly in the quotanode. Changes which do not alter the tree size, e.g.
+//! a chown, are only picked up by a full recompute.
 //------------------------------------------------------------------------------
 class QuotaRecomputer
 {
 public:
   //----------------------------------------------------------------------------
   //! Constructor
+  //!
+  //! @param view namespace view
+  //! @param qcl QClient object, no ownership
+  //! @param threads number of threads exploring the namespace
   //----------------------------------------------------------------------------
-  QuotaRecomputer(IView *view, qclient::QClient *qcl);
+  QuotaRecomputer(IView *view, qclient::QClient *qcl, size_t threads = 16);
 
   //----------------------------------------------------------------------------
   //! Given a quotanode, re-calculate the quota values,
   //! store into QuotaNodeCore.
+  //!
+  //! @param quotanode quota node container
+  //! @param core output quota values
+  //! @param incremental if true, reuse the usage of the subcontainers whose
+  //!        tree size did not change since the last recompute of this node
   //----------------------------------------------------------------------------
-  MDStatus recompute(IContainerMDPtr quotanode, QuotaNodeCore &core);
+  MDStatus recompute(IContainerMDPtr quotanode, QuotaNodeCore &core,
+                     bool incremental = false);
 
 private:
+  //! Usage of a direct subcontainer of a quotanode
+  struct SubtreeUsage {
+    uint64_t treeSize = 0; ///< Tree size when the usage was computed
+    QuotaNodeCore core;
+  };
+
+  //! Usage of the subcontainers of a quotanode, by container id
+  typedef std::map<IContainerMD::id_t, SubtreeUsage> SubtreeMap;
+
+  //! Number of threads accounting the explored files
+  static constexpr size_t kAccountingThreads = 4;
+
   IView *mView;
   qclient::QClient *mQcl;
+  size_t mThreads;
+
+  static std::mutex sSnapshotMutex; ///< Protects sSnapshots
+  //! Usage of the subcontainers as of the last recompute, by quotanode id
+  static std::map<IContainerMD::id_t, SubtreeMap> sSnapshots;
 };
 
 EOSNSNAMESPACE_END
@@ -42,7 +42,8 @@ EOSNSNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 QuarkHierarchicalView::QuarkHierarchicalView()
   : pContainerSvc(nullptr), pFileSvc(nullptr),
-    pQuotaStats(new QuarkQuotaStats()), pRoot(nullptr)
+    pQuotaStats(new QuarkQuotaStats()), pRoot(nullptr), pNegativeCache(nullptr),
+    pPathCache(nullptr)
 {
   pExecutor.reset(new folly::IOThreadPoolExecutor(8));
 }
@@ -73,6 +74,14 @@ QuarkHierarchicalView::configure(const std::map<std::string, std::string>& confi
     throw e;
   }
 
+  QuarkContainerMDSvc* impl_cont_svc = dynamic_cast<QuarkContainerMDSvc*>
+                                       (pContainerSvc);
+
+  if (impl_cont_svc) {
+    pNegativeCache = impl_cont_svc->getNegativeLookupCache();
+    pPathCache = impl_cont_svc->getPathLookupCache();
+  }
+
   delete pQuotaStats;
   pQuotaStats = new QuarkQuotaStats();
   pQuotaStats->configure(config);
@@ -184,11 +193,115 @@ QuarkHierarchicalView::getItem(const std::string& uri, bool follow)
   //----------------------------------------------------------------------------
   std::deque<std::string> pendingChunks;
   eos::PathProcessor::insertChunksIntoDeque(pendingChunks, uri);
+  return getPathCached(pendingChunks, follow);
+}
+
+//------------------------------------------------------------------------------
+// Lookup a given path starting from the longest cached prefix.
+//------------------------------------------------------------------------------
+folly::Future<FileOrContainerMD>
+QuarkHierarchicalView::getPathCached(const std::deque<std::string>& chunks,
+                                     bool follow)
+{
   //----------------------------------------------------------------------------
   // Initial state: We're at "/", and have to look up all chunks.
   //----------------------------------------------------------------------------
   FileOrContainerMD initialState {nullptr, pRoot};
-  return getPathInternal(initialState, pendingChunks, follow, 0);
+
+  if (!pPathCache || (pPathCache->get_max_num() == 0ull) || chunks.empty()) {
+    return getPathInternal(initialState, chunks, follow, 0);
+  }
+
+  //----------------------------------------------------------------------------
+  // Skip the chunks resolved by the longest cached prefix. Only a container
+  // which is in memory and still carries the expected name is trusted,
+  // otherwise start from "/" as usual.
+  //----------------------------------------------------------------------------
+  std::deque<std::string> pendingChunks = chunks;
+  ContainerIdentifier id;
+  size_t depth = 0;
+
+  if (pPathCache->lookup(chunks, depth, id)) {
+    folly::Future<IContainerMDPtr> fut =
+      pContainerSvc->getContainerMDFut(id.getUnderlyingUInt64());
+
+    if (fut.isReady() && fut.hasValue() && fut.value() &&
+        !fut.value()->isDeleted() &&
+        (fut.value()->getName() == chunks[depth - 1])) {
+      initialState.container = fut.value();
+      pendingChunks.erase(pendingChunks.begin(), pendingChunks.begin() + depth);
+    } else {
+      if (fut.isReady()) {
+        pPathCache->invalidate(id);
+      }
+
+      depth = 0;
+    }
+  }
+
+  return getPathInternal(initialState, pendingChunks, follow, 0)
+  .then([this, chunks, depth](FileOrContainerMD item) {
+    cachePath(chunks, depth, item);
+    return item;
+  });
+}
+
+//------------------------------------------------------------------------------
+// Add the directories of a resolved path to the path cache.
+//------------------------------------------------------------------------------
+void
+QuarkHierarchicalView::cachePath(const std::deque<std::string>& chunks,
+                                 size_t depth, const FileOrContainerMD& item)
+{
+  //----------------------------------------------------------------------------
+  // Number of chunks resolved by the deepest directory of the path, nothing
+  // to do if the lookup started from it already.
+  //----------------------------------------------------------------------------
+  size_t end = chunks.size();
+  IContainerMDPtr cont = item.container;
+
+  if (item.file) {
+    if (--end <= depth) {
+      return;
+    }
+
+    folly::Future<IContainerMDPtr> fut =
+      pContainerSvc->getContainerMDFut(item.file->getContainerId());
+
+    if (!fut.isReady() || !fut.hasValue()) {
+      return;
+    }
+
+    cont = fut.value();
+  }
+
+  if (!cont || (end <= depth)) {
+    return;
+  }
+
+  //----------------------------------------------------------------------------
+  // Walk up to the cached prefix, only through containers in memory. If the
+  // lookup went through a symlink the chain does not match the chunks and
+  // the cache rejects it.
+  //----------------------------------------------------------------------------
+  std::vector<IContainerMDPtr> conts(end - depth);
+
+  for (size_t i = conts.size(); i > 0; --i) {
+    conts[i - 1] = cont;
+
+    if (i > 1) {
+      folly::Future<IContainerMDPtr> fut =
+        pContainerSvc->getContainerMDFut(cont->getParentId());
+
+      if (!fut.isReady() || !fut.hasValue() || !fut.value()) {
+        return;
+      }
+
+      cont = fut.value();
+    }
+  }
+
+  (void) pPathCache->insert(chunks, depth, conts);
 }
 
 //------------------------------------------------------------------------------
@@ -312,11 +425,19 @@ QuarkHierarchicalView::getPathInternal(FileOrContainerMD state,
 
       //------------------------------------------------------------------------
       // Normal case: Our current state contains a container, and we're simply
-      // looking up the next chunk.
+      // looking up the next chunk. Names recently found missing are answered
+      // by the negative lookup cache.
       //------------------------------------------------------------------------
+      ContainerIdentifier parentId = state.container->getIdentifier();
+
+      if (pNegativeCache &&
+          pNegativeCache->contains(parentId, pendingChunks.front())) {
+        return folly::makeFuture<FileOrContainerMD>(make_mdexception(ENOENT,
+               "No such file or directory"));
+      }
+
       folly::Future<FileOrContainerMD> next = state.container->findItem(
           pendingChunks.front());
-      pendingChunks.pop_front();
 
       //------------------------------------------------------------------------
       // If we're lucky, the result is ready immediately. Update state, and
@@ -324,11 +445,18 @@ QuarkHierarchicalView::getPathInternal(FileOrContainerMD state,
       //------------------------------------------------------------------------
       if (next.isReady()) {
         state = next.get();
+
+        if (!state.container && !state.file && pNegativeCache) {
+          pNegativeCache->insert(parentId, pendingChunks.front());
+        }
+
+        pendingChunks.pop_front();
         continue;
       } else {
         //----------------------------------------------------------------------
         // We're blocked, "pause" execution, unblock caller.
         //----------------------------------------------------------------------
+        pendingChunks.pop_front();
         return getPathDeferred(std::move(next), pendingChunks, follow, expendedEffort);
       }
     }
@@ -682,8 +810,7 @@ QuarkHierarchicalView::getPathExpectContainer(const std::deque<std::string>& chu
     return pRoot;
   }
 
-  return getPathInternal(FileOrContainerMD {nullptr, pRoot}, chunks, true, 0)
-         .then(extractContainerMD);
+  return getPathCached(chunks, true).then(extractContainerMD);
 }
 
 //------------------------------------------------------------------------------
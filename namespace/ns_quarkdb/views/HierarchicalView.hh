@@ -29,6 +29,8 @@
 #include "namespace/interface/IFileMDSvc.hh"
 #include "namespace/interface/IView.hh"
 #include "namespace/ns_quarkdb/accounting/QuotaStats.hh"
+#include "namespace/ns_quarkdb/NegativeLookupCache.hh"
+#include "namespace/ns_quarkdb/PathLookupCache.hh"
 
 #ifdef __clang__
 #pragma clang diagnostic ignored "-Wunused-private-field"
@@ -325,6 +327,24 @@ private:
   folly::Future<IContainerMDPtr>
   getPathExpectContainer(const std::deque<std::string> &chunks);
 
+  //----------------------------------------------------------------------------
+  //! Lookup a given path starting from the longest prefix found in the path
+  //! cache, the directories resolved on the way are added to the cache.
+  //----------------------------------------------------------------------------
+  folly::Future<FileOrContainerMD>
+  getPathCached(const std::deque<std::string>& chunks, bool follow);
+
+  //----------------------------------------------------------------------------
+  //! Add the directories of a resolved path to the path cache
+  //!
+  //! @param chunks path chunks
+  //! @param depth number of chunks resolved by the cached prefix the lookup
+  //!        started from
+  //! @param item result of the lookup
+  //----------------------------------------------------------------------------
+  void cachePath(const std::deque<std::string>& chunks, size_t depth,
+                 const FileOrContainerMD& item);
+
   //----------------------------------------------------------------------------
   //! Clean up contents of container
   //!
@@ -340,6 +360,8 @@ private:
   IQuotaStats* pQuotaStats;
   std::shared_ptr<IContainerMD> pRoot;
   std::unique_ptr<folly::Executor> pExecutor;
+  NegativeLookupCache* pNegativeCache; ///< Cache of failed lookups
+  PathLookupCache* pPathCache; ///< Cache of resolved directory paths
 };
 
 EOSNSNAMESPACE_END
@@ -0,0 +1,543 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Compressed bitmap of file ids
+//------------------------------------------------------------------------------
+
+#include "namespace/utils/FileBitmap.hh"
+#include <algorithm>
+#include <iterator>
+
+EOSNSNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+// A bitmap chunk turns back into an array only well below kArrayMax, so that
+// ids inserted and erased around the limit do not convert it every time
+//------------------------------------------------------------------------------
+constexpr uint32_t kArrayMin = FileBitmap::kArrayMax / 2;
+
+//------------------------------------------------------------------------------
+// Number of set bits of a word
+//------------------------------------------------------------------------------
+inline uint32_t PopCount(uint64_t word)
+{
+  return __builtin_popcountll(word);
+}
+}
+
+//------------------------------------------------------------------------------
+// Iterator constructor
+//------------------------------------------------------------------------------
+FileBitmap::const_iterator::const_iterator(const std::vector<Chunk>* chunks,
+    size_t chunk):
+  mChunks(chunks), mChunk(chunk), mPos(0), mWord(0), mValue(0)
+{
+  if (mChunk < mChunks->size()) {
+    const Chunk& current = (*mChunks)[mChunk];
+    mWord = (current.isBitmap() ? current.mBits[0] : 0);
+    settle();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Position on the first id at or after the current position
+//------------------------------------------------------------------------------
+void
+FileBitmap::const_iterator::settle()
+{
+  while (mChunk < mChunks->size()) {
+    const Chunk& current = (*mChunks)[mChunk];
+    const uint64_t base = current.mKey << 16;
+
+    if (current.isBitmap()) {
+      while ((mWord == 0) && (++mPos < kWords)) {
+        mWord = current.mBits[mPos];
+      }
+
+      if (mWord) {
+        mValue = base | (mPos * 64 + __builtin_ctzll(mWord));
+        return;
+      }
+    } else if (mPos < current.mArray.size()) {
+      mValue = base | current.mArray[mPos];
+      return;
+    }
+
+    // Next chunk, the end iterator has mPos and mWord at 0
+    mPos = 0;
+    mWord = 0;
+
+    if (++mChunk < mChunks->size()) {
+      const Chunk& next = (*mChunks)[mChunk];
+      mWord = (next.isBitmap() ? next.mBits[0] : 0);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Move to the next id
+//------------------------------------------------------------------------------
+void
+FileBitmap::const_iterator::advance()
+{
+  if (mChunk >= mChunks->size()) {
+    return;
+  }
+
+  if ((*mChunks)[mChunk].isBitmap()) {
+    mWord &= mWord - 1;
+  } else {
+    ++mPos;
+  }
+
+  settle();
+}
+
+//------------------------------------------------------------------------------
+// Find the chunk of the given key or the position where it would go
+//------------------------------------------------------------------------------
+size_t
+FileBitmap::lowerBound(uint64_t key) const
+{
+  // Ids are mostly allocated, hence inserted, in ascending order
+  if (mChunks.empty() || (mChunks.back().mKey < key)) {
+    return mChunks.size();
+  }
+
+  if (mChunks.back().mKey == key) {
+    return mChunks.size() - 1;
+  }
+
+  auto it = std::lower_bound(mChunks.begin(), mChunks.end(), key,
+  [](const Chunk & chunk, uint64_t k) {
+    return chunk.mKey < k;
+  });
+  return it - mChunks.begin();
+}
+
+//------------------------------------------------------------------------------
+// Insert an id
+//------------------------------------------------------------------------------
+bool
+FileBitmap::insert(uint64_t id)
+{
+  const uint64_t key = id >> 16;
+  const uint16_t low = id & 0xffff;
+  size_t pos = lowerBound(key);
+
+  if ((pos == mChunks.size()) || (mChunks[pos].mKey != key)) {
+    Chunk chunk;
+    chunk.mKey = key;
+    chunk.mCard = 1;
+    chunk.mArray.push_back(low);
+    mChunks.insert(mChunks.begin() + pos, std::move(chunk));
+    ++mSize;
+    return true;
+  }
+
+  Chunk& chunk = mChunks[pos];
+
+  if (chunk.isBitmap()) {
+    uint64_t& word = chunk.mBits[low >> 6];
+    const uint64_t mask = 1ull << (low & 63);
+
+    if (word & mask) {
+      return false;
+    }
+
+    word |= mask;
+  } else {
+    auto it = std::lower_bound(chunk.mArray.begin(), chunk.mArray.end(), low);
+
+    if ((it != chunk.mArray.end()) && (*it == low)) {
+      return false;
+    }
+
+    if (chunk.mArray.size() < kArrayMax) {
+      chunk.mArray.insert(it, low);
+    } else {
+      chunk.mBits.assign(kWords, 0);
+
+      for (uint16_t val : chunk.mArray) {
+        chunk.mBits[val >> 6] |= 1ull << (val & 63);
+      }
+
+      chunk.mBits[low >> 6] |= 1ull << (low & 63);
+      std::vector<uint16_t>().swap(chunk.mArray);
+    }
+  }
+
+  ++chunk.mCard;
+  ++mSize;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Erase an id
+//------------------------------------------------------------------------------
+bool
+FileBitmap::erase(uint64_t id)
+{
+  const uint64_t key = id >> 16;
+  const uint16_t low = id & 0xffff;
+  size_t pos = lowerBound(key);
+
+  if ((pos == mChunks.size()) || (mChunks[pos].mKey != key)) {
+    return false;
+  }
+
+  Chunk& chunk = mChunks[pos];
+
+  if (chunk.isBitmap()) {
+    uint64_t& word = chunk.mBits[low >> 6];
+    const uint64_t mask = 1ull << (low & 63);
+
+    if (!(word & mask)) {
+      return false;
+    }
+
+    word &= ~mask;
+
+    if (chunk.mCard - 1 < kArrayMin) {
+      chunk.mArray.reserve(chunk.mCard - 1);
+
+      for (uint32_t i = 0; i < kWords; ++i) {
+        for (uint64_t w = chunk.mBits[i]; w; w &= w - 1) {
+          chunk.mArray.push_back(i * 64 + __builtin_ctzll(w));
+        }
+      }
+
+      std::vector<uint64_t>().swap(chunk.mBits);
+    }
+  } else {
+    auto it = std::lower_bound(chunk.mArray.begin(), chunk.mArray.end(), low);
+
+    if ((it == chunk.mArray.end()) || (*it != low)) {
+      return false;
+    }
+
+    chunk.mArray.erase(it);
+  }
+
+  --mSize;
+
+  if (--chunk.mCard == 0) {
+    mChunks.erase(mChunks.begin() + pos);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Check if an id is present
+//------------------------------------------------------------------------------
+bool
+FileBitmap::contains(uint64_t id) const
+{
+  const uint64_t key = id >> 16;
+  const uint16_t low = id & 0xffff;
+  size_t pos = lowerBound(key);
+
+  if ((pos == mChunks.size()) || (mChunks[pos].mKey != key)) {
+    return false;
+  }
+
+  const Chunk& chunk = mChunks[pos];
+
+  if (chunk.isBitmap()) {
+    return (chunk.mBits[low >> 6] >> (low & 63)) & 1;
+  }
+
+  return std::binary_search(chunk.mArray.begin(), chunk.mArray.end(), low);
+}
+
+//------------------------------------------------------------------------------
+// Remove all the ids and release the memory
+//------------------------------------------------------------------------------
+void
+FileBitmap::clear()
+{
+  std::vector<Chunk>().swap(mChunks);
+  mSize = 0;
+}
+
+//------------------------------------------------------------------------------
+// Get the id of the given rank
+//------------------------------------------------------------------------------
+bool
+FileBitmap::select(uint64_t rank, uint64_t& id) const
+{
+  if (rank >= mSize) {
+    return false;
+  }
+
+  for (const auto& chunk : mChunks) {
+    if (rank >= chunk.mCard) {
+      rank -= chunk.mCard;
+      continue;
+    }
+
+    const uint64_t base = chunk.mKey << 16;
+
+    if (!chunk.isBitmap()) {
+      id = base | chunk.mArray[rank];
+      return true;
+    }
+
+    for (uint32_t i = 0; i < kWords; ++i) {
+      uint64_t word = chunk.mBits[i];
+      const uint32_t count = PopCount(word);
+
+      if (rank >= count) {
+        rank -= count;
+        continue;
+      }
+
+      for (; rank; --rank) {
+        word &= word - 1;
+      }
+
+      id = base | (i * 64 + __builtin_ctzll(word));
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Get approximate number of bytes used by the bitmap
+//------------------------------------------------------------------------------
+size_t
+FileBitmap::getMemoryUsage() const
+{
+  size_t bytes = sizeof(*this) + mChunks.capacity() * sizeof(Chunk);
+
+  for (const auto& chunk : mChunks) {
+    bytes += chunk.mArray.capacity() * sizeof(uint16_t) +
+             chunk.mBits.capacity() * sizeof(uint64_t);
+  }
+
+  return bytes;
+}
+
+//------------------------------------------------------------------------------
+// Release the memory reserved beyond what the chunks use
+//------------------------------------------------------------------------------
+void
+FileBitmap::shrink()
+{
+  mChunks.shrink_to_fit();
+
+  for (auto& chunk : mChunks) {
+    chunk.mArray.shrink_to_fit();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Append a chunk resulting of a set operation
+//------------------------------------------------------------------------------
+void
+FileBitmap::appendChunk(Chunk&& chunk)
+{
+  if (chunk.mCard == 0) {
+    return;
+  }
+
+  if (chunk.isBitmap() && (chunk.mCard <= kArrayMax)) {
+    chunk.mArray.reserve(chunk.mCard);
+
+    for (uint32_t i = 0; i < kWords; ++i) {
+      for (uint64_t w = chunk.mBits[i]; w; w &= w - 1) {
+        chunk.mArray.push_back(i * 64 + __builtin_ctzll(w));
+      }
+    }
+
+    std::vector<uint64_t>().swap(chunk.mBits);
+  }
+
+  mSize += chunk.mCard;
+  mChunks.push_back(std::move(chunk));
+}
+
+//------------------------------------------------------------------------------
+// Intersection of two chunks with the same key
+//------------------------------------------------------------------------------
+FileBitmap::Chunk
+FileBitmap::intersectChunks(const Chunk& a, const Chunk& b)
+{
+  Chunk out;
+  out.mKey = a.mKey;
+  out.mCard = 0;
+
+  if (a.isBitmap() && b.isBitmap()) {
+    out.mBits.resize(kWords);
+
+    for (uint32_t i = 0; i < kWords; ++i) {
+      out.mBits[i] = a.mBits[i] & b.mBits[i];
+      out.mCard += PopCount(out.mBits[i]);
+    }
+  } else if (a.isBitmap() || b.isBitmap()) {
+    const Chunk& arr = (a.isBitmap() ? b : a);
+    const Chunk& bmp = (a.isBitmap() ? a : b);
+
+    for (uint16_t low : arr.mArray) {
+      if ((bmp.mBits[low >> 6] >> (low & 63)) & 1) {
+        out.mArray.push_back(low);
+      }
+    }
+
+    out.mCard = out.mArray.size();
+  } else {
+    std::set_intersection(a.mArray.begin(), a.mArray.end(), b.mArray.begin(),
+                          b.mArray.end(), std::back_inserter(out.mArray));
+    out.mCard = out.mArray.size();
+  }
+
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Difference of two chunks with the same key
+//------------------------------------------------------------------------------
+FileBitmap::Chunk
+FileBitmap::subtractChunks(const Chunk& a, const Chunk& b)
+{
+  Chunk out;
+  out.mKey = a.mKey;
+  out.mCard = 0;
+
+  if (a.isBitmap()) {
+    out.mBits = a.mBits;
+
+    if (b.isBitmap()) {
+      for (uint32_t i = 0; i < kWords; ++i) {
+        out.mBits[i] &= ~b.mBits[i];
+      }
+    } else {
+      for (uint16_t low : b.mArray) {
+        out.mBits[low >> 6] &= ~(1ull << (low & 63));
+      }
+    }
+
+    for (uint32_t i = 0; i < kWords; ++i) {
+      out.mCard += PopCount(out.mBits[i]);
+    }
+  } else if (b.isBitmap()) {
+    for (uint16_t low : a.mArray) {
+      if (!((b.mBits[low >> 6] >> (low & 63)) & 1)) {
+        out.mArray.push_back(low);
+      }
+    }
+
+    out.mCard = out.mArray.size();
+  } else {
+    std::set_difference(a.mArray.begin(), a.mArray.end(), b.mArray.begin(),
+                        b.mArray.end(), std::back_inserter(out.mArray));
+    out.mCard = out.mArray.size();
+  }
+
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Ids present in both bitmaps
+//------------------------------------------------------------------------------
+FileBitmap
+FileBitmap::intersect(const FileBitmap& a, const FileBitmap& b)
+{
+  FileBitmap out;
+  auto ita = a.mChunks.begin();
+  auto itb = b.mChunks.begin();
+
+  while ((ita != a.mChunks.end()) && (itb != b.mChunks.end())) {
+    if (ita->mKey < itb->mKey) {
+      ++ita;
+    } else if (itb->mKey < ita->mKey) {
+      ++itb;
+    } else {
+      out.appendChunk(intersectChunks(*ita, *itb));
+      ++ita;
+      ++itb;
+    }
+  }
+
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Ids present in a but not in b
+//------------------------------------------------------------------------------
+FileBitmap
+FileBitmap::difference(const FileBitmap& a, const FileBitmap& b)
+{
+  FileBitmap out;
+  auto itb = b.mChunks.begin();
+
+  for (auto ita = a.mChunks.begin(); ita != a.mChunks.end(); ++ita) {
+    while ((itb != b.mChunks.end()) && (itb->mKey < ita->mKey)) {
+      ++itb;
+    }
+
+    if ((itb != b.mChunks.end()) && (itb->mKey == ita->mKey)) {
+      out.appendChunk(subtractChunks(*ita, *itb));
+    } else {
+      Chunk copy = *ita;
+      out.appendChunk(std::move(copy));
+    }
+  }
+
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Number of ids present in both bitmaps
+//------------------------------------------------------------------------------
+uint64_t
+FileBitmap::intersectionSize(const FileBitmap& a, const FileBitmap& b)
+{
+  uint64_t count = 0;
+  auto ita = a.mChunks.begin();
+  auto itb = b.mChunks.begin();
+
+  while ((ita != a.mChunks.end()) && (itb != b.mChunks.end())) {
+    if (ita->mKey < itb->mKey) {
+      ++ita;
+    } else if (itb->mKey < ita->mKey) {
+      ++itb;
+    } else {
+      if (ita->isBitmap() && itb->isBitmap()) {
+        for (uint32_t i = 0; i < kWords; ++i) {
+          count += PopCount(ita->mBits[i] & itb->mBits[i]);
+        }
+      } else {
+        count += intersectChunks(*ita, *itb).mCard;
+      }
+
+      ++ita;
+      ++itb;
+    }
+  }
+
+  return count;
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,271 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Compressed bitmap of file ids
+//------------------------------------------------------------------------------
+
+#ifndef EOS_NS_FILE_BITMAP_HH
+#define EOS_NS_FILE_BITMAP_HH
+
+#include "namespace/Namespace.hh"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Set of 64-bit file ids stored as a roaring bitmap: the ids are split in
+//! chunks of 2^16 consecutive values, a chunk with at most 4096 ids keeps
+//! them as a sorted array of their low 16 bits and a denser one as a bitmap
+//! of 1024 words. The chunks are kept sorted by the high 48 bits of the ids.
+//!
+//! File ids are allocated sequentially so the file list of a filesystem
+//! costs about 2 bytes per id when sparse and down to 1 bit per id when
+//! dense, instead of 16-24 for a hash set. Iteration returns the ids in
+//! ascending order and the set operations work a chunk at a time, word by
+//! word for the bitmaps.
+//!
+//! Not thread-safe, like the hash set it replaces.
+//------------------------------------------------------------------------------
+class FileBitmap
+{
+private:
+  //! Chunk of 2^16 consecutive ids
+  struct Chunk {
+    uint64_t mKey; ///< High 48 bits of the ids
+    uint32_t mCard; ///< Number of ids in the chunk
+    std::vector<uint16_t> mArray; ///< Sorted low bits if not a bitmap
+    std::vector<uint64_t> mBits; ///< Bitmap of kWords words, or empty
+
+    bool isBitmap() const
+    {
+      return !mBits.empty();
+    }
+  };
+
+public:
+  //! Max number of ids of an array chunk
+  static constexpr uint32_t kArrayMax = 4096;
+  //! Number of 64-bit words of a bitmap chunk
+  static constexpr uint32_t kWords = 1024;
+
+  //----------------------------------------------------------------------------
+  //! Forward iterator going through the ids in ascending order, invalidated
+  //! by any change of the bitmap
+  //----------------------------------------------------------------------------
+  class const_iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef uint64_t value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const uint64_t* pointer;
+    typedef const uint64_t& reference;
+
+    const_iterator():
+      mChunks(nullptr), mChunk(0), mPos(0), mWord(0), mValue(0) {}
+
+    const uint64_t& operator*() const
+    {
+      return mValue;
+    }
+
+    const_iterator& operator++()
+    {
+      advance();
+      return *this;
+    }
+
+    bool operator==(const const_iterator& other) const
+    {
+      return (mChunk == other.mChunk) && (mPos == other.mPos) &&
+             (mWord == other.mWord);
+    }
+
+    bool operator!=(const const_iterator& other) const
+    {
+      return !(*this == other);
+    }
+
+  private:
+    friend class FileBitmap;
+
+    const_iterator(const std::vector<Chunk>* chunks, size_t chunk);
+
+    //--------------------------------------------------------------------------
+    //! Position on the first id at or after the current position
+    //--------------------------------------------------------------------------
+    void settle();
+
+    //--------------------------------------------------------------------------
+    //! Move to the next id
+    //--------------------------------------------------------------------------
+    void advance();
+
+    const std::vector<Chunk>* mChunks;
+    size_t mChunk; ///< Index of the current chunk
+    uint32_t mPos; ///< Index in the array or word of the bitmap
+    uint64_t mWord; ///< Bits of the current word not visited yet
+    uint64_t mValue; ///< Current id
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  FileBitmap(): mSize(0) {}
+
+  //----------------------------------------------------------------------------
+  //! Insert an id
+  //!
+  //! @return true if inserted, false if already present
+  //----------------------------------------------------------------------------
+  bool insert(uint64_t id);
+
+  //----------------------------------------------------------------------------
+  //! Erase an id
+  //!
+  //! @return true if erased, false if not present
+  //----------------------------------------------------------------------------
+  bool erase(uint64_t id);
+
+  //----------------------------------------------------------------------------
+  //! Check if an id is present
+  //----------------------------------------------------------------------------
+  bool contains(uint64_t id) const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of ids
+  //----------------------------------------------------------------------------
+  uint64_t size() const
+  {
+    return mSize;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if there are no ids
+  //----------------------------------------------------------------------------
+  bool empty() const
+  {
+    return (mSize == 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove all the ids and release the memory
+  //----------------------------------------------------------------------------
+  void clear();
+
+  //----------------------------------------------------------------------------
+  //! Get the id of the given rank, i.e. the rank-th smallest one
+  //!
+  //! @return false if rank >= size()
+  //----------------------------------------------------------------------------
+  bool select(uint64_t rank, uint64_t& id) const;
+
+  //----------------------------------------------------------------------------
+  //! Get approximate number of bytes used by the bitmap
+  //----------------------------------------------------------------------------
+  size_t getMemoryUsage() const;
+
+  //----------------------------------------------------------------------------
+  //! Release the memory reserved beyond what the chunks use
+  //----------------------------------------------------------------------------
+  void shrink();
+
+  //----------------------------------------------------------------------------
+  //! Iterators
+  //----------------------------------------------------------------------------
+  const_iterator begin() const
+  {
+    return const_iterator(&mChunks, 0);
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator(&mChunks, mChunks.size());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Call func(id) for every id in ascending order, faster than iterating
+  //----------------------------------------------------------------------------
+  template<typename Callable>
+  void forEach(Callable func) const
+  {
+    for (const auto& chunk : mChunks) {
+      const uint64_t base = chunk.mKey << 16;
+
+      if (chunk.isBitmap()) {
+        for (uint32_t i = 0; i < kWords; ++i) {
+          for (uint64_t word = chunk.mBits[i]; word; word &= word - 1) {
+            func(base | (i * 64 + __builtin_ctzll(word)));
+          }
+        }
+      } else {
+        for (uint16_t low : chunk.mArray) {
+          func(base | low);
+        }
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Ids present in both bitmaps
+  //----------------------------------------------------------------------------
+  static FileBitmap intersect(const FileBitmap& a, const FileBitmap& b);
+
+  //----------------------------------------------------------------------------
+  //! Ids present in a but not in b
+  //----------------------------------------------------------------------------
+  static FileBitmap difference(const FileBitmap& a, const FileBitmap& b);
+
+  //----------------------------------------------------------------------------
+  //! Number of ids present in both bitmaps, without building the result
+  //----------------------------------------------------------------------------
+  static uint64_t intersectionSize(const FileBitmap& a, const FileBitmap& b);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Find the chunk of the given key or the position where it would go
+  //----------------------------------------------------------------------------
+  size_t lowerBound(uint64_t key) const;
+
+  //----------------------------------------------------------------------------
+  //! Intersection of two chunks with the same key
+  //----------------------------------------------------------------------------
+  static Chunk intersectChunks(const Chunk& a, const Chunk& b);
+
+  //----------------------------------------------------------------------------
+  //! Difference of two chunks with the same key
+  //----------------------------------------------------------------------------
+  static Chunk subtractChunks(const Chunk& a, const Chunk& b);
+
+  //----------------------------------------------------------------------------
+  //! Append a chunk resulting of a set operation, in the representation
+  //! matching its cardinality, dropping it if empty
+  //----------------------------------------------------------------------------
+  void appendChunk(Chunk&& chunk);
+
+  std::vector<Chunk> mChunks; ///< Chunks sorted by key
+  uint64_t mSize; ///< Total number of ids
+};
+
+EOSNSNAMESPACE_END
+
+#endif
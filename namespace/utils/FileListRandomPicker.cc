@@ -57,4 +57,16 @@ bool pickRandomFile(const IFsView::FileList &filelist, eos::IFileMD::id_t &retva
   }
 }
 
+bool pickRandomFile(const FileBitmap &bitmap, eos::IFileMD::id_t &retval) {
+  if(bitmap.empty()) {
+    return false;
+  }
+
+  std::uniform_int_distribution<uint64_t> distribution(0, bitmap.size() - 1);
+  std::unique_lock<std::mutex> lock(generatorMtx);
+  uint64_t rank = distribution(generator);
+  lock.unlock();
+  return bitmap.select(rank, retval);
+}
+
 EOSNSNAMESPACE_END
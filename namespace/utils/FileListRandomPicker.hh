@@ -27,4 +27,7 @@ EOSNSNAMESPACE_BEGIN
 
 bool pickRandomFile(const IFsView::FileList &filelist, eos::IFileMD::id_t &retval);
 
+class FileBitmap;
+bool pickRandomFile(const FileBitmap &bitmap, eos::IFileMD::id_t &retval);
+
 EOSNSNAMESPACE_END
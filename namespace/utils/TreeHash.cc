@@ -0,0 +1,170 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Merkle-style hash of the subtree of a container
+//------------------------------------------------------------------------------
+
+#include "namespace/utils/TreeHash.hh"
+#include "namespace/interface/ContainerIterators.hh"
+#include "namespace/interface/IContainerMDSvc.hh"
+#include "namespace/interface/IFileMDSvc.hh"
+#include "namespace/MDException.hh"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+EOSNSNAMESPACE_BEGIN
+
+namespace
+{
+constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+//------------------------------------------------------------------------------
+// FNV-1a over a buffer
+//------------------------------------------------------------------------------
+uint64_t Fnv(uint64_t hash, const void* data, size_t len)
+{
+  const unsigned char* ptr = static_cast<const unsigned char*>(data);
+
+  for (size_t i = 0; i < len; ++i) {
+    hash ^= ptr[i];
+    hash *= kFnvPrime;
+  }
+
+  return hash;
+}
+
+//------------------------------------------------------------------------------
+// FNV-1a over an integer, fixed width and byte order
+//------------------------------------------------------------------------------
+uint64_t Fnv(uint64_t hash, uint64_t value)
+{
+  for (int i = 0; i < 8; ++i) {
+    hash ^= (value & 0xff);
+    hash *= kFnvPrime;
+    value >>= 8;
+  }
+
+  return hash;
+}
+
+//------------------------------------------------------------------------------
+// Final mix of an entry, the entries are summed so that their bits have to
+// be spread over the whole word
+//------------------------------------------------------------------------------
+uint64_t Mix(uint64_t hash)
+{
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9ull;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111ebull;
+  hash ^= hash >> 31;
+  return hash;
+}
+}
+
+//------------------------------------------------------------------------------
+// Check if the tree hashes are maintained
+//------------------------------------------------------------------------------
+bool
+TreeHash::IsEnabled()
+{
+  static bool enabled = []() {
+    const char* ptr = getenv("EOS_NS_TREE_HASH");
+    return (ptr && strlen(ptr) && strcmp(ptr, "0"));
+  }();
+  return enabled;
+}
+
+//------------------------------------------------------------------------------
+// Entry of a file in the tree hash of its container
+//------------------------------------------------------------------------------
+uint64_t
+TreeHash::FileEntry(const IFileMD* fmd)
+{
+  const std::string name = fmd->getName();
+  IFileMD::ctime_t mtime;
+  fmd->getMTime(mtime);
+  const Buffer xs = fmd->getChecksum();
+  // The leading tag keeps a file and a subcontainer with the same name apart
+  uint64_t hash = Fnv(kFnvOffset, 'f');
+  hash = Fnv(hash, name.length());
+  hash = Fnv(hash, name.c_str(), name.length());
+  hash = Fnv(hash, fmd->getSize());
+  hash = Fnv(hash, mtime.tv_sec);
+  hash = Fnv(hash, mtime.tv_nsec);
+  hash = Fnv(hash, xs.getDataPtr(), xs.getSize());
+  return Mix(hash);
+}
+
+//------------------------------------------------------------------------------
+// Entry of a subcontainer in the tree hash of its parent
+//------------------------------------------------------------------------------
+uint64_t
+TreeHash::ContainerEntry(const std::string& name, uint64_t tree_hash)
+{
+  uint64_t hash = Fnv(kFnvOffset, 'd');
+  hash = Fnv(hash, name.length());
+  hash = Fnv(hash, name.c_str(), name.length());
+  hash = Fnv(hash, tree_hash);
+  return Mix(hash);
+}
+
+//------------------------------------------------------------------------------
+// Compute the tree hash of a container from its direct children
+//------------------------------------------------------------------------------
+uint64_t
+TreeHash::Compute(const IContainerMDPtr& cont, IFileMDSvc* file_svc,
+                  IContainerMDSvc* cont_svc)
+{
+  uint64_t tree_hash = 0;
+
+  for (auto fit = FileMapIterator(cont); fit.valid(); fit.next()) {
+    try {
+      tree_hash += FileEntry(file_svc->getFileMD(fit.value()).get());
+    } catch (const MDException& e) {
+      continue;
+    }
+  }
+
+  for (auto cit = ContainerMapIterator(cont); cit.valid(); cit.next()) {
+    try {
+      tree_hash += ContainerEntry(cit.key(),
+                                  cont_svc->getContainerMD(cit.value())->getTreeHash());
+    } catch (const MDException& e) {
+      continue;
+    }
+  }
+
+  return tree_hash;
+}
+
+//------------------------------------------------------------------------------
+// Format a tree hash as 16 hexadecimal digits
+//------------------------------------------------------------------------------
+std::string
+TreeHash::ToHex(uint64_t tree_hash)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long) tree_hash);
+  return std::string(buffer);
+}
+
+EOSNSNAMESPACE_END
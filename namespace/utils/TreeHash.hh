@@ -0,0 +1,90 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Merkle-style hash of the subtree of a container
+//------------------------------------------------------------------------------
+
+#ifndef EOS_NS_TREE_HASH_HH
+#define EOS_NS_TREE_HASH_HH
+
+#include "namespace/Namespace.hh"
+#include "namespace/interface/IContainerMD.hh"
+#include <stdint.h>
+#include <string>
+
+EOSNSNAMESPACE_BEGIN
+
+class IFileMD;
+class IFileMDSvc;
+class IContainerMDSvc;
+
+//------------------------------------------------------------------------------
+//! The tree hash of a container is the sum modulo 2^64 of the entries of its
+//! children: a file enters with its name, size, mtime and checksum, a
+//! subcontainer with its name and its own tree hash. The sum does not depend
+//! on the order of the children and a change of one child is applied to its
+//! parent by swapping the old entry for the new one, so two subtrees with the
+//! same tree hash can be skipped by diff and sync tools without listing them.
+//!
+//! The tree hash is maintained by the container accounting only if
+//! EOS_NS_TREE_HASH is set, otherwise it stays 0.
+//------------------------------------------------------------------------------
+class TreeHash
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Check if the tree hashes are maintained, set by EOS_NS_TREE_HASH
+  //----------------------------------------------------------------------------
+  static bool IsEnabled();
+
+  //----------------------------------------------------------------------------
+  //! Entry of a file in the tree hash of its container
+  //----------------------------------------------------------------------------
+  static uint64_t FileEntry(const IFileMD* fmd);
+
+  //----------------------------------------------------------------------------
+  //! Entry of a subcontainer in the tree hash of its parent
+  //!
+  //! @param name name of the subcontainer
+  //! @param tree_hash tree hash of the subcontainer
+  //----------------------------------------------------------------------------
+  static uint64_t ContainerEntry(const std::string& name, uint64_t tree_hash);
+
+  //----------------------------------------------------------------------------
+  //! Compute the tree hash of a container from its direct children, the tree
+  //! hashes of the subcontainers being taken as they are
+  //!
+  //! @param cont container
+  //! @param file_svc file metadata service
+  //! @param cont_svc container metadata service
+  //!
+  //! @return tree hash, children which can not be fetched are left out
+  //----------------------------------------------------------------------------
+  static uint64_t Compute(const IContainerMDPtr& cont, IFileMDSvc* file_svc,
+                          IContainerMDSvc* cont_svc);
+
+  //----------------------------------------------------------------------------
+  //! Format a tree hash as 16 hexadecimal digits
+  //----------------------------------------------------------------------------
+  static std::string ToHex(uint64_t tree_hash);
+};
+
+EOSNSNAMESPACE_END
+
+#endif
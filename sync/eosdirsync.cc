@@ -26,11 +26,25 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
-#include <sys/mman.h>
 #include <fcntl.h>
-#include <sys/types.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <poll.h>
+#ifndef __APPLE__
+#include <sys/inotify.h>
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdSys/XrdSysTimer.hh"
@@ -41,14 +55,43 @@
 void usage()
 {
   fprintf(stderr, "usage: %s <src-dir> <dst-url-dir> [--debug]\n", PROGNAME);
+  fprintf(stderr, "       EOS_DIRSYNC_THREADS=<n>      parallel uploads "
+          "(default 8)\n");
+  fprintf(stderr, "       EOS_DIRSYNC_DEBOUNCE_MS=<ms> quiet time of a "
+          "changed file before its upload (default 1000)\n");
   exit(-1);
 }
 
 #define TRANSFERBLOCKSIZE 1024*1024*4
 
-bool forwardFile(XrdOucString& filename, XrdOucString& destfilename)
+//------------------------------------------------------------------------------
+// Get a positive integer from the environment
+//------------------------------------------------------------------------------
+static long getEnvLong(const char* name, long def)
+{
+  const char* ptr = getenv(name);
+  long val = (ptr ? strtol(ptr, nullptr, 10) : 0);
+  return ((val > 0) ? val : def);
+}
+
+//------------------------------------------------------------------------------
+//! Destination file kept open by an upload worker, source files are
+//! synchronized by appending the bytes the destination doesn't have yet
+//------------------------------------------------------------------------------
+struct RemoteFile {
+  std::unique_ptr<XrdCl::File> mFile; ///< open destination file
+  uint64_t mSize {0}; ///< size of the destination file
+  ino_t mIno {0}; ///< inode of the source file last synchronized
+  std::chrono::steady_clock::time_point mLastUse; ///< time of the last upload
+};
+
+//------------------------------------------------------------------------------
+// Open the destination file creating it if needed
+//------------------------------------------------------------------------------
+static bool openRemote(XrdCl::FileSystem& fs, const std::string& destfilename,
+                       RemoteFile& remote)
 {
-  XrdOucString destfile = destfilename;
+  XrdOucString destfile = destfilename.c_str();
   int pos1 = destfile.find("//");
   int pos2 = destfile.find("//", pos1 + 2);
 
@@ -58,128 +101,405 @@ bool forwardFile(XrdOucString& filename, XrdOucString& destfilename)
   }
 
   destfile.erase(0, pos2 + 1);
-  XrdCl::Buffer arg;
   XrdCl::StatInfo* stat_info = 0;
-  XrdCl::URL url(destfilename.c_str());
-
-  if (!url.IsValid()) {
-    eos_static_err("error=URL is not valid: %s", destfilename.c_str());
-    exit(-1);
-  }
-
-  //.............................................................................
-  // Get XrdCl::FileSystem object
-  //.............................................................................
-  XrdCl::FileSystem* fs = new XrdCl::FileSystem(url);
-
-  if (!fs) {
-    eos_static_crit("cannot create FS obj to %s\n", destfilename.c_str());
-    exit(-1);
-  }
-
-  //..................................................................
-  // Do a remote stat using XrdCl::FileSystem
-  //..................................................................
   XrdCl::OpenFlags::Flags flags_xrdcl;
   uint16_t mode_xrdcl = XrdCl::Access::UR | XrdCl::Access::UW | XrdCl::Access::GR
                         |
                         XrdCl::Access::GW | XrdCl::Access::OR;
 
-  if (!fs->Stat(destfile.c_str(), stat_info).IsOK()) {
+  if (!fs.Stat(destfile.c_str(), stat_info).IsOK()) {
     flags_xrdcl = XrdCl::OpenFlags::MakePath | XrdCl::OpenFlags::New;
   } else {
     flags_xrdcl = XrdCl::OpenFlags::MakePath | XrdCl::OpenFlags::Update;
   }
 
-  XrdCl::File* file = new XrdCl::File();
+  delete stat_info;
+  remote.mFile.reset(new XrdCl::File());
 
-  if (!file->Open(destfilename.c_str(), flags_xrdcl,
-                  (XrdCl::Access::Mode)mode_xrdcl).IsOK()) {
+  if (!remote.mFile->Open(destfilename, flags_xrdcl,
+                          (XrdCl::Access::Mode)mode_xrdcl).IsOK()) {
     eos_static_err("cannot open remote file %s\n", destfilename.c_str());
-    delete stat_info;
-    delete fs;
-    delete file;
+    remote.mFile.reset();
     return false;
   }
 
-  //............................................................................
-  // Free used memory by stat
-  //............................................................................
-  delete stat_info;
-  delete fs;
-  struct stat srcstat;
   XrdCl::StatInfo* dststat = 0;
-  bool success = true;
+
+  if (!remote.mFile->Stat(true, dststat).IsOK()) {
+    eos_static_err("cannot stat destination file %s", destfilename.c_str());
+    delete dststat;
+    remote.mFile.reset();
+    return false;
+  }
+
+  remote.mSize = dststat->GetSize();
+  delete dststat;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Close the destination file, which commits its size
+//------------------------------------------------------------------------------
+static void closeRemote(RemoteFile& remote)
+{
+  if (remote.mFile) {
+    (void) remote.mFile->Close();
+    remote.mFile.reset();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Synchronize a source file into its destination. A destination shorter than
+// the source gets only the missing bytes appended, as for log files, a longer
+// one or the destination of a replaced source file is rewritten completely.
+//------------------------------------------------------------------------------
+static bool forwardFile(XrdCl::FileSystem& fs, const std::string& filename,
+                        const std::string& destfilename, RemoteFile& remote)
+{
+  struct stat srcstat;
   int fd = open(filename.c_str(), O_RDONLY);
 
   if (fd < 0) {
     eos_static_err("cannot open source file %s - errno=%d ", filename.c_str(),
                    errno);
-    success = false;
-  } else {
-    if (fstat(fd, &srcstat)) {
-      eos_static_err("cannot stat source file %s - errno=%d ", filename.c_str(),
-                     errno);
-      success = false;
-    } else {
-      if (!file->Stat(true, dststat).IsOK()) {
-        eos_static_err("cannot stat destination file %s", destfilename.c_str());
-        delete dststat;
-        delete file;
-        close(fd);
-        return false;
-      }
+    return false;
+  }
+
+  if (fstat(fd, &srcstat)) {
+    eos_static_err("cannot stat source file %s - errno=%d ", filename.c_str(),
+                   errno);
+    close(fd);
+    return false;
+  }
+
+  bool replaced = (remote.mIno && (remote.mIno != srcstat.st_ino));
+
+  if (!remote.mFile && !openRemote(fs, destfilename, remote)) {
+    close(fd);
+    return false;
+  }
+
+  remote.mIno = srcstat.st_ino;
+  remote.mLastUse = std::chrono::steady_clock::now();
+
+  if (replaced || (remote.mSize > static_cast<uint64_t>(srcstat.st_size))) {
+    if (!remote.mFile->Truncate(0).IsOK()) {
+      eos_static_err("cannot truncate remote file %s", destfilename.c_str());
+      closeRemote(remote);
+      close(fd);
+      return false;
+    }
+
+    remote.mSize = 0;
+  }
+
+  bool success = true;
+
+  if (remote.mSize < static_cast<uint64_t>(srcstat.st_size)) {
+    std::unique_ptr<char[]> buffer(new char[TRANSFERBLOCKSIZE]);
+    eos_static_debug("syncing %s offset=%llu size=%llu", filename.c_str(),
+                     (unsigned long long) remote.mSize,
+                     (unsigned long long) srcstat.st_size);
 
-      if (dststat->GetSize() == static_cast<uint64_t>(srcstat.st_size)) {
-        // if the file exists already with the correct size we don't need to copoy
-        delete dststat;
-        delete file;
-        close(fd);
-        return true;
+    while (remote.mSize < static_cast<uint64_t>(srcstat.st_size)) {
+      ssize_t length = pread(fd, buffer.get(), TRANSFERBLOCKSIZE, remote.mSize);
+
+      if (length <= 0) {
+        // the source shrank meanwhile, the next change rewrites it
+        break;
       }
 
-      if (!file->Truncate(0).IsOK()) {
-        eos_static_err("cannot truncate remote file");
+      if (!remote.mFile->Write(remote.mSize, length, buffer.get()).IsOK()) {
+        eos_static_err("cannot write remote block at %llu/%lu\n",
+                       (unsigned long long) remote.mSize, (unsigned long) length);
         success = false;
-      } else {
-        char* copyptr = (char*) mmap(NULL, srcstat.st_size, PROT_READ, MAP_SHARED, fd,
-                                     0);
-
-        if (!copyptr) {
-          eos_static_err("cannot map source file ");
-          success = false;
-        } else {
-          for (unsigned long long offset = 0;
-               offset < (unsigned long long)srcstat.st_size;
-               offset += (TRANSFERBLOCKSIZE)) {
-            unsigned long long length;
-
-            if ((srcstat.st_size - offset) > TRANSFERBLOCKSIZE) {
-              length = TRANSFERBLOCKSIZE;
-            } else {
-              length = srcstat.st_size - offset;
-            }
-
-            if (!file->Write(offset, length, copyptr + offset).IsOK()) {
-              eos_static_err("cannot write remote block at %llu/%lu\n",
-                             (unsigned long long)offset, (unsigned long)length);
-              success = false;
-              break;
-            }
-          }
+        break;
+      }
+
+      remote.mSize += length;
+    }
+  }
+
+  if (!success) {
+    // the size of the destination is unknown, stat it again next time
+    closeRemote(remote);
+  }
+
+  close(fd);
+  return success;
+}
+
+//------------------------------------------------------------------------------
+//! Pool of upload workers. A file always goes to the same worker, which
+//! keeps the destination open while the file changes and shares one
+//! XrdCl::FileSystem and the XrdCl connections for all its uploads.
+//------------------------------------------------------------------------------
+class UploadPool
+{
+public:
+  //! Number of idle destination files kept open per worker
+  static constexpr size_t kMaxOpenPerWorker = 64;
+  //! Idle time after which a destination file is closed
+  static constexpr std::chrono::seconds kIdleClose {10};
+
+  UploadPool(const std::string& srcdir, const std::string& dsturl,
+             size_t nworkers):
+    mSrcDir(srcdir), mDstUrl(dsturl), mWorkers(nworkers)
+  {
+    for (size_t i = 0; i < mWorkers.size(); ++i) {
+      mWorkers[i].reset(new Worker());
+      mWorkers[i]->mThread = std::thread(&UploadPool::Run, this,
+                                         std::ref(*mWorkers[i]));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Queue the upload of a file of the source directory, unless it is queued
+  //----------------------------------------------------------------------------
+  void Submit(const std::string& name)
+  {
+    Worker& worker = *mWorkers[std::hash<std::string>()(name) %
+                               mWorkers.size()];
+    std::lock_guard<std::mutex> lock(worker.mMutex);
+
+    if (worker.mPending.insert(name).second) {
+      worker.mQueue.push_back(name);
+      worker.mCond.notify_one();
+    }
+  }
+
+private:
+  struct Worker {
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    std::deque<std::string> mQueue; ///< files to upload in order
+    std::set<std::string> mPending; ///< files in the queue
+  };
+
+  //----------------------------------------------------------------------------
+  //! Worker loop
+  //----------------------------------------------------------------------------
+  void Run(Worker& worker)
+  {
+    XrdCl::URL url(mDstUrl);
+
+    if (!url.IsValid()) {
+      eos_static_crit("error=URL is not valid: %s", mDstUrl.c_str());
+      exit(-1);
+    }
+
+    XrdCl::FileSystem fs(url);
+    std::map<std::string, RemoteFile> open_files;
+
+    while (true) {
+      std::string name;
+      {
+        std::unique_lock<std::mutex> lock(worker.mMutex);
+
+        if (worker.mQueue.empty()) {
+          worker.mCond.wait_for(lock, kIdleClose);
+        }
+
+        if (!worker.mQueue.empty()) {
+          name = worker.mQueue.front();
+          worker.mQueue.pop_front();
+          worker.mPending.erase(name);
+        }
+      }
+
+      if (name.length()) {
+        RemoteFile& remote = open_files[name];
+
+        if (!forwardFile(fs, mSrcDir + "/" + name, mDstUrl + "/" + name,
+                         remote)) {
+          eos_static_err("cannot sync file %s/%s => %s", mSrcDir.c_str(),
+                         name.c_str(), mDstUrl.c_str());
+        }
+      }
+
+      CloseIdle(open_files);
+    }
+  }
 
-          munmap(copyptr, srcstat.st_size);
+  //----------------------------------------------------------------------------
+  //! Close the destination files idle since kIdleClose, or the least recently
+  //! used ones above kMaxOpenPerWorker
+  //----------------------------------------------------------------------------
+  void CloseIdle(std::map<std::string, RemoteFile>& open_files)
+  {
+    auto now = std::chrono::steady_clock::now();
+    size_t nopen = 0;
+
+    for (auto it = open_files.begin(); it != open_files.end(); ++it) {
+      if (it->second.mFile && (now - it->second.mLastUse > kIdleClose)) {
+        closeRemote(it->second);
+      }
+
+      nopen += (it->second.mFile ? 1 : 0);
+    }
+
+    while (nopen > kMaxOpenPerWorker) {
+      auto lru = open_files.end();
+
+      for (auto it = open_files.begin(); it != open_files.end(); ++it) {
+        if (it->second.mFile && ((lru == open_files.end()) ||
+                                 (it->second.mLastUse < lru->second.mLastUse))) {
+          lru = it;
         }
       }
+
+      closeRemote(lru->second);
+      --nopen;
     }
+  }
 
-    close(fd);
+  std::string mSrcDir; ///< source directory
+  std::string mDstUrl; ///< destination directory URL
+  std::vector<std::unique_ptr<Worker>> mWorkers; ///< upload workers
+};
+
+constexpr size_t UploadPool::kMaxOpenPerWorker;
+constexpr std::chrono::seconds UploadPool::kIdleClose;
+
+//------------------------------------------------------------------------------
+// Queue the upload of all the regular files of the source directory
+//------------------------------------------------------------------------------
+static bool scanDirectory(const XrdOucString& sourcedir, UploadPool& pool)
+{
+  DIR* dir = opendir(sourcedir.c_str());
+
+  if (!dir) {
+    eos_static_err("cannot open source directory %s - errno=%d - retry in 1 minute ...",
+                   sourcedir.c_str(), errno);
+    return false;
   }
 
-  delete dststat;
-  delete file;
-  return success;
+  struct dirent* entry;
+
+  while ((entry = readdir(dir))) {
+    XrdOucString sentry = sourcedir;
+    sentry += "/";
+    sentry += entry->d_name;
+    struct stat entrystat;
+
+    if (stat(sentry.c_str(), &entrystat)) {
+      eos_static_err("cannot stat file %s", sentry.c_str());
+    } else {
+      if (!S_ISREG(entrystat.st_mode)) {
+        eos_static_info("skipping %s [not a file]", sentry.c_str());
+      } else {
+        pool.Submit(entry->d_name);
+      }
+    }
+  }
+
+  closedir(dir);
+  return true;
+}
+
+#ifndef __APPLE__
+//------------------------------------------------------------------------------
+// Follow the changes of the source directory through inotify. A changed file
+// is uploaded once it has been quiet for the debounce time, a file changing
+// all the time at the latest after ten times the debounce time.
+//
+// Returns if the watch of the directory was lost.
+//------------------------------------------------------------------------------
+static void watchDirectory(int inotify_fd, const XrdOucString& sourcedir,
+                           UploadPool& pool, std::chrono::milliseconds debounce)
+{
+  typedef std::chrono::steady_clock Clock;
+  int watch_fd = inotify_add_watch(inotify_fd, sourcedir.c_str(),
+                                   IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO |
+                                   IN_CREATE | IN_ATTRIB);
+
+  if (watch_fd < 0) {
+    eos_static_err("cannot watch source directory %s - errno=%d",
+                   sourcedir.c_str(), errno);
+    return;
+  }
+
+  // everything changed before the watch is picked up by a full scan
+  if (!scanDirectory(sourcedir, pool)) {
+    inotify_rm_watch(inotify_fd, watch_fd);
+    return;
+  }
+
+  // first and last change of the files waiting for the debounce
+  std::map<std::string, std::pair<Clock::time_point, Clock::time_point>> dirty;
+  std::vector<char> buffer(64 * 1024);
+
+  while (true) {
+    struct pollfd pfd;
+    pfd.fd = inotify_fd;
+    pfd.events = POLLIN;
+    int timeout = (dirty.empty() ? 1000 : (int) debounce.count() / 4 + 1);
+    int rc = poll(&pfd, 1, timeout);
+
+    if (rc > 0) {
+      ssize_t length = read(inotify_fd, buffer.data(), buffer.size());
+
+      if (length <= 0) {
+        eos_static_crit("read via inotify returned errno=%d", errno);
+        inotify_rm_watch(inotify_fd, watch_fd);
+        return;
+      }
+
+      Clock::time_point now = Clock::now();
+
+      for (ssize_t pos = 0; pos < length;) {
+        struct inotify_event* event = (struct inotify_event*) &buffer[pos];
+        pos += sizeof(struct inotify_event) + event->len;
+
+        if (event->mask & IN_Q_OVERFLOW) {
+          eos_static_warning("msg=\"inotify queue overflow, rescanning\" dir=%s",
+                             sourcedir.c_str());
+          scanDirectory(sourcedir, pool);
+          continue;
+        }
+
+        if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+          eos_static_warning("msg=\"lost the watch of the source directory\" "
+                             "dir=%s", sourcedir.c_str());
+          inotify_rm_watch(inotify_fd, watch_fd);
+          return;
+        }
+
+        if (event->len && !(event->mask & IN_ISDIR)) {
+          auto it = dirty.find(event->name);
+
+          if (it == dirty.end()) {
+            dirty[event->name] = std::make_pair(now, now);
+          } else {
+            it->second.second = now;
+          }
+        }
+      }
+    }
+
+    Clock::time_point now = Clock::now();
+
+    for (auto it = dirty.begin(); it != dirty.end();) {
+      if ((now - it->second.second >= debounce) ||
+          (now - it->second.first >= 10 * debounce)) {
+        XrdOucString sentry = sourcedir;
+        sentry += "/";
+        sentry += it->first.c_str();
+        struct stat entrystat;
+
+        if (!stat(sentry.c_str(), &entrystat) && S_ISREG(entrystat.st_mode)) {
+          pool.Submit(it->first);
+        }
+
+        it = dirty.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
 }
+#endif
 
 int main(int argc, char* argv[])
 {
@@ -203,6 +523,27 @@ int main(int argc, char* argv[])
   eos_static_notice("starting %s=>%s", argv[1], argv[2]);
   XrdOucString sourcedir = argv[1];
   XrdOucString dsturl = argv[2];
+  size_t nthreads = getEnvLong("EOS_DIRSYNC_THREADS", 8);
+  std::chrono::milliseconds debounce(getEnvLong("EOS_DIRSYNC_DEBOUNCE_MS",
+                                     1000));
+  UploadPool pool(sourcedir.c_str(), dsturl.c_str(), nthreads);
+  int inotify_fd = -1;
+#ifndef __APPLE__
+  inotify_fd = inotify_init();
+
+  if (inotify_fd < 0) {
+    fprintf(stderr,
+            "error: unable to initialize inotify interface - will use polling\n");
+  }
+
+  while (inotify_fd >= 0) {
+    watchDirectory(inotify_fd, sourcedir, pool, debounce);
+    // the directory is gone or could not be watched, wait for it
+    XrdSysTimer sleeper;
+    sleeper.Wait(60000);
+  }
+
+#endif
   struct stat laststat;
   struct stat presentstat;
   memset(&laststat   , 0, sizeof(struct stat));
@@ -219,47 +560,14 @@ int main(int argc, char* argv[])
 
     if (presentstat.st_mtime != laststat.st_mtime) {
       // yes, there are modifications, loop over the contents in that directory
-      DIR* dir = opendir(sourcedir.c_str());
-
-      if (!dir) {
-        eos_static_err("cannot open source directory %s - errno=%d - retry in 1 minute ...",
-                       sourcedir.c_str(), errno);
+      if (!scanDirectory(sourcedir, pool)) {
         XrdSysTimer sleeper;
         sleeper.Wait(60000);
         continue;
       }
-
-      struct dirent* entry;
-
-      while ((entry = readdir(dir))) {
-        XrdOucString dstfile = dsturl;
-        XrdOucString sentry = sourcedir;
-        XrdOucString file = entry->d_name;
-        sentry += "/";
-        sentry += entry->d_name;
-        dstfile += "/";
-        dstfile += entry->d_name;
-        struct stat entrystat;
-
-        if (stat(sentry.c_str(), &entrystat)) {
-          eos_static_err("cannot stat file %s", sentry.c_str());
-        } else {
-          if (!S_ISREG(entrystat.st_mode)) {
-            eos_static_info("skipping %s [not a file]", sentry.c_str());
-          } else {
-            if (!forwardFile(sentry, dstfile)) {
-              eos_static_err("cannot sync file %s => %s", sentry.c_str(), dsturl.c_str());
-            }
-          }
-        }
-      }
-
-      closedir(dir);
     }
 
     memcpy(&laststat, &presentstat, sizeof(struct stat));
     usleep(10000000);
   } while (1);
 }
-
-
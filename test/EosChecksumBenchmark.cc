@@ -30,6 +30,8 @@
 #include "common/Timing.hh"
 #include "common/StringConversion.hh"
 #include "fst/checksum/ChecksumPlugins.hh"
+#include "common/crc32c/checksumkernels.h"
+#include "common/crc32c/crc32c.h"
 /*-----------------------------------------------------------------------------*/
 #include <XrdPosix/XrdPosixXrootd.hh>
 #include <XrdOuc/XrdOucString.hh>
@@ -139,6 +141,38 @@ int main(int argc, char* argv[])
         }
       }
 
+      // Raw throughput of every kernel supported by this CPU
+      const std::vector<std::pair<std::string, const checksum::ChecksumKernel*>>
+      kernel_sets = {
+        {"adler32", checksum::adler32Kernels()},
+        {"crc32", checksum::crc32Kernels()},
+        {"crc32c", checksum::crc32cKernels()}
+      };
+
+      for (size_t bs = 0; bs < blocksize.size(); bs++) {
+        for (const auto& set : kernel_sets) {
+          for (auto kernel = set.second; kernel->name; ++kernel) {
+            eos::common::Timing tm("Kernel");
+            COMMONTIMING("START", &tm);
+            uint32_t value = 0;
+
+            for (size_t j = 0; j < MEMORYBUFFERSIZE / blocksize[bs]; j++) {
+              value = kernel->function(value, buffer + j * blocksize[bs],
+                                       blocksize[bs]);
+            }
+
+            COMMONTIMING("STOP", &tm);
+            XrdOucString sizestring;
+            eos::common::StringConversion::GetReadableSizeString(sizestring,
+                blocksize[bs], "B");
+            eos_static_info("kernel( %-7s %-8s ) = %08x realtime=%.02f [ms] "
+                            "blocksize=%s rate=%.02f GB/s", set.first.c_str(),
+                            kernel->name, value, tm.RealTime(), sizestring.c_str(),
+                            MEMORYBUFFERSIZE / tm.RealTime() / 1000000.0);
+          }
+        }
+      }
+
       exit(0);
     }
   }
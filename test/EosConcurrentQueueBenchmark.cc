@@ -0,0 +1,314 @@
+//------------------------------------------------------------------------------
+// File: EosConcurrentQueueBenchmark.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! Benchmark comparing the mutex based ConcurrentQueue with the lock-free
+//! BoundedConcurrentQueue for different numbers of producers and consumers.
+//! Every configuration runs for a fixed duration and produces one record in
+//! CSV or JSON format with the throughput and the average queueing latency.
+//------------------------------------------------------------------------------
+
+#include "common/ConcurrentQueue.hh"
+#include "common/BoundedConcurrentQueue.hh"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Benchmark configuration
+//------------------------------------------------------------------------------
+struct Config {
+  std::vector<std::string> mImpls {"mutex", "bounded"};
+  std::vector<size_t> mProducers {1, 2, 4, 8, 16, 32, 64};
+  std::vector<size_t> mConsumers {4};
+  size_t mCapacity {1024};
+  unsigned mDurationMs {1000};
+  std::string mFormat {"csv"};
+};
+
+//------------------------------------------------------------------------------
+//! Result of one benchmark run
+//------------------------------------------------------------------------------
+struct Result {
+  uint64_t mOps {0};
+  uint64_t mSumLatencyNs {0};
+  double mElapsedSec {0};
+};
+
+//------------------------------------------------------------------------------
+//! Per thread counters, padded to avoid false sharing between workers
+//------------------------------------------------------------------------------
+struct alignas(64) ThreadStats {
+  uint64_t mOps {0};
+  uint64_t mSumLatencyNs {0};
+};
+
+//------------------------------------------------------------------------------
+//! Get monotonic time in nanoseconds, 0 is reserved for the stop marker
+//------------------------------------------------------------------------------
+static inline uint64_t
+NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+         (std::chrono::steady_clock::now().time_since_epoch()).count() + 1;
+}
+
+//------------------------------------------------------------------------------
+//! Run one benchmark configuration
+//------------------------------------------------------------------------------
+template <typename Queue>
+static Result
+RunOne(const Config& cfg, Queue& queue, size_t nproducers, size_t nconsumers)
+{
+  std::vector<ThreadStats> stats(nconsumers);
+  std::vector<std::thread> producers;
+  std::vector<std::thread> consumers;
+  std::atomic<bool> start {false};
+  std::atomic<bool> stop {false};
+
+  for (size_t i = 0; i < nconsumers; ++i) {
+    consumers.emplace_back([&, i]() {
+      ThreadStats& st = stats[i];
+      uint64_t value = 0;
+
+      while (true) {
+        queue.wait_pop(value);
+
+        // Stop marker
+        if (value == 0) {
+          break;
+        }
+
+        st.mSumLatencyNs += NowNs() - value;
+        ++st.mOps;
+      }
+    });
+  }
+
+  for (size_t i = 0; i < nproducers; ++i) {
+    producers.emplace_back([&]() {
+      while (!start) {
+        std::this_thread::yield();
+      }
+
+      while (!stop) {
+        uint64_t value = NowNs();
+        queue.push(value);
+      }
+    });
+  }
+
+  auto t0 = std::chrono::steady_clock::now();
+  start = true;
+  std::this_thread::sleep_for(std::chrono::milliseconds(cfg.mDurationMs));
+  stop = true;
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  for (size_t i = 0; i < nconsumers; ++i) {
+    uint64_t marker = 0;
+    queue.push(marker);
+  }
+
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+
+  Result res;
+  res.mElapsedSec = std::chrono::duration<double>
+                    (std::chrono::steady_clock::now() - t0).count();
+
+  for (const auto& st : stats) {
+    res.mOps += st.mOps;
+    res.mSumLatencyNs += st.mSumLatencyNs;
+  }
+
+  return res;
+}
+
+//------------------------------------------------------------------------------
+//! Run one benchmark configuration with the queue implementation by name
+//------------------------------------------------------------------------------
+static Result
+RunImpl(const Config& cfg, const std::string& impl, size_t nproducers,
+        size_t nconsumers)
+{
+  if (impl == "mutex") {
+    eos::common::ConcurrentQueue<uint64_t> queue;
+    return RunOne(cfg, queue, nproducers, nconsumers);
+  }
+
+  eos::common::BoundedConcurrentQueue<uint64_t> queue(cfg.mCapacity);
+  return RunOne(cfg, queue, nproducers, nconsumers);
+}
+
+//------------------------------------------------------------------------------
+//! Split comma separated list of numbers
+//------------------------------------------------------------------------------
+static std::vector<size_t>
+SplitNumbers(const std::string& input)
+{
+  std::vector<size_t> values;
+  std::stringstream ss(input);
+  std::string token;
+
+  while (std::getline(ss, token, ',')) {
+    if (!token.empty()) {
+      values.push_back(strtoul(token.c_str(), nullptr, 10));
+    }
+  }
+
+  return values;
+}
+
+//------------------------------------------------------------------------------
+//! Print usage
+//------------------------------------------------------------------------------
+static void
+Usage()
+{
+  std::cerr << "Usage: eos-queue-benchmark [options]" << std::endl
+            << "  -m <impl,...>    queue implementations (mutex,bounded)"
+            << std::endl
+            << "  -p <n,...>       producer counts" << std::endl
+            << "  -c <n,...>       consumer counts" << std::endl
+            << "  -s <n>           capacity of the bounded queue" << std::endl
+            << "  -d <ms>          duration of each run in milliseconds"
+            << std::endl
+            << "  -f <csv|json>    output format" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  Config cfg;
+  int c;
+
+  while ((c = getopt(argc, argv, "m:p:c:s:d:f:h")) != -1) {
+    switch (c) {
+    case 'm': {
+      cfg.mImpls.clear();
+      std::stringstream ss(optarg);
+      std::string token;
+
+      while (std::getline(ss, token, ',')) {
+        if ((token != "mutex") && (token != "bounded")) {
+          std::cerr << "error: unknown queue implementation " << token
+                    << std::endl;
+          return 1;
+        }
+
+        cfg.mImpls.push_back(token);
+      }
+
+      break;
+    }
+
+    case 'p':
+      cfg.mProducers = SplitNumbers(optarg);
+      break;
+
+    case 'c':
+      cfg.mConsumers = SplitNumbers(optarg);
+      break;
+
+    case 's':
+      cfg.mCapacity = strtoul(optarg, nullptr, 10);
+      break;
+
+    case 'd':
+      cfg.mDurationMs = strtoul(optarg, nullptr, 10);
+      break;
+
+    case 'f':
+      cfg.mFormat = optarg;
+      break;
+
+    default:
+      Usage();
+      return 1;
+    }
+  }
+
+  if ((cfg.mFormat != "csv") && (cfg.mFormat != "json")) {
+    Usage();
+    return 1;
+  }
+
+  if (cfg.mFormat == "csv") {
+    std::cout << "impl,producers,consumers,capacity,duration_s,ops,"
+              "ops_per_sec,avg_latency_ns" << std::endl;
+  } else {
+    std::cout << "[" << std::endl;
+  }
+
+  bool first = true;
+
+  for (const auto& impl : cfg.mImpls) {
+    for (auto nconsumers : cfg.mConsumers) {
+      for (auto nproducers : cfg.mProducers) {
+        Result res = RunImpl(cfg, impl, nproducers, nconsumers);
+        double ops_sec = res.mOps / res.mElapsedSec;
+        uint64_t avg_latency = res.mOps ? res.mSumLatencyNs / res.mOps : 0;
+        size_t capacity = (impl == "bounded") ? cfg.mCapacity : 0;
+        char line[1024];
+
+        if (cfg.mFormat == "csv") {
+          snprintf(line, sizeof(line), "%s,%zu,%zu,%zu,%.3f,%llu,%.0f,%llu",
+                   impl.c_str(), nproducers, nconsumers, capacity,
+                   res.mElapsedSec, (unsigned long long)res.mOps, ops_sec,
+                   (unsigned long long)avg_latency);
+        } else {
+          snprintf(line, sizeof(line), "%s{\"impl\":\"%s\",\"producers\":%zu,"
+                   "\"consumers\":%zu,\"capacity\":%zu,\"duration_s\":%.3f,"
+                   "\"ops\":%llu,\"ops_per_sec\":%.0f,\"avg_latency_ns\":%llu}",
+                   first ? "  " : ",\n  ", impl.c_str(), nproducers, nconsumers,
+                   capacity, res.mElapsedSec, (unsigned long long)res.mOps,
+                   ops_sec, (unsigned long long)avg_latency);
+        }
+
+        first = false;
+        std::cout << line;
+
+        if (cfg.mFormat == "csv") {
+          std::cout << std::endl;
+        } else {
+          std::cout.flush();
+        }
+      }
+    }
+  }
+
+  if (cfg.mFormat == "json") {
+    std::cout << std::endl << "]" << std::endl;
+  }
+
+  return 0;
+}
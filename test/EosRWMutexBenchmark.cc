@@ -0,0 +1,503 @@
+//------------------------------------------------------------------------------
+// File: EosRWMutexBenchmark.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! Benchmark comparing the IRWMutex implementations under different reader
+//! and writer ratios, thread counts and thread placements across NUMA nodes.
+//! Every configuration runs for a fixed duration and produces one record in
+//! CSV or JSON format so that results from different machines can be compared.
+//------------------------------------------------------------------------------
+
+#include "common/IRWMutex.hh"
+#include "common/BigReaderRWMutex.hh"
+#include "common/PthreadRWMutex.hh"
+#include "common/SharedMutex.hh"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <pthread.h>
+#include <random>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using eos::common::IRWMutex;
+
+//------------------------------------------------------------------------------
+//! Benchmark configuration
+//------------------------------------------------------------------------------
+struct Config {
+  std::vector<std::string> mImpls {
+    "pthread", "pthread-rd", "shared", "bigreader", "bigreader-rd"
+  };
+  std::vector<size_t> mThreads {1, 2, 4, 8, 16, 32, 64};
+  std::vector<unsigned> mReadPct {100, 99, 90, 50};
+  std::vector<std::string> mPlacements {"none", "compact", "spread"};
+  unsigned mDurationMs {1000};
+  unsigned mWork {50};
+  uint64_t mTimedRdNs {0};
+  std::string mFormat {"csv"};
+};
+
+//------------------------------------------------------------------------------
+//! Result of one benchmark run
+//------------------------------------------------------------------------------
+struct Result {
+  uint64_t mRdOps {0};
+  uint64_t mWrOps {0};
+  uint64_t mRdTimeouts {0};
+  uint64_t mMaxWrWaitNs {0};
+  uint64_t mSumWrWaitNs {0};
+  double mElapsedSec {0};
+};
+
+//------------------------------------------------------------------------------
+//! Per thread counters, padded to avoid false sharing between workers
+//------------------------------------------------------------------------------
+struct alignas(64) ThreadStats {
+  uint64_t mRdOps {0};
+  uint64_t mWrOps {0};
+  uint64_t mRdTimeouts {0};
+  uint64_t mMaxWrWaitNs {0};
+  uint64_t mSumWrWaitNs {0};
+};
+
+//------------------------------------------------------------------------------
+//! Create mutex implementation by name
+//------------------------------------------------------------------------------
+static std::unique_ptr<IRWMutex>
+MakeMutex(const std::string& name)
+{
+  if (name == "pthread") {
+    return std::unique_ptr<IRWMutex>(new eos::common::PthreadRWMutex(false));
+  } else if (name == "pthread-rd") {
+    return std::unique_ptr<IRWMutex>(new eos::common::PthreadRWMutex(true));
+  } else if (name == "shared") {
+    return std::unique_ptr<IRWMutex>(new eos::common::SharedMutex());
+  } else if (name == "bigreader") {
+    return std::unique_ptr<IRWMutex>(new eos::common::BigReaderRWMutex(false));
+  } else if (name == "bigreader-rd") {
+    return std::unique_ptr<IRWMutex>(new eos::common::BigReaderRWMutex(true));
+  }
+
+  return nullptr;
+}
+
+//------------------------------------------------------------------------------
+//! Parse a cpu list like "0-3,8,10-11" as found in sysfs
+//------------------------------------------------------------------------------
+static std::vector<int>
+ParseCpuList(const std::string& list)
+{
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+
+  while (std::getline(ss, range, ',')) {
+    if (range.empty()) {
+      continue;
+    }
+
+    size_t pos = range.find('-');
+    int first = atoi(range.c_str());
+    int last = (pos == std::string::npos) ? first :
+               atoi(range.c_str() + pos + 1);
+
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  return cpus;
+}
+
+//------------------------------------------------------------------------------
+//! Get the list of cpus of every NUMA node, a single node holding all the
+//! online cpus is returned if the topology is not available.
+//------------------------------------------------------------------------------
+static std::vector<std::vector<int>>
+GetNumaTopology()
+{
+  std::vector<std::vector<int>> nodes;
+
+  for (int node = 0; ; ++node) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) +
+                       "/cpulist");
+
+    if (!file.is_open()) {
+      break;
+    }
+
+    std::string line;
+    std::getline(file, line);
+    std::vector<int> cpus = ParseCpuList(line);
+
+    if (!cpus.empty()) {
+      nodes.push_back(cpus);
+    }
+  }
+
+  if (nodes.empty()) {
+    std::vector<int> cpus;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (long cpu = 0; cpu < ncpu; ++cpu) {
+      cpus.push_back((int)cpu);
+    }
+
+    nodes.push_back(cpus);
+  }
+
+  return nodes;
+}
+
+//------------------------------------------------------------------------------
+//! Compute the cpu of the given worker for the placement policy.
+//! "compact" fills one NUMA node before moving to the next one, "spread"
+//! distributes the workers round-robin across nodes.
+//!
+//! @return cpu number or -1 if the thread should not be pinned
+//------------------------------------------------------------------------------
+static int
+GetWorkerCpu(const std::vector<std::vector<int>>& nodes,
+             const std::string& placement, size_t worker)
+{
+  if (placement == "compact") {
+    size_t total = 0;
+
+    for (const auto& node : nodes) {
+      total += node.size();
+    }
+
+    size_t idx = worker % total;
+
+    for (const auto& node : nodes) {
+      if (idx < node.size()) {
+        return node[idx];
+      }
+
+      idx -= node.size();
+    }
+  } else if (placement == "spread") {
+    const auto& node = nodes[worker % nodes.size()];
+    return node[(worker / nodes.size()) % node.size()];
+  }
+
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+//! Busy work done inside and outside the critical section
+//------------------------------------------------------------------------------
+static inline uint64_t
+DoWork(unsigned iterations, uint64_t seed)
+{
+  for (unsigned i = 0; i < iterations; ++i) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+  }
+
+  return seed;
+}
+
+//------------------------------------------------------------------------------
+//! Run one benchmark configuration
+//------------------------------------------------------------------------------
+static Result
+RunOne(const Config& cfg, const std::string& impl, size_t nthreads,
+       unsigned read_pct, const std::string& placement,
+       const std::vector<std::vector<int>>& nodes)
+{
+  std::unique_ptr<IRWMutex> mutex = MakeMutex(impl);
+  std::vector<ThreadStats> stats(nthreads);
+  std::vector<std::thread> workers;
+  std::atomic<bool> start {false};
+  std::atomic<bool> stop {false};
+  std::atomic<size_t> ready {0};
+  volatile uint64_t shared_value = 0;
+
+  for (size_t i = 0; i < nthreads; ++i) {
+    workers.emplace_back([&, i]() {
+      int cpu = GetWorkerCpu(nodes, placement, i);
+
+      if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        (void) pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+      }
+
+      std::mt19937_64 rng(i + 1);
+      ThreadStats& st = stats[i];
+      uint64_t seed = i;
+      ++ready;
+
+      while (!start) {
+        std::this_thread::yield();
+      }
+
+      while (!stop) {
+        if ((rng() % 100) < read_pct) {
+          if (cfg.mTimedRdNs) {
+            if (mutex->TimedRdLock(cfg.mTimedRdNs)) {
+              ++st.mRdTimeouts;
+              continue;
+            }
+          } else {
+            mutex->LockRead();
+          }
+
+          seed = DoWork(cfg.mWork, seed + shared_value);
+          mutex->UnLockRead();
+          ++st.mRdOps;
+        } else {
+          auto t0 = std::chrono::steady_clock::now();
+          mutex->LockWrite();
+          uint64_t wait_ns = std::chrono::duration_cast<std::chrono::nanoseconds>
+                             (std::chrono::steady_clock::now() - t0).count();
+          shared_value = DoWork(cfg.mWork, shared_value);
+          mutex->UnLockWrite();
+          ++st.mWrOps;
+          st.mSumWrWaitNs += wait_ns;
+
+          if (wait_ns > st.mMaxWrWaitNs) {
+            st.mMaxWrWaitNs = wait_ns;
+          }
+        }
+
+        // Some work outside the critical section
+        seed = DoWork(cfg.mWork, seed);
+      }
+
+      if (seed == 42) {
+        fprintf(stderr, " ");
+      }
+    });
+  }
+
+  while (ready != nthreads) {
+    std::this_thread::yield();
+  }
+
+  auto t_start = std::chrono::steady_clock::now();
+  start = true;
+  std::this_thread::sleep_for(std::chrono::milliseconds(cfg.mDurationMs));
+  stop = true;
+
+  for (auto& th : workers) {
+    th.join();
+  }
+
+  Result res;
+  res.mElapsedSec = std::chrono::duration<double>
+                    (std::chrono::steady_clock::now() - t_start).count();
+
+  for (const auto& st : stats) {
+    res.mRdOps += st.mRdOps;
+    res.mWrOps += st.mWrOps;
+    res.mRdTimeouts += st.mRdTimeouts;
+    res.mSumWrWaitNs += st.mSumWrWaitNs;
+
+    if (st.mMaxWrWaitNs > res.mMaxWrWaitNs) {
+      res.mMaxWrWaitNs = st.mMaxWrWaitNs;
+    }
+  }
+
+  return res;
+}
+
+//------------------------------------------------------------------------------
+//! Split comma separated list
+//------------------------------------------------------------------------------
+static std::vector<std::string>
+Split(const std::string& input)
+{
+  std::vector<std::string> tokens;
+  std::stringstream ss(input);
+  std::string token;
+
+  while (std::getline(ss, token, ',')) {
+    if (!token.empty()) {
+      tokens.push_back(token);
+    }
+  }
+
+  return tokens;
+}
+
+//------------------------------------------------------------------------------
+//! Print usage
+//------------------------------------------------------------------------------
+static void
+Usage()
+{
+  std::cerr << "Usage: eos-rwmutex-benchmark [options]" << std::endl
+            << "  -m <impl,...>    mutex implementations "
+            "(pthread,pthread-rd,shared," << std::endl
+            << "                   bigreader,bigreader-rd)" << std::endl
+            << "  -t <n,...>       thread counts" << std::endl
+            << "  -r <pct,...>     percentage of read operations" << std::endl
+            << "  -p <mode,...>    thread placement (none,compact,spread)"
+            << std::endl
+            << "  -d <ms>          duration of each run in milliseconds"
+            << std::endl
+            << "  -w <n>           work iterations inside/outside the lock"
+            << std::endl
+            << "  -T <ns>          use TimedRdLock with the given timeout"
+            << std::endl
+            << "  -f <csv|json>    output format" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  Config cfg;
+  int c;
+
+  while ((c = getopt(argc, argv, "m:t:r:p:d:w:T:f:h")) != -1) {
+    switch (c) {
+    case 'm':
+      cfg.mImpls = Split(optarg);
+      break;
+
+    case 't':
+      cfg.mThreads.clear();
+
+      for (const auto& tok : Split(optarg)) {
+        cfg.mThreads.push_back(strtoul(tok.c_str(), nullptr, 10));
+      }
+
+      break;
+
+    case 'r':
+      cfg.mReadPct.clear();
+
+      for (const auto& tok : Split(optarg)) {
+        cfg.mReadPct.push_back(strtoul(tok.c_str(), nullptr, 10));
+      }
+
+      break;
+
+    case 'p':
+      cfg.mPlacements = Split(optarg);
+      break;
+
+    case 'd':
+      cfg.mDurationMs = strtoul(optarg, nullptr, 10);
+      break;
+
+    case 'w':
+      cfg.mWork = strtoul(optarg, nullptr, 10);
+      break;
+
+    case 'T':
+      cfg.mTimedRdNs = strtoull(optarg, nullptr, 10);
+      break;
+
+    case 'f':
+      cfg.mFormat = optarg;
+      break;
+
+    default:
+      Usage();
+      return 1;
+    }
+  }
+
+  if ((cfg.mFormat != "csv") && (cfg.mFormat != "json")) {
+    Usage();
+    return 1;
+  }
+
+  for (const auto& impl : cfg.mImpls) {
+    if (!MakeMutex(impl)) {
+      std::cerr << "error: unknown mutex implementation " << impl << std::endl;
+      return 1;
+    }
+  }
+
+  const auto nodes = GetNumaTopology();
+  std::cerr << "# numa_nodes=" << nodes.size() << std::endl;
+
+  if (cfg.mFormat == "csv") {
+    std::cout << "impl,threads,read_pct,placement,timed_rd_ns,duration_s,"
+              "rd_ops,wr_ops,rd_timeouts,ops_per_sec,avg_wr_wait_ns,"
+              "max_wr_wait_ns" << std::endl;
+  } else {
+    std::cout << "[" << std::endl;
+  }
+
+  bool first = true;
+
+  for (const auto& impl : cfg.mImpls) {
+    for (const auto& placement : cfg.mPlacements) {
+      for (auto nthreads : cfg.mThreads) {
+        for (auto read_pct : cfg.mReadPct) {
+          Result res = RunOne(cfg, impl, nthreads, read_pct, placement, nodes);
+          double ops_sec = (res.mRdOps + res.mWrOps) / res.mElapsedSec;
+          uint64_t avg_wr_wait = res.mWrOps ? res.mSumWrWaitNs / res.mWrOps : 0;
+          char line[1024];
+
+          if (cfg.mFormat == "csv") {
+            snprintf(line, sizeof(line), "%s,%zu,%u,%s,%llu,%.3f,%llu,%llu,%llu,"
+                     "%.0f,%llu,%llu", impl.c_str(), nthreads, read_pct,
+                     placement.c_str(), (unsigned long long)cfg.mTimedRdNs,
+                     res.mElapsedSec, (unsigned long long)res.mRdOps,
+                     (unsigned long long)res.mWrOps,
+                     (unsigned long long)res.mRdTimeouts, ops_sec,
+                     (unsigned long long)avg_wr_wait,
+                     (unsigned long long)res.mMaxWrWaitNs);
+          } else {
+            snprintf(line, sizeof(line), "%s{\"impl\":\"%s\",\"threads\":%zu,"
+                     "\"read_pct\":%u,\"placement\":\"%s\",\"timed_rd_ns\":%llu,"
+                     "\"duration_s\":%.3f,\"rd_ops\":%llu,\"wr_ops\":%llu,"
+                     "\"rd_timeouts\":%llu,\"ops_per_sec\":%.0f,"
+                     "\"avg_wr_wait_ns\":%llu,\"max_wr_wait_ns\":%llu}",
+                     first ? "  " : ",\n  ", impl.c_str(), nthreads, read_pct,
+                     placement.c_str(), (unsigned long long)cfg.mTimedRdNs,
+                     res.mElapsedSec, (unsigned long long)res.mRdOps,
+                     (unsigned long long)res.mWrOps,
+                     (unsigned long long)res.mRdTimeouts, ops_sec,
+                     (unsigned long long)avg_wr_wait,
+                     (unsigned long long)res.mMaxWrWaitNs);
+          }
+
+          std::cout << line << (cfg.mFormat == "csv" ? "\n" : "") << std::flush;
+          first = false;
+        }
+      }
+    }
+  }
+
+  if (cfg.mFormat == "json") {
+    std::cout << std::endl << "]" << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,340 @@
+//------------------------------------------------------------------------------
+// File: EosStringConversionBenchmark.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! Microbenchmark of the StringConversion helpers against the straightforward
+//! implementations they replaced: std::string based tokenizing, per character
+//! hex conversion, sprintf and libcurl escaping. Every case produces one
+//! record in CSV or JSON format with the time per call.
+//------------------------------------------------------------------------------
+
+#include "common/StringConversion.hh"
+#include "curl/curl.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using eos::common::StringConversion;
+
+//------------------------------------------------------------------------------
+//! Value consumed by every benchmark iteration, prevents dead code removal
+//------------------------------------------------------------------------------
+static volatile size_t sSink = 0;
+
+//------------------------------------------------------------------------------
+//! Benchmark case
+//------------------------------------------------------------------------------
+struct Case {
+  std::string mName;
+  std::string mImpl;
+  std::function<size_t(void)> mFunc;
+};
+
+//------------------------------------------------------------------------------
+//! Reference tokenizer as implemented with std::string::find_first_of
+//------------------------------------------------------------------------------
+static void
+RefTokenize(const std::string& str, std::vector<std::string>& tokens,
+            const std::string& delimiters)
+{
+  std::string::size_type lastPos = str.find_first_not_of(delimiters, 0);
+  std::string::size_type pos = str.find_first_of(delimiters, lastPos);
+
+  while (std::string::npos != pos || std::string::npos != lastPos) {
+    tokens.push_back(str.substr(lastPos, pos - lastPos));
+    lastPos = str.find_first_not_of(delimiters, pos);
+    pos = str.find_first_of(delimiters, lastPos);
+  }
+}
+
+//------------------------------------------------------------------------------
+//! Reference curl escaping
+//------------------------------------------------------------------------------
+static std::string
+RefCurlEscaped(CURL* curl, const std::string& str)
+{
+  char* output = curl_easy_escape(curl, str.c_str(), str.length());
+  std::string ret = output;
+  curl_free(output);
+  size_t pos = 0;
+
+  while ((pos = ret.find("%2F", pos)) != std::string::npos) {
+    ret.replace(pos, 3, "/");
+  }
+
+  return "/#curl#" + ret;
+}
+
+//------------------------------------------------------------------------------
+//! Run one case and return the time per call in nanoseconds
+//------------------------------------------------------------------------------
+static double
+RunCase(const Case& c, size_t iterations)
+{
+  // Warm up
+  for (size_t i = 0; i < iterations / 10 + 1; ++i) {
+    sSink += c.mFunc();
+  }
+
+  auto t0 = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < iterations; ++i) {
+    sSink += c.mFunc();
+  }
+
+  auto elapsed = std::chrono::duration<double, std::nano>
+                 (std::chrono::steady_clock::now() - t0).count();
+  return elapsed / iterations;
+}
+
+//------------------------------------------------------------------------------
+//! Print usage
+//------------------------------------------------------------------------------
+static void
+Usage()
+{
+  std::cerr << "Usage: eos-stringconversion-benchmark [options]" << std::endl
+            << "  -n <iterations>  iterations per case" << std::endl
+            << "  -f <csv|json>    output format" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  size_t iterations = 1000000;
+  std::string format = "csv";
+  int c;
+
+  while ((c = getopt(argc, argv, "n:f:h")) != -1) {
+    switch (c) {
+    case 'n':
+      iterations = strtoul(optarg, nullptr, 10);
+      break;
+
+    case 'f':
+      format = optarg;
+      break;
+
+    default:
+      Usage();
+      return 1;
+    }
+  }
+
+  if (!iterations || ((format != "csv") && (format != "json"))) {
+    Usage();
+    return 1;
+  }
+
+  StringConversion::InitLookupTables();
+  CURL* curl = curl_easy_init();
+  const std::string path =
+    "/eos/experiment/user/a/alice/analysis/run 2019/data set & more/file.root";
+  const std::string list = "fs=12,fs=13,fs=14,fs=15,fs=16,fs=17,fs=18,fs=19";
+  const std::string opaque =
+    "eos.app=fuse&eos.ruid=1000&eos.rgid=1000&mgm.logid=0a1b2c3d&eos.bookingsize=0";
+  std::string binary;
+
+  for (int i = 0; i < 64; ++i) {
+    binary.push_back((char)(i * 37));
+  }
+
+  const std::string hex = StringConversion::string_to_hex(binary);
+  const std::string escaped = StringConversion::curl_escaped(path);
+  char fxid[] = "00000000a3f81c2d";
+  std::string out;
+  std::vector<std::string> tokens;
+  std::vector<char> buffer(2 * binary.length());
+  std::vector<Case> cases = {
+    {
+      "tokenize", "reference", [&]() {
+        tokens.clear();
+        RefTokenize(list, tokens, ",");
+        return tokens.size();
+      }
+    },
+    {
+      "tokenize", "current", [&]() {
+        tokens.clear();
+        StringConversion::Tokenize(list, tokens, ",");
+        return tokens.size();
+      }
+    },
+    {
+      "tokenize", "for_each_token", [&]() {
+        size_t n = 0;
+        StringConversion::ForEachToken(list.data(), list.length(), ",",
+        [&](const char*, size_t len) {
+          n += len;
+        });
+        return n;
+      }
+    },
+    {
+      "hex_encode", "reference", [&]() {
+        static const char* const lut = "0123456789ABCDEF";
+        out.clear();
+
+        for (unsigned char ch : binary) {
+          out.push_back(lut[ch >> 4]);
+          out.push_back(lut[ch & 15]);
+        }
+
+        return out.length();
+      }
+    },
+    {
+      "hex_encode", "current", [&]() {
+        return (size_t)(StringConversion::HexEncode(binary.data(),
+                        binary.length(), buffer.data(), true) - buffer.data());
+      }
+    },
+    {
+      "hex_decode", "reference", [&]() {
+        for (size_t i = 0; i < hex.length(); i += 2) {
+          buffer[i / 2] = (char) strtoul(hex.substr(i, 2).c_str(), nullptr, 16);
+        }
+
+        return (size_t) buffer[0];
+      }
+    },
+    {
+      "hex_decode", "current", [&]() {
+        return (size_t) StringConversion::HexDecode(hex.data(), hex.length(),
+            buffer.data());
+      }
+    },
+    {
+      "hex_to_unsigned", "reference", [&]() {
+        return (size_t) strtoull(fxid, nullptr, 16);
+      }
+    },
+    {
+      "hex_to_unsigned", "current", [&]() {
+        unsigned long long value;
+        StringConversion::FastAsciiHexToUnsigned(fxid, &value, 16);
+        return (size_t) value;
+      }
+    },
+    {
+      "size_string", "reference", [&]() {
+        char sbuf[1024];
+        sprintf(sbuf, "%llu", 123456789012ull);
+        out = sbuf;
+        return out.length();
+      }
+    },
+    {
+      "size_string", "current", [&]() {
+        StringConversion::GetSizeString(out, 123456789012ull);
+        return out.length();
+      }
+    },
+    {
+      "curl_escape", "reference", [&]() {
+        return RefCurlEscaped(curl, path).length();
+      }
+    },
+    {
+      "curl_escape", "current", [&]() {
+        return StringConversion::curl_escaped(path).length();
+      }
+    },
+    {
+      "curl_escape", "append", [&]() {
+        out.clear();
+        StringConversion::curl_escaped(path.data(), path.length(), out);
+        return out.length();
+      }
+    },
+    {
+      "curl_unescape", "reference", [&]() {
+        char* output = curl_easy_unescape(curl, escaped.c_str() + 7,
+                                          escaped.length() - 7, 0);
+        std::string ret = output;
+        curl_free(output);
+        return ret.length();
+      }
+    },
+    {
+      "curl_unescape", "current", [&]() {
+        return StringConversion::curl_unescaped(escaped).length();
+      }
+    },
+    {
+      "seal_opaque", "reference", [&]() {
+        std::string sealed = opaque;
+        size_t pos = 0;
+
+        while ((pos = sealed.find("&", pos)) != std::string::npos) {
+          sealed.replace(pos, 1, "#AND#");
+          pos += 5;
+        }
+
+        return sealed.length();
+      }
+    },
+    {
+      "seal_opaque", "current", [&]() {
+        return StringConversion::SealXrdOpaque(opaque).length();
+      }
+    }
+  };
+
+  if (format == "csv") {
+    std::cout << "case,impl,iterations,ns_per_call" << std::endl;
+  } else {
+    std::cout << "[" << std::endl;
+  }
+
+  bool first = true;
+
+  for (const auto& bcase : cases) {
+    double ns = RunCase(bcase, iterations);
+    char line[1024];
+
+    if (format == "csv") {
+      snprintf(line, sizeof(line), "%s,%s,%zu,%.1f", bcase.mName.c_str(),
+               bcase.mImpl.c_str(), iterations, ns);
+      std::cout << line << std::endl;
+    } else {
+      snprintf(line, sizeof(line), "%s{\"case\":\"%s\",\"impl\":\"%s\","
+               "\"iterations\":%zu,\"ns_per_call\":%.1f}", first ? "  " : ",\n  ",
+               bcase.mName.c_str(), bcase.mImpl.c_str(), iterations, ns);
+      std::cout << line;
+      std::cout.flush();
+    }
+
+    first = false;
+  }
+
+  if (format == "json") {
+    std::cout << std::endl << "]" << std::endl;
+  }
+
+  curl_easy_cleanup(curl);
+  return 0;
+}
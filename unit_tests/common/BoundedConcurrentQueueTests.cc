@@ -0,0 +1,125 @@
+//------------------------------------------------------------------------------
+// File: BoundedConcurrentQueueTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/BoundedConcurrentQueue.hh"
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace eos::common;
+
+TEST(BoundedConcurrentQueue, BasicSanity)
+{
+  BoundedConcurrentQueue<int> queue(3);
+  ASSERT_EQ(4u, queue.capacity());
+  ASSERT_TRUE(queue.empty());
+  int value = 0;
+  ASSERT_FALSE(queue.try_pop(value));
+
+  for (int i = 1; i <= 4; ++i) {
+    ASSERT_TRUE(queue.try_push(i));
+  }
+
+  value = 5;
+  ASSERT_FALSE(queue.try_push(value));
+  ASSERT_EQ(4u, queue.size());
+  ASSERT_TRUE(queue.try_pop(value));
+  ASSERT_EQ(1, value);
+  // Same semantics as ConcurrentQueue::push_size
+  ASSERT_FALSE(queue.push_size(value, 2));
+  ASSERT_TRUE(queue.push_size(value, 3));
+  queue.wait_pop(value);
+  ASSERT_EQ(2, value);
+  queue.clear();
+  ASSERT_TRUE(queue.empty());
+}
+
+TEST(BoundedConcurrentQueue, ReleasePoppedElements)
+{
+  BoundedConcurrentQueue<std::shared_ptr<int>> queue(2);
+  auto ptr = std::make_shared<int>(1);
+  queue.push(ptr);
+  std::shared_ptr<int> popped;
+  queue.wait_pop(popped);
+  popped.reset();
+  ASSERT_EQ(1, ptr.use_count());
+}
+
+TEST(BoundedConcurrentQueue, ProducersConsumers)
+{
+  // Tiny capacity so that both producers and consumers block
+  BoundedConcurrentQueue<uint64_t> queue(4);
+  const uint64_t per_producer = 20000;
+  const size_t num_producers = 4;
+  const size_t num_consumers = 3;
+  std::vector<std::thread> threads;
+  std::vector<uint64_t> sums(num_consumers, 0);
+  std::vector<uint64_t> counts(num_consumers, 0);
+
+  for (size_t i = 0; i < num_consumers; ++i) {
+    threads.emplace_back([&, i]() {
+      uint64_t value;
+
+      while (true) {
+        queue.wait_pop(value);
+
+        if (value == 0) {
+          break;
+        }
+
+        sums[i] += value;
+        ++counts[i];
+      }
+    });
+  }
+
+  for (size_t i = 0; i < num_producers; ++i) {
+    threads.emplace_back([&]() {
+      for (uint64_t value = 1; value <= per_producer; ++value) {
+        queue.push(value);
+      }
+    });
+  }
+
+  for (size_t i = num_consumers; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  for (size_t i = 0; i < num_consumers; ++i) {
+    uint64_t marker = 0;
+    queue.push(marker);
+  }
+
+  uint64_t sum = 0;
+  uint64_t count = 0;
+
+  for (size_t i = 0; i < num_consumers; ++i) {
+    threads[i].join();
+    sum += sums[i];
+    count += counts[i];
+  }
+
+  ASSERT_EQ(num_producers * per_producer, count);
+  ASSERT_EQ(num_producers * per_producer * (per_producer + 1) / 2, sum);
+  ASSERT_TRUE(queue.empty());
+}
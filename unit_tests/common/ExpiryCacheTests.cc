@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------------
+// File: ExpiryCacheTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/ExpiryCache.hh"
+#include <thread>
+
+using namespace eos::common;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Update function taking some time and counting its calls
+//------------------------------------------------------------------------------
+struct SlowUpdate {
+  std::atomic<int>* calls;
+  int delay_ms;
+
+  int* operator()(int value)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    (*calls)++;
+    return new int(value);
+  }
+};
+}
+
+//------------------------------------------------------------------------------
+// Without timeout the clients wait for the update of invalid data
+//------------------------------------------------------------------------------
+TEST(ExpiryCache, Blocking)
+{
+  std::atomic<int> calls {0};
+  ExpiryCache<int> cache(std::chrono::seconds(60));
+  ASSERT_EQ(1, cache.getCachedObject(false, SlowUpdate{&calls, 10}, 1));
+  ASSERT_EQ(1, cache.getCachedObject(false, SlowUpdate{&calls, 10}, 2));
+  ASSERT_EQ(2, cache.getCachedObject(true, SlowUpdate{&calls, 10}, 2));
+  ASSERT_EQ(2, calls);
+}
+
+//------------------------------------------------------------------------------
+// With a timeout one background update runs while the clients keep the data
+// in cache
+//------------------------------------------------------------------------------
+TEST(ExpiryCache, StaleWhileRevalidate)
+{
+  std::atomic<int> calls {0};
+  ExpiryCache<int> cache(std::chrono::seconds(60), std::chrono::seconds::max(),
+                         std::chrono::milliseconds(20));
+  // no data yet and the update is too slow
+  ASSERT_THROW(cache.getCachedObject(false, SlowUpdate{&calls, 200}, 1),
+               UpdateException);
+  std::this_thread::sleep_for(std::chrono::milliseconds(400));
+  ASSERT_EQ(1, calls);
+  ASSERT_EQ(1, cache.getCachedObject(false, SlowUpdate{&calls, 200}, 2));
+  // forced updates from many clients return the old data in time
+  std::vector<std::thread> clients;
+  std::atomic<int> stale {0};
+
+  for (int i = 0; i < 8; ++i) {
+    clients.emplace_back([&]() {
+      auto start = std::chrono::steady_clock::now();
+
+      if (cache.getCachedObject(true, SlowUpdate{&calls, 200}, 3) == 1) {
+        stale++;
+      }
+
+      ASSERT_LT(std::chrono::steady_clock::now() - start,
+                std::chrono::milliseconds(150));
+    });
+  }
+
+  for (auto& client : clients) {
+    client.join();
+  }
+
+  ASSERT_EQ(8, stale);
+  std::this_thread::sleep_for(std::chrono::milliseconds(400));
+  ASSERT_EQ(2, calls);
+  ASSERT_EQ(3, cache.getCachedObject(false, SlowUpdate{&calls, 200}, 4));
+}
@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+// File: LayoutIdTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+#include "gtest/gtest.h"
+#include "common/LayoutId.hh"
+
+using eos::common::LayoutId;
+using eos::common::LayoutDescriptor;
+
+//------------------------------------------------------------------------------
+// Descriptors of constant layout ids are decoded at compile time
+//------------------------------------------------------------------------------
+TEST(LayoutDescriptor, Constexpr)
+{
+  constexpr LayoutDescriptor rain(LayoutId::GetId(LayoutId::kRaid6,
+                                  LayoutId::kAdler, 6, LayoutId::k1M,
+                                  LayoutId::kCRC32C));
+  static_assert(rain.mStripes == 6, "stripes");
+  static_assert(rain.mRedundancyStripes == 2, "parity stripes");
+  static_assert(rain.mBlocksize == 1024 * 1024, "blocksize");
+  static_assert(rain.mSizeFactor == 1.5, "size factor");
+  static_assert(rain.IsRain(), "rain layout");
+  constexpr LayoutDescriptor replica(LayoutId::GetId(LayoutId::kReplica,
+                                     LayoutId::kMD5, 2, LayoutId::k4M,
+                                     LayoutId::kCRC32C));
+  static_assert(replica.mBlockChecksum == LayoutId::kNone, "no block xs");
+  static_assert(replica.mChecksumLen == 16, "checksum length");
+  static_assert(!replica.IsRain(), "not a rain layout");
+  ASSERT_EQ(2.0, replica.mSizeFactor);
+}
+
+//------------------------------------------------------------------------------
+// Descriptors agree with the static decoding functions
+//------------------------------------------------------------------------------
+TEST(LayoutDescriptor, SameAsLayoutId)
+{
+  for (int type = LayoutId::kPlain; type <= LayoutId::kRaid6; ++type) {
+    for (int stripes = 1; stripes <= 16; ++stripes) {
+      for (int bs = LayoutId::k4k; bs <= LayoutId::k64M; ++bs) {
+        unsigned long lid = LayoutId::GetId(type, LayoutId::kSHA1, stripes, bs,
+                                            LayoutId::kCRC32, type % 3);
+        LayoutDescriptor desc(lid);
+        ASSERT_EQ(lid, desc.mLayoutId);
+        ASSERT_EQ(LayoutId::GetLayoutType(lid), desc.mType);
+        ASSERT_EQ(LayoutId::GetChecksum(lid), desc.mChecksum);
+        ASSERT_EQ(LayoutId::GetChecksumLen(lid), desc.mChecksumLen);
+        ASSERT_EQ(LayoutId::GetStripeNumber(lid) + 1, desc.mStripes);
+        ASSERT_EQ(LayoutId::GetExcessStripeNumber(lid), desc.mExcessStripes);
+        ASSERT_EQ(LayoutId::GetRedundancyStripeNumber(lid),
+                  desc.mRedundancyStripes);
+        ASSERT_EQ(LayoutId::GetBlocksize(lid), desc.mBlocksize);
+        ASSERT_EQ(LayoutId::GetBlockChecksum(lid), desc.mBlockChecksum);
+        ASSERT_EQ(LayoutId::GetSizeFactor(lid), desc.mSizeFactor);
+        ASSERT_EQ(LayoutId::GetMinOnlineReplica(lid), desc.mMinOnlineReplica);
+        ASSERT_EQ(LayoutId::GetOnlineStripeNumber(lid), desc.mOnlineStripes);
+      }
+    }
+  }
+}
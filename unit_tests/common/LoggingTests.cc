@@ -42,4 +42,36 @@ TEST(Logging, Log)
   function_using_logging();
 }
 
+TEST(Logging, LazyArguments)
+{
+  using namespace eos::common;
+  gLogging.SetLogPriority(LOG_INFO);
+  int count = 0;
+  auto arg = [&count]() {
+    ++count;
+    return "evaluated";
+  };
+  // Arguments of masked messages are not evaluated
+  eos_static_debug("msg=\"%s\"", arg());
+  ASSERT_EQ(0, count);
+  eos_static_info("msg=\"%s\"", arg());
+  ASSERT_EQ(1, count);
+}
+
+TEST(Logging, AsyncLog)
+{
+  using namespace eos::common;
+  gLogging.SetLogPriority(LOG_INFO);
+  gLogging.SetAsync(true);
+
+  for (int i = 0; i < 100; ++i) {
+    eos_static_info("msg=\"async test log line\" count=%i", i);
+  }
+
+  // Disabling the asynchronous mode writes out the buffered lines
+  gLogging.SetAsync(false);
+  ASSERT_EQ(0u, gLogging.GetAsyncDropped());
+  eos_static_info("%s", "msg=\"sync test log line\"");
+}
+
 EOSCOMMONTESTING_END
@@ -78,4 +78,44 @@ TEST(Mapping, VidAssignOperator)
   ASSERT_TRUE(vid.sudoer == copy_vid.sudoer);
 }
 
+TEST(Mapping, VidCache)
+{
+  using namespace eos::common;
+  Mapping::vid_cache cache(60);
+  Mapping::VirtualIdentity vid;
+  Mapping::VirtualIdentity cached;
+  std::string mytident;
+  vid.uid = 1234;
+  vid.gid = 5678;
+  vid.uid_list = {1234, 99};
+  vid.gid_list = {5678, 99};
+  vid.name = "dummy_user";
+  vid.prot = "krb5";
+  ASSERT_TRUE(cache.IsEnabled());
+  ASSERT_FALSE(cache.Get("key1", cached, mytident));
+  cache.Store("key1", cache.GetGeneration(), vid, "dummy_user@host");
+  ASSERT_TRUE(cache.Get("key1", cached, mytident));
+  ASSERT_EQ(1234u, cached.uid);
+  ASSERT_EQ(5678u, cached.gid);
+  ASSERT_EQ(2u, cached.uid_list.size());
+  ASSERT_TRUE(cached.name == "dummy_user");
+  ASSERT_EQ("dummy_user@host", mytident);
+  ASSERT_FALSE(cache.Get("key2", cached, mytident));
+  // A mapping computed before a rule change is not stored
+  uint64_t generation = cache.GetGeneration();
+  cache.Invalidate();
+  ASSERT_FALSE(cache.Get("key1", cached, mytident));
+  cache.Store("key2", generation, vid, "dummy_user@host");
+  ASSERT_FALSE(cache.Get("key2", cached, mytident));
+  cache.Store("key2", cache.GetGeneration(), vid, "dummy_user@host");
+  ASSERT_TRUE(cache.Get("key2", cached, mytident));
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  cache.GetStats(hits, misses);
+  ASSERT_EQ(2u, hits);
+  ASSERT_EQ(4u, misses);
+  cache.SetLifeTime(0);
+  ASSERT_FALSE(cache.IsEnabled());
+}
+
 EOSCOMMONTESTING_END
@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------
+// File: MetricsPushTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/MetricsPush.hh"
+#include "common/Metrics.hh"
+
+using namespace eos::common;
+
+//------------------------------------------------------------------------------
+// Only the changed series are sent between two full snapshots
+//------------------------------------------------------------------------------
+TEST(MetricsPush, Delta)
+{
+  MetricsRegistry registry;
+  MetricCounter& open = registry.GetCounter("test_ops_total", "ops",
+                        {{"op", "open"}});
+  MetricGauge& gauge = registry.GetGauge("test_gauge", "gauge");
+  open.Inc(3);
+  gauge.Set(1);
+  std::map<std::string, std::string> last;
+  std::vector<std::string> batches = MetricsPush::MakeBatches(
+                                       registry.Expose(), "#eos test host 0 0", 1400, last, false);
+  ASSERT_EQ(1u, batches.size());
+  ASSERT_EQ("#eos test host 0 0 1/1 delta\n"
+            "test_gauge 1\n"
+            "test_ops_total{op=\"open\"} 3\n", batches[0]);
+  ASSERT_EQ(2u, last.size());
+  // Nothing changed
+  batches = MetricsPush::MakeBatches(registry.Expose(), "#eos test host 0 1",
+                                     1400, last, false);
+  ASSERT_TRUE(batches.empty());
+  open.Inc();
+  batches = MetricsPush::MakeBatches(registry.Expose(), "#eos test host 0 2",
+                                     1400, last, false);
+  ASSERT_EQ(1u, batches.size());
+  ASSERT_EQ("#eos test host 0 2 1/1 delta\n"
+            "test_ops_total{op=\"open\"} 4\n", batches[0]);
+  // Full snapshot
+  batches = MetricsPush::MakeBatches(registry.Expose(), "#eos test host 0 3",
+                                     1400, last, true);
+  ASSERT_EQ(1u, batches.size());
+  ASSERT_NE(std::string::npos, batches[0].find("1/1 full\n"));
+  ASSERT_NE(std::string::npos, batches[0].find("test_gauge 1\n"));
+}
+
+//------------------------------------------------------------------------------
+// Batches respect the max size
+//------------------------------------------------------------------------------
+TEST(MetricsPush, Split)
+{
+  MetricsRegistry registry;
+
+  for (int i = 0; i < 200; ++i) {
+    registry.GetCounter("test_ops_total", "ops",
+    {{"op", "op" + std::to_string(i)}}).Inc(i + 1);
+  }
+
+  std::map<std::string, std::string> last;
+  std::vector<std::string> batches = MetricsPush::MakeBatches(
+                                       registry.Expose(), "#eos test host 0 0", 512, last, true);
+  ASSERT_LT(1u, batches.size());
+  size_t num_lines = 0;
+
+  for (size_t i = 0; i < batches.size(); ++i) {
+    ASSERT_LE(batches[i].length(), 512u);
+    std::string part = " " + std::to_string(i + 1) + "/" +
+                       std::to_string(batches.size()) + " full\n";
+    ASSERT_EQ(0u, batches[i].find("#eos test host 0 0" + part));
+
+    for (char c : batches[i]) {
+      num_lines += (c == '\n');
+    }
+  }
+
+  ASSERT_EQ(200u + batches.size(), num_lines);
+}
@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------
+// File: MetricsTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+#include "gtest/gtest.h"
+#include "common/Metrics.hh"
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace eos::common;
+
+//------------------------------------------------------------------------------
+// Counter updated concurrently
+//------------------------------------------------------------------------------
+TEST(Metrics, Counter)
+{
+  MetricsRegistry registry;
+  MetricCounter& counter = registry.GetCounter("test_ops_total", "ops",
+                           {{"op", "open"}});
+  ASSERT_EQ(&counter, &registry.GetCounter("test_ops_total", "ops",
+            {{"op", "open"}}));
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < 1000; ++j) {
+        counter.Inc();
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(4000u, counter.Get());
+  ASSERT_NE(std::string::npos,
+            registry.Expose().find("test_ops_total{op=\"open\"} 4000\n"));
+  ASSERT_THROW(registry.GetGauge("test_ops_total", "ops"),
+               std::invalid_argument);
+}
+
+//------------------------------------------------------------------------------
+// Gauges and callbacks
+//------------------------------------------------------------------------------
+TEST(Metrics, Gauge)
+{
+  MetricsRegistry registry;
+  MetricGauge& gauge = registry.GetGauge("test_queue", "queue length");
+  gauge.Set(2.5);
+  gauge.Add(-1);
+  ASSERT_DOUBLE_EQ(1.5, gauge.Get());
+  registry.SetGaugeCallback("test_files", "files", []() {
+    return 42.0;
+  });
+  std::string out = registry.Expose();
+  ASSERT_NE(std::string::npos, out.find("# TYPE test_queue gauge\n"));
+  ASSERT_NE(std::string::npos, out.find("test_queue 1.5\n"));
+  ASSERT_NE(std::string::npos, out.find("test_files 42\n"));
+  registry.RemoveGaugeCallback("test_files");
+  ASSERT_EQ(std::string::npos, registry.Expose().find("test_files"));
+}
+
+//------------------------------------------------------------------------------
+// Histogram buckets are cumulative and inclusive
+//------------------------------------------------------------------------------
+TEST(Metrics, Histogram)
+{
+  MetricsRegistry registry;
+  MetricHistogram& histo = registry.GetHistogram("test_seconds", "latency",
+                           {0.1, 1});
+  histo.Observe(0.05);
+  histo.Observe(0.1);
+  histo.Observe(0.5);
+  histo.Observe(3);
+  ASSERT_EQ((std::vector<uint64_t> {2, 3, 4}), histo.GetCumulativeCounts());
+  ASSERT_DOUBLE_EQ(3.65, histo.GetSum());
+  std::string out = registry.Expose();
+  ASSERT_NE(std::string::npos, out.find("# TYPE test_seconds histogram\n"));
+  ASSERT_NE(std::string::npos, out.find("test_seconds_bucket{le=\"0.1\"} 2\n"));
+  ASSERT_NE(std::string::npos, out.find("test_seconds_bucket{le=\"1\"} 3\n"));
+  ASSERT_NE(std::string::npos,
+            out.find("test_seconds_bucket{le=\"+Inf\"} 4\n"));
+  ASSERT_NE(std::string::npos, out.find("test_seconds_count 4\n"));
+}
+
+//------------------------------------------------------------------------------
+// Label formatting and escaping
+//------------------------------------------------------------------------------
+TEST(Metrics, Labels)
+{
+  ASSERT_EQ("", MetricsRegistry::FormatLabels({}));
+  ASSERT_EQ("{a=\"x\",b=\"q\\\"\"}",
+            MetricsRegistry::FormatLabels({{"b", "q\""}, {"a", "x"}}));
+  ASSERT_EQ("{a=\"x\",le=\"1\"}",
+            MetricsRegistry::FormatLabels({{"a", "x"}}, "le", "1"));
+}
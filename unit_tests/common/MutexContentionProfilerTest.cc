@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------
+// File: MutexContentionProfilerTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/MutexContentionProfiler.hh"
+#include "common/RWMutex.hh"
+#include <chrono>
+#include <thread>
+
+using eos::common::MutexContentionProfiler;
+
+//------------------------------------------------------------------------------
+// Sampling rate
+//------------------------------------------------------------------------------
+TEST(MutexContentionProfiler, Sampling)
+{
+  MutexContentionProfiler::SetSampling(0);
+  ASSERT_FALSE(MutexContentionProfiler::IsEnabled());
+  ASSERT_FALSE(MutexContentionProfiler::Sample());
+  MutexContentionProfiler::SetSampling(0.25);
+  ASSERT_DOUBLE_EQ(0.25, MutexContentionProfiler::GetSampling());
+  int sampled = 0;
+
+  for (int i = 0; i < 100000; ++i) {
+    sampled += MutexContentionProfiler::Sample();
+  }
+
+  ASSERT_GT(sampled, 24000);
+  ASSERT_LT(sampled, 26000);
+  MutexContentionProfiler::SetSampling(1.0);
+  ASSERT_TRUE(MutexContentionProfiler::Sample());
+  ASSERT_TRUE(MutexContentionProfiler::Sample());
+  MutexContentionProfiler::SetSampling(0);
+}
+
+//------------------------------------------------------------------------------
+// Contended read lock is accounted to the waiter and the writer
+//------------------------------------------------------------------------------
+TEST(MutexContentionProfiler, ContendedSites)
+{
+  MutexContentionProfiler::Reset();
+  MutexContentionProfiler::SetSampling(1.0, 1000 * 1000);
+  eos::common::RWMutex mutex;
+  mutex.SetBlocking(true);
+#ifdef EOS_INSTRUMENTED_RWMUTEX
+  mutex.SetDebugName("contended");
+#endif
+  // Uncontended locks stay below the threshold
+  mutex.LockRead();
+  mutex.UnLockRead();
+  mutex.LockWrite();
+  std::thread reader([&]() {
+    eos::common::RWMutexReadLock rd_lock(mutex);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  mutex.UnLockWrite();
+  reader.join();
+  auto sites = MutexContentionProfiler::GetTopSites(10);
+  ASSERT_EQ(1u, sites.size());
+  ASSERT_FALSE(sites[0].mWrite);
+  ASSERT_EQ(1u, sites[0].mCount);
+  ASSERT_GE(sites[0].mTotalNs, 10 * 1000 * 1000ull);
+  ASSERT_EQ(sites[0].mTotalNs, sites[0].mMaxNs);
+  ASSERT_NE(0u, sites[0].mWaiter);
+  ASSERT_NE(0u, sites[0].mHolder);
+#ifdef EOS_INSTRUMENTED_RWMUTEX
+  ASSERT_EQ("contended", sites[0].mMutex);
+#endif
+  ASSERT_FALSE(MutexContentionProfiler::Dump(10).empty());
+  MutexContentionProfiler::Reset();
+  ASSERT_TRUE(MutexContentionProfiler::GetTopSites(10).empty());
+  MutexContentionProfiler::SetSampling(0);
+}
@@ -0,0 +1,190 @@
+//------------------------------------------------------------------------------
+// File: NssResolverTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/NssResolver.hh"
+#include <atomic>
+#include <cerrno>
+#include <thread>
+#include <vector>
+
+using namespace eos::common;
+
+//------------------------------------------------------------------------------
+// Fake name service knowing user 1000 "alice" and group 2000 "atlas"
+//------------------------------------------------------------------------------
+struct FakeNss {
+  std::atomic<int> mCalls {0};
+  std::atomic<int> mDelayMs {0};
+  std::atomic<int> mErrc {0};
+
+  NssResolver::Backend Get()
+  {
+    return [this](NssResolver::Type type, const std::string & key,
+    NssResolver::Reply & reply) {
+      ++mCalls;
+
+      if (mDelayMs) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(mDelayMs));
+      }
+
+      reply = NssResolver::Reply();
+
+      if (mErrc) {
+        reply.mErrc = mErrc;
+      } else if (((type == NssResolver::Type::kUidToName) && (key == "1000")) ||
+                 ((type == NssResolver::Type::kNameToUid) && (key == "alice"))) {
+        reply.mId = 1000;
+        reply.mGid = 2000;
+        reply.mName = "alice";
+      } else if (((type == NssResolver::Type::kGidToName) && (key == "2000")) ||
+                 ((type == NssResolver::Type::kNameToGid) && (key == "atlas"))) {
+        reply.mId = 2000;
+        reply.mGid = 2000;
+        reply.mName = "atlas";
+      } else {
+        reply.mErrc = ENOENT;
+      }
+    };
+  }
+};
+
+TEST(NssResolver, PositiveNegativeCache)
+{
+  FakeNss nss;
+  NssResolver resolver(2, 3600, 3600, 0);
+  resolver.SetBackend(nss.Get());
+  NssResolver::Reply reply;
+  ASSERT_EQ(0, resolver.Lookup(NssResolver::Type::kUidToName, "1000", reply));
+  ASSERT_EQ("alice", reply.mName);
+  ASSERT_EQ(2000u, reply.mGid);
+  ASSERT_EQ(0, resolver.Lookup(NssResolver::Type::kUidToName, "1000", reply));
+  // The reverse lookup is answered by the first one
+  ASSERT_EQ(0, resolver.Lookup(NssResolver::Type::kNameToUid, "alice", reply));
+  ASSERT_EQ(1000u, reply.mId);
+  ASSERT_EQ(1, nss.mCalls);
+  ASSERT_EQ(ENOENT, resolver.Lookup(NssResolver::Type::kUidToName, "1001",
+                                    reply));
+  ASSERT_EQ(ENOENT, resolver.Lookup(NssResolver::Type::kUidToName, "1001",
+                                    reply));
+  ASSERT_EQ(2, nss.mCalls);
+  ASSERT_EQ(0, resolver.Lookup(NssResolver::Type::kNameToGid, "atlas", reply));
+  ASSERT_EQ(2000u, reply.mId);
+  ASSERT_EQ(0, resolver.Lookup(NssResolver::Type::kGidToName, "2000", reply));
+  ASSERT_EQ("atlas", reply.mName);
+  ASSERT_EQ(3, nss.mCalls);
+  NssResolver::Stats stats = resolver.GetStats();
+  ASSERT_EQ(3u, stats.mHits);
+  ASSERT_EQ(1u, stats.mNegativeHits);
+  ASSERT_EQ(3u, stats.mMisses);
+  ASSERT_EQ(3u, stats.mLookups);
+  ASSERT_EQ(1u, stats.mFailures);
+  resolver.Clear();
+  ASSERT_EQ(0, resolver.Lookup(NssResolver::Type::kUidToName, "1000", reply));
+  ASSERT_EQ(4, nss.mCalls);
+}
+
+TEST(NssResolver, NegativeExpiryAndTransientErrors)
+{
+  FakeNss nss;
+  NssResolver resolver(1, 3600, 0, 0);
+  resolver.SetBackend(nss.Get());
+  NssResolver::Reply reply;
+  // Negative entries with a zero lifetime expire immediately
+  ASSERT_EQ(ENOENT, resolver.Lookup(NssResolver::Type::kNameToUid, "bob",
+                                    reply));
+  ASSERT_EQ(ENOENT, resolver.Lookup(NssResolver::Type::kNameToUid, "bob",
+                                    reply));
+  ASSERT_EQ(2, nss.mCalls);
+  // Errors other than "not found" are not cached
+  nss.mErrc = EIO;
+  ASSERT_EQ(EIO, resolver.Lookup(NssResolver::Type::kUidToName, "1000", reply));
+  nss.mErrc = 0;
+  ASSERT_EQ(0, resolver.Lookup(NssResolver::Type::kUidToName, "1000", reply));
+  ASSERT_EQ(4, nss.mCalls);
+}
+
+TEST(NssResolver, TimeoutAndSharedLookups)
+{
+  FakeNss nss;
+  nss.mDelayMs = 300;
+  NssResolver resolver(2, 3600, 60, 20);
+  resolver.SetBackend(nss.Get());
+  NssResolver::Reply reply;
+  ASSERT_EQ(ETIMEDOUT, resolver.Lookup(NssResolver::Type::kUidToName, "1000",
+                                       reply));
+  ASSERT_EQ(1u, resolver.GetStats().mTimeouts);
+  // Callers waiting for the same key share the running lookup
+  resolver.Configure(2, 3600, 60, 0);
+  std::vector<std::thread> threads;
+  std::atomic<int> found {0};
+
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&]() {
+      NssResolver::Reply r;
+
+      if (!resolver.Lookup(NssResolver::Type::kUidToName, "1000", r) &&
+          (r.mName == "alice")) {
+        ++found;
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(8, found);
+  ASSERT_EQ(1, nss.mCalls);
+}
+
+TEST(NssResolver, AsyncAndPrefetch)
+{
+  FakeNss nss;
+  NssResolver resolver(2, 3600, 60, 0);
+  resolver.SetBackend(nss.Get());
+  std::promise<NssResolver::Reply> promise;
+  resolver.LookupAsync(NssResolver::Type::kGidToName, "2000",
+  [&](const NssResolver::Reply & reply) {
+    promise.set_value(reply);
+  });
+  NssResolver::Reply reply = promise.get_future().get();
+  ASSERT_EQ(0, reply.mErrc);
+  ASSERT_EQ("atlas", reply.mName);
+  bool called = false;
+  // Cached keys call back immediately
+  resolver.LookupAsync(NssResolver::Type::kGidToName, "2000",
+  [&](const NssResolver::Reply & reply) {
+    called = (reply.mName == "atlas");
+  });
+  ASSERT_TRUE(called);
+  resolver.Prefetch(NssResolver::Type::kUidToName, {"1000", "1001"});
+
+  while (resolver.GetStats().mLookups < 3) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  ASSERT_EQ(0, resolver.Lookup(NssResolver::Type::kUidToName, "1000", reply));
+  ASSERT_EQ(ENOENT, resolver.Lookup(NssResolver::Type::kUidToName, "1001",
+                                    reply));
+  ASSERT_EQ(3, nss.mCalls);
+}
@@ -0,0 +1,142 @@
+//------------------------------------------------------------------------------
+// File: ParallelTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/Parallel.hh"
+#include <algorithm>
+#include <list>
+#include <map>
+#include <stdexcept>
+
+using namespace eos::common;
+
+TEST(Parallel, ForVisitsEveryIndexOnce)
+{
+  std::vector<std::atomic<int>> visits(10007);
+
+  for (auto& visit : visits) {
+    visit = 0;
+  }
+
+  Parallel::For(0, (int) visits.size(), [&](int i) {
+    ++visits[i];
+  });
+
+  for (auto& visit : visits) {
+    ASSERT_EQ(visit.load(), 1);
+  }
+
+  // Empty and reversed ranges do nothing
+  Parallel::For(5, 5, [&](int i) {
+    ++visits[i];
+  });
+  Parallel::For(5, 2, [&](int i) {
+    ++visits[i];
+  });
+  ASSERT_EQ(visits[5].load(), 1);
+}
+
+TEST(Parallel, ForReduction)
+{
+  uint64_t sum = Parallel::For((uint64_t) 1, (uint64_t) 100001, (uint64_t) 0,
+  [](uint64_t i, uint64_t & local) {
+    local += i;
+  }, [](uint64_t & result, uint64_t & local) {
+    result += local;
+  });
+  ASSERT_EQ(sum, 5000050000ull);
+  // The threads taking part get their own copy of the initial object
+  std::vector<int> init(1, 7);
+  std::vector<int> all = Parallel::For(0, 1000, init,
+  [](int i, std::vector<int>& local) {
+    local.push_back(i);
+  }, [](std::vector<int>& result, std::vector<int>& local) {
+    ASSERT_EQ(local[0], 7);
+    result.insert(result.end(), local.begin() + 1, local.end());
+  });
+  ASSERT_EQ(all.size(), 1001u);
+  std::sort(all.begin() + 1, all.end());
+
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(all[i + 1], i);
+  }
+}
+
+TEST(Parallel, ForNestedAndUneven)
+{
+  // Nested loops and very uneven iterations must not deadlock the pool
+  std::atomic<uint64_t> count(0);
+  Parallel::For(0, 64, [&](int i) {
+    if (i % 8 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    Parallel::For(0, 100, [&](int) {
+      ++count;
+    });
+  });
+  ASSERT_EQ(count.load(), 6400u);
+}
+
+TEST(Parallel, ForException)
+{
+  std::atomic<int> count(0);
+  ASSERT_THROW(Parallel::For(0, 100000, [&](int i) {
+    ++count;
+
+    if (i == 10) {
+      throw std::runtime_error("stop");
+    }
+  }), std::runtime_error);
+  ASSERT_LT(count.load(), 100000);
+}
+
+TEST(Parallel, ForEach)
+{
+  std::map<int, std::atomic<int>> map;
+  std::list<int> list;
+
+  for (int i = 0; i < 5000; ++i) {
+    map[i] = 0;
+    list.push_back(i);
+  }
+
+  Parallel::ForEach(map.begin(), map.end(),
+  [](std::pair<const int, std::atomic<int>>& entry) {
+    ++entry.second;
+  });
+
+  for (auto& entry : map) {
+    ASSERT_EQ(entry.second.load(), 1);
+  }
+
+  std::vector<int> vect(list.begin(), list.end());
+  std::atomic<uint64_t> lsum(0), vsum(0);
+  Parallel::ForEach(list.begin(), list.end(), [&](int value) {
+    lsum += value;
+  });
+  Parallel::ForEach(vect.begin(), vect.end(), [&](int value) {
+    vsum += value;
+  });
+  ASSERT_EQ(lsum.load(), 12497500u);
+  ASSERT_EQ(vsum.load(), 12497500u);
+}
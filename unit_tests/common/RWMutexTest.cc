@@ -23,7 +23,11 @@
 
 #include "gtest/gtest.h"
 #include "common/RWMutex.hh"
+#include "common/BigReaderRWMutex.hh"
 #include "common/StacktraceHere.hh"
+#include <atomic>
+#include <thread>
+#include <vector>
 
 //------------------------------------------------------------------------------
 // Check stacktrace generation
@@ -130,3 +134,68 @@ TEST(RWMutex, MultiWrLockTest)
   ASSERT_NO_THROW(mutex.UnLockWrite());
   t.join();
 }
+
+//------------------------------------------------------------------------------
+// Big reader mutex - readers share the lock, writers are exclusive and timed
+// locks expire while the lock is held in the other mode
+//------------------------------------------------------------------------------
+TEST(BigReaderRWMutex, BasicSanity)
+{
+  for (int prefer_rd = 0; prefer_rd < 2; ++prefer_rd) {
+    eos::common::BigReaderRWMutex mutex(prefer_rd);
+    ASSERT_EQ(0, mutex.LockRead());
+    std::thread t([&]() {
+      ASSERT_EQ(0, mutex.TimedRdLock(1000000));
+      ASSERT_EQ(0, mutex.UnLockRead());
+      ASSERT_EQ(ETIMEDOUT, mutex.TimedWrLock(10000000));
+    });
+    t.join();
+    ASSERT_EQ(0, mutex.UnLockRead());
+    ASSERT_EQ(0, mutex.LockWrite());
+    std::thread t2([&]() {
+      ASSERT_EQ(ETIMEDOUT, mutex.TimedRdLock(10000000));
+      ASSERT_EQ(ETIMEDOUT, mutex.TimedWrLock(10000000));
+    });
+    t2.join();
+    ASSERT_EQ(0, mutex.UnLockWrite());
+    ASSERT_EQ(0, mutex.TimedWrLock(1000000));
+    ASSERT_EQ(0, mutex.UnLockWrite());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Big reader mutex under concurrent readers and writers
+//------------------------------------------------------------------------------
+TEST(BigReaderRWMutex, Concurrency)
+{
+  eos::common::RWMutex mutex(true, true);
+  uint64_t value = 0;
+  std::atomic<bool> failed {false};
+  std::vector<std::thread> workers;
+
+  for (int i = 0; i < 8; ++i) {
+    workers.emplace_back([&, i]() {
+      for (int j = 0; j < 10000; ++j) {
+        if ((j % 100) == i) {
+          eos::common::RWMutexWriteLock wr_lock(mutex);
+          uint64_t tmp = value;
+          value = tmp + 1;
+        } else {
+          eos::common::RWMutexReadLock rd_lock(mutex);
+          uint64_t tmp = value;
+
+          if (tmp != value) {
+            failed = true;
+          }
+        }
+      }
+    });
+  }
+
+  for (auto& th : workers) {
+    th.join();
+  }
+
+  ASSERT_FALSE(failed);
+  ASSERT_EQ(800u, value);
+}
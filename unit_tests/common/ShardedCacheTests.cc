@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------
+// File: ShardedCacheTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/ShardedCache.hh"
+
+typedef ShardedCache<uint64_t, int, IdentityHash<uint64_t>> IntCache;
+
+//------------------------------------------------------------------------------
+// Store, retrieve and invalidate update the counters
+//------------------------------------------------------------------------------
+TEST(ShardedCache, BasicSanity)
+{
+  IntCache cache(4, 1000 * 60);
+  ASSERT_FALSE(cache.retrieve(1));
+  ASSERT_TRUE(cache.store(1, std::unique_ptr<int>(new int(10))));
+  ASSERT_FALSE(cache.store(1, std::unique_ptr<int>(new int(11)), false));
+  ASSERT_EQ(10, *cache.retrieve(1));
+  ASSERT_TRUE(cache.store(1, std::unique_ptr<int>(new int(12))));
+  ASSERT_EQ(12, *cache.retrieve(1));
+  ASSERT_TRUE(cache.invalidate(1));
+  ASSERT_FALSE(cache.invalidate(1));
+  ASSERT_FALSE(cache.retrieve(1));
+  ShardedCacheStats stats = cache.getStats();
+  ASSERT_EQ(2u, stats.hits);
+  ASSERT_EQ(2u, stats.misses);
+  ASSERT_EQ(0u, stats.size);
+}
+
+//------------------------------------------------------------------------------
+// A shard over its budget evicts the entries without a recent hit
+//------------------------------------------------------------------------------
+TEST(ShardedCache, SizeBudget)
+{
+  IntCache cache(0, 1000 * 60, 4);
+
+  for (uint64_t i = 0; i < 4; i++) {
+    cache.store(i, std::unique_ptr<int>(new int(i)));
+  }
+
+  // the first store over the budget clears all the reference bits
+  cache.store(4, std::unique_ptr<int>(new int(4)));
+  ASSERT_EQ(1u, cache.getStats().evicted);
+  ASSERT_EQ(4u, cache.getStats().size);
+  ASSERT_FALSE(cache.retrieve(0));
+
+  // an entry hit between two stores is never the one evicted
+  for (int round = 0; round < 10; round++) {
+    ASSERT_TRUE(cache.retrieve(3));
+    cache.store(100 + round, std::unique_ptr<int>(new int(round)));
+    ASSERT_TRUE(cache.retrieve(100 + round));
+  }
+
+  ASSERT_TRUE(cache.retrieve(3));
+  ASSERT_EQ(4u, cache.getStats().size);
+  ASSERT_EQ(11u, cache.getStats().evicted);
+}
+
+//------------------------------------------------------------------------------
+// Sequential keys spread over all the shards
+//------------------------------------------------------------------------------
+TEST(ShardedCache, Spread)
+{
+  IntCache cache(4, 1000 * 60, 8);
+
+  for (uint64_t pid = 1; pid <= 128; pid++) {
+    cache.store(pid, std::unique_ptr<int>(new int(pid)));
+  }
+
+  // 16 shards with a budget of 8 hold all of them only if perfectly spread
+  ASSERT_EQ(128u, cache.getStats().size + cache.getStats().evicted);
+  ASSERT_GE(cache.getStats().size, 100u);
+}
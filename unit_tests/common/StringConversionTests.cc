@@ -44,4 +44,128 @@ TEST(StringConversion, Seal_Unseal_Operation)
                StringConversion::UnsealXrdOpaque(expected).c_str());
 }
 
+TEST(StringConversion, Tokenize)
+{
+  std::vector<std::string> tokens;
+  StringConversion::Tokenize("  a b  c   ", tokens);
+  ASSERT_EQ((std::vector<std::string> {"a", "b", "c"}), tokens);
+  tokens.clear();
+  StringConversion::Tokenize("fs1,,fs2;fs3,", tokens, ",;");
+  ASSERT_EQ((std::vector<std::string> {"fs1", "fs2", "fs3"}), tokens);
+  tokens.clear();
+  // Longer than one vector register and more delimiters than vectorized
+  StringConversion::Tokenize("key1=val1&key2=val2|key3:val3 key4;",
+                             tokens, "&| ;:");
+  ASSERT_EQ((std::vector<std::string> {"key1=val1", "key2=val2", "key3",
+                                       "val3", "key4"
+                                      }), tokens);
+  tokens.clear();
+  StringConversion::Tokenize(",,,", tokens, ",");
+  ASSERT_TRUE(tokens.empty());
+  StringConversion::EmptyTokenize("a||b|", tokens, "|");
+  ASSERT_EQ((std::vector<std::string> {"a", "", "b", ""}), tokens);
+  std::vector<std::string> views;
+  std::string input = "/eos/dev/some/deep/directory/structure/file.dat";
+  StringConversion::ForEachToken(input.data(), input.length(), "/",
+  [&](const char* token, size_t len) {
+    views.emplace_back(token, len);
+  });
+  ASSERT_EQ((std::vector<std::string> {"eos", "dev", "some", "deep",
+                                       "directory", "structure", "file.dat"
+                                      }), views);
+}
+
+TEST(StringConversion, HexEncodeDecode)
+{
+  std::string input;
+
+  for (int i = 0; i < 256; ++i) {
+    input.push_back((char) i);
+  }
+
+  std::string upper = StringConversion::string_to_hex(input);
+  ASSERT_EQ(512u, upper.length());
+  ASSERT_EQ("000102", upper.substr(0, 6));
+  ASSERT_EQ("7F8081", upper.substr(254, 6));
+  ASSERT_EQ("FDFEFF", upper.substr(506));
+  std::string lower(2 * input.length(), '\0');
+  ASSERT_EQ(&lower[0] + lower.length(),
+            StringConversion::HexEncode(input.data(), input.length(), &lower[0]));
+
+  for (size_t i = 0; i < lower.length(); ++i) {
+    ASSERT_EQ(tolower(upper[i]), lower[i]);
+  }
+
+  std::string output(input.length(), '\0');
+  ASSERT_TRUE(StringConversion::HexDecode(upper.data(), upper.length(),
+                                          &output[0]));
+  ASSERT_EQ(input, output);
+  ASSERT_TRUE(StringConversion::HexDecode(lower.data(), lower.length(),
+                                          &output[0]));
+  ASSERT_EQ(input, output);
+  ASSERT_FALSE(StringConversion::HexDecode("abc", 3, &output[0]));
+  ASSERT_FALSE(StringConversion::HexDecode("0123456789abcdefg1", 18,
+               &output[0]));
+  ASSERT_FALSE(StringConversion::HexDecode("0123456789abcdef0123456789abcdeX",
+               32, &output[0]));
+}
+
+TEST(StringConversion, FastAsciiHexToUnsigned)
+{
+  StringConversion::InitLookupTables();
+  char hex[] = "00000123456789abcdef";
+  uint64_t value = 0;
+  StringConversion::FastAsciiHexToUnsigned(hex + 4, &value, 16);
+  ASSERT_EQ(0x0123456789abcdefull, value);
+  StringConversion::FastAsciiHexToUnsigned(hex + 4, &value, 3);
+  ASSERT_EQ(0x012ull, value);
+  StringConversion::FastAsciiHexToUnsigned(hex, &value);
+  ASSERT_EQ(0x0123456789abcdefull, value);
+  uint32_t value32 = 0;
+  StringConversion::FastAsciiHexToUnsigned(hex + 4, &value32, 16);
+  ASSERT_EQ(0x89abcdefu, value32);
+  // Stops at the end of the string
+  char shorthex[] = "ff";
+  StringConversion::FastAsciiHexToUnsigned(shorthex, &value, 8);
+  ASSERT_EQ(0xffull, value);
+}
+
+TEST(StringConversion, GetSizeString)
+{
+  std::string out;
+  ASSERT_STREQ("0", StringConversion::GetSizeString(out, 0ull));
+  ASSERT_STREQ("9", StringConversion::GetSizeString(out, 9ull));
+  ASSERT_STREQ("100", StringConversion::GetSizeString(out, 100ull));
+  ASSERT_STREQ("18446744073709551615",
+               StringConversion::GetSizeString(out, 18446744073709551615ull));
+  char buffer[32];
+  char* end = StringConversion::FastUnsignedToAscii(1234567890ull, buffer);
+  ASSERT_EQ("1234567890", std::string(buffer, end - buffer));
+}
+
+TEST(StringConversion, CurlEscape)
+{
+  ASSERT_EQ("/#curl#/eos/dev/file%20name%26x%3D1.dat_~-",
+            StringConversion::curl_escaped("/eos/dev/file name&x=1.dat_~-"));
+  ASSERT_EQ("/#curl#%C3%A4%25", StringConversion::curl_escaped("\xc3\xa4%"));
+  ASSERT_EQ("/#curl#", StringConversion::curl_escaped(""));
+  std::string path = "/eos/dev/a very long path with spaces/and?query=1&x#y";
+  ASSERT_EQ(path, StringConversion::curl_unescaped(
+              StringConversion::curl_escaped(path)));
+  // Not escaped strings are returned as is
+  ASSERT_EQ("/eos/dev/a%20b", StringConversion::curl_unescaped("/eos/dev/a%20b"));
+  // Invalid escape sequences are kept, lower case hex digits are accepted
+  ASSERT_EQ("a%zz%4%2f", StringConversion::curl_unescaped("/#curl#a%zz%4%252f"));
+  ASSERT_EQ("a/", StringConversion::curl_unescaped("/#curl#a%2f"));
+  // The result ends at an escaped null character like the C string of curl
+  ASSERT_EQ("ab", StringConversion::curl_unescaped("/#curl#ab%00cd"));
+  std::string out = "prefix:";
+  StringConversion::curl_escaped(path.data(), 8, out);
+  ASSERT_EQ("prefix:/#curl#/eos/dev", out);
+  std::string sealed;
+  StringConversion::SealXrdOpaque("a&b", 3, sealed);
+  StringConversion::UnsealXrdOpaque("#AND#c#AND", 10, sealed);
+  ASSERT_EQ("a#AND#b&c#AND", sealed);
+}
+
 EOSCOMMONTESTING_END
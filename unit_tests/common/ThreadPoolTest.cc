@@ -125,3 +125,48 @@ TEST(ThreadPoolTest, MaxMinDynamicScalling)
   std::this_thread::sleep_for(std::chrono::seconds(3));
   ASSERT_EQ(2, pool.GetSize());
 }
+
+// Test that the pool grows as soon as the tasks wait for too long
+TEST(ThreadPoolTest, ReactiveScaleUp)
+{
+  ThreadPool pool(1, 4);
+  std::promise<void> release;
+  std::shared_future<void> blocker = release.get_future().share();
+  auto blocked = pool.PushTask<void>([blocker] { blocker.wait(); });
+  auto future = pool.PushTask<int>([] { return 42; });
+  // Way below the default sampling period of 120 seconds
+  ASSERT_EQ(std::future_status::ready,
+            future.wait_for(std::chrono::seconds(5)));
+  ASSERT_EQ(42, future.get());
+  ASSERT_GT(pool.GetSize(), 1u);
+  release.set_value();
+  blocked.get();
+}
+
+// Test tasks pushed from a worker are stolen by the other workers
+TEST(ThreadPoolTest, NestedTasksStolen)
+{
+  ThreadPool pool(2, 2);
+  auto outer = pool.PushTask<std::set<std::thread::id>>([&pool] {
+    std::vector<std::future<std::thread::id>> futures;
+
+    for (int i = 0; i < 10; i++) {
+      futures.emplace_back(pool.PushTask<std::thread::id>([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return std::this_thread::get_id();
+      }));
+    }
+
+    // Blocking here leaves the nested tasks to the other worker
+    std::set<std::thread::id> ids;
+
+    for (auto& future : futures) {
+      ids.insert(future.get());
+    }
+
+    ids.insert(std::this_thread::get_id());
+    return ids;
+  });
+  ASSERT_EQ(2u, outer.get().size());
+  ASSERT_EQ(2u, pool.GetSize());
+}
@@ -22,6 +22,7 @@
  ************************************************************************/
 
 #include "common/Statfs.hh"
+#include "common/StripedRWMutex.hh"
 #include "Namespace.hh"
 #include "gtest/gtest.h"
 #include <list>
@@ -38,4 +39,36 @@ TEST(StatFs, BasicSanity)
   ASSERT_EQ(statfs, nullptr);
 }
 
+TEST(StripedRWMutex, BasicSanity)
+{
+  eos::common::StripedRWMutex locks(100);
+  ASSERT_EQ(locks.GetNumStripes(), 128u);
+
+  for (uint64_t id = 0; id < 1000; ++id) {
+    ASSERT_LT(locks.GetStripeIndex(id), locks.GetNumStripes());
+    ASSERT_EQ(&locks.GetStripe(id),
+              &locks.GetStripeByIndex(locks.GetStripeIndex(id)));
+  }
+
+  {
+    // Same id twice must not self-deadlock
+    eos::common::StripedWriteLock wr_lock(&locks, {1, 2, 1});
+    ASSERT_FALSE(locks.GetStripe(1).try_lock_shared());
+    ASSERT_FALSE(locks.GetStripe(2).try_lock_shared());
+  }
+
+  {
+    eos::common::StripedReadLock rd_lock(&locks, 1);
+    ASSERT_TRUE(locks.GetStripe(1).try_lock_shared());
+    locks.GetStripe(1).unlock_shared();
+    ASSERT_FALSE(locks.GetStripe(1).try_lock());
+  }
+
+  ASSERT_TRUE(locks.GetStripe(1).try_lock());
+  locks.GetStripe(1).unlock();
+  // Null mutex turns the guards into no-ops
+  eos::common::StripedWriteLock noop_wr(nullptr, {1});
+  eos::common::StripedReadLock noop_rd(nullptr, 1);
+}
+
 EOSCOMMONTESTING_END
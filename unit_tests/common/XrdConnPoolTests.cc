@@ -25,6 +25,7 @@
 #include "Namespace.hh"
 #include "common/XrdConnPool.hh"
 #include <list>
+#include <thread>
 
 EOSCOMMONTESTING_BEGIN
 
@@ -142,4 +143,44 @@ TEST(XrdConnPool, ConnIdHelper)
   lst.clear();
 }
 
+TEST(XrdConnPool, AdaptiveSize)
+{
+  XrdCl::URL url("root://eospps.cern.ch:1094/path/test.dat");
+  std::string surl1 = "root://1@eospps.cern.ch:1094/path/test.dat";
+  eos::common::XrdConnPool pool(true, 2);
+  pool.SetTargetDelay(std::chrono::milliseconds(100));
+  ASSERT_EQ(pool.AssignConnection(url), 1);
+  ASSERT_EQ(pool.AssignConnection(url), 2);
+  // Fast request using an exclusive connection
+  pool.ReleaseConnection(surl1, 10);
+  ASSERT_EQ(pool.AssignConnection(url), 1);
+  // Pool limit reached and no latency information, connection is shared
+  ASSERT_EQ(pool.AssignConnection(url), 1);
+  // Slow request using a shared connection
+  pool.ReleaseConnection(surl1, 500);
+  // Queueing delay above target, the pool grows
+  ASSERT_EQ(pool.AssignConnection(url), 3);
+  auto stats = pool.GetStats();
+  ASSERT_EQ(stats.mEndpoints, 1);
+  ASSERT_EQ(stats.mConnections, 3);
+  ASSERT_EQ(stats.mInFlight, 3);
+  ASSERT_EQ(stats.mShared, 1);
+  ASSERT_EQ(stats.mGrown, 1);
+  ASSERT_EQ(stats.mShrunk, 0);
+  // Idle connections are removed from the pool
+  pool.SetIdleTimeout(std::chrono::seconds(1));
+
+  for (uint32_t id = 1; id <= 3; ++id) {
+    pool.ReleaseConnection("root://" + std::to_string(id) +
+                           "@eospps.cern.ch:1094/path/test.dat");
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  ASSERT_EQ(pool.AssignConnection(url), 1);
+  stats = pool.GetStats();
+  ASSERT_EQ(stats.mConnections, 1);
+  ASSERT_EQ(stats.mInFlight, 1);
+  ASSERT_EQ(stats.mShrunk, 3);
+}
+
 EOSCOMMONTESTING_END
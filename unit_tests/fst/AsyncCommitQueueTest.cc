@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------
+// File: AsyncCommitQueueTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/utils/AsyncCommitQueue.hh"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using eos::fst::AsyncCommitQueue;
+using Status = AsyncCommitQueue::Status;
+
+TEST(AsyncCommitQueue, Retry)
+{
+  std::atomic<int> attempts {0};
+  std::atomic<int> gave_up {0};
+  AsyncCommitQueue queue(2, 5, std::chrono::milliseconds(1),
+                         std::chrono::milliseconds(4));
+  // Succeeds at the third attempt
+  ASSERT_TRUE(queue.Push("a", [&](size_t attempt) {
+    ++attempts;
+    return (attempt < 3) ? Status::kRetry : Status::kDone;
+  }, [&]() {
+    ++gave_up;
+  }));
+  ASSERT_TRUE(queue.Wait("a", std::chrono::seconds(10)));
+  ASSERT_EQ(3, attempts);
+  ASSERT_EQ(0, gave_up);
+  // Never succeeds
+  attempts = 0;
+  ASSERT_TRUE(queue.Push("b", [&](size_t attempt) {
+    ++attempts;
+    return Status::kRetry;
+  }, [&]() {
+    ++gave_up;
+  }));
+  ASSERT_TRUE(queue.Wait("b", std::chrono::seconds(10)));
+  ASSERT_EQ(5, attempts);
+  ASSERT_EQ(1, gave_up);
+  // Permanent failures are not retried and do not give up
+  attempts = 0;
+  ASSERT_TRUE(queue.Push("c", [&](size_t attempt) {
+    ++attempts;
+    return Status::kFailed;
+  }, [&]() {
+    ++gave_up;
+  }));
+  ASSERT_TRUE(queue.Wait("c", std::chrono::seconds(10)));
+  ASSERT_EQ(1, attempts);
+  ASSERT_EQ(1, gave_up);
+  ASSERT_EQ(0u, queue.GetQueued());
+}
+
+TEST(AsyncCommitQueue, KeyOrder)
+{
+  std::mutex mutex;
+  std::vector<int> order;
+  std::atomic<int> running {0};
+  std::atomic<bool> overlap {false};
+  AsyncCommitQueue queue(4, 3, std::chrono::milliseconds(1));
+
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_TRUE(queue.Push("file", [&, i](size_t attempt) {
+      if (++running > 1) {
+        overlap = true;
+      }
+
+      // Every commit fails once, the next ones have to wait for the retry
+      Status status = (attempt == 1) ? Status::kRetry : Status::kDone;
+
+      if (status == Status::kDone) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(i);
+      }
+
+      --running;
+      return status;
+    }, nullptr));
+  }
+
+  ASSERT_TRUE(queue.Wait("file", std::chrono::seconds(10)));
+  ASSERT_FALSE(overlap);
+  ASSERT_EQ(20u, order.size());
+
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_EQ(i, order[i]);
+  }
+}
+
+TEST(AsyncCommitQueue, StopAndFull)
+{
+  std::atomic<int> attempts {0};
+  std::atomic<int> gave_up {0};
+  {
+    // The retries are far away, the destructor attempts them one last time
+    AsyncCommitQueue queue(1, 10, std::chrono::seconds(3600),
+                           std::chrono::seconds(3600), 2);
+
+    for (int i = 0; i < 2; ++i) {
+      ASSERT_TRUE(queue.Push(std::to_string(i), [&](size_t attempt) {
+        ++attempts;
+        return Status::kRetry;
+      }, [&]() {
+        ++gave_up;
+      }));
+    }
+
+    ASSERT_FALSE(queue.Push("2", [](size_t) {
+      return Status::kDone;
+    }, nullptr));
+
+    while (attempts < 2) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ASSERT_FALSE(queue.Wait("0", std::chrono::milliseconds(10)));
+  }
+  ASSERT_EQ(4, attempts);
+  ASSERT_EQ(2, gave_up);
+}
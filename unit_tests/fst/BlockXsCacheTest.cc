@@ -0,0 +1,128 @@
+//------------------------------------------------------------------------------
+// File: BlockXsCacheTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/checksum/BlockXsCache.hh"
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using eos::fst::BlockXsCache;
+
+namespace
+{
+class BlockXsCacheTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    char tmpl[] = "/tmp/eos-blockxs-XXXXXX";
+    mFd = mkstemp(tmpl);
+    ASSERT_TRUE(mFd >= 0);
+    mPath = tmpl;
+    struct stat buf;
+    ASSERT_EQ(0, fstat(mFd, &buf));
+    mIno = buf.st_ino;
+  }
+
+  void TearDown() override
+  {
+    close(mFd);
+    unlink(mPath.c_str());
+  }
+
+  std::string ReadFile(off_t offset, size_t length)
+  {
+    std::string data(length, '\0');
+    ssize_t nread = pread(mFd, &data[0], length, offset);
+    data.resize(nread > 0 ? nread : 0);
+    return data;
+  }
+
+  std::string mPath;
+  int mFd {-1};
+  ino_t mIno {0};
+};
+}
+
+TEST_F(BlockXsCacheTest, ReadWrite)
+{
+  BlockXsCache cache(1024 * 1024);
+  std::string data(10000, 'x');
+  ASSERT_EQ(0, ftruncate(mFd, 20000));
+  ASSERT_EQ(5, pwrite(mFd, "hello", 5, 0));
+  cache.Attach(mIno);
+  char buffer[10000];
+  ASSERT_TRUE(cache.Read(mIno, mFd, 0, buffer, 5));
+  ASSERT_EQ("hello", std::string(buffer, 5));
+  // Straddles three pages, written back only on flush
+  ASSERT_TRUE(cache.Write(mIno, mFd, 4000, data.c_str(), data.size()));
+  ASSERT_EQ(std::string(10000, '\0'), ReadFile(4000, 10000));
+  ASSERT_TRUE(cache.Read(mIno, mFd, 4000, buffer, sizeof(buffer)));
+  ASSERT_EQ(data, std::string(buffer, sizeof(buffer)));
+  ASSERT_TRUE(cache.Flush(mIno));
+  ASSERT_EQ(data, ReadFile(4000, 10000));
+  // Bytes past the end of the file read as 0 and the file is not extended
+  ASSERT_TRUE(cache.Read(mIno, mFd, 19998, buffer, 10));
+  ASSERT_EQ(std::string(10, '\0'), std::string(buffer, 10));
+  ASSERT_TRUE(cache.Write(mIno, mFd, 19990, "0123456789", 10));
+  ASSERT_TRUE(cache.Flush(mIno));
+  struct stat buf;
+  ASSERT_EQ(0, fstat(mFd, &buf));
+  ASSERT_EQ(20000, buf.st_size);
+  ASSERT_EQ("0123456789", ReadFile(19990, 10));
+  ASSERT_TRUE(cache.Detach(mIno, mFd));
+  ASSERT_EQ(0u, cache.GetNumPages());
+}
+
+TEST_F(BlockXsCacheTest, EvictionAndDetach)
+{
+  // A single page per shard, every new page evicts the previous one
+  BlockXsCache cache(BlockXsCache::kPageSize, 1);
+  ASSERT_EQ(0, ftruncate(mFd, 4 * BlockXsCache::kPageSize));
+  int fd2 = open(mPath.c_str(), O_RDWR);
+  ASSERT_TRUE(fd2 >= 0);
+  cache.Attach(mIno);
+  cache.Attach(mIno);
+  ASSERT_TRUE(cache.Write(mIno, mFd, 0, "a", 1));
+  ASSERT_TRUE(cache.Write(mIno, fd2, BlockXsCache::kPageSize, "b", 1));
+  ASSERT_EQ(1u, cache.GetNumPages());
+  ASSERT_EQ("a", ReadFile(0, 1));
+  // Detaching a descriptor writes back its pages and keeps them cached
+  ASSERT_TRUE(cache.Detach(mIno, fd2));
+  close(fd2);
+  ASSERT_EQ("b", ReadFile(BlockXsCache::kPageSize, 1));
+  ASSERT_EQ(1u, cache.GetNumPages());
+  // Truncated content is dropped without write back
+  ASSERT_TRUE(cache.Write(mIno, mFd, BlockXsCache::kPageSize + 10, "c", 1));
+  cache.Truncate(mIno, BlockXsCache::kPageSize + 5);
+  ASSERT_EQ(0, ftruncate(mFd, BlockXsCache::kPageSize + 5));
+  char buffer[16];
+  ASSERT_TRUE(cache.Read(mIno, mFd, BlockXsCache::kPageSize, buffer, 16));
+  ASSERT_EQ(std::string("b") + std::string(15, '\0'), std::string(buffer, 16));
+  ASSERT_EQ(0, ftruncate(mFd, 2 * BlockXsCache::kPageSize));
+  ASSERT_TRUE(cache.Detach(mIno, mFd));
+  ASSERT_EQ(0u, cache.GetNumPages());
+  ASSERT_EQ(std::string(6, '\0'), ReadFile(BlockXsCache::kPageSize + 5, 6));
+}
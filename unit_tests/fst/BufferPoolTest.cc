@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------------
+// File: BufferPoolTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/BufferPool.hh"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+using eos::fst::BufferPool;
+
+TEST(BufferPool, SizeClasses)
+{
+  ASSERT_EQ(4096u, BufferPool::GetClassSize(0));
+  ASSERT_EQ(4096u, BufferPool::GetClassSize(1));
+  ASSERT_EQ(4096u, BufferPool::GetClassSize(4096));
+  ASSERT_EQ(8192u, BufferPool::GetClassSize(4097));
+  ASSERT_EQ(1024u * 1024u, BufferPool::GetClassSize(1000 * 1000));
+  ASSERT_EQ(BufferPool::kMaxClassSize,
+            BufferPool::GetClassSize(BufferPool::kMaxClassSize));
+  ASSERT_EQ(0u, BufferPool::GetClassSize(BufferPool::kMaxClassSize + 1));
+}
+
+TEST(BufferPool, Alignment)
+{
+  BufferPool pool(1024 * 1024);
+  BufferPool::Buffer small = pool.Get(100);
+  BufferPool::Buffer big = pool.Get(BufferPool::kMaxClassSize + 1);
+  BufferPool::Buffer aligned = pool.Get(100, 64 * 1024);
+  ASSERT_EQ(0u, (uintptr_t) small.GetDataPtr() % BufferPool::kAlignment);
+  ASSERT_EQ(0u, (uintptr_t) big.GetDataPtr() % BufferPool::kAlignment);
+  ASSERT_EQ(0u, (uintptr_t) aligned.GetDataPtr() % (64 * 1024));
+  ASSERT_EQ(4096u, small.GetCapacity());
+  ASSERT_EQ(BufferPool::kMaxClassSize + BufferPool::kAlignment,
+            big.GetCapacity());
+  ASSERT_EQ(4096u, aligned.GetCapacity());
+  memset(big.GetDataPtr(), 0, big.GetCapacity());
+}
+
+TEST(BufferPool, Reuse)
+{
+  BufferPool pool(64 * 1024);
+  BufferPool::Buffer buffer = pool.Get(10000);
+  char* data = buffer.GetDataPtr();
+  ASSERT_EQ(16384u, pool.GetLeasedBytes());
+  ASSERT_EQ(0u, pool.GetCachedBytes());
+  buffer.Release();
+  ASSERT_EQ(nullptr, buffer.GetDataPtr());
+  ASSERT_EQ(0u, pool.GetLeasedBytes());
+  ASSERT_EQ(16384u, pool.GetCachedBytes());
+  // Same size class gets the cached buffer back
+  buffer = pool.Get(16384);
+  ASSERT_EQ(data, buffer.GetDataPtr());
+  ASSERT_EQ(0u, pool.GetCachedBytes());
+  // Buffers of a different size class or alignment are never cached
+  {
+    BufferPool::Buffer other = pool.Get(4096, 8192);
+  }
+  ASSERT_EQ(0u, pool.GetCachedBytes());
+  ASSERT_EQ(16384u, pool.GetLeasedBytes());
+}
+
+TEST(BufferPool, CacheLimit)
+{
+  BufferPool pool(32 * 1024);
+  {
+    BufferPool::Buffer first = pool.Get(16384);
+    BufferPool::Buffer second = pool.Get(16384);
+    BufferPool::Buffer third = pool.Get(16384);
+  }
+  ASSERT_EQ(32u * 1024u, pool.GetCachedBytes());
+  ASSERT_EQ(0u, pool.GetLeasedBytes());
+}
+
+TEST(BufferPool, Move)
+{
+  BufferPool pool(64 * 1024);
+  BufferPool::Buffer buffer = pool.Get(4096);
+  char* data = buffer.GetDataPtr();
+  BufferPool::Buffer moved(std::move(buffer));
+  ASSERT_EQ(nullptr, buffer.GetDataPtr());
+  ASSERT_EQ(0u, buffer.GetCapacity());
+  ASSERT_EQ(data, moved.GetDataPtr());
+  BufferPool::Buffer assigned;
+  assigned = std::move(moved);
+  ASSERT_EQ(data, assigned.GetDataPtr());
+  ASSERT_EQ(4096u, pool.GetLeasedBytes());
+  // Assigning over a leased buffer releases it
+  assigned = pool.Get(8192);
+  ASSERT_EQ(4096u, pool.GetCachedBytes());
+  ASSERT_EQ(8192u, pool.GetLeasedBytes());
+}
@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+// File: CheckSumScanTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/checksum/Adler.hh"
+#include "fst/checksum/CRC32.hh"
+#include "fst/checksum/CRC32C.hh"
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using eos::fst::CheckSum;
+
+namespace
+{
+class CheckSumScanTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    char tmpl[] = "/tmp/eos-xsscan-XXXXXX";
+    mFd = mkstemp(tmpl);
+    ASSERT_TRUE(mFd >= 0);
+    mPath = tmpl;
+  }
+
+  void TearDown() override
+  {
+    close(mFd);
+    unlink(mPath.c_str());
+  }
+
+  //----------------------------------------------------------------------------
+  // Fill the file with random data
+  //----------------------------------------------------------------------------
+  void Fill(size_t length)
+  {
+    std::mt19937 rng(length);
+    mData.resize(length);
+
+    for (auto& c : mData) {
+      c = rng();
+    }
+
+    ASSERT_EQ(0, ftruncate(mFd, 0));
+    ASSERT_EQ((ssize_t) length, pwrite(mFd, mData.data(), length, 0));
+  }
+
+  //----------------------------------------------------------------------------
+  // Checksum of the data added in one go
+  //----------------------------------------------------------------------------
+  std::string Reference(CheckSum& xs)
+  {
+    xs.Reset();
+    xs.Add(mData.data(), mData.size(), 0);
+    xs.Finalize();
+    return xs.GetHexChecksum();
+  }
+
+  std::string mPath;
+  int mFd {-1};
+  std::vector<char> mData;
+};
+}
+
+TEST_F(CheckSumScanTest, Sequential)
+{
+  eos::fst::Adler adler;
+  eos::fst::CRC32C crc32c;
+
+  // Empty, single and many buffers, partial last one
+  for (size_t length : {0, 1000, 1024 * 1024, 3 * 1024 * 1024 + 17}) {
+    Fill(length);
+
+    for (CheckSum* xs : std::vector<CheckSum*> {&adler, &crc32c}) {
+      std::string ref = Reference(*xs);
+      unsigned long long scansize = 0;
+      float scantime = 0;
+      ASSERT_TRUE(xs->ScanFile(mFd, scansize, scantime));
+      ASSERT_EQ(length, scansize);
+      ASSERT_EQ(ref, xs->GetHexChecksum()) << xs->GetName() << " " << length;
+    }
+  }
+}
+
+TEST_F(CheckSumScanTest, ParallelSegments)
+{
+  eos::fst::Adler adler;
+  eos::fst::CRC32 crc32;
+  eos::fst::CRC32C crc32c;
+  Fill(5 * 1024 * 1024 + 4321);
+
+  for (CheckSum* xs : std::vector<CheckSum*> {&adler, &crc32, &crc32c}) {
+    std::string ref = Reference(*xs);
+
+    for (size_t num_threads : {1, 2, 3, 8}) {
+      unsigned long long scansize = 0;
+      float scantime = 0;
+      ASSERT_TRUE(xs->ScanFileParallel(mFd, scansize, scantime, num_threads,
+                                       1024 * 1024));
+      ASSERT_EQ(mData.size(), scansize);
+      ASSERT_EQ(ref, xs->GetHexChecksum()) << xs->GetName() << " " <<
+                                           num_threads;
+    }
+  }
+}
@@ -0,0 +1,109 @@
+//------------------------------------------------------------------------------
+// File: ChecksumKernelsTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "common/crc32c/checksumkernels.h"
+#include "common/crc32c/crc32c.h"
+#include "gtest/gtest.h"
+#include <zlib.h>
+#include <random>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// All the kernels supported by the CPU must agree with the reference ones for
+// any length and alignment
+//------------------------------------------------------------------------------
+TEST(ChecksumKernels, MatchReference)
+{
+  std::mt19937 rng(42);
+  std::vector<unsigned char> buffer(1024 * 1024 + 64);
+
+  for (auto& c : buffer) {
+    c = rng();
+  }
+
+  std::vector<size_t> lengths {0, 1, 15, 16, 31, 32, 63, 64, 65, 127, 4096,
+                               5552, 5553, 65537, 1024 * 1024};
+
+  for (size_t length : lengths) {
+    for (size_t offset : {0, 1, 7, 13}) {
+      const unsigned char* data = buffer.data() + offset;
+      uint32_t seed = rng();
+      uint32_t adler_seed = (seed % 65521) | (((seed >> 16) % 65521) << 16);
+      uint32_t ref_adler = ::adler32(adler_seed, data, length);
+      uint32_t ref_crc = ::crc32(seed, data, length);
+      uint32_t ref_crc32c = checksum::crc32cSarwate(seed, data, length);
+
+      for (auto k = checksum::adler32Kernels(); k->name; ++k) {
+        ASSERT_EQ(ref_adler, k->function(adler_seed, data, length)) << k->name;
+      }
+
+      for (auto k = checksum::crc32Kernels(); k->name; ++k) {
+        ASSERT_EQ(ref_crc, k->function(seed, data, length)) << k->name;
+      }
+
+      for (auto k = checksum::crc32cKernels(); k->name; ++k) {
+        ASSERT_EQ(ref_crc32c, k->function(seed, data, length)) << k->name;
+      }
+
+      ASSERT_EQ(ref_adler, checksum::adler32(adler_seed, data, length));
+      ASSERT_EQ(ref_crc, checksum::crc32(seed, data, length));
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Adler32 worst case input for the modulo reductions
+//------------------------------------------------------------------------------
+TEST(ChecksumKernels, AdlerAllOnes)
+{
+  std::vector<unsigned char> buffer(1024 * 1024, 0xff);
+  uint32_t seed = (65520u << 16) | 65520u;
+  uint32_t ref = ::adler32(seed, buffer.data(), buffer.size());
+
+  for (auto k = checksum::adler32Kernels(); k->name; ++k) {
+    ASSERT_EQ(ref, k->function(seed, buffer.data(), buffer.size())) << k->name;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Checksums of consecutive blocks combine into the checksum of the whole
+//------------------------------------------------------------------------------
+TEST(ChecksumKernels, Combine)
+{
+  std::mt19937 rng(7);
+  std::vector<unsigned char> buffer(256 * 1024);
+
+  for (auto& c : buffer) {
+    c = rng();
+  }
+
+  uint32_t ref = checksum::crc32cFinish(checksum::crc32c(checksum::crc32cInit(),
+                                        buffer.data(), buffer.size()));
+
+  for (size_t split : {0, 1, 4096, 100000, 256 * 1024}) {
+    uint32_t crc1 = checksum::crc32cFinish(checksum::crc32c(
+        checksum::crc32cInit(), buffer.data(), split));
+    uint32_t crc2 = checksum::crc32cFinish(checksum::crc32c(
+        checksum::crc32cInit(), buffer.data() + split, buffer.size() - split));
+    ASSERT_EQ(ref, checksum::crc32cCombine(crc1, crc2, buffer.size() - split));
+  }
+}
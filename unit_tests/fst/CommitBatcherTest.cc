@@ -0,0 +1,128 @@
+//------------------------------------------------------------------------------
+// File: CommitBatcherTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/utils/CommitBatcher.hh"
+#include "common/StringConversion.hh"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cerrno>
+#include <thread>
+
+using eos::fst::CommitBatcher;
+
+TEST(CommitBatcher, EncodeBatch)
+{
+  std::string query = CommitBatcher::EncodeBatch({"mgm.pcmd=commit&mgm.fid=1",
+                      "mgm.pcmd=commit&mgm.fid=2"
+                                                 });
+  ASSERT_EQ("/?mgm.pcmd=commitbatch&mgm.batch.n=2"
+            "&mgm.batch.0=mgm.pcmd=commit#AND#mgm.fid=1"
+            "&mgm.batch.1=mgm.pcmd=commit#AND#mgm.fid=2", query);
+  ASSERT_EQ("mgm.pcmd=commit&mgm.fid=2",
+            eos::common::StringConversion::UnsealXrdOpaque(
+              "mgm.pcmd=commit#AND#mgm.fid=2"));
+}
+
+TEST(CommitBatcher, DecodeResponse)
+{
+  std::vector<CommitBatcher::Result> results;
+  // The response buffer sent by the MGM is NUL terminated
+  const char response[] = "OK\n0\n43 commit file removed [EIDRM]\n0";
+  ASSERT_TRUE(CommitBatcher::DecodeResponse(
+                std::string(response, sizeof(response)), 3, results));
+  ASSERT_EQ(3u, results.size());
+  ASSERT_EQ(0, results[0].mErrno);
+  ASSERT_EQ(43, results[1].mErrno);
+  ASSERT_EQ("commit file removed [EIDRM]", results[1].mMsg);
+  ASSERT_EQ(0, results[2].mErrno);
+  ASSERT_FALSE(results[2].mFallback);
+  // Wrong number of entries or malformed lines
+  ASSERT_FALSE(CommitBatcher::DecodeResponse("OK\n0", 2, results));
+  ASSERT_FALSE(CommitBatcher::DecodeResponse("OK\nx", 1, results));
+  ASSERT_FALSE(CommitBatcher::DecodeResponse("ERR\n0", 1, results));
+  ASSERT_FALSE(CommitBatcher::DecodeResponse("OK0", 1, results));
+}
+
+TEST(CommitBatcher, BatchConcurrentCommits)
+{
+  std::atomic<int> num_batches {0};
+  std::atomic<int> num_entries {0};
+  CommitBatcher batcher([&](const std::string & manager,
+  const std::string & opaque, std::string & response) {
+    size_t pos = opaque.find("mgm.batch.n=");
+    int num = std::stoi(opaque.substr(pos + 12));
+    ++num_batches;
+    num_entries += num;
+    response = "OK";
+
+    for (int i = 0; i < num; ++i) {
+      response += "\n0";
+    }
+
+    return 0;
+  }, std::chrono::milliseconds(200), 8, 1);
+  std::vector<std::thread> threads;
+  std::atomic<int> num_ok {0};
+  std::atomic<int> num_fallback {0};
+
+  for (int i = 0; i < 16; ++i) {
+    threads.emplace_back([&, i]() {
+      CommitBatcher::Result res = batcher.Commit("mgm", "/?mgm.pcmd=commit"
+                                  "&mgm.fid=" + std::to_string(i));
+
+      if (res.mFallback) {
+        ++num_fallback;
+      } else if (res.mErrno == 0) {
+        ++num_ok;
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Every commit is either batched or, if it ended up alone, left to the caller
+  ASSERT_EQ(16, num_ok + num_fallback);
+  ASSERT_EQ(num_ok.load(), num_entries.load());
+  ASSERT_GE(num_ok.load(), 14);
+  ASSERT_LE(num_batches.load(), 3);
+}
+
+TEST(CommitBatcher, UnsupportedManager)
+{
+  std::atomic<int> num_calls {0};
+  CommitBatcher batcher([&](const std::string & manager,
+  const std::string & opaque, std::string & response) {
+    ++num_calls;
+    return EINVAL;
+  }, std::chrono::milliseconds(100), 2, 1);
+  std::thread other([&]() {
+    ASSERT_TRUE(batcher.Commit("mgm", "mgm.fid=1").mFallback);
+  });
+  ASSERT_TRUE(batcher.Commit("mgm", "mgm.fid=2").mFallback);
+  other.join();
+  ASSERT_EQ(1, num_calls.load());
+  // No more batching towards this manager
+  ASSERT_TRUE(batcher.Commit("mgm", "mgm.fid=3").mFallback);
+  ASSERT_EQ(1, num_calls.load());
+}
@@ -0,0 +1,271 @@
+//------------------------------------------------------------------------------
+// File: FmdSlotDbMapInterfaceTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/FmdSlotDbMapInterface.hh"
+#include "proto/FmdBase.pb.h"
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <set>
+#include <unistd.h>
+
+using eos::fst::FmdSlotDbMapInterface;
+using eos::fst::FmdBase;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Serialized record of a file with all the fields set like FmdHelper does
+//------------------------------------------------------------------------------
+std::string
+MakeRecord(uint64_t fid, const std::string& locations = "1,2")
+{
+  FmdBase fmd;
+  fmd.set_fid(fid);
+  fmd.set_cid(fid / 10);
+  fmd.set_fsid(7);
+  fmd.set_ctime(1500000000);
+  fmd.set_ctime_ns(1);
+  fmd.set_mtime(1500000001);
+  fmd.set_mtime_ns(2);
+  fmd.set_atime(1500000002);
+  fmd.set_atime_ns(3);
+  fmd.set_checktime(0);
+  fmd.set_size(fid * 1000);
+  fmd.set_disksize(fid * 1000);
+  fmd.set_mgmsize(0xfffffff1ULL);
+  fmd.set_checksum("0a1b2c3d");
+  fmd.set_diskchecksum("0a1b2c3d");
+  fmd.set_mgmchecksum("");
+  fmd.set_lid(0x100002);
+  fmd.set_uid(99);
+  fmd.set_gid(98);
+  fmd.set_filecxerror(0);
+  fmd.set_blockcxerror(0);
+  fmd.set_layouterror(-1);
+  fmd.set_locations(locations);
+  std::string value;
+  fmd.SerializePartialToString(&value);
+  return value;
+}
+
+eos::common::Slice
+Key(const uint64_t& fid)
+{
+  return eos::common::Slice((const char*) &fid, sizeof(fid));
+}
+
+//------------------------------------------------------------------------------
+// Compare a stored value with the expected record
+//------------------------------------------------------------------------------
+bool
+SameRecord(const std::string& expected, const std::string& value)
+{
+  FmdBase a, b;
+  return a.ParseFromString(expected) && b.ParseFromString(value) &&
+         (a.SerializeAsString() == b.SerializeAsString());
+}
+
+class FmdSlotStoreTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    char tmpl[] = "/tmp/eos-fmdslot-XXXXXX";
+    ASSERT_TRUE(mkdtemp(tmpl) != nullptr);
+    mDir = tmpl;
+    mDbName = mDir + "/fmd.0007.Slot";
+  }
+
+  void TearDown() override
+  {
+    std::string cmd = "rm -rf " + mDir;
+    (void) system(cmd.c_str());
+  }
+
+  bool Set(FmdSlotDbMapInterface& db, uint64_t fid, const std::string& value)
+  {
+    eos::common::DbMapTypes::Tval val {"", 1, "", value, ""};
+    return db.setEntry(Key(fid), val);
+  }
+
+  std::string mDir;
+  std::string mDbName;
+};
+}
+
+TEST_F(FmdSlotStoreTest, SetGetRemove)
+{
+  FmdSlotDbMapInterface db;
+  FmdSlotDbMapInterface::Tval val;
+  ASSERT_TRUE(db.attachDb(mDbName));
+  ASSERT_EQ(0u, db.size());
+  std::string long_locations(200, '1');
+  ASSERT_TRUE(Set(db, 1, MakeRecord(1)));
+  ASSERT_TRUE(Set(db, 1000000, MakeRecord(1000000, long_locations)));
+  ASSERT_EQ(2u, db.size());
+  ASSERT_EQ(1u, db.count(Key(1)));
+  ASSERT_EQ(0u, db.count(Key(2)));
+  ASSERT_TRUE(db.getEntry(Key(1), &val));
+  ASSERT_TRUE(SameRecord(MakeRecord(1), val.value));
+  ASSERT_TRUE(db.getEntry(Key(1000000), &val));
+  ASSERT_TRUE(SameRecord(MakeRecord(1000000, long_locations), val.value));
+  // Shrink the overflow record back into its slot and overwrite
+  ASSERT_TRUE(Set(db, 1000000, MakeRecord(1000000)));
+  ASSERT_EQ(2u, db.size());
+  ASSERT_TRUE(db.getEntry(Key(1000000), &val));
+  ASSERT_TRUE(SameRecord(MakeRecord(1000000), val.value));
+  ASSERT_TRUE(db.removeEntry(Key(1), val));
+  ASSERT_FALSE(db.getEntry(Key(1), &val));
+  ASSERT_EQ(1u, db.size());
+  // Records too large for an overflow chunk and invalid keys are refused
+  ASSERT_FALSE(Set(db, 3, MakeRecord(3, std::string(1000, '1'))));
+  ASSERT_FALSE(db.setEntry(eos::common::Slice("abc"), val));
+  ASSERT_TRUE(db.clear());
+  ASSERT_EQ(0u, db.size());
+  ASSERT_FALSE(db.getEntry(Key(1000000), &val));
+  ASSERT_TRUE(db.detachDb());
+}
+
+TEST_F(FmdSlotStoreTest, Transaction)
+{
+  FmdSlotDbMapInterface db;
+  FmdSlotDbMapInterface::Tval val;
+  ASSERT_TRUE(db.attachDb(mDbName));
+  db.setSyncTransactions(true);
+  ASSERT_TRUE(db.beginTransaction());
+
+  for (uint64_t fid = 1; fid <= 1000; ++fid) {
+    ASSERT_TRUE(Set(db, fid, MakeRecord(fid)));
+  }
+
+  ASSERT_TRUE(db.removeEntry(Key(10), val));
+  // Pending until the end of the transaction
+  ASSERT_EQ(0u, db.size());
+  ASSERT_TRUE(db.endTransaction());
+  ASSERT_EQ(999u, db.size());
+  ASSERT_FALSE(db.getEntry(Key(10), &val));
+  ASSERT_TRUE(db.getEntry(Key(11), &val));
+  ASSERT_TRUE(SameRecord(MakeRecord(11), val.value));
+}
+
+TEST_F(FmdSlotStoreTest, Iterate)
+{
+  FmdSlotDbMapInterface db;
+  ASSERT_TRUE(db.attachDb(mDbName));
+  std::set<uint64_t> fids {5, 339, 340, 341, 100000, 7000000000ull};
+
+  for (auto fid : fids) {
+    ASSERT_TRUE(Set(db, fid, MakeRecord(fid)));
+  }
+
+  // Iterate by blocks of two as the DbMap does when out-of-core
+  std::set<uint64_t> seen;
+  FmdSlotDbMapInterface::Tlogentry last;
+  FmdSlotDbMapInterface::TlogentryVec entries;
+
+  while (db.getAll(&entries, 2, &last)) {
+    ASSERT_LE(entries.size(), 2u);
+
+    for (const auto& entry : entries) {
+      uint64_t fid;
+      ASSERT_EQ(sizeof(fid), entry.key.size());
+      memcpy(&fid, entry.key.data(), sizeof(fid));
+      ASSERT_TRUE(SameRecord(MakeRecord(fid), entry.value));
+      ASSERT_TRUE(seen.insert(fid).second);
+    }
+
+    entries.clear();
+  }
+
+  ASSERT_EQ(fids, seen);
+}
+
+TEST_F(FmdSlotStoreTest, Reattach)
+{
+  FmdSlotDbMapInterface::Tval val;
+  {
+    FmdSlotDbMapInterface db;
+    ASSERT_TRUE(db.attachDb(mDbName));
+
+    for (uint64_t fid = 1; fid <= 2000; fid += 3) {
+      ASSERT_TRUE(Set(db, fid, MakeRecord(fid, fid % 2 ? std::string(100, '2') :
+                                          "3")));
+    }
+
+    ASSERT_TRUE(db.removeEntry(Key(4), val));
+  }
+  FmdSlotDbMapInterface db;
+  ASSERT_TRUE(db.attachDb(mDbName));
+  ASSERT_EQ(666u, db.size());
+  ASSERT_EQ(0u, db.GetJournalSize());
+  ASSERT_FALSE(db.getEntry(Key(4), &val));
+  ASSERT_TRUE(db.getEntry(Key(7), &val));
+  ASSERT_TRUE(SameRecord(MakeRecord(7, std::string(100, '2')), val.value));
+  ASSERT_TRUE(db.getEntry(Key(10), &val));
+  ASSERT_TRUE(SameRecord(MakeRecord(10, "3"), val.value));
+}
+
+TEST_F(FmdSlotStoreTest, CrashRecovery)
+{
+  FmdSlotDbMapInterface::Tval val;
+  FmdSlotDbMapInterface db;
+  ASSERT_TRUE(db.attachDb(mDbName));
+  ASSERT_TRUE(Set(db, 1, MakeRecord(1)));
+  ASSERT_TRUE(Set(db, 2, MakeRecord(2)));
+  ASSERT_TRUE(db.Checkpoint());
+  ASSERT_TRUE(Set(db, 2, MakeRecord(2, "4,5")));
+  ASSERT_TRUE(Set(db, 3, MakeRecord(3)));
+  ASSERT_LT(0u, db.GetJournalSize());
+  // Take a copy of the files as if the FST died before the next checkpoint
+  std::string crash = mDir + "/crash";
+  std::string cmd = "cp -r " + mDbName + " " + crash;
+  ASSERT_EQ(0, system(cmd.c_str()));
+  // Tear the slot of fid 2 and the tail of the journal
+  int fd = open((crash + "/slots").c_str(), O_WRONLY);
+  ASSERT_TRUE(fd >= 0);
+  off_t off = 4096 + 256 + 2 * FmdSlotDbMapInterface::kSlotSize + 40;
+  ASSERT_EQ(8, pwrite(fd, "garbage!", 8, off));
+  close(fd);
+  fd = open((crash + "/journal").c_str(), O_WRONLY | O_APPEND);
+  ASSERT_TRUE(fd >= 0);
+  ASSERT_EQ(10, write(fd, "\x4a\x52\x4e\x4ctorn!", 10));
+  close(fd);
+  FmdSlotDbMapInterface recovered;
+  ASSERT_TRUE(recovered.attachDb(crash));
+  ASSERT_EQ(3u, recovered.size());
+  ASSERT_TRUE(recovered.getEntry(Key(2), &val));
+  ASSERT_TRUE(SameRecord(MakeRecord(2, "4,5"), val.value));
+  ASSERT_TRUE(recovered.getEntry(Key(3), &val));
+  ASSERT_TRUE(SameRecord(MakeRecord(3), val.value));
+  // A torn slot without journal entry is dropped
+  ASSERT_TRUE(recovered.detachDb());
+  fd = open((crash + "/slots").c_str(), O_WRONLY);
+  ASSERT_TRUE(fd >= 0);
+  off = 4096 + 256 + 1 * FmdSlotDbMapInterface::kSlotSize + 40;
+  ASSERT_EQ(8, pwrite(fd, "garbage!", 8, off));
+  close(fd);
+  ASSERT_TRUE(recovered.attachDb(crash));
+  ASSERT_EQ(2u, recovered.size());
+  ASSERT_FALSE(recovered.getEntry(Key(1), &val));
+}
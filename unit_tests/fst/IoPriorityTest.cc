@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+// File: IoPriorityTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/utils/IoPriority.hh"
+#include "gtest/gtest.h"
+
+using eos::fst::IoPriority;
+using eos::fst::IoThrottle;
+
+TEST(IoPriority, Parse)
+{
+  int ioprio = -1;
+  ASSERT_TRUE(IoPriority::Parse("none", ioprio));
+  ASSERT_EQ(0, ioprio);
+  ASSERT_TRUE(IoPriority::Parse("idle", ioprio));
+  ASSERT_EQ(3 << 13, ioprio);
+  ASSERT_TRUE(IoPriority::Parse("be", ioprio));
+  ASSERT_EQ((2 << 13) | 4, ioprio);
+  ASSERT_TRUE(IoPriority::Parse("be:7", ioprio));
+  ASSERT_EQ((2 << 13) | 7, ioprio);
+  ASSERT_TRUE(IoPriority::Parse("be:0", ioprio));
+  ASSERT_EQ(2 << 13, ioprio);
+  ASSERT_FALSE(IoPriority::Parse("be:8", ioprio));
+  ASSERT_FALSE(IoPriority::Parse("be:", ioprio));
+  ASSERT_FALSE(IoPriority::Parse("rt:0", ioprio));
+  ASSERT_FALSE(IoPriority::Parse("", ioprio));
+  ASSERT_EQ(IoPriority::kDrain, IoPriority::GetClassFromApp("eos/draining"));
+  ASSERT_EQ(IoPriority::kBalance, IoPriority::GetClassFromApp("eos/balancing"));
+  ASSERT_EQ(IoPriority::kUser, IoPriority::GetClassFromApp("eos/replication"));
+  ASSERT_EQ(0, IoPriority::Get(IoPriority::kUser));
+  ASSERT_STREQ("scrub", IoPriority::GetName(IoPriority::kScrub));
+  ASSERT_STREQ("user", IoPriority::GetName(IoPriority::kUser));
+}
+
+TEST(IoPriority, Throttle)
+{
+  using namespace std::chrono;
+  IoThrottle throttle;
+  steady_clock::time_point now = steady_clock::now();
+  // No limit by default
+  ASSERT_EQ(0, throttle.Reserve(1 << 30, now).count());
+  ASSERT_EQ(0, throttle.Reserve(1 << 30, now).count());
+  // 1 MB/s, 1 MB requests are spaced by one second
+  throttle.SetRate(1024 * 1024);
+  ASSERT_EQ(0, throttle.Reserve(1024 * 1024, now).count());
+  ASSERT_EQ(1000000, throttle.Reserve(1024 * 1024, now).count());
+  ASSERT_EQ(1500000, throttle.Reserve(512 * 1024, now + milliseconds(500)).count());
+  // An idle period does not accumulate credit
+  now += seconds(10);
+  ASSERT_EQ(0, throttle.Reserve(1024 * 1024, now).count());
+  ASSERT_EQ(1000000, throttle.Reserve(1024 * 1024, now).count());
+  throttle.SetRate(0);
+  ASSERT_EQ(0, throttle.Reserve(1024 * 1024, now).count());
+}
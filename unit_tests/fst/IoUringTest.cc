@@ -0,0 +1,133 @@
+//------------------------------------------------------------------------------
+// File: IoUringTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/local/IoUring.hh"
+#include "gtest/gtest.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <vector>
+
+using eos::fst::IoUring;
+
+//------------------------------------------------------------------------------
+// Write, sync and read back a file through the ring
+//------------------------------------------------------------------------------
+TEST(IoUring, ReadWriteSync)
+{
+  if (!IoUring::IsSupported()) {
+    std::cerr << "io_uring not supported, skipping test" << std::endl;
+    return;
+  }
+
+  char tmp_path[] = "/tmp/eos.iouring.XXXXXX";
+  int fd = mkstemp(tmp_path);
+  ASSERT_NE(-1, fd);
+  const size_t block = 4096;
+  const size_t num_blocks = 64;
+  std::vector<char> wbuf(block * num_blocks);
+  std::vector<char> rbuf(block * num_blocks, 0);
+
+  for (size_t i = 0; i < wbuf.size(); ++i) {
+    wbuf[i] = (char)(i * 7);
+  }
+
+  // Use a small ring so that submissions have to wait for completions
+  {
+    IoUring ring(8);
+    ASSERT_TRUE(ring.IsOk());
+    std::atomic<size_t> nbytes {0};
+    std::atomic<int> nerrors {0};
+    auto cb = [&](int res) {
+      if (res < 0) {
+        ++nerrors;
+      } else {
+        nbytes += res;
+      }
+    };
+
+    for (size_t i = 0; i < num_blocks; ++i) {
+      ASSERT_TRUE(ring.SubmitWrite(fd, wbuf.data() + i * block, block,
+                                   i * block, cb));
+    }
+
+    // Requests are not ordered, wait for the writes before moving on
+    while (nbytes + nerrors < wbuf.size()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ASSERT_EQ(0, nerrors);
+    std::promise<int> sync_done;
+    ASSERT_TRUE(ring.SubmitFsync(fd, [&](int res) {
+      sync_done.set_value(res);
+    }));
+    ASSERT_EQ(0, sync_done.get_future().get());
+
+    for (size_t i = 0; i < num_blocks; ++i) {
+      ASSERT_TRUE(ring.SubmitRead(fd, rbuf.data() + i * block, block,
+                                  i * block, cb));
+    }
+
+    // Read past the end of the file returns 0 and a bad descriptor an error
+    std::promise<int> eof_done;
+    ASSERT_TRUE(ring.SubmitRead(fd, rbuf.data(), block, 2 * wbuf.size(),
+    [&](int res) {
+      eof_done.set_value(res);
+    }));
+    ASSERT_EQ(0, eof_done.get_future().get());
+    std::promise<int> ebadf_done;
+    ASSERT_TRUE(ring.SubmitRead(-1, rbuf.data(), block, 0, [&](int res) {
+      ebadf_done.set_value(res);
+    }));
+    ASSERT_EQ(-EBADF, ebadf_done.get_future().get());
+    while (nbytes + nerrors < 2 * wbuf.size()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ASSERT_EQ(0, nerrors);
+  }
+
+  ASSERT_EQ(0, memcmp(wbuf.data(), rbuf.data(), wbuf.size()));
+  (void) close(fd);
+  (void) unlink(tmp_path);
+}
+
+//------------------------------------------------------------------------------
+// Files on the same device share the same ring
+//------------------------------------------------------------------------------
+TEST(IoUring, RingPerDevice)
+{
+  if (!IoUring::IsSupported()) {
+    std::cerr << "io_uring not supported, skipping test" << std::endl;
+    return;
+  }
+
+  auto ring1 = IoUring::GetRing(1);
+  auto ring2 = IoUring::GetRing(1);
+  auto ring3 = IoUring::GetRing(2);
+  ASSERT_TRUE(ring1 != nullptr);
+  ASSERT_EQ(ring1.get(), ring2.get());
+  ASSERT_NE(ring1.get(), ring3.get());
+}
@@ -0,0 +1,84 @@
+//------------------------------------------------------------------------------
+// File: LoadTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "fst/Load.hh"
+#include <sstream>
+
+using eos::fst::DiskBusy;
+
+//------------------------------------------------------------------------------
+// Build a /proc/diskstats line, newer kernels append four more fields
+//------------------------------------------------------------------------------
+static std::string
+DiskStatsLine(const std::string& dev, unsigned long long in_flight,
+              unsigned long long millis_io,
+              unsigned long long weighted_millis_io, bool extended = false)
+{
+  std::ostringstream oss;
+  oss << "   8       0 " << dev << " 100 0 800 50 100 0 800 50 " << in_flight
+      << " " << millis_io << " " << weighted_millis_io;
+
+  if (extended) {
+    oss << " 0 0 0 0";
+  }
+
+  oss << "\n";
+  return oss.str();
+}
+
+TEST(DiskBusy, Averages)
+{
+  DiskBusy disk;
+  auto now = std::chrono::steady_clock::now();
+  ASSERT_FALSE(disk.Update("garbage\n", now));
+  ASSERT_TRUE(disk.Update(DiskStatsLine("sda", 0, 1000, 2000) +
+                          DiskStatsLine("sdb", 3, 0, 0, true), now));
+  // No rates before the second sample
+  ASSERT_EQ(-1, disk.GetBusy("sda"));
+  ASSERT_EQ(-1, disk.GetQueueDepth("sda"));
+  ASSERT_EQ(3, disk.GetInFlight("sdb"));
+  ASSERT_EQ(-1, disk.GetInFlight("sdc"));
+  // sda busy for 125 of 250 ms with 4 requests queued, sdb saturated
+  now += std::chrono::milliseconds(250);
+  ASSERT_TRUE(disk.Update(DiskStatsLine("sda", 4, 1125, 3000) +
+                          DiskStatsLine("sdb", 3, 300, 750, true), now));
+  ASSERT_DOUBLE_EQ(50.0, disk.GetBusy("sda"));
+  ASSERT_DOUBLE_EQ(4.0, disk.GetQueueDepth("sda"));
+  ASSERT_DOUBLE_EQ(100.0, disk.GetBusy("sdb"));
+  ASSERT_DOUBLE_EQ(3.0, disk.GetQueueDepth("sdb"));
+
+  // The average follows an idle disk within about a second
+  for (int i = 0; i < 4; ++i) {
+    now += std::chrono::milliseconds(250);
+    ASSERT_TRUE(disk.Update(DiskStatsLine("sda", 0, 1125, 3000), now));
+  }
+
+  ASSERT_GT(disk.GetBusy("sda"), 0.0);
+  ASSERT_LT(disk.GetBusy("sda"), 50.0 * 0.4);
+  ASSERT_LT(disk.GetQueueDepth("sda"), 4.0 * 0.4);
+  // A counter reset keeps the previous average
+  double busy = disk.GetBusy("sda");
+  now += std::chrono::milliseconds(250);
+  ASSERT_TRUE(disk.Update(DiskStatsLine("sda", 0, 10, 10), now));
+  ASSERT_DOUBLE_EQ(busy, disk.GetBusy("sda"));
+}
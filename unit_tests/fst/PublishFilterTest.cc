@@ -0,0 +1,74 @@
+//------------------------------------------------------------------------------
+// File: PublishFilterTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/utils/PublishFilter.hh"
+#include "gtest/gtest.h"
+
+using eos::fst::PublishFilter;
+
+TEST(PublishFilter, OnlyChangedValues)
+{
+  PublishFilter filter(0.1, std::chrono::seconds(60));
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  filter.BeginCycle(now);
+  // First cycle publishes everything
+  ASSERT_TRUE(filter.Changed("fs1", "stat.boot", std::string("booted")));
+  ASSERT_TRUE(filter.Changed("fs1", "stat.ropen", 5ll));
+  ASSERT_TRUE(filter.Changed("fs1", "stat.disk.load", 10.0));
+  ASSERT_TRUE(filter.Changed("fs2", "stat.ropen", 5ll));
+  filter.BeginCycle(now + std::chrono::seconds(1));
+  ASSERT_FALSE(filter.Changed("fs1", "stat.boot", std::string("booted")));
+  ASSERT_TRUE(filter.Changed("fs1", "stat.boot", std::string("booting")));
+  ASSERT_FALSE(filter.Changed("fs1", "stat.ropen", 5ll));
+  ASSERT_TRUE(filter.Changed("fs1", "stat.ropen", 6ll));
+  // Within the tolerance of the last published value
+  ASSERT_FALSE(filter.Changed("fs1", "stat.disk.load", 10.9));
+  ASSERT_FALSE(filter.Changed("fs1", "stat.disk.load", 9.1));
+  ASSERT_TRUE(filter.Changed("fs1", "stat.disk.load", 11.5));
+  ASSERT_FALSE(filter.Changed("fs1", "stat.disk.load", 12.5));
+  // Small absolute changes around zero are ignored too
+  ASSERT_TRUE(filter.Changed("fs1", "stat.disk.readratemb", 0.0));
+  ASSERT_FALSE(filter.Changed("fs1", "stat.disk.readratemb", 0.05));
+  ASSERT_EQ(6u, filter.GetNumSuppressed());
+  ASSERT_EQ(8u, filter.GetNumPublished());
+}
+
+TEST(PublishFilter, RefreshAndForget)
+{
+  PublishFilter filter(0.1, std::chrono::seconds(60));
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  filter.BeginCycle(now);
+  ASSERT_TRUE(filter.Changed("fs1", "stat.ropen", 5ll));
+  ASSERT_TRUE(filter.Changed("fs1", "stat.disk.load", 10.0));
+  filter.BeginCycle(now + std::chrono::seconds(30));
+  ASSERT_FALSE(filter.Changed("fs1", "stat.ropen", 5ll));
+  ASSERT_FALSE(filter.Changed("fs1", "stat.disk.load", 10.5));
+  // Everything is published again after the refresh interval, the published
+  // value becomes the reference
+  filter.BeginCycle(now + std::chrono::seconds(60));
+  ASSERT_TRUE(filter.Changed("fs1", "stat.ropen", 5ll));
+  ASSERT_TRUE(filter.Changed("fs1", "stat.disk.load", 10.5));
+  filter.BeginCycle(now + std::chrono::seconds(61));
+  ASSERT_FALSE(filter.Changed("fs1", "stat.disk.load", 11.5));
+  filter.Forget("fs1");
+  ASSERT_TRUE(filter.Changed("fs1", "stat.ropen", 5ll));
+}
@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------
+// File: ReadVCoalescerTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/utils/ReadVCoalescer.hh"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <vector>
+
+using eos::fst::ReadVCoalescer;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Build a vector read description
+//------------------------------------------------------------------------------
+std::vector<XrdOucIOVec>
+MakeReadV(const std::vector<std::pair<long long, int>>& chunks,
+          std::vector<std::vector<char>>& buffers)
+{
+  std::vector<XrdOucIOVec> readv;
+  buffers.resize(chunks.size());
+
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    buffers[i].resize(chunks[i].second);
+    XrdOucIOVec elem;
+    memset(&elem, 0, sizeof(elem));
+    elem.offset = chunks[i].first;
+    elem.size = chunks[i].second;
+    elem.data = buffers[i].data();
+    readv.push_back(elem);
+  }
+
+  return readv;
+}
+
+//------------------------------------------------------------------------------
+// Fill the merged reads with data derived from the file offset
+//------------------------------------------------------------------------------
+void
+FillMerged(ReadVCoalescer& coalescer)
+{
+  for (uint32_t i = 0; i < coalescer.GetReadCount(); ++i) {
+    XrdOucIOVec& elem = coalescer.GetReadV()[i];
+
+    for (int j = 0; j < elem.size; ++j) {
+      elem.data[j] = (char)((elem.offset + j) % 251);
+    }
+  }
+}
+}
+
+//------------------------------------------------------------------------------
+// Chunks closer than the gap are merged, the others are left alone
+//------------------------------------------------------------------------------
+TEST(ReadVCoalescer, MergeAndScatter)
+{
+  std::vector<std::vector<char>> buffers;
+  // Unsorted, adjacent, overlapping and far away chunks
+  auto readv = MakeReadV({{1000, 100}, {0, 100}, {100, 50}, {120, 100},
+    {500, 10}, {1 << 20, 64}
+  }, buffers);
+  ReadVCoalescer coalescer(readv.data(), readv.size(), 512);
+  ASSERT_TRUE(coalescer.IsCoalesced());
+  ASSERT_EQ(2u, coalescer.GetReadCount());
+  ASSERT_EQ(0, coalescer.GetReadV()[0].offset);
+  ASSERT_EQ(1100, coalescer.GetReadV()[0].size);
+  ASSERT_EQ(1 << 20, coalescer.GetReadV()[1].offset);
+  // A single chunk is read directly into its own buffer
+  ASSERT_EQ(buffers[5].data(), coalescer.GetReadV()[1].data);
+  ASSERT_EQ(424u, coalescer.GetReqLength());
+  ASSERT_EQ(1164u, coalescer.GetReadLength());
+  FillMerged(coalescer);
+  coalescer.Scatter();
+
+  for (size_t i = 0; i < readv.size(); ++i) {
+    for (int j = 0; j < readv[i].size; ++j) {
+      ASSERT_EQ((char)((readv[i].offset + j) % 251), buffers[i][j]);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Merged reads are bounded by the maximum length
+//------------------------------------------------------------------------------
+TEST(ReadVCoalescer, MaxLength)
+{
+  std::vector<std::vector<char>> buffers;
+  auto readv = MakeReadV({{0, 400}, {400, 400}, {800, 400}, {1200, 400}},
+                         buffers);
+  ReadVCoalescer coalescer(readv.data(), readv.size(), 0, 800);
+  ASSERT_TRUE(coalescer.IsCoalesced());
+  ASSERT_EQ(2u, coalescer.GetReadCount());
+  ASSERT_EQ(800, coalescer.GetReadV()[0].size);
+  ASSERT_EQ(800, coalescer.GetReadV()[1].offset);
+  ReadVCoalescer none(readv.data(), readv.size(), 0, 400);
+  ASSERT_FALSE(none.IsCoalesced());
+  ASSERT_EQ(4u, none.GetReadCount());
+}
@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+// File: ReadaheadTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/xrd/Readahead.hh"
+#include "gtest/gtest.h"
+
+using eos::fst::ReadaheadBlock;
+using eos::fst::ReadaheadBlockPool;
+using eos::fst::ReadaheadPolicy;
+
+//------------------------------------------------------------------------------
+// Classification of the access pattern
+//------------------------------------------------------------------------------
+TEST(ReadaheadPolicy, Pattern)
+{
+  ReadaheadPolicy policy(2, 8);
+  ASSERT_EQ(ReadaheadPolicy::Pattern::kSequential, policy.Update(0, 100));
+  ASSERT_EQ(ReadaheadPolicy::Pattern::kSequential, policy.Update(100, 100));
+  ASSERT_EQ(ReadaheadPolicy::Pattern::kRandom, policy.Update(1000, 100));
+  ASSERT_EQ(ReadaheadPolicy::Pattern::kRandom, policy.Update(2000, 100));
+  ASSERT_EQ(ReadaheadPolicy::Pattern::kStrided, policy.Update(3000, 100));
+  ASSERT_EQ(1000, policy.GetStride());
+  ASSERT_EQ(ReadaheadPolicy::Pattern::kStrided, policy.Update(4000, 100));
+  ASSERT_EQ(ReadaheadPolicy::Pattern::kRandom, policy.Update(500, 100));
+  ASSERT_EQ(ReadaheadPolicy::Pattern::kSequential, policy.Update(600, 100));
+}
+
+//------------------------------------------------------------------------------
+// Window adapts to the hit rate
+//------------------------------------------------------------------------------
+TEST(ReadaheadPolicy, Window)
+{
+  ReadaheadPolicy policy(2, 8);
+  ASSERT_EQ(2u, policy.GetWindow());
+
+  for (uint32_t i = 0; i < 3 * ReadaheadPolicy::kSampleSize; ++i) {
+    policy.Hit();
+  }
+
+  ASSERT_EQ(8u, policy.GetWindow());
+
+  // Mixed sample keeps the window unchanged
+  for (uint32_t i = 0; i < ReadaheadPolicy::kSampleSize; ++i) {
+    (i % 3) ? policy.Hit() : policy.Miss();
+  }
+
+  ASSERT_EQ(8u, policy.GetWindow());
+
+  for (uint32_t i = 0; i < 5 * ReadaheadPolicy::kSampleSize; ++i) {
+    policy.Miss();
+  }
+
+  ASSERT_EQ(1u, policy.GetWindow());
+  ASSERT_GT(policy.GetEfficiency(), 0.0);
+  ASSERT_LT(policy.GetEfficiency(), 100.0);
+}
+
+//------------------------------------------------------------------------------
+// Block pool reuses blocks and respects the memory limit
+//------------------------------------------------------------------------------
+TEST(ReadaheadBlockPool, Limit)
+{
+  ReadaheadBlockPool pool(4096);
+  ReadaheadBlock* blk1 = pool.Get(1024);
+  ReadaheadBlock* blk2 = pool.Get(1024);
+  ReadaheadBlock* blk3 = pool.Get(2048);
+  ASSERT_NE(nullptr, blk1);
+  ASSERT_NE(nullptr, blk2);
+  ASSERT_NE(nullptr, blk3);
+  ASSERT_EQ(nullptr, pool.Get(1024));
+  ASSERT_EQ(4096u, pool.GetAllocatedBytes());
+  pool.Put(blk1);
+  ASSERT_EQ(1024u, pool.GetCachedBytes());
+  // Cached block of the same size is reused
+  ASSERT_EQ(blk1, pool.Get(1024));
+  ASSERT_EQ(0u, pool.GetCachedBytes());
+  // Cached blocks of other sizes are evicted to make room
+  pool.Put(blk1);
+  pool.Put(blk2);
+  ReadaheadBlock* blk4 = pool.Get(2048);
+  ASSERT_NE(nullptr, blk4);
+  ASSERT_EQ(2048u, blk4->capacity);
+  ASSERT_EQ(0u, pool.GetCachedBytes());
+  ASSERT_EQ(4096u, pool.GetAllocatedBytes());
+  pool.Put(blk3);
+  pool.Put(blk4);
+}
@@ -0,0 +1,102 @@
+//------------------------------------------------------------------------------
+// File: StripeOpenTrackerTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/layout/StripeOpenTracker.hh"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using eos::fst::StripeOpenTracker;
+using State = StripeOpenTracker::State;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Send an open response to a handler
+//------------------------------------------------------------------------------
+void Respond(XrdCl::ResponseHandler* handler, bool ok)
+{
+  XrdCl::XRootDStatus* status = ok ? new XrdCl::XRootDStatus() :
+                                new XrdCl::XRootDStatus(XrdCl::stError,
+                                    XrdCl::errSocketTimeout);
+  handler->HandleResponseWithHosts(status, nullptr, nullptr);
+}
+}
+
+TEST(StripeOpenTracker, AllResponses)
+{
+  auto tracker = std::make_shared<StripeOpenTracker>(4);
+  std::vector<std::thread> threads;
+
+  for (unsigned int i = 1; i < 4; ++i) {
+    XrdCl::ResponseHandler* handler = tracker->GetHandler(i);
+    threads.emplace_back([handler, i]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5 * i));
+      Respond(handler, (i != 2));
+    });
+  }
+
+  ASSERT_TRUE(tracker->Wait(0, std::chrono::milliseconds(0)));
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(State::kNone, tracker->GetState(0));
+  ASSERT_EQ(State::kOk, tracker->GetState(1));
+  ASSERT_EQ(State::kFailed, tracker->GetState(2));
+  ASSERT_EQ(State::kOk, tracker->GetState(3));
+}
+
+TEST(StripeOpenTracker, EarlyCompletion)
+{
+  auto tracker = std::make_shared<StripeOpenTracker>(4);
+  // Opened synchronously
+  tracker->Done(0, true);
+  XrdCl::ResponseHandler* late = tracker->GetHandler(3);
+  Respond(tracker->GetHandler(1), true);
+  Respond(tracker->GetHandler(2), false);
+  // Not enough successful opens, the grace period does not apply
+  std::thread responder([late]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    Respond(late, true);
+  });
+  ASSERT_TRUE(tracker->Wait(3, std::chrono::milliseconds(0)));
+  responder.join();
+  ASSERT_EQ(State::kOk, tracker->GetState(3));
+  // Enough successful opens, the slowest one is left behind
+  tracker = std::make_shared<StripeOpenTracker>(3);
+  Respond(tracker->GetHandler(0), true);
+  Respond(tracker->GetHandler(1), true);
+  late = tracker->GetHandler(2);
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_FALSE(tracker->Wait(2, std::chrono::milliseconds(20)));
+  ASSERT_TRUE(std::chrono::steady_clock::now() - start >=
+              std::chrono::milliseconds(20));
+  ASSERT_EQ(State::kPending, tracker->GetState(2));
+  // The late response is still recorded
+  Respond(late, false);
+  ASSERT_TRUE(tracker->Wait(0, std::chrono::milliseconds(0)));
+  ASSERT_EQ(State::kFailed, tracker->GetState(2));
+}
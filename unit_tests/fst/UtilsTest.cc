@@ -241,3 +241,60 @@ TEST(OpenFileTracker, SortedByUseCount) {
   auto hotFiles3 = oft.getHotFiles(3, 0);
   ASSERT_TRUE(hotFiles3.empty());
 }
+
+TEST(OpenFileTracker, HotIo) {
+  eos::common::SteadyClock clock(true);
+  eos::fst::OpenFileTracker oft(&clock, std::chrono::seconds(10));
+
+  // Nothing reported until the first window is complete
+  oft.addIo(1, 100, 1000);
+  ASSERT_TRUE(oft.getHotIo(1, 10).empty());
+
+  for(size_t i = 0; i < 9; i++) {
+    oft.addIo(1, 100, 1000);
+  }
+
+  oft.addIo(1, 200, 50000);
+  oft.addIo(2, 300, 1);
+
+  clock.advance(std::chrono::seconds(10));
+  auto hot = oft.getHotIo(1, 10);
+  ASSERT_EQ(hot.size(), 2u);
+  ASSERT_EQ(hot[0].fid, 200u);
+  ASSERT_DOUBLE_EQ(hot[0].bytesPerSec, 5000);
+  ASSERT_DOUBLE_EQ(hot[0].iops, 0.1);
+  ASSERT_EQ(hot[1].fid, 100u);
+  ASSERT_DOUBLE_EQ(hot[1].bytesPerSec, 1000);
+  ASSERT_DOUBLE_EQ(hot[1].iops, 1);
+  ASSERT_EQ(oft.getHotIo(1, 1).size(), 1u);
+  ASSERT_EQ(oft.getHotIo(2, 10).size(), 1u);
+
+  // New window, the previous one is reported meanwhile
+  oft.addIo(1, 100, 1000);
+  clock.advance(std::chrono::seconds(5));
+  ASSERT_EQ(oft.getHotIo(1, 10).size(), 2u);
+
+  // Idle filesystem cools down
+  clock.advance(std::chrono::seconds(30));
+  oft.addIo(1, 100, 1000);
+  ASSERT_TRUE(oft.getHotIo(1, 10).empty());
+}
+
+TEST(OpenFileTracker, HotIoBoundedMemory) {
+  eos::common::SteadyClock clock(true);
+  eos::fst::OpenFileTracker oft(&clock, std::chrono::seconds(10));
+
+  // One heavy file among many light ones sharing its shard
+  for(uint64_t fid = 0; fid < 100000; fid++) {
+    oft.addIo(1, fid * 16, 10);
+    if(fid % 100 == 0) {
+      oft.addIo(1, 7 * 16, 100000);
+    }
+  }
+
+  clock.advance(std::chrono::seconds(10));
+  auto hot = oft.getHotIo(1, 1000);
+  ASSERT_LE(hot.size(), 16u);
+  ASSERT_EQ(hot[0].fid, 7u * 16);
+  ASSERT_GE(hot[0].bytesPerSec, 100000 * 1000 / 10.0);
+}
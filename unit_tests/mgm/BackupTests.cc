@@ -0,0 +1,84 @@
+//------------------------------------------------------------------------------
+// File: BackupTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/proc/admin/Backup.hh"
+#include <cstring>
+
+using eos::mgm::SyncTimePruner;
+using eos::mgm::TwindowFilter;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Container metadata with the given stime, optionally propagating mtimes
+//------------------------------------------------------------------------------
+eos::ns::ContainerMdProto MakeContainer(time_t stime_sec, bool propagation)
+{
+  eos::ns::ContainerMdProto proto;
+  eos::IContainerMD::tmtime_t stime;
+  memset(&stime, 0, sizeof(stime));
+  stime.tv_sec = stime_sec;
+  proto.set_stime(&stime, sizeof(stime));
+
+  if (propagation) {
+    (*proto.mutable_xattrs())["sys.mtime.propagation"] = "1";
+  }
+
+  return proto;
+}
+}
+
+TEST(SyncTimePruner, PrunesOnlyOldPropagatedSubtrees)
+{
+  SyncTimePruner pruner(10000);
+  eos::IContainerMD::XAttrMap attrs;
+  ASSERT_FALSE(pruner.shouldExpandContainer(MakeContainer(5000, true), attrs));
+  ASSERT_FALSE(pruner.shouldExpandContainer(MakeContainer(9999, true), attrs));
+  ASSERT_EQ(pruner.GetPruned(), 2u);
+  // Changed since the reference time
+  ASSERT_TRUE(pruner.shouldExpandContainer(MakeContainer(10000, true), attrs));
+  ASSERT_TRUE(pruner.shouldExpandContainer(MakeContainer(20000, true), attrs));
+  // The stime is not maintained without sys.mtime.propagation
+  ASSERT_TRUE(pruner.shouldExpandContainer(MakeContainer(5000, false), attrs));
+  // Never propagated or missing stime
+  ASSERT_TRUE(pruner.shouldExpandContainer(MakeContainer(0, true), attrs));
+  eos::ns::ContainerMdProto proto;
+  (*proto.mutable_xattrs())["sys.mtime.propagation"] = "1";
+  ASSERT_TRUE(pruner.shouldExpandContainer(proto, attrs));
+  ASSERT_EQ(pruner.GetPruned(), 2u);
+}
+
+TEST(SyncTimePruner, OnlyForMtimeWindows)
+{
+  ASSERT_EQ(TwindowFilter("", "").GetExpansionDecider(), nullptr);
+  ASSERT_EQ(TwindowFilter("ctime", "10000").GetExpansionDecider(), nullptr);
+  ASSERT_EQ(TwindowFilter("mtime", "").GetExpansionDecider(), nullptr);
+  ASSERT_EQ(TwindowFilter("mtime", "garbage").GetExpansionDecider(), nullptr);
+  TwindowFilter filter("mtime", "10000");
+  auto decider = filter.GetExpansionDecider();
+  ASSERT_NE(decider, nullptr);
+  ASSERT_EQ(filter.GetExpansionDecider(), decider);
+  eos::IContainerMD::XAttrMap attrs;
+  ASSERT_FALSE(decider->shouldExpandContainer(MakeContainer(100, true), attrs));
+  ASSERT_EQ(filter.GetPruned(), 1u);
+}
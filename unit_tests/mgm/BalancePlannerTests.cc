@@ -0,0 +1,158 @@
+//------------------------------------------------------------------------------
+//! @file BalancePlannerTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/BalancePlanner.hh"
+
+using eos::mgm::BalancePlanner;
+
+namespace
+{
+constexpr uint64_t kCapacity = 1000000;
+
+//------------------------------------------------------------------------------
+// Make a filesystem entry
+//------------------------------------------------------------------------------
+BalancePlanner::FsEntry
+MakeFs(eos::common::FileSystem::fsid_t id, const std::string& unit,
+       const std::string& node, uint64_t used)
+{
+  BalancePlanner::FsEntry entry;
+  entry.mId = id;
+  entry.mUnit = unit;
+  entry.mNode = node;
+  entry.mUsed = used;
+  entry.mCapacity = kCapacity;
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+// Sum the planned bytes leaving or reaching a unit
+//------------------------------------------------------------------------------
+int64_t
+GetBalance(const BalancePlanner::Plan& plan, const std::string& unit)
+{
+  int64_t balance = 0;
+
+  for (const auto& move : plan.mMoves) {
+    if (move.mSrcUnit == unit) {
+      balance -= move.mBytes;
+    }
+
+    if (move.mDstUnit == unit) {
+      balance += move.mBytes;
+    }
+  }
+
+  return balance;
+}
+}
+
+TEST(BalancePlanner, InsideTolerance)
+{
+  std::vector<BalancePlanner::FsEntry> fs {
+    MakeFs(1, "default.0", "n1", 610000),
+    MakeFs(2, "default.1", "n2", 590000)};
+  BalancePlanner::Plan plan = BalancePlanner::ComputePlan(fs, {}, 0.02);
+  ASSERT_NEAR(0.6, plan.mTarget, 1e-9);
+  ASSERT_NEAR(0.01, plan.mDeviation, 1e-9);
+  ASSERT_TRUE(plan.mMoves.empty());
+  ASSERT_EQ(0ull, plan.mBytes);
+  // A single unit is never balanced
+  fs.resize(1);
+  plan = BalancePlanner::ComputePlan(fs, {}, 0.02);
+  ASSERT_TRUE(plan.mMoves.empty());
+}
+
+TEST(BalancePlanner, MinimalBytes)
+{
+  std::vector<BalancePlanner::FsEntry> fs {
+    MakeFs(1, "default.0", "n1", 800000),
+    MakeFs(2, "default.1", "n2", 400000),
+    MakeFs(3, "default.2", "n3", 600000)};
+  BalancePlanner::Plan plan = BalancePlanner::ComputePlan(fs, {}, 0.02);
+  // Only down to the upper and up to the lower edge of the band
+  ASSERT_EQ(1u, plan.mMoves.size());
+  ASSERT_EQ("default.0", plan.mMoves[0].mSrcUnit);
+  ASSERT_EQ("n1", plan.mMoves[0].mSrcNode);
+  ASSERT_EQ("default.1", plan.mMoves[0].mDstUnit);
+  ASSERT_NEAR(180000, plan.mBytes, 2);
+  ASSERT_EQ(0, GetBalance(plan, "default.2"));
+  ASSERT_EQ(0ull, plan.mDeferred);
+}
+
+TEST(BalancePlanner, AddedCapacity)
+{
+  // A new empty group lowers the target, the full groups only shed their
+  // excess and don't oscillate around an average of the ratios
+  std::vector<BalancePlanner::FsEntry> fs {
+    MakeFs(1, "default.0", "n1", 600000),
+    MakeFs(2, "default.1", "n2", 600000),
+    MakeFs(3, "default.2", "n3", 0)};
+  BalancePlanner::Plan plan = BalancePlanner::ComputePlan(fs, {}, 0.02);
+  ASSERT_NEAR(0.4, plan.mTarget, 1e-9);
+  ASSERT_NEAR(380000, GetBalance(plan, "default.2"), 4);
+  ASSERT_NEAR(-380000, GetBalance(plan, "default.0") +
+              GetBalance(plan, "default.1"), 4);
+  ASSERT_LE(GetBalance(plan, "default.0"), -179998);
+  ASSERT_LE(GetBalance(plan, "default.1"), -179998);
+  ASSERT_NEAR(380000, plan.mBytes, 4);
+
+  // After the plan is done every group is inside the band
+  for (auto& entry : fs) {
+    entry.mUsed += GetBalance(plan, entry.mUnit);
+  }
+
+  plan = BalancePlanner::ComputePlan(fs, {}, 0.02);
+  ASSERT_TRUE(plan.mMoves.empty());
+}
+
+TEST(BalancePlanner, NodeBudgets)
+{
+  std::vector<BalancePlanner::FsEntry> fs {
+    MakeFs(1, "default.0", "n1", 800000),
+    MakeFs(2, "default.0", "n2", 800000),
+    MakeFs(3, "default.1", "n1", 400000),
+    MakeFs(4, "default.1", "n3", 400000)};
+  std::map<std::string, uint64_t> budgets {{"n1", 50000}, {"n2", 100000},
+    {"n3", 70000}};
+  BalancePlanner::Plan plan = BalancePlanner::ComputePlan(fs, budgets, 0.02);
+  std::map<std::string, uint64_t> sent;
+
+  for (const auto& move : plan.mMoves) {
+    ASSERT_EQ("default.0", move.mSrcUnit);
+    ASSERT_EQ("default.1", move.mDstUnit);
+    sent[move.mSrcNode] += move.mBytes;
+  }
+
+  // The receiving nodes take 120000 bytes, n1 also sends 50000 bytes
+  ASSERT_EQ(120000ull, plan.mBytes);
+  ASSERT_LE(sent["n1"], 50000ull);
+  ASSERT_LE(sent["n2"], 100000ull);
+  ASSERT_NEAR(360000 - 120000, plan.mDeferred, 2);
+  // Nodes without budget take no part
+  budgets["n1"] = 0;
+  budgets["n3"] = 0;
+  plan = BalancePlanner::ComputePlan(fs, budgets, 0.02);
+  ASSERT_TRUE(plan.mMoves.empty());
+  ASSERT_NEAR(360000, plan.mDeferred, 2);
+}
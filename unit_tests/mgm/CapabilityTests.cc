@@ -0,0 +1,85 @@
+//------------------------------------------------------------------------------
+// File: CapabilityTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "authz/XrdCapability.hh"
+#include "XrdOuc/XrdOucEnv.hh"
+#include <memory>
+#include <string>
+
+//------------------------------------------------------------------------------
+// Round trip of the env and binary capability formats
+//------------------------------------------------------------------------------
+TEST(Capability, CreateExtract)
+{
+  char binkey[SHA_DIGEST_LENGTH];
+
+  for (int i = 0; i < SHA_DIGEST_LENGTH; ++i) {
+    binkey[i] = (char)(0x30 + i);
+  }
+
+  eos::common::SymKey* key = eos::common::gSymKeyStore.SetKey(binkey, 0);
+  ASSERT_TRUE(key != nullptr);
+  XrdOucEnv in("mgm.access=read&mgm.fid=0000abcd&mgm.path=/eos/dir/file");
+
+  for (bool binary : {
+         false, true
+       }) {
+    XrdCapability::SetBinaryFormat(binary);
+    XrdOucEnv* cap = nullptr;
+    XrdOucEnv* out = nullptr;
+    ASSERT_EQ(0, XrdCapability::Create(&in, cap, key, 3600));
+    std::unique_ptr<XrdOucEnv> cap_ptr(cap);
+    std::string msg = cap->Get("cap.msg");
+    ASSERT_EQ(binary, msg.find(XrdCapability::sBinaryPrefix) == 0);
+    ASSERT_EQ(0, XrdCapability::Extract(cap, out));
+    std::unique_ptr<XrdOucEnv> out_ptr(out);
+    ASSERT_STREQ("read", out->Get("mgm.access"));
+    ASSERT_STREQ("0000abcd", out->Get("mgm.fid"));
+    ASSERT_STREQ("/eos/dir/file", out->Get("mgm.path"));
+    ASSERT_TRUE(out->Get("cap.valid") != nullptr);
+  }
+
+  // A modified binary capability is rejected
+  XrdOucEnv* cap = nullptr;
+  XrdOucEnv* out = nullptr;
+  ASSERT_EQ(0, XrdCapability::Create(&in, cap, key, 3600));
+  std::unique_ptr<XrdOucEnv> cap_ptr(cap);
+  std::string msg = cap->Get("cap.msg");
+  msg[msg.length() - 6] = (msg[msg.length() - 6] == 'A') ? 'B' : 'A';
+  std::string tampered = "cap.sym=";
+  tampered += key->GetDigest64();
+  tampered += "&cap.msg=";
+  tampered += msg;
+  XrdOucEnv bad(tampered.c_str());
+  ASSERT_EQ(EKEYREJECTED, XrdCapability::Extract(&bad, out));
+  delete out;
+  out = nullptr;
+  std::string truncated = "cap.sym=";
+  truncated += key->GetDigest64();
+  truncated += "&cap.msg=";
+  truncated += XrdCapability::sBinaryPrefix;
+  truncated += "RU9TQw==";
+  XrdOucEnv trunc(truncated.c_str());
+  ASSERT_EQ(EINVAL, XrdCapability::Extract(&trunc, out));
+  XrdCapability::SetBinaryFormat(false);
+}
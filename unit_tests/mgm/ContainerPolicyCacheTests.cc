@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------------
+// File: ContainerPolicyCacheTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/ContainerPolicyCache.hh"
+#include "common/LayoutId.hh"
+#include <thread>
+
+using eos::mgm::ContainerPolicyCache;
+using eos::mgm::Policy;
+
+//------------------------------------------------------------------------------
+// Cached items per container version, expiry and eviction
+//------------------------------------------------------------------------------
+TEST(ContainerPolicyCache, GetPut)
+{
+  ContainerPolicyCache cache(std::chrono::milliseconds(60000), 16);
+  ContainerPolicyCache::Version v1 {{1, 2, 0, 0}};
+  ContainerPolicyCache::Version v2 {{1, 3, 0, 0}};
+  auto item = std::make_shared<ContainerPolicyCache::Item>();
+  item->mAttrs["sys.forced.space"] = "ssd";
+  ASSERT_TRUE(cache.IsEnabled());
+  ASSERT_EQ(nullptr, cache.Get(10, v1));
+  cache.Put(10, v1, item);
+  auto cached = cache.Get(10, v1);
+  ASSERT_NE(nullptr, cached);
+  ASSERT_EQ("ssd", cached->mAttrs.at("sys.forced.space"));
+  ASSERT_EQ(nullptr, cache.Get(11, v1));
+  // An attribute change drops the entry
+  ASSERT_EQ(nullptr, cache.Get(10, v2));
+  ASSERT_EQ(nullptr, cache.Get(10, v1));
+  ASSERT_EQ(0u, cache.Size());
+  ASSERT_EQ(1u, cache.GetHits());
+  ASSERT_EQ(4u, cache.GetMisses());
+  // One entry per shard
+  cache.Put(16, v1, item);
+  cache.Put(32, v1, item);
+  ASSERT_EQ(nullptr, cache.Get(16, v1));
+  ASSERT_NE(nullptr, cache.Get(32, v1));
+  {
+    ContainerPolicyCache expiring(std::chrono::milliseconds(20), 100);
+    expiring.Put(10, v1, item);
+    ASSERT_NE(nullptr, expiring.Get(10, v1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    ASSERT_EQ(nullptr, expiring.Get(10, v1));
+  }
+  {
+    ContainerPolicyCache disabled(std::chrono::milliseconds(0), 100);
+    ASSERT_FALSE(disabled.IsEnabled());
+    disabled.Put(10, v1, item);
+    ASSERT_EQ(nullptr, disabled.Get(10, v1));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Precedence of the sys and user settings of a directory
+//------------------------------------------------------------------------------
+TEST(ContainerPolicyCache, DirPolicy)
+{
+  using eos::common::LayoutId;
+  eos::IContainerMD::XAttrMap attrs;
+  Policy::DirPolicy policy;
+  Policy::GetDirPolicy(attrs, policy);
+  ASSERT_FALSE(policy.mSpace.mSet);
+  ASSERT_FALSE(policy.mLayout.mSet);
+  ASSERT_FALSE(policy.mPlacement.mSet);
+  ASSERT_FALSE(policy.mNoFsSelection);
+  attrs["sys.forced.space"] = "default";
+  attrs["sys.forced.group"] = "3";
+  attrs["sys.forced.layout"] = "replica";
+  attrs["sys.forced.nstripes"] = "2";
+  attrs["user.forced.space"] = "ssd";
+  attrs["user.forced.nstripes"] = "3";
+  attrs["user.forced.placementpolicy"] = "gathered:site1";
+  Policy::GetDirPolicy(attrs, policy);
+  ASSERT_EQ("ssd", policy.mSpace.mValue);
+  ASSERT_EQ(3, policy.mGroup.mValue);
+  ASSERT_EQ((unsigned long) LayoutId::kReplica, policy.mLayout.mValue);
+  ASSERT_EQ(3u, policy.mStripes.mValue);
+  ASSERT_EQ("gathered:site1", policy.mPlacement.mValue);
+  // The directory can forbid the user settings
+  attrs["sys.forced.nouserlayout"] = "1";
+  attrs["user.forced.nouserplacementpolicy"] = "1";
+  Policy::GetDirPolicy(attrs, policy);
+  ASSERT_EQ("default", policy.mSpace.mValue);
+  ASSERT_EQ(2u, policy.mStripes.mValue);
+  ASSERT_FALSE(policy.mPlacement.mSet);
+  // The hot space of a tiering policy and the sys placement always win
+  attrs["sys.tier.hot"] = "hot";
+  attrs["sys.forced.placementpolicy"] = "hybrid:site2";
+  attrs["user.forced.nofsselection"] = "1";
+  Policy::GetDirPolicy(attrs, policy);
+  ASSERT_EQ("hot", policy.mSpace.mValue);
+  ASSERT_EQ("hybrid:site2", policy.mPlacement.mValue);
+  ASSERT_TRUE(policy.mNoFsSelection);
+}
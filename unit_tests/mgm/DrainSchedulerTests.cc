@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+// File: DrainSchedulerTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/drain/DrainScheduler.hh"
+
+using eos::mgm::DrainScheduler;
+using std::chrono::milliseconds;
+
+static constexpr uint64_t kMB = 1024 * 1024;
+
+//------------------------------------------------------------------------------
+// Jobs are admitted at the rate of the node, the bucket may go into debt
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, TokenBucket)
+{
+  DrainScheduler sched;
+  sched.Register("node1", 1);
+  // 100 MB/s, the bucket starts with a burst of two seconds
+  sched.SetNodeRate("node1", 100.0 * kMB);
+  auto now = std::chrono::steady_clock::now();
+  std::vector<std::unique_ptr<DrainScheduler::Ticket>> tickets;
+
+  while (true) {
+    auto ticket = sched.Admit("node1", 1, now);
+
+    if (!ticket) {
+      break;
+    }
+
+    ticket->Start(10, 64 * kMB);
+    tickets.push_back(std::move(ticket));
+    ASSERT_LT(tickets.size(), 10u);
+  }
+
+  ASSERT_EQ(4u, tickets.size());
+  ASSERT_EQ(256 * kMB, sched.GetNodeInflight("node1"));
+  ASSERT_EQ(256 * kMB, sched.GetFsInflight(10));
+  // A large file puts the bucket into debt which is paid back over time
+  tickets[0]->Start(10, 1024 * kMB);
+  ASSERT_FALSE(sched.Admit("node1", 1, now + milliseconds(1000)));
+  ASSERT_FALSE(sched.Admit("node1", 1, now + milliseconds(10000)));
+  ASSERT_TRUE(sched.Admit("node1", 1, now + milliseconds(10200)) != nullptr);
+  tickets.clear();
+  ASSERT_EQ(0u, sched.GetNodeInflight("node1"));
+  ASSERT_EQ(0u, sched.GetFsInflight(10));
+}
+
+//------------------------------------------------------------------------------
+// Nodes without bandwidth information are not rate limited
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, NoRate)
+{
+  DrainScheduler sched;
+  sched.Register("node1", 1);
+  auto now = std::chrono::steady_clock::now();
+  std::vector<std::unique_ptr<DrainScheduler::Ticket>> tickets;
+
+  for (int i = 0; i < 100; ++i) {
+    auto ticket = sched.Admit("node1", 1, now);
+    ASSERT_TRUE(ticket != nullptr);
+    tickets.push_back(std::move(ticket));
+  }
+
+  sched.Unregister("node1", 1);
+  tickets.clear();
+  ASSERT_EQ(0u, sched.GetNodeInflight("node1"));
+}
+
+//------------------------------------------------------------------------------
+// Concurrent drains of a node are interleaved
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, Fairness)
+{
+  DrainScheduler sched;
+  sched.Register("node1", 1);
+  sched.Register("node1", 2);
+  auto now = std::chrono::steady_clock::now();
+  std::vector<std::unique_ptr<DrainScheduler::Ticket>> tickets;
+  // The first drain is always the first to ask
+  auto ticket = sched.Admit("node1", 1, now);
+  ASSERT_TRUE(ticket != nullptr);
+  tickets.push_back(std::move(ticket));
+
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_FALSE(sched.Admit("node1", 1, now));
+    ticket = sched.Admit("node1", 2, now);
+    ASSERT_TRUE(ticket != nullptr);
+    tickets.push_back(std::move(ticket));
+    ticket = sched.Admit("node1", 1, now);
+    ASSERT_TRUE(ticket != nullptr);
+    tickets.push_back(std::move(ticket));
+  }
+
+  // The second drain catches up with the first one
+  ASSERT_FALSE(sched.Admit("node1", 1, now));
+  ticket = sched.Admit("node1", 2, now);
+  ASSERT_TRUE(ticket != nullptr);
+  ASSERT_EQ(sched.GetDrainInflight("node1", 1),
+            sched.GetDrainInflight("node1", 2));
+  // Drains of other nodes are independent
+  sched.Register("node2", 3);
+  ASSERT_TRUE(sched.Admit("node2", 3, now) != nullptr);
+}
+
+//------------------------------------------------------------------------------
+// Destination file systems above the in-flight limit are reported
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, SaturatedFs)
+{
+  DrainScheduler sched;
+  sched.SetFsInflightLimit(100 * kMB);
+  sched.Register("node1", 1);
+  auto now = std::chrono::steady_clock::now();
+  auto ticket1 = sched.Admit("node1", 1, now);
+  auto ticket2 = sched.Admit("node1", 1, now);
+  ticket1->Start(10, 60 * kMB);
+  ticket2->Start(20, 60 * kMB);
+  std::vector<DrainScheduler::fsid_t> fsids;
+  sched.GetSaturatedFs(fsids);
+  ASSERT_TRUE(fsids.empty());
+  auto ticket3 = sched.Admit("node1", 1, now);
+  ticket3->Start(10, 60 * kMB);
+  sched.GetSaturatedFs(fsids);
+  ASSERT_EQ(1u, fsids.size());
+  ASSERT_EQ(10u, fsids[0]);
+  ticket1.reset();
+  fsids.clear();
+  sched.GetSaturatedFs(fsids);
+  ASSERT_TRUE(fsids.empty());
+  ASSERT_EQ(60 * kMB, sched.GetFsInflight(10));
+}
@@ -152,3 +152,64 @@ TEST(Egroup, ExplicitRefresh) {
     "egroup=awesome-users user=user1 member=true lifetime=1800");
 }
 
+
+TEST(Egroup, RefreshGroup) {
+  SteadyClock clock(true);
+  Egroup egroup(&clock);
+
+  egroup.inject("user1", "awesome-users", Egroup::Status::kNotMember);
+  egroup.inject("user2", "awesome-users", Egroup::Status::kMember);
+
+  ASSERT_EQ(egroup.DumpMember("user1", "awesome-users"),
+    "egroup=awesome-users user=user1 member=false lifetime=1800");
+
+  ASSERT_EQ(egroup.DumpMember("user2", "awesome-users"),
+    "egroup=awesome-users user=user2 member=true lifetime=1800");
+
+  ASSERT_EQ(egroup.DumpMember("user3", "awesome-users"),
+    "egroup=awesome-users user=user3 member=false lifetime=1800");
+
+  egroup.inject("user1", "awesome-users", Egroup::Status::kMember);
+  egroup.inject("user2", "awesome-users", Egroup::Status::kNotMember);
+
+  clock.advance(std::chrono::seconds(10));
+
+  // One lookup of the members for all the given users
+  egroup.refreshGroup("awesome-users", {"user1", "user2"});
+
+  ASSERT_EQ(egroup.DumpMembers(),
+    "egroup=awesome-users user=user1 member=true lifetime=1800\n"
+    "egroup=awesome-users user=user2 member=false lifetime=1800\n"
+    "egroup=awesome-users user=user3 member=false lifetime=1790\n");
+}
+
+TEST(Egroup, RefreshAhead) {
+  SteadyClock clock(true);
+  Egroup egroup(&clock);
+
+  egroup.inject("user1", "awesome-users", Egroup::Status::kMember);
+
+  ASSERT_EQ(egroup.DumpMember("user1", "awesome-users"),
+    "egroup=awesome-users user=user1 member=true lifetime=1800");
+
+  egroup.inject("user1", "awesome-users", Egroup::Status::kNotMember);
+
+  // Rarely accessed entries are not refreshed before they expire
+  clock.advance(std::chrono::seconds(1700));
+
+  ASSERT_EQ(egroup.DumpMember("user1", "awesome-users"),
+    "egroup=awesome-users user=user1 member=true lifetime=100");
+
+  ASSERT_EQ(egroup.getPendingQueueSize(), 0u);
+
+  // Frequently accessed entries are refreshed ahead, serving the current value
+  // meanwhile
+  for (int i = 0; i < 9; ++i) {
+    ASSERT_TRUE(egroup.Member("user1", "awesome-users"));
+  }
+
+  while(egroup.getPendingQueueSize() != 0) { }
+
+  ASSERT_EQ(egroup.DumpMember("user1", "awesome-users"),
+    "egroup=awesome-users user=user1 member=false lifetime=1800");
+}
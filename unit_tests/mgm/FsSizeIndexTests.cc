@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------
+// File: FsSizeIndexTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/FsSizeIndex.hh"
+
+using eos::mgm::FsSizeIndex;
+
+TEST(FsSizeIndex, Buckets)
+{
+  ASSERT_EQ(0, FsSizeIndex::GetBucket(0));
+  ASSERT_EQ(1, FsSizeIndex::GetBucket(1));
+  ASSERT_EQ(2, FsSizeIndex::GetBucket(2));
+  ASSERT_EQ(2, FsSizeIndex::GetBucket(3));
+  ASSERT_EQ(11, FsSizeIndex::GetBucket(1024));
+  ASSERT_EQ(64, FsSizeIndex::GetBucket(UINT64_MAX));
+}
+
+TEST(FsSizeIndex, PickBiggest)
+{
+  FsSizeIndex index;
+  uint64_t fid = 0;
+  uint64_t size = 0;
+  auto no_skip = [](uint64_t) {
+    return false;
+  };
+  ASSERT_FALSE(index.Pick(1, 0, 0, no_skip, fid, size));
+  index.Add(1, 10, 100);
+  index.Add(1, 11, 5000);
+  index.Add(1, 12, 1000000);
+  index.Add(2, 20, 2000000);
+  ASSERT_EQ(3u, index.GetNumSamples(1));
+  ASSERT_TRUE(index.Pick(1, 0, 0, no_skip, fid, size));
+  ASSERT_EQ(12u, fid);
+  ASSERT_EQ(1000000u, size);
+  // Bounded by the max size
+  ASSERT_TRUE(index.Pick(1, 0, 10000, no_skip, fid, size));
+  ASSERT_EQ(11u, fid);
+  // Nothing in the range
+  ASSERT_FALSE(index.Pick(1, 6000, 10000, no_skip, fid, size));
+  ASSERT_FALSE(index.Pick(1, 2000, 1000, no_skip, fid, size));
+  // Scheduled files are skipped
+  auto skip_12 = [](uint64_t fid) {
+    return (fid == 12);
+  };
+  ASSERT_TRUE(index.Pick(1, 0, 0, skip_12, fid, size));
+  ASSERT_EQ(11u, fid);
+  // An update moves the file to its new bucket
+  index.Add(1, 10, 5000000);
+  ASSERT_EQ(3u, index.GetNumSamples(1));
+  ASSERT_TRUE(index.Pick(1, 0, 0, no_skip, fid, size));
+  ASSERT_EQ(10u, fid);
+  ASSERT_EQ(5000000u, size);
+  index.Remove(1, 10);
+  index.Remove(1, 99);
+  ASSERT_EQ(2u, index.GetNumSamples(1));
+  ASSERT_TRUE(index.Pick(1, 0, 0, no_skip, fid, size));
+  ASSERT_EQ(12u, fid);
+}
+
+TEST(FsSizeIndex, BucketLimit)
+{
+  FsSizeIndex index;
+  uint64_t fid = 0;
+  uint64_t size = 0;
+
+  for (uint64_t i = 0; i < FsSizeIndex::kMaxPerBucket + 10; ++i) {
+    index.Add(1, i, 4096);
+  }
+
+  ASSERT_EQ(FsSizeIndex::kMaxPerBucket, index.GetNumSamples(1));
+  // The oldest samples were replaced
+  auto skip_new = [](uint64_t fid) {
+    return (fid >= 10);
+  };
+  ASSERT_FALSE(index.Pick(1, 0, 0, skip_new, fid, size));
+  auto skip_old = [](uint64_t fid) {
+    return (fid < 10);
+  };
+  ASSERT_TRUE(index.Pick(1, 0, 0, skip_old, fid, size));
+  ASSERT_EQ(4096u, size);
+}
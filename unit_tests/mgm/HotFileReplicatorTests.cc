@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+// File: HotFileReplicatorTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/HotFileReplicator.hh"
+
+using eos::mgm::HotFileReplicator;
+
+TEST(HotFileReplicator, Parse)
+{
+  std::map<uint64_t, HotFileReplicator::Heat> heat;
+  HotFileReplicator::ParseHotIo("2000:10:0000000a 500:1:0000000b bogus", heat);
+  HotFileReplicator::ParseHotIo("1000:4:0000000a", heat);
+  HotFileReplicator::ParseHotFiles("7:0000000a 3:0000000c ", heat);
+  HotFileReplicator::ParseHotFiles("2:0000000a", heat);
+  ASSERT_EQ(3u, heat.size());
+  ASSERT_DOUBLE_EQ(2000, heat[10].mMaxRate);
+  ASSERT_DOUBLE_EQ(3000, heat[10].mTotalRate);
+  ASSERT_EQ(7u, heat[10].mMaxOpens);
+  ASSERT_EQ(9u, heat[10].mTotalOpens);
+  ASSERT_DOUBLE_EQ(500, heat[11].mMaxRate);
+  ASSERT_EQ(3u, heat[12].mMaxOpens);
+}
+
+TEST(HotFileReplicator, Plan)
+{
+  HotFileReplicator replicator;
+  HotFileReplicator::Settings settings;
+  settings.mEnabled = true;
+  settings.mRate = 1000;
+  settings.mMaxExtra = 2;
+  settings.mCooldown = 600;
+  std::map<uint64_t, HotFileReplicator::Heat> heat;
+  heat[1].mMaxRate = heat[1].mTotalRate = 2000;
+  heat[2].mMaxRate = heat[2].mTotalRate = 100;
+  std::set<uint64_t> grow, shrink;
+  replicator.Plan(heat, settings, 1000, grow, shrink);
+  ASSERT_EQ(std::set<uint64_t> {1}, grow);
+  ASSERT_TRUE(shrink.empty());
+  // One replica more, the next one only after the settle time
+  replicator.SetPromoted(1, 1, 2, 1000);
+  grow.clear();
+  replicator.Plan(heat, settings, 1060, grow, shrink);
+  ASSERT_TRUE(grow.empty());
+  replicator.Plan(heat, settings, 1200, grow, shrink);
+  ASSERT_EQ(std::set<uint64_t> {1}, grow);
+  // Never more than the maximum of extra replicas
+  replicator.SetPromoted(1, 1, 3, 1200);
+  grow.clear();
+  replicator.Plan(heat, settings, 2000, grow, shrink);
+  ASSERT_TRUE(grow.empty());
+  ASSERT_TRUE(shrink.empty());
+  // Load spread over the replicas keeps the file promoted
+  heat[1].mMaxRate = 700;
+  heat[1].mTotalRate = 2100;
+  replicator.Plan(heat, settings, 2500, grow, shrink);
+  ASSERT_TRUE(grow.empty());
+  ASSERT_TRUE(shrink.empty());
+  // Cooled down
+  heat.erase(1);
+  replicator.Plan(heat, settings, 3000, grow, shrink);
+  ASSERT_TRUE(shrink.empty());
+  replicator.Plan(heat, settings, 3100, grow, shrink);
+  ASSERT_EQ(std::set<uint64_t> {1}, shrink);
+  replicator.Forget(1);
+  ASSERT_TRUE(replicator.GetPromoted().empty());
+}
+
+TEST(HotFileReplicator, PlanDisabled)
+{
+  HotFileReplicator replicator;
+  HotFileReplicator::Settings settings;
+  std::map<uint64_t, HotFileReplicator::Heat> heat;
+  heat[1].mMaxOpens = heat[1].mTotalOpens = 100;
+  replicator.SetPromoted(2, 2, 3, 1000);
+  std::set<uint64_t> grow, shrink;
+  // Disabling the replicator removes all the extra replicas
+  replicator.Plan(heat, settings, 1000, grow, shrink);
+  ASSERT_TRUE(grow.empty());
+  ASSERT_EQ(std::set<uint64_t> {2}, shrink);
+  settings.mEnabled = true;
+  settings.mOpens = 50;
+  shrink.clear();
+  replicator.Plan(heat, settings, 1000, grow, shrink);
+  ASSERT_EQ(std::set<uint64_t> {1}, grow);
+  ASSERT_TRUE(shrink.empty());
+}
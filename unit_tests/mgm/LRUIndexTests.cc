@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------
+// File: LRUIndexTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/LRUIndex.hh"
+
+using eos::mgm::LRUIndex;
+
+TEST(LRUIndex, OldestAndUpdates)
+{
+  LRUIndex index(true);
+  ASSERT_TRUE(index.Track(10));
+  ASSERT_FALSE(index.Track(10));
+  uint64_t gen = index.GetGeneration(10);
+  ASSERT_TRUE(index.AddContainer(11, 10));
+  ASSERT_FALSE(index.AddContainer(11, 10));
+  // Not indexed parent
+  ASSERT_FALSE(index.AddContainer(21, 20));
+  index.Upsert(1, 10, 300, 100);
+  index.Upsert(2, 11, 100, 100);
+  index.Upsert(3, 11, 200, 100);
+  index.Upsert(4, 20, 50, 100);
+  std::vector<LRUIndex::Entry> entries;
+  // Not filled yet
+  ASSERT_FALSE(index.GetOldest(10, 1, entries));
+  index.SetReady(10, gen);
+  ASSERT_TRUE(index.IsReady(10));
+  ASSERT_EQ(3u, index.GetNumFiles());
+  ASSERT_TRUE(index.GetOldest(10, 150, entries));
+  ASSERT_EQ(2u, entries.size());
+  ASSERT_EQ(2u, entries[0].mFid);
+  ASSERT_EQ(3u, entries[1].mFid);
+  // A new ctime moves the file to the end
+  index.Upsert(2, 11, 400, 100);
+  entries.clear();
+  ASSERT_TRUE(index.GetOlderThan(10, 350, entries));
+  ASSERT_EQ(2u, entries.size());
+  ASSERT_EQ(3u, entries[0].mFid);
+  ASSERT_EQ(1u, entries[1].mFid);
+  // Moved out of the tree
+  index.Upsert(3, 20, 200, 100);
+  index.Remove(1);
+  entries.clear();
+  ASSERT_TRUE(index.GetOldest(10, 1000, entries));
+  ASSERT_EQ(1u, entries.size());
+  ASSERT_EQ(2u, entries[0].mFid);
+  index.Retain({});
+  ASSERT_FALSE(index.IsReady(10));
+  ASSERT_EQ(0u, index.GetNumFiles());
+}
+
+TEST(LRUIndex, NestedTrees)
+{
+  LRUIndex index(true);
+  ASSERT_TRUE(index.Track(10));
+  ASSERT_TRUE(index.AddContainer(11, 10));
+  index.Upsert(1, 11, 100, 100);
+  index.SetReady(10, index.GetGeneration(10));
+  // Indexing a sub tree invalidates the outer tree
+  uint64_t gen = index.GetGeneration(10);
+  ASSERT_TRUE(index.Track(11));
+  ASSERT_FALSE(index.IsReady(10));
+  ASSERT_NE(gen, index.GetGeneration(10));
+  // A fill started before the invalidation doesn't make the tree ready
+  index.SetReady(10, gen);
+  ASSERT_FALSE(index.IsReady(10));
+  // The walk of the outer tree stops at the nested one
+  ASSERT_FALSE(index.AddContainer(11, 10));
+  index.SetReady(10, index.GetGeneration(10));
+  index.Upsert(1, 11, 100, 100);
+  index.SetReady(11, index.GetGeneration(11));
+  std::vector<LRUIndex::Entry> entries;
+  ASSERT_TRUE(index.GetOldest(10, 1000, entries));
+  ASSERT_TRUE(entries.empty());
+  ASSERT_TRUE(index.GetOldest(11, 1000, entries));
+  ASSERT_EQ(1u, entries.size());
+  // Dropping the nested tree hands its subtree back to the outer one
+  index.Retain({10});
+  ASSERT_FALSE(index.IsReady(10));
+  ASSERT_EQ(0u, index.GetNumFiles());
+}
+
+TEST(LRUIndex, FlatIndex)
+{
+  LRUIndex index(false);
+  ASSERT_TRUE(index.Track(10));
+  ASSERT_FALSE(index.AddContainer(11, 10));
+  index.Upsert(1, 10, 100, 1);
+  index.Upsert(2, 11, 50, 1);
+  index.SetReady(10, index.GetGeneration(10));
+  std::vector<LRUIndex::Entry> entries;
+  ASSERT_TRUE(index.GetOlderThan(10, 1000, entries));
+  ASSERT_EQ(1u, entries.size());
+  ASSERT_EQ(1u, entries[0].mFid);
+  index.Clear();
+  ASSERT_FALSE(index.IsReady(10));
+}
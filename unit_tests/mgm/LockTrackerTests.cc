@@ -361,3 +361,85 @@ TEST(LockTracker, various) {
   lock.l_type = F_WRLCK;
   ASSERT_TRUE(tracker.setlk(4, &lock, 0, "owner"));
 }
+
+TEST(LockSet, rangeLookup) {
+  LockSet set;
+
+  // many disjoint locks of different pids and a whole file lock
+  for (int i = 0; i < 1000; i++) {
+    set.add(Lock(ByteRange(i * 10, 5), i, "owner"));
+  }
+
+  set.add(Lock(ByteRange(20000, -1), 1000, "other"));
+  ASSERT_EQ(set.nlocks(), 1001u);
+
+  ASSERT_TRUE(set.conflict(Lock(ByteRange(5003, 1), 1)));
+  ASSERT_FALSE(set.conflict(Lock(ByteRange(5003, 1), 500)));
+  ASSERT_FALSE(set.overlap(ByteRange(5005, 5)));
+  ASSERT_TRUE(set.overlap(ByteRange(1 << 30, 1)));
+
+  // a long lock starting early is found by a lookup far to its right
+  set.add(Lock(ByteRange(7, 15000), 2000, "other"));
+  Lock probe(ByteRange(14006, 2), 3000);
+  ASSERT_TRUE(set.getconflict(probe));
+  ASSERT_EQ(probe.pid(), 2000);
+
+  // partial unlocks keep the owner of the remainders
+  ASSERT_TRUE(set.remove(Lock(ByteRange(100, 1000), 2000)));
+  ASSERT_FALSE(set.remove(Lock(ByteRange(100, 1000), 2000)));
+  ASSERT_EQ(set.nlocks(2000), 2u);
+  std::vector<ByteRange> removed;
+  set.remove(std::string("other"), &removed);
+  ASSERT_EQ(removed.size(), 3u);
+  ASSERT_EQ(set.nlocks(), 1000u);
+  ASSERT_FALSE(set.overlap(ByteRange(14006, 2)));
+}
+
+TEST(LockTracker, waiters) {
+  LockTracker tracker;
+  std::set<std::string> wakeup;
+  struct flock lock;
+  lock.l_start = 0;
+  lock.l_len = -1;
+  lock.l_type = F_WRLCK;
+
+  ASSERT_TRUE(tracker.setlk(1, &lock, 1, "client1", &wakeup));
+
+  // getlk reports the blocking lock
+  struct flock probe = lock;
+  probe.l_type = F_RDLCK;
+  tracker.getlk(2, &probe);
+  ASSERT_EQ(probe.l_type, F_WRLCK);
+  ASSERT_EQ(probe.l_pid, 1);
+
+  // blocking requests wait, non-blocking ones don't
+  lock.l_start = 10;
+  lock.l_len = 10;
+  ASSERT_FALSE(tracker.setlk(2, &lock, 1, "client2", &wakeup));
+  ASSERT_FALSE(tracker.setlk(2, &lock, 1, "client2", &wakeup));
+  ASSERT_FALSE(tracker.setlk(3, &lock, 0, "client3", &wakeup));
+  lock.l_start = 100;
+  ASSERT_FALSE(tracker.setlk(4, &lock, 1, "client4", &wakeup));
+  ASSERT_EQ(tracker.nwaiters(), 2u);
+
+  // unlocking a range only wakes up the waiters on it
+  lock.l_start = 0;
+  lock.l_len = 50;
+  lock.l_type = F_UNLCK;
+  ASSERT_TRUE(tracker.setlk(1, &lock, 0, "client1", &wakeup));
+  ASSERT_EQ(wakeup, std::set<std::string>({"client2"}));
+  ASSERT_EQ(tracker.nwaiters(), 1u);
+
+  // the retry succeeds
+  lock.l_start = 10;
+  lock.l_len = 10;
+  lock.l_type = F_WRLCK;
+  ASSERT_TRUE(tracker.setlk(2, &lock, 1, "client2", &wakeup));
+
+  // the owner going away wakes up the others
+  wakeup.clear();
+  tracker.removelk("client1", &wakeup);
+  ASSERT_EQ(wakeup, std::set<std::string>({"client4"}));
+  ASSERT_EQ(tracker.nwaiters(), 0u);
+  ASSERT_TRUE(tracker.inuse());
+}
@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+// File: NsChangeStreamTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/NsChangeStream.hh"
+
+using eos::mgm::NsChangeStream;
+
+TEST(NsChangeStream, EncodeDecode)
+{
+  NsChangeStream::Record rec;
+  rec.mSeq = 42;
+  rec.mId = 1234;
+  rec.mParent = 7;
+  rec.mMtimeSec = 1570000000;
+  rec.mMtimeNsec = 999;
+  rec.mNameLen = 8;
+  rec.mVersion = NsChangeStream::sVersion;
+  rec.mType = 'f';
+  rec.mOp = 'c';
+  std::string data;
+  NsChangeStream::Encode(rec, "file.txt", data);
+  ASSERT_EQ(sizeof(NsChangeStream::Record) + 8, data.length());
+  NsChangeStream::Record out;
+  std::string name;
+  ASSERT_TRUE(NsChangeStream::Decode(data, out, name));
+  ASSERT_EQ(42u, out.mSeq);
+  ASSERT_EQ(1234u, out.mId);
+  ASSERT_EQ(7u, out.mParent);
+  ASSERT_EQ(1570000000, out.mMtimeSec);
+  ASSERT_EQ(999u, out.mMtimeNsec);
+  ASSERT_EQ('f', out.mType);
+  ASSERT_EQ('c', out.mOp);
+  ASSERT_EQ("file.txt", name);
+  ASSERT_FALSE(NsChangeStream::Decode(data.substr(0, data.length() - 1), out,
+                                      name));
+}
+
+TEST(NsChangeStream, RetainAndReplay)
+{
+  NsChangeStream stream("", "", 5, nullptr);
+  std::vector<std::string> records;
+  uint64_t first = stream.GetStats().mLastSeq + 1;
+  // Nothing published yet, so nothing is missed either
+  ASSERT_TRUE(stream.Replay(first, 10, records));
+  ASSERT_TRUE(records.empty());
+
+  for (int i = 0; i < 8; ++i) {
+    stream.Push('f', 'u', 100 + i, 1, 0, 0, "f" + std::to_string(i));
+  }
+
+  stream.Process();
+  NsChangeStream::Stats stats = stream.GetStats();
+  ASSERT_EQ(first + 7, stats.mLastSeq);
+  ASSERT_EQ(8u, stats.mPublished);
+  ASSERT_EQ(5u, stats.mRetained);
+  // The first three records are not retained anymore
+  ASSERT_FALSE(stream.Replay(first, 10, records));
+  ASSERT_TRUE(stream.Replay(first + 3, 2, records));
+  ASSERT_EQ(2u, records.size());
+  NsChangeStream::Record rec;
+  std::string name;
+  ASSERT_TRUE(NsChangeStream::Decode(records[0], rec, name));
+  ASSERT_EQ(first + 3, rec.mSeq);
+  ASSERT_EQ(103u, rec.mId);
+  ASSERT_EQ("f3", name);
+  ASSERT_TRUE(stream.Replay(first + 6, 10, records));
+  ASSERT_EQ(2u, records.size());
+  // Up to date consumer
+  ASSERT_TRUE(stream.Replay(first + 8, 10, records));
+  ASSERT_TRUE(records.empty());
+}
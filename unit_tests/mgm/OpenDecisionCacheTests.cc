@@ -0,0 +1,118 @@
+//------------------------------------------------------------------------------
+// File: OpenDecisionCacheTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/OpenDecisionCache.hh"
+#include <thread>
+
+using eos::mgm::OpenDecisionCache;
+
+//------------------------------------------------------------------------------
+// Cached access per identity and file version
+//------------------------------------------------------------------------------
+TEST(OpenDecisionCache, Access)
+{
+  OpenDecisionCache cache(std::chrono::milliseconds(60000), 100);
+  OpenDecisionCache::Version v1 {{1, 2, 3, 4, 5, 6, 7, 8}};
+  OpenDecisionCache::Version v2 {{1, 2, 3, 4, 5, 6, 7, 9}};
+  OpenDecisionCache::Access access;
+  ASSERT_TRUE(cache.IsEnabled());
+  ASSERT_FALSE(cache.GetAccess("alice", 10, v1, access));
+  access.mUid = 1000;
+  access.mGid = 100;
+  access.mAttrs["sys.forced.space"] = "default";
+  cache.PutAccess("alice", 10, v1, access);
+  OpenDecisionCache::Access cached;
+  ASSERT_TRUE(cache.GetAccess("alice", 10, v1, cached));
+  ASSERT_EQ(1000u, cached.mUid);
+  ASSERT_EQ(100u, cached.mGid);
+  ASSERT_EQ("default", cached.mAttrs["sys.forced.space"]);
+  // Other identity or file
+  ASSERT_FALSE(cache.GetAccess("bob", 10, v1, cached));
+  ASSERT_FALSE(cache.GetAccess("alice", 11, v1, cached));
+  // A changed file drops the entry
+  ASSERT_FALSE(cache.GetAccess("alice", 10, v2, cached));
+  ASSERT_FALSE(cache.GetAccess("alice", 10, v1, cached));
+  ASSERT_EQ(0u, cache.Size());
+  ASSERT_EQ(1u, cache.GetHits());
+}
+
+//------------------------------------------------------------------------------
+// Replica selections need the same locations and filesystem states
+//------------------------------------------------------------------------------
+TEST(OpenDecisionCache, Replicas)
+{
+  OpenDecisionCache cache(std::chrono::milliseconds(60000), 100);
+  OpenDecisionCache::Version version {{1, 0, 1, 0, 1, 0, 1, 0}};
+  OpenDecisionCache::Replicas replicas;
+  replicas.mLocations = {3, 5};
+  replicas.mFsIndex = 1;
+  replicas.mSelectedFs = {3, 5};
+  // No access entry yet
+  cache.PutReplicas("alice", 10, version, 7, replicas);
+  ASSERT_FALSE(cache.GetReplicas("alice", 10, version, 7, {3, 5}, replicas));
+  cache.PutAccess("alice", 10, version, OpenDecisionCache::Access());
+  replicas.mLocations = {3, 5};
+  replicas.mFsIndex = 1;
+  cache.PutReplicas("alice", 10, version, 7, replicas);
+  OpenDecisionCache::Replicas cached;
+  ASSERT_TRUE(cache.GetReplicas("alice", 10, version, 7, {3, 5}, cached));
+  ASSERT_EQ(1u, cached.mFsIndex);
+  ASSERT_FALSE(cache.GetReplicas("alice", 10, version, 8, {3, 5}, cached));
+  ASSERT_FALSE(cache.GetReplicas("alice", 10, version, 7, {3, 6}, cached));
+  // A new access evaluation forgets the selection
+  cache.PutAccess("alice", 10, version, OpenDecisionCache::Access());
+  ASSERT_FALSE(cache.GetReplicas("alice", 10, version, 7, {3, 5}, cached));
+}
+
+//------------------------------------------------------------------------------
+// Entries expire and the least recently used ones are evicted
+//------------------------------------------------------------------------------
+TEST(OpenDecisionCache, ExpiryAndEviction)
+{
+  OpenDecisionCache::Version version {{0}};
+  OpenDecisionCache::Access access;
+  {
+    OpenDecisionCache cache(std::chrono::milliseconds(20), 100);
+    cache.PutAccess("alice", 10, version, access);
+    ASSERT_TRUE(cache.GetAccess("alice", 10, version, access));
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    ASSERT_FALSE(cache.GetAccess("alice", 10, version, access));
+  }
+  {
+    // One entry per shard, files of the same shard evict each other
+    OpenDecisionCache cache(std::chrono::milliseconds(60000), 1);
+    cache.PutAccess("alice", 16, version, access);
+    cache.PutAccess("alice", 32, version, access);
+    cache.PutAccess("alice", 17, version, access);
+    ASSERT_EQ(2u, cache.Size());
+    ASSERT_FALSE(cache.GetAccess("alice", 16, version, access));
+    ASSERT_TRUE(cache.GetAccess("alice", 32, version, access));
+    ASSERT_TRUE(cache.GetAccess("alice", 17, version, access));
+  }
+  {
+    OpenDecisionCache cache(std::chrono::milliseconds(0), 100);
+    ASSERT_FALSE(cache.IsEnabled());
+    cache.PutAccess("alice", 10, version, access);
+    ASSERT_FALSE(cache.GetAccess("alice", 10, version, access));
+  }
+}
@@ -0,0 +1,102 @@
+//------------------------------------------------------------------------------
+// File: ProcOutputPipeTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/proc/ProcOutputPipe.hh"
+#include <atomic>
+#include <thread>
+
+using eos::mgm::ProcOutputPipe;
+
+//------------------------------------------------------------------------------
+// Output written through the stream is read back in order
+//------------------------------------------------------------------------------
+TEST(ProcOutputPipe, StreamInOrder)
+{
+  ProcOutputPipe pipe(1024);
+  std::string expected;
+
+  for (int i = 0; i < 10000; ++i) {
+    expected += "line=" + std::to_string(i) + "\n";
+  }
+
+  std::thread producer([&]() {
+    for (int i = 0; i < 10000; ++i) {
+      pipe.GetStream() << "line=" << i << "\n";
+    }
+
+    pipe.CloseWrite();
+  });
+  std::string result;
+  char buff[100];
+  size_t nread;
+
+  while ((nread = pipe.Read(buff, sizeof(buff)))) {
+    result.append(buff, nread);
+  }
+
+  producer.join();
+  ASSERT_EQ(expected, result);
+  ASSERT_EQ(0u, pipe.Read(buff, sizeof(buff)));
+}
+
+//------------------------------------------------------------------------------
+// The producer blocks while the pipe is full
+//------------------------------------------------------------------------------
+TEST(ProcOutputPipe, BackPressure)
+{
+  ProcOutputPipe pipe(100);
+  std::string data(100, 'a');
+  ASSERT_TRUE(pipe.Write(data.data(), data.size()));
+  std::atomic<bool> written {false};
+  std::thread producer([&]() {
+    ASSERT_TRUE(pipe.Write("b", 1));
+    written = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_FALSE(written);
+  char buff[10];
+  ASSERT_EQ(10u, pipe.Read(buff, sizeof(buff)));
+  producer.join();
+  ASSERT_TRUE(written);
+  ASSERT_EQ(91u, pipe.GetSize());
+}
+
+//------------------------------------------------------------------------------
+// Closing the consumer end unblocks the producer and fails its writes
+//------------------------------------------------------------------------------
+TEST(ProcOutputPipe, CloseRead)
+{
+  ProcOutputPipe pipe(10);
+  std::thread producer([&]() {
+    std::string data(1000, 'a');
+
+    while (pipe.GetStream()) {
+      pipe.GetStream() << data;
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  pipe.CloseRead();
+  producer.join();
+  ASSERT_FALSE(pipe.Write("a", 1));
+  ASSERT_EQ(0u, pipe.GetSize());
+}
@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------
+// File: QuotaCounterTableTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+#include "gtest/gtest.h"
+#include "mgm/QuotaCounterTable.hh"
+#include <thread>
+#include <vector>
+
+using eos::mgm::QuotaCounterTable;
+
+//------------------------------------------------------------------------------
+// Basic operations on the counters
+//------------------------------------------------------------------------------
+TEST(QuotaCounterTable, Operations)
+{
+  QuotaCounterTable table;
+  uint64_t key = (3ull << 32) | 1000;
+  ASSERT_EQ(0ull, table.Get(key));
+  ASSERT_FALSE(table.Erase(key));
+  table.Set(key, 100);
+  ASSERT_EQ(100ull, table.Get(key));
+  table.Add(key, -40);
+  ASSERT_EQ(60ull, table.Get(key));
+  // Additions leading to negative values are ignored
+  table.Add(key, -100);
+  ASSERT_EQ(60ull, table.Get(key));
+  table.Add((4ull << 32) | 1000, 5);
+  size_t count = 0;
+  table.ForEach([&](uint64_t k, unsigned long long v) {
+    ++count;
+  });
+  ASSERT_EQ(2u, count);
+  ASSERT_TRUE(table.Erase(key));
+  ASSERT_FALSE(table.Erase(key));
+  ASSERT_EQ(0ull, table.Get(key));
+  count = 0;
+  table.ForEach([&](uint64_t k, unsigned long long v) {
+    ++count;
+  });
+  ASSERT_EQ(1u, count);
+}
+
+//------------------------------------------------------------------------------
+// Keys not fitting in the table go to the overflow map
+//------------------------------------------------------------------------------
+TEST(QuotaCounterTable, Overflow)
+{
+  QuotaCounterTable table(16);
+  unsigned long long sum = 0;
+
+  for (uint64_t id = 1; id <= 100; ++id) {
+    table.Set((1ull << 32) | id, id);
+  }
+
+  for (uint64_t id = 1; id <= 100; ++id) {
+    ASSERT_EQ(id, table.Get((1ull << 32) | id));
+  }
+
+  table.ForEach([&](uint64_t k, unsigned long long v) {
+    sum += v;
+  });
+  ASSERT_EQ(5050ull, sum);
+  ASSERT_TRUE(table.Erase((1ull << 32) | 100));
+  ASSERT_EQ(0ull, table.Get((1ull << 32) | 100));
+}
+
+//------------------------------------------------------------------------------
+// Concurrent additions are not lost
+//------------------------------------------------------------------------------
+TEST(QuotaCounterTable, ConcurrentAdd)
+{
+  QuotaCounterTable table(64);
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&table]() {
+      for (uint64_t n = 0; n < 10000; ++n) {
+        table.Add((1ull << 32) | (n % 100), 1);
+      }
+    });
+  }
+
+  for (auto& th : threads) {
+    th.join();
+  }
+
+  for (uint64_t id = 0; id < 100; ++id) {
+    ASSERT_EQ(800ull, table.Get((1ull << 32) | id));
+  }
+}
@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+// File: RateLimiterTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/RateLimiter.hh"
+
+using eos::mgm::RateLimiter;
+
+//------------------------------------------------------------------------------
+// Wildcard user rule with the stall time given by the deficit
+//------------------------------------------------------------------------------
+TEST(RateLimiter, UserWildcard)
+{
+  RateLimiter limiter;
+  std::string rule;
+  limiter.Configure({{"rate:user:*:Stat", "10"}, {"*", "60"}});
+  // The bucket holds 5 seconds worth of operations
+  limiter.Consume("Stat", 1000, 1000, 50);
+  ASSERT_EQ(0, limiter.GetStallTime(1000, 1000, rule));
+  limiter.Consume("Stat", 1000, 1000, 25);
+  ASSERT_EQ(3, limiter.GetStallTime(1000, 1000, rule));
+  ASSERT_EQ("rate:user:*:Stat", rule);
+  // Other users and operations are not affected
+  ASSERT_EQ(0, limiter.GetStallTime(1001, 1000, rule));
+  limiter.Consume("OpenRead", 1001, 1000, 1000);
+  ASSERT_EQ(0, limiter.GetStallTime(1001, 1000, rule));
+}
+
+//------------------------------------------------------------------------------
+// Rules for given users or groups
+//------------------------------------------------------------------------------
+TEST(RateLimiter, UserAndGroup)
+{
+  RateLimiter limiter;
+  std::string rule;
+  limiter.Configure({{"rate:user:*:Stat", "10"}, {"rate:user:1000:Stat", "100"},
+    {"rate:group:2000:Stat", "1"}, {"rate:user:*:FindFiles", "1"}
+  });
+  // The user rule overrides the wildcard
+  limiter.Consume("Stat", 1000, 1000, 100);
+  ASSERT_EQ(0, limiter.GetStallTime(1000, 1000, rule));
+  // The group rule applies next to the user rule
+  limiter.Consume("Stat", 1000, 2000, 10);
+  ASSERT_EQ(5, limiter.GetStallTime(1000, 2000, rule));
+  ASSERT_EQ("rate:group:2000:Stat", rule);
+  ASSERT_EQ(5, limiter.GetStallTime(1001, 2000, rule));
+  ASSERT_EQ(0, limiter.GetStallTime(1000, 1000, rule));
+  // Find limits are not rates
+  limiter.Consume("FindFiles", 1001, 1001, 1000);
+  ASSERT_EQ(0, limiter.GetStallTime(1001, 1001, rule));
+  // Removing the rules drops the holds
+  limiter.Configure({});
+  ASSERT_EQ(0, limiter.GetStallTime(1000, 2000, rule));
+}
@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------------
+// File: RecycleIndexTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/RecycleIndex.hh"
+
+using eos::mgm::RecycleIndex;
+
+//------------------------------------------------------------------------------
+// The entries are ordered by deletion time in the index
+//------------------------------------------------------------------------------
+TEST(RecycleIndex, FieldOrder)
+{
+  RecycleIndex::Entry e1, e2, e3;
+  e1.mDeletionTime = 999;
+  e1.mId = 0xffff;
+  e2.mDeletionTime = 1000;
+  e2.mId = 0x1;
+  e3.mDeletionTime = 1560000000;
+  e3.mId = 0x10;
+  e3.mIsDir = true;
+  ASSERT_EQ("fxid:000000000000ffff", e1.GetKey());
+  ASSERT_EQ("pxid:0000000000000010", e3.GetKey());
+  ASSERT_EQ("00000000000000000999:fxid:000000000000ffff", e1.GetField());
+  ASSERT_LT(e1.GetField(), e2.GetField());
+  ASSERT_LT(e2.GetField(), e3.GetField());
+}
+
+//------------------------------------------------------------------------------
+// Serialization of entries
+//------------------------------------------------------------------------------
+TEST(RecycleIndex, Serialization)
+{
+  RecycleIndex::Entry entry;
+  entry.mDeletionTime = 1560000000;
+  entry.mId = 12345;
+  entry.mIsDir = true;
+  entry.mUid = 1001;
+  entry.mGid = 2002;
+  entry.mSize = 4096;
+  entry.mPath = "/eos/proc/recycle/uid:1001/2019/06/08/0/#:#eos#:#my dir."
+                "0000000000003039.d";
+  RecycleIndex::Entry out;
+  ASSERT_TRUE(RecycleIndex::Entry::Deserialize(entry.Serialize(), out));
+  ASSERT_EQ(entry.mDeletionTime, out.mDeletionTime);
+  ASSERT_EQ(entry.mId, out.mId);
+  ASSERT_EQ(entry.mIsDir, out.mIsDir);
+  ASSERT_EQ(entry.mUid, out.mUid);
+  ASSERT_EQ(entry.mGid, out.mGid);
+  ASSERT_EQ(entry.mSize, out.mSize);
+  ASSERT_EQ(entry.mPath, out.mPath);
+  ASSERT_EQ(entry.GetField(), out.GetField());
+  ASSERT_FALSE(RecycleIndex::Entry::Deserialize("", out));
+  ASSERT_FALSE(RecycleIndex::Entry::Deserialize("1 2 x 3 4 5 /path", out));
+  ASSERT_FALSE(RecycleIndex::Entry::Deserialize("1 2 f 3 4 5", out));
+}
@@ -0,0 +1,76 @@
+//------------------------------------------------------------------------------
+// File: RequestTraceTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/RequestTrace.hh"
+#include <chrono>
+#include <thread>
+
+using eos::mgm::RequestTrace;
+
+TEST(RequestTrace, Disabled)
+{
+  RequestTrace::Configure(0);
+  RequestTrace trace("open", "logid");
+  ASSERT_FALSE(trace.IsActive());
+  trace.Mark("stage");
+  ASSERT_EQ(0u, trace.GetElapsedNs());
+}
+
+TEST(RequestTrace, Stages)
+{
+  RequestTrace::Configure(1000);
+  RequestTrace trace("open", "0123-abcd");
+  ASSERT_TRUE(trace.IsActive());
+  trace.SetInfo("/eos/dir/\"file\"", 12, 34);
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  trace.Mark("idmap");
+  trace.Mark("ns_lock_wait");
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  trace.Mark("ns_lock_wait");
+  ASSERT_GE(trace.GetElapsedNs(), 10 * 1000 * 1000ull);
+  std::string report = trace.Report(false);
+  ASSERT_NE(std::string::npos, report.find("op=open logid=0123-abcd"));
+  ASSERT_NE(std::string::npos, report.find("uid=12 gid=34"));
+  ASSERT_NE(std::string::npos, report.find(" idmap_ms=5"));
+  ASSERT_NE(std::string::npos, report.find(" ns_lock_wait_ms=5"));
+  // Repeated stages accumulate into one entry
+  ASSERT_EQ(report.find("ns_lock_wait"), report.rfind("ns_lock_wait"));
+  std::string json = trace.Report(true);
+  ASSERT_NE(std::string::npos, json.find("\"path\": \"/eos/dir/\\\"file\\\"\""));
+  ASSERT_NE(std::string::npos, json.find("\"stages_ms\": {\"idmap\": "));
+  RequestTrace::Configure(0);
+}
+
+TEST(RequestTrace, Sampling)
+{
+  RequestTrace::Configure(1000, 0.25);
+  int active = 0;
+
+  for (int i = 0; i < 100; ++i) {
+    RequestTrace trace("open", "logid");
+    active += trace.IsActive();
+  }
+
+  ASSERT_EQ(25, active);
+  RequestTrace::Configure(0);
+}
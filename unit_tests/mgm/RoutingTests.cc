@@ -161,3 +161,77 @@ TEST(Routing, StallRedirect)
   ASSERT_EQ(5094, port);
   route.Clear();
 }
+
+//------------------------------------------------------------------------------
+// Test the longest match of nested routes and the endpoint selection
+//------------------------------------------------------------------------------
+TEST(Routing, LongestMatchAndLatency)
+{
+  using namespace eos::mgm;
+  using eos::mgm::PathRouting;
+  std::string stat_info;
+  eos::mgm::PathRouting route(std::chrono::seconds(0));
+  std::vector<std::pair<std::string, std::string>> inputs {
+    {"/eos/dir/", "eos_dummy1.cern.ch:1094:8000"},
+    {"/eos/dir/sub/", "eos_dummy2.cern.ch:2094:9000"},
+    {"/eos/dir/sub/deep/", "eos_dummy3.cern.ch:3094:10000"}};
+
+  for (const auto& input : inputs) {
+    RouteEndpoint endpoint;
+    endpoint.mIsOnline.store(true);
+    ASSERT_TRUE(endpoint.ParseFromString(input.second));
+    ASSERT_TRUE(route.Add(input.first, std::move(endpoint)));
+  }
+
+  eos::common::Mapping::VirtualIdentity vid;
+  eos::common::Mapping::Root(vid);
+  std::string host;
+  int port;
+  ASSERT_TRUE(PathRouting::Status::REROUTE ==
+              route.Reroute("/eos/dir/sub/deep/file", nullptr, vid, host, port,
+                            stat_info));
+  ASSERT_EQ(3094, port);
+  ASSERT_TRUE(PathRouting::Status::REROUTE ==
+              route.Reroute("/eos/dir/sub/other/file", nullptr, vid, host,
+                            port, stat_info));
+  ASSERT_EQ(2094, port);
+  ASSERT_TRUE(PathRouting::Status::REROUTE ==
+              route.Reroute("/eos/dir/sub/deep/../../file", nullptr, vid, host,
+                            port, stat_info));
+  ASSERT_EQ(1094, port);
+  ASSERT_TRUE(PathRouting::Status::REROUTE ==
+              route.Reroute("/", "mgm.path=/eos/dir/sub/x", vid, host, port,
+                            stat_info));
+  ASSERT_EQ(2094, port);
+  ASSERT_TRUE(route.Remove("/eos/dir/sub/"));
+  ASSERT_TRUE(PathRouting::Status::REROUTE ==
+              route.Reroute("/eos/dir/sub/other/file", nullptr, vid, host,
+                            port, stat_info));
+  ASSERT_EQ(1094, port);
+  ASSERT_TRUE(PathRouting::Status::REROUTE ==
+              route.Reroute("/eos/dir/sub/deep/file", nullptr, vid, host, port,
+                            stat_info));
+  ASSERT_EQ(3094, port);
+  // Without a master the online endpoint with the lowest latency is used
+  std::vector<std::pair<std::string, uint64_t>> endpoints {
+    {"eos_dummy4.cern.ch:4094:11000", 3000},
+    {"eos_dummy5.cern.ch:5094:12000", 1000},
+    {"eos_dummy6.cern.ch:6094:13000", 200}};
+
+  for (const auto& input : endpoints) {
+    RouteEndpoint endpoint;
+    endpoint.mIsOnline.store(input.second != 200);
+    endpoint.mLatencyUs.store(input.second);
+    ASSERT_TRUE(endpoint.ParseFromString(input.first));
+    ASSERT_TRUE(route.Add("/eos/multi/", std::move(endpoint)));
+  }
+
+  ASSERT_TRUE(PathRouting::Status::REROUTE ==
+              route.Reroute("/eos/multi/file", nullptr, vid, host, port,
+                            stat_info));
+  ASSERT_STREQ("eos_dummy5.cern.ch", host.c_str());
+  route.Clear();
+  ASSERT_TRUE(PathRouting::Status::NOROUTING ==
+              route.Reroute("/eos/dir/sub/deep/file", nullptr, vid, host, port,
+                            stat_info));
+}
@@ -0,0 +1,81 @@
+//------------------------------------------------------------------------------
+// File: StatHistoTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/Stat.hh"
+
+using eos::mgm::StatHisto;
+
+//------------------------------------------------------------------------------
+// Bucket boundaries and relative error
+//------------------------------------------------------------------------------
+TEST(StatHisto, Buckets)
+{
+  for (uint64_t val = 0; val < StatHisto::kLinearMax; ++val) {
+    ASSERT_EQ(val, StatHisto::GetBucket(val));
+    ASSERT_EQ((double) val, StatHisto::GetBucketValue(val));
+  }
+
+  uint32_t prev = 0;
+
+  for (uint64_t val = StatHisto::kLinearMax; val < (1ull << 30); val += val / 7) {
+    uint32_t bucket = StatHisto::GetBucket(val);
+    ASSERT_GE(bucket, prev);
+    ASSERT_LT(bucket, StatHisto::kNumBuckets);
+    ASSERT_LE(fabs(StatHisto::GetBucketValue(bucket) - val) / val,
+              1.0 / StatHisto::kSubBuckets);
+    prev = bucket;
+  }
+
+  ASSERT_EQ(StatHisto::kNumBuckets - 1, StatHisto::GetBucket(~0ull));
+}
+
+//------------------------------------------------------------------------------
+// Percentiles and time windows
+//------------------------------------------------------------------------------
+TEST(StatHisto, Percentiles)
+{
+  StatHisto histo;
+  std::vector<double> values;
+  const std::vector<double> quantiles {0.5, 0.9, 0.99};
+  time_t now = 1000000;
+
+  for (uint64_t i = 1; i <= 1000; ++i) {
+    histo.Record(i * 100, now);
+  }
+
+  ASSERT_EQ(1000u, histo.GetPercentiles(5, quantiles, values, now));
+  ASSERT_NEAR(50000, values[0], 50000 / StatHisto::kSubBuckets);
+  ASSERT_NEAR(90000, values[1], 90000 / StatHisto::kSubBuckets);
+  ASSERT_NEAR(99000, values[2], 99000 / StatHisto::kSubBuckets);
+  // Samples leave the short windows but are still in the long ones
+  ASSERT_EQ(0u, histo.GetPercentiles(5, quantiles, values, now + 5));
+  ASSERT_EQ(1000u, histo.GetPercentiles(60, quantiles, values, now + 5));
+  ASSERT_EQ(0u, histo.GetPercentiles(60, quantiles, values, now + 60));
+  ASSERT_EQ(1000u, histo.GetPercentiles(3600, quantiles, values, now + 600));
+  // Slot reused after a full rotation drops the old samples
+  histo.Record(10, now + 60);
+  ASSERT_EQ(1u, histo.GetPercentiles(5, quantiles, values, now + 60));
+  ASSERT_EQ(10.0, values[0]);
+  histo.Clear();
+  ASSERT_EQ(0u, histo.GetPercentiles(3600, quantiles, values, now + 60));
+}
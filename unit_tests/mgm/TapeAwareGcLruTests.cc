@@ -223,3 +223,41 @@ TEST_F(TapeAwareGcLruTest, DISABLED_performance_500000_files) {
     std::cout << "Time elapsed for fid " << fid << " = " << elapsed.count() << " seconds" << std::endl;
   }
 }
+
+//------------------------------------------------------------------------------
+// Test
+//------------------------------------------------------------------------------
+TEST_F(TapeAwareGcLruTest, oldFileDiscovered)
+{
+  using namespace eos;
+  using namespace eos::mgm;
+
+  const TapeAwareGcLru::FidQueue::size_type maxQueueSize = 4;
+  TapeAwareGcLru lru(maxQueueSize);
+
+  // Files accessed while the queue is being rebuilt stay the most used
+  lru.fileAccessed(1);
+
+  // Rebuild from the most to the least recently used file
+  lru.oldFileDiscovered(2);
+  lru.oldFileDiscovered(1);
+  lru.oldFileDiscovered(3);
+
+  ASSERT_EQ(3, lru.size());
+  ASSERT_FALSE(lru.maxQueueSizeExceeded());
+
+  lru.oldFileDiscovered(4);
+  lru.oldFileDiscovered(5);
+
+  ASSERT_EQ(maxQueueSize, lru.size());
+  ASSERT_TRUE(lru.maxQueueSizeExceeded());
+
+  const std::list<IFileMD::id_t> fidsOut = {4, 3, 2, 1};
+
+  for(const auto fid: fidsOut) {
+    ASSERT_FALSE(lru.empty());
+    ASSERT_EQ(fid, lru.getAndPopFidOfLeastUsedFile());
+  }
+
+  ASSERT_TRUE(lru.empty());
+}
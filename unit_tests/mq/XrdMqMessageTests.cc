@@ -187,3 +187,39 @@ TEST(XrdMqMessage, RSATest)
   free(decrypted_data);
   BIO_free(bio);
 }
+
+//------------------------------------------------------------------------------
+// Message body compression test
+//------------------------------------------------------------------------------
+TEST(XrdMqMessage, CompressionTest)
+{
+  std::string body;
+
+  for (int i = 0; i < 1000; ++i) {
+    body += "key" + std::to_string(i) + "=value&";
+  }
+
+  XrdMqMessage msg("compression");
+  msg.SetBody(body.c_str());
+  // Below the threshold or disabled the body is kept as is
+  ASSERT_FALSE(msg.Compress(0));
+  ASSERT_FALSE(msg.Compress(body.length() + 1));
+  ASSERT_EQ(0u, msg.kMessageHeader.kCompressed);
+  ASSERT_TRUE(msg.Compress(1024));
+  ASSERT_NE(0u, msg.kMessageHeader.kCompressed);
+  ASSERT_FALSE(msg.Compress(1024));
+  msg.Encode();
+  std::unique_ptr<XrdMqMessage> rmsg(XrdMqMessage::Create(
+                                       msg.GetMessageBuffer()));
+  ASSERT_TRUE(rmsg != nullptr);
+  ASSERT_EQ(0u, rmsg->kMessageHeader.kCompressed);
+  ASSERT_EQ(body, rmsg->GetBody());
+  // Random data does not shrink and is sent as is
+  std::unique_ptr<char[]> data {new char[4096]};
+  GenerateRandomData(data.get(), 4096);
+  std::string encoded;
+  ASSERT_TRUE(XrdMqMessage::Base64Encode(data.get(), 4096, encoded));
+  XrdMqMessage rnd("compression");
+  rnd.SetBody(encoded.c_str());
+  ASSERT_FALSE(rnd.Compress(1024));
+}
@@ -0,0 +1,83 @@
+//------------------------------------------------------------------------------
+// File: XrdMqSharedHashTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mq/XrdMqSharedObject.hh"
+
+//------------------------------------------------------------------------------
+// Binary encoding of the pairs round trip
+//------------------------------------------------------------------------------
+TEST(XrdMqSharedHash, BinaryPairsRoundTrip)
+{
+  std::vector<XrdMqSharedHash::Pair> pairs {
+    {"#0#stat.boot", "booted", 1},
+    {"stat.statfs.bavail", "123456789", 300},
+    {"stat.statfs.bfree", "", 1ull << 40},
+    {"stat.statfs.blocks", std::string("a\0b|~%&", 7), 0},
+    {"uuid", "3d8a2a4e-0f3e-4b55-9cf2-2e0fa9b2ec35", 1234567}
+  };
+  std::string bin;
+  XrdMqSharedHash::EncodeBinaryPairs(pairs, bin);
+  std::vector<XrdMqSharedHash::Pair> decoded;
+  ASSERT_TRUE(XrdMqSharedHash::DecodeBinaryPairs(bin.c_str(), bin.length(),
+              decoded));
+  ASSERT_EQ(pairs.size(), decoded.size());
+
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    ASSERT_EQ(pairs[i].mKey, decoded[i].mKey);
+    ASSERT_EQ(pairs[i].mValue, decoded[i].mValue);
+    ASSERT_EQ(pairs[i].mChangeId, decoded[i].mChangeId);
+  }
+
+  // Shared key prefixes are not repeated
+  ASSERT_EQ(std::string::npos, bin.find("stat.statfs.bfree"));
+  bin.clear();
+  XrdMqSharedHash::EncodeBinaryPairs({}, bin);
+  ASSERT_TRUE(XrdMqSharedHash::DecodeBinaryPairs(bin.c_str(), bin.length(),
+              decoded));
+  ASSERT_TRUE(decoded.empty());
+}
+
+//------------------------------------------------------------------------------
+// Corrupted binary pairs are rejected
+//------------------------------------------------------------------------------
+TEST(XrdMqSharedHash, BinaryPairsCorrupted)
+{
+  std::vector<XrdMqSharedHash::Pair> pairs {
+    {"stat.geotag", "site::rack", 10}, {"stat.host", "fst.cern.ch", 11}
+  };
+  std::string bin;
+  XrdMqSharedHash::EncodeBinaryPairs(pairs, bin);
+  std::vector<XrdMqSharedHash::Pair> decoded;
+
+  for (size_t len = 0; len < bin.length(); ++len) {
+    ASSERT_FALSE(XrdMqSharedHash::DecodeBinaryPairs(bin.c_str(), len, decoded));
+  }
+
+  std::string trailing = bin + "x";
+  ASSERT_FALSE(XrdMqSharedHash::DecodeBinaryPairs(trailing.c_str(),
+               trailing.length(), decoded));
+  std::string version = bin;
+  version[0] = 2;
+  ASSERT_FALSE(XrdMqSharedHash::DecodeBinaryPairs(version.c_str(),
+               version.length(), decoded));
+}
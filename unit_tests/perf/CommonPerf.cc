@@ -0,0 +1,247 @@
+//------------------------------------------------------------------------------
+// File: CommonPerf.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! Micro-benchmarks of the hot primitives of the common library
+//------------------------------------------------------------------------------
+
+#include "PerfRunner.hh"
+#include "common/ConcurrentQueue.hh"
+#include "common/LayoutId.hh"
+#include "common/Mapping.hh"
+#include "common/RWMutex.hh"
+#include "common/StringConversion.hh"
+#include "common/ThreadPool.hh"
+#include "common/crc32c/checksumkernels.h"
+#include "common/crc32c/crc32c.h"
+#include "XrdSec/XrdSecEntity.hh"
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using eos::perf::PerfRunner;
+using eos::perf::gSink;
+
+TEST(CommonPerf, RWMutexReadLock)
+{
+  eos::common::RWMutex mutex;
+  EXPECT_TRUE(PerfRunner::Get().Run(1000000, [&](size_t ops) {
+    for (size_t i = 0; i < ops; ++i) {
+      mutex.LockRead();
+      mutex.UnLockRead();
+    }
+  }));
+}
+
+TEST(CommonPerf, RWMutexWriteLock)
+{
+  eos::common::RWMutex mutex;
+  EXPECT_TRUE(PerfRunner::Get().Run(1000000, [&](size_t ops) {
+    for (size_t i = 0; i < ops; ++i) {
+      mutex.LockWrite();
+      mutex.UnLockWrite();
+    }
+  }));
+}
+
+TEST(CommonPerf, RWMutexContendedRead)
+{
+  // Time per read lock taken by one of four concurrent readers
+  eos::common::RWMutex mutex;
+  const size_t nthreads = 4;
+  EXPECT_TRUE(PerfRunner::Get().Run(200000, [&](size_t ops) {
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < nthreads; ++t) {
+      threads.emplace_back([&]() {
+        for (size_t i = 0; i < ops; ++i) {
+          eos::common::RWMutexReadLock lock(mutex);
+          gSink += i;
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }));
+}
+
+TEST(CommonPerf, ThreadPoolTask)
+{
+  eos::common::ThreadPool pool(4, 4);
+  std::vector<std::future<int>> futures;
+  EXPECT_TRUE(PerfRunner::Get().Run(100000, [&](size_t ops) {
+    futures.clear();
+
+    for (size_t i = 0; i < ops; ++i) {
+      futures.push_back(pool.PushTask<int>([]() {
+        return 1;
+      }));
+    }
+
+    for (auto& future : futures) {
+      gSink += future.get();
+    }
+  }));
+}
+
+TEST(CommonPerf, ConcurrentQueuePushPop)
+{
+  eos::common::ConcurrentQueue<uint64_t> queue;
+  EXPECT_TRUE(PerfRunner::Get().Run(1000000, [&](size_t ops) {
+    uint64_t value = 0;
+
+    for (size_t i = 0; i < ops; ++i) {
+      value = i;
+      queue.push(value);
+      queue.try_pop(value);
+      gSink += value;
+    }
+  }));
+}
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Time per MB of a checksum function
+//------------------------------------------------------------------------------
+::testing::AssertionResult
+RunChecksum(checksum::ChecksumFunctionPtr func, uint32_t init)
+{
+  std::vector<char> buffer(1024 * 1024);
+
+  for (size_t i = 0; i < buffer.size(); ++i) {
+    buffer[i] = (char)(i * 7 + (i >> 9));
+  }
+
+  return PerfRunner::Get().Run(100, [&](size_t ops) {
+    uint32_t value = init;
+
+    for (size_t i = 0; i < ops; ++i) {
+      value = func(value, buffer.data(), buffer.size());
+    }
+
+    gSink += value;
+  });
+}
+}
+
+TEST(CommonPerf, Adler32PerMB)
+{
+  EXPECT_TRUE(RunChecksum(checksum::adler32, 1));
+}
+
+TEST(CommonPerf, Crc32PerMB)
+{
+  EXPECT_TRUE(RunChecksum(checksum::crc32, 0));
+}
+
+TEST(CommonPerf, Crc32cPerMB)
+{
+  EXPECT_TRUE(RunChecksum(checksum::crc32c, checksum::crc32cInit()));
+}
+
+TEST(CommonPerf, MappingIdMap)
+{
+  static std::once_flag sInit;
+  std::call_once(sInit, []() {
+    eos::common::Mapping::Init();
+  });
+  XrdSecEntity client("unix");
+  client.name = (char*) "perftest";
+  client.host = (char*) "localhost.localdomain";
+  client.tident = (char*) "perftest.1:1@localhost";
+  EXPECT_TRUE(PerfRunner::Get().Run(100000, [&](size_t ops) {
+    for (size_t i = 0; i < ops; ++i) {
+      eos::common::Mapping::VirtualIdentity vid;
+      eos::common::Mapping::IdMap(&client, "eos.app=perf", client.tident, vid,
+                                  false);
+      gSink += vid.uid;
+    }
+  }));
+}
+
+TEST(CommonPerf, LayoutIdDecode)
+{
+  using eos::common::LayoutId;
+  const std::vector<unsigned long> lids = {
+    LayoutId::GetId(LayoutId::kPlain, LayoutId::kAdler),
+    LayoutId::GetId(LayoutId::kReplica, LayoutId::kAdler, 2, LayoutId::k4M),
+    LayoutId::GetId(LayoutId::kRaid6, LayoutId::kCRC32C, 10, LayoutId::k1M,
+                    LayoutId::kCRC32C),
+    LayoutId::GetId(LayoutId::kRaidDP, LayoutId::kMD5, 6, LayoutId::k64k)
+  };
+  EXPECT_TRUE(PerfRunner::Get().Run(1000000, [&](size_t ops) {
+    size_t sum = 0;
+
+    for (size_t i = 0; i < ops; ++i) {
+      // what the open and the scheduler read out of a layout id
+      unsigned long lid = lids[i & 3];
+      sum += LayoutId::GetLayoutType(lid) + LayoutId::GetStripeNumber(lid) +
+             LayoutId::GetBlocksize(lid) + LayoutId::GetChecksumLen(lid) +
+             LayoutId::GetRedundancyStripeNumber(lid) +
+             (size_t) LayoutId::GetSizeFactor(lid);
+    }
+
+    gSink += sum;
+  }));
+}
+
+TEST(CommonPerf, StringConversionTokenize)
+{
+  const std::string list = "fs=12,fs=13,fs=14,fs=15,fs=16,fs=17,fs=18,fs=19";
+  std::vector<std::string> tokens;
+  EXPECT_TRUE(PerfRunner::Get().Run(1000000, [&](size_t ops) {
+    for (size_t i = 0; i < ops; ++i) {
+      tokens.clear();
+      eos::common::StringConversion::Tokenize(list, tokens, ",");
+      gSink += tokens.size();
+    }
+  }));
+}
+
+TEST(CommonPerf, StringConversionHex)
+{
+  char buffer[32];
+  eos::common::StringConversion::InitLookupTables();
+  EXPECT_TRUE(PerfRunner::Get().Run(1000000, [&](size_t ops) {
+    for (size_t i = 0; i < ops; ++i) {
+      eos::common::StringConversion::FastUnsignedToAsciiHex(
+        (unsigned long long) i * 0x9e3779b97f4a7c15ull, buffer);
+      gSink += buffer[0];
+    }
+  }));
+}
+
+TEST(CommonPerf, StringConversionCurlEscape)
+{
+  const std::string path =
+    "/eos/experiment/user/a/alice/analysis/run 2019/data set & more/file.root";
+  EXPECT_TRUE(PerfRunner::Get().Run(100000, [&](size_t ops) {
+    for (size_t i = 0; i < ops; ++i) {
+      gSink += eos::common::StringConversion::curl_escaped(path).length();
+    }
+  }));
+}
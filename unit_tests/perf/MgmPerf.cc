@@ -0,0 +1,118 @@
+//------------------------------------------------------------------------------
+// File: MgmPerf.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! Micro-benchmarks of the hot primitives of the MGM
+//------------------------------------------------------------------------------
+
+#include "PerfRunner.hh"
+#include "mgm/LRUIndex.hh"
+#include "mgm/geotree/SchedulingSlowTree.hh"
+#include <sstream>
+#include <vector>
+
+using eos::perf::PerfRunner;
+using eos::perf::gSink;
+using namespace eos::mgm;
+
+TEST(MgmPerf, LRUIndexGetOldest)
+{
+  // One tree of 100k files, the LRU engine asks for the oldest 100 MB
+  LRUIndex index(true);
+  index.Track(1);
+
+  for (uint64_t cid = 2; cid < 102; ++cid) {
+    index.AddContainer(cid, 1);
+  }
+
+  for (uint64_t fid = 1; fid <= 100000; ++fid) {
+    index.Upsert(fid, 2 + fid % 100, (time_t)((fid * 7919) % 100000), 1 << 20);
+  }
+
+  index.SetReady(1, index.GetGeneration(1));
+  std::vector<LRUIndex::Entry> entries;
+  EXPECT_TRUE(PerfRunner::Get().Run(10000, [&](size_t ops) {
+    for (size_t i = 0; i < ops; ++i) {
+      entries.clear();
+      index.GetOldest(1, 100 << 20, entries);
+      gSink += entries.size();
+    }
+  }));
+}
+
+TEST(MgmPerf, GeoTreePlacement)
+{
+  // Placement of two replicas in a group of 240 file systems spread over two
+  // sites, done like the GeoTreeEngine on a copy of the group tree
+  SlowTree st("perf");
+  SchedTreeBase::TreeNodeInfo info;
+  SchedTreeBase::TreeNodeStateFloat state;
+
+  for (size_t i = 0; i < 240; ++i) {
+    std::ostringstream oss;
+    oss << "site" << i % 2 << "::rack" << i % 20;
+    info.geotag = oss.str();
+    oss << "::host" << i / 20;
+    info.host = oss.str();
+    info.fsId = i + 1;
+    state.dlScore = 50 + i % 50;
+    state.ulScore = 50 + (i * 7) % 50;
+    state.fillRatio = (i * 13) % 80;
+    state.totalSpace = 2e12;
+    state.mStatus = (SchedTreeBase::tStatus)(SchedTreeBase::Available |
+                    SchedTreeBase::Writable | SchedTreeBase::Readable);
+    ASSERT_TRUE(st.insert(&info, &state) != NULL);
+  }
+
+  FastPlacementTree fpt;
+  FastROAccessTree froat;
+  FastRWAccessTree frwat;
+  FastBalancingPlacementTree fbpt;
+  FastBalancingAccessTree fbat;
+  FastDrainingPlacementTree fdpt;
+  FastDrainingAccessTree fdat;
+  SchedTreeBase::FastTreeInfo ftinfo;
+  Fs2TreeIdxMap ftmap;
+  GeoTag2NodeIdxMap geomap;
+  fpt.selfAllocate(st.getNodeCount());
+  froat.selfAllocate(st.getNodeCount());
+  frwat.selfAllocate(st.getNodeCount());
+  fbpt.selfAllocate(st.getNodeCount());
+  fbat.selfAllocate(st.getNodeCount());
+  fdpt.selfAllocate(st.getNodeCount());
+  fdat.selfAllocate(st.getNodeCount());
+  ASSERT_TRUE(st.buildFastStrcturesSched(&fpt, &froat, &frwat, &fbpt, &fbat,
+                                         &fdpt, &fdat, &ftinfo, &ftmap,
+                                         &geomap));
+  fpt.setSaturationThreshold(10);
+  std::vector<char> buffer(fpt.copyToBuffer(nullptr, 0));
+  EXPECT_TRUE(PerfRunner::Get().Run(100000, [&](size_t ops) {
+    for (size_t i = 0; i < ops; ++i) {
+      fpt.copyToBuffer(buffer.data(), buffer.size());
+      FastPlacementTree* tree = (FastPlacementTree*) buffer.data();
+      SchedTreeBase::tFastTreeIdx idx1 = 0, idx2 = 0;
+      tree->findFreeSlot(idx1);
+      tree->findFreeSlot(idx2);
+      gSink += idx1 + idx2;
+    }
+  }));
+}
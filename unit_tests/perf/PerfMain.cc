@@ -0,0 +1,42 @@
+//------------------------------------------------------------------------------
+// File: PerfMain.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "PerfRunner.hh"
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  eos::perf::PerfRunner& runner = eos::perf::PerfRunner::Get();
+
+  if (!runner.Configure(argc, argv)) {
+    eos::perf::PerfRunner::Usage(argv[0]);
+    return 2;
+  }
+
+  int rc = RUN_ALL_TESTS();
+
+  if (!runner.Finish()) {
+    return 1;
+  }
+
+  return rc;
+}
@@ -0,0 +1,230 @@
+//------------------------------------------------------------------------------
+// File: PerfRunner.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "PerfRunner.hh"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#ifndef EOS_PERF_BASELINES
+#define EOS_PERF_BASELINES "perf_baselines.txt"
+#endif
+
+namespace eos
+{
+namespace perf
+{
+
+volatile size_t gSink = 0;
+
+//------------------------------------------------------------------------------
+// Get the runner of the process
+//------------------------------------------------------------------------------
+PerfRunner&
+PerfRunner::Get()
+{
+  static PerfRunner sRunner;
+  return sRunner;
+}
+
+//------------------------------------------------------------------------------
+// Print the options
+//------------------------------------------------------------------------------
+void
+PerfRunner::Usage(const char* prog)
+{
+  std::cerr << "Usage: " << prog << " [gtest options] [options]" << std::endl
+            << "  --baseline=<file>  baseline file (default "
+            << EOS_PERF_BASELINES << ")" << std::endl
+            << "  --tolerance=<pct>  allowed slowdown in percent" << std::endl
+            << "  --repetitions=<n>  repetitions of every benchmark" << std::endl
+            << "  --update           store the measured times as baselines"
+            << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// Take the options out of the command line and load the baselines
+//------------------------------------------------------------------------------
+bool
+PerfRunner::Configure(int& argc, char** argv)
+{
+  const char* env_tolerance = getenv("EOS_PERF_TOLERANCE");
+  mBaselineFile = EOS_PERF_BASELINES;
+
+  if (env_tolerance) {
+    mTolerance = strtod(env_tolerance, nullptr);
+  }
+
+  int kept = 1;
+
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+
+    if (!strncmp(arg, "--baseline=", 11)) {
+      mBaselineFile = arg + 11;
+    } else if (!strncmp(arg, "--tolerance=", 12)) {
+      mTolerance = strtod(arg + 12, nullptr);
+    } else if (!strncmp(arg, "--repetitions=", 14)) {
+      mRepetitions = strtoul(arg + 14, nullptr, 10);
+    } else if (!strcmp(arg, "--update")) {
+      mUpdate = true;
+    } else {
+      argv[kept++] = argv[i];
+    }
+  }
+
+  argc = kept;
+
+  if ((mTolerance < 0) || (mRepetitions == 0) || mBaselineFile.empty()) {
+    return false;
+  }
+
+  return LoadBaselines();
+}
+
+//------------------------------------------------------------------------------
+// Load the baselines
+//------------------------------------------------------------------------------
+bool
+PerfRunner::LoadBaselines()
+{
+  std::ifstream file(mBaselineFile);
+
+  if (!file.is_open()) {
+    std::cerr << "warning: no baseline file " << mBaselineFile << std::endl;
+    return true;
+  }
+
+  std::string line;
+
+  while (std::getline(file, line)) {
+    if (line.empty() || (line[0] == '#')) {
+      continue;
+    }
+
+    std::istringstream iss(line);
+    std::string name;
+    double ns_per_op = 0;
+
+    if (!(iss >> name >> ns_per_op) || (ns_per_op <= 0)) {
+      std::cerr << "error: invalid baseline \"" << line << "\" in "
+                << mBaselineFile << std::endl;
+      return false;
+    }
+
+    mBaselines[name] = ns_per_op;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Measure the benchmark of the current test
+//------------------------------------------------------------------------------
+::testing::AssertionResult
+PerfRunner::Run(size_t ops, const std::function<void(size_t)>& body)
+{
+  const ::testing::TestInfo* info =
+    ::testing::UnitTest::GetInstance()->current_test_info();
+  const std::string name = std::string(info->test_case_name()) + "." +
+                           info->name();
+  // Warm up the caches and the lazily initialized state of the primitive
+  body(std::max(ops / 10, (size_t) 1));
+  double best = std::numeric_limits<double>::max();
+
+  for (size_t rep = 0; rep < mRepetitions; ++rep) {
+    auto start = std::chrono::steady_clock::now();
+    body(ops);
+    std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count() / ops);
+  }
+
+  mResults[name] = best;
+  char line[256];
+  auto it = mBaselines.find(name);
+
+  if (it == mBaselines.end()) {
+    snprintf(line, sizeof(line), "[ PERF     ] %s %.2f ns/op no baseline",
+             name.c_str(), best);
+    std::cout << line << std::endl;
+    return ::testing::AssertionSuccess();
+  }
+
+  double change = 100.0 * (best - it->second) / it->second;
+  snprintf(line, sizeof(line), "[ PERF     ] %s %.2f ns/op baseline %.2f "
+           "(%+.1f%%)", name.c_str(), best, it->second, change);
+  std::cout << line << std::endl;
+
+  if (!mUpdate && (change > mTolerance)) {
+    snprintf(line, sizeof(line), "%s regressed by %.1f%% beyond the tolerance "
+             "of %.1f%%", name.c_str(), change, mTolerance);
+    return ::testing::AssertionFailure() << line;
+  }
+
+  return ::testing::AssertionSuccess();
+}
+
+//------------------------------------------------------------------------------
+// Store the measured times if running with --update
+//------------------------------------------------------------------------------
+bool
+PerfRunner::Finish()
+{
+  if (!mUpdate) {
+    return true;
+  }
+
+  // benchmarks left out by a filter keep their baseline
+  for (const auto& result : mResults) {
+    mBaselines[result.first] = result.second;
+  }
+
+  std::ofstream file(mBaselineFile, std::ios::trunc);
+
+  if (!file.is_open()) {
+    std::cerr << "error: failed to write " << mBaselineFile << std::endl;
+    return false;
+  }
+
+  file << "# eos-perf-tests baselines: <test name> <ns per op>" << std::endl
+       << "# regenerate on the reference machine with eos-perf-tests --update"
+       << std::endl;
+  char value[64];
+
+  for (const auto& baseline : mBaselines) {
+    snprintf(value, sizeof(value), "%.2f", baseline.second);
+    file << baseline.first << " " << value << std::endl;
+  }
+
+  std::cout << "stored " << mResults.size() << " baselines in "
+            << mBaselineFile << std::endl;
+  return file.good();
+}
+
+} // namespace perf
+} // namespace eos
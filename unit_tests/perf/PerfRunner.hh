@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------------
+// File: PerfRunner.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2019 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace eos
+{
+namespace perf
+{
+
+//------------------------------------------------------------------------------
+//! Value consumed by the benchmarks, prevents dead code removal
+//------------------------------------------------------------------------------
+extern volatile size_t gSink;
+
+//------------------------------------------------------------------------------
+//! @brief Class PerfRunner - measures the micro-benchmarks of eos-perf-tests
+//! and compares them against stored baselines
+//!
+//! Every benchmark is a gtest test calling Run once, the time per operation
+//! is stored under the name of the test. The baseline file holds one
+//! "<test name> <ns per op>" line per benchmark, comment lines start with #.
+//! A benchmark fails if it is slower than its baseline by more than the
+//! tolerance, benchmarks without a baseline are only reported. Options:
+//!
+//!   --baseline=<file>   baseline file, by default the one of the source tree
+//!   --tolerance=<pct>   allowed slowdown in percent, default 20 or the value
+//!                       of EOS_PERF_TOLERANCE
+//!   --repetitions=<n>   repetitions of every benchmark, the fastest one is
+//!                       taken, default 5
+//!   --update            store the measured times as the new baselines
+//!                       instead of checking them
+//------------------------------------------------------------------------------
+class PerfRunner
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Get the runner of the process
+  //----------------------------------------------------------------------------
+  static PerfRunner& Get();
+
+  //----------------------------------------------------------------------------
+  //! Take the options out of the command line and load the baselines
+  //!
+  //! @return false if an option is invalid
+  //----------------------------------------------------------------------------
+  bool Configure(int& argc, char** argv);
+
+  //----------------------------------------------------------------------------
+  //! Print the options
+  //----------------------------------------------------------------------------
+  static void Usage(const char* prog);
+
+  //----------------------------------------------------------------------------
+  //! Measure the benchmark of the current test
+  //!
+  //! @param ops number of operations done by one call of body
+  //! @param body benchmark, called with the number of operations to do
+  //!
+  //! @return failure if the benchmark regressed beyond the tolerance
+  //----------------------------------------------------------------------------
+  ::testing::AssertionResult Run(size_t ops,
+                                 const std::function<void(size_t)>& body);
+
+  //----------------------------------------------------------------------------
+  //! Store the measured times if running with --update
+  //!
+  //! @return false if the baseline file could not be written
+  //----------------------------------------------------------------------------
+  bool Finish();
+
+private:
+  PerfRunner() = default;
+
+  //----------------------------------------------------------------------------
+  //! Load the baselines, a missing file is an empty one
+  //----------------------------------------------------------------------------
+  bool LoadBaselines();
+
+  std::string mBaselineFile; ///< file of the baselines
+  double mTolerance {20}; ///< allowed slowdown in percent
+  size_t mRepetitions {5}; ///< repetitions of every benchmark
+  bool mUpdate {false}; ///< store the results instead of checking them
+  std::map<std::string, double> mBaselines; ///< ns per op by test name
+  std::map<std::string, double> mResults; ///< ns per op by test name
+};
+
+} // namespace perf
+} // namespace eos